@@ -47,6 +47,9 @@ compile_definition(QUARISMA_ENABLE_NUMA)
 # SVML support
 compile_definition(QUARISMA_ENABLE_SVML)
 
+# Runtime CPU capability dispatch
+compile_definition(QUARISMA_ENABLE_CPU_DISPATCH)
+
 # CUDA support
 compile_definition(QUARISMA_ENABLE_CUDA)
 
@@ -121,6 +124,10 @@ if(QUARISMA_LU_PIVOTING)
   list(APPEND QUARISMA_DEPENDENCY_COMPILE_DEFINITIONS QUARISMA_LU_PIVOTING=1)
 endif()
 
+if(QUARISMA_SWISS_TABLE)
+  list(APPEND QUARISMA_DEPENDENCY_COMPILE_DEFINITIONS QUARISMA_SWISS_TABLE=1)
+endif()
+
 # Compression support
 compile_definition(QUARISMA_ENABLE_COMPRESSION)
 if(QUARISMA_ENABLE_COMPRESSION)
@@ -133,6 +140,10 @@ else()
   list(APPEND QUARISMA_DEPENDENCY_COMPILE_DEFINITIONS QUARISMA_COMPRESSION_TYPE_SNAPPY=0)
 endif()
 
+# Optional codecs of compression/codec.h
+compile_definition(QUARISMA_ENABLE_LZ4)
+compile_definition(QUARISMA_ENABLE_ZSTD)
+
 # Allocation statistics support (optional feature flag)
 compile_definition(QUARISMA_ENABLE_ALLOCATION_STATS)
 
@@ -35,3 +35,35 @@ if(QUARISMA_ENABLE_COMPRESSION)
 else()
   message(STATUS "Compression disabled")
 endif()
+
+# Additional Codecs Enables the LZ4 and Zstandard codecs of compression/codec.h. Each is independent
+# of QUARISMA_COMPRESSION_TYPE and is linked from the system library when found.
+option(QUARISMA_ENABLE_LZ4 "Enable the LZ4 compression codec" OFF)
+option(QUARISMA_ENABLE_ZSTD "Enable the Zstandard compression codec" OFF)
+mark_as_advanced(QUARISMA_ENABLE_LZ4 QUARISMA_ENABLE_ZSTD)
+
+if(QUARISMA_ENABLE_LZ4)
+  find_path(LZ4_INCLUDE_DIR lz4.h)
+  find_library(LZ4_LIBRARY NAMES lz4)
+  if(LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+    include_directories(SYSTEM ${LZ4_INCLUDE_DIR})
+    list(APPEND QUARISMA_DEPENDENCY_LIBS "${LZ4_LIBRARY}")
+    message(STATUS "Compression codec enabled: LZ4")
+  else()
+    message(WARNING "LZ4 not found. Suppress this warning with -DQUARISMA_ENABLE_LZ4=OFF")
+    set(QUARISMA_ENABLE_LZ4 OFF)
+  endif()
+endif()
+
+if(QUARISMA_ENABLE_ZSTD)
+  find_path(ZSTD_INCLUDE_DIR zstd.h)
+  find_library(ZSTD_LIBRARY NAMES zstd)
+  if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+    include_directories(SYSTEM ${ZSTD_INCLUDE_DIR})
+    list(APPEND QUARISMA_DEPENDENCY_LIBS "${ZSTD_LIBRARY}")
+    message(STATUS "Compression codec enabled: Zstandard")
+  else()
+    message(WARNING "Zstandard not found. Suppress this warning with -DQUARISMA_ENABLE_ZSTD=OFF")
+    set(QUARISMA_ENABLE_ZSTD OFF)
+  endif()
+endif()
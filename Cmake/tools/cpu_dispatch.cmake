@@ -0,0 +1,83 @@
+# ============================================================================= CPU Capability
+# Dispatch
+# =============================================================================
+# Builds the kernels in the cpu/ directories once per instruction set, so that util/cpu_dispatch.h
+# can pick the best one for the running CPU. Unlike QUARISMA_VECTORIZATION_TYPE, which raises the
+# baseline of the whole library, one binary then uses AVX-512 where it is available and still
+# runs on machines without it. Requires the AVX2 and AVX512 checks of utils.cmake.
+# =============================================================================
+include_guard(GLOBAL)
+
+include(CMakePushCheckState)
+
+option(QUARISMA_ENABLE_CPU_DISPATCH "Build kernels for AVX2 and AVX-512 and select one at run time"
+       ON
+)
+mark_as_advanced(QUARISMA_ENABLE_CPU_DISPATCH)
+
+if(MSVC)
+  set(QUARISMA_DISPATCH_AVX2_FLAGS "/arch:AVX2")
+  set(QUARISMA_DISPATCH_AVX512_FLAGS "/arch:AVX512")
+else()
+  set(QUARISMA_DISPATCH_AVX2_FLAGS "-mavx2;-mfma")
+  set(QUARISMA_DISPATCH_AVX512_FLAGS "-mavx512f;-mavx512bw;-mavx512dq;-mavx512vl;-mfma")
+endif()
+
+if(QUARISMA_ENABLE_CPU_DISPATCH)
+  # The kernels use AVX-512BW byte comparisons, which the utils.cmake check does not cover
+  cmake_push_check_state(RESET)
+  string(REPLACE ";" " " CMAKE_REQUIRED_FLAGS "${QUARISMA_DISPATCH_AVX512_FLAGS}")
+  check_cxx_source_compiles(
+    "#include <immintrin.h>
+     int main() {
+       __m512i a = _mm512_set1_epi8(1);
+       __mmask64 m = _mm512_cmpeq_epi8_mask(a, a);
+       return static_cast<int>(m & 1);
+     }"
+    QUARISMA_COMPILER_SUPPORTS_AVX512BW_EXTENSIONS
+  )
+  cmake_pop_check_state()
+
+  if(NOT CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64|x64)$")
+    message(STATUS "CPU dispatch disabled: not an x86-64 target")
+    set(QUARISMA_ENABLE_CPU_DISPATCH OFF)
+  elseif(NOT QUARISMA_COMPILER_SUPPORTS_AVX2_EXTENSIONS
+         OR NOT QUARISMA_COMPILER_SUPPORTS_AVX512BW_EXTENSIONS
+  )
+    message(STATUS "CPU dispatch disabled: the compiler does not support AVX2 and AVX-512BW")
+    set(QUARISMA_ENABLE_CPU_DISPATCH OFF)
+  else()
+    message(STATUS "CPU dispatch enabled: default, avx2, avx512")
+  endif()
+endif()
+
+# =============================================================================
+# quarisma_add_dispatch_sources(<target> <source>...)
+#
+# Adds each kernel source to target as is, for cpu_capability::DEFAULT, and, when
+# QUARISMA_ENABLE_CPU_DISPATCH is on, a copy per capability compiled with its flags and
+# QUARISMA_CPU_CAPABILITY defined. Copies are configured into the binary directory, so includes
+# must be relative to the include directories of target, not to the source.
+# =============================================================================
+function(quarisma_add_dispatch_sources target)
+  foreach(_source IN LISTS ARGN)
+    get_filename_component(_source "${_source}" ABSOLUTE)
+    get_filename_component(_name "${_source}" NAME_WE)
+    target_sources(${target} PRIVATE "${_source}")
+
+    if(QUARISMA_ENABLE_CPU_DISPATCH)
+      foreach(_capability IN ITEMS AVX2 AVX512)
+        set(_copy "${CMAKE_CURRENT_BINARY_DIR}/cpu_dispatch/${_name}.${_capability}.cpp")
+        configure_file("${_source}" "${_copy}" COPYONLY)
+        set_source_files_properties(
+          "${_copy}"
+          PROPERTIES
+            COMPILE_OPTIONS "${QUARISMA_DISPATCH_${_capability}_FLAGS}"
+            COMPILE_DEFINITIONS
+            "QUARISMA_CPU_CAPABILITY=${_capability};QUARISMA_CPU_CAPABILITY_${_capability}"
+        )
+        target_sources(${target} PRIVATE "${_copy}")
+      endforeach()
+    endif()
+  endforeach()
+endfunction()
@@ -48,6 +48,9 @@ set_property(
   TARGET Quarisma::mkl PROPERTY INTERFACE_LINK_DIRECTORIES
   ${MKL_ROOT}/lib ${MKL_ROOT}/lib/intel64 ${MKL_ROOT}/lib/intel64_win ${MKL_ROOT}/lib/win-x64)
 
+# Core's LU factorization calls LAPACKE_dgetrf, see Library/Core/math/lu.cpp
+list(APPEND QUARISMA_DEPENDENCY_LIBS Quarisma::mkl)
+
 if(UNIX)
   if(QUARISMA_ENABLE_STATIC_MKL)
     foreach(MKL_LIB_PATH IN LISTS MKL_LIBRARIES)
@@ -69,6 +69,7 @@ function(print_configuration_summary)
   message("    NUMA                : ${QUARISMA_ENABLE_NUMA}")
   message("    Sobol 1111          : ${QUARISMA_SOBOL_1111}")
   message("    LU Pivoting         : ${QUARISMA_LU_PIVOTING}")
+  message("    Swiss table         : ${QUARISMA_SWISS_TABLE}")
   message("    LTO                 : ${QUARISMA_ENABLE_LTO}")
   message("    Magic Enum          : ${QUARISMA_ENABLE_MAGICENUM}")
   message("    Mimalloc            : ${QUARISMA_ENABLE_MIMALLOC}")
@@ -41,6 +41,7 @@
 #include <unordered_set>
 #include <utility>
 
+#include "parallel/std_thread/parallel_thread_pool.h"
 #include "util/exception.h"
 
 namespace torch::autograd
@@ -148,6 +149,11 @@ QUARISMA_DEFINE_TLS_static(std::shared_ptr<GraphTask>, tls_current_graph_task);
 QUARISMA_DEFINE_TLS_static(std::shared_ptr<ReadyQueue>, tls_local_ready_queue);
 #define local_ready_queue (tls_local_ready_queue.get())
 
+// The shard of the ReadyQueue that this thread pushes to and pops from first.
+// It is 0 except on the pool threads running a parallel CPU backward; see
+// Note [Parallel CPU backward]
+static thread_local size_t ready_queue_shard = 0;
+
 // Note [Reentrant backwards]
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~
 // To understand the reentrant backwards problem, we have to notice two
@@ -178,6 +184,28 @@ QUARISMA_DEFINE_TLS_static(std::shared_ptr<ReadyQueue>, tls_local_ready_queue);
 // When the GraphTask is finished, the parent worker thread that is waiting on
 // the task is notified and the current thread returns to the pool.
 
+// Note [Parallel CPU backward]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// By default the CPU nodes of a backward pass all run on the thread that called
+// backward(). When Engine::set_num_cpu_backward_threads(n) is set, a backward
+// call that is not reentrant gives its GraphTask a ReadyQueue with n + 1
+// shards and posts n helpers to the Quarisma thread pool. The calling thread
+// drains shard 0 and helper i drains shard i, so independent branches of the
+// graph run concurrently.
+//
+// A thread pushes the nodes it makes ready to its own shard and pops the first
+// task of its own heap, so every shard keeps the sequence_nr order and a thread
+// tends to follow the branch whose inputs it just produced. An idle thread
+// steals the first task of another shard, trying the threads on its NUMA node
+// (as placed by the pool's affinity policy) before the others, and sleeps on
+// the queue only when every shard is empty.
+//
+// All these threads are the owner of the GraphTask, so the thread that
+// completes it pushes one dummy task per other thread to wake them up. Dummy
+// tasks never wake up threads themselves, and those left over are no-ops for
+// later backward calls reusing the queue. Helpers posted after the GraphTask
+// completed return at once.
+
 // Note [Streaming backwards]
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~
 // On CUDA/privateuse1 devices the autograd engine's device operations are run
@@ -237,53 +265,116 @@ CheckpointValidGuard::~CheckpointValidGuard()
     checkpoint_valid = prev_checkpoint_valid_state;
 }
 
+ReadyQueue::ReadyQueue(size_t num_shards)
+{
+    TORCH_INTERNAL_ASSERT(num_shards > 0);
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i)
+    {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
 auto ReadyQueue::push(NodeTask item, bool incrementOutstandingTasks) -> void
 {
+    Shard& shard = *shards_[ready_queue_shard % shards_.size()];
     {
         // Lock mutex for writing to heap_
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
         if (incrementOutstandingTasks)
         {
             std::shared_ptr<GraphTask> graph_task = item.base_.lock();
             TORCH_INTERNAL_ASSERT(graph_task, "GraphTask is no longer valid!");
             ++graph_task->outstanding_tasks_;
         }
-        heap_.push(std::move(item));
+        shard.heap_.push(std::move(item));
+        ++size_;
+    }
+    // A thread about to wait has checked size_ under mutex_, so taking mutex_
+    // here guarantees that it either sees the task or gets the notification
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
     }
     not_empty_.notify_one();
 }
 
 auto ReadyQueue::pushShutdownTask() -> void
 {
+    Shard& shard = *shards_[0];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        shard.heap_.push(NodeTask({}, nullptr, InputBuffer(0), true));
+        ++size_;
+    }
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        heap_.push(NodeTask({}, nullptr, InputBuffer(0), true));
     }
     not_empty_.notify_one();
 }
 
 size_t ReadyQueue::size() const
 {
-    // Lock mutex for accesses to heap_
-    std::unique_lock<std::mutex> lock(mutex_);
-    return heap_.size();
+    return size_.load();
 }
 
-auto ReadyQueue::pop() -> NodeTask
+std::optional<NodeTask> ReadyQueue::pop_from(Shard& shard)
 {
     // Lock mutex for accesses to heap_
-    std::unique_lock<std::mutex> lock(mutex_);
-    not_empty_.wait(lock, [this] { return !heap_.empty(); });
-    auto task = std::move(const_cast<NodeTask&>(heap_.top()));
-    heap_.pop();
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    if (shard.heap_.empty())
+    {
+        return std::nullopt;
+    }
+    auto task = std::move(const_cast<NodeTask&>(shard.heap_.top()));
+    shard.heap_.pop();
+    --size_;
     return task;
 }
 
+auto ReadyQueue::pop() -> NodeTask
+{
+    const size_t num_shards = shards_.size();
+    const size_t home       = ready_queue_shard % num_shards;
+    const int    numa_node  = shards_[home]->numa_node_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        if (auto task = pop_from(*shards_[home]))
+        {
+            return std::move(*task);
+        }
+        // Steal the first task of another thread, from the threads on our NUMA
+        // node first, as they wrote the inputs of their tasks
+        for (bool same_node : {true, false})
+        {
+            for (size_t i = 1; i < num_shards; ++i)
+            {
+                Shard&     victim = *shards_[(home + i) % num_shards];
+                const bool local  = numa_node >= 0 &&
+                                   victim.numa_node_.load(std::memory_order_relaxed) == numa_node;
+                if (local != same_node)
+                {
+                    continue;
+                }
+                if (auto task = pop_from(victim))
+                {
+                    return std::move(*task);
+                }
+            }
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return size_.load() > 0; });
+    }
+}
+
 bool ReadyQueue::empty() const
 {
-    // Lock mutex for accesses to heap_
-    std::unique_lock<std::mutex> lock(mutex_);
-    return heap_.empty();
+    return size_.load() == 0;
+}
+
+void ReadyQueue::set_numa_node(size_t shard, int numa_node)
+{
+    TORCH_INTERNAL_ASSERT(shard < shards_.size());
+    shards_[shard]->numa_node_.store(numa_node, std::memory_order_relaxed);
 }
 
 Engine::Engine() : max_recursion_depth_(MAX_DEPTH), non_reentrant_device_thread_count_(0) {}
@@ -567,6 +658,7 @@ auto Engine::thread_main(const std::shared_ptr<GraphTask>& graph_task) -> void
         // The outer graph_task represents the overall graph_task we need to execute
         // for reentrant execution.
         std::shared_ptr<GraphTask> local_graph_task;
+        bool                       dummy_task = false;
         {
             // Scope this block of execution since NodeTask is not needed after this
             // block and can be deallocated (release any references to grad tensors
@@ -589,6 +681,7 @@ auto Engine::thread_main(const std::shared_ptr<GraphTask>& graph_task) -> void
             }
 
             set_device(worker_device);
+            dummy_task = !task.fn_;
 
             if (task.fn_ && !local_graph_task->has_error_.load())
             {
@@ -651,6 +744,16 @@ auto Engine::thread_main(const std::shared_ptr<GraphTask>& graph_task) -> void
                 ready_queue_by_index(local_graph_task->cpu_ready_queue_, base_owner)
                     ->push(NodeTask(local_graph_task, nullptr, InputBuffer(0)));
             }
+            else if (!dummy_task)
+            {
+                // The other threads of a parallel CPU backward may be sleeping on
+                // pop(). See Note [Parallel CPU backward]
+                const auto& cpu_queue = local_graph_task->cpu_ready_queue_;
+                for (size_t i = 1; i < cpu_queue->num_shards(); ++i)
+                {
+                    cpu_queue->push(NodeTask(local_graph_task, nullptr, InputBuffer(0)));
+                }
+            }
         }
     }
 }
@@ -1170,7 +1273,9 @@ void Engine::evaluate_function(
     auto                        opt_parent_stream = (*func).stream();
     quarisma::OptionalStreamGuard parent_stream_guard{opt_parent_stream};
 
-    // Ensure that the incoming gradients are ready
+    // Sum the gradients the buffer held back, then ensure that the incoming
+    // gradients are ready
+    inputs.flush();
     for (size_t pos = 0; pos < inputs.ready_events.size(); ++pos)
     {
         if (!inputs.buffer[pos].defined())
@@ -1442,8 +1547,19 @@ auto Engine::execute(
     // initialize a new thread local ready queue on CPU or reuse the existing one
     // (if there is one allocated already, i.e. consecutive backward calls,
     // re-entrant backward calls), then memoize the local_ready_queue in GraphTask
-    init_local_ready_queue();
     bool not_reentrant_backward_call = worker_device == NO_DEVICE;
+    // See Note [Parallel CPU backward]
+    const size_t cpu_backward_threads =
+        not_reentrant_backward_call ? num_cpu_backward_threads() : 0;
+    if (cpu_backward_threads > 0 &&
+        (!local_ready_queue || local_ready_queue->num_shards() != cpu_backward_threads + 1))
+    {
+        init_local_ready_queue(std::make_shared<ReadyQueue>(cpu_backward_threads + 1));
+    }
+    else
+    {
+        init_local_ready_queue();
+    }
 
     // Store root nodes so we can traverse through the graph later
     // e.g., for get_current_graph_task_execution_order
@@ -1556,6 +1672,20 @@ quarisma::intrusive_ptr<quarisma::ivalue::Future> Engine::execute_with_graph_tas
         // populated, we can enqueue it.
         queue->push(NodeTask(graph_task, std::move(graph_root), std::move(input_buffer)));
 
+        // See Note [Parallel CPU backward]
+        auto&       pool      = quarisma::detail::parallel::parallel_thread_pool::instance();
+        const auto& cpu_queue = graph_task->cpu_ready_queue_;
+        if (cpu_queue->num_shards() > 1)
+        {
+            cpu_queue->set_numa_node(0, pool.get_thread_numa_node());
+        }
+        for (size_t shard = 1; shard < cpu_queue->num_shards(); ++shard)
+        {
+            pool.post(
+                [this, graph_task, cpu_queue, shard]
+                { cpu_backward_thread_main(graph_task, cpu_queue, shard); });
+        }
+
         // The owning thread start to drive the engine execution for any CPU task
         // that was just pushed or will be added later from other worker threads
         lock.unlock();
@@ -1657,6 +1787,44 @@ bool Engine::is_checkpoint_valid()
     return checkpoint_valid;
 }
 
+void Engine::set_num_cpu_backward_threads(size_t num_threads)
+{
+    num_cpu_backward_threads_.store(num_threads);
+}
+
+size_t Engine::num_cpu_backward_threads() const
+{
+    return num_cpu_backward_threads_.load();
+}
+
+// Runs on a pool thread, as one of the owners of a non-reentrant GraphTask. See
+// Note [Parallel CPU backward]
+void Engine::cpu_backward_thread_main(
+    const std::shared_ptr<GraphTask>&  graph_task,
+    const std::shared_ptr<ReadyQueue>& queue,
+    size_t                             shard)
+{
+    // Pool threads run other jobs afterwards, so restore their autograd state
+    const int                   prev_worker_device = worker_device;
+    const int                   prev_total_depth   = total_depth;
+    const size_t                prev_shard         = ready_queue_shard;
+    std::shared_ptr<ReadyQueue> prev_queue         = local_ready_queue;
+
+    auto& pool = quarisma::detail::parallel::parallel_thread_pool::instance();
+    queue->set_numa_node(shard, pool.get_thread_numa_node());
+    worker_device     = CPU_DEVICE;
+    total_depth       = graph_task->reentrant_depth_;
+    ready_queue_shard = shard;
+    local_ready_queue = queue;
+
+    thread_main(graph_task);
+
+    local_ready_queue = std::move(prev_queue);
+    ready_queue_shard = prev_shard;
+    total_depth       = prev_total_depth;
+    worker_device     = prev_worker_device;
+}
+
 void Engine::init_local_ready_queue(std::shared_ptr<ReadyQueue> ready_queue)
 {
     if (ready_queue)
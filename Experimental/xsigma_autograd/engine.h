@@ -18,6 +18,7 @@
 #include <exception>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <utility>
 #include <vector>
@@ -120,14 +121,35 @@ private:
         }
     };
 
-    // To notify threads waiting on the ReadyQueue of available tasks on the heap_
+    // The tasks pushed by one of the threads draining the queue. A queue has a
+    // single shard, except the CPU ready queue of a backward pass that runs on
+    // several threads. See Note [Parallel CPU backward]
+    struct Shard
+    {
+        // To protect read and writes to heap_
+        std::mutex mutex_;
+
+        std::priority_queue<NodeTask, std::vector<NodeTask>, CompareNodeTaskTime> heap_;
+
+        // NUMA node of the thread draining this shard, -1 when unknown
+        std::atomic<int> numa_node_{-1};
+    };
+
+    // Takes the first task of the shard, if any
+    std::optional<NodeTask> pop_from(Shard& shard);
+
+    // To notify threads waiting on the ReadyQueue of available tasks on the heaps
     std::condition_variable not_empty_;
-    // To protect read and writes to heap_
-    mutable std::mutex mutex_;
+    // To wait on not_empty_
+    std::mutex mutex_;
 
-    std::priority_queue<NodeTask, std::vector<NodeTask>, CompareNodeTaskTime> heap_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // Number of tasks over all the shards
+    std::atomic<size_t> size_{0};
 
 public:
+    explicit ReadyQueue(size_t num_shards = 1);
+
     // incrementOutstandingTasks indicates whether or not we should increment
     // 'outstanding_tasks_' for the associated GraphTask. This should mostly
     // always be true and is only set false in certain cases (see docs for
@@ -137,6 +159,11 @@ public:
     NodeTask pop();
     bool     empty() const;
     size_t   size() const;
+
+    size_t num_shards() const { return shards_.size(); }
+    // Records the NUMA node of the thread draining `shard`, so that idle threads
+    // steal from threads on their own node first
+    void set_numa_node(size_t shard, int numa_node);
 };
 
 // A single instance of this struct should be created through the whole process
@@ -221,6 +248,12 @@ struct TORCH_API Engine
     virtual void thread_init(
         int device, const std::shared_ptr<ReadyQueue>& ready_queue, bool should_increment = true);
 
+    // Number of thread pool workers that run the CPU nodes of a backward pass
+    // along with the calling thread; 0, the default, runs them on the calling
+    // thread only. See Note [Parallel CPU backward]
+    void   set_num_cpu_backward_threads(size_t num_threads);
+    size_t num_cpu_backward_threads() const;
+
 protected:
     Engine();
     void compute_dependencies(Node* root, GraphTask& task, uint64_t min_topo_nr);
@@ -241,6 +274,10 @@ protected:
     void         decrement_non_reentrant_thread_count();
     virtual void thread_main(const std::shared_ptr<GraphTask>& task);
     void         reentrant_thread_init();
+    void         cpu_backward_thread_main(
+        const std::shared_ptr<GraphTask>&  graph_task,
+        const std::shared_ptr<ReadyQueue>& queue,
+        size_t                             shard);
     void         add_thread_pool_task(const std::weak_ptr<GraphTask>& graph_task);
 
     // Safe to read device_ready_queues_ without synchronization after
@@ -294,6 +331,8 @@ private:
     // whether stop() has already been called, so we can call this in every
     // destructor of the class hierarchy.
     bool stopped_{false};
+
+    std::atomic<size_t> num_cpu_backward_threads_{0};
 };
 
 // allow python_engine to override the default engine when it loads
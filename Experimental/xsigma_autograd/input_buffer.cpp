@@ -1,5 +1,7 @@
 #include <Quarisma/CachedTensorUtils.h>
+#include <Quarisma/Dispatch.h>
 #include <Quarisma/LegacyBatchedTensorImpl.h>
+#include <Quarisma/Parallel.h>
 #include <Quarisma/SparseCsrTensorUtils.h>
 #include <Quarisma/TensorOperators.h>
 #include <Quarisma/TensorSubclassLikeUtils.h>
@@ -9,8 +11,11 @@
 #include <quarisma/core/DeviceGuard.h>
 #include <quarisma/core/Event.h>
 #include <quarisma/core/StreamGuard.h>
+#include <quarisma/util/irange.h>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -20,6 +25,14 @@ namespace torch::autograd
 
 namespace
 {
+// Gradients of one input held back before they are summed, which bounds the
+// memory they keep alive
+constexpr size_t kMaxDeferredGradients = 8;
+
+// Elements of the output summed over all the gradients before moving on, so
+// that they stay in L1 while every gradient streams over them
+constexpr int64_t kSumChunk = 1024;
+
 // look what you made me do >.<
 // Divergent paths for per-Impl stream recording that leak implementation
 // details of the impls should not be needed here.
@@ -93,6 +106,69 @@ bool can_accumulate_inplace(const Variable& v)
         quarisma::caching::adjusted_use_count(v) == 1 && v.has_storage() &&
         v.storage().use_count() == 1);
 }
+
+bool is_plain_dense(const Variable& v)
+{
+    return !(quarisma::isTensorSubclassLike(v) || v._is_zerotensor() || v.is_nested()) &&
+           v.layout() == quarisma::kStrided && v.is_non_overlapping_and_dense();
+}
+
+// Whether var can wait to be summed with old_var by InputBuffer::flush: both
+// are dense tensors of the same layout, so that their elements line up in
+// memory, and the sum needs no autograd history
+bool can_defer(const Variable& old_var, const Variable& var)
+{
+    return !quarisma::GradMode::is_enabled() && is_plain_dense(old_var) && is_plain_dense(var) &&
+           old_var.scalar_type() == var.scalar_type() && old_var.device() == var.device() &&
+           old_var.sizes() == var.sizes() && old_var.strides() == var.strides();
+}
+
+// out += sum of grads, all laid out like out. On the CPU the floating point
+// sums are fused: every element of out is read and written once, whatever
+// the number of gradients.
+void sum_into(Variable& out, const std::vector<Variable>& grads)
+{
+    const auto dtype = out.scalar_type();
+    if (!out.is_cpu() || (dtype != quarisma::kFloat && dtype != quarisma::kDouble))
+    {
+        for (const auto& grad : grads)
+        {
+            out.add_(grad);
+        }
+        return;
+    }
+    AT_DISPATCH_FLOATING_TYPES(
+        dtype,
+        "InputBuffer::flush",
+        [&]
+        {
+            std::vector<const scalar_t*> sources;
+            sources.reserve(grads.size());
+            for (const auto& grad : grads)
+            {
+                sources.push_back(grad.const_data_ptr<scalar_t>());
+            }
+            scalar_t* dst = out.mutable_data_ptr<scalar_t>();
+            quarisma::parallel_for(
+                0,
+                out.numel(),
+                quarisma::internal::GRAIN_SIZE,
+                [&](int64_t begin, int64_t end)
+                {
+                    for (int64_t c = begin; c < end; c += kSumChunk)
+                    {
+                        const int64_t c_end = std::min(end, c + kSumChunk);
+                        for (const scalar_t* src : sources)
+                        {
+                            for (int64_t i = c; i < c_end; ++i)
+                            {
+                                dst[i] += src[i];
+                            }
+                        }
+                    }
+                });
+        });
+}
 }  // anonymous namespace
 
 static void accumulate(std::vector<Variable>& buffer, const size_t pos, Variable&& var)
@@ -138,6 +214,14 @@ static void accumulate(std::vector<Variable>& buffer, const size_t pos, Variable
     {
         buffer[pos] = old_var.add_(var);
     }
+    else if (
+        // Otherwise the incoming gradient may be the one we can repurpose
+        can_accumulate_inplace(var) && !quarisma::isTensorSubclassLike(old_var) &&
+        var.sizes() == old_var.sizes() && var.scalar_type() == old_var.scalar_type() &&
+        var.device() == old_var.device())
+    {
+        buffer[pos] = var.add_(old_var);
+    }
     else
     {
         buffer[pos] = old_var + var;
@@ -227,7 +311,7 @@ void InputBuffer::add(
         else
         {
             quarisma::OptionalDeviceGuard device_guard{device};
-            accumulate(buffer, pos, std::move(var));
+            accumulate_or_defer(pos, std::move(var));
         }
         return;
     }
@@ -318,7 +402,7 @@ void InputBuffer::add(
         }
         // 2)
         quarisma::OptionalStreamGuard stream_guard{accum_stream};
-        accumulate(buffer, pos, std::move(var));
+        accumulate_or_defer(pos, std::move(var));
         // 3)
         if (*opt_consumer_stream != *accum_stream)
         {
@@ -331,8 +415,84 @@ void InputBuffer::add(
     }
 }
 
+void InputBuffer::accumulate_or_defer(size_t pos, Variable&& var)
+{
+    if (pos < pending.size() && can_defer(buffer[pos], var))
+    {
+        pending[pos].push_back(std::move(var));
+        if (pending[pos].size() >= kMaxDeferredGradients)
+        {
+            flush(pos);
+        }
+        return;
+    }
+    // Sum what was held back first, to add the gradients in the order they came
+    flush(pos);
+    accumulate(buffer, pos, std::move(var));
+}
+
+void InputBuffer::flush()
+{
+    for (const auto pos : quarisma::irange(pending.size()))
+    {
+        flush(pos);
+    }
+}
+
+// The held back gradients arrived as described in Note: [Autograd
+// Producer-Consumer Stream Syncs]: each was made ready on the accumulation
+// stream, and buffer[pos] too, so they are summed there. Only the event the
+// consumer waits on must be recorded again, after the sum.
+void InputBuffer::flush(size_t pos)
+{
+    if (pos >= pending.size() || pending[pos].empty())
+    {
+        return;
+    }
+    auto&      grads  = pending[pos];
+    auto&      first  = buffer[pos];
+    const auto device = first.device();
+
+    quarisma::OptionalDeviceGuard device_guard{device};
+    quarisma::OptionalStreamGuard stream_guard{opt_accum_streams[pos]};
+
+    // Sum into the first gradient, or any other we hold the last reference
+    // to, and only allocate the output when there is none
+    Variable out;
+    if (can_accumulate_inplace(first))
+    {
+        out = std::move(first);
+    }
+    else
+    {
+        auto it = std::find_if(grads.begin(), grads.end(), can_accumulate_inplace);
+        if (it != grads.end())
+        {
+            out = std::move(*it);
+            *it = std::move(first);
+        }
+        else
+        {
+            out = first + grads.back();
+            grads.pop_back();
+            first.reset();
+        }
+    }
+    sum_into(out, grads);
+    buffer[pos] = std::move(out);
+    grads.clear();
+
+    if (quarisma::accelerator::isAccelerator(device.type()) && ready_events[pos].has_value())
+    {
+        auto event = quarisma::Event{device.type()};
+        event.record(*opt_accum_streams[pos]);
+        ready_events[pos] = std::move(event);
+    }
+}
+
 auto InputBuffer::variables(InputBuffer&& g) -> std::vector<Variable>
 {
+    g.flush();
     std::vector<Variable> result = std::move(g.buffer);
     return result;
 }
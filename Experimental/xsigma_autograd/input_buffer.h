@@ -4,6 +4,11 @@
 // function. It implements logic to avoid modifying the passed
 // values in-place (adding an input twice will accumulate the result).
 // This behaviour is needed and used only in backward graphs.
+//
+// When grad mode is off, the gradients flowing into an input after the first
+// one are held back rather than added one by one, and flush() sums all of
+// them in a single pass, into one of them when it is uniquely owned. The
+// engine flushes a buffer once its node has received all its gradients.
 
 #include <torch/csrc/autograd/variable.h>
 #include <quarisma/core/Stream.h>
@@ -18,7 +23,11 @@ namespace torch::autograd
 struct InputBuffer
 {
     explicit InputBuffer(size_t size)
-        : buffer(size), opt_accum_streams(size), ready_events(size), ready_streams(size)
+        : buffer(size),
+          opt_accum_streams(size),
+          ready_events(size),
+          ready_streams(size),
+          pending(size)
     {
     }
     InputBuffer(const InputBuffer& other) = delete;
@@ -35,7 +44,15 @@ struct InputBuffer
         const std::optional<quarisma::Stream>& opt_producer_stream,
         const std::optional<quarisma::Stream>& opt_consumer_stream);
 
-    Variable operator[](size_t pos) { return buffer[pos]; }
+    // Sums the gradients held back by add into buffer, on the accumulation
+    // stream of each input, and records the events its consumer waits on
+    TORCH_API void flush();
+
+    Variable operator[](size_t pos)
+    {
+        flush();
+        return buffer[pos];
+    }
 
     // Returns the inputs as a list of variables. Destroys given InputBuffer.
     static std::vector<Variable> variables(InputBuffer&& g);
@@ -49,6 +66,13 @@ struct InputBuffer
     // The streams corresponding to the events above. This is only used to
     // check if more synchronization is needed or not.
     std::vector<std::optional<quarisma::Stream>> ready_streams;
+    // The gradients of each input, after the one in buffer, not summed yet
+    std::vector<std::vector<Variable>> pending;
+
+private:
+    // Adds var to buffer[pos], or holds it back for flush
+    void accumulate_or_defer(size_t pos, Variable&& var);
+    void flush(size_t pos);
 };
 
 }  // namespace torch::autograd
@@ -0,0 +1,178 @@
+#include <torch/csrc/autograd/saved_tensor_budget.h>
+
+#ifndef AT_PER_OPERATOR_HEADERS
+#include <Quarisma/Functions.h>
+#else
+#include <Quarisma/ops/empty.h>
+#endif
+
+#include <quarisma/core/DeviceGuard.h>
+#include <quarisma/core/Stream.h>
+#include <quarisma/core/impl/DeviceGuardImplInterface.h>
+
+#include <atomic>
+#include <list>
+#include <mutex>
+
+#include "memory/gpu/gpu_memory_transfer.h"
+#include "util/exception.h"
+
+namespace torch::autograd
+{
+
+namespace
+{
+
+class BudgetedSavedVariableHooks;
+
+struct BudgetState
+{
+    std::atomic<size_t> budget{0};
+
+    // To protect the fields below and the hooks in resident
+    std::mutex mutex;
+    size_t     resident_bytes  = 0;
+    size_t     offloaded_bytes = 0;
+    // The hooks holding a device tensor, oldest first
+    std::list<BudgetedSavedVariableHooks*> resident;
+};
+
+BudgetState& budget_state()
+{
+    static BudgetState state;
+    return state;
+}
+
+class BudgetedSavedVariableHooks : public SavedVariableHooks
+{
+public:
+    void call_pack_hook(const quarisma::Tensor& tensor) override
+    {
+        auto&                       state = budget_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        device_tensor_ = tensor;
+        bytes_         = tensor.nbytes();
+        state.resident_bytes += bytes_;
+        position_ = state.resident.insert(state.resident.end(), this);
+        while (state.resident_bytes > state.budget.load() && !state.resident.empty())
+        {
+            state.resident.front()->offload(state);
+        }
+    }
+
+    quarisma::Tensor call_unpack_hook() override
+    {
+        quarisma::Tensor host_tensor;
+        {
+            std::lock_guard<std::mutex> lock(budget_state().mutex);
+            if (device_tensor_.defined())
+            {
+                return device_tensor_;
+            }
+            host_tensor = host_tensor_;
+        }
+        // Kept on the host, in case the graph is retained and unpacked again
+        quarisma::DeviceGuard guard(device_);
+        auto                  restored = quarisma::empty(
+            host_tensor.sizes(), host_tensor.options().device(device_).pinned_memory(false));
+        quarisma::gpu::gpu_memory_transfer::instance().transfer_sync(
+            host_tensor.const_data_ptr(),
+            restored.mutable_data_ptr(),
+            bytes_,
+            quarisma::gpu::transfer_direction::HOST_TO_DEVICE);
+        return restored;
+    }
+
+    ~BudgetedSavedVariableHooks() override
+    {
+        auto&                       state = budget_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (device_tensor_.defined())
+        {
+            state.resident_bytes -= bytes_;
+            state.resident.erase(position_);
+        }
+        else if (host_tensor_.defined())
+        {
+            state.offloaded_bytes -= bytes_;
+        }
+    }
+
+private:
+    // Called with state.mutex held
+    void offload(BudgetState& state)
+    {
+        device_ = device_tensor_.device();
+        quarisma::DeviceGuard guard(device_);
+        // The transfer does not run on the stream that computes the tensor
+        quarisma::impl::getDeviceGuardImpl(device_.type())->getStream(device_).synchronize();
+
+        const quarisma::Tensor source = device_tensor_.contiguous();
+        host_tensor_                  = quarisma::empty(
+            source.sizes(), source.options().device(quarisma::kCPU).pinned_memory(true));
+        quarisma::gpu::gpu_memory_transfer::instance().transfer_sync(
+            source.const_data_ptr(),
+            host_tensor_.mutable_data_ptr(),
+            bytes_,
+            quarisma::gpu::transfer_direction::DEVICE_TO_HOST);
+
+        device_tensor_.reset();
+        state.resident.erase(position_);
+        state.resident_bytes -= bytes_;
+        state.offloaded_bytes += bytes_;
+    }
+
+    quarisma::Tensor                                 device_tensor_;
+    quarisma::Tensor                                 host_tensor_;
+    quarisma::Device                                 device_{quarisma::kCPU};
+    size_t                                           bytes_ = 0;
+    std::list<BudgetedSavedVariableHooks*>::iterator position_;
+};
+
+}  // namespace
+
+void SavedTensorBudget::set_budget(size_t bytes)
+{
+    budget_state().budget.store(bytes);
+}
+
+size_t SavedTensorBudget::budget()
+{
+    return budget_state().budget.load();
+}
+
+size_t SavedTensorBudget::resident_bytes()
+{
+    auto&                       state = budget_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.resident_bytes;
+}
+
+size_t SavedTensorBudget::offloaded_bytes()
+{
+    auto&                       state = budget_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.offloaded_bytes;
+}
+
+std::unique_ptr<SavedVariableHooks> SavedTensorBudget::make_hooks(const quarisma::Tensor& tensor)
+{
+    if (budget() == 0 || !tensor.is_cuda() || tensor.nbytes() == 0)
+    {
+        return nullptr;
+    }
+    return std::make_unique<BudgetedSavedVariableHooks>();
+}
+
+SavedTensorBudgetGuard::SavedTensorBudgetGuard(size_t bytes)
+    : prev_budget_(SavedTensorBudget::budget())
+{
+    SavedTensorBudget::set_budget(bytes);
+}
+
+SavedTensorBudgetGuard::~SavedTensorBudgetGuard()
+{
+    SavedTensorBudget::set_budget(prev_budget_);
+}
+
+}  // namespace torch::autograd
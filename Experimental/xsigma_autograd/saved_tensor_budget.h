@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Quarisma/core/Tensor.h>
+#include <torch/csrc/Export.h>
+#include <torch/csrc/autograd/saved_variable_hooks.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace torch::autograd
+{
+
+// Note [Saved tensor memory budget]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A graph keeps every tensor saved for backward alive until backward runs, so
+// a long chain of operations (e.g. the steps of a path simulation) can exhaust
+// the device memory before backward starts. With a budget set, the tensors
+// saved on a CUDA device are packed by SavedTensorBudget hooks, which count
+// their bytes. When the saved bytes on the devices exceed the budget, the
+// oldest saved tensors are copied to pinned host memory through
+// gpu_memory_transfer and their device copy is released. The oldest go first
+// because backward needs them last. An offloaded tensor is copied back to its
+// device when backward unpacks it.
+//
+// The device memory of an offloaded tensor is only freed once nothing else
+// references the tensor. Like any saved tensor hooks, the budget hooks
+// disable the check that saved tensors were not modified in-place. They are
+// not installed while Python saved tensor hooks are enabled.
+struct TORCH_API SavedTensorBudget
+{
+    // The budget in bytes, 0 (the default) disables it. Tensors saved before
+    // the budget is set are not accounted.
+    static void   set_budget(size_t bytes);
+    static size_t budget();
+
+    // Bytes of the accounted saved tensors kept on the devices and offloaded
+    // to the host
+    static size_t resident_bytes();
+    static size_t offloaded_bytes();
+
+    // The hooks accounting `tensor` against the budget, or nullptr when the
+    // budget is disabled or tensor is not on a CUDA device
+    static std::unique_ptr<SavedVariableHooks> make_hooks(const quarisma::Tensor& tensor);
+};
+
+/// A RAII guard that sets the saved tensor memory budget and restores the
+/// previous one on exit. See Note [Saved tensor memory budget]
+///
+/// Example:
+/// @code
+/// {
+///   torch::autograd::SavedTensorBudgetGuard budget(8ull << 30);
+///   auto loss = simulate(paths, 10000);
+///   loss.backward();
+/// }
+/// @endcode
+class TORCH_API SavedTensorBudgetGuard
+{
+public:
+    explicit SavedTensorBudgetGuard(size_t bytes);
+    ~SavedTensorBudgetGuard();
+
+private:
+    size_t prev_budget_;
+};
+
+}  // namespace torch::autograd
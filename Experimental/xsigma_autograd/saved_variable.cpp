@@ -4,6 +4,7 @@
 #include <torch/csrc/autograd/engine.h>
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/grad_mode.h>
+#include <torch/csrc/autograd/saved_tensor_budget.h>
 #include <torch/csrc/autograd/saved_variable.h>
 #include <torch/csrc/autograd/variable.h>
 
@@ -54,8 +55,11 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output, bool is_i
             TORCH_INTERNAL_ASSERT(!is_leaf_ && is_output);
             weak_grad_fn_ = variable.grad_fn();
         }
+        // See Note [Saved tensor memory budget]
         std::unique_ptr<SavedVariableHooks> maybe_hooks =
-            quarisma::SavedTensorDefaultHooks::is_enabled() ? get_default_hooks() : nullptr;
+            quarisma::SavedTensorDefaultHooks::is_enabled()
+                ? get_default_hooks()
+                : SavedTensorBudget::make_hooks(variable);
 
         // Avoid wrapped numbers from being leaked to the user
         if (maybe_hooks && !variable.unsafeGetTensorImpl()->is_wrapped_number())
@@ -441,7 +441,8 @@ struct DifferentiableGraphOp {
     detachVariables(stack);
     if (IsNewExecutorEnabled()) {
       const ExecutionPlan& plan = f_ptr->getPlanFor(stack);
-      InterpreterState(plan.code).run(stack);
+      InterpreterState(plan.code, quarisma::launch, plan.memory_plan)
+          .run(stack);
     } else {
       InterpreterState(legacy_f).run(stack);
     }
@@ -582,7 +583,7 @@ void GraphExecutorImplBase::run(Stack& stack) {
       logging::runtime_counters::GRAPH_EXECUTOR_INVOCATIONS, 1.0);
 
   const ExecutionPlan& plan = getPlanFor(stack);
-  InterpreterState(plan.code).run(stack);
+  InterpreterState(plan.code, quarisma::launch, plan.memory_plan).run(stack);
   last_executed_optimized_graph = plan.graph;
 }
 
@@ -602,7 +603,8 @@ quarisma::intrusive_ptr<Future> GraphExecutorImplBase::runAsync(
 
   struct Frame {
     explicit Frame(ExecutionPlan eplan, TaskLauncher taskLauncher)
-        : plan(std::move(eplan)), state(plan.code, std::move(taskLauncher)) {}
+        : plan(std::move(eplan)),
+          state(plan.code, std::move(taskLauncher), plan.memory_plan) {}
     ExecutionPlan plan;
     InterpreterState state;
   };
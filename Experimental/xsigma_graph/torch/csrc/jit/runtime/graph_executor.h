@@ -4,6 +4,7 @@
 #include <torch/csrc/jit/python/update_graph_executor_opt.h>
 #include <torch/csrc/jit/runtime/argument_spec.h>
 #include <torch/csrc/jit/runtime/interpreter.h>
+#include <torch/csrc/jit/runtime/memory_arena.h>
 #include <torch/csrc/jit/runtime/variable_tensor_list.h>
 
 #include <atomic>
@@ -29,7 +30,8 @@ struct ExecutionPlan
     ExecutionPlan() = default;
     ExecutionPlan(std::shared_ptr<Graph> graph, std::string function_name)
         : code(graph, std::move(function_name)),
-          graph(FLAGS_torch_jit_execution_plan_reuse_code_graph ? code.graph() : std::move(graph))
+          graph(FLAGS_torch_jit_execution_plan_reuse_code_graph ? code.graph() : std::move(graph)),
+          memory_plan(MemoryArenaPlan::create(code))
     {
     }
 
@@ -37,6 +39,9 @@ struct ExecutionPlan
 
     Code                   code;
     std::shared_ptr<Graph> graph;
+    // nullptr unless torch_jit_enable_memory_planning is set, see
+    // Note [Memory planning of execution plans]
+    std::shared_ptr<MemoryArenaPlan> memory_plan;
 };
 
 // Notice that those structs don't manage lifetime of their members.
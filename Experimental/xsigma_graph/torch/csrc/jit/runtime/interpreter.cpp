@@ -18,6 +18,7 @@
 #include <torch/csrc/jit/runtime/interpreter/code_impl.h>
 #include <torch/csrc/jit/runtime/interpreter/frame.h>
 #include <torch/csrc/jit/runtime/jit_exception.h>
+#include <torch/csrc/jit/runtime/memory_arena.h>
 #include <torch/csrc/jit/runtime/operator.h>
 #include <torch/csrc/jit/runtime/profiling_record.h>
 #include <torch/csrc/jit/runtime/script_profile.h>
@@ -39,6 +40,7 @@ using torch::distributed::autograd::DistAutogradContainer;
 #include <exception>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <ostream>
 #include <stdexcept>
 #include <typeinfo>
@@ -105,6 +107,192 @@ inline int64_t getDistAutogradContextId() {
   return 0;
 #endif
 }
+
+// Note [Interpreter fast paths]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Scripted pricing loops spend most of their time in int and float
+// arithmetic and comparisons (loop counters, indices, accumulators), where
+// each operation is a boxed operator call on the stack, surrounded by the
+// instructions that move its operands in and its result out. Without
+// profiling, the interpreter runs these with two fast paths:
+// * an OP whose node is one of ScalarOpKind on two statically typed int or
+//   float inputs computes its result in place on the stack, without calling
+//   the operator, and
+// * the sequence {LOAD|MOVE|LOADC} {LOAD|MOVE|LOADC} OP STORE around such an
+//   OP runs as one instruction reading its operands from the registers and
+//   constants and writing its result to the register, without going through
+//   the stack.
+// Both check the tags of the operands at runtime and fall back to the boxed
+// operator when they do not match. The OPs eligible for a CodeImpl are found
+// once, the first time the current thread enters a frame of it.
+enum class ScalarOpKind : uint8_t {
+  None,
+  Add,
+  Sub,
+  Mul,
+  Lt,
+  Le,
+  Gt,
+  Ge,
+  Eq,
+  Ne,
+};
+
+struct ScalarOp {
+  ScalarOpKind kind = ScalarOpKind::None;
+  bool is_float = false;
+};
+
+struct FastPaths {
+  // the scalar op of the OP instruction at each pc, None for other pcs
+  std::vector<ScalarOp> ops;
+  // whether the instruction at each pc starts a fused sequence
+  std::vector<uint8_t> fused;
+};
+
+ScalarOp scalarOpOf(const Node* node) {
+  if (!node || node->inputs().size() != 2 || node->outputs().size() != 1) {
+    return {};
+  }
+  ScalarOpKind kind = ScalarOpKind::None;
+  switch (node->kind()) {
+    case aten::add:
+      kind = ScalarOpKind::Add;
+      break;
+    case aten::sub:
+      kind = ScalarOpKind::Sub;
+      break;
+    case aten::mul:
+      kind = ScalarOpKind::Mul;
+      break;
+    case aten::lt:
+      kind = ScalarOpKind::Lt;
+      break;
+    case aten::le:
+      kind = ScalarOpKind::Le;
+      break;
+    case aten::gt:
+      kind = ScalarOpKind::Gt;
+      break;
+    case aten::ge:
+      kind = ScalarOpKind::Ge;
+      break;
+    case aten::eq:
+      kind = ScalarOpKind::Eq;
+      break;
+    case aten::ne:
+      kind = ScalarOpKind::Ne;
+      break;
+    default:
+      return {};
+  }
+  const auto lhs = node->input(0)->type()->kind();
+  const auto rhs = node->input(1)->type()->kind();
+  if (lhs == TypeKind::IntType && rhs == TypeKind::IntType) {
+    return {kind, false};
+  }
+  if (lhs == TypeKind::FloatType && rhs == TypeKind::FloatType) {
+    return {kind, true};
+  }
+  return {};
+}
+
+template <typename T>
+IValue applyScalarOp(ScalarOpKind kind, T a, T b) {
+  switch (kind) {
+    case ScalarOpKind::Add:
+      return a + b;
+    case ScalarOpKind::Sub:
+      return a - b;
+    case ScalarOpKind::Mul:
+      return a * b;
+    case ScalarOpKind::Lt:
+      return a < b;
+    case ScalarOpKind::Le:
+      return a <= b;
+    case ScalarOpKind::Gt:
+      return a > b;
+    case ScalarOpKind::Ge:
+      return a >= b;
+    case ScalarOpKind::Eq:
+      return a == b;
+    case ScalarOpKind::Ne:
+      return a != b;
+    case ScalarOpKind::None:
+      break;
+  }
+  TORCH_INTERNAL_ASSERT(false, "unexpected scalar op");
+}
+
+// Returns false, leaving result unchanged, when a or b does not have the
+// static type of the op
+bool applyScalarOp(
+    ScalarOp op,
+    const IValue& a,
+    const IValue& b,
+    IValue& result) {
+  if (op.is_float) {
+    if (!a.isDouble() || !b.isDouble()) {
+      return false;
+    }
+    result = applyScalarOp(op.kind, a.toDouble(), b.toDouble());
+  } else {
+    if (!a.isInt() || !b.isInt()) {
+      return false;
+    }
+    result = applyScalarOp(op.kind, a.toInt(), b.toInt());
+  }
+  return true;
+}
+
+bool isOperandLoad(const Instruction& inst) {
+  return inst.op == LOAD || inst.op == MOVE || inst.op == LOADC;
+}
+
+std::shared_ptr<const FastPaths> buildFastPaths(
+    const interpreter::CodeImpl& code) {
+  const auto& instructions = code.instructions_;
+  const auto& source = code.instructions_source_;
+  auto paths = std::make_shared<FastPaths>();
+  paths->ops.resize(instructions.size());
+  paths->fused.resize(instructions.size(), 0);
+  for (const auto pc : quarisma::irange(instructions.size())) {
+    if (instructions[pc].op == OP && pc < source.size()) {
+      paths->ops[pc] = scalarOpOf(source[pc]);
+    }
+  }
+  for (size_t pc = 0; pc + 3 < instructions.size(); ++pc) {
+    paths->fused[pc] = isOperandLoad(instructions[pc]) &&
+        isOperandLoad(instructions[pc + 1]) &&
+        paths->ops[pc + 2].kind != ScalarOpKind::None &&
+        instructions[pc + 3].op == STORE;
+  }
+  return paths;
+}
+
+std::shared_ptr<const FastPaths> fastPathsFor(
+    const std::shared_ptr<interpreter::CodeImpl>& code) {
+  struct Entry {
+    std::weak_ptr<interpreter::CodeImpl> code;
+    std::shared_ptr<const FastPaths> paths;
+  };
+  // Per thread so that entering a frame takes no lock. The weak_ptr tells a
+  // live entry from one of a destroyed CodeImpl whose address was reused.
+  thread_local std::unordered_map<const interpreter::CodeImpl*, Entry> cache;
+  auto it = cache.find(code.get());
+  if (it != cache.end() && !it->second.code.owner_before(code) &&
+      !code.owner_before(it->second.code)) {
+    return it->second.paths;
+  }
+  if (cache.size() >= 1024) {
+    for (auto entry = cache.begin(); entry != cache.end();) {
+      entry = entry->second.code.expired() ? cache.erase(entry) : ++entry;
+    }
+  }
+  auto paths = buildFastPaths(*code);
+  cache[code.get()] = Entry{code, paths};
+  return paths;
+}
 } // namespace
 
 static thread_local InterpreterStateImpl* tls_int_state_ptr_ = nullptr;
@@ -128,11 +316,24 @@ bool in_torchscript_runtime() {
 
 // InterpreterState state that and used to compute a Code
 struct InterpreterStateImpl : quarisma::intrusive_ptr_target {
-  InterpreterStateImpl(const Code& code, TaskLauncher taskLauncher)
-      : taskLauncher_(std::move(taskLauncher)) {
+  InterpreterStateImpl(
+      const Code& code,
+      TaskLauncher taskLauncher,
+      std::shared_ptr<MemoryArenaPlan> memoryPlan = nullptr)
+      : taskLauncher_(std::move(taskLauncher)),
+        memory_plan_(std::move(memoryPlan)) {
+    if (memory_plan_) {
+      memory_arena_ = memory_plan_->acquire();
+    }
     enterFrame(code, 0);
   }
 
+  ~InterpreterStateImpl() override {
+    if (memory_arena_ != nullptr) {
+      memory_plan_->recycle(memory_arena_);
+    }
+  }
+
  private:
   using Frame = torch::jit::interpreter::Frame;
   struct WarnedNodes {
@@ -174,6 +375,14 @@ struct InterpreterStateImpl : quarisma::intrusive_ptr_target {
 
   std::vector<Frame> frames;
 
+  // The memory plan of the code of the first frame and the arena of this run,
+  // see Note [Memory planning of execution plans]
+  std::shared_ptr<MemoryArenaPlan> memory_plan_;
+  MemoryArena* memory_arena_ = nullptr;
+
+  // The fast paths of each frame's code, see Note [Interpreter fast paths]
+  std::vector<std::shared_ptr<const FastPaths>> frame_fast_paths_;
+
   quarisma::intrusive_ptr<InterpreterStateImpl> intrusive_from_this() {
     quarisma::raw::intrusive_ptr::incref(this);
     return quarisma::intrusive_ptr<InterpreterStateImpl>::reclaim(this);
@@ -181,12 +390,49 @@ struct InterpreterStateImpl : quarisma::intrusive_ptr_target {
 
   void enterFrame(const Code& code, size_t base_pointer) {
     frames.emplace_back(Frame{code.pImpl, 0, base_pointer, std::nullopt});
+    frame_fast_paths_.emplace_back(fastPathsFor(code.pImpl));
     registers.resize(registers.size() + code.pImpl->register_size_);
   }
 
   void leaveFrame() {
     registers.resize(registers.size() - frames.back().function->register_size_);
     frames.pop_back();
+    frame_fast_paths_.pop_back();
+  }
+
+  // The block of the arena where the OP at frame.pc allocates its output, see
+  // Note [Memory planning of execution plans]
+  const PlannedTensor* plannedOutput(const Frame& frame) const {
+    return memory_arena_ != nullptr && frames.size() == 1
+        ? memory_plan_->at(frame.pc)
+        : nullptr;
+  }
+
+  const IValue& operand(const Frame& frame, const Instruction& inst) {
+    return inst.op == LOADC ? frame.function->constant_table_[inst.X]
+                            : reg(inst.X);
+  }
+
+  // Runs the fused sequence starting at frame.pc, see
+  // Note [Interpreter fast paths]. Returns false, having changed nothing,
+  // when the operands do not have the static types of the op.
+  bool runFusedScalarOp(const Frame& frame, const FastPaths& paths) {
+    const Instruction* seq = &frame.function->instructions_[frame.pc];
+    IValue result;
+    if (!applyScalarOp(
+            paths.ops[frame.pc + 2],
+            operand(frame, seq[0]),
+            operand(frame, seq[1]),
+            result)) {
+      return false;
+    }
+    for (const auto i : {0, 1}) {
+      if (seq[i].op == MOVE) {
+        reg(seq[i].X) = IValue();
+      }
+    }
+    reg(seq[3].X) = std::move(result);
+    return true;
   }
 
   void callFunction(
@@ -310,6 +556,7 @@ struct InterpreterStateImpl : quarisma::intrusive_ptr_target {
     try {
       while (true) {
         Frame& frame = frames.back();
+        const FastPaths& fastPaths = *frame_fast_paths_.back();
 
         auto instFetch = [&](auto x) {
           return frame.function->instructions_[frame.pc += x];
@@ -351,7 +598,20 @@ struct InterpreterStateImpl : quarisma::intrusive_ptr_target {
             continue;
           }
           case INST(OP): {
+            if constexpr (!EnableProfiling) {
+              const ScalarOp& scalarOp = fastPaths.ops[frame.pc];
+              auto top = stack.end();
+              if (scalarOp.kind != ScalarOpKind::None &&
+                  applyScalarOp(scalarOp, top[-2], top[-1], top[-2])) {
+                stack.pop_back();
+                INST_NEXT;
+              }
+            }
             [[maybe_unused]] auto _ = instGuard();
+            std::optional<PlannedOutputGuard> outputGuard;
+            if (const PlannedTensor* planned = plannedOutput(frame)) {
+              outputGuard.emplace(*memory_arena_, *planned);
+            }
             auto stackSizeGuard = stackSizeAssertGuard();
             frame.function->operator_table_[inst.X](stack);
             stackSizeGuard.callAssert();
@@ -360,17 +620,35 @@ struct InterpreterStateImpl : quarisma::intrusive_ptr_target {
           case INST(OPN): {
             [[maybe_unused]] auto _ = instGuard();
             stack.emplace_back(inst.N);
+            std::optional<PlannedOutputGuard> outputGuard;
+            if (const PlannedTensor* planned = plannedOutput(frame)) {
+              outputGuard.emplace(*memory_arena_, *planned);
+            }
             auto stackSizeGuard = stackSizeAssertGuard();
             frame.function->operator_table_[inst.X](stack);
             stackSizeGuard.callAssert();
           }
             INST_NEXT;
           case INST(LOAD): {
+            if constexpr (!EnableProfiling) {
+              if (fastPaths.fused[frame.pc] &&
+                  runFusedScalarOp(frame, fastPaths)) {
+                frame.pc += 3;
+                INST_NEXT;
+              }
+            }
             [[maybe_unused]] auto _ = instGuard();
             stack.emplace_back(reg(inst.X));
           }
             INST_NEXT;
           case INST(MOVE): {
+            if constexpr (!EnableProfiling) {
+              if (fastPaths.fused[frame.pc] &&
+                  runFusedScalarOp(frame, fastPaths)) {
+                frame.pc += 3;
+                INST_NEXT;
+              }
+            }
             [[maybe_unused]] auto _ = instGuard();
             stack.emplace_back(std::move(reg(inst.X)));
           }
@@ -399,6 +677,13 @@ struct InterpreterStateImpl : quarisma::intrusive_ptr_target {
           }
             INST_NEXT;
           case INST(LOADC): {
+            if constexpr (!EnableProfiling) {
+              if (fastPaths.fused[frame.pc] &&
+                  runFusedScalarOp(frame, fastPaths)) {
+                frame.pc += 3;
+                INST_NEXT;
+              }
+            }
             [[maybe_unused]] auto _ = instGuard();
             stack.emplace_back(frame.function->constant_table_[inst.X]);
           }
@@ -1228,10 +1513,14 @@ std::shared_ptr<Graph> Code::graph() const {
   return pImpl->preprocess_.graph;
 }
 
-InterpreterState::InterpreterState(const Code& code, TaskLauncher taskLauncher)
+InterpreterState::InterpreterState(
+    const Code& code,
+    TaskLauncher taskLauncher,
+    std::shared_ptr<MemoryArenaPlan> memory_plan)
     : pImpl(quarisma::make_intrusive<InterpreterStateImpl>(
           code,
-          std::move(taskLauncher))) {}
+          std::move(taskLauncher),
+          std::move(memory_plan))) {}
 
 void InterpreterState::run(Stack& stack) {
   static_cast<InterpreterStateImpl*>(pImpl.get())->run(stack);
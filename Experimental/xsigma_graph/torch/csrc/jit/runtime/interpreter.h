@@ -37,6 +37,7 @@ struct CodeImpl;
 struct Node;
 struct GraphExecutor;
 struct InterpreterStateImpl;
+class MemoryArenaPlan;
 struct Graph;
 struct Node;
 struct Instruction;
@@ -93,7 +94,12 @@ struct TORCH_API MobileCode : Code
 
 struct InterpreterState
 {
-    TORCH_API      InterpreterState(const Code& code, TaskLauncher taskLauncher = quarisma::launch);
+    // memory_plan places the planned outputs of code in an arena, see
+    // Note [Memory planning of execution plans]
+    TORCH_API InterpreterState(
+        const Code&                      code,
+        TaskLauncher                     taskLauncher = quarisma::launch,
+        std::shared_ptr<MemoryArenaPlan> memory_plan  = nullptr);
     TORCH_API void run(Stack& stack);
     TORCH_API quarisma::intrusive_ptr<Future> runAsync(Stack& stack);
     quarisma::intrusive_ptr<Future>           getFuture();
@@ -0,0 +1,106 @@
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/runtime/instruction.h>
+#include <torch/csrc/jit/runtime/memory_arena.h>
+#include <quarisma/util/irange.h>
+
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "util/exception.h"
+
+// clang-format off
+QUARISMA_DEFINE_bool(
+    torch_jit_enable_memory_planning,
+    false,
+    "Place the statically shaped intermediate tensors of optimized graphs in one arena per run, see Note [Memory planning of execution plans]")
+
+namespace torch::jit {
+
+MemoryArena::MemoryArena(size_t size)
+    : storage_(new std::byte[size + kMemoryPlanAlignment]) {
+  void* base = storage_.get();
+  size_t space = size + kMemoryPlanAlignment;
+  data_ = static_cast<std::byte*>(
+      std::align(kMemoryPlanAlignment, size, base, space));
+  QUARISMA_CHECK(data_ != nullptr, "Cannot align an arena of ", size, " bytes");
+}
+
+void MemoryArena::release(void* arena) {
+  auto* self = static_cast<MemoryArena*>(arena);
+  if (self->refcount_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete self;
+  }
+}
+
+std::shared_ptr<MemoryArenaPlan> MemoryArenaPlan::create(const Code& code) {
+  if (!FLAGS_torch_jit_enable_memory_planning || !code) {
+    return nullptr;
+  }
+  auto plan = PlanMemory(code.graph());
+  if (plan.tensors.empty()) {
+    return nullptr;
+  }
+  return std::make_shared<MemoryArenaPlan>(code, std::move(plan));
+}
+
+MemoryArenaPlan::MemoryArenaPlan(const Code& code, MemoryPlan plan)
+    : plan_(std::move(plan)) {
+  std::unordered_map<const Node*, int32_t> tensor_of_node;
+  for (const auto i : quarisma::irange(plan_.tensors.size())) {
+    tensor_of_node.emplace(plan_.tensors[i].node, static_cast<int32_t>(i));
+  }
+  const auto& instructions = code.instructions();
+  const auto& source = code.instructions_source();
+  tensor_of_pc_.assign(instructions.size(), -1);
+  for (const auto pc : quarisma::irange(instructions.size())) {
+    if (instructions[pc].op != OP && instructions[pc].op != OPN) {
+      continue;
+    }
+    auto it = tensor_of_node.find(source[pc]);
+    if (it != tensor_of_node.end()) {
+      tensor_of_pc_[pc] = it->second;
+    }
+  }
+  GRAPH_DEBUG(
+      "Memory plan of ",
+      plan_.tensors.size(),
+      " tensors in ",
+      plan_.arena_size,
+      " bytes (",
+      plan_.total_size,
+      " without sharing)");
+}
+
+MemoryArenaPlan::~MemoryArenaPlan() {
+  for (MemoryArena* arena : free_arenas_) {
+    MemoryArena::release(arena);
+  }
+}
+
+MemoryArena* MemoryArenaPlan::acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_arenas_.empty()) {
+      MemoryArena* arena = free_arenas_.back();
+      free_arenas_.pop_back();
+      return arena;
+    }
+  }
+  return new MemoryArena(plan_.arena_size);
+}
+
+void MemoryArenaPlan::recycle(MemoryArena* arena) {
+  // Once unique, no tensor can take a new reference to the arena
+  if (arena->unique()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Enough for the runs of the plan that can be in flight at once
+    if (free_arenas_.size() < std::thread::hardware_concurrency()) {
+      free_arenas_.push_back(arena);
+      return;
+    }
+  }
+  MemoryArena::release(arena);
+}
+
+} // namespace torch::jit
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <c10/core/CPUAllocator.h>
+#include <torch/csrc/Export.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <torch/csrc/jit/runtime/interpreter.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+TORCH_DECLARE_bool(torch_jit_enable_memory_planning);
+
+namespace torch::jit
+{
+
+// Note [Memory planning of execution plans]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// With torch_jit_enable_memory_planning, an ExecutionPlan runs PlanMemory on
+// the graph of its code. Execution plans are specialized to the shapes of
+// their inputs (per ArgumentSpec in the legacy executor, behind the profiled
+// type checks in the profiling executor), so the plan is computed once per
+// input-shape signature. Each run of the plan takes one MemoryArena, and while
+// the interpreter runs the OP of a planned node it sets the node's block of the
+// arena as the PlannedCPUAllocation of the thread, from which the CPU
+// allocator serves the output of the node. An allocation of another size,
+// such as a temporary of the operator, goes to the heap.
+//
+// Tensors keep their arena alive: it is reused by a later run once every
+// tensor of the previous one is freed, and freed otherwise with the last of
+// them.
+
+class TORCH_API MemoryArena
+{
+public:
+    explicit MemoryArena(size_t size);
+
+    std::byte* data() const { return data_; }
+
+    // Whether nothing but the run holds the arena
+    bool unique() const { return refcount_.load(std::memory_order_acquire) == 1; }
+
+    void retain() { refcount_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Drops a reference to arena, a MemoryArena*, deletes it with the last one
+    static void release(void* arena);
+
+private:
+    std::atomic<size_t>          refcount_{1};
+    std::unique_ptr<std::byte[]> storage_;
+    std::byte*                   data_ = nullptr;
+};
+
+class TORCH_API MemoryArenaPlan
+{
+public:
+    // nullptr when memory planning is disabled or nothing is planned in the
+    // graph of code
+    static std::shared_ptr<MemoryArenaPlan> create(const Code& code);
+
+    MemoryArenaPlan(const Code& code, MemoryPlan plan);
+    ~MemoryArenaPlan();
+
+    // The planned output of the instruction at pc, nullptr when it has none
+    const PlannedTensor* at(size_t pc) const
+    {
+        return pc < tensor_of_pc_.size() && tensor_of_pc_[pc] >= 0
+                   ? &plan_.tensors[tensor_of_pc_[pc]]
+                   : nullptr;
+    }
+
+    size_t arenaSize() const { return plan_.arena_size; }
+
+    // An arena for one run, held by the caller until it calls recycle
+    MemoryArena* acquire();
+    void         recycle(MemoryArena* arena);
+
+private:
+    MemoryPlan           plan_;
+    std::vector<int32_t> tensor_of_pc_;  // index in plan_.tensors, -1 if none
+
+    std::mutex                mutex_;
+    std::vector<MemoryArena*> free_arenas_;
+};
+
+// Serves the output of a planned node from its block of arena during the scope
+class PlannedOutputGuard
+{
+public:
+    PlannedOutputGuard(MemoryArena& arena, const PlannedTensor& tensor)
+        : allocation_{arena.data() + tensor.offset, tensor.nbytes, &arena, &MemoryArena::release}
+    {
+        // The reference of the output, dropped here if it goes to the heap
+        arena.retain();
+        prev_ = c10::SetPlannedCPUAllocation(&allocation_);
+    }
+
+    ~PlannedOutputGuard()
+    {
+        c10::SetPlannedCPUAllocation(prev_);
+        if (allocation_.data != nullptr)
+        {
+            MemoryArena::release(allocation_.context);
+        }
+    }
+
+    PlannedOutputGuard(const PlannedOutputGuard&)            = delete;
+    PlannedOutputGuard& operator=(const PlannedOutputGuard&) = delete;
+
+private:
+    c10::PlannedCPUAllocation  allocation_;
+    c10::PlannedCPUAllocation* prev_ = nullptr;
+};
+
+}  // namespace torch::jit
@@ -0,0 +1,433 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "model_runner.h"
+
+#include <exception>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#if QUARISMA_HAS_CUDA
+#include <cuda_runtime.h>
+
+#include "memory/gpu/cuda_pinned_host_allocator.h"
+#endif
+
+#include "parallel/std_thread/parallel_thread_pool.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace aoti
+{
+namespace
+{
+void* open_library(const std::string& path)
+{
+#if defined(_WIN32)
+    return reinterpret_cast<void*>(LoadLibraryA(path.c_str()));
+#else
+    return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+void* find_symbol(void* library, const char* name)
+{
+#if defined(_WIN32)
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(library), name));
+#else
+    return dlsym(library, name);
+#endif
+}
+
+void close_library(void* library)
+{
+    if (library == nullptr)
+    {
+        return;
+    }
+#if defined(_WIN32)
+    FreeLibrary(static_cast<HMODULE>(library));
+#else
+    dlclose(library);
+#endif
+}
+
+std::string last_library_error()
+{
+#if defined(_WIN32)
+    return "error " + std::to_string(GetLastError());
+#else
+    const char* error = dlerror();
+    return error != nullptr ? error : "unknown error";
+#endif
+}
+
+bool is_cuda(const std::string& device)
+{
+    return device.compare(0, 4, "cuda") == 0;
+}
+
+#if QUARISMA_HAS_CUDA
+int cuda_device_index(const std::string& device)
+{
+    size_t const colon = device.find(':');
+    return colon == std::string::npos ? 0 : std::stoi(device.substr(colon + 1));
+}
+
+void check_cuda(cudaError_t error, const char* what)
+{
+    QUARISMA_CHECK(error == cudaSuccess, what, " failed: ", cudaGetErrorString(error));
+}
+#endif
+}  // namespace
+
+// The container entry points of the model library, resolved by name
+struct model_runner::api
+{
+    decltype(&AOTInductorModelContainerCreateWithDevice) create      = nullptr;
+    decltype(&AOTInductorModelContainerDelete)           destroy     = nullptr;
+    decltype(&AOTInductorModelContainerRun)              run         = nullptr;
+    decltype(&AOTInductorModelContainerGetNumInputs)     num_inputs  = nullptr;
+    decltype(&AOTInductorModelContainerGetNumOutputs)    num_outputs = nullptr;
+};
+
+struct model_runner::instance
+{
+    AOTInductorModelContainerHandle container = nullptr;
+    instance_context                context;
+};
+
+model_runner::model_runner(Options options) : options_(std::move(options))
+{
+    QUARISMA_CHECK(options_.instances > 0, "model_runner needs at least one instance");
+    QUARISMA_CHECK(options_.max_batch > 0, "model_runner max_batch must be positive");
+    QUARISMA_CHECK(
+        options_.max_batch == 1 || (options_.collate && options_.split),
+        "model_runner batching needs both the collate and split hooks");
+#if !QUARISMA_HAS_CUDA
+    QUARISMA_CHECK(
+        !is_cuda(options_.device),
+        "model_runner built without CUDA cannot serve ",
+        options_.device);
+#endif
+
+    library_ = open_library(options_.library);
+    QUARISMA_CHECK(
+        library_ != nullptr,
+        "Cannot load model library ",
+        options_.library,
+        ": ",
+        last_library_error());
+
+    api_         = std::make_unique<api>();
+    auto resolve = [this](auto& fn, const char* name)
+    {
+        fn = reinterpret_cast<std::remove_reference_t<decltype(fn)>>(find_symbol(library_, name));
+        QUARISMA_CHECK(fn != nullptr, "Model library ", options_.library, " lacks ", name);
+    };
+    try
+    {
+        resolve(api_->create, "AOTInductorModelContainerCreateWithDevice");
+        resolve(api_->destroy, "AOTInductorModelContainerDelete");
+        resolve(api_->run, "AOTInductorModelContainerRun");
+        resolve(api_->num_inputs, "AOTInductorModelContainerGetNumInputs");
+        resolve(api_->num_outputs, "AOTInductorModelContainerGetNumOutputs");
+
+        const char* const cubin_dir =
+            options_.cubin_dir.empty() ? nullptr : options_.cubin_dir.c_str();
+        instances_.reserve(options_.instances);
+        for (size_t i = 0; i < options_.instances; ++i)
+        {
+            // One model per container: every instance owns its constants and activations
+            auto inst           = std::make_unique<instance>();
+            inst->context.index = i;
+            QUARISMA_CHECK(
+                api_->create(&inst->container, 1, options_.device.c_str(), cubin_dir) ==
+                    AOTI_RUNTIME_SUCCESS,
+                "Cannot create instance ",
+                i,
+                " of ",
+                options_.library,
+                " on ",
+                options_.device);
+            instances_.push_back(std::move(inst));
+
+#if QUARISMA_HAS_CUDA
+            if (is_cuda(options_.device))
+            {
+                instance_context& context = instances_.back()->context;
+                check_cuda(cudaSetDevice(cuda_device_index(options_.device)), "cudaSetDevice");
+                cudaStream_t stream = nullptr;
+                check_cuda(
+                    cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking),
+                    "cudaStreamCreateWithFlags");
+                context.stream = stream;
+                if (options_.pinned_bytes > 0)
+                {
+                    context.pinned = gpu::cuda_pinned_host_allocator::instance().allocate(
+                        options_.pinned_bytes);
+                    context.pinned_bytes = options_.pinned_bytes;
+                }
+            }
+#endif
+        }
+
+        AOTInductorModelContainerHandle const first = instances_.front()->container;
+        QUARISMA_CHECK(
+            api_->num_inputs(first, &num_inputs_) == AOTI_RUNTIME_SUCCESS &&
+                api_->num_outputs(first, &num_outputs_) == AOTI_RUNTIME_SUCCESS,
+            "Cannot query the signature of ",
+            options_.library);
+    }
+    catch (...)
+    {
+        for (auto& inst : instances_)
+        {
+#if QUARISMA_HAS_CUDA
+            gpu::cuda_pinned_host_allocator::instance().deallocate(inst->context.pinned);
+            if (inst->context.stream != nullptr)
+            {
+                cudaStreamDestroy(static_cast<cudaStream_t>(inst->context.stream));
+            }
+#endif
+            api_->destroy(inst->container);
+        }
+        instances_.clear();
+        close_library(library_);
+        throw;
+    }
+
+    free_.reserve(instances_.size());
+    for (auto it = instances_.rbegin(); it != instances_.rend(); ++it)
+    {
+        free_.push_back(it->get());
+    }
+}
+
+model_runner::~model_runner()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(
+            lock, [this] { return free_.size() == instances_.size() && queue_.empty(); });
+    }
+
+    for (auto& inst : instances_)
+    {
+#if QUARISMA_HAS_CUDA
+        if (inst->context.stream != nullptr)
+        {
+            auto* const stream = static_cast<cudaStream_t>(inst->context.stream);
+            cudaStreamSynchronize(stream);
+            gpu::cuda_pinned_host_allocator::instance().deallocate(inst->context.pinned);
+            cudaStreamDestroy(stream);
+        }
+#endif
+        api_->destroy(inst->container);
+    }
+    close_library(library_);
+}
+
+std::future<model_runner::tensor_list> model_runner::submit(tensor_list inputs)
+{
+    QUARISMA_CHECK(
+        inputs.size() == num_inputs_ || options_.max_batch > 1,
+        "model_runner expects ",
+        num_inputs_,
+        " inputs, got ",
+        inputs.size());
+
+    request req;
+    req.inputs = std::move(inputs);
+    req.queued = std::chrono::steady_clock::now();
+    std::future<tensor_list> result = req.result.get_future();
+
+    instance* inst = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(req));
+        ++requests_;
+        if (!free_.empty())
+        {
+            inst = free_.back();
+            free_.pop_back();
+        }
+    }
+    if (inst != nullptr)
+    {
+        detail::parallel::parallel_thread_pool::instance().post([this, inst] { serve(*inst); });
+    }
+    else
+    {
+        // A busy instance collecting a batch may take the request
+        arrived_.notify_one();
+    }
+    return result;
+}
+
+model_runner::stats model_runner::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats s;
+    s.requests = requests_;
+    s.runs     = runs_;
+    s.failures = failures_;
+    s.queued   = queue_.size();
+    return s;
+}
+
+void model_runner::serve(instance& inst)
+{
+    std::vector<request> batch;
+    for (;;)
+    {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (queue_.empty())
+            {
+                free_.push_back(&inst);
+                idle_.notify_all();
+                return;
+            }
+
+            if (options_.max_batch > 1 && queue_.size() < options_.max_batch &&
+                options_.batch_window.count() > 0)
+            {
+                auto const deadline = queue_.front().queued + options_.batch_window;
+                arrived_.wait_until(
+                    lock, deadline, [this] { return queue_.size() >= options_.max_batch; });
+            }
+
+            // Another instance may have drained the queue while this one waited
+            while (!queue_.empty() && batch.size() < options_.max_batch)
+            {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+        if (!batch.empty())
+        {
+            run_requests(inst, batch);
+        }
+    }
+}
+
+void model_runner::run_requests(instance& inst, std::vector<request>& batch)
+{
+    bool const batched = options_.max_batch > 1;
+    try
+    {
+        tensor_list inputs;
+        if (batched)
+        {
+            std::vector<tensor_list> requests;
+            requests.reserve(batch.size());
+            for (auto& req : batch)
+            {
+                requests.push_back(std::move(req.inputs));
+            }
+            inputs = options_.collate(requests, inst.context);
+        }
+        else
+        {
+            inputs = std::move(batch.front().inputs);
+        }
+        QUARISMA_CHECK(
+            inputs.size() == num_inputs_,
+            "model_runner collated ",
+            inputs.size(),
+            " inputs, the model takes ",
+            num_inputs_);
+
+        tensor_list outputs(num_outputs_, nullptr);
+        AOTIRuntimeError const error = api_->run(
+            inst.container,
+            inputs.data(),
+            inputs.size(),
+            outputs.data(),
+            outputs.size(),
+            static_cast<AOTInductorStreamHandle>(inst.context.stream),
+            nullptr);
+        QUARISMA_CHECK(
+            error == AOTI_RUNTIME_SUCCESS, "Instance ", inst.context.index, " failed to run");
+
+#if QUARISMA_HAS_CUDA
+        if (inst.context.stream != nullptr)
+        {
+            // Callers read the outputs from other streams
+            check_cuda(
+                cudaStreamSynchronize(static_cast<cudaStream_t>(inst.context.stream)),
+                "cudaStreamSynchronize");
+        }
+#endif
+
+        if (batched)
+        {
+            std::vector<tensor_list> results = options_.split(outputs, batch.size(), inst.context);
+            QUARISMA_CHECK(
+                results.size() == batch.size(),
+                "model_runner split ",
+                results.size(),
+                " results for ",
+                batch.size(),
+                " requests");
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                batch[i].result.set_value(std::move(results[i]));
+            }
+        }
+        else
+        {
+            batch.front().result.set_value(std::move(outputs));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++runs_;
+    }
+    catch (...)
+    {
+        std::exception_ptr const error = std::current_exception();
+        for (auto& req : batch)
+        {
+            try
+            {
+                req.result.set_exception(error);
+            }
+            catch (const std::future_error&)
+            {
+                // Already satisfied before the failure
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++runs_;
+        ++failures_;
+    }
+}
+
+}  // namespace aoti
+}  // namespace quarisma
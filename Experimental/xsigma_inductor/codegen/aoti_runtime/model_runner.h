@@ -0,0 +1,183 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <torch/csrc/inductor/aoti_runtime/interface.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace quarisma
+{
+namespace aoti
+{
+
+/**
+ * @brief The resources of one model instance, as seen by the batching hooks
+ */
+struct instance_context
+{
+    size_t index  = 0;
+    void*  stream = nullptr;  ///< cudaStream_t the instance runs on; nullptr on CPU
+
+    /// Page-locked host buffer of Options::pinned_bytes, for staging host inputs
+    void*  pinned       = nullptr;
+    size_t pinned_bytes = 0;
+};
+
+/**
+ * @brief Serves an AOT-compiled model from a pool of instances
+ *
+ * The model library produced by AOTInductor is loaded once, and
+ * Options::instances containers are created from it, each holding a single
+ * model with its own constants and preallocated activation buffers. The
+ * instances share nothing, so they run concurrently: a request never waits
+ * for another instance's run, only for a free instance.
+ *
+ * Requests queue in submit() and are served by jobs posted to the
+ * parallel_thread_pool, one per busy instance; a job serves requests until
+ * the queue is empty, then returns its instance. With Options::max_batch
+ * above 1 and the collate and split hooks set, a job takes up to max_batch
+ * queued requests, waiting up to Options::batch_window for them, and runs
+ * them as one batch.
+ *
+ * On CUDA each instance has a stream of its own and, if
+ * Options::pinned_bytes is set, a page-locked staging buffer from
+ * cuda_pinned_host_allocator for the collate hook to copy host inputs
+ * through. Results are returned once their stream is synchronized.
+ *
+ * Example:
+ * @code
+ * aoti::model_runner::Options opts;
+ * opts.library   = "/models/pricer.so";
+ * opts.device    = "cuda";
+ * opts.instances = 4;
+ * aoti::model_runner runner(opts);
+ * std::future<aoti::model_runner::tensor_list> outputs = runner.submit(std::move(inputs));
+ * @endcode
+ *
+ * **Thread Safety**: submit() and run() may be called from any thread.
+ */
+class model_runner
+{
+public:
+    /// Tensor handles, owned by whoever holds the list
+    using tensor_list = std::vector<AtenTensorHandle>;
+
+    /// Merges the inputs of several requests into the inputs of one run
+    using collate_fn =
+        std::function<tensor_list(std::vector<tensor_list>& requests, const instance_context&)>;
+
+    /// Splits the outputs of a batched run into one output list per request
+    using split_fn = std::function<std::vector<tensor_list>(
+        tensor_list& outputs, size_t requests, const instance_context&)>;
+
+    struct Options
+    {
+        std::string library;           ///< Shared library compiled by AOTInductor
+        std::string device = "cpu";    ///< "cpu", "cuda" or "cuda:<index>"
+        std::string cubin_dir;         ///< Directory of the CUDA kernels, if not the default
+        size_t      instances = 4;     ///< Model instances, i.e. concurrent runs
+        size_t      max_batch = 1;     ///< Requests per run; above 1 needs collate and split
+        std::chrono::microseconds batch_window{0};  ///< Wait for a batch to fill
+        size_t                    pinned_bytes = 0;  ///< Staging buffer per CUDA instance
+        collate_fn                collate;
+        split_fn                  split;
+    };
+
+    struct stats
+    {
+        uint64_t requests = 0;
+        uint64_t runs     = 0;
+        uint64_t failures = 0;  ///< Runs that threw or returned an error
+        uint64_t queued   = 0;  ///< Requests waiting for an instance now
+    };
+
+    /**
+     * @brief Loads the library and creates the instances
+     * @throws quarisma::Error if the library or one of its entry points
+     *         cannot be loaded, or an instance cannot be created
+     */
+    explicit model_runner(Options options);
+
+    /// Waits for the queued requests, then releases the instances and the library
+    ~model_runner();
+
+    model_runner(const model_runner&)            = delete;
+    model_runner& operator=(const model_runner&) = delete;
+
+    /**
+     * @brief Queues a request
+     *
+     * The input handles are stolen, as by AOTInductorModelContainerRun; the
+     * output handles of the result belong to the caller.
+     */
+    std::future<tensor_list> submit(tensor_list inputs);
+
+    /// submit() and wait
+    tensor_list run(tensor_list inputs) { return submit(std::move(inputs)).get(); }
+
+    size_t num_inputs() const noexcept { return num_inputs_; }
+    size_t num_outputs() const noexcept { return num_outputs_; }
+    size_t num_instances() const noexcept { return instances_.size(); }
+
+    stats statistics() const;
+
+private:
+    struct api;
+    struct instance;
+    struct request
+    {
+        tensor_list                      inputs;
+        std::promise<tensor_list>        result;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    void serve(instance& inst);
+    void run_requests(instance& inst, std::vector<request>& batch);
+
+    Options                                options_;
+    void*                                  library_ = nullptr;
+    std::unique_ptr<api>                   api_;
+    std::vector<std::unique_ptr<instance>> instances_;
+    size_t                                 num_inputs_  = 0;
+    size_t                                 num_outputs_ = 0;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable arrived_;  // A request was queued
+    std::condition_variable idle_;     // An instance was returned
+    std::deque<request>     queue_;
+    std::vector<instance*>  free_;
+    uint64_t                requests_ = 0;
+    uint64_t                runs_     = 0;
+    uint64_t                failures_ = 0;
+};
+
+}  // namespace aoti
+}  // namespace quarisma
@@ -8,6 +8,7 @@
 #include <quarisma/util/flat_hash_map.h>
 #include <quarisma/util/irange.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -246,16 +247,23 @@ struct AliasDb::WriteRegistry
 };
 
 AliasDb::AliasDb(std::shared_ptr<Graph> graph, bool isFrozen, bool descendFunctionCalls)
-    : graph_(std::move(graph)),
-      isFrozen_(isFrozen),
-      descend_function_calls_(descendFunctionCalls),
-      memoryDAGBuilder_(std::make_unique<MemoryDAGBuilder>()),
-      writeRegistry_(std::make_unique<AliasDb::WriteRegistry>())
+    : graph_(std::move(graph)), isFrozen_(isFrozen), descend_function_calls_(descendFunctionCalls)
 {
+    build();
+}
+
+void AliasDb::build()
+{
+    memoryDAGBuilder_ = std::make_unique<MemoryDAGBuilder>();
+    writeRegistry_    = std::make_unique<AliasDb::WriteRegistry>();
+    elementMap_.clear();
+    wildcardIndex_.clear();
+    wildcards_.clear();
+    function_call_copies_.clear();
+
     analyze(graph_);
 
     memoryDAG_ = std::move(*memoryDAGBuilder_).createMemoryDAG();
-    // NOLINTNEXTLINE(cppcoreguidelines-prefer-member-initializer)
     memoryDAGBuilder_ = nullptr;  // to make further access a hard error
 
     memoryDAG_->setWildcards(
@@ -265,9 +273,21 @@ AliasDb::AliasDb(std::shared_ptr<Graph> graph, bool isFrozen, bool descendFuncti
 
     // Now we build up the various write indices based on information in the write
     // registry that we populated during analysis
+    writeIndex_ = TWriteIndex();
+    indexWrites();
+
+    // Now that we've built the write index, we can null out the WriteRegistry to
+    // make future access an error. In this way we prevent the index from getting
+    // out of sync (writes of new nodes go through addNode())
+    writeRegistry_ = nullptr;
+
+    // Initialize the write cache
+    buildWrittenToLocationsIndex();
+    GRAPH_DEBUG(toString());
+}
 
-    // Initialize the write index
-    writeIndex_      = TWriteIndex();
+void AliasDb::indexWrites()
+{
     auto& writeIndex = *writeIndex_;  // to make operator[] less ugly
 
     // Build the write index
@@ -305,15 +325,177 @@ AliasDb::AliasDb(std::shared_ptr<Graph> graph, bool isFrozen, bool descendFuncti
             writeIndex[write].set(pr.second->index);
         }
     }
+}
 
-    // Now that we've built the write index, we can null out the WriteRegistry to
-    // make future access an error. In this way we prevent the index from getting
-    // out of sync (since we have no way of registering new writes)
+void AliasDb::rebuild()
+{
+    GRAPH_DEBUG("Rebuilding AliasDb");
+    build();
+}
+
+void AliasDb::addNode(Node* n)
+{
+    // Reopen the DAG and run the analysis over `n` alone. New wildcards are
+    // collected apart, to be set on the DAG like build() does for all of them.
+    memoryDAGBuilder_ = std::make_unique<MemoryDAGBuilder>(std::move(*memoryDAG_));
+    writeRegistry_    = std::make_unique<AliasDb::WriteRegistry>();
+    std::unordered_set<const Value*> newWildcards;
+    std::swap(newWildcards, wildcards_);
+
+    analyze(n);
+
+    std::swap(newWildcards, wildcards_);
+    wildcards_.insert(newWildcards.begin(), newWildcards.end());
+    bool           affectsExisting = memoryDAGBuilder_->modifiedExistingElements();
+    unsigned const firstNewIndex   = memoryDAGBuilder_->firstNewIndex();
+    memoryDAG_                     = std::move(*memoryDAGBuilder_).createMemoryDAG();
+    memoryDAGBuilder_              = nullptr;
+
+    // A new wildcard makes its memory locations point to the wildcard element,
+    // which is only safe for locations nothing analyzed before can reach
+    for (const Value* v : newWildcards)
+    {
+        for (const auto loc : memoryDAG_->getMemoryLocations(elementMap_.quarisma(v)))
+        {
+            affectsExisting |= loc < firstNewIndex;
+        }
+    }
+    if (affectsExisting)
+    {
+        writeRegistry_ = nullptr;
+        rebuild();
+        return;
+    }
+
+    if (!newWildcards.empty())
+    {
+        memoryDAG_->setWildcards(
+            newWildcards,
+            elementMap_,
+            [&](const Value* v) -> Element* { return getWildcard(v->type()); });
+    }
+    indexWrites();
+    // Only the entries of `n` and its sub-blocks can have grown
+    auto addWritten = [&](Node* writer)
+    { *writtenToLocationsIndex_ |= writeIndex_->quarisma(writer); };
+    for (const auto& write : writeRegistry_->writes_)
+    {
+        addWritten(write.first);
+    }
+    for (const auto& write : writeRegistry_->containedWrites_)
+    {
+        addWritten(write.first);
+    }
+    for (Node* writer : writeRegistry_->writesToAllWildcards_)
+    {
+        addWritten(writer);
+    }
     writeRegistry_ = nullptr;
+}
 
-    // Initialize the write cache
-    buildWrittenToLocationsIndex();
-    GRAPH_DEBUG(toString());
+void AliasDb::removeValue(const Value* v)
+{
+    // The element stays in the DAG, unreachable from the graph; only its
+    // debug back-reference to `v` has to go
+    auto it = elementMap_.find(v);
+    if (it != elementMap_.end())
+    {
+        it->second->values.erase(v);
+        elementMap_.erase(it);
+    }
+    wildcards_.erase(v);
+}
+
+bool AliasDb::forgetNode(Node* n)
+{
+    bool wrote = writeIndex_->erase(n) > 0;
+    for (auto block : n->blocks())
+    {
+        for (auto param : block->inputs())
+        {
+            removeValue(param);
+        }
+        for (auto node : block->nodes())
+        {
+            wrote |= forgetNode(node);
+        }
+    }
+    for (auto output : n->outputs())
+    {
+        removeValue(output);
+    }
+    return wrote;
+}
+
+void AliasDb::removeNode(Node* n)
+{
+    for (auto output : n->outputs())
+    {
+        TORCH_INTERNAL_ASSERT(!output->hasUses(), "AliasDb::removeNode on a node still in use");
+    }
+    if (forgetNode(n))
+    {
+        buildWrittenToLocationsIndex();
+    }
+}
+
+bool AliasDb::replaceValueInPlace(const Value* existing, const Value* replacement)
+{
+    auto existingIt = elementMap_.find(existing);
+    if (existingIt == elementMap_.end())
+    {
+        return true;
+    }
+    auto replacementIt = elementMap_.find(replacement);
+    if (replacementIt == elementMap_.end())
+    {
+        return false;
+    }
+    Element* const existingElem    = existingIt->second;
+    Element* const replacementElem = replacementIt->second;
+    if (existingElem == replacementElem)
+    {
+        return true;
+    }
+
+    // The element also stands for other values, or its location is the target
+    // of recorded writes, or the replacement reaches it: redirecting the
+    // pointers would lose aliasing information
+    if (existingElem->values.size() > 1 ||
+        (existingElem->pointsTo.empty() &&
+         writtenToLocationsIndex_->test(existingElem->index)) ||
+        existingElem->pointedFrom.test(replacementElem->index) ||
+        replacementElem->containedElements.test(existingElem->index))
+    {
+        return false;
+    }
+    memoryDAG_->unsafeReplaceElement(existingElem, replacementElem);
+    return true;
+}
+
+void AliasDb::replaceNode(Node* existing, Node* replacement)
+{
+    TORCH_INTERNAL_ASSERT(existing->outputs().size() == replacement->outputs().size());
+    bool const known = writeIndex_->count(replacement) ||
+                       std::any_of(
+                           replacement->outputs().begin(),
+                           replacement->outputs().end(),
+                           [&](const Value* v) { return elementMap_.count(v) > 0; });
+    if (!known)
+    {
+        addNode(replacement);
+    }
+
+    bool inPlace = true;
+    for (const auto i : quarisma::irange(existing->outputs().size()))
+    {
+        inPlace &= replaceValueInPlace(existing->outputs()[i], replacement->outputs()[i]);
+    }
+    if (!inPlace)
+    {
+        rebuild();
+    }
+    removeNode(existing);
 }
 
 AliasDb::~AliasDb() = default;
@@ -171,6 +171,27 @@ public:
     // Create a new `value` that does not alias anything else.
     TORCH_API void createValue(const Value* value);
 
+    /**
+   * Node-level updates
+   *
+   * Keep an AliasDb valid across graph rewrites, so that it can be shared by
+   * a pipeline of passes instead of being rebuilt by each of them. Updates
+   * that would change what already-analyzed values may alias fall back to
+   * rebuild().
+   */
+    // Analyze `n`, which was just inserted into the graph.
+    TORCH_API void addNode(Node* n);
+    // Forget `n`, which is about to be destroyed. Its outputs must be unused.
+    TORCH_API void removeNode(Node* n);
+    // Forget `v`, which is about to be erased from its node or block.
+    TORCH_API void removeValue(const Value* v);
+    // The uses of the outputs of `existing` were redirected to the outputs of
+    // `replacement`, and `existing` is about to be destroyed. `replacement` is
+    // analyzed first if the AliasDb does not know it yet.
+    TORCH_API void replaceNode(Node* existing, Node* replacement);
+    // Re-run the analysis over the whole graph.
+    TORCH_API void rebuild();
+
     // Enable more precise treatment of prim::TupleConstruct.
     void enablePreciseTupleContainerAnalysis();
 
@@ -189,6 +210,17 @@ private:
     void move(Node* toMove, Node* movePoint, MoveSide moveSide);
     bool isBeforeOrAfter(const Node* n, MoveSide moveSide) const;
 
+    // Run the analysis over graph_ from scratch.
+    void build();
+    // Add the writes recorded in writeRegistry_ to the write index.
+    void indexWrites();
+    // Forget the values and writes of `n` and its sub-blocks; returns whether
+    // `n` wrote to anything.
+    bool forgetNode(Node* n);
+    // Make the element of `existing` stand for `replacement`'s. Returns false
+    // if that cannot be done in place.
+    bool replaceValueInPlace(const Value* existing, const Value* replacement);
+
     bool isMutableTypeInternal(const Value* v) const;
     bool isMutableTypeInternal(const TypePtr& type) const;
 
@@ -11,7 +11,10 @@
 #include <quarisma/util/irange.h>
 
 #include <algorithm>
+#include <optional>
+#include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "util/exception.h"
@@ -416,35 +419,39 @@ static RegisterOperators mm_batch_side_reg({Operator(
     },
     aliasAnalysisIsSpecialCase())});
 
-static std::pair<std::vector<Node*>, std::vector<Node*>> gatherIndependentMMUses(
-    Value* value, AliasDb& alias_db)
+// Sorts the nodes topologically and drops those that depend on an earlier one
+static std::vector<Node*> filterIndependentNodes(std::vector<Node*> mms, AliasDb& alias_db)
 {
-    const auto postprocess = [&](std::vector<Node*> mms)
+    if (mms.empty())
     {
-        if (mms.empty())
-        {
-            return mms;
-        }
-        std::sort(mms.begin(), mms.end(), [](Node* n, Node* m) { return n->isBefore(m); });
-        // Filter out dependent MMs. This algorithm might do very badly if e.g. you
-        // have a lot of independent MMs, that depend on the first one, but I doubt
-        // this will be a common scenario.
-        for (const auto i : quarisma::irange(mms.size()))
+        return mms;
+    }
+    std::sort(mms.begin(), mms.end(), [](Node* n, Node* m) { return n->isBefore(m); });
+    // Filter out dependent MMs. This algorithm might do very badly if e.g. you
+    // have a lot of independent MMs, that depend on the first one, but I doubt
+    // this will be a common scenario.
+    for (const auto i : quarisma::irange(mms.size()))
+    {
+        if (mms[i] == nullptr)
+            continue;
+        for (size_t j = i + 1; j < mms.size(); ++j)
         {
-            if (mms[i] == nullptr)
+            if (mms[j] == nullptr)
                 continue;
-            for (size_t j = i + 1; j < mms.size(); ++j)
+            if (!alias_db.couldMoveBeforeTopologically(mms[j], mms[i]))
             {
-                if (mms[j] == nullptr)
-                    continue;
-                if (!alias_db.couldMoveBeforeTopologically(mms[j], mms[i]))
-                {
-                    mms[j] = nullptr;
-                }
+                mms[j] = nullptr;
             }
         }
-        return quarisma::filter(mms, [](Node* n) { return n != nullptr; });
-    };
+    }
+    return quarisma::filter(mms, [](Node* n) { return n != nullptr; });
+}
+
+static std::pair<std::vector<Node*>, std::vector<Node*>> gatherIndependentMMUses(
+    Value* value, AliasDb& alias_db)
+{
+    const auto postprocess = [&](std::vector<Node*> mms)
+    { return filterIndependentNodes(std::move(mms), alias_db); };
 
     Block*             block = value->node()->owningBlock();
     std::vector<Node*> lhses;  // Will contain nodes where value is used as an lhs
@@ -530,13 +537,297 @@ static void BatchMMSide(Block* block, AliasDb& alias_db)
     }
 }
 
+// Horizontal batching looks for independent nodes in the same block that run
+// the same op on inputs of identical static shapes, like the parallel heads of
+// an ensemble, and replaces them with one call on the stacked inputs:
+//
+//   mm(A1, B1), ..., mm(An, Bn)       -> unbind(bmm(stack(A), stack(B)))
+//   linear(X1, W1, b1), ...           -> unbind(baddbmm(stack(b)[:, None],
+//                                                       stack(X),
+//                                                       stack(W).transpose(1, 2)))
+//   relu(X1), ..., relu(Xn)           -> unbind(relu(stack(X)))
+//
+// Inputs shared by every node of an elementwise group are broadcast instead of
+// stacked. The pass only pays off when the ops are small enough for dispatch
+// to dominate them, since stacking copies every input once: see
+// is_small_for_horizontal_batch.
+
+// Tunable parameters. Groups smaller than this are left alone.
+static constexpr size_t min_horizontal_batch_size = 4;
+// Multiply-adds of one mm or linear, and elements of one elementwise op,
+// above which the op is left alone
+static constexpr int64_t max_horizontal_batch_macs  = 64 * 64 * 64;
+static constexpr int64_t max_horizontal_batch_numel = 64 * 64;
+
+static const OperatorSet& horizontal_batch_elementwise_ops()
+{
+    static const OperatorSet ops{
+        "aten::relu(Tensor self) -> Tensor",
+        "aten::sigmoid(Tensor self) -> Tensor",
+        "aten::tanh(Tensor self) -> Tensor",
+        "aten::exp(Tensor self) -> Tensor",
+        "aten::gelu(Tensor self, *, str approximate='none') -> Tensor",
+        "aten::add(Tensor self, Tensor other, *, Scalar alpha=1) -> Tensor",
+        "aten::sub(Tensor self, Tensor other, *, Scalar alpha=1) -> Tensor",
+        "aten::mul(Tensor self, Tensor other) -> Tensor",
+        "aten::div(Tensor self, Tensor other) -> Tensor",
+    };
+    return ops;
+}
+
+static bool is_horizontal_batch_linear(Node* node)
+{
+    return node->matches(
+        "aten::linear(Tensor input, Tensor weight, Tensor? bias=None) -> Tensor");
+}
+
+static std::optional<std::vector<int64_t>> static_sizes(Value* value)
+{
+    auto type = value->type()->cast<TensorType>();
+    if (!type || !type->scalarType() || !type->device())
+    {
+        return std::nullopt;
+    }
+    return type->sizes().concrete_sizes();
+}
+
+static bool is_small_for_horizontal_batch(Node* node)
+{
+    std::vector<std::vector<int64_t>> sizes;
+    for (Value* input : node->inputs())
+    {
+        if (input->type()->cast<TensorType>())
+        {
+            auto input_sizes = static_sizes(input);
+            if (!input_sizes)
+            {
+                return false;
+            }
+            sizes.push_back(std::move(*input_sizes));
+        }
+    }
+    if (node->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor"))
+    {
+        return sizes[0][0] * sizes[0][1] * sizes[1][1] <= max_horizontal_batch_macs;
+    }
+    if (is_horizontal_batch_linear(node))
+    {
+        // Only 2-D inputs stack into the 3-D operands of baddbmm
+        return sizes[0].size() == 2 && sizes[1].size() == 2 &&
+               sizes[0][0] * sizes[0][1] * sizes[1][0] <= max_horizontal_batch_macs;
+    }
+    for (const auto& input_sizes : sizes)
+    {
+        // Broadcasting inputs could not be stacked
+        if (input_sizes != sizes[0])
+        {
+            return false;
+        }
+    }
+    return quarisma::multiply_integers(sizes[0]) <= max_horizontal_batch_numel;
+}
+
+// Nodes with equal keys can be batched together
+static std::optional<std::string> horizontal_batch_key(Node* node, AliasDb& alias_db)
+{
+    if (!(node->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor") ||
+          is_horizontal_batch_linear(node) ||
+          node->isMemberOf(horizontal_batch_elementwise_ops())) ||
+        alias_db.hasWriters(node) || !is_small_for_horizontal_batch(node))
+    {
+        return std::nullopt;
+    }
+    std::ostringstream key;
+    key << node->schema();
+    for (Value* input : node->inputs())
+    {
+        // Static shapes, dtypes and devices of the tensors, identity of the rest
+        if (input->type()->cast<TensorType>() || input->type() == NoneType::get())
+        {
+            key << "|" << *input->type();
+        }
+        else
+        {
+            key << "|%" << input->unique();
+        }
+    }
+    return key.str();
+}
+
+static Value* stack_inputs(const std::vector<Node*>& nodes, size_t offset, bool allow_shared)
+{
+    Graph* graph = nodes[0]->owningGraph();
+    Value* first = nodes[0]->inputs().quarisma(offset);
+    if (allow_shared &&
+        std::all_of(
+            nodes.begin(),
+            nodes.end(),
+            [&](Node* node) { return node->inputs().quarisma(offset) == first; }))
+    {
+        return first;
+    }
+    std::vector<Value*> inputs;
+    inputs.reserve(nodes.size());
+    for (Node* node : nodes)
+    {
+        inputs.push_back(node->inputs().quarisma(offset));
+    }
+    Value* list = graph->insertNode(graph->createList(TensorType::get(), inputs))->output();
+    return graph->insert(aten::stack, {list, 0});
+}
+
+// Replaces the nodes, contiguous and in topological order, by one batched call
+static void batch_horizontally(const std::vector<Node*>& nodes)
+{
+    Node*  first = nodes[0];
+    Graph* graph = first->owningGraph();
+    {
+        WithInsertPoint insert_guard{first};
+        Value*          batched = nullptr;
+        if (first->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor"))
+        {
+            batched = graph->insert(
+                aten::bmm, {stack_inputs(nodes, 0, false), stack_inputs(nodes, 1, false)});
+        }
+        else if (is_horizontal_batch_linear(first))
+        {
+            Value* input  = stack_inputs(nodes, 0, false);
+            Value* weight = graph->insert(aten::transpose, {stack_inputs(nodes, 1, false), 1, 2});
+            if (first->inputs().quarisma(2)->type() == NoneType::get())
+            {
+                batched = graph->insert(aten::bmm, {input, weight});
+            }
+            else
+            {
+                Value* bias = graph->insert(aten::unsqueeze, {stack_inputs(nodes, 2, false), 1});
+                batched     = graph->insert(aten::baddbmm, {bias, input, weight});
+            }
+        }
+        else
+        {
+            std::unordered_map<Value*, Value*> stacked;
+            bool                               any_stacked = false;
+            for (const auto i : quarisma::irange(first->inputs().size()))
+            {
+                Value* input = first->inputs().quarisma(i);
+                if (input->type()->cast<TensorType>())
+                {
+                    stacked[input] = stack_inputs(nodes, i, true);
+                    any_stacked    = any_stacked || stacked[input] != input;
+                }
+            }
+            // Nodes with only shared inputs are copies of each other, but
+            // the output must still have the batch dimension
+            if (!any_stacked)
+            {
+                stacked[first->inputs().quarisma(0)] = stack_inputs(nodes, 0, false);
+            }
+            Node* op = graph->insertNode(graph->createClone(
+                first,
+                [&](Value* v)
+                {
+                    auto it = stacked.find(v);
+                    return it != stacked.end() ? it->second : v;
+                }));
+            batched = op->output();
+            batched->setType(TensorType::get());
+        }
+        Value* outputs = graph->insert(aten::unbind, {batched, 0});
+        Node*  unpack  = graph->insertNode(graph->createListUnpack(outputs, nodes.size()));
+        for (const auto i : quarisma::irange(nodes.size()))
+        {
+            unpack->outputs().quarisma(i)->setType(nodes[i]->output()->type());
+            nodes[i]->output()->replaceAllUsesWith(unpack->outputs().quarisma(i));
+        }
+    }
+    for (Node* node : nodes)
+    {
+        node->destroy();
+    }
+}
+
+// Finds a group of nodes to batch in block, and makes it contiguous
+static std::vector<Node*> findHorizontalBatch(
+    Block* block, AliasDb& alias_db, std::unordered_set<Node*>& rejected)
+{
+    std::unordered_map<std::string, std::vector<Node*>> groups;
+    std::vector<std::string>                              keys;
+    for (Node* node : block->nodes())
+    {
+        for (Block* subblock : node->blocks())
+        {
+            auto batch = findHorizontalBatch(subblock, alias_db, rejected);
+            if (!batch.empty())
+            {
+                return batch;
+            }
+        }
+        if (rejected.count(node))
+        {
+            continue;
+        }
+        if (auto key = horizontal_batch_key(node, alias_db))
+        {
+            auto& group = groups[*key];
+            if (group.empty())
+            {
+                keys.push_back(*key);
+            }
+            group.push_back(node);
+        }
+    }
+    for (const auto& key : keys)
+    {
+        auto& group = groups[key];
+        if (group.size() < min_horizontal_batch_size)
+        {
+            continue;
+        }
+        auto nodes = filterIndependentNodes(group, alias_db);
+        if (nodes.size() < min_horizontal_batch_size)
+        {
+            continue;
+        }
+        bool moved = true;
+        for (int64_t i = static_cast<int64_t>(nodes.size()) - 2; i >= 0 && moved; --i)
+        {
+            moved = alias_db.moveBeforeTopologicallyValid(nodes[i], nodes[i + 1]);
+        }
+        if (!moved)
+        {
+            rejected.insert(nodes.begin(), nodes.end());
+            continue;
+        }
+        return nodes;
+    }
+    return {};
+}
+
+// Batches one group at a time, since AliasDb does not know the nodes a batch
+// adds to the graph
+static void BatchHorizontally(std::shared_ptr<Graph>& graph)
+{
+    std::unordered_set<Node*> rejected;
+    while (true)
+    {
+        AliasDb alias_db(graph);
+        auto    nodes = findHorizontalBatch(graph->block(), alias_db, rejected);
+        if (nodes.empty())
+        {
+            return;
+        }
+        batch_horizontally(nodes);
+    }
+}
+
 static bool hasMMOperators(std::shared_ptr<Graph>& graph)
 {
     DepthFirstGraphNodeIterator it(graph);
     Node*                       n = nullptr;
     while ((n = it.next()) != nullptr)
     {
-        if (n->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor"))
+        if (n->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor") ||
+            is_horizontal_batch_linear(n))
         {
             return true;
         }
@@ -554,6 +845,7 @@ void BatchMM(std::shared_ptr<Graph>& graph)
     BatchMMTreeReduce(graph->block(), alias_db);
     BatchMMSide(graph->block(), alias_db);
     EliminateDeadCode(graph);
+    BatchHorizontally(graph);
     // It's possible that transpose rearrangements have created sequences of
     // consecutive transposes that didn't exist before.
 
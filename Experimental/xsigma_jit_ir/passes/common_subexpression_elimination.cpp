@@ -13,7 +13,10 @@ namespace
 
 struct CommonSubexpressionEliminator
 {
-    CommonSubexpressionEliminator(std::shared_ptr<Graph> graph) : graph_(std::move(graph)) {}
+    CommonSubexpressionEliminator(std::shared_ptr<Graph> graph, AliasDb* shared_alias_db = nullptr)
+        : shared_alias_db_(shared_alias_db), graph_(std::move(graph))
+    {
+    }
 
     bool run(std::function<Node*(Node*)> parent_lookup_fn)
     {
@@ -94,6 +97,10 @@ struct CommonSubexpressionEliminator
                 GRAPH_UPDATE("Replacing\n", *node, "with\n", *parent_lookup);
                 changed = true;
                 node->replaceAllUsesWith(parent_lookup);
+                if (shared_alias_db_)
+                {
+                    shared_alias_db_->replaceNode(node, parent_lookup);
+                }
                 it.destroyCurrent();
                 continue;
             }
@@ -116,6 +123,10 @@ struct CommonSubexpressionEliminator
                 GRAPH_UPDATE("Replacing\n", *node, "with\n", *existing);
                 changed = true;
                 node->replaceAllUsesWith(existing);
+                if (shared_alias_db_)
+                {
+                    shared_alias_db_->replaceNode(node, existing);
+                }
                 // Destroy the node.
                 it.destroyCurrent();
             }
@@ -126,6 +137,10 @@ struct CommonSubexpressionEliminator
 
     AliasDb& getOrCreateAliasDb()
     {
+        if (shared_alias_db_)
+        {
+            return *shared_alias_db_;
+        }
         if (!alias_db_)
         {
             alias_db_ = std::make_unique<AliasDb>(graph_);
@@ -135,6 +150,8 @@ struct CommonSubexpressionEliminator
     }
 
 private:
+    // Kept up to date when given by the caller, who may reuse it afterwards
+    AliasDb*                 shared_alias_db_;
     std::unique_ptr<AliasDb> alias_db_;
     std::shared_ptr<Graph>   graph_;
 };
@@ -147,4 +164,11 @@ bool EliminateCommonSubexpression(const std::shared_ptr<Graph>& graph)
     CommonSubexpressionEliminator cse(graph);
     return cse.run([](Node*) { return nullptr; });
 }
+
+bool EliminateCommonSubexpression(const std::shared_ptr<Graph>& graph, AliasDb& aliasDb)
+{
+    GRAPH_DUMP("Before CSE", graph);
+    CommonSubexpressionEliminator cse(graph, &aliasDb);
+    return cse.run([](Node*) { return nullptr; });
+}
 }  // namespace torch::jit
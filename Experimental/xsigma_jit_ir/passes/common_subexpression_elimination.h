@@ -6,4 +6,9 @@ namespace torch::jit
 {
 
 TORCH_API bool EliminateCommonSubexpression(const std::shared_ptr<Graph>& graph);
+
+// Same, reusing `aliasDb` instead of analyzing the graph again. The nodes
+// eliminated are removed from it, so it stays valid for the passes after.
+TORCH_API bool EliminateCommonSubexpression(
+    const std::shared_ptr<Graph>& graph, AliasDb& aliasDb);
 }
@@ -14,8 +14,12 @@ namespace
 
 // Very similar to the common subexpression elimination pass
 // Move all constants to the beginning of the graph, and deduplicate
+// When `update` is set, the constants removed are removed from `aliasDb` too
 void ConstantPooling(
-    Block* block, std::unordered_set<Node*, HashNode, EqualNode>& constants, const AliasDb& aliasDb)
+    Block*                                          block,
+    std::unordered_set<Node*, HashNode, EqualNode>& constants,
+    AliasDb&                                        aliasDb,
+    bool                                            update)
 {
     for (auto it = block->nodes().begin(); it != block->nodes().end();)
     {
@@ -27,7 +31,7 @@ void ConstantPooling(
             // Traverse sub-blocks.
             for (auto block : node->blocks())
             {
-                ConstantPooling(block, constants, aliasDb);
+                ConstantPooling(block, constants, aliasDb, update);
             }
             continue;
         }
@@ -58,6 +62,10 @@ void ConstantPooling(
 
             // constant exists, replace the uses of node, and destroy it.
             node->replaceAllUsesWith(existing);
+            if (update)
+            {
+                aliasDb.replaceNode(node, existing);
+            }
             node->destroy();
             continue;
         }
@@ -74,6 +82,12 @@ void ConstantPooling(const std::shared_ptr<Graph>& graph)
 {
     AliasDb                                        aliasDb(graph);
     std::unordered_set<Node*, HashNode, EqualNode> constants;
-    ConstantPooling(graph->block(), constants, aliasDb);
+    ConstantPooling(graph->block(), constants, aliasDb, /*update=*/false);
+}
+
+void ConstantPooling(const std::shared_ptr<Graph>& graph, AliasDb& aliasDb)
+{
+    std::unordered_set<Node*, HashNode, EqualNode> constants;
+    ConstantPooling(graph->block(), constants, aliasDb, /*update=*/true);
 }
 }  // namespace torch::jit
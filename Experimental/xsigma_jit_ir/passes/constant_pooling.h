@@ -7,4 +7,8 @@ namespace torch::jit
 
 TORCH_API void ConstantPooling(const std::shared_ptr<Graph>& graph);
 
+// Same, reusing `aliasDb` instead of analyzing the graph again. The constants
+// deduplicated are removed from it, so it stays valid for the passes after.
+TORCH_API void ConstantPooling(const std::shared_ptr<Graph>& graph, AliasDb& aliasDb);
+
 }
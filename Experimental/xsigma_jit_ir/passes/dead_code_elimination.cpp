@@ -17,8 +17,14 @@ using namespace ::quarisma::prim;
 class DeadCodeEliminator
 {
 public:
-    explicit DeadCodeEliminator(std::shared_ptr<Graph> graph, DCESideEffectPolicy sideEffectPolicy)
-        : sideEffectPolicy_(sideEffectPolicy), graph_(std::move(graph)), useAliasDb_(true)
+    explicit DeadCodeEliminator(
+        std::shared_ptr<Graph> graph,
+        DCESideEffectPolicy    sideEffectPolicy,
+        AliasDb*               sharedAliasDb = nullptr)
+        : sideEffectPolicy_(sideEffectPolicy),
+          graph_(std::move(graph)),
+          useAliasDb_(true),
+          sharedAliasDb_(sharedAliasDb)
     {
     }
     DeadCodeEliminator(DCESideEffectPolicy sideEffectPolicy) : sideEffectPolicy_(sideEffectPolicy)
@@ -80,6 +86,7 @@ private:
                         "(",
                         g.inputs().quarisma(i)->debugName(),
                         " in a subgraph) will be removed");
+                    forgetValue(g.inputs().quarisma(i));
                     g.eraseInput(i);
                     node->removeInput(i);
                 }
@@ -329,6 +336,10 @@ private:
                     " which outputs ",
                     (!node->outputs().empty() ? node->outputs().quarisma(0)->debugName() : "n/a"),
                     " will be removed");
+                if (sharedAliasDb_)
+                {
+                    sharedAliasDb_->removeNode(node);
+                }
                 it.destroyCurrent();
             }
         }
@@ -402,6 +413,7 @@ private:
                     " of node ",
                     node->kind().toQualString(),
                     " will be removed");
+                forgetValue(node->outputs().quarisma(i));
                 node->eraseOutput(i);
                 for (Block* b : node->blocks())
                 {
@@ -431,6 +443,8 @@ private:
                 !loop_body->inputs().quarisma(loop_body_offset + i)->hasUses())
             {
                 logDeadLoopOutputs(node, i, loop_input_offset, loop_body_offset);
+                forgetValue(node->outputs().quarisma(i));
+                forgetValue(loop_body->inputs().quarisma(loop_body_offset + i));
                 node->eraseOutput(i);
                 node->removeInput(loop_input_offset + i);
                 loop_body->eraseInput(loop_body_offset + i);
@@ -464,8 +478,21 @@ private:
             " will be removed");
     }
 
+    // Values erased from the graph must be erased from a shared AliasDb too
+    void forgetValue(const Value* v)
+    {
+        if (sharedAliasDb_)
+        {
+            sharedAliasDb_->removeValue(v);
+        }
+    }
+
     AliasDb* getOrCreateAliasDb()
     {
+        if (sharedAliasDb_)
+        {
+            return sharedAliasDb_;
+        }
         if (!aliasDb_)
         {
             aliasDb_ = std::make_unique<AliasDb>(graph_);
@@ -534,6 +561,8 @@ private:
     bool                   useAliasDb_ = false;
     // lazily initialized
     std::unique_ptr<AliasDb>        aliasDb_ = nullptr;
+    // Borrowed from the caller and kept up to date; used instead of aliasDb_
+    AliasDb*                        sharedAliasDb_ = nullptr;
     std::unordered_map<Node*, bool> memo_;
     std::unordered_set<Node*>       marked_;
 
@@ -554,6 +583,13 @@ void EliminateDeadCode(const std::shared_ptr<Graph>& graph, DCESideEffectPolicy
     GRAPH_DUMP("After EliminateDeadCode: ", graph);
 }
 
+void EliminateDeadCode(
+    const std::shared_ptr<Graph>& graph, AliasDb& aliasDb, DCESideEffectPolicy sideEffectPolicy)
+{
+    DeadCodeEliminator(graph, sideEffectPolicy, &aliasDb).run(graph->block(), /*recurse=*/true);
+    GRAPH_DUMP("After EliminateDeadCode: ", graph);
+}
+
 void EliminateDeadCode(Block* block, bool recurse, DCESideEffectPolicy sideEffectPolicy)
 {
     DeadCodeEliminator(sideEffectPolicy).run(block, recurse);
@@ -27,6 +27,14 @@ TORCH_API void EliminateDeadCode(
     const std::shared_ptr<Graph>& graph,
     DCESideEffectPolicy           sideEffectPolicy =
         DCESideEffectPolicy::DONT_DELETE_NODES_WITH_SIDE_EFFECTS);
+// Same as the graph version, reusing `aliasDb` instead of analyzing the graph
+// again. The nodes and values removed are removed from it, so it stays valid
+// for the passes after.
+TORCH_API void EliminateDeadCode(
+    const std::shared_ptr<Graph>& graph,
+    AliasDb&                      aliasDb,
+    DCESideEffectPolicy           sideEffectPolicy =
+        DCESideEffectPolicy::DONT_DELETE_NODES_WITH_SIDE_EFFECTS);
 TORCH_API void EliminateDeadCode(
     Block*              block,
     bool                recurse = true,
@@ -4,6 +4,7 @@
 #include <torch/csrc/jit/passes/frozen_conv_folding.h>
 #include <torch/csrc/jit/passes/frozen_graph_optimizations.h>
 #include <torch/csrc/jit/passes/frozen_linear_folding.h>
+#include <torch/csrc/jit/passes/frozen_linear_prepack.h>
 #include <torch/csrc/jit/passes/remove_dropout.h>
 #include <torch/csrc/jit/runtime/graph_executor.h>
 #include <quarisma/util/irange.h>
@@ -28,6 +29,11 @@ void OptimizeFrozenGraph(std::shared_ptr<Graph>& graph, bool optimize_numerics)
             changed |= FoldFrozenLinearBatchnorm(graph);
         } while (changed);
     }
+    // Last, as it hides the linear layers from the folding passes
+    if (frozenLinearPrepackEnabled())
+    {
+        PrepackFrozenLinear(graph);
+    }
 }
 
 }  // namespace torch::jit
@@ -9,6 +9,7 @@
  * - FoldFrozenConvAddOrSub
  * - FoldFrozenConvMulOrDiv
  * - FoldFrozenLinearBatchnorm
+ * - PrepackFrozenLinear, when frozenLinearPrepackEnabled()
  */
 
 namespace torch::jit
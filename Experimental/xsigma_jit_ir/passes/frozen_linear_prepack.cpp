@@ -0,0 +1,203 @@
+#include <torch/csrc/jit/ir/ir.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/frozen_linear_prepack.h>
+#include <torch/csrc/jit/passes/utils/optimization_utils.h>
+#include <torch/csrc/jit/runtime/custom_operator.h>
+#include <torch/csrc/jit/runtime/graph_iterator.h>
+
+#include <Quarisma/native/PackedLinear.h>
+
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace torch::jit
+{
+namespace
+{
+
+using Tensor = quarisma::Tensor;
+
+bool frozen_linear_prepack_enabled_ = false;
+
+const Symbol& prepacked_linear()
+{
+    static const Symbol symbol = Symbol::fromQualString("prepacked::linear");
+    return symbol;
+}
+
+RegisterOperators reg_prepacked_linear({Operator(
+    "prepacked::linear(Tensor input, Tensor packed_weight, Tensor? bias, int out_features) "
+    "-> Tensor",
+    [](Stack& stack)
+    {
+        const int64_t out_features = pop(stack).toInt();
+        auto          bias         = pop(stack).toOptional<Tensor>();
+        auto          packed       = pop(stack).toTensor();
+        auto          input        = pop(stack).toTensor();
+        push(stack, quarisma::native::packed_linear(input, packed, bias, out_features));
+    },
+    aliasAnalysisFromSchema())});
+
+/*
+ * The packed weights of all the graphs of the process, so that the instances
+ * of a module, frozen one by one, share one packed copy of their weights.
+ *
+ * Entries are found by a hash of the contents of the weight and checked
+ * element by element; they hold the packed tensor weakly, so a packed weight
+ * lives as long as a graph refers to it.
+ */
+class PackedWeightCache
+{
+public:
+    Tensor get(const Tensor& weight)
+    {
+        const Tensor contiguous = weight.contiguous();
+        const size_t key        = hash(contiguous);
+
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto                        range = entries_.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            quarisma::IValue packed = it->second.lock();
+            if (packed.isTensor() && packed.toTensor().defined() &&
+                quarisma::native::packed_linear_weight_equals(packed.toTensor(), contiguous))
+            {
+                return packed.toTensor();
+            }
+        }
+
+        prune();
+        Tensor packed = quarisma::native::pack_linear_weight(contiguous);
+        entries_.emplace(key, quarisma::WeakIValue(quarisma::IValue(packed)));
+        return packed;
+    }
+
+private:
+    static size_t hash(const Tensor& weight)
+    {
+        const std::string_view bytes(
+            static_cast<const char*>(weight.const_data_ptr()), weight.nbytes());
+        size_t seed = std::hash<std::string_view>()(bytes);
+        for (const int64_t size : weight.sizes())
+        {
+            seed = quarisma::hash_combine(seed, std::hash<int64_t>()(size));
+        }
+        return seed;
+    }
+
+    // Drops the entries of packed weights that no graph refers to anymore
+    void prune()
+    {
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            it = it->second.use_count() == 0 ? entries_.erase(it) : std::next(it);
+        }
+    }
+
+    std::mutex                                            mutex_;
+    std::unordered_multimap<size_t, quarisma::WeakIValue> entries_;
+};
+
+PackedWeightCache& packed_weight_cache()
+{
+    static PackedWeightCache cache;
+    return cache;
+}
+
+bool is_packable_tensor(const std::optional<Tensor>& t, int64_t dim)
+{
+    return t.has_value() && t->defined() && t->dim() == dim &&
+           t->scalar_type() == quarisma::kFloat && t->is_cpu() && !t->requires_grad();
+}
+
+class PrepackFrozenLinearPass
+{
+public:
+    explicit PrepackFrozenLinearPass(std::shared_ptr<Graph> graph) : graph_(std::move(graph)) {}
+
+    bool run()
+    {
+        // Can't delete nodes while also iterating over it
+        DepthFirstGraphNodeIterator graph_it(graph_);
+
+        for (auto next_node = graph_it.next(); next_node != nullptr;)
+        {
+            Node* node = next_node;
+            next_node  = graph_it.next();
+
+            if (is_packable_linear_op(node))
+            {
+                replace_with_prepacked_linear(node);
+            }
+        }
+        return graph_modified_;
+    }
+
+private:
+    static bool is_packable_linear_op(Node* node)
+    {
+        // This also filters out out-variants of the linear op.
+        if (node->kind() != aten::linear || nonConstantParameters(node))
+        {
+            return false;
+        }
+        // The input must have the dtype and device of the weight, so a float
+        // CPU weight is all the packed kernel needs
+        if (!is_packable_tensor(constant_as<Tensor>(node->namedInput("weight")), 2))
+        {
+            return false;
+        }
+        Value* bias = node->namedInput("bias");
+        return bias->type() == NoneType::get() ||
+               is_packable_tensor(constant_as<Tensor>(bias), 1);
+    }
+
+    void replace_with_prepacked_linear(Node* node)
+    {
+        graph_modified_ = true;
+
+        WithInsertPoint insert_guard(node);
+        Tensor          weight = constant_as<Tensor>(node->namedInput("weight")).value();
+        Value*          packed = graph_->insertConstant(packed_weight_cache().get(weight));
+        Value*          out_features = graph_->insertConstant(weight.size(0));
+
+        Node* linear = graph_->create(
+            prepacked_linear(),
+            {node->inputs()[0], packed, node->namedInput("bias"), out_features});
+        linear->insertAfter(node);
+        linear->output()->setType(node->output()->type());
+        node->replaceAllUsesWith(linear);
+        node->destroy();
+    }
+
+    std::shared_ptr<Graph> graph_;
+    bool                   graph_modified_ = false;
+};
+}  // namespace
+
+void setFrozenLinearPrepackEnabled(bool val)
+{
+    frozen_linear_prepack_enabled_ = val;
+}
+
+bool frozenLinearPrepackEnabled()
+{
+    return frozen_linear_prepack_enabled_;
+}
+
+bool PrepackFrozenLinear(std::shared_ptr<Graph>& graph)
+{
+    PrepackFrozenLinearPass prepack(graph);
+    GRAPH_DUMP("Before PrepackFrozenLinear", graph);
+    bool changed = prepack.run();
+    if (changed)
+    {
+        GRAPH_DUMP("After PrepackFrozenLinear", graph);
+    }
+    return changed;
+}
+
+}  // namespace torch::jit
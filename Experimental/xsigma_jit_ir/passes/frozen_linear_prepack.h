@@ -0,0 +1,19 @@
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch::jit
+{
+
+// Replaces the float CPU linear layers of a frozen graph, whose weight is a
+// constant, by prepacked::linear, which multiplies by a copy of the weight
+// packed once into cache-blocked panels (see Quarisma/native/PackedLinear.h).
+// Identical weights, e.g. of several instances of a module, share one packed
+// copy. prepacked::linear has no gradient, so the pass only runs from
+// OptimizeFrozenGraph when enabled.
+TORCH_API bool PrepackFrozenLinear(std::shared_ptr<Graph>& graph);
+
+TORCH_API void setFrozenLinearPrepackEnabled(bool val);
+TORCH_API bool frozenLinearPrepackEnabled();
+
+}  // namespace torch::jit
@@ -1330,6 +1330,7 @@ void PeepholeOptimizeShapeExpressions(Block* block, AliasDb* db)
             if (node->inputs().size() == 1)
             {
                 node->output()->replaceAllUsesWith(node->input());
+                db->removeNode(node);
                 it.destroyCurrent();
                 continue;
             }
@@ -1357,6 +1358,7 @@ void PeepholeOptimizeShapeExpressions(Block* block, AliasDb* db)
                     WithInsertPoint insert_guard{node};
                     node->output()->replaceAllUsesWith(broadcastSizes(inputs, db));
                 }
+                db->removeNode(node);
                 it.destroyCurrent();
                 --it;  // Revisit the node with deduplicated inputs
                 continue;
@@ -1373,6 +1375,7 @@ void PeepholeOptimizeShapeExpressions(Block* block, AliasDb* db)
                 {
                     user->addInput(i);
                 }
+                db->removeNode(node);
                 it.destroyCurrent();
             }
         }
@@ -1396,13 +1399,18 @@ void overrideCanFuseOnCPULegacy(bool value)
 void FuseGraph(std::shared_ptr<Graph>& graph, bool strict_fuser_check)
 {
     AliasDb db(graph);
+    FuseGraph(graph, db, strict_fuser_check);
+}
+
+void FuseGraph(std::shared_ptr<Graph>& graph, AliasDb& db, bool strict_fuser_check)
+{
     GraphFuser(&db, graph->block(), strict_fuser_check).run();
     Lint(&db);
     // After FuseGraph some common subexpressions may come back
-    EliminateCommonSubexpression(graph);
+    EliminateCommonSubexpression(graph, db);
     // We might have emitted a fair amount of useless shape propagating code, so
     // remove it
-    EliminateDeadCode(graph);
+    EliminateDeadCode(graph, db);
     // Improve the quality of shape propagation code that was left
     PeepholeOptimizeShapeExpressions(graph->block(), &db);
 }
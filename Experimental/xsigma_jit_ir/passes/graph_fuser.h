@@ -13,6 +13,12 @@ TORCH_API void overrideCanFuseOnCPULegacy(bool value);
 // On Windows will noop, NYI
 TORCH_API void FuseGraph(std::shared_ptr<Graph>& graph, bool strict_fuser_check = false);
 
+// Same, with `db` holding the alias analysis of `graph`. It is kept up to date
+// through fusion and the cleanup passes that follow, so a pass pipeline can
+// analyze the graph once and share the result.
+TORCH_API void FuseGraph(
+    std::shared_ptr<Graph>& graph, AliasDb& db, bool strict_fuser_check = false);
+
 // \brief Custom fusion pass using a node-level callback to
 // determine the inclusion of nodes in a subgraph.
 //
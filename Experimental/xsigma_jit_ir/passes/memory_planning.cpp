@@ -0,0 +1,209 @@
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/liveness.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <quarisma/core/ScalarType.h>
+#include <quarisma/util/irange.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace torch::jit
+{
+
+namespace
+{
+
+size_t alignUp(size_t size)
+{
+    return (size + kMemoryPlanAlignment - 1) / kMemoryPlanAlignment * kMemoryPlanAlignment;
+}
+
+// Bytes of the output of node when it can be planned, 0 otherwise
+size_t plannedSize(Node* node, const AliasDb& aliasDb)
+{
+    if (!node->kind().is_aten() || node->outputs().size() != 1 || !node->blocks().empty() ||
+        node->maybeOperator() == nullptr)
+    {
+        return 0;
+    }
+    Value* output = node->output();
+    auto   type   = output->type()->cast<TensorType>();
+    if (!type || !type->isComplete() || type->requiresGrad() != false ||
+        type->device() != quarisma::Device(quarisma::kCPU))
+    {
+        return 0;
+    }
+    const auto sizes = *type->sizes().concrete_sizes();
+    if (*type->strides().concrete_sizes() != TensorType::contiguousStridesOf(sizes))
+    {
+        return 0;
+    }
+    // Views and in-place ops do not allocate their output
+    if (aliasDb.mayContainAlias(output, node->inputs()) || aliasDb.escapesScope({output}))
+    {
+        return 0;
+    }
+    const auto numel = type->numel();
+    if (!numel.has_value() || *numel <= 0)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(*numel) * quarisma::elementSize(*type->scalarType());
+}
+
+bool mayRequireGrad(const Value* value)
+{
+    auto type = value->type()->cast<TensorType>();
+    return type && type->requiresGrad() != false;
+}
+
+bool anyMayRequireGrad(Block* block)
+{
+    for (Value* input : block->inputs())
+    {
+        if (mayRequireGrad(input))
+        {
+            return true;
+        }
+    }
+    for (Node* node : block->nodes())
+    {
+        for (Value* output : node->outputs())
+        {
+            if (mayRequireGrad(output))
+            {
+                return true;
+            }
+        }
+        for (Block* sub : node->blocks())
+        {
+            if (anyMayRequireGrad(sub))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The values live at node or at any node nested in it
+void collectLiveValues(
+    Node*                                                 node,
+    const std::unordered_map<Node*, std::vector<Value*>>& liveness,
+    std::vector<Value*>&                                  live)
+{
+    auto it = liveness.find(node);
+    if (it != liveness.end())
+    {
+        live.insert(live.end(), it->second.begin(), it->second.end());
+    }
+    for (Block* block : node->blocks())
+    {
+        for (Node* nested : block->nodes())
+        {
+            collectLiveValues(nested, liveness, live);
+        }
+    }
+}
+
+}  // namespace
+
+MemoryPlan PlanMemory(const std::shared_ptr<Graph>& graph)
+{
+    MemoryPlan plan;
+    if (anyMayRequireGrad(graph->block()))
+    {
+        GRAPH_DEBUG("Not planning memory, a tensor may require grad");
+        return plan;
+    }
+
+    // Before the AliasDb, BuildLivenessSets edits the graph while it runs
+    const auto liveness = BuildLivenessSets(graph);
+    AliasDb    aliasDb(graph);
+
+    std::vector<Node*> nodes(graph->nodes().begin(), graph->nodes().end());
+    for (const auto i : quarisma::irange(nodes.size()))
+    {
+        const size_t nbytes = plannedSize(nodes[i], aliasDb);
+        if (nbytes != 0)
+        {
+            plan.tensors.push_back(PlannedTensor{nodes[i], nbytes, 0, alignUp(nbytes), i, i});
+        }
+    }
+
+    // Extend each lifetime to the last node where an alias of the tensor is live
+    std::vector<Value*> live;
+    for (const auto i : quarisma::irange(nodes.size()))
+    {
+        live.clear();
+        collectLiveValues(nodes[i], liveness, live);
+        if (live.empty())
+        {
+            continue;
+        }
+        for (auto& tensor : plan.tensors)
+        {
+            if (tensor.first < i && aliasDb.mayContainAlias(tensor.node->output(), live))
+            {
+                tensor.last = i;
+            }
+        }
+    }
+
+    // Largest first, then by definition, so that the order is deterministic
+    std::sort(
+        plan.tensors.begin(),
+        plan.tensors.end(),
+        [](const PlannedTensor& a, const PlannedTensor& b)
+        {
+            if (a.size != b.size)
+            {
+                return a.size > b.size;
+            }
+            return a.first < b.first;
+        });
+
+    std::vector<const PlannedTensor*> conflicts;
+    for (auto it = plan.tensors.begin(); it != plan.tensors.end(); ++it)
+    {
+        conflicts.clear();
+        for (auto placed = plan.tensors.begin(); placed != it; ++placed)
+        {
+            if (placed->first <= it->last && it->first <= placed->last)
+            {
+                conflicts.push_back(&*placed);
+            }
+        }
+        std::sort(
+            conflicts.begin(),
+            conflicts.end(),
+            [](const PlannedTensor* a, const PlannedTensor* b) { return a->offset < b->offset; });
+
+        // Lowest gap between the live tensors that fits
+        size_t offset = 0;
+        for (const PlannedTensor* other : conflicts)
+        {
+            if (offset + it->size <= other->offset)
+            {
+                break;
+            }
+            offset = std::max(offset, other->offset + other->size);
+        }
+        it->offset      = offset;
+        plan.arena_size = std::max(plan.arena_size, offset + it->size);
+        plan.total_size += it->size;
+    }
+
+    GRAPH_DEBUG(
+        "Planned ",
+        plan.tensors.size(),
+        " tensors into ",
+        plan.arena_size,
+        " bytes (",
+        plan.total_size,
+        " without sharing)");
+    return plan;
+}
+
+}  // namespace torch::jit
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <torch/csrc/Export.h>
+#include <torch/csrc/jit/ir/ir.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace torch::jit
+{
+
+// Alignment of every tensor placed in a memory plan's arena
+constexpr size_t kMemoryPlanAlignment = 64;
+
+struct PlannedTensor
+{
+    // The node whose single output is placed in the arena
+    Node*  node;
+    size_t nbytes;  // of the tensor
+    size_t offset;  // from the start of the arena
+    size_t size;    // nbytes rounded up to kMemoryPlanAlignment
+    // Positions in the top-level block of the definition and the last use
+    size_t first;
+    size_t last;
+};
+
+struct MemoryPlan
+{
+    std::vector<PlannedTensor> tensors;
+    size_t                     arena_size = 0;
+    // Bytes the planned tensors would take without sharing
+    size_t total_size = 0;
+};
+
+// PlanMemory places the intermediate tensors of graph in one arena, so that
+// tensors which are never alive together share memory.
+//
+// Planned tensors are the outputs of the single-output aten nodes of the
+// top-level block whose type is a complete, contiguous CPU tensor that does
+// not require grad, as set by shape propagation or profiling, and which neither
+// alias an input of their node nor escape the graph. The lifetime of a tensor
+// goes from its node to the last node where it, or any value that may contain
+// an alias of it, is live according to BuildLivenessSets. Nested blocks count
+// as their enclosing node. Nothing is planned when any tensor of the graph may
+// require grad, since autograd could keep it past its last use.
+//
+// Tensors are placed greedily by size, largest first, each at the lowest offset
+// free of the placed tensors whose lifetime overlaps its own.
+TORCH_API MemoryPlan PlanMemory(const std::shared_ptr<Graph>& graph);
+
+}  // namespace torch::jit
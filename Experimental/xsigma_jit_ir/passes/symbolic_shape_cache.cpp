@@ -1,7 +1,12 @@
+#include <torch/csrc/jit/passes/canonicalize.h>
 #include <torch/csrc/jit/passes/symbolic_shape_analysis.h>
 #include <torch/csrc/jit/passes/symbolic_shape_cache.h>
 #include <torch/csrc/lazy/core/cache.h>
 
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <sstream>
 #include <utility>
 
 // SHAPE CACHING CODE
@@ -167,6 +172,131 @@ TORCH_API size_t get_shape_cache_size()
     return shapeCache.Numel();
 }
 
+// FUSED KERNEL CACHING CODE
+
+namespace
+{
+using FusedKernelCache = lazy::Cache<std::string, tensorexpr::TensorExprKernel>;
+
+constexpr size_t kFusedKernelCacheSize = 256;
+FusedKernelCache fusedKernelCache(kFusedKernelCacheSize);
+
+std::atomic<size_t>  fusedKernelHits{0};
+std::atomic<size_t>  fusedKernelMisses{0};
+std::atomic<int64_t> fusedKernelCompileNanos{0};
+
+// Renumbers the symbolic dimensions SS(<id>) of key -1, -2, ... in order of
+// appearance, so that structurally identical subgraphs whose symbols were
+// created by different graphs get the same key
+std::string canonicalizeShapeSymbols(const std::string& key)
+{
+    std::unordered_map<std::string, int64_t> symbols;
+    std::string                              result;
+    result.reserve(key.size());
+    size_t pos = 0;
+    while (pos < key.size())
+    {
+        const size_t start = key.find("SS(", pos);
+        if (start == std::string::npos)
+        {
+            result.append(key, pos, std::string::npos);
+            break;
+        }
+        size_t end = start + 3;
+        if (end < key.size() && key[end] == '-')
+        {
+            end++;
+        }
+        while (end < key.size() && std::isdigit(static_cast<unsigned char>(key[end])))
+        {
+            end++;
+        }
+        result.append(key, pos, start + 3 - pos);
+        auto symbol = symbols.emplace(
+            key.substr(start + 3, end - start - 3), -static_cast<int64_t>(symbols.size()) - 1);
+        result += std::to_string(symbol.first->second);
+        pos = end;
+    }
+    return result;
+}
+
+}  // namespace
+
+std::string fused_kernel_cache_key(const Node* node)
+{
+    // Compilation only depends on the subgraph and the attributes read by
+    // createTensorExprOp, value names aside
+    std::ostringstream key;
+    key << Canonicalize(node->g(attr::Subgraph), /*keep_unique_names=*/false)->toString(false);
+    if (node->hasAttribute(attr::symbolic_shape_inputs))
+    {
+        key << "symbolic_shape_inputs:";
+        for (int64_t symbol : node->is(attr::symbolic_shape_inputs))
+        {
+            key << " SS(" << symbol << ")";
+        }
+        key << "\n";
+    }
+    if (node->hasAttribute(attr::striding_inputs_desc))
+    {
+        key << "striding_inputs_desc: " << node->ival(attr::striding_inputs_desc) << "\n";
+    }
+    if (node->hasAttribute(attr::striding_outputs_desc))
+    {
+        key << "striding_outputs_desc: " << node->ival(attr::striding_outputs_desc) << "\n";
+    }
+    if (node->hasAttribute(attr::allow_stack_outputs))
+    {
+        key << "allow_stack_outputs: " << node->i(attr::allow_stack_outputs) << "\n";
+    }
+    return canonicalizeShapeSymbols(key.str());
+}
+
+std::shared_ptr<tensorexpr::TensorExprKernel> get_or_compile_fused_kernel(
+    const Node* node, const FusedKernelCompiler& compile)
+{
+    std::string key = fused_kernel_cache_key(node);
+    if (auto kernel = fusedKernelCache.Get(key))
+    {
+        fusedKernelHits++;
+        return kernel;
+    }
+
+    // Two graphs missing on the same key concurrently both compile; the
+    // second Add replaces the first kernel, which stays valid for its user
+    const auto start  = std::chrono::steady_clock::now();
+    auto       kernel = compile();
+    const auto nanos  = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    fusedKernelMisses++;
+    fusedKernelCompileNanos += nanos;
+    return fusedKernelCache.Add(std::move(key), std::move(kernel));
+}
+
+FusedKernelCacheStats get_fused_kernel_cache_stats()
+{
+    FusedKernelCacheStats stats;
+    stats.hits            = fusedKernelHits.load();
+    stats.misses          = fusedKernelMisses.load();
+    stats.entries         = static_cast<size_t>(fusedKernelCache.Numel());
+    stats.compile_seconds = static_cast<double>(fusedKernelCompileNanos.load()) * 1e-9;
+    return stats;
+}
+
+TORCH_API void clear_fused_kernel_cache()
+{
+    fusedKernelCache.Clear();
+    fusedKernelHits         = 0;
+    fusedKernelMisses       = 0;
+    fusedKernelCompileNanos = 0;
+}
+
+TORCH_API size_t get_fused_kernel_cache_size()
+{
+    return fusedKernelCache.Numel();
+}
+
 void CanonicalizedSymbolicShape::init(
     const quarisma::SymbolicShape& orig_shape, std::unordered_map<int64_t, int64_t>& ss_map)
 {
@@ -3,8 +3,16 @@
 #include <torch/csrc/jit/ir/ir.h>
 #include <torch/csrc/jit/passes/symbolic_shape_analysis.h>
 
+#include <functional>
+#include <memory>
+#include <string>
+
 namespace torch::jit
 {
+namespace tensorexpr
+{
+class TensorExprKernel;
+}  // namespace tensorexpr
 
 struct TORCH_API CanonicalizedSymbolicShape
 {
@@ -51,4 +59,34 @@ TORCH_API void cache_shape_function(
 TORCH_API void   clear_shape_cache();
 TORCH_API size_t get_shape_cache_size();
 
+// FUSED KERNEL CACHE API
+// Compiled TensorExprKernels are shared by every graph of the process, so
+// that models with identical fusion groups compile them once. A kernel is
+// keyed by the canonicalized subgraph of its prim::TensorExprGroup node and
+// its symbolic shape class: the symbolic dimensions, renumbered in order of
+// appearance, and the striding descriptors. The cache keeps the
+// kFusedKernelCacheSize most recently used kernels.
+struct TORCH_API FusedKernelCacheStats
+{
+    size_t hits            = 0;
+    size_t misses          = 0;  // Kernels compiled
+    size_t entries         = 0;
+    double compile_seconds = 0;  // Spent in the compilations of the misses
+};
+
+using FusedKernelCompiler = std::function<std::shared_ptr<tensorexpr::TensorExprKernel>()>;
+
+// The key of the kernel compiled for a prim::TensorExprGroup node
+TORCH_API std::string fused_kernel_cache_key(const Node* node);
+
+// The cached kernel for node, compiling it with compile on a miss
+TORCH_API std::shared_ptr<tensorexpr::TensorExprKernel> get_or_compile_fused_kernel(
+    const Node* node, const FusedKernelCompiler& compile);
+
+TORCH_API FusedKernelCacheStats get_fused_kernel_cache_stats();
+
+// For use in test code
+TORCH_API void   clear_fused_kernel_cache();
+TORCH_API size_t get_fused_kernel_cache_size();
+
 }  // namespace torch::jit
@@ -11,6 +11,7 @@
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 #include <torch/csrc/jit/passes/pass_manager.h>
 #include <torch/csrc/jit/passes/remove_redundant_profiles.h>
+#include <torch/csrc/jit/passes/symbolic_shape_cache.h>
 #include <torch/csrc/jit/passes/symbolic_shape_runtime_fusion.h>
 #include <torch/csrc/jit/passes/tensorexpr_fuser.h>
 #include <torch/csrc/jit/passes/utils/subgraph_utils.h>
@@ -422,8 +423,10 @@ class TensorExprFuser {
       std::shared_ptr<Graph> graph,
       size_t min_group_size,
       bool add_composed_op,
-      bool fuse_to_dynamic_shapes)
+      bool fuse_to_dynamic_shapes,
+      AliasDb* shared_alias_db = nullptr)
       : graph_(std::move(graph)),
+        aliasDb_(shared_alias_db),
         min_group_size_(min_group_size),
         add_composed_op_(add_composed_op),
         fuse_to_dynamic_shapes_(fuse_to_dynamic_shapes) {
@@ -521,7 +524,7 @@ class TensorExprFuser {
       shape_of.emplace(
           n->output(),
           shapes.size() == 1 ? shapes[0]
-                             : broadcastSizes(shapes, aliasDb_.get()));
+                             : broadcastSizes(shapes, aliasDb_));
     }
     return shape_of;
   }
@@ -554,7 +557,10 @@ class TensorExprFuser {
   }
 
   void run() {
-    aliasDb_ = std::make_unique<AliasDb>(graph_);
+    if (!aliasDb_) {
+      ownedAliasDb_ = std::make_unique<AliasDb>(graph_);
+      aliasDb_ = ownedAliasDb_.get();
+    }
     RemoveRedundantProfiles(graph_);
     GRAPH_DUMP("After removing redundant profile nodes: ", graph_);
     createFusionGroups(graph_->block());
@@ -1317,7 +1323,9 @@ class TensorExprFuser {
   }
 
   std::shared_ptr<Graph> graph_;
-  std::unique_ptr<AliasDb> aliasDb_ = nullptr;
+  // Either shared by the caller or owned
+  AliasDb* aliasDb_ = nullptr;
+  std::unique_ptr<AliasDb> ownedAliasDb_ = nullptr;
 
   std::set<NodeKind> operators_not_to_fuse;
   // Minimal size of a fusion group
@@ -1333,6 +1341,17 @@ void FuseTensorExprs(
     size_t min_group_size,
     bool add_composed_op,
     bool fuse_to_dynamic_shapes) {
+  AliasDb db(graph);
+  FuseTensorExprs(
+      graph, db, min_group_size, add_composed_op, fuse_to_dynamic_shapes);
+}
+
+void FuseTensorExprs(
+    std::shared_ptr<Graph>& graph,
+    AliasDb& db,
+    size_t min_group_size,
+    bool add_composed_op,
+    bool fuse_to_dynamic_shapes) {
   GRAPH_DUMP("Before TExprFuser: ", graph);
 
   // Temporary change for Block code generation.
@@ -1346,14 +1365,17 @@ void FuseTensorExprs(
   }
 
   // Get rid of dead code so that we don't waste effort fusing it.
-  EliminateDeadCode(graph);
+  EliminateDeadCode(graph, db);
 
   TensorExprFuser fuser(
-      graph, min_group_size, add_composed_op, fuse_to_dynamic_shapes);
+      graph, min_group_size, add_composed_op, fuse_to_dynamic_shapes, &db);
   fuser.run();
+  // The fuser keeps `db` valid while it creates fusion groups but not through
+  // inlining and guarding, see TensorExprFuser::run()
+  db.rebuild();
 
-  EliminateCommonSubexpression(graph);
-  EliminateDeadCode(graph);
+  EliminateCommonSubexpression(graph, db);
+  EliminateDeadCode(graph, db);
 
   GRAPH_DUMP("After TExprFuser: ", graph);
 }
@@ -1362,8 +1384,12 @@ static Operation createTensorExprOp(const Node* node) {
   bool dynamic_shape_fusion_node =
       node->hasAttribute(attr::striding_inputs_desc);
   if (!dynamic_shape_fusion_node) {
-    auto kernel =
-        std::make_shared<tensorexpr::TensorExprKernel>(node->g(attr::Subgraph));
+    // Kernels are shared with every graph holding an identical fusion group,
+    // see the fused kernel cache in symbolic_shape_cache.h
+    auto kernel = get_or_compile_fused_kernel(node, [node] {
+      return std::make_shared<tensorexpr::TensorExprKernel>(
+          node->g(attr::Subgraph));
+    });
     return [kernel](Stack& stack) {
       RECORD_FUNCTION(kernel->getKernelName(), std::vector<quarisma::IValue>());
       kernel->run(stack);
@@ -1372,7 +1398,6 @@ static Operation createTensorExprOp(const Node* node) {
   }
 
   // Handle the case when dynamic shape fusion is enabled.
-  VLOG(1) << "Compiling a new kernel for " << *node;
   std::vector<int64_t> sym_shapes;
   if (node->hasAttribute(attr::symbolic_shape_inputs)) {
     sym_shapes = node->is(attr::symbolic_shape_inputs);
@@ -1417,12 +1442,15 @@ static Operation createTensorExprOp(const Node* node) {
   }
 
   std::shared_ptr<tensorexpr::TensorExprKernel> kernel =
-      std::make_shared<tensorexpr::TensorExprKernel>(
-          subgraph,
-          custom_lowerings,
-          sym_shapes,
-          /*pre_alloc*/ false,
-          stride_map);
+      get_or_compile_fused_kernel(node, [&] {
+        VLOG(1) << "Compiling a new kernel for " << *node;
+        return std::make_shared<tensorexpr::TensorExprKernel>(
+            subgraph,
+            custom_lowerings,
+            sym_shapes,
+            /*pre_alloc*/ false,
+            stride_map);
+      });
 
   auto num_subgraph_inputs = subgraph->inputs().size();
   return [kernel, num_subgraph_inputs, allow_stack_outputs](Stack& stack) {
@@ -18,6 +18,16 @@ TORCH_API void FuseTensorExprs(
     bool                    add_composed_op        = false,
     bool                    fuse_to_dynamic_shapes = false);
 
+// Same, with `db` holding the alias analysis of `graph`. It is used by the
+// fuser and the cleanup passes around it, and left valid for the caller, so
+// that a pass pipeline can share one instance.
+TORCH_API void FuseTensorExprs(
+    std::shared_ptr<Graph>& graph,
+    AliasDb&                db,
+    size_t                  min_group_size         = 2,
+    bool                    add_composed_op        = false,
+    bool                    fuse_to_dynamic_shapes = false);
+
 TORCH_API void setTensorExprFuserEnabled(bool val);
 TORCH_API bool tensorExprFuserEnabled();
 TORCH_API void setTensorExprDynamicShapeFusionEnabled(bool val);
@@ -142,14 +142,22 @@ bool MemoryDAG::mayContainAlias(
     return all_a_mlocs.intersects(all_b_mlocs);
 }
 
+MemoryDAGBuilder::MemoryDAGBuilder(MemoryDAG&& dag)
+    : indexToElementMap_(std::move(dag.indexToElementMap_)),
+      firstNewIndex_(static_cast<unsigned>(indexToElementMap_.size()))
+{
+}
+
 void MemoryDAGBuilder::makePointerTo(Element* from, Element* to)
 {
+    modifiedExisting_ |= from->index < firstNewIndex_;
     makePointerToImpl(from, to);
 }
 
 void MemoryDAGBuilder::addToContainedElements(Element* elem, Element* container)
 {
     TORCH_INTERNAL_ASSERT(elem != container, "Elements cannot contain themselves");
+    modifiedExisting_ |= container->index < firstNewIndex_;
     container->containedElements.set(elem->index);
 }
 
@@ -259,4 +267,45 @@ Element* MemoryDAG::unsafeMakeFreshValue(const Value* v)
 {
     return makeFreshValueImpl(v, indexToElementMap_);
 }
+
+void MemoryDAG::unsafeReplaceElement(Element* existing, Element* replacement)
+{
+    TORCH_INTERNAL_ASSERT(existing != replacement);
+    bool redirected = false;
+    for (const auto from : existing->pointedFrom)
+    {
+        Element* pointer = fromIndex(from);
+        pointer->pointsTo.reset(existing->index);
+        if (pointer != replacement)
+        {
+            makePointerToImpl(pointer, replacement);
+        }
+        redirected = true;
+    }
+    existing->pointedFrom.clear();
+
+    for (const std::unique_ptr<Element>& e : indexToElementMap_)
+    {
+        if (e->containedElements.test(existing->index))
+        {
+            e->containedElements.reset(existing->index);
+            if (e.get() != replacement)
+            {
+                e->containedElements.set(replacement->index);
+            }
+            redirected = true;
+        }
+    }
+
+    if (!redirected)
+    {
+        return;
+    }
+    // Any memoized set may have been reached through `existing`
+    for (const std::unique_ptr<Element>& e : indexToElementMap_)
+    {
+        e->cachedMemoryLocations_.reset();
+        e->cachedAllContainedMemoryLocations_.reset();
+    }
+}
 }  // namespace torch::jit
@@ -130,6 +130,12 @@ public:
         const quarisma::flat_hash_map<const Value*, Element*>& elementMap,
         const std::function<Element*(const Value*)>&         getWildcardElement);
     Element* unsafeMakeFreshValue(const Value* v);
+    // Make everything that points to or contains `existing` point to or contain
+    // `replacement` instead. Drops all memoized memory locations if anything
+    // was redirected.
+    void unsafeReplaceElement(Element* existing, Element* replacement);
+
+    friend class MemoryDAGBuilder;
 
 private:
     const MemoryLocations& getAllContainedMemoryLocations(const Element* elem) const;
@@ -147,7 +153,11 @@ private:
 class TORCH_API MemoryDAGBuilder
 {
 public:
-    MemoryDAGBuilder()                                   = default;
+    MemoryDAGBuilder() = default;
+    // Reopen a finished DAG to add elements to it. The memoized memory
+    // locations of its elements are kept, so `modifiedExistingElements()` must
+    // be checked before the result is queried again.
+    explicit MemoryDAGBuilder(MemoryDAG&& dag);
     MemoryDAGBuilder(const MemoryDAGBuilder&)            = delete;
     MemoryDAGBuilder& operator=(const MemoryDAGBuilder&) = delete;
 
@@ -165,11 +175,21 @@ public:
     // return it.
     Element* makeFreshValue(const Value* v);
 
+    // Did an edge start from, or a contained element get added to, an element
+    // that existed when the builder was reopened? Such edits can change the
+    // memory locations of elements outside of the ones added since.
+    bool modifiedExistingElements() const { return modifiedExisting_; }
+
+    // Index of the first element added since the builder was reopened
+    unsigned firstNewIndex() const { return firstNewIndex_; }
+
     friend MemoryDAG;
 
 private:
     // `MemoryDAGBuilder` builds up `indexToElementMap_`, then uses
     // the map to construct the `MemoryDAG`
     std::vector<std::unique_ptr<Element>> indexToElementMap_;
+    unsigned                              firstNewIndex_    = 0;
+    bool                                  modifiedExisting_ = false;
 };
 }  // namespace torch::jit
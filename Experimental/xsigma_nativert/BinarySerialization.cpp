@@ -0,0 +1,978 @@
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <torch/nativert/graph/BinarySerialization.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_set>
+
+#include "util/error.h"
+
+namespace torch::nativert
+{
+
+namespace
+{
+
+constexpr char     kMagic[8]  = {'Q', 'N', 'R', 'T', 'G', 'R', 'P', 'H'};
+constexpr uint32_t kVersion   = 1;
+constexpr uint32_t kByteOrder = 0x01020304;
+
+struct FileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint64_t alignment;
+    uint64_t stringsOffset;
+    uint64_t numStrings;
+    uint64_t graphOffset;
+    uint64_t graphSize;
+    uint64_t constantsOffset;
+    uint64_t numConstants;
+};
+static_assert(sizeof(FileHeader) == 80);
+
+// The bytes of a string follow the table of entries
+struct StringEntry
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+// The sizes then the strides of a constant are dim int64 each at dimsOffset
+struct ConstantEntry
+{
+    uint32_t name;
+    uint8_t  dtype;
+    uint8_t  padding[3];
+    uint64_t dim;
+    uint64_t dimsOffset;
+    uint64_t dataOffset;
+    uint64_t nbytes;
+};
+static_assert(sizeof(ConstantEntry) == 40);
+
+// How a value is created when it is first used as a node input, rather
+// than as the output of a node or a graph input
+enum class ValueOrigin : uint8_t
+{
+    NoneOwnedByUser,  // None input whose producer is the node reading it
+    NoneDetached,     // None element of an optional tensor list
+    ConstantSymInt,
+};
+
+constexpr uint8_t kRequiresGrad     = 1 << 0;
+constexpr uint8_t kHasSymbolicShape = 1 << 1;
+
+constexpr uint64_t alignUp(uint64_t offset, uint64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+namespace detail
+{
+
+class BinaryGraphWriter
+{
+public:
+    void writeGraph(const Graph& graph)
+    {
+        GraphState state;
+        state.constantSymInts = graph.getConstantSymIntValues();
+
+        const auto& inputs = graph.inputs();
+        put<uint32_t>(inputs.size());
+        for (const Value* input : inputs)
+        {
+            // Constant graph inputs have no Value
+            put<uint8_t>(input != nullptr);
+            if (input)
+            {
+                putString(input->name());
+                writeType(input->type());
+                state.index.emplace(input, state.index.size());
+            }
+        }
+
+        uint32_t numNodes = 0;
+        for (const Node& node : graph.nodes())
+        {
+            numNodes += !isBoundary(node);
+        }
+        put<uint32_t>(numNodes);
+        for (const Node& node : graph.nodes())
+        {
+            if (!isBoundary(node))
+            {
+                writeNode(node, state);
+            }
+        }
+
+        const auto outputs = graph.outputs();
+        put<uint32_t>(outputs.size());
+        for (const Value* output : outputs)
+        {
+            writeValueRef(output, nullptr, state);
+        }
+
+        uint32_t numConstantOutputs = 0;
+        for (const auto& output : graph.userOutputs())
+        {
+            numConstantOutputs += std::holds_alternative<Constant>(output);
+        }
+        put<uint32_t>(numConstantOutputs);
+        for (const auto& output : graph.userOutputs())
+        {
+            if (const auto* constant = std::get_if<Constant>(&output))
+            {
+                writeConstant(*constant);
+            }
+        }
+
+        writeSignature(graph.signature());
+        writeTensorMetaMap(graph.weightsMeta());
+        writeTensorMetaMap(graph.tensorValuesMeta());
+    }
+
+    uint32_t intern(std::string_view s)
+    {
+        auto [it, inserted] = stringIndex_.emplace(std::string(s), strings_.size());
+        if (inserted)
+        {
+            strings_.push_back(&it->first);
+        }
+        return it->second;
+    }
+
+    const std::vector<const std::string*>& strings() const { return strings_; }
+
+    const std::vector<char>& bytes() const { return out_; }
+
+private:
+    struct GraphState
+    {
+        std::unordered_map<const Value*, uint32_t> index;
+        std::unordered_map<ValueId, int>           constantSymInts;
+    };
+
+    static bool isBoundary(const Node& node)
+    {
+        return node.target() == "prim.Input" || node.target() == "prim.Output";
+    }
+
+    template <typename T>
+    void put(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto* p = reinterpret_cast<const char*>(&value);
+        out_.insert(out_.end(), p, p + sizeof(T));
+    }
+
+    void putString(std::string_view s) { put<uint32_t>(intern(s)); }
+
+    void writeType(const Type& type)
+    {
+        put<uint8_t>(static_cast<uint8_t>(type.kind()));
+        if (type.kind() == Type::Kind::CustomObj)
+        {
+            putString(type.classFqn());
+        }
+    }
+
+    void writeNode(const Node& node, GraphState& state)
+    {
+        putString(node.target());
+
+        put<uint32_t>(node.metadata().size());
+        for (const auto& [key, value] : node.metadata())
+        {
+            putString(key);
+            putString(value);
+        }
+
+        put<uint32_t>(node.inputs().size());
+        for (const auto& input : node.inputs())
+        {
+            putString(input.name);
+            writeValueRef(input.value, &node, state);
+        }
+
+        put<uint32_t>(node.attributes().size());
+        for (const auto& attribute : node.attributes())
+        {
+            putString(attribute.name);
+            writeConstant(attribute.value);
+        }
+
+        put<uint32_t>(node.outputs().size());
+        for (const Value* output : node.outputs())
+        {
+            putString(output->name());
+            writeType(output->type());
+            state.index.emplace(output, state.index.size());
+        }
+    }
+
+    // A value not seen yet is defined here, with the next index
+    void writeValueRef(const Value* value, const Node* user, GraphState& state)
+    {
+        auto it = state.index.find(value);
+        if (it != state.index.end())
+        {
+            put<uint32_t>(it->second);
+            return;
+        }
+        QUARISMA_CHECK(
+            user != nullptr, fmt::format("Graph output {} has no producer", value->name()));
+
+        const uint32_t index = state.index.size();
+        put<uint32_t>(index);
+        state.index.emplace(value, index);
+
+        auto symInt = state.constantSymInts.find(value->id());
+        if (symInt != state.constantSymInts.end())
+        {
+            put(ValueOrigin::ConstantSymInt);
+            put<int64_t>(symInt->second);
+        }
+        else if (value->type().kind() == Type::Kind::None)
+        {
+            const Node* producer = value->producer(/*resolve_folded=*/true);
+            QUARISMA_CHECK(
+                producer == user || producer == nullptr,
+                fmt::format("None value {} is produced by another node", value->name()));
+            put(producer ? ValueOrigin::NoneOwnedByUser : ValueOrigin::NoneDetached);
+            putString(value->name());
+        }
+        else
+        {
+            QUARISMA_CHECK(
+                false, fmt::format("Value {} is used before it is produced", value->name()));
+        }
+    }
+
+    void writeConstant(const Constant& constant)
+    {
+        put<uint8_t>(constant.index());
+        std::visit([this](const auto& value) { writeConstantValue(value); }, constant);
+    }
+
+    void writeConstantValue(const None& /*unused*/) {}
+    void writeConstantValue(int64_t value) { put(value); }
+    void writeConstantValue(double value) { put(value); }
+    void writeConstantValue(bool value) { put<uint8_t>(value); }
+    void writeConstantValue(const std::string& value) { putString(value); }
+    void writeConstantValue(quarisma::ScalarType value) { put<int8_t>(static_cast<int8_t>(value)); }
+    void writeConstantValue(quarisma::MemoryFormat value)
+    {
+        put<int8_t>(static_cast<int8_t>(value));
+    }
+    void writeConstantValue(quarisma::Layout value) { put<int8_t>(static_cast<int8_t>(value)); }
+    void writeConstantValue(const quarisma::Device& value) { writeDevice(value); }
+    void writeConstantValue(const std::unique_ptr<Graph>& value) { writeGraph(*value); }
+
+    template <typename T>
+    void writeConstantValue(const std::vector<T>& values)
+    {
+        put<uint32_t>(values.size());
+        for (const auto& value : values)
+        {
+            writeConstantValue(static_cast<T>(value));
+        }
+    }
+
+    void writeDevice(const quarisma::Device& device)
+    {
+        put<int8_t>(static_cast<int8_t>(device.type()));
+        put<int8_t>(static_cast<int8_t>(device.index()));
+    }
+
+    void writeStringMap(const quarisma::FastMap<std::string, std::string>& map)
+    {
+        put<uint32_t>(map.size());
+        for (const auto& [key, value] : map)
+        {
+            putString(key);
+            putString(value);
+        }
+    }
+
+    void writeStringPairs(const std::vector<std::pair<std::string, std::string>>& pairs)
+    {
+        put<uint32_t>(pairs.size());
+        for (const auto& [first, second] : pairs)
+        {
+            putString(first);
+            putString(second);
+        }
+    }
+
+    void writeSignature(const GraphSignature& signature)
+    {
+        writeStringMap(signature.gradientsToParameters_);
+        writeStringMap(signature.gradientsToUserInputs_);
+        writeStringMap(signature.buffersToMutate_);
+        writeStringMap(signature.userInputsToMutate_);
+
+        writeStringPairs(signature.inputsToWeights_);
+        put<int32_t>(signature.numParameters_);
+        put<int32_t>(signature.numPersistentBuffers_);
+        put<int32_t>(signature.numNonPersistentBuffers_);
+        put<int32_t>(signature.numTensorConstants_);
+        put<int32_t>(signature.numCustomObjs_);
+        writeStringPairs(signature.inputsToCustomObjs_);
+
+        put<uint32_t>(signature.userInputs_.size());
+        for (const auto& name : signature.userInputs_)
+        {
+            putString(name);
+        }
+        put<uint32_t>(signature.userOutputs_.size());
+        for (const auto& name : signature.userOutputs_)
+        {
+            put<uint8_t>(name.has_value());
+            if (name)
+            {
+                putString(*name);
+            }
+        }
+        putString(signature.lossOutput_);
+    }
+
+    void writeTensorMeta(const TensorMeta& meta)
+    {
+        put<int8_t>(static_cast<int8_t>(meta.dtype_));
+        put<int8_t>(static_cast<int8_t>(meta.layout_));
+        writeDevice(meta.device_);
+        put<uint8_t>(
+            (meta.requiresGrad_ ? kRequiresGrad : 0) |
+            (meta.hasSymbolicShape_ ? kHasSymbolicShape : 0));
+        put<int64_t>(meta.storage_offset_);
+        writeConstantValue(meta.sizes_);
+        writeConstantValue(meta.strides_);
+    }
+
+    void writeTensorMetaMap(const std::unordered_map<std::string, TensorMeta>& metas)
+    {
+        put<uint32_t>(metas.size());
+        for (const auto& [name, meta] : metas)
+        {
+            putString(name);
+            writeTensorMeta(meta);
+        }
+    }
+
+    std::unordered_map<std::string, uint32_t> stringIndex_;
+    std::vector<const std::string*>           strings_;
+    std::vector<char>                         out_;
+};
+
+class BinaryGraphReader
+{
+public:
+    BinaryGraphReader(const BinaryModel& model, bool loadNodeMetadata)
+        : model_(model),
+          cursor_(model.graph_),
+          end_(model.graph_ + model.graphSize_),
+          loadNodeMetadata_(loadNodeMetadata)
+    {
+    }
+
+    std::unique_ptr<Graph> readGraph()
+    {
+        auto                graph = Graph::createGraph();
+        std::vector<Value*> values;
+
+        const uint32_t numInputs = getCount();
+        for (uint32_t i = 0; i < numInputs; ++i)
+        {
+            if (get<uint8_t>())
+            {
+                const auto name = getString();
+                values.push_back(graph->addInput(name, readType()));
+            }
+            else
+            {
+                graph->addInput();
+            }
+        }
+
+        const uint32_t numNodes = getCount();
+        for (uint32_t i = 0; i < numNodes; ++i)
+        {
+            readNode(*graph, values);
+        }
+
+        const uint32_t numOutputs = getCount();
+        for (uint32_t i = 0; i < numOutputs; ++i)
+        {
+            graph->addOutput(readValueRef(*graph, values, nullptr));
+        }
+
+        const uint32_t numConstantOutputs = getCount();
+        for (uint32_t i = 0; i < numConstantOutputs; ++i)
+        {
+            graph->addConstantOutput(readConstant());
+        }
+
+        graph->setSignature(readSignature());
+        graph->setWeightsMeta(readTensorMetaMap());
+        graph->setTensorValuesMeta(readTensorMetaMap());
+
+        graph->finalize();
+
+        graph->lint();
+        return graph;
+    }
+
+    bool atEnd() const { return cursor_ == end_; }
+
+private:
+    template <typename T>
+    T get()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        QUARISMA_CHECK(
+            static_cast<size_t>(end_ - cursor_) >= sizeof(T), "Truncated binary graph");
+        T value;
+        std::memcpy(&value, cursor_, sizeof(T));
+        cursor_ += sizeof(T);
+        return value;
+    }
+
+    // Every element takes at least one byte, which bounds a corrupt count
+    uint32_t getCount()
+    {
+        const auto count = get<uint32_t>();
+        QUARISMA_CHECK(
+            count <= static_cast<size_t>(end_ - cursor_),
+            fmt::format("Invalid element count {} in binary graph", count));
+        return count;
+    }
+
+    std::string_view getString() { return model_.string(get<uint32_t>()); }
+
+    Type readType()
+    {
+        const auto kind = get<uint8_t>();
+        QUARISMA_CHECK(
+            kind <= static_cast<uint8_t>(Type::Kind::CustomObj),
+            fmt::format("Unknown type kind {} in binary graph", kind));
+        if (static_cast<Type::Kind>(kind) == Type::Kind::CustomObj)
+        {
+            return Type(Type::Kind::CustomObj, std::string(getString()));
+        }
+        return static_cast<Type::Kind>(kind);
+    }
+
+    void readNode(Graph& graph, std::vector<Value*>& values)
+    {
+        const auto target = getString();
+
+        std::unordered_map<std::string, std::string> metadata;
+        const uint32_t                               numMetadata = getCount();
+        for (uint32_t i = 0; i < numMetadata; ++i)
+        {
+            const auto key   = getString();
+            const auto value = getString();
+            if (loadNodeMetadata_)
+            {
+                metadata.emplace(key, value);
+            }
+        }
+
+        Node* node = graph.insertNode(std::string(target), {}, std::move(metadata));
+
+        const uint32_t numInputs = getCount();
+        for (uint32_t i = 0; i < numInputs; ++i)
+        {
+            const auto name = getString();
+            node->addInput(NamedArgument{std::string(name), readValueRef(graph, values, node)});
+        }
+
+        const uint32_t numAttributes = getCount();
+        for (uint32_t i = 0; i < numAttributes; ++i)
+        {
+            const auto name = getString();
+            node->addAttribute(Attribute{std::string(name), readConstant()});
+        }
+
+        const uint32_t numOutputs = getCount();
+        for (uint32_t i = 0; i < numOutputs; ++i)
+        {
+            const auto name = getString();
+            values.push_back(node->addOutput(name, readType()));
+        }
+    }
+
+    Value* readValueRef(Graph& graph, std::vector<Value*>& values, Node* user)
+    {
+        const auto index = get<uint32_t>();
+        if (index < values.size())
+        {
+            return values[index];
+        }
+        QUARISMA_CHECK(
+            index == values.size() && user != nullptr,
+            fmt::format("Invalid value index {} in binary graph", index));
+
+        Value* value = nullptr;
+        switch (get<ValueOrigin>())
+        {
+        case ValueOrigin::NoneOwnedByUser:
+            value = graph.addValue(std::string(getString()), Type::Kind::None, user);
+            break;
+        case ValueOrigin::NoneDetached:
+            value = graph.addValue(std::string(getString()), Type::Kind::None, nullptr);
+            break;
+        case ValueOrigin::ConstantSymInt:
+            value = graph.createConstantSymIntValue(static_cast<int>(get<int64_t>()));
+            break;
+        default:
+            QUARISMA_CHECK(false, "Unknown value origin in binary graph");
+        }
+        values.push_back(value);
+        return value;
+    }
+
+    template <typename T, typename ReadFn>
+    std::vector<T> readVector(ReadFn read)
+    {
+        std::vector<T> ret;
+        const uint32_t count = getCount();
+        ret.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ret.push_back(read());
+        }
+        return ret;
+    }
+
+    quarisma::Device readDevice()
+    {
+        const auto type  = get<int8_t>();
+        const auto index = get<int8_t>();
+        return quarisma::Device(
+            static_cast<quarisma::DeviceType>(type), static_cast<quarisma::DeviceIndex>(index));
+    }
+
+    Constant readConstant()
+    {
+        // Tags are the alternative indices of Constant
+        static_assert(std::variant_size_v<Constant> == 14);
+        switch (get<uint8_t>())
+        {
+        case 0:
+            return None();
+        case 1:
+            return get<int64_t>();
+        case 2:
+            return readVector<int64_t>([this] { return get<int64_t>(); });
+        case 3:
+            return get<double>();
+        case 4:
+            return readVector<double>([this] { return get<double>(); });
+        case 5:
+            return std::string(getString());
+        case 6:
+            return static_cast<quarisma::ScalarType>(get<int8_t>());
+        case 7:
+            return static_cast<quarisma::MemoryFormat>(get<int8_t>());
+        case 8:
+            return static_cast<quarisma::Layout>(get<int8_t>());
+        case 9:
+            return readDevice();
+        case 10:
+            return get<uint8_t>() != 0;
+        case 11:
+            return readVector<bool>([this] { return get<uint8_t>() != 0; });
+        case 12:
+            return readVector<std::string>([this] { return std::string(getString()); });
+        case 13:
+            return readGraph();
+        default:
+            QUARISMA_CHECK(false, "Unknown constant type in binary graph");
+        }
+    }
+
+    quarisma::FastMap<std::string, std::string> readStringMap()
+    {
+        quarisma::FastMap<std::string, std::string> map;
+        const uint32_t                              count = getCount();
+        map.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const auto key = getString();
+            map.emplace(key, getString());
+        }
+        return map;
+    }
+
+    std::vector<std::pair<std::string, std::string>> readStringPairs()
+    {
+        return readVector<std::pair<std::string, std::string>>(
+            [this]
+            {
+                const auto first = getString();
+                return std::pair<std::string, std::string>(first, getString());
+            });
+    }
+
+    GraphSignature readSignature()
+    {
+        GraphSignature signature;
+        signature.gradientsToParameters_ = readStringMap();
+        signature.gradientsToUserInputs_ = readStringMap();
+        signature.buffersToMutate_       = readStringMap();
+        signature.userInputsToMutate_    = readStringMap();
+
+        signature.inputsToWeights_         = readStringPairs();
+        signature.numParameters_           = get<int32_t>();
+        signature.numPersistentBuffers_    = get<int32_t>();
+        signature.numNonPersistentBuffers_ = get<int32_t>();
+        signature.numTensorConstants_      = get<int32_t>();
+        signature.numCustomObjs_           = get<int32_t>();
+        signature.inputsToCustomObjs_      = readStringPairs();
+
+        signature.userInputs_ =
+            readVector<std::string>([this] { return std::string(getString()); });
+        signature.userOutputs_ = readVector<std::optional<std::string>>(
+            [this]() -> std::optional<std::string>
+            {
+                if (get<uint8_t>())
+                {
+                    return std::string(getString());
+                }
+                return std::nullopt;
+            });
+        signature.lossOutput_ = getString();
+        return signature;
+    }
+
+    TensorMeta readTensorMeta()
+    {
+        const auto dtype   = static_cast<quarisma::ScalarType>(get<int8_t>());
+        const auto layout  = static_cast<quarisma::Layout>(get<int8_t>());
+        const auto device  = readDevice();
+        const auto flags   = get<uint8_t>();
+        const auto offset  = get<int64_t>();
+        auto       sizes   = readVector<int64_t>([this] { return get<int64_t>(); });
+        auto       strides = readVector<int64_t>([this] { return get<int64_t>(); });
+        return TensorMeta(
+            dtype,
+            layout,
+            device,
+            (flags & kRequiresGrad) != 0,
+            std::move(sizes),
+            std::move(strides),
+            offset,
+            (flags & kHasSymbolicShape) != 0);
+    }
+
+    std::unordered_map<std::string, TensorMeta> readTensorMetaMap()
+    {
+        std::unordered_map<std::string, TensorMeta> metas;
+        const uint32_t                              count = getCount();
+        metas.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const auto name = getString();
+            metas.emplace(name, readTensorMeta());
+        }
+        return metas;
+    }
+
+    const BinaryModel& model_;
+    const char*        cursor_;
+    const char*        end_;
+    bool               loadNodeMetadata_;
+};
+
+}  // namespace detail
+
+void graphToBinary(
+    const Graph& graph, const std::vector<BinaryConstant>& constants, const std::string& path)
+{
+    detail::BinaryGraphWriter writer;
+    writer.writeGraph(graph);
+
+    std::unordered_set<std::string_view> names;
+    std::vector<ConstantEntry>           entries(constants.size());
+    std::vector<int64_t>                 dims;
+    for (size_t i = 0; i < constants.size(); ++i)
+    {
+        const auto& constant = constants[i];
+        QUARISMA_CHECK(
+            names.insert(constant.name).second,
+            fmt::format("Duplicate constant name {}", constant.name));
+        QUARISMA_CHECK(
+            constant.strides.empty() || constant.strides.size() == constant.sizes.size(),
+            fmt::format(
+                "Constant {} has {} strides for {} dims",
+                constant.name,
+                constant.strides.size(),
+                constant.sizes.size()));
+
+        auto& entry  = entries[i];
+        entry.name   = writer.intern(constant.name);
+        entry.dtype  = static_cast<uint8_t>(constant.dtype);
+        entry.dim    = constant.sizes.size();
+        entry.nbytes = constant.nbytes;
+
+        dims.insert(dims.end(), constant.sizes.begin(), constant.sizes.end());
+        if (constant.strides.empty())
+        {
+            std::vector<int64_t> strides(constant.sizes.size());
+            int64_t              stride = 1;
+            for (size_t d = strides.size(); d-- > 0;)
+            {
+                strides[d] = stride;
+                stride *= constant.sizes[d];
+            }
+            dims.insert(dims.end(), strides.begin(), strides.end());
+        }
+        else
+        {
+            dims.insert(dims.end(), constant.strides.begin(), constant.strides.end());
+        }
+    }
+
+    const auto& strings    = writer.strings();
+    const auto& graphBytes = writer.bytes();
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version   = kVersion;
+    header.byteOrder = kByteOrder;
+    header.alignment = kConstantAlignment;
+
+    uint64_t offset      = sizeof(FileHeader);
+    header.stringsOffset = offset;
+    header.numStrings    = strings.size();
+    offset += strings.size() * sizeof(StringEntry);
+    std::vector<StringEntry> stringEntries;
+    stringEntries.reserve(strings.size());
+    for (const std::string* s : strings)
+    {
+        stringEntries.push_back({offset, s->size()});
+        offset += s->size();
+    }
+
+    header.graphOffset = offset = alignUp(offset, 8);
+    header.graphSize            = graphBytes.size();
+    offset += graphBytes.size();
+
+    header.constantsOffset = offset = alignUp(offset, 8);
+    header.numConstants             = entries.size();
+    offset += entries.size() * sizeof(ConstantEntry);
+    uint64_t dimsOffset = offset;
+    offset += dims.size() * sizeof(int64_t);
+    for (auto& entry : entries)
+    {
+        entry.dimsOffset = dimsOffset;
+        dimsOffset += 2 * entry.dim * sizeof(int64_t);
+        entry.dataOffset = offset = alignUp(offset, kConstantAlignment);
+        offset += entry.nbytes;
+    }
+    header.fileSize = offset;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    QUARISMA_CHECK(out.good(), fmt::format("Failed to open {} for writing", path));
+
+    uint64_t   written = 0;
+    const auto write   = [&](const void* data, size_t size)
+    {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        written += size;
+    };
+    const auto padTo = [&](uint64_t target)
+    {
+        static const char zeros[kConstantAlignment] = {};
+        while (written < target)
+        {
+            write(zeros, std::min<uint64_t>(target - written, sizeof(zeros)));
+        }
+    };
+
+    write(&header, sizeof(header));
+    write(stringEntries.data(), stringEntries.size() * sizeof(StringEntry));
+    for (const std::string* s : strings)
+    {
+        write(s->data(), s->size());
+    }
+    padTo(header.graphOffset);
+    write(graphBytes.data(), graphBytes.size());
+    padTo(header.constantsOffset);
+    write(entries.data(), entries.size() * sizeof(ConstantEntry));
+    write(dims.data(), dims.size() * sizeof(int64_t));
+    for (size_t i = 0; i < constants.size(); ++i)
+    {
+        padTo(entries[i].dataOffset);
+        write(constants[i].data, constants[i].nbytes);
+    }
+
+    out.flush();
+    QUARISMA_CHECK(out.good(), fmt::format("Failed to write {}", path));
+}
+
+std::shared_ptr<BinaryModel> BinaryModel::open(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    QUARISMA_CHECK(
+        fd != -1, fmt::format("Failed to open {}: {}", path, quarisma::utils::str_error(errno)));
+
+    struct stat st{};
+    if (::fstat(fd, &st) == -1)
+    {
+        const int err = errno;
+        ::close(fd);
+        QUARISMA_CHECK(
+            false, fmt::format("Failed to stat {}: {}", path, quarisma::utils::str_error(err)));
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    QUARISMA_CHECK(size >= sizeof(FileHeader), fmt::format("{} is not a binary model", path));
+
+    // Private and writable: pages are shared with the page cache until a
+    // kernel writes to a constant, and the file itself is never modified
+    void*     base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    const int err  = errno;
+    ::close(fd);
+    QUARISMA_CHECK(
+        base != MAP_FAILED,
+        fmt::format("Failed to mmap {}: {}", path, quarisma::utils::str_error(err)));
+
+    std::shared_ptr<BinaryModel> model(new BinaryModel(base, size));
+    model->parse();
+    return model;
+}
+
+BinaryModel::~BinaryModel()
+{
+    ::munmap(base_, size_);
+}
+
+void BinaryModel::parse()
+{
+    FileHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    QUARISMA_CHECK(
+        std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0, "Not a binary model file");
+    QUARISMA_CHECK(
+        header.byteOrder == kByteOrder, "Binary model was written with another byte order");
+    QUARISMA_CHECK(
+        header.version == kVersion,
+        fmt::format("Unsupported binary model version {}", header.version));
+    QUARISMA_CHECK(
+        header.fileSize == size_,
+        fmt::format("Binary model is {} bytes, expected {}", size_, header.fileSize));
+
+    const auto inBounds = [this](uint64_t offset, uint64_t size)
+    { return offset <= size_ && size <= size_ - offset; };
+
+    QUARISMA_CHECK(
+        header.numStrings <= size_ / sizeof(StringEntry) &&
+            inBounds(header.stringsOffset, header.numStrings * sizeof(StringEntry)),
+        "Binary model string table is out of bounds");
+    strings_    = base_ + header.stringsOffset;
+    numStrings_ = header.numStrings;
+    for (size_t i = 0; i < numStrings_; ++i)
+    {
+        StringEntry entry;
+        std::memcpy(&entry, strings_ + i * sizeof(StringEntry), sizeof(entry));
+        QUARISMA_CHECK(
+            inBounds(entry.offset, entry.size), "Binary model string is out of bounds");
+    }
+
+    QUARISMA_CHECK(
+        inBounds(header.graphOffset, header.graphSize), "Binary model graph is out of bounds");
+    graph_     = base_ + header.graphOffset;
+    graphSize_ = header.graphSize;
+
+    QUARISMA_CHECK(
+        header.numConstants <= size_ / sizeof(ConstantEntry) &&
+            inBounds(header.constantsOffset, header.numConstants * sizeof(ConstantEntry)),
+        "Binary model constant table is out of bounds");
+    constants_    = base_ + header.constantsOffset;
+    numConstants_ = header.numConstants;
+    constantIndex_.reserve(numConstants_);
+    for (size_t i = 0; i < numConstants_; ++i)
+    {
+        ConstantEntry entry;
+        std::memcpy(&entry, constants_ + i * sizeof(ConstantEntry), sizeof(entry));
+        QUARISMA_CHECK(
+            entry.dim <= size_ / (2 * sizeof(int64_t)) &&
+                inBounds(entry.dimsOffset, 2 * entry.dim * sizeof(int64_t)) &&
+                inBounds(entry.dataOffset, entry.nbytes) &&
+                entry.dataOffset % header.alignment == 0,
+            "Binary model constant is out of bounds");
+        constantIndex_.emplace(string(entry.name), i);
+    }
+}
+
+std::string_view BinaryModel::string(uint32_t index) const
+{
+    QUARISMA_CHECK(
+        index < numStrings_, fmt::format("Invalid string index {} in binary model", index));
+    StringEntry entry;
+    std::memcpy(&entry, strings_ + index * sizeof(StringEntry), sizeof(entry));
+    return {base_ + entry.offset, entry.size};
+}
+
+std::unique_ptr<Graph> BinaryModel::loadGraph(bool loadNodeMetadata) const
+{
+    detail::BinaryGraphReader reader(*this, loadNodeMetadata);
+    auto                      graph = reader.readGraph();
+    QUARISMA_CHECK(reader.atEnd(), "Trailing bytes after the binary graph");
+    return graph;
+}
+
+std::vector<std::string_view> BinaryModel::constantNames() const
+{
+    std::vector<std::string_view> names;
+    names.reserve(numConstants_);
+    for (size_t i = 0; i < numConstants_; ++i)
+    {
+        ConstantEntry entry;
+        std::memcpy(&entry, constants_ + i * sizeof(ConstantEntry), sizeof(entry));
+        names.push_back(string(entry.name));
+    }
+    return names;
+}
+
+std::optional<BinaryModel::MappedConstant> BinaryModel::constant(std::string_view name)
+{
+    auto it = constantIndex_.find(name);
+    if (it == constantIndex_.end())
+    {
+        return std::nullopt;
+    }
+    return constantAt(it->second);
+}
+
+BinaryModel::MappedConstant BinaryModel::constantAt(size_t index)
+{
+    ConstantEntry entry;
+    std::memcpy(&entry, constants_ + index * sizeof(ConstantEntry), sizeof(entry));
+
+    const auto* dims = reinterpret_cast<const int64_t*>(base_ + entry.dimsOffset);
+    return MappedConstant{
+        string(entry.name),
+        static_cast<quarisma::ScalarType>(entry.dtype),
+        std::vector<int64_t>(dims, dims + entry.dim),
+        std::vector<int64_t>(dims + entry.dim, dims + 2 * entry.dim),
+        // Aliases the ownership of the model, so the mapping outlives the storage
+        std::shared_ptr<void>(shared_from_this(), base_ + entry.dataOffset),
+        entry.nbytes};
+}
+
+}  // namespace torch::nativert
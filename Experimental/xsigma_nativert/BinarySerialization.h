@@ -0,0 +1,123 @@
+#pragma once
+
+#include <torch/nativert/graph/Graph.h>
+#include <quarisma/core/ScalarType.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace torch::nativert
+{
+/**
+ * Binary serialization of a Graph and its constant tensors.
+ *
+ * The json schema has to be parsed and converted node by node, which
+ * dominates the load time of large models. The binary format stores the
+ * Graph as jsonToGraph produces it, so loading only replays the graph
+ * construction. It is meant to be written once from a Graph loaded from
+ * json, and is tied to the byte order of the machine that wrote it.
+ *
+ * Layout, all offsets from the start of the file:
+ *   header
+ *   string table: every name and target, stored once
+ *   graph:        the nodes, values, signature and tensor metadata, as a
+ *                 stream of fixed-width fields that refer to the strings
+ *                 and to earlier values by index
+ *   constants:    a table of fixed-size entries, then the dims of the
+ *                 constants, then their data
+ *
+ * The data of each constant starts on a kConstantAlignment boundary, so
+ * the file is memory-mapped and the constants are used in place as tensor
+ * storage, with no copy.
+ */
+
+inline constexpr size_t kConstantAlignment = 4096;
+
+namespace detail
+{
+class BinaryGraphReader;
+}  // namespace detail
+
+// A tensor to store in the constants section. data must hold nbytes bytes.
+struct BinaryConstant
+{
+    std::string          name;
+    quarisma::ScalarType dtype;
+    std::vector<int64_t> sizes;
+    std::vector<int64_t> strides;  // empty for a contiguous tensor
+    const void*          data;
+    size_t               nbytes;
+};
+
+// Graph -> binary file. Throws if the file cannot be written.
+void graphToBinary(
+    const Graph& graph, const std::vector<BinaryConstant>& constants, const std::string& path);
+
+/**
+ * A binary model file mapped in memory.
+ *
+ * The mapping is private: a kernel that writes to a constant gets its own
+ * copy of the pages it touches and never modifies the file. The mapping
+ * lives as long as the BinaryModel or any MappedConstant::data handed out.
+ */
+class BinaryModel : public std::enable_shared_from_this<BinaryModel>
+{
+public:
+    struct MappedConstant
+    {
+        std::string_view     name;
+        quarisma::ScalarType dtype;
+        std::vector<int64_t> sizes;
+        std::vector<int64_t> strides;
+        // Points into the mapping and keeps it alive, for use as storage
+        std::shared_ptr<void> data;
+        size_t                nbytes;
+    };
+
+    // Throws if the file cannot be mapped or is not a binary model
+    static std::shared_ptr<BinaryModel> open(const std::string& path);
+
+    BinaryModel(const BinaryModel&)            = delete;
+    BinaryModel& operator=(const BinaryModel&) = delete;
+    ~BinaryModel();
+
+    std::unique_ptr<Graph> loadGraph(bool loadNodeMetadata = true) const;
+
+    size_t numConstants() const { return numConstants_; }
+
+    std::vector<std::string_view> constantNames() const;
+
+    // std::nullopt if there is no constant with this name
+    std::optional<MappedConstant> constant(std::string_view name);
+
+private:
+    friend class detail::BinaryGraphReader;
+
+    BinaryModel(void* base, size_t size) : base_(static_cast<char*>(base)), size_(size) {}
+
+    // Checks the header and the bounds of every section
+    void parse();
+
+    std::string_view string(uint32_t index) const;
+    MappedConstant   constantAt(size_t index);
+
+    char*  base_;
+    size_t size_;
+
+    const char* strings_      = nullptr;
+    size_t      numStrings_   = 0;
+    const char* graph_        = nullptr;
+    size_t      graphSize_    = 0;
+    const char* constants_    = nullptr;
+    size_t      numConstants_ = 0;
+
+    std::unordered_map<std::string_view, size_t> constantIndex_;
+};
+
+}  // namespace torch::nativert
@@ -563,6 +563,13 @@ public:
         }
     }
 
+    void setWeightsMeta(std::unordered_map<std::string, TensorMeta> tensorsMeta)
+    {
+        QUARISMA_CHECK(!placementApplied_);
+
+        weightsMeta_ = std::move(tensorsMeta);
+    }
+
     const std::unordered_map<std::string, TensorMeta>& weightsMeta() const { return weightsMeta_; }
 
     std::vector<TensorMeta> userInputsMeta() const
@@ -587,6 +594,13 @@ public:
         }
     }
 
+    void setTensorValuesMeta(std::unordered_map<std::string, TensorMeta> tensorsMeta)
+    {
+        QUARISMA_CHECK(!placementApplied_);
+
+        tensorValuesMeta_ = std::move(tensorsMeta);
+    }
+
     const std::unordered_map<std::string, TensorMeta>& tensorValuesMeta() const
     {
         return tensorValuesMeta_;
@@ -9,6 +9,12 @@
 namespace torch::nativert
 {
 
+namespace detail
+{
+class BinaryGraphWriter;
+class BinaryGraphReader;
+}  // namespace detail
+
 /**
  * @brief An in-memory representation for input and output specs of a graph.
  *
@@ -158,6 +164,9 @@ public:
     torch::_export::GraphSignature serialize() const;
 
 private:
+    friend class detail::BinaryGraphWriter;
+    friend class detail::BinaryGraphReader;
+
     quarisma::FastSet<std::string>                inputNames() const;
     quarisma::FastSet<std::optional<std::string>> outputNames() const;
 
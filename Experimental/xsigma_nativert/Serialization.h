@@ -8,8 +8,9 @@ namespace torch::nativert
 /**
  * This file contains serialization utilities for Graph.
  *
- * There are two serialized representations we care about:
+ * There are three serialized representations we care about:
  * - Json: stable but hard to work with, not really human readable
+ * - Binary: fast to load and mapped in place, see BinarySerialization.h
  * - Debug format: human-readable, not stable.
  */
 
@@ -162,4 +162,33 @@ TensorMeta::TensorMeta(const torch::_export::TensorMeta& tensorMeta)
     }
 }
 
+TensorMeta::TensorMeta(
+    quarisma::ScalarType dtype,
+    quarisma::Layout     layout,
+    quarisma::Device     device,
+    bool                 requiresGrad,
+    std::vector<int64_t> sizes,
+    std::vector<int64_t> strides,
+    int64_t              storageOffset,
+    bool                 hasSymbolicShape)
+    : hasSymbolicShape_(hasSymbolicShape),
+      sizes_(std::move(sizes)),
+      strides_(std::move(strides)),
+      storage_offset_(storageOffset),
+      dtype_(dtype),
+      layout_(layout),
+      requiresGrad_(requiresGrad),
+      device_(device)
+{
+    for (int64_t size : sizes_)
+    {
+        if (size < 0)
+        {
+            numel_ = -1;
+            break;
+        }
+        numel_ *= size;
+    }
+}
+
 }  // namespace torch::nativert
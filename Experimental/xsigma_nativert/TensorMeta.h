@@ -18,11 +18,27 @@ quarisma::MemoryFormat convertJsonMemoryFormat(const torch::_export::MemoryForma
 quarisma::Layout       convertJsonLayout(const torch::_export::Layout& layout);
 quarisma::Device       convertJsonDevice(const torch::_export::Device& device);
 
+namespace detail
+{
+class BinaryGraphWriter;
+}  // namespace detail
+
 class TensorMeta
 {
 public:
     explicit TensorMeta(const torch::_export::TensorMeta& tensorMeta);
 
+    // Symbolic dims and strides are -1, as in the json conversion
+    TensorMeta(
+        quarisma::ScalarType dtype,
+        quarisma::Layout     layout,
+        quarisma::Device     device,
+        bool                 requiresGrad,
+        std::vector<int64_t> sizes,
+        std::vector<int64_t> strides,
+        int64_t              storageOffset,
+        bool                 hasSymbolicShape);
+
     quarisma::IntArrayRef sizes() const
     {
         QUARISMA_CHECK(!hasSymbolicShape_, "TensorMeta has symbolic shape");
@@ -45,6 +61,8 @@ public:
 
     int64_t dim() const { return sizes_.size(); }
 
+    bool hasSymbolicShape() const { return hasSymbolicShape_; }
+
     int64_t numel() const
     {
         QUARISMA_CHECK(!hasSymbolicShape_, "TensorMeta has symbolic shape");
@@ -74,6 +92,8 @@ public:
     // quarisma::SymInt sym_numel() const {}
 
 private:
+    friend class detail::BinaryGraphWriter;
+
     bool hasSymbolicShape_ = false;
 
     std::vector<int64_t> sizes_;
@@ -0,0 +1,23 @@
+#include <torch/nativert/executor/ExecutionFrame.h>
+
+#include <memory>
+
+namespace torch::nativert
+{
+
+ExecutionFrame::ExecutionFrame(const MemoryPlan& plan, size_t numValues)
+    : plan_(&plan), values_(numValues)
+{
+    if (plan.arenaSize() == 0)
+    {
+        return;
+    }
+    storage_.resize(plan.arenaSize() + kArenaAlignment);
+    void*  base  = storage_.data();
+    size_t space = storage_.size();
+    arena_ =
+        static_cast<std::byte*>(std::align(kArenaAlignment, plan.arenaSize(), base, space));
+    QUARISMA_CHECK(arena_ != nullptr, "Cannot align an arena of ", plan.arenaSize(), " bytes");
+}
+
+}  // namespace torch::nativert
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Quarisma/core/ivalue.h>
+#include <torch/nativert/executor/memory/MemoryPlanner.h>
+#include <torch/nativert/graph/Graph.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "parallel/task_graph.h"
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+
+/**
+ * State of one run of a StaticExecutor: a slot per Value and the arena of
+ * the memory plan.
+ *
+ * Both are sized when the frame is created, so running a graph in a frame
+ * allocates nothing beyond what the kernels themselves do. A frame serves one
+ * run at a time; concurrent requests use a frame each. Kernels of a parallel
+ * run share the frame, each writing only the slots of its own outputs.
+ */
+class ExecutionFrame
+{
+public:
+    ExecutionFrame(const MemoryPlan& plan, size_t numValues);
+
+    ExecutionFrame(const ExecutionFrame&)            = delete;
+    ExecutionFrame& operator=(const ExecutionFrame&) = delete;
+
+    const quarisma::IValue& getIValue(ValueId id) const
+    {
+        QUARISMA_CHECK_DEBUG(id >= 0 && static_cast<size_t>(id) < values_.size());
+        return values_[id];
+    }
+
+    quarisma::IValue& getIValue(ValueId id)
+    {
+        QUARISMA_CHECK_DEBUG(id >= 0 && static_cast<size_t>(id) < values_.size());
+        return values_[id];
+    }
+
+    void setIValue(ValueId id, quarisma::IValue value)
+    {
+        QUARISMA_CHECK_DEBUG(id >= 0 && static_cast<size_t>(id) < values_.size());
+        values_[id] = std::move(value);
+    }
+
+    // Drops the frame's reference, so that a planned buffer can be reused
+    void releaseValue(ValueId id) { values_[id] = quarisma::IValue(); }
+
+    // Storage planned for the value, kArenaAlignment-aligned; nullptr when not planned
+    void* buffer(ValueId id) const
+    {
+        const PlannedBuffer* planned = plan_->find(id);
+        return planned != nullptr ? arena_ + planned->offset : nullptr;
+    }
+
+    size_t bufferSize(ValueId id) const
+    {
+        const PlannedBuffer* planned = plan_->find(id);
+        return planned != nullptr ? planned->size : 0;
+    }
+
+    size_t arenaSize() const { return plan_->arenaSize(); }
+
+private:
+    friend class StaticExecutor;
+
+    const MemoryPlan*             plan_;
+    std::vector<quarisma::IValue> values_;
+    std::vector<std::byte>        storage_;
+    std::byte*                    arena_ = nullptr;
+
+    // Parallel runs only: the tasks bound to this frame, and the readers of
+    // each value still to finish
+    std::unique_ptr<task_graph>              tasks_;
+    std::unique_ptr<std::atomic<uint32_t>[]> pendingReaders_;
+};
+
+}  // namespace torch::nativert
@@ -0,0 +1,172 @@
+#include <Quarisma/core/dispatch/Dispatcher.h>
+#include <Quarisma/core/function_schema.h>
+#include <fmt/format.h>
+#include <torch/nativert/executor/ExecutionFrame.h>
+#include <torch/nativert/executor/OpKernel.h>
+#include <torch/nativert/graph/passes/GraphOptimizations.h>
+#include <quarisma/util/StringUtil.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+namespace
+{
+
+/**
+ * Runs a prim.FusedElementwise node: its members are called through the
+ * dispatcher one after the other, each result passed on to the next member
+ * without going through the frame. A member marked inplace calls the in-place
+ * variant of its op when the dispatcher has one, so the chain writes into the
+ * tensor of the first member.
+ *
+ * The schemas and the source of every argument are resolved at construction.
+ */
+class FusedElementwiseKernel : public OpKernel
+{
+public:
+    explicit FusedElementwiseKernel(const Node* node) : OpKernel(node)
+    {
+        const auto& targets = std::get<std::vector<std::string>>(
+            node->getAttribute("targets").value);
+        const auto& chained = std::get<std::vector<std::string>>(
+            node->getAttribute("chained").value);
+        const auto& inplace = std::get<std::vector<bool>>(node->getAttribute("inplace").value);
+        QUARISMA_CHECK(
+            !targets.empty() && chained.size() + 1 == targets.size() &&
+                inplace.size() == chained.size(),
+            "Malformed ",
+            kFusedElementwiseTarget,
+            " node: ",
+            node->toString());
+
+        const auto& constants = node->owningGraph()->getConstantSymIntValues();
+        members_.reserve(targets.size());
+        for (size_t k = 0; k < targets.size(); ++k)
+        {
+            members_.push_back({resolve(targets[k], k > 0 && inplace[k - 1]), {}});
+            Member& member = members_.back();
+            for (const auto& arg : member.op.schema().arguments())
+            {
+                if (k > 0 && arg.name() == chained[k - 1])
+                {
+                    member.args.push_back({Source::Chained, 0, {}});
+                    continue;
+                }
+                const std::string key = fmt::format("{}.{}", k, arg.name());
+                if (const NamedArgument* input = node->tryGetInput(key))
+                {
+                    auto it = constants.find(input->value->id());
+                    if (input->value->producer() == nullptr && it != constants.end())
+                    {
+                        member.args.push_back(
+                            {Source::Constant, 0, quarisma::IValue(int64_t{it->second})});
+                    }
+                    else
+                    {
+                        member.args.push_back({Source::Frame, input->value->id(), {}});
+                    }
+                }
+                else if (const Attribute* attr = node->tryGetAttribute(key))
+                {
+                    member.args.push_back({Source::Constant, 0, constantToIValue(attr->value)});
+                }
+                else
+                {
+                    QUARISMA_CHECK(
+                        arg.default_value().has_value(),
+                        "Missing argument ",
+                        arg.name(),
+                        " of ",
+                        targets[k],
+                        " in ",
+                        node->toString());
+                    member.args.push_back({Source::Constant, 0, *arg.default_value()});
+                }
+            }
+        }
+        output_ = node->outputs()[0]->id();
+    }
+
+    void compute(ExecutionFrame& frame) const override
+    {
+        std::vector<quarisma::IValue> stack;
+        quarisma::IValue              result;
+        for (const Member& member : members_)
+        {
+            stack.clear();
+            for (const Argument& arg : member.args)
+            {
+                switch (arg.source)
+                {
+                case Source::Chained:
+                    stack.push_back(std::move(result));
+                    break;
+                case Source::Frame:
+                    stack.push_back(frame.getIValue(arg.id));
+                    break;
+                case Source::Constant:
+                    stack.push_back(arg.constant);
+                    break;
+                }
+            }
+            member.op.callBoxed(stack);
+            result = std::move(stack[0]);
+        }
+        frame.setIValue(output_, std::move(result));
+    }
+
+private:
+    enum class Source
+    {
+        Chained,
+        Frame,
+        Constant
+    };
+
+    struct Argument
+    {
+        Source           source;
+        ValueId          id;
+        quarisma::IValue constant;
+    };
+
+    struct Member
+    {
+        quarisma::OperatorHandle op;
+        std::vector<Argument>    args;
+    };
+
+    // The in-place variant takes the arguments of the functional op, so the
+    // argument sources do not depend on which one is called
+    static quarisma::OperatorHandle resolve(std::string_view target, bool inplace)
+    {
+        std::vector<std::string_view> atoms = quarisma::split(target, '.');
+        QUARISMA_CHECK(atoms.size() == 5, "Unexpected fused target ", target);
+        const std::string name     = fmt::format("{}::{}", atoms[2], atoms[3]);
+        const std::string overload = atoms[4] == "default" ? "" : std::string(atoms[4]);
+        if (inplace)
+        {
+            if (auto op = quarisma::Dispatcher::singleton().findSchema(
+                    {fmt::format("{}_", name), overload}))
+            {
+                return *op;
+            }
+        }
+        return quarisma::Dispatcher::singleton().findSchemaOrThrow(
+            name.c_str(), overload.c_str());
+    }
+
+    std::vector<Member> members_;
+    ValueId             output_;
+};
+
+}  // namespace
+
+NATIVERT_REGISTER_KERNEL(std::string(kFusedElementwiseTarget), FusedElementwiseKernel);
+
+}  // namespace torch::nativert
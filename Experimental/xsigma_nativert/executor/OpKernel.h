@@ -0,0 +1,111 @@
+#pragma once
+
+#include <torch/nativert/graph/Graph.h>
+#include <quarisma/util/Logging.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+
+class ExecutionFrame;
+
+/**
+ * The executable form of one Node, created once when the graph is loaded.
+ *
+ * A kernel reads its inputs from the frame by the ids of node()->inputs() and
+ * writes its outputs by the ids of node()->outputs(). Outputs the memory
+ * planner placed in the arena have storage ready in
+ * ExecutionFrame::buffer(); kernels should construct their output tensors
+ * over it instead of allocating.
+ */
+class OpKernel
+{
+public:
+    explicit OpKernel(const Node* node) : node_(node) {}
+    virtual ~OpKernel() = default;
+
+    OpKernel(const OpKernel&)            = delete;
+    OpKernel& operator=(const OpKernel&) = delete;
+
+    virtual void compute(ExecutionFrame& frame) const = 0;
+
+    // Estimated work, in the unit of output elements; negative when unknown,
+    // in which case the scheduler estimates it from the TensorMeta
+    virtual int64_t cost() const { return -1; }
+
+    const Node* node() const { return node_; }
+
+private:
+    const Node* node_;
+};
+
+using OpKernelFactory = std::function<std::unique_ptr<OpKernel>(const Node*)>;
+
+/**
+ * Maps a Node target, e.g. "aten.add.Tensor", to the factory of its kernel.
+ *
+ * Lookups happen when a graph is loaded, never while it runs.
+ */
+class KernelRegistry
+{
+public:
+    static KernelRegistry& get()
+    {
+        static KernelRegistry instance;
+        return instance;
+    }
+
+    void addKernel(std::string target, OpKernelFactory factory)
+    {
+        if (auto it = registry_.find(target); it != registry_.end())
+        {
+            LOG(WARNING) << "Kernel for " << target << " already registered";
+            return;
+        }
+        registry_.emplace(std::move(target), std::move(factory));
+    }
+
+    bool hasKernel(std::string_view target) const
+    {
+        return registry_.find(std::string{target}) != registry_.end();
+    }
+
+    std::unique_ptr<OpKernel> createKernel(const Node& node) const
+    {
+        auto it = registry_.find(std::string{node.target()});
+        QUARISMA_CHECK(
+            it != registry_.end(),
+            "No kernel registered for ",
+            node.target(),
+            ": ",
+            node.toString());
+        auto kernel = it->second(&node);
+        QUARISMA_CHECK(kernel != nullptr, "Kernel factory for ", node.target(), " returned null");
+        return kernel;
+    }
+
+private:
+    KernelRegistry() = default;
+
+    std::unordered_map<std::string, OpKernelFactory> registry_;
+};
+
+// Registers KernelClass, constructible from a const Node*, for target
+#define NATIVERT_REGISTER_KERNEL(target, KernelClass)                        \
+    static const bool nativert_kernel_registered_##KernelClass = []          \
+    {                                                                        \
+        ::torch::nativert::KernelRegistry::get().addKernel(                  \
+            target,                                                          \
+            [](const ::torch::nativert::Node* node)                          \
+            { return std::make_unique<KernelClass>(node); });                \
+        return true;                                                         \
+    }()
+
+}  // namespace torch::nativert
@@ -0,0 +1,164 @@
+#include <torch/nativert/executor/ParallelSchedule.h>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <unordered_map>
+
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+
+namespace
+{
+
+constexpr int64_t kUnknownCost = std::numeric_limits<int64_t>::max();
+
+int64_t estimateCost(const Graph& graph, const Node& node)
+{
+    int64_t     cost  = 0;
+    const auto& metas = graph.tensorValuesMeta();
+    for (const Value* output : node.outputs())
+    {
+        if (output->type().kind() != Type::Kind::Tensor)
+        {
+            continue;
+        }
+        auto it = metas.find(std::string{output->name()});
+        if (it == metas.end() || it->second.hasSymbolicShape())
+        {
+            return kUnknownCost;
+        }
+        cost += it->second.numel();
+    }
+    return cost;
+}
+
+}  // namespace
+
+ParallelSchedule::ParallelSchedule(
+    const Graph&                                  graph,
+    const std::vector<std::unique_ptr<OpKernel>>& kernels,
+    int64_t                                       inlineCostThreshold)
+{
+    std::vector<const Node*>                   nodes;
+    std::unordered_map<const Node*, NodeIndex> indices;
+    for (const Node& node : graph.nodes())
+    {
+        indices.emplace(&node, nodes.size());
+        nodes.push_back(&node);
+    }
+    QUARISMA_CHECK(kernels.size() == nodes.size(), "Expected one kernel slot per node");
+
+    ValueId maxId = -1;
+    for (const Value* value : graph.values())
+    {
+        maxId = std::max(maxId, value->id());
+    }
+    readerCounts_.assign(static_cast<size_t>(maxId + 1), 0);
+    producers_.assign(static_cast<size_t>(maxId + 1), 0);
+    readers_.resize(static_cast<size_t>(maxId + 1));
+    inputs_.resize(nodes.size());
+    costs_.assign(nodes.size(), 0);
+
+    const Node* outputNode = graph.outputNode();
+    for (NodeIndex i = 0; i < nodes.size(); ++i)
+    {
+        for (const Value* output : nodes[i]->outputs())
+        {
+            producers_[output->id()] = i;
+        }
+        for (const auto& input : nodes[i]->inputs())
+        {
+            auto& ids = inputs_[i];
+            if (std::find(ids.begin(), ids.end(), input.value->id()) == ids.end())
+            {
+                ids.push_back(input.value->id());
+                readers_[input.value->id()].push_back(i);
+                if (nodes[i] != outputNode)
+                {
+                    ++readerCounts_[input.value->id()];
+                }
+            }
+        }
+        if (kernels[i] != nullptr)
+        {
+            const int64_t declared = kernels[i]->cost();
+            costs_[i]              = declared >= 0 ? declared : estimateCost(graph, *nodes[i]);
+        }
+    }
+
+    // Descendants of every node, in reverse graph order since it is topological
+    const size_t words = (nodes.size() + 63) / 64;
+    reachable_.assign(nodes.size(), std::vector<uint64_t>(words, 0));
+    for (NodeIndex i = nodes.size(); i-- > 0;)
+    {
+        for (const Value* output : nodes[i]->outputs())
+        {
+            for (NodeIndex user : readers_[output->id()])
+            {
+                reachable_[i][user / 64] |= uint64_t{1} << (user % 64);
+                for (size_t w = 0; w < words; ++w)
+                {
+                    reachable_[i][w] |= reachable_[user][w];
+                }
+            }
+        }
+    }
+
+    // prim.Input and prim.Output have no kernel and no task
+    std::vector<size_t> taskOfNode(nodes.size(), std::numeric_limits<size_t>::max());
+    for (NodeIndex i = 0; i < nodes.size(); ++i)
+    {
+        if (kernels[i] == nullptr)
+        {
+            continue;
+        }
+        std::set<size_t> producerTasks;
+        for (ValueId id : inputs_[i])
+        {
+            const size_t task = taskOfNode[producers_[id]];
+            if (task != std::numeric_limits<size_t>::max())
+            {
+                producerTasks.insert(task);
+            }
+        }
+        if (costs_[i] < inlineCostThreshold && producerTasks.size() == 1)
+        {
+            taskOfNode[i] = *producerTasks.begin();
+            tasks_[taskOfNode[i]].push_back(i);
+            continue;
+        }
+        taskOfNode[i] = tasks_.size();
+        tasks_.push_back({i});
+        for (size_t task : producerTasks)
+        {
+            dependencies_.emplace_back(task, taskOfNode[i]);
+        }
+    }
+}
+
+bool ParallelSchedule::precedes(ValueId first, ValueId second) const
+{
+    const NodeIndex producer = producers_[second];
+    if (!reaches(producers_[first], producer))
+    {
+        return false;
+    }
+    for (NodeIndex reader : readers_[first])
+    {
+        if (!reaches(reader, producer))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParallelSchedule::conflicts(const PlannedBuffer& a, const PlannedBuffer& b) const
+{
+    return !precedes(a.value, b.value) && !precedes(b.value, a.value);
+}
+
+}  // namespace torch::nativert
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <torch/nativert/executor/OpKernel.h>
+#include <torch/nativert/executor/memory/MemoryPlanner.h>
+#include <torch/nativert/graph/Graph.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace torch::nativert
+{
+
+/**
+ * Tasks of a graph for inter-op parallel execution on parallel_thread_pool.
+ *
+ * Nodes are grouped into tasks by a cost model: a node whose estimated cost
+ * is below inlineCostThreshold and whose inputs all come from one task (or
+ * from the graph inputs) runs inline at the end of that task, saving a pool
+ * handoff; every other node starts a task of its own. Tasks depend on the
+ * tasks producing their inputs, so independent branches run concurrently.
+ *
+ * The cost of a node is OpKernel::cost() when the kernel provides one, and
+ * otherwise the number of elements of its statically shaped tensor outputs.
+ * Nodes of unknown cost count as expensive.
+ *
+ * As the order of independent nodes is not fixed, two planned buffers may
+ * only share memory when one value's producer and readers all precede the
+ * other's producer in the data dependencies, which conflicts() checks.
+ */
+class ParallelSchedule
+{
+public:
+    ParallelSchedule(
+        const Graph&                                  graph,
+        const std::vector<std::unique_ptr<OpKernel>>& kernels,
+        int64_t                                       inlineCostThreshold);
+
+    // Node indices, in graph order, of every task
+    const std::vector<std::vector<NodeIndex>>& tasks() const { return tasks_; }
+
+    // (before, after) pairs of task indices
+    const std::vector<std::pair<size_t, size_t>>& dependencies() const { return dependencies_; }
+
+    int64_t cost(NodeIndex node) const { return costs_[node]; }
+
+    // Distinct values each node reads
+    const std::vector<ValueId>& inputsOf(NodeIndex node) const { return inputs_[node]; }
+
+    // Nodes reading the value, prim.Output excluded: the frame releases the
+    // value once they have all run
+    uint32_t readerCount(ValueId id) const { return readerCounts_[id]; }
+
+    // Whether the two buffers can be alive at the same time in some run
+    bool conflicts(const PlannedBuffer& a, const PlannedBuffer& b) const;
+
+private:
+    // Whether every access to first happens before second is produced
+    bool precedes(ValueId first, ValueId second) const;
+
+    bool reaches(NodeIndex from, NodeIndex to) const
+    {
+        return (reachable_[from][to / 64] >> (to % 64) & 1) != 0;
+    }
+
+    std::vector<std::vector<NodeIndex>>    tasks_;
+    std::vector<std::pair<size_t, size_t>> dependencies_;
+    std::vector<int64_t>                   costs_;
+    std::vector<std::vector<ValueId>>      inputs_;
+    std::vector<uint32_t>                  readerCounts_;
+    std::vector<NodeIndex>                 producers_;  // by ValueId
+    std::vector<std::vector<NodeIndex>>    readers_;    // by ValueId
+    std::vector<std::vector<uint64_t>>     reachable_;  // transitive users, one bit per node
+};
+
+}  // namespace torch::nativert
@@ -0,0 +1,248 @@
+#include <torch/nativert/executor/StaticExecutor.h>
+#include <torch/nativert/graph/passes/pass_manager/GraphPasses.h>
+#include <torch/nativert/graph/passes/pass_manager/PassManager.h>
+
+#include <quarisma/util/Logging.h>
+
+#include <utility>
+#include <variant>
+
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+namespace
+{
+
+std::unique_ptr<Graph> loadGraph(std::unique_ptr<Graph> graph, const ExecutorConfig& config)
+{
+    QUARISMA_CHECK(graph != nullptr, "StaticExecutor needs a graph");
+    if (config.optimize)
+    {
+        GraphPassManager(defaultOptimizationPipeline()).run(graph.get());
+    }
+    return graph;
+}
+
+}  // namespace
+
+StaticExecutor::StaticExecutor(
+    std::unique_ptr<Graph>        graph,
+    std::vector<quarisma::IValue> constants,
+    ExecutorConfig                config)
+    : graph_(loadGraph(std::move(graph), config)),
+      constants_(std::move(constants)),
+      config_(config),
+      liveness_(*graph_)
+{
+    const size_t numUserInputs = graph_->userInputs().size();
+    QUARISMA_CHECK(
+        constants_.size() + numUserInputs == graph_->inputs().size(),
+        "Expected ",
+        graph_->inputs().size() - numUserInputs,
+        " constant inputs, got ",
+        constants_.size());
+    for (const Value* input : graph_->inputs())
+    {
+        inputIds_.push_back(input->id());
+    }
+    for (const auto& [id, value] : graph_->getConstantSymIntValues())
+    {
+        constantSymInts_.emplace_back(id, value);
+    }
+
+    for (const Value* value : graph_->values())
+    {
+        QUARISMA_CHECK(
+            !value->isFolded(), "StaticExecutor does not run folded constants: ", value->name());
+    }
+
+    kernels_.reserve(liveness_.numNodes());
+    for (const Node& node : graph_->nodes())
+    {
+        auto& kernel = kernels_.emplace_back();
+        if (&node != graph_->inputNode() && &node != graph_->outputNode())
+        {
+            kernel = KernelRegistry::get().createKernel(node);
+        }
+    }
+
+    if (config_.parallel)
+    {
+        schedule_ =
+            std::make_unique<ParallelSchedule>(*graph_, kernels_, config_.inlineCostThreshold);
+        memoryPlan_ = std::make_unique<MemoryPlan>(
+            *graph_,
+            liveness_,
+            [schedule = schedule_.get()](const PlannedBuffer& a, const PlannedBuffer& b)
+            { return schedule->conflicts(a, b); });
+    }
+    else
+    {
+        memoryPlan_ = std::make_unique<MemoryPlan>(*graph_, liveness_);
+    }
+
+    for (const auto& output : graph_->userOutputs())
+    {
+        Output& out = outputs_.emplace_back();
+        if (std::holds_alternative<Value*>(output))
+        {
+            out.value = std::get<Value*>(output)->id();
+        }
+        else
+        {
+            out.constant = constantToIValue(std::get<Constant>(output));
+        }
+    }
+
+    LOG(INFO) << "StaticExecutor planned " << memoryPlan_->buffers().size()
+              << " intermediate tensors into " << memoryPlan_->arenaSize() << " bytes ("
+              << memoryPlan_->totalBufferSize() << " without sharing)";
+    if (schedule_ != nullptr)
+    {
+        LOG(INFO) << "StaticExecutor grouped " << liveness_.numNodes() << " nodes into "
+                  << schedule_->tasks().size() << " parallel tasks";
+    }
+}
+
+std::unique_ptr<ExecutionFrame> StaticExecutor::createFrame() const
+{
+    auto frame = std::make_unique<ExecutionFrame>(*memoryPlan_, liveness_.lifetimes().size());
+    if (schedule_ == nullptr)
+    {
+        return frame;
+    }
+
+    // Bound once to the frame, whose address is stable
+    ExecutionFrame* const target = frame.get();
+    frame->tasks_                = std::make_unique<task_graph>();
+    for (size_t task = 0; task < schedule_->tasks().size(); ++task)
+    {
+        frame->tasks_->add_node([this, target, task] { runTask(*target, task); });
+    }
+    for (const auto& [before, after] : schedule_->dependencies())
+    {
+        frame->tasks_->add_dependency(
+            static_cast<task_graph::node_id>(before), static_cast<task_graph::node_id>(after));
+    }
+    frame->tasks_->finalize();
+    frame->pendingReaders_ =
+        std::make_unique<std::atomic<uint32_t>[]>(liveness_.lifetimes().size());
+    return frame;
+}
+
+std::vector<quarisma::IValue> StaticExecutor::execute(
+    ExecutionFrame& frame, std::vector<quarisma::IValue> inputs) const
+{
+    QUARISMA_CHECK(
+        constants_.size() + inputs.size() == inputIds_.size(),
+        "Expected ",
+        inputIds_.size() - constants_.size(),
+        " inputs, got ",
+        inputs.size());
+    QUARISMA_CHECK(
+        (schedule_ != nullptr) == (frame.tasks_ != nullptr),
+        "Frame was not created by this executor");
+
+    // Copies share the constants, which are released like any input
+    size_t slot = 0;
+    for (const auto& constant : constants_)
+    {
+        frame.setIValue(inputIds_[slot++], constant);
+    }
+    for (auto& input : inputs)
+    {
+        frame.setIValue(inputIds_[slot++], std::move(input));
+    }
+    for (const auto& [id, value] : constantSymInts_)
+    {
+        frame.setIValue(id, value);
+    }
+
+    if (schedule_ != nullptr)
+    {
+        executeParallel(frame);
+    }
+    else
+    {
+        executeSequential(frame);
+    }
+
+    std::vector<quarisma::IValue> outputs;
+    outputs.reserve(outputs_.size());
+    for (const Output& output : outputs_)
+    {
+        outputs.push_back(output.value >= 0 ? frame.getIValue(output.value) : output.constant);
+    }
+    // Graph outputs are never released during the run
+    for (const Output& output : outputs_)
+    {
+        if (output.value >= 0)
+        {
+            frame.releaseValue(output.value);
+        }
+    }
+    return outputs;
+}
+
+void StaticExecutor::executeSequential(ExecutionFrame& frame) const
+{
+    for (NodeIndex index = 0; index < kernels_.size(); ++index)
+    {
+        if (kernels_[index] != nullptr)
+        {
+            kernels_[index]->compute(frame);
+        }
+        for (ValueId id : liveness_.diesAfter(index))
+        {
+            frame.releaseValue(id);
+        }
+    }
+}
+
+void StaticExecutor::executeParallel(ExecutionFrame& frame) const
+{
+    const size_t numValues = liveness_.lifetimes().size();
+    for (size_t id = 0; id < numValues; ++id)
+    {
+        frame.pendingReaders_[id].store(
+            schedule_->readerCount(static_cast<ValueId>(id)), std::memory_order_relaxed);
+    }
+    // Inputs nothing reads
+    for (ValueId id : inputIds_)
+    {
+        if (schedule_->readerCount(id) == 0 && !liveness_.isGraphOutput(id))
+        {
+            frame.releaseValue(id);
+        }
+    }
+    // task_graph::run() publishes the reset above to the workers
+    frame.tasks_->run(config_.maxThreads);
+}
+
+void StaticExecutor::runTask(ExecutionFrame& frame, size_t task) const
+{
+    for (NodeIndex index : schedule_->tasks()[task])
+    {
+        const OpKernel& kernel = *kernels_[index];
+        kernel.compute(frame);
+
+        for (const Value* output : kernel.node()->outputs())
+        {
+            if (schedule_->readerCount(output->id()) == 0 && !liveness_.isGraphOutput(output->id()))
+            {
+                frame.releaseValue(output->id());
+            }
+        }
+        for (ValueId id : schedule_->inputsOf(index))
+        {
+            if (frame.pendingReaders_[id].fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+                !liveness_.isGraphOutput(id))
+            {
+                frame.releaseValue(id);
+            }
+        }
+    }
+}
+
+}  // namespace torch::nativert
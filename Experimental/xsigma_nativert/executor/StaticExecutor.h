@@ -0,0 +1,108 @@
+#pragma once
+
+#include <Quarisma/core/ivalue.h>
+#include <torch/nativert/executor/ExecutionFrame.h>
+#include <torch/nativert/executor/OpKernel.h>
+#include <torch/nativert/executor/ParallelSchedule.h>
+#include <torch/nativert/executor/memory/LivenessAnalysis.h>
+#include <torch/nativert/executor/memory/MemoryPlanner.h>
+#include <torch/nativert/graph/Graph.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace torch::nativert
+{
+
+/**
+ * Runs a Graph with every decision taken when it is loaded.
+ *
+ * The constructor resolves the kernel of each Node through the
+ * KernelRegistry, runs the LivenessAnalysis and plans the intermediate
+ * tensors into one arena. A run then walks the kernels in node order,
+ * releasing each value after its last reader so that its buffer can be
+ * reused, with no lookup or dispatch in between.
+ *
+ * With ExecutorConfig::parallel, a run executes the tasks of a
+ * ParallelSchedule on parallel_thread_pool instead, so that independent
+ * branches proceed concurrently; each value is then released by the last of
+ * its readers to finish, and the memory plan only shares buffers between
+ * values ordered by the data dependencies.
+ *
+ * Unless disabled in the ExecutorConfig, the graph is first rewritten by the
+ * passes of defaultOptimizationPipeline(): SymInt arithmetic on constants is
+ * folded, no-op views and dead nodes are removed and elementwise chains are
+ * fused, so that graph() may differ from the graph passed in.
+ *
+ * Use like:
+ *   StaticExecutor executor(std::move(graph), weights);
+ *   auto frame = executor.createFrame();  // once per serving thread
+ *   auto outputs = executor.execute(*frame, std::move(inputs));
+ */
+struct ExecutorConfig
+{
+    // Run defaultOptimizationPipeline() on the graph before planning it
+    bool optimize = true;
+    // Run independent nodes concurrently on parallel_thread_pool
+    bool parallel = false;
+    // Nodes of lower estimated cost run inline in the task of their producer
+    int64_t inlineCostThreshold = int64_t{1} << 15;
+    // Pool threads a run may use, 0 for all of them
+    size_t maxThreads = 0;
+};
+
+class StaticExecutor
+{
+public:
+    // constants: values of the graph inputs before userInputs() (weights,
+    // custom objects), in graph order
+    StaticExecutor(
+        std::unique_ptr<Graph>        graph,
+        std::vector<quarisma::IValue> constants,
+        ExecutorConfig                config = {});
+
+    StaticExecutor(const StaticExecutor&)            = delete;
+    StaticExecutor& operator=(const StaticExecutor&) = delete;
+
+    std::unique_ptr<ExecutionFrame> createFrame() const;
+
+    // inputs: one per userInputs(); returns one value per userOutputs()
+    std::vector<quarisma::IValue> execute(
+        ExecutionFrame& frame, std::vector<quarisma::IValue> inputs) const;
+
+    const Graph& graph() const { return *graph_; }
+
+    const LivenessAnalysis& liveness() const { return liveness_; }
+
+    const MemoryPlan& memoryPlan() const { return *memoryPlan_; }
+
+    // nullptr unless ExecutorConfig::parallel
+    const ParallelSchedule* parallelSchedule() const { return schedule_.get(); }
+
+private:
+    void executeSequential(ExecutionFrame& frame) const;
+    void executeParallel(ExecutionFrame& frame) const;
+    void runTask(ExecutionFrame& frame, size_t task) const;
+
+    struct Output
+    {
+        ValueId          value = -1;  // -1 for constant outputs
+        quarisma::IValue constant;
+    };
+
+    std::unique_ptr<Graph>                   graph_;
+    std::vector<quarisma::IValue>            constants_;
+    ExecutorConfig                           config_;
+    LivenessAnalysis                         liveness_;
+    std::vector<std::unique_ptr<OpKernel>>   kernels_;  // by node; null for prim.Input/Output
+    std::unique_ptr<ParallelSchedule>        schedule_;
+    std::unique_ptr<MemoryPlan>              memoryPlan_;
+    std::vector<ValueId>                     inputIds_;  // constants first, then user inputs
+    std::vector<std::pair<ValueId, int64_t>> constantSymInts_;  // set at the start of each run
+    std::vector<Output>                      outputs_;
+};
+
+}  // namespace torch::nativert
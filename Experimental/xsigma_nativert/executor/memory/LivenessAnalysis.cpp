@@ -0,0 +1,84 @@
+#include <torch/nativert/executor/memory/LivenessAnalysis.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+
+LivenessAnalysis::LivenessAnalysis(const Graph& graph)
+{
+    std::unordered_map<const Node*, NodeIndex> indices;
+    for (const Node& node : graph.nodes())
+    {
+        indices.emplace(&node, numNodes_++);
+    }
+
+    ValueId maxId = -1;
+    for (const Value* value : graph.values())
+    {
+        maxId = std::max(maxId, value->id());
+    }
+    lifetimes_.resize(static_cast<size_t>(maxId + 1));
+    isGraphOutput_.resize(static_cast<size_t>(maxId + 1), false);
+    diesAfter_.resize(numNodes_);
+
+    for (const Value* value : graph.outputs())
+    {
+        isGraphOutput_[value->id()] = true;
+    }
+
+    for (const Value* value : graph.values())
+    {
+        // Folded values are constants: no node produces them at run time
+        const Node* producer = value->producer();
+        if (producer == nullptr)
+        {
+            continue;
+        }
+        auto producerIt = indices.find(producer);
+        QUARISMA_CHECK(
+            producerIt != indices.end(), "Value ", value->name(), " produced outside the graph");
+
+        NodeIndex end = producerIt->second;
+        for (const Node* user : value->users())
+        {
+            auto userIt = indices.find(user);
+            QUARISMA_CHECK(
+                userIt != indices.end(), "Value ", value->name(), " read outside the graph");
+            end = std::max(end, userIt->second);
+        }
+        if (isGraphOutput_[value->id()])
+        {
+            end = numNodes_ - 1;
+        }
+
+        lifetimes_[value->id()] = ValueLifetime{value->id(), producerIt->second, end};
+        if (!isGraphOutput_[value->id()])
+        {
+            diesAfter_[end].push_back(value->id());
+        }
+    }
+}
+
+const std::optional<ValueLifetime>& LivenessAnalysis::lifetime(ValueId id) const
+{
+    QUARISMA_CHECK(
+        id >= 0 && static_cast<size_t>(id) < lifetimes_.size(), "Unknown value id ", id);
+    return lifetimes_[id];
+}
+
+const std::vector<ValueId>& LivenessAnalysis::diesAfter(NodeIndex index) const
+{
+    QUARISMA_CHECK(index < diesAfter_.size(), "Node index ", index, " out of range");
+    return diesAfter_[index];
+}
+
+bool LivenessAnalysis::isGraphOutput(ValueId id) const
+{
+    return id >= 0 && static_cast<size_t>(id) < isGraphOutput_.size() && isGraphOutput_[id];
+}
+
+}  // namespace torch::nativert
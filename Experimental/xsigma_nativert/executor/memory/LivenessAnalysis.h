@@ -0,0 +1,60 @@
+#pragma once
+
+#include <torch/nativert/graph/Graph.h>
+
+#include <optional>
+#include <vector>
+
+namespace torch::nativert
+{
+
+/**
+ * Steps of the graph, in node order, during which a Value must stay alive:
+ * from the node that produces it to the last node that reads it, both
+ * included, since a node reads its inputs while it writes its outputs.
+ */
+struct ValueLifetime
+{
+    ValueId   value;
+    NodeIndex start;
+    NodeIndex end;
+
+    bool overlaps(const ValueLifetime& other) const
+    {
+        return start <= other.end && other.start <= end;
+    }
+};
+
+/**
+ * Lifetimes of the Values produced inside a graph.
+ *
+ * Nodes are indexed in graph order, prim.Input being 0 and prim.Output the
+ * last. Graph inputs are produced by prim.Input, and graph outputs are read
+ * by prim.Output, so they live until the end of the run. Values nothing reads
+ * die with the node that produces them.
+ */
+class LivenessAnalysis
+{
+public:
+    explicit LivenessAnalysis(const Graph& graph);
+
+    size_t numNodes() const { return numNodes_; }
+
+    // Lifetimes of every Value, indexed by ValueId; nullopt for ids no Value has
+    const std::vector<std::optional<ValueLifetime>>& lifetimes() const { return lifetimes_; }
+
+    const std::optional<ValueLifetime>& lifetime(ValueId id) const;
+
+    // Values whose last reader is the node at index, which the executor releases after it
+    const std::vector<ValueId>& diesAfter(NodeIndex index) const;
+
+    bool isGraphOutput(ValueId id) const;
+
+private:
+    size_t                                    numNodes_ = 0;
+    std::vector<std::optional<ValueLifetime>> lifetimes_;
+    std::vector<std::vector<ValueId>>         diesAfter_;
+    std::vector<bool>                         isGraphOutput_;
+};
+
+}  // namespace torch::nativert
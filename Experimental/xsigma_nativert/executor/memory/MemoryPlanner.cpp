@@ -0,0 +1,130 @@
+#include <torch/nativert/executor/memory/MemoryPlanner.h>
+
+#include <quarisma/core/ScalarType.h>
+
+#include <algorithm>
+
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+
+namespace
+{
+
+size_t alignUp(size_t size)
+{
+    return (size + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+}
+
+// Bytes of a statically shaped tensor; 0 when the value cannot be planned
+size_t plannedSize(const Graph& graph, const Value& value)
+{
+    if (value.type().kind() != Type::Kind::Tensor)
+    {
+        return 0;
+    }
+    const auto& metas = graph.tensorValuesMeta();
+    auto        it    = metas.find(std::string{value.name()});
+    if (it == metas.end() || it->second.hasSymbolicShape())
+    {
+        return 0;
+    }
+    const int64_t numel = it->second.numel();
+    if (numel <= 0)
+    {
+        return 0;
+    }
+    return alignUp(static_cast<size_t>(numel) * quarisma::elementSize(it->second.dtype()));
+}
+
+}  // namespace
+
+MemoryPlan::MemoryPlan(
+    const Graph& graph, const LivenessAnalysis& liveness, const ConflictFn& conflict)
+{
+    bufferOfValue_.assign(liveness.lifetimes().size(), -1);
+
+    for (const Value* value : graph.values())
+    {
+        const auto& lifetime = liveness.lifetime(value->id());
+        // Graph inputs come from the caller, graph outputs go back to it
+        if (!lifetime.has_value() || lifetime->start == 0 || liveness.isGraphOutput(value->id()))
+        {
+            continue;
+        }
+        const size_t size = plannedSize(graph, *value);
+        if (size == 0)
+        {
+            continue;
+        }
+        buffers_.push_back(PlannedBuffer{value->id(), 0, size, *lifetime});
+        totalBufferSize_ += size;
+    }
+
+    // Largest first, then by first use, so that the order is deterministic
+    std::sort(
+        buffers_.begin(),
+        buffers_.end(),
+        [](const PlannedBuffer& a, const PlannedBuffer& b)
+        {
+            if (a.size != b.size)
+            {
+                return a.size > b.size;
+            }
+            if (a.lifetime.start != b.lifetime.start)
+            {
+                return a.lifetime.start < b.lifetime.start;
+            }
+            return a.value < b.value;
+        });
+
+    std::vector<const PlannedBuffer*> placed;
+    std::vector<const PlannedBuffer*> conflicts;
+    placed.reserve(buffers_.size());
+    for (auto& buffer : buffers_)
+    {
+        conflicts.clear();
+        for (const PlannedBuffer* other : placed)
+        {
+            if (conflict ? conflict(*other, buffer) : other->lifetime.overlaps(buffer.lifetime))
+            {
+                conflicts.push_back(other);
+            }
+        }
+        std::sort(
+            conflicts.begin(),
+            conflicts.end(),
+            [](const PlannedBuffer* a, const PlannedBuffer* b) { return a->offset < b->offset; });
+
+        // Lowest gap between the live buffers that fits
+        size_t offset = 0;
+        for (const PlannedBuffer* other : conflicts)
+        {
+            if (offset + buffer.size <= other->offset)
+            {
+                break;
+            }
+            offset = std::max(offset, other->offset + other->size);
+        }
+        buffer.offset = offset;
+        arenaSize_    = std::max(arenaSize_, offset + buffer.size);
+        placed.push_back(&buffer);
+    }
+
+    for (size_t i = 0; i < buffers_.size(); ++i)
+    {
+        bufferOfValue_[buffers_[i].value] = static_cast<int>(i);
+    }
+}
+
+const PlannedBuffer* MemoryPlan::find(ValueId id) const
+{
+    if (id < 0 || static_cast<size_t>(id) >= bufferOfValue_.size() || bufferOfValue_[id] < 0)
+    {
+        return nullptr;
+    }
+    return &buffers_[bufferOfValue_[id]];
+}
+
+}  // namespace torch::nativert
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <torch/nativert/executor/memory/LivenessAnalysis.h>
+#include <torch/nativert/graph/Graph.h>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace torch::nativert
+{
+
+// Alignment of every buffer in the arena, enough for any vector load
+inline constexpr size_t kArenaAlignment = 64;
+
+struct PlannedBuffer
+{
+    ValueId       value;
+    size_t        offset;  // from the start of the arena
+    size_t        size;    // rounded up to kArenaAlignment
+    ValueLifetime lifetime;
+};
+
+/**
+ * Placement of the intermediate tensors of a graph in one arena.
+ *
+ * Planned values are the tensors produced by a node, other than the graph
+ * outputs which outlive the run, whose TensorMeta has a static shape. The
+ * others are left to their kernels.
+ *
+ * Buffers are placed greedily by size, largest first, each at the lowest
+ * offset free of every placed buffer that conflicts with it, by default
+ * those whose lifetime overlaps its own, so that values which are never
+ * alive together share memory.
+ */
+class MemoryPlan
+{
+public:
+    // Whether two buffers may be alive at the same time
+    using ConflictFn = std::function<bool(const PlannedBuffer&, const PlannedBuffer&)>;
+
+    // conflict defaults to the overlap of the lifetimes, exact for sequential runs
+    MemoryPlan(
+        const Graph& graph, const LivenessAnalysis& liveness, const ConflictFn& conflict = {});
+
+    size_t arenaSize() const { return arenaSize_; }
+
+    // Bytes the planned values would take without sharing
+    size_t totalBufferSize() const { return totalBufferSize_; }
+
+    const std::vector<PlannedBuffer>& buffers() const { return buffers_; }
+
+    // nullptr when the value is not planned
+    const PlannedBuffer* find(ValueId id) const;
+
+private:
+    std::vector<PlannedBuffer> buffers_;
+    std::vector<int>           bufferOfValue_;  // index in buffers_, -1 when not planned
+    size_t                     arenaSize_       = 0;
+    size_t                     totalBufferSize_ = 0;
+};
+
+}  // namespace torch::nativert
@@ -0,0 +1,549 @@
+#include <Quarisma/core/dispatch/Dispatcher.h>
+#include <fmt/format.h>
+#include <torch/nativert/graph/passes/GraphOptimizations.h>
+#include <quarisma/util/Logging.h>
+#include <quarisma/util/StringUtil.h>
+
+#include <limits>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include "util/exception.h"
+
+namespace torch::nativert
+{
+namespace
+{
+
+// The atoms of a "torch.ops.aten.<name>.<overload>" target
+struct AtenOp
+{
+    std::string_view name;
+    std::string_view overload;
+};
+
+std::optional<AtenOp> parseAtenTarget(std::string_view target)
+{
+    std::vector<std::string_view> atoms = quarisma::split(target, '.');
+    if (atoms.size() != 5 || atoms[0] != "torch" || atoms[1] != "ops" || atoms[2] != "aten" ||
+        atoms[3].empty())
+    {
+        return std::nullopt;
+    }
+    return AtenOp{atoms[3], atoms[4]};
+}
+
+bool isGraphOutput(const Graph& graph, const Value* value)
+{
+    for (const Node* user : value->users())
+    {
+        if (user == graph.outputNode())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const TensorMeta* staticMeta(const Graph& graph, const Value* value)
+{
+    const auto& metas = graph.tensorValuesMeta();
+    auto        it    = metas.find(std::string(value->name()));
+    return it != metas.end() && !it->second.hasSymbolicShape() ? &it->second : nullptr;
+}
+
+void finish(Graph* graph)
+{
+    graph->renumberValues();
+    graph->finalize();
+    graph->lint();
+}
+
+// ----------------------------- constant folding -----------------------------
+
+// Python semantics: the quotient rounds down, the remainder takes the sign of b
+std::optional<int64_t> applySymIntOp(std::string_view target, int64_t a, int64_t b)
+{
+    if (target == "_operator.add")
+    {
+        return a + b;
+    }
+    if (target == "_operator.sub")
+    {
+        return a - b;
+    }
+    if (target == "_operator.mul")
+    {
+        return a * b;
+    }
+    if (b == 0)
+    {
+        return std::nullopt;
+    }
+    const int64_t quotient = a / b - ((a % b != 0 && (a < 0) != (b < 0)) ? 1 : 0);
+    if (target == "_operator.floordiv")
+    {
+        return quotient;
+    }
+    if (target == "_operator.mod")
+    {
+        return a - quotient * b;
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+bool foldConstants(Graph* graph)
+{
+    std::unordered_map<ValueId, int64_t> constants;
+    for (const auto& [id, value] : graph->getConstantSymIntValues())
+    {
+        constants.emplace(id, value);
+    }
+
+    // An operand given either as a constant SymInt value or as an int attribute
+    auto operand = [&](const Node& node, std::string_view name) -> std::optional<int64_t>
+    {
+        if (const NamedArgument* input = node.tryGetInput(name))
+        {
+            auto it = constants.find(input->value->id());
+            if (input->value->producer() == nullptr && it != constants.end())
+            {
+                return it->second;
+            }
+            return std::nullopt;
+        }
+        if (const Attribute* attr = node.tryGetAttribute(name))
+        {
+            if (std::holds_alternative<int64_t>(attr->value))
+            {
+                return std::get<int64_t>(attr->value);
+            }
+        }
+        return std::nullopt;
+    };
+
+    auto fold = [&](const Node& node) -> std::optional<int64_t>
+    {
+        const std::string_view target = node.target();
+        if (target.substr(0, 10) == "_operator.")
+        {
+            auto a = operand(node, "a");
+            auto b = operand(node, "b");
+            return a && b ? applySymIntOp(target, *a, *b) : std::nullopt;
+        }
+        if (target == "torch.ops.aten.sym_size.int")
+        {
+            const NamedArgument* self = node.tryGetInput("self");
+            const TensorMeta*    meta = self ? staticMeta(*graph, self->value) : nullptr;
+            auto                 dim  = operand(node, "dim");
+            if (meta == nullptr || !dim)
+            {
+                return std::nullopt;
+            }
+            const int64_t d = *dim < 0 ? *dim + meta->dim() : *dim;
+            return d >= 0 && d < meta->dim() ? std::optional(meta->sizes()[d]) : std::nullopt;
+        }
+        if (target == "torch.ops.aten.sym_numel.default")
+        {
+            const NamedArgument* self = node.tryGetInput("self");
+            const TensorMeta*    meta = self ? staticMeta(*graph, self->value) : nullptr;
+            return meta != nullptr ? std::optional(meta->numel()) : std::nullopt;
+        }
+        return std::nullopt;
+    };
+
+    std::vector<Node*> nodes;
+    for (auto& node : graph->nodes())
+    {
+        nodes.push_back(&node);
+    }
+
+    size_t folded = 0;
+    for (Node* node : nodes)
+    {
+        if (node->numOutputs() != 1 || node->outputs()[0] == nullptr ||
+            node->outputs()[0]->type().kind() != Type::Kind::SymInt ||
+            isGraphOutput(*graph, node->outputs()[0]))
+        {
+            continue;
+        }
+        auto value = fold(*node);
+        if (!value || *value < std::numeric_limits<int>::min() ||
+            *value > std::numeric_limits<int>::max())
+        {
+            continue;
+        }
+        Value* constant = graph->createConstantSymIntValue(static_cast<int>(*value));
+        constants.emplace(constant->id(), *value);
+        graph->replaceAllUses(node->outputs()[0], constant);
+        node->destroy();
+        ++folded;
+    }
+
+    VLOG(1) << "[GraphOptimizations] Folded " << folded << " SymInt nodes";
+    if (folded == 0)
+    {
+        return false;
+    }
+    finish(graph);
+    return true;
+}
+
+// ---------------------------- dead code elimination ----------------------------
+
+namespace
+{
+
+bool mayHaveSideEffects(const Node& node)
+{
+    const std::string_view target = node.target();
+    if (target == "prim.ListPack" || target.substr(0, 10) == "_operator.")
+    {
+        return false;
+    }
+    auto op = parseAtenTarget(target);
+    if (!op)
+    {
+        return true;
+    }
+    return op->name.back() == '_' || op->overload.substr(0, 3) == "out" ||
+           op->name.substr(0, 7) == "_assert";
+}
+
+bool outputsUnused(const Node& node)
+{
+    if (node.numOutputs() == 0)
+    {
+        return false;
+    }
+    for (const Value* output : node.outputs())
+    {
+        if (output != nullptr && !output->users().empty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool eliminateDeadCode(Graph* graph)
+{
+    std::vector<Node*> nodes;
+    for (auto& node : graph->nodes())
+    {
+        if (&node != graph->inputNode() && &node != graph->outputNode())
+        {
+            nodes.push_back(&node);
+        }
+    }
+
+    // Users come after their producers, so a reverse walk sees every node after
+    // the removal of its users
+    std::unordered_set<const Node*> removed;
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+    {
+        Node* node = *it;
+        if (removed.count(node) != 0 || !outputsUnused(*node))
+        {
+            continue;
+        }
+        if (node->target() == "prim.ListUnpack")
+        {
+            // A list must keep its unpack unless it comes from a prim.ListPack,
+            // so an unused unpack goes together with the producer of its list
+            Value* list     = node->inputs()[0].value;
+            Node*  producer = list->producer();
+            if (producer == nullptr || mayHaveSideEffects(*producer) ||
+                list->users().size() != 1 || producer->numOutputs() != 1)
+            {
+                continue;
+            }
+            node->destroy();
+            removed.insert(node);
+            producer->destroy();
+            removed.insert(producer);
+            continue;
+        }
+        if (!mayHaveSideEffects(*node))
+        {
+            node->destroy();
+            removed.insert(node);
+        }
+    }
+
+    VLOG(1) << "[GraphOptimizations] Removed " << removed.size() << " dead nodes";
+    if (removed.empty())
+    {
+        return false;
+    }
+    finish(graph);
+    return true;
+}
+
+// ---------------------------- view elimination ----------------------------
+
+namespace
+{
+
+bool isViewTarget(std::string_view target)
+{
+    return target == "torch.ops.aten.view.default" || target == "torch.ops.aten.reshape.default" ||
+           target == "torch.ops.aten._unsafe_view.default";
+}
+
+}  // namespace
+
+bool eliminateRedundantViews(Graph* graph)
+{
+    std::vector<Node*> nodes;
+    for (auto& node : graph->nodes())
+    {
+        if (isViewTarget(node.target()))
+        {
+            nodes.push_back(&node);
+        }
+    }
+
+    size_t removed   = 0;
+    size_t collapsed = 0;
+    for (Node* node : nodes)
+    {
+        const NamedArgument* self = node->tryGetInput("self");
+        if (self == nullptr || node->numOutputs() != 1)
+        {
+            continue;
+        }
+        Value* input  = self->value;
+        Value* output = node->outputs()[0];
+
+        // Same shape: the view is its input
+        const TensorMeta* inMeta  = staticMeta(*graph, input);
+        const TensorMeta* outMeta = staticMeta(*graph, output);
+        if (inMeta != nullptr && outMeta != nullptr && inMeta->sizes() == outMeta->sizes() &&
+            !isGraphOutput(*graph, output))
+        {
+            graph->replaceAllUses(output, input);
+            node->destroy();
+            ++removed;
+            continue;
+        }
+
+        // A view of a view: reshape the source directly, which is a view of it
+        // since the chain was one. The inner node is then dead.
+        Node* inner = input->producer();
+        if (inner == nullptr || !isViewTarget(inner->target()) || input->users().size() != 1 ||
+            isGraphOutput(*graph, input) || inner->tryGetInput("self") == nullptr)
+        {
+            continue;
+        }
+        Value* source = inner->getInput("self").value;
+        for (auto& arg : node->inputs())
+        {
+            if (arg.name == "self")
+            {
+                arg.value = source;
+            }
+        }
+        input->eraseUser(node);
+        source->addUser(node);
+        if (node->target() != "torch.ops.aten.reshape.default")
+        {
+            node->setTarget("torch.ops.aten.reshape.default");
+            node->updateInputName("size", "shape");
+            node->updateAttributeName("size", "shape");
+        }
+        inner->destroy();
+        ++collapsed;
+    }
+
+    VLOG(1) << "[GraphOptimizations] Removed " << removed << " no-op views, collapsed "
+            << collapsed << " view chains";
+    if (removed + collapsed == 0)
+    {
+        return false;
+    }
+    finish(graph);
+    return true;
+}
+
+// ---------------------------- elementwise fusion ----------------------------
+
+namespace
+{
+
+bool isFusible(const Node& node)
+{
+    static const std::unordered_set<std::string_view> kElementwise = {
+        "abs", "add", "clamp", "clamp_max", "clamp_min", "cos", "div", "elu", "erf", "exp", "gelu",
+        "hardsigmoid", "hardswish", "hardtanh", "leaky_relu", "log", "maximum", "minimum", "mish",
+        "mul", "neg", "pow", "reciprocal", "relu", "rsqrt", "rsub", "sigmoid", "silu", "sin",
+        "sqrt", "sub", "tanh"};
+
+    auto op = parseAtenTarget(node.target());
+    if (!op || kElementwise.count(op->name) == 0 ||
+        (op->overload != "default" && op->overload != "Tensor" && op->overload != "Scalar") ||
+        node.numOutputs() != 1 || node.outputs()[0]->type().kind() != Type::Kind::Tensor)
+    {
+        return false;
+    }
+    for (const auto& attr : node.attributes())
+    {
+        if (std::holds_alternative<std::unique_ptr<Graph>>(attr.value))
+        {
+            return false;
+        }
+    }
+    const std::string name = fmt::format("aten::{}", op->name);
+    return quarisma::Dispatcher::singleton()
+        .findSchema({name, op->overload == "default" ? "" : std::string(op->overload)})
+        .has_value();
+}
+
+// The member the output of node flows into, if the chain goes on
+Node* nextInChain(const Graph& graph, Node* node)
+{
+    Value* output = node->outputs()[0];
+    if (output->users().size() != 1 || isGraphOutput(graph, output))
+    {
+        return nullptr;
+    }
+    Node* user = output->users()[0];
+    if (!isFusible(*user))
+    {
+        return nullptr;
+    }
+    size_t uses = 0;
+    for (const auto& input : user->inputs())
+    {
+        uses += input.value == output ? 1 : 0;
+    }
+    return uses == 1 ? user : nullptr;
+}
+
+Constant copyConstant(const Constant& constant)
+{
+    return std::visit(
+        [](const auto& value) -> Constant
+        {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, std::unique_ptr<Graph>>)
+            {
+                QUARISMA_CHECK(false, "Graph attributes cannot be fused");
+                return None{};
+            }
+            else
+            {
+                return value;
+            }
+        },
+        constant);
+}
+
+void fuseChain(Graph* graph, const std::vector<Node*>& members)
+{
+    std::vector<NamedArgument> inputs;
+    std::vector<std::string>   targets;
+    std::vector<std::string>   chained;
+    std::vector<bool>          inplace;
+    for (size_t k = 0; k < members.size(); ++k)
+    {
+        const Node* member = members[k];
+        targets.emplace_back(member->target());
+        const Value* previous = k > 0 ? members[k - 1]->outputs()[0] : nullptr;
+        for (const auto& input : member->inputs())
+        {
+            if (input.value == previous)
+            {
+                chained.push_back(input.name);
+                const TensorMeta* before = staticMeta(*graph, previous);
+                const TensorMeta* after  = staticMeta(*graph, member->outputs()[0]);
+                inplace.push_back(
+                    input.name == "self" && before != nullptr && after != nullptr &&
+                    before->sizes() == after->sizes() && before->dtype() == after->dtype());
+                continue;
+            }
+            inputs.push_back({fmt::format("{}.{}", k, input.name), input.value});
+        }
+    }
+
+    Node* last  = members.back();
+    Node* fused = graph->createNode(
+        std::string(kFusedElementwiseTarget), std::move(inputs), last->metadata());
+    for (size_t k = 0; k < members.size(); ++k)
+    {
+        for (const auto& attr : members[k]->attributes())
+        {
+            fused->addAttribute({fmt::format("{}.{}", k, attr.name), copyConstant(attr.value)});
+        }
+    }
+    fused->addAttribute({"targets", std::move(targets)});
+    fused->addAttribute({"chained", std::move(chained)});
+    fused->addAttribute({"inplace", std::move(inplace)});
+    graph->insertBefore(fused, last);
+
+    // The fused output takes over the name of the chain's output, under which
+    // its TensorMeta and the graph signature know it
+    Value*            output = last->outputs()[0];
+    const std::string name(output->name());
+    Value*            placeholder = graph->addValue(std::nullopt, Type::Kind::Tensor, nullptr);
+    graph->replaceAllUses(output, placeholder);
+    for (auto it = members.rbegin(); it != members.rend(); ++it)
+    {
+        (*it)->destroy();
+    }
+    Value* fusedOutput = fused->addOutput(name, Type::Kind::Tensor);
+    graph->replaceAllUses(placeholder, fusedOutput);
+    graph->removeValue(placeholder);
+}
+
+}  // namespace
+
+bool fuseElementwiseChains(Graph* graph)
+{
+    std::vector<std::vector<Node*>> chains;
+    std::unordered_set<const Node*> inChain;
+    for (auto& node : graph->nodes())
+    {
+        if (inChain.count(&node) != 0 || !isFusible(node))
+        {
+            continue;
+        }
+        std::vector<Node*> chain{&node};
+        while (Node* next = nextInChain(*graph, chain.back()))
+        {
+            chain.push_back(next);
+        }
+        if (chain.size() < 2)
+        {
+            continue;
+        }
+        inChain.insert(chain.begin(), chain.end());
+        chains.push_back(std::move(chain));
+    }
+
+    size_t fusedNodes = 0;
+    for (const auto& chain : chains)
+    {
+        fuseChain(graph, chain);
+        fusedNodes += chain.size();
+    }
+
+    VLOG(1) << "[GraphOptimizations] Fused " << fusedNodes << " elementwise nodes into "
+            << chains.size() << " nodes";
+    if (chains.empty())
+    {
+        return false;
+    }
+    finish(graph);
+    return true;
+}
+
+}  // namespace torch::nativert
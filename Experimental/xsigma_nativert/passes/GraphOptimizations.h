@@ -0,0 +1,51 @@
+#pragma once
+
+#include <torch/nativert/graph/Graph.h>
+
+namespace torch::nativert
+{
+
+/**
+ * Optimization passes run on exported graphs before they are executed. Each
+ * returns whether it changed the graph, and leaves it renumbered, finalized
+ * and linted when it did.
+ */
+
+// Replaces SymInt arithmetic (_operator.add, sub, mul, floordiv, mod) on
+// constant SymInts, and aten.sym_size/sym_numel of tensors whose TensorMeta
+// has a static shape, by constant SymInt values.
+bool foldConstants(Graph* graph);
+
+// Removes the nodes none of whose outputs is used, unless they may have side
+// effects: in-place and out= variants, asserts and non-aten targets are kept.
+// Unlike Graph::cleanupDeadNodes, nodes not reachable from the outputs but
+// mutating their inputs survive.
+bool eliminateDeadCode(Graph* graph);
+
+// Removes view, reshape and _unsafe_view nodes that keep the static shape of
+// their input, and collapses a chain of them into a single reshape of the
+// first input.
+bool eliminateRedundantViews(Graph* graph);
+
+// Target of the nodes created by fuseElementwiseChains
+inline constexpr std::string_view kFusedElementwiseTarget = "prim.FusedElementwise";
+
+/**
+ * Replaces each chain of two or more elementwise aten ops, where every link
+ * is the only use of the output of the previous one, by one
+ * prim.FusedElementwise node.
+ *
+ * The fused node takes the other inputs of the members as inputs named
+ * "<member>.<argument>", and their attributes likewise, with:
+ *  - targets: the member targets, in order;
+ *  - chained: for each member after the first, the name of the argument
+ *    that receives the output of the previous member;
+ *  - inplace: whether the member may overwrite that output, i.e. it is
+ *    passed as self and the TensorMeta of the member keeps its shape and
+ *    dtype.
+ * Intermediate results then never reach the execution frame, and the
+ * in-place members reuse the buffer of the first one.
+ */
+bool fuseElementwiseChains(Graph* graph);
+
+}  // namespace torch::nativert
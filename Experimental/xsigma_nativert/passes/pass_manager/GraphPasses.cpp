@@ -1,3 +1,4 @@
+#include <torch/nativert/graph/passes/GraphOptimizations.h>
 #include <torch/nativert/graph/passes/SubgraphRewriter.h>
 #include <torch/nativert/graph/passes/pass_manager/GraphPassRegistry.h>
 #include <torch/nativert/graph/passes/pass_manager/GraphPasses.h>
@@ -96,6 +97,18 @@ void register_base_passes()
 
             return mutated;
         });
+
+    GraphPassRegistry::add_pass("ConstantFolding", foldConstants);
+    GraphPassRegistry::add_pass("RemoveRedundantViews", eliminateRedundantViews);
+    GraphPassRegistry::add_pass("DeadCodeElimination", eliminateDeadCode);
+    GraphPassRegistry::add_pass("FuseElementwise", fuseElementwiseChains);
+}
+
+GraphPassPipeline defaultOptimizationPipeline()
+{
+    // Folding and view elimination leave nodes dead, which then do not cut
+    // elementwise chains
+    return {"ConstantFolding", "RemoveRedundantViews", "DeadCodeElimination", "FuseElementwise"};
 }
 
 }  // namespace torch::nativert
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <torch/nativert/graph/passes/pass_manager/PassPipeline.h>
+
 namespace torch::nativert
 {
 
 void register_base_passes();
 
+// The passes StaticExecutor runs on a graph when it is loaded
+GraphPassPipeline defaultOptimizationPipeline();
+
 }  // namespace torch::nativert
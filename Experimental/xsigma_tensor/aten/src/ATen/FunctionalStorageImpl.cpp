@@ -5,6 +5,8 @@
 #include <Quarisma/core/LegacyTypeDispatch.h>
 #include <c10/util/Exception.h>
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 namespace at::functionalization
@@ -64,6 +66,47 @@ static const Tensor apply_update(const FunctionalStorageImpl::Update& update, co
     return t;
 }
 
+// Note [Functionalization: In-place Reapply]
+// apply_update() rebuilds the base through the view inverses, allocating a new
+// base for every update: twice the memory traffic of the eager mutation. When
+// nothing but the storage holds the base, no other alias can observe it, so if
+// replaying the view chain on it gives an alias of it, the update is written
+// straight into that view instead, as eager mode would. Bases that autograd
+// tracks, inference tensors and chains that copy (view_copy ops, when views
+// are not reapplied) take the out-of-place path.
+static bool apply_update_inplace(const FunctionalStorageImpl::Update& update, const Tensor& base)
+{
+    if (update.view_metas.empty() || !base.has_storage() || base.layout() != c10::kStrided ||
+        base.requires_grad() || base.is_inference() ||
+        base.unsafeGetTensorImpl()->has_symbolic_sizes_strides())
+    {
+        return false;
+    }
+    if (base.use_count() != 1 || base.storage().use_count() != 1 ||
+        update.new_val.is_alias_of(base))
+    {
+        return false;
+    }
+
+    at::Tensor view =
+        at::functionalization::impl::apply_view_meta_sequence(base, update.view_metas);
+    if (!view.is_alias_of(base))
+    {
+        return false;
+    }
+    view.copy_(update.new_val);
+    return true;
+}
+
+// Whether two updates write the same region of the base: the same ViewMeta
+// objects, which only the wrapper that queued them shares
+static bool same_view_chain(
+    const std::vector<std::shared_ptr<ViewMeta>>& a,
+    const std::vector<std::shared_ptr<ViewMeta>>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
 static c10::SymInt get_nbytes(const Tensor& value)
 {
     // The functionalization story when wrapping tensors that don't have storage
@@ -150,6 +193,20 @@ void FunctionalStorageImpl::add_update(
                 "https://github.com/pytorch/pytorch/issues/104505.");
         }
     }
+    // Note [Functionalization: Coalescing Updates]
+    // Updates are only applied when an alias syncs, so an update that
+    // overwrites the region of pending ones makes them dead: a mutation of the
+    // whole base drops every pending update, and a mutation through the view
+    // chain of the last one replaces it. A loop of in-place ops on one view
+    // thus materializes the base once.
+    if (metas.empty())
+    {
+        updates_.clear();
+    }
+    else if (!updates_.empty() && same_view_chain(updates_.back().view_metas, metas))
+    {
+        updates_.pop_back();
+    }
     updates_.push_back({updated_val, metas});
     generation_++;
 }
@@ -164,7 +221,10 @@ bool FunctionalStorageImpl::apply_updates()
     bool                              any_updates = !updates_.empty();
     for (auto& update_data : updates_)
     {
-        base_ = apply_update(update_data, base_);
+        if (!apply_update_inplace(update_data, base_))
+        {
+            base_ = apply_update(update_data, base_);
+        }
     }
     updates_.clear();
     return any_updates;
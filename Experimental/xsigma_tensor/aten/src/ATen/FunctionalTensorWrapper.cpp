@@ -185,6 +185,7 @@ void FunctionalTensorWrapper::mutate_view_meta(
     const std::shared_ptr<at::functionalization::ViewMeta>& meta)
 {
     view_metas_.push_back(meta);
+    composed_view_.reset();
     // Manually track the fact that this tensor received a metadata mutation!
     has_metadata_mutation_ = true;
     // Mark this tensor as being symbolic if there are any symbolic inputs used by the view operation.
@@ -272,10 +273,11 @@ bool FunctionalTensorWrapper::has_data_mutation()
 void FunctionalTensorWrapper::set__impl(const FunctionalTensorWrapper* other)
 {
     // self.set_(src) will cause self to have all of the tensor properties of self.
-    value_       = other->value_;
-    generation_  = other->generation_;
-    view_metas_  = other->view_metas_;
-    is_symbolic_ = other->is_symbolic_;
+    value_         = other->value_;
+    generation_    = other->generation_;
+    view_metas_    = other->view_metas_;
+    composed_view_ = other->composed_view_;
+    is_symbolic_   = other->is_symbolic_;
     // FREEZE the old storage, preventing mutations to it.
     // this is a huge pain to handle properly in all cases, so we ban it.
     functional_storage_impl()->freeze();
@@ -387,6 +389,7 @@ void FunctionalTensorWrapper::_unsafe_reset_storage()
     generation_ = 0;
     // Clear any pre-existing view metas so that base and value_ are semantically the same
     view_metas_.clear();
+    composed_view_.reset();
 }
 
 void FunctionalTensorWrapper::sync_()
@@ -412,13 +415,63 @@ void FunctionalTensorWrapper::regenerate_from_base()
     auto                              t            = storage_impl->base();
 
     TORCH_INTERNAL_ASSERT(!at::functionalization::impl::isFunctionalTensor(t));
-    t = at::functionalization::impl::apply_view_meta_sequence(t, view_metas_);
+    t = replay_view_metas(t);
     TORCH_INTERNAL_ASSERT(!at::functionalization::impl::isFunctionalTensor(t));
 
     replace_(t, /*from_lazy_regenerate=*/true);
     generation_ = storage_impl->generation();
 }
 
+// Note [Functionalization: View Chain Compression]
+// Regenerating a view replays its whole chain of ViewMetas off the base: one
+// op and one intermediate tensor per view, on every sync. When the chain
+// returns an alias of the base, with the dtype and conj/neg bits of the base,
+// its result is a function of the sizes, strides and storage offset of the
+// base alone, and is the as_strided() of the base with the sizes, strides and
+// storage offset of that result. The first replay records them; later replays
+// off a base of the same layout run that single as_strided(). Chains that
+// copy (view_copy ops, when views are not reapplied) and symbolic chains are
+// always replayed in full.
+Tensor FunctionalTensorWrapper::replay_view_metas(const Tensor& base)
+{
+    if (view_metas_.empty())
+    {
+        return base;
+    }
+
+    const bool composable = !is_symbolic_ && base.has_storage() &&
+                            base.layout() == c10::kStrided &&
+                            !base.unsafeGetTensorImpl()->has_symbolic_sizes_strides();
+    if (composable && composed_view_.has_value() &&
+        base.sizes().equals(composed_view_->base_sizes) &&
+        base.strides().equals(composed_view_->base_strides) &&
+        base.storage_offset() == composed_view_->base_storage_offset)
+    {
+        return base.as_strided(
+            composed_view_->sizes, composed_view_->strides, composed_view_->storage_offset);
+    }
+
+    Tensor r = at::functionalization::impl::apply_view_meta_sequence(base, view_metas_);
+    if (composable && r.is_alias_of(base) && r.layout() == c10::kStrided &&
+        !r.unsafeGetTensorImpl()->has_symbolic_sizes_strides() &&
+        r.scalar_type() == base.scalar_type() && r.is_conj() == base.is_conj() &&
+        r.is_neg() == base.is_neg())
+    {
+        composed_view_ = ComposedView{
+            base.sizes().vec(),
+            base.strides().vec(),
+            base.storage_offset(),
+            r.sizes().vec(),
+            r.strides().vec(),
+            r.storage_offset()};
+    }
+    else
+    {
+        composed_view_.reset();
+    }
+    return r;
+}
+
 bool FunctionalTensorWrapper::apply_updates()
 {
     // Apply all updates on alias_
@@ -449,6 +502,7 @@ void FunctionalTensorWrapper::copy_tensor_metadata(
     dest_impl->is_symbolic_           = src_impl->is_symbolic_;
     dest_impl->generation_            = src_impl->generation_;
     dest_impl->view_metas_            = src_impl->view_metas_;
+    dest_impl->composed_view_         = src_impl->composed_view_;
 }
 
 void FunctionalTensorWrapper::copy_tensor_metadata_and_refresh(
@@ -10,6 +10,10 @@
 #include <Quarisma/core/dispatch/Dispatcher.h>
 #include <c10/core/DispatchKey.h>
 
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 namespace at
 {
 
@@ -270,6 +274,22 @@ private:
     size_t                                                        generation_ = 0;
     std::vector<std::shared_ptr<at::functionalization::ViewMeta>> view_metas_;
 
+    // view_metas_ composed into one as_strided() of a base of the recorded
+    // layout, see Note [Functionalization: View Chain Compression]
+    struct ComposedView
+    {
+        std::vector<int64_t> base_sizes;
+        std::vector<int64_t> base_strides;
+        int64_t              base_storage_offset = 0;
+        std::vector<int64_t> sizes;
+        std::vector<int64_t> strides;
+        int64_t              storage_offset = 0;
+    };
+    std::optional<ComposedView> composed_view_;
+
+    // base with view_metas_ replayed on it
+    Tensor replay_view_metas(const Tensor& base);
+
 protected:
     static void copy_tensor_metadata(
         const FunctionalTensorWrapper* src_impl,
@@ -63,6 +63,17 @@ class RegistrationListenerList;
 }
 class SchemaRegistrationHandleRAII;
 
+// Note [Uncached Kernel Lookup]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// call() and redispatch() resolve the kernel with OperatorEntry::lookup on
+// every invocation. That lookup is a highest-bit scan of the key set, an
+// offsets table read and an index into the operator's dispatch table, so it
+// is already a handful of instructions with no hashing or locking. A
+// per-thread (operator, key set) -> kernel cache was tried on top of it and
+// removed: it needs a generation counter that every registration path must
+// bump, a probe costs about as much as the lookup it replaces, and there was
+// no benchmark showing a win. Measure against this path before adding one.
+
 /**
  * Top-level dispatch interface for dispatching via the dynamic dispatcher.
  * Most end users shouldn't use this directly; if you're trying to register
@@ -777,6 +788,7 @@ Dispatcher::call(const TypedOperatorHandle<Return(Args...)>& op, Args... args) c
         detail::_print_dispatch_trace("[call]", toString(op.operator_name()), dispatchKeySet);
     }
 #endif
+    // See Note [Uncached Kernel Lookup]
     const KernelFunction& kernel = op.operatorDef_->op.lookup(dispatchKeySet);
 #ifndef PYTORCH_DISABLE_PER_OP_PROFILING
     auto step_callbacks = at::getStepCallbacksUnlessEmpty(at::RecordScope::FUNCTION);
@@ -834,6 +846,7 @@ inline Return Dispatcher::redispatch(
             "[redispatch]", toString(op.operator_name()), currentDispatchKeySet);
     }
 #endif
+    // See Note [Uncached Kernel Lookup]
     const KernelFunction& kernel = op.operatorDef_->op.lookup(currentDispatchKeySet);
     return kernel.template call<Return, Args...>(
         op, currentDispatchKeySet, std::forward<Args>(args)...);
@@ -0,0 +1,151 @@
+#include <Quarisma/cuda/CUDAContext.h>
+#include <Quarisma/cuda/CoreCUDAAllocator.h>
+#include <c10/util/Exception.h>
+
+#include <cuda_runtime_api.h>
+
+#include <new>
+
+#include "memory/gpu/cuda_caching_allocator.h"
+#include "memory/gpu/cuda_pinned_host_allocator.h"
+
+namespace at::cuda
+{
+namespace
+{
+
+using quarisma::gpu::cuda_caching_allocator;
+using quarisma::gpu::cuda_pinned_host_allocator;
+
+struct CoreCUDADeviceAllocator final : public c10::Allocator
+{
+    c10::DataPtr allocate(size_t nbytes) override
+    {
+        const auto   device = c10::cuda::current_device();
+        const Device cuda_device(c10::DeviceType::CUDA, device);
+        if (nbytes == 0)
+        {
+            return {nullptr, nullptr, &Delete, cuda_device};
+        }
+
+        void* data = nullptr;
+        try
+        {
+            data = cuda_caching_allocator::instance(device).allocate(
+                nbytes, getCurrentCUDAStream(device).stream());
+        }
+        catch (const std::bad_alloc&)
+        {
+            TORCH_CHECK_WITH(
+                OutOfMemoryError,
+                false,
+                "CUDA out of memory. Tried to allocate ",
+                nbytes,
+                " bytes on device ",
+                static_cast<int>(device));
+        }
+        return {data, data, &Delete, cuda_device};
+    }
+
+    // The block goes back to the stream it was allocated on, after the
+    // streams recorded with recordStream()
+    static void Delete(void* ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        cudaPointerAttributes attributes{};
+        C10_CUDA_CHECK(cudaPointerGetAttributes(&attributes, ptr));
+        cuda_caching_allocator::instance(attributes.device).deallocate(ptr, 0);
+    }
+
+    c10::DeleterFnPtr raw_deleter() const override { return &Delete; }
+
+    void copy_data(void* dest, const void* src, std::size_t count) const final
+    {
+        C10_CUDA_CHECK(cudaMemcpy(dest, src, count, cudaMemcpyDeviceToDevice));
+    }
+};
+
+struct CoreCUDAPinnedAllocator final : public c10::Allocator
+{
+    c10::DataPtr allocate(size_t nbytes) override
+    {
+        const Device cpu_device(c10::DeviceType::CPU);
+        if (nbytes == 0)
+        {
+            return {nullptr, nullptr, &Delete, cpu_device};
+        }
+
+        void* data = nullptr;
+        try
+        {
+            data = cuda_pinned_host_allocator::instance().allocate(nbytes);
+        }
+        catch (const std::bad_alloc&)
+        {
+            TORCH_CHECK_WITH(
+                OutOfMemoryError,
+                false,
+                "Failed to allocate ",
+                nbytes,
+                " bytes of pinned host memory");
+        }
+        return {data, data, &Delete, cpu_device};
+    }
+
+    static void Delete(void* ptr) { cuda_pinned_host_allocator::instance().deallocate(ptr); }
+
+    c10::DeleterFnPtr raw_deleter() const override { return &Delete; }
+
+    void copy_data(void* dest, const void* src, std::size_t count) const final
+    {
+        default_copy_data(dest, src, count);
+    }
+};
+
+CoreCUDADeviceAllocator device_allocator;
+CoreCUDAPinnedAllocator pinned_allocator;
+
+}  // namespace
+
+c10::Allocator* getCoreCUDADeviceAllocator()
+{
+    return &device_allocator;
+}
+
+c10::Allocator* getCoreCUDAPinnedAllocator()
+{
+    return &pinned_allocator;
+}
+
+void recordStream(const c10::DataPtr& data_ptr, c10::Stream stream)
+{
+    void* ptr = data_ptr.get();
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    TORCH_CHECK(
+        stream.device_type() == c10::DeviceType::CUDA,
+        "recordStream expects a CUDA stream, got a stream on ",
+        stream.device());
+
+    const CUDAStream cuda_stream(stream);
+    if (data_ptr.device().is_cpu())
+    {
+        TORCH_CHECK(
+            data_ptr.get_deleter() == &CoreCUDAPinnedAllocator::Delete,
+            "recordStream: the CPU tensor is not pinned");
+        cuda_pinned_host_allocator::instance().record_stream(ptr, cuda_stream.stream());
+        return;
+    }
+    TORCH_CHECK(
+        data_ptr.get_deleter() == &CoreCUDADeviceAllocator::Delete,
+        "recordStream: the storage was not allocated by the CUDA allocator");
+    cuda_caching_allocator::instance(data_ptr.device().index())
+        .record_stream(ptr, cuda_stream.stream());
+}
+
+}  // namespace at::cuda
@@ -0,0 +1,34 @@
+#pragma once
+#include <c10/core/Allocator.h>
+#include <c10/core/Stream.h>
+
+namespace at::cuda
+{
+
+// Note [Core CUDA allocators]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// CUDA tensors and pinned CPU tensors are allocated from the caching
+// allocators of the Core library: the per-device
+// quarisma::gpu::cuda_caching_allocator::instance() and the process-wide
+// quarisma::gpu::cuda_pinned_host_allocator::instance(). Tensors therefore
+// share one cache, and one set of unified_cache_stats, with every other Core
+// component that allocates through them, and memory_pressure trims them along
+// with the other caches.
+//
+// A device block is allocated on, and freed in the order of, the current
+// stream of its device at allocation time. A tensor used on another stream
+// must be recorded there with recordStream() (Tensor.record_stream()), so that
+// its block is not reused before the work queued on that stream completes.
+// The same holds for pinned buffers read by asynchronous copies.
+
+// Allocator of CUDA tensors on the current device
+TORCH_CUDA_CPP_API c10::Allocator* getCoreCUDADeviceAllocator();
+
+// Allocator of pinned CPU tensors
+TORCH_CUDA_CPP_API c10::Allocator* getCoreCUDAPinnedAllocator();
+
+// Marks the allocation of data_ptr, device or pinned, as used by stream. The
+// pointer must be the start of an allocation of one of the allocators above.
+TORCH_CUDA_CPP_API void recordStream(const c10::DataPtr& data_ptr, c10::Stream stream);
+
+}  // namespace at::cuda
@@ -1,6 +1,7 @@
 #define TORCH_ASSERT_NO_OPERATORS
 #include <Quarisma/EmptyTensor.h>
 #include <Quarisma/cuda/CUDAContext.h>
+#include <Quarisma/cuda/CoreCUDAAllocator.h>
 #include <Quarisma/cuda/EmptyTensor.h>
 
 namespace at::detail
@@ -16,7 +17,7 @@ TensorBase empty_cuda(
     const auto device = device_or_default(device_opt);
     TORCH_INTERNAL_ASSERT(device.is_cuda());
     const DeviceGuard             device_guard(device);
-    auto*                         allocator = at::cuda::getCUDADeviceAllocator();
+    auto*                         allocator = at::cuda::getCoreCUDADeviceAllocator();
     constexpr c10::DispatchKeySet cuda_dks(c10::DispatchKey::CUDA);
     return at::detail::empty_generic(size, allocator, cuda_dks, dtype, memory_format_opt);
 }
@@ -55,7 +56,7 @@ TensorBase empty_strided_cuda(
     const auto device = device_or_default(device_opt);
     TORCH_INTERNAL_ASSERT(device.is_cuda());
     const DeviceGuard             device_guard(device);
-    auto*                         allocator = at::cuda::getCUDADeviceAllocator();
+    auto*                         allocator = at::cuda::getCoreCUDADeviceAllocator();
     constexpr c10::DispatchKeySet cuda_dks(c10::DispatchKey::CUDA);
     return at::detail::empty_strided_generic(size, stride, allocator, cuda_dks, dtype);
 }
@@ -0,0 +1,583 @@
+#include <Quarisma/Quarisma.h>
+#include <Quarisma/WrapDimUtils.h>
+#include <Quarisma/functorch/BatchRules.h>
+#include <Quarisma/functorch/BatchedTensorImpl.h>
+#include <c10/util/Exception.h>
+#include <c10/util/irange.h>
+#include <torch/library.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace at::functorch
+{
+
+std::tuple<Tensor, std::optional<int64_t>> unwrapTensorAtLevel(const Tensor& tensor, int64_t level)
+{
+    auto* batched = maybeGetBatchedImpl(tensor);
+    if (batched == nullptr || batched->level() != level)
+    {
+        return {tensor, std::nullopt};
+    }
+    return {batched->value(), batched->bdim()};
+}
+
+Tensor moveBatchDimToFront(const Tensor& tensor, std::optional<int64_t> bdim)
+{
+    if (!bdim.has_value() || *bdim == 0)
+    {
+        return tensor;
+    }
+    return tensor.movedim(*bdim, 0);
+}
+
+int64_t rankWithoutBatchDim(const Tensor& tensor, std::optional<int64_t> bdim)
+{
+    return tensor.dim() - (bdim.has_value() ? 1 : 0);
+}
+
+Tensor maybePadToLogicalRank(
+    const Tensor& tensor, std::optional<int64_t> bdim, int64_t logical_rank)
+{
+    if (!bdim.has_value())
+    {
+        return tensor;
+    }
+    const int64_t rank = rankWithoutBatchDim(tensor, bdim);
+    if (rank >= logical_rank)
+    {
+        return tensor;
+    }
+    DimVector sizes(tensor.sizes().begin(), tensor.sizes().end());
+    sizes.insert(sizes.begin() + 1, logical_rank - rank, 1);
+    return tensor.view(sizes);
+}
+
+Tensor removeBatchDim(const Tensor& tensor, int64_t level, int64_t batch_size, int64_t out_dim)
+{
+    auto [value, bdim] = unwrapTensorAtLevel(tensor, level);
+    if (bdim.has_value())
+    {
+        TORCH_CHECK(
+            value.size(*bdim) == batch_size,
+            "removeBatchDim: expected a batch of ",
+            batch_size,
+            " but got ",
+            value.size(*bdim));
+        return value.movedim(*bdim, maybe_wrap_dim(out_dim, value.dim()));
+    }
+    out_dim = maybe_wrap_dim(out_dim, value.dim() + 1);
+    DimVector sizes(value.sizes().begin(), value.sizes().end());
+    sizes.insert(sizes.begin() + out_dim, batch_size);
+    return value.unsqueeze(out_dim).expand(sizes);
+}
+
+namespace
+{
+
+int64_t batchedLevel(const Tensor& tensor)
+{
+    auto* batched = maybeGetBatchedImpl(tensor);
+    return batched != nullptr ? batched->level() : -1;
+}
+
+// The level of a call, see Note [Batching rules without a vmap interpreter]
+template <typename... Tensors>
+int64_t callLevel(const Tensors&... tensors)
+{
+    int64_t level = -1;
+    ((level = std::max(level, batchedLevel(tensors))), ...);
+    TORCH_INTERNAL_ASSERT(level >= 0, "A batching rule ran without a batched argument");
+    return level;
+}
+
+// tensor at level, with its batch dim, if any, at the front
+struct PhysicalTensor
+{
+    Tensor                 value;
+    std::optional<int64_t> bdim;
+
+    int64_t logicalRank() const { return rankWithoutBatchDim(value, bdim); }
+
+    // The physical dim of a logical dim
+    int64_t physicalDim(int64_t dim) const
+    {
+        return maybe_wrap_dim(dim, logicalRank()) + (bdim.has_value() ? 1 : 0);
+    }
+};
+
+PhysicalTensor toPhysical(const Tensor& tensor, int64_t level)
+{
+    auto [value, bdim] = unwrapTensorAtLevel(tensor, level);
+    if (!bdim.has_value())
+    {
+        return {std::move(value), std::nullopt};
+    }
+    return {moveBatchDimToFront(value, bdim), 0};
+}
+
+// The physical dims of the logical dims of self, which has a batch dim; all the
+// logical dims when dims is empty or nullopt
+DimVector physicalDims(const PhysicalTensor& self, OptionalIntArrayRef dims)
+{
+    DimVector result;
+    if (!dims.has_value() || dims->empty())
+    {
+        for (const auto d : c10::irange(self.logicalRank()))
+        {
+            result.push_back(d + 1);
+        }
+        return result;
+    }
+    for (const int64_t d : *dims)
+    {
+        result.push_back(self.physicalDim(d));
+    }
+    return result;
+}
+
+// Runs op once on the physical tensors of a pointwise call and wraps the
+// result, whose batch dim is at the front since at least one operand has one
+template <typename Op, typename... Tensors>
+Tensor pointwiseBatchRule(const Op& op, const Tensors&... tensors)
+{
+    const int64_t level        = callLevel(tensors...);
+    int64_t       logical_rank = 0;
+    ((logical_rank = std::max(logical_rank, toPhysical(tensors, level).logicalRank())), ...);
+    auto padded = [level, logical_rank](const Tensor& tensor)
+    {
+        auto physical = toPhysical(tensor, level);
+        return maybePadToLogicalRank(physical.value, physical.bdim, logical_rank);
+    };
+    return makeBatched(op(padded(tensors)...), 0, level);
+}
+
+// Runs op on the physical tensor of self, the only batched argument of a call
+template <typename Op>
+Tensor singleBatchRule(const Tensor& self, const Op& op)
+{
+    const int64_t level    = callLevel(self);
+    auto          physical = toPhysical(self, level);
+    return makeBatched(op(physical), 0, level);
+}
+
+// tensor with a batch dim of batch_size at the front, expanded if it has none
+Tensor withBatchDim(const PhysicalTensor& tensor, int64_t batch_size)
+{
+    if (tensor.bdim.has_value())
+    {
+        return tensor.value;
+    }
+    DimVector sizes(tensor.value.sizes().begin(), tensor.value.sizes().end());
+    sizes.insert(sizes.begin(), batch_size);
+    return tensor.value.unsqueeze(0).expand(sizes);
+}
+
+int64_t batchSize(const PhysicalTensor& a, const PhysicalTensor& b)
+{
+    return a.bdim.has_value() ? a.value.size(0) : b.value.size(0);
+}
+
+// Elementwise ops
+
+#define UNARY_POINTWISE_BATCH_RULE(op)                                              \
+    Tensor op##_batch_rule(const Tensor& self)                                      \
+    {                                                                               \
+        return pointwiseBatchRule([](const Tensor& a) { return at::op(a); }, self); \
+    }
+
+UNARY_POINTWISE_BATCH_RULE(abs)
+UNARY_POINTWISE_BATCH_RULE(neg)
+UNARY_POINTWISE_BATCH_RULE(exp)
+UNARY_POINTWISE_BATCH_RULE(log)
+UNARY_POINTWISE_BATCH_RULE(sqrt)
+UNARY_POINTWISE_BATCH_RULE(reciprocal)
+UNARY_POINTWISE_BATCH_RULE(sin)
+UNARY_POINTWISE_BATCH_RULE(cos)
+UNARY_POINTWISE_BATCH_RULE(tanh)
+UNARY_POINTWISE_BATCH_RULE(erf)
+#undef UNARY_POINTWISE_BATCH_RULE
+
+#define BINARY_POINTWISE_BATCH_RULE(op)                                                  \
+    Tensor op##_batch_rule(const Tensor& self, const Tensor& other)                      \
+    {                                                                                    \
+        return pointwiseBatchRule(                                                       \
+            [](const Tensor& a, const Tensor& b) { return at::op(a, b); }, self, other); \
+    }
+
+BINARY_POINTWISE_BATCH_RULE(mul)
+BINARY_POINTWISE_BATCH_RULE(div)
+BINARY_POINTWISE_BATCH_RULE(maximum)
+BINARY_POINTWISE_BATCH_RULE(minimum)
+BINARY_POINTWISE_BATCH_RULE(eq)
+BINARY_POINTWISE_BATCH_RULE(ne)
+BINARY_POINTWISE_BATCH_RULE(lt)
+BINARY_POINTWISE_BATCH_RULE(le)
+BINARY_POINTWISE_BATCH_RULE(gt)
+BINARY_POINTWISE_BATCH_RULE(ge)
+#undef BINARY_POINTWISE_BATCH_RULE
+
+Tensor add_batch_rule(const Tensor& self, const Tensor& other, const Scalar& alpha)
+{
+    return pointwiseBatchRule(
+        [&alpha](const Tensor& a, const Tensor& b) { return at::add(a, b, alpha); }, self, other);
+}
+
+Tensor sub_batch_rule(const Tensor& self, const Tensor& other, const Scalar& alpha)
+{
+    return pointwiseBatchRule(
+        [&alpha](const Tensor& a, const Tensor& b) { return at::sub(a, b, alpha); }, self, other);
+}
+
+Tensor addcmul_batch_rule(
+    const Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value)
+{
+    return pointwiseBatchRule(
+        [&value](const Tensor& a, const Tensor& b, const Tensor& c)
+        { return at::addcmul(a, b, c, value); },
+        self,
+        tensor1,
+        tensor2);
+}
+
+Tensor addcdiv_batch_rule(
+    const Tensor& self, const Tensor& tensor1, const Tensor& tensor2, const Scalar& value)
+{
+    return pointwiseBatchRule(
+        [&value](const Tensor& a, const Tensor& b, const Tensor& c)
+        { return at::addcdiv(a, b, c, value); },
+        self,
+        tensor1,
+        tensor2);
+}
+
+Tensor lerp_tensor_batch_rule(const Tensor& self, const Tensor& end, const Tensor& weight)
+{
+    return pointwiseBatchRule(
+        [](const Tensor& a, const Tensor& b, const Tensor& c) { return at::lerp(a, b, c); },
+        self,
+        end,
+        weight);
+}
+
+Tensor lerp_scalar_batch_rule(const Tensor& self, const Tensor& end, const Scalar& weight)
+{
+    return pointwiseBatchRule(
+        [&weight](const Tensor& a, const Tensor& b) { return at::lerp(a, b, weight); }, self, end);
+}
+
+// TensorCompare
+
+Tensor where_batch_rule(const Tensor& condition, const Tensor& self, const Tensor& other)
+{
+    return pointwiseBatchRule(
+        [](const Tensor& c, const Tensor& a, const Tensor& b) { return at::where(c, a, b); },
+        condition,
+        self,
+        other);
+}
+
+Tensor clamp_batch_rule(
+    const Tensor& self, const std::optional<Scalar>& min, const std::optional<Scalar>& max)
+{
+    return pointwiseBatchRule([&](const Tensor& a) { return at::clamp(a, min, max); }, self);
+}
+
+// Reductions
+
+Tensor sum_dim_batch_rule(
+    const Tensor&             self,
+    OptionalIntArrayRef       dim,
+    bool                      keepdim,
+    std::optional<ScalarType> dtype)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            if (physical.logicalRank() == 0)
+            {
+                return dtype.has_value() ? physical.value.to(*dtype) : physical.value.clone();
+            }
+            return at::sum(physical.value, physicalDims(physical, dim), keepdim, dtype);
+        });
+}
+
+Tensor sum_batch_rule(const Tensor& self, std::optional<ScalarType> dtype)
+{
+    return sum_dim_batch_rule(self, std::nullopt, false, dtype);
+}
+
+Tensor amax_batch_rule(const Tensor& self, IntArrayRef dim, bool keepdim)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            if (physical.logicalRank() == 0)
+            {
+                return physical.value.clone();
+            }
+            return at::amax(physical.value, physicalDims(physical, dim), keepdim);
+        });
+}
+
+Tensor amin_batch_rule(const Tensor& self, IntArrayRef dim, bool keepdim)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            if (physical.logicalRank() == 0)
+            {
+                return physical.value.clone();
+            }
+            return at::amin(physical.value, physicalDims(physical, dim), keepdim);
+        });
+}
+
+// TensorShape
+
+// The physical sizes of the logical sizes of a tensor with a batch dim at the
+// front
+DimVector physicalSizes(const PhysicalTensor& physical, IntArrayRef sizes)
+{
+    DimVector result;
+    result.reserve(sizes.size() + 1);
+    result.push_back(physical.value.size(0));
+    result.append(sizes.begin(), sizes.end());
+    return result;
+}
+
+Tensor view_batch_rule(const Tensor& self, IntArrayRef size)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        { return physical.value.view(physicalSizes(physical, size)); });
+}
+
+Tensor reshape_batch_rule(const Tensor& self, IntArrayRef shape)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        { return physical.value.reshape(physicalSizes(physical, shape)); });
+}
+
+Tensor expand_batch_rule(const Tensor& self, IntArrayRef size, bool implicit)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            TORCH_CHECK(
+                static_cast<int64_t>(size.size()) >= physical.logicalRank(),
+                "expand: the number of sizes provided (",
+                size.size(),
+                ") must be greater or equal to the number of dimensions in the tensor (",
+                physical.logicalRank(),
+                ")");
+            const auto padded = maybePadToLogicalRank(
+                physical.value, physical.bdim, static_cast<int64_t>(size.size()));
+            return padded.expand(physicalSizes(physical, size), implicit);
+        });
+}
+
+Tensor permute_batch_rule(const Tensor& self, IntArrayRef dims)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            DimVector physical_dims{0};
+            for (const int64_t d : dims)
+            {
+                physical_dims.push_back(physical.physicalDim(d));
+            }
+            return physical.value.permute(physical_dims);
+        });
+}
+
+Tensor transpose_batch_rule(const Tensor& self, int64_t dim0, int64_t dim1)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            // transpose of a 0-d tensor is itself
+            if (physical.logicalRank() == 0)
+            {
+                return physical.value;
+            }
+            return physical.value.transpose(
+                physical.physicalDim(dim0), physical.physicalDim(dim1));
+        });
+}
+
+Tensor unsqueeze_batch_rule(const Tensor& self, int64_t dim)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            return physical.value.unsqueeze(maybe_wrap_dim(dim, physical.logicalRank() + 1) + 1);
+        });
+}
+
+Tensor squeeze_dim_batch_rule(const Tensor& self, int64_t dim)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        {
+            if (physical.logicalRank() == 0)
+            {
+                return physical.value;
+            }
+            return physical.value.squeeze(physical.physicalDim(dim));
+        });
+}
+
+Tensor select_batch_rule(const Tensor& self, int64_t dim, int64_t index)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        { return physical.value.select(physical.physicalDim(dim), index); });
+}
+
+Tensor narrow_batch_rule(const Tensor& self, int64_t dim, int64_t start, int64_t length)
+{
+    return singleBatchRule(
+        self,
+        [&](const PhysicalTensor& physical)
+        { return physical.value.narrow(physical.physicalDim(dim), start, length); });
+}
+
+// TensorAdvancedIndexing
+
+Tensor index_select_batch_rule(const Tensor& self, int64_t dim, const Tensor& index)
+{
+    const int64_t level        = callLevel(self, index);
+    const auto    self_        = toPhysical(self, level);
+    const auto    index_       = toPhysical(index, level);
+    const int64_t physical_dim = maybe_wrap_dim(dim, std::max<int64_t>(self_.logicalRank(), 1));
+
+    // index_select of a 0-d tensor works on one element
+    const bool scalar = self_.logicalRank() == 0;
+    if (!index_.bdim.has_value())
+    {
+        auto values = scalar ? self_.value.unsqueeze(1) : self_.value;
+        auto result = at::index_select(values, physical_dim + 1, index_.value);
+        return makeBatched(scalar ? result.squeeze(1) : result, 0, level);
+    }
+
+    // A batch of indices selects per instance: gather along the dim with the
+    // indices of each instance broadcast over the other dims of self
+    TORCH_CHECK(index_.logicalRank() <= 1, "index_select(): Index is supposed to be a vector");
+    const int64_t batch_size = batchSize(self_, index_);
+    auto          values     = withBatchDim(self_, batch_size);
+    if (scalar)
+    {
+        values = values.unsqueeze(1);
+    }
+    auto      indices = index_.value.reshape({batch_size, -1});
+    DimVector index_sizes(values.dim(), 1);
+    index_sizes[0]                = batch_size;
+    index_sizes[physical_dim + 1] = indices.size(1);
+    DimVector gather_sizes(values.sizes().begin(), values.sizes().end());
+    gather_sizes[physical_dim + 1] = indices.size(1);
+    auto result = at::gather(
+        values, physical_dim + 1, indices.view(index_sizes).expand(gather_sizes));
+    if (scalar)
+    {
+        result = result.squeeze(1);
+    }
+    return makeBatched(result, 0, level);
+}
+
+Tensor gather_batch_rule(const Tensor& self, int64_t dim, const Tensor& index, bool sparse_grad)
+{
+    const int64_t level        = callLevel(self, index);
+    const auto    self_        = toPhysical(self, level);
+    const auto    index_       = toPhysical(index, level);
+    const int64_t batch_size   = batchSize(self_, index_);
+    const int64_t physical_dim = maybe_wrap_dim(dim, std::max<int64_t>(self_.logicalRank(), 1));
+
+    auto values  = withBatchDim(self_, batch_size);
+    auto indices = withBatchDim(index_, batch_size);
+    // gather of 0-d tensors works on one element
+    const bool scalar = self_.logicalRank() == 0;
+    if (scalar)
+    {
+        values  = values.unsqueeze(1);
+        indices = indices.reshape({batch_size, 1});
+    }
+    auto result = at::gather(values, physical_dim + 1, indices, sparse_grad);
+    if (scalar && index_.logicalRank() == 0)
+    {
+        result = result.squeeze(1);
+    }
+    return makeBatched(result, 0, level);
+}
+
+}  // namespace
+
+TORCH_LIBRARY_IMPL(aten, FuncTorchBatched, m)
+{
+    // Elementwise
+    m.impl("abs", abs_batch_rule);
+    m.impl("neg", neg_batch_rule);
+    m.impl("exp", exp_batch_rule);
+    m.impl("log", log_batch_rule);
+    m.impl("sqrt", sqrt_batch_rule);
+    m.impl("reciprocal", reciprocal_batch_rule);
+    m.impl("sin", sin_batch_rule);
+    m.impl("cos", cos_batch_rule);
+    m.impl("tanh", tanh_batch_rule);
+    m.impl("erf", erf_batch_rule);
+    m.impl("add.Tensor", add_batch_rule);
+    m.impl("sub.Tensor", sub_batch_rule);
+    m.impl("mul.Tensor", mul_batch_rule);
+    m.impl("div.Tensor", div_batch_rule);
+    m.impl("maximum", maximum_batch_rule);
+    m.impl("minimum", minimum_batch_rule);
+    m.impl("addcmul", addcmul_batch_rule);
+    m.impl("addcdiv", addcdiv_batch_rule);
+    m.impl("lerp.Tensor", lerp_tensor_batch_rule);
+    m.impl("lerp.Scalar", lerp_scalar_batch_rule);
+
+    // TensorCompare
+    m.impl("eq.Tensor", eq_batch_rule);
+    m.impl("ne.Tensor", ne_batch_rule);
+    m.impl("lt.Tensor", lt_batch_rule);
+    m.impl("le.Tensor", le_batch_rule);
+    m.impl("gt.Tensor", gt_batch_rule);
+    m.impl("ge.Tensor", ge_batch_rule);
+    m.impl("where.self", where_batch_rule);
+    m.impl("clamp", clamp_batch_rule);
+
+    // Reductions
+    m.impl("sum", sum_batch_rule);
+    m.impl("sum.dim_IntList", sum_dim_batch_rule);
+    m.impl("amax", amax_batch_rule);
+    m.impl("amin", amin_batch_rule);
+
+    // TensorShape
+    m.impl("view", view_batch_rule);
+    m.impl("reshape", reshape_batch_rule);
+    m.impl("expand", expand_batch_rule);
+    m.impl("permute", permute_batch_rule);
+    m.impl("transpose.int", transpose_batch_rule);
+    m.impl("unsqueeze", unsqueeze_batch_rule);
+    m.impl("squeeze.dim", squeeze_dim_batch_rule);
+    m.impl("select.int", select_batch_rule);
+    m.impl("narrow", narrow_batch_rule);
+
+    // TensorAdvancedIndexing
+    m.impl("index_select", index_select_batch_rule);
+    m.impl("gather", gather_batch_rule);
+}
+
+}  // namespace at::functorch
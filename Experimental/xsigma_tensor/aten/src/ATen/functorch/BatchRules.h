@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Quarisma/Tensor.h>
+#include <Quarisma/functorch/BatchedTensorImpl.h>
+
+#include <cstdint>
+#include <optional>
+#include <tuple>
+
+namespace at::functorch
+{
+
+// Note [Batching rules without a vmap interpreter]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// This port has no DynamicLayer stack, so the batching rules registered for
+// the FuncTorchBatched key (BatchRules.cpp) take the level of a call from its
+// arguments: the highest level among the batched tensors. They unwrap the
+// tensors batched at that level, move their batch dim to the front, run the op
+// once over the whole batch and wrap the result at the same level with its
+// batch dim at the front. Tensors that are not batched at that level, including
+// those batched at a lower level, go to the op as they are, so nested levels
+// unwrap one call at a time.
+//
+// Pointwise rules pad the batched operands to the highest logical rank of the
+// call, so that the batch dim never broadcasts against a logical dim.
+//
+// To run a graph over N independent instances, stack their inputs, wrap them
+// with addBatchDim(input, 0, level) and take the outputs back with
+// removeBatchDim(output, level, N). Ops without a batching rule fail in the
+// dispatcher.
+
+// The value of tensor and its batch dim if it is batched at level, tensor and
+// nullopt otherwise
+TORCH_API std::tuple<Tensor, std::optional<int64_t>> unwrapTensorAtLevel(
+    const Tensor& tensor, int64_t level);
+
+// tensor with its batch dim, if any, moved to dim 0
+TORCH_API Tensor moveBatchDimToFront(const Tensor& tensor, std::optional<int64_t> bdim);
+
+TORCH_API int64_t rankWithoutBatchDim(const Tensor& tensor, std::optional<int64_t> bdim);
+
+// Inserts size-1 dims after the batch dim, at the front, of tensor so that it
+// has logical_rank logical dims. Unbatched tensors are left as they are.
+TORCH_API Tensor maybePadToLogicalRank(
+    const Tensor& tensor, std::optional<int64_t> bdim, int64_t logical_rank);
+
+// The plain tensor of the batch of tensor at level, with the batch dim at
+// out_dim. A tensor not batched at level is the same for the whole batch and
+// is expanded to batch_size along out_dim.
+TORCH_API Tensor removeBatchDim(
+    const Tensor& tensor, int64_t level, int64_t batch_size, int64_t out_dim = 0);
+
+}  // namespace at::functorch
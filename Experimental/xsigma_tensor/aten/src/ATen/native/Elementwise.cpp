@@ -0,0 +1,185 @@
+#define TORCH_ASSERT_ONLY_METHOD_OPERATORS
+#include <Quarisma/Dispatch.h>
+#include <Quarisma/TensorIterator.h>
+#include <Quarisma/WrapDimUtils.h>
+#include <Quarisma/core/Tensor.h>
+#include <Quarisma/native/Elementwise.h>
+#include <c10/util/irange.h>
+
+#ifndef AT_PER_OPERATOR_HEADERS
+#include <Quarisma/Functions.h>
+#else
+#include <Quarisma/ops/empty.h>
+#endif
+
+#include <limits>
+#include <vector>
+
+namespace at::native
+{
+
+DEFINE_DISPATCH(unary_elementwise_stub);
+DEFINE_DISPATCH(binary_elementwise_stub);
+DEFINE_DISPATCH(ternary_elementwise_stub);
+DEFINE_DISPATCH(reduce_elementwise_stub);
+
+namespace
+{
+bool is_floating_only(UnaryOpKind op)
+{
+    return op != UnaryOpKind::Abs && op != UnaryOpKind::Neg;
+}
+
+// The neutral element of op for the dtype of self
+c10::Scalar reduce_identity(ReduceOpKind op, const Tensor& self)
+{
+    c10::Scalar identity;
+    AT_DISPATCH_ALL_TYPES(
+        self.scalar_type(),
+        "elementwise_reduce",
+        [&]
+        {
+            using limits = std::numeric_limits<scalar_t>;
+            switch (op)
+            {
+            case ReduceOpKind::Sum:
+                identity = scalar_t(0);
+                break;
+            case ReduceOpKind::Prod:
+                identity = scalar_t(1);
+                break;
+            case ReduceOpKind::Max:
+                identity = limits::has_infinity ? -limits::infinity() : limits::lowest();
+                break;
+            case ReduceOpKind::Min:
+                identity = limits::has_infinity ? limits::infinity() : limits::max();
+                break;
+            }
+        });
+    return identity;
+}
+}  // namespace
+
+Tensor& elementwise_unary_out(UnaryOpKind op, const Tensor& self, Tensor& result)
+{
+    auto iter = is_floating_only(op) ? TensorIterator::unary_float_op(result, self)
+                                     : TensorIterator::unary_op(result, self);
+    unary_elementwise_stub(iter.device_type(), iter, op);
+    return result;
+}
+
+Tensor elementwise_unary(UnaryOpKind op, const Tensor& self)
+{
+    Tensor result;
+    auto   iter = is_floating_only(op) ? TensorIterator::unary_float_op(result, self)
+                                       : TensorIterator::unary_op(result, self);
+    unary_elementwise_stub(iter.device_type(), iter, op);
+    return iter.output();
+}
+
+Tensor& elementwise_binary_out(
+    BinaryOpKind       op,
+    const Tensor&      self,
+    const Tensor&      other,
+    const c10::Scalar& alpha,
+    Tensor&            result)
+{
+    auto iter = op == BinaryOpKind::Div ? TensorIterator::binary_float_op(result, self, other)
+                                        : TensorIterator::binary_op(result, self, other);
+    binary_elementwise_stub(iter.device_type(), iter, op, alpha);
+    return result;
+}
+
+Tensor elementwise_binary(
+    BinaryOpKind op, const Tensor& self, const Tensor& other, const c10::Scalar& alpha)
+{
+    Tensor result;
+    auto   iter = op == BinaryOpKind::Div ? TensorIterator::binary_float_op(result, self, other)
+                                          : TensorIterator::binary_op(result, self, other);
+    binary_elementwise_stub(iter.device_type(), iter, op, alpha);
+    return iter.output();
+}
+
+Tensor& elementwise_ternary_out(
+    TernaryOpKind      op,
+    const Tensor&      self,
+    const Tensor&      tensor1,
+    const Tensor&      tensor2,
+    const c10::Scalar& value,
+    Tensor&            result)
+{
+    auto iter = TensorIteratorConfig()
+                    .set_check_mem_overlap(true)
+                    .add_output(result)
+                    .add_const_input(self)
+                    .add_const_input(tensor1)
+                    .add_const_input(tensor2)
+                    .promote_inputs_to_common_dtype(true)
+                    .promote_integer_inputs_to_float(true)
+                    .cast_common_dtype_to_outputs(true)
+                    .enforce_safe_casting_to_output(true)
+                    .build();
+    ternary_elementwise_stub(iter.device_type(), iter, op, value);
+    return result;
+}
+
+Tensor elementwise_ternary(
+    TernaryOpKind      op,
+    const Tensor&      self,
+    const Tensor&      tensor1,
+    const Tensor&      tensor2,
+    const c10::Scalar& value)
+{
+    auto iter = TensorIteratorConfig()
+                    .add_output(Tensor())
+                    .add_const_input(self)
+                    .add_const_input(tensor1)
+                    .add_const_input(tensor2)
+                    .promote_inputs_to_common_dtype(true)
+                    .promote_integer_inputs_to_float(true)
+                    .build();
+    ternary_elementwise_stub(iter.device_type(), iter, op, value);
+    return iter.output();
+}
+
+Tensor elementwise_reduce(ReduceOpKind op, const Tensor& self, IntArrayRef dims, bool keepdim)
+{
+    TORCH_CHECK(
+        op == ReduceOpKind::Sum || op == ReduceOpKind::Prod || self.numel() > 0,
+        "elementwise_reduce: max and min of an empty tensor are not defined");
+
+    const int64_t     ndim = self.dim();
+    std::vector<bool> reduced(ndim, dims.empty());
+    for (const int64_t dim : dims)
+    {
+        reduced[maybe_wrap_dim(dim, ndim)] = true;
+    }
+    DimVector shape(self.sizes());
+    for (const auto d : c10::irange(ndim))
+    {
+        if (reduced[d])
+        {
+            shape[d] = 1;
+        }
+    }
+
+    // The kernel accumulates into the result
+    Tensor result = at::empty(shape, self.options());
+    result.fill_(reduce_identity(op, self));
+    auto iter = TensorIterator::reduce_op(result, self);
+    reduce_elementwise_stub(iter.device_type(), iter, op);
+
+    if (!keepdim)
+    {
+        for (int64_t d = ndim - 1; d >= 0; --d)
+        {
+            if (reduced[d])
+            {
+                result = result.squeeze(d);
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace at::native
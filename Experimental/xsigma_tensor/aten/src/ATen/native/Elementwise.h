@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Quarisma/native/DispatchStub.h>
+#include <c10/core/Scalar.h>
+#include <c10/util/ArrayRef.h>
+
+#include <cstdint>
+
+namespace at
+{
+class Tensor;
+struct TensorIteratorBase;
+}  // namespace at
+
+namespace at::native
+{
+
+// Elementwise and reduction kernels of the CPU port: one DispatchStub per
+// arity, with DEFAULT, AVX2 and AVX512 entries from native/cpu. The kernels
+// vectorize the contiguous inner loops and run on the Core thread pool, see
+// native/cpu/ElementwiseLoops.h.
+
+enum class UnaryOpKind : uint8_t
+{
+    Abs,
+    Neg,
+    // Floating point only
+    Exp,
+    Log,
+    Sqrt,
+    Reciprocal,
+    Sin,
+    Cos,
+    Tanh,
+    Erf,
+};
+
+enum class BinaryOpKind : uint8_t
+{
+    Add,  // self + alpha * other
+    Sub,  // self - alpha * other
+    Mul,
+    Maximum,
+    Minimum,
+    // Floating point only
+    Div,
+};
+
+// Floating point only
+enum class TernaryOpKind : uint8_t
+{
+    Addcmul,  // self + value * tensor1 * tensor2
+    Addcdiv,  // self + value * tensor1 / tensor2
+    Lerp,     // self + tensor2 * (tensor1 - self)
+};
+
+enum class ReduceOpKind : uint8_t
+{
+    Sum,
+    Prod,
+    Max,
+    Min,
+};
+
+using unary_elementwise_fn   = void (*)(TensorIteratorBase&, UnaryOpKind);
+using binary_elementwise_fn  = void (*)(TensorIteratorBase&, BinaryOpKind, const c10::Scalar&);
+using ternary_elementwise_fn = void (*)(TensorIteratorBase&, TernaryOpKind, const c10::Scalar&);
+using reduce_elementwise_fn  = void (*)(TensorIteratorBase&, ReduceOpKind);
+
+DECLARE_DISPATCH(unary_elementwise_fn, unary_elementwise_stub)
+DECLARE_DISPATCH(binary_elementwise_fn, binary_elementwise_stub)
+DECLARE_DISPATCH(ternary_elementwise_fn, ternary_elementwise_stub)
+DECLARE_DISPATCH(reduce_elementwise_fn, reduce_elementwise_stub)
+
+TORCH_API Tensor& elementwise_unary_out(UnaryOpKind op, const Tensor& self, Tensor& result);
+TORCH_API Tensor  elementwise_unary(UnaryOpKind op, const Tensor& self);
+
+// alpha only applies to Add and Sub
+TORCH_API Tensor& elementwise_binary_out(
+    BinaryOpKind       op,
+    const Tensor&      self,
+    const Tensor&      other,
+    const c10::Scalar& alpha,
+    Tensor&            result);
+TORCH_API Tensor elementwise_binary(
+    BinaryOpKind op, const Tensor& self, const Tensor& other, const c10::Scalar& alpha = 1);
+
+// value only applies to Addcmul and Addcdiv
+TORCH_API Tensor& elementwise_ternary_out(
+    TernaryOpKind      op,
+    const Tensor&      self,
+    const Tensor&      tensor1,
+    const Tensor&      tensor2,
+    const c10::Scalar& value,
+    Tensor&            result);
+TORCH_API Tensor elementwise_ternary(
+    TernaryOpKind      op,
+    const Tensor&      self,
+    const Tensor&      tensor1,
+    const Tensor&      tensor2,
+    const c10::Scalar& value = 1);
+
+// Reduces self over dims, all of them when dims is empty
+TORCH_API Tensor elementwise_reduce(
+    ReduceOpKind op, const Tensor& self, IntArrayRef dims = {}, bool keepdim = false);
+
+}  // namespace at::native
@@ -0,0 +1,198 @@
+#define TORCH_ASSERT_ONLY_METHOD_OPERATORS
+#include <Quarisma/core/Tensor.h>
+#include <Quarisma/native/PackedLinear.h>
+#include <c10/util/irange.h>
+
+#ifndef AT_PER_OPERATOR_HEADERS
+#include <Quarisma/Functions.h>
+#else
+#include <Quarisma/ops/empty.h>
+#include <Quarisma/ops/from_blob.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "memory/backend/allocator_huge_page.h"
+
+namespace at::native
+{
+
+DEFINE_DISPATCH(packed_linear_stub);
+
+namespace
+{
+// Alignment of packed buffers: a cache line, and an AVX512 register
+constexpr size_t kPackedAlignment = 64;
+
+quarisma::huge_page_cpu_allocator& huge_page_allocator()
+{
+    static quarisma::huge_page_cpu_allocator allocator(
+        /*numa_node=*/-1, {}, {}, quarisma::huge_page_cpu_allocator::Options{});
+    return allocator;
+}
+
+// An uninitialized float buffer of numel elements, on huge pages from one
+// page on
+Tensor empty_packed(int64_t numel)
+{
+    const size_t bytes = static_cast<size_t>(numel) * sizeof(float);
+    if (bytes < huge_page_allocator().page_size())
+    {
+        return at::empty({numel}, at::TensorOptions().dtype(kFloat));
+    }
+    size_t received = 0;
+    void*  data     = huge_page_allocator().Alloc(kPackedAlignment, bytes, &received);
+    TORCH_CHECK(data != nullptr, "pack_linear_weight: cannot allocate ", bytes, " bytes");
+    return at::from_blob(
+        data,
+        {numel},
+        [received](void* ptr) { huge_page_allocator().Free(ptr, received); },
+        at::TensorOptions().dtype(kFloat));
+}
+
+int64_t padded_channels(int64_t n)
+{
+    return (n + kPackedLinearPanel - 1) / kPackedLinearPanel * kPackedLinearPanel;
+}
+
+// Applies f(packed offset, row of W, column of W) to every element of the
+// packed form of an n x k weight, with row >= n in the padding
+template <typename F>
+void for_each_packed(int64_t n, int64_t k, const F& f)
+{
+    const int64_t padded = padded_channels(n);
+    for (int64_t k0 = 0; k0 < k; k0 += kPackedLinearBlockK)
+    {
+        const int64_t block_len = std::min(kPackedLinearBlockK, k - k0);
+        int64_t       offset    = k0 * padded;
+        for (int64_t p0 = 0; p0 < padded; p0 += kPackedLinearPanel)
+        {
+            for (const auto l : c10::irange(block_len))
+            {
+                for (const auto j : c10::irange(kPackedLinearPanel))
+                {
+                    f(offset++, p0 + j, k0 + l);
+                }
+            }
+        }
+    }
+}
+
+void check_weight(const Tensor& weight)
+{
+    TORCH_CHECK(
+        weight.scalar_type() == kFloat && weight.dim() == 2 && weight.is_cpu(),
+        "pack_linear_weight: expected a 2-d float CPU weight, got a ",
+        weight.dim(),
+        "-d ",
+        weight.scalar_type(),
+        " tensor");
+}
+}  // namespace
+
+int64_t packed_linear_weight_numel(int64_t n, int64_t k)
+{
+    return padded_channels(n) * k;
+}
+
+Tensor pack_linear_weight(const Tensor& weight)
+{
+    check_weight(weight);
+    const int64_t n      = weight.size(0);
+    const int64_t k      = weight.size(1);
+    const Tensor  w      = weight.contiguous();
+    const float*  w_data = w.const_data_ptr<float>();
+    Tensor        packed = empty_packed(packed_linear_weight_numel(n, k));
+    float*        data   = packed.mutable_data_ptr<float>();
+    for_each_packed(
+        n,
+        k,
+        [&](int64_t offset, int64_t row, int64_t col)
+        { data[offset] = row < n ? w_data[row * k + col] : 0.0f; });
+    return packed;
+}
+
+bool packed_linear_weight_equals(const Tensor& packed, const Tensor& weight)
+{
+    check_weight(weight);
+    const int64_t n = weight.size(0);
+    const int64_t k = weight.size(1);
+    if (packed.scalar_type() != kFloat || packed.dim() != 1 ||
+        packed.numel() != packed_linear_weight_numel(n, k))
+    {
+        return false;
+    }
+    const Tensor w      = weight.contiguous();
+    const Tensor p      = packed.contiguous();
+    const float* w_data = w.const_data_ptr<float>();
+    const float* p_data = p.const_data_ptr<float>();
+    bool         equal  = true;
+    for_each_packed(
+        n,
+        k,
+        [&](int64_t offset, int64_t row, int64_t col)
+        {
+            // Bitwise, so that NaNs and signed zeros match too
+            const float expected = row < n ? w_data[row * k + col] : 0.0f;
+            equal = equal && std::memcmp(&p_data[offset], &expected, sizeof(float)) == 0;
+        });
+    return equal;
+}
+
+Tensor packed_linear(
+    const Tensor&                input,
+    const Tensor&                packed_weight,
+    const std::optional<Tensor>& bias,
+    int64_t                      out_features)
+{
+    TORCH_CHECK(
+        input.scalar_type() == kFloat && input.dim() >= 1 && input.is_cpu(),
+        "packed_linear: expected a float CPU input of at least one dimension");
+    const int64_t k = input.size(-1);
+    TORCH_CHECK(
+        packed_weight.scalar_type() == kFloat && packed_weight.is_contiguous() &&
+            packed_weight.numel() == packed_linear_weight_numel(out_features, k),
+        "packed_linear: the packed weight does not hold ",
+        out_features,
+        " x ",
+        k,
+        " floats");
+    const bool has_bias = bias.has_value() && bias->defined();
+    TORCH_CHECK(
+        !has_bias || (bias->scalar_type() == kFloat && bias->numel() == out_features),
+        "packed_linear: expected a float bias of ",
+        out_features,
+        " elements");
+
+    const Tensor a = input.contiguous();
+    const Tensor b = has_bias ? bias->contiguous() : Tensor();
+    int64_t      m = 1;
+    for (const auto d : c10::irange(a.dim() - 1))
+    {
+        m *= a.size(d);
+    }
+
+    std::vector<int64_t> shape(input.sizes().begin(), input.sizes().end());
+    shape.back() = out_features;
+    Tensor out   = at::empty(shape, input.options());
+    if (m > 0 && out_features > 0)
+    {
+        packed_linear_stub(
+            kCPU,
+            m,
+            out_features,
+            k,
+            a.const_data_ptr<float>(),
+            k,
+            packed_weight.const_data_ptr<float>(),
+            has_bias ? b.const_data_ptr<float>() : nullptr,
+            out.mutable_data_ptr<float>(),
+            out_features);
+    }
+    return out;
+}
+
+}  // namespace at::native
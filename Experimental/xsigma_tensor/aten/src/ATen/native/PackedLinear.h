@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Quarisma/native/DispatchStub.h>
+
+#include <cstdint>
+#include <optional>
+
+namespace at
+{
+class Tensor;
+}  // namespace at
+
+namespace at::native
+{
+
+// Float linear layers on weights packed once, typically when a module is
+// frozen, so that the GEMM reads them in the order it uses them instead of
+// gathering strided columns of W on every call.
+//
+// The n x k weight W is split into panels of kPackedLinearPanel output
+// channels, zero-padded to a whole panel, and the inputs into blocks of
+// kPackedLinearBlockK. Within an input block, each panel is stored k-major:
+//
+//   packed[kb * KB * N + p * kb_len * P + l * P + j] = W[p * P + j][kb * KB + l]
+//
+// with P = kPackedLinearPanel, KB = kPackedLinearBlockK, N the padded number
+// of output channels and kb_len the length of block kb. A panel of one block,
+// kb_len x P floats, stays in L1 while the rows of the input stream over it,
+// and each of its rows is one or a few SIMD registers.
+inline constexpr int64_t kPackedLinearPanel  = 16;
+inline constexpr int64_t kPackedLinearBlockK = 256;
+
+// out (m x n, row stride ldo) = A W^T + bias; A is m x k with row stride lda,
+// packed holds W as above and bias, of n elements, may be null
+using packed_linear_fn = void (*)(
+    int64_t      m,
+    int64_t      n,
+    int64_t      k,
+    const float* a,
+    int64_t      lda,
+    const float* packed,
+    const float* bias,
+    float*       out,
+    int64_t      ldo);
+
+DECLARE_DISPATCH(packed_linear_fn, packed_linear_stub)
+
+// Number of floats of the packed form of an n x k weight
+TORCH_API int64_t packed_linear_weight_numel(int64_t n, int64_t k);
+
+// The packed form of the float (n, k) weight. Buffers of at least one huge
+// page are backed by transparent huge pages, so that the TLB covers them
+// while the GEMM sweeps over them on every call.
+TORCH_API Tensor pack_linear_weight(const Tensor& weight);
+
+// Whether packed is the packed form of weight, compared element by element
+TORCH_API bool packed_linear_weight_equals(const Tensor& packed, const Tensor& weight);
+
+// Linear layer on a weight packed by pack_linear_weight: input is a float
+// tensor of shape (*, in_features), bias an optional float (out_features)
+// tensor. Returns the (*, out_features) output.
+TORCH_API Tensor packed_linear(
+    const Tensor&                input,
+    const Tensor&                packed_weight,
+    const std::optional<Tensor>& bias,
+    int64_t                      out_features);
+
+}  // namespace at::native
@@ -0,0 +1,106 @@
+#define TORCH_ASSERT_ONLY_METHOD_OPERATORS
+#include <Quarisma/SparseCsrTensorUtils.h>
+#include <Quarisma/core/Tensor.h>
+#include <Quarisma/native/SparseCsrBlas.h>
+#include <Quarisma/native/TensorConversions.h>
+
+#ifndef AT_PER_OPERATOR_HEADERS
+#include <Quarisma/Functions.h>
+#else
+#include <Quarisma/ops/empty.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math/sparse_csr.h"
+
+namespace at::native
+{
+
+namespace
+{
+// The operands of a product with the CSR matrix self, in the types of the
+// Core kernels
+struct CsrOperands
+{
+    Tensor                     row_offsets;
+    Tensor                     columns;
+    Tensor                     values;
+    quarisma::linalg::csr_view view;
+};
+
+CsrOperands csr_operands(const Tensor& self, const Tensor& other, const char* name)
+{
+    TORCH_CHECK(
+        self.layout() == kSparseCsr && self.dim() == 2,
+        name,
+        ": expected a 2-d sparse CSR tensor, got layout ",
+        self.layout(),
+        " of ",
+        self.dim(),
+        " dims");
+    TORCH_CHECK(self.is_cpu() && other.is_cpu(), name, ": only CPU tensors are supported");
+    TORCH_CHECK(
+        at::isFloatingType(self.scalar_type()) && self.scalar_type() == other.scalar_type(),
+        name,
+        ": expected floating point operands of one dtype, got ",
+        self.scalar_type(),
+        " and ",
+        other.scalar_type());
+    TORCH_CHECK(
+        self.size(1) == other.size(0),
+        name,
+        ": sizes ",
+        self.sizes(),
+        " and ",
+        other.sizes(),
+        " do not match");
+
+    auto*       impl = get_sparse_csr_impl(self);
+    CsrOperands operands;
+    operands.row_offsets = to_contiguous(impl->compressed_indices(), kLong);
+    operands.columns     = to_contiguous(impl->plain_indices(), kLong);
+    operands.values      = to_contiguous(impl->values(), kDouble);
+    operands.view        = {
+        static_cast<size_t>(self.size(0)),
+        static_cast<size_t>(self.size(1)),
+        operands.row_offsets.const_data_ptr<int64_t>(),
+        operands.columns.const_data_ptr<int64_t>(),
+        operands.values.const_data_ptr<double>()};
+    return operands;
+}
+}  // namespace
+
+Tensor sparse_csr_mv(const Tensor& self, const Tensor& vec)
+{
+    TORCH_CHECK(vec.dim() == 1, "sparse_csr_mv: expected a 1-d vector, got ", vec.dim(), " dims");
+    const CsrOperands a = csr_operands(self, vec, "sparse_csr_mv");
+
+    const Tensor x      = to_contiguous(vec, kDouble);
+    Tensor       result = at::empty({self.size(0)}, vec.options().dtype(kDouble));
+    quarisma::linalg::csr_spmv(
+        a.view, x.const_data_ptr<double>(), result.mutable_data_ptr<double>());
+    return result.to(vec.scalar_type());
+}
+
+Tensor sparse_csr_mm(const Tensor& self, const Tensor& dense)
+{
+    TORCH_CHECK(
+        dense.dim() == 2, "sparse_csr_mm: expected a 2-d dense matrix, got ", dense.dim(), " dims");
+    const CsrOperands a = csr_operands(self, dense, "sparse_csr_mm");
+
+    const Tensor  b      = to_contiguous(dense, kDouble);
+    const int64_t p      = b.size(1);
+    Tensor        result = at::empty({self.size(0), p}, dense.options().dtype(kDouble));
+    quarisma::linalg::csr_spmm(
+        a.view,
+        b.const_data_ptr<double>(),
+        static_cast<size_t>(p),
+        static_cast<size_t>(p),
+        result.mutable_data_ptr<double>(),
+        static_cast<size_t>(p));
+    return result.to(dense.scalar_type());
+}
+
+}  // namespace at::native
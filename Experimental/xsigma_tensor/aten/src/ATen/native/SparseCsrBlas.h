@@ -0,0 +1,24 @@
+#pragma once
+
+#include <c10/macros/Macros.h>
+
+namespace at
+{
+class Tensor;
+}  // namespace at
+
+namespace at::native
+{
+
+// Products of 2-d CPU sparse CSR tensors with strided tensors, on the
+// nonzero-balanced, row-parallel kernels of Core (math/sparse_csr.h) rather
+// than through a dense copy of the sparse operand. The products run in
+// double; other floating point dtypes are converted and the result cast back.
+
+// self (m, n) CSR times vec (n); returns the strided (m) result
+TORCH_API Tensor sparse_csr_mv(const Tensor& self, const Tensor& vec);
+
+// self (m, n) CSR times dense (n, p); returns the strided (m, p) result
+TORCH_API Tensor sparse_csr_mm(const Tensor& self, const Tensor& dense);
+
+}  // namespace at::native
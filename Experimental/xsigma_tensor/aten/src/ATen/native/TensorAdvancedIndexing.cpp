@@ -139,6 +139,8 @@
 #include <c10/util/irange.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <numeric>
 #include <utility>
 #include <vector>
@@ -1647,6 +1649,89 @@ static Tensor& index_select_out_cpu_dim1_(
     return result_contig;
 }
 
+// Note [index_select of contiguous tensors]
+// With self and result contiguous, self is (outer, size(dim), inner) and
+// result (outer, numel, inner): every block of inner elements of result is
+// one copy of the block of self that the index names. The blocks are copied
+// in parallel, in chunks of about GRAIN_SIZE elements, and the block
+// kIndexSelectPrefetch indices ahead is prefetched, hiding the latency of the
+// scattered reads when the blocks are small.
+static constexpr int64_t kIndexSelectPrefetch = 8;
+
+template <typename word_t>
+static void copy_word(char* dst, const char* src)
+{
+    word_t word;
+    std::memcpy(&word, src, sizeof(word_t));
+    std::memcpy(dst, &word, sizeof(word_t));
+}
+
+static Tensor& index_select_out_cpu_contiguous_(
+    Tensor& result, const Tensor& self, int64_t dim, const Tensor& index_contig)
+{
+    const int64_t item_bytesize = static_cast<int64_t>(self.element_size());
+    const int64_t outer         = c10::size_to_dim_(dim, self.sizes());
+    const int64_t inner         = c10::size_from_dim_(dim + 1, self.sizes());
+    const int64_t dim_size      = self.size(dim);
+    const int64_t block_bytes   = inner * item_bytesize;
+    const int64_t N             = index_contig.numel();
+
+    const auto* src = static_cast<const char*>(self.const_data_ptr());
+    auto*       out = static_cast<char*>(result.data_ptr());
+
+    AT_DISPATCH_INDEX_TYPES(
+        index_contig.scalar_type(),
+        "index_select_out_cpu_contiguous_",
+        [&]()
+        {
+            const auto* idxs = index_contig.const_data_ptr<index_t>();
+            check_indexarray_range<index_t>(idxs, N, dim_size);
+
+            auto copy_blocks = [&](auto copy_block)
+            {
+                at::parallel_for(
+                    0,
+                    outer * N,
+                    std::max<int64_t>(at::internal::GRAIN_SIZE / std::max<int64_t>(inner, 1), 1),
+                    [&](int64_t begin, int64_t end)
+                    {
+                        for (const auto k : c10::irange(begin, end))
+                        {
+                            const int64_t batch     = k / N;
+                            const int64_t i         = k % N;
+                            const char*   batch_src = src + batch * dim_size * block_bytes;
+#if defined(__GNUC__) || defined(__clang__)
+                            if (i + kIndexSelectPrefetch < N)
+                            {
+                                __builtin_prefetch(
+                                    batch_src + idxs[i + kIndexSelectPrefetch] * block_bytes,
+                                    0,
+                                    1);
+                            }
+#endif
+                            copy_block(out + k * block_bytes, batch_src + idxs[i] * block_bytes);
+                        }
+                    });
+            };
+
+            // Fixed size copies of the single element blocks of 1-D lookups
+            if (block_bytes == 4)
+            {
+                copy_blocks(copy_word<uint32_t>);
+            }
+            else if (block_bytes == 8)
+            {
+                copy_blocks(copy_word<uint64_t>);
+            }
+            else
+            {
+                copy_blocks([block_bytes](char* dst, const char* from)
+                            { std::memcpy(dst, from, block_bytes); });
+            }
+        });
+    return result;
+}
+
 Tensor& index_select_out_cpu_(const Tensor& self, int64_t dim, const Tensor& index, Tensor& result)
 {
     if (self.is_quantized())
@@ -1704,6 +1789,12 @@ Tensor& index_select_out_cpu_(const Tensor& self, int64_t dim, const Tensor& ind
             return result;
         }
 
+        // See Note [index_select of contiguous tensors]
+        if (self.is_contiguous() && result.is_contiguous() && !self.is_quantized())
+        {
+            return index_select_out_cpu_contiguous_(result, self, dim, index_contig);
+        }
+
         if (dim == 1 && result.is_contiguous())
         {
             // fast pass
@@ -456,6 +456,18 @@ static inline Tensor to_impl(
         self, dtype, layout, device, pin_memory, non_blocking, optional_memory_format);
 }
 
+Tensor to_contiguous(const Tensor& self, ScalarType dtype, c10::MemoryFormat memory_format)
+{
+    if (self.scalar_type() == dtype)
+    {
+        return self.contiguous(memory_format);
+    }
+    // to(dtype) alone would preserve the strides of self and contiguous()
+    // would then copy a second time
+    return at::_to_copy(
+        self, dtype, std::nullopt, std::nullopt, std::nullopt, false, memory_format);
+}
+
 // If input tensor is fp32, cast it to fp16, otherwise leave it alone.
 // (this is intended to be used internally by the JIT autocast implementation)
 Tensor _autocast_to_reduced_precision(
@@ -20,6 +20,13 @@ bool to_will_alias(
     bool                             copy,
     std::optional<c10::MemoryFormat> optional_memory_format);
 
+// self.to(dtype).contiguous(memory_format) with at most one copy: the
+// conversion writes straight into a tensor of the requested layout
+Tensor to_contiguous(
+    const Tensor&     self,
+    ScalarType        dtype,
+    c10::MemoryFormat memory_format = c10::MemoryFormat::Contiguous);
+
 Tensor                to_meta(const Tensor& tensor);
 std::optional<Tensor> to_meta(const std::optional<Tensor>& tensor);
 std::vector<Tensor>   to_meta(at::ITensorListRef t_list);
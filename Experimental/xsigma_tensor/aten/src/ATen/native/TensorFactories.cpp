@@ -95,6 +95,7 @@
 #include <Quarisma/ops/zeros_native.h>
 #endif
 
+#include <c10/core/CPUAllocator.h>
 #include <c10/core/SymIntArrayRef.h>
 
 #include <algorithm>
@@ -102,6 +103,8 @@
 #include <string>
 #include <utility>
 
+#include "parallel/parallel_tools.h"
+
 namespace at::native
 {
 namespace
@@ -698,6 +701,146 @@ Tensor& eye_out_cpu(int64_t n, int64_t m, Tensor& result)
     return result;
 }
 
+// Note [First-touch fills]
+// ~~~~~~~~~~~~~~~~~~~~~~~~
+// A page of a CPU tensor is placed on the NUMA node of the thread that first
+// writes it. The large tensors made by full and zeros are therefore filled on
+// the Core parallel_tools pool, in blocks of GRAIN_SIZE elements like the
+// elementwise kernels, rather than by the calling thread alone, which would
+// place every page on its own node. With PARALLEL_AFFINITY=numa each node's
+// threads fill one contiguous segment, the same one they take in later loops
+// over the tensor.
+//
+// A large zeros is not filled at all: its storage is served from fresh
+// anonymous pages (MapZeroedCPUAllocation), which the kernel zeroes when they
+// are first touched, by whichever thread touches them. This also spares the
+// memset of pages that are never read.
+
+namespace
+{
+
+// Below these sizes the serial fill is as fast, and a memset is cheaper than
+// mapping pages
+constexpr size_t kFirstTouchFillBytes = size_t{1} << 20;
+constexpr size_t kZeroedPagesBytes    = size_t{1} << 21;
+
+// The dtypes dispatched by first_touch_fill_
+bool has_fill_dtype(ScalarType dtype)
+{
+    switch (dtype)
+    {
+    case kByte:
+    case kChar:
+    case kShort:
+    case kInt:
+    case kLong:
+    case kHalf:
+    case kFloat:
+    case kDouble:
+    case kComplexFloat:
+    case kComplexDouble:
+    case kBool:
+    case kBFloat16:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Fills self, a tensor just allocated, as in Note [First-touch fills].
+// Returns false, leaving self untouched, unless it is a large contiguous
+// tensor in CPU memory of one of the dispatched dtypes.
+bool first_touch_fill_(const Tensor& self, const Scalar& value)
+{
+    if (!self.is_cpu() || self.layout() != kStrided || !has_fill_dtype(self.scalar_type()) ||
+        self.unsafeGetTensorImpl()->is_python_dispatch() || !self.is_contiguous() ||
+        self.nbytes() < kFirstTouchFillBytes || parallel_tools::is_parallel_scope())
+    {
+        return false;
+    }
+    AT_DISPATCH_V2(
+        self.scalar_type(),
+        "first_touch_fill_",
+        [&]() -> void
+        {
+            const auto fill = value.to<scalar_t>();
+            scalar_t*  data = self.mutable_data_ptr<scalar_t>();
+            parallel_tools::parallel_for(
+                0,
+                static_cast<size_t>(self.numel()),
+                static_cast<size_t>(internal::GRAIN_SIZE),
+                [data, fill](size_t begin, size_t end)
+                { std::fill(data + begin, data + end, fill); });
+        },
+        kBFloat16,
+        kHalf,
+        kBool,
+        AT_EXPAND(AT_ALL_TYPES_AND_COMPLEX));
+    return true;
+}
+
+Tensor& fill_new_(Tensor& self, const Scalar& value)
+{
+    return first_touch_fill_(self, value) ? self : self.fill_(value);
+}
+
+Tensor& zero_new_(Tensor& self)
+{
+    return first_touch_fill_(self, 0) ? self : self.zero_();
+}
+
+// A zeros of size served from zeroed pages, as in Note [First-touch fills].
+// Returns an undefined tensor unless the tensor is large, dense and in CPU
+// memory, and the default CPU allocator took the pages.
+Tensor zeros_from_zeroed_pages(c10::SymIntArrayRef size, const TensorOptions& options)
+{
+    const auto concrete = c10::asIntArrayRefSlowOpt(size);
+    if (!concrete.has_value() || options.device().type() != kCPU || options.layout() != kStrided ||
+        options.pinned_memory() || isQIntType(typeMetaToScalarType(options.dtype())))
+    {
+        return Tensor();
+    }
+    const size_t nbytes = at::detail::computeStorageNbytesContiguous(
+        *concrete, options.dtype().itemsize());
+    // Leave a pending block of a memory plan to the allocation it was planned for
+    c10::PlannedCPUAllocation* outer = c10::GetPlannedCPUAllocation();
+    if (nbytes < kZeroedPagesBytes || (outer != nullptr && outer->data != nullptr))
+    {
+        return Tensor();
+    }
+
+    c10::PlannedCPUAllocation pages;
+    if (!c10::MapZeroedCPUAllocation(nbytes, &pages))
+    {
+        return Tensor();
+    }
+    Tensor result;
+    c10::SetPlannedCPUAllocation(&pages);
+    try
+    {
+        result = at::empty(*concrete, options);
+    }
+    catch (...)
+    {
+        c10::SetPlannedCPUAllocation(outer);
+        if (pages.data != nullptr)
+        {
+            pages.deleter(pages.context);
+        }
+        throw;
+    }
+    c10::SetPlannedCPUAllocation(outer);
+    if (pages.data != nullptr)
+    {
+        // Served by another allocator, e.g. the mobile one
+        pages.deleter(pages.context);
+        return Tensor();
+    }
+    return result;
+}
+
+}  // namespace
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ full ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 namespace
@@ -749,7 +892,7 @@ Tensor full(
     TORCH_CHECK(options.layout() != kSparse, "full(...) is not implemented for sparse layout");
 
     auto result = at::empty(size, infer_full_options(fill_value, options));
-    return result.fill_(fill_value);
+    return fill_new_(result, fill_value);
 }
 
 Tensor& full_out(IntArrayRef size, const Scalar& fill_value, Tensor& result)
@@ -774,7 +917,7 @@ Tensor full_like(
         TensorOptions().dtype(dtype).layout(layout).device(device).pinned_memory(pin_memory);
 
     auto result = at::empty_like(self, options, optional_memory_format);
-    return result.fill_(fill_value);
+    return fill_new_(result, fill_value);
 }
 
 Tensor new_full(
@@ -1672,8 +1815,13 @@ Tensor zeros_symint(
     // See [Note: hacky wrapper removal for TensorOptions]
     TensorOptions options =
         TensorOptions().dtype(dtype).layout(layout).device(device).pinned_memory(pin_memory);
+    Tensor zeroed = zeros_from_zeroed_pages(size, options);
+    if (zeroed.defined())
+    {
+        return zeroed;
+    }
     auto result = at::empty_symint(size, options);
-    return result.zero_();
+    return zero_new_(result);
 }
 
 Tensor _efficientzerotensor(
@@ -1794,7 +1942,7 @@ Tensor zeros_like(
         return res;
     }
     auto result = at::empty_like(self, options, optional_memory_format);
-    return result.zero_();
+    return zero_new_(result);
 }
 
 Tensor new_zeros(
@@ -11,13 +11,35 @@
 
 #include <c10/util/irange.h>
 
+#include "parallel/parallel_tools.h"
+
 /// Contains the implementation of parallel reductions in TensorIterator.
 
+// Note [Parallel reductions]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A reduction whose output is too small to keep every thread busy splits the
+// reduced dimensions instead: the flat iteration space is cut into blocks, each
+// block folds into its own copy of the output, and the copies are then combined
+// pairwise at distance 1, 2, 4, ... (cascade summation), which keeps the error
+// of a floating point sum growing with the log of the number of blocks rather
+// than linearly. Within a block the loop runs as usual, with the vector
+// accumulators of the kernel. Larger outputs are split along the output
+// elements, each of which is then reduced by one thread in the serial order.
+//
+// Both run on the Core parallel_tools pool. In its deterministic mode the
+// block boundaries come from parallel_tools_block_count, which does not depend
+// on the thread count, and so do the choice between the two strategies and
+// the serial fallback, so results are bit-identical on any number of threads.
+
 namespace at
 {
 
 using loop2d_t = TensorIteratorBase::loop2d_t;
 
+// Output elements below which the reduced dimensions are split in
+// deterministic mode, where the thread count may not be used
+constexpr int64_t kDeterministicTwoPassOutputs = 16;
+
 static bool use_two_pass_reduction(TensorIteratorBase& iter);
 static void two_pass_reduction(TensorIteratorBase& iter, loop2d_t loop);
 static void parallel_dim_reduction(TensorIteratorBase& iter, loop2d_t loop);
@@ -26,7 +48,10 @@ void TensorIteratorBase::parallel_reduce(loop2d_t loop)
 {
     TORCH_CHECK(ntensors() == 2, "parallel_reduce only supports one input and one output");
     int64_t numel = this->numel();
-    if (numel < at::internal::GRAIN_SIZE || at::get_num_threads() == 1 || at::in_parallel_region())
+    if (numel < at::internal::GRAIN_SIZE ||
+        (!parallel_tools::deterministic() &&
+         (parallel_tools::estimated_number_of_threads() == 1 ||
+          parallel_tools::is_parallel_scope())))
     {
         serial_for_each(loop, {0, numel});
     }
@@ -42,17 +67,28 @@ void TensorIteratorBase::parallel_reduce(loop2d_t loop)
 
 static bool use_two_pass_reduction(TensorIteratorBase& iter)
 {
-    return iter.output(0).numel() == 1;
+    const int64_t outputs = iter.output(0).numel();
+    if (outputs == 1)
+    {
+        return true;
+    }
+    const int64_t max_outputs = parallel_tools::deterministic()
+                                    ? kDeterministicTwoPassOutputs
+                                    : parallel_tools::estimated_number_of_threads();
+    return outputs < max_outputs && iter.numel() / outputs >= at::internal::GRAIN_SIZE;
 }
 
 static void two_pass_reduction(TensorIteratorBase& iter, loop2d_t loop)
 {
-    const int max_threads = at::get_num_threads();
+    using namespace quarisma::detail::parallel;
+    const int64_t numel  = iter.numel();
+    const auto    blocks = static_cast<int64_t>(parallel_tools_block_count(
+        static_cast<size_t>(numel), static_cast<size_t>(internal::GRAIN_SIZE)));
 
     const auto& dst          = iter.output(0);
     auto        unsqueezed   = dst.unsqueeze(0);
     auto        buffer_shape = DimVector(unsqueezed.sizes());
-    buffer_shape[0]          = max_threads;
+    buffer_shape[0]          = blocks;
     auto buffer              = at::empty(buffer_shape, dst.options());
     // Fill with the identity
     buffer.copy_(unsqueezed);
@@ -62,25 +98,36 @@ static void two_pass_reduction(TensorIteratorBase& iter, loop2d_t loop)
     auto first_reduce  = TensorIterator::reduce_op(buffer_0, iter.input(0));
     TORCH_INTERNAL_ASSERT(first_reduce.output(0).is_alias_of(buffer_0));
 
-    at::parallel_for(
+    parallel_tools::parallel_for(
         0,
-        iter.numel(),
-        internal::GRAIN_SIZE,
-        [&](int64_t begin, int64_t end)
+        static_cast<size_t>(blocks),
+        parallel_tools_block_grain(static_cast<size_t>(blocks)),
+        [&](size_t first, size_t last)
         {
-            const auto thread_num = at::get_thread_num();
-            auto       shape      = first_reduce.shape();
-            auto       strides    = first_reduce.get_strides();
-
-            // Bump output ptr so each thread has its own output slice
-            auto base_ptrs = first_reduce.get_base_ptrs();
-            base_ptrs[0] += buffer_stride * thread_num;
+            auto shape   = first_reduce.shape();
+            auto strides = first_reduce.get_strides();
+            for (auto b = static_cast<int64_t>(first); b < static_cast<int64_t>(last); ++b)
+            {
+                // Bump output ptr so each block has its own output slice
+                auto base_ptrs = first_reduce.get_base_ptrs();
+                base_ptrs[0] += buffer_stride * b;
 
-            at::internal::serial_for_each(
-                shape, strides, base_ptrs.data(), base_ptrs.size(), loop, {begin, end});
+                const int64_t begin = numel * b / blocks;
+                const int64_t end   = numel * (b + 1) / blocks;
+                at::internal::serial_for_each(
+                    shape, strides, base_ptrs.data(), base_ptrs.size(), loop, {begin, end});
+            }
         });
 
-    auto final_reduce = TensorIterator::reduce_op(unsqueezed, buffer);
+    // Fold slice b + stride into slice b, for every b multiple of 2 * stride
+    for (int64_t stride = 1; stride < blocks; stride *= 2)
+    {
+        auto acc = buffer.slice(0, 0, blocks - stride, 2 * stride).unsqueeze(1);
+        auto rhs = buffer.slice(0, stride, blocks, 2 * stride).unsqueeze(1);
+        TensorIterator::reduce_op(acc, rhs).for_each(loop);
+    }
+
+    auto final_reduce = TensorIterator::reduce_op(unsqueezed, buffer.narrow(0, 0, 1));
     final_reduce.for_each(loop);
 }
 
@@ -88,7 +135,7 @@ static void two_pass_reduction(TensorIteratorBase& iter, loop2d_t loop)
 /// dimension that's larger than the number of available threads.
 static int find_split_dim(TensorIteratorBase& iter)
 {
-    int  num_threads = at::get_num_threads();
+    int  num_threads = parallel_tools::estimated_number_of_threads();
     auto shape       = iter.shape();
 
     // start with the outer-most dimension
@@ -128,18 +175,20 @@ static void parallel_dim_reduction(TensorIteratorBase& iter, loop2d_t loop)
     int64_t cols         = iter.shape()[dim];
     int     element_size = iter.element_size(/*arg=*/1);
 
-    bool should_round_columns = iter.strides(1)[dim] == element_size;
-    at::parallel_for(
+    bool    should_round_columns = iter.strides(1)[dim] == element_size;
+    int64_t cols_per_128_bytes   = 128 / element_size;
+    parallel_tools::parallel_for(
         0,
-        cols,
-        1,
-        [&](int64_t begin, int64_t end)
+        static_cast<size_t>(cols),
+        should_round_columns ? static_cast<size_t>(cols_per_128_bytes) : 1,
+        [&](size_t first, size_t last)
         {
+            auto begin = static_cast<int64_t>(first);
+            auto end   = static_cast<int64_t>(last);
             if (should_round_columns)
             {
                 // round columns to multiples of 128 bytes if adjacent columns are
                 // contiguous in memory.
-                int64_t cols_per_128_bytes = 128 / element_size;
                 std::tie(begin, end) = round_columns(iter, dim, cols_per_128_bytes, begin, end);
             }
             if (begin == end)
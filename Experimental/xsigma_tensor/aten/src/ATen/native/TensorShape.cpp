@@ -216,6 +216,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <utility>
 #include <vector>
 
@@ -341,9 +342,19 @@ TORCH_PRECOMPUTE_META_FUNC(cat)(const ITensorListRef& tensors, int64_t dim)
     if (is_out_defined && found_valid_tensor)
     {
         at::assert_no_internal_overlap(result);
+        int64_t offset = 0;
         for (const Tensor& t : materialized)
         {
-            at::assert_no_overlap(result, t);
+            if (native::cat_should_skip_tensor(t))
+            {
+                continue;
+            }
+            // See Note [cat into destination slots]
+            if (!native::cat_is_destination_slot(result, t, dim, offset))
+            {
+                at::assert_no_overlap(result, t);
+            }
+            offset += t.size(dim);
         }
     }
 
@@ -693,6 +704,98 @@ static void fastCatOutDim0(const Tensor& out, const MaterializedITensorListRef&
     TORCH_CHECK(outBytes == totalBytes);
 }
 
+// Note [cat of contiguous inputs]
+// With a contiguous result and contiguous inputs of its dtype, the result is
+// outer rows, outer the product of the sizes before dim, and row r is the
+// concatenation of row r of every input: a run of size(dim) * inner bytes of
+// each. Those runs are copied with memcpy on all threads, in blocks of about
+// GRAIN_SIZE elements. Inputs already in their slot of the result are left out.
+static constexpr int64_t kCatMinRunBytes = 64;
+
+static bool can_cat_contiguous_parallel(
+    const Tensor& result, const MaterializedITensorListRef& inputs, int64_t dim)
+{
+    if (!result.is_contiguous())
+    {
+        return false;
+    }
+    const int64_t inner = c10::multiply_integers(result.sizes().slice(dim + 1));
+    for (const Tensor& t : inputs)
+    {
+        if (cat_should_skip_tensor(t))
+        {
+            continue;
+        }
+        // Short runs are better left to the TensorIterator copies
+        if (t.size(dim) * inner * static_cast<int64_t>(t.element_size()) < kCatMinRunBytes)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void cat_contiguous_parallel(
+    const Tensor&                     result,
+    const MaterializedITensorListRef& inputs,
+    int64_t                           dim,
+    const std::vector<bool>&          in_place)
+{
+    struct Run
+    {
+        const char* src;
+        int64_t     bytes;   // Bytes of a row of the input
+        int64_t     offset;  // Byte offset of the run in a row of the result
+    };
+
+    const int64_t elem_size = static_cast<int64_t>(result.element_size());
+    const int64_t outer     = c10::multiply_integers(result.sizes().slice(0, dim));
+    const int64_t inner     = c10::multiply_integers(result.sizes().slice(dim + 1));
+    const int64_t row_bytes = result.size(dim) * inner * elem_size;
+
+    std::vector<Run> runs;
+    runs.reserve(inputs.size());
+    int64_t offset = 0;
+    for (const auto i : c10::irange(inputs.size()))
+    {
+        const Tensor& t = inputs[i];
+        if (cat_should_skip_tensor(t))
+        {
+            continue;
+        }
+        const int64_t bytes = t.size(dim) * inner * elem_size;
+        if (!in_place[i] && bytes > 0)
+        {
+            runs.push_back({static_cast<const char*>(t.const_data_ptr()), bytes, offset});
+        }
+        offset += bytes;
+    }
+    if (runs.empty() || outer == 0)
+    {
+        return;
+    }
+
+    char*         out        = static_cast<char*>(result.data_ptr());
+    const int64_t nruns      = static_cast<int64_t>(runs.size());
+    const int64_t run_bytes  = row_bytes / nruns + 1;
+    const int64_t grain_runs = std::max<int64_t>(
+        at::internal::GRAIN_SIZE * elem_size / run_bytes, 1);
+    at::parallel_for(
+        0,
+        outer * nruns,
+        grain_runs,
+        [&](int64_t begin, int64_t end)
+        {
+            for (const auto k : c10::irange(begin, end))
+            {
+                const int64_t row = k / nruns;
+                const Run&    run = runs[k % nruns];
+                std::memcpy(
+                    out + row * row_bytes + run.offset, run.src + row * run.bytes, run.bytes);
+            }
+        });
+}
+
 TORCH_IMPL_FUNC(cat_out_cpu)
 (const ITensorListRef& tensors,
  int64_t               dim,
@@ -710,6 +813,22 @@ TORCH_IMPL_FUNC(cat_out_cpu)
 
     auto materialized = tensors.materialize();
 
+    // Inputs already in their slot of result, see Note [cat into destination slots]
+    std::vector<bool> in_place(materialized.size(), false);
+    bool              any_in_place = false;
+    int64_t           slot_offset  = 0;
+    for (const auto i : c10::irange(materialized.size()))
+    {
+        const Tensor& t = materialized[i];
+        if (cat_should_skip_tensor(t))
+        {
+            continue;
+        }
+        in_place[i]  = cat_is_destination_slot(result, t, dim, slot_offset);
+        any_in_place = any_in_place || in_place[i];
+        slot_offset += t.size(dim);
+    }
+
     bool use_serial_kernel =
         result.numel() < at::internal::GRAIN_SIZE || at::get_num_threads() == 1;
     ScalarType dtype        = materialized[valid].get().scalar_type();
@@ -717,25 +836,31 @@ TORCH_IMPL_FUNC(cat_out_cpu)
     // fast path for single thread when both inputs and result are contiguous and
     // not empty, and concat dim is 0
     if (use_serial_kernel && all_contiguous && all_same_dtype &&
-        (MemoryFormat::Contiguous == memory_format))
+        (MemoryFormat::Contiguous == memory_format) && !any_in_place)
     {
         if (dim == 0)
         {
             fastCatOutDim0(result, materialized);
             return;
         }
-        // TODO: Add fast cat for higher dimensions and support multi-threaded fast
-        // cat
     }
 
     // fast path for single thread when both inputs and result are contiguous and
     // not empty
-    if (use_serial_kernel && all_contiguous && all_same_dtype && serial_dtype)
+    if (use_serial_kernel && all_contiguous && all_same_dtype && serial_dtype && !any_in_place)
     {
         cat_serial_stub(kCPU, result, materialized, dim);
         return;
     }
 
+    // See Note [cat of contiguous inputs]
+    if (all_contiguous && all_same_dtype && MemoryFormat::Contiguous == memory_format &&
+        can_cat_contiguous_parallel(result, materialized, dim))
+    {
+        cat_contiguous_parallel(result, materialized, dim, in_place);
+        return;
+    }
+
     int64_t offset = 0;
     if (all_same_sizes_and_stride && result.is_contiguous(memory_format) && all_same_dtype)
     {
@@ -753,12 +878,18 @@ TORCH_IMPL_FUNC(cat_out_cpu)
                         .enforce_safe_casting_to_output(true)
                         .build();
 
-        for (const Tensor& tensor : materialized)
+        for (const auto i : c10::irange(materialized.size()))
         {
+            const Tensor& tensor = materialized[i];
             if (cat_should_skip_tensor(tensor))
             {
                 continue;
             }
+            if (in_place[i])
+            {
+                offset += slice_dim_size;
+                continue;
+            }
             auto source_data = static_cast<const char*>(tensor.const_data_ptr());
             auto result_data = static_cast<char*>(result_slice_data) + offset * result_stride_bytes;
             iter.unsafe_replace_operand(0, result_data);
@@ -769,14 +900,20 @@ TORCH_IMPL_FUNC(cat_out_cpu)
     }
     else
     {
-        for (const Tensor& tensor : materialized)
+        for (const auto i : c10::irange(materialized.size()))
         {
+            const Tensor& tensor = materialized[i];
             if (cat_should_skip_tensor(tensor))
             {
                 continue;
             }
             auto slice_dim_size = tensor.sizes()[dim];
-            auto result_slice   = result.narrow(dim, offset, slice_dim_size);
+            if (in_place[i])
+            {
+                offset += slice_dim_size;
+                continue;
+            }
+            auto result_slice = result.narrow(dim, offset, slice_dim_size);
 
             auto iter = TensorIteratorConfig()
                             .set_check_mem_overlap(false)  // Already checked above
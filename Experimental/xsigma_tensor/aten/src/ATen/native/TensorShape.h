@@ -13,6 +13,40 @@ inline bool cat_should_skip_tensor(const Tensor& t)
     return t.sym_numel() == 0 && t.dim() == 1;
 }
 
+// Note [cat into destination slots]
+// A producer can write its part of a concatenation straight into the output:
+// allocate the output, take its slots with split_with_sizes() or chunk(),
+// which are views, compute into them, then cat_out() them into the output.
+// An input that is its own slot, of the output dtype, is already in place;
+// cat_out() accepts it despite the overlap and copies nothing for it.
+//
+// Whether t is the slot of result at offset along dim
+inline bool cat_is_destination_slot(
+    const Tensor& result, const Tensor& t, int64_t dim, int64_t offset)
+{
+    if (!result.defined() || !t.defined() || !result.has_storage() || !t.has_storage() ||
+        t.scalar_type() != result.scalar_type() || t.dim() != result.dim() ||
+        t.is_conj() != result.is_conj() || t.is_neg() != result.is_neg() ||
+        !t.is_alias_of(result))
+    {
+        return false;
+    }
+    if (offset + t.size(dim) > result.size(dim) ||
+        t.storage_offset() != result.storage_offset() + offset * result.stride(dim))
+    {
+        return false;
+    }
+    for (const auto d : c10::irange(t.dim()))
+    {
+        if ((d != dim && t.size(d) != result.size(d)) ||
+            (t.size(d) > 1 && t.stride(d) != result.stride(d)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 // Check to see if the shape of tensors is compatible
 // for being concatenated along a given dimension.
 inline void check_cat_shape_except_dim(
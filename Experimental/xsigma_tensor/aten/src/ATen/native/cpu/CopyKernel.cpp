@@ -8,9 +8,22 @@
 #include <Quarisma/native/TensorIterator.h>
 #include <Quarisma/native/UnaryOps.h>
 #include <Quarisma/native/cpu/CopyKernel.h>
+#include <Quarisma/native/cpu/DtypeConversion.h>
+#include <Quarisma/native/cpu/ElementwiseLoops.h>
 #include <Quarisma/native/cpu/Loops.h>
 #include <Quarisma/native/cpu/zmath.h>
 #include <c10/util/TypeCast.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "parallel/parallel_tools.h"
+
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+#include <immintrin.h>
+#endif
+
 namespace at::native
 {
 inline namespace CPU_CAPABILITY
@@ -27,6 +40,291 @@ bool reduced_output(ScalarType input_t, ScalarType output_t)
 {
     return !at::isFloat8Type(output_t) && at::isReducedFloatingType(output_t) && input_t == kFloat;
 }
+
+// Copies between double, float, BFloat16, Half, int32 and int64 with the rows
+// of native/cpu/DtypeConversion.h when the innermost dimension is contiguous.
+// Returns false, leaving iter untouched, for the other copies.
+bool dtype_conversion_copy(TensorIteratorBase& iter)
+{
+    const auto convert = dtype_conversion::conversion_kernel(iter.dtype(1), iter.dtype(0));
+    if (convert == nullptr || !iter.has_contiguous_first_dim())
+    {
+        return false;
+    }
+    TORCH_INTERNAL_ASSERT(iter.ninputs() == 1);
+    TORCH_INTERNAL_ASSERT(iter.noutputs() == 1);
+
+    auto loop = [convert](char** base, const int64_t* strides, int64_t size0, int64_t size1)
+    {
+        char*       dst = base[0];
+        const char* src = base[1];
+        for ([[maybe_unused]] const auto j : c10::irange(size1))
+        {
+            convert(src, dst, size0);
+            dst += strides[2];
+            src += strides[3];
+        }
+    };
+    parallel_for_each(iter, loop, elementwise_grain_size(1));
+    return true;
+}
+
+// Note [Tiled transpose copies]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// In a copy whose output is contiguous along one dimension and whose input is
+// contiguous along another, such as .contiguous() after a transpose or a
+// permute, the generic loop reads the input a row apart at every element. The
+// copy is instead cut into square tiles of kTransposeTile elements along the
+// two dimensions: a tile reads kTransposeTile rows of the input and writes
+// kTransposeTile rows of the output, all of which stay in L1 meanwhile. The
+// tiles, for every index of the other dimensions, are spread over the
+// parallel_tools pool. Elements are moved as raw bytes, so there is one
+// instantiation per element size; with AVX2, 4-byte elements are transposed
+// in registers 8x8 at a time.
+//
+// Large copies between contiguous tensors write with non-temporal stores
+// instead, which bypass the cache rather than evicting the input and the rest
+// of the working set for an output that is not read back before it is complete.
+
+constexpr int64_t kTransposeTile = 32;
+// Elements below which the generic loop is as fast
+constexpr int64_t kMinTransposeNumel = 64 * 64;
+
+// A 16-byte element, such as a complex double
+struct bytes16
+{
+    uint64_t words[2];
+};
+
+// Copies element (i, j) at src + i * src_row + j * sizeof(T) to
+// dst + i * sizeof(T) + j * dst_row, for i < rows and j < cols
+template <typename T>
+void transpose_block(
+    const char* src, int64_t src_row, char* dst, int64_t dst_row, int64_t rows, int64_t cols)
+{
+    for (const auto j : c10::irange(cols))
+    {
+        auto*       out = reinterpret_cast<T*>(dst + j * dst_row);
+        const char* in  = src + j * static_cast<int64_t>(sizeof(T));
+        for (const auto i : c10::irange(rows))
+        {
+            out[i] = *reinterpret_cast<const T*>(in + i * src_row);
+        }
+    }
+}
+
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+// transpose_block of 8x8 4-byte elements in registers. The float shuffles move
+// the bits of any 4-byte type unchanged.
+inline void transpose_8x8(const char* src, int64_t src_row, char* dst, int64_t dst_row)
+{
+    __m256 r[8];
+    __m256 t[8];
+    for (const auto k : c10::irange(8))
+    {
+        r[k] = _mm256_loadu_ps(reinterpret_cast<const float*>(src + k * src_row));
+    }
+    for (int k = 0; k < 8; k += 2)
+    {
+        t[k]     = _mm256_unpacklo_ps(r[k], r[k + 1]);
+        t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+    }
+    for (int k = 0; k < 8; k += 4)
+    {
+        r[k]     = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+        r[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+        r[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+        r[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (const auto k : c10::irange(4))
+    {
+        t[k]     = _mm256_permute2f128_ps(r[k], r[k + 4], 0x20);
+        t[k + 4] = _mm256_permute2f128_ps(r[k], r[k + 4], 0x31);
+    }
+    for (const auto k : c10::irange(8))
+    {
+        _mm256_storeu_ps(reinterpret_cast<float*>(dst + k * dst_row), t[k]);
+    }
+}
+
+template <>
+void transpose_block<uint32_t>(
+    const char* src, int64_t src_row, char* dst, int64_t dst_row, int64_t rows, int64_t cols)
+{
+    constexpr int64_t size  = sizeof(uint32_t);
+    const int64_t     rows8 = rows & ~int64_t{7};
+    const int64_t     cols8 = cols & ~int64_t{7};
+    for (int64_t j = 0; j < cols8; j += 8)
+    {
+        for (int64_t i = 0; i < rows8; i += 8)
+        {
+            transpose_8x8(
+                src + i * src_row + j * size, src_row, dst + i * size + j * dst_row, dst_row);
+        }
+    }
+    // The last rows, then the last columns of the other rows
+    auto scalar = [&](int64_t i, int64_t j, int64_t nrows, int64_t ncols)
+    {
+        for (const auto jj : c10::irange(j, j + ncols))
+        {
+            auto* out = reinterpret_cast<uint32_t*>(dst + jj * dst_row);
+            for (const auto ii : c10::irange(i, i + nrows))
+            {
+                out[ii] = *reinterpret_cast<const uint32_t*>(src + ii * src_row + jj * size);
+            }
+        }
+    };
+    scalar(rows8, 0, rows - rows8, cols);
+    scalar(0, cols8, rows8, cols - cols8);
+}
+#endif
+
+template <typename T>
+void tiled_transpose_copy_impl(TensorIteratorBase& iter, int k)
+{
+    const auto    shape      = iter.shape();
+    const auto    out_stride = iter.strides(0);
+    const auto    in_stride  = iter.strides(1);
+    char* const   out        = static_cast<char*>(iter.data_ptr(0));
+    const char*   in         = static_cast<const char*>(iter.data_ptr(1));
+    const int64_t tiles0     = (shape[0] + kTransposeTile - 1) / kTransposeTile;
+    const int64_t tilesk     = (shape[k] + kTransposeTile - 1) / kTransposeTile;
+    const int64_t tasks      = iter.numel() / shape[0] / shape[k] * tiles0 * tilesk;
+
+    parallel_tools::parallel_for(
+        0,
+        static_cast<size_t>(tasks),
+        static_cast<size_t>(std::max<int64_t>(
+            internal::GRAIN_SIZE / (kTransposeTile * kTransposeTile), 1)),
+        [&](size_t first, size_t last)
+        {
+            for (auto task = static_cast<int64_t>(first); task < static_cast<int64_t>(last);
+                 ++task)
+            {
+                const int64_t t0    = task % tiles0;
+                const int64_t tk    = task / tiles0 % tilesk;
+                int64_t       outer = task / tiles0 / tilesk;
+
+                // The other dimensions, fastest first
+                int64_t out_offset = 0;
+                int64_t in_offset  = 0;
+                for (int d = 1; d < iter.ndim(); ++d)
+                {
+                    if (d == k)
+                    {
+                        continue;
+                    }
+                    const int64_t index = outer % shape[d];
+                    outer /= shape[d];
+                    out_offset += index * out_stride[d];
+                    in_offset += index * in_stride[d];
+                }
+
+                const int64_t i = t0 * kTransposeTile;
+                const int64_t j = tk * kTransposeTile;
+                transpose_block<T>(
+                    in + in_offset + i * in_stride[0] + j * in_stride[k],
+                    in_stride[0],
+                    out + out_offset + i * out_stride[0] + j * out_stride[k],
+                    out_stride[k],
+                    std::min(kTransposeTile, shape[0] - i),
+                    std::min(kTransposeTile, shape[k] - j));
+            }
+        });
+}
+
+// Copies as in Note [Tiled transpose copies] when the output is contiguous
+// along the first dimension of iter and the input along another. Returns
+// false, leaving iter untouched, for the other copies.
+bool tiled_transpose_copy(TensorIteratorBase& iter)
+{
+    if (iter.ndim() < 2 || iter.numel() < kMinTransposeNumel)
+    {
+        return false;
+    }
+    const int64_t size  = iter.element_size(0);
+    const auto    shape = iter.shape();
+    if (iter.strides(0)[0] != size || iter.strides(1)[0] == size || iter.strides(1)[0] == 0 ||
+        shape[0] < 8)
+    {
+        return false;
+    }
+    int k = -1;
+    for (int d = 1; d < iter.ndim() && k < 0; ++d)
+    {
+        if (iter.strides(1)[d] == size && shape[d] >= 8)
+        {
+            k = d;
+        }
+    }
+    if (k < 0)
+    {
+        return false;
+    }
+
+    switch (size)
+    {
+    case 1:
+        tiled_transpose_copy_impl<uint8_t>(iter, k);
+        return true;
+    case 2:
+        tiled_transpose_copy_impl<uint16_t>(iter, k);
+        return true;
+    case 4:
+        tiled_transpose_copy_impl<uint32_t>(iter, k);
+        return true;
+    case 8:
+        tiled_transpose_copy_impl<uint64_t>(iter, k);
+        return true;
+    case 16:
+        tiled_transpose_copy_impl<bytes16>(iter, k);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Copies large contiguous tensors as in Note [Tiled transpose copies].
+// Returns false, leaving iter untouched, for the other copies.
+bool streaming_copy(TensorIteratorBase& iter)
+{
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+    // About the size of a last-level cache
+    constexpr int64_t kStreamingCopyBytes = int64_t{1} << 25;
+    const int64_t     nbytes              = iter.numel() * iter.element_size(0);
+    if (nbytes < kStreamingCopyBytes || !iter.is_contiguous())
+    {
+        return false;
+    }
+    char* const       out = static_cast<char*>(iter.data_ptr(0));
+    const char* const in  = static_cast<const char*>(iter.data_ptr(1));
+    parallel_tools::parallel_for(
+        0,
+        static_cast<size_t>(nbytes),
+        size_t{1} << 20,
+        [out, in](size_t first, size_t last)
+        {
+            // Align the stores to 32 bytes, as _mm256_stream_si256 requires
+            const size_t misaligned = reinterpret_cast<uintptr_t>(out + first) % 32;
+            const size_t head =
+                std::min<size_t>(last - first, misaligned == 0 ? 0 : 32 - misaligned);
+            std::memcpy(out + first, in + first, head);
+            size_t i = first + head;
+            for (; i + 32 <= last; i += 32)
+            {
+                _mm256_stream_si256(
+                    reinterpret_cast<__m256i*>(out + i),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+            }
+            std::memcpy(out + i, in + i, last - i);
+            _mm_sfence();
+        });
+    return true;
+#else
+    (void)iter;
+    return false;
+#endif
+}
 }  // namespace
 
 static bool reduced_float_type_copy(bool requires_conj, TensorIteratorBase& iter)
@@ -395,7 +693,7 @@ static void copy_same_dtype(TensorIteratorBase& iter, bool requires_conj, bool r
         {
             conj_kernel(iter);
         }
-        else
+        else if (!tiled_transpose_copy(iter) && !streaming_copy(iter))
         {
             direct_copy_kernel(iter);
         }
@@ -417,6 +715,15 @@ void copy_kernel(TensorIterator& iter, bool /*non_blocking*/)
     {
         reduced_float_copy_kernel(iter, requires_neg);
     }
+    else if (dtype_conversion_copy(iter))
+    {
+        if (requires_neg)
+        {
+            auto self = iter.tensor_base(0);
+            auto iter = TensorIterator::unary_op(self, self);
+            copy_same_dtype(iter, false, requires_neg);
+        }
+    }
     else
     {
         _AT_DISPATCH_ALL_TYPES(
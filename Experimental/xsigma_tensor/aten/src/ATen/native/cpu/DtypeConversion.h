@@ -0,0 +1,451 @@
+#pragma once
+
+// Vectorized conversions of contiguous rows between double, float,
+// BFloat16, Half, int32 and int64, used by the CPU copy kernel for to(dtype).
+//
+// The conversions to or from Half and BFloat16 go through float, as
+// c10::convert does, so every path rounds exactly as the scalar one: round to
+// nearest even, NaN to the quiet NaN of BFloat16, float to integer by
+// truncation. The primitive float <-> Half/BFloat16, double <-> float and
+// integer <-> floating point rows use F16C and AVX2, AVX-512 (and AVX-512DQ
+// for int64), or the NEON vcvt instructions; the other pairs are chained
+// through a float block that stays in L1.
+//
+// Only included from files compiled once per CPU capability.
+
+#include <c10/core/ScalarType.h>
+#include <c10/util/BFloat16.h>
+#include <c10/util/Half.h>
+#include <c10/util/TypeCast.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace at::native
+{
+inline namespace CPU_CAPABILITY
+{
+namespace dtype_conversion
+{
+
+// Elements of the float block that chains two conversions
+constexpr int64_t kChainBlock = 256;
+
+template <typename src_t, typename dst_t>
+inline void convert_scalar(const src_t* src, dst_t* dst, int64_t n)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        dst[i] = c10::convert<dst_t>(src[i]);
+    }
+}
+
+// The bits of the BFloat16 nearest to x, as c10::BFloat16(float)
+inline uint16_t bfloat16_bits(float x)
+{
+    return c10::BFloat16(x).x;
+}
+
+// Primitive rows: the generic one is scalar, the overloads below vectorize
+template <typename src_t, typename dst_t>
+inline void convert_row(const src_t* src, dst_t* dst, int64_t n)
+{
+    convert_scalar(src, dst, n);
+}
+
+inline void convert_row(const float* src, c10::Half* dst, int64_t n)
+{
+    int64_t i   = 0;
+    auto*   out = reinterpret_cast<uint16_t*>(dst);
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512  v = _mm512_loadu_ps(src + i);
+        const __m256i h = _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), h);
+    }
+#elif defined(CPU_CAPABILITY_AVX2) && defined(__F16C__)
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const c10::Half* src, float* dst, int64_t n)
+{
+    int64_t     i  = 0;
+    const auto* in = reinterpret_cast<const uint16_t*>(src);
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+    }
+#elif defined(CPU_CAPABILITY_AVX2) && defined(__F16C__)
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const float* src, c10::BFloat16* dst, int64_t n)
+{
+    // Round to nearest even on the bits, NaN to 0x7FC0, as c10::BFloat16
+    int64_t i   = 0;
+    auto*   out = reinterpret_cast<uint16_t*>(dst);
+#if defined(CPU_CAPABILITY_AVX512)
+    const __m512i bias = _mm512_set1_epi32(0x7FFF);
+    const __m512i one  = _mm512_set1_epi32(1);
+    const __m512i qnan = _mm512_set1_epi32(0x7FC0);
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512  v    = _mm512_loadu_ps(src + i);
+        const __m512i x    = _mm512_castps_si512(v);
+        const __m512i lsb  = _mm512_and_si512(_mm512_srli_epi32(x, 16), one);
+        const __m512i sum  = _mm512_add_epi32(x, _mm512_add_epi32(bias, lsb));
+        const __m512i bits = _mm512_mask_blend_epi32(
+            _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q), _mm512_srli_epi32(sum, 16), qnan);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtepi32_epi16(bits));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    const __m256i bias = _mm256_set1_epi32(0x7FFF);
+    const __m256i one  = _mm256_set1_epi32(1);
+    const __m256i qnan = _mm256_set1_epi32(0x7FC0);
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256  v    = _mm256_loadu_ps(src + i);
+        const __m256i x    = _mm256_castps_si256(v);
+        const __m256i lsb  = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+        const __m256i sum  = _mm256_add_epi32(x, _mm256_add_epi32(bias, lsb));
+        const __m256i nan  = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+        const __m256i bits = _mm256_blendv_epi8(_mm256_srli_epi32(sum, 16), qnan, nan);
+        // Pack the 32-bit lanes to 16 bits and gather the two 128-bit halves
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(bits, bits), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint32x4_t bias = vdupq_n_u32(0x7FFF);
+    const uint32x4_t one  = vdupq_n_u32(1);
+    const uint32x4_t qnan = vdupq_n_u32(0x7FC0);
+    for (; i + 4 <= n; i += 4)
+    {
+        const float32x4_t v    = vld1q_f32(src + i);
+        const uint32x4_t  x    = vreinterpretq_u32_f32(v);
+        const uint32x4_t  lsb  = vandq_u32(vshrq_n_u32(x, 16), one);
+        const uint32x4_t  sum  = vaddq_u32(x, vaddq_u32(bias, lsb));
+        const uint32x4_t  bits = vbslq_u32(vmvnq_u32(vceqq_f32(v, v)), qnan, vshrq_n_u32(sum, 16));
+        vst1_u16(out + i, vmovn_u32(bits));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        out[i] = bfloat16_bits(src[i]);
+    }
+}
+
+inline void convert_row(const c10::BFloat16* src, float* dst, int64_t n)
+{
+    // A BFloat16 is the high half of the float
+    int64_t     i  = 0;
+    const auto* in = reinterpret_cast<const uint16_t*>(src);
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm512_storeu_ps(
+            dst + i, _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16)));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(
+            dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f32(dst + i, vreinterpretq_f32_u32(vshlq_n_u32(vmovl_u16(vld1_u16(in + i)), 16)));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const double* src, float* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(dst + i, _mm512_cvtpd_ps(_mm512_loadu_pd(src + i)));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+    {
+        const float32x2_t lo = vcvt_f32_f64(vld1q_f64(src + i));
+        vst1q_f32(dst + i, vcvt_high_f32_f64(lo, vld1q_f64(src + i + 2)));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const float* src, double* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_storeu_pd(dst + i, _mm512_cvtps_pd(_mm256_loadu_ps(src + i)));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+    {
+        const float32x4_t v = vld1q_f32(src + i);
+        vst1q_f64(dst + i, vcvt_f64_f32(vget_low_f32(v)));
+        vst1q_f64(dst + i + 2, vcvt_high_f64_f32(v));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const int32_t* src, float* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(dst + i, _mm512_cvtepi32_ps(_mm512_loadu_si512(src + i)));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(v));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f32(dst + i, vcvtq_f32_s32(vld1q_s32(src + i)));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const float* src, int32_t* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_si512(dst + i, _mm512_cvttps_epi32(_mm512_loadu_ps(src + i)));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(dst + i), _mm256_cvttps_epi32(_mm256_loadu_ps(src + i)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_s32(dst + i, vcvtq_s32_f32(vld1q_f32(src + i)));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const int32_t* src, double* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm512_storeu_pd(dst + i, _mm512_cvtepi32_pd(v));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_pd(dst + i, _mm256_cvtepi32_pd(v));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const double* src, int32_t* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(dst + i), _mm512_cvttpd_epi32(_mm512_loadu_pd(src + i)));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + i), _mm256_cvttpd_epi32(_mm256_loadu_pd(src + i)));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const int64_t* src, double* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512) && defined(__AVX512DQ__)
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_storeu_pd(dst + i, _mm512_cvtepi64_pd(_mm512_loadu_si512(src + i)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 2 <= n; i += 2)
+    {
+        vst1q_f64(dst + i, vcvtq_f64_s64(vld1q_s64(src + i)));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+inline void convert_row(const double* src, int64_t* dst, int64_t n)
+{
+    int64_t i = 0;
+#if defined(CPU_CAPABILITY_AVX512) && defined(__AVX512DQ__)
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_storeu_si512(dst + i, _mm512_cvttpd_epi64(_mm512_loadu_pd(src + i)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 2 <= n; i += 2)
+    {
+        vst1q_s64(dst + i, vcvtq_s64_f64(vld1q_f64(src + i)));
+    }
+#endif
+    convert_scalar(src + i, dst + i, n - i);
+}
+
+template <typename T>
+constexpr bool is_reduced_float_v =
+    std::is_same_v<T, c10::Half> || std::is_same_v<T, c10::BFloat16>;
+
+// src -> dst for any pair of the supported types. Pairs with a reduced
+// floating point end that is not float go through a float block.
+template <typename src_t, typename dst_t>
+void convert_chained(const src_t* src, dst_t* dst, int64_t n)
+{
+    constexpr bool via_float = (is_reduced_float_v<src_t> && !std::is_same_v<dst_t, float>) ||
+                               (is_reduced_float_v<dst_t> && !std::is_same_v<src_t, float>);
+    if constexpr (via_float)
+    {
+        float block[kChainBlock];
+        for (int64_t i = 0; i < n; i += kChainBlock)
+        {
+            const int64_t len = std::min(kChainBlock, n - i);
+            convert_row(src + i, block, len);
+            convert_row(static_cast<const float*>(block), dst + i, len);
+        }
+    }
+    else
+    {
+        convert_row(src, dst, n);
+    }
+}
+
+using convert_fn = void (*)(const void* src, void* dst, int64_t n);
+
+template <typename src_t, typename dst_t>
+void convert_erased(const void* src, void* dst, int64_t n)
+{
+    convert_chained(static_cast<const src_t*>(src), static_cast<dst_t*>(dst), n);
+}
+
+template <typename src_t>
+convert_fn convert_from(ScalarType dst_type)
+{
+    switch (dst_type)
+    {
+    case ScalarType::Double:
+        return &convert_erased<src_t, double>;
+    case ScalarType::Float:
+        return &convert_erased<src_t, float>;
+    case ScalarType::BFloat16:
+        return &convert_erased<src_t, c10::BFloat16>;
+    case ScalarType::Half:
+        return &convert_erased<src_t, c10::Half>;
+    case ScalarType::Int:
+        return &convert_erased<src_t, int32_t>;
+    case ScalarType::Long:
+        return &convert_erased<src_t, int64_t>;
+    default:
+        return nullptr;
+    }
+}
+
+// The row conversion of src_type to dst_type, or nullptr when the pair is
+// not one of the vectorized conversions
+inline convert_fn conversion_kernel(ScalarType src_type, ScalarType dst_type)
+{
+    const bool src_integral = src_type == ScalarType::Int || src_type == ScalarType::Long;
+    const bool dst_integral = dst_type == ScalarType::Int || dst_type == ScalarType::Long;
+    if (src_type == dst_type || (src_integral && dst_integral))
+    {
+        return nullptr;
+    }
+    switch (src_type)
+    {
+    case ScalarType::Double:
+        return convert_from<double>(dst_type);
+    case ScalarType::Float:
+        return convert_from<float>(dst_type);
+    case ScalarType::BFloat16:
+        return convert_from<c10::BFloat16>(dst_type);
+    case ScalarType::Half:
+        return convert_from<c10::Half>(dst_type);
+    case ScalarType::Int:
+        return convert_from<int32_t>(dst_type);
+    case ScalarType::Long:
+        return convert_from<int64_t>(dst_type);
+    default:
+        return nullptr;
+    }
+}
+
+}  // namespace dtype_conversion
+}  // namespace CPU_CAPABILITY
+}  // namespace at::native
@@ -0,0 +1,380 @@
+#define TORCH_ASSERT_NO_OPERATORS
+#include <Quarisma/Dispatch.h>
+#include <Quarisma/NumericUtils.h>
+#include <Quarisma/TensorIterator.h>
+#include <Quarisma/cpu/vec/functional.h>
+#include <Quarisma/cpu/vec/vec.h>
+#include <Quarisma/native/Elementwise.h>
+#include <Quarisma/native/cpu/ElementwiseLoops.h>
+#include <c10/util/irange.h>
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include "parallel/parallel_tools.h"
+
+namespace at::native
+{
+inline namespace CPU_CAPABILITY
+{
+
+namespace
+{
+// Per-element cost of the transcendental functions, relative to an add
+constexpr int64_t kTranscendentalCost = 8;
+
+// NaN propagating maximum and minimum, as vec::maximum and vec::minimum
+template <typename scalar_t>
+scalar_t propagate_nan_max(scalar_t a, scalar_t b)
+{
+    return (_isnan<scalar_t>(a) || a > b) ? a : b;
+}
+
+template <typename scalar_t>
+scalar_t propagate_nan_min(scalar_t a, scalar_t b)
+{
+    return (_isnan<scalar_t>(a) || a < b) ? a : b;
+}
+
+void unary_elementwise_kernel(TensorIteratorBase& iter, UnaryOpKind op)
+{
+    if (op == UnaryOpKind::Abs || op == UnaryOpKind::Neg)
+    {
+        AT_DISPATCH_ALL_TYPES(
+            iter.common_dtype(),
+            "elementwise_unary",
+            [&]
+            {
+                using Vec = Vectorized<scalar_t>;
+                if (op == UnaryOpKind::Abs)
+                {
+                    elementwise_kernel<scalar_t, 1>(
+                        iter,
+                        make_vec_op(
+                            [](scalar_t a) { return static_cast<scalar_t>(std::abs(a)); },
+                            [](Vec a) { return a.abs(); }));
+                }
+                else
+                {
+                    elementwise_kernel<scalar_t, 1>(
+                        iter,
+                        make_vec_op(
+                            [](scalar_t a) { return static_cast<scalar_t>(-a); },
+                            [](Vec a) { return a.neg(); }));
+                }
+            });
+        return;
+    }
+
+    AT_DISPATCH_FLOATING_TYPES(
+        iter.common_dtype(),
+        "elementwise_unary",
+        [&]
+        {
+            using Vec = Vectorized<scalar_t>;
+            switch (op)
+            {
+            case UnaryOpKind::Exp:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return std::exp(a); }, [](Vec a) { return a.exp(); }),
+                    kTranscendentalCost);
+                break;
+            case UnaryOpKind::Log:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return std::log(a); }, [](Vec a) { return a.log(); }),
+                    kTranscendentalCost);
+                break;
+            case UnaryOpKind::Sqrt:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return std::sqrt(a); }, [](Vec a) { return a.sqrt(); }),
+                    2);
+                break;
+            case UnaryOpKind::Reciprocal:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return static_cast<scalar_t>(1) / a; },
+                        [](Vec a) { return a.reciprocal(); }),
+                    2);
+                break;
+            case UnaryOpKind::Sin:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return std::sin(a); }, [](Vec a) { return a.sin(); }),
+                    kTranscendentalCost);
+                break;
+            case UnaryOpKind::Cos:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return std::cos(a); }, [](Vec a) { return a.cos(); }),
+                    kTranscendentalCost);
+                break;
+            case UnaryOpKind::Tanh:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return std::tanh(a); }, [](Vec a) { return a.tanh(); }),
+                    kTranscendentalCost);
+                break;
+            case UnaryOpKind::Erf:
+                elementwise_kernel<scalar_t, 1>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a) { return std::erf(a); }, [](Vec a) { return a.erf(); }),
+                    kTranscendentalCost);
+                break;
+            default:
+                TORCH_INTERNAL_ASSERT(false, "Unexpected unary op");
+            }
+        });
+}
+
+void binary_elementwise_kernel(
+    TensorIteratorBase& iter, BinaryOpKind op, const c10::Scalar& alpha_scalar)
+{
+    if (op == BinaryOpKind::Div)
+    {
+        AT_DISPATCH_FLOATING_TYPES(
+            iter.common_dtype(),
+            "elementwise_binary",
+            [&]
+            {
+                using Vec = Vectorized<scalar_t>;
+                elementwise_kernel<scalar_t, 2>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return a / b; },
+                        [](Vec a, Vec b) { return a / b; }),
+                    2);
+            });
+        return;
+    }
+
+    AT_DISPATCH_ALL_TYPES(
+        iter.common_dtype(),
+        "elementwise_binary",
+        [&]
+        {
+            using Vec              = Vectorized<scalar_t>;
+            const scalar_t alpha   = alpha_scalar.to<scalar_t>();
+            const Vec      alpha_v = Vec(alpha);
+            switch (op)
+            {
+            case BinaryOpKind::Add:
+                elementwise_kernel<scalar_t, 2>(
+                    iter,
+                    make_vec_op(
+                        [=](scalar_t a, scalar_t b)
+                        { return static_cast<scalar_t>(a + alpha * b); },
+                        [=](Vec a, Vec b) { return vec::fmadd(b, alpha_v, a); }));
+                break;
+            case BinaryOpKind::Sub:
+                elementwise_kernel<scalar_t, 2>(
+                    iter,
+                    make_vec_op(
+                        [=](scalar_t a, scalar_t b)
+                        { return static_cast<scalar_t>(a - alpha * b); },
+                        [=](Vec a, Vec b) { return a - b * alpha_v; }));
+                break;
+            case BinaryOpKind::Mul:
+                elementwise_kernel<scalar_t, 2>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a * b); },
+                        [](Vec a, Vec b) { return a * b; }));
+                break;
+            case BinaryOpKind::Maximum:
+                elementwise_kernel<scalar_t, 2>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return propagate_nan_max(a, b); },
+                        [](Vec a, Vec b) { return vec::maximum(a, b); }));
+                break;
+            case BinaryOpKind::Minimum:
+                elementwise_kernel<scalar_t, 2>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return propagate_nan_min(a, b); },
+                        [](Vec a, Vec b) { return vec::minimum(a, b); }));
+                break;
+            default:
+                TORCH_INTERNAL_ASSERT(false, "Unexpected binary op");
+            }
+        });
+}
+
+void ternary_elementwise_kernel(
+    TensorIteratorBase& iter, TernaryOpKind op, const c10::Scalar& value_scalar)
+{
+    AT_DISPATCH_FLOATING_TYPES(
+        iter.common_dtype(),
+        "elementwise_ternary",
+        [&]
+        {
+            using Vec              = Vectorized<scalar_t>;
+            const scalar_t value   = value_scalar.to<scalar_t>();
+            const Vec      value_v = Vec(value);
+            switch (op)
+            {
+            case TernaryOpKind::Addcmul:
+                elementwise_kernel<scalar_t, 3>(
+                    iter,
+                    make_vec_op(
+                        [=](scalar_t a, scalar_t b, scalar_t c) { return a + value * b * c; },
+                        [=](Vec a, Vec b, Vec c) { return vec::fmadd(value_v * b, c, a); }));
+                break;
+            case TernaryOpKind::Addcdiv:
+                elementwise_kernel<scalar_t, 3>(
+                    iter,
+                    make_vec_op(
+                        [=](scalar_t a, scalar_t b, scalar_t c) { return a + value * b / c; },
+                        [=](Vec a, Vec b, Vec c) { return vec::fmadd(value_v, b / c, a); }),
+                    2);
+                break;
+            case TernaryOpKind::Lerp:
+                // a is self, b the end and c the weight
+                elementwise_kernel<scalar_t, 3>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b, scalar_t c) { return a + c * (b - a); },
+                        [](Vec a, Vec b, Vec c) { return vec::fmadd(c, b - a, a); }));
+                break;
+            default:
+                TORCH_INTERNAL_ASSERT(false, "Unexpected ternary op");
+            }
+        });
+}
+
+// Folds the input of iter into its output, which holds the identity of op.
+// A full reduction runs parallel_tools::parallel_reduce over the input, each
+// block starting from the identity; a partial one runs
+// TensorIteratorBase::parallel_reduce, which splits the work so that no two
+// threads write the same output element.
+template <typename scalar_t, typename op_t>
+void reduce_kernel(TensorIteratorBase& iter, const op_t& op)
+{
+    const int64_t numel = iter.numel();
+    if (numel == 0)
+    {
+        return;
+    }
+
+    if (iter.num_output_elements() == 1)
+    {
+        auto*          out      = static_cast<scalar_t*>(iter.data_ptr(0));
+        const scalar_t identity = *out;
+        *out                    = parallel_tools::parallel_reduce(
+            0,
+            static_cast<size_t>(numel),
+            static_cast<size_t>(elementwise_grain_size(1)),
+            identity,
+            [&iter, &op, identity](size_t begin, size_t end)
+            {
+                scalar_t acc  = identity;
+                auto     loop = [&acc, &op](
+                                char** data, const int64_t* strides, int64_t size0, int64_t size1)
+                {
+                    const char* in = data[1];
+                    for ([[maybe_unused]] const auto j : c10::irange(size1))
+                    {
+                        acc = reduce_row(acc, in, strides[1], size0, op);
+                        in += strides[3];
+                    }
+                };
+                iter.serial_for_each(
+                    loop, {static_cast<int64_t>(begin), static_cast<int64_t>(end)});
+                return acc;
+            },
+            [&op](scalar_t a, scalar_t b) { return op(a, b); });
+        return;
+    }
+
+    iter.parallel_reduce(
+        [&op](char** data, const int64_t* strides, int64_t size0, int64_t size1)
+        {
+            char* out = data[0];
+            char* in  = data[1];
+            for ([[maybe_unused]] const auto j : c10::irange(size1))
+            {
+                if (strides[0] == 0)
+                {
+                    // The row folds into one output element
+                    auto* acc = reinterpret_cast<scalar_t*>(out);
+                    *acc      = reduce_row(*acc, in, strides[1], size0, op);
+                }
+                else
+                {
+                    // Each element of the row folds into its own output element
+                    char* const   row[3]         = {out, out, in};
+                    const int64_t row_strides[3] = {strides[0], strides[0], strides[1]};
+                    vectorized_row<scalar_t>(
+                        row, row_strides, size0, op, std::make_index_sequence<2>{});
+                }
+                out += strides[2];
+                in += strides[3];
+            }
+        });
+}
+
+void reduce_elementwise_kernel(TensorIteratorBase& iter, ReduceOpKind op)
+{
+    AT_DISPATCH_ALL_TYPES(
+        iter.input_dtype(),
+        "elementwise_reduce",
+        [&]
+        {
+            using Vec = Vectorized<scalar_t>;
+            switch (op)
+            {
+            case ReduceOpKind::Sum:
+                reduce_kernel<scalar_t>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a + b); },
+                        [](Vec a, Vec b) { return a + b; }));
+                break;
+            case ReduceOpKind::Prod:
+                reduce_kernel<scalar_t>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a * b); },
+                        [](Vec a, Vec b) { return a * b; }));
+                break;
+            case ReduceOpKind::Max:
+                reduce_kernel<scalar_t>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return propagate_nan_max(a, b); },
+                        [](Vec a, Vec b) { return vec::maximum(a, b); }));
+                break;
+            case ReduceOpKind::Min:
+                reduce_kernel<scalar_t>(
+                    iter,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return propagate_nan_min(a, b); },
+                        [](Vec a, Vec b) { return vec::minimum(a, b); }));
+                break;
+            default:
+                TORCH_INTERNAL_ASSERT(false, "Unexpected reduce op");
+            }
+        });
+}
+}  // namespace
+
+}  // namespace CPU_CAPABILITY
+
+REGISTER_DISPATCH(unary_elementwise_stub, &unary_elementwise_kernel)
+REGISTER_DISPATCH(binary_elementwise_stub, &binary_elementwise_kernel)
+REGISTER_DISPATCH(ternary_elementwise_stub, &ternary_elementwise_kernel)
+REGISTER_DISPATCH(reduce_elementwise_stub, &reduce_elementwise_kernel)
+
+}  // namespace at::native
@@ -0,0 +1,181 @@
+#pragma once
+
+// Loops of the elementwise kernels of native/Elementwise.h.
+//
+// An op is a functor with a scalar operator() and a vec() member of the same
+// arity on Vectorized<scalar_t>. The inner dimension of the iterator runs
+// vec() when the output is contiguous and each input is contiguous or
+// broadcast, and operator() otherwise and on the tail. Blocks of the iteration
+// space run on the Core thread pool, sized by the cost of the op.
+//
+// This file is compiled once per CPU capability, like the kernels including it.
+
+#include <Quarisma/TensorIterator.h>
+#include <Quarisma/cpu/vec/functional.h>
+#include <Quarisma/cpu/vec/vec.h>
+#include <c10/util/irange.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "parallel/parallel_tools.h"
+
+namespace at::native
+{
+inline namespace CPU_CAPABILITY
+{
+
+// An op from a scalar lambda and a vectorized lambda, as in cpu_kernel_vec
+template <typename scalar_op_t, typename vec_op_t>
+struct VecOp
+{
+    scalar_op_t scalar_op;
+    vec_op_t    vec_op;
+
+    template <typename... Args>
+    auto operator()(Args... args) const
+    {
+        return scalar_op(args...);
+    }
+
+    template <typename... Args>
+    auto vec(Args... args) const
+    {
+        return vec_op(args...);
+    }
+};
+
+template <typename scalar_op_t, typename vec_op_t>
+VecOp<scalar_op_t, vec_op_t> make_vec_op(scalar_op_t scalar_op, vec_op_t vec_op)
+{
+    return {std::move(scalar_op), std::move(vec_op)};
+}
+
+// Elements per block of an op costing about cost adds per element, so that a
+// block does about GRAIN_SIZE adds of work
+inline int64_t elementwise_grain_size(int64_t cost)
+{
+    return std::max<int64_t>(at::internal::GRAIN_SIZE / std::max<int64_t>(cost, 1), 1);
+}
+
+// TensorIteratorBase::for_each on the Core thread pool: serial below grain
+// elements or within a parallel region, in blocks of at least grain otherwise
+template <typename loop_t>
+void parallel_for_each(TensorIteratorBase& iter, const loop_t& loop, int64_t grain)
+{
+    const int64_t numel = iter.numel();
+    if (numel == 0)
+    {
+        return;
+    }
+    if (numel < grain || parallel_tools::is_parallel_scope())
+    {
+        iter.serial_for_each(loop, {0, numel});
+        return;
+    }
+    parallel_tools::parallel_for(
+        0,
+        static_cast<size_t>(numel),
+        static_cast<size_t>(grain),
+        [&iter, &loop](size_t begin, size_t end)
+        {
+            iter.serial_for_each(
+                loop, {static_cast<int64_t>(begin), static_cast<int64_t>(end)});
+        });
+}
+
+// Element i of a contiguous row, or the broadcast element when stride is 0
+template <typename scalar_t>
+Vectorized<scalar_t> load_vec(const char* ptr, int64_t stride, int64_t i)
+{
+    return stride == 0 ? Vectorized<scalar_t>(*reinterpret_cast<const scalar_t*>(ptr))
+                       : Vectorized<scalar_t>::loadu(ptr + i * sizeof(scalar_t));
+}
+
+// Applies op to a row of n elements, data[0] being the output and data[1 + I]
+// the inputs
+template <typename scalar_t, typename op_t, size_t... I>
+void vectorized_row(
+    char* const* data, const int64_t* strides, int64_t n, const op_t& op, std::index_sequence<I...>)
+{
+    using Vec                   = Vectorized<scalar_t>;
+    constexpr int64_t elem_size = sizeof(scalar_t);
+    constexpr int64_t vec_size  = Vec::size();
+
+    char*   out = data[0];
+    int64_t i   = 0;
+    if (strides[0] == elem_size &&
+        ((strides[1 + I] == elem_size || strides[1 + I] == 0) && ...))
+    {
+        for (; i + vec_size <= n; i += vec_size)
+        {
+            op.vec(load_vec<scalar_t>(data[1 + I], strides[1 + I], i)...)
+                .store(out + i * elem_size);
+        }
+    }
+    for (; i < n; ++i)
+    {
+        *reinterpret_cast<scalar_t*>(out + i * strides[0]) =
+            op(*reinterpret_cast<const scalar_t*>(data[1 + I] + i * strides[1 + I])...);
+    }
+}
+
+// Runs op of ninputs inputs over iter, whose operands all have type scalar_t
+template <typename scalar_t, size_t ninputs, typename op_t>
+void elementwise_kernel(TensorIteratorBase& iter, const op_t& op, int64_t cost = 1)
+{
+    constexpr size_t ntensors = ninputs + 1;
+    TORCH_INTERNAL_ASSERT(iter.ntensors() == static_cast<int>(ntensors));
+
+    auto loop = [&op](char** base, const int64_t* strides, int64_t size0, int64_t size1)
+    {
+        std::array<char*, ntensors> data;
+        std::copy_n(base, ntensors, data.data());
+        const int64_t* outer_strides = &strides[ntensors];
+
+        for ([[maybe_unused]] const auto j : c10::irange(size1))
+        {
+            vectorized_row<scalar_t>(
+                data.data(), strides, size0, op, std::make_index_sequence<ninputs>{});
+            for (const auto arg : c10::irange(ntensors))
+            {
+                data[arg] += outer_strides[arg];
+            }
+        }
+    };
+    parallel_for_each(iter, loop, elementwise_grain_size(cost));
+}
+
+// Folds the n elements of a row of the given stride into acc with the binary
+// op, vectorized when the row is contiguous
+template <typename scalar_t, typename op_t>
+scalar_t reduce_row(scalar_t acc, const char* in, int64_t stride, int64_t n, const op_t& op)
+{
+    using Vec                   = Vectorized<scalar_t>;
+    constexpr int64_t elem_size = sizeof(scalar_t);
+    constexpr int64_t vec_size  = Vec::size();
+
+    int64_t i = 0;
+    if (stride == elem_size && n >= vec_size)
+    {
+        Vec vacc = Vec::loadu(in);
+        for (i = vec_size; i + vec_size <= n; i += vec_size)
+        {
+            vacc = op.vec(vacc, Vec::loadu(in + i * elem_size));
+        }
+        acc = op(
+            acc,
+            vec::vec_reduce_all<scalar_t>([&op](Vec a, Vec b) { return op.vec(a, b); }, vacc));
+    }
+    for (; i < n; ++i)
+    {
+        acc = op(acc, *reinterpret_cast<const scalar_t*>(in + i * stride));
+    }
+    return acc;
+}
+
+}  // namespace CPU_CAPABILITY
+}  // namespace at::native
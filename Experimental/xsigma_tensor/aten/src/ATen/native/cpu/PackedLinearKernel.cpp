@@ -0,0 +1,228 @@
+#define TORCH_ASSERT_NO_OPERATORS
+#include <Quarisma/native/PackedLinear.h>
+#include <c10/util/irange.h>
+
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+
+#include "parallel/parallel_tools.h"
+
+namespace at::native
+{
+inline namespace CPU_CAPABILITY
+{
+
+namespace
+{
+constexpr int64_t kPanel = kPackedLinearPanel;
+
+// Rows of A sharing the loads of a panel row in the micro-kernel: 4 rows of
+// 16 floats are 4 AVX512, 8 AVX2 or 16 NEON accumulators
+constexpr int kMicroRows = 4;
+
+// Tiles of the output: kBlockM rows of A, 16 KiB for a block of 256 inputs,
+// run over one panel while it stays in L1
+constexpr int64_t kBlockM = 16;
+
+// Multiply-adds below which packed_linear stays on the calling thread
+constexpr int64_t kParallelMacs = int64_t{1} << 18;
+
+// acc (kRows x kPanel, row-major) += A[0..kRows)[0..len) panel, where panel
+// is the len x kPanel block of one panel and one input block
+template <int kRows>
+void panel_kernel(const float* a, int64_t lda, const float* panel, int64_t len, float* acc)
+{
+#if defined(CPU_CAPABILITY_AVX512)
+    __m512 c[kRows];
+    for (const auto r : c10::irange(kRows))
+    {
+        c[r] = _mm512_loadu_ps(acc + r * kPanel);
+    }
+    for (const auto l : c10::irange(len))
+    {
+        const __m512 w = _mm512_loadu_ps(panel + l * kPanel);
+        for (const auto r : c10::irange(kRows))
+        {
+            c[r] = _mm512_fmadd_ps(_mm512_set1_ps(a[r * lda + l]), w, c[r]);
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        _mm512_storeu_ps(acc + r * kPanel, c[r]);
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    __m256 c[kRows][2];
+    for (const auto r : c10::irange(kRows))
+    {
+        c[r][0] = _mm256_loadu_ps(acc + r * kPanel);
+        c[r][1] = _mm256_loadu_ps(acc + r * kPanel + 8);
+    }
+    for (const auto l : c10::irange(len))
+    {
+        const __m256 w0 = _mm256_loadu_ps(panel + l * kPanel);
+        const __m256 w1 = _mm256_loadu_ps(panel + l * kPanel + 8);
+        for (const auto r : c10::irange(kRows))
+        {
+            const __m256 va = _mm256_broadcast_ss(a + r * lda + l);
+            c[r][0]         = _mm256_fmadd_ps(va, w0, c[r][0]);
+            c[r][1]         = _mm256_fmadd_ps(va, w1, c[r][1]);
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        _mm256_storeu_ps(acc + r * kPanel, c[r][0]);
+        _mm256_storeu_ps(acc + r * kPanel + 8, c[r][1]);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t c[kRows][4];
+    for (const auto r : c10::irange(kRows))
+    {
+        for (const auto q : c10::irange(4))
+        {
+            c[r][q] = vld1q_f32(acc + r * kPanel + q * 4);
+        }
+    }
+    for (const auto l : c10::irange(len))
+    {
+        float32x4_t w[4];
+        for (const auto q : c10::irange(4))
+        {
+            w[q] = vld1q_f32(panel + l * kPanel + q * 4);
+        }
+        for (const auto r : c10::irange(kRows))
+        {
+            const float va = a[r * lda + l];
+            for (const auto q : c10::irange(4))
+            {
+                c[r][q] = vfmaq_n_f32(c[r][q], w[q], va);
+            }
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        for (const auto q : c10::irange(4))
+        {
+            vst1q_f32(acc + r * kPanel + q * 4, c[r][q]);
+        }
+    }
+#else
+    for (const auto l : c10::irange(len))
+    {
+        const float* w = panel + l * kPanel;
+        for (const auto r : c10::irange(kRows))
+        {
+            const float va = a[r * lda + l];
+            for (const auto j : c10::irange(kPanel))
+            {
+                acc[r * kPanel + j] += va * w[j];
+            }
+        }
+    }
+#endif
+}
+
+void panel_rows(
+    int64_t rows, const float* a, int64_t lda, const float* panel, int64_t len, float* acc)
+{
+    switch (rows)
+    {
+    case 1:
+        panel_kernel<1>(a, lda, panel, len, acc);
+        break;
+    case 2:
+        panel_kernel<2>(a, lda, panel, len, acc);
+        break;
+    case 3:
+        panel_kernel<3>(a, lda, panel, len, acc);
+        break;
+    default:
+        panel_kernel<kMicroRows>(a, lda, panel, len, acc);
+        break;
+    }
+}
+
+void packed_linear_kernel(
+    int64_t      m,
+    int64_t      n,
+    int64_t      k,
+    const float* a,
+    int64_t      lda,
+    const float* packed,
+    const float* bias,
+    float*       out,
+    int64_t      ldo)
+{
+    const int64_t padded   = packed_linear_weight_numel(n, 1);
+    const int64_t m_blocks = (m + kBlockM - 1) / kBlockM;
+    const int64_t panels   = padded / kPanel;
+
+    // Tile t covers rows [mb * kBlockM, ...) and the columns of panel p,
+    // accumulated over all the input blocks in a kBlockM x kPanel buffer
+    auto run_tiles = [&](int64_t begin, int64_t end)
+    {
+        alignas(64) float acc[kBlockM * kPanel];
+        for (int64_t t = begin; t < end; ++t)
+        {
+            const int64_t p    = t / m_blocks;
+            const int64_t i0   = (t % m_blocks) * kBlockM;
+            const int64_t rows = std::min(kBlockM, m - i0);
+            const int64_t j0   = p * kPanel;
+            const int64_t cols = std::min(kPanel, n - j0);
+
+            for (const auto r : c10::irange(rows))
+            {
+                for (const auto j : c10::irange(kPanel))
+                {
+                    acc[r * kPanel + j] = bias != nullptr && j < cols ? bias[j0 + j] : 0.0f;
+                }
+            }
+            for (int64_t k0 = 0; k0 < k; k0 += kPackedLinearBlockK)
+            {
+                const int64_t len   = std::min(kPackedLinearBlockK, k - k0);
+                const float*  panel = packed + k0 * padded + p * len * kPanel;
+                for (int64_t r = 0; r < rows; r += kMicroRows)
+                {
+                    panel_rows(
+                        std::min<int64_t>(kMicroRows, rows - r),
+                        a + (i0 + r) * lda + k0,
+                        lda,
+                        panel,
+                        len,
+                        acc + r * kPanel);
+                }
+            }
+            for (const auto r : c10::irange(rows))
+            {
+                std::copy_n(acc + r * kPanel, cols, out + (i0 + r) * ldo + j0);
+            }
+        }
+    };
+
+    // Consecutive tiles share their panel
+    const int64_t tiles = m_blocks * panels;
+    if (m * n * k < kParallelMacs || tiles == 1 || parallel_tools::is_parallel_scope())
+    {
+        run_tiles(0, tiles);
+        return;
+    }
+    parallel_tools::parallel_for(
+        0,
+        static_cast<size_t>(tiles),
+        1,
+        [&run_tiles](size_t begin, size_t end)
+        { run_tiles(static_cast<int64_t>(begin), static_cast<int64_t>(end)); });
+}
+}  // namespace
+
+}  // namespace CPU_CAPABILITY
+
+REGISTER_DISPATCH(packed_linear_stub, &packed_linear_kernel)
+
+}  // namespace at::native
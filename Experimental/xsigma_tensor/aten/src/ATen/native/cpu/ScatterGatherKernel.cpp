@@ -0,0 +1,568 @@
+#define TORCH_ASSERT_NO_OPERATORS
+#include <Quarisma/AccumulateType.h>
+#include <Quarisma/Dispatch.h>
+#include <Quarisma/core/Tensor.h>
+#include <Quarisma/cpu/vec/vec.h>
+#include <Quarisma/native/TensorAdvancedIndexing.h>
+#include <Quarisma/native/cpu/ElementwiseLoops.h>
+#include <c10/util/irange.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "parallel/parallel_tools.h"
+
+namespace at::native
+{
+inline namespace CPU_CAPABILITY
+{
+
+namespace
+{
+// Note [CPU gather and scatter_add]
+// gather and scatter_add walk the lines of index along dim: line l is the
+// l-th position of index with dim dropped, and every tensor of the op is
+// addressed with its own strides along that line.
+//
+// gather only reads self, so it splits the elements of all lines evenly
+// across the Core thread pool and prefetches the gathered elements a few
+// iterations ahead.
+//
+// scatter_add is deterministic and free of atomics. The writes of distinct
+// lines never meet, so with enough lines each thread takes whole lines and
+// adds along them in order. With few long lines, the bucketed aggregation of
+// millions of rows into a few thousand buckets, each line is split instead:
+//   - when the line of self is short against the line of index, into at
+//     most kMaxPartials chunks, each summed into a private copy of the line
+//     of self, and the copies are added to self in chunk order;
+//   - otherwise its positions are sorted by destination, stably, and the
+//     runs of one destination are summed in position order.
+// The chunks depend on the sizes only, so results do not change with the
+// number of threads. When index is a vector expanded along the trailing dims
+// of self and src, which all are contiguous, dim 0 scatters whole rows: the
+// rows are sorted by destination and each run is summed with Vectorized adds.
+//
+// An out of range index is not written; the first one found is reported
+// once the parallel region has joined.
+
+// Elements read ahead of the current one when gathering
+constexpr int64_t kPrefetchDistance = 8;
+
+// Partial copies of a line of self when splitting one line
+constexpr int64_t kMaxPartials = 64;
+
+inline void prefetch_read(const void* ptr)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr, 0, 1);
+#else
+    (void)ptr;
+#endif
+}
+
+// Runs body(begin, end) over [0, n) on the Core thread pool, serially below
+// grain or within a parallel region
+template <typename body_t>
+void parallel_range(int64_t n, int64_t grain, const body_t& body)
+{
+    if (n <= grain || parallel_tools::is_parallel_scope())
+    {
+        body(0, n);
+        return;
+    }
+    parallel_tools::parallel_for(
+        0,
+        static_cast<size_t>(n),
+        static_cast<size_t>(std::max<int64_t>(grain, 1)),
+        [&body](size_t begin, size_t end)
+        { body(static_cast<int64_t>(begin), static_cast<int64_t>(end)); });
+}
+
+// The first out of range index seen by any thread
+class BadIndex
+{
+public:
+    void record(int64_t index)
+    {
+        bool expected = false;
+        if (seen_.compare_exchange_strong(expected, true))
+        {
+            index_ = index;
+        }
+    }
+
+    void check(const char* method_name, int64_t dim, int64_t dim_size) const
+    {
+        TORCH_CHECK_INDEX(
+            !seen_.load(),
+            method_name,
+            "(): index ",
+            index_,
+            " is out of bounds for dimension ",
+            dim,
+            " with size ",
+            dim_size);
+    }
+
+private:
+    std::atomic<bool> seen_{false};
+    int64_t           index_ = 0;
+};
+
+// The lines of index along dim, see Note [CPU gather and scatter_add], for N
+// tensors addressed at the positions of index
+template <size_t N>
+class DimLines
+{
+public:
+    DimLines(const Tensor& index, int64_t dim, const std::array<const Tensor*, N>& tensors)
+    {
+        length_ = index.dim() == 0 ? 1 : index.size(dim);
+        count_  = length_ == 0 ? 0 : index.numel() / length_;
+        for (const auto t : c10::irange(N))
+        {
+            dim_strides_[t] = tensors[t]->dim() == 0 ? 0 : tensors[t]->stride(dim);
+        }
+        for (const auto d : c10::irange(index.dim()))
+        {
+            if (d == dim)
+            {
+                continue;
+            }
+            sizes_.push_back(index.size(d));
+            for (const auto t : c10::irange(N))
+            {
+                strides_[t].push_back(tensors[t]->stride(d));
+            }
+        }
+    }
+
+    int64_t count() const { return count_; }
+    int64_t length() const { return length_; }
+    int64_t dim_stride(size_t t) const { return dim_strides_[t]; }
+
+    // Element offsets of the start of line in each tensor
+    std::array<int64_t, N> offsets(int64_t line) const
+    {
+        std::array<int64_t, N> result{};
+        for (int64_t d = static_cast<int64_t>(sizes_.size()) - 1; d >= 0; --d)
+        {
+            const int64_t i = line % sizes_[d];
+            line /= sizes_[d];
+            for (const auto t : c10::irange(N))
+            {
+                result[t] += i * strides_[t][d];
+            }
+        }
+        return result;
+    }
+
+private:
+    int64_t                             count_  = 0;
+    int64_t                             length_ = 0;
+    std::vector<int64_t>                sizes_;
+    std::array<std::vector<int64_t>, N> strides_;
+    std::array<int64_t, N>              dim_strides_{};
+};
+
+// The positions [0, n) of a line ordered by destination, stably
+std::vector<int64_t> sort_by_destination(
+    const int64_t* index, int64_t index_stride, int64_t n, int64_t dim_size)
+{
+    std::vector<int64_t> order(n);
+    if (dim_size <= 4 * n)
+    {
+        // Counting sort; out of range indices go last and are skipped later
+        std::vector<int64_t> starts(dim_size + 2, 0);
+        for (const auto j : c10::irange(n))
+        {
+            const int64_t d = index[j * index_stride];
+            starts[(d >= 0 && d < dim_size ? d : dim_size) + 1]++;
+        }
+        for (const auto d : c10::irange(dim_size + 1))
+        {
+            starts[d + 1] += starts[d];
+        }
+        for (const auto j : c10::irange(n))
+        {
+            const int64_t d = index[j * index_stride];
+            order[starts[d >= 0 && d < dim_size ? d : dim_size]++] = j;
+        }
+        return order;
+    }
+    for (const auto j : c10::irange(n))
+    {
+        order[j] = j;
+    }
+    std::stable_sort(
+        order.begin(),
+        order.end(),
+        [index, index_stride](int64_t a, int64_t b)
+        { return index[a * index_stride] < index[b * index_stride]; });
+    return order;
+}
+
+// Runs body(first, last) over the runs of one destination of order, in
+// parallel; every run lies in one call
+template <typename body_t>
+void for_each_run(
+    const std::vector<int64_t>& order,
+    const int64_t*              index,
+    int64_t                     index_stride,
+    int64_t                     grain,
+    const body_t&               body)
+{
+    const int64_t n         = static_cast<int64_t>(order.size());
+    auto          run_start = [&](int64_t k)
+    {
+        while (k > 0 && k < n &&
+               index[order[k] * index_stride] == index[order[k - 1] * index_stride])
+        {
+            ++k;
+        }
+        return k;
+    };
+    parallel_range(
+        n,
+        grain,
+        [&](int64_t begin, int64_t end)
+        {
+            const int64_t first = run_start(begin);
+            const int64_t last  = run_start(end);
+            if (first < last)
+            {
+                body(first, last);
+            }
+        });
+}
+
+template <typename scalar_t>
+void scatter_add_line_sorted(
+    scalar_t*       self_line,
+    int64_t         self_stride,
+    int64_t         dim_size,
+    const int64_t*  index,
+    int64_t         index_stride,
+    const scalar_t* src,
+    int64_t         src_stride,
+    int64_t         n,
+    BadIndex&       bad)
+{
+    using acc_t                      = at::acc_type<scalar_t, false>;
+    const std::vector<int64_t> order = sort_by_destination(index, index_stride, n, dim_size);
+    for_each_run(
+        order,
+        index,
+        index_stride,
+        at::internal::GRAIN_SIZE,
+        [&](int64_t first, int64_t last)
+        {
+            int64_t k = first;
+            while (k < last)
+            {
+                const int64_t d   = index[order[k] * index_stride];
+                acc_t         acc = acc_t(0);
+                for (; k < last && index[order[k] * index_stride] == d; ++k)
+                {
+                    acc += static_cast<acc_t>(src[order[k] * src_stride]);
+                }
+                if (d < 0 || d >= dim_size)
+                {
+                    bad.record(d);
+                    continue;
+                }
+                scalar_t& out = self_line[d * self_stride];
+                out           = static_cast<scalar_t>(static_cast<acc_t>(out) + acc);
+            }
+        });
+}
+
+template <typename scalar_t>
+void scatter_add_line_partials(
+    scalar_t*       self_line,
+    int64_t         self_stride,
+    int64_t         dim_size,
+    const int64_t*  index,
+    int64_t         index_stride,
+    const scalar_t* src,
+    int64_t         src_stride,
+    int64_t         n,
+    int64_t         nchunks,
+    BadIndex&       bad)
+{
+    using acc_t                = at::acc_type<scalar_t, false>;
+    const int64_t      chunk   = (n + nchunks - 1) / nchunks;
+    std::vector<acc_t> partial(nchunks * dim_size, acc_t(0));
+    parallel_range(
+        nchunks,
+        1,
+        [&](int64_t begin, int64_t end)
+        {
+            for (const auto c : c10::irange(begin, end))
+            {
+                acc_t* sums = partial.data() + c * dim_size;
+                for (const auto j : c10::irange(c * chunk, std::min(n, (c + 1) * chunk)))
+                {
+                    const int64_t d = index[j * index_stride];
+                    if (d < 0 || d >= dim_size)
+                    {
+                        bad.record(d);
+                        continue;
+                    }
+                    sums[d] += static_cast<acc_t>(src[j * src_stride]);
+                }
+            }
+        });
+    parallel_range(
+        dim_size,
+        at::internal::GRAIN_SIZE / nchunks,
+        [&](int64_t begin, int64_t end)
+        {
+            for (const auto d : c10::irange(begin, end))
+            {
+                acc_t acc = static_cast<acc_t>(self_line[d * self_stride]);
+                for (const auto c : c10::irange(nchunks))
+                {
+                    acc += partial[c * dim_size + d];
+                }
+                self_line[d * self_stride] = static_cast<scalar_t>(acc);
+            }
+        });
+}
+
+// Whether scatter_add along dim 0 moves whole contiguous rows, see
+// Note [CPU gather and scatter_add]
+bool is_row_scatter(const Tensor& self, int64_t dim, const Tensor& index, const Tensor& src)
+{
+    if (dim != 0 || self.dim() < 2 || !self.is_contiguous() || !src.is_contiguous())
+    {
+        return false;
+    }
+    for (const auto d : c10::irange(1, index.dim()))
+    {
+        if (index.stride(d) != 0 || index.size(d) != self.size(d) ||
+            index.size(d) != src.size(d))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename scalar_t>
+void scatter_add_rows(
+    const Tensor& self, const Tensor& index, const Tensor& src, BadIndex& bad)
+{
+    using Vec                  = Vectorized<scalar_t>;
+    const int64_t   n          = index.size(0);
+    const int64_t   dim_size   = self.size(0);
+    const int64_t   row        = self.numel() / std::max<int64_t>(dim_size, 1);
+    const int64_t   src_row    = src.stride(0);
+    const int64_t*  index_data = index.const_data_ptr<int64_t>();
+    const int64_t   idx_stride = index.stride(0);
+    const scalar_t* src_data   = src.const_data_ptr<scalar_t>();
+    scalar_t*       self_data  = self.mutable_data_ptr<scalar_t>();
+
+    const std::vector<int64_t> order = sort_by_destination(index_data, idx_stride, n, dim_size);
+    for_each_run(
+        order,
+        index_data,
+        idx_stride,
+        std::max<int64_t>(at::internal::GRAIN_SIZE / std::max<int64_t>(row, 1), 1),
+        [&](int64_t first, int64_t last)
+        {
+            for (const auto k : c10::irange(first, last))
+            {
+                const int64_t d = index_data[order[k] * idx_stride];
+                if (d < 0 || d >= dim_size)
+                {
+                    bad.record(d);
+                    continue;
+                }
+                // Rows of one destination follow each other within the range
+                scalar_t*       out = self_data + d * row;
+                const scalar_t* in  = src_data + order[k] * src_row;
+                int64_t         i   = 0;
+                for (; i + Vec::size() <= row; i += Vec::size())
+                {
+                    (Vec::loadu(out + i) + Vec::loadu(in + i)).store(out + i);
+                }
+                for (; i < row; ++i)
+                {
+                    out[i] += in[i];
+                }
+            }
+        });
+}
+
+void scatter_add_kernel(const Tensor& self, int64_t dim, const Tensor& index, const Tensor& src)
+{
+    const int64_t dim_size = self.dim() == 0 ? 1 : self.size(dim);
+    BadIndex      bad;
+
+    AT_DISPATCH_ALL_TYPES_AND_COMPLEX_AND3(
+        ScalarType::Bool,
+        ScalarType::Half,
+        ScalarType::BFloat16,
+        self.scalar_type(),
+        "scatter_add_cpu",
+        [&]
+        {
+            using acc_t = at::acc_type<scalar_t, false>;
+            if constexpr (std::is_same_v<acc_t, scalar_t> && !std::is_same_v<scalar_t, bool>)
+            {
+                if (is_row_scatter(self, dim, index, src))
+                {
+                    scatter_add_rows<scalar_t>(self, index, src, bad);
+                    return;
+                }
+            }
+
+            const DimLines<3> lines(index, dim, {&self, &index, &src});
+            const int64_t     n          = lines.length();
+            const int64_t     threads    = parallel_tools::estimated_number_of_threads();
+            scalar_t*         self_data  = self.mutable_data_ptr<scalar_t>();
+            const int64_t*    index_data = index.const_data_ptr<int64_t>();
+            const scalar_t*   src_data   = src.const_data_ptr<scalar_t>();
+
+            if (lines.count() >= threads || n < at::internal::GRAIN_SIZE)
+            {
+                // Whole lines per thread, added along in order
+                parallel_range(
+                    lines.count(),
+                    std::max<int64_t>(at::internal::GRAIN_SIZE / std::max<int64_t>(n, 1), 1),
+                    [&](int64_t begin, int64_t end)
+                    {
+                        for (const auto l : c10::irange(begin, end))
+                        {
+                            const auto      off = lines.offsets(l);
+                            scalar_t*       out = self_data + off[0];
+                            const int64_t*  idx = index_data + off[1];
+                            const scalar_t* in  = src_data + off[2];
+                            for (const auto j : c10::irange(n))
+                            {
+                                const int64_t d = idx[j * lines.dim_stride(1)];
+                                if (d < 0 || d >= dim_size)
+                                {
+                                    bad.record(d);
+                                    continue;
+                                }
+                                out[d * lines.dim_stride(0)] += in[j * lines.dim_stride(2)];
+                            }
+                        }
+                    });
+                return;
+            }
+
+            // Few long lines: split each, see Note [CPU gather and scatter_add]
+            const int64_t nchunks = std::min<int64_t>(
+                kMaxPartials, (n + at::internal::GRAIN_SIZE - 1) / at::internal::GRAIN_SIZE);
+            for (const auto l : c10::irange(lines.count()))
+            {
+                const auto off = lines.offsets(l);
+                if (dim_size * nchunks <= n)
+                {
+                    scatter_add_line_partials<scalar_t>(
+                        self_data + off[0],
+                        lines.dim_stride(0),
+                        dim_size,
+                        index_data + off[1],
+                        lines.dim_stride(1),
+                        src_data + off[2],
+                        lines.dim_stride(2),
+                        n,
+                        nchunks,
+                        bad);
+                }
+                else
+                {
+                    scatter_add_line_sorted<scalar_t>(
+                        self_data + off[0],
+                        lines.dim_stride(0),
+                        dim_size,
+                        index_data + off[1],
+                        lines.dim_stride(1),
+                        src_data + off[2],
+                        lines.dim_stride(2),
+                        n,
+                        bad);
+                }
+            }
+        });
+    bad.check("scatter_add", dim, dim_size);
+}
+
+void gather_kernel(const Tensor& result, const Tensor& self, int64_t dim, const Tensor& index)
+{
+    const int64_t dim_size = self.dim() == 0 ? 1 : self.size(dim);
+    BadIndex      bad;
+
+    AT_DISPATCH_ALL_TYPES_AND_COMPLEX_AND3(
+        ScalarType::Bool,
+        ScalarType::Half,
+        ScalarType::BFloat16,
+        self.scalar_type(),
+        "gather_cpu",
+        [&]
+        {
+            const DimLines<3> lines(index, dim, {&result, &self, &index});
+            const int64_t     n            = lines.length();
+            const int64_t     out_stride   = lines.dim_stride(0);
+            const int64_t     self_stride  = lines.dim_stride(1);
+            const int64_t     index_stride = lines.dim_stride(2);
+            scalar_t*         result_data  = result.mutable_data_ptr<scalar_t>();
+            const scalar_t*   self_data    = self.const_data_ptr<scalar_t>();
+            const int64_t*    index_data   = index.const_data_ptr<int64_t>();
+
+            // Elements of all lines, split evenly whatever the line count
+            parallel_range(
+                lines.count() * n,
+                at::internal::GRAIN_SIZE,
+                [&](int64_t begin, int64_t end)
+                {
+                    int64_t l = begin / n;
+                    int64_t j = begin % n;
+                    for (int64_t k = begin; k < end; ++l, j = 0)
+                    {
+                        const auto      off  = lines.offsets(l);
+                        scalar_t*       out  = result_data + off[0];
+                        const scalar_t* in   = self_data + off[1];
+                        const int64_t*  idx  = index_data + off[2];
+                        const int64_t   stop = std::min(n, j + end - k);
+                        k += stop - j;
+                        for (; j < stop; ++j)
+                        {
+                            if (j + kPrefetchDistance < stop)
+                            {
+                                const int64_t next = idx[(j + kPrefetchDistance) * index_stride];
+                                if (next >= 0 && next < dim_size)
+                                {
+                                    prefetch_read(in + next * self_stride);
+                                }
+                            }
+                            const int64_t d = idx[j * index_stride];
+                            if (d < 0 || d >= dim_size)
+                            {
+                                bad.record(d);
+                                continue;
+                            }
+                            out[j * out_stride] = in[d * self_stride];
+                        }
+                    }
+                });
+        });
+    bad.check("gather", dim, dim_size);
+}
+}  // namespace
+
+}  // namespace CPU_CAPABILITY
+
+REGISTER_DISPATCH(gather_stub, &gather_kernel)
+REGISTER_DISPATCH(scatter_add_stub, &scatter_add_kernel)
+
+}  // namespace at::native
@@ -0,0 +1,324 @@
+#define TORCH_ASSERT_NO_OPERATORS
+#include <Quarisma/Dispatch.h>
+#include <Quarisma/NumericUtils.h>
+#include <Quarisma/core/Tensor.h>
+#include <Quarisma/cpu/vec/functional.h>
+#include <Quarisma/cpu/vec/vec.h>
+#include <Quarisma/native/cpu/ElementwiseLoops.h>
+#include <Quarisma/native/nested/NestedTensorSegmented.h>
+#include <c10/util/irange.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "math/sparse_csr.h"
+#include "parallel/parallel_tools.h"
+
+namespace at::native
+{
+inline namespace CPU_CAPABILITY
+{
+
+namespace
+{
+// Segments per thread, so that a long segment late in a range does not leave
+// the other threads idle
+constexpr size_t kRangesPerThread = 4;
+
+template <typename scalar_t>
+scalar_t propagate_nan_max(scalar_t a, scalar_t b)
+{
+    return (_isnan<scalar_t>(a) || a > b) ? a : b;
+}
+
+template <typename scalar_t>
+scalar_t propagate_nan_min(scalar_t a, scalar_t b)
+{
+    return (_isnan<scalar_t>(a) || a < b) ? a : b;
+}
+
+// Runs body(first, last) over the segments [0, nsegments) in ranges of about
+// equal rows, serially for small buffers or within a parallel region. The
+// work of a segment is its rows plus one, as the work of a CSR row in
+// csr_partition() is its nonzeros plus one.
+template <typename body_t>
+void for_each_segment_range(
+    const int64_t* offsets, int64_t nsegments, int64_t inner, int64_t cost, const body_t& body)
+{
+    const int64_t numel = offsets[nsegments] * inner;
+    if (nsegments <= 1 || numel < elementwise_grain_size(cost) ||
+        parallel_tools::is_parallel_scope())
+    {
+        body(0, nsegments);
+        return;
+    }
+
+    quarisma::linalg::csr_view segments;
+    segments.rows        = static_cast<size_t>(nsegments);
+    segments.row_offsets = offsets;
+    const std::vector<size_t> bounds = quarisma::linalg::csr_partition(
+        segments,
+        static_cast<size_t>(parallel_tools::estimated_number_of_threads()) * kRangesPerThread);
+    parallel_tools::parallel_for(
+        0,
+        bounds.size() - 1,
+        1,
+        [&bounds, &body](size_t begin, size_t end)
+        {
+            for (size_t r = begin; r < end; ++r)
+            {
+                body(static_cast<int64_t>(bounds[r]), static_cast<int64_t>(bounds[r + 1]));
+            }
+        });
+}
+
+// Row s of out = the rows of segment s of values folded with op from identity
+template <typename scalar_t, typename op_t>
+void segment_reduce_rows(
+    const Tensor&  values,
+    const int64_t* offsets,
+    int64_t        nsegments,
+    const Tensor&  out,
+    scalar_t       identity,
+    const op_t&    op)
+{
+    const int64_t   inner     = values.size(1);
+    const scalar_t* in_data   = values.const_data_ptr<scalar_t>();
+    scalar_t*       out_data  = out.mutable_data_ptr<scalar_t>();
+    const int64_t   elem_size = sizeof(scalar_t);
+
+    for_each_segment_range(
+        offsets,
+        nsegments,
+        inner,
+        1,
+        [&](int64_t first, int64_t last)
+        {
+            for (const auto s : c10::irange(first, last))
+            {
+                scalar_t* acc = out_data + s * inner;
+                if (inner == 1)
+                {
+                    // One column: the segment is a contiguous run of its rows
+                    *acc = reduce_row(
+                        identity,
+                        reinterpret_cast<const char*>(in_data + offsets[s]),
+                        elem_size,
+                        offsets[s + 1] - offsets[s],
+                        op);
+                    continue;
+                }
+
+                std::fill_n(acc, inner, identity);
+                const int64_t strides[] = {elem_size, elem_size, elem_size};
+                for (const auto row : c10::irange(offsets[s], offsets[s + 1]))
+                {
+                    char* const data[] = {
+                        reinterpret_cast<char*>(acc),
+                        reinterpret_cast<char*>(acc),
+                        reinterpret_cast<char*>(const_cast<scalar_t*>(in_data + row * inner))};
+                    vectorized_row<scalar_t>(
+                        data, strides, inner, op, std::make_index_sequence<2>{});
+                }
+            }
+        });
+}
+
+// The rows of segment s of out = op(the rows of segment s of values, row s
+// of other), other having one column broadcast along the row or inner ones
+template <typename scalar_t, typename op_t>
+void segment_broadcast_rows(
+    const Tensor&  values,
+    const int64_t* offsets,
+    int64_t        nsegments,
+    const Tensor&  other,
+    const Tensor&  out,
+    const op_t&    op,
+    int64_t        cost)
+{
+    const int64_t   inner       = values.size(1);
+    const int64_t   other_inner = other.size(1);
+    const scalar_t* in_data     = values.const_data_ptr<scalar_t>();
+    const scalar_t* other_data  = other.const_data_ptr<scalar_t>();
+    scalar_t*       out_data    = out.mutable_data_ptr<scalar_t>();
+    const int64_t   elem_size   = sizeof(scalar_t);
+    const int64_t   strides[]   = {elem_size, elem_size, other_inner == 1 ? 0 : elem_size};
+
+    for_each_segment_range(
+        offsets,
+        nsegments,
+        inner,
+        cost,
+        [&](int64_t first, int64_t last)
+        {
+            for (const auto s : c10::irange(first, last))
+            {
+                char* const other_row =
+                    reinterpret_cast<char*>(const_cast<scalar_t*>(other_data + s * other_inner));
+                for (const auto row : c10::irange(offsets[s], offsets[s + 1]))
+                {
+                    char* const data[] = {
+                        reinterpret_cast<char*>(out_data + row * inner),
+                        reinterpret_cast<char*>(const_cast<scalar_t*>(in_data + row * inner)),
+                        other_row};
+                    vectorized_row<scalar_t>(
+                        data, strides, inner, op, std::make_index_sequence<2>{});
+                }
+            }
+        });
+}
+
+void segment_reduce_kernel(
+    const Tensor&  values,
+    const int64_t* offsets,
+    int64_t        nsegments,
+    ReduceOpKind   op,
+    const Tensor&  out)
+{
+    AT_DISPATCH_ALL_TYPES(
+        values.scalar_type(),
+        "segment_reduce",
+        [&]
+        {
+            using Vec    = Vectorized<scalar_t>;
+            using limits = std::numeric_limits<scalar_t>;
+            switch (op)
+            {
+            case ReduceOpKind::Sum:
+                segment_reduce_rows<scalar_t>(
+                    values,
+                    offsets,
+                    nsegments,
+                    out,
+                    scalar_t(0),
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a + b); },
+                        [](Vec a, Vec b) { return a + b; }));
+                break;
+            case ReduceOpKind::Prod:
+                segment_reduce_rows<scalar_t>(
+                    values,
+                    offsets,
+                    nsegments,
+                    out,
+                    scalar_t(1),
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a * b); },
+                        [](Vec a, Vec b) { return a * b; }));
+                break;
+            case ReduceOpKind::Max:
+                segment_reduce_rows<scalar_t>(
+                    values,
+                    offsets,
+                    nsegments,
+                    out,
+                    limits::has_infinity ? -limits::infinity() : limits::lowest(),
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return propagate_nan_max(a, b); },
+                        [](Vec a, Vec b) { return vec::maximum(a, b); }));
+                break;
+            case ReduceOpKind::Min:
+                segment_reduce_rows<scalar_t>(
+                    values,
+                    offsets,
+                    nsegments,
+                    out,
+                    limits::has_infinity ? limits::infinity() : limits::max(),
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return propagate_nan_min(a, b); },
+                        [](Vec a, Vec b) { return vec::minimum(a, b); }));
+                break;
+            default:
+                TORCH_INTERNAL_ASSERT(false, "Unexpected reduce op");
+            }
+        });
+}
+
+void segment_broadcast_kernel(
+    const Tensor&      values,
+    const int64_t*     offsets,
+    int64_t            nsegments,
+    const Tensor&      other,
+    BinaryOpKind       op,
+    const c10::Scalar& alpha_scalar,
+    const Tensor&      out)
+{
+    if (op == BinaryOpKind::Div)
+    {
+        AT_DISPATCH_FLOATING_TYPES(
+            values.scalar_type(),
+            "segment_broadcast",
+            [&]
+            {
+                using Vec = Vectorized<scalar_t>;
+                segment_broadcast_rows<scalar_t>(
+                    values,
+                    offsets,
+                    nsegments,
+                    other,
+                    out,
+                    make_vec_op(
+                        [](scalar_t a, scalar_t b) { return a / b; },
+                        [](Vec a, Vec b) { return a / b; }),
+                    2);
+            });
+        return;
+    }
+
+    AT_DISPATCH_ALL_TYPES(
+        values.scalar_type(),
+        "segment_broadcast",
+        [&]
+        {
+            using Vec              = Vectorized<scalar_t>;
+            const scalar_t alpha   = alpha_scalar.to<scalar_t>();
+            const Vec      alpha_v = Vec(alpha);
+            auto           run     = [&](const auto& vec_op)
+            {
+                segment_broadcast_rows<scalar_t>(
+                    values, offsets, nsegments, other, out, vec_op, 1);
+            };
+            switch (op)
+            {
+            case BinaryOpKind::Add:
+                run(make_vec_op(
+                    [=](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a + alpha * b); },
+                    [=](Vec a, Vec b) { return vec::fmadd(b, alpha_v, a); }));
+                break;
+            case BinaryOpKind::Sub:
+                run(make_vec_op(
+                    [=](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a - alpha * b); },
+                    [=](Vec a, Vec b) { return a - b * alpha_v; }));
+                break;
+            case BinaryOpKind::Mul:
+                run(make_vec_op(
+                    [](scalar_t a, scalar_t b) { return static_cast<scalar_t>(a * b); },
+                    [](Vec a, Vec b) { return a * b; }));
+                break;
+            case BinaryOpKind::Maximum:
+                run(make_vec_op(
+                    [](scalar_t a, scalar_t b) { return propagate_nan_max(a, b); },
+                    [](Vec a, Vec b) { return vec::maximum(a, b); }));
+                break;
+            case BinaryOpKind::Minimum:
+                run(make_vec_op(
+                    [](scalar_t a, scalar_t b) { return propagate_nan_min(a, b); },
+                    [](Vec a, Vec b) { return vec::minimum(a, b); }));
+                break;
+            default:
+                TORCH_INTERNAL_ASSERT(false, "Unexpected binary op");
+            }
+        });
+}
+}  // namespace
+
+}  // namespace CPU_CAPABILITY
+
+REGISTER_DISPATCH(segment_reduce_stub, &segment_reduce_kernel)
+REGISTER_DISPATCH(segment_broadcast_stub, &segment_broadcast_kernel)
+
+}  // namespace at::native
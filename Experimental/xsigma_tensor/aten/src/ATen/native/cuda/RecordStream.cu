@@ -1,6 +1,6 @@
 #define TORCH_ASSERT_ONLY_METHOD_OPERATORS
 #include <Quarisma/core/Tensor.h>
-#include <c10/cuda/CUDACachingAllocator.h>
+#include <Quarisma/cuda/CoreCUDAAllocator.h>
 
 #ifndef AT_PER_OPERATOR_HEADERS
 #include <Quarisma/NativeFunctions.h>
@@ -9,8 +9,9 @@
 #endif
 
 namespace at::native {
+// Device tensors and pinned CPU tensors are both recorded with the Core
+// allocator that owns their storage, see Note [Core CUDA allocators]
 void record_stream_cuda(Tensor& self, c10::Stream stream) {
-  struct c10::StreamData3 data = stream.pack3();
-  c10::cuda::CUDACachingAllocator::recordStream(self.storage().data_ptr(), at::cuda::CUDAStream::unpack3(data.stream_id, data.device_index, data.device_type));
+  at::cuda::recordStream(self.storage().data_ptr(), stream);
 }
 }  // namespace at::native
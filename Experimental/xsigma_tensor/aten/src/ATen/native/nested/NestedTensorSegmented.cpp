@@ -0,0 +1,217 @@
+#define TORCH_ASSERT_ONLY_METHOD_OPERATORS
+#include <Quarisma/NestedTensorImpl.h>
+#include <Quarisma/core/Tensor.h>
+#include <Quarisma/native/nested/NestedTensorSegmented.h>
+#include <c10/util/accumulate.h>
+#include <c10/util/irange.h>
+
+#ifndef AT_PER_OPERATOR_HEADERS
+#include <Quarisma/Functions.h>
+#else
+#include <Quarisma/ops/empty.h>
+#include <Quarisma/ops/empty_like.h>
+#endif
+
+#include <vector>
+
+namespace at::native
+{
+
+DEFINE_DISPATCH(segment_reduce_stub);
+DEFINE_DISPATCH(segment_broadcast_stub);
+
+namespace
+{
+// values as (rows, inner), contiguous
+Tensor as_rows(const Tensor& values)
+{
+    TORCH_CHECK(values.dim() >= 1, "segmented ops expect values of at least one dim");
+    const int64_t inner = c10::multiply_integers(values.sizes().slice(1));
+    return values.contiguous().view({values.size(0), inner});
+}
+
+void check_offsets(const Tensor& offsets, int64_t rows)
+{
+    TORCH_CHECK(
+        offsets.scalar_type() == kLong && offsets.dim() == 1 && offsets.numel() >= 1 &&
+            offsets.is_contiguous(),
+        "segmented ops expect contiguous int64 offsets of one dim, got ",
+        offsets.scalar_type(),
+        " of ",
+        offsets.dim(),
+        " dims");
+    const int64_t* data = offsets.const_data_ptr<int64_t>();
+    const int64_t  n    = offsets.numel();
+    TORCH_CHECK(
+        data[0] == 0 && data[n - 1] == rows,
+        "segment offsets must run from 0 to the ",
+        rows,
+        " rows of the values, got ",
+        data[0],
+        " to ",
+        data[n - 1]);
+    for (const auto s : c10::irange(1, n))
+    {
+        TORCH_CHECK(data[s - 1] <= data[s], "segment offsets must not decrease");
+    }
+}
+
+// The buffer of the contiguous nested tensor self, without the storage past
+// its elements
+Tensor packed_buffer(const Tensor& self)
+{
+    const Tensor contiguous = self.is_contiguous() ? self : self.contiguous();
+    return get_nested_tensor_impl(contiguous)->get_buffer().narrow(0, 0, contiguous.numel());
+}
+
+Tensor wrap_buffer(Tensor buffer, const Tensor& nested_sizes)
+{
+    return at::detail::make_tensor<NestedTensorImpl>(std::move(buffer), nested_sizes.clone());
+}
+
+// The shape shared by the components of self past their first dim
+std::vector<int64_t> regular_rest(const Tensor& self)
+{
+    const Tensor& sizes = get_nested_sizes(self);
+    const int64_t n     = sizes.size(0);
+    const int64_t dim   = sizes.dim() == 2 ? sizes.size(1) : 0;
+    TORCH_CHECK(dim >= 1, "nested segmented ops expect components of at least one dim");
+
+    const int64_t*       data = sizes.const_data_ptr<int64_t>();
+    std::vector<int64_t> rest(data + 1, data + dim);
+    for (const auto i : c10::irange(1, n))
+    {
+        for (const auto d : c10::irange(1, dim))
+        {
+            TORCH_CHECK(
+                data[i * dim + d] == rest[d - 1],
+                "nested segmented ops expect components that differ in their first dim only, "
+                "component ",
+                i,
+                " differs in dim ",
+                d);
+        }
+    }
+    return rest;
+}
+}  // namespace
+
+Tensor segment_reduce(ReduceOpKind op, const Tensor& values, const Tensor& offsets)
+{
+    const Tensor rows = as_rows(values);
+    check_offsets(offsets, rows.size(0));
+    const int64_t nsegments = offsets.numel() - 1;
+
+    std::vector<int64_t> shape(values.sizes().begin(), values.sizes().end());
+    shape[0]   = nsegments;
+    Tensor out = at::empty({nsegments, rows.size(1)}, values.options());
+    if (out.numel() > 0)
+    {
+        segment_reduce_stub(
+            values.device().type(), rows, offsets.const_data_ptr<int64_t>(), nsegments, op, out);
+    }
+    return out.view(shape);
+}
+
+Tensor segment_broadcast(
+    BinaryOpKind       op,
+    const Tensor&      values,
+    const Tensor&      offsets,
+    const Tensor&      other,
+    const c10::Scalar& alpha)
+{
+    TORCH_CHECK(
+        op != BinaryOpKind::Div || at::isFloatingType(values.scalar_type()),
+        "segment_broadcast: division expects floating point values");
+    TORCH_CHECK(
+        values.scalar_type() == other.scalar_type(),
+        "segment_broadcast: expected values and other of one dtype, got ",
+        values.scalar_type(),
+        " and ",
+        other.scalar_type());
+
+    const Tensor rows = as_rows(values);
+    check_offsets(offsets, rows.size(0));
+    const int64_t nsegments = offsets.numel() - 1;
+    TORCH_CHECK(
+        other.dim() >= 1 && other.size(0) == nsegments &&
+            (other.numel() == nsegments || other.numel() == nsegments * rows.size(1)),
+        "segment_broadcast: expected other of shape (",
+        nsegments,
+        ", *rest) or (",
+        nsegments,
+        "), got ",
+        other.sizes());
+
+    const Tensor per_segment =
+        other.contiguous().view({nsegments, other.numel() == nsegments ? 1 : rows.size(1)});
+    Tensor       out         = at::empty_like(rows);
+    if (out.numel() > 0)
+    {
+        segment_broadcast_stub(
+            values.device().type(),
+            rows,
+            offsets.const_data_ptr<int64_t>(),
+            nsegments,
+            per_segment,
+            op,
+            alpha,
+            out);
+    }
+    return out.view(values.sizes());
+}
+
+Tensor nested_segment_offsets(const Tensor& self)
+{
+    const Tensor& sizes = get_nested_sizes(self);
+    const int64_t n     = sizes.size(0);
+    const int64_t dim   = sizes.dim() == 2 ? sizes.size(1) : 0;
+    TORCH_CHECK(dim >= 1, "nested_segment_offsets expects components of at least one dim");
+
+    Tensor         offsets = at::empty({n + 1}, sizes.options());
+    int64_t*       data    = offsets.mutable_data_ptr<int64_t>();
+    const int64_t* rows    = sizes.const_data_ptr<int64_t>();
+
+    data[0] = 0;
+    for (const auto i : c10::irange(n))
+    {
+        data[i + 1] = data[i] + rows[i * dim];
+    }
+    return offsets;
+}
+
+Tensor nested_unary(UnaryOpKind op, const Tensor& self)
+{
+    const Tensor buffer = packed_buffer(self);
+    return wrap_buffer(elementwise_unary(op, buffer), get_nested_sizes(self));
+}
+
+Tensor nested_binary(
+    BinaryOpKind op, const Tensor& self, const Tensor& other, const c10::Scalar& alpha)
+{
+    const Tensor buffer = packed_buffer(self);
+    if (other.is_nested())
+    {
+        TORCH_CHECK(
+            get_nested_sizes(self).equal(get_nested_sizes(other)),
+            "nested_binary: expected nested tensors of the same nested sizes");
+        return wrap_buffer(
+            elementwise_binary(op, buffer, packed_buffer(other), alpha), get_nested_sizes(self));
+    }
+
+    std::vector<int64_t> rest = regular_rest(self);
+    rest.insert(rest.begin(), -1);
+    const Tensor offsets = nested_segment_offsets(self);
+    const Tensor out =
+        segment_broadcast(op, buffer.view(rest), offsets, other.to(self.scalar_type()), alpha);
+    return wrap_buffer(out.reshape({-1}), get_nested_sizes(self));
+}
+
+Tensor nested_reduce(ReduceOpKind op, const Tensor& self)
+{
+    std::vector<int64_t> rest = regular_rest(self);
+    rest.insert(rest.begin(), -1);
+    return segment_reduce(op, packed_buffer(self).view(rest), nested_segment_offsets(self));
+}
+
+}  // namespace at::native
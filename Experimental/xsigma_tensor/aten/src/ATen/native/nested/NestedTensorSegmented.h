@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Quarisma/native/DispatchStub.h>
+#include <Quarisma/native/Elementwise.h>
+#include <c10/core/Scalar.h>
+
+#include <cstdint>
+
+namespace at
+{
+class Tensor;
+}  // namespace at
+
+namespace at::native
+{
+
+// Fused kernels on the packed buffer of a nested tensor.
+//
+// A contiguous nested tensor of components of shapes (L_i, *rest) is a packed
+// (sum_i L_i, *rest) buffer and the offsets of its segments: component i is
+// the rows [offsets[i], offsets[i + 1]) of the buffer. Elementwise ops run on
+// the buffer directly, and the segmented primitives below fold or broadcast
+// per segment, so no component is padded to the longest one.
+//
+// The segmented kernels take a (rows, inner) buffer, *rest flattened into
+// inner, and nsegments + 1 offsets from 0 to rows. Segments are split across
+// the Core thread pool in ranges of about equal rows, and the rows of a
+// segment run the vectorized loops of native/cpu/ElementwiseLoops.h.
+
+// out (nsegments, inner) = the rows of each segment of values folded with op;
+// empty segments give the identity of op
+using segment_reduce_fn = void (*)(
+    const Tensor&  values,
+    const int64_t* offsets,
+    int64_t        nsegments,
+    ReduceOpKind   op,
+    const Tensor&  out);
+
+// out (rows, inner) = op(values, other[s]) on the rows of segment s, other
+// being (nsegments, inner) or (nsegments, 1)
+using segment_broadcast_fn = void (*)(
+    const Tensor&      values,
+    const int64_t*     offsets,
+    int64_t            nsegments,
+    const Tensor&      other,
+    BinaryOpKind       op,
+    const c10::Scalar& alpha,
+    const Tensor&      out);
+
+DECLARE_DISPATCH(segment_reduce_fn, segment_reduce_stub)
+DECLARE_DISPATCH(segment_broadcast_fn, segment_broadcast_stub)
+
+// Folds the rows [offsets[s], offsets[s + 1]) of values (rows, *rest) into
+// row s of the (nsegments, *rest) result; offsets is int64 (nsegments + 1)
+TORCH_API Tensor segment_reduce(ReduceOpKind op, const Tensor& values, const Tensor& offsets);
+
+// op(values, other[s]) on the rows of segment s: values is (rows, *rest),
+// other (nsegments, *rest) or (nsegments)
+TORCH_API Tensor segment_broadcast(
+    BinaryOpKind       op,
+    const Tensor&      values,
+    const Tensor&      offsets,
+    const Tensor&      other,
+    const c10::Scalar& alpha = 1);
+
+// The offsets of the components of a nested tensor along their first dim,
+// int64 (ntensors + 1)
+TORCH_API Tensor nested_segment_offsets(const Tensor& self);
+
+// op on every element of the nested tensor self
+TORCH_API Tensor nested_unary(UnaryOpKind op, const Tensor& self);
+
+// op(self, other) for other a nested tensor of the same nested sizes, or a
+// dense (ntensors, *rest) or (ntensors) tensor applied to each row of the
+// matching component
+TORCH_API Tensor nested_binary(
+    BinaryOpKind op, const Tensor& self, const Tensor& other, const c10::Scalar& alpha = 1);
+
+// Each component (L_i, *rest) of self folded over its first dim: the dense
+// (ntensors, *rest) result
+TORCH_API Tensor nested_reduce(ReduceOpKind op, const Tensor& self);
+
+}  // namespace at::native
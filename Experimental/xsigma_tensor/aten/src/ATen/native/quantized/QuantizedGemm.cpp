@@ -0,0 +1,287 @@
+#define TORCH_ASSERT_ONLY_METHOD_OPERATORS
+#include <Quarisma/core/Tensor.h>
+#include <Quarisma/native/quantized/QuantizedGemm.h>
+#include <c10/util/irange.h>
+
+#ifndef AT_PER_OPERATOR_HEADERS
+#include <Quarisma/Functions.h>
+#else
+#include <Quarisma/ops/empty.h>
+#endif
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "parallel/parallel_tools.h"
+
+namespace at::native
+{
+
+DEFINE_DISPATCH(qgemm_u8s8_stub);
+DEFINE_DISPATCH(requantize_u8_stub);
+DEFINE_DISPATCH(dequantize_acc_stub);
+
+namespace
+{
+// Rows of the output below which requantization stays on the calling thread
+constexpr int64_t kRequantizeGrainRows = 64;
+
+void check_linear_args(
+    const Tensor&                input,
+    int64_t                      input_zero_point,
+    const Tensor&                weight,
+    const Tensor&                weight_scales,
+    const std::optional<Tensor>& bias)
+{
+    TORCH_CHECK(
+        input.scalar_type() == kByte,
+        "quantized_linear: expected a uint8 input, got ",
+        input.scalar_type());
+    TORCH_CHECK(
+        weight.scalar_type() == kChar && weight.dim() == 2,
+        "quantized_linear: expected a 2-d int8 weight, got a ",
+        weight.dim(),
+        "-d ",
+        weight.scalar_type(),
+        " tensor");
+    TORCH_CHECK(
+        input.dim() >= 1 && input.size(-1) == weight.size(1),
+        "quantized_linear: input of shape ",
+        input.sizes(),
+        " does not match the weight of shape ",
+        weight.sizes());
+    TORCH_CHECK(
+        input_zero_point >= 0 && input_zero_point <= std::numeric_limits<uint8_t>::max(),
+        "quantized_linear: input zero point out of range: ",
+        input_zero_point);
+    TORCH_CHECK(
+        weight_scales.scalar_type() == kFloat && weight_scales.numel() == weight.size(0),
+        "quantized_linear: expected ",
+        weight.size(0),
+        " float weight scales");
+    TORCH_CHECK(
+        !bias.has_value() || !bias->defined() ||
+            (bias->scalar_type() == kFloat && bias->numel() == weight.size(0)),
+        "quantized_linear: expected a float bias of ",
+        weight.size(0),
+        " elements");
+    TORCH_CHECK(
+        input.is_cpu() && weight.is_cpu(), "quantized_linear: only CPU tensors are supported");
+}
+
+// The int32 accumulators (m, n) of input (*, k) and weight (n, k)
+Tensor accumulate(const Tensor& input, int64_t input_zero_point, const Tensor& weight)
+{
+    const int64_t k = weight.size(1);
+    const int64_t n = weight.size(0);
+    const Tensor  a = input.contiguous();
+    const Tensor  w = weight.contiguous();
+    int64_t       m = 1;
+    for (const auto d : c10::irange(a.dim() - 1))
+    {
+        m *= a.size(d);
+    }
+
+    std::vector<int32_t> w_row_sums(n);
+    const int8_t*        w_data = w.const_data_ptr<int8_t>();
+    for (const auto j : c10::irange(n))
+    {
+        int32_t sum = 0;
+        for (const auto l : c10::irange(k))
+        {
+            sum += w_data[j * k + l];
+        }
+        w_row_sums[j] = sum;
+    }
+
+    Tensor acc = at::empty({m, n}, input.options().dtype(kInt));
+    if (m > 0 && n > 0)
+    {
+        qgemm_u8s8_stub(
+            kCPU,
+            m,
+            n,
+            k,
+            a.const_data_ptr<uint8_t>(),
+            k,
+            static_cast<int32_t>(input_zero_point),
+            w_data,
+            k,
+            w_row_sums.data(),
+            acc.mutable_data_ptr<int32_t>());
+    }
+    return acc;
+}
+
+// multiplier[j] = input_scale * weight_scales[j] / output_scale and
+// offset[j] = bias[j] / output_scale
+void channel_params(
+    double                       input_scale,
+    const Tensor&                weight_scales,
+    const std::optional<Tensor>& bias,
+    double                       output_scale,
+    std::vector<float>&          multiplier,
+    std::vector<float>&          offset)
+{
+    const int64_t n                = weight_scales.numel();
+    const Tensor  scales           = weight_scales.contiguous();
+    const float*  scales_data      = scales.const_data_ptr<float>();
+    const bool    has_bias         = bias.has_value() && bias->defined();
+    const Tensor  bias_contig      = has_bias ? bias->contiguous() : Tensor();
+    const float*  bias_data        = has_bias ? bias_contig.const_data_ptr<float>() : nullptr;
+    const double  inv_output_scale = 1.0 / output_scale;
+
+    multiplier.resize(n);
+    offset.resize(n);
+    for (const auto j : c10::irange(n))
+    {
+        multiplier[j] = static_cast<float>(input_scale * scales_data[j] * inv_output_scale);
+        offset[j]     = has_bias ? static_cast<float>(bias_data[j] * inv_output_scale) : 0.0f;
+    }
+}
+
+std::vector<int64_t> output_shape(const Tensor& input, int64_t n)
+{
+    std::vector<int64_t> shape(input.sizes().begin(), input.sizes().end());
+    shape.back() = n;
+    return shape;
+}
+
+// Applies f(row) to the m rows of the output, on the Core thread pool when
+// there are enough of them
+template <typename F>
+void for_each_row(int64_t m, const F& f)
+{
+    if (m < kRequantizeGrainRows || parallel_tools::is_parallel_scope())
+    {
+        for (const auto i : c10::irange(m))
+        {
+            f(i);
+        }
+        return;
+    }
+    parallel_tools::parallel_for(
+        0,
+        static_cast<size_t>(m),
+        static_cast<size_t>(kRequantizeGrainRows),
+        [&f](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                f(static_cast<int64_t>(i));
+            }
+        });
+}
+}  // namespace
+
+Tensor quantized_linear_u8s8(
+    const Tensor&                input,
+    double                       input_scale,
+    int64_t                      input_zero_point,
+    const Tensor&                weight,
+    const Tensor&                weight_scales,
+    const std::optional<Tensor>& bias,
+    double                       output_scale,
+    int64_t                      output_zero_point)
+{
+    check_linear_args(input, input_zero_point, weight, weight_scales, bias);
+    TORCH_CHECK(output_scale > 0, "quantized_linear: output scale must be positive");
+
+    const int64_t n   = weight.size(0);
+    const Tensor  acc = accumulate(input, input_zero_point, weight);
+    const int64_t m   = acc.size(0);
+
+    std::vector<float> multiplier;
+    std::vector<float> offset;
+    channel_params(input_scale, weight_scales, bias, output_scale, multiplier, offset);
+
+    Tensor         out      = at::empty({m, n}, input.options());
+    const int32_t* acc_data = acc.const_data_ptr<int32_t>();
+    uint8_t*       out_data = out.mutable_data_ptr<uint8_t>();
+    for_each_row(
+        m,
+        [&](int64_t i)
+        {
+            requantize_u8_stub(
+                kCPU,
+                acc_data + i * n,
+                n,
+                multiplier.data(),
+                offset.data(),
+                static_cast<int32_t>(output_zero_point),
+                out_data + i * n);
+        });
+    return out.view(output_shape(input, n));
+}
+
+Tensor quantized_linear_u8s8_dequantize(
+    const Tensor&                input,
+    double                       input_scale,
+    int64_t                      input_zero_point,
+    const Tensor&                weight,
+    const Tensor&                weight_scales,
+    const std::optional<Tensor>& bias)
+{
+    check_linear_args(input, input_zero_point, weight, weight_scales, bias);
+
+    const int64_t n   = weight.size(0);
+    const Tensor  acc = accumulate(input, input_zero_point, weight);
+    const int64_t m   = acc.size(0);
+
+    std::vector<float> multiplier;
+    std::vector<float> offset;
+    channel_params(input_scale, weight_scales, bias, 1.0, multiplier, offset);
+
+    Tensor         out      = at::empty({m, n}, input.options().dtype(kFloat));
+    const int32_t* acc_data = acc.const_data_ptr<int32_t>();
+    float*         out_data = out.mutable_data_ptr<float>();
+    for_each_row(
+        m,
+        [&](int64_t i)
+        {
+            dequantize_acc_stub(
+                kCPU, acc_data + i * n, n, multiplier.data(), offset.data(), out_data + i * n);
+        });
+    return out.view(output_shape(input, n));
+}
+
+Tensor requantize_u8(
+    const Tensor& acc, const Tensor& multiplier, const Tensor& offset, int64_t output_zero_point)
+{
+    TORCH_CHECK(
+        acc.scalar_type() == kInt && acc.dim() >= 1,
+        "requantize_u8: expected an int32 tensor of at least one dimension");
+    const int64_t n = acc.size(-1);
+    TORCH_CHECK(
+        multiplier.scalar_type() == kFloat && multiplier.numel() == n &&
+            offset.scalar_type() == kFloat && offset.numel() == n,
+        "requantize_u8: expected ",
+        n,
+        " float multipliers and offsets");
+
+    const Tensor  acc_contig = acc.contiguous();
+    const Tensor  mult       = multiplier.contiguous();
+    const Tensor  off        = offset.contiguous();
+    const int64_t m          = n == 0 ? 0 : acc_contig.numel() / n;
+
+    Tensor         out      = at::empty(acc.sizes(), acc.options().dtype(kByte));
+    const int32_t* acc_data = acc_contig.const_data_ptr<int32_t>();
+    uint8_t*       out_data = out.mutable_data_ptr<uint8_t>();
+    for_each_row(
+        m,
+        [&](int64_t i)
+        {
+            requantize_u8_stub(
+                kCPU,
+                acc_data + i * n,
+                n,
+                mult.const_data_ptr<float>(),
+                off.const_data_ptr<float>(),
+                static_cast<int32_t>(output_zero_point),
+                out_data + i * n);
+        });
+    return out;
+}
+
+}  // namespace at::native
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Quarisma/native/DispatchStub.h>
+
+#include <cstdint>
+#include <optional>
+
+namespace at
+{
+class Tensor;
+}  // namespace at
+
+namespace at::native
+{
+
+// Int8 compute kernels behind the quant/dequant nodes that the JIT
+// quantization passes insert around linear layers. The quantized operands are
+// plain uint8 (activations, affine per tensor) and int8 (weights, symmetric
+// per output channel) tensors with explicit quantization parameters, as this
+// port has no Quantizer.
+//
+// qgemm computes, for the m x k activations A, the n x k weights W and the
+// zero point z of A, the int32 accumulators
+//
+//   acc[i][j] = sum_l (A[i][l] - z) * W[j][l]
+//
+// as dot products of u8 rows with s8 rows: with VNNI on AVX512, 16-bit
+// multiply-adds on AVX512-BW and AVX2, and SDOT on ARM. Rows of W are summed
+// once to fold the zero point in. requantize then maps the accumulators of a
+// row, per output channel, to
+//
+//   y[j] = acc[j] * multiplier[j] + offset[j]
+//
+// rounded, shifted by the output zero point and saturated to uint8, or kept in
+// float (dequantize fused).
+
+// acc (m x n, row-major, ld n) = (A - a_zero_point) W^T; A is m x k with row
+// stride lda, W is n x k with row stride ldw and w_row_sums[j] = sum_l W[j][l]
+using qgemm_u8s8_fn = void (*)(
+    int64_t        m,
+    int64_t        n,
+    int64_t        k,
+    const uint8_t* a,
+    int64_t        lda,
+    int32_t        a_zero_point,
+    const int8_t*  w,
+    int64_t        ldw,
+    const int32_t* w_row_sums,
+    int32_t*       acc);
+
+// out[j] = saturate_u8(nearbyint(acc[j] * multiplier[j] + offset[j]) + zero_point)
+using requantize_u8_fn = void (*)(
+    const int32_t* acc,
+    int64_t        n,
+    const float*   multiplier,
+    const float*   offset,
+    int32_t        zero_point,
+    uint8_t*       out);
+
+// out[j] = acc[j] * multiplier[j] + offset[j]
+using dequantize_acc_fn = void (*)(
+    const int32_t* acc, int64_t n, const float* multiplier, const float* offset, float* out);
+
+DECLARE_DISPATCH(qgemm_u8s8_fn, qgemm_u8s8_stub)
+DECLARE_DISPATCH(requantize_u8_fn, requantize_u8_stub)
+DECLARE_DISPATCH(dequantize_acc_fn, dequantize_acc_stub)
+
+// Quantized linear layer: input is a uint8 tensor of shape (*, k) quantized
+// with input_scale and input_zero_point, weight an int8 (n, k) tensor
+// quantized symmetrically with the float (n) weight_scales, bias an optional
+// float (n) tensor. Returns the uint8 (*, n) output quantized with
+// output_scale and output_zero_point.
+TORCH_API Tensor quantized_linear_u8s8(
+    const Tensor&                input,
+    double                       input_scale,
+    int64_t                      input_zero_point,
+    const Tensor&                weight,
+    const Tensor&                weight_scales,
+    const std::optional<Tensor>& bias,
+    double                       output_scale,
+    int64_t                      output_zero_point);
+
+// As quantized_linear_u8s8, with the float (*, n) output
+TORCH_API Tensor quantized_linear_u8s8_dequantize(
+    const Tensor&                input,
+    double                       input_scale,
+    int64_t                      input_zero_point,
+    const Tensor&                weight,
+    const Tensor&                weight_scales,
+    const std::optional<Tensor>& bias);
+
+// The uint8 tensor of the int32 accumulators acc (*, n), requantized with the
+// float (n) per-channel multipliers and offsets
+TORCH_API Tensor requantize_u8(
+    const Tensor& acc,
+    const Tensor& multiplier,
+    const Tensor& offset,
+    int64_t       output_zero_point);
+
+}  // namespace at::native
@@ -0,0 +1,386 @@
+#define TORCH_ASSERT_NO_OPERATORS
+#include <Quarisma/native/quantized/QuantizedGemm.h>
+#include <c10/util/irange.h>
+
+#if defined(CPU_CAPABILITY_AVX512) || defined(CPU_CAPABILITY_AVX2)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "parallel/parallel_tools.h"
+
+namespace at::native
+{
+inline namespace CPU_CAPABILITY
+{
+
+namespace
+{
+// Tiles of the output: kBlockN rows of W, about 64 KiB for k = 1024, stay in
+// cache while kBlockM rows of A run over them
+constexpr int64_t kBlockM = 16;
+constexpr int64_t kBlockN = 64;
+
+// Multiply-adds below which qgemm stays on the calling thread
+constexpr int64_t kParallelMacs = int64_t{1} << 18;
+
+#if defined(__ARM_NEON) && defined(__aarch64__) && defined(__ARM_FEATURE_DOTPROD)
+// SDOT multiplies signed bytes only: the activations are shifted to int8 and
+// the dot products come out as sum (a - 128) w, which the zero point
+// correction takes back
+constexpr int32_t kActivationShift = 128;
+#else
+constexpr int32_t kActivationShift = 0;
+#endif
+
+#if defined(CPU_CAPABILITY_AVX2)
+inline int32_t reduce_add(__m256i v)
+{
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum         = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum         = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+// out[r] = sum_l (a[l] - kActivationShift) * w[r][l] for the rows w[0..kRows)
+// of W, sharing the loads of a
+template <int kRows>
+void dot_u8s8(const uint8_t* a, const int8_t* const* w, int64_t k, int32_t* out)
+{
+    int64_t l = 0;
+    int32_t sums[kRows];
+    std::fill_n(sums, kRows, 0);
+
+#if defined(CPU_CAPABILITY_AVX512) && defined(__AVX512VNNI__)
+    __m512i acc[kRows];
+    for (const auto r : c10::irange(kRows))
+    {
+        acc[r] = _mm512_setzero_si512();
+    }
+    for (; l + 64 <= k; l += 64)
+    {
+        const __m512i va = _mm512_loadu_si512(a + l);
+        for (const auto r : c10::irange(kRows))
+        {
+            acc[r] = _mm512_dpbusd_epi32(acc[r], va, _mm512_loadu_si512(w[r] + l));
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        sums[r] = _mm512_reduce_add_epi32(acc[r]);
+    }
+#elif defined(CPU_CAPABILITY_AVX512)
+    // Widened to 16 bits: u8 * s8 products and their pairwise sums are exact
+    // in VPMADDWD, unlike the saturating VPMADDUBSW
+    __m512i acc[kRows];
+    for (const auto r : c10::irange(kRows))
+    {
+        acc[r] = _mm512_setzero_si512();
+    }
+    for (; l + 32 <= k; l += 32)
+    {
+        const __m512i va =
+            _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + l)));
+        for (const auto r : c10::irange(kRows))
+        {
+            const __m512i vw = _mm512_cvtepi8_epi16(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w[r] + l)));
+            acc[r] = _mm512_add_epi32(acc[r], _mm512_madd_epi16(va, vw));
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        sums[r] = _mm512_reduce_add_epi32(acc[r]);
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    __m256i acc[kRows];
+    for (const auto r : c10::irange(kRows))
+    {
+        acc[r] = _mm256_setzero_si256();
+    }
+    for (; l + 16 <= k; l += 16)
+    {
+        const __m256i va =
+            _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + l)));
+        for (const auto r : c10::irange(kRows))
+        {
+            const __m256i vw =
+                _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w[r] + l)));
+            acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(va, vw));
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        sums[r] = reduce_add(acc[r]);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__) && defined(__ARM_FEATURE_DOTPROD)
+    int32x4_t acc[kRows];
+    for (const auto r : c10::irange(kRows))
+    {
+        acc[r] = vdupq_n_s32(0);
+    }
+    const uint8x16_t shift = vdupq_n_u8(static_cast<uint8_t>(kActivationShift));
+    for (; l + 16 <= k; l += 16)
+    {
+        const int8x16_t va = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(a + l), shift));
+        for (const auto r : c10::irange(kRows))
+        {
+            acc[r] = vdotq_s32(acc[r], va, vld1q_s8(w[r] + l));
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        sums[r] = vaddvq_s32(acc[r]);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    int32x4_t acc[kRows];
+    for (const auto r : c10::irange(kRows))
+    {
+        acc[r] = vdupq_n_s32(0);
+    }
+    for (; l + 8 <= k; l += 8)
+    {
+        const int16x8_t va = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(a + l)));
+        for (const auto r : c10::irange(kRows))
+        {
+            const int16x8_t vw = vmovl_s8(vld1_s8(w[r] + l));
+            acc[r]             = vmlal_s16(acc[r], vget_low_s16(va), vget_low_s16(vw));
+            acc[r]             = vmlal_high_s16(acc[r], va, vw);
+        }
+    }
+    for (const auto r : c10::irange(kRows))
+    {
+        sums[r] = vaddvq_s32(acc[r]);
+    }
+#endif
+
+    for (; l < k; ++l)
+    {
+        const int32_t av = static_cast<int32_t>(a[l]) - kActivationShift;
+        for (const auto r : c10::irange(kRows))
+        {
+            sums[r] += av * w[r][l];
+        }
+    }
+    std::copy_n(sums, kRows, out);
+}
+
+// The tile [m0, m1) x [n0, n1) of qgemm
+void qgemm_tile(
+    int64_t        m0,
+    int64_t        m1,
+    int64_t        n0,
+    int64_t        n1,
+    int64_t        n,
+    int64_t        k,
+    const uint8_t* a,
+    int64_t        lda,
+    int32_t        a_zero_point,
+    const int8_t*  w,
+    int64_t        ldw,
+    const int32_t* w_row_sums,
+    int32_t*       acc)
+{
+    constexpr int kRows                 = 4;
+    const int32_t zero_point_correction = kActivationShift - a_zero_point;
+
+    for (int64_t i = m0; i < m1; ++i)
+    {
+        const uint8_t* a_row   = a + i * lda;
+        int32_t*       acc_row = acc + i * n;
+        int64_t        j       = n0;
+        for (; j + kRows <= n1; j += kRows)
+        {
+            const int8_t* rows[kRows] = {
+                w + j * ldw, w + (j + 1) * ldw, w + (j + 2) * ldw, w + (j + 3) * ldw};
+            dot_u8s8<kRows>(a_row, rows, k, acc_row + j);
+        }
+        for (; j < n1; ++j)
+        {
+            const int8_t* row = w + j * ldw;
+            dot_u8s8<1>(a_row, &row, k, acc_row + j);
+        }
+        for (j = n0; j < n1; ++j)
+        {
+            acc_row[j] += zero_point_correction * w_row_sums[j];
+        }
+    }
+}
+
+void qgemm_u8s8_kernel(
+    int64_t        m,
+    int64_t        n,
+    int64_t        k,
+    const uint8_t* a,
+    int64_t        lda,
+    int32_t        a_zero_point,
+    const int8_t*  w,
+    int64_t        ldw,
+    const int32_t* w_row_sums,
+    int32_t*       acc)
+{
+    const int64_t m_blocks = (m + kBlockM - 1) / kBlockM;
+    const int64_t n_blocks = (n + kBlockN - 1) / kBlockN;
+
+    auto run_tiles = [&](int64_t begin, int64_t end)
+    {
+        for (int64_t t = begin; t < end; ++t)
+        {
+            const int64_t m0 = (t % m_blocks) * kBlockM;
+            const int64_t n0 = (t / m_blocks) * kBlockN;
+            qgemm_tile(
+                m0,
+                std::min(m0 + kBlockM, m),
+                n0,
+                std::min(n0 + kBlockN, n),
+                n,
+                k,
+                a,
+                lda,
+                a_zero_point,
+                w,
+                ldw,
+                w_row_sums,
+                acc);
+        }
+    };
+
+    // Consecutive tiles share their block of W
+    const int64_t tiles = m_blocks * n_blocks;
+    if (m * n * k < kParallelMacs || tiles == 1 || parallel_tools::is_parallel_scope())
+    {
+        run_tiles(0, tiles);
+        return;
+    }
+    parallel_tools::parallel_for(
+        0,
+        static_cast<size_t>(tiles),
+        1,
+        [&run_tiles](size_t begin, size_t end)
+        { run_tiles(static_cast<int64_t>(begin), static_cast<int64_t>(end)); });
+}
+
+void requantize_u8_kernel(
+    const int32_t* acc,
+    int64_t        n,
+    const float*   multiplier,
+    const float*   offset,
+    int32_t        zero_point,
+    uint8_t*       out)
+{
+    // Clamping before rounding keeps the conversion in range; the bounds are
+    // integers, so the rounding of the values inside is unchanged
+    const float lo = static_cast<float>(-zero_point);
+    const float hi = static_cast<float>(255 - zero_point);
+
+    int64_t j = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    const __m512  vlo = _mm512_set1_ps(lo);
+    const __m512  vhi = _mm512_set1_ps(hi);
+    const __m512i vzp = _mm512_set1_epi32(zero_point);
+    for (; j + 16 <= n; j += 16)
+    {
+        __m512 v = _mm512_fmadd_ps(
+            _mm512_cvtepi32_ps(_mm512_loadu_si512(acc + j)),
+            _mm512_loadu_ps(multiplier + j),
+            _mm512_loadu_ps(offset + j));
+        v               = _mm512_min_ps(_mm512_max_ps(v, vlo), vhi);
+        const __m512i q = _mm512_add_epi32(_mm512_cvtps_epi32(v), vzp);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm512_cvtusepi32_epi8(q));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    const __m256  vlo = _mm256_set1_ps(lo);
+    const __m256  vhi = _mm256_set1_ps(hi);
+    const __m256i vzp = _mm256_set1_epi32(zero_point);
+    for (; j + 8 <= n; j += 8)
+    {
+        __m256 v = _mm256_fmadd_ps(
+            _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + j))),
+            _mm256_loadu_ps(multiplier + j),
+            _mm256_loadu_ps(offset + j));
+        v                   = _mm256_min_ps(_mm256_max_ps(v, vlo), vhi);
+        const __m256i q     = _mm256_add_epi32(_mm256_cvtps_epi32(v), vzp);
+        const __m128i words =
+            _mm_packus_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(words, words));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t vlo         = vdupq_n_f32(lo);
+    const float32x4_t vhi         = vdupq_n_f32(hi);
+    const int32x4_t   vzp         = vdupq_n_s32(zero_point);
+    auto              requantize4 = [&](int64_t at)
+    {
+        float32x4_t v = vfmaq_f32(
+            vld1q_f32(offset + at), vcvtq_f32_s32(vld1q_s32(acc + at)), vld1q_f32(multiplier + at));
+        v = vminq_f32(vmaxq_f32(v, vlo), vhi);
+        return vqmovun_s32(vaddq_s32(vcvtnq_s32_f32(v), vzp));
+    };
+    for (; j + 8 <= n; j += 8)
+    {
+        vst1_u8(out + j, vqmovn_u16(vcombine_u16(requantize4(j), requantize4(j + 4))));
+    }
+#endif
+    for (; j < n; ++j)
+    {
+        const float v = std::min(std::max(acc[j] * multiplier[j] + offset[j], lo), hi);
+        out[j]        = static_cast<uint8_t>(static_cast<int32_t>(std::nearbyint(v)) + zero_point);
+    }
+}
+
+void dequantize_acc_kernel(
+    const int32_t* acc, int64_t n, const float* multiplier, const float* offset, float* out)
+{
+    int64_t j = 0;
+#if defined(CPU_CAPABILITY_AVX512)
+    for (; j + 16 <= n; j += 16)
+    {
+        _mm512_storeu_ps(
+            out + j,
+            _mm512_fmadd_ps(
+                _mm512_cvtepi32_ps(_mm512_loadu_si512(acc + j)),
+                _mm512_loadu_ps(multiplier + j),
+                _mm512_loadu_ps(offset + j)));
+    }
+#elif defined(CPU_CAPABILITY_AVX2)
+    for (; j + 8 <= n; j += 8)
+    {
+        _mm256_storeu_ps(
+            out + j,
+            _mm256_fmadd_ps(
+                _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + j))),
+                _mm256_loadu_ps(multiplier + j),
+                _mm256_loadu_ps(offset + j)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; j + 4 <= n; j += 4)
+    {
+        vst1q_f32(
+            out + j,
+            vfmaq_f32(
+                vld1q_f32(offset + j),
+                vcvtq_f32_s32(vld1q_s32(acc + j)),
+                vld1q_f32(multiplier + j)));
+    }
+#endif
+    for (; j < n; ++j)
+    {
+        out[j] = acc[j] * multiplier[j] + offset[j];
+    }
+}
+}  // namespace
+
+}  // namespace CPU_CAPABILITY
+
+REGISTER_DISPATCH(qgemm_u8s8_stub, &qgemm_u8s8_kernel)
+REGISTER_DISPATCH(requantize_u8_stub, &requantize_u8_kernel)
+REGISTER_DISPATCH(dequantize_acc_stub, &dequantize_acc_kernel)
+
+}  // namespace at::native
@@ -7,16 +7,92 @@
 #include <c10/mobile/CPUProfilingAllocator.h>
 #include <c10/util/Logging.h>
 
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 // TODO: rename flag to C10
 C10_DEFINE_bool(caffe2_report_cpu_memory_usage, false, "If set, print out detailed memory usage")
 
     namespace c10
 {
+    namespace
+    {
+    thread_local PlannedCPUAllocation* planned_allocation = nullptr;
+    }  // namespace
+
+    PlannedCPUAllocation* SetPlannedCPUAllocation(PlannedCPUAllocation* planned)
+    {
+        return std::exchange(planned_allocation, planned);
+    }
+
+    PlannedCPUAllocation* GetPlannedCPUAllocation()
+    {
+        return planned_allocation;
+    }
+
+    namespace
+    {
+#ifdef _WIN32
+    void UnmapZeroedPages(void* base)
+    {
+        VirtualFree(base, 0, MEM_RELEASE);
+    }
+#else
+    // The length of the mapping is kept in its first page, ahead of the data
+    void UnmapZeroedPages(void* base)
+    {
+        munmap(base, *static_cast<size_t*>(base));
+    }
+#endif
+    }  // namespace
+
+    bool MapZeroedCPUAllocation(size_t nbytes, PlannedCPUAllocation* allocation)
+    {
+#ifdef _WIN32
+        void* base = VirtualAlloc(nullptr, nbytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (base == nullptr)
+        {
+            return false;
+        }
+        *allocation = PlannedCPUAllocation{base, nbytes, base, &UnmapZeroedPages};
+#else
+        const auto   page   = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t length = page + nbytes;
+        void*        base =
+            mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            return false;
+        }
+        *static_cast<size_t*>(base) = length;
+        *allocation =
+            PlannedCPUAllocation{static_cast<char*>(base) + page, nbytes, base, &UnmapZeroedPages};
+#endif
+        return true;
+    }
+
     struct C10_API DefaultCPUAllocator final : at::Allocator
     {
         DefaultCPUAllocator() = default;
         at::DataPtr allocate(size_t nbytes) override
         {
+            PlannedCPUAllocation* planned = planned_allocation;
+            if (C10_UNLIKELY(planned != nullptr) && planned->data != nullptr &&
+                planned->nbytes == nbytes)
+            {
+                return {
+                    std::exchange(planned->data, nullptr),
+                    planned->context,
+                    planned->deleter,
+                    at::Device(at::DeviceType::CPU)};
+            }
+
             void* data = nullptr;
             try
             {
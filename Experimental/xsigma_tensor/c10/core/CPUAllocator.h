@@ -51,6 +51,32 @@ C10_API at::Allocator* GetDefaultCPUAllocator();
 // Get the Default Mobile CPU Allocator
 C10_API at::Allocator* GetDefaultMobileCPUAllocator();
 
+// A block reserved for one CPU allocation of exactly nbytes bytes, used by
+// the memory plans of the JIT graph executor. The DataPtr of the allocation
+// frees it by calling deleter(context).
+struct PlannedCPUAllocation
+{
+    void*        data    = nullptr;
+    size_t       nbytes  = 0;
+    void*        context = nullptr;
+    DeleterFnPtr deleter = nullptr;
+};
+
+// Makes the default CPU allocator serve the next allocation of
+// planned->nbytes bytes on the calling thread from planned->data, then set
+// planned->data to nullptr. nullptr serves every allocation from the heap.
+// Returns the previous planned allocation of the thread.
+C10_API PlannedCPUAllocation* SetPlannedCPUAllocation(PlannedCPUAllocation* planned);
+
+// The planned allocation of the calling thread, nullptr if there is none.
+C10_API PlannedCPUAllocation* GetPlannedCPUAllocation();
+
+// Maps nbytes of fresh anonymous pages into *allocation. The kernel zeroes
+// such pages when they are first touched, so a tensor served from them is
+// zeroed without a memset, and each page is placed on the NUMA node of the
+// thread that first writes it. Returns false if the mapping fails.
+C10_API bool MapZeroedCPUAllocation(size_t nbytes, PlannedCPUAllocation* allocation);
+
 // The CPUCachingAllocator is experimental and might disappear in the future.
 // The only place that uses it is in StaticRuntime.
 // Set the CPU Caching Allocator
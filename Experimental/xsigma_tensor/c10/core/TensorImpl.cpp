@@ -37,9 +37,10 @@ C10_DEFINE_bool(
 
     at::Tensor& TensorImpl::mutable_grad()
     {
-        if (!autograd_meta_)
-            autograd_meta_ = impl::GetAutogradMetaFactory()->make();
-        return autograd_meta_->mutable_grad();
+        auto& autograd_meta = autograd_meta_owner();
+        if (!autograd_meta)
+            autograd_meta = impl::GetAutogradMetaFactory()->make();
+        return autograd_meta->mutable_grad();
     }
 
     const at::Tensor& TensorImpl::grad() const
@@ -50,17 +51,19 @@ C10_DEFINE_bool(
         // is not so easy to fix right now because the mutable counterpart of
         // this function must keep working so that "x.grad() = ..." keeps working
         // (part of public API).
-        if (!autograd_meta_)
+        const auto* autograd_meta = autograd_meta_ptr();
+        if (!autograd_meta)
             return impl::GetAutogradMetaFactory()->undefined_tensor();
-        return autograd_meta_->grad();
+        return autograd_meta->grad();
     }
 
     const at::Tensor& TensorImpl::_fw_grad(uint64_t level, const at::TensorBase& self) const
     {
         // See TensorImpl::grad() above for explanation about the line below
-        if (!autograd_meta_)
+        const auto* autograd_meta = autograd_meta_ptr();
+        if (!autograd_meta)
             return impl::GetAutogradMetaFactory()->undefined_tensor();
-        return autograd_meta_->fw_grad(level, self);
+        return autograd_meta->fw_grad(level, self);
     }
 
     void TensorImpl::_set_fw_grad(
@@ -69,9 +72,10 @@ C10_DEFINE_bool(
         uint64_t              level,
         bool                  is_inplace_op)
     {
-        if (!autograd_meta_)
-            autograd_meta_ = impl::GetAutogradMetaFactory()->make();
-        autograd_meta_->set_fw_grad(new_grad, self, level, is_inplace_op);
+        auto& autograd_meta = autograd_meta_owner();
+        if (!autograd_meta)
+            autograd_meta = impl::GetAutogradMetaFactory()->make();
+        autograd_meta->set_fw_grad(new_grad, self, level, is_inplace_op);
     }
 
     TensorImpl::~TensorImpl() = default;
@@ -289,7 +293,8 @@ C10_DEFINE_bool(
 
     void TensorImpl::release_resources()
     {
-        autograd_meta_.reset();
+        if (autograd_meta_ptr())
+            autograd_meta_owner().reset();
         if (storage_)
         {
             storage_ = {};
@@ -503,10 +508,11 @@ C10_DEFINE_bool(
         TORCH_CHECK(
             !(requires_grad && is_inference() && !c10::InferenceMode::is_enabled()),
             "Setting requires_grad=True on inference tensor outside InferenceMode is not allowed.");
-        if (!requires_grad && !autograd_meta_)
+        if (!requires_grad && !autograd_meta_ptr())
             return;
-        if (!autograd_meta_)
-            autograd_meta_ = impl::GetAutogradMetaFactory()->make();
+        auto& autograd_meta = autograd_meta_owner();
+        if (!autograd_meta)
+            autograd_meta = impl::GetAutogradMetaFactory()->make();
         // NB: In principle, setting requires_grad to false could result in
         // the AutogradMeta becoming equal to a default constructed state,
         // in which case we could apply the nullptr AutogradMeta optimization
@@ -516,27 +522,29 @@ C10_DEFINE_bool(
         // information content in the other fields; for example, we may
         // have set the string name for a Variable, or there may be hooks
         // registered for it.
-        autograd_meta_->set_requires_grad(requires_grad, this);
+        autograd_meta->set_requires_grad(requires_grad, this);
     }
 
     bool TensorImpl::requires_grad() const
     {
-        if (!autograd_meta_)
+        const auto* autograd_meta = autograd_meta_ptr();
+        if (!autograd_meta)
             return false;
-        return autograd_meta_->requires_grad();
+        return autograd_meta->requires_grad();
     }
 
     void TensorImpl::set_autograd_meta(std::unique_ptr<c10::AutogradMetaInterface> autograd_meta)
     {
         // NB: autograd_meta may be null!  That just means it's the default
         // constructor
-        autograd_meta_ = std::move(autograd_meta);
+        if (autograd_meta || autograd_meta_ptr())
+            autograd_meta_owner() = std::move(autograd_meta);
     }
 
     c10::AutogradMetaInterface* TensorImpl::autograd_meta() const
     {
         // NB: Might return null!
-        return autograd_meta_.get();
+        return autograd_meta_ptr();
     }
 
     template <typename VariableVersion>
@@ -623,6 +631,14 @@ C10_DEFINE_bool(
         dest_impl->is_wrapped_number_              = src_impl->is_wrapped_number_;
         dest_impl->reserved_                       = src_impl->reserved_;
         dest_impl->numel_                          = src_impl->numel_;
+#ifdef C10_COMPACT_TENSOR_METADATA
+        // The AutogradMeta stays with dest_impl, whose ExtraMeta is replaced below
+        std::unique_ptr<c10::AutogradMetaInterface> dest_autograd_meta;
+        if (dest_impl->extra_meta_ != nullptr)
+        {
+            dest_autograd_meta = std::move(dest_impl->extra_meta_->autograd_meta_);
+        }
+#endif
         if (src_impl->extra_meta_ != nullptr)
         {
             dest_impl->extra_meta_ = src_impl->extra_meta_->clone();
@@ -634,6 +650,12 @@ C10_DEFINE_bool(
             // contaminate the new dest_impl metadata info.
             dest_impl->extra_meta_.reset(nullptr);
         }
+#ifdef C10_COMPACT_TENSOR_METADATA
+        if (dest_autograd_meta)
+        {
+            dest_impl->get_extra_meta().autograd_meta_ = std::move(dest_autograd_meta);
+        }
+#endif
 
         // NB: symbolic sizes and strides are copied as is custom policy, but python
         // policy is NOT (you have no Python object to dispatch to!)
@@ -257,6 +257,11 @@ struct C10_API ExtraMeta
     intrusive_ptr<c10::BackendMeta>                backend_meta_              = nullptr;
     std::optional<std::string>                     custom_data_ptr_error_msg_ = std::nullopt;
     std::optional<std::string>                     custom_storage_error_msg_  = std::nullopt;
+#ifdef C10_COMPACT_TENSOR_METADATA
+    // See TensorImpl::autograd_meta_ptr. It has a single owner, so it is not
+    // copied with the rest of the ExtraMeta.
+    std::unique_ptr<c10::AutogradMetaInterface> autograd_meta_ = nullptr;
+#endif
 
     ExtraMeta()  = default;
     ~ExtraMeta() = default;
@@ -1945,6 +1950,30 @@ private:
         return *extra_meta_;
     }
 
+    // The AutogradMeta of this tensor, null when it has none. With
+    // C10_COMPACT_TENSOR_METADATA it is kept in the ExtraMeta rather than in
+    // TensorImpl, so that the many tensors which never require grad save a
+    // word, at the cost of one more indirection for those which do.
+    c10::AutogradMetaInterface* autograd_meta_ptr() const
+    {
+#ifdef C10_COMPACT_TENSOR_METADATA
+        return extra_meta_ ? extra_meta_->autograd_meta_.get() : nullptr;
+#else
+        return autograd_meta_.get();
+#endif
+    }
+
+    // The owner of the AutogradMeta, which allocates the ExtraMeta in compact
+    // mode: only call it to store an AutogradMeta
+    std::unique_ptr<c10::AutogradMetaInterface>& autograd_meta_owner()
+    {
+#ifdef C10_COMPACT_TENSOR_METADATA
+        return get_extra_meta().autograd_meta_;
+#else
+        return autograd_meta_;
+#endif
+    }
+
     c10::SymbolicShapeMeta& symbolic_shape_meta()
     {
         TORCH_INTERNAL_ASSERT(extra_meta_ && extra_meta_->symbolic_shape_meta_);
@@ -3108,7 +3137,11 @@ private:
     //    2. autograd_meta_ is default constructed (semantically, same as (1))
     //    3. autograd_meta_ has nontrivial information content
     //
+    // With C10_COMPACT_TENSOR_METADATA, it is a field of extra_meta_ instead.
+    // Always go through autograd_meta_ptr() and autograd_meta_owner().
+#ifndef C10_COMPACT_TENSOR_METADATA
     std::unique_ptr<c10::AutogradMetaInterface> autograd_meta_ = nullptr;
+#endif
 
 protected:
     std::unique_ptr<c10::ExtraMeta> extra_meta_ = nullptr;
@@ -3311,7 +3344,7 @@ private:
 //    strong refcount           TODO: pack these into one word
 //    weak refcount
 //    storage pointer
-//    autograd metadata pointer
+//    autograd metadata pointer (in the ExtraMeta with C10_COMPACT_TENSOR_METADATA)
 //    named tensor metadata pointer
 //    version counter pointer
 //    PyObjectSlot
@@ -3392,7 +3425,9 @@ class C10_TensorImpl_Size_Check_Dummy_Class : private TensorImpl
     enum class FieldNameEnum
     {
         storage_,
+#ifndef C10_COMPACT_TENSOR_METADATA
         autograd_meta_,
+#endif
         extra_meta_,
         version_counter_,
         pyobj_slot_,
@@ -3447,7 +3482,9 @@ public:
 
         // clang-format off
     are_equal<sizeof(storage_),            4,  FieldNameEnum::storage_>();
+#ifndef C10_COMPACT_TENSOR_METADATA
     are_equal<sizeof(autograd_meta_),      4,  FieldNameEnum::autograd_meta_>();
+#endif
     are_equal<sizeof(extra_meta_),         4,  FieldNameEnum::extra_meta_>();
     are_equal<sizeof(version_counter_),    4,  FieldNameEnum::version_counter_>();
     are_equal<sizeof(pyobj_slot_),    8,  FieldNameEnum::pyobj_slot_>();
@@ -3473,7 +3510,9 @@ public:
     // On some systems involving NVCC the size of unique_ptr is 16 bytes. We haven't
     // figured out how to detect those via macro preprocessors yet, so we use <=
     // comparisons for the relevant fields.
+#ifndef C10_COMPACT_TENSOR_METADATA
     is_le<sizeof(autograd_meta_),         16,  FieldNameEnum::autograd_meta_>();
+#endif
     is_le<sizeof(extra_meta_),            16,  FieldNameEnum::extra_meta_>();
     are_equal<sizeof(version_counter_),    8,  FieldNameEnum::version_counter_>();
     are_equal<sizeof(pyobj_slot_),   16,  FieldNameEnum::pyobj_slot_>();
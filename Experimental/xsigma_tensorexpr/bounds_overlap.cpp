@@ -1,9 +1,13 @@
 #include <torch/csrc/jit/tensorexpr/bounds_overlap.h>
+#include <torch/csrc/jit/tensorexpr/ir_printer.h>
 #include <torch/csrc/jit/tensorexpr/ir_simplifier.h>
 #include <torch/csrc/jit/tensorexpr/ir_visitor.h>
 #include <torch/csrc/jit/tensorexpr/stmt.h>
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
 
 namespace torch::jit::tensorexpr::analysis
 {
@@ -101,6 +105,29 @@ bool Bound::operator<(const Bound& other) const
 
 OverlapKind boundOverlap(const Bound& a, const Bound& b)
 {
+    // Constant bounds, the usual case once loop extents are substituted, are
+    // compared directly rather than through the simplifier.
+    auto aStart = intValue(a.start);
+    auto aEnd   = intValue(a.end);
+    auto bStart = intValue(b.start);
+    auto bEnd   = intValue(b.end);
+    if (aStart && aEnd && bStart && bEnd)
+    {
+        if (*aStart > *bEnd || *bStart > *aEnd)
+        {
+            return OverlapKind::NoOverlap;
+        }
+        if (*bStart <= *aStart && *bEnd >= *aEnd)
+        {
+            return OverlapKind::ContainedOrEqual;
+        }
+        if (*bStart >= *aStart && *bEnd <= *aEnd)
+        {
+            return OverlapKind::Contains;
+        }
+        return OverlapKind::PartialOverlap;
+    }
+
     // If they're equal they're equal.
     bool startEqual = exprEquals(a.start, b.start);
     bool endEqual   = exprEquals(a.end, b.end);
@@ -225,7 +252,7 @@ Bound flattenBounds(const IndexBounds& a)
     return ret;
 }
 
-OverlapKind overlaps(const IndexBounds& a, const IndexBounds& b)
+static OverlapKind computeOverlaps(const IndexBounds& a, const IndexBounds& b)
 {
     if (a.empty() && b.empty())
     {
@@ -269,6 +296,79 @@ OverlapKind overlaps(const IndexBounds& a, const IndexBounds& b)
     return overlap;
 }
 
+namespace
+{
+
+// Prints bounds with every Var identified by its address: two live Vars never
+// share one, so equal keys mean structurally equal bounds over the same Vars.
+class OverlapKeyPrinter : public IRPrinter
+{
+public:
+    explicit OverlapKeyPrinter(std::ostream& os) : IRPrinter(os) {}
+
+    using IRPrinter::visit;
+
+    void visit(const VarPtr& v) override { os() << "v" << v.get(); }
+
+    void print(const IndexBounds& bounds)
+    {
+        for (const Bound& bound : bounds)
+        {
+            bound.start->accept(this);
+            os() << ":";
+            bound.end->accept(this);
+            os() << ";";
+        }
+    }
+};
+
+// Caps the memory of the cache; it is cleared once full
+constexpr size_t kOverlapsCacheSize = 1 << 16;
+
+std::unordered_map<std::string, OverlapKind>& overlapsCache()
+{
+    thread_local std::unordered_map<std::string, OverlapKind> cache;
+    return cache;
+}
+
+}  // namespace
+
+// Loop nest transforms rebuild their dependency analysis from scratch after
+// each step, asking the same questions about the bounds the step left
+// untouched. The answer only depends on the bound expressions, so it is kept
+// across analyses.
+OverlapKind overlaps(const IndexBounds& a, const IndexBounds& b)
+{
+    std::ostringstream key_stream;
+    {
+        OverlapKeyPrinter printer(key_stream);
+        printer.print(a);
+        key_stream << "|";
+        printer.print(b);
+    }
+    std::string key = key_stream.str();
+
+    auto& cache = overlapsCache();
+    auto  it    = cache.find(key);
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+
+    OverlapKind overlap = computeOverlaps(a, b);
+    if (cache.size() >= kOverlapsCacheSize)
+    {
+        cache.clear();
+    }
+    cache.emplace(std::move(key), overlap);
+    return overlap;
+}
+
+void clearOverlapsCache()
+{
+    overlapsCache().clear();
+}
+
 std::vector<Bound> subtractBound(const Bound& a, const Bound& b)
 {
     OverlapKind overlap = boundOverlap(a, b);
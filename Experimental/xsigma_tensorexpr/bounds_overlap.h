@@ -101,8 +101,12 @@ bool TORCH_API indexBoundsEquals(const IndexBounds& A, const IndexBounds& B);
 Bound TORCH_API flattenBounds(const IndexBounds& a);
 
 // Determines the kind of overlap in X dimensions.
+// Results are cached per thread, keyed on the bound expressions.
 OverlapKind TORCH_API overlaps(const IndexBounds& a, const IndexBounds& b);
 
+// Drops the results cached by overlaps().
+void TORCH_API clearOverlapsCache();
+
 // Returns the Bound slices created by subtracing bound B from bound A.
 // Multiple Bounds can be returned in the case where B slices A into two
 // distinct regions with no overlap.
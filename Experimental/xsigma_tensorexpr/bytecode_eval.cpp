@@ -0,0 +1,1598 @@
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/tensorexpr/bytecode_eval.h>
+#include <torch/csrc/jit/tensorexpr/hash_provider.h>
+#include <torch/csrc/jit/tensorexpr/ir_visitor.h>
+#include <quarisma/util/irange.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace torch::jit::tensorexpr
+{
+
+static RegisterCodeGen<BytecodeEvaluator> bytecode_eval_codegen_reg("bytecode_eval");
+
+namespace
+{
+
+// Values per register. Scalar code only uses the first; a vectorized loop runs
+// its body on up to kLanes iterations at once.
+constexpr int64_t kLanes = 64;
+
+enum class RegClass : uint8_t
+{
+    Int,  // Bool and the integral types, widened to int64_t
+    Float,
+    Double,
+};
+
+struct Reg
+{
+    RegClass cls = RegClass::Int;
+    int32_t  idx = -1;
+
+    bool valid() const { return idx >= 0; }
+
+    uint64_t key() const { return (uint64_t(cls) << 32) | uint32_t(idx); }
+};
+
+enum class Op : uint8_t
+{
+    Mov,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Max,
+    Min,
+    And,
+    Or,
+    Xor,
+    Shl,
+    Shr,
+    CmpEQ,
+    CmpGT,
+    CmpGE,
+    CmpLT,
+    CmpLE,
+    CmpNE,
+    Select,  // dst = c ? a : b
+    Cast,    // dst = (type)a
+    IsNan,
+    Abs,
+    Unary,   // dst = fn(a)
+    Binary,  // dst = fn(a, b)
+    Load,    // dst = slot[a], in the lanes where c, if any, is set
+    Store,   // slot[a] = b
+    Alloc,   // slot = a bytes
+    Free,
+    Jump,
+    JumpIfZero,  // on a
+    Loop,        // for dst in [a, b): run up to target
+    VecLoop,     // the same, kLanes iterations at a time
+};
+
+// Any function pointer, cast back by the instruction that calls it
+using AnyFn = void (*)();
+
+struct Instr
+{
+    Op          op = Op::Mov;
+    Reg         dst;
+    Reg         a;
+    Reg         b;
+    Reg         c;
+    ScalarType  type   = ScalarType::Undefined;  // element type of a Cast, Load or Store
+    size_t      target = 0;                      // end of a loop body, or of a jump
+    int32_t     slot   = -1;  // buffer of a memory op; live-in list of a VecLoop
+    AnyFn       fn     = nullptr;
+};
+
+// The statement needs the SimpleIREvaluator fallback
+class unsupported_ir : public std::runtime_error
+{
+public:
+    explicit unsupported_ir(const std::string& what) : std::runtime_error(what) {}
+};
+
+// The loop has to run one iteration at a time
+struct not_vectorizable
+{
+};
+
+RegClass classOf(const Dtype& dtype)
+{
+    if (dtype.lanes() != 1)
+    {
+        throw unsupported_ir("vector dtype");
+    }
+    switch (dtype.scalar_type())
+    {
+    case ScalarType::Bool:
+    case ScalarType::Byte:
+    case ScalarType::Char:
+    case ScalarType::Short:
+    case ScalarType::Int:
+    case ScalarType::Long:
+        return RegClass::Int;
+    case ScalarType::Float:
+        return RegClass::Float;
+    case ScalarType::Double:
+        return RegClass::Double;
+    default:
+        throw unsupported_ir("scalar type " + std::to_string(dtype.scalar_type()));
+    }
+}
+
+template <typename T>
+using UnaryFn = T (*)(T);
+
+template <typename T>
+using BinaryFn = T (*)(T, T);
+
+template <typename T>
+UnaryFn<T> unaryIntrinsic(IntrinsicsOp op)
+{
+    switch (op)
+    {
+    case kSin:
+        return [](T v) -> T { return std::sin(v); };
+    case kCos:
+        return [](T v) -> T { return std::cos(v); };
+    case kTan:
+        return [](T v) -> T { return std::tan(v); };
+    case kAsin:
+        return [](T v) -> T { return std::asin(v); };
+    case kAcos:
+        return [](T v) -> T { return std::acos(v); };
+    case kAtan:
+        return [](T v) -> T { return std::atan(v); };
+    case kSinh:
+        return [](T v) -> T { return std::sinh(v); };
+    case kCosh:
+        return [](T v) -> T { return std::cosh(v); };
+    case kTanh:
+        return [](T v) -> T { return std::tanh(v); };
+    case kExp:
+        return [](T v) -> T { return std::exp(v); };
+    case kAbs:
+        return [](T v) -> T { return std::abs(v); };
+    case kExpm1:
+        return [](T v) -> T { return std::expm1(v); };
+    case kLog:
+        return [](T v) -> T { return std::log(v); };
+    case kLog2:
+        return [](T v) -> T { return std::log2(v); };
+    case kLog10:
+        return [](T v) -> T { return std::log10(v); };
+    case kLog1p:
+        return [](T v) -> T { return std::log1p(v); };
+    case kErf:
+        return [](T v) -> T { return std::erf(v); };
+    case kErfc:
+        return [](T v) -> T { return std::erfc(v); };
+    case kSqrt:
+        return [](T v) -> T { return std::sqrt(v); };
+    case kRsqrt:
+        return [](T v) __ubsan_ignore_float_divide_by_zero__ { return T(1) / std::sqrt(v); };
+    case kCeil:
+        return [](T v) -> T { return std::ceil(v); };
+    case kFloor:
+        return [](T v) -> T { return std::floor(v); };
+    case kRound:
+        return [](T v) -> T { return std::round(v); };
+    case kTrunc:
+        return [](T v) -> T { return std::trunc(v); };
+    case kLgamma:
+        return [](T v) -> T { return std::lgamma(v); };
+    case kFrac:
+        return [](T v) -> T
+        {
+            T intpart;
+            return std::modf(v, &intpart);
+        };
+    default:
+        return nullptr;
+    }
+}
+
+template <typename T>
+BinaryFn<T> binaryIntrinsic(IntrinsicsOp op)
+{
+    switch (op)
+    {
+    case kPow:
+        return [](T a, T b) -> T { return std::pow(a, b); };
+    case kFmod:
+        return [](T a, T b) -> T { return std::fmod(a, b); };
+    case kRemainder:
+        return [](T a, T b) -> T { return std::remainder(a, b); };
+    case kAtan2:
+        return [](T a, T b) -> T { return std::atan2(a, b); };
+    default:
+        return nullptr;
+    }
+}
+
+// Calls f with a value of the C++ type of the register class
+template <typename F>
+void dispatch(RegClass cls, F&& f)
+{
+    switch (cls)
+    {
+    case RegClass::Int:
+        f(int64_t{});
+        break;
+    case RegClass::Float:
+        f(float{});
+        break;
+    case RegClass::Double:
+        f(double{});
+        break;
+    }
+}
+
+template <typename T>
+void bitwise(Op op, T* d, const T* a, const T* b, int64_t n)
+{
+    switch (op)
+    {
+    case Op::And:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] & b[i];
+        }
+        break;
+    case Op::Or:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] | b[i];
+        }
+        break;
+    case Op::Xor:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] ^ b[i];
+        }
+        break;
+    case Op::Shl:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = static_cast<T>(static_cast<std::make_unsigned_t<T>>(a[i]) << b[i]);
+        }
+        break;
+    default:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] >> b[i];
+        }
+        break;
+    }
+}
+
+template <typename T>
+void __ubsan_ignore_float_divide_by_zero__ arith(Op op, T* d, const T* a, const T* b, int64_t n)
+{
+    switch (op)
+    {
+    case Op::Add:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] + b[i];
+        }
+        break;
+    case Op::Sub:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] - b[i];
+        }
+        break;
+    case Op::Mul:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] * b[i];
+        }
+        break;
+    case Op::Div:
+        if constexpr (std::is_integral_v<T>)
+        {
+            QUARISMA_CHECK(std::find(b, b + n, T(0)) == b + n, "Division by zero");
+        }
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] / b[i];
+        }
+        break;
+    case Op::Mod:
+        if constexpr (std::is_integral_v<T>)
+        {
+            QUARISMA_CHECK(std::find(b, b + n, T(0)) == b + n, "Division by zero");
+            for (int64_t i = 0; i < n; ++i)
+            {
+                d[i] = a[i] % b[i];
+            }
+        }
+        else
+        {
+            for (int64_t i = 0; i < n; ++i)
+            {
+                d[i] = std::fmod(a[i], b[i]);
+            }
+        }
+        break;
+    case Op::Max:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                d[i] = std::isnan(a[i])   ? a[i]
+                       : std::isnan(b[i]) ? b[i]
+                                          : (a[i] < b[i] ? b[i] : a[i]);
+            }
+            else
+            {
+                d[i] = a[i] < b[i] ? b[i] : a[i];
+            }
+        }
+        break;
+    case Op::Min:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                d[i] = std::isnan(a[i])   ? a[i]
+                       : std::isnan(b[i]) ? b[i]
+                                          : (a[i] < b[i] ? a[i] : b[i]);
+            }
+            else
+            {
+                d[i] = a[i] < b[i] ? a[i] : b[i];
+            }
+        }
+        break;
+    default:
+        // The bitwise ops, only emitted on integers
+        if constexpr (std::is_integral_v<T>)
+        {
+            bitwise(op, d, a, b, n);
+        }
+        break;
+    }
+}
+
+template <typename T>
+void compare(Op op, int64_t* d, const T* a, const T* b, int64_t n)
+{
+    switch (op)
+    {
+    case Op::CmpEQ:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] == b[i];
+        }
+        break;
+    case Op::CmpGT:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] > b[i];
+        }
+        break;
+    case Op::CmpGE:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] >= b[i];
+        }
+        break;
+    case Op::CmpLT:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] < b[i];
+        }
+        break;
+    case Op::CmpLE:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] <= b[i];
+        }
+        break;
+    default:
+        for (int64_t i = 0; i < n; ++i)
+        {
+            d[i] = a[i] != b[i];
+        }
+        break;
+    }
+}
+
+// disable ubsan: like SimpleIREvaluator, this performs out-of-range casts,
+// e.g. of negative floats to unsigned char
+template <typename To, typename From, typename R>
+void convert(const From* src, R* dst, int64_t n) __ubsan_ignore_undefined__
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        // NOLINTNEXTLINE(bugprone-signed-char-misuse)
+        dst[i] = static_cast<R>(static_cast<To>(src[i]));
+    }
+}
+
+template <typename T, typename R>
+void gather(const T* base, const int64_t* index, const int64_t* mask, R* out, int64_t n)
+{
+    if (mask == nullptr)
+    {
+        for (int64_t i = 0; i < n; ++i)
+        {
+            out[i] = static_cast<R>(base[index[i]]);
+        }
+        return;
+    }
+    for (int64_t i = 0; i < n; ++i)
+    {
+        out[i] = mask[i] ? static_cast<R>(base[index[i]]) : R(0);
+    }
+}
+
+template <typename T, typename R>
+void scatter(T* base, const int64_t* index, const R* value, int64_t n)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        // NOLINTNEXTLINE(bugprone-signed-char-misuse)
+        base[index[i]] = static_cast<T>(value[i]);
+    }
+}
+
+}  // namespace
+
+class BytecodeProgram
+{
+public:
+    std::vector<Instr>            code;
+    std::vector<std::vector<Reg>> live_ins;  // by VecLoop, broadcast before it runs
+    int32_t                       num_regs[3] = {0, 0, 0};
+
+    std::vector<int32_t> arg_slots;  // by buffer arg, -1 for a var
+    std::vector<Reg>     arg_regs;   // by buffer arg, invalid for a buf
+
+    std::vector<void*>                buffers;  // by slot
+    std::vector<std::vector<int64_t>> storage;  // by slot, for Allocate
+
+    Reg newReg(RegClass cls)
+    {
+        Reg r;
+        r.cls = cls;
+        r.idx = num_regs[static_cast<int>(cls)]++;
+        return r;
+    }
+
+    void allocateRegisters()
+    {
+        ints_.assign(size_t(num_regs[0]) * kLanes, 0);
+        floats_.assign(size_t(num_regs[1]) * kLanes, 0);
+        doubles_.assign(size_t(num_regs[2]) * kLanes, 0);
+    }
+
+    template <typename T>
+    T* at(Reg r)
+    {
+        if constexpr (std::is_same_v<T, int64_t>)
+        {
+            return ints_.data() + r.idx * kLanes;
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            return floats_.data() + r.idx * kLanes;
+        }
+        else
+        {
+            return doubles_.data() + r.idx * kLanes;
+        }
+    }
+
+    void bind(const std::vector<CodeGen::BufferArg>& args, const std::vector<void*>& data)
+    {
+        for (const auto i : quarisma::irange(args.size()))
+        {
+            if (arg_slots[i] >= 0)
+            {
+                buffers[arg_slots[i]] = data[i];
+                continue;
+            }
+            switch (args[i].dtype().scalar_type())
+            {
+#define TYPE_CASE(Type, Name)                  \
+    case ScalarType::Name:                     \
+    {                                          \
+        Type value;                            \
+        memcpy(&value, data[i], sizeof(Type)); \
+        setScalar(arg_regs[i], value);         \
+        break;                                 \
+    }
+                AT_FORALL_SCALAR_TYPES_AND(Bool, TYPE_CASE)
+#undef TYPE_CASE
+            default:
+                throw unsupported_dtype();
+            }
+        }
+    }
+
+    template <typename V>
+    void setScalar(Reg r, V value)
+    {
+        dispatch(
+            r.cls, [&](auto tag) { at<decltype(tag)>(r)[0] = static_cast<decltype(tag)>(value); });
+    }
+
+    void unbind() { std::fill(buffers.begin(), buffers.end(), nullptr); }
+
+    void run(size_t begin, size_t end, int64_t n);
+
+private:
+    template <typename R>
+    void load(const Instr& ins, int64_t n);
+
+    template <typename R>
+    void store(const Instr& ins, int64_t n);
+
+    template <typename From>
+    void cast(const Instr& ins, int64_t n);
+
+    void* buffer(const Instr& ins)
+    {
+        void* base = buffers[ins.slot];
+        if (base == nullptr)
+        {
+            throw malformed_input("buffer accessed before it is bound or allocated");
+        }
+        return base;
+    }
+
+    std::vector<int64_t> ints_;
+    std::vector<float>   floats_;
+    std::vector<double>  doubles_;
+};
+
+template <typename R>
+void BytecodeProgram::load(const Instr& ins, int64_t n)
+{
+    const void*    base  = buffer(ins);
+    const int64_t* index = at<int64_t>(ins.a);
+    const int64_t* mask  = ins.c.valid() ? at<int64_t>(ins.c) : nullptr;
+    R*             out   = at<R>(ins.dst);
+    switch (ins.type)
+    {
+#define TYPE_CASE(Type, Name)                                         \
+    case ScalarType::Name:                                            \
+        gather(static_cast<const Type*>(base), index, mask, out, n); \
+        break;
+        AT_FORALL_SCALAR_TYPES_AND(Bool, TYPE_CASE)
+#undef TYPE_CASE
+    default:
+        throw unsupported_dtype();
+    }
+}
+
+template <typename R>
+void BytecodeProgram::store(const Instr& ins, int64_t n)
+{
+    void*          base  = buffer(ins);
+    const int64_t* index = at<int64_t>(ins.a);
+    const R*       value = at<R>(ins.b);
+    switch (ins.type)
+    {
+#define TYPE_CASE(Type, Name)                                 \
+    case ScalarType::Name:                                    \
+        scatter(static_cast<Type*>(base), index, value, n); \
+        break;
+        AT_FORALL_SCALAR_TYPES_AND(Bool, TYPE_CASE)
+#undef TYPE_CASE
+    default:
+        throw unsupported_dtype();
+    }
+}
+
+template <typename From>
+void BytecodeProgram::cast(const Instr& ins, int64_t n)
+{
+    const From* src = at<From>(ins.a);
+    switch (ins.type)
+    {
+#define TYPE_CASE(Type, Name)                        \
+    case ScalarType::Name:                           \
+        convert<Type>(src, at<int64_t>(ins.dst), n); \
+        break;
+        AT_FORALL_INT_TYPES(TYPE_CASE)
+        TYPE_CASE(bool, Bool)
+#undef TYPE_CASE
+    case ScalarType::Float:
+        convert<float>(src, at<float>(ins.dst), n);
+        break;
+    case ScalarType::Double:
+        convert<double>(src, at<double>(ins.dst), n);
+        break;
+    default:
+        throw unsupported_dtype();
+    }
+}
+
+void BytecodeProgram::run(size_t begin, size_t end, int64_t n)
+{
+    size_t pc = begin;
+    while (pc < end)
+    {
+        const Instr& ins = code[pc];
+        switch (ins.op)
+        {
+        case Op::Mov:
+            dispatch(
+                ins.dst.cls,
+                [&](auto tag)
+                {
+                    using T = decltype(tag);
+                    std::copy_n(at<T>(ins.a), n, at<T>(ins.dst));
+                });
+            break;
+        case Op::Add:
+        case Op::Sub:
+        case Op::Mul:
+        case Op::Div:
+        case Op::Mod:
+        case Op::Max:
+        case Op::Min:
+        case Op::And:
+        case Op::Or:
+        case Op::Xor:
+        case Op::Shl:
+        case Op::Shr:
+            dispatch(
+                ins.dst.cls,
+                [&](auto tag)
+                {
+                    using T = decltype(tag);
+                    arith(ins.op, at<T>(ins.dst), at<T>(ins.a), at<T>(ins.b), n);
+                });
+            break;
+        case Op::CmpEQ:
+        case Op::CmpGT:
+        case Op::CmpGE:
+        case Op::CmpLT:
+        case Op::CmpLE:
+        case Op::CmpNE:
+            dispatch(
+                ins.a.cls,
+                [&](auto tag)
+                {
+                    using T = decltype(tag);
+                    compare(ins.op, at<int64_t>(ins.dst), at<T>(ins.a), at<T>(ins.b), n);
+                });
+            break;
+        case Op::Select:
+            dispatch(
+                ins.dst.cls,
+                [&](auto tag)
+                {
+                    using T              = decltype(tag);
+                    const int64_t* cond  = at<int64_t>(ins.c);
+                    const T*       lhs   = at<T>(ins.a);
+                    const T*       rhs   = at<T>(ins.b);
+                    T*             dst   = at<T>(ins.dst);
+                    for (int64_t i = 0; i < n; ++i)
+                    {
+                        dst[i] = cond[i] ? lhs[i] : rhs[i];
+                    }
+                });
+            break;
+        case Op::Cast:
+            dispatch(ins.a.cls, [&](auto tag) { cast<decltype(tag)>(ins, n); });
+            break;
+        case Op::IsNan:
+            dispatch(
+                ins.a.cls,
+                [&](auto tag)
+                {
+                    using T            = decltype(tag);
+                    const T*     src   = at<T>(ins.a);
+                    int64_t*     dst   = at<int64_t>(ins.dst);
+                    for (int64_t i = 0; i < n; ++i)
+                    {
+                        if constexpr (std::is_floating_point_v<T>)
+                        {
+                            dst[i] = std::isnan(src[i]);
+                        }
+                        else
+                        {
+                            dst[i] = 0;
+                        }
+                    }
+                });
+            break;
+        case Op::Abs:
+        {
+            const int64_t* src = at<int64_t>(ins.a);
+            int64_t*       dst = at<int64_t>(ins.dst);
+            for (int64_t i = 0; i < n; ++i)
+            {
+                dst[i] = src[i] < 0 ? -src[i] : src[i];
+            }
+            break;
+        }
+        case Op::Unary:
+            dispatch(
+                ins.dst.cls,
+                [&](auto tag)
+                {
+                    using T        = decltype(tag);
+                    const auto fn  = reinterpret_cast<UnaryFn<T>>(ins.fn);
+                    const T*   src = at<T>(ins.a);
+                    T*         dst = at<T>(ins.dst);
+                    if constexpr (std::is_floating_point_v<T>)
+                    {
+                        for (int64_t i = 0; i < n; ++i)
+                        {
+                            dst[i] = fn(src[i]);
+                        }
+                    }
+                });
+            break;
+        case Op::Binary:
+            dispatch(
+                ins.dst.cls,
+                [&](auto tag)
+                {
+                    using T        = decltype(tag);
+                    const auto fn  = reinterpret_cast<BinaryFn<T>>(ins.fn);
+                    const T*   lhs = at<T>(ins.a);
+                    const T*   rhs = at<T>(ins.b);
+                    T*         dst = at<T>(ins.dst);
+                    if constexpr (std::is_floating_point_v<T>)
+                    {
+                        for (int64_t i = 0; i < n; ++i)
+                        {
+                            dst[i] = fn(lhs[i], rhs[i]);
+                        }
+                    }
+                });
+            break;
+        case Op::Load:
+            dispatch(ins.dst.cls, [&](auto tag) { load<decltype(tag)>(ins, n); });
+            break;
+        case Op::Store:
+            dispatch(ins.b.cls, [&](auto tag) { store<decltype(tag)>(ins, n); });
+            break;
+        case Op::Alloc:
+        {
+            const int64_t bytes = at<int64_t>(ins.a)[0];
+            if (buffers[ins.slot] != nullptr)
+            {
+                throw std::runtime_error("Allocate a buffer that has already been allocated");
+            }
+            // Kept between calls, so that a kernel allocates its temporaries once
+            auto& words = storage[ins.slot];
+            words.resize((bytes + sizeof(int64_t) - 1) / sizeof(int64_t));
+            buffers[ins.slot] = words.data();
+            break;
+        }
+        case Op::Free:
+            buffers[ins.slot] = nullptr;
+            break;
+        case Op::Jump:
+            pc = ins.target;
+            continue;
+        case Op::JumpIfZero:
+        {
+            bool zero = false;
+            dispatch(ins.a.cls, [&](auto tag) { zero = at<decltype(tag)>(ins.a)[0] == 0; });
+            if (zero)
+            {
+                pc = ins.target;
+                continue;
+            }
+            break;
+        }
+        case Op::Loop:
+        {
+            const int64_t start = at<int64_t>(ins.a)[0];
+            const int64_t stop  = at<int64_t>(ins.b)[0];
+            int64_t*      var   = at<int64_t>(ins.dst);
+            for (int64_t i = start; i < stop; ++i)
+            {
+                *var = i;
+                run(pc + 1, ins.target, 1);
+            }
+            pc = ins.target;
+            continue;
+        }
+        case Op::VecLoop:
+        {
+            const int64_t start = at<int64_t>(ins.a)[0];
+            const int64_t stop  = at<int64_t>(ins.b)[0];
+            int64_t*      var   = at<int64_t>(ins.dst);
+            for (const Reg& r : live_ins[ins.slot])
+            {
+                dispatch(
+                    r.cls,
+                    [&](auto tag)
+                    {
+                        auto* lanes = at<decltype(tag)>(r);
+                        std::fill(lanes + 1, lanes + kLanes, lanes[0]);
+                    });
+            }
+            for (int64_t base = start; base < stop; base += kLanes)
+            {
+                const int64_t chunk = std::min(kLanes, stop - base);
+                for (int64_t i = 0; i < chunk; ++i)
+                {
+                    var[i] = base + i;
+                }
+                run(pc + 1, ins.target, chunk);
+            }
+            pc = ins.target;
+            continue;
+        }
+        }
+        ++pc;
+    }
+}
+
+namespace
+{
+
+// Lowers a statement into a BytecodeProgram.
+//
+// Expressions get a fresh register per node, and constants one register per
+// value, written at compile time. Registers are never reused: a kernel needs a
+// few hundred at most. Integer arithmetic runs in 64 bits; Byte, Char and Short
+// results, whose wrap-around is defined, are narrowed after each operation.
+class BytecodeCompiler : public IRVisitor
+{
+public:
+    explicit BytecodeCompiler(BytecodeProgram& program) : program_(program) {}
+
+    void compile(const std::vector<CodeGen::BufferArg>& args, const StmtPtr& stmt)
+    {
+        for (const auto& arg : args)
+        {
+            if (arg.isVar())
+            {
+                Reg r             = program_.newReg(classOf(arg.dtype()));
+                vars_[arg.var()] = r;
+                program_.arg_slots.push_back(-1);
+                program_.arg_regs.push_back(r);
+            }
+            else
+            {
+                program_.arg_slots.push_back(slotOf(arg.buf()));
+                program_.arg_regs.emplace_back();
+            }
+        }
+
+        stmt->accept(this);
+
+        program_.buffers.assign(slots_.size(), nullptr);
+        program_.storage.resize(slots_.size());
+        program_.allocateRegisters();
+        for (const auto& [value, r] : int_consts_)
+        {
+            program_.at<int64_t>(r)[0] = value;
+        }
+        for (const auto& [bits, r] : float_consts_)
+        {
+            memcpy(program_.at<float>(r), &bits, sizeof(float));
+        }
+        for (const auto& [bits, r] : double_consts_)
+        {
+            memcpy(program_.at<double>(r), &bits, sizeof(double));
+        }
+    }
+
+    void visit(const AddPtr& v) override { binary(v, Op::Add); }
+    void visit(const SubPtr& v) override { binary(v, Op::Sub); }
+    void visit(const MulPtr& v) override { binary(v, Op::Mul); }
+    void visit(const DivPtr& v) override { binary(v, Op::Div); }
+    void visit(const ModPtr& v) override { binary(v, Op::Mod); }
+    void visit(const MaxPtr& v) override { binary(v, Op::Max); }
+    void visit(const MinPtr& v) override { binary(v, Op::Min); }
+    void visit(const AndPtr& v) override { binary(v, Op::And); }
+    void visit(const OrPtr& v) override { binary(v, Op::Or); }
+    void visit(const XorPtr& v) override { binary(v, Op::Xor); }
+    void visit(const LshiftPtr& v) override { binary(v, Op::Shl); }
+    void visit(const RshiftPtr& v) override { binary(v, Op::Shr); }
+
+    void visit(const CompareSelectPtr& v) override
+    {
+        Reg lhs = compile(v->lhs());
+        Reg rhs = compile(v->rhs());
+        Reg t   = compile(v->ret_val1());
+        Reg f   = compile(v->ret_val2());
+        if (lhs.cls != rhs.cls || t.cls != f.cls)
+        {
+            throw malformed_input("bad dtype in CompareSelect", v);
+        }
+
+        Op op = Op::CmpNE;
+        switch (v->compare_select_op())
+        {
+        case CompareSelectOperation::kEQ:
+            op = Op::CmpEQ;
+            break;
+        case CompareSelectOperation::kGT:
+            op = Op::CmpGT;
+            break;
+        case CompareSelectOperation::kGE:
+            op = Op::CmpGE;
+            break;
+        case CompareSelectOperation::kLT:
+            op = Op::CmpLT;
+            break;
+        case CompareSelectOperation::kLE:
+            op = Op::CmpLE;
+            break;
+        case CompareSelectOperation::kNE:
+            op = Op::CmpNE;
+            break;
+        }
+        Reg cond = emit(op, program_.newReg(RegClass::Int), lhs, rhs);
+
+        // The usual comparison to a boolean needs no select
+        if (t.cls == RegClass::Int && t.idx == constInt(1).idx && f.idx == constInt(0).idx)
+        {
+            result_ = cond;
+            return;
+        }
+        result_ = emit(Op::Select, program_.newReg(t.cls), t, f, cond);
+    }
+
+#define IMM_VISIT(Type, Name) \
+    void visit(const Name##ImmPtr& v) override { result_ = constInt(int64_t(v->value())); }
+    AT_FORALL_INT_TYPES(IMM_VISIT)
+    IMM_VISIT(bool, Bool)
+#undef IMM_VISIT
+
+    void visit(const FloatImmPtr& v) override { result_ = constFloat(v->value()); }
+    void visit(const DoubleImmPtr& v) override { result_ = constDouble(v->value()); }
+    void visit(const HalfImmPtr& v) override { throw unsupported_ir("Half"); }
+    void visit(const BFloat16ImmPtr& v) override { throw unsupported_ir("BFloat16"); }
+
+    void visit(const CastPtr& v) override
+    {
+        Reg   src       = compile(v->src_value());
+        Dtype dst_dtype = v->dtype();
+        if (v->src_value()->dtype() == dst_dtype)
+        {
+            result_ = src;
+            return;
+        }
+        Instr ins = instr(Op::Cast, program_.newReg(classOf(dst_dtype)), src);
+        ins.type  = dst_dtype.scalar_type();
+        result_   = push(ins);
+    }
+
+    void visit(const VarPtr& v) override
+    {
+        auto it = vars_.find(v);
+        if (it == vars_.end())
+        {
+            throw unsupported_ir("unbound Var " + v->name_hint());
+        }
+        result_ = it->second;
+    }
+
+    void visit(const LoadPtr& v) override
+    {
+        BufPtr  buf   = v->buf();
+        int32_t slot  = boundSlot(buf);
+        ExprPtr index = flatten_index(buf->dims(), v->indices(), buf->strides());
+        Instr   ins   = instr(Op::Load, program_.newReg(classOf(v->dtype())), indexReg(index));
+        ins.c         = mask_;
+        ins.type      = v->dtype().scalar_type();
+        ins.slot      = slot;
+        result_       = push(ins);
+        if (vector_)
+        {
+            accesses_.push_back({buf->base_handle(), index, false});
+        }
+    }
+
+    void visit(const StorePtr& v) override
+    {
+        BufPtr  buf   = v->buf();
+        int32_t slot  = boundSlot(buf);
+        ExprPtr index = flatten_index(buf->dims(), v->indices(), buf->strides());
+        Reg     idx   = indexReg(index);
+        Reg     value = compile(v->value());
+        Instr   ins   = instr(Op::Store, Reg(), idx, value);
+        ins.type      = v->value()->dtype().scalar_type();
+        ins.slot      = slot;
+        push(ins);
+        if (vector_)
+        {
+            accesses_.push_back({buf->base_handle(), index, true});
+        }
+    }
+
+    void visit(const IfThenElsePtr& v) override
+    {
+        Reg      cond = compile(v->condition());
+        RegClass cls  = classOf(v->dtype());
+        if (!vector_)
+        {
+            // Only the selected value is computed: the other may load out of bounds
+            Reg    dst  = program_.newReg(cls);
+            size_t skip = program_.code.size();
+            push(instr(Op::JumpIfZero, Reg(), cond));
+            push(instr(Op::Mov, dst, compile(v->true_value())));
+            size_t done = program_.code.size();
+            push(instr(Op::Jump));
+            program_.code[skip].target = program_.code.size();
+            push(instr(Op::Mov, dst, compile(v->false_value())));
+            program_.code[done].target = program_.code.size();
+            result_                    = dst;
+            return;
+        }
+
+        // Vectorized, both values are computed, each with the loads outside its
+        // lanes masked off
+        Reg zero = cond.cls == RegClass::Int     ? constInt(0)
+                   : cond.cls == RegClass::Float ? constFloat(0)
+                                                 : constDouble(0);
+        Reg taken     = emit(Op::CmpNE, program_.newReg(RegClass::Int), cond, zero);
+        Reg not_taken = emit(Op::CmpEQ, program_.newReg(RegClass::Int), cond, zero);
+        Reg outer     = mask_;
+        mask_ = outer.valid() ? emit(Op::And, program_.newReg(RegClass::Int), outer, taken) : taken;
+        Reg t = compile(v->true_value());
+        mask_ = outer.valid() ? emit(Op::And, program_.newReg(RegClass::Int), outer, not_taken)
+                              : not_taken;
+        Reg f   = compile(v->false_value());
+        mask_   = outer;
+        result_ = emit(Op::Select, program_.newReg(cls), t, f, taken);
+    }
+
+    void visit(const IntrinsicsPtr& v) override
+    {
+        IntrinsicsOp op = v->op_type();
+        if (op == kIsNan)
+        {
+            result_ = push(instr(Op::IsNan, program_.newReg(RegClass::Int), compile(v->param(0))));
+            return;
+        }
+
+        RegClass         cls = classOf(v->dtype());
+        std::vector<Reg> params;
+        for (const ExprPtr& param : v->params())
+        {
+            params.push_back(compile(param));
+            if (params.back().cls != cls)
+            {
+                throw malformed_input("bad dtype in Intrinsics", v);
+            }
+        }
+
+        Instr ins;
+        if (cls == RegClass::Int && op == kAbs && params.size() == 1)
+        {
+            ins = instr(Op::Abs, program_.newReg(cls), params[0]);
+        }
+        else if (cls != RegClass::Int && params.size() == 1)
+        {
+            ins    = instr(Op::Unary, program_.newReg(cls), params[0]);
+            ins.fn = cls == RegClass::Float ? reinterpret_cast<AnyFn>(unaryIntrinsic<float>(op))
+                                            : reinterpret_cast<AnyFn>(unaryIntrinsic<double>(op));
+        }
+        else if (cls != RegClass::Int && params.size() == 2)
+        {
+            ins    = instr(Op::Binary, program_.newReg(cls), params[0], params[1]);
+            ins.fn = cls == RegClass::Float ? reinterpret_cast<AnyFn>(binaryIntrinsic<float>(op))
+                                            : reinterpret_cast<AnyFn>(binaryIntrinsic<double>(op));
+        }
+        if (ins.op != Op::Abs && ins.fn == nullptr)
+        {
+            throw unsupported_ir("intrinsic " + std::to_string(op));
+        }
+        result_ = push(ins);
+    }
+
+    void visit(const BlockPtr& v) override
+    {
+        // Lets are scoped to their block
+        auto outer = vars_;
+        for (const StmtPtr& s : v->stmts())
+        {
+            s->accept(this);
+        }
+        vars_ = std::move(outer);
+    }
+
+    void visit(const LetPtr& v) override
+    {
+        vars_[v->var()] = compile(v->value());
+        if (vector_)
+        {
+            body_lets_.insert(v->var());
+        }
+    }
+
+    void visit(const CondPtr& v) override
+    {
+        if (vector_)
+        {
+            throw not_vectorizable();
+        }
+        Reg    cond = compile(v->condition());
+        size_t skip = program_.code.size();
+        push(instr(Op::JumpIfZero, Reg(), cond));
+        if (v->true_stmt())
+        {
+            v->true_stmt()->accept(this);
+        }
+        if (!v->false_stmt())
+        {
+            program_.code[skip].target = program_.code.size();
+            return;
+        }
+        size_t done = program_.code.size();
+        push(instr(Op::Jump));
+        program_.code[skip].target = program_.code.size();
+        v->false_stmt()->accept(this);
+        program_.code[done].target = program_.code.size();
+    }
+
+    void visit(const ForPtr& v) override
+    {
+        if (vector_)
+        {
+            throw not_vectorizable();
+        }
+        Reg start = indexReg(v->start());
+        Reg stop  = indexReg(v->stop());
+        Reg var   = program_.newReg(RegClass::Int);
+        if (!v->body())
+        {
+            return;
+        }
+
+        auto outer       = vars_;
+        vars_[v->var()] = var;
+        if (straightLine(v->body()))
+        {
+            size_t at = program_.code.size();
+            push(instr(Op::VecLoop, var, start, stop));
+            vector_   = true;
+            loop_var_ = v->var();
+            try
+            {
+                v->body()->accept(this);
+                program_.code[at].slot   = liveIns(at, var);
+                program_.code[at].target = program_.code.size();
+                checkAccesses();
+                vector_ = false;
+                accesses_.clear();
+                body_lets_.clear();
+                vars_ = std::move(outer);
+                return;
+            }
+            catch (const not_vectorizable&)
+            {
+                if (program_.code[at].slot >= 0)
+                {
+                    program_.live_ins.pop_back();
+                }
+                program_.code.resize(at);
+                vector_ = false;
+                mask_   = Reg();
+                accesses_.clear();
+                body_lets_.clear();
+                vars_           = outer;
+                vars_[v->var()] = var;
+            }
+        }
+
+        size_t at = program_.code.size();
+        push(instr(Op::Loop, var, start, stop));
+        v->body()->accept(this);
+        program_.code[at].target = program_.code.size();
+        vars_                    = std::move(outer);
+    }
+
+    void visit(const AllocatePtr& v) override
+    {
+        if (vector_)
+        {
+            throw not_vectorizable();
+        }
+        BufPtr     buf   = v->buf();
+        ExprHandle bytes = LongImm::make(buf->dtype().byte_size());
+        for (const ExprPtr& dim : buf->dims())
+        {
+            bytes = bytes * cast<int64_t>(ExprHandle(dim));
+        }
+        Instr ins = instr(Op::Alloc, Reg(), compile(bytes.node()));
+        ins.slot  = slotOf(buf);
+        push(ins);
+    }
+
+    void visit(const FreePtr& v) override
+    {
+        if (vector_)
+        {
+            throw not_vectorizable();
+        }
+        Instr ins = instr(Op::Free);
+        ins.slot  = boundSlot(v->buf());
+        push(ins);
+    }
+
+    void visit(const BitCastPtr& v) override { throw unsupported_ir("BitCast"); }
+    void visit(const BufPtr& v) override { throw unsupported_ir("Buf"); }
+    void visit(const RampPtr& v) override { throw unsupported_ir("Ramp"); }
+    void visit(const BroadcastPtr& v) override { throw unsupported_ir("Broadcast"); }
+    void visit(const FreeExtPtr& v) override { throw unsupported_ir("FreeExt"); }
+    void visit(const PlacementAllocatePtr& v) override
+    {
+        throw unsupported_ir("PlacementAllocate");
+    }
+    void visit(const TermPtr& v) override { throw unsupported_ir("Term"); }
+    void visit(const PolynomialPtr& v) override { throw unsupported_ir("Polynomial"); }
+    void visit(const RoundOffPtr& v) override { throw unsupported_ir("RoundOff"); }
+    void visit(const MaxTermPtr& v) override { throw unsupported_ir("MaxTerm"); }
+    void visit(const MinTermPtr& v) override { throw unsupported_ir("MinTerm"); }
+    void visit(const ReduceOpPtr& v) override { throw unsupported_ir("ReduceOp"); }
+    void visit(const AtomicAddPtr& v) override { throw unsupported_ir("AtomicAdd"); }
+    void visit(const SyncThreadsPtr& v) override { throw unsupported_ir("SyncThreads"); }
+    void visit(const ExternalCallPtr& v) override { throw unsupported_ir("ExternalCall"); }
+    void visit(const ExternalCallWithAllocPtr& v) override
+    {
+        throw unsupported_ir("ExternalCallWithAlloc");
+    }
+
+private:
+    struct Access
+    {
+        VarPtr  base;
+        ExprPtr index;
+        bool    store;
+    };
+
+    static Instr instr(Op op, Reg dst = Reg(), Reg a = Reg(), Reg b = Reg(), Reg c = Reg())
+    {
+        Instr ins;
+        ins.op  = op;
+        ins.dst = dst;
+        ins.a   = a;
+        ins.b   = b;
+        ins.c   = c;
+        return ins;
+    }
+
+    Reg push(const Instr& ins)
+    {
+        program_.code.push_back(ins);
+        return ins.dst;
+    }
+
+    Reg emit(Op op, Reg dst, Reg a, Reg b, Reg c = Reg()) { return push(instr(op, dst, a, b, c)); }
+
+    Reg compile(const ExprPtr& e)
+    {
+        e->accept(this);
+        return result_;
+    }
+
+    Reg indexReg(const ExprPtr& e)
+    {
+        Reg r = compile(e);
+        if (r.cls != RegClass::Int)
+        {
+            throw malformed_input("index must be integral", e);
+        }
+        return r;
+    }
+
+    template <typename NodePtrT>
+    void binary(const NodePtrT& v, Op op)
+    {
+        Reg lhs = compile(v->lhs());
+        Reg rhs = compile(v->rhs());
+        if (lhs.cls != rhs.cls)
+        {
+            throw malformed_input("bad dtype in binary op", v);
+        }
+        ScalarType type    = v->dtype().scalar_type();
+        bool       bitwise = op == Op::And || op == Op::Or || op == Op::Xor || op == Op::Shl ||
+                       op == Op::Shr;
+        if ((bitwise && lhs.cls != RegClass::Int) || (!bitwise && type == ScalarType::Bool))
+        {
+            // SimpleIREvaluator computes Bool arithmetic in Byte
+            throw unsupported_ir("binary op on " + std::to_string(type));
+        }
+        if (vector_ && mask_.valid() && lhs.cls == RegClass::Int &&
+            (op == Op::Div || op == Op::Mod))
+        {
+            // A masked-off lane may divide by zero
+            throw not_vectorizable();
+        }
+        result_ = emit(op, program_.newReg(lhs.cls), lhs, rhs);
+
+        bool narrow = type == ScalarType::Byte || type == ScalarType::Char ||
+                      type == ScalarType::Short || (type == ScalarType::Int && op == Op::Shl);
+        if (narrow && (op == Op::Add || op == Op::Sub || op == Op::Mul || op == Op::Shl))
+        {
+            Instr ins = instr(Op::Cast, program_.newReg(RegClass::Int), result_);
+            ins.type  = type;
+            result_   = push(ins);
+        }
+    }
+
+    Reg constInt(int64_t value)
+    {
+        auto it = int_consts_.find(value);
+        if (it == int_consts_.end())
+        {
+            it = int_consts_.emplace(value, program_.newReg(RegClass::Int)).first;
+        }
+        return it->second;
+    }
+
+    Reg constFloat(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        auto it = float_consts_.find(bits);
+        if (it == float_consts_.end())
+        {
+            it = float_consts_.emplace(bits, program_.newReg(RegClass::Float)).first;
+        }
+        return it->second;
+    }
+
+    Reg constDouble(double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        auto it = double_consts_.find(bits);
+        if (it == double_consts_.end())
+        {
+            it = double_consts_.emplace(bits, program_.newReg(RegClass::Double)).first;
+        }
+        return it->second;
+    }
+
+    int32_t slotOf(const BufPtr& buf)
+    {
+        auto it = slots_.find(buf);
+        if (it == slots_.end())
+        {
+            it = slots_.emplace(buf, static_cast<int32_t>(slots_.size())).first;
+        }
+        return it->second;
+    }
+
+    // A buffer must be an argument or allocated before it is used
+    int32_t boundSlot(const BufPtr& buf)
+    {
+        auto it = slots_.find(buf);
+        if (it == slots_.end())
+        {
+            throw unsupported_ir("unbound buffer " + buf->name_hint());
+        }
+        return it->second;
+    }
+
+    static bool straightLine(const StmtPtr& s)
+    {
+        if (auto block = to<Block>(s))
+        {
+            for (const StmtPtr& child : block->stmts())
+            {
+                if (!straightLine(child))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return to<Store>(s) != nullptr || to<Let>(s) != nullptr;
+    }
+
+    // The registers the body of the VecLoop at `at` reads before writing them:
+    // they hold a scalar in their first lane, broadcast once before the loop
+    int32_t liveIns(size_t at, Reg var)
+    {
+        std::unordered_set<uint64_t> written{var.key()};
+        std::unordered_set<uint64_t> read;
+        std::vector<Reg>             live;
+        for (size_t pc = at + 1; pc < program_.code.size(); ++pc)
+        {
+            const Instr& ins = program_.code[pc];
+            for (const Reg& r : {ins.a, ins.b, ins.c})
+            {
+                if (r.valid() && !written.count(r.key()) && read.insert(r.key()).second)
+                {
+                    live.push_back(r);
+                }
+            }
+            if (ins.dst.valid())
+            {
+                if (read.count(ins.dst.key()) && !written.count(ins.dst.key()))
+                {
+                    // Carried from the previous iteration
+                    throw not_vectorizable();
+                }
+                written.insert(ins.dst.key());
+            }
+        }
+        program_.live_ins.push_back(std::move(live));
+        return static_cast<int32_t>(program_.live_ins.size() - 1);
+    }
+
+    // The coefficient of the vectorized loop variable in an index, if the index
+    // is affine in it
+    std::optional<int64_t> stride(const ExprPtr& e) const
+    {
+        if (auto var = to<Var>(e))
+        {
+            if (var == loop_var_)
+            {
+                return 1;
+            }
+            return body_lets_.count(var) ? std::nullopt : std::optional<int64_t>(0);
+        }
+        if (intValue(e))
+        {
+            return 0;
+        }
+        if (auto c = to<Cast>(e))
+        {
+            return stride(c->src_value());
+        }
+        if (auto add = to<Add>(e))
+        {
+            auto lhs = stride(add->lhs());
+            auto rhs = stride(add->rhs());
+            return lhs && rhs ? std::optional<int64_t>(*lhs + *rhs) : std::nullopt;
+        }
+        if (auto sub = to<Sub>(e))
+        {
+            auto lhs = stride(sub->lhs());
+            auto rhs = stride(sub->rhs());
+            return lhs && rhs ? std::optional<int64_t>(*lhs - *rhs) : std::nullopt;
+        }
+        if (auto mul = to<Mul>(e))
+        {
+            auto lhs = stride(mul->lhs());
+            auto rhs = stride(mul->rhs());
+            if (!lhs || !rhs)
+            {
+                return std::nullopt;
+            }
+            if (*lhs == 0 && *rhs == 0)
+            {
+                return 0;
+            }
+            if (auto k = intValue(mul->lhs()))
+            {
+                return *k * *rhs;
+            }
+            if (auto k = intValue(mul->rhs()))
+            {
+                return *lhs * *k;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Lanes run interleaved, so a buffer the body stores to may only be
+    // accessed at one index, distinct in every iteration
+    void checkAccesses()
+    {
+        HashProvider hasher;
+        for (const Access& st : accesses_)
+        {
+            if (!st.store)
+            {
+                continue;
+            }
+            auto s = stride(st.index);
+            if (!s || *s == 0)
+            {
+                throw not_vectorizable();
+            }
+            SimplifierHashType index = hasher.hash(st.index);
+            for (const Access& other : accesses_)
+            {
+                if (other.base == st.base && !(hasher.hash(other.index) == index))
+                {
+                    throw not_vectorizable();
+                }
+            }
+        }
+    }
+
+    BytecodeProgram&                      program_;
+    Reg                                   result_;
+    std::unordered_map<VarPtr, Reg>       vars_;
+    std::unordered_map<BufPtr, int32_t>   slots_;
+    std::unordered_map<int64_t, Reg>      int_consts_;
+    std::unordered_map<uint32_t, Reg>     float_consts_;
+    std::unordered_map<uint64_t, Reg>     double_consts_;
+
+    // State of the innermost loop being vectorized
+    bool                       vector_ = false;
+    VarPtr                     loop_var_;
+    Reg                        mask_;
+    std::vector<Access>        accesses_;
+    std::unordered_set<VarPtr> body_lets_;
+};
+
+}  // namespace
+
+BytecodeEvaluator::BytecodeEvaluator(
+    StmtPtr                       stmt,
+    const std::vector<BufferArg>& buffer_args,
+    quarisma::Device                device,
+    const std::string&            kernel_func_name)
+    : CodeGen(std::move(stmt), buffer_args, device, kernel_func_name)
+{
+    GenericIntrinsicsExpander intrinsics_expander;
+    apply_mutator(&intrinsics_expander);
+
+    program_ = std::make_unique<BytecodeProgram>();
+    try
+    {
+        BytecodeCompiler compiler(*program_);
+        compiler.compile(this->buffer_args(), this->stmt());
+    }
+    catch (const std::exception& e)
+    {
+        GRAPH_DEBUG("BytecodeEvaluator falls back to SimpleIREvaluator: ", e.what());
+        program_.reset();
+        fallback_ = std::make_unique<SimpleIREvaluator>(
+            this->stmt(), this->buffer_args(), device, kernel_func_name);
+    }
+}
+
+BytecodeEvaluator::~BytecodeEvaluator() = default;
+
+void BytecodeEvaluator::call(const std::vector<CallArg>& args)
+{
+    std::vector<void*> raw_args(args.size());
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        raw_args[i] = argToPtr(buffer_args()[i], args[i]);
+    }
+    call_raw(raw_args);
+}
+
+void BytecodeEvaluator::call_raw(const std::vector<void*>& args)
+{
+    if (fallback_)
+    {
+        fallback_->call_raw(args);
+        return;
+    }
+    if (args.size() != buffer_args().size())
+    {
+        throw malformed_input("bad args in BytecodeEvaluator call");
+    }
+    program_->bind(buffer_args(), args);
+    try
+    {
+        program_->run(0, program_->code.size(), 1);
+    }
+    catch (...)
+    {
+        program_->unbind();
+        throw;
+    }
+    program_->unbind();
+}
+
+}  // namespace torch::jit::tensorexpr
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <torch/csrc/jit/tensorexpr/codegen.h>
+#include <torch/csrc/jit/tensorexpr/eval.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace torch::jit::tensorexpr
+{
+
+class BytecodeProgram;
+
+// Runs a statement on the CPU without LLVM.
+//
+// The statement is lowered once, at construction, into a flat array of
+// register-based instructions, so a call runs a switch per instruction instead
+// of a visitor and a heap-allocated InterpValue per IR node. Every register
+// holds a column of values: the innermost loops whose bodies are straight-line
+// stores are vectorized, running each instruction on a chunk of iterations at
+// once. Loops carrying a dependency through memory run one iteration at a time.
+//
+// Statements the lowering does not cover (vector dtypes, Half and BFloat16,
+// external calls, atomics...) run on a SimpleIREvaluator instead.
+class TORCH_API BytecodeEvaluator : public CodeGen
+{
+public:
+    BytecodeEvaluator(
+        StmtPtr                       stmt,
+        const std::vector<BufferArg>& buffer_args,
+        quarisma::Device                device           = quarisma::kCPU,
+        const std::string&            kernel_func_name = "func");
+
+    ~BytecodeEvaluator() override;
+
+    void call(const std::vector<CallArg>& args) override;
+    void call_raw(const std::vector<void*>& args) override;
+
+    template <typename... Ts>
+    void operator()(const Ts&... ts)
+    {
+        std::vector<CallArg> args({CallArg(ts)...});
+        call(args);
+    }
+
+    // False if the statement runs on the SimpleIREvaluator fallback.
+    bool compiled() const { return program_ != nullptr; }
+
+private:
+    std::unique_ptr<BytecodeProgram>   program_;
+    std::unique_ptr<SimpleIREvaluator> fallback_;
+};
+
+}  // namespace torch::jit::tensorexpr
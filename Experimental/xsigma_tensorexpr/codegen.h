@@ -4,6 +4,7 @@
 #include <torch/csrc/jit/tensorexpr/ir.h>
 #include <torch/csrc/jit/tensorexpr/tensor.h>
 
+#include <string>
 #include <utility>
 
 namespace torch::jit::tensorexpr
@@ -65,6 +66,18 @@ public:
     /// a simple division, rather than evaluating an expression.
     virtual void call_with_numel(void** args, int64_t numel);
 
+    /// Launch parameters of highest occupancy of the compiled kernel, as
+    /// cudaOccupancyMaxPotentialBlockSize returns them, for backends that
+    /// launch thread blocks.
+    struct LaunchHint
+    {
+        int         blockSize = -1;  // Threads per block
+        int         gridSize  = -1;  // Blocks resident at once on the device
+        std::string device;          // Identifies the device, for cache keys
+    };
+
+    virtual LaunchHint launchHint() { return {}; }
+
     virtual quarisma::Tensor empty_strided(
         quarisma::IntArrayRef               size,
         quarisma::IntArrayRef               stride,
@@ -6,6 +6,7 @@
 #include <torch/csrc/jit/jit_log.h>
 #include <torch/csrc/jit/tensorexpr/analysis.h>
 #include <torch/csrc/jit/tensorexpr/cuda_codegen.h>
+#include <torch/csrc/jit/tensorexpr/cuda_kernel_cache.h>
 #include <torch/csrc/jit/tensorexpr/cuda_random.h>
 #include <torch/csrc/jit/tensorexpr/eval.h>
 #include <torch/csrc/jit/tensorexpr/exceptions.h>
@@ -21,6 +22,7 @@
 #include <Quarisma/ops/empty_strided_native.h>
 #endif
 
+#include <sstream>
 #include <unordered_map>
 #include <utility>
 
@@ -1469,6 +1471,27 @@ void CudaCodeGen::CompileToNVRTC(const std::string& code, const std::string& fun
     bool            compile_to_sass = false;
     fuser::cuda::codegenOutputQuery(prop, major, minor, compile_to_sass);
 
+    // The image depends on the code, the target and the NVRTC release
+    int nvrtc_major = 0, nvrtc_minor = 0;
+    AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+    std::ostringstream cache_key;
+    cache_key << "cuda_cache_version=" << kCudaKernelCacheVersion << ";nvrtc=" << nvrtc_major
+              << "." << nvrtc_minor << ";arch=" << (compile_to_sass ? "sm_" : "compute_")
+              << major << minor << ";func=" << func_name << ";code=" << code;
+    const auto& cache_dir = CudaKernelCacheDir();
+    if (cache_dir)
+    {
+        if (auto image = loadCachedCudaImage(*cache_dir, cache_key.str()))
+        {
+            LoadModule(image->data(), func_name);
+            if (prior_device != this->device().index())
+            {
+                quarisma::cuda::set_device(prior_device);
+            }
+            return;
+        }
+    }
+
     // Creates the NVRTC program
     nvrtcProgram program{nullptr};
     AT_CUDA_NVRTC_CHECK(
@@ -1527,15 +1550,65 @@ void CudaCodeGen::CompileToNVRTC(const std::string& code, const std::string& fun
     AT_CUDA_NVRTC_CHECK(getSize(program, &ptx_size));
     ptx.resize(ptx_size);
     AT_CUDA_NVRTC_CHECK(getFunc(program, ptx.data()));
+    if (cache_dir)
+    {
+        storeCachedCudaImage(*cache_dir, cache_key.str(), std::string(ptx.data(), ptx.size()));
+    }
+
+    LoadModule(ptx.data(), func_name);
 
+    if (prior_device != this->device().index())
+    {
+        quarisma::cuda::set_device(prior_device);
+    }
+}
+
+void CudaCodeGen::LoadModule(const char* image, const std::string& func_name)
+{
     CUmodule module{nullptr};
-    AT_CUDA_DRIVER_CHECK(nvrtc().cuModuleLoadData(&module, ptx.data()));
+    AT_CUDA_DRIVER_CHECK(nvrtc().cuModuleLoadData(&module, image));
     AT_CUDA_DRIVER_CHECK(nvrtc().cuModuleGetFunction(&function_, module, func_name.c_str()));
+}
 
-    if (prior_device != this->device().index())
+CodeGen::LaunchHint CudaCodeGen::launchHint()
+{
+    const auto device       = this->device().index();
+    const auto prior_device = quarisma::cuda::current_device();
+    if (prior_device != device)
+    {
+        quarisma::cuda::set_device(device);
+    }
+
+    cudaDeviceProp* prop        = quarisma::cuda::getCurrentDeviceProperties();
+    int             max_threads = 0;
+    AT_CUDA_DRIVER_CHECK(nvrtc().cuFuncGetAttribute(
+        &max_threads, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, function_));
+
+    // The largest block size of highest occupancy, the choice of
+    // cudaOccupancyMaxPotentialBlockSize, which only takes a runtime kernel
+    LaunchHint hint;
+    int        best_threads = 0;
+    for (int block_size = max_threads - max_threads % prop->warpSize; block_size > 0;
+         block_size -= prop->warpSize)
+    {
+        int blocks = 0;
+        AT_CUDA_DRIVER_CHECK(nvrtc().cuOccupancyMaxActiveBlocksPerMultiprocessor(
+            &blocks, function_, block_size, 0));
+        if (blocks * block_size > best_threads)
+        {
+            best_threads   = blocks * block_size;
+            hint.blockSize = block_size;
+            hint.gridSize  = blocks * prop->multiProcessorCount;
+        }
+    }
+    hint.device = std::string(prop->name) + " sm_" + std::to_string(prop->major) +
+                  std::to_string(prop->minor);
+
+    if (prior_device != device)
     {
         quarisma::cuda::set_device(prior_device);
     }
+    return hint;
 }
 
 CudaCodeGen::~CudaCodeGen() = default;
@@ -204,6 +204,8 @@ public:
     void call_raw(const std::vector<void*>& args) override;
     void call_with_numel(void** args, int64_t numel) override;
 
+    LaunchHint launchHint() override;
+
     template <typename... Ts>
     void operator()(const Ts&... ts)
     {
@@ -235,6 +237,9 @@ private:
 
     void CompileToNVRTC(const std::string& code, const std::string& func_name);
 
+    // Loads the PTX or CUBIN image and looks up func_name in it
+    void LoadModule(const char* image, const std::string& func_name);
+
     UniqueNameManager* name_manager()
     {
         if (!printer_)
@@ -0,0 +1,154 @@
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/tensorexpr/cuda_kernel_cache.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include "util/env.h"
+
+namespace torch::jit::tensorexpr
+{
+
+namespace
+{
+
+constexpr char kEntryMagic[8] = {'Q', 'T', 'E', 'C', 'U', 'D', 'A', '1'};
+
+// FNV-1a, stable across builds and runs, unlike std::hash
+uint64_t hashKey(const std::string& key)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key)
+    {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string entryPath(const std::string& dir, const std::string& key, const char* extension)
+{
+    std::ostringstream path;
+    path << dir << "/" << std::hex << hashKey(key) << extension;
+    return path.str();
+}
+
+bool readSized(std::istream& in, std::string& out)
+{
+    uint64_t size = 0;
+    if (!in.read(reinterpret_cast<char*>(&size), sizeof(size)))
+    {
+        return false;
+    }
+    out.resize(size);
+    return static_cast<bool>(in.read(out.data(), static_cast<std::streamsize>(size)));
+}
+
+void writeSized(std::ostream& out, const std::string& bytes)
+{
+    const uint64_t size = bytes.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::optional<std::string> loadEntry(const std::string& path, const std::string& key)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return std::nullopt;
+    }
+
+    char        magic[sizeof(kEntryMagic)];
+    std::string storedKey;
+    std::string payload;
+    if (!in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, kEntryMagic, sizeof(kEntryMagic)) != 0 || !readSized(in, storedKey) ||
+        storedKey != key || !readSized(in, payload))
+    {
+        GRAPH_DEBUG("Ignoring kernel cache entry ", path);
+        return std::nullopt;
+    }
+    GRAPH_DEBUG("Loaded kernel cache entry ", path);
+    return payload;
+}
+
+void storeEntry(
+    const std::string& dir,
+    const std::string& path,
+    const std::string& key,
+    const std::string& payload)
+{
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error)
+    {
+        GRAPH_DEBUG("Cannot create kernel cache directory ", dir);
+        return;
+    }
+
+    // Unique per writer, so that concurrent stores of one key do not interleave
+    static std::atomic<uint64_t> writers{0};
+    const auto writer = std::hash<std::thread::id>{}(std::this_thread::get_id()) ^
+                        static_cast<uint64_t>(
+                            std::chrono::steady_clock::now().time_since_epoch().count());
+    const std::string tmp = path + ".tmp" + std::to_string(writer) + "." +
+                            std::to_string(writers.fetch_add(1, std::memory_order_relaxed));
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(kEntryMagic, sizeof(kEntryMagic));
+        writeSized(out, key);
+        writeSized(out, payload);
+        if (!out.flush())
+        {
+            GRAPH_DEBUG("Cannot write kernel cache entry ", tmp);
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        GRAPH_DEBUG("Cannot rename kernel cache entry to ", path);
+        std::remove(tmp.c_str());
+    }
+}
+
+}  // namespace
+
+std::optional<std::string>& CudaKernelCacheDir()
+{
+    static std::optional<std::string> dir =
+        quarisma::utils::get_env("QUARISMA_TENSOREXPR_KERNEL_CACHE_DIR");
+    return dir;
+}
+
+std::optional<std::string> loadCachedCudaImage(const std::string& dir, const std::string& key)
+{
+    return loadEntry(entryPath(dir, key, ".cubin"), key);
+}
+
+void storeCachedCudaImage(const std::string& dir, const std::string& key, const std::string& image)
+{
+    storeEntry(dir, entryPath(dir, key, ".cubin"), key, image);
+}
+
+std::optional<std::string> loadCachedLaunchSchedule(const std::string& dir, const std::string& key)
+{
+    return loadEntry(entryPath(dir, key, ".launch"), key);
+}
+
+void storeCachedLaunchSchedule(
+    const std::string& dir, const std::string& key, const std::string& schedule)
+{
+    storeEntry(dir, entryPath(dir, key, ".launch"), key, schedule);
+}
+
+}  // namespace torch::jit::tensorexpr
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <torch/csrc/Export.h>
+
+#include <optional>
+#include <string>
+
+namespace torch::jit::tensorexpr
+{
+
+// Part of every key. Bump it when CudaCodeGen emits different code for the
+// same Stmt, or a CudaLaunchSchedule changes meaning, so that entries written
+// by older builds are no longer found.
+inline constexpr int kCudaKernelCacheVersion = 1;
+
+/*
+ * On-disk cache of the images NVRTC compiles for CudaCodeGen, and of the
+ * launch schedules picked by the autotuner (see loopnest_autotune.h).
+ *
+ * The entries follow the layout of the LLVM kernel cache: a file named after
+ * a hash of the key holds the key, compared on load so that a collision of
+ * file names is a miss, and is written to a temporary file and renamed, so
+ * processes sharing the directory never read a partial entry. Nothing here
+ * depends on CUDA, so that TensorExprKernel can look up launch schedules
+ * without the CUDA codegen.
+ */
+
+// Directory of the cache, disabled when unset. Defaults to
+// $QUARISMA_TENSOREXPR_KERNEL_CACHE_DIR, shared with the LLVM kernel cache.
+TORCH_API std::optional<std::string>& CudaKernelCacheDir();
+
+// The PTX or CUBIN of a kernel, std::nullopt on a miss or an unreadable entry
+TORCH_API std::optional<std::string> loadCachedCudaImage(
+    const std::string& dir, const std::string& key);
+
+// Failures are not fatal: the kernel is just compiled again next time
+TORCH_API void storeCachedCudaImage(
+    const std::string& dir, const std::string& key, const std::string& image);
+
+// A launch schedule is tuned by running the kernel, so its key must name the
+// device it was timed on
+TORCH_API std::optional<std::string> loadCachedLaunchSchedule(
+    const std::string& dir, const std::string& key);
+
+TORCH_API void storeCachedLaunchSchedule(
+    const std::string& dir, const std::string& key, const std::string& schedule);
+
+}  // namespace torch::jit::tensorexpr
@@ -92,7 +92,14 @@ std::vector<quarisma::Tensor> constructTensors2(
 extern "C"
 {
 #endif
-    void DispatchParallel(int8_t* func, int64_t start, int64_t stop, int8_t* packed_data) noexcept;
+    // Runs func(begin, end, packed_data) over chunks of [start, stop) of at
+    // least grain_size iterations, on the intra-op thread pool.
+    void DispatchParallel(
+        int8_t* func,
+        int64_t start,
+        int64_t stop,
+        int64_t grain_size,
+        int8_t* packed_data) noexcept;
 
     FOR_ALL_EXTERNAL_FUNCTIONS(DECLARE_EXTERNAL_FUNCTION)
 #if AT_MKLDNN_ENABLED()
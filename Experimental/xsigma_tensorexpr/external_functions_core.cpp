@@ -8,8 +8,9 @@ extern "C"
 {
 #endif
 
-    using ParallelCallee = void (*)(int64_t, int8_t*);
-    void DispatchParallel(int8_t* func, int64_t start, int64_t stop, int8_t* packed_data) noexcept
+    using ParallelCallee = void (*)(int64_t, int64_t, int8_t*);
+    void DispatchParallel(
+        int8_t* func, int64_t start, int64_t stop, int64_t grain_size, int8_t* packed_data) noexcept
     {
         // TODO: preserve the func type.
         try
@@ -18,14 +19,8 @@ extern "C"
             quarisma::parallel_for(
                 start,
                 stop,
-                1,
-                [&](int64_t f_begin, int64_t f_end)
-                {
-                    for (int64_t index = f_begin; index < f_end; index++)
-                    {
-                        callee(index, packed_data);
-                    }
-                });
+                grain_size,
+                [&](int64_t f_begin, int64_t f_end) { callee(f_begin, f_end, packed_data); });
         }
         catch (...)
         {
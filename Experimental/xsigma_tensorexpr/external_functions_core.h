@@ -13,7 +13,14 @@ namespace torch::jit::tensorexpr
 extern "C"
 {
 #endif
-    void DispatchParallel(int8_t* func, int64_t start, int64_t stop, int8_t* packed_data) noexcept;
+    // Runs func(begin, end, packed_data) over chunks of [start, stop) of at
+    // least grain_size iterations, on the intra-op thread pool.
+    void DispatchParallel(
+        int8_t* func,
+        int64_t start,
+        int64_t stop,
+        int64_t grain_size,
+        int8_t* packed_data) noexcept;
 
     TORCH_API void nnc_aten_free(size_t bufs_num, void** ptrs) noexcept;
 
@@ -6,17 +6,22 @@
 #include <torch/csrc/jit/passes/mkldnn_rewrite.h>
 #include <torch/csrc/jit/passes/symbolic_shape_runtime_fusion.h>
 #include <torch/csrc/jit/tensorexpr/analysis.h>
+#include <torch/csrc/jit/tensorexpr/cuda_kernel_cache.h>
 #include <torch/csrc/jit/tensorexpr/expr.h>
 #include <torch/csrc/jit/tensorexpr/graph_opt.h>
+#include <torch/csrc/jit/tensorexpr/hash_provider.h>
 #include <torch/csrc/jit/tensorexpr/ir_printer.h>
 #include <torch/csrc/jit/tensorexpr/ir_simplifier.h>
 #include <torch/csrc/jit/tensorexpr/kernel.h>
+#include <torch/csrc/jit/tensorexpr/llvm_codegen.h>
+#include <torch/csrc/jit/tensorexpr/llvm_kernel_cache.h>
 #include <torch/csrc/jit/tensorexpr/loopnest.h>
 #include <torch/csrc/jit/tensorexpr/loopnest_randomization.h>
 #include <torch/csrc/jit/tensorexpr/operators/operators.h>
 #include <quarisma/core/ScalarTypeToTypeMeta.h>
 #include <quarisma/util/irange.h>
 
+#include <sstream>
 #include <utility>
 
 using namespace torch::jit;
@@ -99,6 +104,14 @@ static int64_t randomTransformsRequested()
     return std::stoi(enable_opt.value());
 }
 
+// Interpret with SimpleIREvaluator rather than the bytecode evaluator
+static bool useSimpleIREvalFlag()
+{
+    static const auto enable_opt =
+        quarisma::utils::get_env("PYTORCH_TENSOREXPR_USE_SIMPLE_IR_EVAL");
+    return enable_opt == "1";
+}
+
 #ifdef TORCH_ENABLE_LLVM
 static bool dontUseLLVMFlag()
 {
@@ -149,6 +162,12 @@ bool& getOptConditionals()
     return opt_conditionals;
 }
 
+bool& getTEAutotuneLoopSchedules()
+{
+    static bool autotune = quarisma::utils::get_env("PYTORCH_TENSOREXPR_AUTOTUNE") == "1";
+    return autotune;
+}
+
 std::optional<quarisma::Device> pickDeviceType(const quarisma::ArrayRef<torch::jit::Value*>& inputs)
 {
     std::optional<quarisma::Device> device = std::nullopt;
@@ -953,7 +972,11 @@ static void parallelizeOuterLoops(LoopNest& l, const Bufs& bufs)
     }
 }
 
-StmtPtr TensorExprKernel::transformLoops(BackendType backendType, StmtPtr st)
+StmtPtr TensorExprKernel::transformLoops(
+    BackendType               backendType,
+    StmtPtr                   st,
+    const LoopSchedule*       schedule,
+    const CudaLaunchSchedule* launch)
 {
     torch::jit::tensorexpr::LoopNest l(std::move(st), bufOutputs_);
     LoopNest::sanitizeNames(l.root_stmt());
@@ -1009,8 +1032,16 @@ StmtPtr TensorExprKernel::transformLoops(BackendType backendType, StmtPtr st)
     {
         fuseAllLoops(l.root_stmt());
         GRAPH_DEBUG("after fuse", *l.root_stmt());
-        parallelizeOuterLoops(l, bufsToBeParallelized_);
-        GRAPH_DEBUG("after parallelize", *l.root_stmt());
+        if (!schedule || schedule->parallelize)
+        {
+            parallelizeOuterLoops(l, bufsToBeParallelized_);
+            GRAPH_DEBUG("after parallelize", *l.root_stmt());
+        }
+        if (schedule && schedule->tile > 0)
+        {
+            tileInnerLoops(l, schedule->tile);
+            GRAPH_DEBUG("after tiling", *l.root_stmt());
+        }
     }
 
     if (backendType == kCudaCodeGen)
@@ -1032,6 +1063,12 @@ StmtPtr TensorExprKernel::transformLoops(BackendType backendType, StmtPtr st)
             loopLevels                   = (loopLevels > 0) ? loopLevels : kDefaultLoopLevels;
             int blockCount               = getTECudaPointwiseBlockCount();
             int blockSize                = getTECudaPointwiseBlockSize();
+            if (launch)
+            {
+                loopLevels = launch->loopLevels;
+                blockCount = launch->blockCount;
+                blockSize  = launch->blockSize;
+            }
 
             if (loopLevels == 2)
             {
@@ -1107,11 +1144,35 @@ StmtPtr TensorExprKernel::transformLoops(BackendType backendType, StmtPtr st)
     l.simplify();
     GRAPH_DEBUG("after simplification", *l.root_stmt());
 
-    if (backendType == kLLVMCodeGen && !hasReduction)
+    if (schedule)
+    {
+        // Reduction loops are only expanded by prepareForCodegen
+        if (schedule->interchangeReductions)
+        {
+            interchangeReductionLoops(l);
+            GRAPH_DEBUG("after interchanging reductions", *l.root_stmt());
+        }
+        else if (schedule->registerBlock)
+        {
+            registerBlockReductions(l);
+            GRAPH_DEBUG("after register blocking", *l.root_stmt());
+        }
+        if (schedule->vectorize)
+        {
+            vectorizeIndependentInnerLoops(l);
+            GRAPH_DEBUG("after vectorization", *l.root_stmt());
+        }
+    }
+    else if (backendType == kLLVMCodeGen && !hasReduction)
     {
         l.vectorizeInnerLoops();
         GRAPH_DEBUG("after vectorization", *l.root_stmt());
     }
+    else if (backendType == kLLVMCodeGen)
+    {
+        registerBlockReductions(l);
+        GRAPH_DEBUG("after register blocking", *l.root_stmt());
+    }
 
     StmtPtr stmt = l.root_stmt();
     // Arithmetic Simplification.
@@ -1132,6 +1193,8 @@ std::string TensorExprKernel::getCodeGenName(BackendType backendType)
         return "simple_ir_eval";
     case kBlockCodeGen:
         return "block_codegen";
+    case kBytecodeEval:
+        return "bytecode_eval";
     default:
         throw std::runtime_error(
             "invalid backend type: " + std::to_string(static_cast<int>(backendType)));
@@ -1157,12 +1220,13 @@ TensorExprKernel::BackendType TensorExprKernel::inferBackendTypeFromDevice(quari
     }
     else if (device.type() == quarisma::kCPU)
     {
+        BackendType const interpreter = useSimpleIREvalFlag() ? kSimpleIREval : kBytecodeEval;
 #ifdef TORCH_ENABLE_LLVM
-        backendType = dontUseLLVMFlag() ? kSimpleIREval : kLLVMCodeGen;
+        backendType = dontUseLLVMFlag() ? interpreter : kLLVMCodeGen;
 #else
-        backendType = kSimpleIREval;
+        backendType = interpreter;
 #endif
-        if (getTEMustUseLLVMOnCPU() && backendType == kSimpleIREval)
+        if (getTEMustUseLLVMOnCPU() && backendType != kLLVMCodeGen)
         {
             throw std::runtime_error("LLVM Backend not found");
         }
@@ -2089,8 +2153,21 @@ void TensorExprKernel::compile()
         bufs_.erase(output);
     }
 
-    BackendType backendType = inferBackendTypeFromDevice(device_);
-    stmt_                   = transformLoops(backendType, block);
+    BackendType                       backendType = inferBackendTypeFromDevice(device_);
+    std::optional<LoopSchedule>       schedule;
+    std::optional<CudaLaunchSchedule> launch;
+#ifdef TORCH_ENABLE_LLVM
+    if (backendType == kLLVMCodeGen && getTEAutotuneLoopSchedules())
+    {
+        schedule = tuneLoopSchedule(block);
+    }
+#endif
+    if (backendType == kCudaCodeGen && getTEAutotuneLoopSchedules())
+    {
+        launch = tuneCudaLaunchSchedule(block);
+    }
+    stmt_ = transformLoops(
+        backendType, block, schedule ? &*schedule : nullptr, launch ? &*launch : nullptr);
 
     for (const auto& c : constants_)
     {
@@ -2108,6 +2185,190 @@ void TensorExprKernel::compile()
         CreateCodeGen(getCodeGenName(backendType), stmt_, bufferArgs_, device_, kernel_func_name_);
 }
 
+#ifdef TORCH_ENABLE_LLVM
+std::optional<LoopSchedule> TensorExprKernel::tuneLoopSchedule(const StmtPtr& st)
+{
+    // Tuning runs the kernel on made-up inputs of the profiled shapes
+    if (has_symbolic_shapes_ || pre_alloc_ || hasRandom_)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<CodeGen::BufferArg>   args = bufferArgs_;
+    std::unordered_map<BufPtr, void*> bound;
+    for (const auto& c : constants_)
+    {
+        args.emplace_back(BufHandle(c.buf));
+        bound.emplace(c.buf, c.ptr);
+    }
+
+    // Static shapes are part of the loop bounds, and so of the Stmt hash
+    static const std::string kDefaultSchedule = "default";
+    HashProvider             hasher;
+    std::ostringstream       key;
+    key << "schedule_version=" << kLoopScheduleVersion
+        << ";threads=" << quarisma::get_num_threads()
+        << ";opt_conditionals=" << getOptConditionals() << ";stmt=" << std::hex
+        << hasher.hash(st)._h << ";args=";
+    for (const auto& arg : args)
+    {
+        key << arg.dtype().ToCppString() << " " << hasher.hash(arg.var())._h << ",";
+    }
+    const auto& cacheDir = LLVMKernelCacheDir();
+    if (cacheDir)
+    {
+        if (auto cached = loadCachedSchedule(*cacheDir, key.str()))
+        {
+            if (*cached == kDefaultSchedule)
+            {
+                return std::nullopt;
+            }
+            if (auto schedule = LoopSchedule::parse(*cached))
+            {
+                return schedule;
+            }
+        }
+    }
+
+    const bool hasReduction = !NodeFinder<ReduceOp>::find(st).empty();
+
+    // Candidate 0 is the default schedule, the reference for the outputs
+    const std::vector<LoopSchedule>  schedules = loopScheduleCandidates(hasReduction);
+    std::vector<StmtPtr>             stmts{transformLoops(kLLVMCodeGen, Stmt::clone(st))};
+    std::vector<const LoopSchedule*> stmtSchedules{nullptr};
+    for (const auto& schedule : schedules)
+    {
+        try
+        {
+            stmts.push_back(transformLoops(kLLVMCodeGen, Stmt::clone(st), &schedule));
+            stmtSchedules.push_back(&schedule);
+        }
+        catch (const std::exception& e)
+        {
+            GRAPH_DEBUG("Cannot apply schedule ", schedule.toString(), ": ", e.what());
+        }
+    }
+
+    auto fastest = pickFastestStmt(
+        getCodeGenName(kLLVMCodeGen), stmts, args, bound, bufOutputs_, device_, kernel_func_name_);
+    if (!fastest)
+    {
+        return std::nullopt;
+    }
+    std::optional<LoopSchedule> picked;
+    if (stmtSchedules[*fastest])
+    {
+        picked = *stmtSchedules[*fastest];
+    }
+    const std::string pickedName = picked ? picked->toString() : kDefaultSchedule;
+    GRAPH_DEBUG("Picked schedule ", pickedName, " for ", kernel_func_name_);
+    if (cacheDir)
+    {
+        storeCachedSchedule(*cacheDir, key.str(), pickedName);
+    }
+    return picked;
+}
+#endif
+
+std::optional<CudaLaunchSchedule> TensorExprKernel::tuneCudaLaunchSchedule(const StmtPtr& st)
+{
+    // Tuning runs the kernel on made-up inputs of the profiled shapes
+    if (has_symbolic_shapes_ || pre_alloc_ || hasRandom_)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<CodeGen::BufferArg>   args = bufferArgs_;
+    std::unordered_map<BufPtr, void*> bound;
+    for (const auto& c : constants_)
+    {
+        args.emplace_back(BufHandle(c.buf));
+        bound.emplace(c.buf, c.ptr);
+    }
+
+    // Candidate 0 is the default launch schedule, the reference for the
+    // outputs. Its occupancy is where the search starts, and its device name
+    // is part of the key, since the timings only hold for that device.
+    std::vector<StmtPtr> stmts{transformLoops(kCudaCodeGen, Stmt::clone(st))};
+    CodeGen::LaunchHint  hint;
+    try
+    {
+        hint = CreateCodeGen(
+                   getCodeGenName(kCudaCodeGen), stmts[0], args, device_, kernel_func_name_)
+                   ->launchHint();
+    }
+    catch (const std::exception& e)
+    {
+        GRAPH_DEBUG("Cannot compile ", kernel_func_name_, " for tuning: ", e.what());
+        return std::nullopt;
+    }
+    if (hint.device.empty())
+    {
+        return std::nullopt;
+    }
+
+    static const std::string kDefaultSchedule = "default";
+    HashProvider             hasher;
+    std::ostringstream       key;
+    key << "launch_version=" << kCudaKernelCacheVersion << ";device=" << hint.device
+        << ";opt_conditionals=" << getOptConditionals() << ";stmt=" << std::hex
+        << hasher.hash(st)._h << ";args=";
+    for (const auto& arg : args)
+    {
+        key << arg.dtype().ToCppString() << " " << hasher.hash(arg.var())._h << ",";
+    }
+    const auto& cacheDir = CudaKernelCacheDir();
+    if (cacheDir)
+    {
+        if (auto cached = loadCachedLaunchSchedule(*cacheDir, key.str()))
+        {
+            if (*cached == kDefaultSchedule)
+            {
+                return std::nullopt;
+            }
+            if (auto launch = CudaLaunchSchedule::parse(*cached))
+            {
+                return launch;
+            }
+        }
+    }
+
+    const std::vector<CudaLaunchSchedule> launches =
+        cudaLaunchScheduleCandidates(hint.blockSize, hint.gridSize);
+    std::vector<const CudaLaunchSchedule*> stmtLaunches{nullptr};
+    for (const auto& launch : launches)
+    {
+        try
+        {
+            stmts.push_back(transformLoops(kCudaCodeGen, Stmt::clone(st), nullptr, &launch));
+            stmtLaunches.push_back(&launch);
+        }
+        catch (const std::exception& e)
+        {
+            GRAPH_DEBUG("Cannot apply launch schedule ", launch.toString(), ": ", e.what());
+        }
+    }
+
+    auto fastest = pickFastestStmt(
+        getCodeGenName(kCudaCodeGen), stmts, args, bound, bufOutputs_, device_, kernel_func_name_);
+    if (!fastest)
+    {
+        return std::nullopt;
+    }
+    std::optional<CudaLaunchSchedule> picked;
+    if (stmtLaunches[*fastest])
+    {
+        picked = *stmtLaunches[*fastest];
+    }
+    const std::string pickedName = picked ? picked->toString() : kDefaultSchedule;
+    GRAPH_DEBUG("Picked launch schedule ", pickedName, " for ", kernel_func_name_);
+    if (cacheDir)
+    {
+        storeCachedLaunchSchedule(*cacheDir, key.str(), pickedName);
+    }
+    return picked;
+}
+
 void TensorExprKernel::recompile()
 {
     codegen_ = CreateCodeGen("llvm_codegen", stmt_, bufferArgs_, device_, kernel_func_name_);
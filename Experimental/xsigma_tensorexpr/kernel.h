@@ -6,6 +6,7 @@
 #include <torch/csrc/jit/runtime/interpreter.h>
 #include <torch/csrc/jit/tensorexpr/analysis.h>
 #include <torch/csrc/jit/tensorexpr/codegen.h>
+#include <torch/csrc/jit/tensorexpr/loopnest_autotune.h>
 #include <torch/csrc/jit/tensorexpr/lowerings.h>
 #include <torch/csrc/jit/tensorexpr/tensor.h>
 
@@ -208,6 +209,7 @@ private:
         kLLVMCodeGen,
         kCudaCodeGen,
         kBlockCodeGen,
+        kBytecodeEval,
     };
 
     enum MemoryLayoutPolicy
@@ -234,7 +236,23 @@ private:
 
     void bindConstant(const torch::jit::Value* v);
 
-    StmtPtr transformLoops(BackendType backendType, StmtPtr st);
+    // Without a schedule, the loops get the default CPU schedule. Without a
+    // launch schedule, CUDA kernels get the launch configuration set by
+    // getTECudaPointwiseLoopLevels and friends.
+    StmtPtr transformLoops(
+        BackendType               backendType,
+        StmtPtr                   st,
+        const LoopSchedule*       schedule = nullptr,
+        const CudaLaunchSchedule* launch   = nullptr);
+
+    // Times the candidate schedules of the LLVM kernel built from st, or
+    // loads the fastest one from the kernel cache. std::nullopt when the
+    // kernel cannot be tuned, or the default schedule is the fastest.
+    std::optional<LoopSchedule> tuneLoopSchedule(const StmtPtr& st);
+
+    // Same for the launch schedule of the CUDA kernel built from st, starting
+    // from the launch configuration of highest occupancy
+    std::optional<CudaLaunchSchedule> tuneCudaLaunchSchedule(const StmtPtr& st);
 
     std::string getCodeGenName(BackendType backendType);
 
@@ -374,6 +392,8 @@ TORCH_API bool  fallbackAllowed();
 TORCH_API bool  setFallbackAllowed(bool value);
 TORCH_API bool& getCatWoConditionals();
 TORCH_API bool& getOptConditionals();
+// Set by PYTORCH_TENSOREXPR_AUTOTUNE=1
+TORCH_API bool& getTEAutotuneLoopSchedules();
 
 TORCH_API std::optional<quarisma::Device> pickDeviceType(
     const quarisma::ArrayRef<torch::jit::Value*>& inputs);
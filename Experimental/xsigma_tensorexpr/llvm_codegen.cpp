@@ -5,8 +5,11 @@
 #include <torch/csrc/jit/tensorexpr/analysis.h>
 #include <torch/csrc/jit/tensorexpr/llvm_codegen.h>
 #include <torch/csrc/jit/tensorexpr/llvm_jit.h>
+#include <torch/csrc/jit/tensorexpr/llvm_kernel_cache.h>
+#include <torch/csrc/jit/tensorexpr/loopnest.h>
 #include <quarisma/util/irange.h>
 
+#include "util/env.h"
 #include "util/exception.h"
 
 // Note [llvm::SCEVPredicate non-virtual destructor]
@@ -69,12 +72,14 @@ QUARISMA_DIAGNOSTIC_POP()
 #include <torch/csrc/jit/tensorexpr/expr.h>
 #include <torch/csrc/jit/tensorexpr/external_functions_registry.h>
 #include <torch/csrc/jit/tensorexpr/half_support.h>
+#include <torch/csrc/jit/tensorexpr/hash_provider.h>
 #include <torch/csrc/jit/tensorexpr/ir.h>
 #include <torch/csrc/jit/tensorexpr/ir_printer.h>
 #include <torch/csrc/jit/tensorexpr/tensor.h>
 #include <torch/csrc/jit/tensorexpr/types.h>
 
 #include <memory>
+#include <sstream>
 
 using namespace torch::jit::tensorexpr;
 
@@ -105,6 +110,12 @@ QUARISMA_DEFINE_bool(
         static bool aot_workflow = false;
         return aot_workflow;
     }
+    std::optional<std::string>& LLVMKernelCacheDir()
+    {
+        static std::optional<std::string> dir =
+            quarisma::utils::get_env("QUARISMA_TENSOREXPR_KERNEL_CACHE_DIR");
+        return dir;
+    }
 
     namespace
     {
@@ -271,6 +282,9 @@ QUARISMA_DEFINE_bool(
         llvm::Type*        dtypeToLLVMPtr(Dtype dtype);
         void               emitWrapper(const std::vector<llvm::Type*>& params);
         void               emitKernel(StmtPtr stmt, const std::vector<llvm::Type*>& params);
+        std::string        kernelCacheKey(
+                   const StmtPtr& stmt, const std::vector<CodeGen::BufferArg>& args, Dtype dtype);
+        std::string        emitObject();
         llvm::Value*       toVec(llvm::Value* v, int lanes);
 
         enum Arity
@@ -296,6 +310,7 @@ QUARISMA_DEFINE_bool(
 #endif
 
         void processParallelFor(ForPtr v);
+        void emitLoop(const ForPtr& v, llvm::Value* start, llvm::Value* stop);
         void handleBufReuse(BufPtr buf, BufPtr buf_to_reuse);
 
     public:
@@ -534,6 +549,20 @@ LLVMCodeGenImpl::LLVMCodeGenImpl(
         jit_ = std::make_unique<llvm::orc::PytorchLLVMJIT>(triple, cpu, attrs);
     }
 
+    // rand() is not part of the Stmt hash, and AOT callers want the IR
+    std::optional<std::string> cacheKey;
+    if (LLVMKernelCacheDir() && !LLVMAOTWorkflow() && !HasRand(stmt).has_rand())
+    {
+        cacheKey = kernelCacheKey(stmt, args, dtype);
+        if (auto object = loadCachedKernel(*LLVMKernelCacheDir(), *cacheKey))
+        {
+            jit_->addObjectFile(std::move(object));
+            auto sym       = jit_->findSymbol(kernel_func_name_);
+            kernelAddress_ = assertSuccess(sym.getAddress());
+            return;
+        }
+    }
+
     module_ = std::make_unique<llvm::Module>("pytorch", getContext());
     module_->setDataLayout(jit_->getDataLayout());
     module_->setTargetTriple(
@@ -582,7 +611,17 @@ LLVMCodeGenImpl::LLVMCodeGenImpl(
     emitWrapper(params);
     emitKernel(stmt, params);
 
-    jit_->addModule(std::move(module_), std::move(context_));
+    if (cacheKey)
+    {
+        // Compile once, for both the cache and the JIT
+        const std::string object = emitObject();
+        storeCachedKernel(*LLVMKernelCacheDir(), *cacheKey, object);
+        jit_->addObjectFile(llvm::MemoryBuffer::getMemBufferCopy(object, kernel_func_name_));
+    }
+    else
+    {
+        jit_->addModule(std::move(module_), std::move(context_));
+    }
     if (!LLVMAOTWorkflow())
     {
         auto sym       = jit_->findSymbol(kernel_func_name_);
@@ -802,6 +841,49 @@ void LLVMCodeGenImpl::emitKernel(StmtPtr stmt, const std::vector<llvm::Type*>& p
     GRAPH_DEBUG("\nLLVM generated assembly code\n\n", asmCode_, "\n");
 }
 
+// Everything the object code depends on. Vars are hashed by the names the
+// HashProvider gives them, so the argument hashes must come from the same
+// provider as the Stmt hash.
+std::string LLVMCodeGenImpl::kernelCacheKey(
+    const StmtPtr& stmt, const std::vector<CodeGen::BufferArg>& args, Dtype dtype)
+{
+    HashProvider       hasher;
+    const auto&        TM = jit_->getTargetMachine();
+    std::ostringstream key;
+    key << "version=" << kLLVMKernelCacheVersion << ";llvm=" << LLVM_VERSION_STRING
+        << ";triple=" << TM.getTargetTriple().str() << ";cpu=" << TM.getTargetCPU().str()
+        << ";features=" << TM.getTargetFeatureString().str()
+        << ";fast_intrinsics=" << FLAGS_torch_jit_llvm_use_fast_intrinsics
+        << ";func=" << kernel_func_name_ << ";ret=" << dtype.ToCppString() << ";stmt=" << std::hex
+        << hasher.hash(stmt)._h << ";args=";
+    for (const auto& arg : args)
+    {
+        key << (arg.isVar() ? "var " : "buf ") << arg.dtype().ToCppString() << " "
+            << hasher.hash(arg.var())._h << ",";
+    }
+    return key.str();
+}
+
+std::string LLVMCodeGenImpl::emitObject()
+{
+    llvm::SmallVector<char, 0> objBuffer;
+    llvm::raw_svector_ostream  objStream(objBuffer);
+    llvm::legacy::PassManager  PM;
+    jit_->getTargetMachine().addPassesToEmitFile(
+        PM,
+        objStream,
+        nullptr,
+#if LLVM_VERSION_MAJOR >= 18
+        llvm::CodeGenFileType::ObjectFile);
+#elif LLVM_VERSION_MAJOR >= 10
+        llvm::CodeGenFileType::CGFT_ObjectFile);
+#else
+        llvm::TargetMachine::CodeGenFileType::CGFT_ObjectFile);
+#endif
+    PM.run(*module_);
+    return std::string(objBuffer.begin(), objBuffer.end());
+}
+
 // TODO: The binary ops are copypaste.
 
 void LLVMCodeGenImpl::visit(const AddPtr& v)
@@ -1706,6 +1788,34 @@ std::vector<llvm::Value*> LLVMCodeGenImpl::unpackFuncArgs(llvm::Value* packed, i
 }
 #endif
 
+// Iterations of a parallel loop per task, so that a task runs about
+// kMinParallelWork iterations of the innermost loops. Below that, the cost of
+// waking up a thread is not recovered.
+static int64_t parallelGrainSize(const ForPtr& v)
+{
+    constexpr int64_t kMinParallelWork = 32768;
+    int64_t           work             = 0;
+    for (const StorePtr& store : NodeFinder<Store>::find(v->body()))
+    {
+        int64_t iterations = store->value()->dtype().lanes();
+        StmtPtr s          = store->get_parent();
+        while (s && s != v && iterations < kMinParallelWork)
+        {
+            if (ForPtr loop = to<For>(s))
+            {
+                auto start = intValue(loop->start());
+                auto stop  = intValue(loop->stop());
+                // A loop of unknown length is assumed to be long
+                iterations = start && stop ? iterations * std::max<int64_t>(*stop - *start, 0)
+                                           : kMinParallelWork;
+            }
+            s = s->get_parent();
+        }
+        work = std::min(work + iterations, kMinParallelWork);
+    }
+    return std::max<int64_t>(1, kMinParallelWork / std::max<int64_t>(work, 1));
+}
+
 // Lower the parallel for-loop.
 // * Move the body into its own closure.
 // * Identify var across the boundary into arguments and forward them.
@@ -1748,11 +1858,13 @@ void LLVMCodeGenImpl::processParallelFor(ForPtr v)
     // Remember where we are before moving to the new function.
     llvm::BasicBlock* old_insert_block = irb_.GetInsertBlock();
 
-    // Create the new body closure code.
+    // Create the new body closure code. It runs the iterations [begin, end)
+    // of the loop, so that a task is a loop LLVM can optimize, rather than a
+    // call per iteration.
 #if LLVM_VERSION_MAJOR >= 15
-    auto func_type = llvm::FunctionType::get(VoidTy_, {LongTy_, OpqPtrTy_}, false);
+    auto func_type = llvm::FunctionType::get(VoidTy_, {LongTy_, LongTy_, OpqPtrTy_}, false);
 #else
-    auto func_type = llvm::FunctionType::get(VoidTy_, {LongTy_, Int8PtrTy_}, false);
+    auto func_type = llvm::FunctionType::get(VoidTy_, {LongTy_, LongTy_, Int8PtrTy_}, false);
 #endif
 
     llvm::Function* func =
@@ -1760,7 +1872,8 @@ void LLVMCodeGenImpl::processParallelFor(ForPtr v)
     auto func_body = llvm::BasicBlock::Create(getContext(), "func_body", func);
     irb_.SetInsertPoint(func_body);
     auto         args                 = func->arg_begin();
-    llvm::Value* index                = args++;
+    llvm::Value* begin                = args++;
+    llvm::Value* end                  = args++;
     llvm::Value* packed_func_args_raw = args++;
     llvm::Value* packed_func_args =
         irb_.CreatePointerCast(packed_func_args_raw, packed_caller_args->getType());
@@ -1768,8 +1881,9 @@ void LLVMCodeGenImpl::processParallelFor(ForPtr v)
     // Unpack the arguments from the opaque buffer.
     if (v->var()->dtype().scalar_type() != quarisma::kLong)
     {
-        index = irb_.CreateIntCast(
-            index, dtypeToLLVM(v->var()->dtype()), v->var()->dtype().is_signed());
+        auto index_type = dtypeToLLVM(v->var()->dtype());
+        begin           = irb_.CreateIntCast(begin, index_type, v->var()->dtype().is_signed());
+        end             = irb_.CreateIntCast(end, index_type, v->var()->dtype().is_signed());
     }
 #if LLVM_VERSION_MAJOR >= 15
     body_closure_args = unpackFuncArgs({packData.type, packed_func_args}, body_arg_vars.size());
@@ -1778,19 +1892,14 @@ void LLVMCodeGenImpl::processParallelFor(ForPtr v)
 #endif
     // Set the codegen to the new func.
     // TODO: this should be replaced by RAII wrappers.
-    varToVal_[v->var()] = index;
     replaceVarMapping(body_arg_vars, body_closure_args);
     llvm::Function* old_fn = fn_;
     fn_                    = func;
-    if (v->body())
-    {
-        v->body()->accept(this);
-    }
+    emitLoop(v, begin, end);
     // Restore back to the previous fn_
     fn_ = old_fn;
     irb_.CreateRet(nullptr);
     replaceVarMapping(body_arg_vars, body_caller_vals);
-    varToVal_.erase(v->var());
 
     // Points back to the original block and generate the callee code.
     irb_.SetInsertPoint(old_insert_block);
@@ -1798,22 +1907,23 @@ void LLVMCodeGenImpl::processParallelFor(ForPtr v)
 #if LLVM_VERSION_MAJOR >= 15
     llvm::Value* packed_caller_args_ptr = irb_.CreatePointerCast(packed_caller_args, OpqPtrTy_);
     llvm::Value* func_value             = irb_.CreatePointerCast(func, OpqPtrTy_);
-    llvm::FunctionType* dispatcher_fntype =
-        llvm::FunctionType::get(VoidTy_, {OpqPtrTy_, LongTy_, LongTy_, OpqPtrTy_}, false);
+    llvm::FunctionType* dispatcher_fntype = llvm::FunctionType::get(
+        VoidTy_, {OpqPtrTy_, LongTy_, LongTy_, LongTy_, OpqPtrTy_}, false);
 #else
     llvm::Value* packed_caller_args_ptr = irb_.CreatePointerCast(packed_caller_args, Int8PtrTy_);
     llvm::Value* func_value             = irb_.CreatePointerCast(func, Int8PtrTy_);
-    llvm::FunctionType* dispatcher_fntype =
-        llvm::FunctionType::get(VoidTy_, {Int8PtrTy_, LongTy_, LongTy_, Int8PtrTy_}, false);
+    llvm::FunctionType* dispatcher_fntype = llvm::FunctionType::get(
+        VoidTy_, {Int8PtrTy_, LongTy_, LongTy_, LongTy_, Int8PtrTy_}, false);
 #endif
 
     FunctionCallee dispatcher_callee =
         module_->getOrInsertFunction("DispatchParallel", dispatcher_fntype);
     llvm::Function* dispatcher = llvm::cast<llvm::Function>(dispatcher_callee.getCallee());
     dispatcher->addFnAttr(llvm::Attribute::NoUnwind);
-    start = irb_.CreateIntCast(start, LongTy_, true);
-    stop  = irb_.CreateIntCast(stop, LongTy_, true);
-    irb_.CreateCall(dispatcher, {func_value, start, stop, packed_caller_args_ptr});
+    start           = irb_.CreateIntCast(start, LongTy_, true);
+    stop            = irb_.CreateIntCast(stop, LongTy_, true);
+    auto grain_size = llvm::ConstantInt::getSigned(LongTy_, parallelGrainSize(v));
+    irb_.CreateCall(dispatcher, {func_value, start, stop, grain_size, packed_caller_args_ptr});
     value_ = llvm::ConstantInt::get(IntTy_, 0);
 }
 
@@ -1821,8 +1931,14 @@ void LLVMCodeGenImpl::visit(const ForPtr& v)
 {
     if (v->is_parallel())
     {
-        processParallelFor(v);
-        return;
+        // The flag may have been set by hand, or by a transform that did not
+        // check the accesses
+        if (!LoopNest::hasLoopCarriedDependence(v))
+        {
+            processParallelFor(v);
+            return;
+        }
+        GRAPH_DEBUG("Running a parallel loop with a loop-carried dependence serially: ", *v);
     }
 
     // Create "start" and "stop" values.
@@ -1831,6 +1947,11 @@ void LLVMCodeGenImpl::visit(const ForPtr& v)
     v->stop()->accept(this);
     auto stop = this->value_;
 
+    emitLoop(v, start, stop);
+}
+
+void LLVMCodeGenImpl::emitLoop(const ForPtr& v, llvm::Value* start, llvm::Value* stop)
+{
     // Create block for loop condition test.
     auto preheader = irb_.GetInsertBlock();
     auto condBlock = llvm::BasicBlock::Create(getContext(), "cond", fn_);
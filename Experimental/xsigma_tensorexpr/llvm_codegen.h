@@ -75,6 +75,7 @@ public:
         return rv;
     }
 
+    // Empty when the kernel was loaded from the kernel cache
     std::string getCodeText(const std::string& attr = "") override;
 
 private:
@@ -150,6 +151,9 @@ TORCH_API std::optional<std::string>& LLVMTargetTriple();
 TORCH_API std::optional<std::string>& LLVMTargetCPU();
 TORCH_API std::optional<std::string>& LLVMTargetAttrs();
 TORCH_API bool&                       LLVMAOTWorkflow();
+// Directory of the on-disk kernel cache, disabled when unset. Defaults to
+// $QUARISMA_TENSOREXPR_KERNEL_CACHE_DIR.
+TORCH_API std::optional<std::string>& LLVMKernelCacheDir();
 
 }  // namespace tensorexpr
 }  // namespace jit
@@ -247,6 +247,11 @@ public:
             "Failed to add module to compile layer");
     }
 
+    void addObjectFile(std::unique_ptr<MemoryBuffer> Obj)
+    {
+        assertSuccess(LLJ->addObjectFile(std::move(Obj)), "Failed to add object file");
+    }
+
     JITSymbol findSymbol(const std::string Name)
     {
 #if LLVM_VERSION_MAJOR >= 15
@@ -333,6 +338,12 @@ public:
             CompileLayer.addModule(K, std::move(M)), "Failed to add module to compile layer");
     }
 
+    void addObjectFile(std::unique_ptr<MemoryBuffer> Obj)
+    {
+        auto K = ES.allocateVModule();
+        assertSuccess(ObjectLayer.addObject(K, std::move(Obj)), "Failed to add object file");
+    }
+
     JITSymbol findSymbol(const std::string Name)
     {
         std::string        MangledName;
@@ -372,6 +383,11 @@ void PytorchLLVMJIT::addModule(std::unique_ptr<Module> M, std::unique_ptr<LLVMCo
     impl_->addModule(std::move(M), std::move(C));
 }
 
+void PytorchLLVMJIT::addObjectFile(std::unique_ptr<MemoryBuffer> Obj)
+{
+    impl_->addObjectFile(std::move(Obj));
+}
+
 JITSymbol PytorchLLVMJIT::findSymbol(const std::string Name)
 {
     return impl_->findSymbol(std::move(Name));
@@ -14,6 +14,7 @@ QUARISMA_DIAGNOSTIC_POP()
 QUARISMA_DIAGNOSTIC_PUSH_AND_IGNORED_IF_DEFINED("-Wextra-semi")
 #include <llvm/ExecutionEngine/Orc/Core.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Target/TargetMachine.h>
 QUARISMA_DIAGNOSTIC_POP()
 
@@ -70,6 +71,9 @@ public:
 
     void addModule(std::unique_ptr<Module> M, std::unique_ptr<LLVMContext> C);
 
+    // Links object code compiled for getTargetMachine(), with no IR compilation
+    void addObjectFile(std::unique_ptr<MemoryBuffer> Obj);
+
     JITSymbol findSymbol(const std::string Name);
 
     bool hasSymbol(const std::string& Name);
@@ -0,0 +1,156 @@
+#ifdef TORCH_ENABLE_LLVM
+
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/tensorexpr/llvm_kernel_cache.h>
+
+QUARISMA_DIAGNOSTIC_PUSH_AND_IGNORED_IF_DEFINED("-Wextra-semi")
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/xxhash.h>
+#if LLVM_VERSION_MAJOR >= 18
+#include <llvm/TargetParser/Host.h>
+#else
+#include <llvm/Support/Host.h>
+#endif
+QUARISMA_DIAGNOSTIC_POP()
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <sstream>
+
+namespace torch::jit::tensorexpr
+{
+
+namespace
+{
+
+constexpr char kEntryMagic[8] = {'Q', 'T', 'E', 'K', 'E', 'R', 'N', '1'};
+
+std::string entryPath(const std::string& dir, const std::string& key, const char* extension)
+{
+    std::ostringstream path;
+    path << dir << "/" << std::hex << llvm::xxHash64(key) << extension;
+    return path.str();
+}
+
+bool readSized(std::istream& in, std::string& out)
+{
+    uint64_t size = 0;
+    if (!in.read(reinterpret_cast<char*>(&size), sizeof(size)))
+    {
+        return false;
+    }
+    out.resize(size);
+    return static_cast<bool>(in.read(out.data(), static_cast<std::streamsize>(size)));
+}
+
+void writeSized(std::ostream& out, llvm::StringRef bytes)
+{
+    const uint64_t size = bytes.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::optional<std::string> loadEntry(const std::string& path, const std::string& key)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return std::nullopt;
+    }
+
+    char        magic[sizeof(kEntryMagic)];
+    std::string storedKey;
+    std::string payload;
+    if (!in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, kEntryMagic, sizeof(kEntryMagic)) != 0 || !readSized(in, storedKey) ||
+        storedKey != key || !readSized(in, payload))
+    {
+        GRAPH_DEBUG("Ignoring kernel cache entry ", path);
+        return std::nullopt;
+    }
+    GRAPH_DEBUG("Loaded kernel cache entry ", path);
+    return payload;
+}
+
+void storeEntry(
+    const std::string& dir,
+    const std::string& path,
+    const std::string& key,
+    llvm::StringRef    payload)
+{
+    if (llvm::sys::fs::create_directories(dir))
+    {
+        GRAPH_DEBUG("Cannot create kernel cache directory ", dir);
+        return;
+    }
+
+    // Unique per writer, so that concurrent stores of one key do not interleave
+    static std::atomic<uint64_t> writers{0};
+    const std::string            tmp = path + ".tmp" +
+                            std::to_string(llvm::sys::Process::getProcessId()) + "." +
+                            std::to_string(writers.fetch_add(1, std::memory_order_relaxed));
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(kEntryMagic, sizeof(kEntryMagic));
+        writeSized(out, key);
+        writeSized(out, payload);
+        if (!out.flush())
+        {
+            GRAPH_DEBUG("Cannot write kernel cache entry ", tmp);
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        GRAPH_DEBUG("Cannot rename kernel cache entry to ", path);
+        std::remove(tmp.c_str());
+    }
+}
+
+// A schedule is tuned by running the kernel, so it belongs to this CPU
+std::string scheduleKey(const std::string& key)
+{
+    return key + ";host=" + llvm::sys::getHostCPUName().str();
+}
+
+}  // namespace
+
+std::unique_ptr<llvm::MemoryBuffer> loadCachedKernel(const std::string& dir, const std::string& key)
+{
+    const std::string path   = entryPath(dir, key, ".o");
+    auto              object = loadEntry(path, key);
+    if (!object)
+    {
+        return nullptr;
+    }
+    return llvm::MemoryBuffer::getMemBufferCopy(*object, path);
+}
+
+void storeCachedKernel(const std::string& dir, const std::string& key, llvm::StringRef object)
+{
+    storeEntry(dir, entryPath(dir, key, ".o"), key, object);
+}
+
+std::optional<std::string> loadCachedSchedule(const std::string& dir, const std::string& key)
+{
+    const std::string fullKey = scheduleKey(key);
+    return loadEntry(entryPath(dir, fullKey, ".sched"), fullKey);
+}
+
+void storeCachedSchedule(
+    const std::string& dir, const std::string& key, const std::string& schedule)
+{
+    const std::string fullKey = scheduleKey(key);
+    storeEntry(dir, entryPath(dir, fullKey, ".sched"), fullKey, schedule);
+}
+
+}  // namespace torch::jit::tensorexpr
+
+#endif  // TORCH_ENABLE_LLVM
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef TORCH_ENABLE_LLVM
+#include <torch/csrc/Export.h>
+
+#include "common/macros.h"
+
+QUARISMA_DIAGNOSTIC_PUSH_AND_IGNORED_IF_DEFINED("-Wextra-semi")
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+QUARISMA_DIAGNOSTIC_POP()
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace torch
+{
+namespace jit
+{
+namespace tensorexpr
+{
+
+// Part of every key. Bump it when LLVMCodeGen emits different code for the
+// same Stmt, so that entries written by older builds are no longer found.
+inline constexpr int kLLVMKernelCacheVersion = 2;
+
+/*
+ * On-disk cache of the object code of LLVM kernels.
+ *
+ * The key describes everything the object code depends on; LLVMCodeGen
+ * builds it from the hash of the Stmt, the arguments, the target and the
+ * LLVM version. An entry is stored in `dir` in a file named after a hash of
+ * the key, and holds the key itself, which is compared on load so that a
+ * collision of file names is a miss. Entries are written to a temporary file
+ * and renamed, so processes sharing the directory never read a partial entry.
+ */
+
+// nullptr on a miss or an unreadable entry
+TORCH_API std::unique_ptr<llvm::MemoryBuffer> loadCachedKernel(
+    const std::string& dir, const std::string& key);
+
+// Failures are not fatal: the kernel is just compiled again next time
+TORCH_API void storeCachedKernel(
+    const std::string& dir, const std::string& key, llvm::StringRef object);
+
+// The loop schedules picked by the autotuner (see loopnest_autotune.h) are
+// kept in the same directory. The key is extended with the host CPU, which
+// the schedule was timed on.
+TORCH_API std::optional<std::string> loadCachedSchedule(
+    const std::string& dir, const std::string& key);
+
+TORCH_API void storeCachedSchedule(
+    const std::string& dir, const std::string& key, const std::string& schedule);
+
+}  // namespace tensorexpr
+}  // namespace jit
+}  // namespace torch
+
+#endif  // TORCH_ENABLE_LLVM
@@ -0,0 +1,699 @@
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/tensorexpr/analysis.h>
+#include <torch/csrc/jit/tensorexpr/ir_mutator.h>
+#include <torch/csrc/jit/tensorexpr/ir_simplifier.h>
+#include <torch/csrc/jit/tensorexpr/loopnest_autotune.h>
+
+#include "util/cpu_topology.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace torch::jit::tensorexpr
+{
+
+std::string LoopSchedule::toString() const
+{
+    return "p" + std::to_string(parallelize) + ",t" + std::to_string(tile) + ",i" +
+           std::to_string(interchangeReductions) + ",r" + std::to_string(registerBlock) + ",v" +
+           std::to_string(vectorize);
+}
+
+std::optional<LoopSchedule> LoopSchedule::parse(const std::string& s)
+{
+    int  p = 0, t = 0, i = 0, r = 0, v = 0;
+    char trailing;
+    if (std::sscanf(s.c_str(), "p%d,t%d,i%d,r%d,v%d%c", &p, &t, &i, &r, &v, &trailing) != 5 ||
+        p < 0 || p > 1 || t < 0 || i < 0 || i > 1 || r < 0 || r > 1 || v < 0 || v > 1)
+    {
+        return std::nullopt;
+    }
+    LoopSchedule schedule;
+    schedule.parallelize           = p;
+    schedule.tile                  = t;
+    schedule.interchangeReductions = i;
+    schedule.registerBlock         = r;
+    schedule.vectorize             = v;
+    return schedule;
+}
+
+std::vector<LoopSchedule> loopScheduleCandidates(bool hasReduction)
+{
+    std::vector<LoopSchedule> candidates;
+    for (bool parallelize : {true, false})
+    {
+        for (int tile : {0, 8, 32})
+        {
+            for (bool interchange : {false, true})
+            {
+                if (interchange && !hasReduction)
+                {
+                    continue;
+                }
+                // Both reorder the same loops
+                for (bool registerBlock : {!interchange, false})
+                {
+                    for (bool vectorize : {true, false})
+                    {
+                        candidates.push_back(
+                            {parallelize, tile, interchange, registerBlock, vectorize});
+                    }
+                    if (!hasReduction || interchange)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return candidates;
+}
+
+std::string CudaLaunchSchedule::toString() const
+{
+    return "l" + std::to_string(loopLevels) + ",b" + std::to_string(blockSize) + ",c" +
+           std::to_string(blockCount);
+}
+
+std::optional<CudaLaunchSchedule> CudaLaunchSchedule::parse(const std::string& s)
+{
+    int  l = 0, b = 0, c = 0;
+    char trailing;
+    if (std::sscanf(s.c_str(), "l%d,b%d,c%d%c", &l, &b, &c, &trailing) != 3 || l < 2 || l > 3 ||
+        b <= 0 || c <= 0)
+    {
+        return std::nullopt;
+    }
+    CudaLaunchSchedule schedule;
+    schedule.loopLevels = l;
+    schedule.blockSize  = b;
+    schedule.blockCount = c;
+    return schedule;
+}
+
+std::vector<CudaLaunchSchedule> cudaLaunchScheduleCandidates(
+    int occupancyBlockSize, int occupancyGridSize)
+{
+    // Threads per block allowed by every CUDA device
+    static const int kMaxBlockSize = 1024;
+
+    std::vector<int> blockSizes;
+    for (int blockSize : {occupancyBlockSize, 128, 256, 512, kMaxBlockSize})
+    {
+        if (blockSize > 0 && blockSize <= kMaxBlockSize &&
+            std::find(blockSizes.begin(), blockSizes.end(), blockSize) == blockSizes.end())
+        {
+            blockSizes.push_back(blockSize);
+        }
+    }
+
+    std::vector<CudaLaunchSchedule> candidates;
+    for (int blockSize : blockSizes)
+    {
+        candidates.push_back({2, blockSize, 1});
+    }
+    // A grid of a few waves of resident blocks, each looping over its share
+    if (occupancyGridSize > 0)
+    {
+        for (int blockSize : blockSizes)
+        {
+            for (int waves : {1, 2, 4})
+            {
+                candidates.push_back({3, blockSize, waves * occupancyGridSize});
+            }
+        }
+    }
+    return candidates;
+}
+
+namespace
+{
+
+std::vector<ForPtr> innermostLoops(const StmtPtr& root)
+{
+    std::vector<ForPtr> loops;
+    for (const ForPtr& f : NodeFinder<For>::find(root))
+    {
+        if (NodeFinder<For>::find(f->body()).empty())
+        {
+            loops.push_back(f);
+        }
+    }
+    return loops;
+}
+
+std::optional<int64_t> constantTripCount(const ForPtr& f)
+{
+    auto start = intValue(f->start());
+    auto stop  = intValue(f->stop());
+    if (!start || !stop)
+    {
+        return std::nullopt;
+    }
+    return *stop - *start;
+}
+
+}  // namespace
+
+void tileInnerLoops(LoopNest& l, int factor)
+{
+    for (const ForPtr& inner : innermostLoops(l.root_stmt()))
+    {
+        ForPtr outer = LoopNest::getParentLoop(inner);
+        if (!outer || outer->is_parallel() || inner->is_parallel() ||
+            !to<Block>(outer->get_parent()) || !LoopNest::areLoopsPerfectlyNested({outer, inner}))
+        {
+            continue;
+        }
+        // Tiling a loop shorter than the tile only adds a tail loop
+        auto outerTrips = constantTripCount(outer);
+        auto innerTrips = constantTripCount(inner);
+        if (!outerTrips || !innerTrips || *outerTrips <= factor || *innerTrips <= factor)
+        {
+            continue;
+        }
+        l.tile(outer, inner, factor, factor);
+    }
+}
+
+void interchangeReductionLoops(LoopNest& l)
+{
+    for (const ForPtr& inner : innermostLoops(l.root_stmt()))
+    {
+        ForPtr outer = LoopNest::getParentLoop(inner);
+        // Another loop in the same nest would be moved along by reorderAxis
+        if (!outer || outer->is_parallel() || !to<Block>(outer->get_parent()) ||
+            NodeFinder<For>::find(outer->body()).size() != 1)
+        {
+            continue;
+        }
+        // Only a loop that accumulates, inside a loop over independent outputs
+        if (!LoopNest::hasLoopCarriedDependence(inner) || LoopNest::hasLoopCarriedDependence(outer))
+        {
+            continue;
+        }
+        LoopNest::reorderAxis(outer, inner);
+    }
+}
+
+void vectorizeIndependentInnerLoops(LoopNest& l)
+{
+    // The widths used by LoopNest::vectorizeInnerLoops
+    static const int kBodyVectorWidth = 8;
+    static const int kTailVectorWidth = 4;
+    for (const ForPtr& loop : innermostLoops(l.root_stmt()))
+    {
+        if (loop->is_parallel() || LoopNest::hasLoopCarriedDependence(loop))
+        {
+            continue;
+        }
+        ForPtr split1;
+        ForPtr tail1;
+        LoopNest::splitWithTail(loop, kBodyVectorWidth, &split1, &tail1);
+        LoopNest::vectorize(split1);
+        if (tail1)
+        {
+            ForPtr split2;
+            ForPtr tail2;
+            LoopNest::splitWithTail(tail1, kTailVectorWidth, &split2, &tail2);
+            LoopNest::vectorize(split2);
+        }
+    }
+}
+
+namespace
+{
+
+// The accumulator tile of a register-blocked reduction has kRegisterBlockRows
+// rows of kRegisterBlockBytes, one AVX2 register each
+constexpr int kRegisterBlockRows  = 4;
+constexpr int kRegisterBlockBytes = 32;
+
+// Redirects the loads of the accumulated buffer to the accumulator tile
+class AccumulatorLoadReplacer : public IRMutator
+{
+public:
+    AccumulatorLoadReplacer(BufPtr buf, BufPtr acc, ExprPtr index)
+        : buf_(std::move(buf)), acc_(std::move(acc)), index_(std::move(index))
+    {
+    }
+
+    ExprPtr mutate(const LoadPtr& v) override
+    {
+        if (v->buf() != buf_)
+        {
+            return IRMutator::mutate(v);
+        }
+        return alloc<Load>(acc_, std::vector<ExprPtr>({index_}));
+    }
+
+private:
+    BufPtr  buf_;
+    BufPtr  acc_;
+    ExprPtr index_;
+};
+
+// A reduction of a 2-D output over k, as expanded by prepareForCodegen:
+//   for m
+//     for n
+//       C[i] = init
+//       for k
+//         C[i] = C[i] + ...
+bool isReductionNest(const ForPtr& k)
+{
+    ForPtr n = LoopNest::getParentLoop(k);
+    ForPtr m = n ? LoopNest::getParentLoop(n) : nullptr;
+    if (!m || m->is_parallel() || n->is_parallel() || k->is_parallel() ||
+        !to<Block>(m->get_parent()) || m->body()->nstmts() != 1 || m->body()->front() != n ||
+        n->body()->nstmts() != 2 || n->body()->back() != k || k->body()->nstmts() != 1)
+    {
+        return false;
+    }
+    StorePtr init   = to<Store>(n->body()->front());
+    StorePtr update = to<Store>(k->body()->front());
+    if (!init || !update || init->buf() != update->buf() ||
+        update->value()->dtype().lanes() != 1)
+    {
+        return false;
+    }
+    auto sameElement = [&](const std::vector<ExprPtr>& indices)
+    {
+        if (indices.size() != update->indices().size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            if (!exprEquals(indices[i], update->indices()[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!sameElement(init->indices()))
+    {
+        return false;
+    }
+    for (const auto& index : update->indices())
+    {
+        if (VarFinder::find(index).count(k->var()))
+        {
+            return false;
+        }
+    }
+    // The accumulated element must be the only one of C the update reads
+    for (const LoadPtr& load : NodeFinder<Load>::find(update->value()))
+    {
+        if (load->buf() == update->buf() && !sameElement(load->indices()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The largest divisor of trips that is at most limit
+int64_t largestDivisorAtMost(int64_t trips, int64_t limit)
+{
+    for (int64_t d = std::min(trips, limit); d > 1; d--)
+    {
+        if (trips % d == 0)
+        {
+            return d;
+        }
+    }
+    return 1;
+}
+
+// Vectorizes, or else unrolls, the columns of a tile and unrolls its rows, so
+// that every access to the accumulator tile has a constant index
+void unrollTile(const ForPtr& row, const ForPtr& col)
+{
+    if (!LoopNest::vectorize(col))
+    {
+        LoopNest::fullUnroll(col);
+    }
+    LoopNest::fullUnroll(row);
+}
+
+void registerBlockReduction(LoopNest& l, const ForPtr& k)
+{
+    ForPtr      n     = LoopNest::getParentLoop(k);
+    ForPtr      m     = LoopNest::getParentLoop(n);
+    const Dtype dtype = to<Store>(k->body()->front())->value()->dtype();
+    const int   rows  = kRegisterBlockRows;
+    const int   cols  = std::max(1, kRegisterBlockBytes / dtype.byte_size());
+    auto        mTrips = constantTripCount(m);
+    auto        nTrips = constantTripCount(n);
+    auto        kTrips = constantTripCount(k);
+    if (!mTrips || !nTrips || !kTrips || *mTrips < rows || *nTrips < cols || *kTrips <= 0)
+    {
+        return;
+    }
+
+    // The tails of the tiling keep accumulating in memory
+    l.tile(m, n, rows, cols);
+    std::vector<ForPtr> tile = LoopNest::getLoopStmtsInLoopNest(m, 4);
+    ForPtr              mo   = tile[0];
+    ForPtr              no   = tile[1];
+    ForPtr              mi   = tile[2];
+    ForPtr              ni   = tile[3];
+
+    // Accumulate into a rows x cols buffer small enough for codegen to keep
+    // it on the stack, where LLVM promotes it to registers once every access
+    // has a constant index
+    StorePtr init   = to<Store>(ni->body()->front());
+    ForPtr   reduce = to<For>(ni->body()->back());
+    StorePtr update = to<Store>(reduce->body()->front());
+    BufPtr   buf    = update->buf();
+    BufPtr   acc    = BufHandle(buf->name_hint() + "_acc", {rows * cols}, dtype).node();
+    ExprPtr  accIndex =
+        alloc<Add>(alloc<Mul>(mi->var(), immLike(mi->var(), cols)), ni->var());
+    AccumulatorLoadReplacer replacer(buf, acc, accIndex);
+    ni->body()->replace_stmt(
+        init, alloc<Store>(acc, std::vector<ExprPtr>({accIndex}), init->value()));
+    reduce->body()->replace_stmt(
+        update,
+        alloc<Store>(
+            acc,
+            std::vector<ExprPtr>({accIndex}),
+            update->value()->accept_mutator(&replacer)));
+    ni->body()->append_stmt(
+        alloc<Store>(buf, update->indices(), alloc<Load>(acc, std::vector<ExprPtr>({accIndex}))));
+
+    // Initialize the tile, run k around the whole tile, then store the tile:
+    //   for k
+    //     for mi
+    //       for ni
+    //         acc[mi * cols + ni] = acc[mi * cols + ni] + ...
+    LoopNest::distributeLoop(ni);
+    std::vector<ForPtr> steps = LoopNest::distributeLoop(mi);
+    std::vector<ForPtr> accumulate =
+        LoopNest::reorder(LoopNest::getLoopStmtsInLoopNest(steps[1], 3), {2, 0, 1});
+    unrollTile(steps[0], to<For>(steps[0]->body()->front()));
+    unrollTile(accumulate[1], accumulate[2]);
+    unrollTile(steps[2], to<For>(steps[2]->body()->front()));
+
+    // Each tile streams a k x cols panel of the right-hand side. Visit the
+    // column blocks whose panels fit in half of the L2 cache of a core for
+    // every row block before moving on, so that the panels are read from
+    // memory once.
+    if (mo->body()->nstmts() != 1)
+    {
+        // A column tail follows the column blocks
+        return;
+    }
+    const auto&   topology   = quarisma::cpu_topology::instance();
+    const int64_t l2Bytes    = topology.cache_per_core(topology.l2()) / 2;
+    const int64_t panelBytes = *kTrips * cols * dtype.byte_size();
+    const int64_t noTrips    = *nTrips / cols;
+    const int64_t block = largestDivisorAtMost(noTrips, std::max<int64_t>(1, l2Bytes / panelBytes));
+    if (block < noTrips)
+    {
+        ForPtr inner;
+        ForPtr tail;
+        LoopNest::splitWithTail(no, block, &inner, &tail);
+        LoopNest::reorder({mo, no}, {1, 0});
+    }
+}
+
+}  // namespace
+
+void registerBlockReductions(LoopNest& l)
+{
+    std::vector<ForPtr> reductions;
+    for (const ForPtr& k : innermostLoops(l.root_stmt()))
+    {
+        if (isReductionNest(k))
+        {
+            reductions.push_back(k);
+        }
+    }
+    for (const ForPtr& k : reductions)
+    {
+        registerBlockReduction(l, k);
+    }
+}
+
+namespace
+{
+
+constexpr int     kTimedRuns     = 5;
+constexpr double  kMinRunSeconds = 1e-3;
+constexpr int64_t kMaxCalls      = 1000;
+
+// Elements spanned by a buffer of static shape
+std::optional<int64_t> numElements(const BufPtr& buf)
+{
+    const auto strides = buf->strides();
+    int64_t    span    = 1;
+    for (size_t i = 0; i < buf->ndim(); i++)
+    {
+        auto dim    = intValue(buf->dim(i));
+        auto stride = strides.size() == buf->ndim() ? intValue(strides[i]) : std::nullopt;
+        if (!dim || !stride)
+        {
+            return std::nullopt;
+        }
+        if (*dim == 0)
+        {
+            return 0;
+        }
+        span += (*dim - 1) * *stride;
+    }
+    return span;
+}
+
+struct Buffer
+{
+    std::vector<double> data;  // double for the alignment
+    ScalarType          dtype;
+    int64_t             elements;
+};
+
+void fillRandom(Buffer& b, std::mt19937& gen)
+{
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (int64_t i = 0; i < b.elements; i++)
+    {
+        if (b.dtype == ScalarType::Float)
+        {
+            reinterpret_cast<float*>(b.data.data())[i] = static_cast<float>(dist(gen));
+        }
+        else
+        {
+            b.data[i] = dist(gen);
+        }
+    }
+}
+
+template <typename T>
+bool allClose(const T* actual, const T* expected, int64_t n)
+{
+    for (int64_t i = 0; i < n; i++)
+    {
+        if (std::isnan(actual[i]) && std::isnan(expected[i]))
+        {
+            continue;
+        }
+        if (!(std::abs(actual[i] - expected[i]) <= 1e-5 + 1e-3 * std::abs(expected[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool allClose(const Buffer& actual, const Buffer& expected)
+{
+    if (actual.dtype == ScalarType::Float)
+    {
+        return allClose(
+            reinterpret_cast<const float*>(actual.data.data()),
+            reinterpret_cast<const float*>(expected.data.data()),
+            actual.elements);
+    }
+    return allClose(actual.data.data(), expected.data.data(), actual.elements);
+}
+
+// A CPU tensor over the data of b
+quarisma::Tensor hostTensor(Buffer& b)
+{
+    return quarisma::from_blob(
+        b.data.data(), {b.elements}, quarisma::TensorOptions().dtype(b.dtype));
+}
+
+// synchronize waits for the calls launched on the device, if any
+double secondsPerCall(
+    CodeGen&                     codegen,
+    const std::vector<void*>&    callArgs,
+    const std::function<void()>& synchronize)
+{
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    codegen.call_raw(callArgs);
+    synchronize();
+    const double once  = std::chrono::duration<double>(clock::now() - start).count();
+    const auto   calls = std::clamp<int64_t>(
+        static_cast<int64_t>(kMinRunSeconds / std::max(once, 1e-9)), 1, kMaxCalls);
+
+    double best = std::numeric_limits<double>::infinity();
+    for (int run = 0; run < kTimedRuns; run++)
+    {
+        start = clock::now();
+        for (int64_t i = 0; i < calls; i++)
+        {
+            codegen.call_raw(callArgs);
+        }
+        synchronize();
+        const double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        best                 = std::min(best, elapsed / static_cast<double>(calls));
+    }
+    return best;
+}
+
+}  // namespace
+
+std::optional<size_t> pickFastestStmt(
+    const std::string&                       codegenName,
+    const std::vector<StmtPtr>&              stmts,
+    const std::vector<CodeGen::BufferArg>&   args,
+    const std::unordered_map<BufPtr, void*>& bound,
+    const std::unordered_set<BufPtr>&        outputs,
+    quarisma::Device                         device,
+    const std::string&                       kernelFuncName)
+{
+    std::mt19937        gen(0);
+    std::vector<Buffer> buffers;
+    std::vector<size_t> outputBuffers;
+    std::vector<void*>  callArgs;
+    buffers.reserve(args.size());
+
+    // On a device, buffers[i] is copied to deviceBuffers[i], which the
+    // kernels take, and the outputs are copied back to be compared
+    const bool                    onDevice = device.type() != quarisma::kCPU;
+    std::vector<quarisma::Tensor> deviceBuffers;
+    std::function<void()>         synchronize = [] {};
+    if (onDevice)
+    {
+        // Copying to the host waits for the kernels queued before it
+        auto probe  = quarisma::zeros({1}, quarisma::TensorOptions().device(device));
+        synchronize = [probe] { (void)probe.cpu(); };
+    }
+    for (const auto& arg : args)
+    {
+        if (arg.isVar())
+        {
+            return std::nullopt;
+        }
+        auto it = bound.find(arg.buf());
+        if (it != bound.end())
+        {
+            callArgs.push_back(it->second);
+            continue;
+        }
+        const ScalarType dtype    = arg.dtype().scalar_type();
+        const auto       elements = numElements(arg.buf());
+        if ((dtype != ScalarType::Float && dtype != ScalarType::Double) || !elements)
+        {
+            return std::nullopt;
+        }
+        Buffer& b = buffers.emplace_back();
+        b.dtype    = dtype;
+        b.elements = *elements;
+        b.data.resize(static_cast<size_t>(*elements));
+        fillRandom(b, gen);
+        if (outputs.count(arg.buf()))
+        {
+            outputBuffers.push_back(buffers.size() - 1);
+        }
+        if (onDevice)
+        {
+            deviceBuffers.push_back(hostTensor(b).to(device));
+            callArgs.push_back(deviceBuffers.back().data_ptr());
+        }
+        else
+        {
+            callArgs.push_back(b.data.data());
+        }
+    }
+
+    std::vector<Buffer>   expected;
+    std::optional<size_t> fastest;
+    double                fastestSeconds = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < stmts.size(); i++)
+    {
+        std::unique_ptr<CodeGen> codegen;
+        try
+        {
+            codegen = CreateCodeGen(codegenName, stmts[i], args, device, kernelFuncName);
+        }
+        catch (const std::exception& e)
+        {
+            GRAPH_DEBUG("Cannot compile schedule candidate ", i, ": ", e.what());
+            if (i == 0)
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+
+        // Scramble the outputs, so that a candidate that does not write all of
+        // them is caught
+        for (size_t o : outputBuffers)
+        {
+            fillRandom(buffers[o], gen);
+            if (onDevice)
+            {
+                deviceBuffers[o].copy_(hostTensor(buffers[o]));
+            }
+        }
+        codegen->call_raw(callArgs);
+        if (onDevice)
+        {
+            for (size_t o : outputBuffers)
+            {
+                hostTensor(buffers[o]).copy_(deviceBuffers[o]);
+            }
+        }
+        if (i == 0)
+        {
+            for (size_t o : outputBuffers)
+            {
+                expected.push_back(buffers[o]);
+            }
+        }
+        else
+        {
+            bool same = true;
+            for (size_t k = 0; k < outputBuffers.size() && same; k++)
+            {
+                same = allClose(buffers[outputBuffers[k]], expected[k]);
+            }
+            if (!same)
+            {
+                GRAPH_DEBUG("Schedule candidate ", i, " computes different outputs");
+                continue;
+            }
+        }
+
+        const double seconds = secondsPerCall(*codegen, callArgs, synchronize);
+        GRAPH_DEBUG("Schedule candidate ", i, ": ", seconds * 1e6, "us");
+        if (seconds < fastestSeconds)
+        {
+            fastest        = i;
+            fastestSeconds = seconds;
+        }
+    }
+    return fastest;
+}
+
+}  // namespace torch::jit::tensorexpr
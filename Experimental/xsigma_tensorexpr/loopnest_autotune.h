@@ -0,0 +1,115 @@
+#pragma once
+
+#include <torch/csrc/Export.h>
+#include <torch/csrc/jit/tensorexpr/codegen.h>
+#include <torch/csrc/jit/tensorexpr/loopnest.h>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch::jit::tensorexpr
+{
+
+// Part of the key of tuned schedules. Bump it when the meaning of a
+// LoopSchedule changes, so that schedules tuned by older builds are tuned
+// again.
+inline constexpr int kLoopScheduleVersion = 2;
+
+/*
+ * The knobs of the CPU schedule applied by TensorExprKernel::transformLoops.
+ *
+ * Without a schedule, transformLoops parallelizes the outer loops and
+ * vectorizes the inner loops of kernels without reductions, and register
+ * blocks the reductions of the other kernels. The autotuner
+ * tries the combinations of these knobs and keeps the fastest.
+ */
+struct TORCH_API LoopSchedule
+{
+    // Flatten and parallelize the outer loops of every output
+    bool parallelize = true;
+    // Tile the two innermost loops of every perfect loop nest by
+    // tile x tile, 0 for no tiling
+    int tile = 0;
+    // Swap a reduction loop with the loop around it, so that the innermost
+    // loop runs over independent outputs
+    bool interchangeReductions = false;
+    // Accumulate 2-D reductions in register tiles, in column blocks sized
+    // for the L2 cache
+    bool registerBlock = true;
+    // Vectorize the innermost loops that carry no dependence
+    bool vectorize = true;
+
+    std::string toString() const;
+    // std::nullopt if s was not produced by toString
+    static std::optional<LoopSchedule> parse(const std::string& s);
+};
+
+// The schedules tried by the autotuner
+TORCH_API std::vector<LoopSchedule> loopScheduleCandidates(bool hasReduction);
+
+/*
+ * The launch configuration of the pointwise CUDA kernels built by
+ * TensorExprKernel::transformLoops.
+ *
+ * The flattened loop of every output is split by blockSize and bound to
+ * blockIdx.x and threadIdx.x (loopLevels 2), or split by
+ * blockCount * blockSize and then blockSize, so that each of blockCount
+ * blocks loops over its share of the elements (loopLevels 3).
+ */
+struct TORCH_API CudaLaunchSchedule
+{
+    int loopLevels = 2;
+    int blockSize  = 512;
+    int blockCount = 1280;
+
+    std::string toString() const;
+    // std::nullopt if s was not produced by toString
+    static std::optional<CudaLaunchSchedule> parse(const std::string& s);
+};
+
+// The launch schedules tried by the autotuner, starting from the block size
+// and grid size of highest occupancy of the kernel (see CodeGen::launchHint),
+// ignored when not positive
+TORCH_API std::vector<CudaLaunchSchedule> cudaLaunchScheduleCandidates(
+    int occupancyBlockSize, int occupancyGridSize);
+
+// The steps of a LoopSchedule. Loops that cannot be transformed are left
+// unchanged.
+void tileInnerLoops(LoopNest& l, int factor);
+void interchangeReductionLoops(LoopNest& l);
+// Turns every reduction C[m, n] += ... over k, with constant bounds, into
+//   for each 4 x (vector width) tile of C
+//     for k
+//       accumulate the whole tile in registers
+//     store the tile
+// with the column tiles blocked so that the panels of the right-hand side
+// they read stay in the L2 cache (cpu_topology) across the row tiles.
+void registerBlockReductions(LoopNest& l);
+void vectorizeIndependentInnerLoops(LoopNest& l);
+
+/*
+ * Compiles every statement with the codegen `codegenName`, runs it on
+ * random inputs and returns the index of the fastest one.
+ *
+ * All the statements take `args`. The buffers in `bound` are passed as
+ * given, the other arguments are allocated and must be floating point
+ * buffers of static shape; on a device other than the CPU they are
+ * allocated on the device, and the timings wait for its current stream.
+ * Statement 0 is the reference: a statement that fails to compile, or
+ * writes `outputs` that differ from those of the reference, is never
+ * picked. Returns std::nullopt if the arguments cannot be allocated or the
+ * reference fails.
+ */
+TORCH_API std::optional<size_t> pickFastestStmt(
+    const std::string&                       codegenName,
+    const std::vector<StmtPtr>&              stmts,
+    const std::vector<CodeGen::BufferArg>&   args,
+    const std::unordered_map<BufPtr, void*>& bound,
+    const std::unordered_set<BufPtr>&        outputs,
+    quarisma::Device                         device,
+    const std::string&                       kernelFuncName);
+
+}  // namespace torch::jit::tensorexpr
@@ -918,6 +918,18 @@ void MemDependencyChecker::visit(const ForPtr& v)
     // Store buffers allocated quarisma this scope.
     std::unordered_set<VarPtr> local_intermediates;
 
+    // The positions of the writes to each buffer, so that a read only scans the
+    // writes to its own buffer rather than every access in the loop.
+    std::unordered_map<VarPtr, std::vector<size_t>> writesByVar;
+    for (size_t j = 0; j < currentScope_->accesses_.size(); ++j)
+    {
+        const auto& access = currentScope_->accesses_[j];
+        if (access->isWrite())
+        {
+            writesByVar[access->var()].push_back(j);
+        }
+    }
+
     // Scanning from the top of the loop, we look for accesses which may depend
     // on a previous or parallel loop iteration.
     for (size_t a = 0; a < currentScope_->accesses_.size(); ++a)
@@ -940,25 +952,22 @@ void MemDependencyChecker::visit(const ForPtr& v)
             continue;
         }
 
+        auto writes = writesByVar.find(info->var());
+        if (writes == writesByVar.end())
+        {
+            continue;
+        }
+
         // Copy the bounds so we can keep track of open bounds internally without
         // affecting the merge into the enclosing scope. The open portion of the
         // bounds may be cut into multiple independent slices.
         std::vector<IndexBounds> openBounds({info->bounds()});
 
         // Scan from the bottom of the loop.
-        for (size_t j = currentScope_->accesses_.size() - 1; j > a; --j)
+        for (auto w = writes->second.rbegin(); w != writes->second.rend() && *w > a; ++w)
         {
+            size_t                      j     = *w;
             std::shared_ptr<AccessInfo> other = currentScope_->accesses_[j];
-            if (!other->isWrite())
-            {
-                continue;
-            }
-
-            if (info->var() != other->var())
-            {
-                continue;
-            }
-
             if (info->hasDependency(other))
             {
                 continue;
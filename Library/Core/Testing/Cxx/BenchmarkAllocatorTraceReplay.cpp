@@ -0,0 +1,605 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @file BenchmarkAllocatorTraceReplay.cpp
+ * @brief Replays recorded allocation traces against the CPU allocators
+ *
+ * A trace is the allocation history of an allocator_tracking instance with
+ * enhanced tracking: the size and alignment of every allocation, the order of
+ * all allocation and deallocation events, and the threads that performed them.
+ * Each benchmark replays the trace with 1 to 64 threads; the events of a
+ * recorded thread go to replay thread `recorded_thread % threads`, so frees
+ * made by another thread than the allocation stay cross-thread frees. A free
+ * waits until its allocation has been replayed, which preserves the recorded
+ * order without a global lock.
+ *
+ * Reported counters:
+ * - items_per_second: replayed allocations and frees per second
+ * - p50_ns, p99_ns: latency of a single allocate_raw() or deallocate_raw()
+ * - peak_rss_MiB: growth of the resident set over the benchmark
+ * - frag: peak resident growth divided by the peak live requested bytes
+ *
+ * The resident set is the process's, so memory an earlier benchmark left
+ * cached in the process inflates or hides the growth of a later one; run a
+ * single backend per process (--benchmark_filter) when comparing RSS and frag.
+ *
+ * By default the trace is recorded at start-up from a synthetic workload of 64
+ * threads mixing short-lived objects, long-lived buffers and objects handed to
+ * another thread. Set QUARISMA_ALLOC_TRACE to the path of a CSV file to replay
+ * a real trace instead, one allocation per line:
+ *
+ *     requested_bytes,alignment,alloc_sequence,dealloc_sequence,alloc_thread,dealloc_thread
+ *
+ * which is what the fields of allocator_tracking::GetEnhancedRecords() give:
+ * ```cpp
+ * for (const auto& r : tracker->GetEnhancedRecords())
+ *     out << r.requested_bytes << ',' << r.alignment << ',' << r.alloc_sequence << ','
+ *         << r.dealloc_sequence << ',' << r.alloc_thread << ',' << r.dealloc_thread << '\n';
+ * ```
+ * Allocations never freed (dealloc_sequence 0) are freed after the replay.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "common/pointer.h"
+#include "logging/logger.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/backend/allocator_slab.h"
+#include "memory/backend/allocator_tracking.h"
+#include "memory/cpu/allocator.h"
+#include "memory/cpu/allocator_cpu.h"
+#include "memory/helper/memory_allocator.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+using namespace quarisma;
+
+namespace
+{
+
+// =============================================================================
+// Trace
+// =============================================================================
+
+/**
+ * @brief One allocation or deallocation of a trace
+ */
+struct trace_event
+{
+    uint32_t slot;    ///< Index of the allocation in alloc_trace::bytes
+    uint32_t thread;  ///< Recorded thread, dense from 0
+    bool     is_free;
+};
+
+/**
+ * @brief Allocation trace in event order
+ */
+struct alloc_trace
+{
+    std::vector<size_t>      bytes;      ///< Requested bytes of each allocation
+    std::vector<size_t>      alignment;  ///< Alignment of each allocation
+    std::vector<trace_event> events;     ///< All events, in recorded order
+    size_t                   peak_live_bytes = 0;
+    uint32_t                 threads         = 0;
+};
+
+struct trace_record
+{
+    size_t   requested_bytes;
+    size_t   alignment;
+    uint64_t alloc_sequence;
+    uint64_t dealloc_sequence;
+    uint64_t alloc_thread;
+    uint64_t dealloc_thread;
+};
+
+alloc_trace build_trace(const std::vector<trace_record>& records)
+{
+    alloc_trace                            trace;
+    std::unordered_map<uint64_t, uint32_t> thread_ids;
+    auto                                   dense_thread = [&](uint64_t id)
+    { return thread_ids.emplace(id, static_cast<uint32_t>(thread_ids.size())).first->second; };
+
+    std::vector<std::pair<uint64_t, trace_event>> ordered;
+    ordered.reserve(records.size() * 2);
+    for (const auto& record : records)
+    {
+        if (record.requested_bytes == 0)
+        {
+            continue;
+        }
+        auto const slot = static_cast<uint32_t>(trace.bytes.size());
+        trace.bytes.push_back(record.requested_bytes);
+        trace.alignment.push_back(std::max<size_t>(record.alignment, 8));
+        ordered.push_back(
+            {record.alloc_sequence, {slot, dense_thread(record.alloc_thread), false}});
+        if (record.dealloc_sequence != 0)
+        {
+            ordered.push_back(
+                {record.dealloc_sequence, {slot, dense_thread(record.dealloc_thread), true}});
+        }
+    }
+    std::sort(
+        ordered.begin(),
+        ordered.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    size_t live = 0;
+    trace.events.reserve(ordered.size());
+    for (const auto& entry : ordered)
+    {
+        const trace_event& event = entry.second;
+        live = event.is_free ? live - trace.bytes[event.slot] : live + trace.bytes[event.slot];
+        trace.peak_live_bytes = std::max(trace.peak_live_bytes, live);
+        trace.events.push_back(event);
+    }
+    trace.threads = static_cast<uint32_t>(thread_ids.size());
+    return trace;
+}
+
+std::vector<trace_record> load_trace_csv(const std::string& path)
+{
+    std::vector<trace_record> records;
+    std::ifstream             file(path);
+    std::string               line;
+    while (std::getline(file, line))
+    {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        trace_record       record{};
+        if (fields >> record.requested_bytes >> record.alignment >> record.alloc_sequence >>
+            record.dealloc_sequence >> record.alloc_thread >> record.dealloc_thread)
+        {
+            records.push_back(record);
+        }
+    }
+    return records;
+}
+
+constexpr int    kRecordedThreads      = 64;
+constexpr int    kAllocationsPerThread = 320;
+constexpr size_t kHandOffQueueCapacity = 256;
+constexpr size_t kLiveObjectsPerThread = 48;
+constexpr size_t kLargeBufferBytes     = 256 << 10;
+
+/**
+ * @brief Record the synthetic workload through allocator_tracking
+ *
+ * Each thread keeps a window of live objects with log-uniform sizes and frees
+ * a random one when the window is full; one allocation in eight is a large
+ * buffer kept until the thread ends, and one small object in five is handed to
+ * the next thread, which frees it.
+ */
+std::vector<trace_record> record_synthetic_trace()
+{
+    auto* tracker = new allocator_tracking(cpu_allocator(0), true, true);
+
+    struct hand_off
+    {
+        std::mutex         mutex;
+        std::deque<void*> queue;
+    };
+    std::vector<hand_off> queues(kRecordedThreads);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kRecordedThreads; ++t)
+    {
+        workers.emplace_back(
+            [&, t]()
+            {
+                std::mt19937                          rng(static_cast<uint32_t>(t + 1));
+                std::uniform_real_distribution<double> log_size(4.0, 13.0);
+                std::uniform_int_distribution<int>     percent(0, 99);
+                std::vector<void*>                     live;
+                std::vector<void*>                     buffers;
+
+                for (int i = 0; i < kAllocationsPerThread; ++i)
+                {
+                    if (percent(rng) < 12)
+                    {
+                        buffers.push_back(tracker->allocate_raw(64, kLargeBufferBytes));
+                        continue;
+                    }
+                    const auto bytes = static_cast<size_t>(std::exp2(log_size(rng)));
+                    void*      ptr   = tracker->allocate_raw(64, bytes);
+
+                    if (percent(rng) < 20)
+                    {
+                        auto&                  next = queues[(t + 1) % kRecordedThreads];
+                        std::scoped_lock const lock(next.mutex);
+                        if (next.queue.size() < kHandOffQueueCapacity)
+                        {
+                            next.queue.push_back(ptr);
+                            ptr = nullptr;
+                        }
+                    }
+                    if (ptr != nullptr)
+                    {
+                        live.push_back(ptr);
+                    }
+                    if (live.size() > kLiveObjectsPerThread)
+                    {
+                        std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+                        std::swap(live[pick(rng)], live.back());
+                        tracker->deallocate_raw(live.back());
+                        live.pop_back();
+                    }
+
+                    std::deque<void*> received;
+                    {
+                        std::scoped_lock const lock(queues[t].mutex);
+                        received.swap(queues[t].queue);
+                    }
+                    for (void* handed : received)
+                    {
+                        tracker->deallocate_raw(handed);
+                    }
+                }
+                for (void* ptr : live)
+                {
+                    tracker->deallocate_raw(ptr);
+                }
+                for (void* ptr : buffers)
+                {
+                    tracker->deallocate_raw(ptr);
+                }
+            });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    for (auto& q : queues)
+    {
+        for (void* ptr : q.queue)
+        {
+            tracker->deallocate_raw(ptr);
+        }
+    }
+
+    std::vector<trace_record> records;
+    for (const auto& r : tracker->GetEnhancedRecords())
+    {
+        records.push_back(
+            {r.requested_bytes,
+             r.alignment,
+             r.alloc_sequence,
+             r.dealloc_sequence,
+             r.alloc_thread,
+             r.dealloc_thread});
+    }
+    tracker->GetRecordsAndUnRef();
+    return records;
+}
+
+const alloc_trace& replay_trace()
+{
+    static const alloc_trace trace = []()
+    {
+        const char* path = std::getenv("QUARISMA_ALLOC_TRACE");
+        alloc_trace result =
+            build_trace(path != nullptr ? load_trace_csv(path) : record_synthetic_trace());
+        QUARISMA_LOG_INFO(
+            "Replaying {} allocation events of {} threads, peak live {} bytes",
+            result.events.size(),
+            result.threads,
+            result.peak_live_bytes);
+        return result;
+    }();
+    return trace;
+}
+
+// =============================================================================
+// Replay
+// =============================================================================
+
+size_t resident_bytes()
+{
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    size_t        pages    = 0;
+    size_t        resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Replay the trace on `threads` threads and report the counters
+ */
+void replay(benchmark::State& state, Allocator* allocator)
+{
+    const alloc_trace& trace   = replay_trace();
+    const auto         threads = static_cast<uint32_t>(state.range(0));
+
+    std::vector<std::vector<uint32_t>> schedule(threads);
+    for (uint32_t i = 0; i < trace.events.size(); ++i)
+    {
+        schedule[trace.events[i].thread % threads].push_back(i);
+    }
+    std::vector<bool> freed(trace.bytes.size(), false);
+    for (const auto& event : trace.events)
+    {
+        if (event.is_free)
+        {
+            freed[event.slot] = true;
+        }
+    }
+
+    const size_t              rss_before = resident_bytes();
+    std::atomic<size_t>       peak_rss{rss_before};
+    std::vector<int64_t>      latencies;
+    std::vector<void*>        leftovers;
+    std::unique_ptr<std::atomic<void*>[]> ptrs(new std::atomic<void*>[trace.bytes.size()]);
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < trace.bytes.size(); ++i)
+        {
+            ptrs[i].store(nullptr, std::memory_order_relaxed);
+        }
+        std::vector<std::vector<int64_t>> thread_latencies(threads);
+        std::atomic<uint32_t>             ready{0};
+        std::atomic<bool>                 go{false};
+        std::atomic<bool>                 done{false};
+
+        // Samples the resident set while the replay runs
+        std::thread sampler(
+            [&]()
+            {
+                while (!done.load(std::memory_order_acquire))
+                {
+                    const size_t rss = resident_bytes();
+                    size_t       seen = peak_rss.load(std::memory_order_relaxed);
+                    while (rss > seen && !peak_rss.compare_exchange_weak(seen, rss))
+                    {
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+
+        std::vector<std::thread> workers;
+        for (uint32_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back(
+                [&, t]()
+                {
+                    auto& samples = thread_latencies[t];
+                    samples.reserve(schedule[t].size());
+                    ready.fetch_add(1);
+                    while (!go.load(std::memory_order_acquire))
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    for (const uint32_t index : schedule[t])
+                    {
+                        const trace_event& event = trace.events[index];
+                        if (event.is_free)
+                        {
+                            void* ptr = ptrs[event.slot].load(std::memory_order_acquire);
+                            while (ptr == nullptr)
+                            {
+                                std::this_thread::yield();
+                                ptr = ptrs[event.slot].load(std::memory_order_acquire);
+                            }
+                            const auto start = std::chrono::steady_clock::now();
+                            allocator->deallocate_raw(ptr);
+                            samples.push_back((std::chrono::steady_clock::now() - start).count());
+                            continue;
+                        }
+
+                        const size_t bytes = trace.bytes[event.slot];
+                        const auto   start = std::chrono::steady_clock::now();
+                        void* ptr = allocator->allocate_raw(trace.alignment[event.slot], bytes);
+                        samples.push_back((std::chrono::steady_clock::now() - start).count());
+
+                        // Touch every page, as the application would
+                        auto* data = static_cast<char*>(ptr);
+                        for (size_t offset = 0; offset < bytes; offset += 4096)
+                        {
+                            data[offset] = 1;
+                        }
+                        ptrs[event.slot].store(ptr, std::memory_order_release);
+                    }
+                });
+        }
+        while (ready.load() < threads)
+        {
+            std::this_thread::yield();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        state.SetIterationTime(std::chrono::duration<double>(elapsed).count());
+
+        done.store(true, std::memory_order_release);
+        sampler.join();
+
+        // Free what the trace left allocated
+        for (size_t i = 0; i < trace.bytes.size(); ++i)
+        {
+            if (!freed[i])
+            {
+                allocator->deallocate_raw(ptrs[i].load(std::memory_order_relaxed));
+            }
+        }
+
+        for (auto& samples : thread_latencies)
+        {
+            latencies.insert(latencies.end(), samples.begin(), samples.end());
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p)
+    {
+        return latencies.empty()
+                   ? 0.0
+                   : static_cast<double>(latencies[static_cast<size_t>(
+                         p * static_cast<double>(latencies.size() - 1))]);
+    };
+    const size_t rss_growth = peak_rss.load() - std::min(peak_rss.load(), rss_before);
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(trace.events.size()));
+    state.counters["p50_ns"]       = percentile(0.50);
+    state.counters["p99_ns"]       = percentile(0.99);
+    state.counters["peak_rss_MiB"] = static_cast<double>(rss_growth) / (1 << 20);
+    state.counters["frag"]         = static_cast<double>(rss_growth) /
+                             static_cast<double>(std::max<size_t>(trace.peak_live_bytes, 1));
+}
+
+std::unique_ptr<sub_allocator> make_sub_allocator()
+{
+    return std::make_unique<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+}
+
+/**
+ * @brief Allocator over a pair of memory_allocator functions (mimalloc, TBB)
+ */
+template <void* (*Allocate)(std::size_t, std::size_t), void (*Free)(void*, std::size_t) noexcept>
+class function_allocator : public Allocator
+{
+public:
+    explicit function_allocator(std::string name) : name_(std::move(name)) {}
+
+    std::string Name() const override { return name_; }
+
+    void* allocate_raw(size_t alignment, size_t num_bytes) override
+    {
+        return Allocate(num_bytes, alignment);
+    }
+
+    void deallocate_raw(void* ptr) override { Free(ptr, 0); }
+
+private:
+    std::string name_;
+};
+
+}  // namespace
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+static void BM_TraceReplay_CPU(benchmark::State& state)
+{
+    replay(state, cpu_allocator(0));
+}
+
+static void BM_TraceReplay_BFC(benchmark::State& state)
+{
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+    allocator_bfc allocator(make_sub_allocator(), size_t{16} << 30, "replay_bfc", opts);
+    replay(state, &allocator);
+}
+
+static void BM_TraceReplay_BFCThreadCache(benchmark::State& state)
+{
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+    opts.thread_cache = true;
+    allocator_bfc allocator(make_sub_allocator(), size_t{16} << 30, "replay_bfc_tc", opts);
+    replay(state, &allocator);
+}
+
+static void BM_TraceReplay_Pool(benchmark::State& state)
+{
+    allocator_pool allocator(
+        1024,
+        true,
+        make_sub_allocator(),
+        util::make_ptr_unique_mutable<Pow2Rounder>(),
+        "replay_pool");
+    replay(state, &allocator);
+}
+
+static void BM_TraceReplay_Slab(benchmark::State& state)
+{
+    allocator_slab allocator(make_sub_allocator(), "replay_slab", allocator_slab::Options{});
+    replay(state, &allocator);
+}
+
+#if QUARISMA_HAS_MIMALLOC
+static void BM_TraceReplay_Mimalloc(benchmark::State& state)
+{
+    function_allocator<cpu::memory_allocator::allocate_mi, cpu::memory_allocator::free_mi>
+        allocator("mimalloc");
+    replay(state, &allocator);
+}
+#endif
+
+#if QUARISMA_HAS_TBB
+static void BM_TraceReplay_TBB(benchmark::State& state)
+{
+    function_allocator<cpu::memory_allocator::allocate_tbb, cpu::memory_allocator::free_tbb>
+        allocator("tbb");
+    replay(state, &allocator);
+}
+#endif
+
+// clang-format off
+#define QUARISMA_TRACE_REPLAY(fn, label) \
+    BENCHMARK(fn)->Name("TraceReplay/" label)->RangeMultiplier(2)->Range(1, 64) \
+        ->UseManualTime()->Unit(benchmark::kMillisecond)
+// clang-format on
+
+QUARISMA_TRACE_REPLAY(BM_TraceReplay_CPU, "CPU");
+QUARISMA_TRACE_REPLAY(BM_TraceReplay_BFC, "BFC");
+QUARISMA_TRACE_REPLAY(BM_TraceReplay_BFCThreadCache, "BFCThreadCache");
+QUARISMA_TRACE_REPLAY(BM_TraceReplay_Pool, "Pool");
+QUARISMA_TRACE_REPLAY(BM_TraceReplay_Slab, "Slab");
+#if QUARISMA_HAS_MIMALLOC
+QUARISMA_TRACE_REPLAY(BM_TraceReplay_Mimalloc, "Mimalloc");
+#endif
+#if QUARISMA_HAS_TBB
+QUARISMA_TRACE_REPLAY(BM_TraceReplay_TBB, "TBB");
+#endif
@@ -27,6 +27,8 @@
 
 #include "common/configure.h"
 #include "common/macros.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/backend/allocator_slab.h"
 #include "memory/helper/memory_allocator.h"
 
 // Standard aligned allocation
@@ -88,6 +90,34 @@ public:
     const char* name() const noexcept override { return "tbb_scalable"; }
 };
 
+class slab_benchmark_allocator : public allocator_benchmark_interface
+{
+public:
+    slab_benchmark_allocator()
+        : slab_(
+              std::make_unique<basic_cpu_allocator>(
+                  0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{}),
+              "benchmark_slab",
+              allocator_slab::Options{})
+    {
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment = 64) noexcept override
+    {
+        return slab_.allocate_raw(alignment, size);
+    }
+
+    void deallocate(void* ptr, QUARISMA_UNUSED std::size_t size = 0) noexcept override
+    {
+        slab_.deallocate_raw(ptr);
+    }
+
+    const char* name() const noexcept override { return "slab"; }
+
+private:
+    allocator_slab slab_;
+};
+
 class standard_aligned_benchmark_allocator : public allocator_benchmark_interface
 {
 public:
@@ -309,6 +339,12 @@ BENCHMARK_TEMPLATE(benchmark_simple_allocation, tbb_scalable_benchmark_allocator
     ->Unit(benchmark::kMicrosecond);
 #endif
 
+// Requests above allocator_slab::kMaxObjectSize are forwarded: only its range is measured
+BENCHMARK_TEMPLATE(benchmark_simple_allocation, slab_benchmark_allocator)
+    ->Name("BM_Slab_SimpleAllocation")
+    ->Range(16, allocator_slab::kMaxObjectSize)
+    ->Unit(benchmark::kMicrosecond);
+
 // =============================================================================
 // Batch Allocation Benchmarks
 // =============================================================================
@@ -419,6 +455,47 @@ BENCHMARK_TEMPLATE(benchmark_memory_access_pattern, tbb_scalable_benchmark_alloc
     ->Unit(benchmark::kMicrosecond);
 #endif
 
+// =============================================================================
+// Small Object Benchmarks
+// =============================================================================
+
+// Node-, handle- and small-vector-sized blocks: the slab allocator target
+BENCHMARK_TEMPLATE(benchmark_batch_allocation, malloc_benchmark_allocator)
+    ->Name("BM_Malloc_SmallObjects")
+    ->Args({1000, 16})
+    ->Args({1000, 64})
+    ->Args({1000, 256})
+    ->Args({10000, 64})
+    ->Unit(benchmark::kMicrosecond);
+
+#if QUARISMA_HAS_MIMALLOC
+BENCHMARK_TEMPLATE(benchmark_batch_allocation, mimalloc_benchmark_allocator)
+    ->Name("BM_Mimalloc_SmallObjects")
+    ->Args({1000, 16})
+    ->Args({1000, 64})
+    ->Args({1000, 256})
+    ->Args({10000, 64})
+    ->Unit(benchmark::kMicrosecond);
+#endif
+
+#if QUARISMA_HAS_TBB
+BENCHMARK_TEMPLATE(benchmark_batch_allocation, tbb_scalable_benchmark_allocator)
+    ->Name("BM_TBBScalable_SmallObjects")
+    ->Args({1000, 16})
+    ->Args({1000, 64})
+    ->Args({1000, 256})
+    ->Args({10000, 64})
+    ->Unit(benchmark::kMicrosecond);
+#endif
+
+BENCHMARK_TEMPLATE(benchmark_batch_allocation, slab_benchmark_allocator)
+    ->Name("BM_Slab_SmallObjects")
+    ->Args({1000, 16})
+    ->Args({1000, 64})
+    ->Args({1000, 256})
+    ->Args({10000, 64})
+    ->Unit(benchmark::kMicrosecond);
+
 // =============================================================================
 // Alignment-Specific Benchmarks
 // =============================================================================
@@ -584,5 +661,11 @@ BENCHMARK_TEMPLATE(benchmark_fragmentation_pattern, tbb_scalable_benchmark_alloc
     ->Unit(benchmark::kMicrosecond);
 #endif
 
+BENCHMARK_TEMPLATE(benchmark_fragmentation_pattern, slab_benchmark_allocator)
+    ->Name("BM_Slab_Fragmentation")
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Unit(benchmark::kMicrosecond);
+
 }  // namespace benchmarks
 }  // namespace quarisma
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Benchmark suite for the block-linked queues of util/lock_free_queue.h
+ *
+ * Compares the single-producer LockFreeQueue with MultiProducerLockFreeQueue:
+ * - push/pop on one thread: cost of the push path, including block allocation
+ *   for LockFreeQueue and block reuse for MultiProducerLockFreeQueue
+ * - one producer thread and a consumer draining with PopAll()
+ * - several producer threads feeding one consumer (multi-producer queue only)
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "util/lock_free_queue.h"
+
+namespace quarisma
+{
+namespace
+{
+using spsc_queue = LockFreeQueue<std::int64_t>;
+using mpsc_queue = MultiProducerLockFreeQueue<std::int64_t>;
+
+constexpr std::int64_t kElements = 1 << 16;
+
+// Benchmark 1: push then drain on the calling thread
+template <typename Queue>
+void BM_LockFreeQueue_PushPop(benchmark::State& state)
+{
+    Queue        queue;
+    std::int64_t sum = 0;
+    for (auto _ : state)
+    {
+        for (std::int64_t i = 0; i < kElements; ++i)
+        {
+            queue.push(std::int64_t{i});
+        }
+        while (auto element = queue.pop())
+        {
+            sum += *element;
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK_TEMPLATE(BM_LockFreeQueue_PushPop, spsc_queue);
+BENCHMARK_TEMPLATE(BM_LockFreeQueue_PushPop, mpsc_queue);
+
+// Benchmark 2: producer threads pushing kElements in total, consumer draining
+// with PopAll() on the benchmark thread. state.range(0) is the producer count.
+template <typename Queue>
+void BM_LockFreeQueue_Producers(benchmark::State& state)
+{
+    const auto         producers    = static_cast<int>(state.range(0));
+    const std::int64_t per_producer = kElements / producers;
+
+    Queue        queue;
+    std::int64_t sum = 0;
+    for (auto _ : state)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(producers);
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back(
+                [&queue, per_producer]
+                {
+                    for (std::int64_t i = 0; i < per_producer; ++i)
+                    {
+                        queue.push(std::int64_t{i});
+                    }
+                });
+        }
+
+        std::int64_t received = 0;
+        while (received < per_producer * producers)
+        {
+            for (const auto value : queue.PopAll())
+            {
+                sum += value;
+                ++received;
+            }
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * per_producer * producers);
+}
+BENCHMARK_TEMPLATE(BM_LockFreeQueue_Producers, spsc_queue)->Arg(1)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockFreeQueue_Producers, mpsc_queue)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace quarisma
+
+BENCHMARK_MAIN();
@@ -0,0 +1,713 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @file BenchmarkMemoryBandwidth.cpp
+ * @brief Memory bandwidth, latency and TLB baselines through the Core allocators
+ *
+ * Three families, meant to be run once per new machine type and compared
+ * when an allocator or NUMA placement change claims to help:
+ *
+ * - Stream/<kernel>: the STREAM copy, scale, add and triad kernels over
+ *   arrays of at least four times the L3 of the machine, split over
+ *   parallel_tools with 1 to all threads. Memory comes from cpu_allocator(),
+ *   from allocator_bfc over basic_cpu_allocator, or from allocator_bfc over
+ *   huge_page_cpu_allocator with transparent or explicit 2 MiB pages.
+ *   bytes_per_second counts the bytes STREAM counts: reads plus writes,
+ *   without write-allocate traffic.
+ * - Latency/PointerChase: dependent loads around a random cycle of cache
+ *   lines, from a thread bound to cpu_node over memory from
+ *   cpu_allocator(memory_node), first touched by a thread bound to
+ *   memory_node. The working set sweep shows each cache level, then DRAM
+ *   of the local and of every remote node. placed_node is the node the
+ *   memory actually landed on, -1 without NUMA support.
+ * - TLB/PageWalk: one load per 4 KiB of the working set in random order,
+ *   over base pages, transparent huge pages and explicit 2 MiB and 1 GiB
+ *   pages from huge_page_cpu_allocator. The access pattern is the same for
+ *   every page kind, so the difference is the cost of TLB misses. Explicit
+ *   pages are skipped unless enough of them are free in the reserved pool.
+ *
+ * Latency counters: ns_per_load, the average time of one dependent load.
+ *
+ * The topology from cpu_topology (packages, cores, threads, NUMA nodes and
+ * cache sizes) is written into the benchmark context, so that results of
+ * different machines can be told apart and compared against it.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_huge_page.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/cpu/allocator.h"
+#include "memory/numa.h"
+#include "parallel/parallel_tools.h"
+#include "util/cpu_topology.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+using namespace quarisma;
+
+namespace
+{
+// =============================================================================
+// Machine
+// =============================================================================
+
+constexpr size_t kBasePage  = size_t{4} << 10;
+constexpr size_t kHugePage  = size_t{2} << 20;
+constexpr size_t kGiantPage = size_t{1} << 30;
+constexpr size_t kLine      = 64;
+
+int numa_nodes()
+{
+    return std::max(cpu_topology::instance().numa_nodes(), 1);
+}
+
+// Four times the L3 of all packages, as STREAM asks, and no less than 64 MiB
+size_t stream_elements()
+{
+    const auto&  topology = cpu_topology::instance();
+    size_t const l3       = topology.l3().size * static_cast<size_t>(topology.packages());
+    return std::max(4 * l3, size_t{64} << 20) / sizeof(double);
+}
+
+/**
+ * @brief Whether the reserved pool has `bytes` of free explicit pages of `page_size`
+ *
+ * huge_page_cpu_allocator falls back to transparent huge pages when the pool
+ * runs dry, which would measure the wrong pages under an explicit label.
+ */
+bool explicit_pages_free(size_t page_size, size_t bytes)
+{
+    if (!huge_page_cpu_allocator::ExplicitPagesSupported(page_size))
+    {
+        return false;
+    }
+#if defined(__linux__)
+    std::ifstream pool(
+        "/sys/kernel/mm/hugepages/hugepages-" + std::to_string(page_size >> 10) +
+        "kB/free_hugepages");
+    size_t free_pages = 0;
+    return static_cast<bool>(pool >> free_pages) &&
+           free_pages >= (bytes + page_size - 1) / page_size;
+#else
+    return true;
+#endif
+}
+
+std::vector<int> thread_sweep()
+{
+    const int max_threads = std::max(parallel_tools::estimated_default_number_of_threads(), 1);
+    const int cores       = std::min(cpu_topology::instance().cores(), max_threads);
+
+    std::vector<int> result;
+    for (int t = 1; t < max_threads; t *= 2)
+    {
+        result.push_back(t);
+    }
+    result.push_back(cores);
+    result.push_back(max_threads);
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// Written once at start-up, before the benchmarks run
+const bool topology_context = []
+{
+    const auto& topology = cpu_topology::instance();
+    benchmark::AddCustomContext("cpu_topology_detected", topology.detected() ? "yes" : "no");
+    benchmark::AddCustomContext("packages", std::to_string(topology.packages()));
+    benchmark::AddCustomContext("cores", std::to_string(topology.cores()));
+    benchmark::AddCustomContext("processors", std::to_string(topology.processors()));
+    benchmark::AddCustomContext("numa_nodes", std::to_string(topology.numa_nodes()));
+    benchmark::AddCustomContext("l1d_KiB", std::to_string(topology.l1d().size >> 10));
+    benchmark::AddCustomContext("l2_KiB", std::to_string(topology.l2().size >> 10));
+    benchmark::AddCustomContext("l3_KiB", std::to_string(topology.l3().size >> 10));
+    benchmark::AddCustomContext("l3_processors", std::to_string(topology.l3().processors));
+    return true;
+}();
+
+/**
+ * @brief Thread bound to one NUMA node that runs the jobs it is given
+ *
+ * numa_bind() is permanent for a thread, so latency measurements use their
+ * own threads instead of binding the benchmark thread.
+ */
+class node_thread
+{
+public:
+    explicit node_thread(int numa_node)
+        : thread_(
+              [this, numa_node]
+              {
+                  NUMABind(numa_node);
+                  std::unique_lock<std::mutex> lock(mutex_);
+                  for (;;)
+                  {
+                      wake_.wait(lock, [this] { return job_ || stop_; });
+                      if (!job_)
+                      {
+                          return;
+                      }
+                      job_();
+                      job_ = nullptr;
+                      done_.notify_one();
+                  }
+              })
+    {
+    }
+
+    ~node_thread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    void run(std::function<void()> job)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        job_ = std::move(job);
+        wake_.notify_one();
+        done_.wait(lock, [this] { return !job_; });
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::function<void()>   job_;
+    bool                    stop_ = false;
+    std::thread             thread_;
+};
+
+// =============================================================================
+// Pointer chasing
+// =============================================================================
+
+/**
+ * @brief Links one line of every `stride` bytes of `memory` into a random cycle
+ *
+ * The line is also random within its stride, so that strided pages do not
+ * all map to the same cache sets. Returns the start of the cycle.
+ */
+void** build_cycle(void* memory, size_t bytes, size_t stride, uint64_t seed)
+{
+    size_t const        nodes = bytes / stride;
+    size_t const        lines = stride / kLine;
+    std::vector<size_t> order(nodes);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::mt19937_64 rng(seed);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    auto*               base = static_cast<char*>(memory);
+    std::vector<void**> slots(nodes);
+    for (size_t i = 0; i < nodes; ++i)
+    {
+        size_t const line = lines > 1 ? static_cast<size_t>(rng() % lines) : 0;
+        slots[i]          = reinterpret_cast<void**>(base + order[i] * stride + line * kLine);
+    }
+    for (size_t i = 0; i < nodes; ++i)
+    {
+        *slots[i] = slots[(i + 1) % nodes];
+    }
+    return slots[0];
+}
+
+void** chase(void** start, size_t loads)
+{
+    void** p = start;
+    for (size_t i = 0; i < loads; i += 8)
+    {
+        p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p);
+    }
+    return p;
+}
+
+/**
+ * @brief Times `loads` dependent loads per iteration and reports ns_per_load
+ */
+template <typename Chase>
+void time_chase(benchmark::State& state, size_t loads, Chase&& run)
+{
+    double total = 0.0;
+    for (auto _ : state)
+    {
+        double const seconds = run(loads);
+        state.SetIterationTime(seconds);
+        total += seconds;
+    }
+    if (state.iterations() > 0)
+    {
+        state.counters["ns_per_load"] =
+            total * 1e9 / (static_cast<double>(state.iterations()) * static_cast<double>(loads));
+    }
+}
+
+// Loads per iteration: the cycle a few times over, bounded to keep DRAM runs short
+size_t chase_loads(size_t nodes)
+{
+    return std::clamp<size_t>(nodes * 4, size_t{1} << 16, size_t{1} << 22);
+}
+
+// =============================================================================
+// Allocators
+// =============================================================================
+
+enum stream_allocator : int
+{
+    default_cpu    = 0,  ///< cpu_allocator()
+    bfc_base       = 1,  ///< allocator_bfc over basic_cpu_allocator
+    bfc_thp        = 2,  ///< allocator_bfc over transparent huge pages
+    bfc_huge_pages = 3   ///< allocator_bfc over explicit 2 MiB pages
+};
+
+const char* stream_allocator_name(int id)
+{
+    switch (id)
+    {
+    case bfc_base:
+        return "bfc";
+    case bfc_thp:
+        return "bfc_thp";
+    case bfc_huge_pages:
+        return "bfc_huge_2M";
+    default:
+        return "cpu";
+    }
+}
+
+std::unique_ptr<Allocator> make_bfc(std::unique_ptr<sub_allocator> pages, const char* name)
+{
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+    return std::make_unique<allocator_bfc>(std::move(pages), size_t{64} << 30, name, opts);
+}
+
+std::unique_ptr<sub_allocator> make_huge_pages(size_t page_size, bool explicit_pages)
+{
+    huge_page_cpu_allocator::Options pages;
+    pages.page_size          = page_size;
+    pages.use_explicit_pages = explicit_pages;
+    return std::make_unique<huge_page_cpu_allocator>(
+        NUMANOAFFINITY,
+        std::vector<sub_allocator::Visitor>{},
+        std::vector<sub_allocator::Visitor>{},
+        pages);
+}
+
+/**
+ * @brief The allocator `id`, or nullptr when the system lacks its pages
+ *
+ * `owned` keeps allocators made for the benchmark alive.
+ */
+Allocator* stream_allocator_for(int id, std::unique_ptr<Allocator>& owned)
+{
+    switch (id)
+    {
+    case bfc_base:
+        owned = make_bfc(
+            std::make_unique<basic_cpu_allocator>(
+                NUMANOAFFINITY,
+                std::vector<sub_allocator::Visitor>{},
+                std::vector<sub_allocator::Visitor>{}),
+            "stream_bfc");
+        break;
+    case bfc_thp:
+        owned = make_bfc(make_huge_pages(kHugePage, false), "stream_bfc_thp");
+        break;
+    case bfc_huge_pages:
+        if (!explicit_pages_free(kHugePage, 3 * stream_elements() * sizeof(double)))
+        {
+            return nullptr;
+        }
+        owned = make_bfc(make_huge_pages(kHugePage, true), "stream_bfc_huge_2M");
+        break;
+    default:
+        return cpu_allocator();
+    }
+    return owned.get();
+}
+
+/**
+ * @brief An array of doubles from an Allocator, freed with it
+ */
+struct stream_array
+{
+    stream_array(Allocator* allocator, size_t size)
+        : allocator_(allocator),
+          data_(static_cast<double*>(allocator->allocate_raw(kHugePage, size * sizeof(double))))
+    {
+    }
+
+    ~stream_array()
+    {
+        if (data_ != nullptr)
+        {
+            allocator_->deallocate_raw(data_);
+        }
+    }
+
+    stream_array(const stream_array&)            = delete;
+    stream_array& operator=(const stream_array&) = delete;
+
+    Allocator* allocator_;
+    double*    data_;
+};
+
+// =============================================================================
+// STREAM
+// =============================================================================
+
+enum stream_kernel : int
+{
+    copy  = 0,  ///< c = a
+    scale = 1,  ///< b = s c
+    add   = 2,  ///< c = a + b
+    triad = 3   ///< a = b + s c
+};
+
+const char* stream_kernel_name(int kernel)
+{
+    switch (kernel)
+    {
+    case scale:
+        return "scale";
+    case add:
+        return "add";
+    case triad:
+        return "triad";
+    default:
+        return "copy";
+    }
+}
+
+// Arrays read and written per element
+int stream_arrays(int kernel)
+{
+    return kernel == add || kernel == triad ? 3 : 2;
+}
+
+// Large blocks, so that a thread streams through whole pages
+constexpr size_t kStreamGrain = size_t{1} << 16;
+
+void BM_Stream(benchmark::State& state)
+{
+    const int kernel    = static_cast<int>(state.range(0));
+    const int allocator = static_cast<int>(state.range(1));
+    const int threads   = static_cast<int>(state.range(2));
+    state.SetLabel(std::string(stream_kernel_name(kernel)) + "/" +
+                   stream_allocator_name(allocator));
+
+    std::unique_ptr<Allocator> owned;
+    Allocator* const           source = stream_allocator_for(allocator, owned);
+    if (source == nullptr)
+    {
+        state.SkipWithError("not enough free explicit 2 MiB pages");
+        return;
+    }
+
+    size_t const n = stream_elements();
+    stream_array a(source, n);
+    stream_array b(source, n);
+    stream_array c(source, n);
+    if (a.data_ == nullptr || b.data_ == nullptr || c.data_ == nullptr)
+    {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    double* const pa = a.data_;
+    double* const pb = b.data_;
+    double* const pc = c.data_;
+    double const  s  = 3.0;
+
+    parallel_tools::local_scope(
+        parallel_tools::config(threads),
+        [&]
+        {
+            // First touch in parallel, so that the pages spread over the nodes of the threads
+            parallel_tools::parallel_for(
+                0,
+                n,
+                kStreamGrain,
+                [=](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        pa[i] = 1.0;
+                        pb[i] = 2.0;
+                        pc[i] = 0.0;
+                    }
+                });
+
+            for (auto _ : state)
+            {
+                parallel_tools::parallel_for(
+                    0,
+                    n,
+                    kStreamGrain,
+                    [=](size_t begin, size_t end)
+                    {
+                        switch (kernel)
+                        {
+                        case scale:
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                pb[i] = s * pc[i];
+                            }
+                            break;
+                        case add:
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                pc[i] = pa[i] + pb[i];
+                            }
+                            break;
+                        case triad:
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                pa[i] = pb[i] + s * pc[i];
+                            }
+                            break;
+                        default:
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                pc[i] = pa[i];
+                            }
+                            break;
+                        }
+                    });
+                benchmark::ClobberMemory();
+            }
+        });
+
+    state.SetBytesProcessed(
+        state.iterations() * static_cast<int64_t>(n * sizeof(double)) * stream_arrays(kernel));
+}
+
+void stream_arguments(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"kernel", "allocator", "threads"});
+    for (const int kernel : {copy, scale, add, triad})
+    {
+        for (const int allocator : {default_cpu, bfc_base, bfc_thp, bfc_huge_pages})
+        {
+            for (const int threads : thread_sweep())
+            {
+                b->Args({kernel, allocator, threads});
+            }
+        }
+    }
+}
+
+// =============================================================================
+// NUMA latency
+// =============================================================================
+
+void BM_Latency_PointerChase(benchmark::State& state)
+{
+    const int    cpu_node    = static_cast<int>(state.range(0));
+    const int    memory_node = static_cast<int>(state.range(1));
+    size_t const bytes       = size_t{1} << state.range(2);
+
+    Allocator* const allocator = cpu_allocator(memory_node);
+    void* const      memory    = allocator->allocate_raw(kBasePage, bytes);
+    if (memory == nullptr)
+    {
+        state.SkipWithError("out of memory");
+        return;
+    }
+
+    void**      start = nullptr;
+    node_thread owner(memory_node);
+    owner.run([&] { start = build_cycle(memory, bytes, kLine, 42); });
+
+    node_thread reader(cpu_node);
+    time_chase(
+        state,
+        chase_loads(bytes / kLine),
+        [&](size_t loads)
+        {
+            double seconds = 0.0;
+            reader.run(
+                [&]
+                {
+                    auto const begin = std::chrono::steady_clock::now();
+                    benchmark::DoNotOptimize(chase(start, loads));
+                    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                            begin)
+                                  .count();
+                });
+            return seconds;
+        });
+
+    state.counters["placed_node"] = GetNUMANode(memory);
+    state.SetLabel(
+        cpu_node == memory_node ? "local" : "remote/" + std::to_string(memory_node));
+    allocator->deallocate_raw(memory);
+}
+
+void latency_arguments(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"cpu_node", "memory_node", "log2_bytes"});
+    for (int cpu_node = 0; cpu_node < numa_nodes(); ++cpu_node)
+    {
+        for (int memory_node = 0; memory_node < numa_nodes(); ++memory_node)
+        {
+            // 16 KiB, within L1d, to 256 MiB, far beyond any L3
+            for (int log2_bytes = 14; log2_bytes <= 28; log2_bytes += 2)
+            {
+                b->Args({cpu_node, memory_node, log2_bytes});
+            }
+        }
+    }
+}
+
+// =============================================================================
+// TLB reach
+// =============================================================================
+
+enum page_kind : int
+{
+    base_pages  = 0,  ///< 4 KiB pages, transparent huge pages disabled
+    thp_pages   = 1,  ///< Transparent 2 MiB pages
+    explicit_2m = 2,  ///< Explicit 2 MiB pages from the reserved pool
+    explicit_1g = 3   ///< Explicit 1 GiB pages, one of which holds any working set here
+};
+
+const char* page_kind_name(int kind)
+{
+    switch (kind)
+    {
+    case thp_pages:
+        return "thp_2M";
+    case explicit_2m:
+        return "huge_2M";
+    case explicit_1g:
+        return "huge_1G";
+    default:
+        return "base_4K";
+    }
+}
+
+void BM_TLB_PageWalk(benchmark::State& state)
+{
+    const int    kind  = static_cast<int>(state.range(0));
+    size_t const bytes = size_t{1} << state.range(1);
+    state.SetLabel(page_kind_name(kind));
+
+    size_t const page_size = kind == explicit_1g ? kGiantPage
+                             : kind == base_pages ? kBasePage
+                                                  : kHugePage;
+    bool const explicit_pages = kind == explicit_2m || kind == explicit_1g;
+    if (explicit_pages && !explicit_pages_free(page_size, bytes))
+    {
+        state.SkipWithError("not enough free explicit pages of this size");
+        return;
+    }
+
+    auto   pages    = make_huge_pages(page_size, explicit_pages);
+    size_t received = 0;
+    void*  memory   = pages->Alloc(page_size, bytes, &received);
+    if (memory == nullptr)
+    {
+        state.SkipWithError("out of memory");
+        return;
+    }
+#if defined(__linux__) && defined(MADV_NOHUGEPAGE)
+    if (kind == base_pages)
+    {
+        // With THP set to "always" the kernel would merge base pages anyway
+        madvise(memory, received, MADV_NOHUGEPAGE);
+    }
+#endif
+
+    void** const start = build_cycle(memory, bytes, kBasePage, 7);
+    time_chase(
+        state,
+        chase_loads(bytes / kBasePage),
+        [&](size_t loads)
+        {
+            auto const begin = std::chrono::steady_clock::now();
+            benchmark::DoNotOptimize(chase(start, loads));
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin)
+                .count();
+        });
+    pages->Free(memory, received);
+}
+
+void tlb_arguments(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"pages", "log2_bytes"});
+    for (const int kind : {base_pages, thp_pages, explicit_2m, explicit_1g})
+    {
+        // 4 MiB, within the reach of a 4 KiB second-level TLB, to 512 MiB
+        for (int log2_bytes = 22; log2_bytes <= 29; ++log2_bytes)
+        {
+            b->Args({kind, log2_bytes});
+        }
+    }
+}
+
+}  // namespace
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+BENCHMARK(BM_Stream)->Name("Stream")->Apply(stream_arguments)->UseRealTime();
+
+BENCHMARK(BM_Latency_PointerChase)
+    ->Name("Latency/PointerChase")
+    ->Apply(latency_arguments)
+    ->UseManualTime();
+
+BENCHMARK(BM_TLB_PageWalk)->Name("TLB/PageWalk")->Apply(tlb_arguments)->UseManualTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,547 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Scaling benchmark suite for the parallel backends
+ *
+ * Sweeps thread count, grain size and per-iteration cost over every backend
+ * available in the build, and reports two counters next to the timings:
+ * - speedup:    serial time of the same kernel / parallel time
+ * - efficiency: speedup / threads
+ * A scheduler regression shows up as a drop of these curves at a given column
+ * of the sweep, independently of the absolute speed of the machine.
+ *
+ * Backends:
+ * - parallel_tools: the backend the library was built with (std_thread, TBB or OpenMP)
+ * - std_thread_rr / std_thread_ws: the std_thread pool, round-robin and work-stealing,
+ *   which is compiled in every configuration
+ * - tbb / openmp: native loops, as an upper reference, when available
+ *
+ * Also covered: nested parallel_for, threaded_callback_queue throughput,
+ * threaded_task_queue round-trip latency and parallel_reduce with and without
+ * the deterministic mode.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/configure.h"
+#include "parallel/parallel_tools.h"
+#include "parallel/std_thread/parallel_thread_pool.h"
+#include "parallel/threaded_callback_queue.h"
+#include "parallel/threaded_task_queue.h"
+
+#if QUARISMA_HAS_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+namespace quarisma
+{
+namespace
+{
+// =============================================================================
+// Kernels
+// =============================================================================
+
+enum workload : int
+{
+    trivial       = 0,  ///< One add per item: measures scheduling overhead
+    memory_bound  = 1,  ///< Streaming triad over arrays larger than the caches
+    compute_bound = 2   ///< Dependent floating point chain per item
+};
+
+const char* workload_name(int kind)
+{
+    switch (kind)
+    {
+    case memory_bound:
+        return "memory_bound";
+    case compute_bound:
+        return "compute_bound";
+    default:
+        return "trivial";
+    }
+}
+
+std::size_t workload_size(int kind)
+{
+    switch (kind)
+    {
+    case memory_bound:
+        return std::size_t{1} << 21;  // 3 x 16 MiB
+    case compute_bound:
+        return std::size_t{1} << 14;
+    default:
+        return std::size_t{1} << 16;
+    }
+}
+
+struct kernel_data
+{
+    explicit kernel_data(int kind)
+        : kind_(kind),
+          a_(workload_size(kind), 0.0),
+          b_(workload_size(kind), 1.0),
+          c_(workload_size(kind), 2.0)
+    {
+    }
+
+    void operator()(std::size_t begin, std::size_t end)
+    {
+        switch (kind_)
+        {
+        case memory_bound:
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                a_[i] = b_[i] + 3.0 * c_[i];
+            }
+            break;
+        case compute_bound:
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                double x = b_[i] + static_cast<double>(i);
+                for (int k = 0; k < 256; ++k)
+                {
+                    x = 0.999 * x + 1.0 / (x + 1.0);
+                }
+                a_[i] = x;
+            }
+            break;
+        default:
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                a_[i] += 1.0;
+            }
+            break;
+        }
+    }
+
+    std::size_t size() const { return a_.size(); }
+
+    static void execute(void* context, std::size_t from, std::size_t to)
+    {
+        (*static_cast<kernel_data*>(context))(from, to);
+    }
+
+    int                 kind_;
+    std::vector<double> a_;
+    std::vector<double> b_;
+    std::vector<double> c_;
+};
+
+/**
+ * Best-of-five serial time of a workload, in seconds, measured once per process.
+ */
+double serial_seconds(int kind)
+{
+    static std::mutex            mutex;
+    static std::map<int, double> cache;
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    auto                              it = cache.find(kind);
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+
+    kernel_data data(kind);
+    data(0, data.size());  // Warm up
+
+    double best = 0.0;
+    for (int run = 0; run < 5; ++run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        data(0, data.size());
+        benchmark::DoNotOptimize(data.a_.data());
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = run == 0 ? seconds : (std::min)(best, seconds);
+    }
+    cache.emplace(kind, best);
+    return best;
+}
+
+/**
+ * Wall time accumulated over the benchmark iterations.
+ */
+class wall_timer
+{
+public:
+    template <typename F>
+    void time(F&& f)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double seconds() const { return seconds_; }
+
+private:
+    double seconds_ = 0.0;
+};
+
+/**
+ * Attach speedup and efficiency counters, relative to the serial time of `kind`.
+ */
+void report_scaling(benchmark::State& state, const wall_timer& timer, int kind, int threads)
+{
+    if (state.iterations() == 0 || timer.seconds() <= 0.0)
+    {
+        return;
+    }
+    const double parallel = timer.seconds() / static_cast<double>(state.iterations());
+    const double speedup  = serial_seconds(kind) / parallel;
+    state.counters["speedup"]    = speedup;
+    state.counters["efficiency"] = speedup / threads;
+}
+
+// =============================================================================
+// Backends
+// =============================================================================
+
+enum backend : int
+{
+    parallel_tools_backend   = 0,
+    std_thread_round_robin   = 1,
+    std_thread_work_stealing = 2,
+    native_tbb               = 3,
+    native_openmp            = 4
+};
+
+const char* backend_name(int id)
+{
+    switch (id)
+    {
+    case std_thread_round_robin:
+        return "std_thread_rr";
+    case std_thread_work_stealing:
+        return "std_thread_ws";
+    case native_tbb:
+        return "tbb";
+    case native_openmp:
+        return "openmp";
+    default:
+        return "parallel_tools";
+    }
+}
+
+std::vector<int> available_backends()
+{
+    std::vector<int> result{
+        parallel_tools_backend, std_thread_round_robin, std_thread_work_stealing};
+#if QUARISMA_HAS_TBB
+    result.push_back(native_tbb);
+#endif
+#if QUARISMA_HAS_OPENMP
+    result.push_back(native_openmp);
+#endif
+    return result;
+}
+
+std::size_t default_grain(std::size_t n, int threads)
+{
+    return (std::max)(n / (4 * static_cast<std::size_t>(threads)), std::size_t{1});
+}
+
+void run_parallel_for(int id, int threads, std::size_t grain, kernel_data& data)
+{
+    const std::size_t n    = data.size();
+    const std::size_t step = grain == 0 ? default_grain(n, threads) : grain;
+    auto&             pool = detail::parallel::parallel_thread_pool::instance();
+
+    switch (id)
+    {
+    case std_thread_round_robin:
+    {
+        auto proxy = pool.allocate_threads(static_cast<std::size_t>(threads));
+        for (std::size_t from = 0; from < n; from += step)
+        {
+            proxy.do_job(&kernel_data::execute, &data, from, (std::min)(from + step, n));
+        }
+        proxy.join();
+        break;
+    }
+    case std_thread_work_stealing:
+        pool.parallel_for_work_stealing(
+            0, n, step, static_cast<std::size_t>(threads), &kernel_data::execute, &data);
+        break;
+#if QUARISMA_HAS_TBB
+    case native_tbb:
+    {
+        static std::map<int, std::unique_ptr<tbb::task_arena>> arenas;
+        auto&                                                   arena = arenas[threads];
+        if (!arena)
+        {
+            arena.reset(new tbb::task_arena(threads));
+        }
+        arena->execute(
+            [&]
+            {
+                if (grain == 0)
+                {
+                    tbb::parallel_for(
+                        tbb::blocked_range<std::size_t>(0, n),
+                        [&data](const tbb::blocked_range<std::size_t>& r)
+                        { data(r.begin(), r.end()); });
+                }
+                else
+                {
+                    tbb::parallel_for(
+                        tbb::blocked_range<std::size_t>(0, n, grain),
+                        [&data](const tbb::blocked_range<std::size_t>& r)
+                        { data(r.begin(), r.end()); },
+                        tbb::simple_partitioner());
+                }
+            });
+        break;
+    }
+#endif
+#if QUARISMA_HAS_OPENMP
+    case native_openmp:
+    {
+        const auto chunks = static_cast<long long>((n + step - 1) / step);
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+        for (long long chunk = 0; chunk < chunks; ++chunk)
+        {
+            const auto from = static_cast<std::size_t>(chunk) * step;
+            data(from, (std::min)(from + step, n));
+        }
+        break;
+    }
+#endif
+    default:
+        parallel_tools::local_scope(
+            parallel_tools::config(threads),
+            [&] { parallel_tools::parallel_for(0, n, grain, data); });
+        break;
+    }
+}
+
+// =============================================================================
+// Argument sweeps
+// =============================================================================
+
+std::vector<int> thread_sweep()
+{
+    const int max_threads = (std::max)(parallel_tools::estimated_default_number_of_threads(), 1);
+
+    std::vector<int> result;
+    for (int t = 1; t < max_threads; t *= 2)
+    {
+        result.push_back(t);
+    }
+    result.push_back(max_threads);
+    return result;
+}
+
+void scaling_arguments(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"backend", "cost", "threads", "grain"});
+    for (const int id : available_backends())
+    {
+        for (const int kind : {trivial, memory_bound, compute_bound})
+        {
+            for (const int threads : thread_sweep())
+            {
+                // 0 lets each backend choose its own grain
+                for (const int grain : {0, 64, 1024, 16384})
+                {
+                    b->Args({id, kind, threads, grain});
+                }
+            }
+        }
+    }
+}
+
+void thread_arguments(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"threads"});
+    for (const int threads : thread_sweep())
+    {
+        b->Arg(threads);
+    }
+}
+
+void reduce_arguments(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({"deterministic", "threads"});
+    for (const int deterministic : {0, 1})
+    {
+        for (const int threads : thread_sweep())
+        {
+            b->Args({deterministic, threads});
+        }
+    }
+}
+
+// =============================================================================
+// Benchmarks
+// =============================================================================
+
+// Benchmark 1: parallel_for scaling over backend x cost x threads x grain
+void BM_Scaling_ParallelFor(benchmark::State& state)
+{
+    const int         id      = static_cast<int>(state.range(0));
+    const int         kind    = static_cast<int>(state.range(1));
+    const int         threads = static_cast<int>(state.range(2));
+    const std::size_t grain   = static_cast<std::size_t>(state.range(3));
+
+    kernel_data data(kind);
+    wall_timer  timer;
+    for (auto _ : state)
+    {
+        timer.time([&] { run_parallel_for(id, threads, grain, data); });
+        benchmark::DoNotOptimize(data.a_.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+    report_scaling(state, timer, kind, threads);
+    state.SetLabel(std::string(backend_name(id)) + "/" + workload_name(kind));
+}
+BENCHMARK(BM_Scaling_ParallelFor)->Apply(scaling_arguments)->UseRealTime();
+
+// Benchmark 2: nested parallel_for, 16 outer blocks each split again
+void BM_Scaling_NestedParallelFor(benchmark::State& state)
+{
+    const int         threads = static_cast<int>(state.range(0));
+    const std::size_t outer   = 16;
+
+    kernel_data       data(compute_bound);
+    const std::size_t block = data.size() / outer;
+    wall_timer        timer;
+    const auto        nested = [&]
+    {
+        parallel_tools::parallel_for(
+            0,
+            outer,
+            1,
+            [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t b = begin; b < end; ++b)
+                {
+                    parallel_tools::parallel_for(b * block, (b + 1) * block, 16, data);
+                }
+            });
+    };
+    for (auto _ : state)
+    {
+        timer.time(
+            [&]
+            { parallel_tools::local_scope(parallel_tools::config(threads, "", true), nested); });
+        benchmark::DoNotOptimize(data.a_.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+    report_scaling(state, timer, compute_bound, threads);
+    state.SetLabel(backend_name(parallel_tools_backend));
+}
+BENCHMARK(BM_Scaling_NestedParallelFor)->Apply(thread_arguments)->UseRealTime();
+
+// Benchmark 3: threaded_callback_queue throughput on tiny tasks
+void BM_Scaling_CallbackQueueThroughput(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+    const int tasks   = 4096;
+
+    threaded_callback_queue queue;
+    queue.set_number_of_threads(threads);
+
+    using future_array = std::vector<threaded_callback_queue::shared_future_pointer<void>>;
+    std::atomic<int> counter{0};
+    future_array     futures;
+    futures.reserve(tasks);
+    for (auto _ : state)
+    {
+        futures.clear();
+        for (int i = 0; i < tasks; ++i)
+        {
+            futures.emplace_back(
+                queue.push([&counter] { counter.fetch_add(1, std::memory_order_relaxed); }));
+        }
+        queue.wait(futures);
+    }
+
+    benchmark::DoNotOptimize(counter.load());
+    state.SetItemsProcessed(state.iterations() * tasks);
+}
+BENCHMARK(BM_Scaling_CallbackQueueThroughput)->Apply(thread_arguments)->UseRealTime();
+
+// Benchmark 4: threaded_task_queue push-to-pop latency of a single task
+void BM_Scaling_TaskQueueLatency(benchmark::State& state)
+{
+    const int threads = static_cast<int>(state.range(0));
+
+    threaded_task_queue<int, int> queue([](int x) { return x + 1; }, true, -1, threads);
+    int                           result = 0;
+    for (auto _ : state)
+    {
+        int value = result;
+        queue.push(std::move(value));
+        queue.pop(result);
+    }
+
+    benchmark::DoNotOptimize(result);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Scaling_TaskQueueLatency)
+    ->Apply(thread_arguments)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// Benchmark 5: floating-point parallel_reduce, default vs deterministic partitioning
+void BM_Scaling_Reduce(benchmark::State& state)
+{
+    const bool deterministic = state.range(0) != 0;
+    const int  threads       = static_cast<int>(state.range(1));
+
+    kernel_data data(memory_bound);
+    const auto  reduce = [&data]
+    {
+        const double sum = parallel_tools::parallel_reduce(
+            0,
+            data.size(),
+            0,
+            0.0,
+            [&data](std::size_t begin, std::size_t end)
+            {
+                double acc = 0.0;
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    acc += data.b_[i] * data.c_[i];
+                }
+                return acc;
+            },
+            [](double a, double b) { return a + b; });
+        benchmark::DoNotOptimize(sum);
+    };
+
+    parallel_tools::set_deterministic(deterministic);
+    for (auto _ : state)
+    {
+        parallel_tools::local_scope(parallel_tools::config(threads), reduce);
+    }
+    parallel_tools::set_deterministic(false);
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+    state.SetLabel(deterministic ? "deterministic" : "default");
+}
+BENCHMARK(BM_Scaling_Reduce)->Apply(reduce_arguments)->UseRealTime();
+
+}  // namespace
+}  // namespace quarisma
+
+BENCHMARK_MAIN();
@@ -0,0 +1,322 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * End-to-end benchmark suite (quarisma_perf)
+ *
+ * Prices a European call by Monte Carlo with parallel_tools::parallel_for and
+ * times it with the observability subsystems switched on one at a time:
+ * - allocator: the scratch buffers of each chunk come from cpu_allocator()
+ *   with statistics enabled instead of std::vector
+ * - tracing: the traceme event of each chunk is recorded (it is only checked
+ *   against the recorder state otherwise)
+ * - logging: each chunk logs its partial sum at INFO to a callback
+ * - all: the three at once
+ *
+ * BM_Perf_Breakdown runs every configuration inside a profiler_scope of a
+ * native profiler session and reports the overhead of each subsystem over the
+ * baseline as counters. Run with --benchmark_format=json (or through
+ * Tools/benchmark/benchmark_regression.py) for machine-readable results; set
+ * QUARISMA_PERF_REPORT to a file name to also export the profiler report.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "logging/logger.h"
+#include "memory/cpu/allocator.h"
+#include "parallel/parallel_tools.h"
+#include "profiler/native/session/profiler.h"
+#include "profiler/native/tracing/traceme.h"
+#include "profiler/native/tracing/traceme_recorder.h"
+
+namespace quarisma
+{
+namespace
+{
+constexpr std::size_t kPaths = 1 << 15;
+constexpr std::size_t kSteps = 32;
+constexpr std::size_t kGrain = 512;
+constexpr std::size_t kChunks = kPaths / kGrain;
+
+constexpr double kSpot       = 100.0;
+constexpr double kStrike     = 105.0;
+constexpr double kRate       = 0.02;
+constexpr double kVolatility = 0.25;
+constexpr double kMaturity   = 1.0;
+
+enum subsystem : unsigned
+{
+    kNone      = 0,
+    kAllocator = 1U << 0,
+    kTracing   = 1U << 1,
+    kLogging   = 1U << 2,
+    kAll       = kAllocator | kTracing | kLogging,
+};
+
+// Counter-based generator: the paths do not depend on how chunks are scheduled
+std::uint64_t splitmix64(std::uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+double uniform_open(std::uint64_t bits)
+{
+    return (static_cast<double>(bits >> 11) + 0.5) * 0x1.0p-53;
+}
+
+// Simulates paths [begin, end) into `increments` (scratch of kSteps doubles per
+// path) and returns the sum of their discounted payoffs.
+double price_chunk(std::size_t begin, std::size_t end, double* increments)
+{
+    constexpr double dt    = kMaturity / kSteps;
+    const double     drift = (kRate - 0.5 * kVolatility * kVolatility) * dt;
+    const double     sigma = kVolatility * std::sqrt(dt);
+
+    const std::size_t count = end - begin;
+    for (std::size_t p = 0; p < count; ++p)
+    {
+        double* z = increments + p * kSteps;
+        for (std::size_t s = 0; s < kSteps; s += 2)
+        {
+            const std::uint64_t key = ((begin + p) * kSteps + s) * 2;
+            const double        r   = std::sqrt(-2.0 * std::log(uniform_open(splitmix64(key))));
+            const double        t   = 6.283185307179586 * uniform_open(splitmix64(key + 1));
+            z[s]                    = drift + sigma * r * std::cos(t);
+            z[s + 1]                = drift + sigma * r * std::sin(t);
+        }
+    }
+
+    double sum = 0.0;
+    for (std::size_t p = 0; p < count; ++p)
+    {
+        const double* z   = increments + p * kSteps;
+        double        log = 0.0;
+        for (std::size_t s = 0; s < kSteps; ++s)
+        {
+            log += z[s];
+        }
+        sum += std::max(kSpot * std::exp(log) - kStrike, 0.0);
+    }
+    return sum * std::exp(-kRate * kMaturity);
+}
+
+// One pricing run; returns the option price
+double run_pricing(unsigned enabled)
+{
+    std::array<double, kChunks> partial{};
+
+    parallel_tools::parallel_for(
+        std::size_t{0},
+        kPaths,
+        kGrain,
+        [enabled, &partial](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t first = begin; first < end; first += kGrain)
+            {
+                const std::size_t last = std::min(first + kGrain, end);
+                const std::size_t size = (last - first) * kSteps;
+
+                // Costs a check of the recorder state when tracing is off
+                traceme const trace("quarisma_perf/price_chunk");
+
+                double sum = 0.0;
+                if ((enabled & kAllocator) != 0)
+                {
+                    Allocator* allocator = cpu_allocator();
+                    auto*      scratch   = static_cast<double*>(allocator->allocate_raw(
+                        Allocator::Allocator_Alignment, size * sizeof(double)));
+                    sum = price_chunk(first, last, scratch);
+                    allocator->deallocate_raw(scratch);
+                }
+                else
+                {
+                    std::vector<double> scratch(size);
+                    sum = price_chunk(first, last, scratch.data());
+                }
+
+                if ((enabled & kLogging) != 0)
+                {
+                    QUARISMA_LOG_INFO(
+                        "chunk {} of {}: payoff sum {}", first / kGrain, kChunks, sum);
+                }
+                partial[first / kGrain] = sum;
+            }
+        });
+
+    double total = 0.0;
+    for (double const sum : partial)
+    {
+        total += sum;
+    }
+    return total / static_cast<double>(kPaths);
+}
+
+void count_message(void* user_data, const logger::Message& /*message*/)
+{
+    static_cast<std::atomic<std::int64_t>*>(user_data)->fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Switches the subsystems of a configuration on for its lifetime. Log messages
+ * go to a callback counting them, with stderr output off, so the cost measured
+ * is that of formatting and dispatching them rather than of the terminal.
+ */
+class observability_guard
+{
+public:
+    explicit observability_guard(unsigned enabled) : enabled_(enabled)
+    {
+        if ((enabled_ & kAllocator) != 0)
+        {
+            EnableCPUAllocatorStats();
+        }
+        if ((enabled_ & kTracing) != 0)
+        {
+            traceme_recorder::start(1);
+        }
+        if ((enabled_ & kLogging) != 0)
+        {
+            logger::SetStderrVerbosity(logger_verbosity_enum::VERBOSITY_OFF);
+            logger::AddCallback(
+                "quarisma_perf", &count_message, &messages_, logger_verbosity_enum::VERBOSITY_INFO);
+        }
+    }
+
+    ~observability_guard()
+    {
+        if ((enabled_ & kLogging) != 0)
+        {
+            logger::RemoveCallback("quarisma_perf");
+            logger::SetStderrVerbosity(logger_verbosity_enum::VERBOSITY_INFO);
+        }
+        if ((enabled_ & kTracing) != 0)
+        {
+            traceme_recorder::stop();
+        }
+        if ((enabled_ & kAllocator) != 0)
+        {
+            DisableCPUAllocatorStats();
+        }
+    }
+
+    // Drops the events recorded so far, so long runs do not grow the recorder
+    void drain() const
+    {
+        if ((enabled_ & kTracing) != 0)
+        {
+            traceme_recorder::stop();
+            traceme_recorder::start(1);
+        }
+    }
+
+    std::int64_t messages() const { return messages_.load(std::memory_order_relaxed); }
+
+    observability_guard(const observability_guard&)            = delete;
+    observability_guard& operator=(const observability_guard&) = delete;
+
+private:
+    unsigned                  enabled_;
+    std::atomic<std::int64_t> messages_{0};
+};
+
+// Benchmark 1: the pricing loop with a given set of subsystems on
+void BM_Perf_Pricing(benchmark::State& state, unsigned enabled)
+{
+    observability_guard const guard(enabled);
+    double                    price = 0.0;
+    for (auto _ : state)
+    {
+        price = run_pricing(enabled);
+        benchmark::DoNotOptimize(price);
+        state.PauseTiming();
+        guard.drain();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(kPaths));
+    state.counters["price"] = price;
+    if ((enabled & kLogging) != 0)
+    {
+        state.counters["log_messages"] = static_cast<double>(guard.messages());
+    }
+}
+BENCHMARK_CAPTURE(BM_Perf_Pricing, baseline, kNone)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Perf_Pricing, allocator, kAllocator)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Perf_Pricing, tracing, kTracing)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Perf_Pricing, logging, kLogging)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Perf_Pricing, all, kAll)->Unit(benchmark::kMillisecond);
+
+// Benchmark 2: every configuration in turn, timed by profiler scopes
+void BM_Perf_Breakdown(benchmark::State& state)
+{
+    struct configuration
+    {
+        const char* name;
+        unsigned    enabled;
+    };
+    static constexpr std::array<configuration, 5> kConfigurations = {{
+        {"baseline", kNone},
+        {"allocator", kAllocator},
+        {"tracing", kTracing},
+        {"logging", kLogging},
+        {"all", kAll},
+    }};
+
+    auto session = profiler_session_builder()
+                       .with_timing(true)
+                       .with_hierarchical_profiling(true)
+                       .with_statistical_analysis(true)
+                       .with_thread_safety(true)
+                       .build();
+    session->start();
+
+    std::array<double, kConfigurations.size()> total_ms{};
+    for (auto _ : state)
+    {
+        for (std::size_t k = 0; k < kConfigurations.size(); ++k)
+        {
+            observability_guard const guard(kConfigurations[k].enabled);
+            profiler_scope            scope(
+                std::string("quarisma_perf/") + kConfigurations[k].name, session.get());
+            benchmark::DoNotOptimize(run_pricing(kConfigurations[k].enabled));
+            scope.stop();
+            total_ms[k] += scope.data().get_duration_ms();
+        }
+    }
+    session->stop();
+
+    // Overhead of each configuration over the baseline, in percent
+    for (std::size_t k = 1; k < kConfigurations.size(); ++k)
+    {
+        state.counters[std::string(kConfigurations[k].name) + "_overhead_pct"] =
+            total_ms[0] > 0.0 ? 100.0 * (total_ms[k] - total_ms[0]) / total_ms[0] : 0.0;
+    }
+    state.counters["baseline_ms"] = benchmark::Counter(
+        total_ms[0], benchmark::Counter::kAvgIterations);
+
+    if (const char* report = std::getenv("QUARISMA_PERF_REPORT"))
+    {
+        session->export_report(report);
+    }
+}
+BENCHMARK(BM_Perf_Breakdown)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace quarisma
+#endif  // QUARISMA_HAS_NATIVE_PROFILER
+
+BENCHMARK_MAIN();
@@ -0,0 +1,78 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Benchmark suite for recording traceme events with arguments
+ *
+ * Compares the two ways of naming an event with arguments while tracing is on:
+ * - a name built by traceme_encode() in the name generator
+ * - an interned traceme_name with typed arguments, formatted at collection
+ * Collecting the events, where interned names are formatted, is not timed.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/tracing/traceme.h"
+#include "profiler/native/tracing/traceme_encode.h"
+#include "profiler/native/tracing/traceme_recorder.h"
+
+namespace quarisma
+{
+namespace
+{
+constexpr std::int64_t kEvents = 1 << 14;
+
+// Benchmark 1: name and arguments encoded into a string when recording
+void BM_Traceme_Encoded(benchmark::State& state)
+{
+    traceme_recorder::start(1);
+    for (auto _ : state)
+    {
+        for (std::int64_t i = 0; i < kEvents; ++i)
+        {
+            traceme const trace(
+                [i]() { return traceme_encode("gemm", {{"rows", i}, {"cols", 64}}); });
+        }
+        state.PauseTiming();
+        traceme_recorder::stop();
+        traceme_recorder::start(1);
+        state.ResumeTiming();
+    }
+    traceme_recorder::stop();
+    state.SetItemsProcessed(state.iterations() * kEvents);
+}
+BENCHMARK(BM_Traceme_Encoded);
+
+// Benchmark 2: interned name and arguments, formatted when the events are collected
+void BM_Traceme_Interned(benchmark::State& state)
+{
+    static const traceme_name kGemm("gemm");
+    static const traceme_name kRows("rows");
+    static const traceme_name kCols("cols");
+
+    traceme_recorder::start(1);
+    for (auto _ : state)
+    {
+        for (std::int64_t i = 0; i < kEvents; ++i)
+        {
+            traceme const trace(kGemm, {{kRows, i}, {kCols, 64}});
+        }
+        state.PauseTiming();
+        traceme_recorder::stop();
+        traceme_recorder::start(1);
+        state.ResumeTiming();
+    }
+    traceme_recorder::stop();
+    state.SetItemsProcessed(state.iterations() * kEvents);
+}
+BENCHMARK(BM_Traceme_Interned);
+
+}  // namespace
+}  // namespace quarisma
+#endif  // QUARISMA_HAS_NATIVE_PROFILER
+
+BENCHMARK_MAIN();
@@ -0,0 +1,185 @@
+/**
+ * @file TestAllocationProfile.cpp
+ * @brief Tests for allocation profiles and allocator warm-up
+ *
+ * Covers:
+ * - Recording peak live allocations per size through allocator_tracking
+ * - Saving and loading profiles
+ * - Reserving BFC regions and filling pools from a profile, within the cap
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/backend/allocator_tracking.h"
+#include "memory/helper/allocation_profile.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+std::unique_ptr<allocator_bfc> create_profile_bfc_allocator()
+{
+    auto sub_alloc = std::make_unique<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+
+    return std::make_unique<allocator_bfc>(
+        std::move(sub_alloc), 64ULL << 20, "profile_bfc", opts);
+}
+
+std::string temp_path(const char* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+}  // namespace
+
+QUARISMATEST(AllocationProfile, records_peaks_through_tracking)
+{
+    auto  bfc     = create_profile_bfc_allocator();
+    auto* tracker = new allocator_tracking(bfc.get(), true, false);
+
+    std::vector<void*> small;
+    for (int i = 0; i < 10; ++i)
+    {
+        small.push_back(tracker->allocate_raw(64, 1000));
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        tracker->deallocate_raw(small.back());
+        small.pop_back();
+    }
+    std::vector<void*> large;
+    for (int i = 0; i < 3; ++i)
+    {
+        large.push_back(tracker->allocate_raw(64, 4096));
+    }
+
+    // Sizes are those BFC hands out: 1000 bytes round up to 1024
+    const auto profile = tracker->GetAllocationProfile();
+    ASSERT_EQ(profile.classes.size(), 2U);
+    EXPECT_EQ(profile.classes[0].bytes, 1024U);
+    EXPECT_EQ(profile.classes[0].peak_count, 10U);
+    EXPECT_EQ(profile.classes[1].bytes, 4096U);
+    EXPECT_EQ(profile.classes[1].peak_count, 3U);
+    EXPECT_EQ(profile.peak_bytes_in_use, 5 * 1024U + 3 * 4096U);
+
+    // ClearStats() restarts the peaks from what is live
+    tracker->ClearStats();
+    EXPECT_EQ(tracker->GetAllocationProfile().classes[0].peak_count, 5U);
+
+    for (void* ptr : small)
+    {
+        tracker->deallocate_raw(ptr);
+    }
+    for (void* ptr : large)
+    {
+        tracker->deallocate_raw(ptr);
+    }
+    tracker->GetRecordsAndUnRef();
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocationProfile, save_and_load)
+{
+    allocation_profile profile;
+    profile.peak_bytes_in_use = 1 << 20;
+    profile.classes           = {{256, 7}, {65536, 2}};
+
+    const std::string path = temp_path("quarisma_allocation_profile.txt");
+    profile.save(path);
+
+    const auto loaded = allocation_profile::load(path);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->peak_bytes_in_use, profile.peak_bytes_in_use);
+    ASSERT_EQ(loaded->classes.size(), 2U);
+    EXPECT_EQ(loaded->classes[1].bytes, 65536U);
+    EXPECT_EQ(loaded->classes[1].peak_count, 2U);
+    EXPECT_EQ(loaded->class_bytes(), 256U * 7 + 65536U * 2);
+
+    std::ofstream(path) << "not a profile\n";
+    EXPECT_ANY_THROW(allocation_profile::load(path));
+
+    std::remove(path.c_str());
+    EXPECT_FALSE(allocation_profile::load(path).has_value());
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocationProfile, warm_up_reserves_bfc_regions)
+{
+    auto bfc = create_profile_bfc_allocator();
+
+    allocation_profile profile;
+    profile.peak_bytes_in_use = 8 << 20;
+
+    // The cap wins over the profile
+    EXPECT_EQ(warm_up_allocator(*bfc, profile, {.max_bytes = 4 << 20}), 4U << 20);
+    EXPECT_GE(bfc->GetStats()->pool_bytes.load(), 4 << 20);
+
+    EXPECT_EQ(warm_up_allocator(*bfc, profile), 8U << 20);
+    const auto pool_bytes = bfc->GetStats()->pool_bytes.load();
+    EXPECT_GE(pool_bytes, 8 << 20);
+    EXPECT_EQ(bfc->GetStats()->bytes_in_use.load(), 0);
+
+    // Requests up to the peak no longer extend the regions
+    std::vector<void*> blocks;
+    for (int i = 0; i < 8; ++i)
+    {
+        blocks.push_back(bfc->allocate_raw(64, (1 << 20) - 4096));
+    }
+    EXPECT_EQ(bfc->GetStats()->pool_bytes.load(), pool_bytes);
+    for (void* ptr : blocks)
+    {
+        bfc->deallocate_raw(ptr);
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocationProfile, warm_up_fills_pool)
+{
+    allocator_pool pool(
+        10,
+        false,
+        std::make_unique<basic_cpu_allocator>(
+            0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{}),
+        std::make_unique<NoopRounder>(),
+        "profile_pool");
+
+    allocation_profile profile;
+    profile.classes = {{1000, 4}, {2000, 20}};
+
+    // Within the byte cap, only two of the smallest class
+    EXPECT_EQ(warm_up_allocator(pool, profile, {.max_bytes = 2500}), 2000U);
+    pool.Clear();
+
+    // Within the pool size limit, four of the first class and six of the second
+    EXPECT_EQ(warm_up_allocator(pool, profile), 4 * 1000U + 6 * 2000U);
+
+    const int64_t hits = pool.get_from_pool_count();
+    std::vector<void*> blocks;
+    for (int i = 0; i < 4; ++i)
+    {
+        blocks.push_back(pool.allocate_raw(64, 1000));
+    }
+    EXPECT_EQ(pool.get_from_pool_count() - hits, 4);
+    for (void* ptr : blocks)
+    {
+        pool.deallocate_raw(ptr);
+    }
+
+    END_TEST();
+}
@@ -12,7 +12,10 @@
  * - Error handling and edge cases
  */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <memory>
 #include <thread>
 #include <vector>
@@ -493,6 +496,479 @@ QUARISMATEST(AllocatorBFC, thread_safety)
     END_TEST();
 }
 
+/**
+ * @brief Test the per-thread cache front-end (Options::thread_cache)
+ */
+QUARISMATEST(AllocatorBFC, thread_cache)
+{
+    auto make_allocator = [](size_t memory_limit, bool allow_growth)
+    {
+        auto sub_alloc = std::make_unique<basic_cpu_allocator>(
+            0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+        allocator_bfc::Options opts;
+        opts.allow_growth = allow_growth;
+        opts.thread_cache = true;
+        return std::make_unique<allocator_bfc>(
+            std::move(sub_alloc), memory_limit, "test_bfc_thread_cache", opts);
+    };
+
+    // Statistics and allocation ids are those of the allocator without cache
+    {
+        auto allocator = make_allocator(64ULL << 20, true);
+
+        void* a = allocator->allocate_raw(64, 100);
+        void* b = allocator->allocate_raw(64, 1000);
+        ASSERT_NE(nullptr, a);
+        ASSERT_NE(nullptr, b);
+        EXPECT_TRUE(is_aligned(a, 64));
+        EXPECT_EQ(allocator->RequestedSize(a), 100);
+        EXPECT_EQ(allocator->RequestedSize(b), 1000);
+        EXPECT_LT(allocator->AllocationId(a), allocator->AllocationId(b));
+
+        auto stats = allocator->GetStats();
+        ASSERT_TRUE(stats.has_value());
+        EXPECT_EQ(stats->num_allocs, 2);
+        EXPECT_EQ(
+            stats->bytes_in_use,
+            static_cast<int64_t>(allocator->AllocatedSize(a) + allocator->AllocatedSize(b)));
+
+        const int64_t id_b = allocator->AllocationId(b);
+        allocator->deallocate_raw(a);
+        allocator->deallocate_raw(b);
+        stats = allocator->GetStats();
+        EXPECT_EQ(stats->bytes_in_use, 0);
+        EXPECT_GT(stats->peak_bytes_in_use, 0);
+
+        // A cached chunk is reused, with a new id and requested size
+        void* c = allocator->allocate_raw(64, 900);
+        EXPECT_EQ(c, b);
+        EXPECT_GT(allocator->AllocationId(c), id_b);
+        EXPECT_EQ(allocator->RequestedSize(c), 900);
+        EXPECT_EQ(allocator->GetStats()->num_allocs, 3);
+        allocator->deallocate_raw(c);
+
+        // Large allocations bypass the cache
+        void* large = allocator->allocate_raw(64, allocator_bfc::kThreadCacheMaxBytes + 1);
+        ASSERT_NE(nullptr, large);
+        allocator->deallocate_raw(large);
+
+        EXPECT_TRUE(allocator->FlushThreadCaches());
+        EXPECT_FALSE(allocator->FlushThreadCaches());
+    }
+
+    // Chunks freed by other threads go back to their cache, caches of exited
+    // threads are returned to the allocator
+    {
+        auto allocator = make_allocator(64ULL << 20, true);
+
+        const int                       num_threads = 4;
+        const int                       iterations  = 2000;
+        std::vector<std::vector<void*>> handoff(num_threads);
+        std::vector<std::thread>        threads;
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back(
+                [&, t]()
+                {
+                    std::vector<void*> live;
+                    for (int i = 0; i < iterations; ++i)
+                    {
+                        const size_t size = 16 + static_cast<size_t>((i * 37 + t * 11) % 4000);
+                        void*        ptr  = allocator->allocate_raw(64, size);
+                        ASSERT_NE(nullptr, ptr);
+                        fill_memory(ptr, size, static_cast<uint8_t>(t));
+                        live.push_back(ptr);
+                        if (live.size() > 16)
+                        {
+                            allocator->deallocate_raw(live.front());
+                            live.erase(live.begin());
+                        }
+                    }
+                    handoff[t] = std::move(live);
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (auto& ptrs : handoff)
+        {
+            for (void* ptr : ptrs)
+            {
+                allocator->deallocate_raw(ptr);
+            }
+        }
+
+        auto stats = allocator->GetStats();
+        EXPECT_EQ(stats->bytes_in_use, 0);
+        EXPECT_EQ(stats->num_allocs, num_threads * iterations);
+    }
+
+    // Memory held by the caches is given back when the allocator runs out
+    {
+        const size_t memory_limit = 1ULL << 20;
+        auto         allocator    = make_allocator(memory_limit, false);
+
+        std::vector<void*> small;
+        for (int i = 0; i < 64; ++i)
+        {
+            small.push_back(allocator->allocate_raw(64, 4096));
+            ASSERT_NE(nullptr, small.back());
+        }
+        for (void* ptr : small)
+        {
+            allocator->deallocate_raw(ptr);
+        }
+
+        allocation_attributes attr;
+        attr.retry_on_failure = false;
+        void* large           = allocator->allocate_raw(64, memory_limit, attr);
+        EXPECT_NE(nullptr, large);
+        allocator->deallocate_raw(large);
+    }
+
+    END_TEST();
+}
+
+/**
+ * @brief Test region compaction and movable allocations
+ */
+QUARISMATEST(AllocatorBFC, compaction_and_movable_allocations)
+{
+    auto make_allocator = [](std::chrono::milliseconds interval, std::chrono::milliseconds idle)
+    {
+        auto sub_alloc = std::make_unique<basic_cpu_allocator>(
+            0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+        allocator_bfc::Options opts;
+        opts.allow_growth        = true;
+        opts.compaction_interval = interval;
+        opts.region_idle_timeout = idle;
+        return std::make_unique<allocator_bfc>(
+            std::move(sub_alloc), 64ULL << 20, "test_bfc_compaction", opts);
+    };
+    auto pool_bytes = [](allocator_bfc& allocator)
+    { return allocator.GetStats()->pool_bytes.load(); };
+
+    constexpr size_t kBlock = 256 * 1024;
+
+    // Fills a byte pattern through a pin, or checks it
+    auto fill = [](allocator_bfc& allocator, allocator_bfc::movable_handle h, unsigned char v)
+    {
+        std::memset(allocator.PinMovable(h), v, kBlock);
+        allocator.UnpinMovable(h);
+    };
+    auto holds = [](allocator_bfc& allocator, allocator_bfc::movable_handle h, unsigned char v)
+    {
+        auto const* p  = static_cast<const unsigned char*>(allocator.PinMovable(h));
+        bool        ok = true;
+        for (size_t i = 0; i < kBlock; ++i)
+        {
+            ok = ok && p[i] == v;
+        }
+        allocator.UnpinMovable(h);
+        return ok;
+    };
+
+    // One block left in each of two regions: compaction moves one of them and
+    // releases the emptied region, without changing the contents
+    {
+        auto allocator = make_allocator(std::chrono::milliseconds(0), std::chrono::milliseconds(0));
+
+        std::vector<allocator_bfc::movable_handle> handles;
+        handles.push_back(allocator->AllocateMovable(64, kBlock));
+        ASSERT_NE(handles.back(), allocator_bfc::kInvalidMovableHandle);
+        int64_t const first_region = pool_bytes(*allocator);
+        while (pool_bytes(*allocator) == first_region)
+        {
+            handles.push_back(allocator->AllocateMovable(64, kBlock));
+            ASSERT_NE(handles.back(), allocator_bfc::kInvalidMovableHandle);
+        }
+        for (size_t i = 1; i + 1 < handles.size(); ++i)
+        {
+            allocator->DeallocateMovable(handles[i]);
+        }
+        allocator_bfc::movable_handle const a = handles.front();
+        allocator_bfc::movable_handle const b = handles.back();
+        fill(*allocator, a, 0x5a);
+        fill(*allocator, b, 0xa5);
+
+        auto stats = allocator->GetStats();
+        EXPECT_GT(stats->largest_free_block_bytes.load(), 0);
+        EXPECT_GE(stats->fragmentation_score(), 0.0);
+        EXPECT_LE(stats->fragmentation_score(), 1.0);
+
+        int64_t const pool_before = pool_bytes(*allocator);
+        size_t const  released    = allocator->Compact();
+        EXPECT_GT(released, 0u);
+        EXPECT_EQ(pool_bytes(*allocator), pool_before - static_cast<int64_t>(released));
+        EXPECT_TRUE(holds(*allocator, a, 0x5a));
+        EXPECT_TRUE(holds(*allocator, b, 0xa5));
+
+        // Pinned blocks stay in place, and nothing else can be released
+        void* pinned = allocator->PinMovable(a);
+        EXPECT_EQ(allocator->Compact(), 0u);
+        EXPECT_EQ(allocator->PinMovable(a), pinned);
+        allocator->UnpinMovable(a);
+        allocator->UnpinMovable(a);
+
+        EXPECT_ANY_THROW(allocator->UnpinMovable(a));
+        allocator->PinMovable(b);
+        EXPECT_ANY_THROW(allocator->DeallocateMovable(b));
+        allocator->UnpinMovable(b);
+
+        allocator->DeallocateMovable(a);
+        allocator->DeallocateMovable(b);
+        EXPECT_ANY_THROW(allocator->PinMovable(a));
+        EXPECT_EQ(allocator->AllocateMovable(64, 0), allocator_bfc::kInvalidMovableHandle);
+    }
+
+    // One unpinned block in each of the first two regions and a pinned one in
+    // the third: a block moved out of one candidate can land in the other,
+    // and has to be followed when that one is evacuated in turn
+    {
+        auto allocator = make_allocator(std::chrono::milliseconds(0), std::chrono::milliseconds(0));
+
+        std::vector<allocator_bfc::movable_handle> handles;
+        std::vector<size_t>                        region_starts;
+        int64_t                                    region_bytes = 0;
+        while (region_starts.size() < 3)
+        {
+            handles.push_back(allocator->AllocateMovable(64, kBlock));
+            ASSERT_NE(handles.back(), allocator_bfc::kInvalidMovableHandle);
+            if (pool_bytes(*allocator) != region_bytes)
+            {
+                region_bytes = pool_bytes(*allocator);
+                region_starts.push_back(handles.size() - 1);
+            }
+        }
+        std::vector<allocator_bfc::movable_handle> kept;
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            if (std::find(region_starts.begin(), region_starts.end(), i) != region_starts.end())
+            {
+                kept.push_back(handles[i]);
+            }
+            else
+            {
+                allocator->DeallocateMovable(handles[i]);
+            }
+        }
+        fill(*allocator, kept[0], 0x11);
+        fill(*allocator, kept[1], 0x22);
+        fill(*allocator, kept[2], 0x33);
+        void* const pinned = allocator->PinMovable(kept[2]);
+
+        int64_t const pool_before = pool_bytes(*allocator);
+        size_t const  released    = allocator->Compact();
+        EXPECT_GT(released, 0u);
+        EXPECT_EQ(pool_bytes(*allocator), pool_before - static_cast<int64_t>(released));
+        EXPECT_EQ(allocator->PinMovable(kept[2]), pinned);
+        allocator->UnpinMovable(kept[2]);
+        allocator->UnpinMovable(kept[2]);
+
+        EXPECT_TRUE(holds(*allocator, kept[0], 0x11));
+        EXPECT_TRUE(holds(*allocator, kept[1], 0x22));
+        EXPECT_TRUE(holds(*allocator, kept[2], 0x33));
+        for (allocator_bfc::movable_handle const h : kept)
+        {
+            allocator->DeallocateMovable(h);
+        }
+    }
+
+    // The background thread releases the regions left free past the timeout
+    {
+        auto allocator =
+            make_allocator(std::chrono::milliseconds(10), std::chrono::milliseconds(20));
+
+        void* ptr = allocator->allocate_raw(64, kBlock);
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_GT(pool_bytes(*allocator), 0);
+        allocator->deallocate_raw(ptr);
+
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (pool_bytes(*allocator) > 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(pool_bytes(*allocator), 0);
+
+        // Regions are allocated again on demand
+        ptr = allocator->allocate_raw(64, kBlock);
+        EXPECT_NE(nullptr, ptr);
+        allocator->deallocate_raw(ptr);
+    }
+
+    END_TEST();
+}
+
+/**
+ * @brief Test that waiting allocations are woken by the frees they fit in
+ */
+QUARISMATEST(AllocatorBFC, retry_wakeups)
+{
+    auto sub_alloc = std::make_unique<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+
+    allocator_bfc::Options opts;
+    opts.allow_growth       = false;
+    opts.garbage_collection = false;
+
+    constexpr size_t kPool = 1 << 20;
+    auto             allocator =
+        std::make_unique<allocator_bfc>(std::move(sub_alloc), kPool, "test_bfc_retry", opts);
+
+    // The pool is used up by a small and a large block
+    void* small = allocator->allocate_raw(64, kPool / 4);
+    void* large = allocator->allocate_raw(64, kPool - kPool / 4);
+    ASSERT_NE(nullptr, small);
+    ASSERT_NE(nullptr, large);
+
+    std::atomic<void*> big_waiter{nullptr};
+    std::atomic<void*> small_waiter{nullptr};
+    std::thread        big([&]() { big_waiter = allocator->allocate_raw(64, kPool / 2); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::thread little([&]() { small_waiter = allocator->allocate_raw(64, kPool / 8); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Freeing the small block only serves the request that fits in it, even
+    // though it queued last
+    auto const start = std::chrono::steady_clock::now();
+    allocator->deallocate_raw(small);
+    little.join();
+    EXPECT_NE(nullptr, small_waiter.load());
+    EXPECT_EQ(nullptr, big_waiter.load());
+
+    allocator->deallocate_raw(large);
+    big.join();
+    EXPECT_NE(nullptr, big_waiter.load());
+    EXPECT_LT(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count(),
+        5000);
+
+    auto const stats = allocator->GetRetryWaitStats();
+    EXPECT_EQ(stats.waits, 2u);
+    EXPECT_EQ(stats.timeouts, 0u);
+    EXPECT_EQ(stats.wakeups, 2u);
+    uint64_t recorded = 0;
+    for (uint64_t count : stats.wait_micros)
+    {
+        recorded += count;
+    }
+    EXPECT_EQ(recorded, 2u);
+
+    allocator->deallocate_raw(small_waiter.load());
+    allocator->deallocate_raw(big_waiter.load());
+
+    END_TEST();
+}
+
+/**
+ * @brief Test that an incremental memory map matches a full one when chunks
+ * change between its batches
+ */
+QUARISMATEST(AllocatorBFC, incremental_memory_map)
+{
+    auto sub_alloc = std::make_unique<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+
+    allocator_bfc::Options opts;
+    opts.allow_growth       = false;
+    opts.garbage_collection = false;
+
+    constexpr size_t kPool  = 1 << 20;
+    constexpr size_t kBlock = 4096;
+    auto             allocator =
+        std::make_unique<allocator_bfc>(std::move(sub_alloc), kPool, "test_bfc_map", opts);
+
+    // Used blocks with a free one every third, so frees merge with a neighbour
+    std::vector<void*> blocks;
+    for (int i = 0; i < 96; ++i)
+    {
+        blocks.push_back(allocator->allocate_raw(64, kBlock));
+        ASSERT_NE(nullptr, blocks.back());
+    }
+    for (size_t i = 0; i < blocks.size(); i += 3)
+    {
+        allocator->deallocate_raw(blocks[i]);
+        blocks[i] = nullptr;
+    }
+
+    // Between batches, chunks on both sides of the cursor are freed and merged,
+    // or split by new allocations
+    std::vector<void*> extra;
+    int                batches = 0;
+    allocator->SetMapBatchHookForTesting(
+        [&]()
+        {
+            int const step = batches++;
+            if (step >= 30)
+            {
+                return;
+            }
+            void*& victim = blocks[(static_cast<size_t>(step) * 7 + 1) % blocks.size()];
+            switch (step % 3)
+            {
+            case 0:
+                allocator->deallocate_raw(victim);
+                victim = nullptr;
+                break;
+            case 1:
+                extra.push_back(allocator->allocate_raw(64, kBlock / 4));
+                break;
+            default:
+                extra.push_back(allocator->allocate_raw(64, 2 * kBlock));
+                allocator->deallocate_raw(victim);
+                victim = nullptr;
+                break;
+            }
+        });
+
+    memory_dump const incremental = allocator->RecordMemoryMapIncremental(2);
+    allocator->SetMapBatchHookForTesting(nullptr);
+    memory_dump const full = allocator->RecordMemoryMap();
+    EXPECT_GT(batches, 30);
+
+    ASSERT_EQ(incremental.chunk().size(), full.chunk().size());
+    for (size_t i = 0; i < full.chunk().size(); ++i)
+    {
+        const MemChunk& a = incremental.chunk()[i];
+        const MemChunk& b = full.chunk()[i];
+        EXPECT_EQ(a.address(), b.address());
+        EXPECT_EQ(a.size(), b.size());
+        EXPECT_EQ(a.requested_size(), b.requested_size());
+        EXPECT_EQ(a.in_use(), b.in_use());
+        EXPECT_EQ(a.bin(), b.bin());
+    }
+
+    ASSERT_EQ(incremental.bin_summary().size(), full.bin_summary().size());
+    for (size_t i = 0; i < full.bin_summary().size(); ++i)
+    {
+        const BinSummary& a = incremental.bin_summary()[i];
+        const BinSummary& b = full.bin_summary()[i];
+        EXPECT_EQ(a.bin(), b.bin());
+        EXPECT_EQ(a.total_bytes_in_use(), b.total_bytes_in_use());
+        EXPECT_EQ(a.total_bytes_in_bin(), b.total_bytes_in_bin());
+        EXPECT_EQ(a.total_chunks_in_use(), b.total_chunks_in_use());
+        EXPECT_EQ(a.total_chunks_in_bin(), b.total_chunks_in_bin());
+    }
+    EXPECT_EQ(incremental.stats().num_allocs(), full.stats().num_allocs());
+    EXPECT_EQ(incremental.stats().bytes_in_use(), full.stats().bytes_in_use());
+
+    for (void* ptr : blocks)
+    {
+        allocator->deallocate_raw(ptr);
+    }
+    for (void* ptr : extra)
+    {
+        allocator->deallocate_raw(ptr);
+    }
+
+    END_TEST();
+}
+
 /**
  * @brief Test BFC allocator performance characteristics
  */
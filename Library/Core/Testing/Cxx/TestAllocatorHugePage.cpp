@@ -0,0 +1,161 @@
+/**
+ * @file TestAllocatorHugePage.cpp
+ * @brief Test suite for the huge page sub_allocator
+ *
+ * Tests the huge_page_cpu_allocator class including:
+ * - Page size rounding and alignment of regions
+ * - Visitor notification with the rounded sizes
+ * - Explicit huge pages with fallback when the pool is empty
+ * - Use as the sub_allocator of allocator_bfc
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_huge_page.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+bool is_aligned(const void* ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+std::unique_ptr<huge_page_cpu_allocator> make_huge_page_allocator(
+    const huge_page_cpu_allocator::Options& opts)
+{
+    return std::make_unique<huge_page_cpu_allocator>(
+        -1, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{}, opts);
+}
+
+}  // namespace
+
+QUARISMATEST(AllocatorHugePage, regions_are_rounded_and_aligned)
+{
+    auto pages = make_huge_page_allocator(huge_page_cpu_allocator::Options{});
+
+    EXPECT_EQ(pages->page_size(), size_t{2} << 20);
+    EXPECT_FALSE(pages->SupportsCoalescing());
+    EXPECT_EQ(pages->GetMemoryType(), allocator_memory_enum::HOST_PAGEABLE);
+
+    size_t received = 0;
+    EXPECT_EQ(pages->Alloc(64, 0, &received), nullptr);
+
+    for (size_t bytes : {size_t{1}, size_t{4096}, size_t{2} << 20, (size_t{5} << 20) + 1})
+    {
+        void* ptr = pages->Alloc(64, bytes, &received);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_GE(received, bytes);
+        EXPECT_EQ(received % pages->page_size(), 0u);
+        EXPECT_TRUE(is_aligned(ptr, pages->page_size()));
+
+        // The whole rounded region is usable
+        std::memset(ptr, 0x3C, received);
+        EXPECT_EQ(static_cast<unsigned char*>(ptr)[received - 1], 0x3C);
+        pages->Free(ptr, received);
+    }
+
+    // Alignments above the page size are honoured
+    void* ptr = pages->Alloc(size_t{8} << 20, 4096, &received);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(is_aligned(ptr, size_t{8} << 20));
+    pages->Free(ptr, received);
+
+    EXPECT_EQ(pages->fallback_regions(), 5);
+    EXPECT_EQ(pages->explicit_regions(), 0);
+
+    huge_page_cpu_allocator::Options bad;
+    bad.page_size = 3 << 20;
+    ASSERT_ANY_THROW(make_huge_page_allocator(bad));
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorHugePage, visitors_see_rounded_sizes)
+{
+    size_t allocated = 0;
+    size_t freed     = 0;
+    auto   pages     = std::make_unique<huge_page_cpu_allocator>(
+        -1,
+        std::vector<sub_allocator::Visitor>{
+            [&](void*, int, size_t bytes) { allocated += bytes; }},
+        std::vector<sub_allocator::Visitor>{[&](void*, int, size_t bytes) { freed += bytes; }},
+        huge_page_cpu_allocator::Options{});
+
+    size_t received = 0;
+    void*  ptr      = pages->Alloc(64, 100, &received);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(allocated, received);
+    pages->Free(ptr, received);
+    EXPECT_EQ(freed, received);
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorHugePage, explicit_pages_fall_back)
+{
+    huge_page_cpu_allocator::Options opts;
+    opts.use_explicit_pages = true;
+    auto pages              = make_huge_page_allocator(opts);
+
+    // Whether the pool has pages depends on the machine: either way the region
+    // is usable and accounted to one of the two modes.
+    std::vector<std::pair<void*, size_t>> regions;
+    for (int i = 0; i < 4; ++i)
+    {
+        size_t received = 0;
+        void*  ptr      = pages->Alloc(64, size_t{3} << 20, &received);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_TRUE(is_aligned(ptr, pages->page_size()));
+        std::memset(ptr, i, received);
+        regions.emplace_back(ptr, received);
+    }
+    EXPECT_EQ(pages->explicit_regions() + pages->fallback_regions(), 4);
+
+    for (const auto& [ptr, bytes] : regions)
+    {
+        pages->Free(ptr, bytes);
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorHugePage, backs_allocator_bfc)
+{
+    auto  sub   = make_huge_page_allocator(huge_page_cpu_allocator::Options{});
+    auto* pages = sub.get();
+
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+    allocator_bfc bfc(std::move(sub), 1LL << 30, "test_bfc_huge_pages", opts);
+
+    std::vector<void*> arrays;
+    for (int i = 0; i < 8; ++i)
+    {
+        auto* values =
+            static_cast<double*>(bfc.allocate_raw(64, (size_t{1} << 20) * sizeof(double)));
+        ASSERT_NE(values, nullptr);
+        values[0]             = i;
+        values[(1 << 20) - 1] = i;
+        arrays.push_back(values);
+    }
+    EXPECT_GT(pages->fallback_regions(), 0);
+
+    auto stats = bfc.GetStats();
+    ASSERT_TRUE(stats.has_value());
+    EXPECT_EQ(stats->bytes_reserved % static_cast<int64_t>(pages->page_size()), 0);
+
+    for (void* ptr : arrays)
+    {
+        bfc.deallocate_raw(ptr);
+    }
+
+    END_TEST();
+}
@@ -0,0 +1,256 @@
+/**
+ * @file TestAllocatorMmap.cpp
+ * @brief Test suite for memory-mapped buffers and the mmap sub_allocator
+ *
+ * Tests mmap_buffer and mmap_cpu_allocator including:
+ * - Mapping a file read-only and writable, with read-ahead hints
+ * - Anonymous swap-backed buffers
+ * - Anonymous and file-backed regions, their rounding and alignment
+ * - Reuse of the file ranges of freed regions
+ * - Use as the sub_allocator of allocator_bfc
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_mmap.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+bool is_aligned(const void* ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+std::string temp_path(const char* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::unique_ptr<mmap_cpu_allocator> make_mmap_allocator(const mmap_cpu_allocator::Options& opts)
+{
+    return std::make_unique<mmap_cpu_allocator>(
+        std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{}, opts);
+}
+
+}  // namespace
+
+#if defined(__unix__) || defined(__APPLE__)
+QUARISMATEST(AllocatorMmap, maps_files)
+{
+    const std::string path = temp_path("quarisma_mmap_buffer.bin");
+    std::vector<double> values(100000);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = static_cast<double>(i);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    }
+
+    {
+        mmap_buffer::Options opts;
+        opts.access    = mmap_access::SEQUENTIAL;
+        opts.will_need = true;
+        auto buffer    = mmap_buffer::open(path, opts);
+        ASSERT_EQ(buffer.size(), values.size() * sizeof(double));
+        EXPECT_FALSE(buffer.writable());
+        EXPECT_EQ(std::memcmp(buffer.data(), values.data(), buffer.size()), 0);
+
+        // Hints on ranges, clamped to the mapping
+        buffer.advise(mmap_access::RANDOM, 4096, 8192);
+        buffer.will_need(buffer.size() - 10);
+        buffer.dont_need(0, 4096);
+        EXPECT_EQ(static_cast<const double*>(buffer.data())[99999], 99999.0);
+
+        // A mapping from an offset, moved to another buffer
+        opts.offset = mmap_buffer::page_size();
+        mmap_buffer tail;
+        tail = mmap_buffer::open(path, opts);
+        EXPECT_EQ(tail.size(), buffer.size() - opts.offset);
+        EXPECT_EQ(
+            static_cast<const double*>(tail.data())[0],
+            static_cast<double>(opts.offset / sizeof(double)));
+    }
+
+    {
+        // Writes through a writable mapping reach the file, which grows to the size mapped
+        mmap_buffer::Options opts;
+        opts.writable = true;
+        opts.size     = values.size() * sizeof(double) * 2;
+        auto buffer   = mmap_buffer::open(path, opts);
+        auto* data    = static_cast<double*>(buffer.data());
+        EXPECT_EQ(data[10], 10.0);
+        data[values.size() * 2 - 1] = -1.0;
+        buffer.sync();
+    }
+    EXPECT_EQ(std::filesystem::file_size(path), values.size() * sizeof(double) * 2);
+    {
+        auto buffer = mmap_buffer::open(path);
+        EXPECT_EQ(static_cast<const double*>(buffer.data())[values.size() * 2 - 1], -1.0);
+    }
+
+    // A read-only mapping cannot extend the file, nor map a missing one
+    mmap_buffer::Options too_long;
+    too_long.size = values.size() * sizeof(double) * 4;
+    ASSERT_ANY_THROW(mmap_buffer::open(path, too_long));
+    std::filesystem::remove(path);
+    ASSERT_ANY_THROW(mmap_buffer::open(path));
+
+    END_TEST();
+}
+#endif
+
+QUARISMATEST(AllocatorMmap, maps_anonymous_memory)
+{
+    mmap_buffer::Options opts;
+    opts.huge_pages = true;
+    auto buffer     = mmap_buffer::anonymous((size_t{4} << 20) + 1, opts);
+    ASSERT_NE(buffer.data(), nullptr);
+    EXPECT_TRUE(buffer.writable());
+    EXPECT_TRUE(is_aligned(buffer.data(), mmap_buffer::page_size()));
+
+    auto* bytes = static_cast<unsigned char*>(buffer.data());
+    EXPECT_EQ(bytes[buffer.size() - 1], 0);
+    std::memset(bytes, 0x5A, buffer.size());
+
+    // Dropped anonymous pages read back as zero
+    buffer.dont_need();
+    EXPECT_EQ(bytes[0], 0);
+
+    buffer.reset();
+    EXPECT_TRUE(buffer.empty());
+    ASSERT_ANY_THROW(mmap_buffer::anonymous(0));
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorMmap, anonymous_regions_are_rounded_and_aligned)
+{
+    auto mapped = make_mmap_allocator(mmap_cpu_allocator::Options{});
+    EXPECT_FALSE(mapped->file_backed());
+    EXPECT_FALSE(mapped->SupportsCoalescing());
+    EXPECT_EQ(mapped->GetMemoryType(), allocator_memory_enum::HOST_PAGEABLE);
+    EXPECT_EQ(mapped->file_bytes(), 0u);
+
+    size_t received = 0;
+    EXPECT_EQ(mapped->Alloc(64, 0, &received), nullptr);
+
+    for (size_t alignment : {size_t{64}, size_t{1} << 20})
+    {
+        void* ptr = mapped->Alloc(alignment, 100000, &received);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_EQ(received % mmap_buffer::page_size(), 0u);
+        EXPECT_GE(received, 100000u);
+        EXPECT_TRUE(is_aligned(ptr, alignment));
+        EXPECT_EQ(mapped->mapped_bytes(), received);
+
+        std::memset(ptr, 0x3C, received);
+        mapped->Free(ptr, received);
+        EXPECT_EQ(mapped->mapped_bytes(), 0u);
+    }
+
+    END_TEST();
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+QUARISMATEST(AllocatorMmap, file_regions_reuse_freed_ranges)
+{
+    const std::string path = temp_path("quarisma_mmap_regions.bin");
+
+    mmap_cpu_allocator::Options opts;
+    opts.path      = path;
+    opts.keep_file = true;
+    opts.access    = mmap_access::SEQUENTIAL;
+    auto mapped    = make_mmap_allocator(opts);
+    EXPECT_TRUE(mapped->file_backed());
+
+    size_t const region = size_t{1} << 20;
+    size_t       sizes[3];
+    void*        regions[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        regions[i] = mapped->Alloc(size_t{2} << 20, region, &sizes[i]);
+        ASSERT_NE(regions[i], nullptr);
+        EXPECT_TRUE(is_aligned(regions[i], size_t{2} << 20));
+        std::memset(regions[i], i + 1, sizes[i]);
+    }
+    EXPECT_EQ(mapped->file_bytes(), 3 * region);
+    EXPECT_EQ(std::filesystem::file_size(path), 3 * region);
+
+    // The range of a freed region in the middle goes to the next region
+    mapped->Free(regions[1], sizes[1]);
+    EXPECT_EQ(mapped->file_bytes(), 3 * region);
+    regions[1] = mapped->Alloc(64, region, &sizes[1]);
+    ASSERT_NE(regions[1], nullptr);
+    EXPECT_EQ(mapped->file_bytes(), 3 * region);
+    EXPECT_EQ(static_cast<unsigned char*>(regions[0])[region - 1], 1);
+
+    // Freeing the last regions truncates the file
+    mapped->Free(regions[2], sizes[2]);
+    mapped->Free(regions[1], sizes[1]);
+    EXPECT_EQ(mapped->file_bytes(), region);
+    mapped->Free(regions[0], sizes[0]);
+    EXPECT_EQ(mapped->file_bytes(), 0u);
+    EXPECT_EQ(mapped->mapped_bytes(), 0u);
+
+    mapped.reset();
+    EXPECT_TRUE(std::filesystem::exists(path));
+    std::filesystem::remove(path);
+
+    // Without keep_file the file is gone as soon as it is opened
+    opts.keep_file = false;
+    mapped         = make_mmap_allocator(opts);
+    EXPECT_FALSE(std::filesystem::exists(path));
+
+    END_TEST();
+}
+#endif
+
+QUARISMATEST(AllocatorMmap, backs_allocator_bfc)
+{
+    mmap_cpu_allocator::Options mmap_opts;
+#if defined(__unix__) || defined(__APPLE__)
+    mmap_opts.path = temp_path("quarisma_mmap_bfc.bin");
+#endif
+    auto  sub    = make_mmap_allocator(mmap_opts);
+    auto* mapped = sub.get();
+
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+    allocator_bfc bfc(std::move(sub), 1LL << 30, "test_bfc_mmap", opts);
+
+    std::vector<double*> arrays;
+    for (int i = 0; i < 4; ++i)
+    {
+        auto* values =
+            static_cast<double*>(bfc.allocate_raw(64, (size_t{1} << 20) * sizeof(double)));
+        ASSERT_NE(values, nullptr);
+        values[0]             = i;
+        values[(1 << 20) - 1] = i;
+        arrays.push_back(values);
+    }
+    EXPECT_GT(mapped->mapped_bytes(), 0u);
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(arrays[i][(1 << 20) - 1], i);
+    }
+
+    for (double* values : arrays)
+    {
+        bfc.deallocate_raw(values);
+    }
+
+    END_TEST();
+}
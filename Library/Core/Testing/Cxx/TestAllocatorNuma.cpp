@@ -0,0 +1,175 @@
+/**
+ * @file TestAllocatorNuma.cpp
+ * @brief Test suite for the per NUMA node allocator
+ *
+ * Tests the allocator_numa class including:
+ * - One allocator_bfc per node and routing of allocate_raw()
+ * - Ownership lookup when freeing memory of any node
+ * - Aggregated statistics
+ * - Concurrent allocation, region growth and cross node frees
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/backend/allocator_huge_page.h"
+#include "memory/backend/allocator_numa.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+/**
+ * @brief allocator_numa with `num_nodes` emulated nodes on base page regions
+ */
+std::unique_ptr<allocator_numa> make_numa_allocator(int num_nodes)
+{
+    allocator_numa::Options opts;
+    opts.memory_limit_per_node = size_t{256} << 20;
+    return std::make_unique<allocator_numa>(
+        "test_numa",
+        num_nodes,
+        [](int) -> std::unique_ptr<sub_allocator>
+        {
+            huge_page_cpu_allocator::Options pages;
+            pages.page_size = 4096;
+            return std::make_unique<huge_page_cpu_allocator>(
+                -1,
+                std::vector<sub_allocator::Visitor>{},
+                std::vector<sub_allocator::Visitor>{},
+                pages);
+        },
+        opts);
+}
+
+}  // namespace
+
+QUARISMATEST(AllocatorNuma, nodes_and_ownership)
+{
+    auto numa = make_numa_allocator(2);
+
+    EXPECT_EQ(numa->Name(), "test_numa");
+    EXPECT_EQ(numa->num_nodes(), 2);
+    EXPECT_EQ(numa->node_allocator(1)->Name(), "test_numa_node1");
+    EXPECT_TRUE(numa->tracks_allocation_sizes());
+    ASSERT_ANY_THROW(numa->node_allocator(2));
+
+    // This machine is emulated as node 0 when the CPU's node is unknown
+    const int home = numa->CurrentNode();
+    EXPECT_GE(home, 0);
+    EXPECT_LT(home, 2);
+
+    void* local = numa->allocate_raw(64, 1000);
+    ASSERT_NE(local, nullptr);
+    EXPECT_EQ(numa->NodeOf(local), home);
+    EXPECT_GE(numa->RequestedSize(local), 1000u);
+
+    void* remote = numa->node_allocator(1 - home)->allocate_raw(64, 5000);
+    ASSERT_NE(remote, nullptr);
+    EXPECT_EQ(numa->NodeOf(remote), 1 - home);
+    EXPECT_EQ(numa->AllocatedSize(remote), numa->node_allocator(1 - home)->AllocatedSize(remote));
+
+    int on_stack = 0;
+    EXPECT_EQ(numa->NodeOf(&on_stack), -1);
+    ASSERT_ANY_THROW(numa->deallocate_raw(&on_stack));
+
+    auto stats = numa->GetStats();
+    ASSERT_TRUE(stats.has_value());
+    EXPECT_EQ(stats->num_allocs, 2);
+    EXPECT_GE(stats->bytes_in_use, 6000);
+
+    // Memory of either node is freed through the allocator_numa
+    numa->deallocate_raw(local);
+    numa->deallocate_raw(remote);
+    numa->deallocate_raw(nullptr);
+    EXPECT_EQ(numa->GetStats()->bytes_in_use, 0);
+    EXPECT_EQ(numa->allocate_raw(64, 0), nullptr);
+
+    EXPECT_TRUE(numa->ClearStats());
+    EXPECT_EQ(numa->GetStats()->num_allocs, 0);
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorNuma, machine_nodes)
+{
+    allocator_numa numa("machine_numa", allocator_numa::Options{});
+    EXPECT_GE(numa.num_nodes(), 1);
+
+    std::vector<void*> arrays;
+    for (int i = 0; i < 4; ++i)
+    {
+        auto* values =
+            static_cast<double*>(numa.allocate_raw(64, (size_t{1} << 18) * sizeof(double)));
+        ASSERT_NE(values, nullptr);
+        values[0]             = i;
+        values[(1 << 18) - 1] = i;
+        EXPECT_EQ(numa.NodeOf(values), numa.CurrentNode());
+        arrays.push_back(values);
+    }
+    for (void* ptr : arrays)
+    {
+        numa.deallocate_raw(ptr);
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorNuma, concurrent_cross_node_frees)
+{
+    auto numa = make_numa_allocator(3);
+
+    constexpr int            kThreads    = 4;
+    constexpr int            kIterations = 2000;
+    std::atomic<int>         corrupted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                std::vector<unsigned char*> live;
+                for (int i = 0; i < kIterations; ++i)
+                {
+                    // Growing sizes keep the node allocators adding regions
+                    const size_t bytes = 64 + static_cast<size_t>(i) * 97 % 20000;
+                    auto*        ptr   = static_cast<unsigned char*>(
+                        numa->node_allocator((t + i) % 3)->allocate_raw(64, bytes));
+                    ASSERT_NE(ptr, nullptr);
+                    std::memset(ptr, t + 1, bytes);
+                    live.push_back(ptr);
+                    if (i % 2 == 1)
+                    {
+                        unsigned char* victim = live.front();
+                        if (victim[0] != t + 1)
+                        {
+                            ++corrupted;
+                        }
+                        numa->deallocate_raw(victim);
+                        live.erase(live.begin());
+                    }
+                }
+                for (unsigned char* ptr : live)
+                {
+                    numa->deallocate_raw(ptr);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(corrupted.load(), 0);
+    auto stats = numa->GetStats();
+    EXPECT_EQ(stats->bytes_in_use, 0);
+    EXPECT_EQ(stats->num_allocs, kThreads * kIterations);
+
+    END_TEST();
+}
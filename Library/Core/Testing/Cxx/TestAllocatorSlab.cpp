@@ -0,0 +1,298 @@
+/**
+ * @file TestAllocatorSlab.cpp
+ * @brief Test suite for the size-class slab allocator
+ *
+ * Tests the allocator_slab class including:
+ * - Size class selection and alignment
+ * - Object reuse within a slab and slab refill
+ * - Return of empty slabs to the sub_allocator
+ * - Forwarding of large or over-aligned requests
+ * - Statistics and concurrent access
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/backend/allocator_slab.h"
+#include "memory/cpu/allocator.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+/**
+ * @brief Counting wrapper around basic_cpu_allocator to observe slab traffic
+ */
+class counting_sub_allocator : public sub_allocator
+{
+public:
+    counting_sub_allocator()
+        : sub_allocator({}, {}),
+          underlying_(
+              0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{})
+    {
+    }
+
+    void* Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received) override
+    {
+        ++alloc_count_;
+        return underlying_.Alloc(alignment, num_bytes, bytes_received);
+    }
+
+    void Free(void* ptr, size_t num_bytes) override
+    {
+        ++free_count_;
+        underlying_.Free(ptr, num_bytes);
+    }
+
+    bool SupportsCoalescing() const override { return false; }
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return underlying_.GetMemoryType();
+    }
+
+    int alloc_count() const { return alloc_count_; }
+    int free_count() const { return free_count_; }
+
+private:
+    std::atomic<int>    alloc_count_{0};
+    std::atomic<int>    free_count_{0};
+    basic_cpu_allocator underlying_;
+};
+
+std::unique_ptr<allocator_slab> make_slab_allocator(
+    counting_sub_allocator** counter, const allocator_slab::Options& opts)
+{
+    auto sub = std::make_unique<counting_sub_allocator>();
+    *counter = sub.get();
+    return std::make_unique<allocator_slab>(std::move(sub), "test_slab", opts);
+}
+
+bool is_aligned(const void* ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+}  // namespace
+
+QUARISMATEST(AllocatorSlab, size_classes)
+{
+    EXPECT_EQ(allocator_slab::SizeClassBytes(allocator_slab::SizeClass(8, 1)), 16u);
+    EXPECT_EQ(allocator_slab::SizeClassBytes(allocator_slab::SizeClass(8, 16)), 16u);
+    EXPECT_EQ(allocator_slab::SizeClassBytes(allocator_slab::SizeClass(8, 17)), 32u);
+    EXPECT_EQ(allocator_slab::SizeClassBytes(allocator_slab::SizeClass(8, 129)), 160u);
+    EXPECT_EQ(allocator_slab::SizeClassBytes(allocator_slab::SizeClass(8, 256)), 256u);
+    EXPECT_EQ(allocator_slab::SizeClass(8, 257), -1);
+
+    // Alignment moves the request up to a class whose objects provide it
+    EXPECT_EQ(allocator_slab::SizeClassBytes(allocator_slab::SizeClass(32, 40)), 64u);
+    EXPECT_EQ(allocator_slab::SizeClassBytes(allocator_slab::SizeClass(64, 130)), 192u);
+    EXPECT_EQ(allocator_slab::SizeClass(128, 16), -1);
+
+    for (size_t bytes = 1; bytes <= allocator_slab::kMaxObjectSize; ++bytes)
+    {
+        for (size_t alignment = 1; alignment <= allocator_slab::kMaxObjectAlignment;
+             alignment *= 2)
+        {
+            const size_t object = allocator_slab::SizeClassBytes(
+                allocator_slab::SizeClass(alignment, bytes));
+            EXPECT_GE(object, bytes);
+            EXPECT_EQ(object % std::min<size_t>(alignment, 64), 0u);
+        }
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorSlab, allocation_and_alignment)
+{
+    counting_sub_allocator* counter = nullptr;
+    auto                    slab    = make_slab_allocator(&counter, allocator_slab::Options{});
+
+    EXPECT_EQ(slab->Name(), "test_slab");
+    EXPECT_EQ(slab->GetMemoryType(), allocator_memory_enum::HOST_PAGEABLE);
+    EXPECT_EQ(slab->allocate_raw(8, 0), nullptr);
+
+    std::vector<void*> ptrs;
+    for (size_t bytes = 1; bytes <= allocator_slab::kMaxObjectSize; bytes += 7)
+    {
+        for (size_t alignment : {8, 16, 32, 64})
+        {
+            void* ptr = slab->allocate_raw(alignment, bytes);
+            ASSERT_NE(ptr, nullptr);
+            EXPECT_TRUE(is_aligned(ptr, alignment));
+            EXPECT_GE(slab->AllocatedSizeSlow(ptr), bytes);
+            std::memset(ptr, 0x5A, bytes);
+            ptrs.push_back(ptr);
+        }
+    }
+
+    // All objects are distinct and do not overlap
+    std::set<void*> unique(ptrs.begin(), ptrs.end());
+    EXPECT_EQ(unique.size(), ptrs.size());
+
+    for (void* ptr : ptrs)
+    {
+        slab->deallocate_raw(ptr);
+    }
+    slab->deallocate_raw(nullptr);
+
+    auto stats = slab->GetStats();
+    ASSERT_TRUE(stats.has_value());
+    EXPECT_EQ(stats->bytes_in_use, 0);
+    EXPECT_EQ(stats->num_allocs, static_cast<int64_t>(ptrs.size()));
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorSlab, slab_reuse_and_release)
+{
+    allocator_slab::Options opts;
+    opts.slab_size           = 4 << 10;
+    opts.empty_slabs_to_keep = 1;
+
+    counting_sub_allocator* counter = nullptr;
+    auto                    slab    = make_slab_allocator(&counter, opts);
+
+    // A freed object is handed out again before the slab is extended
+    void* first = slab->allocate_raw(16, 64);
+    slab->deallocate_raw(first);
+    void* again = slab->allocate_raw(16, 64);
+    EXPECT_EQ(first, again);
+    EXPECT_EQ(counter->alloc_count(), 1);
+
+    // Fill several 4 KiB slabs of the 64-byte class
+    std::vector<void*> ptrs{again};
+    for (int i = 0; i < 255; ++i)
+    {
+        ptrs.push_back(slab->allocate_raw(16, 64));
+        ASSERT_NE(ptrs.back(), nullptr);
+    }
+    const int slabs = counter->alloc_count();
+    EXPECT_GE(slabs, 4);
+    EXPECT_EQ(counter->free_count(), 0);
+
+    // All but one emptied slab go back to the sub_allocator
+    for (void* ptr : ptrs)
+    {
+        slab->deallocate_raw(ptr);
+    }
+    EXPECT_EQ(counter->free_count(), slabs - 1);
+
+    auto stats = slab->GetStats();
+    EXPECT_EQ(stats->bytes_reserved, static_cast<int64_t>(opts.slab_size));
+    EXPECT_GE(stats->peak_bytes_reserved, static_cast<int64_t>(slabs * opts.slab_size));
+
+    EXPECT_EQ(slab->ReleaseEmptySlabs(), 1u);
+    EXPECT_EQ(counter->free_count(), slabs);
+    EXPECT_EQ(slab->GetStats()->bytes_reserved, 0);
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorSlab, large_requests)
+{
+    counting_sub_allocator* counter = nullptr;
+    auto                    slab    = make_slab_allocator(&counter, allocator_slab::Options{});
+
+    void* large = slab->allocate_raw(64, 100000);
+    ASSERT_NE(large, nullptr);
+    EXPECT_TRUE(is_aligned(large, 64));
+    EXPECT_GE(slab->AllocatedSizeSlow(large), 100000u);
+    std::memset(large, 0x11, 100000);
+
+    void* aligned = slab->allocate_raw(4096, 32);
+    ASSERT_NE(aligned, nullptr);
+    EXPECT_TRUE(is_aligned(aligned, 4096));
+    EXPECT_EQ(counter->alloc_count(), 2);
+
+    slab->deallocate_raw(large);
+    slab->deallocate_raw(aligned);
+    EXPECT_EQ(counter->free_count(), 2);
+    EXPECT_EQ(slab->GetStats()->bytes_in_use, 0);
+    EXPECT_EQ(slab->GetStats()->bytes_reserved, 0);
+
+    ASSERT_ANY_THROW(slab->allocate_raw(64 << 10, 16));
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorSlab, invalid_options_and_double_free)
+{
+    allocator_slab::Options opts;
+    opts.slab_size = 3000;
+    ASSERT_ANY_THROW(allocator_slab(
+        std::make_unique<counting_sub_allocator>(), "bad_slab", opts));
+
+    counting_sub_allocator* counter = nullptr;
+    auto                    slab    = make_slab_allocator(&counter, allocator_slab::Options{});
+    void*                   keep    = slab->allocate_raw(16, 32);
+    void*                   ptr     = slab->allocate_raw(16, 32);
+    slab->deallocate_raw(ptr);
+    ASSERT_ANY_THROW(slab->deallocate_raw(ptr));
+    slab->deallocate_raw(keep);
+
+    END_TEST();
+}
+
+QUARISMATEST(AllocatorSlab, thread_safety)
+{
+    counting_sub_allocator* counter = nullptr;
+    auto                    slab    = make_slab_allocator(&counter, allocator_slab::Options{});
+
+    constexpr int            kThreads    = 4;
+    constexpr int            kIterations = 2000;
+    std::atomic<int>         corrupted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                std::vector<void*> live;
+                for (int i = 0; i < kIterations; ++i)
+                {
+                    const size_t bytes = 8 + static_cast<size_t>((i * 37 + t) % 240);
+                    auto*        ptr   = static_cast<unsigned char*>(slab->allocate_raw(8, bytes));
+                    std::memset(ptr, t + 1, bytes);
+                    live.push_back(ptr);
+                    if (i % 3 == 2)
+                    {
+                        auto* victim = static_cast<unsigned char*>(live.front());
+                        if (victim[0] != t + 1)
+                        {
+                            ++corrupted;
+                        }
+                        slab->deallocate_raw(victim);
+                        live.erase(live.begin());
+                    }
+                }
+                for (void* ptr : live)
+                {
+                    slab->deallocate_raw(ptr);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(corrupted.load(), 0);
+    auto stats = slab->GetStats();
+    EXPECT_EQ(stats->bytes_in_use, 0);
+    EXPECT_EQ(stats->num_allocs, kThreads * kIterations);
+    EXPECT_EQ(stats->num_deallocs, kThreads * kIterations);
+
+    END_TEST();
+}
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include "common/pointer.h"
@@ -222,6 +223,53 @@ QUARISMATEST(AllocatorStatistics, CPUAllocatorBasicStats)
     QUARISMA_LOG_INFO("CPU allocator statistics test completed successfully");
 }
 
+QUARISMATEST(AllocatorStatistics, CPUAllocatorConcurrentStats)
+{
+    EnableCPUAllocatorStats();
+
+    // A private instance, so that other users of cpu_allocator() do not count
+    allocator_cpu cpu_alloc;
+
+    constexpr int            kThreads    = 8;
+    constexpr int            kIterations = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&cpu_alloc, t]()
+            {
+                for (int i = 0; i < kIterations; ++i)
+                {
+                    void* ptr = cpu_alloc.allocate_raw(64, 64 + static_cast<size_t>(t) * 64);
+                    EXPECT_NE(nullptr, ptr);
+                    cpu_alloc.deallocate_raw(ptr);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Shards of the exited threads are merged by GetStats()
+    auto stats_opt = cpu_alloc.GetStats();
+    ASSERT_TRUE(stats_opt.has_value());
+    EXPECT_EQ(stats_opt->num_allocs.load(), kThreads * kIterations);
+    EXPECT_EQ(stats_opt->num_deallocs.load(), kThreads * kIterations);
+    EXPECT_EQ(stats_opt->largest_alloc_size.load(), 64 * kThreads);
+    EXPECT_EQ(
+        stats_opt->total_bytes_allocated.load(),
+        int64_t{kIterations} * 64 * kThreads * (kThreads + 1) / 2);
+
+    // Counts restart from the clear; the largest allocation is the one since
+    EXPECT_TRUE(cpu_alloc.ClearStats());
+    void* ptr = cpu_alloc.allocate_raw(64, 128);
+    stats_opt = cpu_alloc.GetStats();
+    EXPECT_EQ(stats_opt->num_allocs.load(), 1);
+    EXPECT_EQ(stats_opt->largest_alloc_size.load(), 128);
+    cpu_alloc.deallocate_raw(ptr);
+}
+
 QUARISMATEST(AllocatorStatistics, BFCAllocatorStats)
 {
     QUARISMA_LOG_INFO("Testing BFC allocator statistics exposure...");
@@ -601,4 +601,177 @@ QUARISMATEST(AllocatorTracking, BasicTracking)
 
     // Properly cleanup tracking allocator by releasing reference
     tracker->GetRecordsAndUnRef();
-}
\ No newline at end of file
+}
+/**
+ * @brief Test estimates of the sampling mode against the exact allocation volume
+ */
+QUARISMATEST(AllocatorTracking, sampling_estimates_usage)
+{
+    static allocator_cpu underlying;
+
+    tracking_sampling_options options;
+    options.sample_interval_bytes = 16 << 10;
+    options.thread_buffer_records = 4096;
+    auto* tracker                 = new allocator_tracking(&underlying, options);
+    EXPECT_TRUE(tracker->sampling());
+    EXPECT_EQ(tracker->Name(), underlying.Name());
+
+    // 20 MB in 1 KiB allocations: about 1250 samples, each standing for ~16 allocations
+    constexpr size_t   kCount = 20000;
+    constexpr size_t   kBytes = 1024;
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        void* ptr = tracker->allocate_raw(64, kBytes);
+        ASSERT_NE(ptr, nullptr);
+        ptrs.push_back(ptr);
+    }
+    EXPECT_EQ(tracker->GetDroppedSamples(), 0);
+
+    auto [total_bytes, high_watermark, live_bytes] = tracker->GetSizes();
+    EXPECT_EQ(total_bytes, kCount * kBytes);
+    EXPECT_NEAR(static_cast<double>(live_bytes), kCount * kBytes, 0.15 * kCount * kBytes);
+    EXPECT_GE(high_watermark, live_bytes);
+
+    auto samples = tracker->GetSampledRecords();
+    ASSERT_FALSE(samples.empty());
+    EXPECT_LT(samples.size(), kCount / 4);
+    for (const auto& sample : samples)
+    {
+        EXPECT_EQ(sample.requested_bytes, kBytes);
+        EXPECT_GE(sample.allocated_bytes, kBytes);
+        EXPECT_GT(sample.weight, 1.0);
+        EXPECT_TRUE(sample.live);
+    }
+
+    auto [utilization, overhead, efficiency] = tracker->GetEfficiencyMetrics();
+    EXPECT_GT(utilization, 0.0);
+    EXPECT_LE(utilization, 1.0);
+    EXPECT_NEAR(overhead, 1.0 - utilization, 1e-9);
+    EXPECT_GT(efficiency, 0.0);
+
+    std::string const report = tracker->GenerateReport(true);
+    EXPECT_NE(report.find("Sampling: every ~16384 bytes"), std::string::npos);
+    EXPECT_NE(report.find("Current Allocated (estimated)"), std::string::npos);
+    EXPECT_NE(report.find("Sampled Allocation Details"), std::string::npos);
+
+    // Freeing every other allocation halves the estimate
+    for (size_t i = 0; i < kCount; i += 2)
+    {
+        tracker->deallocate_raw(ptrs[i]);
+    }
+    EXPECT_NEAR(
+        static_cast<double>(std::get<2>(tracker->GetSizes())),
+        kCount * kBytes / 2,
+        0.2 * kCount * kBytes / 2);
+
+    for (size_t i = 1; i < kCount; i += 2)
+    {
+        tracker->deallocate_raw(ptrs[i]);
+    }
+    EXPECT_EQ(std::get<2>(tracker->GetSizes()), 0u);
+    for (const auto& sample : tracker->GetSampledRecords())
+    {
+        EXPECT_FALSE(sample.live);
+    }
+
+    auto records = tracker->GetRecordsAndUnRef();
+    EXPECT_EQ(records.size(), samples.size());
+    END_TEST();
+}
+
+/**
+ * @brief Test that allocations larger than the interval are sampled with a weight near 1
+ */
+QUARISMATEST(AllocatorTracking, sampling_large_allocations)
+{
+    static allocator_cpu underlying;
+
+    tracking_sampling_options options;
+    options.sample_interval_bytes = 4096;
+    auto* tracker                 = new allocator_tracking(&underlying, options);
+
+    void* ptr = tracker->allocate_raw(64, 1 << 20);
+    ASSERT_NE(ptr, nullptr);
+    auto samples = tracker->GetSampledRecords();
+    ASSERT_EQ(samples.size(), 1u);
+    EXPECT_NEAR(samples[0].weight, 1.0, 1e-9);
+    EXPECT_GE(std::get<2>(tracker->GetSizes()), size_t{1} << 20);
+    EXPECT_EQ(tracker->GetTimingStats().total_allocations, 1u);
+
+    tracker->deallocate_raw(ptr);
+    tracker->deallocate_raw(nullptr);
+    EXPECT_EQ(std::get<2>(tracker->GetSizes()), 0u);
+    EXPECT_EQ(tracker->GetTimingStats().total_deallocations, 1u);
+
+    tracking_sampling_options invalid;
+    invalid.sample_interval_bytes = 0;
+    ASSERT_ANY_THROW(new allocator_tracking(&underlying, invalid));
+
+    tracker->GetRecordsAndUnRef();
+    END_TEST();
+}
+
+/**
+ * @brief Test sampling with allocations freed by other threads
+ */
+QUARISMATEST(AllocatorTracking, sampling_concurrent_cross_thread_frees)
+{
+    static allocator_cpu underlying;
+
+    tracking_sampling_options options;
+    options.sample_interval_bytes = 8 << 10;
+    auto* tracker                 = new allocator_tracking(&underlying, options);
+
+    constexpr int            kThreads    = 4;
+    constexpr int            kIterations = 5000;
+    std::vector<void*>       handoff[kThreads];
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                for (int i = 0; i < kIterations; ++i)
+                {
+                    void* ptr = tracker->allocate_raw(16, 64 + (i % 64) * 32);
+                    ASSERT_NE(ptr, nullptr);
+                    handoff[t].push_back(ptr);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+    for (int t = 0; t < kThreads; ++t)
+    {
+        // Each thread frees the allocations of another one
+        threads.emplace_back(
+            [&, t]()
+            {
+                for (void* ptr : handoff[(t + 1) % kThreads])
+                {
+                    tracker->deallocate_raw(ptr);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(std::get<2>(tracker->GetSizes()), 0u);
+    EXPECT_GT(std::get<1>(tracker->GetSizes()), 0u);
+    std::string const report = tracker->GenerateReport();
+    EXPECT_NE(
+        report.find("Total Allocations: " + std::to_string(kThreads * kIterations)),
+        std::string::npos);
+    EXPECT_NE(
+        report.find("Total Deallocations: " + std::to_string(kThreads * kIterations)),
+        std::string::npos);
+
+    tracker->GetRecordsAndUnRef();
+    END_TEST();
+}
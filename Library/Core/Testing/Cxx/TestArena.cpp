@@ -0,0 +1,373 @@
+/**
+ * @file TestArena.cpp
+ * @brief Test suite for the monotonic arena allocator
+ *
+ * Tests the arena class including:
+ * - Bump allocation, alignment and chunk growth
+ * - O(1) reset with chunk reuse, release, mark/rewind and scopes
+ * - Use through quarisma::allocator<T>, arena_allocator<T> with flat_hash_map,
+ *   and std::pmr containers
+ * - small_vector_resource_scope and the pmr:: hash containers, over an arena
+ *   and over allocator_pool through allocator_resource
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "common/pointer.h"
+#include "memory/allocator.h"
+#include "memory/arena/arena.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/cpu/allocator_resource.h"
+#include "util/flat_hash.h"
+#include "util/small_vector.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+/**
+ * @brief basic_cpu_allocator counting the chunks an arena asks for
+ */
+class counting_sub_allocator : public sub_allocator
+{
+public:
+    counting_sub_allocator()
+        : sub_allocator({}, {}),
+          underlying_(
+              0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{})
+    {
+    }
+
+    void* Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received) override
+    {
+        ++alloc_count_;
+        return underlying_.Alloc(alignment, num_bytes, bytes_received);
+    }
+
+    void Free(void* ptr, size_t num_bytes) override
+    {
+        ++free_count_;
+        underlying_.Free(ptr, num_bytes);
+    }
+
+    bool SupportsCoalescing() const override { return false; }
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return underlying_.GetMemoryType();
+    }
+
+    int alloc_count() const { return alloc_count_; }
+    int free_count() const { return free_count_; }
+
+private:
+    std::atomic<int>    alloc_count_{0};
+    std::atomic<int>    free_count_{0};
+    basic_cpu_allocator underlying_;
+};
+
+std::unique_ptr<arena> make_arena(counting_sub_allocator** counter, size_t initial_chunk_size)
+{
+    auto sub = std::make_unique<counting_sub_allocator>();
+    *counter = sub.get();
+    arena::Options opts;
+    opts.initial_chunk_size = initial_chunk_size;
+    opts.max_chunk_size     = 16 * initial_chunk_size;
+    return std::make_unique<arena>(std::move(sub), "test_arena", opts);
+}
+
+bool is_aligned(const void* ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+}  // namespace
+
+QUARISMATEST(Arena, bump_allocation_and_growth)
+{
+    counting_sub_allocator* counter = nullptr;
+    auto                    scratch = make_arena(&counter, 4096);
+
+    EXPECT_EQ(scratch->Name(), "test_arena");
+    EXPECT_EQ(scratch->GetMemoryType(), allocator_memory_enum::HOST_PAGEABLE);
+    EXPECT_EQ(counter->alloc_count(), 0);  // The first chunk is obtained lazily
+
+    // Consecutive blocks are packed in the same chunk
+    auto* a = static_cast<char*>(scratch->allocate_raw(8, 24));
+    auto* b = static_cast<char*>(scratch->allocate_raw(8, 8));
+    EXPECT_EQ(b, a + 24);
+    EXPECT_EQ(counter->alloc_count(), 1);
+
+    for (size_t alignment = 1; alignment <= 4096; alignment *= 2)
+    {
+        void* ptr = scratch->allocate_raw(alignment, 3);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_TRUE(is_aligned(ptr, alignment));
+    }
+    EXPECT_NE(scratch->allocate_raw(8, 0), nullptr);
+
+    // Filling several chunks; every block stays valid
+    std::vector<std::pair<unsigned char*, size_t>> blocks;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        const size_t bytes = 1 + (i * 37) % 300;
+        auto*        ptr   = static_cast<unsigned char*>(scratch->allocate_raw(16, bytes));
+        ASSERT_NE(ptr, nullptr);
+        std::memset(ptr, static_cast<int>(i & 0xFF), bytes);
+        blocks.emplace_back(ptr, bytes);
+    }
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        EXPECT_EQ(blocks[i].first[blocks[i].second - 1], static_cast<unsigned char>(i & 0xFF));
+    }
+    EXPECT_GT(counter->alloc_count(), 1);
+
+    // A request larger than the next chunk gets a chunk of its own
+    const int chunks = counter->alloc_count();
+    void*     large  = scratch->allocate_raw(64, 1 << 20);
+    ASSERT_NE(large, nullptr);
+    std::memset(large, 0, 1 << 20);
+    EXPECT_EQ(counter->alloc_count(), chunks + 1);
+
+    scratch->deallocate_raw(large);  // No-op
+    auto stats = scratch->GetStats();
+    ASSERT_TRUE(stats.has_value());
+    EXPECT_GE(stats->bytes_in_use, (1 << 20));
+    EXPECT_EQ(stats->largest_alloc_size, (1 << 20));
+    EXPECT_EQ(stats->bytes_reserved, static_cast<int64_t>(scratch->bytes_reserved()));
+
+    ASSERT_ANY_THROW(scratch->allocate_raw(3, 1 << 20));
+
+    END_TEST();
+}
+
+QUARISMATEST(Arena, reset_rewind_and_release)
+{
+    counting_sub_allocator* counter = nullptr;
+    auto                    scratch = make_arena(&counter, 4096);
+
+    void* first = scratch->allocate_raw(16, 100);
+    for (int i = 0; i < 200; ++i)
+    {
+        scratch->allocate_raw(16, 100);
+    }
+    const int    chunks   = counter->alloc_count();
+    const size_t reserved = scratch->bytes_reserved();
+
+    // reset() frees everything and reuses the same chunks in the same order
+    scratch->reset();
+    EXPECT_EQ(scratch->bytes_in_use(), 0u);
+    EXPECT_EQ(scratch->allocate_raw(16, 100), first);
+    for (int i = 0; i < 200; ++i)
+    {
+        scratch->allocate_raw(16, 100);
+    }
+    EXPECT_EQ(counter->alloc_count(), chunks);
+    EXPECT_EQ(scratch->bytes_reserved(), reserved);
+    EXPECT_EQ(scratch->GetStats()->peak_bytes_in_use, 201 * 100);
+
+    // Nested scopes rewind to where they started
+    const size_t in_use = scratch->bytes_in_use();
+    void*        next   = nullptr;
+    {
+        arena::scope outer(*scratch);
+        next = scratch->allocate_raw(16, 64);
+        {
+            arena::scope inner(*scratch);
+            for (int i = 0; i < 500; ++i)
+            {
+                scratch->allocate_raw(16, 64);
+            }
+        }
+        EXPECT_EQ(scratch->bytes_in_use(), in_use + 64);
+    }
+    EXPECT_EQ(scratch->bytes_in_use(), in_use);
+    EXPECT_EQ(scratch->allocate_raw(16, 64), next);
+
+    // A marker taken before the first chunk rewinds to the start
+    counting_sub_allocator* fresh_counter = nullptr;
+    auto                    fresh         = make_arena(&fresh_counter, 4096);
+    const arena::marker     start         = fresh->mark();
+    void*                   block         = fresh->allocate_raw(8, 8);
+    fresh->rewind(start);
+    EXPECT_EQ(fresh->allocate_raw(8, 8), block);
+
+    // release() hands every chunk back
+    const int total = counter->alloc_count();
+    scratch->release();
+    EXPECT_EQ(counter->free_count(), total);
+    EXPECT_EQ(scratch->bytes_reserved(), 0u);
+    EXPECT_NE(scratch->allocate_raw(8, 8), nullptr);
+
+    END_TEST();
+}
+
+QUARISMATEST(Arena, container_integration)
+{
+    counting_sub_allocator* counter = nullptr;
+    auto                    scratch = make_arena(&counter, 64 << 10);
+
+    // quarisma::allocator<T> drawing from the arena
+    auto* values = allocator<double>::allocate(1000, *scratch);
+    ASSERT_NE(values, nullptr);
+    EXPECT_TRUE(is_aligned(values, QUARISMA_ALIGNMENT));
+    for (int i = 0; i < 1000; ++i)
+    {
+        values[i] = i * 0.5;
+    }
+    EXPECT_DOUBLE_EQ(values[999], 499.5);
+    allocator<double>::free(values, *scratch);
+    EXPECT_EQ(values, nullptr);
+
+    // flat_hash_map with arena_allocator
+    {
+        using map_type = flat_hash_map<
+            int,
+            std::string,
+            std::hash<int>,
+            std::equal_to<int>,
+            arena_allocator<std::pair<int, std::string>>>;
+        map_type map{arena_allocator<std::pair<int, std::string>>(*scratch)};
+        for (int i = 0; i < 1000; ++i)
+        {
+            map[i] = std::to_string(i);
+        }
+        EXPECT_EQ(map.size(), 1000u);
+        EXPECT_EQ(map[123], "123");
+        EXPECT_TRUE(map.get_allocator().owner() == scratch.get());
+    }
+
+    // std containers with arena_allocator
+    {
+        std::vector<int, arena_allocator<int>> vec{arena_allocator<int>(*scratch)};
+        for (int i = 0; i < 10000; ++i)
+        {
+            vec.push_back(i);
+        }
+        EXPECT_EQ(vec[9999], 9999);
+    }
+
+#if QUARISMA_HAS_MEMORY_RESOURCE
+    // std::pmr containers
+    {
+        std::pmr::vector<std::pmr::string> strings(scratch.get());
+        for (int i = 0; i < 100; ++i)
+        {
+            strings.emplace_back("a string long enough to skip the small string buffer");
+        }
+        EXPECT_EQ(strings.size(), 100u);
+        EXPECT_TRUE(scratch->is_equal(*scratch));
+    }
+#endif
+
+    const size_t reserved = scratch->bytes_reserved();
+    scratch->reset();
+    EXPECT_EQ(scratch->bytes_in_use(), 0u);
+    EXPECT_EQ(scratch->bytes_reserved(), reserved);
+
+    END_TEST();
+}
+
+#if QUARISMA_HAS_MEMORY_RESOURCE
+QUARISMATEST(Arena, pmr_small_vector_and_hash_containers)
+{
+    counting_sub_allocator* counter = nullptr;
+    auto                    scratch = make_arena(&counter, 64 << 10);
+
+    // small_vector spills into the scoped resource, trivially copyable or not
+    small_vector<int, 4> kept;
+    {
+        small_vector_resource_scope const scope(scratch.get());
+        EXPECT_EQ(small_vector_resource_scope::current(), scratch.get());
+
+        small_vector<int, 4>         ids;
+        small_vector<std::string, 2> names;
+        for (int i = 0; i < 1000; ++i)
+        {
+            ids.push_back(i);
+            names.push_back(std::to_string(i));
+        }
+        EXPECT_EQ(ids[999], 999);
+        EXPECT_EQ(names[999], "999");
+        EXPECT_GE(scratch->bytes_in_use(), 1000 * (sizeof(int) + sizeof(std::string)));
+
+        kept = std::move(ids);
+        {
+            small_vector_resource_scope const inner(nullptr);
+            EXPECT_EQ(small_vector_resource_scope::current(), nullptr);
+        }
+        EXPECT_EQ(small_vector_resource_scope::current(), scratch.get());
+    }
+    EXPECT_EQ(small_vector_resource_scope::current(), nullptr);
+
+    // Outside the scope a spilled vector keeps growing in its own resource
+    const size_t in_use = scratch->bytes_in_use();
+    kept.reserve(4 * kept.capacity());
+    EXPECT_GT(scratch->bytes_in_use(), in_use);
+    EXPECT_EQ(kept.size(), 1000u);
+    EXPECT_EQ(kept[999], 999);
+
+    // Vectors that stay small never touch the resource
+    {
+        small_vector_resource_scope const scope(scratch.get());
+        const size_t                      before = scratch->bytes_in_use();
+        small_vector<int, 8>              small(8, 1);
+        EXPECT_EQ(scratch->bytes_in_use(), before);
+    }
+
+    // allocator_pool through allocator_resource
+    auto sub_allocator = util::make_ptr_unique_mutable<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+    auto           size_rounder = util::make_ptr_unique_mutable<NoopRounder>();
+    allocator_pool pool(8, false, std::move(sub_allocator), std::move(size_rounder), "test_pool");
+    allocator_resource pooled(pool);
+    EXPECT_EQ(&pooled.allocator(), &pool);
+    EXPECT_TRUE(pooled.is_equal(allocator_resource(pool)));
+    EXPECT_FALSE(pooled.is_equal(*scratch));
+
+    {
+        small_vector_resource_scope const scope(&pooled);
+        small_vector<double, 4>           values(100, 0.5);
+        EXPECT_DOUBLE_EQ(values[99], 0.5);
+    }
+    EXPECT_GT(pool.put_count(), 0);
+
+    // pmr:: hash containers, moved and copied across resources
+    {
+        pmr::flat_hash_map<int, std::string> map(&pooled);
+        pmr::flat_hash_set<int>              set(scratch.get());
+        for (int i = 0; i < 100; ++i)
+        {
+            map[i] = std::to_string(i);
+            set.insert(i);
+        }
+        EXPECT_EQ(map.get_allocator().resource(), &pooled);
+        EXPECT_EQ(set.size(), 100u);
+
+        pmr::flat_hash_map<int, std::string> moved(scratch.get());
+        moved = std::move(map);
+        EXPECT_EQ(moved.get_allocator().resource(), scratch.get());
+        EXPECT_EQ(moved.size(), 100u);
+        EXPECT_EQ(moved[42], "42");
+
+        pmr::flat_hash_map<int, std::string> copied(&pooled);
+        copied = moved;
+        EXPECT_EQ(copied.get_allocator().resource(), &pooled);
+        EXPECT_EQ(copied[7], "7");
+
+        pmr::flat_hash_map<int, std::string> swapped(&pooled);
+        swapped.swap(copied);
+        EXPECT_EQ(swapped.size(), 100u);
+        EXPECT_TRUE(copied.empty());
+    }
+
+    END_TEST();
+}
+#endif
@@ -0,0 +1,352 @@
+/**
+ * @file TestAsyncIo.cpp
+ * @brief Test suite for the asynchronous file I/O engine
+ *
+ * Tests async_io and io_scheduler including:
+ * - Reads and writes through every backend available here
+ * - Fixed buffers and waiting for a minimum number of completions
+ * - Error completions and the queue depth limit
+ * - Futures of io_scheduler with tasks depending on them
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "io/async_io.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+std::string temp_path(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::vector<char> make_bytes(size_t size, unsigned seed)
+{
+    std::vector<char> bytes(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        bytes[i] = static_cast<char>((i * 31 + seed) & 0xff);
+    }
+    return bytes;
+}
+
+void write_file(const std::string& path, const std::vector<char>& bytes)
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::vector<io::io_backend_enum> available_backends()
+{
+    std::vector<io::io_backend_enum> backends{io::io_backend_enum::THREADS};
+    for (auto backend : {io::io_backend_enum::IO_URING, io::io_backend_enum::IOCP})
+    {
+        if (io::async_io::is_supported(backend))
+        {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+// Reaps until `count` completions are in, indexed by user_data
+std::vector<io::io_completion> reap_all(io::async_io& ring, size_t count)
+{
+    std::vector<io::io_completion> completions(count);
+    io::io_completion              batch[16];
+    for (size_t left = count; left > 0;)
+    {
+        size_t const reaped = ring.wait(batch, std::size(batch));
+        for (size_t i = 0; i < reaped; ++i)
+        {
+            completions[batch[i].user_data] = batch[i];
+        }
+        left -= reaped;
+    }
+    return completions;
+}
+
+}  // namespace
+
+QUARISMATEST(AsyncIo, reads_many_files)
+{
+    constexpr size_t file_count = 40;
+    std::vector<std::string>       paths;
+    std::vector<std::vector<char>> contents;
+    for (size_t i = 0; i < file_count; ++i)
+    {
+        paths.push_back(temp_path("quarisma_async_io_" + std::to_string(i) + ".bin"));
+        contents.push_back(make_bytes(1000 + i * 517, static_cast<unsigned>(i)));
+        write_file(paths.back(), contents.back());
+    }
+
+    for (auto backend : available_backends())
+    {
+        io::async_io::Options opts;
+        opts.backend     = backend;
+        opts.queue_depth = 16;
+        io::async_io ring(opts);
+        EXPECT_EQ(ring.backend(), backend);
+
+        std::vector<io::io_file>       files;
+        std::vector<std::vector<char>> buffers(file_count);
+        for (size_t i = 0; i < file_count; ++i)
+        {
+            files.push_back(io::io_file::open(paths[i]));
+            buffers[i].resize(contents[i].size());
+        }
+
+        // More files than the queue is deep: submit as the completions come in
+        std::vector<io::io_completion> completions(file_count);
+        io::io_completion              batch[8];
+        size_t                         next = 0;
+        for (size_t done = 0; done < file_count;)
+        {
+            for (; next < file_count; ++next)
+            {
+                auto&          buffer = buffers[next];
+                io::io_request request{
+                    io::io_op::READ, &files[next], 0, buffer.data(), buffer.size(), next};
+                if (!ring.submit(request))
+                {
+                    break;
+                }
+            }
+            EXPECT_LE(ring.in_flight(), opts.queue_depth);
+            size_t const reaped = ring.wait(batch, std::size(batch));
+            for (size_t i = 0; i < reaped; ++i)
+            {
+                completions[batch[i].user_data] = batch[i];
+            }
+            done += reaped;
+        }
+        EXPECT_EQ(ring.in_flight(), 0u);
+
+        for (size_t i = 0; i < file_count; ++i)
+        {
+            EXPECT_EQ(completions[i].result, static_cast<int64_t>(contents[i].size()));
+            EXPECT_TRUE(buffers[i] == contents[i]);
+        }
+    }
+
+    for (auto const& path : paths)
+    {
+        std::filesystem::remove(path);
+    }
+}
+
+QUARISMATEST(AsyncIo, writes_and_reads_back)
+{
+    const std::string path = temp_path("quarisma_async_io_write.bin");
+    constexpr size_t  block = 4096;
+    constexpr size_t  count = 32;
+
+    for (auto backend : available_backends())
+    {
+        io::async_io::Options opts;
+        opts.backend = backend;
+        io::async_io ring(opts);
+
+        std::vector<std::vector<char>> blocks;
+        {
+            auto file = io::io_file::open(path, io::io_file::mode::WRITE);
+            for (size_t i = 0; i < count; ++i)
+            {
+                blocks.push_back(make_bytes(block, static_cast<unsigned>(i * 7)));
+                ASSERT_TRUE(ring.submit(
+                    {io::io_op::WRITE, &file, i * block, blocks[i].data(), block, i}));
+            }
+            EXPECT_EQ(ring.flush(), count);
+            for (auto const& completion : reap_all(ring, count))
+            {
+                EXPECT_EQ(completion.result, static_cast<int64_t>(block));
+            }
+            EXPECT_EQ(file.size(), block * count);
+        }
+
+        // The last read runs past the end of the file and comes back short
+        auto              file = io::io_file::open(path);
+        std::vector<char> data(block * count + block);
+        for (size_t i = 0; i <= count; ++i)
+        {
+            ASSERT_TRUE(
+                ring.submit({io::io_op::READ, &file, i * block, &data[i * block], block, i}));
+        }
+        auto const completions = reap_all(ring, count + 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            EXPECT_EQ(completions[i].result, static_cast<int64_t>(block));
+            EXPECT_EQ(std::memcmp(&data[i * block], blocks[i].data(), block), 0);
+        }
+        EXPECT_EQ(completions[count].result, 0);
+    }
+    std::filesystem::remove(path);
+}
+
+QUARISMATEST(AsyncIo, uses_fixed_buffers)
+{
+    const std::string path     = temp_path("quarisma_async_io_fixed.bin");
+    auto const        contents = make_bytes(64 * 1024, 3);
+    write_file(path, contents);
+
+    for (auto backend : available_backends())
+    {
+        io::async_io::Options opts;
+        opts.backend            = backend;
+        opts.fixed_buffer_count = 4;
+        opts.fixed_buffer_size  = 16 * 1024;
+        io::async_io ring(opts);
+        EXPECT_EQ(ring.fixed_buffer_count(), 4u);
+
+        std::vector<io::io_buffer> buffers;
+        for (io::io_buffer buffer = ring.acquire_buffer(); buffer; buffer = ring.acquire_buffer())
+        {
+            EXPECT_EQ(buffer.size, opts.fixed_buffer_size);
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data) % 4096, 0u);
+            buffers.push_back(buffer);
+        }
+        ASSERT_EQ(buffers.size(), 4u);
+
+        auto file = io::io_file::open(path);
+        for (size_t i = 0; i < buffers.size(); ++i)
+        {
+            io::io_request request{
+                io::io_op::READ, &file, i * buffers[i].size, buffers[i].data, buffers[i].size, i};
+            request.fixed_buffer = buffers[i].index;
+            ASSERT_TRUE(ring.submit(request));
+        }
+
+        // wait() blocks until all four are in
+        io::io_completion completions[4];
+        ASSERT_EQ(ring.wait(completions, 4, 4), 4u);
+        for (auto const& completion : completions)
+        {
+            size_t const i = completion.user_data;
+            EXPECT_EQ(completion.result, static_cast<int64_t>(buffers[i].size));
+            EXPECT_EQ(
+                std::memcmp(buffers[i].data, &contents[i * buffers[i].size], buffers[i].size), 0);
+        }
+
+        for (auto const& buffer : buffers)
+        {
+            ring.release_buffer(buffer);
+        }
+        EXPECT_TRUE(ring.acquire_buffer());
+    }
+    std::filesystem::remove(path);
+}
+
+QUARISMATEST(AsyncIo, reports_errors)
+{
+    const std::string path = temp_path("quarisma_async_io_errors.bin");
+    write_file(path, make_bytes(100, 1));
+
+    for (auto backend : available_backends())
+    {
+        io::async_io::Options opts;
+        opts.backend     = backend;
+        opts.queue_depth = 2;
+        io::async_io ring(opts);
+
+        // Writing to a file opened for reading fails in the completion, not in submit()
+        auto file  = io::io_file::open(path);
+        char buffer[100];
+        ASSERT_TRUE(ring.submit({io::io_op::WRITE, &file, 0, buffer, sizeof(buffer), 0}));
+        ASSERT_TRUE(ring.submit({io::io_op::NOP, nullptr, 0, nullptr, 0, 1}));
+        EXPECT_FALSE(ring.submit({io::io_op::NOP, nullptr, 0, nullptr, 0, 2}));
+
+        auto const completions = reap_all(ring, 2);
+        EXPECT_FALSE(completions[0].ok());
+        EXPECT_TRUE(completions[1].ok());
+
+        // Nothing in flight: wait() returns at once
+        io::io_completion none[1];
+        EXPECT_EQ(ring.wait(none, 1), 0u);
+        EXPECT_EQ(ring.poll(none, 1), 0u);
+    }
+
+    ASSERT_ANY_THROW(io::io_file::open(temp_path("quarisma_async_io_missing/file.bin")));
+    std::filesystem::remove(path);
+}
+
+QUARISMATEST(AsyncIo, completes_scheduler_futures)
+{
+    constexpr size_t file_count = 24;
+    std::vector<std::string>       paths;
+    std::vector<std::vector<char>> contents;
+    for (size_t i = 0; i < file_count; ++i)
+    {
+        paths.push_back(temp_path("quarisma_io_scheduler_" + std::to_string(i) + ".bin"));
+        contents.push_back(make_bytes(2000 + i * 97, static_cast<unsigned>(i + 5)));
+        write_file(paths.back(), contents.back());
+    }
+
+    threaded_callback_queue queue;
+    queue.set_number_of_threads(2);
+    std::atomic<int64_t> checksum(0);
+    {
+        // A queue this shallow keeps most reads waiting in the scheduler
+        io::async_io::Options opts;
+        opts.queue_depth = 4;
+        io::io_scheduler scheduler(queue, opts);
+
+        std::vector<io::io_file>                                          files;
+        std::vector<std::vector<char>>                                    buffers(file_count);
+        std::vector<io::io_scheduler::future_pointer>                     reads;
+        std::vector<threaded_callback_queue::shared_future_pointer<bool>> checks;
+        for (size_t i = 0; i < file_count; ++i)
+        {
+            files.push_back(io::io_file::open(paths[i]));
+            buffers[i].resize(contents[i].size());
+        }
+        for (size_t i = 0; i < file_count; ++i)
+        {
+            auto read = scheduler.read(files[i], 0, buffers[i].data(), buffers[i].size());
+            reads.push_back(read);
+
+            // Runs in the queue once the read is in
+            checks.push_back(queue.push_dependent(
+                std::vector<io::io_scheduler::future_pointer>{read},
+                [&, i, read]
+                {
+                    checksum += read->get().result;
+                    return buffers[i] == contents[i];
+                }));
+        }
+
+        for (size_t i = 0; i < file_count; ++i)
+        {
+            EXPECT_TRUE(queue.get(checks[i]));
+            EXPECT_EQ(reads[i]->get().result, static_cast<int64_t>(contents[i].size()));
+        }
+
+        auto out =
+            io::io_file::open(temp_path("quarisma_io_scheduler.out"), io::io_file::mode::WRITE);
+        auto write = scheduler.write(out, 0, contents[0].data(), contents[0].size());
+        write->wait();
+        EXPECT_EQ(write->get().result, static_cast<int64_t>(contents[0].size()));
+    }
+
+    int64_t expected = 0;
+    for (auto const& bytes : contents)
+    {
+        expected += static_cast<int64_t>(bytes.size());
+    }
+    EXPECT_EQ(checksum.load(), expected);
+
+    for (auto const& path : paths)
+    {
+        std::filesystem::remove(path);
+    }
+    std::filesystem::remove(temp_path("quarisma_io_scheduler.out"));
+}
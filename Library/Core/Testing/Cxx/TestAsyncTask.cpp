@@ -0,0 +1,198 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Unit tests for the coroutine task of parallel/async_task.h
+ *
+ * Tests cover:
+ * - Results, void tasks, nesting and exception propagation through co_await
+ * - schedule() moving coroutines to the pool
+ * - Awaiting threaded_callback_queue futures without parking pool workers
+ *
+ * Requires C++20 coroutines (QUARISMA_HAS_COROUTINES).
+ */
+
+#include "common/macros.h"
+
+#if QUARISMA_HAS_COROUTINES
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "parallel/async_task.h"
+#include "parallel/std_thread/parallel_thread_pool.h"
+#include "parallel/threaded_callback_queue.h"
+
+namespace quarisma
+{
+namespace
+{
+using pool_type = detail::parallel::parallel_thread_pool;
+
+task<int> add(int a, int b)
+{
+    co_return a + b;
+}
+
+task<int> fibonacci(int n)
+{
+    if (n < 2)
+    {
+        co_return n;
+    }
+    const int a = co_await fibonacci(n - 1);
+    const int b = co_await fibonacci(n - 2);
+    co_return a + b;
+}
+
+task<void> count_to(int n, std::atomic<int>& counter)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        co_await schedule();
+        counter.fetch_add(1);
+    }
+}
+
+task<int> fail()
+{
+    co_await schedule();
+    throw std::runtime_error("task failed");
+    co_return 0;
+}
+
+task<bool> runs_on_pool()
+{
+    co_await schedule();
+    co_return pool_type::instance().is_parallel_scope();
+}
+}  // namespace
+
+// ============================================================================
+// Consolidated Test 1: Results, Nesting and Exceptions
+// ============================================================================
+
+QUARISMATEST(AsyncTask, results_and_exceptions)
+{
+    // Test 1: Value, nested and void tasks
+    EXPECT_EQ(sync_wait(add(2, 3)), 5);
+    EXPECT_EQ(sync_wait(fibonacci(15)), 610);
+
+    std::atomic<int> counter{0};
+    sync_wait(count_to(100, counter));
+    EXPECT_EQ(counter.load(), 100);
+
+    // Test 2: Exceptions reach the awaiter and sync_wait
+    EXPECT_THROW(sync_wait(fail()), std::runtime_error);
+
+    auto catcher = []() -> task<int>
+    {
+        try
+        {
+            co_return co_await fail();
+        }
+        catch (const std::runtime_error&)
+        {
+            co_return -1;
+        }
+    };
+    EXPECT_EQ(sync_wait(catcher()), -1);
+
+    // Test 3: schedule() resumes on a pool worker; tasks can be awaited after completion
+    EXPECT_TRUE(sync_wait(runs_on_pool()));
+
+    auto outer = []() -> task<int>
+    {
+        task<int> inner = add(20, 22);
+        co_return co_await inner;
+    };
+    EXPECT_EQ(sync_wait(outer()), 42);
+
+    // Test 4: Awaiting an empty (moved-from) task raises instead of terminating
+    auto empty = []() -> task<int>
+    {
+        task<int> inner = add(1, 2);
+        task<int> taken = std::move(inner);
+        co_return co_await inner;
+    };
+    EXPECT_ANY_THROW(sync_wait(empty()));
+}
+
+// ============================================================================
+// Consolidated Test 2: Awaiting Futures Without Blocking
+// ============================================================================
+
+QUARISMATEST(AsyncTask, await_future)
+{
+    threaded_callback_queue queue;
+
+    // Test 1: co_await on a future returns its value, on the pool
+    {
+        auto future = queue.push([] { return 7; });
+        auto reader = [](threaded_callback_queue::shared_future_pointer<int> f) -> task<int>
+        { co_return co_await await_future(f); };
+        EXPECT_EQ(sync_wait(reader(future)), 7);
+
+        auto void_future = queue.push([] {});
+        auto waiter = [](threaded_callback_queue::shared_future_pointer<void> f) -> task<bool>
+        {
+            co_await await_future(f);
+            co_return f->is_ready();
+        };
+        EXPECT_TRUE(sync_wait(waiter(void_future)));
+    }
+
+    // Test 2: Many more suspended coroutines than pool workers, all awaiting one
+    // future; the pool keeps running other jobs meanwhile
+    {
+        std::promise<void> gate;
+        auto               released = gate.get_future().share();
+        auto               blocked  = queue.push([released] { released.wait(); return 5; });
+
+        const std::size_t coroutines = 4 * pool_type::instance().thread_count();
+        std::atomic<int>  suspended{0};
+        auto awaiter = [&suspended](threaded_callback_queue::shared_future_pointer<int> f)
+            -> task<int>
+        {
+            co_await schedule();
+            suspended.fetch_add(1);
+            co_return co_await await_future(f);
+        };
+
+        std::vector<std::thread> callers;
+        std::atomic<int>         total{0};
+        for (std::size_t i = 0; i < coroutines; ++i)
+        {
+            callers.emplace_back([&] { total.fetch_add(sync_wait(awaiter(blocked))); });
+        }
+        while (suspended.load() < static_cast<int>(coroutines))
+        {
+            std::this_thread::yield();
+        }
+
+        std::promise<void> ran;
+        auto               ran_future = ran.get_future();
+        pool_type::instance().post([&ran] { ran.set_value(); });
+        EXPECT_EQ(
+            ran_future.wait_for(std::chrono::seconds(10)), std::future_status::ready)
+            << "A pool worker is parked by a suspended coroutine";
+
+        gate.set_value();
+        for (auto& caller : callers)
+        {
+            caller.join();
+        }
+        EXPECT_EQ(total.load(), 5 * static_cast<int>(coroutines));
+    }
+}
+
+}  // namespace quarisma
+
+#endif  // QUARISMA_HAS_COROUTINES
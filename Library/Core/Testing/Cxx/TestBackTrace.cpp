@@ -88,6 +88,32 @@ QUARISMATEST(BackTrace, capture_and_format)
     END_TEST();
 }
 
+QUARISMATEST(BackTrace, capture_addresses_and_symbolize)
+{
+    auto addresses = back_trace::capture_addresses(0, 10);
+    EXPECT_LE(addresses.size(), 10U);
+
+    if (back_trace::is_supported())
+    {
+        EXPECT_FALSE(addresses.empty());
+    }
+
+    backtrace_options options;
+    options.skip_python_frames = false;
+
+    // One frame per address, in capture order
+    auto frames = back_trace::symbolize(addresses, options);
+    EXPECT_EQ(frames.size(), addresses.size());
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        EXPECT_EQ(frames[i].return_address, addresses[i]);
+        EXPECT_FALSE(frames[i].function_name.empty());
+    }
+
+    EXPECT_TRUE(back_trace::symbolize({}).empty());
+    END_TEST();
+}
+
 QUARISMATEST(BackTrace, compact_format)
 {
     backtrace_options options;
@@ -0,0 +1,191 @@
+/**
+ * @file TestBuffer.cpp
+ * @brief Test suite for reference-counted buffers and their views
+ *
+ * Tests buffer and buffer_view including:
+ * - Memory returned to the originating Allocator, or to a custom deleter
+ * - Slicing without copies, and bounds checks
+ * - Copy-on-write of shared, sliced and read-only bytes
+ * - Views shared across threads
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/buffer.h"
+#include "memory/cpu/allocator.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+class counting_allocator : public Allocator
+{
+public:
+    std::string Name() const override { return "counting_allocator"; }
+
+    void* allocate_raw(size_t alignment, size_t num_bytes) override
+    {
+        ++allocations;
+        return cpu_allocator()->allocate_raw(alignment, num_bytes);
+    }
+
+    void deallocate_raw(void* ptr) override
+    {
+        ++deallocations;
+        cpu_allocator()->deallocate_raw(ptr);
+    }
+
+    std::atomic<int> allocations{0};
+    std::atomic<int> deallocations{0};
+};
+
+buffer_view iota_view(size_t count, Allocator* allocator = nullptr)
+{
+    buffer_view view(buffer::allocate(count * sizeof(int32_t), allocator));
+    std::iota(view.mutable_values<int32_t>(), view.mutable_values<int32_t>() + count, 0);
+    return view;
+}
+
+}  // namespace
+
+QUARISMATEST(Buffer, returns_memory_to_its_allocator)
+{
+    counting_allocator allocator;
+    {
+        buffer_view const view = iota_view(100, &allocator);
+        EXPECT_EQ(view.size(), 400u);
+        EXPECT_EQ(view.source()->allocator(), &allocator);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(view.data()) % QUARISMA_ALIGNMENT, 0u);
+
+        buffer_view const copy = view;
+        EXPECT_EQ(copy.data(), view.data());
+        EXPECT_EQ(allocator.allocations, 1);
+        EXPECT_EQ(allocator.deallocations, 0);
+    }
+    EXPECT_EQ(allocator.deallocations, 1);
+
+    int released = 0;
+    {
+        void*       memory = std::malloc(64);
+        buffer_view view(buffer::adopt(
+            memory,
+            64,
+            [&](void* data, size_t size)
+            {
+                EXPECT_EQ(data, memory);
+                EXPECT_EQ(size, 64u);
+                std::free(data);
+                ++released;
+            }));
+        EXPECT_EQ(view.source()->allocator(), nullptr);
+        EXPECT_TRUE(view.is_unique());
+        EXPECT_EQ(view.mutable_data(), memory);
+    }
+    EXPECT_EQ(released, 1);
+}
+
+QUARISMATEST(Buffer, slices_share_bytes)
+{
+    buffer_view const whole = iota_view(16);
+    buffer_view const tail  = whole.slice(8 * sizeof(int32_t));
+    buffer_view const mid   = tail.slice(2 * sizeof(int32_t), 4 * sizeof(int32_t));
+
+    EXPECT_EQ(tail.data(), whole.data() + 32);
+    EXPECT_EQ(mid.values<int32_t>()[0], 10);
+    EXPECT_EQ(mid.values<int32_t>()[3], 13);
+    EXPECT_EQ(mid.offset(), 40u);
+    EXPECT_EQ(whole.source().use_count(), 3u);
+    EXPECT_TRUE(whole.slice(64).empty());
+
+    EXPECT_ANY_THROW(whole.slice(65));
+    EXPECT_ANY_THROW(mid.slice(4, 16));
+    EXPECT_ANY_THROW(buffer_view(whole.source(), 60, 8));
+
+    buffer_view const none;
+    EXPECT_EQ(none.data(), nullptr);
+    EXPECT_TRUE(none.empty());
+    EXPECT_TRUE(none.copy().empty());
+}
+
+QUARISMATEST(Buffer, copies_on_write)
+{
+    counting_allocator allocator;
+    buffer_view        original = iota_view(8, &allocator);
+    const uint8_t*     bytes    = original.data();
+
+    // The only holder writes in place
+    EXPECT_TRUE(original.is_unique());
+    original.mutable_values<int32_t>()[0] = 100;
+    EXPECT_EQ(original.data(), bytes);
+    EXPECT_EQ(allocator.allocations, 1);
+
+    // A shared holder writes to a private copy from the same allocator
+    buffer_view shared = original.slice(4 * sizeof(int32_t));
+    EXPECT_FALSE(shared.is_unique());
+    shared.mutable_values<int32_t>()[0] = -4;
+    EXPECT_EQ(allocator.allocations, 2);
+    EXPECT_EQ(shared.size(), 16u);
+    EXPECT_EQ(shared.offset(), 0u);
+    EXPECT_EQ(shared.values<int32_t>()[1], 5);
+    EXPECT_EQ(original.values<int32_t>()[4], 4);
+    EXPECT_EQ(original.values<int32_t>()[0], 100);
+
+    // ...after which the original is unique again and keeps its bytes
+    EXPECT_TRUE(original.is_unique());
+    original.make_unique();
+    EXPECT_EQ(original.data(), bytes);
+
+    // Read-only memory is copied even by its only holder
+    static const int32_t table[] = {1, 2, 3};
+    buffer_view          constant(buffer::wrap(table, sizeof(table)));
+    EXPECT_FALSE(constant.is_unique());
+    EXPECT_EQ(constant.data(), reinterpret_cast<const uint8_t*>(table));
+    constant.mutable_values<int32_t>()[2] = 30;
+    EXPECT_EQ(table[2], 3);
+    EXPECT_EQ(constant.values<int32_t>()[2], 30);
+    EXPECT_TRUE(constant.is_unique());
+}
+
+QUARISMATEST(Buffer, shared_across_threads)
+{
+    constexpr size_t count   = 4096;
+    buffer_view const source = iota_view(count);
+
+    std::vector<std::thread> threads;
+    std::atomic<int>         mismatches{0};
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back(
+            [&, t]
+            {
+                for (int round = 0; round < 200; ++round)
+                {
+                    buffer_view mine = source.slice(0);
+                    if (mine.values<int32_t>()[count - 1] != static_cast<int32_t>(count - 1))
+                    {
+                        ++mismatches;
+                    }
+                    mine.mutable_values<int32_t>()[count - 1] = t;
+                    if (mine.data() == source.data())
+                    {
+                        ++mismatches;
+                    }
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_EQ(source.values<int32_t>()[count - 1], static_cast<int32_t>(count - 1));
+    EXPECT_EQ(source.source().use_count(), 1u);
+}
@@ -22,6 +22,7 @@
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "common/configure.h"
@@ -142,6 +143,57 @@ QUARISMATEST(CPUMemoryStats, timing_stats_snapshot)
     END_TEST();
 }
 
+QUARISMATEST(CPUMemoryStats, latency_histogram_percentiles)
+{
+    // Buckets tile the range without gaps, each at most 1/16 of its values wide
+    for (size_t bucket = 1; bucket < latency_histogram::kBuckets; ++bucket)
+    {
+        EXPECT_EQ(
+            latency_histogram::bucket_lower_ns(bucket),
+            latency_histogram::bucket_upper_ns(bucket - 1));
+        EXPECT_EQ(latency_histogram::bucket_index(latency_histogram::bucket_lower_ns(bucket)), bucket);
+    }
+    EXPECT_EQ(latency_histogram::bucket_index(UINT64_MAX), latency_histogram::kBuckets - 1);
+
+    // 9990 fast operations and a tail of 10 slow ones, from several threads
+    latency_histogram        histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back(
+            [&histogram, t]
+            {
+                for (int i = t; i < 9990; i += 4)
+                {
+                    histogram.record(1000 + i % 100);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        histogram.record(5000000);
+    }
+
+    auto const snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 10000U);
+    EXPECT_EQ(snapshot.max_ns, 5000000U);
+    EXPECT_GE(snapshot.percentile_ns(50.0), 1000U);
+    EXPECT_LE(snapshot.percentile_ns(99.0), 1100U + 1100U / 16);  // Within a bucket width
+    EXPECT_EQ(snapshot.percentile_ns(99.95), 5000000U);  // The tail an average hides
+    EXPECT_EQ(snapshot.percentile_ns(100.0), 5000000U);
+    EXPECT_LT(snapshot.mean_ns(), 7000.0);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.snapshot().count, 0U);
+    EXPECT_EQ(histogram.snapshot().percentile_ns(99.9), 0U);
+
+    END_TEST();
+}
+
 QUARISMATEST(CPUMemoryStats, unified_cache_stats_functionality)
 {
     unified_cache_stats stats;
@@ -288,6 +340,9 @@ QUARISMATEST(CPUMemoryStats, comprehensive_tests)
     // Test timing stats snapshot
     QUARISMATEST_CALL(CPUMemoryStats, timing_stats_snapshot);
 
+    // Test latency histograms
+    QUARISMATEST_CALL(CPUMemoryStats, latency_histogram_percentiles);
+
     // Test unified cache statistics
     QUARISMATEST_CALL(CPUMemoryStats, unified_cache_stats_functionality);
 
@@ -21,9 +21,10 @@
 
 #include <vector>
 
-#include "logging/logger.h"  // for END_LOG_TO_FILE_NAME, START_LOG_TO_FILE_NAME
-#include "util/cpu_info.h"   // for cpu_info
-#include "baseTest.h"      // for END_TEST, QUARISMATEST
+#include "logging/logger.h"     // for END_LOG_TO_FILE_NAME, START_LOG_TO_FILE_NAME
+#include "util/cpu_info.h"      // for cpu_info
+#include "util/cpu_topology.h"  // for cpu_topology
+#include "baseTest.h"           // for END_TEST, QUARISMATEST
 
 QUARISMATEST(CPUinfo, CPUinfo)
 {
@@ -135,3 +136,64 @@ QUARISMATEST(CPUinfo, cpuinfo_cache_hierarchy)
 
     END_TEST();
 }
+
+QUARISMATEST(CPUinfo, capability)
+{
+    using quarisma::cpu_capability;
+
+    EXPECT_STREQ(quarisma::to_string(cpu_capability::DEFAULT), "default");
+    EXPECT_STREQ(quarisma::to_string(cpu_capability::AVX2), "avx2");
+    EXPECT_STREQ(quarisma::to_string(cpu_capability::AVX512), "avx512");
+
+    // Detected once, and never above what the build can dispatch to
+    cpu_capability const capability = quarisma::cpu_info::capability();
+    EXPECT_EQ(quarisma::cpu_info::capability(), capability);
+    EXPECT_GE(capability, cpu_capability::DEFAULT);
+    EXPECT_LE(capability, cpu_capability::AVX512);
+
+    END_TEST();
+}
+
+QUARISMATEST(CPUinfo, topology)
+{
+    using quarisma::cpu_topology;
+
+    cpu_topology const& topology = cpu_topology::instance();
+    EXPECT_EQ(&cpu_topology::instance(), &topology);
+
+    EXPECT_GE(topology.packages(), 1);
+    EXPECT_GE(topology.cores(), topology.packages());
+    EXPECT_LE(topology.cores(), topology.processors());
+    EXPECT_GE(topology.cores_per_package(), 1);
+    EXPECT_GE(topology.threads_per_core(), 1);
+    EXPECT_GE(topology.numa_nodes(), 1);
+
+    // The fallback sizes apply when cpuinfo cannot read the machine: L1d and L2 never vanish
+    EXPECT_GT(topology.l1d().size, 0U);
+    EXPECT_GT(topology.l2().size, 0U);
+    EXPECT_LE(topology.l1d().size, topology.l2().size);
+    for (auto const* cache : {&topology.l1d(), &topology.l2(), &topology.l3()})
+    {
+        EXPECT_GT(cache->line_size, 0U);
+        EXPECT_EQ(cache->line_size & (cache->line_size - 1), 0U);
+        EXPECT_GE(cache->processors, 1);
+        EXPECT_LE(topology.cache_per_core(*cache), cache->size);
+    }
+    EXPECT_GT(topology.cache_per_core(topology.l2()), 0U);
+
+    for (int id = 0; id < topology.processors(); ++id)
+    {
+        quarisma::cpu_processor const processor = topology.processor(id);
+        EXPECT_GE(processor.core, 0);
+        EXPECT_LT(processor.core, topology.cores());
+        EXPECT_GE(processor.package, 0);
+        EXPECT_LT(processor.package, topology.packages());
+        EXPECT_GE(processor.smt, 0);
+        EXPECT_GE(processor.numa_node, 0);
+        EXPECT_LT(processor.numa_node, topology.numa_nodes());
+    }
+    EXPECT_EQ(topology.processor(-1).core, 0);
+    EXPECT_EQ(topology.processor(topology.processors()).smt, 0);
+
+    END_TEST();
+}
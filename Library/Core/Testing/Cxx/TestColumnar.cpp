@@ -0,0 +1,279 @@
+/**
+ * @file TestColumnar.cpp
+ * @brief Test suite for the columnar buffer format
+ *
+ * Tests column_buffer, column, record_batch and their exchange including:
+ * - Aligned, padded and shared buffers, slices and validity bitmaps
+ * - Serializing to memory and to mapped files, read back in place
+ * - Rejection of corrupt serializations
+ * - Export to and import from the Arrow C data interface
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/columnar/arrow_bridge.h"
+#include "memory/columnar/column.h"
+#include "memory/columnar/columnar_ipc.h"
+
+using namespace quarisma;
+using namespace quarisma::columnar;
+
+namespace
+{
+
+bool is_aligned(const void* ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+record_batch make_batch(size_t rows)
+{
+    std::vector<int64_t> ids(rows);
+    std::vector<double>  pvs(rows);
+    std::vector<float>   deltas(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        ids[i]    = static_cast<int64_t>(i) * 3;
+        pvs[i]    = 100.0 + static_cast<double>(i) * 0.25;
+        deltas[i] = static_cast<float>(i) * -0.5f;
+    }
+
+    record_batch batch;
+    batch.add("id", column::copy_of(ids));
+    auto pv = column::copy_of(pvs);
+    for (size_t i = 0; i < rows; i += 7)
+    {
+        pv.set_valid(i, false);
+    }
+    batch.add("pv", std::move(pv));
+    batch.add("delta", column::copy_of(deltas));
+    return batch;
+}
+
+void expect_same(const record_batch& a, const record_batch& b)
+{
+    ASSERT_EQ(a.num_columns(), b.num_columns());
+    ASSERT_EQ(a.num_rows(), b.num_rows());
+    for (size_t c = 0; c < a.num_columns(); ++c)
+    {
+        EXPECT_EQ(a.name(c), b.name(c));
+        column const& x = a.get(c);
+        column const& y = b.get(c);
+        ASSERT_EQ(x.type(), y.type());
+        EXPECT_EQ(x.null_count(), y.null_count());
+        size_t const width = column_type_size(x.type());
+        for (size_t i = 0; i < a.num_rows(); ++i)
+        {
+            EXPECT_EQ(x.is_valid(i), y.is_valid(i));
+            EXPECT_EQ(
+                std::memcmp(
+                    x.values_buffer()->data() + (x.offset() + i) * width,
+                    y.values_buffer()->data() + (y.offset() + i) * width,
+                    width),
+                0);
+        }
+    }
+}
+
+}  // namespace
+
+QUARISMATEST(Columnar, buffers_and_columns)
+{
+    auto buffer = column_buffer::allocate(100);
+    EXPECT_TRUE(is_aligned(buffer->data(), column_buffer::alignment));
+    EXPECT_EQ(buffer->size(), 100u);
+    EXPECT_TRUE(buffer->owns_memory());
+
+    std::vector<double> values(1000);
+    std::iota(values.begin(), values.end(), 0.0);
+    auto prices = column::copy_of(values);
+    EXPECT_EQ(prices.type(), column_type::FLOAT64);
+    EXPECT_EQ(prices.length(), 1000u);
+    EXPECT_EQ(prices.null_count(), 0u);
+    EXPECT_EQ(prices.validity_buffer(), nullptr);
+    EXPECT_EQ(prices.values<double>()[999], 999.0);
+    ASSERT_ANY_THROW(prices.values<float>());
+
+    // Copies and slices share the buffer
+    column copy = prices;
+    EXPECT_EQ(copy.values_buffer().get(), prices.values_buffer().get());
+    copy.mutable_values<double>()[5] = -1.0;
+    EXPECT_EQ(prices.values<double>()[5], -1.0);
+
+    prices.set_valid(3, false);
+    prices.set_valid(500, false);
+    prices.set_valid(500, false);
+    EXPECT_EQ(prices.null_count(), 2u);
+    EXPECT_FALSE(prices.is_valid(3));
+    EXPECT_TRUE(prices.is_valid(4));
+
+    auto tail = prices.slice(400, 200);
+    EXPECT_EQ(tail.offset(), 400u);
+    EXPECT_EQ(tail.values<double>()[0], 400.0);
+    EXPECT_EQ(tail.null_count(), 1u);
+    EXPECT_FALSE(tail.is_valid(100));
+    ASSERT_ANY_THROW(prices.slice(900, 200));
+
+    prices.set_valid(3, true);
+    EXPECT_EQ(prices.null_count(), 1u);
+
+    record_batch batch = make_batch(50);
+    EXPECT_EQ(batch.num_columns(), 3u);
+    ASSERT_NE(batch.find("pv"), nullptr);
+    EXPECT_EQ(batch.find("missing"), nullptr);
+    EXPECT_EQ(batch.find("pv")->null_count(), 8u);
+    ASSERT_ANY_THROW(batch.add("short", column::allocate<int32_t>(10)));
+    ASSERT_ANY_THROW(batch.add("id", column::allocate<int32_t>(50)));
+
+    auto const part = batch.slice(10, 20);
+    EXPECT_EQ(part.num_rows(), 20u);
+    EXPECT_EQ(part.find("id")->values<int64_t>()[0], 30);
+}
+
+QUARISMATEST(Columnar, bit_helpers)
+{
+    uint8_t bits[4] = {0xb5, 0x3c, 0xff, 0x01};
+    EXPECT_EQ(columnar::detail::count_set_bits(bits, 0, 32), 5u + 4u + 8u + 1u);
+    EXPECT_EQ(columnar::detail::count_set_bits(bits, 3, 10), 6u);
+
+    for (size_t offset = 0; offset < 16; ++offset)
+    {
+        for (size_t length = 1; offset + length <= 32; length += 5)
+        {
+            uint8_t copied[4] = {0xaa, 0xaa, 0xaa, 0xaa};
+            columnar::detail::copy_bits(bits, offset, length, copied);
+            for (size_t i = 0; i < length; ++i)
+            {
+                size_t const bit = offset + i;
+                EXPECT_EQ((copied[i / 8] >> (i % 8)) & 1, (bits[bit / 8] >> (bit % 8)) & 1);
+            }
+            if (length % 8 != 0)
+            {
+                EXPECT_EQ(copied[length / 8] >> (length % 8), 0);
+            }
+        }
+    }
+}
+
+QUARISMATEST(Columnar, serializes_in_place)
+{
+    record_batch const batch = make_batch(1001);
+    size_t const       size  = serialized_size(batch);
+    EXPECT_EQ(size % 64, 0u);
+
+    auto storage = column_buffer::allocate(size);
+    serialize(batch, storage->mutable_data());
+
+    auto read_back = read(storage->data(), size, intrusive_ptr<intrusive_ptr_target>(storage));
+    ASSERT_TRUE(read_back.has_value());
+    expect_same(batch, *read_back);
+
+    // The columns view the serialized bytes
+    column const& ids = *read_back->find("id");
+    EXPECT_FALSE(ids.values_buffer()->owns_memory());
+    EXPECT_GE(ids.values_buffer()->data(), storage->data());
+    EXPECT_LT(ids.values_buffer()->data(), storage->data() + size);
+    EXPECT_TRUE(is_aligned(ids.values<int64_t>(), 64));
+
+    // A slice at an odd offset is written from its offset
+    record_batch const part = batch.slice(13, 500);
+    auto               bytes = column_buffer::allocate(serialized_size(part));
+    serialize(part, bytes->mutable_data());
+    auto part_back = read(bytes->data(), bytes->size(), intrusive_ptr<intrusive_ptr_target>(bytes));
+    ASSERT_TRUE(part_back.has_value());
+    expect_same(part, *part_back);
+    EXPECT_EQ(part_back->find("pv")->offset(), 0u);
+}
+
+QUARISMATEST(Columnar, rejects_corrupt_input)
+{
+    record_batch const batch = make_batch(100);
+    size_t const       size  = serialized_size(batch);
+    auto               bytes = column_buffer::allocate(size);
+    serialize(batch, bytes->mutable_data());
+    intrusive_ptr<intrusive_ptr_target> owner(bytes);
+
+    EXPECT_FALSE(read(bytes->data(), 16, owner).has_value());
+    EXPECT_FALSE(read(bytes->data(), size - 64, owner).has_value());
+
+    // Any change to the metadata fails its checksum
+    bytes->mutable_data()[40] ^= 1;
+    EXPECT_FALSE(read(bytes->data(), size, owner).has_value());
+    bytes->mutable_data()[40] ^= 1;
+    bytes->mutable_data()[0] = 'X';
+    EXPECT_FALSE(read(bytes->data(), size, owner).has_value());
+    bytes->mutable_data()[0] = 'Q';
+    EXPECT_TRUE(read(bytes->data(), size, owner).has_value());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+QUARISMATEST(Columnar, maps_files)
+{
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "quarisma_columnar.qcol").string();
+    record_batch const batch = make_batch(100000);
+    write_file(batch, path);
+    EXPECT_EQ(std::filesystem::file_size(path), serialized_size(batch));
+
+    column pv;
+    {
+        auto mapped = map_file(path);
+        ASSERT_TRUE(mapped.has_value());
+        expect_same(batch, *mapped);
+        pv = *mapped->find("pv");
+    }
+    // The column keeps the mapping alive after its batch is gone
+    EXPECT_EQ(pv.values<double>()[99999], batch.find("pv")->values<double>()[99999]);
+
+    // Rewriting a shorter batch leaves no stale tail
+    write_file(make_batch(10), path);
+    EXPECT_EQ(map_file(path)->num_rows(), 10u);
+    pv = column();
+    std::filesystem::remove(path);
+}
+#endif
+
+QUARISMATEST(Columnar, exchanges_arrow_arrays)
+{
+    record_batch const batch = make_batch(300);
+
+    ArrowArray  array;
+    ArrowSchema schema;
+    export_column(batch.get(1).slice(5, 100), "pv", &array, &schema);
+    EXPECT_STREQ(schema.format, "g");
+    EXPECT_STREQ(schema.name, "pv");
+    EXPECT_EQ(array.length, 100);
+    EXPECT_EQ(array.offset, 5);
+    EXPECT_EQ(array.n_buffers, 2);
+    EXPECT_EQ(array.buffers[1], batch.get(1).values_buffer()->data());
+
+    auto imported = import_column(&array, schema);
+    ASSERT_TRUE(imported.has_value());
+    EXPECT_EQ(array.release, nullptr);
+    schema.release(&schema);
+    EXPECT_EQ(imported->values<double>(), batch.get(1).values<double>() + 5);
+    EXPECT_EQ(imported->null_count(), batch.get(1).slice(5, 100).null_count());
+
+    export_record_batch(batch, &array, &schema);
+    EXPECT_STREQ(schema.format, "+s");
+    EXPECT_EQ(schema.n_children, 3);
+    EXPECT_STREQ(schema.children[2]->name, "delta");
+    EXPECT_STREQ(schema.children[2]->format, "f");
+
+    auto batch_back = import_record_batch(&array, schema);
+    ASSERT_TRUE(batch_back.has_value());
+    schema.release(&schema);
+    expect_same(batch, *batch_back);
+
+    // A released array is not importable
+    export_column(batch.get(0), "id", &array, &schema);
+    array.release(&array);
+    EXPECT_FALSE(import_column(&array, schema).has_value());
+    schema.release(&schema);
+}
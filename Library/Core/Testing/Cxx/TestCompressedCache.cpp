@@ -0,0 +1,278 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "compression/codec.h"
+#include "memory/compressed_cache.h"
+
+using namespace quarisma;
+
+namespace
+{
+// Run-length codec, so that the compressed tier is exercised even when no
+// compression library is built in
+class rle_codec final : public compression::codec
+{
+public:
+    compression::codec_type type() const noexcept override
+    {
+        return compression::codec_type::none;
+    }
+
+    const char* name() const noexcept override { return "rle"; }
+
+    size_t max_compressed_length(size_t length) const noexcept override { return 2 * length; }
+
+    bool compress(const char* input, size_t length, std::string* output) const override
+    {
+        output->clear();
+        for (size_t i = 0; i < length;)
+        {
+            size_t run = 1;
+            while (i + run < length && run < 255 && input[i + run] == input[i])
+            {
+                ++run;
+            }
+            output->push_back(static_cast<char>(run));
+            output->push_back(input[i]);
+            i += run;
+        }
+        return true;
+    }
+
+    bool uncompress(
+        const char* input, size_t length, std::string* output, size_t max_length) const override
+    {
+        output->clear();
+        for (size_t i = 0; i + 1 < length; i += 2)
+        {
+            output->append(static_cast<unsigned char>(input[i]), input[i + 1]);
+            if (output->size() > max_length)
+            {
+                return false;
+            }
+        }
+        return length % 2 == 0;
+    }
+
+    bool uncompress_into(
+        const char* input, size_t length, char* output, size_t output_length) const override
+    {
+        std::string data;
+        if (!uncompress(input, length, &data, output_length) || data.size() != output_length)
+        {
+            return false;
+        }
+        std::memcpy(output, data.data(), data.size());
+        return true;
+    }
+};
+
+const rle_codec rle;
+
+compressed_cache::options small_cache(size_t resident_budget, size_t compressed_budget)
+{
+    compressed_cache::options opts;
+    opts.resident_budget   = resident_budget;
+    opts.compressed_budget = compressed_budget;
+    opts.codec             = &rle;
+    opts.name              = "";
+    return opts;
+}
+
+// 1000 bytes that run-length encode to 80
+std::string compressible(char c)
+{
+    std::string data;
+    for (int i = 0; i < 40; ++i)
+    {
+        data.append(25, static_cast<char>(c + i % 2));
+    }
+    return data;
+}
+
+// 1000 bytes without runs, which run-length encoding doubles
+std::string incompressible()
+{
+    std::string data(1000, '\0');
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<char>(i % 2);
+    }
+    return data;
+}
+}  // namespace
+
+QUARISMATEST(CompressedCache, resident_hits_and_misses)
+{
+    compressed_cache cache(small_cache(10000, 10000));
+
+    EXPECT_EQ(cache.get(1), nullptr);
+    auto const stored = cache.put(1, compressible('a'));
+    ASSERT_NE(stored, nullptr);
+    EXPECT_TRUE(cache.contains(1));
+
+    auto const found = cache.get(1);
+    EXPECT_EQ(found, stored);
+    EXPECT_EQ(*found, compressible('a'));
+
+    auto const stats = cache.stats();
+    EXPECT_EQ(stats.resident_hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.resident_entries, 1u);
+    EXPECT_EQ(stats.resident_bytes, 1000u);
+    EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.5);
+
+    // Replacing an entry updates its size
+    cache.put(1, std::string(10, 'x'));
+    EXPECT_EQ(cache.stats().resident_bytes, 10u);
+    EXPECT_TRUE(cache.erase(1));
+    EXPECT_FALSE(cache.erase(1));
+    EXPECT_EQ(cache.stats().resident_entries, 0u);
+    END_TEST();
+}
+
+QUARISMATEST(CompressedCache, cold_entries_are_compressed)
+{
+    // Room for 3 resident entries; the 7 older ones fit compressed (80 bytes each)
+    compressed_cache cache(small_cache(3000, 1000));
+    for (int key = 0; key < 10; ++key)
+    {
+        cache.put(key, compressible(static_cast<char>('a' + key)));
+    }
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.resident_entries, 3u);
+    EXPECT_EQ(stats.compressed_entries, 7u);
+    EXPECT_EQ(stats.compressed_bytes, 7u * 80u);
+    EXPECT_EQ(stats.compressions, 7);
+    EXPECT_EQ(stats.evictions, 0);
+    EXPECT_DOUBLE_EQ(stats.compression_ratio(), 12.5);
+
+    // Ten entries of 1000 bytes in 3560 bytes, every one still a hit
+    for (int key = 0; key < 10; ++key)
+    {
+        auto const data = cache.get(key);
+        ASSERT_NE(data, nullptr) << key;
+        EXPECT_EQ(*data, compressible(static_cast<char>('a' + key))) << key;
+    }
+    stats = cache.stats();
+    EXPECT_EQ(stats.misses, 0);
+    EXPECT_GT(stats.compressed_hits, 0);
+    EXPECT_DOUBLE_EQ(stats.hit_rate(), 1.0);
+    EXPECT_LE(stats.resident_bytes, 3000u);
+    EXPECT_LE(stats.compressed_bytes, 1000u);
+    END_TEST();
+}
+
+QUARISMATEST(CompressedCache, budgets_evict_least_recently_used)
+{
+    // 2 resident entries, 2 compressed ones
+    compressed_cache cache(small_cache(2000, 160));
+    for (int key = 0; key < 4; ++key)
+    {
+        cache.put(key, compressible('a'));
+    }
+    cache.get(0);  // Promotes 0, demotes 2; 1 is now the coldest
+    cache.put(4, compressible('a'));
+
+    EXPECT_TRUE(cache.contains(0));
+    EXPECT_FALSE(cache.contains(1));
+    EXPECT_TRUE(cache.contains(2));
+    EXPECT_TRUE(cache.contains(3));
+    EXPECT_TRUE(cache.contains(4));
+    EXPECT_EQ(cache.stats().evictions, 1);
+
+    // Incompressible entries are dropped instead of compressed
+    cache.put(5, incompressible());
+    cache.put(6, incompressible());
+    cache.put(7, incompressible());
+    EXPECT_EQ(cache.stats().incompressible, 1);
+    EXPECT_FALSE(cache.contains(5));
+    END_TEST();
+}
+
+QUARISMATEST(CompressedCache, release_drops_compressed_tier_first)
+{
+    compressed_cache cache(small_cache(2000, 10000));
+    for (int key = 0; key < 5; ++key)
+    {
+        cache.put(key, compressible('a'));
+    }
+    ASSERT_EQ(cache.stats().compressed_entries, 3u);
+
+    EXPECT_EQ(cache.release(100), 160u);
+    EXPECT_EQ(cache.stats().compressed_entries, 1u);
+    EXPECT_EQ(cache.stats().resident_entries, 2u);
+
+    EXPECT_EQ(cache.release(~size_t{0}), 80u + 2000u);
+    EXPECT_EQ(cache.stats().resident_entries, 0u);
+    EXPECT_EQ(cache.stats().compressed_entries, 0u);
+
+    // Registered caches give memory back through memory_pressure
+    compressed_cache::options opts = small_cache(1000, 10000);
+    opts.name                      = "test_compressed_cache";
+    compressed_cache registered(opts);
+    registered.put(1, compressible('a'));
+    registered.put(2, compressible('b'));
+    EXPECT_GE(memory_pressure::instance().relieve(device_enum::CPU, -1, ~size_t{0}), 1080u);
+    EXPECT_FALSE(registered.contains(1));
+    EXPECT_FALSE(registered.contains(2));
+    END_TEST();
+}
+
+QUARISMATEST(CompressedCache, concurrent_access)
+{
+    compressed_cache cache(small_cache(8000, 4000));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back(
+            [&cache, t]()
+            {
+                for (int i = 0; i < 2000; ++i)
+                {
+                    int const key = (i * 7 + t) % 64;
+                    auto      data = cache.get(key);
+                    if (data == nullptr)
+                    {
+                        data = cache.put(key, compressible(static_cast<char>('a' + key % 16)));
+                    }
+                    EXPECT_EQ(*data, compressible(static_cast<char>('a' + key % 16)));
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto const stats = cache.stats();
+    EXPECT_LE(stats.resident_bytes, 8000u);
+    EXPECT_LE(stats.compressed_bytes, 4000u);
+    EXPECT_EQ(stats.resident_hits + stats.compressed_hits + stats.misses, 8000);
+    END_TEST();
+}
@@ -0,0 +1,403 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "Testing/baseTest.h"
+#include "compression/block_container.h"
+#include "compression/codec.h"
+#include "compression/framed_stream.h"
+
+using namespace quarisma::compression;
+
+namespace
+{
+// Compressible text-like data: words from a small vocabulary, with random noise
+std::string sample_data(size_t size, uint64_t seed)
+{
+    static const char* const words[] = {
+        "price ", "volume ", "bid ", "ask ", "trade ", "quote ", "0.25 ", "100 "};
+    std::mt19937_64 rng(seed);
+    std::string     data;
+    data.reserve(size + 16);
+    while (data.size() < size)
+    {
+        if (rng() % 16 == 0)
+        {
+            data.push_back(static_cast<char>(rng()));
+        }
+        else
+        {
+            data += words[rng() % 8];
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+std::string compress_framed(const std::string& input, size_t piece)
+{
+    std::string       output;
+    framed_compressor compressor([&](const char* data, size_t size) { output.append(data, size); });
+    for (size_t i = 0; i < input.size(); i += piece)
+    {
+        compressor.write(input.data() + i, std::min(piece, input.size() - i));
+    }
+    compressor.flush();
+    EXPECT_EQ(compressor.bytes_in(), input.size());
+    EXPECT_EQ(compressor.bytes_out(), output.size());
+    return output;
+}
+
+bool decompress_framed(const std::string& input, size_t piece, std::string* output)
+{
+    output->clear();
+    framed_decompressor decompressor([&](const char* data, size_t size)
+                                     { output->append(data, size); });
+    for (size_t i = 0; i < input.size(); i += piece)
+    {
+        if (!decompressor.write(input.data() + i, std::min(piece, input.size() - i)))
+        {
+            return false;
+        }
+    }
+    return decompressor.finish();
+}
+}  // namespace
+
+QUARISMATEST(Compression, codec_round_trip)
+{
+    EXPECT_TRUE(codec::available(codec_type::none));
+
+    for (auto type : {codec_type::none, codec_type::snappy, codec_type::lz4, codec_type::zstd})
+    {
+        const codec* c = codec::get(type);
+        if (c == nullptr)
+        {
+            continue;
+        }
+        EXPECT_EQ(c->type(), type);
+
+        for (size_t size : {size_t{0}, size_t{1}, size_t{1000}, size_t{300000}})
+        {
+            std::string const input = sample_data(size, size);
+            std::string       compressed;
+            std::string       output;
+            ASSERT_TRUE(c->compress(input.data(), input.size(), &compressed)) << c->name();
+            EXPECT_LE(compressed.size(), c->max_compressed_length(input.size())) << c->name();
+            ASSERT_TRUE(c->uncompress(compressed.data(), compressed.size(), &output)) << c->name();
+            EXPECT_EQ(output, input) << c->name();
+
+            // The length limit is enforced before decompressing
+            if (size != 0)
+            {
+                EXPECT_FALSE(
+                    c->uncompress(compressed.data(), compressed.size(), &output, size - 1))
+                    << c->name();
+            }
+        }
+    }
+    END_TEST();
+}
+
+QUARISMATEST(Compression, codec_rejects_corrupt_input)
+{
+    for (auto type : {codec_type::snappy, codec_type::lz4, codec_type::zstd})
+    {
+        const codec* c = codec::get(type);
+        if (c == nullptr)
+        {
+            continue;
+        }
+
+        std::string const input = sample_data(10000, 7);
+        std::string       compressed;
+        std::string       output;
+        ASSERT_TRUE(c->compress(input.data(), input.size(), &compressed));
+
+        // Truncation anywhere must fail cleanly, never read out of bounds
+        for (size_t length : {size_t{0}, size_t{1}, compressed.size() / 2, compressed.size() - 1})
+        {
+            std::string const truncated = compressed.substr(0, length);
+            bool const        ok = c->uncompress(truncated.data(), truncated.size(), &output);
+            EXPECT_TRUE(!ok || output != input) << c->name() << " " << length;
+        }
+    }
+    END_TEST();
+}
+
+QUARISMATEST(Compression, codec_select)
+{
+    const codec& speed = codec::select(codec_preference::speed);
+    const codec& ratio = codec::select(codec_preference::ratio);
+
+    if (codec::available(codec_type::lz4))
+    {
+        EXPECT_EQ(speed.type(), codec_type::lz4);
+    }
+    if (codec::available(codec_type::zstd))
+    {
+        EXPECT_EQ(ratio.type(), codec_type::zstd);
+    }
+    if (!codec::available(codec_type::snappy) && !codec::available(codec_type::lz4) &&
+        !codec::available(codec_type::zstd))
+    {
+        EXPECT_EQ(speed.type(), codec_type::none);
+        EXPECT_EQ(ratio.type(), codec_type::none);
+    }
+    std::cout << "Codec for speed: " << speed.name() << ", for ratio: " << ratio.name()
+              << std::endl;
+    END_TEST();
+}
+
+QUARISMATEST(Compression, framed_stream_format)
+{
+    // A chunk of incompressible data is stored uncompressed with its masked CRC-32C
+    std::string const stream = compress_framed("123456789", 9);
+    std::string const expected =
+        std::string("\xff\x06\x00\x00sNaPpY", 10) + std::string("\x01\x0d\x00\x00", 4) +
+        "\xe5\xb0\x8a\xc7" + "123456789";
+    EXPECT_EQ(stream, expected);
+
+    // An empty stream is the stream identifier alone
+    std::string output;
+    EXPECT_EQ(compress_framed("", 1), expected.substr(0, 10));
+    EXPECT_TRUE(decompress_framed(expected.substr(0, 10), 10, &output));
+    EXPECT_TRUE(output.empty());
+
+    // Padding and skippable chunks are ignored, concatenated streams are accepted
+    std::string const skippable = std::string("\xfe\x03\x00\x00\x00\x00\x00", 7) +
+                                  std::string("\x80\x02\x00\x00xy", 6);
+    EXPECT_TRUE(decompress_framed(expected + skippable + expected, 1, &output));
+    EXPECT_EQ(output, "123456789123456789");
+    END_TEST();
+}
+
+QUARISMATEST(Compression, framed_stream_round_trip)
+{
+    std::string const input = sample_data(5 * framed_compressor::max_chunk_size + 123, 42);
+
+    for (size_t piece : {size_t{1000}, framed_compressor::max_chunk_size, input.size()})
+    {
+        std::string const stream = compress_framed(input, piece);
+        if (codec::available(codec_type::snappy))
+        {
+            EXPECT_LT(stream.size(), input.size());
+        }
+
+        // Decompression accepts the stream in pieces of any size
+        for (size_t read_piece : {size_t{1}, size_t{7}, size_t{4096}, stream.size()})
+        {
+            std::string output;
+            ASSERT_TRUE(decompress_framed(stream, read_piece, &output)) << read_piece;
+            EXPECT_EQ(output, input) << read_piece;
+        }
+    }
+    END_TEST();
+}
+
+QUARISMATEST(Compression, framed_stream_rejects_corrupt_input)
+{
+    std::string const input  = sample_data(100000, 3);
+    std::string const stream = compress_framed(input, input.size());
+    std::string       output;
+
+    // Missing stream identifier
+    EXPECT_FALSE(decompress_framed(stream.substr(10), stream.size(), &output));
+
+    // Truncated in a chunk header and in a chunk body
+    EXPECT_FALSE(decompress_framed(stream.substr(0, 12), 5, &output));
+    EXPECT_FALSE(decompress_framed(stream.substr(0, stream.size() - 1), 5, &output));
+
+    // Flipped data byte, caught by the CRC
+    std::string corrupt = stream;
+    corrupt[corrupt.size() - 10] ^= 0x01;
+    EXPECT_FALSE(decompress_framed(corrupt, corrupt.size(), &output));
+
+    // Reserved unskippable chunk type
+    std::string const reserved = stream.substr(0, 10) + std::string("\x02\x01\x00\x00\x00", 5);
+    EXPECT_FALSE(decompress_framed(reserved, reserved.size(), &output));
+
+    // Once failed, the decompressor stays failed
+    framed_decompressor decompressor([](const char*, size_t) {});
+    EXPECT_FALSE(decompressor.write(reserved.data() + 10, 5));
+    EXPECT_TRUE(decompressor.failed());
+    EXPECT_FALSE(decompressor.write(stream.data(), stream.size()));
+    EXPECT_FALSE(decompressor.finish());
+    END_TEST();
+}
+
+QUARISMATEST(Compression, block_container_round_trip)
+{
+    size_t const block_size = block_container::min_block_size;
+
+    for (auto type : {codec_type::none, codec_type::snappy, codec_type::lz4, codec_type::zstd})
+    {
+        const codec* c = codec::get(type);
+        if (c == nullptr)
+        {
+            continue;
+        }
+
+        for (size_t size : {size_t{0}, size_t{1}, block_size, 37 * block_size + 5})
+        {
+            std::string const input = sample_data(size, size);
+            std::string       packed;
+            ASSERT_TRUE(
+                block_container::compress(input.data(), input.size(), &packed, *c, block_size));
+
+            auto const container = block_container::open(packed.data(), packed.size());
+            ASSERT_TRUE(container.has_value()) << c->name() << " " << size;
+            EXPECT_EQ(container->uncompressed_size(), size);
+            EXPECT_EQ(container->block_count(), (size + block_size - 1) / block_size);
+            EXPECT_EQ(container->block_codec().type(), type);
+
+            std::string output;
+            ASSERT_TRUE(container->uncompress(&output)) << c->name() << " " << size;
+            EXPECT_EQ(output, input);
+            if (size != 0)
+            {
+                EXPECT_FALSE(container->uncompress(&output, size - 1));
+            }
+        }
+    }
+
+    // Block sizes out of range are refused
+    std::string packed;
+    EXPECT_FALSE(block_container::compress(
+        "x", 1, &packed, codec::select(codec_preference::speed), block_size - 1));
+    END_TEST();
+}
+
+QUARISMATEST(Compression, block_container_random_access)
+{
+    size_t const      block_size = block_container::min_block_size;
+    std::string const input      = sample_data(10 * block_size + 100, 11);
+    std::string       packed;
+    ASSERT_TRUE(block_container::compress(
+        input.data(), input.size(), &packed, codec::select(codec_preference::speed), block_size));
+    auto const container = block_container::open(packed.data(), packed.size());
+    ASSERT_TRUE(container.has_value());
+
+    // Ranges within a block, across block boundaries, and up to the end
+    std::mt19937_64 rng(5);
+    for (int i = 0; i < 200; ++i)
+    {
+        size_t const offset = rng() % input.size();
+        size_t const length = rng() % (std::min<size_t>(3 * block_size, input.size() - offset) + 1);
+        std::string  output(length, '\0');
+        ASSERT_TRUE(container->read(offset, length, output.data())) << offset << " " << length;
+        EXPECT_EQ(output, input.substr(offset, length)) << offset << " " << length;
+    }
+
+    std::string block;
+    ASSERT_TRUE(container->uncompress_block(10, &block));
+    EXPECT_EQ(block, input.substr(10 * block_size));
+    EXPECT_FALSE(container->uncompress_block(11, &block));
+
+    char byte = 0;
+    EXPECT_FALSE(container->read(input.size(), 1, &byte));
+    EXPECT_TRUE(container->read(input.size(), 0, &byte));
+    END_TEST();
+}
+
+QUARISMATEST(Compression, block_container_rejects_corrupt_input)
+{
+    size_t const      block_size = block_container::min_block_size;
+    std::string const input      = sample_data(4 * block_size, 13);
+    std::string       packed;
+    ASSERT_TRUE(block_container::compress(
+        input.data(), input.size(), &packed, codec::select(codec_preference::speed), block_size));
+
+    // Truncated header or index
+    EXPECT_FALSE(block_container::open(packed.data(), 23).has_value());
+    EXPECT_FALSE(block_container::open(packed.data(), 24 + 16).has_value());
+    EXPECT_FALSE(block_container::open(packed.data(), packed.size() - 1).has_value());
+
+    // Corrupt index
+    std::string corrupt = packed;
+    corrupt[24] ^= 0x01;
+    EXPECT_FALSE(block_container::open(corrupt.data(), corrupt.size()).has_value());
+
+    // Corrupt block: the container opens, but the block fails its CRC
+    corrupt = packed;
+    corrupt[corrupt.size() - 1] ^= 0x01;
+    auto const container = block_container::open(corrupt.data(), corrupt.size());
+    ASSERT_TRUE(container.has_value());
+    std::string output;
+    EXPECT_TRUE(container->uncompress_block(0, &output));
+    EXPECT_FALSE(container->uncompress_block(3, &output));
+    EXPECT_FALSE(container->uncompress(&output));
+    END_TEST();
+}
+
+QUARISMATEST(Compression, throughput_benchmark)
+{
+    std::string const input = sample_data(16 << 20, 1);
+
+    for (auto type : {codec_type::none, codec_type::snappy, codec_type::lz4, codec_type::zstd})
+    {
+        const codec* c = codec::get(type);
+        if (c == nullptr)
+        {
+            continue;
+        }
+
+        std::string compressed;
+        std::string output;
+        auto const  start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(c->compress(input.data(), input.size(), &compressed));
+        auto const middle = std::chrono::steady_clock::now();
+        ASSERT_TRUE(c->uncompress(compressed.data(), compressed.size(), &output));
+        auto const end = std::chrono::steady_clock::now();
+        EXPECT_EQ(output.size(), input.size());
+
+        double const mib   = static_cast<double>(input.size()) / (1 << 20);
+        double const ratio = static_cast<double>(input.size()) / compressed.size();
+        std::cout << std::setw(8) << c->name() << ": ratio " << std::fixed << std::setprecision(2)
+                  << ratio << ", compress "
+                  << mib / std::chrono::duration<double>(middle - start).count() << " MiB/s"
+                  << ", uncompress " << mib / std::chrono::duration<double>(end - middle).count()
+                  << " MiB/s" << std::endl;
+
+        std::string packed;
+        std::string unpacked;
+        auto const  block_start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(block_container::compress(input.data(), input.size(), &packed, *c));
+        auto const block_middle = std::chrono::steady_clock::now();
+        ASSERT_TRUE(block_container::open(packed.data(), packed.size())->uncompress(&unpacked));
+        auto const block_end = std::chrono::steady_clock::now();
+        EXPECT_EQ(unpacked.size(), input.size());
+
+        std::cout << std::setw(8) << "blocks" << ": ratio "
+                  << static_cast<double>(input.size()) / packed.size() << ", compress "
+                  << mib / std::chrono::duration<double>(block_middle - block_start).count()
+                  << " MiB/s, uncompress "
+                  << mib / std::chrono::duration<double>(block_end - block_middle).count()
+                  << " MiB/s" << std::endl;
+    }
+    END_TEST();
+}
@@ -0,0 +1,166 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "util/concurrent_flat_map.h"
+
+using quarisma::concurrent_flat_map;
+
+using pointer_like_map = concurrent_flat_map<std::uint64_t, int>;
+
+QUARISMATEST(ConcurrentFlatMap, basic_operations)
+{
+    concurrent_flat_map<std::string, int> map(5);
+    EXPECT_EQ(map.shard_count(), 8U);
+    EXPECT_TRUE(map.empty());
+
+    EXPECT_TRUE(map.try_emplace("one", 1));
+    EXPECT_FALSE(map.try_emplace("one", 10));
+    EXPECT_TRUE(map.insert_or_assign("two", 2));
+    EXPECT_FALSE(map.insert_or_assign("two", 20));
+    EXPECT_EQ(map.size(), 2U);
+    EXPECT_TRUE(map.contains("one"));
+    EXPECT_FALSE(map.contains("three"));
+
+    int value = 0;
+    EXPECT_TRUE(map.cvisit("one", [&value](const int& v) { value = v; }));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(map.cvisit("two", [&value](const int& v) { value = v; }));
+    EXPECT_EQ(value, 20);
+    EXPECT_FALSE(map.cvisit("three", [&value](const int& v) { value = v; }));
+
+    EXPECT_TRUE(map.visit("one", [](int& v) { v += 5; }));
+    EXPECT_FALSE(map.emplace_or_visit("one", [](int& v) { v *= 2; }));
+    EXPECT_TRUE(map.emplace_or_visit("three", [](int& v) { v += 1; }, 2));
+    EXPECT_TRUE(map.cvisit("one", [&value](const int& v) { value = v; }));
+    EXPECT_EQ(value, 12);
+    EXPECT_TRUE(map.cvisit("three", [&value](const int& v) { value = v; }));
+    EXPECT_EQ(value, 3);
+
+    int sum = 0;
+    map.cvisit_all([&sum](const std::string&, const int& v) { sum += v; });
+    EXPECT_EQ(sum, 12 + 20 + 3);
+    map.visit_all([](const std::string&, int& v) { v = 0; });
+    sum = 0;
+    map.cvisit_all([&sum](const std::string&, const int& v) { sum += v; });
+    EXPECT_EQ(sum, 0);
+
+    auto const extracted = map.extract("two");
+    ASSERT_TRUE(extracted.has_value());
+    EXPECT_EQ(*extracted, 0);
+    EXPECT_FALSE(map.extract("two").has_value());
+    EXPECT_EQ(map.erase("three"), 1U);
+    EXPECT_EQ(map.erase("three"), 0U);
+    EXPECT_EQ(map.size(), 1U);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+
+    END_TEST();
+}
+
+QUARISMATEST(ConcurrentFlatMap, shard_distribution)
+{
+    pointer_like_map map;
+    EXPECT_EQ(map.shard_count(), pointer_like_map::default_shard_count);
+
+    // Consecutive and aligned keys, like pointers, still reach every shard
+    std::vector<std::size_t> per_shard(map.shard_count());
+    for (std::uint64_t i = 0; i < 64 * 1024; ++i)
+    {
+        ++per_shard[map.shard_index(i * 64)];
+    }
+    for (std::size_t const count : per_shard)
+    {
+        EXPECT_GT(count, 512U);
+        EXPECT_LT(count, 2048U);
+    }
+
+    pointer_like_map single(1);
+    EXPECT_EQ(single.shard_count(), 1U);
+    EXPECT_EQ(single.shard_index(12345), 0U);
+
+    map.reserve(1000);
+    EXPECT_TRUE(map.empty());
+
+    END_TEST();
+}
+
+QUARISMATEST(ConcurrentFlatMap, concurrent_churn)
+{
+    constexpr int      threads_count = 8;
+    constexpr uint64_t keys_per_run  = 2000;
+
+    concurrent_flat_map<std::uint64_t, std::uint64_t> map;
+    std::atomic<std::uint64_t>                       found{0};
+
+    // Each thread inserts, looks up and extracts its own keys, and bumps a
+    // shared counter key, while the others do the same in the same shards.
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count);
+    for (int t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back(
+            [&map, &found, t]
+            {
+                std::uint64_t const base = static_cast<std::uint64_t>(t) << 32;
+                for (std::uint64_t i = 0; i < keys_per_run; ++i)
+                {
+                    map.try_emplace(base + i, i);
+                    map.emplace_or_visit(UINT64_MAX, [](std::uint64_t& v) { ++v; }, 0);
+                }
+                for (std::uint64_t i = 0; i < keys_per_run; ++i)
+                {
+                    map.cvisit(
+                        base + i,
+                        [&found, i](const std::uint64_t& v)
+                        {
+                            if (v == i)
+                            {
+                                found.fetch_add(1, std::memory_order_relaxed);
+                            }
+                        });
+                }
+                for (std::uint64_t i = 0; i < keys_per_run; i += 2)
+                {
+                    map.extract(base + i);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(found.load(), threads_count * keys_per_run);
+    EXPECT_EQ(map.size(), threads_count * keys_per_run / 2 + 1);
+
+    std::uint64_t bumps = 0;
+    EXPECT_TRUE(map.cvisit(UINT64_MAX, [&bumps](const std::uint64_t& v) { bumps = v; }));
+    EXPECT_EQ(bumps, threads_count * keys_per_run);
+
+    END_TEST();
+}
@@ -6,6 +6,7 @@
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <random>
 #include <thread>
 #include <vector>
@@ -13,6 +14,7 @@
 #include "Testing/baseTest.h"
 #include "memory/gpu/allocator_gpu.h"
 #include "memory/gpu/cuda_caching_allocator.h"
+#include "memory/gpu/gpu_resource_tracker.h"
 #include "memory/helper/memory_allocator.h"
 
 #if QUARISMA_HAS_CUDA
@@ -596,3 +598,58 @@ QUARISMATEST(AllocatorCuda, device_id_method)
         EXPECT_EQ(allocator->device_id(), i);
     }
 }
+
+/**
+ * @brief Test managed memory allocation with prefetch and advice
+ */
+QUARISMATEST(AllocatorCuda, managed_memory_prefetch_and_advice)
+{
+    int device_count = get_cuda_device_count();
+    if (device_count == 0)
+    {
+        GTEST_SKIP() << "No CUDA devices available";
+    }
+
+    allocator_gpu::Options options;
+    options.use_managed_memory = true;
+    auto allocator             = create_gpu_allocator(0, options, "Managed-Test");
+    EXPECT_EQ(allocator_memory_enum::UNIFIED, allocator->GetMemoryType());
+
+    const size_t size = 4 << 20;
+    void*        ptr  = allocator->allocate_raw(256, size);
+    ASSERT_NE(ptr, nullptr);
+
+    // Managed memory is directly accessible from the host
+    static_cast<char*>(ptr)[0]        = 1;
+    static_cast<char*>(ptr)[size - 1] = 2;
+
+    auto& tracker = gpu_resource_tracker::instance();
+    tracker.track_allocation(ptr, size, device_enum::CUDA, 0, "managed_test");
+
+    using memory_allocator::managed_memory_advice;
+    EXPECT_TRUE(allocator->advise(ptr, size, managed_memory_advice::SET_READ_MOSTLY, 0));
+    EXPECT_TRUE(allocator->advise(ptr, size, managed_memory_advice::SET_PREFERRED_LOCATION, 0));
+    EXPECT_TRUE(allocator->prefetch(ptr, size, 0));
+    EXPECT_TRUE(allocator->prefetch(
+        static_cast<char*>(ptr) + size / 2, size / 2, memory_allocator::host_device_id));
+#if QUARISMA_HAS_CUDA
+    cudaDeviceSynchronize();
+#endif
+
+    auto info = tracker.get_allocation_info(ptr);
+    ASSERT_NE(nullptr, info);
+    EXPECT_EQ(2u, info->prefetch_count.load());
+    EXPECT_EQ(size + size / 2, info->prefetched_bytes.load());
+    EXPECT_EQ(memory_allocator::host_device_id, info->last_prefetch_device);
+    EXPECT_TRUE(info->read_mostly);
+    EXPECT_EQ(std::optional<int>(0), info->preferred_location);
+
+    tracker.track_deallocation(ptr);
+    allocator->deallocate_raw(ptr);
+
+    // Device allocators do not accept managed memory calls
+    auto device_allocator = create_gpu_allocator(0, "Device-Test");
+    void* device_ptr       = device_allocator->allocate_raw(256, 1024);
+    EXPECT_FALSE(device_allocator->prefetch(device_ptr, 1024, 0));
+    device_allocator->deallocate_raw(device_ptr);
+}
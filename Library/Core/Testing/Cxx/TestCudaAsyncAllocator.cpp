@@ -0,0 +1,146 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "baseTest.h"
+
+#if QUARISMA_HAS_CUDA
+
+#include <cuda_runtime.h>
+
+#include <memory>
+#include <vector>
+
+#include "memory/gpu/cuda_async_allocator.h"
+#include "memory/gpu/gpu_allocator_tracking.h"
+
+using namespace quarisma;
+using namespace quarisma::gpu;
+
+namespace
+{
+
+bool memory_pools_supported()
+{
+    int device_count = 0;
+    int supported    = 0;
+    return cudaGetDeviceCount(&device_count) == cudaSuccess && device_count > 0 &&
+           cudaDeviceGetAttribute(&supported, cudaDevAttrMemoryPoolsSupported, 0) == cudaSuccess &&
+           supported != 0;
+}
+
+}  // namespace
+
+/**
+ * @brief Test stream-ordered allocation and reuse on one stream
+ */
+QUARISMATEST(CudaAsyncAllocator, allocates_on_streams)
+{
+    if (!memory_pools_supported())
+    {
+        return;
+    }
+
+    cudaStream_t stream = nullptr;
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream));
+
+    {
+        cuda_async_allocator allocator(0);
+        EXPECT_EQ(0, allocator.device());
+        EXPECT_NE(nullptr, allocator.memory_pool());
+        EXPECT_EQ(nullptr, allocator.allocate(0, stream));
+
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 16; ++i)
+        {
+            void* ptr = allocator.allocate(size_t{1} << (10 + i % 8), stream);
+            ASSERT_NE(nullptr, ptr);
+            ASSERT_EQ(cudaSuccess, cudaMemsetAsync(ptr, i, 1024, stream));
+            ptrs.push_back(ptr);
+        }
+        for (size_t i = 0; i < ptrs.size(); ++i)
+        {
+            allocator.deallocate(ptrs[i], size_t{1} << (10 + i % 8), stream);
+        }
+        ASSERT_EQ(cudaSuccess, cudaStreamSynchronize(stream));
+
+        auto stats = allocator.stats();
+        EXPECT_EQ(16u, stats.successful_allocations.load());
+        EXPECT_EQ(16u, stats.successful_frees.load());
+
+        // The default threshold keeps the freed memory reserved until trimmed
+        EXPECT_GT(stats.bytes_cached.load(), 0u);
+        allocator.trim(0);
+        EXPECT_EQ(0u, allocator.stats().bytes_cached.load());
+    }
+
+    cudaStreamDestroy(stream);
+}
+
+/**
+ * @brief Test release threshold configuration
+ */
+QUARISMATEST(CudaAsyncAllocator, configures_release_threshold)
+{
+    if (!memory_pools_supported())
+    {
+        return;
+    }
+
+    cuda_async_allocator::Options options;
+    options.release_threshold = 64ULL << 20;
+    cuda_async_allocator allocator(0, options);
+    EXPECT_EQ(64ULL << 20, allocator.release_threshold());
+
+    allocator.set_release_threshold(0);
+    EXPECT_EQ(0u, allocator.release_threshold());
+
+    // The default pool is shared with cudaMallocAsync()
+    cuda_async_allocator::Options shared;
+    shared.use_default_pool = true;
+    cuda_async_allocator default_pool(0, shared);
+    cudaMemPool_t        pool = nullptr;
+    ASSERT_EQ(cudaSuccess, cudaDeviceGetDefaultMemPool(&pool, 0));
+    EXPECT_EQ(pool, default_pool.memory_pool());
+}
+
+/**
+ * @brief Test that gpu_allocator_tracking reports allocations of the pool
+ */
+QUARISMATEST(CudaAsyncAllocator, reports_through_tracking)
+{
+    if (!memory_pools_supported())
+    {
+        return;
+    }
+
+    auto backend = std::make_shared<cuda_async_allocator>(0);
+
+    gpu_allocator_tracking tracker(backend);
+    void*                  ptr = tracker.allocate_raw(8192);
+    ASSERT_NE(nullptr, ptr);
+    tracker.deallocate_raw(ptr, 8192);
+
+    EXPECT_EQ(1u, tracker.GetGPUTimingStats().total_allocations.load());
+    EXPECT_EQ(1u, backend->stats().successful_allocations.load());
+    EXPECT_EQ(1u, backend->stats().successful_frees.load());
+}
+
+#endif  // QUARISMA_HAS_CUDA
@@ -25,6 +25,7 @@
 
 #include <cuda_runtime.h>
 
+#include <new>
 #include <vector>
 
 #include "logging/logger.h"
@@ -187,6 +188,187 @@ QUARISMATEST(CudaCachingAllocator, provides_accurate_statistics)
     QUARISMA_LOG_INFO("CUDA caching allocator statistics test passed");
 }
 
+/**
+ * @brief Test block splitting and reuse within the pool of a stream
+ */
+QUARISMATEST(CudaCachingAllocator, reuses_blocks_on_the_same_stream)
+{
+    cudaStream_t stream1 = nullptr;
+    cudaStream_t stream2 = nullptr;
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream1));
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream2));
+
+    {
+        cuda_caching_allocator allocator(0);
+
+        // Small requests are split from one segment
+        void* ptr1 = allocator.allocate(1000, stream1);
+        void* ptr2 = allocator.allocate(1000, stream1);
+        EXPECT_EQ(static_cast<char*>(ptr1) + 1024, static_cast<char*>(ptr2));
+        EXPECT_EQ(1u, allocator.stats().driver_allocations.load());
+
+        // A block freed on its stream is reused right away
+        allocator.deallocate(ptr1, 1000, stream1);
+        void* ptr3 = allocator.allocate(512, stream1);
+        EXPECT_EQ(ptr1, ptr3);
+        EXPECT_EQ(1u, allocator.stats().driver_allocations.load());
+
+        // Another stream does not share the segment
+        void* ptr4 = allocator.allocate(512, stream2);
+        EXPECT_EQ(2u, allocator.stats().driver_allocations.load());
+
+        // Freed blocks merge back into whole segments, which empty_cache() releases
+        allocator.deallocate(ptr2, 1000, stream1);
+        allocator.deallocate(ptr3, 512, stream1);
+        allocator.deallocate(ptr4, 512, stream2);
+        EXPECT_EQ(2u, allocator.stats().cache_blocks.load());
+        allocator.empty_cache();
+        EXPECT_EQ(0u, allocator.stats().bytes_cached.load());
+        EXPECT_EQ(2u, allocator.stats().driver_frees.load());
+    }
+
+    cudaStreamDestroy(stream1);
+    cudaStreamDestroy(stream2);
+}
+
+/**
+ * @brief Test that a block freed on another stream is reused after its event
+ */
+QUARISMATEST(CudaCachingAllocator, defers_cross_stream_frees)
+{
+    cudaStream_t stream1 = nullptr;
+    cudaStream_t stream2 = nullptr;
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream1));
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream2));
+
+    {
+        cuda_caching_allocator allocator(0);
+
+        void* ptr = allocator.allocate(4096, stream1);
+        allocator.deallocate(ptr, 4096, stream2);
+
+        // Once stream2 has drained, the block is back in the pool of stream1
+        ASSERT_EQ(cudaSuccess, cudaStreamSynchronize(stream2));
+        void* reused = allocator.allocate(4096, stream1);
+        EXPECT_EQ(ptr, reused);
+        allocator.deallocate(reused, 4096, stream1);
+    }
+
+    cudaStreamDestroy(stream1);
+    cudaStreamDestroy(stream2);
+}
+
+/**
+ * @brief Test that a block used by another stream is reused after that stream drains
+ */
+QUARISMATEST(CudaCachingAllocator, defers_frees_of_blocks_recorded_on_other_streams)
+{
+    cudaStream_t stream1 = nullptr;
+    cudaStream_t stream2 = nullptr;
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream1));
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream2));
+
+    {
+        cuda_caching_allocator allocator(0);
+
+        void* ptr = allocator.allocate(4096, stream1);
+        allocator.record_stream(ptr, stream2);
+        // Recording the owner stream changes nothing
+        allocator.record_stream(ptr, stream1);
+        allocator.deallocate(ptr, 4096, stream1);
+
+        ASSERT_EQ(cudaSuccess, cudaStreamSynchronize(stream2));
+        void* reused = allocator.allocate(4096, stream1);
+        EXPECT_EQ(ptr, reused);
+
+        // The recorded streams of a block end with its free
+        allocator.deallocate(reused, 4096, stream1);
+        void* again = allocator.allocate(4096, stream1);
+        EXPECT_EQ(ptr, again);
+        allocator.deallocate(again, 4096, stream1);
+
+        EXPECT_ANY_THROW(allocator.record_stream(ptr, stream2));
+    }
+
+    cudaStreamDestroy(stream1);
+    cudaStreamDestroy(stream2);
+}
+
+/**
+ * @brief Test that instance() returns one allocator per device
+ */
+QUARISMATEST(CudaCachingAllocator, shares_one_instance_per_device)
+{
+    cuda_caching_allocator& allocator = cuda_caching_allocator::instance(0);
+    EXPECT_EQ(&allocator, &cuda_caching_allocator::instance(0));
+    EXPECT_EQ(0, allocator.device());
+    EXPECT_ANY_THROW(cuda_caching_allocator::instance(-1));
+}
+
+/**
+ * @brief Test that graph capture is served from a reserved private pool
+ */
+QUARISMATEST(CudaCachingAllocator, serves_graph_capture_from_private_pool)
+{
+    cudaStream_t stream = nullptr;
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream));
+
+    {
+        cuda_caching_allocator allocator(0);
+
+        // A shared block in use before the capture and freed during it
+        void* before = allocator.allocate(4096, stream);
+
+        auto pool = allocator.create_graph_pool(size_t{4} << 20);
+        EXPECT_EQ(size_t{4} << 20, allocator.graph_pool_bytes(pool));
+        size_t const driver_allocations = allocator.stats().driver_allocations.load();
+
+        allocator.begin_graph_capture(pool, stream);
+        EXPECT_ANY_THROW(allocator.begin_graph_capture(pool, stream));
+        ASSERT_EQ(cudaSuccess, cudaStreamBeginCapture(stream, cudaStreamCaptureModeGlobal));
+
+        void* input  = allocator.allocate(size_t{1} << 20, stream);
+        void* output = allocator.allocate(1000, stream);
+        EXPECT_EQ(cudaSuccess, cudaMemsetAsync(input, 0, size_t{1} << 20, stream));
+
+        // Blocks freed during capture are reused by the capture itself
+        allocator.deallocate(input, size_t{1} << 20, stream);
+        void* scratch = allocator.allocate(size_t{1} << 20, stream);
+        EXPECT_EQ(input, scratch);
+        allocator.deallocate(scratch, size_t{1} << 20, stream);
+        allocator.deallocate(before, 4096, stream);
+
+        // The pool cannot grow while capturing
+        EXPECT_THROW(allocator.allocate(size_t{8} << 20, stream), std::bad_alloc);
+
+        cudaGraph_t graph = nullptr;
+        ASSERT_EQ(cudaSuccess, cudaStreamEndCapture(stream, &graph));
+        allocator.end_graph_capture(stream);
+        EXPECT_EQ(driver_allocations, allocator.stats().driver_allocations.load());
+
+        // The graph's addresses are not handed out to shared allocations
+        void* shared = allocator.allocate(4096, stream);
+        EXPECT_NE(before, shared);
+        auto* const pool_begin = static_cast<char*>(input);
+        auto* const pool_end   = pool_begin + allocator.graph_pool_bytes(pool);
+        auto* const shared_begin = static_cast<char*>(shared);
+        EXPECT_TRUE(shared_begin < pool_begin || shared_begin >= pool_end);
+
+        EXPECT_ANY_THROW(allocator.release_graph_pool(pool + 1));
+        cudaGraphDestroy(graph);
+        allocator.release_graph_pool(pool);
+        EXPECT_ANY_THROW(allocator.graph_pool_bytes(pool));
+
+        // The output outlives the pool as an ordinary block
+        allocator.deallocate(output, 1000, stream);
+        allocator.deallocate(shared, 4096, stream);
+        allocator.empty_cache();
+        EXPECT_EQ(0u, allocator.stats().bytes_cached.load());
+    }
+
+    cudaStreamDestroy(stream);
+}
+
 /**
  * @brief Test move semantics and resource transfer
  */
@@ -0,0 +1,109 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "baseTest.h"
+
+#if QUARISMA_HAS_CUDA
+
+#include <cuda_runtime.h>
+
+#include "logging/logger.h"
+#include "memory/gpu/cuda_pinned_host_allocator.h"
+
+using namespace quarisma;
+using namespace quarisma::gpu;
+
+/**
+ * @brief Test that freed buffers are reused from the cache
+ */
+QUARISMATEST(CudaPinnedHostAllocator, reuses_freed_buffers)
+{
+    cuda_pinned_host_allocator allocator;
+
+    EXPECT_EQ(nullptr, allocator.allocate(0));
+
+    void* ptr = allocator.allocate(1000);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_TRUE(allocator.owns(ptr));
+
+    cudaPointerAttributes attributes{};
+    ASSERT_EQ(cudaSuccess, cudaPointerGetAttributes(&attributes, ptr));
+    EXPECT_EQ(cudaMemoryTypeHost, attributes.type);
+
+    allocator.deallocate(ptr);
+    EXPECT_ANY_THROW(allocator.deallocate(ptr));
+
+    // Same power-of-two size class
+    void* reused = allocator.allocate(1024);
+    EXPECT_EQ(ptr, reused);
+    allocator.deallocate(reused);
+
+    auto stats = allocator.stats();
+    EXPECT_EQ(1U, stats.driver_allocations.load());
+    EXPECT_EQ(1U, stats.cache_hits.load());
+
+    allocator.empty_cache();
+    EXPECT_FALSE(allocator.owns(ptr));
+    EXPECT_EQ(0U, allocator.stats().bytes_cached.load());
+
+    QUARISMA_LOG_INFO("CUDA pinned host allocator reuse test passed");
+}
+
+/**
+ * @brief Test that a buffer used by a stream is reused after that stream drains
+ */
+QUARISMATEST(CudaPinnedHostAllocator, defers_frees_of_buffers_recorded_on_streams)
+{
+    cudaStream_t stream = nullptr;
+    ASSERT_EQ(cudaSuccess, cudaStreamCreate(&stream));
+
+    {
+        cuda_pinned_host_allocator allocator;
+
+        void* host   = allocator.allocate(4096);
+        void* device = nullptr;
+        ASSERT_EQ(cudaSuccess, cudaMalloc(&device, 4096));
+        ASSERT_EQ(
+            cudaSuccess, cudaMemcpyAsync(device, host, 4096, cudaMemcpyHostToDevice, stream));
+        allocator.record_stream(host, stream);
+        allocator.deallocate(host);
+
+        ASSERT_EQ(cudaSuccess, cudaStreamSynchronize(stream));
+        void* reused = allocator.allocate(4096);
+        EXPECT_EQ(host, reused);
+        allocator.deallocate(reused);
+
+        EXPECT_ANY_THROW(allocator.record_stream(host, stream));
+        cudaFree(device);
+    }
+
+    cudaStreamDestroy(stream);
+}
+
+/**
+ * @brief Test that instance() returns the same allocator
+ */
+QUARISMATEST(CudaPinnedHostAllocator, shares_one_instance)
+{
+    EXPECT_EQ(&cuda_pinned_host_allocator::instance(), &cuda_pinned_host_allocator::instance());
+}
+
+#endif  // QUARISMA_HAS_CUDA
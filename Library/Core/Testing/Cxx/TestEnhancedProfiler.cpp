@@ -48,6 +48,7 @@
 #include <iostream>       // for char_traits, basic_ostream, operator<<, endl, cout
 #include <memory>         // for unique_ptr, allocator, _Simple_types
 #include <numeric>        // for accumulate
+#include <sstream>        // for ostringstream
 #include <string>         // for operator+, basic_string, string, to_string, operator<<
 #include <thread>         // for thread, sleep_for
 #include <unordered_map>  // for unordered_map
@@ -1192,8 +1193,147 @@ bool test_high_concurrency()
         return true;
     }
 }
+
+// Two distinct allocation sites for the stack interning test
+QUARISMA_NOINLINE void track_from_first_site(memory_tracker& tracker, void* ptr, size_t size)
+{
+    tracker.track_allocation(ptr, size);
+}
+
+QUARISMA_NOINLINE void track_from_second_site(memory_tracker& tracker, void* ptr, size_t size)
+{
+    tracker.track_allocation(ptr, size);
+}
 }  // namespace
 
+QUARISMATEST(Profiler, memory_tracker_interns_allocation_stacks)
+{
+    memory_tracker tracker;
+    tracker.start_tracking();
+    tracker.set_stack_sampling_interval(1);
+
+    std::vector<void*> first(8);
+    for (auto*& ptr : first)
+    {
+        ptr = std::malloc(1024);
+        track_from_first_site(tracker, ptr, 1024);
+    }
+    void* second = std::malloc(64 * 1024);
+    track_from_second_site(tracker, second, 64 * 1024);
+
+    if (tracker.stack_sampling_interval() == 0)
+    {
+        // No unwinder on this platform
+        for (auto* ptr : first)
+        {
+            std::free(ptr);
+        }
+        std::free(second);
+        GTEST_SKIP() << "Call stacks are unavailable";
+    }
+
+    // Allocations from one call site share a single interned stack
+    auto allocations = tracker.get_active_allocations();
+    ASSERT_EQ(allocations.size(), 9u);
+    for (const auto& allocation : allocations)
+    {
+        EXPECT_NE(allocation.stack_id_, 0u);
+    }
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        tracker.track_deallocation(first[i]);
+    }
+
+    auto sites = tracker.get_allocation_sites(unwind::Mode::dladdr);
+    ASSERT_EQ(sites.size(), 2u);
+
+    // The larger site comes first; the first site keeps its peak after frees
+    EXPECT_EQ(sites[0].allocations_, 1u);
+    EXPECT_EQ(sites[0].bytes_at_peak_, 64u * 1024u);
+    EXPECT_EQ(sites[1].allocations_, 8u);
+    EXPECT_EQ(sites[1].allocated_bytes_, 8u * 1024u);
+    EXPECT_EQ(sites[1].live_bytes_, 4u * 1024u);
+    EXPECT_EQ(sites[1].peak_live_bytes_, 8u * 1024u);
+    EXPECT_NE(sites[0].stack_id_, sites[1].stack_id_);
+
+    auto const stack = tracker.get_stack(sites[1].stack_id_);
+    EXPECT_FALSE(stack.empty());
+    EXPECT_EQ(sites[1].frames_.size(), stack.size());
+    EXPECT_TRUE(tracker.get_stack(0).empty());
+
+    // Unsampled allocations carry no stack
+    tracker.set_stack_sampling_interval(0);
+    void* unsampled = std::malloc(16);
+    tracker.track_allocation(unsampled, 16);
+    for (const auto& allocation : tracker.get_active_allocations())
+    {
+        if (allocation.address_ == unsampled)
+        {
+            EXPECT_EQ(allocation.stack_id_, 0u);
+        }
+    }
+
+    tracker.stop_tracking();
+    for (auto* ptr : first)
+    {
+        std::free(ptr);
+    }
+    std::free(second);
+    std::free(unsampled);
+}
+
+QUARISMATEST(Profiler, memory_tracker_timeline_replays_usage)
+{
+    memory_tracker tracker;
+    tracker.start_tracking();
+    auto const before = std::chrono::high_resolution_clock::now() - std::chrono::seconds(1);
+    tracker.set_timeline_capacity(3000);
+    EXPECT_EQ(tracker.timeline_capacity(), 4096u);
+
+    // The tracker never dereferences the addresses
+    auto address = [](size_t i) { return reinterpret_cast<void*>(0x1000 + i * 16); };
+    size_t const count = 3000;
+    for (size_t i = 0; i < count; ++i)
+    {
+        tracker.track_allocation(address(i), i + 1);
+    }
+    auto const all_live = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        tracker.track_deallocation(address(i));
+    }
+
+    auto const at_peak = tracker.get_usage_at(all_live);
+    ASSERT_TRUE(at_peak.has_value());
+    EXPECT_EQ(at_peak->current_usage_, count * (count + 1) / 2);
+    EXPECT_EQ(at_peak->live_allocations_, count);
+
+    auto const now = tracker.get_usage_at(std::chrono::high_resolution_clock::now());
+    ASSERT_TRUE(now.has_value());
+    EXPECT_EQ(now->current_usage_, 0u);
+    EXPECT_EQ(now->live_allocations_, 0u);
+    EXPECT_FALSE(tracker.get_usage_at(before).has_value());
+
+    // The ring wrapped: the timeline starts at a retained keyframe
+    auto const timeline = tracker.get_timeline();
+    ASSERT_FALSE(timeline.empty());
+    EXPECT_LE(timeline.size(), tracker.timeline_capacity() + 1);
+    EXPECT_EQ(timeline.back().current_usage_, 0u);
+    for (size_t i = 1; i < timeline.size(); ++i)
+    {
+        EXPECT_LE(timeline[i - 1].timestamp_, timeline[i].timestamp_);
+    }
+
+    std::ostringstream json;
+    tracker.write_timeline_chrome_trace(json);
+    EXPECT_NE(json.str().find(R"("ph":"C")"), std::string::npos);
+
+    tracker.set_timeline_capacity(0);
+    EXPECT_FALSE(tracker.get_usage_at(std::chrono::high_resolution_clock::now()).has_value());
+    tracker.stop_tracking();
+}
+
 // Main test function
 QUARISMATEST(Profiler, enhanced_profiler_comprehensive_test)
 {
@@ -0,0 +1,157 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include "Testing/baseTest.h"
+#include "ad/enzyme_diff.h"
+
+#if QUARISMA_HAS_ENZYME
+
+using namespace quarisma;
+
+namespace
+{
+struct call_option
+{
+    double strike;
+};
+
+constexpr std::size_t n_inputs = 4;
+
+double normal_cdf(double x)
+{
+    return 0.5 * std::erfc(-x / std::sqrt(2.0));
+}
+
+double normal_pdf(double x)
+{
+    // 1 / sqrt(2 pi)
+    return 0.3989422804014327 * std::exp(-0.5 * x * x);
+}
+
+// x = {spot, volatility, rate, maturity}
+double black_scholes_call(const double* x, const call_option* option)
+{
+    double const s      = x[0];
+    double const sigma  = x[1];
+    double const r      = x[2];
+    double const t      = x[3];
+    double const sqrt_t = std::sqrt(t);
+    double const d1 =
+        (std::log(s / option->strike) + (r + 0.5 * sigma * sigma) * t) / (sigma * sqrt_t);
+    double const d2 = d1 - sigma * sqrt_t;
+    return s * normal_cdf(d1) - option->strike * std::exp(-r * t) * normal_cdf(d2);
+}
+
+// Delta, vega, rho and the derivative in maturity
+std::array<double, n_inputs> black_scholes_greeks(const double* x, const call_option& option)
+{
+    double const s      = x[0];
+    double const sigma  = x[1];
+    double const r      = x[2];
+    double const t      = x[3];
+    double const sqrt_t = std::sqrt(t);
+    double const d1 =
+        (std::log(s / option.strike) + (r + 0.5 * sigma * sigma) * t) / (sigma * sqrt_t);
+    double const d2       = d1 - sigma * sqrt_t;
+    double const discount = option.strike * std::exp(-r * t);
+    return {
+        normal_cdf(d1),
+        s * normal_pdf(d1) * sqrt_t,
+        t * discount * normal_cdf(d2),
+        s * normal_pdf(d1) * sigma / (2.0 * sqrt_t) + r * discount * normal_cdf(d2)};
+}
+}  // namespace
+
+QUARISMATEST(EnzymeDiff, gradient)
+{
+    call_option const option{100.0};
+    double const      x[n_inputs] = {105.0, 0.25, 0.03, 1.5};
+    auto const        expected    = black_scholes_greeks(x, option);
+
+    double grad[n_inputs] = {-1.0, -1.0, -1.0, -1.0};
+    ad::gradient(&black_scholes_call, x, grad, n_inputs, &option);
+    for (std::size_t i = 0; i < n_inputs; ++i)
+    {
+        EXPECT_NEAR(grad[i], expected[i], 1e-10) << "input " << i;
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(EnzymeDiff, derivative)
+{
+    call_option const option{90.0};
+    double const      x[n_inputs]  = {100.0, 0.2, 0.01, 0.75};
+    double const      dx[n_inputs] = {1.0, 0.0, -2.0, 0.5};
+    auto const        greeks       = black_scholes_greeks(x, option);
+
+    double expected = 0.0;
+    for (std::size_t i = 0; i < n_inputs; ++i)
+    {
+        expected += greeks[i] * dx[i];
+    }
+    EXPECT_NEAR(ad::derivative(&black_scholes_call, x, dx, &option), expected, 1e-10);
+
+    END_TEST();
+}
+
+QUARISMATEST(EnzymeDiff, derivatives)
+{
+    call_option const option{110.0};
+    double const      x[n_inputs] = {100.0, 0.3, 0.02, 2.0};
+    auto const        greeks      = black_scholes_greeks(x, option);
+
+    // Three directions, one after the other
+    double const dx[3 * n_inputs] = {1, 0, 0, 0, 0, 1, 1, 0, 0.5, 0, 0, -1};
+    auto const   d = ad::derivatives<3>(&black_scholes_call, x, dx, n_inputs, &option);
+    for (std::size_t k = 0; k < 3; ++k)
+    {
+        double expected = 0.0;
+        for (std::size_t i = 0; i < n_inputs; ++i)
+        {
+            expected += greeks[i] * dx[k * n_inputs + i];
+        }
+        EXPECT_NEAR(d[k], expected, 1e-10) << "direction " << k;
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(EnzymeDiff, gradient_forward)
+{
+    call_option const option{95.0};
+    double const      x[n_inputs] = {100.0, 0.15, 0.04, 0.5};
+    auto const        expected    = black_scholes_greeks(x, option);
+
+    // A width that does not divide the number of inputs leaves a partial pass
+    double grad[n_inputs] = {};
+    ad::gradient_forward<3>(&black_scholes_call, x, grad, n_inputs, &option);
+    for (std::size_t i = 0; i < n_inputs; ++i)
+    {
+        EXPECT_NEAR(grad[i], expected[i], 1e-10) << "input " << i;
+    }
+
+    END_TEST();
+}
+
+#endif  // QUARISMA_HAS_ENZYME
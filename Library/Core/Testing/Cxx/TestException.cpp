@@ -375,6 +375,10 @@ QUARISMATEST(Exception, constructors_and_accessors)
     ASSERT_FALSE(ex3.backtrace().empty());
     ASSERT_TRUE(ex3.backtrace().find("Exception raised from") != std::string::npos);
 
+    // The frames are symbolized once, then the same string is returned
+    ASSERT_TRUE(ex3.backtrace().find("frame #") != std::string::npos);
+    ASSERT_EQ(&ex3.backtrace(), &ex3.backtrace());
+
     // Test context() accessor
     ASSERT_TRUE(ex3.context().empty());  // No context added yet
 
@@ -452,10 +456,9 @@ QUARISMATEST(Exception, what_methods)
     // Should contain the error message
     ASSERT_TRUE(msg_str.find("Test error message") != std::string::npos);
 
-    // Note: Due to a bug in refresh_what() (line 195 in exception.cpp),
-    // what_without_backtrace_ is currently set with include_backtrace=true
-    // So this test documents the current behavior
-    // The backtrace is currently included in what_without_backtrace_
+    // The backtrace is left out, and what() still has it
+    ASSERT_TRUE(msg_str.find("Exception raised from") == std::string::npos);
+    ASSERT_TRUE(std::string(ex2.what()).find("Exception raised from") != std::string::npos);
 
     // Test what_without_backtrace with context
     quarisma::source_location loc3{__func__, __FILE__, __LINE__};
@@ -18,10 +18,19 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "util/flat_hash.h"
+#include "util/swiss_table.h"
 #include "baseTest.h"
 
 using namespace quarisma;
@@ -1003,3 +1012,318 @@ QUARISMATEST(FlatHash, power_of_two_hash_policy_comprehensive)
 
     END_TEST();
 }
+
+// ============================================================================
+// Consolidated Test 8: Swiss Table Map and Set
+// ============================================================================
+// Tests: same API as flat_hash_map/flat_hash_set, growth, tombstone reuse,
+//        randomized churn against std::unordered_map, identity pointer hashes
+QUARISMATEST(FlatHash, swiss_table_comprehensive)
+{
+    // ===== MAP BASIC OPERATIONS =====
+    swiss_hash_map<int, std::string> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.begin() == map.end());
+    EXPECT_TRUE(map.find(1) == map.end());
+    EXPECT_EQ(map.erase(1), 0U);
+
+    map[1] = "one";
+    map[2] = "two";
+    map.emplace(3, "three");
+    map.insert({4, "four"});
+    EXPECT_EQ(map.size(), 4U);
+    EXPECT_EQ(map.at(3), "three");
+    EXPECT_TRUE(map.contains(4));
+    EXPECT_EQ(map.count(5), 0U);
+    EXPECT_ANY_THROW(map.at(5));
+
+    EXPECT_FALSE(map.emplace(1, "uno").second);
+    EXPECT_EQ(map[1], "one");
+    EXPECT_FALSE(map.insert_or_assign(1, "uno").second);
+    EXPECT_EQ(map[1], "uno");
+    EXPECT_TRUE(map.try_emplace(5, 3, 'x').second);
+    EXPECT_EQ(map[5], "xxx");
+
+    EXPECT_EQ(map.erase(2), 1U);
+    EXPECT_FALSE(map.contains(2));
+    EXPECT_EQ(map.size(), 4U);
+
+    // erase(iterator) returns the next element, so a filtering loop works
+    for (auto it = map.begin(); it != map.end();)
+    {
+        it = it->first % 2 == 1 ? map.erase(it) : std::next(it);
+    }
+    EXPECT_EQ(map.size(), 1U);
+    EXPECT_TRUE(map.contains(4));
+
+    // ===== COPY, MOVE, COMPARISON =====
+    swiss_hash_map<int, std::string> copy(map);
+    EXPECT_TRUE(copy == map);
+    copy[7] = "seven";
+    EXPECT_TRUE(copy != map);
+    swiss_hash_map<int, std::string> moved(std::move(copy));
+    EXPECT_EQ(moved.size(), 2U);
+    map = moved;
+    EXPECT_TRUE(map == moved);
+    moved.clear();
+    EXPECT_TRUE(moved.empty());
+    EXPECT_TRUE(moved.begin() == moved.end());
+    map.swap(moved);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(moved.size(), 2U);
+
+    // ===== MOVE ASSIGNMENT =====
+    // Onto a populated map: its own storage is released exactly once
+    swiss_hash_map<int, std::string> target;
+    target[1] = "one";
+    target[2] = "two";
+    swiss_hash_map<int, std::string> source(target);
+    source[3] = "three";
+    target    = std::move(source);
+    EXPECT_EQ(target.size(), 3U);
+    EXPECT_EQ(target.at(3), "three");
+
+    // Onto the moved-from map, which stays usable afterwards
+    source = std::move(target);
+    EXPECT_EQ(source.size(), 3U);
+    target[4] = "four";
+    source    = std::move(target);
+    EXPECT_EQ(source.size(), 1U);
+    EXPECT_EQ(source.at(4), "four");
+
+    // Onto itself
+    auto& alias = source;
+    source      = std::move(alias);
+    EXPECT_EQ(source.size(), 1U);
+
+    // ===== GROWTH AND RESERVE =====
+    swiss_hash_map<uint64_t, uint64_t> big;
+    big.reserve(1000);
+    uint64_t const reserved = big.bucket_count();
+    EXPECT_GE(reserved, 1000U);
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        big[i] = i * i;
+    }
+    EXPECT_EQ(big.bucket_count(), reserved);
+    EXPECT_LE(big.load_factor(), big.max_load_factor());
+    for (uint64_t i = 0; i < 100000; ++i)
+    {
+        big[i] = i * i;
+    }
+    EXPECT_EQ(big.size(), 100000U);
+    uint64_t sum = 0;
+    for (const auto& [key, value] : big)
+    {
+        EXPECT_EQ(value, key * key);
+        sum += key;
+    }
+    EXPECT_EQ(sum, 99999ULL * 100000ULL / 2);
+
+    // Insert/erase churn at constant size reuses tombstones instead of growing
+    uint64_t const buckets = big.bucket_count();
+    for (uint64_t i = 0; i < 500000; ++i)
+    {
+        big.erase(i);
+        big[i + 100000] = 0;
+    }
+    EXPECT_EQ(big.size(), 100000U);
+    EXPECT_EQ(big.bucket_count(), buckets);
+
+    big.clear();
+    big.shrink_to_fit();
+    EXPECT_EQ(big.bucket_count(), 0U);
+
+    // ===== RANDOMIZED CHURN AGAINST std::unordered_map =====
+    std::mt19937_64                         rng(42);
+    swiss_hash_map<uint64_t, int>           swiss;
+    std::unordered_map<uint64_t, int>       reference;
+    std::uniform_int_distribution<uint64_t> keys(0, 5000);
+    for (int step = 0; step < 200000; ++step)
+    {
+        uint64_t const key = keys(rng);
+        switch (rng() % 3)
+        {
+        case 0:
+            swiss[key]     = step;
+            reference[key] = step;
+            break;
+        case 1:
+            EXPECT_EQ(swiss.erase(key), reference.erase(key));
+            break;
+        default:
+            EXPECT_EQ(swiss.contains(key), reference.count(key) == 1);
+            break;
+        }
+    }
+    EXPECT_EQ(swiss.size(), reference.size());
+    for (const auto& [key, value] : reference)
+    {
+        auto found = swiss.find(key);
+        ASSERT_TRUE(found != swiss.end());
+        EXPECT_EQ(found->second, value);
+    }
+
+    // ===== IDENTITY HASH OF ALIGNED POINTERS =====
+    struct identity_hash
+    {
+        size_t operator()(const void* ptr) const noexcept
+        {
+            return reinterpret_cast<uintptr_t>(ptr);
+        }
+    };
+    std::vector<std::unique_ptr<std::array<char, 64>>> blocks;
+    swiss_hash_map<const void*, size_t, identity_hash> owners;
+    for (size_t i = 0; i < 4096; ++i)
+    {
+        blocks.push_back(std::make_unique<std::array<char, 64>>());
+        owners[blocks.back().get()] = i;
+    }
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        EXPECT_EQ(owners.at(blocks[i].get()), i);
+    }
+
+    // ===== SET =====
+    swiss_hash_set<std::string> set{"a", "b", "c"};
+    EXPECT_EQ(set.size(), 3U);
+    EXPECT_FALSE(set.emplace("a").second);
+    EXPECT_TRUE(set.emplace(3, 'd').second);
+    EXPECT_TRUE(set.contains("ddd"));
+    EXPECT_EQ(set.erase("b"), 1U);
+    swiss_hash_set<std::string> other(set.begin(), set.end());
+    EXPECT_TRUE(other == set);
+    other.insert("e");
+    EXPECT_TRUE(other != set);
+
+    END_TEST();
+}
+
+// ============================================================================
+// Consolidated Test 9: Comparative Benchmarks
+// ============================================================================
+// Times flat_hash_map, swiss_hash_map and std::unordered_map on the same
+// workloads and prints a table; only the results are checked, not the timings.
+namespace
+{
+template <typename Map>
+struct hash_benchmark
+{
+    double   insert_ns  = 0.0;
+    double   hit_ns     = 0.0;
+    double   miss_ns    = 0.0;
+    double   erase_ns   = 0.0;
+    double   iterate_ns = 0.0;
+    uint64_t checksum   = 0;
+
+    hash_benchmark(const std::vector<uint64_t>& present, const std::vector<uint64_t>& absent)
+    {
+        using clock = std::chrono::steady_clock;
+        auto per_op = [](clock::time_point start, size_t ops)
+        {
+            return static_cast<double>(
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start)
+                           .count()) /
+                   static_cast<double>(ops);
+        };
+
+        Map  map;
+        auto start = clock::now();
+        for (uint64_t key : present)
+        {
+            map[key] = key;
+        }
+        insert_ns = per_op(start, present.size());
+
+        start = clock::now();
+        for (uint64_t key : present)
+        {
+            checksum += map.find(key)->second;
+        }
+        hit_ns = per_op(start, present.size());
+
+        start = clock::now();
+        for (uint64_t key : absent)
+        {
+            checksum += map.count(key);
+        }
+        miss_ns = per_op(start, absent.size());
+
+        constexpr int rounds = 10;
+        start                = clock::now();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (const auto& entry : map)
+            {
+                checksum += entry.second;
+            }
+        }
+        iterate_ns = per_op(start, rounds * map.size());
+
+        start = clock::now();
+        for (size_t i = 0; i < present.size(); i += 2)
+        {
+            checksum += map.erase(present[i]);
+        }
+        erase_ns = per_op(start, present.size() / 2);
+    }
+};
+
+void print_benchmark_row(
+    const char* name, double insert, double hit, double miss, double erase, double iterate)
+{
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << insert << std::setw(10) << hit
+              << std::setw(10) << miss << std::setw(10) << erase << std::setw(12) << iterate
+              << "\n";
+}
+}  // namespace
+
+QUARISMATEST(FlatHash, swiss_table_comparative_benchmark)
+{
+    constexpr size_t count = 1 << 18;
+
+    std::mt19937_64       rng(7);
+    std::vector<uint64_t> present(count);
+    std::vector<uint64_t> absent(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        present[i] = rng() | 1;      // odd keys are stored
+        absent[i]  = rng() & ~1ULL;  // even keys are never stored
+    }
+
+    hash_benchmark<flat_hash_map<uint64_t, uint64_t>>      robin_hood(present, absent);
+    hash_benchmark<swiss_hash_map<uint64_t, uint64_t>>     swiss(present, absent);
+    hash_benchmark<std::unordered_map<uint64_t, uint64_t>> standard(present, absent);
+
+    EXPECT_EQ(robin_hood.checksum, swiss.checksum);
+    EXPECT_EQ(swiss.checksum, standard.checksum);
+
+    std::cout << "\n=== Hash Map Benchmark (" << count << " uint64_t keys, ns/op) ===\n";
+    std::cout << std::left << std::setw(22) << "Container" << std::right << std::setw(10)
+              << "insert" << std::setw(10) << "hit" << std::setw(10) << "miss" << std::setw(10)
+              << "erase" << std::setw(12) << "iterate" << "\n";
+    print_benchmark_row(
+        "flat_hash_map",
+        robin_hood.insert_ns,
+        robin_hood.hit_ns,
+        robin_hood.miss_ns,
+        robin_hood.erase_ns,
+        robin_hood.iterate_ns);
+    print_benchmark_row(
+        "swiss_hash_map",
+        swiss.insert_ns,
+        swiss.hit_ns,
+        swiss.miss_ns,
+        swiss.erase_ns,
+        swiss.iterate_ns);
+    print_benchmark_row(
+        "std::unordered_map",
+        standard.insert_ns,
+        standard.hit_ns,
+        standard.miss_ns,
+        standard.erase_ns,
+        standard.iterate_ns);
+
+    END_TEST();
+}
@@ -190,6 +190,31 @@ QUARISMATEST(GpuAllocatorFactory, creates_caching_allocators)
     }
 }
 
+/**
+ * @brief Test stream-ordered pool allocator creation
+ */
+QUARISMATEST(GpuAllocatorFactory, creates_async_pool_allocators)
+{
+    auto config = gpu_allocator_config::create_default(gpu_allocation_strategy::ASYNC_POOL, 0);
+    EXPECT_EQ("AsyncPool", gpu_allocator_factory::strategy_name(config.strategy));
+
+    if (!gpu_allocator_factory::validate_device_support(
+            gpu_allocation_strategy::ASYNC_POOL, device_enum::CUDA, 0))
+    {
+        // No device, or one without memory pool support
+        EXPECT_ANY_THROW(gpu_allocator_factory::create_async_allocator(config));
+        return;
+    }
+
+    auto allocator = gpu_allocator_factory::create_async_allocator(config);
+    EXPECT_EQ(config.async_pool.release_threshold, allocator->release_threshold());
+
+    void* ptr = allocator->allocate(4096);
+    EXPECT_NE(nullptr, ptr);
+    allocator->deallocate(ptr, 4096);
+    EXPECT_EQ(1u, allocator->stats().successful_frees.load());
+}
+
 /**
  * @brief Test factory error handling
  */
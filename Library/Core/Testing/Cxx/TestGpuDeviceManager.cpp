@@ -128,6 +128,44 @@ QUARISMATEST(GpuDeviceManager, enumerates_available_devices)
     QUARISMA_LOG_INFO("GPU device manager device enumeration test passed");
 }
 
+/**
+ * @brief Test peer-to-peer topology reporting
+ */
+QUARISMATEST(GpuDeviceManager, reports_peer_topology)
+{
+    auto& manager = gpu_device_manager::instance();
+    manager.initialize();
+
+    auto devices = manager.get_available_devices();
+    for (const auto& device : devices)
+    {
+        // Every other device is listed once, and a device is not its own peer
+        EXPECT_EQ(device.peers.size(), devices.size() - 1);
+        EXPECT_EQ(
+            manager.get_interconnect(device.device_index, device.device_index),
+            gpu_interconnect::NONE);
+        EXPECT_FALSE(manager.enable_peer_access(device.device_index, device.device_index));
+
+        for (const auto& peer : device.peers)
+        {
+            EXPECT_NE(peer.device_index, device.device_index);
+            EXPECT_EQ(manager.get_interconnect(device.device_index, peer.device_index), peer.link);
+            EXPECT_EQ(peer.access_supported, peer.link != gpu_interconnect::NONE);
+
+            // Enabling is remembered, so repeated calls agree
+            bool const enabled = manager.enable_peer_access(device.device_index, peer.device_index);
+            EXPECT_EQ(enabled, peer.access_supported);
+            EXPECT_EQ(
+                manager.enable_peer_access(device.device_index, peer.device_index), enabled);
+        }
+    }
+
+    EXPECT_EQ(manager.get_interconnect(-1, 0), gpu_interconnect::NONE);
+    EXPECT_FALSE(manager.enable_peer_access(-1, 0));
+
+    QUARISMA_LOG_INFO("GPU device manager peer topology test passed");
+}
+
 /**
  * @brief Test device information retrieval for specific devices
  */
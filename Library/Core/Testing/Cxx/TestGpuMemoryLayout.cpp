@@ -0,0 +1,218 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "baseTest.h"
+
+#if QUARISMA_HAS_CUDA
+
+#include <cuda_runtime.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "logging/logger.h"
+#include "memory/gpu/gpu_memory_layout.h"
+
+using namespace quarisma;
+using namespace quarisma::gpu;
+
+namespace
+{
+
+struct quote
+{
+    double  bid;
+    double  ask;
+    int32_t size;
+    char    venue;
+    char    flags[3];
+    int16_t level;
+    char    symbol[12];
+};
+
+record_layout quote_layout()
+{
+    record_layout layout(sizeof(quote));
+    layout.add_field(QUARISMA_RECORD_FIELD(quote, bid))
+        .add_field(QUARISMA_RECORD_FIELD(quote, ask))
+        .add_field(QUARISMA_RECORD_FIELD(quote, size))
+        .add_field(QUARISMA_RECORD_FIELD(quote, venue))
+        .add_field(QUARISMA_RECORD_FIELD(quote, level))
+        .add_field(QUARISMA_RECORD_FIELD(quote, symbol));
+    return layout;
+}
+
+std::vector<quote> make_quotes(size_t count)
+{
+    // Zeroed, so that the padding the layouts do not carry compares equal
+    std::vector<quote> quotes(count);
+    std::memset(quotes.data(), 0, count * sizeof(quote));
+    for (size_t i = 0; i < count; ++i)
+    {
+        quotes[i].bid   = 100.0 + static_cast<double>(i);
+        quotes[i].ask   = 100.5 + static_cast<double>(i);
+        quotes[i].size  = static_cast<int32_t>(i * 7);
+        quotes[i].venue = static_cast<char>('A' + i % 26);
+        quotes[i].level = static_cast<int16_t>(i % 10);
+        std::memset(quotes[i].symbol, static_cast<int>('a' + i % 26), sizeof(quotes[i].symbol));
+    }
+    return quotes;
+}
+
+std::vector<quote> zeroed_quotes(size_t count)
+{
+    std::vector<quote> quotes(count);
+    std::memset(quotes.data(), 0, count * sizeof(quote));
+    return quotes;
+}
+
+}  // namespace
+
+/**
+ * @brief Test the record description and its errors
+ */
+QUARISMATEST(GpuMemoryLayout, describes_record_fields)
+{
+    record_layout const layout = quote_layout();
+    EXPECT_EQ(layout.fields().size(), 6u);
+    EXPECT_EQ(layout.field_index("level"), 4u);
+    EXPECT_EQ(layout.fields()[5].size, 12u);
+
+    record_layout overlapping(sizeof(quote));
+    overlapping.add_field(QUARISMA_RECORD_FIELD(quote, bid));
+    EXPECT_ANY_THROW(overlapping.add_field("half", 4, 8));
+    EXPECT_ANY_THROW(overlapping.add_field("outside", sizeof(quote) - 2, 4));
+    EXPECT_ANY_THROW(layout.field_index("missing"));
+
+    QUARISMA_LOG_INFO("GPU memory layout record description test passed");
+}
+
+/**
+ * @brief Test the planned offsets: aligned SoA columns and AoSoA tiles
+ */
+QUARISMATEST(GpuMemoryLayout, plans_aligned_columns_and_tiles)
+{
+    record_layout const layout = quote_layout();
+
+    auto const soa = layout_plan::make(layout, record_layout_kind::SOA, 1000);
+    for (size_t start : soa.field_starts)
+    {
+        EXPECT_EQ(start % alignment::CUDA_TEXTURE_ALIGNMENT, 0u);
+    }
+    EXPECT_EQ(soa.offset(1, 10), soa.field_starts[1] + 10 * sizeof(double));
+
+    auto const aosoa = layout_plan::make(layout, record_layout_kind::AOSOA, 1000, 32);
+    EXPECT_EQ(aosoa.tile_bytes % alignment::CUDA_COALESCING_BOUNDARY, 0u);
+    EXPECT_EQ(aosoa.bytes, 32 * aosoa.tile_bytes);  // 1000 records fill 32 tiles
+    EXPECT_EQ(aosoa.offset(2, 33), aosoa.tile_bytes + aosoa.field_starts[2] + sizeof(int32_t));
+
+    QUARISMA_LOG_INFO("GPU memory layout planning test passed");
+}
+
+/**
+ * @brief Test that packing then unpacking on the host restores the records
+ */
+QUARISMATEST(GpuMemoryLayout, round_trips_on_host)
+{
+    record_layout const layout = quote_layout();
+    for (auto kind : {record_layout_kind::AOS, record_layout_kind::SOA, record_layout_kind::AOSOA})
+    {
+        for (size_t count : {size_t{1}, size_t{31}, size_t{33}, size_t{5000}})
+        {
+            auto const plan   = layout_plan::make(layout, kind, count, 32);
+            auto const quotes = make_quotes(count);
+            auto       back   = zeroed_quotes(count);
+
+            std::vector<uint8_t> buffer(plan.bytes);
+            pack_records(quotes.data(), plan, buffer.data());
+
+            int32_t size = 0;
+            std::memcpy(&size, buffer.data() + plan.offset(2, count - 1), sizeof(size));
+            EXPECT_EQ(size, quotes[count - 1].size);
+
+            unpack_records(buffer.data(), plan, back.data());
+            EXPECT_EQ(std::memcmp(quotes.data(), back.data(), count * sizeof(quote)), 0);
+        }
+    }
+
+    QUARISMA_LOG_INFO("GPU memory layout host round trip test passed");
+}
+
+/**
+ * @brief Test staged uploads and downloads, and the on-device transpose
+ */
+QUARISMATEST(GpuMemoryLayout, round_trips_through_device)
+{
+    try
+    {
+        size_t const        count  = 100003;  // Several staging chunks and a partial tile
+        record_layout const layout = quote_layout();
+        auto const          quotes = make_quotes(count);
+
+        void* device_records = nullptr;
+        if (cudaMalloc(&device_records, count * sizeof(quote)) == cudaSuccess)
+        {
+            cudaMemcpy(
+                device_records, quotes.data(), count * sizeof(quote), cudaMemcpyHostToDevice);
+
+            for (auto kind : {record_layout_kind::SOA, record_layout_kind::AOSOA})
+            {
+                auto const plan = layout_plan::make(layout, kind, count);
+
+                void* uploaded   = nullptr;
+                void* transposed = nullptr;
+                cudaMalloc(&uploaded, plan.bytes);
+                cudaMalloc(&transposed, plan.bytes);
+                cudaMemset(uploaded, 0, plan.bytes);
+                cudaMemset(transposed, 0, plan.bytes);
+
+                upload_records(quotes.data(), plan, uploaded);
+                transpose_records_on_device(device_records, plan, transposed);
+
+                auto back = zeroed_quotes(count);
+                download_records(uploaded, plan, back.data());
+                EXPECT_EQ(std::memcmp(quotes.data(), back.data(), count * sizeof(quote)), 0);
+
+                back = zeroed_quotes(count);
+                download_records(transposed, plan, back.data());
+                EXPECT_EQ(std::memcmp(quotes.data(), back.data(), count * sizeof(quote)), 0);
+
+                cudaFree(transposed);
+                cudaFree(uploaded);
+            }
+
+            cudaFree(device_records);
+            QUARISMA_LOG_INFO("GPU memory layout device round trip test passed");
+        }
+        else
+        {
+            QUARISMA_LOG_INFO("GPU memory layout device round trip test skipped (no GPU)");
+        }
+    }
+    catch (const std::exception& e)
+    {
+        QUARISMA_LOG_INFO(
+            "GPU memory layout device round trip test failed (expected if no GPU): {}", e.what());
+    }
+}
+
+#endif  // QUARISMA_HAS_CUDA
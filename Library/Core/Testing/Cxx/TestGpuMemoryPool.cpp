@@ -44,7 +44,7 @@ QUARISMATEST(GpuMemoryPool, validates_configuration_parameters)
     EXPECT_GT(default_config.max_block_size, default_config.min_block_size);
     EXPECT_GT(default_config.block_growth_factor, 1.0);
     EXPECT_GT(default_config.max_pool_size, 0);
-    EXPECT_GT(default_config.max_cached_blocks, 0);
+    EXPECT_GT(default_config.max_cached_bytes, 0);
     EXPECT_GT(default_config.alignment_boundary, 0);
     EXPECT_TRUE(default_config.enable_alignment);
     EXPECT_TRUE(default_config.enable_tracking);
@@ -55,7 +55,7 @@ QUARISMATEST(GpuMemoryPool, validates_configuration_parameters)
     custom_config.max_block_size      = 32 * 1024ULL;
     custom_config.block_growth_factor = 1.5;
     custom_config.max_pool_size       = 128 * 1024ULL;
-    custom_config.max_cached_blocks   = 8;
+    custom_config.max_cached_bytes    = 8 * 1024ULL;
     custom_config.alignment_boundary  = 512;
     custom_config.enable_alignment    = true;
     custom_config.enable_tracking     = true;
@@ -79,7 +79,7 @@ QUARISMATEST(GpuMemoryPool, creates_pool_successfully)
     config.max_block_size      = 16 * 1024ULL;
     config.block_growth_factor = 2.0;
     config.max_pool_size       = 256 * 1024ULL;
-    config.max_cached_blocks   = 8;
+    config.max_cached_bytes    = 64 * 1024ULL;
     config.enable_alignment    = true;
     config.alignment_boundary  = 256;
     config.enable_tracking     = true;
@@ -179,7 +179,7 @@ QUARISMATEST(GpuMemoryPool, handles_multiple_allocations)
     gpu_memory_pool_config config;
     config.min_block_size    = 512;
     config.max_block_size    = 4 * 1024ULL;
-    config.max_cached_blocks = 16;
+    config.max_cached_bytes  = 64 * 1024ULL;
 
     auto pool = gpu_memory_pool::create(config);
     EXPECT_NE(nullptr, pool.get());
@@ -270,7 +270,7 @@ QUARISMATEST(GpuMemoryPool, manages_cache_effectively)
 {
     gpu_memory_pool_config config;
     config.min_block_size    = 1024;
-    config.max_cached_blocks = 4;
+    config.max_cached_bytes  = 16 * 1024ULL;
     config.enable_tracking   = true;
 
     auto pool = gpu_memory_pool::create(config);
@@ -305,6 +305,96 @@ QUARISMATEST(GpuMemoryPool, manages_cache_effectively)
     }
 }
 
+/**
+ * @brief Test that large requests are rounded to size classes and reused
+ */
+QUARISMATEST(GpuMemoryPool, caches_large_blocks_by_size_class)
+{
+    gpu_memory_pool_config config;
+    auto                   pool = gpu_memory_pool::create(config);
+
+    try
+    {
+        size_t const request = 300ULL * 1024ULL * 1024ULL;
+        auto         first   = pool->allocate(request, device_enum::CUDA, 0);
+        if (first.ptr != nullptr)
+        {
+            EXPECT_GE(first.size, request);
+            EXPECT_LE(first.size, request + request / 4 + config.alignment_boundary);
+            void* const ptr = first.ptr;
+            pool->deallocate(first);
+
+            // A slightly different size in the same class reuses the block
+            auto second = pool->allocate(request - 4096, device_enum::CUDA, 0);
+            EXPECT_EQ(ptr, second.ptr);
+            pool->deallocate(second);
+
+            auto stats = pool->get_statistics();
+            EXPECT_EQ(1, stats.cache_hits);
+            EXPECT_EQ(1, stats.cache_misses);
+            ASSERT_EQ(1, stats.bins.size());
+            EXPECT_EQ(first.size, stats.bins[0].block_size);
+            EXPECT_EQ(1, stats.bins[0].cache_hits);
+            EXPECT_EQ(1, stats.bins[0].cached_blocks);
+            EXPECT_EQ(first.size, stats.cached_memory);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        QUARISMA_LOG_INFO(
+            "GPU memory pool size class test failed (expected if no GPU): {}", e.what());
+    }
+}
+
+/**
+ * @brief Test that the cache stays within its byte budget
+ */
+QUARISMATEST(GpuMemoryPool, keeps_cache_within_byte_budget)
+{
+    gpu_memory_pool_config config;
+    config.min_block_size      = 1024ULL * 1024ULL;
+    config.max_block_size      = 8ULL * 1024ULL * 1024ULL;
+    config.block_growth_factor = 2.0;
+    config.max_cached_bytes    = 3ULL * 1024ULL * 1024ULL;
+
+    auto pool = gpu_memory_pool::create(config);
+
+    try
+    {
+        std::vector<gpu_memory_block> blocks;
+        for (int i = 0; i < 5; ++i)
+        {
+            blocks.push_back(pool->allocate(1024ULL * 1024ULL, device_enum::CUDA, 0));
+        }
+        if (blocks.front().ptr != nullptr)
+        {
+            for (const auto& block : blocks)
+            {
+                pool->deallocate(block);
+            }
+
+            auto stats = pool->get_statistics();
+            EXPECT_EQ(3ULL * 1024ULL * 1024ULL, stats.cached_memory);
+            ASSERT_EQ(1, stats.bins.size());
+            EXPECT_EQ(3, stats.bins[0].cached_blocks);
+            EXPECT_EQ(2, stats.bins[0].evictions);
+
+            // Requests above the largest size class are never cached
+            auto large = pool->allocate(16ULL * 1024ULL * 1024ULL, device_enum::CUDA, 0);
+            pool->deallocate(large);
+            stats = pool->get_statistics();
+            EXPECT_EQ(1, stats.uncached_allocations);
+            EXPECT_EQ(3ULL * 1024ULL * 1024ULL, stats.cached_memory);
+            EXPECT_EQ(0, pool->get_allocated_bytes());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        QUARISMA_LOG_INFO(
+            "GPU memory pool cache budget test failed (expected if no GPU): {}", e.what());
+    }
+}
+
 /**
  * @brief Test memory pool with different device types
  */
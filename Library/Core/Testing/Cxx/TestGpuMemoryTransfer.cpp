@@ -23,6 +23,9 @@
 
 #if QUARISMA_HAS_CUDA
 
+#include <cuda_runtime.h>
+
+#include <cstring>
 #include <future>
 #include <memory>
 #include <vector>
@@ -322,6 +325,116 @@ QUARISMATEST(GpuMemoryTransfer, performs_asynchronous_transfers)
     }
 }
 
+/**
+ * @brief Test that pageable host transfers are staged through pinned buffers
+ */
+QUARISMATEST(GpuMemoryTransfer, stages_pageable_transfers)
+{
+    auto& transfer_manager = gpu_memory_transfer::instance();
+
+    void* device_data = nullptr;
+    if (cudaMalloc(&device_data, 1 << 20) != cudaSuccess)
+    {
+        QUARISMA_LOG_INFO("GPU memory transfer staging test skipped (no GPU)");
+        return;
+    }
+
+    // Small buffers so that the transfer spans several chunks and a partial one
+    transfer_manager.configure_staging_buffers(64 * 1024, 3);
+
+    size_t const               size = (1 << 20) - 1000;
+    std::vector<unsigned char> host_data(size);
+    std::vector<unsigned char> result_data(size, 0);
+    for (size_t i = 0; i < size; ++i)
+    {
+        host_data[i] = static_cast<unsigned char>(i * 7 + 3);
+    }
+
+    auto upload = transfer_manager.transfer_sync(
+        host_data.data(), device_data, size, transfer_direction::HOST_TO_DEVICE);
+    EXPECT_EQ(transfer_status::COMPLETED, upload.status);
+    EXPECT_TRUE(upload.staged);
+
+    auto download = transfer_manager.transfer_sync(
+        device_data, result_data.data(), size, transfer_direction::DEVICE_TO_HOST);
+    EXPECT_EQ(transfer_status::COMPLETED, download.status);
+    EXPECT_TRUE(download.staged);
+    EXPECT_EQ(host_data, result_data);
+
+    // Transfers that fit in one buffer are issued directly
+    auto small = transfer_manager.transfer_sync(
+        host_data.data(), device_data, 1024, transfer_direction::HOST_TO_DEVICE);
+    EXPECT_EQ(transfer_status::COMPLETED, small.status);
+    EXPECT_FALSE(small.staged);
+
+    EXPECT_ANY_THROW(transfer_manager.configure_staging_buffers(64 * 1024, 1));
+    transfer_manager.configure_staging_buffers(4 * 1024 * 1024, 2);
+    cudaFree(device_data);
+}
+
+/**
+ * @brief Test copies between the memories of two devices
+ */
+QUARISMATEST(GpuMemoryTransfer, performs_peer_transfers)
+{
+    auto& transfer_manager = gpu_memory_transfer::instance();
+
+    int device_count = 0;
+    if (cudaGetDeviceCount(&device_count) != cudaSuccess || device_count < 2)
+    {
+        QUARISMA_LOG_INFO("GPU peer transfer test skipped (fewer than two GPUs)");
+        return;
+    }
+
+    size_t const size        = 1 << 20;
+    void*        source_data = nullptr;
+    void*        peer_data   = nullptr;
+    void*        local_data  = nullptr;
+    int          previous    = 0;
+    cudaGetDevice(&previous);
+    cudaSetDevice(0);
+    ASSERT_EQ(cudaSuccess, cudaMalloc(&source_data, size));
+    ASSERT_EQ(cudaSuccess, cudaMalloc(&local_data, size));
+    cudaSetDevice(1);
+    ASSERT_EQ(cudaSuccess, cudaMalloc(&peer_data, size));
+    cudaSetDevice(previous);
+
+    std::vector<unsigned char> host_data(size);
+    std::vector<unsigned char> result_data(size, 0);
+    for (size_t i = 0; i < size; ++i)
+    {
+        host_data[i] = static_cast<unsigned char>(i * 13 + 5);
+    }
+    transfer_manager.transfer_sync(
+        host_data.data(), source_data, size, transfer_direction::HOST_TO_DEVICE);
+
+    // Direct over NVLink or PCIe when the pair supports it, else relayed through the host
+    auto info = transfer_manager.transfer_peer_sync(source_data, 0, peer_data, 1, size);
+    EXPECT_EQ(transfer_status::COMPLETED, info.status);
+    EXPECT_NE(info.peer_to_peer, info.staged);
+    EXPECT_EQ(1, info.destination_device.index());
+
+    transfer_manager.transfer_sync(
+        peer_data, result_data.data(), size, transfer_direction::DEVICE_TO_HOST);
+    EXPECT_EQ(host_data, result_data);
+
+    auto future = transfer_manager.transfer_peer_async(peer_data, 1, local_data, 0, size / 2);
+    auto async_info = future.get();
+    EXPECT_EQ(transfer_status::COMPLETED, async_info.status);
+
+    // Copies within one device are not peer copies
+    auto local = transfer_manager.transfer_peer_sync(source_data, 0, local_data, 0, size);
+    EXPECT_EQ(transfer_status::COMPLETED, local.status);
+    EXPECT_FALSE(local.peer_to_peer);
+    EXPECT_FALSE(local.staged);
+
+    EXPECT_ANY_THROW(transfer_manager.transfer_peer_sync(source_data, -1, peer_data, 1, size));
+
+    cudaFree(source_data);
+    cudaFree(local_data);
+    cudaFree(peer_data);
+}
+
 /**
  * @brief Test batch memory transfers
  */
@@ -370,6 +483,102 @@ QUARISMATEST(GpuMemoryTransfer, performs_batch_transfers)
     }
 }
 
+/**
+ * @brief Test overlapped upload, compute and download of a buffer
+ */
+QUARISMATEST(GpuMemoryTransfer, runs_copy_compute_pipelines)
+{
+    auto& transfer_manager = gpu_memory_transfer::instance();
+
+    size_t const items      = 100003;
+    void*        device_in  = nullptr;
+    void*        device_out = nullptr;
+    float*       host_in    = nullptr;
+    double*      host_out   = nullptr;
+    if (cudaMalloc(&device_in, items * sizeof(float)) != cudaSuccess)
+    {
+        QUARISMA_LOG_INFO("GPU memory transfer pipeline test skipped (no GPU)");
+        return;
+    }
+    cudaMalloc(&device_out, items * sizeof(double));
+    cudaMallocHost(reinterpret_cast<void**>(&host_in), items * sizeof(float));
+    cudaMallocHost(reinterpret_cast<void**>(&host_out), items * sizeof(double));
+    for (size_t i = 0; i < items; ++i)
+    {
+        host_in[i]  = static_cast<float>(i);
+        host_out[i] = -1.0;
+    }
+
+    transfer_pipeline pipeline;
+    pipeline.item_count        = items;
+    pipeline.input_item_bytes  = sizeof(float);
+    pipeline.output_item_bytes = sizeof(double);
+    pipeline.host_input        = host_in;
+    pipeline.device_input      = device_in;
+    pipeline.device_output     = device_out;
+    pipeline.host_output       = host_out;
+    pipeline.chunk_count       = 7;
+    pipeline.stream_count      = 3;
+
+    // The "kernel" copies the float bits of each item into the low half of its double
+    std::vector<size_t> covered(pipeline.chunk_count, 0);
+    auto info = transfer_manager.run_pipeline(
+        pipeline,
+        [&covered](const pipeline_chunk& chunk)
+        {
+            ASSERT_NE(chunk.stream, nullptr);
+            covered[chunk.index] = chunk.end - chunk.begin;
+            cudaMemsetAsync(
+                chunk.device_output,
+                0,
+                (chunk.end - chunk.begin) * sizeof(double),
+                static_cast<cudaStream_t>(chunk.stream->get_native_handle()));
+            cudaMemcpy2DAsync(
+                chunk.device_output,
+                sizeof(double),
+                chunk.device_input,
+                sizeof(float),
+                sizeof(float),
+                chunk.end - chunk.begin,
+                cudaMemcpyDeviceToDevice,
+                static_cast<cudaStream_t>(chunk.stream->get_native_handle()));
+        });
+    EXPECT_EQ(transfer_status::COMPLETED, info.status);
+    EXPECT_EQ(items * (sizeof(float) + sizeof(double)), info.bytes_transferred);
+
+    size_t total = 0;
+    for (size_t const count : covered)
+    {
+        EXPECT_GE(count, items / pipeline.chunk_count);
+        total += count;
+    }
+    EXPECT_EQ(items, total);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < items; ++i)
+    {
+        float value = 0.0f;
+        std::memcpy(&value, &host_out[i], sizeof(float));
+        mismatches += value == host_in[i] ? 0 : 1;
+    }
+    EXPECT_EQ(0u, mismatches);
+
+    // Copies only, more chunks than items, ordered after a caller stream
+    auto stream          = gpu_stream::create(device_enum::CUDA, 0);
+    pipeline.item_count  = 5;
+    pipeline.chunk_count = 16;
+    info                 = transfer_manager.run_pipeline(pipeline, nullptr, stream.get());
+    EXPECT_EQ(transfer_status::COMPLETED, info.status);
+
+    pipeline.host_input = nullptr;
+    EXPECT_ANY_THROW(transfer_manager.run_pipeline(pipeline, nullptr));
+
+    cudaFreeHost(host_out);
+    cudaFreeHost(host_in);
+    cudaFree(device_out);
+    cudaFree(device_in);
+}
+
 /**
  * @brief Test transfer error handling
  */
@@ -28,6 +28,7 @@
 
 #include "logging/logger.h"
 #include "memory/device.h"
+#include "memory/gpu/gpu_deferred_free.h"
 #include "memory/gpu/gpu_memory_pool.h"
 #include "memory/gpu/gpu_memory_wrapper.h"
 
@@ -451,4 +452,61 @@ QUARISMATEST(GpuMemoryWrapper, supports_swap_operation)
     }
 }
 
+
+/**
+ * @brief Test stream-ordered release through the deferred free queue
+ */
+QUARISMATEST(GpuMemoryWrapper, defers_free_until_stream_work_completes)
+{
+    try
+    {
+        cudaStream_t stream = nullptr;
+        if (cudaStreamCreate(&stream) == cudaSuccess)
+        {
+            auto&        queue  = gpu_deferred_free_queue::instance();
+            size_t const before = queue.pending();
+            {
+                auto wrapper =
+                    gpu_memory_wrapper<float>::allocate(1 << 20, device_enum::CUDA, 0);
+                if (wrapper.get() != nullptr)
+                {
+                    wrapper.set_stream(stream);
+                    EXPECT_EQ(wrapper.stream(), stream);
+
+                    // Queued work still uses the memory when the wrapper goes away
+                    cudaMemsetAsync(wrapper.get(), 0, wrapper.size_bytes(), stream);
+                }
+            }
+            EXPECT_LE(queue.pending(), before + 1);
+
+            // Once the work has completed, polling returns the memory without blocking
+            cudaStreamSynchronize(stream);
+            queue.reclaim(stream);
+            EXPECT_EQ(queue.pending(), before);
+
+            // Moves carry the stream along
+            auto first = gpu_memory_wrapper<void>::allocate(4096, device_enum::CUDA, 0);
+            first.set_stream(stream);
+            auto second = std::move(first);
+            EXPECT_EQ(second.stream(), stream);
+            EXPECT_EQ(first.stream(), nullptr);
+            second.reset();
+            queue.synchronize();
+            EXPECT_EQ(queue.pending(), before);
+
+            cudaStreamDestroy(stream);
+            QUARISMA_LOG_INFO("GPU memory wrapper deferred free test passed");
+        }
+        else
+        {
+            QUARISMA_LOG_INFO("GPU memory wrapper deferred free test skipped (no stream)");
+        }
+    }
+    catch (const std::exception& e)
+    {
+        QUARISMA_LOG_INFO(
+            "GPU memory wrapper deferred free test failed (expected if no GPU): {}", e.what());
+    }
+}
+
 #endif  // QUARISMA_HAS_CUDA
@@ -25,6 +25,7 @@
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <thread>
 #include <vector>
 
@@ -151,6 +152,96 @@ QUARISMATEST(GpuResourceTracker, records_memory_access)
     QUARISMA_LOG_INFO("GPU resource tracker memory access recording test passed");
 }
 
+/**
+ * @brief Test accesses logged to per-thread buffers
+ */
+QUARISMATEST(GpuResourceTracker, logs_memory_access)
+{
+    auto& tracker = gpu_resource_tracker::instance();
+
+    leak_detection_config config;
+    config.enable_periodic_scan = false;
+    config.log_accesses         = true;
+    tracker.configure_leak_detection(config);
+
+    void* test_ptr = malloc(512);
+    EXPECT_NE(nullptr, test_ptr);
+    tracker.track_allocation(test_ptr, 512, device_enum::CPU, 0, "access_log_test");
+
+    // Enough accesses to overflow each thread's buffer more than once
+    constexpr size_t accesses_per_thread = 5000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back(
+            [&tracker, test_ptr]()
+            {
+                for (size_t k = 0; k < accesses_per_thread; ++k)
+                {
+                    tracker.record_access(test_ptr);
+                }
+            });
+    }
+    tracker.record_access(test_ptr);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Exited threads flushed their own buffers; this one is applied by the query
+    auto alloc_info = tracker.get_allocation_info(test_ptr);
+    ASSERT_NE(nullptr, alloc_info);
+    EXPECT_EQ(alloc_info->access_count.load(), 4 * accesses_per_thread + 1);
+
+    // Accesses logged before a free do not reach the next allocation at that address
+    tracker.record_access(test_ptr);
+    tracker.track_deallocation(test_ptr);
+    tracker.track_allocation(test_ptr, 512, device_enum::CPU, 0, "access_log_test");
+    tracker.flush_access_log();
+    EXPECT_EQ(tracker.get_allocation_info(test_ptr)->access_count.load(), 0U);
+
+    tracker.track_deallocation(test_ptr);
+    free(test_ptr);
+    tracker.configure_leak_detection(leak_detection_config{});
+
+    QUARISMA_LOG_INFO("GPU resource tracker access log test passed");
+}
+
+/**
+ * @brief Test recording of managed memory prefetches and hints
+ */
+QUARISMATEST(GpuResourceTracker, records_managed_memory_hints)
+{
+    auto& tracker = gpu_resource_tracker::instance();
+
+    void* test_ptr = malloc(4096);
+    EXPECT_NE(nullptr, test_ptr);
+    tracker.track_allocation(test_ptr, 4096, device_enum::CUDA, 0, "managed_hints");
+
+    // Ranges inside the allocation are attributed to it
+    auto* middle = static_cast<char*>(test_ptr) + 1024;
+    tracker.record_prefetch(test_ptr, 4096, 0);
+    tracker.record_prefetch(middle, 1024, memory_allocator::host_device_id);
+    tracker.record_advice(middle, 1024, memory_allocator::managed_memory_advice::SET_READ_MOSTLY, 0);
+    tracker.record_advice(
+        test_ptr, 4096, memory_allocator::managed_memory_advice::SET_PREFERRED_LOCATION, 1);
+
+    auto alloc_info = tracker.get_allocation_info(test_ptr);
+    ASSERT_NE(nullptr, alloc_info);
+    EXPECT_EQ(2, alloc_info->prefetch_count.load());
+    EXPECT_EQ(5120, alloc_info->prefetched_bytes.load());
+    EXPECT_EQ(memory_allocator::host_device_id, alloc_info->last_prefetch_device);
+    EXPECT_TRUE(alloc_info->read_mostly);
+    EXPECT_EQ(std::optional<int>(1), alloc_info->preferred_location);
+
+    tracker.record_advice(
+        test_ptr, 4096, memory_allocator::managed_memory_advice::UNSET_PREFERRED_LOCATION, 1);
+    EXPECT_FALSE(alloc_info->preferred_location.has_value());
+
+    tracker.track_deallocation(test_ptr);
+    free(test_ptr);
+}
+
 /**
  * @brief Test statistics collection
  */
@@ -0,0 +1,216 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "util/hash.h"
+
+using namespace quarisma;
+
+namespace
+{
+std::vector<unsigned char> random_bytes(size_t size, uint64_t seed)
+{
+    std::mt19937_64            rng(seed);
+    std::vector<unsigned char> bytes(size);
+    for (auto& b : bytes)
+    {
+        b = static_cast<unsigned char>(rng());
+    }
+    return bytes;
+}
+
+// Bitwise CRC-32C, the reference for the table and hardware paths
+uint32_t crc32c_reference(const unsigned char* p, size_t size)
+{
+    uint32_t crc = ~0U;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc ^= p[i];
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc >> 1) ^ ((crc & 1U) != 0 ? 0x82F63B78U : 0U);
+        }
+    }
+    return ~crc;
+}
+}  // namespace
+
+QUARISMATEST(Hash, crc32c_vectors)
+{
+    std::string const check = "123456789";
+    EXPECT_EQ(crc32c(check.data(), check.size()), 0xE3069283U);
+    EXPECT_EQ(crc32c(nullptr, 0), 0U);
+
+    // RFC 3720, B.4
+    std::vector<unsigned char> bytes(32, 0);
+    EXPECT_EQ(crc32c(bytes.data(), bytes.size()), 0x8A9136AAU);
+    std::fill(bytes.begin(), bytes.end(), 0xFF);
+    EXPECT_EQ(crc32c(bytes.data(), bytes.size()), 0x62A8AB43U);
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        bytes[i] = static_cast<unsigned char>(i);
+    }
+    EXPECT_EQ(crc32c(bytes.data(), bytes.size()), 0x46DD794EU);
+
+    // Every length and misalignment, and chaining
+    auto const data = random_bytes(300, 1);
+    for (size_t offset = 0; offset < 8; ++offset)
+    {
+        for (size_t size = 0; offset + size <= data.size(); size += 7)
+        {
+            const unsigned char* p = data.data() + offset;
+            EXPECT_EQ(crc32c(p, size), crc32c_reference(p, size));
+            size_t const split = size / 3;
+            EXPECT_EQ(crc32c(p + split, size - split, crc32c(p, split)), crc32c(p, size));
+        }
+    }
+
+    std::cout << "crc32c hardware path: " << (crc32c_hardware() ? "yes" : "no") << "\n";
+
+    END_TEST();
+}
+
+QUARISMATEST(Hash, hash_bytes_properties)
+{
+    auto const data = random_bytes(1024, 2);
+
+    // Deterministic, seeded, and the 128-bit low word is the 64-bit hash
+    EXPECT_EQ(hash_bytes(data.data(), data.size()), hash_bytes(data.data(), data.size()));
+    EXPECT_NE(hash_bytes(data.data(), data.size(), 1), hash_bytes(data.data(), data.size(), 2));
+    for (size_t size = 0; size <= 200; ++size)
+    {
+        hash128 const wide = hash_bytes128(data.data(), size, 5);
+        EXPECT_EQ(wide.low_, hash_bytes(data.data(), size, 5));
+        EXPECT_NE(wide.low_, wide.high_);
+    }
+    EXPECT_EQ(hash_bytes128(data.data(), 64).str().size(), 32U);
+
+    // Prefixes and single bit flips all hash differently
+    std::vector<uint64_t> seen;
+    for (size_t size = 0; size <= 200; ++size)
+    {
+        seen.push_back(hash_bytes(data.data(), size));
+    }
+    auto flipped = data;
+    for (size_t bit = 0; bit < 8 * 100; bit += 3)
+    {
+        flipped[bit / 8] ^= static_cast<unsigned char>(1U << (bit % 8));
+        seen.push_back(hash_bytes(flipped.data(), 100));
+        flipped[bit / 8] ^= static_cast<unsigned char>(1U << (bit % 8));
+    }
+    std::sort(seen.begin(), seen.end());
+    EXPECT_TRUE(std::adjacent_find(seen.begin(), seen.end()) == seen.end());
+
+    // get_hash of a byte range is hash_bytes, and combines with other values
+    std::string const text = "content-addressed";
+    EXPECT_EQ(
+        get_hash(as_byte_range(text)),
+        static_cast<size_t>(hash_bytes(text.data(), text.size())));
+    std::vector<double> const values = {1.0, 2.0, 3.0};
+    EXPECT_EQ(
+        get_hash(as_byte_range(values)),
+        static_cast<size_t>(hash_bytes(values.data(), values.size() * sizeof(double))));
+    EXPECT_NE(get_hash(as_byte_range(text), 1), get_hash(as_byte_range(text), 2));
+
+    END_TEST();
+}
+
+QUARISMATEST(Hash, byte_hasher_matches_one_shot)
+{
+    auto const      data = random_bytes(2000, 3);
+    std::mt19937_64 rng(4);
+
+    for (size_t size = 0; size <= 400; ++size)
+    {
+        byte_hasher    hasher(9);
+        byte_hasher128 hasher128(9);
+        size_t         done = 0;
+        while (done < size)
+        {
+            size_t const piece = (std::min)(size - done, static_cast<size_t>(rng() % 70));
+            hasher.update(data.data() + done, piece);
+            hasher128.update(data.data() + done, piece);
+            done += piece;
+        }
+        EXPECT_EQ(hasher.digest(), hash_bytes(data.data(), size, 9));
+        EXPECT_EQ(hasher128.digest(), hash_bytes128(data.data(), size, 9));
+    }
+
+    // One large update after a partial block, and byte by byte
+    byte_hasher large;
+    large.update(data.data(), 5).update(data.data() + 5, data.size() - 5);
+    EXPECT_EQ(large.digest(), hash_bytes(data.data(), data.size()));
+
+    byte_hasher bytewise;
+    for (unsigned char b : data)
+    {
+        bytewise.update(&b, 1);
+    }
+    EXPECT_EQ(bytewise.digest(), hash_bytes(data.data(), data.size()));
+
+    END_TEST();
+}
+
+QUARISMATEST(Hash, throughput_benchmark)
+{
+    auto const data = random_bytes(size_t{4} << 20, 5);
+
+    auto const megabytes_per_second = [&data](auto&& hash_once)
+    {
+        constexpr int runs  = 4;
+        auto const    start = std::chrono::steady_clock::now();
+        for (int r = 0; r < runs; ++r)
+        {
+            hash_once();
+        }
+        double const seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(data.size()) * runs / (1 << 20) / seconds;
+    };
+
+    uint64_t   sink = 0;
+    auto const row  = [](const char* name, double mbps)
+    {
+        std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(10) << mbps << " MB/s\n";
+    };
+
+    std::cout << "\n=== Byte Hash Throughput (" << (data.size() >> 20) << " MB input) ===\n";
+    std::string const text(data.begin(), data.end());
+    row("sha1", megabytes_per_second([&] { sink += sha1(text).str().size(); }));
+    row("hash_bytes",
+        megabytes_per_second([&] { sink += hash_bytes(data.data(), data.size()); }));
+    row("hash_bytes128",
+        megabytes_per_second([&] { sink += hash_bytes128(data.data(), data.size()).high_; }));
+    row("crc32c",
+        megabytes_per_second([&] { sink += crc32c(data.data(), data.size()); }));
+    EXPECT_NE(sink, 0U);
+
+    END_TEST();
+}
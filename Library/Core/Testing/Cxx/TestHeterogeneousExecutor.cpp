@@ -0,0 +1,121 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Test suite for heterogeneous_executor: every item of a batch is processed
+ * once, measurements, settings and error propagation. The GPU pipeline needs
+ * CUDA devices, so the checks run on the CPU worker.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "parallel/heterogeneous_executor.h"
+
+namespace quarisma
+{
+namespace
+{
+//-----------------------------------------------------------------------------
+// Runs a batch of `size` items on `executor` and checks each one ran once
+void RunAndCheckCoverage(heterogeneous_executor& executor, std::size_t size)
+{
+    std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[size]);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        visits[i].store(0);
+    }
+
+    heterogeneous_executor::batch work;
+    work.size = size;
+    work.cpu  = [&visits](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            visits[i].fetch_add(1);
+        }
+    };
+    executor.run(work);
+
+    std::size_t wrong = 0;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        wrong += visits[i].load() == 1 ? 0 : 1;
+    }
+    EXPECT_EQ(wrong, 0u);
+}
+}  // namespace
+
+QUARISMATEST(TestHeterogeneousExecutor, HeterogeneousExecutor)
+{
+    // Coverage and measurements on the CPU worker
+    {
+        heterogeneous_executor executor(std::vector<int>{});
+        EXPECT_EQ(executor.number_of_gpus(), 0u);
+
+        RunAndCheckCoverage(executor, 100000);
+        RunAndCheckCoverage(executor, 1);
+        RunAndCheckCoverage(executor, 0);
+
+        auto stats = executor.statistics();
+        ASSERT_EQ(stats.size(), 1u);
+        EXPECT_EQ(stats[0].device.type(), device_enum::CPU);
+        EXPECT_EQ(stats[0].items, 100001u);
+
+        executor.reset_statistics();
+        stats = executor.statistics();
+        EXPECT_EQ(stats[0].items, 0u);
+        EXPECT_EQ(stats[0].throughput, 0.0);
+    }
+
+    // Settings are clamped, and large minimum chunks still cover the range
+    {
+        heterogeneous_executor executor(std::vector<int>{});
+        EXPECT_EQ(executor.get_pipeline_depth(), 2u);
+        EXPECT_EQ(executor.get_min_chunk(), 1u);
+
+        executor.set_pipeline_depth(0);
+        EXPECT_EQ(executor.get_pipeline_depth(), 1u);
+        executor.set_min_chunk(0);
+        EXPECT_EQ(executor.get_min_chunk(), 1u);
+
+        executor.set_min_chunk(4096);
+        RunAndCheckCoverage(executor, 10000);
+        RunAndCheckCoverage(executor, 100);
+    }
+
+    // The first exception of a kernel is rethrown by run()
+    {
+        heterogeneous_executor        executor(std::vector<int>{});
+        heterogeneous_executor::batch work;
+        work.size = 1000;
+        work.cpu  = [](std::size_t begin, std::size_t end)
+        {
+            if (begin <= 500 && 500 < end)
+            {
+                throw std::runtime_error("item 500");
+            }
+        };
+        EXPECT_THROW(executor.run(work), std::runtime_error);
+
+        // The executor is still usable afterwards
+        RunAndCheckCoverage(executor, 1000);
+    }
+
+    // A batch without any kernel for the workers is rejected
+    {
+        heterogeneous_executor        executor(std::vector<int>{});
+        heterogeneous_executor::batch work;
+        work.size = 10;
+        EXPECT_ANY_THROW(executor.run(work));
+    }
+
+    END_TEST();
+}
+
+}  // namespace quarisma
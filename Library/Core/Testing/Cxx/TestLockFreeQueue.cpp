@@ -0,0 +1,180 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Unit tests for the block-linked queues of util/lock_free_queue.h
+ *
+ * Tests cover:
+ * - BlockedQueue and LockFreeQueue push, pop, PopAll and iteration
+ * - MultiProducerLockFreeQueue across block boundaries and block reuse
+ * - MultiProducerLockFreeQueue with concurrent producers
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "util/lock_free_queue.h"
+
+namespace quarisma
+{
+namespace
+{
+// Small blocks so that the tests cross many block boundaries
+constexpr size_t kTestBlockSize = 256;
+}  // namespace
+
+// ============================================================================
+// Consolidated Test 1: Single-producer Queues
+// ============================================================================
+
+QUARISMATEST(LockFreeQueue, single_producer)
+{
+    using queue_type          = LockFreeQueue<std::int64_t, kTestBlockSize>;
+    const std::int64_t slots  = queue_type::kNumSlotsPerBlockForTesting;
+    const std::int64_t number = slots * 5 + 3;
+
+    // Test 1: push / pop in order, then empty
+    {
+        queue_type queue;
+        for (std::int64_t i = 0; i < number; ++i)
+        {
+            queue.push(std::int64_t{i});
+        }
+        for (std::int64_t i = 0; i < number; ++i)
+        {
+            auto element = queue.pop();
+            ASSERT_TRUE(element.has_value());
+            EXPECT_EQ(*element, i);
+        }
+        EXPECT_FALSE(queue.pop().has_value());
+    }
+
+    // Test 2: PopAll hands the elements over to an iterable BlockedQueue
+    {
+        queue_type queue;
+        for (std::int64_t i = 0; i < number; ++i)
+        {
+            queue.push(std::int64_t{i});
+        }
+        auto         all      = queue.PopAll();
+        std::int64_t expected = 0;
+        for (const auto value : all)
+        {
+            EXPECT_EQ(value, expected++);
+        }
+        EXPECT_EQ(expected, number);
+        EXPECT_FALSE(queue.pop().has_value());
+
+        // The source queue remains usable
+        queue.push(42);
+        EXPECT_EQ(queue.pop().value_or(-1), 42);
+    }
+}
+
+// ============================================================================
+// Consolidated Test 2: Multi-producer Queue
+// ============================================================================
+
+QUARISMATEST(LockFreeQueue, multi_producer)
+{
+    using queue_type         = MultiProducerLockFreeQueue<std::int64_t, kTestBlockSize>;
+    const std::int64_t slots = queue_type::kNumSlotsPerBlockForTesting;
+    ASSERT_GT(slots, 1);
+
+    // Test 1: single thread, across block boundaries, with block reuse
+    {
+        queue_type queue;
+        for (int round = 0; round < 3; ++round)
+        {
+            const std::int64_t number = slots * 4 + round;
+            for (std::int64_t i = 0; i < number; ++i)
+            {
+                queue.push(std::int64_t{i});
+            }
+            for (std::int64_t i = 0; i < number; ++i)
+            {
+                auto element = queue.pop();
+                ASSERT_TRUE(element.has_value());
+                EXPECT_EQ(*element, i);
+            }
+            EXPECT_FALSE(queue.pop().has_value());
+        }
+    }
+
+    // Test 2: elements that own memory are destroyed by clear() and the destructor
+    {
+        auto tracker = std::make_shared<int>(0);
+        {
+            MultiProducerLockFreeQueue<std::shared_ptr<int>, kTestBlockSize> queue;
+            for (std::int64_t i = 0; i < slots * 2; ++i)
+            {
+                queue.push(std::shared_ptr<int>(tracker));
+            }
+            queue.clear();
+            EXPECT_EQ(tracker.use_count(), 1);
+            for (std::int64_t i = 0; i < slots + 1; ++i)
+            {
+                queue.push(std::shared_ptr<int>(tracker));
+            }
+        }
+        EXPECT_EQ(tracker.use_count(), 1);
+    }
+
+    // Test 3: concurrent producers with a draining consumer; every element is
+    // received once and each producer's elements arrive in order
+    {
+        queue_type         queue;
+        const int          producers    = 4;
+        const std::int64_t per_producer = 20000;
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back(
+                [&queue, p]
+                {
+                    for (std::int64_t i = 0; i < per_producer; ++i)
+                    {
+                        queue.push(std::int64_t{p} * per_producer + i);
+                    }
+                });
+        }
+
+        std::vector<std::int64_t> last(producers, -1);
+        std::int64_t              received = 0;
+        bool                      ordered  = true;
+        while (received < producers * per_producer)
+        {
+            auto batch = queue.PopAll();
+            for (const auto value : batch)
+            {
+                const auto producer = static_cast<size_t>(value / per_producer);
+                ordered             = ordered && value % per_producer == last[producer] + 1;
+                last[producer]      = value % per_producer;
+                ++received;
+            }
+            if (auto element = queue.pop())
+            {
+                const auto producer = static_cast<size_t>(*element / per_producer);
+                ordered             = ordered && *element % per_producer == last[producer] + 1;
+                last[producer]      = *element % per_producer;
+                ++received;
+            }
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        EXPECT_TRUE(ordered);
+        EXPECT_EQ(received, producers * per_producer);
+        EXPECT_FALSE(queue.pop().has_value());
+    }
+}
+
+}  // namespace quarisma
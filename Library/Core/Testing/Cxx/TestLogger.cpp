@@ -17,10 +17,18 @@
  * Website: https://www.quarisma.co.uk
  */
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
+#include "logging/deferred_log.h"
 #include "logging/logger.h"
 #include "baseTest.h"
 
@@ -32,6 +40,33 @@ QUARISMA_UNUSED void log_handler(void* user_data, const quarisma::logger::Messag
     (*lines) += "\n";
     (*lines) += message.message;
 }
+
+struct gated_sink
+{
+    std::atomic<bool>        open{true};
+    std::vector<std::string> messages;
+};
+
+// Holds the async writer thread while the gate is closed, so that the queue fills up.
+QUARISMA_UNUSED void gated_handler(void* user_data, const quarisma::logger::Message& message)
+{
+    auto* sink = reinterpret_cast<gated_sink*>(user_data);
+    while (!sink->open.load())
+    {
+        std::this_thread::yield();
+    }
+    sink->messages.emplace_back(message.message);
+}
+
+// Logs until the writer is stuck in the closed gate with a full queue behind it.
+QUARISMA_UNUSED void fill_async_queue(gated_sink& sink)
+{
+    sink.open = false;
+    while (quarisma::logger::AsyncDroppedCount() == 0)
+    {
+        QUARISMA_LOG_INFO("filler");
+    }
+}
 }  // namespace
 
 QUARISMATEST(Logger, test)
@@ -115,3 +150,325 @@ QUARISMATEST(Logger, test)
 
     END_TEST();
 }
+
+#if QUARISMA_HAS_LOGURU
+QUARISMATEST(Logger, nested_scopes_compare_whole_ids)
+{
+    std::string errors;
+    quarisma::logger::AddCallback(
+        "scope-errors", log_handler, &errors, quarisma::logger_verbosity_enum::VERBOSITY_ERROR);
+
+    // Ids share their first 63 characters, and the stack grows past its 32 inline entries.
+    const std::string        prefix(63, 's');
+    std::vector<std::string> ids;
+    for (int i = 0; i < 40; ++i)
+    {
+        ids.push_back(prefix + std::to_string(i));
+        QUARISMA_LOG_START_SCOPE(INFO, ids.back().c_str());
+    }
+    for (int i = 39; i >= 32; --i)
+    {
+        QUARISMA_LOG_END_SCOPE(ids[i].c_str());
+    }
+    EXPECT_TRUE(errors.empty());
+
+    // Closing the wrong inline scope is reported and leaves the stack intact.
+    QUARISMA_LOG_END_SCOPE(ids[30].c_str());
+    EXPECT_NE(errors.find("Mismatched scope!"), std::string::npos);
+
+    errors.clear();
+    for (int i = 31; i >= 0; --i)
+    {
+        QUARISMA_LOG_END_SCOPE(ids[i].c_str());
+    }
+    EXPECT_TRUE(errors.empty());
+
+    quarisma::logger::RemoveCallback("scope-errors");
+
+    END_TEST();
+}
+#endif  // QUARISMA_HAS_LOGURU
+
+#if QUARISMA_HAS_NATIVE_LOGGING
+QUARISMATEST(Logger, sampled_and_rate_limited_macros)
+{
+    std::string lines;
+    quarisma::logger::AddCallback(
+        "sampled", log_handler, &lines, quarisma::logger_verbosity_enum::VERBOSITY_INFO);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        QUARISMA_LOG_EVERY_N(INFO, 3, "every {}", i);
+    }
+    EXPECT_EQ(lines, "\nevery 0\nevery 3\nevery 6\nevery 9");
+
+    lines.clear();
+    for (int i = 0; i < 10; ++i)
+    {
+        QUARISMA_LOG_FIRST_N(INFO, 2, "first {}", i);
+    }
+    EXPECT_EQ(lines, "\nfirst 0\nfirst 1");
+
+    lines.clear();
+    for (int i = 0; i < 10; ++i)
+    {
+        QUARISMA_LOG_EVERY_T(INFO, 60000, "timed {}", i);
+    }
+    EXPECT_EQ(lines, "\ntimed 0");
+
+    lines.clear();
+    for (int i = 0; i < 10; ++i)
+    {
+        QUARISMA_LOG_RATE_LIMITED(INFO, 0.001, 3, "limited {}", i);
+    }
+    EXPECT_EQ(lines, "\nlimited 0\nlimited 1\nlimited 2");
+
+    quarisma::logger::RemoveCallback("sampled");
+
+    END_TEST();
+}
+
+QUARISMATEST(Logger, first_n_across_threads)
+{
+    gated_sink sink;
+    quarisma::logger::AddCallback(
+        "first-n", gated_handler, &sink, quarisma::logger_verbosity_enum::VERBOSITY_INFO);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back(
+            []
+            {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    QUARISMA_LOG_FIRST_N(ERROR, 5, "bad input {}", i);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(sink.messages.size(), 5u);
+
+    quarisma::logger::RemoveCallback("first-n");
+
+    END_TEST();
+}
+
+QUARISMATEST(Logger, structured_callback_fields)
+{
+    // The views are only valid during the call, so the fields are copied out.
+    struct record
+    {
+        quarisma::logger_verbosity_enum verbosity;
+        std::string                     filename;
+        unsigned                        line;
+        uint64_t                        thread_id;
+        int64_t                         timestamp_ns;
+        std::string                     message;
+    };
+    std::vector<record> records;
+    auto handler = [](void* user_data, const quarisma::logger::StructuredMessage& m)
+    {
+        reinterpret_cast<std::vector<record>*>(user_data)->push_back(
+            {m.verbosity,
+             std::string(m.filename),
+             m.line,
+             m.thread_id,
+             m.timestamp_ns,
+             std::string(m.message)});
+    };
+    quarisma::logger::AddStructuredCallback(
+        "structured", handler, &records, quarisma::logger_verbosity_enum::VERBOSITY_INFO);
+
+    const int64_t before = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+    const int line = __LINE__ + 1;
+    QUARISMA_LOG_WARNING("value {}", 7);
+
+    quarisma::logger::StartAsync();
+    std::thread([] { QUARISMA_LOG_INFO("from worker"); }).join();
+    QUARISMA_LOG_INFO("from main");
+    quarisma::logger::StopAsync();
+    quarisma::logger::RemoveCallback("structured");
+
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].verbosity, quarisma::logger_verbosity_enum::VERBOSITY_WARNING);
+    EXPECT_EQ(records[0].filename, "TestLogger.cpp");
+    EXPECT_EQ(records[0].line, static_cast<unsigned>(line));
+    EXPECT_EQ(records[0].message, "value 7");
+    EXPECT_GE(records[0].timestamp_ns, before);
+    EXPECT_LE(records[0].timestamp_ns, records[2].timestamp_ns);
+    EXPECT_EQ(records[1].message, "from worker");
+    EXPECT_EQ(records[2].message, "from main");
+
+    // Async records keep the id of the thread that logged, not the writer's.
+    EXPECT_EQ(records[2].thread_id, records[0].thread_id);
+    EXPECT_NE(records[1].thread_id, records[0].thread_id);
+
+    END_TEST();
+}
+
+QUARISMATEST(Logger, async_preserves_per_thread_order)
+{
+    gated_sink sink;
+    quarisma::logger::AddCallback(
+        "async-order", gated_handler, &sink, quarisma::logger_verbosity_enum::VERBOSITY_INFO);
+    quarisma::logger::StartAsync();
+    EXPECT_TRUE(quarisma::logger::IsAsync());
+
+    constexpr int kThreads  = 4;
+    constexpr int kMessages = 200;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [t]
+            {
+                for (int i = 0; i < kMessages; ++i)
+                {
+                    QUARISMA_LOG_INFO("{} {}", t, i);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    quarisma::logger::Flush();
+
+    EXPECT_EQ(sink.messages.size(), static_cast<size_t>(kThreads * kMessages));
+    std::vector<int> next(kThreads, 0);
+    for (const auto& message : sink.messages)
+    {
+        std::istringstream in(message);
+        int                t = 0;
+        int                i = 0;
+        in >> t >> i;
+        EXPECT_EQ(i, next[t]);
+        next[t] = i + 1;
+    }
+    EXPECT_EQ(quarisma::logger::AsyncDroppedCount(), 0u);
+
+    quarisma::logger::StopAsync();
+    EXPECT_FALSE(quarisma::logger::IsAsync());
+    quarisma::logger::RemoveCallback("async-order");
+
+    END_TEST();
+}
+
+QUARISMATEST(Logger, async_overflow_drop_low_severity)
+{
+    gated_sink sink;
+    quarisma::logger::AddCallback(
+        "async-drop", gated_handler, &sink, quarisma::logger_verbosity_enum::VERBOSITY_INFO);
+
+    quarisma::logger::AsyncOptions options;
+    options.queue_capacity  = 4;
+    options.overflow_policy = quarisma::logger::OverflowPolicy::DROP_LOW_SEVERITY;
+    quarisma::logger::StartAsync(options);
+
+    fill_async_queue(sink);
+    const size_t dropped = quarisma::logger::AsyncDroppedCount();
+
+    // An ERROR waits for room instead of being dropped.
+    std::thread opener(
+        [&sink]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            sink.open = true;
+        });
+    QUARISMA_LOG_ERROR("kept");
+    opener.join();
+    quarisma::logger::Flush();
+
+    EXPECT_EQ(quarisma::logger::AsyncDroppedCount(), dropped);
+    EXPECT_EQ(sink.messages.back(), "kept");
+
+    quarisma::logger::StopAsync();
+    quarisma::logger::RemoveCallback("async-drop");
+
+    END_TEST();
+}
+
+QUARISMATEST(Logger, async_fatal_is_written_before_returning)
+{
+    std::string lines;
+    quarisma::logger::AddCallback(
+        "async-fatal", log_handler, &lines, quarisma::logger_verbosity_enum::VERBOSITY_INFO);
+    quarisma::logger::StartAsync();
+
+    QUARISMA_LOG_INFO("before");
+    QUARISMA_LOG_FATAL("fatal");
+    EXPECT_EQ(lines, "\nbefore\nfatal");
+
+    quarisma::logger::StopAsync();
+    quarisma::logger::RemoveCallback("async-fatal");
+
+    END_TEST();
+}
+
+QUARISMATEST(Logger, async_writes_log_files)
+{
+    const std::string path = "TestLoggerAsync.log";
+    quarisma::logger::LogToFile(
+        path.c_str(),
+        quarisma::logger::FileMode::TRUNCATE,
+        quarisma::logger_verbosity_enum::VERBOSITY_WARNING);
+    quarisma::logger::StartAsync();
+
+    QUARISMA_LOG_INFO("filtered out");
+    QUARISMA_LOG_WARNING("written to file");
+    quarisma::logger::EndLogToFile(path.c_str());
+    quarisma::logger::StopAsync();
+
+    std::ifstream     file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_NE(content.str().find("[WARNING] TestLogger.cpp:"), std::string::npos);
+    EXPECT_NE(content.str().find("written to file"), std::string::npos);
+    EXPECT_EQ(content.str().find("filtered out"), std::string::npos);
+    file.close();
+    std::remove(path.c_str());
+
+    END_TEST();
+}
+
+QUARISMATEST(Logger, deferred_formats_on_writer)
+{
+    std::string lines;
+    quarisma::logger::AddCallback(
+        "deferred", log_handler, &lines, quarisma::logger_verbosity_enum::VERBOSITY_INFO);
+
+    // Without the async writer the call site formats the message itself.
+    QUARISMA_LOG_DEFERRED(INFO, "sync {} {}", 1, "one");
+    EXPECT_EQ(lines, "\nsync 1 one");
+
+    quarisma::logger::StartAsync();
+    lines.clear();
+    {
+        // The record keeps its own copy of the string arguments.
+        std::string       owner = "temporary";
+        const std::string wide(400, 'x');
+        QUARISMA_LOG_DEFERRED(
+            INFO, "order {} filled {} @ {:.2f} by {}", int64_t{42}, 7u, 101.256, owner);
+        owner.assign("overwritten");
+        QUARISMA_LOG_DEFERRED(WARNING, "{}|{}", wide, 'c');
+        QUARISMA_LOG_DEFERRED(INFO, "no arguments");
+    }
+    quarisma::logger::Flush();
+    EXPECT_EQ(
+        lines,
+        "\norder 42 filled 7 @ 101.26 by temporary\n" + std::string(400, 'x') +
+            "|c\nno arguments");
+
+    quarisma::logger::StopAsync();
+    quarisma::logger::RemoveCallback("deferred");
+
+    END_TEST();
+}
+#endif  // QUARISMA_HAS_NATIVE_LOGGING
@@ -0,0 +1,293 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "Testing/cpuCapabilityTest.h"
+#include "math/lu.h"
+#include "math/lu_dispatch.h"
+#include "util/cpu_info.h"
+
+using namespace quarisma;
+
+namespace
+{
+// n x n, row stride lda; diagonally dominant unless this build pivots
+std::vector<double> random_matrix(size_t n, size_t lda, std::mt19937& engine)
+{
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<double>                    a(n * lda, 0.0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            a[i * lda + j] = uniform(engine);
+        }
+        if (!linalg::lu_pivoting())
+        {
+            a[i * lda + i] += static_cast<double>(n);
+        }
+    }
+    return a;
+}
+
+// max |P A - L U| / max |A|
+double factor_error(
+    const std::vector<double>& a, const std::vector<double>& lu, size_t n, size_t lda,
+    const int* pivots)
+{
+    std::vector<double> pa(a);
+    for (size_t k = 0; k < n; ++k)
+    {
+        auto const p = static_cast<size_t>(pivots[k]);
+        std::swap_ranges(pa.begin() + k * lda, pa.begin() + k * lda + n, pa.begin() + p * lda);
+    }
+
+    double error = 0.0;
+    double scale = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            double sum = i <= j ? lu[i * lda + j] : 0.0;
+            for (size_t k = 0; k < std::min(i, j + 1); ++k)
+            {
+                sum += lu[i * lda + k] * lu[k * lda + j];
+            }
+            error = std::max(error, std::fabs(pa[i * lda + j] - sum));
+            scale = std::max(scale, std::fabs(a[i * lda + j]));
+        }
+    }
+    return error / scale;
+}
+
+void check_pivots(const std::vector<double>& lu, size_t n, size_t lda, const int* pivots)
+{
+    for (size_t k = 0; k < n; ++k)
+    {
+        if (!linalg::lu_pivoting())
+        {
+            ASSERT_EQ(pivots[k], static_cast<int>(k));
+            continue;
+        }
+        ASSERT_GE(pivots[k], static_cast<int>(k));
+        ASSERT_LT(pivots[k], static_cast<int>(n));
+        for (size_t i = k + 1; i < n; ++i)
+        {
+            ASSERT_LE(std::fabs(lu[i * lda + k]), 1.0);
+        }
+    }
+}
+}  // namespace
+
+QUARISMATEST(Lu, factor)
+{
+    std::mt19937 engine(3);
+    for (size_t n : {1, 2, 3, 5, 8, 16, 17, 31, 33, 64, 100, 257, 600})
+    {
+        size_t const lda = n + n % 3;
+        auto const   a   = random_matrix(n, lda, engine);
+
+        auto             lu = a;
+        std::vector<int> pivots(n, -1);
+        ASSERT_EQ(linalg::lu_factor(lu.data(), n, lda, pivots.data()), 0);
+        check_pivots(lu, n, lda, pivots.data());
+        EXPECT_LT(factor_error(a, lu, n, lda, pivots.data()), 1e-14 * static_cast<double>(n))
+            << "order " << n;
+
+        // Three right-hand sides of known solutions
+        size_t const        nrhs = 3;
+        size_t const        ldb  = nrhs + 1;
+        std::vector<double> x(n * ldb, 0.0);
+        std::vector<double> b(n * ldb, 0.0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t r = 0; r < nrhs; ++r)
+            {
+                x[i * ldb + r] = std::sin(static_cast<double>(i + 7 * r));
+            }
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t k = 0; k < n; ++k)
+            {
+                for (size_t r = 0; r < nrhs; ++r)
+                {
+                    b[i * ldb + r] += a[i * lda + k] * x[k * ldb + r];
+                }
+            }
+        }
+        linalg::lu_solve(lu.data(), n, lda, pivots.data(), b.data(), nrhs, ldb);
+        for (size_t i = 0; i < n * ldb; ++i)
+        {
+            ASSERT_NEAR(b[i], x[i], 1e-9) << "order " << n << ", element " << i;
+        }
+    }
+
+    ASSERT_ANY_THROW(linalg::lu_factor(nullptr, 4, 3, nullptr));
+
+    END_TEST();
+}
+
+QUARISMATEST(Lu, singular)
+{
+    // U(k, k) = 0 for the first time at k = 1, with or without pivoting
+    std::vector<double> a = {2, 1, 0, 0, 0, 0, 1, 3, 5};
+    std::vector<int>    pivots(3);
+    EXPECT_EQ(linalg::lu_factor(a.data(), 3, 3, pivots.data()), linalg::lu_pivoting() ? 3 : 2);
+
+    std::vector<double> zero(40 * 40, 0.0);
+    pivots.resize(40);
+    EXPECT_EQ(linalg::lu_factor(zero.data(), 40, 40, pivots.data()), 1);
+
+    END_TEST();
+}
+
+QUARISMATEST(Lu, batched)
+{
+    std::mt19937 engine(5);
+    for (size_t n = 1; n <= linalg::batch_max_order + 3; ++n)
+    {
+        size_t const        count = 37;
+        size_t const        size  = n * n;
+        std::vector<double> a;
+        for (size_t m = 0; m < count; ++m)
+        {
+            auto const one = random_matrix(n, n, engine);
+            a.insert(a.end(), one.begin(), one.end());
+        }
+        // A singular matrix among them
+        std::fill(a.begin() + 4 * size, a.begin() + 5 * size, 0.0);
+
+        std::vector<double> b(count * n);
+        for (size_t i = 0; i < b.size(); ++i)
+        {
+            b[i] = std::cos(static_cast<double>(i));
+        }
+
+        // One matrix at a time
+        auto             expected_lu = a;
+        auto             expected_x  = b;
+        std::vector<int> expected_pivots(count * n);
+        std::vector<int> expected_info(count);
+        for (size_t m = 0; m < count; ++m)
+        {
+            expected_info[m] = linalg::lu_factor(
+                expected_lu.data() + m * size, n, n, expected_pivots.data() + m * n);
+            if (expected_info[m] == 0)
+            {
+                linalg::lu_solve(
+                    expected_lu.data() + m * size,
+                    n,
+                    n,
+                    expected_pivots.data() + m * n,
+                    expected_x.data() + m * n,
+                    1,
+                    1);
+            }
+        }
+        EXPECT_EQ(expected_info[4], 1);
+
+        for (cpu_capability c : capabilities())
+        {
+            auto const factor = linalg::detail::batch_factor_stub_type::kernel(c);
+            auto const solve  = linalg::detail::batch_solve_stub_type::kernel(c);
+            if (factor == nullptr || solve == nullptr)
+            {
+                continue;
+            }
+
+            auto             lu = a;
+            auto             x  = b;
+            std::vector<int> pivots(count * n, -1);
+            std::vector<int> info(count, -1);
+            if (n <= linalg::batch_max_order)
+            {
+                factor(linalg::lu_pivoting(), lu.data(), n, count, pivots.data(), info.data());
+                solve(lu.data(), n, count, pivots.data(), x.data());
+            }
+            else
+            {
+                linalg::lu_factor_batched(lu.data(), n, count, pivots.data(), info.data());
+                linalg::lu_solve_batched(lu.data(), n, count, pivots.data(), x.data());
+            }
+
+            EXPECT_EQ(info, expected_info) << "order " << n;
+            EXPECT_EQ(pivots, expected_pivots) << "order " << n;
+            for (size_t i = 0; i < lu.size(); ++i)
+            {
+                ASSERT_NEAR(lu[i], expected_lu[i], 1e-12 * (1 + std::fabs(expected_lu[i])))
+                    << "capability " << static_cast<int>(c) << ", order " << n;
+            }
+            for (size_t m = 0; m < count; ++m)
+            {
+                for (size_t i = 0; i < n && info[m] == 0; ++i)
+                {
+                    ASSERT_NEAR(x[m * n + i], expected_x[m * n + i], 1e-10)
+                        << "capability " << static_cast<int>(c) << ", order " << n;
+                }
+            }
+        }
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(Lu, batched_parallel)
+{
+    // Enough 4 x 4 systems for several parallel tasks
+    size_t const        n     = 4;
+    size_t const        count = 20011;
+    std::mt19937        engine(7);
+    std::vector<double> a;
+    for (size_t m = 0; m < count; ++m)
+    {
+        auto const one = random_matrix(n, n, engine);
+        a.insert(a.end(), one.begin(), one.end());
+    }
+
+    auto             lu = a;
+    std::vector<int> pivots(count * n);
+    std::vector<int> info(count);
+    linalg::lu_factor_batched(lu.data(), n, count, pivots.data(), info.data());
+
+    std::vector<double> x(count * n, 1.0);
+    linalg::lu_solve_batched(lu.data(), n, count, pivots.data(), x.data());
+    for (size_t m = 0; m < count; ++m)
+    {
+        ASSERT_EQ(info[m], 0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            double ax = 0.0;
+            for (size_t k = 0; k < n; ++k)
+            {
+                ax += a[m * n * n + i * n + k] * x[m * n + k];
+            }
+            ASSERT_NEAR(ax, 1.0, 1e-9) << "matrix " << m;
+        }
+    }
+
+    END_TEST();
+}
@@ -0,0 +1,228 @@
+/**
+ * @file TestMappedLogSink.cpp
+ * @brief Tests for the memory-mapped segment log sink
+ *
+ * Covers:
+ * - Size- and time-based rotation, and the lines the segments hold
+ * - Compression of the closed segments
+ * - Receiving the messages of the async logger
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "compression/codec.h"
+#include "logging/logger.h"
+#include "logging/mapped_log_sink.h"
+
+using namespace quarisma;
+
+namespace
+{
+std::string make_directory(const char* name)
+{
+    auto const path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(path);
+    return path.string();
+}
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream     in(path, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+logger::StructuredMessage make_message(const std::string& text, int64_t timestamp_ns)
+{
+    return {
+        logger_verbosity_enum::VERBOSITY_INFO,
+        "TestMappedLogSink.cpp",
+        42,
+        7,
+        timestamp_ns,
+        text};
+}
+}  // namespace
+
+QUARISMATEST(MappedLogSink, rotates_full_segments)
+{
+    mapped_log_sink::Options opts;
+    opts.directory     = make_directory("quarisma_mapped_log_size");
+    opts.segment_bytes = 4096;
+
+    std::vector<std::string> segments;
+    {
+        mapped_log_sink sink(opts);
+        for (int i = 0; i < 500; ++i)
+        {
+            sink.write(make_message("line " + std::to_string(i), 1'700'000'000'123'456'789));
+        }
+        sink.wait_idle();
+        EXPECT_GE(sink.closed_segments().size(), 5U);
+    }
+
+    std::string content;
+    for (const auto& entry : std::filesystem::directory_iterator(opts.directory))
+    {
+        segments.push_back(entry.path().string());
+    }
+    std::sort(segments.begin(), segments.end());
+    for (const auto& path : segments)
+    {
+        // Truncated to the whole lines written
+        EXPECT_LE(std::filesystem::file_size(path), 4096U);
+        std::string const lines = read_file(path);
+        ASSERT_FALSE(lines.empty());
+        EXPECT_EQ(lines.back(), '\n');
+        EXPECT_EQ(lines.find('\0'), std::string::npos);
+        content += lines;
+    }
+
+    EXPECT_EQ(
+        content.find("1700000000.123456789 7 [INFO] TestMappedLogSink.cpp:42 line 0\n"), 0U);
+    size_t position = 0;
+    for (int i = 0; i < 500; ++i)
+    {
+        position = content.find(" line " + std::to_string(i) + "\n", position);
+        ASSERT_NE(position, std::string::npos);
+    }
+
+    std::filesystem::remove_all(opts.directory);
+    END_TEST();
+}
+
+QUARISMATEST(MappedLogSink, rotates_old_segments)
+{
+    mapped_log_sink::Options opts;
+    opts.directory       = make_directory("quarisma_mapped_log_age");
+    opts.max_segment_age = std::chrono::seconds(60);
+
+    {
+        mapped_log_sink sink(opts);
+        int64_t const   now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+        sink.write(make_message("first", now));
+        sink.write(make_message("same segment", now + 1'000'000'000));
+        sink.write(make_message("next segment", now + 61'000'000'000));
+        sink.wait_idle();
+
+        auto const closed = sink.closed_segments();
+        ASSERT_EQ(closed.size(), 1U);
+        std::string const lines = read_file(closed[0]);
+        EXPECT_NE(lines.find("same segment"), std::string::npos);
+        EXPECT_EQ(lines.find("next segment"), std::string::npos);
+
+        // An explicit rotation of an empty segment does nothing
+        sink.rotate();
+        sink.rotate();
+        sink.wait_idle();
+        EXPECT_EQ(sink.closed_segments().size(), 2U);
+        EXPECT_EQ(sink.stats().lines, 3U);
+    }
+    EXPECT_EQ(
+        std::distance(
+            std::filesystem::directory_iterator(opts.directory),
+            std::filesystem::directory_iterator()),
+        2);
+
+    std::filesystem::remove_all(opts.directory);
+    END_TEST();
+}
+
+QUARISMATEST(MappedLogSink, compresses_closed_segments)
+{
+    const compression::codec* codec = nullptr;
+    for (auto type :
+         {compression::codec_type::snappy,
+          compression::codec_type::lz4,
+          compression::codec_type::zstd})
+    {
+        if (codec == nullptr)
+        {
+            codec = compression::codec::get(type);
+        }
+    }
+    if (codec == nullptr)
+    {
+        GTEST_SKIP() << "No compression codec is enabled in this build";
+    }
+
+    mapped_log_sink::Options opts;
+    opts.directory     = make_directory("quarisma_mapped_log_codec");
+    opts.segment_bytes = 8192;
+    opts.compression   = codec->type();
+
+    std::string expected;
+    {
+        mapped_log_sink sink(opts);
+        for (int i = 0; i < 100; ++i)
+        {
+            sink.write(make_message("repetitive message " + std::to_string(i), 0));
+        }
+        sink.rotate();
+        sink.wait_idle();
+
+        for (const auto& path : sink.closed_segments())
+        {
+            EXPECT_EQ(
+                std::filesystem::path(path).extension().string(),
+                "." + std::string(codec->name()));
+            EXPECT_FALSE(std::filesystem::exists(path.substr(0, path.rfind('.'))));
+
+            std::string const compressed = read_file(path);
+            std::string       lines;
+            ASSERT_TRUE(codec->uncompress(compressed.data(), compressed.size(), &lines));
+            expected += lines;
+        }
+        EXPECT_EQ(expected.size(), sink.stats().bytes);
+    }
+    EXPECT_NE(expected.find("repetitive message 99\n"), std::string::npos);
+
+    std::filesystem::remove_all(opts.directory);
+    END_TEST();
+}
+
+QUARISMATEST(MappedLogSink, receives_async_logger_messages)
+{
+    mapped_log_sink::Options opts;
+    opts.directory = make_directory("quarisma_mapped_log_async");
+    opts.prefix    = "async";
+
+    {
+        mapped_log_sink sink(opts);
+        sink.attach(logger_verbosity_enum::VERBOSITY_INFO);
+        logger::StartAsync();
+
+        std::thread([] { QUARISMA_LOG_INFO("from worker {}", 1); }).join();
+        QUARISMA_LOG_WARNING("from main");
+        logger::StopAsync();
+        sink.detach();
+
+        // Logged after detaching, so not in the segment
+        QUARISMA_LOG_INFO("not written");
+
+        sink.rotate();
+        sink.wait_idle();
+        ASSERT_EQ(sink.closed_segments().size(), 1U);
+        std::string const lines = read_file(sink.closed_segments()[0]);
+        EXPECT_NE(lines.find("[INFO] TestMappedLogSink.cpp:"), std::string::npos);
+        EXPECT_NE(lines.find("from worker 1\n"), std::string::npos);
+        EXPECT_NE(lines.find("[WARNING]"), std::string::npos);
+        EXPECT_EQ(lines.find("not written"), std::string::npos);
+    }
+
+    std::filesystem::remove_all(opts.directory);
+    END_TEST();
+}
@@ -0,0 +1,253 @@
+/**
+ * @file TestMemoryMetrics.cpp
+ * @brief Tests for metrics_registry, statsd_exporter and the web_dashboard metrics export
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/visualization/metrics_registry.h"
+#include "memory/visualization/web_dashboard.h"
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+using namespace quarisma;
+
+namespace
+{
+std::unique_ptr<allocator_bfc> create_metrics_bfc_allocator()
+{
+    auto sub_alloc = std::make_unique<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+
+    return std::make_unique<allocator_bfc>(
+        std::move(sub_alloc), 1024ULL * 1024ULL, "metrics_bfc", opts);
+}
+
+size_t count_occurrences(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos;
+         pos        = text.find(pattern, pos + pattern.size()))
+    {
+        ++count;
+    }
+    return count;
+}
+}  // namespace
+
+QUARISMATEST(MemoryMetrics, registry_export_text)
+{
+    metrics_registry registry;
+
+    auto a_allocs = registry.add_counter("allocs_total", "Total allocations", "pool=\"a\"");
+    auto a_bytes  = registry.add_gauge("bytes_in_use", "Bytes in use", "pool=\"a\"");
+    auto b_allocs = registry.add_counter("allocs_total", "Total allocations", "pool=\"b\"");
+
+    a_allocs.increment(3);
+    b_allocs.increment();
+    a_bytes.set(4096);
+    a_bytes.add(-96);
+
+    EXPECT_EQ(registry.value("allocs_total", "pool=\"a\""), 3);
+    EXPECT_EQ(registry.value("bytes_in_use", "pool=\"a\""), 4000);
+    EXPECT_EQ(registry.value("bytes_in_use", "pool=\"b\""), 0);
+
+    const std::string text = registry.export_text();
+    EXPECT_EQ(count_occurrences(text, "# HELP allocs_total Total allocations\n"), 1U);
+    EXPECT_EQ(count_occurrences(text, "# TYPE allocs_total counter\n"), 1U);
+    EXPECT_EQ(count_occurrences(text, "# TYPE bytes_in_use gauge\n"), 1U);
+    EXPECT_NE(
+        text.find("allocs_total{pool=\"a\"} 3\nallocs_total{pool=\"b\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("bytes_in_use{pool=\"a\"} 4000\n"), std::string::npos);
+    EXPECT_EQ(text.find("# EOF"), std::string::npos);
+
+    const std::string openmetrics = registry.export_text(true);
+    EXPECT_EQ(openmetrics.substr(openmetrics.size() - 6), "# EOF\n");
+
+    EXPECT_EQ(registry.remove_series("pool=\"a\""), 2U);
+    EXPECT_EQ(registry.collect().size(), 1U);
+    EXPECT_EQ(registry.export_text().find("pool=\"a\""), std::string::npos);
+
+    metric_counter unbound;
+    unbound.increment();
+    EXPECT_FALSE(unbound.bound());
+    EXPECT_EQ(unbound.value(), 0);
+
+    END_TEST();
+}
+
+QUARISMATEST(MemoryMetrics, registry_bind_reads_source)
+{
+    metrics_registry     registry;
+    std::atomic<int64_t> source{7};
+
+    registry.bind("external", "Owner-maintained value", "", metric_type::gauge, &source);
+    EXPECT_EQ(registry.value("external", ""), 7);
+
+    source.store(42);
+    EXPECT_EQ(registry.value("external", ""), 42);
+    EXPECT_NE(registry.export_text().find("external 42\n"), std::string::npos);
+
+    END_TEST();
+}
+
+QUARISMATEST(MemoryMetrics, registry_exports_latency_summary)
+{
+    metrics_registry  registry;
+    latency_histogram histogram;
+    for (int i = 0; i < 1000; ++i)
+    {
+        histogram.record(i < 998 ? 2000 : 900000);
+    }
+
+    registry.bind_latency("op_latency_ns", "Operation latency", "pool=\"a\"", &histogram);
+    EXPECT_EQ(registry.value("op_latency_ns_count", "pool=\"a\""), 1000);
+    EXPECT_EQ(registry.value("op_latency_ns", "pool=\"a\",quantile=\"0.999\""), 900000);
+
+    const std::string text = registry.export_text();
+    EXPECT_NE(text.find("# TYPE op_latency_ns summary\n"), std::string::npos);
+    EXPECT_NE(text.find("op_latency_ns{pool=\"a\",quantile=\"0.5\"} "), std::string::npos);
+    EXPECT_NE(text.find("op_latency_ns_count{pool=\"a\"} 1000\n"), std::string::npos);
+
+    END_TEST();
+}
+
+QUARISMATEST(MemoryMetrics, statsd_push_formats_and_deltas)
+{
+    metrics_registry registry;
+
+    auto allocs = registry.add_counter("allocs_total", "Total allocations", "allocator=\"main\"");
+    auto bytes  = registry.add_gauge("bytes_in_use", "Bytes in use", "allocator=\"main\"");
+
+    std::vector<std::string> datagrams;
+    statsd_exporter::config  cfg;
+    cfg.prefix = "app";
+
+    auto const      collect = [&datagrams](const std::string& datagram)
+    { datagrams.push_back(datagram); };
+    statsd_exporter exporter(registry, cfg, collect);
+
+    allocs.increment(5);
+    bytes.set(128);
+    EXPECT_EQ(exporter.push_now(), 1U);
+    ASSERT_EQ(datagrams.size(), 1U);
+    EXPECT_EQ(datagrams[0], "app.allocs_total.main:5|c\napp.bytes_in_use.main:128|g");
+
+    // Counters are sent as the delta since the previous push, and skipped when unchanged.
+    datagrams.clear();
+    allocs.increment(2);
+    exporter.push_now();
+    ASSERT_EQ(datagrams.size(), 1U);
+    EXPECT_EQ(datagrams[0], "app.allocs_total.main:2|c\napp.bytes_in_use.main:128|g");
+
+    datagrams.clear();
+    exporter.push_now();
+    ASSERT_EQ(datagrams.size(), 1U);
+    EXPECT_EQ(datagrams[0], "app.bytes_in_use.main:128|g");
+
+    // DogStatsD tags, one line per datagram when the limit is too small for two.
+    cfg.dogstatsd_tags     = true;
+    cfg.max_datagram_bytes = 48;
+    statsd_exporter tagged(registry, cfg, collect);
+
+    datagrams.clear();
+    EXPECT_EQ(tagged.push_now(), 2U);
+    ASSERT_EQ(datagrams.size(), 2U);
+    EXPECT_EQ(datagrams[0], "app.allocs_total:7|c|#allocator:main");
+    EXPECT_EQ(datagrams[1], "app.bytes_in_use:128|g|#allocator:main");
+
+    END_TEST();
+}
+
+#ifndef _WIN32
+QUARISMATEST(MemoryMetrics, statsd_sends_udp)
+{
+    int const receiver = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(receiver, 0);
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = 0;
+    ASSERT_EQ(::bind(receiver, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(::getsockname(receiver, reinterpret_cast<sockaddr*>(&addr), &addr_len), 0);
+
+    timeval timeout{};
+    timeout.tv_sec = 5;
+    ::setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    metrics_registry registry;
+    registry.add_gauge("bytes_in_use", "Bytes in use").set(64);
+
+    statsd_exporter::config cfg;
+    cfg.port     = ntohs(addr.sin_port);
+    cfg.interval = std::chrono::milliseconds(10);
+
+    statsd_exporter exporter(registry, cfg);
+    ASSERT_TRUE(exporter.start());
+    EXPECT_FALSE(exporter.start());
+
+    char          buffer[256];
+    ssize_t const received = ::recv(receiver, buffer, sizeof(buffer), 0);
+    exporter.stop();
+    ::close(receiver);
+
+    ASSERT_GT(received, 0);
+    EXPECT_EQ(std::string(buffer, static_cast<size_t>(received)), "quarisma.bytes_in_use:64|g");
+
+    END_TEST();
+}
+#endif
+
+QUARISMATEST(MemoryMetrics, dashboard_reads_bfc_live_stats)
+{
+    auto allocator = create_metrics_bfc_allocator();
+    ASSERT_NE(allocator->live_stats(), nullptr);
+
+    web_dashboard dashboard;
+    ASSERT_TRUE(dashboard.register_allocator("main", allocator.get()));
+
+    void* ptr = allocator->allocate_raw(64, 4096);
+    ASSERT_NE(ptr, nullptr);
+
+    const auto        stats  = allocator->GetStats();
+    const std::string labels = "allocator=\"main\",type=\"BFC\"";
+    ASSERT_TRUE(stats.has_value());
+    EXPECT_EQ(dashboard.metrics().value("memory_bytes_allocated", labels), stats->bytes_in_use);
+    EXPECT_EQ(dashboard.metrics().value("memory_allocations_total", labels), stats->num_allocs);
+
+    const std::string prometheus = dashboard.export_prometheus_metrics();
+    EXPECT_NE(prometheus.find("# HELP memory_allocations_total"), std::string::npos);
+    EXPECT_NE(
+        prometheus.find(
+            "memory_bytes_allocated{" + labels + "} " + std::to_string(stats->bytes_in_use.load())),
+        std::string::npos);
+    EXPECT_NE(
+        dashboard.get_allocator_metrics_json("main").find("\"num_allocs\": 1"), std::string::npos);
+
+    allocator->deallocate_raw(ptr);
+    EXPECT_EQ(dashboard.metrics().value("memory_bytes_allocated", labels), 0);
+
+    EXPECT_TRUE(dashboard.unregister_allocator("main"));
+    EXPECT_TRUE(dashboard.metrics().collect().empty());
+
+    END_TEST();
+}
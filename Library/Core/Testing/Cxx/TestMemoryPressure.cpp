@@ -0,0 +1,242 @@
+/**
+ * @file TestMemoryPressure.cpp
+ * @brief Tests for the process-wide memory-pressure registry
+ *
+ * Covers:
+ * - Trimming registered caches in rebuild-cost order
+ * - Device filtering and exclusion of the calling cache
+ * - Re-entrant relieve() calls from trim callbacks
+ * - allocator_pool and allocator_bfc trim entry points
+ * - The host memory monitor
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "common/pointer.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/helper/memory_pressure.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+/**
+ * @brief Fake cache recording the order in which it is trimmed
+ */
+struct fake_cache
+{
+    fake_cache(
+        std::vector<std::string>* log,
+        std::string               name,
+        memory_trim_cost          cost,
+        device_enum               device_type,
+        int                       device_index,
+        size_t                    cached)
+        : cached_(cached)
+    {
+        id_ = memory_pressure::instance().register_cache(
+            name,
+            cost,
+            device_type,
+            device_index,
+            [this, log, name](size_t bytes_wanted)
+            {
+                log->push_back(name);
+                const size_t released = std::min(bytes_wanted, cached_);
+                cached_ -= released;
+                return released;
+            });
+    }
+
+    ~fake_cache() { memory_pressure::instance().unregister_cache(id_); }
+
+    fake_cache(const fake_cache&)            = delete;
+    fake_cache& operator=(const fake_cache&) = delete;
+
+    memory_pressure::cache_id id_ = 0;
+    size_t                    cached_;
+};
+
+}  // namespace
+
+QUARISMATEST(MemoryPressure, trims_caches_in_cost_order)
+{
+    // A device type no allocator of the process registers under
+    const device_enum        device = device_enum::PrivateUse1;
+    std::vector<std::string> log;
+    fake_cache               high(&log, "high", memory_trim_cost::HIGH, device, -1, 100);
+    fake_cache               low(&log, "low", memory_trim_cost::LOW, device, -1, 100);
+    fake_cache               medium(&log, "medium", memory_trim_cost::MEDIUM, device, -1, 100);
+
+    const memory_pressure_stats before = memory_pressure::instance().stats();
+    EXPECT_EQ(memory_pressure::instance().relieve(device, -1, 150), 150u);
+    ASSERT_EQ(log.size(), 2u);
+    EXPECT_EQ(log[0], "low");
+    EXPECT_EQ(log[1], "medium");
+    EXPECT_EQ(high.cached_, 100u);
+
+    const memory_pressure_stats after = memory_pressure::instance().stats();
+    EXPECT_EQ(after.relief_requests, before.relief_requests + 1);
+    EXPECT_EQ(after.caches_trimmed, before.caches_trimmed + 2);
+    EXPECT_EQ(after.bytes_released, before.bytes_released + 150);
+
+    // Nothing to trim
+    EXPECT_EQ(memory_pressure::instance().relieve(device, -1, 0), 0u);
+}
+
+QUARISMATEST(MemoryPressure, filters_by_device_and_excludes_caller)
+{
+    const device_enum        device = device_enum::PrivateUse1;
+    std::vector<std::string> log;
+    fake_cache               first(&log, "first", memory_trim_cost::LOW, device, 0, 100);
+    fake_cache               second(&log, "second", memory_trim_cost::LOW, device, 1, 100);
+    fake_cache               shared(&log, "shared", memory_trim_cost::HIGH, device, -1, 100);
+
+    EXPECT_EQ(memory_pressure::instance().relieve(device, 1, 1000, second.id_), 100u);
+    ASSERT_EQ(log.size(), 1u);
+    EXPECT_EQ(log[0], "shared");
+    EXPECT_EQ(first.cached_, 100u);
+    EXPECT_EQ(second.cached_, 100u);
+
+    log.clear();
+    {
+        fake_cache gone(&log, "gone", memory_trim_cost::LOW, device, 0, 100);
+    }
+    // The shared cache is already empty
+    EXPECT_EQ(memory_pressure::instance().relieve(device, 0, 1000), 100u);
+    ASSERT_EQ(log.size(), 2u);
+    EXPECT_EQ(log[0], "first");
+    EXPECT_EQ(log[1], "shared");
+}
+
+QUARISMATEST(MemoryPressure, ignores_reentrant_relief)
+{
+    const device_enum device = device_enum::PrivateUse1;
+    size_t            nested = std::numeric_limits<size_t>::max();
+
+    auto& pressure = memory_pressure::instance();
+    auto  id       = pressure.register_cache(
+        "reentrant",
+        memory_trim_cost::LOW,
+        device,
+        -1,
+        [&](size_t bytes_wanted)
+        {
+            // A trim callback whose own allocation fails must not recurse
+            nested = memory_pressure::instance().relieve(device, -1, bytes_wanted);
+            return size_t{8};
+        });
+
+    EXPECT_EQ(pressure.relieve(device, -1, 8), 8u);
+    EXPECT_EQ(nested, 0u);
+    pressure.unregister_cache(id);
+
+    EXPECT_ANY_THROW(pressure.register_cache(
+        "empty", memory_trim_cost::LOW, device, -1, memory_pressure::trim_function()));
+}
+
+QUARISMATEST(MemoryPressure, releases_allocator_pool_buffers)
+{
+    auto sub_allocator = util::make_ptr_unique_mutable<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+    auto size_rounder = util::make_ptr_unique_mutable<NoopRounder>();
+
+    allocator_pool pool(
+        8, false, std::move(sub_allocator), std::move(size_rounder), "pressure_pool");
+
+    std::vector<void*> ptrs;
+    for (size_t i = 1; i <= 4; ++i)
+    {
+        ptrs.push_back(pool.allocate_raw(64, i * 1024));
+    }
+    for (void* ptr : ptrs)
+    {
+        pool.deallocate_raw(ptr);
+    }
+    const int64_t puts = pool.put_count();
+
+    // The least recently used buffer alone satisfies the request
+    const size_t first = pool.Release(1);
+    EXPECT_GE(first, 1024u);
+    EXPECT_LT(first, 2048u);
+    EXPECT_EQ(pool.put_count(), puts);
+    EXPECT_EQ(pool.evicted_count(), 0);
+
+    // The registered pool is trimmed by a host relief request
+    EXPECT_GE(memory_pressure::instance().relieve(device_enum::CPU, -1, 1 << 30), 9u * 1024u);
+    EXPECT_EQ(pool.Release(1 << 30), 0u);
+
+    void* ptr = pool.allocate_raw(64, 1024);
+    EXPECT_NE(ptr, nullptr);
+    pool.deallocate_raw(ptr);
+}
+
+QUARISMATEST(MemoryPressure, releases_free_bfc_regions)
+{
+    auto sub_alloc = std::make_unique<basic_cpu_allocator>(
+        0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+
+    allocator_bfc::Options opts;
+    opts.allow_growth = true;
+    auto allocator =
+        std::make_unique<allocator_bfc>(std::move(sub_alloc), 64ULL << 20, "pressure_bfc", opts);
+
+    void* held  = allocator->allocate_raw(64, 1024);
+    void* large = allocator->allocate_raw(64, 8ULL << 20);
+    ASSERT_NE(held, nullptr);
+    ASSERT_NE(large, nullptr);
+    allocator->deallocate_raw(large);
+
+    // Only the region of the large allocation is free
+    EXPECT_GE(allocator->ReleaseFreeRegions(), 8ULL << 20);
+    EXPECT_EQ(allocator->ReleaseFreeRegions(), 0u);
+    EXPECT_EQ(allocator->RequestedSize(held), 1024u);
+
+    large = allocator->allocate_raw(64, 8ULL << 20);
+    EXPECT_NE(large, nullptr);
+    allocator->deallocate_raw(large);
+    allocator->deallocate_raw(held);
+
+    EXPECT_GT(memory_pressure::instance().relieve(device_enum::CPU, -1, 1), 0u);
+    EXPECT_EQ(allocator->ReleaseFreeRegions(), 0u);
+}
+
+QUARISMATEST(MemoryPressure, monitor_trims_host_caches_below_watermark)
+{
+    EXPECT_GT(memory_pressure::available_host_memory(), 0);
+
+    std::vector<std::string> log;
+    fake_cache host(&log, "host", memory_trim_cost::LOW, device_enum::CPU, -1, 1 << 20);
+
+    auto&                            pressure = memory_pressure::instance();
+    memory_pressure::monitor_options options;
+    options.low_watermark_bytes = std::numeric_limits<int64_t>::max();
+    options.poll_interval       = std::chrono::milliseconds(1);
+    pressure.start_monitor(options);
+    EXPECT_TRUE(pressure.is_monitoring());
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pressure.stats().monitor_wakeups == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pressure.stop_monitor();
+    EXPECT_FALSE(pressure.is_monitoring());
+
+    EXPECT_GT(pressure.stats().monitor_wakeups, 0u);
+    EXPECT_FALSE(log.empty());
+    EXPECT_EQ(host.cached_, 0u);
+
+    options.poll_interval = std::chrono::milliseconds(0);
+    EXPECT_ANY_THROW(pressure.start_monitor(options));
+}
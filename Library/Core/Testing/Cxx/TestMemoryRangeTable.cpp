@@ -0,0 +1,137 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Test suite for memory_range_table: classification of interior pointers,
+ * registration through sub_allocator visits, and lookups concurrent with
+ * updates.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/helper/memory_range_table.h"
+#include "memory/helper/process_state.h"
+
+namespace quarisma
+{
+
+QUARISMATEST(TestMemoryRangeTable, MemoryRangeTable)
+{
+    auto&        ranges = memory_range_table::instance();
+    size_t const before = ranges.size();
+
+    // Interior pointers and bounds; the addresses are only keys
+    {
+        std::vector<char> storage(4096);
+        char*             base = storage.data();
+
+        ranges.insert(base, 1024, allocator_memory_enum::DEVICE, 1);
+        ranges.insert(base + 2048, 1024, allocator_memory_enum::HOST_PINNED, -1);
+        EXPECT_EQ(ranges.size(), before + 2);
+
+        auto region = ranges.find(base + 1000);
+        ASSERT_TRUE(region.has_value());
+        EXPECT_EQ(region->type, allocator_memory_enum::DEVICE);
+        EXPECT_EQ(region->index, 1);
+        EXPECT_EQ(region->end - region->begin, 1024u);
+        EXPECT_FALSE(ranges.find(base + 1024).has_value());
+        EXPECT_FALSE(ranges.find(base + 3072).has_value());
+
+        auto desc = process_state::singleton()->PtrType(base + 10);
+        EXPECT_EQ(desc.loc, process_state::MemDesc::GPU);
+        EXPECT_EQ(desc.dev_index, 1);
+        desc = process_state::singleton()->PtrType(base + 3000);
+        EXPECT_EQ(desc.loc, process_state::MemDesc::CPU);
+        EXPECT_TRUE(desc.gpu_registered);
+
+        // A new region replaces the ones it overlaps
+        ranges.insert(base + 512, 2048, allocator_memory_enum::HOST_PAGEABLE, 0);
+        EXPECT_EQ(ranges.size(), before + 1);
+        region = ranges.find(base + 600);
+        ASSERT_TRUE(region.has_value());
+        EXPECT_EQ(region->type, allocator_memory_enum::HOST_PAGEABLE);
+        EXPECT_FALSE(ranges.find(base).has_value());
+
+        // Only region bases are erased
+        ranges.erase(base + 600);
+        EXPECT_EQ(ranges.size(), before + 1);
+        ranges.erase(base + 512);
+        EXPECT_EQ(ranges.size(), before);
+        EXPECT_FALSE(ranges.find(base + 600).has_value());
+    }
+
+    // Sub_allocators register their regions through VisitAlloc() and VisitFree()
+    {
+        basic_cpu_allocator sub(
+            0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{});
+        size_t received = 0;
+        void*  ptr      = sub.Alloc(64, 1 << 20, &received);
+        ASSERT_NE(ptr, nullptr);
+
+        auto region = ranges.find(static_cast<char*>(ptr) + received - 1);
+        ASSERT_TRUE(region.has_value());
+        EXPECT_EQ(region->type, sub.GetMemoryType());
+        EXPECT_EQ(region->index, 0);
+
+        sub.Free(ptr, received);
+        EXPECT_FALSE(ranges.find(ptr).has_value());
+    }
+
+    // Lookups run while regions come and go
+    {
+        constexpr size_t  kRegions = 64;
+        std::vector<char> storage(kRegions * 256);
+        char*             base = storage.data();
+        ranges.insert(base, 256, allocator_memory_enum::DEVICE, 0);
+
+        std::atomic<bool>        stop{false};
+        std::atomic<size_t>      misses{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t)
+        {
+            readers.emplace_back(
+                [&]()
+                {
+                    while (!stop.load(std::memory_order_relaxed))
+                    {
+                        if (!ranges.find(base + 100).has_value())
+                        {
+                            misses.fetch_add(1);
+                        }
+                        (void)ranges.find(base + 1000);
+                    }
+                });
+        }
+        for (int round = 0; round < 200; ++round)
+        {
+            for (size_t i = 1; i < kRegions; ++i)
+            {
+                ranges.insert(base + i * 256, 256, allocator_memory_enum::HOST_PAGEABLE, 0);
+            }
+            for (size_t i = 1; i < kRegions; ++i)
+            {
+                ranges.erase(base + i * 256);
+            }
+        }
+        stop.store(true);
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+        EXPECT_EQ(misses.load(), 0u);
+
+        ranges.erase(base);
+        EXPECT_EQ(ranges.size(), before);
+    }
+
+    END_TEST();
+}
+
+}  // namespace quarisma
@@ -86,6 +86,19 @@ static void spawned_worker(void* data)
     }
 }
 
+// Helper that returns only once every thread has arrived, so it deadlocks
+// unless each callback runs on a thread of its own
+static void barrier_worker(void* data)
+{
+    auto* ti      = static_cast<multi_threader::thread_info*>(data);
+    auto* arrived = static_cast<std::atomic<int>*>(ti->user_data);
+    arrived->fetch_add(1, std::memory_order_acq_rel);
+    while (arrived->load(std::memory_order_acquire) < ti->number_of_threads)
+    {
+        std::this_thread::yield();
+    }
+}
+
 // ============================================================================
 // Test Group 1: Basic Functionality
 // ============================================================================
@@ -402,5 +415,92 @@ QUARISMATEST(MultiThreader, Test)
         EXPECT_EQ(counter.load(), QUARISMA_MAX_THREADS);
         delete mt;
     }
+
+    // ============================================================================
+    // Test Group 8: Persistent Thread Pool
+    // ============================================================================
+
+    // Test 19: Thread pool mode defaults and setters
+    {
+        EXPECT_FALSE(multi_threader::get_global_default_use_thread_pool());
+
+        multi_threader* mt = multi_threader::create();
+        EXPECT_FALSE(mt->get_use_thread_pool());
+        mt->set_use_thread_pool(true);
+        EXPECT_TRUE(mt->get_use_thread_pool());
+        delete mt;
+
+        multi_threader::set_global_default_use_thread_pool(true);
+        mt = multi_threader::create();
+        EXPECT_TRUE(mt->get_use_thread_pool());
+        delete mt;
+        multi_threader::set_global_default_use_thread_pool(false);
+    }
+
+    // Test 20: Single method on the pool keeps the thread_info contract
+    {
+        multi_threader* mt = multi_threader::create();
+        mt->set_use_thread_pool(true);
+        mt->set_number_of_threads(4);
+
+        std::atomic<int> counters[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            counters[i].store(0);
+        }
+
+        mt->set_single_method(thread_info_worker, counters);
+        for (int i = 0; i < 100; ++i)
+        {
+            mt->single_method_execute();
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(counters[i].load(), 100);
+        }
+        delete mt;
+    }
+
+    // Test 21: Multiple methods on the pool
+    {
+        multi_threader* mt = multi_threader::create();
+        mt->set_use_thread_pool(true);
+        mt->set_number_of_threads(4);
+
+        std::atomic<int> counters[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            counters[i].store(0);
+        }
+
+        mt->set_multiple_method(0, method_0, counters);
+        mt->set_multiple_method(1, method_1, counters);
+        mt->set_multiple_method(2, method_2, counters);
+        mt->set_multiple_method(3, method_3, counters);
+        mt->multiple_method_execute();
+
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(counters[i].load(), 1);
+        }
+        delete mt;
+    }
+
+    // Test 22: Callbacks on the pool may wait on each other
+    {
+        multi_threader* mt = multi_threader::create();
+        mt->set_use_thread_pool(true);
+        mt->set_number_of_threads(4);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            std::atomic<int> arrived{0};
+            mt->set_single_method(barrier_worker, &arrived);
+            mt->single_method_execute();
+            EXPECT_EQ(arrived.load(), 4);
+        }
+        delete mt;
+    }
 }
 }  // namespace quarisma
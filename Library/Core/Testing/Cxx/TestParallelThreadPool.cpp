@@ -20,6 +20,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <thread>
 #include <vector>
@@ -29,7 +30,10 @@
 // Only compile these tests for std_thread backend
 #if !QUARISMA_HAS_OPENMP && !QUARISMA_HAS_TBB
 
+#include "parallel/parallel_tools.h"
+#include "parallel/std_thread/adaptive_grain.h"
 #include "parallel/std_thread/parallel_thread_pool.h"
+#include "parallel/std_thread/work_stealing_deque.h"
 
 namespace quarisma
 {
@@ -536,6 +540,548 @@ QUARISMATEST(ParallelThreadPool, integration_tests)
     }
 }
 
+// ============================================================================
+// Consolidated Test 11: Work-Stealing Deque and Scheduling Policy
+// ============================================================================
+
+QUARISMATEST(ParallelThreadPool, work_stealing_deque)
+{
+    using deque_type = detail::parallel::work_stealing_deque<std::uint64_t, 8>;
+
+    // Test 1: Owner sees LIFO order, thieves see FIFO order
+    {
+        deque_type deque;
+        EXPECT_TRUE(deque.empty());
+        for (std::uint64_t i = 0; i < 4; ++i)
+        {
+            EXPECT_TRUE(deque.push(i));
+        }
+
+        std::uint64_t value = 0;
+        EXPECT_TRUE(deque.steal(value));
+        EXPECT_EQ(value, 0u);
+        EXPECT_TRUE(deque.pop(value));
+        EXPECT_EQ(value, 3u);
+        EXPECT_TRUE(deque.pop(value));
+        EXPECT_EQ(value, 2u);
+        EXPECT_TRUE(deque.steal(value));
+        EXPECT_EQ(value, 1u);
+        EXPECT_FALSE(deque.pop(value));
+        EXPECT_FALSE(deque.steal(value));
+        EXPECT_TRUE(deque.empty());
+    }
+
+    // Test 2: Bounded capacity
+    {
+        deque_type deque;
+        for (std::uint64_t i = 0; i < deque_type::capacity(); ++i)
+        {
+            EXPECT_TRUE(deque.push(i));
+        }
+        EXPECT_FALSE(deque.push(99));
+    }
+
+    // Test 3: Concurrent thieves never duplicate or lose items
+    {
+        constexpr std::uint64_t                                    total = 20000;
+        detail::parallel::work_stealing_deque<std::uint64_t, 1024> deque;
+        std::vector<std::atomic<int>>                              seen(total);
+        std::atomic<std::uint64_t>                                 taken{0};
+
+        std::vector<std::thread> thieves;
+        for (int t = 0; t < 3; ++t)
+        {
+            thieves.emplace_back(
+                [&]
+                {
+                    std::uint64_t value = 0;
+                    while (taken.load(std::memory_order_acquire) < total)
+                    {
+                        if (deque.steal(value))
+                        {
+                            seen[value].fetch_add(1, std::memory_order_relaxed);
+                            taken.fetch_add(1, std::memory_order_acq_rel);
+                        }
+                    }
+                });
+        }
+
+        std::uint64_t next  = 0;
+        std::uint64_t value = 0;
+        while (next < total)
+        {
+            if (deque.push(next))
+            {
+                ++next;
+            }
+            if ((next & 3) == 0 && deque.pop(value))
+            {
+                seen[value].fetch_add(1, std::memory_order_relaxed);
+                taken.fetch_add(1, std::memory_order_acq_rel);
+            }
+        }
+        while (deque.pop(value))
+        {
+            seen[value].fetch_add(1, std::memory_order_relaxed);
+            taken.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        for (auto& thief : thieves)
+        {
+            thief.join();
+        }
+
+        EXPECT_EQ(taken.load(), total);
+        for (std::uint64_t i = 0; i < total; ++i)
+        {
+            EXPECT_EQ(seen[i].load(std::memory_order_relaxed), 1) << "Item " << i;
+        }
+    }
+}
+
+QUARISMATEST(ParallelThreadPool, work_stealing_parallel_for)
+{
+    using pool_type            = detail::parallel::parallel_thread_pool;
+    pool_type& pool            = pool_type::instance();
+    const auto previous_policy = pool.get_scheduling_policy();
+
+    // Test 1: Every index is visited exactly once, across grains and thread counts
+    for (std::size_t grain : {std::size_t{0}, std::size_t{1}, std::size_t{7}, std::size_t{5000}})
+    {
+        const std::size_t             size = 10007;
+        std::vector<std::atomic<int>> visits(size);
+
+        auto fn = [](void* context, std::size_t from, std::size_t to)
+        {
+            auto& data = *static_cast<std::vector<std::atomic<int>>*>(context);
+            for (std::size_t i = from; i < to; ++i)
+            {
+                data[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+
+        pool.parallel_for_work_stealing(0, size, grain, 0, fn, &visits);
+        pool.parallel_for_work_stealing(0, 0, grain, 0, fn, &visits);  // Empty range
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(visits[i].load(std::memory_order_relaxed), 1) << "Index " << i;
+        }
+    }
+
+    // Test 2: Irregular workloads through parallel_tools with the policy enabled
+    pool.set_scheduling_policy(pool_type::scheduling_policy::work_stealing);
+    EXPECT_EQ(pool.get_scheduling_policy(), pool_type::scheduling_policy::work_stealing);
+    {
+        const std::size_t   size = 4096;
+        std::vector<double> values(size, 0.0);
+        parallel_tools::parallel_for(
+            0,
+            size,
+            16,
+            [&values](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    // The first iterations are far more expensive than the tail
+                    const std::size_t work = (i < 256) ? 2000 : 1;
+                    double            acc  = 0.0;
+                    for (std::size_t k = 0; k < work; ++k)
+                    {
+                        acc += 1.0;
+                    }
+                    values[i] = acc;
+                }
+            });
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(values[i], (i < 256) ? 2000.0 : 1.0) << "Index " << i;
+        }
+    }
+
+    // Test 3: Nested work-stealing loops complete without deadlock
+    {
+        parallel_tools::set_nested_parallelism(true);
+        std::atomic<std::size_t> total{0};
+        parallel_tools::parallel_for(
+            0,
+            8,
+            1,
+            [&total](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    parallel_tools::parallel_for(
+                        0,
+                        100,
+                        10,
+                        [&total](std::size_t b, std::size_t e)
+                        { total.fetch_add(e - b, std::memory_order_relaxed); });
+                }
+            });
+        EXPECT_EQ(total.load(), 800u);
+    }
+
+    pool.set_scheduling_policy(previous_policy);
+    EXPECT_FALSE(pool.is_parallel_scope());
+}
+
+QUARISMATEST(ParallelThreadPool, range_job_submission)
+{
+    using pool_type = detail::parallel::parallel_thread_pool;
+    pool_type& pool = pool_type::instance();
+
+    const auto add_range = [](void* context, std::size_t from, std::size_t to)
+    { static_cast<std::atomic<std::size_t>*>(context)->fetch_add(to - from); };
+
+    // Test 1: Range jobs and std::function jobs can be mixed on one proxy, and
+    // proxies recycled from the cache behave like fresh ones
+    for (int iteration = 0; iteration < 20; ++iteration)
+    {
+        std::atomic<std::size_t> total{0};
+        std::atomic<int>         generic{0};
+
+        auto proxy = pool.allocate_threads();
+        for (std::size_t from = 0; from < 1000; from += 10)
+        {
+            proxy.do_job(add_range, &total, from, from + 10);
+        }
+        proxy.do_job([&generic] { generic.fetch_add(1); });
+        proxy.join();
+
+        ASSERT_EQ(total.load(), 1000u);
+        ASSERT_EQ(generic.load(), 1);
+    }
+
+    // Test 2: Nested proxies submitting range jobs from inside the pool
+    {
+        std::atomic<std::size_t> total{0};
+        auto                     outer = pool.allocate_threads();
+        for (int i = 0; i < 4; ++i)
+        {
+            outer.do_job(
+                [&pool, &total, add_range]
+                {
+                    auto inner = pool.allocate_threads();
+                    for (std::size_t from = 0; from < 100; from += 5)
+                    {
+                        inner.do_job(add_range, &total, from, from + 5);
+                    }
+                    inner.join();
+                });
+        }
+        outer.join();
+        EXPECT_EQ(total.load(), 400u);
+    }
+
+    EXPECT_FALSE(pool.is_parallel_scope());
+}
+
+QUARISMATEST(ParallelThreadPool, local_scope_thread_budget)
+{
+    using pool_type            = detail::parallel::parallel_thread_pool;
+    pool_type& pool            = pool_type::instance();
+    const auto previous_policy = pool.get_scheduling_policy();
+    const auto budget          = (std::min)(std::size_t{2}, pool.thread_count());
+
+    // Test 1: Top-level proxies are capped by the scope budget
+    parallel_tools::local_scope(
+        parallel_tools::config(static_cast<int>(budget)),
+        [&pool, budget]()
+        {
+            auto proxy = pool.allocate_threads();
+            EXPECT_EQ(proxy.get_threads().size(), budget);
+            proxy.join();
+        });
+    {
+        auto proxy = pool.allocate_threads();
+        EXPECT_EQ(proxy.get_threads().size(), pool.thread_count());
+        proxy.join();
+    }
+
+    // Test 2: Nested loops never run on more threads than the budget
+    for (auto policy :
+         {pool_type::scheduling_policy::round_robin, pool_type::scheduling_policy::work_stealing})
+    {
+        pool.set_scheduling_policy(policy);
+
+        std::atomic<std::size_t> active{0};
+        std::atomic<std::size_t> peak{0};
+        std::atomic<std::size_t> total{0};
+        parallel_tools::local_scope(
+            parallel_tools::config(static_cast<int>(budget), "", true),
+            [&]()
+            {
+                parallel_tools::parallel_for(
+                    0,
+                    8,
+                    1,
+                    [&](std::size_t begin, std::size_t end)
+                    {
+                        for (std::size_t i = begin; i < end; ++i)
+                        {
+                            parallel_tools::parallel_for(
+                                0,
+                                64,
+                                4,
+                                [&](std::size_t b, std::size_t e)
+                                {
+                                    const std::size_t now = active.fetch_add(1) + 1;
+                                    std::size_t       seen = peak.load();
+                                    while (now > seen && !peak.compare_exchange_weak(seen, now))
+                                    {
+                                    }
+                                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                                    total.fetch_add(e - b, std::memory_order_relaxed);
+                                    active.fetch_sub(1);
+                                });
+                        }
+                    });
+            });
+
+        EXPECT_EQ(total.load(), 8u * 64u);
+        EXPECT_LE(peak.load(), budget);
+    }
+
+    pool.set_scheduling_policy(previous_policy);
+    EXPECT_FALSE(pool.is_parallel_scope());
+}
+
+QUARISMATEST(ParallelThreadPool, adaptive_grain)
+{
+    using pool_type = detail::parallel::parallel_thread_pool;
+    using site_type = detail::parallel::adaptive_grain_site;
+
+    // Test 1: Grain sizing rules
+    EXPECT_EQ(site_type::grain(0.0, 1000, 4), 250u);           // Unknown cost
+    EXPECT_EQ(site_type::grain(1.0, 1000000, 4), 50000u);      // 50 us of 1 ns items
+    EXPECT_EQ(site_type::grain(0.001, 1000000, 4), 250000u);   // One chunk per thread
+    EXPECT_EQ(site_type::grain(1.0e9, 1000, 4), 1u);           // Expensive items
+    EXPECT_EQ(site_type::probe_size(6400, 4), 25u);
+    EXPECT_EQ(site_type::probe_size(10, 4), 1u);
+    EXPECT_TRUE(site_type::run_serially(1.0, 1000));
+    EXPECT_FALSE(site_type::run_serially(1.0, 1000000));
+    EXPECT_FALSE(site_type::run_serially(0.0, 10));
+
+    site_type site;
+    EXPECT_LE(site.cost(), 0.0);
+    site.update(10.0);
+    EXPECT_DOUBLE_EQ(site.cost(), 10.0);
+    site.update(20.0);
+    EXPECT_DOUBLE_EQ(site.cost(), 15.0);
+    site.update(-1.0);  // Ignored
+    EXPECT_DOUBLE_EQ(site.cost(), 15.0);
+
+    // Test 2: Cheap and expensive loops visit every index exactly once, both
+    // on the first (probing) call and on later calls using the learned cost
+    pool_type& pool            = pool_type::instance();
+    const auto previous_policy = pool.get_grain_policy();
+    pool.set_grain_policy(pool_type::grain_policy::adaptive);
+    EXPECT_EQ(pool.get_grain_policy(), pool_type::grain_policy::adaptive);
+
+    for (int call = 0; call < 3; ++call)
+    {
+        const std::size_t             size = 200000;
+        std::vector<std::atomic<int>> cheap(size);
+        parallel_tools::parallel_for(
+            0,
+            size,
+            0,
+            [&cheap](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    cheap[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+
+        std::vector<std::atomic<int>> expensive(64);
+        parallel_tools::parallel_for(
+            0,
+            expensive.size(),
+            0,
+            [&expensive](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    expensive[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(cheap[i].load(std::memory_order_relaxed), 1)
+                << "Call " << call << " index " << i;
+        }
+        for (std::size_t i = 0; i < expensive.size(); ++i)
+        {
+            ASSERT_EQ(expensive[i].load(std::memory_order_relaxed), 1)
+                << "Call " << call << " index " << i;
+        }
+    }
+
+    pool.set_grain_policy(previous_policy);
+}
+
+QUARISMATEST(ParallelThreadPool, affinity_and_numa_split)
+{
+    using pool_type            = detail::parallel::parallel_thread_pool;
+    pool_type& pool            = pool_type::instance();
+    const auto previous_policy = pool.get_affinity_policy();
+
+    EXPECT_EQ(pool.get_thread_numa_node(), -1);  // Not a pool thread
+
+    // Test 1: Direct NUMA-split loops visit every index exactly once
+    pool.set_affinity_policy(pool_type::affinity_policy::numa);
+    EXPECT_EQ(pool.get_affinity_policy(), pool_type::affinity_policy::numa);
+    for (std::size_t grain : {std::size_t{1}, std::size_t{13}, std::size_t{100000}})
+    {
+        const std::size_t             size = 10007;
+        std::vector<std::atomic<int>> visits(size);
+        pool.parallel_for_numa(
+            0,
+            size,
+            grain,
+            0,
+            [](void* context, std::size_t from, std::size_t to)
+            {
+                auto& data = *static_cast<std::vector<std::atomic<int>>*>(context);
+                for (std::size_t i = from; i < to; ++i)
+                {
+                    data[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            },
+            &visits);
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(visits[i].load(std::memory_order_relaxed), 1) << "Index " << i;
+        }
+    }
+
+    // Test 2: parallel_tools routes through the NUMA split and workers report a node
+    {
+        std::atomic<int>              bad_node{0};
+        std::vector<std::atomic<int>> visits(5000);
+        parallel_tools::parallel_for(
+            0,
+            visits.size(),
+            50,
+            [&pool, &visits, &bad_node](std::size_t begin, std::size_t end)
+            {
+                if (pool.is_parallel_scope() && pool.get_thread_numa_node() < 0)
+                {
+                    bad_node.fetch_add(1);
+                }
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    visits[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+
+        EXPECT_EQ(bad_node.load(), 0);
+        for (auto& visit : visits)
+        {
+            ASSERT_EQ(visit.load(std::memory_order_relaxed), 1);
+        }
+    }
+
+    // Test 3: Pinned workers still run jobs, and unpinning restores the default
+    pool.set_affinity_policy(pool_type::affinity_policy::pinned);
+    {
+        std::atomic<int> done{0};
+        auto             proxy = pool.allocate_threads();
+        for (std::size_t i = 0; i < pool.thread_count(); ++i)
+        {
+            proxy.do_job([&done] { done.fetch_add(1); });
+        }
+        proxy.join();
+        EXPECT_EQ(done.load(), static_cast<int>(pool.thread_count()));
+    }
+
+    pool.set_affinity_policy(previous_policy);
+    EXPECT_EQ(pool.get_affinity_policy(), previous_policy);
+}
+
+QUARISMATEST(ParallelThreadPool, wait_policy)
+{
+    using pool_type = detail::parallel::parallel_thread_pool;
+
+    pool_type& pool            = pool_type::instance();
+    const auto previous_policy = pool.get_wait_policy();
+
+    // Back-to-back small loops, plus a pause long enough for hybrid workers
+    // to give up spinning and block
+    for (const auto policy :
+         {pool_type::wait_policy::hybrid,
+          pool_type::wait_policy::active,
+          pool_type::wait_policy::passive})
+    {
+        pool.set_wait_policy(policy);
+        EXPECT_EQ(pool.get_wait_policy(), policy);
+
+        for (int round = 0; round < 2; ++round)
+        {
+            std::atomic<std::size_t> total{0};
+            for (int call = 0; call < 200; ++call)
+            {
+                parallel_tools::parallel_for(
+                    0,
+                    64,
+                    1,
+                    [&total](std::size_t begin, std::size_t end) { total.fetch_add(end - begin); });
+            }
+            EXPECT_EQ(total.load(), 200u * 64u);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    pool.set_wait_policy(previous_policy);
+    EXPECT_EQ(pool.get_wait_policy(), previous_policy);
+}
+
+QUARISMATEST(ParallelThreadPool, post)
+{
+    auto& pool = detail::parallel::parallel_thread_pool::instance();
+
+    // Posted jobs run without a proxy to join
+    const int        jobs = 200;
+    std::atomic<int> done{0};
+    for (int i = 0; i < jobs; ++i)
+    {
+        pool.post([&done] { done.fetch_add(1, std::memory_order_release); });
+    }
+
+    // A posted job may run a parallel loop and allocate its own proxy
+    std::atomic<std::size_t> total{0};
+    std::atomic<bool>        in_pool{false};
+    pool.post(
+        [&pool, &total, &in_pool]
+        {
+            in_pool.store(pool.is_parallel_scope());
+            auto proxy = pool.allocate_threads();
+            for (std::size_t i = 0; i < 64; ++i)
+            {
+                proxy.do_job([&total] { total.fetch_add(1); });
+            }
+            proxy.join();
+            pool.post([&total] { total.fetch_add(1000); });
+        });
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((done.load(std::memory_order_acquire) < jobs || total.load() < 1064) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(done.load(), jobs);
+    EXPECT_EQ(total.load(), 1064u);
+    EXPECT_TRUE(in_pool.load());
+}
+
 }  // namespace quarisma
 
 #endif  // !QUARISMA_HAS_OPENMP && !QUARISMA_HAS_TBB
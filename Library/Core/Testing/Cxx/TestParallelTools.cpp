@@ -17,7 +17,14 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "Testing/baseTest.h"
@@ -501,6 +508,433 @@ QUARISMATEST(ParallelTools, test)
                 << "Data race detected at index " << i;
         }
     }
+
+    // ============================================================================
+    // Consolidated Test 10: Local Scope Configuration
+    // ============================================================================
+
+    {
+        const int  default_threads = parallel_tools::estimated_number_of_threads();
+        const bool default_nested  = parallel_tools::nested_parallelism();
+        const int  budget =
+            (std::min)(2, parallel_tools::estimated_default_number_of_threads());
+
+        // Test 1: Thread budget and nesting policy are visible inside the scope only
+        parallel_tools::local_scope(
+            parallel_tools::config(budget, "", !default_nested),
+            [budget, default_nested]()
+            {
+                EXPECT_EQ(parallel_tools::estimated_number_of_threads(), budget);
+                EXPECT_EQ(parallel_tools::nested_parallelism(), !default_nested);
+            });
+        EXPECT_EQ(parallel_tools::estimated_number_of_threads(), default_threads);
+        EXPECT_EQ(parallel_tools::nested_parallelism(), default_nested);
+
+        // Test 2: Scopes nest and restore the enclosing scope
+        parallel_tools::local_scope(
+            parallel_tools::config(budget),
+            [budget]()
+            {
+                parallel_tools::local_scope(
+                    parallel_tools::config(1),
+                    []() { EXPECT_EQ(parallel_tools::estimated_number_of_threads(), 1); });
+                EXPECT_EQ(parallel_tools::estimated_number_of_threads(), budget);
+            });
+
+        // Test 3: The configuration is restored when the functor throws
+        EXPECT_THROW(
+            parallel_tools::local_scope(
+                parallel_tools::config(1), []() { throw std::runtime_error("scope"); }),
+            std::runtime_error);
+        EXPECT_EQ(parallel_tools::estimated_number_of_threads(), default_threads);
+
+        // Test 4: Concurrent scopes on different threads do not interfere
+        std::atomic<int> mismatches{0};
+        auto             scoped_worker = [&mismatches](int threads)
+        {
+            parallel_tools::local_scope(
+                parallel_tools::config(threads),
+                [&mismatches, threads]()
+                {
+                    std::vector<std::atomic<int>> hits(1000);
+                    for (int iter = 0; iter < 20; ++iter)
+                    {
+                        if (parallel_tools::estimated_number_of_threads() != threads)
+                        {
+                            mismatches.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        parallel_tools::parallel_for(
+                            0,
+                            hits.size(),
+                            10,
+                            [&hits](size_t begin, size_t end)
+                            {
+                                for (size_t i = begin; i < end; ++i)
+                                {
+                                    hits[i].fetch_add(1, std::memory_order_relaxed);
+                                }
+                            });
+                    }
+                    for (auto& hit : hits)
+                    {
+                        if (hit.load(std::memory_order_relaxed) != 20)
+                        {
+                            mismatches.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                });
+        };
+
+        std::thread first(scoped_worker, 1);
+        std::thread second(scoped_worker, budget);
+        first.join();
+        second.join();
+        EXPECT_EQ(mismatches.load(), 0);
+        EXPECT_EQ(parallel_tools::estimated_number_of_threads(), default_threads);
+
+        // Test 5: A nested scope with another budget runs inside the outer scope's loop
+        const int                     outer_budget = budget + 1;
+        std::vector<std::atomic<int>> nested_hits(64 * 64);
+        parallel_tools::local_scope(
+            parallel_tools::config(outer_budget, "", true),
+            [&nested_hits]()
+            {
+                parallel_tools::parallel_for(
+                    0,
+                    64,
+                    1,
+                    [&nested_hits](size_t begin, size_t end)
+                    {
+                        for (size_t row = begin; row < end; ++row)
+                        {
+                            parallel_tools::local_scope(
+                                parallel_tools::config(1, "", true),
+                                [&nested_hits, row]()
+                                {
+                                    parallel_tools::parallel_for(
+                                        0,
+                                        64,
+                                        8,
+                                        [&nested_hits, row](size_t first, size_t last)
+                                        {
+                                            for (size_t col = first; col < last; ++col)
+                                            {
+                                                nested_hits[row * 64 + col].fetch_add(
+                                                    1, std::memory_order_relaxed);
+                                            }
+                                        });
+                                });
+                        }
+                    });
+            });
+        int nested_misses = 0;
+        for (auto& hit : nested_hits)
+        {
+            nested_misses += hit.load(std::memory_order_relaxed) != 1 ? 1 : 0;
+        }
+        EXPECT_EQ(nested_misses, 0);
+        EXPECT_EQ(parallel_tools::estimated_number_of_threads(), default_threads);
+    }
+
+    // ============================================================================
+    // Consolidated Test 11: Parallel Reduce and Scan
+    // ============================================================================
+
+    {
+        // Test 1: Sum reduction across grains, including a grain larger than the range
+        const size_t size = 100003;
+        for (size_t grain : {size_t{0}, size_t{1}, size_t{1000}, size_t{1000000}})
+        {
+            const auto sum = parallel_tools::parallel_reduce(
+                0,
+                size,
+                grain,
+                std::uint64_t{0},
+                [](size_t begin, size_t end)
+                {
+                    std::uint64_t acc = 0;
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        acc += i;
+                    }
+                    return acc;
+                },
+                [](std::uint64_t a, std::uint64_t b) { return a + b; });
+            EXPECT_EQ(sum, std::uint64_t{size} * (size - 1) / 2) << "grain " << grain;
+        }
+
+        // Test 2: Non-commutative combine keeps the block order
+        const auto concatenated = parallel_tools::parallel_reduce(
+            0,
+            26,
+            1,
+            std::string(),
+            [](size_t begin, size_t end)
+            {
+                std::string part;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    part += static_cast<char>('a' + i);
+                }
+                return part;
+            },
+            [](const std::string& a, const std::string& b) { return a + b; });
+        EXPECT_EQ(concatenated, "abcdefghijklmnopqrstuvwxyz");
+
+        // Test 3: Empty range returns the identity
+        EXPECT_EQ(
+            parallel_tools::parallel_reduce(
+                5, 5, 0, 42, [](size_t, size_t) { return 0; }, [](int a, int b) { return a + b; }),
+            42);
+
+        // Test 4: Inclusive and exclusive scans match the serial prefix sums
+        std::vector<std::int64_t> input(size);
+        std::iota(input.begin(), input.end(), std::int64_t{-500});
+
+        std::vector<std::int64_t> expected_inclusive(size);
+        std::partial_sum(input.begin(), input.end(), expected_inclusive.begin());
+
+        std::vector<std::int64_t> output(size);
+        const auto                total = parallel_tools::parallel_scan(
+            input.begin(),
+            size,
+            output.begin(),
+            std::int64_t{0},
+            [](std::int64_t a, std::int64_t b) { return a + b; });
+        EXPECT_EQ(output, expected_inclusive);
+        EXPECT_EQ(total, expected_inclusive.back());
+
+        parallel_tools::parallel_scan(
+            input.data(),
+            size,
+            output.data(),
+            std::int64_t{0},
+            [](std::int64_t a, std::int64_t b) { return a + b; },
+            parallel_tools::scan_type::exclusive,
+            97);
+        EXPECT_EQ(output[0], 0);
+        for (size_t i = 1; i < size; ++i)
+        {
+            ASSERT_EQ(output[i], expected_inclusive[i - 1]) << "Index " << i;
+        }
+
+        // Test 5: In-place scan
+        std::vector<std::int64_t> in_place(input);
+        parallel_tools::parallel_scan(
+            in_place.begin(),
+            size,
+            in_place.begin(),
+            std::int64_t{0},
+            [](std::int64_t a, std::int64_t b) { return a + b; });
+        EXPECT_EQ(in_place, expected_inclusive);
+    }
+
+    // ============================================================================
+    // Consolidated Test 12: Deterministic Mode
+    // ============================================================================
+
+    {
+        EXPECT_FALSE(parallel_tools::deterministic());
+        parallel_tools::set_deterministic(true);
+        EXPECT_TRUE(parallel_tools::deterministic());
+
+        const int    default_threads = parallel_tools::estimated_default_number_of_threads();
+        const size_t size            = 1000003;
+
+        // Terms of alternating sign and very different magnitudes: any change in
+        // the block boundaries or in the combine order changes the rounding.
+        auto sum_with = [size](int threads)
+        {
+            double sum = 0.0;
+            parallel_tools::local_scope(
+                parallel_tools::config(threads),
+                [&sum, size]()
+                {
+                    sum = parallel_tools::parallel_reduce(
+                        0,
+                        size,
+                        0,
+                        0.0,
+                        [](size_t begin, size_t end)
+                        {
+                            double acc = 0.0;
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                const double sign = (i % 3 == 0) ? -1.0 : 1.0;
+                                acc += sign * (1e8 / static_cast<double>(i + 1) + 0.1 * i);
+                            }
+                            return acc;
+                        },
+                        [](double a, double b) { return a + b; });
+                });
+            return sum;
+        };
+
+        auto chunks_with = [size](int threads)
+        {
+            std::mutex                                       mutex;
+            std::vector<std::pair<std::size_t, std::size_t>> chunks;
+            parallel_tools::local_scope(
+                parallel_tools::config(threads),
+                [&mutex, &chunks, size]()
+                {
+                    parallel_tools::parallel_for(
+                        0,
+                        size,
+                        0,
+                        [&mutex, &chunks](size_t begin, size_t end)
+                        {
+                            const std::lock_guard<std::mutex> lock(mutex);
+                            chunks.emplace_back(begin, end);
+                        });
+                });
+            std::sort(chunks.begin(), chunks.end());
+            return chunks;
+        };
+
+        // Test 1: Reductions are bit-identical whatever the thread count
+        const double reference = sum_with(1);
+        for (int threads : {2, 3, default_threads})
+        {
+            EXPECT_EQ(sum_with(threads), reference) << "threads " << threads;
+        }
+
+        // Test 2: parallel_for with a zero grain uses the same chunks for any thread count
+        const auto reference_chunks = chunks_with(1);
+        EXPECT_LE(
+            reference_chunks.size(),
+            quarisma::detail::parallel::parallel_tools_api::deterministic_max_blocks);
+        for (int threads : {2, 3, default_threads})
+        {
+            EXPECT_EQ(chunks_with(threads), reference_chunks) << "threads " << threads;
+        }
+
+        // Test 3: The tree combine keeps the operand order
+        const auto concatenated = parallel_tools::parallel_reduce(
+            0,
+            1000,
+            1,
+            std::string(),
+            [](size_t begin, size_t end)
+            {
+                std::string part;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    part += static_cast<char>('a' + i % 26);
+                }
+                return part;
+            },
+            [](const std::string& a, const std::string& b) { return a + b; });
+        ASSERT_EQ(concatenated.size(), 1000u);
+        for (size_t i = 0; i < concatenated.size(); ++i)
+        {
+            ASSERT_EQ(concatenated[i], static_cast<char>('a' + i % 26)) << "Index " << i;
+        }
+
+        parallel_tools::set_deterministic(false);
+        EXPECT_FALSE(parallel_tools::deterministic());
+    }
+
+    // ============================================================================
+    // Consolidated Test 13: Iterator Algorithms
+    // ============================================================================
+
+    {
+        // Sizes below and above the serial threshold
+        for (size_t size : {size_t{1000}, parallel_tools::THRESHOLD + 12345})
+        {
+            std::vector<std::int64_t> values(size);
+            std::uint64_t             state = 12345;
+            for (auto& value : values)
+            {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                value = static_cast<std::int64_t>(state >> 40) % 5000 - 2500;
+            }
+
+            // Test 1: sort matches std::sort, with the default and a custom order
+            std::vector<std::int64_t> expected(values);
+            std::sort(expected.begin(), expected.end());
+            std::vector<std::int64_t> sorted(values);
+            parallel_tools::sort(sorted.begin(), sorted.end());
+            EXPECT_EQ(sorted, expected) << "size " << size;
+
+            std::sort(expected.begin(), expected.end(), std::greater<>());
+            parallel_tools::sort(sorted.data(), sorted.data() + size, std::greater<>());
+            EXPECT_EQ(sorted, expected) << "size " << size;
+
+            // Test 2: sort moves non-trivial values
+            std::vector<std::string> words(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                words[i] = std::to_string(values[i]);
+            }
+            std::vector<std::string> expected_words(words);
+            std::sort(expected_words.begin(), expected_words.end());
+            parallel_tools::sort(words.begin(), words.end());
+            EXPECT_EQ(words, expected_words) << "size " << size;
+
+            // Test 3: partition keeps the relative order of both groups
+            auto                      is_even = [](std::int64_t v) { return v % 2 == 0; };
+            std::vector<std::int64_t> expected_partition(values);
+            const auto                expected_split = std::stable_partition(
+                expected_partition.begin(), expected_partition.end(), is_even);
+            std::vector<std::int64_t> partitioned(values);
+            const auto                split =
+                parallel_tools::partition(partitioned.begin(), partitioned.end(), is_even);
+            EXPECT_EQ(partitioned, expected_partition) << "size " << size;
+            EXPECT_EQ(
+                split - partitioned.begin(), expected_split - expected_partition.begin());
+
+            // Test 4: transform, unary and binary, and for_each
+            std::vector<double> doubled(size);
+            parallel_tools::transform(
+                values.begin(),
+                values.end(),
+                doubled.begin(),
+                [](std::int64_t v) { return 2.0 * static_cast<double>(v); });
+            std::vector<std::int64_t> sums(size);
+            parallel_tools::transform(
+                values.begin(),
+                values.end(),
+                values.begin(),
+                sums.begin(),
+                [](std::int64_t a, std::int64_t b) { return a + b; });
+            parallel_tools::for_each(sums.begin(), sums.end(), [](std::int64_t& v) { v += 1; });
+            for (size_t i = 0; i < size; ++i)
+            {
+                ASSERT_EQ(doubled[i], 2.0 * static_cast<double>(values[i])) << "Index " << i;
+                ASSERT_EQ(sums[i], 2 * values[i] + 1) << "Index " << i;
+            }
+
+            // Test 5: inclusive_scan matches std::partial_sum, in place too
+            std::vector<std::int64_t> expected_scan(size);
+            std::partial_sum(values.begin(), values.end(), expected_scan.begin());
+            std::vector<std::int64_t> scanned(size);
+            const auto end = parallel_tools::inclusive_scan(
+                values.begin(), values.end(), scanned.begin());
+            EXPECT_EQ(scanned, expected_scan) << "size " << size;
+            EXPECT_TRUE(end == scanned.end());
+
+            std::vector<std::int64_t> in_place(values);
+            parallel_tools::inclusive_scan(
+                in_place.begin(),
+                in_place.end(),
+                in_place.begin(),
+                [](std::int64_t a, std::int64_t b) { return a + b; },
+                std::int64_t{0});
+            EXPECT_EQ(in_place, expected_scan) << "size " << size;
+        }
+
+        // Test 6: Empty ranges
+        std::vector<int> empty;
+        parallel_tools::sort(empty.begin(), empty.end());
+        EXPECT_TRUE(
+            parallel_tools::partition(empty.begin(), empty.end(), [](int) { return true; }) ==
+            empty.end());
+        EXPECT_TRUE(
+            parallel_tools::inclusive_scan(empty.begin(), empty.end(), empty.begin()) ==
+            empty.begin());
+    }
 }
 
 }  // namespace quarisma
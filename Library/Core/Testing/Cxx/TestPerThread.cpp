@@ -0,0 +1,173 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "util/per_thread.h"
+
+namespace quarisma
+{
+namespace
+{
+// One registry per type: each test counts its own instances
+template <int Tag>
+struct counter
+{
+    counter() { live.fetch_add(1); }
+    ~counter() { live.fetch_sub(1); }
+
+    int64_t value = 0;
+
+    static inline std::atomic<int> live{0};
+};
+
+template <typename F>
+void run_thread(F&& f)
+{
+    std::thread thread(std::forward<F>(f));
+    thread.join();
+}
+}  // namespace
+
+QUARISMATEST(PerThread, instances)
+{
+    using type = counter<0>;
+
+    type& mine = per_thread<type>::Get();
+    EXPECT_EQ(&per_thread<type>::Get(), &mine);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(&mine) % 64, 0U);
+
+    // Every thread has its own instance, destroyed with the thread
+    type* theirs = nullptr;
+    run_thread(
+        [&]
+        {
+            theirs = &per_thread<type>::Get();
+            EXPECT_EQ(type::live.load(), 2);
+        });
+    EXPECT_NE(theirs, &mine);
+    EXPECT_EQ(type::live.load(), 1);
+
+    // The slot of the exited thread is reused
+    type* next = nullptr;
+    run_thread([&] { next = &per_thread<type>::Get(); });
+    EXPECT_EQ(next, theirs);
+
+    // ForEachThread visits the same instances as GetAll
+    mine.value = 3;
+    std::vector<std::shared_ptr<type>> const all = per_thread<type>::GetAll();
+    ASSERT_EQ(all.size(), 1U);
+    EXPECT_EQ(all[0].get(), &mine);
+    int64_t sum = 0;
+    per_thread<type>::ForEachThread([&](type& instance) { sum += instance.value; });
+    EXPECT_EQ(sum, 3);
+
+    END_TEST();
+}
+
+QUARISMATEST(PerThread, recording)
+{
+    using type = counter<1>;
+
+    per_thread<type>::Get().value = 1;
+    EXPECT_EQ(per_thread<type>::StartRecording().size(), 1U);
+
+    // Instances of threads exiting while recording survive until StopRecording
+    constexpr int threads = 8;
+    for (int i = 0; i < threads; ++i)
+    {
+        run_thread([i] { per_thread<type>::Get().value = 10 + i; });
+    }
+    EXPECT_EQ(type::live.load(), threads + 1);
+    EXPECT_EQ(per_thread<type>::GetAll().size(), static_cast<size_t>(threads + 1));
+
+    std::vector<std::shared_ptr<type>> recorded = per_thread<type>::StopRecording();
+    ASSERT_EQ(recorded.size(), static_cast<size_t>(threads + 1));
+    int64_t sum = 0;
+    for (auto const& instance : recorded)
+    {
+        sum += instance->value;
+    }
+    EXPECT_EQ(sum, 1 + threads * 10 + threads * (threads - 1) / 2);
+    EXPECT_EQ(per_thread<type>::GetAll().size(), 1U);
+
+    // A slot is only reused once the last shared_ptr to its instance is gone
+    type* const           mine = &per_thread<type>::Get();
+    std::shared_ptr<type> kept;
+    for (auto const& instance : recorded)
+    {
+        if (instance.get() != mine)
+        {
+            kept = instance;
+        }
+    }
+    recorded.clear();
+    EXPECT_EQ(type::live.load(), 2);
+    type* reused = nullptr;
+    run_thread([&] { reused = &per_thread<type>::Get(); });
+    EXPECT_NE(reused, kept.get());
+    kept.reset();
+    EXPECT_EQ(type::live.load(), 1);
+
+    END_TEST();
+}
+
+QUARISMATEST(PerThread, concurrent_registration)
+{
+    using type = counter<2>;
+
+    // Threads register, exit and reuse slots while another one aggregates
+    constexpr int     threads = 4;
+    constexpr int     rounds  = 50;
+    std::atomic<bool> done{false};
+    std::thread       reader(
+        [&]
+        {
+            while (!done.load())
+            {
+                int64_t sum = 0;
+                per_thread<type>::ForEachThread([&](type& instance) { sum += instance.value; });
+                EXPECT_GE(sum, 0);
+                EXPECT_LE(per_thread<type>::GetAll().size(), static_cast<size_t>(threads));
+            }
+        });
+    for (int round = 0; round < rounds; ++round)
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([] { per_thread<type>::Get().value += 1; });
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+    done.store(true);
+    reader.join();
+    EXPECT_EQ(type::live.load(), 0);
+
+    END_TEST();
+}
+}  // namespace quarisma
@@ -0,0 +1,209 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Tests for pool_instrumentation: queue-wait and utilization counters of
+ * parallel_thread_pool and threaded_callback_queue, and their profiler report.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "parallel/pool_instrumentation.h"
+#include "parallel/threaded_callback_queue.h"
+
+#if !QUARISMA_HAS_OPENMP && !QUARISMA_HAS_TBB
+#include "parallel/std_thread/parallel_thread_pool.h"
+#endif
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/session/profiler.h"
+#include "profiler/native/session/profiler_report.h"
+#endif
+
+using quarisma::pool_instrumentation;
+
+namespace
+{
+std::vector<pool_instrumentation::worker_stats> stats_of(const std::string& pool)
+{
+    std::vector<pool_instrumentation::worker_stats> result;
+    for (auto& stats : pool_instrumentation::collect())
+    {
+        if (stats.pool_ == pool)
+        {
+            result.push_back(std::move(stats));
+        }
+    }
+    return result;
+}
+
+uint64_t total_jobs(const std::vector<pool_instrumentation::worker_stats>& workers)
+{
+    uint64_t jobs = 0;
+    for (const auto& w : workers)
+    {
+        jobs += w.jobs_;
+    }
+    return jobs;
+}
+}  // namespace
+
+QUARISMATEST(PoolInstrumentation, wait_buckets)
+{
+    EXPECT_EQ(pool_instrumentation::wait_bucket(0), 0U);
+    EXPECT_EQ(pool_instrumentation::wait_bucket(999), 0U);
+    EXPECT_EQ(pool_instrumentation::wait_bucket(1000), 1U);
+    EXPECT_EQ(pool_instrumentation::wait_bucket(1999), 1U);
+    EXPECT_EQ(pool_instrumentation::wait_bucket(2000), 2U);
+    EXPECT_EQ(pool_instrumentation::wait_bucket(1000 * 1000), 10U);
+    EXPECT_EQ(
+        pool_instrumentation::wait_bucket(INT64_C(1) << 62),
+        pool_instrumentation::wait_buckets - 1);
+
+    for (size_t b = 0; b + 1 < pool_instrumentation::wait_buckets; ++b)
+    {
+        int64_t const limit = pool_instrumentation::wait_bucket_limit_ns(b);
+        EXPECT_EQ(pool_instrumentation::wait_bucket(limit - 1), b);
+        EXPECT_EQ(pool_instrumentation::wait_bucket(limit), b + 1);
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(PoolInstrumentation, callback_queue_counts_jobs)
+{
+    // Nothing is measured while disabled
+    pool_instrumentation::reset();
+    {
+        threaded_callback_queue queue;
+        queue.push([] {})->wait();
+    }
+    EXPECT_TRUE(stats_of("threaded_callback_queue").empty());
+
+    // A worker records its job after the future is ready, so the queue is
+    // destroyed, joining the workers, before the counters are read.
+    pool_instrumentation::set_enabled(true);
+    {
+        threaded_callback_queue queue;
+        queue.set_number_of_threads(2);
+
+        std::vector<threaded_callback_queue::shared_future_base_pointer> futures;
+        for (int i = 0; i < 8; ++i)
+        {
+            futures.push_back(
+                queue.push([] { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }));
+        }
+        queue.wait(futures);
+    }
+    pool_instrumentation::set_enabled(false);
+
+    auto const workers = stats_of("threaded_callback_queue");
+    ASSERT_FALSE(workers.empty());
+    EXPECT_EQ(total_jobs(workers), 8U);
+    for (const auto& w : workers)
+    {
+        uint64_t histogram_jobs = 0;
+        for (uint64_t count : w.wait_histogram_)
+        {
+            histogram_jobs += count;
+        }
+        EXPECT_EQ(histogram_jobs, w.jobs_);
+        EXPECT_GE(w.busy_ns_, static_cast<int64_t>(w.jobs_) * 2'000'000);
+        EXPECT_LE(w.max_wait_ns_, w.wait_ns_);
+        EXPECT_GT(w.utilization(), 0.0);
+        EXPECT_LE(w.utilization(), 1.0);
+        EXPECT_GE(w.idle_ns(), 0);
+    }
+
+    // The interval is closed: counters and window no longer move
+    {
+        threaded_callback_queue queue;
+        queue.push([] {})->wait();
+    }
+    auto const frozen = stats_of("threaded_callback_queue");
+    EXPECT_EQ(total_jobs(frozen), 8U);
+    EXPECT_EQ(frozen.front().window_ns_, workers.front().window_ns_);
+
+    pool_instrumentation::reset();
+    EXPECT_TRUE(stats_of("threaded_callback_queue").empty());
+
+    END_TEST();
+}
+
+#if !QUARISMA_HAS_OPENMP && !QUARISMA_HAS_TBB
+QUARISMATEST(PoolInstrumentation, thread_pool_counts_jobs)
+{
+    auto& pool = quarisma::detail::parallel::parallel_thread_pool::instance();
+
+    pool_instrumentation::reset();
+    pool_instrumentation::set_enabled(true);
+    {
+        auto proxy = pool.allocate_threads(2);
+        for (int i = 0; i < 6; ++i)
+        {
+            proxy.do_job([] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+        }
+        proxy.join();
+    }
+    pool_instrumentation::set_enabled(false);
+
+    auto const workers = stats_of("parallel_thread_pool");
+    ASSERT_FALSE(workers.empty());
+    EXPECT_EQ(total_jobs(workers), 6U);
+    for (const auto& w : workers)
+    {
+        EXPECT_LT(w.worker_, pool.thread_count());
+        EXPECT_GE(w.busy_ns_, static_cast<int64_t>(w.jobs_) * 1'000'000);
+    }
+    pool_instrumentation::reset();
+
+    END_TEST();
+}
+#endif
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+QUARISMATEST(PoolInstrumentation, profiler_report_section)
+{
+    auto session = quarisma::profiler_session_builder().with_thread_pool_stats().build();
+    ASSERT_TRUE(session->start());
+    EXPECT_TRUE(pool_instrumentation::enabled());
+
+    {
+        threaded_callback_queue queue;
+        queue.push([] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); })->wait();
+    }
+
+    ASSERT_TRUE(session->stop());
+    EXPECT_FALSE(pool_instrumentation::enabled());
+    ASSERT_FALSE(session->thread_pool_stats().empty());
+
+    auto const report  = session->generate_report();
+    auto const console = report->generate_console_report();
+    EXPECT_NE(console.find("=== Thread Pool Analysis ==="), std::string::npos);
+    EXPECT_NE(console.find("threaded_callback_queue worker"), std::string::npos);
+    EXPECT_NE(console.find("queue wait:"), std::string::npos);
+
+    auto const json = report->generate_json_report();
+    EXPECT_NE(json.find("\"thread_pools\": ["), std::string::npos);
+    EXPECT_NE(json.find("\"wait_histogram\": ["), std::string::npos);
+
+    // Sessions without the option leave the pools alone
+    auto plain = quarisma::profiler_session_builder().build();
+    ASSERT_TRUE(plain->start());
+    EXPECT_FALSE(pool_instrumentation::enabled());
+    ASSERT_TRUE(plain->stop());
+    EXPECT_TRUE(plain->thread_pool_stats().empty());
+    EXPECT_EQ(
+        plain->generate_report()->generate_console_report().find("Thread Pool Analysis"),
+        std::string::npos);
+
+    END_TEST();
+}
+#endif
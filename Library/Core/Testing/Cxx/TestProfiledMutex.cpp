@@ -0,0 +1,242 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Tests for profiled_mutex: per-site contention, wait and hold counters, and
+ * the lock section of the profiler report.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "parallel/profiled_mutex.h"
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/session/profiler.h"
+#include "profiler/native/session/profiler_report.h"
+#endif
+
+using quarisma::profiled_mutex;
+
+namespace
+{
+profiled_mutex::site_stats stats_of(const std::string& site)
+{
+    for (auto& stats : profiled_mutex::collect())
+    {
+        if (stats.site_ == site)
+        {
+            return stats;
+        }
+    }
+    profiled_mutex::site_stats none;
+    none.site_ = site;
+    return none;
+}
+
+// Holds `mutex` until another thread is about to block on it
+void contend(profiled_mutex& mutex)
+{
+    std::atomic<bool> waiting{false};
+    mutex.lock();
+    std::thread waiter(
+        [&]
+        {
+            waiting.store(true);
+            const std::lock_guard<profiled_mutex> lock(mutex);
+        });
+    while (!waiting.load())
+    {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    mutex.unlock();
+    waiter.join();
+}
+}  // namespace
+
+QUARISMATEST(ProfiledMutex, disabled_counts_nothing)
+{
+    profiled_mutex::set_enabled(false);
+    profiled_mutex::reset();
+
+    profiled_mutex mutex("test::disabled");
+    for (int i = 0; i < 10; ++i)
+    {
+        const std::lock_guard<profiled_mutex> lock(mutex);
+    }
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+
+    EXPECT_EQ(stats_of("test::disabled").acquisitions_, 0U);
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfiledMutex, counts_contended_waits)
+{
+    profiled_mutex::reset();
+    profiled_mutex::set_enabled(true);
+
+    profiled_mutex mutex("test::contended");
+    for (int i = 0; i < 5; ++i)
+    {
+        const std::lock_guard<profiled_mutex> lock(mutex);
+    }
+    contend(mutex);
+    profiled_mutex::set_enabled(false);
+
+    auto const stats = stats_of("test::contended");
+    EXPECT_EQ(stats.mutexes_, 1U);
+    EXPECT_EQ(stats.acquisitions_, 7U);
+    EXPECT_EQ(stats.contentions_, 1U);
+    EXPECT_GT(stats.wait_ns_, 0);
+    EXPECT_EQ(stats.max_wait_ns_, stats.wait_ns_);
+    EXPECT_NEAR(stats.contention_rate(), 1.0 / 7.0, 1e-12);
+    EXPECT_DOUBLE_EQ(stats.mean_wait_ns(), static_cast<double>(stats.wait_ns_));
+
+    // The most waited on sites come first
+    auto const all = profiled_mutex::collect();
+    ASSERT_FALSE(all.empty());
+    for (size_t i = 1; i < all.size(); ++i)
+    {
+        EXPECT_GE(all[i - 1].wait_ns_, all[i].wait_ns_);
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfiledMutex, samples_hold_time)
+{
+    uint32_t const period = profiled_mutex::hold_sample_period();
+    profiled_mutex::set_hold_sample_period(1);
+    profiled_mutex::reset();
+    profiled_mutex::set_enabled(true);
+
+    profiled_mutex mutex("test::hold");
+    for (int i = 0; i < 3; ++i)
+    {
+        const std::lock_guard<profiled_mutex> lock(mutex);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    profiled_mutex::set_enabled(false);
+    profiled_mutex::set_hold_sample_period(period);
+
+    auto const stats = stats_of("test::hold");
+    EXPECT_EQ(stats.acquisitions_, 3U);
+    EXPECT_EQ(stats.hold_samples_, 3U);
+    EXPECT_GE(stats.hold_ns_, 3 * 1000 * 1000);
+    EXPECT_GE(stats.max_hold_ns_, 1000 * 1000);
+    EXPECT_GE(stats.mean_hold_ns(), 1e6);
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfiledMutex, sums_live_and_destroyed_mutexes)
+{
+    profiled_mutex::reset();
+    profiled_mutex::set_enabled(true);
+
+    profiled_mutex live("test::site");
+    for (int i = 0; i < 4; ++i)
+    {
+        auto gone = std::make_unique<profiled_mutex>("test::site");
+        const std::lock_guard<profiled_mutex> lock(*gone);
+    }
+    {
+        const std::lock_guard<profiled_mutex> lock(live);
+    }
+    profiled_mutex::set_enabled(false);
+
+    auto stats = stats_of("test::site");
+    EXPECT_EQ(stats.mutexes_, 5U);
+    EXPECT_EQ(stats.acquisitions_, 5U);
+
+    profiled_mutex::reset();
+    stats = stats_of("test::site");
+    EXPECT_EQ(stats.acquisitions_, 0U);
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfiledMutex, waits_on_condition_variable)
+{
+    profiled_mutex::reset();
+    profiled_mutex::set_enabled(true);
+
+    profiled_mutex          mutex("test::condition");
+    std::condition_variable cv;
+    bool                    ready = false;
+
+    std::thread producer(
+        [&]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            {
+                const std::lock_guard<profiled_mutex> lock(mutex);
+                ready = true;
+            }
+            cv.notify_one();
+        });
+
+    {
+        std::unique_lock<profiled_mutex> lock(mutex);
+        profiled_mutex::wait(cv, lock, [&] { return ready; });
+        EXPECT_TRUE(ready);
+        EXPECT_TRUE(lock.owns_lock());
+    }
+    producer.join();
+    profiled_mutex::set_enabled(false);
+
+    // The waiter's lock and the producer's; the reacquisition is not counted
+    EXPECT_EQ(stats_of("test::condition").acquisitions_, 2U);
+
+    END_TEST();
+}
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+QUARISMATEST(ProfiledMutex, profiler_report_section)
+{
+    profiled_mutex mutex("test::report");
+
+    auto session = quarisma::profiler_session_builder().with_lock_stats().build();
+    ASSERT_TRUE(session->start());
+    EXPECT_TRUE(profiled_mutex::enabled());
+    contend(mutex);
+    ASSERT_TRUE(session->stop());
+    EXPECT_FALSE(profiled_mutex::enabled());
+
+    auto const locks = session->lock_stats();
+    ASSERT_FALSE(locks.empty());
+
+    auto const report  = session->generate_report();
+    auto const console = report->generate_console_report();
+    EXPECT_NE(console.find("=== Lock Contention ==="), std::string::npos);
+    EXPECT_NE(console.find("test::report: 2 acquisition(s), 1 contended"), std::string::npos);
+
+    auto const json = report->generate_json_report();
+    EXPECT_NE(json.find("\"locks\": ["), std::string::npos);
+    EXPECT_NE(json.find("\"site\": \"test::report\""), std::string::npos);
+
+    // Sessions without the option leave the mutexes alone
+    auto plain = quarisma::profiler_session_builder().build();
+    ASSERT_TRUE(plain->start());
+    EXPECT_FALSE(profiled_mutex::enabled());
+    ASSERT_TRUE(plain->stop());
+    EXPECT_TRUE(plain->lock_stats().empty());
+    EXPECT_EQ(
+        plain->generate_report()->generate_console_report().find("Lock Contention"),
+        std::string::npos);
+
+    END_TEST();
+}
+#endif
@@ -0,0 +1,228 @@
+/**
+ * @file TestProfilerAggregator.cpp
+ * @brief Test suite for merging profiles of several processes
+ *
+ * Tests profiler_collector and profiler_aggregator including:
+ * - Spaces of two sources merged into one plane, with distinct line ids
+ * - Source labels on the line names and timestamps on the aggregator clock
+ * - Profiles larger than a chunk reassembled intact
+ * - Stats snapshots merged into one stats_calculator
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "profiler/native/analysis/stats_calculator.h"
+#include "profiler/native/exporters/xplane/xplane.h"
+#include "profiler/native/session/profiler_aggregator.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+using namespace quarisma;
+
+namespace
+{
+
+std::string unique_name(const char* tag)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return std::string("/quarisma_test_aggregator_") + tag + "_" + std::to_string(::getpid());
+#else
+    return std::string("quarisma_test_aggregator_") + tag;
+#endif
+}
+
+// One host plane with a single line of `events` events
+x_space make_space(int64_t line_id, size_t events)
+{
+    x_space space;
+    xplane* plane = space.add_planes();
+    plane->set_id(0);
+    plane->set_name("/host:CPU");
+
+    xevent_metadata* metadata = plane->add_event_metadata(1);
+    metadata->set_id(1);
+    metadata->set_name("kernel");
+
+    xline* line = plane->add_lines();
+    line->set_id(line_id);
+    line->set_name("worker");
+    line->set_timestamp_ns(1000);
+    for (size_t i = 0; i < events; ++i)
+    {
+        xevent* event = line->add_events();
+        event->set_metadata_id(1);
+        event->set_offset_ps(static_cast<int64_t>(i) * 1000);
+        event->set_duration_ps(500);
+    }
+    space.add_hostname("localhost");
+    return space;
+}
+
+const xplane* find_plane(const x_space& space, const std::string& name)
+{
+    for (const auto& plane : space.planes())
+    {
+        if (plane.name() == name)
+        {
+            return &plane;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+QUARISMATEST(ProfilerAggregator, merges_spaces_of_two_sources)
+{
+    std::string const   name = unique_name("spaces");
+    profiler_aggregator aggregator(name);
+
+    std::vector<std::thread> senders;
+    for (int source = 0; source < 2; ++source)
+    {
+        senders.emplace_back(
+            [&name, source]
+            {
+                profiler_collector collector(name, "rank " + std::to_string(source));
+                EXPECT_TRUE(collector.send_space(make_space(7, 3), 1'000'000));
+            });
+    }
+    for (auto& sender : senders)
+    {
+        sender.join();
+    }
+
+    EXPECT_EQ(aggregator.poll(std::chrono::milliseconds(200)), 2u);
+
+    const xplane* plane = find_plane(aggregator.merged_space(), "/host:CPU");
+    ASSERT_NE(plane, nullptr);
+    ASSERT_EQ(plane->lines().size(), 2u);
+    EXPECT_NE(plane->lines()[0].id(), plane->lines()[1].id());
+    EXPECT_EQ(aggregator.merged_space().hostnames().size(), 1u);
+
+    auto const sources = aggregator.sources();
+    ASSERT_EQ(sources.size(), 2u);
+    for (const auto& line : plane->lines())
+    {
+        EXPECT_EQ(line.events().size(), 3u);
+        EXPECT_NE(line.display_name().find("/worker"), std::string::npos);
+        EXPECT_EQ(line.display_name().rfind("rank ", 0), 0u);
+    }
+    for (const auto& info : sources)
+    {
+        EXPECT_EQ(info.spaces, 1u);
+        EXPECT_FALSE(info.has_stats);
+        // Same host, so the offset is the queueing delay alone
+        EXPECT_GE(info.clock_offset_ns, 0);
+        EXPECT_LT(info.clock_offset_ns, int64_t{10'000'000'000});
+    }
+    EXPECT_GE(plane->lines()[0].timestamp_ns(), 1'001'000);
+}
+
+QUARISMATEST(ProfilerAggregator, reassembles_profiles_larger_than_a_chunk)
+{
+    std::string const            name = unique_name("chunks");
+    profiler_aggregator::Options opts;
+    opts.arena_size   = size_t{1} << 20;
+    opts.align_clocks = false;
+    profiler_aggregator aggregator(name, opts);
+
+    // About 40 bytes per event, several times the 128 KiB chunk
+    size_t const events = 20000;
+    std::thread  sender(
+        [&]
+        {
+            profiler_collector collector(name);
+            EXPECT_TRUE(collector.send_space(make_space(3, events)));
+        });
+
+    // Receive while sending, as the chunks together overflow the arena
+    size_t merged = 0;
+    for (int attempt = 0; attempt < 20 && merged == 0; ++attempt)
+    {
+        merged += aggregator.poll(std::chrono::milliseconds(500));
+    }
+    sender.join();
+    EXPECT_EQ(merged, 1u);
+
+    const xplane* plane = find_plane(aggregator.merged_space(), "/host:CPU");
+    ASSERT_NE(plane, nullptr);
+    ASSERT_EQ(plane->lines().size(), 1u);
+    const auto& line = plane->lines()[0];
+    ASSERT_EQ(line.events().size(), events);
+    EXPECT_EQ(line.events().back().offset_ps(), static_cast<int64_t>(events - 1) * 1000);
+    EXPECT_EQ(line.timestamp_ns(), 1000);
+    EXPECT_EQ(line.id() & 0xFFFFFFFF, 3);
+}
+
+QUARISMATEST(ProfilerAggregator, merges_stats_snapshots)
+{
+    std::string const   name = unique_name("stats");
+    profiler_aggregator aggregator(name);
+
+    {
+        profiler_collector first(name, "first");
+        profiler_collector second(name, "second");
+
+        stats_calculator a{stat_summarizer_options()};
+        a.update_run_total_us(100);
+        a.add_node_stats("matmul", "op", 0, 40, 1024);
+        a.add_node_stats("softmax", "op", 1, 10, 0);
+
+        stats_calculator b{stat_summarizer_options()};
+        b.update_run_total_us(300);
+        b.add_node_stats("matmul", "op", 0, 60, 2048);
+
+        // A later snapshot of a source replaces its earlier one
+        EXPECT_TRUE(first.send_stats(stats_calculator{stat_summarizer_options()}));
+        EXPECT_TRUE(first.send_stats(a));
+        EXPECT_TRUE(second.send_stats(b));
+    }
+    EXPECT_EQ(aggregator.poll(std::chrono::milliseconds(200)), 3u);
+
+    stats_calculator const merged = aggregator.merged_stats();
+    EXPECT_EQ(merged.run_total_us().count(), 2);
+    EXPECT_EQ(merged.run_total_us().sum(), 400);
+    EXPECT_EQ(merged.run_total_us().max(), 300);
+
+    const auto& details = merged.get_details();
+    ASSERT_EQ(details.size(), 2u);
+    const auto& matmul = details.at("matmul");
+    EXPECT_EQ(matmul.times_called, 2);
+    EXPECT_EQ(matmul.elapsed_time.sum(), 100);
+    EXPECT_EQ(matmul.elapsed_time.min(), 40);
+    EXPECT_EQ(matmul.mem_used.max(), 2048);
+    EXPECT_EQ(details.at("softmax").times_called, 1);
+}
+
+QUARISMATEST(ProfilerAggregator, stat_merge_matches_single_stream)
+{
+    quarisma::stat<int64_t> all;
+    quarisma::stat<int64_t> low;
+    quarisma::stat<int64_t> high;
+    for (int64_t v : {5, 1, 9})
+    {
+        all.update_stat(v);
+        low.update_stat(v);
+    }
+    for (int64_t v : {2, 12})
+    {
+        all.update_stat(v);
+        high.update_stat(v);
+    }
+    low.merge(high);
+    EXPECT_EQ(low.count(), all.count());
+    EXPECT_EQ(low.sum(), all.sum());
+    EXPECT_EQ(low.min(), all.min());
+    EXPECT_EQ(low.max(), all.max());
+    EXPECT_EQ(low.first(), all.first());
+    EXPECT_EQ(low.newest(), all.newest());
+    EXPECT_EQ(low.std_deviation(), all.std_deviation());
+}
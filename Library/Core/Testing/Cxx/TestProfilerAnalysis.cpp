@@ -7,10 +7,17 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
+#include <random>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "profiler/native/analysis/statistical_analyzer.h"
 #include "profiler/native/analysis/stats_calculator.h"
+#include "profiler/native/analysis/streaming_stats.h"
 #include "baseTest.h"
 
 using namespace quarisma;
@@ -276,4 +283,126 @@ QUARISMATEST(Profiler, stat_with_percentiles_output_stream)
     EXPECT_NE(output.find("p95="), std::string::npos);
 }
 
+// ============================================================================
+// Streaming Statistics Tests
+// ============================================================================
+
+QUARISMATEST(Profiler, running_moments_match_two_pass)
+{
+    std::vector<double> const data = {1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16};
+    running_moments           moments;
+    for (double const value : data)
+    {
+        moments.add(value);
+    }
+    EXPECT_EQ(moments.count(), 4u);
+    EXPECT_DOUBLE_EQ(moments.mean(), 1e9 + 10);
+    // Population variance of {4, 7, 13, 16}, lost by a sum of squares at 1e9
+    EXPECT_NEAR(moments.variance(), 22.5, 1e-6);
+    EXPECT_EQ(moments.min(), 1e9 + 4);
+    EXPECT_EQ(moments.max(), 1e9 + 16);
+}
+
+QUARISMATEST(Profiler, quantile_sketch_relative_accuracy)
+{
+    std::mt19937                     rng(42);
+    std::lognormal_distribution<>    distribution(0.0, 2.0);
+    std::vector<double>              data(100000);
+    quantile_sketch                  sketch(0.01);
+    for (double& value : data)
+    {
+        value = distribution(rng) - 1.0;  // Some negatives and values near zero
+        sketch.add(value);
+    }
+    std::sort(data.begin(), data.end());
+    EXPECT_EQ(sketch.count(), data.size());
+    for (double const q : {0.0, 0.1, 0.25, 0.5, 0.9, 0.99, 1.0})
+    {
+        double const exact = data[static_cast<size_t>(q * (data.size() - 1))];
+        EXPECT_NEAR(sketch.quantile(q), exact, std::abs(exact) * 0.01 + 1e-9) << "q=" << q;
+    }
+
+    sketch.clear();
+    EXPECT_EQ(sketch.count(), 0u);
+    EXPECT_EQ(sketch.quantile(0.5), 0.0);
+}
+
+QUARISMATEST(Profiler, statistical_analyzer_streams_past_window)
+{
+    statistical_analyzer analyzer;
+    analyzer.set_max_samples_per_series(100);
+    analyzer.set_percentiles({50.0, 99.0});
+    analyzer.start_analysis();
+
+    // Exact while every sample is kept
+    for (int i = 1; i <= 100; ++i)
+    {
+        analyzer.add_timing_sample("window", i);
+    }
+    auto exact = analyzer.calculate_timing_stats("window");
+    EXPECT_EQ(exact.count, 100u);
+    EXPECT_DOUBLE_EQ(exact.median, 50.5);
+    ASSERT_EQ(exact.percentiles.size(), 2u);
+    EXPECT_DOUBLE_EQ(exact.percentiles[0], 50.5);
+
+    // Moments cover all the samples, percentiles come from the sketch
+    for (int i = 101; i <= 10000; ++i)
+    {
+        analyzer.add_timing_sample("window", i);
+    }
+    auto streamed = analyzer.calculate_timing_stats("window");
+    EXPECT_EQ(streamed.count, 10000u);
+    EXPECT_EQ(analyzer.get_sample_count("window"), 10000u);
+    EXPECT_DOUBLE_EQ(streamed.mean, 5000.5);
+    EXPECT_EQ(streamed.min_value, 1.0);
+    EXPECT_EQ(streamed.max_value, 10000.0);
+    EXPECT_NEAR(streamed.median, 5000.0, 5000.0 * 0.01 + 1);
+    ASSERT_EQ(streamed.percentiles.size(), 2u);
+    EXPECT_NEAR(streamed.percentiles[1], 9900.0, 9900.0 * 0.01 + 1);
+
+    analyzer.clear_series("window");
+    EXPECT_FALSE(analyzer.calculate_timing_stats("window").is_valid());
+    analyzer.stop_analysis();
+}
+
+QUARISMATEST(Profiler, statistical_analyzer_parallel_batch)
+{
+    statistical_analyzer analyzer;
+    analyzer.set_worker_threads_hint(4);
+    analyzer.start_analysis();
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t)
+    {
+        writers.emplace_back(
+            [&analyzer, t]()
+            {
+                for (int series = 0; series < 50; ++series)
+                {
+                    for (int i = 0; i < 200; ++i)
+                    {
+                        analyzer.add_custom_sample(
+                            "series_" + std::to_string(series), static_cast<double>(t * 200 + i));
+                    }
+                }
+            });
+    }
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+
+    auto const all = analyzer.calculate_all_custom_stats();
+    ASSERT_EQ(all.size(), 50u);
+    for (const auto& entry : all)
+    {
+        EXPECT_EQ(entry.second.count, 800u) << entry.first;
+        EXPECT_DOUBLE_EQ(entry.second.mean, 399.5) << entry.first;
+        EXPECT_DOUBLE_EQ(entry.second.median, 399.5) << entry.first;
+        EXPECT_EQ(entry.second.max_value, 799.0) << entry.first;
+    }
+    EXPECT_TRUE(analyzer.calculate_all_timing_stats().empty());
+    analyzer.stop_analysis();
+}
+
 #endif  // QUARISMA_HAS_NATIVE_PROFILER
@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
  */
 
+#include <string>
 #include <string_view>
 
 #include "Testing/baseTest.h"
@@ -103,6 +104,44 @@ QUARISMATEST(Profiler, parse_annotation_stack_ignores_empty_segments)
     EXPECT_EQ(annos[1].name, "inner"sv);
 }
 
+// ============================================================================
+// annotation_parser and for_each_annotation tests
+// ============================================================================
+
+QUARISMATEST(Profiler, annotation_parser_matches_parse_annotation)
+{
+    constexpr std::string_view text = " kernel # attr={a:1,b:2}, bad , shape=[1,2] ,x= #ignored#";
+    const auto                 anno = parse_annotation(text);
+
+    annotation_parser parser(text);
+    EXPECT_EQ(parser.name(), anno.name);
+    EXPECT_EQ(parser.name(), "kernel"sv);
+
+    annotation::metadata_entry entry;
+    for (const auto& expected : anno.metadata)
+    {
+        ASSERT_TRUE(parser.next(entry));
+        EXPECT_EQ(entry.key, expected.key);
+        EXPECT_EQ(entry.value, expected.value);
+    }
+    EXPECT_EQ(anno.metadata.size(), 2u);
+    EXPECT_FALSE(parser.next(entry));
+    EXPECT_FALSE(parser.next(entry));
+}
+
+QUARISMATEST(Profiler, for_each_annotation_visits_non_empty_segments)
+{
+    std::string names;
+    for_each_annotation(
+        "::outer#id=1#::::inner::"sv,
+        [&names](std::string_view part)
+        {
+            names += annotation_parser(part).name();
+            names += ';';
+        });
+    EXPECT_EQ(names, "outer;inner;");
+}
+
 // ============================================================================
 // has_metadata tests
 // ============================================================================
@@ -349,4 +349,38 @@ QUARISMATEST(Profiler, annotation_stack_push_whitespace)
     const std::string& result = annotation_stack::get();
     EXPECT_TRUE(result.find("test name") != std::string::npos);
 }
+
+// Test that the lazily built path follows pushes and pops made between reads
+QUARISMATEST(Profiler, annotation_stack_lazy_path)
+{
+    annotation_stack::enable(false);
+    annotation_stack::enable(true);
+
+    annotation_stack::push_annotation("a");
+    annotation_stack::push_annotation("b");
+    EXPECT_EQ(annotation_stack::get(), "a::b");
+
+    // Levels pushed and popped without a read in between leave no trace
+    for (int i = 0; i < 100; ++i)
+    {
+        annotation_stack::push_annotation("deep");
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        annotation_stack::pop_annotation();
+    }
+    annotation_stack::pop_annotation();
+    annotation_stack::push_annotation("c");
+    annotation_stack::push_annotation("d");
+    EXPECT_EQ(annotation_stack::get(), "a::c::d");
+    EXPECT_EQ(annotation_stack::get_scope_range_ids().size(), 3u);
+
+    annotation_stack::pop_annotation();
+    EXPECT_EQ(annotation_stack::get(), "a::c");
+
+    annotation_stack::enable(false);
+    annotation_stack::enable(true);
+    EXPECT_TRUE(annotation_stack::get().empty());
+    EXPECT_TRUE(annotation_stack::get_scope_range_ids().empty());
+}
 #endif  // QUARISMA_HAS_NATIVE_PROFILER
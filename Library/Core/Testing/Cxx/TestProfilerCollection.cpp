@@ -0,0 +1,80 @@
+/*
+ * Profiler Collection Tests
+ *
+ * Tests for the ordering of the records getRecords() gathers from its subqueues.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "baseTest.h"
+#include "profiler/common/collection.h"
+
+using quarisma::profiler::impl::EventType;
+using quarisma::profiler::impl::ExtraFields;
+using quarisma::profiler::impl::Result;
+using quarisma::profiler::impl::sort_runs_by_start_time;
+
+namespace
+{
+// One run of events per subqueue, with start times drawn from a few values
+// so that most events tie with events of other runs.
+std::vector<std::shared_ptr<Result>> make_runs(
+    const std::vector<size_t>& run_sizes, std::vector<size_t>& bounds, std::mt19937& rng)
+{
+    std::uniform_int_distribution<int64_t> start_time(0, 3);
+    std::vector<std::shared_ptr<Result>>   events;
+    bounds.assign(1, 0);
+    for (size_t run = 0; run < run_sizes.size(); ++run)
+    {
+        for (size_t i = 0; i < run_sizes[run]; ++i)
+        {
+            events.push_back(Result::create(
+                start_time(rng),
+                static_cast<uint64_t>(run),
+                quarisma::profiler::impl::kineto::DeviceAndResource{0, 0},
+                ExtraFields<EventType::Kineto>{}));
+        }
+        bounds.push_back(events.size());
+    }
+    return events;
+}
+}  // namespace
+
+QUARISMATEST(ProfilerCollection, sorted_runs_match_serial_stable_sort)
+{
+    auto const by_start = [](const auto& a, const auto& b)
+    { return a->start_time_ns_ < b->start_time_ns_; };
+
+    std::mt19937                     rng(42);
+    std::vector<std::vector<size_t>> cases = {
+        {5},
+        {7, 1},
+        {7, 1, 12},
+        {3, 8, 2, 6, 9},
+        {4, 4, 4, 4, 4, 4, 4, 4},
+    };
+    std::vector<size_t> many(37);
+    for (size_t i = 0; i < many.size(); ++i)
+    {
+        many[i] = 1 + (i * 13) % 29;
+    }
+    cases.push_back(many);
+
+    for (const auto& run_sizes : cases)
+    {
+        std::vector<size_t> bounds;
+        auto                events   = make_runs(run_sizes, bounds, rng);
+        auto                expected = events;
+        std::stable_sort(expected.begin(), expected.end(), by_start);
+
+        sort_runs_by_start_time(events, bounds);
+        EXPECT_EQ(events, expected);
+    }
+
+    END_TEST();
+}
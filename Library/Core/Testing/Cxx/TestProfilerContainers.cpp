@@ -0,0 +1,199 @@
+/*
+ * Profiler Container Tests
+ *
+ * Tests for AppendOnlyList and the BlockPool that recycles its blocks.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "baseTest.h"
+#include "profiler/common/containers.h"
+
+using quarisma::profiler::impl::AppendOnlyList;
+using quarisma::profiler::impl::BlockPool;
+
+namespace
+{
+template <typename T, size_t N>
+struct counted_block : std::array<T, N>
+{
+    void reuse() { ++reuse_count; }
+
+    static inline int reuse_count = 0;
+};
+
+template <typename List>
+std::vector<int> contents(List& list)
+{
+    std::vector<int> out;
+    for (auto& i : list)
+    {
+        out.push_back(i);
+    }
+    return out;
+}
+}  // namespace
+
+QUARISMATEST(ProfilerContainers, append_only_list_recycles_blocks)
+{
+    using list_t = AppendOnlyList<int, 3>;
+    auto& pool   = BlockPool<list_t::array_t>::instance();
+
+    size_t const before = pool.size();
+    {
+        list_t list;
+        for (int i = 0; i < 7; ++i)
+        {
+            list.emplace_back(i);
+        }
+        EXPECT_EQ(list.size(), 7U);
+        EXPECT_EQ(contents(list), (std::vector<int>{0, 1, 2, 3, 4, 5, 6}));
+
+        list.clear();
+        EXPECT_EQ(pool.size(), before + 3);
+        EXPECT_EQ(list.size(), 0U);
+
+        // Growing again takes the pooled blocks back, in order.
+        for (int i = 10; i < 15; ++i)
+        {
+            list.emplace_back(i);
+        }
+        EXPECT_EQ(pool.size(), before + 1);
+        EXPECT_EQ(contents(list), (std::vector<int>{10, 11, 12, 13, 14}));
+    }
+
+    // Destruction releases blocks too.
+    EXPECT_EQ(pool.size(), before + 3);
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfilerContainers, block_pool_is_bounded_and_calls_reuse)
+{
+    using list_t = AppendOnlyList<int, 2, counted_block>;
+    auto& pool   = BlockPool<list_t::array_t>::instance();
+
+    list_t list;
+    for (size_t i = 0; i < 2 * (BlockPool<list_t::array_t>::MaxBlocks + 10); ++i)
+    {
+        list.emplace_back(static_cast<int>(i));
+    }
+    EXPECT_EQ(list_t::array_t::reuse_count, 0);
+
+    list.clear();
+    EXPECT_EQ(pool.size(), BlockPool<list_t::array_t>::MaxBlocks);
+
+    list.emplace_back(1);
+    list.emplace_back(2);
+    list.emplace_back(3);
+    EXPECT_EQ(list_t::array_t::reuse_count, 2);
+    EXPECT_EQ(contents(list), (std::vector<int>{1, 2, 3}));
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfilerContainers, append_only_list_swap)
+{
+    using list_t = AppendOnlyList<int, 3>;
+
+    list_t live;
+    list_t retired;
+    for (int i = 0; i < 4; ++i)
+    {
+        live.emplace_back(i);
+    }
+
+    // Swapping with an empty list leaves the source ready to grow again.
+    live.swap(retired);
+    EXPECT_EQ(live.size(), 0U);
+    EXPECT_EQ(contents(retired), (std::vector<int>{0, 1, 2, 3}));
+
+    live.emplace_back(10);
+    retired.emplace_back(4);
+    EXPECT_EQ(contents(live), (std::vector<int>{10}));
+    EXPECT_EQ(contents(retired), (std::vector<int>{0, 1, 2, 3, 4}));
+
+    live.swap(retired);
+    EXPECT_EQ(contents(live), (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(contents(retired), (std::vector<int>{10}));
+
+    END_TEST();
+}
+
+// Same hand-off as the profiler's background flush: the writer swaps its list
+// out when asked and keeps appending while the other thread drains it.
+QUARISMATEST(ProfilerContainers, append_only_list_generation_handoff)
+{
+    using list_t = AppendOnlyList<int, 16>;
+
+    enum : int
+    {
+        idle,
+        requested,
+        retired_state
+    };
+
+    constexpr int     n = 100000;
+    list_t            live;
+    list_t            retired;
+    std::atomic<int>  state{idle};
+    std::atomic<bool> done{false};
+    std::vector<int>  drained;
+
+    std::thread drainer(
+        [&]
+        {
+            auto drain = [&]
+            {
+                for (auto& i : retired)
+                {
+                    drained.push_back(i);
+                }
+                retired.clear();
+            };
+            while (!done.load(std::memory_order_acquire))
+            {
+                int const s = state.load(std::memory_order_acquire);
+                if (s == retired_state)
+                {
+                    drain();
+                }
+                if (s != requested)
+                {
+                    state.store(requested, std::memory_order_release);
+                }
+                std::this_thread::yield();
+            }
+            if (state.load(std::memory_order_acquire) == retired_state)
+            {
+                drain();
+            }
+        });
+
+    for (int i = 0; i < n; ++i)
+    {
+        if (state.load(std::memory_order_acquire) == requested)
+        {
+            live.swap(retired);
+            state.store(retired_state, std::memory_order_release);
+        }
+        live.emplace_back(i);
+    }
+    done.store(true, std::memory_order_release);
+    drainer.join();
+
+    for (auto& i : live)
+    {
+        drained.push_back(i);
+    }
+    std::vector<int> expected(n);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(drained, expected);
+
+    END_TEST();
+}
@@ -0,0 +1,146 @@
+#if QUARISMA_HAS_NATIVE_PROFILER
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "profiler/native/cpu/sampling_profiler.h"
+#include "profiler/native/exporters/folded_stacks_exporter.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+#include "profiler/native/session/profiler.h"
+#include "baseTest.h"
+
+using namespace quarisma;
+using namespace quarisma::profiler;
+
+namespace
+{
+
+// Uninstrumented CPU work
+QUARISMA_NOINLINE double burn_cpu(std::chrono::milliseconds duration)
+{
+    double     sum      = 0;
+    auto const deadline = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        for (int i = 1; i < 10000; ++i)
+        {
+            sum += std::sqrt(static_cast<double>(i));
+        }
+    }
+    return sum;
+}
+
+uint64_t count_folded_samples(const std::string& folded)
+{
+    std::istringstream lines(folded);
+    std::string        line;
+    uint64_t           total = 0;
+    while (std::getline(lines, line))
+    {
+        total += std::stoull(line.substr(line.rfind(' ') + 1));
+    }
+    return total;
+}
+
+}  // namespace
+
+#if defined(__linux__) && defined(__x86_64__)
+
+QUARISMATEST(ProfilerCpuSampling, samples_uninstrumented_code)
+{
+    sampling_profiler_options options;
+    options.frequency_hz = 250;
+    auto profiler        = create_sampling_profiler(options);
+    ASSERT_NE(profiler, nullptr);
+    ASSERT_TRUE(profiler->start().ok());
+    EXPECT_FALSE(create_sampling_profiler(options)->start().ok());
+
+    std::thread worker([]() { burn_cpu(std::chrono::milliseconds(300)); });
+    double const sum = burn_cpu(std::chrono::milliseconds(300));
+    worker.join();
+    EXPECT_GT(sum, 0);
+
+    ASSERT_TRUE(profiler->stop().ok());
+    x_space space;
+    ASSERT_TRUE(profiler->collect_data(&space).ok());
+
+    const xplane* plane = find_plane_with_name(space, kHostCpuSamplesPlaneName);
+    ASSERT_NE(plane, nullptr);
+    size_t events = 0;
+    for (const auto& line : plane->lines())
+    {
+        EXPECT_FALSE(line.name().empty());
+        for (const auto& event : line.events())
+        {
+            EXPECT_EQ(event.stats().size(), 1u);
+            ++events;
+        }
+    }
+    // About 150 samples of 600ms of CPU time; the timer is tick-based
+    EXPECT_GT(events, 10u);
+    EXPECT_GE(plane->lines_size(), 1u);
+
+    std::ostringstream folded;
+    ASSERT_TRUE(export_folded_stacks(space, folded));
+    EXPECT_EQ(count_folded_samples(folded.str()), events);
+
+    // The profiler can run again
+    ASSERT_TRUE(profiler->start().ok());
+    ASSERT_TRUE(profiler->stop().ok());
+}
+
+QUARISMATEST(ProfilerCpuSampling, session_writes_folded_stacks)
+{
+    auto session = profiler_session_builder()
+                       .with_cpu_sampling(250)
+                       .with_hierarchical_profiling(false)
+                       .with_memory_tracking(false)
+                       .build();
+    ASSERT_TRUE(session->start());
+    burn_cpu(std::chrono::milliseconds(200));
+    ASSERT_TRUE(session->stop());
+
+    const auto path = (std::filesystem::temp_directory_path() / "quarisma_cpu_samples.folded");
+    ASSERT_TRUE(session->write_folded_stacks(path.string()));
+    std::ifstream     file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_GT(count_folded_samples(content.str()), 0u);
+    std::remove(path.string().c_str());
+}
+
+#endif  // defined(__linux__) && defined(__x86_64__)
+
+QUARISMATEST(ProfilerCpuSampling, disabled_and_empty)
+{
+    sampling_profiler_options options;
+    options.frequency_hz = 0;
+    EXPECT_EQ(create_sampling_profiler(options), nullptr);
+
+    // No samples plane
+    x_space            space;
+    std::ostringstream folded;
+    EXPECT_FALSE(export_folded_stacks(space, folded));
+    EXPECT_TRUE(folded.str().empty());
+
+    // A session without sampling has nothing to write
+    auto session = profiler_session_builder().with_memory_tracking(false).build();
+    ASSERT_TRUE(session->start());
+    ASSERT_TRUE(session->stop());
+    EXPECT_FALSE(session->write_folded_stacks(
+        (std::filesystem::temp_directory_path() / "quarisma_no_samples.folded").string()));
+}
+
+#endif  // QUARISMA_HAS_NATIVE_PROFILER
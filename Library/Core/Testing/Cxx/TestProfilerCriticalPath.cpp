@@ -0,0 +1,214 @@
+/**
+ * @file TestProfilerCriticalPath.cpp
+ * @brief Test suite for the critical-path analysis of collected spaces
+ *
+ * Tests analyze_critical_paths including:
+ * - Attribution to compute, queue wait, lock wait and I/O across threads
+ * - The last-finishing task taken as the one releasing a wait
+ * - XFlow stats linking events as the traceme producer/consumer stats do
+ * - Ranked spans, one path per request and the default root
+ * - Classification of event names
+ */
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "profiler/native/analysis/critical_path.h"
+#include "profiler/native/exporters/xplane/xplane.h"
+#include "profiler/native/exporters/xplane/xplane_builder.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+using stats = std::vector<std::pair<std::string, int64_t>>;
+
+void add_event(
+    xplane_builder&    plane,
+    int64_t            line_id,
+    const std::string& name,
+    int64_t            start_ns,
+    int64_t            end_ns,
+    const stats&       event_stats = {})
+{
+    xline_builder line = plane.get_or_create_line(line_id);
+    line.SetName("thread " + std::to_string(line_id));
+    xevent_builder event = line.add_event(*plane.get_or_create_event_metadata(name));
+    event.SetTimestampNs(start_ns);
+    event.SetDurationNs(end_ns - start_ns);
+    for (const auto& [stat, value] : event_stats)
+    {
+        event.add_stat_value(*plane.get_or_create_stat_metadata(stat), value);
+    }
+}
+
+int64_t const threadpool = static_cast<int64_t>(ContextType::kThreadpoolEvent);
+
+// A request on thread 1 hands a closure to thread 2 and waits for it:
+//   thread 1: request [0, 100] > schedule [10, 12], wait [12, 95]
+//   thread 2: run [30, 90] > read [40, 60]
+x_space make_request(int64_t offset_ns, int64_t closure_id)
+{
+    x_space        space;
+    xplane_builder plane(space.add_planes());
+    plane.SetName("/host:CPU");
+
+    int64_t const t = offset_ns;
+    add_event(plane, 1, "request", t, t + 100);
+    add_event(plane, 1, "schedule", t + 10, t + 12, {{"_pt", threadpool}, {"_p", closure_id}});
+    add_event(plane, 1, "wait_for_result", t + 12, t + 95);
+    add_event(plane, 2, "run", t + 30, t + 90, {{"_ct", threadpool}, {"_c", closure_id}});
+    add_event(plane, 2, "ReadFile", t + 40, t + 60);
+    return space;
+}
+
+}  // namespace
+
+QUARISMATEST(ProfilerCriticalPath, attributes_time_across_threads)
+{
+    x_space const         space = make_request(1000, 7);
+    critical_path_options options;
+    options.root_event = "request";
+
+    critical_path const path = analyze_critical_path(space, options);
+    EXPECT_EQ(path.root, "request");
+    EXPECT_EQ(path.duration_ns(), 100);
+
+    // request, schedule, queued, run, ReadFile, run, woken up, request
+    ASSERT_EQ(path.segments.size(), 8u);
+    int64_t covered = path.start_ns;
+    for (const auto& segment : path.segments)
+    {
+        EXPECT_EQ(segment.start_ns, covered);
+        covered = segment.end_ns;
+    }
+    EXPECT_EQ(covered, path.end_ns);
+
+    EXPECT_EQ(path.segments[2].category, critical_path_category::queue_wait);
+    EXPECT_EQ(path.segments[2].event, "run");
+    EXPECT_EQ(path.segments[2].duration_ns(), 18);
+    EXPECT_EQ(path.segments[4].event, "ReadFile");
+    EXPECT_EQ(path.segments[4].line_id, 2);
+    EXPECT_EQ(path.segments[6].category, critical_path_category::lock_wait);
+    EXPECT_EQ(path.segments[6].duration_ns(), 5);
+    EXPECT_EQ(path.segments[7].event, "request");
+
+    EXPECT_EQ(path.time_in(critical_path_category::compute), 10 + 2 + 10 + 30 + 5);
+    EXPECT_EQ(path.time_in(critical_path_category::queue_wait), 18);
+    EXPECT_EQ(path.time_in(critical_path_category::io), 20);
+    EXPECT_EQ(path.time_in(critical_path_category::lock_wait), 5);
+
+    // run is on the path twice, around ReadFile
+    ASSERT_FALSE(path.spans.empty());
+    EXPECT_EQ(path.spans[0].event, "run");
+    EXPECT_EQ(path.spans[0].critical_ns, 40);
+    EXPECT_EQ(path.spans[0].segments, 2u);
+    EXPECT_EQ(path.spans[1].event, "ReadFile");
+}
+
+QUARISMATEST(ProfilerCriticalPath, wait_is_released_by_the_last_task)
+{
+    x_space        space;
+    xplane_builder plane(space.add_planes());
+    plane.SetName("/host:CPU");
+    add_event(plane, 1, "request", 0, 100);
+    add_event(plane, 1, "schedule", 0, 1, {{"_pt", threadpool}, {"_p", 1}});
+    add_event(plane, 1, "schedule", 1, 2, {{"_pt", threadpool}, {"_p", 2}});
+    add_event(plane, 1, "join", 2, 100);
+    add_event(plane, 2, "short_task", 2, 40, {{"_ct", threadpool}, {"_c", 1}});
+    add_event(plane, 3, "long_task", 5, 98, {{"_ct", threadpool}, {"_c", 2}});
+    // Not handed off by the request, so it cannot release its wait
+    add_event(plane, 4, "unrelated", 0, 99);
+
+    critical_path_options options;
+    options.root_event       = "request";
+    critical_path const path = analyze_critical_path(space, options);
+
+    EXPECT_EQ(path.time_in(critical_path_category::lock_wait), 2);
+    EXPECT_EQ(path.time_in(critical_path_category::queue_wait), 3);
+    for (const auto& segment : path.segments)
+    {
+        EXPECT_NE(segment.event, "short_task");
+        EXPECT_NE(segment.event, "unrelated");
+    }
+    ASSERT_FALSE(path.spans.empty());
+    EXPECT_EQ(path.spans[0].event, "long_task");
+    EXPECT_EQ(path.spans[0].critical_ns, 93);
+}
+
+QUARISMATEST(ProfilerCriticalPath, follows_xflow_stats)
+{
+    x_space        space;
+    xplane_builder plane(space.add_planes());
+    plane.SetName("/host:CPU");
+
+    XFlow const out(42, XFlow::kFlowOut);
+    XFlow const in(42, XFlow::kFlowIn);
+    add_event(plane, 1, "request", 0, 50);
+    add_event(plane, 1, "enqueue", 0, 5, {{"flow", static_cast<int64_t>(out.ToStatValue())}});
+    add_event(plane, 1, "wait", 5, 50);
+    add_event(plane, 2, "dequeue", 20, 50, {{"flow", static_cast<int64_t>(in.ToStatValue())}});
+
+    critical_path const path = analyze_critical_path(space);
+    EXPECT_EQ(path.root, "request");
+    EXPECT_EQ(path.time_in(critical_path_category::queue_wait), 15);
+    EXPECT_EQ(path.time_in(critical_path_category::compute), 35);
+    ASSERT_EQ(path.segments.size(), 3u);
+    EXPECT_EQ(path.segments[2].event, "dequeue");
+}
+
+QUARISMATEST(ProfilerCriticalPath, one_path_per_request)
+{
+    x_space        space = make_request(0, 1);
+    xplane_builder plane(space.mutable_planes(0));
+    add_event(plane, 1, "request", 200, 260);
+    add_event(plane, 1, "compute", 210, 250);
+
+    critical_path_options options;
+    options.root_event = "request";
+    options.max_spans  = 1;
+
+    auto const paths = analyze_critical_paths(space, options);
+    ASSERT_EQ(paths.size(), 2u);
+    EXPECT_EQ(paths[0].start_ns, 0);
+    EXPECT_EQ(paths[1].start_ns, 200);
+    EXPECT_EQ(paths[1].time_in(critical_path_category::compute), 60);
+    ASSERT_EQ(paths[1].spans.size(), 1u);
+    EXPECT_EQ(paths[1].spans[0].event, "compute");
+
+    options.root_event = "missing";
+    EXPECT_TRUE(analyze_critical_paths(space, options).empty());
+    EXPECT_TRUE(analyze_critical_path(space, options).segments.empty());
+}
+
+QUARISMATEST(ProfilerCriticalPath, longest_event_is_the_default_root)
+{
+    x_space        space;
+    xplane_builder plane(space.add_planes());
+    add_event(plane, 1, "request", 0, 30);
+    add_event(plane, 2, "outer", 0, 100);
+    add_event(plane, 2, "inner", 10, 20);
+
+    critical_path const path = analyze_critical_path(space);
+    EXPECT_EQ(path.root, "outer");
+    EXPECT_EQ(path.time_in(critical_path_category::compute), 100);
+    EXPECT_EQ(path.segments.size(), 3u);
+}
+
+QUARISMATEST(ProfilerCriticalPath, classify_event_name)
+{
+    EXPECT_EQ(classify_event_name("ReadFile"), critical_path_category::io);
+    EXPECT_EQ(classify_event_name("socket::send"), critical_path_category::io);
+    EXPECT_EQ(classify_event_name("io_wait"), critical_path_category::io);
+    EXPECT_EQ(classify_event_name("mutex::lock"), critical_path_category::lock_wait);
+    EXPECT_EQ(classify_event_name("WaitForWork"), critical_path_category::lock_wait);
+    EXPECT_EQ(classify_event_name("thread_join"), critical_path_category::lock_wait);
+    EXPECT_EQ(classify_event_name("ratio_radio"), critical_path_category::compute);
+    EXPECT_EQ(classify_event_name("MatMul"), critical_path_category::compute);
+    EXPECT_EQ(to_string(critical_path_category::queue_wait), "queue_wait");
+}
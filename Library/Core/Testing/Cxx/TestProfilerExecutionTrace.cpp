@@ -0,0 +1,137 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @file TestProfilerExecutionTrace.cpp
+ * @brief Tests of the execution trace observer and its background writer
+ *
+ * - every node recorded on several threads reaches the file, once
+ * - the compressed output decompresses to the same JSON document
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "compression/framed_stream.h"
+#include "profiler/common/record_function.h"
+#include "profiler/common/standalone/execution_trace_observer.h"
+
+using namespace quarisma;
+using namespace quarisma::profiler::impl;
+
+namespace
+{
+
+constexpr int kThreads      = 4;
+constexpr int kOpsPerThread = 3000;
+
+std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+size_t count_of(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos;
+         pos        = text.find(pattern, pos + pattern.size()))
+    {
+        ++count;
+    }
+    return count;
+}
+
+// Records kThreads * kOpsPerThread operators into a trace at path
+void record_trace(const std::string& path, bool compress)
+{
+    clearCallbacks();
+    ASSERT_TRUE(addExecutionTraceObserver(path, compress));
+    enableExecutionTraceObserver();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            []
+            {
+                std::vector<IValue> const inputs;
+                for (int i = 0; i < kOpsPerThread; ++i)
+                {
+                    RecordFunction guard(RecordScope::USER_SCOPE);
+                    guard.before("et_test_op", &inputs);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    disableExecutionTraceObserver();
+    removeExecutionTraceObserver();
+    clearCallbacks();
+}
+
+void expect_complete_trace(const std::string& json)
+{
+    EXPECT_EQ(json.rfind("{", 0), 0U);
+    EXPECT_NE(json.find("\"finish_ts\""), std::string::npos);
+    EXPECT_EQ(
+        count_of(json, "\"name\": \"et_test_op\""), static_cast<size_t>(kThreads * kOpsPerThread));
+    EXPECT_EQ(
+        count_of(json, "\"name\": \"[pytorch|profiler|execution_trace|thread]\""),
+        static_cast<size_t>(kThreads));
+    EXPECT_EQ(count_of(json, "\"name\": \"[pytorch|profiler|execution_trace|process]\""), 1U);
+}
+
+}  // namespace
+
+QUARISMATEST(ProfilerExecutionTrace, writes_every_node_once)
+{
+    std::string const path =
+        (std::filesystem::temp_directory_path() / "quarisma_execution_trace.json").string();
+    record_trace(path, false);
+
+    expect_complete_trace(read_file(path));
+    std::remove(path.c_str());
+}
+
+QUARISMATEST(ProfilerExecutionTrace, compressed_output_decompresses_to_json)
+{
+    std::string const path =
+        (std::filesystem::temp_directory_path() / "quarisma_execution_trace.json.sz").string();
+    record_trace(path, true);
+
+    std::string const                stream = read_file(path);
+    std::string                      json;
+    compression::framed_decompressor decompressor(
+        [&json](const char* data, size_t size) { json.append(data, size); });
+    EXPECT_TRUE(decompressor.write(stream.data(), stream.size()));
+    EXPECT_TRUE(decompressor.finish());
+
+    expect_complete_trace(json);
+    std::remove(path.c_str());
+}
@@ -11,6 +11,7 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <string>
 #include <string_view>
 
 #include "profiler/native/exporters/chrome_trace_exporter.h"
@@ -281,6 +282,59 @@ QUARISMATEST(Profiler, chrome_trace_export_many_events)
     EXPECT_NE(json.find("event"), std::string::npos);
 }
 
+QUARISMATEST(Profiler, chrome_trace_export_long_lines_keep_order)
+{
+    // Longer than the chunks lines are split into when serialized concurrently
+    constexpr int kEvents = 40000;
+
+    x_space space;
+    for (int p = 0; p < 2; ++p)
+    {
+        auto* plane = space.add_planes();
+        plane->set_id(p + 1);
+        plane->set_name("Plane-" + std::to_string(p));
+        (*plane->mutable_event_metadata())[1].set_name("event");
+
+        for (int l = 0; l < 2; ++l)
+        {
+            auto* line = plane->add_lines();
+            line->set_id(l + 1);
+            line->set_name("Thread-" + std::to_string(l));
+            line->set_timestamp_ns(1000);
+            for (int i = 0; i < kEvents; ++i)
+            {
+                auto* event = line->add_events();
+                event->set_offset_ps(int64_t{i} * 1000 + 500);
+                event->set_duration_ps(250);
+                event->set_metadata_id(1);
+            }
+        }
+    }
+
+    std::string json = export_to_chrome_trace_json(space);
+
+    // Every event once, in order within its line, with exact timestamps
+    size_t count    = 0;
+    double previous = 0.0;
+    bool   ordered  = true;
+    for (size_t pos = json.find("\"ts\":"); pos != std::string::npos;
+         pos        = json.find("\"ts\":", pos + 1))
+    {
+        double const ts = std::stod(json.substr(pos + 5, 16));
+        ordered         = ordered && (count % kEvents == 0 || ts > previous);
+        previous        = ts;
+        ++count;
+    }
+    EXPECT_EQ(count, size_t{4} * kEvents);
+    EXPECT_TRUE(ordered);
+    EXPECT_NE(json.find("\"ts\":1000.5,\"dur\":0.25"), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":40999.5,"), std::string::npos);
+
+    // Metadata events stay ahead of the events they name
+    EXPECT_LT(json.find("Plane-0"), json.find("Thread-0"));
+    EXPECT_LT(json.find("Thread-1"), json.find("Plane-1"));
+}
+
 QUARISMATEST(Profiler, chrome_trace_export_file_write)
 {
     x_space space;
@@ -0,0 +1,140 @@
+#if QUARISMA_HAS_NATIVE_PROFILER
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ */
+
+#include <cmath>
+#include <string>
+
+#include "profiler/native/cpu/hardware_counters.h"
+#include "profiler/native/session/profiler.h"
+#include "profiler/native/session/profiler_report.h"
+#include "baseTest.h"
+
+using namespace quarisma;
+using namespace quarisma::profiler;
+
+namespace
+{
+
+QUARISMA_NOINLINE double compute(int n)
+{
+    double sum = 0;
+    for (int i = 1; i < n; ++i)
+    {
+        sum += std::sqrt(static_cast<double>(i));
+    }
+    return sum;
+}
+
+hardware_counter_values make_values(uint64_t cycles, uint64_t instructions, uint64_t llc)
+{
+    hardware_counter_values values;
+    values.counts[static_cast<size_t>(hardware_counter::cycles)]       = cycles;
+    values.counts[static_cast<size_t>(hardware_counter::instructions)] = instructions;
+    values.counts[static_cast<size_t>(hardware_counter::llc_misses)]   = llc;
+    values.available_mask = (1u << static_cast<size_t>(hardware_counter::cycles)) |
+                            (1u << static_cast<size_t>(hardware_counter::instructions)) |
+                            (1u << static_cast<size_t>(hardware_counter::llc_misses));
+    return values;
+}
+
+}  // namespace
+
+QUARISMATEST(ProfilerHardwareCounters, derived_metrics)
+{
+    auto const start = make_values(1000, 2000, 10);
+    auto const end   = make_values(3000, 6000, 30);
+    auto const delta = hardware_counter_delta(start, end);
+    EXPECT_EQ(delta.get(hardware_counter::cycles), 2000u);
+    EXPECT_DOUBLE_EQ(delta.ipc(), 2.0);
+    EXPECT_DOUBLE_EQ(delta.per_kilo_instruction(hardware_counter::llc_misses), 5.0);
+    EXPECT_FALSE(delta.has(hardware_counter::branch_misses));
+    EXPECT_DOUBLE_EQ(delta.per_kilo_instruction(hardware_counter::branch_misses), 0.0);
+
+    hardware_counter_values total;
+    EXPECT_TRUE(total.empty());
+    EXPECT_DOUBLE_EQ(total.ipc(), 0.0);
+    total.accumulate(delta);
+    total.accumulate(delta);
+    EXPECT_EQ(total.get(hardware_counter::instructions), 8000u);
+    EXPECT_EQ(total.available_mask, delta.available_mask);
+    EXPECT_EQ(hardware_counter_name(hardware_counter::dtlb_misses), "dtlb_misses");
+}
+
+QUARISMATEST(ProfilerHardwareCounters, per_scope_deltas)
+{
+    auto session = profiler_session_builder()
+                       .with_hardware_counters(true)
+                       .with_memory_tracking(false)
+                       .with_statistical_analysis(false)
+                       .build();
+    ASSERT_TRUE(session->start());
+    double sum = 0;
+    {
+        profiler_scope const outer("hw_outer", session.get());
+        for (int i = 0; i < 3; ++i)
+        {
+            profiler_scope const inner("hw_inner", session.get());
+            sum += compute(100000);
+        }
+    }
+    ASSERT_TRUE(session->stop());
+    EXPECT_GT(sum, 0);
+
+    const profiler_scope_data* root = session->get_root_scope();
+    ASSERT_NE(root, nullptr);
+    ASSERT_EQ(root->children_.size(), 1u);
+    const auto& outer = *root->children_[0];
+    ASSERT_EQ(outer.children_.size(), 3u);
+
+    std::string const report = session->generate_report()->generate_console_report();
+    EXPECT_NE(report.find("=== Hardware Counters ==="), std::string::npos);
+
+    hardware_counter_values probe;
+    if (!read_thread_hardware_counters(&probe))
+    {
+        // No PMU here: the scopes have no counters and the report says so
+        EXPECT_TRUE(outer.hardware_counters_.empty());
+        EXPECT_NE(report.find("No hardware counters were read"), std::string::npos);
+        return;
+    }
+
+    uint64_t inner_instructions = 0;
+    for (const auto& inner : outer.children_)
+    {
+        ASSERT_FALSE(inner->hardware_counters_.empty());
+        EXPECT_GT(inner->hardware_counters_.get(hardware_counter::instructions), 100000u);
+        inner_instructions += inner->hardware_counters_.get(hardware_counter::instructions);
+    }
+    // Scope counts are inclusive
+    EXPECT_GE(outer.hardware_counters_.get(hardware_counter::instructions), inner_instructions);
+    EXPECT_GT(outer.hardware_counters_.ipc(), 0.0);
+    EXPECT_NE(report.find("hw_inner: calls 3"), std::string::npos);
+
+    std::string const json = session->generate_report()->generate_json_report();
+    EXPECT_NE(json.find("\"hardware_counters\""), std::string::npos);
+}
+
+QUARISMATEST(ProfilerHardwareCounters, disabled_by_default)
+{
+    auto session = profiler_session_builder().with_memory_tracking(false).build();
+    ASSERT_TRUE(session->start());
+    {
+        profiler_scope const scope("hw_disabled", session.get());
+        compute(1000);
+    }
+    ASSERT_TRUE(session->stop());
+
+    const profiler_scope_data* root = session->get_root_scope();
+    ASSERT_NE(root, nullptr);
+    ASSERT_EQ(root->children_.size(), 1u);
+    EXPECT_TRUE(root->children_[0]->hardware_counters_.empty());
+    EXPECT_EQ(
+        session->generate_report()->generate_console_report().find("=== Hardware Counters ==="),
+        std::string::npos);
+}
+
+#endif  // QUARISMA_HAS_NATIVE_PROFILER
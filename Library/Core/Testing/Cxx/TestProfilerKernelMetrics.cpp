@@ -0,0 +1,102 @@
+#if QUARISMA_HAS_NATIVE_PROFILER
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "profiler/native/analysis/kernel_metrics.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+#include "profiler/native/session/profiler.h"
+#include "profiler/native/session/profiler_report.h"
+#include "baseTest.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+kernel_metric_sample make_launch(
+    const char* kernel, int32_t device, int64_t start_ns, int64_t duration_ns, double occupancy)
+{
+    kernel_metric_sample sample;
+    sample.kernel      = kernel;
+    sample.device      = device;
+    sample.start_ns    = start_ns;
+    sample.duration_ns = duration_ns;
+    sample.values[static_cast<size_t>(kernel_metric::achieved_occupancy)] = occupancy;
+    return sample;
+}
+
+}  // namespace
+
+QUARISMATEST(ProfilerKernelMetrics, attaches_and_summarizes)
+{
+    std::vector<kernel_metric_sample> launches{
+        make_launch("gemm", 0, 2000, 300, 40.0),
+        make_launch("gemm", 1, 1000, 100, 80.0),
+        make_launch("reduce", 0, 3000, 50, 25.0),
+    };
+    launches[2].values[static_cast<size_t>(kernel_metric::l2_hit_rate)] = 90.0;
+
+    x_space space;
+    add_kernel_metrics(&space, launches);
+    ASSERT_EQ(space.planes().size(), 2u);
+    const xplane* gpu0 = find_plane_with_name(space, GpuPlaneName(0));
+    ASSERT_NE(gpu0, nullptr);
+    ASSERT_EQ(gpu0->lines_size(), 1u);
+    EXPECT_EQ(gpu0->lines(0).name(), kKernelMetricsLineName);
+    EXPECT_EQ(gpu0->lines(0).events_size(), 2u);
+
+    auto const kernels = summarize_kernel_metrics(space);
+    ASSERT_EQ(kernels.size(), 2u);
+
+    // Longest first, with the means weighted by the launch durations
+    EXPECT_EQ(kernels[0].kernel, "gemm");
+    EXPECT_EQ(kernels[0].launches, 2u);
+    EXPECT_EQ(kernels[0].total_ns, 400);
+    EXPECT_DOUBLE_EQ(kernels[0].value(kernel_metric::achieved_occupancy), 50.0);
+    EXPECT_TRUE(std::isnan(kernels[0].value(kernel_metric::l2_hit_rate)));
+
+    EXPECT_EQ(kernels[1].kernel, "reduce");
+    EXPECT_DOUBLE_EQ(kernels[1].value(kernel_metric::l2_hit_rate), 90.0);
+
+    // Nothing to summarize without GPU planes
+    EXPECT_TRUE(summarize_kernel_metrics(x_space()).empty());
+}
+
+QUARISMATEST(ProfilerKernelMetrics, session_reports_kernels)
+{
+    auto session = profiler_session_builder()
+                       .with_hierarchical_profiling(false)
+                       .with_memory_tracking(false)
+                       .build();
+    ASSERT_TRUE(session->start());
+    ASSERT_TRUE(session->stop());
+
+    auto const start = static_cast<int64_t>(session->start_time_ns());
+    x_space    space;
+    add_kernel_metrics(&space, {make_launch("gemm", 0, start + 1000, 500, 62.5)});
+    session->add_planes(std::move(space));
+
+    const xplane* gpu = find_plane_with_name(session->collected_xspace(), GpuPlaneName(0));
+    ASSERT_NE(gpu, nullptr);
+    EXPECT_EQ(gpu->lines(0).timestamp_ns(), 1000);
+
+    profiler_report const report(*session);
+    std::string const     console = report.generate_console_report();
+    EXPECT_NE(console.find("=== GPU Kernel Metrics ==="), std::string::npos);
+    EXPECT_NE(console.find("gemm: 1 launch(es)"), std::string::npos);
+    EXPECT_NE(console.find("achieved occupancy 62.50%"), std::string::npos);
+
+    std::string const json = report.generate_json_report();
+    EXPECT_NE(json.find("\"gpu_kernels\""), std::string::npos);
+    EXPECT_NE(json.find("\"achieved_occupancy_pct\": "), std::string::npos);
+}
+
+#endif  // QUARISMA_HAS_NATIVE_PROFILER
@@ -0,0 +1,167 @@
+/**
+ * @file TestProfilerOverheadControl.cpp
+ * @brief Test suite for the per-label overhead control of profiler sessions
+ *
+ * Tests label_overhead_control and its use by profiler_scope, including:
+ * - Labels switching to sampled recording past their budget
+ * - Exact call counts next to the recorded ones
+ * - Sampled labels marked in the console and JSON reports
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "profiler/native/session/label_overhead_control.h"
+#include "profiler/native/session/profiler.h"
+#include "profiler/native/session/profiler_report.h"
+
+using namespace quarisma;
+
+namespace
+{
+label_overhead_control::label_stats stats_of(
+    const std::vector<label_overhead_control::label_stats>& labels, const std::string& label)
+{
+    for (const auto& stats : labels)
+    {
+        if (stats.label_ == label)
+        {
+            return stats;
+        }
+    }
+    return {};
+}
+
+size_t children_named(const profiler_scope_data& scope, const std::string& name)
+{
+    size_t count = 0;
+    for (const auto& child : scope.children_)
+    {
+        count += child->name_ == name ? 1 : 0;
+    }
+    return count;
+}
+}  // namespace
+
+QUARISMATEST(ProfilerOverheadControl, samples_labels_past_budget)
+{
+    label_overhead_control control(100, 4);
+    EXPECT_EQ(control.budget_ns(), 100);
+    EXPECT_EQ(control.sample_period(), 4U);
+
+    auto& hot  = control.find("hot");
+    auto& cold = control.find("cold");
+    EXPECT_EQ(&control.find("hot"), &hot);
+
+    // Under budget, every scope is recorded
+    for (int i = 0; i < 2; ++i)
+    {
+        ASSERT_TRUE(control.admit(hot));
+        control.charge(hot, 40);
+    }
+    ASSERT_TRUE(control.admit(cold));
+    control.charge(cold, 10);
+
+    // The third charge crosses the budget: then one call in four is recorded
+    ASSERT_TRUE(control.admit(hot));
+    control.charge(hot, 40);
+    size_t admitted = 0;
+    for (int call = 3; call < 19; ++call)
+    {
+        if (control.admit(hot))
+        {
+            EXPECT_EQ(call % 4, 0);
+            control.charge(hot, 40);
+            ++admitted;
+        }
+    }
+    EXPECT_EQ(admitted, 4U);
+
+    auto const labels = control.collect();
+    ASSERT_EQ(labels.size(), 2U);
+    EXPECT_EQ(labels[0].label_, "hot");
+    EXPECT_TRUE(labels[0].sampled_);
+    EXPECT_EQ(labels[0].calls_, 19U);
+    EXPECT_EQ(labels[0].recorded_, 7U);
+    EXPECT_EQ(labels[0].overhead_ns_, 280);
+    EXPECT_DOUBLE_EQ(labels[0].mean_overhead_ns(), 40.0);
+    EXPECT_EQ(labels[1].label_, "cold");
+    EXPECT_FALSE(labels[1].sampled_);
+    EXPECT_EQ(labels[1].calls_, 1U);
+
+    // A period of 0 records every call
+    label_overhead_control every(0, 0);
+    EXPECT_EQ(every.sample_period(), 1U);
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfilerOverheadControl, session_samples_hot_scopes)
+{
+    // Any recording cost exceeds the 1 ns budget, so labels are sampled from their second scope
+    auto session = profiler_session_builder().with_overhead_control(1, 10).build();
+    ASSERT_TRUE(session->start());
+    for (int i = 0; i < 1000; ++i)
+    {
+        profiler_scope scope("hot_scope", session.get());
+    }
+    {
+        profiler_scope scope("cold_scope", session.get());
+    }
+    ASSERT_TRUE(session->stop());
+
+    auto const labels = session->label_overheads();
+    auto const hot    = stats_of(labels, "hot_scope");
+    EXPECT_TRUE(hot.sampled_);
+    EXPECT_EQ(hot.calls_, 1000U);
+    EXPECT_EQ(hot.recorded_, 100U);
+    EXPECT_GT(hot.overhead_ns_, 0);
+
+    auto const cold = stats_of(labels, "cold_scope");
+    EXPECT_EQ(cold.calls_, 1U);
+    EXPECT_EQ(cold.recorded_, 1U);
+
+    // Only the recorded scopes enter the tree
+    const profiler_scope_data* root = session->get_root_scope();
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(children_named(*root, "hot_scope"), 100U);
+    EXPECT_EQ(children_named(*root, "cold_scope"), 1U);
+
+    auto const report  = session->generate_report();
+    auto const console = report->generate_console_report();
+    EXPECT_NE(console.find("=== Overhead Control ==="), std::string::npos);
+    EXPECT_NE(
+        console.find("hot_scope [sampled]: 1000 call(s), 100 recorded"), std::string::npos);
+    EXPECT_NE(console.find("(sampled from 1000 calls)"), std::string::npos);
+
+    auto const json = report->generate_json_report();
+    EXPECT_NE(json.find("\"overhead_control\": {"), std::string::npos);
+    EXPECT_NE(json.find("\"label\": \"hot_scope\""), std::string::npos);
+    EXPECT_NE(json.find("\"sampled\": true"), std::string::npos);
+
+    END_TEST();
+}
+
+QUARISMATEST(ProfilerOverheadControl, disabled_by_default)
+{
+    auto session = profiler_session_builder().build();
+    ASSERT_TRUE(session->start());
+    for (int i = 0; i < 10; ++i)
+    {
+        profiler_scope scope("plain_scope", session.get());
+    }
+    ASSERT_TRUE(session->stop());
+
+    EXPECT_TRUE(session->label_overheads().empty());
+    const profiler_scope_data* root = session->get_root_scope();
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(children_named(*root, "plain_scope"), 10U);
+    EXPECT_EQ(
+        session->generate_report()->generate_console_report().find("Overhead Control"),
+        std::string::npos);
+
+    END_TEST();
+}
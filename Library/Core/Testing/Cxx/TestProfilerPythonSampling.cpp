@@ -0,0 +1,217 @@
+#if QUARISMA_HAS_NATIVE_PROFILER
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "profiler/native/cpu/python_sampler.h"
+#include "profiler/native/cpu/sampling_profiler.h"
+#include "profiler/native/exporters/folded_stacks_exporter.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+#include "baseTest.h"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace quarisma;
+using namespace quarisma::profiler;
+
+namespace
+{
+
+// Stands in for the interpreter: the "code objects" are the names of the
+// functions, and each thread publishes the stack it is in
+struct fake_interpreter
+{
+    std::mutex                                                   mutex;
+    std::map<uint64_t, std::vector<std::pair<const char*, int>>> stacks;  // Root first
+    std::atomic<int>                                             describe_calls{0};
+};
+
+fake_interpreter& interpreter()
+{
+    static fake_interpreter instance;
+    return instance;
+}
+
+uint64_t current_tid()
+{
+#if defined(__linux__)
+    return static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+    return std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+}
+
+void read_fake_stacks(python_frame_table& frames, std::vector<python_thread_stack>& stacks)
+{
+    auto&                  fake = interpreter();
+    std::scoped_lock const lock(fake.mutex);
+    for (const auto& [tid, calls] : fake.stacks)
+    {
+        python_thread_stack stack;
+        stack.tid = tid;
+        for (auto it = calls.rbegin(); it != calls.rend(); ++it)
+        {
+            const char* function = it->first;
+            stack.frames.push_back(frames.intern(
+                function,
+                it->second,
+                [&]()
+                {
+                    ++fake.describe_calls;
+                    return python_frame{"/srv/orchestration/driver.py", function, 0};
+                }));
+        }
+        stacks.push_back(std::move(stack));
+    }
+}
+
+// Runs `work` as if called from the Python functions `calls`, root first
+template <typename Work>
+void run_in_python(std::vector<std::pair<const char*, int>> calls, Work&& work)
+{
+    uint64_t const tid = current_tid();
+    {
+        std::scoped_lock const lock(interpreter().mutex);
+        interpreter().stacks[tid] = std::move(calls);
+    }
+    work();
+    std::scoped_lock const lock(interpreter().mutex);
+    interpreter().stacks.erase(tid);
+}
+
+QUARISMA_NOINLINE double burn_cpu(std::chrono::milliseconds duration)
+{
+    double     sum      = 0;
+    auto const deadline = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        for (int i = 1; i < 10000; ++i)
+        {
+            sum += std::sqrt(static_cast<double>(i));
+        }
+    }
+    return sum;
+}
+
+}  // namespace
+
+QUARISMATEST(ProfilerPythonSampling, needs_a_reader)
+{
+    register_python_stack_reader(nullptr);
+    EXPECT_EQ(create_python_sampler(python_sampler_options{}), nullptr);
+
+    register_python_stack_reader(&read_fake_stacks);
+    python_sampler_options options;
+    options.frequency_hz = 0;
+    EXPECT_EQ(create_python_sampler(options), nullptr);
+    register_python_stack_reader(nullptr);
+}
+
+QUARISMATEST(ProfilerPythonSampling, interns_frames_and_folds_stacks)
+{
+    register_python_stack_reader(&read_fake_stacks);
+    interpreter().describe_calls = 0;
+
+    python_sampler_options options;
+    options.frequency_hz = 500;
+    auto sampler         = create_python_sampler(options);
+    ASSERT_NE(sampler, nullptr);
+    ASSERT_TRUE(sampler->start().ok());
+    EXPECT_FALSE(sampler->start().ok());
+
+    run_in_python(
+        {{"main", 10}, {"rebalance", 42}},
+        []() { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+
+    ASSERT_TRUE(sampler->stop().ok());
+    register_python_stack_reader(nullptr);
+
+    // Each frame was described once, however many samples saw it
+    EXPECT_EQ(interpreter().describe_calls.load(), 2);
+
+    x_space space;
+    ASSERT_TRUE(sampler->collect_data(&space).ok());
+    const xplane* plane = find_plane_with_name(space, kHostPythonSamplesPlaneName);
+    ASSERT_NE(plane, nullptr);
+    ASSERT_EQ(plane->lines_size(), 1u);
+    size_t const events = plane->lines(0).events_size();
+    EXPECT_GT(events, 5u);
+
+    // Without CPU samples, the Python stacks are written on their own
+    std::ostringstream folded;
+    ASSERT_TRUE(export_folded_stacks(space, folded));
+    EXPECT_EQ(
+        folded.str(),
+        "main (driver.py:10);rebalance (driver.py:42) " + std::to_string(events) + "\n");
+}
+
+#if defined(__linux__) && defined(__x86_64__)
+
+QUARISMATEST(ProfilerPythonSampling, roots_cpu_stacks_in_python_stacks)
+{
+    register_python_stack_reader(&read_fake_stacks);
+
+    sampling_profiler_options cpu_options;
+    cpu_options.frequency_hz = 250;
+    python_sampler_options python_options;
+    python_options.frequency_hz = 1000;
+
+    auto cpu    = create_sampling_profiler(cpu_options);
+    auto python = create_python_sampler(python_options);
+    ASSERT_TRUE(python->start().ok());
+    ASSERT_TRUE(cpu->start().ok());
+
+    double sum = 0;
+    run_in_python(
+        {{"main", 10}, {"price_portfolio", 7}},
+        [&]() { sum = burn_cpu(std::chrono::milliseconds(300)); });
+    EXPECT_GT(sum, 0);
+
+    ASSERT_TRUE(cpu->stop().ok());
+    ASSERT_TRUE(python->stop().ok());
+    register_python_stack_reader(nullptr);
+
+    x_space space;
+    ASSERT_TRUE(cpu->collect_data(&space).ok());
+    ASSERT_TRUE(python->collect_data(&space).ok());
+
+    std::ostringstream folded;
+    ASSERT_TRUE(export_folded_stacks(space, folded));
+    std::istringstream lines(folded.str());
+    std::string        line;
+    uint64_t           rooted = 0;
+    uint64_t           total  = 0;
+    while (std::getline(lines, line))
+    {
+        uint64_t const count = std::stoull(line.substr(line.rfind(' ') + 1));
+        total += count;
+        if (line.rfind("main (driver.py:10);price_portfolio (driver.py:7);", 0) == 0)
+        {
+            rooted += count;
+        }
+    }
+    // Samples on the sampler threads, or at the very edges, have no Python stack
+    EXPECT_GT(total, 10u);
+    EXPECT_GT(rooted, total / 2);
+}
+
+#endif  // defined(__linux__) && defined(__x86_64__)
+
+#endif  // QUARISMA_HAS_NATIVE_PROFILER
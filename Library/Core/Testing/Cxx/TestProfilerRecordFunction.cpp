@@ -0,0 +1,131 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "Testing/baseTest.h"
+#include "profiler/common/record_function.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+std::atomic<int>    g_starts{0};
+std::atomic<size_t> g_kwinputs_seen{0};
+
+std::unique_ptr<ObserverContext> count_start(const RecordFunction& rf)
+{
+    ++g_starts;
+    if (rf.needsInputs())
+    {
+        g_kwinputs_seen += rf.kwinputs().size();
+    }
+    return nullptr;
+}
+
+void reset_counters()
+{
+    clearCallbacks();
+    g_starts        = 0;
+    g_kwinputs_seen = 0;
+}
+
+}  // namespace
+
+QUARISMATEST(ProfilerRecordFunction, fast_path_without_callbacks)
+{
+    reset_counters();
+    EXPECT_FALSE(mayRunRecordFunctionCallbacks());
+    EXPECT_FALSE(getStepCallbacksUnlessEmpty(RecordScope::USER_SCOPE).has_value());
+
+    RecordFunction guard(RecordScope::USER_SCOPE);
+    EXPECT_FALSE(guard.isActive());
+    EXPECT_EQ(guard.scope(), RecordScope::USER_SCOPE);
+    guard.before("rf_inactive");
+    EXPECT_EQ(g_starts.load(), 0);
+}
+
+QUARISMATEST(ProfilerRecordFunction, callback_count_follows_registration)
+{
+    reset_counters();
+    auto const local = addThreadLocalCallback(RecordFunctionCallback(count_start));
+    EXPECT_TRUE(mayRunRecordFunctionCallbacks());
+    disableCallback(local);
+    EXPECT_FALSE(mayRunRecordFunctionCallbacks());
+    reenableCallback(local);
+    EXPECT_TRUE(mayRunRecordFunctionCallbacks());
+    {
+        RECORD_USER_SCOPE("rf_local");
+    }
+    EXPECT_EQ(g_starts.load(), 1);
+    removeCallback(local);
+    EXPECT_FALSE(mayRunRecordFunctionCallbacks());
+
+    auto const global = addGlobalCallback(RecordFunctionCallback(count_start));
+    EXPECT_TRUE(mayRunRecordFunctionCallbacks());
+    disableCallback(global);
+    removeCallback(global);
+    EXPECT_FALSE(mayRunRecordFunctionCallbacks());
+
+    // Callbacks left behind by a thread are dropped from the count on exit
+    std::thread([] { addThreadLocalCallback(RecordFunctionCallback(count_start)); }).join();
+    EXPECT_FALSE(mayRunRecordFunctionCallbacks());
+
+    addGlobalCallback(RecordFunctionCallback(count_start));
+    addThreadLocalCallback(RecordFunctionCallback(count_start));
+    clearCallbacks();
+    EXPECT_FALSE(mayRunRecordFunctionCallbacks());
+}
+
+QUARISMATEST(ProfilerRecordFunction, sampled_callback_skips_inputs)
+{
+    reset_counters();
+    set_record_function_seed_for_testing(42);
+    addThreadLocalCallback(
+        RecordFunctionCallback(count_start).samplingProb(0.01).needsInputs(true));
+
+    constexpr int kCalls = 100000;
+    int           active = 0;
+    for (int i = 0; i < kCalls; ++i)
+    {
+        RecordFunction guard(RecordScope::FUNCTION);
+        // A waiting sampled callback must not make unsampled calls capture
+        EXPECT_EQ(guard.needsInputs(), guard.isActive());
+        active += guard.isActive() ? 1 : 0;
+    }
+    EXPECT_GT(active, kCalls / 100 / 2);
+    EXPECT_LT(active, kCalls / 100 * 2);
+    clearCallbacks();
+}
+
+QUARISMATEST(ProfilerRecordFunction, inputs_are_opt_in)
+{
+    std::unordered_map<std::string, IValue> const kwargs{{"alpha", IValue()}, {"beta", IValue()}};
+
+    reset_counters();
+    addThreadLocalCallback(RecordFunctionCallback(count_start));
+    {
+        RECORD_USER_SCOPE_WITH_KWARGS_ONLY("rf_no_inputs", &kwargs);
+        EXPECT_FALSE(guard.needsInputs());
+    }
+    EXPECT_EQ(g_starts.load(), 1);
+    EXPECT_EQ(g_kwinputs_seen.load(), 0u);
+
+    reset_counters();
+    addThreadLocalCallback(RecordFunctionCallback(count_start).needsInputs(true));
+    {
+        RECORD_USER_SCOPE_WITH_KWARGS_ONLY("rf_inputs", &kwargs);
+        EXPECT_TRUE(guard.needsInputs());
+    }
+    EXPECT_EQ(g_starts.load(), 1);
+    EXPECT_EQ(g_kwinputs_seen.load(), 2u);
+    clearCallbacks();
+}
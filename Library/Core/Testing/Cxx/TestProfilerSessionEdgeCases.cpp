@@ -8,9 +8,18 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <vector>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "memory/columnar/columnar_ipc.h"
 #include "profiler/native/session/profiler.h"
 #include "profiler/native/session/profiler_report.h"
 #include "baseTest.h"
@@ -647,4 +656,96 @@ QUARISMATEST(Profiler, report_customization_data_inclusion)
     std::string output2 = report->generate_console_report();
     EXPECT_FALSE(output2.empty());
 }
+
+// Test 11: Streaming and Columnar Reports
+// Tests: write_*() match generate_*(), write_report() to a pipe, the columnar
+//        batch of the scope tree and its export
+QUARISMATEST(Profiler, report_streaming_and_columnar_export)
+{
+    profiler_options opts;
+    auto             session = std::make_unique<profiler_session>(opts);
+    EXPECT_TRUE(session->start());
+
+    {
+        profiler_scope outer("stream_outer", session.get());
+        for (int i = 0; i < 2; ++i)
+        {
+            profiler_scope inner("stream_inner", session.get());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    EXPECT_TRUE(session->stop());
+    auto report = session->generate_report();
+    ASSERT_TRUE(report != nullptr);
+
+    // Streamed reports are the generated ones, byte for byte
+    std::ostringstream json;
+    report->write_json_report(json);
+    EXPECT_EQ(json.str(), report->generate_json_report());
+
+    std::ostringstream csv;
+    report->write_report(csv, profiler_options::output_format_enum::CSV);
+    EXPECT_EQ(csv.str(), report->generate_csv_report());
+
+    std::ostringstream xml;
+    report->write_xml_report(xml);
+    EXPECT_EQ(xml.str(), report->generate_xml_report());
+
+#ifndef _WIN32
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    EXPECT_TRUE(report->write_report(fds[1], profiler_options::output_format_enum::CSV));
+    ::close(fds[1]);
+    std::string piped;
+    char        chunk[4096];
+    for (ssize_t n; (n = ::read(fds[0], chunk, sizeof(chunk))) > 0;)
+    {
+        piped.append(chunk, static_cast<size_t>(n));
+    }
+    ::close(fds[0]);
+    EXPECT_EQ(piped, csv.str());
+    EXPECT_FALSE(report->write_report(-1, profiler_options::output_format_enum::CSV));
+#endif
+
+    // One row per scope in depth-first order, names and threads interned
+    std::vector<std::string> strings;
+    auto const               batch = report->generate_columnar_report(strings);
+    ASSERT_EQ(batch.num_rows(), 4u);
+    EXPECT_EQ(batch.num_columns(), 11u);
+
+    const auto* parent = batch.find("parent")->values<int64_t>();
+    const auto* depth  = batch.find("depth")->values<uint32_t>();
+    const auto* name   = batch.find("name")->values<uint32_t>();
+    const auto* thread = batch.find("thread")->values<uint32_t>();
+    EXPECT_EQ(parent[0], -1);
+    EXPECT_EQ(depth[0], 0u);
+    ASSERT_EQ(strings.size(), 4u);  // root, outer, inner and the thread id
+    EXPECT_EQ(strings[name[1]], "stream_outer");
+    EXPECT_EQ(std::vector<int64_t>(parent + 1, parent + 4), (std::vector<int64_t>{0, 1, 1}));
+    EXPECT_EQ(name[2], name[3]);
+    EXPECT_EQ(thread[0], thread[3]);
+
+    const auto* start    = batch.find("start_ns")->values<int64_t>();
+    const auto* duration = batch.find("duration_ns")->values<int64_t>();
+    EXPECT_GE(duration[2], 1'000'000);
+    EXPECT_LE(start[2], start[3]);
+    EXPECT_GE(duration[1], duration[2] + duration[3]);
+
+    std::string const path = "test_profiler_columnar_report.qcol";
+    ASSERT_TRUE(report->export_columnar_report(path));
+    auto const mapped = columnar::map_file(path);
+    ASSERT_TRUE(mapped.has_value());
+    EXPECT_EQ(mapped->num_rows(), 4u);
+    EXPECT_EQ(mapped->find("depth")->values<uint32_t>()[3], 2u);
+
+    std::ifstream     names(path + ".strings.json");
+    std::stringstream names_json;
+    names_json << names.rdbuf();
+    EXPECT_NE(names_json.str().find("\"stream_inner\""), std::string::npos);
+    names.close();
+
+    std::remove(path.c_str());
+    std::remove((path + ".strings.json").c_str());
+}
 #endif  // QUARISMA_HAS_NATIVE_PROFILER
@@ -0,0 +1,237 @@
+#if QUARISMA_HAS_NATIVE_PROFILER
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "profiler/native/exporters/chrome_trace_exporter.h"
+#include "profiler/native/exporters/trace_stream_exporter.h"
+#include "profiler/native/tracing/traceme.h"
+#include "profiler/native/tracing/traceme_recorder.h"
+#include "baseTest.h"
+
+using namespace quarisma;
+using namespace quarisma::profiler;
+
+namespace
+{
+
+/**
+ * @brief Sink appending to a string shared with the test.
+ */
+trace_stream_sink make_string_sink(std::shared_ptr<std::string> out)
+{
+    return [out](const char* data, size_t size)
+    {
+        out->append(data, size);
+        return true;
+    };
+}
+
+void wait_for_drain(const trace_stream_writer& writer, uint64_t drains)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (writer.stats().drains <= drains && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+}  // namespace
+
+QUARISMATEST(Profiler, trace_stream_writes_events_incrementally)
+{
+    auto                 bytes = std::make_shared<std::string>();
+    trace_stream_options options;
+    options.flush_interval = std::chrono::milliseconds(1);
+    trace_stream_writer writer(make_string_sink(bytes), options);
+    ASSERT_TRUE(writer.start());
+    EXPECT_TRUE(writer.is_running());
+
+    // The writer owns the traceme session
+    EXPECT_FALSE(traceme_recorder::start(1));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        traceme const trace("stream_work");
+    }
+    wait_for_drain(writer, 0);
+    wait_for_drain(writer, writer.stats().drains);
+
+    // Written before the capture stops
+    EXPECT_EQ(writer.stats().events_written, 10u);
+    EXPECT_GT(writer.stats().bytes_written, 8u);
+    EXPECT_EQ(writer.stats().bytes_written, bytes->size());
+
+    // A split activity whose start is drained before its end is recorded
+    int64_t const activity = traceme::activity_start("stream_split");
+    wait_for_drain(writer, writer.stats().drains);
+    std::thread ending([activity]() { traceme::activity_end(activity); });
+    std::thread other([]() { traceme const trace("stream_other_thread"); });
+    ending.join();
+    other.join();
+
+    EXPECT_TRUE(writer.stop());
+    EXPECT_FALSE(writer.is_running());
+    EXPECT_FALSE(writer.stop());
+    EXPECT_EQ(writer.stats().events_dropped, 0u);
+
+    std::istringstream  in(*bytes);
+    trace_stream_reader reader(in);
+    ASSERT_TRUE(reader.valid());
+
+    std::map<std::string, int> names;
+    size_t                     threads = 0;
+    uint64_t                   events  = 0;
+    trace_stream_record        record;
+    while (reader.next(&record))
+    {
+        if (record.kind == trace_stream_record_kind::kThread)
+        {
+            ++threads;
+        }
+        else if (record.kind == trace_stream_record_kind::kEvent)
+        {
+            ++names[record.name];
+            ++events;
+        }
+        else if (record.kind == trace_stream_record_kind::kEnd)
+        {
+            EXPECT_EQ(record.event_count, events);
+        }
+    }
+    EXPECT_TRUE(reader.complete());
+    EXPECT_EQ(threads, 3u);
+    EXPECT_EQ(names["stream_work"], 10);
+    EXPECT_EQ(names["stream_other_thread"], 1);
+
+    // Offline conversion pairs the two halves of the split activity
+    std::istringstream converted(*bytes);
+    std::ostringstream json;
+    ASSERT_TRUE(export_trace_stream_to_chrome_json(converted, json));
+    EXPECT_NE(json.str().find("\"stream_split\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.str().find("thread_name"), std::string::npos);
+    EXPECT_NE(json.str().find("displayTimeUnit"), std::string::npos);
+}
+
+QUARISMATEST(Profiler, trace_stream_writes_uninterned_names_inline)
+{
+    auto                 bytes = std::make_shared<std::string>();
+    trace_stream_options options;
+    options.max_interned_names = 1;
+    options.buffer_bytes       = 1;
+    {
+        trace_stream_writer writer(make_string_sink(bytes), options);
+        ASSERT_TRUE(writer.start());
+        {
+            traceme const first("interned_name");
+        }
+        {
+            traceme const second("inline_name");
+        }
+        // Stopped by the destructor
+    }
+
+    std::istringstream  in(*bytes);
+    trace_stream_reader reader(in);
+    std::string         names;
+    trace_stream_record record;
+    while (reader.next(&record))
+    {
+        if (record.kind == trace_stream_record_kind::kEvent)
+        {
+            names += record.name + ";";
+        }
+    }
+    EXPECT_TRUE(reader.complete());
+    EXPECT_EQ(names, "interned_name;inline_name;");
+}
+
+QUARISMATEST(Profiler, trace_stream_failures)
+{
+    // Empty and failing sinks
+    EXPECT_FALSE(trace_stream_writer(trace_stream_sink()).start());
+    EXPECT_FALSE(trace_stream_writer([](const char*, size_t) { return false; }).start());
+    EXPECT_FALSE(traceme_recorder::active(0));
+    {
+        // Accepts the header only
+        int                 writes = 0;
+        trace_stream_writer writer([&writes](const char*, size_t) { return writes++ == 0; });
+        ASSERT_TRUE(writer.start());
+        {
+            traceme const trace("dropped");
+        }
+        EXPECT_FALSE(writer.stop());
+        EXPECT_EQ(writer.stats().events_written, 0u);
+        EXPECT_EQ(writer.stats().events_dropped, 1u);
+    }
+
+    // Not a trace stream
+    std::istringstream not_a_stream("{\"traceEvents\": []}");
+    std::ostringstream json;
+    EXPECT_FALSE(export_trace_stream_to_chrome_json(not_a_stream, json));
+
+    // A truncated stream converts up to the cut
+    auto bytes = std::make_shared<std::string>();
+    {
+        trace_stream_writer writer(make_string_sink(bytes));
+        ASSERT_TRUE(writer.start());
+        {
+            traceme const trace("before_cut");
+        }
+        EXPECT_TRUE(writer.stop());
+    }
+    std::istringstream  cut(bytes->substr(0, bytes->size() - 1));
+    trace_stream_reader reader(cut);
+    trace_stream_record record;
+    while (reader.next(&record))
+    {
+    }
+    EXPECT_TRUE(reader.valid());
+    EXPECT_FALSE(reader.complete());
+
+    std::istringstream truncated(bytes->substr(0, bytes->size() - 1));
+    EXPECT_TRUE(export_trace_stream_to_chrome_json(truncated, json));
+    EXPECT_NE(json.str().find("before_cut"), std::string::npos);
+}
+
+QUARISMATEST(Profiler, trace_stream_file_round_trip)
+{
+    const auto dir         = std::filesystem::temp_directory_path();
+    const auto stream_path = (dir / "quarisma_trace_stream_test.qtrs").string();
+    const auto json_path   = (dir / "quarisma_trace_stream_test.json").string();
+
+    trace_stream_sink sink = make_trace_file_sink(stream_path);
+    ASSERT_TRUE(static_cast<bool>(sink));
+    {
+        trace_stream_writer writer(std::move(sink));
+        ASSERT_TRUE(writer.start());
+        {
+            traceme const trace("file_event");
+        }
+        EXPECT_TRUE(writer.stop());
+    }
+
+    ASSERT_TRUE(export_trace_stream_to_chrome_json_file(stream_path, json_path));
+    std::ifstream     file(json_path);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_NE(content.str().find("file_event"), std::string::npos);
+
+    EXPECT_FALSE(static_cast<bool>(make_trace_file_sink((dir / "missing" / "x.qtrs").string())));
+    std::remove(stream_path.c_str());
+    std::remove(json_path.c_str());
+}
+
+#endif  // QUARISMA_HAS_NATIVE_PROFILER
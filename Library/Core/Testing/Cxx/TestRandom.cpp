@@ -0,0 +1,304 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "Testing/cpuCapabilityTest.h"
+#include "math/random.h"
+#include "math/random_dispatch.h"
+#include "util/cpu_info.h"
+
+using namespace quarisma;
+using random::array4x32;
+using random::generator;
+
+namespace
+{
+constexpr generator generators[] = {generator::philox4x32, generator::threefry4x32};
+
+constexpr uint64_t key    = 0x0123456789ABCDEFULL;
+constexpr uint64_t stream = 0xFEDCBA9876543210ULL;
+constexpr double   two_pi = 6.283185307179586;
+
+template <typename T>
+auto kernel_of(cpu_capability c)
+{
+    if constexpr (std::is_same_v<T, double>)
+    {
+        return random::detail::double_fill_stub_type::kernel(c);
+    }
+    else
+    {
+        return random::detail::float_fill_stub_type::kernel(c);
+    }
+}
+
+// Block n of the stream, straight from random.h
+array4x32 block_of(generator g, uint64_t n)
+{
+    array4x32 const counter = {
+        {static_cast<uint32_t>(n),
+         static_cast<uint32_t>(n >> 32),
+         static_cast<uint32_t>(stream),
+         static_cast<uint32_t>(stream >> 32)}};
+    auto const lo = static_cast<uint32_t>(key);
+    auto const hi = static_cast<uint32_t>(key >> 32);
+    return g == generator::philox4x32 ? random::philox4x32::generate(counter, {{lo, hi}})
+                                      : random::threefry4x32::generate(counter, {{lo, hi, 0, 0}});
+}
+
+// Values [first, first + n) by the table of random.h, with the std:: functions
+template <typename T>
+std::vector<T> reference(generator g, bool normal, uint64_t first, size_t n)
+{
+    std::vector<T> result;
+    for (uint64_t i = first; i < first + n; ++i)
+    {
+        if constexpr (std::is_same_v<T, double>)
+        {
+            array4x32 const w  = block_of(g, i / 2);
+            double const    u1 = random::uniform_double(w.v[0], w.v[1]);
+            double const    u2 = random::uniform_double(w.v[2], w.v[3]);
+            if (!normal)
+            {
+                result.push_back(i % 2 == 0 ? u1 : u2);
+                continue;
+            }
+            double const r     = std::sqrt(-2 * std::log(u1));
+            double const theta = two_pi * u2;
+            result.push_back(i % 2 == 0 ? r * std::cos(theta) : r * std::sin(theta));
+        }
+        else
+        {
+            array4x32 const w = block_of(g, i / 4);
+            if (!normal)
+            {
+                result.push_back(random::uniform_float(w.v[i % 4]));
+                continue;
+            }
+            size_t const pair  = i % 4 / 2;
+            double const u1    = random::uniform_float(w.v[2 * pair]);
+            double const u2    = random::uniform_float(w.v[2 * pair + 1]);
+            double const r     = std::sqrt(-2 * std::log(u1));
+            double const theta = two_pi * u2;
+            double const z     = i % 2 == 0 ? r * std::cos(theta) : r * std::sin(theta);
+            result.push_back(static_cast<float>(z));
+        }
+    }
+    return result;
+}
+
+template <typename T>
+void fill(generator g, bool normal, uint64_t first, T* out, size_t n)
+{
+    normal ? random::normal(g, key, stream, first, out, n)
+           : random::uniform(g, key, stream, first, out, n);
+}
+
+template <typename T>
+void check_splits(generator g, bool normal, size_t n)
+{
+    std::vector<T> whole(n);
+    fill(g, normal, 3, whole.data(), n);
+
+    std::vector<T> pieces(n);
+    size_t         done = 0;
+    for (size_t step = 1; done < n; step = step * 3 + 1)
+    {
+        size_t const count = std::min(step, n - done);
+        fill(g, normal, 3 + done, pieces.data() + done, count);
+        done += count;
+    }
+    EXPECT_EQ(whole, pieces) << "normal " << normal;
+}
+
+// Every kernel, at every offset and length around a block and a chunk, against reference()
+template <typename T>
+void check_kernels(bool normal, double tolerance)
+{
+    auto const distribution =
+        normal ? random::detail::distribution::normal : random::detail::distribution::uniform;
+    for (generator g : generators)
+    {
+        auto const expected = reference<T>(g, normal, 1000, 600);
+        for (cpu_capability c : capabilities())
+        {
+            auto const kernel = kernel_of<T>(c);
+            if (kernel == nullptr)
+            {
+                continue;
+            }
+            for (size_t offset : {0, 1, 2, 3, 5, 130, 257})
+            {
+                for (size_t n : {1, 2, 3, 7, 64, 129, 257, 343})
+                {
+                    std::vector<T> out(n + 1, T{-7});
+                    kernel(g, distribution, key, stream, 1000 + offset, out.data(), n);
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        T const e = expected[offset + i];
+                        ASSERT_NEAR(out[i], e, tolerance * std::fmax(1, std::fabs(e)))
+                            << "capability " << static_cast<int>(c) << ", value " << offset + i;
+                    }
+                    ASSERT_EQ(out[n], T{-7});
+                }
+            }
+        }
+    }
+}
+}  // namespace
+
+QUARISMATEST(Random, known_answers)
+{
+    // Random123's known-answer vectors
+    array4x32 const zero = {{0, 0, 0, 0}};
+    array4x32 const ones = {{0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF}};
+    array4x32 const pi   = {{0x243F6A88, 0x85A308D3, 0x13198A2E, 0x03707344}};
+
+    struct known
+    {
+        array4x32 result;
+        array4x32 expected;
+    };
+
+    known const philox[] = {
+        {random::philox4x32::generate(zero, {{0, 0}}),
+         {{0x6627E8D5, 0xE169C58D, 0xBC57AC4C, 0x9B00DBD8}}},
+        {random::philox4x32::generate(ones, {{0xFFFFFFFF, 0xFFFFFFFF}}),
+         {{0x408F276D, 0x41C83B0E, 0xA20BC7C6, 0x6D5451FD}}},
+        {random::philox4x32::generate(pi, {{0xA4093822, 0x299F31D0}}),
+         {{0xD16CFE09, 0x94FDCCEB, 0x5001E420, 0x24126EA1}}},
+    };
+    known const threefry[] = {
+        {random::threefry4x32::generate(zero, {{0, 0, 0, 0}}),
+         {{0x9C6CA96A, 0xE17EAE66, 0xFC10ECD4, 0x5256A7D8}}},
+        {random::threefry4x32::generate(ones, {{0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF}}),
+         {{0x2A881696, 0x57012287, 0xF6C7446E, 0xA16A6732}}},
+        {random::threefry4x32::generate(pi, {{0xA4093822, 0x299F31D0, 0x082EFA98, 0xEC4E6C89}}),
+         {{0x59CD1DBB, 0xB8879579, 0x86B5D00C, 0xAC8B6D84}}},
+    };
+
+    for (const auto& k : philox)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(k.result.v[i], k.expected.v[i]) << "philox4x32, word " << i;
+        }
+    }
+    for (const auto& k : threefry)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(k.result.v[i], k.expected.v[i]) << "threefry4x32, word " << i;
+        }
+    }
+
+    // The block functions are constexpr
+    static_assert(random::philox4x32::generate({{1, 2, 3, 4}}, {{5, 6}}).v[0] != 0);
+
+    END_TEST();
+}
+
+QUARISMATEST(Random, uniform)
+{
+    check_kernels<double>(false, 0);
+    check_kernels<float>(false, 0);
+
+    EXPECT_EQ(random::uniform_double(0, 0), 0x1p-54);
+    EXPECT_EQ(random::uniform_double(0xFFFFFFFF, 0xFFFFFFFF), 1 - 0x1p-54);
+    EXPECT_EQ(random::uniform_float(0), 0x1p-25f);
+    EXPECT_EQ(random::uniform_float(0xFFFFFFFF), 1 - 0x1p-25f);
+
+    END_TEST();
+}
+
+QUARISMATEST(Random, normal)
+{
+    check_kernels<double>(true, 1e-14);
+    check_kernels<float>(true, 1e-6);
+
+    END_TEST();
+}
+
+QUARISMATEST(Random, reproducible)
+{
+    // Parallel batches give the values of any other split of the stream
+    size_t const n = 5 * random::parallel_grain + 11;
+    for (generator g : generators)
+    {
+        for (bool normal : {false, true})
+        {
+            check_splits<double>(g, normal, n);
+            check_splits<float>(g, normal, n);
+        }
+    }
+
+    // Other streams and keys are other sequences
+    std::vector<double> a(64);
+    std::vector<double> b(64);
+    random::uniform(generator::philox4x32, key, stream, 0, a.data(), a.size());
+    random::uniform(generator::philox4x32, key, stream + 1, 0, b.data(), b.size());
+    EXPECT_NE(a, b);
+    random::uniform(generator::philox4x32, key + 1, stream, 0, b.data(), b.size());
+    EXPECT_NE(a, b);
+    random::uniform(generator::threefry4x32, key, stream, 0, b.data(), b.size());
+    EXPECT_NE(a, b);
+
+    END_TEST();
+}
+
+QUARISMATEST(Random, moments)
+{
+    size_t const n = size_t{1} << 20;
+    for (generator g : generators)
+    {
+        std::vector<double> u(n);
+        random::uniform(g, key, 0, 0, u.data(), n);
+        std::vector<double> z(n);
+        random::normal(g, key, 0, 0, z.data(), n);
+
+        double u_sum = 0, u_squares = 0, z_sum = 0, z_squares = 0, z_fourth = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_GT(u[i], 0.0);
+            ASSERT_LT(u[i], 1.0);
+            u_sum += u[i];
+            u_squares += u[i] * u[i];
+            z_sum += z[i];
+            z_squares += z[i] * z[i];
+            z_fourth += z[i] * z[i] * z[i] * z[i];
+        }
+
+        // Five standard errors of each estimate
+        double const samples = static_cast<double>(n);
+        EXPECT_NEAR(u_sum / samples, 0.5, 5 * std::sqrt(1 / 12.0 / samples));
+        EXPECT_NEAR(u_squares / samples, 1 / 3.0, 5 * std::sqrt(4 / 45.0 / samples));
+        EXPECT_NEAR(z_sum / samples, 0.0, 5 / std::sqrt(samples));
+        EXPECT_NEAR(z_squares / samples, 1.0, 5 * std::sqrt(2 / samples));
+        EXPECT_NEAR(z_fourth / samples, 3.0, 5 * std::sqrt(96 / samples));
+    }
+
+    END_TEST();
+}
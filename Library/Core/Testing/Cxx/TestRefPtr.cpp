@@ -0,0 +1,172 @@
+/**
+ * @file TestRefPtr.cpp
+ * @brief Test suite for ref_counted and ref_ptr
+ *
+ * Tests the weak-reference-free reference counting including:
+ * - Ownership transfer: copies, moves, conversions, release and adopt
+ * - Destruction as the derived type with the last reference
+ * - The single-threaded local_refcount policy
+ * - Concurrent copies under atomic_refcount
+ */
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "common/ref_ptr.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+int destroyed = 0;
+
+class shared_node : public ref_counted<shared_node>
+{
+public:
+    explicit shared_node(int value) : value(value) {}
+    ~shared_node() { ++destroyed; }
+
+    int value;
+};
+
+class local_node : public ref_counted<local_node, local_refcount>
+{
+public:
+    ~local_node() { ++destroyed; }
+
+    std::vector<ref_ptr<local_node>> inputs;
+};
+
+class base_node : public ref_counted<base_node>
+{
+public:
+    virtual ~base_node() = default;
+};
+
+class derived_node : public base_node
+{
+public:
+    ~derived_node() override { ++destroyed; }
+};
+
+}  // namespace
+
+QUARISMATEST(RefPtr, ownership)
+{
+    destroyed = 0;
+    {
+        ref_ptr<shared_node> a = make_ref<shared_node>(7);
+        EXPECT_TRUE(a.unique());
+        EXPECT_EQ(a->value, 7);
+
+        ref_ptr<shared_node> b = a;
+        EXPECT_EQ(a.use_count(), 2u);
+        EXPECT_EQ(a, b);
+
+        ref_ptr<shared_node> c = std::move(b);
+        EXPECT_EQ(b, nullptr);
+        EXPECT_EQ(b.use_count(), 0u);
+        EXPECT_EQ(a.use_count(), 2u);
+
+        // The count lives in the object, so a raw pointer can be shared again
+        ref_ptr<shared_node> d(c.get());
+        EXPECT_EQ(a.use_count(), 3u);
+
+        shared_node* raw = d.release();
+        EXPECT_FALSE(d);
+        EXPECT_EQ(a.use_count(), 3u);
+        ref_ptr<shared_node> e = ref_ptr<shared_node>::adopt(raw);
+        EXPECT_EQ(a.use_count(), 3u);
+
+        c = nullptr;
+        e.reset();
+        EXPECT_TRUE(a.unique());
+        EXPECT_EQ(destroyed, 0);
+
+        // Copying an object does not copy its references
+        shared_node copy(*a);
+        EXPECT_EQ(copy.use_count(), 0u);
+    }
+    EXPECT_EQ(destroyed, 2);
+
+    std::unordered_set<ref_ptr<shared_node>> set;
+    auto                                     x = make_ref<shared_node>(1);
+    set.insert(x);
+    set.insert(x);
+    EXPECT_EQ(set.size(), 1u);
+    EXPECT_EQ(x.use_count(), 2u);
+}
+
+QUARISMATEST(RefPtr, deletes_derived)
+{
+    destroyed = 0;
+    {
+        ref_ptr<derived_node> derived = make_ref<derived_node>();
+        ref_ptr<base_node>    base    = derived;
+        EXPECT_EQ(base.use_count(), 2u);
+        derived.reset();
+        EXPECT_EQ(destroyed, 0);
+
+        ref_ptr<base_node> moved(make_ref<derived_node>());
+        EXPECT_TRUE(moved.unique());
+    }
+    EXPECT_EQ(destroyed, 2);
+
+    static_assert(sizeof(ref_ptr<local_node>) == sizeof(void*));
+    static_assert(!std::is_polymorphic_v<shared_node>);
+}
+
+QUARISMATEST(RefPtr, local_refcount)
+{
+    destroyed = 0;
+    {
+        auto root = make_ref<local_node>();
+        auto leaf = make_ref<local_node>();
+        for (int i = 0; i < 10; ++i)
+        {
+            root->inputs.push_back(leaf);
+        }
+        EXPECT_EQ(leaf.use_count(), 11u);
+
+        root->inputs.resize(2);
+        EXPECT_EQ(leaf.use_count(), 3u);
+        leaf.reset();
+        EXPECT_EQ(destroyed, 0);
+    }
+    EXPECT_EQ(destroyed, 2);
+}
+
+QUARISMATEST(RefPtr, concurrent_copies)
+{
+    destroyed = 0;
+    {
+        auto                     shared = make_ref<shared_node>(3);
+        std::atomic<int>         sum{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back(
+                [&shared, &sum]
+                {
+                    for (int i = 0; i < 10000; ++i)
+                    {
+                        ref_ptr<shared_node> copy = shared;
+                        ref_ptr<shared_node> moved(std::move(copy));
+                        sum.fetch_add(moved->value, std::memory_order_relaxed);
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        EXPECT_EQ(sum, 4 * 10000 * 3);
+        EXPECT_TRUE(shared.unique());
+    }
+    EXPECT_EQ(destroyed, 1);
+}
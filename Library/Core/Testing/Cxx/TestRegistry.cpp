@@ -0,0 +1,192 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "util/frozen_map.h"
+#include "util/registry.h"
+
+using namespace quarisma;
+
+namespace
+{
+struct shape
+{
+    virtual ~shape()          = default;
+    virtual int sides() const = 0;
+};
+
+struct triangle : shape
+{
+    int sides() const override { return 3; }
+};
+
+struct square : shape
+{
+    int sides() const override { return 4; }
+};
+
+int twice(int& x, int& y)
+{
+    return 2 * (x + y);
+}
+
+int thrice(int& x, int& y)
+{
+    return 3 * (x + y);
+}
+
+// Every key hashes alike: no perfect hash exists
+struct constant_hash
+{
+    size_t operator()(int /*key*/) const { return 42; }
+};
+}  // namespace
+
+QUARISMA_DECLARE_REGISTRY(ShapeRegistry, shape);
+QUARISMA_DEFINE_REGISTRY(ShapeRegistry, shape);
+QUARISMA_REGISTER_CLASS(ShapeRegistry, triangle, triangle);
+QUARISMA_REGISTER_CLASS(ShapeRegistry, square, square);
+
+QUARISMATEST(FrozenMap, lookup)
+{
+    // Sizes around the bucket count boundaries, string and integer keys alike
+    for (size_t const n :
+         {size_t{1}, size_t{2}, size_t{3}, size_t{17}, size_t{1000}, size_t{50000}})
+    {
+        std::vector<std::pair<std::string, size_t>> named;
+        std::vector<std::pair<int, size_t>>         numbered;
+        for (size_t i = 0; i < n; ++i)
+        {
+            named.emplace_back("key_" + std::to_string(i), i);
+            numbered.emplace_back(static_cast<int>(i * 7919), i);
+        }
+
+        frozen_map<std::string, size_t> const by_name(named);
+        frozen_map<int, size_t> const         by_number(numbered);
+        ASSERT_EQ(by_name.size(), n);
+        ASSERT_EQ(by_number.size(), n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const size_t* value = by_name.find("key_" + std::to_string(i));
+            ASSERT_TRUE(value != nullptr);
+            ASSERT_EQ(*value, i);
+            value = by_number.find(static_cast<int>(i * 7919));
+            ASSERT_TRUE(value != nullptr);
+            ASSERT_EQ(*value, i);
+        }
+
+        // Absent keys
+        for (size_t i = n; i < n + 100; ++i)
+        {
+            EXPECT_FALSE(by_name.contains("key_" + std::to_string(i)));
+            EXPECT_FALSE(by_number.contains(static_cast<int>(i * 7919)));
+        }
+        EXPECT_FALSE(by_number.contains(1));
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(FrozenMap, duplicates_empty_and_degenerate_hash)
+{
+    // The last entry of a key wins
+    frozen_map<std::string, int> map({{"a", 1}, {"b", 2}, {"a", 3}, {"c", 4}, {"b", 5}});
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_EQ(*map.find("a"), 3);
+    EXPECT_EQ(*map.find("b"), 5);
+    EXPECT_EQ(*map.find("c"), 4);
+
+    *map.find("c") = 6;
+    EXPECT_EQ(*map.find("c"), 6);
+
+    size_t visited = 0;
+    for (const auto& entry : map)
+    {
+        EXPECT_EQ(map.find(entry.first), &entry.second);
+        ++visited;
+    }
+    EXPECT_EQ(visited, 3u);
+
+    frozen_map<std::string, int> const empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.find("a"), nullptr);
+
+    frozen_map<int, int, constant_hash> const single({{1, 1}});
+    EXPECT_EQ(*single.find(1), 1);
+    EXPECT_EQ(single.find(2), nullptr);
+
+    using degenerate = frozen_map<int, int, constant_hash>;
+    ASSERT_ANY_THROW(degenerate({{1, 1}, {2, 2}, {3, 3}}));
+
+    END_TEST();
+}
+
+QUARISMATEST(Registry, function_registry)
+{
+    using function_type = int (*)(int&, int&);
+    Registry<std::string, function_type> registry;
+
+    registry.Register("twice", &twice);
+    registry.Register("thrice", &thrice);
+
+    int x = 1;
+    int y = 2;
+    EXPECT_TRUE(registry.Has("twice"));
+    EXPECT_FALSE(registry.Has("once"));
+    EXPECT_EQ(registry.run("twice", x, y), 6);
+    EXPECT_EQ(registry.run("thrice", x, y), 9);
+
+    // Registering after the first lookup thaws the registry; the later entry of a key wins
+    registry.Register("once", [](int& a, int& b) { return a + b; });
+    registry.Register("twice", &thrice);
+    registry.Freeze();
+    EXPECT_EQ(registry.run("once", x, y), 3);
+    EXPECT_EQ(registry.run("twice", x, y), 9);
+    EXPECT_EQ(registry.Keys().size(), 3u);
+
+    END_TEST();
+}
+
+QUARISMATEST(Registry, typed_registry)
+{
+    ShapeRegistry()->Freeze();
+
+    EXPECT_TRUE(ShapeRegistry()->Has("triangle"));
+    EXPECT_TRUE(ShapeRegistry()->Has("square"));
+    EXPECT_FALSE(ShapeRegistry()->Has("circle"));
+
+    auto square_shape = ShapeRegistry()->run("square");
+    ASSERT_TRUE(square_shape != nullptr);
+    EXPECT_EQ(square_shape->sides(), 4);
+    EXPECT_EQ(ShapeRegistry()->run("triangle")->sides(), 3);
+    EXPECT_EQ(ShapeRegistry()->run("circle"), nullptr);
+
+    auto keys = ShapeRegistry()->Keys();
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(keys, (std::vector<std::string>{"square", "triangle"}));
+
+    END_TEST();
+}
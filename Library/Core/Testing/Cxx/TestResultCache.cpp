@@ -0,0 +1,242 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "memory/result_cache.h"
+#include "memory/visualization/web_dashboard.h"
+
+using namespace quarisma;
+
+namespace
+{
+result_cache::options make_options(size_t budget, result_cache::eviction_policy policy)
+{
+    result_cache::options opts;
+    opts.byte_budget = budget;
+    opts.shards      = 1;  // One LRU list, so that eviction order is predictable
+    opts.policy      = policy;
+    opts.name        = "";
+    return opts;
+}
+
+result_cache::key_type key_of(uint64_t instrument, uint64_t version)
+{
+    return result_cache::make_key(
+        {as_byte_range(&instrument, sizeof(instrument)), as_byte_range(&version, sizeof(version))});
+}
+
+buffer_ptr make_result(result_cache& cache, size_t size, uint8_t fill)
+{
+    auto out = cache.allocate(size);
+    std::memset(out->mutable_data(), fill, size);
+    return out;
+}
+}  // namespace
+
+QUARISMATEST(ResultCache, keys_address_content)
+{
+    EXPECT_EQ(key_of(1, 2), key_of(1, 2));
+    EXPECT_NE(key_of(1, 2), key_of(2, 1));
+
+    // Parts are length-prefixed: "ab" + "c" differs from "a" + "bc"
+    EXPECT_NE(
+        result_cache::make_key({as_byte_range("ab"), as_byte_range("c")}),
+        result_cache::make_key({as_byte_range("a"), as_byte_range("bc")}));
+
+    END_TEST();
+}
+
+QUARISMATEST(ResultCache, computes_once_then_hits)
+{
+    result_cache cache(make_options(1 << 20, result_cache::eviction_policy::LRU));
+
+    int  computed = 0;
+    auto compute  = [&]
+    {
+        ++computed;
+        return make_result(cache, 64, 7);
+    };
+
+    auto first  = cache.get_or_compute(key_of(1, 1), compute);
+    auto second = cache.get_or_compute(key_of(1, 1), compute);
+    EXPECT_EQ(computed, 1);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(second->data()[63], 7);
+
+    auto const stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.entries, 1U);
+    EXPECT_EQ(stats.bytes, 64U);
+
+    EXPECT_TRUE(cache.erase(key_of(1, 1)));
+    EXPECT_FALSE(cache.get(key_of(1, 1)));
+    EXPECT_EQ(cache.stats().bytes, 0U);
+
+    // Failures reach the caller and are not cached
+    EXPECT_THROW(
+        cache.get_or_compute(
+            key_of(2, 1), []() -> buffer_ptr { throw std::runtime_error("no market data"); }),
+        std::runtime_error);
+    EXPECT_EQ(cache.stats().failures, 1);
+    EXPECT_FALSE(cache.get(key_of(2, 1)));
+
+    END_TEST();
+}
+
+QUARISMATEST(ResultCache, lru_evicts_within_budget)
+{
+    result_cache cache(make_options(4096, result_cache::eviction_policy::LRU));
+
+    for (uint64_t i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(cache.put(key_of(i, 0), make_result(cache, 1024, 0)));
+    }
+    cache.get(key_of(0, 0));  // 1 becomes the least recently used
+    EXPECT_TRUE(cache.put(key_of(4, 0), make_result(cache, 1024, 0)));
+
+    EXPECT_TRUE(cache.get(key_of(0, 0)));
+    EXPECT_FALSE(cache.get(key_of(1, 0)));
+    EXPECT_EQ(cache.stats().evictions, 1);
+    EXPECT_EQ(cache.stats().bytes, 4096U);
+
+    // Larger than the budget: never cached
+    EXPECT_FALSE(cache.put(key_of(5, 0), make_result(cache, 8192, 0)));
+
+    EXPECT_EQ(cache.release(2048), 2048U);
+    EXPECT_EQ(cache.stats().entries, 2U);
+    cache.clear();
+    EXPECT_EQ(cache.stats().entries, 0U);
+
+    END_TEST();
+}
+
+QUARISMATEST(ResultCache, tiny_lfu_keeps_popular_results)
+{
+    result_cache cache(make_options(4096, result_cache::eviction_policy::TINY_LFU));
+
+    for (uint64_t i = 0; i < 4; ++i)
+    {
+        cache.put(key_of(i, 0), make_result(cache, 1024, 0));
+        for (int j = 0; j < 5; ++j)
+        {
+            cache.get(key_of(i, 0));
+        }
+    }
+
+    // A scan of one-off results does not flush the popular ones
+    for (uint64_t i = 100; i < 200; ++i)
+    {
+        EXPECT_FALSE(cache.put(key_of(i, 0), make_result(cache, 1024, 0)));
+    }
+    for (uint64_t i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(cache.get(key_of(i, 0)));
+    }
+    EXPECT_EQ(cache.stats().rejections, 100);
+
+    // A result asked for more often than the least recent one gets in
+    for (int j = 0; j < 10; ++j)
+    {
+        cache.get(key_of(500, 0));
+    }
+    EXPECT_TRUE(cache.put(key_of(500, 0), make_result(cache, 1024, 0)));
+
+    END_TEST();
+}
+
+QUARISMATEST(ResultCache, coalesces_concurrent_misses)
+{
+    result_cache cache(make_options(1 << 20, result_cache::eviction_policy::TINY_LFU));
+
+    std::atomic<int>         computed{0};
+    std::atomic<int>         started{0};
+    std::vector<std::thread> threads;
+    std::vector<buffer_ptr>  results(8);
+    for (size_t t = 0; t < results.size(); ++t)
+    {
+        threads.emplace_back(
+            [&, t]
+            {
+                ++started;
+                results[t] = cache.get_or_compute(
+                    key_of(42, 7),
+                    [&]
+                    {
+                        ++computed;
+                        // Long enough for the other threads to miss meanwhile
+                        while (started.load() < static_cast<int>(results.size()))
+                        {
+                            std::this_thread::yield();
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                        return make_result(cache, 128, 3);
+                    });
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(computed.load(), 1);
+    for (const auto& result : results)
+    {
+        EXPECT_EQ(result.get(), results[0].get());
+    }
+    auto const stats = cache.stats();
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.hits + stats.coalesced, 7);
+
+    END_TEST();
+}
+
+QUARISMATEST(ResultCache, dashboard_exports_counters)
+{
+    result_cache  cache(make_options(1 << 20, result_cache::eviction_policy::LRU));
+    web_dashboard dashboard;
+    ASSERT_TRUE(dashboard.register_result_cache("pricing", &cache));
+    EXPECT_FALSE(dashboard.register_result_cache("pricing", &cache));
+
+    cache.get(key_of(1, 1));
+    cache.put(key_of(1, 1), make_result(cache, 256, 0));
+    cache.get(key_of(1, 1));
+
+    const std::string labels = "cache=\"pricing\"";
+    EXPECT_EQ(dashboard.metrics().value("result_cache_hits_total", labels), 1);
+    EXPECT_EQ(dashboard.metrics().value("result_cache_misses_total", labels), 1);
+    EXPECT_EQ(dashboard.metrics().value("result_cache_bytes", labels), 256);
+    EXPECT_NE(
+        dashboard.export_prometheus_metrics().find("result_cache_hits_total{" + labels + "} 1"),
+        std::string::npos);
+
+    EXPECT_TRUE(dashboard.unregister_result_cache("pricing"));
+    EXPECT_EQ(dashboard.metrics().value("result_cache_hits_total", labels), 0);
+
+    END_TEST();
+}
@@ -0,0 +1,292 @@
+/**
+ * @file TestShmChannel.cpp
+ * @brief Test suite for the shared-memory channel and arena
+ *
+ * Tests shm_arena_allocator and shm_channel including:
+ * - Arena regions shared, freed and reused across two mappings
+ * - In-order delivery through a second mapping of the ring
+ * - Several sending threads, and a forked sending process
+ * - Large messages through the arena, copied or allocated in place
+ * - Timeouts on an empty and on a full ring
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "io/shm_channel.h"
+#include "memory/backend/allocator_shm.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace quarisma;
+using namespace quarisma::io;
+
+namespace
+{
+
+std::string unique_name(const char* tag)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return std::string("/quarisma_test_") + tag + "_" + std::to_string(::getpid());
+#else
+    return std::string("quarisma_test_") + tag;
+#endif
+}
+
+// Receives one uint64_t message, or returns ~0 on timeout
+uint64_t receive_value(shm_channel& channel)
+{
+    uint64_t value = ~uint64_t{0};
+    channel.receive(
+        [&](const void* data, size_t size)
+        {
+            EXPECT_EQ(size, sizeof(value));
+            std::memcpy(&value, data, sizeof(value));
+        },
+        std::chrono::seconds(10));
+    return value;
+}
+
+}  // namespace
+
+#if defined(__unix__) || defined(__APPLE__)
+
+QUARISMATEST(ShmChannel, arena_shared_between_mappings)
+{
+    std::string const name = unique_name("arena");
+    shm_arena_allocator owner({}, {}, shm_arena_allocator::Options{name, 1 << 20});
+    shm_arena_allocator guest({}, {}, shm_arena_allocator::Options{name, 0});
+    EXPECT_EQ(owner.bytes_in_use(), 0u);
+
+    size_t received = 0;
+    void*  block    = owner.Alloc(64, 1000, &received);
+    ASSERT_NE(block, nullptr);
+    EXPECT_GE(received, 1000u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 64, 0u);
+    std::memset(block, 0x5a, 1000);
+
+    // The other mapping sees the same bytes at the same offset
+    auto const* seen = static_cast<const uint8_t*>(guest.pointer_at(owner.offset_of(block)));
+    EXPECT_EQ(seen[0], 0x5a);
+    EXPECT_EQ(seen[999], 0x5a);
+    EXPECT_EQ(guest.bytes_in_use(), owner.bytes_in_use());
+
+    // Freed through one mapping, reused through the other
+    guest.Free(const_cast<uint8_t*>(seen), 1000);
+    EXPECT_EQ(owner.bytes_in_use(), 0u);
+    size_t const untouched = owner.bytes_untouched();
+    void*        again     = guest.Alloc(64, 1000, &received);
+    EXPECT_EQ(guest.offset_of(again), owner.offset_of(block));
+    EXPECT_EQ(owner.bytes_untouched(), untouched);
+    guest.Free(again, 1000);
+
+    // Exhaustion is reported, not thrown
+    EXPECT_EQ(owner.Alloc(64, 2 << 20, &received), nullptr);
+}
+
+QUARISMATEST(ShmChannel, delivers_in_order)
+{
+    std::string const    name = unique_name("order");
+    shm_channel::Options opts;
+    opts.capacity = 6;
+    auto receiver = shm_channel::create(name, opts);
+    auto sender   = shm_channel::open(name);
+    EXPECT_EQ(receiver.capacity(), 8u);
+    EXPECT_EQ(sender.capacity(), 8u);
+    EXPECT_EQ(sender.slot_size(), 240u);
+    EXPECT_EQ(sender.arena(), nullptr);
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (uint64_t i = 0; i < 8; ++i)
+        {
+            uint64_t const value = round * 100 + i;
+            EXPECT_TRUE(sender.try_send(&value, sizeof(value)));
+        }
+        uint64_t const extra = 0;
+        EXPECT_FALSE(sender.try_send(&extra, sizeof(extra)));
+        EXPECT_FALSE(sender.send(&extra, sizeof(extra), std::chrono::milliseconds(5)));
+        EXPECT_EQ(receiver.size(), 8u);
+
+        for (uint64_t i = 0; i < 8; ++i)
+        {
+            EXPECT_EQ(receive_value(receiver), round * 100 + i);
+        }
+        EXPECT_EQ(receiver.size(), 0u);
+    }
+
+    auto const started = std::chrono::steady_clock::now();
+    EXPECT_FALSE(receiver.receive(
+        [](const void*, size_t) { FAIL() << "nothing was sent"; }, std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(20));
+
+    // The slot is released even when the callback throws
+    uint64_t const value = 7;
+    EXPECT_TRUE(sender.try_send(&value, sizeof(value)));
+    EXPECT_ANY_THROW(
+        receiver.try_receive([](const void*, size_t) { throw std::runtime_error("consumer"); }));
+    EXPECT_EQ(receiver.size(), 0u);
+
+    // Without an arena, a message has to fit its slot
+    std::vector<uint8_t> const large(1000);
+    EXPECT_ANY_THROW(sender.try_send(large.data(), large.size()));
+    EXPECT_ANY_THROW(shm_channel::open(unique_name("missing")));
+}
+
+QUARISMATEST(ShmChannel, multiple_senders)
+{
+    std::string const    name = unique_name("mp");
+    shm_channel::Options opts;
+    opts.capacity       = 64;
+    opts.multi_producer = true;
+    auto receiver       = shm_channel::create(name, opts);
+
+    constexpr uint64_t       threads = 4;
+    constexpr uint64_t       count   = 20000;
+    std::vector<std::thread> senders;
+    for (uint64_t t = 0; t < threads; ++t)
+    {
+        senders.emplace_back(
+            [&name, t]
+            {
+                auto sender = shm_channel::open(name);
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    uint64_t const value = (t << 32) | i;
+                    sender.send(&value, sizeof(value));
+                }
+            });
+    }
+
+    // Each sender's messages arrive in its own order
+    std::vector<uint64_t> next(threads, 0);
+    for (uint64_t n = 0; n < threads * count; ++n)
+    {
+        uint64_t const value  = receive_value(receiver);
+        uint64_t const sender = value >> 32;
+        ASSERT_LT(sender, threads);
+        ASSERT_EQ(value & 0xffffffff, next[sender]);
+        ++next[sender];
+    }
+    for (auto& sender : senders)
+    {
+        sender.join();
+    }
+    EXPECT_EQ(receiver.size(), 0u);
+}
+
+QUARISMATEST(ShmChannel, forked_sender)
+{
+    std::string const    name = unique_name("fork");
+    shm_channel::Options opts;
+    opts.capacity   = 16;
+    opts.arena_size = 1 << 20;
+    auto receiver   = shm_channel::create(name, opts);
+
+    constexpr uint64_t count = 5000;
+    pid_t const        child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        int status = 0;
+        try
+        {
+            auto                  sender = shm_channel::open(name);
+            std::vector<uint64_t> large(100);
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                if (i % 10 == 0)
+                {
+                    large.assign(large.size(), i);
+                    status |= sender.send(large.data(), large.size() * sizeof(uint64_t)) ? 0 : 1;
+                }
+                else
+                {
+                    status |= sender.send(&i, sizeof(i)) ? 0 : 1;
+                }
+            }
+        }
+        catch (...)
+        {
+            status = 2;
+        }
+        ::_exit(status);
+    }
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        bool const ok = receiver.receive(
+            [&](const void* data, size_t size)
+            {
+                auto const* values = static_cast<const uint64_t*>(data);
+                if (i % 10 == 0)
+                {
+                    ASSERT_EQ(size, 100 * sizeof(uint64_t));
+                    EXPECT_EQ(values[0], i);
+                    EXPECT_EQ(values[99], i);
+                }
+                else
+                {
+                    ASSERT_EQ(size, sizeof(uint64_t));
+                    EXPECT_EQ(values[0], i);
+                }
+            },
+            std::chrono::seconds(10));
+        ASSERT_TRUE(ok);
+    }
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(receiver.arena()->bytes_in_use(), 0u);
+}
+
+QUARISMATEST(ShmChannel, send_allocated)
+{
+    std::string const    name = unique_name("zero_copy");
+    shm_channel::Options opts;
+    opts.capacity   = 4;
+    opts.slot_size  = 16;
+    opts.arena_size = 1 << 16;
+    auto receiver   = shm_channel::create(name, opts);
+    auto sender     = shm_channel::open(name);
+    ASSERT_NE(sender.arena(), nullptr);
+
+    auto* payload = static_cast<double*>(sender.allocate(512 * sizeof(double)));
+    ASSERT_NE(payload, nullptr);
+    for (int i = 0; i < 512; ++i)
+    {
+        payload[i] = i * 0.5;
+    }
+    EXPECT_TRUE(sender.send_allocated(payload, 512 * sizeof(double)));
+    EXPECT_GT(receiver.arena()->bytes_in_use(), 0u);
+
+    EXPECT_TRUE(receiver.try_receive(
+        [&](const void* data, size_t size)
+        {
+            ASSERT_EQ(size, 512 * sizeof(double));
+            EXPECT_EQ(static_cast<const double*>(data)[511], 255.5);
+        }));
+    EXPECT_EQ(receiver.arena()->bytes_in_use(), 0u);
+
+    // A full arena fails the send instead of blocking the ring
+    std::vector<uint8_t> const huge(1 << 17);
+    EXPECT_FALSE(sender.try_send(huge.data(), huge.size()));
+    EXPECT_EQ(receiver.size(), 0u);
+
+    // Memory from elsewhere cannot be sent without a copy
+    EXPECT_ANY_THROW(sender.try_send_allocated(const_cast<uint8_t*>(huge.data()), 16));
+}
+
+#endif
@@ -0,0 +1,383 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "util/simd/vec.h"
+
+using namespace quarisma::simd;
+
+namespace
+{
+template <typename V>
+std::vector<typename V::value_type> lanes(const V& v)
+{
+    std::vector<typename V::value_type> result(V::size);
+    v.storeu(result.data());
+    return result;
+}
+
+template <typename V>
+V iota(typename V::value_type start)
+{
+    alignas(V::alignment) typename V::value_type values[V::size];
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        values[i] = static_cast<typename V::value_type>(start + static_cast<int>(i));
+    }
+    return V::load(values);
+}
+
+template <typename T>
+bool is_set(T lane)
+{
+    using bits = typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type;
+    bits value;
+    std::memcpy(&value, &lane, sizeof(T));
+    return value == static_cast<bits>(~bits{0});
+}
+
+template <typename V>
+void check_arithmetic()
+{
+    using T = typename V::value_type;
+
+    V const a = iota<V>(1);
+    V const b(T{2});
+
+    auto const sum        = lanes(a + b);
+    auto const difference = lanes(a - b);
+    auto const product    = lanes(a * b);
+    auto const fused      = lanes(fma(a, b, V(T{1})));
+    auto const negated    = lanes(-a);
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        T const x = static_cast<T>(i + 1);
+        EXPECT_EQ(sum[i], x + 2);
+        EXPECT_EQ(difference[i], x - 2);
+        EXPECT_EQ(product[i], x * 2);
+        EXPECT_EQ(fused[i], x * 2 + 1);
+        EXPECT_EQ(negated[i], -x);
+    }
+
+    V c = a;
+    c += b;
+    c *= T{3};
+    c -= a;
+    EXPECT_EQ(c[0], (T{1} + 2) * 3 - 1);
+
+    EXPECT_EQ(reduce_add(a), static_cast<T>(V::size * (V::size + 1) / 2));
+    EXPECT_EQ(reduce_min(a), T{1});
+    EXPECT_EQ(reduce_max(a), static_cast<T>(V::size));
+    EXPECT_EQ(reduce_min(-a), -static_cast<T>(V::size));
+    EXPECT_EQ(reduce_max(abs(-a)), static_cast<T>(V::size));
+}
+
+template <typename V>
+void check_floating()
+{
+    using T = typename V::value_type;
+
+    V const a = iota<V>(1);
+
+    auto const quotient = lanes(a / V(T{4}));
+    auto const root     = lanes(sqrt(a * a));
+    auto const rounded  = lanes(round(a + V(T{0.5})));
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        T const x = static_cast<T>(i + 1);
+        EXPECT_EQ(quotient[i], x / 4);
+        EXPECT_EQ(root[i], x);
+        EXPECT_EQ(rounded[i], std::nearbyint(x + T{0.5}));  // Ties to even
+    }
+
+    auto const powers    = lanes(pow2(iota<V>(-3)));
+    auto const exponents = lanes(exponent(a * V(T{3})));
+    auto const mantissas = lanes(mantissa(a * V(T{3})));
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        int const x = static_cast<int>(i) + 1;
+        EXPECT_EQ(powers[i], std::ldexp(T{1}, x - 4));
+        EXPECT_EQ(exponents[i], static_cast<T>(std::ilogb(T(3 * x))));
+        EXPECT_EQ(mantissas[i], std::scalbn(T(3 * x), -std::ilogb(T(3 * x))));
+    }
+}
+
+template <typename V>
+void check_compare_select()
+{
+    using T = typename V::value_type;
+
+    V const a = iota<V>(0);
+    V const b(static_cast<T>(V::size / 2));
+
+    auto const less    = lanes(a < b);
+    auto const equal   = lanes(a == b);
+    auto const greater = lanes(a >= b);
+    auto const picked  = lanes(select(a < b, a, b));
+    auto const low     = lanes(min(a, b));
+    auto const high    = lanes(max(a, b));
+    auto const odd     = lanes(blend<0xAAAAAAAAAAAAAAAAULL>(a, b));
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        bool const is_less = i < V::size / 2;
+        EXPECT_EQ(is_set(less[i]), is_less);
+        if (!is_less)
+        {
+            EXPECT_EQ(less[i], T{0});
+        }
+        EXPECT_EQ(is_set(equal[i]), i == V::size / 2);
+        EXPECT_EQ(is_set(greater[i]), !is_less);
+        EXPECT_EQ(picked[i], is_less ? a[i] : b[i]);
+        EXPECT_EQ(low[i], is_less ? a[i] : b[i]);
+        EXPECT_EQ(high[i], is_less ? b[i] : a[i]);
+        EXPECT_EQ(odd[i], i % 2 == 1 ? b[i] : a[i]);
+    }
+
+    auto const masked = lanes(and_not(a, a < b) | ((a < b) & V(T{7})));
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        EXPECT_EQ(masked[i], i < V::size / 2 ? T{7} : a[i]);
+    }
+}
+
+template <typename V>
+void check_load_store()
+{
+    using T = typename V::value_type;
+
+    alignas(V::alignment) T aligned[V::size];
+    std::vector<T>          buffer(V::size + 1);
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        aligned[i]    = static_cast<T>(i + 10);
+        buffer[i + 1] = static_cast<T>(i + 20);
+    }
+
+    V const a = V::load(aligned);
+    V const u = V::loadu(buffer.data() + 1);
+    for (size_t i = 0; i < V::size; ++i)
+    {
+        EXPECT_EQ(a[i], aligned[i]);
+        EXPECT_EQ(u[i], buffer[i + 1]);
+    }
+
+    alignas(V::alignment) T out[V::size];
+    (u + V(T{1})).store(out);
+    EXPECT_EQ(out[V::size - 1], buffer[V::size] + 1);
+    a.storeu(buffer.data() + 1);
+    EXPECT_EQ(buffer[1], aligned[0]);
+
+    // Partial loads and stores touch exactly count lanes
+    for (size_t count = 0; count <= V::size; ++count)
+    {
+        std::vector<T> source(count, T{5});
+        V const        partial = V::load_partial(source.data(), count);
+        for (size_t i = 0; i < V::size; ++i)
+        {
+            EXPECT_EQ(partial[i], i < count ? T{5} : T{0});
+        }
+
+        std::vector<T> target(V::size + 1, T{-1});
+        a.store_partial(target.data(), count);
+        for (size_t i = 0; i <= V::size; ++i)
+        {
+            EXPECT_EQ(target[i], i < count ? aligned[i] : T{-1});
+        }
+    }
+}
+
+template <typename V, typename F, typename G>
+double max_error(F vector_fn, G scalar_fn, double lo, double hi, bool relative)
+{
+    using T = typename V::value_type;
+
+    constexpr size_t samples = 4096;
+    double           worst   = 0;
+    for (size_t i = 0; i < samples; i += V::size)
+    {
+        alignas(V::alignment) T x[V::size];
+        for (size_t j = 0; j < V::size; ++j)
+        {
+            x[j] = static_cast<T>(lo + (hi - lo) * static_cast<double>(i + j) / samples);
+        }
+        auto const y = lanes(vector_fn(V::load(x)));
+        for (size_t j = 0; j < V::size; ++j)
+        {
+            double const expected = scalar_fn(x[j]);
+            double       error    = std::fabs(static_cast<double>(y[j]) - expected);
+            if (relative)
+            {
+                error /= std::fabs(expected);
+            }
+            worst = std::max(worst, error);
+        }
+    }
+    return worst;
+}
+
+template <typename V>
+void check_math()
+{
+    using T = typename V::value_type;
+
+    constexpr double eps = std::numeric_limits<T>::epsilon();
+    auto             exp = [](const V& x) { return quarisma::simd::exp(x); };
+    auto             log = [](const V& x) { return quarisma::simd::log(x); };
+    auto             erf = [](const V& x) { return quarisma::simd::erf(x); };
+
+    double const max_exp = sizeof(T) == 8 ? 700.0 : 87.0;
+    EXPECT_LE(max_error<V>(exp, [](T x) { return std::exp(x); }, -max_exp, max_exp, true), 4 * eps);
+    EXPECT_LE(max_error<V>(log, [](T x) { return std::log(x); }, 1e-3, 1e3, true), 4 * eps);
+    EXPECT_LE(max_error<V>(log, [](T x) { return std::log(x); }, 0.5, 2.0, false), 4 * eps);
+    EXPECT_LE(max_error<V>(erf, [](T x) { return std::erf(x); }, -6.0, 6.0, false), 2e-7);
+
+    T const inf = std::numeric_limits<T>::infinity();
+    T const nan = std::numeric_limits<T>::quiet_NaN();
+    T const tiny = std::numeric_limits<T>::denorm_min() * 8;
+
+    EXPECT_EQ(exp(V(inf))[0], inf);
+    EXPECT_EQ(exp(V(-inf))[0], T{0});
+    EXPECT_EQ(exp(V(T{0}))[0], T{1});
+    EXPECT_TRUE(std::isnan(exp(V(nan))[0]));
+
+    EXPECT_EQ(log(V(T{1}))[0], T{0});
+    EXPECT_EQ(log(V(T{0}))[0], -inf);
+    EXPECT_EQ(log(V(inf))[0], inf);
+    EXPECT_TRUE(std::isnan(log(V(T{-1}))[0]));
+    EXPECT_TRUE(std::isnan(log(V(nan))[0]));
+    EXPECT_NEAR(log(V(tiny))[0], std::log(tiny), 4 * eps * std::fabs(std::log(tiny)));
+
+    EXPECT_EQ(erf(V(T{0}))[0], T{0});
+    EXPECT_EQ(erf(V(inf))[0], T{1});
+    EXPECT_EQ(erf(V(-inf))[0], T{-1});
+    EXPECT_TRUE(std::isnan(erf(V(nan))[0]));
+}
+}  // namespace
+
+QUARISMATEST(Simd, native_width)
+{
+    EXPECT_EQ(vec<double>::size * sizeof(double), native_bytes);
+    EXPECT_EQ(vec<float>::size * sizeof(float), native_bytes);
+    EXPECT_LE(vec<double>::alignment, static_cast<size_t>(QUARISMA_ALIGNMENT));
+    EXPECT_EQ(vec<double>::alignment, native_bytes);
+    EXPECT_EQ(alignof(vec<float>), native_bytes);
+    END_TEST();
+}
+
+QUARISMATEST(Simd, arithmetic)
+{
+    check_arithmetic<vec<double>>();
+    check_arithmetic<vec<float>>();
+    check_arithmetic<vec<double, 2>>();
+    check_arithmetic<vec<float, 4>>();
+    check_arithmetic<vec<double, 4>>();
+    check_arithmetic<vec<float, 8>>();
+    check_arithmetic<vec<double, 8>>();
+    check_arithmetic<vec<float, 16>>();
+    check_arithmetic<vec<float, 3>>();
+    check_arithmetic<vec<int32_t, 4>>();
+    check_arithmetic<vec<int64_t, 5>>();
+    END_TEST();
+}
+
+QUARISMATEST(Simd, floating_point)
+{
+    check_floating<vec<double>>();
+    check_floating<vec<float>>();
+    check_floating<vec<double, 2>>();
+    check_floating<vec<float, 4>>();
+    check_floating<vec<double, 4>>();
+    check_floating<vec<float, 8>>();
+    check_floating<vec<double, 8>>();
+    check_floating<vec<float, 16>>();
+    check_floating<vec<double, 3>>();
+    END_TEST();
+}
+
+QUARISMATEST(Simd, compare_select)
+{
+    check_compare_select<vec<double>>();
+    check_compare_select<vec<float>>();
+    check_compare_select<vec<double, 2>>();
+    check_compare_select<vec<float, 4>>();
+    check_compare_select<vec<double, 4>>();
+    check_compare_select<vec<float, 8>>();
+    check_compare_select<vec<double, 8>>();
+    check_compare_select<vec<float, 16>>();
+    check_compare_select<vec<float, 5>>();
+    END_TEST();
+}
+
+QUARISMATEST(Simd, load_store)
+{
+    check_load_store<vec<double>>();
+    check_load_store<vec<float>>();
+    check_load_store<vec<double, 2>>();
+    check_load_store<vec<float, 4>>();
+    check_load_store<vec<double, 4>>();
+    check_load_store<vec<float, 8>>();
+    check_load_store<vec<double, 8>>();
+    check_load_store<vec<float, 16>>();
+    check_load_store<vec<int32_t, 7>>();
+    END_TEST();
+}
+
+QUARISMATEST(Simd, math)
+{
+    check_math<vec<double>>();
+    check_math<vec<float>>();
+    check_math<vec<double, 2>>();
+    check_math<vec<float, 4>>();
+    check_math<vec<double, 3>>();
+    END_TEST();
+}
+
+QUARISMATEST(Simd, axpy_tail)
+{
+    using V = vec<double>;
+
+    size_t const        n = 3 * V::size + 3;
+    std::vector<double> x(n);
+    std::vector<double> y(n, 1.0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        x[i] = static_cast<double>(i);
+    }
+
+    size_t i = 0;
+    for (; i + V::size <= n; i += V::size)
+    {
+        fma(V::loadu(x.data() + i), V(2.0), V::loadu(y.data() + i)).storeu(y.data() + i);
+    }
+    fma(V::load_partial(x.data() + i, n - i), V(2.0), V::load_partial(y.data() + i, n - i))
+        .store_partial(y.data() + i, n - i);
+
+    for (size_t j = 0; j < n; ++j)
+    {
+        EXPECT_EQ(y[j], 2.0 * static_cast<double>(j) + 1.0);
+    }
+    END_TEST();
+}
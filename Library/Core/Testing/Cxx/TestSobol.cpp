@@ -0,0 +1,261 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "common/macros.h"
+#include "math/sobol.h"
+
+using namespace quarisma;
+
+namespace
+{
+// Points [first, first + count) by next(), in the layout of generate()
+std::vector<double> sequential(size_t dimensions, uint64_t first, size_t count, size_t stride)
+{
+    sobol_generator     sobol(dimensions);
+    std::vector<double> point(dimensions);
+    std::vector<double> out(dimensions * stride, -1.0);
+    sobol.skip_to(first);
+    for (size_t i = 0; i < count; ++i)
+    {
+        sobol.next(point.data());
+        for (size_t d = 0; d < dimensions; ++d)
+        {
+            out[d * stride + i] = point[d];
+        }
+    }
+    return out;
+}
+}  // namespace
+
+QUARISMATEST(Sobol, first_points)
+{
+    // Joe and Kuo's published sequence, point 0 being the origin
+    const double expected[][3] = {
+        {0.0, 0.0, 0.0},
+        {0.5, 0.5, 0.5},
+        {0.75, 0.25, 0.25},
+        {0.25, 0.75, 0.75},
+        {0.375, 0.375, 0.625},
+        {0.875, 0.875, 0.125},
+    };
+
+    sobol_generator sobol(3);
+    double          point[3];
+    for (const auto& row : expected)
+    {
+        sobol.next(point);
+        for (size_t d = 0; d < 3; ++d)
+        {
+            EXPECT_EQ(point[d], row[d]);
+        }
+    }
+    EXPECT_EQ(sobol.index(), 6U);
+
+    END_TEST();
+}
+
+QUARISMATEST(Sobol, dimensions)
+{
+#if defined(QUARISMA_SOBOL_1111)
+    EXPECT_EQ(sobol_generator::max_dimensions(), 1111U);
+#else
+    EXPECT_EQ(sobol_generator::max_dimensions(), 32U);
+#endif
+
+    // Every dimension puts one of the first 2^10 points in each interval of width 2^-10
+    size_t const          dimensions = sobol_generator::max_dimensions();
+    sobol_generator       sobol(dimensions);
+    std::vector<uint32_t> point(dimensions);
+    std::vector<int>      hits(dimensions << 10);
+    for (size_t i = 0; i < 1024; ++i)
+    {
+        sobol.next(point.data());
+        for (size_t d = 0; d < dimensions; ++d)
+        {
+            ++hits[(d << 10) + (point[d] >> 22)];
+        }
+    }
+    for (size_t d = 0; d < dimensions; ++d)
+    {
+        for (size_t j = 0; j < 1024; ++j)
+        {
+            ASSERT_EQ(hits[(d << 10) + j], 1) << "dimension " << d + 1 << ", interval " << j;
+        }
+    }
+
+    ASSERT_ANY_THROW(sobol_generator(0));
+    ASSERT_ANY_THROW(sobol_generator(dimensions + 1));
+
+    END_TEST();
+}
+
+QUARISMATEST(Sobol, skip_to)
+{
+    size_t const dimensions = 16;
+    auto const   expected   = sequential(dimensions, 0, 5000, 5000);
+
+    sobol_generator     sobol(dimensions);
+    std::vector<double> point(dimensions);
+    for (uint64_t index : {4999U, 1U, 4096U, 1023U, 0U, 2047U})
+    {
+        sobol.skip_to(index);
+        EXPECT_EQ(sobol.index(), index);
+        sobol.next(point.data());
+        for (size_t d = 0; d < dimensions; ++d)
+        {
+            ASSERT_EQ(point[d], expected[d * 5000 + index]);
+        }
+    }
+
+    // The last point, then the end of the sequence
+    sobol.skip_to(sobol_generator::max_points - 1);
+    sobol.next(point.data());
+    EXPECT_EQ(sobol.index(), sobol_generator::max_points);
+    ASSERT_ANY_THROW(sobol.next(point.data()));
+    ASSERT_ANY_THROW(sobol.skip_to(sobol_generator::max_points));
+
+    END_TEST();
+}
+
+QUARISMATEST(Sobol, generate)
+{
+    // Several parallel tasks and a partial block, from an odd first point
+    size_t const   dimensions = 24;
+    uint64_t const first      = 12345;
+    size_t const   count      = 20000 + 77;
+    size_t const   stride     = sobol_generator::aligned_stride(count);
+    EXPECT_GE(stride, count);
+    EXPECT_EQ(stride * sizeof(double) % QUARISMA_ALIGNMENT, 0U);
+
+    auto const          expected = sequential(dimensions, first, count, stride);
+    std::vector<double> out(dimensions * stride, -1.0);
+
+    sobol_generator sobol(dimensions);
+    sobol.generate(first, count, out.data(), stride);
+    EXPECT_EQ(sobol.index(), 0U);
+    EXPECT_EQ(out, expected);
+
+    // Up to the last point, whose successor has no direction
+    uint64_t const tail = sobol_generator::max_points - 300;
+    std::vector<double> last(dimensions * 300);
+    sobol.generate(tail, 300, last.data(), 300);
+    EXPECT_EQ(last, sequential(dimensions, tail, 300, 300));
+
+    ASSERT_ANY_THROW(sobol.generate(tail, 301, last.data(), 301));
+    ASSERT_ANY_THROW(sobol.generate(0, 300, last.data(), 299));
+
+    END_TEST();
+}
+
+QUARISMATEST(Sobol, brownian_bridge)
+{
+    // The increments are A z for a matrix A with A A^T = diag(t_i - t_(i-1))
+    std::vector<double> const times = {0.1, 0.25, 0.3, 0.7, 1.0, 1.05, 1.5, 2.0, 3.0, 3.5, 4.25};
+    brownian_bridge const     bridge(times);
+    size_t const              n = times.size();
+    EXPECT_EQ(bridge.steps(), n);
+
+    std::vector<double> a(n * n);
+    std::vector<double> unit(n);
+    std::vector<double> column(n);
+    for (size_t k = 0; k < n; ++k)
+    {
+        std::fill(unit.begin(), unit.end(), 0.0);
+        unit[k] = 1.0;
+        bridge.transform(unit.data(), column.data());
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i * n + k] = column[i];
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            double covariance = 0.0;
+            for (size_t k = 0; k < n; ++k)
+            {
+                covariance += a[i * n + k] * a[j * n + k];
+            }
+            double const expected = i != j ? 0.0 : times[i] - (i == 0 ? 0.0 : times[i - 1]);
+            EXPECT_NEAR(covariance, expected, 1e-14) << "row " << i << ", column " << j;
+        }
+    }
+
+    // The first normal alone sets the terminal value, on a straight line
+    std::fill(unit.begin(), unit.end(), 0.0);
+    unit[0] = 2.0;
+    bridge.transform(unit.data(), column.data());
+    for (size_t i = 0; i < n; ++i)
+    {
+        double const dt = times[i] - (i == 0 ? 0.0 : times[i - 1]);
+        EXPECT_NEAR(column[i], 2.0 * dt / std::sqrt(times[n - 1]), 1e-14);
+    }
+
+    ASSERT_ANY_THROW(brownian_bridge(0));
+    ASSERT_ANY_THROW(brownian_bridge(std::vector<double>{1.0, 1.0}));
+    ASSERT_ANY_THROW(brownian_bridge(std::vector<double>{0.0, 1.0}));
+
+    END_TEST();
+}
+
+QUARISMATEST(Sobol, brownian_bridge_paths)
+{
+    // Many paths give the increments of each path on its own
+    size_t const    steps  = 37;
+    size_t const    paths  = 3001;
+    size_t const    stride = sobol_generator::aligned_stride(paths);
+    brownian_bridge bridge(steps);
+
+    std::mt19937                     engine(11);
+    std::normal_distribution<double> normal;
+    std::vector<double>              z(steps * stride);
+    for (double& x : z)
+    {
+        x = normal(engine);
+    }
+
+    std::vector<double> dw(steps * stride);
+    bridge.transform(z.data(), dw.data(), paths, stride);
+
+    std::vector<double> path(steps);
+    std::vector<double> expected(steps);
+    for (size_t p = 0; p < paths; ++p)
+    {
+        for (size_t i = 0; i < steps; ++i)
+        {
+            path[i] = z[i * stride + p];
+        }
+        bridge.transform(path.data(), expected.data());
+        for (size_t i = 0; i < steps; ++i)
+        {
+            ASSERT_NEAR(dw[i * stride + p], expected[i], 1e-12) << "path " << p << ", step " << i;
+        }
+    }
+
+    END_TEST();
+}
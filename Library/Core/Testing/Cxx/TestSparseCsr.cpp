@@ -0,0 +1,205 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "Testing/cpuCapabilityTest.h"
+#include "math/sparse_csr.h"
+#include "math/sparse_csr_dispatch.h"
+#include "util/cpu_info.h"
+
+using namespace quarisma;
+
+namespace
+{
+// A random rows x cols CSR matrix with a few dense rows among short ones
+struct random_csr
+{
+    std::vector<int64_t> row_offsets{0};
+    std::vector<int64_t> columns;
+    std::vector<double>  values;
+    linalg::csr_view     view;
+
+    random_csr(size_t rows, size_t cols, std::mt19937& engine)
+    {
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        std::uniform_int_distribution<size_t>  column(0, cols - 1);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            size_t const nnz = i % 97 == 0 ? cols : i % 5;
+            for (size_t k = 0; k < nnz; ++k)
+            {
+                columns.push_back(static_cast<int64_t>(column(engine)));
+                values.push_back(uniform(engine));
+            }
+            row_offsets.push_back(static_cast<int64_t>(columns.size()));
+        }
+        view = {rows, cols, row_offsets.data(), columns.data(), values.data()};
+    }
+
+    double dot(size_t i, const double* x, size_t stride) const
+    {
+        double sum = 0.0;
+        for (auto k = row_offsets[i]; k < row_offsets[i + 1]; ++k)
+        {
+            sum += values[k] * x[columns[k] * stride];
+        }
+        return sum;
+    }
+};
+
+std::vector<double> random_vector(size_t n, std::mt19937& engine)
+{
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<double>                    v(n);
+    for (auto& x : v)
+    {
+        x = uniform(engine);
+    }
+    return v;
+}
+}  // namespace
+
+QUARISMATEST(SparseCsr, partition)
+{
+    std::mt19937     engine(7);
+    random_csr const a(1000, 500, engine);
+
+    for (size_t parts : {1, 3, 16, 5000})
+    {
+        auto const bounds = linalg::csr_partition(a.view, parts);
+        ASSERT_GE(bounds.size(), 2U);
+        EXPECT_LE(bounds.size(), parts + 1);
+        EXPECT_EQ(bounds.front(), 0U);
+        EXPECT_EQ(bounds.back(), 1000U);
+        for (size_t r = 1; r < bounds.size(); ++r)
+        {
+            EXPECT_LT(bounds[r - 1], bounds[r]);
+        }
+    }
+
+    // No range takes much more than its share of the work, at most one dense
+    // row over it, whatever the rows it spans
+    auto const   bounds = linalg::csr_partition(a.view, 16);
+    size_t const work   = a.view.nnz() + a.view.rows;
+    for (size_t r = 1; r < bounds.size(); ++r)
+    {
+        size_t const range_work = static_cast<size_t>(
+                                      a.row_offsets[bounds[r]] - a.row_offsets[bounds[r - 1]]) +
+                                  bounds[r] - bounds[r - 1];
+        EXPECT_LE(range_work, 2 * work / 16 + 500);
+    }
+
+    EXPECT_EQ(linalg::csr_partition(linalg::csr_view{}, 4), std::vector<size_t>{0});
+}
+
+QUARISMATEST(SparseCsr, spmv)
+{
+    std::mt19937 engine(11);
+    for (size_t rows : {1, 17, 3000})
+    {
+        random_csr const a(rows, 257, engine);
+        auto const       x  = random_vector(257, engine);
+        auto const       y0 = random_vector(rows, engine);
+
+        auto y = y0;
+        linalg::csr_spmv(a.view, x.data(), y.data(), 2.0, -0.5);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            ASSERT_NEAR(y[i], 2.0 * a.dot(i, x.data(), 1) - 0.5 * y0[i], 1e-12) << "row " << i;
+        }
+
+        // beta = 0 does not read y
+        std::vector<double> z(rows, std::nan(""));
+        linalg::csr_spmv(a.view, x.data(), z.data());
+        for (size_t i = 0; i < rows; ++i)
+        {
+            ASSERT_NEAR(z[i], a.dot(i, x.data(), 1), 1e-12) << "row " << i;
+        }
+
+        for (cpu_capability c : capabilities())
+        {
+            auto const kernel = linalg::detail::spmv_rows_stub_type::kernel(c);
+            if (kernel == nullptr)
+            {
+                continue;
+            }
+            std::vector<double> w(rows);
+            kernel(a.view, 0, rows, x.data(), w.data(), 1.0, 0.0);
+            for (size_t i = 0; i < rows; ++i)
+            {
+                ASSERT_NEAR(w[i], z[i], 1e-12) << "capability " << static_cast<int>(c);
+            }
+        }
+    }
+}
+
+QUARISMATEST(SparseCsr, spmm)
+{
+    std::mt19937 engine(13);
+    for (size_t p : {1, 5, 16, 37})
+    {
+        size_t const     rows = 600;
+        size_t const     cols = 129;
+        size_t const     ldb  = p + 3;
+        size_t const     ldc  = p + 1;
+        random_csr const a(rows, cols, engine);
+        auto const       b  = random_vector(cols * ldb, engine);
+        auto const       c0 = random_vector(rows * ldc, engine);
+
+        auto c = c0;
+        linalg::csr_spmm(a.view, b.data(), p, ldb, c.data(), ldc, 0.5, 2.0);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            for (size_t j = 0; j < p; ++j)
+            {
+                ASSERT_NEAR(
+                    c[i * ldc + j], 0.5 * a.dot(i, b.data() + j, ldb) + 2.0 * c0[i * ldc + j],
+                    1e-12)
+                    << "p " << p << ", row " << i << ", column " << j;
+            }
+            // Padding past p columns is left alone
+            ASSERT_EQ(c[i * ldc + p], c0[i * ldc + p]);
+        }
+
+        for (cpu_capability cap : capabilities())
+        {
+            auto const kernel = linalg::detail::spmm_rows_stub_type::kernel(cap);
+            if (kernel == nullptr)
+            {
+                continue;
+            }
+            std::vector<double> d(rows * ldc, std::nan(""));
+            kernel(a.view, 0, rows, b.data(), p, ldb, d.data(), ldc, 1.0, 0.0);
+            for (size_t i = 0; i < rows; ++i)
+            {
+                for (size_t j = 0; j < p; ++j)
+                {
+                    ASSERT_NEAR(d[i * ldc + j], a.dot(i, b.data() + j, ldb), 1e-12)
+                        << "capability " << static_cast<int>(cap);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Tests for startup_tracer: scoped phases, the report, capacity and
+ * concurrent recording.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "util/startup_tracer.h"
+
+using quarisma::startup_tracer;
+
+QUARISMATEST(StartupTracer, records_scopes)
+{
+    startup_tracer::clear_for_test();
+    {
+        const startup_tracer::scope phase("test::sleep");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    startup_tracer::record("test::manual", startup_tracer::now_ns(), 1000);
+    startup_tracer::record("test::manual", startup_tracer::now_ns(), 2000);
+
+    auto const phases = startup_tracer::phases();
+    ASSERT_EQ(phases.size(), 3u);
+    EXPECT_EQ(std::string(phases[0].name), "test::sleep");
+    EXPECT_GE(phases[0].duration_ns, 2'000'000);
+    EXPECT_LE(phases[0].start_ns, phases[1].start_ns);
+    EXPECT_EQ(phases[2].duration_ns, 2000);
+
+    std::string const report = startup_tracer::report();
+    EXPECT_NE(report.find("=== Startup Phases ==="), std::string::npos);
+    EXPECT_NE(report.find("--- Total per phase ---"), std::string::npos);
+    // The sleep dominates, so it comes first among the totals
+    size_t const totals = report.find("--- Total per phase ---");
+    EXPECT_LT(report.find("test::sleep", totals), report.find("test::manual", totals));
+    EXPECT_EQ(startup_tracer::dropped(), 0u);
+
+    startup_tracer::clear_for_test();
+    EXPECT_TRUE(startup_tracer::phases().empty());
+    EXPECT_NE(startup_tracer::report().find("(none recorded)"), std::string::npos);
+
+    END_TEST();
+}
+
+QUARISMATEST(StartupTracer, drops_past_capacity)
+{
+    startup_tracer::clear_for_test();
+    for (size_t i = 0; i < startup_tracer::capacity + 5; ++i)
+    {
+        startup_tracer::record("test::phase", startup_tracer::now_ns(), 1);
+    }
+    EXPECT_EQ(startup_tracer::phases().size(), startup_tracer::capacity);
+    EXPECT_EQ(startup_tracer::dropped(), 5u);
+    EXPECT_NE(startup_tracer::report().find("5 phase(s) dropped"), std::string::npos);
+
+    startup_tracer::clear_for_test();
+    EXPECT_EQ(startup_tracer::dropped(), 0u);
+
+    END_TEST();
+}
+
+QUARISMATEST(StartupTracer, concurrent_records)
+{
+    startup_tracer::clear_for_test();
+    constexpr int            threads = 4;
+    constexpr int            per     = 50;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back(
+            []
+            {
+                for (int i = 0; i < per; ++i)
+                {
+                    const startup_tracer::scope phase("test::concurrent");
+                }
+            });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    EXPECT_EQ(startup_tracer::phases().size(), static_cast<size_t>(threads * per));
+    startup_tracer::clear_for_test();
+
+    END_TEST();
+}
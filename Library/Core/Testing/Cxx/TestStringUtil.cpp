@@ -32,8 +32,12 @@
 #include <gtest/gtest.h>  // for AssertionResult, Message, TestPartResult, EXPECT_EQ, EXPECT_FALSE, EXPECT_TRUE
 
 #include <cstddef>      // for size_t
+#include <cstdint>      // for int64_t, uint64_t
+#include <filesystem>   // for path
 #include <fstream>      // for basic_ostream, filebuf, ostream
+#include <limits>       // for numeric_limits
 #include <memory>       // for _Simple_types
+#include <sstream>      // for ostringstream
 #include <string>       // for string, basic_string, char_traits
 #include <string_view>  // for string_view
 #include <vector>       // for vector, _Vector_const_iterato
@@ -209,6 +213,57 @@ void testStringAppend()
     EXPECT_EQ(s4, "Numbers: 1, 2, 3");
 }
 
+void testStringConversions()
+{
+    // Numbers come out as operator<< would write them
+    auto streamed = [](auto value)
+    {
+        std::ostringstream oss;
+        oss << value;
+        return oss.str();
+    };
+    for (double const value : {0.0, -0.0, 3.14159265, 1e-5, 123456789.0, -2.5e300, 1.0 / 3})
+    {
+        EXPECT_EQ(quarisma::strings::str_cat(value), streamed(value));
+        EXPECT_EQ(
+            quarisma::strings::str_cat(static_cast<float>(value)),
+            streamed(static_cast<float>(value)));
+    }
+    EXPECT_EQ(quarisma::strings::str_cat(std::numeric_limits<double>::infinity()), "inf");
+    EXPECT_EQ(
+        quarisma::strings::str_cat(std::numeric_limits<int64_t>::min()),
+        streamed(std::numeric_limits<int64_t>::min()));
+    EXPECT_EQ(
+        quarisma::strings::str_cat(std::numeric_limits<uint64_t>::max()),
+        "18446744073709551615");
+    EXPECT_EQ(quarisma::strings::str_cat(short{-7}, 7U, 7L, 7ULL), "-7777");
+
+    // Characters stay characters, bools are digits
+    EXPECT_EQ(
+        quarisma::strings::str_cat('a', static_cast<unsigned char>('b'), true, false), "ab10");
+
+    // Strings of every kind, a null C string is empty
+    std::string const owned   = "owned";
+    const char*       null    = nullptr;
+    char              array[] = "array";
+    EXPECT_EQ(
+        quarisma::strings::str_cat(owned, std::string_view("/view"), null, array),
+        "owned/viewarray");
+    EXPECT_EQ(quarisma::strings::str_cat(), "");
+
+    // Other types go through their operator<<
+    std::filesystem::path const path("p");
+    EXPECT_EQ(quarisma::strings::str_cat(path), streamed(path));
+
+    // Appending result to itself, with and without growing it
+    std::string self = "ab";
+    quarisma::strings::str_append(&self, self, 1, self);
+    EXPECT_EQ(self, "abab1ab");
+    self.reserve(64);
+    quarisma::strings::str_append(&self, std::string_view(self).substr(0, 3), '!');
+    EXPECT_EQ(self, "abab1ababa!");
+}
+
 void testStringContains()
 {
     // Test str_contains with character found
@@ -386,6 +441,7 @@ void testAllFunctions()
     testSourceLocation();
     testStringConcatenation();
     testStringAppend();
+    testStringConversions();
     testStringContains();
     testFormatHex();
     testToLower();
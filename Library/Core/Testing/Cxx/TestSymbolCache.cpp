@@ -0,0 +1,132 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @file TestSymbolCache.cpp
+ * @brief Tests of the process-wide symbol cache
+ *
+ * - an address resolves to its function and library, then hits the cache
+ * - back_trace fills source locations through the cache when asked to
+ * - resolved frames are written to the directory of the disk cache
+ */
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#endif
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "common/macros.h"
+#include "logging/back_trace.h"
+#include "logging/symbol_cache.h"
+
+using namespace quarisma;
+
+namespace
+{
+
+QUARISMA_NOINLINE int symbol_cache_probe(int x)
+{
+    return x * 3 + 1;
+}
+
+QUARISMA_NOINLINE int symbol_cache_disk_probe(int x)
+{
+    return x * 5 + 2;
+}
+
+// An address inside f, which resolve() takes as a return address
+void* inside(int (*f)(int))
+{
+    return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(f) + 4);
+}
+
+}  // namespace
+
+#if defined(__linux__)
+
+QUARISMATEST(SymbolCache, resolves_functions_and_caches_them)
+{
+    EXPECT_EQ(symbol_cache_probe(1), 4);
+    auto& cache = symbol_cache::instance();
+
+    std::vector<void*> const addresses{inside(&symbol_cache_probe), nullptr};
+    auto const               first = cache.resolve(addresses);
+    ASSERT_EQ(first.size(), 2U);
+    EXPECT_NE(first[0].function.find("symbol_cache_probe"), std::string::npos);
+    EXPECT_FALSE(first[0].library.empty());
+    EXPECT_EQ(first[1].function, "??");
+
+    auto const hits   = cache.stats().hits;
+    auto const second = cache.resolve(addresses);
+    EXPECT_EQ(cache.stats().hits, hits + 2);
+    EXPECT_EQ(second[0].function, first[0].function);
+    EXPECT_EQ(second[0].offset, first[0].offset);
+}
+
+QUARISMATEST(SymbolCache, back_trace_source_info)
+{
+    backtrace_options options;
+    options.include_source_info = true;
+    auto const frames           = back_trace::capture(options);
+    ASSERT_FALSE(frames.empty());
+    for (const auto& frame : frames)
+    {
+        // Either no line information, or a file with a line
+        EXPECT_EQ(frame.source_file.empty(), frame.source_line < 0);
+    }
+}
+
+QUARISMATEST(SymbolCache, writes_disk_cache)
+{
+    EXPECT_EQ(symbol_cache_disk_probe(1), 7);
+    auto&      cache    = symbol_cache::instance();
+    auto const previous = cache.directory();
+    auto const directory =
+        (std::filesystem::temp_directory_path() / "quarisma_symbol_cache_test").string();
+    std::filesystem::remove_all(directory);
+    cache.set_directory(directory);
+
+    // Only libraries first seen with the directory set are cached on disk, so
+    // also resolve an address in the C library, which no other test resolves
+    void* const libc_function = dlsym(RTLD_DEFAULT, "qsort");
+    ASSERT_NE(libc_function, nullptr);
+    auto const symbols = cache.resolve(
+        {inside(&symbol_cache_disk_probe),
+         reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(libc_function) + 4)});
+    EXPECT_NE(symbols[0].function.find("symbol_cache_disk_probe"), std::string::npos);
+    EXPECT_NE(symbols[1].function.find("qsort"), std::string::npos);
+    cache.set_directory(previous);
+
+    if (std::filesystem::exists(directory))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(directory))
+        {
+            EXPECT_EQ(entry.path().extension(), ".sym");
+            EXPECT_GT(std::filesystem::file_size(entry.path()), 0U);
+        }
+    }
+    std::filesystem::remove_all(directory);
+}
+
+#endif  // __linux__
@@ -0,0 +1,185 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Unit tests for task_graph
+ *
+ * Tests cover:
+ * - Topological levels and cycle detection
+ * - Dependency ordering over repeated runs
+ * - Large layered graphs and restricted thread counts
+ * - Exception propagation
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "parallel/parallel_tools.h"
+#include "parallel/task_graph.h"
+
+namespace quarisma
+{
+// ============================================================================
+// Consolidated Test 1: Construction, Levels and Validation
+// ============================================================================
+
+QUARISMATEST(TaskGraph, levels_and_validation)
+{
+    // Test 1: Empty graph
+    {
+        task_graph graph;
+        graph.run();
+        EXPECT_EQ(graph.size(), 0u);
+        EXPECT_EQ(graph.number_of_levels(), 0u);
+    }
+
+    // Test 2: Diamond a -> {b, c} -> d
+    {
+        task_graph graph;
+        const auto a = graph.add_node(nullptr);
+        const auto b = graph.add_node(nullptr);
+        const auto c = graph.add_node(nullptr);
+        const auto d = graph.add_node(nullptr);
+        graph.add_dependency(a, b);
+        graph.add_dependency(a, c);
+        graph.add_dependency(b, d);
+        graph.add_dependency(c, d);
+        graph.finalize();
+
+        EXPECT_EQ(graph.size(), 4u);
+        EXPECT_EQ(graph.number_of_levels(), 3u);
+        EXPECT_EQ(graph.level(a), 0u);
+        EXPECT_EQ(graph.level(b), 1u);
+        EXPECT_EQ(graph.level(c), 1u);
+        EXPECT_EQ(graph.level(d), 2u);
+    }
+
+    // Test 3: Invalid dependencies and cycles are rejected
+    {
+        task_graph graph;
+        const auto a = graph.add_node(nullptr);
+        const auto b = graph.add_node(nullptr);
+        EXPECT_ANY_THROW(graph.add_dependency(a, a));
+        EXPECT_ANY_THROW(graph.add_dependency(a, 7));
+        graph.add_dependency(a, b);
+        graph.add_dependency(b, a);
+        EXPECT_ANY_THROW(graph.finalize());
+        EXPECT_ANY_THROW(graph.run());
+    }
+}
+
+// ============================================================================
+// Consolidated Test 2: Execution Order and Reuse
+// ============================================================================
+
+QUARISMATEST(TaskGraph, execution_order_and_reuse)
+{
+    // Layered graph: every node of layer l depends on two nodes of layer l - 1.
+    const std::size_t layers = 50;
+    const std::size_t width  = 100;
+
+    task_graph                         graph;
+    std::vector<std::atomic<int>>      done(layers * width);
+    std::vector<std::atomic<int>>      runs(layers * width);
+    std::atomic<int>                   violations{0};
+    std::vector<std::vector<unsigned>> predecessors(layers * width);
+
+    for (std::size_t l = 0; l < layers; ++l)
+    {
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            const std::size_t id = l * width + i;
+            graph.add_node(
+                [id, &done, &runs, &violations, &predecessors]
+                {
+                    for (const unsigned p : predecessors[id])
+                    {
+                        if (done[p].load(std::memory_order_acquire) <= done[id].load())
+                        {
+                            violations.fetch_add(1);
+                        }
+                    }
+                    runs[id].fetch_add(1, std::memory_order_relaxed);
+                    done[id].fetch_add(1, std::memory_order_release);
+                });
+        }
+    }
+    for (std::size_t l = 1; l < layers; ++l)
+    {
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            const auto id = static_cast<unsigned>(l * width + i);
+            for (const std::size_t j : {i, (i * 7 + 3) % width})
+            {
+                const auto p = static_cast<unsigned>((l - 1) * width + j);
+                if (predecessors[id].empty() || predecessors[id].back() != p)
+                {
+                    predecessors[id].push_back(p);
+                    graph.add_dependency(p, id);
+                }
+            }
+        }
+    }
+
+    graph.finalize();
+    EXPECT_EQ(graph.number_of_levels(), layers);
+
+    // Test 1: Repeated runs with all threads and with a single thread
+    const int repeats = 5;
+    for (int run = 0; run < repeats; ++run)
+    {
+        graph.run(run % 2 == 0 ? 0 : 1);
+    }
+
+    EXPECT_EQ(violations.load(), 0);
+    for (std::size_t id = 0; id < runs.size(); ++id)
+    {
+        ASSERT_EQ(runs[id].load(), repeats) << "Node " << id;
+    }
+
+    // Test 2: Tasks may use parallel_tools internally
+    task_graph               nested;
+    std::atomic<std::size_t> total{0};
+    for (int i = 0; i < 8; ++i)
+    {
+        nested.add_node(
+            [&total]
+            {
+                parallel_tools::parallel_for(
+                    0,
+                    1000,
+                    100,
+                    [&total](std::size_t begin, std::size_t end) { total.fetch_add(end - begin); });
+            });
+    }
+    nested.add_dependency(0, 7);
+    nested.run();
+    EXPECT_EQ(total.load(), 8000u);
+}
+
+// ============================================================================
+// Consolidated Test 3: Exceptions
+// ============================================================================
+
+QUARISMATEST(TaskGraph, exceptions)
+{
+    task_graph       graph;
+    std::atomic<int> after{0};
+    const auto       thrower = graph.add_node([] { throw std::runtime_error("task failed"); });
+    const auto       child   = graph.add_node([&after] { after.fetch_add(1); });
+    graph.add_dependency(thrower, child);
+
+    // The dependents still run and the first exception reaches the caller
+    EXPECT_THROW(graph.run(), std::runtime_error);
+    EXPECT_EQ(after.load(), 1);
+
+    // The graph stays usable
+    EXPECT_THROW(graph.run(), std::runtime_error);
+    EXPECT_EQ(after.load(), 2);
+}
+
+}  // namespace quarisma
@@ -10,7 +10,9 @@
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "Testing/baseTest.h"
 #include "common/pointer.h"
@@ -217,6 +219,49 @@ bool TestSharedFutures()
     return retVal;
 }
 
+//-----------------------------------------------------------------------------
+// Runs `pushes` on a single-threaded queue while its worker is blocked, then releases the worker
+// and returns the order in which the tasks ran.
+template <class PushesT>
+std::vector<int> RunBlocked(threaded_callback_queue& queue, PushesT&& pushes)
+{
+    std::atomic_bool started(false);
+    std::atomic_bool release(false);
+    queue.push(
+        [&started, &release]
+        {
+            started = true;
+            while (!release)
+            {
+                std::this_thread::yield();
+            }
+        });
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+
+    std::mutex       mutex;
+    std::vector<int> order;
+    auto             record = [&mutex, &order](int id)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(id);
+    };
+
+    using Array = std::vector<threaded_callback_queue::shared_future_base_pointer>;
+    Array futures;
+    pushes(record, futures);
+
+    // Waiting on the futures directly: queue.wait() would run enqueued tasks on this thread
+    release = true;
+    for (const auto& future : futures)
+    {
+        future->wait();
+    }
+    return order;
+}
+
 QUARISMATEST(TestThreadedCallbackQueue, Test)
 {
     QUARISMA_LOG_INFO("Testing futures");
@@ -232,4 +277,225 @@ QUARISMATEST(TestThreadedCallbackQueue, Test)
     // Testing shrinking the number of threads
     quarisma::RunThreads(8, 2);
 }
+
+QUARISMATEST(TestThreadedCallbackQueue, Priorities)
+{
+    using priority = threaded_callback_queue::priority;
+
+    // Test 1: Tasks run by priority level, in FIFO order within a level
+    {
+        threaded_callback_queue queue;
+        const auto              order = RunBlocked(
+            queue,
+            [&queue](auto& record, auto& futures)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    futures.emplace_back(queue.push_with_priority(priority::low, record, 20 + i));
+                    futures.emplace_back(queue.push(record, 10 + i));
+                    futures.emplace_back(queue.push_with_priority(priority::high, record, i));
+                }
+            });
+        const std::vector<int> expected{0, 1, 2, 3, 10, 11, 12, 13, 20, 21, 22, 23};
+        EXPECT_EQ(order, expected);
+    }
+
+    // Test 2: The starvation guard lets a skipped queue through
+    {
+        threaded_callback_queue queue;
+        queue.set_starvation_limit(0);
+        EXPECT_EQ(queue.get_starvation_limit(), 1);
+        queue.set_starvation_limit(3);
+        EXPECT_EQ(queue.get_starvation_limit(), 3);
+
+        const auto order = RunBlocked(
+            queue,
+            [&queue](auto& record, auto& futures)
+            {
+                futures.emplace_back(queue.push_with_priority(priority::low, record, 100));
+                for (int i = 0; i < 8; ++i)
+                {
+                    futures.emplace_back(queue.push_with_priority(priority::high, record, i));
+                }
+            });
+        const std::vector<int> expected{0, 1, 2, 100, 3, 4, 5, 6, 7};
+        EXPECT_EQ(order, expected);
+    }
+
+    // Test 3: Dependent tasks can be pushed with a priority
+    {
+        threaded_callback_queue queue;
+        const auto              order = RunBlocked(
+            queue,
+            [&queue](auto& record, auto& futures)
+            {
+                using Array = std::vector<threaded_callback_queue::shared_future_pointer<void>>;
+                auto first  = queue.push_with_priority(priority::high, record, 0);
+                futures.emplace_back(first);
+                for (int i = 0; i < 3; ++i)
+                {
+                    futures.emplace_back(queue.push(record, 10 + i));
+                }
+                futures.emplace_back(
+                    queue.push_dependent_with_priority(priority::high, Array{first}, record, 1));
+            });
+        ASSERT_EQ(order.size(), 5u);
+        EXPECT_EQ(order[0], 0);
+        EXPECT_EQ(order[1], 1);
+    }
+}
+
+QUARISMATEST(TestThreadedCallbackQueue, Pending)
+{
+    threaded_callback_queue queue;
+    queue.set_number_of_threads(2);
+
+    // Tasks depending on a pending future wait for set_value, which another thread calls
+    using IntArray = std::vector<threaded_callback_queue::shared_future_pointer<int>>;
+    auto            value = queue.make_pending<int>();
+    auto            done  = queue.make_pending<void>();
+    std::atomic_int sum(0);
+    auto            dependent = queue.push_dependent(
+        IntArray{value},
+        [&sum, value]
+        {
+            sum += value->get();
+            return sum.load();
+        });
+    EXPECT_FALSE(value->is_ready());
+    EXPECT_FALSE(dependent->is_ready());
+
+    std::thread producer(
+        [&queue, value, done]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            queue.set_value(value, 42);
+            queue.set_value(done);
+        });
+    EXPECT_EQ(queue.get(dependent), 42);
+    EXPECT_EQ(value->get(), 42);
+    queue.wait(std::vector<threaded_callback_queue::shared_future_pointer<void>>{done});
+    EXPECT_TRUE(done->is_ready());
+    producer.join();
+
+    // A task pushed after the value is set runs straight away
+    auto late = queue.push_dependent(IntArray{value}, [value] { return value->get() + 1; });
+    EXPECT_EQ(queue.get(late), 43);
+}
+
+QUARISMATEST(TestThreadedCallbackQueue, Cancellation)
+{
+    using task_options = threaded_callback_queue::task_options;
+    using VoidArray    = std::vector<threaded_callback_queue::shared_future_pointer<void>>;
+
+    // Test 1: Tasks whose token is cancelled before they start are dropped, and so are the tasks
+    // depending on them
+    {
+        threaded_callback_queue                       queue;
+        threaded_callback_queue::shared_future_base_pointer dropped;
+        threaded_callback_queue::shared_future_base_pointer dependent;
+        const auto                                          order = RunBlocked(
+            queue,
+            [&](auto& record, auto& futures)
+            {
+                task_options options;
+                options.token = threaded_callback_queue::cancellation_token();
+
+                auto first = queue.push_with_options(options, record, 0);
+                dropped    = first;
+                dependent  = queue.push_dependent(VoidArray{first}, record, 1);
+                futures.emplace_back(first);
+                futures.emplace_back(dependent);
+                futures.emplace_back(queue.push(record, 2));
+                options.token->cancel();
+            });
+        const std::vector<int> expected{2};
+        EXPECT_EQ(order, expected);
+        EXPECT_TRUE(dropped->is_cancelled());
+        EXPECT_TRUE(dependent->is_cancelled());
+    }
+
+    // Test 2: Deadlines are checked when the task is dequeued
+    {
+        threaded_callback_queue                             queue;
+        threaded_callback_queue::shared_future_base_pointer late;
+        const auto                                          order = RunBlocked(
+            queue,
+            [&](auto& record, auto& futures)
+            {
+                task_options expired;
+                expired.deadline = threaded_callback_queue::clock::now();
+                task_options distant;
+                distant.deadline =
+                    threaded_callback_queue::clock::now() + std::chrono::hours(1);
+
+                late = queue.push_with_options(expired, record, 0);
+                futures.emplace_back(late);
+                futures.emplace_back(queue.push_with_options(distant, record, 1));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            });
+        const std::vector<int> expected{1};
+        EXPECT_EQ(order, expected);
+        EXPECT_TRUE(late->is_cancelled());
+    }
+
+    // Test 3: cancel_all_matching completes the queued tasks of a tag right away
+    {
+        threaded_callback_queue                                         queue;
+        std::vector<threaded_callback_queue::shared_future_pointer<int>> tagged;
+        const auto                                                       order = RunBlocked(
+            queue,
+            [&](auto& record, auto& futures)
+            {
+                task_options request;
+                request.tag = "request";
+                task_options other;
+                other.tag = "other";
+
+                for (int i = 0; i < 3; ++i)
+                {
+                    tagged.emplace_back(queue.push_with_options(
+                        request,
+                        [&record, i]
+                        {
+                            record(i);
+                            return i + 1;
+                        }));
+                    futures.emplace_back(tagged.back());
+                    futures.emplace_back(queue.push_with_options(other, record, 10 + i));
+                }
+
+                queue.cancel_all_matching("request");
+                queue.cancel_all_matching("unknown");
+                for (const auto& future : tagged)
+                {
+                    EXPECT_TRUE(future->is_ready());
+                    EXPECT_TRUE(future->is_cancelled());
+                    EXPECT_EQ(future->get(), 0);
+                }
+
+                // The tag can be reused once cancelled
+                futures.emplace_back(queue.push_with_options(request, record, 20));
+            });
+        const std::vector<int> expected{10, 11, 12, 20};
+        EXPECT_EQ(order, expected);
+    }
+
+    // Test 4: Tasks that are not cancelled run as usual
+    {
+        threaded_callback_queue queue;
+        queue.set_number_of_threads(2);
+        task_options options;
+        options.token = threaded_callback_queue::cancellation_token();
+        options.tag   = "kept";
+        auto value    = queue.push_with_options(options, [] { return 7; });
+        auto sum      = queue.push_dependent_with_options(
+            options,
+            std::vector<threaded_callback_queue::shared_future_pointer<int>>{value},
+            [value] { return value->get() + 1; });
+        EXPECT_EQ(queue.get(sum), 8);
+        EXPECT_FALSE(value->is_cancelled());
+        EXPECT_FALSE(sum->is_cancelled());
+    }
+}
 }  // namespace quarisma
@@ -10,10 +10,12 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <tuple>
 #include <vector>
 
 #include "Testing/baseTest.h"
 #include "parallel/threaded_task_queue.h"
+#include "util/mpmc_ring_buffer.h"
 
 namespace quarisma
 {
@@ -488,4 +490,146 @@ QUARISMATEST(ThreadedTaskQueue, Test)
     }
 }
 
+// ============================================================================
+// Test Group 3: Lock-free Ring Mode and Batch Operations
+// ============================================================================
+
+QUARISMATEST(ThreadedTaskQueue, ring_and_batch)
+{
+    // Test 1: mpmc_ring_buffer capacity, full and empty states
+    {
+        mpmc_ring_buffer<int> ring(5);
+        EXPECT_EQ(ring.capacity(), 8u);
+
+        int value = 0;
+        EXPECT_FALSE(ring.try_pop(value));
+        for (int i = 0; i < 8; ++i)
+        {
+            EXPECT_TRUE(ring.try_push(std::move(i)));
+        }
+        EXPECT_FALSE(ring.try_push(100));
+        EXPECT_EQ(ring.size_approx(), 8u);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            EXPECT_TRUE(ring.try_pop(value));
+            EXPECT_EQ(value, i);
+        }
+        EXPECT_FALSE(ring.try_pop(value));
+    }
+
+    // Test 2: mpmc_ring_buffer with concurrent producers and consumers
+    {
+        mpmc_ring_buffer<int>    ring(64);
+        const int                producers  = 4;
+        const int                per_thread = 10000;
+        std::atomic<long long>   sum{0};
+        std::atomic<int>         consumed{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back(
+                [&ring]
+                {
+                    for (int i = 1; i <= per_thread; ++i)
+                    {
+                        int value = i;
+                        while (!ring.try_push(std::move(value)))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            threads.emplace_back(
+                [&ring, &sum, &consumed]
+                {
+                    int value = 0;
+                    while (consumed.load() < producers * per_thread)
+                    {
+                        if (ring.try_pop(value))
+                        {
+                            sum += value;
+                            ++consumed;
+                        }
+                        else
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        EXPECT_EQ(consumed.load(), producers * per_thread);
+        EXPECT_EQ(sum.load(), producers * (per_thread * (per_thread + 1LL) / 2));
+    }
+
+    // Test 3: Ring mode keeps strict ordering, including when the ring is full
+    {
+        auto                          worker = [](int x) { return x * 3; };
+        threaded_task_queue<int, int> queue(worker, true, -1, 4, 4);
+
+        const int num_tasks = 500;
+        for (int i = 0; i < num_tasks; ++i)
+        {
+            int val = i;
+            queue.push(std::move(val));
+        }
+        for (int i = 0; i < num_tasks; ++i)
+        {
+            int result = 0;
+            EXPECT_TRUE(queue.pop(result));
+            EXPECT_EQ(result, i * 3);
+        }
+        EXPECT_TRUE(queue.is_empty());
+    }
+
+    // Test 4: push_batch and pop_batch, with and without the ring
+    for (const int ring_capacity : {0, 256})
+    {
+        using queue_type = threaded_task_queue<int, int, int>;
+
+        const int                               num_tasks = 1000;
+        std::vector<queue_type::argument_tuple> batch;
+        auto                                    worker = [](int a, int b) { return a * b; };
+        queue_type                              queue(worker, true, -1, 3, ring_capacity);
+        for (int i = 0; i < num_tasks; ++i)
+        {
+            batch.emplace_back(i, 2);
+        }
+        queue.push_batch(std::move(batch));
+
+        std::vector<int> results;
+        while (queue.pop_batch(results, 64) > 0)
+        {
+        }
+        ASSERT_EQ(results.size(), static_cast<std::size_t>(num_tasks));
+        for (int i = 0; i < num_tasks; ++i)
+        {
+            EXPECT_EQ(results[i], i * 2);
+        }
+        EXPECT_TRUE(queue.is_empty());
+        EXPECT_EQ(queue.pop_batch(results), 0u);
+    }
+
+    // Test 5: Void specialization in ring mode
+    {
+        std::atomic<int>               counter{0};
+        auto                           worker = [&counter](int x) { counter += x; };
+        threaded_task_queue<void, int> queue(worker, false, -1, 4, 16);
+
+        std::vector<std::tuple<int>> batch(100, std::tuple<int>(1));
+        queue.push_batch(std::move(batch));
+        for (int i = 0; i < 100; ++i)
+        {
+            queue.push(2);
+        }
+        queue.flush();
+        EXPECT_EQ(counter.load(), 300);
+        EXPECT_TRUE(queue.is_empty());
+    }
+}
+
 }  // namespace quarisma
@@ -18,6 +18,7 @@
  * Website: https://www.quarisma.co.uk
  */
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -26,6 +27,7 @@
 #include <thread>
 #include <vector>
 
+#include "profiler/base/external_ranges.h"
 #include "profiler/native/tracing/traceme.h"
 #include "profiler/native/tracing/traceme_encode.h"
 #include "profiler/native/tracing/traceme_recorder.h"
@@ -648,4 +650,209 @@ QUARISMATEST(TracemeTest, zero_duration_traces)
     QUARISMA_CHECK(true, "Zero duration traces should be handled gracefully");
     END_TEST();
 }
+
+QUARISMATEST(TracemeTest, flight_recorder_keeps_recent_events)
+{
+    traceme_recorder::FlightRecorderOptions options;
+    options.window            = std::chrono::milliseconds(60000);
+    options.events_per_thread = 16;
+    ASSERT_TRUE(traceme_recorder::start_flight_recorder(options));
+    EXPECT_TRUE(traceme_recorder::flight_recorder_active());
+
+    // Only one session at a time
+    EXPECT_FALSE(traceme_recorder::start(1));
+    EXPECT_FALSE(traceme_recorder::start_flight_recorder(options));
+
+    for (int i = 0; i < 100; ++i)
+    {
+        traceme trace([i]() { return "flight_" + std::to_string(i); });
+    }
+
+    auto count_events = [](const traceme_recorder::Events& events, const std::string& name)
+    {
+        size_t count = 0;
+        for (const auto& thread_events : events)
+        {
+            for (const auto& event : thread_events.events)
+            {
+                count += event.name == name ? 1 : 0;
+            }
+        }
+        return count;
+    };
+
+    // The ring holds the 16 most recent events of this thread
+    auto events = traceme_recorder::snapshot();
+    ASSERT_EQ(events.size(), 1u);
+    ASSERT_EQ(events[0].events.size(), 16u);
+    EXPECT_EQ(events[0].events.front().name, "flight_84");
+    EXPECT_EQ(events[0].events.back().name, "flight_99");
+
+    // A snapshot does not stop recording or consume the ring
+    EXPECT_TRUE(traceme_recorder::flight_recorder_active());
+    EXPECT_EQ(count_events(traceme_recorder::snapshot(), "flight_99"), 1u);
+
+    // Split activities are paired across threads; the ending thread stays alive
+    // since the rings of exited threads are discarded
+    int64_t const    activity = traceme::activity_start("flight_split");
+    std::atomic<int> step{0};
+    std::thread      ending(
+        [activity, &step]()
+        {
+            traceme::activity_end(activity);
+            step = 1;
+            while (step.load() != 2)
+            {
+                std::this_thread::yield();
+            }
+        });
+    while (step.load() != 1)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(count_events(traceme_recorder::snapshot(), "flight_split"), 1u);
+    step = 2;
+    ending.join();
+
+    events = traceme_recorder::stop();
+    EXPECT_FALSE(traceme_recorder::flight_recorder_active());
+    EXPECT_EQ(count_events(events, "flight_99"), 1u);
+    EXPECT_TRUE(traceme_recorder::snapshot().empty());
+
+    // The regular mode is available again and starts empty
+    ASSERT_TRUE(traceme_recorder::start(1));
+    {
+        traceme trace("after_flight");
+    }
+    events = traceme_recorder::stop();
+    EXPECT_EQ(count_events(events, "after_flight"), 1u);
+    EXPECT_EQ(count_events(events, "flight_99"), 0u);
+}
+
+QUARISMATEST(TracemeTest, flight_recorder_window)
+{
+    traceme_recorder::FlightRecorderOptions options;
+    options.window = std::chrono::milliseconds(50);
+    ASSERT_TRUE(traceme_recorder::start_flight_recorder(options));
+
+    {
+        traceme trace("flight_old");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        traceme trace("flight_new");
+    }
+
+    // Events that ended before the window are left out
+    auto events = traceme_recorder::snapshot();
+    ASSERT_EQ(events.size(), 1u);
+    ASSERT_EQ(events[0].events.size(), 1u);
+    EXPECT_EQ(events[0].events[0].name, "flight_new");
+    traceme_recorder::stop();
+
+    options.window = std::chrono::milliseconds(0);
+    EXPECT_ANY_THROW(traceme_recorder::start_flight_recorder(options));
+    EXPECT_FALSE(traceme_recorder::active(0));
+}
+
+QUARISMATEST(TracemeTest, interned_names)
+{
+    static const traceme_name kOp("interned_op");
+    static const traceme_name kRows("rows");
+    static const traceme_name kScale("scale");
+    static const traceme_name kDone("done");
+    static const traceme_name kKind("kind");
+    static const traceme_name kGemm("gemm");
+
+    // Ids are stable and shared by equal strings
+    EXPECT_NE(kOp.id(), 0u);
+    EXPECT_EQ(traceme_name("interned_op").id(), kOp.id());
+    EXPECT_NE(kRows.id(), kOp.id());
+    EXPECT_EQ(kRows.str(), "rows");
+    EXPECT_TRUE(traceme_name::lookup(0).empty());
+    EXPECT_ANY_THROW(traceme_name("bad#name"));
+
+    // Disabled tracing records nothing
+    {
+        traceme trace(kOp, {{kRows, 1}});
+    }
+
+    ASSERT_TRUE(traceme_recorder::start(1));
+    {
+        traceme trace(kOp, {{kRows, -42}, {kScale, 0.5}, {kDone, true}, {kKind, kGemm}});
+    }
+    {
+        traceme trace(kOp);
+    }
+    {
+        traceme trace(kOp, {{kRows, uint64_t{7}}});
+        trace.append_metadata([]() { return traceme_encode({{"extra", 1}}); });
+    }
+    int64_t const activity = traceme::activity_start(kGemm, {{kRows, 3}});
+    traceme::activity_end(activity);
+    auto events = traceme_recorder::stop();
+
+    std::vector<std::string> names;
+    for (const auto& thread : events)
+    {
+        for (const auto& event : thread.events)
+        {
+            EXPECT_TRUE(event.payload.empty());
+            names.push_back(event.name);
+        }
+    }
+    ASSERT_EQ(names.size(), 4u);
+    EXPECT_EQ(
+        names[0],
+        traceme_encode(
+            "interned_op", {{"rows", -42}, {"scale", 0.5}, {"done", true}, {"kind", "gemm"}}));
+    EXPECT_EQ(names[1], "interned_op");
+    EXPECT_EQ(names[2], "interned_op#rows=7,extra=1#");
+    EXPECT_EQ(names[3], "gemm#rows=3#");
+}
+
+QUARISMATEST(TracemeTest, external_ranges)
+{
+    using quarisma::profiler::external_ranges;
+
+    int const level = external_ranges::level();
+#if QUARISMA_HAS_EXTERNAL_RANGES
+    external_ranges::set_level(2);
+    EXPECT_TRUE(external_ranges::active(2));
+    EXPECT_FALSE(external_ranges::active(3));
+#else
+    EXPECT_EQ(level, 0);
+    EXPECT_FALSE(external_ranges::active());
+#endif
+
+    // Ranges open and close along with the events, recorded or not
+    static const traceme_name kOp("external_op");
+    for (bool const record : {false, true})
+    {
+        if (record)
+        {
+            ASSERT_TRUE(traceme_recorder::start(2));
+        }
+        {
+            traceme outer("outer#rows=1#");
+            traceme inner([] { return std::string("inner"); }, 2);
+            traceme interned(kOp);
+            traceme moved(std::move(inner));
+            moved.stop();
+        }
+        if (record)
+        {
+            size_t recorded = 0;
+            for (const auto& thread : traceme_recorder::stop())
+            {
+                recorded += thread.events.size();
+            }
+            EXPECT_EQ(recorded, 3u);
+        }
+    }
+
+    external_ranges::set_level(0);
+    EXPECT_FALSE(external_ranges::active());
+    external_ranges::set_level(level);
+}
 #endif  // QUARISMA_HAS_NATIVE_PROFILER
@@ -0,0 +1,101 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * Tests for tsc_clock: monotonicity, agreement with steady_clock and the
+ * steady_clock fallback.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+#include "Testing/baseTest.h"
+#include "util/tsc_clock.h"
+
+using quarisma::tsc_clock;
+
+namespace
+{
+/// Largest tolerated difference with steady_clock, generous for loaded machines
+constexpr int64_t tolerance_ns = 2'000'000;
+
+int64_t distance_to_steady()
+{
+    int64_t const before = tsc_clock::steady_ns();
+    int64_t const now    = tsc_clock::now_ns();
+    int64_t const after  = tsc_clock::steady_ns();
+    return (std::max)(before - now, now - after);
+}
+}  // namespace
+
+QUARISMATEST(TscClock, monotonic)
+{
+    int64_t previous = tsc_clock::now_ns();
+    for (int i = 0; i < 100000; ++i)
+    {
+        int64_t const now = tsc_clock::now_ns();
+        ASSERT_GE(now, previous);
+        previous = now;
+    }
+
+    static_assert(tsc_clock::is_steady);
+    auto const first  = tsc_clock::now();
+    auto const second = tsc_clock::now();
+    EXPECT_LE(first, second);
+
+    END_TEST();
+}
+
+QUARISMATEST(TscClock, follows_steady_clock)
+{
+    EXPECT_LE(distance_to_steady(), tolerance_ns);
+
+    int64_t const clock_start  = tsc_clock::now_ns();
+    int64_t const steady_start = tsc_clock::steady_ns();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int64_t const clock_elapsed  = tsc_clock::now_ns() - clock_start;
+    int64_t const steady_elapsed = tsc_clock::steady_ns() - steady_start;
+    EXPECT_LE(std::abs(clock_elapsed - steady_elapsed), tolerance_ns);
+
+    if (tsc_clock::available())
+    {
+        EXPECT_GT(tsc_clock::ticks_per_second(), 1e6);
+        EXPECT_LE(tsc_clock::measured_skew_ns(), tsc_clock::max_skew_ns);
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(TscClock, recalibration_is_continuous)
+{
+    for (int round = 0; round < 5; ++round)
+    {
+        int64_t const before = tsc_clock::now_ns();
+        tsc_clock::recalibrate();
+        int64_t const after = tsc_clock::now_ns();
+        EXPECT_GE(after, before);
+        EXPECT_LE(distance_to_steady(), tolerance_ns);
+    }
+
+    END_TEST();
+}
+
+QUARISMATEST(TscClock, steady_clock_fallback)
+{
+    bool const was_enabled = tsc_clock::available();
+
+    EXPECT_FALSE(tsc_clock::set_enabled(false));
+    EXPECT_FALSE(tsc_clock::available());
+    EXPECT_EQ(tsc_clock::ticks_per_second(), 0.0);
+    EXPECT_LE(distance_to_steady(), 0);
+
+    EXPECT_EQ(tsc_clock::set_enabled(true), was_enabled);
+    EXPECT_EQ(tsc_clock::available(), was_enabled);
+    EXPECT_LE(distance_to_steady(), tolerance_ns);
+
+    END_TEST();
+}
@@ -0,0 +1,434 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Testing/baseTest.h"
+#include "Testing/cpuCapabilityTest.h"
+#include "math/vmath.h"
+#include "math/vmath_dispatch.h"
+#include "util/cpu_info.h"
+
+using namespace quarisma;
+using vmath::accuracy;
+using vmath::detail::function;
+
+namespace
+{
+constexpr accuracy tiers[] = {accuracy::high, accuracy::medium, accuracy::fast};
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+constexpr double qnan = std::numeric_limits<double>::quiet_NaN();
+
+// The table of math/vmath.h: ulp for high and medium, relative error for fast
+struct bounds
+{
+    double high;
+    double medium;
+    double fast;
+
+    double operator()(accuracy a) const
+    {
+        return a == accuracy::high ? high : a == accuracy::medium ? medium : fast;
+    }
+};
+
+template <typename T>
+auto kernel_of(cpu_capability c)
+{
+    if constexpr (std::is_same_v<T, double>)
+    {
+        return vmath::detail::double_kernel_stub_type::kernel(c);
+    }
+    else
+    {
+        return vmath::detail::float_kernel_stub_type::kernel(c);
+    }
+}
+
+template <typename T>
+long double ulp_of(long double reference)
+{
+    long double const a = std::fabs(reference);
+    if (a < std::numeric_limits<T>::min())
+    {
+        return std::numeric_limits<T>::denorm_min();
+    }
+    return std::ldexp(1.0L, std::ilogb(a) - (std::numeric_limits<T>::digits - 1));
+}
+
+// Error of value in ulp of T or, when relative is set, relative to reference
+template <typename T>
+double error_of(T value, long double reference, bool relative)
+{
+    if (std::fabs(reference) > std::numeric_limits<T>::max())
+    {
+        reference = std::copysign(std::numeric_limits<long double>::infinity(), reference);
+    }
+    if (std::isnan(reference) || std::isinf(reference))
+    {
+        bool const same = (std::isnan(reference) && std::isnan(value)) ||
+                          static_cast<long double>(value) == reference;
+        return same ? 0 : inf;
+    }
+
+    long double const difference = std::fabs(static_cast<long double>(value) - reference);
+    if (relative)
+    {
+        long double const scale =
+            std::max<long double>(std::fabs(reference), std::numeric_limits<T>::min());
+        return static_cast<double>(difference / scale);
+    }
+    return static_cast<double>(difference / ulp_of<T>(reference));
+}
+
+std::vector<double> linear(double lo, double hi, size_t n)
+{
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        x[i] = lo + (hi - lo) * static_cast<double>(i) / static_cast<double>(n - 1);
+    }
+    return x;
+}
+
+// Uniformly distributed exponents in [lo, hi) and significands in [1, 2)
+std::vector<double> logarithmic(int lo, int hi, size_t n, uint32_t seed)
+{
+    std::mt19937_64                        engine(seed);
+    std::uniform_real_distribution<double> significand(1.0, 2.0);
+    std::uniform_int_distribution<int>     exponent(lo, hi - 1);
+    std::vector<double>                    x(n);
+    for (auto& v : x)
+    {
+        v = std::ldexp(significand(engine), exponent(engine));
+    }
+    return x;
+}
+
+std::vector<double> join(std::vector<double> a, const std::vector<double>& b)
+{
+    a.insert(a.end(), b.begin(), b.end());
+    return a;
+}
+
+template <typename T>
+std::vector<T> narrow(const std::vector<double>& x)
+{
+    return std::vector<T>(x.begin(), x.end());
+}
+
+// Worst error of fn over x, for each tier and capability
+template <typename T, typename Reference>
+void check_accuracy(function fn, const std::vector<T>& x, Reference reference, bounds limit)
+{
+    for (cpu_capability c : capabilities())
+    {
+        auto const kernel = kernel_of<T>(c);
+        for (accuracy a : tiers)
+        {
+            std::vector<T> y(x.size());
+            kernel(fn, a, x.data(), y.data(), x.size());
+
+            double worst = 0;
+            size_t where = 0;
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                double const e = error_of(y[i], reference(x[i]), a == accuracy::fast);
+                if (e > worst)
+                {
+                    worst = e;
+                    where = i;
+                }
+            }
+            EXPECT_LE(worst, limit(a)) << "capability " << static_cast<int>(c) << ", tier "
+                                       << static_cast<int>(a) << ", x = " << x[where];
+        }
+    }
+}
+
+long double norm_cdf_reference(long double x)
+{
+    return 0.5L * std::erfc(-x / std::sqrt(2.0L));
+}
+
+template <typename T>
+void expect_same(T value, T expected)
+{
+    if (std::isnan(expected))
+    {
+        EXPECT_TRUE(std::isnan(value));
+    }
+    else
+    {
+        EXPECT_EQ(value, expected);
+        EXPECT_EQ(std::signbit(value), std::signbit(expected));
+    }
+}
+
+template <typename T, typename Function>
+void expect_special(
+    Function f, const std::vector<double>& x, const std::vector<double>& expected)
+{
+    std::vector<T> const in = narrow<T>(x);
+    for (accuracy a : tiers)
+    {
+        std::vector<T> out(in.size());
+        f(in.data(), out.data(), in.size(), a);
+        for (size_t i = 0; i < in.size(); ++i)
+        {
+            expect_same(out[i], static_cast<T>(expected[i]));
+        }
+    }
+}
+}  // namespace
+
+QUARISMATEST(Vmath, exp)
+{
+    auto const x = join(linear(-745.2, 709.8, 200001), linear(-1.0, 1.0, 20001));
+    check_accuracy(
+        function::exp, x, [](long double v) { return std::exp(v); }, {1, 4, 0x1p-26});
+    check_accuracy(
+        function::exp,
+        narrow<float>(linear(-104.0, 88.8, 200001)),
+        [](double v) { return std::exp(v); },
+        {1, 4, 0x1p-12});
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, log)
+{
+    auto const x = join(logarithmic(-1074, 1024, 200000, 1), linear(0.5, 2.0, 100001));
+    check_accuracy(
+        function::log, x, [](long double v) { return std::log(v); }, {1, 4, 0x1p-26});
+    check_accuracy(
+        function::log,
+        narrow<float>(join(logarithmic(-149, 128, 200000, 2), linear(0.5, 2.0, 100001))),
+        [](double v) { return std::log(v); },
+        {1, 4, 0x1p-12});
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, sqrt)
+{
+    auto const x = logarithmic(-1074, 1024, 100000, 3);
+    check_accuracy(
+        function::sqrt, x, [](double v) { return std::sqrt(v); }, {0, 0, 0});
+    check_accuracy(
+        function::sqrt,
+        narrow<float>(logarithmic(-149, 128, 100000, 4)),
+        [](float v) { return std::sqrt(v); },
+        {0, 0, 0});
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, erf)
+{
+    check_accuracy(
+        function::erf,
+        linear(-7.0, 7.0, 200001),
+        [](long double v) { return std::erf(v); },
+        {2, 4, 0x1p-26});
+    check_accuracy(
+        function::erfc,
+        linear(-7.0, 27.5, 200001),
+        [](long double v) { return std::erfc(v); },
+        {3, 4, 0x1p-26});
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, norm_cdf)
+{
+    check_accuracy(
+        function::norm_cdf, linear(-38.5, 9.0, 200001), norm_cdf_reference, {3, 4, 0x1p-26});
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, norm_inv_cdf)
+{
+    // The error of quantile x of p is (Phi(x) - p) / phi(x); in its ulps, or relative for fast
+    std::vector<double> p = join(logarithmic(-1000, -1, 100000, 5), linear(1e-3, 1 - 1e-3, 100001));
+    for (size_t i = 0, n = p.size(); i < n; i += 2)
+    {
+        p.push_back(1.0 - p[i]);
+    }
+
+    long double const sqrt_2pi = std::sqrt(2.0L * 3.141592653589793238462643383279502884L);
+    for (cpu_capability c : capabilities())
+    {
+        auto const kernel = kernel_of<double>(c);
+        for (accuracy a : tiers)
+        {
+            std::vector<double> x(p.size());
+            kernel(function::norm_inv_cdf, a, p.data(), x.data(), p.size());
+
+            double worst = 0;
+            size_t where = 0;
+            for (size_t i = 0; i < p.size(); ++i)
+            {
+                long double const xi    = x[i];
+                long double const pdf   = std::exp(-0.5L * xi * xi) / sqrt_2pi;
+                long double const error = std::fabs((norm_cdf_reference(xi) - p[i]) / pdf);
+                double const      e     = static_cast<double>(
+                    a == accuracy::fast ? error / std::fabs(xi) : error / ulp_of<double>(xi));
+                if (e > worst)
+                {
+                    worst = e;
+                    where = i;
+                }
+            }
+            EXPECT_LE(worst, (bounds{3, 4, 0x1p-26}(a)))
+                << "capability " << static_cast<int>(c) << ", tier " << static_cast<int>(a)
+                << ", p = " << p[where];
+        }
+    }
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, float_erf_family)
+{
+    // The double kernels round to within 1 ulp of float at every tier
+    auto const x = narrow<float>(linear(-9.0, 9.0, 20001));
+    auto const p =
+        narrow<float>(join(logarithmic(-126, -1, 10000, 6), linear(1e-3, 1 - 1e-3, 10001)));
+    for (accuracy a : tiers)
+    {
+        std::vector<float>  y(x.size());
+        std::vector<float>  q(p.size());
+        std::vector<double> wide(p.begin(), p.end());
+        std::vector<double> quantile(p.size());
+        vmath::norm_inv_cdf(wide.data(), quantile.data(), wide.size(), accuracy::high);
+        vmath::norm_inv_cdf(p.data(), q.data(), p.size(), a);
+        for (size_t i = 0; i < p.size(); ++i)
+        {
+            EXPECT_LE(error_of(q[i], quantile[i], false), 1) << "p = " << p[i];
+        }
+
+        vmath::erf(x.data(), y.data(), x.size(), a);
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            EXPECT_LE(error_of(y[i], std::erf(static_cast<double>(x[i])), false), 1);
+        }
+        vmath::erfc(x.data(), y.data(), x.size(), a);
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            EXPECT_LE(error_of(y[i], std::erfc(static_cast<double>(x[i])), false), 1);
+        }
+        vmath::norm_cdf(x.data(), y.data(), x.size(), a);
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            EXPECT_LE(error_of(y[i], norm_cdf_reference(x[i]), false), 1);
+        }
+    }
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, special_values)
+{
+    double const tiny = std::numeric_limits<double>::denorm_min();
+
+    auto const exp = [](const auto* x, auto* y, size_t n, accuracy a) { vmath::exp(x, y, n, a); };
+    expect_special<double>(exp, {qnan, inf, -inf, 0.0, 710.0, -746.0}, {qnan, inf, 0, 1, inf, 0});
+    expect_special<float>(exp, {qnan, inf, -inf, 0.0, 89.0, -104.0}, {qnan, inf, 0, 1, inf, 0});
+
+    auto const log = [](const auto* x, auto* y, size_t n, accuracy a) { vmath::log(x, y, n, a); };
+    expect_special<double>(
+        log, {qnan, inf, 0.0, -0.0, -1.0, -inf, 1.0}, {qnan, inf, -inf, -inf, qnan, qnan, 0});
+    expect_special<float>(
+        log, {qnan, inf, 0.0, -0.0, -1.0, -inf, 1.0}, {qnan, inf, -inf, -inf, qnan, qnan, 0});
+
+    auto const sqrt = [](const auto* x, auto* y, size_t n, accuracy a) { vmath::sqrt(x, y, n, a); };
+    expect_special<double>(sqrt, {qnan, inf, 0.0, -0.0, -1.0}, {qnan, inf, 0.0, -0.0, qnan});
+
+    auto const erf = [](const auto* x, auto* y, size_t n, accuracy a) { vmath::erf(x, y, n, a); };
+    expect_special<double>(erf, {qnan, inf, -inf, 0.0, -0.0}, {qnan, 1, -1, 0.0, -0.0});
+    expect_special<float>(erf, {qnan, inf, -inf, 0.0, -0.0}, {qnan, 1, -1, 0.0, -0.0});
+
+    auto const erfc = [](const auto* x, auto* y, size_t n, accuracy a) { vmath::erfc(x, y, n, a); };
+    expect_special<double>(erfc, {qnan, inf, -inf, 0.0, 30.0}, {qnan, 0, 2, 1, 0});
+
+    auto const cdf = [](const auto* x, auto* y, size_t n, accuracy a)
+    { vmath::norm_cdf(x, y, n, a); };
+    expect_special<double>(cdf, {qnan, inf, -inf, 0.0, -40.0, 40.0}, {qnan, 1, 0, 0.5, 0, 1});
+    expect_special<float>(cdf, {qnan, inf, -inf, 0.0, -40.0, 40.0}, {qnan, 1, 0, 0.5, 0, 1});
+
+    auto const inv = [](const auto* x, auto* y, size_t n, accuracy a)
+    { vmath::norm_inv_cdf(x, y, n, a); };
+    expect_special<double>(
+        inv, {qnan, 0.0, 1.0, -0.5, 1.5, inf, 0.5}, {qnan, -inf, inf, qnan, qnan, qnan, 0});
+    expect_special<float>(
+        inv, {qnan, 0.0, 1.0, -0.5, 1.5, inf, 0.5}, {qnan, -inf, inf, qnan, qnan, qnan, 0});
+
+    // Subnormal results and arguments
+    std::vector<double> const x = {-740.0, tiny, -37.5};
+    std::vector<double>       y(x.size());
+    vmath::exp(x.data(), y.data(), 1);
+    EXPECT_LE(error_of(y[0], std::exp(-740.0L), false), 1);
+    vmath::log(x.data() + 1, y.data() + 1, 1);
+    EXPECT_LE(error_of(y[1], std::log(static_cast<long double>(tiny)), false), 1);
+    vmath::norm_cdf(x.data() + 2, y.data() + 2, 1);
+    EXPECT_LE(error_of(y[2], norm_cdf_reference(-37.5L), false), 1);
+    END_TEST();
+}
+
+QUARISMATEST(Vmath, blocks)
+{
+    // Past parallel_grain the work is split across tasks, which must not change a bit
+    size_t const        n = 3 * vmath::parallel_grain + 7;
+    std::vector<double> x = linear(-30.0, 30.0, n);
+    std::vector<double> expected(n);
+    kernel_of<double>(cpu_info::capability())(
+        function::norm_cdf, accuracy::high, x.data(), expected.data(), n);
+
+    std::vector<double> y(n);
+    vmath::norm_cdf(x.data(), y.data(), n);
+    EXPECT_TRUE(std::equal(y.begin(), y.end(), expected.begin()));
+
+    vmath::norm_cdf(x.data(), x.data(), n);
+    EXPECT_TRUE(std::equal(x.begin(), x.end(), expected.begin()));
+
+    std::vector<float> xf = narrow<float>(linear(-30.0, 30.0, n));
+    std::vector<float> yf(n);
+    vmath::norm_cdf(xf.data(), yf.data(), n);
+    for (size_t i = 0; i < n; i += 97)
+    {
+        EXPECT_LE(error_of(yf[i], norm_cdf_reference(xf[i]), false), 1);
+    }
+
+    // Lengths around the vector width, from an unaligned start, stop at n
+    std::vector<double> in = linear(0.5, 2.0, 40);
+    for (size_t count = 0; count < 33; ++count)
+    {
+        std::vector<double> out(in.size(), -1.0);
+        vmath::log(in.data() + 1, out.data() + 1, count);
+        EXPECT_EQ(out[0], -1.0);
+        EXPECT_EQ(out[count + 1], -1.0);
+        for (size_t i = 1; i <= count; ++i)
+        {
+            EXPECT_LE(error_of(out[i], std::log(static_cast<long double>(in[i])), false), 1);
+        }
+    }
+    END_TEST();
+}
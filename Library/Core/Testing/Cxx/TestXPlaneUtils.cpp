@@ -8,6 +8,8 @@
  * Tests utility functions for XPlane manipulation
  */
 
+#include <algorithm>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -321,4 +323,189 @@ QUARISMATEST(XPlaneUtils, xevents_comparator_nested_events)
     EXPECT_TRUE(comparator(event1, event2));
     EXPECT_FALSE(comparator(event2, event1));
 }
+// ============================================================================
+// sort_xplane / MergePlanes / AggregateXPlane Tests
+// ============================================================================
+
+namespace
+{
+
+void add_events(xplane_builder& builder, xline_builder line, std::vector<int64_t> offsets)
+{
+    xevent_metadata* metadata = builder.get_or_create_event_metadata("op");
+    for (int64_t const offset : offsets)
+    {
+        xevent_builder event = line.add_event(*metadata);
+        event.SetOffsetPs(offset);
+        event.SetDurationPs(10);
+    }
+}
+
+bool line_sorted(const xline& line)
+{
+    return std::is_sorted(line.events().begin(), line.events().end(), xevents_comparator());
+}
+
+}  // namespace
+
+QUARISMATEST(XPlaneUtils, sort_xplane_small_and_large_lines)
+{
+    x_space space;
+    space.add_planes();
+    space.add_planes();
+    xplane*        plane = space.mutable_planes(0);
+    xplane_builder builder(plane);
+    add_events(builder, builder.get_or_create_line(1), {30, 10, 20});
+
+    std::vector<int64_t> offsets(5000);
+    std::mt19937         rng(7);
+    for (auto& offset : offsets)
+    {
+        offset = static_cast<int64_t>(rng() % 1000);
+    }
+    add_events(builder, builder.get_or_create_line(2), offsets);
+    // Same start, the longer event sorts first
+    xevent_builder outer = builder.get_or_create_line(2).add_event(
+        *builder.get_or_create_event_metadata("outer"));
+    outer.SetOffsetPs(500);
+    outer.SetDurationPs(1000);
+
+    xplane_builder(space.mutable_planes(1)).get_or_create_line(3);
+    add_events(builder, builder.get_or_create_line(4), {5, 4, 3, 2, 1});
+
+    sort_x_space(&space);
+    for (const xplane& p : space.planes())
+    {
+        for (const xline& line : p.lines())
+        {
+            EXPECT_TRUE(line_sorted(line));
+        }
+    }
+    const xline* large = find_line_with_id(*plane, 2);
+    ASSERT_NE(large, nullptr);
+    EXPECT_EQ(large->events_size(), 5001u);
+    auto const first_500 = std::find_if(
+        large->events().begin(),
+        large->events().end(),
+        [](const xevent& e) { return e.offset_ps() == 500; });
+    ASSERT_NE(first_500, large->events().end());
+    EXPECT_EQ(first_500->duration_ps(), 1000);
+    EXPECT_EQ(find_line_with_id(*plane, 1)->events(0).offset_ps(), 10);
+}
+
+QUARISMATEST(XPlaneUtils, merge_planes_offsets_and_metadata)
+{
+    xplane src_a;
+    xplane src_b;
+    xplane dst;
+    {
+        xplane_builder a(&src_a);
+        xline_builder  line = a.get_or_create_line(1);
+        line.SetName("thread");
+        line.SetTimestampNs(100);
+        add_events(a, line, {0, 1000});
+        // Metadata ids of the sources differ from the destination's
+        a.get_or_create_event_metadata("padding");
+        xevent_builder tagged = line.add_event(*a.get_or_create_event_metadata("tagged"));
+        tagged.SetOffsetPs(2000);
+        tagged.add_stat_value(
+            *a.get_or_create_stat_metadata("kind"), *a.get_or_create_stat_metadata("kernel"));
+        a.get_or_create_line(2).SetTimestampNs(0);  // No events: dropped
+    }
+    {
+        xplane_builder b(&src_b);
+        xline_builder  line = b.get_or_create_line(1);
+        line.SetTimestampNs(50);
+        add_events(b, line, {0});
+        xline_builder other = b.get_or_create_line(3);
+        other.SetTimestampNs(7);
+        other.SetName("other");
+        xevent_builder aggregated = other.add_event(*b.get_or_create_event_metadata("agg"));
+        aggregated.SetNumOccurrences(4);
+        aggregated.SetDurationPs(40);
+    }
+    {
+        xplane_builder d(&dst);
+        xline_builder  line = d.get_or_create_line(1);
+        line.SetTimestampNs(200);
+        add_events(d, line, {0});
+    }
+
+    MergePlanes(std::vector<const xplane*>{&src_a, &src_b}, &dst);
+
+    ASSERT_EQ(dst.lines().size(), 2u);
+    const xline* merged = find_line_with_id(dst, 1);
+    ASSERT_NE(merged, nullptr);
+    EXPECT_EQ(merged->name(), "thread");
+    EXPECT_EQ(merged->timestamp_ns(), 50);
+    // dst event, then src_a's three events, then src_b's, all relative to 50 ns
+    ASSERT_EQ(merged->events_size(), 5u);
+    EXPECT_EQ(merged->events(0).offset_ps(), 150000);
+    EXPECT_EQ(merged->events(1).offset_ps(), 50000);
+    EXPECT_EQ(merged->events(2).offset_ps(), 51000);
+    EXPECT_EQ(merged->events(3).offset_ps(), 52000);
+    EXPECT_EQ(merged->events(4).offset_ps(), 0);
+    EXPECT_EQ(find_line_with_id(dst, 2), nullptr);
+
+    xplane_visitor const visitor(&dst);
+    xline_visitor const  line(&visitor, merged);
+    std::vector<std::string> names;
+    line.for_each_event([&](const xevent_visitor& e) { names.emplace_back(e.name()); });
+    EXPECT_EQ(names, (std::vector<std::string>{"op", "op", "op", "tagged", "op"}));
+
+    xevent_visitor const tagged(&visitor, merged, &merged->events(3));
+    std::string          kind;
+    tagged.for_each_stat(
+        [&](const x_stat_visitor& stat)
+        {
+            if (stat.name() == "kind")
+            {
+                kind = std::string(stat.str_or_ref_value());
+            }
+        });
+    EXPECT_EQ(kind, "kernel");
+
+    const xline* other = find_line_with_id(dst, 3);
+    ASSERT_NE(other, nullptr);
+    EXPECT_EQ(other->display_name(), "other");
+    EXPECT_EQ(other->events(0).num_occurrences(), 4);
+}
+
+QUARISMATEST(XPlaneUtils, aggregate_xplane_op_lines)
+{
+    xplane full;
+    xplane aggregated;
+    {
+        xplane_builder builder(&full);
+        for (int64_t id = 1; id <= 3; ++id)
+        {
+            xline_builder line = builder.get_or_create_line(id);
+            line.SetName("kXlaOpLineName");
+            xevent_builder parent = line.add_event(*builder.get_or_create_event_metadata("parent"));
+            parent.SetOffsetPs(0);
+            parent.SetDurationPs(100);
+            xevent_builder child = line.add_event(*builder.get_or_create_event_metadata("child"));
+            child.SetOffsetPs(10);
+            child.SetDurationPs(30 * id);
+        }
+        builder.get_or_create_line(9).SetName("not ops");
+    }
+
+    AggregateXPlane(full, aggregated);
+
+    ASSERT_EQ(aggregated.lines().size(), 3u);
+    xplane_visitor const visitor(&aggregated);
+    for (int64_t id = 1; id <= 3; ++id)
+    {
+        const xline* line = find_line_with_id(aggregated, id);
+        ASSERT_NE(line, nullptr);
+        ASSERT_EQ(line->events_size(), 2u);
+        for (const xevent& raw : line->events())
+        {
+            xevent_visitor const event(&visitor, line, &raw);
+            EXPECT_EQ(event.num_occurrences(), 1);
+            EXPECT_EQ(event.duration_ps(), event.name() == "parent" ? 100 : 30 * id);
+        }
+    }
+}
 #endif  // QUARISMA_HAS_NATIVE_PROFILER
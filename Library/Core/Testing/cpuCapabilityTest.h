@@ -0,0 +1,41 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#ifndef QUARISMA_CPU_CAPABILITY_TEST_H
+#define QUARISMA_CPU_CAPABILITY_TEST_H
+
+#include <vector>
+
+#include "util/cpu_info.h"
+
+namespace quarisma
+{
+// Every capability this CPU runs, so that each registered kernel is checked
+inline std::vector<cpu_capability> capabilities()
+{
+    std::vector<cpu_capability> result;
+    for (int c = 0; c <= static_cast<int>(cpu_info::capability()); ++c)
+    {
+        result.push_back(static_cast<cpu_capability>(c));
+    }
+    return result;
+}
+}  // namespace quarisma
+
+#endif  // QUARISMA_CPU_CAPABILITY_TEST_H
@@ -0,0 +1,169 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file enzyme_diff.h
+ * @brief Derivatives of plain C++ kernels generated at compile time by Enzyme
+ *
+ * A kernel is a function double f(const double* x, const P* params): x holds
+ * the n inputs to differentiate (spot, volatility, rates, ...) and params all
+ * that is held constant (strike, maturity, flags, ...). Enzyme differentiates
+ * the optimized LLVM IR of the kernel, so the derivatives run without a tape
+ * and cost a small multiple of the kernel itself.
+ *
+ * The derivative code is generated by the Enzyme plugin while compiling the
+ * translation unit that calls these functions, which therefore has to be
+ * built with QUARISMA_ENABLE_ENZYME and link Quarisma::enzyme (the target
+ * defines QUARISMA_HAS_ENZYME); calling them elsewhere fails to compile. The
+ * body of the kernel must be in that translation unit, or reachable with LTO.
+ *
+ * The reverse pass gives the whole gradient in one sweep, whatever n. The
+ * forward pass gives a derivative along one direction; derivatives<Width>
+ * carries Width directions through a single vectorized pass, which for the
+ * handful of inputs of a closed-form pricer computes every first-order Greek
+ * in one or two passes.
+ */
+
+// Recognized by name by the Enzyme plugin, which replaces the calls
+// NOLINTBEGIN(bugprone-reserved-identifier,readability-identifier-naming)
+extern int enzyme_dup;
+extern int enzyme_dupv;
+extern int enzyme_const;
+extern int enzyme_width;
+
+template <typename Return, typename... Args>
+Return __enzyme_autodiff(void*, Args...);
+
+template <typename Return, typename... Args>
+Return __enzyme_fwddiff(void*, Args...);
+// NOLINTEND(bugprone-reserved-identifier,readability-identifier-naming)
+
+namespace quarisma
+{
+namespace ad
+{
+
+/** A kernel: the value at the inputs x, given the constant params. */
+template <typename P>
+using kernel = double (*)(const double* x, const P* params);
+
+namespace detail
+{
+#if QUARISMA_HAS_ENZYME
+template <typename P>
+inline constexpr bool enzyme_enabled = true;
+#else
+template <typename P>
+inline constexpr bool enzyme_enabled = false;
+#endif
+
+// Fails to compile in a translation unit not built with the Enzyme plugin
+template <typename P>
+constexpr void require_enzyme()
+{
+    static_assert(
+        enzyme_enabled<P>, "quarisma::ad needs QUARISMA_ENABLE_ENZYME and Quarisma::enzyme");
+}
+}  // namespace detail
+
+/**
+ * @brief The gradient of f at x in grad[0, n), by one reverse pass
+ */
+template <typename P>
+void gradient(kernel<P> f, const double* x, double* grad, std::size_t n, const P* params)
+{
+    detail::require_enzyme<P>();
+    // Enzyme accumulates into the shadow of x
+    std::fill(grad, grad + n, 0.0);
+    __enzyme_autodiff<void>(reinterpret_cast<void*>(f), enzyme_dup, x, grad, enzyme_const, params);
+}
+
+/**
+ * @brief The derivative of f at x along the direction dx[0, n), by one forward pass
+ */
+template <typename P>
+double derivative(kernel<P> f, const double* x, const double* dx, const P* params)
+{
+    detail::require_enzyme<P>();
+    return __enzyme_fwddiff<double>(
+        reinterpret_cast<void*>(f), enzyme_dup, x, dx, enzyme_const, params);
+}
+
+/**
+ * @brief The derivatives of f at x along Width directions, by one forward pass
+ *
+ * Direction k is dx[k * n, (k + 1) * n).
+ */
+template <std::size_t Width, typename P>
+std::array<double, Width> derivatives(
+    kernel<P> f, const double* x, const double* dx, std::size_t n, const P* params)
+{
+    static_assert(Width > 0, "derivatives needs at least one direction");
+    if constexpr (Width == 1)
+    {
+        return {derivative(f, x, dx, params)};
+    }
+    else
+    {
+        detail::require_enzyme<P>();
+        return __enzyme_fwddiff<std::array<double, Width>>(
+            reinterpret_cast<void*>(f),
+            enzyme_width,
+            static_cast<int>(Width),
+            enzyme_dupv,
+            n * sizeof(double),
+            x,
+            dx,
+            enzyme_const,
+            params);
+    }
+}
+
+/**
+ * @brief The gradient of f at x in grad[0, n), by forward passes of Width directions
+ *
+ * Takes ceil(n / Width) passes. Unlike gradient(), nothing is stored for a
+ * reverse sweep, which pays off for few inputs.
+ */
+template <std::size_t Width, typename P>
+void gradient_forward(kernel<P> f, const double* x, double* grad, std::size_t n, const P* params)
+{
+    std::vector<double> seeds(Width * n);
+    for (std::size_t first = 0; first < n; first += Width)
+    {
+        const std::size_t count = (std::min)(Width, n - first);
+        std::fill(seeds.begin(), seeds.end(), 0.0);
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            seeds[k * n + first + k] = 1.0;
+        }
+        const auto d = derivatives<Width>(f, x, seeds.data(), n, params);
+        std::copy(d.begin(), d.begin() + static_cast<std::ptrdiff_t>(count), grad + first);
+    }
+}
+
+}  // namespace ad
+}  // namespace quarisma
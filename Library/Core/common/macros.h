@@ -197,6 +197,32 @@ inline constexpr int QUARISMA_COMPILE_TIME_MAX_GPUS = 16;
 #endif
 #endif
 
+//----------------------------------------------------------------------------
+// C++20 coroutines: compiler support and the <coroutine> header
+#if !QUARISMA_HAS_COROUTINES
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && defined(__has_include)
+#if __has_include(<coroutine>)
+#define QUARISMA_HAS_COROUTINES 1
+#endif
+#endif
+#ifndef QUARISMA_HAS_COROUTINES
+#define QUARISMA_HAS_COROUTINES 0
+#endif
+#endif
+
+//----------------------------------------------------------------------------
+// C++17 polymorphic memory resources: the <memory_resource> header
+#if !QUARISMA_HAS_MEMORY_RESOURCE
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#define QUARISMA_HAS_MEMORY_RESOURCE 1
+#endif
+#endif
+#ifndef QUARISMA_HAS_MEMORY_RESOURCE
+#define QUARISMA_HAS_MEMORY_RESOURCE 0
+#endif
+#endif
+
 //----------------------------------------------------------------------------
 // A function level attribute to disable checking for use of uninitialized
 // memory when built with MemorySanitizer.
@@ -0,0 +1,295 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "common/macros.h"
+
+namespace quarisma
+{
+/**
+ * @brief Reference count of a ref_counted shared between threads.
+ *
+ * Taking a reference is a relaxed increment; dropping one is a release
+ * decrement, with an acquire fence only for the last reference.
+ */
+struct atomic_refcount
+{
+    using value_type = std::atomic<uint32_t>;
+
+    static void increment(value_type& count) noexcept
+    {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /** @brief Drops a reference; true when it was the last. */
+    static bool decrement(value_type& count) noexcept
+    {
+        if (count.fetch_sub(1, std::memory_order_release) != 1)
+        {
+            return false;
+        }
+        // Every other holder's use of the object happens before its destruction
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    static uint32_t load(const value_type& count) noexcept
+    {
+        return count.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Reference count of a ref_counted that never leaves its thread.
+ *
+ * Plain integer arithmetic: no locked instruction and no cache line
+ * claimed from another core. Sharing such an object between threads, even
+ * read-only, races on the count.
+ */
+struct local_refcount
+{
+    using value_type = uint32_t;
+
+    static void increment(value_type& count) noexcept { ++count; }
+
+    static bool decrement(value_type& count) noexcept { return --count == 0; }
+
+    static uint32_t load(const value_type& count) noexcept { return count; }
+};
+
+template <typename T>
+class ref_ptr;
+
+/**
+ * @brief Base of objects owned through ref_ptr: one counter, no weak references.
+ *
+ * intrusive_ptr_target keeps a 64-bit combined strong and weak count, a
+ * virtual destructor and a release_resources() hook for weak_intrusive_ptr.
+ * Objects that are never observed weakly need none of that: ref_counted
+ * stores a single 32-bit count whose threading `Policy` is chosen by the
+ * type, atomic_refcount or local_refcount, and deletes the object as its
+ * `Derived` type, so no destructor needs to be virtual unless classes
+ * below `Derived` are held through ref_ptr<Derived>.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * class graph_node : public ref_counted<graph_node, local_refcount>
+ * {
+ *     std::vector<ref_ptr<graph_node>> inputs_;
+ * };
+ *
+ * auto root = make_ref<graph_node>();
+ * ```
+ */
+template <typename Derived, typename Policy = atomic_refcount>
+class ref_counted
+{
+public:
+    using refcount_policy = Policy;
+
+    /** @brief Number of ref_ptr to this object, exact only for local_refcount. */
+    uint32_t use_count() const noexcept { return Policy::load(refcount_); }
+
+protected:
+    ref_counted() noexcept = default;
+
+    // A copy is a new object: it starts without references
+    ref_counted(const ref_counted& /*other*/) noexcept {}
+
+    ref_counted& operator=(const ref_counted& /*other*/) noexcept { return *this; }
+
+    ~ref_counted() = default;
+
+private:
+    template <typename T>
+    friend class ref_ptr;
+
+    void add_ref() const noexcept { Policy::increment(refcount_); }
+
+    void release_ref() const noexcept
+    {
+        if (Policy::decrement(refcount_))
+        {
+            delete static_cast<const Derived*>(this);
+        }
+    }
+
+    mutable typename Policy::value_type refcount_{0};
+};
+
+/**
+ * @brief Shared ownership of a ref_counted object.
+ *
+ * Same interface as intrusive_ptr, without weak references. The count
+ * lives in the object, so a ref_ptr can be made from any raw pointer to a
+ * live heap object already owned by another ref_ptr.
+ */
+template <typename T>
+class ref_ptr
+{
+public:
+    using element_type = T;
+
+    constexpr ref_ptr() noexcept = default;
+
+    constexpr ref_ptr(std::nullptr_t) noexcept {}
+
+    /** @brief Takes a reference to `target`, a heap object or nullptr. */
+    explicit ref_ptr(T* target) noexcept : target_(target) { retain(); }
+
+    ref_ptr(const ref_ptr& other) noexcept : target_(other.target_) { retain(); }
+
+    ref_ptr(ref_ptr&& other) noexcept : target_(std::exchange(other.target_, nullptr)) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    ref_ptr(const ref_ptr<U>& other) noexcept : target_(other.get())
+    {
+        retain();
+    }
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    ref_ptr(ref_ptr<U>&& other) noexcept : target_(other.release())
+    {
+    }
+
+    ~ref_ptr() { reset(); }
+
+    ref_ptr& operator=(const ref_ptr& other) noexcept
+    {
+        ref_ptr(other).swap(*this);
+        return *this;
+    }
+
+    ref_ptr& operator=(ref_ptr&& other) noexcept
+    {
+        ref_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ref_ptr& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    T* get() const noexcept { return target_; }
+    T& operator*() const noexcept { return *target_; }
+    T* operator->() const noexcept { return target_; }
+
+    explicit operator bool() const noexcept { return target_ != nullptr; }
+
+    uint32_t use_count() const noexcept { return target_ != nullptr ? target_->use_count() : 0; }
+    bool     unique() const noexcept { return use_count() == 1; }
+
+    void reset() noexcept
+    {
+        if (target_ != nullptr)
+        {
+            std::exchange(target_, nullptr)->release_ref();
+        }
+    }
+
+    /** @brief Gives up the reference without dropping it; adopt() takes it back. */
+    T* release() noexcept { return std::exchange(target_, nullptr); }
+
+    /** @brief Takes over a reference given up by release(). */
+    static ref_ptr adopt(T* target) noexcept
+    {
+        ref_ptr result;
+        result.target_ = target;
+        return result;
+    }
+
+    void swap(ref_ptr& other) noexcept { std::swap(target_, other.target_); }
+
+private:
+    void retain() const noexcept
+    {
+        if (target_ != nullptr)
+        {
+            target_->add_ref();
+        }
+    }
+
+    T* target_ = nullptr;
+};
+
+template <typename T, typename... Args>
+ref_ptr<T> make_ref(Args&&... args)
+{
+    return ref_ptr<T>(new T(std::forward<Args>(args)...));
+}
+
+template <typename T>
+void swap(ref_ptr<T>& lhs, ref_ptr<T>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+template <typename T, typename U>
+bool operator==(const ref_ptr<T>& lhs, const ref_ptr<U>& rhs) noexcept
+{
+    return lhs.get() == rhs.get();
+}
+
+template <typename T, typename U>
+bool operator!=(const ref_ptr<T>& lhs, const ref_ptr<U>& rhs) noexcept
+{
+    return lhs.get() != rhs.get();
+}
+
+template <typename T, typename U>
+bool operator<(const ref_ptr<T>& lhs, const ref_ptr<U>& rhs) noexcept
+{
+    return lhs.get() < rhs.get();
+}
+
+template <typename T>
+bool operator==(const ref_ptr<T>& lhs, std::nullptr_t) noexcept
+{
+    return lhs.get() == nullptr;
+}
+
+template <typename T>
+bool operator!=(const ref_ptr<T>& lhs, std::nullptr_t) noexcept
+{
+    return lhs.get() != nullptr;
+}
+
+}  // namespace quarisma
+
+namespace std
+{
+template <typename T>
+struct hash<quarisma::ref_ptr<T>>
+{
+    size_t operator()(const quarisma::ref_ptr<T>& x) const noexcept
+    {
+        return std::hash<T*>()(x.get());
+    }
+};
+}  // namespace std
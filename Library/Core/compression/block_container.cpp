@@ -0,0 +1,287 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "compression/block_container.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "parallel/parallel_tools.h"
+#include "util/hash.h"
+
+namespace quarisma
+{
+namespace compression
+{
+
+namespace
+{
+constexpr char    magic[4]    = {'Q', 'Z', 'B', 'K'};
+constexpr uint8_t version     = 1;
+constexpr size_t  header_size = 24;
+constexpr size_t  entry_size  = 16;  // Offset (u64), compressed size (u32), CRC-32C (u32)
+
+void store_le(char* out, uint64_t value, int bytes) noexcept
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint64_t load_le(const char* in, int bytes) noexcept
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+struct block_entry
+{
+    uint64_t offset;
+    uint32_t size;
+    uint32_t crc;
+};
+
+block_entry load_entry(const char* index, size_t block) noexcept
+{
+    const char* const p = index + block * entry_size;
+    return {load_le(p, 8), static_cast<uint32_t>(load_le(p + 8, 4)),
+            static_cast<uint32_t>(load_le(p + 12, 4))};
+}
+}  // namespace
+
+bool block_container::compress(
+    const char*  input,
+    size_t       length,
+    std::string* output,
+    const codec& block_codec,
+    size_t       block_size)
+{
+    if (block_size < min_block_size || block_size > max_block_size ||
+        block_codec.max_compressed_length(block_size) > UINT32_MAX)
+    {
+        return false;
+    }
+
+    size_t const             block_count = (length + block_size - 1) / block_size;
+    std::vector<std::string> blocks(block_count);
+    std::atomic<bool>        failed{false};
+
+    parallel_tools::parallel_for(
+        0,
+        block_count,
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t b = begin; b < end && !failed.load(std::memory_order_relaxed); ++b)
+            {
+                size_t const first = b * block_size;
+                size_t const size  = std::min(block_size, length - first);
+                if (!block_codec.compress(input + first, size, &blocks[b]))
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    if (failed.load())
+    {
+        return false;
+    }
+
+    // Lay out the blocks after the index, then copy them in parallel too
+    size_t const        index_size = block_count * entry_size;
+    std::vector<size_t> offsets(block_count);
+    size_t              total = header_size + index_size;
+    for (size_t b = 0; b < block_count; ++b)
+    {
+        offsets[b] = total;
+        total += blocks[b].size();
+    }
+
+    output->resize(total);
+    char* const out = output->data();
+    parallel_tools::parallel_for(
+        0,
+        block_count,
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t b = begin; b < end; ++b)
+            {
+                std::string const& block = blocks[b];
+                char* const        entry = out + header_size + b * entry_size;
+                std::memcpy(out + offsets[b], block.data(), block.size());
+                store_le(entry, offsets[b], 8);
+                store_le(entry + 8, block.size(), 4);
+                store_le(entry + 12, crc32c(block.data(), block.size()), 4);
+            }
+        });
+
+    std::memcpy(out, magic, sizeof(magic));
+    out[4] = static_cast<char>(version);
+    out[5] = static_cast<char>(block_codec.type());
+    store_le(out + 6, 0, 2);
+    store_le(out + 8, block_size, 4);
+    store_le(out + 12, crc32c(out + header_size, index_size), 4);
+    store_le(out + 16, length, 8);
+    return true;
+}
+
+std::optional<block_container> block_container::open(const char* data, size_t length)
+{
+    if (length < header_size || std::memcmp(data, magic, sizeof(magic)) != 0 ||
+        static_cast<uint8_t>(data[4]) != version)
+    {
+        return std::nullopt;
+    }
+
+    block_container container;
+    container.data_              = data;
+    container.codec_             = codec::get(static_cast<codec_type>(data[5]));
+    container.block_size_        = static_cast<size_t>(load_le(data + 8, 4));
+    container.uncompressed_size_ = load_le(data + 16, 8);
+    if (container.codec_ == nullptr || container.block_size_ < min_block_size ||
+        container.block_size_ > max_block_size)
+    {
+        return std::nullopt;
+    }
+
+    // The index must fit in the container, then its entries within the data
+    uint64_t const block_count =
+        container.uncompressed_size_ / container.block_size_ +
+        (container.uncompressed_size_ % container.block_size_ != 0 ? 1 : 0);
+    if (block_count > (length - header_size) / entry_size)
+    {
+        return std::nullopt;
+    }
+    container.block_count_ = static_cast<size_t>(block_count);
+
+    const char* const index      = data + header_size;
+    size_t const      index_size = container.block_count_ * entry_size;
+    if (crc32c(index, index_size) != static_cast<uint32_t>(load_le(data + 12, 4)))
+    {
+        return std::nullopt;
+    }
+    for (size_t b = 0; b < container.block_count_; ++b)
+    {
+        block_entry const entry = load_entry(index, b);
+        if (entry.offset < header_size + index_size || entry.offset > length ||
+            entry.size > length - entry.offset)
+        {
+            return std::nullopt;
+        }
+    }
+    return container;
+}
+
+size_t block_container::uncompressed_block_size(size_t index) const noexcept
+{
+    uint64_t const first = static_cast<uint64_t>(index) * block_size_;
+    return static_cast<size_t>(std::min<uint64_t>(block_size_, uncompressed_size_ - first));
+}
+
+bool block_container::uncompress_block_into(size_t index, char* output) const
+{
+    block_entry const entry = load_entry(data_ + header_size, index);
+    const char* const block = data_ + entry.offset;
+    return crc32c(block, entry.size) == entry.crc &&
+           codec_->uncompress_into(block, entry.size, output, uncompressed_block_size(index));
+}
+
+bool block_container::uncompress_block(size_t index, std::string* output) const
+{
+    if (index >= block_count_)
+    {
+        return false;
+    }
+    output->resize(uncompressed_block_size(index));
+    return uncompress_block_into(index, output->data());
+}
+
+bool block_container::uncompress(std::string* output, size_t max_length) const
+{
+    if (uncompressed_size_ > max_length)
+    {
+        return false;
+    }
+    output->resize(static_cast<size_t>(uncompressed_size_));
+    return read(0, output->size(), output->data());
+}
+
+bool block_container::read(uint64_t offset, size_t length, char* output) const
+{
+    if (offset > uncompressed_size_ || length > uncompressed_size_ - offset)
+    {
+        return false;
+    }
+    if (length == 0)
+    {
+        return true;
+    }
+
+    size_t const      first_block = static_cast<size_t>(offset / block_size_);
+    size_t const      last_block  = static_cast<size_t>((offset + length - 1) / block_size_);
+    std::atomic<bool> failed{false};
+
+    parallel_tools::parallel_for(
+        first_block,
+        last_block + 1,
+        1,
+        [&](size_t begin, size_t end)
+        {
+            std::string partial;
+            for (size_t b = begin; b < end && !failed.load(std::memory_order_relaxed); ++b)
+            {
+                uint64_t const block_first = static_cast<uint64_t>(b) * block_size_;
+                uint64_t const block_last  = block_first + uncompressed_block_size(b);
+                uint64_t const copy_first  = std::max(block_first, offset);
+                uint64_t const copy_last   = std::min(block_last, offset + length);
+                char* const    target      = output + (copy_first - offset);
+
+                // Whole blocks go straight to the output, partial ones through a copy
+                bool ok = false;
+                if (copy_first == block_first && copy_last == block_last)
+                {
+                    ok = uncompress_block_into(b, target);
+                }
+                else if (uncompress_block(b, &partial))
+                {
+                    std::memcpy(
+                        target,
+                        partial.data() + (copy_first - block_first),
+                        static_cast<size_t>(copy_last - copy_first));
+                    ok = true;
+                }
+                if (!ok)
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    return !failed.load();
+}
+
+}  // namespace compression
+}  // namespace quarisma
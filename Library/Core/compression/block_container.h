@@ -0,0 +1,133 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "common/export.h"
+#include "compression/codec.h"
+
+namespace quarisma
+{
+namespace compression
+{
+
+/**
+ * @brief Seekable container of independently compressed blocks
+ *
+ * compress() splits a buffer into fixed-size blocks and compresses them in
+ * parallel on parallel_tools, so large buffers (snapshots, serialized
+ * tensors) compress at roughly the core count times the codec speed. The
+ * container starts with a block index, which makes decompression parallel
+ * too, and lets read() decompress only the blocks covering a byte range.
+ *
+ * Layout, little-endian:
+ * - header (24 bytes): magic "QZBK", version, codec_type, 2 reserved bytes,
+ *   block size (u32), CRC-32C of the index (u32), uncompressed size (u64);
+ * - index: per block, its offset in the container (u64), compressed size
+ *   (u32) and CRC-32C of the compressed bytes (u32);
+ * - the compressed blocks, in order.
+ *
+ * A block_container is a view: the bytes passed to open() must outlive it.
+ * Every operation returns false rather than throw on corrupt input, and the
+ * codec named by the header must be built in.
+ *
+ * @code
+ * std::string packed;
+ * block_container::compress(data, size, &packed, codec::select(codec_preference::speed));
+ *
+ * auto container = block_container::open(packed.data(), packed.size());
+ * std::string restored;
+ * if (!container || !container->uncompress(&restored)) { ... }
+ * @endcode
+ */
+class QUARISMA_VISIBILITY block_container
+{
+public:
+    static constexpr size_t default_block_size = size_t{1} << 20;
+    static constexpr size_t min_block_size     = size_t{4} << 10;
+    static constexpr size_t max_block_size     = size_t{1} << 30;
+
+    /**
+     * @brief Compresses input into a new container, in parallel
+     * @param block_size Uncompressed bytes per block, in
+     *        [min_block_size, max_block_size]; larger blocks compress
+     *        better, smaller ones make read() cheaper
+     * @return false if the codec fails or block_size is out of range
+     */
+    static QUARISMA_API bool compress(
+        const char*  input,
+        size_t       length,
+        std::string* output,
+        const codec& block_codec,
+        size_t       block_size = default_block_size);
+
+    /**
+     * @brief Opens a container, validating its header and index
+     * @return The container, or nullopt if it is corrupt or its codec is not
+     *         built in
+     */
+    static QUARISMA_API std::optional<block_container> open(const char* data, size_t length);
+
+    uint64_t uncompressed_size() const noexcept { return uncompressed_size_; }
+
+    size_t block_size() const noexcept { return block_size_; }
+
+    size_t block_count() const noexcept { return block_count_; }
+
+    const codec& block_codec() const noexcept { return *codec_; }
+
+    /**
+     * @brief Decompresses the whole container, in parallel
+     * @param max_length Fails, before allocating, if the data is larger
+     */
+    QUARISMA_API bool uncompress(std::string* output, size_t max_length = ~size_t{0}) const;
+
+    /**
+     * @brief Decompresses length bytes from offset into output
+     *
+     * Only the blocks overlapping the range are decompressed, in parallel.
+     * @return false if the range is out of bounds or a block is corrupt
+     */
+    QUARISMA_API bool read(uint64_t offset, size_t length, char* output) const;
+
+    /**
+     * @brief Decompresses one block; all blocks but the last hold block_size() bytes
+     */
+    QUARISMA_API bool uncompress_block(size_t index, std::string* output) const;
+
+private:
+    block_container() = default;
+
+    size_t uncompressed_block_size(size_t index) const noexcept;
+    bool   uncompress_block_into(size_t index, char* output) const;
+
+    const char*  data_              = nullptr;
+    const codec* codec_             = nullptr;
+    uint64_t     uncompressed_size_ = 0;
+    size_t       block_size_        = 0;
+    size_t       block_count_       = 0;
+};
+
+}  // namespace compression
+}  // namespace quarisma
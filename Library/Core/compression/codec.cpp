@@ -0,0 +1,333 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "compression/codec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "common/configure.h"
+
+#if QUARISMA_HAS_COMPRESSION && defined(QUARISMA_COMPRESSION_TYPE_SNAPPY)
+#include "compression/snappy.h"
+#endif
+
+#if QUARISMA_HAS_LZ4
+#include <lz4.h>
+#endif
+
+#if QUARISMA_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace quarisma
+{
+namespace compression
+{
+
+namespace
+{
+class none_codec final : public codec
+{
+public:
+    codec_type type() const noexcept override { return codec_type::none; }
+
+    const char* name() const noexcept override { return "none"; }
+
+    size_t max_compressed_length(size_t length) const noexcept override { return length; }
+
+    bool compress(const char* input, size_t length, std::string* output) const override
+    {
+        output->assign(input, length);
+        return true;
+    }
+
+    bool uncompress(
+        const char* input, size_t length, std::string* output, size_t max_length) const override
+    {
+        if (length > max_length)
+        {
+            return false;
+        }
+        output->assign(input, length);
+        return true;
+    }
+
+    bool uncompress_into(
+        const char* input, size_t length, char* output, size_t output_length) const override
+    {
+        if (length != output_length)
+        {
+            return false;
+        }
+        if (length != 0)
+        {
+            std::memcpy(output, input, length);
+        }
+        return true;
+    }
+};
+
+#if QUARISMA_HAS_COMPRESSION && defined(QUARISMA_COMPRESSION_TYPE_SNAPPY)
+class snappy_codec final : public codec
+{
+public:
+    codec_type type() const noexcept override { return codec_type::snappy; }
+
+    const char* name() const noexcept override { return "snappy"; }
+
+    size_t max_compressed_length(size_t length) const noexcept override
+    {
+        return 32 + length + length / 6;  // snappy::MaxCompressedLength
+    }
+
+    bool compress(const char* input, size_t length, std::string* output) const override
+    {
+        return snappy::compress(input, length, output);
+    }
+
+    bool uncompress(
+        const char* input, size_t length, std::string* output, size_t max_length) const override
+    {
+        size_t size = 0;
+        if (!snappy::get_uncompressed_length(input, length, &size) || size > max_length)
+        {
+            return false;
+        }
+        output->resize(size);
+        return snappy::uncompress(input, length, output->data());
+    }
+
+    bool uncompress_into(
+        const char* input, size_t length, char* output, size_t output_length) const override
+    {
+        size_t size = 0;
+        return snappy::get_uncompressed_length(input, length, &size) && size == output_length &&
+               snappy::uncompress(input, length, output);
+    }
+};
+#endif
+
+#if QUARISMA_HAS_LZ4 || QUARISMA_HAS_ZSTD
+// Little-endian base-128, as Snappy prefixes its blocks
+void append_varint(std::string* output, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        output->push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    output->push_back(static_cast<char>(value));
+}
+
+bool read_varint(const char*& input, size_t& length, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && length != 0; shift += 7)
+    {
+        auto const byte = static_cast<unsigned char>(*input++);
+        --length;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+#if QUARISMA_HAS_LZ4
+class lz4_codec final : public codec
+{
+public:
+    codec_type type() const noexcept override { return codec_type::lz4; }
+
+    const char* name() const noexcept override { return "lz4"; }
+
+    size_t max_compressed_length(size_t length) const noexcept override
+    {
+        return 10 + length + length / 255 + 16;  // Varint and LZ4_COMPRESSBOUND
+    }
+
+    bool compress(const char* input, size_t length, std::string* output) const override
+    {
+        if (length > static_cast<size_t>(LZ4_MAX_INPUT_SIZE))
+        {
+            return false;
+        }
+        output->clear();
+        append_varint(output, length);
+        size_t const header = output->size();
+        int const    bound  = LZ4_compressBound(static_cast<int>(length));
+        output->resize(header + static_cast<size_t>(bound));
+        int const written = LZ4_compress_default(
+            input, output->data() + header, static_cast<int>(length), bound);
+        if (written <= 0 && length != 0)
+        {
+            return false;
+        }
+        output->resize(header + static_cast<size_t>(written));
+        return true;
+    }
+
+    bool uncompress(
+        const char* input, size_t length, std::string* output, size_t max_length) const override
+    {
+        const char* data      = input;
+        size_t      remaining = length;
+        uint64_t    size      = 0;
+        if (!read_varint(data, remaining, size) || size > max_length ||
+            size > static_cast<uint64_t>(LZ4_MAX_INPUT_SIZE))
+        {
+            return false;
+        }
+        output->resize(static_cast<size_t>(size));
+        return uncompress_into(input, length, output->data(), output->size());
+    }
+
+    bool uncompress_into(
+        const char* input, size_t length, char* output, size_t output_length) const override
+    {
+        uint64_t size = 0;
+        if (!read_varint(input, length, size) || size != output_length ||
+            size > static_cast<uint64_t>(LZ4_MAX_INPUT_SIZE) ||
+            length > static_cast<size_t>(std::numeric_limits<int>::max()))
+        {
+            return false;
+        }
+        int const read = LZ4_decompress_safe(
+            input, output, static_cast<int>(length), static_cast<int>(size));
+        return read >= 0 && static_cast<uint64_t>(read) == size;
+    }
+};
+#endif
+
+#if QUARISMA_HAS_ZSTD
+class zstd_codec final : public codec
+{
+public:
+    static constexpr int level = 3;
+
+    codec_type type() const noexcept override { return codec_type::zstd; }
+
+    const char* name() const noexcept override { return "zstd"; }
+
+    size_t max_compressed_length(size_t length) const noexcept override
+    {
+        return ZSTD_compressBound(length);
+    }
+
+    bool compress(const char* input, size_t length, std::string* output) const override
+    {
+        output->resize(ZSTD_compressBound(length));
+        size_t const written =
+            ZSTD_compress(output->data(), output->size(), input, length, level);
+        if (ZSTD_isError(written) != 0)
+        {
+            return false;
+        }
+        output->resize(written);
+        return true;
+    }
+
+    bool uncompress(
+        const char* input, size_t length, std::string* output, size_t max_length) const override
+    {
+        unsigned long long const size = ZSTD_getFrameContentSize(input, length);
+        if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN ||
+            size > max_length)
+        {
+            return false;
+        }
+        output->resize(static_cast<size_t>(size));
+        return uncompress_into(input, length, output->data(), output->size());
+    }
+
+    bool uncompress_into(
+        const char* input, size_t length, char* output, size_t output_length) const override
+    {
+        if (ZSTD_getFrameContentSize(input, length) != output_length)
+        {
+            return false;
+        }
+        size_t const read = ZSTD_decompress(output, output_length, input, length);
+        return ZSTD_isError(read) == 0 && read == output_length;
+    }
+};
+#endif
+}  // namespace
+
+const codec* codec::get(codec_type type) noexcept
+{
+    switch (type)
+    {
+    case codec_type::none:
+    {
+        static const none_codec instance;
+        return &instance;
+    }
+#if QUARISMA_HAS_COMPRESSION && defined(QUARISMA_COMPRESSION_TYPE_SNAPPY)
+    case codec_type::snappy:
+    {
+        static const snappy_codec instance;
+        return &instance;
+    }
+#endif
+#if QUARISMA_HAS_LZ4
+    case codec_type::lz4:
+    {
+        static const lz4_codec instance;
+        return &instance;
+    }
+#endif
+#if QUARISMA_HAS_ZSTD
+    case codec_type::zstd:
+    {
+        static const zstd_codec instance;
+        return &instance;
+    }
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const codec& codec::select(codec_preference preference) noexcept
+{
+    static constexpr codec_type by_speed[] = {
+        codec_type::lz4, codec_type::snappy, codec_type::zstd, codec_type::none};
+    static constexpr codec_type by_ratio[] = {
+        codec_type::zstd, codec_type::lz4, codec_type::snappy, codec_type::none};
+
+    for (codec_type const type : preference == codec_preference::speed ? by_speed : by_ratio)
+    {
+        if (const codec* const c = get(type))
+        {
+            return *c;
+        }
+    }
+    return *get(codec_type::none);
+}
+
+}  // namespace compression
+}  // namespace quarisma
@@ -0,0 +1,128 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "common/export.h"
+#include "common/macros.h"
+
+namespace quarisma
+{
+namespace compression
+{
+
+/**
+ * @brief Compression algorithms behind the codec interface
+ *
+ * The values are stored in block containers (see block_container.h).
+ */
+enum class codec_type
+{
+    none,    ///< Stored as is; always available
+    snappy,  ///< QUARISMA_COMPRESSION_TYPE=snappy
+    lz4,     ///< QUARISMA_ENABLE_LZ4
+    zstd     ///< QUARISMA_ENABLE_ZSTD
+};
+
+/**
+ * @brief What codec::select() optimizes for
+ */
+enum class codec_preference
+{
+    speed,  ///< Fastest compression and decompression: lz4, snappy, zstd
+    ratio   ///< Smallest output: zstd, lz4, snappy
+};
+
+/**
+ * @brief Whole-buffer compressor, one per algorithm built in
+ *
+ * Codecs are stateless singletons obtained from get() or select(), and are
+ * safe to use from any thread. The compressed formats are:
+ * - snappy: raw Snappy;
+ * - lz4: varint uncompressed length, then an LZ4 block;
+ * - zstd: a Zstandard frame with its content size (level 3);
+ * - none: the input.
+ *
+ * Every call returns false rather than throw on failure, including on
+ * corrupt input, which is never read past its length.
+ *
+ * For data that does not fit in memory, see framed_stream.h.
+ */
+class QUARISMA_VISIBILITY codec
+{
+public:
+    virtual ~codec() = default;
+
+    virtual codec_type type() const noexcept = 0;
+
+    virtual const char* name() const noexcept = 0;
+
+    /**
+     * @brief Upper bound of the compressed size of length bytes
+     */
+    virtual size_t max_compressed_length(size_t length) const noexcept = 0;
+
+    /**
+     * @brief Replaces *output with the compression of input
+     */
+    virtual bool compress(const char* input, size_t length, std::string* output) const = 0;
+
+    /**
+     * @brief Replaces *output with the decompression of input
+     * @param max_length Fails, before allocating, when the data claims to
+     *        decompress to more
+     */
+    virtual bool uncompress(
+        const char* input, size_t length, std::string* output, size_t max_length) const = 0;
+
+    bool uncompress(const char* input, size_t length, std::string* output) const
+    {
+        return uncompress(input, length, output, ~size_t{0});
+    }
+
+    /**
+     * @brief Decompresses input into a caller-provided buffer
+     * @return false unless input decompresses to exactly output_length bytes
+     */
+    virtual bool uncompress_into(
+        const char* input, size_t length, char* output, size_t output_length) const = 0;
+
+    /**
+     * @brief Codec of the given type, or nullptr if it is not built in
+     */
+    static QUARISMA_API const codec* get(codec_type type) noexcept;
+
+    /**
+     * @brief Best built-in codec for the preference; none if no other is built in
+     */
+    static QUARISMA_API const codec& select(codec_preference preference) noexcept;
+
+    static bool available(codec_type type) noexcept { return get(type) != nullptr; }
+
+protected:
+    codec() = default;
+
+    QUARISMA_DELETE_COPY_AND_MOVE(codec);
+};
+
+}  // namespace compression
+}  // namespace quarisma
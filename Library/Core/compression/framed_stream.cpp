@@ -0,0 +1,329 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "compression/framed_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "compression/codec.h"
+#include "util/exception.h"
+#include "util/hash.h"
+
+namespace quarisma
+{
+namespace compression
+{
+
+namespace
+{
+// Chunk types of https://github.com/google/snappy/blob/main/framing_format.txt
+constexpr unsigned compressed_chunk     = 0x00;
+constexpr unsigned uncompressed_chunk   = 0x01;
+constexpr unsigned first_reserved_chunk = 0x80;  // 0x80-0xfd skippable, 0xfe padding
+constexpr unsigned stream_identifier    = 0xff;
+
+constexpr char   stream_header[] = "\xff\x06\x00\x00sNaPpY";
+constexpr size_t header_size     = 4;  // Type, then 24-bit little-endian length
+constexpr size_t checksum_size   = 4;
+
+// Snappy's MaxCompressedLength of a full chunk
+constexpr size_t max_compressed_chunk_size =
+    32 + framed_compressor::max_chunk_size + framed_compressor::max_chunk_size / 6;
+
+uint32_t masked_crc32c(const char* data, size_t size) noexcept
+{
+    uint32_t const crc = crc32c(data, size);
+    return ((crc >> 15) | (crc << 17)) + 0xa282ead8U;
+}
+
+void store_le32(char* out, uint32_t value) noexcept
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint32_t load_le(const char* in, int bytes) noexcept
+{
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+    {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+}  // namespace
+
+//=============================================================================
+// framed_compressor
+//=============================================================================
+
+framed_compressor::framed_compressor(framed_sink sink) : sink_(std::move(sink))
+{
+    QUARISMA_CHECK(static_cast<bool>(sink_), "framed_compressor needs a sink");
+    pending_.reserve(max_chunk_size);
+}
+
+void framed_compressor::write(const char* data, size_t size)
+{
+    if (!header_emitted_)
+    {
+        emit(stream_header, sizeof(stream_header) - 1);
+        header_emitted_ = true;
+    }
+    bytes_in_ += size;
+
+    while (size != 0)
+    {
+        // Full chunks straight from the input, without copying them to pending_
+        if (pending_.empty() && size >= max_chunk_size)
+        {
+            emit_chunk(data, max_chunk_size);
+            data += max_chunk_size;
+            size -= max_chunk_size;
+            continue;
+        }
+
+        size_t const take = std::min(max_chunk_size - pending_.size(), size);
+        pending_.append(data, take);
+        data += take;
+        size -= take;
+        if (pending_.size() == max_chunk_size)
+        {
+            emit_chunk(pending_.data(), pending_.size());
+            pending_.clear();
+        }
+    }
+}
+
+void framed_compressor::flush()
+{
+    if (!header_emitted_)
+    {
+        emit(stream_header, sizeof(stream_header) - 1);
+        header_emitted_ = true;
+    }
+    if (!pending_.empty())
+    {
+        emit_chunk(pending_.data(), pending_.size());
+        pending_.clear();
+    }
+}
+
+void framed_compressor::emit(const char* data, size_t size)
+{
+    sink_(data, size);
+    bytes_out_ += size;
+}
+
+void framed_compressor::emit_chunk(const char* data, size_t size)
+{
+    static const codec* const snappy = codec::get(codec_type::snappy);
+
+    unsigned    type      = uncompressed_chunk;
+    const char* body      = data;
+    size_t      body_size = size;
+    if (snappy != nullptr && snappy->compress(data, size, &scratch_) &&
+        scratch_.size() < size - size / 8)
+    {
+        type      = compressed_chunk;
+        body      = scratch_.data();
+        body_size = scratch_.size();
+    }
+
+    char         header[header_size + checksum_size];
+    size_t const length = body_size + checksum_size;
+    store_le32(header, static_cast<uint32_t>(length << 8) | type);
+    store_le32(header + header_size, masked_crc32c(data, size));
+    emit(header, sizeof(header));
+    emit(body, body_size);
+}
+
+//=============================================================================
+// framed_decompressor
+//=============================================================================
+
+framed_decompressor::framed_decompressor(framed_sink sink) : sink_(std::move(sink))
+{
+    QUARISMA_CHECK(static_cast<bool>(sink_), "framed_decompressor needs a sink");
+}
+
+bool framed_decompressor::write(const char* data, size_t size)
+{
+    if (failed_)
+    {
+        return false;
+    }
+
+    while (size != 0)
+    {
+        if (skip_ != 0)
+        {
+            size_t const n = std::min(skip_, size);
+            data += n;
+            size -= n;
+            skip_ -= n;
+            continue;
+        }
+
+        // Whole chunks straight from the input
+        if (buffer_.empty() && size >= header_size)
+        {
+            unsigned const type   = static_cast<unsigned char>(data[0]);
+            size_t const   length = load_le(data + 1, 3);
+            if (!check_header(type, length))
+            {
+                return false;
+            }
+            if (type >= first_reserved_chunk && type != stream_identifier)
+            {
+                skip_ = length;
+                data += header_size;
+                size -= header_size;
+                continue;
+            }
+            if (size >= header_size + length)
+            {
+                if (!process_chunk(type, data + header_size, length))
+                {
+                    return false;
+                }
+                data += header_size + length;
+                size -= header_size + length;
+                continue;
+            }
+        }
+
+        // A chunk split across calls: complete its header, then its body
+        if (buffer_.size() < header_size)
+        {
+            size_t const take = std::min(header_size - buffer_.size(), size);
+            buffer_.append(data, take);
+            data += take;
+            size -= take;
+            if (buffer_.size() < header_size)
+            {
+                break;
+            }
+
+            unsigned const type   = static_cast<unsigned char>(buffer_[0]);
+            size_t const   length = load_le(buffer_.data() + 1, 3);
+            if (!check_header(type, length))
+            {
+                return false;
+            }
+            if (type >= first_reserved_chunk && type != stream_identifier)
+            {
+                skip_ = length;
+                buffer_.clear();
+                continue;
+            }
+        }
+
+        unsigned const type   = static_cast<unsigned char>(buffer_[0]);
+        size_t const   length = load_le(buffer_.data() + 1, 3);
+        size_t const   take   = std::min(header_size + length - buffer_.size(), size);
+        buffer_.append(data, take);
+        data += take;
+        size -= take;
+        if (buffer_.size() == header_size + length)
+        {
+            if (!process_chunk(type, buffer_.data() + header_size, length))
+            {
+                return false;
+            }
+            buffer_.clear();
+        }
+    }
+    return true;
+}
+
+bool framed_decompressor::finish()
+{
+    if (!failed_ && (!header_seen_ || !buffer_.empty() || skip_ != 0))
+    {
+        failed_ = true;
+    }
+    return !failed_;
+}
+
+bool framed_decompressor::check_header(unsigned type, size_t length)
+{
+    bool valid = false;
+    if (!header_seen_ || type == stream_identifier)
+    {
+        valid = type == stream_identifier && length == sizeof(stream_header) - 1 - header_size;
+    }
+    else if (type == compressed_chunk)
+    {
+        valid = length >= checksum_size && length <= checksum_size + max_compressed_chunk_size;
+    }
+    else if (type == uncompressed_chunk)
+    {
+        valid = length >= checksum_size &&
+                length <= checksum_size + framed_compressor::max_chunk_size;
+    }
+    else
+    {
+        valid = type >= first_reserved_chunk;  // 0x02-0x7f are reserved unskippable
+    }
+
+    failed_ = !valid;
+    return valid;
+}
+
+bool framed_decompressor::process_chunk(unsigned type, const char* body, size_t length)
+{
+    if (type == stream_identifier)
+    {
+        header_seen_ = std::memcmp(body, stream_header + header_size, length) == 0;
+        failed_      = !header_seen_;
+        return header_seen_;
+    }
+
+    uint32_t const checksum = load_le(body, 4);
+    const char*    data     = body + checksum_size;
+    size_t         size     = length - checksum_size;
+    if (type == compressed_chunk)
+    {
+        static const codec* const snappy = codec::get(codec_type::snappy);
+        if (snappy == nullptr ||
+            !snappy->uncompress(data, size, &scratch_, framed_compressor::max_chunk_size))
+        {
+            failed_ = true;
+            return false;
+        }
+        data = scratch_.data();
+        size = scratch_.size();
+    }
+
+    if (masked_crc32c(data, size) != checksum)
+    {
+        failed_ = true;
+        return false;
+    }
+    sink_(data, size);
+    return true;
+}
+
+}  // namespace compression
+}  // namespace quarisma
@@ -0,0 +1,159 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "common/export.h"
+#include "common/macros.h"
+
+namespace quarisma
+{
+namespace compression
+{
+
+/**
+ * @brief Receives the bytes produced by a framed stream, in order
+ */
+using framed_sink = std::function<void(const char* data, size_t size)>;
+
+/**
+ * @brief Streaming compressor writing the Snappy framing format
+ *
+ * Input of any length is cut into chunks of at most 64 KiB, each compressed
+ * on its own and protected by a masked CRC-32C of its uncompressed bytes, so
+ * memory use stays bounded whatever the stream length. The output can be read
+ * by framed_decompressor and by any other implementation of the format
+ * (e.g. python-snappy, snzip), and can be concatenated with other streams.
+ *
+ * Chunks that Snappy does not shrink by at least 1/8, and every chunk when
+ * Snappy is not built in, are stored uncompressed.
+ *
+ * @code
+ * framed_compressor compressor([&](const char* data, size_t size) { file.write(data, size); });
+ * for (const auto& record : records)
+ *     compressor.write(record.data(), record.size());
+ * compressor.flush();
+ * @endcode
+ */
+class QUARISMA_VISIBILITY framed_compressor
+{
+public:
+    /// Largest uncompressed chunk allowed by the format
+    static constexpr size_t max_chunk_size = 65536;
+
+    /**
+     * @brief Starts a stream; the stream identifier is emitted on the first
+     * write() or flush()
+     */
+    QUARISMA_API explicit framed_compressor(framed_sink sink);
+
+    /**
+     * @brief Appends data to the stream; full chunks are emitted immediately
+     */
+    QUARISMA_API void write(const char* data, size_t size);
+
+    /**
+     * @brief Emits the pending partial chunk, if any
+     *
+     * The output is then a complete stream that ends on a chunk boundary;
+     * data still pending when the compressor is destroyed is dropped.
+     */
+    QUARISMA_API void flush();
+
+    /**
+     * @brief Number of bytes written to the stream so far
+     */
+    uint64_t bytes_in() const noexcept { return bytes_in_; }
+
+    /**
+     * @brief Number of bytes emitted to the sink so far
+     */
+    uint64_t bytes_out() const noexcept { return bytes_out_; }
+
+    QUARISMA_DELETE_COPY_AND_MOVE(framed_compressor);
+
+private:
+    void emit(const char* data, size_t size);
+    void emit_chunk(const char* data, size_t size);
+
+    framed_sink sink_;
+    std::string pending_;
+    std::string scratch_;
+    uint64_t    bytes_in_       = 0;
+    uint64_t    bytes_out_      = 0;
+    bool        header_emitted_ = false;
+};
+
+/**
+ * @brief Streaming decompressor reading the Snappy framing format
+ *
+ * Accepts the stream in pieces of any size and forwards the uncompressed
+ * bytes to the sink chunk by chunk; at most one chunk is buffered. Every
+ * chunk is checked against its CRC. Padding and skippable chunks are
+ * ignored without being buffered, and concatenated streams are accepted.
+ *
+ * Once a call fails the stream is corrupt (or uses compressed chunks while
+ * Snappy is not built in) and every following call fails too.
+ */
+class QUARISMA_VISIBILITY framed_decompressor
+{
+public:
+    /**
+     * @brief Starts a stream; the uncompressed data is passed to sink
+     */
+    QUARISMA_API explicit framed_decompressor(framed_sink sink);
+
+    /**
+     * @brief Consumes the next part of the stream
+     * @return false if the stream is corrupt
+     */
+    QUARISMA_API bool write(const char* data, size_t size);
+
+    /**
+     * @brief Checks that the stream ended on a chunk boundary
+     * @return false if the stream is corrupt, truncated or empty
+     */
+    QUARISMA_API bool finish();
+
+    /**
+     * @brief Whether a call has failed
+     */
+    bool failed() const noexcept { return failed_; }
+
+    QUARISMA_DELETE_COPY_AND_MOVE(framed_decompressor);
+
+private:
+    bool check_header(unsigned type, size_t length);
+    bool process_chunk(unsigned type, const char* body, size_t length);
+
+    framed_sink sink_;
+    std::string buffer_;
+    std::string scratch_;
+    size_t      skip_        = 0;  // Bytes left of a skippable chunk
+    bool        header_seen_ = false;
+    bool        failed_      = false;
+};
+
+}  // namespace compression
+}  // namespace quarisma
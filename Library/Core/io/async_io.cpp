@@ -0,0 +1,452 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "io/async_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include "io/async_io_backend.h"
+#include "memory/backend/allocator_pool.h"
+#include "util/error.h"
+#include "util/exception.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace quarisma
+{
+namespace io
+{
+//=============================================================================
+// io_file
+//=============================================================================
+
+io_file::~io_file()
+{
+    close();
+}
+
+io_file::io_file(io_file&& other) noexcept
+    : handle_(std::exchange(other.handle_, invalid_handle()))
+{
+}
+
+io_file& io_file::operator=(io_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        handle_ = std::exchange(other.handle_, invalid_handle());
+    }
+    return *this;
+}
+
+io_file io_file::open(const std::string& path, mode m)
+{
+    io_file file;
+#ifdef _WIN32
+    DWORD const access = m == mode::READ    ? GENERIC_READ
+                         : m == mode::WRITE ? GENERIC_WRITE
+                                            : GENERIC_READ | GENERIC_WRITE;
+    DWORD const disposition = m == mode::READ    ? OPEN_EXISTING
+                              : m == mode::WRITE ? CREATE_ALWAYS
+                                                 : OPEN_ALWAYS;
+    file.handle_ = CreateFileA(
+        path.c_str(),
+        access,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr,
+        disposition,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+        nullptr);
+    QUARISMA_CHECK(
+        file.handle_ != INVALID_HANDLE_VALUE,
+        "failed to open {}: error {}",
+        path,
+        static_cast<unsigned>(GetLastError()));
+#else
+    int const flags = m == mode::READ    ? O_RDONLY
+                      : m == mode::WRITE ? O_WRONLY | O_CREAT | O_TRUNC
+                                         : O_RDWR | O_CREAT;
+    file.handle_ = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    QUARISMA_CHECK(file.handle_ >= 0, "failed to open {}: {}", path, utils::str_error(errno));
+#endif
+    return file;
+}
+
+uint64_t io_file::size() const
+{
+    QUARISMA_CHECK(is_open(), "io_file::size() of a closed file");
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    QUARISMA_CHECK(
+        GetFileSizeEx(handle_, &size) != 0,
+        "failed to stat a file: error {}",
+        static_cast<unsigned>(GetLastError()));
+    return static_cast<uint64_t>(size.QuadPart);
+#else
+    struct stat info;
+    QUARISMA_CHECK(
+        fstat(handle_, &info) == 0, "failed to stat a file: {}", utils::str_error(errno));
+    return static_cast<uint64_t>(info.st_size);
+#endif
+}
+
+void io_file::close() noexcept
+{
+    if (!is_open())
+    {
+        return;
+    }
+#ifdef _WIN32
+    CloseHandle(handle_);
+#else
+    ::close(handle_);
+#endif
+    handle_ = invalid_handle();
+}
+
+//=============================================================================
+// async_io
+//=============================================================================
+
+async_io::async_io() : async_io(Options{}) {}
+
+async_io::async_io(const Options& opts)
+{
+    init(opts);
+}
+
+void async_io::init(const Options& opts)
+{
+    QUARISMA_CHECK(opts.queue_depth > 0, "async_io needs a queue depth of at least 1");
+    queue_depth_ = opts.queue_depth;
+
+    io_backend_enum const wanted = opts.backend;
+    if (wanted == io_backend_enum::AUTO || wanted == io_backend_enum::IO_URING)
+    {
+        impl_    = detail::make_io_uring_backend(queue_depth_);
+        backend_ = io_backend_enum::IO_URING;
+    }
+    if (impl_ == nullptr && (wanted == io_backend_enum::AUTO || wanted == io_backend_enum::IOCP))
+    {
+        impl_    = detail::make_iocp_backend(queue_depth_);
+        backend_ = io_backend_enum::IOCP;
+    }
+    QUARISMA_CHECK(
+        impl_ != nullptr || wanted == io_backend_enum::AUTO || wanted == io_backend_enum::THREADS,
+        "the {} async_io backend is not available",
+        wanted == io_backend_enum::IO_URING ? "io_uring" : "IOCP");
+    if (impl_ == nullptr)
+    {
+        QUARISMA_CHECK(opts.threads > 0, "the threads backend needs at least one thread");
+        impl_    = detail::make_threads_backend(queue_depth_, opts.threads);
+        backend_ = io_backend_enum::THREADS;
+    }
+
+    if (opts.fixed_buffer_count == 0)
+    {
+        return;
+    }
+    QUARISMA_CHECK(opts.fixed_buffer_size > 0, "fixed buffers need a size");
+
+    buffer_pool_ = opts.buffer_pool;
+    if (buffer_pool_ == nullptr)
+    {
+        own_pool_ = std::make_unique<allocator_pool>(
+            opts.fixed_buffer_count,
+            false,
+            std::make_unique<basic_cpu_allocator>(
+                0, std::vector<sub_allocator::Visitor>{}, std::vector<sub_allocator::Visitor>{}),
+            std::make_unique<NoopRounder>(),
+            "async_io_buffers");
+        buffer_pool_ = own_pool_.get();
+    }
+
+    // Page-aligned so that the buffers also suit files opened for direct I/O
+    constexpr size_t buffer_alignment = 4096;
+    fixed_buffers_.reserve(opts.fixed_buffer_count);
+    for (size_t i = 0; i < opts.fixed_buffer_count; ++i)
+    {
+        void* data = buffer_pool_->allocate_raw(buffer_alignment, opts.fixed_buffer_size);
+        if (data == nullptr)
+        {
+            release_fixed_buffers();
+            QUARISMA_THROW(
+                "failed to allocate {} fixed buffers of {} bytes",
+                opts.fixed_buffer_count,
+                opts.fixed_buffer_size);
+        }
+        fixed_buffers_.push_back({data, opts.fixed_buffer_size, static_cast<int>(i)});
+    }
+    for (size_t i = fixed_buffers_.size(); i-- > 0;)
+    {
+        free_buffers_.push_back(static_cast<int>(i));
+    }
+    buffers_registered_ = impl_->register_buffers(fixed_buffers_.data(), fixed_buffers_.size());
+}
+
+async_io::~async_io()
+{
+    io_completion completions[64];
+    while (in_flight() > 0)
+    {
+        wait(completions, std::size(completions));
+    }
+    // The backend may still reference the registered buffers
+    impl_.reset();
+    release_fixed_buffers();
+}
+
+void async_io::release_fixed_buffers() noexcept
+{
+    for (auto const& buffer : fixed_buffers_)
+    {
+        buffer_pool_->deallocate_raw(buffer.data);
+    }
+    fixed_buffers_.clear();
+    free_buffers_.clear();
+}
+
+bool async_io::submit(const io_request& request)
+{
+    QUARISMA_CHECK(
+        request.op == io_op::NOP || (request.file != nullptr && request.file->is_open()),
+        "an async_io request needs an open file");
+    QUARISMA_CHECK(
+        request.fixed_buffer < static_cast<int>(fixed_buffers_.size()),
+        "fixed buffer {} does not exist",
+        request.fixed_buffer);
+
+    std::lock_guard<std::mutex> lock(submit_mutex_);
+    size_t count = in_flight_.load(std::memory_order_relaxed);
+    do
+    {
+        if (count >= queue_depth_)
+        {
+            return false;
+        }
+    } while (!in_flight_.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel));
+
+    io_request queued = request;
+    if (!buffers_registered_)
+    {
+        queued.fixed_buffer = -1;
+    }
+    impl_->submit(queued);
+    return true;
+}
+
+size_t async_io::flush()
+{
+    std::lock_guard<std::mutex> lock(submit_mutex_);
+    return impl_->flush();
+}
+
+size_t async_io::poll(io_completion* completions, size_t max)
+{
+    std::lock_guard<std::mutex> lock(reap_mutex_);
+    size_t const count = impl_->reap(completions, max, 0);
+    in_flight_.fetch_sub(count, std::memory_order_acq_rel);
+    return count;
+}
+
+size_t async_io::wait(io_completion* completions, size_t max, size_t min)
+{
+    flush();
+
+    std::lock_guard<std::mutex> lock(reap_mutex_);
+    min                = std::min({min, max, in_flight()});
+    size_t const count = impl_->reap(completions, max, min);
+    in_flight_.fetch_sub(count, std::memory_order_acq_rel);
+    return count;
+}
+
+io_buffer async_io::acquire_buffer()
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    if (free_buffers_.empty())
+    {
+        return {};
+    }
+    int const index = free_buffers_.back();
+    free_buffers_.pop_back();
+    return fixed_buffers_[index];
+}
+
+void async_io::release_buffer(const io_buffer& buffer)
+{
+    QUARISMA_CHECK(
+        buffer.index >= 0 && buffer.index < static_cast<int>(fixed_buffers_.size()) &&
+            fixed_buffers_[buffer.index].data == buffer.data,
+        "the buffer was not lent by this async_io");
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    free_buffers_.push_back(buffer.index);
+}
+
+bool async_io::is_supported(io_backend_enum backend)
+{
+    switch (backend)
+    {
+    case io_backend_enum::IO_URING:
+        return detail::make_io_uring_backend(1) != nullptr;
+    case io_backend_enum::IOCP:
+        return detail::make_iocp_backend(1) != nullptr;
+    case io_backend_enum::AUTO:
+    case io_backend_enum::THREADS:
+        return true;
+    }
+    return false;
+}
+
+//=============================================================================
+// io_scheduler
+//=============================================================================
+
+namespace
+{
+// Owns the future while its request is in flight; user_data points at it
+struct pending_request
+{
+    io_scheduler::future_pointer future;
+};
+}  // namespace
+
+io_scheduler::io_scheduler(threaded_callback_queue& queue)
+    : io_scheduler(queue, async_io::Options{})
+{
+}
+
+io_scheduler::io_scheduler(threaded_callback_queue& queue, const async_io::Options& opts)
+    : queue_(queue), io_(opts), reaper_([this] { reap(); })
+{
+}
+
+io_scheduler::~io_scheduler()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return outstanding_ == 0; });
+        stopping_ = true;
+
+        // The reaper exits once it reaps this
+        io_request wake;
+        wake.op = io_op::NOP;
+        io_.submit(wake);
+        io_.flush();
+    }
+    work_.notify_one();
+    reaper_.join();
+}
+
+io_scheduler::future_pointer io_scheduler::read(
+    const io_file& file, uint64_t offset, void* buffer, size_t size, int fixed_buffer)
+{
+    return enqueue({io_op::READ, &file, offset, buffer, size, 0, fixed_buffer});
+}
+
+io_scheduler::future_pointer io_scheduler::write(
+    const io_file& file, uint64_t offset, const void* buffer, size_t size, int fixed_buffer)
+{
+    return enqueue(
+        {io_op::WRITE, &file, offset, const_cast<void*>(buffer), size, 0, fixed_buffer});
+}
+
+io_scheduler::future_pointer io_scheduler::enqueue(io_request request)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    QUARISMA_CHECK(!stopping_, "io_scheduler is shutting down");
+
+    auto future       = queue_.make_pending<io_completion>();
+    request.user_data = reinterpret_cast<uintptr_t>(new pending_request{future});
+    ++outstanding_;
+    waiting_.push_back(request);
+    submit_waiting();
+    work_.notify_one();
+    return future;
+}
+
+void io_scheduler::submit_waiting()
+{
+    // Called under mutex_, so requests are submitted in the order they came
+    size_t submitted = 0;
+    while (!waiting_.empty() && io_.submit(waiting_.front()))
+    {
+        waiting_.pop_front();
+        ++submitted;
+    }
+    if (submitted > 0)
+    {
+        io_.flush();
+    }
+}
+
+void io_scheduler::reap()
+{
+    io_completion completions[64];
+    for (;;)
+    {
+        {
+            // Requests are only submitted under mutex_, so none can be missed here
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_.wait(lock, [this] { return io_.in_flight() > 0; });
+        }
+
+        size_t const count = io_.wait(completions, std::size(completions));
+        size_t       done  = 0;
+        bool         stop  = false;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (completions[i].user_data == 0)
+            {
+                stop = true;
+                continue;
+            }
+            std::unique_ptr<pending_request> pending(
+                reinterpret_cast<pending_request*>(completions[i].user_data));
+            queue_.set_value(pending->future, completions[i]);
+            ++done;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        submit_waiting();
+        outstanding_ -= done;
+        if (outstanding_ == 0)
+        {
+            idle_.notify_all();
+        }
+        if (stop)
+        {
+            return;
+        }
+    }
+}
+
+}  // namespace io
+}  // namespace quarisma
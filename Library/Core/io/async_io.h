@@ -0,0 +1,411 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/macros.h"
+#include "parallel/threaded_callback_queue.h"
+
+namespace quarisma
+{
+class allocator_pool;
+
+namespace io
+{
+namespace detail
+{
+class io_backend;
+}  // namespace detail
+
+/**
+ * @brief Implementation behind async_io.
+ */
+enum class io_backend_enum : uint8_t
+{
+    /** @brief The native engine of the platform when it is usable, THREADS otherwise. */
+    AUTO = 0,
+
+    /** @brief Linux io_uring (kernel 5.7 or later). */
+    IO_URING = 1,
+
+    /** @brief Windows I/O completion ports. */
+    IOCP = 2,
+
+    /** @brief Blocking positional reads and writes (pread/pwrite) on worker threads. */
+    THREADS = 3
+};
+
+/**
+ * @brief Operation of an io_request.
+ */
+enum class io_op : uint8_t
+{
+    READ = 0,
+    WRITE = 1,
+
+    /** @brief Transfers nothing and completes at once, e.g. to wake a thread in wait(). */
+    NOP = 2
+};
+
+/**
+ * @brief A file opened for positional, asynchronous reads and writes.
+ *
+ * Owns the native handle (a descriptor on POSIX, a HANDLE opened for
+ * overlapped I/O on Windows) and closes it when destroyed. Requests on the
+ * file must complete before it is closed.
+ */
+class QUARISMA_VISIBILITY io_file
+{
+public:
+#ifdef _WIN32
+    using native_handle_type = void*;
+#else
+    using native_handle_type = int;
+#endif
+
+    enum class mode : uint8_t
+    {
+        READ = 0,
+        /** @brief Created when missing, truncated otherwise. */
+        WRITE = 1,
+        /** @brief Created when missing, kept otherwise. */
+        READ_WRITE = 2
+    };
+
+    io_file() noexcept = default;
+    QUARISMA_API ~io_file();
+
+    QUARISMA_API io_file(io_file&& other) noexcept;
+    QUARISMA_API io_file& operator=(io_file&& other) noexcept;
+
+    /**
+     * @brief Opens the file at `path`.
+     * @throws quarisma::Error when it cannot be opened
+     */
+    QUARISMA_API static io_file open(const std::string& path, mode m = mode::READ);
+
+    bool               is_open() const noexcept { return handle_ != invalid_handle(); }
+    native_handle_type native_handle() const noexcept { return handle_; }
+
+    /** @brief Size of the file in bytes. */
+    QUARISMA_API uint64_t size() const;
+
+    QUARISMA_API void close() noexcept;
+
+    static native_handle_type invalid_handle() noexcept
+    {
+#ifdef _WIN32
+        return reinterpret_cast<void*>(static_cast<intptr_t>(-1));
+#else
+        return -1;
+#endif
+    }
+
+private:
+    native_handle_type handle_ = invalid_handle();
+
+    io_file(const io_file&)        = delete;
+    void operator=(const io_file&) = delete;
+};
+
+/**
+ * @brief One read, write or no-op handed to async_io::submit().
+ */
+struct io_request
+{
+    io_op          op     = io_op::READ;
+    const io_file* file   = nullptr;
+    uint64_t       offset = 0;
+    void*          buffer = nullptr;
+    size_t         size   = 0;
+
+    /** @brief Returned unchanged in the completion. */
+    uint64_t user_data = 0;
+
+    /**
+     * @brief Index of the fixed buffer (io_buffer::index) holding `buffer`, or -1.
+     *
+     * Reads and writes into a fixed buffer skip mapping the pages on every
+     * request when the backend has registered the buffers with the kernel.
+     */
+    int fixed_buffer = -1;
+};
+
+/**
+ * @brief Outcome of a request, reaped by async_io::poll() or wait().
+ */
+struct io_completion
+{
+    uint64_t user_data = 0;
+
+    /** @brief Bytes transferred, or a negated system error code (errno, GetLastError). */
+    int64_t result = 0;
+
+    bool ok() const noexcept { return result >= 0; }
+};
+
+/**
+ * @brief A fixed buffer of async_io, see async_io::acquire_buffer().
+ */
+struct io_buffer
+{
+    void*  data  = nullptr;
+    size_t size  = 0;
+    int    index = -1;
+
+    explicit operator bool() const noexcept { return data != nullptr; }
+};
+
+/**
+ * @brief Submission and completion queues of asynchronous file I/O.
+ *
+ * Requests are queued with submit(), handed to the kernel in batches with
+ * flush(), and their completions reaped in any order with poll() or wait().
+ * Up to Options::queue_depth requests may be in flight at once.
+ *
+ * **Backends**:
+ * - IO_URING: the submission and completion rings are shared with the
+ *   kernel, so a whole batch costs one system call and completions none.
+ *   Fixed buffers are registered with the ring.
+ * - IOCP: each request is an overlapped ReadFile or WriteFile, and wait()
+ *   dequeues from the completion port.
+ * - THREADS: Options::threads workers run blocking pread and pwrite. Used
+ *   when neither of the others is available, or when asked for.
+ *
+ * **Fixed Buffers**: Options::fixed_buffer_count buffers of
+ * Options::fixed_buffer_size bytes are drawn at construction from an
+ * allocator_pool, Options::buffer_pool or a private one. acquire_buffer()
+ * and release_buffer() lend them out; pass io_buffer::index in
+ * io_request::fixed_buffer.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * io::async_io ring;
+ * std::vector<io::io_file> files = ...;
+ * for (size_t i = 0; i < files.size(); ++i)
+ *     ring.submit({io::io_op::READ, &files[i], 0, buffers[i], sizes[i], i});
+ * ring.flush();
+ * io::io_completion done[64];
+ * for (size_t left = files.size(); left > 0;)
+ *     left -= ring.wait(done, 64);
+ * ```
+ *
+ * **Thread Safety**: submit(), flush() and the reaping functions may be
+ * called from different threads; each completion is reaped once.
+ */
+class QUARISMA_VISIBILITY async_io
+{
+public:
+    /**
+     * @brief Configuration options for async_io.
+     */
+    struct Options
+    {
+        /**
+         * @brief Backend to use. An explicit backend the platform lacks throws.
+         *
+         * **Default**: AUTO
+         */
+        io_backend_enum backend = io_backend_enum::AUTO;
+
+        /**
+         * @brief Maximum number of requests in flight.
+         *
+         * **Default**: 256
+         */
+        unsigned queue_depth = 256;
+
+        /**
+         * @brief Worker threads of the THREADS backend.
+         *
+         * **Default**: 4
+         */
+        int threads = 4;
+
+        /**
+         * @brief Number and size of the fixed buffers.
+         *
+         * **Default**: none
+         */
+        size_t fixed_buffer_count = 0;
+        size_t fixed_buffer_size  = 0;
+
+        /**
+         * @brief Pool the fixed buffers are drawn from, or nullptr for a private one.
+         *
+         * **Default**: nullptr
+         */
+        allocator_pool* buffer_pool = nullptr;
+    };
+
+    QUARISMA_API async_io();
+    QUARISMA_API explicit async_io(const Options& opts);
+
+    /** @brief Waits for the requests still in flight. */
+    QUARISMA_API ~async_io();
+
+    io_backend_enum backend() const noexcept { return backend_; }
+    unsigned        queue_depth() const noexcept { return queue_depth_; }
+
+    /** @brief Requests submitted and not reaped yet. */
+    size_t in_flight() const noexcept { return in_flight_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Queues a request.
+     * @return false, queueing nothing, when queue_depth() requests are in flight
+     */
+    QUARISMA_API bool submit(const io_request& request);
+
+    /**
+     * @brief Hands the queued requests to the kernel.
+     * @return Number of requests handed over
+     */
+    QUARISMA_API size_t flush();
+
+    /**
+     * @brief Reaps up to `max` completions without blocking.
+     * @return Number written to `completions`
+     */
+    QUARISMA_API size_t poll(io_completion* completions, size_t max);
+
+    /**
+     * @brief Flushes, then reaps up to `max` completions, blocking until there are `min`.
+     *
+     * `min` is capped by in_flight(): nothing blocks once every request is reaped.
+     * @return Number written to `completions`
+     */
+    QUARISMA_API size_t wait(io_completion* completions, size_t max, size_t min = 1);
+
+    /** @brief Lends a free fixed buffer, or an empty one when all are lent. */
+    QUARISMA_API io_buffer acquire_buffer();
+
+    /** @brief Returns a buffer lent by acquire_buffer(). */
+    QUARISMA_API void release_buffer(const io_buffer& buffer);
+
+    size_t fixed_buffer_count() const noexcept { return fixed_buffers_.size(); }
+
+    /** @brief Whether the fixed buffers are registered with the kernel. */
+    bool fixed_buffers_registered() const noexcept { return buffers_registered_; }
+
+    /** @brief Whether `backend` can be used on this machine. */
+    QUARISMA_API static bool is_supported(io_backend_enum backend);
+
+private:
+    void init(const Options& opts);
+    void release_fixed_buffers() noexcept;
+
+    std::unique_ptr<detail::io_backend> impl_;
+    io_backend_enum                     backend_     = io_backend_enum::THREADS;
+    unsigned                            queue_depth_ = 0;
+    std::atomic<size_t>                 in_flight_{0};
+
+    std::mutex submit_mutex_;
+    std::mutex reap_mutex_;
+
+    std::vector<io_buffer>          fixed_buffers_;
+    std::vector<int>                free_buffers_;
+    std::mutex                      buffers_mutex_;
+    allocator_pool*                 buffer_pool_ = nullptr;
+    std::unique_ptr<allocator_pool> own_pool_;
+    bool                            buffers_registered_ = false;
+
+    async_io(const async_io&)       = delete;
+    void operator=(const async_io&) = delete;
+};
+
+/**
+ * @brief Reads and writes that complete threaded_callback_queue futures.
+ *
+ * Every request returns a pending future of the queue (see
+ * threaded_callback_queue::make_pending), which one reaping thread makes
+ * ready with the io_completion. Tasks pushed with push_dependent on those
+ * futures run in the queue once their data is in, so no pool thread blocks
+ * on a read. Requests beyond the queue depth wait in the scheduler and are
+ * submitted as others complete.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * threaded_callback_queue queue;
+ * io::io_scheduler io(queue);
+ * auto file  = io::io_file::open(path);
+ * auto read  = io.read(file, 0, buffer.data(), buffer.size());
+ * auto parse = queue.push_dependent(std::vector{read}, [&] { return parse_scenario(buffer); });
+ * ```
+ *
+ * **Thread Safety**: Fully thread-safe
+ */
+class QUARISMA_VISIBILITY io_scheduler
+{
+public:
+    using future_pointer = threaded_callback_queue::shared_future_pointer<io_completion>;
+
+    QUARISMA_API explicit io_scheduler(threaded_callback_queue& queue);
+    QUARISMA_API io_scheduler(threaded_callback_queue& queue, const async_io::Options& opts);
+
+    /** @brief Waits for every request, completing their futures. */
+    QUARISMA_API ~io_scheduler();
+
+    /** @brief Reads `size` bytes at `offset` of `file` into `buffer`. */
+    QUARISMA_API future_pointer read(
+        const io_file& file, uint64_t offset, void* buffer, size_t size, int fixed_buffer = -1);
+
+    /** @brief Writes `size` bytes of `buffer` at `offset` of `file`. */
+    QUARISMA_API future_pointer write(
+        const io_file& file,
+        uint64_t       offset,
+        const void*    buffer,
+        size_t         size,
+        int            fixed_buffer = -1);
+
+    /** @brief The engine, e.g. for its fixed buffers. Submit through the scheduler only. */
+    async_io& engine() noexcept { return io_; }
+
+private:
+    future_pointer enqueue(io_request request);
+    void           submit_waiting();
+    void           reap();
+
+    threaded_callback_queue& queue_;
+    async_io                 io_;
+
+    std::mutex              mutex_;
+    std::condition_variable work_;
+    std::condition_variable idle_;
+    std::deque<io_request>  waiting_;
+    size_t                  outstanding_ = 0;
+    bool                    stopping_    = false;
+    std::thread             reaper_;
+
+    io_scheduler(const io_scheduler&)   = delete;
+    void operator=(const io_scheduler&) = delete;
+};
+
+}  // namespace io
+}  // namespace quarisma
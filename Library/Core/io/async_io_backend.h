@@ -0,0 +1,66 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "io/async_io.h"
+
+namespace quarisma
+{
+namespace io
+{
+namespace detail
+{
+/**
+ * @brief Queues of one async_io backend.
+ *
+ * async_io serializes submit() and flush() under one lock and reap() under
+ * another, and never queues more than the depth the backend was made with.
+ */
+class io_backend
+{
+public:
+    virtual ~io_backend() = default;
+
+    /** @brief Queues `request` until the next flush(). */
+    virtual void submit(const io_request& request) = 0;
+
+    /** @brief Starts the queued requests, returning their number. */
+    virtual size_t flush() = 0;
+
+    /** @brief Copies up to `max` completions into `out`, blocking until there are `min`. */
+    virtual size_t reap(io_completion* out, size_t max, size_t min) = 0;
+
+    /** @brief Registers the fixed buffers with the kernel; false when unsupported. */
+    virtual bool register_buffers(const io_buffer* /*buffers*/, size_t /*count*/) { return false; }
+};
+
+/** @brief The io_uring backend, or nullptr when the kernel or the sandbox refuse it. */
+std::unique_ptr<io_backend> make_io_uring_backend(unsigned depth);
+
+/** @brief The completion port backend, or nullptr outside Windows. */
+std::unique_ptr<io_backend> make_iocp_backend(unsigned depth);
+
+std::unique_ptr<io_backend> make_threads_backend(unsigned depth, int threads);
+}  // namespace detail
+}  // namespace io
+}  // namespace quarisma
@@ -0,0 +1,236 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "io/async_io_backend.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#endif
+
+namespace quarisma
+{
+namespace io
+{
+namespace detail
+{
+#ifdef _WIN32
+namespace
+{
+// The OVERLAPPED comes first so that the port hands back the whole request
+struct overlapped_request
+{
+    OVERLAPPED overlapped;
+    HANDLE     file;
+    uint64_t   user_data;
+};
+
+/**
+ * A file can be bound to one completion port only, so a file used with one
+ * async_io cannot also be used with another. Requests that fail before
+ * they start post no packet and complete on the next reap() instead.
+ */
+class iocp_backend final : public io_backend
+{
+public:
+    explicit iocp_backend(unsigned depth) : requests_(depth), entries_(depth)
+    {
+        free_.reserve(depth);
+        for (auto& request : requests_)
+        {
+            free_.push_back(&request);
+        }
+        staged_.reserve(depth);
+    }
+
+    ~iocp_backend() override
+    {
+        if (port_ != nullptr)
+        {
+            CloseHandle(port_);
+        }
+    }
+
+    bool init()
+    {
+        port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 0);
+        return port_ != nullptr;
+    }
+
+    void submit(const io_request& request) override { staged_.push_back(request); }
+
+    size_t flush() override
+    {
+        for (auto const& request : staged_)
+        {
+            start(request);
+        }
+        size_t const count = staged_.size();
+        staged_.clear();
+        return count;
+    }
+
+    size_t reap(io_completion* out, size_t max, size_t min) override
+    {
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (; count < max && !failed_.empty(); ++count)
+            {
+                out[count] = failed_.front();
+                failed_.pop_front();
+            }
+        }
+
+        while (count < max)
+        {
+            ULONG       removed = 0;
+            ULONG const wanted  = static_cast<ULONG>(std::min(max - count, entries_.size()));
+            BOOL const  ok      = GetQueuedCompletionStatusEx(
+                port_, entries_.data(), wanted, &removed, count < min ? INFINITE : 0, FALSE);
+            if (!ok || removed == 0)
+            {
+                break;
+            }
+            for (ULONG i = 0; i < removed; ++i)
+            {
+                out[count++] = finish(entries_[i]);
+            }
+            if (count >= min)
+            {
+                break;
+            }
+        }
+        return count;
+    }
+
+private:
+    void start(const io_request& request)
+    {
+        overlapped_request* slot = acquire();
+        std::memset(&slot->overlapped, 0, sizeof(slot->overlapped));
+        slot->user_data = request.user_data;
+        slot->file      = request.op == io_op::NOP ? nullptr : request.file->native_handle();
+
+        if (request.op == io_op::NOP)
+        {
+            PostQueuedCompletionStatus(port_, 0, 0, &slot->overlapped);
+            return;
+        }
+
+        if (bound_.insert(slot->file).second &&
+            CreateIoCompletionPort(slot->file, port_, 0, 0) == nullptr)
+        {
+            bound_.erase(slot->file);
+            fail(slot, GetLastError());
+            return;
+        }
+
+        slot->overlapped.Offset     = static_cast<DWORD>(request.offset);
+        slot->overlapped.OffsetHigh = static_cast<DWORD>(request.offset >> 32);
+        DWORD const size = static_cast<DWORD>(std::min<size_t>(request.size, size_t{1} << 30));
+        OVERLAPPED* overlapped = &slot->overlapped;
+        BOOL const  ok =
+            request.op == io_op::READ
+                ? ReadFile(slot->file, request.buffer, size, nullptr, overlapped)
+                : WriteFile(slot->file, request.buffer, size, nullptr, overlapped);
+        DWORD const error = ok ? ERROR_SUCCESS : GetLastError();
+        if (error != ERROR_SUCCESS && error != ERROR_IO_PENDING)
+        {
+            fail(slot, error);
+        }
+    }
+
+    io_completion finish(const OVERLAPPED_ENTRY& entry)
+    {
+        auto* slot = reinterpret_cast<overlapped_request*>(entry.lpOverlapped);
+        io_completion completion{
+            slot->user_data, static_cast<int64_t>(entry.dwNumberOfBytesTransferred)};
+        DWORD bytes = 0;
+        if (slot->file != nullptr &&
+            !GetOverlappedResult(slot->file, &slot->overlapped, &bytes, FALSE))
+        {
+            DWORD const error = GetLastError();
+            completion.result = error == ERROR_HANDLE_EOF ? 0 : -static_cast<int64_t>(error);
+        }
+        release(slot);
+        return completion;
+    }
+
+    void fail(overlapped_request* slot, DWORD error)
+    {
+        io_completion const completion{
+            slot->user_data, error == ERROR_HANDLE_EOF ? 0 : -static_cast<int64_t>(error)};
+        release(slot);
+        std::lock_guard<std::mutex> lock(mutex_);
+        failed_.push_back(completion);
+    }
+
+    overlapped_request* acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        overlapped_request* slot = free_.back();
+        free_.pop_back();
+        return slot;
+    }
+
+    void release(overlapped_request* slot)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(slot);
+    }
+
+    HANDLE                           port_ = nullptr;
+    std::vector<overlapped_request>  requests_;
+    std::vector<OVERLAPPED_ENTRY>    entries_;
+    std::vector<io_request>          staged_;
+    std::unordered_set<HANDLE>       bound_;
+    std::mutex                       mutex_;
+    std::vector<overlapped_request*> free_;
+    std::deque<io_completion>        failed_;
+};
+}  // namespace
+
+std::unique_ptr<io_backend> make_iocp_backend(unsigned depth)
+{
+    auto backend = std::make_unique<iocp_backend>(depth);
+    if (!backend->init())
+    {
+        return nullptr;
+    }
+    return backend;
+}
+#else
+std::unique_ptr<io_backend> make_iocp_backend(unsigned /*depth*/)
+{
+    return nullptr;
+}
+#endif
+}  // namespace detail
+}  // namespace io
+}  // namespace quarisma
@@ -0,0 +1,238 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "io/async_io_backend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace quarisma
+{
+namespace io
+{
+namespace detail
+{
+namespace
+{
+#ifdef _WIN32
+// Bytes moved by one blocking ReadFile or WriteFile, or a negated error
+int64_t transfer_chunk(const io_request& request, char* data, uint64_t offset, size_t size)
+{
+    HANDLE const event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (event == nullptr)
+    {
+        return -static_cast<int64_t>(GetLastError());
+    }
+
+    // The handle is overlapped, so even a blocking transfer needs an OVERLAPPED; the
+    // set low bit of the event keeps its completion off any port the file is bound to
+    OVERLAPPED overlapped{};
+    overlapped.Offset     = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    overlapped.hEvent     = reinterpret_cast<HANDLE>(reinterpret_cast<uintptr_t>(event) | 1);
+
+    HANDLE const file  = request.file->native_handle();
+    DWORD const  chunk = static_cast<DWORD>(std::min<size_t>(size, size_t{1} << 30));
+    BOOL         ok    = request.op == io_op::READ
+                             ? ReadFile(file, data, chunk, nullptr, &overlapped)
+                             : WriteFile(file, data, chunk, nullptr, &overlapped);
+    DWORD bytes = 0;
+    if (ok || GetLastError() == ERROR_IO_PENDING)
+    {
+        ok = GetOverlappedResult(file, &overlapped, &bytes, TRUE);
+    }
+    DWORD const error = ok ? ERROR_SUCCESS : GetLastError();
+    CloseHandle(event);
+
+    if (error == ERROR_HANDLE_EOF)
+    {
+        return 0;
+    }
+    return error == ERROR_SUCCESS ? static_cast<int64_t>(bytes) : -static_cast<int64_t>(error);
+}
+#else
+// Bytes moved by one pread or pwrite, or a negated errno
+int64_t transfer_chunk(const io_request& request, char* data, uint64_t offset, size_t size)
+{
+    int const   fd       = request.file->native_handle();
+    off_t const position = static_cast<off_t>(offset);
+    for (;;)
+    {
+        ssize_t const result = request.op == io_op::READ ? pread(fd, data, size, position)
+                                                         : pwrite(fd, data, size, position);
+        if (result >= 0 || errno != EINTR)
+        {
+            return result >= 0 ? static_cast<int64_t>(result) : -static_cast<int64_t>(errno);
+        }
+    }
+}
+#endif
+
+// Repeats short transfers until the request is done or the file ends
+int64_t transfer(const io_request& request)
+{
+    if (request.op == io_op::NOP)
+    {
+        return 0;
+    }
+
+    auto*  data = static_cast<char*>(request.buffer);
+    size_t done = 0;
+    while (done < request.size)
+    {
+        int64_t const result =
+            transfer_chunk(request, data + done, request.offset + done, request.size - done);
+        if (result < 0)
+        {
+            return result;
+        }
+        if (result == 0)
+        {
+            break;
+        }
+        done += static_cast<size_t>(result);
+    }
+    return static_cast<int64_t>(done);
+}
+
+/**
+ * Workers take flushed requests in order and queue their completions; the
+ * depth bounds both queues, so neither grows past what async_io admits.
+ */
+class threads_backend final : public io_backend
+{
+public:
+    threads_backend(unsigned depth, int threads)
+    {
+        staged_.reserve(depth);
+        workers_.reserve(static_cast<size_t>(threads));
+        for (int i = 0; i < threads; ++i)
+        {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+    ~threads_backend() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    void submit(const io_request& request) override { staged_.push_back(request); }
+
+    size_t flush() override
+    {
+        size_t const count = staged_.size();
+        if (count == 0)
+        {
+            return 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            work_.insert(work_.end(), staged_.begin(), staged_.end());
+        }
+        staged_.clear();
+        if (count == 1)
+        {
+            work_ready_.notify_one();
+        }
+        else
+        {
+            work_ready_.notify_all();
+        }
+        return count;
+    }
+
+    size_t reap(io_completion* out, size_t max, size_t min) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_ready_.wait(lock, [&] { return done_.size() >= min; });
+
+        size_t count = 0;
+        for (; count < max && !done_.empty(); ++count)
+        {
+            out[count] = done_.front();
+            done_.pop_front();
+        }
+        return count;
+    }
+
+private:
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            work_ready_.wait(lock, [this] { return stopping_ || !work_.empty(); });
+            if (work_.empty())
+            {
+                return;
+            }
+            io_request const request = work_.front();
+            work_.pop_front();
+
+            lock.unlock();
+            io_completion const completion{request.user_data, transfer(request)};
+            lock.lock();
+
+            done_.push_back(completion);
+            done_ready_.notify_one();
+        }
+    }
+
+    std::vector<io_request> staged_;
+
+    std::mutex                mutex_;
+    std::condition_variable   work_ready_;
+    std::condition_variable   done_ready_;
+    std::deque<io_request>    work_;
+    std::deque<io_completion> done_;
+    bool                      stopping_ = false;
+    std::vector<std::thread>  workers_;
+};
+}  // namespace
+
+std::unique_ptr<io_backend> make_threads_backend(unsigned depth, int threads)
+{
+    return std::make_unique<threads_backend>(depth, threads);
+}
+}  // namespace detail
+}  // namespace io
+}  // namespace quarisma
@@ -0,0 +1,291 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "io/async_io_backend.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+#if defined(IORING_FEAT_FAST_POLL) && defined(IORING_OFF_SQES)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#define QUARISMA_HAS_IO_URING 1
+#endif
+
+namespace quarisma
+{
+namespace io
+{
+namespace detail
+{
+#if QUARISMA_HAS_IO_URING
+namespace
+{
+// Called directly, there being no liburing to link against
+int sys_io_uring_setup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T* ring_field(void* ring, uint32_t offset) noexcept
+{
+    return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+
+/**
+ * The submission ring is only written under async_io's submit lock and the
+ * completion ring only read under its reap lock, so the one acquire or
+ * release per side orders them against the kernel.
+ */
+class io_uring_backend final : public io_backend
+{
+public:
+    ~io_uring_backend() override
+    {
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+        {
+            munmap(cq_ring_, cq_ring_bytes_);
+        }
+        if (sq_ring_ != nullptr)
+        {
+            munmap(sq_ring_, sq_ring_bytes_);
+        }
+        if (sqes_ != nullptr)
+        {
+            munmap(sqes_, sqes_bytes_);
+        }
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+    }
+
+    bool init(unsigned depth)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = sys_io_uring_setup(depth, &params);
+        // Kernels before 5.7 lack IORING_OP_READ and IORING_OP_WRITE
+        if (fd_ < 0 || (params.features & IORING_FEAT_FAST_POLL) == 0)
+        {
+            return false;
+        }
+
+        sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+        {
+            sq_ring_bytes_ = cq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+        }
+
+        sq_ring_ = map(sq_ring_bytes_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == nullptr)
+        {
+            return false;
+        }
+        cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_bytes_, IORING_OFF_CQ_RING);
+        sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_       = static_cast<io_uring_sqe*>(map(sqes_bytes_, IORING_OFF_SQES));
+        if (cq_ring_ == nullptr || sqes_ == nullptr)
+        {
+            return false;
+        }
+
+        sq_tail_  = ring_field<uint32_t>(sq_ring_, params.sq_off.tail);
+        sq_mask_  = *ring_field<uint32_t>(sq_ring_, params.sq_off.ring_mask);
+        sq_array_ = ring_field<uint32_t>(sq_ring_, params.sq_off.array);
+        cq_head_  = ring_field<uint32_t>(cq_ring_, params.cq_off.head);
+        cq_tail_  = ring_field<uint32_t>(cq_ring_, params.cq_off.tail);
+        cq_mask_  = *ring_field<uint32_t>(cq_ring_, params.cq_off.ring_mask);
+        cqes_     = ring_field<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+        local_tail_ = *sq_tail_;
+        return true;
+    }
+
+    void submit(const io_request& request) override
+    {
+        uint32_t const index = local_tail_ & sq_mask_;
+        io_uring_sqe&  sqe   = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+
+        bool const fixed = request.fixed_buffer >= 0;
+        switch (request.op)
+        {
+        case io_op::READ:
+            sqe.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            break;
+        case io_op::WRITE:
+            sqe.opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            break;
+        case io_op::NOP:
+            sqe.opcode = IORING_OP_NOP;
+            break;
+        }
+        if (request.op != io_op::NOP)
+        {
+            sqe.fd   = request.file->native_handle();
+            sqe.off  = request.offset;
+            sqe.addr = reinterpret_cast<uintptr_t>(request.buffer);
+            sqe.len  = static_cast<uint32_t>(std::min<size_t>(request.size, 0x7ffff000));
+            if (fixed)
+            {
+                sqe.buf_index = static_cast<uint16_t>(request.fixed_buffer);
+            }
+        }
+        sqe.user_data = request.user_data;
+
+        sq_array_[index] = index;
+        ++local_tail_;
+        ++unsubmitted_;
+    }
+
+    size_t flush() override
+    {
+        if (unsubmitted_ == 0)
+        {
+            return 0;
+        }
+        __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+
+        int consumed;
+        do
+        {
+            consumed = sys_io_uring_enter(fd_, unsubmitted_, 0, 0);
+        } while (consumed < 0 && errno == EINTR);
+        // On EAGAIN or EBUSY the entries stay published and go with the next flush
+        if (consumed <= 0)
+        {
+            return 0;
+        }
+        unsubmitted_ -= static_cast<unsigned>(consumed);
+        return static_cast<size_t>(consumed);
+    }
+
+    size_t reap(io_completion* out, size_t max, size_t min) override
+    {
+        size_t count = 0;
+        for (;;)
+        {
+            uint32_t       head = *cq_head_;
+            uint32_t const tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            for (; head != tail && count < max; ++head, ++count)
+            {
+                io_uring_cqe const& cqe = cqes_[head & cq_mask_];
+                out[count]              = {cqe.user_data, cqe.res};
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+            if (count >= min)
+            {
+                return count;
+            }
+            int const result = sys_io_uring_enter(
+                fd_, 0, static_cast<unsigned>(min - count), IORING_ENTER_GETEVENTS);
+            if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                return count;
+            }
+        }
+    }
+
+    bool register_buffers(const io_buffer* buffers, size_t count) override
+    {
+        std::vector<iovec> iovecs(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            iovecs[i] = {buffers[i].data, buffers[i].size};
+        }
+        // Fails over RLIMIT_MEMLOCK, in which case requests fall back to copying page lists
+        return sys_io_uring_register(
+                   fd_, IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(count)) == 0;
+    }
+
+private:
+    void* map(size_t bytes, uint64_t offset) const
+    {
+        void* ring = mmap(
+            nullptr,
+            bytes,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            fd_,
+            static_cast<off_t>(offset));
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    int           fd_            = -1;
+    void*         sq_ring_       = nullptr;
+    void*         cq_ring_       = nullptr;
+    io_uring_sqe* sqes_          = nullptr;
+    size_t        sq_ring_bytes_ = 0;
+    size_t        cq_ring_bytes_ = 0;
+    size_t        sqes_bytes_    = 0;
+
+    uint32_t*     sq_tail_     = nullptr;
+    uint32_t*     sq_array_    = nullptr;
+    uint32_t      sq_mask_     = 0;
+    uint32_t*     cq_head_     = nullptr;
+    uint32_t*     cq_tail_     = nullptr;
+    uint32_t      cq_mask_     = 0;
+    io_uring_cqe* cqes_        = nullptr;
+    uint32_t      local_tail_  = 0;
+    unsigned      unsubmitted_ = 0;
+};
+}  // namespace
+
+std::unique_ptr<io_backend> make_io_uring_backend(unsigned depth)
+{
+    auto backend = std::make_unique<io_uring_backend>();
+    if (!backend->init(depth))
+    {
+        return nullptr;
+    }
+    return backend;
+}
+#else
+std::unique_ptr<io_backend> make_io_uring_backend(unsigned /*depth*/)
+{
+    return nullptr;
+}
+#endif
+}  // namespace detail
+}  // namespace io
+}  // namespace quarisma
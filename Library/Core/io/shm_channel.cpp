@@ -0,0 +1,575 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "io/shm_channel.h"
+
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "util/exception.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>  // For _mm_pause
+#elif defined(_M_ARM64)
+#include <intrin.h>  // For __yield
+#endif
+
+namespace quarisma
+{
+namespace io
+{
+namespace detail
+{
+constexpr uint64_t channel_magic   = 0x314e414843534d51ULL;  // "QMSCHAN1"
+constexpr uint32_t channel_version = 1;
+
+// Shared by every process on the channel; senders and the receiver write different lines
+struct shm_channel_header
+{
+    std::atomic<uint64_t> magic;
+    uint32_t              version;
+    uint32_t              multi_producer;
+    uint64_t              capacity;
+    uint64_t              slot_size;
+    uint64_t              slot_stride;
+    uint64_t              arena_size;
+
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint64_t> head;
+
+    // Bumped to wake the receiver (data) or the senders (space) sleeping on them
+    alignas(64) std::atomic<uint32_t> data_signal;
+    std::atomic<uint32_t>             data_waiters;
+    alignas(64) std::atomic<uint32_t> space_signal;
+    std::atomic<uint32_t>             space_waiters;
+};
+
+// Precedes the payload in every slot; a message in the arena keeps its offset there
+struct shm_channel_slot
+{
+    std::atomic<uint64_t> sequence;
+    uint32_t              size;
+    uint32_t              in_arena;
+};
+static_assert(sizeof(shm_channel_slot) == 16, "slots lay out 16 bytes of header");
+}  // namespace detail
+
+namespace
+{
+using detail::shm_channel_header;
+using detail::shm_channel_slot;
+using clock = std::chrono::steady_clock;
+
+/**
+ * @brief Checks of the ring before sleeping: a reply often comes back
+ * quicker than a futex round trip.
+ */
+constexpr int wait_spin_count = 256;
+
+inline void cpu_pause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#elif defined(_M_ARM64)
+    __yield();
+#endif
+}
+
+size_t align_up(size_t value, size_t alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t round_up_to_power_of_two(size_t value) noexcept
+{
+    size_t result = 2;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+std::string arena_name(const std::string& name)
+{
+    return name + ".arena";
+}
+
+// Sleeps while `word` holds `expected`, for at most `timeout`
+void wait_on(std::atomic<uint32_t>& word, uint32_t expected, shm_channel::duration timeout)
+{
+#ifdef __linux__
+    // Not FUTEX_PRIVATE_FLAG: the word is shared with other processes
+    timespec  relative;
+    timespec* limit = nullptr;
+    if (timeout != shm_channel::forever)
+    {
+        auto const ns    = timeout.count();
+        relative.tv_sec  = static_cast<time_t>(ns / 1000000000);
+        relative.tv_nsec = static_cast<long>(ns % 1000000000);
+        limit            = &relative;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, limit, nullptr, 0);
+#else
+    // No address-shared wait primitive here: sleep in short steps instead
+    (void)word;
+    (void)expected;
+    std::this_thread::sleep_for(
+        std::min<shm_channel::duration>(timeout, std::chrono::microseconds(50)));
+#endif
+}
+
+void wake_all(std::atomic<uint32_t>& word)
+{
+#ifdef __linux__
+    syscall(
+        SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Wakes sleepers on `signal`, at the cost of one load when there are none
+void notify(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiters)
+{
+    // Orders the slot just published before reading waiters, against wait_for()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) != 0)
+    {
+        signal.fetch_add(1, std::memory_order_release);
+        wake_all(signal);
+    }
+}
+
+struct deadline
+{
+    explicit deadline(shm_channel::duration timeout)
+        : bounded(timeout != shm_channel::forever),
+          at(bounded ? clock::now() + timeout : clock::time_point{})
+    {
+    }
+
+    // forever when unbounded, zero or less once passed
+    shm_channel::duration remaining() const
+    {
+        return bounded ? std::chrono::duration_cast<shm_channel::duration>(at - clock::now())
+                       : shm_channel::forever;
+    }
+
+    bool              bounded;
+    clock::time_point at;
+};
+
+template <typename Ready>
+bool wait_for(
+    std::atomic<uint32_t>& signal,
+    std::atomic<uint32_t>& waiters,
+    Ready                  ready,
+    const deadline&        until)
+{
+    for (int i = 0; i < wait_spin_count; ++i)
+    {
+        if (ready())
+        {
+            return true;
+        }
+        cpu_pause();
+    }
+
+    for (;;)
+    {
+        uint32_t const observed = signal.load(std::memory_order_acquire);
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (ready())
+        {
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        shm_channel::duration const remaining = until.remaining();
+        if (remaining <= shm_channel::duration::zero())
+        {
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        wait_on(signal, observed, remaining);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        if (ready())
+        {
+            return true;
+        }
+    }
+}
+}  // namespace
+
+shm_channel::~shm_channel() = default;
+
+shm_channel::shm_channel(shm_channel&& other) noexcept
+    : ring_(std::move(other.ring_)),
+      arena_(std::move(other.arena_)),
+      header_(std::exchange(other.header_, nullptr)),
+      capacity_(std::exchange(other.capacity_, 0)),
+      slot_size_(std::exchange(other.slot_size_, 0)),
+      slot_stride_(std::exchange(other.slot_stride_, 0)),
+      multi_producer_(std::exchange(other.multi_producer_, false))
+{
+}
+
+shm_channel& shm_channel::operator=(shm_channel&& other) noexcept
+{
+    if (this != &other)
+    {
+        arena_          = std::move(other.arena_);
+        ring_           = std::move(other.ring_);
+        header_         = std::exchange(other.header_, nullptr);
+        capacity_       = std::exchange(other.capacity_, 0);
+        slot_size_      = std::exchange(other.slot_size_, 0);
+        slot_stride_    = std::exchange(other.slot_stride_, 0);
+        multi_producer_ = std::exchange(other.multi_producer_, false);
+    }
+    return *this;
+}
+
+shm_channel shm_channel::create(const std::string& name)
+{
+    return create(name, Options{});
+}
+
+shm_channel shm_channel::create(const std::string& name, const Options& opts)
+{
+    QUARISMA_CHECK(opts.slot_size > 0, "shm_channel slots need room for a message");
+    QUARISMA_CHECK(opts.slot_size <= UINT32_MAX, "shm_channel slots of {} bytes", opts.slot_size);
+
+    shm_channel channel;
+    channel.capacity_       = round_up_to_power_of_two(opts.capacity);
+    channel.slot_size_      = std::max(opts.slot_size, sizeof(uint64_t));
+    channel.slot_stride_    = align_up(sizeof(shm_channel_slot) + channel.slot_size_, 64);
+    channel.multi_producer_ = opts.multi_producer;
+
+    // The arena exists before the ring is published, so that openers find it
+    if (opts.arena_size > 0)
+    {
+        channel.arena_ = std::make_unique<shm_arena_allocator>(
+            std::vector<sub_allocator::Visitor>{},
+            std::vector<sub_allocator::Visitor>{},
+            shm_arena_allocator::Options{arena_name(name), opts.arena_size});
+    }
+
+    channel.ring_ = shm_segment::create(
+        name, align_up(sizeof(shm_channel_header), 64) + channel.capacity_ * channel.slot_stride_);
+
+    auto* header           = new (channel.ring_.data()) shm_channel_header;
+    header->version        = detail::channel_version;
+    header->multi_producer = opts.multi_producer ? 1 : 0;
+    header->capacity       = channel.capacity_;
+    header->slot_size      = channel.slot_size_;
+    header->slot_stride    = channel.slot_stride_;
+    header->arena_size     = opts.arena_size;
+    header->tail.store(0, std::memory_order_relaxed);
+    header->head.store(0, std::memory_order_relaxed);
+    header->data_signal.store(0, std::memory_order_relaxed);
+    header->data_waiters.store(0, std::memory_order_relaxed);
+    header->space_signal.store(0, std::memory_order_relaxed);
+    header->space_waiters.store(0, std::memory_order_relaxed);
+    channel.header_ = header;
+
+    for (uint64_t i = 0; i < channel.capacity_; ++i)
+    {
+        auto* slot = new (channel.slot_base(i)) shm_channel_slot;
+        slot->sequence.store(i, std::memory_order_relaxed);
+    }
+    header->magic.store(detail::channel_magic, std::memory_order_release);
+    return channel;
+}
+
+shm_channel shm_channel::open(const std::string& name)
+{
+    shm_channel channel;
+    channel.ring_ = shm_segment::open(name);
+
+    auto* header = static_cast<shm_channel_header*>(channel.ring_.data());
+    QUARISMA_CHECK(
+        channel.ring_.size() >= sizeof(shm_channel_header) &&
+            header->magic.load(std::memory_order_acquire) == detail::channel_magic &&
+            header->version == detail::channel_version,
+        "{} is not a shm_channel",
+        name);
+    channel.header_         = header;
+    channel.capacity_       = header->capacity;
+    channel.slot_size_      = header->slot_size;
+    channel.slot_stride_    = header->slot_stride;
+    channel.multi_producer_ = header->multi_producer != 0;
+    QUARISMA_CHECK(
+        align_up(sizeof(shm_channel_header), 64) + channel.capacity_ * channel.slot_stride_ <=
+            channel.ring_.size(),
+        "{} is truncated",
+        name);
+
+    if (header->arena_size > 0)
+    {
+        channel.arena_ = std::make_unique<shm_arena_allocator>(
+            std::vector<sub_allocator::Visitor>{},
+            std::vector<sub_allocator::Visitor>{},
+            shm_arena_allocator::Options{arena_name(name), 0});
+    }
+    return channel;
+}
+
+uint8_t* shm_channel::slot_base(uint64_t position) const noexcept
+{
+    return static_cast<uint8_t*>(ring_.data()) + align_up(sizeof(shm_channel_header), 64) +
+           (position & (capacity_ - 1)) * slot_stride_;
+}
+
+bool shm_channel::publish(const void* data, size_t size, uint64_t arena_offset, bool in_arena)
+{
+    uint64_t          position = header_->tail.load(std::memory_order_relaxed);
+    shm_channel_slot* slot     = nullptr;
+    for (;;)
+    {
+        slot                    = reinterpret_cast<shm_channel_slot*>(slot_base(position));
+        uint64_t const sequence = slot->sequence.load(std::memory_order_acquire);
+        auto const     lag      = static_cast<int64_t>(sequence - position);
+        if (lag == 0)
+        {
+            if (!multi_producer_)
+            {
+                header_->tail.store(position + 1, std::memory_order_relaxed);
+                break;
+            }
+            if (header_->tail.compare_exchange_weak(
+                    position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (lag < 0)
+        {
+            // The receiver has not freed this slot from the previous lap: full
+            return false;
+        }
+        else
+        {
+            position = header_->tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    auto* payload  = reinterpret_cast<uint8_t*>(slot + 1);
+    slot->size     = static_cast<uint32_t>(size);
+    slot->in_arena = in_arena ? 1 : 0;
+    if (in_arena)
+    {
+        std::memcpy(payload, &arena_offset, sizeof(arena_offset));
+    }
+    else if (size > 0)
+    {
+        std::memcpy(payload, data, size);
+    }
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    notify(header_->data_signal, header_->data_waiters);
+    return true;
+}
+
+bool shm_channel::ready_to_send() const noexcept
+{
+    uint64_t const position = header_->tail.load(std::memory_order_relaxed);
+    auto const*    slot     = reinterpret_cast<const shm_channel_slot*>(slot_base(position));
+    return slot->sequence.load(std::memory_order_acquire) == position;
+}
+
+bool shm_channel::ready_to_receive() const noexcept
+{
+    uint64_t const position = header_->head.load(std::memory_order_relaxed);
+    auto const*    slot     = reinterpret_cast<const shm_channel_slot*>(slot_base(position));
+    return slot->sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+bool shm_channel::try_send(const void* data, size_t size)
+{
+    QUARISMA_CHECK(header_ != nullptr, "shm_channel::try_send() on a closed channel");
+    if (size <= slot_size_)
+    {
+        return publish(data, size, 0, false);
+    }
+    QUARISMA_CHECK(
+        arena_ != nullptr,
+        "a message of {} bytes needs an arena; the slots of {} hold {}",
+        size,
+        ring_.name(),
+        slot_size_);
+
+    // Saves the copy into the arena when the ring has no room anyway
+    if (!ready_to_send())
+    {
+        return false;
+    }
+    void* payload = allocate(size);
+    if (payload == nullptr)
+    {
+        return false;
+    }
+    std::memcpy(payload, data, size);
+    if (!try_send_allocated(payload, size))
+    {
+        release(payload, size);
+        return false;
+    }
+    return true;
+}
+
+bool shm_channel::send(const void* data, size_t size, duration timeout)
+{
+    deadline const until(timeout);
+    while (!try_send(data, size))
+    {
+        if (!wait_for(
+                header_->space_signal,
+                header_->space_waiters,
+                [this] { return ready_to_send(); },
+                until))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void* shm_channel::allocate(size_t size)
+{
+    QUARISMA_CHECK(arena_ != nullptr, "{} has no arena", ring_.name());
+    QUARISMA_CHECK(size <= UINT32_MAX, "shm_channel messages of {} bytes", size);
+    size_t received = 0;
+    return arena_->Alloc(64, size, &received);
+}
+
+void shm_channel::release(void* payload, size_t size)
+{
+    arena_->Free(payload, size);
+}
+
+bool shm_channel::try_send_allocated(void* payload, size_t size)
+{
+    QUARISMA_CHECK(
+        arena_ != nullptr && arena_->contains(payload),
+        "send_allocated() takes memory from allocate()");
+    return publish(nullptr, size, arena_->offset_of(payload), true);
+}
+
+bool shm_channel::send_allocated(void* payload, size_t size, duration timeout)
+{
+    deadline const until(timeout);
+    while (!try_send_allocated(payload, size))
+    {
+        if (!wait_for(
+                header_->space_signal,
+                header_->space_waiters,
+                [this] { return ready_to_send(); },
+                until))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool shm_channel::try_receive(const receiver& consume)
+{
+    QUARISMA_CHECK(header_ != nullptr, "shm_channel::try_receive() on a closed channel");
+    uint64_t const position = header_->head.load(std::memory_order_relaxed);
+    auto*          slot     = reinterpret_cast<shm_channel_slot*>(slot_base(position));
+    if (slot->sequence.load(std::memory_order_acquire) != position + 1)
+    {
+        return false;
+    }
+
+    size_t const size     = slot->size;
+    void*        payload  = slot + 1;
+    bool const   in_arena = slot->in_arena != 0;
+    if (in_arena)
+    {
+        uint64_t offset;
+        std::memcpy(&offset, payload, sizeof(offset));
+        payload = arena_->pointer_at(offset);
+    }
+
+    // Frees the slot even when consume throws
+    struct slot_release
+    {
+        ~slot_release()
+        {
+            if (in_arena)
+            {
+                channel.release(payload, size);
+            }
+            slot->sequence.store(position + channel.capacity_, std::memory_order_release);
+            channel.header_->head.store(position + 1, std::memory_order_relaxed);
+            notify(channel.header_->space_signal, channel.header_->space_waiters);
+        }
+
+        shm_channel&      channel;
+        shm_channel_slot* slot;
+        uint64_t          position;
+        void*             payload;
+        size_t            size;
+        bool              in_arena;
+    } const done{*this, slot, position, payload, size, in_arena};
+
+    consume(payload, size);
+    return true;
+}
+
+bool shm_channel::receive(const receiver& consume, duration timeout)
+{
+    deadline const until(timeout);
+    while (!try_receive(consume))
+    {
+        if (!wait_for(
+                header_->data_signal,
+                header_->data_waiters,
+                [this] { return ready_to_receive(); },
+                until))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t shm_channel::size() const noexcept
+{
+    uint64_t const head = header_->head.load(std::memory_order_relaxed);
+    uint64_t const tail = header_->tail.load(std::memory_order_relaxed);
+    return tail > head ? static_cast<size_t>(tail - head) : 0;
+}
+
+}  // namespace io
+}  // namespace quarisma
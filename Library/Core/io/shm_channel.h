@@ -0,0 +1,204 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "common/macros.h"
+#include "memory/backend/allocator_shm.h"
+
+namespace quarisma
+{
+namespace io
+{
+namespace detail
+{
+struct shm_channel_header;
+}  // namespace detail
+
+/**
+ * @brief Message queue between processes of one host, over shared memory.
+ *
+ * A ring of fixed-size slots lives in a shared memory segment: sending
+ * copies the message into the next slot and receiving hands the slot's
+ * bytes to a callback, so a message costs two copies and no system call
+ * while the receiver is busy. Nobody waiting means nobody is woken; a
+ * receiver idle on an empty ring (or a sender on a full one) sleeps on a
+ * futex in the segment, woken by a single syscall.
+ *
+ * **Index protocol**: each slot carries a sequence number saying which lap
+ * it is free or full for (see mpmc_ring_buffer). With
+ * Options::multi_producer the senders claim slots with a CAS on the shared
+ * tail; without it the one sender simply advances the tail. There is one
+ * receiver, normally the process that created the channel.
+ *
+ * **Large messages**: with Options::arena_size the channel also creates a
+ * shm_arena_allocator. Messages above Options::slot_size are copied into
+ * it and the slot carries their offset, or a sender writes straight into
+ * allocate()'d arena memory and passes it with send_allocated(); the
+ * receiver frees the region once its callback returns.
+ *
+ * **Crashes**: a sender dying between claiming and publishing a slot
+ * leaves the ring stuck at that slot; the receiver then times out.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * // Aggregator process
+ * auto results = io::shm_channel::create("/pricing_results", opts);
+ * results.receive([&](const void* data, size_t size) { merge(data, size); });
+ *
+ * // Each worker process
+ * auto results = io::shm_channel::open("/pricing_results");
+ * results.send(&result, sizeof(result));
+ * ```
+ *
+ * **Thread Safety**: sending is thread-safe with Options::multi_producer;
+ * one thread receives
+ */
+class QUARISMA_VISIBILITY shm_channel
+{
+public:
+    using receiver = std::function<void(const void* data, size_t size)>;
+    using duration = std::chrono::nanoseconds;
+
+    /** @brief Waits without limit. */
+    static constexpr duration forever = duration::max();
+
+    /**
+     * @brief Configuration options for shm_channel.
+     */
+    struct Options
+    {
+        /**
+         * @brief Number of slots, rounded up to a power of two.
+         *
+         * **Default**: 1024
+         */
+        size_t capacity = 1024;
+
+        /**
+         * @brief Largest message copied into a slot.
+         *
+         * **Default**: 240 bytes (256-byte slots)
+         */
+        size_t slot_size = 240;
+
+        /**
+         * @brief Whether several threads or processes send.
+         *
+         * **Default**: false
+         */
+        bool multi_producer = false;
+
+        /**
+         * @brief Bytes of the arena for messages above slot_size, or 0 for none.
+         *
+         * **Default**: 0
+         */
+        size_t arena_size = 0;
+    };
+
+    shm_channel() noexcept = default;
+    QUARISMA_API ~shm_channel();
+
+    QUARISMA_API shm_channel(shm_channel&& other) noexcept;
+    QUARISMA_API shm_channel& operator=(shm_channel&& other) noexcept;
+
+    /**
+     * @brief Creates the channel `name`, replacing a stale one; the name goes with it.
+     * @throws quarisma::Error when the segments cannot be created
+     */
+    QUARISMA_API static shm_channel create(const std::string& name, const Options& opts);
+    QUARISMA_API static shm_channel create(const std::string& name);
+
+    /**
+     * @brief Opens the channel `name` created by another process.
+     * @throws quarisma::Error when it does not exist or is not a channel
+     */
+    QUARISMA_API static shm_channel open(const std::string& name);
+
+    /**
+     * @brief Sends a copy of `size` bytes unless the ring or the arena is full.
+     * @throws quarisma::Error when the message needs an arena the channel lacks
+     */
+    QUARISMA_API bool try_send(const void* data, size_t size);
+
+    /** @brief Sends a copy of `size` bytes, waiting up to `timeout` for room. */
+    QUARISMA_API bool send(const void* data, size_t size, duration timeout = forever);
+
+    /**
+     * @brief Arena memory for a message of `size` bytes, or nullptr when none is free.
+     *
+     * Fill it and pass it to send_allocated(), or give it back with release().
+     */
+    QUARISMA_API void* allocate(size_t size);
+
+    QUARISMA_API void release(void* payload, size_t size);
+
+    /** @brief Sends allocate()'d memory without copying it, unless the ring is full. */
+    QUARISMA_API bool try_send_allocated(void* payload, size_t size);
+
+    QUARISMA_API bool send_allocated(void* payload, size_t size, duration timeout = forever);
+
+    /**
+     * @brief Passes the oldest message to `consume`, unless there is none.
+     *
+     * The bytes are only valid during the call.
+     */
+    QUARISMA_API bool try_receive(const receiver& consume);
+
+    /** @brief Passes the oldest message to `consume`, waiting up to `timeout` for one. */
+    QUARISMA_API bool receive(const receiver& consume, duration timeout = forever);
+
+    size_t capacity() const noexcept { return capacity_; }
+    size_t slot_size() const noexcept { return slot_size_; }
+    bool   multi_producer() const noexcept { return multi_producer_; }
+
+    /** @brief Messages sent and not yet received, an estimate while others are busy. */
+    QUARISMA_API size_t size() const noexcept;
+
+    /** @brief The arena, or nullptr without one. */
+    shm_arena_allocator* arena() const noexcept { return arena_.get(); }
+
+private:
+    bool     publish(const void* data, size_t size, uint64_t arena_offset, bool in_arena);
+    bool     ready_to_receive() const noexcept;
+    bool     ready_to_send() const noexcept;
+    uint8_t* slot_base(uint64_t position) const noexcept;
+
+    shm_segment                          ring_;
+    std::unique_ptr<shm_arena_allocator> arena_;
+    detail::shm_channel_header*          header_         = nullptr;
+    size_t                               capacity_       = 0;
+    size_t                               slot_size_      = 0;
+    size_t                               slot_stride_    = 0;
+    bool                                 multi_producer_ = false;
+
+    shm_channel(const shm_channel&)    = delete;
+    void operator=(const shm_channel&) = delete;
+};
+
+}  // namespace io
+}  // namespace quarisma
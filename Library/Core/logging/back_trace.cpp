@@ -7,6 +7,8 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
 #include <functional>
 #include <optional>
@@ -14,6 +16,7 @@
 #include <vector>
 
 #include "common/pointer.h"
+#include "logging/symbol_cache.h"
 #include "util/string_util.h"
 
 // Platform-specific includes
@@ -158,26 +161,60 @@ std::string back_trace::print(const backtrace_options& options)
 
 std::vector<stack_frame> back_trace::capture(const backtrace_options& options)
 {
-    std::vector<stack_frame> result;
+    // Skip this frame (capture) plus user-requested frames
+    auto const addresses = capture_addresses(
+        options.frames_to_skip + 1ULL, options.maximum_number_of_frames);  //NOLINT
+    return symbolize(addresses, options);
+}
+
+std::vector<void*> back_trace::capture_addresses(
+    QUARISMA_UNUSED size_t frames_to_skip, QUARISMA_UNUSED size_t maximum_number_of_frames)
+{
+    std::vector<void*> callstack;
 
 #if SUPPORTS_BACKTRACE
-    // Skip this frame (capture) plus user-requested frames
-    size_t frames_to_skip = options.frames_to_skip + 1ULL;  //NOLINT
+    // Skip this frame (capture_addresses) plus user-requested frames
+    ++frames_to_skip;
 
 #ifdef _WIN32
-    // Windows implementation using CaptureStackBackTrace
-    const size_t       max_frames = frames_to_skip + options.maximum_number_of_frames;
-    std::vector<void*> callstack(max_frames, nullptr);
+    callstack.resize(maximum_number_of_frames, nullptr);
 
-    // Capture stack frames
     USHORT const captured = CaptureStackBackTrace(
         static_cast<DWORD>(frames_to_skip),
-        static_cast<DWORD>(options.maximum_number_of_frames),
+        static_cast<DWORD>(maximum_number_of_frames),
         callstack.data(),
         nullptr);
 
     callstack.resize(captured);
+#else   // Unix/Linux/macOS implementation
+    callstack.resize(frames_to_skip + maximum_number_of_frames, nullptr);
+
+    auto const number_of_frames =
+        static_cast<size_t>(::backtrace(callstack.data(), static_cast<int>(callstack.size())));
+
+    size_t const skipped = std::min(frames_to_skip, number_of_frames);
+    callstack.erase(callstack.begin(), callstack.begin() + static_cast<std::ptrdiff_t>(skipped));
+    callstack.resize(number_of_frames - skipped);
+#endif  // _WIN32
+
+#endif  // SUPPORTS_BACKTRACE
+
+    return callstack;
+}
+
+std::vector<stack_frame> back_trace::symbolize(
+    QUARISMA_UNUSED const std::vector<void*>& addresses,
+    QUARISMA_UNUSED const backtrace_options&  options)
+{
+    std::vector<stack_frame> result;
+
+#if SUPPORTS_BACKTRACE
+    if (addresses.empty())
+    {
+        return result;
+    }
 
+#ifdef _WIN32
     // Initialize symbol handler (thread-safe)
     static bool symbol_handler_initialized = false;
     if (!symbol_handler_initialized)
@@ -193,18 +230,18 @@ std::vector<stack_frame> back_trace::capture(const backtrace_options& options)
     std::vector<char> buffer(buffer_size);
     auto*             symbol = reinterpret_cast<SYMBOL_INFO*>(buffer.data());
 
-    for (size_t i = 0; i < callstack.size(); ++i)
+    for (size_t i = 0; i < addresses.size(); ++i)
     {
         stack_frame frame;
         frame.frame_number   = i;
-        frame.return_address = callstack[i];
+        frame.return_address = addresses[i];
 
         // Get symbol information
         symbol->MaxNameLen   = MAX_SYM_NAME;
         symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
 
         DWORD64 displacement = 0;
-        if (SymFromAddr(process, reinterpret_cast<DWORD64>(callstack[i]), &displacement, symbol) !=
+        if (SymFromAddr(process, reinterpret_cast<DWORD64>(addresses[i]), &displacement, symbol) !=
             0)
         {
             frame.function_name        = symbol->Name;
@@ -213,13 +250,13 @@ std::vector<stack_frame> back_trace::capture(const backtrace_options& options)
         else
         {
             frame.function_name =
-                fmt::format("<unknown> [0x{:x}]", reinterpret_cast<uintptr_t>(callstack[i]));
+                fmt::format("<unknown> [0x{:x}]", reinterpret_cast<uintptr_t>(addresses[i]));
         }
 
         // Get module information
         IMAGEHLP_MODULE64 module_info;
         module_info.SizeOfStruct = sizeof(IMAGEHLP_MODULE64);
-        if (SymGetModuleInfo64(process, reinterpret_cast<DWORD64>(callstack[i]), &module_info) != 0)
+        if (SymGetModuleInfo64(process, reinterpret_cast<DWORD64>(addresses[i]), &module_info) != 0)
         {
             frame.object_file = module_info.ModuleName;
         }
@@ -232,7 +269,7 @@ std::vector<stack_frame> back_trace::capture(const backtrace_options& options)
             DWORD line_displacement = 0;
             if (SymGetLineFromAddr64(
                     process,
-                    reinterpret_cast<DWORD64>(callstack[i]),
+                    reinterpret_cast<DWORD64>(addresses[i]),
                     &line_displacement,
                     &line_info) != 0)
             {
@@ -245,33 +282,30 @@ std::vector<stack_frame> back_trace::capture(const backtrace_options& options)
     }
 
 #else   // Unix/Linux/macOS implementation
-    std::vector<void*> callstack(frames_to_skip + options.maximum_number_of_frames, nullptr);
-
-    // Capture raw stack addresses
-    auto number_of_frames = ::backtrace(callstack.data(), static_cast<int>(callstack.size()));
-
-    // Skip requested frames
-    for (; frames_to_skip > 0 && number_of_frames > 0; --frames_to_skip, --number_of_frames)
-    {
-        callstack.erase(callstack.begin());
-    }
-
-    callstack.resize(static_cast<size_t>(number_of_frames));
-
     // Get symbol information
     std::unique_ptr<char*, std::function<void(char**)> > const raw_symbols(
-        ::backtrace_symbols(callstack.data(), static_cast<int>(callstack.size())), free);
+        ::backtrace_symbols(addresses.data(), static_cast<int>(addresses.size())), free);
 
     if (!raw_symbols)
     {
         return result;  // Failed to get symbols
     }
     // cppcheck-suppress arithOperationsOnVoidPointer
-    const std::vector<std::string> symbols(raw_symbols.get(), raw_symbols.get() + callstack.size());
+    const std::vector<std::string> symbols(raw_symbols.get(), raw_symbols.get() + addresses.size());
+
+#if defined(__linux__)
+    // File and line come from DWARF, looked up once per process (and per binary
+    // with a disk cache), see logging/symbol_cache.h
+    std::vector<symbol_info> source_info;
+    if (options.include_source_info)
+    {
+        source_info = symbol_cache::instance().resolve(addresses);
+    }
+#endif
 
     // Parse each frame
     bool has_skipped_python_frames = false;
-    for (size_t frame_number = 0; frame_number < callstack.size(); ++frame_number)
+    for (size_t frame_number = 0; frame_number < addresses.size(); ++frame_number)
     {
         const auto frame_info = parse_frame_information(symbols[frame_number]);
 
@@ -291,7 +325,7 @@ std::vector<stack_frame> back_trace::capture(const backtrace_options& options)
 
         stack_frame frame;
         frame.frame_number   = frame_number;
-        frame.return_address = callstack[frame_number];
+        frame.return_address = addresses[frame_number];
 
         if (frame_info)
         {
@@ -305,6 +339,23 @@ std::vector<stack_frame> back_trace::capture(const backtrace_options& options)
             frame.function_name = symbols[frame_number];
         }
 
+#if defined(__linux__)
+        if (!source_info.empty())
+        {
+            const auto& symbol = source_info[frame_number];
+            if (!symbol.file.empty())
+            {
+                frame.source_file = symbol.file;
+                frame.source_line = static_cast<int>(symbol.line);
+            }
+            // backtrace_symbols() only names exported functions
+            if (frame.function_name.empty() && symbol.function != "??")
+            {
+                frame.function_name = symbol.function;
+            }
+        }
+#endif
+
         result.push_back(frame);
     }
 #endif  // _WIN32
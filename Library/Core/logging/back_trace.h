@@ -108,6 +108,31 @@ public:
     QUARISMA_API static std::vector<stack_frame> capture(
         const backtrace_options& options = backtrace_options());
 
+    /**
+     * @brief Capture the raw return addresses of the current stack
+     *
+     * @param frames_to_skip Number of top frames to skip, not counting this one
+     * @param maximum_number_of_frames Maximum frames to capture
+     * @return Return addresses, most recent call first
+     *
+     * Only walks the stack: no symbol lookup, no allocation beyond the result.
+     * Pass the addresses to symbolize() when the frames are actually needed.
+     */
+    QUARISMA_API static std::vector<void*> capture_addresses(
+        size_t frames_to_skip = 0, size_t maximum_number_of_frames = 64);
+
+    /**
+     * @brief Resolve return addresses from capture_addresses() to stack frames
+     *
+     * @param addresses Return addresses, most recent call first
+     * @param options Symbol resolution options; frames_to_skip and
+     *        maximum_number_of_frames are ignored
+     * @return Vector of stack frame information
+     */
+    QUARISMA_API static std::vector<stack_frame> symbolize(
+        const std::vector<void*>& addresses,
+        const backtrace_options&  options = backtrace_options());
+
     /**
      * @brief Format captured stack frames to string
      *
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint32_t
+#include <cstring>      // for memcpy
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <tuple>        // for tuple, apply
+#include <type_traits>  // for decay_t, enable_if_t, is_arithmetic_v
+
+#include "fmt/format.h"                     // for FMT_STRING, format, runtime
+#include "logging/logger.h"                 // for logger
+#include "logging/logger_verbosity_enum.h"  // for logger_verbosity_enum
+
+namespace quarisma
+{
+/**
+ * @brief A `QUARISMA_LOG_DEFERRED` call site.
+ *
+ * Sites are constant-initialized, so they are registered before any code runs
+ * and a log record only has to carry a pointer to its site.
+ */
+struct deferred_log_site
+{
+    logger_verbosity_enum verbosity;
+    const char*           fname;
+    unsigned int          lineno;
+    const char*           format;
+};
+
+namespace deferred_log
+{
+/**
+ * @brief Raw encoding of one argument of a deferred log call.
+ *
+ * Arithmetic, enum and pointer values are stored as their bytes; anything
+ * convertible to std::string_view is stored as a uint32_t length followed by
+ * the characters, so the record stays valid after the argument is gone.
+ */
+template <typename T, typename = void>
+struct codec
+{
+    static_assert(
+        std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+        "QUARISMA_LOG_DEFERRED arguments must be arithmetic, enum, pointer or string values");
+
+    using decoded_type = T;
+
+    static size_t size(const T&) { return sizeof(T); }
+
+    static char* encode(char* out, const T& value)
+    {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+
+    static T decode(const char*& in)
+    {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+};
+
+template <typename T>
+struct codec<T, std::enable_if_t<std::is_convertible_v<const T&, std::string_view>>>
+{
+    using decoded_type = std::string_view;
+
+    static size_t size(const T& value)
+    {
+        return sizeof(uint32_t) + std::string_view(value).size();
+    }
+
+    static char* encode(char* out, const T& value)
+    {
+        const std::string_view text(value);
+        const auto             length = static_cast<uint32_t>(text.size());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), text.data(), length);
+        return out + sizeof(length) + length;
+    }
+
+    static std::string_view decode(const char*& in)
+    {
+        uint32_t length = 0;
+        std::memcpy(&length, in, sizeof(length));
+        const std::string_view text(in + sizeof(length), length);
+        in += sizeof(length) + length;
+        return text;
+    }
+};
+
+template <typename T>
+using codec_t = codec<std::decay_t<const T>>;
+
+// `args` points at the std::tuple<const Args&...> built by log().
+template <typename... Args>
+void encode(char* out, const void* args)
+{
+    std::apply(
+        [&out](const auto&... values) { ((out = codec_t<Args>::encode(out, values)), ...); },
+        *static_cast<const std::tuple<const Args&...>*>(args));
+}
+
+template <typename... Args>
+std::string decode(const char* format, const char* data)
+{
+    // Braced initialization decodes the arguments left to right.
+    const std::tuple<typename codec_t<Args>::decoded_type...> values{
+        codec_t<Args>::decode(data)...};
+    return std::apply(
+        [format](const auto&... v) { return fmt::format(fmt::runtime(format), v...); }, values);
+}
+
+/**
+ * Copies the raw arguments into the asynchronous log queue; the writer thread
+ * formats them. Without an asynchronous writer the message is formatted here.
+ */
+template <typename... Args>
+void log(const deferred_log_site& site, const Args&... args)
+{
+    const std::tuple<const Args&...> refs(args...);
+    const size_t                     size = (size_t{0} + ... + codec_t<Args>::size(args));
+    if (!logger::LogDeferred(site, size, &encode<Args...>, &refs, &decode<Args...>))
+    {
+        logger::Log(
+            site.verbosity,
+            site.fname,
+            site.lineno,
+            fmt::format(fmt::runtime(site.format), args...).c_str());
+    }
+}
+}  // namespace deferred_log
+}  // namespace quarisma
+
+/**
+ * @brief Log with the formatting deferred to the asynchronous writer thread.
+ *
+ * Same use as QUARISMA_LOG, but the calling thread only copies the raw
+ * arguments into the queue started by `logger::StartAsync`; arguments are
+ * limited to arithmetic, enum, pointer and string values. The format string is
+ * still checked at compile time. Without an asynchronous writer this behaves
+ * like QUARISMA_LOG.
+ *
+ * Example:
+ *     QUARISMA_LOG_DEFERRED(INFO, "order {} filled {} @ {:.2f}", id, quantity, price);
+ */
+#define QUARISMA_LOG_DEFERRED(verbosity_name, format_string, ...)                     \
+    do                                                                                \
+    {                                                                                 \
+        if (quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name <=            \
+            quarisma::logger::GetCurrentVerbosityCutoff())                            \
+        {                                                                             \
+            static constexpr quarisma::deferred_log_site quarisma_deferred_site{      \
+                quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name,          \
+                __FILE__,                                                             \
+                __LINE__,                                                             \
+                format_string};                                                       \
+            if (false)                                                                \
+            {                                                                         \
+                (void)fmt::format(FMT_STRING(format_string), ##__VA_ARGS__);          \
+            }                                                                         \
+            quarisma::deferred_log::log(quarisma_deferred_site, ##__VA_ARGS__);       \
+        }                                                                             \
+    } while (0)
@@ -1,20 +1,26 @@
 #include "logging/logger.h"
 
 #include <array>    // for array
+#include <chrono>   // for system_clock
 #include <cstdarg>  // for va_end, va_list, va_start
+#include <cstdint>  // for int64_t, uint64_t, uintptr_t
 #include <cstdio>   // for vsnprintf
 #include <cstdlib>  // for strtol
 #include <cstring>  // for strcmp, strlen, strncpy
-#include <memory>   // for make_shared, shared_ptr, make_unique, unique_ptr
+#include <memory>   // for make_unique, unique_ptr
 #include <mutex>    // for mutex, lock_guard
+#include <new>      // for launder
 #include <string>
 #include <thread>   // for get_id, operator==, thread
 #include <utility>  // for pair
 #include <vector>   // for vector
 
 #include "common/macros.h"
+#include "logging/deferred_log.h"
 #include "logging/logger_verbosity_enum.h"
-#include "util/flat_hash.h"
+#include "parallel/profiled_mutex.h"
+#include "profiler/base/external_ranges.h"
+#include "util/startup_tracer.h"
 
 // Include appropriate logging backend headers
 #if QUARISMA_HAS_LOGURU
@@ -26,7 +32,59 @@
 #include <fmt/format.h>
 
 #include <atomic>
-#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iterator>
+
+#include "util/mpmc_ring_buffer.h"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+#if QUARISMA_HAS_LOGURU || QUARISMA_HAS_NATIVE_LOGGING
+namespace quarisma
+{
+namespace internal
+{
+// OS id of the calling thread for StructuredMessage, looked up once per thread
+static uint64_t current_thread_id()
+{
+    thread_local const uint64_t tid = []
+    {
+#ifdef _WIN32
+        return static_cast<uint64_t>(::GetCurrentThreadId());
+#elif defined(__APPLE__)
+        uint64_t id = 0;
+        if (pthread_threadid_np(nullptr, &id) == 0)
+        {
+            return id;
+        }
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pthread_self()));
+#elif defined(__linux__)
+        return static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pthread_self()));
+#endif
+    }();
+    return tid;
+}
+
+static int64_t wall_clock_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace internal
+}  // namespace quarisma
 #endif
 
 //=============================================================================
@@ -78,6 +136,482 @@ static fmt::color get_severity_color(logger_verbosity_enum severity)
 // Global verbosity level for VLOG
 static std::atomic<int> g_max_vlog_level{0};
 
+// Strip the directories from a __FILE__ path
+static const char* base_name(const char* fname)
+{
+    const char* filename = fname;
+    for (const char* p = fname; *p; ++p)
+    {
+        if (*p == '/' || *p == '\\')
+        {
+            filename = p + 1;
+        }
+    }
+    return filename;
+}
+
+namespace
+{
+// A message ready to be written; the strings are NUL terminated.
+struct native_line
+{
+    logger_verbosity_enum severity;
+    const char*           filename;
+    int                   line;
+    const char*           message;
+    size_t                message_size;
+    uint64_t              thread_id;
+    int64_t               timestamp_ns;
+};
+
+struct native_file_sink
+{
+    std::string           path;
+    FILE*                 file;
+    logger_verbosity_enum verbosity;
+};
+
+// Exactly one of `handler` and `structured_handler` is set.
+struct native_callback_sink
+{
+    std::string                        id;
+    logger::LogHandlerCallbackT        handler;
+    logger::StructuredHandlerCallbackT structured_handler;
+    void*                              user_data;
+    logger_verbosity_enum              verbosity;
+    logger::CloseHandlerCallbackT      on_close;
+    logger::FlushHandlerCallbackT      on_flush;
+};
+
+// The outputs of the native backend. Both the synchronous path and the async
+// writer thread write under `mutex`, so lines never interleave and a sink
+// removed by EndLogToFile or RemoveCallback is not used afterwards.
+struct native_sinks
+{
+    profiled_mutex                    mutex{"logger::native_sinks"};
+    std::vector<native_file_sink>     files;
+    std::vector<native_callback_sink> callbacks;
+};
+
+// Leaked on purpose so that logging keeps working during static destruction.
+native_sinks& sinks()
+{
+    static auto* instance = new native_sinks();
+    return *instance;
+}
+
+// Writes `count` lines to every sink; the caller holds sinks().mutex. stderr is
+// unbuffered, so its lines are gathered and written with a single call.
+void write_lines(native_sinks& outputs, const native_line* lines, size_t count)
+{
+    fmt::memory_buffer err;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const native_line& l = lines[i];
+        fmt::format_to(
+            std::back_inserter(err),
+            fg(get_severity_color(l.severity)),
+            "[{}] {}:{} {}\n",
+            verbosity_to_string(l.severity),
+            l.filename,
+            l.line,
+            l.message);
+    }
+    std::fwrite(err.data(), 1, err.size(), stderr);
+
+    for (auto& sink : outputs.files)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const native_line& l = lines[i];
+            if (l.severity <= sink.verbosity)
+            {
+                fmt::print(
+                    sink.file,
+                    "[{}] {}:{} {}\n",
+                    verbosity_to_string(l.severity),
+                    l.filename,
+                    l.line,
+                    l.message);
+            }
+        }
+        std::fflush(sink.file);
+    }
+
+    if (outputs.callbacks.empty())
+    {
+        return;
+    }
+    fmt::memory_buffer preamble;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const native_line& l = lines[i];
+        preamble.clear();
+
+        const logger::StructuredMessage structured{
+            l.severity,
+            l.filename,
+            static_cast<unsigned>(l.line),
+            l.thread_id,
+            l.timestamp_ns,
+            std::string_view(l.message, l.message_size)};
+        for (const auto& sink : outputs.callbacks)
+        {
+            if (l.severity > sink.verbosity)
+            {
+                continue;
+            }
+            if (sink.structured_handler != nullptr)
+            {
+                sink.structured_handler(sink.user_data, structured);
+                continue;
+            }
+            // The preamble is only formatted for the first callback that wants it.
+            if (preamble.size() == 0)
+            {
+                fmt::format_to(
+                    std::back_inserter(preamble),
+                    "[{}] {}:{}",
+                    verbosity_to_string(l.severity),
+                    l.filename,
+                    l.line);
+                preamble.push_back('\0');
+            }
+            const logger::Message message{
+                l.severity,
+                l.filename,
+                static_cast<unsigned>(l.line),
+                preamble.data(),
+                "",
+                "",
+                l.message};
+            sink.handler(sink.user_data, message);
+        }
+    }
+}
+
+// One queued message. A formatted message stores the file name and the text,
+// each NUL terminated; a deferred one stores the raw arguments of its `site`.
+// Short records are stored inline so that queuing them does not allocate.
+struct native_log_record
+{
+    static constexpr size_t kInlineSize = 256;
+
+    logger_verbosity_enum         severity     = logger_verbosity_enum::VERBOSITY_INFO;
+    int                           line         = 0;
+    uint32_t                      name_size    = 0;
+    uint32_t                      size         = 0;
+    uint64_t                      thread_id    = 0;
+    int64_t                       timestamp_ns = 0;
+    const deferred_log_site*      site         = nullptr;
+    logger::DeferredDecodeT       decode       = nullptr;
+    std::array<char, kInlineSize> inline_text;
+    std::string                   long_text;
+
+    void assign(
+        const char* filename, int l, logger_verbosity_enum s, const std::string& message)
+    {
+        severity  = s;
+        line      = l;
+        site      = nullptr;
+        decode    = nullptr;
+        name_size = static_cast<uint32_t>(std::strlen(filename));
+        size      = static_cast<uint32_t>(name_size + 1 + message.size() + 1);
+        char* out = reserve();
+        std::memcpy(out, filename, name_size + 1);
+        std::memcpy(out + name_size + 1, message.c_str(), message.size() + 1);
+    }
+
+    void assign_deferred(
+        const deferred_log_site& s,
+        size_t                   args_size,
+        logger::DeferredEncodeT  encode,
+        const void*              args,
+        logger::DeferredDecodeT  d)
+    {
+        severity  = s.verbosity;
+        line      = static_cast<int>(s.lineno);
+        site      = &s;
+        decode    = d;
+        name_size = 0;
+        size      = static_cast<uint32_t>(args_size);
+        encode(reserve(), args);
+    }
+
+    const char* data() const { return size > kInlineSize ? long_text.data() : inline_text.data(); }
+
+    char* reserve()
+    {
+        if (size > kInlineSize)
+        {
+            long_text.resize(size);
+            return long_text.data();
+        }
+        return inline_text.data();
+    }
+
+    native_line view() const
+    {
+        const char* text = data();
+        return {
+            severity,
+            text,
+            line,
+            text + name_size + 1,
+            size - name_size - 2,
+            thread_id,
+            timestamp_ns};
+    }
+};
+
+// Asynchronous mode: producers copy their message into a thread-local record
+// and move it into a bounded MPMC ring, used here with a single consumer. The
+// writer thread pops up to kMaxBatch records at once and writes them with one
+// write_lines call, so the sink mutex and the stderr write are paid per batch.
+class native_async_logger
+{
+public:
+    static native_async_logger& instance()
+    {
+        static auto* logger = new native_async_logger();
+        return *logger;
+    }
+
+    void start(const logger::AsyncOptions& options)
+    {
+        const std::scoped_lock control(control_mutex_);
+        if (enabled_.load())
+        {
+            return;
+        }
+        options_ = options;
+        queue_   = std::make_unique<mpmc_ring_buffer<native_log_record>>(options.queue_capacity);
+        dropped_.store(0);
+        stopping_.store(false);
+        writer_ = std::thread([this] { run(); });
+        enabled_.store(true);
+    }
+
+    // Writes everything queued, then joins the writer thread.
+    void stop()
+    {
+        const std::scoped_lock control(control_mutex_);
+        if (!enabled_.load())
+        {
+            return;
+        }
+        enabled_.store(false);
+        // Producers that saw enabled_ still push; the writer keeps draining for them.
+        while (producers_.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+        {
+            const std::scoped_lock lock(wake_mutex_);
+            stopping_.store(true);
+        }
+        wake_.notify_one();
+        writer_.join();
+        queue_.reset();
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Queues the message, or returns false when async mode is off and the
+    // caller has to write it itself.
+    bool submit(
+        const char* filename, int line, logger_verbosity_enum severity, const std::string& message)
+    {
+        return push(
+            severity,
+            [&](native_log_record& record) { record.assign(filename, line, severity, message); });
+    }
+
+    // Queues the raw arguments of a deferred log call; the writer formats them.
+    bool submit_deferred(
+        const deferred_log_site& site,
+        size_t                   size,
+        logger::DeferredEncodeT  encode,
+        const void*              args,
+        logger::DeferredDecodeT  decode)
+    {
+        return push(
+            site.verbosity,
+            [&](native_log_record& record)
+            { record.assign_deferred(site, size, encode, args, decode); });
+    }
+
+    // Waits until the writer has written every message queued before the call.
+    void flush()
+    {
+        if (!enabled() || is_writer_thread())
+        {
+            return;
+        }
+        const uint64_t target = pushed_.load();
+        wake();
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        drained_.wait(lock, [&] { return written_.load() >= target || stopping_.load(); });
+    }
+
+private:
+    static constexpr size_t kMaxBatch = 256;
+
+    static bool& is_writer_thread()
+    {
+        thread_local bool writer = false;
+        return writer;
+    }
+
+    // Fills this thread's record and pushes it as the overflow policy allows.
+    template <typename Fill>
+    bool push(logger_verbosity_enum severity, Fill&& fill)
+    {
+        producers_.fetch_add(1);
+        if (!enabled_.load())
+        {
+            producers_.fetch_sub(1);
+            return false;
+        }
+
+        thread_local native_log_record record;
+        fill(record);
+        record.thread_id    = current_thread_id();
+        record.timestamp_ns = wall_clock_ns();
+
+        // The writer thread cannot wait for itself, e.g. when a callback logs.
+        const auto policy    = options_.overflow_policy;
+        const bool fatal     = severity <= logger_verbosity_enum::VERBOSITY_FATAL;
+        const bool may_block = !is_writer_thread() &&
+                               (fatal || policy == logger::OverflowPolicy::BLOCK ||
+                                (policy == logger::OverflowPolicy::DROP_LOW_SEVERITY &&
+                                 severity <= options_.keep_threshold));
+
+        bool queued = queue_->try_push(std::move(record));
+        while (!queued && may_block)
+        {
+            wake();
+            std::this_thread::yield();
+            queued = queue_->try_push(std::move(record));
+        }
+        if (queued)
+        {
+            pushed_.fetch_add(1);
+            if (sleeping_.load())
+            {
+                wake();
+            }
+        }
+        else
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        producers_.fetch_sub(1);
+
+        if (fatal)
+        {
+            flush();
+        }
+        return true;
+    }
+
+    void wake()
+    {
+        {
+            const std::scoped_lock lock(wake_mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    void run()
+    {
+        is_writer_thread() = true;
+        std::vector<native_log_record> batch(kMaxBatch);
+        std::vector<std::string>       formatted(kMaxBatch);
+        std::vector<native_line>       lines(kMaxBatch);
+        while (true)
+        {
+            size_t count = 0;
+            while (count < kMaxBatch && queue_->try_pop(batch[count]))
+            {
+                const native_log_record& record = batch[count];
+                if (record.site == nullptr)
+                {
+                    lines[count] = record.view();
+                }
+                else
+                {
+                    formatted[count] = record.decode(record.site->format, record.data());
+                    lines[count]     = {
+                        record.severity,
+                        base_name(record.site->fname),
+                        record.line,
+                        formatted[count].c_str(),
+                        formatted[count].size(),
+                        record.thread_id,
+                        record.timestamp_ns};
+                }
+                ++count;
+            }
+
+            if (count > 0)
+            {
+                {
+                    auto&                  outputs = sinks();
+                    const std::scoped_lock lock(outputs.mutex);
+                    write_lines(outputs, lines.data(), count);
+                }
+                {
+                    const std::scoped_lock lock(wake_mutex_);
+                    written_.fetch_add(count);
+                }
+                drained_.notify_all();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            if (stopping_.load() && queue_->size_approx() == 0)
+            {
+                break;
+            }
+            // A wakeup racing with sleeping_ is caught by the timeout.
+            sleeping_.store(true);
+            wake_.wait_for(
+                lock,
+                std::chrono::milliseconds(10),
+                [&] { return stopping_.load() || queue_->size_approx() > 0; });
+            sleeping_.store(false);
+        }
+        drained_.notify_all();
+    }
+
+    std::mutex                                           control_mutex_;
+    logger::AsyncOptions                                 options_;
+    std::unique_ptr<mpmc_ring_buffer<native_log_record>> queue_;
+    std::thread                                          writer_;
+
+    std::atomic<bool>     enabled_{false};
+    std::atomic<int>      producers_{0};
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<size_t>   dropped_{0};
+
+    std::mutex              wake_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::atomic<bool>       sleeping_{false};
+    std::atomic<bool>       stopping_{false};
+};
+
+// Writes the queued messages at normal exit.
+struct native_async_shutdown
+{
+    ~native_async_shutdown() { native_async_logger::instance().stop(); }
+} g_native_async_shutdown;
+}  // namespace
+
 // Implementation functions called by inline classes in logger.h
 void native_log_output(
     const char* fname, int line, logger_verbosity_enum severity, const std::string& message)
@@ -87,25 +621,156 @@ void native_log_output(
         return;
     }
 
-    // Extract just the filename from the full path
-    const char* filename = fname;
-    for (const char* p = fname; *p; ++p)
+    const char* filename = base_name(fname);
+    if (native_async_logger::instance().submit(filename, line, severity, message))
     {
-        if (*p == '/' || *p == '\\')
-        {
-            filename = p + 1;
-        }
+        return;
     }
 
-    // Format and print the log message
-    fmt::print(
-        stderr,
-        fg(get_severity_color(severity)),
-        "[{}] {}:{} {}\n",
-        verbosity_to_string(severity),
+    const native_line l{
+        severity,
         filename,
         line,
-        message);
+        message.c_str(),
+        message.size(),
+        current_thread_id(),
+        wall_clock_ns()};
+    auto&                  outputs = sinks();
+    const std::scoped_lock lock(outputs.mutex);
+    write_lines(outputs, &l, 1);
+}
+
+bool native_log_deferred(
+    const deferred_log_site& site,
+    size_t                   size,
+    logger::DeferredEncodeT  encode,
+    const void*              args,
+    logger::DeferredDecodeT  decode)
+{
+    return native_async_logger::instance().submit_deferred(site, size, encode, args, decode);
+}
+
+void native_add_file(const char* path, logger::FileMode filemode, logger_verbosity_enum verbosity)
+{
+    std::error_code ec;
+    const auto      parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+    {
+        std::filesystem::create_directories(parent, ec);
+    }
+    FILE* file = std::fopen(path, filemode == logger::FileMode::APPEND ? "a" : "w");
+    if (file == nullptr)
+    {
+        fmt::print(stderr, "[ERROR] Failed to open log file '{}'\n", path);
+        return;
+    }
+
+    auto&                  outputs = sinks();
+    const std::scoped_lock lock(outputs.mutex);
+    outputs.files.push_back({path, file, verbosity});
+}
+
+void native_remove_file(const char* path)
+{
+    native_async_logger::instance().flush();
+    auto&                  outputs = sinks();
+    const std::scoped_lock lock(outputs.mutex);
+    auto&                  files = outputs.files;
+    for (auto it = files.begin(); it != files.end(); ++it)
+    {
+        if (it->path == path)
+        {
+            std::fclose(it->file);
+            files.erase(it);
+            return;
+        }
+    }
+}
+
+void native_add_callback(
+    const char*                   id,
+    logger::LogHandlerCallbackT   callback,
+    void*                         user_data,
+    logger_verbosity_enum         verbosity,
+    logger::CloseHandlerCallbackT on_close,
+    logger::FlushHandlerCallbackT on_flush)
+{
+    auto&                  outputs = sinks();
+    const std::scoped_lock lock(outputs.mutex);
+    outputs.callbacks.push_back({id, callback, nullptr, user_data, verbosity, on_close, on_flush});
+}
+
+void native_add_structured_callback(
+    const char*                        id,
+    logger::StructuredHandlerCallbackT callback,
+    void*                              user_data,
+    logger_verbosity_enum              verbosity,
+    logger::CloseHandlerCallbackT      on_close,
+    logger::FlushHandlerCallbackT      on_flush)
+{
+    auto&                  outputs = sinks();
+    const std::scoped_lock lock(outputs.mutex);
+    outputs.callbacks.push_back({id, nullptr, callback, user_data, verbosity, on_close, on_flush});
+}
+
+bool native_remove_callback(const char* id)
+{
+    native_async_logger::instance().flush();
+    auto&                  outputs = sinks();
+    const std::scoped_lock lock(outputs.mutex);
+    auto&                  callbacks = outputs.callbacks;
+    for (auto it = callbacks.begin(); it != callbacks.end(); ++it)
+    {
+        if (it->id == id)
+        {
+            if (it->on_close != nullptr)
+            {
+                it->on_close(it->user_data);
+            }
+            callbacks.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void native_start_async(const logger::AsyncOptions& options)
+{
+    native_async_logger::instance().start(options);
+}
+
+void native_stop_async()
+{
+    native_async_logger::instance().stop();
+}
+
+bool native_is_async()
+{
+    return native_async_logger::instance().enabled();
+}
+
+size_t native_async_dropped_count()
+{
+    return native_async_logger::instance().dropped();
+}
+
+void native_flush()
+{
+    native_async_logger::instance().flush();
+    auto&                  outputs = sinks();
+    const std::scoped_lock lock(outputs.mutex);
+    std::fflush(stderr);
+    for (auto& sink : outputs.files)
+    {
+        std::fflush(sink.file);
+    }
+    for (const auto& sink : outputs.callbacks)
+    {
+        if (sink.on_flush != nullptr)
+        {
+            sink.on_flush(sink.user_data);
+        }
+    }
 }
 
 int native_max_vlog_level()
@@ -115,6 +780,7 @@ int native_max_vlog_level()
 
 void native_fatal_exit()
 {
+    native_flush();
     std::abort();
 }
 
@@ -188,46 +854,177 @@ logger::LogScopeRAII::LogScopeRAII(
     (void)lineno;
     (void)format;
 #endif
+
+    // Shows the scope in Nsight and VTune timelines
+    if (quarisma::profiler::external_ranges::active())
+    {
+        std::array<char, 256> name{};
+        va_list               vlist;
+        va_start(vlist, format);
+        vsnprintf(name.data(), name.size(), format, vlist);
+        va_end(vlist);
+        quarisma::profiler::external_ranges::push(name.data());
+        external_range_ = true;
+    }
 }
 
 logger::LogScopeRAII::~LogScopeRAII()
 {
+    if (external_range_)
+    {
+        quarisma::profiler::external_ranges::pop();
+    }
     delete this->Internals;
 }
 //=============================================================================
 namespace detail
 {
 #if QUARISMA_HAS_LOGURU
-using scope_pair = std::pair<std::string, std::shared_ptr<loguru::LogScopeRAII>>;
-static std::mutex                                           g_mutex;
-static quarisma_map<std::thread::id, std::vector<scope_pair>> g_vectors;
-static std::vector<scope_pair>&                             get_vector()
+// The scopes opened with StartScope on one thread, innermost last. Each thread
+// owns its stack, so pushing and popping takes no lock; the first kInlineScopes
+// scopes are constructed in place and only deeper nesting, or an id longer than
+// kMaxIdLength - 1 characters, allocates.
+class scope_stack
+{
+public:
+    static constexpr size_t kInlineScopes = 32;
+    static constexpr size_t kMaxIdLength  = 64;
+
+    scope_stack() = default;
+    QUARISMA_DELETE_COPY_AND_MOVE(scope_stack)
+
+    // Closes the scopes left open when the thread exits, innermost first.
+    ~scope_stack()
+    {
+        while (size_ > 0)
+        {
+            pop();
+        }
+    }
+
+    // Opens a scope that logs `text`, or a silent one when `text` is null.
+    void push(
+        const char*       id,
+        const char*       text,
+        loguru::Verbosity verbosity,
+        const char*       fname,
+        unsigned int      lineno)
+    {
+        if (size_ < kInlineScopes)
+        {
+            entry& e    = inline_[size_];
+            e.id_length = std::strlen(id);
+            if (e.id_length < kMaxIdLength)
+            {
+                std::memcpy(e.id, id, e.id_length + 1);
+            }
+            else
+            {
+                e.long_id.assign(id, e.id_length);
+            }
+            if (text == nullptr)
+            {
+                new (e.storage) loguru::LogScopeRAII();
+            }
+            else
+            {
+                new (e.storage) loguru::LogScopeRAII(verbosity, fname, lineno, "%s", text);
+            }
+        }
+        else
+        {
+            overflow_.emplace_back(
+                std::string(id),
+                text == nullptr ? std::make_unique<loguru::LogScopeRAII>()
+                                : std::make_unique<loguru::LogScopeRAII>(
+                                      verbosity, fname, lineno, "%s", text));
+        }
+        ++size_;
+    }
+
+    bool empty() const { return size_ == 0; }
+
+    // Id of the innermost scope.
+    const char* top_id() const
+    {
+        if (size_ > kInlineScopes)
+        {
+            return overflow_.back().first.c_str();
+        }
+        const entry& e = inline_[size_ - 1];
+        return e.id_length < kMaxIdLength ? e.id : e.long_id.c_str();
+    }
+
+    // Compares the whole id, so ids sharing a long prefix stay distinct.
+    bool top_matches(const char* id) const
+    {
+        if (size_ > kInlineScopes)
+        {
+            return overflow_.back().first == id;
+        }
+        size_t const length = std::strlen(id);
+        return length == inline_[size_ - 1].id_length && std::memcmp(top_id(), id, length) == 0;
+    }
+
+    // Closes the innermost scope.
+    void pop()
+    {
+        if (size_ > kInlineScopes)
+        {
+            overflow_.pop_back();
+        }
+        else
+        {
+            std::launder(reinterpret_cast<loguru::LogScopeRAII*>(inline_[size_ - 1].storage))
+                ->~LogScopeRAII();
+        }
+        --size_;
+    }
+
+private:
+    struct entry
+    {
+        alignas(loguru::LogScopeRAII) unsigned char storage[sizeof(loguru::LogScopeRAII)];
+        char        id[kMaxIdLength];
+        size_t      id_length = 0;
+        std::string long_id;  // Holds ids of kMaxIdLength characters or more
+    };
+
+    std::array<entry, kInlineScopes> inline_;
+    size_t                           size_ = 0;
+    std::vector<std::pair<std::string, std::unique_ptr<loguru::LogScopeRAII>>> overflow_;
+};
+
+static scope_stack& get_scopes()
 {
-    const std::scoped_lock guard(g_mutex);
-    return g_vectors[std::this_thread::get_id()];
+    static thread_local scope_stack scopes;
+    return scopes;
 }
 
-static void push_scope(const char* id, std::shared_ptr<loguru::LogScopeRAII> ptr)
+static void push_scope(
+    const char*           id,
+    const char*           text      = nullptr,
+    logger_verbosity_enum verbosity = logger_verbosity_enum::VERBOSITY_OFF,
+    const char*           fname     = nullptr,
+    unsigned int          lineno    = 0)
 {
-    get_vector().emplace_back(std::string(id), ptr);
+    get_scopes().push(id, text, static_cast<loguru::Verbosity>(verbosity), fname, lineno);
 }
 
 static void pop_scope(const char* id)
 {
-    auto& vector = get_vector();
-    if (!vector.empty() && vector.back().first == id)
+    auto& scopes = get_scopes();
+    if (!scopes.empty() && scopes.top_matches(id))
     {
-        vector.pop_back();
-
-        if (vector.empty())
-        {
-            const std::scoped_lock guard(g_mutex);
-            g_vectors.erase(std::this_thread::get_id());
-        }
+        scopes.pop();
     }
     else
     {
-        LOG_F(ERROR, "Mismatched scope! expected (%s), got (%s)", vector.back().first.c_str(), id);
+        LOG_F(
+            ERROR,
+            "Mismatched scope! expected (%s), got (%s)",
+            scopes.empty() ? "" : scopes.top_id(),
+            id);
     }
 }
 static thread_local char ThreadName[128] = {};
@@ -257,6 +1054,7 @@ logger::~logger() = default;
 //------------------------------------------------------------------------------
 void logger::Init(int& argc, char* argv[], const char* verbosity_flag /*= "-v"*/)
 {
+    const startup_tracer::scope traced("logger::init");
 #if QUARISMA_HAS_LOGURU
     if (argc == 0)
     {  // loguru::init can't handle this case -- call the no-arg overload.
@@ -399,10 +1197,7 @@ void logger::LogToFile(const char* path, logger::FileMode filemode, logger_verbo
     }
     google::SetLogDestination(google::GLOG_INFO, path);
 #elif QUARISMA_HAS_NATIVE_LOGGING
-    // Native logging file support not implemented yet
-    (void)path;
-    (void)filemode;
-    (void)verbosity;
+    internal::native_add_file(path, filemode, verbosity);
 #else
     (void)path;
     (void)filemode;
@@ -420,7 +1215,7 @@ void logger::EndLogToFile(const char* path)
     // We can flush and close all log files
     google::FlushLogFiles(google::GLOG_INFO);
 #elif QUARISMA_HAS_NATIVE_LOGGING
-    (void)path;
+    internal::native_remove_file(path);
 #else
     (void)path;
 #endif
@@ -466,10 +1261,11 @@ namespace
 #if QUARISMA_HAS_LOGURU
 struct CallbackBridgeData
 {
-    logger::LogHandlerCallbackT   handler;
-    logger::CloseHandlerCallbackT close;
-    logger::FlushHandlerCallbackT flush;
-    void*                         inner_data;
+    logger::LogHandlerCallbackT        handler;
+    logger::CloseHandlerCallbackT      close;
+    logger::FlushHandlerCallbackT      flush;
+    void*                              inner_data;
+    logger::StructuredHandlerCallbackT structured_handler = nullptr;
 };
 
 void loguru_callback_bridge_handler(void* user_data, const loguru::Message& message)
@@ -489,6 +1285,33 @@ void loguru_callback_bridge_handler(void* user_data, const loguru::Message& mess
     data->handler(data->inner_data, quarisma_message);
 }
 
+// loguru runs callbacks on the logging thread, so the thread id and the time
+// are read here.
+void loguru_structured_bridge_handler(void* user_data, const loguru::Message& message)
+{
+    auto* data = reinterpret_cast<CallbackBridgeData*>(user_data);
+
+    const char* filename = message.filename;
+    for (const char* p = message.filename; *p; ++p)
+    {
+        if (*p == '/' || *p == '\\')
+        {
+            filename = p + 1;
+        }
+    }
+
+    const logger::StructuredMessage quarisma_message{
+        static_cast<logger_verbosity_enum>(message.verbosity),
+        filename,
+        message.line,
+        internal::current_thread_id(),
+        internal::wall_clock_ns(),
+        message.message,
+    };
+
+    data->structured_handler(data->inner_data, quarisma_message);
+}
+
 void loguru_callback_bridge_close(void* user_data)
 {
     auto* data = reinterpret_cast<CallbackBridgeData*>(user_data);
@@ -532,8 +1355,10 @@ void logger::AddCallback(
         static_cast<loguru::Verbosity>(verbosity),
         loguru_callback_bridge_close,
         loguru_callback_bridge_flush);
-#elif QUARISMA_HAS_GLOG || QUARISMA_HAS_NATIVE_LOGGING
-    // glog and native logging don't support custom callbacks in the same way
+#elif QUARISMA_HAS_NATIVE_LOGGING
+    internal::native_add_callback(id, callback, user_data, verbosity, on_close, on_flush);
+#elif QUARISMA_HAS_GLOG
+    // glog doesn't support custom callbacks in the same way
     // FIXME: Should we call the `close` callback with `user_data` to free any
     // resources expected to be passed in here?
     (void)id;
@@ -552,12 +1377,45 @@ void logger::AddCallback(
 #endif
 }
 
+//------------------------------------------------------------------------------
+void logger::AddStructuredCallback(
+    const char*                        id,
+    logger::StructuredHandlerCallbackT callback,
+    void*                              user_data,
+    logger_verbosity_enum              verbosity,
+    logger::CloseHandlerCallbackT      on_close,
+    logger::FlushHandlerCallbackT      on_flush)
+{
+#if QUARISMA_HAS_LOGURU
+    auto* callback_data = new CallbackBridgeData{nullptr, on_close, on_flush, user_data, callback};
+    loguru::add_callback(
+        id,
+        loguru_structured_bridge_handler,
+        callback_data,
+        static_cast<loguru::Verbosity>(verbosity),
+        loguru_callback_bridge_close,
+        loguru_callback_bridge_flush);
+#elif QUARISMA_HAS_NATIVE_LOGGING
+    internal::native_add_structured_callback(
+        id, callback, user_data, verbosity, on_close, on_flush);
+#else
+    (void)id;
+    (void)callback;
+    (void)user_data;
+    (void)verbosity;
+    (void)on_close;
+    (void)on_flush;
+#endif
+}
+
 //------------------------------------------------------------------------------
 bool logger::RemoveCallback(const char* id)
 {
 #if QUARISMA_HAS_LOGURU
     return loguru::remove_callback(id);
-#elif QUARISMA_HAS_GLOG || QUARISMA_HAS_NATIVE_LOGGING
+#elif QUARISMA_HAS_NATIVE_LOGGING
+    return internal::native_remove_callback(id);
+#elif QUARISMA_HAS_GLOG
     (void)id;
     return false;
 #else
@@ -566,6 +1424,62 @@ bool logger::RemoveCallback(const char* id)
 #endif
 }
 
+//------------------------------------------------------------------------------
+void logger::StartAsync()
+{
+    logger::StartAsync(AsyncOptions());
+}
+
+//------------------------------------------------------------------------------
+void logger::StartAsync(const AsyncOptions& options)
+{
+#if QUARISMA_HAS_NATIVE_LOGGING
+    internal::native_start_async(options);
+#else
+    (void)options;
+#endif
+}
+
+//------------------------------------------------------------------------------
+void logger::StopAsync()
+{
+#if QUARISMA_HAS_NATIVE_LOGGING
+    internal::native_stop_async();
+#endif
+}
+
+//------------------------------------------------------------------------------
+bool logger::IsAsync()
+{
+#if QUARISMA_HAS_NATIVE_LOGGING
+    return internal::native_is_async();
+#else
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+size_t logger::AsyncDroppedCount()
+{
+#if QUARISMA_HAS_NATIVE_LOGGING
+    return internal::native_async_dropped_count();
+#else
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+void logger::Flush()
+{
+#if QUARISMA_HAS_LOGURU
+    loguru::flush();
+#elif QUARISMA_HAS_GLOG
+    google::FlushLogFiles(google::GLOG_INFO);
+#elif QUARISMA_HAS_NATIVE_LOGGING
+    internal::native_flush();
+#endif
+}
+
 //------------------------------------------------------------------------------
 bool logger::IsEnabled()
 {
@@ -615,6 +1529,21 @@ void logger::Log(
 #endif
 }
 
+//------------------------------------------------------------------------------
+bool logger::LogDeferred(
+    QUARISMA_UNUSED const deferred_log_site& site,
+    QUARISMA_UNUSED size_t                   size,
+    QUARISMA_UNUSED DeferredEncodeT          encode,
+    QUARISMA_UNUSED const void*              args,
+    QUARISMA_UNUSED DeferredDecodeT          decode)
+{
+#if QUARISMA_HAS_NATIVE_LOGGING
+    return internal::native_log_deferred(site, size, encode, args, decode);
+#else
+    return false;
+#endif
+}
+
 //------------------------------------------------------------------------------
 void logger::LogF(
     logger_verbosity_enum verbosity,
@@ -643,12 +1572,14 @@ void logger::StartScope(
     logger_verbosity_enum verbosity, const char* id, const char* fname, unsigned int lineno)
 {
 #if QUARISMA_HAS_LOGURU
-    detail::push_scope(
-        id,
-        verbosity > logger::GetCurrentVerbosityCutoff()
-            ? std::make_shared<loguru::LogScopeRAII>()
-            : std::make_shared<loguru::LogScopeRAII>(
-                  static_cast<loguru::Verbosity>(verbosity), fname, lineno, "%s", id));
+    if (verbosity > logger::GetCurrentVerbosityCutoff())
+    {
+        detail::push_scope(id);
+    }
+    else
+    {
+        detail::push_scope(id, id, verbosity, fname, lineno);
+    }
 #elif QUARISMA_HAS_GLOG || QUARISMA_HAS_NATIVE_LOGGING
     // glog and native logging don't have built-in scope support
     // Just log the scope entry
@@ -686,7 +1617,7 @@ void logger::StartScopeF(
 #if QUARISMA_HAS_LOGURU
     if (verbosity > logger::GetCurrentVerbosityCutoff())
     {
-        detail::push_scope(id, std::make_shared<loguru::LogScopeRAII>());
+        detail::push_scope(id);
     }
     else
     {
@@ -696,10 +1627,7 @@ void logger::StartScopeF(
         vsnprintf(buffer, sizeof(buffer), format, vlist);
         va_end(vlist);
 
-        detail::push_scope(
-            id,
-            std::make_shared<loguru::LogScopeRAII>(
-                static_cast<loguru::Verbosity>(verbosity), fname, lineno, "%s", buffer));
+        detail::push_scope(id, buffer, verbosity, fname, lineno);
     }
 #elif QUARISMA_HAS_GLOG || QUARISMA_HAS_NATIVE_LOGGING
     va_list vlist;
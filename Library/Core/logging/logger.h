@@ -1,6 +1,11 @@
 #pragma once
 
-#include <string>  // for string
+#include <atomic>       // for atomic, memory_order_relaxed
+#include <chrono>       // for steady_clock, nanoseconds
+#include <cstddef>      // for size_t
+#include <cstdint>      // for int64_t, uint64_t
+#include <string>       // for string
+#include <string_view>  // for string_view
 
 #include "common/export.h"                  // for QUARISMA_API
 #include "common/macros.h"                  // for QUARISMA_DELETE_COPY_AND_MOVE
@@ -24,6 +29,8 @@
 
 namespace quarisma
 {
+struct deferred_log_site;
+
 class QUARISMA_VISIBILITY logger
 {
 public:
@@ -161,12 +168,100 @@ public:
 
 #endif  // #if !defined(__WRAP__)
 
+    /**
+   * The message structure passed to callbacks registered using
+   * `logger::AddStructuredCallback`. Nothing is formatted beyond the user
+   * message; the views point into the logger's buffers and are only valid
+   * during the call.
+   */
+    struct StructuredMessage
+    {
+        logger_verbosity_enum verbosity;
+        std::string_view      filename;      // Without the directories
+        unsigned              line;
+        uint64_t              thread_id;     // OS id of the thread that logged
+        int64_t               timestamp_ns;  // System clock, nanoseconds since the epoch
+        std::string_view      message;
+    };
+
+    using StructuredHandlerCallbackT = void (*)(void* user_data, const StructuredMessage& message);
+
+    /**
+   * Same as `AddCallback`, for a callback receiving the fields of each message
+   * instead of a formatted preamble. `RemoveCallback` removes it. With the
+   * native backend and `StartAsync`, it runs on the writer thread; the thread
+   * id and timestamp are still those of the logging call. Not supported with
+   * glog.
+   */
+    QUARISMA_API static void AddStructuredCallback(
+        const char*                id,
+        StructuredHandlerCallbackT callback,
+        void*                      user_data,
+        logger_verbosity_enum      verbosity,
+        CloseHandlerCallbackT      on_close = nullptr,
+        FlushHandlerCallbackT      on_flush = nullptr);
+
     /**
    * Remove a callback using the id specified.
    * Returns true if and only if the callback was found (and removed).
    */
     QUARISMA_API static bool RemoveCallback(const char* id);
 
+    /**
+   * What the asynchronous logger does with a message when its queue is full:
+   * `BLOCK` waits for the writer thread to make room, `DROP` discards the
+   * message, and `DROP_LOW_SEVERITY` discards it only when it is less severe
+   * than `AsyncOptions::keep_threshold` and blocks otherwise. FATAL messages
+   * are never dropped.
+   */
+    enum class OverflowPolicy
+    {
+        BLOCK,
+        DROP,
+        DROP_LOW_SEVERITY
+    };
+
+    /**
+   * Options of `logger::StartAsync`. The queue capacity is rounded up to a
+   * power of two.
+   */
+    struct AsyncOptions
+    {
+        size_t                queue_capacity  = 1024;
+        OverflowPolicy        overflow_policy = OverflowPolicy::BLOCK;
+        logger_verbosity_enum keep_threshold  = logger_verbosity_enum::VERBOSITY_WARNING;
+    };
+
+    ///@{
+    /**
+   * Move log output off the logging threads. Messages are queued in a bounded
+   * lock-free queue and a single writer thread writes them in batches to
+   * stderr, the files added with `LogToFile` and the callbacks added with
+   * `AddCallback`. A FATAL message is written out before the call logging it
+   * returns. `StopAsync` writes every queued message and joins the writer;
+   * it also runs at exit.
+   *
+   * Only the native backend supports asynchronous output; with loguru or glog
+   * these calls do nothing.
+   */
+    QUARISMA_API static void StartAsync();
+    QUARISMA_API static void StartAsync(const AsyncOptions& options);
+    QUARISMA_API static void StopAsync();
+    QUARISMA_API static bool IsAsync();
+    ///@}
+
+    /**
+   * Number of messages discarded by the overflow policy since the last
+   * `StartAsync`.
+   */
+    QUARISMA_API static size_t AsyncDroppedCount();
+
+    /**
+   * Block until every message logged so far has been written, then flush the
+   * log files and callbacks.
+   */
+    QUARISMA_API static void Flush();
+
     /**
    * Returns true if QUARISMA is built with logging support enabled.
    */
@@ -206,6 +301,18 @@ public:
     QUARISMA_API static void StartScope(
         logger_verbosity_enum verbosity, const char* id, const char* fname, unsigned int lineno);
     QUARISMA_API static void EndScope(const char* id);
+
+    using DeferredEncodeT = void (*)(char* out, const void* args);
+    using DeferredDecodeT = std::string (*)(const char* format, const char* data);
+
+    // Queues `size` bytes written by `encode` for the asynchronous writer, which
+    // formats them with `decode`. Returns false when asynchronous mode is off.
+    QUARISMA_API static bool LogDeferred(
+        const deferred_log_site& site,
+        size_t                   size,
+        DeferredEncodeT          encode,
+        const void*              args,
+        DeferredDecodeT          decode);
 #if !defined(__WRAP__)
     QUARISMA_API static void LogF(
         logger_verbosity_enum       verbosity,
@@ -234,9 +341,11 @@ public:
         QUARISMA_API ~LogScopeRAII();
 #if defined(_MSC_VER) && _MSC_VER > 1800
         // see loguru.hpp for the reason why this is needed on MSVC
-        LogScopeRAII(LogScopeRAII&& other) : Internals(other.Internals)
+        LogScopeRAII(LogScopeRAII&& other)
+            : Internals(other.Internals), external_range_(other.external_range_)
         {
-            other.Internals = nullptr;
+            other.Internals       = nullptr;
+            other.external_range_ = false;
         }
 #else
         LogScopeRAII(LogScopeRAII&&) = default;
@@ -246,7 +355,8 @@ public:
         LogScopeRAII(const LogScopeRAII&)   = delete;
         void operator=(const LogScopeRAII&) = delete;
         class LSInternals;
-        LSInternals* Internals = nullptr;
+        LSInternals* Internals       = nullptr;
+        bool         external_range_ = false;  ///< An NVTX/ITT range is open for the scope
     };
 #endif
     ///@}
@@ -274,6 +384,71 @@ protected:
 private:
     static logger_verbosity_enum InternalVerbosityLevel;
 };
+
+namespace logger_detail
+{
+// Per-call-site state of the sampled and rate-limited log macros. Each macro
+// expansion owns one static atomic, so call sites never contend with each other.
+
+inline int64_t steady_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// True for the 1st, (n+1)th, (2n+1)th, ... call.
+inline bool every_n(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    return n <= 1 || counter.fetch_add(1, std::memory_order_relaxed) % n == 0;
+}
+
+// True for the first n calls; later calls only read the counter.
+inline bool first_n(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    return counter.load(std::memory_order_relaxed) < n &&
+           counter.fetch_add(1, std::memory_order_relaxed) < n;
+}
+
+// True at most once per interval; `last_ns` starts at INT64_MIN.
+inline bool every_t(std::atomic<int64_t>& last_ns, int64_t interval_ns)
+{
+    const int64_t now  = steady_now_ns();
+    int64_t       last = last_ns.load(std::memory_order_relaxed);
+    if (last != INT64_MIN && now - last < interval_ns)
+    {
+        return false;
+    }
+    return last_ns.compare_exchange_strong(last, now, std::memory_order_relaxed);
+}
+
+// Token bucket of `burst` tokens refilled at `per_second`, kept as the single
+// theoretical arrival time of the generic cell rate algorithm: a call is
+// allowed when it does not push that time more than `burst` intervals ahead.
+inline bool rate_limit(std::atomic<int64_t>& tat_ns, double per_second, double burst)
+{
+    if (per_second <= 0.0)
+    {
+        return false;
+    }
+    const auto    interval = static_cast<int64_t>(1e9 / per_second);
+    const auto    limit    = static_cast<int64_t>(1e9 / per_second * burst);
+    const int64_t now      = steady_now_ns();
+    int64_t       tat      = tat_ns.load(std::memory_order_relaxed);
+    while (true)
+    {
+        const int64_t next = (tat > now ? tat : now) + interval;
+        if (next - now > limit)
+        {
+            return false;
+        }
+        if (tat_ns.compare_exchange_weak(tat, next, std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+}
+}  // namespace logger_detail
 }  // namespace quarisma
 
 ///@{
@@ -377,6 +552,119 @@ private:
     } while (0)
 ///@}
 
+///@{
+/**
+ * @brief Sampled and rate-limited logging macros.
+ *
+ * Each expansion keeps its own static atomic, so a message logged from every
+ * iteration of a parallel loop costs one relaxed atomic operation once it is
+ * suppressed. Messages below the verbosity cutoff are not counted.
+ *
+ * Examples:
+ *     QUARISMA_LOG_EVERY_N(WARNING, 1000, "Slow tick {}", tick);  // 1st, 1001st, ...
+ *     QUARISMA_LOG_FIRST_N(ERROR, 10, "Bad input {}", row);       // first 10 calls
+ *     QUARISMA_LOG_EVERY_T(INFO, 500, "Queue depth {}", depth);    // at most every 500 ms
+ *     QUARISMA_LOG_RATE_LIMITED(ERROR, 5, 20, "Reject {}", id);    // 5/s, bursts of 20
+ */
+
+/**
+ * @brief Log one call out of every n at the call site.
+ * @param verbosity_name Verbosity level name
+ * @param n Sampling period
+ * @param format_string Format string with {} placeholders
+ * @param ... Optional arguments to format
+ */
+#define QUARISMA_LOG_EVERY_N(verbosity_name, n, format_string, ...)                           \
+    do                                                                                        \
+    {                                                                                         \
+        static std::atomic<uint64_t> quarisma_log_counter{0};                                 \
+        if (quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name <=                    \
+                quarisma::logger::GetCurrentVerbosityCutoff() &&                              \
+            quarisma::logger_detail::every_n(quarisma_log_counter, static_cast<uint64_t>(n))) \
+        {                                                                                     \
+            quarisma::logger::Log(                                                            \
+                quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name,                  \
+                __FILE__,                                                                     \
+                __LINE__,                                                                     \
+                fmt::format(FMT_STRING(format_string), ##__VA_ARGS__).c_str());               \
+        }                                                                                     \
+    } while (0)
+
+/**
+ * @brief Log only the first n calls at the call site.
+ * @param verbosity_name Verbosity level name
+ * @param n Number of calls to log
+ * @param format_string Format string with {} placeholders
+ * @param ... Optional arguments to format
+ */
+#define QUARISMA_LOG_FIRST_N(verbosity_name, n, format_string, ...)                           \
+    do                                                                                        \
+    {                                                                                         \
+        static std::atomic<uint64_t> quarisma_log_counter{0};                                 \
+        if (quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name <=                    \
+                quarisma::logger::GetCurrentVerbosityCutoff() &&                              \
+            quarisma::logger_detail::first_n(quarisma_log_counter, static_cast<uint64_t>(n))) \
+        {                                                                                     \
+            quarisma::logger::Log(                                                            \
+                quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name,                  \
+                __FILE__,                                                                     \
+                __LINE__,                                                                     \
+                fmt::format(FMT_STRING(format_string), ##__VA_ARGS__).c_str());               \
+        }                                                                                     \
+    } while (0)
+
+/**
+ * @brief Log at most once every `ms` milliseconds at the call site.
+ * @param verbosity_name Verbosity level name
+ * @param ms Minimum interval between two messages, in milliseconds
+ * @param format_string Format string with {} placeholders
+ * @param ... Optional arguments to format
+ */
+#define QUARISMA_LOG_EVERY_T(verbosity_name, ms, format_string, ...)            \
+    do                                                                          \
+    {                                                                           \
+        static std::atomic<int64_t> quarisma_log_last_ns{INT64_MIN};            \
+        if (quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name <=      \
+                quarisma::logger::GetCurrentVerbosityCutoff() &&                \
+            quarisma::logger_detail::every_t(                                   \
+                quarisma_log_last_ns, static_cast<int64_t>((ms) * 1000000.0)))  \
+        {                                                                       \
+            quarisma::logger::Log(                                              \
+                quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name,    \
+                __FILE__,                                                       \
+                __LINE__,                                                       \
+                fmt::format(FMT_STRING(format_string), ##__VA_ARGS__).c_str()); \
+        }                                                                       \
+    } while (0)
+
+/**
+ * @brief Log through a per-call-site token bucket.
+ * @param verbosity_name Verbosity level name
+ * @param per_second Sustained messages per second
+ * @param burst Messages allowed back to back before the rate applies
+ * @param format_string Format string with {} placeholders
+ * @param ... Optional arguments to format
+ */
+#define QUARISMA_LOG_RATE_LIMITED(verbosity_name, per_second, burst, format_string, ...) \
+    do                                                                                   \
+    {                                                                                    \
+        static std::atomic<int64_t> quarisma_log_tat_ns{0};                              \
+        if (quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name <=               \
+                quarisma::logger::GetCurrentVerbosityCutoff() &&                         \
+            quarisma::logger_detail::rate_limit(                                         \
+                quarisma_log_tat_ns,                                                     \
+                static_cast<double>(per_second),                                         \
+                static_cast<double>(burst)))                                             \
+        {                                                                                \
+            quarisma::logger::Log(                                                       \
+                quarisma::logger_verbosity_enum::VERBOSITY_##verbosity_name,             \
+                __FILE__,                                                                \
+                __LINE__,                                                                \
+                fmt::format(FMT_STRING(format_string), ##__VA_ARGS__).c_str());          \
+        }                                                                                \
+    } while (0)
+///@}
+
 ///@{
 /**
  * @brief Scope logging macros for RAII-style logging.
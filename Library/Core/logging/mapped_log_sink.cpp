@@ -0,0 +1,421 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "logging/mapped_log_sink.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include "util/exception.h"
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace quarisma
+{
+namespace
+{
+const char* severity_name(logger_verbosity_enum severity)
+{
+    switch (severity)
+    {
+    case logger_verbosity_enum::VERBOSITY_FATAL:
+        return "FATAL";
+    case logger_verbosity_enum::VERBOSITY_ERROR:
+        return "ERROR";
+    case logger_verbosity_enum::VERBOSITY_WARNING:
+        return "WARNING";
+    case logger_verbosity_enum::VERBOSITY_INFO:
+        return "INFO";
+    default:
+        return "VLOG";
+    }
+}
+
+int64_t wall_clock_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+int process_id()
+{
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+}  // namespace
+
+mapped_log_sink::mapped_log_sink(Options opts)
+    : opts_(std::move(opts)),
+      segment_bytes_(
+          (std::max<size_t>(opts_.segment_bytes, 1) + mmap_buffer::page_size() - 1) /
+          mmap_buffer::page_size() * mmap_buffer::page_size())
+{
+    if (opts_.compression != compression::codec_type::none)
+    {
+        codec_ = compression::codec::get(opts_.compression);
+        QUARISMA_CHECK(
+            codec_ != nullptr,
+            "mapped_log_sink: codec {} is not built in",
+            static_cast<int>(opts_.compression));
+    }
+
+    std::filesystem::create_directories(opts_.directory);
+    auto const started =
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    base_name_ = (std::filesystem::path(opts_.directory) /
+                  fmt::format("{}.{}.{}.", opts_.prefix, started, process_id()))
+                     .string();
+
+    current_           = open_segment(0);
+    current_.opened_ns = wall_clock_ns();
+    next_index_        = 1;
+    worker_            = std::thread([this] { run(); });
+}
+
+mapped_log_sink::~mapped_log_sink()
+{
+    detach();
+    {
+        std::scoped_lock const lock(mutex_, work_mutex_);
+        closed_.push_back(std::move(current_));
+        stopping_ = true;
+    }
+    work_.notify_one();
+    worker_.join();
+
+    std::scoped_lock const lock(work_mutex_);
+    if (spare_ready_)
+    {
+        std::error_code ec;
+        spare_.mapping.reset();
+        std::filesystem::remove(spare_.path, ec);
+    }
+}
+
+void mapped_log_sink::attach(logger_verbosity_enum verbosity)
+{
+    if (!attached_.exchange(true))
+    {
+        logger::AddStructuredCallback(opts_.callback_id.c_str(), on_message, this, verbosity);
+    }
+}
+
+void mapped_log_sink::detach()
+{
+    // Not under mutex_: removing the callback waits for the async writer,
+    // which may be in write()
+    if (attached_.exchange(false))
+    {
+        logger::RemoveCallback(opts_.callback_id.c_str());
+    }
+}
+
+void mapped_log_sink::on_message(void* user_data, const logger::StructuredMessage& message)
+{
+    static_cast<mapped_log_sink*>(user_data)->write(message);
+}
+
+void mapped_log_sink::write(const logger::StructuredMessage& message)
+{
+    // Formatted before taking the lock; the buffer only allocates while it grows
+    thread_local fmt::memory_buffer line;
+    line.clear();
+    fmt::format_to(
+        std::back_inserter(line),
+        "{}.{:09} {} [{}] {}:{} {}\n",
+        message.timestamp_ns / 1000000000,
+        message.timestamp_ns % 1000000000,
+        message.thread_id,
+        severity_name(message.verbosity),
+        message.filename,
+        message.line,
+        message.message);
+
+    size_t size = line.size();
+    if (size > segment_bytes_)
+    {
+        size                  = segment_bytes_;
+        line.data()[size - 1] = '\n';
+        truncated_lines_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::scoped_lock const lock(mutex_);
+    bool const expired =
+        opts_.max_segment_age.count() > 0 &&
+        message.timestamp_ns - current_.opened_ns >=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(opts_.max_segment_age).count();
+    // An empty mapping is a segment that could not be created: try again
+    if (current_.mapping.empty() ||
+        (current_.used > 0 && (expired || current_.used + size > segment_bytes_)))
+    {
+        rotate_locked(message.timestamp_ns);
+    }
+    if (current_.mapping.empty())
+    {
+        dropped_lines_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::memcpy(static_cast<char*>(current_.mapping.data()) + current_.used, line.data(), size);
+    current_.used += size;
+    lines_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(size, std::memory_order_relaxed);
+}
+
+void mapped_log_sink::rotate()
+{
+    std::scoped_lock const lock(mutex_);
+    if (current_.used > 0)
+    {
+        rotate_locked(wall_clock_ns());
+    }
+}
+
+void mapped_log_sink::rotate_locked(int64_t now_ns)
+{
+    segment  next;
+    uint64_t index = 0;
+    {
+        std::unique_lock<std::mutex> lock(work_mutex_);
+        // A spare being mapped is nearly ready, and taking the next index
+        // instead would number the segments out of order
+        idle_.wait(lock, [&] { return !spare_pending_; });
+
+        closed_.push_back(std::move(current_));
+        if (spare_ready_)
+        {
+            next         = std::move(spare_);
+            spare_ready_ = false;
+        }
+        else
+        {
+            index = next_index_++;
+        }
+        want_spare_ = true;
+    }
+    work_.notify_one();
+
+    if (next.mapping.empty())
+    {
+        sync_rotations_.fetch_add(1, std::memory_order_relaxed);
+        try
+        {
+            next = open_segment(index);
+        }
+        catch (const std::exception& e)
+        {
+            // Not logged: this runs inside the logger
+            fmt::print(stderr, "[ERROR] mapped_log_sink: {}\n", e.what());
+        }
+    }
+    current_           = std::move(next);
+    current_.opened_ns = now_ns;
+}
+
+mapped_log_sink::segment mapped_log_sink::open_segment(uint64_t index) const
+{
+    segment s;
+    s.path = fmt::format("{}{:06}.log", base_name_, index);
+
+    std::error_code ec;
+    std::filesystem::remove(s.path, ec);
+
+    mmap_buffer::Options opts;
+    opts.writable = true;
+    opts.size     = segment_bytes_;
+    opts.access   = mmap_access::SEQUENTIAL;
+    s.mapping     = mmap_buffer::open(s.path, opts);
+    return s;
+}
+
+void mapped_log_sink::finalize(segment& closed) const
+{
+    if (closed.mapping.empty())
+    {
+        return;
+    }
+
+    std::string compressed;
+    if (codec_ != nullptr && closed.used > 0)
+    {
+        QUARISMA_CHECK(
+            codec_->compress(
+                static_cast<const char*>(closed.mapping.data()), closed.used, &compressed),
+            "mapped_log_sink: failed to compress {}",
+            closed.path);
+    }
+    closed.mapping.reset();
+
+    if (closed.used == 0)
+    {
+        std::filesystem::remove(closed.path);
+        closed.path.clear();
+        return;
+    }
+    if (codec_ == nullptr)
+    {
+        std::filesystem::resize_file(closed.path, closed.used);
+        return;
+    }
+
+    std::string const path = closed.path + "." + codec_->name();
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+        QUARISMA_CHECK(out.good(), "mapped_log_sink: failed to write {}", path);
+    }
+    std::filesystem::remove(closed.path);
+    closed.path = path;
+}
+
+void mapped_log_sink::run()
+{
+    size_t const page = mmap_buffer::page_size();
+
+    std::unique_lock<std::mutex> lock(work_mutex_);
+    while (true)
+    {
+        // The spare first: a rotation may be waiting for it
+        if (want_spare_ && !spare_ready_ && !stopping_)
+        {
+            uint64_t const index = next_index_++;
+            want_spare_          = false;
+            spare_pending_       = true;
+            lock.unlock();
+
+            segment spare;
+            try
+            {
+                spare = open_segment(index);
+                // Faults the pages in, so that the logging threads do not
+                auto* data = static_cast<volatile char*>(spare.mapping.data());
+                for (size_t offset = 0; offset < spare.mapping.size(); offset += page)
+                {
+                    data[offset] = 0;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                fmt::print(stderr, "[ERROR] mapped_log_sink: {}\n", e.what());
+            }
+
+            lock.lock();
+            spare_pending_ = false;
+            if (!spare.mapping.empty())
+            {
+                spare_       = std::move(spare);
+                spare_ready_ = true;
+            }
+            idle_.notify_all();
+            continue;
+        }
+
+        if (!closed_.empty())
+        {
+            segment closed = std::move(closed_.front());
+            closed_.pop_front();
+            busy_ = true;
+            lock.unlock();
+
+            try
+            {
+                finalize(closed);
+            }
+            catch (const std::exception& e)
+            {
+                fmt::print(stderr, "[ERROR] mapped_log_sink: {}\n", e.what());
+            }
+
+            lock.lock();
+            busy_ = false;
+            if (!closed.path.empty())
+            {
+                finalized_.push_back(std::move(closed.path));
+                segments_.fetch_add(1, std::memory_order_relaxed);
+            }
+            idle_.notify_all();
+            continue;
+        }
+
+        if (stopping_)
+        {
+            break;
+        }
+        work_.wait(lock);
+    }
+}
+
+void mapped_log_sink::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(work_mutex_);
+    idle_.wait(lock, [&] { return closed_.empty() && !busy_; });
+}
+
+void mapped_log_sink::sync()
+{
+    std::scoped_lock const lock(mutex_);
+    if (!current_.mapping.empty())
+    {
+        current_.mapping.sync();
+    }
+}
+
+std::vector<std::string> mapped_log_sink::closed_segments() const
+{
+    std::scoped_lock const lock(work_mutex_);
+    return finalized_;
+}
+
+std::string mapped_log_sink::current_segment() const
+{
+    std::scoped_lock const lock(mutex_);
+    return current_.path;
+}
+
+mapped_log_sink_stats mapped_log_sink::stats() const noexcept
+{
+    mapped_log_sink_stats stats;
+    stats.lines           = lines_.load(std::memory_order_relaxed);
+    stats.bytes           = bytes_.load(std::memory_order_relaxed);
+    stats.segments        = segments_.load(std::memory_order_relaxed);
+    stats.sync_rotations  = sync_rotations_.load(std::memory_order_relaxed);
+    stats.truncated_lines = truncated_lines_.load(std::memory_order_relaxed);
+    stats.dropped_lines   = dropped_lines_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace quarisma
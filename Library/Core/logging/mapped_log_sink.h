@@ -0,0 +1,217 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/export.h"
+#include "common/macros.h"
+#include "compression/codec.h"
+#include "logging/logger.h"
+#include "memory/backend/allocator_mmap.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief Counters of a mapped_log_sink.
+ */
+struct mapped_log_sink_stats
+{
+    uint64_t lines           = 0;  ///< Lines written
+    uint64_t bytes           = 0;  ///< Bytes written, before compression
+    uint64_t segments        = 0;  ///< Segments closed and finalized
+    uint64_t sync_rotations  = 0;  ///< Rotations that had to map the next segment inline
+    uint64_t truncated_lines = 0;  ///< Lines longer than a segment, cut to fit
+    uint64_t dropped_lines   = 0;  ///< Lines lost because no segment could be created
+};
+
+/**
+ * @brief Log sink writing into memory-mapped, pre-sized file segments.
+ *
+ * A line is a memcpy into the mapping of the current segment: no write()
+ * call and no fflush() per message, and the lines are in the page cache,
+ * so a crash of the process loses none of them. The segment files are named
+ * `<directory>/<prefix>.<start time>.<pid>.<index>.log` and hold lines in the
+ * format `<seconds>.<nanoseconds> <thread id> [<severity>] <file>:<line> <message>`.
+ *
+ * A segment is closed once full, or once older than Options::max_segment_age
+ * when the next line comes. A background thread keeps the next segment
+ * mapped and its pages faulted in, so switching to it is a pointer swap; it
+ * also finalizes the closed segments off the logging path: truncates them to
+ * the bytes written, unmaps them and, with Options::compression, replaces
+ * them by `<segment>.log.<codec name>`. A segment cut short by a crash is
+ * padded with NUL bytes after its last line.
+ *
+ * attach() registers the sink as a logger structured callback, so with
+ * logger::StartAsync() the lines are written by the async writer thread.
+ *
+ * Example:
+ * ```cpp
+ * mapped_log_sink::Options opts;
+ * opts.directory     = "/var/log/pricer";
+ * opts.segment_bytes = size_t{256} << 20;
+ * opts.compression   = compression::codec_type::snappy;
+ *
+ * mapped_log_sink sink(opts);
+ * sink.attach(logger_verbosity_enum::VERBOSITY_TRACE);
+ * logger::StartAsync();
+ * ```
+ *
+ * **Thread Safety**: write() and the other members are thread-safe.
+ */
+class QUARISMA_VISIBILITY mapped_log_sink
+{
+public:
+    /**
+     * @brief Configuration options for mapped_log_sink.
+     */
+    struct Options
+    {
+        /** @brief Directory of the segments, created if missing. */
+        std::string directory = ".";
+
+        /** @brief First part of the segment file names. */
+        std::string prefix = "quarisma";
+
+        /**
+         * @brief Size of a segment, rounded up to mmap_buffer::page_size().
+         *
+         * **Default**: 64 MiB
+         */
+        size_t segment_bytes = size_t{64} << 20;
+
+        /**
+         * @brief Age after which a segment is closed, or zero to rotate on size only.
+         *
+         * **Default**: 0
+         */
+        std::chrono::seconds max_segment_age{0};
+
+        /**
+         * @brief Codec compressing the closed segments; none keeps them as is.
+         *
+         * **Default**: none
+         */
+        compression::codec_type compression = compression::codec_type::none;
+
+        /** @brief Id of the logger callback registered by attach(). */
+        std::string callback_id = "mapped_log_sink";
+    };
+
+    /**
+     * @brief Creates the directory and maps the first segment.
+     *
+     * @throws quarisma::exception when the codec is not built in, or when the
+     *         first segment cannot be created
+     */
+    QUARISMA_API explicit mapped_log_sink(Options opts);
+
+    /** @brief Detaches, then closes and finalizes the current segment. */
+    QUARISMA_API ~mapped_log_sink();
+
+    /** @brief Receives the messages up to `verbosity` from the logger. */
+    QUARISMA_API void attach(logger_verbosity_enum verbosity);
+
+    /** @brief Stops receiving messages; queued async messages are written first. */
+    QUARISMA_API void detach();
+
+    /** @brief Appends one line. */
+    QUARISMA_API void write(const logger::StructuredMessage& message);
+
+    /** @brief Closes the current segment even if it has room left. */
+    QUARISMA_API void rotate();
+
+    /** @brief Waits until every closed segment is finalized. */
+    QUARISMA_API void wait_idle();
+
+    /** @brief Writes the current segment back to its file and waits for the writes. */
+    QUARISMA_API void sync();
+
+    /** @brief Paths of the finalized segments, oldest first. */
+    QUARISMA_API std::vector<std::string> closed_segments() const;
+
+    /** @brief Path of the segment being written. */
+    QUARISMA_API std::string current_segment() const;
+
+    QUARISMA_API mapped_log_sink_stats stats() const noexcept;
+
+    QUARISMA_DELETE_COPY_AND_MOVE(mapped_log_sink);
+
+private:
+    struct segment
+    {
+        std::string path;
+        mmap_buffer mapping;
+        size_t      used      = 0;
+        int64_t     opened_ns = 0;
+    };
+
+    segment open_segment(uint64_t index) const;
+    void    rotate_locked(int64_t now_ns) QUARISMA_NO_THREAD_SAFETY_ANALYSIS;
+    void    finalize(segment& closed) const;
+    void    run();
+
+    static void on_message(void* user_data, const logger::StructuredMessage& message);
+
+    const Options             opts_;
+    const size_t              segment_bytes_;
+    const compression::codec* codec_ = nullptr;
+    std::string               base_name_;  // Path of the segments up to the index
+
+    std::atomic<bool> attached_{false};
+
+    mutable std::mutex mutex_;  // Taken before work_mutex_
+    segment            current_ QUARISMA_GUARDED_BY(mutex_);
+
+    // Shared with the background thread. Segments are numbered in the order
+    // they are opened, whichever thread opens them.
+    mutable std::mutex       work_mutex_;
+    std::condition_variable  work_;
+    std::condition_variable  idle_;
+    uint64_t                 next_index_ QUARISMA_GUARDED_BY(work_mutex_) = 0;
+    segment                  spare_ QUARISMA_GUARDED_BY(work_mutex_);
+    bool                     want_spare_ QUARISMA_GUARDED_BY(work_mutex_)    = true;
+    bool                     spare_pending_ QUARISMA_GUARDED_BY(work_mutex_) = false;
+    bool                     spare_ready_ QUARISMA_GUARDED_BY(work_mutex_)   = false;
+    std::deque<segment>      closed_ QUARISMA_GUARDED_BY(work_mutex_);
+    std::vector<std::string> finalized_ QUARISMA_GUARDED_BY(work_mutex_);
+    bool                     busy_ QUARISMA_GUARDED_BY(work_mutex_)     = false;
+    bool                     stopping_ QUARISMA_GUARDED_BY(work_mutex_) = false;
+    std::thread              worker_;
+
+    std::atomic<uint64_t> lines_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> segments_{0};
+    std::atomic<uint64_t> sync_rotations_{0};
+    std::atomic<uint64_t> truncated_lines_{0};
+    std::atomic<uint64_t> dropped_lines_{0};
+};
+
+}  // namespace quarisma
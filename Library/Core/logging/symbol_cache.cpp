@@ -0,0 +1,427 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "logging/symbol_cache.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/env.h"
+#include "util/flat_hash.h"
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "parallel/parallel_tools.h"
+#include "profiler/common/unwind/fast_symbolizer.h"
+#include "util/string_util.h"
+#endif
+
+namespace quarisma
+{
+
+#if defined(__linux__)
+namespace
+{
+
+// Library containing addr and the offset of addr past its load address
+bool library_of(const void* addr, std::string& path, uint64_t& load_address, uint64_t& offset)
+{
+    Dl_info   info;
+    link_map* map = nullptr;
+    if (dladdr1(addr, &info, reinterpret_cast<void**>(&map), RTLD_DL_LINKMAP) == 0 ||
+        map == nullptr)
+    {
+        return false;
+    }
+
+    path = map->l_name != nullptr ? map->l_name : "";
+    if (path.empty())
+    {
+        // The main program
+        char          name[PATH_MAX + 1];
+        ssize_t const length = readlink("/proc/self/exe", name, PATH_MAX);
+        if (length <= 0)
+        {
+            return false;
+        }
+        path.assign(name, static_cast<size_t>(length));
+    }
+    load_address = map->l_addr;
+    offset       = reinterpret_cast<uint64_t>(addr) - map->l_addr;
+    return true;
+}
+
+// Hex GNU build id of the loaded library at load_address, empty if it has none
+std::string build_id_of(uint64_t load_address)
+{
+    struct search
+    {
+        uint64_t    load_address;
+        std::string build_id;
+    } state{load_address, {}};
+
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, size_t /*size*/, void* data)
+        {
+            auto& s = *static_cast<search*>(data);
+            if (info->dlpi_addr != s.load_address)
+            {
+                return 0;
+            }
+            for (int i = 0; i < info->dlpi_phnum; ++i)
+            {
+                const ElfW(Phdr)& segment = info->dlpi_phdr[i];
+                if (segment.p_type != PT_NOTE)
+                {
+                    continue;
+                }
+                const char* p =
+                    reinterpret_cast<const char*>(info->dlpi_addr + segment.p_vaddr);
+                const char* const end = p + segment.p_memsz;
+                while (p + sizeof(ElfW(Nhdr)) <= end)
+                {
+                    ElfW(Nhdr) note;
+                    std::memcpy(&note, p, sizeof(note));
+                    const char*  name = p + sizeof(note);
+                    const char*  desc = name + ((note.n_namesz + 3) & ~3U);
+                    const size_t next = (note.n_descsz + 3) & ~3U;
+                    if (desc + note.n_descsz > end)
+                    {
+                        break;
+                    }
+                    if (note.n_type == NT_GNU_BUILD_ID && note.n_namesz == 4 &&
+                        std::memcmp(name, "GNU", 4) == 0)
+                    {
+                        static constexpr char digits[] = "0123456789abcdef";
+                        for (uint32_t b = 0; b < note.n_descsz; ++b)
+                        {
+                            auto const byte = static_cast<unsigned char>(desc[b]);
+                            s.build_id += digits[byte >> 4];
+                            s.build_id += digits[byte & 15];
+                        }
+                        return 1;
+                    }
+                    p = desc + next;
+                }
+            }
+            return 1;
+        },
+        &state);
+    return state.build_id;
+}
+
+// A record of the disk cache: u64 offset, u64 line, u32 function and file
+// lengths, then the two strings
+void append_record(std::string& out, uint64_t offset, const symbol_info& symbol)
+{
+    uint64_t const numbers[] = {offset, symbol.line};
+    uint32_t const lengths[] = {
+        static_cast<uint32_t>(symbol.function.size()), static_cast<uint32_t>(symbol.file.size())};
+    out.append(reinterpret_cast<const char*>(numbers), sizeof(numbers));
+    out.append(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+    out += symbol.function;
+    out += symbol.file;
+}
+
+// Reads the records of a disk cache file, stopping at a truncated one
+void read_records(
+    const std::string&                         path,
+    const std::string&                         library,
+    std::unordered_map<uint64_t, symbol_info>& frames)
+{
+    std::ifstream     in(path, std::ios::binary);
+    std::string const bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    constexpr size_t header = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+    size_t           pos    = 0;
+    while (pos + header <= bytes.size())
+    {
+        uint64_t numbers[2];
+        uint32_t lengths[2];
+        std::memcpy(numbers, bytes.data() + pos, sizeof(numbers));
+        std::memcpy(lengths, bytes.data() + pos + sizeof(numbers), sizeof(lengths));
+        pos += header;
+        if (pos + lengths[0] + lengths[1] > bytes.size())
+        {
+            break;
+        }
+
+        symbol_info symbol;
+        symbol.function.assign(bytes, pos, lengths[0]);
+        symbol.file.assign(bytes, pos + lengths[0], lengths[1]);
+        symbol.line    = numbers[1];
+        symbol.library = library;
+        symbol.offset  = numbers[0];
+        pos += lengths[0] + lengths[1];
+        frames.emplace(numbers[0], std::move(symbol));
+    }
+}
+
+// Appends in one write, so that processes sharing the directory do not
+// interleave their records
+void append_file(const std::string& path, const std::string& bytes)
+{
+    int const fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return;
+    }
+    [[maybe_unused]] ssize_t const written = ::write(fd, bytes.data(), bytes.size());
+    ::close(fd);
+}
+
+}  // namespace
+#endif  // __linux__
+
+struct symbol_cache::impl
+{
+#if defined(__linux__)
+    // Frames of one library, by offset; resolved under the library's own lock
+    struct library
+    {
+        std::mutex                                mutex;
+        std::string                               path;
+        std::string                               cache_file;  // Empty: memory only
+        bool                                      loaded = false;
+        std::unordered_map<uint64_t, symbol_info> frames;
+        unwind::FastSymbolizer                    symbolizer;
+    };
+
+    std::unordered_map<std::string, std::unique_ptr<library>> libraries;
+#endif
+
+    mutable std::shared_mutex         mutex;
+    flat_hash_map<void*, symbol_info> addresses;
+    std::string                       directory;
+
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> disk_hits{0};
+    std::atomic<size_t> resolutions{0};
+};
+
+symbol_cache::symbol_cache() : impl_(std::make_unique<impl>())
+{
+    if (auto directory = utils::get_env("QUARISMA_SYMBOL_CACHE_DIR"))
+    {
+        impl_->directory = std::move(*directory);
+    }
+}
+
+symbol_cache::~symbol_cache() = default;
+
+symbol_cache& symbol_cache::instance()
+{
+    // Never destroyed: exceptions thrown during static destruction still symbolize
+    static auto* cache = new symbol_cache();
+    return *cache;
+}
+
+void symbol_cache::set_directory(const std::string& directory)
+{
+    std::unique_lock<std::shared_mutex> const lock(impl_->mutex);
+    impl_->directory = directory;
+}
+
+std::string symbol_cache::directory() const
+{
+    std::shared_lock<std::shared_mutex> const lock(impl_->mutex);
+    return impl_->directory;
+}
+
+symbol_cache::statistics symbol_cache::stats() const
+{
+    statistics result;
+    result.hits        = impl_->hits.load(std::memory_order_relaxed);
+    result.disk_hits   = impl_->disk_hits.load(std::memory_order_relaxed);
+    result.resolutions = impl_->resolutions.load(std::memory_order_relaxed);
+    return result;
+}
+
+std::vector<symbol_info> symbol_cache::resolve(const std::vector<void*>& addresses)
+{
+    std::vector<symbol_info> result(addresses.size(), symbol_info{"??", {}, 0, {}, 0});
+    std::vector<size_t>      missing;
+    {
+        std::shared_lock<std::shared_mutex> const lock(impl_->mutex);
+        for (size_t i = 0; i < addresses.size(); ++i)
+        {
+            auto const it = impl_->addresses.find(addresses[i]);
+            if (it != impl_->addresses.end())
+            {
+                result[i] = it->second;
+            }
+            else
+            {
+                missing.push_back(i);
+            }
+        }
+    }
+    impl_->hits.fetch_add(addresses.size() - missing.size(), std::memory_order_relaxed);
+
+#if defined(__linux__)
+    if (missing.empty())
+    {
+        return result;
+    }
+
+    // The missing addresses of each library, with their offsets
+    struct request
+    {
+        impl::library*                          library;
+        std::vector<std::pair<size_t, uint64_t>> lookups;
+    };
+    std::vector<request> requests;
+    {
+        std::unordered_map<impl::library*, size_t> request_of;
+        std::unique_lock<std::shared_mutex> const  lock(impl_->mutex);
+        for (size_t const i : missing)
+        {
+            std::string path;
+            uint64_t    load_address = 0;
+            uint64_t    offset       = 0;
+            if (addresses[i] == nullptr || !library_of(addresses[i], path, load_address, offset))
+            {
+                continue;
+            }
+
+            auto& entry = impl_->libraries[path];
+            if (!entry)
+            {
+                entry       = std::make_unique<impl::library>();
+                entry->path = path;
+                if (!impl_->directory.empty())
+                {
+                    std::string const build_id = build_id_of(load_address);
+                    if (!build_id.empty())
+                    {
+                        ::mkdir(impl_->directory.c_str(), 0755);
+                        entry->cache_file = impl_->directory + "/" + build_id + ".sym";
+                    }
+                }
+            }
+
+            auto const [it, inserted] = request_of.emplace(entry.get(), requests.size());
+            if (inserted)
+            {
+                requests.push_back({entry.get(), {}});
+            }
+            // Look up the call instruction rather than the return address
+            requests[it->second].lookups.emplace_back(i, offset - 1);
+        }
+    }
+
+    // Libraries are independent, each guarded by its own lock
+    parallel_tools::parallel_for(
+        0,
+        requests.size(),
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t r = begin; r < end; ++r)
+            {
+                impl::library&              library = *requests[r].library;
+                std::lock_guard<std::mutex> lock(library.mutex);
+                if (!library.loaded)
+                {
+                    if (!library.cache_file.empty())
+                    {
+                        read_records(library.cache_file, library.path, library.frames);
+                    }
+                    library.loaded = true;
+                }
+
+                std::string new_records;
+                for (auto const& [index, offset] : requests[r].lookups)
+                {
+                    auto const it = library.frames.find(offset);
+                    if (it != library.frames.end())
+                    {
+                        result[index] = it->second;
+                        impl_->disk_hits.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    symbol_info symbol{"??", {}, 0, library.path, offset};
+                    try
+                    {
+                        unwind::Frame frame = library.symbolizer.symbolize(library.path, offset);
+                        symbol.function     = std::move(frame.funcname);
+                        // Without a line table the symbolizer returns the library and offset
+                        if (frame.filename != library.path || frame.lineno != offset)
+                        {
+                            symbol.file = std::move(frame.filename);
+                            symbol.line = frame.lineno;
+                        }
+                    }
+                    catch (...)
+                    {
+                        // Unreadable library: keep the library and offset only
+                    }
+                    if (symbol.function == "??")
+                    {
+                        Dl_info info;
+                        if (dladdr(addresses[index], &info) != 0 && info.dli_sname != nullptr)
+                        {
+                            symbol.function = demangle(info.dli_sname);
+                        }
+                    }
+                    impl_->resolutions.fetch_add(1, std::memory_order_relaxed);
+
+                    if (!library.cache_file.empty())
+                    {
+                        append_record(new_records, offset, symbol);
+                    }
+                    result[index] = symbol;
+                    library.frames.emplace(offset, std::move(symbol));
+                }
+                if (!new_records.empty())
+                {
+                    append_file(library.cache_file, new_records);
+                }
+            }
+        });
+
+    std::unique_lock<std::shared_mutex> const lock(impl_->mutex);
+    for (size_t const i : missing)
+    {
+        impl_->addresses.emplace(addresses[i], result[i]);
+    }
+#endif  // __linux__
+
+    return result;
+}
+
+}  // namespace quarisma
@@ -0,0 +1,108 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief Source location of a code address
+ */
+struct symbol_info
+{
+    std::string function;    ///< Demangled function name, "??" when unknown
+    std::string file;        ///< Source file, empty when there is no line information
+    uint64_t    line   = 0;  ///< Source line, 0 when there is no line information
+    std::string library;     ///< Executable or shared library, empty when unknown
+    uint64_t    offset = 0;  ///< Offset of the looked-up byte in the library
+};
+
+/**
+ * @brief Process-wide cache of symbolized code addresses
+ *
+ * back_trace, the exception backtraces that go through it, and
+ * unwind::symbolize() (used by the memory and sampling profilers) all resolve
+ * addresses here, so each address has its DWARF looked up once per process.
+ *
+ * Addresses missing from the cache are grouped by library and the libraries
+ * are resolved in parallel, each by a DWARF reader that stays alive between
+ * calls so a library is parsed only once. When a cache directory is set (by
+ * default from QUARISMA_SYMBOL_CACHE_DIR), the resolved frames of each library
+ * are also appended to `<directory>/<build-id>.sym`. Later processes running
+ * the same binary then read them back instead of parsing its DWARF again.
+ * Libraries without a GNU build id are cached in memory only.
+ *
+ * Symbolization needs ELF and DWARF, so it is available on Linux only;
+ * elsewhere resolve() returns "??" frames.
+ *
+ * **Thread Safety**: All member functions are thread-safe
+ */
+class QUARISMA_VISIBILITY symbol_cache
+{
+public:
+    struct statistics
+    {
+        size_t hits        = 0;  ///< Addresses found in memory
+        size_t disk_hits   = 0;  ///< Addresses read from the disk cache
+        size_t resolutions = 0;  ///< Addresses resolved from DWARF
+    };
+
+    /** The cache shared by the whole process. */
+    QUARISMA_API static symbol_cache& instance();
+
+    /**
+     * @brief Resolves each address to its function, source file and line
+     *
+     * Addresses are taken as return addresses: each is looked up one byte
+     * earlier, inside the call instruction, so that a call at the very end of
+     * a function is not attributed to the next one.
+     */
+    QUARISMA_API std::vector<symbol_info> resolve(const std::vector<void*>& addresses);
+
+    /**
+     * @brief Sets the directory of the on-disk cache; empty disables it
+     *
+     * Libraries already resolved in this process are not written again.
+     */
+    QUARISMA_API void set_directory(const std::string& directory);
+
+    QUARISMA_API std::string directory() const;
+
+    QUARISMA_API statistics stats() const;
+
+    QUARISMA_DELETE_COPY_AND_MOVE(symbol_cache);
+
+private:
+    symbol_cache();
+    ~symbol_cache();
+
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+}  // namespace quarisma
@@ -0,0 +1,335 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+// Kernels of math/lu.h. This file is compiled once per cpu_capability (see
+// util/cpu_dispatch.h), so everything but the registrations stays in the
+// anonymous namespace.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+#include "math/lu_dispatch.h"
+#include "util/cpu_topology.h"
+#include "util/simd/vec.h"
+
+namespace quarisma
+{
+namespace linalg
+{
+namespace detail
+{
+namespace
+{
+using V = simd::vec<double>;
+
+constexpr size_t lanes = V::size;
+
+// Register tile of update(): tile_rows x tile_cols of C in accumulators
+constexpr size_t tile_rows = 4;
+constexpr size_t tile_cols = 2 * lanes;
+
+/// Side of the square cache block of update(): that block of B fills half of one
+/// core's L2, 256 for 1 MiB, in whole register tiles
+size_t cache_block() noexcept
+{
+    cpu_topology const& topology = cpu_topology::instance();
+    double const        doubles  = static_cast<double>(topology.cache_per_core(topology.l2()) / 2);
+    auto const          side     = static_cast<size_t>(std::sqrt(doubles / sizeof(double)));
+    return std::clamp(side / tile_cols * tile_cols, 8 * tile_cols, 128 * tile_cols);
+}
+
+/// A full register tile: C -= A B for tile_rows x tile_cols of C, depth q
+void update_tile(
+    size_t q, const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc)
+{
+    V acc[tile_rows][2];
+    for (auto& row : acc)
+    {
+        row[0] = V(0.0);
+        row[1] = V(0.0);
+    }
+
+    for (size_t k = 0; k < q; ++k)
+    {
+        V const b0 = V::loadu(b + k * ldb);
+        V const b1 = V::loadu(b + k * ldb + lanes);
+        for (size_t r = 0; r < tile_rows; ++r)
+        {
+            V const ar = V(a[r * lda + k]);
+            acc[r][0]  = fma(ar, b0, acc[r][0]);
+            acc[r][1]  = fma(ar, b1, acc[r][1]);
+        }
+    }
+
+    for (size_t r = 0; r < tile_rows; ++r)
+    {
+        double* row = c + r * ldc;
+        (V::loadu(row) - acc[r][0]).storeu(row);
+        (V::loadu(row + lanes) - acc[r][1]).storeu(row + lanes);
+    }
+}
+
+/// The edges of C that do not fill a register tile
+void update_edge(
+    size_t        rows,
+    size_t        cols,
+    size_t        q,
+    const double* a,
+    size_t        lda,
+    const double* b,
+    size_t        ldb,
+    double*       c,
+    size_t        ldc)
+{
+    for (size_t r = 0; r < rows; ++r)
+    {
+        for (size_t k = 0; k < q; ++k)
+        {
+            double const  ark = a[r * lda + k];
+            const double* bk  = b + k * ldb;
+            double*       cr  = c + r * ldc;
+            for (size_t j = 0; j < cols; ++j)
+            {
+                cr[j] -= ark * bk[j];
+            }
+        }
+    }
+}
+
+void update(
+    size_t        m,
+    size_t        p,
+    size_t        q,
+    const double* a,
+    size_t        lda,
+    const double* b,
+    size_t        ldb,
+    double*       c,
+    size_t        ldc)
+{
+    static size_t const block = cache_block();
+
+    for (size_t k0 = 0; k0 < q; k0 += block)
+    {
+        size_t const depth = std::min(block, q - k0);
+        for (size_t j0 = 0; j0 < p; j0 += block)
+        {
+            size_t const width = std::min(block, p - j0);
+            size_t const full  = width / tile_cols * tile_cols;
+            for (size_t i = 0; i < m; i += tile_rows)
+            {
+                size_t const  rows = std::min(tile_rows, m - i);
+                const double* ai   = a + i * lda + k0;
+                const double* bk   = b + k0 * ldb + j0;
+                double*       ci   = c + i * ldc + j0;
+                if (rows == tile_rows)
+                {
+                    for (size_t j = 0; j < full; j += tile_cols)
+                    {
+                        update_tile(depth, ai, lda, bk + j, ldb, ci + j, ldc);
+                    }
+                }
+                else
+                {
+                    update_edge(rows, full, depth, ai, lda, bk, ldb, ci, ldc);
+                }
+                update_edge(rows, width - full, depth, ai, lda, bk + full, ldb, ci + full, ldc);
+            }
+        }
+    }
+}
+
+/// Lane l of the result is base[l * stride], for the used lanes; pad in the others
+V gather(const double* base, size_t stride, size_t used, double pad) noexcept
+{
+    double values[lanes];
+    for (size_t l = 0; l < lanes; ++l)
+    {
+        values[l] = l < used ? base[l * stride] : pad;
+    }
+    return V::loadu(values);
+}
+
+void scatter(const V& v, double* base, size_t stride, size_t used) noexcept
+{
+    double values[lanes];
+    v.storeu(values);
+    for (size_t l = 0; l < used; ++l)
+    {
+        base[l * stride] = values[l];
+    }
+}
+
+// Matrix l of a group of lanes matrices sits in lane l; lanes past the batch factor
+// the identity
+void batch_factor(bool pivot, double* a, size_t n, size_t count, int* pivots, int* info)
+{
+    size_t const size = n * n;
+
+    V s[batch_max_order * batch_max_order];
+    V rows[batch_max_order];
+    for (size_t g = 0; g < count; g += lanes)
+    {
+        size_t const used = std::min(lanes, count - g);
+        double*      m    = a + g * size;
+        for (size_t e = 0; e < size; ++e)
+        {
+            s[e] = gather(m + e, size, used, e % (n + 1) == 0 ? 1.0 : 0.0);
+        }
+
+        V first_zero(0.0);
+        for (size_t k = 0; k < n; ++k)
+        {
+            V* const sk = s + k * n;
+            rows[k]     = V(static_cast<double>(k));
+            if (pivot)
+            {
+                // Largest magnitude of column k, in each lane
+                V best = abs(sk[k]);
+                for (size_t i = k + 1; i < n; ++i)
+                {
+                    V const magnitude = abs(s[i * n + k]);
+                    V const larger    = magnitude > best;
+                    best              = select(larger, magnitude, best);
+                    rows[k]           = select(larger, V(static_cast<double>(i)), rows[k]);
+                }
+
+                for (size_t i = k + 1; i < n; ++i)
+                {
+                    V const swap = rows[k] == V(static_cast<double>(i));
+                    if (reduce_add(swap & V(1.0)) == 0.0)
+                    {
+                        continue;
+                    }
+                    V* const si = s + i * n;
+                    for (size_t j = 0; j < n; ++j)
+                    {
+                        V const t = sk[j];
+                        sk[j]     = select(swap, si[j], t);
+                        si[j]     = select(swap, t, si[j]);
+                    }
+                }
+            }
+
+            V const d    = sk[k];
+            V const zero = d == V(0.0);
+            first_zero   = select(
+                zero & (first_zero == V(0.0)), V(static_cast<double>(k + 1)), first_zero);
+
+            V const inverse = V(1.0) / select(zero, V(1.0), d);
+            for (size_t i = k + 1; i < n; ++i)
+            {
+                V* const si = s + i * n;
+                V const  l  = si[k] * inverse;
+                si[k]       = l;
+                for (size_t j = k + 1; j < n; ++j)
+                {
+                    si[j] = fma(-l, sk[j], si[j]);
+                }
+            }
+        }
+
+        double values[lanes];
+        for (size_t e = 0; e < size; ++e)
+        {
+            scatter(s[e], m + e, size, used);
+        }
+        for (size_t k = 0; k < n; ++k)
+        {
+            rows[k].storeu(values);
+            for (size_t l = 0; l < used; ++l)
+            {
+                pivots[(g + l) * n + k] = static_cast<int>(values[l]);
+            }
+        }
+        first_zero.storeu(values);
+        for (size_t l = 0; l < used; ++l)
+        {
+            info[g + l] = static_cast<int>(values[l]);
+        }
+    }
+}
+
+void batch_solve(const double* lu, size_t n, size_t count, const int* pivots, double* b)
+{
+    size_t const size = n * n;
+
+    V      x[batch_max_order];
+    double permuted[lanes][batch_max_order];
+    for (size_t g = 0; g < count; g += lanes)
+    {
+        size_t const  used = std::min(lanes, count - g);
+        const double* m    = lu + g * size;
+
+        // The row swaps differ from lane to lane, so they are applied before the gather
+        for (size_t l = 0; l < lanes; ++l)
+        {
+            double* r = permuted[l];
+            if (l >= used)
+            {
+                std::fill(r, r + n, 0.0);
+                continue;
+            }
+            std::copy_n(b + (g + l) * n, n, r);
+            const int* p = pivots + (g + l) * n;
+            for (size_t k = 0; k < n; ++k)
+            {
+                std::swap(r[k], r[p[k]]);
+            }
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] = gather(&permuted[0][i], batch_max_order, lanes, 0.0);
+        }
+
+        // L y = P b, then U x = y
+        for (size_t i = 1; i < n; ++i)
+        {
+            for (size_t k = 0; k < i; ++k)
+            {
+                x[i] = fma(-gather(m + i * n + k, size, used, 0.0), x[k], x[i]);
+            }
+        }
+        for (size_t i = n; i-- > 0;)
+        {
+            for (size_t k = i + 1; k < n; ++k)
+            {
+                x[i] = fma(-gather(m + i * n + k, size, used, 0.0), x[k], x[i]);
+            }
+            x[i] = x[i] / gather(m + i * n + i, size, used, 1.0);
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            scatter(x[i], b + g * n + i, n, used);
+        }
+    }
+}
+
+}  // namespace
+
+QUARISMA_REGISTER_DISPATCH(update_stub, &update);
+QUARISMA_REGISTER_DISPATCH(batch_factor_stub, &batch_factor);
+QUARISMA_REGISTER_DISPATCH(batch_solve_stub, &batch_solve);
+
+}  // namespace detail
+}  // namespace linalg
+}  // namespace quarisma
@@ -0,0 +1,316 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+// Kernels of math/random.h. This file is compiled once per cpu_capability (see
+// util/cpu_dispatch.h), so everything but the registrations stays in the
+// anonymous namespace.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "math/random_dispatch.h"
+#include "util/simd/vec.h"
+
+namespace quarisma
+{
+namespace random
+{
+namespace detail
+{
+namespace
+{
+using simd::vec;
+
+// Blocks generated at a time, word by word so that each loop vectorizes
+constexpr size_t chunk = 64;
+
+template <typename T>
+struct constants;
+
+template <>
+struct constants<double>
+{
+    static constexpr size_t per_block = 2;
+    static constexpr double two_pi    = 6.283185307179586;
+
+    // Taylor series of sin(x) / x and cos(x) in x^2, for |x| <= pi / 4
+    static constexpr double sin_terms[] = {
+        1.0,
+        -1.0 / 6,
+        1.0 / 120,
+        -1.0 / 5040,
+        1.0 / 362880,
+        -1.0 / 39916800,
+        1.0 / 6227020800,
+        -1.0 / 1307674368000,
+    };
+    static constexpr double cos_terms[] = {
+        1.0,
+        -1.0 / 2,
+        1.0 / 24,
+        -1.0 / 720,
+        1.0 / 40320,
+        -1.0 / 3628800,
+        1.0 / 479001600,
+        -1.0 / 87178291200,
+        1.0 / 20922789888000,
+    };
+};
+
+template <>
+struct constants<float>
+{
+    static constexpr size_t per_block = 4;
+    static constexpr float  two_pi    = 6.28318531f;
+
+    static constexpr float sin_terms[] = {
+        1.0f,
+        -1.0f / 6,
+        1.0f / 120,
+        -1.0f / 5040,
+        1.0f / 362880,
+    };
+    static constexpr float cos_terms[] = {
+        1.0f,
+        -1.0f / 2,
+        1.0f / 24,
+        -1.0f / 720,
+        1.0f / 40320,
+        -1.0f / 3628800,
+    };
+};
+
+/// c[0] + c[1] x + c[2] x^2 + ..., by Horner's rule
+template <typename V, typename T, size_t K>
+V polynomial(const V& x, const T (&c)[K]) noexcept
+{
+    V p(c[K - 1]);
+    for (size_t k = K - 1; k-- > 0;)
+    {
+        p = fma(p, x, V(c[k]));
+    }
+    return p;
+}
+
+template <generator G>
+struct engine;
+
+template <>
+struct engine<generator::philox4x32>
+{
+    static array4x32 generate(array4x32 counter, uint64_t key) noexcept
+    {
+        philox4x32::key_type const k = {
+            {static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)}};
+        return philox4x32::generate(counter, k);
+    }
+};
+
+template <>
+struct engine<generator::threefry4x32>
+{
+    static array4x32 generate(array4x32 counter, uint64_t key) noexcept
+    {
+        threefry4x32::key_type const k = {
+            {static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32), 0, 0}};
+        return threefry4x32::generate(counter, k);
+    }
+};
+
+/// w[k][j] = word k of block first + j of the stream, for j < count
+template <generator G>
+void blocks(uint64_t key, uint64_t stream, uint64_t first, size_t count, uint32_t (&w)[4][chunk])
+{
+    auto const stream_lo = static_cast<uint32_t>(stream);
+    auto const stream_hi = static_cast<uint32_t>(stream >> 32);
+    for (size_t j = 0; j < count; ++j)
+    {
+        uint64_t const  n       = first + j;
+        array4x32 const counter = {
+            {static_cast<uint32_t>(n), static_cast<uint32_t>(n >> 32), stream_lo, stream_hi}};
+        array4x32 const block = engine<G>::generate(counter, key);
+        w[0][j] = block.v[0];
+        w[1][j] = block.v[1];
+        w[2][j] = block.v[2];
+        w[3][j] = block.v[3];
+    }
+}
+
+/// cos(2 pi u) and sin(2 pi u) of u in [0, 1]
+template <typename V>
+void sincos_two_pi(const V& u, V& c, V& s) noexcept
+{
+    using T = typename V::value_type;
+    using C = constants<T>;
+
+    // u = q / 4 + f with |f| <= 1 / 8, exactly; the quadrant q is in [0, 4]
+    V const q     = round(u * V(T{4}));
+    V const x     = fma(q, V(T{-0.25}), u) * V(C::two_pi);
+    V const x2    = x * x;
+    V const sin_x = x * polynomial(x2, C::sin_terms);
+    V const cos_x = polynomial(x2, C::cos_terms);
+
+    V const q1 = q == V(T{1});
+    V const q2 = q == V(T{2});
+    V const q3 = q == V(T{3});
+    V const negative_zero(T{-0.0});
+
+    V const swap = q1 | q3;
+    c = select(swap, sin_x, cos_x) ^ ((q1 | q2) & negative_zero);
+    s = select(swap, cos_x, sin_x) ^ ((q2 | q3) & negative_zero);
+}
+
+/// The Box-Muller pairs of u1[m], u2[m] in (0, 1): z[2m] = r cos, z[2m + 1] = r sin
+template <typename T>
+void box_muller(const T* u1, const T* u2, T* z, size_t pairs) noexcept
+{
+    using V = vec<T>;
+
+    T cosine[2 * chunk];
+    T sine[2 * chunk];
+
+    auto const pair = [](const V& a, const V& b, V& r, V& c, V& s)
+    {
+        r = sqrt(V(T{-2}) * simd::log(a));
+        sincos_two_pi(b, c, s);
+    };
+
+    size_t m = 0;
+    for (; m + V::size <= pairs; m += V::size)
+    {
+        V r, c, s;
+        pair(V::loadu(u1 + m), V::loadu(u2 + m), r, c, s);
+        (r * c).storeu(cosine + m);
+        (r * s).storeu(sine + m);
+    }
+    if (m < pairs)
+    {
+        size_t const rest = pairs - m;
+        V            r, c, s;
+        // Lanes past rest are zero: log(0) is -infinity, harmless and never stored
+        pair(V::load_partial(u1 + m, rest), V::load_partial(u2 + m, rest), r, c, s);
+        (r * c).store_partial(cosine + m, rest);
+        (r * s).store_partial(sine + m, rest);
+    }
+
+    for (size_t k = 0; k < pairs; ++k)
+    {
+        z[2 * k]     = cosine[k];
+        z[2 * k + 1] = sine[k];
+    }
+}
+
+template <typename T>
+void uniforms(const uint32_t (&w)[4][chunk], size_t count, T* u) noexcept;
+
+// Two doubles per block, from words 0 and 1, then 2 and 3
+template <>
+void uniforms(const uint32_t (&w)[4][chunk], size_t count, double* u) noexcept
+{
+    for (size_t j = 0; j < count; ++j)
+    {
+        u[2 * j]     = uniform_double(w[0][j], w[1][j]);
+        u[2 * j + 1] = uniform_double(w[2][j], w[3][j]);
+    }
+}
+
+// Four floats per block, a word each
+template <>
+void uniforms(const uint32_t (&w)[4][chunk], size_t count, float* u) noexcept
+{
+    for (size_t j = 0; j < count; ++j)
+    {
+        u[4 * j]     = uniform_float(w[0][j]);
+        u[4 * j + 1] = uniform_float(w[1][j]);
+        u[4 * j + 2] = uniform_float(w[2][j]);
+        u[4 * j + 3] = uniform_float(w[3][j]);
+    }
+}
+
+template <generator G, distribution D, typename T>
+void fill(uint64_t key, uint64_t stream, uint64_t first, T* out, size_t n) noexcept
+{
+    constexpr size_t per_block = constants<T>::per_block;
+
+    uint32_t w[4][chunk];
+    T        values[per_block * chunk];
+    T        u1[per_block * chunk / 2];
+    T        u2[per_block * chunk / 2];
+
+    uint64_t block = first / per_block;
+    size_t   skip  = static_cast<size_t>(first % per_block);
+    while (n > 0)
+    {
+        size_t const count = std::min(chunk, (skip + n + per_block - 1) / per_block);
+        blocks<G>(key, stream, block, count, w);
+        uniforms(w, count, values);
+
+        if constexpr (D == distribution::normal)
+        {
+            // Consecutive uniforms pair up: value 2m is u1 of pair m, 2m + 1 its u2
+            size_t const pairs = count * per_block / 2;
+            for (size_t m = 0; m < pairs; ++m)
+            {
+                u1[m] = values[2 * m];
+                u2[m] = values[2 * m + 1];
+            }
+            box_muller(u1, u2, values, pairs);
+        }
+
+        size_t const take = std::min(n, count * per_block - skip);
+        std::copy_n(values + skip, take, out);
+        out += take;
+        n -= take;
+        skip = 0;
+        block += count;
+    }
+}
+
+template <typename T>
+void fill_kernel(
+    generator    g,
+    distribution d,
+    uint64_t     key,
+    uint64_t     stream,
+    uint64_t     first,
+    T*           out,
+    size_t       n)
+{
+    bool const philox = g == generator::philox4x32;
+    if (d == distribution::uniform)
+    {
+        philox ? fill<generator::philox4x32, distribution::uniform>(key, stream, first, out, n)
+               : fill<generator::threefry4x32, distribution::uniform>(key, stream, first, out, n);
+    }
+    else
+    {
+        philox ? fill<generator::philox4x32, distribution::normal>(key, stream, first, out, n)
+               : fill<generator::threefry4x32, distribution::normal>(key, stream, first, out, n);
+    }
+}
+
+}  // namespace
+
+QUARISMA_REGISTER_DISPATCH(double_fill_stub, &fill_kernel<double>);
+QUARISMA_REGISTER_DISPATCH(float_fill_stub, &fill_kernel<float>);
+
+}  // namespace detail
+}  // namespace random
+}  // namespace quarisma
@@ -0,0 +1,186 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+// Kernels of math/sparse_csr.h. This file is compiled once per cpu_capability
+// (see util/cpu_dispatch.h), so everything but the registrations stays in the
+// anonymous namespace.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math/sparse_csr_dispatch.h"
+#include "util/simd/vec.h"
+
+namespace quarisma
+{
+namespace linalg
+{
+namespace detail
+{
+namespace
+{
+using V = simd::vec<double>;
+
+constexpr size_t lanes = V::size;
+
+// Columns of C per pass over a row of SpMM, in registers
+constexpr size_t tile_vectors = 4;
+constexpr size_t tile_cols    = tile_vectors * lanes;
+
+/// sum_k values[k] x[columns[k]] over the nonzeros of row i, x gathered a
+/// vector at a time
+double row_dot(const csr_view& a, size_t i, const double* x)
+{
+    auto const first = static_cast<size_t>(a.row_offsets[i]);
+    auto const last  = static_cast<size_t>(a.row_offsets[i + 1]);
+
+    size_t k   = first;
+    double sum = 0.0;
+    if (last - first >= lanes)
+    {
+        V      acc(0.0);
+        double gathered[lanes];
+        for (; k + lanes <= last; k += lanes)
+        {
+            for (size_t l = 0; l < lanes; ++l)
+            {
+                gathered[l] = x[a.columns[k + l]];
+            }
+            acc = fma(V::loadu(a.values + k), V::loadu(gathered), acc);
+        }
+        sum = reduce_add(acc);
+    }
+    for (; k < last; ++k)
+    {
+        sum += a.values[k] * x[a.columns[k]];
+    }
+    return sum;
+}
+
+void spmv_rows(
+    const csr_view& a,
+    size_t          first,
+    size_t          last,
+    const double*   x,
+    double*         y,
+    double          alpha,
+    double          beta)
+{
+    for (size_t i = first; i < last; ++i)
+    {
+        double const dot = alpha * row_dot(a, i, x);
+        y[i]             = beta == 0.0 ? dot : dot + beta * y[i];
+    }
+}
+
+/// Writes alpha acc + beta C to count columns of C at c
+void store_scaled(V acc, double* c, size_t count, double alpha, double beta)
+{
+    V result = acc * V(alpha);
+    if (beta != 0.0)
+    {
+        result = fma(V(beta), V::load_partial(c, count), result);
+    }
+    result.store_partial(c, count);
+}
+
+/// Row i of C = alpha A B + beta C for width <= tile_cols columns from column j
+void spmm_row_tile(
+    const csr_view& a,
+    size_t          i,
+    size_t          j,
+    size_t          width,
+    const double*   b,
+    size_t          ldb,
+    double*         c,
+    double          alpha,
+    double          beta)
+{
+    auto const first = static_cast<size_t>(a.row_offsets[i]);
+    auto const last  = static_cast<size_t>(a.row_offsets[i + 1]);
+
+    V acc[tile_vectors];
+    for (auto& v : acc)
+    {
+        v = V(0.0);
+    }
+    if (width == tile_cols)
+    {
+        for (size_t k = first; k < last; ++k)
+        {
+            V const       value = V(a.values[k]);
+            const double* row   = b + static_cast<size_t>(a.columns[k]) * ldb + j;
+            for (size_t v = 0; v < tile_vectors; ++v)
+            {
+                acc[v] = fma(value, V::loadu(row + v * lanes), acc[v]);
+            }
+        }
+    }
+    else
+    {
+        size_t const vectors = (width + lanes - 1) / lanes;
+        for (size_t k = first; k < last; ++k)
+        {
+            V const       value = V(a.values[k]);
+            const double* row   = b + static_cast<size_t>(a.columns[k]) * ldb + j;
+            for (size_t v = 0; v < vectors; ++v)
+            {
+                size_t const count = width - v * lanes < lanes ? width - v * lanes : lanes;
+                acc[v]             = fma(value, V::load_partial(row + v * lanes, count), acc[v]);
+            }
+        }
+    }
+
+    for (size_t v = 0; v * lanes < width; ++v)
+    {
+        size_t const count = width - v * lanes < lanes ? width - v * lanes : lanes;
+        store_scaled(acc[v], c + j + v * lanes, count, alpha, beta);
+    }
+}
+
+void spmm_rows(
+    const csr_view& a,
+    size_t          first,
+    size_t          last,
+    const double*   b,
+    size_t          p,
+    size_t          ldb,
+    double*         c,
+    size_t          ldc,
+    double          alpha,
+    double          beta)
+{
+    for (size_t i = first; i < last; ++i)
+    {
+        for (size_t j = 0; j < p; j += tile_cols)
+        {
+            size_t const width = p - j < tile_cols ? p - j : tile_cols;
+            spmm_row_tile(a, i, j, width, b, ldb, c + i * ldc, alpha, beta);
+        }
+    }
+}
+
+}  // namespace
+
+QUARISMA_REGISTER_DISPATCH(spmv_rows_stub, &spmv_rows);
+QUARISMA_REGISTER_DISPATCH(spmm_rows_stub, &spmm_rows);
+
+}  // namespace detail
+}  // namespace linalg
+}  // namespace quarisma
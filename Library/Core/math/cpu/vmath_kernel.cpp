@@ -0,0 +1,619 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+// Kernels of math/vmath.h. This file is compiled once per cpu_capability (see
+// util/cpu_dispatch.h), so everything but the registrations stays in the
+// anonymous namespace.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+#include "math/vmath_dispatch.h"
+#include "util/simd/vec.h"
+
+namespace quarisma
+{
+namespace vmath
+{
+namespace detail
+{
+namespace
+{
+using simd::vec;
+
+template <typename T>
+struct constants;
+
+template <>
+struct constants<double>
+{
+    static constexpr double log2e      = 1.4426950408889634;
+    static constexpr double sqrt2      = 1.4142135623730951;
+    static constexpr double sqrt1_2    = 0.7071067811865476;
+    static constexpr double sqrt1_2_lo = -4.833646656726457e-17;  // sqrt(1/2) - sqrt1_2
+    static constexpr double sqrt2pi    = 2.5066282746310002;
+    static constexpr double inv_sqrtpi = 0.5641895835477563;
+
+    // ln(2) split as fdlibm: ln2_hi has 32 significant bits, so k * ln2_hi is
+    // exact for every exponent k
+    static constexpr double ln2_hi = 6.93147180369123816490e-01;
+    static constexpr double ln2_lo = 1.90821492927058770002e-10;
+
+    static constexpr double exp_max = 709.782712893384;    // ln(DBL_MAX)
+    static constexpr double exp_min = -745.1332191019412;  // ln(DBL_TRUE_MIN / 2)
+
+    static constexpr double min_exponent       = -1022;
+    static constexpr double max_exponent       = 1023;
+    static constexpr double subnormal_exponent = 54;
+    static constexpr double subnormal_scale    = 0x1p54;
+    static constexpr double min_normal         = std::numeric_limits<double>::min();
+};
+
+template <>
+struct constants<float>
+{
+    static constexpr float log2e = 1.44269504f;
+    static constexpr float sqrt2 = 1.41421356f;
+
+    static constexpr float ln2_hi = 6.9313812256e-01f;
+    static constexpr float ln2_lo = 9.0580006145e-06f;
+
+    static constexpr float exp_max = 88.7228394f;   // ln(FLT_MAX)
+    static constexpr float exp_min = -103.972077f;  // ln(FLT_TRUE_MIN / 2)
+
+    static constexpr float min_exponent       = -126;
+    static constexpr float max_exponent       = 127;
+    static constexpr float subnormal_exponent = 25;
+    static constexpr float subnormal_scale    = 0x1p25f;
+    static constexpr float min_normal         = std::numeric_limits<float>::min();
+};
+
+/**
+ * @brief Polynomials of each tier
+ *
+ * exp: q(r) = (e^r - 1 - r) / r^2 on |r| <= ln(2) / 2, and log: R(z) =
+ * (log(1 + f) - 2s) / s in z = s^2, s = f / (2 + f), |s| <= 3 - 2 sqrt(2);
+ * both minimax fits of the relative error of the result. erf: erf(x) / x in
+ * x^2, |x| < 1/2. erfc_terms: the Chebyshev coefficients of erfc_chebyshev
+ * that are summed.
+ */
+template <typename T, accuracy A>
+struct tier;
+
+template <>
+struct tier<double, accuracy::high>
+{
+    static constexpr double exp_poly[] = {
+        0.5000000000000011, 0.16666666666666413, 0.041666666666530267, 0.008333333333494335,
+        0.001388888894359742, 0.00019841269506772164, 2.4801493136433562e-05,
+        2.7557586275084822e-06, 2.7630233844767376e-07, 2.500006905552792e-08,
+    };
+    static constexpr double log_poly[] = {
+        0.6666666666666734, 0.3999999999941468, 0.28571428742387023, 0.22222198573260976,
+        0.18183564321552453, 0.1531405068080525, 0.1479594831948716,
+    };
+    static constexpr double erf_poly[] = {
+        1.1283791670955126, -0.37612638903183465, 0.11283791670924812, -0.02686617063271549,
+        0.00522397737032212, -0.0008548297524063998, 0.00012053324299106379,
+        -1.4845583401530559e-05, 1.4723212150811998e-06,
+    };
+    static constexpr size_t erfc_terms = 30;
+};
+
+template <>
+struct tier<double, accuracy::medium>
+{
+    static constexpr double exp_poly[] = {
+        0.49999999999998324, 0.16666666666611557, 0.04166666666813624, 0.008333333370869665,
+        0.0013888888516296574, 0.00019841185236791224, 2.4801931642534547e-05,
+        2.7634990545464447e-06, 2.7476824427758874e-07,
+    };
+    static constexpr double log_poly[] = {
+        0.666666666665872, 0.4000000005227546, 0.2857141712951484, 0.22223371702389447,
+        0.1812364196576541, 0.16819828959796201,
+    };
+    static constexpr const double (&erf_poly)[9] = tier<double, accuracy::high>::erf_poly;
+    static constexpr size_t erfc_terms           = 27;
+};
+
+template <>
+struct tier<double, accuracy::fast>
+{
+    static constexpr double exp_poly[] = {
+        0.49999993451553576, 0.16666520690233438, 0.04166838741132956, 0.008368709797344564,
+        0.0013814610228342166,
+    };
+    static constexpr double log_poly[] = {
+        0.666667763815817, 0.39977541577657233, 0.29871727737829323,
+    };
+    static constexpr double erf_poly[] = {
+        1.12837916556735, -0.37612608572919753, 0.11282822811545962, -0.026757184378392567,
+        0.00471799028816772,
+    };
+    static constexpr size_t erfc_terms = 13;
+};
+
+template <>
+struct tier<float, accuracy::high>
+{
+    static constexpr float exp_poly[] = {
+        0.49999994f, 0.166665211f, 0.041668389f, 0.00836871006f, 0.00138146104f,
+    };
+    static constexpr float log_poly[] = {
+        0.666667759f, 0.399775416f, 0.29871729f,
+    };
+};
+
+template <>
+struct tier<float, accuracy::medium>
+{
+    static constexpr float exp_poly[] = {
+        0.499992311f, 0.166671142f, 0.0418901145f, 0.00831252523f,
+    };
+    static constexpr float log_poly[] = {
+        0.666556001f, 0.412029147f,
+    };
+};
+
+template <>
+struct tier<float, accuracy::fast>
+{
+    static constexpr float exp_poly[] = {
+        0.503941f, 0.166628107f,
+    };
+    static constexpr float log_poly[] = {
+        0.676612973f,
+    };
+};
+
+// Chebyshev series in u = 2t - 1, t = 2 / (2 + z), of log(erfc(z) e^(z^2) / t)
+// over z in [0, inf): the coefficients decay fast enough that truncating the
+// series gives each tier
+constexpr double erfc_chebyshev[] = {
+    -1.3026537197817094, 0.6419697923564902, 0.019476473204185836, -0.009561514786808632,
+    -0.0009465953444820369, 0.00036683949785276145, 4.252332480690777e-05,
+    -2.0278578112534242e-05, -1.6242900046470256e-06, 1.3036558355805232e-06,
+    1.5626441722066142e-08, -8.523809591492654e-08, 6.5290544390988515e-09,
+    5.059343495551469e-09, -9.91364156493033e-10, -2.273651222931836e-10,
+    9.646791102015527e-11, 2.3940380830391146e-12, -6.886027526497553e-12,
+    8.944879273090725e-13, 3.130921399342958e-13, -1.1270822361367252e-13,
+    3.810905255189232e-16, 7.106097613609237e-15, -1.5230282014571043e-15,
+    -9.457494571291233e-17, 1.210237189224279e-16, -2.816663087747177e-17,
+    5.003005559445902e-20, 2.3281042579529253e-18,
+};
+
+// The rounding errors of erfc_chebyshev[0] / 2 and erfc_chebyshev[1], which
+// erfc_series() adds back
+constexpr double erfc_chebyshev_lo[] = {-1.3523262854996133e-17, 5.0520496981086374e-17};
+
+// Acklam's approximation of the normal quantile, relative error 1.15e-9;
+// numerators and denominators in increasing powers
+constexpr double acklam_split = 0.02425;
+
+constexpr double acklam_central_num[] = {
+    2.506628277459239e+00, -3.066479806614716e+01, 1.383577518672690e+02,
+    -2.759285104469687e+02, 2.209460984245205e+02, -3.969683028665376e+01,
+};
+constexpr double acklam_central_den[] = {
+    1.0, -1.328068155288572e+01, 6.680131188771972e+01,
+    -1.556989798598866e+02, 1.615858368580409e+02, -5.447609879822406e+01,
+};
+constexpr double acklam_tail_num[] = {
+    2.938163982698783e+00, 4.374664141464968e+00, -2.549732539343734e+00,
+    -2.400758277161838e+00, -3.223964580411365e-01, -7.784894002430293e-03,
+};
+constexpr double acklam_tail_den[] = {
+    1.0, 3.754408661907416e+00, 2.445134137142996e+00, 3.224671290700398e-01,
+    7.784695709041462e-03,
+};
+
+// Past these, erfc(z) and Phi(-x) are 0; clamping keeps infinities out of the splits
+constexpr double erfc_cutoff = 40;
+constexpr double cdf_cutoff  = 40;
+
+/// c[0] + c[1] x + c[2] x^2 + ..., by Horner's rule
+template <typename V, typename T, size_t K>
+V horner(V x, const T (&c)[K]) noexcept
+{
+    V p(c[K - 1]);
+    for (size_t k = K - 1; k-- > 0;)
+    {
+        p = fma(p, x, V(c[k]));
+    }
+    return p;
+}
+
+/// a with the low 27 significand bits cleared, so that its square is exact
+template <typename V>
+V high_half(V a) noexcept
+{
+    constexpr uint64_t bits = 0xFFFFFFFFF8000000ULL;
+    double             mask;
+    std::memcpy(&mask, &bits, sizeof(mask));
+    return a & V(mask);
+}
+
+/// a * b - p exactly, for p the rounded product: one fma, or Dekker's product without it
+template <typename V>
+V product_error(V a, V b, V p) noexcept
+{
+#if defined(QUARISMA_SIMD_AVX2) || defined(QUARISMA_SIMD_AVX512) || \
+    defined(QUARISMA_SIMD_NEON) || defined(__FMA__)
+    return fma(a, b, -p);
+#else
+    V const a_hi = high_half(a);
+    V const a_lo = a - a_hi;
+    V const b_hi = high_half(b);
+    V const b_lo = b - b_hi;
+    return (((a_hi * b_hi - p) + a_hi * b_lo) + a_lo * b_hi) + a_lo * b_lo;
+#endif
+}
+
+/**
+ * @brief erfc_chebyshev summed to Terms at u, as hi + lo
+ *
+ * Clenshaw's recurrence over the terms from T_2 on, which stay below 0.03,
+ * and the two leading terms in double-double: the sum is about -1.3, so
+ * rounding it once would already cost an ulp of erfc.
+ */
+template <size_t Terms, typename V>
+V erfc_series(V u, V& lo) noexcept
+{
+    static_assert(
+        Terms > 2 && Terms <= std::size(erfc_chebyshev), "erfc_series() sums T_2 and on");
+
+    V const two_u = u + u;
+    V       b1(0.0);
+    V       b2(0.0);
+    for (size_t k = Terms - 1; k > 1; --k)
+    {
+        V const b = fma(two_u, b1, V(erfc_chebyshev[k]) - b2);
+        b2        = b1;
+        b1        = b;
+    }
+    V const tail = b1 * fma(two_u, u, V(-1.0)) - b2 * u;
+
+    V const c0 = V(0.5 * erfc_chebyshev[0]);
+    V const c1 = V(erfc_chebyshev[1]);
+    V const p  = c1 * u;
+    V const hi = c0 + p;
+    V const b  = hi - c0;
+    lo = ((c0 - (hi - b)) + (p - b)) + product_error(c1, u, p) +
+         fma(V(erfc_chebyshev_lo[1]), u, V(erfc_chebyshev_lo[0])) + tail;
+    return hi;
+}
+
+/**
+ * @brief e^(hi + lo), without rounding hi + lo first
+ *
+ * The bits that rounding the sum loses go into the reduced argument, where
+ * they still count: the erf family passes -z^2 split in two.
+ */
+template <accuracy A, typename V>
+V exp_split(V hi, V lo) noexcept
+{
+    using T = typename V::value_type;
+    using C = constants<T>;
+
+    // hi + lo as its rounded sum x and the error e of that rounding (Knuth's two-sum)
+    V const x = hi + lo;
+    V const b = x - hi;
+    V const e = (hi - (x - b)) + (lo - b);
+
+    V const clamped = min(max(x, V(C::exp_min)), V(C::exp_max));
+    V const n       = round(clamped * V(C::log2e));
+    V const r_hi    = fma(n, V(-C::ln2_hi), clamped);
+    V const r_lo    = fma(n, V(-C::ln2_lo), e);
+    V const r       = r_hi + r_lo;
+    V const p       = V(T{1}) + (r_hi + fma(r * r, horner(r, tier<T, A>::exp_poly), r_lo));
+
+    // 2^n as two normal factors, so that subnormal results are rounded once
+    V const adjust = select(
+        n > V(C::max_exponent),
+        V(T{1}),
+        select(n < V(C::min_exponent), V(-C::subnormal_exponent), V(T{0})));
+    V result = p * pow2(n - adjust) * pow2(adjust);
+
+    result = select(x > V(C::exp_max), V(std::numeric_limits<T>::infinity()), result);
+    result = select(x < V(C::exp_min), V(T{0}), result);
+    return select(x != x, x, result);
+}
+
+template <accuracy A, typename V>
+V exp_kernel(V x) noexcept
+{
+    return exp_split<A>(x, V(typename V::value_type{0}));
+}
+
+template <accuracy A, typename V>
+V log_kernel(V x) noexcept
+{
+    using T = typename V::value_type;
+    using C = constants<T>;
+
+    // x = m 2^k, m in [sqrt(1/2), sqrt(2)]
+    V const tiny   = x < V(C::min_normal);
+    V const scaled = select(tiny, x * V(C::subnormal_scale), x);
+    V       k      = exponent(scaled) - (tiny & V(C::subnormal_exponent));
+    V       m      = mantissa(scaled);
+    V const high   = m > V(C::sqrt2);
+    m              = select(high, m * V(T{0.5}), m);
+    k              = k + (high & V(T{1}));
+
+    // log(1 + f) = f - hfsq + s (hfsq + R), as fdlibm's e_log.c
+    V const f      = m - V(T{1});
+    V const s      = f / (V(T{2}) + f);
+    V const z      = s * s;
+    V const R      = z * horner(z, tier<T, A>::log_poly);
+    V const hfsq   = V(T{0.5}) * f * f;
+    V const low    = hfsq - fma(s, hfsq + R, k * V(C::ln2_lo));
+    V       result = fma(k, V(C::ln2_hi), f - low);
+
+    result = select(x == V(T{0}), V(-std::numeric_limits<T>::infinity()), result);
+    result = select(x < V(T{0}), V(std::numeric_limits<T>::quiet_NaN()), result);
+    result = select(x == V(std::numeric_limits<T>::infinity()), x, result);
+    return select(x != x, x, result);
+}
+
+/// exp inside the erf family: medium already spends its ulps on a shorter series
+template <accuracy A>
+constexpr accuracy exp_tier = A == accuracy::fast ? accuracy::fast : accuracy::high;
+
+/**
+ * @brief erfc(z + z_lo) e^(z^2 - square_hi - square_lo), for z >= 0
+ *
+ * erfc(z + z_lo) itself when square_hi + square_lo is z^2; the caller splits
+ * the square exactly, since rounding it would cost ulps in proportion to z^2.
+ * The series is summed at the z' that the rounded u stands for, and e^(z^2)
+ * erfc(z) carried from z' to z + z_lo by its logarithmic derivative L(z): u
+ * alone rounds away a few ulps once z is large.
+ */
+template <accuracy A, typename V>
+V erfc_scaled(V z, V z_lo, V square_hi, V square_lo) noexcept
+{
+    // 2 + z + z_lo = d + d_e, by Knuth's two-sum
+    V const d   = V(2.0) + z;
+    V const d_b = d - V(2.0);
+    V const d_e = (V(2.0) - (d - d_b)) + (z - d_b) + z_lo;
+
+    // u + 1 = 2t' is exact, t' = 2 / (2 + z')
+    V const u  = V(4.0) / d - V(1.0);
+    V const t2 = u + V(1.0);
+    V       f_lo;
+    V const f = erfc_series<tier<double, A>::erfc_terms>(u, f_lo);
+
+    // rho = 4 - 2t' (2 + z + z_lo), so z + z_lo - z' = -rho / 2t', about -rho d / 4. The
+    // derivative L(z) = 2z - 2 / (sqrt(pi) e^(z^2) erfc(z)) tends to z - sqrt(z^2 + 2),
+    // close enough where u is rounded at all, z > 6
+    V const t2d   = t2 * d;
+    V const rho   = ((V(4.0) - t2d) - product_error(t2, d, t2d)) - t2 * d_e;
+    V const slope = z - sqrt(fma(z, z, V(2.0)));
+    V const shift = V(-0.25) * rho * d * slope;
+    return V(0.5) * t2 * exp_split<exp_tier<A>>(-square_hi, f + ((shift - square_lo) + f_lo));
+}
+
+/// erfc(|x|), without clamping
+template <accuracy A, typename V>
+V erfc_of_abs(V x) noexcept
+{
+    V const z    = min(abs(x), V(erfc_cutoff));
+    V const z_hi = high_half(z);
+    return erfc_scaled<A>(z, V(0.0), z_hi * z_hi, (z - z_hi) * (z + z_hi));
+}
+
+/// erf(x) for |x| < 1/2
+template <accuracy A, typename V>
+V erf_small(V x) noexcept
+{
+    return x * horner(x * x, tier<double, A>::erf_poly);
+}
+
+template <accuracy A, typename V>
+V erf_kernel(V x) noexcept
+{
+    V const large = (V(1.0) - erfc_of_abs<A>(x)) | (x & V(-0.0));
+    return select(x != x, x, select(abs(x) < V(0.5), erf_small<A>(x), large));
+}
+
+template <accuracy A, typename V>
+V erfc_kernel(V x) noexcept
+{
+    V const tail  = erfc_of_abs<A>(x);
+    V const large = select(x < V(0.0), V(2.0) - tail, tail);
+    return select(x != x, x, select(abs(x) < V(0.5), V(1.0) - erf_small<A>(x), large));
+}
+
+/// Phi(-|x|) with the square x^2 / 2 split exactly
+template <accuracy A, typename V>
+V norm_cdf_lower(V x) noexcept
+{
+    using C = constants<double>;
+
+    V const a    = min(abs(x), V(cdf_cutoff));
+    V const a_hi = high_half(a);
+    V const half = V(0.5);
+    V const z    = a * V(C::sqrt1_2);
+    V const z_lo = product_error(a, V(C::sqrt1_2), z) + a * V(C::sqrt1_2_lo);
+    return half * erfc_scaled<A>(z, z_lo, half * a_hi * a_hi, half * (a - a_hi) * (a + a_hi));
+}
+
+template <accuracy A, typename V>
+V norm_cdf_kernel(V x) noexcept
+{
+    using C = constants<double>;
+
+    V const z     = x * V(C::sqrt1_2);
+    V const small = fma(V(0.5), erf_small<A>(z), V(0.5));
+    V const lower = norm_cdf_lower<A>(x);
+    V const large = select(x < V(0.0), lower, V(1.0) - lower);
+    return select(x != x, x, select(abs(z) < V(0.5), small, large));
+}
+
+template <accuracy A, typename V>
+V norm_inv_cdf_kernel(V p) noexcept
+{
+    using C = constants<double>;
+
+    // Tail probability: 1 - p is exact for p >= 1/2
+    V const pt = min(p, V(1.0) - p);
+
+    V const q       = p - V(0.5);
+    V const r       = q * q;
+    V const central = q * horner(r, acklam_central_num) / horner(r, acklam_central_den);
+
+    V const s     = sqrt(V(-2.0) * log_kernel<A>(pt));
+    V const lower = horner(s, acklam_tail_num) / horner(s, acklam_tail_den);
+    V       x     = select(pt < V(acklam_split), select(q > V(0.0), -lower, lower), central);
+
+    if constexpr (A != accuracy::fast)
+    {
+        // One Halley step on Phi(y) = pt, y = -|x|. Near the median Phi(y) - pt
+        // is taken as erf(z) / 2 + (1/2 - pt), z = y / sqrt(2), which keeps its
+        // relative accuracy; z_lo e^(-z^2) / sqrt(pi), the rounding of z, is
+        // worth an ulp there
+        V const y       = -abs(x);
+        V const z       = y * V(C::sqrt1_2);
+        V const z_lo    = product_error(y, V(C::sqrt1_2), z) + y * V(C::sqrt1_2_lo);
+        V const slope   = V(C::inv_sqrtpi) * fma(-z, z, V(1.0));
+        V const median  = fma(V(0.5), erf_small<A>(z), V(0.5) - pt) + z_lo * slope;
+        V const e       = select(abs(z) < V(0.5), median, norm_cdf_lower<A>(y) - pt);
+        V const u       = e * V(C::sqrt2pi) * exp_kernel<exp_tier<A>>(V(0.5) * y * y);
+        V const refined = y - u / fma(V(0.5) * y, u, V(1.0));
+        x               = select(q < V(0.0), refined, -refined);
+    }
+
+    V const inf = V(std::numeric_limits<double>::infinity());
+    x = select(p == V(0.0), -inf, x);
+    x = select(p == V(1.0), inf, x);
+    x = select((p < V(0.0)) | (p > V(1.0)), V(std::numeric_limits<double>::quiet_NaN()), x);
+    return select(p != p, p, x);
+}
+
+/// y[i] = f(x[i]) for i in [0, n), a register at a time
+template <typename T, typename F>
+void apply(const T* x, T* y, size_t n, F f) noexcept
+{
+    using V = vec<T>;
+
+    size_t i = 0;
+    for (; i + V::size <= n; i += V::size)
+    {
+        f(V::loadu(x + i)).storeu(y + i);
+    }
+    if (i < n)
+    {
+        f(V::load_partial(x + i, n - i)).store_partial(y + i, n - i);
+    }
+}
+
+template <accuracy A>
+void double_tier_kernel(function fn, const double* x, double* y, size_t n) noexcept
+{
+    using V = vec<double>;
+
+    switch (fn)
+    {
+    case function::exp:
+        apply(x, y, n, [](V v) { return exp_kernel<A>(v); });
+        break;
+    case function::log:
+        apply(x, y, n, [](V v) { return log_kernel<A>(v); });
+        break;
+    case function::sqrt:
+        apply(x, y, n, [](V v) { return sqrt(v); });
+        break;
+    case function::erf:
+        apply(x, y, n, [](V v) { return erf_kernel<A>(v); });
+        break;
+    case function::erfc:
+        apply(x, y, n, [](V v) { return erfc_kernel<A>(v); });
+        break;
+    case function::norm_cdf:
+        apply(x, y, n, [](V v) { return norm_cdf_kernel<A>(v); });
+        break;
+    case function::norm_inv_cdf:
+        apply(x, y, n, [](V v) { return norm_inv_cdf_kernel<A>(v); });
+        break;
+    }
+}
+
+template <accuracy A>
+void float_tier_kernel(function fn, const float* x, float* y, size_t n) noexcept
+{
+    using V = vec<float>;
+
+    switch (fn)
+    {
+    case function::exp:
+        apply(x, y, n, [](V v) { return exp_kernel<A>(v); });
+        break;
+    case function::log:
+        apply(x, y, n, [](V v) { return log_kernel<A>(v); });
+        break;
+    case function::sqrt:
+        apply(x, y, n, [](V v) { return sqrt(v); });
+        break;
+    default:
+        // vmath.cpp widens the others to double
+        break;
+    }
+}
+
+void double_kernel(function fn, accuracy a, const double* x, double* y, size_t n)
+{
+    switch (a)
+    {
+    case accuracy::high:
+        double_tier_kernel<accuracy::high>(fn, x, y, n);
+        break;
+    case accuracy::medium:
+        double_tier_kernel<accuracy::medium>(fn, x, y, n);
+        break;
+    case accuracy::fast:
+        double_tier_kernel<accuracy::fast>(fn, x, y, n);
+        break;
+    }
+}
+
+void float_kernel(function fn, accuracy a, const float* x, float* y, size_t n)
+{
+    switch (a)
+    {
+    case accuracy::high:
+        float_tier_kernel<accuracy::high>(fn, x, y, n);
+        break;
+    case accuracy::medium:
+        float_tier_kernel<accuracy::medium>(fn, x, y, n);
+        break;
+    case accuracy::fast:
+        float_tier_kernel<accuracy::fast>(fn, x, y, n);
+        break;
+    }
+}
+}  // namespace
+
+QUARISMA_REGISTER_DISPATCH(double_kernel_stub, &double_kernel);
+QUARISMA_REGISTER_DISPATCH(float_kernel_stub, &float_kernel);
+
+}  // namespace detail
+}  // namespace vmath
+}  // namespace quarisma
@@ -0,0 +1,399 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "math/lu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "math/lu_dispatch.h"
+#include "parallel/parallel_tools.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_MKL
+#include <mkl_lapacke.h>
+#endif
+
+namespace quarisma
+{
+namespace linalg
+{
+namespace detail
+{
+
+QUARISMA_DEFINE_DISPATCH(update_stub);
+QUARISMA_DEFINE_DISPATCH(batch_factor_stub);
+QUARISMA_DEFINE_DISPATCH(batch_solve_stub);
+
+}  // namespace detail
+
+namespace
+{
+#if defined(QUARISMA_LU_PIVOTING)
+constexpr bool pivoting = true;
+#else
+constexpr bool pivoting = false;
+#endif
+
+// Columns factored one at a time at the bottom of the recursion, and rows of the
+// triangular solves
+constexpr size_t panel_width = 16;
+
+// Multiply-adds below which an update stays on the calling thread, and the rows or
+// columns of each parallel task above it
+constexpr size_t parallel_work  = size_t{1} << 21;
+constexpr size_t parallel_slice = 64;
+
+// Multiply-adds of each task of the batched functions
+constexpr size_t batch_work = size_t{1} << 16;
+
+#if QUARISMA_HAS_MKL
+// Orders below this are faster here than through LAPACKE's row-major transposition
+constexpr size_t mkl_min_order = 64;
+#endif
+
+template <typename Block>
+void run(size_t n, size_t grain, Block const& block)
+{
+    if (n <= grain)
+    {
+        block(0, n);
+        return;
+    }
+    parallel_tools::parallel_for(0, n, grain, block);
+}
+
+/// C -= A B, C m x p, split by rows or columns when large
+void update(
+    size_t        m,
+    size_t        p,
+    size_t        q,
+    const double* a,
+    size_t        lda,
+    const double* b,
+    size_t        ldb,
+    double*       c,
+    size_t        ldc)
+{
+    auto const kernel = detail::update_stub.selected();
+    if (m * p * q < parallel_work)
+    {
+        kernel(m, p, q, a, lda, b, ldb, c, ldc);
+    }
+    else if (m >= p)
+    {
+        parallel_tools::parallel_for(
+            0,
+            m,
+            parallel_slice,
+            [=](size_t begin, size_t end)
+            { kernel(end - begin, p, q, a + begin * lda, lda, b, ldb, c + begin * ldc, ldc); });
+    }
+    else
+    {
+        parallel_tools::parallel_for(
+            0,
+            p,
+            parallel_slice,
+            [=](size_t begin, size_t end)
+            { kernel(m, end - begin, q, a, lda, b + begin, ldb, c + begin, ldc); });
+    }
+}
+
+/// B = L^-1 B for L n x n unit lower triangular, B n x cols
+void solve_lower_unit(const double* l, size_t ldl, size_t n, double* b, size_t ldb, size_t cols)
+{
+    if (n > panel_width)
+    {
+        size_t const n1 = n / 2;
+        solve_lower_unit(l, ldl, n1, b, ldb, cols);
+        update(n - n1, cols, n1, l + n1 * ldl, ldl, b, ldb, b + n1 * ldb, ldb);
+        solve_lower_unit(l + n1 * ldl + n1, ldl, n - n1, b + n1 * ldb, ldb, cols);
+        return;
+    }
+
+    for (size_t i = 1; i < n; ++i)
+    {
+        double* bi = b + i * ldb;
+        for (size_t k = 0; k < i; ++k)
+        {
+            double const  lik = l[i * ldl + k];
+            const double* bk  = b + k * ldb;
+            for (size_t j = 0; j < cols; ++j)
+            {
+                bi[j] -= lik * bk[j];
+            }
+        }
+    }
+}
+
+/// B = U^-1 B for U n x n upper triangular, B n x cols
+void solve_upper(const double* u, size_t ldu, size_t n, double* b, size_t ldb, size_t cols)
+{
+    if (n > panel_width)
+    {
+        size_t const n1 = n / 2;
+        solve_upper(u + n1 * ldu + n1, ldu, n - n1, b + n1 * ldb, ldb, cols);
+        update(n1, cols, n - n1, u + n1, ldu, b + n1 * ldb, ldb, b, ldb);
+        solve_upper(u, ldu, n1, b, ldb, cols);
+        return;
+    }
+
+    for (size_t i = n; i-- > 0;)
+    {
+        double* bi = b + i * ldb;
+        for (size_t k = i + 1; k < n; ++k)
+        {
+            double const  uik = u[i * ldu + k];
+            const double* bk  = b + k * ldb;
+            for (size_t j = 0; j < cols; ++j)
+            {
+                bi[j] -= uik * bk[j];
+            }
+        }
+        double const inverse = 1.0 / u[i * ldu + i];
+        for (size_t j = 0; j < cols; ++j)
+        {
+            bi[j] *= inverse;
+        }
+    }
+}
+
+/// Row swaps [first, last) of pivots, over cols columns from a
+void apply_swaps(double* a, size_t lda, size_t cols, const int* pivots, size_t first, size_t last)
+{
+    for (size_t k = first; k < last; ++k)
+    {
+        auto const p = static_cast<size_t>(pivots[k]);
+        if (p != k)
+        {
+            std::swap_ranges(a + k * lda, a + k * lda + cols, a + p * lda);
+        }
+    }
+}
+
+/// One column at a time, m x n with m >= n
+int factor_panel(double* a, size_t m, size_t n, size_t lda, int* pivots)
+{
+    int info = 0;
+    for (size_t k = 0; k < n; ++k)
+    {
+        double* ak = a + k * lda;
+
+        size_t p = k;
+        if (pivoting)
+        {
+            double best = std::fabs(ak[k]);
+            for (size_t i = k + 1; i < m; ++i)
+            {
+                double const magnitude = std::fabs(a[i * lda + k]);
+                if (magnitude > best)
+                {
+                    best = magnitude;
+                    p    = i;
+                }
+            }
+            if (p != k)
+            {
+                std::swap_ranges(ak, ak + n, a + p * lda);
+            }
+        }
+        pivots[k] = static_cast<int>(p);
+
+        // A zero pivot leaves its column unscaled, as LAPACK does
+        double const d = ak[k];
+        if (d == 0.0 && info == 0)
+        {
+            info = static_cast<int>(k + 1);
+        }
+        double const inverse = d == 0.0 ? 1.0 : 1.0 / d;
+
+        for (size_t i = k + 1; i < m; ++i)
+        {
+            double*      ai = a + i * lda;
+            double const l  = ai[k] * inverse;
+            ai[k]           = l;
+            for (size_t j = k + 1; j < n; ++j)
+            {
+                ai[j] -= l * ak[j];
+            }
+        }
+    }
+    return info;
+}
+
+/**
+ * Toledo's recursive LU of the m x n panel a, m >= n: the left half, the
+ * right half's rows of U by a triangular solve, the Schur complement by
+ * update(), and then its own LU. Pivots are rows of a.
+ */
+int factor(double* a, size_t m, size_t n, size_t lda, int* pivots)
+{
+    if (n <= panel_width)
+    {
+        return factor_panel(a, m, n, lda, pivots);
+    }
+
+    size_t const n1  = n / 2;
+    size_t const n2  = n - n1;
+    double*      a12 = a + n1;
+    double*      a21 = a + n1 * lda;
+    double*      a22 = a21 + n1;
+
+    int info = factor(a, m, n1, lda, pivots);
+    if (pivoting)
+    {
+        apply_swaps(a12, lda, n2, pivots, 0, n1);
+    }
+    solve_lower_unit(a, lda, n1, a12, lda, n2);
+    update(m - n1, n2, n1, a21, lda, a12, lda, a22, lda);
+
+    int const right = factor(a22, m - n1, n2, lda, pivots + n1);
+    for (size_t k = n1; k < n; ++k)
+    {
+        pivots[k] += static_cast<int>(n1);
+    }
+    if (pivoting)
+    {
+        apply_swaps(a, lda, n1, pivots, n1, n);
+    }
+
+    if (info == 0 && right != 0)
+    {
+        info = right + static_cast<int>(n1);
+    }
+    return info;
+}
+}  // namespace
+
+bool lu_pivoting() noexcept
+{
+    return pivoting;
+}
+
+int lu_factor(double* a, size_t n, size_t lda, int* pivots)
+{
+    QUARISMA_CHECK(lda >= n, "lu_factor: row stride {} is shorter than the order {}", lda, n);
+    if (n == 0)
+    {
+        return 0;
+    }
+
+#if QUARISMA_HAS_MKL
+    if (pivoting && n >= mkl_min_order)
+    {
+        std::vector<lapack_int> ipiv(n);
+        lapack_int const        status = LAPACKE_dgetrf(
+            LAPACK_ROW_MAJOR,
+            static_cast<lapack_int>(n),
+            static_cast<lapack_int>(n),
+            a,
+            static_cast<lapack_int>(lda),
+            ipiv.data());
+        QUARISMA_CHECK(status >= 0, "LAPACKE_dgetrf rejected argument {}", -status);
+        for (size_t k = 0; k < n; ++k)
+        {
+            pivots[k] = static_cast<int>(ipiv[k] - 1);
+        }
+        return static_cast<int>(status);
+    }
+#endif
+
+    return factor(a, n, n, lda, pivots);
+}
+
+void lu_solve(
+    const double* lu, size_t n, size_t lda, const int* pivots, double* b, size_t nrhs, size_t ldb)
+{
+    QUARISMA_CHECK(lda >= n, "lu_solve: row stride {} is shorter than the order {}", lda, n);
+    QUARISMA_CHECK(ldb >= nrhs, "lu_solve: row stride {} is shorter than {} columns", ldb, nrhs);
+
+    apply_swaps(b, ldb, nrhs, pivots, 0, n);
+    solve_lower_unit(lu, lda, n, b, ldb, nrhs);
+    solve_upper(lu, lda, n, b, ldb, nrhs);
+}
+
+void lu_factor_batched(double* a, size_t n, size_t count, int* pivots, int* info)
+{
+    if (n == 0)
+    {
+        std::fill(info, info + count, 0);
+        return;
+    }
+
+    size_t const size  = n * n;
+    size_t const grain = std::max<size_t>(1, batch_work / (size * n));
+    if (n <= batch_max_order)
+    {
+        auto const kernel = detail::batch_factor_stub.selected();
+        run(count,
+            grain,
+            [=](size_t begin, size_t end)
+            {
+                kernel(
+                    pivoting, a + begin * size, n, end - begin, pivots + begin * n, info + begin);
+            });
+        return;
+    }
+
+    run(count,
+        grain,
+        [=](size_t begin, size_t end)
+        {
+            for (size_t m = begin; m < end; ++m)
+            {
+                info[m] = factor(a + m * size, n, n, n, pivots + m * n);
+            }
+        });
+}
+
+void lu_solve_batched(const double* lu, size_t n, size_t count, const int* pivots, double* b)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    size_t const size  = n * n;
+    size_t const grain = std::max<size_t>(1, batch_work / size);
+    if (n <= batch_max_order)
+    {
+        auto const kernel = detail::batch_solve_stub.selected();
+        run(count,
+            grain,
+            [=](size_t begin, size_t end)
+            { kernel(lu + begin * size, n, end - begin, pivots + begin * n, b + begin * n); });
+        return;
+    }
+
+    run(count,
+        grain,
+        [=](size_t begin, size_t end)
+        {
+            for (size_t m = begin; m < end; ++m)
+            {
+                lu_solve(lu + m * size, n, n, pivots + m * n, b + m * n, 1, 1);
+            }
+        });
+}
+
+}  // namespace linalg
+}  // namespace quarisma
@@ -0,0 +1,94 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/export.h"
+
+/**
+ * @file lu.h
+ * @brief LU factorization of dense row-major matrices, one large or many small
+ *
+ * A = P L U, L unit lower triangular and U upper triangular, stored over A as
+ * LAPACK's getrf does; pivots[k] is the row swapped with row k at step k, in
+ * order, counting from 0. Partial pivoting, the largest magnitude in each
+ * column, is compiled in with QUARISMA_LU_PIVOTING (CMake
+ * -DQUARISMA_LU_PIVOTING=ON, Bazel --config=lu_pivoting); without it P = I
+ * and pivots[k] = k, which is stable for diagonally dominant or symmetric
+ * positive definite matrices only.
+ *
+ * Large matrices are factored recursively, half the columns at a time, so
+ * that most of the work is a cache-blocked matrix product split across
+ * parallel_tools::parallel_for; with pivoting and MKL (QUARISMA_ENABLE_MKL)
+ * they go to LAPACKE_dgetrf instead. The batched functions factor many small
+ * matrices of the same order, vector lanes across matrices, for orders up
+ * to batch_max_order, which is where their speed matters.
+ *
+ * The factorizations return 0, or k + 1 when U(k, k) is exactly zero, the
+ * first such k; U is then singular, and the factorization is finished but
+ * cannot be used to solve.
+ */
+
+namespace quarisma
+{
+namespace linalg
+{
+
+/** Orders factored a matrix per vector lane by the batched functions; larger ones loop. */
+inline constexpr size_t batch_max_order = 16;
+
+/** Whether this build pivots, QUARISMA_LU_PIVOTING. */
+QUARISMA_API bool lu_pivoting() noexcept;
+
+/**
+ * @brief Factors the n x n matrix a, row i at a + i * lda, in place
+ *
+ * pivots receives n entries. Returns 0, or one plus the step of the first
+ * zero pivot.
+ */
+QUARISMA_API int lu_factor(double* a, size_t n, size_t lda, int* pivots);
+
+/**
+ * @brief Solves A X = B with the factors of lu_factor(), overwriting b with X
+ *
+ * b is n x nrhs, row i at b + i * ldb.
+ */
+QUARISMA_API void lu_solve(
+    const double* lu, size_t n, size_t lda, const int* pivots, double* b, size_t nrhs, size_t ldb);
+
+/**
+ * @brief Factors count n x n matrices stored one after the other, a + m * n * n
+ *
+ * Matrix m gets pivots + m * n and info[m], the return value of lu_factor().
+ * Matrices are split across parallel_tools::parallel_for.
+ */
+QUARISMA_API void lu_factor_batched(double* a, size_t n, size_t count, int* pivots, int* info);
+
+/**
+ * @brief Solves each system of lu_factor_batched() for one right-hand side
+ *
+ * Right-hand side m is b + m * n, overwritten with the solution.
+ */
+QUARISMA_API void lu_solve_batched(
+    const double* lu, size_t n, size_t count, const int* pivots, double* b);
+
+}  // namespace linalg
+}  // namespace quarisma
@@ -0,0 +1,61 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "math/lu.h"
+#include "util/cpu_dispatch.h"
+
+namespace quarisma
+{
+namespace linalg
+{
+namespace detail
+{
+
+/** C -= A B for C m x p, A m x q and B q x p, all row-major with the given row strides. */
+using update_fn = void (*)(
+    size_t        m,
+    size_t        p,
+    size_t        q,
+    const double* a,
+    size_t        lda,
+    const double* b,
+    size_t        ldb,
+    double*       c,
+    size_t        ldc);
+
+/** lu_factor_batched() for n <= batch_max_order, pivoting when pivot is set. */
+using batch_factor_fn =
+    void (*)(bool pivot, double* a, size_t n, size_t count, int* pivots, int* info);
+
+/** lu_solve_batched() for n <= batch_max_order. */
+using batch_solve_fn =
+    void (*)(const double* lu, size_t n, size_t count, const int* pivots, double* b);
+
+// The kernels of cpu/lu_kernel.cpp
+QUARISMA_DECLARE_DISPATCH(update_fn, update_stub);
+QUARISMA_DECLARE_DISPATCH(batch_factor_fn, batch_factor_stub);
+QUARISMA_DECLARE_DISPATCH(batch_solve_fn, batch_solve_stub);
+
+}  // namespace detail
+}  // namespace linalg
+}  // namespace quarisma
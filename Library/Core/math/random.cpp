@@ -0,0 +1,114 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "math/random.h"
+
+#include "math/random_dispatch.h"
+#include "parallel/parallel_tools.h"
+
+namespace quarisma
+{
+namespace random
+{
+namespace detail
+{
+
+QUARISMA_DEFINE_DISPATCH(double_fill_stub);
+QUARISMA_DEFINE_DISPATCH(float_fill_stub);
+
+}  // namespace detail
+
+namespace
+{
+// Every value has its own counter, so the tasks need nothing from each other
+template <typename T, typename Kernel>
+void run(
+    Kernel               kernel,
+    generator            g,
+    detail::distribution d,
+    uint64_t             key,
+    uint64_t             stream,
+    uint64_t             first,
+    T*                   out,
+    size_t               n)
+{
+    if (n <= parallel_grain)
+    {
+        kernel(g, d, key, stream, first, out, n);
+        return;
+    }
+    parallel_tools::parallel_for(
+        0,
+        n,
+        parallel_grain,
+        [=](size_t begin, size_t end)
+        { kernel(g, d, key, stream, first + begin, out + begin, end - begin); });
+}
+}  // namespace
+
+void uniform(generator g, uint64_t key, uint64_t stream, uint64_t first, double* out, size_t n)
+{
+    run(detail::double_fill_stub.selected(),
+        g,
+        detail::distribution::uniform,
+        key,
+        stream,
+        first,
+        out,
+        n);
+}
+
+void uniform(generator g, uint64_t key, uint64_t stream, uint64_t first, float* out, size_t n)
+{
+    run(detail::float_fill_stub.selected(),
+        g,
+        detail::distribution::uniform,
+        key,
+        stream,
+        first,
+        out,
+        n);
+}
+
+void normal(generator g, uint64_t key, uint64_t stream, uint64_t first, double* out, size_t n)
+{
+    run(detail::double_fill_stub.selected(),
+        g,
+        detail::distribution::normal,
+        key,
+        stream,
+        first,
+        out,
+        n);
+}
+
+void normal(generator g, uint64_t key, uint64_t stream, uint64_t first, float* out, size_t n)
+{
+    run(detail::float_fill_stub.selected(),
+        g,
+        detail::distribution::normal,
+        key,
+        stream,
+        first,
+        out,
+        n);
+}
+
+}  // namespace random
+}  // namespace quarisma
@@ -0,0 +1,214 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/export.h"
+#include "common/macros.h"
+
+/**
+ * @file random.h
+ * @brief Counter-based random number generators and their batch fills
+ *
+ * Philox4x32-10 and Threefry4x32-20 (Salmon, Moraes, Dror and Shaw, "Parallel
+ * random numbers: as easy as 1, 2, 3", SC 2011) are keyed bijections of a
+ * 128-bit counter: block n of a stream is generate(counter n, key), with no
+ * state carried from one block to the next. Any thread, task or GPU kernel
+ * can compute any value directly, and a computation split any way across
+ * devices or thread counts draws the same numbers.
+ *
+ * The batch fills address value i of stream (key, stream) as follows:
+ *
+ *     counter = {lo(n), hi(n), lo(stream), hi(stream)}, n = i / per_block
+ *     key     = {lo(key), hi(key)}            (philox4x32)
+ *             = {lo(key), hi(key), 0, 0}      (threefry4x32)
+ *
+ * with per_block values from the four words w of each block:
+ *
+ * | fill            | per_block | value j of the block                        |
+ * |-----------------|-----------|---------------------------------------------|
+ * | uniform, double | 2         | uniform_double(w[2j], w[2j+1])              |
+ * | uniform, float  | 4         | uniform_float(w[j])                         |
+ * | normal, double  | 2         | Box-Muller of the two uniform doubles       |
+ * | normal, float   | 4         | Box-Muller of (w[0], w[1]) and (w[2], w[3]) |
+ *
+ * Uniforms are in the open interval (0, 1). Box-Muller turns u1, u2 into
+ * sqrt(-2 log u1) cos(2 pi u2), then sqrt(-2 log u1) sin(2 pi u2).
+ */
+
+namespace quarisma
+{
+namespace random
+{
+
+/** Four 32-bit words: a counter, or the block generated from it. */
+struct array4x32
+{
+    uint32_t v[4];
+};
+
+/** Philox4x32 with 10 rounds: two 32 x 32 -> 64-bit multiplies per round. */
+struct philox4x32
+{
+    struct key_type
+    {
+        uint32_t v[2];
+    };
+
+    static constexpr int rounds = 10;
+
+    QUARISMA_CUDA_FUNCTION_TYPE static constexpr array4x32 generate(
+        array4x32 counter, key_type key) noexcept
+    {
+        for (int r = 0; r < rounds; ++r)
+        {
+            uint64_t const p0 = uint64_t{0xD2511F53} * counter.v[0];
+            uint64_t const p1 = uint64_t{0xCD9E8D57} * counter.v[2];
+
+            counter = {{
+                static_cast<uint32_t>(p1 >> 32) ^ counter.v[1] ^ key.v[0],
+                static_cast<uint32_t>(p1),
+                static_cast<uint32_t>(p0 >> 32) ^ counter.v[3] ^ key.v[1],
+                static_cast<uint32_t>(p0),
+            }};
+
+            // Weyl sequence of the golden ratio and sqrt(3) - 1
+            key.v[0] += 0x9E3779B9;
+            key.v[1] += 0xBB67AE85;
+        }
+        return counter;
+    }
+};
+
+/** Threefry4x32 with 20 rounds: the Threefish add-rotate-xor mix, no multiplies. */
+struct threefry4x32
+{
+    struct key_type
+    {
+        uint32_t v[4];
+    };
+
+    static constexpr int rounds = 20;
+
+    QUARISMA_CUDA_FUNCTION_TYPE static constexpr array4x32 generate(
+        array4x32 counter, key_type key) noexcept
+    {
+        uint32_t const schedule[5] = {
+            key.v[0],
+            key.v[1],
+            key.v[2],
+            key.v[3],
+            0x1BD11BDA ^ key.v[0] ^ key.v[1] ^ key.v[2] ^ key.v[3]};
+
+        uint32_t x[4] = {
+            counter.v[0] + schedule[0],
+            counter.v[1] + schedule[1],
+            counter.v[2] + schedule[2],
+            counter.v[3] + schedule[3]};
+
+        // Four rounds then key injection s; the rotations repeat every eight rounds
+        for (int s = 1; s <= rounds / 4; ++s)
+        {
+            if (s % 2 == 1)
+            {
+                mix(x[0], x[1], x[2], x[3], 10, 26);
+                mix(x[0], x[3], x[2], x[1], 11, 21);
+                mix(x[0], x[1], x[2], x[3], 13, 27);
+                mix(x[0], x[3], x[2], x[1], 23, 5);
+            }
+            else
+            {
+                mix(x[0], x[1], x[2], x[3], 6, 20);
+                mix(x[0], x[3], x[2], x[1], 17, 11);
+                mix(x[0], x[1], x[2], x[3], 25, 10);
+                mix(x[0], x[3], x[2], x[1], 18, 20);
+            }
+            x[0] += schedule[s % 5];
+            x[1] += schedule[(s + 1) % 5];
+            x[2] += schedule[(s + 2) % 5];
+            x[3] += schedule[(s + 3) % 5] + static_cast<uint32_t>(s);
+        }
+        return {{x[0], x[1], x[2], x[3]}};
+    }
+
+private:
+    // One round: a += b, b = rotl(b, rb) ^ a, and likewise c, d
+    QUARISMA_CUDA_FUNCTION_TYPE static constexpr void mix(
+        uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d, int rb, int rd) noexcept
+    {
+        a += b;
+        b = ((b << rb) | (b >> (32 - rb))) ^ a;
+        c += d;
+        d = ((d << rd) | (d >> (32 - rd))) ^ c;
+    }
+};
+
+/** The 53 bits of hi:lo, from the top, as a double in (0, 1): odd multiples of 2^-54. */
+QUARISMA_CUDA_FUNCTION_TYPE constexpr double uniform_double(uint32_t hi, uint32_t lo) noexcept
+{
+    uint64_t const bits = (uint64_t{hi} << 21) | (lo >> 11);
+    return (static_cast<double>(bits) + 0.5) * 0x1p-53;
+}
+
+/** The top 24 bits of w as a float in (0, 1): odd multiples of 2^-25. */
+QUARISMA_CUDA_FUNCTION_TYPE constexpr float uniform_float(uint32_t w) noexcept
+{
+    return (static_cast<float>(w >> 8) + 0.5f) * 0x1p-24f;
+}
+
+/** Block function of a batch fill. */
+enum class generator : int
+{
+    philox4x32,
+    threefry4x32
+};
+
+/** Values handed to each parallel_tools::parallel_for task */
+inline constexpr size_t parallel_grain = size_t{1} << 14;
+
+/**
+ * @brief Values [first, first + n) of stream (key, stream), uniform in (0, 1)
+ *
+ * Vectorized for every cpu_capability; spans of more than parallel_grain
+ * values are split across parallel_tools::parallel_for. The values do not
+ * depend on the split, the capability or the device, see the table above.
+ */
+QUARISMA_API void uniform(
+    generator g, uint64_t key, uint64_t stream, uint64_t first, double* out, size_t n);
+QUARISMA_API void uniform(
+    generator g, uint64_t key, uint64_t stream, uint64_t first, float* out, size_t n);
+
+/**
+ * @brief Values [first, first + n) of stream (key, stream), standard normal
+ *
+ * Box-Muller, vectorized like uniform(). The cosine of a pair is value 2k,
+ * the sine 2k + 1, so any first and n may be asked for. Results are within
+ * 1e-14 max(1, |z|) of those of std::log, std::cos and std::sin (float:
+ * 1e-6), but not bit for bit.
+ */
+QUARISMA_API void normal(
+    generator g, uint64_t key, uint64_t stream, uint64_t first, double* out, size_t n);
+QUARISMA_API void normal(
+    generator g, uint64_t key, uint64_t stream, uint64_t first, float* out, size_t n);
+
+}  // namespace random
+}  // namespace quarisma
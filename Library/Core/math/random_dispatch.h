@@ -0,0 +1,64 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math/random.h"
+#include "util/cpu_dispatch.h"
+
+namespace quarisma
+{
+namespace random
+{
+namespace detail
+{
+
+enum class distribution : int
+{
+    uniform,
+    normal
+};
+
+/** Writes values [first, first + n) of a stream to out; the kernels of cpu/random_kernel.cpp. */
+using double_fill_fn = void (*)(
+    generator    g,
+    distribution d,
+    uint64_t     key,
+    uint64_t     stream,
+    uint64_t     first,
+    double*      out,
+    size_t       n);
+using float_fill_fn = void (*)(
+    generator    g,
+    distribution d,
+    uint64_t     key,
+    uint64_t     stream,
+    uint64_t     first,
+    float*       out,
+    size_t       n);
+
+QUARISMA_DECLARE_DISPATCH(double_fill_fn, double_fill_stub);
+QUARISMA_DECLARE_DISPATCH(float_fill_fn, float_fill_stub);
+
+}  // namespace detail
+}  // namespace random
+}  // namespace quarisma
@@ -0,0 +1,372 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "math/sobol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "common/macros.h"
+#include "math/sobol_directions.h"
+#include "parallel/parallel_tools.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+constexpr int    bits  = 32;
+constexpr double scale = 0x1p-32;
+
+// Points per task of sobol_generator::generate, and paths per task of brownian_bridge
+constexpr size_t generate_grain  = size_t{1} << 12;
+constexpr size_t transform_grain = size_t{1} << 10;
+
+// Points of generate() blocked so that each row is written contiguously
+constexpr size_t block = 256;
+
+// Of x != 0; the Gray codes of n - 1 and n differ in this bit of n
+int lowest_set_bit(uint64_t x) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+}  // namespace
+
+size_t sobol_generator::max_dimensions() noexcept
+{
+    return detail::sobol_polynomial_count + 1;
+}
+
+size_t sobol_generator::aligned_stride(size_t count) noexcept
+{
+    constexpr size_t lanes = QUARISMA_ALIGNMENT / sizeof(double);
+    return (count + lanes - 1) / lanes * lanes;
+}
+
+sobol_generator::sobol_generator(size_t dimensions)
+    : dimensions_(dimensions), directions_(bits * dimensions), state_(dimensions)
+{
+    QUARISMA_CHECK(
+        dimensions >= 1 && dimensions <= max_dimensions(),
+        "sobol_generator supports 1 to {} dimensions, got {}",
+        max_dimensions(),
+        dimensions);
+
+    // v_k = m_k 2^(32 - k); the first dimension has every m_k = 1
+    for (int k = 0; k < bits; ++k)
+    {
+        directions_[k] = uint32_t{1} << (bits - 1 - k);
+    }
+
+    for (size_t d = 1; d < dimensions; ++d)
+    {
+        detail::sobol_polynomial const& p = detail::sobol_polynomials[d - 1];
+        int const                       s = p.degree;
+
+        uint64_t m[bits];
+        for (int k = 0; k < bits; ++k)
+        {
+            if (k < s)
+            {
+                m[k] = p.m[k];
+                continue;
+            }
+
+            // m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^s m_(k-s) ^ m_(k-s)
+            m[k] = m[k - s] ^ (m[k - s] << s);
+            for (int j = 1; j < s; ++j)
+            {
+                if (((p.coefficients >> (s - 1 - j)) & 1) != 0)
+                {
+                    m[k] ^= m[k - j] << j;
+                }
+            }
+        }
+
+        uint32_t* v = directions_.data() + bits * d;
+        for (int k = 0; k < bits; ++k)
+        {
+            v[k] = static_cast<uint32_t>(m[k] << (bits - 1 - k));
+        }
+    }
+}
+
+void sobol_generator::state_at(uint64_t index, uint32_t* state) const noexcept
+{
+    uint64_t const gray = index ^ (index >> 1);
+    for (size_t d = 0; d < dimensions_; ++d)
+    {
+        const uint32_t* v = directions(d);
+        uint32_t        x = 0;
+        for (int k = 0; k < bits; ++k)
+        {
+            if (((gray >> k) & 1) != 0)
+            {
+                x ^= v[k];
+            }
+        }
+        state[d] = x;
+    }
+}
+
+void sobol_generator::skip_to(uint64_t index)
+{
+    QUARISMA_CHECK(index < max_points, "Sobol point {} is past the last, 2^32 - 1", index);
+    state_at(index, state_.data());
+    index_ = index;
+}
+
+void sobol_generator::advance() noexcept
+{
+    ++index_;
+    if (index_ == max_points)
+    {
+        return;
+    }
+
+    int const k = lowest_set_bit(index_);
+    for (size_t d = 0; d < dimensions_; ++d)
+    {
+        state_[d] ^= directions(d)[k];
+    }
+}
+
+void sobol_generator::next(uint32_t* point)
+{
+    QUARISMA_CHECK(index_ < max_points, "the Sobol sequence has no points past 2^32 - 1");
+    std::copy(state_.begin(), state_.end(), point);
+    advance();
+}
+
+void sobol_generator::next(double* point)
+{
+    QUARISMA_CHECK(index_ < max_points, "the Sobol sequence has no points past 2^32 - 1");
+    for (size_t d = 0; d < dimensions_; ++d)
+    {
+        point[d] = static_cast<double>(state_[d]) * scale;
+    }
+    advance();
+}
+
+void sobol_generator::generate(uint64_t first, size_t count, double* out, size_t stride) const
+{
+    QUARISMA_CHECK(
+        first <= max_points && count <= max_points - first,
+        "Sobol points {} to {} are past the last, 2^32 - 1",
+        first,
+        first + count);
+    QUARISMA_CHECK(stride >= count, "stride {} is shorter than the {} points", stride, count);
+
+    parallel_tools::parallel_for(
+        0,
+        count,
+        generate_grain,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<uint32_t> state(dimensions_);
+            state_at(first + begin, state.data());
+
+            // Direction to apply after each point of the block, shared by every dimension
+            int step[block];
+            for (size_t i = begin; i < end; i += block)
+            {
+                size_t const n = std::min(block, end - i);
+                for (size_t j = 0; j < n; ++j)
+                {
+                    // The point after the last has no Gray code; its state is never read
+                    step[j] = std::min(lowest_set_bit(first + i + j + 1), bits - 1);
+                }
+
+                for (size_t d = 0; d < dimensions_; ++d)
+                {
+                    const uint32_t* v   = directions(d);
+                    double*         row = out + d * stride + i;
+                    uint32_t        x   = state[d];
+                    for (size_t j = 0; j < n; ++j)
+                    {
+                        row[j] = static_cast<double>(x) * scale;
+                        x ^= v[step[j]];
+                    }
+                    state[d] = x;
+                }
+            }
+        });
+}
+
+brownian_bridge::brownian_bridge(size_t steps) : times_(steps)
+{
+    for (size_t i = 0; i < steps; ++i)
+    {
+        times_[i] = static_cast<double>(i + 1);
+    }
+    initialize();
+}
+
+brownian_bridge::brownian_bridge(std::vector<double> times) : times_(std::move(times))
+{
+    initialize();
+}
+
+void brownian_bridge::initialize()
+{
+    size_t const n = times_.size();
+    QUARISMA_CHECK(n > 0, "brownian_bridge needs at least one step");
+    for (size_t i = 0; i < n; ++i)
+    {
+        double const previous = i == 0 ? 0.0 : times_[i - 1];
+        QUARISMA_CHECK(
+            times_[i] > previous,
+            "brownian_bridge times must be positive and increasing, got {} after {}",
+            times_[i],
+            previous);
+    }
+
+    bridge_.assign(n, 0);
+    left_.assign(n, 0);
+    right_.assign(n, 0);
+    left_weight_.assign(n, 0.0);
+    right_weight_.assign(n, 0.0);
+    std_dev_.assign(n, 0.0);
+
+    // set[i] != 0 once W(t_i) is constructed; the terminal value comes first
+    std::vector<char> set(n, 0);
+    set[n - 1]  = 1;
+    bridge_[0]  = n - 1;
+    std_dev_[0] = std::sqrt(times_[n - 1]);
+
+    // Sweep the gaps left to right, bisecting each, until every time is set
+    size_t j = 0;
+    for (size_t i = 1; i < n; ++i)
+    {
+        while (set[j] != 0)
+        {
+            ++j;
+        }
+        size_t k = j;
+        while (set[k] == 0)
+        {
+            ++k;
+        }
+
+        // W(t_l), l the midpoint of the gap [j, k - 1], from W(t_(j-1)) and W(t_k)
+        size_t const l = j + ((k - 1 - j) >> 1);
+        set[l]         = 1;
+        bridge_[i]     = l;
+        left_[i]       = j;
+        right_[i]      = k;
+
+        double const t_left = j == 0 ? 0.0 : times_[j - 1];
+        double const span   = times_[k] - t_left;
+        left_weight_[i]     = (times_[k] - times_[l]) / span;
+        right_weight_[i]    = (times_[l] - t_left) / span;
+        std_dev_[i]         = std::sqrt((times_[l] - t_left) * (times_[k] - times_[l]) / span);
+
+        j = k + 1 < n ? k + 1 : 0;
+    }
+}
+
+void brownian_bridge::transform(const double* normals, double* increments) const
+{
+    size_t const n = times_.size();
+
+    // Build W(t_i) in place, then difference it
+    double* w = increments;
+    w[n - 1]  = std_dev_[0] * normals[0];
+    for (size_t i = 1; i < n; ++i)
+    {
+        double const left = left_[i] == 0 ? 0.0 : w[left_[i] - 1];
+        w[bridge_[i]] =
+            left_weight_[i] * left + right_weight_[i] * w[right_[i]] + std_dev_[i] * normals[i];
+    }
+
+    for (size_t i = n; --i > 0;)
+    {
+        w[i] -= w[i - 1];
+    }
+}
+
+void brownian_bridge::transform(
+    const double* normals, double* increments, size_t count, size_t stride) const
+{
+    QUARISMA_CHECK(stride >= count, "stride {} is shorter than the {} paths", stride, count);
+    size_t const n = times_.size();
+
+    // The single-path recurrences row by row, over a contiguous range of paths
+    parallel_tools::parallel_for(
+        0,
+        count,
+        transform_grain,
+        [&](size_t begin, size_t end)
+        {
+            const double* z = normals + begin;
+            double*       w = increments + begin;
+            size_t const  m = end - begin;
+
+            double*      terminal = w + (n - 1) * stride;
+            double const sd0      = std_dev_[0];
+            for (size_t p = 0; p < m; ++p)
+            {
+                terminal[p] = sd0 * z[p];
+            }
+
+            for (size_t i = 1; i < n; ++i)
+            {
+                double*       target = w + bridge_[i] * stride;
+                const double* right  = w + right_[i] * stride;
+                const double* normal = z + i * stride;
+                double const  wr     = right_weight_[i];
+                double const  sd     = std_dev_[i];
+                if (left_[i] == 0)
+                {
+                    for (size_t p = 0; p < m; ++p)
+                    {
+                        target[p] = wr * right[p] + sd * normal[p];
+                    }
+                }
+                else
+                {
+                    const double* left = w + (left_[i] - 1) * stride;
+                    double const  wl   = left_weight_[i];
+                    for (size_t p = 0; p < m; ++p)
+                    {
+                        target[p] = wl * left[p] + wr * right[p] + sd * normal[p];
+                    }
+                }
+            }
+
+            for (size_t i = n; --i > 0;)
+            {
+                double*       row      = w + i * stride;
+                const double* previous = w + (i - 1) * stride;
+                for (size_t p = 0; p < m; ++p)
+                {
+                    row[p] -= previous[p];
+                }
+            }
+        });
+}
+
+}  // namespace quarisma
@@ -0,0 +1,168 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/export.h"
+
+/**
+ * @file sobol.h
+ * @brief Sobol low-discrepancy sequences and the Brownian bridge for quasi-Monte Carlo
+ *
+ * sobol_generator yields the points of a Sobol sequence from Joe and Kuo's
+ * direction numbers: 1111 dimensions when built with QUARISMA_SOBOL_1111
+ * (CMake -DQUARISMA_SOBOL_1111=ON, Bazel --config=sobol_1111), 32 without.
+ * Points are in Gray-code order, so any index can be reached in O(dimensions)
+ * and the batches of different parallel_tools::parallel_for tasks are the
+ * same points a single thread would produce.
+ *
+ * A typical path generation, one row per dimension and one column per path:
+ *
+ *     sobol_generator sobol(steps);
+ *     size_t const    stride = sobol_generator::aligned_stride(paths);
+ *     // z and dw: steps * stride doubles, aligned to QUARISMA_ALIGNMENT
+ *     sobol.generate(1, paths, z, stride);
+ *     for (size_t d = 0; d < steps; ++d)
+ *         vmath::norm_inv_cdf(z + d * stride, z + d * stride, paths);
+ *     brownian_bridge(steps).transform(z, dw, paths, stride);
+ *
+ * Point 0 is the origin, which norm_inv_cdf maps to -infinity: start at 1.
+ */
+
+namespace quarisma
+{
+
+class QUARISMA_VISIBILITY sobol_generator
+{
+public:
+    /** Points of the sequence: the direction numbers have 32 bits. */
+    static constexpr uint64_t max_points = uint64_t{1} << 32;
+
+    /** Dimensions of this build's direction table. */
+    static QUARISMA_API size_t max_dimensions() noexcept;
+
+    /**
+     * @brief Smallest stride of at least count doubles that keeps rows aligned
+     *
+     * Rows of a buffer aligned to QUARISMA_ALIGNMENT then all start on a
+     * QUARISMA_ALIGNMENT boundary.
+     */
+    static QUARISMA_API size_t aligned_stride(size_t count) noexcept;
+
+    /** Throws unless 1 <= dimensions <= max_dimensions(); starts at point 0. */
+    QUARISMA_API explicit sobol_generator(size_t dimensions);
+
+    size_t dimensions() const noexcept { return dimensions_; }
+
+    /** Index of the point next() writes. */
+    uint64_t index() const noexcept { return index_; }
+
+    /** Moves to point index < max_points, in O(dimensions * 32). */
+    QUARISMA_API void skip_to(uint64_t index);
+
+    /** Writes the dimensions() coordinates of the current point, in [0, 1), and advances. */
+    QUARISMA_API void next(double* point);
+
+    /** The coordinates as 32-bit fractions, x = point[d] / 2^32. */
+    QUARISMA_API void next(uint32_t* point);
+
+    /**
+     * @brief Points [first, first + count) in dimension-major order
+     *
+     * Coordinate d of point first + i goes to out[d * stride + i], stride >=
+     * count, so that each dimension is a contiguous row. Batches larger than
+     * a few thousand points are split across parallel_tools::parallel_for.
+     * Does not move index().
+     */
+    QUARISMA_API void generate(uint64_t first, size_t count, double* out, size_t stride) const;
+
+private:
+    // The state of a point is the XOR of the directions of the set bits of its Gray code
+    void state_at(uint64_t index, uint32_t* state) const noexcept;
+
+    // Moves state_ from point index_ to index_ + 1
+    void advance() noexcept;
+
+    // Row d: the 32 direction numbers v_1 ... v_32 of dimension d
+    const uint32_t* directions(size_t d) const noexcept { return directions_.data() + 32 * d; }
+
+    size_t                dimensions_;
+    uint64_t              index_ = 0;
+    std::vector<uint32_t> directions_;
+    std::vector<uint32_t> state_;
+};
+
+/**
+ * @brief Brownian bridge construction of Wiener paths from standard normals
+ *
+ * The first normal fixes the terminal value, the next the midpoint, and so on
+ * by bisection, so that the lowest dimensions of a low-discrepancy sequence,
+ * the best distributed, set the coarse shape of the path and most of its
+ * variance.
+ */
+class QUARISMA_VISIBILITY brownian_bridge
+{
+public:
+    /** Steps at the times 1, 2, ..., steps. */
+    QUARISMA_API explicit brownian_bridge(size_t steps);
+
+    /** Steps at the given increasing, positive times. */
+    QUARISMA_API explicit brownian_bridge(std::vector<double> times);
+
+    size_t steps() const noexcept { return times_.size(); }
+
+    const std::vector<double>& times() const noexcept { return times_; }
+
+    /**
+     * @brief Increments W(t_i) - W(t_(i-1)) of one path, t_0 = 0
+     *
+     * normals and increments hold steps() values each and must not overlap.
+     */
+    QUARISMA_API void transform(const double* normals, double* increments) const;
+
+    /**
+     * @brief The increments of count paths, in the layout of sobol_generator::generate
+     *
+     * Row i, normals[i * stride + p], is dimension i of path p; the
+     * increments of step i go to the same place in increments. Many paths are
+     * split across parallel_tools::parallel_for.
+     */
+    QUARISMA_API void transform(
+        const double* normals, double* increments, size_t count, size_t stride) const;
+
+private:
+    void initialize();
+
+    std::vector<double> times_;
+
+    // Step i of the construction sets W at bridge_[i] from W at left_[i] - 1 (0 for
+    // W(t_0) = 0) and right_[i]
+    std::vector<size_t> bridge_;
+    std::vector<size_t> left_;
+    std::vector<size_t> right_;
+    std::vector<double> left_weight_;
+    std::vector<double> right_weight_;
+    std::vector<double> std_dev_;
+};
+
+}  // namespace quarisma
@@ -0,0 +1,48 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace quarisma
+{
+namespace detail
+{
+
+/** Primitive polynomial of one Sobol dimension and its initial direction numbers. */
+struct sobol_polynomial
+{
+    /** Degree s of the polynomial. */
+    uint16_t degree;
+
+    /** Coefficients a_1 ... a_(s-1), a_1 in the highest bit; a_0 = a_s = 1 are implied. */
+    uint16_t coefficients;
+
+    /** Odd m_1 ... m_s, m_k < 2^k; the entries past degree are zero. */
+    uint16_t m[13];
+};
+
+/** Dimensions 2 and up: 1110 with QUARISMA_SOBOL_1111, 31 without. */
+extern const sobol_polynomial sobol_polynomials[];
+extern const size_t           sobol_polynomial_count;
+
+}  // namespace detail
+}  // namespace quarisma
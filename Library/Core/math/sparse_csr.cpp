@@ -0,0 +1,245 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "math/sparse_csr.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "math/sparse_csr_dispatch.h"
+#include "parallel/parallel_tools.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_MKL
+#include <mkl_spblas.h>
+#endif
+
+namespace quarisma
+{
+namespace linalg
+{
+namespace detail
+{
+
+QUARISMA_DEFINE_DISPATCH(spmv_rows_stub);
+QUARISMA_DEFINE_DISPATCH(spmm_rows_stub);
+
+}  // namespace detail
+
+namespace
+{
+// Multiply-adds below which a product stays on the calling thread
+constexpr size_t parallel_work = size_t{1} << 16;
+
+// Ranges per thread, so that rows costlier than their nonzeros even out
+constexpr size_t parts_per_thread = 4;
+
+#if QUARISMA_HAS_MKL
+// Nonzeros below which the handle and descriptor setup of MKL costs more than it saves
+constexpr size_t mkl_min_nnz = size_t{1} << 16;
+
+// Runs product(handle, descriptor) on an MKL handle over a, returning false
+// when MKL cannot take a: 32-bit MKL_INT, or a status other than success
+template <typename Product>
+bool run_mkl(const csr_view& a, Product const& product)
+{
+    if constexpr (sizeof(MKL_INT) != sizeof(int64_t))
+    {
+        return false;
+    }
+    else
+    {
+        if (a.nnz() < mkl_min_nnz)
+        {
+            return false;
+        }
+        // MKL takes mutable arrays but does not write them
+        auto*           offsets = reinterpret_cast<MKL_INT*>(const_cast<int64_t*>(a.row_offsets));
+        sparse_matrix_t handle  = nullptr;
+        if (mkl_sparse_d_create_csr(
+                &handle,
+                SPARSE_INDEX_BASE_ZERO,
+                static_cast<MKL_INT>(a.rows),
+                static_cast<MKL_INT>(a.cols),
+                offsets,
+                offsets + 1,
+                reinterpret_cast<MKL_INT*>(const_cast<int64_t*>(a.columns)),
+                const_cast<double*>(a.values)) != SPARSE_STATUS_SUCCESS)
+        {
+            return false;
+        }
+        matrix_descr descriptor{};
+        descriptor.type         = SPARSE_MATRIX_TYPE_GENERAL;
+        sparse_status_t const s = product(handle, descriptor);
+        mkl_sparse_destroy(handle);
+        return s == SPARSE_STATUS_SUCCESS;
+    }
+}
+#endif
+
+/// Runs rows(first, last) over the rows of a, in nonzero-balanced ranges
+/// across threads when the product is large
+template <typename Rows>
+void run(const csr_view& a, size_t work, Rows const& rows)
+{
+    if (work < parallel_work || parallel_tools::is_parallel_scope())
+    {
+        rows(0, a.rows);
+        return;
+    }
+    auto const threads = static_cast<size_t>(parallel_tools::estimated_number_of_threads());
+    auto const bounds  = csr_partition(a, threads * parts_per_thread);
+    parallel_tools::parallel_for(
+        0,
+        bounds.size() - 1,
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t r = begin; r < end; ++r)
+            {
+                rows(bounds[r], bounds[r + 1]);
+            }
+        });
+}
+
+void check(const csr_view& a)
+{
+    QUARISMA_CHECK(
+        a.rows == 0 || (a.row_offsets != nullptr && a.row_offsets[0] == 0),
+        "sparse_csr: row offsets must start at 0");
+}
+}  // namespace
+
+std::vector<size_t> csr_partition(const csr_view& a, size_t parts)
+{
+    std::vector<size_t> bounds{0};
+    if (a.rows == 0)
+    {
+        return bounds;
+    }
+
+    // Work before row i is row_offsets[i] + i, increasing in i
+    parts             = std::clamp<size_t>(parts, 1, a.rows);
+    size_t const work = a.nnz() + a.rows;
+    size_t       row  = 0;
+    for (size_t r = 1; r < parts; ++r)
+    {
+        size_t const target = work * r / parts;
+        size_t       lo     = row + 1;
+        size_t       hi     = a.rows;
+        while (lo < hi)
+        {
+            size_t const mid = lo + (hi - lo) / 2;
+            if (static_cast<size_t>(a.row_offsets[mid]) + mid < target)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        if (lo < a.rows)
+        {
+            row = lo;
+            bounds.push_back(row);
+        }
+    }
+    bounds.push_back(a.rows);
+    return bounds;
+}
+
+void csr_spmv(const csr_view& a, const double* x, double* y, double alpha, double beta)
+{
+    check(a);
+    if (a.rows == 0)
+    {
+        return;
+    }
+
+#if QUARISMA_HAS_MKL
+    bool const done = run_mkl(
+        a,
+        [&](sparse_matrix_t handle, matrix_descr descriptor)
+        {
+            return mkl_sparse_d_mv(
+                SPARSE_OPERATION_NON_TRANSPOSE, alpha, handle, descriptor, x, beta, y);
+        });
+    if (done)
+    {
+        return;
+    }
+#endif
+
+    auto const kernel = detail::spmv_rows_stub.selected();
+    run(a, a.nnz() + a.rows, [&](size_t first, size_t last)
+        { kernel(a, first, last, x, y, alpha, beta); });
+}
+
+void csr_spmm(
+    const csr_view& a,
+    const double*   b,
+    size_t          p,
+    size_t          ldb,
+    double*         c,
+    size_t          ldc,
+    double          alpha,
+    double          beta)
+{
+    check(a);
+    QUARISMA_CHECK(ldb >= p, "csr_spmm: row stride {} of B is shorter than {} columns", ldb, p);
+    QUARISMA_CHECK(ldc >= p, "csr_spmm: row stride {} of C is shorter than {} columns", ldc, p);
+    if (a.rows == 0 || p == 0)
+    {
+        return;
+    }
+
+#if QUARISMA_HAS_MKL
+    bool const done = run_mkl(
+        a,
+        [&](sparse_matrix_t handle, matrix_descr descriptor)
+        {
+            return mkl_sparse_d_mm(
+                SPARSE_OPERATION_NON_TRANSPOSE,
+                alpha,
+                handle,
+                descriptor,
+                SPARSE_LAYOUT_ROW_MAJOR,
+                b,
+                static_cast<MKL_INT>(p),
+                static_cast<MKL_INT>(ldb),
+                beta,
+                c,
+                static_cast<MKL_INT>(ldc));
+        });
+    if (done)
+    {
+        return;
+    }
+#endif
+
+    auto const kernel = detail::spmm_rows_stub.selected();
+    run(a, (a.nnz() + a.rows) * p, [&](size_t first, size_t last)
+        { kernel(a, first, last, b, p, ldb, c, ldc, alpha, beta); });
+}
+
+}  // namespace linalg
+}  // namespace quarisma
@@ -0,0 +1,97 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/export.h"
+
+/**
+ * @file sparse_csr.h
+ * @brief Products of sparse CSR matrices with dense vectors and matrices
+ *
+ * A is rows x cols in compressed sparse row form: the nonzeros of row i are
+ * values[k] in column columns[k] for k in [row_offsets[i], row_offsets[i + 1]),
+ * indices counting from 0 and row_offsets[0] = 0, as in the crow_indices,
+ * col_indices and values of a torch.sparse_csr tensor.
+ *
+ * Rows are split across parallel_tools::parallel_for in ranges of about the
+ * same number of nonzeros (csr_partition()), not the same number of rows, so
+ * that a few dense rows, a boundary layer of a PDE grid or the factors of a
+ * correlation matrix, do not leave the other threads idle. Within a row the
+ * products are accumulated in vector lanes: gathered from x for SpMV, along
+ * the columns of B for SpMM. With MKL (QUARISMA_ENABLE_MKL) built with 64-bit
+ * integers, large matrices go to its sparse BLAS instead.
+ */
+
+namespace quarisma
+{
+namespace linalg
+{
+
+/** A rows x cols CSR matrix, see the file comment. */
+struct csr_view
+{
+    size_t         rows        = 0;
+    size_t         cols        = 0;
+    const int64_t* row_offsets = nullptr;  ///< rows + 1 entries
+    const int64_t* columns     = nullptr;  ///< row_offsets[rows] entries
+    const double*  values      = nullptr;  ///< row_offsets[rows] entries
+
+    size_t nnz() const noexcept { return rows == 0 ? 0 : static_cast<size_t>(row_offsets[rows]); }
+};
+
+/**
+ * @brief Splits the rows of a into at most parts ranges of about equal work
+ *
+ * The work of a row is its nonzeros plus one. Returns the first row of each
+ * range followed by a.rows, so range r is [result[r], result[r + 1]); ranges
+ * are not empty.
+ */
+QUARISMA_API std::vector<size_t> csr_partition(const csr_view& a, size_t parts);
+
+/**
+ * @brief y = alpha A x + beta y
+ *
+ * x has a.cols entries and y a.rows; y is not read when beta is 0.
+ */
+QUARISMA_API void csr_spmv(
+    const csr_view& a, const double* x, double* y, double alpha = 1.0, double beta = 0.0);
+
+/**
+ * @brief C = alpha A B + beta C
+ *
+ * B is a.cols x p, row k at b + k * ldb, and C a.rows x p, row i at
+ * c + i * ldc; C is not read when beta is 0.
+ */
+QUARISMA_API void csr_spmm(
+    const csr_view& a,
+    const double*   b,
+    size_t          p,
+    size_t          ldb,
+    double*         c,
+    size_t          ldc,
+    double          alpha = 1.0,
+    double          beta  = 0.0);
+
+}  // namespace linalg
+}  // namespace quarisma
@@ -0,0 +1,63 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "math/sparse_csr.h"
+#include "util/cpu_dispatch.h"
+
+namespace quarisma
+{
+namespace linalg
+{
+namespace detail
+{
+
+/** csr_spmv() for the rows [first, last) of a. */
+using spmv_rows_fn = void (*)(
+    const csr_view& a,
+    size_t          first,
+    size_t          last,
+    const double*   x,
+    double*         y,
+    double          alpha,
+    double          beta);
+
+/** csr_spmm() for the rows [first, last) of a. */
+using spmm_rows_fn = void (*)(
+    const csr_view& a,
+    size_t          first,
+    size_t          last,
+    const double*   b,
+    size_t          p,
+    size_t          ldb,
+    double*         c,
+    size_t          ldc,
+    double          alpha,
+    double          beta);
+
+// The kernels of cpu/sparse_csr_kernel.cpp
+QUARISMA_DECLARE_DISPATCH(spmv_rows_fn, spmv_rows_stub);
+QUARISMA_DECLARE_DISPATCH(spmm_rows_fn, spmm_rows_stub);
+
+}  // namespace detail
+}  // namespace linalg
+}  // namespace quarisma
@@ -0,0 +1,161 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "math/vmath.h"
+
+#include <algorithm>
+
+#include "math/vmath_dispatch.h"
+#include "parallel/parallel_tools.h"
+
+namespace quarisma
+{
+namespace vmath
+{
+namespace detail
+{
+
+QUARISMA_DEFINE_DISPATCH(double_kernel_stub);
+QUARISMA_DEFINE_DISPATCH(float_kernel_stub);
+
+}  // namespace detail
+
+namespace
+{
+// Splits [0, n) into tasks of parallel_grain elements; block(begin, end) runs one
+template <typename Block>
+void run(size_t n, Block const& block)
+{
+    if (n <= parallel_grain)
+    {
+        block(0, n);
+        return;
+    }
+    parallel_tools::parallel_for(0, n, parallel_grain, block);
+}
+
+void run(detail::function fn, accuracy a, const double* x, double* y, size_t n)
+{
+    auto const kernel = detail::double_kernel_stub.selected();
+    run(n, [=](size_t begin, size_t end) { kernel(fn, a, x + begin, y + begin, end - begin); });
+}
+
+void run(detail::function fn, accuracy a, const float* x, float* y, size_t n)
+{
+    auto const kernel = detail::float_kernel_stub.selected();
+    run(n, [=](size_t begin, size_t end) { kernel(fn, a, x + begin, y + begin, end - begin); });
+}
+
+// The float erf family goes through the double kernel, a stack buffer at a time: the
+// fast double tier is within 2^-26, so every float tier rounds to within 1 ulp
+void run_widened(detail::function fn, accuracy a, const float* x, float* y, size_t n)
+{
+    auto const     kernel = detail::double_kernel_stub.selected();
+    accuracy const wide   = a == accuracy::fast ? accuracy::fast : accuracy::medium;
+    run(n,
+        [=](size_t begin, size_t end)
+        {
+            constexpr size_t chunk = 512;
+            double           buffer[chunk];
+            for (size_t i = begin; i < end; i += chunk)
+            {
+                size_t const count = std::min(chunk, end - i);
+                std::copy_n(x + i, count, buffer);
+                kernel(fn, wide, buffer, buffer, count);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    y[i + j] = static_cast<float>(buffer[j]);
+                }
+            }
+        });
+}
+}  // namespace
+
+void exp(const double* x, double* y, size_t n, accuracy a)
+{
+    run(detail::function::exp, a, x, y, n);
+}
+
+void exp(const float* x, float* y, size_t n, accuracy a)
+{
+    run(detail::function::exp, a, x, y, n);
+}
+
+void log(const double* x, double* y, size_t n, accuracy a)
+{
+    run(detail::function::log, a, x, y, n);
+}
+
+void log(const float* x, float* y, size_t n, accuracy a)
+{
+    run(detail::function::log, a, x, y, n);
+}
+
+void sqrt(const double* x, double* y, size_t n, accuracy a)
+{
+    run(detail::function::sqrt, a, x, y, n);
+}
+
+void sqrt(const float* x, float* y, size_t n, accuracy a)
+{
+    run(detail::function::sqrt, a, x, y, n);
+}
+
+void erf(const double* x, double* y, size_t n, accuracy a)
+{
+    run(detail::function::erf, a, x, y, n);
+}
+
+void erf(const float* x, float* y, size_t n, accuracy a)
+{
+    run_widened(detail::function::erf, a, x, y, n);
+}
+
+void erfc(const double* x, double* y, size_t n, accuracy a)
+{
+    run(detail::function::erfc, a, x, y, n);
+}
+
+void erfc(const float* x, float* y, size_t n, accuracy a)
+{
+    run_widened(detail::function::erfc, a, x, y, n);
+}
+
+void norm_cdf(const double* x, double* y, size_t n, accuracy a)
+{
+    run(detail::function::norm_cdf, a, x, y, n);
+}
+
+void norm_cdf(const float* x, float* y, size_t n, accuracy a)
+{
+    run_widened(detail::function::norm_cdf, a, x, y, n);
+}
+
+void norm_inv_cdf(const double* p, double* y, size_t n, accuracy a)
+{
+    run(detail::function::norm_inv_cdf, a, p, y, n);
+}
+
+void norm_inv_cdf(const float* p, float* y, size_t n, accuracy a)
+{
+    run_widened(detail::function::norm_inv_cdf, a, p, y, n);
+}
+
+}  // namespace vmath
+}  // namespace quarisma
@@ -0,0 +1,102 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/export.h"
+
+/**
+ * @file vmath.h
+ * @brief Transcendental functions over arrays, vectorized and parallel
+ *
+ * Each function computes y[i] = f(x[i]) for i in [0, n), with the vector
+ * kernels of util/simd/vec.h built for every cpu_capability (see
+ * util/cpu_dispatch.h), and splits spans of more than parallel_grain
+ * elements across parallel_tools::parallel_for. x and y may be the same
+ * array, but must not overlap otherwise.
+ *
+ * Errors, measured against long double references over the whole domain;
+ * those of norm_inv_cdf are in ulps of the quantile:
+ *
+ * | function                     | high  | medium | fast                 |
+ * |------------------------------|-------|--------|----------------------|
+ * | exp, log                     | 1 ulp | 4 ulp  | 2^-26 (float: 2^-12) |
+ * | sqrt                         | correctly rounded in every tier        |
+ * | erf                          | 2 ulp | 4 ulp  | 2^-26 (float: 1 ulp) |
+ * | erfc, norm_cdf, norm_inv_cdf | 3 ulp | 4 ulp  | 2^-26 (float: 1 ulp) |
+ *
+ * fast bounds are relative errors, about half the significand; subnormal
+ * results are in ulps of the subnormal range. The float erf, erfc,
+ * norm_cdf and norm_inv_cdf run the double kernels, which round to within
+ * 1 ulp of float at every tier.
+ */
+
+namespace quarisma
+{
+namespace vmath
+{
+
+/** Error bound of a function, see the table of vmath.h. */
+enum class accuracy : int
+{
+    high,    ///< 1 ulp for exp and log, 3 for the erf family
+    medium,  ///< 4 ulp
+    fast     ///< Half the significand: 2^-26 relative for double, 2^-12 for float
+};
+
+/** Elements handed to each parallel_tools::parallel_for task */
+inline constexpr size_t parallel_grain = size_t{1} << 14;
+
+/** e^x; overflow gives infinity, and results underflow gradually to zero. */
+QUARISMA_API void exp(const double* x, double* y, size_t n, accuracy a = accuracy::high);
+QUARISMA_API void exp(const float* x, float* y, size_t n, accuracy a = accuracy::high);
+
+/** Natural logarithm; log(0) is -infinity and log of a negative number NaN. */
+QUARISMA_API void log(const double* x, double* y, size_t n, accuracy a = accuracy::high);
+QUARISMA_API void log(const float* x, float* y, size_t n, accuracy a = accuracy::high);
+
+/** Square root; accuracy only exists for symmetry with the other functions. */
+QUARISMA_API void sqrt(const double* x, double* y, size_t n, accuracy a = accuracy::high);
+QUARISMA_API void sqrt(const float* x, float* y, size_t n, accuracy a = accuracy::high);
+
+/** Error function. */
+QUARISMA_API void erf(const double* x, double* y, size_t n, accuracy a = accuracy::high);
+QUARISMA_API void erf(const float* x, float* y, size_t n, accuracy a = accuracy::high);
+
+/** Complementary error function 1 - erf(x), without the cancellation for large x. */
+QUARISMA_API void erfc(const double* x, double* y, size_t n, accuracy a = accuracy::high);
+QUARISMA_API void erfc(const float* x, float* y, size_t n, accuracy a = accuracy::high);
+
+/** Standard normal cumulative distribution, Phi(x) = erfc(-x / sqrt(2)) / 2. */
+QUARISMA_API void norm_cdf(const double* x, double* y, size_t n, accuracy a = accuracy::high);
+QUARISMA_API void norm_cdf(const float* x, float* y, size_t n, accuracy a = accuracy::high);
+
+/**
+ * @brief Inverse of norm_cdf, the standard normal quantile
+ *
+ * Acklam's rational approximation, refined by one Halley step except in the
+ * fast tier. p of 0 and 1 give -infinity and infinity, p outside [0, 1] NaN.
+ */
+QUARISMA_API void norm_inv_cdf(const double* p, double* y, size_t n, accuracy a = accuracy::high);
+QUARISMA_API void norm_inv_cdf(const float* p, float* y, size_t n, accuracy a = accuracy::high);
+
+}  // namespace vmath
+}  // namespace quarisma
@@ -0,0 +1,56 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "math/vmath.h"
+#include "util/cpu_dispatch.h"
+
+namespace quarisma
+{
+namespace vmath
+{
+namespace detail
+{
+
+enum class function : int
+{
+    exp,
+    log,
+    sqrt,
+    erf,
+    erfc,
+    norm_cdf,
+    norm_inv_cdf
+};
+
+/** Computes y[i] = fn(x[i]) for a block [0, n); the kernels of cpu/vmath_kernel.cpp. */
+using double_kernel_fn = void (*)(function fn, accuracy a, const double* x, double* y, size_t n);
+using float_kernel_fn  = void (*)(function fn, accuracy a, const float* x, float* y, size_t n);
+
+QUARISMA_DECLARE_DISPATCH(double_kernel_fn, double_kernel_stub);
+
+// exp, log and sqrt only: the others run the double kernel
+QUARISMA_DECLARE_DISPATCH(float_kernel_fn, float_kernel_stub);
+
+}  // namespace detail
+}  // namespace vmath
+}  // namespace quarisma
@@ -196,6 +196,40 @@ public:
         ptr = nullptr;
     }
 
+    /**
+     * @brief Allocate memory from a given Allocator, e.g. an arena or allocator_slab
+     * @param n Number of elements to allocate
+     * @param source Allocator to draw the memory from
+     * @return Pointer to allocated memory, aligned to `alignment`
+     * @throws std::bad_alloc if allocation fails
+     */
+    QUARISMA_FORCE_INLINE static pointer allocate(size_type n, Allocator& source)
+    {
+        if (n == 0)
+            return nullptr;
+
+        auto* ptr = static_cast<pointer>(source.allocate_raw(alignment, n * scalar_size));
+        if (!ptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    /**
+     * @brief Free memory obtained from allocate(n, source)
+     * @param ptr Reference to pointer to memory to free (will be set to nullptr)
+     * @param source Allocator the memory was drawn from
+     */
+    QUARISMA_FORCE_INLINE static void free(pointer& ptr, Allocator& source)
+    {
+        if (!ptr)
+            return;
+
+        source.deallocate_raw(ptr);
+        ptr = nullptr;
+    }
+
     /**
      * @brief Copy memory between different memory spaces
      * @param from Source pointer
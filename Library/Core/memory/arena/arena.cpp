@@ -0,0 +1,209 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/arena/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "memory/sub_allocator.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+// Lives at the start of every chunk, the usable bytes follow it.
+struct arena::chunk
+{
+    chunk* next;
+    size_t bytes;  // Bytes received from the sub_allocator
+
+    char* begin() noexcept { return reinterpret_cast<char*>(this + 1); }
+    char* end() noexcept { return reinterpret_cast<char*>(this) + bytes; }
+};
+
+namespace
+{
+constexpr size_t kChunkAlignment = 64;
+}  // namespace
+
+arena::arena(
+    std::unique_ptr<quarisma::sub_allocator> sub_allocator,
+    std::string                              name,
+    const Options&                           opts)
+    : name_(std::move(name)),
+      opts_(opts),
+      sub_allocator_(std::move(sub_allocator)),
+      next_chunk_size_(opts.initial_chunk_size)
+{
+    QUARISMA_CHECK(sub_allocator_ != nullptr, "arena needs a sub_allocator");
+    QUARISMA_CHECK(
+        opts_.initial_chunk_size > sizeof(chunk) &&
+            opts_.initial_chunk_size <= opts_.max_chunk_size,
+        "arena chunk sizes must satisfy {} < initial_chunk_size <= max_chunk_size, got {} and {}",
+        sizeof(chunk),
+        opts_.initial_chunk_size,
+        opts_.max_chunk_size);
+}
+
+arena::~arena()
+{
+    release();
+}
+
+void* arena::AllocateSlow(size_t alignment, size_t num_bytes)
+{
+    QUARISMA_CHECK(
+        alignment != 0 && (alignment & (alignment - 1)) == 0,
+        "arena {}: alignment {} is not a power of two",
+        name_,
+        alignment);
+    num_bytes = std::max<size_t>(num_bytes, 1);
+
+    // Room for the request at any position of a chunk
+    const size_t needed = sizeof(chunk) + std::max(alignment, kChunkAlignment) + num_bytes;
+
+    // Chunks kept by reset() or rewind() are reused first, a new one goes after them
+    chunk* previous = current_;
+    chunk* next     = current_ != nullptr ? current_->next : head_;
+    while (next != nullptr && next->bytes < needed)
+    {
+        previous = next;
+        next     = next->next;
+    }
+
+    if (next == nullptr)
+    {
+        size_t       bytes_received = 0;
+        const size_t chunk_size     = std::max(next_chunk_size_, needed);
+        void*        memory = sub_allocator_->Alloc(kChunkAlignment, chunk_size, &bytes_received);
+        if (memory == nullptr)
+        {
+            return nullptr;
+        }
+        next        = static_cast<chunk*>(memory);
+        next->bytes = bytes_received;
+        next->next  = nullptr;
+        if (previous != nullptr)
+        {
+            previous->next = next;
+        }
+        else
+        {
+            head_ = next;
+        }
+        bytes_reserved_ += bytes_received;
+        next_chunk_size_ = std::min(next_chunk_size_ * 2, opts_.max_chunk_size);
+    }
+    else if (previous != current_)
+    {
+        // Move the fitting chunk right after the current one so that the
+        // skipped, smaller chunks stay reachable
+        previous->next = next->next;
+        if (current_ != nullptr)
+        {
+            next->next     = current_->next;
+            current_->next = next;
+        }
+        else
+        {
+            next->next = head_;
+            head_      = next;
+        }
+    }
+
+    current_ = next;
+    cursor_  = next->begin();
+    limit_   = next->end();
+    return arena::allocate_raw(alignment, num_bytes);
+}
+
+void arena::reset() noexcept
+{
+    peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+    bytes_in_use_      = 0;
+    current_           = head_;
+    cursor_            = head_ != nullptr ? head_->begin() : nullptr;
+    limit_             = head_ != nullptr ? head_->end() : nullptr;
+}
+
+void arena::release() noexcept
+{
+    peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+    while (head_ != nullptr)
+    {
+        chunk* next = head_->next;
+        sub_allocator_->Free(head_, head_->bytes);
+        head_ = next;
+    }
+    current_         = nullptr;
+    cursor_          = nullptr;
+    limit_           = nullptr;
+    bytes_in_use_    = 0;
+    bytes_reserved_  = 0;
+    next_chunk_size_ = opts_.initial_chunk_size;
+}
+
+void arena::rewind(const marker& position) noexcept
+{
+    peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+    if (position.chunk == nullptr)
+    {
+        // Marked before the first allocation: everything goes
+        reset();
+        return;
+    }
+    current_      = static_cast<chunk*>(position.chunk);
+    cursor_       = position.cursor;
+    limit_        = position.limit;
+    bytes_in_use_ = position.bytes_in_use;
+}
+
+std::optional<allocator_stats> arena::GetStats() const
+{
+    allocator_stats stats;
+    stats.num_allocs         = static_cast<int64_t>(num_allocs_);
+    stats.bytes_in_use       = static_cast<int64_t>(bytes_in_use_);
+    stats.peak_bytes_in_use  = static_cast<int64_t>(std::max(peak_bytes_in_use_, bytes_in_use_));
+    stats.largest_alloc_size = static_cast<int64_t>(largest_alloc_size_);
+    stats.bytes_reserved     = static_cast<int64_t>(bytes_reserved_);
+    return stats;
+}
+
+bool arena::ClearStats()
+{
+    num_allocs_         = 0;
+    peak_bytes_in_use_  = bytes_in_use_;
+    largest_alloc_size_ = 0;
+    return true;
+}
+
+#if QUARISMA_HAS_MEMORY_RESOURCE
+void* arena::do_allocate(size_t bytes, size_t alignment)
+{
+    void* ptr = allocate_raw(alignment, bytes);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+#endif
+}  // namespace quarisma
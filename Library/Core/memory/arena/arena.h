@@ -0,0 +1,311 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+
+#include "common/macros.h"
+#include "memory/cpu/allocator.h"
+
+#if QUARISMA_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+
+namespace quarisma
+{
+
+/**
+ * @brief Monotonic (bump pointer) arena for memory that dies all at once.
+ *
+ * An arena hands out memory by advancing a cursor through chunks obtained
+ * from a sub_allocator, and never frees individual blocks: deallocate_raw()
+ * is a no-op. Everything is released at once by reset(), which rewinds the
+ * cursor to the first chunk in O(1) and keeps the chunks for the next round,
+ * or by release(), which returns the chunks to the sub_allocator.
+ *
+ * The arena is both an Allocator and, when the standard library provides
+ * it, a std::pmr::memory_resource, so it plugs into:
+ * - quarisma::allocator<T>::allocate(n, arena) (memory/allocator.h)
+ * - flat_hash_map / flat_hash_set and std containers via arena_allocator<T>
+ * - std::pmr containers via std::pmr::polymorphic_allocator
+ *
+ * **Chunks**: The first chunk has Options::initial_chunk_size bytes, and each
+ * new chunk doubles up to Options::max_chunk_size. A request larger than the
+ * next chunk gets a chunk of its own. Any sub_allocator works: a
+ * basic_cpu_allocator bound to a NUMA node places the whole arena there.
+ *
+ * **Thread Safety**: Not thread-safe; use one arena per request or thread
+ *
+ * **Example Usage**:
+ * ```cpp
+ * arena scratch(std::make_unique<basic_cpu_allocator>(0, {}, {}), "pricing", {});
+ * for (const auto& request : requests)
+ * {
+ *     flat_hash_map<int, double, std::hash<int>, std::equal_to<int>,
+ *                   arena_allocator<std::pair<int, double>>> cache(scratch);
+ *     price(request, cache);
+ *     scratch.reset();  // every temporary of the request is gone
+ * }
+ * ```
+ */
+class QUARISMA_VISIBILITY arena : public Allocator
+#if QUARISMA_HAS_MEMORY_RESOURCE
+    ,
+                                  public std::pmr::memory_resource
+#endif
+{
+public:
+    /**
+     * @brief Configuration options for arena.
+     */
+    struct Options
+    {
+        /** Size of the first chunk in bytes. */
+        size_t initial_chunk_size = 64 << 10;
+
+        /** Upper bound of the geometric chunk growth in bytes. */
+        size_t max_chunk_size = 4 << 20;
+    };
+
+    /**
+     * @brief Position of the arena cursor, see mark() and rewind().
+     */
+    struct marker
+    {
+        void*  chunk;
+        char*  cursor;
+        char*  limit;
+        size_t bytes_in_use;
+    };
+
+    /**
+     * @brief Constructs an empty arena; the first chunk is obtained lazily.
+     *
+     * @param sub_allocator Backend providing the chunks (takes ownership)
+     * @param name Human-readable name for debugging
+     * @param opts Chunk sizing options
+     */
+    QUARISMA_API arena(
+        std::unique_ptr<quarisma::sub_allocator> sub_allocator,
+        std::string                              name,
+        const Options&                           opts);
+
+    /**
+     * @brief Returns every chunk to the sub_allocator.
+     */
+    QUARISMA_API ~arena() override;
+
+    std::string Name() const override { return name_; }
+
+    /**
+     * @brief Allocates `num_bytes` aligned to `alignment` (a power of two).
+     *
+     * A zero-byte request returns a valid pointer.
+     *
+     * @return Pointer to the block, or nullptr if the sub_allocator is exhausted
+     *
+     * **Performance**: O(1); an align and a compare-and-add in the common case
+     */
+    void* allocate_raw(size_t alignment, size_t num_bytes) override
+    {
+        const auto cursor  = reinterpret_cast<uintptr_t>(cursor_);
+        const auto limit   = reinterpret_cast<uintptr_t>(limit_);
+        const auto address = (cursor + alignment - 1) & ~(uintptr_t{alignment} - 1);
+        if (address < limit && num_bytes <= limit - address)
+        {
+            cursor_ = reinterpret_cast<char*>(address + num_bytes);
+            RecordAllocation(num_bytes);
+            return reinterpret_cast<void*>(address);
+        }
+        return AllocateSlow(alignment, num_bytes);
+    }
+
+    /**
+     * @brief No-op: arena memory is only reclaimed by reset(), rewind() or release().
+     */
+    void deallocate_raw(QUARISMA_UNUSED void* ptr) override {}
+
+    QUARISMA_API std::optional<allocator_stats> GetStats() const override;
+
+    QUARISMA_API bool ClearStats() override;
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return sub_allocator_->GetMemoryType();
+    }
+
+    /**
+     * @brief Frees every block at once and keeps the chunks for reuse.
+     *
+     * **Performance**: O(1)
+     */
+    QUARISMA_API void reset() noexcept;
+
+    /**
+     * @brief Frees every block at once and returns the chunks to the sub_allocator.
+     *
+     * **Performance**: O(number of chunks)
+     */
+    QUARISMA_API void release() noexcept;
+
+    /**
+     * @brief Current cursor position, to free everything allocated after it
+     * with rewind().
+     */
+    marker mark() const noexcept { return {current_, cursor_, limit_, bytes_in_use_}; }
+
+    /**
+     * @brief Frees every block allocated since `position` was taken. Chunks
+     * obtained in the meantime are kept for reuse.
+     *
+     * **Performance**: O(1)
+     */
+    QUARISMA_API void rewind(const marker& position) noexcept;
+
+    /** Bytes handed out since the last reset(). */
+    size_t bytes_in_use() const noexcept { return bytes_in_use_; }
+
+    /** Bytes held in chunks. */
+    size_t bytes_reserved() const noexcept { return bytes_reserved_; }
+
+    /**
+     * @brief RAII scope: everything allocated during its lifetime is freed when
+     * it is destroyed. Scopes nest.
+     */
+    class scope
+    {
+    public:
+        explicit scope(arena& owner) noexcept : owner_(owner), position_(owner.mark()) {}
+        ~scope() { owner_.rewind(position_); }
+
+        scope(const scope&)            = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        arena& owner_;
+        marker position_;
+    };
+
+#if QUARISMA_HAS_MEMORY_RESOURCE
+protected:
+    QUARISMA_API void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(
+        QUARISMA_UNUSED void* ptr,
+        QUARISMA_UNUSED size_t bytes,
+        QUARISMA_UNUSED size_t alignment) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+#endif
+
+private:
+    struct chunk;
+
+    QUARISMA_API void* AllocateSlow(size_t alignment, size_t num_bytes);
+
+    void RecordAllocation(size_t num_bytes) noexcept
+    {
+        ++num_allocs_;
+        bytes_in_use_ += num_bytes;
+        largest_alloc_size_ = std::max(largest_alloc_size_, num_bytes);
+    }
+
+    const std::string                        name_;
+    const Options                            opts_;
+    std::unique_ptr<quarisma::sub_allocator> sub_allocator_;
+
+    chunk* head_    = nullptr;  // First chunk; chunks form a singly linked list
+    chunk* current_ = nullptr;  // Chunk the cursor is in
+    char*  cursor_  = nullptr;
+    char*  limit_   = nullptr;
+
+    size_t next_chunk_size_;
+    size_t bytes_in_use_       = 0;
+    size_t peak_bytes_in_use_  = 0;
+    size_t bytes_reserved_     = 0;
+    size_t largest_alloc_size_ = 0;
+    size_t num_allocs_         = 0;
+
+    arena(const arena&)            = delete;
+    arena& operator=(const arena&) = delete;
+};
+
+/**
+ * @brief Standard allocator drawing from an arena.
+ *
+ * Unlike std::pmr::polymorphic_allocator it needs no virtual call and works
+ * with containers typed on their allocator, such as flat_hash_map. The arena
+ * must outlive the container; deallocate() is a no-op.
+ */
+template <typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+
+    arena_allocator(arena& owner) noexcept : arena_(&owner) {}  // NOLINT
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept : arena_(other.owner())  // NOLINT
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        void* ptr = arena_->allocate_raw(alignof(T), std::max<size_t>(n * sizeof(T), 1));
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(QUARISMA_UNUSED T* ptr, QUARISMA_UNUSED size_t n) noexcept {}
+
+    arena* owner() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>& other) const noexcept
+    {
+        return arena_ == other.owner();
+    }
+
+    template <typename U>
+    bool operator!=(const arena_allocator<U>& other) const noexcept
+    {
+        return arena_ != other.owner();
+    }
+
+private:
+    arena* arena_;
+};
+
+}  // namespace quarisma
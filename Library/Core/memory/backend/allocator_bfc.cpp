@@ -31,19 +31,23 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <deque>
+#include <functional>
 #include <iomanip>
 #include <ios>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <numeric>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -55,6 +59,7 @@
 #include "profiler/native/tracing/traceme.h"
 #include "profiler/native/tracing/traceme_encode.h"
 #endif
+#include "util/cpu_topology.h"
 #include "util/exception.h"
 #include "util/flat_hash.h"
 #include "util/string_util.h"
@@ -95,164 +100,101 @@ static std::string format_human_readable_bytes(int64_t bytes)
     return std::to_string(bytes) + "B";
 }
 
-class MemAllocatorStats
-{
-public:
-    // Getters
-    QUARISMA_NODISCARD int64_t num_allocs() const { return num_allocs_; }
-    QUARISMA_NODISCARD int64_t bytes_in_use() const { return bytes_in_use_; }
-    QUARISMA_NODISCARD int64_t peak_bytes_in_use() const { return peak_bytes_in_use_; }
-    QUARISMA_NODISCARD int64_t largest_alloc_size() const { return largest_alloc_size_; }
-    QUARISMA_NODISCARD float   fragmentation_metric() const { return fragmentation_metric_; }
-
-    // Setters
-    void set_num_allocs(int64_t value) { num_allocs_ = value; }
-    void set_bytes_in_use(int64_t value) { bytes_in_use_ = value; }
-    void set_peak_bytes_in_use(int64_t value) { peak_bytes_in_use_ = value; }
-    void set_largest_alloc_size(int64_t value) { largest_alloc_size_ = value; }
-    void set_fragmentation_metric(float value) { fragmentation_metric_ = value; }
-
-private:
-    int64_t num_allocs_{0};
-    int64_t bytes_in_use_{0};
-    int64_t peak_bytes_in_use_{0};
-    int64_t largest_alloc_size_{0};
-    float   fragmentation_metric_{0.0F};
-};
-
-class MemChunk
-{
-public:
-    // Getters
-    QUARISMA_NODISCARD uint64_t address() const { return address_; }
-    QUARISMA_NODISCARD int64_t  size() const { return size_; }
-    QUARISMA_NODISCARD int64_t  requested_size() const { return requested_size_; }
-    QUARISMA_NODISCARD int32_t  bin() const { return bin_; }
-    QUARISMA_NODISCARD const std::string& op_name() const { return op_name_; }
-    QUARISMA_NODISCARD uint64_t           freed_at_count() const { return freed_at_count_; }
-    QUARISMA_NODISCARD uint64_t           action_count() const { return action_count_; }
-    QUARISMA_NODISCARD bool               in_use() const { return in_use_; }
-    QUARISMA_NODISCARD uint64_t           step_id() const { return step_id_; }
-
-    // Setters
-    void set_address(uint64_t value) { address_ = value; }
-    void set_size(int64_t value) { size_ = value; }
-    void set_requested_size(int64_t value) { requested_size_ = value; }
-    void set_bin(int32_t value) { bin_ = value; }
-    void set_op_name(const std::string& value) { op_name_ = value; }
-    void set_op_name(std::string&& value) { op_name_ = std::move(value); }
-    void set_freed_at_count(uint64_t value) { freed_at_count_ = value; }
-    void set_action_count(uint64_t value) { action_count_ = value; }
-    void set_in_use(bool value) { in_use_ = value; }
-    void set_step_id(uint64_t value) { step_id_ = value; }
-
-private:
-    uint64_t    address_{0};
-    int64_t     size_{0};
-    int64_t     requested_size_{0};
-    int32_t     bin_{0};
-    std::string op_name_;
-    uint64_t    freed_at_count_{0};
-    uint64_t    action_count_{0};
-    bool        in_use_{false};
-    uint64_t    step_id_{0};
-};
+//constexpr allocator_bfc::ChunkHandle allocator_bfc::kInvalidChunkHandle;
 
-class BinSummary
+// Per-thread cache of small chunks (Options::thread_cache).
+//
+// A cache owns the chunks it took from the bins, cached or handed out, until
+// it returns them; the allocator sees them as in use. Its lock is normally
+// only taken by its thread, so it is uncontended; other threads take it to
+// free a chunk handed out from this cache, and to flush or detach the cache.
+class allocator_bfc::ThreadCache
 {
 public:
-    // Getters
-    QUARISMA_NODISCARD int32_t bin() const { return bin_; }
-    QUARISMA_NODISCARD int64_t total_bytes_in_use() const { return total_bytes_in_use_; }
-    QUARISMA_NODISCARD int64_t total_bytes_in_bin() const { return total_bytes_in_bin_; }
-    QUARISMA_NODISCARD int64_t total_chunks_in_use() const { return total_chunks_in_use_; }
-    QUARISMA_NODISCARD int64_t total_chunks_in_bin() const { return total_chunks_in_bin_; }
-
-    // Setters
-    void set_bin(int32_t value) { bin_ = value; }
-    void set_total_bytes_in_use(int64_t value) { total_bytes_in_use_ = value; }
-    void set_total_bytes_in_bin(int64_t value) { total_bytes_in_bin_ = value; }
-    void set_total_chunks_in_use(int64_t value) { total_chunks_in_use_ = value; }
-    void set_total_chunks_in_bin(int64_t value) { total_chunks_in_bin_ = value; }
-
-private:
-    int32_t bin_{0};
-    int64_t total_bytes_in_use_{0};
-    int64_t total_bytes_in_bin_{0};
-    int64_t total_chunks_in_use_{0};
-    int64_t total_chunks_in_bin_{0};
-};
+    struct Entry
+    {
+        ChunkHandle handle;
+        Chunk*      chunk;
+    };
 
-class SnapShot
-{
-public:
-    // Getters
-    QUARISMA_NODISCARD uint64_t action_count() const { return action_count_; }
-    QUARISMA_NODISCARD int64_t  size() const { return size_; }
+    explicit ThreadCache(allocator_bfc* owner) : owner_(owner) {}
 
-    // Setters
-    void set_action_count(uint64_t value) { action_count_ = value; }
-    void set_size(int64_t value) { size_ = value; }
+    std::mutex mutex_;
 
-private:
-    uint64_t action_count_{0};
-    int64_t  size_{0};
-};
+    // Allocator of the cache, reset when the allocator is destroyed
+    allocator_bfc* owner_ QUARISMA_GUARDED_BY(mutex_);
 
-class memory_dump
-{
-public:
-    // Getters
-    QUARISMA_NODISCARD const std::string& allocator_name() const { return allocator_name_; }
-    QUARISMA_NODISCARD const std::vector<BinSummary>& bin_summary() const { return bin_summary_; }
-    QUARISMA_NODISCARD const std::vector<MemChunk>& chunk() const { return chunk_; }
-    QUARISMA_NODISCARD const std::vector<SnapShot>& snap_shot() const { return snap_shot_; }
-    QUARISMA_NODISCARD const MemAllocatorStats&     stats() const { return stats_; }
+    // Set when the thread of the cache has exited; a new thread may take it over
+    std::atomic<bool> retired_{false};
 
-    // Mutable accessors
-    MemAllocatorStats* stats() { return &stats_; }
+    // Free chunks by size class, most recently freed last
+    std::array<std::vector<Entry>, kThreadCacheMaxBytes / kMinAllocationSize> free_
+        QUARISMA_GUARDED_BY(mutex_);
 
-    // Setters
-    void set_allocator_name(const std::string& name) { allocator_name_ = name; }
-    void set_allocator_name(std::string&& name) { allocator_name_ = std::move(name); }
+    // Chunks handed out from this cache, by pointer
+    flat_hash_map<void*, Entry> in_use_ QUARISMA_GUARDED_BY(mutex_);
+};
 
-    // Add methods
-    BinSummary* add_bin_summary()
+// Caches of the calling thread, one per allocator it used. The slots share the
+// ownership of the caches with the allocators, so that a thread exiting after
+// an allocator was destroyed finds a detached cache.
+struct allocator_bfc::ThreadCacheSlots
+{
+    struct Slot
     {
-        bin_summary_.emplace_back();
-        return &bin_summary_.back();
-    }
+        uint64_t                     allocator_id;
+        std::shared_ptr<ThreadCache> cache;
+    };
 
-    MemChunk* add_chunk()
+    ~ThreadCacheSlots()
     {
-        chunk_.emplace_back();
-        return &chunk_.back();
+        for (auto& slot : slots_)
+        {
+            std::scoped_lock const lock(slot.cache->mutex_);
+            if (slot.cache->owner_ != nullptr)
+            {
+                slot.cache->owner_->ReleaseThreadCache(slot.cache.get(), /*retire=*/true);
+            }
+            slot.cache->retired_.store(true, std::memory_order_release);
+        }
     }
 
-    SnapShot* add_snap_shot()
+    static ThreadCacheSlots& local()
     {
-        snap_shot_.emplace_back();
-        return &snap_shot_.back();
+        static thread_local ThreadCacheSlots slots;
+        return slots;
     }
 
-    void Clear()
-    {
-        allocator_name_.clear();
-        bin_summary_.clear();
-        chunk_.clear();
-        snap_shot_.clear();
-        stats_ = MemAllocatorStats{};
-    }
+    std::vector<Slot> slots_;
+};
 
-private:
-    std::string             allocator_name_;
-    std::vector<BinSummary> bin_summary_;
-    std::vector<MemChunk>   chunk_;
-    std::vector<SnapShot>   snap_shot_;
-    MemAllocatorStats       stats_;
+// Progress of RecordMemoryMapIncremental(). Every chunk at or below the cursor
+// has been copied; the ones changed since are read again at the next batch.
+struct allocator_bfc::MapSnapshot
+{
+    std::uintptr_t             cursor{0};
+    flat_hash_set<const void*> changed;
 };
 
-//constexpr allocator_bfc::ChunkHandle allocator_bfc::kInvalidChunkHandle;
+inline void allocator_bfc::NoteChunkChange(const void* ptr)
+{
+    if QUARISMA_UNLIKELY (map_snapshot_ != nullptr)
+    {
+        if (reinterpret_cast<std::uintptr_t>(ptr) <= map_snapshot_->cursor)
+        {
+            map_snapshot_->changed.insert(ptr);
+        }
+    }
+}
+
+namespace
+{
+uint64_t next_allocator_instance_id()
+{
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+}  // namespace
 
 allocator_bfc::allocator_bfc(
     std::unique_ptr<quarisma::sub_allocator> sub_allocator,
@@ -262,8 +204,10 @@ allocator_bfc::allocator_bfc(
     : opts_(opts),
       coalesce_regions_(sub_allocator->SupportsCoalescing()),
       sub_allocator_(std::move(sub_allocator)),
-      name_(std::move(name))
-
+      name_(std::move(name)),
+      instance_id_(next_allocator_instance_id()),
+      thread_cache_batch_bytes_(
+          std::clamp<size_t>(cpu_topology::instance().l1d().size, 16 << 10, 128 << 10))
 {
     if (opts.allow_growth)
     {
@@ -305,10 +249,51 @@ allocator_bfc::allocator_bfc(
             QUARISMA_CHECK(BinForSize(bin_size * 2) != BinFromIndex(b));
         }
     }
+
+    pressure_id_ = memory_pressure::instance().register_cache(
+        name_,
+        memory_trim_cost::MEDIUM,
+        device_enum::CPU,
+        -1,
+        [this](size_t /*bytes_wanted*/) { return ReleaseFreeRegions(); });
+
+    if (opts_.compaction_interval.count() > 0)
+    {
+        compaction_thread_ = std::thread([this]() { CompactionLoop(); });
+    }
 }
 
 allocator_bfc::~allocator_bfc()
 {
+    if (compaction_thread_.joinable())
+    {
+        {
+            std::scoped_lock const lock(compaction_mutex_);
+            stop_compaction_ = true;
+        }
+        compaction_cv_.notify_all();
+        compaction_thread_.join();
+    }
+
+    memory_pressure::instance().unregister_cache(pressure_id_);
+
+    // Detach the thread caches: their threads may outlive the allocator. The
+    // chunks they hold are part of the regions released below.
+    {
+        std::scoped_lock const lock(thread_caches_mutex_);
+        for (const auto& cache : thread_caches_)
+        {
+            std::scoped_lock const cache_lock(cache->mutex_);
+            cache->owner_ = nullptr;
+            cache->in_use_.clear();
+            for (auto& entries : cache->free_)
+            {
+                entries.clear();
+            }
+        }
+        thread_caches_.clear();
+    }
+
     // Lock the mutex to make sure that all memory effects are safely published
     // and available to a thread running the destructor (i.e., deallocations
     // happened on a different thread right before the destructor).
@@ -472,7 +457,7 @@ allocator_bfc::ChunkHandle allocator_bfc::AllocateChunk()
     }
 
     ChunkHandle const h = chunks_.size();
-    chunks_.resize(h + 1);
+    chunks_.emplace_back();
     return h;
 }
 
@@ -496,6 +481,12 @@ void* allocator_bfc::AllocateRawInternalWithRetry(
     }
     void* r = AllocateRawInternal(unused_alignment, num_bytes, false, freed_by_count);  //NOLINT
 
+    // Memory held by the thread caches may be what is missing
+    if (r == nullptr && opts_.thread_cache && FlushThreadCaches())
+    {
+        r = AllocateRawInternal(unused_alignment, num_bytes, false, freed_by_count);  //NOLINT
+    }
+
     if (r != nullptr)
     {
         return r;
@@ -523,6 +514,16 @@ void* allocator_bfc::allocate_raw(
     size_t unused_alignment, size_t num_bytes, const allocation_attributes& allocation_attr)
 {
     //QUARISMA_LOG_INFO_DEBUG_BFC("allocate_raw {}  {}", Name(), num_bytes);
+    if (opts_.thread_cache && num_bytes > 0 && num_bytes <= kThreadCacheMaxBytes &&
+        timing_counter_ == nullptr && allocation_attr.freed_by_func == nullptr)
+    {
+        void* ptr = AllocateFromThreadCache(unused_alignment, num_bytes);
+        if (ptr != nullptr)
+        {
+            return ptr;
+        }
+    }
+
     void* result = [&]  //NOLINT
     {
         if (!opts_.allow_retry_on_failure || !allocation_attr.retry_on_failure)
@@ -553,6 +554,12 @@ void* allocator_bfc::allocate_raw(
                 num_bytes,
                 dump_log_on_failure,
                 freed_by_count);
+            if (res == nullptr && opts_.thread_cache && FlushThreadCaches())
+            {
+                // Memory held by the thread caches may be what is missing
+                res = AllocateRawInternal(
+                    unused_alignment, num_bytes, dump_log_on_failure, freed_by_count);
+            }
             if (res == nullptr)
             {
                 int32_t const counter_value = log_counter.load(std::memory_order_relaxed);
@@ -602,29 +609,7 @@ bool allocator_bfc::DeallocateFreeRegions(size_t rounded_bytes)
 
     // Searching for free regions.
     flat_hash_set<void*> free_region_ptrs;
-    size_t               total_free_bytes = 0;
-    for (const AllocationRegion& region : region_manager_.regions())
-    {
-        ChunkHandle h       = region_manager_.get_handle(region.ptr());
-        bool        any_use = false;
-        while (h != kInvalidChunkHandle)
-        {
-            const Chunk* c = ChunkFromHandle(h);
-            if (c->in_use())
-            {
-                any_use = true;
-                break;
-            }
-            h = c->next;
-        }
-
-        if (!any_use)
-        {
-            QUARISMA_LOG_INFO("Found free region with ptr = {}", region.ptr());
-            free_region_ptrs.insert(region.ptr());
-            total_free_bytes += region.memory_size();
-        }
-    }
+    size_t const         total_free_bytes = FindFreeRegions(&free_region_ptrs);
 
     if (total_free_bytes == 0)
     {
@@ -656,6 +641,52 @@ bool allocator_bfc::DeallocateFreeRegions(size_t rounded_bytes)
     return true;
 }
 
+size_t allocator_bfc::FindFreeRegions(flat_hash_set<void*>* region_ptrs)
+    QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_)
+{
+    size_t total_free_bytes = 0;
+    for (const AllocationRegion& region : region_manager_.regions())
+    {
+        ChunkHandle h       = region_manager_.get_handle(region.ptr());
+        bool        any_use = false;
+        while (h != kInvalidChunkHandle)
+        {
+            const Chunk* c = ChunkFromHandle(h);
+            if (c->in_use())
+            {
+                any_use = true;
+                break;
+            }
+            h = c->next;
+        }
+
+        if (!any_use)
+        {
+            QUARISMA_LOG_INFO("Found free region with ptr = {}", region.ptr());
+            region_ptrs->insert(region.ptr());
+            total_free_bytes += region.memory_size();
+        }
+    }
+    return total_free_bytes;
+}
+
+size_t allocator_bfc::ReleaseFreeRegions()
+{
+    if (opts_.thread_cache)
+    {
+        FlushThreadCaches();
+    }
+
+    std::scoped_lock const lock(mutex_);
+    flat_hash_set<void*>   free_region_ptrs;
+    size_t const           total_free_bytes = FindFreeRegions(&free_region_ptrs);
+    if (total_free_bytes > 0)
+    {
+        DeallocateRegions(free_region_ptrs);
+    }
+    return total_free_bytes;
+}
+
 void allocator_bfc::DeallocateRegions(const flat_hash_set<void*>& region_ptrs)
     QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_)
 {
@@ -688,12 +719,274 @@ void allocator_bfc::DeallocateRegions(const flat_hash_set<void*>& region_ptrs)
         }
 
         // Deallocate the memory.
+        region_free_since_.erase(it->ptr());
         sub_allocator_->Free(it->ptr(), it->memory_size());
         stats_.pool_bytes.fetch_sub(it->memory_size(), std::memory_order_relaxed);
         it = region_manager_.RemoveAllocationRegion(it);
     }
 }
 
+allocator_bfc::movable_handle allocator_bfc::AllocateMovable(size_t alignment, size_t num_bytes)
+{
+    if (num_bytes == 0)
+    {
+        return kInvalidMovableHandle;
+    }
+
+    // Not through the thread caches: their chunks stay with their cache
+    void* ptr = AllocateRawInternalWithRetry(alignment, num_bytes, allocation_attributes{});
+    if (ptr == nullptr)
+    {
+        return kInvalidMovableHandle;
+    }
+
+    std::scoped_lock const lock(mutex_);
+    movable_handle const   handle = next_movable_handle_++;
+    movable_[handle].ptr          = ptr;
+    return handle;
+}
+
+void* allocator_bfc::PinMovable(movable_handle handle)
+{
+    std::scoped_lock const lock(mutex_);
+    auto                   it = movable_.find(handle);
+    QUARISMA_CHECK(it != movable_.end(), "Unknown movable allocation {}", handle);
+    ++it->second.pins;
+    return it->second.ptr;
+}
+
+void allocator_bfc::UnpinMovable(movable_handle handle)
+{
+    std::scoped_lock const lock(mutex_);
+    auto                   it = movable_.find(handle);
+    QUARISMA_CHECK(it != movable_.end(), "Unknown movable allocation {}", handle);
+    QUARISMA_CHECK(it->second.pins > 0, "Movable allocation {} is not pinned", handle);
+    --it->second.pins;
+}
+
+void allocator_bfc::DeallocateMovable(movable_handle handle)
+{
+    void* ptr = nullptr;
+    {
+        std::scoped_lock const lock(mutex_);
+        auto                   it = movable_.find(handle);
+        QUARISMA_CHECK(it != movable_.end(), "Unknown movable allocation {}", handle);
+        QUARISMA_CHECK(
+            it->second.pins == 0, "Movable allocation {} freed while pinned", handle);
+        ptr = it->second.ptr;
+        movable_.erase(it);
+    }
+    deallocate_raw(ptr);
+}
+
+size_t allocator_bfc::Compact()
+{
+    if (opts_.thread_cache)
+    {
+        FlushThreadCaches();
+    }
+    return CompactInternal(std::chrono::steady_clock::duration::zero());
+}
+
+size_t allocator_bfc::CompactInternal(std::chrono::steady_clock::duration idle_timeout)
+{
+    auto const             now = std::chrono::steady_clock::now();
+    std::scoped_lock const lock(mutex_);
+
+    // Copies need host access to both sides
+    allocator_memory_enum const memory_type = GetMemoryType();
+    bool const                  relocate    = !movable_.empty() &&
+                          (memory_type == allocator_memory_enum::HOST_PAGEABLE ||
+                           memory_type == allocator_memory_enum::HOST_PINNED ||
+                           memory_type == allocator_memory_enum::UNIFIED);
+
+    flat_hash_map<void*, movable_handle> movable_by_ptr;
+    if (relocate)
+    {
+        for (const auto& [handle, allocation] : movable_)
+        {
+            if (allocation.pins == 0)
+            {
+                movable_by_ptr[allocation.ptr] = handle;
+            }
+        }
+    }
+
+    // Free regions and emptied ones are parked: their free chunks stay out of
+    // the bins until the end of the pass, so that nothing moves into them
+    std::vector<ChunkHandle> parked;
+    auto                     park = [this, &parked](const AllocationRegion& region)
+    {
+        for (ChunkHandle h = region_manager_.get_handle(region.ptr()); h != kInvalidChunkHandle;
+             h             = ChunkFromHandle(h)->next)
+        {
+            if (ChunkFromHandle(h)->bin_num != kInvalidBinNum)
+            {
+                RemoveFreeChunkFromBin(h);
+                parked.push_back(h);
+            }
+        }
+    };
+
+    // Regions whose allocations are all unpinned movable ones
+    std::vector<std::pair<size_t, const AllocationRegion*>> candidates;
+    for (const AllocationRegion& region : region_manager_.regions())
+    {
+        size_t bytes_in_use = 0;
+        bool   movable      = true;
+        for (ChunkHandle h = region_manager_.get_handle(region.ptr()); h != kInvalidChunkHandle;
+             h             = ChunkFromHandle(h)->next)
+        {
+            const Chunk* c = ChunkFromHandle(h);
+            if (c->in_use())
+            {
+                bytes_in_use += c->size;
+                movable = movable && c->cache_owner == nullptr &&
+                          movable_by_ptr.find(c->ptr) != movable_by_ptr.end();
+            }
+        }
+
+        if (bytes_in_use == 0)
+        {
+            park(region);
+        }
+        else if (movable)
+        {
+            candidates.emplace_back(bytes_in_use, &region);
+        }
+    }
+
+    // Sparsest first: the fewest bytes to copy per region emptied
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [bytes_in_use, region] : candidates)
+    {
+        if (EvacuateRegion(*region, movable_by_ptr))
+        {
+            park(*region);
+        }
+    }
+
+    for (ChunkHandle const h : parked)
+    {
+        InsertFreeChunkIntoBin(h);
+    }
+
+    // Release the regions that have been free long enough
+    flat_hash_set<void*> free_region_ptrs;
+    FindFreeRegions(&free_region_ptrs);
+    for (auto it = region_free_since_.begin(); it != region_free_since_.end();)
+    {
+        it = free_region_ptrs.find(it->first) == free_region_ptrs.end()
+                 ? region_free_since_.erase(it)
+                 : std::next(it);
+    }
+
+    flat_hash_set<void*> expired;
+    size_t               released_bytes = 0;
+    for (const AllocationRegion& region : region_manager_.regions())
+    {
+        if (free_region_ptrs.find(region.ptr()) == free_region_ptrs.end())
+        {
+            continue;
+        }
+        auto const since = region_free_since_.emplace(region.ptr(), now).first->second;
+        if (now - since >= idle_timeout)
+        {
+            expired.insert(region.ptr());
+            released_bytes += region.memory_size();
+        }
+    }
+    if (!expired.empty())
+    {
+        DeallocateRegions(expired);
+    }
+    return released_bytes;
+}
+
+bool allocator_bfc::EvacuateRegion(
+    const AllocationRegion& region, flat_hash_map<void*, movable_handle>& movable_by_ptr)
+{
+    std::vector<ChunkHandle> free_chunks;
+    std::vector<ChunkHandle> moving;
+    for (ChunkHandle h = region_manager_.get_handle(region.ptr()); h != kInvalidChunkHandle;
+         h             = ChunkFromHandle(h)->next)
+    {
+        if (ChunkFromHandle(h)->in_use())
+        {
+            moving.push_back(h);
+        }
+        else if (ChunkFromHandle(h)->bin_num != kInvalidBinNum)
+        {
+            RemoveFreeChunkFromBin(h);
+            free_chunks.push_back(h);
+        }
+    }
+
+    // Chunk metadata lives in a deque, so c stays valid while FindChunkPtr
+    // splits other chunks
+    std::vector<ChunkHandle> moved;
+    for (ChunkHandle const h : moving)
+    {
+        Chunk* const c         = ChunkFromHandle(h);
+        size_t const requested = c->requested_size.load(std::memory_order_relaxed);
+        size_t const rounded   = RoundedBytes(requested);
+        void* const  target    = FindChunkPtr(BinNumForSize(rounded), rounded, requested, 0);
+        if (target == nullptr)
+        {
+            break;
+        }
+        std::memcpy(target, c->ptr, requested);
+
+        // The copy can land in a region evacuated later in the same pass, so
+        // the map follows it to its new address
+        auto const           it     = movable_by_ptr.find(c->ptr);
+        movable_handle const handle = it->second;
+        movable_by_ptr.erase(it);
+        movable_by_ptr[target] = handle;
+        movable_[handle].ptr   = target;
+        moved.push_back(h);
+    }
+
+    for (ChunkHandle const h : free_chunks)
+    {
+        InsertFreeChunkIntoBin(h);
+    }
+    for (ChunkHandle const h : moved)
+    {
+        MarkFree(h);
+        if (timing_counter_ != nullptr)
+        {
+            InsertFreeChunkIntoBin(h);
+            timestamped_chunks_.push_back(h);
+        }
+        else
+        {
+            InsertFreeChunkIntoBin(TryToCoalesce(h, false));
+        }
+    }
+    return moved.size() == moving.size();
+}
+
+void allocator_bfc::CompactionLoop()
+{
+    std::unique_lock<std::mutex> lock(compaction_mutex_);
+    while (!compaction_cv_.wait_for(
+        lock, opts_.compaction_interval, [this]() { return stop_compaction_; }))
+    {
+        lock.unlock();
+        size_t const released = CompactInternal(opts_.region_idle_timeout);
+        if (released > 0)
+        {
+            QUARISMA_LOG_INFO_DEBUG_BFC(
+                "Compaction of {} released {}", Name(), format_human_readable_bytes(released));
+        }
+        lock.lock();
+    }
+}
+
 void* allocator_bfc::AllocateRawInternal(
     size_t unused_alignment, size_t num_bytes, bool dump_log_on_failure, uint64_t freed_before)
 {
@@ -795,7 +1088,7 @@ void* allocator_bfc::AllocateRawInternal(
     return nullptr;
 }
 
-int64_t allocator_bfc::LargestFreeChunk()
+int64_t allocator_bfc::LargestFreeChunk() const
 {
     for (int i = kNumBins - 1; i >= 0; i--)
     {
@@ -863,6 +1156,46 @@ void allocator_bfc::AddTraceMe(
 
 void* allocator_bfc::FindChunkPtr(
     BinNum bin_num, size_t rounded_bytes, size_t num_bytes, uint64_t freed_before)
+{
+    ChunkHandle const h = FindChunk(bin_num, rounded_bytes, freed_before);
+    if (h == kInvalidChunkHandle)
+    {
+        return nullptr;
+    }
+
+    allocator_bfc::Chunk* chunk = ChunkFromHandle(h);
+    RecordAllocation(chunk, num_bytes);
+
+#ifdef QUARISMA_MEM_DEBUG
+    if (ShouldRecordOpName())
+    {
+        const auto& annotation = ScopedMemoryDebugAnnotation::CurrentAnnotation();
+        if (annotation.pending_op_name != nullptr)
+        {
+            chunk->op_name = annotation.pending_op_name;
+        }
+        else
+        {
+            QUARISMA_LOG_INFO(
+                "missing pending_op_name for {} reading addr {}\n{}",
+                Name(),
+                static_cast<const void*>(&annotation.pending_op_name),
+                CurrentStackTrace());
+            chunk->op_name = nullptr;
+        }
+        chunk->action_count = ++action_counter_;
+        chunk->step_id      = annotation.pending_step_id;
+        int slot            = chunk->action_count % MEM_DEBUG_SIZE_HISTORY_SIZE;
+        size_history_[slot] = stats_.bytes_in_use;
+    }
+#endif
+
+    //QUARISMA_LOG_INFO_DEBUG_BFC("Returning: {}\nA: {}", chunk->ptr, RenderOccupancy());
+    return chunk->ptr;
+}
+
+allocator_bfc::ChunkHandle allocator_bfc::FindChunk(
+    BinNum bin_num, size_t rounded_bytes, uint64_t freed_before)
 {
     // First identify the first bin that could satisfy rounded_bytes.
     for (; bin_num < kNumBins; bin_num++)
@@ -899,77 +1232,55 @@ void* allocator_bfc::FindChunkPtr(
                         max_internal_fragmentation_bytes + static_cast<int64_t>(rounded_bytes))
                 {
                     SplitChunk(h, rounded_bytes);
-                    chunk = ChunkFromHandle(h);  // Update chunk pointer in case it moved
                 }
-
-                // The requested size of the returned chunk is what the user
-                // has allocated.
-                chunk->requested_size = num_bytes;
-                // Assign a unique id and increment the id counter, marking the
-                // chunk as being in use.
-                chunk->allocation_id = next_allocation_id_++;
-
-                // Update stats.
-                stats_.num_allocs.fetch_add(1, std::memory_order_relaxed);
-                stats_.bytes_in_use.fetch_add(chunk->size, std::memory_order_relaxed);
-
-                int64_t const current_bytes = stats_.bytes_in_use.load(std::memory_order_relaxed);
-                int64_t       peak_bytes = stats_.peak_bytes_in_use.load(std::memory_order_relaxed);
-                // if (current_bytes > peak_bytes)
-                // {
-                //     QUARISMA_LOG_INFO_DEBUG_BFC(
-                //         "New Peak memory usage of {} bytes for {}", current_bytes, Name());
-                // }
-
-                // Update peak bytes atomically
-                while (current_bytes > peak_bytes &&
-                       !stats_.peak_bytes_in_use.compare_exchange_weak(
-                           peak_bytes, current_bytes, std::memory_order_relaxed))
-                {
-                    // Retry if another thread updated peak_bytes
-                }
-
-                // Update largest allocation size atomically
-                auto const chunk_size_int64 = static_cast<int64_t>(chunk->size);
-                int64_t    largest_size = stats_.largest_alloc_size.load(std::memory_order_relaxed);
-                while (chunk_size_int64 > largest_size &&
-                       !stats_.largest_alloc_size.compare_exchange_weak(
-                           largest_size, chunk_size_int64, std::memory_order_relaxed))
-                {
-                    // Retry if another thread updated largest_size
-                }
-
-#ifdef QUARISMA_MEM_DEBUG
-                if (ShouldRecordOpName())
-                {
-                    const auto& annotation = ScopedMemoryDebugAnnotation::CurrentAnnotation();
-                    if (annotation.pending_op_name != nullptr)
-                    {
-                        chunk->op_name = annotation.pending_op_name;
-                    }
-                    else
-                    {
-                        QUARISMA_LOG_INFO(
-                            "missing pending_op_name for {} reading addr {}\n{}",
-                            Name(),
-                            static_cast<const void*>(&annotation.pending_op_name),
-                            CurrentStackTrace());
-                        chunk->op_name = nullptr;
-                    }
-                    chunk->action_count = ++action_counter_;
-                    chunk->step_id      = annotation.pending_step_id;
-                    int slot            = chunk->action_count % MEM_DEBUG_SIZE_HISTORY_SIZE;
-                    size_history_[slot] = stats_.bytes_in_use;
-                }
-#endif
-
-                //QUARISMA_LOG_INFO_DEBUG_BFC("Returning: {}\nA: {}", chunk->ptr, RenderOccupancy());
-                return chunk->ptr;
+                return h;
             }
         }
     }
 
-    return nullptr;
+    return kInvalidChunkHandle;
+}
+
+void allocator_bfc::RecordAllocation(Chunk* chunk, size_t num_bytes)
+    QUARISMA_NO_THREAD_SAFETY_ANALYSIS
+{
+    // The requested size of the returned chunk is what the user
+    // has allocated.
+    chunk->requested_size.store(num_bytes, std::memory_order_relaxed);
+    // Assign a unique id and increment the id counter, marking the
+    // chunk as being in use.
+    chunk->allocation_id.store(
+        next_allocation_id_.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+
+    // Update stats.
+    stats_.num_allocs.fetch_add(1, std::memory_order_relaxed);
+    stats_.bytes_in_use.fetch_add(chunk->size, std::memory_order_relaxed);
+
+    int64_t const current_bytes = stats_.bytes_in_use.load(std::memory_order_relaxed);
+    int64_t       peak_bytes    = stats_.peak_bytes_in_use.load(std::memory_order_relaxed);
+    // if (current_bytes > peak_bytes)
+    // {
+    //     QUARISMA_LOG_INFO_DEBUG_BFC(
+    //         "New Peak memory usage of {} bytes for {}", current_bytes, Name());
+    // }
+
+    // Update peak bytes atomically
+    while (current_bytes > peak_bytes &&
+           !stats_.peak_bytes_in_use.compare_exchange_weak(
+               peak_bytes, current_bytes, std::memory_order_relaxed))
+    {
+        // Retry if another thread updated peak_bytes
+    }
+
+    // Update largest allocation size atomically
+    auto const chunk_size_int64 = static_cast<int64_t>(chunk->size);
+    int64_t    largest_size     = stats_.largest_alloc_size.load(std::memory_order_relaxed);
+    while (chunk_size_int64 > largest_size &&
+           !stats_.largest_alloc_size.compare_exchange_weak(
+               largest_size, chunk_size_int64, std::memory_order_relaxed))
+    {
+        // Retry if another thread updated largest_size
+    }
 }
 
 void allocator_bfc::SplitChunk(allocator_bfc::ChunkHandle h, size_t num_bytes)
@@ -988,6 +1299,7 @@ void allocator_bfc::SplitChunk(allocator_bfc::ChunkHandle h, size_t num_bytes)
     // Set the new sizes of the chunks.
     new_chunk->size = c->size - num_bytes;
     c->size         = num_bytes;
+    NoteChunkChange(c->ptr);
 
     // The new chunk is not in use.
     new_chunk->allocation_id = -1;
@@ -1022,51 +1334,96 @@ void allocator_bfc::deallocate_raw(void* ptr)
         (ptr ? RequestedSize(ptr) : 0),
         ptr);
 
-    DeallocateRawInternal(ptr);
-    retry_helper_.NotifyDealloc();
+    if (opts_.thread_cache && ptr != nullptr)
+    {
+        // Fast path: the chunk was handed out from this thread's cache
+        for (const auto& slot : ThreadCacheSlots::local().slots_)
+        {
+            if (slot.allocator_id == instance_id_)
+            {
+                std::scoped_lock const lock(slot.cache->mutex_);
+                if (ReleaseToThreadCache(slot.cache.get(), ptr))
+                {
+                    return;
+                }
+                break;
+            }
+        }
+    }
+
+    size_t const freed = DeallocateRawInternal(ptr);
+    if (freed > 0)
+    {
+        retry_helper_.NotifyDealloc(freed);
+    }
 }
 
-void allocator_bfc::DeallocateRawInternal(void* ptr)
+size_t allocator_bfc::DeallocateRawInternal(void* ptr)
 {
     if (ptr == nullptr)
     {
         QUARISMA_LOG(INFO, "tried to deallocate nullptr");
-        return;
+        return 0;
     }
-    std::scoped_lock const lock(mutex_);
 
-    // Find the chunk from the ptr.
-    allocator_bfc::ChunkHandle const h = region_manager_.get_handle(ptr);
-    QUARISMA_CHECK(h != kInvalidChunkHandle);
+    while (true)
+    {
+        ThreadCache* owner = nullptr;
+        {
+            std::scoped_lock const lock(mutex_);
 
+            // Find the chunk from the ptr.
+            allocator_bfc::ChunkHandle const h = region_manager_.get_handle(ptr);
+            QUARISMA_CHECK(h != kInvalidChunkHandle);
+
+            owner = ChunkFromHandle(h)->cache_owner;
+            if (owner == nullptr)
+            {
 #if QUARISMA_HAS_NATIVE_PROFILER
-    // Record chunk information before it's freed (only needed for profiling).
-    const Chunk* const chunk       = ChunkFromHandle(h);
-    void const* const  chunk_ptr   = chunk->ptr;
-    int64_t const      req_bytes   = chunk->requested_size;
-    int64_t const      alloc_bytes = chunk->size;
+                // Record chunk information before it's freed (only needed for profiling).
+                const Chunk* const chunk       = ChunkFromHandle(h);
+                void const* const  chunk_ptr   = chunk->ptr;
+                int64_t const      req_bytes   = chunk->requested_size;
+                int64_t const      alloc_bytes = chunk->size;
 #endif
 
-    MarkFree(h);
+                MarkFree(h);
 
-    // Consider coalescing it.
-    if (timing_counter_ != nullptr)
-    {
-        InsertFreeChunkIntoBin(h);
-        timestamped_chunks_.push_back(h);
-    }
-    else
-    {
-        InsertFreeChunkIntoBin(TryToCoalesce(h, false));
-    }
+                // Consider coalescing it. A timestamped chunk only becomes
+                // usable once SetSafeFrontier() passes it, which notifies then.
+                size_t freed = 0;
+                if (timing_counter_ != nullptr)
+                {
+                    InsertFreeChunkIntoBin(h);
+                    timestamped_chunks_.push_back(h);
+                }
+                else
+                {
+                    ChunkHandle const coalesced = TryToCoalesce(h, false);
+                    freed                       = ChunkFromHandle(coalesced)->size;
+                    InsertFreeChunkIntoBin(coalesced);
+                }
 
 #if QUARISMA_HAS_NATIVE_PROFILER
-    // TraceMe needs to be added after MarkFree and InsertFreeChunkIntoBin for
-    // correct aggregation stats (bytes_in_use, fragmentation).
-    AddTraceMe("MemoryDeallocation", chunk_ptr, req_bytes, alloc_bytes);
+                // TraceMe needs to be added after MarkFree and InsertFreeChunkIntoBin for
+                // correct aggregation stats (bytes_in_use, fragmentation).
+                AddTraceMe("MemoryDeallocation", chunk_ptr, req_bytes, alloc_bytes);
 #endif
 
-    QUARISMA_LOG_INFO_DEBUG_BFC("F: {}", RenderOccupancy());
+                QUARISMA_LOG_INFO_DEBUG_BFC("F: {}", RenderOccupancy());
+                return freed;
+            }
+        }
+
+        // Handed out from another thread's cache: give it back to that cache.
+        // If the cache gave the chunk up in the meantime (its thread exited),
+        // the chunk is now an ordinary one and the next round frees it.
+        std::scoped_lock const lock(owner->mutex_);
+        if (ReleaseToThreadCache(owner, ptr))
+        {
+            return 0;
+        }
+    }
 }
 
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
@@ -1097,6 +1454,7 @@ void allocator_bfc::Merge(allocator_bfc::ChunkHandle h1, allocator_bfc::ChunkHan
 
     // Set the new size
     c1->size += c2->size;
+    NoteChunkChange(c1->ptr);
 
     // Pick latest free time.
     c1->freed_at_count = std::max(c1->freed_at_count, c2->freed_at_count);
@@ -1109,6 +1467,7 @@ void allocator_bfc::DeleteChunk(ChunkHandle h)
     // Delete h and cleanup all state
     Chunk const* c = ChunkFromHandle(h);
     //  VLOG(4) << "Removing: " << c->ptr;
+    NoteChunkChange(c->ptr);
     region_manager_.erase(c->ptr);
     DeallocateChunk(h);
 }
@@ -1121,6 +1480,7 @@ void allocator_bfc::InsertFreeChunkIntoBin(allocator_bfc::ChunkHandle h)
     Bin*         new_bin = BinFromIndex(bin_num);
     c->bin_num           = bin_num;
     new_bin->free_chunks.insert(h);
+    NoteChunkChange(c->ptr);
 }
 
 void allocator_bfc::RemoveFreeChunkIterFromBin(
@@ -1132,6 +1492,7 @@ void allocator_bfc::RemoveFreeChunkIterFromBin(
     QUARISMA_CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));  //NOLINT
     free_chunks->erase(citer);
     c->bin_num = kInvalidBinNum;
+    NoteChunkChange(c->ptr);
 }
 
 void allocator_bfc::RemoveFreeChunkFromBin(allocator_bfc::ChunkHandle h)
@@ -1140,6 +1501,7 @@ void allocator_bfc::RemoveFreeChunkFromBin(allocator_bfc::ChunkHandle h)
     QUARISMA_CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));  //NOLINT
     QUARISMA_CHECK(BinFromIndex(c->bin_num)->free_chunks.erase(h) > 0, "Could not find chunk in bin");
     c->bin_num = kInvalidBinNum;
+    NoteChunkChange(c->ptr);
 }
 
 void allocator_bfc::MarkFree(allocator_bfc::ChunkHandle h)
@@ -1149,6 +1511,7 @@ void allocator_bfc::MarkFree(allocator_bfc::ChunkHandle h)
 
     // Mark the chunk as no longer in use.
     c->allocation_id = -1;
+    NoteChunkChange(c->ptr);
 
     // Optionally record the free time.
     if (timing_counter_ != nullptr)
@@ -1356,8 +1719,10 @@ int64_t allocator_bfc::AllocationId(const void* ptr) const
     QUARISMA_CHECK(
         h != kInvalidChunkHandle, "Asked for allocation id of pointer we never allocated: ", ptr);
 
-    const allocator_bfc::Chunk* c = ChunkFromHandle(h);
-    return c->allocation_id;
+    const allocator_bfc::Chunk* c  = ChunkFromHandle(h);
+    int64_t const               id = c->allocation_id;
+    // Chunks held by a thread cache are free for the user
+    return id == kThreadCacheAllocationId ? -1 : id;
 }
 
 namespace
@@ -1599,13 +1964,6 @@ memory_dump allocator_bfc::RecordMemoryMapInternal()
 
     md.set_allocator_name(Name());
 
-    // Record the general stats
-    MemAllocatorStats* mas = md.stats();
-    mas->set_num_allocs(stats_.num_allocs);
-    mas->set_bytes_in_use(stats_.bytes_in_use);
-    mas->set_peak_bytes_in_use(stats_.peak_bytes_in_use);
-    mas->set_largest_alloc_size(stats_.largest_alloc_size);
-
     // Record summary data for every bin.
     const std::array<BinDebugInfo, kNumBins> bin_infos = get_bin_debug_info();
     for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++)
@@ -1630,26 +1988,122 @@ memory_dump allocator_bfc::RecordMemoryMapInternal()
         ChunkHandle h = region_manager_.get_handle(region.ptr());
         while (h != kInvalidChunkHandle)
         {
-            const Chunk* c  = ChunkFromHandle(h);
-            MemChunk*    mc = md.add_chunk();
-            mc->set_in_use(c->in_use());
-            mc->set_address(reinterpret_cast<uint64_t>(c->ptr));
-            mc->set_size(c->size);
-            mc->set_requested_size(c->requested_size);
-            mc->set_bin(c->bin_num);
-#ifdef QUARISMA_MEM_DEBUG
-            mc->set_op_name(c->op_name ? std::string(c->op_name) : "UNKNOWN");
-            mc->set_step_id(c->step_id);
-            mc->set_action_count(c->action_count);
-#endif
-            if (timing_counter_ != nullptr)
+            const Chunk* c = ChunkFromHandle(h);
+            RecordChunk(*c, md.add_chunk());
+            h = c->next;
+        }
+    }
+
+    RecordMemoryMapStats(&md);
+    return md;
+}
+
+memory_dump allocator_bfc::RecordMemoryMapIncremental(size_t chunks_per_batch)
+{
+    chunks_per_batch = std::max<size_t>(chunks_per_batch, 1);
+    std::scoped_lock const snapshot_lock(map_snapshot_mutex_);
+
+    memory_dump                        md;
+    std::map<std::uintptr_t, MemChunk> chunks;
+    MapSnapshot                        snapshot;
+
+    std::unique_lock<profiled_mutex> lock(mutex_);
+    map_snapshot_ = &snapshot;
+    try
+    {
+        for (;;)
+        {
+            // Read the chunks changed behind the cursor since the last batch again
+            for (const void* ptr : snapshot.changed)
             {
-                mc->set_freed_at_count(c->in_use() ? 0 : c->freed_at_count);
+                auto const        address = reinterpret_cast<std::uintptr_t>(ptr);
+                ChunkHandle const h       = MapChunkAt(ptr);
+                if (h == kInvalidChunkHandle)
+                {
+                    chunks.erase(address);
+                }
+                else
+                {
+                    RecordChunk(*ChunkFromHandle(h), &chunks[address]);
+                }
             }
-            h = c->next;
+            snapshot.changed.clear();
+
+            ChunkHandle h = NextMapChunk(snapshot.cursor);
+            if (h == kInvalidChunkHandle)
+            {
+                break;
+            }
+            for (size_t n = 0; n < chunks_per_batch && h != kInvalidChunkHandle; ++n)
+            {
+                const Chunk* c  = ChunkFromHandle(h);
+                snapshot.cursor = reinterpret_cast<std::uintptr_t>(c->ptr);
+                RecordChunk(*c, &chunks[snapshot.cursor]);
+                h = c->next != kInvalidChunkHandle ? c->next : NextMapChunk(snapshot.cursor);
+            }
+
+            lock.unlock();
+            if (map_batch_hook_)
+            {
+                map_batch_hook_();
+            }
+            lock.lock();
         }
+
+        // The copy now matches the allocator: the last batch ends here
+        md.set_allocator_name(Name());
+        RecordMemoryMapStats(&md);
+    }
+    catch (...)
+    {
+        map_snapshot_ = nullptr;
+        throw;
+    }
+    map_snapshot_ = nullptr;
+    lock.unlock();
+
+    // Bin summaries follow from the chunks, as in get_bin_debug_info()
+    std::array<BinDebugInfo, kNumBins> bin_infos;
+    for (auto& [address, mc] : chunks)
+    {
+        BinDebugInfo& bin_info = bin_infos[BinNumForSize(mc.size())];
+        bin_info.total_bytes_in_bin += mc.size();
+        bin_info.total_chunks_in_bin++;
+        if (mc.in_use())
+        {
+            bin_info.total_bytes_in_use += mc.size();
+            bin_info.total_requested_bytes_in_use += mc.requested_size();
+            bin_info.total_chunks_in_use++;
+        }
+        *md.add_chunk() = std::move(mc);
+    }
+    for (BinNum bin_num = 0; bin_num < kNumBins; bin_num++)
+    {
+        const BinDebugInfo& bin_info = bin_infos[bin_num];
+        BinSummary*         bs       = md.add_bin_summary();
+        bs->set_bin(bin_num);
+        bs->set_total_bytes_in_use(bin_info.total_bytes_in_use);
+        bs->set_total_bytes_in_bin(bin_info.total_bytes_in_bin);
+        bs->set_total_chunks_in_use(bin_info.total_chunks_in_use);
+        bs->set_total_chunks_in_bin(bin_info.total_chunks_in_bin);
     }
+    return md;
+}
+
+void allocator_bfc::SetMapBatchHookForTesting(std::function<void()> hook)
+{
+    std::scoped_lock const lock(map_snapshot_mutex_);
+    map_batch_hook_ = std::move(hook);
+}
 
+void allocator_bfc::RecordMemoryMapStats(memory_dump* md)
+{
+    // Record the general stats
+    MemAllocatorStats* mas = md->stats();
+    mas->set_num_allocs(stats_.num_allocs);
+    mas->set_bytes_in_use(stats_.bytes_in_use);
+    mas->set_peak_bytes_in_use(stats_.peak_bytes_in_use);
+    mas->set_largest_alloc_size(stats_.largest_alloc_size);
     mas->set_fragmentation_metric(GetFragmentation());
 
 #ifdef QUARISMA_MEM_DEBUG
@@ -1658,14 +2112,84 @@ memory_dump allocator_bfc::RecordMemoryMapInternal()
         std::min(action_counter_, static_cast<int64>(MEM_DEBUG_SIZE_HISTORY_SIZE)));
     for (int i = action_counter_ - history_len; i < action_counter_; ++i)
     {
-        SnapShot* ss = md.add_snap_shot();
+        SnapShot* ss = md->add_snap_shot();
         ss->set_action_count(i);
         int slot = i % MEM_DEBUG_SIZE_HISTORY_SIZE;
         ss->set_size(size_history_[slot]);
     }
 #endif
+}
 
-    return md;
+void allocator_bfc::RecordChunk(const Chunk& c, MemChunk* mc) const
+{
+    mc->set_in_use(c.in_use());
+    mc->set_address(reinterpret_cast<uint64_t>(c.ptr));
+    mc->set_size(c.size);
+    mc->set_requested_size(c.requested_size);
+    mc->set_bin(c.bin_num);
+#ifdef QUARISMA_MEM_DEBUG
+    mc->set_op_name(c.op_name ? std::string(c.op_name) : "UNKNOWN");
+    mc->set_step_id(c.step_id);
+    mc->set_action_count(c.action_count);
+#endif
+    if (timing_counter_ != nullptr)
+    {
+        mc->set_freed_at_count(c.in_use() ? 0 : c.freed_at_count);
+    }
+}
+
+allocator_bfc::ChunkHandle allocator_bfc::MapChunkAt(const void* ptr) const
+{
+    // Unlike RegionManager::get_handle(), ptr may lie outside every region
+    const auto& regions = region_manager_.regions();
+    auto const  it      = std::upper_bound(
+        regions.begin(),
+        regions.end(),
+        ptr,
+        [](const void* p, const AllocationRegion& region) { return p < region.end_ptr(); });
+    if (it == regions.end() || ptr < it->ptr())
+    {
+        return kInvalidChunkHandle;
+    }
+    ChunkHandle const h = it->get_handle(ptr);
+    return h != kInvalidChunkHandle && ChunkFromHandle(h)->ptr == ptr ? h : kInvalidChunkHandle;
+}
+
+allocator_bfc::ChunkHandle allocator_bfc::NextMapChunk(std::uintptr_t cursor) const
+{
+    const auto& regions = region_manager_.regions();
+    auto        it      = std::upper_bound(
+        regions.begin(),
+        regions.end(),
+        cursor,
+        [](std::uintptr_t p, const AllocationRegion& region)
+        { return p < reinterpret_cast<std::uintptr_t>(region.end_ptr()); });
+    if (it == regions.end())
+    {
+        return kInvalidChunkHandle;
+    }
+    if (cursor < reinterpret_cast<std::uintptr_t>(it->ptr()))
+    {
+        return it->get_handle(it->ptr());
+    }
+
+    // Chunk covering the cursor: only chunk starts have handles, and the
+    // first chunk of a region always starts at the region
+    auto*       p = reinterpret_cast<const char*>(cursor);
+    ChunkHandle h = it->get_handle(p);
+    while (h == kInvalidChunkHandle)
+    {
+        p -= kMinAllocationSize;
+        h = it->get_handle(p);
+    }
+
+    ChunkHandle const next = ChunkFromHandle(h)->next;
+    if (next != kInvalidChunkHandle)
+    {
+        return next;
+    }
+    ++it;
+    return it == regions.end() ? kInvalidChunkHandle : it->get_handle(it->ptr());
 }
 
 std::optional<allocator_stats> allocator_bfc::GetStats() const
@@ -1673,6 +2197,7 @@ std::optional<allocator_stats> allocator_bfc::GetStats() const
     std::scoped_lock const lock(mutex_);
     // Create a copy of the atomic stats structure
     allocator_stats stats_copy(stats_);
+    stats_copy.largest_free_block_bytes.store(LargestFreeChunk(), std::memory_order_relaxed);
     return stats_copy;
 }
 
@@ -1717,6 +2242,193 @@ std::array<allocator_bfc::BinDebugInfo, allocator_bfc::kNumBins> allocator_bfc::
     return bin_infos;
 }
 
+allocator_bfc::ThreadCache* allocator_bfc::GetThreadCache()
+{
+    auto& slots = ThreadCacheSlots::local().slots_;
+    for (const auto& slot : slots)
+    {
+        if (slot.allocator_id == instance_id_)
+        {
+            return slot.cache.get();
+        }
+    }
+
+    // Forget the caches of the allocators destroyed since
+    slots.erase(
+        std::remove_if(
+            slots.begin(),
+            slots.end(),
+            [](const ThreadCacheSlots::Slot& slot)
+            {
+                std::scoped_lock const lock(slot.cache->mutex_);
+                return slot.cache->owner_ == nullptr;
+            }),
+        slots.end());
+
+    // Take over the cache of an exited thread, or create one
+    std::shared_ptr<ThreadCache> cache;
+    {
+        std::scoped_lock const lock(thread_caches_mutex_);
+        for (const auto& candidate : thread_caches_)
+        {
+            bool retired = true;
+            if (candidate->retired_.compare_exchange_strong(
+                    retired, false, std::memory_order_acq_rel))
+            {
+                cache = candidate;
+                break;
+            }
+        }
+        if (cache == nullptr)
+        {
+            cache = std::make_shared<ThreadCache>(this);
+            thread_caches_.push_back(cache);
+        }
+    }
+    slots.push_back({instance_id_, cache});
+    return cache.get();
+}
+
+void* allocator_bfc::AllocateFromThreadCache(size_t alignment, size_t num_bytes)
+    QUARISMA_NO_THREAD_SAFETY_ANALYSIS
+{
+    size_t const size_class = ThreadCacheClass(RoundedBytes(num_bytes));
+    ThreadCache* cache      = GetThreadCache();
+
+    std::scoped_lock const lock(cache->mutex_);
+    auto&                  entries = cache->free_[size_class];
+    if (entries.empty() && !RefillThreadCache(cache, size_class, alignment))
+    {
+        return nullptr;
+    }
+
+    ThreadCache::Entry const entry = entries.back();
+    entries.pop_back();
+    cache->in_use_.emplace(entry.chunk->ptr, entry);
+    RecordAllocation(entry.chunk, num_bytes);
+    return entry.chunk->ptr;
+}
+
+bool allocator_bfc::RefillThreadCache(ThreadCache* cache, size_t size_class, size_t alignment)
+    QUARISMA_NO_THREAD_SAFETY_ANALYSIS
+{
+    size_t const rounded_bytes = (size_class + 1) * kMinAllocationSize;
+    BinNum const bin_num       = BinNumForSize(rounded_bytes);
+    size_t const batch         = ThreadCacheBatchSize(size_class);
+    auto&        entries       = cache->free_[size_class];
+
+    std::scoped_lock const lock(mutex_);
+    bool                   extended = false;
+    while (entries.size() < batch)
+    {
+        ChunkHandle const h = FindChunk(bin_num, rounded_bytes, 0);
+        if (h == kInvalidChunkHandle)
+        {
+            // Regions grow geometrically: one extension covers the batch
+            if (extended || !Extend(alignment, rounded_bytes))
+            {
+                break;
+            }
+            extended = true;
+            continue;
+        }
+
+        Chunk* const chunk = ChunkFromHandle(h);
+        chunk->allocation_id.store(kThreadCacheAllocationId, std::memory_order_relaxed);
+        chunk->cache_owner = cache;
+        entries.push_back({h, chunk});
+    }
+    return !entries.empty();
+}
+
+bool allocator_bfc::ReleaseToThreadCache(ThreadCache* cache, void* ptr)
+    QUARISMA_NO_THREAD_SAFETY_ANALYSIS
+{
+    auto const it = cache->in_use_.find(ptr);
+    if (it == cache->in_use_.end())
+    {
+        return false;
+    }
+    ThreadCache::Entry const entry = it->second;
+    cache->in_use_.erase(it);
+
+    Chunk* const chunk = entry.chunk;
+    chunk->allocation_id.store(kThreadCacheAllocationId, std::memory_order_relaxed);
+    stats_.bytes_in_use.fetch_sub(chunk->size, std::memory_order_relaxed);
+
+    size_t const size_class = ThreadCacheClass(chunk->size);
+    size_t const batch      = ThreadCacheBatchSize(size_class);
+    auto&        entries    = cache->free_[size_class];
+    entries.push_back(entry);
+    if (entries.size() > 2 * batch)
+    {
+        {
+            std::scoped_lock const lock(mutex_);
+            ReturnThreadCacheChunks(cache, size_class, batch);
+        }
+        retry_helper_.NotifyDealloc();
+    }
+    return true;
+}
+
+void allocator_bfc::ReturnThreadCacheChunks(ThreadCache* cache, size_t size_class, size_t count)
+    QUARISMA_NO_THREAD_SAFETY_ANALYSIS
+{
+    // The oldest entries come first: the recently freed ones stay hot in the cache
+    auto& entries = cache->free_[size_class];
+    count         = std::min(count, entries.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        Chunk* const chunk = entries[i].chunk;
+        chunk->cache_owner = nullptr;
+        chunk->allocation_id.store(-1, std::memory_order_relaxed);
+        InsertFreeChunkIntoBin(TryToCoalesce(entries[i].handle, false));
+    }
+    entries.erase(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+bool allocator_bfc::ReleaseThreadCache(ThreadCache* cache, bool retire)
+    QUARISMA_NO_THREAD_SAFETY_ANALYSIS
+{
+    bool released = false;
+    {
+        std::scoped_lock const lock(mutex_);
+        for (size_t size_class = 0; size_class < cache->free_.size(); ++size_class)
+        {
+            released = released || !cache->free_[size_class].empty();
+            ReturnThreadCacheChunks(cache, size_class, cache->free_[size_class].size());
+        }
+
+        if (retire)
+        {
+            // The chunks still handed out become ordinary allocations
+            for (auto& item : cache->in_use_)
+            {
+                item.second.chunk->cache_owner = nullptr;
+            }
+            cache->in_use_.clear();
+        }
+    }
+
+    if (released)
+    {
+        retry_helper_.NotifyDealloc();
+    }
+    return released;
+}
+
+bool allocator_bfc::FlushThreadCaches()
+{
+    std::scoped_lock const lock(thread_caches_mutex_);
+    bool                   released = false;
+    for (const auto& cache : thread_caches_)
+    {
+        std::scoped_lock const cache_lock(cache->mutex_);
+        released = ReleaseThreadCache(cache.get(), /*retire=*/false) || released;
+    }
+    return released;
+}
+
 allocator_memory_enum allocator_bfc::GetMemoryType() const noexcept
 {
     return sub_allocator_->GetMemoryType();
@@ -31,19 +31,27 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <set>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "common/macros.h"
 #include "logging/logger.h"
 #include "memory/backend/allocator_retry.h"
 #include "memory/cpu/allocator.h"
+#include "memory/helper/memory_pressure.h"
+#include "parallel/profiled_mutex.h"
 #include "util/flat_hash.h"
 #include "util/string_util.h"
 namespace quarisma
@@ -193,7 +201,163 @@ private:
     std::atomic<int64_t> value_{0};  ///< Atomic counter storage
 };
 
-class memory_dump;
+// Memory map of an allocator_bfc, returned by RecordMemoryMap().
+class MemAllocatorStats
+{
+public:
+    // Getters
+    QUARISMA_NODISCARD int64_t num_allocs() const { return num_allocs_; }
+    QUARISMA_NODISCARD int64_t bytes_in_use() const { return bytes_in_use_; }
+    QUARISMA_NODISCARD int64_t peak_bytes_in_use() const { return peak_bytes_in_use_; }
+    QUARISMA_NODISCARD int64_t largest_alloc_size() const { return largest_alloc_size_; }
+    QUARISMA_NODISCARD float   fragmentation_metric() const { return fragmentation_metric_; }
+
+    // Setters
+    void set_num_allocs(int64_t value) { num_allocs_ = value; }
+    void set_bytes_in_use(int64_t value) { bytes_in_use_ = value; }
+    void set_peak_bytes_in_use(int64_t value) { peak_bytes_in_use_ = value; }
+    void set_largest_alloc_size(int64_t value) { largest_alloc_size_ = value; }
+    void set_fragmentation_metric(float value) { fragmentation_metric_ = value; }
+
+private:
+    int64_t num_allocs_{0};
+    int64_t bytes_in_use_{0};
+    int64_t peak_bytes_in_use_{0};
+    int64_t largest_alloc_size_{0};
+    float   fragmentation_metric_{0.0F};
+};
+
+class MemChunk
+{
+public:
+    // Getters
+    QUARISMA_NODISCARD uint64_t address() const { return address_; }
+    QUARISMA_NODISCARD int64_t  size() const { return size_; }
+    QUARISMA_NODISCARD int64_t  requested_size() const { return requested_size_; }
+    QUARISMA_NODISCARD int32_t  bin() const { return bin_; }
+    QUARISMA_NODISCARD const std::string& op_name() const { return op_name_; }
+    QUARISMA_NODISCARD uint64_t           freed_at_count() const { return freed_at_count_; }
+    QUARISMA_NODISCARD uint64_t           action_count() const { return action_count_; }
+    QUARISMA_NODISCARD bool               in_use() const { return in_use_; }
+    QUARISMA_NODISCARD uint64_t           step_id() const { return step_id_; }
+
+    // Setters
+    void set_address(uint64_t value) { address_ = value; }
+    void set_size(int64_t value) { size_ = value; }
+    void set_requested_size(int64_t value) { requested_size_ = value; }
+    void set_bin(int32_t value) { bin_ = value; }
+    void set_op_name(const std::string& value) { op_name_ = value; }
+    void set_op_name(std::string&& value) { op_name_ = std::move(value); }
+    void set_freed_at_count(uint64_t value) { freed_at_count_ = value; }
+    void set_action_count(uint64_t value) { action_count_ = value; }
+    void set_in_use(bool value) { in_use_ = value; }
+    void set_step_id(uint64_t value) { step_id_ = value; }
+
+private:
+    uint64_t    address_{0};
+    int64_t     size_{0};
+    int64_t     requested_size_{0};
+    int32_t     bin_{0};
+    std::string op_name_;
+    uint64_t    freed_at_count_{0};
+    uint64_t    action_count_{0};
+    bool        in_use_{false};
+    uint64_t    step_id_{0};
+};
+
+class BinSummary
+{
+public:
+    // Getters
+    QUARISMA_NODISCARD int32_t bin() const { return bin_; }
+    QUARISMA_NODISCARD int64_t total_bytes_in_use() const { return total_bytes_in_use_; }
+    QUARISMA_NODISCARD int64_t total_bytes_in_bin() const { return total_bytes_in_bin_; }
+    QUARISMA_NODISCARD int64_t total_chunks_in_use() const { return total_chunks_in_use_; }
+    QUARISMA_NODISCARD int64_t total_chunks_in_bin() const { return total_chunks_in_bin_; }
+
+    // Setters
+    void set_bin(int32_t value) { bin_ = value; }
+    void set_total_bytes_in_use(int64_t value) { total_bytes_in_use_ = value; }
+    void set_total_bytes_in_bin(int64_t value) { total_bytes_in_bin_ = value; }
+    void set_total_chunks_in_use(int64_t value) { total_chunks_in_use_ = value; }
+    void set_total_chunks_in_bin(int64_t value) { total_chunks_in_bin_ = value; }
+
+private:
+    int32_t bin_{0};
+    int64_t total_bytes_in_use_{0};
+    int64_t total_bytes_in_bin_{0};
+    int64_t total_chunks_in_use_{0};
+    int64_t total_chunks_in_bin_{0};
+};
+
+class SnapShot
+{
+public:
+    // Getters
+    QUARISMA_NODISCARD uint64_t action_count() const { return action_count_; }
+    QUARISMA_NODISCARD int64_t  size() const { return size_; }
+
+    // Setters
+    void set_action_count(uint64_t value) { action_count_ = value; }
+    void set_size(int64_t value) { size_ = value; }
+
+private:
+    uint64_t action_count_{0};
+    int64_t  size_{0};
+};
+
+class memory_dump
+{
+public:
+    // Getters
+    QUARISMA_NODISCARD const std::string& allocator_name() const { return allocator_name_; }
+    QUARISMA_NODISCARD const std::vector<BinSummary>& bin_summary() const { return bin_summary_; }
+    QUARISMA_NODISCARD const std::vector<MemChunk>& chunk() const { return chunk_; }
+    QUARISMA_NODISCARD const std::vector<SnapShot>& snap_shot() const { return snap_shot_; }
+    QUARISMA_NODISCARD const MemAllocatorStats&     stats() const { return stats_; }
+
+    // Mutable accessors
+    MemAllocatorStats* stats() { return &stats_; }
+
+    // Setters
+    void set_allocator_name(const std::string& name) { allocator_name_ = name; }
+    void set_allocator_name(std::string&& name) { allocator_name_ = std::move(name); }
+
+    // Add methods
+    BinSummary* add_bin_summary()
+    {
+        bin_summary_.emplace_back();
+        return &bin_summary_.back();
+    }
+
+    MemChunk* add_chunk()
+    {
+        chunk_.emplace_back();
+        return &chunk_.back();
+    }
+
+    SnapShot* add_snap_shot()
+    {
+        snap_shot_.emplace_back();
+        return &snap_shot_.back();
+    }
+
+    void Clear()
+    {
+        allocator_name_.clear();
+        bin_summary_.clear();
+        chunk_.clear();
+        snap_shot_.clear();
+        stats_ = MemAllocatorStats{};
+    }
+
+private:
+    std::string             allocator_name_;
+    std::vector<BinSummary> bin_summary_;
+    std::vector<MemChunk>   chunk_;
+    std::vector<SnapShot>   snap_shot_;
+    MemAllocatorStats       stats_;
+};
 
 /**
  * @brief High-performance Best-Fit with Coalescing (BFC) memory allocator.
@@ -310,6 +474,59 @@ public:
          * **Example**: 0.1 means split only if remainder > 10% of original chunk
          */
         double fragmentation_fraction = 0.0;
+
+        /**
+         * @brief Enables per-thread caches of small chunks in front of the allocator.
+         *
+         * When true, allocations of up to kThreadCacheMaxBytes are served from a
+         * cache owned by the calling thread, in the manner of tcmalloc's thread
+         * caches: each cache keeps freed chunks per size class, refills a class
+         * with a batch of chunks under a single acquisition of the allocator
+         * mutex, and returns half of a class to the allocator when it overflows.
+         * A chunk freed by another thread goes back to the cache it came from.
+         *
+         * GetStats() and AllocationId() are unaffected: cached chunks count as
+         * free in bytes_in_use, and every allocation gets a new id. Chunks held
+         * by caches are returned when the allocator runs out of memory, on
+         * FlushThreadCaches() and when their thread exits.
+         *
+         * **Default**: false (every call takes the allocator mutex)
+         * **Performance**: Removes the allocator mutex from the small-allocation
+         * fast path, which is the main contention point with many threads
+         * **Limitations**: Bypassed when a timing counter is set (see
+         * SetTimingCounter()) or when allocation_attributes::freed_by_func is used
+         */
+        bool thread_cache = false;
+
+        /**
+         * @brief Period of the background compaction thread (0 = no thread).
+         *
+         * When non-zero, a thread owned by the allocator wakes up at this
+         * period and runs a compaction pass: unpinned movable allocations (see
+         * AllocateMovable()) are relocated out of sparsely used regions, and
+         * regions that have stayed without any allocation for
+         * region_idle_timeout are returned to the sub_allocator. Long-running
+         * processes then give back the peaks of their usage instead of
+         * fragmenting into many partly used regions.
+         *
+         * **Default**: 0 (compaction only on Compact() or ReleaseFreeRegions())
+         * **Performance**: One pass holds the mutex for O(chunks) plus the copies
+         * **Limitations**: Relocation needs host-accessible memory; on device
+         * memory movable allocations are never moved, free regions are still released
+         */
+        std::chrono::milliseconds compaction_interval{0};
+
+        /**
+         * @brief Time a region must stay free before the background compaction
+         * releases it.
+         *
+         * Regions are seen by the compaction passes only, so a region is
+         * released between region_idle_timeout and region_idle_timeout +
+         * compaction_interval after its last allocation was freed.
+         *
+         * **Default**: 30 seconds
+         */
+        std::chrono::milliseconds region_idle_timeout{30000};
     };
 
     /**
@@ -513,6 +730,122 @@ public:
      */
     QUARISMA_API bool ClearStats() override;
 
+    /**
+     * @brief Counters and wait-time distribution of the allocations that waited
+     *        for memory to be freed.
+     *
+     * **Thread Safety**: Thread-safe
+     */
+    allocator_retry::wait_stats GetRetryWaitStats() const
+    {
+        return retry_helper_.GetWaitStats();
+    }
+
+    /**
+     * @brief Exposes stats_ for lock-free loads; GetStats() takes mutex_.
+     */
+    const allocator_stats* live_stats() const noexcept override
+        QUARISMA_NO_THREAD_SAFETY_ANALYSIS
+    {
+        return &stats_;
+    }
+
+    /**
+     * @brief Returns the free chunks held by all thread caches to the allocator.
+     *
+     * @return true if any chunk was returned
+     *
+     * **Thread Safety**: Thread-safe
+     * **Performance**: O(cached chunks) - takes each cache lock in turn
+     * **Use Cases**: Before measuring fragmentation, under memory pressure
+     */
+    QUARISMA_API bool FlushThreadCaches();
+
+    /**
+     * @brief Returns every region without an allocation to the sub_allocator.
+     *
+     * @return Bytes returned to the sub_allocator
+     *
+     * Thread caches are flushed first. Unlike Options::garbage_collection,
+     * this releases the regions regardless of a pending request; the
+     * allocator registers it with memory_pressure at memory_trim_cost::MEDIUM.
+     *
+     * **Thread Safety**: Thread-safe
+     * **Performance**: O(chunks) plus one sub_allocator Free() per region
+     * **Use Cases**: Memory pressure relief, shrinking after a peak
+     */
+    QUARISMA_API size_t ReleaseFreeRegions();
+
+    /**
+     * @brief Handle of a movable allocation, see AllocateMovable().
+     */
+    using movable_handle = uint64_t;
+
+    /**
+     * @brief Handle returned when a movable allocation fails.
+     */
+    static constexpr movable_handle kInvalidMovableHandle = 0;
+
+    /**
+     * @brief Allocates a buffer that compaction may relocate while it is unpinned.
+     *
+     * The buffer has no stable address: PinMovable() returns its current
+     * address and keeps it there until the matching UnpinMovable(). Between
+     * pins, a compaction pass may copy it to another region so that its
+     * region can be returned to the sub_allocator. Use it for long-lived
+     * buffers accessed in bursts, such as caches and staging data.
+     *
+     * @param alignment Required alignment in bytes (must be power of 2)
+     * @param num_bytes Size of the buffer
+     * @return Handle of the buffer, or kInvalidMovableHandle on failure
+     *
+     * **Thread Safety**: Thread-safe
+     * **Statistics**: Counted as an ordinary allocation, and again on each move
+     */
+    QUARISMA_API movable_handle AllocateMovable(size_t alignment, size_t num_bytes);
+
+    /**
+     * @brief Pins a movable allocation and returns its address.
+     *
+     * Pins nest: the buffer stays in place until every PinMovable() is
+     * matched by an UnpinMovable().
+     *
+     * @throws quarisma::exception if handle is unknown
+     */
+    QUARISMA_API void* PinMovable(movable_handle handle);
+
+    /**
+     * @brief Releases a pin taken by PinMovable().
+     */
+    QUARISMA_API void UnpinMovable(movable_handle handle);
+
+    /**
+     * @brief Frees a movable allocation; it must not be pinned.
+     */
+    QUARISMA_API void DeallocateMovable(movable_handle handle);
+
+    /**
+     * @brief Runs a compaction pass now and releases every free region.
+     *
+     * Relocates the unpinned movable allocations of each region that holds
+     * nothing else into the other regions, then returns all the regions
+     * without an allocation to the sub_allocator, regardless of
+     * Options::region_idle_timeout. Regions are emptied in increasing order
+     * of bytes in use; a region whose allocations do not fit elsewhere is
+     * left as it is.
+     *
+     * @return Bytes returned to the sub_allocator
+     *
+     * **Thread Safety**: Thread-safe
+     * **Performance**: O(chunks) plus one copy per relocated allocation
+     */
+    QUARISMA_API size_t Compact();
+
+    /**
+     * @brief Largest allocation served by the thread caches (Options::thread_cache).
+     */
+    static constexpr size_t kThreadCacheMaxBytes = 8 << 10;
+
     /**
      * @brief Sets timing counter for temporal memory management.
      *
@@ -568,8 +901,37 @@ public:
      */
     QUARISMA_API memory_dump RecordMemoryMap();
 
+    /**
+     * @brief Captures the memory map in batches, releasing the lock in between.
+     *
+     * @param chunks_per_batch Chunks copied per hold of the lock (at least 1)
+     * @return memory_dump of the allocator state when the last batch was copied
+     *
+     * Chunks are copied in address order. The chunks behind the copy cursor
+     * that change while the lock is released are logged and read again at the
+     * next batch, so the result is as consistent as RecordMemoryMap() without
+     * stalling the allocating threads for the whole walk. Concurrent calls run
+     * one after the other.
+     *
+     * **Performance**: O(n) in total; O(chunks_per_batch + changed chunks) per lock hold
+     * **Thread Safety**: Thread-safe
+     * **Use Cases**: Periodic memory maps of large heaps in production
+     */
+    QUARISMA_API memory_dump RecordMemoryMapIncremental(size_t chunks_per_batch = 4096);
+
+    /**
+     * @brief Sets a function RecordMemoryMapIncremental() calls between two
+     * batches, while the lock is released. For tests only; pass an empty
+     * function to remove it.
+     */
+    QUARISMA_API void SetMapBatchHookForTesting(std::function<void()> hook);
+
 private:
-    struct Bin;  ///< Forward declaration of bin structure
+    struct Bin;               ///< Forward declaration of bin structure
+    struct Chunk;             ///< Forward declaration of chunk structure
+    class ThreadCache;        ///< Per-thread cache of small chunks, see Options::thread_cache
+    struct ThreadCacheSlots;  ///< Caches of the calling thread, one per allocator
+    struct MapSnapshot;       ///< Progress of RecordMemoryMapIncremental()
 
     /**
      * @brief Core allocation implementation without retry logic.
@@ -619,13 +981,91 @@ private:
      * constraints and statistics updates.
      *
      * @param ptr Pointer to memory to deallocate
+     * @return Size of the free chunk the memory is now part of, or 0 when it went
+     *         back to a thread cache or awaits the safe frontier
      *
      * **Algorithm Complexity**: O(log n) average for coalescing and bin operations
      * **Thread Safety**: Requires external mutex protection
      * **Coalescing Strategy**: Immediate coalescing with adjacent free chunks
      * **Bin Management**: Places coalesced chunks in appropriate size bins
      */
-    void DeallocateRawInternal(void* ptr) QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    size_t DeallocateRawInternal(void* ptr) QUARISMA_LOCKS_EXCLUDED(mutex_);
+
+    /**
+     * @brief Marks a chunk as allocated for num_bytes and updates the statistics.
+     *
+     * Assigns a new allocation id. Only touches atomics, so the thread caches
+     * call it without holding the mutex on chunks they own.
+     */
+    void RecordAllocation(Chunk* chunk, size_t num_bytes);
+
+    /**
+     * @brief Size class of the thread caches for a chunk or a rounded request.
+     *
+     * Class c holds chunks of at least (c + 1) * kMinAllocationSize bytes.
+     */
+    static size_t ThreadCacheClass(size_t bytes) noexcept
+    {
+        return std::min(bytes, kThreadCacheMaxBytes) / kMinAllocationSize - 1;
+    }
+
+    /**
+     * @brief Number of chunks moved at once between a thread cache class and
+     * the allocator (about one L1d, between 2 and 32 chunks).
+     */
+    size_t ThreadCacheBatchSize(size_t size_class) const noexcept
+    {
+        const size_t bytes = (size_class + 1) * kMinAllocationSize;
+        return std::clamp<size_t>(thread_cache_batch_bytes_ / bytes, 2, 32);
+    }
+
+    /**
+     * @brief Returns the calling thread's cache for this allocator, creating it if needed.
+     */
+    ThreadCache* GetThreadCache() QUARISMA_LOCKS_EXCLUDED(mutex_);
+
+    /**
+     * @brief Fast path of allocate_raw() through the calling thread's cache.
+     *
+     * @return Allocated memory, or nullptr if the allocator has no chunk to
+     * refill the cache with (the caller then takes the regular path)
+     */
+    void* AllocateFromThreadCache(size_t alignment, size_t num_bytes)
+        QUARISMA_LOCKS_EXCLUDED(mutex_);
+
+    /**
+     * @brief Moves a batch of chunks of size_class from the bins into cache,
+     * growing the pool if needed. Requires the cache lock.
+     *
+     * @return true if at least one chunk was moved
+     */
+    bool RefillThreadCache(ThreadCache* cache, size_t size_class, size_t alignment)
+        QUARISMA_LOCKS_EXCLUDED(mutex_);
+
+    /**
+     * @brief Puts ptr back in cache if it was handed out from there.
+     *
+     * Returns the oldest half of the size class to the allocator when the
+     * class holds more than two batches. Requires the cache lock.
+     *
+     * @return false if ptr does not belong to cache
+     */
+    bool ReleaseToThreadCache(ThreadCache* cache, void* ptr) QUARISMA_LOCKS_EXCLUDED(mutex_);
+
+    /**
+     * @brief Returns the first count cached chunks of size_class to the bins.
+     */
+    void ReturnThreadCacheChunks(ThreadCache* cache, size_t size_class, size_t count)
+        QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    /**
+     * @brief Returns all the cached chunks of a cache, and gives up the
+     * ownership of the chunks handed out from it when retire is true
+     * (their thread has exited). Requires the cache lock.
+     *
+     * @return true if any chunk was returned
+     */
+    bool ReleaseThreadCache(ThreadCache* cache, bool retire) QUARISMA_LOCKS_EXCLUDED(mutex_);
 
     /**
      * @brief Processes timestamped chunks for safe memory reuse.
@@ -668,7 +1108,7 @@ private:
      * **Implementation**: Checks largest bin with free chunks
      * **Use Cases**: Fragmentation metrics, allocation planning, statistics
      */
-    int64_t LargestFreeChunk() QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    int64_t LargestFreeChunk() const QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
     /**
      * @brief Adds profiling trace for memory operations.
@@ -730,6 +1170,14 @@ private:
      */
     static constexpr ChunkHandle kInvalidChunkHandle = SIZE_MAX;
 
+    /**
+     * @brief Allocation id of the free chunks held by a thread cache.
+     *
+     * Not -1, so that the allocator treats them as in use, and never
+     * assigned to an allocation since ids start at 1.
+     */
+    static constexpr int64_t kThreadCacheAllocationId = 0;
+
     /**
      * @brief Type for bin number identification.
      *
@@ -810,8 +1258,9 @@ private:
          * **Usage**: Efficiency analysis, fragmentation metrics, debugging
          * **Invariant**: requested_size <= size
          * **Statistics**: Used for overhead calculations and optimization
+         * **Thread Safety**: Atomic, thread caches set it without the allocator mutex
          */
-        size_t requested_size{0};
+        std::atomic<size_t> requested_size{0};
 
         /**
          * @brief Unique identifier for allocated chunks.
@@ -822,13 +1271,14 @@ private:
          *
          * **Values**:
          * - -1: Chunk is free and available for allocation
+         * - 0: Chunk is free but held by a thread cache (kThreadCacheAllocationId)
          * - >0: Chunk is allocated with unique identifier
          *
          * **Uniqueness**: Each allocated chunk gets a different positive ID
-         * **Thread Safety**: Atomically updated during allocation/deallocation
+         * **Thread Safety**: Atomic, thread caches set it without the allocator mutex
          * **Use Cases**: Memory leak detection, allocation tracking, debugging
          */
-        int64_t allocation_id{-1};
+        std::atomic<int64_t> allocation_id{-1};
 
         /**
          * @brief Pointer to the actual memory buffer.
@@ -909,6 +1359,15 @@ private:
          */
         uint64_t freed_at_count{0};
 
+        /**
+         * @brief Thread cache owning this chunk, or nullptr.
+         *
+         * Set while the chunk belongs to a thread cache, whether it is cached
+         * there or handed out from there. Such chunks are in use for the
+         * allocator: they are never split, merged or put in a bin.
+         */
+        ThreadCache* cache_owner{nullptr};
+
         /**
          * @brief Checks if chunk is currently allocated.
          *
@@ -1839,6 +2298,46 @@ private:
      */
     bool DeallocateFreeRegions(size_t rounded_bytes) QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+    /**
+     * @brief Collects the regions that contain no chunk in use.
+     *
+     * @param region_ptrs Receives the base pointers of the free regions
+     * @return Total bytes of the free regions
+     */
+    size_t FindFreeRegions(flat_hash_set<void*>* region_ptrs)
+        QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    /**
+     * @brief One compaction pass, see Options::compaction_interval.
+     *
+     * Relocates the unpinned movable allocations of the regions that hold
+     * nothing else, sparsest first, then releases the regions that have been
+     * free for at least idle_timeout (all the free ones for a zero timeout).
+     *
+     * @return Bytes returned to the sub_allocator
+     */
+    size_t CompactInternal(std::chrono::steady_clock::duration idle_timeout)
+        QUARISMA_LOCKS_EXCLUDED(mutex_);
+
+    /**
+     * @brief Moves the allocations of a region into the other regions.
+     *
+     * Every allocation of the region must be an unpinned movable one, found
+     * in movable_by_ptr, which is updated with the new address of each moved
+     * allocation. The free chunks of the region are kept out of the bins
+     * during the moves, so that the copies land elsewhere.
+     *
+     * @return true if the region was left without allocations
+     */
+    bool EvacuateRegion(
+        const AllocationRegion& region, flat_hash_map<void*, movable_handle>& movable_by_ptr)
+        QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    /**
+     * @brief Body of the background compaction thread.
+     */
+    void CompactionLoop() QUARISMA_LOCKS_EXCLUDED(mutex_);
+
     /**
      * @brief Helper to deallocate specified regions back to sub_allocator.
      *
@@ -1874,6 +2373,18 @@ private:
         BinNum bin_num, size_t rounded_bytes, size_t num_bytes, uint64_t freed_before)
         QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+    /**
+     * @brief Takes the best-fit free chunk of at least rounded_bytes out of the bins.
+     *
+     * Search and split part of FindChunkPtr(), without marking the chunk
+     * allocated: FindChunkPtr() records the allocation, the thread caches
+     * keep the chunk for later allocations.
+     *
+     * @return Handle of the chunk, or kInvalidChunkHandle if none is suitable
+     */
+    ChunkHandle FindChunk(BinNum bin_num, size_t rounded_bytes, uint64_t freed_before)
+        QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
     /**
      * @brief Splits chunk into two parts for allocation.
      *
@@ -2015,6 +2526,42 @@ private:
      */
     void MaybeWriteMemoryMap() QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+    /**
+     * @brief Records the stats, fragmentation and size history of a memory map.
+     */
+    void RecordMemoryMapStats(memory_dump* md) QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    /**
+     * @brief Records the state of one chunk in a memory map.
+     */
+    void RecordChunk(const Chunk& c, MemChunk* mc) const QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    /**
+     * @brief Logs a chunk change for the incremental memory map in progress.
+     *
+     * @param ptr Address of the chunk that changed, was created or was deleted
+     *
+     * **Performance**: O(1) - a single branch unless a snapshot is running
+     */
+    void NoteChunkChange(const void* ptr) QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    /**
+     * @brief Returns the first chunk after address cursor, in address order.
+     *
+     * @param cursor Address of the last chunk copied, 0 to start from the lowest region
+     * @return Next chunk to copy, or kInvalidChunkHandle past the last region
+     *
+     * The chunk at cursor may have been merged into its predecessor since, or
+     * its region released; the walk then resumes after the chunk covering
+     * cursor, or at the next region.
+     */
+    ChunkHandle NextMapChunk(std::uintptr_t cursor) const QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    /**
+     * @brief Returns the chunk starting at ptr, or kInvalidChunkHandle.
+     */
+    ChunkHandle MapChunkAt(const void* ptr) const QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
     /**
      * @brief Allocates new chunk handle from internal pool.
      *
@@ -2137,6 +2684,11 @@ private:
      */
     allocator_retry retry_helper_;
 
+    /**
+     * @brief Registration of ReleaseFreeRegions() with memory_pressure.
+     */
+    memory_pressure::cache_id pressure_id_{0};
+
     /**
      * @brief Maximum memory limit in bytes (0 = unlimited).
      *
@@ -2159,6 +2711,11 @@ private:
         return reinterpret_cast<Bin*>(&(bins_space_[index * sizeof(Bin)]));
     }
 
+    const Bin* BinFromIndex(BinNum index) const noexcept
+    {
+        return reinterpret_cast<const Bin*>(&(bins_space_[index * sizeof(Bin)]));
+    }
+
     /**
      * @brief Converts bin number to minimum size for that bin.
      *
@@ -2282,7 +2839,31 @@ private:
      * internal data structure operations. Marked mutable to allow
      * const methods to acquire locks for read operations.
      */
-    mutable std::mutex mutex_;
+    mutable profiled_mutex mutex_{"allocator_bfc"};
+
+    /**
+     * @brief Unique id of this instance, to find its thread caches
+     * even when a later allocator is constructed at the same address.
+     */
+    const uint64_t instance_id_;
+
+    /**
+     * @brief Bytes of a thread cache refill, the L1d of a core so that the
+     * chunks of a batch are still cached when handed out.
+     */
+    const size_t thread_cache_batch_bytes_;
+
+    /**
+     * @brief All the thread caches created for this allocator.
+     *
+     * Caches of exited threads are kept and reused by new threads, so a
+     * cache pointer read from Chunk::cache_owner stays valid for the
+     * lifetime of the allocator. Lock order: thread_caches_mutex_, then a
+     * cache lock, then mutex_.
+     */
+    std::mutex                                thread_caches_mutex_;
+    std::vector<std::shared_ptr<ThreadCache>> thread_caches_ QUARISMA_GUARDED_BY(
+        thread_caches_mutex_);
 
     /**
      * @brief Manager for all memory regions obtained from sub_allocator.
@@ -2293,12 +2874,13 @@ private:
     RegionManager region_manager_ QUARISMA_GUARDED_BY(mutex_);
 
     /**
-     * @brief Vector storing all chunk metadata.
+     * @brief Deque storing all chunk metadata.
      *
      * Central repository for chunk information. ChunkHandles are
-     * indices into this vector. May contain gaps for deallocated chunks.
+     * indices into this deque. May contain gaps for deallocated chunks.
+     * Elements never move, so thread caches keep Chunk pointers.
      */
-    std::vector<Chunk> chunks_ QUARISMA_GUARDED_BY(mutex_);
+    std::deque<Chunk> chunks_ QUARISMA_GUARDED_BY(mutex_);
 
     /**
      * @brief Head of linked list of free chunk handles.
@@ -2314,9 +2896,52 @@ private:
      *
      * Provides unique positive IDs for each allocation to enable
      * tracking, debugging, and correlation with external systems.
-     * Incremented for each new allocation.
+     * Incremented for each new allocation, atomically since the thread
+     * caches allocate without the mutex.
+     */
+    std::atomic<int64_t> next_allocation_id_{1};
+
+    /**
+     * @brief A movable allocation, see AllocateMovable().
+     */
+    struct MovableAllocation
+    {
+        void* ptr{nullptr};  ///< Current address, changed by compaction
+        int   pins{0};       ///< Outstanding PinMovable() calls; moved only at 0
+    };
+
+    /**
+     * @brief Movable allocations by handle.
+     */
+    flat_hash_map<movable_handle, MovableAllocation> movable_ QUARISMA_GUARDED_BY(mutex_);
+
+    /**
+     * @brief Next handle returned by AllocateMovable(); 0 is kInvalidMovableHandle.
+     */
+    movable_handle next_movable_handle_ QUARISMA_GUARDED_BY(mutex_){1};
+
+    /**
+     * @brief When each free region was first seen free by a compaction pass.
+     */
+    flat_hash_map<void*, std::chrono::steady_clock::time_point> region_free_since_
+        QUARISMA_GUARDED_BY(mutex_);
+
+    /**
+     * @brief Background compaction thread, running when
+     * Options::compaction_interval is non-zero, and its stop request.
+     */
+    std::mutex              compaction_mutex_;
+    std::condition_variable compaction_cv_;
+    bool                    stop_compaction_ QUARISMA_GUARDED_BY(compaction_mutex_){false};
+    std::thread             compaction_thread_;
+
+    /**
+     * @brief Incremental memory map in progress, if any, and the lock that
+     * runs RecordMemoryMapIncremental() calls one after the other.
      */
-    int64_t next_allocation_id_ QUARISMA_GUARDED_BY(mutex_){1};
+    MapSnapshot*          map_snapshot_ QUARISMA_GUARDED_BY(mutex_){nullptr};
+    std::mutex            map_snapshot_mutex_;
+    std::function<void()> map_batch_hook_ QUARISMA_GUARDED_BY(map_snapshot_mutex_);
 
     /**
      * @brief Comprehensive allocator statistics and metrics.
@@ -0,0 +1,288 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/backend/allocator_huge_page.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "logging/logger.h"
+#include "memory/helper/memory_allocator.h"
+#include "memory/numa.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/tracing/traceme.h"
+#endif
+
+#ifdef _WIN32
+#include <Windows.h>
+#define QUARISMA_HUGE_PAGE_VIRTUAL_ALLOC 1
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define QUARISMA_HUGE_PAGE_MMAP 1
+#if defined(__linux__)
+#include <sys/stat.h>
+#endif
+#endif
+
+namespace quarisma
+{
+namespace
+{
+size_t round_up(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+bool is_power_of_two(size_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+#if defined(QUARISMA_HUGE_PAGE_MMAP) && defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+int log2_of(size_t value)
+{
+    int shift = 0;
+    while ((size_t{1} << shift) < value)
+    {
+        ++shift;
+    }
+    return shift;
+}
+#endif
+
+size_t effective_page_size(const huge_page_cpu_allocator::Options& opts)
+{
+#ifdef QUARISMA_HUGE_PAGE_VIRTUAL_ALLOC
+    // Windows has a single large page size, and no transparent huge pages.
+    const size_t large_page = GetLargePageMinimum();
+    if (opts.use_explicit_pages && large_page != 0)
+    {
+        return large_page;
+    }
+#endif
+    return opts.page_size;
+}
+}  // namespace
+
+huge_page_cpu_allocator::huge_page_cpu_allocator(
+    int                         numa_node,
+    const std::vector<Visitor>& alloc_visitors,
+    const std::vector<Visitor>& free_visitors,
+    const Options&              opts)
+    : sub_allocator(alloc_visitors, free_visitors),
+      numa_node_(numa_node),
+      use_explicit_pages_(opts.use_explicit_pages),
+      page_size_(effective_page_size(opts))
+{
+    QUARISMA_CHECK(
+        is_power_of_two(page_size_) && page_size_ >= 4096,
+        "huge page size must be a power of two of at least 4 KiB, got ",
+        page_size_);
+
+    if (use_explicit_pages_ && !ExplicitPagesSupported(page_size_))
+    {
+        QUARISMA_LOG_WARNING(
+            "Explicit huge pages of {} bytes are not supported; regions fall back to "
+            "transparent huge pages",
+            page_size_);
+    }
+}
+
+huge_page_cpu_allocator::~huge_page_cpu_allocator() = default;
+
+void* huge_page_cpu_allocator::Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received)
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    quarisma::traceme const traceme("huge_page_cpu_allocator::Alloc");
+#endif
+
+    *bytes_received = num_bytes;
+    if (num_bytes == 0)
+    {
+        return nullptr;
+    }
+
+    const size_t bytes = round_up(num_bytes, page_size_);
+    void*        ptr   = nullptr;
+
+    // Explicit pages are aligned to the page size; larger alignments use the
+    // transparent path, which aligns explicitly.
+    if (use_explicit_pages_ && alignment <= page_size_)
+    {
+        ptr = MapExplicit(bytes);
+        if (ptr != nullptr)
+        {
+            explicit_regions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (fallback_regions_.load(std::memory_order_relaxed) == 0)
+        {
+            QUARISMA_LOG_WARNING(
+                "Huge page pool exhausted for a {} byte region; falling back to transparent "
+                "huge pages",
+                bytes);
+        }
+    }
+    if (ptr == nullptr)
+    {
+        ptr = MapTransparent(alignment, bytes);
+        if (ptr == nullptr)
+        {
+            return nullptr;
+        }
+        fallback_regions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (numa_node_ >= 0)
+    {
+        NUMAMove(ptr, bytes, numa_node_);
+    }
+
+    *bytes_received = bytes;
+    VisitAlloc(ptr, numa_node_, bytes);
+    return ptr;
+}
+
+void huge_page_cpu_allocator::Free(void* ptr, size_t num_bytes)
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    quarisma::traceme const traceme("huge_page_cpu_allocator::Free");
+#endif
+
+    if (ptr == nullptr || num_bytes == 0)
+    {
+        return;
+    }
+    VisitFree(ptr, numa_node_, num_bytes);
+
+#if defined(QUARISMA_HUGE_PAGE_VIRTUAL_ALLOC)
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(QUARISMA_HUGE_PAGE_MMAP)
+    // Both page modes are plain mappings of the rounded size reported by Alloc().
+    munmap(ptr, num_bytes);
+#else
+    quarisma::cpu::memory_allocator::free(ptr, num_bytes);
+#endif
+}
+
+void* huge_page_cpu_allocator::MapExplicit(QUARISMA_UNUSED size_t num_bytes) noexcept
+{
+#if defined(QUARISMA_HUGE_PAGE_VIRTUAL_ALLOC)
+    if (GetLargePageMinimum() == 0)
+    {
+        return nullptr;
+    }
+    // Fails unless the process holds SeLockMemoryPrivilege.
+    return VirtualAlloc(
+        nullptr, num_bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+#elif defined(QUARISMA_HUGE_PAGE_MMAP) && defined(MAP_HUGETLB)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+    flags |= log2_of(page_size_) << MAP_HUGE_SHIFT;
+#endif
+    void* ptr = mmap(nullptr, num_bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+    return nullptr;
+#endif
+}
+
+void* huge_page_cpu_allocator::MapTransparent(size_t alignment, size_t num_bytes) noexcept
+{
+#if defined(QUARISMA_HUGE_PAGE_VIRTUAL_ALLOC)
+    // VirtualAlloc aligns to the 64 KiB allocation granularity. For more, reserve
+    // a larger range to find an aligned address, release it and map at that
+    // address; another thread may take it in between, hence the retries.
+    if (alignment <= (64 << 10))
+    {
+        return VirtualAlloc(nullptr, num_bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    for (int attempt = 0; attempt < 8; ++attempt)
+    {
+        void* probe = VirtualAlloc(nullptr, num_bytes + alignment, MEM_RESERVE, PAGE_NOACCESS);
+        if (probe == nullptr)
+        {
+            return nullptr;
+        }
+        const auto aligned = round_up(reinterpret_cast<uintptr_t>(probe), alignment);
+        VirtualFree(probe, 0, MEM_RELEASE);
+        void* ptr = VirtualAlloc(
+            reinterpret_cast<void*>(aligned), num_bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (ptr != nullptr)
+        {
+            return ptr;
+        }
+    }
+    return nullptr;
+#elif defined(QUARISMA_HUGE_PAGE_MMAP)
+    // Over-map by the alignment and trim both ends, so that the region starts on
+    // a huge page boundary and every page of it can be promoted.
+    const size_t align = std::max(alignment, page_size_);
+    const size_t span  = num_bytes + align;
+    void*        raw =
+        mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    const auto   start   = reinterpret_cast<uintptr_t>(raw);
+    const auto   aligned = round_up(start, align);
+    const size_t head    = aligned - start;
+    const size_t tail    = span - head - num_bytes;
+    if (head > 0)
+    {
+        munmap(raw, head);
+    }
+    if (tail > 0)
+    {
+        munmap(reinterpret_cast<void*>(aligned + num_bytes), tail);
+    }
+
+    void* ptr = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+    if (page_size_ > static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+    {
+        madvise(ptr, num_bytes, MADV_HUGEPAGE);
+    }
+#endif
+    return ptr;
+#else
+    return quarisma::cpu::memory_allocator::allocate(num_bytes, std::max(alignment, page_size_));
+#endif
+}
+
+/*static*/ bool huge_page_cpu_allocator::ExplicitPagesSupported(
+    QUARISMA_UNUSED size_t page_size) noexcept
+{
+#if defined(QUARISMA_HUGE_PAGE_VIRTUAL_ALLOC)
+    return GetLargePageMinimum() != 0;
+#elif defined(__linux__) && defined(MAP_HUGETLB)
+    const std::string path =
+        "/sys/kernel/mm/hugepages/hugepages-" + std::to_string(page_size >> 10) + "kB";
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+#else
+    return false;
+#endif
+}
+
+}  // namespace quarisma
@@ -0,0 +1,169 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/macros.h"
+#include "memory/sub_allocator.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief sub_allocator backing its regions with huge pages.
+ *
+ * basic_cpu_allocator obtains regions from the general purpose heap, which
+ * maps them with base (4 KiB) pages. For the large regions allocator_bfc asks
+ * for, every page of a big array costs a TLB entry; huge_page_cpu_allocator
+ * maps regions directly from the OS so that they are covered by 2 MiB (or
+ * 1 GiB) pages instead.
+ *
+ * **Page Modes**:
+ * - Transparent (default): the region is mapped aligned to Options::page_size
+ *   and advised with madvise(MADV_HUGEPAGE), so the kernel backs it with
+ *   transparent huge pages when it can. Needs no system configuration.
+ *   Windows has no transparent huge pages: there the region is a plain
+ *   VirtualAlloc mapping.
+ * - Explicit (Options::use_explicit_pages): the region is mapped from the
+ *   reserved huge page pool, with mmap(MAP_HUGETLB) on Linux and
+ *   VirtualAlloc(MEM_LARGE_PAGES) on Windows. Guarantees huge pages but needs
+ *   pages reserved in /proc/sys/vm/nr_hugepages, or SeLockMemoryPrivilege on
+ *   Windows. When the pool is exhausted the region falls back to the
+ *   transparent mode.
+ *
+ * On platforms without either facility, regions come from
+ * cpu::memory_allocator aligned to the page size.
+ *
+ * **Sizes**: Regions are rounded up to a multiple of the page size and the
+ * rounded size is reported in bytes_received, so allocator_bfc uses the whole
+ * region.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * huge_page_cpu_allocator::Options pages;
+ * pages.use_explicit_pages = true;
+ * allocator_bfc bfc(
+ *     std::make_unique<huge_page_cpu_allocator>(numa_node, visitors, visitors, pages),
+ *     64LL << 30, "bfc_huge_pages", allocator_bfc::Options{});
+ * ```
+ * process_state uses it for its BFC CPU allocator when CPU_BFC_USE_HUGE_PAGES
+ * is set, with explicit pages when CPU_BFC_USE_EXPLICIT_HUGE_PAGES is set too.
+ *
+ * **Thread Safety**: Fully thread-safe
+ */
+class QUARISMA_VISIBILITY huge_page_cpu_allocator : public sub_allocator
+{
+public:
+    /**
+     * @brief Configuration options for huge_page_cpu_allocator.
+     */
+    struct Options
+    {
+        /**
+         * @brief Huge page size in bytes, a power of two.
+         *
+         * Regions are aligned to and rounded up to this size. With explicit
+         * pages it selects the pool: 2 MiB or 1 GiB on x86-64. On Windows the
+         * large page size of the system is used instead. The base page size
+         * (4 KiB) maps regions with base pages, which still places them on
+         * the NUMA node given to the constructor.
+         *
+         * **Default**: 2 MiB
+         */
+        size_t page_size = 2 << 20;
+
+        /**
+         * @brief Map regions from the reserved huge page pool.
+         *
+         * **Default**: false (transparent huge pages)
+         */
+        bool use_explicit_pages = false;
+    };
+
+    /**
+     * @brief Constructs a huge page sub_allocator.
+     *
+     * @param numa_node NUMA node the regions are moved to, or -1 for no affinity
+     * @param alloc_visitors Functions called on each allocation
+     * @param free_visitors Functions called on each deallocation
+     * @param opts Page size and mode
+     */
+    QUARISMA_API huge_page_cpu_allocator(
+        int                         numa_node,
+        const std::vector<Visitor>& alloc_visitors,
+        const std::vector<Visitor>& free_visitors,
+        const Options&              opts);
+
+    QUARISMA_API ~huge_page_cpu_allocator() override;
+
+    QUARISMA_API void* Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received) override;
+
+    QUARISMA_API void Free(void* ptr, size_t num_bytes) override;
+
+    bool SupportsCoalescing() const override { return false; }
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return allocator_memory_enum::HOST_PAGEABLE;
+    }
+
+    /** Page size regions are rounded to, in bytes. */
+    size_t page_size() const noexcept { return page_size_; }
+
+    /** Number of regions mapped from the explicit huge page pool. */
+    int64_t explicit_regions() const noexcept
+    {
+        return explicit_regions_.load(std::memory_order_relaxed);
+    }
+
+    /** Number of regions mapped with transparent huge pages or from the heap. */
+    int64_t fallback_regions() const noexcept
+    {
+        return fallback_regions_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Whether the platform supports explicit huge pages of `page_size`.
+     *
+     * Checks /sys/kernel/mm/hugepages on Linux and GetLargePageMinimum() on
+     * Windows; it does not tell whether pages are currently reserved.
+     */
+    QUARISMA_API static bool ExplicitPagesSupported(size_t page_size) noexcept;
+
+private:
+    void* MapExplicit(size_t num_bytes) noexcept;
+    void* MapTransparent(size_t alignment, size_t num_bytes) noexcept;
+
+    const int    numa_node_;
+    const bool   use_explicit_pages_;
+    const size_t page_size_;
+
+    std::atomic<int64_t> explicit_regions_{0};
+    std::atomic<int64_t> fallback_regions_{0};
+
+    huge_page_cpu_allocator(const huge_page_cpu_allocator&) = delete;
+    void operator=(const huge_page_cpu_allocator&)          = delete;
+};
+
+}  // namespace quarisma
@@ -0,0 +1,564 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/backend/allocator_mmap.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "memory/helper/memory_allocator.h"
+#include "util/error.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/tracing/traceme.h"
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define QUARISMA_MMAP_POSIX 1
+#endif
+
+namespace quarisma
+{
+namespace
+{
+// Regions belong to no NUMA node in particular
+constexpr int no_numa_node = -1;
+
+// Alignment that lets the kernel back an anonymous region with 2 MiB pages
+constexpr size_t huge_page_bytes = size_t{2} << 20;
+
+size_t round_up(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+#ifdef QUARISMA_MMAP_POSIX
+int advice_of(mmap_access access)
+{
+    switch (access)
+    {
+    case mmap_access::SEQUENTIAL:
+        return MADV_SEQUENTIAL;
+    case mmap_access::RANDOM:
+        return MADV_RANDOM;
+    default:
+        return MADV_NORMAL;
+    }
+}
+
+void request_huge_pages(QUARISMA_UNUSED void* ptr, QUARISMA_UNUSED size_t bytes)
+{
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+}
+
+// Closes a descriptor on every path out of a scope
+struct fd_closer
+{
+    int fd;
+    ~fd_closer() { ::close(fd); }
+};
+#endif
+}  // namespace
+
+//-----------------------------------------------------------------------------
+// mmap_buffer
+//-----------------------------------------------------------------------------
+
+mmap_buffer::~mmap_buffer()
+{
+    reset();
+}
+
+mmap_buffer::mmap_buffer(mmap_buffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      writable_(std::exchange(other.writable_, false)),
+      heap_(std::exchange(other.heap_, false))
+{
+}
+
+mmap_buffer& mmap_buffer::operator=(mmap_buffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        data_     = std::exchange(other.data_, nullptr);
+        size_     = std::exchange(other.size_, 0);
+        writable_ = std::exchange(other.writable_, false);
+        heap_     = std::exchange(other.heap_, false);
+    }
+    return *this;
+}
+
+mmap_buffer mmap_buffer::open(const std::string& path, const Options& opts)
+{
+#ifdef QUARISMA_MMAP_POSIX
+    QUARISMA_CHECK(
+        opts.offset % page_size() == 0,
+        "mmap offset {} is not a multiple of the page size {}",
+        opts.offset,
+        page_size());
+
+    int const flags = opts.writable ? O_RDWR | O_CREAT : O_RDONLY;
+    int const fd    = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    QUARISMA_CHECK(fd >= 0, "failed to open {}: {}", path, utils::str_error(errno));
+    // The mapping keeps the file open on its own
+    fd_closer const closer{fd};
+
+    struct stat info{};
+    QUARISMA_CHECK(fstat(fd, &info) == 0, "failed to stat {}: {}", path, utils::str_error(errno));
+    auto const file_size = static_cast<size_t>(info.st_size);
+
+    size_t size = opts.size;
+    if (size == 0)
+    {
+        QUARISMA_CHECK(
+            file_size > opts.offset, "nothing to map in {} from offset {}", path, opts.offset);
+        size = file_size - opts.offset;
+    }
+    if (opts.offset + size > file_size)
+    {
+        QUARISMA_CHECK(
+            opts.writable,
+            "{} holds {} bytes, fewer than {} from offset {}",
+            path,
+            file_size,
+            size,
+            opts.offset);
+        QUARISMA_CHECK(
+            ftruncate(fd, static_cast<off_t>(opts.offset + size)) == 0,
+            "failed to extend {} to {} bytes: {}",
+            path,
+            opts.offset + size,
+            utils::str_error(errno));
+    }
+
+    int const prot = PROT_READ | (opts.writable ? PROT_WRITE : 0);
+    void*     data = mmap(nullptr, size, prot, MAP_SHARED, fd, static_cast<off_t>(opts.offset));
+    QUARISMA_CHECK(data != MAP_FAILED, "failed to map {}: {}", path, utils::str_error(errno));
+
+    mmap_buffer buffer;
+    buffer.data_     = data;
+    buffer.size_     = size;
+    buffer.writable_ = opts.writable;
+    if (opts.huge_pages)
+    {
+        request_huge_pages(data, size);
+    }
+    buffer.advise(opts.access);
+    if (opts.will_need)
+    {
+        buffer.will_need();
+    }
+    return buffer;
+#else
+    QUARISMA_THROW("mmap_buffer cannot map files on this platform: {}", path);
+#endif
+}
+
+mmap_buffer mmap_buffer::anonymous(size_t size, const Options& opts)
+{
+    QUARISMA_CHECK(size > 0, "an anonymous mmap_buffer needs at least one byte");
+
+    mmap_buffer buffer;
+    buffer.size_     = size;
+    buffer.writable_ = true;
+#ifdef QUARISMA_MMAP_POSIX
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    QUARISMA_CHECK(
+        data != MAP_FAILED, "failed to map {} anonymous bytes: {}", size, utils::str_error(errno));
+    buffer.data_ = data;
+    if (opts.huge_pages)
+    {
+        request_huge_pages(data, size);
+    }
+    buffer.advise(opts.access);
+#else
+    (void)opts;
+    buffer.data_ = cpu::memory_allocator::allocate_zero(size, page_size());
+    buffer.heap_ = true;
+    QUARISMA_CHECK(buffer.data_ != nullptr, "failed to allocate {} bytes", size);
+#endif
+    return buffer;
+}
+
+void mmap_buffer::advise(
+    QUARISMA_UNUSED mmap_access access,
+    QUARISMA_UNUSED size_t      offset,
+    QUARISMA_UNUSED size_t      length)
+{
+#ifdef QUARISMA_MMAP_POSIX
+    if (heap_ || offset >= size_)
+    {
+        return;
+    }
+    // madvise() takes whole pages: widen the range to the pages it touches
+    size_t const start = offset / page_size() * page_size();
+    size_t const end   = offset + std::min(length, size_ - offset);
+    madvise(static_cast<char*>(data_) + start, end - start, advice_of(access));
+#endif
+}
+
+void mmap_buffer::will_need(QUARISMA_UNUSED size_t offset, QUARISMA_UNUSED size_t length)
+{
+#ifdef QUARISMA_MMAP_POSIX
+    if (heap_ || offset >= size_)
+    {
+        return;
+    }
+    size_t const start = offset / page_size() * page_size();
+    size_t const end   = offset + std::min(length, size_ - offset);
+    madvise(static_cast<char*>(data_) + start, end - start, MADV_WILLNEED);
+#endif
+}
+
+void mmap_buffer::dont_need(QUARISMA_UNUSED size_t offset, QUARISMA_UNUSED size_t length)
+{
+#ifdef QUARISMA_MMAP_POSIX
+    if (heap_ || offset >= size_)
+    {
+        return;
+    }
+    // Rounded inwards: a partial page may hold data outside the range
+    size_t const start = round_up(offset, page_size());
+    size_t const end   = offset + std::min(length, size_ - offset);
+    // The last page of the mapping is whole even when the file ends inside it
+    size_t const last = end == size_ ? round_up(end, page_size()) : end / page_size() * page_size();
+    if (last > start)
+    {
+        madvise(static_cast<char*>(data_) + start, last - start, MADV_DONTNEED);
+    }
+#endif
+}
+
+void mmap_buffer::sync()
+{
+#ifdef QUARISMA_MMAP_POSIX
+    if (heap_ || !writable_ || data_ == nullptr)
+    {
+        return;
+    }
+    QUARISMA_CHECK(
+        msync(data_, size_, MS_SYNC) == 0,
+        "failed to write back {} mapped bytes: {}",
+        size_,
+        utils::str_error(errno));
+#endif
+}
+
+void mmap_buffer::reset() noexcept
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+    if (heap_)
+    {
+        cpu::memory_allocator::free(data_, size_);
+    }
+#ifdef QUARISMA_MMAP_POSIX
+    else
+    {
+        munmap(data_, size_);
+    }
+#endif
+    data_     = nullptr;
+    size_     = 0;
+    writable_ = false;
+    heap_     = false;
+}
+
+/*static*/ size_t mmap_buffer::page_size() noexcept
+{
+#ifdef QUARISMA_MMAP_POSIX
+    static size_t const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page;
+#else
+    return 4096;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// mmap_cpu_allocator
+//-----------------------------------------------------------------------------
+
+mmap_cpu_allocator::mmap_cpu_allocator(
+    const std::vector<Visitor>& alloc_visitors,
+    const std::vector<Visitor>& free_visitors,
+    const Options&              opts)
+    : sub_allocator(alloc_visitors, free_visitors),
+      access_(opts.access),
+      huge_pages_(opts.huge_pages)
+{
+    if (opts.path.empty())
+    {
+        return;
+    }
+#ifdef QUARISMA_MMAP_POSIX
+    fd_ = ::open(opts.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    QUARISMA_CHECK(fd_ >= 0, "failed to create {}: {}", opts.path, utils::str_error(errno));
+    if (!opts.keep_file)
+    {
+        // The open descriptor keeps the data until the allocator closes it
+        unlink(opts.path.c_str());
+    }
+#else
+    QUARISMA_THROW("mmap_cpu_allocator cannot map files on this platform: {}", opts.path);
+#endif
+}
+
+mmap_cpu_allocator::~mmap_cpu_allocator()
+{
+#ifdef QUARISMA_MMAP_POSIX
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+#endif
+}
+
+void* mmap_cpu_allocator::Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received)
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    quarisma::traceme const traceme("mmap_cpu_allocator::Alloc");
+#endif
+
+    *bytes_received = num_bytes;
+    if (num_bytes == 0)
+    {
+        return nullptr;
+    }
+
+    size_t const bytes = round_up(num_bytes, mmap_buffer::page_size());
+    void*        ptr   = nullptr;
+    if (file_backed())
+    {
+        std::scoped_lock const lock(mutex_);
+        size_t const           offset = TakeExtent(bytes);
+        if (offset == SIZE_MAX)
+        {
+            return nullptr;
+        }
+        ptr = MapRegion(alignment, bytes, offset);
+        if (ptr == nullptr)
+        {
+            ReturnExtent({offset, bytes});
+            return nullptr;
+        }
+        regions_.emplace(ptr, extent{offset, bytes});
+    }
+    else
+    {
+        ptr = MapRegion(huge_pages_ ? std::max(alignment, huge_page_bytes) : alignment, bytes, 0);
+        if (ptr == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+#ifdef QUARISMA_MMAP_POSIX
+    if (access_ != mmap_access::NORMAL)
+    {
+        madvise(ptr, bytes, advice_of(access_));
+    }
+    if (huge_pages_)
+    {
+        request_huge_pages(ptr, bytes);
+    }
+#endif
+
+    mapped_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    *bytes_received = bytes;
+    VisitAlloc(ptr, no_numa_node, bytes);
+    return ptr;
+}
+
+void mmap_cpu_allocator::Free(void* ptr, size_t num_bytes)
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    quarisma::traceme const traceme("mmap_cpu_allocator::Free");
+#endif
+
+    if (ptr == nullptr || num_bytes == 0)
+    {
+        return;
+    }
+    VisitFree(ptr, no_numa_node, num_bytes);
+
+#ifdef QUARISMA_MMAP_POSIX
+    munmap(ptr, num_bytes);
+#else
+    cpu::memory_allocator::free(ptr, num_bytes);
+#endif
+    mapped_bytes_.fetch_sub(num_bytes, std::memory_order_relaxed);
+
+    if (file_backed())
+    {
+        // Unmapped first, so that no write-back reaches the range once it is reused
+        std::scoped_lock const lock(mutex_);
+        auto                   it = regions_.find(ptr);
+        if (it != regions_.end())
+        {
+            ReturnExtent(it->second);
+            regions_.erase(it);
+        }
+    }
+}
+
+size_t mmap_cpu_allocator::file_bytes() const
+{
+    std::scoped_lock const lock(mutex_);
+    return file_size_;
+}
+
+size_t mmap_cpu_allocator::TakeExtent(size_t bytes)
+{
+    // First fit among the ranges of freed regions
+    for (auto it = free_extents_.begin(); it != free_extents_.end(); ++it)
+    {
+        if (it->second < bytes)
+        {
+            continue;
+        }
+        size_t const offset = it->first;
+        size_t const rest   = it->second - bytes;
+        free_extents_.erase(it);
+        if (rest > 0)
+        {
+            free_extents_.emplace(offset + bytes, rest);
+        }
+        return offset;
+    }
+
+#ifdef QUARISMA_MMAP_POSIX
+    if (ftruncate(fd_, static_cast<off_t>(file_size_ + bytes)) != 0)
+    {
+        return SIZE_MAX;
+    }
+#endif
+    size_t const offset = file_size_;
+    file_size_ += bytes;
+    return offset;
+}
+
+void mmap_cpu_allocator::ReturnExtent(extent range)
+{
+    // Merge with the free neighbours on either side
+    auto next = free_extents_.lower_bound(range.offset);
+    if (next != free_extents_.end() && range.offset + range.size == next->first)
+    {
+        range.size += next->second;
+        next = free_extents_.erase(next);
+    }
+    if (next != free_extents_.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == range.offset)
+        {
+            range.offset = prev->first;
+            range.size += prev->second;
+            free_extents_.erase(prev);
+        }
+    }
+
+#ifdef QUARISMA_MMAP_POSIX
+    // Give the disk blocks back: truncate a free tail, punch a hole elsewhere
+    if (range.offset + range.size == file_size_ &&
+        ftruncate(fd_, static_cast<off_t>(range.offset)) == 0)
+    {
+        file_size_ = range.offset;
+        return;
+    }
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+    fallocate(
+        fd_,
+        FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+        static_cast<off_t>(range.offset),
+        static_cast<off_t>(range.size));
+#endif
+#endif
+    free_extents_.emplace(range.offset, range.size);
+}
+
+void* mmap_cpu_allocator::MapRegion(size_t alignment, size_t bytes, size_t offset) noexcept
+{
+#ifdef QUARISMA_MMAP_POSIX
+    int const prot  = PROT_READ | PROT_WRITE;
+    int       flags = fd_ >= 0 ? MAP_SHARED : MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= fd_ >= 0 ? 0 : MAP_NORESERVE;
+#endif
+    auto const file_offset = static_cast<off_t>(offset);
+
+    if (alignment <= mmap_buffer::page_size())
+    {
+        void* ptr = mmap(nullptr, bytes, prot, flags, fd_, file_offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    // Reserve an inaccessible range with room to align, map the region over
+    // its aligned part and unmap what is left on either side.
+    size_t const span = bytes + alignment;
+    void* const  raw  = mmap(nullptr, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    auto const start   = reinterpret_cast<uintptr_t>(raw);
+    auto const aligned = round_up(start, alignment);
+    void*      ptr =
+        mmap(reinterpret_cast<void*>(aligned), bytes, prot, flags | MAP_FIXED, fd_, file_offset);
+    if (ptr == MAP_FAILED)
+    {
+        munmap(raw, span);
+        return nullptr;
+    }
+    size_t const head = aligned - start;
+    size_t const tail = span - head - bytes;
+    if (head > 0)
+    {
+        munmap(raw, head);
+    }
+    if (tail > 0)
+    {
+        munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    }
+    return ptr;
+#else
+    (void)offset;
+    return cpu::memory_allocator::allocate_zero(
+        bytes, std::max(alignment, mmap_buffer::page_size()));
+#endif
+}
+
+}  // namespace quarisma
@@ -0,0 +1,335 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "memory/sub_allocator.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief How a mapping is going to be read, passed on to madvise().
+ */
+enum class mmap_access : uint8_t
+{
+    /** @brief Default read-ahead. */
+    NORMAL = 0,
+
+    /** @brief Read front to back: aggressive read-ahead, pages dropped once read. */
+    SEQUENTIAL = 1,
+
+    /** @brief Read in no particular order: no read-ahead. */
+    RANDOM = 2
+};
+
+/**
+ * @brief A file, or anonymous swap-backed memory, mapped into the address space.
+ *
+ * Pages are read from the file when first touched and written back by the
+ * kernel, so data sets larger than RAM are used in place, without copying
+ * into the heap: the page cache is the buffer. mmap_buffer owns the mapping
+ * and unmaps it when destroyed; the file itself is closed as soon as it is
+ * mapped.
+ *
+ * **Read-ahead**: Options::access sets the pattern for the whole mapping, and
+ * advise(), will_need() and dont_need() adjust ranges of it, e.g. to fetch
+ * the next block of a tick file while the current one is processed.
+ *
+ * **Huge Pages**: Options::huge_pages asks for transparent huge pages with
+ * madvise(MADV_HUGEPAGE). Anonymous mappings accept it everywhere; files only
+ * on file systems with huge page support (tmpfs, or hugetlbfs where every
+ * mapping is huge regardless).
+ *
+ * **Example Usage**:
+ * ```cpp
+ * mmap_buffer::Options opts;
+ * opts.access = mmap_access::SEQUENTIAL;
+ * auto ticks  = mmap_buffer::open("/data/ticks/2024-06.bin", opts);
+ * const auto* rows = static_cast<const tick*>(ticks.data());
+ * ```
+ *
+ * Only POSIX systems map files; elsewhere open() throws and anonymous()
+ * falls back to cpu::memory_allocator.
+ *
+ * **Thread Safety**: The mapping may be read and written from any thread;
+ * moving or destroying it must not race with other uses.
+ */
+class QUARISMA_VISIBILITY mmap_buffer
+{
+public:
+    /**
+     * @brief Configuration options for mmap_buffer.
+     */
+    struct Options
+    {
+        /**
+         * @brief Map for writing. Writes to a file mapping reach the file.
+         *
+         * **Default**: false (read-only)
+         */
+        bool writable = false;
+
+        /**
+         * @brief Bytes to map, or 0 for the rest of the file from offset.
+         *
+         * A writable file shorter than offset + size is extended to it.
+         *
+         * **Default**: 0
+         */
+        size_t size = 0;
+
+        /**
+         * @brief Offset of the mapping in the file, a multiple of page_size().
+         *
+         * **Default**: 0
+         */
+        size_t offset = 0;
+
+        /**
+         * @brief Access pattern of the whole mapping.
+         *
+         * **Default**: NORMAL
+         */
+        mmap_access access = mmap_access::NORMAL;
+
+        /**
+         * @brief Start reading the whole mapping in the background (MADV_WILLNEED).
+         *
+         * **Default**: false
+         */
+        bool will_need = false;
+
+        /**
+         * @brief Ask for transparent huge pages (MADV_HUGEPAGE).
+         *
+         * **Default**: false
+         */
+        bool huge_pages = false;
+    };
+
+    /** @brief An empty buffer, mapping nothing. */
+    mmap_buffer() noexcept = default;
+
+    QUARISMA_API ~mmap_buffer();
+
+    QUARISMA_API mmap_buffer(mmap_buffer&& other) noexcept;
+    QUARISMA_API mmap_buffer& operator=(mmap_buffer&& other) noexcept;
+
+    /**
+     * @brief Maps the file at `path`, creating it when writable.
+     *
+     * @throws quarisma::Error when the file cannot be opened, sized or mapped
+     */
+    QUARISMA_API static mmap_buffer open(const std::string& path, const Options& opts);
+
+    static mmap_buffer open(const std::string& path) { return open(path, Options{}); }
+
+    /**
+     * @brief Maps `size` bytes of zeroed memory backed by swap, not by the heap.
+     *
+     * The memory is reserved without committing it (MAP_NORESERVE), so it may
+     * exceed RAM; Options::offset is ignored and Options::writable is implied.
+     *
+     * @throws quarisma::Error when the region cannot be mapped
+     */
+    QUARISMA_API static mmap_buffer anonymous(size_t size, const Options& opts);
+
+    static mmap_buffer anonymous(size_t size) { return anonymous(size, Options{}); }
+
+    void*  data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    bool   empty() const noexcept { return size_ == 0; }
+    bool   writable() const noexcept { return writable_; }
+
+    /** @brief Sets the access pattern of [offset, offset + length), clamped to the mapping. */
+    QUARISMA_API void advise(mmap_access access, size_t offset = 0, size_t length = SIZE_MAX);
+
+    /** @brief Starts reading [offset, offset + length) in the background. */
+    QUARISMA_API void will_need(size_t offset = 0, size_t length = SIZE_MAX);
+
+    /**
+     * @brief Drops the pages of [offset, offset + length) from memory.
+     *
+     * File pages, written ones included, are read back from the page cache
+     * or the file on the next access; anonymous pages read back as zero.
+     */
+    QUARISMA_API void dont_need(size_t offset = 0, size_t length = SIZE_MAX);
+
+    /** @brief Writes modified pages back to the file and waits for the writes. */
+    QUARISMA_API void sync();
+
+    /** @brief Unmaps the buffer, leaving it empty. */
+    QUARISMA_API void reset() noexcept;
+
+    /** @brief Granularity of offsets and of the ranges advised, in bytes. */
+    QUARISMA_API static size_t page_size() noexcept;
+
+private:
+    void*  data_     = nullptr;
+    size_t size_     = 0;
+    bool   writable_ = false;
+    bool   heap_     = false;  // Allocated by the fallback of anonymous()
+
+    mmap_buffer(const mmap_buffer&)    = delete;
+    void operator=(const mmap_buffer&) = delete;
+};
+
+/**
+ * @brief sub_allocator mapping its regions from a file or from swap.
+ *
+ * basic_cpu_allocator and huge_page_cpu_allocator commit RAM for every
+ * region. mmap_cpu_allocator maps regions that the kernel pages out to a
+ * backing store under memory pressure instead, so that an allocator_bfc on
+ * top of it can hold scenario cubes and other working sets larger than RAM.
+ *
+ * **Backing Store**:
+ * - Anonymous (Options::path empty, the default): MAP_NORESERVE mappings
+ *   backed by swap.
+ * - File (Options::path set): every region is a shared mapping of its own
+ *   range of the file, so pages are written back to the file rather than to
+ *   swap; suited to a scratch file on NVMe. The file grows as regions are
+ *   allocated; the range of a freed region is reused, and on Linux its disk
+ *   blocks are released. Unless Options::keep_file is set the file is
+ *   removed as soon as it is opened, and disappears with the allocator.
+ *
+ * **Sizes**: Regions are rounded up to a multiple of the page size and the
+ * rounded size is reported in bytes_received, so allocator_bfc uses the whole
+ * region.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * mmap_cpu_allocator::Options scratch;
+ * scratch.path = "/nvme/scratch/scenarios.bin";
+ * allocator_bfc bfc(
+ *     std::make_unique<mmap_cpu_allocator>(visitors, visitors, scratch),
+ *     size_t{1} << 40, "bfc_out_of_core", allocator_bfc::Options{});
+ * ```
+ *
+ * **Thread Safety**: Fully thread-safe
+ */
+class QUARISMA_VISIBILITY mmap_cpu_allocator : public sub_allocator
+{
+public:
+    /**
+     * @brief Configuration options for mmap_cpu_allocator.
+     */
+    struct Options
+    {
+        /**
+         * @brief Backing file, or empty for anonymous swap-backed regions.
+         *
+         * **Default**: empty
+         */
+        std::string path;
+
+        /**
+         * @brief Keep the backing file when the allocator is destroyed.
+         *
+         * **Default**: false (the file is removed once opened)
+         */
+        bool keep_file = false;
+
+        /**
+         * @brief Access pattern advised on every region.
+         *
+         * **Default**: NORMAL
+         */
+        mmap_access access = mmap_access::NORMAL;
+
+        /**
+         * @brief Ask for transparent huge pages on every region (MADV_HUGEPAGE).
+         *
+         * **Default**: false
+         */
+        bool huge_pages = false;
+    };
+
+    /**
+     * @brief Constructs an mmap sub_allocator.
+     *
+     * @param alloc_visitors Functions called on each allocation
+     * @param free_visitors Functions called on each deallocation
+     * @param opts Backing store and hints
+     * @throws quarisma::Error when the backing file cannot be created
+     */
+    QUARISMA_API mmap_cpu_allocator(
+        const std::vector<Visitor>& alloc_visitors,
+        const std::vector<Visitor>& free_visitors,
+        const Options&              opts);
+
+    QUARISMA_API ~mmap_cpu_allocator() override;
+
+    QUARISMA_API void* Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received) override;
+
+    QUARISMA_API void Free(void* ptr, size_t num_bytes) override;
+
+    bool SupportsCoalescing() const override { return false; }
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return allocator_memory_enum::HOST_PAGEABLE;
+    }
+
+    /** Whether regions are mapped from a file rather than from swap. */
+    bool file_backed() const noexcept { return fd_ >= 0; }
+
+    /** Bytes of regions currently mapped. */
+    size_t mapped_bytes() const noexcept { return mapped_bytes_.load(std::memory_order_relaxed); }
+
+    /** Size of the backing file, 0 when anonymous. */
+    QUARISMA_API size_t file_bytes() const;
+
+private:
+    // Range of the backing file taken by a region, or to be reused by the next ones
+    struct extent
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    size_t TakeExtent(size_t bytes);
+    void   ReturnExtent(extent range);
+    void*  MapRegion(size_t alignment, size_t bytes, size_t offset) noexcept;
+
+    const mmap_access access_;
+    const bool        huge_pages_;
+    int               fd_ = -1;
+
+    mutable std::mutex       mutex_;
+    size_t                   file_size_ = 0;
+    std::map<size_t, size_t> free_extents_;  // offset -> size, coalesced
+    std::map<void*, extent>  regions_;
+
+    std::atomic<size_t> mapped_bytes_{0};
+
+    mmap_cpu_allocator(const mmap_cpu_allocator&) = delete;
+    void operator=(const mmap_cpu_allocator&)     = delete;
+};
+
+}  // namespace quarisma
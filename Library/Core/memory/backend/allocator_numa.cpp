@@ -0,0 +1,334 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/backend/allocator_numa.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory/numa.h"
+#include "memory/sub_allocator.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+// Allocations between two GetCurrentNUMANode() calls of a thread.
+constexpr uint32_t kNodeRefreshInterval = 256;
+
+using stats_field = std::atomic<int64_t> allocator_stats::*;
+
+constexpr stats_field kSummedStats[] = {
+    &allocator_stats::num_allocs,
+    &allocator_stats::num_deallocs,
+    &allocator_stats::bytes_in_use,
+    &allocator_stats::peak_bytes_in_use,
+    &allocator_stats::active_allocations,
+    &allocator_stats::total_bytes_allocated,
+    &allocator_stats::total_bytes_deallocated,
+    &allocator_stats::failed_allocations,
+    &allocator_stats::total_allocations,
+    &allocator_stats::bytes_reserved,
+    &allocator_stats::peak_bytes_reserved,
+    &allocator_stats::bytes_reservable_limit,
+    &allocator_stats::pool_bytes,
+    &allocator_stats::peak_pool_bytes,
+    &allocator_stats::bytes_limit,
+};
+
+constexpr stats_field kMaxedStats[] = {
+    &allocator_stats::largest_alloc_size,
+    &allocator_stats::largest_free_block_bytes,
+};
+}  // namespace
+
+/**
+ * @brief Forwards to a node's sub_allocator and records its regions in the
+ * region table of the owning allocator_numa.
+ */
+class allocator_numa::node_sub_allocator : public sub_allocator
+{
+public:
+    node_sub_allocator(allocator_numa* owner, int numa_node, std::unique_ptr<sub_allocator> inner)
+        : sub_allocator({}, {}), owner_(owner), numa_node_(numa_node), inner_(std::move(inner))
+    {
+    }
+
+    void* Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received) override
+    {
+        void* ptr = inner_->Alloc(alignment, num_bytes, bytes_received);
+        if (ptr != nullptr)
+        {
+            owner_->AddRegion(ptr, *bytes_received, numa_node_);
+        }
+        return ptr;
+    }
+
+    void Free(void* ptr, size_t num_bytes) override
+    {
+        if (ptr != nullptr)
+        {
+            owner_->RemoveRegion(ptr);
+        }
+        inner_->Free(ptr, num_bytes);
+    }
+
+    // The region table tracks regions one by one, as returned by Alloc().
+    bool SupportsCoalescing() const override { return false; }
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return inner_->GetMemoryType();
+    }
+
+private:
+    allocator_numa*                owner_;
+    const int                      numa_node_;
+    std::unique_ptr<sub_allocator> inner_;
+};
+
+allocator_numa::allocator_numa(std::string name, const Options& opts)
+    : allocator_numa(
+          std::move(name),
+          std::max(1, GetNumNUMANodes()),
+          [pages = opts.pages](int numa_node) -> std::unique_ptr<sub_allocator>
+          {
+              return std::make_unique<huge_page_cpu_allocator>(
+                  IsNUMAEnabled() ? numa_node : -1,
+                  std::vector<sub_allocator::Visitor>{},
+                  std::vector<sub_allocator::Visitor>{},
+                  pages);
+          },
+          opts)
+{
+}
+
+allocator_numa::allocator_numa(
+    std::string name, int num_nodes, sub_allocator_factory factory, const Options& opts)
+    : name_(std::move(name))
+{
+    QUARISMA_CHECK(num_nodes >= 1, "allocator_numa needs at least one node, got ", num_nodes);
+    nodes_.reserve(num_nodes);
+    for (int node = 0; node < num_nodes; ++node)
+    {
+        nodes_.push_back(std::make_unique<allocator_bfc>(
+            std::make_unique<node_sub_allocator>(this, node, factory(node)),
+            opts.memory_limit_per_node,
+            name_ + "_node" + std::to_string(node),
+            opts.bfc));
+    }
+}
+
+allocator_numa::~allocator_numa()
+{
+    // The node allocators return their regions through RemoveRegion(), so they
+    // go before the region table.
+    nodes_.clear();
+}
+
+void* allocator_numa::allocate_raw(
+    size_t alignment, size_t num_bytes, const allocation_attributes& allocation_attr)
+{
+    return nodes_[CurrentNode()]->allocate_raw(alignment, num_bytes, allocation_attr);
+}
+
+void allocator_numa::deallocate_raw(void* ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    OwnerOf(ptr)->deallocate_raw(ptr);
+}
+
+size_t allocator_numa::RequestedSize(const void* ptr) const
+{
+    return OwnerOf(ptr)->RequestedSize(ptr);
+}
+
+size_t allocator_numa::AllocatedSize(const void* ptr) const
+{
+    return OwnerOf(ptr)->AllocatedSize(ptr);
+}
+
+int64_t allocator_numa::AllocationId(const void* ptr) const
+{
+    return OwnerOf(ptr)->AllocationId(ptr);
+}
+
+std::optional<allocator_stats> allocator_numa::GetStats() const
+{
+    allocator_stats total;
+    for (const auto& node : nodes_)
+    {
+        const auto stats = node->GetStats();
+        if (!stats.has_value())
+        {
+            continue;
+        }
+        for (const stats_field field : kSummedStats)
+        {
+            (total.*field) += ((*stats).*field).load(std::memory_order_relaxed);
+        }
+        for (const stats_field field : kMaxedStats)
+        {
+            const int64_t value = ((*stats).*field).load(std::memory_order_relaxed);
+            if (value > (total.*field).load(std::memory_order_relaxed))
+            {
+                (total.*field).store(value, std::memory_order_relaxed);
+            }
+        }
+    }
+    return total;
+}
+
+bool allocator_numa::ClearStats()
+{
+    bool cleared = true;
+    for (const auto& node : nodes_)
+    {
+        cleared = node->ClearStats() && cleared;
+    }
+    return cleared;
+}
+
+allocator_bfc* allocator_numa::node_allocator(int numa_node) const
+{
+    QUARISMA_CHECK(
+        numa_node >= 0 && numa_node < num_nodes(),
+        "NUMA node ",
+        numa_node,
+        " is out of range for ",
+        name_);
+    return nodes_[numa_node].get();
+}
+
+int allocator_numa::NodeOf(const void* ptr) const noexcept
+{
+    const auto   address = reinterpret_cast<uintptr_t>(ptr);
+    const size_t slots   = num_region_slots_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < slots; ++i)
+    {
+        const region& slot = regions_[i];
+        for (;;)
+        {
+            const uint32_t  version = slot.version.load(std::memory_order_acquire);
+            const uintptr_t begin   = slot.begin.load(std::memory_order_relaxed);
+            const uintptr_t end     = slot.end.load(std::memory_order_relaxed);
+            const int       node    = slot.node.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((version & 1) == 0 && slot.version.load(std::memory_order_relaxed) == version)
+            {
+                if (address >= begin && address < end)
+                {
+                    return node;
+                }
+                break;
+            }
+        }
+    }
+    return -1;
+}
+
+int allocator_numa::CurrentNode() const noexcept
+{
+    if (nodes_.size() == 1)
+    {
+        return 0;
+    }
+
+    thread_local int      node      = 0;
+    thread_local uint32_t countdown = 0;
+    if (countdown == 0)
+    {
+        node      = GetCurrentNUMANode();
+        countdown = kNodeRefreshInterval;
+    }
+    --countdown;
+    return node >= 0 && node < num_nodes() ? node : 0;
+}
+
+void allocator_numa::AddRegion(void* ptr, size_t num_bytes, int numa_node)
+{
+    const auto             begin = reinterpret_cast<uintptr_t>(ptr);
+    std::scoped_lock const lock(regions_mutex_);
+
+    const size_t slots = num_region_slots_.load(std::memory_order_relaxed);
+    size_t       index = 0;
+    while (index < slots && regions_[index].begin.load(std::memory_order_relaxed) !=
+                                regions_[index].end.load(std::memory_order_relaxed))
+    {
+        ++index;
+    }
+    QUARISMA_CHECK(index < kMaxRegions, "allocator_numa ", name_, " has too many regions");
+
+    region&        slot    = regions_[index];
+    const uint32_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.begin.store(begin, std::memory_order_relaxed);
+    slot.end.store(begin + num_bytes, std::memory_order_relaxed);
+    slot.node.store(numa_node, std::memory_order_relaxed);
+    slot.version.store(version + 2, std::memory_order_release);
+
+    if (index == slots)
+    {
+        num_region_slots_.store(slots + 1, std::memory_order_release);
+    }
+}
+
+void allocator_numa::RemoveRegion(void* ptr)
+{
+    const auto             begin = reinterpret_cast<uintptr_t>(ptr);
+    std::scoped_lock const lock(regions_mutex_);
+
+    const size_t slots = num_region_slots_.load(std::memory_order_relaxed);
+    for (size_t index = 0; index < slots; ++index)
+    {
+        region& slot = regions_[index];
+        if (slot.begin.load(std::memory_order_relaxed) == begin &&
+            slot.end.load(std::memory_order_relaxed) != begin)
+        {
+            const uint32_t version = slot.version.load(std::memory_order_relaxed);
+            slot.version.store(version + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.begin.store(0, std::memory_order_relaxed);
+            slot.end.store(0, std::memory_order_relaxed);
+            slot.node.store(-1, std::memory_order_relaxed);
+            slot.version.store(version + 2, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+allocator_bfc* allocator_numa::OwnerOf(const void* ptr) const
+{
+    const int node = NodeOf(ptr);
+    QUARISMA_CHECK(node >= 0, "Pointer ", ptr, " was not allocated by ", name_);
+    return nodes_[node].get();
+}
+
+}  // namespace quarisma
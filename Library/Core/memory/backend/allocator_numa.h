@@ -0,0 +1,217 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_huge_page.h"
+#include "memory/cpu/allocator.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief CPU allocator with one allocator_bfc per NUMA node.
+ *
+ * Each node has its own BFC region manager whose regions are mapped by a
+ * huge_page_cpu_allocator bound to that node (mbind), so memory handed out
+ * for a node is physically on it regardless of which thread touches it
+ * first. allocate_raw() serves the node of the calling thread; workers of
+ * parallel_thread_pool pinned with affinity_policy::numa therefore always
+ * allocate from their own node, and the data they produce stays local to
+ * the threads of parallel_for_numa() that consume it.
+ *
+ * deallocate_raw() may be called from any thread: the owning node is found
+ * from a table of the regions of every node, read without locking.
+ *
+ * Without NUMA support (or on a single node machine) there is one node and
+ * the allocator behaves like a single allocator_bfc on huge page regions.
+ *
+ * **Thread Safety**: Fully thread-safe
+ *
+ * **Example Usage**:
+ * ```cpp
+ * allocator_numa numa("numa_cpu", allocator_numa::Options{});
+ * void* local  = numa.allocate_raw(64, 1 << 20);                 // calling thread's node
+ * void* remote = numa.node_allocator(1)->allocate_raw(64, 4096); // explicit node
+ * numa.deallocate_raw(local);
+ * numa.deallocate_raw(remote);
+ * ```
+ */
+class QUARISMA_VISIBILITY allocator_numa : public Allocator
+{
+public:
+    /** Maximum number of regions over all nodes. */
+    static constexpr size_t kMaxRegions = 1024;
+
+    /**
+     * @brief Configuration options for allocator_numa.
+     */
+    struct Options
+    {
+        /** Memory limit of each node's allocator_bfc in bytes. */
+        size_t memory_limit_per_node = size_t{64} << 30;
+
+        /** Options of each node's allocator_bfc. */
+        allocator_bfc::Options bfc;
+
+        /** Page mode of the regions of each node. */
+        huge_page_cpu_allocator::Options pages;
+    };
+
+    /**
+     * @brief Creates the sub_allocator of node `numa_node`.
+     */
+    using sub_allocator_factory = std::function<std::unique_ptr<sub_allocator>(int numa_node)>;
+
+    /**
+     * @brief Constructs one allocator_bfc per NUMA node of the machine.
+     *
+     * @param name Human-readable name; nodes are named `<name>_node<i>`
+     * @param opts Per node limits and options
+     */
+    QUARISMA_API allocator_numa(std::string name, const Options& opts);
+
+    /**
+     * @brief Constructs `num_nodes` node allocators on custom sub_allocators.
+     *
+     * @param name Human-readable name
+     * @param num_nodes Number of nodes (at least 1)
+     * @param factory Creates the sub_allocator of each node
+     * @param opts Per node limits and BFC options (Options::pages is unused)
+     */
+    QUARISMA_API allocator_numa(
+        std::string           name,
+        int                   num_nodes,
+        sub_allocator_factory factory,
+        const Options&        opts);
+
+    QUARISMA_API ~allocator_numa() override;
+
+    std::string Name() const override { return name_; }
+
+    void* allocate_raw(size_t alignment, size_t num_bytes) override
+    {
+        return num_bytes == 0 ? nullptr
+                              : allocate_raw(alignment, num_bytes, allocation_attributes{});
+    }
+
+    /**
+     * @brief Allocates from the node of the calling thread.
+     *
+     * **Performance**: A thread local lookup, then the node's allocator_bfc
+     */
+    QUARISMA_API void* allocate_raw(
+        size_t alignment, size_t num_bytes, const allocation_attributes& allocation_attr) override;
+
+    /**
+     * @brief Returns `ptr` to the node allocator that owns it.
+     */
+    QUARISMA_API void deallocate_raw(void* ptr) override;
+
+    bool tracks_allocation_sizes() const noexcept override { return true; }
+
+    QUARISMA_API size_t RequestedSize(const void* ptr) const override;
+
+    QUARISMA_API size_t AllocatedSize(const void* ptr) const override;
+
+    QUARISMA_API int64_t AllocationId(const void* ptr) const override;
+
+    /**
+     * @brief Statistics summed over the nodes; peaks are the sum of the node peaks.
+     */
+    QUARISMA_API std::optional<allocator_stats> GetStats() const override;
+
+    QUARISMA_API bool ClearStats() override;
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return allocator_memory_enum::HOST_PAGEABLE;
+    }
+
+    /** Number of nodes. */
+    int num_nodes() const noexcept { return static_cast<int>(nodes_.size()); }
+
+    /**
+     * @brief Allocator of `numa_node`.
+     *
+     * Memory allocated from it may also be freed through the allocator_numa.
+     */
+    QUARISMA_API allocator_bfc* node_allocator(int numa_node) const;
+
+    /**
+     * @brief Node whose allocator owns `ptr`, or -1 if none does.
+     *
+     * **Performance**: Linear scan of the region table without locking; there
+     * are only a few regions per node as BFC regions grow geometrically
+     */
+    QUARISMA_API int NodeOf(const void* ptr) const noexcept;
+
+    /**
+     * @brief Node allocate_raw() serves for the calling thread.
+     *
+     * The node of the CPU the thread runs on, refreshed every few hundred
+     * allocations so that threads migrated by the scheduler follow their CPU;
+     * pinned threads never move. Always 0 on a single node.
+     */
+    QUARISMA_API int CurrentNode() const noexcept;
+
+private:
+    class node_sub_allocator;
+
+    // A region of a node, published to NodeOf() without a lock. Slots are
+    // rewritten under regions_mutex_ as a seqlock: `version` is odd while a
+    // write is in progress, and readers retry when it changed under them.
+    struct region
+    {
+        std::atomic<uint32_t>  version{0};
+        std::atomic<uintptr_t> begin{0};
+        std::atomic<uintptr_t> end{0};  // begin == end for a free slot
+        std::atomic<int>       node{-1};
+    };
+
+    void AddRegion(void* ptr, size_t num_bytes, int numa_node);
+    void RemoveRegion(void* ptr);
+
+    allocator_bfc* OwnerOf(const void* ptr) const;
+
+    const std::string                           name_;
+    std::vector<std::unique_ptr<allocator_bfc>> nodes_;
+
+    std::mutex                      regions_mutex_;
+    std::array<region, kMaxRegions> regions_;
+    std::atomic<size_t>             num_region_slots_{0};  // Slots ever used
+
+    allocator_numa(const allocator_numa&)            = delete;
+    allocator_numa& operator=(const allocator_numa&) = delete;
+};
+
+}  // namespace quarisma
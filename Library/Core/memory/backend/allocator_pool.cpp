@@ -71,10 +71,23 @@ allocator_pool::allocator_pool(
     {
         QUARISMA_CHECK(pool_size_limit > 0, "size limit must be > 0 if auto_resize is true.");
     }
+    if (has_size_limit_)
+    {
+        pressure_id_ = memory_pressure::instance().register_cache(
+            name_,
+            memory_trim_cost::LOW,
+            device_enum::CPU,
+            -1,
+            [this](size_t bytes_wanted) { return Release(bytes_wanted); });
+    }
 }
 
 allocator_pool::~allocator_pool()
 {
+    if (pressure_id_ != 0)
+    {
+        memory_pressure::instance().unregister_cache(pressure_id_);
+    }
     Clear();
 }
 
@@ -176,6 +189,11 @@ void* allocator_pool::allocate_raw(size_t alignment, size_t num_bytes)
 
     size_t bytes_received;
     void*  ptr = allocator_->Alloc(kPoolAlignment, num_bytes, &bytes_received);
+    if (ptr == nullptr && memory_pressure::instance().relieve(device_enum::CPU, -1, num_bytes) > 0)
+    {
+        // Idle caches, this pool's included, gave memory back
+        ptr = allocator_->Alloc(kPoolAlignment, num_bytes, &bytes_received);
+    }
     return PrepareChunk(ptr, alignment, bytes_received);
 }
 
@@ -278,7 +296,18 @@ void allocator_pool::AddToList(PtrRecord* pr)
     lru_head_ = pr;
 }
 
-void allocator_pool::EvictOne()
+size_t allocator_pool::Release(size_t bytes_wanted)
+{
+    std::scoped_lock const lock(mutex_);
+    size_t                 released = 0;
+    while (lru_tail_ != nullptr && released < bytes_wanted)
+    {
+        released += FreeLeastRecentlyUsed();
+    }
+    return released;
+}
+
+size_t allocator_pool::FreeLeastRecentlyUsed()
 {
     QUARISMA_CHECK(lru_tail_ != nullptr);
     PtrRecord* prec = lru_tail_;
@@ -289,8 +318,15 @@ void allocator_pool::EvictOne()
     });
     QUARISMA_CHECK(iter != range.second);
     pool_.erase(iter);
-    allocator_->Free(prec->ptr, prec->num_bytes);
+    const size_t num_bytes = prec->num_bytes;
+    allocator_->Free(prec->ptr, num_bytes);
     delete prec;
+    return num_bytes;
+}
+
+void allocator_pool::EvictOne()
+{
+    FreeLeastRecentlyUsed();
     ++evicted_count_;
     // Auto-resizing, and warning messages.
     static const double kTolerable      = 2e-3;
@@ -41,6 +41,7 @@
 #endif
 
 #include "memory/cpu/allocator.h"
+#include "memory/helper/memory_pressure.h"
 
 namespace quarisma
 {
@@ -346,6 +347,20 @@ public:
      */
     QUARISMA_API void Clear();
 
+    /**
+     * @brief Frees cached buffers, least recently used first.
+     *
+     * @param bytes_wanted Stop once at least this many bytes were freed
+     * @return Bytes returned to the backend allocator
+     *
+     * Unlike Clear(), the counters are kept, and the buffers freed here do not
+     * count as evictions for auto-resize. Pools with a size limit register this
+     * with memory_pressure at memory_trim_cost::LOW.
+     *
+     * **Thread Safety**: Thread-safe with internal synchronization
+     */
+    QUARISMA_API size_t Release(size_t bytes_wanted);
+
     // The following accessors permit monitoring the effectiveness of
     // the pool at avoiding repeated malloc/frees on the underlying
     // allocator.  Read locks are not taken on the theory that value
@@ -385,6 +400,9 @@ private:
     // Delete the least recently used record.
     void EvictOne() QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+    // Free the least recently used buffer and return its size.
+    size_t FreeLeastRecentlyUsed() QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
     const std::string                             name_;
     const bool                                    has_size_limit_;
     const bool                                    auto_resize_;
@@ -399,6 +417,7 @@ private:
     int64_t put_count_                            QUARISMA_GUARDED_BY(mutex_) = 0;
     int64_t allocated_count_                      QUARISMA_GUARDED_BY(mutex_) = 0;
     int64_t evicted_count_                        QUARISMA_GUARDED_BY(mutex_) = 0;
+    memory_pressure::cache_id                     pressure_id_ = 0;
 };
 
 // Do-nothing rounder. Passes through sizes unchanged.
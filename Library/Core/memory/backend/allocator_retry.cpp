@@ -35,6 +35,7 @@
 #include <optional>
 
 #include "common/macros.h"
+#include "memory/helper/memory_pressure.h"
 
 namespace quarisma
 {
@@ -150,33 +151,98 @@ void* allocator_retry::allocate_raw(
     using Clock         = std::chrono::steady_clock;
     const auto deadline = Clock::now() + std::chrono::milliseconds(max_millis_to_wait);
 
-    void* ptr = nullptr;  //NOLINT
+    void* ptr = alloc_func(alignment, num_bytes, /*verbose_failure=*/false);  //NOLINT
+    if (ptr != nullptr)
+    {
+        return ptr;
+    }
+
+    // Have the idle caches of the process give memory back before waiting
+    if (memory_pressure::instance().relieve(device_enum::CPU, -1, num_bytes) > 0)
+    {
+        ptr = alloc_func(alignment, num_bytes, /*verbose_failure=*/false);
+        if (ptr != nullptr)
+        {
+            return ptr;
+        }
+    }
+
+    // Queued before the next attempt, so that a block freed while it runs
+    // signals this waiter instead of being missed
+    tracker.enable();
+    auto const start = Clock::now();
+    waiter     self(num_bytes);
+    std::list<waiter*>::iterator position;
+    {
+        std::scoped_lock const lock(mu_);
+        position = waiters_.insert(waiters_.end(), &self);
+    }
 
     while (ptr == nullptr)
     {
-        // Try allocation without holding the lock
         ptr = alloc_func(alignment, num_bytes, /*verbose_failure=*/false);
+        if (ptr != nullptr)
+        {
+            break;
+        }
 
-        if (ptr == nullptr)
+        std::unique_lock<std::mutex> lock(mu_);
+        if (!self.cv.wait_until(lock, deadline, [&self]() { return self.signalled; }))
         {
-            auto now = Clock::now();
-
-            if (now < deadline)
-            {
-                tracker.enable();
-                // Wait for memory to become available
-                std::unique_lock<std::mutex> lock(mu_);
-
-                memory_returned_.wait_until(lock, deadline);
-            }
-            else
-            {
-                // Final attempt with verbose failure
-                return alloc_func(alignment, num_bytes, /*verbose_failure=*/true);
-            }
+            break;
         }
+        self.signalled = false;
+    }
+
+    auto const waited =
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    size_t bucket = 0;
+    while (bucket + 1 < kWaitBuckets && waited >= (int64_t{1} << bucket))
+    {
+        ++bucket;
+    }
+    {
+        std::scoped_lock const lock(mu_);
+        waiters_.erase(position);
+        ++stats_.waits;
+        ++stats_.wait_micros[bucket];
+        stats_.timeouts += ptr == nullptr ? 1 : 0;
     }
 
+    if (ptr == nullptr)
+    {
+        // Final attempt with verbose failure
+        ptr = alloc_func(alignment, num_bytes, /*verbose_failure=*/true);
+    }
     return ptr;
 }
+
+void allocator_retry::NotifyDealloc(size_t bytes)
+{
+    std::scoped_lock const lock(mu_);
+    for (waiter* w : waiters_)
+    {
+        if (bytes == 0)
+        {
+            break;
+        }
+        if (w->signalled || w->bytes > bytes)
+        {
+            continue;
+        }
+        w->signalled = true;
+        w->cv.notify_one();
+        ++stats_.wakeups;
+        if (bytes != kUnknownBytes)
+        {
+            bytes -= w->bytes;
+        }
+    }
+}
+
+allocator_retry::wait_stats allocator_retry::GetWaitStats() const
+{
+    std::scoped_lock const lock(mu_);
+    return stats_;
+}
 }  // namespace quarisma
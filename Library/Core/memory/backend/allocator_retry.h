@@ -28,9 +28,13 @@
 
 #pragma once
 
+#include <array>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <list>
 #include <mutex>
 
 #include "common/macros.h"
@@ -40,13 +44,32 @@ namespace quarisma
 class allocator_retry
 {
 public:
+    // Number of wait-time buckets: bucket i counts the waits shorter than
+    // 2^i microseconds, the last one the longer waits.
+    static constexpr size_t kWaitBuckets = 24;
+
+    // Passed to NotifyDealloc() when the number of bytes freed is unknown:
+    // every waiter is woken.
+    static constexpr size_t kUnknownBytes = std::numeric_limits<size_t>::max();
+
+    // Counters of the allocations that had to wait.
+    struct wait_stats
+    {
+        uint64_t                           waits    = 0;   // Allocations that waited
+        uint64_t                           timeouts = 0;   // Of which failed at the deadline
+        uint64_t                           wakeups  = 0;   // Waiters woken by NotifyDealloc()
+        std::array<uint64_t, kWaitBuckets> wait_micros{};  // Distribution of the wait times
+    };
+
     allocator_retry();
     ~allocator_retry();
 
     // Call 'alloc_func' to obtain memory.  On first call,
     // 'verbose_failure' will be false.  If return value is nullptr,
-    // then wait up to 'max_millis_to_wait' milliseconds, retrying each
-    // time a call to deallocate_raw() is detected, until either a good
+    // ask memory_pressure to trim the process's idle host caches and
+    // retry at once if that released memory; otherwise wait up to
+    // 'max_millis_to_wait' milliseconds, retrying each time NotifyDealloc()
+    // reports a block the request fits in, until either a good
     // pointer is returned or the deadline is exhausted.  If the
     // deadline is exhausted, try one more time with 'verbose_failure'
     // set to true.  The value returned is either the first good pointer
@@ -57,19 +80,30 @@ public:
         size_t alignment,
         size_t bytes);
 
-    // Called to notify clients that some memory was returned.
-    void NotifyDealloc();
+    // Called to notify clients that some memory was returned: 'bytes' is the
+    // size of the free block it is now part of. Waiters are woken in arrival
+    // order, skipping the ones whose request does not fit in the block, until
+    // the block is used up; a waiter that then still fails waits again in its
+    // place.
+    void NotifyDealloc(size_t bytes = kUnknownBytes);
+
+    // Returns the counters of the allocations that had to wait.
+    wait_stats GetWaitStats() const;
 
 private:
-    std::mutex mu_;
+    // An allocation waiting for memory, queued from its first failure on.
+    struct waiter
+    {
+        explicit waiter(size_t num_bytes) : bytes(num_bytes) {}
 
-    std::condition_variable memory_returned_ QUARISMA_GUARDED_BY(mu_);
-};
+        size_t                  bytes;
+        bool                    signalled = false;
+        std::condition_variable cv;
+    };
 
-// Implementation details below
-inline void allocator_retry::NotifyDealloc()
-{
-    std::unique_lock<std::mutex> l(mu_);
-    memory_returned_.notify_all();
-}
+    mutable std::mutex mu_;
+
+    std::list<waiter*> waiters_ QUARISMA_GUARDED_BY(mu_);
+    wait_stats         stats_ QUARISMA_GUARDED_BY(mu_);
+};
 }  // namespace quarisma
@@ -0,0 +1,408 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/backend/allocator_shm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "util/error.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/tracing/traceme.h"
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define QUARISMA_SHM_POSIX 1
+#endif
+
+namespace quarisma
+{
+namespace
+{
+constexpr int no_numa_node = -1;
+
+std::string posix_name(const std::string& name)
+{
+    QUARISMA_CHECK(!name.empty(), "a shared memory segment needs a name");
+    return name.front() == '/' ? name : "/" + name;
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+// shm_segment
+//-----------------------------------------------------------------------------
+
+shm_segment::~shm_segment()
+{
+    reset();
+}
+
+shm_segment::shm_segment(shm_segment&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      name_(std::move(other.name_)),
+      created_(std::exchange(other.created_, false))
+{
+}
+
+shm_segment& shm_segment::operator=(shm_segment&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        data_    = std::exchange(other.data_, nullptr);
+        size_    = std::exchange(other.size_, 0);
+        name_    = std::move(other.name_);
+        created_ = std::exchange(other.created_, false);
+    }
+    return *this;
+}
+
+#ifdef QUARISMA_SHM_POSIX
+namespace
+{
+void* map_shared(int fd, size_t size, const std::string& name)
+{
+    void*     data  = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int const error = errno;
+    ::close(fd);
+    QUARISMA_CHECK(data != MAP_FAILED, "failed to map {}: {}", name, utils::str_error(error));
+    return data;
+}
+}  // namespace
+
+shm_segment shm_segment::create(const std::string& name, size_t size)
+{
+    QUARISMA_CHECK(size > 0, "a shared memory segment needs at least one byte");
+    std::string const path = posix_name(name);
+
+    // A segment left behind by a process that died is replaced, not reused
+    shm_unlink(path.c_str());
+    int const fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    QUARISMA_CHECK(fd >= 0, "failed to create {}: {}", path, utils::str_error(errno));
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        int const error = errno;
+        ::close(fd);
+        shm_unlink(path.c_str());
+        QUARISMA_THROW("failed to size {} to {} bytes: {}", path, size, utils::str_error(error));
+    }
+
+    shm_segment segment;
+    segment.name_    = path;
+    segment.created_ = true;
+    try
+    {
+        segment.data_ = map_shared(fd, size, path);
+    }
+    catch (...)
+    {
+        shm_unlink(path.c_str());
+        throw;
+    }
+    segment.size_ = size;
+    return segment;
+}
+
+shm_segment shm_segment::open(const std::string& name)
+{
+    std::string const path = posix_name(name);
+    int const         fd   = shm_open(path.c_str(), O_RDWR, 0600);
+    QUARISMA_CHECK(fd >= 0, "failed to open {}: {}", path, utils::str_error(errno));
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        ::close(fd);
+        QUARISMA_THROW("{} is empty or cannot be stat'ed", path);
+    }
+
+    shm_segment segment;
+    segment.name_ = path;
+    segment.size_ = static_cast<size_t>(info.st_size);
+    segment.data_ = map_shared(fd, segment.size_, path);
+    return segment;
+}
+
+void shm_segment::unlink(const std::string& name) noexcept
+{
+    if (!name.empty())
+    {
+        shm_unlink((name.front() == '/' ? name : "/" + name).c_str());
+    }
+}
+
+void shm_segment::reset() noexcept
+{
+    if (data_ != nullptr)
+    {
+        munmap(data_, size_);
+    }
+    if (created_)
+    {
+        shm_unlink(name_.c_str());
+    }
+    data_    = nullptr;
+    size_    = 0;
+    created_ = false;
+    name_.clear();
+}
+#else
+shm_segment shm_segment::create(const std::string& name, size_t /*size*/)
+{
+    QUARISMA_THROW("shared memory segments are not available on this platform: {}", name);
+}
+
+shm_segment shm_segment::open(const std::string& name)
+{
+    QUARISMA_THROW("shared memory segments are not available on this platform: {}", name);
+}
+
+void shm_segment::unlink(const std::string& /*name*/) noexcept {}
+
+void shm_segment::reset() noexcept
+{
+    data_    = nullptr;
+    size_    = 0;
+    created_ = false;
+    name_.clear();
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// shm_arena_allocator
+//-----------------------------------------------------------------------------
+
+namespace
+{
+constexpr uint64_t arena_magic     = 0x314e455241534d51ULL;  // "QMSAREN1"
+constexpr uint32_t arena_version   = 1;
+constexpr size_t   min_class_shift = 6;
+constexpr size_t   min_class_bytes = size_t{1} << min_class_shift;
+constexpr size_t   max_alignment   = 4096;
+constexpr int      class_count     = 34;  // 64 bytes to 512 GiB
+
+// Free list heads: the offset in units of 64 bytes below, a counter against ABA above
+constexpr int      offset_bits = 40;
+constexpr uint64_t offset_mask = (uint64_t{1} << offset_bits) - 1;
+
+int class_of(size_t bytes) noexcept
+{
+    int    k     = 0;
+    size_t limit = min_class_bytes;
+    while (limit < bytes && k < class_count)
+    {
+        limit <<= 1;
+        ++k;
+    }
+    return k;
+}
+
+size_t align_up(size_t value, size_t alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+// Lives at the start of the segment; every field is shared by the processes
+struct shm_arena_allocator::header
+{
+    std::atomic<uint64_t> magic;
+    uint32_t              version;
+    uint32_t              reserved;
+    uint64_t              size;
+    std::atomic<uint64_t> untouched;
+    std::atomic<uint64_t> in_use;
+    std::atomic<uint64_t> free_heads[class_count];
+};
+
+static_assert(
+    std::atomic<uint64_t>::is_always_lock_free,
+    "the arena needs address-free 64-bit atomics to be shared across processes");
+
+shm_arena_allocator::shm_arena_allocator(
+    const std::vector<Visitor>& alloc_visitors,
+    const std::vector<Visitor>& free_visitors,
+    const Options&              opts)
+    : shm_arena_allocator(
+          alloc_visitors,
+          free_visitors,
+          opts.size > 0 ? shm_segment::create(opts.name, opts.size) : shm_segment::open(opts.name))
+{
+}
+
+shm_arena_allocator::shm_arena_allocator(
+    const std::vector<Visitor>& alloc_visitors,
+    const std::vector<Visitor>& free_visitors,
+    shm_segment                 segment)
+    : sub_allocator(alloc_visitors, free_visitors), segment_(std::move(segment))
+{
+    QUARISMA_CHECK(
+        segment_.size() > align_up(sizeof(header), max_alignment),
+        "{} is too small for an arena",
+        segment_.name());
+
+    if (segment_.created())
+    {
+        auto* shared    = new (segment_.data()) header;
+        shared->version = arena_version;
+        shared->size    = segment_.size();
+        shared->untouched.store(align_up(sizeof(header), max_alignment), std::memory_order_relaxed);
+        shared->in_use.store(0, std::memory_order_relaxed);
+        for (auto& head : shared->free_heads)
+        {
+            head.store(0, std::memory_order_relaxed);
+        }
+        // Published last, so that a process opening the arena sees it whole
+        shared->magic.store(arena_magic, std::memory_order_release);
+        return;
+    }
+
+    header const* shared = state();
+    QUARISMA_CHECK(
+        shared->magic.load(std::memory_order_acquire) == arena_magic &&
+            shared->version == arena_version && shared->size == segment_.size(),
+        "{} is not a shared memory arena",
+        segment_.name());
+}
+
+shm_arena_allocator::~shm_arena_allocator() = default;
+
+shm_arena_allocator::header* shm_arena_allocator::state() const noexcept
+{
+    return static_cast<header*>(segment_.data());
+}
+
+void* shm_arena_allocator::Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received)
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    quarisma::traceme const traceme("shm_arena_allocator::Alloc");
+#endif
+
+    *bytes_received = num_bytes;
+    if (num_bytes == 0 || alignment > max_alignment)
+    {
+        return nullptr;
+    }
+    int const k = class_of(std::max({num_bytes, alignment, min_class_bytes}));
+    if (k >= class_count)
+    {
+        return nullptr;
+    }
+    size_t const bytes = min_class_bytes << k;
+
+    header*                shared = state();
+    std::atomic<uint64_t>& head   = shared->free_heads[k];
+    uint64_t               offset = 0;
+
+    uint64_t top = head.load(std::memory_order_acquire);
+    while ((top & offset_mask) != 0)
+    {
+        uint64_t const candidate = (top & offset_mask) << min_class_shift;
+        // May read a region another process just took: the counter then fails the exchange
+        uint64_t const next =
+            reinterpret_cast<std::atomic<uint64_t>*>(base() + candidate)->load(
+                std::memory_order_relaxed);
+        uint64_t const replacement =
+            ((top >> offset_bits) + 1) << offset_bits | (next & offset_mask);
+        if (head.compare_exchange_weak(
+                top, replacement, std::memory_order_acquire, std::memory_order_acquire))
+        {
+            offset = candidate;
+            break;
+        }
+    }
+
+    if (offset == 0)
+    {
+        size_t const placement = std::min(bytes, max_alignment);
+        uint64_t     current   = shared->untouched.load(std::memory_order_relaxed);
+        do
+        {
+            offset = align_up(current, placement);
+            if (offset + bytes > shared->size)
+            {
+                return nullptr;
+            }
+        } while (!shared->untouched.compare_exchange_weak(
+            current, offset + bytes, std::memory_order_relaxed));
+    }
+
+    shared->in_use.fetch_add(bytes, std::memory_order_relaxed);
+    void* ptr       = base() + offset;
+    *bytes_received = bytes;
+    VisitAlloc(ptr, no_numa_node, bytes);
+    return ptr;
+}
+
+void shm_arena_allocator::Free(void* ptr, size_t num_bytes)
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    quarisma::traceme const traceme("shm_arena_allocator::Free");
+#endif
+
+    if (ptr == nullptr || num_bytes == 0)
+    {
+        return;
+    }
+    QUARISMA_CHECK_DEBUG(contains(ptr), "the region is not in {}", segment_.name());
+
+    int const      k      = class_of(std::max(num_bytes, min_class_bytes));
+    size_t const   bytes  = min_class_bytes << k;
+    uint64_t const offset = offset_of(ptr);
+    VisitFree(ptr, no_numa_node, bytes);
+
+    header*                shared = state();
+    std::atomic<uint64_t>& head   = shared->free_heads[k];
+    auto*                  link   = reinterpret_cast<std::atomic<uint64_t>*>(ptr);
+
+    uint64_t top = head.load(std::memory_order_relaxed);
+    uint64_t replacement;
+    do
+    {
+        link->store(top & offset_mask, std::memory_order_relaxed);
+        replacement = ((top >> offset_bits) + 1) << offset_bits | (offset >> min_class_shift);
+    } while (!head.compare_exchange_weak(
+        top, replacement, std::memory_order_release, std::memory_order_relaxed));
+
+    shared->in_use.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+size_t shm_arena_allocator::bytes_in_use() const noexcept
+{
+    return static_cast<size_t>(state()->in_use.load(std::memory_order_relaxed));
+}
+
+size_t shm_arena_allocator::bytes_untouched() const noexcept
+{
+    header const* shared = state();
+    return static_cast<size_t>(shared->size - shared->untouched.load(std::memory_order_relaxed));
+}
+
+}  // namespace quarisma
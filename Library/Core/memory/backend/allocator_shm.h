@@ -0,0 +1,211 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "memory/sub_allocator.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief A named POSIX shared memory object (shm_open), mapped read-write.
+ *
+ * Every process mapping the same name sees the same bytes, at a different
+ * address in each, so structures inside a segment must refer to each other
+ * by offset. The creator unlinks the name when it is destroyed; processes
+ * that opened it keep their mapping until they close it.
+ */
+class QUARISMA_VISIBILITY shm_segment
+{
+public:
+    shm_segment() noexcept = default;
+    QUARISMA_API ~shm_segment();
+
+    QUARISMA_API shm_segment(shm_segment&& other) noexcept;
+    QUARISMA_API shm_segment& operator=(shm_segment&& other) noexcept;
+
+    /**
+     * @brief Creates the segment `name` of `size` zeroed bytes, replacing any stale one.
+     *
+     * A leading '/' is added to the name when missing.
+     * @throws quarisma::Error when it cannot be created or mapped
+     */
+    QUARISMA_API static shm_segment create(const std::string& name, size_t size);
+
+    /**
+     * @brief Maps the existing segment `name`.
+     * @throws quarisma::Error when it does not exist or cannot be mapped
+     */
+    QUARISMA_API static shm_segment open(const std::string& name);
+
+    /** @brief Removes the name; mappings stay valid until closed. */
+    QUARISMA_API static void unlink(const std::string& name) noexcept;
+
+    void*              data() const noexcept { return data_; }
+    size_t             size() const noexcept { return size_; }
+    const std::string& name() const noexcept { return name_; }
+
+    /** @brief Whether this segment created the name, and unlinks it when destroyed. */
+    bool created() const noexcept { return created_; }
+
+    /** @brief Unmaps the segment, unlinking the name when created(). */
+    QUARISMA_API void reset() noexcept;
+
+private:
+    void*       data_    = nullptr;
+    size_t      size_    = 0;
+    std::string name_;
+    bool        created_ = false;
+
+    shm_segment(const shm_segment&)    = delete;
+    void operator=(const shm_segment&) = delete;
+};
+
+/**
+ * @brief sub_allocator carving regions out of a shared memory segment.
+ *
+ * The allocator's state lives in the segment itself, so several processes
+ * can allocate and free regions of the same arena: a region written by a
+ * producer is handed to a consumer by its offset() and freed by whichever
+ * process is done with it.
+ *
+ * **Design**: regions are rounded up to a power of two of at least 64
+ * bytes. Each size class keeps a lock-free list of freed regions, with a
+ * tagged head against ABA; when a list is empty a region is carved off the
+ * untouched end of the segment with one atomic add. Regions are never
+ * coalesced or returned to the untouched end, which suits the fixed mix of
+ * message sizes of a transport. Alignments up to 4096 bytes are honoured.
+ *
+ * **Freeing**: Free() takes the bytes requested or the bytes received;
+ * both round to the same class as long as the alignment asked for was at
+ * most the size.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * // Producer process
+ * shm_arena_allocator arena({}, {}, {"/pricing_results", size_t{1} << 30});
+ * size_t received;
+ * void* payload = arena.Alloc(64, bytes, &received);
+ * send_offset(arena.offset_of(payload), bytes);
+ *
+ * // Consumer process
+ * shm_arena_allocator arena({}, {}, {"/pricing_results"});
+ * consume(arena.pointer_at(offset), bytes);
+ * arena.Free(arena.pointer_at(offset), bytes);
+ * ```
+ *
+ * **Thread Safety**: Fully thread-safe across threads and processes
+ */
+class QUARISMA_VISIBILITY shm_arena_allocator : public sub_allocator
+{
+public:
+    /**
+     * @brief Configuration options for shm_arena_allocator.
+     */
+    struct Options
+    {
+        /**
+         * @brief Name of the shared memory segment.
+         */
+        std::string name;
+
+        /**
+         * @brief Bytes of the segment to create, or 0 to open an existing arena.
+         *
+         * **Default**: 0
+         */
+        size_t size = 0;
+    };
+
+    /**
+     * @brief Creates or opens the arena named by `opts`.
+     *
+     * @param alloc_visitors Functions called on each allocation
+     * @param free_visitors Functions called on each deallocation
+     * @param opts Segment name and, when creating it, size
+     * @throws quarisma::Error when the segment cannot be mapped or is not an arena
+     */
+    QUARISMA_API shm_arena_allocator(
+        const std::vector<Visitor>& alloc_visitors,
+        const std::vector<Visitor>& free_visitors,
+        const Options&              opts);
+
+    /** @brief Arena over a segment the caller mapped, initializing it when created(). */
+    QUARISMA_API shm_arena_allocator(
+        const std::vector<Visitor>& alloc_visitors,
+        const std::vector<Visitor>& free_visitors,
+        shm_segment                 segment);
+
+    QUARISMA_API ~shm_arena_allocator() override;
+
+    QUARISMA_API void* Alloc(size_t alignment, size_t num_bytes, size_t* bytes_received) override;
+
+    QUARISMA_API void Free(void* ptr, size_t num_bytes) override;
+
+    bool SupportsCoalescing() const override { return false; }
+
+    allocator_memory_enum GetMemoryType() const noexcept override
+    {
+        return allocator_memory_enum::HOST_PAGEABLE;
+    }
+
+    /** @brief Offset of `ptr` in the segment, the same in every process. */
+    uint64_t offset_of(const void* ptr) const noexcept
+    {
+        return static_cast<uint64_t>(static_cast<const char*>(ptr) - base());
+    }
+
+    /** @brief Address in this process of the region at `offset`. */
+    void* pointer_at(uint64_t offset) const noexcept { return base() + offset; }
+
+    /** @brief Whether `ptr` lies in the segment. */
+    bool contains(const void* ptr) const noexcept
+    {
+        auto const* p = static_cast<const char*>(ptr);
+        return p >= base() && p < base() + segment_.size();
+    }
+
+    /** @brief Bytes of regions currently allocated, across all processes. */
+    QUARISMA_API size_t bytes_in_use() const noexcept;
+
+    /** @brief Bytes that can still be carved, besides the freed regions. */
+    QUARISMA_API size_t bytes_untouched() const noexcept;
+
+    const shm_segment& segment() const noexcept { return segment_; }
+
+private:
+    struct header;
+
+    char*   base() const noexcept { return static_cast<char*>(segment_.data()); }
+    header* state() const noexcept;
+
+    shm_segment segment_;
+
+    shm_arena_allocator(const shm_arena_allocator&) = delete;
+    void operator=(const shm_arena_allocator&)      = delete;
+};
+
+}  // namespace quarisma
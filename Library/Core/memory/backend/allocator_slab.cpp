@@ -0,0 +1,494 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/backend/allocator_slab.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "logging/logger.h"
+#include "memory/sub_allocator.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+constexpr size_t kMinSlabSize   = 4 << 10;
+constexpr size_t kMaxSlabSize   = 1 << 20;
+constexpr size_t kMinObjectSize = 16;
+
+constexpr std::array<size_t, allocator_slab::kNumSizeClasses> kClassBytes = {
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256};
+
+// Size class of a request of (n + 15) / 16 16-byte units, for n <= kMaxObjectSize
+constexpr std::array<int8_t, (allocator_slab::kMaxObjectSize / kMinObjectSize) + 1>
+    kClassOfUnits = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 8, 9, 9, 10, 10, 11, 11};
+
+constexpr size_t round_up(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Alignment every object of `bytes` gets when objects start on a 64-byte boundary
+constexpr size_t natural_alignment(size_t bytes)
+{
+    return std::min(bytes & (~bytes + 1), allocator_slab::kMaxObjectAlignment);
+}
+
+uint32_t lowest_set_bit(uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+    uint32_t bit = 0;
+    while ((word & 1) == 0)
+    {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+void update_max(std::atomic<int64_t>& target, int64_t value) noexcept
+{
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+}  // namespace
+
+// Lives at the start of every slab. A forwarded (large) allocation has one too,
+// with size_class == -1, so that deallocate_raw() can mask any pointer it gets.
+struct allocator_slab::SlabHeader
+{
+    SlabHeader* prev;
+    SlabHeader* next;
+    size_t      bytes;        // Bytes received from the sub_allocator
+    int         size_class;   // -1 for a forwarded allocation
+    uint32_t    object_size;  // Object size, 0 for a forwarded allocation
+    uint32_t    capacity;     // Objects in the slab
+    uint32_t    free_count;   // Free objects in the slab
+    uint32_t    first_word;   // No free object below this bitmap word
+
+    // Bitmap of free objects (bit set = free), stored right after the header.
+    uint64_t* free_bits() noexcept { return reinterpret_cast<uint64_t*>(this + 1); }
+};
+
+namespace
+{
+template <typename Slab>
+void push_front(Slab*& head, Slab* slab)
+{
+    slab->prev = nullptr;
+    slab->next = head;
+    if (head != nullptr)
+    {
+        head->prev = slab;
+    }
+    head = slab;
+}
+
+template <typename Slab>
+void unlink(Slab*& head, Slab* slab)
+{
+    if (slab->prev != nullptr)
+    {
+        slab->prev->next = slab->next;
+    }
+    else
+    {
+        head = slab->next;
+    }
+    if (slab->next != nullptr)
+    {
+        slab->next->prev = slab->prev;
+    }
+}
+}  // namespace
+
+allocator_slab::allocator_slab(
+    std::unique_ptr<quarisma::sub_allocator> sub_allocator,
+    std::string                              name,
+    const Options&                           opts)
+    : name_(std::move(name)),
+      opts_(opts),
+      objects_offset_(round_up(
+          sizeof(SlabHeader) + round_up(opts.slab_size / kMinObjectSize, 64) / 8,
+          kMaxObjectAlignment)),
+      sub_allocator_(std::move(sub_allocator))
+{
+    QUARISMA_CHECK(sub_allocator_ != nullptr, "allocator_slab needs a sub_allocator");
+    QUARISMA_CHECK(
+        opts_.slab_size >= kMinSlabSize && opts_.slab_size <= kMaxSlabSize &&
+            (opts_.slab_size & (opts_.slab_size - 1)) == 0,
+        "allocator_slab slab_size must be a power of two in [{}, {}], got {}",
+        kMinSlabSize,
+        kMaxSlabSize,
+        opts_.slab_size);
+}
+
+allocator_slab::~allocator_slab()
+{
+    int64_t leaked = 0;
+    for (auto& state : classes_)
+    {
+        std::scoped_lock const lock(state.mutex);
+        for (SlabHeader** list : {&state.partial, &state.full})
+        {
+            while (*list != nullptr)
+            {
+                SlabHeader* slab = *list;
+                unlink(*list, slab);
+                leaked += slab->capacity - slab->free_count;
+                FreeSlab(slab);
+            }
+        }
+        state.empty_slabs = 0;
+    }
+    if (leaked > 0)
+    {
+        QUARISMA_LOG_ERROR("allocator_slab {} destroyed with {} objects in use", name_, leaked);
+    }
+}
+
+int allocator_slab::SizeClass(size_t alignment, size_t num_bytes) noexcept
+{
+    if (num_bytes > kMaxObjectSize || alignment > kMaxObjectAlignment)
+    {
+        return -1;
+    }
+    int size_class = kClassOfUnits[(num_bytes + kMinObjectSize - 1) / kMinObjectSize];
+    // Objects are only aligned as much as their size allows
+    while (size_class < kNumSizeClasses && natural_alignment(kClassBytes[size_class]) < alignment)
+    {
+        ++size_class;
+    }
+    return size_class < kNumSizeClasses ? size_class : -1;
+}
+
+size_t allocator_slab::SizeClassBytes(int size_class) noexcept
+{
+    return size_class >= 0 && size_class < kNumSizeClasses ? kClassBytes[size_class] : 0;
+}
+
+void* allocator_slab::allocate_raw(size_t alignment, size_t num_bytes)
+{
+    if (num_bytes == 0)
+    {
+        QUARISMA_LOG_WARNING("tried to allocate 0 bytes");
+        return nullptr;
+    }
+
+    const int size_class = SizeClass(alignment, num_bytes);
+    if (size_class < 0)
+    {
+        return AllocateLarge(alignment, num_bytes);
+    }
+
+    ClassState& state = classes_[size_class];
+    SlabHeader* slab  = nullptr;
+    uint32_t    index = 0;
+    {
+        std::scoped_lock const lock(state.mutex);
+        slab = state.partial != nullptr ? state.partial : NewSlab(size_class, state);
+        if (slab == nullptr)
+        {
+            return nullptr;
+        }
+
+        uint64_t* bits = slab->free_bits();
+        uint32_t  word = slab->first_word;
+        while (bits[word] == 0)
+        {
+            ++word;
+        }
+        const uint32_t bit = lowest_set_bit(bits[word]);
+        bits[word] &= bits[word] - 1;
+        slab->first_word = word;
+        index            = word * 64 + bit;
+
+        if (slab->free_count-- == slab->capacity)
+        {
+            --state.empty_slabs;
+        }
+        if (slab->free_count == 0)
+        {
+            unlink(state.partial, slab);
+            push_front(state.full, slab);
+        }
+
+        ++state.num_allocs;
+        state.bytes_in_use += slab->object_size;
+        state.peak_bytes_in_use = std::max(state.peak_bytes_in_use, state.bytes_in_use);
+    }
+
+    return reinterpret_cast<char*>(slab) + objects_offset_ +
+           static_cast<size_t>(index) * slab->object_size;
+}
+
+void allocator_slab::deallocate_raw(void* ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    SlabHeader* slab = SlabOf(ptr);
+    if (slab->size_class < 0)
+    {
+        stats_.bytes_in_use.fetch_sub(
+            static_cast<int64_t>(slab->bytes), std::memory_order_relaxed);
+        stats_.num_deallocs.fetch_add(1, std::memory_order_relaxed);
+        FreeSlab(slab);
+        return;
+    }
+
+    // Read before unlocking: once the bit is set the slab may be released by another thread
+    const size_t object_size = slab->object_size;
+    const size_t offset =
+        static_cast<size_t>(static_cast<char*>(ptr) - reinterpret_cast<char*>(slab)) -
+        objects_offset_;
+    const auto index = static_cast<uint32_t>(offset / object_size);
+    QUARISMA_CHECK(
+        offset % object_size == 0 && index < slab->capacity,
+        "allocator_slab {}: {} is not an object of this allocator",
+        name_,
+        ptr);
+
+    const uint32_t word     = index / 64;
+    const uint64_t mask     = uint64_t{1} << (index % 64);
+    ClassState&    state    = classes_[slab->size_class];
+    SlabHeader*    released = nullptr;
+    {
+        std::scoped_lock const lock(state.mutex);
+        uint64_t*              bits = slab->free_bits();
+        QUARISMA_CHECK(
+            (bits[word] & mask) == 0, "allocator_slab {}: double free of {}", name_, ptr);
+        bits[word] |= mask;
+        slab->first_word = std::min(slab->first_word, word);
+
+        if (slab->free_count++ == 0)
+        {
+            unlink(state.full, slab);
+            push_front(state.partial, slab);
+        }
+        if (slab->free_count == slab->capacity &&
+            ++state.empty_slabs > opts_.empty_slabs_to_keep)
+        {
+            --state.empty_slabs;
+            unlink(state.partial, slab);
+            released = slab;
+        }
+
+        ++state.num_deallocs;
+        state.bytes_in_use -= static_cast<int64_t>(object_size);
+    }
+
+    if (released != nullptr)
+    {
+        FreeSlab(released);
+    }
+}
+
+size_t allocator_slab::AllocatedSizeSlow(const void* ptr) const
+{
+    const SlabHeader* slab = SlabOf(ptr);
+    if (slab->size_class < 0)
+    {
+        return slab->bytes - static_cast<size_t>(
+                                 static_cast<const char*>(ptr) -
+                                 reinterpret_cast<const char*>(slab));
+    }
+    return slab->object_size;
+}
+
+std::optional<allocator_stats> allocator_slab::GetStats() const
+{
+    // stats_ counts forwarded allocations, the size classes count their objects
+    allocator_stats stats_copy(stats_);
+    for (int size_class = 0; size_class < kNumSizeClasses; ++size_class)
+    {
+        const ClassState&      state = classes_[size_class];
+        std::scoped_lock const lock(state.mutex);
+        stats_copy.num_allocs += state.num_allocs;
+        stats_copy.num_deallocs += state.num_deallocs;
+        stats_copy.bytes_in_use += state.bytes_in_use;
+        stats_copy.peak_bytes_in_use += state.peak_bytes_in_use;
+        if (state.num_allocs > 0)
+        {
+            update_max(
+                stats_copy.largest_alloc_size, static_cast<int64_t>(kClassBytes[size_class]));
+        }
+    }
+    return stats_copy;
+}
+
+bool allocator_slab::ClearStats()
+{
+    for (auto& state : classes_)
+    {
+        std::scoped_lock const lock(state.mutex);
+        state.num_allocs        = 0;
+        state.num_deallocs      = 0;
+        state.peak_bytes_in_use = state.bytes_in_use;
+    }
+    stats_.num_allocs.store(0, std::memory_order_relaxed);
+    stats_.num_deallocs.store(0, std::memory_order_relaxed);
+    stats_.peak_bytes_in_use.store(
+        stats_.bytes_in_use.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    stats_.peak_bytes_reserved.store(
+        stats_.bytes_reserved.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    stats_.largest_alloc_size.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+size_t allocator_slab::ReleaseEmptySlabs()
+{
+    size_t released = 0;
+    for (auto& state : classes_)
+    {
+        std::vector<SlabHeader*> empty;
+        {
+            std::scoped_lock const lock(state.mutex);
+            for (SlabHeader* slab = state.partial; slab != nullptr && state.empty_slabs > 0;)
+            {
+                SlabHeader* next = slab->next;
+                if (slab->free_count == slab->capacity)
+                {
+                    unlink(state.partial, slab);
+                    --state.empty_slabs;
+                    empty.push_back(slab);
+                }
+                slab = next;
+            }
+        }
+        for (SlabHeader* slab : empty)
+        {
+            FreeSlab(slab);
+        }
+        released += empty.size();
+    }
+    return released;
+}
+
+allocator_slab::SlabHeader* allocator_slab::NewSlab(int size_class, ClassState& state)
+{
+    size_t bytes_received = 0;
+    void*  memory = sub_allocator_->Alloc(opts_.slab_size, opts_.slab_size, &bytes_received);
+    if (memory == nullptr)
+    {
+        stats_.failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto* slab        = static_cast<SlabHeader*>(memory);
+    slab->bytes       = bytes_received;
+    slab->size_class  = size_class;
+    slab->object_size = static_cast<uint32_t>(kClassBytes[size_class]);
+    slab->capacity =
+        static_cast<uint32_t>((opts_.slab_size - objects_offset_) / slab->object_size);
+    slab->free_count  = slab->capacity;
+    slab->first_word  = 0;
+
+    uint64_t*      bits  = slab->free_bits();
+    const uint32_t words = (slab->capacity + 63) / 64;
+    std::fill(bits, bits + words, ~uint64_t{0});
+    if (slab->capacity % 64 != 0)
+    {
+        bits[words - 1] = (uint64_t{1} << (slab->capacity % 64)) - 1;
+    }
+
+    push_front(state.partial, slab);
+    ++state.empty_slabs;
+
+    const int64_t reserved =
+        stats_.bytes_reserved.fetch_add(
+            static_cast<int64_t>(bytes_received), std::memory_order_relaxed) +
+        static_cast<int64_t>(bytes_received);
+    update_max(stats_.peak_bytes_reserved, reserved);
+    return slab;
+}
+
+void allocator_slab::FreeSlab(SlabHeader* slab)
+{
+    stats_.bytes_reserved.fetch_sub(static_cast<int64_t>(slab->bytes), std::memory_order_relaxed);
+    sub_allocator_->Free(slab, slab->bytes);
+}
+
+allocator_slab::SlabHeader* allocator_slab::SlabOf(const void* ptr) const noexcept
+{
+    return reinterpret_cast<SlabHeader*>(
+        reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(opts_.slab_size - 1));
+}
+
+void* allocator_slab::AllocateLarge(size_t alignment, size_t num_bytes)
+{
+    // The header sits in front of the object, in the same slab-aligned block
+    const size_t offset = std::max(round_up(sizeof(SlabHeader), kMaxObjectAlignment), alignment);
+    QUARISMA_CHECK(
+        offset < opts_.slab_size,
+        "allocator_slab {}: alignment {} exceeds the slab size {}",
+        name_,
+        alignment,
+        opts_.slab_size);
+
+    size_t bytes_received = 0;
+    void*  memory = sub_allocator_->Alloc(opts_.slab_size, offset + num_bytes, &bytes_received);
+    if (memory == nullptr)
+    {
+        stats_.failed_allocations.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto* header        = static_cast<SlabHeader*>(memory);
+    header->prev        = nullptr;
+    header->next        = nullptr;
+    header->bytes       = bytes_received;
+    header->size_class  = -1;
+    header->object_size = 0;
+    header->capacity    = 0;
+    header->free_count  = 0;
+    header->first_word  = 0;
+
+    const int64_t reserved =
+        stats_.bytes_reserved.fetch_add(
+            static_cast<int64_t>(bytes_received), std::memory_order_relaxed) +
+        static_cast<int64_t>(bytes_received);
+    update_max(stats_.peak_bytes_reserved, reserved);
+    RecordAllocation(bytes_received);
+    return static_cast<char*>(memory) + offset;
+}
+
+void allocator_slab::RecordAllocation(size_t bytes) noexcept
+{
+    const auto    size   = static_cast<int64_t>(bytes);
+    const int64_t in_use = stats_.bytes_in_use.fetch_add(size, std::memory_order_relaxed) + size;
+    stats_.num_allocs.fetch_add(1, std::memory_order_relaxed);
+    update_max(stats_.peak_bytes_in_use, in_use);
+    update_max(stats_.largest_alloc_size, size);
+}
+}  // namespace quarisma
@@ -31,16 +31,19 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
 #include <ios>
 #include <iterator>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -52,6 +55,184 @@
 
 namespace quarisma
 {
+namespace
+{
+// Keys of the live sample table besides pointers.
+constexpr uintptr_t kFreeKey     = 0;
+constexpr uintptr_t kReservedKey = 1;
+
+// Sequence number of a sample buffer record being written.
+constexpr uint64_t kWritingRecord = ~uint64_t{0};
+
+constexpr size_t kLiveBucketSlots = 8;
+
+uint64_t current_thread_hash()
+{
+    return std::hash<std::thread::id>{}(std::this_thread::get_id());
+}
+
+uint64_t next_tracker_instance_id()
+{
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+size_t live_bucket_of(uintptr_t key, size_t mask)
+{
+    return static_cast<size_t>(((key >> 4) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+// Counters of sample buffers have a single writer, so they are updated
+// without read-modify-write instructions.
+void bump(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void update_max(std::atomic<int64_t>& maximum, int64_t value)
+{
+    int64_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current &&
+           !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t latency_ns(
+    std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return static_cast<uint64_t>(std::max<int64_t>(
+        0, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+}
+
+void record_duration(
+    std::atomic<uint64_t>& count,
+    std::atomic<uint64_t>& total_us,
+    std::atomic<uint64_t>& min_us,
+    std::atomic<uint64_t>& max_us,
+    uint64_t               duration_us)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    total_us.fetch_add(duration_us, std::memory_order_relaxed);
+    uint64_t current = min_us.load(std::memory_order_relaxed);
+    while (duration_us < current &&
+           !min_us.compare_exchange_weak(current, duration_us, std::memory_order_relaxed))
+    {
+    }
+    current = max_us.load(std::memory_order_relaxed);
+    while (duration_us > current &&
+           !max_us.compare_exchange_weak(current, duration_us, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Bytes allocated until the next sample: exponentially distributed with mean
+// `interval`, so that samples form a Poisson process over the allocated bytes.
+int64_t draw_countdown(uint64_t& state, size_t interval)
+{
+    // xorshift64*
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    const uint64_t bits    = state * 0x2545F4914F6CDD1DULL;
+    const double   uniform = (static_cast<double>(bits >> 11) + 1.0) * 0x1.0p-53;  // (0, 1]
+    return 1 + static_cast<int64_t>(-std::log(uniform) * static_cast<double>(interval));
+}
+
+// Allocations of `num_bytes` a sample stands for: the inverse of the
+// probability 1 - exp(-num_bytes / interval) that such an allocation is sampled.
+double sample_weight(size_t num_bytes, size_t interval)
+{
+    const double probability =
+        -std::expm1(-static_cast<double>(num_bytes) / static_cast<double>(interval));
+    return probability > 0.0 ? 1.0 / probability : 0.0;
+}
+}  // namespace
+
+/**
+ * @brief Sampling state, counters and recent samples of one thread.
+ *
+ * Only the owning thread writes; other threads read the counters and the
+ * records without locking. Records are a ring rewritten as seqlocks:
+ * `sequence` is the index of the sample held, kWritingRecord during a write.
+ */
+struct allocator_tracking::SampleBuffer
+{
+    struct Record
+    {
+        std::atomic<uint64_t>  sequence{kWritingRecord};
+        std::atomic<uintptr_t> ptr{0};
+        std::atomic<size_t>    requested_bytes{0};
+        std::atomic<size_t>    allocated_bytes{0};
+        std::atomic<size_t>    alignment{0};
+        std::atomic<int64_t>   alloc_micros{0};
+        std::atomic<int64_t>   allocation_id{0};
+    };
+
+    SampleBuffer(size_t capacity, uint64_t seed)
+        : rng(seed != 0 ? seed : 0x9E3779B97F4A7C15ULL),
+          records(std::make_unique<Record[]>(capacity)),
+          capacity(capacity)
+    {
+    }
+
+    int64_t  countdown{0};  // Bytes until the next sample
+    uint64_t rng;
+
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> deallocations{0};
+    std::atomic<uint64_t> requested_bytes{0};
+
+    std::unique_ptr<Record[]> records;
+    const size_t              capacity;
+    std::atomic<uint64_t>     head{0};  // Samples ever written
+
+    // Set when the tracker is destroyed
+    std::atomic<bool> detached{false};
+};
+
+// Sample buffers of the calling thread, one per tracker it used.
+struct allocator_tracking::SampleBufferSlots
+{
+    struct Slot
+    {
+        uint64_t                      tracker_id;
+        std::shared_ptr<SampleBuffer> buffer;
+    };
+
+    static SampleBufferSlots& local()
+    {
+        static thread_local SampleBufferSlots slots;
+        return slots;
+    }
+
+    std::vector<Slot> slots;
+};
+
+namespace
+{
+// Buffer the calling thread used last. Trivially destructible, so that the
+// fast path reads it without the initialization guard of `slots`.
+struct last_sample_buffer
+{
+    uint64_t tracker_id;
+    void*    buffer;
+};
+
+thread_local last_sample_buffer tls_last_sample_buffer{0, nullptr};
+}  // namespace
+
+struct alignas(64) allocator_tracking::LiveBucket
+{
+    std::atomic<uintptr_t> keys[kLiveBucketSlots]{};
+};
+
+struct allocator_tracking::LiveSample
+{
+    std::atomic<int64_t> allocation_id{0};
+    std::atomic<int64_t> requested_estimate{0};
+    std::atomic<int64_t> allocated_estimate{0};
+};
 
 allocator_tracking::allocator_tracking(
     Allocator* allocator, bool track_sizes, bool enable_enhanced_tracking)
@@ -81,8 +262,57 @@ allocator_tracking::allocator_tracking(
     }
 }
 
+allocator_tracking::allocator_tracking(
+    Allocator* allocator, const tracking_sampling_options& sampling)
+    : allocator_(allocator),
+      track_sizes_locally_(false),
+      enhanced_tracking_enabled_(false),
+      sample_interval_bytes_(sampling.sample_interval_bytes),
+      thread_buffer_records_(std::max<size_t>(1, sampling.thread_buffer_records)),
+      instance_id_(next_tracker_instance_id())
+{
+    QUARISMA_CHECK(
+        sample_interval_bytes_ > 0, "allocator_tracking sampling interval must be positive");
+
+    size_t buckets = 1;
+    while (buckets * kLiveBucketSlots < sampling.max_live_samples)
+    {
+        buckets *= 2;
+    }
+    live_buckets_     = std::make_unique<LiveBucket[]>(buckets);
+    live_samples_     = std::make_unique<LiveSample[]>(buckets * kLiveBucketSlots);
+    live_bucket_mask_ = buckets - 1;
+
+    timing_stats_.reset();
+
+    if (log_level_.load(std::memory_order_relaxed) >= tracking_log_level::INFO)
+    {
+        QUARISMA_LOG_INFO(
+            "allocator_tracking initialized: sampling every {} bytes, underlying={}",
+            sample_interval_bytes_,
+            allocator_->Name());
+    }
+}
+
+allocator_tracking::~allocator_tracking()
+{
+    // Threads drop the buffers of a destroyed tracker from their slots.
+    std::scoped_lock const lock(sample_buffers_mutex_);
+    for (const auto& buffer : sample_buffers_)
+    {
+        buffer->detached.store(true, std::memory_order_release);
+    }
+}
+
 void* allocator_tracking::allocate_raw(
     size_t alignment, size_t num_bytes, const allocation_attributes& allocation_attr)
+{
+    return sampling() ? SampledAllocate(alignment, num_bytes, allocation_attr)
+                      : TrackedAllocate(alignment, num_bytes, allocation_attr);
+}
+
+void* allocator_tracking::TrackedAllocate(
+    size_t alignment, size_t num_bytes, const allocation_attributes& allocation_attr)
 {
     // Start timing for performance analysis
     auto start_time = std::chrono::steady_clock::now();
@@ -100,6 +330,7 @@ void* allocator_tracking::allocate_raw(
 
     // Calculate allocation timing
     auto end_time = std::chrono::steady_clock::now();
+    alloc_latency_.record(latency_ns(start_time, end_time));
     auto duration_us =
         std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
     auto duration_us_unsigned = std::max<uint64_t>(0ULL, duration_us);
@@ -154,10 +385,11 @@ void* allocator_tracking::allocate_raw(
         int64_t      allocation_id   = 0;
 
         {
-            std::unique_lock<std::mutex> const lock(mu_);
+            std::unique_lock<profiled_mutex> const lock(mu_);
             allocated_ += allocated_bytes;
             high_watermark_ = std::max(high_watermark_, allocated_);
             total_bytes_ += allocated_bytes;
+            profile_.on_allocate(allocated_bytes);
 
             int64_t const tmp = std::chrono::duration_cast<std::chrono::microseconds>(
                                     std::chrono::steady_clock::now().time_since_epoch())
@@ -168,16 +400,15 @@ void* allocator_tracking::allocate_raw(
             next_allocation_id_ += 1;
             allocation_id = next_allocation_id_;
 
-            // Populate in_use_ map if we're tracking sizes locally (needed for RequestedSize)
-            if (track_sizes_locally_)
-            {
-                Chunk const chunk = {num_bytes, allocated_bytes, allocation_id};
-                in_use_.emplace(std::make_pair(ptr, chunk));
-            }
-
             ++ref_;
         }
 
+        // Populate in_use_ map if we're tracking sizes locally (needed for RequestedSize)
+        if (track_sizes_locally_)
+        {
+            in_use_.insert_or_assign(ptr, Chunk{num_bytes, allocated_bytes, allocation_id});
+        }
+
         // Add enhanced record if enabled
         if (enhanced_tracking_enabled_)
         {
@@ -195,6 +426,8 @@ void* allocator_tracking::allocate_raw(
                 nullptr         // function_name
             );
             enhanced_records_.back().alloc_duration_us = duration_us;
+            enhanced_records_.back().alloc_sequence    = ++event_sequence_;
+            enhanced_records_.back().alloc_thread      = current_thread_hash();
         }
     }
     else if (track_sizes_locally_)
@@ -207,20 +440,20 @@ void* allocator_tracking::allocate_raw(
         int64_t allocation_id  = 0;
 
         {
-            std::unique_lock<std::mutex> const lock(mu_);
+            std::unique_lock<profiled_mutex> const lock(mu_);
             next_allocation_id_ += 1;
-            allocation_id     = next_allocation_id_;
-            Chunk const chunk = {num_bytes, allocated_bytes, allocation_id};
-            in_use_.emplace(std::make_pair(ptr, chunk));
+            allocation_id = next_allocation_id_;
             allocated_ += allocated_bytes;
             high_watermark_ = std::max(high_watermark_, allocated_);
             total_bytes_ += allocated_bytes;
+            profile_.on_allocate(allocated_bytes);
             int64_t const tmp = std::chrono::duration_cast<std::chrono::microseconds>(
                                     std::chrono::steady_clock::now().time_since_epoch())
                                     .count();
             allocations_.emplace_back(allocated_bytes, tmp);
             ++ref_;
         }
+        in_use_.insert_or_assign(ptr, Chunk{num_bytes, allocated_bytes, allocation_id});
 
         // Add enhanced record if enabled
         if (enhanced_tracking_enabled_)
@@ -239,13 +472,15 @@ void* allocator_tracking::allocate_raw(
                 nullptr         // function_name
             );
             enhanced_records_.back().alloc_duration_us = duration_us;
+            enhanced_records_.back().alloc_sequence    = ++event_sequence_;
+            enhanced_records_.back().alloc_thread      = current_thread_hash();
         }
     }
     else
     {
         int64_t allocation_id = 0;
         {
-            std::unique_lock<std::mutex> const lock(mu_);
+            std::unique_lock<profiled_mutex> const lock(mu_);
             total_bytes_ += num_bytes;
             int64_t const tmp = std::chrono::duration_cast<std::chrono::microseconds>(
                                     std::chrono::steady_clock::now().time_since_epoch())
@@ -273,6 +508,8 @@ void* allocator_tracking::allocate_raw(
                 nullptr         // function_name
             );
             enhanced_records_.back().alloc_duration_us = duration_us;
+            enhanced_records_.back().alloc_sequence    = ++event_sequence_;
+            enhanced_records_.back().alloc_thread      = current_thread_hash();
         }
     }
     return ptr;
@@ -286,6 +523,19 @@ void allocator_tracking::deallocate_raw(void* ptr)
         return;
     }
 
+    if (sampling())
+    {
+        SampledDeallocate(ptr);
+    }
+    else
+    {
+        TrackedDeallocate(ptr);
+    }
+}
+
+void allocator_tracking::TrackedDeallocate(void* ptr)
+{
+
     // Start timing for performance analysis
     auto start_time = std::chrono::steady_clock::now();
 
@@ -308,14 +558,11 @@ void allocator_tracking::deallocate_raw(void* ptr)
     // Always check local tracking for allocation_id when enhanced tracking is enabled
     if (track_sizes_locally_)
     {
-        std::unique_lock<std::mutex> const lock(mu_);
-        auto                               itr = in_use_.find(ptr);
-        if (itr != in_use_.end())
+        if (auto const chunk = in_use_.extract(ptr))
         {
-            allocated_bytes         = (*itr).second.allocated_size;
-            allocation_id           = (*itr).second.allocation_id;
+            allocated_bytes         = chunk->allocated_size;
+            allocation_id           = chunk->allocation_id;
             tracks_allocation_sizes = true;
-            in_use_.erase(itr);
         }
     }
     else if (tracks_allocation_sizes)
@@ -324,11 +571,12 @@ void allocator_tracking::deallocate_raw(void* ptr)
     }
     Allocator* allocator = allocator_;
     {
-        std::unique_lock<std::mutex> const lock(mu_);
+        std::unique_lock<profiled_mutex> const lock(mu_);
         if (tracks_allocation_sizes)
         {
             QUARISMA_CHECK_DEBUG(allocated_ >= allocated_bytes);
             allocated_ -= allocated_bytes;
+            profile_.on_deallocate(allocated_bytes);
             int64_t const tmp = std::chrono::duration_cast<std::chrono::microseconds>(
                                     std::chrono::steady_clock::now().time_since_epoch())
                                     .count();
@@ -342,6 +590,7 @@ void allocator_tracking::deallocate_raw(void* ptr)
 
     // Calculate deallocation timing
     auto end_time = std::chrono::steady_clock::now();
+    dealloc_latency_.record(latency_ns(start_time, end_time));
     auto duration_us =
         std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
     auto duration_us_unsigned = std::max<uint64_t>(0ULL, duration_us);
@@ -380,6 +629,8 @@ void allocator_tracking::deallocate_raw(void* ptr)
         if (record_it != enhanced_records_.end())
         {
             record_it->dealloc_duration_us = duration_us;
+            record_it->dealloc_sequence    = ++event_sequence_;
+            record_it->dealloc_thread      = current_thread_hash();
         }
     }
 
@@ -411,13 +662,9 @@ size_t allocator_tracking::RequestedSize(const void* ptr) const
 {
     if (track_sizes_locally_)
     {
-        std::unique_lock<std::mutex> const lock(mu_);
-        auto                               it = in_use_.find(ptr);
-        if (it != in_use_.end())
-        {
-            return (*it).second.requested_size;
-        }
-        return 0;
+        size_t size = 0;
+        in_use_.cvisit(ptr, [&size](const Chunk& chunk) { size = chunk.requested_size; });
+        return size;
     }
 
     return allocator_->RequestedSize(ptr);
@@ -427,13 +674,9 @@ size_t allocator_tracking::AllocatedSize(const void* ptr) const
 {
     if (track_sizes_locally_)
     {
-        std::unique_lock<std::mutex> const lock(mu_);
-        auto                               it = in_use_.find(ptr);
-        if (it != in_use_.end())
-        {
-            return (*it).second.allocated_size;
-        }
-        return 0;
+        size_t size = 0;
+        in_use_.cvisit(ptr, [&size](const Chunk& chunk) { size = chunk.allocated_size; });
+        return size;
     }
 
     return allocator_->AllocatedSize(ptr);
@@ -443,13 +686,9 @@ int64_t allocator_tracking::AllocationId(const void* ptr) const
 {
     if (track_sizes_locally_)
     {
-        std::unique_lock<std::mutex> const lock(mu_);
-        auto                               it = in_use_.find(ptr);
-        if (it != in_use_.end())
-        {
-            return (*it).second.allocation_id;
-        }
-        return 0;
+        int64_t id = 0;
+        in_use_.cvisit(ptr, [&id](const Chunk& chunk) { id = chunk.allocation_id; });
+        return id;
     }
 
     return allocator_->AllocationId(ptr);
@@ -462,16 +701,50 @@ std::optional<allocator_stats> allocator_tracking::GetStats() const
 
 bool allocator_tracking::ClearStats()
 {
+    {
+        std::unique_lock<profiled_mutex> const lock(mu_);
+        profile_.reset();
+    }
     return allocator_->ClearStats();
 }
 
+const allocator_stats* allocator_tracking::live_stats() const noexcept
+{
+    return allocator_->live_stats();
+}
+
+const latency_histogram* allocator_tracking::allocation_latency() const noexcept
+{
+    return &alloc_latency_;
+}
+
+const latency_histogram* allocator_tracking::deallocation_latency() const noexcept
+{
+    return &dealloc_latency_;
+}
+
+allocation_profile allocator_tracking::GetAllocationProfile() const
+{
+    std::unique_lock<profiled_mutex> const lock(mu_);
+    return profile_.profile();
+}
+
 std::tuple<size_t, size_t, size_t> allocator_tracking::GetSizes() const
 {
+    if (sampling())
+    {
+        return std::make_tuple(
+            static_cast<size_t>(std::get<2>(SampleCounters())),
+            static_cast<size_t>(peak_allocated_estimate_.load(std::memory_order_relaxed)),
+            static_cast<size_t>(
+                std::max<int64_t>(0, live_allocated_estimate_.load(std::memory_order_relaxed))));
+    }
+
     size_t high_watermark;
     size_t total_bytes;
     size_t still_live_bytes;
     {
-        std::unique_lock<std::mutex> const lock(mu_);
+        std::unique_lock<profiled_mutex> const lock(mu_);
         high_watermark   = high_watermark_;
         total_bytes      = total_bytes_;
         still_live_bytes = allocated_;
@@ -483,9 +756,16 @@ std::vector<alloc_record> allocator_tracking::GetRecordsAndUnRef()
 {
     bool                      should_delete;
     std::vector<alloc_record> allocations;
+    if (sampling())
+    {
+        allocations = SampledAllocRecords();
+    }
     {
-        std::unique_lock<std::mutex> const lock(mu_);
-        allocations.swap(allocations_);
+        std::unique_lock<profiled_mutex> const lock(mu_);
+        if (!sampling())
+        {
+            allocations.swap(allocations_);
+        }
         should_delete = UnRef();
     }
     if (should_delete)
@@ -497,9 +777,14 @@ std::vector<alloc_record> allocator_tracking::GetRecordsAndUnRef()
 
 std::vector<alloc_record> allocator_tracking::GetCurrentRecords()
 {
+    if (sampling())
+    {
+        return SampledAllocRecords();
+    }
+
     std::vector<alloc_record> allocations;
     {
-        std::unique_lock<std::mutex> const lock(mu_);
+        std::unique_lock<profiled_mutex> const lock(mu_);
 
         std::copy(allocations_.begin(), allocations_.end(), std::back_inserter(allocations));
     }
@@ -542,6 +827,15 @@ memory_fragmentation_metrics allocator_tracking::GetFragmentationMetrics() const
     // Get current allocation statistics
     size_t total_allocated;
     size_t total_requested;
+    if (sampling())
+    {
+        // Estimated from the live samples
+        total_allocated = static_cast<size_t>(
+            std::max<int64_t>(0, live_allocated_estimate_.load(std::memory_order_relaxed)));
+        total_requested = static_cast<size_t>(
+            std::max<int64_t>(0, live_requested_estimate_.load(std::memory_order_relaxed)));
+    }
+    else
     {
         std::scoped_lock const stats_lock(mu_);
         total_allocated = allocated_;
@@ -550,10 +844,8 @@ memory_fragmentation_metrics allocator_tracking::GetFragmentationMetrics() const
         // Calculate total requested bytes from local tracking
         if (track_sizes_locally_)
         {
-            for (const auto& [ptr, chunk] : in_use_)
-            {
-                total_requested += chunk.requested_size;
-            }
+            in_use_.cvisit_all([&total_requested](const void*, const Chunk& chunk)
+                               { total_requested += chunk.requested_size; });
         }
         else
         {
@@ -606,6 +898,8 @@ tracking_log_level allocator_tracking::GetLoggingLevel() const noexcept
 void allocator_tracking::ResetTimingStats() noexcept
 {
     timing_stats_.reset();
+    alloc_latency_.reset();
+    dealloc_latency_.reset();
 
     if (log_level_.load(std::memory_order_relaxed) >= tracking_log_level::INFO)
     {
@@ -615,6 +909,27 @@ void allocator_tracking::ResetTimingStats() noexcept
 
 std::tuple<double, double, double> allocator_tracking::GetEfficiencyMetrics() const
 {
+    double utilization_ratio = 1.0;
+    double overhead_ratio    = 0.0;
+
+    if (sampling())
+    {
+        // Ratios of the estimates of the live samples
+        const auto allocated = live_allocated_estimate_.load(std::memory_order_relaxed);
+        const auto requested = live_requested_estimate_.load(std::memory_order_relaxed);
+        if (allocated <= 0)
+        {
+            return std::make_tuple(1.0, 0.0, 1.0);
+        }
+        utilization_ratio =
+            std::min(1.0, static_cast<double>(requested) / static_cast<double>(allocated));
+        overhead_ratio = 1.0 - utilization_ratio;
+        return std::make_tuple(
+            utilization_ratio,
+            overhead_ratio,
+            (utilization_ratio * 0.7) + ((1.0 - overhead_ratio) * 0.3));
+    }
+
     std::scoped_lock const lock(mu_);
 
     if (allocated_ == 0)
@@ -622,17 +937,12 @@ std::tuple<double, double, double> allocator_tracking::GetEfficiencyMetrics() co
         return std::make_tuple(1.0, 0.0, 1.0);  // Perfect efficiency when no allocations
     }
 
-    double utilization_ratio = 1.0;
-    double overhead_ratio    = 0.0;
-
     if (track_sizes_locally_)
     {
         size_t total_requested = 0;
         // Calculate actual utilization from tracked data
-        for (const auto& [ptr, chunk] : in_use_)
-        {
-            total_requested += chunk.requested_size;
-        }
+        in_use_.cvisit_all([&total_requested](const void*, const Chunk& chunk)
+                           { total_requested += chunk.requested_size; });
 
         if (total_requested > 0)
         {
@@ -657,21 +967,43 @@ std::string allocator_tracking::GenerateReport(bool include_allocations) const
     report << "Enhanced Tracking: " << (enhanced_tracking_enabled_ ? "Enabled" : "Disabled")
            << "\n";
     report << "Local Size Tracking: " << (track_sizes_locally_ ? "Enabled" : "Disabled") << "\n";
+    if (sampling())
+    {
+        report << "Sampling: every ~" << sample_interval_bytes_
+               << " bytes (usage and fragmentation are estimated)\n";
+    }
+    else
+    {
+        report << "Sampling: Disabled\n";
+    }
     report << "Logging Level: " << static_cast<int>(log_level_.load(std::memory_order_relaxed))
            << "\n\n";
 
     // Memory Usage Summary
     auto [total_bytes, high_watermark, current_bytes] = GetSizes();
+    const char* estimated = sampling() ? " (estimated)" : "";
     report << "--- Memory Usage Summary ---\n";
-    report << "Current Allocated: " << current_bytes << " bytes\n";
-    report << "Peak Usage (High Watermark): " << high_watermark << " bytes\n";
+    report << "Current Allocated" << estimated << ": " << current_bytes << " bytes\n";
+    report << "Peak Usage (High Watermark)" << estimated << ": " << high_watermark << " bytes\n";
     report << "Total Allocated (Cumulative): " << total_bytes << " bytes\n\n";
 
-    // Performance Statistics
+    // Performance Statistics; when sampling, timings cover the sampled operations
     auto timing = GetTimingStats();
     report << "--- Performance Statistics ---\n";
-    report << "Total Allocations: " << timing.total_allocations << "\n";
-    report << "Total Deallocations: " << timing.total_deallocations << "\n";
+    if (sampling())
+    {
+        auto [allocations, deallocations, requested_bytes] = SampleCounters();
+        report << "Total Allocations: " << allocations << "\n";
+        report << "Total Deallocations: " << deallocations << "\n";
+        report << "Sampled Allocations: " << timing.total_allocations << " (dropped "
+               << GetDroppedSamples() << ", live "
+               << live_sample_count_.load(std::memory_order_relaxed) << ")\n";
+    }
+    else
+    {
+        report << "Total Allocations: " << timing.total_allocations << "\n";
+        report << "Total Deallocations: " << timing.total_deallocations << "\n";
+    }
     report << "Average Allocation Time: " << std::fixed << std::setprecision(2)
            << timing.average_alloc_time_us() << " μs\n";
     report << "Average Deallocation Time: " << std::fixed << std::setprecision(2)
@@ -690,6 +1022,17 @@ std::string allocator_tracking::GenerateReport(bool include_allocations) const
     {
         report << "Min/Max Deallocation Time: " << min_dealloc << "/" << max_dealloc << " μs\n";
     }
+    for (auto const& [label, histogram] :
+         {std::pair{"Allocation", &alloc_latency_}, std::pair{"Deallocation", &dealloc_latency_}})
+    {
+        auto const latency = histogram->snapshot();
+        if (latency.count != 0)
+        {
+            report << label << " Latency p50/p99/p99.9: " << latency.percentile_ns(50.0) << "/"
+                   << latency.percentile_ns(99.0) << "/" << latency.percentile_ns(99.9)
+                   << " ns\n";
+        }
+    }
     report << "\n";
 
     // Efficiency Metrics
@@ -770,8 +1113,355 @@ std::string allocator_tracking::GenerateReport(bool include_allocations) const
         }
     }
 
+    if (include_allocations && sampling())
+    {
+        auto samples = GetSampledRecords();
+        report << "--- Sampled Allocation Details ---\n";
+        report << "Total Samples: " << samples.size() << "\n";
+
+        if (!samples.empty())
+        {
+            report << "Recent Samples (last 10):\n";
+            size_t const start = samples.size() > 10 ? samples.size() - 10 : 0;
+
+            for (size_t i = start; i < samples.size(); ++i)
+            {
+                const auto& sample = samples[i];
+                report << "  [" << sample.allocation_id << "] " << sample.requested_bytes << "/"
+                       << sample.allocated_bytes << " bytes, align=" << sample.alignment
+                       << ", weight=" << std::fixed << std::setprecision(1) << sample.weight
+                       << (sample.live ? ", live" : "") << "\n";
+            }
+        }
+    }
+
     report << "=== End Report ===\n";
     return report.str();
 }
 
+// ========== Sampling Mode Implementation ==========
+
+inline allocator_tracking::SampleBuffer* allocator_tracking::LocalSampleBuffer()
+{
+    const last_sample_buffer last = tls_last_sample_buffer;
+    if (last.tracker_id == instance_id_)
+    {
+        return static_cast<SampleBuffer*>(last.buffer);
+    }
+    return AttachSampleBuffer(SampleBufferSlots::local());
+}
+
+void* allocator_tracking::SampledAllocate(
+    size_t alignment, size_t num_bytes, const allocation_attributes& allocation_attr)
+{
+    SampleBuffer* buffer = LocalSampleBuffer();
+    bump(buffer->allocations, 1);
+    bump(buffer->requested_bytes, num_bytes);
+    if QUARISMA_UNLIKELY (static_cast<int64_t>(num_bytes) >= buffer->countdown)
+    {
+        return SampleAllocation(buffer, alignment, num_bytes, allocation_attr);
+    }
+    buffer->countdown -= static_cast<int64_t>(num_bytes);
+    return allocator_->allocate_raw(alignment, num_bytes, allocation_attr);  //NOLINT
+}
+
+void* allocator_tracking::SampleAllocation(
+    SampleBuffer*                buffer,
+    size_t                       alignment,
+    size_t                       num_bytes,
+    const allocation_attributes& allocation_attr)
+{
+    auto  start_time = std::chrono::steady_clock::now();
+    void* ptr        = allocator_->allocate_raw(alignment, num_bytes, allocation_attr);  //NOLINT
+    auto  end_time   = std::chrono::steady_clock::now();
+    alloc_latency_.record(latency_ns(start_time, end_time));
+    record_duration(
+        timing_stats_.total_allocations,
+        timing_stats_.total_alloc_time_us,
+        timing_stats_.min_alloc_time_us,
+        timing_stats_.max_alloc_time_us,
+        std::max<int64_t>(
+            0,
+            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count()));
+
+    // A failed allocation leaves the countdown expired: the next one is sampled.
+    if (ptr == nullptr)
+    {
+        if (log_level_.load(std::memory_order_relaxed) >= tracking_log_level::WARNING)
+        {
+            QUARISMA_LOG_WARNING(
+                "allocator_tracking::allocate_raw failed: {} bytes, alignment={}",
+                num_bytes,
+                alignment);
+        }
+        return ptr;
+    }
+
+    buffer->countdown = draw_countdown(buffer->rng, sample_interval_bytes_);
+
+    size_t const allocated_bytes = allocator_->tracks_allocation_sizes()
+                                       ? allocator_->AllocatedSize(ptr)
+                                       : std::max(num_bytes, allocator_->AllocatedSizeSlow(ptr));
+    double const  weight        = sample_weight(num_bytes, sample_interval_bytes_);
+    int64_t const allocation_id = next_sample_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto const    requested_estimate =
+        static_cast<int64_t>(std::llround(static_cast<double>(num_bytes) * weight));
+    auto const allocated_estimate =
+        static_cast<int64_t>(std::llround(static_cast<double>(allocated_bytes) * weight));
+
+    if (InsertLiveSample(ptr, allocation_id, requested_estimate, allocated_estimate))
+    {
+        live_requested_estimate_.fetch_add(requested_estimate, std::memory_order_relaxed);
+        update_max(
+            peak_allocated_estimate_,
+            live_allocated_estimate_.fetch_add(allocated_estimate, std::memory_order_relaxed) +
+                allocated_estimate);
+    }
+    else
+    {
+        dropped_samples_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t const        index  = buffer->head.load(std::memory_order_relaxed);
+    SampleBuffer::Record& record = buffer->records[index % buffer->capacity];
+    record.sequence.store(kWritingRecord, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.ptr.store(reinterpret_cast<uintptr_t>(ptr), std::memory_order_relaxed);
+    record.requested_bytes.store(num_bytes, std::memory_order_relaxed);
+    record.allocated_bytes.store(allocated_bytes, std::memory_order_relaxed);
+    record.alignment.store(alignment, std::memory_order_relaxed);
+    record.alloc_micros.store(
+        std::chrono::duration_cast<std::chrono::microseconds>(end_time.time_since_epoch()).count(),
+        std::memory_order_relaxed);
+    record.allocation_id.store(allocation_id, std::memory_order_relaxed);
+    record.sequence.store(index, std::memory_order_release);
+    buffer->head.store(index + 1, std::memory_order_release);
+
+    return ptr;
+}
+
+void allocator_tracking::SampledDeallocate(void* ptr)
+{
+    bump(LocalSampleBuffer()->deallocations, 1);
+    if (live_sample_count_.load(std::memory_order_relaxed) != 0)
+    {
+        const auto        key  = reinterpret_cast<uintptr_t>(ptr);
+        const LiveBucket& line = live_buckets_[live_bucket_of(key, live_bucket_mask_)];
+        for (const auto& slot : line.keys)
+        {
+            if QUARISMA_UNLIKELY (slot.load(std::memory_order_relaxed) == key)
+            {
+                DeallocateSample(ptr);
+                return;
+            }
+        }
+    }
+    allocator_->deallocate_raw(ptr);
+}
+
+void allocator_tracking::DeallocateSample(void* ptr)
+{
+    int64_t requested_estimate = 0;
+    int64_t allocated_estimate = 0;
+    if (!RemoveLiveSample(ptr, &requested_estimate, &allocated_estimate))
+    {
+        allocator_->deallocate_raw(ptr);
+        return;
+    }
+    live_requested_estimate_.fetch_sub(requested_estimate, std::memory_order_relaxed);
+    live_allocated_estimate_.fetch_sub(allocated_estimate, std::memory_order_relaxed);
+
+    auto start_time = std::chrono::steady_clock::now();
+    allocator_->deallocate_raw(ptr);
+    auto end_time = std::chrono::steady_clock::now();
+    dealloc_latency_.record(latency_ns(start_time, end_time));
+    record_duration(
+        timing_stats_.total_deallocations,
+        timing_stats_.total_dealloc_time_us,
+        timing_stats_.min_dealloc_time_us,
+        timing_stats_.max_dealloc_time_us,
+        std::max<int64_t>(
+            0,
+            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count()));
+}
+
+allocator_tracking::SampleBuffer* allocator_tracking::AttachSampleBuffer(SampleBufferSlots& local)
+{
+    auto& slots = local.slots;
+    slots.erase(
+        std::remove_if(
+            slots.begin(),
+            slots.end(),
+            [](const SampleBufferSlots::Slot& slot)
+            { return slot.buffer->detached.load(std::memory_order_acquire); }),
+        slots.end());
+
+    SampleBuffer* buffer = nullptr;
+    for (const auto& slot : slots)
+    {
+        if (slot.tracker_id == instance_id_)
+        {
+            buffer = slot.buffer.get();
+            break;
+        }
+    }
+
+    if (buffer == nullptr)
+    {
+        // Seeds differ between threads and trackers
+        const uint64_t seed = (reinterpret_cast<uintptr_t>(&local) ^
+                               (instance_id_ * 0x9E3779B97F4A7C15ULL)) |
+                              1;
+        auto created       = std::make_shared<SampleBuffer>(thread_buffer_records_, seed);
+        created->countdown = draw_countdown(created->rng, sample_interval_bytes_);
+        {
+            std::scoped_lock const lock(sample_buffers_mutex_);
+            sample_buffers_.push_back(created);
+        }
+        slots.push_back({instance_id_, created});
+        buffer = created.get();
+    }
+
+    tls_last_sample_buffer = {instance_id_, buffer};
+    return buffer;
+}
+
+bool allocator_tracking::InsertLiveSample(
+    void* ptr, int64_t allocation_id, int64_t requested, int64_t allocated)
+{
+    const auto   key    = reinterpret_cast<uintptr_t>(ptr);
+    const size_t bucket = live_bucket_of(key, live_bucket_mask_);
+    LiveBucket&  line   = live_buckets_[bucket];
+    for (size_t i = 0; i < kLiveBucketSlots; ++i)
+    {
+        uintptr_t expected = kFreeKey;
+        if (line.keys[i].load(std::memory_order_relaxed) == kFreeKey &&
+            line.keys[i].compare_exchange_strong(
+                expected, kReservedKey, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            LiveSample& sample = live_samples_[bucket * kLiveBucketSlots + i];
+            sample.allocation_id.store(allocation_id, std::memory_order_relaxed);
+            sample.requested_estimate.store(requested, std::memory_order_relaxed);
+            sample.allocated_estimate.store(allocated, std::memory_order_relaxed);
+            live_sample_count_.fetch_add(1, std::memory_order_relaxed);
+            line.keys[i].store(key, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool allocator_tracking::RemoveLiveSample(void* ptr, int64_t* requested, int64_t* allocated)
+{
+    auto         key    = reinterpret_cast<uintptr_t>(ptr);
+    const size_t bucket = live_bucket_of(key, live_bucket_mask_);
+    LiveBucket&  line   = live_buckets_[bucket];
+    for (size_t i = 0; i < kLiveBucketSlots; ++i)
+    {
+        if (line.keys[i].load(std::memory_order_acquire) == key &&
+            line.keys[i].compare_exchange_strong(
+                key, kReservedKey, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            const LiveSample& sample = live_samples_[bucket * kLiveBucketSlots + i];
+            *requested               = sample.requested_estimate.load(std::memory_order_relaxed);
+            *allocated               = sample.allocated_estimate.load(std::memory_order_relaxed);
+            live_sample_count_.fetch_sub(1, std::memory_order_relaxed);
+            line.keys[i].store(kFreeKey, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool allocator_tracking::IsLiveSample(uintptr_t ptr, int64_t allocation_id) const noexcept
+{
+    const size_t      bucket = live_bucket_of(ptr, live_bucket_mask_);
+    const LiveBucket& line   = live_buckets_[bucket];
+    for (size_t i = 0; i < kLiveBucketSlots; ++i)
+    {
+        if (line.keys[i].load(std::memory_order_acquire) == ptr &&
+            live_samples_[bucket * kLiveBucketSlots + i].allocation_id.load(
+                std::memory_order_relaxed) == allocation_id)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::tuple<uint64_t, uint64_t, uint64_t> allocator_tracking::SampleCounters() const
+{
+    uint64_t               allocations     = 0;
+    uint64_t               deallocations   = 0;
+    uint64_t               requested_bytes = 0;
+    std::scoped_lock const lock(sample_buffers_mutex_);
+    for (const auto& buffer : sample_buffers_)
+    {
+        allocations += buffer->allocations.load(std::memory_order_relaxed);
+        deallocations += buffer->deallocations.load(std::memory_order_relaxed);
+        requested_bytes += buffer->requested_bytes.load(std::memory_order_relaxed);
+    }
+    return std::make_tuple(allocations, deallocations, requested_bytes);
+}
+
+std::vector<sampled_alloc_record> allocator_tracking::GetSampledRecords() const
+{
+    std::vector<sampled_alloc_record> samples;
+    if (!sampling())
+    {
+        return samples;
+    }
+
+    {
+        std::scoped_lock const lock(sample_buffers_mutex_);
+        for (const auto& buffer : sample_buffers_)
+        {
+            const uint64_t head  = buffer->head.load(std::memory_order_acquire);
+            const uint64_t first = head > buffer->capacity ? head - buffer->capacity : 0;
+            for (uint64_t index = first; index < head; ++index)
+            {
+                const SampleBuffer::Record& record = buffer->records[index % buffer->capacity];
+                if (record.sequence.load(std::memory_order_acquire) != index)
+                {
+                    continue;  // Being rewritten by the thread
+                }
+                sampled_alloc_record sample;
+                const uintptr_t      ptr = record.ptr.load(std::memory_order_relaxed);
+                sample.requested_bytes   = record.requested_bytes.load(std::memory_order_relaxed);
+                sample.allocated_bytes   = record.allocated_bytes.load(std::memory_order_relaxed);
+                sample.alignment         = record.alignment.load(std::memory_order_relaxed);
+                sample.alloc_micros      = record.alloc_micros.load(std::memory_order_relaxed);
+                sample.allocation_id     = record.allocation_id.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (record.sequence.load(std::memory_order_relaxed) != index)
+                {
+                    continue;
+                }
+                sample.weight = sample_weight(sample.requested_bytes, sample_interval_bytes_);
+                sample.live   = IsLiveSample(ptr, sample.allocation_id);
+                samples.push_back(sample);
+            }
+        }
+    }
+
+    std::sort(
+        samples.begin(),
+        samples.end(),
+        [](const sampled_alloc_record& a, const sampled_alloc_record& b)
+        { return a.allocation_id < b.allocation_id; });
+    return samples;
+}
+
+std::vector<alloc_record> allocator_tracking::SampledAllocRecords() const
+{
+    std::vector<alloc_record> allocations;
+    for (const auto& sample : GetSampledRecords())
+    {
+        allocations.emplace_back(
+            std::llround(static_cast<double>(sample.allocated_bytes) * sample.weight),
+            sample.alloc_micros);
+    }
+    return allocations;
+}
+
 }  // namespace quarisma
@@ -30,6 +30,8 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -41,7 +43,10 @@
 #include "common/macros.h"
 #include "logging/logger.h"
 #include "memory/cpu/allocator.h"
+#include "memory/helper/allocation_profile.h"
 #include "memory/unified_memory_stats.h"
+#include "parallel/profiled_mutex.h"
+#include "util/concurrent_flat_map.h"
 #include "util/flat_hash.h"
 
 namespace quarisma
@@ -174,6 +179,10 @@ struct enhanced_alloc_record : public alloc_record
     const char* source_file{nullptr};    ///< Source file where allocation occurred
     int         source_line{0};          ///< Source line number
     const char* function_name{nullptr};  ///< Function name where allocation occurred
+    uint64_t    alloc_sequence{0};       ///< Position of the allocation in the event order
+    uint64_t    dealloc_sequence{0};     ///< Position of the deallocation (0 while live)
+    uint64_t    alloc_thread{0};         ///< Hash of the allocating thread's id
+    uint64_t    dealloc_thread{0};       ///< Hash of the deallocating thread's id
 
     /**
      * @brief Constructs enhanced allocation record with comprehensive metadata.
@@ -215,6 +224,35 @@ struct enhanced_alloc_record : public alloc_record
     enhanced_alloc_record() noexcept = default;
 };
 
+/**
+ * @brief Configuration of the sampling mode of allocator_tracking.
+ *
+ * In sampling mode allocations are sampled with a probability growing with
+ * their size, on average once every `sample_interval_bytes` allocated bytes
+ * (Poisson sampling, as in tcmalloc and jemalloc's heap profiler). Only the
+ * sampled allocations are recorded, and the analytics are estimated from them.
+ */
+struct tracking_sampling_options
+{
+    size_t sample_interval_bytes = 512 << 10;  ///< Mean allocated bytes between two samples
+    size_t max_live_samples      = 16384;      ///< Capacity of the table of live samples
+    size_t thread_buffer_records = 256;        ///< Recent samples kept per thread
+};
+
+/**
+ * @brief Allocation sampled by allocator_tracking in sampling mode.
+ */
+struct sampled_alloc_record
+{
+    size_t  requested_bytes{0};  ///< Originally requested size
+    size_t  allocated_bytes{0};  ///< Actual allocated size
+    size_t  alignment{0};        ///< Memory alignment requirement
+    int64_t alloc_micros{0};     ///< Timestamp when allocation occurred
+    int64_t allocation_id{0};    ///< Identifier of the sample
+    double  weight{0.0};         ///< Number of allocations of this size the sample stands for
+    bool    live{false};         ///< Not deallocated when the records were read
+};
+
 /**
  * @brief Advanced memory allocation tracker with comprehensive debugging capabilities.
  *
@@ -243,6 +281,27 @@ public:
     QUARISMA_API explicit allocator_tracking(
         Allocator* allocator, bool track_sizes, bool enable_enhanced_tracking = true);
 
+    /**
+     * @brief Constructs a tracking allocator in sampling mode.
+     *
+     * Unsampled allocations and deallocations only update counters of the
+     * calling thread, without locking; sampled ones go to a lock-free buffer
+     * of the thread and to a table of live samples. GetSizes(),
+     * GetFragmentationMetrics(), GetEfficiencyMetrics() and GenerateReport()
+     * report estimates, and sizes and IDs come from the underlying allocator.
+     *
+     * @param allocator Underlying allocator to wrap (not owned)
+     * @param sampling Sampling interval and buffer sizes
+     *
+     * **Lifecycle**: Allocations do not hold references; the wrapper is
+     *                deleted by GetRecordsAndUnRef(), after all of its
+     *                allocations were deallocated
+     * **Performance**: A thread local lookup and a few non-atomic counter
+     *                  updates per unsampled operation
+     */
+    QUARISMA_API allocator_tracking(
+        Allocator* allocator, const tracking_sampling_options& sampling);
+
     /**
      * @brief Returns name of underlying allocator.
      *
@@ -379,6 +438,23 @@ public:
      */
     QUARISMA_API bool ClearStats() override;
 
+    /**
+     * @brief Forwards to the underlying allocator's live statistics.
+     */
+    QUARISMA_API const allocator_stats* live_stats() const noexcept override;
+
+    /**
+     * @brief Latencies of the underlying allocator's allocate_raw().
+     *
+     * When sampling, only the sampled allocations are timed.
+     */
+    QUARISMA_API const latency_histogram* allocation_latency() const noexcept override;
+
+    /**
+     * @brief Latencies of the underlying allocator's deallocate_raw().
+     */
+    QUARISMA_API const latency_histogram* deallocation_latency() const noexcept override;
+
     /**
      * @brief Returns memory type of underlying allocator.
      *
@@ -417,6 +493,18 @@ public:
      */
     QUARISMA_API std::tuple<size_t, size_t, size_t> GetSizes() const;
 
+    /**
+     * @brief Peak live allocations per size since construction or ClearStats().
+     *
+     * Sizes are those the underlying allocator reports (AllocatedSize()), or
+     * the requested ones when it tracks none. Empty in sampling mode and when
+     * sizes are not tracked at all. Save it once the process has reached
+     * steady state and replay it with warm_up_allocator() at startup.
+     *
+     * **Thread Safety**: Thread-safe with internal synchronization
+     */
+    QUARISMA_API allocation_profile GetAllocationProfile() const;
+
     /**
      * @brief Retrieves allocation records and releases reference.
      *
@@ -605,6 +693,31 @@ public:
      */
     QUARISMA_API std::string GenerateReport(bool include_allocations = false) const;
 
+    // ========== Sampling Mode ==========
+
+    /** Whether the tracker samples allocations, see tracking_sampling_options. */
+    bool sampling() const noexcept { return sample_interval_bytes_ != 0; }
+
+    /**
+     * @brief Returns the recent samples of every thread, oldest first.
+     *
+     * @return Up to tracking_sampling_options::thread_buffer_records samples
+     *         per thread; empty when not sampling
+     *
+     * **Thread Safety**: Thread-safe; reads the thread buffers without
+     *                    blocking their threads
+     */
+    QUARISMA_API std::vector<sampled_alloc_record> GetSampledRecords() const;
+
+    /**
+     * @brief Number of samples left out of the estimates as the table of live
+     * samples was full.
+     */
+    int64_t GetDroppedSamples() const noexcept
+    {
+        return dropped_samples_.load(std::memory_order_relaxed);
+    }
+
 protected:
     /**
      * @brief Protected destructor for reference-counted lifecycle management.
@@ -616,9 +729,44 @@ protected:
      * **Lifecycle**: Only called by UnRef() when reference count reaches zero
      * **Thread Safety**: Destructor assumes no concurrent access
      */
-    ~allocator_tracking() override = default;
+    QUARISMA_API ~allocator_tracking() override;
 
 private:
+    struct SampleBuffer;       ///< Sampling state and recent samples of a thread
+    struct SampleBufferSlots;  ///< Sample buffers of the calling thread, one per tracker
+    struct LiveBucket;         ///< Cache line of keys of the live sample table
+    struct LiveSample;         ///< Estimates of a live sample
+
+    // Out of line, so that the sampling fast paths stay small
+    QUARISMA_NOINLINE void* TrackedAllocate(
+        size_t alignment, size_t num_bytes, const allocation_attributes& allocation_attr);
+    QUARISMA_NOINLINE void TrackedDeallocate(void* ptr);
+
+    void* SampledAllocate(
+        size_t alignment, size_t num_bytes, const allocation_attributes& allocation_attr);
+    QUARISMA_NOINLINE void* SampleAllocation(
+        SampleBuffer*                buffer,
+        size_t                       alignment,
+        size_t                       num_bytes,
+        const allocation_attributes& allocation_attr);
+    void                   SampledDeallocate(void* ptr);
+    QUARISMA_NOINLINE void DeallocateSample(void* ptr);
+
+    SampleBuffer* LocalSampleBuffer();
+    SampleBuffer* AttachSampleBuffer(SampleBufferSlots& local)
+        QUARISMA_LOCKS_EXCLUDED(sample_buffers_mutex_);
+
+    bool InsertLiveSample(void* ptr, int64_t allocation_id, int64_t requested, int64_t allocated);
+    bool RemoveLiveSample(void* ptr, int64_t* requested, int64_t* allocated);
+    bool IsLiveSample(uintptr_t ptr, int64_t allocation_id) const noexcept;
+
+    /** (allocations, deallocations, requested bytes) counted by the thread buffers. */
+    std::tuple<uint64_t, uint64_t, uint64_t> SampleCounters() const
+        QUARISMA_LOCKS_EXCLUDED(sample_buffers_mutex_);
+
+    /** Samples as alloc_records of their estimated bytes, oldest first. */
+    std::vector<alloc_record> SampledAllocRecords() const;
+
     /**
      * @brief Decrements reference count and handles self-destruction.
      *
@@ -652,7 +800,7 @@ private:
      * **Granularity**: Protects all mutable members
      * **Performance**: Fine-grained locking minimizes contention
      */
-    mutable std::mutex mu_;
+    mutable profiled_mutex mu_{"allocator_tracking"};
 
     // ========== Reference Counting and Lifecycle ==========
 
@@ -695,6 +843,11 @@ private:
      */
     size_t high_watermark_ QUARISMA_GUARDED_BY(mu_){0};
 
+    /**
+     * @brief Live and peak counts per allocation size, see GetAllocationProfile().
+     */
+    allocation_profile_recorder profile_ QUARISMA_GUARDED_BY(mu_);
+
     /**
      * @brief Total bytes allocated through this wrapper.
      *
@@ -758,8 +911,10 @@ private:
      * **Key**: Memory pointer returned by allocator
      * **Value**: Chunk metadata with size and ID information
      * **Lifecycle**: Entries added on allocation, removed on deallocation
+     * **Thread Safety**: Sharded with its own locks, so size lookups and
+     * deallocations of unrelated pointers do not serialize on mu_
      */
-    quarisma_map<const void*, Chunk> in_use_ QUARISMA_GUARDED_BY(mu_);
+    concurrent_flat_map<const void*, Chunk> in_use_;
 
     /**
      * @brief Counter for generating unique allocation IDs.
@@ -787,6 +942,14 @@ private:
      */
     mutable atomic_timing_stats timing_stats_;
 
+    /**
+     * @brief Distributions of the same timings in nanoseconds, for percentiles.
+     *
+     * Cleared together with timing_stats_ by ResetTimingStats().
+     */
+    latency_histogram alloc_latency_;
+    latency_histogram dealloc_latency_;
+
     /**
      * @brief Enhanced allocation records with comprehensive metadata.
      *
@@ -800,6 +963,14 @@ private:
      */
     mutable std::vector<enhanced_alloc_record> enhanced_records_ QUARISMA_GUARDED_BY(shared_mu_);
 
+    /**
+     * @brief Last sequence number given to an allocation or deallocation event.
+     *
+     * Orders the events of enhanced_records_ exactly, where the microsecond
+     * timestamps tie; trace replays rely on it.
+     */
+    uint64_t event_sequence_ QUARISMA_GUARDED_BY(shared_mu_) = 0;
+
     /**
      * @brief Current logging verbosity level.
      *
@@ -864,6 +1035,48 @@ private:
      * **Usage**: Cache invalidation and update scheduling
      */
     mutable std::atomic<int64_t> last_fragmentation_update_{0};
+
+    // ========== Sampling Mode ==========
+
+    /**
+     * @brief Mean allocated bytes between two samples; 0 when every
+     * allocation is tracked.
+     */
+    const size_t sample_interval_bytes_{0};
+
+    /** Capacity of the sample buffer of each thread. */
+    const size_t thread_buffer_records_{0};
+
+    /** Identifies the tracker in the sample buffer slots of the threads. */
+    const uint64_t instance_id_{0};
+
+    /**
+     * @brief Sample buffers of every thread that used the tracker.
+     *
+     * Shared with the threads' slots, so that buffers outlive either side;
+     * buffers of exited threads are kept for their counters and samples.
+     */
+    mutable std::mutex                         sample_buffers_mutex_;
+    std::vector<std::shared_ptr<SampleBuffer>> sample_buffers_ QUARISMA_GUARDED_BY(
+        sample_buffers_mutex_);
+
+    /**
+     * @brief Open addressing table of the live samples, by pointer.
+     *
+     * A pointer hashes to one cache line of keys, so a deallocation checks
+     * whether it frees a sample with a single cache line read and no lock.
+     * Samples are dropped when their line is full.
+     */
+    std::unique_ptr<LiveBucket[]> live_buckets_;
+    std::unique_ptr<LiveSample[]> live_samples_;
+    size_t                        live_bucket_mask_{0};
+
+    std::atomic<int64_t> live_sample_count_{0};
+    std::atomic<int64_t> live_requested_estimate_{0};
+    std::atomic<int64_t> live_allocated_estimate_{0};
+    std::atomic<int64_t> peak_allocated_estimate_{0};
+    std::atomic<int64_t> dropped_samples_{0};
+    std::atomic<int64_t> next_sample_id_{0};
 };
 
 }  // namespace quarisma
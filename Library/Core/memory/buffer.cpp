@@ -0,0 +1,179 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+#include "memory/cpu/allocator.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+//=============================================================================
+// buffer
+//=============================================================================
+
+buffer_ptr buffer::allocate(size_t size, Allocator* allocator, size_t alignment)
+{
+    if (allocator == nullptr)
+    {
+        allocator = cpu_allocator();
+    }
+    void* data = allocator->allocate_raw(alignment, size);
+    QUARISMA_CHECK(
+        data != nullptr || size == 0,
+        "{} could not allocate a buffer of {} bytes",
+        allocator->Name(),
+        size);
+    return make_intrusive<buffer>(
+        static_cast<uint8_t*>(data), size, alignment, allocator, deleter(), true);
+}
+
+buffer_ptr buffer::copy_of(const void* data, size_t size, Allocator* allocator)
+{
+    buffer_ptr result = allocate(size, allocator);
+    if (size > 0)
+    {
+        std::memcpy(result->mutable_data(), data, size);
+    }
+    return result;
+}
+
+buffer_ptr buffer::adopt(void* data, size_t size, deleter release)
+{
+    return make_intrusive<buffer>(
+        static_cast<uint8_t*>(data), size, size_t{1}, nullptr, std::move(release), true);
+}
+
+buffer_ptr buffer::wrap(const void* data, size_t size, deleter release)
+{
+    return make_intrusive<buffer>(
+        static_cast<uint8_t*>(const_cast<void*>(data)),
+        size,
+        size_t{1},
+        nullptr,
+        std::move(release),
+        false);
+}
+
+buffer::buffer(
+    uint8_t*   data,
+    size_t     size,
+    size_t     alignment,
+    Allocator* allocator,
+    deleter    release,
+    bool       writable) noexcept
+    : data_(data),
+      size_(size),
+      alignment_(alignment),
+      allocator_(allocator),
+      release_(std::move(release)),
+      writable_(writable)
+{
+}
+
+buffer::~buffer()
+{
+    if (allocator_ != nullptr)
+    {
+        if (data_ != nullptr)
+        {
+            allocator_->deallocate_raw(data_, alignment_, size_);
+        }
+    }
+    else if (release_)
+    {
+        release_(data_, size_);
+    }
+}
+
+//=============================================================================
+// buffer_view
+//=============================================================================
+
+buffer_view::buffer_view(buffer_ptr source) noexcept
+    : source_(std::move(source)), length_(source_ ? source_->size() : 0)
+{
+}
+
+buffer_view::buffer_view(buffer_ptr source, size_t offset, size_t length)
+    : source_(std::move(source)), offset_(offset), length_(length)
+{
+    QUARISMA_CHECK(
+        source_ != nullptr ? offset <= source_->size() && length <= source_->size() - offset
+                           : offset == 0 && length == 0,
+        "view of {} bytes from {} exceeds a buffer of {}",
+        length,
+        offset,
+        source_ != nullptr ? source_->size() : 0);
+}
+
+uint8_t* buffer_view::mutable_data()
+{
+    make_unique();
+    return source_ ? source_->mutable_data() + offset_ : nullptr;
+}
+
+void buffer_view::make_unique()
+{
+    if (!source_)
+    {
+        return;
+    }
+    if (is_unique())
+    {
+        // Another view's reads finished before it dropped its reference (acq_rel)
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return;
+    }
+    *this = copy();
+}
+
+buffer_view buffer_view::copy() const
+{
+    if (!source_)
+    {
+        return {};
+    }
+    // From the original's Allocator; adopted and wrapped memory has none, so cpu_allocator()
+    size_t const alignment = std::max(source_->alignment(), QUARISMA_ALIGNMENT);
+    buffer_ptr   result    = buffer::allocate(length_, source_->allocator(), alignment);
+    if (length_ > 0)
+    {
+        std::memcpy(result->mutable_data(), data(), length_);
+    }
+    return buffer_view(std::move(result));
+}
+
+buffer_view buffer_view::slice(size_t offset, size_t length) const
+{
+    QUARISMA_CHECK(
+        offset <= length_ && length <= length_ - offset,
+        "slice of {} bytes from {} exceeds a view of {}",
+        length,
+        offset,
+        length_);
+    return buffer_view(source_, offset_ + offset, length);
+}
+
+}  // namespace quarisma
@@ -0,0 +1,186 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "common/export.h"
+#include "common/intrusive_ptr.h"
+#include "common/macros.h"
+
+namespace quarisma
+{
+class Allocator;
+
+/**
+ * @brief Reference-counted block of bytes that knows how to give itself back.
+ *
+ * A buffer holds memory from an Allocator, returned to that same Allocator
+ * when the last reference goes, or memory owned elsewhere together with a
+ * deleter. Buffers are not used directly but through buffer_view, which
+ * adds slicing and copy-on-write.
+ *
+ * **Thread Safety**: references may be taken and dropped from any thread;
+ * the bytes themselves are not synchronized.
+ */
+class QUARISMA_VISIBILITY buffer : public intrusive_ptr_target
+{
+public:
+    /** @brief Releases adopted memory; receives what was passed to adopt() or wrap(). */
+    using deleter = std::function<void(void* data, size_t size)>;
+
+    /**
+     * @brief `size` uninitialized bytes from `allocator`, cpu_allocator() when null.
+     * @throws quarisma::Error when the allocator is out of memory
+     */
+    QUARISMA_API static intrusive_ptr<buffer> allocate(
+        size_t size, Allocator* allocator = nullptr, size_t alignment = QUARISMA_ALIGNMENT);
+
+    /** @brief A copy of `size` bytes at `data`, allocated as by allocate(). */
+    QUARISMA_API static intrusive_ptr<buffer> copy_of(
+        const void* data, size_t size, Allocator* allocator = nullptr);
+
+    /** @brief Takes over writable memory; `release` frees it with the last reference. */
+    QUARISMA_API static intrusive_ptr<buffer> adopt(void* data, size_t size, deleter release);
+
+    /**
+     * @brief Read-only memory, e.g. a mapped file or a constant table.
+     *
+     * Views copy it before the first write. Without `release` the caller
+     * keeps the memory alive for as long as the buffer.
+     */
+    QUARISMA_API static intrusive_ptr<buffer> wrap(
+        const void* data, size_t size, deleter release = {});
+
+    QUARISMA_API buffer(
+        uint8_t*   data,
+        size_t     size,
+        size_t     alignment,
+        Allocator* allocator,
+        deleter    release,
+        bool       writable) noexcept;
+
+    QUARISMA_API ~buffer() override;
+
+    const uint8_t* data() const noexcept { return data_; }
+    uint8_t*       mutable_data() noexcept { return data_; }
+    size_t         size() const noexcept { return size_; }
+    size_t         alignment() const noexcept { return alignment_; }
+
+    /** @brief The Allocator the memory came from, or nullptr for adopted and wrapped memory. */
+    Allocator* allocator() const noexcept { return allocator_; }
+
+    /** @brief Whether the bytes may be written in place by their only holder. */
+    bool writable() const noexcept { return writable_; }
+
+private:
+    uint8_t*   data_;
+    size_t     size_;
+    size_t     alignment_;
+    Allocator* allocator_;
+    deleter    release_;
+    bool       writable_;
+};
+
+using buffer_ptr = intrusive_ptr<buffer>;
+
+/**
+ * @brief Slice of a shared buffer, copied on write.
+ *
+ * Copying or slicing a view only takes a reference to its buffer, so
+ * stages of a pipeline can pass arrays along without defensive copies.
+ * Reading is always in place. mutable_data() writes in place only while
+ * this view holds the one reference to a writable buffer; otherwise it
+ * first moves the view to a private copy of its bytes, allocated from the
+ * same Allocator, so no other holder ever sees the change.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * buffer_view prices(buffer::allocate(paths * sizeof(double)));
+ * auto        tail = prices.slice(half * sizeof(double));  // shares the bytes
+ * tail.mutable_values<double>()[0] = 0.0;                   // copies them first
+ * ```
+ *
+ * **Thread Safety**: distinct views of one buffer may be used from
+ * different threads; a single view may not be.
+ */
+class QUARISMA_VISIBILITY buffer_view
+{
+public:
+    buffer_view() = default;
+
+    /** @brief Views the whole of `source`. */
+    QUARISMA_API explicit buffer_view(buffer_ptr source) noexcept;
+
+    /** @brief Views `length` bytes of `source` from `offset`. */
+    QUARISMA_API buffer_view(buffer_ptr source, size_t offset, size_t length);
+
+    const uint8_t* data() const noexcept { return source_ ? source_->data() + offset_ : nullptr; }
+    size_t         size() const noexcept { return length_; }
+    bool           empty() const noexcept { return length_ == 0; }
+
+    template <typename T>
+    const T* values() const noexcept
+    {
+        return reinterpret_cast<const T*>(data());
+    }
+
+    /**
+     * @brief The bytes for writing, copied first unless this view owns them.
+     * @throws quarisma::Error when the copy cannot be allocated
+     */
+    QUARISMA_API uint8_t* mutable_data();
+
+    template <typename T>
+    T* mutable_values()
+    {
+        return reinterpret_cast<T*>(mutable_data());
+    }
+
+    /** @brief `length` bytes from `offset`, sharing the buffer. */
+    QUARISMA_API buffer_view slice(size_t offset, size_t length) const;
+
+    /** @brief The bytes from `offset` to the end, sharing the buffer. */
+    buffer_view slice(size_t offset) const { return slice(offset, length_ - offset); }
+
+    /** @brief Whether mutable_data() would write in place. */
+    bool is_unique() const noexcept
+    {
+        return source_ && source_->writable() && source_.unique();
+    }
+
+    /** @brief Makes this view the only holder of its bytes, copying when shared. */
+    QUARISMA_API void make_unique();
+
+    /** @brief A view of a private copy of the bytes. */
+    QUARISMA_API buffer_view copy() const;
+
+    size_t            offset() const noexcept { return offset_; }
+    const buffer_ptr& source() const noexcept { return source_; }
+
+private:
+    buffer_ptr source_;
+    size_t     offset_ = 0;
+    size_t     length_ = 0;
+};
+
+}  // namespace quarisma
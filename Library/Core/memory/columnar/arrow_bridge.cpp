@@ -0,0 +1,317 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/columnar/arrow_bridge.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace quarisma
+{
+namespace columnar
+{
+namespace
+{
+// Format strings of the C data interface, indexed by column_type
+constexpr const char* arrow_formats[column_type_count] = {
+    "c", "s", "i", "l", "C", "S", "I", "L", "f", "g"};
+
+std::optional<column_type> from_arrow_format(const char* format) noexcept
+{
+    if (format == nullptr)
+    {
+        return std::nullopt;
+    }
+    for (uint8_t i = 0; i < column_type_count; ++i)
+    {
+        if (std::strcmp(format, arrow_formats[i]) == 0)
+        {
+            return static_cast<column_type>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+//-----------------------------------------------------------------------------
+// Export: private_data keeps the buffers referenced until release
+//-----------------------------------------------------------------------------
+
+struct exported_column
+{
+    column_buffer_ptr values;
+    column_buffer_ptr validity;
+    const void*       buffers[2];
+};
+
+struct exported_batch
+{
+    std::vector<ArrowArray>  children;
+    std::vector<ArrowArray*> child_pointers;
+    const void*              buffers[1] = {nullptr};
+};
+
+struct exported_schema
+{
+    std::string               name;
+    std::vector<ArrowSchema>  children;
+    std::vector<ArrowSchema*> child_pointers;
+};
+
+void release_column_array(ArrowArray* array)
+{
+    delete static_cast<exported_column*>(array->private_data);
+    array->release = nullptr;
+}
+
+void release_batch_array(ArrowArray* array)
+{
+    auto* owned = static_cast<exported_batch*>(array->private_data);
+    for (auto& child : owned->children)
+    {
+        if (child.release != nullptr)
+        {
+            child.release(&child);
+        }
+    }
+    delete owned;
+    array->release = nullptr;
+}
+
+void release_schema(ArrowSchema* schema)
+{
+    auto* owned = static_cast<exported_schema*>(schema->private_data);
+    for (auto& child : owned->children)
+    {
+        if (child.release != nullptr)
+        {
+            child.release(&child);
+        }
+    }
+    delete owned;
+    schema->release = nullptr;
+}
+
+void fill_array(const column& values, ArrowArray* array)
+{
+    auto* owned   = new exported_column;
+    owned->values = values.values_buffer();
+    if (values.null_count() > 0)
+    {
+        owned->validity = values.validity_buffer();
+    }
+    owned->buffers[0] = owned->validity == nullptr ? nullptr : owned->validity->data();
+    owned->buffers[1] = owned->values->data();
+
+    array->length       = static_cast<int64_t>(values.length());
+    array->null_count   = static_cast<int64_t>(values.null_count());
+    array->offset       = static_cast<int64_t>(values.offset());
+    array->n_buffers    = 2;
+    array->n_children   = 0;
+    array->buffers      = owned->buffers;
+    array->children     = nullptr;
+    array->dictionary   = nullptr;
+    array->release      = release_column_array;
+    array->private_data = owned;
+}
+
+exported_schema* fill_schema(const char* format, std::string_view name, ArrowSchema* schema)
+{
+    auto* owned = new exported_schema{std::string(name), {}, {}};
+
+    schema->format       = format;
+    schema->name         = owned->name.c_str();
+    schema->metadata     = nullptr;
+    schema->flags        = ARROW_FLAG_NULLABLE;
+    schema->n_children   = 0;
+    schema->children     = nullptr;
+    schema->dictionary   = nullptr;
+    schema->release      = release_schema;
+    schema->private_data = owned;
+    return owned;
+}
+
+//-----------------------------------------------------------------------------
+// Import: the columns share one holder, which releases the array with them
+//-----------------------------------------------------------------------------
+
+struct imported_array : intrusive_ptr_target
+{
+    explicit imported_array(ArrowArray* source) : array(*source)
+    {
+        // Marks the source moved, as the interface specifies
+        source->release = nullptr;
+    }
+
+    ~imported_array() override
+    {
+        if (array.release != nullptr)
+        {
+            array.release(&array);
+        }
+    }
+
+    ArrowArray array;
+};
+
+bool importable(const ArrowArray& array, const ArrowSchema& schema) noexcept
+{
+    if (array.release == nullptr || !from_arrow_format(schema.format) || array.n_buffers != 2 ||
+        array.n_children != 0 || array.dictionary != nullptr || schema.dictionary != nullptr ||
+        array.length < 0 || array.offset < 0)
+    {
+        return false;
+    }
+    // Buffers may only be missing when they would be empty
+    return array.buffers[1] != nullptr || array.offset + array.length == 0;
+}
+
+// Values [extra_offset, extra_offset + length) of a validated primitive array
+column make_column(
+    const ArrowArray&                          array,
+    const ArrowSchema&                         schema,
+    size_t                                     extra_offset,
+    size_t                                     length,
+    const intrusive_ptr<intrusive_ptr_target>& holder)
+{
+    column_type const type   = *from_arrow_format(schema.format);
+    size_t const      offset = static_cast<size_t>(array.offset) + extra_offset;
+    size_t const      end    = offset + length;
+
+    column_buffer_ptr values = array.buffers[1] == nullptr
+                                   ? column_buffer::allocate(0)
+                                   : column_buffer::wrap(
+                                         array.buffers[1], end * column_type_size(type), holder);
+    column_buffer_ptr validity;
+    if (array.buffers[0] != nullptr && array.null_count != 0)
+    {
+        validity = column_buffer::wrap(array.buffers[0], (end + 7) / 8, holder);
+    }
+
+    bool const whole      = extra_offset == 0 && length == static_cast<size_t>(array.length);
+    int64_t    null_count = whole ? array.null_count : -1;
+    return column(type, length, std::move(values), std::move(validity), null_count, offset);
+}
+}  // namespace
+
+void export_column(
+    const column& values, std::string_view name, ArrowArray* array, ArrowSchema* schema)
+{
+    fill_array(values, array);
+    fill_schema(arrow_formats[static_cast<uint8_t>(values.type())], name, schema);
+}
+
+void export_record_batch(const record_batch& batch, ArrowArray* array, ArrowSchema* schema)
+{
+    size_t const count = batch.num_columns();
+
+    auto* owned = new exported_batch;
+    owned->children.resize(count);
+    owned->child_pointers.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        fill_array(batch.get(i), &owned->children[i]);
+        owned->child_pointers[i] = &owned->children[i];
+    }
+    array->length       = static_cast<int64_t>(batch.num_rows());
+    array->null_count   = 0;
+    array->offset       = 0;
+    array->n_buffers    = 1;
+    array->n_children   = static_cast<int64_t>(count);
+    array->buffers      = owned->buffers;
+    array->children     = owned->child_pointers.data();
+    array->dictionary   = nullptr;
+    array->release      = release_batch_array;
+    array->private_data = owned;
+
+    exported_schema* schema_owned = fill_schema("+s", "", schema);
+    schema->flags                 = 0;
+    schema_owned->children.resize(count);
+    schema_owned->child_pointers.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        char const* format = arrow_formats[static_cast<uint8_t>(batch.get(i).type())];
+        fill_schema(format, batch.name(i), &schema_owned->children[i]);
+        schema_owned->child_pointers[i] = &schema_owned->children[i];
+    }
+    schema->n_children = static_cast<int64_t>(count);
+    schema->children   = schema_owned->child_pointers.data();
+}
+
+std::optional<column> import_column(ArrowArray* array, const ArrowSchema& schema)
+{
+    if (array == nullptr || !importable(*array, schema))
+    {
+        return std::nullopt;
+    }
+    auto holder = make_intrusive<imported_array>(array);
+    return make_column(
+        holder->array,
+        schema,
+        0,
+        static_cast<size_t>(holder->array.length),
+        intrusive_ptr<intrusive_ptr_target>(holder));
+}
+
+std::optional<record_batch> import_record_batch(ArrowArray* array, const ArrowSchema& schema)
+{
+    if (array == nullptr || array->release == nullptr || schema.format == nullptr ||
+        std::strcmp(schema.format, "+s") != 0 || array->n_children != schema.n_children ||
+        array->length < 0 || array->offset < 0 || array->null_count != 0)
+    {
+        return std::nullopt;
+    }
+
+    size_t const offset = static_cast<size_t>(array->offset);
+    size_t const length = static_cast<size_t>(array->length);
+    for (int64_t i = 0; i < array->n_children; ++i)
+    {
+        ArrowArray const&  child        = *array->children[i];
+        ArrowSchema const& child_schema = *schema.children[i];
+        if (!importable(child, child_schema) ||
+            static_cast<size_t>(child.length) < offset + length || child_schema.name == nullptr)
+        {
+            return std::nullopt;
+        }
+        for (int64_t j = 0; j < i; ++j)
+        {
+            if (std::strcmp(child_schema.name, schema.children[j]->name) == 0)
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    // The children are released with the parent, so one holder keeps them all
+    auto holder = make_intrusive<imported_array>(array);
+    intrusive_ptr<intrusive_ptr_target> owner(holder);
+
+    record_batch batch;
+    for (int64_t i = 0; i < holder->array.n_children; ++i)
+    {
+        batch.add(
+            schema.children[i]->name,
+            make_column(*holder->array.children[i], *schema.children[i], offset, length, owner));
+    }
+    return batch;
+}
+
+}  // namespace columnar
+}  // namespace quarisma
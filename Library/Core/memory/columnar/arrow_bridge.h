@@ -0,0 +1,114 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "common/export.h"
+#include "memory/columnar/column.h"
+
+// The structures of the Arrow C data interface, as its specification has
+// consumers copy them; the guard avoids a clash with Arrow's own headers.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+    const char*   format;
+    const char*   name;
+    const char*   metadata;
+    int64_t       flags;
+    int64_t       n_children;
+    ArrowSchema** children;
+    ArrowSchema*  dictionary;
+    void (*release)(ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    int64_t      length;
+    int64_t      null_count;
+    int64_t      offset;
+    int64_t      n_buffers;
+    int64_t      n_children;
+    const void** buffers;
+    ArrowArray** children;
+    ArrowArray*  dictionary;
+    void (*release)(ArrowArray*);
+    void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace quarisma
+{
+namespace columnar
+{
+/**
+ * @brief Zero-copy exchange of columns and batches with Arrow.
+ *
+ * Exported arrays point at the buffers of the column, which they keep
+ * alive until the consumer calls their release callback; pyarrow's
+ * `Array._import_from_c` or `RecordBatch._import_from_c`, or Arrow C++'s
+ * `arrow::ImportRecordBatch`, take them without copying. Imported columns
+ * likewise view the producer's buffers and release the array with the
+ * last of them.
+ *
+ * Only fixed-width primitive arrays (and, for batches, struct arrays of
+ * them) map to columns; importing anything else returns nullopt and leaves
+ * the array to the caller.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * ArrowArray  array;
+ * ArrowSchema schema;
+ * columnar::export_record_batch(results, &array, &schema);
+ * // hand &array and &schema to Python, which now owns them
+ * ```
+ */
+
+/** @brief Exports `values` as a primitive array named `name`. */
+QUARISMA_API void export_column(
+    const column& values, std::string_view name, ArrowArray* array, ArrowSchema* schema);
+
+/** @brief Exports `batch` as a struct array, one child per column. */
+QUARISMA_API void export_record_batch(
+    const record_batch& batch, ArrowArray* array, ArrowSchema* schema);
+
+/**
+ * @brief Imports a primitive array, taking ownership of `array` on success.
+ *
+ * `schema` is only read; the caller still releases it.
+ */
+QUARISMA_API std::optional<column> import_column(ArrowArray* array, const ArrowSchema& schema);
+
+/** @brief Imports a struct array of primitive arrays, taking ownership of `array` on success. */
+QUARISMA_API std::optional<record_batch> import_record_batch(
+    ArrowArray* array, const ArrowSchema& schema);
+
+}  // namespace columnar
+}  // namespace quarisma
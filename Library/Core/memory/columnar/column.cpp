@@ -0,0 +1,312 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/columnar/column.h"
+
+#include <cstring>
+
+#include "memory/allocator.h"
+
+namespace quarisma
+{
+namespace columnar
+{
+namespace
+{
+using buffer_allocator = allocator<uint8_t, column_buffer::alignment>;
+
+size_t padded_size(size_t size) noexcept
+{
+    return (size + column_buffer::alignment - 1) & ~(column_buffer::alignment - 1);
+}
+
+int popcount(uint8_t byte) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(byte);
+#else
+    int count = 0;
+    for (; byte != 0; byte &= static_cast<uint8_t>(byte - 1))
+    {
+        ++count;
+    }
+    return count;
+#endif
+}
+}  // namespace
+
+size_t column_type_size(column_type type) noexcept
+{
+    switch (type)
+    {
+    case column_type::INT8:
+    case column_type::UINT8:
+        return 1;
+    case column_type::INT16:
+    case column_type::UINT16:
+        return 2;
+    case column_type::INT32:
+    case column_type::UINT32:
+    case column_type::FLOAT32:
+        return 4;
+    case column_type::INT64:
+    case column_type::UINT64:
+    case column_type::FLOAT64:
+        return 8;
+    }
+    return 0;
+}
+
+const char* column_type_name(column_type type) noexcept
+{
+    switch (type)
+    {
+    case column_type::INT8:
+        return "int8";
+    case column_type::INT16:
+        return "int16";
+    case column_type::INT32:
+        return "int32";
+    case column_type::INT64:
+        return "int64";
+    case column_type::UINT8:
+        return "uint8";
+    case column_type::UINT16:
+        return "uint16";
+    case column_type::UINT32:
+        return "uint32";
+    case column_type::UINT64:
+        return "uint64";
+    case column_type::FLOAT32:
+        return "float32";
+    case column_type::FLOAT64:
+        return "float64";
+    }
+    return "unknown";
+}
+
+namespace detail
+{
+size_t count_set_bits(const uint8_t* bits, size_t offset, size_t length) noexcept
+{
+    size_t count = 0;
+    size_t i     = offset;
+    size_t end   = offset + length;
+    for (; i < end && i % 8 != 0; ++i)
+    {
+        count += (bits[i / 8] >> (i % 8)) & 1;
+    }
+    for (; i + 8 <= end; i += 8)
+    {
+        count += static_cast<size_t>(popcount(bits[i / 8]));
+    }
+    for (; i < end; ++i)
+    {
+        count += (bits[i / 8] >> (i % 8)) & 1;
+    }
+    return count;
+}
+
+void copy_bits(const uint8_t* source, size_t offset, size_t length, uint8_t* destination) noexcept
+{
+    size_t const bytes = (length + 7) / 8;
+    if (offset % 8 == 0)
+    {
+        std::memcpy(destination, source + offset / 8, bytes);
+    }
+    else
+    {
+        size_t const   shift = offset % 8;
+        const uint8_t* from  = source + offset / 8;
+        size_t const   last  = (offset + length - 1) / 8 - offset / 8;
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            unsigned const high = i + 1 <= last ? from[i + 1] : 0u;
+            destination[i]      = static_cast<uint8_t>((from[i] >> shift) | (high << (8 - shift)));
+        }
+    }
+    // Arrow leaves the bits past the end unspecified; clear them for stable checksums
+    if (length % 8 != 0)
+    {
+        destination[bytes - 1] &= static_cast<uint8_t>((1u << (length % 8)) - 1);
+    }
+}
+}  // namespace detail
+
+//=============================================================================
+// column_buffer
+//=============================================================================
+
+intrusive_ptr<column_buffer> column_buffer::allocate(size_t size)
+{
+    size_t const capacity = padded_size(size == 0 ? 1 : size);
+    uint8_t*     data     = buffer_allocator::allocate(capacity);
+    std::memset(data + size, 0, capacity - size);
+    return make_intrusive<column_buffer>(data, size, intrusive_ptr<intrusive_ptr_target>());
+}
+
+intrusive_ptr<column_buffer> column_buffer::wrap(
+    const void* data, size_t size, intrusive_ptr<intrusive_ptr_target> owner)
+{
+    QUARISMA_CHECK(owner != nullptr, "a column_buffer view needs an owner to keep it alive");
+    return make_intrusive<column_buffer>(
+        static_cast<uint8_t*>(const_cast<void*>(data)), size, std::move(owner));
+}
+
+column_buffer::~column_buffer()
+{
+    if (owns_memory())
+    {
+        uint8_t* data = data_.data();
+        buffer_allocator::free(data);
+    }
+}
+
+//=============================================================================
+// column
+//=============================================================================
+
+column::column(
+    column_type       type,
+    size_t            length,
+    column_buffer_ptr values,
+    column_buffer_ptr validity,
+    int64_t           null_count,
+    size_t            offset)
+    : type_(type),
+      length_(length),
+      offset_(offset),
+      values_(std::move(values)),
+      validity_(std::move(validity))
+{
+    QUARISMA_CHECK(static_cast<uint8_t>(type) < column_type_count, "unknown column type");
+    QUARISMA_CHECK(values_ != nullptr, "a column needs a values buffer");
+    QUARISMA_CHECK(
+        values_->size() >= (offset + length) * column_type_size(type),
+        "a values buffer of {} bytes cannot hold {} {} values",
+        values_->size(),
+        offset + length,
+        column_type_name(type));
+    QUARISMA_CHECK(
+        validity_ == nullptr || validity_->size() * 8 >= offset + length,
+        "a validity bitmap of {} bytes cannot hold {} bits",
+        validity_ == nullptr ? 0 : validity_->size(),
+        offset + length);
+
+    if (validity_ == nullptr)
+    {
+        null_count_ = 0;
+    }
+    else if (null_count < 0)
+    {
+        null_count_ = length - detail::count_set_bits(validity_->data(), offset, length);
+    }
+    else
+    {
+        null_count_ = static_cast<size_t>(null_count);
+    }
+}
+
+void column::set_valid(size_t i, bool valid)
+{
+    QUARISMA_CHECK(i < length_, "value {} of a column of {}", i, length_);
+    if (validity_ == nullptr)
+    {
+        if (valid)
+        {
+            return;
+        }
+        validity_ = column_buffer::allocate((offset_ + length_ + 7) / 8);
+        std::memset(validity_->mutable_data(), 0xff, validity_->size());
+    }
+
+    size_t const bit  = offset_ + i;
+    uint8_t&     byte = validity_->mutable_data()[bit / 8];
+    bool const   was  = ((byte >> (bit % 8)) & 1) != 0;
+    if (was == valid)
+    {
+        return;
+    }
+    byte        = static_cast<uint8_t>(byte ^ (1u << (bit % 8)));
+    null_count_ = valid ? null_count_ - 1 : null_count_ + 1;
+}
+
+column column::slice(size_t offset, size_t length) const
+{
+    QUARISMA_CHECK(
+        offset + length <= length_,
+        "slice [{}, {}) of a column of {}",
+        offset,
+        offset + length,
+        length_);
+    return column(type_, length, values_, validity_, null_count_ == 0 ? 0 : -1, offset_ + offset);
+}
+
+void column::check_type(column_type expected) const
+{
+    QUARISMA_CHECK(
+        expected == type_,
+        "{} values requested from a {} column",
+        column_type_name(expected),
+        column_type_name(type_));
+}
+
+//=============================================================================
+// record_batch
+//=============================================================================
+
+void record_batch::add(std::string name, column values)
+{
+    QUARISMA_CHECK(
+        columns_.empty() || values.length() == rows_,
+        "column {} has {} rows, the batch {}",
+        name,
+        values.length(),
+        rows_);
+    QUARISMA_CHECK(find(name) == nullptr, "the batch already has a column {}", name);
+    rows_ = values.length();
+    names_.push_back(std::move(name));
+    columns_.push_back(std::move(values));
+}
+
+const column* record_batch::find(std::string_view name) const noexcept
+{
+    for (size_t i = 0; i < names_.size(); ++i)
+    {
+        if (names_[i] == name)
+        {
+            return &columns_[i];
+        }
+    }
+    return nullptr;
+}
+
+record_batch record_batch::slice(size_t offset, size_t length) const
+{
+    record_batch result;
+    for (size_t i = 0; i < columns_.size(); ++i)
+    {
+        result.add(names_[i], columns_[i].slice(offset, length));
+    }
+    result.rows_ = length;
+    return result;
+}
+
+}  // namespace columnar
+}  // namespace quarisma
@@ -0,0 +1,285 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/export.h"
+#include "common/intrusive_ptr.h"
+#include "memory/data_ptr.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace columnar
+{
+/**
+ * @brief Type of the values of a column, each a fixed-width Arrow primitive type.
+ */
+enum class column_type : uint8_t
+{
+    INT8    = 0,
+    INT16   = 1,
+    INT32   = 2,
+    INT64   = 3,
+    UINT8   = 4,
+    UINT16  = 5,
+    UINT32  = 6,
+    UINT64  = 7,
+    FLOAT32 = 8,
+    FLOAT64 = 9
+};
+
+inline constexpr uint8_t column_type_count = 10;
+
+/** @brief Bytes of one value of `type`. */
+QUARISMA_API size_t column_type_size(column_type type) noexcept;
+
+QUARISMA_API const char* column_type_name(column_type type) noexcept;
+
+namespace detail
+{
+template <typename T>
+struct column_type_of;
+
+#define QUARISMA_COLUMN_TYPE_OF(value_type, enum_value)                \
+    template <>                                                        \
+    struct column_type_of<value_type>                                  \
+    {                                                                  \
+        static constexpr column_type value = column_type::enum_value;  \
+    };
+
+QUARISMA_COLUMN_TYPE_OF(int8_t, INT8)
+QUARISMA_COLUMN_TYPE_OF(int16_t, INT16)
+QUARISMA_COLUMN_TYPE_OF(int32_t, INT32)
+QUARISMA_COLUMN_TYPE_OF(int64_t, INT64)
+QUARISMA_COLUMN_TYPE_OF(uint8_t, UINT8)
+QUARISMA_COLUMN_TYPE_OF(uint16_t, UINT16)
+QUARISMA_COLUMN_TYPE_OF(uint32_t, UINT32)
+QUARISMA_COLUMN_TYPE_OF(uint64_t, UINT64)
+QUARISMA_COLUMN_TYPE_OF(float, FLOAT32)
+QUARISMA_COLUMN_TYPE_OF(double, FLOAT64)
+
+#undef QUARISMA_COLUMN_TYPE_OF
+
+/** @brief Set bits among `length` bits of `bits` from bit `offset`. */
+QUARISMA_API size_t count_set_bits(const uint8_t* bits, size_t offset, size_t length) noexcept;
+
+/** @brief Copies `length` bits of `source` from bit `offset` to the start of `destination`. */
+QUARISMA_API void copy_bits(
+    const uint8_t* source, size_t offset, size_t length, uint8_t* destination) noexcept;
+}  // namespace detail
+
+/** @brief column_type of the C++ type T, e.g. column_type::FLOAT64 for double. */
+template <typename T>
+inline constexpr column_type column_type_of = detail::column_type_of<std::remove_cv_t<T>>::value;
+
+/**
+ * @brief Reference-counted bytes shared by columns, batches and other processes.
+ *
+ * A buffer either owns memory allocated by allocate(), aligned to 64 bytes
+ * and padded to a multiple of 64 as Arrow recommends, or views memory kept
+ * alive by an owner, e.g. a mapped file or an imported Arrow array. Copying
+ * a column or a batch only copies references to its buffers.
+ */
+class QUARISMA_VISIBILITY column_buffer : public intrusive_ptr_target
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    /** @brief Allocates `size` bytes; the padding after them is zeroed. */
+    QUARISMA_API static intrusive_ptr<column_buffer> allocate(size_t size);
+
+    /** @brief Views `size` bytes at `data`, which `owner` keeps alive. */
+    QUARISMA_API static intrusive_ptr<column_buffer> wrap(
+        const void* data, size_t size, intrusive_ptr<intrusive_ptr_target> owner);
+
+    QUARISMA_API ~column_buffer() override;
+
+    const uint8_t* data() const noexcept { return data_.data(); }
+    uint8_t*       mutable_data() noexcept { return data_.data(); }
+    size_t         size() const noexcept { return data_.size(); }
+
+    /** @brief Whether the memory belongs to the buffer rather than to an owner. */
+    bool owns_memory() const noexcept { return owner_ == nullptr; }
+
+    column_buffer(uint8_t* data, size_t size, intrusive_ptr<intrusive_ptr_target> owner) noexcept
+        : data_(data, size, device_enum::CPU), owner_(std::move(owner))
+    {
+    }
+
+private:
+    data_ptr<uint8_t, false>            data_;
+    intrusive_ptr<intrusive_ptr_target> owner_;
+};
+
+using column_buffer_ptr = intrusive_ptr<column_buffer>;
+
+/**
+ * @brief Values of one column, laid out as an Arrow primitive array.
+ *
+ * The values are contiguous in a values buffer; an optional validity
+ * bitmap holds one bit per value, least significant bit first, cleared for
+ * nulls. Both are indexed from offset(), so slice() shares the buffers of
+ * the column it is taken from.
+ *
+ * Buffers are shared, not copied on write: mutable_values() writes through
+ * to every column and batch holding them.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * auto prices = columnar::column::allocate<double>(paths);
+ * std::copy(results.begin(), results.end(), prices.mutable_values<double>());
+ * prices.set_valid(failed_path, false);
+ * ```
+ */
+class QUARISMA_VISIBILITY column
+{
+public:
+    column() = default;
+
+    /**
+     * @brief A column over existing buffers.
+     *
+     * `values` must hold offset + length values of `type` and `validity`,
+     * when present, offset + length bits.
+     * @param null_count Nulls among the `length` values, or -1 to count them
+     */
+    QUARISMA_API column(
+        column_type       type,
+        size_t            length,
+        column_buffer_ptr values,
+        column_buffer_ptr validity   = {},
+        int64_t           null_count = -1,
+        size_t            offset     = 0);
+
+    /** @brief A column of `length` uninitialized values, all valid. */
+    template <typename T>
+    static column allocate(size_t length)
+    {
+        return column(column_type_of<T>, length, column_buffer::allocate(length * sizeof(T)));
+    }
+
+    /** @brief A column holding a copy of `values`. */
+    template <typename T>
+    static column copy_of(const T* values, size_t length)
+    {
+        column result = allocate<T>(length);
+        std::copy(values, values + length, result.mutable_values<T>());
+        return result;
+    }
+
+    template <typename T>
+    static column copy_of(const std::vector<T>& values)
+    {
+        return copy_of(values.data(), values.size());
+    }
+
+    column_type type() const noexcept { return type_; }
+    size_t      length() const noexcept { return length_; }
+    size_t      offset() const noexcept { return offset_; }
+    size_t      null_count() const noexcept { return null_count_; }
+
+    const column_buffer_ptr& values_buffer() const noexcept { return values_; }
+    const column_buffer_ptr& validity_buffer() const noexcept { return validity_; }
+
+    bool is_valid(size_t i) const noexcept
+    {
+        size_t const bit = offset_ + i;
+        return validity_ == nullptr || ((validity_->data()[bit / 8] >> (bit % 8)) & 1) != 0;
+    }
+
+    /** @brief Marks value `i` valid or null, adding a validity bitmap on the first null. */
+    QUARISMA_API void set_valid(size_t i, bool valid);
+
+    /** @brief The values, from offset(); T must match type(). */
+    template <typename T>
+    const T* values() const
+    {
+        check_type(column_type_of<T>);
+        return reinterpret_cast<const T*>(values_->data()) + offset_;
+    }
+
+    template <typename T>
+    T* mutable_values()
+    {
+        check_type(column_type_of<T>);
+        return reinterpret_cast<T*>(values_->mutable_data()) + offset_;
+    }
+
+    /** @brief `length` values from `offset`, sharing the buffers. */
+    QUARISMA_API column slice(size_t offset, size_t length) const;
+
+private:
+    QUARISMA_API void check_type(column_type expected) const;
+
+    column_type       type_       = column_type::FLOAT64;
+    size_t            length_     = 0;
+    size_t            offset_     = 0;
+    size_t            null_count_ = 0;
+    column_buffer_ptr values_;
+    column_buffer_ptr validity_;
+};
+
+/**
+ * @brief Named columns of equal length, an Arrow record batch.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * columnar::record_batch batch;
+ * batch.add("path", columnar::column::copy_of(path_ids));
+ * batch.add("pv", columnar::column::copy_of(pvs));
+ * columnar::write_file(batch, "/dev/shm/scenario_42.qcol");
+ * ```
+ */
+class QUARISMA_VISIBILITY record_batch
+{
+public:
+    /** @brief Appends a column; its length must match those already added. */
+    QUARISMA_API void add(std::string name, column values);
+
+    size_t num_columns() const noexcept { return columns_.size(); }
+    size_t num_rows() const noexcept { return rows_; }
+
+    const column&      get(size_t i) const { return columns_.at(i); }
+    column&            get(size_t i) { return columns_.at(i); }
+    const std::string& name(size_t i) const { return names_.at(i); }
+
+    /** @brief The column called `name`, or nullptr. */
+    QUARISMA_API const column* find(std::string_view name) const noexcept;
+
+    /** @brief `length` rows from `offset` of every column, sharing the buffers. */
+    QUARISMA_API record_batch slice(size_t offset, size_t length) const;
+
+private:
+    std::vector<std::string> names_;
+    std::vector<column>      columns_;
+    size_t                   rows_ = 0;
+};
+
+}  // namespace columnar
+}  // namespace quarisma
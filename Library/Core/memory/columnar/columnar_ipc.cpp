@@ -0,0 +1,289 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/columnar/columnar_ipc.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "memory/backend/allocator_mmap.h"
+#include "util/hash.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the columnar format is little-endian and read in place"
+#endif
+
+namespace quarisma
+{
+namespace columnar
+{
+namespace
+{
+constexpr char     magic[4]       = {'Q', 'C', 'O', 'L'};
+constexpr uint16_t format_version = 1;
+constexpr size_t   body_alignment = column_buffer::alignment;
+
+struct file_header
+{
+    char     magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t column_count;
+    uint32_t metadata_crc;
+    uint64_t row_count;
+    uint64_t metadata_bytes;
+};
+static_assert(sizeof(file_header) == 32, "the header is 32 bytes on disk");
+
+struct column_entry
+{
+    uint8_t  type;
+    uint8_t  has_validity;
+    uint16_t name_length;
+    uint32_t reserved;
+    uint64_t null_count;
+    uint64_t validity_offset;
+    uint64_t values_offset;
+};
+static_assert(sizeof(column_entry) == 32, "a column entry is 32 bytes on disk");
+
+constexpr size_t align_up(size_t size, size_t alignment) noexcept
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+size_t values_bytes(column_type type, size_t rows) noexcept
+{
+    return rows * column_type_size(type);
+}
+
+size_t bitmap_bytes(size_t rows) noexcept
+{
+    return (rows + 7) / 8;
+}
+
+// Where serialize() puts everything, shared with serialized_size()
+struct layout
+{
+    std::vector<column_entry> entries;
+    size_t                    metadata_bytes = 0;
+    size_t                    total_bytes    = 0;
+};
+
+layout make_layout(const record_batch& batch)
+{
+    QUARISMA_CHECK(batch.num_columns() <= UINT32_MAX, "too many columns to serialize");
+
+    layout result;
+    result.entries.resize(batch.num_columns());
+    for (size_t i = 0; i < batch.num_columns(); ++i)
+    {
+        QUARISMA_CHECK(
+            batch.name(i).size() <= UINT16_MAX, "the name of column {} is too long", i);
+        result.metadata_bytes += sizeof(column_entry) + align_up(batch.name(i).size(), 8);
+    }
+
+    size_t       offset = align_up(sizeof(file_header) + result.metadata_bytes, body_alignment);
+    size_t const rows   = batch.num_rows();
+    for (size_t i = 0; i < batch.num_columns(); ++i)
+    {
+        column const& values = batch.get(i);
+        column_entry& entry  = result.entries[i];
+        entry.type           = static_cast<uint8_t>(values.type());
+        entry.name_length    = static_cast<uint16_t>(batch.name(i).size());
+        entry.null_count     = values.null_count();
+
+        // A bitmap without nulls carries nothing
+        if (values.null_count() > 0)
+        {
+            entry.has_validity    = 1;
+            entry.validity_offset = offset;
+            offset += align_up(bitmap_bytes(rows), body_alignment);
+        }
+        entry.values_offset = offset;
+        offset += align_up(values_bytes(values.type(), rows), body_alignment);
+    }
+    result.total_bytes = offset;
+    return result;
+}
+
+// Keeps a mapped file alive for the buffers viewing it
+struct mapped_file : intrusive_ptr_target
+{
+    explicit mapped_file(mmap_buffer mapping) : buffer(std::move(mapping)) {}
+
+    mmap_buffer buffer;
+};
+}  // namespace
+
+size_t serialized_size(const record_batch& batch)
+{
+    return make_layout(batch).total_bytes;
+}
+
+void serialize(const record_batch& batch, void* output)
+{
+    layout const plan  = make_layout(batch);
+    auto*        bytes = static_cast<uint8_t*>(output);
+    size_t const rows  = batch.num_rows();
+
+    // Zeroes the reserved fields and every padding byte
+    std::memset(bytes, 0, plan.total_bytes);
+
+    uint8_t* metadata = bytes + sizeof(file_header);
+    uint8_t* cursor   = metadata;
+    for (size_t i = 0; i < batch.num_columns(); ++i)
+    {
+        column const&       values = batch.get(i);
+        column_entry const& entry  = plan.entries[i];
+        std::memcpy(cursor, &entry, sizeof(entry));
+        std::memcpy(cursor + sizeof(entry), batch.name(i).data(), entry.name_length);
+        cursor += sizeof(entry) + align_up(entry.name_length, 8);
+
+        if (entry.has_validity != 0)
+        {
+            detail::copy_bits(
+                values.validity_buffer()->data(),
+                values.offset(),
+                rows,
+                bytes + entry.validity_offset);
+        }
+        size_t const width = column_type_size(values.type());
+        std::memcpy(
+            bytes + entry.values_offset,
+            values.values_buffer()->data() + values.offset() * width,
+            rows * width);
+    }
+
+    file_header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version        = format_version;
+    header.column_count   = static_cast<uint32_t>(batch.num_columns());
+    header.metadata_crc   = crc32c(metadata, plan.metadata_bytes);
+    header.row_count      = rows;
+    header.metadata_bytes = plan.metadata_bytes;
+    std::memcpy(bytes, &header, sizeof(header));
+}
+
+void write_file(const record_batch& batch, const std::string& path)
+{
+    // A writable mapping keeps a longer file's tail, so start from an empty one
+    std::remove(path.c_str());
+
+    mmap_buffer::Options opts;
+    opts.writable = true;
+    opts.size     = serialized_size(batch);
+    opts.access   = mmap_access::SEQUENTIAL;
+    auto mapping  = mmap_buffer::open(path, opts);
+    serialize(batch, mapping.data());
+}
+
+std::optional<record_batch> read(
+    const void* data, size_t size, intrusive_ptr<intrusive_ptr_target> owner)
+{
+    auto const* bytes = static_cast<const uint8_t*>(data);
+    if (size < sizeof(file_header) || reinterpret_cast<uintptr_t>(data) % 8 != 0)
+    {
+        return std::nullopt;
+    }
+
+    file_header header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+        header.version != format_version || header.metadata_bytes % 8 != 0 ||
+        header.metadata_bytes > size - sizeof(file_header) || header.row_count > size ||
+        header.column_count > header.metadata_bytes / sizeof(column_entry))
+    {
+        return std::nullopt;
+    }
+    const uint8_t* metadata = bytes + sizeof(file_header);
+    if (crc32c(metadata, header.metadata_bytes) != header.metadata_crc)
+    {
+        return std::nullopt;
+    }
+
+    size_t const   rows   = header.row_count;
+    const uint8_t* cursor = metadata;
+    const uint8_t* end    = metadata + header.metadata_bytes;
+    auto const     fits   = [size](uint64_t offset, size_t bytes_needed)
+    { return offset % body_alignment == 0 && offset <= size && bytes_needed <= size - offset; };
+
+    record_batch batch;
+    for (uint32_t i = 0; i < header.column_count; ++i)
+    {
+        column_entry entry;
+        if (static_cast<size_t>(end - cursor) < sizeof(entry))
+        {
+            return std::nullopt;
+        }
+        std::memcpy(&entry, cursor, sizeof(entry));
+        size_t const name_bytes = align_up(entry.name_length, 8);
+        if (static_cast<size_t>(end - cursor) - sizeof(entry) < name_bytes ||
+            entry.type >= column_type_count || entry.null_count > rows)
+        {
+            return std::nullopt;
+        }
+        std::string name(reinterpret_cast<const char*>(cursor + sizeof(entry)), entry.name_length);
+        cursor += sizeof(entry) + name_bytes;
+
+        auto const type = static_cast<column_type>(entry.type);
+        if (!fits(entry.values_offset, values_bytes(type, rows)) || batch.find(name) != nullptr)
+        {
+            return std::nullopt;
+        }
+        column_buffer_ptr values =
+            column_buffer::wrap(bytes + entry.values_offset, values_bytes(type, rows), owner);
+
+        column_buffer_ptr validity;
+        if (entry.has_validity != 0)
+        {
+            if (!fits(entry.validity_offset, bitmap_bytes(rows)))
+            {
+                return std::nullopt;
+            }
+            validity =
+                column_buffer::wrap(bytes + entry.validity_offset, bitmap_bytes(rows), owner);
+        }
+        batch.add(
+            std::move(name),
+            column(
+                type,
+                rows,
+                std::move(values),
+                std::move(validity),
+                static_cast<int64_t>(entry.null_count)));
+    }
+    return batch;
+}
+
+std::optional<record_batch> map_file(const std::string& path)
+{
+    // Pages are read as columns are touched, not up front
+    auto mapping = make_intrusive<mapped_file>(mmap_buffer::open(path));
+
+    void const*  data = mapping->buffer.data();
+    size_t const size = mapping->buffer.size();
+    return read(data, size, intrusive_ptr<intrusive_ptr_target>(std::move(mapping)));
+}
+
+}  // namespace columnar
+}  // namespace quarisma
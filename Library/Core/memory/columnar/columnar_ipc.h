@@ -0,0 +1,103 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "common/export.h"
+#include "memory/columnar/column.h"
+
+namespace quarisma
+{
+namespace columnar
+{
+/**
+ * @brief Memory-mappable serialization of a record_batch.
+ *
+ * The body follows the Arrow IPC body: every buffer starts on a 64-byte
+ * boundary and is padded to a multiple of 64, so a mapped file or shared
+ * memory segment is used in place. map_file() and read() parse only the
+ * metadata and return columns whose buffers point into the mapping, which
+ * stays mapped while any of them is alive.
+ *
+ * Layout, little-endian:
+ * - header (32 bytes): magic "QCOL", version (u16), 2 reserved bytes,
+ *   column count (u32), CRC-32C of the metadata (u32), row count (u64),
+ *   metadata bytes (u64);
+ * - metadata: per column, its column_type (u8), whether it has a validity
+ *   bitmap (u8), name length (u16), 4 reserved bytes, null count (u64),
+ *   offsets of the validity bitmap and of the values in the file (u64
+ *   each), then the name, padded to 8 bytes;
+ * - the buffers, each at a multiple of 64 bytes.
+ *
+ * The metadata is checksummed but the buffers are not, as checking them
+ * would read the whole file. Sliced columns are written from their offset.
+ * Arrow's own IPC metadata is a FlatBuffer; to exchange batches with Arrow
+ * itself, go through the C data interface in arrow_bridge.h.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * // Producer
+ * columnar::write_file(results, "/dev/shm/scenario_42.qcol");
+ *
+ * // Consumer, in another process
+ * auto results = columnar::map_file("/dev/shm/scenario_42.qcol");
+ * const double* pv = results->find("pv")->values<double>();
+ * ```
+ */
+
+/** @brief Bytes serialize() writes for `batch`, a multiple of 64. */
+QUARISMA_API size_t serialized_size(const record_batch& batch);
+
+/**
+ * @brief Writes `batch` to `output`, serialized_size() bytes.
+ *
+ * `output` should be aligned to 64 bytes, as a mapping is, for the buffers
+ * read back from it to be.
+ */
+QUARISMA_API void serialize(const record_batch& batch, void* output);
+
+/**
+ * @brief Writes `batch` to a new file at `path` through a writable mapping.
+ * @throws quarisma::Error when the file cannot be created or mapped
+ */
+QUARISMA_API void write_file(const record_batch& batch, const std::string& path);
+
+/**
+ * @brief A batch viewing serialized bytes in place.
+ *
+ * `data` must be aligned to 8 bytes and stay valid while `owner` is alive;
+ * every buffer of the batch holds a reference to `owner`.
+ * @return The batch, or nullopt if the bytes are not a valid serialization
+ */
+QUARISMA_API std::optional<record_batch> read(
+    const void* data, size_t size, intrusive_ptr<intrusive_ptr_target> owner);
+
+/**
+ * @brief Maps the file at `path` read-only and views it in place.
+ * @return The batch, or nullopt if the file is not a valid serialization
+ * @throws quarisma::Error when the file cannot be opened or mapped
+ */
+QUARISMA_API std::optional<record_batch> map_file(const std::string& path);
+
+}  // namespace columnar
+}  // namespace quarisma
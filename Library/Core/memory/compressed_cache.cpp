@@ -0,0 +1,270 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/compressed_cache.h"
+
+#include <utility>
+
+#include "compression/codec.h"
+
+namespace quarisma
+{
+
+compressed_cache::compressed_cache(options opts)
+    : resident_budget_(opts.resident_budget),
+      compressed_budget_(opts.compressed_budget),
+      codec_(
+          opts.codec != nullptr ? opts.codec
+                                : &compression::codec::select(compression::codec_preference::speed))
+{
+    if (!opts.name.empty())
+    {
+        pressure_id_ = memory_pressure::instance().register_cache(
+            std::move(opts.name),
+            memory_trim_cost::HIGH,
+            device_enum::CPU,
+            -1,
+            [this](size_t bytes_wanted) { return release(bytes_wanted); });
+    }
+}
+
+compressed_cache::~compressed_cache()
+{
+    if (pressure_id_ != 0)
+    {
+        memory_pressure::instance().unregister_cache(pressure_id_);
+    }
+}
+
+compressed_cache::buffer_type compressed_cache::put(key_type key, std::string data)
+{
+    auto buffer = std::make_shared<const std::string>(std::move(data));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        found = entries_.find(key);
+    if (found != entries_.end())
+    {
+        remove(key, found->second);
+    }
+
+    entry& e   = entries_[key];
+    e.resident = buffer;
+    e.size     = buffer->size();
+    resident_lru_.push_front(key);
+    e.position = resident_lru_.begin();
+    ++stats_.resident_entries;
+    stats_.resident_bytes += e.size;
+
+    enforce_budgets();
+    return buffer;
+}
+
+compressed_cache::buffer_type compressed_cache::put(key_type key, const void* data, size_t size)
+{
+    return put(key, std::string(static_cast<const char*>(data), size));
+}
+
+compressed_cache::buffer_type compressed_cache::get(key_type key)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto                         found = entries_.find(key);
+    if (found == entries_.end())
+    {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    entry& e = found->second;
+    if (e.resident)
+    {
+        ++stats_.resident_hits;
+        resident_lru_.splice(resident_lru_.begin(), resident_lru_, e.position);
+        return e.resident;
+    }
+
+    // Decompress without the lock; the shared pointer keeps the data alive
+    buffer_type const packed = e.compressed;
+    size_t const      size   = e.size;
+    lock.unlock();
+
+    std::string data;
+    bool const  ok = codec_->uncompress(packed->data(), packed->size(), &data, size) &&
+                     data.size() == size;
+
+    lock.lock();
+    found = entries_.find(key);
+    if (!ok)
+    {
+        if (found != entries_.end() && found->second.compressed == packed)
+        {
+            remove(key, found->second);
+        }
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.compressed_hits;
+    auto buffer = std::make_shared<const std::string>(std::move(data));
+    if (found == entries_.end())
+    {
+        return buffer;  // Erased meanwhile
+    }
+    entry& current = found->second;
+    if (current.compressed != packed)
+    {
+        // Promoted by another get(), or replaced by a put()
+        return current.resident != nullptr ? current.resident : buffer;
+    }
+
+    compressed_lru_.erase(current.position);
+    --stats_.compressed_entries;
+    stats_.compressed_bytes -= packed->size();
+    stats_.compressed_input -= size;
+
+    current.compressed.reset();
+    current.resident = buffer;
+    resident_lru_.push_front(key);
+    current.position = resident_lru_.begin();
+    ++stats_.resident_entries;
+    stats_.resident_bytes += size;
+
+    enforce_budgets();
+    return buffer;
+}
+
+bool compressed_cache::contains(key_type key) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.find(key) != entries_.end();
+}
+
+bool compressed_cache::erase(key_type key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        found = entries_.find(key);
+    if (found == entries_.end())
+    {
+        return false;
+    }
+    remove(key, found->second);
+    return true;
+}
+
+void compressed_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    resident_lru_.clear();
+    compressed_lru_.clear();
+    stats_.resident_entries   = 0;
+    stats_.resident_bytes     = 0;
+    stats_.compressed_entries = 0;
+    stats_.compressed_bytes   = 0;
+    stats_.compressed_input   = 0;
+}
+
+size_t compressed_cache::release(size_t bytes_wanted)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t                      released = 0;
+    while (released < bytes_wanted && !compressed_lru_.empty())
+    {
+        key_type const key   = compressed_lru_.back();
+        auto const     found = entries_.find(key);
+        released += found->second.compressed->size();
+        remove(key, found->second);
+    }
+    while (released < bytes_wanted && !resident_lru_.empty())
+    {
+        key_type const key   = resident_lru_.back();
+        auto const     found = entries_.find(key);
+        released += found->second.size;
+        remove(key, found->second);
+    }
+    return released;
+}
+
+compressed_cache_stats compressed_cache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void compressed_cache::remove(key_type key, entry& e)
+{
+    if (e.resident)
+    {
+        resident_lru_.erase(e.position);
+        --stats_.resident_entries;
+        stats_.resident_bytes -= e.size;
+    }
+    else
+    {
+        compressed_lru_.erase(e.position);
+        --stats_.compressed_entries;
+        stats_.compressed_bytes -= e.compressed->size();
+        stats_.compressed_input -= e.size;
+    }
+    entries_.erase(key);
+}
+
+void compressed_cache::enforce_budgets()
+{
+    // Demote the coldest resident entries into the compressed tier
+    while (stats_.resident_bytes > resident_budget_)
+    {
+        key_type const key = resident_lru_.back();
+        entry&         e   = entries_.find(key)->second;
+
+        std::string packed;
+        bool const  kept = compressed_budget_ != 0 &&
+                          codec_->compress(e.resident->data(), e.size, &packed) &&
+                          packed.size() < e.size - e.size / 8 &&
+                          packed.size() <= compressed_budget_;
+        if (!kept)
+        {
+            stats_.incompressible += compressed_budget_ != 0 ? 1 : 0;
+            ++stats_.evictions;
+            remove(key, e);
+            continue;
+        }
+
+        resident_lru_.pop_back();
+        --stats_.resident_entries;
+        stats_.resident_bytes -= e.size;
+
+        e.resident.reset();
+        e.compressed = std::make_shared<const std::string>(std::move(packed));
+        compressed_lru_.push_front(key);
+        e.position = compressed_lru_.begin();
+        ++stats_.compressed_entries;
+        ++stats_.compressions;
+        stats_.compressed_bytes += e.compressed->size();
+        stats_.compressed_input += e.size;
+    }
+
+    while (stats_.compressed_bytes > compressed_budget_)
+    {
+        key_type const key = compressed_lru_.back();
+        ++stats_.evictions;
+        remove(key, entries_.find(key)->second);
+    }
+}
+
+}  // namespace quarisma
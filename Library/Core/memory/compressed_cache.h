@@ -0,0 +1,198 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "common/export.h"
+#include "common/macros.h"
+#include "memory/helper/memory_pressure.h"
+#include "util/flat_hash.h"
+
+namespace quarisma
+{
+namespace compression
+{
+class codec;
+}
+
+/**
+ * @brief Counters of a compressed_cache.
+ */
+struct compressed_cache_stats
+{
+    int64_t resident_hits   = 0;  ///< get() served from the resident tier
+    int64_t compressed_hits = 0;  ///< get() served by decompressing an entry
+    int64_t misses          = 0;  ///< get() of a key not in the cache
+    int64_t compressions    = 0;  ///< Entries moved to the compressed tier
+    int64_t evictions       = 0;  ///< Entries dropped to stay within the budgets
+    int64_t incompressible  = 0;  ///< Evictions of entries the codec could not shrink
+
+    size_t resident_entries   = 0;
+    size_t resident_bytes     = 0;
+    size_t compressed_entries = 0;
+    size_t compressed_bytes   = 0;  ///< Size of the compressed tier
+    size_t compressed_input   = 0;  ///< Uncompressed size of the entries it holds
+
+    /** Fraction of get() calls that found the key, in either tier. */
+    double hit_rate() const noexcept
+    {
+        int64_t const hits = resident_hits + compressed_hits;
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+    }
+
+    /** Uncompressed over compressed size of the compressed tier. */
+    double compression_ratio() const noexcept
+    {
+        return compressed_bytes == 0 ? 0.0
+                                     : static_cast<double>(compressed_input) / compressed_bytes;
+    }
+};
+
+/**
+ * @brief Two-tier LRU cache of byte buffers, with the cold tier compressed.
+ *
+ * Memoized intermediate results are kept resident up to a byte budget; the
+ * least recently used ones beyond it are compressed into a second, separately
+ * budgeted tier instead of being dropped, and decompressed back into the
+ * resident tier on the next get(). With compressible data the cache thus holds
+ * several times more results in the same memory before they have to be
+ * recomputed.
+ *
+ * Entries that the codec does not shrink by at least 1/8 are dropped rather
+ * than compressed, and the compressed tier evicts its own least recently used
+ * entries. Buffers are returned as shared pointers, so an entry that is
+ * compressed or evicted stays valid for the callers still holding it.
+ *
+ * The cache registers with memory_pressure (memory_trim_cost::HIGH, since
+ * refilling it means recomputing) and gives back the compressed tier first.
+ *
+ * Example:
+ * ```cpp
+ * compressed_cache::options opts;
+ * opts.resident_budget   = size_t{1} << 30;
+ * opts.compressed_budget = size_t{1} << 30;
+ * compressed_cache cache(opts);
+ *
+ * auto result = cache.get(key);
+ * if (!result)
+ * {
+ *     result = cache.put(key, compute(key));
+ * }
+ * ```
+ *
+ * **Thread Safety**: Fully thread-safe. Compression runs under the cache lock;
+ * decompression does not.
+ */
+class QUARISMA_VISIBILITY compressed_cache
+{
+public:
+    using key_type    = uint64_t;
+    using buffer_type = std::shared_ptr<const std::string>;
+
+    struct options
+    {
+        /** Bytes of uncompressed entries kept resident. */
+        size_t resident_budget = size_t{256} << 20;
+
+        /** Bytes of compressed entries; 0 disables the compressed tier. */
+        size_t compressed_budget = size_t{256} << 20;
+
+        /** Codec of the compressed tier; nullptr selects the fastest built in. */
+        const compression::codec* codec = nullptr;
+
+        /** Name used for memory_pressure; empty to not register. */
+        std::string name = "compressed_cache";
+    };
+
+    QUARISMA_API explicit compressed_cache(options opts);
+
+    QUARISMA_API ~compressed_cache();
+
+    /**
+     * @brief Inserts or replaces the entry of key
+     * @return The cached buffer
+     */
+    QUARISMA_API buffer_type put(key_type key, std::string data);
+
+    QUARISMA_API buffer_type put(key_type key, const void* data, size_t size);
+
+    /**
+     * @brief Buffer of key, decompressed if needed, or nullptr on a miss
+     */
+    QUARISMA_API buffer_type get(key_type key);
+
+    /**
+     * @brief Whether key is cached, in either tier; does not count as an access
+     */
+    QUARISMA_API bool contains(key_type key) const;
+
+    /**
+     * @brief Removes the entry of key
+     * @return false if it was not cached
+     */
+    QUARISMA_API bool erase(key_type key);
+
+    /**
+     * @brief Removes every entry; the counters are kept
+     */
+    QUARISMA_API void clear();
+
+    /**
+     * @brief Drops entries, compressed ones first, least recently used first
+     * @return Bytes released
+     */
+    QUARISMA_API size_t release(size_t bytes_wanted);
+
+    QUARISMA_API compressed_cache_stats stats() const;
+
+    const compression::codec& codec() const noexcept { return *codec_; }
+
+    QUARISMA_DELETE_COPY_AND_MOVE(compressed_cache);
+
+private:
+    struct entry
+    {
+        buffer_type                   resident;    // Null while compressed
+        buffer_type                   compressed;  // Null while resident
+        size_t                        size = 0;    // Uncompressed size
+        std::list<key_type>::iterator position;    // In the LRU list of its tier
+    };
+
+    void remove(key_type key, entry& e) QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    void enforce_budgets() QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    const size_t                           resident_budget_;
+    const size_t                           compressed_budget_;
+    const compression::codec*              codec_;
+    mutable std::mutex                     mutex_;
+    quarisma::flat_hash_map<key_type, entry> entries_ QUARISMA_GUARDED_BY(mutex_);
+    std::list<key_type> resident_lru_                 QUARISMA_GUARDED_BY(mutex_);  // MRU first
+    std::list<key_type> compressed_lru_               QUARISMA_GUARDED_BY(mutex_);
+    compressed_cache_stats stats_                     QUARISMA_GUARDED_BY(mutex_);
+    memory_pressure::cache_id pressure_id_ = 0;
+};
+
+}  // namespace quarisma
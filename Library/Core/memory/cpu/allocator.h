@@ -40,7 +40,7 @@
 #include "common/export.h"                // for QUARISMA_API
 #include "common/macros.h"                // for QUARISMA_UNUSED
 #include "memory/sub_allocator.h"         // for sub_allocator, allocator_memory_enum
-#include "memory/unified_memory_stats.h"  // for allocator_stats
+#include "memory/unified_memory_stats.h"  // for allocator_stats, latency_histogram
 #include "util/exception.h"               // for check_msg_impl, QUARISMA_CHECK
 
 namespace quarisma
@@ -584,6 +584,43 @@ public:
      */
     virtual bool ClearStats() { return false; }
 
+    /**
+     * @brief Returns the allocator's statistics counters for lock-free reading.
+     *
+     * Unlike GetStats(), which may lock the allocator to take a consistent
+     * snapshot, this exposes the atomics the allocator updates in place, so a
+     * metrics exporter can load individual fields at any rate without
+     * contending with allocations. Fields read this way are not mutually
+     * consistent.
+     *
+     * @return Pointer valid for the allocator's lifetime, nullptr if the
+     *         allocator does not maintain its statistics in place
+     *
+     * **Thread Safety**: The returned fields may only be loaded, from any thread
+     */
+    virtual const allocator_stats* live_stats() const noexcept { return nullptr; }
+
+    /**
+     * @brief Returns the distribution of allocate_raw() latencies, if measured.
+     *
+     * Averages hide the rare slow allocations that break latency budgets; the
+     * histogram keeps the tail, e.g. snapshot().percentile_ns(99.9).
+     * allocator_tracking measures the allocator it wraps, so wrapping any
+     * allocator in one gives it latency histograms.
+     *
+     * @return Pointer valid for the allocator's lifetime, nullptr if not measured
+     *
+     * **Thread Safety**: Thread-safe
+     */
+    virtual const latency_histogram* allocation_latency() const noexcept { return nullptr; }
+
+    /**
+     * @brief Returns the distribution of deallocate_raw() latencies, if measured.
+     *
+     * @see allocation_latency()
+     */
+    virtual const latency_histogram* deallocation_latency() const noexcept { return nullptr; }
+
     /**
      * @brief Sets the safe frontier for timestamped memory management.
      *
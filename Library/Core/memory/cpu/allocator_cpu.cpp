@@ -28,6 +28,7 @@
 
 #include "memory/cpu/allocator_cpu.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -35,6 +36,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "common/macros.h"
 #include "logging/logger.h"
@@ -57,7 +59,7 @@ namespace quarisma
  * including allocation counts, peak usage, and memory warnings. This adds
  * minimal overhead but provides valuable debugging information.
  *
- * **Performance Impact**: ~1-2% overhead when enabled
+ * **Performance Impact**: Per-thread counter updates without atomics when enabled
  * **Thread Safety**: Atomic operations ensure thread-safe access
  * **Default**: Disabled for optimal performance
  */
@@ -152,10 +154,99 @@ static int64_t TotalAllocationWarningBytes() noexcept
     return value;
 }
 
+// ========== Statistics Shards ==========
+
+namespace
+{
+/**
+ * @brief Hands out small thread indices, reused after their thread exits.
+ *
+ * Indices select the statistics shard of a thread in every allocator_cpu, so
+ * at most one live thread writes a shard. A thread taking over the index of
+ * an exited one goes through the registry mutex, which orders its writes
+ * after those of the previous owner.
+ */
+class thread_index_registry
+{
+public:
+    static thread_index_registry& instance()
+    {
+        // Leaked: threads may exit after static destruction
+        static auto* registry = new thread_index_registry();
+        return *registry;
+    }
+
+    size_t acquire()
+    {
+        std::scoped_lock const lock(mutex_);
+        if (free_.empty())
+        {
+            return next_++;
+        }
+        const size_t index = free_.back();
+        free_.pop_back();
+        return index;
+    }
+
+    void release(size_t index)
+    {
+        std::scoped_lock const lock(mutex_);
+        free_.push_back(index);
+    }
+
+private:
+    std::mutex          mutex_;
+    std::vector<size_t> free_;
+    size_t              next_{0};
+};
+
+struct thread_index
+{
+    thread_index() : value(thread_index_registry::instance().acquire()) {}
+    ~thread_index() { thread_index_registry::instance().release(value); }
+
+    const size_t value;
+};
+
+size_t current_thread_index()
+{
+    static thread_local thread_index const index;
+    return index.value;
+}
+
+// Shards have a single writer, so they are updated without read-modify-write
+// instructions.
+void add_to(std::atomic<int64_t>& counter, int64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void raise_to(std::atomic<int64_t>& maximum, int64_t value)
+{
+    if (value > maximum.load(std::memory_order_relaxed))
+    {
+        maximum.store(value, std::memory_order_relaxed);
+    }
+}
+}  // namespace
+
+struct alignas(64) allocator_cpu::stats_shard
+{
+    std::atomic<int64_t>  num_allocs{0};
+    std::atomic<int64_t>  num_deallocs{0};
+    std::atomic<int64_t>  bytes_in_use{0};  // May be negative: frees of other threads' memory
+    std::atomic<int64_t>  total_bytes_allocated{0};
+    std::atomic<int64_t>  peak_bytes_in_use{0};   // Of this shard, since `epoch`
+    std::atomic<int64_t>  largest_alloc_size{0};  // Since `epoch`
+    std::atomic<uint64_t> epoch{0};
+};
+
 // ========== allocator_cpu Implementation ==========
 
 allocator_cpu::allocator_cpu()
-    : single_allocation_warning_count_{0}, total_allocation_warning_count_{0}
+    : shards_(std::make_unique<stats_shard[]>(kMaxStatsShards + 1)),
+      single_allocation_warning_count_{0},
+      total_allocation_warning_count_{0}
 {
 }
 
@@ -200,49 +291,7 @@ void* allocator_cpu::allocate_raw(size_t alignment, size_t num_bytes)
     if QUARISMA_UNLIKELY (cpu_allocator_collect_stats.load(std::memory_order_relaxed) && p != nullptr)
     {
         const auto alloc_size = 0;
-
-        // Use scoped lock for statistics update
-        {
-            std::scoped_lock const lock(mu_);
-
-            // Update core statistics
-            stats_.num_allocs.fetch_add(1, std::memory_order_relaxed);
-            stats_.bytes_in_use.fetch_add(alloc_size, std::memory_order_relaxed);
-
-            // Update peak bytes in use atomically
-            int64_t const current_bytes = stats_.bytes_in_use.load(std::memory_order_relaxed);
-            int64_t       peak_bytes    = stats_.peak_bytes_in_use.load(std::memory_order_relaxed);
-            while (current_bytes > peak_bytes &&
-                   !stats_.peak_bytes_in_use.compare_exchange_weak(
-                       peak_bytes, current_bytes, std::memory_order_relaxed))
-            {
-                // Retry if another thread updated peak_bytes
-            }
-
-            // Update largest allocation size atomically
-            auto const alloc_size_int64 = static_cast<int64_t>(alloc_size);
-            int64_t    largest_size     = stats_.largest_alloc_size.load(std::memory_order_relaxed);
-            while (alloc_size_int64 > largest_size &&
-                   !stats_.largest_alloc_size.compare_exchange_weak(
-                       largest_size, alloc_size_int64, std::memory_order_relaxed))
-            {
-                // Retry if another thread updated largest_size
-            }
-
-            // Check for total allocation warning (rate-limited)
-            if (stats_.bytes_in_use > TotalAllocationWarningBytes() &&
-                total_allocation_warning_count_ < kMaxTotalAllocationWarnings)
-            {
-                ++total_allocation_warning_count_;
-                size_t bytes_in_use = stats_.bytes_in_use.load(std::memory_order_relaxed);
-                QUARISMA_LOG_WARNING(
-                    "Total allocated memory {} bytes ({}% of available RAM) exceeds {}% "
-                    "threshold",
-                    bytes_in_use,
-                    (100.0 * bytes_in_use / port::available_ram()),
-                    (100 * kTotalAllocationWarningThreshold));
-            }
-        }
+        RecordAllocation(num_bytes, alloc_size);
 
         // Add profiling trace (outside lock to minimize contention)
 #if QUARISMA_HAS_NATIVE_PROFILER
@@ -260,12 +309,7 @@ void allocator_cpu::deallocate_raw(void* ptr)
     {
         // Get allocation size before deallocation
         const auto alloc_size = 0;
-
-        // Update statistics under lock
-        {
-            std::scoped_lock const lock(mu_);
-            stats_.bytes_in_use -= alloc_size;
-        }
+        RecordDeallocation(alloc_size);
 
         // Add profiling trace (outside lock to minimize contention)
 #if QUARISMA_HAS_NATIVE_PROFILER
@@ -284,6 +328,113 @@ void allocator_cpu::deallocate_raw(void* ptr, size_t /*alignment*/, size_t /*num
     deallocate_raw(ptr);
 }
 
+void allocator_cpu::RecordAllocation(size_t num_bytes, int64_t alloc_size)
+{
+    const size_t                 index = std::min(current_thread_index(), kMaxStatsShards);
+    std::unique_lock<std::mutex> shared_lock(mu_, std::defer_lock);
+    if QUARISMA_UNLIKELY (index == kMaxStatsShards)
+    {
+        shared_lock.lock();
+    }
+
+    stats_shard&   shard = shards_[index];
+    const uint64_t epoch = stats_epoch_.load(std::memory_order_relaxed);
+    if QUARISMA_UNLIKELY (shard.epoch.load(std::memory_order_relaxed) != epoch)
+    {
+        shard.peak_bytes_in_use.store(
+            shard.bytes_in_use.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        shard.largest_alloc_size.store(0, std::memory_order_relaxed);
+        shard.epoch.store(epoch, std::memory_order_relaxed);
+    }
+
+    add_to(shard.num_allocs, 1);
+    add_to(shard.bytes_in_use, alloc_size);
+    add_to(shard.total_bytes_allocated, static_cast<int64_t>(num_bytes));
+    raise_to(shard.peak_bytes_in_use, shard.bytes_in_use.load(std::memory_order_relaxed));
+    raise_to(shard.largest_alloc_size, static_cast<int64_t>(num_bytes));
+
+    // A single thread over the threshold is enough for the total to be; other
+    // cases are caught when GetStats() merges the shards. Once the warnings are
+    // used up there is nothing left to report, so the merge is skipped.
+    if QUARISMA_UNLIKELY (
+        shard.bytes_in_use.load(std::memory_order_relaxed) > TotalAllocationWarningBytes() &&
+        total_allocation_warning_count_.load(std::memory_order_relaxed) <
+            kMaxTotalAllocationWarnings)
+    {
+        if (!shared_lock.owns_lock())
+        {
+            shared_lock.lock();
+        }
+        MergeStatsShards();
+    }
+}
+
+void allocator_cpu::RecordDeallocation(int64_t alloc_size)
+{
+    const size_t                 index = std::min(current_thread_index(), kMaxStatsShards);
+    std::unique_lock<std::mutex> shared_lock(mu_, std::defer_lock);
+    if QUARISMA_UNLIKELY (index == kMaxStatsShards)
+    {
+        shared_lock.lock();
+    }
+
+    stats_shard& shard = shards_[index];
+    add_to(shard.num_deallocs, 1);
+    add_to(shard.bytes_in_use, -alloc_size);
+}
+
+void allocator_cpu::MergeStatsShards() const
+{
+    const uint64_t epoch         = stats_epoch_.load(std::memory_order_relaxed);
+    int64_t        num_allocs    = 0;
+    int64_t        num_deallocs  = 0;
+    int64_t        bytes_in_use  = 0;
+    int64_t        total_bytes   = 0;
+    int64_t        peak          = stats_.peak_bytes_in_use.load(std::memory_order_relaxed);
+    int64_t        largest_alloc = stats_.largest_alloc_size.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= kMaxStatsShards; ++i)
+    {
+        const stats_shard& shard = shards_[i];
+        num_allocs += shard.num_allocs.load(std::memory_order_relaxed);
+        num_deallocs += shard.num_deallocs.load(std::memory_order_relaxed);
+        bytes_in_use += shard.bytes_in_use.load(std::memory_order_relaxed);
+        total_bytes += shard.total_bytes_allocated.load(std::memory_order_relaxed);
+        if (shard.epoch.load(std::memory_order_relaxed) == epoch)
+        {
+            peak = std::max(peak, shard.peak_bytes_in_use.load(std::memory_order_relaxed));
+            largest_alloc =
+                std::max(largest_alloc, shard.largest_alloc_size.load(std::memory_order_relaxed));
+        }
+    }
+    peak = std::max(peak, bytes_in_use);
+
+    stats_.num_allocs.store(num_allocs - cleared_num_allocs_, std::memory_order_relaxed);
+    stats_.num_deallocs.store(num_deallocs, std::memory_order_relaxed);
+    stats_.bytes_in_use.store(bytes_in_use, std::memory_order_relaxed);
+    stats_.total_bytes_allocated.store(total_bytes, std::memory_order_relaxed);
+    stats_.peak_bytes_in_use.store(peak, std::memory_order_relaxed);
+    stats_.largest_alloc_size.store(largest_alloc, std::memory_order_relaxed);
+
+    CheckTotalAllocationWarning(bytes_in_use);
+}
+
+void allocator_cpu::CheckTotalAllocationWarning(int64_t bytes_in_use) const
+{
+    // Check for total allocation warning (rate-limited)
+    if (bytes_in_use > TotalAllocationWarningBytes() &&
+        total_allocation_warning_count_.load(std::memory_order_relaxed) <
+            kMaxTotalAllocationWarnings)
+    {
+        total_allocation_warning_count_.fetch_add(1, std::memory_order_relaxed);
+        QUARISMA_LOG_WARNING(
+            "Total allocated memory {} bytes ({}% of available RAM) exceeds {}% "
+            "threshold",
+            bytes_in_use,
+            (100.0 * bytes_in_use / port::available_ram()),
+            (100 * kTotalAllocationWarningThreshold));
+    }
+}
+
 std::optional<allocator_stats> allocator_cpu::GetStats() const
 {
     if (!cpu_allocator_collect_stats.load(std::memory_order_relaxed))
@@ -292,6 +443,7 @@ std::optional<allocator_stats> allocator_cpu::GetStats() const
     }
 
     std::scoped_lock const lock(mu_);
+    MergeStatsShards();
     // Create a copy of the atomic stats structure
     allocator_stats stats_copy(stats_);
     return stats_copy;
@@ -305,10 +457,14 @@ bool allocator_cpu::ClearStats()
     }
 
     std::scoped_lock const lock(mu_);
+    MergeStatsShards();
+    cleared_num_allocs_ += stats_.num_allocs.load(std::memory_order_relaxed);
     stats_.num_allocs.store(0, std::memory_order_relaxed);
     stats_.peak_bytes_in_use.store(
         stats_.bytes_in_use.load(std::memory_order_relaxed), std::memory_order_relaxed);
     stats_.largest_alloc_size.store(0, std::memory_order_relaxed);
+    // Shards drop their peak and largest allocation when they see the new epoch
+    stats_epoch_.fetch_add(1, std::memory_order_relaxed);
     return true;
 }
 
@@ -0,0 +1,89 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+#include "common/macros.h"
+#include "memory/cpu/allocator.h"
+
+#if QUARISMA_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+
+namespace quarisma
+{
+
+/**
+ * @brief std::pmr::memory_resource over an Allocator.
+ *
+ * Lets std::pmr containers, the pmr:: hash containers of util/flat_hash.h and
+ * small_vector_resource_scope draw from any Allocator, such as allocator_bfc
+ * or allocator_pool. Deallocation passes the size and alignment back to
+ * deallocate_raw(), which sized allocators use. The Allocator is not owned
+ * and must outlive the resource and everything allocated through it.
+ *
+ * An arena is a memory_resource already and needs no adapter.
+ *
+ * **Thread Safety**: As thread-safe as the underlying Allocator
+ *
+ * **Example Usage**:
+ * ```cpp
+ * allocator_resource pooled(*pool);
+ * pmr::flat_hash_map<int, double> cache(&pooled);
+ * ```
+ */
+class allocator_resource : public std::pmr::memory_resource
+{
+public:
+    explicit allocator_resource(Allocator& allocator) noexcept : allocator_(&allocator) {}
+
+    Allocator& allocator() const noexcept { return *allocator_; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        // Zero-byte requests must still return a unique pointer
+        void* ptr = allocator_->allocate_raw(alignment, std::max<size_t>(bytes, 1));
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        allocator_->deallocate_raw(ptr, alignment, std::max<size_t>(bytes, 1));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        const auto* resource = dynamic_cast<const allocator_resource*>(&other);
+        return resource != nullptr && resource->allocator_ == allocator_;
+    }
+
+private:
+    Allocator* allocator_;
+};
+
+}  // namespace quarisma
+#endif  // QUARISMA_HAS_MEMORY_RESOURCE
@@ -11,6 +11,7 @@
 #include <sstream>
 
 #include "logging/logger.h"
+#include "memory/gpu/gpu_resource_tracker.h"
 #include "memory/helper/memory_allocator.h"
 #if QUARISMA_HAS_NATIVE_PROFILER
 #include "profiler/native/tracing/traceme.h"
@@ -178,6 +179,11 @@ allocator_gpu::~allocator_gpu()
 
 void* allocator_gpu::allocate_gpu_memory(size_t num_bytes, void* stream) const
 {
+    if (options_.use_managed_memory)
+    {
+        return quarisma::gpu::memory_allocator::allocate_managed(num_bytes, device_id_);
+    }
+
     // Use the new gpu::memory_allocator with stream and memory pool support
     void* gpu_stream = (stream != nullptr) ? stream : options_.gpu_stream;
     return quarisma::gpu::memory_allocator::allocate(
@@ -191,11 +197,58 @@ void allocator_gpu::deallocate_gpu_memory(void* ptr, size_t num_bytes, void* str
         return;
     }
 
+    if (options_.use_managed_memory)
+    {
+        quarisma::gpu::memory_allocator::free_managed(ptr, device_id_);
+        return;
+    }
+
     // Use the new gpu::memory_allocator with stream support
     void* gpu_stream = (stream != nullptr) ? stream : options_.gpu_stream;
     quarisma::gpu::memory_allocator::free(ptr, num_bytes, device_id_, gpu_stream);
 }
 
+bool allocator_gpu::prefetch(const void* ptr, size_t num_bytes, int device_id, void* stream) const
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    quarisma::traceme const traceme("allocator_gpu::prefetch");
+#endif
+
+    if (!options_.use_managed_memory || ptr == nullptr || num_bytes == 0)
+    {
+        return false;
+    }
+
+    void* gpu_stream = (stream != nullptr) ? stream : options_.gpu_stream;
+    if (!quarisma::gpu::memory_allocator::prefetch(ptr, num_bytes, device_id, gpu_stream))
+    {
+        return false;
+    }
+
+    gpu_resource_tracker::instance().record_prefetch(ptr, num_bytes, device_id);
+    return true;
+}
+
+bool allocator_gpu::advise(
+    const void*                             ptr,
+    size_t                                  num_bytes,
+    memory_allocator::managed_memory_advice advice,
+    int                                     device_id) const
+{
+    if (!options_.use_managed_memory || ptr == nullptr || num_bytes == 0)
+    {
+        return false;
+    }
+
+    if (!quarisma::gpu::memory_allocator::advise(ptr, num_bytes, advice, device_id))
+    {
+        return false;
+    }
+
+    gpu_resource_tracker::instance().record_advice(ptr, num_bytes, advice, device_id);
+    return true;
+}
+
 bool allocator_gpu::set_device_context() const
 {
     return quarisma::gpu::memory_allocator::set_device(device_id_);
@@ -14,6 +14,7 @@
 #include "common/export.h"
 #include "common/macros.h"
 #include "memory/cpu/allocator.h"
+#include "memory/helper/memory_allocator.h"
 #include "memory/sub_allocator.h"
 
 #if QUARISMA_HAS_CUDA
@@ -147,8 +148,15 @@ enum class gpu_allocation_method
  * - Device memory bandwidth: Limited by PCIe and GPU memory bandwidth
  * - Memory fragmentation depends on allocation pattern and method
  *
+ * **Managed Memory** (Options::use_managed_memory):
+ * Allocations use cudaMallocManaged/hipMallocManaged regardless of QUARISMA_GPU_ALLOC,
+ * so data sets may exceed device memory. prefetch() migrates ranges ahead of use and
+ * advise() sets read-mostly or preferred-location hints; both are recorded by
+ * gpu_resource_tracker.
+ *
  * **Thread Safety**: Fully thread-safe with device-level synchronization
- * **Memory Type**: GPU device memory (CUDA global memory or HIP device memory)
+ * **Memory Type**: GPU device memory (CUDA global memory or HIP device memory), or
+ * unified memory in managed mode
  */
 class QUARISMA_VISIBILITY allocator_gpu : public Allocator
 {
@@ -167,6 +175,9 @@ public:
         void*  memory_pool = nullptr;  ///< GPU memory pool handle (nullptr = default pool)
         size_t pool_threshold =
             0;  ///< Minimum allocation size for pool usage (0 = use pool for all sizes)
+
+        /// Allocate managed (unified) memory instead of device memory; see prefetch() and advise()
+        bool use_managed_memory = false;
     };
 
     /**
@@ -287,9 +298,39 @@ public:
      */
     allocator_memory_enum GetMemoryType() const noexcept override
     {
-        return allocator_memory_enum::DEVICE;
+        return options_.use_managed_memory ? allocator_memory_enum::UNIFIED
+                                           : allocator_memory_enum::DEVICE;
     }
 
+    /**
+     * @brief Migrates a range of managed memory ahead of its use.
+     *
+     * @param ptr Start of the range, within an allocation of this allocator
+     * @param num_bytes Size of the range in bytes
+     * @param device_id Destination device, or memory_allocator::host_device_id for the host
+     * @param stream GPU stream to order the migration on (nullptr = Options::gpu_stream)
+     * @return true if the prefetch was enqueued; false if it failed or the
+     *         allocator is not in managed mode
+     */
+    QUARISMA_API bool prefetch(
+        const void* ptr, size_t num_bytes, int device_id, void* stream = nullptr) const;
+
+    /**
+     * @brief Applies a usage hint to a range of managed memory.
+     *
+     * @param ptr Start of the range, within an allocation of this allocator
+     * @param num_bytes Size of the range in bytes
+     * @param advice Hint to apply (read-mostly, preferred location, accessed-by)
+     * @param device_id Device the hint refers to, or memory_allocator::host_device_id
+     * @return true if the hint was applied; false if it failed or the
+     *         allocator is not in managed mode
+     */
+    QUARISMA_API bool advise(
+        const void*                             ptr,
+        size_t                                  num_bytes,
+        memory_allocator::managed_memory_advice advice,
+        int                                     device_id) const;
+
     /**
      * @brief Returns GPU device ID for this allocator.
      *
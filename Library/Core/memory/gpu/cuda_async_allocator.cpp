@@ -0,0 +1,269 @@
+#include "memory/gpu/cuda_async_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "memory/helper/memory_pressure.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_CUDA
+#include <cuda_runtime.h>
+#endif
+
+namespace quarisma
+{
+namespace gpu
+{
+namespace
+{
+
+inline void throw_on_cuda_error(cudaError_t result, const char* what)
+{
+    if (result != cudaSuccess)
+    {
+        std::string const message = std::string(what) + ": " + cudaGetErrorString(result);
+        throw std::runtime_error(message);
+    }
+}
+
+uint64_t pool_attribute(cudaMemPool_t pool, cudaMemPoolAttr attribute)
+{
+    uint64_t value = 0;
+    throw_on_cuda_error(cudaMemPoolGetAttribute(pool, attribute, &value), "cudaMemPoolGetAttribute");
+    return value;
+}
+
+}  // namespace
+
+struct cuda_async_allocator::Impl
+{
+    Impl(int device, const Options& options) : device_(device), owns_pool_(!options.use_default_pool)
+    {
+        int device_count = 0;
+        throw_on_cuda_error(cudaGetDeviceCount(&device_count), "cudaGetDeviceCount");
+        QUARISMA_CHECK(  //NOLINT
+            device >= 0 && device < device_count,
+            "Invalid CUDA device index: " + std::to_string(device) + " (available: 0-" +
+                std::to_string(device_count - 1) + ")");
+
+        int pools_supported = 0;
+        throw_on_cuda_error(
+            cudaDeviceGetAttribute(&pools_supported, cudaDevAttrMemoryPoolsSupported, device),
+            "cudaDeviceGetAttribute");
+        QUARISMA_CHECK(
+            pools_supported != 0, "CUDA device ", device, " does not support memory pools");
+
+        if (owns_pool_)
+        {
+            cudaMemPoolProps props = {};
+            props.allocType        = cudaMemAllocationTypePinned;
+            props.location.type    = cudaMemLocationTypeDevice;
+            props.location.id      = device;
+            props.handleTypes =
+                options.enable_ipc ? cudaMemHandleTypePosixFileDescriptor : cudaMemHandleTypeNone;
+            throw_on_cuda_error(cudaMemPoolCreate(&pool_, &props), "cudaMemPoolCreate");
+        }
+        else
+        {
+            throw_on_cuda_error(
+                cudaDeviceGetDefaultMemPool(&pool_, device), "cudaDeviceGetDefaultMemPool");
+        }
+
+        uint64_t threshold = options.release_threshold;
+        throw_on_cuda_error(
+            cudaMemPoolSetAttribute(pool_, cudaMemPoolAttrReleaseThreshold, &threshold),
+            "cudaMemPoolSetAttribute");
+
+        std::vector<cudaMemAccessDesc> access;
+        for (const int peer : options.peer_devices)
+        {
+            if (peer == device)
+            {
+                continue;
+            }
+            cudaMemAccessDesc desc = {};
+            desc.location.type     = cudaMemLocationTypeDevice;
+            desc.location.id       = peer;
+            desc.flags             = cudaMemAccessFlagsProtReadWrite;
+            access.push_back(desc);
+        }
+        if (!access.empty())
+        {
+            throw_on_cuda_error(
+                cudaMemPoolSetAccess(pool_, access.data(), access.size()), "cudaMemPoolSetAccess");
+        }
+
+        pressure_id_ = memory_pressure::instance().register_cache(
+            "cuda_async_allocator",
+            memory_trim_cost::HIGH,
+            device_enum::CUDA,
+            device,
+            [this](size_t bytes_wanted) { return release_under_pressure(bytes_wanted); });
+    }
+
+    ~Impl()
+    {
+        memory_pressure::instance().unregister_cache(pressure_id_);
+        if (owns_pool_ && pool_ != nullptr)
+        {
+            cudaMemPoolDestroy(pool_);
+        }
+    }
+
+    void* allocate(size_t size, stream_type stream)
+    {
+        QUARISMA_CHECK(size > 0, "cuda_async_allocator cannot allocate zero bytes");
+
+        void* ptr = nullptr;
+        if (cudaMallocFromPoolAsync(&ptr, size, pool_, stream) != cudaSuccess)
+        {
+            // Clear the sticky error state, then retry once the other caches
+            // of the device gave memory back
+            (void)cudaGetLastError();
+            auto& pressure = memory_pressure::instance();
+            if (pressure.relieve(device_enum::CUDA, device_, size, pressure_id_) == 0 ||
+                cudaMallocFromPoolAsync(&ptr, size, pool_, stream) != cudaSuccess)
+            {
+                (void)cudaGetLastError();
+                throw std::bad_alloc();
+            }
+        }
+
+        stats_.successful_allocations++;
+        stats_.bytes_allocated += size;
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t /*size*/, stream_type stream)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        throw_on_cuda_error(cudaFreeAsync(ptr, stream), "cudaFreeAsync");
+        stats_.successful_frees++;
+    }
+
+    void trim(size_t min_bytes_to_keep)
+    {
+        throw_on_cuda_error(cudaMemPoolTrimTo(pool_, min_bytes_to_keep), "cudaMemPoolTrimTo");
+    }
+
+    /**
+     * @brief memory_pressure callback: trim the pool's unused memory
+     */
+    size_t release_under_pressure(size_t bytes_wanted)
+    {
+        const uint64_t reserved = pool_attribute(pool_, cudaMemPoolAttrReservedMemCurrent);
+        const uint64_t used     = pool_attribute(pool_, cudaMemPoolAttrUsedMemCurrent);
+        const uint64_t keep =
+            std::max(reserved - std::min<uint64_t>(reserved, bytes_wanted), used);
+        trim(keep);
+        const uint64_t after = pool_attribute(pool_, cudaMemPoolAttrReservedMemCurrent);
+        return static_cast<size_t>(reserved - std::min(reserved, after));
+    }
+
+    void set_release_threshold(uint64_t bytes)
+    {
+        throw_on_cuda_error(
+            cudaMemPoolSetAttribute(pool_, cudaMemPoolAttrReleaseThreshold, &bytes),
+            "cudaMemPoolSetAttribute");
+    }
+
+    uint64_t release_threshold() const
+    {
+        return pool_attribute(pool_, cudaMemPoolAttrReleaseThreshold);
+    }
+
+    unified_cache_stats stats() const
+    {
+        unified_cache_stats stats(stats_);
+
+        const uint64_t reserved      = pool_attribute(pool_, cudaMemPoolAttrReservedMemCurrent);
+        const uint64_t used          = pool_attribute(pool_, cudaMemPoolAttrUsedMemCurrent);
+        const uint64_t reserved_high = pool_attribute(pool_, cudaMemPoolAttrReservedMemHigh);
+        const uint64_t used_high     = pool_attribute(pool_, cudaMemPoolAttrUsedMemHigh);
+        stats.bytes_cached           = reserved - std::min(reserved, used);
+        stats.peak_bytes_cached      = reserved_high - std::min(reserved_high, used_high);
+        return stats;
+    }
+
+    pool_type memory_pool() const noexcept { return pool_; }
+
+    int device() const noexcept { return device_; }
+
+private:
+    int                 device_;
+    bool                owns_pool_;
+    cudaMemPool_t       pool_ = nullptr;
+    unified_cache_stats stats_;  // Atomic counters, updated without a lock
+
+    memory_pressure::cache_id pressure_id_ = 0;
+};
+
+cuda_async_allocator::cuda_async_allocator(int device) : cuda_async_allocator(device, Options{}) {}
+
+cuda_async_allocator::cuda_async_allocator(int device, const Options& options)
+    : impl_(std::make_unique<Impl>(device, options))
+{
+}
+
+cuda_async_allocator::~cuda_async_allocator() = default;
+
+cuda_async_allocator::cuda_async_allocator(cuda_async_allocator&&) noexcept = default;
+
+cuda_async_allocator& cuda_async_allocator::operator=(cuda_async_allocator&&) noexcept = default;
+
+void* cuda_async_allocator::allocate(size_t size, stream_type stream)
+{
+    //cppcheck-suppress syntaxError
+    if QUARISMA_UNLIKELY (size == 0)
+    {
+        return nullptr;
+    }
+    return impl_->allocate(size, stream);
+}
+
+void cuda_async_allocator::deallocate(void* ptr, size_t size, stream_type stream)
+{
+    impl_->deallocate(ptr, size, stream);
+}
+
+void cuda_async_allocator::trim(size_t min_bytes_to_keep)
+{
+    impl_->trim(min_bytes_to_keep);
+}
+
+void cuda_async_allocator::set_release_threshold(uint64_t bytes)
+{
+    impl_->set_release_threshold(bytes);
+}
+
+uint64_t cuda_async_allocator::release_threshold() const
+{
+    return impl_->release_threshold();
+}
+
+unified_cache_stats cuda_async_allocator::stats() const
+{
+    return impl_->stats();
+}
+
+cuda_async_allocator::pool_type cuda_async_allocator::memory_pool() const noexcept
+{
+    return impl_->memory_pool();
+}
+
+int cuda_async_allocator::device() const noexcept
+{
+    return impl_->device();
+}
+}  // namespace gpu
+}  // namespace quarisma
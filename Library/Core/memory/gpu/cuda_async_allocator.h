@@ -0,0 +1,181 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "memory/unified_memory_stats.h"
+
+#if QUARISMA_HAS_CUDA
+#include <cuda_runtime_api.h>
+#endif
+
+namespace quarisma
+{
+namespace gpu
+{
+/**
+ * @brief CUDA allocator on the driver's stream-ordered allocator
+ *
+ * Allocations are cudaMallocFromPoolAsync() calls on a cudaMemPool_t, and
+ * frees are cudaFreeAsync() calls, both ordered on the given stream. The
+ * driver keeps freed memory in the pool and reuses it across streams once
+ * the free is known to have completed (following event dependencies), so
+ * there is no caching layer, event polling or host-side block bookkeeping
+ * here. Memory above the release threshold goes back to the system at the
+ * next synchronization.
+ *
+ * Unlike cuda_caching_allocator, the backend is chosen at run time (see
+ * gpu_allocation_strategy::ASYNC_POOL) rather than by the QUARISMA_GPU_ALLOC
+ * build flag, and it works with pools exported to other processes.
+ *
+ * Features:
+ * - Device default pool or a private pool, optionally exportable for IPC
+ * - Release threshold and explicit trimming of the pool
+ * - Peer device access to the pool's memory
+ * - Statistics from the pool's reserved and used memory attributes
+ * - Thread-safe without a host lock
+ *
+ * @note Requires a device with memory pool support (CUDA 11.2 or later)
+ */
+class QUARISMA_VISIBILITY cuda_async_allocator
+{
+public:
+#if QUARISMA_HAS_CUDA
+    using stream_type = cudaStream_t;
+    using pool_type   = cudaMemPool_t;
+#else
+    using stream_type = void*;
+    using pool_type   = void*;
+#endif
+
+    /**
+     * @brief Configuration of the memory pool.
+     */
+    struct Options
+    {
+        /** Use the device's default pool, shared with plain cudaMallocAsync(). */
+        bool use_default_pool = false;
+
+        /**
+         * Bytes the pool keeps reserved across synchronizations; the default
+         * keeps everything, as a caching allocator would.
+         */
+        uint64_t release_threshold = std::numeric_limits<uint64_t>::max();
+
+        /** Create the pool with POSIX file descriptor handles for IPC export. */
+        bool enable_ipc = false;
+
+        /** Other devices given read-write access to the pool's memory. */
+        std::vector<int> peer_devices;
+    };
+
+    /**
+     * @brief Construct an allocator on a private pool of `device` with default options
+     * @param device CUDA device index (default: 0)
+     * @throws std::runtime_error if the device does not support memory pools
+     */
+    QUARISMA_API explicit cuda_async_allocator(int device = 0);
+
+    /**
+     * @brief Construct an allocator on a pool of `device`
+     * @param device CUDA device index
+     * @param options Pool configuration
+     * @throws std::runtime_error if the device does not support memory pools
+     */
+    QUARISMA_API cuda_async_allocator(int device, const Options& options);
+
+    /**
+     * @brief Destructor - destroys a private pool
+     *
+     * The driver releases the pool once its outstanding allocations are freed.
+     */
+    QUARISMA_API ~cuda_async_allocator();
+
+    /**
+     * @brief Allocate device memory ordered on `stream`
+     * @param size Number of bytes to allocate
+     * @param stream Stream the memory is first used on (nullptr = default stream)
+     * @return Pointer to allocated memory, usable by work queued on `stream`
+     * @throws std::bad_alloc if allocation fails
+     */
+    QUARISMA_API void* allocate(size_t size, stream_type stream = nullptr);
+
+    /**
+     * @brief Free memory once work queued so far on `stream` has completed
+     * @param ptr Pointer from allocate()
+     * @param size Size passed to allocate() (for statistics)
+     * @param stream Stream last using the memory (nullptr = default stream)
+     */
+    QUARISMA_API void deallocate(void* ptr, size_t size, stream_type stream = nullptr);
+
+    /**
+     * @brief Release unused pool memory down to `min_bytes_to_keep`
+     * @note Only memory whose frees have completed can be released
+     */
+    QUARISMA_API void trim(size_t min_bytes_to_keep = 0);
+
+    /**
+     * @brief Set the bytes the pool keeps reserved across synchronizations
+     */
+    QUARISMA_API void set_release_threshold(uint64_t bytes);
+
+    /**
+     * @brief Get the release threshold of the pool
+     */
+    QUARISMA_API uint64_t release_threshold() const;
+
+    /**
+     * @brief Get allocation statistics
+     *
+     * bytes_cached and peak_bytes_cached are the pool's reserved memory not in
+     * use, as reported by the driver.
+     */
+    QUARISMA_API unified_cache_stats stats() const;
+
+    /**
+     * @brief Get the pool, e.g. to export it to another process
+     */
+    QUARISMA_API pool_type memory_pool() const noexcept;
+
+    /**
+     * @brief Get device index this allocator manages
+     */
+    QUARISMA_API int device() const noexcept;
+
+    // Non-copyable but movable
+    cuda_async_allocator(const cuda_async_allocator&)                       = delete;
+    cuda_async_allocator&            operator=(const cuda_async_allocator&) = delete;
+    QUARISMA_API                     cuda_async_allocator(cuda_async_allocator&&) noexcept;
+    QUARISMA_API cuda_async_allocator& operator=(cuda_async_allocator&&) noexcept;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace gpu
+}  // namespace quarisma
@@ -1,21 +1,24 @@
 #include "memory/gpu/cuda_caching_allocator.h"
 
 #include <algorithm>
-#include <iterator>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <limits>
-#include <map>
 #include <memory>
 #include <mutex>
 #include <new>
+#include <set>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "common/configure.h"
 #include "common/macros.h"
 #include "logging/logger.h"
+#include "memory/helper/memory_pressure.h"
+#include "parallel/profiled_mutex.h"
 #include "util/exception.h"
 #include "util/flat_hash.h"
 
@@ -83,25 +86,74 @@ private:
     bool changed_{false};
 };
 
+// Requests are rounded to kRoundBytes. Those of at most kSmallBytes are served
+// from kSmallSegmentBytes segments, larger ones from kLargeSegmentBytes
+// segments, or from a segment of their own when of kMinLargeAllocBytes or
+// more, rounded to kRoundLargeBytes.
+constexpr size_t kRoundBytes         = 512;
+constexpr size_t kSmallBytes         = size_t{1} << 20;
+constexpr size_t kSmallSegmentBytes  = size_t{2} << 20;
+constexpr size_t kLargeSegmentBytes  = size_t{20} << 20;
+constexpr size_t kMinLargeAllocBytes = size_t{10} << 20;
+constexpr size_t kRoundLargeBytes    = size_t{2} << 20;
+
+size_t round_up(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+size_t round_size(size_t size)
+{
+    return size < kRoundBytes ? kRoundBytes : round_up(size, kRoundBytes);
+}
+
+size_t segment_size(size_t size)
+{
+    if (size <= kSmallBytes)
+    {
+        return kSmallSegmentBytes;
+    }
+    if (size < kMinLargeAllocBytes)
+    {
+        return kLargeSegmentBytes;
+    }
+    return round_up(size, kRoundLargeBytes);
+}
+
 }  // namespace
 
 struct cuda_caching_allocator::Impl
 {
+    /**
+     * A range of a segment (one cudaMalloc). Segments belong to the stream
+     * that first allocated them, and their blocks are split and merged in
+     * place, in address order through `prev` and `next`.
+     */
     struct Block
     {
         void*  ptr  = nullptr;
         size_t size = 0;
 #if QUARISMA_HAS_CUDA
-        cudaStream_t last_stream = nullptr;
-        cudaEvent_t  event       = nullptr;
+        cudaStream_t stream = nullptr;
+        cudaEvent_t  event  = nullptr;
+        // Other streams using the block (record_stream()), and the events
+        // recorded on them when it was freed
+        std::vector<cudaStream_t> stream_uses;
+        std::vector<cudaEvent_t>  use_events;
 #else
-        void* last_stream = nullptr;
-        void* event       = nullptr;
+        void*              stream = nullptr;
+        void*              event  = nullptr;
+        std::vector<void*> stream_uses;
+        std::vector<void*> use_events;
 #endif
-        bool in_use           = false;
-        bool event_pending    = false;
-        bool in_free_list     = false;
-        bool in_deferred_list = false;
+        Block*   prev             = nullptr;
+        Block*   next             = nullptr;
+        uint64_t pool             = 0;  // Graph pool owning the segment, 0 for the shared cache
+        bool     small            = false;
+        bool     in_use           = false;
+        bool     event_pending    = false;
+        bool     in_free_list     = false;
+        bool     in_deferred_list = false;
     };
 
     Impl(int device, size_t max_cached_bytes) : device_(device), max_cached_bytes_(max_cached_bytes)
@@ -117,10 +169,17 @@ struct cuda_caching_allocator::Impl
             "Invalid CUDA device index: " + std::to_string(device) + " (available: 0-" +
                 std::to_string(device_count - 1) + ")");
 #endif
+        pressure_id_ = memory_pressure::instance().register_cache(
+            "cuda_caching_allocator",
+            memory_trim_cost::HIGH,
+            device_enum::CUDA,
+            device,
+            [this](size_t bytes_wanted) { return release_under_pressure(bytes_wanted); });
     }
 
     ~Impl()
     {
+        memory_pressure::instance().unregister_cache(pressure_id_);
         std::scoped_lock const lock(mutex_);
         release_all_blocks_noexcept();
     }
@@ -131,34 +190,48 @@ struct cuda_caching_allocator::Impl
 
         // Debug log (simplified for build compatibility)
 
+        const size_t           rounded = round_size(size);
+        const bool             small   = rounded <= kSmallBytes;
         std::scoped_lock const lock(mutex_);
-        reclaim_deferred_blocks_locked();
 
-        Block* block = find_suitable_block_locked(size);
-
-        if (block == nullptr)
+        Block* block = nullptr;
+        if (auto route = capture_routes_.find(stream); route != capture_routes_.end())
         {
-            block = create_block_locked(size);
-            stats_.cache_misses++;
+            block = take_graph_block_locked(route->second, stream, rounded);
         }
         else
         {
-            cached_bytes_ -= block->size;
-            stats_.bytes_cached = cached_bytes_;
-            stats_.cache_hits++;
+            // Blocks of the stream are reusable at once: work queued on it before
+            // the free completes before work queued after this allocation.
+            if (capture_routes_.empty())
+            {
+                reclaim_deferred_blocks_locked();
+            }
+            block = take_free_block_locked(pool_of(small), stream, rounded);
+
+            if (block == nullptr)
+            {
+                block = create_segment_locked(segment_size(rounded), stream, small);
+                stats_.cache_misses++;
+            }
+            else
+            {
+                stats_.cache_hits++;
+            }
         }
 
-        block->in_use           = true;
-        block->last_stream      = stream;
-        block->event_pending    = false;
-        block->in_free_list     = false;
-        block->in_deferred_list = false;
+        if (should_split(*block, rounded))
+        {
+            split_block_locked(block, rounded);
+        }
 
+        block->in_use = true;
         bytes_in_use_ += block->size;
 
         // Update allocation statistics
         stats_.successful_allocations++;
         stats_.bytes_allocated += block->size;
+        update_cache_stats_locked();
 
         // Debug log (simplified for build compatibility)
 
@@ -186,72 +259,113 @@ struct cuda_caching_allocator::Impl
 
         block->in_use = false;
         bytes_in_use_ -= block->size;
+        auto stream_uses = std::move(block->stream_uses);
+        block->stream_uses.clear();
 
         // Update deallocation statistics
         stats_.successful_frees++;
 
-        if (!should_cache(block->size))
+        // Graph pool blocks are ordered by the graph, or by the caller between replays
+        if (block->pool != 0)
         {
-            // Debug log (simplified for build compatibility)
-            release_block_locked(it);
+            free_block_locked(block);
+            update_cache_stats_locked();
             return;
         }
 
-        cached_bytes_ += block->size;
-        stats_.bytes_cached = cached_bytes_;
-
-        auto* effective_stream = stream != nullptr ? stream : block->last_stream;
+        // A replay may read a block freed during capture until its graph is gone
+        if (auto route = capture_routes_.find(stream); route != capture_routes_.end())
+        {
+            graph_pools_.at(route->second)->held_blocks.push_back(block);
+            return;
+        }
 
-        if (effective_stream == nullptr || effective_stream == block->last_stream)
+        // Freed on another stream, or used by others: the block returns to its
+        // own stream's pool once the work queued so far on them has completed.
+        for (auto use : stream_uses)
         {
-            block->last_stream = effective_stream;
-            insert_ready_block_locked(block);
+            record_use_event_locked(block, use);
         }
-        else
+        if (stream != nullptr && stream != block->stream)
         {
-            record_event_locked(block, effective_stream);
+            record_event_locked(block, stream);
+            return;
+        }
+        if (!stream_uses.empty())
+        {
+            return;
         }
 
-        trim_cache_locked();
+        free_block_locked(block);
+        if (capture_routes_.empty())
+        {
+            trim_cache_locked();
+        }
+        update_cache_stats_locked();
 
         // Debug log (simplified for build compatibility)
     }
 
-    void empty_cache()
+    void record_stream(void* ptr, cuda_caching_allocator::stream_type stream)
     {
         std::scoped_lock const lock(mutex_);
-        DeviceGuard const      guard(device_);
-        reclaim_deferred_blocks_locked(true);
+        auto                   it = blocks_.find(ptr);
+        QUARISMA_CHECK(
+            it != blocks_.end() && it->second->in_use,
+            "cuda_caching_allocator::record_stream needs an allocated block");
 
-        while (!free_blocks_.empty())
+        Block* block = it->second.get();
+        // Graph pool blocks are ordered by the graph, or by the caller between replays
+        if (block->pool != 0 || stream == block->stream)
         {
-            auto   it    = free_blocks_.begin();
-            Block* block = it->second;
-            destroy_event(block);
-            throw_on_cuda_error(cudaFree(block->ptr), "cudaFree");
-            stats_.driver_frees++;
-            blocks_.erase(block->ptr);
-            free_blocks_.erase(it);
+            return;
         }
+        if (std::find(block->stream_uses.begin(), block->stream_uses.end(), stream) ==
+            block->stream_uses.end())
+        {
+            block->stream_uses.push_back(stream);
+        }
+    }
 
-        for (Block* block : deferred_blocks_)
+    void empty_cache()
+    {
+        std::scoped_lock const lock(mutex_);
+        if (!capture_routes_.empty())
         {
-            destroy_event(block);
-            throw_on_cuda_error(cudaFree(block->ptr), "cudaFree");
-            stats_.driver_frees++;
-            blocks_.erase(block->ptr);
+            // Synchronizing or freeing would invalidate the capture
+            return;
         }
-        deferred_blocks_.clear();
+        reclaim_deferred_blocks_locked(true);
+        release_free_segments_locked(0);
+        update_cache_stats_locked();
+    }
 
-        cached_bytes_       = 0;
-        stats_.bytes_cached = 0;
+    /**
+     * @brief memory_pressure callback: release free segments, largest first
+     */
+    size_t release_under_pressure(size_t bytes_wanted)
+    {
+        std::scoped_lock const lock(mutex_);
+        if (!capture_routes_.empty())
+        {
+            return 0;
+        }
+        reclaim_deferred_blocks_locked(true);
+        const size_t before = cached_bytes_;
+        release_free_segments_locked(before > bytes_wanted ? before - bytes_wanted : 0);
+        update_cache_stats_locked();
+        return before - cached_bytes_;
     }
 
     void set_max_cached_bytes(size_t bytes)
     {
         std::scoped_lock const lock(mutex_);
         max_cached_bytes_ = bytes;
-        trim_cache_locked();
+        if (capture_routes_.empty())
+        {
+            trim_cache_locked();
+        }
+        update_cache_stats_locked();
     }
 
     size_t max_cached_bytes() const
@@ -268,45 +382,254 @@ struct cuda_caching_allocator::Impl
         return stats_copy;
     }
 
+    graph_pool_id create_graph_pool(size_t reserve_bytes)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        graph_pool_id const id = next_graph_pool_++;
+        graph_pools_.emplace(id, std::make_unique<GraphPool>());
+        if (reserve_bytes > 0)
+        {
+            Block* block = create_segment_locked(
+                round_up(reserve_bytes, kRoundLargeBytes), nullptr, false, id);
+            insert_free_block_locked(block);
+        }
+        update_cache_stats_locked();
+        return id;
+    }
+
+    void begin_graph_capture(graph_pool_id pool, cuda_caching_allocator::stream_type stream)
+    {
+        std::scoped_lock const lock(mutex_);
+        QUARISMA_CHECK(
+            graph_pools_.find(pool) != graph_pools_.end(), "Unknown graph pool ", pool);
+        QUARISMA_CHECK(
+            stream != nullptr, "The legacy default stream cannot be captured into a graph pool");
+        QUARISMA_CHECK(
+            capture_routes_.emplace(stream, pool).second,
+            "Stream is already routed to a graph pool");
+    }
+
+    void end_graph_capture(cuda_caching_allocator::stream_type stream)
+    {
+        std::scoped_lock const lock(mutex_);
+        capture_routes_.erase(stream);
+        if (capture_routes_.empty())
+        {
+            trim_cache_locked();
+            update_cache_stats_locked();
+        }
+    }
+
+    void release_graph_pool(graph_pool_id pool)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        auto it = graph_pools_.find(pool);
+        QUARISMA_CHECK(it != graph_pools_.end(), "Unknown graph pool ", pool);
+        QUARISMA_CHECK(
+            std::none_of(
+                capture_routes_.begin(),
+                capture_routes_.end(),
+                [pool](const auto& route) { return route.second == pool; }),
+            "Graph pool ",
+            pool,
+            " is still routed to a stream");
+
+        // Segments join the shared large pool of the default stream
+        std::vector<Block*> free_blocks;
+        for (auto& entry : blocks_)
+        {
+            Block* block = entry.second.get();
+            if (block->pool != pool)
+            {
+                continue;
+            }
+            if (block->in_free_list)
+            {
+                remove_free_block_locked(block);
+                free_blocks.push_back(block);
+            }
+            block->pool   = 0;
+            block->stream = nullptr;
+            block->small  = false;
+        }
+        for (Block* block : free_blocks)
+        {
+            insert_free_block_locked(block);
+        }
+
+        std::vector<Block*> held = std::move(it->second->held_blocks);
+        graph_pools_.erase(it);
+        for (Block* block : held)
+        {
+            free_block_locked(block);
+        }
+
+        if (capture_routes_.empty())
+        {
+            trim_cache_locked();
+        }
+        update_cache_stats_locked();
+    }
+
+    size_t graph_pool_bytes(graph_pool_id pool) const
+    {
+        std::scoped_lock const lock(mutex_);
+        auto                   it = graph_pools_.find(pool);
+        QUARISMA_CHECK(it != graph_pools_.end(), "Unknown graph pool ", pool);
+        return it->second->segment_bytes;
+    }
+
     int device() const { return device_; }
 
 private:
+    // Free blocks ordered by stream, then size, so that the best fit of a
+    // stream is a lower_bound away.
+    struct BlockLess
+    {
+        bool operator()(const Block* lhs, const Block* rhs) const
+        {
+            if (lhs->stream != rhs->stream)
+            {
+                return reinterpret_cast<uintptr_t>(lhs->stream) <
+                       reinterpret_cast<uintptr_t>(rhs->stream);
+            }
+            if (lhs->size != rhs->size)
+            {
+                return lhs->size < rhs->size;
+            }
+            return reinterpret_cast<uintptr_t>(lhs->ptr) < reinterpret_cast<uintptr_t>(rhs->ptr);
+        }
+    };
+
     using BlockMap = quarisma_map<void*, std::unique_ptr<Block>>;
-    using FreeList = std::multimap<size_t, Block*>;
+    using FreePool = std::set<Block*, BlockLess>;
 
-    bool should_cache(size_t size) const
+    /**
+     * Private segments of a graph pool. Their blocks have no stream, and
+     * sizes of every class share one free list.
+     */
+    struct GraphPool
     {
-        return max_cached_bytes_ == std::numeric_limits<size_t>::max() || size <= max_cached_bytes_;
+        FreePool            free_blocks;
+        size_t              segment_bytes = 0;
+        std::vector<Block*> held_blocks;  // Shared-cache blocks freed during capture
+    };
+
+    FreePool& pool_of(bool small) { return small ? small_blocks_ : large_blocks_; }
+
+    FreePool& pool_of(const Block& block)
+    {
+        return block.pool != 0 ? graph_pools_.at(block.pool)->free_blocks : pool_of(block.small);
+    }
+
+    static bool should_split(const Block& block, size_t size)
+    {
+        const size_t remaining = block.size - size;
+        // Graph pools cannot grow during capture, so they are packed tightly
+        return block.small || block.pool != 0 ? remaining >= kRoundBytes : remaining > kSmallBytes;
     }
 
-    Block* find_suitable_block_locked(size_t size)
+    static bool is_capturing(cuda_caching_allocator::stream_type stream)
     {
-        auto it = free_blocks_.lower_bound(size);
-        if (it == free_blocks_.end())
+        cudaStreamCaptureStatus status = cudaStreamCaptureStatusNone;
+        return cudaStreamIsCapturing(stream, &status) == cudaSuccess &&
+               status != cudaStreamCaptureStatusNone;
+    }
+
+    Block* take_graph_block_locked(
+        graph_pool_id pool, cuda_caching_allocator::stream_type stream, size_t size)
+    {
+        Block* block = take_free_block_locked(graph_pools_.at(pool)->free_blocks, nullptr, size);
+        if (block != nullptr)
+        {
+            stats_.cache_hits++;
+            return block;
+        }
+
+        if (is_capturing(stream))
+        {
+            QUARISMA_LOG_ERROR(
+                "Graph pool {} has no free block of {} bytes during capture; reserve more "
+                "memory before capturing",
+                pool,
+                size);
+            throw std::bad_alloc();
+        }
+        stats_.cache_misses++;
+        return create_segment_locked(segment_size(size), nullptr, false, pool);
+    }
+
+    Block* take_free_block_locked(
+        FreePool& pool, cuda_caching_allocator::stream_type stream, size_t size)
+    {
+        Block key;
+        key.stream = stream;
+        key.size   = size;
+        auto it    = pool.lower_bound(&key);
+        if (it == pool.end() || (*it)->stream != stream)
         {
             return nullptr;
         }
-        Block* block = it->second;
-        free_blocks_.erase(it);
+        Block* block = *it;
+        pool.erase(it);
         block->in_free_list = false;
+        if (block->pool == 0)
+        {
+            cached_bytes_ -= block->size;
+        }
         return block;
     }
 
-    Block* create_block_locked(size_t size)
+    Block* create_segment_locked(
+        size_t                              size,
+        cuda_caching_allocator::stream_type stream,
+        bool                                small,
+        graph_pool_id                       pool = 0)
     {
         DeviceGuard const guard(device_);
         void*             ptr    = nullptr;
-        cudaError_t const result = cudaMalloc(&ptr, size);
-        if (result != cudaSuccess)
+        cudaError_t       result = cudaMalloc(&ptr, size);
+        if (result != cudaSuccess && !capture_routes_.empty())
         {
+            (void)cudaGetLastError();
             throw std::bad_alloc();
         }
+        if (result != cudaSuccess)
+        {
+            // Return the cached segments of every stream to the driver and retry
+            (void)cudaGetLastError();
+            reclaim_deferred_blocks_locked(true);
+            release_free_segments_locked(0);
+            result = cudaMalloc(&ptr, size);
+        }
+        if (result != cudaSuccess)
+        {
+            // Then have the other caches of the device give memory back
+            (void)cudaGetLastError();
+            auto& pressure = memory_pressure::instance();
+            if (pressure.relieve(device_enum::CUDA, device_, size, pressure_id_) > 0)
+            {
+                result = cudaMalloc(&ptr, size);
+            }
+            if (result != cudaSuccess)
+            {
+                (void)cudaGetLastError();
+                throw std::bad_alloc();
+            }
+        }
 
-        auto block         = std::make_unique<Block>();
-        block->ptr         = ptr;
-        block->size        = size;
-        block->last_stream = nullptr;
-        block->in_use      = false;
+        auto block    = std::make_unique<Block>();
+        block->ptr    = ptr;
+        block->size   = size;
+        block->stream = stream;
+        block->small  = small;
+        block->pool   = pool;
+        if (pool != 0)
+        {
+            graph_pools_.at(pool)->segment_bytes += size;
+        }
 
         Block* raw = block.get();  //NOLINT
         blocks_.emplace(ptr, std::move(block));
@@ -315,14 +638,82 @@ private:
         return raw;
     }
 
-    void insert_ready_block_locked(Block* block)
+    // Keeps the first `size` bytes in `block`; the rest becomes a free block.
+    void split_block_locked(Block* block, size_t size)
+    {
+        auto remaining    = std::make_unique<Block>();
+        remaining->ptr    = static_cast<char*>(block->ptr) + size;
+        remaining->size   = block->size - size;
+        remaining->stream = block->stream;
+        remaining->small  = block->small;
+        remaining->pool   = block->pool;
+        remaining->prev   = block;
+        remaining->next   = block->next;
+        if (block->next != nullptr)
+        {
+            block->next->prev = remaining.get();
+        }
+        block->next = remaining.get();
+        block->size = size;
+
+        Block* raw = remaining.get();  //NOLINT
+        blocks_.emplace(raw->ptr, std::move(remaining));
+        insert_free_block_locked(raw);
+    }
+
+    // Merges `block` with its free neighbours and returns it to its pool.
+    void free_block_locked(Block* block)
+    {
+        if (Block* prev = block->prev; prev != nullptr && prev->in_free_list)
+        {
+            remove_free_block_locked(prev);
+            prev->size += block->size;
+            unlink_block_locked(block);
+            block = prev;
+        }
+        if (Block* next = block->next; next != nullptr && next->in_free_list)
+        {
+            remove_free_block_locked(next);
+            block->size += next->size;
+            unlink_block_locked(next);
+        }
+        insert_free_block_locked(block);
+    }
+
+    // Removes a block absorbed by its predecessor from the segment.
+    void unlink_block_locked(Block* block)
+    {
+        block->prev->next = block->next;
+        if (block->next != nullptr)
+        {
+            block->next->prev = block->prev;
+        }
+        destroy_event(block);
+        blocks_.erase(block->ptr);
+    }
+
+    void insert_free_block_locked(Block* block)
     {
         if (block->in_free_list)
         {
             return;
         }
-        free_blocks_.emplace(block->size, block);
+        pool_of(*block).insert(block);
         block->in_free_list = true;
+        if (block->pool == 0)
+        {
+            cached_bytes_ += block->size;
+        }
+    }
+
+    void remove_free_block_locked(Block* block)
+    {
+        pool_of(*block).erase(block);
+        block->in_free_list = false;
+        if (block->pool == 0)
+        {
+            cached_bytes_ -= block->size;
+        }
     }
 
     void record_event_locked(Block* block, cudaStream_t stream)
@@ -336,7 +727,6 @@ private:
         }
         throw_on_cuda_error(cudaEventRecord(block->event, stream), "cudaEventRecord");
         block->event_pending = true;
-        block->last_stream   = stream;
         if (!block->in_deferred_list)
         {
             deferred_blocks_.push_back(block);
@@ -344,90 +734,140 @@ private:
         }
     }
 
-    void reclaim_deferred_blocks_locked(bool force = false)
+    void record_use_event_locked(Block* block, cudaStream_t stream)
     {
-        if (deferred_blocks_.empty())
+        DeviceGuard const guard(device_);
+        cudaEvent_t       event = nullptr;
+        throw_on_cuda_error(
+            cudaEventCreateWithFlags(&event, cudaEventDisableTiming), "cudaEventCreateWithFlags");
+        block->use_events.push_back(event);
+        throw_on_cuda_error(cudaEventRecord(event, stream), "cudaEventRecord");
+        if (!block->in_deferred_list)
         {
-            return;
+            deferred_blocks_.push_back(block);
+            block->in_deferred_list = true;
         }
+    }
 
-        DeviceGuard const guard(device_);
-        size_t            index = 0;
-        while (index < deferred_blocks_.size())
+    // Whether the work before the events of a deferred block has completed,
+    // waiting for it if `force`. Completed use events are destroyed.
+    static bool deferred_block_ready(Block* block, bool force)
+    {
+        auto completed = [force](cudaEvent_t event)
         {
-            Block* block = deferred_blocks_[index];
-            bool   ready = false;
-
-            if (!block->event_pending)
+            if (force)
             {
-                ready = true;
+                throw_on_cuda_error(cudaEventSynchronize(event), "cudaEventSynchronize");
+                return true;
             }
-            else if (force)
+            cudaError_t const status = cudaEventQuery(event);
+            if (status == cudaErrorNotReady)
             {
-                throw_on_cuda_error(cudaEventSynchronize(block->event), "cudaEventSynchronize");
-                ready = true;
+                return false;
             }
-            else
+            throw_on_cuda_error(status, "cudaEventQuery");
+            return true;
+        };
+
+        if (block->event_pending)
+        {
+            if (!completed(block->event))
             {
-                cudaError_t const status = cudaEventQuery(block->event);
-                if (status == cudaSuccess)
-                {
-                    ready = true;
-                }
-                else if (status == cudaErrorNotReady)
-                {
-                    ++index;
-                    continue;
-                }
-                else
-                {
-                    throw_on_cuda_error(status, "cudaEventQuery");
-                }
+                return false;
             }
-
-            if (ready)
+            block->event_pending = false;
+        }
+        while (!block->use_events.empty())
+        {
+            if (!completed(block->use_events.back()))
             {
-                block->event_pending    = false;
-                block->in_deferred_list = false;
-                deferred_blocks_[index] = deferred_blocks_.back();
-                deferred_blocks_.pop_back();
-                insert_ready_block_locked(block);
+                return false;
             }
+            cudaEventDestroy(block->use_events.back());
+            block->use_events.pop_back();
         }
+        return true;
     }
 
-    void trim_cache_locked()
+    void reclaim_deferred_blocks_locked(bool force = false)
     {
-        if (max_cached_bytes_ == std::numeric_limits<size_t>::max())
+        if (deferred_blocks_.empty())
         {
             return;
         }
 
         DeviceGuard const guard(device_);
-        while (cached_bytes_ > max_cached_bytes_ && !free_blocks_.empty())
+        size_t            index = 0;
+        while (index < deferred_blocks_.size())
         {
-            auto   it    = std::prev(free_blocks_.end());
-            Block* block = it->second;
-            cached_bytes_ -= block->size;
-            stats_.bytes_cached = cached_bytes_;
-            destroy_event(block);
-            throw_on_cuda_error(cudaFree(block->ptr), "cudaFree");
-            stats_.driver_frees++;
-            blocks_.erase(block->ptr);
-            free_blocks_.erase(it);
+            Block* block = deferred_blocks_[index];
+            if (!deferred_block_ready(block, force))
+            {
+                ++index;
+                continue;
+            }
+
+            block->in_deferred_list = false;
+            deferred_blocks_[index] = deferred_blocks_.back();
+            deferred_blocks_.pop_back();
+            free_block_locked(block);
         }
     }
 
-    void release_block_locked(BlockMap::iterator it)
+    void trim_cache_locked()
     {
-        Block* block = it->second.get();
+        if (max_cached_bytes_ == std::numeric_limits<size_t>::max() ||
+            cached_bytes_ <= max_cached_bytes_)
+        {
+            return;
+        }
+        release_free_segments_locked(max_cached_bytes_);
+    }
 
+    // Returns wholly free segments to the driver, largest first, until at most
+    // `target` bytes are cached. Free blocks of partly used segments stay.
+    void release_free_segments_locked(size_t target)
+    {
         DeviceGuard const guard(device_);
-        destroy_event(block);
-        throw_on_cuda_error(cudaFree(block->ptr), "cudaFree");
-        stats_.driver_frees++;
+        for (FreePool* pool : {&large_blocks_, &small_blocks_})
+        {
+            std::vector<Block*> segments;
+            for (Block* block : *pool)
+            {
+                if (block->prev == nullptr && block->next == nullptr)
+                {
+                    segments.push_back(block);
+                }
+            }
+            std::sort(
+                segments.begin(),
+                segments.end(),
+                [](const Block* lhs, const Block* rhs) { return lhs->size > rhs->size; });
 
-        blocks_.erase(it);
+            for (Block* block : segments)
+            {
+                if (cached_bytes_ <= target)
+                {
+                    return;
+                }
+                remove_free_block_locked(block);
+                destroy_event(block);
+                throw_on_cuda_error(cudaFree(block->ptr), "cudaFree");
+                stats_.driver_frees++;
+                stats_.cache_evictions++;
+                blocks_.erase(block->ptr);
+            }
+        }
+    }
+
+    void update_cache_stats_locked()
+    {
+        stats_.bytes_cached = cached_bytes_;
+        stats_.cache_blocks = small_blocks_.size() + large_blocks_.size();
+        if (cached_bytes_ > stats_.peak_bytes_cached)
+        {
+            stats_.peak_bytes_cached = cached_bytes_;
+        }
     }
 
     static void destroy_event(Block* block)
@@ -437,6 +877,11 @@ private:
             cudaEventDestroy(block->event);
             block->event = nullptr;
         }
+        for (auto event : block->use_events)
+        {
+            cudaEventDestroy(event);
+        }
+        block->use_events.clear();
         block->event_pending    = false;
         block->in_deferred_list = false;
     }
@@ -447,33 +892,40 @@ private:
         for (auto& entry : blocks_)
         {
             Block* block = entry.second.get();
-            if (block->event != nullptr)
-            {
-                cudaEventDestroy(block->event);
-                block->event = nullptr;
-            }
-            if (block->ptr != nullptr)
+            destroy_event(block);
+            // Segments are freed through their first block
+            if (block->ptr != nullptr && block->prev == nullptr)
             {
                 cudaFree(block->ptr);
             }
         }
         blocks_.clear();
-        free_blocks_.clear();
+        small_blocks_.clear();
+        large_blocks_.clear();
         deferred_blocks_.clear();
+        graph_pools_.clear();
+        capture_routes_.clear();
         cached_bytes_ = 0;
         bytes_in_use_ = 0;
     }
 
     int    device_;
     size_t max_cached_bytes_;
-    size_t cached_bytes_{0};
+    size_t cached_bytes_{0};  // Free bytes inside segments
     size_t bytes_in_use_{0};
 
-    mutable std::mutex  mutex_;
-    BlockMap            blocks_;
-    FreeList            free_blocks_;
-    std::vector<Block*> deferred_blocks_;
-    unified_cache_stats stats_;
+    mutable profiled_mutex mutex_{"cuda_caching_allocator"};
+    BlockMap               blocks_;  // Every block of every segment, by address
+    FreePool               small_blocks_;
+    FreePool               large_blocks_;
+    std::vector<Block*>    deferred_blocks_;
+    unified_cache_stats    stats_;
+
+    quarisma_map<graph_pool_id, std::unique_ptr<GraphPool>>         graph_pools_;
+    quarisma_map<cuda_caching_allocator::stream_type, graph_pool_id> capture_routes_;
+    graph_pool_id                                                    next_graph_pool_{1};
+
+    memory_pressure::cache_id pressure_id_{0};
 };
 
 cuda_caching_allocator::cuda_caching_allocator(int device, size_t max_cached_bytes)
@@ -503,11 +955,55 @@ void cuda_caching_allocator::deallocate(void* ptr, size_t size, stream_type stre
     impl_->deallocate(ptr, size, stream);
 }
 
+void cuda_caching_allocator::record_stream(void* ptr, stream_type stream)
+{
+    impl_->record_stream(ptr, stream);
+}
+
 void cuda_caching_allocator::empty_cache()
 {
     impl_->empty_cache();
 }
 
+size_t cuda_caching_allocator::warm_up(
+    const allocation_profile&         profile,
+    const allocation_warm_up_options& options,
+    stream_type                       stream)
+{
+    std::vector<allocation_profile::size_class> classes = profile.classes;
+    if (classes.empty() && profile.peak_bytes_in_use > 0)
+    {
+        classes.push_back({profile.peak_bytes_in_use, 1});
+    }
+
+    std::vector<std::pair<void*, size_t>> blocks;
+    size_t                                warmed = 0;
+    try
+    {
+        for (const auto& c : classes)
+        {
+            size_t const count = std::min(c.peak_count, (options.max_bytes - warmed) / c.bytes);
+            for (size_t i = 0; i < count; ++i)
+            {
+                blocks.emplace_back(allocate(c.bytes, stream), c.bytes);
+                warmed += c.bytes;
+            }
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        // Keep what was reserved so far
+    }
+
+    for (const auto& [ptr, bytes] : blocks)
+    {
+        deallocate(ptr, bytes, stream);
+    }
+
+    QUARISMA_LOG_INFO("Warmed up CUDA caching allocator {} with {} bytes", device(), warmed);
+    return warmed;
+}
+
 void cuda_caching_allocator::set_max_cached_bytes(size_t bytes)
 {
     impl_->set_max_cached_bytes(bytes);
@@ -523,9 +1019,59 @@ unified_cache_stats cuda_caching_allocator::stats() const
     return impl_->stats();
 }
 
+cuda_caching_allocator::graph_pool_id cuda_caching_allocator::create_graph_pool(
+    size_t reserve_bytes)
+{
+    return impl_->create_graph_pool(reserve_bytes);
+}
+
+void cuda_caching_allocator::begin_graph_capture(graph_pool_id pool, stream_type stream)
+{
+    impl_->begin_graph_capture(pool, stream);
+}
+
+void cuda_caching_allocator::end_graph_capture(stream_type stream)
+{
+    impl_->end_graph_capture(stream);
+}
+
+void cuda_caching_allocator::release_graph_pool(graph_pool_id pool)
+{
+    impl_->release_graph_pool(pool);
+}
+
+size_t cuda_caching_allocator::graph_pool_bytes(graph_pool_id pool) const
+{
+    return impl_->graph_pool_bytes(pool);
+}
+
 int cuda_caching_allocator::device() const
 {
     return impl_->device();
 }
+
+cuda_caching_allocator& cuda_caching_allocator::instance(int device)
+{
+    constexpr int kMaxDevices = 64;
+    QUARISMA_CHECK(
+        device >= 0 && device < kMaxDevices, "Invalid CUDA device index: ", device);
+
+    static std::array<std::atomic<cuda_caching_allocator*>, kMaxDevices> instances{};
+    static std::mutex                                                   mutex;
+
+    cuda_caching_allocator* allocator = instances[device].load(std::memory_order_acquire);
+    if QUARISMA_UNLIKELY (allocator == nullptr)
+    {
+        std::scoped_lock const lock(mutex);
+        allocator = instances[device].load(std::memory_order_relaxed);
+        if (allocator == nullptr)
+        {
+            // Leaked on purpose, see the header
+            allocator = new cuda_caching_allocator(device);
+            instances[device].store(allocator, std::memory_order_release);
+        }
+    }
+    return *allocator;
+}
 }  // namespace gpu
 }  // namespace quarisma
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <string>
@@ -27,6 +28,7 @@
 #include "common/configure.h"
 #include "common/macros.h"
 #include "memory/device.h"
+#include "memory/helper/allocation_profile.h"
 #include "memory/unified_memory_stats.h"
 
 #if QUARISMA_HAS_CUDA
@@ -44,9 +46,36 @@ namespace gpu
  * of GPU memory blocks. It's optimized for Monte Carlo simulations and PDE solvers
  * where frequent allocation/deallocation patterns can benefit from caching.
  *
+ * Memory is obtained from the driver in segments (2 MiB for requests of up to
+ * 1 MiB, 20 MiB up to 10 MiB, and a segment of its own above) that are split
+ * into blocks on allocation and merged back on free, as allocator_bfc does
+ * for host memory. Segments belong to the stream that allocated them: a block
+ * freed on that stream is reusable by its next allocation at once, while one
+ * freed on another stream waits for an event recorded there.
+ *
+ * CUDA graph capture must not call cudaMalloc, cudaFree or synchronizing
+ * event functions, and a replayed graph touches the addresses it captured.
+ * Allocations on a stream routed to a graph pool (begin_graph_capture()) are
+ * therefore served from the pool's private segments, reserved beforehand, and
+ * the pool keeps those addresses until it is released. While any stream is
+ * routed, the allocator neither polls events nor returns memory to the driver.
+ *
+ * @code
+ * auto pool = allocator.create_graph_pool(64 << 20);
+ * allocator.begin_graph_capture(pool, stream);
+ * cudaStreamBeginCapture(stream, cudaStreamCaptureModeGlobal);
+ * // ... allocate, launch and free on `stream` ...
+ * cudaStreamEndCapture(stream, &graph);
+ * allocator.end_graph_capture(stream);
+ * // ... replay the graph; destroy it, then:
+ * allocator.release_graph_pool(pool);
+ * @endcode
+ *
  * Features:
- * - Stream-aware memory caching with CUDA events
- * - Configurable cache size limits
+ * - Per-stream free pools with best fit, block splitting and coalescing
+ * - Stream-aware memory caching with CUDA events for cross-stream frees
+ * - Private graph pools with fixed addresses for CUDA graph capture
+ * - Configurable cache size limits (whole free segments are released)
  * - Comprehensive performance statistics
  * - Thread-safe operations
  * - Exception-safe RAII design
@@ -63,6 +92,9 @@ public:
     using stream_type = void*;
 #endif
 
+    /** @brief Identifier of a graph pool, never 0 */
+    using graph_pool_id = uint64_t;
+
     /**
      * @brief Construct a CUDA caching allocator
      * @param device CUDA device index (default: 0)
@@ -97,12 +129,45 @@ public:
      */
     QUARISMA_API void deallocate(void* ptr, size_t size, stream_type stream = nullptr);
 
+    /**
+     * @brief Mark an allocated block as used by work queued on another stream
+     *
+     * When the block is freed, it returns to the cache only once the work
+     * queued until then on each recorded stream has completed. Recording the
+     * stream the block was allocated on, or a block of a graph pool, is a no-op.
+     *
+     * @param ptr Pointer returned by allocate() and not yet freed
+     * @param stream Stream that uses the block
+     * @throws std::invalid_argument if ptr is not an allocated block of this allocator
+     */
+    QUARISMA_API void record_stream(void* ptr, stream_type stream);
+
     /**
      * @brief Clear all cached memory immediately
+     *
+     * Segments with a block in use are kept.
+     *
      * @note This will synchronize with all pending CUDA operations
      */
     QUARISMA_API void empty_cache();
 
+    /**
+     * @brief Fill the cache of stream with the blocks a profile says it will need
+     *
+     * Makes peak_count allocations of each class of the profile, smallest
+     * first and within options.max_bytes, then frees them on stream, so that
+     * its first requests after startup are served without cudaMalloc. A
+     * profile without classes (allocation_profile::from_stats()) reserves one
+     * block of its peak bytes in use. Stops at the first failed allocation;
+     * max_cached_bytes() still bounds what stays cached.
+     *
+     * @return Bytes allocated and cached
+     */
+    QUARISMA_API size_t warm_up(
+        const allocation_profile&         profile,
+        const allocation_warm_up_options& options = {},
+        stream_type                       stream  = nullptr);
+
     /**
      * @brief Set maximum bytes to cache
      * @param bytes Maximum cache size (0 = no caching)
@@ -115,6 +180,58 @@ public:
      */
     QUARISMA_API size_t max_cached_bytes() const;
 
+    /**
+     * @brief Create a private pool for allocations made during graph capture
+     * @param reserve_bytes Bytes to reserve now, outside of any capture (0 = none)
+     * @return Identifier of the pool
+     * @throws std::bad_alloc if the reservation fails
+     *
+     * Allocations that do not fit grow the pool as long as their stream is not
+     * capturing, so an eager warm-up run between begin_graph_capture() and the
+     * start of the capture sizes the pool exactly.
+     */
+    QUARISMA_API graph_pool_id create_graph_pool(size_t reserve_bytes = 0);
+
+    /**
+     * @brief Route allocations on `stream` to a graph pool
+     *
+     * Blocks of the pool freed during capture are reused by later allocations
+     * of the capture, which the graph orders on the stream. Shared-cache
+     * blocks freed on `stream` are held back until the pool is released, as
+     * replays may still read them. Several streams, e.g. those forked from a
+     * capturing stream, may be routed to one pool.
+     *
+     * @param pool Pool from create_graph_pool()
+     * @param stream Stream to be captured (not the legacy default stream)
+     * @throws std::invalid_argument if the pool is unknown or the stream is routed
+     * @throws std::bad_alloc from allocate() if the pool is exhausted while
+     *         `stream` is capturing
+     */
+    QUARISMA_API void begin_graph_capture(graph_pool_id pool, stream_type stream);
+
+    /**
+     * @brief Stop routing allocations on `stream` to its graph pool
+     *
+     * Blocks still allocated, e.g. graph outputs, keep their addresses.
+     */
+    QUARISMA_API void end_graph_capture(stream_type stream);
+
+    /**
+     * @brief Hand the segments of a graph pool back to the shared cache
+     *
+     * Call once the graphs captured into the pool are destroyed. Blocks still
+     * in use become ordinary blocks of the shared cache.
+     *
+     * @throws std::invalid_argument if the pool is unknown or a stream is routed to it
+     */
+    QUARISMA_API void release_graph_pool(graph_pool_id pool);
+
+    /**
+     * @brief Get the bytes of the segments a graph pool owns
+     * @throws std::invalid_argument if the pool is unknown
+     */
+    QUARISMA_API size_t graph_pool_bytes(graph_pool_id pool) const;
+
     /**
      * @brief Get comprehensive allocation statistics
      * @return Statistics structure with performance metrics
@@ -127,6 +244,19 @@ public:
      */
     QUARISMA_API int device() const;
 
+    /**
+     * @brief The process-wide allocator of a device
+     *
+     * Every component that caches device memory should allocate through this
+     * instance, so that there is one cache per device and one set of
+     * statistics. It is created on first use and never destroyed, so blocks
+     * may be freed during static destruction.
+     *
+     * @param device CUDA device index
+     * @throws std::invalid_argument if the device index is invalid
+     */
+    QUARISMA_API static cuda_caching_allocator& instance(int device);
+
     // Non-copyable but movable
     cuda_caching_allocator(const cuda_caching_allocator&)                       = delete;
     cuda_caching_allocator&            operator=(const cuda_caching_allocator&) = delete;
@@ -0,0 +1,413 @@
+#include "memory/gpu/cuda_pinned_host_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "memory/device.h"
+#include "memory/helper/memory_pressure.h"
+#include "parallel/profiled_mutex.h"
+#include "util/exception.h"
+#include "util/flat_hash.h"
+
+#if QUARISMA_HAS_CUDA
+#include <cuda_runtime.h>
+#endif
+
+namespace quarisma
+{
+namespace gpu
+{
+namespace
+{
+
+inline void throw_on_cuda_error(cudaError_t result, const char* what)
+{
+    if (result != cudaSuccess)
+    {
+        std::string const message = std::string(what) + ": " + cudaGetErrorString(result);
+        throw std::runtime_error(message);
+    }
+}
+
+// Requests are rounded up to a power of two of at least kMinBufferBytes
+constexpr size_t kMinBufferBytes = 512;
+
+size_t round_size(size_t size)
+{
+    size_t rounded = kMinBufferBytes;
+    while (rounded < size)
+    {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+}  // namespace
+
+struct cuda_pinned_host_allocator::Impl
+{
+    /**
+     * A buffer of one cudaHostAlloc, with the streams using it and, once
+     * freed, the events recorded on them
+     */
+    struct Block
+    {
+        void*                     ptr    = nullptr;
+        size_t                    size   = 0;
+        bool                      in_use = false;
+        std::vector<cudaStream_t> stream_uses;
+        std::vector<cudaEvent_t>  use_events;
+    };
+
+    explicit Impl(size_t max_cached_bytes) : max_cached_bytes_(max_cached_bytes)
+    {
+        pressure_id_ = memory_pressure::instance().register_cache(
+            "cuda_pinned_host_allocator",
+            memory_trim_cost::HIGH,
+            device_enum::CPU,
+            -1,
+            [this](size_t bytes_wanted) { return release_under_pressure(bytes_wanted); });
+    }
+
+    ~Impl()
+    {
+        memory_pressure::instance().unregister_cache(pressure_id_);
+        std::scoped_lock const lock(mutex_);
+        for (auto& entry : blocks_)
+        {
+            Block* block = entry.second.get();
+            destroy_events(block);
+            cudaFreeHost(block->ptr);
+        }
+        blocks_.clear();
+        free_blocks_.clear();
+        deferred_blocks_.clear();
+    }
+
+    void* allocate(size_t size)
+    {
+        const size_t           rounded = round_size(size);
+        std::scoped_lock const lock(mutex_);
+
+        reclaim_deferred_blocks_locked();
+        auto& free_list = free_blocks_[rounded];
+        if (!free_list.empty())
+        {
+            Block* block = free_list.back();
+            free_list.pop_back();
+            block->in_use = true;
+            cached_bytes_ -= block->size;
+            stats_.cache_hits++;
+            stats_.successful_allocations++;
+            stats_.bytes_allocated += block->size;
+            update_cache_stats_locked();
+            return block->ptr;
+        }
+
+        stats_.cache_misses++;
+        void* ptr = host_alloc_locked(rounded);
+
+        auto block    = std::make_unique<Block>();
+        block->ptr    = ptr;
+        block->size   = rounded;
+        block->in_use = true;
+        blocks_.emplace(ptr, std::move(block));
+
+        stats_.driver_allocations++;
+        stats_.successful_allocations++;
+        stats_.bytes_allocated += rounded;
+        return ptr;
+    }
+
+    void deallocate(void* ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        std::scoped_lock const lock(mutex_);
+        auto                   it = blocks_.find(ptr);
+        QUARISMA_CHECK(
+            it != blocks_.end(), "cuda_pinned_host_allocator does not own the provided pointer");
+
+        Block* block = it->second.get();
+        QUARISMA_CHECK(block->in_use, "cuda_pinned_host_allocator detected a double free");
+
+        block->in_use = false;
+        stats_.successful_frees++;
+
+        if (!block->stream_uses.empty())
+        {
+            for (auto stream : block->stream_uses)
+            {
+                cudaEvent_t event = nullptr;
+                throw_on_cuda_error(
+                    cudaEventCreateWithFlags(&event, cudaEventDisableTiming),
+                    "cudaEventCreateWithFlags");
+                block->use_events.push_back(event);
+                throw_on_cuda_error(cudaEventRecord(event, stream), "cudaEventRecord");
+            }
+            block->stream_uses.clear();
+            deferred_blocks_.push_back(block);
+            return;
+        }
+
+        free_block_locked(block);
+        trim_cache_locked(max_cached_bytes_);
+        update_cache_stats_locked();
+    }
+
+    void record_stream(void* ptr, cudaStream_t stream)
+    {
+        std::scoped_lock const lock(mutex_);
+        auto                   it = blocks_.find(ptr);
+        QUARISMA_CHECK(
+            it != blocks_.end() && it->second->in_use,
+            "cuda_pinned_host_allocator::record_stream needs an allocated buffer");
+
+        auto& uses = it->second->stream_uses;
+        if (std::find(uses.begin(), uses.end(), stream) == uses.end())
+        {
+            uses.push_back(stream);
+        }
+    }
+
+    bool owns(const void* ptr) const
+    {
+        std::scoped_lock const lock(mutex_);
+        return blocks_.find(const_cast<void*>(ptr)) != blocks_.end();  //NOLINT
+    }
+
+    void empty_cache()
+    {
+        std::scoped_lock const lock(mutex_);
+        reclaim_deferred_blocks_locked();
+        trim_cache_locked(0);
+        update_cache_stats_locked();
+    }
+
+    void set_max_cached_bytes(size_t bytes)
+    {
+        std::scoped_lock const lock(mutex_);
+        max_cached_bytes_ = bytes;
+        trim_cache_locked(max_cached_bytes_);
+        update_cache_stats_locked();
+    }
+
+    unified_cache_stats stats() const
+    {
+        std::scoped_lock const lock(mutex_);
+        unified_cache_stats const stats_copy(stats_);
+        return stats_copy;
+    }
+
+private:
+    /**
+     * @brief memory_pressure callback: release free buffers, largest first
+     */
+    size_t release_under_pressure(size_t bytes_wanted)
+    {
+        std::scoped_lock const lock(mutex_);
+        reclaim_deferred_blocks_locked();
+        const size_t before = cached_bytes_;
+        trim_cache_locked(before > bytes_wanted ? before - bytes_wanted : 0);
+        update_cache_stats_locked();
+        return before - cached_bytes_;
+    }
+
+    void* host_alloc_locked(size_t size)
+    {
+        void* ptr = nullptr;
+        if (cudaHostAlloc(&ptr, size, cudaHostAllocDefault) == cudaSuccess)
+        {
+            return ptr;
+        }
+
+        // Return the cached buffers to the driver and retry, then have the
+        // other host caches give memory back
+        (void)cudaGetLastError();
+        reclaim_deferred_blocks_locked();
+        trim_cache_locked(0);
+        if (cudaHostAlloc(&ptr, size, cudaHostAllocDefault) == cudaSuccess)
+        {
+            return ptr;
+        }
+        (void)cudaGetLastError();
+        auto& pressure = memory_pressure::instance();
+        if (pressure.relieve(device_enum::CPU, -1, size, pressure_id_) > 0 &&
+            cudaHostAlloc(&ptr, size, cudaHostAllocDefault) == cudaSuccess)
+        {
+            return ptr;
+        }
+        (void)cudaGetLastError();
+        throw std::bad_alloc();
+    }
+
+    void free_block_locked(Block* block)
+    {
+        free_blocks_[block->size].push_back(block);
+        cached_bytes_ += block->size;
+    }
+
+    // Moves the deferred buffers whose streams have drained to the free lists
+    void reclaim_deferred_blocks_locked()
+    {
+        auto ready = [](Block* block)
+        {
+            while (!block->use_events.empty())
+            {
+                cudaError_t const status = cudaEventQuery(block->use_events.back());
+                if (status == cudaErrorNotReady)
+                {
+                    return false;
+                }
+                throw_on_cuda_error(status, "cudaEventQuery");
+                cudaEventDestroy(block->use_events.back());
+                block->use_events.pop_back();
+            }
+            return true;
+        };
+
+        auto pending = std::partition(
+            deferred_blocks_.begin(),
+            deferred_blocks_.end(),
+            [&ready](Block* block) { return !ready(block); });
+        for (auto it = pending; it != deferred_blocks_.end(); ++it)
+        {
+            free_block_locked(*it);
+        }
+        deferred_blocks_.erase(pending, deferred_blocks_.end());
+    }
+
+    // Releases free buffers, largest first, until at most `target` bytes are cached
+    void trim_cache_locked(size_t target)
+    {
+        if (cached_bytes_ <= target)
+        {
+            return;
+        }
+
+        std::vector<size_t> sizes;
+        sizes.reserve(free_blocks_.size());
+        for (const auto& entry : free_blocks_)
+        {
+            sizes.push_back(entry.first);
+        }
+        std::sort(sizes.begin(), sizes.end(), std::greater<>());
+
+        for (size_t const size : sizes)
+        {
+            auto& free_list = free_blocks_[size];
+            while (!free_list.empty() && cached_bytes_ > target)
+            {
+                Block* block = free_list.back();
+                free_list.pop_back();
+                cached_bytes_ -= block->size;
+                cudaFreeHost(block->ptr);
+                blocks_.erase(block->ptr);
+                stats_.driver_frees++;
+                stats_.cache_evictions++;
+            }
+        }
+    }
+
+    void update_cache_stats_locked()
+    {
+        size_t cache_blocks = 0;
+        for (const auto& entry : free_blocks_)
+        {
+            cache_blocks += entry.second.size();
+        }
+        stats_.bytes_cached = cached_bytes_;
+        stats_.cache_blocks = cache_blocks;
+        if (cached_bytes_ > stats_.peak_bytes_cached)
+        {
+            stats_.peak_bytes_cached = cached_bytes_;
+        }
+    }
+
+    static void destroy_events(Block* block)
+    {
+        for (auto event : block->use_events)
+        {
+            cudaEventDestroy(event);
+        }
+        block->use_events.clear();
+    }
+
+    size_t max_cached_bytes_;
+    size_t cached_bytes_{0};  // Bytes of the buffers in the free lists
+
+    mutable profiled_mutex                      mutex_{"cuda_pinned_host_allocator"};
+    quarisma_map<void*, std::unique_ptr<Block>> blocks_;       // Every buffer, by address
+    quarisma_map<size_t, std::vector<Block*>>   free_blocks_;  // Free buffers, by size
+    std::vector<Block*>                         deferred_blocks_;
+    unified_cache_stats                         stats_;
+    memory_pressure::cache_id                   pressure_id_{0};
+};
+
+cuda_pinned_host_allocator::cuda_pinned_host_allocator(size_t max_cached_bytes)
+    : impl_(std::make_unique<Impl>(max_cached_bytes))
+{
+}
+
+cuda_pinned_host_allocator::~cuda_pinned_host_allocator() = default;
+
+void* cuda_pinned_host_allocator::allocate(size_t size)
+{
+    if QUARISMA_UNLIKELY (size == 0)
+    {
+        return nullptr;
+    }
+    return impl_->allocate(size);
+}
+
+void cuda_pinned_host_allocator::deallocate(void* ptr)
+{
+    impl_->deallocate(ptr);
+}
+
+void cuda_pinned_host_allocator::record_stream(void* ptr, stream_type stream)
+{
+    impl_->record_stream(ptr, stream);
+}
+
+bool cuda_pinned_host_allocator::owns(const void* ptr) const
+{
+    return impl_->owns(ptr);
+}
+
+void cuda_pinned_host_allocator::empty_cache()
+{
+    impl_->empty_cache();
+}
+
+void cuda_pinned_host_allocator::set_max_cached_bytes(size_t bytes)
+{
+    impl_->set_max_cached_bytes(bytes);
+}
+
+unified_cache_stats cuda_pinned_host_allocator::stats() const
+{
+    return impl_->stats();
+}
+
+cuda_pinned_host_allocator& cuda_pinned_host_allocator::instance()
+{
+    // Leaked on purpose, see the header
+    static cuda_pinned_host_allocator* allocator = new cuda_pinned_host_allocator();
+    return *allocator;
+}
+}  // namespace gpu
+}  // namespace quarisma
@@ -0,0 +1,154 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "memory/unified_memory_stats.h"
+
+#if QUARISMA_HAS_CUDA
+#include <cuda_runtime_api.h>
+#endif
+
+namespace quarisma
+{
+namespace gpu
+{
+/**
+ * @brief Caching allocator of page-locked host memory for CUDA transfers
+ *
+ * cudaHostAlloc and cudaFreeHost are far slower than a device allocation and
+ * cudaFreeHost synchronizes the device, so staging buffers of host-to-device
+ * copies are cached here. Requests are rounded up to a power of two and served
+ * from free lists of that size.
+ *
+ * An asynchronous copy reads or writes a pinned buffer after the call that
+ * queued it returned. Streams that use a buffer are recorded with
+ * record_stream(); a freed buffer is reused only once the work queued on them
+ * until its free has completed, as with cuda_caching_allocator.
+ *
+ * @code
+ * auto& pinned = cuda_pinned_host_allocator::instance();
+ * void* staging = pinned.allocate(bytes);
+ * // ... fill staging ...
+ * cudaMemcpyAsync(device_ptr, staging, bytes, cudaMemcpyHostToDevice, stream);
+ * pinned.record_stream(staging, stream);
+ * pinned.deallocate(staging);
+ * @endcode
+ *
+ * Free buffers are released to the driver by empty_cache(), above the cache
+ * limit, and when memory_pressure trims host caches.
+ */
+class QUARISMA_VISIBILITY cuda_pinned_host_allocator
+{
+public:
+#if QUARISMA_HAS_CUDA
+    using stream_type = cudaStream_t;
+#else
+    using stream_type = void*;
+#endif
+
+    /**
+     * @brief Construct a pinned host allocator
+     * @param max_cached_bytes Maximum free bytes to cache (default: unlimited)
+     */
+    QUARISMA_API explicit cuda_pinned_host_allocator(
+        size_t max_cached_bytes = std::numeric_limits<size_t>::max());
+
+    /**
+     * @brief Destructor - releases all cached memory
+     */
+    QUARISMA_API ~cuda_pinned_host_allocator();
+
+    /**
+     * @brief Allocate page-locked host memory
+     * @param size Number of bytes to allocate
+     * @return Pointer to allocated memory, nullptr if size is zero
+     * @throws std::bad_alloc if allocation fails
+     */
+    QUARISMA_API void* allocate(size_t size);
+
+    /**
+     * @brief Return a buffer to the cache
+     * @param ptr Pointer returned by allocate(), or nullptr
+     * @throws std::invalid_argument if ptr is not owned by this allocator
+     * @throws std::logic_error if double free detected
+     */
+    QUARISMA_API void deallocate(void* ptr);
+
+    /**
+     * @brief Mark an allocated buffer as used by work queued on a stream
+     *
+     * When the buffer is freed, it returns to the cache only once the work
+     * queued until then on each recorded stream has completed.
+     *
+     * @param ptr Pointer returned by allocate() and not yet freed
+     * @param stream Stream that uses the buffer
+     * @throws std::invalid_argument if ptr is not an allocated buffer of this allocator
+     */
+    QUARISMA_API void record_stream(void* ptr, stream_type stream);
+
+    /**
+     * @brief Whether ptr is a buffer of this allocator, allocated or not
+     */
+    QUARISMA_API bool owns(const void* ptr) const;
+
+    /**
+     * @brief Release every free buffer to the driver
+     *
+     * Buffers still waiting for their streams are kept.
+     */
+    QUARISMA_API void empty_cache();
+
+    /**
+     * @brief Set maximum free bytes to cache
+     * @param bytes Maximum cache size (0 = no caching)
+     */
+    QUARISMA_API void set_max_cached_bytes(size_t bytes);
+
+    /**
+     * @brief Get comprehensive allocation statistics
+     * @return Statistics structure with performance metrics
+     */
+    QUARISMA_API unified_cache_stats stats() const;
+
+    /**
+     * @brief The process-wide pinned host allocator
+     *
+     * Created on first use and never destroyed, so buffers may be freed
+     * during static destruction.
+     */
+    QUARISMA_API static cuda_pinned_host_allocator& instance();
+
+    cuda_pinned_host_allocator(const cuda_pinned_host_allocator&)            = delete;
+    cuda_pinned_host_allocator& operator=(const cuda_pinned_host_allocator&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace gpu
+}  // namespace quarisma
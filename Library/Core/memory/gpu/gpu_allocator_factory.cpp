@@ -42,6 +42,10 @@ gpu_allocator_config gpu_allocator_config::create_default(
     case gpu_allocation_strategy::CACHING:
         config.cache_max_bytes = 256ULL * 1024ULL;  // 256MB cache
         break;
+
+    case gpu_allocation_strategy::ASYNC_POOL:
+        config.async_pool.release_threshold = 256ULL * 1024ULL * 1024ULL;  // Keep 256MB reserved
+        break;
     }
 
     return config;
@@ -86,6 +90,18 @@ std::unique_ptr<void> gpu_allocator_factory::create_allocator(
         "create_caching_allocator() for advanced memory management.");
 }
 
+std::unique_ptr<cuda_async_allocator> gpu_allocator_factory::create_async_allocator(
+    const gpu_allocator_config& config)
+{
+    if (!validate_device_support(
+            gpu_allocation_strategy::ASYNC_POOL, config.device_type, config.device_index))
+    {
+        throw std::runtime_error("Device does not support stream-ordered memory pools");
+    }
+
+    return std::make_unique<cuda_async_allocator>(config.device_index, config.async_pool);
+}
+
 gpu_allocation_strategy gpu_allocator_factory::recommend_strategy(
     size_t avg_allocation_size, double allocation_frequency, double allocation_lifetime)
 {
@@ -112,7 +128,7 @@ gpu_allocation_strategy gpu_allocator_factory::recommend_strategy(
 }
 
 bool gpu_allocator_factory::validate_device_support(
-    gpu_allocation_strategy /*strategy*/, device_enum device_type, int device_index)
+    gpu_allocation_strategy strategy, device_enum device_type, int device_index)
 {
     // Only CUDA devices are supported currently
     if (device_type != device_enum::CUDA)
@@ -125,9 +141,23 @@ bool gpu_allocator_factory::validate_device_support(
     int               device_count = 0;
     cudaError_t const result       = cudaGetDeviceCount(&device_count);
 
-    return (result == cudaSuccess && device_index >= 0 && device_index < device_count);
+    if (result != cudaSuccess || device_index < 0 || device_index >= device_count)
+    {
+        return false;
+    }
+
+    if (strategy == gpu_allocation_strategy::ASYNC_POOL)
+    {
+        int pools_supported = 0;
+        return cudaDeviceGetAttribute(
+                   &pools_supported, cudaDevAttrMemoryPoolsSupported, device_index) ==
+                   cudaSuccess &&
+               pools_supported != 0;
+    }
+    return true;
 
 #else
+    (void)strategy;
     return false;
 #endif
 }
@@ -142,6 +172,8 @@ std::string gpu_allocator_factory::strategy_name(gpu_allocation_strategy strateg
         return "Pool";
     case gpu_allocation_strategy::CACHING:
         return "Caching";
+    case gpu_allocation_strategy::ASYNC_POOL:
+        return "AsyncPool";
     default:
         return "Unknown";
     }
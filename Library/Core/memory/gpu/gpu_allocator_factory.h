@@ -23,6 +23,7 @@
 #include <string>
 
 #include "memory/device.h"
+#include "memory/gpu/cuda_async_allocator.h"
 #include "memory/gpu/cuda_caching_allocator.h"
 
 namespace quarisma
@@ -39,12 +40,15 @@ namespace gpu
  * - DIRECT: Direct CUDA malloc/free for simple, infrequent allocations
  * - POOL: Memory pool for frequent allocations of similar sizes
  * - CACHING: Intelligent caching for complex allocation patterns
+ * - ASYNC_POOL: Driver-managed stream-ordered pool, shared across streams
+ *   and processes
  */
 enum class gpu_allocation_strategy
 {
-    DIRECT  = 0,  ///< Direct CUDA allocation (cudaMalloc/cudaFree)
-    POOL    = 1,  ///< Memory pool-based allocation
-    CACHING = 2   ///< CUDA caching allocator with stream awareness
+    DIRECT     = 0,  ///< Direct CUDA allocation (cudaMalloc/cudaFree)
+    POOL       = 1,  ///< Memory pool-based allocation
+    CACHING    = 2,  ///< CUDA caching allocator with stream awareness
+    ASYNC_POOL = 3   ///< cudaMallocFromPoolAsync on a cudaMemPool_t
 };
 
 /**
@@ -69,6 +73,9 @@ struct QUARISMA_VISIBILITY gpu_allocator_config
     // Caching-specific configuration
     size_t cache_max_bytes = std::numeric_limits<size_t>::max();  ///< Maximum cache size
 
+    // Stream-ordered pool configuration
+    cuda_async_allocator::Options async_pool;  ///< Pool, release threshold and IPC options
+
     /**
      * @brief Create default configuration for strategy
      * @param strategy Allocation strategy
@@ -148,6 +155,15 @@ public:
             config.device_index, config.cache_max_bytes);
     }
 
+    /**
+     * @brief Create an allocator on the driver's stream-ordered pool
+     * @param config Allocator configuration (async_pool selects the pool)
+     * @return Unique pointer to the allocator
+     * @throws std::runtime_error if the device has no memory pool support
+     */
+    QUARISMA_API static std::unique_ptr<cuda_async_allocator> create_async_allocator(
+        const gpu_allocator_config& config);
+
     /**
      * @brief Get recommended strategy for allocation pattern
      * @param avg_allocation_size Average allocation size in bytes
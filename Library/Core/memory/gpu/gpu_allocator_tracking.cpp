@@ -204,6 +204,20 @@ gpu_allocator_tracking::gpu_allocator_tracking(
     }
 }
 
+gpu_allocator_tracking::gpu_allocator_tracking(
+    std::shared_ptr<cuda_async_allocator> backend,
+    bool                                  enable_enhanced_tracking,
+    bool                                  enable_bandwidth_tracking)
+    : gpu_allocator_tracking(
+          device_enum::CUDA,
+          backend != nullptr ? backend->device() : 0,
+          enable_enhanced_tracking,
+          enable_bandwidth_tracking)
+{
+    QUARISMA_CHECK(backend != nullptr, "gpu_allocator_tracking needs a stream-ordered backend");
+    async_backend_ = std::move(backend);
+}
+
 gpu_allocator_tracking::~gpu_allocator_tracking()
 {
     // Log destruction if enabled
@@ -311,6 +325,13 @@ void* gpu_allocator_tracking::allocate_raw(
             auto block = pool->allocate(bytes, device_type_, device_index_);
             ptr        = block.ptr;
         }
+#if QUARISMA_HAS_CUDA
+        else if (async_backend_ != nullptr)
+        {
+            // Stream-ordered pool allocation; throws std::bad_alloc on failure
+            ptr = async_backend_->allocate(bytes, static_cast<cudaStream_t>(stream));
+        }
+#endif
         else
         {
             // Use direct CUDA allocation (replacing gpu_allocator)
@@ -355,6 +376,8 @@ void* gpu_allocator_tracking::allocate_raw(
     auto end_time = std::chrono::steady_clock::now();
     auto duration_us =
         std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+    auto latency_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
 
 #if QUARISMA_HAS_CUDA
     // Get GPU-side timing if CUDA events are available
@@ -369,9 +392,11 @@ void* gpu_allocator_tracking::allocate_raw(
         {
             // Use GPU timing if available (more accurate for GPU operations)
             duration_us = static_cast<uint64_t>(gpu_time_ms * 1000.0f);
+            latency_ns  = static_cast<uint64_t>(gpu_time_ms * 1.0e6);
         }
     }
 #endif
+    alloc_latency_.record(latency_ns);
 
     // Update timing statistics
     gpu_timing_stats_.total_allocations.fetch_add(1, std::memory_order_relaxed);
@@ -485,7 +510,11 @@ void gpu_allocator_tracking::deallocate_raw(void* ptr, size_t bytes, void* strea
 
     // Perform actual GPU deallocation using direct CUDA calls
 #if QUARISMA_HAS_CUDA
-    if (device_type_ == device_enum::CUDA || device_type_ == device_enum::HIP)
+    if (async_backend_ != nullptr)
+    {
+        async_backend_->deallocate(ptr, bytes, static_cast<cudaStream_t>(stream));
+    }
+    else if (device_type_ == device_enum::CUDA || device_type_ == device_enum::HIP)
     {
         cudaError_t result = cudaSetDevice(device_index_);
         if (result != cudaSuccess)
@@ -510,6 +539,8 @@ void gpu_allocator_tracking::deallocate_raw(void* ptr, size_t bytes, void* strea
     auto end_time = std::chrono::steady_clock::now();
     auto duration_us =
         std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+    auto latency_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
 
 #if QUARISMA_HAS_CUDA
     // Get GPU-side timing if CUDA events are available
@@ -523,9 +554,11 @@ void gpu_allocator_tracking::deallocate_raw(void* ptr, size_t bytes, void* strea
         if (result == cudaSuccess)
         {
             duration_us = static_cast<uint64_t>(gpu_time_ms * 1000.0f);
+            latency_ns  = static_cast<uint64_t>(gpu_time_ms * 1.0e6);
         }
     }
 #endif
+    dealloc_latency_.record(latency_ns);
 
     // Update timing statistics
     gpu_timing_stats_.total_deallocations.fetch_add(1, std::memory_order_relaxed);
@@ -633,9 +666,21 @@ gpu_tracking_log_level gpu_allocator_tracking::GetGPULoggingLevel() const noexce
     return gpu_log_level_.load(std::memory_order_relaxed);
 }
 
+const latency_histogram& gpu_allocator_tracking::GetGPUAllocationLatency() const noexcept
+{
+    return alloc_latency_;
+}
+
+const latency_histogram& gpu_allocator_tracking::GetGPUDeallocationLatency() const noexcept
+{
+    return dealloc_latency_;
+}
+
 void gpu_allocator_tracking::ResetGPUTimingStats() noexcept
 {
     gpu_timing_stats_.reset();
+    alloc_latency_.reset();
+    dealloc_latency_.reset();
 }
 
 std::tuple<double, double, double> gpu_allocator_tracking::GetGPUEfficiencyMetrics() const
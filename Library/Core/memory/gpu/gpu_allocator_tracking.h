@@ -40,6 +40,7 @@
 #include "common/macros.h"
 #include "logging/logger.h"
 #include "memory/device.h"
+#include "memory/gpu/cuda_async_allocator.h"
 #include "memory/gpu/gpu_device_manager.h"
 #include "memory/gpu/gpu_memory_pool.h"
 #include "memory/gpu/gpu_memory_transfer.h"
@@ -255,6 +256,22 @@ public:
         bool        enable_enhanced_tracking  = true,
         bool        enable_bandwidth_tracking = false);
 
+    /**
+     * @brief Constructs a tracking allocator on a stream-ordered pool.
+     *
+     * Allocations without a gpu_memory_pool go to `backend` instead of
+     * cudaMalloc(), ordered on the stream passed to allocate_raw(), and are
+     * freed with cudaFreeAsync() on the stream passed to deallocate_raw().
+     *
+     * @param backend Stream-ordered allocator of the tracked CUDA device
+     * @param enable_enhanced_tracking Whether to enable comprehensive analytics
+     * @param enable_bandwidth_tracking Whether to track memory bandwidth metrics
+     */
+    QUARISMA_API explicit gpu_allocator_tracking(
+        std::shared_ptr<cuda_async_allocator> backend,
+        bool                                  enable_enhanced_tracking  = true,
+        bool                                  enable_bandwidth_tracking = false);
+
     /**
      * @brief Destructor ensuring proper cleanup of GPU resources.
      *
@@ -400,6 +417,19 @@ public:
      */
     QUARISMA_API atomic_timing_stats GetGPUTimingStats() const noexcept;
 
+    /**
+     * @brief Distribution of GPU allocation latencies, for tail percentiles.
+     *
+     * Same timings as GetGPUTimingStats() in nanoseconds, e.g.
+     * `GetGPUAllocationLatency().snapshot().percentile_ns(99.9)`.
+     */
+    QUARISMA_API const latency_histogram& GetGPUAllocationLatency() const noexcept;
+
+    /**
+     * @brief Distribution of GPU deallocation latencies.
+     */
+    QUARISMA_API const latency_histogram& GetGPUDeallocationLatency() const noexcept;
+
     /**
      * @brief Retrieves enhanced GPU allocation records with comprehensive metadata.
      *
@@ -537,6 +567,8 @@ private:
     // ========== Enhanced Analytics and Performance Tracking ==========
 
     mutable atomic_timing_stats gpu_timing_stats_;  ///< GPU timing statistics
+    latency_histogram           alloc_latency_;     ///< GPU allocation latencies
+    latency_histogram           dealloc_latency_;   ///< GPU deallocation latencies
     mutable std::vector<enhanced_gpu_alloc_record>
                                         gpu_records_;  ///< Enhanced GPU allocation records
     std::atomic<gpu_tracking_log_level> gpu_log_level_{
@@ -553,6 +585,8 @@ private:
     const bool           bandwidth_tracking_enabled_;  ///< Bandwidth tracking flag
     std::atomic<int64_t> next_gpu_allocation_id_{1};   ///< GPU allocation ID counter
 
+    std::shared_ptr<cuda_async_allocator> async_backend_;  ///< Stream-ordered pool, if any
+
     // ========== CUDA-Specific Members ==========
 
 #if QUARISMA_HAS_CUDA
@@ -0,0 +1,165 @@
+#include "memory/gpu/gpu_deferred_free.h"
+
+#include <utility>
+
+#include "logging/logger.h"
+
+namespace quarisma
+{
+namespace gpu
+{
+
+gpu_deferred_free_queue& gpu_deferred_free_queue::instance()
+{
+    // Never destroyed: wrappers with static storage may defer frees during exit
+    static gpu_deferred_free_queue* const instance = new gpu_deferred_free_queue();
+    return *instance;
+}
+
+void gpu_deferred_free_queue::defer(stream_type stream, int device_index, release_fn release)
+{
+#if QUARISMA_HAS_CUDA
+    event_type event = nullptr;
+    {
+        std::scoped_lock const lock(mutex_);
+        auto&                  events = free_events_[device_index];
+        if (!events.empty())
+        {
+            event = events.back();
+            events.pop_back();
+        }
+    }
+
+    int previous_device = 0;
+    cudaGetDevice(&previous_device);
+    cudaError_t status = cudaSetDevice(device_index);
+    if (status == cudaSuccess && event == nullptr)
+    {
+        status = cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+    }
+    if (status == cudaSuccess)
+    {
+        status = cudaEventRecord(event, stream);
+    }
+    cudaSetDevice(previous_device);
+
+    if (status == cudaSuccess)
+    {
+        std::scoped_lock const lock(mutex_);
+        queues_[stream].push_back(entry{event, device_index, std::move(release)});
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    QUARISMA_LOG_WARNING(
+        "gpu_deferred_free_queue: cannot record an event ({}), freeing at once",
+        cudaGetErrorString(status));
+    if (event != nullptr)
+    {
+        cudaEventDestroy(event);
+    }
+#else
+    (void)stream;
+    (void)device_index;
+#endif
+    release();
+}
+
+size_t gpu_deferred_free_queue::collect(
+    std::deque<entry>& queue, std::vector<entry>& done, bool wait)
+{
+    size_t count = 0;
+    while (!queue.empty())
+    {
+#if QUARISMA_HAS_CUDA
+        cudaError_t const status =
+            wait ? cudaEventSynchronize(queue.front().event) : cudaEventQuery(queue.front().event);
+        if (status == cudaErrorNotReady)
+        {
+            break;
+        }
+        if (status != cudaSuccess)
+        {
+            // The stream is broken: its work will not run, so nothing uses the memory
+            QUARISMA_LOG_WARNING(
+                "gpu_deferred_free_queue: event failed ({}), freeing",
+                cudaGetErrorString(status));
+        }
+#else
+        (void)wait;
+#endif
+        done.push_back(std::move(queue.front()));
+        queue.pop_front();
+        ++count;
+    }
+    return count;
+}
+
+size_t gpu_deferred_free_queue::finish(std::vector<entry>& done)
+{
+    for (auto& e : done)
+    {
+        e.release();
+    }
+
+    pending_.fetch_sub(done.size(), std::memory_order_relaxed);
+    std::scoped_lock const lock(mutex_);
+    for (auto& e : done)
+    {
+        free_events_[e.device].push_back(e.event);
+    }
+    return done.size();
+}
+
+size_t gpu_deferred_free_queue::reclaim(stream_type stream)
+{
+    std::vector<entry> done;
+    {
+        std::scoped_lock const lock(mutex_);
+        auto const             it = queues_.find(stream);
+        if (it == queues_.end() || collect(it->second, done, false) == 0)
+        {
+            return 0;
+        }
+    }
+    return finish(done);
+}
+
+size_t gpu_deferred_free_queue::reclaim_all()
+{
+    if (pending_.load(std::memory_order_relaxed) == 0)
+    {
+        return 0;
+    }
+
+    std::vector<entry> done;
+    {
+        std::scoped_lock const lock(mutex_);
+        for (auto& [stream, queue] : queues_)
+        {
+            collect(queue, done, false);
+        }
+    }
+    return finish(done);
+}
+
+size_t gpu_deferred_free_queue::synchronize()
+{
+    std::vector<entry> done;
+    {
+        std::scoped_lock const lock(mutex_);
+        for (auto& [stream, queue] : queues_)
+        {
+            collect(queue, done, true);
+        }
+    }
+    return finish(done);
+}
+
+size_t gpu_deferred_free_queue::pending() const noexcept
+{
+    return pending_.load(std::memory_order_relaxed);
+}
+
+}  // namespace gpu
+}  // namespace quarisma
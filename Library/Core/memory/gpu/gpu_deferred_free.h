@@ -0,0 +1,143 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/configure.h"
+#include "common/macros.h"
+
+#if QUARISMA_HAS_CUDA
+#include <cuda_runtime.h>
+#endif
+
+namespace quarisma
+{
+namespace gpu
+{
+
+/**
+ * @brief Frees held back until the work queued on a stream before them completes
+ *
+ * Freeing a buffer that kernels still use requires synchronizing the host with
+ * the stream first. defer() instead records an event on the stream and queues
+ * the release behind it; reclaim() runs the releases whose events completed,
+ * polling with cudaEventQuery() so that it never blocks. Events of a stream
+ * complete in the order they were recorded, so each stream has a FIFO queue
+ * and its reclaim stops at the first pending event.
+ *
+ * gpu_memory_wrapper defers its frees here once a stream is attached with
+ * set_stream(), and reclaims from its allocation paths.
+ *
+ * Example:
+ * ```cpp
+ * auto buffer = gpu_memory_wrapper<float>::allocate(n, device_enum::CUDA, 0);
+ * buffer.set_stream(stream);
+ * // ... launch kernels on stream using buffer ...
+ * buffer.reset();  // Returns at once; the memory is freed after the kernels
+ * ```
+ */
+class QUARISMA_VISIBILITY gpu_deferred_free_queue
+{
+public:
+#if QUARISMA_HAS_CUDA
+    using stream_type = cudaStream_t;
+#else
+    using stream_type = void*;
+#endif
+    using release_fn = std::function<void()>;
+
+    QUARISMA_API static gpu_deferred_free_queue& instance();
+
+    /**
+     * @brief Run release once the work queued so far on stream has completed
+     *
+     * Without CUDA, or if the event cannot be recorded, release runs at once.
+     *
+     * @param stream Stream the memory is used on
+     * @param device_index Device of the stream
+     * @param release Frees the memory; runs on the thread of a later reclaim
+     */
+    QUARISMA_API void defer(stream_type stream, int device_index, release_fn release);
+
+    /**
+     * @brief Run the releases of stream whose work has completed, without blocking
+     * @return Number of releases run
+     */
+    QUARISMA_API size_t reclaim(stream_type stream);
+
+    /**
+     * @brief reclaim() for every stream; returns at once when nothing is pending
+     * @return Number of releases run
+     */
+    QUARISMA_API size_t reclaim_all();
+
+    /**
+     * @brief Wait for the work of every pending release, then run them all
+     * @return Number of releases run
+     */
+    QUARISMA_API size_t synchronize();
+
+    /**
+     * @brief Number of releases not run yet
+     */
+    QUARISMA_API size_t pending() const noexcept;
+
+    gpu_deferred_free_queue(const gpu_deferred_free_queue&)            = delete;
+    gpu_deferred_free_queue& operator=(const gpu_deferred_free_queue&) = delete;
+
+private:
+    gpu_deferred_free_queue() = default;
+    ~gpu_deferred_free_queue() = default;
+
+#if QUARISMA_HAS_CUDA
+    using event_type = cudaEvent_t;
+#else
+    using event_type = void*;
+#endif
+
+    struct entry
+    {
+        event_type event  = nullptr;
+        int        device = 0;
+        release_fn release;
+    };
+
+    // Moves the completed entries of queue to done, waiting for them if wait
+    size_t collect(std::deque<entry>& queue, std::vector<entry>& done, bool wait)
+        QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    // Runs the releases of done and recycles their events
+    size_t finish(std::vector<entry>& done);
+
+    mutable std::mutex                                  mutex_;
+    std::unordered_map<stream_type, std::deque<entry>> queues_ QUARISMA_GUARDED_BY(mutex_);
+    std::unordered_map<int, std::vector<event_type>>   free_events_ QUARISMA_GUARDED_BY(mutex_);
+    std::atomic<size_t>                                 pending_{0};
+};
+
+}  // namespace gpu
+}  // namespace quarisma
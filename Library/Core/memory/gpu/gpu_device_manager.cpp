@@ -1,6 +1,7 @@
 #include "memory/gpu/gpu_device_manager.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <iomanip>
 #include <mutex>
 #include <sstream>
@@ -51,6 +52,9 @@ private:
     /** @brief Current active device */
     gpu_device_info current_device_;
 
+    /** @brief Row-major matrix of CUDA device pairs whose peer access is enabled */
+    std::vector<uint8_t> peer_access_enabled_;
+
     /**
      * @brief Initialize CUDA runtime and detect CUDA devices
      */
@@ -186,6 +190,8 @@ private:
                 nvmlShutdown();
             }
 #endif
+
+            detect_cuda_topology();
         }
         else
         {
@@ -198,6 +204,108 @@ private:
 #endif
     }
 
+#if QUARISMA_HAS_CUDA
+    /**
+     * @brief Query peer access and link type between every pair of CUDA devices
+     */
+    void detect_cuda_topology()
+    {
+        peer_access_enabled_.assign(
+            static_cast<size_t>(runtime_info_.cuda_device_count) *
+                static_cast<size_t>(runtime_info_.cuda_device_count),
+            0);
+
+        for (auto& device : available_devices_)
+        {
+            device.peers.clear();
+            for (const auto& peer : available_devices_)
+            {
+                if (peer.device_index == device.device_index)
+                {
+                    continue;
+                }
+
+                gpu_peer_info info;
+                info.device_index = peer.device_index;
+
+                int can_access = 0;
+                if (cudaDeviceCanAccessPeer(&can_access, device.device_index, peer.device_index) ==
+                        cudaSuccess &&
+                    can_access != 0)
+                {
+                    info.access_supported = true;
+
+                    int native_atomics = 0;
+                    cudaDeviceGetP2PAttribute(
+                        &native_atomics,
+                        cudaDevP2PAttrNativeAtomicSupported,
+                        device.device_index,
+                        peer.device_index);
+                    cudaDeviceGetP2PAttribute(
+                        &info.performance_rank,
+                        cudaDevP2PAttrPerformanceRank,
+                        device.device_index,
+                        peer.device_index);
+                    info.link =
+                        native_atomics != 0 ? gpu_interconnect::NVLINK : gpu_interconnect::PCIE;
+                }
+                device.peers.push_back(info);
+            }
+        }
+        (void)cudaGetLastError();
+    }
+#endif
+
+    /**
+     * @brief Find a CUDA device by index
+     * @return The device, or nullptr if it is unknown
+     */
+    const gpu_device_info* find_cuda_device(int device_index) const
+    {
+        auto device_it = std::find_if(
+            available_devices_.begin(),
+            available_devices_.end(),
+            [device_index](const auto& device)
+            {
+                return device.device_type == device_enum::CUDA &&
+                       device.device_index == device_index;
+            });
+        return device_it != available_devices_.end() ? &*device_it : nullptr;
+    }
+
+    /**
+     * @brief Link between two CUDA devices; the caller holds the mutex
+     */
+    gpu_interconnect interconnect_unlocked(int device_index, int peer_index) const
+    {
+        const gpu_device_info* device = find_cuda_device(device_index);
+        if (device == nullptr)
+        {
+            return gpu_interconnect::NONE;
+        }
+        for (const auto& peer : device->peers)
+        {
+            if (peer.device_index == peer_index)
+            {
+                return peer.link;
+            }
+        }
+        return gpu_interconnect::NONE;
+    }
+
+    static const char* interconnect_name(gpu_interconnect link)
+    {
+        switch (link)
+        {
+        case gpu_interconnect::NVLINK:
+            return "NVLink";
+        case gpu_interconnect::PCIE:
+            return "PCIe";
+        default:
+            return "none";
+        }
+    }
+
     /**
      * @brief Determine the recommended backend based on available devices
      */
@@ -463,6 +571,56 @@ public:
         current_device_ = *device_it;
     }
 
+    gpu_interconnect get_interconnect(int device_index, int peer_index) const override
+    {
+        std::scoped_lock const lock(mutex_);
+        return interconnect_unlocked(device_index, peer_index);
+    }
+
+    bool enable_peer_access(int device_index, int peer_index) override
+    {
+        std::scoped_lock const lock(mutex_);
+
+        if (interconnect_unlocked(device_index, peer_index) == gpu_interconnect::NONE)
+        {
+            return false;
+        }
+
+        size_t const slot = static_cast<size_t>(device_index) *
+                                static_cast<size_t>(runtime_info_.cuda_device_count) +
+                            static_cast<size_t>(peer_index);
+        if (peer_access_enabled_[slot] != 0)
+        {
+            return true;
+        }
+
+#if QUARISMA_HAS_CUDA
+        int previous_device = 0;
+        cudaGetDevice(&previous_device);
+        cudaSetDevice(device_index);
+        cudaError_t const result = cudaDeviceEnablePeerAccess(peer_index, 0);
+        cudaSetDevice(previous_device);
+
+        if (result != cudaSuccess && result != cudaErrorPeerAccessAlreadyEnabled)
+        {
+            (void)cudaGetLastError();
+            QUARISMA_LOG_WARNING(
+                "Failed to enable peer access from device {} to device {}: {}",
+                device_index,
+                peer_index,
+                std::string(cudaGetErrorString(result)));
+            return false;
+        }
+        // Clear the sticky error of an already enabled pair
+        (void)cudaGetLastError();
+
+        peer_access_enabled_[slot] = 1;
+        return true;
+#else
+        return false;
+#endif
+    }
+
     gpu_device_info get_current_device() const override
     {
         std::scoped_lock const lock(mutex_);
@@ -550,6 +708,16 @@ public:
             oss << "    Concurrent Kernels: " << (device.supports_concurrent_kernels ? "Yes" : "No")
                 << "\n";
             oss << "    PCI Bus ID: " << device.pci_bus_id << "\n";
+            if (!device.peers.empty())
+            {
+                oss << "    Peers:";
+                for (const auto& peer : device.peers)
+                {
+                    oss << " " << peer.device_index << " (" << interconnect_name(peer.link)
+                        << ")";
+                }
+                oss << "\n";
+            }
             oss << "    Utilization: " << std::fixed << std::setprecision(1)
                 << device.utilization_percentage << "%\n";
             oss << "    Temperature: " << std::fixed << std::setprecision(1)
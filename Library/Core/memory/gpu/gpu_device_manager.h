@@ -36,6 +36,34 @@ namespace quarisma
 namespace gpu
 {
 
+/**
+ * @brief Kind of link between two devices
+ */
+enum class gpu_interconnect
+{
+    NONE,   ///< No peer access; copies go through host memory
+    PCIE,   ///< Peer access over PCIe
+    NVLINK  ///< Peer access over NVLink
+};
+
+/**
+ * @brief Peer-to-peer connectivity from one device to another
+ */
+struct QUARISMA_VISIBILITY gpu_peer_info
+{
+    /** @brief Index of the peer device */
+    int device_index = -1;
+
+    /** @brief Whether the device can map the peer's memory */
+    bool access_supported = false;
+
+    /** @brief Link to the peer */
+    gpu_interconnect link = gpu_interconnect::NONE;
+
+    /** @brief Relative performance of the link (lower is faster) */
+    int performance_rank = 0;
+};
+
 /**
  * @brief GPU device capabilities and properties
  *
@@ -116,6 +144,9 @@ struct QUARISMA_VISIBILITY gpu_device_info
 
     /** @brief Total memory in bytes (alias for total_memory for compatibility) */
     size_t total_memory_bytes = 0;
+
+    /** @brief Connectivity to every other device of the same type */
+    std::vector<gpu_peer_info> peers;
 };
 
 /**
@@ -154,6 +185,7 @@ struct QUARISMA_VISIBILITY gpu_runtime_info
  * - Device capability enumeration and comparison
  * - Optimal device selection based on workload characteristics
  * - Device health monitoring and utilization tracking
+ * - Peer-to-peer topology (NVLink or PCIe) and peer access enablement
  * - Thread-safe device context management
  * - Performance benchmarking for device ranking
  *
@@ -245,6 +277,32 @@ public:
      */
     QUARISMA_API virtual gpu_device_info get_current_device() const = 0;
 
+    /**
+     * @brief Get the link between two CUDA devices
+     *
+     * The runtime does not name the link, so peers with native atomics are
+     * reported as NVLink, which PCIe does not provide, and other accessible
+     * peers as PCIe.
+     *
+     * @param device_index Device issuing the accesses
+     * @param peer_index Device owning the memory
+     * @return Link type, NONE if either device is unknown or peer access is unsupported
+     */
+    QUARISMA_API virtual gpu_interconnect get_interconnect(
+        int device_index, int peer_index) const = 0;
+
+    /**
+     * @brief Let a CUDA device access the memory of a peer
+     *
+     * Enabling is idempotent and remembered, so callers can invoke it before
+     * every peer copy.
+     *
+     * @param device_index Device issuing the accesses
+     * @param peer_index Device owning the memory
+     * @return True if access is enabled, false if the pair does not support it
+     */
+    QUARISMA_API virtual bool enable_peer_access(int device_index, int peer_index) = 0;
+
     /**
      * @brief Refresh device information and update utilization statistics
      */
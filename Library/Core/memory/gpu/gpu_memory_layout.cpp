@@ -0,0 +1,637 @@
+#include "memory/gpu/gpu_memory_layout.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "common/configure.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_CUDA
+#include <cuda_runtime.h>
+#endif
+
+namespace quarisma
+{
+namespace gpu
+{
+
+namespace
+{
+
+// Records transposed at a time, so that the block stays in cache while
+// each of its fields is gathered
+constexpr size_t kBlockBytes = 64 * 1024;
+
+constexpr size_t align_up(size_t value, size_t alignment) noexcept
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Copy field values between n AoS records `stride` bytes apart and a
+ * contiguous run; S is the field size, or 0 for sizes known at run time
+ */
+template <size_t S, bool Pack>
+void copy_run(uint8_t* aos, size_t stride, uint8_t* run, size_t n, size_t size) noexcept
+{
+    size_t const width = S != 0 ? S : size;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if constexpr (Pack)
+        {
+            std::memcpy(run + i * width, aos + i * stride, width);
+        }
+        else
+        {
+            std::memcpy(aos + i * stride, run + i * width, width);
+        }
+    }
+}
+
+using copy_run_fn = void (*)(uint8_t*, size_t, uint8_t*, size_t, size_t) noexcept;
+
+template <bool Pack>
+copy_run_fn select_copy_run(size_t size) noexcept
+{
+    switch (size)
+    {
+    case 1:
+        return &copy_run<1, Pack>;
+    case 2:
+        return &copy_run<2, Pack>;
+    case 4:
+        return &copy_run<4, Pack>;
+    case 8:
+        return &copy_run<8, Pack>;
+    case 16:
+        return &copy_run<16, Pack>;
+    default:
+        return &copy_run<0, Pack>;
+    }
+}
+
+/**
+ * @brief Move the fields of records [first, first + n) between the AoS array
+ * at records (record first) and the laid out buffer
+ */
+template <bool Pack>
+void transpose_host(
+    const layout_plan& plan, uint8_t* records, uint8_t* buffer, size_t first, size_t n)
+{
+    size_t const rs = plan.record_size;
+    if (n == 0)
+    {
+        return;
+    }
+    if (plan.kind == record_layout_kind::AOS)
+    {
+        if constexpr (Pack)
+        {
+            std::memcpy(buffer + first * rs, records, n * rs);
+        }
+        else
+        {
+            std::memcpy(records, buffer + first * rs, n * rs);
+        }
+        return;
+    }
+
+    size_t block = std::max<size_t>(kBlockBytes / rs, 1);
+    if (plan.kind == record_layout_kind::AOSOA)
+    {
+        block = std::max<size_t>(block / plan.tile, 1) * plan.tile;
+    }
+
+    size_t const end = first + n;
+    for (size_t begin = first; begin < end; begin += block)
+    {
+        size_t const len = std::min(block, end - begin);
+        for (size_t f = 0; f < plan.fields.size(); ++f)
+        {
+            size_t const      size = plan.fields[f].size;
+            copy_run_fn const copy = select_copy_run<Pack>(size);
+            uint8_t* const    aos  = records + (begin - first) * rs + plan.fields[f].offset;
+
+            if (plan.kind == record_layout_kind::SOA)
+            {
+                copy(aos, rs, buffer + plan.field_starts[f] + begin * size, len, size);
+                continue;
+            }
+
+            // AoSoA: one run per tile the block overlaps
+            for (size_t i = begin; i < begin + len;)
+            {
+                size_t const lane = i % plan.tile;
+                size_t const run  = std::min(plan.tile - lane, begin + len - i);
+                copy(
+                    aos + (i - begin) * rs,
+                    rs,
+                    buffer + (i / plan.tile) * plan.tile_bytes + plan.field_starts[f] + lane * size,
+                    run,
+                    size);
+                i += run;
+            }
+        }
+    }
+}
+
+#if QUARISMA_HAS_CUDA
+void check_cuda(cudaError_t result, const char* what)
+{
+    if (result != cudaSuccess)
+    {
+        QUARISMA_THROW("{} failed: {}", what, std::string(cudaGetErrorString(result)));
+    }
+}
+
+/**
+ * @brief Two pinned buffers of a device, filled in turn
+ *
+ * Each buffer has an event recorded after its last copy, so that it is only
+ * refilled (upload) or read (download) once the copy is done with it.
+ * Transfers through the buffers of a device are serialized.
+ */
+struct layout_staging
+{
+    static constexpr size_t kDefaultBytes = 4 * 1024 * 1024;
+
+    std::mutex  mutex;
+    size_t      bytes      = 0;
+    void*       buffers[2] = {};
+    cudaEvent_t events[2]  = {};
+
+    // Grows the buffers to at least size bytes; mutex must be held
+    void reserve(size_t size)
+    {
+        if (bytes >= size)
+        {
+            return;
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            if (buffers[i] != nullptr)
+            {
+                cudaEventSynchronize(events[i]);
+                cudaFreeHost(buffers[i]);
+                buffers[i] = nullptr;
+            }
+        }
+        bytes = 0;
+
+        size = std::max(size, kDefaultBytes);
+        for (int i = 0; i < 2; ++i)
+        {
+            check_cuda(
+                cudaHostAlloc(&buffers[i], size, cudaHostAllocDefault),
+                "Allocating layout staging buffer");
+            if (events[i] == nullptr)
+            {
+                check_cuda(
+                    cudaEventCreateWithFlags(&events[i], cudaEventDisableTiming),
+                    "Creating layout staging event");
+            }
+        }
+        bytes = size;
+    }
+};
+
+layout_staging& staging_for_current_device()
+{
+    static std::mutex mutex;
+    // Never destroyed: pinned memory cannot be freed once the runtime has shut down
+    static auto* const staging = new std::unordered_map<int, std::unique_ptr<layout_staging>>();
+
+    int device = 0;
+    cudaGetDevice(&device);
+
+    std::scoped_lock const lock(mutex);
+    auto&                  entry = (*staging)[device];
+    if (!entry)
+    {
+        entry = std::make_unique<layout_staging>();
+    }
+    return *entry;
+}
+
+/**
+ * @brief Plan of the chunk of n records laid out in staging
+ *
+ * AoS and AoSoA chunks are laid out as in the whole buffer, whole tiles at a
+ * time. SoA chunks have one tight run per field.
+ */
+layout_plan chunk_plan(const layout_plan& plan, size_t n)
+{
+    layout_plan part = plan;
+    part.count       = n;
+    switch (plan.kind)
+    {
+    case record_layout_kind::AOS:
+        part.bytes = n * plan.record_size;
+        break;
+    case record_layout_kind::SOA:
+        part.bytes = 0;
+        for (size_t f = 0; f < plan.fields.size(); ++f)
+        {
+            part.field_starts[f] = part.bytes;
+            part.bytes += n * plan.fields[f].size;
+        }
+        break;
+    case record_layout_kind::AOSOA:
+        part.bytes = (n + plan.tile - 1) / plan.tile * plan.tile_bytes;
+        break;
+    }
+    return part;
+}
+
+// Records per staging chunk, and the staging bytes they need
+std::pair<size_t, size_t> chunk_records(const layout_plan& plan)
+{
+    size_t const limit = layout_staging::kDefaultBytes;
+    switch (plan.kind)
+    {
+    case record_layout_kind::AOS:
+    {
+        size_t const n = std::max<size_t>(limit / plan.record_size, 1);
+        return {n, n * plan.record_size};
+    }
+    case record_layout_kind::SOA:
+    {
+        size_t payload = 0;
+        for (const auto& field : plan.fields)
+        {
+            payload += field.size;
+        }
+        size_t const n = std::max<size_t>(limit / payload, 1);
+        return {n, n * payload};
+    }
+    case record_layout_kind::AOSOA:
+    default:
+    {
+        size_t const tiles = std::max<size_t>(limit / plan.tile_bytes, 1);
+        return {tiles * plan.tile, tiles * plan.tile_bytes};
+    }
+    }
+}
+
+/**
+ * @brief Queue the copies of a chunk of records [first, first + part.count)
+ * between staging and the device buffer of the plan
+ */
+void copy_chunk(
+    const layout_plan& plan,
+    const layout_plan& part,
+    size_t             first,
+    uint8_t*           device,
+    uint8_t*           staging,
+    bool               upload,
+    cudaStream_t       stream)
+{
+    auto const copy = [&](uint8_t* on_device, uint8_t* on_host, size_t bytes)
+    {
+        check_cuda(
+            upload ? cudaMemcpyAsync(on_device, on_host, bytes, cudaMemcpyHostToDevice, stream)
+                   : cudaMemcpyAsync(on_host, on_device, bytes, cudaMemcpyDeviceToHost, stream),
+            "Copying laid out records");
+    };
+
+    switch (plan.kind)
+    {
+    case record_layout_kind::AOS:
+        copy(device + first * plan.record_size, staging, part.bytes);
+        break;
+    case record_layout_kind::SOA:
+        for (size_t f = 0; f < plan.fields.size(); ++f)
+        {
+            size_t const size = plan.fields[f].size;
+            copy(
+                device + plan.field_starts[f] + first * size,
+                staging + part.field_starts[f],
+                part.count * size);
+        }
+        break;
+    case record_layout_kind::AOSOA:
+        copy(device + first / plan.tile * plan.tile_bytes, staging, part.bytes);
+        break;
+    }
+}
+#endif
+
+}  // namespace
+
+record_layout::record_layout(size_t record_size) : record_size_(record_size)
+{
+    QUARISMA_CHECK(record_size > 0, "record_layout: record size must not be zero");
+}
+
+record_layout& record_layout::add_field(std::string name, size_t offset, size_t size)
+{
+    QUARISMA_CHECK(size > 0, "record_layout: field {} is empty", name);
+    QUARISMA_CHECK(
+        offset + size <= record_size_,
+        "record_layout: field {} at {}+{} leaves the {} byte record",
+        name,
+        offset,
+        size,
+        record_size_);
+    for (const auto& field : fields_)
+    {
+        QUARISMA_CHECK(
+            offset + size <= field.offset || field.offset + field.size <= offset,
+            "record_layout: field {} overlaps field {}",
+            name,
+            field.name);
+        QUARISMA_CHECK(field.name != name, "record_layout: field {} is described twice", name);
+    }
+    fields_.push_back(record_field{std::move(name), offset, size});
+    return *this;
+}
+
+size_t record_layout::field_index(std::string_view name) const
+{
+    auto const it = std::find_if(
+        fields_.begin(), fields_.end(), [name](const record_field& f) { return f.name == name; });
+    QUARISMA_CHECK(it != fields_.end(), "record_layout: no field {}", std::string(name));
+    return static_cast<size_t>(it - fields_.begin());
+}
+
+layout_plan layout_plan::make(
+    const record_layout& layout,
+    record_layout_kind   kind,
+    size_t               count,
+    size_t               tile,
+    size_t               alignment)
+{
+    QUARISMA_CHECK(!layout.fields().empty(), "layout_plan: the record has no fields");
+    QUARISMA_CHECK(tile > 0, "layout_plan: tile must not be zero");
+    QUARISMA_CHECK(
+        alignment > 0 && (alignment & (alignment - 1)) == 0,
+        "layout_plan: alignment {} is not a power of two",
+        alignment);
+
+    layout_plan plan;
+    plan.kind        = kind;
+    plan.count       = count;
+    plan.record_size = layout.record_size();
+    plan.fields      = layout.fields();
+    plan.field_starts.reserve(plan.fields.size());
+
+    switch (kind)
+    {
+    case record_layout_kind::AOS:
+        for (const auto& field : plan.fields)
+        {
+            plan.field_starts.push_back(field.offset);
+        }
+        plan.bytes = count * plan.record_size;
+        break;
+
+    case record_layout_kind::SOA:
+    {
+        size_t start = 0;
+        for (const auto& field : plan.fields)
+        {
+            start = align_up(start, alignment);
+            plan.field_starts.push_back(start);
+            start += count * field.size;
+        }
+        plan.bytes = align_up(start, alignment);
+        break;
+    }
+
+    case record_layout_kind::AOSOA:
+    {
+        size_t start = 0;
+        for (const auto& field : plan.fields)
+        {
+            start = align_up(start, alignment::CUDA_COALESCING_BOUNDARY);
+            plan.field_starts.push_back(start);
+            start += tile * field.size;
+        }
+        plan.tile       = tile;
+        plan.tile_bytes = align_up(start, alignment::CUDA_COALESCING_BOUNDARY);
+        plan.bytes      = (count + tile - 1) / tile * plan.tile_bytes;
+        break;
+    }
+    }
+    return plan;
+}
+
+size_t layout_plan::offset(size_t field, size_t index) const noexcept
+{
+    switch (kind)
+    {
+    case record_layout_kind::SOA:
+        return field_starts[field] + index * fields[field].size;
+    case record_layout_kind::AOSOA:
+        return index / tile * tile_bytes + field_starts[field] + index % tile * fields[field].size;
+    case record_layout_kind::AOS:
+    default:
+        return index * record_size + fields[field].offset;
+    }
+}
+
+void pack_records(
+    const void* records, const layout_plan& plan, void* out, size_t first, size_t n)
+{
+    QUARISMA_CHECK(first <= plan.count, "pack_records: record {} is out of range", first);
+    n = std::min(n, plan.count - first);
+
+    // transpose_host only reads the records when packing
+    transpose_host<true>(
+        plan,
+        const_cast<uint8_t*>(static_cast<const uint8_t*>(records)),
+        static_cast<uint8_t*>(out),
+        first,
+        n);
+}
+
+void unpack_records(
+    const void* in, const layout_plan& plan, void* records, size_t first, size_t n)
+{
+    QUARISMA_CHECK(first <= plan.count, "unpack_records: record {} is out of range", first);
+    n = std::min(n, plan.count - first);
+
+    // transpose_host only reads the buffer when unpacking
+    transpose_host<false>(
+        plan,
+        static_cast<uint8_t*>(records),
+        const_cast<uint8_t*>(static_cast<const uint8_t*>(in)),
+        first,
+        n);
+}
+
+void upload_records(const void* records, const layout_plan& plan, void* device_out, void* stream)
+{
+#if QUARISMA_HAS_CUDA
+    if (plan.count == 0)
+    {
+        return;
+    }
+    auto* const cuda_stream = static_cast<cudaStream_t>(stream);
+    const auto* host        = static_cast<const uint8_t*>(records);
+    auto* const device      = static_cast<uint8_t*>(device_out);
+
+    auto const [per_chunk, chunk_bytes] = chunk_records(plan);
+    layout_staging&        staging      = staging_for_current_device();
+    std::scoped_lock const lock(staging.mutex);
+    staging.reserve(chunk_bytes);
+
+    for (size_t first = 0, chunk = 0; first < plan.count; first += per_chunk, ++chunk)
+    {
+        size_t const slot   = chunk % 2;
+        auto* const  buffer = static_cast<uint8_t*>(staging.buffers[slot]);
+
+        // The copy out of this buffer two chunks ago must be done before it is refilled
+        check_cuda(cudaEventSynchronize(staging.events[slot]), "Waiting for layout staging");
+        layout_plan const part = chunk_plan(plan, std::min(per_chunk, plan.count - first));
+        pack_records(host + first * plan.record_size, part, buffer, 0, part.count);
+
+        copy_chunk(plan, part, first, device, buffer, true, cuda_stream);
+        check_cuda(
+            cudaEventRecord(staging.events[slot], cuda_stream), "Recording layout staging event");
+    }
+#else
+    (void)records;
+    (void)plan;
+    (void)device_out;
+    (void)stream;
+    QUARISMA_THROW("upload_records requires CUDA support");
+#endif
+}
+
+void download_records(const void* device_in, const layout_plan& plan, void* records, void* stream)
+{
+#if QUARISMA_HAS_CUDA
+    if (plan.count == 0)
+    {
+        return;
+    }
+    auto* const cuda_stream = static_cast<cudaStream_t>(stream);
+    auto* const host        = static_cast<uint8_t*>(records);
+    auto* const device      = const_cast<uint8_t*>(static_cast<const uint8_t*>(device_in));
+
+    auto const [per_chunk, chunk_bytes] = chunk_records(plan);
+    size_t const           chunks       = (plan.count + per_chunk - 1) / per_chunk;
+    layout_staging&        staging      = staging_for_current_device();
+    std::scoped_lock const lock(staging.mutex);
+    staging.reserve(chunk_bytes);
+
+    auto const part_of = [&](size_t chunk)
+    { return chunk_plan(plan, std::min(per_chunk, plan.count - chunk * per_chunk)); };
+
+    // One chunk is in flight while the previous one is unpacked
+    size_t issued = 0;
+    for (size_t drained = 0; drained < chunks; ++drained)
+    {
+        for (; issued < chunks && issued - drained < 2; ++issued)
+        {
+            size_t const slot = issued % 2;
+            copy_chunk(
+                plan,
+                part_of(issued),
+                issued * per_chunk,
+                device,
+                static_cast<uint8_t*>(staging.buffers[slot]),
+                false,
+                cuda_stream);
+            check_cuda(
+                cudaEventRecord(staging.events[slot], cuda_stream),
+                "Recording layout staging event");
+        }
+
+        size_t const slot = drained % 2;
+        check_cuda(cudaEventSynchronize(staging.events[slot]), "Waiting for layout staging");
+        layout_plan const part  = part_of(drained);
+        size_t const      first = drained * per_chunk;
+        unpack_records(
+            staging.buffers[slot], part, host + first * plan.record_size, 0, part.count);
+    }
+#else
+    (void)device_in;
+    (void)plan;
+    (void)records;
+    (void)stream;
+    QUARISMA_THROW("download_records requires CUDA support");
+#endif
+}
+
+void transpose_records_on_device(
+    const void* device_records, const layout_plan& plan, void* device_out, void* stream)
+{
+#if QUARISMA_HAS_CUDA
+    if (plan.count == 0)
+    {
+        return;
+    }
+    auto* const cuda_stream = static_cast<cudaStream_t>(stream);
+    auto* const src         = const_cast<uint8_t*>(static_cast<const uint8_t*>(device_records));
+    auto* const dst         = static_cast<uint8_t*>(device_out);
+    size_t const rs         = plan.record_size;
+
+    // height values size bytes apart in dst, rs bytes apart in src
+    auto const copy_2d = [&](uint8_t* to, const uint8_t* from, size_t size, size_t height)
+    {
+        check_cuda(
+            cudaMemcpy2DAsync(
+                to, size, from, rs, size, height, cudaMemcpyDeviceToDevice, cuda_stream),
+            "Transposing records");
+    };
+
+    if (plan.kind == record_layout_kind::AOS)
+    {
+        check_cuda(
+            cudaMemcpyAsync(dst, src, plan.bytes, cudaMemcpyDeviceToDevice, cuda_stream),
+            "Copying records");
+        return;
+    }
+
+    for (size_t f = 0; f < plan.fields.size(); ++f)
+    {
+        size_t const   size = plan.fields[f].size;
+        uint8_t* const from = src + plan.fields[f].offset;
+        uint8_t* const to   = dst + plan.field_starts[f];
+
+        if (plan.kind == record_layout_kind::SOA)
+        {
+            copy_2d(to, from, size, plan.count);
+            continue;
+        }
+
+        size_t const tiles = plan.count / plan.tile;
+        size_t const rest  = plan.count % plan.tile;
+        if (tiles > 0 && plan.tile_bytes % size == 0)
+        {
+            // The runs of a field are tile_bytes apart: a slice pitch of the destination
+            cudaMemcpy3DParms params = {};
+            params.srcPtr            = make_cudaPitchedPtr(from, rs, size, plan.tile);
+            params.dstPtr = make_cudaPitchedPtr(to, size, size, plan.tile_bytes / size);
+            params.extent = make_cudaExtent(size, plan.tile, tiles);
+            params.kind   = cudaMemcpyDeviceToDevice;
+            check_cuda(cudaMemcpy3DAsync(&params, cuda_stream), "Transposing records");
+        }
+        else
+        {
+            for (size_t t = 0; t < tiles; ++t)
+            {
+                copy_2d(to + t * plan.tile_bytes, from + t * plan.tile * rs, size, plan.tile);
+            }
+        }
+        if (rest > 0)
+        {
+            copy_2d(to + tiles * plan.tile_bytes, from + tiles * plan.tile * rs, size, rest);
+        }
+    }
+#else
+    (void)device_records;
+    (void)plan;
+    (void)device_out;
+    (void)stream;
+    QUARISMA_THROW("transpose_records_on_device requires CUDA support");
+#endif
+}
+
+}  // namespace gpu
+}  // namespace quarisma
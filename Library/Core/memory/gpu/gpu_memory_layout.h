@@ -0,0 +1,198 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "memory/gpu/gpu_memory_alignment.h"
+
+namespace quarisma
+{
+namespace gpu
+{
+
+/**
+ * @brief Arrangement of the fields of an array of records
+ */
+enum class record_layout_kind
+{
+    AOS,   ///< Array of structures: the records as they are
+    SOA,   ///< Structure of arrays: one contiguous column per field
+    AOSOA  ///< Tiles of `tile` records, each tile a small structure of arrays
+};
+
+/**
+ * @brief A field of a record: where it is in the record and how large it is
+ */
+struct QUARISMA_VISIBILITY record_field
+{
+    std::string name;
+    size_t      offset = 0;
+    size_t      size   = 0;
+};
+
+/**
+ * @brief Description of a record type, given once, from which layouts are planned
+ *
+ * Padding between fields is not described and is not copied into the other
+ * layouts; converting back to AoS leaves it untouched.
+ *
+ * @example
+ * ```cpp
+ * struct quote { double bid; double ask; int32_t size; int32_t venue; };
+ *
+ * record_layout layout(sizeof(quote));
+ * layout.add_field(QUARISMA_RECORD_FIELD(quote, bid))
+ *       .add_field(QUARISMA_RECORD_FIELD(quote, ask))
+ *       .add_field(QUARISMA_RECORD_FIELD(quote, size));
+ * ```
+ */
+class QUARISMA_VISIBILITY record_layout
+{
+public:
+    /**
+     * @param record_size sizeof the record, stride of the AoS array
+     */
+    QUARISMA_API explicit record_layout(size_t record_size);
+
+    /**
+     * @brief Describe a field
+     * @throws quarisma::exception if the field is empty, leaves the record or
+     *         overlaps a described field
+     */
+    QUARISMA_API record_layout& add_field(std::string name, size_t offset, size_t size);
+
+    QUARISMA_NODISCARD size_t record_size() const noexcept { return record_size_; }
+
+    QUARISMA_NODISCARD const std::vector<record_field>& fields() const noexcept
+    {
+        return fields_;
+    }
+
+    /**
+     * @brief Position of the field called name in fields()
+     * @throws quarisma::exception if there is none
+     */
+    QUARISMA_API size_t field_index(std::string_view name) const;
+
+private:
+    size_t                    record_size_;
+    std::vector<record_field> fields_;
+};
+
+/** @brief Arguments of record_layout::add_field() for a member of a standard-layout Record */
+#define QUARISMA_RECORD_FIELD(Record, member) \
+    #member, offsetof(Record, member), sizeof(std::declval<Record&>().member)
+
+/**
+ * @brief Byte layout of `count` records in one of the record_layout_kind
+ *
+ * SoA columns start on `alignment` boundaries. In AoSoA each field of a tile
+ * is a run of `tile` values, aligned to alignment::CUDA_COALESCING_BOUNDARY
+ * within the tile, so that a warp reading a field of a tile reads whole
+ * transactions; with tile = alignment::CUDA_WARP_SIZE one warp covers a tile.
+ */
+struct QUARISMA_VISIBILITY layout_plan
+{
+    record_layout_kind        kind        = record_layout_kind::AOS;
+    size_t                    count       = 0;
+    size_t                    record_size = 0;
+    size_t                    tile        = 0;  ///< Records per tile (AoSoA)
+    size_t                    tile_bytes  = 0;  ///< Bytes per tile (AoSoA)
+    size_t                    bytes       = 0;  ///< Size of the laid out buffer
+    std::vector<record_field> fields;           ///< Fields, with offsets in the record
+    std::vector<size_t>       field_starts;     ///< Column (SoA) or run (AoSoA) offsets
+
+    /**
+     * @brief Plan the layout of count records
+     * @param tile Records per tile, for AoSoA
+     * @param alignment Alignment of SoA columns and of the whole buffer
+     * @throws quarisma::exception if the layout has no fields, tile is zero or
+     *         alignment is not a power of two
+     */
+    QUARISMA_API static layout_plan make(
+        const record_layout& layout,
+        record_layout_kind   kind,
+        size_t               count,
+        size_t               tile      = alignment::CUDA_WARP_SIZE,
+        size_t               alignment = alignment::CUDA_TEXTURE_ALIGNMENT);
+
+    /**
+     * @brief Byte offset of field `field` of record `index` in the laid out buffer
+     */
+    QUARISMA_API size_t offset(size_t field, size_t index) const noexcept;
+};
+
+/**
+ * @brief Lay out the records [first, first + n) of an AoS array
+ *
+ * records points at record `first`; out is the whole buffer of the plan.
+ * Fields are gathered a block of records at a time, with copies specialized
+ * for 1, 2, 4, 8 and 16 byte fields that the compiler vectorizes.
+ */
+QUARISMA_API void pack_records(
+    const void* records, const layout_plan& plan, void* out, size_t first = 0, size_t n = SIZE_MAX);
+
+/**
+ * @brief Inverse of pack_records(): scatter the fields back into AoS records
+ */
+QUARISMA_API void unpack_records(
+    const void* in, const layout_plan& plan, void* records, size_t first = 0, size_t n = SIZE_MAX);
+
+/**
+ * @brief Lay out host AoS records into a device buffer of the plan
+ *
+ * Chunks of records are laid out into two pinned staging buffers in turn,
+ * each copied with cudaMemcpyAsync while the next chunk is packed. Returns
+ * once records may be modified again; the copies are ordered on stream.
+ *
+ * @param stream cudaStream_t, or nullptr for the default stream
+ * @throws quarisma::exception on CUDA errors or without CUDA support
+ */
+QUARISMA_API void upload_records(
+    const void* records, const layout_plan& plan, void* device_out, void* stream = nullptr);
+
+/**
+ * @brief Copy a device buffer of the plan back into host AoS records
+ *
+ * Chunks are copied into pinned staging and unpacked while the next chunk
+ * is in flight. Work queued earlier on stream is waited for.
+ */
+QUARISMA_API void download_records(
+    const void* device_in, const layout_plan& plan, void* records, void* stream = nullptr);
+
+/**
+ * @brief Lay out AoS records already on the device, without a kernel
+ *
+ * Each field is gathered by strided copies performed by the copy engines:
+ * one cudaMemcpy2DAsync per SoA column, one cudaMemcpy3DAsync over the whole
+ * tiles of an AoSoA plan. Asynchronous on stream.
+ */
+QUARISMA_API void transpose_records_on_device(
+    const void* device_records, const layout_plan& plan, void* device_out, void* stream = nullptr);
+
+}  // namespace gpu
+}  // namespace quarisma
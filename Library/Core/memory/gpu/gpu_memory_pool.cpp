@@ -3,12 +3,16 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <deque>
 #include <iomanip>
+#include <iterator>
+#include <limits>
 #include <sstream>
 
 #include "common/configure.h"
 #include "common/macros.h"
 #include "logging/logger.h"
+#include "memory/helper/memory_pressure.h"
 #include "util/exception.h"
 #include "util/flat_hash.h"
 
@@ -38,6 +42,28 @@ struct void_ptr_hash
     }
 };
 
+/**
+ * @brief A cached block and the order in which it was cached
+ */
+struct cached_entry
+{
+    gpu_memory_block block;
+    uint64_t         sequence = 0;
+};
+
+/**
+ * @brief Cached blocks and statistics of one size class
+ */
+struct size_bin
+{
+    /** @brief Cached blocks, oldest first; reuse takes the newest */
+    std::deque<cached_entry> blocks;
+
+    size_t cache_hits   = 0;
+    size_t cache_misses = 0;
+    size_t evictions    = 0;
+};
+
 /**
  * @brief Internal implementation of GPU memory pool
  *
@@ -48,18 +74,32 @@ struct void_ptr_hash
 class gpu_memory_pool_impl : public gpu_memory_pool
 {
 private:
+    static constexpr size_t no_bin = std::numeric_limits<size_t>::max();
+
     /** @brief Pool configuration */
     gpu_memory_pool_config config_;
 
+    /** @brief Block size of each size class, ascending */
+    std::vector<size_t> bin_sizes_;
+
     /** @brief Mutex for thread-safe operations */
     mutable std::mutex mutex_;
 
-    /** @brief Map of size class to cached blocks */
-    quarisma_map<size_t, std::vector<gpu_memory_block>> cached_blocks_;
+    /** @brief Cached blocks and statistics of each size class (parallel to bin_sizes_) */
+    std::vector<size_bin> bins_;
 
     /** @brief Map of active allocations for tracking (using custom hash for void*) */
     quarisma_map<void*, gpu_memory_block, void_ptr_hash> active_allocations_;
 
+    /** @brief Bytes held by cached blocks across all size classes */
+    size_t cached_bytes_ = 0;
+
+    /** @brief Order stamp of the next cached block */
+    uint64_t next_sequence_ = 0;
+
+    /** @brief Registration of the cache with memory_pressure */
+    memory_pressure::cache_id pressure_id_ = 0;
+
     /** @brief Current total allocated bytes */
     std::atomic<size_t> allocated_bytes_{0};
 
@@ -78,6 +118,9 @@ private:
     /** @brief Total number of cache misses */
     std::atomic<size_t> cache_misses_{0};
 
+    /** @brief Allocations above the largest size class */
+    std::atomic<size_t> uncached_allocations_{0};
+
     /** @brief Total bytes allocated (cumulative) */
     std::atomic<size_t> total_bytes_allocated_{0};
 
@@ -85,29 +128,176 @@ private:
     std::atomic<size_t> total_bytes_deallocated_{0};
 
     /**
-     * @brief Calculate the appropriate size class for a given size
-     * @param size Requested size in bytes
-     * @return Size class that can accommodate the requested size
+     * @brief Round a size up to the allocation granularity
      */
-    size_t calculate_size_class(size_t size) const
+    size_t round_to_granularity(size_t size) const
     {
-        if (size <= config_.min_block_size)
+        if (!config_.enable_alignment)
         {
-            return config_.min_block_size;
+            return size;
         }
+        return ((size + config_.alignment_boundary - 1) / config_.alignment_boundary) *
+               config_.alignment_boundary;
+    }
 
-        if (size >= config_.max_block_size)
+    /**
+     * @brief Build the size classes S_i = S_0 * r^i, rounded to the granularity
+     */
+    void build_bins()
+    {
+        size_t const largest = round_to_granularity(config_.max_block_size);
+        size_t       size    = round_to_granularity(config_.min_block_size);
+        while (size < largest)
         {
-            return config_.max_block_size;
+            bin_sizes_.push_back(size);
+            auto const next = static_cast<size_t>(
+                std::ceil(static_cast<double>(size) * config_.block_growth_factor));
+            size = std::max(round_to_granularity(next), size + 1);
         }
+        bin_sizes_.push_back(largest);
+        bins_ = std::vector<size_bin>(bin_sizes_.size());
+    }
+
+    /**
+     * @brief Find the smallest size class that can hold `size` bytes
+     * @return Index of the size class, or no_bin if `size` is above the largest
+     */
+    size_t find_bin(size_t size) const
+    {
+        auto const it = std::lower_bound(bin_sizes_.begin(), bin_sizes_.end(), size);
+        return it == bin_sizes_.end() ? no_bin : static_cast<size_t>(it - bin_sizes_.begin());
+    }
+
+    /**
+     * @brief Release the least recently cached block (the cache must not be empty)
+     * @return Size of the released block
+     */
+    size_t evict_oldest_locked()
+    {
+        size_bin* oldest = nullptr;
+        for (auto& bin : bins_)
+        {
+            if (!bin.blocks.empty() &&
+                (oldest == nullptr ||
+                 bin.blocks.front().sequence < oldest->blocks.front().sequence))
+            {
+                oldest = &bin;
+            }
+        }
+
+        cached_entry entry = std::move(oldest->blocks.front());
+        oldest->blocks.pop_front();
+        ++oldest->evictions;
+        cached_bytes_ -= entry.block.size;
+        deallocate_direct(entry.block);
+        return entry.block.size;
+    }
+
+    /**
+     * @brief Release the least recently cached blocks until `incoming` more bytes fit
+     */
+    void evict_for_locked(size_t incoming)
+    {
+        while (cached_bytes_ > 0 && cached_bytes_ + incoming > config_.max_cached_bytes)
+        {
+            evict_oldest_locked();
+        }
+    }
+
+    /**
+     * @brief memory_pressure callback: release cached blocks, oldest first
+     */
+    size_t release_under_pressure(size_t bytes_wanted)
+    {
+        std::scoped_lock const lock(mutex_);
+        size_t                 released = 0;
+        while (cached_bytes_ > 0 && released < bytes_wanted)
+        {
+            released += evict_oldest_locked();
+        }
+        return released;
+    }
+
+    /**
+     * @brief Release every cached block to the device
+     */
+    void release_cached_locked()
+    {
+        for (auto& bin : bins_)
+        {
+            for (const auto& entry : bin.blocks)
+            {
+                deallocate_direct(entry.block);
+            }
+            bin.blocks.clear();
+        }
+        cached_bytes_ = 0;
+    }
+
+    /**
+     * @brief Allocate from the device, retrying on failure after releasing the
+     * pool's cache and then the other caches of the device
+     */
+    gpu_memory_block allocate_device_locked(
+        size_t size, device_enum device_type, int device_index)
+    {
+        try
+        {
+            return allocate_direct(size, device_type, device_index);
+        }
+        catch (const std::exception&)
+        {
+        }
+
+        if (cached_bytes_ > 0)
+        {
+            if (config_.debug_mode)
+            {
+                QUARISMA_LOG_INFO(
+                    "GPU allocation of {} bytes failed; releasing {} cached bytes and retrying",
+                    size,
+                    cached_bytes_);
+            }
+            release_cached_locked();
+            try
+            {
+                return allocate_direct(size, device_type, device_index);
+            }
+            catch (const std::exception&)
+            {
+            }
+        }
+
+        memory_pressure::instance().relieve(device_type, device_index, size, pressure_id_);
+        return allocate_direct(size, device_type, device_index);
+    }
 
-        // Calculate the size class using geometric progression
-        double const log_ratio = std::log(static_cast<double>(size) / config_.min_block_size) /
-                                 std::log(config_.block_growth_factor);
-        auto const class_index = static_cast<size_t>(std::ceil(log_ratio));
+    /**
+     * @brief Register an allocated block and return the caller's copy of it
+     */
+    gpu_memory_block activate_locked(gpu_memory_block&& block)
+    {
+        block.in_use.store(true);
+
+        // Create a copy for return before moving to active_allocations_
+        gpu_memory_block result_block(block.ptr, block.size, block.device);
+        result_block.in_use.store(true);
+        result_block.reuse_count.store(block.reuse_count.load());
+
+        active_allocations_.emplace(block.ptr, std::move(block));
 
-        return static_cast<size_t>(
-            config_.min_block_size * std::pow(config_.block_growth_factor, class_index));
+        // Update statistics
+        size_t const current_allocated =
+            allocated_bytes_.fetch_add(result_block.size) + result_block.size;
+        total_bytes_allocated_.fetch_add(result_block.size);
+        size_t current_peak = peak_allocated_bytes_.load();
+        while (current_allocated > current_peak &&
+               !peak_allocated_bytes_.compare_exchange_weak(current_peak, current_allocated))
+        {
+            // Retry if another thread updated peak_allocated_bytes_
+        }
+
+        return result_block;
     }
 
     /**
@@ -231,18 +421,36 @@ public:
             QUARISMA_THROW("Block growth factor must be greater than 1.0");
         }
 
+        if (config_.enable_alignment && config_.alignment_boundary == 0)
+        {
+            QUARISMA_THROW("Alignment boundary must be non-zero");
+        }
+
+        build_bins();
+
         if (config_.debug_mode)
         {
             QUARISMA_LOG_INFO(
-                "GPU memory pool initialized with min_block={}, max_block={}, growth_factor={}",
+                "GPU memory pool initialized with min_block={}, max_block={}, growth_factor={}, "
+                "{} size classes, cache budget={} bytes",
                 config_.min_block_size,
                 config_.max_block_size,
-                config_.block_growth_factor);
+                config_.block_growth_factor,
+                bin_sizes_.size(),
+                config_.max_cached_bytes);
         }
+
+        pressure_id_ = memory_pressure::instance().register_cache(
+            "gpu_memory_pool",
+            memory_trim_cost::MEDIUM,
+            device_enum::CUDA,
+            -1,
+            [this](size_t bytes_wanted) { return release_under_pressure(bytes_wanted); });
     }
 
     ~gpu_memory_pool_impl() override
     {
+        memory_pressure::instance().unregister_cache(pressure_id_);
         gpu_memory_pool_impl::clear_cache();
 
         if (config_.debug_mode && !active_allocations_.empty())
@@ -260,71 +468,47 @@ public:
             QUARISMA_THROW("Cannot allocate zero bytes");
         }
 
-        size_t const size_class = calculate_size_class(size);
+        size_t const bin_index = find_bin(size);
         total_allocations_.fetch_add(1);
 
         std::scoped_lock const lock(mutex_);
 
-        // Try to find a cached block of the appropriate size class
-        auto cache_it = cached_blocks_.find(size_class);
-        if (cache_it != cached_blocks_.end() && !cache_it->second.empty())
+        // Requests above the largest size class are allocated exactly and never cached
+        if (bin_index == no_bin)
         {
-            // Find a block for the correct device
-            auto& blocks = cache_it->second;
-            for (auto it = blocks.begin(); it != blocks.end(); ++it)
-            {
-                if (it->device.type() == device_type && it->device.index() == device_index)
-                {
-                    gpu_memory_block block = std::move(*it);
-                    blocks.erase(it);
-
-                    block.in_use.store(true);
-                    block.reuse_count.fetch_add(1);
-
-                    // Create a copy for return before moving to active_allocations_
-                    gpu_memory_block result_block(block.ptr, block.size, block.device);
-                    result_block.in_use.store(true);
-                    result_block.reuse_count.store(block.reuse_count.load());
-
-                    active_allocations_.emplace(block.ptr, std::move(block));
+            cache_misses_.fetch_add(1);
+            uncached_allocations_.fetch_add(1);
+            return activate_locked(allocate_device_locked(size, device_type, device_index));
+        }
 
-                    cache_hits_.fetch_add(1);
-                    total_bytes_allocated_.fetch_add(result_block.size);
+        // Reuse the most recently cached block of the size class for this device
+        auto& bin = bins_[bin_index];
+        for (auto it = bin.blocks.rbegin(); it != bin.blocks.rend(); ++it)
+        {
+            if (it->block.device.type() == device_type && it->block.device.index() == device_index)
+            {
+                gpu_memory_block block = std::move(it->block);
+                bin.blocks.erase(std::next(it).base());
+                cached_bytes_ -= block.size;
+                block.reuse_count.fetch_add(1);
 
-                    if (config_.debug_mode)
-                    {
-                        QUARISMA_LOG_INFO("Cache hit: reusing block of size {}", result_block.size);
-                    }
+                ++bin.cache_hits;
+                cache_hits_.fetch_add(1);
 
-                    return result_block;
+                if (config_.debug_mode)
+                {
+                    QUARISMA_LOG_INFO("Cache hit: reusing block of size {}", block.size);
                 }
+
+                return activate_locked(std::move(block));
             }
         }
 
         // No suitable cached block found, allocate new one
+        ++bin.cache_misses;
         cache_misses_.fetch_add(1);
-        gpu_memory_block block = allocate_direct(size_class, device_type, device_index);
-        block.in_use.store(true);
-
-        // Create a copy for return before moving to active_allocations_
-        gpu_memory_block result_block(block.ptr, block.size, block.device);
-        result_block.in_use.store(true);
-        result_block.reuse_count.store(block.reuse_count.load());
-
-        active_allocations_.emplace(block.ptr, std::move(block));
-
-        // Update statistics
-        size_t const current_allocated =
-            allocated_bytes_.fetch_add(result_block.size) + result_block.size;
-        total_bytes_allocated_.fetch_add(result_block.size);
-        size_t current_peak = peak_allocated_bytes_.load();
-        while (current_allocated > current_peak &&
-               !peak_allocated_bytes_.compare_exchange_weak(current_peak, current_allocated))
-        {
-            // Retry if another thread updated peak_allocated_bytes_
-        }
-
-        return result_block;
+        return activate_locked(
+            allocate_device_locked(bin_sizes_[bin_index], device_type, device_index));
     }
 
     void deallocate(const gpu_memory_block& block) override
@@ -348,23 +532,25 @@ public:
         total_deallocations_.fetch_add(1);
         total_bytes_deallocated_.fetch_add(cached_block.size);
 
-        // Check if we should cache this block
-        auto& cache_vector = cached_blocks_[cached_block.size];
-        if (cache_vector.size() < config_.max_cached_blocks)
+        // Only blocks of a size class are cached, and only within the byte budget
+        size_t const bin_index = find_bin(cached_block.size);
+        if (bin_index == no_bin || bin_sizes_[bin_index] != cached_block.size ||
+            cached_block.size > config_.max_cached_bytes)
         {
-            cached_block.in_use.store(false);
-            const auto cached_size = cached_block.size;
-            cache_vector.emplace_back(std::move(cached_block));
-
-            if (config_.debug_mode)
-            {
-                QUARISMA_LOG_INFO("Cached block of size {}", cached_size);
-            }
+            deallocate_direct(cached_block);
+            return;
         }
-        else
+
+        evict_for_locked(cached_block.size);
+
+        cached_block.in_use.store(false);
+        const auto cached_size = cached_block.size;
+        bins_[bin_index].blocks.push_back({std::move(cached_block), next_sequence_++});
+        cached_bytes_ += cached_size;
+
+        if (config_.debug_mode)
         {
-            // Cache is full, deallocate directly
-            deallocate_direct(cached_block);
+            QUARISMA_LOG_INFO("Cached block of size {}", cached_size);
         }
     }
 
@@ -382,15 +568,7 @@ public:
     {
         std::scoped_lock const lock(mutex_);
 
-        for (auto& [size_class, blocks] : cached_blocks_)
-        {
-            for (const auto& block : blocks)
-            {
-                deallocate_direct(block);
-            }
-        }
-
-        cached_blocks_.clear();
+        release_cached_locked();
 
         if (config_.debug_mode)
         {
@@ -412,14 +590,22 @@ public:
         oss << "  Cache hit rate: " << std::fixed << std::setprecision(2)
             << (100.0 * cache_hits_.load() / std::max(total_allocations_.load(), size_t(1)))
             << "%\n";
+        oss << "  Uncached allocations: " << uncached_allocations_.load() << "\n";
+        oss << "  Cached memory: " << (cached_bytes_ / 1024.0 / 1024.0) << " MB of "
+            << (config_.max_cached_bytes / 1024.0 / 1024.0) << " MB\n";
+        oss << "  Size classes: " << bin_sizes_.size() << "\n";
 
-        size_t total_cached = 0;
-        for (const auto& [size_class, blocks] : cached_blocks_)
+        for (size_t i = 0; i < bins_.size(); ++i)
         {
-            total_cached += blocks.size() * size_class;
+            const auto& bin = bins_[i];
+            if (bin.cache_hits + bin.cache_misses == 0 && bin.blocks.empty())
+            {
+                continue;
+            }
+            oss << "    " << (bin_sizes_[i] / 1024.0) << " KB: hits=" << bin.cache_hits
+                << " misses=" << bin.cache_misses << " evictions=" << bin.evictions
+                << " cached=" << bin.blocks.size() << "\n";
         }
-        oss << "  Cached memory: " << (total_cached / 1024.0 / 1024.0) << " MB\n";
-        oss << "  Cache entries: " << cached_blocks_.size() << " size classes\n";
 
         return oss.str();
     }
@@ -435,8 +621,9 @@ public:
         stats.total_deallocations = total_deallocations_.load();
 
         // Cache performance metrics
-        stats.cache_hits   = cache_hits_.load();
-        stats.cache_misses = cache_misses_.load();
+        stats.cache_hits           = cache_hits_.load();
+        stats.cache_misses         = cache_misses_.load();
+        stats.uncached_allocations = uncached_allocations_.load();
 
         // Calculate cache hit rate
         size_t const total_requests = stats.cache_hits + stats.cache_misses;
@@ -455,14 +642,26 @@ public:
         stats.current_bytes_in_use    = allocated_bytes_.load();
         stats.peak_bytes_in_use       = peak_allocated_bytes_.load();
         stats.active_allocations      = active_allocations_.size();
+        stats.cached_memory           = cached_bytes_;
 
-        // Calculate cached memory
-        size_t cached_memory = 0;
-        for (const auto& [size_class, blocks] : cached_blocks_)
+        // Per size class statistics, skipping classes that were never used
+        for (size_t i = 0; i < bins_.size(); ++i)
         {
-            cached_memory += blocks.size() * size_class;
+            const auto& bin = bins_[i];
+            if (bin.cache_hits + bin.cache_misses == 0 && bin.blocks.empty())
+            {
+                continue;
+            }
+
+            gpu_memory_pool_bin_statistics bin_stats;
+            bin_stats.block_size    = bin_sizes_[i];
+            bin_stats.cache_hits    = bin.cache_hits;
+            bin_stats.cache_misses  = bin.cache_misses;
+            bin_stats.evictions     = bin.evictions;
+            bin_stats.cached_blocks = bin.blocks.size();
+            bin_stats.cached_bytes  = bin.blocks.size() * bin_sizes_[i];
+            stats.bins.push_back(bin_stats);
         }
-        stats.cached_memory = cached_memory;
 
         return stats;
     }
@@ -23,6 +23,7 @@
 #include <chrono>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -48,20 +49,34 @@ namespace gpu
  */
 struct QUARISMA_VISIBILITY gpu_memory_pool_config
 {
-    /** @brief Minimum block size in bytes (default: 1KB) */
+    /** @brief Smallest size class in bytes (default: 1KB) */
     size_t min_block_size = 1024;
 
-    /** @brief Maximum block size in bytes (default: 64MB) */
-    size_t max_block_size = 64ULL * 1024ULL;
+    /**
+     * @brief Largest size class in bytes (default: 8GB)
+     *
+     * Larger requests are allocated exactly and never cached.
+     */
+    size_t max_block_size = 8ULL * 1024ULL * 1024ULL * 1024ULL;
 
-    /** @brief Block size growth factor (default: 2.0) */
-    double block_growth_factor = 2.0;
+    /**
+     * @brief Ratio between consecutive size classes (default: 1.25)
+     *
+     * Requests are rounded up to the next class, so this bounds the memory
+     * wasted by rounding to (growth factor - 1) of the request.
+     */
+    double block_growth_factor = 1.25;
 
     /** @brief Maximum total pool size in bytes (default: 1GB) */
     size_t max_pool_size = 1024ULL * 1024;
 
-    /** @brief Maximum number of cached blocks per size class (default: 16) */
-    size_t max_cached_blocks = 16;
+    /**
+     * @brief Byte budget for cached blocks across all size classes (default: 2GB)
+     *
+     * When a freed block does not fit, the least recently cached blocks are
+     * released to the device first.
+     */
+    size_t max_cached_bytes = 2ULL * 1024ULL * 1024ULL * 1024ULL;
 
     /** @brief Enable memory alignment for SIMD operations (default: true) */
     bool enable_alignment = true;
@@ -76,6 +91,30 @@ struct QUARISMA_VISIBILITY gpu_memory_pool_config
     bool debug_mode = false;
 };
 
+/**
+ * @brief Statistics of one size class of a GPU memory pool
+ */
+struct QUARISMA_VISIBILITY gpu_memory_pool_bin_statistics
+{
+    /** @brief Size of the blocks in this class in bytes */
+    size_t block_size = 0;
+
+    /** @brief Allocations served from the cache */
+    size_t cache_hits = 0;
+
+    /** @brief Allocations that went to the device */
+    size_t cache_misses = 0;
+
+    /** @brief Cached blocks released to keep within the byte budget */
+    size_t evictions = 0;
+
+    /** @brief Number of blocks currently cached */
+    size_t cached_blocks = 0;
+
+    /** @brief Bytes currently cached */
+    size_t cached_bytes = 0;
+};
+
 /**
  * @brief GPU memory pool statistics
  *
@@ -116,6 +155,12 @@ struct QUARISMA_VISIBILITY gpu_memory_pool_statistics
 
     /** @brief Number of active allocations */
     size_t active_allocations = 0;
+
+    /** @brief Allocations larger than the largest size class, never cached */
+    size_t uncached_allocations = 0;
+
+    /** @brief Per size class statistics, for the classes that have been used */
+    std::vector<gpu_memory_pool_bin_statistics> bins;
 };
 
 /**
@@ -207,16 +252,19 @@ struct QUARISMA_VISIBILITY gpu_memory_block
  *
  * Mathematical foundation:
  * The pool uses a geometric progression for block sizes: S_i = S_0 * r^i
- * where S_0 is the minimum block size and r is the growth factor.
- * This ensures efficient memory utilization while minimizing fragmentation.
+ * where S_0 is the minimum block size and r is the growth factor, each
+ * rounded up to the alignment boundary. With the defaults this gives about
+ * 70 size classes from 1KB to 8GB. Freed blocks are cached per class until
+ * the cached bytes reach max_cached_bytes.
  *
  * @example
  * ```cpp
  * // Configure memory pool for Monte Carlo simulations
  * gpu_memory_pool_config config;
- * config.min_block_size = 4096;        // 4KB minimum
- * config.max_block_size = 128 * 1024ULL;  // 128MB maximum
- * config.block_growth_factor = 1.5;    // Moderate growth
+ * config.min_block_size = 4096;                    // 4KB minimum
+ * config.max_block_size = 1024ULL * 1024ULL * 1024ULL;  // 1GB maximum
+ * config.block_growth_factor = 1.5;                // Coarser classes
+ * config.max_cached_bytes = 4ULL << 30;            // Cache up to 4GB
  *
  * auto pool = gpu_memory_pool::create(config);
  *
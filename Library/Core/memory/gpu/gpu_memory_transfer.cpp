@@ -2,16 +2,22 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
+#include <map>
 #include <mutex>
 #include <queue>
 #include <sstream>
 #include <thread>
+#include <tuple>
 #include <utility>
 
 #include "common/configure.h"
 #include "common/macros.h"
 #include "logging/logger.h"
+#include "memory/gpu/gpu_device_manager.h"
+#include "memory/helper/memory_range_table.h"
 #include "util/exception.h"
 #include "util/flat_hash.h"
 
@@ -115,6 +121,591 @@ public:
 };
 #endif
 
+#if QUARISMA_HAS_CUDA
+/**
+ * @brief Ring of page-locked host buffers for staging pageable transfers
+ *
+ * Copies from pageable memory cannot be DMA'd directly, so the driver stages
+ * them through its own pinned buffer and the host copy and the DMA run one
+ * after the other. The ring splits a transfer into buffer-sized chunks and
+ * pipelines them: the host memcpy of one chunk runs while the DMA of the
+ * previous chunk is in flight. Each buffer has an event recorded after its
+ * last DMA, so a buffer is only rewritten once the device is done with it.
+ *
+ * Transfers through one ring are serialized; the ring belongs to one device.
+ */
+class pinned_staging_ring
+{
+public:
+    pinned_staging_ring(int device_index, size_t buffer_bytes, size_t buffer_count)
+        : buffer_bytes_(buffer_bytes)
+    {
+        cudaSetDevice(device_index);
+
+        buffers_.reserve(buffer_count);
+        events_.reserve(buffer_count);
+        for (size_t i = 0; i < buffer_count; ++i)
+        {
+            void*             buffer = nullptr;
+            cudaError_t const result = cudaHostAlloc(&buffer, buffer_bytes_, cudaHostAllocDefault);
+            if (result != cudaSuccess)
+            {
+                release();
+                QUARISMA_THROW(
+                    "Failed to allocate pinned staging buffer: {}",
+                    std::string(cudaGetErrorString(result)));
+            }
+            buffers_.push_back(buffer);
+
+            cudaEvent_t event = nullptr;
+            cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+            events_.push_back(event);
+        }
+    }
+
+    ~pinned_staging_ring() { release(); }
+
+    pinned_staging_ring(const pinned_staging_ring&)            = delete;
+    pinned_staging_ring& operator=(const pinned_staging_ring&) = delete;
+
+    size_t buffer_bytes() const noexcept { return buffer_bytes_; }
+
+    /**
+     * @brief Copy pageable host memory to the device, chunk by chunk
+     */
+    cudaError_t upload(void* dst, const void* src, size_t size, cudaStream_t stream)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        const auto* host   = static_cast<const char*>(src);
+        auto*       device = static_cast<char*>(dst);
+        for (size_t offset = 0, chunk = 0; offset < size; offset += buffer_bytes_, ++chunk)
+        {
+            size_t const slot  = chunk % buffers_.size();
+            size_t const bytes = std::min(buffer_bytes_, size - offset);
+
+            // Wait for the previous DMA out of this buffer before refilling it
+            cudaError_t result = cudaEventSynchronize(events_[slot]);
+            if (result != cudaSuccess)
+            {
+                return result;
+            }
+            std::memcpy(buffers_[slot], host + offset, bytes);
+
+            result = cudaMemcpyAsync(
+                device + offset, buffers_[slot], bytes, cudaMemcpyHostToDevice, stream);
+            if (result != cudaSuccess)
+            {
+                return result;
+            }
+            cudaEventRecord(events_[slot], stream);
+        }
+        return cudaSuccess;
+    }
+
+    /**
+     * @brief Copy device memory to pageable host memory, chunk by chunk
+     *
+     * Up to buffer_count - 1 chunks are in flight ahead of the one being
+     * copied out to the destination.
+     */
+    cudaError_t download(void* dst, const void* src, size_t size, cudaStream_t stream)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        auto*        host   = static_cast<char*>(dst);
+        const auto*  device = static_cast<const char*>(src);
+        size_t const chunks = (size + buffer_bytes_ - 1) / buffer_bytes_;
+        size_t const depth  = std::max<size_t>(buffers_.size() - 1, 1);
+
+        size_t issued = 0;
+        for (size_t drained = 0; drained < chunks; ++drained)
+        {
+            while (issued < chunks && issued - drained < depth)
+            {
+                size_t const slot   = issued % buffers_.size();
+                size_t const offset = issued * buffer_bytes_;
+                size_t const bytes  = std::min(buffer_bytes_, size - offset);
+
+                cudaError_t const result = cudaMemcpyAsync(
+                    buffers_[slot], device + offset, bytes, cudaMemcpyDeviceToHost, stream);
+                if (result != cudaSuccess)
+                {
+                    return result;
+                }
+                cudaEventRecord(events_[slot], stream);
+                ++issued;
+            }
+
+            size_t const slot   = drained % buffers_.size();
+            size_t const offset = drained * buffer_bytes_;
+            size_t const bytes  = std::min(buffer_bytes_, size - offset);
+
+            cudaError_t const result = cudaEventSynchronize(events_[slot]);
+            if (result != cudaSuccess)
+            {
+                return result;
+            }
+            std::memcpy(host + offset, buffers_[slot], bytes);
+        }
+        return cudaSuccess;
+    }
+
+private:
+    void release() noexcept
+    {
+        for (auto* event : events_)
+        {
+            cudaEventDestroy(event);
+        }
+        for (auto* buffer : buffers_)
+        {
+            cudaFreeHost(buffer);
+        }
+        events_.clear();
+        buffers_.clear();
+    }
+
+    size_t                   buffer_bytes_;
+    std::vector<void*>       buffers_;
+    std::vector<cudaEvent_t> events_;
+    std::mutex               mutex_;
+};
+
+/**
+ * @brief Pinned host buffers relaying copies between devices without peer access
+ *
+ * Each chunk is copied device-to-host on a stream of the source device and
+ * host-to-device on a stream of the destination device, the second waiting
+ * for the first through an event. Different chunks use different buffers, so
+ * the download of one chunk overlaps the upload of the previous one and the
+ * data crosses the host once, through pinned memory. The copy is ordered after
+ * work already queued on the caller's stream, and work queued on it later
+ * waits for the copy; the host does not block.
+ *
+ * Transfers through one relay are serialized; the relay belongs to one pair.
+ */
+class peer_staging_relay
+{
+public:
+    peer_staging_relay(int src_device, int dst_device, size_t buffer_bytes, size_t buffer_count)
+        : src_device_(src_device), dst_device_(dst_device), buffer_bytes_(buffer_bytes)
+    {
+        int previous_device = 0;
+        cudaGetDevice(&previous_device);
+
+        cudaError_t result = create_side(src_device_, src_stream_, read_done_, buffer_count);
+        if (result == cudaSuccess)
+        {
+            result = create_side(dst_device_, dst_stream_, write_done_, buffer_count);
+        }
+        for (size_t i = 0; result == cudaSuccess && i < buffer_count; ++i)
+        {
+            void* buffer = nullptr;
+            result       = cudaHostAlloc(&buffer, buffer_bytes_, cudaHostAllocPortable);
+            if (result == cudaSuccess)
+            {
+                buffers_.push_back(buffer);
+            }
+        }
+        if (result == cudaSuccess)
+        {
+            cudaSetDevice(src_device_);
+            result = cudaEventCreateWithFlags(&src_start_, cudaEventDisableTiming);
+        }
+        if (result == cudaSuccess)
+        {
+            cudaSetDevice(dst_device_);
+            result = cudaEventCreateWithFlags(&dst_start_, cudaEventDisableTiming);
+        }
+        if (result == cudaSuccess)
+        {
+            result = cudaEventCreateWithFlags(&finished_, cudaEventDisableTiming);
+        }
+        cudaSetDevice(previous_device);
+
+        if (result != cudaSuccess)
+        {
+            release();
+            QUARISMA_THROW(
+                "Failed to create peer staging relay: {}",
+                std::string(cudaGetErrorString(result)));
+        }
+    }
+
+    ~peer_staging_relay() { release(); }
+
+    peer_staging_relay(const peer_staging_relay&)            = delete;
+    peer_staging_relay& operator=(const peer_staging_relay&) = delete;
+
+    /**
+     * @brief Copy `size` bytes from the source to the destination device
+     * @param stream Caller's stream, on `stream_device`
+     * @param stream_device Source or destination device
+     */
+    cudaError_t copy(
+        void* dst, const void* src, size_t size, cudaStream_t stream, int stream_device)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        int previous_device = 0;
+        cudaGetDevice(&previous_device);
+        cudaError_t const result = relay(dst, src, size, stream, stream_device);
+        cudaSetDevice(previous_device);
+        return result;
+    }
+
+private:
+    static cudaError_t create_side(
+        int device, cudaStream_t& stream, std::vector<cudaEvent_t>& events, size_t count)
+    {
+        cudaSetDevice(device);
+        cudaError_t result = cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking);
+        for (size_t i = 0; result == cudaSuccess && i < count; ++i)
+        {
+            cudaEvent_t event = nullptr;
+            result            = cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+            if (result == cudaSuccess)
+            {
+                events.push_back(event);
+            }
+        }
+        return result;
+    }
+
+    cudaError_t relay(
+        void* dst, const void* src, size_t size, cudaStream_t stream, int stream_device)
+    {
+        // Events must be recorded on a stream of the device they belong to
+        cudaEvent_t const start = stream_device == dst_device_ ? dst_start_ : src_start_;
+        cudaSetDevice(stream_device);
+        cudaError_t result = cudaEventRecord(start, stream);
+        if (result != cudaSuccess)
+        {
+            return result;
+        }
+        cudaSetDevice(src_device_);
+        cudaStreamWaitEvent(src_stream_, start, 0);
+
+        const auto* source      = static_cast<const char*>(src);
+        auto*       destination = static_cast<char*>(dst);
+        for (size_t offset = 0, chunk = 0; offset < size; offset += buffer_bytes_, ++chunk)
+        {
+            size_t const slot  = chunk % buffers_.size();
+            size_t const bytes = std::min(buffer_bytes_, size - offset);
+
+            // Refill a buffer only once its previous upload has read it
+            cudaSetDevice(src_device_);
+            cudaStreamWaitEvent(src_stream_, write_done_[slot], 0);
+            result = cudaMemcpyAsync(
+                buffers_[slot], source + offset, bytes, cudaMemcpyDeviceToHost, src_stream_);
+            if (result != cudaSuccess)
+            {
+                return result;
+            }
+            cudaEventRecord(read_done_[slot], src_stream_);
+
+            cudaSetDevice(dst_device_);
+            cudaStreamWaitEvent(dst_stream_, read_done_[slot], 0);
+            result = cudaMemcpyAsync(
+                destination + offset, buffers_[slot], bytes, cudaMemcpyHostToDevice, dst_stream_);
+            if (result != cudaSuccess)
+            {
+                return result;
+            }
+            cudaEventRecord(write_done_[slot], dst_stream_);
+        }
+
+        cudaSetDevice(dst_device_);
+        cudaEventRecord(finished_, dst_stream_);
+        cudaSetDevice(stream_device);
+        return cudaStreamWaitEvent(stream, finished_, 0);
+    }
+
+    void release() noexcept
+    {
+        for (auto* event : read_done_)
+        {
+            cudaEventDestroy(event);
+        }
+        for (auto* event : write_done_)
+        {
+            cudaEventDestroy(event);
+        }
+        for (auto* event : {src_start_, dst_start_, finished_})
+        {
+            if (event != nullptr)
+            {
+                cudaEventDestroy(event);
+            }
+        }
+        for (auto* stream : {src_stream_, dst_stream_})
+        {
+            if (stream != nullptr)
+            {
+                cudaStreamDestroy(stream);
+            }
+        }
+        for (auto* buffer : buffers_)
+        {
+            cudaFreeHost(buffer);
+        }
+        read_done_.clear();
+        write_done_.clear();
+        buffers_.clear();
+        src_start_  = nullptr;
+        dst_start_  = nullptr;
+        finished_   = nullptr;
+        src_stream_ = nullptr;
+        dst_stream_ = nullptr;
+    }
+
+    int                      src_device_;
+    int                      dst_device_;
+    size_t                   buffer_bytes_;
+    std::vector<void*>       buffers_;
+    cudaStream_t             src_stream_ = nullptr;
+    cudaStream_t             dst_stream_ = nullptr;
+    std::vector<cudaEvent_t> read_done_;   // Source device, one per buffer
+    std::vector<cudaEvent_t> write_done_;  // Destination device, one per buffer
+    cudaEvent_t              src_start_ = nullptr;
+    cudaEvent_t              dst_start_ = nullptr;
+    cudaEvent_t              finished_  = nullptr;
+    std::mutex               mutex_;
+};
+
+/**
+ * @brief Streams and events of copy/compute pipelines on one device
+ *
+ * Uploads are issued on one stream and downloads on another, so that both
+ * copy engines run, and the compute of the chunks on a few streams of their
+ * own. Each compute stream has an event recorded after the upload of its
+ * current chunk and one after its compute: a stage waits for the previous
+ * stage of the same chunk on the device, never on the host. An event can be
+ * recorded again for the next chunk of its stream as soon as the waits on it
+ * are enqueued.
+ */
+class copy_compute_pipeline
+{
+public:
+    copy_compute_pipeline(int device, int priority, size_t stream_count) : device_(device)
+    {
+        int previous_device = 0;
+        cudaGetDevice(&previous_device);
+
+        cudaError_t result = cudaSuccess;
+        try
+        {
+            upload_   = gpu_stream::create(device_enum::CUDA, device_, priority);
+            download_ = gpu_stream::create(device_enum::CUDA, device_, priority);
+            for (size_t i = 0; i < stream_count; ++i)
+            {
+                compute_.push_back(gpu_stream::create(device_enum::CUDA, device_, priority));
+            }
+        }
+        catch (...)
+        {
+            cudaSetDevice(previous_device);
+            throw;
+        }
+
+        for (size_t i = 0; result == cudaSuccess && i < 2 * stream_count + 2; ++i)
+        {
+            cudaEvent_t event = nullptr;
+            result            = cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+            if (result == cudaSuccess)
+            {
+                events_.push_back(event);
+            }
+        }
+        cudaSetDevice(previous_device);
+
+        if (result != cudaSuccess)
+        {
+            release();
+            QUARISMA_THROW(
+                "Failed to create copy/compute pipeline: {}",
+                std::string(cudaGetErrorString(result)));
+        }
+    }
+
+    ~copy_compute_pipeline() { release(); }
+
+    copy_compute_pipeline(const copy_compute_pipeline&)            = delete;
+    copy_compute_pipeline& operator=(const copy_compute_pipeline&) = delete;
+
+    /**
+     * @brief Enqueue all the chunks of `pipeline` and wait for the last download
+     * @param caller Stream whose prior work the pipeline waits for, or nullptr
+     */
+    cudaError_t run(
+        const transfer_pipeline& pipeline, const pipeline_compute& compute, cudaStream_t caller)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        int previous_device = 0;
+        cudaGetDevice(&previous_device);
+        cudaSetDevice(device_);
+
+        cudaError_t result = cudaSuccess;
+        try
+        {
+            result = enqueue(pipeline, compute, caller);
+        }
+        catch (...)
+        {
+            // Chunks already enqueued still read and write the caller's buffers
+            cudaStreamSynchronize(native(*upload_));
+            for (const auto& stream : compute_)
+            {
+                cudaStreamSynchronize(native(*stream));
+            }
+            cudaStreamSynchronize(native(*download_));
+            cudaSetDevice(previous_device);
+            throw;
+        }
+        cudaError_t const wait = cudaEventSynchronize(finished());
+        cudaSetDevice(previous_device);
+        return result != cudaSuccess ? result : wait;
+    }
+
+private:
+    static cudaStream_t native(const gpu_stream& stream)
+    {
+        return static_cast<cudaStream_t>(stream.get_native_handle());
+    }
+
+    cudaEvent_t uploaded(size_t stream) const { return events_[2 * stream]; }
+    cudaEvent_t computed(size_t stream) const { return events_[2 * stream + 1]; }
+    cudaEvent_t started() const { return events_[events_.size() - 2]; }
+    cudaEvent_t finished() const { return events_.back(); }
+
+    cudaError_t enqueue(
+        const transfer_pipeline& pipeline, const pipeline_compute& compute, cudaStream_t caller)
+    {
+        cudaStream_t const upload   = native(*upload_);
+        cudaStream_t const download = native(*download_);
+
+        // Downloads wait for the computes, and those for the uploads
+        if (caller != nullptr)
+        {
+            cudaEventRecord(started(), caller);
+            cudaStreamWaitEvent(upload, started(), 0);
+            for (const auto& stream : compute_)
+            {
+                cudaStreamWaitEvent(native(*stream), started(), 0);
+            }
+        }
+
+        const auto*  host_input    = static_cast<const char*>(pipeline.host_input);
+        auto*        device_input  = static_cast<char*>(pipeline.device_input);
+        auto*        device_output = static_cast<char*>(pipeline.device_output);
+        auto*        host_output   = static_cast<char*>(pipeline.host_output);
+        size_t const in_bytes      = pipeline.input_item_bytes;
+        size_t const out_bytes     = pipeline.output_item_bytes;
+
+        // Chunks differ by at most one item
+        size_t const chunks    = pipeline.chunk_count;
+        size_t const per_chunk = pipeline.item_count / chunks;
+        size_t const remainder = pipeline.item_count % chunks;
+
+        cudaError_t result = cudaSuccess;
+        for (size_t i = 0; result == cudaSuccess && i < chunks; ++i)
+        {
+            size_t const begin = i * per_chunk + std::min(i, remainder);
+            size_t const end   = begin + per_chunk + (i < remainder ? 1 : 0);
+            size_t const slot  = i % compute_.size();
+
+            gpu_stream&        stream_ref = *compute_[slot];
+            cudaStream_t const stream     = native(stream_ref);
+
+            if (in_bytes != 0)
+            {
+                result = cudaMemcpyAsync(
+                    device_input + begin * in_bytes,
+                    host_input + begin * in_bytes,
+                    (end - begin) * in_bytes,
+                    cudaMemcpyHostToDevice,
+                    upload);
+                if (result != cudaSuccess)
+                {
+                    break;
+                }
+                cudaEventRecord(uploaded(slot), upload);
+                cudaStreamWaitEvent(stream, uploaded(slot), 0);
+            }
+
+            if (compute)
+            {
+                compute(pipeline_chunk{
+                    i,
+                    begin,
+                    end,
+                    device_input != nullptr ? device_input + begin * in_bytes : nullptr,
+                    device_output != nullptr ? device_output + begin * out_bytes : nullptr,
+                    &stream_ref});
+            }
+            cudaEventRecord(computed(slot), stream);
+            cudaStreamWaitEvent(download, computed(slot), 0);
+
+            if (out_bytes != 0)
+            {
+                result = cudaMemcpyAsync(
+                    host_output + begin * out_bytes,
+                    device_output + begin * out_bytes,
+                    (end - begin) * out_bytes,
+                    cudaMemcpyDeviceToHost,
+                    download);
+            }
+        }
+
+        // The downloads are the last stage: their end is the pipeline's
+        cudaError_t const record = cudaEventRecord(finished(), download);
+        return result != cudaSuccess ? result : record;
+    }
+
+    void release() noexcept
+    {
+        for (auto* event : events_)
+        {
+            cudaEventDestroy(event);
+        }
+        events_.clear();
+    }
+
+    int                                      device_;
+    std::unique_ptr<gpu_stream>              upload_;
+    std::unique_ptr<gpu_stream>              download_;
+    std::vector<std::unique_ptr<gpu_stream>> compute_;
+    std::vector<cudaEvent_t>                 events_;  // Two per compute stream, then start, end
+    std::mutex                               mutex_;
+};
+
+/**
+ * @brief Check whether host memory is pageable, i.e. not registered with CUDA
+ */
+bool is_pageable_host_memory(const void* ptr)
+{
+    // Regions of sub_allocators are classified without a driver call
+    if (auto region = memory_range_table::instance().find(ptr))
+    {
+        if (region->type != allocator_memory_enum::UNKNOWN)
+        {
+            return region->type == allocator_memory_enum::HOST_PAGEABLE;
+        }
+    }
+
+    cudaPointerAttributes attributes{};
+    if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess)
+    {
+        // Older runtimes report unregistered memory as an error
+        (void)cudaGetLastError();
+        return true;
+    }
+    return attributes.type == cudaMemoryTypeUnregistered;
+}
+#endif
+
 /**
  * @brief Transfer operation for async processing
  */
@@ -127,6 +718,8 @@ struct transfer_operation
     transfer_direction              direction;
     gpu_stream*                     stream;
     transfer_callback               callback;
+    int                             src_device = -1;  // Set for peer copies only
+    int                             dst_device = -1;
     std::promise<gpu_transfer_info> promise;
     gpu_transfer_info               info;
 
@@ -174,6 +767,36 @@ private:
     std::atomic<double> total_transfer_time_ms_{0.0};
     std::atomic<size_t> failed_transfers_{0};
 
+    /** @brief Call-to-completion latencies of asynchronous transfers */
+    latency_histogram async_latency_;
+
+#if QUARISMA_HAS_CUDA
+    /** @brief Pinned staging ring of each device, created on first use */
+    quarisma_map<int, std::shared_ptr<pinned_staging_ring>> staging_rings_;
+#endif
+
+    /** @brief Size of each pinned staging buffer */
+    size_t staging_buffer_bytes_ = size_t{4} * 1024ULL * 1024ULL;
+
+    /** @brief Number of pinned staging buffers per device */
+    size_t staging_buffer_count_ = 2;
+
+    /** @brief Number of transfers staged through pinned buffers */
+    std::atomic<size_t> staged_transfers_{0};
+
+#if QUARISMA_HAS_CUDA
+    /** @brief Host relay of each device pair without peer access, keyed by peer_key() */
+    quarisma_map<uint64_t, std::shared_ptr<peer_staging_relay>> peer_relays_;
+#endif
+
+#if QUARISMA_HAS_CUDA
+    /** @brief Copy/compute pipelines, keyed by device, priority and number of compute streams */
+    std::map<std::tuple<int, int, size_t>, std::shared_ptr<copy_compute_pipeline>> pipelines_;
+#endif
+
+    /** @brief Number of direct peer-to-peer transfers */
+    std::atomic<size_t> peer_transfers_{0};
+
     /** @brief Default streams for each device */
     quarisma_map<
         std::pair<device_enum, int>,
@@ -201,6 +824,169 @@ private:
         return it->second.get();
     }
 
+#if QUARISMA_HAS_CUDA
+    /**
+     * @brief Get or create the staging ring of a device
+     * @return The ring, or nullptr if pinned memory could not be allocated
+     */
+    std::shared_ptr<pinned_staging_ring> get_staging_ring(int device_index)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        auto it = staging_rings_.find(device_index);
+        if (it != staging_rings_.end())
+        {
+            return it->second;
+        }
+
+        try
+        {
+            auto ring = std::make_shared<pinned_staging_ring>(
+                device_index, staging_buffer_bytes_, staging_buffer_count_);
+            staging_rings_[device_index] = ring;
+            return ring;
+        }
+        catch (const std::exception& e)
+        {
+            QUARISMA_LOG_WARNING(
+                "Pinned staging unavailable, using direct pageable copies: {}", e.what());
+            return nullptr;
+        }
+    }
+
+    /**
+     * @brief Copy between device and pageable host memory through the staging ring
+     * @return True if the copy was staged, false if it should be issued directly
+     */
+    bool try_staged_copy(transfer_operation& op, cudaStream_t stream, cudaError_t& result)
+    {
+        if (op.direction != transfer_direction::HOST_TO_DEVICE &&
+            op.direction != transfer_direction::DEVICE_TO_HOST)
+        {
+            return false;
+        }
+
+        // A single chunk gains nothing over the driver's own staging
+        const void* host =
+            op.direction == transfer_direction::HOST_TO_DEVICE ? op.src : op.dst;
+        if (op.size <= staging_buffer_bytes() || !is_pageable_host_memory(host))
+        {
+            return false;
+        }
+
+        int device_index = 0;
+        if (op.stream != nullptr)
+        {
+            device_index = op.stream->get_device().index();
+        }
+        else
+        {
+            cudaGetDevice(&device_index);
+        }
+
+        auto ring = get_staging_ring(device_index);
+        if (!ring)
+        {
+            return false;
+        }
+
+        result = op.direction == transfer_direction::HOST_TO_DEVICE
+                     ? ring->upload(op.dst, op.src, op.size, stream)
+                     : ring->download(op.dst, op.src, op.size, stream);
+        op.info.staged = true;
+        staged_transfers_.fetch_add(1);
+        return true;
+    }
+
+    static uint64_t peer_key(int src_device, int dst_device)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(src_device)) << 32) |
+               static_cast<uint32_t>(dst_device);
+    }
+
+    /**
+     * @brief Get or create the host relay of a device pair
+     * @return The relay, or nullptr if pinned memory could not be allocated
+     */
+    std::shared_ptr<peer_staging_relay> get_peer_relay(int src_device, int dst_device)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        uint64_t const key = peer_key(src_device, dst_device);
+        auto           it  = peer_relays_.find(key);
+        if (it != peer_relays_.end())
+        {
+            return it->second;
+        }
+
+        try
+        {
+            auto relay = std::make_shared<peer_staging_relay>(
+                src_device, dst_device, staging_buffer_bytes_, staging_buffer_count_);
+            peer_relays_[key] = relay;
+            return relay;
+        }
+        catch (const std::exception& e)
+        {
+            QUARISMA_LOG_WARNING(
+                "Peer staging unavailable, leaving the copy to the driver: {}", e.what());
+            return nullptr;
+        }
+    }
+
+    /**
+     * @brief Copy between two devices, directly if they are peers
+     */
+    cudaError_t peer_copy(transfer_operation& op, cudaStream_t stream)
+    {
+        if (gpu_device_manager::instance().enable_peer_access(op.dst_device, op.src_device))
+        {
+            op.info.peer_to_peer = true;
+            peer_transfers_.fetch_add(1);
+            return cudaMemcpyPeerAsync(
+                op.dst, op.dst_device, op.src, op.src_device, op.size, stream);
+        }
+
+        int const stream_device =
+            op.stream != nullptr ? op.stream->get_device().index() : op.dst_device;
+        auto relay = stream_device == op.src_device || stream_device == op.dst_device
+                         ? get_peer_relay(op.src_device, op.dst_device)
+                         : nullptr;
+        if (!relay)
+        {
+            return cudaMemcpyPeerAsync(
+                op.dst, op.dst_device, op.src, op.src_device, op.size, stream);
+        }
+
+        op.info.staged = true;
+        staged_transfers_.fetch_add(1);
+        return relay->copy(op.dst, op.src, op.size, stream, stream_device);
+    }
+
+    /**
+     * @brief Get or create the streams and events of a pipeline shape
+     */
+    std::shared_ptr<copy_compute_pipeline> get_pipeline(const transfer_pipeline& pipeline)
+    {
+        std::scoped_lock const lock(mutex_);
+
+        auto& entry = pipelines_[std::make_tuple(
+            pipeline.device_index, pipeline.priority, pipeline.stream_count)];
+        if (!entry)
+        {
+            entry = std::make_shared<copy_compute_pipeline>(
+                pipeline.device_index, pipeline.priority, pipeline.stream_count);
+        }
+        return entry;
+    }
+#endif
+
+    size_t staging_buffer_bytes() const
+    {
+        std::scoped_lock const lock(mutex_);
+        return staging_buffer_bytes_;
+    }
+
     /**
      * @brief Perform the actual memory transfer
      */
@@ -241,7 +1027,21 @@ private:
                     cuda_stream = static_cast<cudaStream_t>(op.stream->get_native_handle());
                 }
 
-                cudaError_t result = cudaMemcpyAsync(op.dst, op.src, op.size, kind, cuda_stream);
+                cudaError_t result = cudaSuccess;
+                if (op.src_device >= 0 && op.src_device != op.dst_device)
+                {
+                    if (cuda_stream == nullptr)
+                    {
+                        cuda_stream = static_cast<cudaStream_t>(
+                            get_default_stream(device_enum::CUDA, op.dst_device)
+                                ->get_native_handle());
+                    }
+                    result = peer_copy(op, cuda_stream);
+                }
+                else if (!try_staged_copy(op, cuda_stream, result))
+                {
+                    result = cudaMemcpyAsync(op.dst, op.src, op.size, kind, cuda_stream);
+                }
                 if (result != cudaSuccess)
                 {
                     op.info.error_message =
@@ -315,6 +1115,57 @@ private:
         }
     }
 
+    static void set_peer_devices(transfer_operation& op, int src_device, int dst_device)
+    {
+        op.src_device              = src_device;
+        op.dst_device              = dst_device;
+        op.info.source_device      = device_option(device_enum::CUDA, src_device);
+        op.info.destination_device = device_option(device_enum::CUDA, dst_device);
+    }
+
+    /**
+     * @brief Run an operation on a detached thread and register it as active
+     */
+    std::future<gpu_transfer_info> launch(std::unique_ptr<transfer_operation> op)
+    {
+        size_t const transfer_id = op->id;
+        auto         future      = op->promise.get_future();
+        auto const   submitted   = std::chrono::steady_clock::now();
+
+        // Launch transfer in separate thread
+        std::thread(
+            [this, op_ptr = op.get(), submitted]()
+            {
+                perform_transfer(*op_ptr);
+                if (op_ptr->info.status == transfer_status::COMPLETED)
+                {
+                    async_latency_.record_since(submitted);
+                }
+
+                // Call callback if provided
+                if (op_ptr->callback)
+                {
+                    op_ptr->callback(op_ptr->info);
+                }
+
+                // Set promise value
+                op_ptr->promise.set_value(op_ptr->info);
+
+                // Remove from active transfers
+                std::scoped_lock const lock(mutex_);
+                active_transfers_.erase(op_ptr->id);
+            })
+            .detach();
+
+        // Store operation
+        {
+            std::scoped_lock const lock(mutex_);
+            active_transfers_[transfer_id] = std::move(op);
+        }
+
+        return future;
+    }
+
 public:
     gpu_memory_transfer_impl() = default;
 
@@ -357,36 +1208,58 @@ public:
         auto         op          = std::make_unique<transfer_operation>(
             transfer_id, src, dst, size, direction, stream, callback);
 
-        auto future = op->promise.get_future();
+        return launch(std::move(op));
+    }
 
-        // Launch transfer in separate thread
-        std::thread(
-            [this, op_ptr = op.get()]()
-            {
-                perform_transfer(*op_ptr);
+    gpu_transfer_info transfer_peer_sync(
+        const void* src,
+        int         src_device,
+        void*       dst,
+        int         dst_device,
+        size_t      size,
+        gpu_stream* stream) override
+    {
+        if ((src == nullptr) || (dst == nullptr) || size == 0 || src_device < 0 || dst_device < 0)
+        {
+            QUARISMA_THROW("Invalid transfer parameters");
+        }
 
-                // Call callback if provided
-                if (op_ptr->callback)
-                {
-                    op_ptr->callback(op_ptr->info);
-                }
+        size_t const       transfer_id = next_transfer_id_.fetch_add(1);
+        transfer_operation op(
+            transfer_id, src, dst, size, transfer_direction::DEVICE_TO_DEVICE, stream, nullptr);
+        set_peer_devices(op, src_device, dst_device);
 
-                // Set promise value
-                op_ptr->promise.set_value(op_ptr->info);
+        perform_transfer(op);
 
-                // Remove from active transfers
-                std::scoped_lock const lock(mutex_);
-                active_transfers_.erase(op_ptr->id);
-            })
-            .detach();
+        return op.info;
+    }
 
-        // Store operation
+    std::future<gpu_transfer_info> transfer_peer_async(
+        const void*       src,
+        int               src_device,
+        void*             dst,
+        int               dst_device,
+        size_t            size,
+        gpu_stream*       stream,
+        transfer_callback callback) override
+    {
+        if ((src == nullptr) || (dst == nullptr) || size == 0 || src_device < 0 || dst_device < 0)
         {
-            std::scoped_lock const lock(mutex_);
-            active_transfers_[transfer_id] = std::move(op);
+            QUARISMA_THROW("Invalid transfer parameters");
         }
 
-        return future;
+        size_t const transfer_id = next_transfer_id_.fetch_add(1);
+        auto         op          = std::make_unique<transfer_operation>(
+            transfer_id,
+            src,
+            dst,
+            size,
+            transfer_direction::DEVICE_TO_DEVICE,
+            stream,
+            std::move(callback));
+        set_peer_devices(*op, src_device, dst_device);
+
+        return launch(std::move(op));
     }
 
     std::vector<std::future<gpu_transfer_info>> transfer_batch_async(
@@ -404,6 +1277,88 @@ public:
         return futures;
     }
 
+    gpu_transfer_info run_pipeline(
+        const transfer_pipeline& pipeline,
+        const pipeline_compute&  compute,
+        gpu_stream*              stream) override
+    {
+        bool const has_input  = pipeline.input_item_bytes != 0;
+        bool const has_output = pipeline.output_item_bytes != 0;
+        if (pipeline.item_count == 0 || pipeline.chunk_count == 0 ||
+            pipeline.stream_count == 0 || pipeline.device_index < 0 ||
+            (has_input && (pipeline.host_input == nullptr || pipeline.device_input == nullptr)) ||
+            (has_output && (pipeline.device_output == nullptr || pipeline.host_output == nullptr)))
+        {
+            QUARISMA_THROW("Invalid transfer parameters");
+        }
+
+        size_t const bytes =
+            pipeline.item_count * (pipeline.input_item_bytes + pipeline.output_item_bytes);
+
+        gpu_transfer_info info;
+        info.transfer_id        = next_transfer_id_.fetch_add(1);
+        info.direction          = has_input ? transfer_direction::HOST_TO_DEVICE
+                                            : transfer_direction::DEVICE_TO_HOST;
+        info.source_device      = device_option(device_enum::CUDA, pipeline.device_index);
+        info.destination_device = info.source_device;
+        info.bytes_transferred  = bytes;
+        info.start_time         = std::chrono::high_resolution_clock::now();
+        info.status             = transfer_status::RUNNING;
+
+#if QUARISMA_HAS_CUDA
+        transfer_pipeline shape = pipeline;
+        shape.chunk_count       = std::min(pipeline.chunk_count, pipeline.item_count);
+
+        cudaStream_t const caller =
+            stream != nullptr ? static_cast<cudaStream_t>(stream->get_native_handle()) : nullptr;
+
+        cudaError_t result = cudaSuccess;
+        try
+        {
+            result = get_pipeline(shape)->run(shape, compute, caller);
+        }
+        catch (const std::exception& e)
+        {
+            info.error_message = e.what();
+            result             = cudaErrorUnknown;
+        }
+        info.end_time = std::chrono::high_resolution_clock::now();
+        if (result != cudaSuccess && info.error_message.empty())
+        {
+            info.error_message = "CUDA pipeline failed: " + std::string(cudaGetErrorString(result));
+        }
+#else
+        (void)compute;
+        (void)stream;
+        info.end_time      = std::chrono::high_resolution_clock::now();
+        info.error_message = "Copy/compute pipelines require CUDA";
+#endif
+
+        if (!info.error_message.empty())
+        {
+            info.status = transfer_status::FAILED;
+            failed_transfers_.fetch_add(1);
+            return info;
+        }
+
+        info.status              = transfer_status::COMPLETED;
+        double const duration_ms = info.get_duration_ms();
+        info.duration_us         = static_cast<uint64_t>(duration_ms * 1000.0);
+        if (duration_ms > 0.0)
+        {
+            info.bandwidth_gbps = (bytes / 1024.0 / 1024.0 / 1024.0) / (duration_ms / 1000.0);
+        }
+
+        total_transfers_.fetch_add(1);
+        total_bytes_transferred_.fetch_add(bytes);
+        double expected = total_transfer_time_ms_.load();
+        while (!total_transfer_time_ms_.compare_exchange_weak(expected, expected + duration_ms))
+        {
+            ;
+        }
+        return info;
+    }
+
     size_t get_optimal_chunk_size(
         size_t total_size, transfer_direction direction, device_enum device_type) const override
     {
@@ -466,6 +1421,9 @@ public:
         oss << "Total bytes transferred: " << std::fixed << std::setprecision(2)
             << (bytes / 1024.0 / 1024.0 / 1024.0) << " GB\n";
 
+        oss << "Staged transfers: " << staged_transfers_.load() << "\n";
+        oss << "Peer-to-peer transfers: " << peer_transfers_.load() << "\n";
+
         oss << "Total transfer time: " << std::fixed << std::setprecision(2) << (time_ms / 1000.0)
             << " seconds\n";
 
@@ -476,6 +1434,16 @@ public:
                 << " GB/s\n";
         }
 
+        auto const latency = async_latency_.snapshot();
+        if (latency.count > 0)
+        {
+            oss << "Async latency p50/p99/p99.9/max: " << std::fixed << std::setprecision(1)
+                << latency.percentile_ns(50.0) / 1000.0 << "/"
+                << latency.percentile_ns(99.0) / 1000.0 << "/"
+                << latency.percentile_ns(99.9) / 1000.0 << "/" << latency.max_ns / 1000.0
+                << " us\n";
+        }
+
         {
             std::scoped_lock const lock(mutex_);
             oss << "Active transfers: " << active_transfers_.size() << "\n";
@@ -484,12 +1452,34 @@ public:
         return oss.str();
     }
 
+    const latency_histogram& get_async_latency() const override { return async_latency_; }
+
+    void configure_staging_buffers(size_t buffer_bytes, size_t buffer_count) override
+    {
+        if (buffer_bytes == 0 || buffer_count < 2)
+        {
+            QUARISMA_THROW("Staging needs at least two non-empty buffers");
+        }
+
+        std::scoped_lock const lock(mutex_);
+        staging_buffer_bytes_ = buffer_bytes;
+        staging_buffer_count_ = buffer_count;
+#if QUARISMA_HAS_CUDA
+        // Rings in use by running transfers are released when those finish
+        staging_rings_.clear();
+        peer_relays_.clear();
+#endif
+    }
+
     void clear_statistics() override
     {
         total_transfers_.store(0);
         total_bytes_transferred_.store(0);
         total_transfer_time_ms_.store(0.0);
         failed_transfers_.store(0);
+        staged_transfers_.store(0);
+        peer_transfers_.store(0);
+        async_latency_.reset();
     }
 
     void wait_for_all_transfers() override
@@ -23,11 +23,13 @@
 #include <functional>
 #include <future>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "common/configure.h"
 #include "common/macros.h"
 #include "memory/device.h"
+#include "memory/unified_memory_stats.h"
 
 #if QUARISMA_HAS_CUDA
 #include <cuda_runtime.h>
@@ -99,6 +101,12 @@ struct QUARISMA_VISIBILITY gpu_transfer_info
     /** @brief Transfer duration in microseconds */
     uint64_t duration_us = 0;
 
+    /** @brief Whether the transfer went through the pinned staging buffers */
+    bool staged = false;
+
+    /** @brief Whether the transfer was a direct peer-to-peer copy between devices */
+    bool peer_to_peer = false;
+
     /** @brief Error message (if failed) */
     std::string error_message;
 
@@ -176,6 +184,73 @@ protected:
     QUARISMA_DELETE_COPY_AND_MOVE(gpu_stream);
 };
 
+/**
+ * @brief Description of a copy/compute pipeline
+ *
+ * The items [0, item_count) are uploaded from `host_input` to `device_input`,
+ * processed by the compute callback, and downloaded from `device_output` to
+ * `host_output`, chunk by chunk. Item `i` occupies `input_item_bytes` at
+ * offset i * input_item_bytes of the inputs, and `output_item_bytes` at
+ * offset i * output_item_bytes of the outputs. A zero item size skips the
+ * upload or the download; `device_output` may equal `device_input`.
+ *
+ * The device buffers hold all the items: chunks only pipeline the copies.
+ * Host buffers must be pinned for the copies to overlap anything.
+ */
+struct QUARISMA_VISIBILITY transfer_pipeline
+{
+    /** @brief Number of items */
+    size_t item_count = 0;
+
+    /** @brief Bytes uploaded per item (0: no upload) */
+    size_t input_item_bytes = 0;
+
+    /** @brief Bytes downloaded per item (0: no download) */
+    size_t output_item_bytes = 0;
+
+    /** @brief Host inputs, pinned */
+    const void* host_input = nullptr;
+
+    /** @brief Device inputs */
+    void* device_input = nullptr;
+
+    /** @brief Device outputs */
+    void* device_output = nullptr;
+
+    /** @brief Host outputs, pinned */
+    void* host_output = nullptr;
+
+    /** @brief CUDA device owning the device buffers */
+    int device_index = 0;
+
+    /** @brief Number of chunks the items are split into */
+    size_t chunk_count = 8;
+
+    /** @brief Number of compute streams, used round-robin by the chunks */
+    size_t stream_count = 2;
+
+    /** @brief Priority of the pipeline streams, as for gpu_stream::create() */
+    int priority = 0;
+};
+
+/**
+ * @brief A chunk of a copy/compute pipeline, passed to its compute callback
+ */
+struct QUARISMA_VISIBILITY pipeline_chunk
+{
+    size_t      index;          ///< Chunk number, in [0, chunk_count)
+    size_t      begin;          ///< First item of the chunk
+    size_t      end;            ///< One past the last item of the chunk
+    const void* device_input;   ///< Inputs of the chunk, uploaded when the stream reaches them
+    void*       device_output;  ///< Outputs of the chunk, downloaded once the stream is done
+    gpu_stream* stream;         ///< Stream to enqueue the kernels of the chunk on
+};
+
+/**
+ * @brief Enqueues the kernels of a chunk on chunk.stream, without waiting for them
+ */
+using pipeline_compute = std::function<void(const pipeline_chunk& chunk)>;
+
 /**
  * @brief High-performance GPU memory transfer manager
  *
@@ -189,6 +264,8 @@ protected:
  * - Automatic bandwidth optimization and monitoring
  * - Support for both CUDA and HIP backends
  * - Memory coalescing for optimal transfer patterns
+ * - Pinned staging buffers that pipeline copies from and to pageable memory
+ * - Peer-to-peer copies between devices, relayed through pinned memory without P2P
  * - Transfer queue management and prioritization
  * - Comprehensive error handling and recovery
  *
@@ -269,6 +346,51 @@ public:
         gpu_stream*        stream   = nullptr,
         transfer_callback  callback = nullptr) = 0;
 
+    /**
+     * @brief Copy between the memories of two devices
+     *
+     * Peer access from the destination to the source device is enabled on
+     * first use, and the copy is a cudaMemcpyPeerAsync() over NVLink or PCIe.
+     * Pairs without peer access are relayed through pinned host buffers, one
+     * device-to-host and one host-to-device copy per chunk, pipelined so that
+     * both devices' copy engines run concurrently; info.staged is set then.
+     * Copies within one device are plain device-to-device copies.
+     *
+     * @param src Source memory pointer on `src_device`
+     * @param src_device Device owning `src`
+     * @param dst Destination memory pointer on `dst_device`
+     * @param dst_device Device owning `dst`
+     * @param size Number of bytes to transfer
+     * @param stream GPU stream of either device the copy is ordered on
+     *               (optional, uses the destination's default stream if null)
+     * @return Transfer information with timing and bandwidth data
+     * @throws std::invalid_argument if parameters are invalid
+     */
+    QUARISMA_API virtual gpu_transfer_info transfer_peer_sync(
+        const void* src,
+        int         src_device,
+        void*       dst,
+        int         dst_device,
+        size_t      size,
+        gpu_stream* stream = nullptr) = 0;
+
+    /**
+     * @brief Asynchronously copy between the memories of two devices
+     *
+     * See transfer_peer_sync() for how the copy is performed.
+     *
+     * @return Future that can be used to wait for completion and get transfer info
+     * @throws std::invalid_argument if parameters are invalid
+     */
+    QUARISMA_API virtual std::future<gpu_transfer_info> transfer_peer_async(
+        const void*       src,
+        int               src_device,
+        void*             dst,
+        int               dst_device,
+        size_t            size,
+        gpu_stream*       stream   = nullptr,
+        transfer_callback callback = nullptr) = 0;
+
     /**
      * @brief Perform batched memory transfers
      * @param transfers Vector of transfer specifications
@@ -279,6 +401,32 @@ public:
         const std::vector<std::tuple<const void*, void*, size_t, transfer_direction>>& transfers,
         gpu_stream* stream = nullptr) = 0;
 
+    /**
+     * @brief Run uploads, compute and downloads of a buffer as an overlapped pipeline
+     *
+     * The items are split into `pipeline.chunk_count` chunks. Uploads go
+     * through one stream and downloads through another, and the compute of
+     * the chunks round-robins over `pipeline.stream_count` streams, all
+     * created with `pipeline.priority`. The stages of a chunk are ordered by
+     * CUDA events rather than host waits, so the upload of chunk i+1, the
+     * compute of chunk i and the download of chunk i-1 run at the same time.
+     * The only host wait is for the last download.
+     *
+     * The streams are created on first use and reused by later pipelines with
+     * the same device, priority and number of streams; such pipelines are
+     * serialized.
+     *
+     * @param pipeline Buffers and shape of the pipeline
+     * @param compute Enqueues the kernels of a chunk (optional: copies only)
+     * @param stream Stream whose prior work the pipeline waits for (optional)
+     * @return Transfer information covering all the copies of the pipeline
+     * @throws std::invalid_argument if parameters are invalid
+     */
+    QUARISMA_API virtual gpu_transfer_info run_pipeline(
+        const transfer_pipeline& pipeline,
+        const pipeline_compute&  compute,
+        gpu_stream*              stream = nullptr) = 0;
+
     /**
      * @brief Get optimal transfer chunk size for given parameters
      * @param total_size Total size to transfer
@@ -289,12 +437,37 @@ public:
     QUARISMA_API virtual size_t get_optimal_chunk_size(
         size_t total_size, transfer_direction direction, device_enum device_type) const = 0;
 
+    /**
+     * @brief Configure the pinned buffers used to stage pageable transfers
+     *
+     * Host-device transfers larger than one buffer whose host side is
+     * pageable are split into buffer-sized chunks, so that copying a chunk
+     * into pinned memory overlaps the DMA of the previous one. Each device
+     * gets its own ring of `buffer_count` buffers, allocated on first use;
+     * peer copies relayed through the host use a ring per device pair.
+     *
+     * @param buffer_bytes Size of each staging buffer (default: 4MB)
+     * @param buffer_count Number of buffers per device, at least 2 (default: 2)
+     * @throws std::invalid_argument if the configuration is invalid
+     */
+    QUARISMA_API virtual void configure_staging_buffers(
+        size_t buffer_bytes, size_t buffer_count) = 0;
+
     /**
      * @brief Get transfer statistics and performance metrics
      * @return String containing detailed transfer statistics
      */
     QUARISMA_API virtual std::string get_transfer_statistics() const = 0;
 
+    /**
+     * @brief Latencies of asynchronous transfers, from the call to completion
+     *
+     * Covers transfer_async(), transfer_peer_async() and transfer_batch_async()
+     * transfers that completed, including the time they waited to start.
+     * Cleared by clear_statistics().
+     */
+    QUARISMA_API virtual const latency_histogram& get_async_latency() const = 0;
+
     /**
      * @brief Clear transfer statistics
      */
@@ -28,6 +28,7 @@
 #include "common/configure.h"
 #include "common/macros.h"
 #include "memory/device.h"
+#include "memory/gpu/gpu_deferred_free.h"
 #include "memory/gpu/gpu_memory_pool.h"
 #include "memory/gpu/gpu_resource_tracker.h"
 
@@ -106,6 +107,9 @@ enum class pool_ownership_mode
  * - Move semantics for efficient transfers
  * - Custom deleter support for specialized cleanup
  * - Alignment-aware allocation for optimal performance
+ * - Stream-ordered frees: with a stream attached (set_stream()), destruction
+ *   hands the memory to gpu_deferred_free_queue, which frees it once the work
+ *   queued on the stream has completed, instead of stalling the host
  * 
  * The wrapper ensures that GPU memory is properly released even in
  * the presence of exceptions, preventing memory leaks in complex
@@ -143,6 +147,7 @@ public:
     using const_pointer = const T*;
     using size_type     = std::size_t;
     using deleter_type  = std::function<void(pointer)>;
+    using stream_type   = gpu_deferred_free_queue::stream_type;
 
 private:
     /** @brief Managed pointer */
@@ -175,6 +180,9 @@ private:
     /** @brief Resource tracker allocation ID */
     size_t tracker_id_ = 0;
 
+    /** @brief Stream whose queued work uses the memory, if any */
+    stream_type stream_ = nullptr;
+
     /**
      * @brief Determine the best allocation strategy
      * @param pool Requested memory pool (can be null)
@@ -335,6 +343,20 @@ private:
         }
     }
 
+    /**
+     * @brief Hand the memory to gpu_deferred_free_queue, which releases it
+     * through a wrapper of its own once the work queued on stream_ completes
+     */
+    void defer_release()
+    {
+        stream_type const stream  = stream_;
+        int const         device  = device_.index();
+        auto*             pending = new gpu_memory_wrapper(std::move(*this));
+        pending->stream_          = nullptr;
+        gpu_deferred_free_queue::instance().defer(
+            stream, device, [pending]() { delete pending; });
+    }
+
 public:
     /**
      * @brief Default constructor - creates empty wrapper
@@ -420,7 +442,8 @@ public:
           block_(std::move(other.block_)),
           deleter_(std::move(other.deleter_)),
           owns_memory_(std::exchange(other.owns_memory_, false)),
-          tracker_id_(std::exchange(other.tracker_id_, 0))
+          tracker_id_(std::exchange(other.tracker_id_, 0)),
+          stream_(std::exchange(other.stream_, nullptr))
     {
         // C++17 std::exchange provides cleaner move semantics
         // All resources are properly transferred
@@ -470,6 +493,7 @@ public:
             deleter_     = std::move(other.deleter_);
             owns_memory_ = std::exchange(other.owns_memory_, false);
             tracker_id_  = std::exchange(other.tracker_id_, 0);
+            stream_      = std::exchange(other.stream_, nullptr);
         }
         return *this;
     }
@@ -523,6 +547,9 @@ public:
             return gpu_memory_wrapper{};
         }
 
+        // Memory of buffers whose stream work has completed goes back first
+        gpu_deferred_free_queue::instance().reclaim_all();
+
         size_t        bytes = count * sizeof(T);
         device_option device(device_type, device_index);
 
@@ -673,6 +700,22 @@ public:
      */
     QUARISMA_NODISCARD bool owns_memory() const noexcept { return owns_memory_; }
 
+    /**
+     * @brief Attach the stream whose queued work uses the memory
+     *
+     * Releasing the memory (destruction, reset()) then defers the free until
+     * that work has completed, see gpu_deferred_free_queue.
+     *
+     * @param stream Stream, or nullptr to free at once
+     */
+    void set_stream(stream_type stream) noexcept { stream_ = stream; }
+
+    /**
+     * @brief Get the attached stream
+     * @return Stream set with set_stream(), or nullptr
+     */
+    QUARISMA_NODISCARD stream_type stream() const noexcept { return stream_; }
+
     /**
      * @brief Release ownership of memory
      * @return Raw pointer to released memory
@@ -694,7 +737,11 @@ public:
      */
     void reset(pointer new_ptr = nullptr, size_type new_count = 0)
     {
-        if (ptr_ && owns_memory_)
+        if (ptr_ && owns_memory_ && stream_ != nullptr)
+        {
+            defer_release();
+        }
+        else if (ptr_ && owns_memory_)
         {
             // C++17 optional-based deleter handling
             if (deleter_ != nullptr && deleter_.has_value())
@@ -765,6 +812,7 @@ public:
         swap(deleter_, other.deleter_);
         swap(owns_memory_, other.owns_memory_);
         swap(tracker_id_, other.tracker_id_);
+        swap(stream_, other.stream_);
     }
 
     // C++17 Pool Management Methods
@@ -890,6 +938,7 @@ public:
     using const_pointer = const void*;
     using size_type     = std::size_t;
     using deleter_type  = std::function<void(pointer)>;
+    using stream_type   = gpu_deferred_free_queue::stream_type;
 
 private:
     pointer                          ptr_   = nullptr;
@@ -900,6 +949,7 @@ private:
     deleter_type                     deleter_;
     bool                             owns_memory_ = false;
     size_t                           tracker_id_  = 0;
+    stream_type                      stream_      = nullptr;
 
     void default_delete()
     {
@@ -930,6 +980,16 @@ private:
         }
     }
 
+    void defer_release()
+    {
+        stream_type const stream  = stream_;
+        int const         device  = device_.index();
+        auto*             pending = new gpu_memory_wrapper(std::move(*this));
+        pending->stream_          = nullptr;
+        gpu_deferred_free_queue::instance().defer(
+            stream, device, [pending]() { delete pending; });
+    }
+
 public:
     gpu_memory_wrapper() = default;
 
@@ -967,12 +1027,14 @@ public:
           block_(std::move(other.block_)),
           deleter_(std::move(other.deleter_)),
           owns_memory_(other.owns_memory_),
-          tracker_id_(other.tracker_id_)
+          tracker_id_(other.tracker_id_),
+          stream_(other.stream_)
     {
         other.ptr_         = nullptr;
         other.bytes_       = 0;
         other.owns_memory_ = false;
         other.tracker_id_  = 0;
+        other.stream_      = nullptr;
     }
 
     gpu_memory_wrapper& operator=(gpu_memory_wrapper&& other) noexcept
@@ -989,11 +1051,13 @@ public:
             deleter_     = std::move(other.deleter_);
             owns_memory_ = other.owns_memory_;
             tracker_id_  = other.tracker_id_;
+            stream_      = other.stream_;
 
             other.ptr_         = nullptr;
             other.bytes_       = 0;
             other.owns_memory_ = false;
             other.tracker_id_  = 0;
+            other.stream_      = nullptr;
         }
         return *this;
     }
@@ -1015,6 +1079,7 @@ public:
         }
 
         device_option device(device_type, device_index);
+        gpu_deferred_free_queue::instance().reclaim_all();
 
         if (!pool)
         {
@@ -1039,6 +1104,9 @@ public:
     const device_option& device() const noexcept { return device_; }
     bool                 empty() const noexcept { return ptr_ == nullptr; }
     bool                 owns_memory() const noexcept { return owns_memory_; }
+    stream_type          stream() const noexcept { return stream_; }
+
+    void set_stream(stream_type stream) noexcept { stream_ = stream; }
 
     pointer release() noexcept
     {
@@ -1052,7 +1120,11 @@ public:
 
     void reset(pointer new_ptr = nullptr, size_type new_bytes = 0)
     {
-        if (ptr_ && owns_memory_)
+        if (ptr_ && owns_memory_ && stream_ != nullptr)
+        {
+            defer_release();
+        }
+        else if (ptr_ && owns_memory_)
         {
             if (deleter_)
             {
@@ -12,6 +12,7 @@
 #include "logging/logger.h"
 #include "util/exception.h"
 #include "util/flat_hash.h"
+#include "util/per_thread.h"
 
 // Hash specialization for std::pair<device_enum, int>
 namespace std
@@ -48,6 +49,64 @@ struct void_ptr_hash
     }
 };
 
+/**
+ * @brief Accesses logged by one thread, waiting to be applied to the allocations
+ *
+ * The owning thread is the only producer, and consumers drain it under its
+ * per_thread slot lock, so a single-producer single-consumer ring suffices.
+ */
+class access_log
+{
+public:
+    struct event
+    {
+        void*                                          ptr;
+        std::chrono::high_resolution_clock::time_point time;
+    };
+
+    static constexpr size_t capacity = 512;
+
+    access_log() = default;
+    ~access_log();
+
+    /** @brief Appends an access; false when the ring is full */
+    bool push(void* ptr, std::chrono::high_resolution_clock::time_point time) noexcept
+    {
+        size_t const head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == capacity)
+        {
+            return false;
+        }
+        events_[head % capacity] = {ptr, time};
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Calls f(const event&) on the accesses logged so far, oldest first */
+    template <typename F>
+    void drain(F&& f)
+    {
+        size_t       tail = tail_.load(std::memory_order_relaxed);
+        size_t const head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+        {
+            f(events_[tail % capacity]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    bool empty() const noexcept
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    // The producer writes head_ and the consumer tail_: keep them on separate lines
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    event events_[capacity];
+};
+
 /**
  * @brief Internal implementation of GPU resource tracker
  */
@@ -60,6 +119,9 @@ private:
     /** @brief Whether tracking is enabled */
     std::atomic<bool> tracking_enabled_{true};
 
+    /** @brief Copy of leak_config_.log_accesses, read without the lock */
+    std::atomic<bool> log_accesses_{false};
+
     /** @brief Next allocation ID */
     std::atomic<size_t> next_allocation_id_{1};
 
@@ -75,6 +137,11 @@ private:
     /** @brief Statistics */
     mutable unified_resource_stats statistics_;
 
+    /** @brief Managed memory prefetches and hints recorded */
+    std::atomic<size_t> prefetch_count_{0};
+    std::atomic<size_t> prefetched_bytes_{0};
+    std::atomic<size_t> advice_count_{0};
+
     /** @brief Background thread for periodic leak scanning */
     std::unique_ptr<std::thread> leak_scan_thread_;
 
@@ -104,6 +171,7 @@ private:
                         }
 
                         // Perform leak detection
+                        flush_access_log();
                         auto leaks = detect_leaks();
                         if (!leaks.empty() && leak_config_.enable_auto_reporting)
                         {
@@ -144,6 +212,59 @@ private:
         }
     }
 
+    /**
+     * @brief Find the active allocation containing `ptr`
+     */
+    std::shared_ptr<gpu_allocation_info> find_containing_unsafe(const void* ptr) const
+    {
+        auto it = active_allocations_.find(const_cast<void*>(ptr));  //NOLINT
+        if (it != active_allocations_.end())
+        {
+            return it->second;
+        }
+
+        // Ranges inside an allocation need a scan; prefetch and advice calls are rare
+        auto const address = reinterpret_cast<std::uintptr_t>(ptr);
+        for (const auto& [base, info] : active_allocations_)
+        {
+            auto const start = reinterpret_cast<std::uintptr_t>(base);
+            if (address >= start && address < start + info->size)
+            {
+                return info;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Apply one access to the allocation it refers to, if still active
+     */
+    void apply_access_unsafe(void* ptr, std::chrono::high_resolution_clock::time_point time) const
+    {
+        auto it = active_allocations_.find(ptr);
+        // An access older than the allocation belongs to a freed one at the same address
+        if (it == active_allocations_.end() || time < it->second->allocation_time)
+        {
+            return;
+        }
+        const auto& info = it->second;
+        info->access_count.fetch_add(1, std::memory_order_relaxed);
+        info->last_access_time = std::max(info->last_access_time, time);
+    }
+
+    /**
+     * @brief Apply the accesses every thread has logged
+     */
+    void drain_access_logs_unsafe() const
+    {
+        per_thread<access_log>::ForEachThread(
+            [this](access_log& log)
+            {
+                log.drain([this](const access_log::event& e)
+                          { apply_access_unsafe(e.ptr, e.time); });
+            });
+    }
+
     /**
      * @brief Update statistics after allocation
      */
@@ -226,6 +347,7 @@ public:
             (config.scan_interval_ms != leak_config_.scan_interval_ms);
 
         leak_config_ = config;
+        log_accesses_.store(config.log_accesses, std::memory_order_relaxed);
 
         if (restart_thread)
         {
@@ -310,14 +432,100 @@ public:
             return;
         }
 
+        auto const now = std::chrono::high_resolution_clock::now();
+        if (log_accesses_.load(std::memory_order_relaxed))
+        {
+            auto& log = per_thread<access_log>::Get();
+            if (log.push(ptr, now))
+            {
+                return;
+            }
+            flush_access_log();
+            if (log.push(ptr, now))
+            {
+                return;
+            }
+        }
+
         std::scoped_lock const lock(mutex_);
+        apply_access_unsafe(ptr, now);
+    }
 
-        auto it = active_allocations_.find(ptr);
-        if (it != active_allocations_.end())
+    void flush_access_log() override
+    {
+        std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
+    }
+
+    /**
+     * @brief Apply the accesses of an exiting thread, which no flush can reach any more
+     */
+    void flush_access_log(access_log& log)
+    {
+        std::scoped_lock const lock(mutex_);
+        log.drain([this](const access_log::event& e) { apply_access_unsafe(e.ptr, e.time); });
+    }
+
+    void record_prefetch(const void* ptr, size_t size, int device_index) override
+    {
+        if (!tracking_enabled_.load() || (ptr == nullptr))
         {
-            const auto& info = it->second;
-            info->access_count.fetch_add(1);
-            info->last_access_time = std::chrono::high_resolution_clock::now();
+            return;
+        }
+
+        prefetch_count_.fetch_add(1, std::memory_order_relaxed);
+        prefetched_bytes_.fetch_add(size, std::memory_order_relaxed);
+
+        std::scoped_lock const lock(mutex_);
+
+        auto info = find_containing_unsafe(ptr);
+        if (info)
+        {
+            info->prefetch_count.fetch_add(1);
+            info->prefetched_bytes.fetch_add(size);
+            info->last_prefetch_device = device_index;
+            info->last_access_time     = std::chrono::high_resolution_clock::now();
+        }
+    }
+
+    void record_advice(
+        const void*                             ptr,
+        QUARISMA_UNUSED size_t                  size,
+        memory_allocator::managed_memory_advice advice,
+        int                                     device_index) override
+    {
+        if (!tracking_enabled_.load() || (ptr == nullptr))
+        {
+            return;
+        }
+
+        advice_count_.fetch_add(1, std::memory_order_relaxed);
+
+        std::scoped_lock const lock(mutex_);
+
+        auto info = find_containing_unsafe(ptr);
+        if (!info)
+        {
+            return;
+        }
+
+        switch (advice)
+        {
+        case memory_allocator::managed_memory_advice::SET_READ_MOSTLY:
+            info->read_mostly = true;
+            break;
+        case memory_allocator::managed_memory_advice::UNSET_READ_MOSTLY:
+            info->read_mostly = false;
+            break;
+        case memory_allocator::managed_memory_advice::SET_PREFERRED_LOCATION:
+            info->preferred_location = device_index;
+            break;
+        case memory_allocator::managed_memory_advice::UNSET_PREFERRED_LOCATION:
+            info->preferred_location.reset();
+            break;
+        default:
+            // Accessed-by hints only affect mappings
+            break;
         }
     }
 
@@ -329,6 +537,7 @@ public:
         }
 
         std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
 
         auto it = active_allocations_.find(ptr);
         if (it != active_allocations_.end())
@@ -370,6 +579,7 @@ public:
     std::vector<std::shared_ptr<gpu_allocation_info>> get_active_allocations() const override
     {
         std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
 
         std::vector<std::shared_ptr<gpu_allocation_info>> result;
         result.reserve(active_allocations_.size());
@@ -420,6 +630,7 @@ public:
     std::vector<std::shared_ptr<gpu_allocation_info>> detect_leaks() const override
     {
         std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
         return detect_leaks_unsafe();
     }
 
@@ -427,6 +638,7 @@ public:
         const std::string& tag) const override
     {
         std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
 
         std::vector<std::shared_ptr<gpu_allocation_info>> result;
 
@@ -445,6 +657,7 @@ public:
         device_enum device_type, int device_index) const override
     {
         std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
 
         std::vector<std::shared_ptr<gpu_allocation_info>> result;
 
@@ -462,10 +675,15 @@ public:
     void clear_all_data() override
     {
         std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
 
         active_allocations_.clear();
         all_allocations_.clear();
 
+        prefetch_count_.store(0, std::memory_order_relaxed);
+        prefetched_bytes_.store(0, std::memory_order_relaxed);
+        advice_count_.store(0, std::memory_order_relaxed);
+
         // Reset all statistics to zero
         statistics_.num_allocs.store(0, std::memory_order_relaxed);
         statistics_.num_deallocs.store(0, std::memory_order_relaxed);
@@ -489,6 +707,7 @@ public:
     std::string generate_report(bool include_call_stacks) const override
     {
         std::scoped_lock const lock(mutex_);
+        drain_access_logs_unsafe();
 
         std::ostringstream oss;
         oss << "GPU Resource Tracker Report:\n";
@@ -516,6 +735,11 @@ public:
         oss << "  Largest allocation size: " << std::fixed << std::setprecision(2)
             << (statistics_.largest_alloc_size.load(std::memory_order_relaxed) / 1024.0) << " KB\n";
 
+        oss << "  Managed memory prefetches: " << prefetch_count_.load(std::memory_order_relaxed)
+            << " (" << std::fixed << std::setprecision(2)
+            << (prefetched_bytes_.load(std::memory_order_relaxed) / 1024.0 / 1024.0) << " MB)\n";
+        oss << "  Managed memory hints: " << advice_count_.load(std::memory_order_relaxed) << "\n";
+
         // Potential leaks
         auto leaks = detect_leaks_unsafe();
         oss << "  Potential leaks: " << leaks.size() << "\n\n";
@@ -637,6 +861,14 @@ public:
     bool is_tracking_enabled() const override { return tracking_enabled_.load(); }
 };
 
+access_log::~access_log()
+{
+    if (!empty())
+    {
+        static_cast<gpu_resource_tracker_impl&>(gpu_resource_tracker::instance())
+            .flush_access_log(*this);
+    }
+}
 }  // anonymous namespace
 
 gpu_resource_tracker& gpu_resource_tracker::instance()
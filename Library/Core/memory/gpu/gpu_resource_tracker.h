@@ -22,12 +22,14 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "common/macros.h"
 #include "memory/device.h"
+#include "memory/helper/memory_allocator.h"
 #include "memory/unified_memory_stats.h"
 
 namespace quarisma
@@ -86,6 +88,21 @@ struct QUARISMA_VISIBILITY gpu_allocation_info
     /** @brief User-defined tag for categorization */
     std::string tag;
 
+    /** @brief Number of prefetches issued on this (managed) allocation */
+    std::atomic<size_t> prefetch_count{0};
+
+    /** @brief Bytes covered by those prefetches */
+    std::atomic<size_t> prefetched_bytes{0};
+
+    /** @brief Destination of the last prefetch (memory_allocator::host_device_id = host) */
+    int last_prefetch_device = memory_allocator::host_device_id;
+
+    /** @brief Whether the allocation is advised read-mostly */
+    bool read_mostly = false;
+
+    /** @brief Advised preferred location, if any (memory_allocator::host_device_id = host) */
+    std::optional<int> preferred_location;
+
     /**
      * @brief Get allocation lifetime in milliseconds
      * @return Lifetime in milliseconds (0 if still active)
@@ -136,6 +153,15 @@ struct QUARISMA_VISIBILITY leak_detection_config
 
     /** @brief Enable automatic leak reporting */
     bool enable_auto_reporting = true;
+
+    /**
+     * @brief Log record_access() calls instead of applying them under the tracker lock
+     *
+     * Each thread appends the pointer and time to a buffer of its own, which
+     * the periodic scan, flush_access_log() and the queries apply in batches.
+     * A thread whose buffer is full applies every buffer itself.
+     */
+    bool log_accesses = false;
 };
 
 /**
@@ -238,6 +264,34 @@ public:
      */
     QUARISMA_API virtual void record_access(void* ptr) = 0;
 
+    /**
+     * @brief Apply the accesses logged by every thread (leak_detection_config::log_accesses)
+     *
+     * Accesses logged after an allocation was freed are dropped.
+     */
+    QUARISMA_API virtual void flush_access_log() = 0;
+
+    /**
+     * @brief Record a prefetch of managed memory
+     * @param ptr Start of the prefetched range, anywhere within a tracked allocation
+     * @param size Size of the prefetched range in bytes
+     * @param device_index Destination device (memory_allocator::host_device_id = host)
+     */
+    QUARISMA_API virtual void record_prefetch(const void* ptr, size_t size, int device_index) = 0;
+
+    /**
+     * @brief Record a usage hint applied to managed memory
+     * @param ptr Start of the advised range, anywhere within a tracked allocation
+     * @param size Size of the advised range in bytes
+     * @param advice Hint that was applied
+     * @param device_index Device the hint refers to (memory_allocator::host_device_id = host)
+     */
+    QUARISMA_API virtual void record_advice(
+        const void*                             ptr,
+        size_t                                  size,
+        memory_allocator::managed_memory_advice advice,
+        int                                     device_index) = 0;
+
     /**
      * @brief Get information about a specific allocation
      * @param ptr Pointer to query
@@ -0,0 +1,113 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include "common/macros.h"
+
+#if QUARISMA_HAS_COROUTINES
+
+#include <coroutine>
+
+#include "memory/gpu/gpu_memory_transfer.h"
+#include "parallel/async_task.h"
+
+namespace quarisma
+{
+namespace gpu
+{
+
+/**
+ * @brief Awaitable asynchronous memory transfer
+ *
+ * Starts gpu_memory_transfer::transfer_async() when awaited and resumes the
+ * coroutine on a parallel_thread_pool worker from the completion callback,
+ * instead of parking a thread on the returned std::future. `co_await` yields
+ * the gpu_transfer_info; a failed transfer is reported through its status.
+ *
+ * @example
+ * ```cpp
+ * quarisma::task<double> upload(const void* host, void* device, size_t size)
+ * {
+ *     auto info = co_await gpu::async_transfer(
+ *         host, device, size, transfer_direction::HOST_TO_DEVICE);
+ *     co_return info.bandwidth_gbps;
+ * }
+ * ```
+ */
+class transfer_awaiter
+{
+public:
+    transfer_awaiter(
+        const void*        src,
+        void*              dst,
+        size_t             size,
+        transfer_direction direction,
+        gpu_stream*        stream)
+        : src_(src), dst_(dst), size_(size), direction_(direction), stream_(stream)
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    // The coroutine may resume, and destroy this awaiter, before transfer_async()
+    // returns: nothing is touched after the call.
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+        gpu_memory_transfer::instance().transfer_async(
+            src_,
+            dst_,
+            size_,
+            direction_,
+            stream_,
+            [this, awaiting](const gpu_transfer_info& info)
+            {
+                info_ = info;
+                quarisma::resume_on_pool(awaiting);
+            });
+    }
+
+    gpu_transfer_info await_resume() { return std::move(info_); }
+
+private:
+    const void*        src_;
+    void*              dst_;
+    size_t             size_;
+    transfer_direction direction_;
+    gpu_stream*        stream_;
+    gpu_transfer_info  info_;
+};
+
+/**
+ * @brief `co_await async_transfer(...)`: coroutine version of transfer_async()
+ */
+inline transfer_awaiter async_transfer(
+    const void*        src,
+    void*              dst,
+    size_t             size,
+    transfer_direction direction,
+    gpu_stream*        stream = nullptr)
+{
+    return transfer_awaiter(src, dst, size, direction, stream);
+}
+
+}  // namespace gpu
+}  // namespace quarisma
+
+#endif  // QUARISMA_HAS_COROUTINES
@@ -0,0 +1,244 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/helper/allocation_profile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "logging/logger.h"
+#include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_pool.h"
+#include "memory/cpu/allocator.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+constexpr const char* kProfileHeader = "# quarisma allocation profile v1";
+
+size_t next_power_of_two(size_t bytes) noexcept
+{
+    size_t power = 1;
+    while (power < bytes && power != 0)
+    {
+        power <<= 1;
+    }
+    return power == 0 ? bytes : power;
+}
+
+// Allocates and frees count blocks of bytes, stopping at the first failure.
+size_t allocate_and_free(Allocator& allocator, size_t alignment, size_t bytes, size_t count)
+{
+    std::vector<void*> blocks;
+    blocks.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        void* ptr = allocator.allocate_raw(alignment, bytes);
+        if (ptr == nullptr)
+        {
+            break;
+        }
+        blocks.push_back(ptr);
+    }
+    for (void* ptr : blocks)
+    {
+        allocator.deallocate_raw(ptr);
+    }
+    return blocks.size() * bytes;
+}
+}  // namespace
+
+allocation_profile allocation_profile::from_stats(const unified_resource_stats& stats)
+{
+    allocation_profile profile;
+    profile.peak_bytes_in_use =
+        static_cast<size_t>(std::max<int64_t>(0, stats.peak_bytes_in_use.load()));
+    return profile;
+}
+
+void allocation_profile::save(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    QUARISMA_CHECK(out.good(), "Cannot write allocation profile {}", path);
+
+    out << kProfileHeader << '\n';
+    out << "peak_bytes_in_use " << peak_bytes_in_use << '\n';
+    for (const auto& c : classes)
+    {
+        out << "size " << c.bytes << ' ' << c.peak_count << '\n';
+    }
+    out.flush();
+    QUARISMA_CHECK(out.good(), "Cannot write allocation profile {}", path);
+}
+
+std::optional<allocation_profile> allocation_profile::load(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        return std::nullopt;
+    }
+
+    std::string line;
+    QUARISMA_CHECK(
+        std::getline(in, line) && line == kProfileHeader, "{} is not an allocation profile", path);
+
+    allocation_profile profile;
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string        key;
+        fields >> key;
+        if (key == "peak_bytes_in_use")
+        {
+            fields >> profile.peak_bytes_in_use;
+        }
+        else if (key == "size")
+        {
+            size_class c;
+            fields >> c.bytes >> c.peak_count;
+            QUARISMA_CHECK(c.bytes > 0, "Empty size class in allocation profile {}", path);
+            profile.classes.push_back(c);
+        }
+        QUARISMA_CHECK(!fields.fail(), "Malformed line in allocation profile {}: {}", path, line);
+    }
+
+    std::sort(
+        profile.classes.begin(),
+        profile.classes.end(),
+        [](const size_class& a, const size_class& b) { return a.bytes < b.bytes; });
+    return profile;
+}
+
+size_t allocation_profile::class_bytes() const noexcept
+{
+    size_t total = 0;
+    for (const auto& c : classes)
+    {
+        total += c.bytes * c.peak_count;
+    }
+    return total;
+}
+
+size_t allocation_profile_recorder::key_of(size_t bytes) const noexcept
+{
+    if (sizes_.size() < kMaxSizes || sizes_.find(bytes) != sizes_.end())
+    {
+        return bytes;
+    }
+    return next_power_of_two(bytes);
+}
+
+void allocation_profile_recorder::on_allocate(size_t bytes)
+{
+    auto& c = sizes_[key_of(bytes)];
+    c.peak  = std::max(c.peak, ++c.live);
+
+    bytes_in_use_ += bytes;
+    peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+}
+
+void allocation_profile_recorder::on_deallocate(size_t bytes) noexcept
+{
+    auto it = sizes_.find(bytes);
+    if (it == sizes_.end())
+    {
+        it = sizes_.find(next_power_of_two(bytes));
+    }
+    if (it != sizes_.end() && it->second.live > 0)
+    {
+        --it->second.live;
+    }
+    bytes_in_use_ -= std::min(bytes_in_use_, bytes);
+}
+
+allocation_profile allocation_profile_recorder::profile() const
+{
+    allocation_profile profile;
+    profile.peak_bytes_in_use = peak_bytes_in_use_;
+    profile.classes.reserve(sizes_.size());
+    for (const auto& [bytes, c] : sizes_)
+    {
+        profile.classes.push_back({bytes, c.peak});
+    }
+    std::sort(
+        profile.classes.begin(),
+        profile.classes.end(),
+        [](const auto& a, const auto& b) { return a.bytes < b.bytes; });
+    return profile;
+}
+
+void allocation_profile_recorder::reset() noexcept
+{
+    // Live allocations stay counted, so that their frees balance
+    for (auto& [bytes, c] : sizes_)
+    {
+        c.peak = c.live;
+    }
+    peak_bytes_in_use_ = bytes_in_use_;
+}
+
+size_t warm_up_allocator(
+    Allocator&                        allocator,
+    const allocation_profile&         profile,
+    const allocation_warm_up_options& options)
+{
+    size_t warmed = 0;
+
+    if (dynamic_cast<allocator_bfc*>(&allocator) != nullptr)
+    {
+        // The class peaks need not coincide, so their sum overestimates
+        size_t const peak =
+            profile.peak_bytes_in_use > 0 ? profile.peak_bytes_in_use : profile.class_bytes();
+        size_t const bytes = std::min(options.max_bytes, peak);
+        if (bytes > 0)
+        {
+            warmed = allocate_and_free(allocator, options.alignment, bytes, 1);
+        }
+    }
+    else
+    {
+        auto const* pool    = dynamic_cast<allocator_pool*>(&allocator);
+        size_t      entries = pool != nullptr ? pool->size_limit() : SIZE_MAX;
+
+        for (const auto& c : profile.classes)
+        {
+            size_t const count =
+                std::min({c.peak_count, (options.max_bytes - warmed) / c.bytes, entries});
+            if (count == 0)
+            {
+                continue;
+            }
+            warmed += allocate_and_free(allocator, options.alignment, c.bytes, count);
+            entries -= count;
+        }
+    }
+
+    QUARISMA_LOG_INFO("Warmed up allocator {} with {} bytes", allocator.Name(), warmed);
+    return warmed;
+}
+
+}  // namespace quarisma
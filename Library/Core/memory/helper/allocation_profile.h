@@ -0,0 +1,164 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "memory/unified_memory_stats.h"
+#include "util/flat_hash.h"
+
+namespace quarisma
+{
+class Allocator;
+
+/**
+ * @brief Steady-state allocation sizes of a process, to warm allocators up with
+ *
+ * A cold process pays for every first sub_allocator::Alloc() and every BFC
+ * region extension during its first requests. A profile recorded once the
+ * process has settled (allocator_tracking::GetAllocationProfile(), or
+ * from_stats() for any allocator with statistics) is saved with the
+ * deployment and replayed by warm_up_allocator() at the next startup, so that
+ * those requests find their memory already reserved.
+ *
+ * Example:
+ * ```cpp
+ * // After the service reached steady state
+ * tracker->GetAllocationProfile().save("/var/lib/app/alloc.profile");
+ *
+ * // At the next startup, before taking traffic
+ * if (auto profile = allocation_profile::load("/var/lib/app/alloc.profile"))
+ * {
+ *     warm_up_allocator(*allocator, *profile, {.max_bytes = 512 << 20});
+ * }
+ * ```
+ */
+struct QUARISMA_VISIBILITY allocation_profile
+{
+    /**
+     * @brief An allocation size and the most allocations of it live at once
+     */
+    struct size_class
+    {
+        size_t bytes      = 0;
+        size_t peak_count = 0;
+    };
+
+    std::vector<size_class> classes;  ///< Sorted by bytes
+    size_t peak_bytes_in_use = 0;     ///< Peak of all the classes together
+
+    /**
+     * @brief Profile of an allocator that only reports statistics
+     *
+     * Holds the peak bytes in use and no classes, which is what
+     * warm_up_allocator() needs to reserve BFC regions.
+     */
+    QUARISMA_API static allocation_profile from_stats(const unified_resource_stats& stats);
+
+    /**
+     * @brief Write the profile as text, one size class per line
+     * @throws quarisma::exception if the file cannot be written
+     */
+    QUARISMA_API void save(const std::string& path) const;
+
+    /**
+     * @brief Read a profile written by save()
+     * @return The profile, or nullopt if there is no file at path
+     * @throws quarisma::exception if the file is not a profile
+     */
+    QUARISMA_API static std::optional<allocation_profile> load(const std::string& path);
+
+    /**
+     * @brief Sum of bytes * peak_count over the classes
+     */
+    QUARISMA_API size_t class_bytes() const noexcept;
+};
+
+/**
+ * @brief Live and peak allocation counts per allocation size
+ *
+ * Not synchronized: owners update it under the lock that already guards
+ * their accounting, as allocator_tracking does. Once kMaxSizes distinct
+ * sizes are seen, further sizes are counted under their next power of two.
+ */
+class QUARISMA_VISIBILITY allocation_profile_recorder
+{
+public:
+    static constexpr size_t kMaxSizes = 1024;
+
+    QUARISMA_API void on_allocate(size_t bytes);
+    QUARISMA_API void on_deallocate(size_t bytes) noexcept;
+
+    QUARISMA_API allocation_profile profile() const;
+
+    QUARISMA_API void reset() noexcept;
+
+private:
+    struct counts
+    {
+        size_t live = 0;
+        size_t peak = 0;
+    };
+
+    size_t key_of(size_t bytes) const noexcept;
+
+    flat_hash_map<size_t, counts> sizes_;
+    size_t                        bytes_in_use_      = 0;
+    size_t                        peak_bytes_in_use_ = 0;
+};
+
+/**
+ * @brief Bounds of warm_up_allocator() and cuda_caching_allocator::warm_up()
+ */
+struct allocation_warm_up_options
+{
+    /** @brief Most bytes reserved, whatever the profile says */
+    size_t max_bytes = size_t{1} << 30;
+
+    /** @brief Alignment of the warm-up allocations, that of the requests to be served */
+    size_t alignment = 64;
+};
+
+/**
+ * @brief Reserve in an allocator the memory that a profile says it will need
+ *
+ * - allocator_bfc: one allocation of peak_bytes_in_use (capped), freed at
+ *   once, extends the regions in a single step; they stay reserved unless
+ *   garbage collection or background compaction releases them.
+ * - allocator_pool: peak_count allocations of each class, smallest first and
+ *   up to the pool size limit, are freed into the pool.
+ * - any other allocator: the allocations of each class are made and freed,
+ *   which fills whatever caches it has.
+ *
+ * Warm-up allocations show in the allocator statistics.
+ *
+ * @return Bytes allocated and freed again
+ */
+QUARISMA_API size_t warm_up_allocator(
+    Allocator&                        allocator,
+    const allocation_profile&         profile,
+    const allocation_warm_up_options& options = {});
+
+}  // namespace quarisma
@@ -547,6 +547,185 @@ void free(
 #endif
 }
 
+void* allocate_managed(std::size_t nbytes, int device_id)
+{
+    QUARISMA_CHECK(
+        static_cast<std::ptrdiff_t>(nbytes) > 0,
+        "gpu allocate_managed() called with negative or zero size: {}",
+        nbytes);
+
+    if (!set_device(device_id))
+    {
+        return nullptr;
+    }
+
+    void* ptr = nullptr;  //NOLINT
+
+#if QUARISMA_HAS_CUDA
+    cudaError_t const result = cudaMallocManaged(&ptr, nbytes, cudaMemAttachGlobal);
+    if (result != cudaSuccess)
+    {
+        QUARISMA_LOG_WARNING(
+            "GPU managed allocation failed for {} bytes on device {}: {}",
+            nbytes,
+            device_id,
+            cudaGetErrorString(result));
+        return nullptr;
+    }
+#elif QUARISMA_HAS_HIP
+    hipError_t const result = hipMallocManaged(&ptr, nbytes, hipMemAttachGlobal);
+    if (result != hipSuccess)
+    {
+        QUARISMA_LOG_WARNING(
+            "HIP managed allocation failed for {} bytes on device {}: {}",
+            nbytes,
+            device_id,
+            hipGetErrorString(result));
+        return nullptr;
+    }
+#else
+    QUARISMA_LOG_ERROR("GPU support not enabled in this build");
+#endif
+
+    return ptr;
+}
+
+void free_managed(void* ptr, int device_id) noexcept
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    set_device(device_id);
+
+#if QUARISMA_HAS_CUDA
+    cudaError_t const result = cudaFree(ptr);
+    if (result != cudaSuccess)
+    {
+        QUARISMA_LOG_ERROR(
+            "GPU managed deallocation failed at {} on device {}: {}",
+            ptr,
+            device_id,
+            cudaGetErrorString(result));
+    }
+#elif QUARISMA_HAS_HIP
+    hipError_t const result = hipFree(ptr);
+    if (result != hipSuccess)
+    {
+        QUARISMA_LOG_ERROR(
+            "HIP managed deallocation failed at {} on device {}: {}",
+            ptr,
+            device_id,
+            hipGetErrorString(result));
+    }
+#endif
+}
+
+#if QUARISMA_HAS_CUDA && CUDART_VERSION >= 13000
+namespace
+{
+// CUDA 13 takes memory locations instead of device ordinals
+cudaMemLocation to_mem_location(int device_id) noexcept
+{
+    cudaMemLocation location{};
+    location.type = device_id == host_device_id ? cudaMemLocationTypeHost
+                                                : cudaMemLocationTypeDevice;
+    location.id   = device_id == host_device_id ? 0 : device_id;
+    return location;
+}
+}  // namespace
+#endif
+
+bool prefetch(
+    QUARISMA_UNUSED const void* ptr,
+    QUARISMA_UNUSED std::size_t nbytes,
+    QUARISMA_UNUSED int         device_id,
+    QUARISMA_UNUSED void*       stream) noexcept
+{
+#if QUARISMA_HAS_CUDA
+    auto* cuda_stream = static_cast<cudaStream_t>(stream);
+#if CUDART_VERSION >= 13000
+    CUDA_CHECK_RETURN_FALSE(
+        cudaMemPrefetchAsync(ptr, nbytes, to_mem_location(device_id), 0, cuda_stream));
+#else
+    CUDA_CHECK_RETURN_FALSE(cudaMemPrefetchAsync(ptr, nbytes, device_id, cuda_stream));
+#endif
+    return true;
+#elif QUARISMA_HAS_HIP
+    HIP_CHECK_RETURN_FALSE(
+        hipMemPrefetchAsync(ptr, nbytes, device_id, static_cast<hipStream_t>(stream)));
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool advise(
+    QUARISMA_UNUSED const void*           ptr,
+    QUARISMA_UNUSED std::size_t           nbytes,
+    QUARISMA_UNUSED managed_memory_advice advice,
+    QUARISMA_UNUSED int                   device_id) noexcept
+{
+#if QUARISMA_HAS_CUDA
+    cudaMemoryAdvise cuda_advice = cudaMemAdviseSetReadMostly;
+    switch (advice)
+    {
+    case managed_memory_advice::SET_READ_MOSTLY:
+        cuda_advice = cudaMemAdviseSetReadMostly;
+        break;
+    case managed_memory_advice::UNSET_READ_MOSTLY:
+        cuda_advice = cudaMemAdviseUnsetReadMostly;
+        break;
+    case managed_memory_advice::SET_PREFERRED_LOCATION:
+        cuda_advice = cudaMemAdviseSetPreferredLocation;
+        break;
+    case managed_memory_advice::UNSET_PREFERRED_LOCATION:
+        cuda_advice = cudaMemAdviseUnsetPreferredLocation;
+        break;
+    case managed_memory_advice::SET_ACCESSED_BY:
+        cuda_advice = cudaMemAdviseSetAccessedBy;
+        break;
+    case managed_memory_advice::UNSET_ACCESSED_BY:
+        cuda_advice = cudaMemAdviseUnsetAccessedBy;
+        break;
+    }
+#if CUDART_VERSION >= 13000
+    CUDA_CHECK_RETURN_FALSE(cudaMemAdvise(ptr, nbytes, cuda_advice, to_mem_location(device_id)));
+#else
+    CUDA_CHECK_RETURN_FALSE(cudaMemAdvise(ptr, nbytes, cuda_advice, device_id));
+#endif
+    return true;
+#elif QUARISMA_HAS_HIP
+    hipMemoryAdvise hip_advice = hipMemAdviseSetReadMostly;
+    switch (advice)
+    {
+    case managed_memory_advice::SET_READ_MOSTLY:
+        hip_advice = hipMemAdviseSetReadMostly;
+        break;
+    case managed_memory_advice::UNSET_READ_MOSTLY:
+        hip_advice = hipMemAdviseUnsetReadMostly;
+        break;
+    case managed_memory_advice::SET_PREFERRED_LOCATION:
+        hip_advice = hipMemAdviseSetPreferredLocation;
+        break;
+    case managed_memory_advice::UNSET_PREFERRED_LOCATION:
+        hip_advice = hipMemAdviseUnsetPreferredLocation;
+        break;
+    case managed_memory_advice::SET_ACCESSED_BY:
+        hip_advice = hipMemAdviseSetAccessedBy;
+        break;
+    case managed_memory_advice::UNSET_ACCESSED_BY:
+        hip_advice = hipMemAdviseUnsetAccessedBy;
+        break;
+    }
+    HIP_CHECK_RETURN_FALSE(hipMemAdvise(ptr, nbytes, hip_advice, device_id));
+    return true;
+#else
+    return false;
+#endif
+}
+
 bool set_device(int device_id) noexcept
 {
 #if QUARISMA_HAS_CUDA
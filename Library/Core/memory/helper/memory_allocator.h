@@ -163,6 +163,70 @@ QUARISMA_API void* allocate(
 QUARISMA_API void free(
     void* ptr, std::size_t nbytes = 0, int device_id = 0, void* stream = nullptr) noexcept;
 
+/**
+ * @brief Device ID that designates host memory as a prefetch target or advice location.
+ *
+ * Matches cudaCpuDeviceId and hipCpuDeviceId.
+ */
+inline constexpr int host_device_id = -1;
+
+/**
+ * @brief Usage hints for managed (unified) memory, mapped to cudaMemAdvise/hipMemAdvise.
+ */
+enum class managed_memory_advice : uint8_t
+{
+    SET_READ_MOSTLY,           ///< Replicate read-only pages on each accessing processor
+    UNSET_READ_MOSTLY,         ///< Undo SET_READ_MOSTLY
+    SET_PREFERRED_LOCATION,    ///< Keep pages resident on the given device when possible
+    UNSET_PREFERRED_LOCATION,  ///< Undo SET_PREFERRED_LOCATION
+    SET_ACCESSED_BY,           ///< Keep pages mapped for the given device to avoid faults
+    UNSET_ACCESSED_BY          ///< Undo SET_ACCESSED_BY
+};
+
+/**
+ * @brief Allocates managed (unified) memory accessible from the host and all devices.
+ *
+ * Managed allocations may exceed device memory; pages migrate on demand or
+ * through prefetch().
+ *
+ * @param nbytes Size of memory block to allocate in bytes
+ * @param device_id GPU device ID whose context the allocation is made in
+ * @return Pointer to managed memory, or nullptr on failure
+ */
+QUARISMA_API void* allocate_managed(std::size_t nbytes, int device_id);
+
+/**
+ * @brief Deallocates memory from allocate_managed().
+ *
+ * @param ptr Pointer to managed memory to deallocate
+ * @param device_id GPU device ID the memory was allocated with
+ */
+QUARISMA_API void free_managed(void* ptr, int device_id = 0) noexcept;
+
+/**
+ * @brief Migrates a range of managed memory to a device or the host, ordered on a stream.
+ *
+ * @param ptr Start of the range (within a managed allocation)
+ * @param nbytes Size of the range in bytes
+ * @param device_id Destination device, or host_device_id for host memory
+ * @param stream GPU stream to order the migration on (nullptr = default stream)
+ * @return true if the prefetch was enqueued
+ */
+QUARISMA_API bool prefetch(
+    const void* ptr, std::size_t nbytes, int device_id, void* stream = nullptr) noexcept;
+
+/**
+ * @brief Applies a usage hint to a range of managed memory.
+ *
+ * @param ptr Start of the range (within a managed allocation)
+ * @param nbytes Size of the range in bytes
+ * @param advice Hint to apply
+ * @param device_id Device the hint refers to, or host_device_id (ignored for read-mostly)
+ * @return true if the hint was applied
+ */
+QUARISMA_API bool advise(
+    const void* ptr, std::size_t nbytes, managed_memory_advice advice, int device_id) noexcept;
+
 /**
  * @brief Sets the GPU device context for subsequent operations.
  *
@@ -0,0 +1,376 @@
+#include "memory/helper/memory_pressure.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "logging/logger.h"
+#include "memory/helper/memory_info.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+
+// Set while this thread runs relieve(), so that allocations made by a trim
+// callback do not re-enter it
+thread_local bool relieving = false;
+
+#if defined(__linux__)
+/**
+ * @brief Read a cgroup counter; nullopt if the file is missing or reads "max"
+ */
+std::optional<int64_t> read_cgroup_value(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string   value;
+    if (!(file >> value) || value == "max")
+    {
+        return std::nullopt;
+    }
+    try
+    {
+        return static_cast<int64_t>(std::stoull(value));
+    }
+    catch (const std::exception&)
+    {
+        return std::nullopt;
+    }
+}
+
+/**
+ * @brief Read one field of a cgroup memory.stat file; 0 if absent
+ */
+int64_t read_cgroup_stat(const std::string& path, const std::string& key)
+{
+    std::ifstream file(path);
+    std::string   name;
+    int64_t       value = 0;
+    while (file >> name >> value)
+    {
+        if (name == key)
+        {
+            return value;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Directory of this process's cgroup v2, from /proc/self/cgroup
+ */
+std::string cgroup_v2_directory()
+{
+    std::ifstream file("/proc/self/cgroup");
+    std::string   line;
+    while (std::getline(file, line))
+    {
+        if (line.rfind("0::", 0) == 0)
+        {
+            std::string const path = "/sys/fs/cgroup" + line.substr(3);
+            if (std::ifstream(path + "/memory.max").good())
+            {
+                return path;
+            }
+        }
+    }
+    return "/sys/fs/cgroup";
+}
+
+/**
+ * @brief Bytes left under the cgroup memory limit, nullopt if there is no limit
+ *
+ * Inactive file pages are not counted as used: the kernel reclaims them
+ * before it invokes the OOM killer.
+ */
+std::optional<int64_t> cgroup_available_memory()
+{
+    static const std::string v2 = cgroup_v2_directory();
+
+    std::optional<int64_t> limit = read_cgroup_value(v2 + "/memory.max");
+    std::optional<int64_t> usage;
+    int64_t                reclaimable = 0;
+    if (limit.has_value())
+    {
+        usage       = read_cgroup_value(v2 + "/memory.current");
+        reclaimable = read_cgroup_stat(v2 + "/memory.stat", "inactive_file");
+    }
+    else
+    {
+        const std::string v1 = "/sys/fs/cgroup/memory";
+        limit                = read_cgroup_value(v1 + "/memory.limit_in_bytes");
+        usage                = read_cgroup_value(v1 + "/memory.usage_in_bytes");
+        reclaimable          = read_cgroup_stat(v1 + "/memory.stat", "total_inactive_file");
+    }
+
+    if (!limit.has_value() || !usage.has_value())
+    {
+        return std::nullopt;
+    }
+    const int64_t used = std::max<int64_t>(*usage - reclaimable, 0);
+    return std::max<int64_t>(*limit - used, 0);
+}
+#else
+std::optional<int64_t> cgroup_available_memory()
+{
+    return std::nullopt;
+}
+#endif
+
+}  // namespace
+
+struct memory_pressure::Impl
+{
+    struct cache_entry
+    {
+        cache_id         id;
+        std::string      name;
+        memory_trim_cost cost;
+        device_enum      device_type;
+        int              device_index;
+        trim_function    trim;
+    };
+
+    ~Impl() { stop_monitor(); }
+
+    cache_id register_cache(
+        std::string      name,
+        memory_trim_cost cost,
+        device_enum      device_type,
+        int              device_index,
+        trim_function    trim)
+    {
+        std::scoped_lock const lock(mutex_);
+        const cache_id         id = next_id_++;
+
+        // Keep the entries sorted by cost, in registration order within a cost
+        auto it = std::upper_bound(
+            caches_.begin(),
+            caches_.end(),
+            cost,
+            [](memory_trim_cost c, const cache_entry& entry) { return c < entry.cost; });
+        caches_.insert(
+            it, cache_entry{id, std::move(name), cost, device_type, device_index, std::move(trim)});
+        return id;
+    }
+
+    void unregister_cache(cache_id id)
+    {
+        std::scoped_lock const lock(mutex_);
+        caches_.erase(
+            std::remove_if(
+                caches_.begin(),
+                caches_.end(),
+                [id](const cache_entry& entry) { return entry.id == id; }),
+            caches_.end());
+    }
+
+    size_t relieve(device_enum device_type, int device_index, size_t bytes_wanted, cache_id exclude)
+    {
+        if (relieving)
+        {
+            return 0;
+        }
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            return 0;
+        }
+        relieving = true;
+        ++stats_.relief_requests;
+
+        size_t released = 0;
+        for (const auto& entry : caches_)
+        {
+            if (released >= bytes_wanted)
+            {
+                break;
+            }
+            if (entry.id == exclude || entry.device_type != device_type ||
+                (device_index >= 0 && entry.device_index >= 0 &&
+                 entry.device_index != device_index))
+            {
+                continue;
+            }
+
+            size_t freed = 0;
+            try
+            {
+                freed = entry.trim(bytes_wanted - released);
+            }
+            catch (const std::exception& e)
+            {
+                QUARISMA_LOG_WARNING("Trimming cache '{}' failed: {}", entry.name, e.what());
+            }
+            ++stats_.caches_trimmed;
+            stats_.bytes_released += freed;
+            released += freed;
+        }
+        relieving = false;
+
+        if (released > 0)
+        {
+            QUARISMA_LOG_INFO(
+                "Memory pressure: released {} of {} bytes wanted from cached memory",
+                released,
+                bytes_wanted);
+        }
+        return released;
+    }
+
+    void start_monitor(const monitor_options& options)
+    {
+        stop_monitor();
+
+        std::scoped_lock const lock(monitor_mutex_);
+        stop_requested_ = false;
+        monitor_        = std::thread([this, options]() { monitor_loop(options); });
+    }
+
+    void stop_monitor()
+    {
+        std::thread monitor;
+        {
+            std::scoped_lock const lock(monitor_mutex_);
+            stop_requested_ = true;
+            monitor         = std::move(monitor_);
+        }
+        monitor_cv_.notify_all();
+        if (monitor.joinable())
+        {
+            monitor.join();
+        }
+    }
+
+    bool is_monitoring() const
+    {
+        std::scoped_lock const lock(monitor_mutex_);
+        return monitor_.joinable();
+    }
+
+    memory_pressure_stats stats() const
+    {
+        std::scoped_lock const lock(mutex_);
+        return stats_;
+    }
+
+private:
+    void monitor_loop(const monitor_options& options)
+    {
+        std::unique_lock<std::mutex> lock(monitor_mutex_);
+        while (!monitor_cv_.wait_for(
+            lock, options.poll_interval, [this]() { return stop_requested_; }))
+        {
+            lock.unlock();
+            const int64_t available = available_host_memory();
+            if (available < options.low_watermark_bytes)
+            {
+                {
+                    std::scoped_lock const stats_lock(mutex_);
+                    ++stats_.monitor_wakeups;
+                }
+                relieve(
+                    device_enum::CPU,
+                    -1,
+                    static_cast<size_t>(options.low_watermark_bytes - available),
+                    0);
+            }
+            lock.lock();
+        }
+    }
+
+    mutable std::mutex       mutex_;
+    std::vector<cache_entry> caches_;
+    cache_id                 next_id_ = 1;
+    memory_pressure_stats    stats_;
+
+    mutable std::mutex      monitor_mutex_;
+    std::condition_variable monitor_cv_;
+    std::thread             monitor_;
+    bool                    stop_requested_ = false;
+};
+
+memory_pressure::memory_pressure() : impl_(std::make_unique<Impl>()) {}
+
+memory_pressure::~memory_pressure() = default;
+
+memory_pressure& memory_pressure::instance()
+{
+    // Never destroyed: allocators with static storage unregister during exit
+    static memory_pressure* const instance = new memory_pressure();
+    return *instance;
+}
+
+memory_pressure::cache_id memory_pressure::register_cache(
+    std::string      name,
+    memory_trim_cost cost,
+    device_enum      device_type,
+    int              device_index,
+    trim_function    trim)
+{
+    QUARISMA_CHECK(trim != nullptr, "memory_pressure: trim callback of '", name, "' is empty");
+    return impl_->register_cache(
+        std::move(name), cost, device_type, device_index, std::move(trim));
+}
+
+void memory_pressure::unregister_cache(cache_id id)
+{
+    impl_->unregister_cache(id);
+}
+
+size_t memory_pressure::relieve(
+    device_enum device_type, int device_index, size_t bytes_wanted, cache_id exclude)
+{
+    //cppcheck-suppress syntaxError
+    if QUARISMA_UNLIKELY (bytes_wanted == 0)
+    {
+        return 0;
+    }
+    return impl_->relieve(device_type, device_index, bytes_wanted, exclude);
+}
+
+int64_t memory_pressure::available_host_memory()
+{
+    int64_t                      available = port::GetMemoryInfo().free;
+    const std::optional<int64_t> cgroup    = cgroup_available_memory();
+    if (cgroup.has_value())
+    {
+        available = std::min(available, *cgroup);
+    }
+    return available;
+}
+
+void memory_pressure::start_monitor(const monitor_options& options)
+{
+    QUARISMA_CHECK(
+        options.poll_interval.count() > 0, "memory_pressure: poll interval must be positive");
+    impl_->start_monitor(options);
+}
+
+void memory_pressure::stop_monitor()
+{
+    impl_->stop_monitor();
+}
+
+bool memory_pressure::is_monitoring() const
+{
+    return impl_->is_monitoring();
+}
+
+memory_pressure_stats memory_pressure::stats() const
+{
+    return impl_->stats();
+}
+
+}  // namespace quarisma
@@ -0,0 +1,193 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "common/macros.h"
+#include "memory/device.h"
+
+namespace quarisma
+{
+/**
+ * @brief How expensive it is to rebuild a cache after it has been trimmed.
+ *
+ * Caches are trimmed in this order, so the ones that are cheapest to refill
+ * give their memory back first.
+ */
+enum class memory_trim_cost : uint8_t
+{
+    LOW,     ///< Host free lists, refilled by plain malloc()
+    MEDIUM,  ///< Whole regions or device pools, refilled by large system allocations
+    HIGH     ///< Driver-level caches whose refill synchronizes the device
+};
+
+/**
+ * @brief Counters of the memory-pressure subsystem.
+ */
+struct memory_pressure_stats
+{
+    size_t relief_requests = 0;  ///< Calls to relieve(), from allocators or the monitor
+    size_t caches_trimmed  = 0;  ///< Trim callbacks run
+    size_t bytes_released  = 0;  ///< Bytes the trim callbacks reported as released
+    size_t monitor_wakeups = 0;  ///< Times the monitor found the host below the watermark
+};
+
+/**
+ * @brief Process-wide registry of caches that can give memory back on demand
+ *
+ * Allocators that keep freed memory around (allocator_pool free lists,
+ * allocator_bfc regions, gpu_memory_pool size classes, cuda_caching_allocator
+ * segments, cuda_async_allocator pools) register a trim callback here. When an
+ * allocation is about to fail, the allocator calls relieve() before retrying
+ * or sleeping; the registered caches of the same device are then trimmed from
+ * the cheapest to the most expensive to rebuild until enough bytes came back.
+ *
+ * An optional monitor thread polls the host memory still available to the
+ * process -- the smaller of the system's free memory and the cgroup limit
+ * minus its usage -- and trims the host caches whenever it drops below a low
+ * watermark, so that idle caches are returned before the kernel OOM-kills the
+ * process.
+ *
+ * Only one relieve() runs at a time. A concurrent call, or a call made from a
+ * trim callback, returns 0 right away instead of waiting: callers hold their
+ * own allocator lock, and waiting on another thread that is trimming that
+ * allocator would deadlock.
+ *
+ * Example:
+ * ```cpp
+ * auto& pressure = memory_pressure::instance();
+ * auto  id       = pressure.register_cache(
+ *     "my_cache", memory_trim_cost::LOW, device_enum::CPU, -1,
+ *     [&](size_t bytes_wanted) { return cache.release(bytes_wanted); });
+ * ...
+ * pressure.unregister_cache(id);
+ * ```
+ */
+class QUARISMA_VISIBILITY memory_pressure
+{
+public:
+    /**
+     * @brief Releases cached memory; gets the bytes wanted, returns the bytes released
+     *
+     * The callback may release more or less than asked for. It runs under the
+     * registry lock, so it must not call register_cache() or unregister_cache().
+     */
+    using trim_function = std::function<size_t(size_t bytes_wanted)>;
+
+    using cache_id = uint64_t;
+
+    /**
+     * @brief Configuration of the host memory monitor.
+     */
+    struct monitor_options
+    {
+        /** Trim host caches while less than this many bytes are available. */
+        int64_t low_watermark_bytes = int64_t{512} << 20;
+
+        /** Time between two reads of the available memory. */
+        std::chrono::milliseconds poll_interval{250};
+    };
+
+    QUARISMA_API static memory_pressure& instance();
+
+    /**
+     * @brief Register a cache
+     * @param name Name used in log messages
+     * @param cost Rebuild cost; lower costs are trimmed first
+     * @param device_type Device whose memory the cache holds
+     * @param device_index Device index, or -1 if the cache spans all devices of the type
+     * @param trim Callback releasing cached memory
+     * @return Identifier to pass to unregister_cache()
+     */
+    QUARISMA_API cache_id register_cache(
+        std::string      name,
+        memory_trim_cost cost,
+        device_enum      device_type,
+        int              device_index,
+        trim_function    trim);
+
+    /**
+     * @brief Unregister a cache
+     *
+     * Waits for a relieve() in progress, so the callback is not running and
+     * will not run once this returns. Call it before tearing the cache down,
+     * without holding a lock the callback takes.
+     */
+    QUARISMA_API void unregister_cache(cache_id id);
+
+    /**
+     * @brief Trim registered caches until `bytes_wanted` bytes were released
+     * @param device_type Device that needs memory
+     * @param device_index Device index, or -1 for every device of the type
+     * @param bytes_wanted Bytes needed; caches are trimmed in cost order until reached
+     * @param exclude Cache not to trim, typically the caller's own (0 = none)
+     * @return Bytes released, or 0 if another relieve() is in progress
+     */
+    QUARISMA_API size_t relieve(
+        device_enum device_type, int device_index, size_t bytes_wanted, cache_id exclude = 0);
+
+    /**
+     * @brief Host memory still available to the process, in bytes
+     *
+     * The smaller of the system's free memory and, on Linux, the remaining
+     * room under the cgroup (v2 or v1) memory limit. INT64_MAX if neither is
+     * known.
+     */
+    QUARISMA_API static int64_t available_host_memory();
+
+    /**
+     * @brief Start the host memory monitor, restarting it with new options if running
+     */
+    QUARISMA_API void start_monitor(const monitor_options& options);
+
+    /**
+     * @brief Stop the host memory monitor
+     */
+    QUARISMA_API void stop_monitor();
+
+    /**
+     * @brief Check whether the host memory monitor is running
+     */
+    QUARISMA_API bool is_monitoring() const;
+
+    /**
+     * @brief Get the subsystem's counters
+     */
+    QUARISMA_API memory_pressure_stats stats() const;
+
+    QUARISMA_API ~memory_pressure();
+
+    memory_pressure(const memory_pressure&)            = delete;
+    memory_pressure& operator=(const memory_pressure&) = delete;
+
+private:
+    memory_pressure();
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace quarisma
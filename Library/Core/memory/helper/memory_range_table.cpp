@@ -0,0 +1,148 @@
+#include "memory/helper/memory_range_table.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+namespace quarisma
+{
+namespace
+{
+size_t reader_slot_index(size_t slots)
+{
+    thread_local size_t const index = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return index % slots;
+}
+}  // namespace
+
+memory_range_table& memory_range_table::instance()
+{
+    // Never destroyed: sub_allocators with static storage free their regions during exit
+    static memory_range_table* const instance = new memory_range_table();
+    return *instance;
+}
+
+memory_range_table::~memory_range_table()
+{
+    delete current_.load(std::memory_order_acquire);
+}
+
+void memory_range_table::insert(
+    const void* ptr, size_t num_bytes, allocator_memory_enum type, int index)
+{
+    if (ptr == nullptr || num_bytes == 0)
+    {
+        return;
+    }
+    range const added{
+        reinterpret_cast<std::uintptr_t>(ptr),
+        reinterpret_cast<std::uintptr_t>(ptr) + num_bytes,
+        type,
+        index};
+
+    std::scoped_lock const lock(mutex_);
+    const table*           current = current_.load(std::memory_order_relaxed);
+    auto                   next    = std::make_unique<table>();
+    next->reserve((current != nullptr ? current->size() : 0) + 1);
+    if (current != nullptr)
+    {
+        // A region freed without VisitFree() may still be listed
+        std::copy_if(
+            current->begin(),
+            current->end(),
+            std::back_inserter(*next),
+            [&added](const range& r) { return r.end <= added.begin || added.end <= r.begin; });
+    }
+    next->insert(
+        std::upper_bound(
+            next->begin(),
+            next->end(),
+            added.begin,
+            [](std::uintptr_t p, const range& r) { return p < r.begin; }),
+        added);
+    publish(std::move(next));
+}
+
+void memory_range_table::erase(const void* ptr)
+{
+    auto const begin = reinterpret_cast<std::uintptr_t>(ptr);
+
+    std::scoped_lock const lock(mutex_);
+    const table*           current = current_.load(std::memory_order_relaxed);
+    if (current == nullptr)
+    {
+        return;
+    }
+    auto const it = std::lower_bound(
+        current->begin(),
+        current->end(),
+        begin,
+        [](const range& r, std::uintptr_t p) { return r.begin < p; });
+    if (it == current->end() || it->begin != begin)
+    {
+        return;
+    }
+
+    auto next = std::make_unique<table>();
+    next->reserve(current->size() - 1);
+    next->insert(next->end(), current->begin(), it);
+    next->insert(next->end(), it + 1, current->end());
+    publish(std::move(next));
+}
+
+void memory_range_table::publish(std::unique_ptr<table> next)
+{
+    table* previous = current_.exchange(next.release(), std::memory_order_seq_cst);
+    if (previous != nullptr)
+    {
+        retired_.emplace_back(previous);
+    }
+
+    // A reader that registers after these loads sees the new table
+    bool const quiescent = std::all_of(
+        readers_.begin(),
+        readers_.end(),
+        [](const reader_slot& slot) { return slot.count.load(std::memory_order_seq_cst) == 0; });
+    if (quiescent)
+    {
+        retired_.clear();
+    }
+}
+
+std::optional<memory_range_table::range> memory_range_table::find(const void* ptr) const noexcept
+{
+    auto const address = reinterpret_cast<std::uintptr_t>(ptr);
+    auto&      slot    = readers_[reader_slot_index(kReaderSlots)].count;
+
+    slot.fetch_add(1, std::memory_order_seq_cst);
+    std::optional<range> found;
+    if (const table* current = current_.load(std::memory_order_seq_cst))
+    {
+        auto const it = std::upper_bound(
+            current->begin(),
+            current->end(),
+            address,
+            [](std::uintptr_t p, const range& r) { return p < r.begin; });
+        if (it != current->begin() && address < std::prev(it)->end)
+        {
+            found = *std::prev(it);
+        }
+    }
+    slot.fetch_sub(1, std::memory_order_release);
+    return found;
+}
+
+size_t memory_range_table::size() const noexcept
+{
+    auto& slot = readers_[reader_slot_index(kReaderSlots)].count;
+
+    slot.fetch_add(1, std::memory_order_seq_cst);
+    const table* current = current_.load(std::memory_order_seq_cst);
+    size_t const count   = current != nullptr ? current->size() : 0;
+    slot.fetch_sub(1, std::memory_order_release);
+    return count;
+}
+
+}  // namespace quarisma
@@ -0,0 +1,124 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "common/macros.h"
+#include "memory/sub_allocator.h"
+
+namespace quarisma
+{
+/**
+ * @brief Process-wide index of the memory regions handed out by sub_allocators
+ *
+ * sub_allocator::VisitAlloc() and VisitFree() report every region here, tagged
+ * with the memory type of the sub_allocator and its index (NUMA node or
+ * device). find() then classifies any pointer inside a region, not only its
+ * base, with a binary search over the regions sorted by address; copy
+ * routines use it to pick the host, pinned or device path without asking the
+ * driver.
+ *
+ * Lookups are lock-free. Writers, serialized by a mutex, publish an immutable
+ * copy of the table; readers announce themselves on one of a few striped
+ * counters, and a replaced copy is freed once all the counters were seen at
+ * zero. A write copies the table, which suits the few large regions that
+ * sub_allocators hand out, not per-object allocations.
+ *
+ * Example:
+ * ```cpp
+ * if (auto region = memory_range_table::instance().find(ptr))
+ * {
+ *     bool const on_device = region->type == allocator_memory_enum::DEVICE;
+ * }
+ * ```
+ */
+class QUARISMA_VISIBILITY memory_range_table
+{
+public:
+    /**
+     * @brief A registered region: [begin, end)
+     */
+    struct range
+    {
+        std::uintptr_t        begin = 0;
+        std::uintptr_t        end   = 0;
+        allocator_memory_enum type  = allocator_memory_enum::UNKNOWN;
+        int                   index = -1;  ///< NUMA node or device, -1 if none
+    };
+
+    QUARISMA_API static memory_range_table& instance();
+
+    /**
+     * @brief Register a region, replacing the registered ones it overlaps
+     */
+    QUARISMA_API void insert(
+        const void* ptr, size_t num_bytes, allocator_memory_enum type, int index);
+
+    /**
+     * @brief Unregister the region starting at ptr; no-op if there is none
+     */
+    QUARISMA_API void erase(const void* ptr);
+
+    /**
+     * @brief Region containing ptr, if any
+     */
+    QUARISMA_API std::optional<range> find(const void* ptr) const noexcept;
+
+    /**
+     * @brief Number of registered regions
+     */
+    QUARISMA_API size_t size() const noexcept;
+
+    QUARISMA_API ~memory_range_table();
+
+    memory_range_table(const memory_range_table&)            = delete;
+    memory_range_table& operator=(const memory_range_table&) = delete;
+
+private:
+    memory_range_table() = default;
+
+    using table = std::vector<range>;
+
+    // Publishes next as the current table; requires mutex_
+    void publish(std::unique_ptr<table> next);
+
+    static constexpr size_t kReaderSlots = 16;
+
+    struct alignas(64) reader_slot
+    {
+        std::atomic<int64_t> count{0};
+    };
+
+    mutable std::array<reader_slot, kReaderSlots> readers_;
+    std::atomic<table*>                           current_{nullptr};
+
+    std::mutex                          mutex_;
+    std::vector<std::unique_ptr<table>> retired_;  // Replaced tables readers may still use
+};
+
+}  // namespace quarisma
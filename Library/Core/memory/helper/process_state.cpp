@@ -28,6 +28,7 @@
 
 #include "memory/helper/process_state.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstring>
@@ -40,9 +41,13 @@
 #include "common/macros.h"
 #include "logging/logger.h"
 #include "memory/backend/allocator_bfc.h"
+#include "memory/backend/allocator_huge_page.h"
+#include "memory/backend/allocator_numa.h"
 #include "memory/backend/allocator_pool.h"
 #include "memory/backend/allocator_tracking.h"
 #include "memory/cpu/allocator.h"
+#include "memory/helper/memory_range_table.h"
+#include "memory/numa.h"
 #include "util/env.h"
 #include "util/exception.h"
 #include "util/string_util.h"
@@ -79,16 +84,46 @@ process_state::MemDesc process_state::PtrType(const void* ptr)
             return iter->second;
         }
     }
-    return {};
+
+    // Any pointer into a region of a sub_allocator
+    MemDesc desc;
+    if (auto region = memory_range_table::instance().find(ptr))
+    {
+        switch (region->type)
+        {
+        case allocator_memory_enum::DEVICE:
+        case allocator_memory_enum::UNIFIED:
+            desc.loc       = MemDesc::GPU;
+            desc.dev_index = std::max(region->index, 0);
+            break;
+        case allocator_memory_enum::HOST_PINNED:
+            desc.gpu_registered = true;
+            break;
+        default:
+            break;
+        }
+    }
+    return desc;
 }
 
 Allocator* process_state::GetCPUAllocator(int numa_node)
 {
-    if (!numa_enabled_ || numa_node == NUMANOAFFINITY)
+    const bool no_affinity = numa_node == NUMANOAFFINITY;
+    if (!numa_enabled_ || no_affinity)
     {
         numa_node = 0;
     }
 
+    // Requests without affinity go to the node of the calling thread once the
+    // per node allocators exist.
+    if (no_affinity)
+    {
+        if (Allocator* routed = numa_allocator_.load(std::memory_order_acquire))
+        {
+            return routed;
+        }
+    }
+
     // Check if allocator for the numa node is in lock-free cache.
     if (numa_node < cpu_allocators_cached_.load(std::memory_order_acquire))
     {
@@ -110,21 +145,54 @@ Allocator* process_state::GetCPUAllocator(int numa_node)
         QUARISMA_UNUSED auto status = quarisma::utils::read_env_bool(
             "CPU_ALLOCATOR_USE_BFC", alloc_visitors_defined, &use_allocator_bfc);
 
-        Allocator*     allocator = nullptr;
+        // TODO(reedwm): evaluate whether 64GB by default is the best choice.
+        int64_t cpu_mem_limit_in_mb = -1;
+
+        QUARISMA_UNUSED auto const status2 = quarisma::utils::read_env_int64(
+            "CPU_BFC_MEM_LIMIT_IN_MB", 1LL << 16 /*64GB max by default*/, &cpu_mem_limit_in_mb);
+        int64_t const cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+
+        // BFC regions are large and long-lived, which is where huge pages cut TLB
+        // misses the most.
+        bool use_huge_pages          = false;
+        bool use_explicit_huge_pages = false;
+        if (use_allocator_bfc)
+        {
+            QUARISMA_UNUSED auto const status3 =
+                quarisma::utils::read_env_bool("CPU_BFC_USE_HUGE_PAGES", false, &use_huge_pages);
+            QUARISMA_UNUSED auto const status4 = quarisma::utils::read_env_bool(
+                "CPU_BFC_USE_EXPLICIT_HUGE_PAGES", false, &use_explicit_huge_pages);
+        }
+        huge_page_cpu_allocator::Options page_opts;
+        page_opts.use_explicit_pages = use_explicit_huge_pages;
+
+        Allocator*     allocator     = nullptr;
         sub_allocator* sub_allocator =
-            (numa_enabled_ || alloc_visitors_defined || use_allocator_bfc)
+            (!use_allocator_bfc && (numa_enabled_ || alloc_visitors_defined))
                 ? new basic_cpu_allocator(
                       numa_enabled_ ? numa_node : -1, cpu_alloc_visitors_, cpu_free_visitors_)
                 : nullptr;
-        if (use_allocator_bfc)
+        if (use_allocator_bfc && numa_enabled_)
         {
-            // TODO(reedwm): evaluate whether 64GB by default is the best choice.
-            int64_t cpu_mem_limit_in_mb = -1;
-
-            QUARISMA_UNUSED auto const status2 = quarisma::utils::read_env_int64(
-                "CPU_BFC_MEM_LIMIT_IN_MB", 1LL << 16 /*64GB max by default*/, &cpu_mem_limit_in_mb);
-            int64_t const cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
-            QUARISMA_CHECK_DEBUG(sub_allocator != nullptr);
+            // One allocator_bfc per node, whose regions huge_page_cpu_allocator
+            // binds to the node; base pages are used unless huge pages are on.
+            if (!use_huge_pages)
+            {
+                page_opts.page_size = 4096;
+            }
+            allocator = GetNUMANodeAllocator(numa_node, cpu_mem_limit, page_opts);
+        }
+        else if (use_allocator_bfc)
+        {
+            if (use_huge_pages)
+            {
+                sub_allocator = new huge_page_cpu_allocator(
+                    -1, cpu_alloc_visitors_, cpu_free_visitors_, page_opts);
+            }
+            else
+            {
+                sub_allocator = new basic_cpu_allocator(-1, cpu_alloc_visitors_, cpu_free_visitors_);
+            }
 
             allocator_bfc::Options allocator_opts;
             allocator_opts.allow_growth = true;
@@ -136,8 +204,10 @@ Allocator* process_state::GetCPUAllocator(int numa_node)
                 allocator_opts);
 
             QUARISMA_LOG_INFO(
-                "Using allocator_bfc with memory limit of {} MB for process_state CPU allocator",
-                cpu_mem_limit_in_mb);
+                "Using allocator_bfc with memory limit of {} MB for process_state CPU allocator "
+                "(huge pages: {})",
+                cpu_mem_limit_in_mb,
+                use_huge_pages ? (use_explicit_huge_pages ? "explicit" : "transparent") : "off");
         }
         else if (sub_allocator != nullptr)
         {
@@ -171,14 +241,54 @@ Allocator* process_state::GetCPUAllocator(int numa_node)
             cpu_allocators_cache_[cpu_allocators_.size() - 1] = allocator;
             cpu_allocators_cached_.fetch_add(1, std::memory_order_release);
         }
-        if (sub_allocator == nullptr)
+        if (sub_allocator == nullptr && !use_allocator_bfc)
         {
             QUARISMA_CHECK_DEBUG(cpu_alloc_visitors_.empty() && cpu_free_visitors_.empty());
         }
     }
+    if (no_affinity)
+    {
+        if (Allocator* routed = numa_allocator_.load(std::memory_order_relaxed))
+        {
+            return routed;
+        }
+    }
     return cpu_allocators_[numa_node];
 }
 
+Allocator* process_state::GetNUMANodeAllocator(
+    int numa_node, int64_t memory_limit_per_node, const huge_page_cpu_allocator::Options& pages)
+{
+    allocator_numa* numa = numa_allocator_.load(std::memory_order_relaxed);
+    if (numa == nullptr)
+    {
+        allocator_numa::Options opts;
+        opts.memory_limit_per_node = static_cast<size_t>(memory_limit_per_node);
+        opts.bfc.allow_growth      = true;
+
+        numa = new allocator_numa(
+            "bfc_cpu_allocator_numa",
+            std::max(1, GetNumNUMANodes()),
+            [this, pages](int node) -> std::unique_ptr<sub_allocator>
+            {
+                return std::make_unique<huge_page_cpu_allocator>(
+                    node, cpu_alloc_visitors_, cpu_free_visitors_, pages);
+            },
+            opts);
+        numa_allocator_.store(numa, std::memory_order_release);
+
+        QUARISMA_LOG_INFO(
+            "Using allocator_numa with {} nodes and a limit of {} MB per node for process_state "
+            "CPU allocator",
+            numa->num_nodes(),
+            memory_limit_per_node >> 20);
+    }
+
+    // A node the machine does not have is served by the routing allocator.
+    return numa_node < numa->num_nodes() ? static_cast<Allocator*>(numa->node_allocator(numa_node))
+                                         : numa;
+}
+
 void process_state::AddCPUAllocVisitor(sub_allocator::Visitor visitor)
 {
     QUARISMA_LOG_INFO("AddCPUAllocVisitor");
@@ -207,6 +317,24 @@ void process_state::TestOnlyReset()
     // Don't delete this value because it's static.
     Allocator const* default_cpu_allocator = allocator_cpu_base();
     mem_desc_map_.clear();
+    // The per node allocators belong to numa_allocator_
+    allocator_numa* numa = numa_allocator_.exchange(nullptr);
+    if (numa != nullptr)
+    {
+        for (int node = 0; node < numa->num_nodes(); ++node)
+        {
+            std::replace(
+                cpu_allocators_.begin(),
+                cpu_allocators_.end(),
+                static_cast<Allocator*>(numa->node_allocator(node)),
+                static_cast<Allocator*>(nullptr));
+        }
+        std::replace(
+            cpu_allocators_.begin(),
+            cpu_allocators_.end(),
+            static_cast<Allocator*>(numa),
+            static_cast<Allocator*>(nullptr));
+    }
     for (Allocator const* a : cpu_allocators_)
     {
         if (a != default_cpu_allocator)
@@ -214,6 +342,7 @@ void process_state::TestOnlyReset()
             delete a;
         }
     }
+    delete numa;
     cpu_allocators_.clear();
     for (Allocator const* a : cpu_al_)
     {
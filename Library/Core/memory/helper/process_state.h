@@ -29,6 +29,8 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <mutex>
@@ -36,12 +38,14 @@
 #include <vector>
 
 #include "common/macros.h"
+#include "memory/backend/allocator_huge_page.h"
 #include "memory/cpu/allocator.h"
 #include "util/flat_hash.h"
 
 namespace quarisma
 {
 
+class allocator_numa;
 class allocator_pool;
 
 // Singleton that manages per-process state, e.g. allocation of
@@ -72,12 +76,16 @@ public:
     // Allocator accessor.
     void EnableNUMA() { numa_enabled_ = true; }
 
-    // Returns what we know about the memory at ptr.
+    // Returns what we know about the memory at ptr, which may point anywhere
+    // inside an allocation: the recorded allocations if FLAGS_brain_gpu_record_mem_types
+    // is set, then the sub_allocator regions of memory_range_table.
     // If we know nothing, it's called CPU 0 with no other attributes.
     QUARISMA_API MemDesc PtrType(const void* ptr);
 
     // Returns the one cpu_allocator used for the given numa_node.
-    // Treats numa_node == NUMANOAFFINITY as numa_node == 0.
+    // Treats numa_node == NUMANOAFFINITY as numa_node == 0, except with NUMA
+    // enabled and allocator_bfc, where each node has its own allocator_bfc and
+    // NUMANOAFFINITY returns an allocator_numa serving the node of the caller.
     QUARISMA_API Allocator* GetCPUAllocator(int numa_node);
 
     // Registers alloc visitor for the CPU allocator(s).
@@ -123,6 +131,14 @@ protected:
     std::atomic<int>          cpu_allocators_cached_;
     std::array<Allocator*, 8> cpu_allocators_cache_;
 
+    // Owner of the per node allocators when NUMA and allocator_bfc are enabled.
+    std::atomic<allocator_numa*> numa_allocator_{nullptr};
+
+    // Creates numa_allocator_ on first use and returns the allocator of numa_node.
+    Allocator* GetNUMANodeAllocator(
+        int numa_node, int64_t memory_limit_per_node, const huge_page_cpu_allocator::Options& pages)
+        QUARISMA_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
     // Optional RecordingAllocators that wrap the corresponding
     // Allocators for runtime attribute use analysis.
     MDMap                           mem_desc_map_;
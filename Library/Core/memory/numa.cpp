@@ -124,4 +124,17 @@ int GetCurrentNUMANode()
 #endif
 }
 
+int GetNUMANodeOfCPU(QUARISMA_UNUSED int cpu)
+{
+#if QUARISMA_HAS_NUMA
+    if (cpu < 0 || !IsNUMAEnabled())
+    {
+        return -1;
+    }
+    return numa_node_of_cpu(cpu);
+#else
+    return -1;
+#endif
+}
+
 }  // namespace quarisma
@@ -37,4 +37,9 @@ QUARISMA_API void NUMAMove(void* ptr, size_t size, int numa_node_id);
  */
 QUARISMA_API int GetCurrentNUMANode();
 
+/**
+ * Get the NUMA node id of logical CPU `cpu`, or -1 if unknown
+ */
+QUARISMA_API int GetNUMANodeOfCPU(int cpu);
+
 }  // namespace quarisma
@@ -0,0 +1,365 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "memory/result_cache.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+size_t round_up_to_power_of_two(size_t value) noexcept
+{
+    size_t power = 1;
+    while (power < value)
+    {
+        power <<= 1;
+    }
+    return power;
+}
+}  // namespace
+
+struct alignas(64) result_cache::shard
+{
+    std::mutex mutex;
+    flat_hash_map<key_type, entry, quarisma::hash<key_type>> entries QUARISMA_GUARDED_BY(mutex);
+    std::list<key_type> lru QUARISMA_GUARDED_BY(mutex);  // MRU first
+    flat_hash_map<key_type, std::shared_future<buffer_ptr>, quarisma::hash<key_type>> running
+        QUARISMA_GUARDED_BY(mutex);
+    frequency_sketch sketch QUARISMA_GUARDED_BY(mutex){0};
+    size_t bytes            QUARISMA_GUARDED_BY(mutex) = 0;
+};
+
+// ============================================================================
+// frequency_sketch
+// ============================================================================
+
+result_cache::frequency_sketch::frequency_sketch(size_t width)
+    : counters_(kRows * round_up_to_power_of_two(std::max<size_t>(width, 64))),
+      width_(round_up_to_power_of_two(std::max<size_t>(width, 64)))
+{
+}
+
+size_t result_cache::frequency_sketch::index(const key_type& key, size_t row) const noexcept
+{
+    // Double hashing over the two independent words of the key
+    return row * width_ + static_cast<size_t>((key.low_ + row * key.high_) & (width_ - 1));
+}
+
+void result_cache::frequency_sketch::increment(const key_type& key) noexcept
+{
+    for (size_t row = 0; row < kRows; ++row)
+    {
+        uint8_t& counter = counters_[index(key, row)];
+        counter          = static_cast<uint8_t>(std::min(counter + 1, 15));
+    }
+
+    if (++increments_ >= 10 * width_)
+    {
+        for (auto& counter : counters_)
+        {
+            counter >>= 1;
+        }
+        increments_ /= 2;
+    }
+}
+
+uint8_t result_cache::frequency_sketch::estimate(const key_type& key) const noexcept
+{
+    uint8_t estimate = 15;
+    for (size_t row = 0; row < kRows; ++row)
+    {
+        estimate = std::min(estimate, counters_[index(key, row)]);
+    }
+    return estimate;
+}
+
+// ============================================================================
+// result_cache
+// ============================================================================
+
+result_cache::result_cache(options opts)
+    : policy_(opts.policy), allocator_(opts.allocator)
+{
+    QUARISMA_CHECK(opts.shards > 0, "result_cache needs at least one shard");
+
+    size_t const shards = round_up_to_power_of_two(opts.shards);
+    shard_budget_       = opts.byte_budget / shards;
+    shard_mask_         = shards - 1;
+
+    shards_ = std::make_unique<shard[]>(shards);
+    for (size_t i = 0; i < shards; ++i)
+    {
+        shards_[i].sketch = frequency_sketch(opts.sketch_width);
+    }
+
+    if (!opts.name.empty())
+    {
+        pressure_id_ = memory_pressure::instance().register_cache(
+            std::move(opts.name),
+            memory_trim_cost::HIGH,
+            device_enum::CPU,
+            -1,
+            [this](size_t bytes_wanted) { return release(bytes_wanted); });
+    }
+}
+
+result_cache::~result_cache()
+{
+    if (pressure_id_ != 0)
+    {
+        memory_pressure::instance().unregister_cache(pressure_id_);
+    }
+}
+
+result_cache::key_type result_cache::make_key(std::initializer_list<byte_range> parts) noexcept
+{
+    byte_hasher128 hasher;
+    for (const auto& part : parts)
+    {
+        uint64_t const size = part.size_;
+        hasher.update(&size, sizeof(size)).update(part.data_, part.size_);
+    }
+    return hasher.digest();
+}
+
+result_cache::shard& result_cache::shard_of(const key_type& key) const noexcept
+{
+    // The maps index by low_, the shards by high_
+    return shards_[static_cast<size_t>(key.high_) & shard_mask_];
+}
+
+buffer_ptr result_cache::get_or_compute(
+    key_type key, const std::function<buffer_ptr()>& compute)
+{
+    shard&                   s = shard_of(key);
+    std::promise<buffer_ptr> promise;
+    {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.sketch.increment(key);
+
+        auto const found = s.entries.find(key);
+        if (found != s.entries.end())
+        {
+            counters_.hits.fetch_add(1, std::memory_order_relaxed);
+            s.lru.splice(s.lru.begin(), s.lru, found->second.position);
+            return found->second.value;
+        }
+
+        auto const running = s.running.find(key);
+        if (running != s.running.end())
+        {
+            counters_.coalesced.fetch_add(1, std::memory_order_relaxed);
+            std::shared_future<buffer_ptr> const result = running->second;
+            lock.unlock();
+            return result.get();
+        }
+
+        counters_.misses.fetch_add(1, std::memory_order_relaxed);
+        s.running.emplace(key, promise.get_future().share());
+    }
+
+    buffer_ptr value;
+    try
+    {
+        value = compute();
+    }
+    catch (...)
+    {
+        {
+            std::scoped_lock const lock(s.mutex);
+            s.running.erase(key);
+        }
+        counters_.failures.fetch_add(1, std::memory_order_relaxed);
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::scoped_lock const lock(s.mutex);
+        s.running.erase(key);
+        if (value)
+        {
+            insert(s, key, value);
+        }
+    }
+    promise.set_value(value);
+    return value;
+}
+
+buffer_ptr result_cache::get(key_type key)
+{
+    shard&                 s = shard_of(key);
+    std::scoped_lock const lock(s.mutex);
+    s.sketch.increment(key);
+
+    auto const found = s.entries.find(key);
+    if (found == s.entries.end())
+    {
+        counters_.misses.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+    counters_.hits.fetch_add(1, std::memory_order_relaxed);
+    s.lru.splice(s.lru.begin(), s.lru, found->second.position);
+    return found->second.value;
+}
+
+bool result_cache::put(key_type key, buffer_ptr value)
+{
+    QUARISMA_CHECK(value, "result_cache::put of a null result");
+
+    shard&                 s = shard_of(key);
+    std::scoped_lock const lock(s.mutex);
+    s.sketch.increment(key);
+    return insert(s, key, std::move(value));
+}
+
+bool result_cache::put(key_type key, const void* data, size_t size)
+{
+    return put(key, buffer::copy_of(data, size, allocator_));
+}
+
+buffer_ptr result_cache::allocate(size_t size) const
+{
+    return buffer::allocate(size, allocator_);
+}
+
+bool result_cache::insert(shard& s, const key_type& key, buffer_ptr value)
+{
+    auto const found = s.entries.find(key);
+    if (found != s.entries.end())
+    {
+        remove(s, key, found->second);
+    }
+
+    size_t const size = value->size();
+    if (size > shard_budget_)
+    {
+        counters_.rejections.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // The least recently used entries that have to go for the result to fit
+    size_t victims = 0;
+    size_t freed   = 0;
+    for (auto it = s.lru.rbegin(); s.bytes - freed + size > shard_budget_; ++it, ++victims)
+    {
+        // TinyLFU: keep the victims unless the newcomer is used more often
+        if (policy_ == eviction_policy::TINY_LFU &&
+            s.sketch.estimate(*it) >= s.sketch.estimate(key))
+        {
+            counters_.rejections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        freed += s.entries.find(*it)->second.value->size();
+    }
+
+    for (; victims > 0; --victims)
+    {
+        key_type const victim = s.lru.back();
+        remove(s, victim, s.entries.find(victim)->second);
+        counters_.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    s.lru.push_front(key);
+    s.entries.emplace(key, entry{std::move(value), s.lru.begin()});
+    s.bytes += size;
+    counters_.entries.fetch_add(1, std::memory_order_relaxed);
+    counters_.bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+    return true;
+}
+
+void result_cache::remove(shard& s, const key_type& key, entry& e)
+{
+    size_t const size = e.value->size();
+    s.bytes -= size;
+    counters_.entries.fetch_sub(1, std::memory_order_relaxed);
+    counters_.bytes.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+    s.lru.erase(e.position);
+    s.entries.erase(key);
+}
+
+bool result_cache::erase(key_type key)
+{
+    shard&                 s = shard_of(key);
+    std::scoped_lock const lock(s.mutex);
+
+    auto const found = s.entries.find(key);
+    if (found == s.entries.end())
+    {
+        return false;
+    }
+    remove(s, key, found->second);
+    return true;
+}
+
+void result_cache::clear()
+{
+    for (size_t i = 0; i <= shard_mask_; ++i)
+    {
+        shard&                 s = shards_[i];
+        std::scoped_lock const lock(s.mutex);
+        counters_.entries.fetch_sub(
+            static_cast<int64_t>(s.entries.size()), std::memory_order_relaxed);
+        counters_.bytes.fetch_sub(static_cast<int64_t>(s.bytes), std::memory_order_relaxed);
+        s.entries.clear();
+        s.lru.clear();
+        s.bytes = 0;
+    }
+}
+
+size_t result_cache::release(size_t bytes_wanted)
+{
+    size_t released = 0;
+    for (size_t i = 0; i <= shard_mask_ && released < bytes_wanted; ++i)
+    {
+        shard&                 s = shards_[i];
+        std::scoped_lock const lock(s.mutex);
+        while (!s.lru.empty() && released < bytes_wanted)
+        {
+            key_type const victim = s.lru.back();
+            auto const     found  = s.entries.find(victim);
+            released += found->second.value->size();
+            remove(s, victim, found->second);
+            counters_.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return released;
+}
+
+result_cache_stats result_cache::stats() const noexcept
+{
+    result_cache_stats stats;
+    stats.hits       = counters_.hits.load(std::memory_order_relaxed);
+    stats.misses     = counters_.misses.load(std::memory_order_relaxed);
+    stats.coalesced  = counters_.coalesced.load(std::memory_order_relaxed);
+    stats.evictions  = counters_.evictions.load(std::memory_order_relaxed);
+    stats.rejections = counters_.rejections.load(std::memory_order_relaxed);
+    stats.failures   = counters_.failures.load(std::memory_order_relaxed);
+    stats.entries    = static_cast<size_t>(counters_.entries.load(std::memory_order_relaxed));
+    stats.bytes      = static_cast<size_t>(counters_.bytes.load(std::memory_order_relaxed));
+    return stats;
+}
+
+}  // namespace quarisma
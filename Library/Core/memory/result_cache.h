@@ -0,0 +1,268 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/export.h"
+#include "common/macros.h"
+#include "memory/buffer.h"
+#include "memory/helper/memory_pressure.h"
+#include "util/flat_hash.h"
+#include "util/hash.h"
+
+namespace quarisma
+{
+class Allocator;
+
+/**
+ * @brief Counters of a result_cache, readable without its locks.
+ *
+ * Each counter sits on its own cache line, so that threads hitting and
+ * missing at once do not share one.
+ */
+struct result_cache_counters
+{
+    alignas(64) std::atomic<int64_t> hits{0};       ///< Lookups that found the key
+    alignas(64) std::atomic<int64_t> misses{0};     ///< Lookups that did not, computations run
+    alignas(64) std::atomic<int64_t> coalesced{0};  ///< Misses that waited on a running computation
+    alignas(64) std::atomic<int64_t> evictions{0};  ///< Entries dropped to stay within the budget
+    alignas(64) std::atomic<int64_t> rejections{0};  ///< Results not admitted by TinyLFU
+    alignas(64) std::atomic<int64_t> failures{0};    ///< Computations that threw
+    alignas(64) std::atomic<int64_t> entries{0};
+    alignas(64) std::atomic<int64_t> bytes{0};
+};
+
+/**
+ * @brief Snapshot of result_cache_counters.
+ */
+struct result_cache_stats
+{
+    int64_t hits       = 0;
+    int64_t misses     = 0;
+    int64_t coalesced  = 0;
+    int64_t evictions  = 0;
+    int64_t rejections = 0;
+    int64_t failures   = 0;
+    size_t  entries    = 0;
+    size_t  bytes      = 0;
+
+    /** Fraction of lookups served without computing, coalesced ones included. */
+    double hit_rate() const noexcept
+    {
+        int64_t const served = hits + coalesced;
+        int64_t const total  = served + misses;
+        return total == 0 ? 0.0 : static_cast<double>(served) / static_cast<double>(total);
+    }
+};
+
+/**
+ * @brief Shared memoization of computed results, addressed by the hash of their inputs.
+ *
+ * Results are byte buffers keyed by a 128-bit content address: the
+ * hash_bytes128() of everything the computation depends on, e.g. the
+ * instrument and the version of the market data. The keys are spread over
+ * lock-striped shards, each an LRU list under its share of the byte budget.
+ * With eviction_policy::TINY_LFU a per-shard count-min sketch of recent
+ * accesses admits a new result only if its key was used more often than the
+ * entries it would evict, so that a burst of one-off requests does not flush
+ * the results in steady use.
+ *
+ * get_or_compute() coalesces concurrent misses: the first caller computes,
+ * the others wait for its result (or its exception) instead of computing the
+ * same thing again. Results live in buffers from options::allocator, so they
+ * can come from a pool or an arena; they are shared, and stay valid for the
+ * callers holding them after they are evicted.
+ *
+ * The cache registers with memory_pressure at memory_trim_cost::HIGH, since
+ * refilling it means recomputing. web_dashboard::register_result_cache()
+ * exports its counters.
+ *
+ * Example:
+ * ```cpp
+ * result_cache cache({.byte_budget = size_t{512} << 20});
+ *
+ * auto const key = result_cache::make_key(
+ *     {as_byte_range(instrument_id), as_byte_range(&market_version, sizeof(market_version))});
+ * buffer_ptr price = cache.get_or_compute(
+ *     key,
+ *     [&]
+ *     {
+ *         auto out = cache.allocate(sizeof(double));
+ *         *reinterpret_cast<double*>(out->mutable_data()) = price_instrument(instrument_id);
+ *         return out;
+ *     });
+ * ```
+ *
+ * **Thread Safety**: Fully thread-safe. Computations run without any lock; a
+ * computation must not look up its own key.
+ */
+class QUARISMA_VISIBILITY result_cache
+{
+public:
+    using key_type = hash128;
+
+    enum class eviction_policy
+    {
+        LRU,      ///< Always admit, evict the least recently used
+        TINY_LFU  ///< Admit over the least recently used only if used more often
+    };
+
+    struct options
+    {
+        /** Bytes of results kept, split evenly between the shards. */
+        size_t byte_budget = size_t{256} << 20;
+
+        /** Number of lock stripes, rounded up to a power of two. */
+        size_t shards = 16;
+
+        eviction_policy policy = eviction_policy::TINY_LFU;
+
+        /** Counters per row of each shard's frequency sketch (TINY_LFU). */
+        size_t sketch_width = 4096;
+
+        /** Allocator of allocate() and of the copies made by put(); cpu_allocator() if null. */
+        Allocator* allocator = nullptr;
+
+        /** Name used for memory_pressure; empty to not register. */
+        std::string name = "result_cache";
+    };
+
+    QUARISMA_API explicit result_cache(options opts);
+
+    QUARISMA_API ~result_cache();
+
+    /**
+     * @brief Content address of the concatenation of parts, each prefixed with its size
+     */
+    QUARISMA_API static key_type make_key(std::initializer_list<byte_range> parts) noexcept;
+
+    /**
+     * @brief Result of key, computing it once if it is not cached
+     *
+     * Callers that miss while the key is being computed wait for that
+     * computation. A null result is returned but not cached.
+     *
+     * @throws Whatever compute throws, to every caller waiting on it
+     */
+    QUARISMA_API buffer_ptr get_or_compute(key_type key, const std::function<buffer_ptr()>& compute);
+
+    /**
+     * @brief Cached result of key, or nullptr
+     */
+    QUARISMA_API buffer_ptr get(key_type key);
+
+    /**
+     * @brief Caches value as the result of key, subject to admission
+     * @return false if the result was not admitted
+     */
+    QUARISMA_API bool put(key_type key, buffer_ptr value);
+
+    /**
+     * @brief Caches a copy of size bytes at data, allocated from options::allocator
+     */
+    QUARISMA_API bool put(key_type key, const void* data, size_t size);
+
+    /**
+     * @brief Uninitialized buffer from options::allocator, for a computation to fill
+     */
+    QUARISMA_API buffer_ptr allocate(size_t size) const;
+
+    /**
+     * @brief Removes the result of key
+     * @return false if it was not cached
+     */
+    QUARISMA_API bool erase(key_type key);
+
+    /**
+     * @brief Removes every result; the counters are kept
+     */
+    QUARISMA_API void clear();
+
+    /**
+     * @brief Drops results, least recently used first, shard by shard
+     * @return Bytes released
+     */
+    QUARISMA_API size_t release(size_t bytes_wanted);
+
+    QUARISMA_API result_cache_stats stats() const noexcept;
+
+    /** @brief Live counters, e.g. to bind into a metrics_registry */
+    const result_cache_counters& counters() const noexcept { return counters_; }
+
+    QUARISMA_DELETE_COPY_AND_MOVE(result_cache);
+
+private:
+    struct shard;
+
+    struct entry
+    {
+        buffer_ptr                    value;
+        std::list<key_type>::iterator position;  // In the LRU list of its shard
+    };
+
+    /**
+     * @brief Count-min sketch of 4 rows of saturating 4-bit counters, halved
+     *        every 10 * width increments so that old popularity fades.
+     */
+    class frequency_sketch
+    {
+    public:
+        explicit frequency_sketch(size_t width);
+
+        void    increment(const key_type& key) noexcept;
+        uint8_t estimate(const key_type& key) const noexcept;
+
+    private:
+        static constexpr size_t kRows = 4;
+
+        size_t index(const key_type& key, size_t row) const noexcept;
+
+        std::vector<uint8_t> counters_;  // kRows rows of width_ counters
+        size_t               width_;
+        size_t               increments_ = 0;
+    };
+
+    shard& shard_of(const key_type& key) const noexcept;
+
+    bool insert(shard& s, const key_type& key, buffer_ptr value)
+        QUARISMA_NO_THREAD_SAFETY_ANALYSIS;
+    void remove(shard& s, const key_type& key, entry& e) QUARISMA_NO_THREAD_SAFETY_ANALYSIS;
+
+    const eviction_policy           policy_;
+    Allocator* const                allocator_;
+    size_t                          shard_budget_;
+    std::unique_ptr<shard[]>        shards_;
+    size_t                          shard_mask_;
+    mutable result_cache_counters   counters_;
+    memory_pressure::cache_id       pressure_id_ = 0;
+};
+
+}  // namespace quarisma
@@ -6,6 +6,8 @@
 
 #include "memory/sub_allocator.h"
 
+#include "memory/helper/memory_range_table.h"
+
 namespace quarisma
 {
 
@@ -17,6 +19,7 @@ sub_allocator::sub_allocator(
 
 void sub_allocator::VisitAlloc(void* ptr, int index, size_t num_bytes)
 {
+    memory_range_table::instance().insert(ptr, num_bytes, GetMemoryType(), index);
     for (const auto& v : alloc_visitors_)
     {
         v(ptr, index, num_bytes);
@@ -31,6 +34,7 @@ void sub_allocator::VisitFree(void* ptr, int index, size_t num_bytes)
     {
         free_visitors_[i](ptr, index, num_bytes);
     }
+    memory_range_table::instance().erase(ptr);
 }
 
 }  // namespace quarisma
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <iomanip>
@@ -113,6 +114,135 @@ double atomic_timing_stats::average_dealloc_time_us() const noexcept
     return static_cast<double>(total_dealloc_time_us.load(std::memory_order_relaxed)) / deallocs;
 }
 
+// ============================================================================
+// LATENCY HISTOGRAM IMPLEMENTATION
+// ============================================================================
+
+namespace
+{
+// Shard of the calling thread: threads take shards in turn as they first record
+size_t latency_shard() noexcept
+{
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t const  shard =
+        next_shard.fetch_add(1, std::memory_order_relaxed) % latency_histogram::kShards;
+    return shard;
+}
+}  // namespace
+
+size_t latency_histogram::bucket_index(uint64_t latency_ns) noexcept
+{
+    if (latency_ns < kSubBuckets)
+    {
+        return static_cast<size_t>(latency_ns);
+    }
+    size_t exponent = 63;
+    while ((latency_ns >> exponent) == 0)
+    {
+        --exponent;
+    }
+    if (exponent > kMaxExponent)
+    {
+        return kBuckets - 1;
+    }
+    // The kSubBucketBits bits below the leading one select the linear bucket
+    size_t const sub = static_cast<size_t>(latency_ns >> (exponent - kSubBucketBits)) &
+                       (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t latency_histogram::bucket_lower_ns(size_t bucket) noexcept
+{
+    if (bucket < kSubBuckets)
+    {
+        return bucket;
+    }
+    size_t const group = bucket / kSubBuckets;
+    return static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets) << (group - 1);
+}
+
+uint64_t latency_histogram::bucket_upper_ns(size_t bucket) noexcept
+{
+    if (bucket < kSubBuckets)
+    {
+        return bucket + 1;
+    }
+    return bucket_lower_ns(bucket) + (uint64_t{1} << (bucket / kSubBuckets - 1));
+}
+
+void latency_histogram::record(uint64_t latency_ns) noexcept
+{
+    shard& s = shards_[latency_shard()];
+    s.counts[bucket_index(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+    s.sum_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+
+    uint64_t current = s.max_ns.load(std::memory_order_relaxed);
+    while (latency_ns > current &&
+           !s.max_ns.compare_exchange_weak(current, latency_ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+latency_snapshot latency_histogram::snapshot() const
+{
+    latency_snapshot result;
+    result.counts.assign(kBuckets, 0);
+    for (const auto& s : shards_)
+    {
+        for (size_t i = 0; i < kBuckets; ++i)
+        {
+            uint64_t const n = s.counts[i].load(std::memory_order_relaxed);
+            result.counts[i] += n;
+            result.count += n;
+        }
+        result.sum_ns += s.sum_ns.load(std::memory_order_relaxed);
+        result.max_ns = std::max(result.max_ns, s.max_ns.load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+void latency_histogram::reset() noexcept
+{
+    for (auto& s : shards_)
+    {
+        for (auto& count : s.counts)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+        s.sum_ns.store(0, std::memory_order_relaxed);
+        s.max_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t latency_snapshot::percentile_ns(double percentile) const noexcept
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    percentile = std::clamp(percentile, 0.0, 100.0);
+
+    // Rank of the percentile among the recorded latencies, from 1
+    auto const rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count))));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return std::min(latency_histogram::bucket_upper_ns(i) - 1, max_ns);
+        }
+    }
+    return max_ns;
+}
+
+double latency_snapshot::mean_ns() const noexcept
+{
+    return count != 0 ? static_cast<double>(sum_ns) / static_cast<double>(count) : 0.0;
+}
+
 // ============================================================================
 // UNIFIED RESOURCE STATISTICS IMPLEMENTATION
 // ============================================================================
@@ -237,6 +367,19 @@ double unified_resource_stats::allocation_success_rate() const noexcept
            100.0;
 }
 
+double unified_resource_stats::fragmentation_score() const noexcept
+{
+    int64_t const free_bytes = pool_bytes.load(std::memory_order_relaxed) -
+                               bytes_in_use.load(std::memory_order_relaxed);
+    if (free_bytes <= 0)
+    {
+        return 0.0;
+    }
+    int64_t const largest =
+        std::min(largest_free_block_bytes.load(std::memory_order_relaxed), free_bytes);
+    return 1.0 - (static_cast<double>(largest) / static_cast<double>(free_bytes));
+}
+
 std::string unified_resource_stats::debug_string() const
 {
     std::ostringstream oss;
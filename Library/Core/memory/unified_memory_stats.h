@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -79,6 +80,114 @@ struct QUARISMA_VISIBILITY atomic_timing_stats
     QUARISMA_API double average_dealloc_time_us() const noexcept;
 };
 
+// ============================================================================
+// LATENCY HISTOGRAMS
+// ============================================================================
+
+/**
+ * @brief Contents of a latency_histogram at one point in time
+ */
+struct QUARISMA_VISIBILITY latency_snapshot
+{
+    std::vector<uint64_t> counts;      ///< Per bucket, see latency_histogram::bucket_index()
+    uint64_t              count  = 0;  ///< Number of recorded latencies
+    uint64_t              sum_ns = 0;
+    uint64_t              max_ns = 0;
+
+    /**
+     * @brief Latency below which `percentile` percent of the recorded ones fall
+     *
+     * The result is the highest value of the bucket holding that rank, capped
+     * by the largest recorded latency, so it overestimates by at most one
+     * bucket width (1/16 of the value).
+     *
+     * @param percentile In [0, 100], e.g. 99.9
+     * @return Latency in nanoseconds, 0 if nothing was recorded
+     */
+    QUARISMA_API uint64_t percentile_ns(double percentile) const noexcept;
+
+    /**
+     * @brief Average latency in nanoseconds, 0.0 if nothing was recorded
+     */
+    QUARISMA_API double mean_ns() const noexcept;
+};
+
+/**
+ * @brief Fixed-size, lock-free log-linear (HDR-style) histogram of latencies
+ *
+ * Each power of two of nanoseconds is split into 16 linear buckets, so a
+ * bucket is never wider than 1/16 of the values it holds and tail percentiles
+ * such as p99.9 are exact to about 6%. Latencies from 0 to 2^41 ns (about 36
+ * minutes) are resolved; longer ones fall in the last bucket.
+ *
+ * record() is a few relaxed atomic adds on one of kShards cache-line aligned
+ * shards, chosen per thread, so concurrent recorders rarely share a line.
+ * snapshot() sums the shards; it does not stop recorders and may miss
+ * latencies recorded while it runs.
+ *
+ * **Thread Safety**: Thread-safe
+ */
+class QUARISMA_VISIBILITY latency_histogram
+{
+public:
+    static constexpr size_t kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets    = size_t{1} << kSubBucketBits;
+    static constexpr size_t kMaxExponent   = 40;  ///< Highest resolved power of two
+    static constexpr size_t kBuckets       = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+    static constexpr size_t kShards        = 8;
+
+    latency_histogram() = default;
+    QUARISMA_DELETE_COPY_AND_MOVE(latency_histogram);
+
+    /**
+     * @brief Record one latency
+     */
+    QUARISMA_API void record(uint64_t latency_ns) noexcept;
+
+    /**
+     * @brief Record the time elapsed since start
+     */
+    void record_since(std::chrono::steady_clock::time_point start) noexcept
+    {
+        auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+        record(elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0);
+    }
+
+    QUARISMA_API latency_snapshot snapshot() const;
+
+    /**
+     * @brief Forget every recorded latency
+     */
+    QUARISMA_API void reset() noexcept;
+
+    /**
+     * @brief Bucket of a latency
+     */
+    QUARISMA_API static size_t bucket_index(uint64_t latency_ns) noexcept;
+
+    /**
+     * @brief Smallest latency of a bucket, in nanoseconds
+     */
+    QUARISMA_API static uint64_t bucket_lower_ns(size_t bucket) noexcept;
+
+    /**
+     * @brief Exclusive upper bound of a bucket, in nanoseconds
+     */
+    QUARISMA_API static uint64_t bucket_upper_ns(size_t bucket) noexcept;
+
+private:
+    struct alignas(64) shard
+    {
+        std::array<std::atomic<uint64_t>, kBuckets> counts{};
+        std::atomic<uint64_t>                        sum_ns{0};
+        std::atomic<uint64_t>                        max_ns{0};
+    };
+
+    std::array<shard, kShards> shards_{};
+};
+
 // ============================================================================
 // UNIFIED RESOURCE STATISTICS
 // ============================================================================
@@ -141,6 +250,13 @@ struct QUARISMA_VISIBILITY unified_resource_stats
      */
     QUARISMA_API double allocation_success_rate() const noexcept;
 
+    /**
+     * @brief Calculate how fragmented the free pool memory is
+     * @return 1 - largest_free_block_bytes / free pool bytes (0.0 to 1.0), or 0.0
+     *         if the pool has no free bytes
+     */
+    QUARISMA_API double fragmentation_score() const noexcept;
+
     /**
      * @brief Generate debug string representation of statistics
      * @return Formatted debug string
@@ -0,0 +1,517 @@
+#include "memory/visualization/metrics_registry.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "logging/logger.h"
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace quarisma
+{
+
+//------------------------------------------------------------------------------
+// metrics_registry
+//------------------------------------------------------------------------------
+
+namespace
+{
+const char* type_name(metric_type type)
+{
+    switch (type)
+    {
+    case metric_type::counter:
+        return "counter";
+    case metric_type::summary:
+        return "summary";
+    case metric_type::gauge:
+    default:
+        return "gauge";
+    }
+}
+}  // namespace
+
+metrics_registry::series& metrics_registry::add_series(
+    const std::string& name, const std::string& help, const std::string& labels, metric_type type)
+{
+    auto s    = std::make_unique<series>();
+    s->name   = name;
+    s->help   = help;
+    s->labels = labels;
+    s->type   = type;
+    s->source = &s->owned;
+
+    std::scoped_lock const lock(mutex_);
+    series_.push_back(std::move(s));
+    return *series_.back();
+}
+
+metric_counter metrics_registry::add_counter(
+    const std::string& name, const std::string& help, const std::string& labels)
+{
+    return metric_counter(&add_series(name, help, labels, metric_type::counter).owned);
+}
+
+metric_gauge metrics_registry::add_gauge(
+    const std::string& name, const std::string& help, const std::string& labels)
+{
+    return metric_gauge(&add_series(name, help, labels, metric_type::gauge).owned);
+}
+
+void metrics_registry::bind(
+    const std::string&          name,
+    const std::string&          help,
+    const std::string&          labels,
+    metric_type                 type,
+    const std::atomic<int64_t>* source)
+{
+    auto s    = std::make_unique<series>();
+    s->name   = name;
+    s->help   = help;
+    s->labels = labels;
+    s->type   = type;
+    s->source = source;
+
+    std::scoped_lock const lock(mutex_);
+    series_.push_back(std::move(s));
+}
+
+void metrics_registry::bind_latency(
+    const std::string&       name,
+    const std::string&       help,
+    const std::string&       labels,
+    const latency_histogram* source)
+{
+    auto s       = std::make_unique<series>();
+    s->name      = name;
+    s->help      = help;
+    s->labels    = labels;
+    s->type      = metric_type::summary;
+    s->source    = &s->owned;
+    s->histogram = source;
+
+    std::scoped_lock const lock(mutex_);
+    series_.push_back(std::move(s));
+}
+
+void metrics_registry::expand(const series& s, std::vector<sample>& out)
+{
+    if (s.histogram == nullptr)
+    {
+        out.push_back({s.name, s.labels, s.type, s.source->load(std::memory_order_relaxed)});
+        return;
+    }
+
+    auto const        latency   = s.histogram->snapshot();
+    std::string const separator = s.labels.empty() ? "" : ",";
+    for (double const q : kSummaryQuantiles)
+    {
+        std::ostringstream quantile;
+        quantile << q;
+        out.push_back(
+            {s.name,
+             s.labels + separator + "quantile=\"" + quantile.str() + "\"",
+             s.type,
+             static_cast<int64_t>(latency.percentile_ns(q * 100.0))});
+    }
+    out.push_back({s.name + "_sum", s.labels, s.type, static_cast<int64_t>(latency.sum_ns)});
+    out.push_back({s.name + "_count", s.labels, s.type, static_cast<int64_t>(latency.count)});
+}
+
+size_t metrics_registry::remove_series(const std::string& labels)
+{
+    std::scoped_lock const lock(mutex_);
+    auto const             end = std::remove_if(
+        series_.begin(), series_.end(), [&](const auto& s) { return s->labels == labels; });
+    auto const removed = static_cast<size_t>(series_.end() - end);
+    series_.erase(end, series_.end());
+    return removed;
+}
+
+std::vector<metrics_registry::sample> metrics_registry::collect() const
+{
+    std::scoped_lock const lock(mutex_);
+
+    std::vector<sample> samples;
+    samples.reserve(series_.size());
+    for (const auto& s : series_)
+    {
+        expand(*s, samples);
+    }
+    return samples;
+}
+
+int64_t metrics_registry::value(const std::string& name, const std::string& labels) const
+{
+    std::scoped_lock const lock(mutex_);
+    for (const auto& s : series_)
+    {
+        if (s->histogram == nullptr && s->name == name && s->labels == labels)
+        {
+            return s->source->load(std::memory_order_relaxed);
+        }
+    }
+
+    // Summary samples, e.g. name_count, only exist once expanded
+    std::vector<sample> samples;
+    for (const auto& s : series_)
+    {
+        if (s->histogram != nullptr && name.compare(0, s->name.size(), s->name) == 0)
+        {
+            expand(*s, samples);
+        }
+    }
+    for (const auto& sample : samples)
+    {
+        if (sample.name == name && sample.labels == labels)
+        {
+            return sample.value;
+        }
+    }
+    return 0;
+}
+
+std::string metrics_registry::export_text(bool openmetrics) const
+{
+    std::scoped_lock const lock(mutex_);
+
+    // Series of one family are grouped under a single HELP/TYPE header, in the
+    // order the family was first registered.
+    std::vector<const std::string*> families;
+    for (const auto& s : series_)
+    {
+        if (std::none_of(
+                families.begin(), families.end(), [&](const auto* f) { return *f == s->name; }))
+        {
+            families.push_back(&s->name);
+        }
+    }
+
+    std::string out;
+    out.reserve(series_.size() * 96);
+    for (const std::string* family : families)
+    {
+        bool header = false;
+        for (const auto& s : series_)
+        {
+            if (s->name != *family)
+            {
+                continue;
+            }
+            if (!header)
+            {
+                header = true;
+                out += "# HELP " + s->name + " " + s->help + "\n";
+                out += "# TYPE " + s->name + " " + type_name(s->type) + "\n";
+            }
+
+            std::vector<sample> samples;
+            expand(*s, samples);
+            for (const auto& sample : samples)
+            {
+                out += sample.name;
+                if (!sample.labels.empty())
+                {
+                    out += "{" + sample.labels + "}";
+                }
+                out += " " + std::to_string(sample.value) + "\n";
+            }
+        }
+    }
+    if (openmetrics)
+    {
+        out += "# EOF\n";
+    }
+    return out;
+}
+
+//------------------------------------------------------------------------------
+// statsd_exporter
+//------------------------------------------------------------------------------
+
+namespace
+{
+// `allocator="main",type="BFC"` -> {("allocator", "main"), ("type", "BFC")}
+std::vector<std::pair<std::string, std::string>> parse_labels(const std::string& labels)
+{
+    std::vector<std::pair<std::string, std::string>> result;
+    size_t                                           pos = 0;
+    while (pos < labels.size())
+    {
+        size_t const eq = labels.find('=', pos);
+        if (eq == std::string::npos)
+        {
+            break;
+        }
+        std::string key = labels.substr(pos, eq - pos);
+        std::string value;
+        size_t      next = eq + 1;
+        if (next < labels.size() && labels[next] == '"')
+        {
+            ++next;
+            while (next < labels.size() && labels[next] != '"')
+            {
+                if (labels[next] == '\\' && next + 1 < labels.size())
+                {
+                    ++next;
+                }
+                value += labels[next++];
+            }
+            ++next;  // closing quote
+        }
+        else
+        {
+            size_t const comma = std::min(labels.find(',', next), labels.size());
+            value              = labels.substr(next, comma - next);
+            next               = comma;
+        }
+        result.emplace_back(std::move(key), std::move(value));
+        pos = labels.find(',', next);
+        pos = pos == std::string::npos ? labels.size() : pos + 1;
+    }
+    return result;
+}
+
+// StatsD reserves ':', '|' and '@'; dots separate name parts.
+std::string sanitize(const std::string& part)
+{
+    std::string out = part;
+    for (char& c : out)
+    {
+        if (c == ':' || c == '|' || c == '@' || c == '.' || c == ' ' || c == ',' || c == '#')
+        {
+            c = '_';
+        }
+    }
+    return out;
+}
+}  // namespace
+
+statsd_exporter::statsd_exporter(const metrics_registry& registry, config cfg, sender_fn sender)
+    : registry_(registry), config_(std::move(cfg)), sender_(std::move(sender))
+{
+}
+
+statsd_exporter::~statsd_exporter()
+{
+    stop();
+    close_socket();
+}
+
+bool statsd_exporter::start()
+{
+    if (running_.load())
+    {
+        return false;
+    }
+    if (!sender_ && !open_socket())
+    {
+        return false;
+    }
+    running_.store(true);
+    thread_ = std::thread(&statsd_exporter::run, this);
+    return true;
+}
+
+void statsd_exporter::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    {
+        std::scoped_lock const lock(wake_mutex_);
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+    push_now();
+}
+
+void statsd_exporter::run()
+{
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (running_.load())
+    {
+        wake_.wait_for(lock, config_.interval, [this] { return !running_.load(); });
+        if (!running_.load())
+        {
+            break;
+        }
+        lock.unlock();
+        push_now();
+        lock.lock();
+    }
+}
+
+size_t statsd_exporter::push_now()
+{
+    const auto samples = registry_.collect();
+
+    std::scoped_lock const lock(push_mutex_);
+
+    std::vector<std::pair<std::string, int64_t>> counters;
+    std::string                                  datagram;
+    size_t                                       sent = 0;
+    auto                                         send = [&](const std::string& payload)
+    {
+        if (sender_)
+        {
+            sender_(payload);
+        }
+        else
+        {
+            send_udp(payload);
+        }
+        ++sent;
+    };
+
+    for (const auto& s : samples)
+    {
+        const auto labels = parse_labels(s.labels);
+
+        std::string name = config_.prefix.empty() ? "" : config_.prefix + ".";
+        name += sanitize(s.name);
+        if (!config_.dogstatsd_tags)
+        {
+            for (const auto& [key, value] : labels)
+            {
+                name += "." + sanitize(value);
+            }
+        }
+
+        int64_t value = s.value;
+        if (s.type == metric_type::counter)
+        {
+            const std::string key = s.name + "{" + s.labels + "}";
+            auto              it  = std::find_if(
+                last_counters_.begin(),
+                last_counters_.end(),
+                [&](const auto& entry) { return entry.first == key; });
+            const int64_t previous = it == last_counters_.end() ? 0 : it->second;
+            counters.emplace_back(key, s.value);
+            // A counter that went down was reset; report its new total.
+            value = s.value >= previous ? s.value - previous : s.value;
+            if (value == 0)
+            {
+                continue;
+            }
+        }
+
+        std::string line =
+            name + ":" + std::to_string(value) + (s.type == metric_type::counter ? "|c" : "|g");
+        if (config_.dogstatsd_tags && !labels.empty())
+        {
+            line += "|#";
+            for (size_t i = 0; i < labels.size(); ++i)
+            {
+                line += (i > 0 ? "," : "") + sanitize(labels[i].first) + ":" +
+                        sanitize(labels[i].second);
+            }
+        }
+
+        if (!datagram.empty() && datagram.size() + 1 + line.size() > config_.max_datagram_bytes)
+        {
+            send(datagram);
+            datagram.clear();
+        }
+        datagram += (datagram.empty() ? "" : "\n") + line;
+    }
+    if (!datagram.empty())
+    {
+        send(datagram);
+    }
+
+    last_counters_ = std::move(counters);
+    return sent;
+}
+
+#ifndef _WIN32
+bool statsd_exporter::open_socket()
+{
+    if (socket_ >= 0)
+    {
+        return true;
+    }
+
+    addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo*         result = nullptr;
+    std::string const port   = std::to_string(config_.port);
+    if (getaddrinfo(config_.host.c_str(), port.c_str(), &hints, &result) != 0)
+    {
+        QUARISMA_LOG_ERROR("statsd_exporter: cannot resolve {}:{}", config_.host, config_.port);
+        return false;
+    }
+
+    for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next)
+    {
+        int const fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+        {
+            continue;
+        }
+        // A connected UDP socket needs no address per send.
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            socket_ = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(result);
+
+    if (socket_ < 0)
+    {
+        QUARISMA_LOG_ERROR(
+            "statsd_exporter: cannot open a UDP socket to {}:{}", config_.host, config_.port);
+        return false;
+    }
+    return true;
+}
+
+void statsd_exporter::close_socket()
+{
+    if (socket_ >= 0)
+    {
+        ::close(socket_);
+        socket_ = -1;
+    }
+}
+
+void statsd_exporter::send_udp(const std::string& datagram) const
+{
+    if (socket_ >= 0)
+    {
+        // StatsD is fire-and-forget: a lost datagram is not retried.
+        (void)::send(socket_, datagram.data(), datagram.size(), 0);
+    }
+}
+#else
+bool statsd_exporter::open_socket()
+{
+    QUARISMA_LOG_ERROR("statsd_exporter: no UDP transport on this platform, pass a sender");
+    return false;
+}
+
+void statsd_exporter::close_socket() {}
+
+void statsd_exporter::send_udp(const std::string& /*datagram*/) const {}
+#endif
+
+}  // namespace quarisma
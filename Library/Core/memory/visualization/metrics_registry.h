@@ -0,0 +1,286 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/configure.h"
+#include "common/macros.h"
+#include "memory/unified_memory_stats.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief Kind of a metric series, as exported to Prometheus / OpenMetrics
+ */
+enum class metric_type
+{
+    counter,  ///< Monotonic total
+    gauge,    ///< Current value
+    summary   ///< Quantiles of a latency_histogram, with `_sum` and `_count`
+};
+
+/**
+ * @brief Handle to a registry-owned counter, updated in place
+ *
+ * A default-constructed handle is unbound and its updates do nothing, so code
+ * can keep a handle unconditionally and pay one branch when no registry is
+ * attached.
+ */
+class metric_counter
+{
+public:
+    metric_counter() = default;
+    explicit metric_counter(std::atomic<int64_t>* cell) : cell_(cell) {}
+
+    void increment(int64_t delta = 1) const noexcept
+    {
+        if (cell_ != nullptr)
+        {
+            cell_->fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+
+    int64_t value() const noexcept
+    {
+        return cell_ != nullptr ? cell_->load(std::memory_order_relaxed) : 0;
+    }
+
+    bool bound() const noexcept { return cell_ != nullptr; }
+
+private:
+    std::atomic<int64_t>* cell_ = nullptr;
+};
+
+/**
+ * @brief Handle to a registry-owned gauge, updated in place
+ */
+class metric_gauge
+{
+public:
+    metric_gauge() = default;
+    explicit metric_gauge(std::atomic<int64_t>* cell) : cell_(cell) {}
+
+    void set(int64_t value) const noexcept
+    {
+        if (cell_ != nullptr)
+        {
+            cell_->store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void add(int64_t delta) const noexcept
+    {
+        if (cell_ != nullptr)
+        {
+            cell_->fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+
+    int64_t value() const noexcept
+    {
+        return cell_ != nullptr ? cell_->load(std::memory_order_relaxed) : 0;
+    }
+
+    bool bound() const noexcept { return cell_ != nullptr; }
+
+private:
+    std::atomic<int64_t>* cell_ = nullptr;
+};
+
+/**
+ * @brief Registry of pre-registered metric series read without locking their owners
+ *
+ * Each series is a name, a label set such as `allocator="main",type="BFC"`
+ * and a value cell. The cell is either owned by the registry, and updated
+ * through a metric_counter / metric_gauge handle, or borrowed: an atomic the
+ * owner already maintains (e.g. an allocator's allocator_stats), which the
+ * registry only loads. Scrapes therefore never call into the owner and never
+ * take its locks; the registry mutex only guards registration.
+ *
+ * **Thread Safety**: Thread-safe. Handles and borrowed cells must outlive
+ * their series; remove them with remove_series() first.
+ */
+class QUARISMA_VISIBILITY metrics_registry
+{
+public:
+    /**
+     * @brief One exported value
+     */
+    struct sample
+    {
+        std::string name;
+        std::string labels;
+        metric_type type;
+        int64_t     value;
+    };
+
+    metrics_registry() = default;
+    QUARISMA_DELETE_COPY_AND_MOVE(metrics_registry)
+
+    /**
+     * @brief Register a registry-owned counter
+     * @param name Metric name, e.g. "memory_allocations_total"
+     * @param help One-line description exported as `# HELP`
+     * @param labels Label set without braces, may be empty
+     */
+    QUARISMA_API metric_counter
+    add_counter(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /**
+     * @brief Register a registry-owned gauge
+     */
+    QUARISMA_API metric_gauge
+    add_gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /**
+     * @brief Export an atomic maintained by its owner
+     *
+     * The registry only performs relaxed loads of `source`.
+     */
+    QUARISMA_API void bind(
+        const std::string&          name,
+        const std::string&          help,
+        const std::string&          labels,
+        metric_type                 type,
+        const std::atomic<int64_t>* source);
+
+    /**
+     * @brief Export a latency_histogram as a summary, in nanoseconds
+     *
+     * Each scrape snapshots the histogram and exports `name{quantile="q"}`
+     * for q in kSummaryQuantiles, then `name_sum` and `name_count`.
+     */
+    QUARISMA_API void bind_latency(
+        const std::string&       name,
+        const std::string&       help,
+        const std::string&       labels,
+        const latency_histogram* source);
+
+    /// Quantiles exported for each bound latency_histogram
+    static constexpr double kSummaryQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    /**
+     * @brief Remove every series with exactly this label set
+     * @return Number of series removed
+     */
+    QUARISMA_API size_t remove_series(const std::string& labels);
+
+    /**
+     * @brief Current value of every series, in registration order
+     */
+    QUARISMA_API std::vector<sample> collect() const;
+
+    /**
+     * @brief Prometheus text exposition of all series
+     * @param openmetrics Terminate with `# EOF` as the OpenMetrics format requires
+     */
+    QUARISMA_API std::string export_text(bool openmetrics = false) const;
+
+    /**
+     * @brief Value of one series, or 0 if it does not exist
+     */
+    QUARISMA_API int64_t value(const std::string& name, const std::string& labels) const;
+
+private:
+    struct series
+    {
+        std::string                 name;
+        std::string                 help;
+        std::string                 labels;
+        metric_type                 type;
+        std::atomic<int64_t>        owned{0};
+        const std::atomic<int64_t>* source    = nullptr;  ///< owned or borrowed cell
+        const latency_histogram*    histogram = nullptr;  ///< summary source instead
+    };
+
+    // Appends the samples of one series: one, or several for a summary
+    static void expand(const series& s, std::vector<sample>& out);
+
+    series& add_series(
+        const std::string& name,
+        const std::string& help,
+        const std::string& labels,
+        metric_type        type);
+
+    mutable std::mutex                   mutex_;
+    std::vector<std::unique_ptr<series>> series_;
+};
+
+/**
+ * @brief Periodically pushes a metrics_registry as StatsD datagrams
+ *
+ * Gauges are sent as `prefix.name.label_values:value|g` and counters as the
+ * delta since the previous push, `|c`; with `dogstatsd_tags` the labels are
+ * sent as `|#key:value` tags instead of name parts. Lines are packed into
+ * datagrams of at most `max_datagram_bytes`. By default they are sent over
+ * UDP to host:port; a custom sender can be supplied instead, e.g. for tests
+ * or another transport.
+ */
+class QUARISMA_VISIBILITY statsd_exporter
+{
+public:
+    using sender_fn = std::function<void(const std::string& datagram)>;
+
+    struct config
+    {
+        std::string               host   = "127.0.0.1";
+        int                       port   = 8125;
+        std::string               prefix = "quarisma";
+        std::chrono::milliseconds interval{1000};
+        size_t                    max_datagram_bytes = 1432;   ///< Fits an Ethernet MTU
+        bool                      dogstatsd_tags     = false;  ///< Labels as DogStatsD tags
+    };
+
+    QUARISMA_API statsd_exporter(
+        const metrics_registry& registry, config cfg, sender_fn sender = nullptr);
+    QUARISMA_API ~statsd_exporter();
+    QUARISMA_DELETE_COPY_AND_MOVE(statsd_exporter)
+
+    /**
+     * @brief Start the background push thread
+     * @return False if it is already running or the UDP socket could not be opened
+     */
+    QUARISMA_API bool start();
+
+    /**
+     * @brief Stop the push thread after a final push
+     */
+    QUARISMA_API void stop();
+
+    /**
+     * @brief Format and send one round of datagrams now
+     * @return Number of datagrams sent
+     */
+    QUARISMA_API size_t push_now();
+
+private:
+    void run();
+    bool open_socket();
+    void close_socket();
+    void send_udp(const std::string& datagram) const;
+
+    const metrics_registry& registry_;
+    config                  config_;
+    sender_fn               sender_;
+
+    std::mutex                                   push_mutex_;
+    std::vector<std::pair<std::string, int64_t>> last_counters_;  ///< (series key, value)
+    int                                          socket_ = -1;    ///< Connected UDP socket
+
+    std::atomic<bool>       running_{false};
+    std::mutex              wake_mutex_;
+    std::condition_variable wake_;
+    std::thread             thread_;
+};
+
+}  // namespace quarisma
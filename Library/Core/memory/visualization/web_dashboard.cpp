@@ -10,10 +10,12 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "logging/logger.h"
 #include "memory/cpu/allocator.h"
+#include "memory/visualization/metrics_registry.h"
 
 namespace quarisma
 {
@@ -106,6 +108,10 @@ bool web_dashboard::register_allocator(const std::string& name, Allocator* alloc
     info.last_update   = std::chrono::steady_clock::now();
 
     registered_allocators_[name] = info;
+    if (!add_allocator_metrics(info))
+    {
+        QUARISMA_LOG_WARNING("Allocator {} provides no statistics, exporting no metrics", name);
+    }
 
     QUARISMA_LOG_INFO("Registered allocator: {} (type: {})", name, info.type);
     return true;
@@ -124,6 +130,13 @@ bool web_dashboard::unregister_allocator(const std::string& name)
 
     registered_allocators_.erase(it);
 
+    auto metrics_it = allocator_metrics_.find(name);
+    if (metrics_it != allocator_metrics_.end())
+    {
+        metrics_.remove_series(metrics_it->second.labels);
+        allocator_metrics_.erase(metrics_it);
+    }
+
     // Also remove history
     {
         std::scoped_lock const history_lock(history_mutex_);
@@ -159,8 +172,8 @@ std::string web_dashboard::get_allocator_metrics_json(const std::string& allocat
         return R"({"error": "Allocator not found"})";
     }
 
-    const auto& info      = it->second;
-    auto        stats_opt = info.allocator_ptr->GetStats();
+    const auto& info       = it->second;
+    auto        metrics_it = allocator_metrics_.find(allocator_name);
 
     std::ostringstream json;
     json << "{\n";
@@ -177,15 +190,32 @@ std::string web_dashboard::get_allocator_metrics_json(const std::string& allocat
          << R"(,
 )";
 
-    if (stats_opt.has_value())
+    if (metrics_it != allocator_metrics_.end())
     {
-        const auto& stats = stats_opt.value();
+        const std::string& labels = metrics_it->second.labels;
         json << "  \"stats\": {\n";
-        json << "    \"bytes_in_use\": " << stats.bytes_in_use << ",\n";
-        json << "    \"peak_bytes_in_use\": " << stats.peak_bytes_in_use << ",\n";
-        json << "    \"num_allocs\": " << stats.num_allocs << ",\n";
-        json << "    \"bytes_limit\": " << stats.bytes_limit << ",\n";
-        json << "    \"largest_alloc_size\": " << stats.largest_alloc_size << ",\n";
+        json << "    \"bytes_in_use\": " << metrics_.value("memory_bytes_allocated", labels)
+             << ",\n";
+        json << "    \"peak_bytes_in_use\": "
+             << metrics_.value("memory_peak_bytes_allocated", labels) << ",\n";
+        json << "    \"num_allocs\": " << metrics_.value("memory_allocations_total", labels)
+             << ",\n";
+        json << "    \"bytes_limit\": " << metrics_.value("memory_bytes_limit", labels) << ",\n";
+        json << "    \"largest_alloc_size\": "
+             << metrics_.value("memory_largest_allocation_bytes", labels) << ",\n";
+        for (auto const& [key, histogram] :
+             {std::pair{"alloc_latency_ns", info.allocator_ptr->allocation_latency()},
+              std::pair{"dealloc_latency_ns", info.allocator_ptr->deallocation_latency()}})
+        {
+            if (histogram != nullptr)
+            {
+                auto const latency = histogram->snapshot();
+                json << "    \"" << key << "\": {\"p50\": " << latency.percentile_ns(50.0)
+                     << ", \"p99\": " << latency.percentile_ns(99.0)
+                     << ", \"p999\": " << latency.percentile_ns(99.9)
+                     << ", \"max\": " << latency.max_ns << "},\n";
+            }
+        }
         json << "    \"fragmentation_ratio\": " << std::fixed << std::setprecision(4) << 0.0
              << "\n";
         json << "  }\n";
@@ -299,47 +329,79 @@ std::string web_dashboard::get_all_allocators_summary_json() const
     return json.str();
 }
 
-std::string web_dashboard::export_prometheus_metrics() const
+void web_dashboard::add_latency_series(
+    const std::string&       name,
+    const std::string&       help,
+    const std::string&       labels,
+    const latency_histogram* histogram)
 {
-    std::scoped_lock const lock(allocators_mutex_);
-
-    std::ostringstream prometheus;
-
-    // Add help and type information
-    prometheus << "# HELP memory_allocations_total Total number of allocations\n";
-    prometheus << "# TYPE memory_allocations_total counter\n";
-
-    prometheus << "# HELP memory_bytes_allocated Current bytes allocated\n";
-    prometheus << "# TYPE memory_bytes_allocated gauge\n";
-
-    prometheus << "# HELP memory_peak_bytes_allocated Peak bytes allocated\n";
-    prometheus << "# TYPE memory_peak_bytes_allocated gauge\n";
-
-    prometheus << "# HELP memory_fragmentation_ratio Memory fragmentation ratio\n";
-    prometheus << "# TYPE memory_fragmentation_ratio gauge\n";
+    metrics_.bind_latency(name, help, labels, histogram);
+}
 
-    // Export metrics for each allocator
-    for (const auto& [name, info] : registered_allocators_)
+bool web_dashboard::register_result_cache(const std::string& name, const result_cache* cache)
+{
+    std::string const labels = "cache=\"" + name + "\"";
+    auto const samples = metrics_.collect();
+    if (std::any_of(
+            samples.begin(), samples.end(), [&](const auto& s) { return s.labels == labels; }))
     {
-        auto stats_opt = info.allocator_ptr->GetStats();
-        if (!stats_opt.has_value())
-        {
-            continue;
-        }
+        QUARISMA_LOG_WARNING("Result cache already registered: {}", name);
+        return false;
+    }
 
-        const auto& stats = stats_opt.value();
+    const auto& counters = cache->counters();
+    metrics_.bind(
+        "result_cache_hits_total",
+        "Lookups served from the cache",
+        labels,
+        metric_type::counter,
+        &counters.hits);
+    metrics_.bind(
+        "result_cache_misses_total",
+        "Lookups that computed the result",
+        labels,
+        metric_type::counter,
+        &counters.misses);
+    metrics_.bind(
+        "result_cache_coalesced_total",
+        "Misses that waited on a computation already running",
+        labels,
+        metric_type::counter,
+        &counters.coalesced);
+    metrics_.bind(
+        "result_cache_evictions_total",
+        "Results evicted to stay within the byte budget",
+        labels,
+        metric_type::counter,
+        &counters.evictions);
+    metrics_.bind(
+        "result_cache_rejections_total",
+        "Results not admitted",
+        labels,
+        metric_type::counter,
+        &counters.rejections);
+    metrics_.bind(
+        "result_cache_failures_total",
+        "Computations that threw",
+        labels,
+        metric_type::counter,
+        &counters.failures);
+    metrics_.bind(
+        "result_cache_entries", "Results cached", labels, metric_type::gauge, &counters.entries);
+    metrics_.bind(
+        "result_cache_bytes", "Bytes of results cached", labels, metric_type::gauge, &counters.bytes);
+    return true;
+}
 
-        prometheus << "memory_allocations_total{allocator=\"" << name << "\",type=\"" << info.type
-                   << "\"} " << stats.num_allocs << "\n";
-        prometheus << "memory_bytes_allocated{allocator=\"" << name << "\",type=\"" << info.type
-                   << "\"} " << stats.bytes_in_use << "\n";
-        prometheus << "memory_peak_bytes_allocated{allocator=\"" << name << "\",type=\""
-                   << info.type << "\"} " << stats.peak_bytes_in_use << "\n";
-        prometheus << "memory_fragmentation_ratio{allocator=\"" << name << "\",type=\"" << info.type
-                   << "\"} " << 0.0 << "\n";
-    }
+bool web_dashboard::unregister_result_cache(const std::string& name)
+{
+    return metrics_.remove_series("cache=\"" + name + "\"") > 0;
+}
 
-    return prometheus.str();
+std::string web_dashboard::export_prometheus_metrics() const
+{
+    // Reads the registry only; allocators are not called and their locks are not taken.
+    return metrics_.export_text();
 }
 
 size_t web_dashboard::get_connected_clients_count() const
@@ -397,20 +459,27 @@ void web_dashboard::collect_metrics()
 
     for (auto& [name, info] : registered_allocators_)
     {
-        auto stats_opt = info.allocator_ptr->GetStats();
-        if (!stats_opt.has_value())
+        auto metrics_it = allocator_metrics_.find(name);
+        if (metrics_it == allocator_metrics_.end())
         {
             continue;
         }
 
-        const auto& stats = stats_opt.value();
+        auto& metrics = metrics_it->second;
+        if (!metrics.live)
+        {
+            poll_allocator_metrics(info, metrics);
+        }
 
         // Create history point
         metrics_history_point point;
-        point.timestamp            = now;
-        point.bytes_in_use         = stats.bytes_in_use;
-        point.peak_bytes_in_use    = stats.peak_bytes_in_use;
-        point.num_allocs           = stats.num_allocs;
+        point.timestamp = now;
+        point.bytes_in_use =
+            static_cast<size_t>(metrics_.value("memory_bytes_allocated", metrics.labels));
+        point.peak_bytes_in_use =
+            static_cast<size_t>(metrics_.value("memory_peak_bytes_allocated", metrics.labels));
+        point.num_allocs =
+            static_cast<size_t>(metrics_.value("memory_allocations_total", metrics.labels));
         point.fragmentation_metric = 0.0;  // Placeholder - fragmentation calculation not available
         point.allocation_rate      = calculate_allocation_rate(name);
 
@@ -446,6 +515,103 @@ void web_dashboard::broadcast_metrics_update(const std::string& /*metrics_json*/
     }
 }
 
+bool web_dashboard::add_allocator_metrics(const allocator_info& info)
+{
+    allocator_metrics metrics;
+    metrics.labels            = "allocator=\"" + info.name + "\",type=\"" + info.type + "\"";
+    const std::string& labels = metrics.labels;
+
+    if (const allocator_stats* live = info.allocator_ptr->live_stats())
+    {
+        // Borrow the counters the allocator already maintains.
+        metrics.live = true;
+        metrics_.bind(
+            "memory_allocations_total",
+            "Total number of allocations",
+            labels,
+            metric_type::counter,
+            &live->num_allocs);
+        metrics_.bind(
+            "memory_bytes_allocated",
+            "Current bytes allocated",
+            labels,
+            metric_type::gauge,
+            &live->bytes_in_use);
+        metrics_.bind(
+            "memory_peak_bytes_allocated",
+            "Peak bytes allocated",
+            labels,
+            metric_type::gauge,
+            &live->peak_bytes_in_use);
+        metrics_.bind(
+            "memory_bytes_limit",
+            "Memory limit of the allocator",
+            labels,
+            metric_type::gauge,
+            &live->bytes_limit);
+        metrics_.bind(
+            "memory_largest_allocation_bytes",
+            "Largest single allocation",
+            labels,
+            metric_type::gauge,
+            &live->largest_alloc_size);
+    }
+    else if (info.allocator_ptr->GetStats().has_value())
+    {
+        metrics.num_allocs =
+            metrics_.add_counter("memory_allocations_total", "Total number of allocations", labels);
+        metrics.bytes_in_use =
+            metrics_.add_gauge("memory_bytes_allocated", "Current bytes allocated", labels);
+        metrics.peak_bytes_in_use =
+            metrics_.add_gauge("memory_peak_bytes_allocated", "Peak bytes allocated", labels);
+        metrics.bytes_limit =
+            metrics_.add_gauge("memory_bytes_limit", "Memory limit of the allocator", labels);
+        metrics.largest_alloc_size = metrics_.add_gauge(
+            "memory_largest_allocation_bytes", "Largest single allocation", labels);
+        poll_allocator_metrics(info, metrics);
+    }
+    else
+    {
+        return false;
+    }
+
+    // Placeholder - fragmentation calculation not available
+    metrics_.add_gauge("memory_fragmentation_ratio", "Memory fragmentation ratio", labels);
+
+    if (const latency_histogram* latency = info.allocator_ptr->allocation_latency())
+    {
+        metrics_.bind_latency(
+            "memory_allocation_latency_ns", "Allocation latency in nanoseconds", labels, latency);
+    }
+    if (const latency_histogram* latency = info.allocator_ptr->deallocation_latency())
+    {
+        metrics_.bind_latency(
+            "memory_deallocation_latency_ns",
+            "Deallocation latency in nanoseconds",
+            labels,
+            latency);
+    }
+
+    allocator_metrics_[info.name] = std::move(metrics);
+    return true;
+}
+
+void web_dashboard::poll_allocator_metrics(const allocator_info& info, allocator_metrics& metrics)
+{
+    auto stats_opt = info.allocator_ptr->GetStats();
+    if (!stats_opt.has_value())
+    {
+        return;
+    }
+
+    const auto& stats = stats_opt.value();
+    metrics.num_allocs.increment(stats.num_allocs - metrics.num_allocs.value());
+    metrics.bytes_in_use.set(stats.bytes_in_use);
+    metrics.peak_bytes_in_use.set(stats.peak_bytes_in_use);
+    metrics.bytes_limit.set(stats.bytes_limit);
+    metrics.largest_alloc_size.set(stats.largest_alloc_size);
+}
+
 std::string web_dashboard::get_allocator_type_name(Allocator* allocator)
 {
     if (allocator == nullptr)
@@ -13,7 +13,9 @@
 
 #include "common/configure.h"
 #include "memory/cpu/allocator.h"
+#include "memory/result_cache.h"
 #include "memory/unified_memory_stats.h"
+#include "memory/visualization/metrics_registry.h"
 
 namespace quarisma
 {
@@ -24,6 +26,10 @@ namespace quarisma
  * Provides HTTP server with REST API endpoints for querying allocator metrics,
  * real-time updates via WebSocket, and JSON export capabilities. Designed for
  * development and debugging of memory allocation patterns.
+ *
+ * Each registered allocator is exported through a metrics_registry. Allocators
+ * that expose Allocator::live_stats() are read without taking their locks; the
+ * others are polled with GetStats() once per update interval.
  * 
  * **Thread Safety**: Thread-safe for concurrent access
  * **Performance**: Minimal overhead when disabled, configurable update intervals
@@ -180,6 +186,55 @@ public:
      */
     QUARISMA_API std::string export_prometheus_metrics() const;
 
+    /**
+     * @brief Registry holding the series of all registered allocators
+     *
+     * Attach a statsd_exporter to it to push the metrics instead of
+     * scraping them:
+     * ```cpp
+     * statsd_exporter exporter(dashboard.metrics(), {});
+     * exporter.start();
+     * ```
+     */
+    const metrics_registry& metrics() const { return metrics_; }
+
+    /**
+     * @brief Export another latency histogram next to the allocators' ones
+     *
+     * Registered allocators that measure their latencies (see
+     * Allocator::allocation_latency()) are exported automatically; this adds
+     * histograms kept elsewhere, which must outlive the dashboard:
+     * ```cpp
+     * dashboard.add_latency_series(
+     *     "gpu_transfer_async_latency_ns", "Async transfer latency", "",
+     *     &gpu::gpu_memory_transfer::instance().get_async_latency());
+     * dashboard.add_latency_series(
+     *     "pool_queue_wait_ns", "Thread pool queue wait", "pool=\"main\"",
+     *     &pool_instrumentation::queue_wait_latency("main"));
+     * ```
+     */
+    QUARISMA_API void add_latency_series(
+        const std::string&       name,
+        const std::string&       help,
+        const std::string&       labels,
+        const latency_histogram* histogram);
+
+    /**
+     * @brief Export the counters of a result_cache, labelled cache="name"
+     *
+     * Hits, misses, coalesced misses, evictions, admission rejections and
+     * failures as counters; entries and bytes as gauges. The cache must stay
+     * alive until unregister_result_cache().
+     *
+     * @return false if a cache of that name is already exported
+     */
+    QUARISMA_API bool register_result_cache(const std::string& name, const result_cache* cache);
+
+    /**
+     * @brief Stop exporting the counters of a result_cache
+     */
+    QUARISMA_API bool unregister_result_cache(const std::string& name);
+
     /**
      * @brief Check if dashboard is currently running
      * @return True if dashboard server is active
@@ -225,6 +280,21 @@ private:
     mutable std::mutex                              allocators_mutex_;
     std::unordered_map<std::string, allocator_info> registered_allocators_;
 
+    // Metric series, keyed by allocator name. Allocators without statistics
+    // have no entry.
+    struct allocator_metrics
+    {
+        std::string    labels;        ///< `allocator="name",type="type"`
+        bool           live = false;  ///< Bound to Allocator::live_stats()
+        metric_counter num_allocs;    ///< Polled handles, unbound when live
+        metric_gauge   bytes_in_use;
+        metric_gauge   peak_bytes_in_use;
+        metric_gauge   bytes_limit;
+        metric_gauge   largest_alloc_size;
+    };
+    metrics_registry                                   metrics_;
+    std::unordered_map<std::string, allocator_metrics> allocator_metrics_;
+
     // Metrics history
     mutable std::mutex                                                 history_mutex_;
     std::unordered_map<std::string, std::queue<metrics_history_point>> metrics_history_;
@@ -297,6 +367,17 @@ private:
      */
     static std::string get_allocator_type_name(Allocator* allocator);
 
+    /**
+     * @brief Register the metric series of one allocator
+     * @return False if the allocator provides no statistics
+     */
+    bool add_allocator_metrics(const allocator_info& info);
+
+    /**
+     * @brief Copy GetStats() into the polled handles of one allocator
+     */
+    static void poll_allocator_metrics(const allocator_info& info, allocator_metrics& metrics);
+
     /**
      * @brief Create JSON string from allocator stats
      * @param stats Allocator statistics
@@ -0,0 +1,394 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @class task
+ * @brief Awaitable coroutine task running on the parallel_thread_pool (C++20)
+ *
+ * A `task<T>` is a lazily started coroutine that produces a T. It starts when
+ * it is awaited, and resumes its awaiter when it completes, so chains of tasks
+ * never block a thread:
+ * - `co_await schedule()` moves the coroutine to a pool worker;
+ * - `co_await await_future(future)` suspends until a threaded_callback_queue
+ *   task has terminated, then resumes on a pool worker;
+ * - `gpu::async_transfer()` (memory/gpu/gpu_transfer_awaitable.h) does the same
+ *   for gpu_memory_transfer::transfer_async().
+ * A suspended coroutine holds no thread, unlike `shared_future_base::wait()` or
+ * `std::future::wait()` which park the caller; this is what lets I/O, device
+ * copies and compute overlap on a small pool.
+ *
+ * Exceptions thrown in a task are rethrown by `co_await`. `sync_wait()` runs a
+ * task from ordinary code and blocks until it is done.
+ *
+ * Only available when the compiler provides coroutines
+ * (QUARISMA_HAS_COROUTINES, e.g. with QUARISMA_CXX_STANDARD=20).
+ */
+
+#ifndef ASYNC_TASK_H
+#define ASYNC_TASK_H
+
+#include "common/macros.h"
+
+#if QUARISMA_HAS_COROUTINES
+
+#include <condition_variable>  // For std::condition_variable
+#include <coroutine>           // For std::coroutine_handle
+#include <exception>           // For std::exception_ptr
+#include <mutex>               // For std::mutex
+#include <optional>            // For std::optional
+#include <type_traits>         // For std::is_void
+#include <utility>             // For std::exchange
+
+#include "parallel/std_thread/parallel_thread_pool.h"
+#include "parallel/threaded_callback_queue.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+template <typename T = void>
+class task;
+
+/**
+ * Resume `handle` on a parallel_thread_pool worker.
+ */
+inline void resume_on_pool(std::coroutine_handle<> handle)
+{
+    detail::parallel::parallel_thread_pool::instance().post([handle]() { handle.resume(); });
+}
+
+namespace coroutine_detail
+{
+struct promise_base
+{
+    struct final_awaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        // Symmetric transfer to the awaiter: long chains do not grow the stack
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            return handle.promise().continuation_;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter       final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error_ = std::current_exception(); }
+
+    std::coroutine_handle<> continuation_{std::noop_coroutine()};
+    std::exception_ptr      error_;
+};
+
+template <typename T>
+struct promise : promise_base
+{
+    task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value)
+    {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T result()
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+        return std::move(*value_);
+    }
+
+    std::optional<T> value_;
+};
+
+template <>
+struct promise<void> : promise_base
+{
+    task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void result() const
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+    }
+};
+}  // namespace coroutine_detail
+
+template <typename T>
+class [[nodiscard]] task
+{
+    static_assert(!std::is_reference<T>::value, "task<T> cannot return a reference");
+
+public:
+    using promise_type = coroutine_detail::promise<T>;
+
+    task() noexcept = default;
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task& operator=(task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_)
+            {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    task(const task&)            = delete;
+    task& operator=(const task&) = delete;
+
+    ~task()
+    {
+        if (handle_)
+        {
+            handle_.destroy();
+        }
+    }
+
+    /**
+   * True once the coroutine has run to completion.
+   */
+    bool is_ready() const noexcept { return !handle_ || handle_.done(); }
+
+    /**
+   * Start the task, or take its result if it already completed. The result is
+   * moved out: a task is awaited once.
+   */
+    auto operator co_await()
+    {
+        struct awaiter
+        {
+            std::coroutine_handle<promise_type> handle_;
+
+            bool await_ready() const noexcept { return handle_.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle_.promise().continuation_ = awaiting;
+                return handle_;
+            }
+
+            T await_resume() { return handle_.promise().result(); }
+        };
+
+        QUARISMA_CHECK(handle_, "Awaiting an empty task");
+        return awaiter{handle_};
+    }
+
+private:
+    friend struct coroutine_detail::promise<T>;
+
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace coroutine_detail
+{
+template <typename T>
+task<T> promise<T>::get_return_object() noexcept
+{
+    return task<T>{std::coroutine_handle<promise<T>>::from_promise(*this)};
+}
+
+inline task<void> promise<void>::get_return_object() noexcept
+{
+    return task<void>{std::coroutine_handle<promise<void>>::from_promise(*this)};
+}
+
+// Coroutine driving sync_wait(): signals the blocked caller from its final suspension point
+struct sync_wait_state
+{
+    std::mutex              mutex_;
+    std::condition_variable done_cv_;
+    bool                    done_ = false;
+};
+
+struct sync_wait_runner
+{
+    struct promise_type
+    {
+        sync_wait_state* state_ = nullptr;
+
+        sync_wait_runner get_return_object() noexcept
+        {
+            return sync_wait_runner{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        auto final_suspend() const noexcept
+        {
+            struct notifier
+            {
+                bool await_ready() const noexcept { return false; }
+
+                // Nothing is touched after the unlock: the caller destroys the frame
+                void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+                {
+                    sync_wait_state&                  state = *handle.promise().state_;
+                    const std::lock_guard<std::mutex> lock(state.mutex_);
+                    state.done_ = true;
+                    state.done_cv_.notify_all();
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return notifier{};
+        }
+
+        void return_void() const noexcept {}
+
+        // The awaited task stores its own exception, run_and_store catches it
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+struct sync_wait_result
+{
+    std::optional<T>   value_;
+    std::exception_ptr error_;
+};
+
+template <>
+struct sync_wait_result<void>
+{
+    std::exception_ptr error_;
+};
+
+template <typename T>
+sync_wait_runner run_and_store(task<T>& awaited, sync_wait_result<T>& result)
+{
+    try
+    {
+        if constexpr (std::is_void<T>::value)
+        {
+            co_await awaited;
+        }
+        else
+        {
+            result.value_.emplace(co_await awaited);
+        }
+    }
+    catch (...)
+    {
+        result.error_ = std::current_exception();
+    }
+}
+}  // namespace coroutine_detail
+
+/**
+ * Awaitable that resumes the awaiting coroutine on a parallel_thread_pool worker.
+ */
+struct schedule_awaiter
+{
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> awaiting) const { resume_on_pool(awaiting); }
+    void await_resume() const noexcept {}
+};
+
+/**
+ * `co_await schedule()` continues the coroutine on a pool worker.
+ */
+inline schedule_awaiter schedule() noexcept
+{
+    return {};
+}
+
+/**
+ * Awaitable on a threaded_callback_queue future: suspends without blocking
+ * until the task has terminated, then resumes on a parallel_thread_pool worker.
+ * `co_await` returns `future->get()`.
+ */
+template <typename ReturnT>
+class future_awaiter
+{
+public:
+    using future_pointer = threaded_callback_queue::shared_future_pointer<ReturnT>;
+
+    explicit future_awaiter(future_pointer future) : future_(std::move(future)) {}
+
+    bool await_ready() const noexcept { return future_->is_ready(); }
+
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        return future_->on_ready([awaiting]() { resume_on_pool(awaiting); });
+    }
+
+    decltype(auto) await_resume() { return future_->get(); }
+
+private:
+    future_pointer future_;
+};
+
+template <typename ReturnT>
+future_awaiter<ReturnT> await_future(
+    threaded_callback_queue::shared_future_pointer<ReturnT> future)
+{
+    QUARISMA_CHECK(future != nullptr, "Awaiting a null future");
+    return future_awaiter<ReturnT>(std::move(future));
+}
+
+/**
+ * Run `awaited` to completion from ordinary code, blocking the calling thread,
+ * and return its result or rethrow its exception. Avoid calling it on a pool
+ * worker: that worker is parked until the task is done.
+ */
+template <typename T>
+T sync_wait(task<T> awaited)
+{
+    coroutine_detail::sync_wait_state     state;
+    coroutine_detail::sync_wait_result<T> result;
+    auto runner = coroutine_detail::run_and_store(awaited, result);
+    runner.handle_.promise().state_ = &state;
+    runner.handle_.resume();
+    {
+        std::unique_lock<std::mutex> lock(state.mutex_);
+        state.done_cv_.wait(lock, [&state] { return state.done_; });
+    }
+    runner.handle_.destroy();
+
+    if (result.error_)
+    {
+        std::rethrow_exception(result.error_);
+    }
+    if constexpr (!std::is_void<T>::value)
+    {
+        return std::move(*result.value_);
+    }
+}
+
+}  // namespace quarisma
+
+#endif  // QUARISMA_HAS_COROUTINES
+
+#endif  // ASYNC_TASK_H
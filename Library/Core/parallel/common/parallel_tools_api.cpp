@@ -25,6 +25,7 @@
 
 #include <algorithm>  // For std::toupper
 #include <cstdlib>    // For std::getenv
+#include <cstring>    // For std::strcmp
 #include <iostream>   // For std::cerr
 #include <string>     // For std::string
 
@@ -43,6 +44,12 @@ parallel_tools_api::parallel_tools_api()
     // Single backend instance is created as member variable (no dynamic allocation needed)
     // Set max thread number from env
     this->refresh_number_of_thread();
+
+    const char* deterministic = std::getenv("PARALLEL_DETERMINISTIC");
+    if (deterministic != nullptr && std::strcmp(deterministic, "1") == 0)
+    {
+        deterministic_.store(true, std::memory_order_relaxed);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -82,7 +89,14 @@ const char* parallel_tools_api::get_backend()
 }
 
 //------------------------------------------------------------------------------
-bool parallel_tools_api::set_backend(const char* type)
+local_scope_state& current_local_scope() noexcept
+{
+    thread_local local_scope_state state;
+    return state;
+}
+
+//------------------------------------------------------------------------------
+bool parallel_tools_api::validate_backend(const char* type)
 {
     // Check for null pointer
     if (type == nullptr)
@@ -95,7 +109,7 @@ bool parallel_tools_api::set_backend(const char* type)
     std::string backend(type);
     std::transform(backend.cbegin(), backend.cend(), backend.begin(), ::tolower);
 
-    const char* current_backend = this->get_backend();
+    const char* current_backend = parallel_tools_api::get_backend();
     std::string current_backend_upper(current_backend);
     std::transform(
         current_backend_upper.cbegin(),
@@ -109,6 +123,16 @@ bool parallel_tools_api::set_backend(const char* type)
                   << "\" but using \"" << current_backend << "\".\n";
         return false;
     }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool parallel_tools_api::set_backend(const char* type)
+{
+    if (!parallel_tools_api::validate_backend(type))
+    {
+        return false;
+    }
 
     this->refresh_number_of_thread();
     return true;
@@ -137,7 +161,7 @@ int parallel_tools_api::estimated_default_number_of_threads()
 //------------------------------------------------------------------------------
 int parallel_tools_api::estimated_number_of_threads()
 {
-    return backend_impl_.estimated_number_of_threads();
+    return scoped_number_of_threads(backend_impl_.estimated_number_of_threads());
 }
 
 //------------------------------------------------------------------------------
@@ -149,7 +173,19 @@ void parallel_tools_api::set_nested_parallelism(bool is_nested)
 //------------------------------------------------------------------------------
 bool parallel_tools_api::nested_parallelism()
 {
-    return backend_impl_.nested_parallelism();
+    return scoped_nested_parallelism(backend_impl_.nested_parallelism());
+}
+
+//------------------------------------------------------------------------------
+void parallel_tools_api::set_deterministic(bool is_deterministic)
+{
+    deterministic_.store(is_deterministic, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+bool parallel_tools_api::deterministic()
+{
+    return deterministic_.load(std::memory_order_relaxed);
 }
 
 //------------------------------------------------------------------------------
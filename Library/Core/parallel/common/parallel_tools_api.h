@@ -24,6 +24,9 @@
 #ifndef PARALLEL_TOOLS_API_H
 #define PARALLEL_TOOLS_API_H
 
+#include <algorithm>  // For std::min
+#include <atomic>     // For std::atomic
+#include <cstddef>    // For size_t
 #include <memory>
 
 #include "common/export.h"
@@ -87,6 +90,12 @@ public:
     //--------------------------------------------------------------------------------
     QUARISMA_API bool nested_parallelism();
 
+    //------------------------------------------------------------------------------
+    QUARISMA_API void set_deterministic(bool is_deterministic);
+
+    //--------------------------------------------------------------------------------
+    QUARISMA_API bool deterministic();
+
     //--------------------------------------------------------------------------------
     QUARISMA_API bool is_parallel_scope();
 
@@ -97,21 +106,38 @@ public:
     int get_internal_desired_number_of_thread() { return desired_number_of_thread_; }
 
     //------------------------------------------------------------------------------
+    /**
+     * Run `lambda` with the thread count and nesting policy of `config`.
+     *
+     * The overrides are stored per thread and restored when the lambda returns
+     * or throws, so concurrent callers can run with different budgets without
+     * reconfiguring the shared backend.
+     */
     template <typename Config, typename T>
     void local_scope(Config const& config, T&& lambda)
     {
-        const Config old_config(*this);
-        *this << config;
-        try
+        if (!config.backend_.empty())
         {
-            lambda();
+            parallel_tools_api::validate_backend(config.backend_.c_str());
         }
-        catch (...)
+
+        local_scope_state& state = current_local_scope();
+
+        struct scope_restorer
         {
-            *this << old_config;
-            throw;
+            local_scope_state& state_;
+            local_scope_state  saved_;
+            ~scope_restorer() { state_ = saved_; }
+        } restorer{state, state};
+
+        if (config.max_number_of_threads_ > 0)
+        {
+            state.max_number_of_threads_ = (std::min)(
+                config.max_number_of_threads_, this->estimated_default_number_of_threads());
         }
-        *this << old_config;
+        state.nested_parallelism_ = config.nested_parallelism_ ? 1 : 0;
+
+        lambda();
     }
 
     //--------------------------------------------------------------------------------
@@ -120,9 +146,21 @@ public:
     template <typename FunctorInternal>
     void parallel_for(size_t first, size_t last, size_t grain, FunctorInternal& fi)
     {
+        // In deterministic mode the chunks depend on the range only, never on the
+        // thread count or on a learned (adaptive) grain
+        if (grain == 0 && last > first && this->deterministic())
+        {
+            grain = (last - first - 1) / deterministic_max_blocks + 1;
+        }
         backend_impl_.parallel_for(first, last, grain, fi);
     }
 
+    /**
+     * Upper bound on the number of chunks of a range in deterministic mode. It
+     * is a constant, so that the partitioning is the same on every machine.
+     */
+    static constexpr size_t deterministic_max_blocks = 256;
+
     // disable copying
     parallel_tools_api(parallel_tools_api const&)  = delete;
     void operator=(parallel_tools_api const&) = delete;
@@ -135,20 +173,18 @@ private:
     QUARISMA_API void refresh_number_of_thread();
 
     //--------------------------------------------------------------------------------
-    template <typename Config>
-    parallel_tools_api& operator<<(Config const& config)
-    {
-        this->initialize(config.max_number_of_threads_);
-        this->set_backend(config.backend_.c_str());
-        this->set_nested_parallelism(config.nested_parallelism_);
-        return *this;
-    }
+    QUARISMA_API static bool validate_backend(const char* type);
 
     /**
    * Desired number of threads
    */
     int desired_number_of_thread_ = 0;
 
+    /**
+   * Deterministic execution mode, see parallel_tools::set_deterministic()
+   */
+    std::atomic<bool> deterministic_{false};
+
     /**
    * Single backend implementation selected at compile-time
    */
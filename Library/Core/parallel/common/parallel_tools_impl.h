@@ -36,6 +36,42 @@ namespace detail
 namespace parallel
 {
 
+/**
+ * @brief Per-thread overrides installed by parallel_tools::local_scope()
+ *
+ * The overrides only affect the thread that opened the scope. Worker threads of
+ * the std_thread pool inherit the state of the proxy whose job they execute, so
+ * nested loops observe the same thread budget and nesting policy.
+ */
+struct local_scope_state
+{
+    int max_number_of_threads_ = 0;   ///< Thread budget, 0 when not overridden
+    int nested_parallelism_    = -1;  ///< 0 or 1, -1 when not overridden
+};
+
+/**
+ * @brief Returns the calling thread's local scope state.
+ */
+QUARISMA_API local_scope_state& current_local_scope() noexcept;
+
+/**
+ * @brief Thread budget of the calling thread's local scope, or `fallback` if none.
+ */
+inline int scoped_number_of_threads(int fallback) noexcept
+{
+    const int scoped = current_local_scope().max_number_of_threads_;
+    return scoped > 0 ? scoped : fallback;
+}
+
+/**
+ * @brief Nesting policy of the calling thread's local scope, or `fallback` if none.
+ */
+inline bool scoped_nested_parallelism(bool fallback) noexcept
+{
+    const int scoped = current_local_scope().nested_parallelism_;
+    return scoped >= 0 ? scoped != 0 : fallback;
+}
+
 template <backend_type Backend>
 class parallel_tools_impl
 {
@@ -0,0 +1,483 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "parallel/heterogeneous_executor.h"
+
+#include <algorithm>  // For std::max, std::min
+#include <atomic>     // For std::atomic
+#include <chrono>     // For std::chrono::steady_clock
+#include <exception>  // For std::exception_ptr
+#include <mutex>      // For std::mutex
+#include <thread>     // For std::thread
+
+#include "common/configure.h"
+#include "parallel/parallel_tools.h"
+#include "util/exception.h"
+
+#if QUARISMA_HAS_CUDA
+#include "memory/gpu/gpu_device_manager.h"
+#include "memory/gpu/gpu_memory_transfer.h"
+#endif
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+// A worker without measurement claims this fraction of its equal share of the
+// remaining items, so that a slow device does not start with a large chunk
+constexpr std::size_t calibration_divisor = 16;
+
+// Guided scheduling: a worker claims 1 / guided_divisor of its share of the
+// remaining items (divided again among its pipeline slots), so that chunks
+// shrink towards the end of the range and the workers finish together
+constexpr std::size_t guided_divisor = 2;
+
+// Weight of the last run in the smoothed throughput
+constexpr double smoothing = 0.5;
+
+double seconds_since(clock_type::time_point start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+}  // namespace
+
+//=============================================================================
+struct heterogeneous_executor::worker
+{
+    explicit worker(quarisma::device_option device_) : device(device_) {}
+
+    quarisma::device_option device;
+
+    // Accumulated over the runs, updated once a run is over
+    std::size_t items        = 0;
+    double      busy_seconds = 0.0;
+    double      throughput   = 0.0;
+
+    // Measured during the current run by the worker's thread; live_throughput
+    // is read by the other workers to size their chunks
+    std::size_t         run_items   = 0;
+    double              run_seconds = 0.0;
+    std::atomic<double> live_throughput{0.0};
+
+#if QUARISMA_HAS_CUDA
+    // One stream per pipeline slot, created on first use
+    std::vector<std::unique_ptr<quarisma::gpu::gpu_stream>> streams;
+#endif
+
+    // Best estimate of the items per second of the worker, 0 if unknown
+    double estimate() const
+    {
+        const double live = live_throughput.load(std::memory_order_relaxed);
+        return live > 0.0 ? live : throughput;
+    }
+
+    void record(std::size_t count, double seconds)
+    {
+        run_items += count;
+        run_seconds = seconds;
+        if (run_seconds > 0.0)
+        {
+            live_throughput.store(
+                static_cast<double>(run_items) / run_seconds, std::memory_order_relaxed);
+        }
+    }
+};
+
+//=============================================================================
+struct heterogeneous_executor::run_state
+{
+    run_state(const batch& work_, std::vector<worker*> active_, std::size_t min_chunk_)
+        : work(work_), active(std::move(active_)), min_chunk(min_chunk_)
+    {
+    }
+
+    const batch&             work;
+    std::vector<worker*>     active;
+    std::size_t              min_chunk;
+    std::atomic<std::size_t> cursor{0};
+    std::mutex               error_mutex;
+    std::exception_ptr       error;
+
+    /**
+   * Number of items `w` claims out of `remaining`, for a worker with `slots`
+   * chunks in flight.
+   */
+    std::size_t chunk_size(const worker& w, std::size_t remaining, std::size_t slots) const
+    {
+        // Workers without measurement count as fast as the fastest known one
+        double      known_sum = 0.0;
+        double      known_max = 0.0;
+        std::size_t unknown   = 0;
+        for (const worker* other : active)
+        {
+            const double estimate = other->estimate();
+            known_sum += estimate;
+            known_max = (std::max)(known_max, estimate);
+            unknown += estimate > 0.0 ? 0 : 1;
+        }
+
+        std::size_t  chunk      = 0;
+        const double throughput = w.estimate();
+        if (throughput <= 0.0)
+        {
+            chunk = remaining / (calibration_divisor * active.size());
+        }
+        else
+        {
+            const double total = known_sum + static_cast<double>(unknown) * known_max;
+            const double share = throughput / total;
+            chunk              = static_cast<std::size_t>(
+                static_cast<double>(remaining) * share /
+                static_cast<double>(guided_divisor * slots));
+        }
+        return (std::min)((std::max)(chunk, min_chunk), remaining);
+    }
+
+    /**
+   * Claims the next chunk for `w`. Returns false once the range is exhausted
+   * or a callback failed.
+   */
+    bool claim(const worker& w, std::size_t slots, std::size_t& begin, std::size_t& end)
+    {
+        std::size_t current = cursor.load(std::memory_order_relaxed);
+        while (current < work.size)
+        {
+            const std::size_t count = this->chunk_size(w, work.size - current, slots);
+            if (cursor.compare_exchange_weak(current, current + count, std::memory_order_relaxed))
+            {
+                begin = current;
+                end   = current + count;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void fail(std::exception_ptr exception)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+            {
+                error = std::move(exception);
+            }
+        }
+        // Stops every worker at its next claim
+        cursor.store(work.size, std::memory_order_relaxed);
+    }
+};
+
+//-----------------------------------------------------------------------------
+heterogeneous_executor::heterogeneous_executor()
+{
+    workers_.push_back(
+        std::make_unique<worker>(quarisma::device_option(quarisma::device_enum::CPU, 0)));
+#if QUARISMA_HAS_CUDA
+    auto& manager = quarisma::gpu::gpu_device_manager::instance();
+    for (const auto& info : manager.get_available_devices())
+    {
+        if (info.device_type == quarisma::device_enum::CUDA &&
+            manager.is_device_available(info.device_type, info.device_index))
+        {
+            workers_.push_back(std::make_unique<worker>(
+                quarisma::device_option(quarisma::device_enum::CUDA, info.device_index)));
+        }
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+heterogeneous_executor::heterogeneous_executor(const std::vector<int>& gpu_devices)
+{
+    workers_.push_back(
+        std::make_unique<worker>(quarisma::device_option(quarisma::device_enum::CPU, 0)));
+#if QUARISMA_HAS_CUDA
+    for (const int device : gpu_devices)
+    {
+        QUARISMA_CHECK(device >= 0, "heterogeneous_executor: invalid CUDA device ", device);
+        workers_.push_back(std::make_unique<worker>(
+            quarisma::device_option(quarisma::device_enum::CUDA, device)));
+    }
+#else
+    (void)gpu_devices;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+heterogeneous_executor::~heterogeneous_executor() = default;
+
+//-----------------------------------------------------------------------------
+void heterogeneous_executor::set_pipeline_depth(std::size_t depth)
+{
+    pipeline_depth_ = (std::max)(depth, std::size_t{1});
+}
+
+//-----------------------------------------------------------------------------
+std::size_t heterogeneous_executor::get_pipeline_depth() const noexcept
+{
+    return pipeline_depth_;
+}
+
+//-----------------------------------------------------------------------------
+void heterogeneous_executor::set_min_chunk(std::size_t min_chunk)
+{
+    min_chunk_ = (std::max)(min_chunk, std::size_t{1});
+}
+
+//-----------------------------------------------------------------------------
+std::size_t heterogeneous_executor::get_min_chunk() const noexcept
+{
+    return min_chunk_;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t heterogeneous_executor::number_of_gpus() const noexcept
+{
+    return workers_.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<heterogeneous_executor::worker_stats> heterogeneous_executor::statistics() const
+{
+    std::vector<worker_stats> result;
+    result.reserve(workers_.size());
+    for (const auto& w : workers_)
+    {
+        result.push_back({w->device, w->items, w->busy_seconds, w->throughput});
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+void heterogeneous_executor::reset_statistics()
+{
+    for (auto& w : workers_)
+    {
+        w->items        = 0;
+        w->busy_seconds = 0.0;
+        w->throughput   = 0.0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void heterogeneous_executor::run(const batch& work)
+{
+    if (work.size == 0)
+    {
+        return;
+    }
+
+    worker&              cpu = *workers_.front();
+    std::vector<worker*> active;
+    if (work.cpu)
+    {
+        active.push_back(&cpu);
+    }
+    if (work.compute)
+    {
+        for (std::size_t i = 1; i < workers_.size(); ++i)
+        {
+            active.push_back(workers_[i].get());
+        }
+    }
+    QUARISMA_CHECK(
+        !active.empty(),
+        "heterogeneous_executor: the batch has neither a CPU kernel nor a GPU compute callback "
+        "for the ",
+        number_of_gpus(),
+        " GPUs of the executor");
+
+    for (worker* w : active)
+    {
+        w->run_items   = 0;
+        w->run_seconds = 0.0;
+        w->live_throughput.store(0.0, std::memory_order_relaxed);
+    }
+
+    run_state state(work, active, min_chunk_);
+
+    // The GPUs are driven from their own threads, which mostly wait on their
+    // streams; the calling thread drives the CPU pool
+    std::vector<std::thread> gpu_threads;
+    for (worker* w : active)
+    {
+        if (w != &cpu)
+        {
+            gpu_threads.emplace_back([this, &state, w] { this->run_gpu(state, *w); });
+        }
+    }
+    if (work.cpu)
+    {
+        this->run_cpu(state, cpu);
+    }
+    for (auto& thread : gpu_threads)
+    {
+        thread.join();
+    }
+
+    for (worker* w : active)
+    {
+        if (w->run_items == 0 || w->run_seconds <= 0.0)
+        {
+            continue;
+        }
+        const double measured = static_cast<double>(w->run_items) / w->run_seconds;
+        w->items += w->run_items;
+        w->busy_seconds += w->run_seconds;
+        if (w->throughput > 0.0)
+        {
+            w->throughput = (1.0 - smoothing) * w->throughput + smoothing * measured;
+        }
+        else
+        {
+            w->throughput = measured;
+        }
+    }
+
+    if (state.error)
+    {
+        std::rethrow_exception(state.error);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void heterogeneous_executor::run_cpu(run_state& state, worker& cpu)
+{
+    const auto& kernel = state.work.cpu;
+    std::size_t begin  = 0;
+    std::size_t end    = 0;
+    try
+    {
+        while (state.claim(cpu, 1, begin, end))
+        {
+            const auto start = clock_type::now();
+            // The pool does not propagate the exceptions of its workers
+            parallel_tools::parallel_for(
+                begin,
+                end,
+                0,
+                [&kernel, &state](std::size_t first, std::size_t last)
+                {
+                    try
+                    {
+                        kernel(first, last);
+                    }
+                    catch (...)
+                    {
+                        state.fail(std::current_exception());
+                    }
+                });
+            cpu.record(end - begin, cpu.run_seconds + seconds_since(start));
+        }
+    }
+    catch (...)
+    {
+        state.fail(std::current_exception());
+    }
+}
+
+//-----------------------------------------------------------------------------
+void heterogeneous_executor::run_gpu(run_state& state, worker& gpu)
+{
+#if QUARISMA_HAS_CUDA
+    struct in_flight
+    {
+        std::size_t begin = 0;
+        std::size_t end   = 0;
+        bool        busy  = false;
+    };
+
+    const std::size_t            depth  = pipeline_depth_;
+    const int                    device = gpu.device.index();
+    std::vector<in_flight>       slots(depth);
+    const clock_type::time_point start = clock_type::now();
+
+    // Throughput over the wall time of the device: the chunks overlap, so their
+    // own durations would count the pipelined work several times
+    auto complete = [&gpu, &slots, start](std::size_t slot)
+    {
+        gpu.streams[slot]->synchronize();
+        slots[slot].busy = false;
+        gpu.record(slots[slot].end - slots[slot].begin, seconds_since(start));
+    };
+
+    try
+    {
+        quarisma::gpu::gpu_device_manager::instance().set_device_context(
+            quarisma::device_enum::CUDA, device);
+        while (gpu.streams.size() < depth)
+        {
+            gpu.streams.push_back(
+                quarisma::gpu::gpu_stream::create(quarisma::device_enum::CUDA, device));
+        }
+
+        for (std::size_t k = 0;; ++k)
+        {
+            const std::size_t slot = k % depth;
+            if (slots[slot].busy)
+            {
+                complete(slot);
+            }
+
+            std::size_t begin = 0;
+            std::size_t end   = 0;
+            if (!state.claim(gpu, depth, begin, end))
+            {
+                break;
+            }
+
+            const gpu_chunk chunk{begin, end, device, slot, gpu.streams[slot].get()};
+            slots[slot] = {begin, end, true};
+            if (state.work.upload)
+            {
+                state.work.upload(chunk);
+            }
+            state.work.compute(chunk);
+            if (state.work.download)
+            {
+                state.work.download(chunk);
+            }
+        }
+    }
+    catch (...)
+    {
+        state.fail(std::current_exception());
+    }
+
+    // Wait for the chunks still in flight, whose callbacks may own host buffers
+    for (std::size_t slot = 0; slot < depth; ++slot)
+    {
+        if (!slots[slot].busy)
+        {
+            continue;
+        }
+        try
+        {
+            complete(slot);
+        }
+        catch (...)
+        {
+            state.fail(std::current_exception());
+        }
+    }
+#else
+    (void)state;
+    (void)gpu;
+#endif
+}
@@ -0,0 +1,180 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @class heterogeneous_executor
+ * @brief Splits a batch of independent items between the CPU pool and the GPUs
+ *
+ * A batch, for instance a grid of scenarios, is a range [0, size) of items
+ * processed by a CPU kernel (run with parallel_tools::parallel_for on the CPU
+ * pool) and by GPU kernels (run on every GPU of the executor). Instead of a
+ * static split, every worker (the CPU pool, and each GPU) repeatedly claims the
+ * next chunk of the range, sized in proportion to its share of the measured
+ * throughput: a faster device claims larger chunks, and the chunks shrink as
+ * the range runs out, so all workers finish close together whatever the split
+ * should have been. Throughputs are smoothed across runs, so only the first run
+ * starts with small calibration chunks.
+ *
+ * On a GPU, a chunk is three callbacks, upload, compute and download, that
+ * enqueue asynchronous work on the stream of a pipeline slot (see
+ * set_pipeline_depth()). Each slot has its own gpu_stream, so the upload of a
+ * chunk overlaps the compute and the download of the previous ones; the
+ * callbacks index their device buffers by slot. Transfers can go through
+ * gpu_memory_transfer::transfer_async() on the slot's stream.
+ *
+ * Without CUDA, or without usable GPUs, the whole batch runs on the CPU.
+ *
+ * run() must not be called concurrently on the same instance. The first
+ * exception thrown by a callback stops the claiming of new chunks and is
+ * rethrown by run() once the chunks in flight are done.
+ */
+
+#ifndef HETEROGENEOUS_EXECUTOR_H
+#define HETEROGENEOUS_EXECUTOR_H
+
+#include <cstddef>     // For std::size_t
+#include <functional>  // For std::function
+#include <memory>      // For std::unique_ptr
+#include <string>      // For std::string
+#include <vector>      // For std::vector
+
+#include "common/export.h"
+#include "memory/device.h"
+
+namespace quarisma
+{
+namespace gpu
+{
+class gpu_stream;
+}  // namespace gpu
+}  // namespace quarisma
+
+class QUARISMA_VISIBILITY heterogeneous_executor
+{
+public:
+    /**
+   * A chunk of the batch run on a GPU, passed to the GPU callbacks.
+   */
+    struct gpu_chunk
+    {
+        std::size_t begin;   ///< First item of the chunk
+        std::size_t end;     ///< One past the last item of the chunk
+        int         device;  ///< CUDA device index, current when the callbacks run
+        std::size_t slot;    ///< Pipeline slot, in [0, pipeline depth)
+        quarisma::gpu::gpu_stream* stream;  ///< Stream of the slot, for all the work of the chunk
+    };
+
+    /**
+   * The work of a batch. Either kernel may be empty: a batch without CPU kernel
+   * only runs on the GPUs, and one without GPU compute only on the CPU.
+   */
+    struct batch
+    {
+        /** @brief Number of items */
+        std::size_t size = 0;
+
+        /** @brief Processes the items [begin, end), concurrently on the CPU pool */
+        std::function<void(std::size_t begin, std::size_t end)> cpu;
+
+        /** @brief Enqueues the copy of the inputs of a chunk to the device */
+        std::function<void(const gpu_chunk&)> upload;
+
+        /** @brief Enqueues the kernels of a chunk */
+        std::function<void(const gpu_chunk&)> compute;
+
+        /** @brief Enqueues the copy of the results of a chunk to the host */
+        std::function<void(const gpu_chunk&)> download;
+    };
+
+    /**
+   * Measurements of a worker, accumulated over the runs.
+   */
+    struct worker_stats
+    {
+        quarisma::device_option device;      ///< CPU, or the CUDA device
+        std::size_t             items;       ///< Items processed
+        double                  busy_seconds;  ///< Time spent processing them
+        double                  throughput;  ///< Smoothed items per second, 0 before any run
+    };
+
+    /**
+   * Uses the CPU pool and every CUDA device reported by gpu_device_manager.
+   */
+    QUARISMA_API heterogeneous_executor();
+
+    /**
+   * Uses the CPU pool and the given CUDA devices; an empty list runs on the CPU
+   * only. Devices are ignored in builds without CUDA.
+   */
+    QUARISMA_API explicit heterogeneous_executor(const std::vector<int>& gpu_devices);
+
+    QUARISMA_API ~heterogeneous_executor();
+
+    heterogeneous_executor(const heterogeneous_executor&)            = delete;
+    heterogeneous_executor& operator=(const heterogeneous_executor&) = delete;
+
+    /**
+   * Processes every item of `work` once, on the CPU pool and the GPUs.
+   */
+    QUARISMA_API void run(const batch& work);
+
+    /**
+   * Number of chunks a GPU keeps in flight, each on its own stream. Values below
+   * 1 are clamped to 1. Default is 2: one chunk uploads while the other computes.
+   */
+    QUARISMA_API void set_pipeline_depth(std::size_t depth);
+
+    QUARISMA_API std::size_t get_pipeline_depth() const noexcept;
+
+    /**
+   * Smallest chunk claimed by a worker, except for the end of the range.
+   * Values below 1 are clamped to 1. Default is 1.
+   */
+    QUARISMA_API void set_min_chunk(std::size_t min_chunk);
+
+    QUARISMA_API std::size_t get_min_chunk() const noexcept;
+
+    /**
+   * Number of GPUs used by run().
+   */
+    QUARISMA_API std::size_t number_of_gpus() const noexcept;
+
+    /**
+   * Measurements of the CPU pool, then of each GPU.
+   */
+    QUARISMA_API std::vector<worker_stats> statistics() const;
+
+    /**
+   * Forgets the measured throughputs: the next run calibrates again.
+   */
+    QUARISMA_API void reset_statistics();
+
+private:
+    struct worker;
+    struct run_state;
+
+    void run_cpu(run_state& state, worker& cpu);
+    void run_gpu(run_state& state, worker& gpu);
+
+    std::vector<std::unique_ptr<worker>> workers_;  ///< The CPU pool first, then the GPUs
+    std::size_t                          pipeline_depth_ = 2;
+    std::size_t                          min_chunk_      = 1;
+};
+
+#endif
@@ -39,6 +39,8 @@
 
 #include <algorithm>
 
+#include "parallel/std_thread/parallel_thread_pool.h"
+
 // Need to define "extern_c_thread_function_type" to avoid warning on some
 // platforms about passing function pointer to an argument expecting an
 // extern "C" function.  Placing the typedef of the function pointer type
@@ -146,6 +148,18 @@ int multi_threader::get_global_default_number_of_threads()
     return g_multi_threader_global_default_number_of_threads;
 }
 
+static bool g_multi_threader_global_default_use_thread_pool = false;
+
+void multi_threader::set_global_default_use_thread_pool(bool use)
+{
+    g_multi_threader_global_default_use_thread_pool = use;
+}
+
+bool multi_threader::get_global_default_use_thread_pool()
+{
+    return g_multi_threader_global_default_use_thread_pool;
+}
+
 // Constructor. Default all the methods to nullptr. Since the
 // thread_info_array is static, the thread_ids can be initialized here
 // and will not change.
@@ -167,6 +181,7 @@ multi_threader::multi_threader()
     single_method_     = nullptr;
     single_data_       = nullptr;
     number_of_threads_ = multi_threader::get_global_default_number_of_threads();
+    use_thread_pool_   = multi_threader::get_global_default_use_thread_pool();
 }
 
 multi_threader::~multi_threader()
@@ -205,6 +220,56 @@ void multi_threader::set_number_of_threads(int num)
     number_of_threads_ = num;
 }
 
+void multi_threader::set_use_thread_pool(bool use)
+{
+    use_thread_pool_ = use;
+}
+
+bool multi_threader::get_use_thread_pool() const
+{
+    return use_thread_pool_;
+}
+
+bool multi_threader::execute_on_thread_pool(bool single_method)
+{
+    using quarisma::detail::parallel::parallel_thread_pool;
+
+    const auto helpers = static_cast<std::size_t>(number_of_threads_ - 1);
+    auto&      pool    = parallel_thread_pool::instance();
+    if (helpers == 0 || pool.thread_count() < helpers || pool.is_parallel_scope())
+    {
+        return false;
+    }
+
+    // A top-level proxy of `helpers` threads queues one job on each of them
+    auto proxy = pool.allocate_threads(helpers);
+    if (!proxy.is_top_level() || proxy.get_threads().size() < helpers)
+    {
+        return false;
+    }
+
+    for (int thread_loop = 0; thread_loop < number_of_threads_; thread_loop++)
+    {
+        thread_info_array_[thread_loop].user_data =
+            single_method ? single_data_ : multiple_data_[thread_loop];
+        thread_info_array_[thread_loop].number_of_threads = number_of_threads_;
+    }
+    for (int thread_loop = 1; thread_loop < number_of_threads_; thread_loop++)
+    {
+        thread_function_type method =
+            single_method ? single_method_ : multiple_method_[thread_loop];
+        thread_info* info = &thread_info_array_[thread_loop];
+        proxy.do_job([method, info]() { method(static_cast<void*>(info)); });
+    }
+
+    // Now, the parent thread calls the method of thread 0 itself
+    thread_function_type method = single_method ? single_method_ : multiple_method_[0];
+    method(static_cast<void*>(&thread_info_array_[0]));
+
+    proxy.join();
+    return true;
+}
+
 // Set the user defined method that will be run on number_of_threads threads
 // when single_method_execute is called.
 void multi_threader::set_single_method(thread_function_type f, void* data)
@@ -257,6 +322,11 @@ void multi_threader::single_method_execute()
         number_of_threads_ = g_multi_threader_global_maximum_number_of_threads;
     }
 
+    if (use_thread_pool_ && execute_on_thread_pool(/*single_method=*/true))
+    {
+        return;
+    }
+
 #if QUARISMA_USE_WIN32_THREADS
     // Using CreateThread on Windows
     //
@@ -390,6 +460,11 @@ void multi_threader::multiple_method_execute()
         }
     }
 
+    if (use_thread_pool_ && execute_on_thread_pool(/*single_method=*/false))
+    {
+        return;
+    }
+
 #if QUARISMA_USE_WIN32_THREADS
     // Using CreateThread on Windows
     for (thread_loop = 1; thread_loop < number_of_threads_; thread_loop++)
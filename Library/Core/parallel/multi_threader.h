@@ -100,6 +100,29 @@ public:
     QUARISMA_API static int  get_global_default_number_of_threads();
     ///@}
 
+    ///@{
+    /**
+   * Set/Get whether single_method_execute and multiple_method_execute run the
+   * callbacks of threads 1 - number_of_threads-1 on the persistent workers of
+   * parallel_thread_pool, instead of creating and joining that many threads on
+   * every call. The callbacks receive the same thread_info, and each still
+   * runs on a thread of its own, so they may wait on each other: when the pool
+   * cannot give every callback a worker (a smaller pool, or a call from
+   * inside the pool), the threads are created as before.
+   */
+    QUARISMA_API void set_use_thread_pool(bool use);
+    QUARISMA_API bool get_use_thread_pool() const;
+    ///@}
+
+    ///@{
+    /**
+   * Set/Get the value which is used to initialize use_thread_pool in the
+   * constructor. Initially false.
+   */
+    QUARISMA_API static void set_global_default_use_thread_pool(bool use);
+    QUARISMA_API static bool get_global_default_use_thread_pool();
+    ///@}
+
     // These methods are excluded from wrapping 1) because the
     // wrapper gives up on them and 2) because they really shouldn't be
     // called from a script anyway.
@@ -162,9 +185,17 @@ public:
 protected:
     multi_threader();
 
+    // Runs the callbacks of threads 1 - number_of_threads_-1 on pool workers
+    // and that of thread 0 on the calling thread, then waits for all of them.
+    // Returns false, having run nothing, if the pool has too few workers.
+    bool execute_on_thread_pool(bool single_method);
+
     // The number of threads to use
     int number_of_threads_;
 
+    // Whether the execute methods run on parallel_thread_pool
+    bool use_thread_pool_;
+
     // An array of thread info containing a thread id
     // (0, 1, 2, .. QUARISMA_MAX_THREADS-1), the thread count, and a pointer
     // to void so that user data can be passed to each thread
@@ -146,10 +146,12 @@ void parallel_tools_impl_for_openmp(
     void*                    functor,
     bool                     nested_activated)
 {
+    // A local_scope() budget sizes this team only, without omp_set_num_threads()
+    const int team_size = scoped_number_of_threads(number_of_threads_openmp());
+
     if (grain == 0)
     {
-        const size_t estimate_grain =
-            (last - first) / (static_cast<size_t>(number_of_threads_openmp()) * 4);
+        const size_t estimate_grain = (last - first) / (static_cast<size_t>(team_size) * 4);
         grain = (estimate_grain > 0) ? estimate_grain : 1;
     }
 
@@ -158,7 +160,7 @@ void parallel_tools_impl_for_openmp(
 #pragma omp single
     thread_id_stack->emplace(omp_get_thread_num());
 
-#pragma omp parallel for schedule(runtime)
+#pragma omp parallel for schedule(runtime) num_threads(team_size)
     for (size_t from = first; from < last; from += grain)
     {
         functor_executer(functor, from, grain, last);
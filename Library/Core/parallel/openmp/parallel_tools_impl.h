@@ -95,7 +95,8 @@ void parallel_tools_impl<backend_type::OpenMP>::parallel_for(
         bool from_parallel_code = is_parallel_.exchange(true);
 
         parallel_tools_impl_for_openmp(
-            first, last, grain, execute_functor_openmp<FunctorInternal>, &fi, nested_activated_);
+            first, last, grain, execute_functor_openmp<FunctorInternal>, &fi,
+            scoped_nested_parallelism(nested_activated_));
 
         // Atomic contortion to achieve is_parallel_ &= from_parallel_code.
         // This compare&exchange basically boils down to:
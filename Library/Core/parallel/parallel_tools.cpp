@@ -58,6 +58,20 @@ bool parallel_tools::nested_parallelism()
     return SMPToolsAPI.nested_parallelism();
 }
 
+//------------------------------------------------------------------------------
+void parallel_tools::set_deterministic(bool is_deterministic)
+{
+    auto& SMPToolsAPI = quarisma::detail::parallel::parallel_tools_api::instance();
+    SMPToolsAPI.set_deterministic(is_deterministic);
+}
+
+//------------------------------------------------------------------------------
+bool parallel_tools::deterministic()
+{
+    auto& SMPToolsAPI = quarisma::detail::parallel::parallel_tools_api::instance();
+    return SMPToolsAPI.deterministic();
+}
+
 //------------------------------------------------------------------------------
 bool parallel_tools::is_parallel_scope()
 {
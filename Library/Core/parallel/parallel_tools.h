@@ -35,9 +35,13 @@
 #ifndef PARALLEL_TOOLS_H
 #define PARALLEL_TOOLS_H
 
+#include <algorithm>    // For std::min, std::max
 #include <functional>   // For std::function
+#include <iterator>     // For std::iterator_traits
+#include <memory>       // For std::unique_ptr
 #include <string>       // For std::string
 #include <type_traits>  // For std::enable_if
+#include <vector>       // For std::vector
 
 #include "common/export.h"
 #include "parallel/common/parallel_tools_api.h"
@@ -198,6 +202,111 @@ public:
 template <typename T>
 using resolved_not_int = typename std::enable_if<!std::is_integral<T>::value, void>::type;
 
+/**
+ * @brief Partial result of one block, padded to a cache line to avoid false sharing.
+ */
+template <typename T>
+struct alignas(64) parallel_tools_padded_slot
+{
+    T value_;
+};
+
+/**
+ * @brief Number of blocks used to split `n` items for reductions and scans.
+ *
+ * Blocks hold at least `grain` items (when non-zero) and there are at most a
+ * few blocks per thread, which keeps the serial combine step negligible. In
+ * deterministic mode the bound is a constant instead, so that the blocks do
+ * not depend on the thread count.
+ */
+inline size_t parallel_tools_block_count(size_t n, size_t grain)
+{
+    auto&  api        = parallel_tools_api::instance();
+    size_t max_blocks = parallel_tools_api::deterministic_max_blocks;
+    if (!api.deterministic())
+    {
+        const auto threads = static_cast<size_t>(api.estimated_number_of_threads());
+        max_blocks         = (std::max)(threads, size_t{1}) * 8;
+    }
+    const size_t blocks = grain > 0 ? (n - 1) / grain + 1 : max_blocks;
+    return (std::min)((std::min)(blocks, max_blocks), n);
+}
+
+/**
+ * @brief Grain of the parallel loop over `blocks` blocks.
+ *
+ * Only the scheduling depends on it, not the results: the blocks are computed
+ * independently. It keeps the number of jobs to a few per thread when the
+ * deterministic mode makes more blocks than that.
+ */
+inline size_t parallel_tools_block_grain(size_t blocks)
+{
+    const auto threads =
+        static_cast<size_t>(parallel_tools_api::instance().estimated_number_of_threads());
+    return (std::max)(blocks / ((std::max)(threads, size_t{1}) * 8), size_t{1});
+}
+
+/**
+ * @brief Combine the partials pairwise in a fixed tree order, in place.
+ *
+ * Neighbours are merged at distance 1, 2, 4, ... so the shape of the tree
+ * only depends on the number of partials, and the left to right order of the
+ * operands is kept for non commutative combines.
+ */
+template <typename Slot, typename Combine>
+void parallel_tools_tree_combine(std::vector<Slot>& partials, Combine& combine)
+{
+    const size_t count = partials.size();
+    for (size_t stride = 1; stride < count; stride *= 2)
+    {
+        for (size_t i = 0; i + stride < count; i += 2 * stride)
+        {
+            partials[i].value_ = combine(partials[i].value_, partials[i + stride].value_);
+        }
+    }
+}
+
+/**
+ * @brief Number of elements of [a, a + na) among the first `k` elements of the
+ * merge of [a, a + na) and [b, b + nb).
+ *
+ * Equivalent elements are taken from `a` first, as std::merge does, so that
+ * output chunks split at these ranks merge independently into the serial result.
+ */
+template <typename Iterator, typename Compare>
+size_t parallel_tools_merge_rank(
+    Iterator a, size_t na, Iterator b, size_t nb, size_t k, Compare& comp)
+{
+    using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = (std::min)(k, na);
+    while (lo < hi)
+    {
+        // Too few elements of a when b[j - 1] does not strictly precede a[i]
+        const size_t i = lo + (hi - lo) / 2;
+        const size_t j = k - i;
+        if (!comp(b[static_cast<difference_type>(j - 1)], a[static_cast<difference_type>(i)]))
+        {
+            lo = i + 1;
+        }
+        else
+        {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Whether the iterator algorithms of parallel_tools run `n` elements on
+ * the calling thread: below `threshold`, or with a single thread.
+ */
+inline bool parallel_tools_serial(size_t n, size_t threshold)
+{
+    return n < threshold || parallel_tools_api::instance().estimated_number_of_threads() <= 1;
+}
+
 }  // namespace parallel
 }  // namespace detail
 }  // namespace quarisma
@@ -236,6 +345,592 @@ public:
         fi.parallel_for(first, last, grain);
     }
 
+    /**
+   * @brief Reduce [first, last) in parallel.
+   *
+   * The range is split into contiguous blocks; `map(begin, end)` returns the
+   * partial result of a block and the partials are folded from left to right
+   * with `combine(accumulated, partial)`, starting from `identity`. `combine`
+   * must be associative and `identity` its neutral element. For a given grain
+   * and thread count the block boundaries, hence the result, are deterministic.
+   * In deterministic mode (see set_deterministic()) the blocks no longer depend
+   * on the thread count and the partials are combined in a fixed tree order, so
+   * floating-point results are bit-identical for any number of threads.
+   *
+   * @param first The start of the range (inclusive)
+   * @param last The end of the range (exclusive)
+   * @param grain Minimum block size (0 lets the implementation decide)
+   * @param identity Neutral element of combine
+   * @param map Callable T(size_t begin, size_t end)
+   * @param combine Callable T(const T&, const T&)
+   * @return The combined result, or identity for an empty range
+   */
+    template <typename T, typename Map, typename Combine>
+    static T parallel_reduce(
+        size_t first, size_t last, size_t grain, T identity, Map&& map, Combine&& combine)
+    {
+        using slot_type = quarisma::detail::parallel::parallel_tools_padded_slot<T>;
+
+        if (last <= first)
+        {
+            return identity;
+        }
+
+        const size_t n      = last - first;
+        const size_t blocks = quarisma::detail::parallel::parallel_tools_block_count(n, grain);
+        std::vector<slot_type> partials(blocks, slot_type{identity});
+
+        parallel_tools::parallel_for(
+            0,
+            blocks,
+            quarisma::detail::parallel::parallel_tools_block_grain(blocks),
+            [&partials, &map, first, n, blocks](size_t begin, size_t end)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    partials[b].value_ = map(first + n * b / blocks, first + n * (b + 1) / blocks);
+                }
+            });
+
+        if (quarisma::detail::parallel::parallel_tools_api::instance().deterministic())
+        {
+            quarisma::detail::parallel::parallel_tools_tree_combine(partials, combine);
+            return combine(identity, partials.front().value_);
+        }
+
+        T result = identity;
+        for (const auto& partial : partials)
+        {
+            result = combine(result, partial.value_);
+        }
+        return result;
+    }
+
+    /**
+   * Kind of prefix computed by parallel_scan().
+   */
+    enum class scan_type
+    {
+        inclusive,  ///< out[i] = in[0] op ... op in[i]
+        exclusive   ///< out[i] = identity op in[0] op ... op in[i - 1]
+    };
+
+    /**
+   * @brief Compute a prefix scan of [in, in + count) into out in parallel.
+   *
+   * Uses the classic three-pass block algorithm: per-block totals in parallel,
+   * a serial exclusive scan of the block totals, then a parallel rescan of each
+   * block seeded with its offset. `combine` must be associative and `identity`
+   * its neutral element. `out` may alias `in`.
+   *
+   * @param in Random access input iterator
+   * @param count Number of elements
+   * @param out Random access output iterator
+   * @param identity Neutral element of combine
+   * @param combine Callable T(const T&, const T&)
+   * @param type Inclusive or exclusive scan
+   * @param grain Minimum block size (0 lets the implementation decide)
+   * @return The combination of all the elements, or identity if count is 0
+   */
+    template <typename InputIt, typename OutputIt, typename T, typename Combine>
+    static T parallel_scan(
+        InputIt   in,
+        size_t    count,
+        OutputIt  out,
+        T         identity,
+        Combine&& combine,
+        scan_type type  = scan_type::inclusive,
+        size_t    grain = 0)
+    {
+        using slot_type = quarisma::detail::parallel::parallel_tools_padded_slot<T>;
+
+        if (count == 0)
+        {
+            return identity;
+        }
+
+        const size_t blocks = quarisma::detail::parallel::parallel_tools_block_count(count, grain);
+        std::vector<slot_type> partials(blocks, slot_type{identity});
+
+        const size_t block_grain = quarisma::detail::parallel::parallel_tools_block_grain(blocks);
+
+        // Pass 1: total of each block
+        parallel_tools::parallel_for(
+            0,
+            blocks,
+            block_grain,
+            [&partials, &combine, &identity, in, count, blocks](size_t begin, size_t end)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    T            acc  = identity;
+                    const size_t stop = count * (b + 1) / blocks;
+                    for (size_t i = count * b / blocks; i < stop; ++i)
+                    {
+                        acc = combine(acc, in[i]);
+                    }
+                    partials[b].value_ = acc;
+                }
+            });
+
+        // Pass 2: exclusive scan of the block totals gives each block's offset
+        T total = identity;
+        for (auto& partial : partials)
+        {
+            T block_total  = partial.value_;
+            partial.value_ = total;
+            total          = combine(total, block_total);
+        }
+
+        // Pass 3: rescan each block from its offset
+        parallel_tools::parallel_for(
+            0,
+            blocks,
+            block_grain,
+            [&partials, &combine, in, out, count, blocks, type](size_t begin, size_t end)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    T            acc  = partials[b].value_;
+                    const size_t stop = count * (b + 1) / blocks;
+                    for (size_t i = count * b / blocks; i < stop; ++i)
+                    {
+                        T value = in[i];
+                        if (type == scan_type::exclusive)
+                        {
+                            out[i] = acc;
+                        }
+                        acc = combine(acc, value);
+                        if (type == scan_type::inclusive)
+                        {
+                            out[i] = acc;
+                        }
+                    }
+                }
+            });
+
+        return total;
+    }
+
+    /**
+   * @brief Call f(*it) for every iterator of [first, last) in parallel.
+   *
+   * Runs on the calling thread below THRESHOLD elements. The calls are
+   * unordered, so f must be safe to run concurrently on distinct elements.
+   *
+   * @param first Random access iterator to the first element
+   * @param last Random access iterator past the last element
+   * @param f Callable void(reference)
+   */
+    template <
+        typename Iterator,
+        typename Function,
+        typename = quarisma::detail::parallel::resolved_not_int<Iterator>>
+    static void for_each(Iterator first, Iterator last, Function f)
+    {
+        using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+
+        const auto n = static_cast<size_t>(last - first);
+        if (quarisma::detail::parallel::parallel_tools_serial(n, THRESHOLD))
+        {
+            std::for_each(first, last, f);
+            return;
+        }
+        parallel_tools::parallel_for(
+            0,
+            n,
+            0,
+            [first, &f](size_t begin, size_t end)
+            {
+                std::for_each(
+                    first + static_cast<difference_type>(begin),
+                    first + static_cast<difference_type>(end),
+                    f);
+            });
+    }
+
+    ///@{
+    /**
+   * @brief Store op(*it) for every element of [first, last) into out in parallel,
+   * or op(*it1, *it2) pairwise with [first2, first2 + (last - first)).
+   *
+   * Runs on the calling thread below THRESHOLD elements. `out` may be equal to
+   * `first` (or `first2`), as with std::transform.
+   *
+   * @return The iterator past the last element written
+   */
+    template <
+        typename InputIt,
+        typename OutputIt,
+        typename UnaryOp,
+        typename = quarisma::detail::parallel::resolved_not_int<InputIt>>
+    static OutputIt transform(InputIt first, InputIt last, OutputIt out, UnaryOp op)
+    {
+        using difference_type = typename std::iterator_traits<InputIt>::difference_type;
+
+        const auto n = static_cast<size_t>(last - first);
+        if (quarisma::detail::parallel::parallel_tools_serial(n, THRESHOLD))
+        {
+            return std::transform(first, last, out, op);
+        }
+        parallel_tools::parallel_for(
+            0,
+            n,
+            0,
+            [first, out, &op](size_t begin, size_t end)
+            {
+                const auto b = static_cast<difference_type>(begin);
+                std::transform(
+                    first + b, first + static_cast<difference_type>(end), out + b, op);
+            });
+        return out + static_cast<difference_type>(n);
+    }
+
+    template <
+        typename InputIt1,
+        typename InputIt2,
+        typename OutputIt,
+        typename BinaryOp,
+        typename = quarisma::detail::parallel::resolved_not_int<InputIt1>>
+    static OutputIt transform(
+        InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out, BinaryOp op)
+    {
+        using difference_type = typename std::iterator_traits<InputIt1>::difference_type;
+
+        const auto n = static_cast<size_t>(last1 - first1);
+        if (quarisma::detail::parallel::parallel_tools_serial(n, THRESHOLD))
+        {
+            return std::transform(first1, last1, first2, out, op);
+        }
+        parallel_tools::parallel_for(
+            0,
+            n,
+            0,
+            [first1, first2, out, &op](size_t begin, size_t end)
+            {
+                const auto b = static_cast<difference_type>(begin);
+                std::transform(
+                    first1 + b,
+                    first1 + static_cast<difference_type>(end),
+                    first2 + b,
+                    out + b,
+                    op);
+            });
+        return out + static_cast<difference_type>(n);
+    }
+    ///@}
+
+    ///@{
+    /**
+   * @brief Sort [first, last) in parallel.
+   *
+   * A merge sort: blocks of the range are sorted concurrently with std::sort,
+   * then merged pairwise through a buffer of the same size, each merge split
+   * into chunks at the ranks given by a binary search so that the last merges
+   * use all the threads too. Runs std::sort on the calling thread below
+   * THRESHOLD elements. As with std::sort, the order of equivalent elements is
+   * unspecified; the value type must be default constructible and movable.
+   *
+   * @param first Random access iterator to the first element
+   * @param last Random access iterator past the last element
+   * @param comp Strict weak ordering bool(const T&, const T&)
+   */
+    template <typename RandomIt, typename Compare>
+    static void sort(RandomIt first, RandomIt last, Compare comp)
+    {
+        using difference_type = typename std::iterator_traits<RandomIt>::difference_type;
+        using value_type      = typename std::iterator_traits<RandomIt>::value_type;
+
+        const auto n = static_cast<size_t>(last - first);
+        if (quarisma::detail::parallel::parallel_tools_serial(n, THRESHOLD))
+        {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        const size_t blocks =
+            quarisma::detail::parallel::parallel_tools_block_count(n, THRESHOLD / 4);
+        std::vector<size_t> bounds(blocks + 1);
+        for (size_t b = 0; b <= blocks; ++b)
+        {
+            bounds[b] = n * b / blocks;
+        }
+
+        parallel_tools::parallel_for(
+            0,
+            blocks,
+            1,
+            [first, &bounds, &comp](size_t begin, size_t end)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    std::sort(
+                        first + static_cast<difference_type>(bounds[b]),
+                        first + static_cast<difference_type>(bounds[b + 1]),
+                        comp);
+                }
+            });
+
+        std::unique_ptr<value_type[]> buffer(new value_type[n]);
+        const auto threads = static_cast<size_t>((std::max)(estimated_number_of_threads(), 1));
+        const size_t chunk = (std::max)(n / (threads * 4), THRESHOLD / 16);
+
+        // Merges the pairs of consecutive runs of src into dst; a run without a
+        // pair is moved as is
+        auto merge_runs = [n, chunk, &bounds, &comp](auto src, auto dst)
+        {
+            // Output chunk [begin_, end_) of the merge of runs run_ and run_ + 1,
+            // made of the elements [split_begin_, split_end_) of the first run
+            // and the rest of the second
+            struct task
+            {
+                size_t run_;
+                size_t begin_;
+                size_t end_;
+                size_t split_begin_;
+                size_t split_end_;
+            };
+            std::vector<task> tasks;
+            const size_t      runs = bounds.size() - 1;
+            for (size_t r = 0; r < runs; r += 2)
+            {
+                const size_t size = bounds[(std::min)(r + 2, runs)] - bounds[r];
+                for (size_t k = 0; k < size; k += chunk)
+                {
+                    tasks.push_back({r, k, (std::min)(k + chunk, size), 0, 0});
+                }
+            }
+
+            // The splits compare elements of src, so they are all found before
+            // any chunk moves from it
+            parallel_tools::parallel_for(
+                0,
+                tasks.size(),
+                1,
+                [src, runs, &tasks, &bounds, &comp](size_t begin, size_t end)
+                {
+                    for (size_t t = begin; t < end; ++t)
+                    {
+                        task&        job = tasks[t];
+                        const size_t lo  = bounds[job.run_];
+                        const size_t mid = bounds[(std::min)(job.run_ + 1, runs)];
+                        const size_t hi  = bounds[(std::min)(job.run_ + 2, runs)];
+                        const auto   a   = src + static_cast<difference_type>(lo);
+                        const auto   b   = src + static_cast<difference_type>(mid);
+                        job.split_begin_ = quarisma::detail::parallel::parallel_tools_merge_rank(
+                            a, mid - lo, b, hi - mid, job.begin_, comp);
+                        job.split_end_ = quarisma::detail::parallel::parallel_tools_merge_rank(
+                            a, mid - lo, b, hi - mid, job.end_, comp);
+                    }
+                });
+
+            parallel_tools::parallel_for(
+                0,
+                tasks.size(),
+                1,
+                [src, dst, runs, &tasks, &bounds, &comp](size_t begin, size_t end)
+                {
+                    for (size_t t = begin; t < end; ++t)
+                    {
+                        const task&  job = tasks[t];
+                        const size_t lo  = bounds[job.run_];
+                        const size_t mid = bounds[(std::min)(job.run_ + 1, runs)];
+                        const auto   a   = src + static_cast<difference_type>(lo);
+                        const auto   b   = src + static_cast<difference_type>(mid);
+                        const auto   i0  = static_cast<difference_type>(job.split_begin_);
+                        const auto   i1  = static_cast<difference_type>(job.split_end_);
+                        const auto   j0  = static_cast<difference_type>(job.begin_) - i0;
+                        const auto   j1  = static_cast<difference_type>(job.end_) - i1;
+                        std::merge(
+                            std::make_move_iterator(a + i0),
+                            std::make_move_iterator(a + i1),
+                            std::make_move_iterator(b + j0),
+                            std::make_move_iterator(b + j1),
+                            dst + static_cast<difference_type>(lo + job.begin_),
+                            comp);
+                    }
+                });
+
+            std::vector<size_t> merged;
+            for (size_t r = 0; r < runs; r += 2)
+            {
+                merged.push_back(bounds[r]);
+            }
+            merged.push_back(n);
+            bounds.swap(merged);
+        };
+
+        bool in_buffer = false;
+        while (bounds.size() > 2)
+        {
+            if (in_buffer)
+            {
+                merge_runs(buffer.get(), first);
+            }
+            else
+            {
+                merge_runs(first, buffer.get());
+            }
+            in_buffer = !in_buffer;
+        }
+
+        if (in_buffer)
+        {
+            value_type* data = buffer.get();
+            parallel_tools::parallel_for(
+                0,
+                n,
+                0,
+                [first, data](size_t begin, size_t end)
+                {
+                    std::move(
+                        data + begin, data + end, first + static_cast<difference_type>(begin));
+                });
+        }
+    }
+
+    template <typename RandomIt>
+    static void sort(RandomIt first, RandomIt last)
+    {
+        parallel_tools::sort(first, last, std::less<>());
+    }
+    ///@}
+
+    /**
+   * @brief Reorder [first, last) in parallel so that the elements satisfying
+   * pred precede those that do not.
+   *
+   * pred is evaluated once per element, concurrently. Each block counts its
+   * matches, a scan of the counts gives every element its destination in a
+   * buffer, and the buffer is moved back. The relative order is preserved in
+   * both groups, as with std::stable_partition, which runs on the calling
+   * thread below THRESHOLD elements. The value type must be default
+   * constructible and movable.
+   *
+   * @param first Random access iterator to the first element
+   * @param last Random access iterator past the last element
+   * @param pred Callable bool(const T&)
+   * @return Iterator to the first element of the second group
+   */
+    template <typename RandomIt, typename Predicate>
+    static RandomIt partition(RandomIt first, RandomIt last, Predicate pred)
+    {
+        using difference_type = typename std::iterator_traits<RandomIt>::difference_type;
+        using value_type      = typename std::iterator_traits<RandomIt>::value_type;
+
+        const auto n = static_cast<size_t>(last - first);
+        if (quarisma::detail::parallel::parallel_tools_serial(n, THRESHOLD))
+        {
+            return std::stable_partition(first, last, pred);
+        }
+
+        const size_t blocks = quarisma::detail::parallel::parallel_tools_block_count(n, 0);
+        const size_t block_grain = quarisma::detail::parallel::parallel_tools_block_grain(blocks);
+        std::unique_ptr<bool[]> matches(new bool[n]);
+        std::vector<quarisma::detail::parallel::parallel_tools_padded_slot<size_t>> offsets(
+            blocks);
+
+        // Pass 1: evaluate pred and count the matches of each block
+        parallel_tools::parallel_for(
+            0,
+            blocks,
+            block_grain,
+            [first, n, blocks, &matches, &offsets, &pred](size_t begin, size_t end)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    size_t       count = 0;
+                    const size_t stop  = n * (b + 1) / blocks;
+                    for (size_t i = n * b / blocks; i < stop; ++i)
+                    {
+                        const auto& value = first[static_cast<difference_type>(i)];
+                        matches[i]        = static_cast<bool>(pred(value));
+                        count += matches[i] ? 1 : 0;
+                    }
+                    offsets[b].value_ = count;
+                }
+            });
+
+        // Pass 2: matches before each block
+        size_t total = 0;
+        for (auto& offset : offsets)
+        {
+            const size_t count = offset.value_;
+            offset.value_      = total;
+            total += count;
+        }
+
+        // Pass 3: move every element to its place in the buffer
+        std::unique_ptr<value_type[]> buffer(new value_type[n]);
+        value_type*                   data = buffer.get();
+        parallel_tools::parallel_for(
+            0,
+            blocks,
+            block_grain,
+            [first, data, n, blocks, total, &matches, &offsets](size_t begin, size_t end)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    const size_t start = n * b / blocks;
+                    const size_t stop  = n * (b + 1) / blocks;
+                    size_t       yes   = offsets[b].value_;
+                    size_t       no    = total + start - yes;
+                    for (size_t i = start; i < stop; ++i)
+                    {
+                        data[matches[i] ? yes++ : no++] =
+                            std::move(first[static_cast<difference_type>(i)]);
+                    }
+                }
+            });
+
+        parallel_tools::parallel_for(
+            0,
+            n,
+            0,
+            [first, data](size_t begin, size_t end)
+            { std::move(data + begin, data + end, first + static_cast<difference_type>(begin)); });
+        return first + static_cast<difference_type>(total);
+    }
+
+    ///@{
+    /**
+   * @brief Store the inclusive prefixes of [first, last) under op into out.
+   *
+   * Parallel form of std::inclusive_scan on top of parallel_scan(), which runs
+   * on the calling thread below THRESHOLD elements. `op` must be associative
+   * and `identity` its neutral element; out may be equal to first.
+   *
+   * @return The iterator past the last element written
+   */
+    template <typename InputIt, typename OutputIt, typename BinaryOp, typename T>
+    static OutputIt inclusive_scan(
+        InputIt first, InputIt last, OutputIt out, BinaryOp op, T identity)
+    {
+        using difference_type = typename std::iterator_traits<InputIt>::difference_type;
+
+        const auto n = static_cast<size_t>(last - first);
+        if (quarisma::detail::parallel::parallel_tools_serial(n, THRESHOLD))
+        {
+            T acc = identity;
+            for (; first != last; ++first, ++out)
+            {
+                acc  = op(acc, *first);
+                *out = acc;
+            }
+            return out;
+        }
+        parallel_tools::parallel_scan(first, n, out, identity, op);
+        return out + static_cast<difference_type>(n);
+    }
+
+    template <typename InputIt, typename OutputIt>
+    static OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt out)
+    {
+        using value_type = typename std::iterator_traits<InputIt>::value_type;
+        return parallel_tools::inclusive_scan(first, last, out, std::plus<>(), value_type{});
+    }
+    ///@}
+
     /**
    * /!\ This method is not thread safe.
    * Initialize the underlying libraries for execution.
@@ -263,6 +958,22 @@ public:
    */
     QUARISMA_API static bool nested_parallelism();
 
+    /**
+   * If true, parallel_for() with a zero grain, parallel_reduce() and
+   * parallel_scan() partition their range independently of the thread count,
+   * and parallel_reduce() combines its partials in a fixed tree order, so that
+   * reductions are reproducible bit for bit on any number of threads. It can
+   * also be enabled with PARALLEL_DETERMINISTIC=1. Functors combining
+   * per-thread state in Reduce() are not covered: their partials follow the
+   * threads, not the blocks.
+   */
+    QUARISMA_API static void set_deterministic(bool is_deterministic);
+
+    /**
+   * Get true if the deterministic execution mode is enabled.
+   */
+    QUARISMA_API static bool deterministic();
+
     /**
    * Return true if it is called from a parallel scope.
    */
@@ -276,11 +987,13 @@ public:
 
     /**
    * Structure used to specify configuration for local_scope() method.
+   * A zero thread count keeps the current budget; an empty backend keeps the
+   * compiled backend.
    */
     struct config
     {
         int         max_number_of_threads_ = 0;
-        std::string backend_               = "std";
+        std::string backend_;
         bool        nested_parallelism_    = false;
 
         config() = default;
@@ -307,8 +1020,10 @@ public:
     static constexpr size_t THRESHOLD = 100000;
 
     /**
-   * /!\ This method is not thread safe.
-   * Change the number of threads locally within this scope and call a functor.
+   * Change the number of threads and the nesting policy locally within this
+   * scope and call a functor. The overrides apply to the calling thread and to
+   * the parallel work it spawns; other threads and the global configuration are
+   * left untouched.
    */
     template <typename T>
     static void local_scope(config const& cfg, T&& lambda)
@@ -0,0 +1,360 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "parallel/pool_instrumentation.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+#include "common/macros.h"
+#include "memory/unified_memory_stats.h"
+#include "util/tsc_clock.h"
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/tracing/traceme_encode.h"
+#include "profiler/native/tracing/traceme_recorder.h"
+#include "profiler/native/tracing/tracing.h"
+#endif
+
+namespace quarisma
+{
+
+std::atomic<bool> pool_instrumentation::enabled_{false};
+
+namespace
+{
+std::int64_t now_ns() noexcept
+{
+    // Same clock as traceme, so that the recorded events line up with the trace
+    return tsc_clock::now_ns();
+}
+
+/**
+ * @brief Live counters of one worker
+ *
+ * Written by the worker itself, except for external_worker which is shared by
+ * every thread that runs jobs outside of a pool.
+ */
+struct worker_slot
+{
+    using histogram = std::array<std::atomic<std::uint64_t>, pool_instrumentation::wait_buckets>;
+
+    std::string                pool_;
+    std::size_t                worker_{};
+    std::atomic<std::uint64_t> jobs_{};
+    std::atomic<std::int64_t>  wait_ns_{};
+    std::atomic<std::int64_t>  max_wait_ns_{};
+    std::atomic<std::int64_t>  busy_ns_{};
+    histogram                  histogram_{};
+    latency_histogram*         pool_waits_{};  ///< Shared by the workers of the pool
+};
+
+/**
+ * @brief Every slot ever used and the measurement interval
+ *
+ * Slots are never freed: workers keep a pointer to theirs in a thread_local
+ * cache, and reset() only clears the counters.
+ */
+struct registry
+{
+    using pool_histogram = std::pair<std::string, std::unique_ptr<latency_histogram>>;
+
+    std::mutex                                mutex_;
+    std::vector<std::unique_ptr<worker_slot>> slots_;
+    std::vector<pool_histogram>               pool_waits_;   ///< Never freed, like the slots
+    std::int64_t                              since_ns_{};   ///< Start of the open interval
+    std::int64_t                              window_ns_{};  ///< Length of the closed intervals
+    bool                                      open_{};       ///< Whether since_ns_ is valid
+
+    static registry& instance()
+    {
+        static auto* r = new registry();  // Leaked: workers may outlive static destruction
+        return *r;
+    }
+
+    std::int64_t window(std::int64_t now) const
+    {
+        return window_ns_ + (open_ ? now - since_ns_ : 0);
+    }
+
+    // Queue-wait histogram of a pool, created on first use; mutex_ must be held
+    latency_histogram& pool_waits(const std::string& pool)
+    {
+        auto it = std::find_if(
+            pool_waits_.begin(), pool_waits_.end(), [&](const auto& p) { return p.first == pool; });
+        if (it == pool_waits_.end())
+        {
+            pool_waits_.emplace_back(pool, std::make_unique<latency_histogram>());
+            it = std::prev(pool_waits_.end());
+        }
+        return *it->second;
+    }
+};
+
+worker_slot& find_slot(const char* pool, std::size_t worker)
+{
+    struct cache_entry
+    {
+        const char*  pool_{};
+        std::size_t  worker_{};
+        worker_slot* slot_{};
+    };
+    thread_local cache_entry cache;
+
+    if (cache.slot_ != nullptr && cache.pool_ == pool && cache.worker_ == worker)
+    {
+        return *cache.slot_;
+    }
+
+    auto&                  r = registry::instance();
+    std::scoped_lock const lock(r.mutex_);
+    auto                   it = std::find_if(
+        r.slots_.begin(),
+        r.slots_.end(),
+        [&](const auto& s) { return s->worker_ == worker && s->pool_ == pool; });
+    if (it == r.slots_.end())
+    {
+        auto slot     = std::make_unique<worker_slot>();
+        slot->pool_       = pool;
+        slot->worker_     = worker;
+        slot->pool_waits_ = &r.pool_waits(slot->pool_);
+        r.slots_.push_back(std::move(slot));
+        it = std::prev(r.slots_.end());
+    }
+
+    cache = {pool, worker, it->get()};
+    return **it;
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+double pool_instrumentation::worker_stats::utilization() const noexcept
+{
+    return window_ns_ > 0 ? (std::min)(1.0, static_cast<double>(busy_ns_) / window_ns_) : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+std::int64_t pool_instrumentation::worker_stats::idle_ns() const noexcept
+{
+    return (std::max)(window_ns_ - busy_ns_, std::int64_t{0});
+}
+
+//-----------------------------------------------------------------------------
+double pool_instrumentation::worker_stats::mean_wait_ns() const noexcept
+{
+    return jobs_ != 0 ? static_cast<double>(wait_ns_) / static_cast<double>(jobs_) : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+void pool_instrumentation::set_enabled(bool enable) noexcept
+{
+    auto&                  r = registry::instance();
+    std::scoped_lock const lock(r.mutex_);
+    if (enable == r.open_)
+    {
+        return;
+    }
+
+    std::int64_t const now = now_ns();
+    if (enable)
+    {
+        r.since_ns_ = now;
+    }
+    else
+    {
+        r.window_ns_ += now - r.since_ns_;
+    }
+    r.open_ = enable;
+    enabled_.store(enable, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<pool_instrumentation::worker_stats> pool_instrumentation::collect()
+{
+    auto&                  r = registry::instance();
+    std::scoped_lock const lock(r.mutex_);
+    std::int64_t const     window = r.window(now_ns());
+
+    std::vector<worker_stats> result;
+    result.reserve(r.slots_.size());
+    for (const auto& slot : r.slots_)
+    {
+        worker_stats stats;
+        stats.pool_        = slot->pool_;
+        stats.worker_      = slot->worker_;
+        stats.jobs_        = slot->jobs_.load(std::memory_order_relaxed);
+        stats.wait_ns_     = slot->wait_ns_.load(std::memory_order_relaxed);
+        stats.max_wait_ns_ = slot->max_wait_ns_.load(std::memory_order_relaxed);
+        stats.busy_ns_     = slot->busy_ns_.load(std::memory_order_relaxed);
+        stats.window_ns_   = window;
+        for (std::size_t i = 0; i < wait_buckets; ++i)
+        {
+            stats.wait_histogram_[i] = slot->histogram_[i].load(std::memory_order_relaxed);
+        }
+        if (stats.jobs_ != 0)
+        {
+            result.push_back(std::move(stats));
+        }
+    }
+
+    std::sort(
+        result.begin(),
+        result.end(),
+        [](const worker_stats& lhs, const worker_stats& rhs)
+        { return std::tie(lhs.pool_, lhs.worker_) < std::tie(rhs.pool_, rhs.worker_); });
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+const latency_histogram& pool_instrumentation::queue_wait_latency(const std::string& pool)
+{
+    auto&                  r = registry::instance();
+    std::scoped_lock const lock(r.mutex_);
+    return r.pool_waits(pool);
+}
+
+//-----------------------------------------------------------------------------
+void pool_instrumentation::reset()
+{
+    auto&                  r = registry::instance();
+    std::scoped_lock const lock(r.mutex_);
+    for (auto& slot : r.slots_)
+    {
+        slot->jobs_.store(0, std::memory_order_relaxed);
+        slot->wait_ns_.store(0, std::memory_order_relaxed);
+        slot->max_wait_ns_.store(0, std::memory_order_relaxed);
+        slot->busy_ns_.store(0, std::memory_order_relaxed);
+        for (auto& bucket : slot->histogram_)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (auto& [pool, waits] : r.pool_waits_)
+    {
+        waits->reset();
+    }
+    r.since_ns_  = now_ns();
+    r.window_ns_ = 0;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t pool_instrumentation::wait_bucket(std::int64_t wait_ns) noexcept
+{
+    std::int64_t const us     = wait_ns / 1000;
+    std::size_t        bucket = 0;
+    for (std::int64_t limit = 1; bucket + 1 < wait_buckets && us >= limit; limit <<= 1)
+    {
+        ++bucket;
+    }
+    return bucket;
+}
+
+//-----------------------------------------------------------------------------
+std::int64_t pool_instrumentation::wait_bucket_limit_ns(std::size_t bucket) noexcept
+{
+    if (bucket + 1 >= wait_buckets)
+    {
+        return (std::numeric_limits<std::int64_t>::max)();
+    }
+    return (std::int64_t{1} << bucket) * 1000;
+}
+
+//-----------------------------------------------------------------------------
+pool_instrumentation::stamp pool_instrumentation::enqueue_stamp() noexcept
+{
+    stamp s;
+    s.enqueued_ns_ = now_ns();
+#if QUARISMA_HAS_NATIVE_PROFILER
+    if (const auto* collector =
+            tracing::get_event_collector(tracing::event_category::kScheduleClosure))
+    {
+        s.flow_id_ = tracing::get_unique_arg();
+        collector->record_event(s.flow_id_);
+    }
+#endif
+    return s;
+}
+
+//-----------------------------------------------------------------------------
+std::int64_t pool_instrumentation::start_job(QUARISMA_UNUSED const stamp& s) noexcept
+{
+#if QUARISMA_HAS_NATIVE_PROFILER
+    if (s.flow_id_ != 0)
+    {
+        if (const auto* collector =
+                tracing::get_event_collector(tracing::event_category::kRunClosure))
+        {
+            collector->start_region(s.flow_id_);
+        }
+    }
+#endif
+    return now_ns();
+}
+
+//-----------------------------------------------------------------------------
+void pool_instrumentation::finish_job(
+    const char* pool, std::size_t worker, const stamp& s, std::int64_t dequeued_ns) noexcept
+{
+    std::int64_t const completed_ns = now_ns();
+    std::int64_t const wait_ns      = (std::max)(dequeued_ns - s.enqueued_ns_, std::int64_t{0});
+    std::int64_t const busy_ns      = completed_ns - dequeued_ns;
+
+    worker_slot& slot = find_slot(pool, worker);
+    slot.jobs_.fetch_add(1, std::memory_order_relaxed);
+    slot.wait_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+    slot.busy_ns_.fetch_add(busy_ns, std::memory_order_relaxed);
+    slot.histogram_[wait_bucket(wait_ns)].fetch_add(1, std::memory_order_relaxed);
+    slot.pool_waits_->record(static_cast<std::uint64_t>(wait_ns));
+    std::int64_t longest = slot.max_wait_ns_.load(std::memory_order_relaxed);
+    while (wait_ns > longest &&
+           !slot.max_wait_ns_.compare_exchange_weak(longest, wait_ns, std::memory_order_relaxed))
+    {
+    }
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+    if (s.flow_id_ != 0)
+    {
+        if (const auto* collector =
+                tracing::get_event_collector(tracing::event_category::kRunClosure))
+        {
+            collector->stop_region();
+        }
+    }
+
+    if (traceme_recorder::active())
+    {
+        traceme_recorder::record(
+            {traceme_encode(
+                 "thread_pool_job",
+                 {{"pool", pool},
+                  {"worker", worker == external_worker ? std::int64_t{-1}
+                                                       : static_cast<std::int64_t>(worker)},
+                  {"wait_ns", wait_ns}}),
+             dequeued_ns,
+             completed_ns});
+    }
+#endif
+}
+
+}  // namespace quarisma
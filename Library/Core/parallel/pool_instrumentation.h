@@ -0,0 +1,204 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @class pool_instrumentation
+ * @brief Queueing and utilization counters of the thread pools
+ *
+ * parallel_thread_pool and threaded_callback_queue stamp every job when it is
+ * enqueued and wrap its execution in a job_scope. While instrumentation is
+ * enabled this records, per pool worker:
+ * - the number of jobs run;
+ * - the time jobs waited between enqueue and dequeue, with a log2 histogram;
+ * - the time spent running jobs, from which utilization and idle time follow.
+ *
+ * When the native profiler is built in and a trace is being recorded, each job
+ * also produces a `thread_pool_job` traceme event on the worker carrying its
+ * queue wait, and the enqueue and run are reported to the threadpool event
+ * collector so that the trace viewer links the producer to the worker.
+ *
+ * Disabled, the cost is one relaxed atomic load per enqueue and a branch per
+ * job. Jobs enqueued while disabled are not measured.
+ */
+
+#ifndef PARALLEL_POOL_INSTRUMENTATION_H
+#define PARALLEL_POOL_INSTRUMENTATION_H
+
+#include <array>    // For std::array
+#include <atomic>   // For std::atomic
+#include <cstddef>  // For std::size_t
+#include <cstdint>  // For std::int64_t, std::uint64_t
+#include <limits>   // For std::numeric_limits
+#include <string>   // For std::string
+#include <vector>   // For std::vector
+
+#include "common/export.h"
+
+namespace quarisma
+{
+
+class latency_histogram;
+
+class QUARISMA_VISIBILITY pool_instrumentation
+{
+public:
+    /**
+     * @brief Number of queue-wait histogram buckets
+     *
+     * Bucket 0 counts waits below 1 microsecond, bucket i waits in
+     * [2^(i-1), 2^i) microseconds and the last bucket everything longer.
+     */
+    static constexpr std::size_t wait_buckets = 24;
+
+    /// Worker index of jobs run by a thread that is not a pool worker
+    static constexpr std::size_t external_worker = (std::numeric_limits<std::size_t>::max)();
+
+    /**
+     * @brief Enqueue time of a job, zero when it is not measured
+     */
+    struct stamp
+    {
+        std::int64_t  enqueued_ns_{};
+        std::uint64_t flow_id_{};  ///< Threadpool event collector argument, 0 if none
+    };
+
+    /**
+     * @brief Counters of one worker, as returned by collect()
+     */
+    struct worker_stats
+    {
+        std::string                              pool_;
+        std::size_t                              worker_{};
+        std::uint64_t                            jobs_{};
+        std::int64_t                             wait_ns_{};      ///< Total enqueue to dequeue
+        std::int64_t                             max_wait_ns_{};  ///< Longest single wait
+        std::int64_t                             busy_ns_{};      ///< Total dequeue to complete
+        std::int64_t                             window_ns_{};    ///< Measured interval
+        std::array<std::uint64_t, wait_buckets> wait_histogram_{};
+
+        /// Fraction of the measured interval spent running jobs
+        QUARISMA_API double utilization() const noexcept;
+
+        /// Time of the measured interval not spent running jobs
+        QUARISMA_API std::int64_t idle_ns() const noexcept;
+
+        /// Average wait per job in nanoseconds
+        QUARISMA_API double mean_wait_ns() const noexcept;
+    };
+
+    /**
+     * @brief Measures one job from dequeue to completion
+     *
+     * Construct it on the worker right before running the job. Does nothing
+     * for an unmeasured stamp.
+     */
+    class job_scope
+    {
+    public:
+        job_scope(const char* pool, std::size_t worker, const stamp& s) noexcept
+            : pool_{pool}, worker_{worker}, stamp_{s}
+        {
+            if (stamp_.enqueued_ns_ != 0)
+            {
+                dequeued_ns_ = pool_instrumentation::start_job(stamp_);
+            }
+        }
+
+        ~job_scope()
+        {
+            if (stamp_.enqueued_ns_ != 0)
+            {
+                pool_instrumentation::finish_job(pool_, worker_, stamp_, dequeued_ns_);
+            }
+        }
+
+        job_scope(const job_scope&)            = delete;
+        job_scope& operator=(const job_scope&) = delete;
+
+    private:
+        const char*  pool_;
+        std::size_t  worker_;
+        stamp        stamp_;
+        std::int64_t dequeued_ns_{};
+    };
+
+    /**
+     * @brief Whether jobs are currently stamped
+     */
+    static bool enabled() noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Start or stop measuring the jobs enqueued from now on
+     *
+     * Enabling starts a new measurement interval, disabling closes it; the
+     * counters themselves are only cleared by reset().
+     */
+    QUARISMA_API static void set_enabled(bool enable) noexcept;
+
+    /**
+     * @brief Stamp a job being enqueued
+     */
+    static stamp on_enqueue() noexcept { return enabled() ? enqueue_stamp() : stamp{}; }
+
+    /**
+     * @brief Counters of every worker that ran a measured job, sorted by pool and worker
+     */
+    QUARISMA_API static std::vector<worker_stats> collect();
+
+    /**
+     * @brief Queue waits of all the measured jobs of a pool, in nanoseconds
+     *
+     * Unlike the log2 histograms of collect(), this log-linear histogram
+     * resolves tail percentiles such as p99.9 to about 6%. It lives for the
+     * rest of the process, so it can be exported once, e.g. through
+     * web_dashboard::add_latency_series(); reset() clears it.
+     *
+     * @param pool Pool name, as in worker_stats::pool_
+     */
+    QUARISMA_API static const latency_histogram& queue_wait_latency(const std::string& pool);
+
+    /**
+     * @brief Clear all counters and restart the measurement interval
+     */
+    QUARISMA_API static void reset();
+
+    /**
+     * @brief Histogram bucket of a wait
+     */
+    QUARISMA_API static std::size_t wait_bucket(std::int64_t wait_ns) noexcept;
+
+    /**
+     * @brief Exclusive upper bound of a histogram bucket, in nanoseconds
+     *
+     * Returns the maximum int64_t value for the last bucket.
+     */
+    QUARISMA_API static std::int64_t wait_bucket_limit_ns(std::size_t bucket) noexcept;
+
+private:
+    QUARISMA_API static stamp        enqueue_stamp() noexcept;
+    QUARISMA_API static std::int64_t start_job(const stamp& s) noexcept;
+    QUARISMA_API static void         finish_job(
+        const char* pool, std::size_t worker, const stamp& s, std::int64_t dequeued_ns) noexcept;
+
+    QUARISMA_API static std::atomic<bool> enabled_;
+};
+
+}  // namespace quarisma
+
+#endif  // PARALLEL_POOL_INSTRUMENTATION_H
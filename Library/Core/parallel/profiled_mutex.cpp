@@ -0,0 +1,312 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#include "parallel/profiled_mutex.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+#include "util/tsc_clock.h"
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+#include "profiler/native/tracing/traceme_encode.h"
+#include "profiler/native/tracing/traceme_recorder.h"
+#endif
+
+namespace quarisma
+{
+
+std::atomic<bool> profiled_mutex::enabled_{false};
+
+namespace
+{
+std::atomic<std::uint32_t> sample_period{64};
+
+std::int64_t now_ns() noexcept
+{
+    // Same clock as traceme, so that the recorded events line up with the trace
+    return tsc_clock::now_ns();
+}
+
+// Loads and stores instead of read-modify-writes: only the thread holding the
+// mutex writes its counters, and collect() merely reads them
+template <typename T>
+void add(std::atomic<T>& counter, T value) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+template <typename T>
+void raise(std::atomic<T>& counter, T value) noexcept
+{
+    if (value > counter.load(std::memory_order_relaxed))
+    {
+        counter.store(value, std::memory_order_relaxed);
+    }
+}
+
+// Whether the acquisition this thread is making gets its hold time measured
+bool sample_hold() noexcept
+{
+    thread_local std::uint32_t countdown = 1;
+    // A shorter period takes effect at once rather than after the current one
+    std::uint32_t const period = sample_period.load(std::memory_order_relaxed);
+    countdown                  = (std::min)(countdown, period);
+    if (--countdown != 0)
+    {
+        return false;
+    }
+    countdown = period;
+    return true;
+}
+}  // namespace
+
+/**
+ * @brief A lock site: its live mutexes and the counters of the destroyed ones
+ *
+ * Sites are never freed, and the registry is leaked, so that the mutexes of
+ * static objects such as the logger's can be destroyed at any time.
+ */
+struct profiled_mutex::site
+{
+    std::string     name_;
+    std::size_t     mutexes_{};
+    profiled_mutex* live_{};
+    site_stats      retired_;
+
+    struct registry
+    {
+        std::mutex                         mutex_;
+        std::vector<std::unique_ptr<site>> sites_;
+    };
+
+    static registry& instance()
+    {
+        static auto* r = new registry();
+        return *r;
+    }
+
+    // Adds the counters of one mutex to `stats`
+    static void accumulate(const counters& c, site_stats& stats) noexcept
+    {
+        stats.acquisitions_ += c.acquisitions_.load(std::memory_order_relaxed);
+        stats.contentions_ += c.contentions_.load(std::memory_order_relaxed);
+        stats.wait_ns_ += c.wait_ns_.load(std::memory_order_relaxed);
+        stats.max_wait_ns_ =
+            (std::max)(stats.max_wait_ns_, c.max_wait_ns_.load(std::memory_order_relaxed));
+        stats.hold_samples_ += c.hold_samples_.load(std::memory_order_relaxed);
+        stats.hold_ns_ += c.hold_ns_.load(std::memory_order_relaxed);
+        stats.max_hold_ns_ =
+            (std::max)(stats.max_hold_ns_, c.max_hold_ns_.load(std::memory_order_relaxed));
+    }
+
+    static void clear(counters& c) noexcept
+    {
+        c.acquisitions_.store(0, std::memory_order_relaxed);
+        c.contentions_.store(0, std::memory_order_relaxed);
+        c.wait_ns_.store(0, std::memory_order_relaxed);
+        c.max_wait_ns_.store(0, std::memory_order_relaxed);
+        c.hold_samples_.store(0, std::memory_order_relaxed);
+        c.hold_ns_.store(0, std::memory_order_relaxed);
+        c.max_hold_ns_.store(0, std::memory_order_relaxed);
+    }
+};
+
+//-----------------------------------------------------------------------------
+double profiled_mutex::site_stats::contention_rate() const noexcept
+{
+    return acquisitions_ != 0
+               ? static_cast<double>(contentions_) / static_cast<double>(acquisitions_)
+               : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+double profiled_mutex::site_stats::mean_wait_ns() const noexcept
+{
+    return contentions_ != 0 ? static_cast<double>(wait_ns_) / static_cast<double>(contentions_)
+                             : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+double profiled_mutex::site_stats::mean_hold_ns() const noexcept
+{
+    return hold_samples_ != 0 ? static_cast<double>(hold_ns_) / static_cast<double>(hold_samples_)
+                              : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+profiled_mutex::profiled_mutex(const char* site_name)
+{
+    auto&                  r = site::instance();
+    std::scoped_lock const lock(r.mutex_);
+    auto                   it = std::find_if(
+        r.sites_.begin(),
+        r.sites_.end(),
+        [site_name](const auto& s) { return s->name_ == site_name; });
+    if (it == r.sites_.end())
+    {
+        auto created            = std::make_unique<site>();
+        created->name_          = site_name;
+        created->retired_.site_ = site_name;
+        r.sites_.push_back(std::move(created));
+        it = std::prev(r.sites_.end());
+    }
+
+    site_ = it->get();
+    ++site_->mutexes_;
+    next_ = site_->live_;
+    if (next_ != nullptr)
+    {
+        next_->prev_ = this;
+    }
+    site_->live_ = this;
+}
+
+//-----------------------------------------------------------------------------
+profiled_mutex::~profiled_mutex()
+{
+    auto&                  r = site::instance();
+    std::scoped_lock const lock(r.mutex_);
+    site::accumulate(counters_, site_->retired_);
+    (prev_ != nullptr ? prev_->next_ : site_->live_) = next_;
+    if (next_ != nullptr)
+    {
+        next_->prev_ = prev_;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void profiled_mutex::lock_profiled()
+{
+    if (mutex_.try_lock())
+    {
+        acquired(0, 0);
+        return;
+    }
+    std::int64_t const start = now_ns();
+    mutex_.lock();
+    acquired(start, now_ns());
+}
+
+//-----------------------------------------------------------------------------
+void profiled_mutex::acquired(std::int64_t wait_start_ns, std::int64_t wait_end_ns) noexcept
+{
+    add(counters_.acquisitions_, std::uint64_t{1});
+    if (wait_start_ns != 0)
+    {
+        std::int64_t const wait_ns = wait_end_ns - wait_start_ns;
+        add(counters_.contentions_, std::uint64_t{1});
+        add(counters_.wait_ns_, wait_ns);
+        raise(counters_.max_wait_ns_, wait_ns);
+
+#if QUARISMA_HAS_NATIVE_PROFILER
+        if (traceme_recorder::active())
+        {
+            traceme_recorder::record(
+                {traceme_encode("lock_wait", {{"site", site_->name_}, {"wait_ns", wait_ns}}),
+                 wait_start_ns,
+                 wait_end_ns});
+        }
+#endif
+    }
+    if (sample_hold())
+    {
+        hold_start_ns_ = wait_end_ns != 0 ? wait_end_ns : now_ns();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void profiled_mutex::release_sampled() noexcept
+{
+    std::int64_t const hold_ns = now_ns() - hold_start_ns_;
+    hold_start_ns_             = 0;
+    add(counters_.hold_samples_, std::uint64_t{1});
+    add(counters_.hold_ns_, hold_ns);
+    raise(counters_.max_hold_ns_, hold_ns);
+}
+
+//-----------------------------------------------------------------------------
+void profiled_mutex::set_enabled(bool enable) noexcept
+{
+    enabled_.store(enable, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+void profiled_mutex::set_hold_sample_period(std::uint32_t period) noexcept
+{
+    sample_period.store((std::max)(period, std::uint32_t{1}), std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+std::uint32_t profiled_mutex::hold_sample_period() noexcept
+{
+    return sample_period.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<profiled_mutex::site_stats> profiled_mutex::collect()
+{
+    auto&                  r = site::instance();
+    std::scoped_lock const lock(r.mutex_);
+
+    std::vector<site_stats> result;
+    for (const auto& s : r.sites_)
+    {
+        site_stats stats = s->retired_;
+        stats.mutexes_   = s->mutexes_;
+        for (const profiled_mutex* m = s->live_; m != nullptr; m = m->next_)
+        {
+            site::accumulate(m->counters_, stats);
+        }
+        if (stats.acquisitions_ != 0)
+        {
+            result.push_back(std::move(stats));
+        }
+    }
+
+    std::sort(
+        result.begin(),
+        result.end(),
+        [](const site_stats& lhs, const site_stats& rhs)
+        {
+            return lhs.wait_ns_ != rhs.wait_ns_ ? lhs.wait_ns_ > rhs.wait_ns_
+                                                : lhs.site_ < rhs.site_;
+        });
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+void profiled_mutex::reset()
+{
+    auto&                  r = site::instance();
+    std::scoped_lock const lock(r.mutex_);
+    for (auto& s : r.sites_)
+    {
+        s->retired_       = site_stats();
+        s->retired_.site_ = s->name_;
+        for (profiled_mutex* m = s->live_; m != nullptr; m = m->next_)
+        {
+            site::clear(m->counters_);
+        }
+    }
+}
+
+}  // namespace quarisma
@@ -0,0 +1,208 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#pragma once
+
+#include <atomic>              // For std::atomic
+#include <condition_variable>  // For std::condition_variable
+#include <cstddef>             // For std::size_t
+#include <cstdint>             // For std::int64_t, std::uint64_t
+#include <mutex>               // For std::mutex, std::unique_lock
+#include <string>              // For std::string
+#include <vector>              // For std::vector
+
+#include "common/export.h"
+#include "common/macros.h"
+
+namespace quarisma
+{
+
+/**
+ * @class profiled_mutex
+ * @brief A std::mutex that measures how it is contended, per lock site
+ *
+ * Every profiled_mutex names its lock site, usually the class and member it
+ * guards. While profiling is enabled, each acquisition records, in counters
+ * next to the mutex and written under it:
+ * - the number of acquisitions, and of those that found the mutex held;
+ * - the time spent waiting for a held mutex, for every contended acquisition,
+ *   whose cost is small next to the wait itself;
+ * - the time the mutex was held, for one acquisition in hold_sample_period()
+ *   on each thread.
+ *
+ * collect() sums the counters of every mutex of a site, live or destroyed.
+ * When the native profiler is built in and a trace is being recorded, each
+ * contended acquisition also produces a `lock_wait` traceme event carrying
+ * the site, so that waits show up on the timeline and in critical paths.
+ *
+ * Disabled, lock() costs one relaxed atomic load more than std::mutex.
+ *
+ * Use it with std::lock_guard, std::unique_lock and std::scoped_lock; wait on
+ * a std::condition_variable through wait(), which hands the underlying mutex
+ * to the condition variable. The reacquisition after a wait is not measured.
+ */
+class QUARISMA_VISIBILITY profiled_mutex
+{
+public:
+    /**
+     * @brief Counters of one lock site, as returned by collect()
+     */
+    struct site_stats
+    {
+        std::string   site_;
+        std::size_t   mutexes_{};       ///< Mutexes of the site ever created
+        std::uint64_t acquisitions_{};  ///< lock() and successful try_lock() calls
+        std::uint64_t contentions_{};   ///< Acquisitions that had to wait
+        std::int64_t  wait_ns_{};       ///< Total wait of the contended acquisitions
+        std::int64_t  max_wait_ns_{};   ///< Longest single wait
+        std::uint64_t hold_samples_{};  ///< Acquisitions whose hold time was measured
+        std::int64_t  hold_ns_{};       ///< Total hold time of the samples
+        std::int64_t  max_hold_ns_{};   ///< Longest sampled hold
+
+        /// Fraction of the acquisitions that had to wait
+        QUARISMA_API double contention_rate() const noexcept;
+
+        /// Average wait per contended acquisition in nanoseconds
+        QUARISMA_API double mean_wait_ns() const noexcept;
+
+        /// Average sampled hold time in nanoseconds
+        QUARISMA_API double mean_hold_ns() const noexcept;
+    };
+
+    /**
+     * @brief Creates a mutex of `site`, which must outlive every profiled_mutex
+     *
+     * Sites are matched by name, so a string literal is the usual argument.
+     */
+    QUARISMA_API explicit profiled_mutex(const char* site);
+    QUARISMA_API ~profiled_mutex();
+
+    profiled_mutex(const profiled_mutex&)            = delete;
+    profiled_mutex& operator=(const profiled_mutex&) = delete;
+
+    void lock()
+    {
+        if QUARISMA_LIKELY (!enabled())
+        {
+            mutex_.lock();
+            return;
+        }
+        lock_profiled();
+    }
+
+    bool try_lock()
+    {
+        if (!mutex_.try_lock())
+        {
+            return false;
+        }
+        if QUARISMA_UNLIKELY (enabled())
+        {
+            acquired(0, 0);
+        }
+        return true;
+    }
+
+    void unlock()
+    {
+        if QUARISMA_UNLIKELY (hold_start_ns_ != 0)
+        {
+            release_sampled();
+        }
+        mutex_.unlock();
+    }
+
+    /**
+     * @brief cv.wait(lock, stop_waiting) on the mutex `lock` owns
+     */
+    template <typename Predicate>
+    static void wait(
+        std::condition_variable&          cv,
+        std::unique_lock<profiled_mutex>& lock,
+        Predicate                         stop_waiting)
+    {
+        profiled_mutex& self = *lock.mutex();
+        if (self.hold_start_ns_ != 0)
+        {
+            self.release_sampled();
+        }
+        std::unique_lock<std::mutex> native(self.mutex_, std::adopt_lock);
+        cv.wait(native, stop_waiting);
+        native.release();
+    }
+
+    /**
+     * @brief Whether acquisitions are currently measured
+     */
+    static bool enabled() noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Start or stop measuring acquisitions
+     */
+    QUARISMA_API static void set_enabled(bool enable) noexcept;
+
+    /**
+     * @brief Acquisitions per thread between two hold-time samples, 64 by default
+     */
+    QUARISMA_API static void set_hold_sample_period(std::uint32_t period) noexcept;
+    QUARISMA_API static std::uint32_t hold_sample_period() noexcept;
+
+    /**
+     * @brief Counters of every site acquired since the last reset(), most waited first
+     */
+    QUARISMA_API static std::vector<site_stats> collect();
+
+    /**
+     * @brief Clear the counters of every site
+     */
+    QUARISMA_API static void reset();
+
+private:
+    struct site;
+
+    /// Counters of this mutex; written only while it is held
+    struct counters
+    {
+        std::atomic<std::uint64_t> acquisitions_{};
+        std::atomic<std::uint64_t> contentions_{};
+        std::atomic<std::int64_t>  wait_ns_{};
+        std::atomic<std::int64_t>  max_wait_ns_{};
+        std::atomic<std::uint64_t> hold_samples_{};
+        std::atomic<std::int64_t>  hold_ns_{};
+        std::atomic<std::int64_t>  max_hold_ns_{};
+    };
+
+    QUARISMA_API void lock_profiled();
+    QUARISMA_API void acquired(std::int64_t wait_start_ns, std::int64_t wait_end_ns) noexcept;
+    QUARISMA_API void release_sampled() noexcept;
+
+    std::mutex   mutex_;
+    std::int64_t hold_start_ns_{};  ///< Acquisition time of a sampled hold, 0 otherwise
+    counters     counters_;
+    site*        site_;
+
+    // Links in the site's list of live mutexes
+    profiled_mutex* prev_{};
+    profiled_mutex* next_{};
+
+    QUARISMA_API static std::atomic<bool> enabled_;
+};
+
+}  // namespace quarisma
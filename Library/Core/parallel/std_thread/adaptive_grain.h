@@ -0,0 +1,127 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @brief Adaptive grain selection for the std_thread parallel_for
+ *
+ * When a loop is submitted without a grain, the first chunk is executed and
+ * timed on the calling thread. The measured cost per iteration sizes the
+ * remaining chunks so that each one runs for roughly `target_chunk_ns`, in the
+ * spirit of TBB's auto_partitioner. Cheap loops get few large chunks (or run
+ * serially when the whole range is cheaper than scheduling it), expensive
+ * loops get small chunks for load balance.
+ *
+ * The learned cost is kept in an adaptive_grain_site, one per call site
+ * (parallel_for instantiates one per functor type), so later calls skip the
+ * probe and refine the estimate from the measured wall time.
+ */
+
+#ifndef PARALLEL_ADAPTIVE_GRAIN_H
+#define PARALLEL_ADAPTIVE_GRAIN_H
+
+#include <algorithm>  // For std::min, std::max
+#include <atomic>     // For std::atomic
+#include <cstddef>    // For std::size_t
+
+namespace quarisma
+{
+namespace detail
+{
+namespace parallel
+{
+
+/**
+ * @brief Learned cost of one call site, in nanoseconds per iteration
+ */
+class adaptive_grain_site
+{
+public:
+    /// Desired duration of one chunk
+    static constexpr double target_chunk_ns = 50000.0;
+
+    /// Fraction of the range timed on the caller when nothing is known yet
+    static constexpr std::size_t probe_divisor = 64;
+
+    /**
+     * @brief Cost per iteration, or a value <= 0 when the site has not been timed.
+     */
+    double cost() const noexcept { return cost_ns_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Blend a new measurement into the learned cost.
+     */
+    void update(double measured_ns) noexcept
+    {
+        if (!(measured_ns > 0.0))
+        {
+            return;
+        }
+        const double previous = cost_ns_.load(std::memory_order_relaxed);
+        cost_ns_.store(
+            previous > 0.0 ? 0.5 * (previous + measured_ns) : measured_ns,
+            std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of iterations timed on the caller for an untimed site.
+     */
+    static std::size_t probe_size(std::size_t n, std::size_t threads) noexcept
+    {
+        const std::size_t divisor = (std::max)(threads, std::size_t{1}) * probe_divisor;
+        return (std::max)(n / divisor, std::size_t{1});
+    }
+
+    /**
+     * @brief Grain for `remaining` iterations of cost `cost_ns` on `threads` threads.
+     *
+     * The result is at most remaining / threads so that every thread gets work.
+     */
+    static std::size_t grain(double cost_ns, std::size_t remaining, std::size_t threads) noexcept
+    {
+        const std::size_t max_grain =
+            (std::max)(remaining / (std::max)(threads, std::size_t{1}), std::size_t{1});
+        if (!(cost_ns > 0.0))
+        {
+            return max_grain;
+        }
+        const double ideal = target_chunk_ns / cost_ns;
+        if (ideal >= static_cast<double>(max_grain))
+        {
+            return max_grain;
+        }
+        return (std::max)(static_cast<std::size_t>(ideal), std::size_t{1});
+    }
+
+    /**
+     * @brief True when `remaining` iterations are too cheap to be worth scheduling.
+     */
+    static bool run_serially(double cost_ns, std::size_t remaining) noexcept
+    {
+        return cost_ns > 0.0 && cost_ns * static_cast<double>(remaining) < 2.0 * target_chunk_ns;
+    }
+
+private:
+    std::atomic<double> cost_ns_{0.0};
+};
+
+}  // namespace parallel
+}  // namespace detail
+}  // namespace quarisma
+
+#endif  // PARALLEL_ADAPTIVE_GRAIN_H
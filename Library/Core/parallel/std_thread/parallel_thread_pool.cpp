@@ -26,10 +26,28 @@
 #include <algorithm>
 #include <cassert>
 #include <condition_variable>
-#include <future>
+#include <cstdint>
+#include <cstdlib>  // For std::getenv
+#include <cstring>  // For std::strcmp
 #include <iostream>
+#include <utility>  // For std::pair
 
 #include "parallel/common/parallel_tools_impl.h"
+#include "parallel/pool_instrumentation.h"
+#include "parallel/profiled_mutex.h"
+#include "parallel/std_thread/work_stealing_deque.h"
+#include "util/cpu_topology.h"
+
+#ifdef __linux__
+#include <pthread.h>  // For pthread_setaffinity_np
+#include <sched.h>    // For sched_getaffinity
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>  // For _mm_pause
+#elif defined(_M_ARM64)
+#include <intrin.h>  // For __yield
+#endif
 
 namespace quarisma
 {
@@ -43,24 +61,110 @@ namespace parallel
  */
 static constexpr std::size_t no_running_job = (std::numeric_limits<std::size_t>::max)();
 
+/**
+ * @brief Pool name reported to pool_instrumentation
+ */
+static constexpr const char* instrumentation_name = "parallel_thread_pool";
+
+/**
+ * @brief Spin and yield budgets of wait_policy::hybrid before blocking
+ *
+ * Roughly 50-100 microseconds of pausing on current x86 cores, then a few
+ * rounds of yielding to let other runnable threads in.
+ */
+static constexpr int wait_spin_count  = 2000;
+static constexpr int wait_yield_count = 64;
+
+/**
+ * @brief Hint to the CPU that the caller is busy-waiting
+ */
+static inline void cpu_pause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#elif defined(_M_ARM64)
+    __yield();
+#endif
+}
+
+/**
+ * @brief Busy-wait for `done` according to the wait policy
+ *
+ * Returns as soon as `done()` holds, or once the spin budget is exhausted so
+ * that the caller falls back to blocking. Under wait_policy::active the budget
+ * is unlimited until the policy changes.
+ */
+template <typename Predicate>
+static void spin_until(
+    const std::atomic<parallel_thread_pool::wait_policy>& policy, Predicate&& done)
+{
+    using wait_policy = parallel_thread_pool::wait_policy;
+
+    if (policy.load(std::memory_order_relaxed) == wait_policy::passive)
+    {
+        return;
+    }
+
+    for (int i = 0; i < wait_spin_count; ++i)
+    {
+        if (done())
+        {
+            return;
+        }
+        cpu_pause();
+    }
+
+    for (int i = 0;
+         i < wait_yield_count || policy.load(std::memory_order_relaxed) == wait_policy::active;
+         ++i)
+    {
+        if (done())
+        {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
 /**
  * @brief Represents a single job/task to be executed by a thread in the pool
  *
  * Each job encapsulates:
- * - The proxy that submitted it (for tracking ownership)
- * - The function to execute
- * - A promise to signal completion
+ * - The proxy that submitted it (for tracking ownership and completion)
+ * - Either a generic function or a fixed-size range descriptor
+ *
+ * Range descriptors (fn, context, from, to) are trivially copyable, so
+ * submitting them never allocates once the queue has reached its capacity.
+ * Jobs are constructed in place in the queue, so construction is the enqueue
+ * time recorded for pool_instrumentation.
  */
 struct parallel_thread_pool::thread_job
 {
     thread_job(proxy_data* proxy = nullptr, std::function<void()> function = nullptr)
-        : proxy_{proxy}, function_{std::move(function)}
+        : proxy_{proxy}, function_{std::move(function)}, stamp_{pool_instrumentation::on_enqueue()}
     {
     }
 
-    proxy_data*           proxy_{};   ///< Proxy that owns this job
-    std::function<void()> function_;  ///< The actual work to be performed
-    std::promise<void>    promise_;   ///< Promise to signal job completion
+    thread_job(
+        proxy_data* proxy, range_function fn, void* context, std::size_t from, std::size_t to)
+        : proxy_{proxy},
+          range_fn_{fn},
+          context_{context},
+          from_{from},
+          to_{to},
+          stamp_{pool_instrumentation::on_enqueue()}
+    {
+    }
+
+    proxy_data*                 proxy_{};     ///< Proxy that owns this job
+    std::function<void()>       function_;    ///< Generic work, empty for range jobs
+    range_function              range_fn_{};  ///< Range work: range_fn_(context_, from_, to_)
+    void*                       context_{};   ///< Opaque pointer forwarded to range_fn_
+    std::size_t                 from_{};      ///< Range start (inclusive)
+    std::size_t                 to_{};        ///< Range end (exclusive)
+    pool_instrumentation::stamp stamp_;       ///< Enqueue time, when instrumented
 };
 
 /**
@@ -74,11 +178,14 @@ struct parallel_thread_pool::thread_job
  */
 struct parallel_thread_pool::thread_data
 {
-    std::vector<thread_job> jobs_;                         ///< Queue of pending jobs
-    std::size_t             running_job_{no_running_job};  ///< Index of active job
-    std::thread             systethread_;                  ///< The actual OS thread
-    std::mutex              mutex_;                        ///< Protects job queue and state
-    std::condition_variable condition_variable_;           ///< For wait/notify operations
+    std::vector<thread_job>  jobs_;                         ///< Queue of pending jobs
+    std::size_t              running_job_{no_running_job};  ///< Index of active job
+    std::thread              systethread_;                  ///< The actual OS thread
+    profiled_mutex           mutex_{"thread_pool"};         ///< Protects job queue and state
+    std::condition_variable  condition_variable_;           ///< For wait/notify operations
+    std::atomic<std::size_t> job_count_{0};                 ///< jobs_.size(), readable unlocked
+    std::atomic<int>         numa_node_{0};                 ///< NUMA node of the pinned CPU
+    std::size_t              index_{};                      ///< Position in threads_
 };
 
 /**
@@ -103,17 +210,167 @@ struct parallel_thread_pool::proxy_thread_data
  *
  * Contains all state needed for a proxy to manage its allocated threads
  * and submitted jobs. Supports nested proxies (local scopes) via parent pointer.
+ * Instances are recycled through a per-thread cache so that allocating a proxy
+ * does not touch the heap in steady state.
  */
 struct parallel_thread_pool::proxy_data
 {
-    parallel_thread_pool*               pool_{};         ///< Owning thread pool
+    parallel_thread_pool*          pool_{};         ///< Owning thread pool
     proxy_data*                    parent_{};       ///< Parent proxy (for nested scopes)
     std::vector<proxy_thread_data> threads_;        ///< Allocated physical threads
     std::size_t                    next_thread_{};  ///< Round-robin index for job distribution
-    std::vector<std::future<void>> jobs_futures_;   ///< Futures for submitted jobs
-    std::mutex                     mutex_;          ///< Protects proxy state
+    std::atomic<std::size_t>       pending_{};      ///< Submitted jobs not completed yet
+    std::mutex                     mutex_;          ///< Serializes updates of pending_
+    std::condition_variable        done_;           ///< Signaled when pending_ drops to zero
+    local_scope_state              scope_;          ///< local_scope() state inherited by jobs
+    proxy_data*                    domain_{};       ///< Top-level proxy sharing the thread budget
+    std::atomic<std::size_t>       budget_used_{};  ///< Threads in use under this top-level proxy
+    std::size_t                    budget_held_{};  ///< Threads this nested proxy added to domain_
+
+    /**
+     * @brief Reserve up to `wanted` extra threads without exceeding `budget` in this domain
+     */
+    std::size_t reserve_budget(std::size_t budget, std::size_t wanted) noexcept
+    {
+        std::size_t used    = budget_used_.load(std::memory_order_relaxed);
+        std::size_t granted = 0;
+        do
+        {
+            granted = used >= budget ? 0 : (std::min)(wanted, budget - used);
+        } while (granted != 0 && !budget_used_.compare_exchange_weak(
+                                     used, used + granted, std::memory_order_relaxed));
+        return granted;
+    }
+};
+
+/**
+ * @brief Shared state of one work-stealing parallel loop
+ *
+ * The loop range is divided into `chunk_count` chunks of `grain` iterations.
+ * Work items are half-open ranges of chunk indices packed into 64 bits
+ * (begin in the high word, end in the low word), so a deque slot is a single
+ * lock-free atomic. Each participating worker owns one deque:
+ * - The owner pops its newest item, keeps halving it (pushing the upper half
+ *   back) and executes the first chunk, which gives lazy binary splitting.
+ * - A worker whose deque is empty steals the oldest, i.e. largest, item from a
+ *   randomly selected victim.
+ * Since the split depth is bounded by log2(chunk_count) <= 32 the fixed deque
+ * capacity is never exceeded in practice; if it were, the owner simply runs the
+ * item without splitting it further.
+ */
+struct parallel_thread_pool::steal_region
+{
+    struct alignas(64) worker_slot
+    {
+        work_stealing_deque<std::uint64_t> deque_;
+    };
+
+    static constexpr std::uint64_t max_chunks = 0xFFFFFFFFULL;
+
+    static std::uint64_t pack(std::uint64_t begin, std::uint64_t end) noexcept
+    {
+        return (begin << 32) | end;
+    }
+
+    range_function           fn_{};
+    void*                    context_{};
+    std::size_t              first_{};
+    std::size_t              last_{};
+    std::size_t              grain_{};
+    std::vector<worker_slot> workers_;
+    std::atomic<std::size_t> remaining_{};  ///< Chunks not executed yet
+
+    void run_item(std::size_t self, std::uint64_t item);
+    bool try_steal(std::size_t self, std::uint32_t& rng, std::uint64_t& item);
+    void work(std::size_t self);
 };
 
+/**
+ * @brief Execute a chunk range, splitting off the upper halves for thieves
+ */
+void parallel_thread_pool::steal_region::run_item(std::size_t self, std::uint64_t item)
+{
+    std::uint64_t begin = item >> 32;
+    std::uint64_t end   = item & max_chunks;
+
+    auto& own = workers_[self].deque_;
+    while (end - begin > 1)
+    {
+        const std::uint64_t middle = begin + (end - begin) / 2;
+        if (!own.push(pack(middle, end)))
+        {
+            break;  // Deque full: run the remainder here
+        }
+        end = middle;
+    }
+
+    // Account for the chunks even if the functor throws, otherwise the
+    // other workers would spin forever waiting for them.
+    struct completion_guard
+    {
+        std::atomic<std::size_t>& remaining_;
+        std::size_t               count_;
+        ~completion_guard() { remaining_.fetch_sub(count_, std::memory_order_acq_rel); }
+    } guard{remaining_, static_cast<std::size_t>(end - begin)};
+
+    for (std::uint64_t chunk = begin; chunk < end; ++chunk)
+    {
+        const std::size_t from = first_ + static_cast<std::size_t>(chunk) * grain_;
+        const std::size_t to   = (std::min)(from + grain_, last_);
+        fn_(context_, from, to);
+    }
+}
+
+/**
+ * @brief Try to steal an item from a random victim
+ *
+ * Uses a per-worker xorshift generator; makes up to 2 * workers attempts so
+ * that a single unlucky draw does not send the worker to yield().
+ */
+bool parallel_thread_pool::steal_region::try_steal(
+    std::size_t self, std::uint32_t& rng, std::uint64_t& item)
+{
+    const std::size_t count = workers_.size();
+    if (count < 2)
+    {
+        return false;
+    }
+
+    for (std::size_t attempt = 0; attempt < 2 * count; ++attempt)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        const std::size_t victim = rng % count;
+        if (victim != self && workers_[victim].deque_.steal(item))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Worker loop: drain the own deque, then steal until every chunk ran
+ */
+void parallel_thread_pool::steal_region::work(std::size_t self)
+{
+    std::uint32_t rng  = static_cast<std::uint32_t>(self) * 2654435761U + 1U;
+    std::uint64_t item = 0;
+
+    while (remaining_.load(std::memory_order_acquire) != 0)
+    {
+        if (workers_[self].deque_.pop(item) || this->try_steal(self, rng, item))
+        {
+            this->run_item(self, item);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
 /**
  * @brief Executes a job on the calling thread
  *
@@ -121,8 +378,8 @@ struct parallel_thread_pool::proxy_data
  * 1. Marks the job as running
  * 2. Releases the lock to allow concurrent operations
  * 3. Executes the job function (with exception handling)
- * 4. Signals completion via the job's promise
- * 5. Removes the job from the queue
+ * 4. Removes the job from the queue
+ * 5. Signals completion to the owning proxy
  *
  * @param data The thread_data containing the job queue
  * @param job_index Index of the job to execute
@@ -132,7 +389,7 @@ struct parallel_thread_pool::proxy_data
  * @note Exceptions from job functions are caught and logged, not propagated
  */
 void parallel_thread_pool::run_job(
-    thread_data& data, std::size_t job_index, std::unique_lock<std::mutex>& lock)
+    thread_data& data, std::size_t job_index, std::unique_lock<profiled_mutex>& lock)
 {
     assert(lock.owns_lock() && "Caller must have locked mutex");
     assert(job_index < data.jobs_.size() && "job_index out of range");
@@ -140,33 +397,67 @@ void parallel_thread_pool::run_job(
     // Save the old running job index (for nested job support)
     const auto old_running_job = data.running_job_;
     data.running_job_          = job_index;
-    auto function              = std::move(data.jobs_[data.running_job_].function_);
+
+    thread_job& job      = data.jobs_[data.running_job_];
+    proxy_data* proxy    = job.proxy_;
+    auto        function = std::move(job.function_);
+    const auto  range_fn = job.range_fn_;
+    void* const context  = job.context_;
+    const auto  from     = job.from_;
+    const auto  to       = job.to_;
+    const auto  stamp    = job.stamp_;
+
+    // Jobs run with the local_scope() state of the thread that allocated their proxy
+    local_scope_state&      scope       = current_local_scope();
+    const local_scope_state outer_scope = scope;
+    scope                               = proxy->scope_;
 
     // Release lock during job execution to allow other threads to proceed
     lock.unlock();
 
     // Execute the job with exception safety
-    try
-    {
-        function();
-    }
-    catch (const std::exception& e)
-    {
-        std::cerr << "Function called by " << parallel_thread_pool::instance().get_thread_id()
-                  << " has thrown an exception. The exception is ignored. what():\n"
-                  << e.what() << std::endl;
-    }
-    catch (...)
     {
-        std::cerr << "Function called by " << parallel_thread_pool::instance().get_thread_id()
-                  << " has thrown an unknown exception. The exception is ignored." << std::endl;
+        const pool_instrumentation::job_scope measure{instrumentation_name, data.index_, stamp};
+        try
+        {
+            if (range_fn != nullptr)
+            {
+                range_fn(context, from, to);
+            }
+            else
+            {
+                function();
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Function called by " << parallel_thread_pool::instance().get_thread_id()
+                      << " has thrown an exception. The exception is ignored. what():\n"
+                      << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "Function called by " << parallel_thread_pool::instance().get_thread_id()
+                      << " has thrown an unknown exception. The exception is ignored."
+                      << std::endl;
+        }
     }
 
+    scope = outer_scope;
+
     // Reacquire lock to clean up job state
     lock.lock();
-    data.jobs_[data.running_job_].promise_.set_value();  // Signal completion
-    data.jobs_.erase(data.jobs_.begin() + job_index);    // Remove completed job
-    data.running_job_ = old_running_job;                 // Restore previous state
+    data.jobs_.erase(data.jobs_.begin() + job_index);  // Remove completed job
+    data.job_count_.store(data.jobs_.size(), std::memory_order_relaxed);
+    data.running_job_ = old_running_job;               // Restore previous state
+
+    // Signal completion. The proxy mutex is held while notifying so that the
+    // joining thread cannot recycle the proxy before we are done with it.
+    const std::lock_guard<std::mutex> proxy_lock{proxy->mutex_};
+    if (--proxy->pending_ == 0)
+    {
+        proxy->done_.notify_all();
+    }
 }
 
 /**
@@ -183,11 +474,24 @@ parallel_thread_pool::proxy::proxy(std::unique_ptr<proxy_data>&& data) : data_{s
  */
 parallel_thread_pool::proxy::~proxy()
 {
-    if (data_ != nullptr && !data_->jobs_futures_.empty())
+    if (data_ == nullptr)
+    {
+        return;
+    }
+
+    if (data_->pending_ != 0)
     {
         std::cerr << "Proxy not joined. Terminating." << std::endl;
         std::terminate();
     }
+
+    // Give the threads borrowed by a nested proxy back to its budget domain
+    if (data_->budget_held_ != 0)
+    {
+        data_->domain_->budget_used_.fetch_sub(data_->budget_held_, std::memory_order_relaxed);
+    }
+
+    parallel_thread_pool::release_proxy_data(std::move(data_));
 }
 
 parallel_thread_pool::proxy::proxy(proxy&&) noexcept                             = default;
@@ -199,7 +503,7 @@ parallel_thread_pool::proxy& parallel_thread_pool::proxy::operator=(proxy&&) noe
  * Behavior depends on whether this is a top-level or nested proxy:
  *
  * Top-level proxy (called from outside thread pool):
- * - Simply waits on all job futures to complete
+ * - Simply waits until all submitted jobs have completed
  *
  * Nested proxy (called from within thread pool):
  * - Actively helps execute jobs from the current thread's queue
@@ -207,20 +511,15 @@ parallel_thread_pool::proxy& parallel_thread_pool::proxy::operator=(proxy&&) noe
  * - Only processes jobs belonging to this proxy
  * - After local jobs are done, waits for jobs on other threads
  *
+ * Completion is tracked by a per-proxy counter rather than one future per job,
+ * which keeps job submission free of heap allocations.
+ *
  * @note Must be called before proxy destruction
  * @note For nested proxies, must be called from the same thread that created the proxy
  */
 void parallel_thread_pool::proxy::join()
 {
-    if (this->is_top_level())
-    {
-        // Top-level proxy: just wait for all futures
-        for (auto& future : data_->jobs_futures_)
-        {
-            future.wait();
-        }
-    }
-    else
+    if (!this->is_top_level())
     {
         // Nested proxy: help execute jobs to prevent deadlock
         thread_data& thread_data_ref = *data_->threads_[0].thread_;
@@ -229,7 +528,7 @@ void parallel_thread_pool::proxy::join()
         // Execute all jobs belonging to this proxy from the current thread's queue
         while (true)
         {
-            std::unique_lock<std::mutex> lock{thread_data_ref.mutex_};
+            std::unique_lock<profiled_mutex> lock{thread_data_ref.mutex_};
 
             // Find next job owned by this proxy
             auto it = std::find_if(
@@ -246,15 +545,15 @@ void parallel_thread_pool::proxy::join()
                 static_cast<std::size_t>(std::distance(thread_data_ref.jobs_.begin(), it));
             run_job(thread_data_ref, job_index, lock);
         }
-
-        // Wait for jobs on other threads to complete
-        for (auto& future : data_->jobs_futures_)
-        {
-            future.wait();
-        }
     }
 
-    data_->jobs_futures_.clear();
+    // Wait for the jobs running on other threads. The lock is still taken after
+    // spinning: the last worker holds it while signaling completion.
+    spin_until(
+        data_->pool_->wait_policy_,
+        [this] { return data_->pending_.load(std::memory_order_acquire) == 0; });
+    std::unique_lock<std::mutex> lock{data_->mutex_};
+    data_->done_.wait(lock, [this] { return data_->pending_ == 0; });
 }
 
 /**
@@ -269,7 +568,6 @@ void parallel_thread_pool::proxy::join()
  *
  * For other threads:
  * - Job is added to the thread's queue
- * - A future is stored to track completion
  * - Thread is notified to wake up and process the job
  *
  * @param job The function to execute
@@ -278,29 +576,65 @@ void parallel_thread_pool::proxy::join()
  * @note Must call join() to ensure all jobs complete
  */
 void parallel_thread_pool::proxy::do_job(std::function<void()> job)
+{
+    this->enqueue(std::move(job));
+}
+
+/**
+ * @brief Submit an allocation-free range job: fn(context, from, to)
+ *
+ * Same scheduling as do_job(std::function), but the job is stored as a fixed-size
+ * descriptor, so no std::function is created and, once the thread queues have
+ * grown to their working size, no memory is allocated.
+ */
+void parallel_thread_pool::proxy::do_job(
+    range_function fn, void* context, std::size_t from, std::size_t to)
+{
+    this->enqueue(fn, context, from, to);
+}
+
+/**
+ * @brief Queue a thread_job built from `args` on the next proxy thread
+ */
+template <typename... Args>
+void parallel_thread_pool::proxy::enqueue(Args&&... args)
 {
     // Round-robin thread selection
     data_->next_thread_ = (data_->next_thread_ + 1) % data_->threads_.size();
-    auto& proxy_thread  = data_->threads_[data_->next_thread_];
+    this->enqueue_on(data_->next_thread_, std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Queue a thread_job built from `args` on proxy thread `thread_index`
+ */
+template <typename... Args>
+void parallel_thread_pool::proxy::enqueue_on(std::size_t thread_index, Args&&... args)
+{
+    auto& proxy_thread = data_->threads_[thread_index];
+
+    {
+        const std::lock_guard<std::mutex> lock{data_->mutex_};
+        ++data_->pending_;
+    }
 
     // Special case: nested proxy submitting to its own thread (thread 0)
-    if (!this->is_top_level() && data_->next_thread_ == 0)
+    if (!this->is_top_level() && thread_index == 0)
     {
         assert(std::this_thread::get_id() == proxy_thread.thread_->systethread_.get_id());
 
         // Add job to queue without notification (will be executed in join())
-        const std::unique_lock<std::mutex> lock{proxy_thread.thread_->mutex_};
-        proxy_thread.thread_->jobs_.emplace_back(data_.get(), std::move(job));
+        const std::unique_lock<profiled_mutex> lock{proxy_thread.thread_->mutex_};
+        proxy_thread.thread_->jobs_.emplace_back(data_.get(), std::forward<Args>(args)...);
+        proxy_thread.thread_->job_count_.store(
+            proxy_thread.thread_->jobs_.size(), std::memory_order_release);
     }
     else
     {
         // Normal case: submit to another thread
-        std::unique_lock<std::mutex> lock{proxy_thread.thread_->mutex_};
-
-        auto& jobs = proxy_thread.thread_->jobs_;
-        jobs.emplace_back(data_.get(), std::move(job));
-        data_->jobs_futures_.emplace_back(jobs.back().promise_.get_future());
-
+        std::unique_lock<profiled_mutex> lock{proxy_thread.thread_->mutex_};
+        proxy_thread.thread_->jobs_.emplace_back(data_.get(), std::forward<Args>(args)...);
+        proxy_thread.thread_->job_count_.store(
+            proxy_thread.thread_->jobs_.size(), std::memory_order_release);
         lock.unlock();
 
         // Wake up the target thread to process the job
@@ -356,10 +690,50 @@ parallel_thread_pool::parallel_thread_pool()
     for (std::size_t i{}; i < thread_count; ++i)
     {
         std::unique_ptr<thread_data> data{new thread_data{}};
+        data->index_       = i;
         data->systethread_ = this->make_thread();
         threads_.emplace_back(std::move(data));
     }
 
+    // Posted jobs belong to a proxy that is never joined and owns no thread, so
+    // that proxies allocated by these jobs may use the whole pool.
+    detached_.reset(new proxy_data{});
+    detached_->pool_   = this;
+    detached_->domain_ = detached_.get();
+
+    // Optional scheduling and grain policy overrides from the environment
+    const char* scheduler = std::getenv("PARALLEL_SCHEDULER");
+    if (scheduler != nullptr && std::strcmp(scheduler, "work_stealing") == 0)
+    {
+        scheduling_policy_.store(scheduling_policy::work_stealing, std::memory_order_relaxed);
+    }
+
+    const char* grain = std::getenv("PARALLEL_GRAIN");
+    if (grain != nullptr && std::strcmp(grain, "adaptive") == 0)
+    {
+        grain_policy_.store(grain_policy::adaptive, std::memory_order_relaxed);
+    }
+
+    const char* wait = std::getenv("PARALLEL_WAIT_POLICY");
+    if (wait != nullptr && std::strcmp(wait, "hybrid") == 0)
+    {
+        wait_policy_.store(wait_policy::hybrid, std::memory_order_relaxed);
+    }
+    else if (wait != nullptr && std::strcmp(wait, "active") == 0)
+    {
+        wait_policy_.store(wait_policy::active, std::memory_order_relaxed);
+    }
+
+    const char* affinity = std::getenv("PARALLEL_AFFINITY");
+    if (affinity != nullptr && std::strcmp(affinity, "pinned") == 0)
+    {
+        this->set_affinity_policy(affinity_policy::pinned);
+    }
+    else if (affinity != nullptr && std::strcmp(affinity, "numa") == 0)
+    {
+        this->set_affinity_policy(affinity_policy::numa);
+    }
+
     // Release worker threads to start processing
     initialized_.store(true, std::memory_order_release);
 }
@@ -408,6 +782,10 @@ parallel_thread_pool::~parallel_thread_pool()
  * - Remaining threads are allocated from threads not used by parent proxies
  * - Returns a proxy with parent pointer set (for hierarchy tracking)
  *
+ * When the caller runs inside parallel_tools::local_scope() with a thread
+ * budget, the top-level proxy is capped to that budget and nested proxies only
+ * borrow free threads while the total used by the hierarchy stays within it.
+ *
  * @param thread_count Number of threads to allocate (0 = use all available)
  * @return A proxy object for submitting jobs
  *
@@ -421,22 +799,48 @@ parallel_thread_pool::proxy parallel_thread_pool::allocate_threads(std::size_t t
         thread_count = this->thread_count();
     }
 
-    std::unique_ptr<proxy_data> proxy{new proxy_data{}};
-    proxy->pool_ = this;
+    std::unique_ptr<proxy_data> proxy = parallel_thread_pool::acquire_proxy_data();
+    proxy->pool_  = this;
+    proxy->scope_ = current_local_scope();
     proxy->threads_.reserve(thread_count);
 
+    const auto budget =
+        static_cast<std::size_t>((std::max)(proxy->scope_.max_number_of_threads_, 0));
+
     thread_data* thread_data_ptr = this->get_caller_thread_data();
     if (thread_data_ptr != nullptr)
     {
         // Nested proxy: allocate from within a parallel region
         proxy->parent_ = thread_data_ptr->jobs_[thread_data_ptr->running_job_].proxy_;
+        proxy->domain_ = proxy->parent_->domain_;
         proxy->threads_.emplace_back(thread_data_ptr, this->get_next_thread_id());
-        this->fill_threads_for_nested_proxy(proxy.get(), thread_count);
+
+        std::size_t extra = thread_count - 1;
+        if (budget != 0)
+        {
+            extra = proxy->domain_->reserve_budget(budget, extra);
+        }
+        this->fill_threads_for_nested_proxy(proxy.get(), 1 + extra);
+
+        if (budget != 0)
+        {
+            // Return the part of the reservation that could not be filled
+            proxy->budget_held_ = proxy->threads_.size() - 1;
+            proxy->domain_->budget_used_.fetch_sub(
+                extra - proxy->budget_held_, std::memory_order_relaxed);
+        }
     }
     else
     {
         // Top-level proxy: allocate from outside the pool
+        if (budget != 0)
+        {
+            thread_count = (std::min)(thread_count, budget);
+        }
+
         proxy->parent_ = nullptr;
+        proxy->domain_ = proxy.get();
+        proxy->budget_used_.store(thread_count, std::memory_order_relaxed);
         for (std::size_t i{}; i < thread_count; ++i)
         {
             proxy->threads_.emplace_back(threads_[i].get(), this->get_next_thread_id());
@@ -446,6 +850,27 @@ parallel_thread_pool::proxy parallel_thread_pool::allocate_threads(std::size_t t
     return parallel_thread_pool::proxy{std::move(proxy)};
 }
 
+/**
+ * @brief Queue a job on the next worker, round-robin, with nothing to join
+ */
+void parallel_thread_pool::post(std::function<void()> job)
+{
+    thread_data& target =
+        *threads_[next_post_thread_.fetch_add(1, std::memory_order_relaxed) % threads_.size()];
+
+    {
+        const std::lock_guard<std::mutex> lock{detached_->mutex_};
+        ++detached_->pending_;
+    }
+
+    {
+        const std::lock_guard<profiled_mutex> lock{target.mutex_};
+        target.jobs_.emplace_back(detached_.get(), std::move(job));
+        target.job_count_.store(target.jobs_.size(), std::memory_order_release);
+    }
+    target.condition_variable_.notify_one();
+}
+
 /**
  * @brief Get the virtual thread ID for the calling thread
  *
@@ -465,7 +890,7 @@ std::size_t parallel_thread_pool::get_thread_id() const noexcept
 
     if (thread_data_ptr != nullptr)
     {
-        std::unique_lock<std::mutex> lock{thread_data_ptr->mutex_};
+        std::unique_lock<profiled_mutex> lock{thread_data_ptr->mutex_};
         assert(thread_data_ptr->running_job_ != no_running_job && "Invalid state");
         const auto& proxy_threads =
             thread_data_ptr->jobs_[thread_data_ptr->running_job_].proxy_->threads_;
@@ -499,8 +924,8 @@ bool parallel_thread_pool::is_parallel_scope() const noexcept
  * @brief Check if the calling thread is the "master" thread of its proxy
  *
  * Returns true for thread 0 of the current proxy (the first thread in
- * the proxy's thread list). Used for implementing single-threaded regions
- * within parallel code.
+ * the proxy's thread list), and for jobs run by post(), which are alone.
+ * Used for implementing single-threaded regions within parallel code.
  *
  * @return true if this is the first thread of the current proxy, false otherwise
  */
@@ -511,8 +936,9 @@ bool parallel_thread_pool::single_thread() const
     {
         const std::scoped_lock lock{thread_data_ptr->mutex_};
         assert(thread_data_ptr->running_job_ != no_running_job && "Invalid state");
-        return thread_data_ptr->jobs_[thread_data_ptr->running_job_].proxy_->threads_[0].thread_ ==
-               thread_data_ptr;
+        const auto& proxy_threads =
+            thread_data_ptr->jobs_[thread_data_ptr->running_job_].proxy_->threads_;
+        return proxy_threads.empty() || proxy_threads[0].thread_ == thread_data_ptr;
     }
 
     return false;
@@ -528,6 +954,292 @@ std::size_t parallel_thread_pool::thread_count() const noexcept
     return threads_.size();
 }
 
+/**
+ * @brief Set the scheduling policy used by parallel_tools loops
+ */
+void parallel_thread_pool::set_scheduling_policy(scheduling_policy policy) noexcept
+{
+    scheduling_policy_.store(policy, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get the scheduling policy used by parallel_tools loops
+ */
+parallel_thread_pool::scheduling_policy parallel_thread_pool::get_scheduling_policy()
+    const noexcept
+{
+    return scheduling_policy_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set how parallel_tools loops pick their grain when none is given
+ */
+void parallel_thread_pool::set_grain_policy(grain_policy policy) noexcept
+{
+    grain_policy_.store(policy, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get how parallel_tools loops pick their grain when none is given
+ */
+parallel_thread_pool::grain_policy parallel_thread_pool::get_grain_policy() const noexcept
+{
+    return grain_policy_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set how idle workers and joining threads wait
+ */
+void parallel_thread_pool::set_wait_policy(wait_policy policy) noexcept
+{
+    wait_policy_.store(policy, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get how idle workers and joining threads wait
+ */
+parallel_thread_pool::wait_policy parallel_thread_pool::get_wait_policy() const noexcept
+{
+    return wait_policy_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief CPUs the process may run on, ordered by (NUMA node, SMT rank, CPU id)
+ *
+ * Each entry is {cpu, node}; the node is 0 when NUMA support is unavailable.
+ * Within a node, one processor of every core comes before any SMT sibling, so
+ * the first workers each get a core of their own. Empty on platforms without
+ * affinity support.
+ */
+static std::vector<std::pair<int, int>> allowed_cpus_by_node()
+{
+    std::vector<std::pair<int, int>> cpus;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+    {
+        return cpus;
+    }
+    const cpu_topology& topology = cpu_topology::instance();
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &mask))
+        {
+            cpus.emplace_back(cpu, topology.processor(cpu).numa_node);
+        }
+    }
+    std::stable_sort(
+        cpus.begin(),
+        cpus.end(),
+        [&topology](const auto& a, const auto& b)
+        {
+            return std::make_pair(a.second, topology.processor(a.first).smt) <
+                   std::make_pair(b.second, topology.processor(b.first).smt);
+        });
+#endif
+    return cpus;
+}
+
+/**
+ * @brief Pin (or unpin) every worker and record its NUMA node
+ *
+ * Worker i goes to the i-th allowed CPU (wrapping when there are more workers
+ * than CPUs). affinity_policy::none restores the process-wide allowed mask.
+ */
+void parallel_thread_pool::set_affinity_policy(affinity_policy policy)
+{
+    const auto cpus = allowed_cpus_by_node();
+
+    for (std::size_t i = 0; i < threads_.size(); ++i)
+    {
+        thread_data& data = *threads_[i];
+        if (cpus.empty())
+        {
+            data.numa_node_.store(0, std::memory_order_relaxed);
+            continue;
+        }
+
+        const auto& placement = cpus[i % cpus.size()];
+#ifdef __linux__
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (policy == affinity_policy::none)
+        {
+            for (const auto& cpu : cpus)
+            {
+                CPU_SET(cpu.first, &mask);
+            }
+        }
+        else
+        {
+            CPU_SET(placement.first, &mask);
+        }
+        pthread_setaffinity_np(data.systethread_.native_handle(), sizeof(mask), &mask);
+#endif
+        data.numa_node_.store(
+            policy == affinity_policy::none ? 0 : placement.second, std::memory_order_relaxed);
+    }
+
+    affinity_policy_.store(policy, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get the current worker placement policy
+ */
+parallel_thread_pool::affinity_policy parallel_thread_pool::get_affinity_policy() const noexcept
+{
+    return affinity_policy_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Get the NUMA node recorded for the calling worker
+ */
+int parallel_thread_pool::get_thread_numa_node() const noexcept
+{
+    const thread_data* data = this->get_caller_thread_data();
+    return data != nullptr ? data->numa_node_.load(std::memory_order_relaxed) : -1;
+}
+
+/**
+ * @brief Execute a chunked loop giving each NUMA node a contiguous segment
+ *
+ * Sequence:
+ * 1. Allocate a proxy and group its threads by the node of their CPU
+ * 2. Give each group a share of [first, last) proportional to its size
+ * 3. Queue the chunks of a segment round-robin on that group's threads only
+ *
+ * Grouping scans the proxy's thread list instead of building per-node lists
+ * so that the loop stays allocation-free.
+ */
+void parallel_thread_pool::parallel_for_numa(
+    std::size_t    first,
+    std::size_t    last,
+    std::size_t    grain,
+    std::size_t    thread_count,
+    range_function fn,
+    void*          context)
+{
+    if (last <= first)
+    {
+        return;
+    }
+
+    grain              = (std::max)(grain, std::size_t{1});
+    auto        proxy  = this->allocate_threads(thread_count);
+    const auto& thread = proxy.data_->threads_;
+    const auto  count  = thread.size();
+    const auto  n      = last - first;
+
+    const auto node_of = [&thread](std::size_t i)
+    { return thread[i].thread_->numa_node_.load(std::memory_order_relaxed); };
+
+    std::size_t threads_before = 0;
+    for (std::size_t leader = 0; leader < count; ++leader)
+    {
+        // Only the first thread of each node starts a group
+        const int node = node_of(leader);
+        bool      seen = false;
+        for (std::size_t i = 0; i < leader && !seen; ++i)
+        {
+            seen = node_of(i) == node;
+        }
+        if (seen)
+        {
+            continue;
+        }
+
+        std::size_t group_size = 0;
+        for (std::size_t i = leader; i < count; ++i)
+        {
+            group_size += node_of(i) == node ? 1 : 0;
+        }
+
+        const std::size_t begin = first + n * threads_before / count;
+        const std::size_t end   = first + n * (threads_before + group_size) / count;
+        threads_before += group_size;
+
+        std::size_t target = leader;
+        for (std::size_t from = begin; from < end; from += grain)
+        {
+            proxy.enqueue_on(target, fn, context, from, (std::min)(from + grain, end));
+            do
+            {
+                target = (target + 1) % count;
+            } while (node_of(target) != node);
+        }
+    }
+
+    proxy.join();
+}
+
+/**
+ * @brief Execute a chunked loop with per-worker deques and random-victim stealing
+ *
+ * Sequence:
+ * 1. Compute the chunk count, coarsening the grain if it exceeds 32 bits
+ * 2. Allocate a proxy and seed one contiguous block of chunks per worker
+ * 3. Queue a single steal_region::work() job per worker and join
+ *
+ * The deques are seeded before the jobs are queued; the per-thread mutex taken
+ * by do_job() publishes the seeded items to their owners.
+ *
+ * @param first Start of the range (inclusive)
+ * @param last End of the range (exclusive)
+ * @param grain Number of iterations per chunk (0 is treated as 1)
+ * @param thread_count Maximum number of threads to use (0 = all)
+ * @param fn Chunk callback
+ * @param context Opaque pointer forwarded to fn
+ */
+void parallel_thread_pool::parallel_for_work_stealing(
+    std::size_t    first,
+    std::size_t    last,
+    std::size_t    grain,
+    std::size_t    thread_count,
+    range_function fn,
+    void*          context)
+{
+    if (last <= first)
+    {
+        return;
+    }
+
+    const std::size_t n = last - first;
+    grain               = (std::max)(grain, std::size_t{1});
+    if ((n - 1) / grain + 1 > steal_region::max_chunks)
+    {
+        grain = (n - 1) / static_cast<std::size_t>(steal_region::max_chunks) + 1;
+    }
+    const std::size_t chunk_count = (n - 1) / grain + 1;
+
+    auto              proxy   = this->allocate_threads(thread_count);
+    const std::size_t workers = (std::min)(proxy.data_->threads_.size(), chunk_count);
+
+    steal_region region;
+    region.fn_      = fn;
+    region.context_ = context;
+    region.first_   = first;
+    region.last_    = last;
+    region.grain_   = grain;
+    region.workers_ = std::vector<steal_region::worker_slot>(workers);
+    region.remaining_.store(chunk_count, std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < workers; ++i)
+    {
+        const std::uint64_t begin = chunk_count * i / workers;
+        const std::uint64_t end   = chunk_count * (i + 1) / workers;
+        region.workers_[i].deque_.push(steal_region::pack(begin, end));
+    }
+
+    const auto work = [](void* context, std::size_t self, std::size_t)
+    { static_cast<steal_region*>(context)->work(self); };
+    for (std::size_t i = 0; i < workers; ++i)
+    {
+        proxy.do_job(work, &region, i, i + 1);
+    }
+    proxy.join();
+}
+
 /**
  * @brief Find thread_data for the calling thread
  *
@@ -578,10 +1290,20 @@ std::thread parallel_thread_pool::make_thread()
                            // Main worker loop
                            while (true)
                            {
-                               std::unique_lock<std::mutex> lock{thread_data_ref.mutex_};
+                               spin_until(
+                                   wait_policy_,
+                                   [this, &thread_data_ref]
+                                   {
+                                       return thread_data_ref.job_count_.load(
+                                                  std::memory_order_acquire) != 0 ||
+                                              joining_.load(std::memory_order_acquire);
+                                   });
+
+                               std::unique_lock<profiled_mutex> lock{thread_data_ref.mutex_};
 
                                // Wait for work or shutdown signal
-                               thread_data_ref.condition_variable_.wait(
+                               profiled_mutex::wait(
+                                   thread_data_ref.condition_variable_,
                                    lock,
                                    [this, &thread_data_ref]
                                    {
@@ -622,9 +1344,10 @@ std::thread parallel_thread_pool::make_thread()
  */
 void parallel_thread_pool::fill_threads_for_nested_proxy(proxy_data* proxy, std::size_t max_count)
 {
-    if (proxy->parent_->threads_.size() == threads_.size())
+    if (proxy->parent_->threads_.size() == threads_.size() ||
+        proxy->threads_.size() >= max_count)
     {
-        return;  // Parent uses all threads, none available
+        return;  // Parent uses all threads or no extra thread requested
     }
 
     // Lambda to check if a thread is free (not used by any ancestor proxy)
@@ -658,6 +1381,75 @@ void parallel_thread_pool::fill_threads_for_nested_proxy(proxy_data* proxy, std:
     }
 }
 
+/**
+ * @brief Per-thread cache of released proxy_data objects
+ *
+ * The depth of the cache bounds the number of simultaneously alive proxies a
+ * thread can allocate without touching the heap (one per nesting level).
+ */
+namespace
+{
+constexpr std::size_t proxy_data_cache_size = 8;
+}  // namespace
+
+std::vector<std::unique_ptr<parallel_thread_pool::proxy_data>>& parallel_thread_pool::
+    proxy_data_cache() noexcept
+{
+    thread_local std::vector<std::unique_ptr<proxy_data>> cache;
+    return cache;
+}
+
+/**
+ * @brief Get a reset proxy_data, reusing a cached one when possible
+ *
+ * Reused objects keep the capacity of their thread list.
+ */
+std::unique_ptr<parallel_thread_pool::proxy_data> parallel_thread_pool::acquire_proxy_data()
+{
+    auto& cache = parallel_thread_pool::proxy_data_cache();
+    if (cache.empty())
+    {
+        return std::unique_ptr<proxy_data>{new proxy_data{}};
+    }
+
+    std::unique_ptr<proxy_data> data = std::move(cache.back());
+    cache.pop_back();
+
+    data->pool_        = nullptr;
+    data->parent_      = nullptr;
+    data->domain_      = nullptr;
+    data->next_thread_ = 0;
+    data->pending_     = 0;
+    data->scope_       = local_scope_state{};
+    data->budget_used_.store(0, std::memory_order_relaxed);
+    data->budget_held_ = 0;
+    data->threads_.clear();
+    return data;
+}
+
+/**
+ * @brief Return a proxy_data to the calling thread's cache
+ */
+void parallel_thread_pool::release_proxy_data(std::unique_ptr<proxy_data>&& data) noexcept
+{
+    auto& cache = parallel_thread_pool::proxy_data_cache();
+    if (cache.size() < proxy_data_cache_size)
+    {
+        if (cache.capacity() == 0)
+        {
+            try
+            {
+                cache.reserve(proxy_data_cache_size);
+            }
+            catch (...)
+            {
+                return;  // data is freed by the caller
+            }
+        }
+        cache.push_back(std::move(data));
+    }
+}
+
 /**
  * @brief Get the next unique virtual thread ID
  *
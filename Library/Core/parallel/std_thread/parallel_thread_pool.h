@@ -36,11 +36,13 @@
 
 #include <atomic>      // For std::atomic
 #include <functional>  // For std::function
+#include <memory>      // For std::unique_ptr
 #include <mutex>       // For std::unique_lock
 #include <thread>      // For std::thread
 #include <vector>      // For std::vector
 
 #include "common/export.h"
+#include "parallel/profiled_mutex.h"
 
 namespace quarisma
 {
@@ -64,8 +66,52 @@ class QUARISMA_VISIBILITY parallel_thread_pool
     struct thread_data;
     struct proxy_thread_data;
     struct proxy_data;
+    struct steal_region;
 
 public:
+    /**
+   * @brief Scheduling policy used by parallel loops submitted through the pool.
+   */
+    enum class scheduling_policy
+    {
+        round_robin,   ///< One queued job per chunk, dealt round-robin to the proxy threads
+        work_stealing  ///< One job per thread, chunks balanced through per-worker deques
+    };
+
+    /**
+   * @brief Grain selection used by parallel_tools loops submitted without a grain.
+   */
+    enum class grain_policy
+    {
+        fixed,    ///< (last - first) / (4 * threads)
+        adaptive  ///< Time the first chunk, size the rest, remember the cost per call site
+    };
+
+    /**
+   * @brief Placement of the pool workers on the machine.
+   */
+    enum class affinity_policy
+    {
+        none,    ///< Workers float over every allowed CPU (default)
+        pinned,  ///< Worker i is pinned to one CPU, CPUs ordered by NUMA node then core
+        numa     ///< pinned, and parallel loops give each node a contiguous share of the range
+    };
+
+    /**
+   * @brief How idle threads wait for work, in the spirit of OMP_WAIT_POLICY.
+   */
+    enum class wait_policy
+    {
+        passive,  ///< Block on the condition variable as soon as there is nothing to do (default)
+        hybrid,   ///< Spin with a CPU pause, then yield, then block
+        active    ///< Spin, then yield until work arrives; never block
+    };
+
+    /**
+   * @brief Chunk callback used by parallel_for_work_stealing(): fn(context, from, to).
+   */
+    using range_function = void (*)(void* context, std::size_t from, std::size_t to);
+
     /**
    * @brief Proxy class used to submit work to the thread pool.
    */
@@ -88,6 +134,14 @@ public:
      */
         QUARISMA_API void do_job(std::function<void()> job);
 
+        /**
+     * @brief Add a range job fn(context, from, to) to the thread pool queue.
+     *
+     * Unlike the std::function overload this never allocates per job.
+     */
+        QUARISMA_API void do_job(
+            range_function fn, void* context, std::size_t from, std::size_t to);
+
         /**
      * @brief Get a reference on all system threads used by this proxy
      */
@@ -103,6 +157,12 @@ public:
 
         proxy(std::unique_ptr<proxy_data>&& data);
 
+        template <typename... Args>
+        void enqueue(Args&&... args);
+
+        template <typename... Args>
+        void enqueue_on(std::size_t thread_index, Args&&... args);
+
         std::unique_ptr<proxy_data> data_;
     };
 
@@ -116,6 +176,16 @@ public:
    */
     QUARISMA_API proxy allocate_threads(std::size_t thread_count = 0);
 
+    /**
+   * @brief Run `job` on a pool thread without waiting for it
+   *
+   * Unlike proxy::do_job() there is nothing to join: posted jobs are dealt to
+   * the workers in turn and complete on their own. A parallel loop inside a
+   * posted job is nested parallelism. Exceptions are reported like those of
+   * proxy jobs. Jobs still queued when the pool is destroyed are run first.
+   */
+    QUARISMA_API void post(std::function<void()> job);
+
     /**
    * Value returned by `get_thread_id` when called by a thread that does not belong to the pool.
    */
@@ -141,14 +211,119 @@ public:
    */
     QUARISMA_API std::size_t thread_count() const noexcept;
 
+    /**
+   * @brief Select the scheduling policy used by parallel_tools on this pool.
+   *
+   * The initial value is read from the PARALLEL_SCHEDULER environment variable
+   * ("work_stealing" or "round_robin"), defaulting to round_robin.
+   */
+    QUARISMA_API void set_scheduling_policy(scheduling_policy policy) noexcept;
+
+    /**
+   * @brief Returns the scheduling policy used by parallel_tools on this pool.
+   */
+    QUARISMA_API scheduling_policy get_scheduling_policy() const noexcept;
+
+    /**
+   * @brief Select how parallel_tools picks the grain when none is given.
+   *
+   * The initial value is read from the PARALLEL_GRAIN environment variable
+   * ("adaptive" or "fixed"), defaulting to fixed.
+   */
+    QUARISMA_API void set_grain_policy(grain_policy policy) noexcept;
+
+    /**
+   * @brief Returns how parallel_tools picks the grain when none is given.
+   */
+    QUARISMA_API grain_policy get_grain_policy() const noexcept;
+
+    /**
+   * @brief Pin the workers according to `policy`.
+   *
+   * Workers are assigned to the CPUs the process may run on, sorted by NUMA
+   * node, so that consecutive workers (which top-level proxies allocate first)
+   * share a node, and within a node by SMT rank (see cpu_topology), so that
+   * workers take separate cores before SMT siblings. Pinning is only
+   * implemented on Linux; elsewhere the policy is recorded but workers are
+   * not moved. The initial value is read from the PARALLEL_AFFINITY
+   * environment variable ("pinned" or "numa").
+   */
+    QUARISMA_API void set_affinity_policy(affinity_policy policy);
+
+    /**
+   * @brief Returns the current worker placement policy.
+   */
+    QUARISMA_API affinity_policy get_affinity_policy() const noexcept;
+
+    /**
+   * @brief Select how idle workers and joining threads wait.
+   *
+   * Spinning before blocking lets back-to-back small parallel loops reach the
+   * workers without a futex wake-up, at the cost of burning CPU while idle.
+   * The initial value is read from the PARALLEL_WAIT_POLICY environment
+   * variable ("passive", "hybrid" or "active"), defaulting to passive.
+   */
+    QUARISMA_API void set_wait_policy(wait_policy policy) noexcept;
+
+    /**
+   * @brief Returns how idle workers and joining threads wait.
+   */
+    QUARISMA_API wait_policy get_wait_policy() const noexcept;
+
+    /**
+   * @brief NUMA node of the calling worker, 0 when unknown, -1 outside the pool.
+   */
+    QUARISMA_API int get_thread_numa_node() const noexcept;
+
+    /**
+   * @brief Run fn over [first, last) in chunks of `grain`, split by NUMA node.
+   *
+   * The allocated threads are grouped by node and each group receives one
+   * contiguous segment of the range, proportional to its size; chunks of a
+   * segment are only queued on that group's threads. Repeated loops over the
+   * same range therefore touch the same pages from the same node, which keeps
+   * first-touch placed data local.
+   */
+    QUARISMA_API void parallel_for_numa(
+        std::size_t    first,
+        std::size_t    last,
+        std::size_t    grain,
+        std::size_t    thread_count,
+        range_function fn,
+        void*          context);
+
+    /**
+   * @brief Run fn over [first, last) in chunks of `grain` with work stealing.
+   *
+   * The range is split into one contiguous block of chunks per allocated thread.
+   * Each worker keeps its block in a lock-free deque, lazily halving it so that
+   * idle workers can steal the largest remaining pieces from random victims.
+   * Only one job is queued per thread, so the mutex/condition variable cost is
+   * paid once per worker instead of once per chunk.
+   *
+   * May be called from inside the pool; the nested proxy rules of
+   * allocate_threads() apply.
+   */
+    QUARISMA_API void parallel_for_work_stealing(
+        std::size_t    first,
+        std::size_t    last,
+        std::size_t    grain,
+        std::size_t    thread_count,
+        range_function fn,
+        void*          context);
+
     QUARISMA_API static parallel_thread_pool& instance();
 
 private:
     static void run_job(
-        thread_data& data, std::size_t job_index, std::unique_lock<std::mutex>& lock);
+        thread_data& data, std::size_t job_index, std::unique_lock<profiled_mutex>& lock);
 
     thread_data* get_caller_thread_data() const noexcept;
 
+    static std::vector<std::unique_ptr<proxy_data>>& proxy_data_cache() noexcept;
+    static std::unique_ptr<proxy_data>               acquire_proxy_data();
+    static void release_proxy_data(std::unique_ptr<proxy_data>&& data) noexcept;
+
     std::thread make_thread();
     void        fill_threads_for_nested_proxy(proxy_data* proxy, std::size_t max_count);
     std::size_t get_next_thread_id() noexcept;
@@ -157,6 +332,12 @@ private:
     std::atomic<bool>                         joining_{};
     std::vector<std::unique_ptr<thread_data>> threads_;  // Thread pool, fixed size
     std::atomic<std::size_t>                  next_proxy_thread_id_{1};
+    std::atomic<scheduling_policy>            scheduling_policy_{scheduling_policy::round_robin};
+    std::atomic<grain_policy>                 grain_policy_{grain_policy::fixed};
+    std::atomic<affinity_policy>              affinity_policy_{affinity_policy::none};
+    std::atomic<wait_policy>                  wait_policy_{wait_policy::passive};
+    std::unique_ptr<proxy_data>               detached_;  // Owner of the jobs run by post()
+    std::atomic<std::size_t>                  next_post_thread_{0};
 };
 
 }  // namespace parallel
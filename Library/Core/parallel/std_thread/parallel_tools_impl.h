@@ -25,10 +25,12 @@
 #define STDTHREAD_PARALLEL_TOOLS_IMPL_H
 
 #include <algorithm>   // For std::sort
+#include <chrono>      // For std::chrono::steady_clock
 #include <functional>  // For std::bind
 
 #include "common/export.h"
 #include "parallel/common/parallel_tools_impl.h"
+#include "parallel/std_thread/adaptive_grain.h"        // For adaptive_grain_site
 #include "parallel/std_thread/parallel_thread_pool.h"  // For parallel_thread_pool
 
 namespace quarisma
@@ -40,6 +42,13 @@ namespace parallel
 
 int QUARISMA_API number_of_threads_stdthread();
 
+//--------------------------------------------------------------------------------
+inline double elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
 //--------------------------------------------------------------------------------
 template <>
 template <typename FunctorInternal>
@@ -52,29 +61,91 @@ void parallel_tools_impl<backend_type::std_thread>::parallel_for(
         return;
     }
 
-    if (grain >= n || (!nested_activated_ && parallel_thread_pool::instance().is_parallel_scope()))
+    if (grain >= n || (!scoped_nested_parallelism(nested_activated_) &&
+                       parallel_thread_pool::instance().is_parallel_scope()))
     {
         fi.Execute(first, last);
     }
     else
     {
-        int thread_number = number_of_threads_stdthread();
+        int   thread_number = scoped_number_of_threads(number_of_threads_stdthread());
+        auto& pool          = detail::parallel::parallel_thread_pool::instance();
 
-        if (grain <= 0)
+        const auto execute = [](void* functor, size_t from, size_t to)
+        { static_cast<FunctorInternal*>(functor)->Execute(from, to); };
+
+        // Adaptive grain: one learned cost per call site (functor type)
+        adaptive_grain_site* site = nullptr;
+        if (grain <= 0 && pool.get_grain_policy() == parallel_thread_pool::grain_policy::adaptive)
+        {
+            static adaptive_grain_site call_site;
+            site = &call_site;
+
+            const auto threads = static_cast<size_t>(thread_number);
+            double     cost    = site->cost();
+            if (!(cost > 0.0))
+            {
+                // Untimed call site: time a probe chunk on the caller
+                const size_t probe = adaptive_grain_site::probe_size(n, threads);
+                const auto   start = std::chrono::steady_clock::now();
+                fi.Execute(first, first + probe);
+                cost = elapsed_ns(start) / static_cast<double>(probe);
+                site->update(cost);
+
+                first += probe;
+                if (first == last)
+                {
+                    return;
+                }
+            }
+
+            if (adaptive_grain_site::run_serially(cost, last - first))
+            {
+                const auto start = std::chrono::steady_clock::now();
+                fi.Execute(first, last);
+                site->update(elapsed_ns(start) / static_cast<double>(last - first));
+                return;
+            }
+            grain = adaptive_grain_site::grain(cost, last - first, threads);
+        }
+        else if (grain <= 0)
         {
             size_t estimate_grain = (last - first) / (thread_number * 4);
             grain                 = (estimate_grain > 0) ? estimate_grain : 1;
         }
 
-        auto proxy = detail::parallel::parallel_thread_pool::instance().allocate_threads(thread_number);
-
-        for (size_t from = first; from < last; from += grain)
+        const auto start = std::chrono::steady_clock::now();
+        if (pool.get_scheduling_policy() ==
+            parallel_thread_pool::scheduling_policy::work_stealing)
         {
-            const auto to = (std::min)(from + grain, last);
-            proxy.do_job([&fi, from, to] { fi.Execute(from, to); });
+            pool.parallel_for_work_stealing(first, last, grain, thread_number, execute, &fi);
         }
+        else if (pool.get_affinity_policy() == parallel_thread_pool::affinity_policy::numa)
+        {
+            pool.parallel_for_numa(first, last, grain, thread_number, execute, &fi);
+        }
+        else
+        {
+            auto proxy = pool.allocate_threads(thread_number);
+
+            for (size_t from = first; from < last; from += grain)
+            {
+                const auto to = (std::min)(from + grain, last);
+                proxy.do_job(execute, &fi, from, to);
+            }
 
-        proxy.join();
+            proxy.join();
+        }
+
+        if (site != nullptr)
+        {
+            // Wall time spread over the threads that had work gives the cost per item
+            const size_t items   = last - first;
+            const size_t chunks  = (items - 1) / grain + 1;
+            const size_t workers = (std::min)(static_cast<size_t>(thread_number), chunks);
+            site->update(
+                elapsed_ns(start) * static_cast<double>(workers) / static_cast<double>(items));
+        }
     }
 }
 
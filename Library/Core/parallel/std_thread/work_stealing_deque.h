@@ -0,0 +1,159 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @class work_stealing_deque
+ * @brief Bounded single-owner, multi-thief lock-free deque (Chase-Lev)
+ *
+ * The owner thread pushes and pops at the bottom (LIFO, cache friendly) while
+ * any other thread may steal from the top (FIFO, oldest and usually largest
+ * work item). The implementation follows "Correct and Efficient Work-Stealing
+ * for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013), with a
+ * fixed power-of-two capacity so that no memory is ever reclaimed while a
+ * thief may still be reading a slot.
+ *
+ * Elements must fit in a lock-free std::atomic; the std_thread scheduler
+ * stores packed chunk ranges (two 32-bit indices in a std::uint64_t).
+ */
+
+#ifndef PARALLEL_WORK_STEALING_DEQUE_H
+#define PARALLEL_WORK_STEALING_DEQUE_H
+
+#include <array>        // For std::array
+#include <atomic>       // For std::atomic
+#include <cstddef>      // For std::size_t
+#include <cstdint>      // For std::int64_t
+#include <type_traits>  // For std::is_trivially_copyable
+
+namespace quarisma
+{
+namespace detail
+{
+namespace parallel
+{
+
+template <typename T, std::size_t Capacity = 64>
+class work_stealing_deque
+{
+    static_assert(
+        Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    static_assert(std::atomic<T>::is_always_lock_free, "T must be lock-free when atomic");
+
+public:
+    work_stealing_deque() = default;
+
+    work_stealing_deque(const work_stealing_deque&)            = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    /**
+     * @brief Push an item at the bottom. Owner thread only.
+     *
+     * @return false if the deque is full; the caller keeps ownership of the item.
+     */
+    bool push(T value) noexcept
+    {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        if (b - t >= static_cast<std::int64_t>(Capacity))
+        {
+            return false;
+        }
+        slot(b).store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Pop the most recently pushed item. Owner thread only.
+     */
+    bool pop(T& value) noexcept
+    {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // Empty: restore bottom.
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = slot(b).load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last item: race against thieves for it.
+            const bool won = top_.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Steal the oldest item. Safe to call from any thread.
+     *
+     * May fail spuriously when racing with another thief or the owner.
+     */
+    bool steal(T& value) noexcept
+    {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return false;
+        }
+
+        value = slot(t).load(std::memory_order_relaxed);
+        return top_.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Approximate emptiness check (exact when called by a quiescent owner).
+     */
+    bool empty() const noexcept
+    {
+        return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+private:
+    std::atomic<T>& slot(std::int64_t index) noexcept
+    {
+        return buffer_[static_cast<std::size_t>(index) & (Capacity - 1)];
+    }
+
+    // top_ is written by thieves, bottom_ by the owner: keep them on separate lines.
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    alignas(64) std::array<std::atomic<T>, Capacity> buffer_{};
+};
+
+}  // namespace parallel
+}  // namespace detail
+}  // namespace quarisma
+
+#endif  // PARALLEL_WORK_STEALING_DEQUE_H
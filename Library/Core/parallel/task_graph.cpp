@@ -0,0 +1,252 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "parallel/task_graph.h"
+
+#include <algorithm>  // For std::max, std::min
+#include <thread>     // For std::this_thread::yield
+
+#include "parallel/std_thread/parallel_thread_pool.h"
+#include "util/exception.h"
+
+//------------------------------------------------------------------------------
+task_graph::task_graph() = default;
+
+//------------------------------------------------------------------------------
+task_graph::~task_graph() = default;
+
+//------------------------------------------------------------------------------
+task_graph::node_id task_graph::add_node(std::function<void()> task)
+{
+    QUARISMA_CHECK(tasks_.size() < not_ready, "task_graph is limited to ", not_ready, " nodes");
+    tasks_.emplace_back(std::move(task));
+    finalized_ = false;
+    return static_cast<node_id>(tasks_.size() - 1);
+}
+
+//------------------------------------------------------------------------------
+void task_graph::add_dependency(node_id before, node_id after)
+{
+    QUARISMA_CHECK(
+        before < tasks_.size() && after < tasks_.size(),
+        "Invalid task_graph dependency ",
+        before,
+        " -> ",
+        after);
+    QUARISMA_CHECK(before != after, "A task_graph node cannot depend on itself: ", before);
+    edges_.emplace_back(before, after);
+    finalized_ = false;
+}
+
+//------------------------------------------------------------------------------
+void task_graph::finalize()
+{
+    if (finalized_)
+    {
+        return;
+    }
+
+    const std::size_t n = tasks_.size();
+
+    // Successors in compressed sparse row form
+    successor_offsets_.assign(n + 1, 0);
+    in_degree_.assign(n, 0);
+    for (const auto& edge : edges_)
+    {
+        ++successor_offsets_[edge.first + 1];
+        ++in_degree_[edge.second];
+    }
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        successor_offsets_[i + 1] += successor_offsets_[i];
+    }
+    successors_.resize(edges_.size());
+    {
+        std::vector<std::size_t> cursor(successor_offsets_.begin(), successor_offsets_.end() - 1);
+        for (const auto& edge : edges_)
+        {
+            successors_[cursor[edge.first]++] = edge.second;
+        }
+    }
+
+    // Kahn's algorithm: levels and cycle detection
+    levels_.assign(n, 0);
+    roots_.clear();
+    std::vector<std::uint32_t> remaining(in_degree_);
+    std::vector<node_id>       order;
+    order.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (in_degree_[i] == 0)
+        {
+            roots_.push_back(static_cast<node_id>(i));
+            order.push_back(static_cast<node_id>(i));
+        }
+    }
+
+    number_of_levels_ = n == 0 ? 0 : 1;
+    for (std::size_t head = 0; head < order.size(); ++head)
+    {
+        const node_id node = order[head];
+        for (std::size_t e = successor_offsets_[node]; e < successor_offsets_[node + 1]; ++e)
+        {
+            const node_id next = successors_[e];
+            levels_[next]      = (std::max)(levels_[next], levels_[node] + 1);
+            if (--remaining[next] == 0)
+            {
+                order.push_back(next);
+                number_of_levels_ = (std::max)(number_of_levels_, std::size_t{levels_[next]} + 1);
+            }
+        }
+    }
+    QUARISMA_CHECK(order.size() == n, "task_graph contains a dependency cycle");
+
+    remaining_.reset(new std::atomic<std::uint32_t>[n]);
+    ready_.reset(new std::atomic<node_id>[n]);
+    finalized_ = true;
+}
+
+//------------------------------------------------------------------------------
+void task_graph::run(std::size_t thread_count)
+{
+    this->finalize();
+
+    const std::size_t n = tasks_.size();
+    if (n == 0)
+    {
+        return;
+    }
+
+    // Reset the per-run state; the roots are ready from the start
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        remaining_[i].store(in_degree_[i], std::memory_order_relaxed);
+        ready_[i].store(not_ready, std::memory_order_relaxed);
+    }
+    ready_count_.store(0, std::memory_order_relaxed);
+    next_slot_.store(0, std::memory_order_relaxed);
+    error_ = nullptr;
+    for (const node_id root : roots_)
+    {
+        this->make_ready(root);
+    }
+
+    // One job per worker; the proxy's mutexes publish the state reset above
+    auto& pool = quarisma::detail::parallel::parallel_thread_pool::instance();
+    if (thread_count == 0 || thread_count > pool.thread_count())
+    {
+        thread_count = pool.thread_count();
+    }
+    auto              proxy   = pool.allocate_threads(thread_count);
+    const std::size_t workers = (std::min)(thread_count, n);
+    for (std::size_t i = 0; i < workers; ++i)
+    {
+        proxy.do_job(&task_graph::work, this, i, i + 1);
+    }
+    proxy.join();
+
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t task_graph::size() const noexcept
+{
+    return tasks_.size();
+}
+
+//------------------------------------------------------------------------------
+std::size_t task_graph::number_of_levels() const noexcept
+{
+    return number_of_levels_;
+}
+
+//------------------------------------------------------------------------------
+std::size_t task_graph::level(node_id node) const
+{
+    QUARISMA_CHECK(finalized_, "task_graph::level() requires finalize()");
+    QUARISMA_CHECK(node < levels_.size(), "Invalid task_graph node ", node);
+    return levels_[node];
+}
+
+//------------------------------------------------------------------------------
+// Worker loop: claim ready slots in order until every node has been claimed.
+// A claimed slot may not be filled yet; it is guaranteed to be filled by a
+// running task because the graph is acyclic, so the worker waits for it.
+void task_graph::work(void* context, std::size_t, std::size_t)
+{
+    auto&             graph = *static_cast<task_graph*>(context);
+    const std::size_t n     = graph.tasks_.size();
+
+    while (true)
+    {
+        const std::size_t slot = graph.next_slot_.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= n)
+        {
+            return;
+        }
+
+        node_id node = graph.ready_[slot].load(std::memory_order_acquire);
+        while (node == not_ready)
+        {
+            std::this_thread::yield();
+            node = graph.ready_[slot].load(std::memory_order_acquire);
+        }
+
+        graph.execute(node);
+    }
+}
+
+//------------------------------------------------------------------------------
+void task_graph::execute(node_id node)
+{
+    try
+    {
+        if (tasks_[node])
+        {
+            tasks_[node]();
+        }
+    }
+    catch (...)
+    {
+        const std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_)
+        {
+            error_ = std::current_exception();
+        }
+    }
+
+    for (std::size_t e = successor_offsets_[node]; e < successor_offsets_[node + 1]; ++e)
+    {
+        const node_id next = successors_[e];
+        if (remaining_[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            this->make_ready(next);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void task_graph::make_ready(node_id node) noexcept
+{
+    const std::size_t slot = ready_count_.fetch_add(1, std::memory_order_relaxed);
+    ready_[slot].store(node, std::memory_order_release);
+}
@@ -0,0 +1,139 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @class task_graph
+ * @brief Reusable static DAG of tasks executed on the parallel_thread_pool
+ *
+ * Nodes and dependencies are declared once. finalize() checks that the graph
+ * is acyclic, stores the successors in a compact adjacency array and computes
+ * the topological level of every node. Each run() then executes the whole graph
+ * on the shared pool workers without locks or futures:
+ * - every node has an atomic count of unfinished predecessors, reset from the
+ *   in-degree at the start of each run;
+ * - a node whose count drops to zero is appended to a ready array of exactly
+ *   size() slots (each node becomes ready once per run), and workers claim the
+ *   slots in order with an atomic index.
+ *
+ * Compared to threaded_callback_queue::push_dependent(), nothing is allocated
+ * per run and no mutex is taken per node, which matters for large graphs
+ * executed many times.
+ *
+ * Building the graph is not thread safe; run() must not be called concurrently
+ * on the same instance. Exceptions thrown by tasks do not stop the run: the
+ * dependents still execute and the first exception is rethrown by run().
+ */
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <atomic>      // For std::atomic
+#include <cstddef>     // For std::size_t
+#include <cstdint>     // For std::uint32_t
+#include <exception>   // For std::exception_ptr
+#include <functional>  // For std::function
+#include <memory>      // For std::unique_ptr
+#include <mutex>       // For std::mutex
+#include <utility>     // For std::pair
+#include <vector>      // For std::vector
+
+#include "common/export.h"
+
+class QUARISMA_VISIBILITY task_graph
+{
+public:
+    using node_id = std::uint32_t;
+
+    QUARISMA_API task_graph();
+    QUARISMA_API ~task_graph();
+
+    task_graph(const task_graph&)            = delete;
+    task_graph& operator=(const task_graph&) = delete;
+
+    /**
+   * Add a task and return its identifier. Invalidates a previous finalize().
+   */
+    QUARISMA_API node_id add_node(std::function<void()> task);
+
+    /**
+   * Declare that `after` may only start once `before` has finished.
+   * Invalidates a previous finalize().
+   */
+    QUARISMA_API void add_dependency(node_id before, node_id after);
+
+    /**
+   * Validate the graph and build the execution data. Throws if the graph has a
+   * cycle. Called by run() when needed.
+   */
+    QUARISMA_API void finalize();
+
+    /**
+   * Execute every task once, honoring the dependencies.
+   *
+   * @param thread_count Maximum number of pool threads to use (0 = all)
+   */
+    QUARISMA_API void run(std::size_t thread_count = 0);
+
+    /**
+   * Number of nodes.
+   */
+    QUARISMA_API std::size_t size() const noexcept;
+
+    /**
+   * Number of topological levels (length of the longest dependency chain).
+   * Requires finalize().
+   */
+    QUARISMA_API std::size_t number_of_levels() const noexcept;
+
+    /**
+   * Topological level of `node`: 0 for nodes without predecessors, otherwise
+   * one more than the deepest predecessor. Requires finalize().
+   */
+    QUARISMA_API std::size_t level(node_id node) const;
+
+private:
+    static constexpr node_id not_ready = ~node_id{0};
+
+    static void work(void* context, std::size_t worker, std::size_t);
+
+    void execute(node_id node);
+    void make_ready(node_id node) noexcept;
+
+    std::vector<std::function<void()>>       tasks_;
+    std::vector<std::pair<node_id, node_id>> edges_;  ///< (before, after) as declared
+
+    // Execution data built by finalize()
+    bool                                          finalized_{false};
+    std::vector<std::size_t>                      successor_offsets_;  ///< CSR offsets
+    std::vector<node_id>                          successors_;         ///< CSR targets
+    std::vector<std::uint32_t>                    in_degree_;
+    std::vector<std::uint32_t>                    levels_;
+    std::vector<node_id>                          roots_;  ///< Nodes without predecessors
+    std::size_t                                   number_of_levels_{0};
+    std::unique_ptr<std::atomic<std::uint32_t>[]> remaining_;  ///< Unfinished predecessors
+    std::unique_ptr<std::atomic<node_id>[]>       ready_;      ///< Ready array, size() slots
+
+    // Per-run state
+    std::atomic<std::size_t> ready_count_{0};  ///< Slots filled
+    std::atomic<std::size_t> next_slot_{0};    ///< Slots claimed by workers
+    std::exception_ptr       error_;
+    std::mutex               error_mutex_;
+};
+
+#endif  // TASK_GRAPH_H
@@ -25,6 +25,7 @@
 
 #include <charconv>
 #include <cstdlib>  // For std::getenv()
+#include <map>      // For std::map
 #include <memory>   // For std::unique_ptr
 #include <mutex>    // For std::mutex
 #include <stack>    // For std::stack
@@ -176,7 +177,21 @@ void parallel_tools_impl_for_tbb(
     thread_id_stack->emplace(tbb::this_task_arena::current_thread_index());
     thread_id_stack_lock->unlock();
 
-    if (task_arena->is_active())
+    const int scoped_threads = current_local_scope().max_number_of_threads_;
+    if (scoped_threads > 0)
+    {
+        // local_scope() budget: run in a per-thread arena of that concurrency and
+        // leave the global arena untouched. Arenas are kept per budget, so a nested
+        // scope with another budget never destroys the arena its caller runs in.
+        thread_local std::map<int, std::unique_ptr<tbb::task_arena>> scoped_arenas;
+        auto& scoped_arena = scoped_arenas[scoped_threads];
+        if (!scoped_arena)
+        {
+            scoped_arena = std::make_unique<tbb::task_arena>(scoped_threads);
+        }
+        scoped_arena->execute([&] { functor_executer(functor, first, last, grain); });
+    }
+    else if (task_arena->is_active())
     {
         task_arena->execute([&] { functor_executer(functor, first, last, grain); });
     }
@@ -135,7 +135,7 @@ template <typename FunctorInternal>
 void parallel_tools_impl<backend_type::TBB>::parallel_for(
     size_t first, size_t last, size_t grain, FunctorInternal& fi)
 {
-    if (!nested_activated_ && is_parallel_)
+    if (!scoped_nested_parallelism(nested_activated_) && is_parallel_)
     {
         fi.Execute(first, last);
     }
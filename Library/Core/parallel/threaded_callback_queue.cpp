@@ -26,6 +26,14 @@
 #include <algorithm>
 #include <iterator>
 
+namespace
+{
+/**
+ * Queue name reported to pool_instrumentation.
+ */
+constexpr const char* instrumentation_name = "threaded_callback_queue";
+}  // namespace
+
 //=============================================================================
 class threaded_callback_queue::thread_worker
 {
@@ -65,16 +73,23 @@ private:
             return false;
         }
 
-        auto& invoker_queue = queue_->invoker_queue_;
+        auto& invoker_queue = queue_->next_invoker_queue();
 
         const shared_future_base_pointer invoker = std::move(invoker_queue.front());
         invoker_queue.pop_front();
+        queue_->pop_front_nullptr(invoker_queue);
 
-        invoker->status_.store(RUNNING, std::memory_order_release);
+        // try_invoke() runs enqueued invokers in place without removing them from the queue
+        if (invoker->status_.load(std::memory_order_acquire) != ENQUEUED)
+        {
+            return true;
+        }
 
-        queue_->pop_front_nullptr();
+        invoker->status_.store(RUNNING, std::memory_order_release);
         lock.unlock();
 
+        const quarisma::pool_instrumentation::job_scope measure{
+            instrumentation_name, static_cast<std::size_t>(thread_index_->load()), invoker->stamp_};
         queue_->invoke(invoker.get());
 
         return true;
@@ -87,7 +102,7 @@ private:
     {
         return *thread_index_ < queue_->number_of_threads_ &&
                !queue_->destroying_.load(std::memory_order_acquire) &&
-               queue_->invoker_queue_.empty();
+               !queue_->has_enqueued_invokers();
     }
 
     /**
@@ -95,7 +110,7 @@ private:
    */
     [[nodiscard]] bool can_continue() const
     {
-        return *thread_index_ < queue_->number_of_threads_ && !queue_->invoker_queue_.empty();
+        return *thread_index_ < queue_->number_of_threads_ && queue_->has_enqueued_invokers();
     }
 
     threaded_callback_queue*         queue_;
@@ -191,6 +206,12 @@ void threaded_callback_queue::set_number_of_threads(int number_of_threads)
         });
 }
 
+//-----------------------------------------------------------------------------
+void threaded_callback_queue::set_starvation_limit(int limit)
+{
+    starvation_limit_.store((std::max)(limit, 1), std::memory_order_relaxed);
+}
+
 //-----------------------------------------------------------------------------
 void threaded_callback_queue::sync(int start_id)
 {
@@ -199,17 +220,171 @@ void threaded_callback_queue::sync(int start_id)
 }
 
 //-----------------------------------------------------------------------------
-void threaded_callback_queue::pop_front_nullptr()
+void threaded_callback_queue::pop_front_nullptr(invoker_queue& queue)
 {
-    while (!invoker_queue_.empty() && !invoker_queue_.front())
+    while (!queue.empty() && !queue.front())
     {
-        invoker_queue_.pop_front();
+        queue.pop_front();
     }
 }
 
+//-----------------------------------------------------------------------------
+bool threaded_callback_queue::has_enqueued_invokers() const
+{
+    return std::any_of(
+        invoker_queues_.begin(),
+        invoker_queues_.end(),
+        [](const invoker_queue& queue) { return !queue.empty(); });
+}
+
+//-----------------------------------------------------------------------------
+threaded_callback_queue::invoker_queue& threaded_callback_queue::next_invoker_queue()
+{
+    // The most urgent non-empty queue wins, unless a less urgent one has been passed over
+    // starvation_limit_ times in a row.
+    const int   limit    = starvation_limit_.load(std::memory_order_relaxed);
+    std::size_t selected = number_of_priorities;
+    for (std::size_t level = 0; level < number_of_priorities; ++level)
+    {
+        if (invoker_queues_[level].empty())
+        {
+            continue;
+        }
+        if (selected == number_of_priorities)
+        {
+            selected = level;
+        }
+        else if (skipped_count_[level] >= limit)
+        {
+            selected = level;
+            break;
+        }
+    }
+    assert(selected != number_of_priorities && "At least one queue should be non-empty");
+
+    for (std::size_t level = 0; level < number_of_priorities; ++level)
+    {
+        if (level == selected || invoker_queues_[level].empty())
+        {
+            skipped_count_[level] = 0;
+        }
+        else
+        {
+            ++skipped_count_[level];
+        }
+    }
+    return invoker_queues_[selected];
+}
+
+//-----------------------------------------------------------------------------
+void threaded_callback_queue::enqueue_front(shared_future_base_pointer invoker)
+{
+    auto& queue = invoker_queues_[static_cast<std::size_t>(invoker->priority_)];
+    invoker->invoker_index_ = queue.empty() ? 0 : queue.front()->invoker_index_ - 1;
+    queue.emplace_front(std::move(invoker));
+}
+
+//-----------------------------------------------------------------------------
+void threaded_callback_queue::enqueue_back(shared_future_base_pointer invoker)
+{
+    invoker->stamp_ = quarisma::pool_instrumentation::on_enqueue();
+    invoker->status_.store(ENQUEUED, std::memory_order_release);
+
+    {
+        const std::scoped_lock lock(mutex_);
+        auto& queue = invoker_queues_[static_cast<std::size_t>(invoker->priority_)];
+        invoker->invoker_index_ = queue.empty() ? 0 : queue.back()->invoker_index_ + 1;
+        queue.emplace_back(std::move(invoker));
+    }
+
+    condition_variable_.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+void threaded_callback_queue::apply_options(
+    shared_future_base* invoker, const task_options& options)
+{
+    invoker->priority_ = options.level;
+    invoker->deadline_ = options.deadline;
+    if (options.token)
+    {
+        invoker->tokens_.push_back(*options.token);
+    }
+    if (!options.tag.empty())
+    {
+        const std::scoped_lock lock(tag_mutex_);
+        invoker->tokens_.push_back(tag_tokens_[options.tag]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void threaded_callback_queue::cancel_all_matching(const std::string& tag)
+{
+    {
+        const std::scoped_lock lock(tag_mutex_);
+        const auto             it = tag_tokens_.find(tag);
+        if (it == tag_tokens_.end())
+        {
+            return;
+        }
+        it->second.cancel();
+        // Later tasks with this tag get a fresh token
+        tag_tokens_.erase(it);
+    }
+
+    // Complete the cancelled tasks waiting in the queues now rather than when a worker reaches
+    // them, so that their waiters and dependents are released. Their slots are left null, which
+    // keeps the indices used by try_invoke valid.
+    std::vector<shared_future_base_pointer> cancelled;
+    {
+        const std::scoped_lock lock(mutex_);
+        for (auto& queue : invoker_queues_)
+        {
+            for (auto& invoker : queue)
+            {
+                if (!invoker || !invoker->must_cancel())
+                {
+                    continue;
+                }
+                const std::scoped_lock inv_lock(invoker->mutex_);
+                if (invoker->status_.load(std::memory_order_acquire) != ENQUEUED)
+                {
+                    continue;
+                }
+                invoker->status_.store(RUNNING, std::memory_order_release);
+                cancelled.emplace_back(std::move(invoker));
+            }
+            this->pop_front_nullptr(queue);
+        }
+    }
+
+    for (const auto& invoker : cancelled)
+    {
+        this->finish_cancelled(invoker.get());
+    }
+}
+
+//-----------------------------------------------------------------------------
+void threaded_callback_queue::finish_cancelled(shared_future_base* invoker)
+{
+    {
+        const std::scoped_lock lock(invoker->mutex_);
+        invoker->cancelled_.store(true, std::memory_order_release);
+        invoker->status_.store(READY, std::memory_order_release);
+    }
+    invoker->condition_variable_.notify_all();
+    this->signal_dependent_shared_futures(invoker);
+}
+
 //-----------------------------------------------------------------------------
 void threaded_callback_queue::invoke(shared_future_base* invoker)
 {
+    // Cancellation and deadlines are checked once the task is dequeued, right before it runs
+    if (invoker->must_cancel())
+    {
+        this->finish_cancelled(invoker);
+        return;
+    }
     (*invoker)();
     this->signal_dependent_shared_futures(invoker);
 }
@@ -218,12 +393,19 @@ void threaded_callback_queue::invoke(shared_future_base* invoker)
 void threaded_callback_queue::signal_dependent_shared_futures(shared_future_base* invoker)
 {
     std::vector<shared_future_base_pointer> invokers_to_launch;
+    std::vector<std::function<void()>>      continuations;
     {
         const std::scoped_lock lock(invoker->mutex_);
+        continuations.swap(invoker->continuations_);
+        const bool cancelled = invoker->cancelled_.load(std::memory_order_acquire);
 
         for (auto& dependent : invoker->dependents_)
         {
             std::unique_lock<std::mutex> dependent_lock(dependent->mutex_);
+            if (cancelled)
+            {
+                dependent->cancelled_.store(true, std::memory_order_release);
+            }
             --dependent->number_of_prior_shared_futures_remaining_;
             if (dependent->status_.load(std::memory_order_acquire) == ON_HOLD &&
                 (dependent->number_of_prior_shared_futures_remaining_ == 0))
@@ -246,18 +428,16 @@ void threaded_callback_queue::signal_dependent_shared_futures(shared_future_base
     if (!invokers_to_launch.empty())
     {
         const std::scoped_lock lock(mutex_);
-        size_t index = invoker_queue_.empty() ? static_cast<size_t>(invokers_to_launch.size())
-                                              : invoker_queue_.front()->invoker_index_;
         for (shared_future_base_pointer& inv : invokers_to_launch)
         {
             assert(
                 inv->status_.load(std::memory_order_acquire) == ON_HOLD &&
                 "Status should be ON_HOLD");
-            inv->invoker_index_ = --index;
 
             const std::scoped_lock state_lock(inv->mutex_);
+            inv->stamp_ = quarisma::pool_instrumentation::on_enqueue();
             inv->status_.store(ENQUEUED, std::memory_order_release);
-            invoker_queue_.emplace_front(std::move(inv));
+            this->enqueue_front(std::move(inv));
         }
     }
 
@@ -265,6 +445,11 @@ void threaded_callback_queue::signal_dependent_shared_futures(shared_future_base
     {
         condition_variable_.notify_one();
     }
+
+    for (auto& continuation : continuations)
+    {
+        continuation();
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -279,7 +464,8 @@ bool threaded_callback_queue::try_invoke(shared_future_base* invoker)
 
             const std::scoped_lock lock(mutex_);
 
-            if (invoker_queue_.empty())
+            auto& invoker_queue = invoker_queues_[static_cast<std::size_t>(invoker->priority_)];
+            if (invoker_queue.empty())
             {
                 return false;
             }
@@ -291,9 +477,13 @@ bool threaded_callback_queue::try_invoke(shared_future_base* invoker)
                 return false;
             }
 
-            const size_t index = invoker->invoker_index_ - invoker_queue_.front()->invoker_index_;
+            const size_t index = invoker->invoker_index_ - invoker_queue.front()->invoker_index_;
+            if (index >= invoker_queue.size())
+            {
+                return false;
+            }
 
-            const shared_future_base_pointer& result = invoker_queue_[index];
+            const shared_future_base_pointer& result = invoker_queue[index];
 
             if (result.get() != invoker)
             {
@@ -302,8 +492,8 @@ bool threaded_callback_queue::try_invoke(shared_future_base* invoker)
 
             if (index == 0)
             {
-                invoker_queue_.pop_front();
-                this->pop_front_nullptr();
+                invoker_queue.pop_front();
+                this->pop_front_nullptr(invoker_queue);
             }
             invoker->status_.store(RUNNING, std::memory_order_release);
             return true;
@@ -312,6 +502,9 @@ bool threaded_callback_queue::try_invoke(shared_future_base* invoker)
         return false;
     }
 
+    // Run in place by a waiting thread rather than by a worker
+    const quarisma::pool_instrumentation::job_scope measure{
+        instrumentation_name, quarisma::pool_instrumentation::external_worker, invoker->stamp_};
     this->invoke(invoker);
     return true;
 }
@@ -35,6 +35,18 @@
  * returned value when the task is finished, and provides functionalities to synchronize the main
  * thread with the status of its associated task.
  *
+ * Tasks can be pushed with a `priority`. Each priority level has its own internal queue and
+ * idle threads always pick from the most urgent non-empty queue, so latency sensitive work does
+ * not wait behind a backlog of batch tasks. A starvation guard bounds how long a non-empty queue
+ * can be passed over: once it has been skipped `get_starvation_limit()` times in a row, its front
+ * task runs next. `push` and `push_dependent` use `priority::normal`.
+ *
+ * Tasks pushed with `task_options` can be cancelled before they start: through a
+ * `cancellation_token`, a deadline, or a tag passed to `cancel_all_matching`. Cancelled tasks are
+ * dropped when they are dequeued, without running: their future becomes ready with
+ * `is_cancelled()` set, and so do the futures of the tasks depending on them. A dependent also
+ * inherits the tokens of its prior futures, so cancelling a request drops its whole task graph.
+ *
  * All public methods of this class are thread safe.
  */
 
@@ -45,11 +57,15 @@
 #include <array>               // For array
 #include <atomic>              // For atomic_bool
 #include <cassert>             // For assert
+#include <chrono>              // For steady_clock
 #include <condition_variable>  // For condition variable
+#include <cstddef>             // For size_t
 #include <deque>               // For deque
 #include <functional>          // For greater
 #include <memory>              // For unique_ptr, shared_ptr
 #include <mutex>               // For mutex
+#include <optional>            // For optional
+#include <string>              // For string
 #include <thread>              // For thread
 #include <tuple>               // For tuple
 #include <type_traits>         // For type_traits
@@ -59,6 +75,7 @@
 #include <vector>              // For vector
 
 #include "common/export.h"
+#include "parallel/pool_instrumentation.h"
 
 class QUARISMA_VISIBILITY threaded_callback_queue
 {
@@ -102,6 +119,68 @@ public:
 
     QUARISMA_API threaded_callback_queue();
 
+    /**
+   * Priority levels of pushed tasks, from the most to the least urgent.
+   */
+    enum class priority
+    {
+        high,
+        normal,
+        low
+    };
+
+    static constexpr std::size_t number_of_priorities = 3;
+
+    using clock = std::chrono::steady_clock;
+
+    /**
+   * Shared flag cancelling the tasks it is attached to. Copies share the flag.
+   */
+    class QUARISMA_VISIBILITY cancellation_token
+    {
+    public:
+        cancellation_token() : cancelled_(std::make_shared<std::atomic_bool>(false)) {}
+
+        /**
+     * Cancels the tasks attached to this token that have not started yet.
+     */
+        void cancel() const noexcept { cancelled_->store(true, std::memory_order_release); }
+
+        bool is_cancelled() const noexcept { return cancelled_->load(std::memory_order_acquire); }
+
+        friend bool operator==(const cancellation_token& lhs, const cancellation_token& rhs)
+        {
+            return lhs.cancelled_ == rhs.cancelled_;
+        }
+
+    private:
+        std::shared_ptr<std::atomic_bool> cancelled_;
+    };
+
+    /**
+   * Options of `push_with_options` and `push_dependent_with_options`.
+   */
+    struct task_options
+    {
+        priority level = priority::normal;
+
+        /**
+     * The task is dropped if this token is cancelled before it starts.
+     */
+        std::optional<cancellation_token> token;
+
+        /**
+     * The task is dropped if it is dequeued after this time point.
+     */
+        clock::time_point deadline = clock::time_point::max();
+
+        /**
+     * The task is dropped if `cancel_all_matching(tag)` is called before it starts. Empty for
+     * none.
+     */
+        std::string tag;
+    };
+
   /**
    * `shared_future_base` is the base block to store, run, get the returned value of the tasks that
    * are pushed in the queue.
@@ -129,6 +208,33 @@ public:
             condition_variable_.wait(lock, [this] { return status_ == READY; });
         }
 
+        /**
+     * Returns true if the task associated with this future has terminated.
+     */
+        bool is_ready() const noexcept { return status_.load(std::memory_order_acquire) == READY; }
+
+        /**
+     * Registers `callback` to be run, on the thread that finishes the task, once the task
+     * associated with this future has terminated. This lets a waiter be resumed instead of
+     * blocking in `wait()`. Returns false, without calling `callback`, if the task is already done.
+     */
+        QUARISMA_API bool on_ready(std::function<void()> callback)
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            if (status_.load(std::memory_order_acquire) == READY)
+            {
+                return false;
+            }
+            continuations_.emplace_back(std::move(callback));
+            return true;
+        }
+
+        /**
+     * Returns true if the task was dropped instead of run, see `task_options`. Only meaningful
+     * once the future is ready; `get()` then returns a value initialized value.
+     */
+        bool is_cancelled() const noexcept { return cancelled_.load(std::memory_order_acquire); }
+
         friend class threaded_callback_queue;
 
     protected:
@@ -142,6 +248,11 @@ public:
      */
         std::vector<std::shared_ptr<shared_future_base>> dependents_;
 
+        /**
+     * Callbacks registered with `on_ready`.
+     */
+        std::vector<std::function<void()>> continuations_;
+
         mutable std::mutex              mutex_;
         mutable std::condition_variable condition_variable_;
 
@@ -167,6 +278,44 @@ public:
      */
         bool is_high_priority_ = false;
 
+        /**
+     * Internal queue this invoker is enqueued in.
+     */
+        priority priority_ = priority::normal;
+
+        /**
+     * Time this invoker was enqueued, when the queue is instrumented.
+     */
+        quarisma::pool_instrumentation::stamp stamp_;
+
+        /**
+     * Tokens of the task, of its tag and of the tasks it depends on. Set before it is pushed.
+     */
+        std::vector<cancellation_token> tokens_;
+
+        /**
+     * Time after which the task is dropped instead of run.
+     */
+        clock::time_point deadline_ = clock::time_point::max();
+
+        /**
+     * Set when the task is dropped, or when a task it depends on was.
+     */
+        std::atomic_bool cancelled_{false};
+
+        /**
+     * Returns true if the task must be dropped instead of run.
+     */
+        bool must_cancel() const
+        {
+            return cancelled_.load(std::memory_order_acquire) ||
+                   std::any_of(
+                       tokens_.begin(),
+                       tokens_.end(),
+                       [](const cancellation_token& token) { return token.is_cancelled(); }) ||
+                   (deadline_ != clock::time_point::max() && clock::now() > deadline_);
+        }
+
         shared_future_base(const shared_future_base& other) = delete;
         void operator=(const shared_future_base& other)     = delete;
     };
@@ -220,6 +369,49 @@ public:
     shared_future_pointer<invoke_result<FT>> push_dependent(
         SharedFutureContainerT&& prior_shared_futures, FT&& f, ArgsT&&... args);
 
+    /**
+   * Same as `push`, with the task enqueued at the given priority level.
+   */
+    template <class FT, class... ArgsT>
+    shared_future_pointer<invoke_result<FT>> push_with_priority(
+        priority level, FT&& f, ArgsT&&... args);
+
+    /**
+   * Same as `push_dependent`, with the task enqueued at the given priority level once its
+   * prior futures are ready.
+   */
+    template <class SharedFutureContainerT, class FT, class... ArgsT>
+    shared_future_pointer<invoke_result<FT>> push_dependent_with_priority(
+        priority                 level,
+        SharedFutureContainerT&& prior_shared_futures,
+        FT&&                     f,
+        ArgsT&&... args);
+
+    /**
+   * Same as `push`, with the priority, cancellation token, deadline and tag of `options`.
+   */
+    template <class FT, class... ArgsT>
+    shared_future_pointer<invoke_result<FT>> push_with_options(
+        const task_options& options, FT&& f, ArgsT&&... args);
+
+    /**
+   * Same as `push_dependent`, with the priority, cancellation token, deadline and tag of
+   * `options`. The task also inherits the tokens of `prior_shared_futures`.
+   */
+    template <class SharedFutureContainerT, class FT, class... ArgsT>
+    shared_future_pointer<invoke_result<FT>> push_dependent_with_options(
+        const task_options&      options,
+        SharedFutureContainerT&& prior_shared_futures,
+        FT&&                     f,
+        ArgsT&&... args);
+
+    /**
+   * Cancels the tasks pushed with `tag` that have not started, and the tasks depending on them.
+   * Those waiting in the queue are completed as cancelled right away. Tasks pushed with `tag`
+   * afterwards are not affected.
+   */
+    QUARISMA_API void cancel_all_matching(const std::string& tag);
+
     /**
    * This method blocks the current thread until all the tasks associated with each shared future
    * inside `prior_shared_future` has terminated.
@@ -238,6 +430,21 @@ public:
         const shared_future_pointer<ReturnT>& future);
     ///@}
 
+    /**
+   * Returns a future that no pushed task completes: it becomes ready when `set_value` is called.
+   * Work done outside the queue, such as I/O, can then be waited on and depended upon like a
+   * pushed task.
+   */
+    template <class ReturnT>
+    shared_future_pointer<ReturnT> make_pending();
+
+    /**
+   * Makes a future returned by `make_pending` ready with `value` (none for `void`), and runs or
+   * enqueues in this queue the tasks that depend on it. Call it once per future, from any thread.
+   */
+    template <class ReturnT, class... ValueT>
+    void set_value(const shared_future_pointer<ReturnT>& future, ValueT&&... value);
+
     /**
    * Sets the number of threads.
    */
@@ -248,6 +455,17 @@ public:
    */
     QUARISMA_API int get_number_of_threads() const { return number_of_threads_; }
 
+    /**
+   * Sets how many times in a row a non-empty queue can be passed over in favor of a more urgent
+   * one before its front task is run. Values below 1 are clamped to 1. Default is 16.
+   */
+    QUARISMA_API void set_starvation_limit(int limit);
+
+    /**
+   * Returns the starvation limit.
+   */
+    QUARISMA_API int get_starvation_limit() const { return starvation_limit_; }
+
 private:
     ///@{
     /**
@@ -260,6 +478,12 @@ private:
 
     struct invoker_impl;
 
+    /**
+   * Future returned by `make_pending`, which is never enqueued.
+   */
+    template <class ReturnT>
+    class pending;
+
     template <class FT, class... ArgsT>
     using invoker_pointer = std::shared_ptr<invoker<FT, ArgsT...>>;
 
@@ -267,6 +491,8 @@ private:
 
     friend class thread_worker;
 
+    using invoker_queue = std::deque<shared_future_base_pointer>;
+
     /**
    * Status that an invoker can be in.
    */
@@ -280,7 +506,10 @@ private:
     };
 
     QUARISMA_API void sync(int start_id = 0);
-    QUARISMA_API void pop_front_nullptr();
+    QUARISMA_API void pop_front_nullptr(invoker_queue& queue);
+    QUARISMA_API bool has_enqueued_invokers() const;
+    QUARISMA_API invoker_queue& next_invoker_queue();
+    QUARISMA_API void enqueue_front(shared_future_base_pointer invoker);
     QUARISMA_API void signal_dependent_shared_futures(shared_future_base* invoker);
 
     template <class SharedFutureContainerT, class InvokerT>
@@ -289,6 +518,13 @@ private:
 
     QUARISMA_API void invoke(shared_future_base* invoker);
     QUARISMA_API bool try_invoke(shared_future_base* invoker);
+    QUARISMA_API void finish_cancelled(shared_future_base* invoker);
+    QUARISMA_API void apply_options(shared_future_base* invoker, const task_options& options);
+    QUARISMA_API void enqueue_back(shared_future_base_pointer invoker);
+
+    template <class SharedFutureContainerT>
+    static void inherit_cancellation(
+        shared_future_base* invoker, SharedFutureContainerT&& prior_shared_futures);
 
     template <class FT, class... ArgsT>
     void push_control(FT&& f, ArgsT&&... args);
@@ -296,7 +532,9 @@ private:
     template <class SharedFutureContainerT>
     static bool must_wait(SharedFutureContainerT&& prior_shared_futures);
 
-    std::deque<shared_future_base_pointer>                                invoker_queue_;
+    std::array<invoker_queue, number_of_priorities>                       invoker_queues_;
+    std::array<int, number_of_priorities>                                 skipped_count_{};
+    std::atomic_int                                                       starvation_limit_{16};
     std::mutex                                                            mutex_;
     std::mutex                                                            control_mutex_;
     std::mutex                                                            destroy_mutex_;
@@ -307,6 +545,8 @@ private:
     std::vector<std::thread>                                              threads_;
     std::unordered_map<std::thread::id, std::shared_ptr<std::atomic_int>> thread_id_to_index_;
     std::unordered_set<shared_future_base_pointer>                        control_futures_;
+    std::mutex                                                            tag_mutex_;
+    std::unordered_map<std::string, cancellation_token>                   tag_tokens_;
 
     threaded_callback_queue(const threaded_callback_queue&) = delete;
     void operator=(const threaded_callback_queue&)          = delete;
@@ -360,7 +600,7 @@ struct threaded_callback_queue::return_value_wrapper<ReturnT, false /* IsLValueR
     ReturnT&       get() { return value_; }
     const ReturnT& get() const { return value_; }
 
-    ReturnT value_;
+    ReturnT value_{};
 };
 
 //-----------------------------------------------------------------------------
@@ -641,6 +881,14 @@ private:
     void operator=(const invoker<FT, ArgsT...>& other) = delete;
 };
 
+//=============================================================================
+template <class ReturnT>
+class threaded_callback_queue::pending : public threaded_callback_queue::shared_future<ReturnT>
+{
+private:
+    void operator()() override {}
+};
+
 //-----------------------------------------------------------------------------
 // Helper functions to extract raw pointer from either raw pointer or shared_ptr
 namespace detail
@@ -765,23 +1013,118 @@ threaded_callback_queue::get(const shared_future_pointer<ReturnT>& future)
     return future->get();
 }
 
+//-----------------------------------------------------------------------------
+template <class ReturnT>
+threaded_callback_queue::shared_future_pointer<ReturnT> threaded_callback_queue::make_pending()
+{
+    shared_future_pointer<ReturnT> future = std::make_shared<pending<ReturnT>>();
+    // Running outside of the queue: wait() blocks on it instead of trying to run it
+    future->status_.store(RUNNING, std::memory_order_release);
+    return future;
+}
+
+//-----------------------------------------------------------------------------
+template <class ReturnT, class... ValueT>
+void threaded_callback_queue::set_value(
+    const shared_future_pointer<ReturnT>& future, ValueT&&... value)
+{
+    static_assert(
+        sizeof...(ValueT) == (std::is_void<ReturnT>::value ? 0 : 1),
+        "set_value takes one value, or none for a void future");
+    assert(dynamic_cast<pending<ReturnT>*>(future.get()) != nullptr && "Not a pending future");
+    {
+        const std::lock_guard<std::mutex> lock(future->mutex_);
+        assert(
+            future->status_.load(std::memory_order_acquire) == RUNNING &&
+            "set_value called twice");
+        future->return_value_ = return_value_wrapper<ReturnT>(std::forward<ValueT>(value)...);
+        future->status_.store(READY, std::memory_order_release);
+    }
+    future->condition_variable_.notify_all();
+    this->signal_dependent_shared_futures(future.get());
+}
+
+//-----------------------------------------------------------------------------
+template <class SharedFutureContainerT>
+void threaded_callback_queue::inherit_cancellation(
+    shared_future_base* invoker, SharedFutureContainerT&& prior_shared_futures)
+{
+    for (const auto& future_item : prior_shared_futures)
+    {
+        const shared_future_base* prior = detail::get_raw_ptr(future_item);
+        for (const cancellation_token& token : prior->tokens_)
+        {
+            // Chains of dependents share their tokens: keep one copy of each
+            if (std::find(invoker->tokens_.begin(), invoker->tokens_.end(), token) ==
+                invoker->tokens_.end())
+            {
+                invoker->tokens_.push_back(token);
+            }
+        }
+        // Priors cancelled later propagate through signal_dependent_shared_futures
+        if (prior->status_.load(std::memory_order_acquire) == READY && prior->is_cancelled())
+        {
+            invoker->cancelled_.store(true, std::memory_order_release);
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 template <class SharedFutureContainerT, class FT, class... ArgsT>
 threaded_callback_queue::shared_future_pointer<threaded_callback_queue::invoke_result<FT>>
 threaded_callback_queue::push_dependent(
     SharedFutureContainerT&& prior_shared_futures, FT&& f, ArgsT&&... args)
+{
+    return this->push_dependent_with_priority(
+        priority::normal,
+        std::forward<SharedFutureContainerT>(prior_shared_futures),
+        std::forward<FT>(f),
+        std::forward<ArgsT>(args)...);
+}
+
+//-----------------------------------------------------------------------------
+template <class SharedFutureContainerT, class FT, class... ArgsT>
+threaded_callback_queue::shared_future_pointer<threaded_callback_queue::invoke_result<FT>>
+threaded_callback_queue::push_dependent_with_priority(
+    priority                 level,
+    SharedFutureContainerT&& prior_shared_futures,
+    FT&&                     f,
+    ArgsT&&... args)
+{
+    task_options options;
+    options.level = level;
+    return this->push_dependent_with_options(
+        options,
+        std::forward<SharedFutureContainerT>(prior_shared_futures),
+        std::forward<FT>(f),
+        std::forward<ArgsT>(args)...);
+}
+
+//-----------------------------------------------------------------------------
+template <class SharedFutureContainerT, class FT, class... ArgsT>
+threaded_callback_queue::shared_future_pointer<threaded_callback_queue::invoke_result<FT>>
+threaded_callback_queue::push_dependent_with_options(
+    const task_options&      options,
+    SharedFutureContainerT&& prior_shared_futures,
+    FT&&                     f,
+    ArgsT&&... args)
 {
     SharedFutureContainerT& prior_shared_futures_r = prior_shared_futures;
-    if (!this->must_wait(prior_shared_futures_r))
-    {
-        return this->push(std::forward<FT>(f), std::forward<ArgsT>(args)...);
-    }
 
     using invoker_pointer_type = invoker_pointer<FT, ArgsT...>;
     auto invoker_ptr           = invoker_pointer_type(
         invoker<FT, ArgsT...>::create(std::forward<FT>(f), std::forward<ArgsT>(args)...));
+    this->apply_options(invoker_ptr.get(), options);
+    threaded_callback_queue::inherit_cancellation(invoker_ptr.get(), prior_shared_futures_r);
 
-    this->push(
+    if (!this->must_wait(prior_shared_futures_r))
+    {
+        this->enqueue_back(invoker_ptr);
+        return invoker_ptr;
+    }
+
+    this->push_with_priority(
+        options.level,
         &threaded_callback_queue::
             handle_dependent_invoker<SharedFutureContainerT, invoker_pointer_type>,
         this,
@@ -835,10 +1178,10 @@ void threaded_callback_queue::push_control(FT&& f, ArgsT&&... args)
             std::lock_guard<std::mutex> invoker_lock(invoker_ptr->mutex_);
             invoker_ptr->status_.store(ENQUEUED, std::memory_order_release);
 
+            invoker_ptr->priority_ = priority::high;
+
             std::lock_guard<std::mutex> lock(mutex_);
-            invoker_ptr->invoker_index_ =
-                invoker_queue_.empty() ? 0 : invoker_queue_.front()->invoker_index_ - 1;
-            invoker_queue_.emplace_front(invoker_ptr);
+            this->enqueue_front(invoker_ptr);
         }
         condition_variable_.notify_one();
         return;
@@ -852,19 +1195,32 @@ void threaded_callback_queue::push_control(FT&& f, ArgsT&&... args)
 template <class FT, class... ArgsT>
 threaded_callback_queue::shared_future_pointer<threaded_callback_queue::invoke_result<FT>>
 threaded_callback_queue::push(FT&& f, ArgsT&&... args)
+{
+    return this->push_with_priority(
+        priority::normal, std::forward<FT>(f), std::forward<ArgsT>(args)...);
+}
+
+//-----------------------------------------------------------------------------
+template <class FT, class... ArgsT>
+threaded_callback_queue::shared_future_pointer<threaded_callback_queue::invoke_result<FT>>
+threaded_callback_queue::push_with_priority(priority level, FT&& f, ArgsT&&... args)
 {
     auto invoker_ptr = invoker_pointer<FT, ArgsT...>(
         invoker<FT, ArgsT...>::create(std::forward<FT>(f), std::forward<ArgsT>(args)...));
-    invoker_ptr->status_.store(ENQUEUED, std::memory_order_release);
-
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        invoker_ptr->invoker_index_ =
-            invoker_queue_.empty() ? 0 : invoker_queue_.back()->invoker_index_ + 1;
-        invoker_queue_.emplace_back(invoker_ptr);
-    }
+    invoker_ptr->priority_ = level;
+    this->enqueue_back(invoker_ptr);
+    return invoker_ptr;
+}
 
-    condition_variable_.notify_one();
+//-----------------------------------------------------------------------------
+template <class FT, class... ArgsT>
+threaded_callback_queue::shared_future_pointer<threaded_callback_queue::invoke_result<FT>>
+threaded_callback_queue::push_with_options(const task_options& options, FT&& f, ArgsT&&... args)
+{
+    auto invoker_ptr = invoker_pointer<FT, ArgsT...>(
+        invoker<FT, ArgsT...>::create(std::forward<FT>(f), std::forward<ArgsT>(args)...));
+    this->apply_options(invoker_ptr.get(), options);
+    this->enqueue_back(invoker_ptr);
     return invoker_ptr;
 }
 
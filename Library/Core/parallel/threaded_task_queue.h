@@ -53,23 +53,41 @@
  * from the queue. Note, this does not impact tasks that may already be in
  * progress. Also, if `strict_ordering` is true, this is ignored; the
  * buffer_size will be set to unlimited.
+ *
+ * `ring_capacity` selects how pending tasks are stored. By default (0) they go
+ * through a mutex-protected queue. A positive value stores them in a bounded
+ * lock-free ring buffer (`mpmc_ring_buffer`) of that many slots rounded up to a
+ * power of two: pushing and picking up tasks is then lock free, and workers
+ * only touch the mutex to block when the ring is empty. When the ring is full,
+ * `push` waits for a free slot, or drops the oldest pending task if a
+ * `buffer_size` is in effect.
+ *
+ * `push_batch` enqueues many argument tuples at once with a single round of
+ * notifications, and `pop_batch` retrieves all the results available at once.
  */
 
 #ifndef THREADED_TASK_QUEUE_H
 #define THREADED_TASK_QUEUE_H
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 #include "common/export.h"
 #include "multi_threader.h"
+#include "util/mpmc_ring_buffer.h"
 
 // Undefine min/max macros from Windows headers if they were defined
 #ifdef min
@@ -96,11 +114,14 @@ template <typename R, typename... Args>
 class QUARISMA_VISIBILITY threaded_task_queue
 {
 public:
+    using argument_tuple = std::tuple<typename std::decay<Args>::type...>;
+
     threaded_task_queue(
         std::function<R(Args...)> worker,
         bool                      strict_ordering      = true,
         int                       buffer_size          = -1,
-        int                       max_concurrent_tasks = -1);
+        int                       max_concurrent_tasks = -1,
+        int                       ring_capacity        = 0);
     ~threaded_task_queue();
 
     /**
@@ -108,12 +129,26 @@ public:
    */
     void push(Args&&... args);
 
+    /**
+   * Push one task per argument tuple, with a single round of notifications.
+   */
+    void push_batch(std::vector<argument_tuple> batch);
+
     /**
    * Pop the last result. Returns true on success. May fail if called on an
    * empty queue. This will wait for result to be available.
    */
     bool pop(R& result);
 
+    /**
+   * Like `pop`, waits for a result, then appends every result available right
+   * now (at most `max_results`) to `results`. Returns the number of results
+   * appended, 0 if the queue is empty.
+   */
+    std::size_t pop_batch(
+        std::vector<R>& results,
+        std::size_t     max_results = (std::numeric_limits<std::size_t>::max)());
+
     /**
    * Attempt to pop without waiting. If no results are available, returns
    * false.
@@ -146,11 +181,14 @@ template <typename... Args>
 class QUARISMA_VISIBILITY threaded_task_queue<void, Args...>
 {
 public:
+    using argument_tuple = std::tuple<typename std::decay<Args>::type...>;
+
     threaded_task_queue(
         std::function<void(Args...)> worker,
         bool                         strict_ordering      = true,
         int                          buffer_size          = -1,
-        int                          max_concurrent_tasks = -1);
+        int                          max_concurrent_tasks = -1,
+        int                          ring_capacity        = 0);
     ~threaded_task_queue();
 
     /**
@@ -158,6 +196,11 @@ public:
    */
     void push(Args&&... args);
 
+    /**
+   * Push one task per argument tuple, with a single round of notifications.
+   */
+    void push_batch(std::vector<argument_tuple> batch);
+
     /**
    * Returns false if there's some result that may be popped right now or in the
    * future.
@@ -192,7 +235,18 @@ template <typename R>
 class task_queue
 {
 public:
-    task_queue(int buffer_size) : done_(false), buffer_size_(buffer_size), next_task_id_(0) {}
+    task_queue(int buffer_size, int ring_capacity = 0)
+        : done_(false),
+          buffer_size_(buffer_size),
+          next_task_id_(0),
+          ring_(nullptr)
+    {
+        if (ring_capacity > 0)
+        {
+            ring_.reset(new quarisma::mpmc_ring_buffer<task_entry>(
+                static_cast<std::size_t>(std::max(ring_capacity, buffer_size))));
+        }
+    }
 
     ~task_queue() = default;
 
@@ -213,25 +267,63 @@ public:
         {
             return;
         }
-        else
+        if (ring_)
+        {
+            this->push_to_ring(std::move(task));
+            this->wake_workers(1);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(tasks_mutex_);
+            this->push_locked(std::move(task));
+        }
+        tasks_cv_.notify_one();
+    }
+
+    void push_batch(std::vector<std::function<R()>>& tasks)
+    {
+        if (done_ || tasks.empty())
+        {
+            return;
+        }
+        if (ring_)
+        {
+            for (auto& task : tasks)
+            {
+                this->push_to_ring(std::move(task));
+            }
+            this->wake_workers(tasks.size());
+            return;
+        }
         {
             std::lock_guard<std::mutex> lk(tasks_mutex_);
-            tasks_.push(std::make_pair(next_task_id_++, std::move(task)));
-            while (buffer_size_ > 0 && static_cast<int>(tasks_.size()) > buffer_size_)
+            for (auto& task : tasks)
             {
-                tasks_.pop();
+                this->push_locked(std::move(task));
             }
         }
-        tasks_cv_.notify_one();
+        if (tasks.size() == 1)
+        {
+            tasks_cv_.notify_one();
+        }
+        else
+        {
+            tasks_cv_.notify_all();
+        }
     }
 
     bool pop(std::uint64_t& task_id, std::function<R()>& task)
     {
+        if (ring_)
+        {
+            return this->pop_from_ring(task_id, task);
+        }
+
         std::unique_lock<std::mutex> lk(tasks_mutex_);
         tasks_cv_.wait(lk, [this] { return done_ || !tasks_.empty(); });
         if (!tasks_.empty())
         {
-            auto task_pair = tasks_.front();
+            auto task_pair = std::move(tasks_.front());
             tasks_.pop();
             lk.unlock();
 
@@ -244,12 +336,110 @@ public:
     }
 
 private:
-    std::atomic_bool                                         done_;
-    int                                                      buffer_size_;
-    std::atomic<std::uint64_t>                               next_task_id_;
-    std::queue<std::pair<std::uint64_t, std::function<R()>>> tasks_;
-    std::mutex                                               tasks_mutex_;
-    std::condition_variable                                  tasks_cv_;
+    using task_entry = std::pair<std::uint64_t, std::function<R()>>;
+
+    // REQUIRES: tasks_mutex_ is held.
+    void push_locked(std::function<R()>&& task)
+    {
+        tasks_.push(std::make_pair(next_task_id_++, std::move(task)));
+        while (buffer_size_ > 0 && static_cast<int>(tasks_.size()) > buffer_size_)
+        {
+            tasks_.pop();
+        }
+    }
+
+    void push_to_ring(std::function<R()>&& task)
+    {
+        task_entry entry(next_task_id_++, std::move(task));
+        task_entry dropped;
+        while (buffer_size_ > 0 && ring_->size_approx() >= static_cast<std::size_t>(buffer_size_) &&
+               ring_->try_pop(dropped))
+        {
+        }
+        while (!ring_->try_push(std::move(entry)))
+        {
+            // Full: make room by dropping the oldest task, or wait for the workers
+            if (buffer_size_ <= 0 || !ring_->try_pop(dropped))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Workers register in sleepers_ before blocking and re-check the ring after
+    // registering; the fences on both sides guarantee that either the producer
+    // sees the sleeper or the sleeper sees the new task.
+    void wake_workers(std::size_t count)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lk(tasks_mutex_);
+        if (count == 1)
+        {
+            tasks_cv_.notify_one();
+        }
+        else
+        {
+            tasks_cv_.notify_all();
+        }
+    }
+
+    bool pop_from_ring(std::uint64_t& task_id, std::function<R()>& task)
+    {
+        task_entry entry;
+        while (true)
+        {
+            for (int spin = 0; spin < 64; ++spin)
+            {
+                if (ring_->try_pop(entry))
+                {
+                    task_id = entry.first;
+                    task    = std::move(entry.second);
+                    return true;
+                }
+                std::this_thread::yield();
+            }
+
+            std::unique_lock<std::mutex> lk(tasks_mutex_);
+            sleepers_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const bool found = ring_->try_pop(entry);
+            if (!found && !done_)
+            {
+                tasks_cv_.wait(lk);
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            if (found)
+            {
+                task_id = entry.first;
+                task    = std::move(entry.second);
+                return true;
+            }
+            if (done_)
+            {
+                lk.unlock();
+                if (ring_->try_pop(entry))
+                {
+                    task_id = entry.first;
+                    task    = std::move(entry.second);
+                    return true;
+                }
+                return false;
+            }
+        }
+    }
+
+    std::atomic_bool                                        done_;
+    int                                                     buffer_size_;
+    std::atomic<std::uint64_t>                              next_task_id_;
+    std::queue<task_entry>                                  tasks_;
+    std::mutex                                              tasks_mutex_;
+    std::condition_variable                                 tasks_cv_;
+    std::unique_ptr<quarisma::mpmc_ring_buffer<task_entry>> ring_;  ///< Lock-free mode
+    std::atomic<int>                                        sleepers_{0};
 };
 
 //=============================================================================
@@ -305,7 +495,30 @@ public:
         return this->try_pop(result);
     }
 
+    std::size_t pop_batch(std::vector<R>& results, std::size_t max_results)
+    {
+        std::unique_lock<std::mutex> lk(results_mutex_);
+        results_cv_.wait(lk, [this] { return this->has_next_result(); });
+
+        std::size_t count = 0;
+        while (count < max_results && this->has_next_result())
+        {
+            auto result_pair = results_.top();
+            next_result_id_  = (result_pair.first + 1);
+            results_.pop();
+            results.push_back(std::move(result_pair.second));
+            ++count;
+        }
+        return count;
+    }
+
 private:
+    // REQUIRES: results_mutex_ is held.
+    bool has_next_result() const
+    {
+        return !results_.empty() && (!strict_ordering_ || results_.top().first == next_result_id_);
+    }
+
     template <typename T>
     struct comparator
     {
@@ -331,10 +544,11 @@ threaded_task_queue<R, Args...>::threaded_task_queue(
     std::function<R(Args...)> worker,
     bool                      strict_ordering,
     int                       buffer_size,
-    int                       max_concurrent_tasks)
+    int                       max_concurrent_tasks,
+    int                       ring_capacity)
     : worker_(worker),
       tasks_(new threaded_task_queue_internals::task_queue<R>(
-          std::max(0, strict_ordering ? 0 : buffer_size))),
+          std::max(0, strict_ordering ? 0 : buffer_size), ring_capacity)),
       results_(new threaded_task_queue_internals::result_queue<R>(strict_ordering)),
       number_of_threads_(
           max_concurrent_tasks <= 0 ? multi_threader::get_global_default_number_of_threads()
@@ -384,6 +598,20 @@ void threaded_task_queue<R, Args...>::push(Args&&... args)
                  { return std::apply(worker_, arguments); });
 }
 
+//-----------------------------------------------------------------------------
+template <typename R, typename... Args>
+void threaded_task_queue<R, Args...>::push_batch(std::vector<argument_tuple> batch)
+{
+    std::vector<std::function<R()>> tasks;
+    tasks.reserve(batch.size());
+    for (auto& arguments : batch)
+    {
+        tasks.emplace_back([this, arguments = std::move(arguments)]()
+                           { return std::apply(worker_, arguments); });
+    }
+    tasks_->push_batch(tasks);
+}
+
 //-----------------------------------------------------------------------------
 template <typename R, typename... Args>
 bool threaded_task_queue<R, Args...>::try_pop(R& result)
@@ -403,6 +631,19 @@ bool threaded_task_queue<R, Args...>::pop(R& result)
     return results_->pop(result);
 }
 
+//-----------------------------------------------------------------------------
+template <typename R, typename... Args>
+std::size_t threaded_task_queue<R, Args...>::pop_batch(
+    std::vector<R>& results, std::size_t max_results)
+{
+    if (max_results == 0 || this->is_empty())
+    {
+        return 0;
+    }
+
+    return results_->pop_batch(results, max_results);
+}
+
 //-----------------------------------------------------------------------------
 template <typename R, typename... Args>
 bool threaded_task_queue<R, Args...>::is_empty() const
@@ -431,10 +672,11 @@ threaded_task_queue<void, Args...>::threaded_task_queue(
     std::function<void(Args...)> worker,
     bool                         strict_ordering,
     int                          buffer_size,
-    int                          max_concurrent_tasks)
+    int                          max_concurrent_tasks,
+    int                          ring_capacity)
     : worker_(worker),
       tasks_(new threaded_task_queue_internals::task_queue<void>(
-          std::max(0, strict_ordering ? 0 : buffer_size))),
+          std::max(0, strict_ordering ? 0 : buffer_size), ring_capacity)),
       next_result_id_(0),
       number_of_threads_(
           max_concurrent_tasks <= 0 ? multi_threader::get_global_default_number_of_threads()
@@ -491,6 +733,20 @@ void threaded_task_queue<void, Args...>::push(Args&&... args)
                  { std::apply(worker_, arguments); });
 }
 
+//-----------------------------------------------------------------------------
+template <typename... Args>
+void threaded_task_queue<void, Args...>::push_batch(std::vector<argument_tuple> batch)
+{
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(batch.size());
+    for (auto& arguments : batch)
+    {
+        tasks.emplace_back([this, arguments = std::move(arguments)]()
+                           { std::apply(worker_, arguments); });
+    }
+    tasks_->push_batch(tasks);
+}
+
 //-----------------------------------------------------------------------------
 template <typename... Args>
 bool threaded_task_queue<void, Args...>::is_empty() const
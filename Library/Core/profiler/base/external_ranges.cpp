@@ -0,0 +1,208 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#include "profiler/base/external_ranges.h"
+
+#if QUARISMA_HAS_EXTERNAL_RANGES
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "util/flat_hash.h"
+
+#if QUARISMA_HAS_ITT
+#include <ittnotify.h>
+
+#include "profiler/itt/itt_wrapper.h"
+#endif
+
+#if QUARISMA_HAS_CUDA
+#ifdef QUARISMA_CUDA_USE_NVTX3
+#include <nvtx3/nvToolsExt.h>
+#else
+#include <nvToolsExt.h>
+#endif
+#endif
+#endif  // QUARISMA_HAS_EXTERNAL_RANGES
+
+namespace quarisma
+{
+namespace profiler
+{
+
+#if QUARISMA_HAS_EXTERNAL_RANGES
+
+std::atomic<int> external_ranges::level_{1};
+
+namespace
+{
+struct range_handles
+{
+#if QUARISMA_HAS_ITT
+    __itt_string_handle* itt_ = nullptr;
+#endif
+#if QUARISMA_HAS_CUDA
+    nvtxStringHandle_t nvtx_ = nullptr;
+#endif
+};
+
+#if QUARISMA_HAS_ITT
+// Null until a collector such as VTune is attached
+__itt_domain* itt_collecting_domain()
+{
+    static __itt_domain* const domain = itt_get_domain();
+    return domain != nullptr && domain->flags != 0 ? domain : nullptr;
+}
+#endif
+
+#if QUARISMA_HAS_CUDA
+nvtxDomainHandle_t nvtx_domain()
+{
+    static nvtxDomainHandle_t const domain = nvtxDomainCreateA("Quarisma");
+    return domain;
+}
+#endif
+
+range_handles register_name(const std::string& name)
+{
+    range_handles handles;
+#if QUARISMA_HAS_ITT
+    handles.itt_ = __itt_string_handle_create(name.c_str());
+#endif
+#if QUARISMA_HAS_CUDA
+    handles.nvtx_ = nvtxDomainRegisterStringA(nvtx_domain(), name.c_str());
+#endif
+    return handles;
+}
+
+// The handles of the names the calling thread has opened ranges for
+class handle_cache
+{
+public:
+    const range_handles& find(std::string_view name)
+    {
+        auto it = by_name_.find(name);
+        if (it == by_name_.end())
+        {
+            const std::string& owned = names_.emplace_back(name);
+            it = by_name_.emplace(std::string_view(owned), register_name(owned)).first;
+        }
+        return it->second;
+    }
+
+    const range_handles& find(std::uint32_t id, std::string_view name)
+    {
+        if (id >= by_id_.size())
+        {
+            by_id_.resize(static_cast<size_t>(id) + 1);
+            registered_.resize(static_cast<size_t>(id) + 1, false);
+        }
+        if (!registered_[id])
+        {
+            by_id_[id]      = register_name(std::string(name));
+            registered_[id] = true;
+        }
+        return by_id_[id];
+    }
+
+private:
+    std::deque<std::string>                       names_;  // Keys of by_name_ view these
+    quarisma_map<std::string_view, range_handles> by_name_;
+    std::vector<range_handles>                    by_id_;
+    std::vector<bool>                             registered_;
+};
+
+handle_cache& thread_cache()
+{
+    thread_local handle_cache cache;
+    return cache;
+}
+
+void begin(const range_handles& handles)
+{
+#if QUARISMA_HAS_ITT
+    if (__itt_domain* const domain = itt_collecting_domain())
+    {
+        __itt_task_begin(domain, __itt_null, __itt_null, handles.itt_);
+    }
+#endif
+#if QUARISMA_HAS_CUDA
+    nvtxEventAttributes_t attributes{};
+    attributes.version            = NVTX_VERSION;
+    attributes.size               = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+    attributes.messageType        = NVTX_MESSAGE_TYPE_REGISTERED;
+    attributes.message.registered = handles.nvtx_;
+    nvtxDomainRangePushEx(nvtx_domain(), &attributes);
+#endif
+}
+}  // namespace
+
+void external_ranges::set_level(int level) noexcept
+{
+    level_.store(level, std::memory_order_relaxed);
+}
+
+int external_ranges::level() noexcept
+{
+    return level_.load(std::memory_order_relaxed);
+}
+
+void external_ranges::push(std::string_view name)
+{
+    begin(thread_cache().find(name.substr(0, name.find('#'))));
+}
+
+void external_ranges::push(std::uint32_t id, std::string_view name)
+{
+    begin(thread_cache().find(id, name));
+}
+
+void external_ranges::pop() noexcept
+{
+#if QUARISMA_HAS_ITT
+    if (__itt_domain* const domain = itt_collecting_domain())
+    {
+        __itt_task_end(domain);
+    }
+#endif
+#if QUARISMA_HAS_CUDA
+    nvtxDomainRangePop(nvtx_domain());
+#endif
+}
+
+#else  // QUARISMA_HAS_EXTERNAL_RANGES
+
+void external_ranges::set_level(int /*level*/) noexcept {}
+
+int external_ranges::level() noexcept
+{
+    return 0;
+}
+
+void external_ranges::push(std::string_view /*name*/) {}
+
+void external_ranges::push(std::uint32_t /*id*/, std::string_view /*name*/) {}
+
+void external_ranges::pop() noexcept {}
+
+#endif  // QUARISMA_HAS_EXTERNAL_RANGES
+
+}  // namespace profiler
+}  // namespace quarisma
@@ -0,0 +1,109 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#pragma once
+
+#include <atomic>       // For std::atomic
+#include <cstdint>      // For std::uint32_t
+#include <string_view>  // For std::string_view
+
+#include "common/export.h"
+
+// NVTX comes with the CUDA toolkit; ITT needs QUARISMA_ENABLE_ITT
+#if QUARISMA_HAS_ITT || QUARISMA_HAS_CUDA
+#define QUARISMA_HAS_EXTERNAL_RANGES 1
+#else
+#define QUARISMA_HAS_EXTERNAL_RANGES 0
+#endif
+
+namespace quarisma
+{
+namespace profiler
+{
+
+/**
+ * @class external_ranges
+ * @brief Nested NVTX and ITT ranges for Nsight Systems and VTune timelines
+ *
+ * traceme, profiler_scope and logger::LogScopeRAII open a range here when
+ * active(), so that their regions show up in the timelines of external tools
+ * without a RecordFunction observer. Ranges nest per thread: every push() is
+ * closed by a pop() on the same thread.
+ *
+ * Both tools register a name once and take a handle to it. Registering is
+ * slow, so each thread caches the handles of the names it has opened; a
+ * range costs one hash lookup and the tool's push and pop calls.
+ *
+ * Without ITT or CUDA in the build, active() is always false and the calls
+ * compile away.
+ */
+class QUARISMA_VISIBILITY external_ranges
+{
+public:
+    /**
+     * @brief Whether events of `level` open ranges
+     *
+     * Levels are those of traceme: 1 for the most important events.
+     */
+    static bool active(int level = 1) noexcept
+    {
+#if QUARISMA_HAS_EXTERNAL_RANGES
+        return level <= level_.load(std::memory_order_relaxed);
+#else
+        (void)level;
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Open ranges for the events of `level` and below, 1 by default; 0 opens none
+     */
+    QUARISMA_API static void set_level(int level) noexcept;
+    QUARISMA_API static int  level() noexcept;
+
+    /**
+     * @brief Open a range named `name` up to its first '#'
+     *
+     * The metadata appended by traceme_encode() is dropped, so that events of
+     * one operation share a name and a cached handle.
+     */
+    QUARISMA_API static void push(std::string_view name);
+
+    /**
+     * @brief Open a range of an interned name, its handles cached by `id`
+     *
+     * @param id Small dense id, such as traceme_name::id(), that always
+     *        denotes `name`
+     */
+    QUARISMA_API static void push(std::uint32_t id, std::string_view name);
+
+    /**
+     * @brief Close the innermost range of the calling thread
+     */
+    QUARISMA_API static void pop() noexcept;
+
+private:
+#if QUARISMA_HAS_EXTERNAL_RANGES
+    QUARISMA_API static std::atomic<int> level_;
+#endif
+};
+
+}  // namespace profiler
+}  // namespace quarisma
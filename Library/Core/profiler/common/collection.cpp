@@ -3,18 +3,22 @@
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <numeric>
 #include <queue>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #if QUARISMA_HAS_KINETO
 #include <libkineto.h>
 #endif
 
+#include "parallel/parallel_tools.h"
 #include "profiler/common/data_flow.h"
 #include "profiler/common/ivalue.h"
 #include "profiler/common/record_function.h"
@@ -367,6 +371,12 @@ void InputOutputEncoder::clear()
 // ---------------------------------------------------
 template <typename T, size_t ChunkSize>
 ThreadLocalSubqueue::TorchOpStorage::EventBlock<T, ChunkSize>::EventBlock()
+{
+    reuse();
+}
+
+template <typename T, size_t ChunkSize>
+void ThreadLocalSubqueue::TorchOpStorage::EventBlock<T, ChunkSize>::reuse()
 {
     static std::atomic<uint64_t> counter_{0};
     id_start_ = 1 + (ChunkSize * counter_++);
@@ -660,6 +670,56 @@ static void materialize_vulkan(
 }
 #endif
 
+void ThreadLocalSubqueue::ActivityStorage::materialize(
+    std::vector<std::shared_ptr<Result>>&                       out,
+    const std::function<quarisma::time_t(quarisma::approx_time_t)>& time_converter,
+    const uint64_t                                              tid,
+    const kineto::DeviceAndResource&                            kineto_info)
+{
+    for (auto& i : backend_events_)
+    {
+        out.emplace_back(
+            Result::create(
+                /*start_time_ns_=*/i.start_time_us_ * 1000,
+                /*start_tid_=*/tid,
+                /*kineto_info_=*/kineto_info,
+                /*extra_fields_=*/std::move(i)));
+    }
+    backend_events_.clear();
+
+    materialize_vulkan(out, vulkan_events_, time_converter, tid, kineto_info);
+
+    for (auto& i : allocations_)
+    {
+        out.emplace_back(
+            Result::create(
+                /*start_time_ns_=*/time_converter(i.start_time_),
+                /*start_tid_=*/tid,
+                /*kineto_info_=*/kineto_info,
+                /*extra_fields_=*/ExtraFields<EventType::Allocation>(i)));
+    }
+    allocations_.clear();
+
+    for (auto& i : ooms_)
+    {
+        out.emplace_back(
+            Result::create(
+                /*start_time_ns_=*/time_converter(i.start_time_),
+                /*start_tid_=*/tid,
+                /*kineto_info_=*/kineto_info,
+                /*extra_fields_=*/std::move(i)));
+    }
+    ooms_.clear();
+}
+
+void ThreadLocalSubqueue::ActivityStorage::swap(ActivityStorage& other) noexcept
+{
+    backend_events_.swap(other.backend_events_);
+    vulkan_events_.swap(other.vulkan_events_);
+    allocations_.swap(other.allocations_);
+    ooms_.swap(other.ooms_);
+}
+
 namespace
 {
 // See `RecordQueue::getSubqueue()` for an overview of this cache.
@@ -866,6 +926,11 @@ RecordQueue::RecordQueue(ProfilerConfig config, std::set<ActivityType> activitie
     }
 }
 
+RecordQueue::~RecordQueue()
+{
+    stopFlush();
+}
+
 bool RecordQueue::tracePython() const
 {
     return config_.with_stack && (activities_.count(ActivityType::CPU) > 0);  //NOLINT
@@ -919,6 +984,71 @@ void RecordQueue::restart()
     }
 }
 
+void RecordQueue::startFlush(
+    std::chrono::milliseconds                                                 interval,
+    std::function<std::function<quarisma::time_t(quarisma::approx_time_t)>()> make_converter)
+{
+    QUARISMA_CHECK(!flush_thread_.joinable(), "Profiler flush thread is already running.");
+    flush_stop_   = false;
+    flush_thread_ = std::thread(
+        [this, interval, make_converter = std::move(make_converter)]
+        {
+            std::unique_lock<std::mutex> lock(flush_mutex_);
+            while (!flush_cv_.wait_for(lock, interval, [this] { return flush_stop_; }))
+            {
+                lock.unlock();
+                flush(make_converter());
+                lock.lock();
+            }
+        });
+}
+
+void RecordQueue::stopFlush()
+{
+    if (!flush_thread_.joinable())
+    {
+        return;
+    }
+    {
+        std::scoped_lock const lock(flush_mutex_);
+        flush_stop_ = true;
+    }
+    flush_cv_.notify_one();
+    flush_thread_.join();
+}
+
+void RecordQueue::flush(
+    const std::function<quarisma::time_t(quarisma::approx_time_t)>& time_converter)
+{
+    std::vector<ThreadLocalSubqueue*> queues;
+    {
+        std::scoped_lock const guard(sub_queue_mutex_);
+        queues.reserve(sub_queues_.size());
+        for (auto& subqueue_it : sub_queues_)
+        {
+            queues.push_back(subqueue_it.second.get());
+        }
+    }
+
+    using FlushState = ThreadLocalSubqueue::FlushState;
+    for (auto* queue : queues)
+    {
+        // Only the owner thread moves `Requested` to `Retired`, and only this
+        // thread moves the other two states, so plain stores are enough.
+        auto state = queue->flush_state_.load(std::memory_order_acquire);
+        if (state == FlushState::Retired)
+        {
+            queue->retired_events_.materialize(
+                queue->flushed_, time_converter, queue->tid(), queue->kineto_info());
+            state = FlushState::Idle;
+        }
+        if (state == FlushState::Idle)
+        {
+            queue->flush_state_.store(FlushState::Requested, std::memory_order_release);
+        }
+    }
+}
+
 namespace
 {
 void mark_finished(const std::shared_ptr<Result>& r)
@@ -1527,7 +1657,7 @@ void build_tree(std::vector<std::shared_ptr<Result>>& sorted_events)
         }
     };
 
-    auto pop_event = [&stacks](std::shared_ptr<Result> event)
+    auto pop_event = [&stacks](const std::shared_ptr<Result>& event)
     {
         if (event->finished_)
         {
@@ -1701,8 +1831,67 @@ void adjust_timestamps(std::vector<std::shared_ptr<Result>>& out)
         }
     }
 }
+
 }  // namespace
 
+// Stable sort by start time of `events`, which is the concatenation of the
+// runs [bounds[i], bounds[i + 1]). Runs are sorted concurrently and then merged
+// pairwise; because both steps are stable the order matches a single
+// `std::stable_sort` of the whole vector.
+void sort_runs_by_start_time(
+    std::vector<std::shared_ptr<Result>>& events, std::vector<size_t> bounds)
+{
+    auto const by_start = [](const auto& a, const auto& b)
+    { return a->start_time_ns_ < b->start_time_ns_; };
+
+    parallel_tools::parallel_for(
+        0,
+        bounds.size() - 1,
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                std::stable_sort(
+                    events.begin() + static_cast<std::ptrdiff_t>(bounds[i]),
+                    events.begin() + static_cast<std::ptrdiff_t>(bounds[i + 1]),
+                    by_start);
+            }
+        });
+
+    while (bounds.size() > 2)
+    {
+        size_t const n_merges = (bounds.size() - 1) / 2;
+        parallel_tools::parallel_for(
+            0,
+            n_merges,
+            1,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    std::inplace_merge(
+                        events.begin() + static_cast<std::ptrdiff_t>(bounds[2 * i]),
+                        events.begin() + static_cast<std::ptrdiff_t>(bounds[2 * i + 1]),
+                        events.begin() + static_cast<std::ptrdiff_t>(bounds[2 * i + 2]),
+                        by_start);
+                }
+            });
+
+        std::vector<size_t> merged;
+        merged.reserve(n_merges + 2);
+        for (size_t i = 0; i < bounds.size(); i += 2)
+        {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != bounds.back())
+        {
+            merged.push_back(bounds.back());
+        }
+        bounds.swap(merged);
+    }
+}
+
 std::pair<
     std::vector<std::shared_ptr<Result>>,
     std::unique_ptr<quarisma::profiler::impl::kineto::ActivityTraceWrapper>>
@@ -1725,55 +1914,81 @@ RecordQueue::getRecords(
         return (base.start_time_ns < ev_start) &&
                (base.end_time_ns <= ev_end && base.end_time_ns > ev_start);
     };
-    std::vector<std::shared_ptr<Result>>        out;
     std::vector<python_tracer::CompressedEvent> python_enters;
-    std::vector<ProfilerStepInfo>               step_info;
     long unsigned int                           step_idx = 0;
+
+    stopFlush();
+
+    // Subqueues are independent until the tree is built, so each one is
+    // materialized into its own buffer concurrently and the buffers are then
+    // concatenated in subqueue order.
+    std::vector<ThreadLocalSubqueue*> queues;
+    queues.reserve(sub_queues_.size());
     for (auto& subqueue_it : sub_queues_)
     {
-        auto& queue       = *subqueue_it.second;
-        auto  materialize = [&](auto& events)
+        queues.push_back(subqueue_it.second.get());
+    }
+
+    std::vector<std::vector<std::shared_ptr<Result>>> queue_out(queues.size());
+    std::vector<std::vector<ProfilerStepInfo>>        queue_steps(queues.size());
+    auto materialize_queue = [&](ThreadLocalSubqueue&                  queue,
+                                 std::vector<std::shared_ptr<Result>>& out,
+                                 std::vector<ProfilerStepInfo>&        step_info)
+    {
+        queue.torch_ops_.materialize(out, step_info, converter, queue.tid(), queue.kineto_info());
+
+        // Events converted by the flush thread, then those it has not reached.
+        std::move(queue.flushed_.begin(), queue.flushed_.end(), std::back_inserter(out));
+        queue.flushed_ = {};
+        queue.retired_events_.materialize(out, converter, queue.tid(), queue.kineto_info());
+        queue.activity_events_.materialize(out, converter, queue.tid(), queue.kineto_info());
+        queue.flush_state_.store(ThreadLocalSubqueue::FlushState::Idle, std::memory_order_relaxed);
+    };
+
+    parallel_tools::parallel_for(
+        0,
+        queues.size(),
+        1,
+        [&](size_t begin, size_t end)
         {
-            for (auto& i : events)
+            for (size_t i = begin; i < end; ++i)
             {
-                quarisma::time_t start_time_ns = 0;
-                if constexpr (std::is_same_v<
-                                  std::remove_reference_t<decltype(i)>,
-                                  ExtraFields<EventType::Backend>>)
-                {
-                    start_time_ns = i.start_time_us_ * 1000;
-                }
-                else
-                {
-                    start_time_ns = converter(i.start_time_);
-                }
-                out.emplace_back(
-                    Result::create(
-                        /*start_time_ns_=*/start_time_ns,
-                        /*start_tid_=*/queue.tid(),
-                        /*kineto_info_=*/queue.kineto_info(),
-                        /*extra_fields_=*/std::move(i)));
+                materialize_queue(*queues[i], queue_out[i], queue_steps[i]);
             }
-            events.clear();
-        };
+        });
 
-        queue.torch_ops_.materialize(out, step_info, converter, queue.tid(), queue.kineto_info());
-        materialize(queue.backend_events_);
-        materialize_vulkan(out, queue.vulkan_events_, converter, queue.tid(), queue.kineto_info());
-        for (auto& i : queue.allocations_)
-        {
-            out.emplace_back(
-                Result::create(
-                    /*start_time_ns_=*/converter(i.start_time_),
-                    /*start_tid_=*/queue.tid(),
-                    /*kineto_info_=*/queue.kineto_info(),
-                    /*extra_fields_=*/ExtraFields<EventType::Allocation>(i)));
+    // `bounds` delimits the runs of `out` that are sorted independently below.
+    std::vector<std::shared_ptr<Result>> out;
+    std::vector<ProfilerStepInfo>        step_info;
+    std::vector<size_t>                  bounds{0};
+    size_t                               total = 0;
+    for (const auto& q : queue_out)
+    {
+        total += q.size();
+    }
+    out.reserve(total);
+    for (size_t i = 0; i < queues.size(); ++i)
+    {
+        // Step indices were recorded relative to the subqueue's own buffer.
+        for (auto step : queue_steps[i])
+        {
+            step.out_idx += out.size();
+            step_info.push_back(step);
+        }
+        std::move(queue_out[i].begin(), queue_out[i].end(), std::back_inserter(out));
+        queue_out[i] = {};
+        if (out.size() != bounds.back())
+        {
+            bounds.push_back(out.size());
         }
-        queue.allocations_.clear();
-        materialize(queue.ooms_);
+    }
 
 #if 0
-        // Disabled: PythonGC event type not in variant (commented out in collection.h)
+    // Disabled: PythonGC event type not in variant (commented out in collection.h)
+    // Kept serial when enabled: it appends to `out` and `python_enters`.
+    for (auto* queue_ptr : queues)
+    {
+        auto& queue = *queue_ptr;
         std::optional<int64_t> pending_start;
         for (auto& e : queue.pythongc_)
         {
@@ -1810,8 +2025,8 @@ RecordQueue::getRecords(
             python_enters.push_back(
                 {i.first, queue.tid(), queue.kineto_info(), converter(i.second)});
         }
-#endif
     }
+#endif
 
     if (python_tracer_)
     {
@@ -1860,14 +2075,20 @@ RecordQueue::getRecords(
             out.push_back(i);
         }
         python_tracer_.reset();
+        if (out.size() != bounds.back())
+        {
+            bounds.push_back(out.size());
+        }
     }
 
     if (config_.experimental_config.adjust_timestamps)
     {
-        std::stable_sort(
-            out.begin(),
-            out.end(),
-            [](const auto& a, const auto& b) { return a->start_time_ns_ < b->start_time_ns_; });
+        sort_runs_by_start_time(out, bounds);
+        bounds.resize(1);
+        if (!out.empty())
+        {
+            bounds.push_back(out.size());
+        }
         build_tree(out);
         adjust_timestamps(out);
         for (auto& r : out)
@@ -1881,10 +2102,12 @@ RecordQueue::getRecords(
 
     auto trace = addKinetoEvents(out, start_time_ns, end_time_ns, config_);
 
-    std::stable_sort(
-        out.begin(),
-        out.end(),
-        [](const auto& a, const auto& b) { return a->start_time_ns_ < b->start_time_ns_; });
+    // Kineto appends its device events to `out`.
+    if (out.size() != bounds.back())
+    {
+        bounds.push_back(out.size());
+    }
+    sort_runs_by_start_time(out, std::move(bounds));
 
     if (config_.report_input_shapes && config_.profile_memory)
     {
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <variant>
@@ -577,25 +582,29 @@ public:
     template <class... Args>
     void emplace_backend_event(Args&&... args)
     {
-        backend_events_.emplace_back(std::forward<Args>(args)...);
+        maybe_retire();
+        activity_events_.backend_events_.emplace_back(std::forward<Args>(args)...);
     }
 
     template <class... Args>
     void emplace_vulkan_event(Args&&... args)
     {
-        vulkan_events_.emplace_back(std::forward<Args>(args)...);
+        maybe_retire();
+        activity_events_.vulkan_events_.emplace_back(std::forward<Args>(args)...);
     }
 
     template <class... Args>
     void emplace_allocation_event(Args&&... args)
     {
-        allocations_.emplace_back(std::forward<Args>(args)...);
+        maybe_retire();
+        activity_events_.allocations_.emplace_back(std::forward<Args>(args)...);
     }
 
     template <class... Args>
     void emplace_ooms_event(Args&&... args)
     {
-        ooms_.emplace_back(std::forward<Args>(args)...);
+        maybe_retire();
+        activity_events_.ooms_.emplace_back(std::forward<Args>(args)...);
     }
 
     template <class... Args>
@@ -646,6 +655,10 @@ private:
             EventBlock();
             uint64_t correlation_id(const T* ptr) const;
 
+            // Called by `BlockPool` when the block is reused: takes a fresh
+            // ID range so correlation IDs stay unique across sessions.
+            void reuse();
+
         private:
             uint64_t id_start_;
         };
@@ -682,17 +695,57 @@ private:
         AppendOnlyList<FallbackPair, BlockSize> device_fallback_;
     } torch_ops_;
 
-    // reportBackendEventToActiveKinetoProfiler
-    AppendOnlyList<ExtraFields<EventType::Backend>, BlockSize> backend_events_;
+    // Events that are complete once recorded, so unlike `torch_ops_` they can
+    // be converted while the profiler is still running.
+    struct ActivityStorage
+    {
+        // NB: This is a destructive operation.
+        void materialize(
+            std::vector<std::shared_ptr<Result>>&                       out,
+            const std::function<quarisma::time_t(quarisma::approx_time_t)>& time_converter,
+            const uint64_t                                              tid,
+            const kineto::DeviceAndResource&                            kineto_info);
+
+        void swap(ActivityStorage& other) noexcept;
 
-    // _reportVulkanEventToProfiler
-    AppendOnlyList<ExtraFields<EventType::Vulkan>::raw_event_t, BlockSize> vulkan_events_;
+        // reportBackendEventToActiveKinetoProfiler
+        AppendOnlyList<ExtraFields<EventType::Backend>, BlockSize> backend_events_;
 
-    // reportMemoryUsage
-    AppendOnlyList<RawAllocation, BlockSize> allocations_;
+        // _reportVulkanEventToProfiler
+        AppendOnlyList<ExtraFields<EventType::Vulkan>::raw_event_t, BlockSize> vulkan_events_;
 
-    // reportOOMs
-    AppendOnlyList<ExtraFields<EventType::OutOfMemory>, BlockSize> ooms_;
+        // reportMemoryUsage
+        AppendOnlyList<RawAllocation, BlockSize> allocations_;
+
+        // reportOOMs
+        AppendOnlyList<ExtraFields<EventType::OutOfMemory>, BlockSize> ooms_;
+    };
+
+    // Background flush (see `RecordQueue::startFlush`). The flush thread sets
+    // `Requested`; the owner thread then swaps `activity_events_` into the
+    // empty `retired_events_` on its next emplace and sets `Retired`, and the
+    // flush thread converts them into `flushed_` and goes back to `Idle`. The
+    // owner never waits, and the blocks drained go back to the `BlockPool`.
+    enum class FlushState : uint8_t
+    {
+        Idle,
+        Requested,
+        Retired
+    };
+
+    void maybe_retire()
+    {
+        if QUARISMA_UNLIKELY (flush_state_.load(std::memory_order_acquire) == FlushState::Requested)
+        {
+            activity_events_.swap(retired_events_);
+            flush_state_.store(FlushState::Retired, std::memory_order_release);
+        }
+    }
+
+    ActivityStorage                      activity_events_;
+    ActivityStorage                      retired_events_;
+    std::atomic<FlushState>              flush_state_{FlushState::Idle};
+    std::vector<std::shared_ptr<Result>> flushed_;
 
     // with_stack (Python)
     AppendOnlyList<std::pair<python_tracer::TraceKey, quarisma::approx_time_t>, BlockSize> py_calls_;
@@ -704,6 +757,9 @@ class QUARISMA_VISIBILITY RecordQueue
 {
 public:
     RecordQueue(ProfilerConfig config, std::set<ActivityType> activities);
+    ~RecordQueue();
+    RecordQueue(const RecordQueue&)            = delete;
+    RecordQueue& operator=(const RecordQueue&) = delete;
 
     bool                 tracePython() const;
     bool                 getPythonGcEvents() const;
@@ -711,6 +767,14 @@ public:
     void                 stop();
     void                 restart();
 
+    // Converts the completed activity events of every subqueue on a background
+    // thread each `interval`, calling `make_converter` once per flush. The
+    // thread stops in `getRecords` (or on destruction) at the latest.
+    void startFlush(
+        std::chrono::milliseconds                                                 interval,
+        std::function<std::function<quarisma::time_t(quarisma::approx_time_t)>()> make_converter);
+    void stopFlush();
+
     // NB: This is a destructive operation.
     std::pair<
         std::vector<std::shared_ptr<Result>>,
@@ -727,6 +791,13 @@ private:
     quarisma::flat_hash_map<uint64_t, std::unique_ptr<ThreadLocalSubqueue>> sub_queues_;
     std::mutex                                                            sub_queue_mutex_;
     std::unique_ptr<python_tracer::PythonTracerBase>                      python_tracer_;
+
+    void flush(const std::function<quarisma::time_t(quarisma::approx_time_t)>& time_converter);
+
+    std::thread             flush_thread_;
+    std::mutex              flush_mutex_;
+    std::condition_variable flush_cv_;
+    bool                    flush_stop_{false};
 };
 
 QUARISMA_API bool get_record_concrete_inputs_enabled();
@@ -747,4 +818,9 @@ QUARISMA_API bool get_record_tensor_addrs_enabled();
 QUARISMA_API void set_record_tensor_addrs_enabled_fn(std::function<bool()> /*fn*/);
 QUARISMA_API void set_record_tensor_addrs_enabled_val(bool /*val*/);
 
+// Stable sort by start time of `events`, the concatenation of the runs
+// [bounds[i], bounds[i + 1]) that getRecords() builds from its subqueues.
+QUARISMA_API void sort_runs_by_start_time(
+    std::vector<std::shared_ptr<Result>>& events, std::vector<size_t> bounds);
+
 }  // namespace quarisma::profiler::impl
@@ -5,6 +5,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <forward_list>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
 #include <utility>
 
 #include "common/macros.h"
@@ -14,6 +17,89 @@
 namespace quarisma::profiler::impl
 {
 
+// ============================================================================
+// == BlockPool ===============================================================
+// ============================================================================
+//   Blocks of an AppendOnlyList are large (`ChunkSize` elements each), so
+// large that the allocator typically serves them with fresh pages, and a
+// profiler that is started repeatedly (e.g. on-demand tracing of a long run)
+// pays for them again every session. `BlockPool` keeps up to `MaxBlocks`
+// released blocks per block type and hands them back to the next list that
+// grows. Blocks move in and out with `splice_after`, so neither side allocates.
+//
+//   A block type may define `reuse()`, which is called when a pooled block is
+// handed out again, to reset per-block state set by its constructor.
+
+template <typename array_t>
+class BlockPool
+{
+public:
+    static constexpr size_t MaxBlocks = 64;
+
+    static BlockPool& instance()
+    {
+        // Leaked: lists may release blocks during static destruction.
+        static auto* pool = new BlockPool();
+        return *pool;
+    }
+
+    // Moves up to `MaxBlocks` blocks from the front of `blocks` into the pool;
+    // the caller frees whatever is left.
+    void release(std::forward_list<array_t>& blocks, size_t n_blocks)
+    {
+        std::scoped_lock const lock(mutex_);
+        size_t const           n = std::min(n_blocks, MaxBlocks - size_);
+        if (n == 0)
+        {
+            return;
+        }
+        auto last = blocks.begin();
+        std::advance(last, n - 1);
+        free_.splice_after(free_.before_begin(), blocks, blocks.before_begin(), std::next(last));
+        size_ += n;
+    }
+
+    // Moves one pooled block after `pos` in `blocks`.
+    bool acquire(
+        std::forward_list<array_t>& blocks, typename std::forward_list<array_t>::iterator pos)
+    {
+        {
+            std::scoped_lock const lock(mutex_);
+            if (size_ == 0)
+            {
+                return false;
+            }
+            blocks.splice_after(pos, free_, free_.before_begin());
+            --size_;
+        }
+        if constexpr (has_reuse<array_t>::value)
+        {
+            std::next(pos)->reuse();
+        }
+        return true;
+    }
+
+    size_t size() const
+    {
+        std::scoped_lock const lock(mutex_);
+        return size_;
+    }
+
+private:
+    template <typename U, typename = void>
+    struct has_reuse : std::false_type
+    {
+    };
+    template <typename U>
+    struct has_reuse<U, std::void_t<decltype(std::declval<U&>().reuse())>> : std::true_type
+    {
+    };
+
+    mutable std::mutex         mutex_;
+    std::forward_list<array_t> free_;
+    size_t                     size_{0};
+};
+
 // ============================================================================
 // == AppendOnlyList ==========================================================
 // ============================================================================
@@ -53,7 +139,7 @@ public:
     AppendOnlyList(AppendOnlyList&&)                 = delete;
     AppendOnlyList& operator=(const AppendOnlyList&) = delete;
     AppendOnlyList& operator=(AppendOnlyList&&)      = delete;
-    ~AppendOnlyList()                                = default;
+    ~AppendOnlyList() { BlockPool<array_t>::instance().release(buffer_, n_blocks_); }
 
     size_t size() const { return n_blocks_ * ChunkSize - (size_t)(end_ - next_); }
 
@@ -102,6 +188,7 @@ public:
 
     void clear()
     {
+        BlockPool<array_t>::instance().release(buffer_, n_blocks_);
         buffer_.clear();
         buffer_last_ = buffer_.before_begin();
         n_blocks_    = 0;
@@ -109,6 +196,27 @@ public:
         end_         = nullptr;
     }
 
+    // Exchanges the contents of two lists without moving any element, so one
+    // can be drained while the other keeps growing.
+    void swap(AppendOnlyList& other) noexcept
+    {
+        buffer_.swap(other.buffer_);
+        std::swap(n_blocks_, other.n_blocks_);
+        std::swap(next_, other.next_);
+        std::swap(end_, other.end_);
+        std::swap(buffer_last_, other.buffer_last_);
+
+        // `before_begin()` belongs to the list object, not to its nodes.
+        if (n_blocks_ == 0)
+        {
+            buffer_last_ = buffer_.before_begin();
+        }
+        if (other.n_blocks_ == 0)
+        {
+            other.buffer_last_ = other.buffer_.before_begin();
+        }
+    }
+
     struct Iterator
     {
         using iterator_category = std::forward_iterator_tag;
@@ -192,7 +300,14 @@ private:
     {
         if QUARISMA_UNLIKELY (next_ == end_)
         {
-            buffer_last_ = buffer_.emplace_after(buffer_last_);
+            if (BlockPool<array_t>::instance().acquire(buffer_, buffer_last_))
+            {
+                ++buffer_last_;
+            }
+            else
+            {
+                buffer_last_ = buffer_.emplace_after(buffer_last_);
+            }
             n_blocks_++;
             next_ = buffer_last_->data();
             end_  = next_ + ChunkSize;
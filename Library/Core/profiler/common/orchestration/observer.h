@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <mutex>
 #include <utility>
 
@@ -73,7 +74,8 @@ struct QUARISMA_VISIBILITY ExperimentalConfig
         bool                     record_python_gc_info        = false,
         bool                     expose_kineto_event_metadata = false,
         std::string              custom_profiler_config       = "",
-        bool                     adjust_timestamps            = false);
+        bool                     adjust_timestamps            = false,
+        int64_t                  flush_interval_ms            = 0);
     QUARISMA_API explicit operator bool() const;
 
     std::vector<std::string> profiler_metrics;
@@ -139,6 +141,14 @@ struct QUARISMA_VISIBILITY ExperimentalConfig
    * information instead of the original information.
    */
     bool adjust_timestamps;
+
+    /*
+   * Period in milliseconds of the background flush of completed activity
+   * buffers while profiling runs (0 disables it). Each flush converts the
+   * events recorded so far into results and returns their blocks to the pool,
+   * so long traces neither pause nor grow their buffers at stop.
+   */
+    int64_t flush_interval_ms;
 };
 
 struct QUARISMA_VISIBILITY ProfilerConfig
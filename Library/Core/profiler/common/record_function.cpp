@@ -13,12 +13,13 @@
 #include "util/irange.h"
 #include "util/overloaded.h"
 #include "util/small_vector.h"
+#include "util/startup_tracer.h"
 #include "util/strong_type.h"
 
 namespace quarisma
 {
 
-extern const std::string kParamCommsCallName = "record_param_comms";
+std::atomic<int64_t> detail::record_function_callback_count{0};
 
 namespace
 {
@@ -53,7 +54,7 @@ RecordFunctionCallbacks::iterator findCallback(
     return std::find_if(entries.begin(), entries.end(), match_handle);
 }
 
-std::optional<RecordFunctionCallback> extractCallback(
+std::optional<RecordFunctionCallbacksEntry> extractCallback(
     RecordFunctionCallbacks& entries, CallbackHandle handle)
 {
     auto it = findCallback(entries, handle);
@@ -61,11 +62,27 @@ std::optional<RecordFunctionCallback> extractCallback(
     {
         return std::nullopt;
     }
-    auto out = it->callback_;
+    auto out = *it;
     entries.erase(it);
     return out;
 }
 
+int64_t countEnabled(const RecordFunctionCallbacks& entries)
+{
+    return std::count_if(
+        entries.begin(), entries.end(), [](const auto& el) { return el.enabled_; });
+}
+
+// Keeps the count read by mayRunRecordFunctionCallbacks() in step with the
+// enabled callbacks of the global and thread local managers
+void adjustCallbackCount(int64_t delta)
+{
+    if (delta != 0)
+    {
+        detail::record_function_callback_count.fetch_add(delta, std::memory_order_relaxed);
+    }
+}
+
 // ============================================================================
 // == Callback manager ========================================================
 // ============================================================================
@@ -109,6 +126,10 @@ std::optional<RecordFunctionCallback> extractCallback(
 // analogous to flipping different coins with the same probability. By sharding
 // on RecordScope, we can consolidate the decrement to a single shared counter
 // and update individual counters during rebuild.
+//
+// In front of all this sits a process wide count of enabled callbacks. When
+// it is zero, which is the normal state of a production run, RecordFunction
+// is inactive after a single relaxed load and never reaches the managers.
 
 class GlobalCallbackManager
 {
@@ -187,6 +208,8 @@ private:
     LocalCallbackManager();
 
 public:
+    ~LocalCallbackManager();
+
     [[nodiscard]] const RecordFunctionTLS& getTLS() const;
     StepCallbacks                          getActiveCallbacks(RecordScope scope);
     std::optional<StepCallbacks>           getActiveCallbacksUnlessEmpty(RecordScope scope);
@@ -244,6 +267,7 @@ CallbackHandle GlobalCallbackManager::addCallback(RecordFunctionCallback cb)
     ++version_;
     auto handle = next_unique_callback_handle();
     global_callbacks_.emplace_back(cb, handle);
+    adjustCallbackCount(1);
     return handle;
 }
 
@@ -257,6 +281,7 @@ void GlobalCallbackManager::setCallbackEnabled(CallbackHandle handle, bool enabl
         {
             ++version_;
             it->enabled_ = enabled;
+            adjustCallbackCount(enabled ? 1 : -1);
         }
     }
     else
@@ -268,9 +293,11 @@ void GlobalCallbackManager::setCallbackEnabled(CallbackHandle handle, bool enabl
 void GlobalCallbackManager::removeCallback(CallbackHandle handle)
 {
     std::scoped_lock const guard(update_mutex_);
-    if (extractCallback(global_callbacks_, handle).has_value())
+    auto                   entry = extractCallback(global_callbacks_, handle);
+    if (entry.has_value())
     {
         ++version_;
+        adjustCallbackCount(entry->enabled_ ? -1 : 0);
     }
     else
     {
@@ -282,6 +309,7 @@ void GlobalCallbackManager::clearCallbacks()
 {
     std::scoped_lock const guard(update_mutex_);
     ++version_;
+    adjustCallbackCount(-countEnabled(global_callbacks_));
     global_callbacks_.clear();
 }
 
@@ -382,8 +410,10 @@ void CacheEntry::rebuildActiveCallbacks()
         {
             // Callback is sampled and we have not reached sampling event. Set
             // `sampling_countdown_` to rebuild when it is time for this callback to
-            // execute.
+            // execute. It does not run, so its inputs, outputs and ids are not
+            // captured either.
             sampling_countdown_ = std::min(sampling_countdown_, i.tries_left_);
+            continue;
         }
         active_callbacks_.needs_inputs_ |= i.callback_.needsInputs();
         active_callbacks_.needs_outputs_ |= i.callback_.needsOutputs();
@@ -398,8 +428,11 @@ int CacheEntry::sampleTries(double p) const
     QUARISMA_CHECK(p > 0.0 && p <= 1.0);  //NOLINT
 
     // The geometric distribution returns the number of failures. We add one to
-    // also account for the call where we succeed.
-    return std::geometric_distribution<int>(p)(*generator_) + 1;
+    // also account for the call where we succeed. Draws are clamped so that
+    // very small probabilities cannot overflow the countdown.
+    auto const failures = std::geometric_distribution<int64_t>(p)(*generator_);
+    return static_cast<int>(
+        std::min<int64_t>(failures, std::numeric_limits<int>::max() - 1) + 1);
 }
 
 // ============================================================================
@@ -425,6 +458,11 @@ LocalCallbackManager::LocalCallbackManager()
     rebuild_all(GlobalCallbackManager::get().getSnapshot());
 }
 
+LocalCallbackManager::~LocalCallbackManager()
+{
+    adjustCallbackCount(-countEnabled(registered_callbacks_.sorted_tls_callbacks_));
+}
+
 const RecordFunctionTLS& LocalCallbackManager::getTLS() const
 {
     return registered_callbacks_;
@@ -454,6 +492,9 @@ std::optional<StepCallbacks> LocalCallbackManager::getActiveCallbacksUnlessEmpty
 
 void LocalCallbackManager::setTLS(const RecordFunctionTLS& tls)
 {
+    adjustCallbackCount(
+        countEnabled(tls.sorted_tls_callbacks_) -
+        countEnabled(registered_callbacks_.sorted_tls_callbacks_));
     registered_callbacks_ = tls;
     rebuild_all(GlobalCallbackManager::get().getSnapshot());
 }
@@ -468,6 +509,7 @@ CallbackHandle LocalCallbackManager::addCallback(RecordFunctionCallback callback
     auto  handle    = next_unique_callback_handle();
     auto& callbacks = registered_callbacks_.sorted_tls_callbacks_;
     callbacks.emplace_back(callback, handle);
+    adjustCallbackCount(1);
     rebuild_callback_scopes(GlobalCallbackManager::get().getSnapshot(), callbacks.back().callback_);
     return handle;
 }
@@ -479,6 +521,7 @@ bool LocalCallbackManager::setCallbackEnabled(CallbackHandle handle, bool enable
     if (found && it->enabled_ != enabled)
     {
         it->enabled_ = enabled;
+        adjustCallbackCount(enabled ? 1 : -1);
         rebuild_callback_scopes(GlobalCallbackManager::get().getSnapshot(), it->callback_);
     }
     return found;
@@ -487,16 +530,18 @@ bool LocalCallbackManager::setCallbackEnabled(CallbackHandle handle, bool enable
 bool LocalCallbackManager::removeCallback(CallbackHandle handle)
 {
     auto& callbacks = registered_callbacks_.sorted_tls_callbacks_;
-    auto  callback  = extractCallback(callbacks, handle);
-    if (callback.has_value())
+    auto  entry     = extractCallback(callbacks, handle);
+    if (entry.has_value())
     {
-        rebuild_callback_scopes(GlobalCallbackManager::get().getSnapshot(), *callback);
+        adjustCallbackCount(entry->enabled_ ? -1 : 0);
+        rebuild_callback_scopes(GlobalCallbackManager::get().getSnapshot(), entry->callback_);
     }
-    return callback.has_value();
+    return entry.has_value();
 }
 
 void LocalCallbackManager::clearCallbacks()
 {
+    adjustCallbackCount(-countEnabled(registered_callbacks_.sorted_tls_callbacks_));
     registered_callbacks_.sorted_tls_callbacks_.clear();
     rebuild_all(GlobalCallbackManager::get().getSnapshot());
 }
@@ -595,8 +640,6 @@ QUARISMA_FORCE_INLINE bool tryRunCallback(
 
 }  // namespace
 
-RecordFunction::RecordFunction(RecordScope scope) : RecordFunction(getStepCallbacks(scope)) {}
-
 RecordFunction::RecordFunction(StepCallbacks&& step_callbacks)
     : step_callbacks_{std::move(step_callbacks)}
 {
@@ -734,11 +777,19 @@ const char* RecordFunction::overload_name()
 
 StepCallbacks getStepCallbacks(RecordScope scope)
 {
+    if (!mayRunRecordFunctionCallbacks())
+    {
+        return StepCallbacks(0, scope);
+    }
     return LocalCallbackManager::get().getActiveCallbacks(scope);
 }
 
 std::optional<StepCallbacks> getStepCallbacksUnlessEmpty(RecordScope scope)
 {
+    if QUARISMA_LIKELY (!mayRunRecordFunctionCallbacks())
+    {
+        return std::nullopt;
+    }
     return LocalCallbackManager::get().getActiveCallbacksUnlessEmpty(scope);
 }
 
@@ -783,6 +834,7 @@ CallbackHandle addThreadLocalCallback(RecordFunctionCallback cb)
 
 CallbackHandle addGlobalCallback(RecordFunctionCallback cb)
 {
+    const startup_tracer::scope traced("record_function::add_global_callback");
     return GlobalCallbackManager::get().addCallback(cb);
 }
 
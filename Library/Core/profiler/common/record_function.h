@@ -3,6 +3,7 @@
 //#include <Quarisma/core/ivalue.h>
 //#include <Quarisma/core/operator_name.h>
 #include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -34,7 +35,7 @@ class OperatorName
 };
 
 // Function name to record NCCL metadata
-extern QUARISMA_API const std::string kParamCommsCallName;
+inline constexpr std::string_view kParamCommsCallName = "record_param_comms";
 
 // Kind of record function scope;
 enum class RecordScope : uint8_t
@@ -292,13 +293,34 @@ struct StepCallbacks
     bool          needs_ids_{false};
 };
 
+namespace detail
+{
+// Enabled global and thread local callbacks of all threads; may overcount,
+// never undercounts
+QUARISMA_API extern std::atomic<int64_t> record_function_callback_count;
+}  // namespace detail
+
+// Whether any callback may run, a single relaxed load. When false, a
+// RecordFunction is inactive without touching the thread local callback
+// managers, which keeps RecordFunction cheap in builds that ship it.
+QUARISMA_FORCE_INLINE bool mayRunRecordFunctionCallbacks()
+{
+    return detail::record_function_callback_count.load(std::memory_order_relaxed) != 0;
+}
+
+QUARISMA_API StepCallbacks getStepCallbacks(RecordScope scope);
+
+QUARISMA_API std::optional<StepCallbacks> getStepCallbacksUnlessEmpty(RecordScope scope);
+
 struct QUARISMA_VISIBILITY RecordFunction
 {
     // Default constructor is used with before function called afterwards:
     //  scope - record scope that this function tracks
-    //  pre_sampled - whether this RecordFunction was already pre-sampled with
-    //    kLowProb probability
-    QUARISMA_API explicit RecordFunction(RecordScope scope = RecordScope::FUNCTION);
+    explicit RecordFunction(RecordScope scope = RecordScope::FUNCTION)
+        : RecordFunction(
+              mayRunRecordFunctionCallbacks() ? getStepCallbacks(scope) : StepCallbacks(0, scope))
+    {
+    }
     QUARISMA_API explicit RecordFunction(StepCallbacks&& step_callbacks);
 
     using schema_ref_t       = std::reference_wrapper<const quarisma::FunctionSchema>;
@@ -327,7 +349,10 @@ struct QUARISMA_VISIBILITY RecordFunction
         {
             return;
         }
-        kwinputs_ = *kwargs;
+        if (needsInputs())
+        {
+            kwinputs_ = *kwargs;
+        }
         before(fn, args, current_sequence_nr);
     }
 
@@ -340,7 +365,10 @@ struct QUARISMA_VISIBILITY RecordFunction
         {
             return;
         }
-        kwinputs_ = *kwargs;
+        if (needsInputs())
+        {
+            kwinputs_ = *kwargs;
+        }
         before(fn, current_sequence_nr);
     }
 
@@ -363,7 +391,10 @@ struct QUARISMA_VISIBILITY RecordFunction
         {
             return;
         }
-        kwinputs_ = *kwargs;
+        if (needsInputs())
+        {
+            kwinputs_ = *kwargs;
+        }
         before(std::move(fn), args, current_sequence_nr);
     }
 
@@ -528,10 +559,6 @@ private:
     bool is_nccl_meta_{false};
 };
 
-QUARISMA_API StepCallbacks getStepCallbacks(RecordScope scope);
-
-QUARISMA_API std::optional<StepCallbacks> getStepCallbacksUnlessEmpty(RecordScope scope);
-
 namespace detail
 {
 template <typename Inputs, typename... Args>
@@ -25,26 +25,36 @@
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <stack>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 // TODO: Missing Quarisma dependencies - original includes were:
 // //#include <Quarisma/core/TensorBody.h>
 // //#include <Quarisma/core/function_schema.h>
 // //#include <Quarisma/core/stack.h>
+#include "compression/framed_stream.h"
 #include "profiler/base/thread_local_debug_info.h"
 #include "profiler/common/record_function.h"
 #include "profiler/common/standalone/execution_trace_observer.h"
 #include "profiler/common/util.h"
 #include "util/env.h"
 #include "util/irange.h"
+#include "util/per_thread.h"
 
 #ifdef USE_DISTRIBUTED
 #include <quarisma/csrc/distributed/c10d/ParamCommsUtils.hpp>
@@ -152,6 +162,100 @@ static int32_t processId()
 #endif
 }
 
+//******************************************************************************
+// Background serialization of the trace.
+//******************************************************************************
+
+// The RecordFunction callbacks only append each node, as a compact binary
+// record, to a buffer of their own thread, and hand full buffers over to a
+// writer thread. The writer formats the records as JSON and writes the file
+// in large blocks, through a Snappy framed stream when compression is on.
+// Nodes reach the file in the order their blocks reach the writer rather than
+// in completion order, which the trace format allows: nodes refer to their
+// parents by id.
+
+// Bytes of records a thread buffers before handing them to the writer
+constexpr size_t kTraceBlockBytes = size_t{256} << 10;
+// Bytes handed over and not yet written beyond which the callbacks wait
+constexpr size_t kTraceMaxPendingBytes = size_t{64} << 20;
+// Bytes of JSON the writer gathers before each write to the file
+constexpr size_t kTraceWriteBytes = size_t{1} << 20;
+// Longest time a record waits in the buffer of a quiet thread
+constexpr auto kTraceFlushInterval = std::chrono::milliseconds(100);
+
+constexpr size_t kTraceNodeLists   = 8;
+constexpr size_t kTraceNodeStrings = 5;
+
+// A node as the callbacks see it; the strings are only borrowed
+struct trace_node
+{
+    uint64_t         id{0};
+    uint64_t         rf_id{0};
+    uint64_t         parent{0};
+    uint64_t         fw_parent{0};
+    int64_t          seq_id{-1};
+    uint64_t         scope{0};
+    uint64_t         tid{0};
+    uint64_t         fw_tid{0};
+    std::string_view name;
+    // Input values, shapes, strides and types, then the same of the outputs;
+    // nullptr is an empty list
+    std::array<const std::vector<std::string>*, kTraceNodeLists> lists{};
+    // Operator schema, kernel backend, kernel file, tensor range, extra attributes
+    std::array<std::string_view, kTraceNodeStrings> strings{};
+};
+
+// Records of one thread not yet handed over to the writer
+struct trace_thread_buffer
+{
+    std::mutex  mutex;
+    std::string bytes;
+};
+
+// Owns the output file and the thread writing it
+class trace_writer
+{
+public:
+    trace_writer(std::ofstream out, bool compress);
+    ~trace_writer() { stop(); }
+
+    // Appends text to the file; only while the writer thread is not running
+    void write(std::string_view text);
+
+    void start();
+
+    // Hands a block of records over, waiting while too many are pending
+    void submit(std::string block);
+
+    // Writes every record buffered so far and joins the writer thread
+    void stop();
+
+    // Completes the compressed stream and closes the file; false on failure
+    bool close();
+
+    trace_writer(const trace_writer&)            = delete;
+    trace_writer& operator=(const trace_writer&) = delete;
+
+private:
+    void run();
+    void write_pending(std::unique_lock<std::mutex>& lock);
+    void drain_threads();
+    void write_records(const std::string& records);
+    void flush_text();
+
+    std::ofstream                                   out_;
+    std::unique_ptr<compression::framed_compressor> compressor_;
+    std::string                                     text_;
+
+    std::mutex              mutex_;
+    std::condition_variable work_;
+    std::condition_variable space_;
+    std::deque<std::string> blocks_;
+    size_t                  pending_bytes_{0};
+    bool                    stop_{false};
+    std::thread             thread_;
+};
+
 //******************************************************************************
 // Main ExecutionTraceObserver implementation.
 //******************************************************************************
@@ -231,8 +335,10 @@ struct QUARISMA_VISIBILITY ExecutionTraceObserver
 
     // Mutex for multithreaded access to the shared containers.
     std::recursive_mutex gMutex;
-    // Stream to write output JSON.
-    std::ofstream out;
+    // Writer of the output JSON.
+    std::unique_ptr<trace_writer> writer;
+    // Whether the output is a Snappy framed stream.
+    bool compress{false};
 
     // Full path to the output file.
     std::string fileName;
@@ -382,7 +488,7 @@ static std::string getAttrJson(
 #endif
 
 static void writeJsonNode(
-    std::ofstream&     out,
+    std::string&       out,
     const std::string& name,
     const uint64_t     id,
     const uint64_t     rf_id,
@@ -406,14 +512,10 @@ static void writeJsonNode(
     const std::string& tensor_range    = "",
     const std::string& additiona_attrs = "")
 {
-    if (!out.is_open() || out.fail() || out.bad())
-    {
-        return;
-    }
-
     try
     {
-        out << fmt::format(
+        fmt::format_to(
+            std::back_inserter(out),
             R"JSON(
       {{
         "id": {}, "name": "{}", "ctrl_deps": {},
@@ -455,6 +557,317 @@ static void writeJsonNode(
     }
 }
 
+static void putTraceString(std::string& out, std::string_view value)
+{
+    auto const size = static_cast<uint32_t>(value.size());
+    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.append(value.data(), value.size());
+}
+
+// Appends node to out as a u32 length, the ids, then the length-prefixed strings
+static void encodeTraceNode(std::string& out, const trace_node& node)
+{
+    size_t const start = out.size();
+    out.append(sizeof(uint32_t), '\0');
+
+    uint64_t const ids[] = {
+        node.id,
+        node.rf_id,
+        node.parent,
+        node.fw_parent,
+        static_cast<uint64_t>(node.seq_id),
+        node.scope,
+        node.tid,
+        node.fw_tid};
+    out.append(reinterpret_cast<const char*>(ids), sizeof(ids));
+    putTraceString(out, node.name);
+    for (const auto* list : node.lists)
+    {
+        auto const count = static_cast<uint32_t>(list != nullptr ? list->size() : 0);
+        out.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            putTraceString(out, (*list)[i]);
+        }
+    }
+    for (auto value : node.strings)
+    {
+        putTraceString(out, value);
+    }
+
+    auto const size = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    std::memcpy(&out[start], &size, sizeof(size));
+}
+
+// Reads back what encodeTraceNode wrote
+class trace_record_reader
+{
+public:
+    trace_record_reader(const char* data, size_t size) : p_(data), end_(data + size) {}
+
+    template <typename T>
+    T get()
+    {
+        QUARISMA_CHECK_DEBUG(p_ + sizeof(T) <= end_, "truncated execution trace record");
+        T value;
+        std::memcpy(&value, p_, sizeof(T));
+        p_ += sizeof(T);
+        return value;
+    }
+
+    std::string_view get_string()
+    {
+        auto const size = get<uint32_t>();
+        QUARISMA_CHECK_DEBUG(p_ + size <= end_, "truncated execution trace record");
+        std::string_view const value(p_, size);
+        p_ += size;
+        return value;
+    }
+
+    // The list as vectorToString() would format it
+    std::string get_list()
+    {
+        auto const  count = get<uint32_t>();
+        std::string result("[");
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (i != 0)
+            {
+                result += ',';
+            }
+            result += get_string();
+        }
+        result += ']';
+        return result;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+};
+
+trace_writer::trace_writer(std::ofstream out, bool compress) : out_(std::move(out))
+{
+    if (compress)
+    {
+        compressor_ = std::make_unique<compression::framed_compressor>(
+            [this](const char* data, size_t size)
+            { out_.write(data, static_cast<std::streamsize>(size)); });
+    }
+}
+
+void trace_writer::write(std::string_view text)
+{
+    text_.append(text);
+}
+
+void trace_writer::start()
+{
+    // Drop what an earlier trace recorded after its last drain
+    per_thread<trace_thread_buffer>::ForEachThread(
+        [](trace_thread_buffer& buffer)
+        {
+            const std::scoped_lock lock(buffer.mutex);
+            buffer.bytes.clear();
+        });
+    // Keeps the buffers of threads exiting mid-trace until they are drained
+    per_thread<trace_thread_buffer>::StartRecording();
+    stop_   = false;
+    thread_ = std::thread([this] { run(); });
+}
+
+void trace_writer::submit(std::string block)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_.wait(lock, [this] { return stop_ || pending_bytes_ < kTraceMaxPendingBytes; });
+    pending_bytes_ += block.size();
+    blocks_.push_back(std::move(block));
+    lock.unlock();
+    work_.notify_one();
+}
+
+void trace_writer::stop()
+{
+    {
+        const std::scoped_lock lock(mutex_);
+        if (!thread_.joinable())
+        {
+            return;
+        }
+        stop_ = true;
+    }
+    work_.notify_one();
+    space_.notify_all();
+    thread_.join();
+    per_thread<trace_thread_buffer>::StopRecording();
+}
+
+bool trace_writer::close()
+{
+    flush_text();
+    if (compressor_)
+    {
+        compressor_->flush();
+    }
+    out_.close();
+    return !out_.fail();
+}
+
+void trace_writer::run()
+{
+    auto                         last_drain = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_)
+    {
+        work_.wait_until(
+            lock, last_drain + kTraceFlushInterval, [this] { return stop_ || !blocks_.empty(); });
+        write_pending(lock);
+
+        auto const now = std::chrono::steady_clock::now();
+        if (now - last_drain >= kTraceFlushInterval)
+        {
+            lock.unlock();
+            drain_threads();
+            lock.lock();
+            last_drain = now;
+        }
+    }
+    write_pending(lock);
+    lock.unlock();
+    drain_threads();
+}
+
+void trace_writer::write_pending(std::unique_lock<std::mutex>& lock)
+{
+    while (!blocks_.empty())
+    {
+        std::deque<std::string> blocks;
+        blocks.swap(blocks_);
+        lock.unlock();
+
+        size_t bytes = 0;
+        for (const auto& block : blocks)
+        {
+            write_records(block);
+            bytes += block.size();
+        }
+
+        lock.lock();
+        pending_bytes_ -= bytes;
+        space_.notify_all();
+    }
+}
+
+void trace_writer::drain_threads()
+{
+    std::vector<std::string> partial;
+    per_thread<trace_thread_buffer>::ForEachThread(
+        [&partial](trace_thread_buffer& buffer)
+        {
+            const std::scoped_lock lock(buffer.mutex);
+            if (!buffer.bytes.empty())
+            {
+                partial.push_back(std::move(buffer.bytes));
+                buffer.bytes.clear();
+            }
+        });
+    for (const auto& records : partial)
+    {
+        write_records(records);
+    }
+}
+
+void trace_writer::write_records(const std::string& records)
+{
+    const char* p   = records.data();
+    const char* end = p + records.size();
+    while (p < end)
+    {
+        uint32_t size;
+        std::memcpy(&size, p, sizeof(size));
+        p += sizeof(size);
+
+        trace_record_reader reader(p, size);
+        uint64_t            ids[8];
+        for (auto& id : ids)
+        {
+            id = reader.get<uint64_t>();
+        }
+        std::string_view const name = reader.get_string();
+        std::array<std::string, kTraceNodeLists> lists;
+        for (auto& list : lists)
+        {
+            list = reader.get_list();
+        }
+        std::array<std::string, kTraceNodeStrings> strings;
+        for (auto& value : strings)
+        {
+            value = reader.get_string();
+        }
+        p += size;
+
+        writeJsonNode(
+            text_,
+            std::string(name),
+            ids[0],
+            ids[1],
+            ids[2],
+            ids[3],
+            static_cast<int64_t>(ids[4]),
+            ids[5],
+            ids[6],
+            ids[7],
+            lists[0],
+            lists[1],
+            lists[2],
+            lists[3],
+            lists[4],
+            lists[5],
+            lists[6],
+            lists[7],
+            strings[0],
+            strings[1],
+            strings[2],
+            strings[3],
+            strings[4]);
+        text_ += ',';
+        if (text_.size() >= kTraceWriteBytes)
+        {
+            flush_text();
+        }
+    }
+}
+
+void trace_writer::flush_text()
+{
+    if (compressor_)
+    {
+        compressor_->write(text_.data(), text_.size());
+    }
+    else
+    {
+        out_.write(text_.data(), static_cast<std::streamsize>(text_.size()));
+    }
+    text_.clear();
+}
+
+// Appends node to the buffer of the calling thread, handing it to the writer once full
+static void pushTraceNode(ExecutionTraceObserver& ob, const trace_node& node)
+{
+    auto&       buffer = per_thread<trace_thread_buffer>::Get();
+    std::string block;
+    {
+        const std::scoped_lock lock(buffer.mutex);
+        encodeTraceNode(buffer.bytes, node);
+        if (buffer.bytes.size() < kTraceBlockBytes)
+        {
+            return;
+        }
+        block.swap(buffer.bytes);
+    }
+    ob.writer->submit(std::move(block));
+}
+
 static std::string timeString(const std::time_t timepoint)
 {
     std::ostringstream oss;
@@ -464,9 +877,9 @@ static std::string timeString(const std::time_t timepoint)
 
 static bool initExecutionTraceStart(ExecutionTraceObserver& ob)
 {
-    ob.out = openOutputFile(ob.fileName);
+    std::ofstream out = openOutputFile(ob.fileName);
     // If somehow the output stream failed to open, finish observer here.
-    if (!ob.out)
+    if (!out)
     {
         //LOG(WARNING) << "Failed to open output file: " << ob.fileName;
         return false;
@@ -480,21 +893,26 @@ static bool initExecutionTraceStart(ExecutionTraceObserver& ob)
                                std::chrono::steady_clock::now().time_since_epoch())
                                .count();
 
-    ob.out << fmt::format(
+    ob.writer = std::make_unique<trace_writer>(std::move(out), ob.compress);
+    ob.writer->write(fmt::format(
         R"JSON({{
   "schema": "1.1.1-chakra.0.0.4", "pid": {}, "time": "{}", "start_ts": {},
   "nodes": [)JSON",
         ob.pid,
         ob.recordTime,
-        timestamp);
+        timestamp));
+    ob.writer->start();
     return true;
 }
 
 // Write out Execution Trace to file
 static void finalizeExecutionTraceOutput(ExecutionTraceObserver& ob)
 {
+    ob.writer->stop();
+
+    std::string text;
     writeJsonNode(
-        ob.out,
+        text,
         "[pytorch|profiler|execution_trace|process]",
         kRootId,
         0,        // rf_id
@@ -509,14 +927,17 @@ static void finalizeExecutionTraceOutput(ExecutionTraceObserver& ob)
     const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                                std::chrono::steady_clock::now().time_since_epoch())
                                .count();
-    ob.out << fmt::format(
+    fmt::format_to(
+        std::back_inserter(text),
         R"JSON(
   ],
   "finish_ts": {}
 }})JSON",
         timestamp);
 
-    ob.out.close();
+    ob.writer->write(text);
+    ob.writer->close();
+    ob.writer.reset();
 #if 0
     // Disabled: Logging macros not available in profiler-only build.
     VLOG(1) << "Quarisma Execution Trace: written to file " << ob.fileName;
@@ -858,6 +1279,7 @@ static void recordOperatorStart(
 
     try
     {
+        ExecutionTraceObserver::ID thread_node_id = kUninitializedId;
         {
             const std::scoped_lock lock(ob.gMutex);
 
@@ -865,22 +1287,21 @@ static void recordOperatorStart(
             // first
             if (ob.opStack[tid].empty())
             {
-                auto thread_node_id = ob.getNewID();
+                thread_node_id = ob.getNewID();
                 ob.opStack[tid].push(thread_node_id);
-                writeJsonNode(
-                    ob.out,
-                    "[pytorch|profiler|execution_trace|thread]",
-                    thread_node_id,
-                    0,  // rf_id
-                    kRootId,
-                    0,   // fw_parent
-                    -1,  // seq_id
-                    static_cast<std::underlying_type_t<RecordScope>>(RecordScope::USER_SCOPE),
-                    tid,
-                    0);  // fw_tid
-                ob.out << ",";
             }
         }
+        if (thread_node_id != kUninitializedId)
+        {
+            trace_node node;
+            node.id     = thread_node_id;
+            node.parent = kRootId;
+            node.scope =
+                static_cast<std::underlying_type_t<RecordScope>>(RecordScope::USER_SCOPE);
+            node.tid  = tid;
+            node.name = "[pytorch|profiler|execution_trace|thread]";
+            pushTraceNode(ob, node);
+        }
 
         // all input nodes should have id > opId
         fc.opId = ob.getNewID();
@@ -1063,33 +1484,31 @@ static void onFunctionExit(const RecordFunction& fn, ObserverContext* ctx_ptr)
 
                 // remove current op id from stack
                 ob->opStack[fn.threadId()].pop();
-
-                writeJsonNode(
-                    ob->out,
-                    fc.name,
-                    fc.opId,
-                    fn.handle(),
-                    fc.parentId,
-                    fc.fwParentId,
-                    fn.seqNr(),
-                    static_cast<std::underlying_type_t<RecordScope>>(fn.scope()),
-                    fn.threadId(),
-                    fn.forwardThreadId(),
-                    vectorToString(fc.inputValues),
-                    vectorToString(fc.inputShapes),
-                    vectorToString(fc.inputStrides),
-                    vectorToString(fc.inputTypes),
-                    vectorToString(output_values),
-                    vectorToString(output_shapes),
-                    vectorToString(output_strides),
-                    vectorToString(output_types),
-                    op_schema_str,
-                    fc.kernelBackend,
-                    fc.kernelFile,
-                    fc.get_string_for_tensor_range(),
-                    additiona_attrs);
-                ob->out << ",";
             }
+
+            const std::string tensor_range = fc.get_string_for_tensor_range();
+            trace_node        node;
+            node.id        = fc.opId;
+            node.rf_id     = fn.handle();
+            node.parent    = fc.parentId;
+            node.fw_parent = fc.fwParentId;
+            node.seq_id    = fn.seqNr();
+            node.scope     = static_cast<std::underlying_type_t<RecordScope>>(fn.scope());
+            node.tid       = fn.threadId();
+            node.fw_tid    = fn.forwardThreadId();
+            node.name      = fc.name;
+            node.lists     = {
+                &fc.inputValues,
+                &fc.inputShapes,
+                &fc.inputStrides,
+                &fc.inputTypes,
+                &output_values,
+                &output_shapes,
+                &output_strides,
+                &output_types};
+            node.strings = {
+                op_schema_str, fc.kernelBackend, fc.kernelFile, tensor_range, additiona_attrs};
+            pushTraceNode(*ob, node);
         }
         catch (const std::exception& e)
         {
@@ -1103,6 +1522,11 @@ static void onFunctionExit(const RecordFunction& fn, ObserverContext* ctx_ptr)
 // Add execution trace observer callback functions to the RecordFunction
 // global observers.
 bool addExecutionTraceObserver(const std::string& output_file_path)
+{
+    return addExecutionTraceObserver(output_file_path, false);
+}
+
+bool addExecutionTraceObserver(const std::string& output_file_path, bool compress)
 {
     // Check if the observer is already initialized.
     if (ObserverManager::get() == nullptr)
@@ -1112,6 +1536,7 @@ bool addExecutionTraceObserver(const std::string& output_file_path)
         ob.pid   = processId();
         // Set output
         ob.fileName = output_file_path;
+        ob.compress = compress;
         if (!initExecutionTraceStart(ob))
         {
             return false;
@@ -11,6 +11,10 @@ namespace quarisma::profiler::impl
 // will be written to output file path.
 QUARISMA_API bool addExecutionTraceObserver(const std::string& output_file_path);
 
+// As above; with compress set the file is a Snappy framed stream of the JSON,
+// readable by compression::framed_decompressor and by tools such as snzip.
+QUARISMA_API bool addExecutionTraceObserver(const std::string& output_file_path, bool compress);
+
 // Remove the execution trace observer from the global callback functions.
 QUARISMA_API void removeExecutionTraceObserver();
 
@@ -16,6 +16,20 @@ std::vector<void*> unwind()
     return {};
 }
 
+size_t unwind_from_context(
+    uint64_t /*rip*/,
+    uint64_t /*rsp*/,
+    uint64_t /*rbp*/,
+    void** /*frames*/,
+    size_t /*max_frames*/,
+    bool* incomplete)
+{
+    *incomplete = true;
+    return 0;
+}
+
+void prepare(const std::vector<void*>& /*addrs*/) {}
+
 std::optional<std::pair<std::string, uint64_t>> libraryFor(void* /*addr*/)
 {
     QUARISMA_LOG_WARNING("record_context_cpp is not support on non-linux non-x86_64 platforms");
@@ -51,10 +65,10 @@ Stats stats()
 #include <shared_mutex>
 #include <vector>
 
+#include "logging/symbol_cache.h"
 #include "profiler/common/unwind/communicate.h"
 #include "profiler/common/unwind/dwarf_enums.h"
 #include "profiler/common/unwind/eh_frame_hdr.h"
-#include "profiler/common/unwind/fast_symbolizer.h"
 #include "profiler/common/unwind/fde.h"
 #include "profiler/common/unwind/unwinder.h"
 #include "util/flat_hash.h"
@@ -232,6 +246,13 @@ struct UnwindCache
         return r.first->second;
     }
 
+    // Read-only lookup, safe in a signal handler under a shared lock
+    const Unwinder* cachedUnwinderFor(uint64_t addr) const
+    {
+        auto it = ip_cache_.find(addr);
+        return it == ip_cache_.end() ? nullptr : &it->second;
+    }
+
     const LibraryInfo* findLibraryFor(uint64_t addr)
     {
         Version current_version = currentVersion();
@@ -321,6 +342,57 @@ std::vector<void*> unwind()
     return frames;
 }
 
+size_t unwind_from_context(
+    uint64_t rip, uint64_t rsp, uint64_t rbp, void** frames, size_t max_frames, bool* incomplete)
+{
+    *incomplete = false;
+    std::shared_lock lock(cache_mutex_, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        *incomplete = true;
+        return 0;
+    }
+    UnwindState state{(int64_t)rip, (int64_t)rbp, (int64_t)rsp};
+    size_t      depth = 0;
+    while (depth < max_frames)
+    {
+        // NOLINTNEXTLINE(performance-no-int-to-ptr)
+        frames[depth++]    = (void*)state.rip;
+        const Unwinder* uw = unwind_cache.cachedUnwinderFor(state.rip);
+        if (!uw)
+        {
+            *incomplete = true;
+            break;
+        }
+        if (uw->terminator())
+        {
+            break;
+        }
+        UnwindState const next = uw->run(state);
+        // Caller frames live above their callees; anything else means the
+        // context was not at a point the unwind information describes
+        if (next.rsp <= state.rsp || next.rip == 0)
+        {
+            break;
+        }
+        state = next;
+    }
+    return depth;
+}
+
+void prepare(const std::vector<void*>& addrs)
+{
+    std::shared_lock lock(cache_mutex_);
+    unwind_cache.checkRefresh(lock);
+    for (void* addr : addrs)
+    {
+        if (addr)
+        {
+            unwind_cache.unwinderFor((uint64_t)addr, lock);
+        }
+    }
+}
+
 std::optional<std::pair<std::string, uint64_t>> libraryFor(void* addr)
 {
     if (!addr)
@@ -467,11 +539,35 @@ private:
     }
 };
 
-static std::vector<Frame> symbolize_fast(const std::vector<void*>& frames, Mode mode)
+// Resolved through the process-wide symbol_cache, which back_trace shares
+static std::vector<Frame> symbolize_fast(const std::vector<void*>& frames)
+{
+    std::vector<Frame> results;
+    results.reserve(frames.size());
+    for (auto& symbol : symbol_cache::instance().resolve(frames))
+    {
+        if (!symbol.file.empty())
+        {
+            results.emplace_back(
+                Frame{std::move(symbol.file), std::move(symbol.function), symbol.line});
+        }
+        else if (!symbol.library.empty())
+        {
+            results.emplace_back(
+                Frame{std::move(symbol.library), std::move(symbol.function), symbol.offset});
+        }
+        else
+        {
+            results.emplace_back(Frame{"??", std::move(symbol.function), 0});
+        }
+    }
+    return results;
+}
+
+static std::vector<Frame> symbolize_dladdr(const std::vector<void*>& frames)
 {
-    static std::mutex                                         cache_mutex;
-    static std::array<quarisma::flat_hash_map<void*, Frame>, 2> frame_maps;
-    auto& frame_map = frame_maps[mode == Mode::fast ? 0 : 1];
+    static std::mutex                           cache_mutex;
+    static quarisma::flat_hash_map<void*, Frame> frame_map;
 
     std::vector<uint32_t> indices_to_lookup;
     std::vector<Frame>    results;
@@ -495,8 +591,6 @@ static std::vector<Frame> symbolize_fast(const std::vector<void*>& frames, Mode
     }
     if (!indices_to_lookup.empty())
     {
-        // do symbolizer work
-        FastSymbolizer symbolizer;
         for (auto i : indices_to_lookup)
         {
             void*  addr    = frames.at(i);
@@ -504,14 +598,7 @@ static std::vector<Frame> symbolize_fast(const std::vector<void*>& frames, Mode
             auto   library = libraryFor(frames.at(i));
             if (library)
             {
-                if (mode == Mode::fast)
-                {
-                    f = symbolizer.symbolize(library->first, library->second - 1);
-                }
-                else
-                {
-                    f = Frame{library->first, "??", library->second - 1};
-                }
+                f = Frame{library->first, "??", library->second - 1};
             }
             if (f.funcname == "??")
             {
@@ -552,9 +639,13 @@ std::vector<Frame> symbolize(const std::vector<void*>& frames, Mode mode)
     {
         return symbolize_addr2line(frames);
     }
+    else if (mode == Mode::fast)
+    {
+        return symbolize_fast(frames);
+    }
     else
     {
-        return symbolize_fast(frames, mode);
+        return symbolize_dladdr(frames);
     }
 }
 #endif
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -12,6 +13,19 @@ namespace quarisma::unwind
 // gets faster once the cache of program counter locations is warm.
 QUARISMA_API std::vector<void*> unwind();
 
+// unwind() for sampling profilers: walks the stack of an interrupted context
+// from its registers, without locking or allocating, so that it can run in a
+// signal handler. Only unwind information cached by earlier calls to unwind()
+// or prepare() is used: the walk stops at the first address whose information
+// is not cached yet, stores it as the last frame and sets *incomplete. Pass
+// such addresses to prepare() so that later walks get past them.
+// Returns the number of frames stored, 0 if the cache is being updated.
+QUARISMA_API size_t unwind_from_context(
+    uint64_t rip, uint64_t rsp, uint64_t rbp, void** frames, size_t max_frames, bool* incomplete);
+
+// caches the unwind information of code addresses for unwind_from_context().
+QUARISMA_API void prepare(const std::vector<void*>& addrs);
+
 struct Frame
 {
     std::string filename;
@@ -27,8 +27,18 @@ namespace
 __itt_domain* g_itt_domain = nullptr;
 std::mutex    g_itt_init_mutex;
 
-// Thread-local string handles cache
-thread_local std::unordered_map<std::string, __itt_string_handle*> g_string_handles;
+// Handles of the names passed on this thread; names are persistent, so their address is the key
+thread_local std::unordered_map<const char*, __itt_string_handle*> g_string_handles;
+
+__itt_string_handle* string_handle(const char* name)
+{
+    auto it = g_string_handles.find(name);
+    if (it == g_string_handles.end())
+    {
+        it = g_string_handles.emplace(name, __itt_string_handle_create(name)).first;
+    }
+    return it->second;
+}
 }  // namespace
 
 void itt_init()
@@ -50,7 +60,7 @@ void itt_range_push(const char* name)
 
     if (g_itt_domain != nullptr && name != nullptr)
     {
-        __itt_string_handle* handle = __itt_string_handle_create(name);
+        __itt_string_handle* handle = string_handle(name);
         __itt_task_begin(g_itt_domain, __itt_null, __itt_null, handle);
     }
 }
@@ -72,7 +82,7 @@ void itt_mark(const char* name)
 
     if (g_itt_domain != nullptr && name != nullptr)
     {
-        __itt_string_handle* handle = __itt_string_handle_create(name);
+        __itt_string_handle* handle = string_handle(name);
         __itt_task_begin(g_itt_domain, __itt_null, __itt_null, handle);
         __itt_task_end(g_itt_domain);
     }
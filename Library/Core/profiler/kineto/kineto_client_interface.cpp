@@ -54,13 +54,23 @@ public:
 
     void start() override
     {
+        // Long on-demand traces can flush completed activity buffers while
+        // they run instead of converting everything when they stop.
+        int64_t flush_interval_ms = 0;
+        quarisma::utils::read_env_int64(
+            "QUARISMA_PROFILER_FLUSH_INTERVAL_MS", 0, &flush_interval_ms);
+
+        ExperimentalConfig experimental_config;
+        experimental_config.flush_interval_ms = flush_interval_ms;
+
         ProfilerConfig const cfg{
             ProfilerState::KINETO_ONDEMAND,
             /*report_input_shapes=*/reportInputShapes_,
             /*profile_memory=*/profileMemory_,
             /*with_stack=*/withStack_,
             /*with_flops=*/withFlops_,
-            /*with_modules=*/withModules_};
+            /*with_modules=*/withModules_,
+            /*experimental_config=*/std::move(experimental_config)};
         std::set<ActivityType> const            activities{ActivityType::CPU};
         std::unordered_set<quarisma::RecordScope> scopes;
         scopes.insert(quarisma::RecordScope::FUNCTION);
@@ -1,3 +1,5 @@
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <utility>
@@ -420,6 +422,12 @@ struct KinetoThreadLocalState : public ProfilerStateBase
           startTime(getTimeNs()),
           recordQueue(config, std::move(activities))
     {
+        if (config.experimental_config.flush_interval_ms > 0)
+        {
+            recordQueue.startFlush(
+                std::chrono::milliseconds(config.experimental_config.flush_interval_ms),
+                [this] { return clockConverter.makeConverter(); });
+        }
     }
     ~KinetoThreadLocalState() override = default;
 
@@ -521,9 +529,14 @@ struct KinetoThreadLocalState : public ProfilerStateBase
 
     void materializeOpEvents(std::vector<std::shared_ptr<Result>>& events)
     {
+        // On-demand (global) traces are only consumed by Kineto, so every event
+        // is released once its activity metadata is written instead of being
+        // kept for a ProfilerResult that is never returned.
+        const bool keep_events = !config_.global();
         for (auto& e : events)
         {
-            if (e->parent_.expired() && e->deviceType() == quarisma::device_enum::CPU)
+            if (keep_events && e->parent_.expired() &&
+                e->deviceType() == quarisma::device_enum::CPU)
             {
                 eventTree.push_back(e);
             }
@@ -536,13 +549,26 @@ struct KinetoThreadLocalState : public ProfilerStateBase
                         [this](ExtraFields<EventType::Backend>& i) { invokeCallback(i); },
                         [](auto&) {}));
 
-                kinetoEvents.emplace_back(e, config_.experimental_config.verbose);
-                AddTensorboardFields const add_tb(e, kinetoEvents.back());
-                AddGenericMetadata const   add_generic(e, &config_);
+                if (keep_events)
+                {
+                    kinetoEvents.emplace_back(e, config_.experimental_config.verbose);
+                    AddTensorboardFields const add_tb(e, kinetoEvents.back());
+                }
+                else
+                {
+                    KinetoEvent                event(e, config_.experimental_config.verbose);
+                    AddTensorboardFields const add_tb(e, event);
+                }
+                AddGenericMetadata const add_generic(e, &config_);
 
                 // It is not safe to use the activity after post processing.
                 e->kineto_activity_ = nullptr;
             }
+
+            if (!keep_events)
+            {
+                e.reset();
+            }
         }
     }
 
@@ -1285,6 +1311,65 @@ void ProfilerResult::save(const std::string& path)
     trace_->save(path);
 }
 
+quarisma::profiler::impl::ExperimentalConfig kernelMetricsConfig()
+{
+    std::vector<std::string> metrics;
+    for (size_t m = 0; m < quarisma::kernel_metric_count; ++m)
+    {
+        metrics.emplace_back(
+            quarisma::cupti_metric_name(static_cast<quarisma::kernel_metric>(m)));
+    }
+    quarisma::profiler::impl::ExperimentalConfig config(
+        std::move(metrics), /*profiler_measure_per_kernel=*/true);
+    // The metric values come back in the metadata of the range events
+    config.expose_kineto_event_metadata = true;
+    return config;
+}
+
+std::vector<quarisma::kernel_metric_sample> kernelMetrics(const ProfilerResult& result)
+{
+    std::vector<quarisma::kernel_metric_sample> samples;
+#if QUARISMA_HAS_KINETO
+    for (const auto& event : result.events())
+    {
+        if (event.activityType() !=
+            static_cast<uint8_t>(libkineto::ActivityType::CUDA_PROFILER_RANGE))
+        {
+            continue;
+        }
+
+        quarisma::kernel_metric_sample sample;
+        sample.kernel      = event.name();
+        sample.device      = event.deviceIndex();
+        sample.start_ns    = static_cast<int64_t>(event.startNs());
+        sample.duration_ns = static_cast<int64_t>(event.durationNs());
+
+        // The metadata holds one "<metric name>": <value> member per metric
+        std::string const metadata = event.metadataJson();
+        for (size_t m = 0; m < quarisma::kernel_metric_count; ++m)
+        {
+            auto const  metric = static_cast<quarisma::kernel_metric>(m);
+            std::string key    = "\"";
+            key.append(quarisma::cupti_metric_name(metric)).append("\"");
+            size_t const position = metadata.find(key);
+            if (position == std::string::npos)
+            {
+                continue;
+            }
+            size_t const colon = metadata.find(':', position + key.size());
+            if (colon != std::string::npos)
+            {
+                sample.values[m] = std::strtod(metadata.c_str() + colon + 1, nullptr);
+            }
+        }
+        samples.push_back(std::move(sample));
+    }
+#else
+    (void)result;
+#endif  // QUARISMA_HAS_KINETO
+    return samples;
+}
+
 }  // namespace autograd::profiler
 
 namespace profiler::impl
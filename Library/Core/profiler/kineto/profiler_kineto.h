@@ -8,6 +8,7 @@
 #include "profiler/common/api.h"
 #include "profiler/common/events.h"
 #include "profiler/common/util.h"
+#include "profiler/native/analysis/kernel_metrics.h"
 
 namespace quarisma
 {
@@ -187,6 +188,19 @@ QUARISMA_API void prepareProfiler(
     const quarisma::profiler::impl::ProfilerConfig&         config,
     const std::set<quarisma::profiler::impl::ActivityType>& activities);
 
+/*
+ * Opt-in per-kernel GPU hardware metrics (achieved occupancy, DRAM
+ * throughput, SM efficiency, L2 hit rate; see kernel_metric). Profiling with
+ * kernelMetricsConfig() as the experimental config runs the CUPTI range
+ * profiler over each kernel, which replays it for every pass the metrics
+ * need: expect the kernels, not the host code, to slow down several times.
+ * kernelMetrics() reads the measured ranges from the result, and
+ * add_kernel_metrics() attaches them to the GPU planes of an x_space.
+ */
+QUARISMA_API quarisma::profiler::impl::ExperimentalConfig kernelMetricsConfig();
+QUARISMA_API std::vector<quarisma::kernel_metric_sample> kernelMetrics(
+    const ProfilerResult& result);
+
 QUARISMA_API void toggleCollectionDynamic(
     const bool enable, const std::set<quarisma::profiler::impl::ActivityType>& activities);
 
@@ -0,0 +1,618 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "critical_path.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <iterator>
+#include <set>
+#include <tuple>
+#include <utility>
+
+#include "profiler/native/exporters/xplane/tf_xplane_visitor.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+#include "profiler/native/exporters/xplane/xplane_visitor.h"
+
+namespace quarisma
+{
+namespace
+{
+constexpr size_t no_task = (std::numeric_limits<size_t>::max)();
+
+// Context type and id shared by the two ends of a flow
+using flow_key = std::pair<int64_t, uint64_t>;
+
+struct event_ref
+{
+    int64_t               start_ns = 0;
+    int64_t               end_ns   = 0;
+    std::string_view      name;
+    std::vector<flow_key> produces;
+    std::vector<flow_key> consumes;
+};
+
+// Stretch of a line covered by one innermost event
+struct piece
+{
+    int64_t          start_ns;
+    int64_t          end_ns;
+    std::string_view name;
+};
+
+struct line_events
+{
+    std::string_view       name;
+    int64_t                id = 0;
+    std::vector<event_ref> events;  // by start, enclosing events first
+    std::vector<piece>     pieces;  // by start, without gaps between events
+};
+
+struct event_position
+{
+    size_t line;
+    size_t event;
+
+    bool operator<(const event_position& other) const
+    {
+        return std::tie(line, event) < std::tie(other.line, other.event);
+    }
+};
+
+// An event of the request, the root or one run on behalf of another one
+struct task
+{
+    size_t           line;
+    int64_t          start_ns;
+    int64_t          end_ns;
+    std::string_view name;
+    size_t           parent       = no_task;
+    int64_t          producer_end = 0;
+};
+
+struct trace_index
+{
+    std::vector<line_events>                        lines;
+    std::map<flow_key, std::vector<event_position>> consumers;
+};
+
+void read_flows(const xevent_visitor& event, event_ref& ref)
+{
+    std::optional<int64_t>  producer_type;
+    std::optional<uint64_t> producer_id;
+    std::optional<int64_t>  consumer_type;
+    std::optional<uint64_t> consumer_id;
+    event.for_each_stat(
+        [&](const x_stat_visitor& stat)
+        {
+            if (!stat.type())
+            {
+                return;
+            }
+            switch (static_cast<StatType>(*stat.type()))
+            {
+            case StatType::kProducerType:
+                producer_type = static_cast<int64_t>(stat.int_or_uint_value());
+                break;
+            case StatType::kProducerId:
+                producer_id = stat.int_or_uint_value();
+                break;
+            case StatType::kConsumerType:
+                consumer_type = static_cast<int64_t>(stat.int_or_uint_value());
+                break;
+            case StatType::kConsumerId:
+                consumer_id = stat.int_or_uint_value();
+                break;
+            case StatType::kFlow:
+            {
+                XFlow const flow = XFlow::FromStatValue(stat.int_or_uint_value());
+                flow_key const key(static_cast<int64_t>(flow.Category()), flow.Id());
+                if ((flow.Direction() & XFlow::kFlowOut) != 0)
+                {
+                    ref.produces.push_back(key);
+                }
+                if ((flow.Direction() & XFlow::kFlowIn) != 0)
+                {
+                    ref.consumes.push_back(key);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        });
+    if (producer_type && producer_id)
+    {
+        ref.produces.emplace_back(*producer_type, *producer_id);
+    }
+    if (consumer_type && consumer_id)
+    {
+        ref.consumes.emplace_back(*consumer_type, *consumer_id);
+    }
+}
+
+// Innermost event at every point of the line, nested events cut out of their parents
+void flatten(line_events& line)
+{
+    std::vector<const event_ref*> open;
+    int64_t                       cursor = 0;
+    auto emit = [&](int64_t end_ns, std::string_view name)
+    {
+        if (end_ns > cursor)
+        {
+            line.pieces.push_back({cursor, end_ns, name});
+        }
+        cursor = (std::max)(cursor, end_ns);
+    };
+
+    for (const event_ref& event : line.events)
+    {
+        while (!open.empty() && open.back()->end_ns <= event.start_ns)
+        {
+            emit(open.back()->end_ns, open.back()->name);
+            open.pop_back();
+        }
+        if (!open.empty())
+        {
+            emit(event.start_ns, open.back()->name);
+        }
+        cursor = (std::max)(cursor, event.start_ns);
+        open.push_back(&event);
+    }
+    while (!open.empty())
+    {
+        emit(open.back()->end_ns, open.back()->name);
+        open.pop_back();
+    }
+}
+
+trace_index index_space(const x_space& space)
+{
+    trace_index index;
+    for (const xplane& plane : space.planes())
+    {
+        xplane_visitor const visitor = CreateTfXPlaneVisitor(&plane);
+        visitor.for_each_line(
+            [&](const xline_visitor& line)
+            {
+                line_events& events = index.lines.emplace_back();
+                events.name         = line.display_name();
+                events.id           = line.id();
+                line.for_each_event(
+                    [&](const xevent_visitor& event)
+                    {
+                        if (event.is_aggregated_event())
+                        {
+                            return;
+                        }
+                        event_ref& ref = events.events.emplace_back();
+                        ref.start_ns   = event.timestamp_ns();
+                        ref.end_ns     = event.end_timestamp_ns();
+                        ref.name       = event.name();
+                        read_flows(event, ref);
+                    });
+            });
+    }
+
+    for (size_t l = 0; l < index.lines.size(); ++l)
+    {
+        line_events& line = index.lines[l];
+        std::sort(
+            line.events.begin(),
+            line.events.end(),
+            [](const event_ref& a, const event_ref& b)
+            { return a.start_ns != b.start_ns ? a.start_ns < b.start_ns : a.end_ns > b.end_ns; });
+        flatten(line);
+        for (size_t e = 0; e < line.events.size(); ++e)
+        {
+            for (const flow_key& key : line.events[e].consumes)
+            {
+                index.consumers[key].push_back({l, e});
+            }
+        }
+    }
+    return index;
+}
+
+// The root and, transitively, every task consuming a flow produced within one
+std::vector<task> collect_tasks(const trace_index& index, const event_position& root)
+{
+    const event_ref&  root_event = index.lines[root.line].events[root.event];
+    std::vector<task> tasks{{root.line, root_event.start_ns, root_event.end_ns, root_event.name}};
+    std::set<event_position> visited{root};
+
+    for (size_t t = 0; t < tasks.size(); ++t)
+    {
+        task const  current = tasks[t];
+        const auto& events  = index.lines[current.line].events;
+        auto        it      = std::lower_bound(
+            events.begin(),
+            events.end(),
+            current.start_ns,
+            [](const event_ref& event, int64_t start_ns) { return event.start_ns < start_ns; });
+        for (; it != events.end() && it->start_ns < current.end_ns; ++it)
+        {
+            for (const flow_key& key : it->produces)
+            {
+                auto const found = index.consumers.find(key);
+                if (found == index.consumers.end())
+                {
+                    continue;
+                }
+                for (const event_position& position : found->second)
+                {
+                    if (!visited.insert(position).second)
+                    {
+                        continue;
+                    }
+                    const event_ref& consumer = index.lines[position.line].events[position.event];
+                    tasks.push_back(
+                        {position.line,
+                         consumer.start_ns,
+                         consumer.end_ns,
+                         consumer.name,
+                         t,
+                         it->end_ns});
+                }
+            }
+        }
+    }
+    return tasks;
+}
+
+bool descends_from(const std::vector<task>& tasks, size_t t, size_t ancestor)
+{
+    for (t = tasks[t].parent; t != no_task; t = tasks[t].parent)
+    {
+        if (t == ancestor)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Walks back from the end of tasks[0]; segments come out latest first
+class path_walker
+{
+public:
+    path_walker(
+        const trace_index&           index,
+        const std::vector<task>&     tasks,
+        const critical_path_options& options,
+        critical_path&               path)
+        : index_(index), tasks_(tasks), options_(options), path_(path)
+    {
+    }
+
+    void walk()
+    {
+        size_t  current = 0;
+        int64_t t       = tasks_[0].end_ns;
+        for (;;)
+        {
+            const task& running = tasks_[current];
+            if (t <= running.start_ns)
+            {
+                if (running.parent == no_task)
+                {
+                    break;
+                }
+                int64_t const resume = std::clamp(
+                    running.producer_end, tasks_[running.parent].start_ns, running.start_ns);
+                emit(
+                    running.line,
+                    resume,
+                    running.start_ns,
+                    critical_path_category::queue_wait,
+                    running.name);
+                t       = resume;
+                current = running.parent;
+                continue;
+            }
+
+            auto [start_ns, category, name] = locate(running, t);
+            if (category != critical_path_category::compute)
+            {
+                size_t const released = last_finished(current, start_ns, t);
+                if (released != no_task)
+                {
+                    emit(running.line, tasks_[released].end_ns, t, category, name);
+                    t       = tasks_[released].end_ns;
+                    current = released;
+                    continue;
+                }
+            }
+            emit(running.line, start_ns, t, category, name);
+            t = start_ns;
+        }
+    }
+
+private:
+    struct located
+    {
+        int64_t                start_ns;
+        critical_path_category category;
+        std::string_view       name;
+    };
+
+    // The innermost event of the running task's line just before t
+    located locate(const task& running, int64_t t) const
+    {
+        const auto& pieces = index_.lines[running.line].pieces;
+        auto const  it     = std::partition_point(
+            pieces.begin(), pieces.end(), [t](const piece& p) { return p.start_ns < t; });
+        if (it != pieces.begin() && std::prev(it)->end_ns >= t)
+        {
+            const piece& p = *std::prev(it);
+            return {(std::max)(p.start_ns, running.start_ns), options_.classify(p.name), p.name};
+        }
+        // Cut short by a malformed nested event; the task's own event covers the rest
+        int64_t const gap_start = it != pieces.begin() ? std::prev(it)->end_ns : running.start_ns;
+        return {
+            (std::max)(gap_start, running.start_ns), options_.classify(running.name), running.name};
+    }
+
+    // The task handed off by `current` that finished last within (after, before]
+    size_t last_finished(size_t current, int64_t after, int64_t before) const
+    {
+        size_t best = no_task;
+        for (size_t t = 1; t < tasks_.size(); ++t)
+        {
+            const task& candidate = tasks_[t];
+            if (candidate.end_ns <= after || candidate.end_ns > before ||
+                candidate.end_ns <= candidate.start_ns || !descends_from(tasks_, t, current))
+            {
+                continue;
+            }
+            if (best == no_task || candidate.end_ns > tasks_[best].end_ns)
+            {
+                best = t;
+            }
+        }
+        return best;
+    }
+
+    void emit(
+        size_t                 line,
+        int64_t                start_ns,
+        int64_t                end_ns,
+        critical_path_category category,
+        std::string_view       name)
+    {
+        if (end_ns <= start_ns)
+        {
+            return;
+        }
+        auto& segments = path_.segments;
+        if (!segments.empty() && segments.back().start_ns == end_ns &&
+            segments.back().category == category && segments.back().event == name &&
+            segments.back().line_id == index_.lines[line].id)
+        {
+            segments.back().start_ns = start_ns;
+            return;
+        }
+        critical_path_segment& segment = segments.emplace_back();
+        segment.start_ns               = start_ns;
+        segment.end_ns                 = end_ns;
+        segment.category               = category;
+        segment.event                  = std::string(name);
+        segment.line                   = std::string(index_.lines[line].name);
+        segment.line_id                = index_.lines[line].id;
+    }
+
+    const trace_index&           index_;
+    const std::vector<task>&     tasks_;
+    const critical_path_options& options_;
+    critical_path&               path_;
+};
+
+void summarize(critical_path& path, size_t max_spans)
+{
+    std::reverse(path.segments.begin(), path.segments.end());
+
+    std::map<std::pair<std::string_view, critical_path_category>, critical_path_span> spans;
+    for (const auto& segment : path.segments)
+    {
+        path.category_ns[static_cast<size_t>(segment.category)] += segment.duration_ns();
+
+        auto& span = spans[{segment.event, segment.category}];
+        span.category = segment.category;
+        span.critical_ns += segment.duration_ns();
+        ++span.segments;
+    }
+
+    path.spans.reserve(spans.size());
+    for (auto& [key, span] : spans)
+    {
+        span.event = std::string(key.first);
+        path.spans.push_back(std::move(span));
+    }
+    std::stable_sort(
+        path.spans.begin(),
+        path.spans.end(),
+        [](const critical_path_span& a, const critical_path_span& b)
+        { return a.critical_ns > b.critical_ns; });
+    if (path.spans.size() > max_spans)
+    {
+        path.spans.resize(max_spans);
+    }
+}
+
+std::vector<event_position> find_roots(const trace_index& index, const std::string& root_event)
+{
+    std::vector<event_position> roots;
+    for (size_t l = 0; l < index.lines.size(); ++l)
+    {
+        const auto& events = index.lines[l].events;
+        for (size_t e = 0; e < events.size(); ++e)
+        {
+            if (root_event.empty())
+            {
+                auto const longest = [&](const event_position& p)
+                {
+                    const event_ref& event = index.lines[p.line].events[p.event];
+                    return event.end_ns - event.start_ns;
+                };
+                if (roots.empty() || events[e].end_ns - events[e].start_ns > longest(roots[0]))
+                {
+                    roots.assign(1, {l, e});
+                }
+            }
+            else if (events[e].name == root_event)
+            {
+                roots.push_back({l, e});
+            }
+        }
+    }
+    std::stable_sort(
+        roots.begin(),
+        roots.end(),
+        [&](const event_position& a, const event_position& b)
+        {
+            return index.lines[a.line].events[a.event].start_ns <
+                   index.lines[b.line].events[b.event].start_ns;
+        });
+    return roots;
+}
+
+// Splits "ReadFile", "mutex::lock" or "io_wait" into lowercase words
+template <typename F>
+void for_each_word(std::string_view name, F&& f)
+{
+    std::string word;
+    auto const  flush = [&]
+    {
+        if (!word.empty())
+        {
+            f(word);
+            word.clear();
+        }
+    };
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        auto const c = static_cast<unsigned char>(name[i]);
+        if (std::isalnum(c) == 0)
+        {
+            flush();
+            continue;
+        }
+        if (std::isupper(c) != 0 && i > 0 &&
+            std::islower(static_cast<unsigned char>(name[i - 1])) != 0)
+        {
+            flush();
+        }
+        word.push_back(static_cast<char>(std::tolower(c)));
+    }
+    flush();
+}
+}  // namespace
+
+std::string_view to_string(critical_path_category category)
+{
+    switch (category)
+    {
+    case critical_path_category::compute:
+        return "compute";
+    case critical_path_category::queue_wait:
+        return "queue_wait";
+    case critical_path_category::lock_wait:
+        return "lock_wait";
+    case critical_path_category::io:
+        return "io";
+    }
+    return "unknown";
+}
+
+critical_path_category classify_event_name(std::string_view name)
+{
+    // Sorted, for binary_search
+    static constexpr std::string_view lock_words[] = {
+        "acquire",
+        "barrier",
+        "condvar",
+        "futex",
+        "join",
+        "lock",
+        "locked",
+        "mutex",
+        "semaphore",
+        "wait",
+        "waiting"};
+    static constexpr std::string_view io_words[] = {
+        "disk",
+        "file",
+        "flush",
+        "fsync",
+        "io",
+        "pread",
+        "pwrite",
+        "read",
+        "recv",
+        "send",
+        "socket",
+        "write"};
+    auto const contains = [](const auto& words, const std::string& word)
+    { return std::binary_search(std::begin(words), std::end(words), std::string_view(word)); };
+
+    bool lock = false;
+    bool io   = false;
+    for_each_word(
+        name,
+        [&](const std::string& word)
+        {
+            lock = lock || contains(lock_words, word);
+            io   = io || contains(io_words, word);
+        });
+    // Waiting on I/O, as in "io_wait", counts as I/O
+    if (io)
+    {
+        return critical_path_category::io;
+    }
+    return lock ? critical_path_category::lock_wait : critical_path_category::compute;
+}
+
+std::vector<critical_path> analyze_critical_paths(
+    const x_space& space, const critical_path_options& options)
+{
+    trace_index const          index = index_space(space);
+    std::vector<critical_path> paths;
+    for (const event_position& root : find_roots(index, options.root_event))
+    {
+        std::vector<task> const tasks = collect_tasks(index, root);
+
+        critical_path& path = paths.emplace_back();
+        path.root           = std::string(tasks[0].name);
+        path.start_ns       = tasks[0].start_ns;
+        path.end_ns         = tasks[0].end_ns;
+        path_walker(index, tasks, options, path).walk();
+        summarize(path, options.max_spans);
+    }
+    return paths;
+}
+
+critical_path analyze_critical_path(const x_space& space, const critical_path_options& options)
+{
+    std::vector<critical_path> paths = analyze_critical_paths(space, options);
+    return paths.empty() ? critical_path() : std::move(paths.front());
+}
+
+}  // namespace quarisma
@@ -0,0 +1,152 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/export.h"
+#include "profiler/native/exporters/xplane/xplane.h"
+
+namespace quarisma
+{
+
+/// Where the wall time of a critical path goes
+enum class critical_path_category : uint8_t
+{
+    compute,     ///< Running an event that does work
+    queue_wait,  ///< Between a producer and the start of its consumer
+    lock_wait,   ///< Blocked in a lock, condition or join event
+    io,          ///< In a read, write or other I/O event
+};
+
+inline constexpr size_t critical_path_category_count = 4;
+
+QUARISMA_API std::string_view to_string(critical_path_category category);
+
+/**
+ * @brief Category of an event from the words of its name
+ *
+ * Names are split at punctuation and case changes, so "ReadFile" and
+ * "mutex::lock" are both recognized: lock, mutex, wait, join, barrier and
+ * futex words make a lock wait; read, write, send, recv, fsync, file, disk,
+ * socket and io make I/O. Anything else is compute.
+ */
+QUARISMA_API critical_path_category classify_event_name(std::string_view name);
+
+struct critical_path_options
+{
+    /// Top-level event of a request; empty for the longest event of the space
+    std::string root_event;
+
+    /// Spans kept in critical_path::spans, longest first
+    size_t max_spans = 10;
+
+    /// Category of the innermost event at a point of the path
+    std::function<critical_path_category(std::string_view)> classify = classify_event_name;
+};
+
+/// A stretch of the path on one thread, covered by one event
+struct critical_path_segment
+{
+    int64_t                start_ns = 0;
+    int64_t                end_ns   = 0;
+    critical_path_category category = critical_path_category::compute;
+    std::string            event;  ///< Innermost event, or the consumer for queue_wait
+    std::string            line;
+    int64_t                line_id = 0;
+
+    int64_t duration_ns() const { return end_ns - start_ns; }
+};
+
+/// Critical time of all segments of one event name and category
+struct critical_path_span
+{
+    std::string            event;
+    critical_path_category category    = critical_path_category::compute;
+    int64_t                critical_ns = 0;
+    size_t                 segments    = 0;
+};
+
+struct critical_path
+{
+    std::string root;
+    int64_t     start_ns = 0;
+    int64_t     end_ns   = 0;
+
+    /// Chronological; the segments tile [start_ns, end_ns]
+    std::vector<critical_path_segment> segments;
+
+    /// Nanoseconds of the path by category, indexed by critical_path_category
+    std::array<int64_t, critical_path_category_count> category_ns{};
+
+    /// The spans that bound the latency, longest first
+    std::vector<critical_path_span> spans;
+
+    int64_t duration_ns() const { return end_ns - start_ns; }
+
+    int64_t time_in(critical_path_category category) const
+    {
+        return category_ns[static_cast<size_t>(category)];
+    }
+};
+
+/**
+ * @brief Critical path of each request in a collected x_space
+ *
+ * A request is an occurrence of options.root_event. Work it hands to other
+ * threads is found through flow links: the producer and consumer stats of
+ * traceme (_p and _pt on the scheduling event, _c and _ct on the running
+ * one, as the thread-pool listener records them) and XFlow stats, followed
+ * transitively.
+ *
+ * The path is walked back from the end of the request. Compute time stays
+ * on its thread. Waiting time jumps to the handed-off task that
+ * finished last within it, as the one that released the wait; the rest of
+ * the wait is kept as it is. Reaching the start of a task jumps back to its
+ * producer, and the time between the producer's end and the task's start is
+ * queue wait. Every nanosecond of the request is attributed once.
+ *
+ * Example:
+ * @code
+ * critical_path_options options;
+ * options.root_event = "handle_request";
+ * for (const auto& path : analyze_critical_paths(session->collected_xspace(), options))
+ * {
+ *     std::cout << path.root << " queued "
+ *               << path.time_in(critical_path_category::queue_wait) << " ns of "
+ *               << path.duration_ns() << " ns\n";
+ * }
+ * @endcode
+ */
+QUARISMA_API std::vector<critical_path> analyze_critical_paths(
+    const x_space& space, const critical_path_options& options = critical_path_options());
+
+/// Critical path of the first request, or an empty path when there is none
+QUARISMA_API critical_path analyze_critical_path(
+    const x_space& space, const critical_path_options& options = critical_path_options());
+
+}  // namespace quarisma
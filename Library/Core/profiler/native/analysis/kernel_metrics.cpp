@@ -0,0 +1,214 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "kernel_metrics.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "profiler/native/exporters/xplane/tf_xplane_visitor.h"
+#include "profiler/native/exporters/xplane/xplane_builder.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+#include "profiler/native/exporters/xplane/xplane_visitor.h"
+
+namespace quarisma
+{
+namespace
+{
+// Above the ids of the GPU streams, which name the other lines of the plane
+constexpr int64_t kKernelMetricsLineId = int64_t{1} << 40;
+
+struct metric_info
+{
+    std::string_view label;
+    std::string_view cupti_name;
+    StatType         stat;
+};
+
+constexpr std::array<metric_info, kernel_metric_count> kMetrics{{
+    {"achieved occupancy",
+     "sm__warps_active.avg.pct_of_peak_sustained_active",
+     StatType::kAchievedOccupancyPct},
+    {"DRAM throughput",
+     "dram__throughput.avg.pct_of_peak_sustained_elapsed",
+     StatType::kDramThroughputPct},
+    {"SM efficiency",
+     "sm__cycles_active.avg.pct_of_peak_sustained_elapsed",
+     StatType::kSmEfficiencyPct},
+    {"L2 hit rate", "lts__t_sector_hit_rate.pct", StatType::kL2HitRatePct},
+}};
+
+const metric_info& info(kernel_metric metric)
+{
+    return kMetrics[static_cast<size_t>(metric)];
+}
+
+struct kernel_totals
+{
+    uint64_t                                 launches = 0;
+    int64_t                                  total_ns = 0;
+    std::array<double, kernel_metric_count>  weighted{};
+    std::array<int64_t, kernel_metric_count> measured_ns{};
+};
+}  // namespace
+
+std::string_view to_string(kernel_metric metric)
+{
+    return info(metric).label;
+}
+
+std::string_view cupti_metric_name(kernel_metric metric)
+{
+    return info(metric).cupti_name;
+}
+
+StatType stat_type(kernel_metric metric)
+{
+    return info(metric).stat;
+}
+
+void add_kernel_metrics(x_space* space, const std::vector<kernel_metric_sample>& samples)
+{
+    if (space == nullptr || samples.empty())
+    {
+        return;
+    }
+
+    std::map<int32_t, std::vector<const kernel_metric_sample*>> by_device;
+    for (const auto& sample : samples)
+    {
+        by_device[sample.device].push_back(&sample);
+    }
+
+    for (auto& [device, launches] : by_device)
+    {
+        std::stable_sort(
+            launches.begin(),
+            launches.end(),
+            [](const kernel_metric_sample* lhs, const kernel_metric_sample* rhs)
+            { return lhs->start_ns < rhs->start_ns; });
+
+        xplane_builder builder(find_or_add_mutable_plane_with_name(space, GpuPlaneName(device)));
+        std::array<const x_stat_metadata*, kernel_metric_count> stats{};
+        for (size_t m = 0; m < kernel_metric_count; ++m)
+        {
+            stats[m] = builder.get_or_create_stat_metadata(GetStatTypeStr(kMetrics[m].stat));
+        }
+
+        xline_builder line = builder.get_or_create_line(kKernelMetricsLineId);
+        line.SetNameIfEmpty(kKernelMetricsLineName);
+        if (line.NumEvents() == 0)
+        {
+            line.SetTimestampNs(launches.front()->start_ns);
+        }
+        for (const auto* launch : launches)
+        {
+            xevent_builder event =
+                line.add_event(*builder.get_or_create_event_metadata(launch->kernel));
+            event.SetTimestampNs(launch->start_ns);
+            event.SetDurationNs(launch->duration_ns);
+            for (size_t m = 0; m < kernel_metric_count; ++m)
+            {
+                if (!std::isnan(launch->values[m]))
+                {
+                    event.add_stat_value(*stats[m], launch->values[m]);
+                }
+            }
+        }
+    }
+}
+
+std::vector<kernel_metric_summary> summarize_kernel_metrics(const x_space& space)
+{
+    std::map<std::string, kernel_totals> kernels;
+    for (const xplane* plane : find_planes_with_prefix(space, kGpuPlanePrefix))
+    {
+        xplane_visitor const visitor = CreateTfXPlaneVisitor(plane);
+        visitor.for_each_line(
+            [&](const xline_visitor& line)
+            {
+                line.for_each_event(
+                    [&](const xevent_visitor& event)
+                    {
+                        std::array<double, kernel_metric_count> values{};
+                        std::array<bool, kernel_metric_count>   found{};
+                        event.for_each_stat(
+                            [&](const x_stat_visitor& stat)
+                            {
+                                if (!stat.type())
+                                {
+                                    return;
+                                }
+                                for (size_t m = 0; m < kernel_metric_count; ++m)
+                                {
+                                    if (*stat.type() == kMetrics[m].stat)
+                                    {
+                                        values[m] = stat.double_value();
+                                        found[m]  = true;
+                                    }
+                                }
+                            });
+                        if (std::none_of(found.begin(), found.end(), [](bool f) { return f; }))
+                        {
+                            return;
+                        }
+
+                        kernel_totals& totals = kernels[std::string(event.name())];
+                        int64_t const  ns     = static_cast<int64_t>(event.duration_ns());
+                        ++totals.launches;
+                        totals.total_ns += ns;
+                        for (size_t m = 0; m < kernel_metric_count; ++m)
+                        {
+                            if (found[m])
+                            {
+                                // A zero-length launch still counts, with a weight of 1 ns
+                                int64_t const weight = std::max<int64_t>(ns, 1);
+                                totals.weighted[m] += values[m] * static_cast<double>(weight);
+                                totals.measured_ns[m] += weight;
+                            }
+                        }
+                    });
+            });
+    }
+
+    std::vector<kernel_metric_summary> summaries;
+    summaries.reserve(kernels.size());
+    for (auto& [name, totals] : kernels)
+    {
+        kernel_metric_summary& summary = summaries.emplace_back();
+        summary.kernel                 = name;
+        summary.launches               = totals.launches;
+        summary.total_ns               = totals.total_ns;
+        for (size_t m = 0; m < kernel_metric_count; ++m)
+        {
+            summary.mean[m] = totals.measured_ns[m] > 0
+                                  ? totals.weighted[m] / static_cast<double>(totals.measured_ns[m])
+                                  : std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+    std::stable_sort(
+        summaries.begin(),
+        summaries.end(),
+        [](const kernel_metric_summary& lhs, const kernel_metric_summary& rhs)
+        { return lhs.total_ns > rhs.total_ns; });
+    return summaries;
+}
+
+}  // namespace quarisma
@@ -0,0 +1,111 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/export.h"
+#include "profiler/native/exporters/xplane/xplane.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+
+namespace quarisma
+{
+
+/// Hardware metrics measured per GPU kernel by the CUPTI range profiler
+enum class kernel_metric : uint8_t
+{
+    achieved_occupancy,  ///< Active warps, % of the SM maximum
+    dram_throughput,     ///< DRAM bandwidth, % of peak
+    sm_efficiency,       ///< Cycles with at least one warp active, % of elapsed
+    l2_hit_rate,         ///< L2 sector hits, % of lookups
+};
+
+inline constexpr size_t kernel_metric_count = 4;
+
+/// "achieved occupancy", "DRAM throughput", ...
+QUARISMA_API std::string_view to_string(kernel_metric metric);
+
+/// Name of the metric for the CUPTI range profiler (CUPTI_PROFILER_METRICS)
+QUARISMA_API std::string_view cupti_metric_name(kernel_metric metric);
+
+/// Stat the metric is stored in on the GPU plane events
+QUARISMA_API StatType stat_type(kernel_metric metric);
+
+/// One kernel launch and the metrics measured over it
+struct kernel_metric_sample
+{
+    std::string kernel;
+    int32_t     device      = 0;
+    int64_t     start_ns    = 0;  ///< Unix time
+    int64_t     duration_ns = 0;
+
+    /// Percentages indexed by kernel_metric; NaN where the metric was not measured
+    std::array<double, kernel_metric_count> values{
+        std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::quiet_NaN()};
+
+    double value(kernel_metric metric) const { return values[static_cast<size_t>(metric)]; }
+};
+
+/**
+ * @brief Adds the samples to the GPU planes of a space
+ *
+ * Each sample becomes an event of the kKernelMetricsLineName line of
+ * GpuPlaneName(sample.device), named after the kernel, with one stat per
+ * measured metric. Planes and the line are created as needed, with the line
+ * timestamped at the earliest sample so that the event offsets stay small.
+ */
+QUARISMA_API void add_kernel_metrics(
+    x_space* space, const std::vector<kernel_metric_sample>& samples);
+
+/// Metrics of all launches of one kernel
+struct kernel_metric_summary
+{
+    std::string kernel;
+    uint64_t    launches = 0;
+    int64_t     total_ns = 0;
+
+    /// Means weighted by the launch durations; NaN where no launch measured the metric
+    std::array<double, kernel_metric_count> mean{};
+
+    double value(kernel_metric metric) const { return mean[static_cast<size_t>(metric)]; }
+};
+
+/**
+ * @brief Summarizes the kernel metric stats of the GPU planes of a space
+ *
+ * Events of any line of a "/device:GPU:" plane count if they carry at least
+ * one of the stats of stat_type(). Launches of the same kernel on different
+ * devices are summarized together.
+ *
+ * @return One summary per kernel, longest total time first
+ */
+QUARISMA_API std::vector<kernel_metric_summary> summarize_kernel_metrics(const x_space& space);
+
+}  // namespace quarisma
@@ -21,7 +21,9 @@
 
 #include <chrono>
 #include <cstddef>
-#include <mutex>
+#include <deque>
+#include <functional>
+#include <iterator>
 #include <string>
 #include <thread>
 #include <utility>
@@ -29,6 +31,9 @@
 
 // Include hash compatibility layer for libc++ versions that don't export __hash_memory
 
+#include "parallel/parallel_tools.h"
+#include "profiler/native/analysis/streaming_stats.h"
+#include "util/concurrent_flat_map.h"
 #include "util/flat_hash.h"
 
 // Prevent Windows min/max macros from interfering
@@ -64,11 +69,116 @@ void statistical_metrics::reset()
     outliers.clear();
 }
 
+//=============================================================================
+// statistical_series_store Implementation
+//=============================================================================
+
+// Samples of one timing, memory or custom series
+struct statistical_series
+{
+    running_moments moments;
+    quantile_sketch sketch;
+
+    // The last samples, a ring starting at `oldest` once full
+    std::vector<double> window;
+    size_t              oldest = 0;
+
+    void add(double value, size_t capacity)
+    {
+        moments.add(value);
+        sketch.add(value);
+        if (window.size() > capacity || (oldest != 0 && window.size() < capacity))
+        {
+            // The capacity changed: back to chronological order, then trim
+            window = retained();
+            oldest = 0;
+            window.erase(
+                window.begin(),
+                window.begin() + static_cast<std::ptrdiff_t>(
+                                     window.size() - (std::min)(window.size(), capacity)));
+        }
+        if (window.size() < capacity)
+        {
+            window.push_back(value);
+        }
+        else if (capacity > 0)
+        {
+            window[oldest] = value;
+            oldest         = (oldest + 1) % capacity;
+        }
+    }
+
+    // Kept samples, oldest first
+    std::vector<double> retained() const
+    {
+        std::vector<double> samples(
+            window.begin() + static_cast<std::ptrdiff_t>(oldest), window.end());
+        samples.insert(
+            samples.end(), window.begin(), window.begin() + static_cast<std::ptrdiff_t>(oldest));
+        return samples;
+    }
+};
+
+// Timing, memory or custom series, spread over shards locked independently
+class statistical_series_store : public concurrent_flat_map<std::string, statistical_series>
+{
+public:
+    statistical_series_store() : concurrent_flat_map(kShards) {}
+
+    void add(const std::string& name, double value, size_t capacity)
+    {
+        emplace_or_visit(
+            name, [value, capacity](statistical_series& series) { series.add(value, capacity); });
+    }
+
+    // Copies of all the series, taking one shard lock at a time
+    std::vector<std::pair<std::string, statistical_series>> snapshot() const
+    {
+        std::vector<std::pair<std::string, statistical_series>> all;
+        cvisit_all([&all](const std::string& name, const statistical_series& series)
+                   { all.emplace_back(name, series); });
+        return all;
+    }
+
+private:
+    static constexpr size_t kShards = 16;
+};
+
+namespace
+{
+
+double median_of_sorted(const std::vector<double>& sorted_data)
+{
+    size_t const mid = sorted_data.size() / 2;
+    return sorted_data.size() % 2 == 0 ? (sorted_data[mid - 1] + sorted_data[mid]) / 2.0
+                                       : sorted_data[mid];
+}
+
+// Values of a time series, copied so that they are analyzed outside its lock
+std::vector<double> values_of(const std::deque<quarisma::time_series_point>& series)
+{
+    std::vector<double> values;
+    values.reserve(series.size());
+    std::transform(
+        series.begin(),
+        series.end(),
+        std::back_inserter(values),
+        [](const quarisma::time_series_point& point) { return point.value_; });
+    return values;
+}
+
+}  // namespace
+
 //=============================================================================
 // statistical_analyzer Implementation
 //=============================================================================
 
-statistical_analyzer::statistical_analyzer() = default;
+statistical_analyzer::statistical_analyzer()
+    : timing_data_(std::make_unique<statistical_series_store>()),
+      memory_data_(std::make_unique<statistical_series_store>()),
+      custom_data_(std::make_unique<statistical_series_store>())
+{
+}
 
 statistical_analyzer::~statistical_analyzer()
 {
@@ -104,10 +214,7 @@ void statistical_analyzer::add_timing_sample(const std::string& name, double tim
         return;
     }
 
-    std::scoped_lock const lock(timing_mutex_);
-    auto&                  series = timing_data_[name];
-    series.push_back(time_ms);
-    trim_series_if_needed(series);
+    timing_data_->add(name, time_ms, max_samples_per_series_);
 }
 
 void statistical_analyzer::add_memory_sample(const std::string& name, size_t memory_bytes)
@@ -117,10 +224,7 @@ void statistical_analyzer::add_memory_sample(const std::string& name, size_t mem
         return;
     }
 
-    std::scoped_lock const lock(memory_mutex_);
-    auto&                  series = memory_data_[name];
-    series.push_back(static_cast<double>(memory_bytes));
-    trim_series_if_needed(series);
+    memory_data_->add(name, static_cast<double>(memory_bytes), max_samples_per_series_);
 }
 
 void statistical_analyzer::add_custom_sample(const std::string& name, double value)
@@ -130,10 +234,7 @@ void statistical_analyzer::add_custom_sample(const std::string& name, double val
         return;
     }
 
-    std::scoped_lock const lock(custom_mutex_);
-    auto&                  series = custom_data_[name];
-    series.push_back(value);
-    trim_series_if_needed(series);
+    custom_data_->add(name, value, max_samples_per_series_);
 }
 
 void statistical_analyzer::add_time_series_point(
@@ -150,136 +251,91 @@ void statistical_analyzer::add_time_series_point(
     point.label_     = label;
     point.thread_id_ = std::this_thread::get_id();
 
-    std::scoped_lock const lock(time_series_mutex_);
-    auto&                  series = time_series_data_[series_name];
-    series.push_back(point);
-    trim_time_series_if_needed(series);
+    time_series_data_.emplace_or_visit(
+        series_name,
+        [this, &point](std::deque<quarisma::time_series_point>& series)
+        {
+            series.push_back(std::move(point));
+            trim_time_series_if_needed(series);
+        });
 }
 
 quarisma::statistical_metrics statistical_analyzer::calculate_timing_stats(
     const std::string& name) const
 {
-    std::scoped_lock const lock(timing_mutex_);
-    auto                   it = timing_data_.find(name);
-    if (it == timing_data_.end())
-    {
-        return quarisma::statistical_metrics{};
-    }
-    return calculate_metrics(it->second);
+    return calculate_series_stats(*timing_data_, name);
 }
 
 quarisma::statistical_metrics statistical_analyzer::calculate_memory_stats(
     const std::string& name) const
 {
-    std::scoped_lock const lock(memory_mutex_);
-    auto                   it = memory_data_.find(name);
-    if (it == memory_data_.end())
-    {
-        return quarisma::statistical_metrics{};
-    }
-    return calculate_metrics(it->second);
+    return calculate_series_stats(*memory_data_, name);
 }
 
 quarisma::statistical_metrics statistical_analyzer::calculate_custom_stats(
     const std::string& name) const
 {
-    std::scoped_lock const lock(custom_mutex_);
-    auto                   it = custom_data_.find(name);
-    if (it == custom_data_.end())
-    {
-        return quarisma::statistical_metrics{};
-    }
-    return calculate_metrics(it->second);
+    return calculate_series_stats(*custom_data_, name);
 }
 
 quarisma_map<std::string, quarisma::statistical_metrics>
 statistical_analyzer::calculate_all_timing_stats() const
 {
-    std::scoped_lock const                               lock(timing_mutex_);
-    quarisma_map<std::string, quarisma::statistical_metrics> results;
-
-    for (const auto& pair : timing_data_)
-    {
-        results[pair.first] = calculate_metrics(pair.second);
-    }
-
-    return results;
+    return calculate_all_series_stats(*timing_data_);
 }
 
 quarisma_map<std::string, quarisma::statistical_metrics>
 statistical_analyzer::calculate_all_memory_stats() const
 {
-    std::scoped_lock const                               lock(memory_mutex_);
-    quarisma_map<std::string, quarisma::statistical_metrics> results;
-
-    for (const auto& pair : memory_data_)
-    {
-        results[pair.first] = calculate_metrics(pair.second);
-    }
-
-    return results;
+    return calculate_all_series_stats(*memory_data_);
 }
 
 quarisma_map<std::string, quarisma::statistical_metrics>
 statistical_analyzer::calculate_all_custom_stats() const
 {
-    std::scoped_lock const                               lock(custom_mutex_);
-    quarisma_map<std::string, quarisma::statistical_metrics> results;
-
-    for (const auto& pair : custom_data_)
-    {
-        results[pair.first] = calculate_metrics(pair.second);
-    }
-
-    return results;
+    return calculate_all_series_stats(*custom_data_);
 }
 
 std::vector<quarisma::time_series_point> statistical_analyzer::get_time_series(
     const std::string& series_name) const
 {
-    std::scoped_lock const lock(time_series_mutex_);
-    auto                   it = time_series_data_.find(series_name);
-
-    if (it == time_series_data_.end())
-    {
-        return {};
-    }
-    return it->second;
+    std::vector<quarisma::time_series_point> points;
+    time_series_data_.cvisit(
+        series_name,
+        [&points](const std::deque<quarisma::time_series_point>& series)
+        { points.assign(series.begin(), series.end()); });
+    return points;
 }
 
 quarisma::statistical_metrics statistical_analyzer::analyze_time_series(
     const std::string& series_name) const
 {
-    std::scoped_lock const lock(time_series_mutex_);
-    auto                   it = time_series_data_.find(series_name);
-    if (it == time_series_data_.end())
+    std::vector<double> values;
+    bool const          found = time_series_data_.cvisit(
+        series_name,
+        [&values](const std::deque<quarisma::time_series_point>& series)
+        { values = values_of(series); });
+    if (!found)
     {
         return quarisma::statistical_metrics{};
     }
 
-    std::vector<double> values;
-    values.reserve(it->second.size());
-    // Use std::transform to extract values
-    std::transform(
-        it->second.begin(),
-        it->second.end(),
-        std::back_inserter(values),
-        [](const quarisma::time_series_point& point) { return point.value_; });
-
     return calculate_metrics(values);
 }
 
 double statistical_analyzer::calculate_trend_slope(const std::string& series_name) const
 {
-    std::scoped_lock const lock(time_series_mutex_);
-    auto                   it = time_series_data_.find(series_name);
-    if (it == time_series_data_.end() || it->second.size() < 2)
+    std::vector<double> series;
+    time_series_data_.cvisit(
+        series_name,
+        [&series](const std::deque<quarisma::time_series_point>& points)
+        { series = values_of(points); });
+    if (series.size() < 2)
     {
         return 0.0;
     }
 
-    const auto&  series = it->second;
-    size_t const n      = series.size();
+    size_t const n = series.size();
 
     // Calculate linear regression slope using least squares
     double sum_x  = 0.0;
@@ -290,7 +346,7 @@ double statistical_analyzer::calculate_trend_slope(const std::string& series_nam
     for (size_t i = 0; i < n; ++i)
     {
         auto const   x = static_cast<double>(i);
-        double const y = series[i].value_;
+        double const y = series[i];
 
         sum_x += x;
         sum_y += y;
@@ -317,18 +373,14 @@ bool statistical_analyzer::is_trending_down(const std::string& series_name, doub
 double statistical_analyzer::calculate_correlation(
     const std::string& series1, const std::string& series2) const
 {
-    std::scoped_lock const lock(time_series_mutex_);
-
-    auto it1 = time_series_data_.find(series1);
-    auto it2 = time_series_data_.find(series2);
-
-    if (it1 == time_series_data_.end() || it2 == time_series_data_.end())
-    {
-        return 0.0;
-    }
-
-    const auto& s1 = it1->second;
-    const auto& s2 = it2->second;
+    std::vector<double> s1;
+    std::vector<double> s2;
+    time_series_data_.cvisit(
+        series1,
+        [&s1](const std::deque<quarisma::time_series_point>& points) { s1 = values_of(points); });
+    time_series_data_.cvisit(
+        series2,
+        [&s2](const std::deque<quarisma::time_series_point>& points) { s2 = values_of(points); });
 
     size_t const min_size = std::min(s1.size(), s2.size());
     if (min_size < 2)
@@ -345,8 +397,8 @@ double statistical_analyzer::calculate_correlation(
 
     for (size_t i = 0; i < min_size; ++i)
     {
-        double const x = s1[i].value_;
-        double const y = s2[i].value_;
+        double const x = s1[i];
+        double const y = s2[i];
 
         sum_x += x;
         sum_y += y;
@@ -378,74 +430,31 @@ bool statistical_analyzer::detect_performance_regression(
 
 void statistical_analyzer::clear_data()
 {
-    {
-        std::scoped_lock const lock(timing_mutex_);
-        timing_data_.clear();
-    }
-    {
-        std::scoped_lock const lock(memory_mutex_);
-        memory_data_.clear();
-    }
-    {
-        std::scoped_lock const lock(custom_mutex_);
-        custom_data_.clear();
-    }
-    {
-        std::scoped_lock const lock(time_series_mutex_);
-        time_series_data_.clear();
-    }
+    timing_data_->clear();
+    memory_data_->clear();
+    custom_data_->clear();
+    time_series_data_.clear();
 }
 
 void statistical_analyzer::clear_series(const std::string& name)
 {
-    {
-        std::scoped_lock const lock(timing_mutex_);
-        timing_data_.erase(name);
-    }
-    {
-        std::scoped_lock const lock(memory_mutex_);
-        memory_data_.erase(name);
-    }
-    {
-        std::scoped_lock const lock(custom_mutex_);
-        custom_data_.erase(name);
-    }
-    {
-        std::scoped_lock const lock(time_series_mutex_);
-        time_series_data_.erase(name);
-    }
+    timing_data_->erase(name);
+    memory_data_->erase(name);
+    custom_data_->erase(name);
+    time_series_data_.erase(name);
 }
 
 size_t statistical_analyzer::get_sample_count(const std::string& name) const
 {
+    size_t     count      = 0;
+    auto const get_count = [&count](const statistical_series& series)
+    { count = series.moments.count(); };
+    if (timing_data_->cvisit(name, get_count) || memory_data_->cvisit(name, get_count))
     {
-        std::scoped_lock const lock(timing_mutex_);
-        auto                   it = timing_data_.find(name);
-
-        if (it != timing_data_.end())
-        {
-            return it->second.size();
-        }
+        return count;
     }
-    {
-        std::scoped_lock const lock(memory_mutex_);
-        auto                   it = memory_data_.find(name);
-
-        if (it != memory_data_.end())
-        {
-            return it->second.size();
-        }
-    }
-    {
-        std::scoped_lock const lock(custom_mutex_);
-        auto                   it = custom_data_.find(name);
-
-        if (it != custom_data_.end())
-        {
-            return it->second.size();
-        }
-    }
-    return 0;
+    custom_data_->cvisit(name, get_count);
+    return count;
 }
 
 void statistical_analyzer::set_max_samples_per_series(size_t max_samples)
@@ -478,60 +487,126 @@ quarisma::statistical_metrics statistical_analyzer::calculate_metrics(
         return metrics;
     }
 
-    metrics.count = data.size();
-
-    // Calculate basic statistics
-    metrics.sum  = std::accumulate(data.begin(), data.end(), 0.0);
-    metrics.mean = metrics.sum / metrics.count;
-
-    metrics.min_value = *std::min_element(data.begin(), data.end());
-    metrics.max_value = *std::max_element(data.begin(), data.end());
-
-    // Calculate variance and standard deviation
-    double variance_sum = 0.0;
-
+    running_moments moments;
     for (double const value : data)
     {
-        double const diff = value - metrics.mean;
-        variance_sum += diff * diff;
+        moments.add(value);
     }
-    metrics.variance      = variance_sum / metrics.count;
+    metrics.count         = moments.count();
+    metrics.sum           = moments.sum();
+    metrics.mean          = moments.mean();
+    metrics.min_value     = moments.min();
+    metrics.max_value     = moments.max();
+    metrics.variance      = moments.variance();
     metrics.std_deviation = std::sqrt(metrics.variance);
 
     // Calculate median and percentiles
     std::vector<double> sorted_data = data;
     std::sort(sorted_data.begin(), sorted_data.end());
+    metrics.median      = median_of_sorted(sorted_data);
+    metrics.percentiles = calculate_percentiles(sorted_data, percentiles_);
 
-    size_t const mid = sorted_data.size() / 2;
+    // Detect outliers
+    metrics.outliers =
+        detect_outliers(data, metrics.mean, metrics.std_deviation, outlier_threshold_);
+    metrics.outlier_threshold = outlier_threshold_;
 
-    if (sorted_data.size() % 2 == 0)
-    {
-        metrics.median = (sorted_data[mid - 1] + sorted_data[mid]) / 2.0;
+    return metrics;
+}
+
+quarisma::statistical_metrics statistical_analyzer::calculate_series_stats(
+    const statistical_series_store& store, const std::string& name) const
+{
+    quarisma::statistical_metrics metrics;
+    store.cvisit(
+        name, [this, &metrics](const statistical_series& series)
+        { metrics = summarize_series(series); });
+    return metrics;
+}
+
+quarisma::statistical_metrics statistical_analyzer::summarize_series(
+    const statistical_series& series) const
+{
+    quarisma::statistical_metrics metrics;
+    const running_moments& moments = series.moments;
+    metrics.count                  = moments.count();
+    metrics.sum                    = moments.sum();
+    metrics.mean                   = moments.mean();
+    metrics.min_value              = moments.min();
+    metrics.max_value              = moments.max();
+    metrics.variance               = moments.variance();
+    metrics.std_deviation          = std::sqrt(metrics.variance);
+
+    std::vector<double> const retained = series.retained();
+    if (retained.size() == moments.count())
+    {
+        // Every sample is kept: exact order statistics
+        std::vector<double> sorted_data = retained;
+        std::sort(sorted_data.begin(), sorted_data.end());
+        metrics.median      = median_of_sorted(sorted_data);
+        metrics.percentiles = calculate_percentiles(sorted_data, percentiles_);
     }
     else
     {
-        metrics.median = sorted_data[mid];
+        auto const estimate = [&](double q)
+        { return std::clamp(series.sketch.quantile(q), moments.min(), moments.max()); };
+        metrics.median = estimate(0.5);
+        for (double const p : percentiles_)
+        {
+            if (p >= 0.0 && p <= 100.0)
+            {
+                metrics.percentiles.push_back(estimate(p / 100.0));
+            }
+        }
     }
 
-    // Calculate percentiles
-    metrics.percentiles = calculate_percentiles(sorted_data, percentiles_);
-
-    // Detect outliers
-    metrics.outliers          = detect_outliers(data, outlier_threshold_);
+    metrics.outliers = detect_outliers(
+        retained, metrics.mean, metrics.std_deviation, outlier_threshold_);
     metrics.outlier_threshold = outlier_threshold_;
-
     return metrics;
 }
 
+quarisma_map<std::string, quarisma::statistical_metrics>
+statistical_analyzer::calculate_all_series_stats(const statistical_series_store& store) const
+{
+    // Copy the series, so that samples can be added while computing
+    auto const all = store.snapshot();
+
+    std::vector<quarisma::statistical_metrics> metrics(all.size());
+    auto const compute = [this, &all, &metrics](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            metrics[i] = summarize_series(all[i].second);
+        }
+    };
+    if (worker_threads_hint_ > 0)
+    {
+        parallel_tools::local_scope(
+            parallel_tools::config(static_cast<int>(worker_threads_hint_)),
+            [&]() { parallel_tools::parallel_for(0, all.size(), 1, compute); });
+    }
+    else
+    {
+        parallel_tools::parallel_for(0, all.size(), 1, compute);
+    }
+
+    quarisma_map<std::string, quarisma::statistical_metrics> results;
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        results[all[i].first] = std::move(metrics[i]);
+    }
+    return results;
+}
+
 std::vector<double> statistical_analyzer::calculate_percentiles(
-    std::vector<double> data, const std::vector<double>& percentiles)
+    const std::vector<double>& sorted_data, const std::vector<double>& percentiles)
 {
-    if (data.empty() || percentiles.empty())
+    if (sorted_data.empty() || percentiles.empty())
     {
         return {};
     }
 
-    std::sort(data.begin(), data.end());
     std::vector<double> results;
     results.reserve(percentiles.size());
 
@@ -542,18 +617,19 @@ std::vector<double> statistical_analyzer::calculate_percentiles(
             continue;
         }
 
-        double const index = (p / 100.0) * (data.size() - 1);
+        double const index = (p / 100.0) * (sorted_data.size() - 1);
         auto const   lower = static_cast<size_t>(std::floor(index));
         auto const   upper = static_cast<size_t>(std::ceil(index));
 
         if (lower == upper)
         {
-            results.push_back(data[lower]);
+            results.push_back(sorted_data[lower]);
         }
         else
         {
             double const weight = index - lower;
-            results.push_back((data[lower] * (1.0 - weight)) + (data[upper] * weight));
+            results.push_back(
+                (sorted_data[lower] * (1.0 - weight)) + (sorted_data[upper] * weight));
         }
     }
 
@@ -561,25 +637,13 @@ std::vector<double> statistical_analyzer::calculate_percentiles(
 }
 
 std::vector<double> statistical_analyzer::detect_outliers(
-    const std::vector<double>& data, double threshold)
+    const std::vector<double>& data, double mean, double std_dev, double threshold)
 {
     if (data.size() < 3)
     {
         return {};  // Need at least 3 points for meaningful outlier detection
     }
 
-    // Calculate mean and standard deviation
-    double const sum  = std::accumulate(data.begin(), data.end(), 0.0);
-    double const mean = sum / data.size();
-
-    double variance_sum = 0.0;
-    for (double const value : data)
-    {
-        double const diff = value - mean;
-        variance_sum += diff * diff;
-    }
-    double const std_dev = std::sqrt(variance_sum / data.size());
-
     // Find outliers using z-score method
     std::vector<double> outliers;
     for (double const value : data)
@@ -594,24 +658,13 @@ std::vector<double> statistical_analyzer::detect_outliers(
     return outliers;
 }
 
-void statistical_analyzer::trim_series_if_needed(std::vector<double>& series) const
-{
-    if (series.size() > max_samples_per_series_)
-    {
-        // Remove oldest samples (from the beginning)
-        size_t const excess = series.size() - max_samples_per_series_;
-        series.erase(series.begin(), series.begin() + excess);
-    }
-}
-
 void statistical_analyzer::trim_time_series_if_needed(
-    std::vector<quarisma::time_series_point>& series) const
+    std::deque<quarisma::time_series_point>& series) const
 {
-    if (series.size() > max_samples_per_series_)
+    while (series.size() > max_samples_per_series_)
     {
         // Remove oldest samples (from the beginning)
-        size_t const excess = series.size() - max_samples_per_series_;
-        series.erase(series.begin(), series.begin() + excess);
+        series.pop_front();
     }
 }
 
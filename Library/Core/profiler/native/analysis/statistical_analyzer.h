@@ -29,12 +29,15 @@
 
 #include <algorithm>
 #include <cmath>
+#include <deque>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
 #include "profiler/native/session/profiler.h"
+#include "util/concurrent_flat_map.h"
 #include "util/flat_hash.h"
 
 namespace quarisma
@@ -72,12 +75,23 @@ struct time_series_point
     std::thread::id                                thread_id_;
 };
 
+struct statistical_series;
+class statistical_series_store;
+
 /**
  * @brief Statistical analyzer for profiling data (OPTIONAL COMPONENT)
  *
  * COMPONENT CLASSIFICATION: OPTIONAL
  * This component provides statistical analysis capabilities but is not required
  * for basic profiling functionality. Can be disabled to reduce binary size.
+ *
+ * Timing, memory and custom samples are summarized as they are added, in
+ * O(1): count, sum, extrema and variance are exact over all the samples of a
+ * series, while the last max_samples_per_series samples are kept for outlier
+ * detection. Median and percentiles are exact while every sample is kept, and
+ * come from a quantile sketch (1% relative error) past that. Series are
+ * spread over independently locked shards, and calculate_all_*_stats()
+ * computes the series in parallel with parallel_tools.
  */
 class QUARISMA_VISIBILITY statistical_analyzer
 {
@@ -141,7 +155,7 @@ public:
     QUARISMA_API void set_outlier_threshold(double threshold);
     QUARISMA_API void set_percentiles(const std::vector<double>& percentiles);
 
-    // Optional threading hint (no-op placeholder for future parallel analysis)
+    // Maximum number of threads of calculate_all_*_stats(), 0 for the parallel_tools default
     QUARISMA_API void set_worker_threads_hint(size_t threads);
 
     // Public helper for external use
@@ -150,16 +164,12 @@ public:
 private:
     std::atomic<bool> analyzing_{false};
 
-    // Thread-safe data storage
-    mutable std::mutex timing_mutex_;
-    mutable std::mutex memory_mutex_;
-    mutable std::mutex custom_mutex_;
-    mutable std::mutex time_series_mutex_;
+    // Thread-safe data storage, sharded by series name
+    std::unique_ptr<statistical_series_store> timing_data_;
+    std::unique_ptr<statistical_series_store> memory_data_;
+    std::unique_ptr<statistical_series_store> custom_data_;
 
-    quarisma_map<std::string, std::vector<double>>                    timing_data_;
-    quarisma_map<std::string, std::vector<double>>                    memory_data_;
-    quarisma_map<std::string, std::vector<double>>                    custom_data_;
-    quarisma_map<std::string, std::vector<quarisma::time_series_point>> time_series_data_;
+    concurrent_flat_map<std::string, std::deque<quarisma::time_series_point>> time_series_data_;
 
     // Configuration
     size_t              max_samples_per_series_ = 10000;
@@ -168,11 +178,16 @@ private:
     size_t              worker_threads_hint_    = 0;
 
     // Helper methods
+    quarisma::statistical_metrics calculate_series_stats(
+        const statistical_series_store& store, const std::string& name) const;
+    quarisma::statistical_metrics summarize_series(const statistical_series& series) const;
+    quarisma_map<std::string, quarisma::statistical_metrics> calculate_all_series_stats(
+        const statistical_series_store& store) const;
     static std::vector<double> calculate_percentiles(
-        std::vector<double> data, const std::vector<double>& percentiles);
-    static std::vector<double> detect_outliers(const std::vector<double>& data, double threshold);
-    void                       trim_series_if_needed(std::vector<double>& series) const;
-    void trim_time_series_if_needed(std::vector<quarisma::time_series_point>& series) const;
+        const std::vector<double>& sorted_data, const std::vector<double>& percentiles);
+    static std::vector<double> detect_outliers(
+        const std::vector<double>& data, double mean, double std_dev, double threshold);
+    void trim_time_series_if_needed(std::deque<quarisma::time_series_point>& series) const;
 };
 
 // RAII statistical analysis scope
@@ -379,4 +379,28 @@ void stats_calculator::add_node_stats(
     detail_ptr->mem_used.update_stat(mem_used);
     detail_ptr->times_called++;
 }
+
+void stats_calculator::merge(const stats_calculator& other)
+{
+    merge_run_stats(other.run_total_us_, other.memory_);
+    for (const auto& entry : other.details_)
+    {
+        merge_node_stats(entry.second);
+    }
+}
+
+void stats_calculator::merge_node_stats(const detail& node)
+{
+    auto const inserted = details_.insert({node.name, {}});
+    detail&    merged   = inserted.first->second;
+    if (inserted.second)
+    {
+        merged.name      = node.name;
+        merged.type      = node.type;
+        merged.run_order = node.run_order;
+    }
+    merged.elapsed_time.merge(node.elapsed_time);
+    merged.mem_used.merge(node.mem_used);
+    merged.times_called += node.times_called;
+}
 }  // namespace quarisma
@@ -71,6 +71,51 @@ public:
 
     void reset() { new (this) stat<ValueType, HighPrecisionValueType>(); }
 
+    // Adds the values summarized by `other`, as if they had been passed to
+    // update_stat() after those of this stat.
+    void merge(const stat& other)
+    {
+        if (other.empty())
+        {
+            return;
+        }
+        if (count_ == 0)
+        {
+            first_ = other.first_;
+        }
+        newest_ = other.newest_;
+        max_    = std::max(other.max_, max_);
+        min_    = std::min(other.min_, min_);
+        count_ += other.count_;
+        sum_ += other.sum_;
+        squared_sum_ += other.squared_sum_;
+    }
+
+    // A stat summarizing `count` values from its accessors' results, e.g.
+    // those of a stat of another process.
+    static stat from_summary(
+        int64_t                count,
+        ValueType              first,
+        ValueType              newest,
+        ValueType              min,
+        ValueType              max,
+        ValueType              sum,
+        HighPrecisionValueType squared_sum)
+    {
+        stat result;
+        if (count > 0)
+        {
+            result.first_       = first;
+            result.newest_      = newest;
+            result.min_         = min;
+            result.max_         = max;
+            result.count_       = count;
+            result.sum_         = sum;
+            result.squared_sum_ = squared_sum;
+        }
+        return result;
+    }
+
     bool empty() const { return count_ == 0; }
 
     ValueType first() const { return first_; }
@@ -243,6 +288,9 @@ public:
 
     void update_memory_used(int64_t memory) { memory_.update_stat(memory); }
 
+    // Returns stats of the memory used by each run.
+    const stat<int64_t>& memory_used() const { return memory_; }
+
     struct detail
     {
         std::string   name;
@@ -262,6 +310,21 @@ public:
         int64_t            elapsed_time,
         int64_t            mem_used);
 
+    // Adds the runs and node stats of `other`, e.g. those of another
+    // process, as if they had been recorded here.
+    QUARISMA_API void merge(const stats_calculator& other);
+
+    // Adds the stats of one node, by name; the type and run order of a node
+    // already present are kept.
+    QUARISMA_API void merge_node_stats(const detail& node);
+
+    // Adds the stats of runs recorded elsewhere.
+    void merge_run_stats(const stat<int64_t>& run_total_us, const stat<int64_t>& memory)
+    {
+        run_total_us_.merge(run_total_us);
+        memory_.merge(memory);
+    }
+
 private:
     void order_nodes_by_metric(
         sorting_metric_enum sorting_metric, std::vector<const detail*>* details) const;
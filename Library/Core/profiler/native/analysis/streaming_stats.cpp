@@ -0,0 +1,151 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler/native/analysis/streaming_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+// Magnitudes below this are counted as zero
+constexpr double kMinIndexableValue = 1e-12;
+}  // namespace
+
+quantile_sketch::quantile_sketch(double relative_accuracy, size_t max_buckets)
+    : gamma_((1.0 + relative_accuracy) / (1.0 - relative_accuracy)),
+      log_gamma_(std::log(gamma_)),
+      max_buckets_(max_buckets)
+{
+    QUARISMA_CHECK(
+        relative_accuracy > 0.0 && relative_accuracy < 1.0,
+        "quantile_sketch relative accuracy must be in (0, 1), got {}",
+        relative_accuracy);
+    QUARISMA_CHECK(max_buckets > 0, "quantile_sketch needs at least one bucket");
+}
+
+void quantile_sketch::add(double value)
+{
+    ++count_;
+    if (value > kMinIndexableValue)
+    {
+        positive_.add(key(value), max_buckets_);
+    }
+    else if (value < -kMinIndexableValue)
+    {
+        negative_.add(key(-value), max_buckets_);
+    }
+    else
+    {
+        ++zero_count_;
+    }
+}
+
+double quantile_sketch::quantile(double q) const
+{
+    if (count_ == 0)
+    {
+        return 0.0;
+    }
+    auto const rank =
+        static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(count_ - 1));
+    uint64_t smaller = 0;
+
+    // Ascending values: negatives by decreasing magnitude, zeros, positives
+    for (size_t i = negative_.counts.size(); i-- > 0;)
+    {
+        smaller += negative_.counts[i];
+        if (smaller > rank)
+        {
+            return -value(negative_.offset + static_cast<int32_t>(i));
+        }
+    }
+    smaller += zero_count_;
+    if (smaller > rank)
+    {
+        return 0.0;
+    }
+    for (size_t i = 0; i < positive_.counts.size(); ++i)
+    {
+        smaller += positive_.counts[i];
+        if (smaller > rank)
+        {
+            return value(positive_.offset + static_cast<int32_t>(i));
+        }
+    }
+    return value(positive_.offset + static_cast<int32_t>(positive_.counts.size()) - 1);
+}
+
+void quantile_sketch::clear()
+{
+    positive_   = bucket_store{};
+    negative_   = bucket_store{};
+    zero_count_ = 0;
+    count_      = 0;
+}
+
+int32_t quantile_sketch::key(double magnitude) const
+{
+    return static_cast<int32_t>(std::ceil(std::log(magnitude) / log_gamma_));
+}
+
+double quantile_sketch::value(int32_t key) const
+{
+    // The bucket (gamma^(key-1), gamma^key] is within the relative accuracy
+    // of this point
+    return 2.0 * std::pow(gamma_, key) / (gamma_ + 1.0);
+}
+
+void quantile_sketch::bucket_store::add(int32_t key, size_t max_buckets)
+{
+    if (counts.empty())
+    {
+        offset = key;
+        counts.assign(1, 1);
+        return;
+    }
+
+    int32_t const last = offset + static_cast<int32_t>(counts.size()) - 1;
+    int32_t       lo   = std::min(key, offset);
+    int32_t const hi   = std::max(key, last);
+    if (static_cast<size_t>(hi - lo) + 1 > max_buckets)
+    {
+        // Collapse the lowest buckets into the lowest one kept
+        lo  = hi - static_cast<int32_t>(max_buckets) + 1;
+        key = std::max(key, lo);
+    }
+    if (lo != offset || hi != last)
+    {
+        std::vector<uint64_t> resized(static_cast<size_t>(hi - lo) + 1, 0);
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            int32_t const k = std::max(offset + static_cast<int32_t>(i), lo);
+            resized[static_cast<size_t>(k - lo)] += counts[i];
+        }
+        counts.swap(resized);
+        offset = lo;
+    }
+    ++counts[static_cast<size_t>(key - offset)];
+}
+
+}  // namespace quarisma
@@ -0,0 +1,116 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common/export.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief Count, sum, extrema and variance of a stream, updated in O(1).
+ *
+ * The variance uses Welford's update, which stays accurate when it is small
+ * compared to the mean, unlike the sum of squares.
+ */
+class running_moments
+{
+public:
+    void add(double value)
+    {
+        ++count_;
+        sum_ += value;
+        double const delta = value - mean_;
+        mean_ += delta / static_cast<double>(count_);
+        m2_ += delta * (value - mean_);
+        min_ = value < min_ ? value : min_;
+        max_ = value > max_ ? value : max_;
+    }
+
+    size_t count() const { return count_; }
+    double sum() const { return sum_; }
+    double mean() const { return count_ > 0 ? sum_ / static_cast<double>(count_) : 0.0; }
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+    /// Population variance, 0 for an empty stream
+    double variance() const { return count_ > 0 ? m2_ / static_cast<double>(count_) : 0.0; }
+
+private:
+    size_t count_ = 0;
+    double sum_   = 0.0;
+    double mean_  = 0.0;
+    double m2_    = 0.0;
+    double min_   = (std::numeric_limits<double>::max)();
+    double max_   = (std::numeric_limits<double>::lowest)();
+};
+
+/**
+ * @brief Streaming quantile estimates with a bounded relative error (DDSketch).
+ *
+ * Values are counted in logarithmic buckets, so add() is O(1) and memory
+ * grows with the log of the value range, not with the sample count. A
+ * quantile is returned within relative_accuracy of the exact value, as long
+ * as no more than max_buckets buckets per sign are needed; beyond that the
+ * lowest buckets are merged, which only affects the smallest magnitudes.
+ */
+class QUARISMA_VISIBILITY quantile_sketch
+{
+public:
+    QUARISMA_API explicit quantile_sketch(
+        double relative_accuracy = 0.01, size_t max_buckets = 2048);
+
+    QUARISMA_API void add(double value);
+
+    /// Estimate of the q-quantile, q in [0, 1]; 0 for an empty sketch
+    QUARISMA_API double quantile(double q) const;
+
+    size_t count() const { return count_; }
+
+    QUARISMA_API void clear();
+
+private:
+    // Counts of consecutive bucket keys, starting at offset
+    struct bucket_store
+    {
+        std::vector<uint64_t> counts;
+        int32_t               offset = 0;
+
+        void add(int32_t key, size_t max_buckets);
+    };
+
+    int32_t key(double magnitude) const;
+    double  value(int32_t key) const;
+
+    double       gamma_;
+    double       log_gamma_;
+    size_t       max_buckets_;
+    bucket_store positive_;
+    bucket_store negative_;
+    uint64_t     zero_count_ = 0;
+    size_t       count_      = 0;
+};
+
+}  // namespace quarisma
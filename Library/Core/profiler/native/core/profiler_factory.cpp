@@ -41,6 +41,7 @@ limitations under the License.
 #include "profiler/native/core/profiler_controller.h"
 #include "profiler/native/core/profiler_interface.h"
 #include "profiler/native/core/profiler_options.h"
+#include "util/startup_tracer.h"
 
 namespace quarisma
 {
@@ -124,6 +125,8 @@ private:
 
 void register_profiler_factory(profiler_factory factory)
 {
+    // Runs from static initializers, before main
+    const startup_tracer::scope traced("profiler_factory::register");
     factory_registry::instance().register_factory(std::move(factory));
 }
 
@@ -127,12 +127,45 @@ public:
     /**
      * @brief Sets the Python tracer level
      * @param python_tracer_level The tracer level (0-3, higher means more detailed)
+     *
+     * Level 1 samples the Python stacks (see python_sampler.h) instead of
+     * tracing every call.
      */
     void set_python_tracer_level(uint32_t python_tracer_level)
     {
         python_tracer_level_ = python_tracer_level;
     }
 
+    /**
+     * @brief Gets the CPU sampling frequency
+     * @return Stack samples per second of CPU time, or 0 if sampling is disabled
+     */
+    uint32_t cpu_sampling_frequency_hz() const { return cpu_sampling_frequency_hz_; }
+
+    /**
+     * @brief Sets the CPU sampling frequency
+     * @param frequency_hz Stack samples per second of CPU time; 0 disables sampling
+     */
+    void set_cpu_sampling_frequency_hz(uint32_t frequency_hz)
+    {
+        cpu_sampling_frequency_hz_ = frequency_hz;
+    }
+
+    /**
+     * @brief Gets the Python sampling frequency
+     * @return Python stack samples per second, or 0 if Python sampling is disabled
+     */
+    uint32_t python_sampling_frequency_hz() const { return python_sampling_frequency_hz_; }
+
+    /**
+     * @brief Sets the Python sampling frequency, used when the Python tracer level is 1
+     * @param frequency_hz Python stack samples per second of wall-clock time
+     */
+    void set_python_sampling_frequency_hz(uint32_t frequency_hz)
+    {
+        python_sampling_frequency_hz_ = frequency_hz;
+    }
+
     /**
      * @brief Gets whether HLO proto generation is enabled
      * @return true if HLO proto generation is enabled, false otherwise
@@ -189,15 +222,17 @@ public:
 
 private:
     // Member variables
-    uint32_t         version_             = 5;
-    device_type_enum device_type_         = device_type_enum::UNSPECIFIED;
-    bool             include_dataset_ops_ = false;
-    uint32_t         host_tracer_level_   = 2;
-    uint32_t         device_tracer_level_ = 3;
-    uint32_t         python_tracer_level_ = 0;
-    bool             enable_hlo_proto_    = false;
-    uint64_t         start_timestamp_ns_  = 0;
-    uint64_t         duration_ms_         = 0;
+    uint32_t         version_                      = 5;
+    device_type_enum device_type_                  = device_type_enum::UNSPECIFIED;
+    bool             include_dataset_ops_          = false;
+    uint32_t         host_tracer_level_            = 2;
+    uint32_t         device_tracer_level_          = 3;
+    uint32_t         python_tracer_level_          = 0;
+    uint32_t         cpu_sampling_frequency_hz_    = 0;
+    uint32_t         python_sampling_frequency_hz_ = 99;
+    bool             enable_hlo_proto_             = false;
+    uint64_t         start_timestamp_ns_           = 0;
+    uint64_t         duration_ms_                  = 0;
     std::string      repository_path_;
 };
 
@@ -34,11 +34,12 @@ limitations under the License.
 
 #include "profiler/native/cpu/annotation_stack.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <string>
-#include <tuple>
+#include <string_view>
 #include <vector>
 
 #include "common/macros.h"
@@ -46,59 +47,110 @@ limitations under the License.
 namespace quarisma::profiler
 {
 
+namespace
+{
+
 /**
- * @brief Get the thread-local annotation data for the given generation.
- *
- * This function maintains thread-local storage for:
- * - Stack of string positions (for efficient pop operations)
- * - Concatenated annotation string
- * - Stack of scope range IDs
+ * @brief Thread-local annotation stack.
  *
- * When the generation changes (enable/disable), the data is reset.
- *
- * @param atomic The generation atomic variable
- * @return Tuple of (stack, string, scope_range_id_stack) pointers
+ * The names are kept back to back in one buffer, so push and pop only move
+ * its end and that of the level and ID vectors: neither touches the
+ * concatenated string, which get() brings up to date lazily, appending only
+ * the levels pushed since it last ran. Buffers are reserved once and keep
+ * their capacity across enable/disable, so nesting within the reserved depth
+ * allocates nothing.
  */
-static auto get_annotation_data(const std::atomic<int>& atomic)
+struct annotation_data
 {
-    static thread_local struct
+    /// End of each level's name in `names`, and of its path in `string` once built
+    struct level
+    {
+        size_t name_end = 0;
+        size_t path_end = 0;
+    };
+
+    int                  generation = 0;
+    std::vector<level>   levels;
+    std::string          names;
+    std::string          string;
+    size_t               built_levels = 0;
+    std::vector<int64_t> scope_range_id_stack;
+
+    annotation_data()
     {
-        int                  generation = 0;
-        std::vector<size_t>  stack;
-        std::string          string;
-        std::vector<int64_t> scope_range_id_stack;
-    } data;
+        constexpr size_t reserved_levels = 64;
+        constexpr size_t reserved_bytes  = 1024;
+        levels.reserve(reserved_levels);
+        scope_range_id_stack.reserve(reserved_levels);
+        names.reserve(reserved_bytes);
+        string.reserve(reserved_bytes);
+    }
 
-    int const generation = atomic.load(std::memory_order_acquire);
-    if (generation != data.generation)
+    void clear()
     {
-        // Generation changed (enable/disable), reset the data
-        data = {generation};
+        levels.clear();
+        names.clear();
+        string.clear();
+        built_levels = 0;
+        scope_range_id_stack.clear();
     }
 
-    return std::make_tuple(&data.stack, &data.string, &data.scope_range_id_stack);
+    std::string_view name(size_t index) const
+    {
+        size_t const begin = index == 0 ? 0 : levels[index - 1].name_end;
+        return std::string_view(names).substr(begin, levels[index].name_end - begin);
+    }
+
+    const std::string& path()
+    {
+        if (built_levels == levels.size())
+        {
+            return string;
+        }
+        string.resize(built_levels == 0 ? 0 : levels[built_levels - 1].path_end);
+        for (; built_levels < levels.size(); ++built_levels)
+        {
+            // An empty path takes the name without separator
+            if (!string.empty())
+            {
+                string.append("::");
+            }
+            string.append(name(built_levels));
+            levels[built_levels].path_end = string.size();
+        }
+        return string;
+    }
+};
+
+/**
+ * @brief Get the thread-local annotation data for the given generation.
+ *
+ * When the generation changes (enable/disable), the data is cleared.
+ */
+annotation_data& get_annotation_data(const std::atomic<int>& atomic)
+{
+    static thread_local annotation_data data;
+
+    int const generation = atomic.load(std::memory_order_acquire);
+    if QUARISMA_UNLIKELY (generation != data.generation)
+    {
+        data.clear();
+        data.generation = generation;
+    }
+    return data;
 }
 
+}  // namespace
+
 void annotation_stack::push_annotation(std::string_view name)
 {
     // Global counter for generating unique scope range IDs
     static std::atomic<int64_t> scope_range_counter = 0;
 
-    auto [stack, string, scope_range_id_stack] = get_annotation_data(generation_);
+    annotation_data& data = get_annotation_data(generation_);
 
-    // Save the current string size for efficient pop
-    stack->push_back(string->size());
-
-    // Append the annotation with "::" separator
-    if (!string->empty())
-    {
-        string->append("::");
-        string->append(name);
-    }
-    else
-    {
-        string->assign(name);
-    }
+    data.names.append(name);
+    data.levels.push_back({data.names.size(), 0});
 
     // Generate a unique scope range ID
     int64_t scope_range_id = scope_range_counter.fetch_add(1, std::memory_order_relaxed) + 1;
@@ -109,36 +161,34 @@ void annotation_stack::push_annotation(std::string_view name)
         scope_range_id = scope_range_counter.fetch_add(1, std::memory_order_relaxed) + 1;
     }
 
-    scope_range_id_stack->push_back(scope_range_id);
+    data.scope_range_id_stack.push_back(scope_range_id);
 }
 
 void annotation_stack::pop_annotation()
 {
-    auto [stack, string, scope_range_id_stack] = get_annotation_data(generation_);
+    annotation_data& data = get_annotation_data(generation_);
 
-    if (stack->empty())
+    if (data.levels.empty())
     {
         // Stack is empty, clear everything
-        string->clear();
-        scope_range_id_stack->clear();
+        data.clear();
         return;
     }
 
-    // Restore the string to the size before the last push
-    string->resize(stack->back());
-    stack->pop_back();
-    scope_range_id_stack->pop_back();
+    data.levels.pop_back();
+    data.scope_range_id_stack.pop_back();
+    data.names.resize(data.levels.empty() ? 0 : data.levels.back().name_end);
+    data.built_levels = (std::min)(data.built_levels, data.levels.size());
 }
 
 const std::string& annotation_stack::get()
 {
-    return *std::get<1>(get_annotation_data(generation_));
+    return get_annotation_data(generation_).path();
 }
 
 const std::vector<int64_t>& annotation_stack::get_scope_range_ids()
 {
-    auto* vec = std::get<2>(get_annotation_data(generation_));
-    return *vec;
+    return get_annotation_data(generation_).scope_range_id_stack;
 }
 
 void annotation_stack::enable(bool enable)
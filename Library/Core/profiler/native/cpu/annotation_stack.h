@@ -95,7 +95,9 @@ public:
      * @brief Get the full annotation string for the current thread.
      *
      * Returns the concatenated annotation stack as a single string,
-     * with annotations separated by "::".
+     * with annotations separated by "::". Push and pop leave the string
+     * alone; it is brought up to date here, appending only the levels pushed
+     * since the last call.
      *
      * @return Reference to the annotation string
      */
@@ -0,0 +1,229 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler/native/cpu/hardware_counters.h"
+
+#include <mutex>
+
+#include "logging/logger.h"
+#include "util/error.h"
+
+#if defined(__linux__)
+#include <cerrno>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace quarisma
+{
+namespace profiler
+{
+namespace
+{
+
+#if defined(__linux__)
+
+struct counter_config
+{
+    uint32_t type;
+    uint64_t config;
+};
+
+// Indexed by hardware_counter; cycles leads the group
+constexpr std::array<counter_config, kNumHardwareCounters> kCounterConfigs{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+}};
+
+int open_counter(const counter_config& counter, int group_fd)
+{
+    perf_event_attr attr{};
+    attr.size           = sizeof(perf_event_attr);
+    attr.type           = counter.type;
+    attr.config         = counter.config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // This thread, any CPU
+    return static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+// The counters of one thread, one perf group led by the cycle counter
+class thread_counter_group
+{
+public:
+    thread_counter_group() { fds_.fill(-1); }
+
+    ~thread_counter_group()
+    {
+        for (int const fd : fds_)
+        {
+            if (fd != -1)
+            {
+                ::close(fd);
+            }
+        }
+    }
+
+    thread_counter_group(const thread_counter_group&)            = delete;
+    thread_counter_group& operator=(const thread_counter_group&) = delete;
+
+    bool read(hardware_counter_values* values)
+    {
+        if (state_ == state::unopened)
+        {
+            open();
+        }
+        if (state_ != state::opened)
+        {
+            return false;
+        }
+
+        // Layout of a PERF_FORMAT_GROUP read, values in the order the
+        // counters were added to the group
+        struct
+        {
+            uint64_t nr;
+            uint64_t time_enabled;
+            uint64_t time_running;
+            uint64_t values[kNumHardwareCounters];
+        } data{};
+        long const n = ::read(fds_[0], &data, sizeof(data));
+        if (n < static_cast<long>(3 * sizeof(uint64_t)) || data.time_running == 0)
+        {
+            return false;
+        }
+
+        double const scale =
+            static_cast<double>(data.time_enabled) / static_cast<double>(data.time_running);
+        *values                = hardware_counter_values{};
+        values->available_mask = mask_;
+        for (size_t i = 0; i < data.nr && i < members_; ++i)
+        {
+            uint64_t const count = data.time_enabled == data.time_running
+                                       ? data.values[i]
+                                       : static_cast<uint64_t>(data.values[i] * scale);
+            values->counts[static_cast<size_t>(order_[i])] = count;
+        }
+        return true;
+    }
+
+private:
+    enum class state : uint8_t
+    {
+        unopened,
+        opened,
+        failed,
+    };
+
+    void open()
+    {
+        state_ = state::failed;
+        for (size_t i = 0; i < kNumHardwareCounters; ++i)
+        {
+            int const fd = open_counter(kCounterConfigs[i], members_ == 0 ? -1 : fds_[0]);
+            if (fd == -1)
+            {
+                if (i == 0)
+                {
+                    static std::once_flag warned;
+                    std::call_once(
+                        warned,
+                        []()
+                        {
+                            QUARISMA_LOG_WARNING(
+                                "Hardware counters are unavailable, perf_event_open() failed: {}",
+                                quarisma::utils::str_error(errno));
+                        });
+                    return;
+                }
+                // Not provided by this CPU; count the others
+                continue;
+            }
+            fds_[members_]   = fd;
+            order_[members_] = static_cast<hardware_counter>(i);
+            mask_ |= 1u << i;
+            ++members_;
+        }
+        state_ = state::opened;
+    }
+
+    state                                              state_ = state::unopened;
+    std::array<int, kNumHardwareCounters>              fds_;
+    std::array<hardware_counter, kNumHardwareCounters> order_{};
+    size_t                                             members_ = 0;
+    uint32_t                                           mask_    = 0;
+};
+
+#endif  // defined(__linux__)
+
+}  // namespace
+
+std::string_view hardware_counter_name(hardware_counter counter)
+{
+    switch (counter)
+    {
+    case hardware_counter::cycles:
+        return "cycles";
+    case hardware_counter::instructions:
+        return "instructions";
+    case hardware_counter::llc_misses:
+        return "llc_misses";
+    case hardware_counter::branch_misses:
+        return "branch_misses";
+    case hardware_counter::dtlb_misses:
+        return "dtlb_misses";
+    }
+    return "unknown";
+}
+
+bool read_thread_hardware_counters(hardware_counter_values* values)
+{
+#if defined(__linux__)
+    thread_local thread_counter_group group;
+    return group.read(values);
+#else
+    (void)values;
+    return false;
+#endif
+}
+
+hardware_counter_values hardware_counter_delta(
+    const hardware_counter_values& start, const hardware_counter_values& end)
+{
+    hardware_counter_values delta;
+    delta.available_mask = start.available_mask & end.available_mask;
+    for (size_t i = 0; i < kNumHardwareCounters; ++i)
+    {
+        // Scaled counts of a multiplexed group can step back slightly
+        delta.counts[i] = end.counts[i] > start.counts[i] ? end.counts[i] - start.counts[i] : 0;
+    }
+    return delta;
+}
+
+}  // namespace profiler
+}  // namespace quarisma
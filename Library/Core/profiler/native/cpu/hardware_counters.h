@@ -0,0 +1,122 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "common/macros.h"
+
+namespace quarisma
+{
+namespace profiler
+{
+
+/**
+ * @brief PMU events counted for profiler scopes.
+ */
+enum class hardware_counter : uint8_t
+{
+    cycles,         ///< CPU cycles
+    instructions,   ///< Retired instructions
+    llc_misses,     ///< Last level cache misses
+    branch_misses,  ///< Mispredicted branches
+    dtlb_misses,    ///< Data TLB read misses
+};
+
+constexpr size_t kNumHardwareCounters = 5;
+
+/// Short name of a counter, as used in reports ("cycles", "llc_misses", ...)
+QUARISMA_API std::string_view hardware_counter_name(hardware_counter counter);
+
+/**
+ * @brief Counts of the hardware counters of one thread.
+ *
+ * Counters the CPU or the kernel does not provide are missing from the mask
+ * and read as 0.
+ */
+struct hardware_counter_values
+{
+    std::array<uint64_t, kNumHardwareCounters> counts{};
+
+    /// Bit i is set when hardware_counter i was counted
+    uint32_t available_mask = 0;
+
+    bool has(hardware_counter counter) const
+    {
+        return (available_mask & (1u << static_cast<size_t>(counter))) != 0;
+    }
+
+    uint64_t get(hardware_counter counter) const { return counts[static_cast<size_t>(counter)]; }
+
+    bool empty() const { return available_mask == 0; }
+
+    /// Instructions per cycle, 0 without both counters
+    double ipc() const
+    {
+        return has(hardware_counter::cycles) && has(hardware_counter::instructions) &&
+                       get(hardware_counter::cycles) != 0
+                   ? static_cast<double>(get(hardware_counter::instructions)) /
+                         static_cast<double>(get(hardware_counter::cycles))
+                   : 0.0;
+    }
+
+    /// Events of `counter` per 1000 instructions, 0 without both counters
+    double per_kilo_instruction(hardware_counter counter) const
+    {
+        return has(counter) && has(hardware_counter::instructions) &&
+                       get(hardware_counter::instructions) != 0
+                   ? 1000.0 * static_cast<double>(get(counter)) /
+                         static_cast<double>(get(hardware_counter::instructions))
+                   : 0.0;
+    }
+
+    /// Adds the counts of `other`, keeping the counters both have
+    void accumulate(const hardware_counter_values& other)
+    {
+        available_mask = empty() ? other.available_mask : (available_mask & other.available_mask);
+        for (size_t i = 0; i < kNumHardwareCounters; ++i)
+        {
+            counts[i] += other.counts[i];
+        }
+    }
+};
+
+/**
+ * @brief Reads the hardware counters of the calling thread.
+ *
+ * The counters of a thread are opened with perf_event_open(2) as one group
+ * on its first call, count user-space events only, and stay open until the
+ * thread exits; a read is then a single read(2). Counts are scaled by the
+ * enabled/running time when the kernel multiplexes the PMU.
+ *
+ * @return false if no counter could be opened for this thread, e.g. outside
+ *         Linux, in a VM without a virtual PMU, or under perf_event_paranoid
+ */
+QUARISMA_API bool read_thread_hardware_counters(hardware_counter_values* values);
+
+/// Counts from `start` to `end`, two reads on the same thread
+QUARISMA_API hardware_counter_values
+hardware_counter_delta(const hardware_counter_values& start, const hardware_counter_values& end);
+
+}  // namespace profiler
+}  // namespace quarisma
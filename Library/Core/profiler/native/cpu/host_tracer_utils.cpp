@@ -45,6 +45,7 @@ limitations under the License.
 #include "profiler/native/exporters/xplane/xplane_utils.h"
 #include "profiler/native/tracing/traceme_recorder.h"
 #include "profiler/native/utils/parse_annotation.h"
+#include "util/flat_hash.h"
 
 namespace quarisma
 {
@@ -141,12 +142,51 @@ void parse_and_add_stat_value(
     xevent.add_stat_value(stat_metadata, std::string(value_str));
 }
 
+// Event and stat metadata by name, keyed by views of the names stored in the
+// xplane, so that repeated annotations are resolved without building a string
+class metadata_cache
+{
+public:
+    explicit metadata_cache(xplane_builder& xplane) : xplane_(xplane) {}
+
+    xevent_metadata& event(std::string_view name)
+    {
+        auto const it = events_.find(name);
+        if (it != events_.end())
+        {
+            return *it->second;
+        }
+        xevent_metadata* metadata = xplane_.get_or_create_event_metadata(name);
+        may_add_display_name(metadata);
+        events_.emplace(metadata->name(), metadata);
+        return *metadata;
+    }
+
+    const x_stat_metadata& stat(std::string_view name)
+    {
+        auto const it = stats_.find(name);
+        if (it != stats_.end())
+        {
+            return *it->second;
+        }
+        x_stat_metadata* metadata = xplane_.get_or_create_stat_metadata(name);
+        stats_.emplace(metadata->name(), metadata);
+        return *metadata;
+    }
+
+private:
+    xplane_builder&                                   xplane_;
+    flat_hash_map<std::string_view, xevent_metadata*> events_;
+    flat_hash_map<std::string_view, x_stat_metadata*> stats_;
+};
+
 }  // namespace
 
 void convert_complete_events_to_xplane(
     uint64_t start_timestamp_ns, traceme_recorder::Events&& events, xplane* raw_plane)
 {
     xplane_builder xplane(raw_plane);
+    metadata_cache metadata(xplane);
 
     for (auto& thread : events)
     {
@@ -176,36 +216,24 @@ void convert_complete_events_to_xplane(
             if (!has_metadata(event.name))
             {
                 // Simple event without metadata
-                xevent_metadata* xevent_metadata =
-                    xplane.get_or_create_event_metadata(std::move(event.name));
-                may_add_display_name(xevent_metadata);
-
-                xevent_builder xevent = xline.add_event(*xevent_metadata);
+                xevent_builder xevent = xline.add_event(metadata.event(event.name));
                 xevent.SetTimestampNs(event.start_time);
                 xevent.SetEndTimestampNs(event.end_time);
                 continue;
             }
 
             // Parse annotated event
-            annotation const annot = parse_annotation(event.name);
+            annotation_parser parser(event.name);
 
-            xevent_metadata* xevent_metadata =
-                xplane.get_or_create_event_metadata(std::string(annot.name));
-            may_add_display_name(xevent_metadata);
-
-            xevent_builder xevent = xline.add_event(*xevent_metadata);
+            xevent_builder xevent = xline.add_event(metadata.event(parser.name()));
             xevent.SetTimestampNs(event.start_time);
             xevent.SetEndTimestampNs(event.end_time);
 
-            // Reserve space for metadata stats
-            xevent.reserve_stats(annot.metadata.size());
-
             // Add metadata as stats
-            for (const auto& metadata : annot.metadata)
+            annotation::metadata_entry entry;
+            while (parser.next(entry))
             {
-                x_stat_metadata const* xstat_metadata =
-                    xplane.get_or_create_stat_metadata(std::string(metadata.key));
-                parse_and_add_stat_value(xevent, *xstat_metadata, metadata.value);
+                parse_and_add_stat_value(xevent, metadata.stat(entry.key), entry.value);
             }
         }
     }
@@ -0,0 +1,307 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler/native/cpu/python_sampler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <thread>
+#include <utility>
+
+#include "logging/logger.h"
+#include "profiler/native/cpu/sampling_profiler.h"
+#include "profiler/native/exporters/xplane/xplane_builder.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+#include "profiler/native/tracing/traceme.h"
+
+namespace quarisma::profiler
+{
+namespace
+{
+std::atomic<python_stack_reader> g_python_stack_reader{nullptr};
+
+struct python_sample
+{
+    uint64_t tid     = 0;
+    int64_t  time_ns = 0;
+    uint32_t stack   = 0;  // Index in python_sampler::stacks_
+};
+
+class python_sampler : public profiler_interface
+{
+public:
+    explicit python_sampler(python_sampler_options options) : options_(std::move(options)) {}
+
+    ~python_sampler() override
+    {
+        if (sampler_.joinable())
+        {
+            // NOLINTNEXTLINE(clang-analyzer-optin.cplusplus.VirtualCall)
+            python_sampler::stop();
+        }
+    }
+
+    profiler_status start() override
+    {
+        if (sampler_.joinable())
+        {
+            return profiler_status::Error("Python sampler already started");
+        }
+        reader_ = registered_python_stack_reader();
+        if (reader_ == nullptr)
+        {
+            return profiler_status::Error("No Python stack reader is registered");
+        }
+
+        start_timestamp_ns_ = get_current_time_nanos();
+        running_            = true;
+        sampler_            = std::thread([this]() { sample_loop(); });
+        return profiler_status::Ok();
+    }
+
+    profiler_status stop() override
+    {
+        if (!sampler_.joinable())
+        {
+            return profiler_status::Error("Python sampler not started");
+        }
+        {
+            std::scoped_lock const lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_all();
+        sampler_.join();
+        return profiler_status::Ok();
+    }
+
+    profiler_status collect_data(x_space* space) override
+    {
+        if (sampler_.joinable())
+        {
+            return profiler_status::Error("Python sampler not stopped");
+        }
+        if (samples_.empty() && dropped_ == 0)
+        {
+            return profiler_status::Ok();
+        }
+        xplane* plane = find_or_add_mutable_plane_with_name(space, kHostPythonSamplesPlaneName);
+        if (plane == nullptr)
+        {
+            return profiler_status::Error("Failed to obtain the Python samples XPlane");
+        }
+
+        // Names and folded stacks are built once per distinct stack
+        std::vector<std::string> folded(stacks_.size());
+        for (size_t i = 0; i < stacks_.size(); ++i)
+        {
+            for (auto it = stacks_[i].rbegin(); it != stacks_[i].rend(); ++it)
+            {
+                if (!folded[i].empty())
+                {
+                    folded[i].push_back(';');
+                }
+                folded[i].append(frames_.name(*it));
+            }
+        }
+
+        xplane_builder builder(plane);
+        const auto&    stack_stat = *builder.get_or_create_stat_metadata(kCpuSampleStackStatName);
+        int64_t const  period_ns  = 1000000000LL / std::max<uint32_t>(1, options_.frequency_hz);
+
+        // The builder keeps pointers into the plane's line vector, so each
+        // line is finished before the next one is added
+        std::stable_sort(
+            samples_.begin(),
+            samples_.end(),
+            [](const python_sample& lhs, const python_sample& rhs) { return lhs.tid < rhs.tid; });
+        for (const auto& s : samples_)
+        {
+            xline_builder line = builder.get_or_create_line(static_cast<int64_t>(s.tid));
+            if (line.NumEvents() == 0)
+            {
+                line.SetNameIfEmpty("Python thread " + std::to_string(s.tid));
+                line.SetTimestampNs(static_cast<int64_t>(start_timestamp_ns_));
+            }
+            auto* metadata =
+                builder.get_or_create_event_metadata(frames_.name(stacks_[s.stack].front()));
+            xevent_builder event = line.add_event(*metadata);
+            event.SetTimestampNs(s.time_ns);
+            event.SetDurationNs(period_ns);
+            event.add_stat_value(stack_stat, *builder.get_or_create_stat_metadata(folded[s.stack]));
+        }
+        builder.add_stat_value(*builder.get_or_create_stat_metadata("dropped_samples"), dropped_);
+        builder.add_stat_value(
+            *builder.get_or_create_stat_metadata("python_frames"),
+            static_cast<uint64_t>(frames_.size()));
+
+        samples_.clear();
+        dropped_ = 0;
+        return profiler_status::Ok();
+    }
+
+private:
+    void sample_loop()
+    {
+        auto const period = std::chrono::nanoseconds(
+            1000000000LL / std::max<uint32_t>(1, options_.frequency_hz));
+        auto next = std::chrono::steady_clock::now();
+
+        std::vector<python_thread_stack> current;
+        std::unique_lock<std::mutex>     lock(mutex_);
+        while (running_)
+        {
+            lock.unlock();
+            take_sample(current);
+            lock.lock();
+
+            // Ticks missed while reading are skipped, not made up in a burst
+            next = std::max(next + period, std::chrono::steady_clock::now());
+            wake_.wait_until(lock, next, [this]() { return !running_; });
+        }
+    }
+
+    void take_sample(std::vector<python_thread_stack>& current)
+    {
+        current.clear();
+        try
+        {
+            reader_(frames_, current);
+        }
+        catch (const std::exception& e)
+        {
+            if (!reader_failed_)
+            {
+                QUARISMA_LOG_WARNING("Python stack reader failed: {}", e.what());
+                reader_failed_ = true;
+            }
+            return;
+        }
+
+        int64_t const time_ns = get_current_time_nanos();
+        for (auto& thread : current)
+        {
+            if (thread.frames.empty())
+            {
+                continue;
+            }
+            if (samples_.size() >= options_.max_samples)
+            {
+                ++dropped_;
+                continue;
+            }
+            auto const [it, inserted] =
+                stack_ids_.emplace(thread.frames, static_cast<uint32_t>(stacks_.size()));
+            if (inserted)
+            {
+                stacks_.push_back(thread.frames);
+            }
+            samples_.push_back({thread.tid, time_ns, it->second});
+        }
+    }
+
+    const python_sampler_options options_;
+    python_stack_reader          reader_             = nullptr;
+    uint64_t                     start_timestamp_ns_ = 0;
+
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    std::thread             sampler_;
+    bool                    running_ = false;
+
+    // Written by the sampler thread while running, read once stopped
+    python_frame_table                        frames_;
+    std::map<std::vector<uint32_t>, uint32_t> stack_ids_;
+    std::vector<std::vector<uint32_t>>        stacks_;  // Innermost frame first
+    std::vector<python_sample>                samples_;
+    uint64_t                                  dropped_       = 0;
+    bool                                      reader_failed_ = false;
+};
+
+}  // namespace
+
+// ============================================================================
+// python_frame_table
+// ============================================================================
+
+uint32_t python_frame_table::intern(
+    const void* code, int line, const std::function<python_frame()>& describe)
+{
+    std::scoped_lock const lock(mutex_);
+    auto const [it, inserted] =
+        ids_.emplace(key{code, line}, static_cast<uint32_t>(frames_.size()));
+    if (inserted)
+    {
+        frames_.push_back(describe());
+        frames_.back().line = line;
+    }
+    return it->second;
+}
+
+python_frame python_frame_table::frame(uint32_t id) const
+{
+    std::scoped_lock const lock(mutex_);
+    return frames_.at(id);
+}
+
+std::string python_frame_table::name(uint32_t id) const
+{
+    python_frame const f = frame(id);
+
+    std::string name = f.function + " (" +
+                       f.filename.substr(f.filename.find_last_of("/\\") + 1) + ":" +
+                       std::to_string(f.line) + ")";
+    // ';' separates the frames of a folded stack
+    std::replace(name.begin(), name.end(), ';', ',');
+    return name;
+}
+
+size_t python_frame_table::size() const
+{
+    std::scoped_lock const lock(mutex_);
+    return frames_.size();
+}
+
+// ============================================================================
+// Registration
+// ============================================================================
+
+void register_python_stack_reader(python_stack_reader reader)
+{
+    g_python_stack_reader.store(reader);
+}
+
+python_stack_reader registered_python_stack_reader()
+{
+    return g_python_stack_reader.load();
+}
+
+std::unique_ptr<profiler_interface> create_python_sampler(const python_sampler_options& options)
+{
+    if (options.frequency_hz == 0 || registered_python_stack_reader() == nullptr)
+    {
+        return nullptr;
+    }
+    return std::make_unique<python_sampler>(options);
+}
+
+}  // namespace quarisma::profiler
@@ -0,0 +1,171 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "profiler/native/core/profiler_interface.h"
+#include "util/flat_hash.h"
+
+namespace quarisma
+{
+namespace profiler
+{
+
+/**
+ * @brief A Python code location: a function and the line being executed.
+ */
+struct python_frame
+{
+    std::string filename;
+    std::string function;
+    int         line = 0;
+};
+
+/**
+ * @brief Interns the Python frames seen by the sampler.
+ *
+ * A frame is keyed by its code object and line, so a stack reader turns a
+ * frame it has seen before into an id without touching any string; the
+ * code object only has to be described the first time. The reader must keep
+ * the code objects it interns alive (e.g. by holding a reference) for as long
+ * as the table, since a freed address could be reused by another function.
+ *
+ * **Thread Safety**: Thread-safe.
+ */
+class QUARISMA_VISIBILITY python_frame_table
+{
+public:
+    /**
+     * @brief Id of the frame executing `line` of `code`, described by `describe` if new
+     */
+    QUARISMA_API uint32_t
+    intern(const void* code, int line, const std::function<python_frame()>& describe);
+
+    /** @brief The frame of an id returned by intern(). */
+    QUARISMA_API python_frame frame(uint32_t id) const;
+
+    /** @brief "function (file:line)", without the directories of the file. */
+    QUARISMA_API std::string name(uint32_t id) const;
+
+    QUARISMA_API size_t size() const;
+
+private:
+    struct key
+    {
+        const void* code;
+        int         line;
+
+        bool operator==(const key& other) const noexcept
+        {
+            return code == other.code && line == other.line;
+        }
+    };
+
+    struct key_hash
+    {
+        size_t operator()(const key& k) const noexcept
+        {
+            return std::hash<const void*>()(k.code) * 31 + static_cast<size_t>(k.line);
+        }
+    };
+
+    mutable std::mutex                               mutex_;
+    quarisma::flat_hash_map<key, uint32_t, key_hash> ids_;
+    std::deque<python_frame>                         frames_;  // Indexed by id
+};
+
+/**
+ * @brief The Python stack of one thread at one instant.
+ */
+struct python_thread_stack
+{
+    uint64_t              tid = 0;  ///< OS id of the thread, as in the CPU samples
+    std::vector<uint32_t> frames;   ///< Ids from python_frame_table, innermost first
+};
+
+/**
+ * @brief Reads the current frame stack of every Python thread.
+ *
+ * Called from the sampler thread once per sample. The reader replaces
+ * `stacks` with one entry per thread running Python code, interning the
+ * frames in `frames`. A typical implementation takes the GIL, walks
+ * PyInterpreterState_ThreadHead() and the frames of each thread state, and
+ * releases the GIL: its cost is paid per sample, not per Python call.
+ */
+using python_stack_reader = void (*)(
+    python_frame_table& frames, std::vector<python_thread_stack>& stacks);
+
+/**
+ * @brief Installs the reader of the Python stacks; nullptr removes it.
+ *
+ * Core does not depend on Python: the Python bindings register the reader
+ * when they are loaded, as they do the tracer of python_tracer.h.
+ */
+QUARISMA_API void register_python_stack_reader(python_stack_reader reader);
+
+/** @brief The registered reader, or nullptr. */
+QUARISMA_API python_stack_reader registered_python_stack_reader();
+
+/**
+ * @brief Configuration of the Python sampler.
+ */
+struct python_sampler_options
+{
+    /** Stacks read per second of wall-clock time; 0 disables sampling. */
+    uint32_t frequency_hz = 99;
+
+    /** Samples kept; later ones are counted as dropped. */
+    size_t max_samples = size_t{1} << 20;
+};
+
+/**
+ * @brief Creates a profiler sampling the Python stacks on a timer.
+ *
+ * Unlike the per-call tracing of PyEval_SetProfile, which slows Python-heavy
+ * code several times over, the sampler reads the frame stacks of all
+ * threads frequency_hz times per second from a thread of its own, through the
+ * registered python_stack_reader. Python code runs at full speed in between.
+ * Identical stacks are stored once.
+ *
+ * collect_data() adds the kHostPythonSamplesPlaneName plane in the layout of
+ * the CPU samples plane: one line per thread, one event per sample named
+ * after the innermost frame, with the folded stack in the
+ * kCpuSampleStackStatName stat. When the CPU sampler ran too,
+ * export_folded_stacks() roots each CPU stack in the Python stack its thread
+ * had at that time.
+ *
+ * @return The profiler, or nullptr if options.frequency_hz is 0 or no reader
+ *         is registered
+ */
+QUARISMA_API std::unique_ptr<profiler_interface> create_python_sampler(
+    const python_sampler_options& options);
+
+}  // namespace profiler
+}  // namespace quarisma
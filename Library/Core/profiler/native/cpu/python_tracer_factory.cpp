@@ -37,6 +37,7 @@ limitations under the License.
 #include "profiler/native/core/profiler_factory.h"    // for register_profiler_factory
 #include "profiler/native/core/profiler_interface.h"  // for profiler_interface
 #include "profiler/native/core/profiler_options.h"    // for profile_options
+#include "profiler/native/cpu/python_sampler.h"       // for create_python_sampler
 
 namespace quarisma
 {
@@ -74,6 +75,13 @@ std::unique_ptr<profiler_interface> CreatePythonTracer(const profile_options& pr
     {
         return nullptr;
     }
+    // Per-call tracing is not built in; sampling needs a registered stack reader
+    if (requested_level == 1 && registered_python_stack_reader() != nullptr)
+    {
+        python_sampler_options options;
+        options.frequency_hz = profile_options.python_sampling_frequency_hz();
+        return create_python_sampler(options);
+    }
     return std::make_unique<python_tracer_stub>(requested_level);
 }
 
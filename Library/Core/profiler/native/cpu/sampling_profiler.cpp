@@ -0,0 +1,466 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler/native/cpu/sampling_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "logging/logger.h"
+#include "profiler/common/unwind/unwind.h"
+#include "profiler/native/exporters/xplane/xplane_builder.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+#include "profiler/native/tracing/traceme.h"
+#include "util/flat_hash.h"
+
+#if defined(__linux__) && defined(__x86_64__)
+#define QUARISMA_HAS_CPU_SAMPLING 1
+#include <csignal>
+#include <cerrno>
+
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#else
+#define QUARISMA_HAS_CPU_SAMPLING 0
+#endif
+
+namespace quarisma::profiler
+{
+namespace
+{
+
+// One sample, written by the signal handler into a free slot and moved out by
+// the drain thread, which frees the slot again
+struct sample_slot
+{
+    static constexpr uint32_t kFree    = 0;
+    static constexpr uint32_t kWriting = 1;
+    static constexpr uint32_t kReady   = 2;
+
+    std::atomic<uint32_t> state{kFree};
+    bool                  incomplete = false;
+    size_t                depth      = 0;
+    uint64_t              tid        = 0;
+    int64_t               time_ns    = 0;
+    void*                 frames[kMaxSampledFrames];
+};
+
+struct sample_buffer
+{
+    explicit sample_buffer(size_t capacity)
+        : slots(std::make_unique<sample_slot[]>(capacity)), size(capacity)
+    {
+    }
+
+    std::unique_ptr<sample_slot[]> slots;
+    size_t                         size;
+    std::atomic<size_t>            next{0};
+    std::atomic<uint64_t>          dropped{0};
+};
+
+struct sample
+{
+    uint64_t           tid        = 0;
+    int64_t            time_ns    = 0;
+    bool               incomplete = false;
+    std::vector<void*> frames;  // Innermost first
+};
+
+#if QUARISMA_HAS_CPU_SAMPLING
+
+// Buffer of the running profiler, read by the signal handler
+std::atomic<sample_buffer*> g_sample_buffer{nullptr};
+
+// Signal handlers between their first and last access to g_sample_buffer
+std::atomic<int> g_running_handlers{0};
+
+// Serializes starting and stopping, and guards the handler installation
+std::mutex       g_sampling_mutex;
+bool             g_handler_installed = false;
+struct sigaction g_previous_action;
+
+void record_sample(sample_buffer* buffer, const ucontext_t* context)
+{
+    sample_slot& slot     = buffer->slots[buffer->next.fetch_add(1) % buffer->size];
+    uint32_t     expected = sample_slot::kFree;
+    if (!slot.state.compare_exchange_strong(expected, sample_slot::kWriting))
+    {
+        // The drain thread is behind
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const greg_t* registers = context->uc_mcontext.gregs;
+    slot.tid                = static_cast<uint64_t>(::syscall(SYS_gettid));
+    slot.time_ns            = get_current_time_nanos();
+    slot.depth              = unwind::unwind_from_context(
+        static_cast<uint64_t>(registers[REG_RIP]),
+        static_cast<uint64_t>(registers[REG_RSP]),
+        static_cast<uint64_t>(registers[REG_RBP]),
+        slot.frames,
+        kMaxSampledFrames,
+        &slot.incomplete);
+    slot.state.store(sample_slot::kReady, std::memory_order_release);
+}
+
+void on_sigprof(int /*signal*/, siginfo_t* /*info*/, void* context)
+{
+    int const saved_errno = errno;
+    g_running_handlers.fetch_add(1);
+    if (sample_buffer* buffer = g_sample_buffer.load())
+    {
+        record_sample(buffer, static_cast<const ucontext_t*>(context));
+    }
+    g_running_handlers.fetch_sub(1);
+    errno = saved_errno;
+}
+
+void set_sampling_interval(uint32_t frequency_hz)
+{
+    itimerval timer{};
+    if (frequency_hz > 0)
+    {
+        timer.it_interval.tv_sec  = 0;
+        timer.it_interval.tv_usec = std::max<long>(1, 1000000 / static_cast<long>(frequency_hz));
+        timer.it_value            = timer.it_interval;
+    }
+    ::setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+#endif  // QUARISMA_HAS_CPU_SAMPLING
+
+std::string thread_name(uint64_t tid)
+{
+    std::ifstream file("/proc/self/task/" + std::to_string(tid) + "/comm");
+    std::string   name;
+    if (file && std::getline(file, name) && !name.empty())
+    {
+        return name;
+    }
+    return "Thread " + std::to_string(tid);
+}
+
+// Innermost-first frames to "root;...;leaf", named by `names`
+std::string fold_stack(const sample& s, const quarisma::flat_hash_map<void*, std::string>& names)
+{
+    std::string folded = s.incomplete ? "[incomplete]" : "";
+    for (auto it = s.frames.rbegin(); it != s.frames.rend(); ++it)
+    {
+        if (!folded.empty())
+        {
+            folded.push_back(';');
+        }
+        folded.append(names.find(*it)->second);
+    }
+    return folded;
+}
+
+class sampling_profiler : public profiler_interface
+{
+public:
+    explicit sampling_profiler(sampling_profiler_options options) : options_(std::move(options))
+    {
+    }
+
+    ~sampling_profiler() override
+    {
+        if (buffer_)
+        {
+            // NOLINTNEXTLINE(clang-analyzer-optin.cplusplus.VirtualCall)
+            sampling_profiler::stop();
+        }
+    }
+
+    profiler_status start() override
+    {
+#if QUARISMA_HAS_CPU_SAMPLING
+        if (buffer_)
+        {
+            return profiler_status::Error("Sampling profiler already started");
+        }
+        std::scoped_lock const lock(g_sampling_mutex);
+        if (g_sample_buffer.load() != nullptr)
+        {
+            return profiler_status::Error("Another sampling profiler is running");
+        }
+
+        if (!g_handler_installed)
+        {
+            struct sigaction action{};
+            action.sa_sigaction = &on_sigprof;
+            action.sa_flags     = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            if (::sigaction(SIGPROF, &action, &g_previous_action) != 0)
+            {
+                return profiler_status::Error("Failed to install the SIGPROF handler");
+            }
+            g_handler_installed = true;
+        }
+
+        // Caches the unwind information of the frames around the profiler
+        (void)unwind::unwind();
+
+        buffer_ = std::make_unique<sample_buffer>(std::max<size_t>(1, options_.buffer_samples));
+        start_timestamp_ns_ = get_current_time_nanos();
+        running_            = true;
+        g_sample_buffer.store(buffer_.get());
+        drainer_ = std::thread([this]() { drain_loop(); });
+        set_sampling_interval(options_.frequency_hz);
+        return profiler_status::Ok();
+#else
+        return profiler_status::Error("CPU sampling requires Linux on x86-64");
+#endif
+    }
+
+    profiler_status stop() override
+    {
+#if QUARISMA_HAS_CPU_SAMPLING
+        if (!buffer_)
+        {
+            return profiler_status::Error("Sampling profiler not started");
+        }
+        {
+            std::scoped_lock const lock(g_sampling_mutex);
+            set_sampling_interval(0);
+            g_sample_buffer.store(nullptr);
+            while (g_running_handlers.load() != 0)
+            {
+                std::this_thread::yield();
+            }
+            // A SIGPROF still pending would terminate the process under the
+            // default action: keep the handler, now a no-op, in that case
+            if (g_previous_action.sa_handler != SIG_DFL)
+            {
+                ::sigaction(SIGPROF, &g_previous_action, nullptr);
+                g_handler_installed = false;
+            }
+        }
+        {
+            std::scoped_lock const lock(drain_mutex_);
+            running_ = false;
+        }
+        drain_cv_.notify_all();
+        drainer_.join();
+        drain();
+        dropped_ += buffer_->dropped.load();
+        buffer_.reset();
+        return profiler_status::Ok();
+#else
+        return profiler_status::Error("CPU sampling requires Linux on x86-64");
+#endif
+    }
+
+    profiler_status collect_data(x_space* space) override
+    {
+        if (buffer_)
+        {
+            return profiler_status::Error("Sampling profiler not stopped");
+        }
+        if (samples_.empty() && dropped_ == 0)
+        {
+            return profiler_status::Ok();
+        }
+        xplane* plane = find_or_add_mutable_plane_with_name(space, kHostCpuSamplesPlaneName);
+        if (plane == nullptr)
+        {
+            return profiler_status::Error("Failed to obtain the CPU samples XPlane");
+        }
+
+        auto const     names = symbolize();
+        xplane_builder builder(plane);
+        const auto&    stack_stat = *builder.get_or_create_stat_metadata(kCpuSampleStackStatName);
+        int64_t const  period_ns  = 1000000000LL / std::max<uint32_t>(1, options_.frequency_hz);
+        uint64_t       incomplete = 0;
+
+        // The builder keeps pointers into the plane's line vector, so each
+        // line is finished before the next one is added
+        std::stable_sort(
+            samples_.begin(),
+            samples_.end(),
+            [](const sample& lhs, const sample& rhs) { return lhs.tid < rhs.tid; });
+        for (const auto& s : samples_)
+        {
+            xline_builder line = builder.get_or_create_line(static_cast<int64_t>(s.tid));
+            if (line.NumEvents() == 0)
+            {
+                line.SetNameIfEmpty(thread_name(s.tid));
+                line.SetTimestampNs(static_cast<int64_t>(start_timestamp_ns_));
+            }
+            auto* metadata = builder.get_or_create_event_metadata(names.find(s.frames[0])->second);
+            xevent_builder event = line.add_event(*metadata);
+            event.SetTimestampNs(s.time_ns);
+            event.SetDurationNs(period_ns);
+            event.add_stat_value(
+                stack_stat, *builder.get_or_create_stat_metadata(fold_stack(s, names)));
+            incomplete += s.incomplete ? 1 : 0;
+        }
+        builder.add_stat_value(*builder.get_or_create_stat_metadata("dropped_samples"), dropped_);
+        builder.add_stat_value(
+            *builder.get_or_create_stat_metadata("incomplete_samples"), incomplete);
+
+        samples_.clear();
+        dropped_ = 0;
+        return profiler_status::Ok();
+    }
+
+private:
+    void drain_loop()
+    {
+        std::unique_lock<std::mutex> lock(drain_mutex_);
+        while (!drain_cv_.wait_for(lock, options_.drain_interval, [this]() { return !running_; }))
+        {
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    // Moves the ready samples out of the buffer, and caches the unwind
+    // information where samples stopped early so that later ones get further
+    void drain()
+    {
+        std::vector<void*> missing;
+        for (size_t i = 0; i < buffer_->size; ++i)
+        {
+            sample_slot& slot = buffer_->slots[i];
+            if (slot.state.load(std::memory_order_acquire) != sample_slot::kReady)
+            {
+                continue;
+            }
+            if (slot.depth == 0)
+            {
+                ++dropped_;
+            }
+            else
+            {
+                sample s;
+                s.tid        = slot.tid;
+                s.time_ns    = slot.time_ns;
+                s.incomplete = slot.incomplete;
+                s.frames.assign(slot.frames, slot.frames + slot.depth);
+                if (s.incomplete)
+                {
+                    missing.push_back(s.frames.back());
+                }
+                samples_.push_back(std::move(s));
+            }
+            slot.state.store(sample_slot::kFree, std::memory_order_release);
+        }
+        if (!missing.empty())
+        {
+            std::sort(missing.begin(), missing.end());
+            missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+            unwind::prepare(missing);
+        }
+    }
+
+    // Names every sampled address: its function, else its library and offset
+    quarisma::flat_hash_map<void*, std::string> symbolize() const
+    {
+        quarisma::flat_hash_map<void*, std::string> names;
+        std::vector<void*>                          addrs;
+        for (const auto& s : samples_)
+        {
+            for (void* frame : s.frames)
+            {
+                if (names.emplace(frame, std::string()).second)
+                {
+                    addrs.push_back(frame);
+                }
+            }
+        }
+
+        std::vector<unwind::Frame> frames;
+        try
+        {
+            frames = unwind::symbolize(addrs, unwind::Mode::fast);
+        }
+        catch (const std::exception& e)
+        {
+            QUARISMA_LOG_WARNING("Falling back to dladdr symbolization: {}", e.what());
+            frames = unwind::symbolize(addrs, unwind::Mode::dladdr);
+        }
+
+        for (size_t i = 0; i < addrs.size(); ++i)
+        {
+            std::string& name = names[addrs[i]];
+            if (i < frames.size() && frames[i].funcname != "??")
+            {
+                name = frames[i].funcname;
+                continue;
+            }
+            char offset[32];
+            if (auto library = unwind::libraryFor(addrs[i]))
+            {
+                std::snprintf(
+                    offset,
+                    sizeof(offset),
+                    "+0x%llx",
+                    static_cast<unsigned long long>(library->second));
+                name = library->first.substr(library->first.find_last_of('/') + 1) + offset;
+            }
+            else
+            {
+                std::snprintf(offset, sizeof(offset), "%p", addrs[i]);
+                name = offset;
+            }
+        }
+        return names;
+    }
+
+    const sampling_profiler_options options_;
+
+    std::unique_ptr<sample_buffer> buffer_;
+    uint64_t                       start_timestamp_ns_ = 0;
+
+    std::mutex              drain_mutex_;
+    std::condition_variable drain_cv_;
+    std::thread             drainer_;
+    bool                    running_ = false;
+
+    // Written by the drain thread while running, read once stopped
+    std::vector<sample> samples_;
+    uint64_t            dropped_ = 0;
+};
+
+}  // namespace
+
+std::unique_ptr<profiler_interface> create_sampling_profiler(
+    const sampling_profiler_options& options)
+{
+    if (options.frequency_hz == 0)
+    {
+        return nullptr;
+    }
+    return std::make_unique<sampling_profiler>(options);
+}
+
+}  // namespace quarisma::profiler
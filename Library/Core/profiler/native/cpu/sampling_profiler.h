@@ -0,0 +1,86 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "common/macros.h"
+#include "profiler/native/core/profiler_interface.h"
+
+namespace quarisma
+{
+namespace profiler
+{
+
+/// Deepest stack captured by a sample; deeper stacks keep their innermost frames
+constexpr size_t kMaxSampledFrames = 64;
+
+/// Name of the stat holding the folded stack of a sample, root frame first
+constexpr std::string_view kCpuSampleStackStatName = "stack";
+
+/**
+ * @brief Configuration of the sampling CPU profiler.
+ */
+struct sampling_profiler_options
+{
+    /** Samples per second of CPU time consumed by the process; 0 disables sampling. */
+    uint32_t frequency_hz = 99;
+
+    /** Samples buffered between two drains; samples arriving while it is full are dropped. */
+    size_t buffer_samples = 4096;
+
+    /** Time between two drains of the sample buffer. */
+    std::chrono::milliseconds drain_interval{10};
+};
+
+/**
+ * @brief Creates a profiler sampling the stacks of the threads that use CPU time.
+ *
+ * A SIGPROF interval timer interrupts the thread consuming CPU time,
+ * frequency_hz times per second of process CPU time, and the signal handler
+ * walks the interrupted stack with the unwinder of profiler/common/unwind.
+ * No instrumentation is needed, so this finds hot spots in code without
+ * traceme scopes.
+ *
+ * The handler neither locks nor allocates: it only uses unwind information
+ * that is already cached, and a background thread caches the code addresses
+ * at which samples stopped early. Stacks are therefore complete once the
+ * profiler has warmed up on the hot paths; earlier samples are kept, rooted
+ * in an "[incomplete]" frame.
+ *
+ * collect_data() adds the kHostCpuSamplesPlaneName plane: one line per
+ * thread and one event per sample, named after the innermost function, with
+ * the folded stack in the kCpuSampleStackStatName stat. Write it as a flame
+ * graph with export_folded_stacks().
+ *
+ * Only one sampling profiler runs at a time. Sampling needs Linux on x86-64;
+ * start() fails elsewhere.
+ *
+ * @return The profiler, or nullptr if options.frequency_hz is 0
+ */
+QUARISMA_API std::unique_ptr<profiler_interface> create_sampling_profiler(
+    const sampling_profiler_options& options);
+
+}  // namespace profiler
+}  // namespace quarisma
@@ -0,0 +1,48 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include <memory>
+
+#include "profiler/native/core/profiler_factory.h"
+#include "profiler/native/core/profiler_interface.h"
+#include "profiler/native/core/profiler_options.h"
+#include "profiler/native/cpu/sampling_profiler.h"
+
+namespace quarisma
+{
+namespace profiler
+{
+namespace
+{
+std::unique_ptr<profiler_interface> CreateSamplingProfiler(const profile_options& profile_options)
+{
+    sampling_profiler_options options;
+    options.frequency_hz = profile_options.cpu_sampling_frequency_hz();
+    return create_sampling_profiler(options);
+}
+
+auto register_sampling_profiler_factory = []
+{
+    register_profiler_factory(&CreateSamplingProfiler);
+    return 0;
+}();
+
+}  // namespace
+}  // namespace profiler
+}  // namespace quarisma
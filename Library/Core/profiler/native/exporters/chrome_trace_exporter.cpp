@@ -19,12 +19,21 @@
 
 #include "profiler/native/exporters/chrome_trace_exporter.h"
 
+#include <fmt/format.h>
+
+#include <algorithm>
 #include <fstream>
-#include <sstream>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "logging/logger.h"
+#include "parallel/parallel_tools.h"
+#include "profiler/native/exporters/trace_stream_exporter.h"
 #include "profiler/native/exporters/xplane/xplane.h"
+#include "util/flat_hash.h"
 
 namespace quarisma::profiler
 {
@@ -32,195 +41,360 @@ namespace quarisma::profiler
 namespace
 {
 
+// Events of a line serialized by one task; longer lines are split
+constexpr size_t kEventsPerChunk = 16384;
+
 /**
- * @brief Escape a string for JSON output.
+ * @brief Return the character following the backslash when `c` is escaped in
+ * JSON output, or '\0' when it is written as is.
+ */
+constexpr char json_escape_code(char c)
+{
+    switch (c)
+    {
+    case '"':
+        return '"';
+    case '\\':
+        return '\\';
+    case '/':
+        return '/';
+    case '\b':
+        return 'b';
+    case '\f':
+        return 'f';
+    case '\n':
+        return 'n';
+    case '\r':
+        return 'r';
+    case '\t':
+        return 't';
+    default:
+        return '\0';
+    }
+}
+
+void append(fmt::memory_buffer& out, std::string_view str)
+{
+    out.append(str.data(), str.data() + str.size());
+}
+
+/**
+ * @brief Append `str` escaped for JSON output to `out`.
  *
- * Escapes special characters: ", \, /, \b, \f, \n, \r, \t
+ * Escapes special characters: ", \, /, \b, \f, \n, \r, \t. The runs of
+ * characters between them are copied at once.
  */
-std::string escape_json_string(std::string_view str)
+void append_json_escaped(fmt::memory_buffer& out, std::string_view str)
 {
-    std::string result;
-    result.reserve(str.size());
-
-    for (char const c : str)
-    {
-        switch (c)
-        {
-        case '"':
-            result += "\\\"";
-            break;
-        case '\\':
-            result += "\\\\";
-            break;
-        case '/':
-            result += "\\/";
-            break;
-        case '\b':
-            result += "\\b";
-            break;
-        case '\f':
-            result += "\\f";
-            break;
-        case '\n':
-            result += "\\n";
-            break;
-        case '\r':
-            result += "\\r";
-            break;
-        case '\t':
-            result += "\\t";
-            break;
-        default:
-            result += c;
-            break;
+    size_t run = 0;
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        char const code = json_escape_code(str[i]);
+        if (code != '\0')
+        {
+            out.append(str.data() + run, str.data() + i);
+            out.push_back('\\');
+            out.push_back(code);
+            run = i + 1;
         }
     }
+    out.append(str.data() + run, str.data() + str.size());
+}
 
-    return result;
+/**
+ * @brief Escape a string for JSON output.
+ */
+std::string escape_json_string(std::string_view str)
+{
+    fmt::memory_buffer out;
+    append_json_escaped(out, str);
+    return fmt::to_string(out);
 }
 
 /**
- * @brief Convert xstat value to JSON string.
+ * @brief Append an xstat value as JSON to `out`.
  */
-std::string xstat_value_to_json(const xstat& stat)
+void append_xstat_value(fmt::memory_buffer& out, const xstat& stat)
 {
     switch (stat.value_case())
     {
     case xstat::value_case_type::kInt64Value:
-        return std::to_string(stat.int64_value());
+        fmt::format_to(std::back_inserter(out), "{}", stat.int64_value());
+        break;
     case xstat::value_case_type::kUint64Value:
-        return std::to_string(stat.uint64_value());
+        fmt::format_to(std::back_inserter(out), "{}", stat.uint64_value());
+        break;
     case xstat::value_case_type::kDoubleValue:
-        return std::to_string(stat.double_value());
+        // Fixed notation with six decimals, as std::to_string
+        fmt::format_to(std::back_inserter(out), "{:f}", stat.double_value());
+        break;
     case xstat::value_case_type::kStrValue:
-        return "\"" + escape_json_string(stat.str_value()) + "\"";
+        out.push_back('"');
+        append_json_escaped(out, stat.str_value());
+        out.push_back('"');
+        break;
     case xstat::value_case_type::kRefValue:
-        return std::to_string(stat.ref_value());
+        fmt::format_to(std::back_inserter(out), "{}", stat.ref_value());
+        break;
     default:
-        return "null";
+        append(out, "null");
+        break;
     }
 }
 
-}  // namespace
+/**
+ * @brief Append `base_ns` plus `ps` picoseconds, in nanoseconds, to `out`.
+ *
+ * Written exactly, with up to three decimals; a double would round the
+ * timestamps since the epoch to a few hundred nanoseconds. Falls back to a
+ * double when the sum does not fit in an int64_t.
+ */
+void append_ns(fmt::memory_buffer& out, int64_t base_ns, int64_t ps)
+{
+    int64_t const whole    = ps / 1000;
+    int64_t       fraction = ps % 1000;
+    bool const    overflow = whole > 0 ? base_ns > std::numeric_limits<int64_t>::max() - whole
+                                       : base_ns < std::numeric_limits<int64_t>::min() - whole;
+    int64_t const ns       = overflow ? 0 : base_ns + whole;
+    if (overflow || (fraction != 0 && (ns < 0) != (fraction < 0)))
+    {
+        fmt::format_to(
+            std::back_inserter(out),
+            "{}",
+            static_cast<double>(base_ns) + static_cast<double>(ps) / 1000.0);
+        return;
+    }
 
-std::string export_to_chrome_trace_json(const x_space& space, bool pretty_print)
+    fmt::format_to(std::back_inserter(out), "{}", ns);
+    if (fraction != 0)
+    {
+        fraction   = fraction < 0 ? -fraction : fraction;
+        int digits = 3;
+        while (fraction % 10 == 0)
+        {
+            fraction /= 10;
+            --digits;
+        }
+        fmt::format_to(std::back_inserter(out), ".{:0{}}", fraction, digits);
+    }
+}
+
+/**
+ * @brief Metadata names of a plane, escaped once and shared by its chunks.
+ */
+struct plane_names
 {
-    std::ostringstream json;
-    std::string const  indent  = pretty_print ? "  " : "";
-    std::string const  newline = pretty_print ? "\n" : "";
+    quarisma::flat_hash_map<int64_t, std::string> events;
+    quarisma::flat_hash_map<int64_t, std::string> stats;
+};
+
+/**
+ * @brief Events [first_event, last_event) of a line, serialized into
+ * parts[part]. The first chunk of a line also writes its thread metadata.
+ */
+struct trace_chunk
+{
+    size_t  plane;
+    size_t  line;
+    size_t  first_event;
+    size_t  last_event;
+    size_t  part;
+    int64_t pid;
+};
+
+void write_chunk(
+    fmt::memory_buffer& out,
+    const xplane&       plane,
+    const plane_names&  names,
+    const trace_chunk&  chunk,
+    std::string_view    separator)
+{
+    const auto&   line = plane.lines(static_cast<int>(chunk.line));
+    int64_t const tid  = line.id() > 0 ? line.id() : static_cast<int64_t>(chunk.line + 1);
+    auto          it   = std::back_inserter(out);
+
+    if (chunk.first_event == 0)
+    {
+        fmt::format_to(
+            it,
+            R"({}{{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":")",
+            separator,
+            chunk.pid,
+            tid);
+        append_json_escaped(out, line.name());
+        append(out, "\"}}");
+    }
+
+    const auto& events = line.events();
+    for (size_t i = chunk.first_event; i < chunk.last_event; ++i)
+    {
+        const xevent& event = events[i];
+
+        auto const             name_it = names.events.find(event.metadata_id());
+        std::string_view const name =
+            name_it != names.events.end() ? std::string_view(name_it->second) : "unknown";
+
+        // Duration event (complete); times in nanoseconds (displayTimeUnit: ns).
+        // XPlane stores: timestamp_ns (line base) + offset_ps (event offset)
+        fmt::format_to(
+            it,
+            R"({}{{"name":"{}","ph":"X","pid":{},"tid":{},"ts":)",
+            separator,
+            name,
+            chunk.pid,
+            tid);
+        append_ns(out, line.timestamp_ns(), event.offset_ps());
+        append(out, ",\"dur\":");
+        append_ns(out, 0, event.duration_ps());
+
+        // Add event stats as args
+        if (!event.stats().empty())
+        {
+            append(out, ",\"args\":{");
+            bool first_arg = true;
+            for (const auto& stat : event.stats())
+            {
+                if (!first_arg)
+                {
+                    out.push_back(',');
+                }
+                first_arg = false;
+
+                out.push_back('"');
+                if (auto stat_it = names.stats.find(stat.metadata_id());
+                    stat_it != names.stats.end())
+                {
+                    append(out, stat_it->second);
+                }
+                else
+                {
+                    fmt::format_to(it, "stat_{}", stat.metadata_id());
+                }
+                append(out, "\":");
+                append_xstat_value(out, stat);
+            }
+            out.push_back('}');
+        }
 
-    json << "{" << newline;
-    json << indent << "\"traceEvents\": [" << newline;
+        out.push_back('}');
+    }
+}
+
+/**
+ * @brief Serialize x_space as Chrome Trace Event Format JSON.
+ *
+ * Returns the document as consecutive parts: its head, then for each plane
+ * its process metadata followed by the chunks of its lines, then its tail.
+ * The chunks are serialized concurrently on parallel_tools.
+ */
+std::vector<fmt::memory_buffer> serialize_chrome_trace_json(const x_space& space, bool pretty_print)
+{
+    std::string_view const indent    = pretty_print ? "  " : "";
+    std::string_view const newline   = pretty_print ? "\n" : "";
+    std::string const      separator = fmt::format(",{}{}{}", newline, indent, indent);
 
-    bool first_event = true;
+    const auto&              planes = space.planes();
+    std::vector<plane_names> names(planes.size());
+    std::vector<trace_chunk> chunks;
+    std::vector<size_t>      plane_parts(planes.size());
+    size_t                   parts_size = 1;
 
-    // Iterate through all planes
-    const auto& planes = space.planes();
     for (size_t plane_idx = 0; plane_idx < planes.size(); ++plane_idx)
     {
         const auto&   plane = planes[plane_idx];
         int64_t const pid   = plane.id() > 0 ? plane.id() : static_cast<int64_t>(plane_idx + 1);
 
-        // Add process name metadata event
-        if (!first_event)
+        names[plane_idx].events.reserve(plane.event_metadata().size());
+        for (const auto& [id, metadata] : plane.event_metadata())
         {
-            json << "," << newline;
+            names[plane_idx].events.emplace(id, escape_json_string(metadata.name()));
+        }
+        names[plane_idx].stats.reserve(plane.stat_metadata().size());
+        for (const auto& [id, metadata] : plane.stat_metadata())
+        {
+            names[plane_idx].stats.emplace(id, escape_json_string(metadata.name()));
         }
-        first_event = false;
-
-        json << indent << indent << "{";
-        json << R"("name":"process_name",)";
-        json << R"("ph":"M",)";
-        json << "\"pid\":" << pid << ",";
-        json << R"("args":{"name":")" << escape_json_string(plane.name()) << "\"}";
-        json << "}";
 
-        // Iterate through all lines (threads) in the plane
+        plane_parts[plane_idx] = parts_size++;
         for (size_t line_idx = 0; line_idx < plane.lines_size(); ++line_idx)
         {
-            const auto&   line = plane.lines(line_idx);
-            int64_t const tid  = line.id() > 0 ? line.id() : static_cast<int64_t>(line_idx + 1);
-
-            // Add thread name metadata event
-            json << "," << newline;
-            json << indent << indent << "{";
-            json << R"("name":"thread_name",)";
-            json << R"("ph":"M",)";
-            json << "\"pid\":" << pid << ",";
-            json << "\"tid\":" << tid << ",";
-            json << R"("args":{"name":")" << escape_json_string(line.name()) << "\"}";
-            json << "}";
-
-            // Get event metadata map for name lookup
-            const auto& event_metadata_map = plane.event_metadata();
-            const auto& stat_metadata_map  = plane.stat_metadata();
-
-            // Iterate through all events in the line
-            for (const auto& event : line.events())
+            size_t const n_events = plane.lines(static_cast<int>(line_idx)).events().size();
+            size_t       first    = 0;
+            do
             {
-                json << "," << newline;
-                json << indent << indent << "{";
-
-                // Get event name from metadata
-                std::string event_name = "unknown";
-                if (auto it = event_metadata_map.find(event.metadata_id());
-                    it != event_metadata_map.end())
-                {
-                    event_name = it->second.name();
-                }
-
-                json << R"("name":")" << escape_json_string(event_name) << "\",";
-                json << R"("ph":"X",)";  // Duration event (complete)
-                json << "\"pid\":" << pid << ",";
-                json << "\"tid\":" << tid << ",";
+                size_t const last = std::min(first + kEventsPerChunk, n_events);
+                chunks.push_back({plane_idx, line_idx, first, last, parts_size++, pid});
+                first = last;
+            } while (first < n_events);
+        }
+    }
 
-                // Calculate timestamp in nanoseconds (displayTimeUnit: ns)
-                // XPlane stores: timestamp_ns (line base) + offset_ps (event offset)
-                const auto timestamp_ns = static_cast<double>(line.timestamp_ns()) +
-                                          (static_cast<double>(event.offset_ps()) / 1000.0);
-                json << "\"ts\":" << timestamp_ns << ",";
+    std::vector<fmt::memory_buffer> parts(parts_size + 1);
 
-                // Duration in nanoseconds
-                const auto duration_ns = static_cast<double>(event.duration_ps()) / 1000.0;
-                json << "\"dur\":" << duration_ns;
+    fmt::format_to(
+        std::back_inserter(parts.front()), "{{{}{}\"traceEvents\": [{}", newline, indent, newline);
 
-                // Add event stats as args
-                if (!event.stats().empty())
-                {
-                    json << ",\"args\":{";
-                    bool first_arg = true;
-                    for (const auto& stat : event.stats())
-                    {
-                        if (!first_arg)
-                        {
-                            json << ",";
-                        }
-                        first_arg = false;
-
-                        // Get stat name from metadata
-                        std::string stat_name = "stat_" + std::to_string(stat.metadata_id());
-                        if (auto it = stat_metadata_map.find(stat.metadata_id());
-                            it != stat_metadata_map.end())
-                        {
-                            stat_name = it->second.name();
-                        }
-
-                        json << "\"" << escape_json_string(stat_name)
-                             << "\":" << xstat_value_to_json(stat);
-                    }
-                    json << "}";
-                }
+    for (size_t plane_idx = 0; plane_idx < planes.size(); ++plane_idx)
+    {
+        const auto&   plane = planes[plane_idx];
+        int64_t const pid   = plane.id() > 0 ? plane.id() : static_cast<int64_t>(plane_idx + 1);
+        auto&         out   = parts[plane_parts[plane_idx]];
+
+        // Process name metadata event; the first event of the document has no separator
+        fmt::format_to(
+            std::back_inserter(out),
+            R"({}{{"name":"process_name","ph":"M","pid":{},"args":{{"name":")",
+            plane_idx == 0 ? fmt::format("{}{}", indent, indent) : separator,
+            pid);
+        append_json_escaped(out, plane.name());
+        append(out, "\"}}");
+    }
 
-                json << "}";
+    parallel_tools::parallel_for(
+        0,
+        chunks.size(),
+        1,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const trace_chunk& chunk = chunks[i];
+                write_chunk(
+                    parts[chunk.part], planes[chunk.plane], names[chunk.plane], chunk, separator);
             }
-        }
-    }
+        });
+
+    fmt::format_to(
+        std::back_inserter(parts.back()),
+        "{}{}],{}{}\"displayTimeUnit\": \"ns\"{}}}{}",
+        newline,
+        indent,
+        newline,
+        indent,
+        newline,
+        newline);
+
+    return parts;
+}
 
-    json << newline << indent << "]," << newline;
-    json << indent << R"("displayTimeUnit": "ns")" << newline;
-    json << "}" << newline;
+}  // namespace
+
+std::string export_to_chrome_trace_json(const x_space& space, bool pretty_print)
+{
+    std::vector<fmt::memory_buffer> const parts = serialize_chrome_trace_json(space, pretty_print);
 
-    return json.str();
+    size_t size = 0;
+    for (const auto& part : parts)
+    {
+        size += part.size();
+    }
+    std::string json;
+    json.reserve(size);
+    for (const auto& part : parts)
+    {
+        json.append(part.data(), part.size());
+    }
+    return json;
 }
 
 bool export_to_chrome_trace_json_file(
@@ -228,8 +402,6 @@ bool export_to_chrome_trace_json_file(
 {
     try
     {
-        std::string const json = export_to_chrome_trace_json(space, pretty_print);
-
         std::ofstream file(filename);
         if (!file.is_open())
         {
@@ -237,8 +409,17 @@ bool export_to_chrome_trace_json_file(
             return false;
         }
 
-        file << json;
+        // Written part by part, without a copy of the whole document
+        for (const auto& part : serialize_chrome_trace_json(space, pretty_print))
+        {
+            file.write(part.data(), static_cast<std::streamsize>(part.size()));
+        }
         file.close();
+        if (!file)
+        {
+            QUARISMA_LOG_ERROR("Failed to write Chrome Trace JSON to: {}", filename);
+            return false;
+        }
 
         QUARISMA_LOG_INFO("Exported Chrome Trace JSON to: {}", filename);
         return true;
@@ -250,4 +431,109 @@ bool export_to_chrome_trace_json_file(
     }
 }
 
+bool export_trace_stream_to_chrome_json(std::istream& stream, std::ostream& json)
+{
+    trace_stream_reader reader(stream);
+    if (!reader.valid())
+    {
+        QUARISMA_LOG_ERROR("Not a trace stream, or an unsupported version");
+        return false;
+    }
+
+    struct pending_start
+    {
+        std::string name;
+        int64_t     start_time;
+    };
+    struct pending_end
+    {
+        uint64_t tid;
+        int64_t  end_time;
+    };
+    // Halves of split activities waiting for their other half
+    quarisma::flat_hash_map<int64_t, pending_start> starts;
+    quarisma::flat_hash_map<int64_t, pending_end>   ends;
+
+    json << "{\"traceEvents\": [";
+    json << R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"Host"}})";
+
+    auto write_event = [&](const std::string& name, uint64_t tid, int64_t start, int64_t end)
+    {
+        json << ",\n"
+             << R"({"name":")" << escape_json_string(name) << R"(","ph":"X","pid":1,"tid":)"
+             << tid << ",\"ts\":" << start << ",\"dur\":" << std::max<int64_t>(end - start, 0)
+             << "}";
+    };
+
+    trace_stream_record record;
+    while (reader.next(&record))
+    {
+        if (record.kind == trace_stream_record_kind::kThread)
+        {
+            json << ",\n"
+                 << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << record.tid
+                 << R"(,"args":{"name":")" << escape_json_string(record.name) << "\"}}";
+            continue;
+        }
+        if (record.kind != trace_stream_record_kind::kEvent)
+        {
+            continue;
+        }
+
+        traceme_recorder::Event const event{record.name, record.start_time, record.end_time};
+        if (event.is_complete())
+        {
+            write_event(event.name, record.tid, event.start_time, event.end_time);
+        }
+        else if (event.is_start())
+        {
+            if (auto it = ends.find(event.activity_id()); it != ends.end())
+            {
+                write_event(event.name, it->second.tid, event.start_time, it->second.end_time);
+                ends.erase(it);
+            }
+            else
+            {
+                starts.emplace(event.activity_id(), pending_start{event.name, event.start_time});
+            }
+        }
+        else if (auto it = starts.find(event.activity_id()); it != starts.end())
+        {
+            // Like traceme_recorder::stop(), attribute the activity to its ending thread
+            write_event(it->second.name, record.tid, it->second.start_time, event.end_time);
+            starts.erase(it);
+        }
+        else
+        {
+            ends.emplace(event.activity_id(), pending_end{record.tid, event.end_time});
+        }
+    }
+
+    json << "],\n\"displayTimeUnit\": \"ns\"}\n";
+
+    if (!reader.complete())
+    {
+        QUARISMA_LOG_WARNING("Trace stream is truncated; converted the events before the cut");
+    }
+    return static_cast<bool>(json);
+}
+
+bool export_trace_stream_to_chrome_json_file(
+    const std::string& stream_filename, const std::string& json_filename)
+{
+    std::ifstream stream(stream_filename, std::ios::binary);
+    if (!stream.is_open())
+    {
+        QUARISMA_LOG_ERROR("Failed to open trace stream: {}", stream_filename);
+        return false;
+    }
+    std::ofstream json(json_filename);
+    if (!json.is_open())
+    {
+        QUARISMA_LOG_ERROR("Failed to open file for writing: {}", json_filename);
+        return false;
+    }
+    return export_trace_stream_to_chrome_json(stream, json);
+}
+
 }  // namespace quarisma::profiler
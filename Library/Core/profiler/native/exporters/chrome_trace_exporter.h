@@ -20,6 +20,8 @@
 #ifndef QUARISMA_PROFILER_EXPORTERS_CHROME_TRACE_EXPORTER_H_
 #define QUARISMA_PROFILER_EXPORTERS_CHROME_TRACE_EXPORTER_H_
 
+#include <istream>
+#include <ostream>
 #include <string>
 
 #include "common/macros.h"
@@ -73,7 +75,11 @@ namespace profiler
  * Converts all planes, lines, and events in the x_space to Chrome Trace
  * Event Format JSON that can be viewed in chrome://tracing or Perfetto UI.
  *
- * **Time Units**: All timestamps are in nanoseconds (ns).
+ * **Time Units**: All timestamps are in nanoseconds (ns), written exactly
+ * down to the picosecond.
+ *
+ * The lines are serialized concurrently on parallel_tools, long lines in
+ * several chunks, and the parts are concatenated in order.
  *
  * **Process/Thread Mapping**:
  * - Each XPlane becomes a process (pid)
@@ -99,6 +105,34 @@ QUARISMA_API std::string export_to_chrome_trace_json(const x_space& space, bool
 QUARISMA_API bool export_to_chrome_trace_json_file(
     const x_space& space, const std::string& filename, bool pretty_print = false);
 
+/**
+ * @brief Convert a binary trace stream to Chrome Trace Event Format JSON.
+ *
+ * Reads a stream written by trace_stream_writer and writes the JSON as it
+ * goes, so memory use is bounded by the split activities still waiting for
+ * their other half rather than by the size of the trace. Each recorded thread
+ * becomes a thread of a single "Host" process; split activities are paired on
+ * their activity id and attributed to the thread that ended them. Halves
+ * whose counterpart is missing are dropped, as traceme_recorder::stop() does.
+ *
+ * A truncated stream, e.g. from a crashed capture, is converted up to the cut.
+ *
+ * @param stream Binary trace stream, opened in binary mode
+ * @param json Output for the JSON document
+ * @return false if the stream header is invalid or writing failed
+ */
+QUARISMA_API bool export_trace_stream_to_chrome_json(std::istream& stream, std::ostream& json);
+
+/**
+ * @brief Convert a binary trace stream file to a Chrome Trace Event Format JSON file.
+ *
+ * @param stream_filename File written through make_trace_file_sink()
+ * @param json_filename Output filename (e.g., "trace.json")
+ * @return true if successful, false on error
+ */
+QUARISMA_API bool export_trace_stream_to_chrome_json_file(
+    const std::string& stream_filename, const std::string& json_filename);
+
 }  // namespace profiler
 }  // namespace quarisma
 
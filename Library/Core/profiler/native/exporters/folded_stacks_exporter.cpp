@@ -0,0 +1,191 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler/native/exporters/folded_stacks_exporter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "logging/logger.h"
+#include "profiler/native/cpu/sampling_profiler.h"
+#include "profiler/native/exporters/xplane/xplane_schema.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+
+namespace quarisma::profiler
+{
+namespace
+{
+// A sample of a samples plane, at picoseconds since the epoch
+struct folded_sample
+{
+    int64_t          time_ps;
+    int64_t          duration_ps;
+    std::string_view stack;
+};
+
+// Calls visit(line, sample) for every sample of plane, in the order of the lines
+template <typename Visit>
+void for_each_sample(const xplane& plane, Visit&& visit)
+{
+    const auto& stat_metadata = plane.stat_metadata();
+    int64_t     stack_stat_id = -1;
+    for (const auto& [id, metadata] : stat_metadata)
+    {
+        if (metadata.name() == kCpuSampleStackStatName)
+        {
+            stack_stat_id = id;
+            break;
+        }
+    }
+    for (const auto& line : plane.lines())
+    {
+        for (const auto& event : line.events())
+        {
+            for (const auto& stat : event.stats())
+            {
+                if (stat.metadata_id() != stack_stat_id)
+                {
+                    continue;
+                }
+                if (auto it = stat_metadata.find(stat.ref_value()); it != stat_metadata.end())
+                {
+                    visit(
+                        line,
+                        folded_sample{
+                            line.timestamp_ns() * 1000 + event.offset_ps(),
+                            event.duration_ps(),
+                            it->second.name()});
+                }
+            }
+        }
+    }
+}
+
+// The Python samples of each thread, by time
+std::map<int64_t, std::vector<folded_sample>> python_samples_by_thread(const x_space& space)
+{
+    std::map<int64_t, std::vector<folded_sample>> threads;
+    if (const xplane* plane = find_plane_with_name(space, kHostPythonSamplesPlaneName))
+    {
+        for_each_sample(
+            *plane,
+            [&](const xline& line, const folded_sample& s) { threads[line.id()].push_back(s); });
+    }
+    for (auto& [tid, samples] : threads)
+    {
+        std::sort(
+            samples.begin(),
+            samples.end(),
+            [](const folded_sample& lhs, const folded_sample& rhs)
+            { return lhs.time_ps < rhs.time_ps; });
+    }
+    return threads;
+}
+
+// The Python stack thread `samples` had at time_ps: that of the last Python
+// sample before it, if still within its sampling period
+std::string_view python_stack_at(const std::vector<folded_sample>& samples, int64_t time_ps)
+{
+    auto it = std::upper_bound(
+        samples.begin(),
+        samples.end(),
+        time_ps,
+        [](int64_t t, const folded_sample& s) { return t < s.time_ps; });
+    if (it == samples.begin())
+    {
+        return {};
+    }
+    --it;
+    return time_ps < it->time_ps + it->duration_ps ? it->stack : std::string_view();
+}
+}  // namespace
+
+bool export_folded_stacks(const x_space& space, std::ostream& out)
+{
+    const xplane* cpu    = find_plane_with_name(space, kHostCpuSamplesPlaneName);
+    const xplane* python = find_plane_with_name(space, kHostPythonSamplesPlaneName);
+    if (cpu == nullptr && python == nullptr)
+    {
+        return false;
+    }
+
+    std::map<std::string, uint64_t, std::less<>> counts;
+    if (cpu == nullptr)
+    {
+        for_each_sample(
+            *python, [&](const xline&, const folded_sample& s) { ++counts[std::string(s.stack)]; });
+    }
+    else
+    {
+        // CPU stacks are rooted in the Python stack of their thread, if any
+        auto const python_threads = python_samples_by_thread(space);
+        std::string stack;
+        for_each_sample(
+            *cpu,
+            [&](const xline& line, const folded_sample& s)
+            {
+                stack.clear();
+                if (auto it = python_threads.find(line.id()); it != python_threads.end())
+                {
+                    std::string_view const root = python_stack_at(it->second, s.time_ps);
+                    if (!root.empty())
+                    {
+                        stack.append(root).push_back(';');
+                    }
+                }
+                stack.append(s.stack);
+                auto found = counts.find(stack);
+                if (found == counts.end())
+                {
+                    found = counts.emplace(stack, 0).first;
+                }
+                ++found->second;
+            });
+    }
+
+    for (const auto& [stack, count] : counts)
+    {
+        out << stack << ' ' << count << '\n';
+    }
+    return true;
+}
+
+bool export_folded_stacks_to_file(const x_space& space, const std::string& filename)
+{
+    if (find_plane_with_name(space, kHostCpuSamplesPlaneName) == nullptr &&
+        find_plane_with_name(space, kHostPythonSamplesPlaneName) == nullptr)
+    {
+        return false;
+    }
+    std::ofstream out(filename, std::ios::out | std::ios::binary);
+    if (!out)
+    {
+        QUARISMA_LOG_ERROR("Failed to open folded stacks file for writing: {}", filename);
+        return false;
+    }
+    return export_folded_stacks(space, out) && out.good();
+}
+
+}  // namespace quarisma::profiler
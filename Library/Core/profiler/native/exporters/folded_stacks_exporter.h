@@ -0,0 +1,57 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "common/macros.h"
+#include "profiler/native/exporters/xplane/xplane.h"
+
+namespace quarisma
+{
+namespace profiler
+{
+
+/**
+ * @brief Write the CPU samples of a space as folded stacks.
+ *
+ * Each line holds a distinct stack, root frame first and frames separated by
+ * ';', followed by a space and the number of samples with that stack: the
+ * input format of flamegraph.pl, speedscope and inferno. Lines are sorted by
+ * stack.
+ *
+ * A CPU sample taken while its thread ran Python code, as recorded by the
+ * Python sampler, is rooted in that Python stack. Without CPU samples, the
+ * Python samples are written on their own.
+ *
+ * @return false if the space has neither a kHostCpuSamplesPlaneName nor a
+ *         kHostPythonSamplesPlaneName plane
+ */
+QUARISMA_API bool export_folded_stacks(const x_space& space, std::ostream& out);
+
+/**
+ * @brief Write the CPU samples of a space as folded stacks to a file
+ * @return false if the space has no samples plane or the file cannot be written
+ */
+QUARISMA_API bool export_folded_stacks_to_file(const x_space& space, const std::string& filename);
+
+}  // namespace profiler
+}  // namespace quarisma
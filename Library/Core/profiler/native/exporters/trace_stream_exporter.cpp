@@ -0,0 +1,470 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler/native/exporters/trace_stream_exporter.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "logging/logger.h"
+#include "util/flat_hash.h"
+
+#ifndef _WIN32
+#include <cerrno>
+
+#include <unistd.h>
+#endif
+
+namespace quarisma::profiler
+{
+
+namespace
+{
+
+constexpr char   kMagic[4]         = {'Q', 'T', 'R', 'S'};
+constexpr size_t kRecordHeaderSize = 5;  // kind + payload size
+
+void put_u32(std::string* out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        out->push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+void put_u64(std::string* out, uint64_t value)
+{
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        out->push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+void put_record_header(std::string* out, trace_stream_record_kind kind, size_t payload_size)
+{
+    out->push_back(static_cast<char>(kind));
+    put_u32(out, static_cast<uint32_t>(payload_size));
+}
+
+uint32_t get_u32(const char* data)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i)
+    {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return value;
+}
+
+uint64_t get_u64(const char* data)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return value;
+}
+
+}  // namespace
+
+// =============================================================================
+// Sinks
+// =============================================================================
+
+trace_stream_sink make_trace_file_sink(const std::string& filename)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (file == nullptr)
+    {
+        QUARISMA_LOG_ERROR("Failed to open trace stream file for writing: {}", filename);
+        return {};
+    }
+    std::shared_ptr<std::FILE> const handle(file, [](std::FILE* f) { std::fclose(f); });
+    return [handle](const char* data, size_t size)
+    { return std::fwrite(data, 1, size, handle.get()) == size && std::fflush(handle.get()) == 0; };
+}
+
+trace_stream_sink make_trace_fd_sink(int fd)
+{
+#ifdef _WIN32
+    (void)fd;
+    QUARISMA_LOG_ERROR("File descriptor trace sinks are not supported on Windows");
+    return {};
+#else
+    return [fd](const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t const written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+#endif
+}
+
+// =============================================================================
+// trace_stream_writer
+// =============================================================================
+
+struct trace_stream_writer::Impl
+{
+    Impl(trace_stream_sink sink, trace_stream_options options)
+        : sink_(std::move(sink)), options_(std::move(options))
+    {
+    }
+
+    bool start()
+    {
+        std::scoped_lock const lock(mutex_);
+        if (started_ || !sink_)
+        {
+            return false;
+        }
+        if (!traceme_recorder::start(options_.level, options_.filter_mask))
+        {
+            QUARISMA_LOG_WARNING("trace_stream_writer: a traceme session is already active");
+            return false;
+        }
+        started_ = true;
+
+        buffer_.append(kMagic, sizeof(kMagic));
+        put_u32(&buffer_, kTraceStreamVersion);
+        flush();
+        if (failed_)
+        {
+            traceme_recorder::stop();
+            return false;
+        }
+
+        running_ = true;
+        drainer_ = std::thread([this]() { drain_loop(); });
+        return true;
+    }
+
+    bool stop()
+    {
+        {
+            std::scoped_lock const lock(mutex_);
+            if (!running_)
+            {
+                return false;
+            }
+            running_ = false;
+        }
+        cv_.notify_all();
+        drainer_.join();
+
+        // The remaining events, with the split activities of the last interval paired
+        for (auto& thread_events : traceme_recorder::stop())
+        {
+            for (auto& event : thread_events.events)
+            {
+                encode(thread_events.thread, event);
+            }
+        }
+
+        put_record_header(&buffer_, trace_stream_record_kind::kEnd, 8);
+        put_u64(&buffer_, encoded_events_);
+        flush();
+        drains_.fetch_add(1, std::memory_order_relaxed);
+        return !failed_;
+    }
+
+    bool is_running() const
+    {
+        std::scoped_lock const lock(mutex_);
+        return running_;
+    }
+
+    trace_stream_stats stats() const
+    {
+        trace_stream_stats result;
+        result.events_written = events_written_.load(std::memory_order_relaxed);
+        result.events_dropped = events_dropped_.load(std::memory_order_relaxed);
+        result.bytes_written  = bytes_written_.load(std::memory_order_relaxed);
+        result.drains         = drains_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    void drain_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!cv_.wait_for(lock, options_.flush_interval, [this]() { return !running_; }))
+        {
+            lock.unlock();
+            traceme_recorder::drain(
+                [this](const traceme_recorder::ThreadInfo& thread, traceme_recorder::Event&& event)
+                { encode(thread, event); });
+            flush();
+            drains_.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+        }
+    }
+
+    // encode() and flush() run on the drain thread while recording, and on the
+    // thread calling stop() once the drain thread has exited.
+
+    void encode(const traceme_recorder::ThreadInfo& thread, const traceme_recorder::Event& event)
+    {
+        if (failed_)
+        {
+            events_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (threads_.insert(thread.tid).second)
+        {
+            put_record_header(&buffer_, trace_stream_record_kind::kThread, 8 + thread.name.size());
+            put_u64(&buffer_, thread.tid);
+            buffer_.append(thread.name);
+        }
+
+        uint32_t         name_id = 0;
+        std::string_view inline_name;
+        if (auto it = names_.find(event.name); it != names_.end())
+        {
+            name_id = it->second;
+        }
+        else if (names_.size() < options_.max_interned_names)
+        {
+            name_id = static_cast<uint32_t>(names_.size() + 1);
+            names_.emplace(event.name, name_id);
+            put_record_header(&buffer_, trace_stream_record_kind::kName, 4 + event.name.size());
+            put_u32(&buffer_, name_id);
+            buffer_.append(event.name);
+        }
+        else
+        {
+            inline_name = event.name;
+        }
+
+        put_record_header(&buffer_, trace_stream_record_kind::kEvent, 28 + inline_name.size());
+        put_u64(&buffer_, thread.tid);
+        put_u32(&buffer_, name_id);
+        put_u64(&buffer_, static_cast<uint64_t>(event.start_time));
+        put_u64(&buffer_, static_cast<uint64_t>(event.end_time));
+        buffer_.append(inline_name);
+        ++encoded_events_;
+        ++buffered_events_;
+
+        if (buffer_.size() >= options_.buffer_bytes)
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if (buffer_.empty())
+        {
+            return;
+        }
+        if (!failed_ && sink_(buffer_.data(), buffer_.size()))
+        {
+            bytes_written_.fetch_add(buffer_.size(), std::memory_order_relaxed);
+            events_written_.fetch_add(buffered_events_, std::memory_order_relaxed);
+        }
+        else
+        {
+            if (!failed_)
+            {
+                QUARISMA_LOG_ERROR("trace_stream_writer: sink failed, dropping the trace");
+            }
+            failed_ = true;
+            events_dropped_.fetch_add(buffered_events_, std::memory_order_relaxed);
+        }
+        buffered_events_ = 0;
+        buffer_.clear();
+    }
+
+    trace_stream_sink    sink_;
+    trace_stream_options options_;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable cv_;
+    std::thread             drainer_;
+    bool                    started_ = false;
+    bool                    running_ = false;
+
+    std::string                                    buffer_;
+    quarisma::flat_hash_set<uint64_t>              threads_;
+    quarisma::flat_hash_map<std::string, uint32_t> names_;
+    uint64_t                                       encoded_events_  = 0;
+    uint64_t                                       buffered_events_ = 0;
+    bool                                           failed_          = false;
+
+    std::atomic<uint64_t> events_written_{0};
+    std::atomic<uint64_t> events_dropped_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+    std::atomic<uint64_t> drains_{0};
+};
+
+trace_stream_writer::trace_stream_writer(trace_stream_sink sink, trace_stream_options options)
+    : impl_(std::make_unique<Impl>(std::move(sink), std::move(options)))
+{
+}
+
+trace_stream_writer::~trace_stream_writer()
+{
+    if (impl_->is_running())
+    {
+        impl_->stop();
+    }
+}
+
+bool trace_stream_writer::start()
+{
+    return impl_->start();
+}
+
+bool trace_stream_writer::stop()
+{
+    return impl_->stop();
+}
+
+bool trace_stream_writer::is_running() const
+{
+    return impl_->is_running();
+}
+
+trace_stream_stats trace_stream_writer::stats() const
+{
+    return impl_->stats();
+}
+
+// =============================================================================
+// trace_stream_reader
+// =============================================================================
+
+trace_stream_reader::trace_stream_reader(std::istream& in) : in_(in)
+{
+    char header[8];
+    valid_ = static_cast<bool>(in_.read(header, sizeof(header))) &&
+             std::string_view(header, 4) == std::string_view(kMagic, 4) &&
+             get_u32(header + 4) == kTraceStreamVersion;
+}
+
+bool trace_stream_reader::next(trace_stream_record* record)
+{
+    std::string payload;
+    while (valid_ && !complete_)
+    {
+        char header[kRecordHeaderSize];
+        if (!in_.read(header, sizeof(header)))
+        {
+            return false;
+        }
+        auto const     kind = static_cast<trace_stream_record_kind>(header[0]);
+        uint32_t const size = get_u32(header + 1);
+        payload.resize(size);
+        if (size > 0 && !in_.read(payload.data(), size))
+        {
+            return false;
+        }
+        const char* data = payload.data();
+
+        switch (kind)
+        {
+        case trace_stream_record_kind::kThread:
+            if (size < 8)
+            {
+                return false;
+            }
+            *record      = trace_stream_record{};
+            record->kind = kind;
+            record->tid  = get_u64(data);
+            record->name.assign(data + 8, size - 8);
+            return true;
+
+        case trace_stream_record_kind::kName:
+        {
+            if (size < 4)
+            {
+                return false;
+            }
+            uint32_t const id = get_u32(data);
+            if (id >= names_.size())
+            {
+                names_.resize(id + 1);
+            }
+            names_[id].assign(data + 4, size - 4);
+            break;
+        }
+
+        case trace_stream_record_kind::kEvent:
+        {
+            if (size < 28)
+            {
+                return false;
+            }
+            *record            = trace_stream_record{};
+            record->kind       = kind;
+            record->tid        = get_u64(data);
+            uint32_t const id  = get_u32(data + 8);
+            record->start_time = static_cast<int64_t>(get_u64(data + 12));
+            record->end_time   = static_cast<int64_t>(get_u64(data + 20));
+            if (id == 0)
+            {
+                record->name.assign(data + 28, size - 28);
+            }
+            else if (id < names_.size())
+            {
+                record->name = names_[id];
+            }
+            return true;
+        }
+
+        case trace_stream_record_kind::kEnd:
+            if (size < 8)
+            {
+                return false;
+            }
+            *record             = trace_stream_record{};
+            record->kind        = kind;
+            record->event_count = get_u64(data);
+            complete_           = true;
+            return true;
+
+        default:
+            // Written by a newer version; skip it
+            break;
+        }
+    }
+    return false;
+}
+
+}  // namespace quarisma::profiler
@@ -0,0 +1,240 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#ifndef QUARISMA_PROFILER_EXPORTERS_TRACE_STREAM_EXPORTER_H_
+#define QUARISMA_PROFILER_EXPORTERS_TRACE_STREAM_EXPORTER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "profiler/native/tracing/traceme_recorder.h"
+
+namespace quarisma
+{
+namespace profiler
+{
+
+/**
+ * @brief Streaming binary trace format.
+ *
+ * A stream starts with an 8-byte header -- the magic "QTRS" and a uint32
+ * version -- followed by length-prefixed records:
+ *
+ * | Field    | Type    | Description                       |
+ * |----------|---------|-----------------------------------|
+ * | kind     | uint8   | trace_stream_record_kind          |
+ * | size     | uint32  | Payload size in bytes             |
+ * | payload  | size    | Kind-specific fields              |
+ *
+ * | Kind    | Payload                                                           |
+ * |---------|-------------------------------------------------------------------|
+ * | kThread | uint64 tid, thread name                                           |
+ * | kName   | uint32 name id, event name                                        |
+ * | kEvent  | uint64 tid, uint32 name id, int64 start, int64 end[, inline name] |
+ * | kEnd    | uint64 number of events in the stream                             |
+ *
+ * Integers are little-endian; strings fill the rest of the payload. A thread
+ * record precedes the first event of its thread, and event names are
+ * interned: each distinct name is sent once in a name record and referenced by
+ * id afterwards. Once the intern table is full, name id 0 is written and the
+ * name follows inline. Start and end times use the traceme_recorder::Event
+ * encoding, so the halves of a split activity appear as separate events whose
+ * negative time holds the activity id. Readers skip record kinds they do not
+ * know, and a stream without its kEnd record was cut short.
+ */
+enum class trace_stream_record_kind : uint8_t
+{
+    kThread = 1,
+    kName   = 2,
+    kEvent  = 3,
+    kEnd    = 4
+};
+
+/// Version written in the stream header
+constexpr uint32_t kTraceStreamVersion = 1;
+
+/**
+ * @brief Destination of a trace stream; returns false if the bytes could not be written.
+ */
+using trace_stream_sink = std::function<bool(const char* data, size_t size)>;
+
+/**
+ * @brief Sink writing to a file, truncated on open
+ * @return The sink, or an empty function if the file cannot be opened
+ */
+QUARISMA_API trace_stream_sink make_trace_file_sink(const std::string& filename);
+
+/**
+ * @brief Sink writing to a file descriptor, such as a connected socket or a pipe
+ *
+ * The descriptor is not closed by the sink. Not available on Windows, where
+ * an empty function is returned.
+ */
+QUARISMA_API trace_stream_sink make_trace_fd_sink(int fd);
+
+/**
+ * @brief Configuration of a trace_stream_writer.
+ */
+struct trace_stream_options
+{
+    /** Maximum traceme level recorded. */
+    int level = 1;
+
+    /** traceme filter mask recorded. */
+    uint64_t filter_mask = traceme_recorder::kDefaultTraceFilter;
+
+    /** Time between two drains of the per-thread event queues. */
+    std::chrono::milliseconds flush_interval{100};
+
+    /** Encoded bytes buffered before they are handed to the sink. */
+    size_t buffer_bytes = size_t{1} << 20;
+
+    /** Distinct event names interned; later names are written inline. */
+    size_t max_interned_names = size_t{1} << 16;
+};
+
+/**
+ * @brief Counters of a trace_stream_writer.
+ */
+struct trace_stream_stats
+{
+    uint64_t events_written = 0;  ///< Events accepted by the sink
+    uint64_t events_dropped = 0;  ///< Events lost because the sink failed
+    uint64_t bytes_written  = 0;  ///< Bytes accepted by the sink
+    uint64_t drains         = 0;  ///< Drains of the per-thread queues, periodic or final
+};
+
+/**
+ * @brief Records traceme events straight to a binary stream with bounded memory.
+ *
+ * Starts a traceme_recorder session and, every flush_interval, drains the
+ * per-thread event queues on a background thread, encodes the events and
+ * hands them to the sink whenever buffer_bytes have accumulated. Memory use
+ * is therefore bounded by the events recorded during one interval plus the
+ * buffer and the intern table, however long the capture runs -- unlike
+ * traceme_recorder::stop(), which returns every event of the session at once.
+ *
+ * Convert a stream offline with export_trace_stream_to_chrome_json(), or read
+ * it with trace_stream_reader.
+ *
+ * The writer owns the traceme session between start() and stop(): do not
+ * call traceme_recorder::stop() or run another host tracer meanwhile. If the
+ * sink fails, the writer keeps draining so that memory stays bounded, and
+ * counts the discarded events in events_dropped.
+ *
+ * Example:
+ * ```cpp
+ * trace_stream_writer writer(make_trace_file_sink("capture.qtrs"));
+ * writer.start();
+ * run_workload();
+ * writer.stop();
+ * export_trace_stream_to_chrome_json_file("capture.qtrs", "capture.json");
+ * ```
+ */
+class QUARISMA_VISIBILITY trace_stream_writer
+{
+public:
+    QUARISMA_API explicit trace_stream_writer(
+        trace_stream_sink sink, trace_stream_options options = {});
+
+    /** Stops the capture if still running. */
+    QUARISMA_API ~trace_stream_writer();
+
+    /**
+     * @brief Write the stream header and start recording
+     * @return false if the writer already ran, the sink is empty or failed, or
+     *         another traceme session is active
+     */
+    QUARISMA_API bool start();
+
+    /**
+     * @brief Stop recording, write the remaining events and the end record
+     * @return true if every byte of the stream reached the sink
+     */
+    QUARISMA_API bool stop();
+
+    /** Check whether a capture is running. */
+    QUARISMA_API bool is_running() const;
+
+    /** Get the writer's counters; safe to call while running. */
+    QUARISMA_API trace_stream_stats stats() const;
+
+    trace_stream_writer(const trace_stream_writer&)            = delete;
+    trace_stream_writer& operator=(const trace_stream_writer&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief One record of a trace stream, with interned names resolved.
+ */
+struct trace_stream_record
+{
+    trace_stream_record_kind kind        = trace_stream_record_kind::kEnd;
+    uint64_t                 tid         = 0;  ///< Thread (kThread, kEvent)
+    std::string              name;             ///< Thread name (kThread) or event name (kEvent)
+    int64_t                  start_time  = 0;  ///< Event::start_time encoding (kEvent)
+    int64_t                  end_time    = 0;  ///< Event::end_time encoding (kEvent)
+    uint64_t                 event_count = 0;  ///< Events in the stream (kEnd)
+};
+
+/**
+ * @brief Sequential reader of a trace stream.
+ *
+ * Name records are consumed internally, so next() returns thread, event and
+ * end records only.
+ */
+class QUARISMA_VISIBILITY trace_stream_reader
+{
+public:
+    /** Reads the header; check valid() before calling next(). */
+    QUARISMA_API explicit trace_stream_reader(std::istream& in);
+
+    /** Check whether the header is that of a supported stream. */
+    bool valid() const { return valid_; }
+
+    /** Check whether the end record was read, i.e. the stream is complete. */
+    bool complete() const { return complete_; }
+
+    /**
+     * @brief Read the next record
+     * @return false at the end of the stream or on a truncated or malformed record
+     */
+    QUARISMA_API bool next(trace_stream_record* record);
+
+private:
+    std::istream&            in_;
+    std::vector<std::string> names_;
+    bool                     valid_    = false;
+    bool                     complete_ = false;
+};
+
+}  // namespace profiler
+}  // namespace quarisma
+
+#endif  // QUARISMA_PROFILER_EXPORTERS_TRACE_STREAM_EXPORTER_H_
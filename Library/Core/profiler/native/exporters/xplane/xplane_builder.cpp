@@ -68,9 +68,9 @@ xplane_builder::xplane_builder(xplane* plane)
             stat_metadata_by_name_.emplace(std::string(metadata.name()), &metadata);
         }
     }
-    for (xline& line : *plane->mutable_lines())
+    for (size_t i = 0; i < plane->lines().size(); ++i)
     {
-        lines_by_id_.emplace(line.id(), &line);
+        lines_by_id_.emplace(plane->lines()[i].id(), i);
     }
 }
 
@@ -186,13 +186,12 @@ x_stat_metadata* xplane_builder::get_or_create_stat_metadata(std::string&& name)
 
 xline_builder xplane_builder::get_or_create_line(int64_t line_id)
 {
-    xline*& line = lines_by_id_[line_id];
-    if (line == nullptr)
+    auto const [it, inserted] = lines_by_id_.emplace(line_id, plane_->lines().size());
+    if (inserted)
     {
-        line = plane_->add_lines();
-        line->set_id(line_id);
+        plane_->add_lines()->set_id(line_id);
     }
-    return xline_builder(line, this);
+    return xline_builder(&(*plane_->mutable_lines())[it->second], this);
 }
 
 xevent_builder xline_builder::add_event(const timespan& timespan, const xevent_metadata& metadata)
@@ -618,7 +618,8 @@ private:
     int64_t                                      last_stat_metadata_id_  = 0LL;
     flat_hash_map<std::string, xevent_metadata*> event_metadata_by_name_;
     flat_hash_map<std::string, x_stat_metadata*> stat_metadata_by_name_;
-    flat_hash_map<int64_t, xline*>               lines_by_id_;
+    // Indices, not pointers: adding a line reallocates the plane's lines
+    flat_hash_map<int64_t, size_t>               lines_by_id_;
 };
 
 template <typename T>
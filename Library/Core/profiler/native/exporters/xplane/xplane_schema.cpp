@@ -36,6 +36,7 @@ limitations under the License.
 
 #include <atomic>
 #include <cstdint>
+#include <initializer_list>
 #include <optional>
 #include <string_view>
 #include <type_traits>
@@ -44,6 +45,7 @@ limitations under the License.
 #include "common/macros.h"
 #include "util/exception.h"
 #include "util/flat_hash.h"
+#include "util/startup_tracer.h"
 
 namespace quarisma
 {
@@ -93,6 +95,21 @@ ReverseM ReverseMap(const M& m)
     ReverseMap(m, &reverse);
     return reverse;
 }
+
+// The tables are built on first use, which startup_tracer times
+template <typename M>
+M* NewTable(const char* phase, std::initializer_list<typename M::value_type> entries)
+{
+    const startup_tracer::scope traced(phase);
+    return new M(entries);
+}
+
+template <typename ReverseM, typename M>
+ReverseM* NewReverseTable(const char* phase, const M& m)
+{
+    const startup_tracer::scope traced(phase);
+    return new ReverseM(ReverseMap<ReverseM>(m));
+}
 // Returns a pointer to the const value associated with the given key if it
 // exists, or NULL otherwise.
 template <class Collection>
@@ -143,319 +160,333 @@ using LineIdTypeStrMap        = flat_hash_map<LineIdType, std::string_view>;
 
 const HostEventTypeMap& GetHostEventTypeMap()
 {
-    static auto* host_event_type_map = new HostEventTypeMap({
-        {"UnknownHostEventType", kUnknownHostEventType},
-        {"TraceContext", kTraceContext},
-        {"SessionRun", kSessionRun},
-        {"FunctionRun", kFunctionRun},
-        {"RunGraph", kRunGraph},
-        {"RunGraphDone", kRunGraphDone},
-        {"TfOpRun", kTfOpRun},
-        {"EagerExecute", kEagerKernelExecute},
-        {"ExecutorState::Process", kExecutorStateProcess},
-        {"ExecutorDoneCallback", kExecutorDoneCallback},
-        {"MemoryAllocation", kMemoryAllocation},
-        {"MemoryDeallocation", kMemoryDeallocation},
-        // Performance counter related.
-        {"RemotePerfCounter", kRemotePerf},
-        // tf data captured function events.
-        {"InstantiatedCapturedFunction::Run", kTfDataCapturedFunctionRun},
-        {"InstantiatedCapturedFunction::RunWithBorrowedArgs",
-         kTfDataCapturedFunctionRunWithBorrowedArgs},
-        {"InstantiatedCapturedFunction::RunInstantiated", kTfDataCapturedFunctionRunInstantiated},
-        {"InstantiatedCapturedFunction::RunAsync", kTfDataCapturedFunctionRunAsync},
-        // Loop ops.
-        {"ParallelForOp", kParallelForOp},
-        {"ForeverOp", kForeverOp},
-        {"WhileOp-EvalCond", kWhileOpEvalCond},
-        {"WhileOp-StartBody", kWhileOpStartBody},
-        {"ForOp", kForOp},
-        // tf.data related.
-        {"IteratorGetNextOp::DoCompute", kIteratorGetNextOp},
-        {"IteratorGetNextAsOptionalOp::DoCompute", kIteratorGetNextAsOptionalOp},
-        {"Iterator", kIterator},
-        {"Iterator::Prefetch::Generator", kDeviceInputPipelineSecondIterator},
-        {"PrefetchProduce", kPrefetchProduce},
-        {"PrefetchConsume", kPrefetchConsume},
-        {"ParallelInterleaveProduce", kParallelInterleaveProduce},
-        {"ParallelInterleaveConsume", kParallelInterleaveConsume},
-        {"ParallelInterleaveInitializeInput", kParallelInterleaveInitializedInput},
-        {"ParallelMapProduce", kParallelMapProduce},
-        {"ParallelMapConsume", kParallelMapConsume},
-        {"MapAndBatchProduce", kMapAndBatchProduce},
-        {"MapAndBatchConsume", kMapAndBatchConsume},
-        {"ParseExampleProduce", kParseExampleProduce},
-        {"ParseExampleConsume", kParseExampleConsume},
-        {"ParallelBatchProduce", kParallelBatchProduce},
-        {"ParallelBatchConsume", kParallelBatchConsume},
-        // Batching related.
-        {"BatchingSessionRun", kBatchingSessionRun},
-        {"ProcessBatch", kProcessBatch},
-        {"BrainSessionRun", kBrainSessionRun},
-        {"ConcatInputTensors", kConcatInputTensors},
-        {"MergeInputTensors", kMergeInputTensors},
-        {"ScheduleWithoutSplit", kScheduleWithoutSplit},
-        {"ScheduleWithSplit", kScheduleWithSplit},
-        {"ScheduleWithEagerSplit", kScheduleWithEagerSplit},
-        {"ASBSQueue::Schedule", kASBSQueueSchedule},
-        // TFRT related.
-        {"TfrtModelRun", kTfrtModelRun},
-        // Serving related.
-        {"ServingModelRun", kServingModelRun},
-        // GPU related.
-        {"KernelLaunch", kKernelLaunch},
-        {"KernelExecute", kKernelExecute},
-        // TPU related.
-        {"EnqueueRequestLocked", kEnqueueRequestLocked},
-        {"RunProgramRequest", kRunProgramRequest},
-        {"HostCallbackRequest", kHostCallbackRequest},
-        {"TransferH2DRequest", kTransferH2DRequest},
-        {"TransferPreprocessedH2DRequest", kTransferPreprocessedH2DRequest},
-        {"TransferD2HRequest", kTransferD2HRequest},
-        {"OnDeviceSendRequest", kOnDeviceSendRequest},
-        {"OnDeviceRecvRequest", kOnDeviceRecvRequest},
-        {"OnDeviceSendRecvLocalRequest", kOnDeviceSendRecvLocalRequest},
-        {"CustomWait", kCustomWait},
-        {"OnDeviceSendRequestMulti", kOnDeviceSendRequestMulti},
-        {"OnDeviceRecvRequestMulti", kOnDeviceRecvRequestMulti},
-        {"PjrtAsyncWait", kPjrtAsyncWait},
-        {"DoEnqueueProgram", kDoEnqueueProgram},
-        {"DoEnqueueContinuationProgram", kDoEnqueueContinuationProgram},
-        {"WriteHbm", kWriteHbm},
-        {"ReadHbm", kReadHbm},
-        {"TpuExecuteOp", kTpuExecuteOp},
-        {"CompleteCallbacks", kCompleteCallbacks},
-        {"TPUPartitionedCallOp-InitializeVarOnTPU", kTpuPartitionedCallOpInitializeVarOnTpu},
-        {"TPUPartitionedCallOp-ExecuteRemote", kTpuPartitionedCallOpExecuteRemote},
-        {"TPUPartitionedCallOp-ExecuteLocal", kTpuPartitionedCallOpExecuteLocal},
-        {"Linearize", kLinearize},
-        {"Delinearize", kDelinearize},
-        {"TransferBufferFromDevice-FastPath", kTransferBufferFromDeviceFastPath},
-        {"tpu::System::TransferToDevice=>IssueEvent", kTransferToDeviceIssueEvent},
-        {"tpu::System::TransferToDevice=>IssueEvent=>Done", kTransferToDeviceDone},
-        {"tpu::System::TransferFromDevice=>IssueEvent", kTransferFromDeviceIssueEvent},
-        {"tpu::System::TransferFromDevice=>IssueEvent=>Done", kTransferFromDeviceDone},
-        {"tpu::System::Execute", kTpuSystemExecute},
-    });
+    static auto* host_event_type_map = NewTable<HostEventTypeMap>(
+        "xplane_schema::host_event_types",
+        {
+            {"UnknownHostEventType", kUnknownHostEventType},
+            {"TraceContext", kTraceContext},
+            {"SessionRun", kSessionRun},
+            {"FunctionRun", kFunctionRun},
+            {"RunGraph", kRunGraph},
+            {"RunGraphDone", kRunGraphDone},
+            {"TfOpRun", kTfOpRun},
+            {"EagerExecute", kEagerKernelExecute},
+            {"ExecutorState::Process", kExecutorStateProcess},
+            {"ExecutorDoneCallback", kExecutorDoneCallback},
+            {"MemoryAllocation", kMemoryAllocation},
+            {"MemoryDeallocation", kMemoryDeallocation},
+            // Performance counter related.
+            {"RemotePerfCounter", kRemotePerf},
+            // tf data captured function events.
+            {"InstantiatedCapturedFunction::Run", kTfDataCapturedFunctionRun},
+            {"InstantiatedCapturedFunction::RunWithBorrowedArgs",
+             kTfDataCapturedFunctionRunWithBorrowedArgs},
+            {"InstantiatedCapturedFunction::RunInstantiated",
+             kTfDataCapturedFunctionRunInstantiated},
+            {"InstantiatedCapturedFunction::RunAsync", kTfDataCapturedFunctionRunAsync},
+            // Loop ops.
+            {"ParallelForOp", kParallelForOp},
+            {"ForeverOp", kForeverOp},
+            {"WhileOp-EvalCond", kWhileOpEvalCond},
+            {"WhileOp-StartBody", kWhileOpStartBody},
+            {"ForOp", kForOp},
+            // tf.data related.
+            {"IteratorGetNextOp::DoCompute", kIteratorGetNextOp},
+            {"IteratorGetNextAsOptionalOp::DoCompute", kIteratorGetNextAsOptionalOp},
+            {"Iterator", kIterator},
+            {"Iterator::Prefetch::Generator", kDeviceInputPipelineSecondIterator},
+            {"PrefetchProduce", kPrefetchProduce},
+            {"PrefetchConsume", kPrefetchConsume},
+            {"ParallelInterleaveProduce", kParallelInterleaveProduce},
+            {"ParallelInterleaveConsume", kParallelInterleaveConsume},
+            {"ParallelInterleaveInitializeInput", kParallelInterleaveInitializedInput},
+            {"ParallelMapProduce", kParallelMapProduce},
+            {"ParallelMapConsume", kParallelMapConsume},
+            {"MapAndBatchProduce", kMapAndBatchProduce},
+            {"MapAndBatchConsume", kMapAndBatchConsume},
+            {"ParseExampleProduce", kParseExampleProduce},
+            {"ParseExampleConsume", kParseExampleConsume},
+            {"ParallelBatchProduce", kParallelBatchProduce},
+            {"ParallelBatchConsume", kParallelBatchConsume},
+            // Batching related.
+            {"BatchingSessionRun", kBatchingSessionRun},
+            {"ProcessBatch", kProcessBatch},
+            {"BrainSessionRun", kBrainSessionRun},
+            {"ConcatInputTensors", kConcatInputTensors},
+            {"MergeInputTensors", kMergeInputTensors},
+            {"ScheduleWithoutSplit", kScheduleWithoutSplit},
+            {"ScheduleWithSplit", kScheduleWithSplit},
+            {"ScheduleWithEagerSplit", kScheduleWithEagerSplit},
+            {"ASBSQueue::Schedule", kASBSQueueSchedule},
+            // TFRT related.
+            {"TfrtModelRun", kTfrtModelRun},
+            // Serving related.
+            {"ServingModelRun", kServingModelRun},
+            // GPU related.
+            {"KernelLaunch", kKernelLaunch},
+            {"KernelExecute", kKernelExecute},
+            // TPU related.
+            {"EnqueueRequestLocked", kEnqueueRequestLocked},
+            {"RunProgramRequest", kRunProgramRequest},
+            {"HostCallbackRequest", kHostCallbackRequest},
+            {"TransferH2DRequest", kTransferH2DRequest},
+            {"TransferPreprocessedH2DRequest", kTransferPreprocessedH2DRequest},
+            {"TransferD2HRequest", kTransferD2HRequest},
+            {"OnDeviceSendRequest", kOnDeviceSendRequest},
+            {"OnDeviceRecvRequest", kOnDeviceRecvRequest},
+            {"OnDeviceSendRecvLocalRequest", kOnDeviceSendRecvLocalRequest},
+            {"CustomWait", kCustomWait},
+            {"OnDeviceSendRequestMulti", kOnDeviceSendRequestMulti},
+            {"OnDeviceRecvRequestMulti", kOnDeviceRecvRequestMulti},
+            {"PjrtAsyncWait", kPjrtAsyncWait},
+            {"DoEnqueueProgram", kDoEnqueueProgram},
+            {"DoEnqueueContinuationProgram", kDoEnqueueContinuationProgram},
+            {"WriteHbm", kWriteHbm},
+            {"ReadHbm", kReadHbm},
+            {"TpuExecuteOp", kTpuExecuteOp},
+            {"CompleteCallbacks", kCompleteCallbacks},
+            {"TPUPartitionedCallOp-InitializeVarOnTPU", kTpuPartitionedCallOpInitializeVarOnTpu},
+            {"TPUPartitionedCallOp-ExecuteRemote", kTpuPartitionedCallOpExecuteRemote},
+            {"TPUPartitionedCallOp-ExecuteLocal", kTpuPartitionedCallOpExecuteLocal},
+            {"Linearize", kLinearize},
+            {"Delinearize", kDelinearize},
+            {"TransferBufferFromDevice-FastPath", kTransferBufferFromDeviceFastPath},
+            {"tpu::System::TransferToDevice=>IssueEvent", kTransferToDeviceIssueEvent},
+            {"tpu::System::TransferToDevice=>IssueEvent=>Done", kTransferToDeviceDone},
+            {"tpu::System::TransferFromDevice=>IssueEvent", kTransferFromDeviceIssueEvent},
+            {"tpu::System::TransferFromDevice=>IssueEvent=>Done", kTransferFromDeviceDone},
+            {"tpu::System::Execute", kTpuSystemExecute},
+        });
     QUARISMA_CHECK_DEBUG(host_event_type_map->size() == kNumHostEventTypes);
     return *host_event_type_map;
 }
 
 const StatTypeMap& GetStatTypeMap()
 {
-    static auto* stat_type_map = new StatTypeMap(
-        {{"UnknownStatType", kUnknownStatType},
-         // TraceMe arguments.
-         {"id", kStepId},
-         {"device_ordinal", kDeviceOrdinal},
-         {"chip_ordinal", kChipOrdinal},
-         {"node_ordinal", kNodeOrdinal},
-         {"model_id", kModelId},
-         {"queue_addr", kQueueAddr},
-         {"queue_id", kQueueId},
-         {"request_id", kRequestId},
-         {"run_id", kRunId},
-         {"replica_id", kReplicaId},
-         {"graph_type", kGraphType},
-         {"step_num", kStepNum},
-         {"iter_num", kIterNum},
-         {"index_on_host", kIndexOnHost},
-         {"allocator_name", kAllocatorName},
-         {"bytes_reserved", kBytesReserved},
-         {"bytes_allocated", kBytesAllocated},
-         {"bytes_available", kBytesAvailable},
-         {"fragmentation", kFragmentation},
-         {"peak_bytes_in_use", kPeakBytesInUse},
-         {"requested_bytes", kRequestedBytes},
-         {"allocation_bytes", kAllocationBytes},
-         {"addr", kAddress},
-         {"region_type", kRegionType},
-         {"data_type", kDataType},
-         {"shape", kTensorShapes},
-         {"layout", kTensorLayout},
-         {"kpi_name", kKpiName},
-         {"kpi_value", kKpiValue},
-         {"element_id", kElementId},
-         {"parent_id", kParentId},
-         {"core_type", kCoreType},
-         // XPlane semantics related.
-         {"_pt", kProducerType},
-         {"_ct", kConsumerType},
-         {"_p", kProducerId},
-         {"_c", kConsumerId},
-         {"_r", kIsRoot},
-         {"_a", kIsAsync},
-         // device_option trace arguments.
-         {"device_id", kDeviceId},
-         {"device_type_string", kDeviceTypeString},
-         {"context_id", kContextId},
-         {"correlation_id", kCorrelationId},
-         {"memcpy_details", kMemcpyDetails},
-         {"memalloc_details", kMemallocDetails},
-         {"MemFree_details", kMemFreeDetails},
-         {"Memset_details", kMemsetDetails},
-         {"MemoryResidency_details", kMemoryResidencyDetails},
-         {"kernel_details", kKernelDetails},
-         {"nvtx_range", kNVTXRange},
-         {"stream", kStream},
-         // Stats added when processing traces.
-         {"group_id", kGroupId},
-         {"flow", kFlow},
-         {"step_name", kStepName},
-         {"tf_op", kTfOp},
-         {"hlo_op", kHloOp},
-         {"deduplicated_name", kDeduplicatedName},
-         {"hlo_category", kHloCategory},
-         {"hlo_module", kHloModule},
-         {"program_id", kProgramId},
-         {"equation", kEquation},
-         {"is_eager", kIsEager},
-         {"is_func", kIsFunc},
-         {"tf_function_call", kTfFunctionCall},
-         {"tracing_count", kTfFunctionTracingCount},
-         {"flops", kFlops},
-         {"model_flops", kModelFlops},
-         {"bytes_accessed", kBytesAccessed},
-         {"memory_access_breakdown", kMemoryAccessBreakdown},
-         {"source", kSourceInfo},
-         {"model_name", kModelName},
-         {"model_version", kModelVersion},
-         {"bytes_transferred", kBytesTransferred},
-         {"queue", kDmaQueue},
-         {"dcn_collective_info", kDcnCollectiveInfo},
-         // Performance counter related.
-         {"Raw Value", kRawValue},
-         {"Scaled Value", kScaledValue},
-         {"Thread Id", kThreadId},
-         {"matrix_unit_utilization_percent", kMatrixUnitUtilizationPercent},
-         // XLA metadata map related.
-         {"Hlo Proto", kHloProto},
-         {"EdgeTPU Model information", kEdgeTpuModelInfo},
-         {"EdgeTPU Model Profile information", kEdgeTpuModelProfileInfo},
-         {"EdgeTPU MLIR", kEdgeTpuMlir},
-         // device_option capability related.
-         {"clock_rate", kDevCapClockRateKHz},
-         {"core_count", kDevCapCoreCount},
-         {"memory_bandwidth", kDevCapMemoryBandwidth},
-         {"memory_size", kDevCapMemorySize},
-         {"compute_cap_major", kDevCapComputeCapMajor},
-         {"compute_cap_minor", kDevCapComputeCapMinor},
-         {"peak_teraflops_per_second", kDevCapPeakTeraflopsPerSecond},
-         {"peak_hbm_bw_gigabytes_per_second", kDevCapPeakHbmBwGigabytesPerSecond},
-         {"peak_sram_rd_bw_gigabytes_per_second", kDevCapPeakSramRdBwGigabytesPerSecond},
-         {"peak_sram_wr_bw_gigabytes_per_second", kDevCapPeakSramWrBwGigabytesPerSecond},
-         {"device_vendor", kDevVendor},
-         // Batching related.
-         {"batch_size_after_padding", kBatchSizeAfterPadding},
-         {"padding_amount", kPaddingAmount},
-         {"batching_input_task_size", kBatchingInputTaskSize},
-         // GPU related metrics.
-         {"theoretical_occupancy_pct", kTheoreticalOccupancyPct},
-         {"occupancy_min_grid_size", kOccupancyMinGridSize},
-         {"occupancy_suggested_block_size", kOccupancySuggestedBlockSize},
-         // Aggregated Stat
-         {"self_duration_ps", kSelfDurationPs},
-         {"min_duration_ps", kMinDurationPs},
-         {"total_profile_duration_ps", kTotalProfileDurationPs},
-         {"max_iteration_num", kMaxIterationNum},
-         {"device_type", kDeviceType},
-         {"uses_megacore", kUsesMegaCore},
-         {"symbol_id", kSymbolId},
-         {"hlo_category", kHloCategory},
-         {"tf_op_name", kTfOpName},
-         {"dma_stall_duration_ps", kDmaStallDurationPs},
-         {"key", kKey},
-         {"payload_size_bytes", kPayloadSizeBytes},
-         {"duration_us", kDuration},
-         {"buffer_size", kBufferSize},
-         {"transfers", kTransfers},
-         // Dcn message Stats
-         {"dcn_label", kDcnLabel},
-         {"dcn_source_slice_id", kDcnSourceSliceId},
-         {"dcn_source_per_slice_device_id", kDcnSourcePerSliceDeviceId},
-         {"dcn_destination_slice_id", kDcnDestinationSliceId},
-         {"dcn_destination_per_slice_device_id", kDcnDestinationPerSliceDeviceId},
-         {"dcn_chunk", kDcnChunk},
-         {"dcn_loop_index", kDcnLoopIndex},
-         {"dropped_traces", kDroppedTraces},
-         {"cuda_graph_id", kCudaGraphId},
-         {"cuda_graph_exec_id", kCudaGraphExecId},
-         {"cuda_graph_orig_id", kCudaGraphOrigId},
-         {"step_idle_time_ps", kStepIdleTimePs},
-         {"gpu_device_name", kGpuDeviceName},
-         {"source_stack", kSourceStack},
-         {"device_offset_ps", kDeviceOffsetPs},
-         {"device_duration_ps", kDeviceDurationPs}});
+    static auto* stat_type_map = NewTable<StatTypeMap>(
+        "xplane_schema::stat_types",
+        {
+            {"UnknownStatType", kUnknownStatType},
+            // TraceMe arguments.
+            {"id", kStepId},
+            {"device_ordinal", kDeviceOrdinal},
+            {"chip_ordinal", kChipOrdinal},
+            {"node_ordinal", kNodeOrdinal},
+            {"model_id", kModelId},
+            {"queue_addr", kQueueAddr},
+            {"queue_id", kQueueId},
+            {"request_id", kRequestId},
+            {"run_id", kRunId},
+            {"replica_id", kReplicaId},
+            {"graph_type", kGraphType},
+            {"step_num", kStepNum},
+            {"iter_num", kIterNum},
+            {"index_on_host", kIndexOnHost},
+            {"allocator_name", kAllocatorName},
+            {"bytes_reserved", kBytesReserved},
+            {"bytes_allocated", kBytesAllocated},
+            {"bytes_available", kBytesAvailable},
+            {"fragmentation", kFragmentation},
+            {"peak_bytes_in_use", kPeakBytesInUse},
+            {"requested_bytes", kRequestedBytes},
+            {"allocation_bytes", kAllocationBytes},
+            {"addr", kAddress},
+            {"region_type", kRegionType},
+            {"data_type", kDataType},
+            {"shape", kTensorShapes},
+            {"layout", kTensorLayout},
+            {"kpi_name", kKpiName},
+            {"kpi_value", kKpiValue},
+            {"element_id", kElementId},
+            {"parent_id", kParentId},
+            {"core_type", kCoreType},
+            // XPlane semantics related.
+            {"_pt", kProducerType},
+            {"_ct", kConsumerType},
+            {"_p", kProducerId},
+            {"_c", kConsumerId},
+            {"_r", kIsRoot},
+            {"_a", kIsAsync},
+            // device_option trace arguments.
+            {"device_id", kDeviceId},
+            {"device_type_string", kDeviceTypeString},
+            {"context_id", kContextId},
+            {"correlation_id", kCorrelationId},
+            {"memcpy_details", kMemcpyDetails},
+            {"memalloc_details", kMemallocDetails},
+            {"MemFree_details", kMemFreeDetails},
+            {"Memset_details", kMemsetDetails},
+            {"MemoryResidency_details", kMemoryResidencyDetails},
+            {"kernel_details", kKernelDetails},
+            {"nvtx_range", kNVTXRange},
+            {"stream", kStream},
+            // Stats added when processing traces.
+            {"group_id", kGroupId},
+            {"flow", kFlow},
+            {"step_name", kStepName},
+            {"tf_op", kTfOp},
+            {"hlo_op", kHloOp},
+            {"deduplicated_name", kDeduplicatedName},
+            {"hlo_category", kHloCategory},
+            {"hlo_module", kHloModule},
+            {"program_id", kProgramId},
+            {"equation", kEquation},
+            {"is_eager", kIsEager},
+            {"is_func", kIsFunc},
+            {"tf_function_call", kTfFunctionCall},
+            {"tracing_count", kTfFunctionTracingCount},
+            {"flops", kFlops},
+            {"model_flops", kModelFlops},
+            {"bytes_accessed", kBytesAccessed},
+            {"memory_access_breakdown", kMemoryAccessBreakdown},
+            {"source", kSourceInfo},
+            {"model_name", kModelName},
+            {"model_version", kModelVersion},
+            {"bytes_transferred", kBytesTransferred},
+            {"queue", kDmaQueue},
+            {"dcn_collective_info", kDcnCollectiveInfo},
+            // Performance counter related.
+            {"Raw Value", kRawValue},
+            {"Scaled Value", kScaledValue},
+            {"Thread Id", kThreadId},
+            {"matrix_unit_utilization_percent", kMatrixUnitUtilizationPercent},
+            // XLA metadata map related.
+            {"Hlo Proto", kHloProto},
+            {"EdgeTPU Model information", kEdgeTpuModelInfo},
+            {"EdgeTPU Model Profile information", kEdgeTpuModelProfileInfo},
+            {"EdgeTPU MLIR", kEdgeTpuMlir},
+            // device_option capability related.
+            {"clock_rate", kDevCapClockRateKHz},
+            {"core_count", kDevCapCoreCount},
+            {"memory_bandwidth", kDevCapMemoryBandwidth},
+            {"memory_size", kDevCapMemorySize},
+            {"compute_cap_major", kDevCapComputeCapMajor},
+            {"compute_cap_minor", kDevCapComputeCapMinor},
+            {"peak_teraflops_per_second", kDevCapPeakTeraflopsPerSecond},
+            {"peak_hbm_bw_gigabytes_per_second", kDevCapPeakHbmBwGigabytesPerSecond},
+            {"peak_sram_rd_bw_gigabytes_per_second", kDevCapPeakSramRdBwGigabytesPerSecond},
+            {"peak_sram_wr_bw_gigabytes_per_second", kDevCapPeakSramWrBwGigabytesPerSecond},
+            {"device_vendor", kDevVendor},
+            // Batching related.
+            {"batch_size_after_padding", kBatchSizeAfterPadding},
+            {"padding_amount", kPaddingAmount},
+            {"batching_input_task_size", kBatchingInputTaskSize},
+            // GPU related metrics.
+            {"theoretical_occupancy_pct", kTheoreticalOccupancyPct},
+            {"occupancy_min_grid_size", kOccupancyMinGridSize},
+            {"occupancy_suggested_block_size", kOccupancySuggestedBlockSize},
+            {"achieved_occupancy_pct", kAchievedOccupancyPct},
+            {"dram_throughput_pct", kDramThroughputPct},
+            {"sm_efficiency_pct", kSmEfficiencyPct},
+            {"l2_hit_rate_pct", kL2HitRatePct},
+            // Aggregated Stat
+            {"self_duration_ps", kSelfDurationPs},
+            {"min_duration_ps", kMinDurationPs},
+            {"total_profile_duration_ps", kTotalProfileDurationPs},
+            {"max_iteration_num", kMaxIterationNum},
+            {"device_type", kDeviceType},
+            {"uses_megacore", kUsesMegaCore},
+            {"symbol_id", kSymbolId},
+            {"hlo_category", kHloCategory},
+            {"tf_op_name", kTfOpName},
+            {"dma_stall_duration_ps", kDmaStallDurationPs},
+            {"key", kKey},
+            {"payload_size_bytes", kPayloadSizeBytes},
+            {"duration_us", kDuration},
+            {"buffer_size", kBufferSize},
+            {"transfers", kTransfers},
+            // Dcn message Stats
+            {"dcn_label", kDcnLabel},
+            {"dcn_source_slice_id", kDcnSourceSliceId},
+            {"dcn_source_per_slice_device_id", kDcnSourcePerSliceDeviceId},
+            {"dcn_destination_slice_id", kDcnDestinationSliceId},
+            {"dcn_destination_per_slice_device_id", kDcnDestinationPerSliceDeviceId},
+            {"dcn_chunk", kDcnChunk},
+            {"dcn_loop_index", kDcnLoopIndex},
+            {"dropped_traces", kDroppedTraces},
+            {"cuda_graph_id", kCudaGraphId},
+            {"cuda_graph_exec_id", kCudaGraphExecId},
+            {"cuda_graph_orig_id", kCudaGraphOrigId},
+            {"step_idle_time_ps", kStepIdleTimePs},
+            {"gpu_device_name", kGpuDeviceName},
+            {"source_stack", kSourceStack},
+            {"device_offset_ps", kDeviceOffsetPs},
+            {"device_duration_ps", kDeviceDurationPs},
+        });
     QUARISMA_CHECK_DEBUG(stat_type_map->size() == kNumStatTypes);
     return *stat_type_map;
 }
 
 const MegaScaleStatTypeMap& GetMegaScaleStatTypeMap()
 {
-    static auto* stat_type_map = new MegaScaleStatTypeMap({
-        {"graph_key", kMegaScaleGraphKey},
-        {"local_device_id", kMegaScaleLocalDeviceId},
-        {"num_actions", kMegaScaleNumActions},
-        {"collective_type", kMegaScaleCollectiveType},
-        {"input_size", kMegaScaleInputSize},
-        {"slack_us", kMegaScaleSlackUs},
-        {"action_type", kMegaScaleActionType},
-        {"start_end_type", kMegaScaleStartEndType},
-        {"action_index", kMegaScaleActionIndex},
-        {"action_duration_ns", kMegaScaleActionDurationNs},
-        {"action_inputs", kMegaScaleActionInputs},
-        {"transfer_source", kMegaScaleTransferSource},
-        {"transfer_destinations", kMegaScaleTransferDestinations},
-        {"buffer_sizes", kMegaScaleBufferSizes},
-        {"compute_operation", kMegaScaleComputeOperation},
-        {"chunk", kMegaScaleChunk},
-        {"launch_id", kMegaScaleLaunchId},
-        {"loop_iteration", kMegaScaleLoopIteration},
-        {"transmission_budget_us", kMegaScaleTransmissionBudgetUs},
-        {"delay_budget_us", kMegaScaleDelayBudgetUs},
-        {"graph_protos", kMegaScaleGraphProtos},
-        {"network_transport_latency_us", kMegaScaleNetworkTransportLatency},
-    });
+    static auto* stat_type_map = NewTable<MegaScaleStatTypeMap>(
+        "xplane_schema::mega_scale_stat_types",
+        {
+            {"graph_key", kMegaScaleGraphKey},
+            {"local_device_id", kMegaScaleLocalDeviceId},
+            {"num_actions", kMegaScaleNumActions},
+            {"collective_type", kMegaScaleCollectiveType},
+            {"input_size", kMegaScaleInputSize},
+            {"slack_us", kMegaScaleSlackUs},
+            {"action_type", kMegaScaleActionType},
+            {"start_end_type", kMegaScaleStartEndType},
+            {"action_index", kMegaScaleActionIndex},
+            {"action_duration_ns", kMegaScaleActionDurationNs},
+            {"action_inputs", kMegaScaleActionInputs},
+            {"transfer_source", kMegaScaleTransferSource},
+            {"transfer_destinations", kMegaScaleTransferDestinations},
+            {"buffer_sizes", kMegaScaleBufferSizes},
+            {"compute_operation", kMegaScaleComputeOperation},
+            {"chunk", kMegaScaleChunk},
+            {"launch_id", kMegaScaleLaunchId},
+            {"loop_iteration", kMegaScaleLoopIteration},
+            {"transmission_budget_us", kMegaScaleTransmissionBudgetUs},
+            {"delay_budget_us", kMegaScaleDelayBudgetUs},
+            {"graph_protos", kMegaScaleGraphProtos},
+            {"network_transport_latency_us", kMegaScaleNetworkTransportLatency},
+        });
     QUARISMA_CHECK_DEBUG(stat_type_map->size() == kNumMegaScaleStatTypes);
     return *stat_type_map;
 }
 
 const LineIdTypeMap& GetLineIdTypeMap()
 {
-    static auto* line_id_type_map = new LineIdTypeMap({
-        {"UnknownLineIdType", kUnknownLineIdType},
-        {"DcnHostTraffic", kDcnHostTraffic},
-        {"DcnCollectiveTraffic", kDcnCollectiveTraffic},
-    });
+    static auto* line_id_type_map = NewTable<LineIdTypeMap>(
+        "xplane_schema::line_id_types",
+        {
+            {"UnknownLineIdType", kUnknownLineIdType},
+            {"DcnHostTraffic", kDcnHostTraffic},
+            {"DcnCollectiveTraffic", kDcnCollectiveTraffic},
+        });
     QUARISMA_CHECK_DEBUG(line_id_type_map->size() == kNumLineIdTypes);
     return *line_id_type_map;
 }
 
 const HostEventTypeStrMap& GetHostEventTypeStrMap()
 {
-    static auto* host_event_type_str_map =
-        new HostEventTypeStrMap(ReverseMap<HostEventTypeStrMap>(GetHostEventTypeMap()));
+    static auto* host_event_type_str_map = NewReverseTable<HostEventTypeStrMap>(
+        "xplane_schema::host_event_type_names", GetHostEventTypeMap());
     return *host_event_type_str_map;
 }
 
 const StatTypeStrMap& GetStatTypeStrMap()
 {
-    static auto* stat_type_str_map =
-        new StatTypeStrMap(ReverseMap<StatTypeStrMap>(GetStatTypeMap()));
+    static auto* stat_type_str_map = NewReverseTable<StatTypeStrMap>(
+        "xplane_schema::stat_type_names", GetStatTypeMap());
     return *stat_type_str_map;
 }
 
 const MegaScaleStatTypeStrMap& GetMegaScaleStatTypeStrMap()
 {
-    static auto* stat_type_str_map =
-        new MegaScaleStatTypeStrMap(ReverseMap<MegaScaleStatTypeStrMap>(GetMegaScaleStatTypeMap()));
+    static auto* stat_type_str_map = NewReverseTable<MegaScaleStatTypeStrMap>(
+        "xplane_schema::mega_scale_stat_type_names", GetMegaScaleStatTypeMap());
     return *stat_type_str_map;
 }
 
 [[maybe_unused]] const LineIdTypeStrMap& GetLineIdTypeStrMap()
 {
-    static auto* line_id_type_str_map =
-        new LineIdTypeStrMap(ReverseMap<LineIdTypeStrMap>(GetLineIdTypeMap()));
+    static auto* line_id_type_str_map = NewReverseTable<LineIdTypeStrMap>(
+        "xplane_schema::line_id_type_names", GetLineIdTypeMap());
     return *line_id_type_str_map;
 }
 
@@ -467,18 +498,20 @@ QUARISMA_UNUSED constexpr int kNumTaskEnvStatTypes =
 
 const TaskEnvStatTypeMap& GetTaskEnvStatTypeMap()
 {
-    static auto* task_env_stat_type_map = new TaskEnvStatTypeMap({
-        {"profile_start_time", kEnvProfileStartTime},
-        {"profile_stop_time", kEnvProfileStopTime},
-    });
+    static auto* task_env_stat_type_map = NewTable<TaskEnvStatTypeMap>(
+        "xplane_schema::task_env_stat_types",
+        {
+            {"profile_start_time", kEnvProfileStartTime},
+            {"profile_stop_time", kEnvProfileStopTime},
+        });
     QUARISMA_CHECK_DEBUG(task_env_stat_type_map->size() == kNumTaskEnvStatTypes);
     return *task_env_stat_type_map;
 }
 
 const TaskEnvStatTypeStrMap& GetTaskEnvStatTypeStrMap()
 {
-    static auto* task_env_stat_type_str_map =
-        new TaskEnvStatTypeStrMap(ReverseMap<TaskEnvStatTypeStrMap>(GetTaskEnvStatTypeMap()));
+    static auto* task_env_stat_type_str_map = NewReverseTable<TaskEnvStatTypeStrMap>(
+        "xplane_schema::task_env_stat_type_names", GetTaskEnvStatTypeMap());
     return *task_env_stat_type_str_map;
 }
 
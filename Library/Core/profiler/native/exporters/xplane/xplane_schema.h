@@ -186,14 +186,16 @@ constexpr char             kSparseCorePlaneRegex[]    = {"/device:TPU:[0-9]+ Spa
 // migrated.
 constexpr std::string_view kCustomPlanePrefix = "/device:CUSTOM:";
 
-constexpr std::string_view kTpuRuntimePlaneName     = "/host:TPU-runtime";
-constexpr std::string_view kCuptiDriverApiPlaneName = "/host:CUPTI";
-constexpr std::string_view kRoctracerApiPlaneName   = "/host:ROCTRACER";
-constexpr std::string_view kMetadataPlaneName       = "/host:metadata";
-constexpr std::string_view kTFStreamzPlaneName      = "/host:tfstreamz";
-constexpr std::string_view kPythonTracerPlaneName   = "/host:python-tracer";
-constexpr std::string_view kHostCpusPlaneName       = "Host CPUs";
-constexpr std::string_view kSyscallsPlaneName       = "Syscalls";
+constexpr std::string_view kTpuRuntimePlaneName        = "/host:TPU-runtime";
+constexpr std::string_view kCuptiDriverApiPlaneName    = "/host:CUPTI";
+constexpr std::string_view kRoctracerApiPlaneName      = "/host:ROCTRACER";
+constexpr std::string_view kMetadataPlaneName          = "/host:metadata";
+constexpr std::string_view kTFStreamzPlaneName         = "/host:tfstreamz";
+constexpr std::string_view kPythonTracerPlaneName      = "/host:python-tracer";
+constexpr std::string_view kHostCpuSamplesPlaneName    = "/host:cpu-samples";
+constexpr std::string_view kHostPythonSamplesPlaneName = "/host:python-samples";
+constexpr std::string_view kHostCpusPlaneName          = "Host CPUs";
+constexpr std::string_view kSyscallsPlaneName          = "Syscalls";
 
 constexpr std::string_view kStepLineName                = "Steps";
 constexpr std::string_view kSparseCoreStepLineName      = "Sparse Core Steps";
@@ -203,6 +205,7 @@ constexpr std::string_view kXlaModuleLineName           = "XLA Modules";
 constexpr std::string_view kXlaOpLineName               = "XLA Ops";
 constexpr std::string_view kXlaAsyncOpLineName          = "Async XLA Ops";
 constexpr std::string_view kKernelLaunchLineName        = "Launch Stats";
+constexpr std::string_view kKernelMetricsLineName       = "Kernel Metrics";
 constexpr std::string_view kSourceLineName              = "Source code";
 constexpr std::string_view kHostOffloadOpLineName       = "Host Offload Ops";
 constexpr std::string_view kCounterEventsLineName       = "_counters_";
@@ -427,6 +430,11 @@ enum StatType
     kTheoreticalOccupancyPct,
     kOccupancyMinGridSize,
     kOccupancySuggestedBlockSize,
+    // GPU kernel hardware metrics, measured by the CUPTI range profiler
+    kAchievedOccupancyPct,
+    kDramThroughputPct,
+    kSmEfficiencyPct,
+    kL2HitRatePct,
     // Aggregated Stats
     kSelfDurationPs,
     kMinDurationPs,
@@ -34,6 +34,7 @@ limitations under the License.
 #include "profiler/native/exporters/xplane/xplane_utils.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <numeric>
@@ -46,6 +47,7 @@ limitations under the License.
 
 #include "common/macros.h"
 #include "logging/logger.h"
+#include "parallel/parallel_tools.h"
 #include "profiler/native/analysis/stats_calculator.h"
 #include "profiler/native/core/timespan.h"
 #include "profiler/native/exporters/xplane/tf_xplane_visitor.h"
@@ -256,14 +258,190 @@ timespan GetEventTimespan(const xevent_visitor& event)
     return event.get_timespan();
 }
 
-}  // namespace
+// Below this many events a line is sorted in place. Above, the sort runs on
+// compact (offset, duration, index) keys and each event, stats included, is
+// moved once instead of being swapped O(n log n) times.
+constexpr size_t kMinEventsForKeySort = 64;
 
-//static const xplane* FindPlaneWithName(const x_space& space, std::string_view name)
-//{
-//    int const i =
-//        Find(space.planes(), [name](const xplane* plane) { return plane->name() == name; });
-//    return (i != -1) ? &space.planes(i) : nullptr;
-//}
+struct event_sort_key
+{
+    uint64_t offset_ps;
+    uint64_t duration_ps;
+    size_t   index;
+
+    // Same order as xevents_comparator, ties kept in their original order
+    bool operator<(const event_sort_key& other) const
+    {
+        if (offset_ps != other.offset_ps)
+        {
+            return offset_ps < other.offset_ps;
+        }
+        if (duration_ps != other.duration_ps)
+        {
+            return duration_ps > other.duration_ps;
+        }
+        return index < other.index;
+    }
+};
+
+void SortLineEvents(xline* line)
+{
+    auto& events = *line->mutable_events();
+    if (std::is_sorted(events.begin(), events.end(), xevents_comparator()))
+    {
+        return;
+    }
+    if (events.size() < kMinEventsForKeySort)
+    {
+        std::sort(events.begin(), events.end(), xevents_comparator());
+        return;
+    }
+
+    std::vector<event_sort_key> keys(events.size());
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        keys[i] = {
+            static_cast<uint64_t>(events[i].offset_ps()),
+            static_cast<uint64_t>(events[i].duration_ps()),
+            i};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<xevent> sorted;
+    sorted.reserve(events.size());
+    for (const event_sort_key& key : keys)
+    {
+        sorted.push_back(std::move(events[key.index]));
+    }
+    events.swap(sorted);
+}
+
+// Lines are independent, so they are sorted concurrently
+void SortLines(const std::vector<xline*>& lines)
+{
+    parallel_tools::parallel_for(
+        0,
+        lines.size(),
+        1,
+        [&lines](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                SortLineEvents(lines[i]);
+            }
+        });
+}
+
+// Destination ids of the metadata of one source plane
+struct merge_metadata_map
+{
+    flat_hash_map<int64_t, int64_t> event_ids;
+    flat_hash_map<int64_t, int64_t> stat_ids;
+};
+
+// Source events bound for a destination line, shifted by offset_ps
+struct merge_segment
+{
+    const xline* src_line;
+    size_t       src_plane;
+    int64_t      offset_ps;
+};
+
+// A destination line while planes are merged: its existing events are
+// shifted by shift_ps, the segments are appended after them.
+struct merge_line
+{
+    xline                      line;
+    int64_t                    num_events = 0;
+    int64_t                    shift_ps   = 0;
+    std::vector<merge_segment> segments;
+};
+
+merge_metadata_map MapMetadata(
+    const xplane& src_plane, const xplane_visitor& src, xplane_builder& dst)
+{
+    merge_metadata_map map;
+    for (const auto& [id, metadata] : src_plane.stat_metadata())
+    {
+        map.stat_ids.emplace(id, dst.get_or_create_stat_metadata(metadata.name())->id());
+    }
+    for (const auto& [id, metadata] : src_plane.event_metadata())
+    {
+        xevent_metadata* dst_metadata = dst.get_or_create_event_metadata(metadata.name());
+        CopyEventMetadata(metadata, src, *dst_metadata, dst);
+        map.event_ids.emplace(id, dst_metadata->id());
+    }
+    return map;
+}
+
+// Rewrites the metadata ids of a copied event; stats whose metadata is not
+// in the source plane are dropped.
+void RemapEvent(const merge_metadata_map& map, xevent* event)
+{
+    auto const event_id = map.event_ids.find(event->metadata_id());
+    event->set_metadata_id(event_id != map.event_ids.end() ? event_id->second : 0);
+
+    auto& stats = *event->mutable_stats();
+    stats.erase(
+        std::remove_if(
+            stats.begin(),
+            stats.end(),
+            [&map](xstat& stat)
+            {
+                auto const stat_id = map.stat_ids.find(stat.metadata_id());
+                if (stat_id == map.stat_ids.end())
+                {
+                    return true;
+                }
+                stat.set_metadata_id(stat_id->second);
+                if (stat.value_case() == xstat::value_case_type::kRefValue)
+                {
+                    auto const ref_id = map.stat_ids.find(stat.ref_value());
+                    if (ref_id != map.stat_ids.end())
+                    {
+                        stat.set_ref_value(ref_id->second);
+                    }
+                    else
+                    {
+                        xstat unset;
+                        unset.set_metadata_id(stat_id->second);
+                        stat = std::move(unset);
+                    }
+                }
+                return false;
+            }),
+        stats.end());
+}
+
+void FinishMergeLine(const std::vector<merge_metadata_map>& maps, merge_line* merged)
+{
+    auto& events = *merged->line.mutable_events();
+    if (merged->shift_ps != 0)
+    {
+        for (xevent& event : events)
+        {
+            if (event.has_offset_ps())
+            {
+                event.set_offset_ps(event.offset_ps() + merged->shift_ps);
+            }
+        }
+    }
+    events.reserve(static_cast<size_t>(merged->num_events));
+    for (const merge_segment& segment : merged->segments)
+    {
+        for (const xevent& src_event : segment.src_line->events())
+        {
+            xevent& event = events.emplace_back(src_event);
+            if (event.has_offset_ps())
+            {
+                event.set_offset_ps(src_event.offset_ps() + segment.offset_ps);
+            }
+            RemapEvent(maps[segment.src_plane], &event);
+        }
+    }
+}
+
+}  // namespace
 
 //static std::vector<const xplane*> FindPlanesWithNames(
 //    const x_space& space, const std::vector<std::string_view>& names)
@@ -282,6 +460,13 @@ timespan GetEventTimespan(const xevent_visitor& event)
 //    return planes;
 //}
 
+const xplane* find_plane_with_name(const x_space& space, std::string_view name)
+{
+    int const i =
+        Find(space.planes(), [name](const xplane* plane) { return plane->name() == name; });
+    return (i != -1) ? &space.planes(i) : nullptr;
+}
+
 xplane* find_mutable_plane_with_name(x_space* space, std::string_view name)
 {
     int const i =
@@ -300,12 +485,11 @@ xplane* find_or_add_mutable_plane_with_name(x_space* space, std::string_view nam
     return plane;
 }
 
-//static std::vector<const xplane*> FindPlanesWithPrefix(
-//    const x_space& space, std::string_view prefix)
-//{
-//    return find_planes(
-//        space, [&](const xplane& plane) { return StartsWith(plane.name(), prefix); });
-//}
+std::vector<const xplane*> find_planes_with_prefix(const x_space& space, std::string_view prefix)
+{
+    return find_planes(
+        space, [&](const xplane& plane) { return StartsWith(plane.name(), prefix); });
+}
 
 std::vector<xplane*> find_mutable_planes_with_prefix(x_space* space, std::string_view prefix)
 {
@@ -367,19 +551,32 @@ xstat* find_or_add_mutable_stat(const x_stat_metadata& stat_metadata, xevent* ev
 //        [&planes_set](const xplane* plane) { return planes_set.find(plane) != planes_set.end(); });
 //}
 
-static void RemoveEmptyLines(xplane* plane)
+void sort_xplane(xplane* plane)
+{
+    std::vector<xline*> lines;
+    lines.reserve(plane->lines().size());
+    for (xline& line : *plane->mutable_lines())
+    {
+        lines.push_back(&line);
+    }
+    SortLines(lines);
+}
+
+void sort_x_space(x_space* space)
 {
-    RemoveIf(plane->mutable_lines(), [&](const xline* line) { return line->events().empty(); });
+    // All lines of all planes in one batch, so that a space with few planes
+    // still keeps every worker busy
+    std::vector<xline*> lines;
+    for (xplane& plane : *space->mutable_planes())
+    {
+        for (xline& line : *plane.mutable_lines())
+        {
+            lines.push_back(&line);
+        }
+    }
+    SortLines(lines);
 }
 
-//static void SortXPlane(xplane* plane)
-//{
-//    for (xline& line : *plane->mutable_lines())
-//    {
-//        auto& events = *line.mutable_events();
-//        std::sort(events.begin(), events.end(), xevents_comparator());
-//    }
-//}
 // Normalize the line's timestamp in this XPlane.
 // NOTE: This can be called multiple times on the same plane. Only the first
 // call will do the normalization, subsequent calls will do nothing.
@@ -406,56 +603,126 @@ void NormalizeTimestamps(x_space* space, uint64_t start_time_ns)
 }
 void MergePlanes(const xplane& src_plane, xplane* dst_plane)
 {
-    RemoveEmptyLines(dst_plane);
-    xplane_visitor src(&src_plane);
+    MergePlanes(std::vector<const xplane*>{&src_plane}, dst_plane);
+}
+
+// Same result as merging the planes one after the other, in two passes: the
+// line timestamps, names and metadata are resolved serially, which is cheap,
+// then the events, the bulk of the work, are copied one destination line per
+// task.
+void MergePlanes(const std::vector<const xplane*>& src_planes, xplane* dst_plane)
+{
+    std::vector<merge_line> lines;
+    lines.reserve(dst_plane->lines().size());
+    for (xline& line : *dst_plane->mutable_lines())
+    {
+        merge_line& merged = lines.emplace_back();
+        merged.num_events  = static_cast<int64_t>(line.events_size());
+        merged.line        = std::move(line);
+    }
+    dst_plane->mutable_lines()->clear();
+
+    std::vector<merge_metadata_map> maps;
+    maps.reserve(src_planes.size());
     xplane_builder dst(dst_plane);
-    src.for_each_stat(
-        [&](const x_stat_visitor& stat)
+    for (size_t k = 0; k < src_planes.size(); ++k)
+    {
+        const xplane& src_plane = *src_planes[k];
+        QUARISMA_CHECK_DEBUG(&src_plane != dst_plane, "Cannot merge a plane into itself");
+
+        // Lines without events are dropped before each source is merged
+        lines.erase(
+            std::remove_if(
+                lines.begin(),
+                lines.end(),
+                [](const merge_line& merged) { return merged.num_events == 0; }),
+            lines.end());
+        flat_hash_map<int64_t, size_t> line_index;
+        for (size_t i = 0; i < lines.size(); ++i)
         {
-            x_stat_metadata const* stat_metadata = dst.get_or_create_stat_metadata(stat.name());
-            // Use SetOrAddStat to avoid duplicating stats in dst_plane.
-            dst.set_or_add_stat(*stat_metadata, stat.raw_stat(), src_plane);
-        });
-    src.for_each_line(
-        [&](const xline_visitor& line)
+            line_index.emplace(lines[i].line.id(), i);
+        }
+
+        xplane_visitor const src(&src_plane);
+        src.for_each_stat(
+            [&](const x_stat_visitor& stat)
+            {
+                x_stat_metadata const* stat_metadata = dst.get_or_create_stat_metadata(stat.name());
+                // Use SetOrAddStat to avoid duplicating stats in dst_plane.
+                dst.set_or_add_stat(*stat_metadata, stat.raw_stat(), src_plane);
+            });
+        maps.push_back(MapMetadata(src_plane, src, dst));
+
+        for (const xline& src_line : src_plane.lines())
         {
-            xline_builder dst_line       = dst.get_or_create_line(line.id());
-            int64_t       time_offset_ps = 0LL;
-            if (dst_line.NumEvents() == 0)
+            auto const [it, inserted] = line_index.emplace(src_line.id(), lines.size());
+            if (inserted)
+            {
+                lines.emplace_back().line.set_id(src_line.id());
+            }
+            merge_line& merged         = lines[it->second];
+            xline&      dst_line       = merged.line;
+            int64_t     time_offset_ps = 0LL;
+            if (merged.num_events == 0)
             {
-                // Since we RemoveEmptyLines above, this could only mean that current
-                // line only exist in src plane.
-                dst_line.SetTimestampNs(line.timestamp_ns());
-                dst_line.SetName(line.name());
-                dst_line.SetDisplayNameIfEmpty(line.display_name());
+                // Since empty lines were removed above, this line only exists in
+                // the src plane.
+                dst_line.set_timestamp_ns(src_line.timestamp_ns());
+                dst_line.set_name(std::string(src_line.name()));
+                if (dst_line.display_name().empty())
+                {
+                    dst_line.set_display_name(std::string(
+                        src_line.display_name().empty() ? src_line.name()
+                                                        : src_line.display_name()));
+                }
             }
             else
             {
-                if (line.timestamp_ns() <= dst_line.TimestampNs())
+                if (src_line.timestamp_ns() <= dst_line.timestamp_ns())
                 {
-                    dst_line.set_time_stamp_ns_and_adjust_event_offsets(line.timestamp_ns());
+                    int64_t const shift_ps = xevent_builder::NanoToPico(
+                        dst_line.timestamp_ns() - src_line.timestamp_ns());
+                    dst_line.set_timestamp_ns(src_line.timestamp_ns());
+                    merged.shift_ps += shift_ps;
+                    for (merge_segment& segment : merged.segments)
+                    {
+                        segment.offset_ps += shift_ps;
+                    }
                 }
                 else
                 {
-                    time_offset_ps =
-                        xevent_builder::NanoToPico(line.timestamp_ns() - dst_line.TimestampNs());
+                    time_offset_ps = xevent_builder::NanoToPico(
+                        src_line.timestamp_ns() - dst_line.timestamp_ns());
+                }
+                if (dst_line.name().empty())
+                {
+                    dst_line.set_name(std::string(src_line.name()));
                 }
-                dst_line.SetNameIfEmpty(line.name());
                 // Don't override dst_line's display name because if both lines have name,
                 // but no display name, line's name will became display name of dst_line.
             }
+            merged.num_events += static_cast<int64_t>(src_line.events_size());
+            merged.segments.push_back({&src_line, k, time_offset_ps});
+        }
+    }
 
-            line.for_each_event(
-                [&](const xevent_visitor& event)
-                { CopyEvent(event, src, src_plane, time_offset_ps, dst, dst_line); });
+    parallel_tools::parallel_for(
+        0,
+        lines.size(),
+        1,
+        [&lines, &maps](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                FinishMergeLine(maps, &lines[i]);
+            }
         });
-}
 
-void MergePlanes(const std::vector<const xplane*>& src_planes, xplane* dst_plane)
-{
-    for (const xplane* src_plane : src_planes)
+    auto& dst_lines = *dst_plane->mutable_lines();
+    dst_lines.reserve(lines.size());
+    for (merge_line& merged : lines)
     {
-        MergePlanes(*src_plane, dst_plane);
+        dst_lines.push_back(std::move(merged.line));
     }
 }
 
@@ -748,53 +1015,72 @@ void AggregateXPlane(const xplane& full_trace, xplane& aggregated_trace)
     using StatByEvent = flat_hash_map<int64_t /*event_id*/, EventStat>;
     using StatByGroup = flat_hash_map<int64_t /*group_id*/, StatByEvent>;
 
-    flat_hash_map<int64_t /*line_id*/, StatByGroup> stats;
-
     const xplane_visitor& plane = CreateTfXPlaneVisitor(&full_trace);
     xplane_builder        aggregated_plane(&aggregated_trace);
     aggregated_plane.SetName(plane.name());
 
-    uint64_t first_op_start_ps = std::numeric_limits<uint64_t>::max();
-    uint64_t last_op_end_ps    = 0;
+    // Op lines grouped by id, in order of first appearance; each group is
+    // aggregated by its own task below
+    struct OpLines
+    {
+        int64_t                   line_id;
+        std::vector<const xline*> lines;
+        StatByGroup               stats;
+        uint64_t                  first_op_start_ps = std::numeric_limits<uint64_t>::max();
+        uint64_t                  last_op_end_ps    = 0;
+    };
+    std::vector<OpLines>           op_lines;
+    flat_hash_map<int64_t, size_t> op_line_index;
 
-    plane.for_each_line(
-        [&](const xline_visitor& line)
+    for (const xline& raw_line : full_trace.lines())
+    {
+        xline_visitor const line(&plane, &raw_line);
+        if (line.name() == kStepLineName || line.name() == kSparseCoreStepLineName)
         {
-            if (line.name() == kStepLineName || line.name() == kSparseCoreStepLineName)
-            {
-                xline_builder aggregated_line = aggregated_plane.get_or_create_line(line.id());
-                aggregated_line.SetName(kStepLineName);
-                line.for_each_event(
-                    [&](const xevent_visitor& event)
-                    {
-                        CopyEvent(event, plane, full_trace, 0LL, aggregated_plane, aggregated_line);
-                    });
-            }
-            if (!IsOpLineName(line.name()))
-            {
-                return;
-            }
             xline_builder aggregated_line = aggregated_plane.get_or_create_line(line.id());
-            aggregated_line.SetName(line.name());
+            aggregated_line.SetName(kStepLineName);
+            line.for_each_event(
+                [&](const xevent_visitor& event)
+                { CopyEvent(event, plane, full_trace, 0LL, aggregated_plane, aggregated_line); });
+        }
+        if (!IsOpLineName(line.name()))
+        {
+            continue;
+        }
+        xline_builder aggregated_line = aggregated_plane.get_or_create_line(line.id());
+        aggregated_line.SetName(line.name());
+        auto const [it, inserted] = op_line_index.emplace(line.id(), op_lines.size());
+        if (inserted)
+        {
+            op_lines.push_back({line.id(), {}, {}});
+        }
+        op_lines[it->second].lines.push_back(&raw_line);
+    }
+
+    auto const aggregate_lines = [&plane](OpLines& group)
+    {
+        for (const xline* raw_line : group.lines)
+        {
+            xline_visitor const         line(&plane, raw_line);
             std::vector<xevent_visitor> event_stack;
             line.for_each_event(
                 [&](xevent_visitor event)
                 {
                     timespan const timespan = GetEventTimespan(event);
-                    first_op_start_ps =
-                        first_op_start_ps <= static_cast<uint64_t>(event.timestamp_ps())
-                            ? first_op_start_ps
+                    group.first_op_start_ps =
+                        group.first_op_start_ps <= static_cast<uint64_t>(event.timestamp_ps())
+                            ? group.first_op_start_ps
                             : timespan.begin_ps();
-                    last_op_end_ps =
-                        last_op_end_ps >= static_cast<uint64_t>(event.end_timestamp_ps())
-                            ? last_op_end_ps
+                    group.last_op_end_ps =
+                        group.last_op_end_ps >= static_cast<uint64_t>(event.end_timestamp_ps())
+                            ? group.last_op_end_ps
                             : timespan.end_ps();
                     const auto&   group_stat = event.get_stat(StatType::kGroupId);
                     int64_t const group_id   = group_stat.has_value()
                                                    ? group_stat->int_or_uint_value()
                                                    : std::numeric_limits<uint64_t>::max();
 
-                    StatByEvent& line_stats = stats[line.id()][group_id];
+                    StatByEvent& line_stats = group.stats[group_id];
                     line_stats[event.id()].stat.update_stat(timespan.duration_ps());
                     QUARISMA_CHECK_DEBUG(                                         //NOLINT
                         event_stack.empty() || !(event < event_stack.back()));  //NOLINT
@@ -810,8 +1096,30 @@ void AggregateXPlane(const xplane& full_trace, xplane& aggregated_trace)
                     }
                     event_stack.push_back(std::move(event));
                 });
+        }
+    };
+    parallel_tools::parallel_for(
+        0,
+        op_lines.size(),
+        1,
+        [&op_lines, &aggregate_lines](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                aggregate_lines(op_lines[i]);
+            }
         });
 
+    flat_hash_map<int64_t /*line_id*/, StatByGroup> stats;
+    uint64_t first_op_start_ps = std::numeric_limits<uint64_t>::max();
+    uint64_t last_op_end_ps    = 0;
+    for (OpLines& group : op_lines)
+    {
+        first_op_start_ps    = std::min(first_op_start_ps, group.first_op_start_ps);
+        last_op_end_ps       = std::max(last_op_end_ps, group.last_op_end_ps);
+        stats[group.line_id] = std::move(group.stats);
+    }
+
     uint64_t const total_time_ps = ((last_op_end_ps != 0u) && last_op_end_ps > first_op_start_ps)
                                        ? last_op_end_ps - first_op_start_ps
                                        : 0;
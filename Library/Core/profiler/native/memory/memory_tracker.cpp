@@ -48,11 +48,35 @@
 
 #include <algorithm>
 #include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <utility>
+
+#include "logging/logger.h"
+
 namespace quarisma
 {
 
+namespace
+{
+/// Events between two timeline keyframes
+constexpr uint64_t timeline_keyframe_interval = 1024;
+
+int64_t to_timeline_ns(std::chrono::high_resolution_clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+std::chrono::high_resolution_clock::time_point from_timeline_ns(int64_t ns)
+{
+    return std::chrono::high_resolution_clock::time_point(
+        std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::nanoseconds(ns)));
+}
+}  // namespace
+
 //=============================================================================
 // memory_tracker Implementation
 //=============================================================================
@@ -80,15 +104,23 @@ void memory_tracker::start_tracking()
     total_allocated_.store(0);
     total_deallocated_.store(0);
 
+    active_allocations_.clear();
+
     {
-        std::scoped_lock const lock(allocations_mutex_);
-        active_allocations_.clear();
+        std::scoped_lock const lock(stacks_mutex_);
+        stacks_.clear();
+        stack_ids_.clear();
+        stack_counters_.clear();
+        sampled_live_bytes_ = 0;
+        sampled_peak_bytes_ = 0;
     }
 
     {
         std::scoped_lock const lock(snapshots_mutex_);
         snapshots_.clear();
     }
+
+    restart_timeline(0, 0);
 }
 
 void memory_tracker::stop_tracking()
@@ -115,12 +147,14 @@ void memory_tracker::track_allocation(void* ptr, size_t size, const std::string&
     allocation.timestamp_ = std::chrono::high_resolution_clock::now();
     allocation.context_   = context;
     allocation.thread_id_ = std::this_thread::get_id();
-
+    if (should_sample(size))
     {
-        std::scoped_lock const lock(allocations_mutex_);
-        active_allocations_[ptr] = allocation;
+        allocation.stack_id_ = record_sampled_stack(size);
     }
 
+    active_allocations_.insert_or_assign(ptr, allocation);
+    record_timeline_event(static_cast<int64_t>(size), allocation.stack_id_, false);
+
     // Update statistics atomically
     size_t const new_current = current_usage_.fetch_add(size) + size;
     total_allocated_.fetch_add(size);
@@ -136,16 +170,19 @@ void memory_tracker::track_deallocation(void* ptr)
         return;
     }
 
-    size_t deallocated_size = 0;
+    size_t   deallocated_size = 0;
+    uint32_t stack_id         = 0;
 
+    if (auto const allocation = active_allocations_.extract(ptr))
     {
-        std::scoped_lock const lock(allocations_mutex_);
-        auto                   it = active_allocations_.find(ptr);
-        if (it != active_allocations_.end())
-        {
-            deallocated_size = it->second.size_;
-            active_allocations_.erase(it);
-        }
+        deallocated_size = allocation->size_;
+        stack_id         = allocation->stack_id_;
+        record_timeline_event(-static_cast<int64_t>(deallocated_size), stack_id, true);
+    }
+
+    if (stack_id != 0)
+    {
+        release_sampled_stack(stack_id, deallocated_size);
     }
 
     if (deallocated_size > 0)
@@ -241,39 +278,198 @@ void memory_tracker::reset()
     total_allocated_.store(0);
     total_deallocated_.store(0);
 
+    active_allocations_.clear();
+
     {
-        std::scoped_lock const lock(allocations_mutex_);
-        active_allocations_.clear();
+        std::scoped_lock const lock(stacks_mutex_);
+        stacks_.clear();
+        stack_ids_.clear();
+        stack_counters_.clear();
+        sampled_live_bytes_ = 0;
+        sampled_peak_bytes_ = 0;
     }
 
     {
         std::scoped_lock const lock(snapshots_mutex_);
         snapshots_.clear();
     }
+
+    restart_timeline(0, 0);
 }
 
 std::vector<quarisma::memory_allocation> memory_tracker::get_active_allocations() const
 {
-    std::scoped_lock const                 lock(allocations_mutex_);
     std::vector<quarisma::memory_allocation> allocations;
     allocations.reserve(active_allocations_.size());
-
-    // Use std::transform to extract allocation values
-    std::transform(
-        active_allocations_.begin(),
-        active_allocations_.end(),
-        std::back_inserter(allocations),
-        [](const auto& pair) { return pair.second; });
+    active_allocations_.cvisit_all(
+        [&allocations](void*, const quarisma::memory_allocation& allocation)
+        { allocations.push_back(allocation); });
 
     return allocations;
 }
 
 size_t memory_tracker::get_allocation_count() const
 {
-    std::scoped_lock const lock(allocations_mutex_);
     return active_allocations_.size();
 }
 
+void memory_tracker::set_stack_sampling_interval(size_t interval_bytes)
+{
+    stack_sampling_interval_.store(interval_bytes);
+    bytes_until_sample_.store(static_cast<int64_t>(interval_bytes));
+}
+
+std::vector<quarisma::memory_allocation_site> memory_tracker::get_allocation_sites(
+    quarisma::unwind::Mode mode) const
+{
+    std::vector<quarisma::memory_allocation_site> sites;
+    std::vector<std::vector<void*>>               stacks;
+    {
+        std::scoped_lock const lock(stacks_mutex_);
+        stacks = stacks_;
+        sites.reserve(stacks_.size());
+        for (size_t i = 0; i < stack_counters_.size(); ++i)
+        {
+            const auto&                      counters = stack_counters_[i];
+            quarisma::memory_allocation_site site;
+            site.stack_id_        = static_cast<uint32_t>(i + 1);
+            site.allocations_     = counters.allocations_;
+            site.allocated_bytes_ = counters.allocated_bytes_;
+            site.live_bytes_      = counters.live_bytes_;
+            site.peak_live_bytes_ = counters.peak_live_bytes_;
+            site.bytes_at_peak_   = counters.bytes_at_peak_;
+            sites.push_back(std::move(site));
+        }
+    }
+
+    // Symbolize each distinct frame once, in a single batch
+    std::vector<void*>                         unique_frames;
+    quarisma_map<void*, size_t, void_ptr_hash> frame_index;
+    for (const auto& stack : stacks)
+    {
+        for (void* frame : stack)
+        {
+            if (frame_index.emplace(frame, unique_frames.size()).second)
+            {
+                unique_frames.push_back(frame);
+            }
+        }
+    }
+    std::vector<quarisma::unwind::Frame> const symbols =
+        unique_frames.empty() ? std::vector<quarisma::unwind::Frame>{}
+                              : quarisma::unwind::symbolize(unique_frames, mode);
+
+    for (size_t i = 0; i < sites.size(); ++i)
+    {
+        sites[i].frames_.reserve(stacks[i].size());
+        for (void* frame : stacks[i])
+        {
+            size_t const index = frame_index[frame];
+            if (index < symbols.size())
+            {
+                sites[i].frames_.push_back(symbols[index]);
+            }
+        }
+    }
+
+    std::stable_sort(
+        sites.begin(),
+        sites.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.bytes_at_peak_ > rhs.bytes_at_peak_; });
+    return sites;
+}
+
+std::vector<void*> memory_tracker::get_stack(uint32_t stack_id) const
+{
+    std::scoped_lock const lock(stacks_mutex_);
+    if (stack_id == 0 || stack_id > stacks_.size())
+    {
+        return {};
+    }
+    return stacks_[stack_id - 1];
+}
+
+bool memory_tracker::should_sample(size_t size)
+{
+    size_t const interval = stack_sampling_interval_.load(std::memory_order_relaxed);
+    if (interval == 0)
+    {
+        return false;
+    }
+
+    // Counting down by bytes samples large allocations proportionally more often
+    int64_t const left =
+        bytes_until_sample_.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed) -
+        static_cast<int64_t>(size);
+    if (left > 0)
+    {
+        return false;
+    }
+    bytes_until_sample_.store(static_cast<int64_t>(interval), std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t memory_tracker::record_sampled_stack(size_t size)
+{
+    // Unwind outside of the lock; only the interning is serialized
+    std::vector<void*> frames = quarisma::unwind::unwind();
+    if (frames.empty())
+    {
+        if (stack_sampling_interval_.exchange(0) != 0)
+        {
+            QUARISMA_LOG_WARNING("Call stacks are unavailable; allocation stack sampling disabled");
+        }
+        return 0;
+    }
+
+    std::scoped_lock const lock(stacks_mutex_);
+
+    uint32_t id = 0;
+    auto     it = stack_ids_.find(frames);
+    if (it != stack_ids_.end())
+    {
+        id = it->second;
+    }
+    else
+    {
+        id = static_cast<uint32_t>(stacks_.size() + 1);
+        stack_ids_.emplace(frames, id);
+        stacks_.push_back(std::move(frames));
+        stack_counters_.emplace_back();
+    }
+
+    auto& counters = stack_counters_[id - 1];
+    counters.allocations_++;
+    counters.allocated_bytes_ += size;
+    counters.live_bytes_ += size;
+    counters.peak_live_bytes_ = (std::max)(counters.peak_live_bytes_, counters.live_bytes_);
+
+    // Record every stack's share of a new peak, at most once per 1/64 of growth
+    sampled_live_bytes_ += size;
+    if (sampled_live_bytes_ > sampled_peak_bytes_ + sampled_peak_bytes_ / 64)
+    {
+        sampled_peak_bytes_ = sampled_live_bytes_;
+        for (auto& stack : stack_counters_)
+        {
+            stack.bytes_at_peak_ = stack.live_bytes_;
+        }
+    }
+    return id;
+}
+
+void memory_tracker::release_sampled_stack(uint32_t stack_id, size_t size)
+{
+    std::scoped_lock const lock(stacks_mutex_);
+    if (stack_id == 0 || stack_id > stack_counters_.size())
+    {
+        // Interned before a reset()
+        return;
+    }
+    auto& counters = stack_counters_[stack_id - 1];
+    counters.live_bytes_ -= (std::min)(counters.live_bytes_, size);
+    sampled_live_bytes_ -= (std::min)(sampled_live_bytes_, size);
+}
+
 void memory_tracker::take_snapshot(const std::string& label)
 {
     quarisma::memory_stats const stats = get_current_stats();
@@ -288,6 +484,202 @@ std::vector<std::pair<std::string, quarisma::memory_stats>> memory_tracker::get_
     return snapshots_;
 }
 
+void memory_tracker::set_timeline_capacity(size_t capacity)
+{
+    size_t rounded = 0;
+    if (capacity > 0)
+    {
+        rounded = 2 * timeline_keyframe_interval;
+        while (rounded < capacity)
+        {
+            rounded *= 2;
+        }
+    }
+
+    {
+        std::scoped_lock const lock(timeline_mutex_);
+        timeline_events_.clear();
+        timeline_events_.shrink_to_fit();
+        timeline_events_.resize(rounded);
+        timeline_capacity_.store(rounded);
+    }
+    restart_timeline(current_usage_.load(), active_allocations_.size());
+}
+
+void memory_tracker::restart_timeline(size_t usage, size_t live_allocations)
+{
+    std::scoped_lock const lock(timeline_mutex_);
+    timeline_keyframes_.clear();
+    timeline_next_event_       = 0;
+    timeline_usage_            = usage;
+    timeline_live_allocations_ = live_allocations;
+    if (timeline_capacity_.load() > 0)
+    {
+        int64_t const now = to_timeline_ns(std::chrono::high_resolution_clock::now());
+        timeline_keyframes_.push_back({now, 0, usage, live_allocations});
+    }
+}
+
+void memory_tracker::record_timeline_event(int64_t delta_bytes, uint32_t stack_id, bool is_free)
+{
+    if (timeline_capacity_.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    std::scoped_lock const lock(timeline_mutex_);
+    uint64_t const capacity = timeline_events_.size();
+    if (capacity == 0 || timeline_keyframes_.empty())
+    {
+        return;  // Disabled or being restarted while waiting for the lock
+    }
+
+    // Timestamps are taken under the lock, so they follow the event order
+    timeline_keyframe const& last = timeline_keyframes_.back();
+    int64_t const            now  = (std::max)(
+        to_timeline_ns(std::chrono::high_resolution_clock::now()), last.time_ns_);
+    if (timeline_next_event_ - last.first_event_ >= timeline_keyframe_interval ||
+        now - last.time_ns_ > static_cast<int64_t>((std::numeric_limits<uint32_t>::max)()))
+    {
+        timeline_keyframes_.push_back(
+            {now, timeline_next_event_, timeline_usage_, timeline_live_allocations_});
+    }
+
+    timeline_event& event = timeline_events_[timeline_next_event_ & (capacity - 1)];
+    event.delta_bytes_    = delta_bytes;
+    event.offset_ns_      = static_cast<uint32_t>(now - timeline_keyframes_.back().time_ns_);
+    event.stack_id_       = stack_id;
+    event.is_free_        = is_free ? 1 : 0;
+    ++timeline_next_event_;
+
+    timeline_usage_ = static_cast<size_t>(static_cast<int64_t>(timeline_usage_) + delta_bytes);
+    timeline_live_allocations_ += is_free ? size_t{0} - 1 : 1;
+
+    // A keyframe is only usable while all of its events are retained
+    uint64_t const oldest = timeline_next_event_ > capacity ? timeline_next_event_ - capacity : 0;
+    while (timeline_keyframes_.size() > 1 && timeline_keyframes_.front().first_event_ < oldest)
+    {
+        timeline_keyframes_.pop_front();
+    }
+}
+
+std::optional<quarisma::memory_timeline_point> memory_tracker::get_usage_at(
+    std::chrono::high_resolution_clock::time_point time) const
+{
+    int64_t const          time_ns = to_timeline_ns(time);
+    std::scoped_lock const lock(timeline_mutex_);
+    if (timeline_keyframes_.empty())
+    {
+        return std::nullopt;
+    }
+
+    // The last keyframe at or before `time`
+    auto it = std::upper_bound(
+        timeline_keyframes_.begin(),
+        timeline_keyframes_.end(),
+        time_ns,
+        [](int64_t t, const timeline_keyframe& keyframe) { return t < keyframe.time_ns_; });
+    if (it == timeline_keyframes_.begin())
+    {
+        return std::nullopt;
+    }
+    const timeline_keyframe& keyframe = *std::prev(it);
+    uint64_t const end = it != timeline_keyframes_.end() ? it->first_event_ : timeline_next_event_;
+
+    uint64_t const                  capacity = timeline_events_.size();
+    quarisma::memory_timeline_point point;
+    int64_t                         point_ns = keyframe.time_ns_;
+    int64_t                         usage    = static_cast<int64_t>(keyframe.usage_);
+    point.live_allocations_                  = keyframe.live_allocations_;
+    for (uint64_t i = keyframe.first_event_; i < end; ++i)
+    {
+        const timeline_event& event    = timeline_events_[i & (capacity - 1)];
+        int64_t const         event_ns = keyframe.time_ns_ + event.offset_ns_;
+        if (event_ns > time_ns)
+        {
+            break;
+        }
+        point_ns = event_ns;
+        usage += event.delta_bytes_;
+        point.live_allocations_ += event.is_free_ != 0 ? size_t{0} - 1 : 1;
+    }
+    point.timestamp_     = from_timeline_ns(point_ns);
+    point.current_usage_ = static_cast<size_t>(usage);
+    return point;
+}
+
+std::vector<quarisma::memory_timeline_point> memory_tracker::get_timeline() const
+{
+    std::vector<quarisma::memory_timeline_point> points;
+    std::scoped_lock const                       lock(timeline_mutex_);
+    if (timeline_keyframes_.empty())
+    {
+        return points;
+    }
+
+    const timeline_keyframe& first    = timeline_keyframes_.front();
+    uint64_t const           capacity = timeline_events_.size();
+    points.reserve(timeline_next_event_ - first.first_event_ + 1);
+
+    quarisma::memory_timeline_point point;
+    point.timestamp_        = from_timeline_ns(first.time_ns_);
+    point.current_usage_    = first.usage_;
+    point.live_allocations_ = first.live_allocations_;
+    points.push_back(point);
+
+    // Offsets are relative to the keyframe each event follows
+    auto next_keyframe = timeline_keyframes_.begin();
+    int64_t base_ns    = first.time_ns_;
+    for (uint64_t i = first.first_event_; i < timeline_next_event_; ++i)
+    {
+        while (next_keyframe != timeline_keyframes_.end() && next_keyframe->first_event_ <= i)
+        {
+            base_ns = next_keyframe->time_ns_;
+            ++next_keyframe;
+        }
+        const timeline_event& event = timeline_events_[i & (capacity - 1)];
+        point.timestamp_            = from_timeline_ns(base_ns + event.offset_ns_);
+        point.current_usage_ =
+            static_cast<size_t>(static_cast<int64_t>(point.current_usage_) + event.delta_bytes_);
+        point.live_allocations_ += event.is_free_ != 0 ? size_t{0} - 1 : 1;
+        points.push_back(point);
+    }
+    return points;
+}
+
+void memory_tracker::write_timeline_chrome_trace(std::ostream& json) const
+{
+    std::vector<quarisma::memory_timeline_point> const points = get_timeline();
+
+    // Counter timestamps are in microseconds
+    std::ios_base::fmtflags const flags = json.flags();
+    json << std::fixed << std::setprecision(3);
+    json << R"({"traceEvents":[)";
+    json << R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"Memory"}})";
+    for (const auto& point : points)
+    {
+        double const ts = static_cast<double>(to_timeline_ns(point.timestamp_)) / 1000.0;
+        json << R"(,{"name":"Tracked memory","ph":"C","pid":1,"ts":)" << ts
+             << R"(,"args":{"bytes":)" << point.current_usage_ << "}}";
+        json << R"(,{"name":"Live allocations","ph":"C","pid":1,"ts":)" << ts
+             << R"(,"args":{"count":)" << point.live_allocations_ << "}}";
+    }
+    json << R"(],"displayTimeUnit":"ns"})";
+    json.flags(flags);
+}
+
+bool memory_tracker::export_timeline_chrome_trace_file(const std::string& filename) const
+{
+    std::ofstream file(filename);
+    if (!file.is_open())
+    {
+        QUARISMA_LOG_ERROR("Failed to open file for memory timeline export: {}", filename);
+        return false;
+    }
+    write_timeline_chrome_trace(file);
+    return file.good();
+}
+
 size_t memory_tracker::get_process_memory_usage()
 {
 #ifdef _WIN32
@@ -29,6 +29,9 @@
  * - Memory usage statistics and reporting
  * - Thread-safe operations for multi-threaded applications
  * - Cross-platform memory usage queries
+ * - Sampled allocation call stacks, interned and symbolized on export
+ * - A delta-encoded usage timeline, queryable at any timestamp and exported
+ *   as Chrome trace counters
  *
  * COMPONENT CLASSIFICATION: OPTIONAL
  * This component provides memory profiling capabilities but is not required
@@ -40,15 +43,22 @@
  */
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <new>
+#include <optional>
+#include <ostream>
+#include <string>
 #include <vector>
 
+#include "profiler/common/unwind/unwind.h"
 #include "profiler/native/session/profiler.h"
+#include "util/concurrent_flat_map.h"
 #include "util/flat_hash.h"
 
 #ifdef _WIN32
@@ -100,6 +110,54 @@ struct memory_allocation
 
     /// ID of the thread that performed the allocation
     std::thread::id thread_id_;
+
+    /// Interned call stack of a sampled allocation, 0 if it was not sampled
+    uint32_t stack_id_ = 0;
+};
+
+/**
+ * @brief Memory attributed to one allocation call stack
+ *
+ * Only sampled allocations are attributed; with a sampling interval of N
+ * bytes, every allocation of at least N bytes is sampled.
+ */
+struct memory_allocation_site
+{
+    /// Interned stack ID, as stored in memory_allocation::stack_id_
+    uint32_t stack_id_ = 0;
+
+    /// Number of sampled allocations from this stack
+    size_t allocations_ = 0;
+
+    /// Bytes of those allocations
+    size_t allocated_bytes_ = 0;
+
+    /// Bytes of those allocations that are still live
+    size_t live_bytes_ = 0;
+
+    /// Highest live_bytes_ of this stack
+    size_t peak_live_bytes_ = 0;
+
+    /// Live bytes of this stack when the sampled live total peaked (within 1/64)
+    size_t bytes_at_peak_ = 0;
+
+    /// Symbolized frames, innermost first
+    std::vector<quarisma::unwind::Frame> frames_;
+};
+
+/**
+ * @brief Tracked memory at one point of the timeline
+ */
+struct memory_timeline_point
+{
+    /// Time of the last allocation or deallocation at or before the queried time
+    std::chrono::high_resolution_clock::time_point timestamp_;
+
+    /// Bytes of the live allocations
+    size_t current_usage_ = 0;
+
+    /// Number of live allocations
+    size_t live_allocations_ = 0;
 };
 
 /**
@@ -204,6 +262,39 @@ public:
      */
     QUARISMA_API void reset();
 
+    /**
+     * @brief Capture the call stack of sampled allocations
+     *
+     * An allocation is sampled each time `interval_bytes` more bytes have
+     * been allocated, so 1 samples every allocation. Stacks are interned:
+     * each sampled allocation stores a stack ID and updates the counters of
+     * its site, and frames are only symbolized by get_allocation_sites().
+     *
+     * @param interval_bytes Bytes between samples (0 = disabled, the default)
+     * @note Stacks are only available on Linux x86_64 builds
+     */
+    QUARISMA_API void set_stack_sampling_interval(size_t interval_bytes);
+
+    /**
+     * @brief Get the sampling interval set by set_stack_sampling_interval()
+     */
+    size_t stack_sampling_interval() const { return stack_sampling_interval_.load(); }
+
+    /**
+     * @brief Get the allocation sites seen so far, symbolized
+     * @param mode Symbolizer, the fast in-process DWARF reader by default
+     * @return Sites ordered by bytes_at_peak_, largest first
+     */
+    QUARISMA_API std::vector<quarisma::memory_allocation_site> get_allocation_sites(
+        quarisma::unwind::Mode mode = quarisma::unwind::Mode::fast) const;
+
+    /**
+     * @brief Get the raw program counters of an interned stack
+     * @param stack_id ID from memory_allocation::stack_id_
+     * @return Frames, empty for an unknown ID
+     */
+    QUARISMA_API std::vector<void*> get_stack(uint32_t stack_id) const;
+
     /**
      * @brief Get a copy of all currently active allocations (thread-safe)
      * @return Vector of active memory allocations
@@ -228,15 +319,62 @@ public:
      */
     QUARISMA_API std::vector<std::pair<std::string, quarisma::memory_stats>> get_snapshots() const;
 
+    /**
+     * @brief Record every allocation and deallocation in a timeline
+     *
+     * Unlike snapshots, the timeline stores only deltas: 16 bytes per event
+     * (size change, time offset, sampled stack ID) in a ring holding the
+     * last `capacity` events. Every 1024 events a keyframe records the
+     * absolute usage, so get_usage_at() replays at most that many deltas.
+     * Once the ring wraps, the oldest events are overwritten together with
+     * the keyframes they start from.
+     *
+     * @param capacity Events kept, rounded up to a power of two of at least
+     *        2048 (0 = disabled, the default); changing it clears the timeline
+     */
+    QUARISMA_API void set_timeline_capacity(size_t capacity);
+
+    /**
+     * @brief Get the capacity of the timeline ring, 0 when it is disabled
+     */
+    size_t timeline_capacity() const { return timeline_capacity_.load(); }
+
+    /**
+     * @brief Get the tracked memory at a point in time
+     * @param time Any time since the oldest retained keyframe
+     * @return The usage at `time`, or nullopt if the timeline is disabled or
+     *         no longer covers it
+     */
+    QUARISMA_API std::optional<quarisma::memory_timeline_point> get_usage_at(
+        std::chrono::high_resolution_clock::time_point time) const;
+
+    /**
+     * @brief Get every point the timeline still covers, oldest first
+     */
+    QUARISMA_API std::vector<quarisma::memory_timeline_point> get_timeline() const;
+
+    /**
+     * @brief Write the timeline as Chrome trace counter events ("ph":"C")
+     *
+     * The output loads in chrome://tracing and the Perfetto UI, with one
+     * counter track for the live bytes and one for the live allocations.
+     */
+    QUARISMA_API void write_timeline_chrome_trace(std::ostream& json) const;
+
+    /**
+     * @brief Write the timeline to a Chrome trace JSON file
+     * @return false if the file cannot be written
+     */
+    QUARISMA_API bool export_timeline_chrome_trace_file(const std::string& filename) const;
+
 private:
     /// Atomic flag indicating if tracking is active
     std::atomic<bool> tracking_{false};
 
-    /// Mutex for thread-safe access to allocation tracking data
-    mutable std::mutex allocations_mutex_;
-
-    /// Map of active memory allocations (using custom hash for void*)
-    quarisma_map<void*, quarisma::memory_allocation, quarisma::void_ptr_hash> active_allocations_;
+    /// Map of active memory allocations (using custom hash for void*), sharded so that
+    /// threads allocating concurrently rarely take the same lock
+    concurrent_flat_map<void*, quarisma::memory_allocation, quarisma::void_ptr_hash>
+        active_allocations_;
 
     /// Atomic counter for current memory usage
     std::atomic<size_t> current_usage_{0};
@@ -256,6 +394,125 @@ private:
     /// Vector of labeled memory usage snapshots
     std::vector<std::pair<std::string, quarisma::memory_stats>> snapshots_;
 
+    /// Hash of a call stack for interning
+    struct stack_hash
+    {
+        std::size_t operator()(const std::vector<void*>& frames) const noexcept
+        {
+            std::size_t seed = frames.size();
+            for (void* frame : frames)
+            {
+                seed ^= reinterpret_cast<std::uintptr_t>(frame) + 0x9e3779b9U +
+                        (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+
+    /// Counters of one interned stack
+    struct stack_counters
+    {
+        size_t allocations_     = 0;
+        size_t allocated_bytes_ = 0;
+        size_t live_bytes_      = 0;
+        size_t peak_live_bytes_ = 0;
+        size_t bytes_at_peak_   = 0;
+    };
+
+    /// Bytes between stack samples, 0 when sampling is disabled
+    std::atomic<size_t> stack_sampling_interval_{0};
+
+    /// Bytes left until the next sample
+    std::atomic<int64_t> bytes_until_sample_{0};
+
+    /// Mutex for thread-safe access to the stack table
+    mutable std::mutex stacks_mutex_;
+
+    /// Interned stacks; ID i + 1 refers to stacks_[i]
+    std::vector<std::vector<void*>> stacks_;
+
+    /// Stack IDs by frames
+    quarisma_map<std::vector<void*>, uint32_t, stack_hash> stack_ids_;
+
+    /// Counters by stack, parallel to stacks_
+    std::vector<stack_counters> stack_counters_;
+
+    /// Sum of live_bytes_ over all stacks
+    size_t sampled_live_bytes_ = 0;
+
+    /// sampled_live_bytes_ when bytes_at_peak_ was last recorded
+    size_t sampled_peak_bytes_ = 0;
+
+    /// One allocation or deallocation of the timeline
+    struct timeline_event
+    {
+        /// Bytes allocated, negative for a deallocation
+        int64_t delta_bytes_ = 0;
+
+        /// Nanoseconds since the keyframe this event follows
+        uint32_t offset_ns_ = 0;
+
+        /// Stack ID of a sampled allocation, 0 otherwise
+        uint32_t stack_id_ : 31;
+
+        /// Whether the event is a deallocation
+        uint32_t is_free_ : 1;
+    };
+
+    /// Absolute state before the event `first_event_`
+    struct timeline_keyframe
+    {
+        int64_t  time_ns_          = 0;
+        uint64_t first_event_      = 0;
+        size_t   usage_            = 0;
+        size_t   live_allocations_ = 0;
+    };
+
+    /// Capacity of the timeline ring, 0 when the timeline is disabled
+    std::atomic<size_t> timeline_capacity_{0};
+
+    /// Mutex for thread-safe access to the timeline
+    mutable std::mutex timeline_mutex_;
+
+    /// Ring of events; event i is at timeline_events_[i & (capacity - 1)]
+    std::vector<timeline_event> timeline_events_;
+
+    /// Keyframes whose events are all still in the ring, oldest first
+    std::deque<timeline_keyframe> timeline_keyframes_;
+
+    /// Index of the next event
+    uint64_t timeline_next_event_ = 0;
+
+    /// Usage and live allocations after the last event
+    size_t timeline_usage_            = 0;
+    size_t timeline_live_allocations_ = 0;
+
+    /**
+     * @brief Append an event to the timeline, if it is enabled
+     */
+    void record_timeline_event(int64_t delta_bytes, uint32_t stack_id, bool is_free);
+
+    /**
+     * @brief Clear the timeline, restarting it from the given state
+     */
+    void restart_timeline(size_t usage, size_t live_allocations);
+
+    /**
+     * @brief Decide whether an allocation of `size` bytes is sampled
+     */
+    bool should_sample(size_t size);
+
+    /**
+     * @brief Intern the current call stack and attribute `size` bytes to it
+     * @return Stack ID, 0 if no stack could be captured
+     */
+    uint32_t record_sampled_stack(size_t size);
+
+    /**
+     * @brief Release `size` bytes of a sampled allocation from its stack
+     */
+    void release_sampled_stack(uint32_t stack_id, size_t size);
+
     /**
      * @brief Get current process memory usage (platform-specific)
      * @return Process memory usage in bytes
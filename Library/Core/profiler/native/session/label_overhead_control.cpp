@@ -0,0 +1,97 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#include "label_overhead_control.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+namespace quarisma
+{
+
+double label_overhead_control::label_stats::mean_overhead_ns() const noexcept
+{
+    return recorded_ == 0 ? 0.0
+                          : static_cast<double>(overhead_ns_) / static_cast<double>(recorded_);
+}
+
+label_overhead_control::label_overhead_control(std::int64_t budget_ns, std::uint32_t sample_period)
+    : budget_ns_(budget_ns), sample_period_((std::max)(sample_period, std::uint32_t{1}))
+{
+}
+
+label_overhead_control::label& label_overhead_control::find(const std::string& name)
+{
+    label* result = nullptr;
+    labels_.cvisit(name, [&result](const std::unique_ptr<label>& l) { result = l.get(); });
+    if (result == nullptr)
+    {
+        labels_.emplace_or_visit(
+            name,
+            [&result](std::unique_ptr<label>& l) { result = l.get(); },
+            std::make_unique<label>());
+    }
+    return *result;
+}
+
+bool label_overhead_control::admit(label& l) noexcept
+{
+    std::uint64_t const call = l.calls_.fetch_add(1, std::memory_order_relaxed);
+    return !l.sampled_.load(std::memory_order_relaxed) || call % sample_period_ == 0;
+}
+
+void label_overhead_control::charge(label& l, std::int64_t cost_ns) noexcept
+{
+    l.recorded_.fetch_add(1, std::memory_order_relaxed);
+    std::int64_t const total =
+        l.overhead_ns_.fetch_add(cost_ns, std::memory_order_relaxed) + cost_ns;
+    if (total > budget_ns_ && !l.sampled_.load(std::memory_order_relaxed))
+    {
+        l.sampled_.store(true, std::memory_order_relaxed);
+    }
+}
+
+std::vector<label_overhead_control::label_stats> label_overhead_control::collect() const
+{
+    std::vector<label_stats> result;
+    labels_.cvisit_all(
+        [&result](const std::string& name, const std::unique_ptr<label>& l)
+        {
+            label_stats stats;
+            stats.label_       = name;
+            stats.calls_       = l->calls_.load(std::memory_order_relaxed);
+            stats.recorded_    = l->recorded_.load(std::memory_order_relaxed);
+            stats.overhead_ns_ = l->overhead_ns_.load(std::memory_order_relaxed);
+            stats.sampled_     = l->sampled_.load(std::memory_order_relaxed);
+            result.push_back(std::move(stats));
+        });
+    std::sort(
+        result.begin(),
+        result.end(),
+        [](const label_stats& a, const label_stats& b)
+        {
+            return std::tie(b.sampled_, b.overhead_ns_, a.label_) <
+                   std::tie(a.sampled_, a.overhead_ns_, b.label_);
+        });
+    return result;
+}
+
+}  // namespace quarisma
@@ -0,0 +1,121 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/export.h"
+#include "util/concurrent_flat_map.h"
+
+namespace quarisma
+{
+
+/**
+ * @class label_overhead_control
+ * @brief Switches the hottest profiler_scope labels to sampled recording
+ *
+ * The session times the bookkeeping of each recorded scope and charges it to
+ * the scope's label. Once a label has cost more than the budget, only one in
+ * sample_period() of its scopes is recorded in full: the others are counted
+ * but neither timed nor added to the scope tree. collect() reports the exact
+ * call counts next to the recorded ones, so a label hit millions of times
+ * keeps its count while its timing comes from a sample.
+ *
+ * **Thread Safety**: All member functions are thread-safe
+ */
+class QUARISMA_VISIBILITY label_overhead_control
+{
+public:
+    /**
+     * @brief Recording cost and sampling state of one label
+     */
+    struct label_stats
+    {
+        std::string   label_;
+        std::uint64_t calls_{};        ///< Scopes of the label, recorded or not
+        std::uint64_t recorded_{};     ///< Scopes recorded in full
+        std::int64_t  overhead_ns_{};  ///< Measured cost of recording them
+        bool          sampled_{};      ///< Whether the label went over budget
+
+        /// Average recording cost of a recorded scope in nanoseconds
+        QUARISMA_API double mean_overhead_ns() const noexcept;
+    };
+
+    /**
+     * @brief Counters of one label, shared by all of its scopes
+     */
+    class label
+    {
+    public:
+        label() = default;
+
+    private:
+        friend class label_overhead_control;
+
+        std::atomic<std::uint64_t> calls_{0};
+        std::atomic<std::uint64_t> recorded_{0};
+        std::atomic<std::int64_t>  overhead_ns_{0};
+        std::atomic<bool>          sampled_{false};
+    };
+
+    /**
+     * @param budget_ns Recording cost a label may take before it is sampled
+     * @param sample_period Scopes of a sampled label per recorded one, at least 1
+     */
+    QUARISMA_API label_overhead_control(std::int64_t budget_ns, std::uint32_t sample_period);
+
+    /**
+     * @brief The counters of `name`, created on first use; the reference stays valid
+     */
+    QUARISMA_API label& find(const std::string& name);
+
+    /**
+     * @brief Counts a scope of `l` and tells whether to record it
+     */
+    QUARISMA_API bool admit(label& l) noexcept;
+
+    /**
+     * @brief Charges the cost of recording an admitted scope to `l`
+     *
+     * The label switches to sampling once its total goes over the budget.
+     */
+    QUARISMA_API void charge(label& l, std::int64_t cost_ns) noexcept;
+
+    /**
+     * @brief Counters of every label, sampled labels first, then by overhead
+     */
+    QUARISMA_API std::vector<label_stats> collect() const;
+
+    std::int64_t  budget_ns() const noexcept { return budget_ns_; }
+    std::uint32_t sample_period() const noexcept { return sample_period_; }
+
+private:
+    std::int64_t  budget_ns_;
+    std::uint32_t sample_period_;
+
+    concurrent_flat_map<std::string, std::unique_ptr<label>> labels_;
+};
+
+}  // namespace quarisma
@@ -37,6 +37,7 @@
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <map>
@@ -49,12 +50,16 @@
 
 #include "common/macros.h"
 #include "logging/logger.h"
+#include "profiler/base/external_ranges.h"
 #include "profiler/native/analysis/statistical_analyzer.h"
 #include "profiler/native/core/profiler_collection.h"
 #include "profiler/native/core/profiler_factory.h"
+#include "profiler/native/exporters/folded_stacks_exporter.h"
 #include "profiler/native/exporters/xplane/xplane_schema.h"
 #include "profiler/native/memory/memory_tracker.h"
+#include "profiler/native/session/profiler_aggregator.h"
 #include "profiler/native/session/profiler_report.h"
+#include "util/tsc_clock.h"
 
 // Prevent Windows min/max macros from interfering with std::numeric_limits
 #ifdef _WIN32
@@ -122,10 +127,9 @@ std::string JsonQuote(std::string_view value)
  * Recursively traverses the scope hierarchy and generates Chrome Trace Event Format
  * events for each scope, with proper timestamp and duration calculations.
  */
-std::string ConvertScopeDataToChromeTrace(
-    const profiler_scope_data* root_scope, uint64_t base_time_ns)
+void ConvertScopeDataToChromeTrace(
+    const profiler_scope_data* root_scope, uint64_t base_time_ns, std::ostream& out)
 {
-    std::ostringstream out;
     // Use nanoseconds consistently for Chrome Trace output
     out << R"({"displayTimeUnit":"ns","metadata":{"highres-ticks":true},"traceEvents":[)";
 
@@ -213,14 +217,12 @@ std::string ConvertScopeDataToChromeTrace(
     }
 
     out << "]}";
-    return out.str();
 }
 
-std::string ConvertXSpaceToChromeTrace(const x_space& space)
+void ConvertXSpaceToChromeTrace(const x_space& space, std::ostream& out)
 {
     constexpr uint32_t kPid = 0;
 
-    std::ostringstream out;
     // Use nanoseconds consistently for Chrome Trace output
     out << R"({"displayTimeUnit":"ns","metadata":{"highres-ticks":true},"traceEvents":[)";
     bool first        = true;
@@ -317,7 +319,6 @@ std::string ConvertXSpaceToChromeTrace(const x_space& space)
     }
 
     out << "]}";
-    return out.str();
 }
 
 }  // namespace
@@ -487,7 +488,8 @@ bool profiler_session::start()
         backend_profilers_.reset();
     }
 
-    start_time_ = std::chrono::high_resolution_clock::now();
+    start_time_     = std::chrono::high_resolution_clock::now();
+    start_clock_ns_ = quarisma::tsc_clock::now_ns();
 
     // Initialize root scope for hierarchical profiling
     if (options_.enable_hierarchical_profiling_)
@@ -514,6 +516,20 @@ bool profiler_session::start()
         statistical_analyzer_->start_analysis();
     }
 
+    if (options_.enable_thread_pool_stats_)
+    {
+        thread_pool_stats_.clear();
+        quarisma::pool_instrumentation::reset();
+        quarisma::pool_instrumentation::set_enabled(true);
+    }
+
+    if (options_.enable_lock_stats_)
+    {
+        lock_stats_.clear();
+        quarisma::profiled_mutex::reset();
+        quarisma::profiled_mutex::set_enabled(true);
+    }
+
     set_current_session(this);
 
     return true;
@@ -549,6 +565,18 @@ bool profiler_session::stop()
         statistical_analyzer_->stop_analysis();
     }
 
+    if (options_.enable_thread_pool_stats_)
+    {
+        quarisma::pool_instrumentation::set_enabled(false);
+        thread_pool_stats_ = quarisma::pool_instrumentation::collect();
+    }
+
+    if (options_.enable_lock_stats_)
+    {
+        quarisma::profiled_mutex::set_enabled(false);
+        lock_stats_ = quarisma::profiled_mutex::collect();
+    }
+
     if (backend_profilers_)
     {
         std::string           backend_errors;
@@ -591,6 +619,24 @@ bool profiler_session::stop()
         xspace_ready_ = false;
     }
 
+    if (xspace_ready_ && !options_.aggregator_channel_.empty())
+    {
+        try
+        {
+            profiler_collector collector(options_.aggregator_channel_);
+            if (!collector.send_session(*this))
+            {
+                QUARISMA_LOG_WARNING(
+                    "Profiler aggregator {} is not receiving", options_.aggregator_channel_);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            QUARISMA_LOG_WARNING(
+                "Cannot send the profile to {}: {}", options_.aggregator_channel_, e.what());
+        }
+    }
+
     if (current_session() == this)
     {
         set_current_session(nullptr);
@@ -647,6 +693,12 @@ void profiler_session::initialize_components()
         statistical_analyzer_->set_worker_threads_hint(options_.thread_pool_size_);
     }
 
+    if (options_.enable_overhead_control_)
+    {
+        overhead_control_ = std::make_unique<quarisma::label_overhead_control>(
+            options_.overhead_budget_ns_, options_.overhead_sample_period_);
+    }
+
     backend_profile_options_ = build_backend_profile_options();
 }
 
@@ -677,12 +729,28 @@ profile_options profiler_session::build_backend_profile_options() const
     opts.set_include_dataset_ops(false);
     opts.set_host_tracer_level(options_.enable_timing_ ? 2U : 0U);
     opts.set_device_tracer_level(0);
-    opts.set_python_tracer_level(0);
+    opts.set_python_tracer_level(options_.python_sampling_frequency_hz_ > 0 ? 1U : 0U);
+    opts.set_python_sampling_frequency_hz(options_.python_sampling_frequency_hz_);
+    opts.set_cpu_sampling_frequency_hz(options_.cpu_sampling_frequency_hz_);
     opts.set_enable_hlo_proto(false);
     opts.set_duration_ms(0);
     return opts;
 }
 
+void profiler_session::add_planes(x_space&& space)
+{
+    normalize_xspace(&space);
+    for (auto& plane : *space.mutable_planes())
+    {
+        *xspace_.add_planes() = std::move(plane);
+    }
+    if (xspace_.hostnames().empty())
+    {
+        xspace_.add_hostname("localhost");
+    }
+    xspace_ready_ = true;
+}
+
 void profiler_session::normalize_xspace(x_space* space) const
 {
     if (space == nullptr)
@@ -749,15 +817,22 @@ void profiler_session::register_scope_end(const quarisma::profiler_scope* scope)
 
     if (thread_current_scope_ != nullptr)
     {
-        thread_current_scope_->end_time_     = scope->data().end_time_;
-        thread_current_scope_->memory_stats_ = scope->data().memory_stats_;
-        thread_current_scope_->timing_stats_ = scope->data().timing_stats_;
+        thread_current_scope_->end_time_          = scope->data().end_time_;
+        thread_current_scope_->memory_stats_      = scope->data().memory_stats_;
+        thread_current_scope_->timing_stats_      = scope->data().timing_stats_;
+        thread_current_scope_->hardware_counters_ = scope->data().hardware_counters_;
 
         // Move back to parent scope
         thread_current_scope_ = thread_current_scope_->parent_;
     }
 }
 
+std::chrono::high_resolution_clock::time_point profiler_session::scope_time() const noexcept
+{
+    return start_time_ + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+                             std::chrono::nanoseconds(tsc_clock::now_ns() - start_clock_ns_));
+}
+
 //=============================================================================
 // profiler_scope Implementation
 //=============================================================================
@@ -769,6 +844,13 @@ profiler_scope::profiler_scope(const std::string& name, quarisma::profiler_sessi
     data_->name_      = name;
     data_->thread_id_ = std::this_thread::get_id();
 
+    // Shows in Nsight and VTune timelines whether or not a session records
+    if (quarisma::profiler::external_ranges::active())
+    {
+        quarisma::profiler::external_ranges::push(data_->name_);
+        external_range_ = true;
+    }
+
     // Auto-start if session is active
     if ((session_ != nullptr) && session_->is_active())
     {
@@ -782,6 +864,10 @@ profiler_scope::~profiler_scope()
     {
         stop();
     }
+    if (external_range_)
+    {
+        quarisma::profiler::external_ranges::pop();
+    }
 }
 
 void profiler_scope::start()
@@ -797,8 +883,22 @@ void profiler_scope::start()
         return;
     }
 
-    started_           = true;
-    data_->start_time_ = std::chrono::high_resolution_clock::now();
+    started_ = true;
+
+    int64_t start_ns = 0;
+    if (session_->overhead_control_ != nullptr)
+    {
+        label_ = &session_->overhead_control_->find(data_->name_);
+        if (!session_->overhead_control_->admit(*label_))
+        {
+            // Counted, but neither timed nor added to the tree
+            stopped_ = true;
+            return;
+        }
+        start_ns = tsc_clock::now_ns();
+    }
+
+    data_->start_time_ = session_->scope_time();
 
     // Register with session for hierarchical tracking
     // session_ is guaranteed non-null here due to check at line 788
@@ -816,11 +916,29 @@ void profiler_scope::start()
             data_->memory_stats_    = start_memory_stats_;
             has_start_memory_stats_ = true;
         }
+
+        // Read last so that the scope's bookkeeping is not counted
+        if (session_->options_.enable_hardware_counters_)
+        {
+            has_start_hardware_counters_ =
+                quarisma::profiler::read_thread_hardware_counters(&start_hardware_counters_);
+        }
+    }
+
+    if (label_ != nullptr)
+    {
+        start_cost_ns_ = tsc_clock::now_ns() - start_ns;
     }
 }
 
 void profiler_scope::stop()
 {
+    if (external_range_)
+    {
+        quarisma::profiler::external_ranges::pop();
+        external_range_ = false;
+    }
+
     // Skip all work if no session or hierarchical profiling disabled
     if (session_ == nullptr || !session_->options_.enable_hierarchical_profiling_)
     {
@@ -832,8 +950,16 @@ void profiler_scope::stop()
         return;
     }
 
-    stopped_         = true;
-    data_->end_time_ = std::chrono::high_resolution_clock::now();
+    stopped_                    = true;
+    int64_t const stop_start_ns = label_ != nullptr ? tsc_clock::now_ns() : 0;
+    quarisma::profiler::hardware_counter_values end_hardware_counters;
+    if (has_start_hardware_counters_ &&
+        quarisma::profiler::read_thread_hardware_counters(&end_hardware_counters))
+    {
+        data_->hardware_counters_ = quarisma::profiler::hardware_counter_delta(
+            start_hardware_counters_, end_hardware_counters);
+    }
+    data_->end_time_ = session_->scope_time();
 
     // Calculate timing statistics
     double const duration_ms = data_->get_duration_ms();
@@ -880,6 +1006,41 @@ void profiler_scope::stop()
     }
 
     memory_annotation_.reset();
+
+    if (label_ != nullptr)
+    {
+        session_->overhead_control_->charge(
+            *label_, start_cost_ns_ + tsc_clock::now_ns() - stop_start_ns);
+    }
+}
+
+std::vector<quarisma::pool_instrumentation::worker_stats> profiler_session::thread_pool_stats()
+    const
+{
+    if (!options_.enable_thread_pool_stats_)
+    {
+        return {};
+    }
+    return active_.load() ? quarisma::pool_instrumentation::collect() : thread_pool_stats_;
+}
+
+std::vector<quarisma::profiled_mutex::site_stats> profiler_session::lock_stats() const
+{
+    if (!options_.enable_lock_stats_)
+    {
+        return {};
+    }
+    return active_.load() ? quarisma::profiled_mutex::collect() : lock_stats_;
+}
+
+std::vector<quarisma::label_overhead_control::label_stats> profiler_session::label_overheads()
+    const
+{
+    if (overhead_control_ == nullptr)
+    {
+        return {};
+    }
+    return overhead_control_->collect();
 }
 
 std::string profiler_session::generate_chrome_trace_json() const
@@ -890,11 +1051,15 @@ std::string profiler_session::generate_chrome_trace_json() const
         uint64_t const base_time_ns =
             std::chrono::duration_cast<std::chrono::nanoseconds>(start_time_.time_since_epoch())
                 .count();
-        return ConvertScopeDataToChromeTrace(root_scope_.get(), base_time_ns);
+        std::ostringstream out;
+        ConvertScopeDataToChromeTrace(root_scope_.get(), base_time_ns, out);
+        return out.str();
     }
     if (xspace_ready_)
     {
-        return ConvertXSpaceToChromeTrace(xspace_);
+        std::ostringstream out;
+        ConvertXSpaceToChromeTrace(xspace_, out);
+        return out.str();
     }
     return "{}";
 }
@@ -907,26 +1072,29 @@ bool profiler_session::write_chrome_trace(const std::string& filename) const
         return false;
     }
 
-    // Prefer hierarchical scope data if available, otherwise use xspace
-    std::string json;
+    // Prefer hierarchical scope data if available, otherwise use xspace. The
+    // JSON goes straight to the file instead of being built in memory first.
     if (root_scope_ != nullptr && options_.enable_hierarchical_profiling_)
     {
         uint64_t const base_time_ns =
             std::chrono::duration_cast<std::chrono::nanoseconds>(start_time_.time_since_epoch())
                 .count();
-        json = ConvertScopeDataToChromeTrace(root_scope_.get(), base_time_ns);
+        ConvertScopeDataToChromeTrace(root_scope_.get(), base_time_ns, out);
     }
     else if (xspace_ready_)
     {
-        json = ConvertXSpaceToChromeTrace(xspace_);
+        ConvertXSpaceToChromeTrace(xspace_, out);
     }
     else
     {
         return false;
     }
-
-    out << json;
     return out.good();
 }
 
+bool profiler_session::write_folded_stacks(const std::string& filename) const
+{
+    return xspace_ready_ && profiler::export_folded_stacks_to_file(xspace_, filename);
+}
+
 }  // namespace quarisma
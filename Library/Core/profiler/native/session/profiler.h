@@ -58,11 +58,15 @@
 #include <vector>
 
 #include "common/macros.h"
+#include "parallel/pool_instrumentation.h"
+#include "parallel/profiled_mutex.h"
 #include "profiler/native/core/profiler_interface.h"
 #include "profiler/native/core/profiler_lock.h"
 #include "profiler/native/core/profiler_options.h"
+#include "profiler/native/cpu/hardware_counters.h"
 #include "profiler/native/exporters/xplane/xplane.h"
 #include "profiler/native/memory/scoped_memory_debug_annotation.h"
+#include "profiler/native/session/label_overhead_control.h"
 #include "profiler/native/tracing/traceme.h"
 
 namespace quarisma
@@ -134,6 +138,33 @@ struct profiler_options
 
     /// Size of thread pool for concurrent profiling operations
     size_t thread_pool_size_ = std::thread::hardware_concurrency();
+
+    /// Stack samples per second of CPU time taken by the sampling profiler; 0 disables it
+    uint32_t cpu_sampling_frequency_hz_ = 0;
+
+    /// Python stack samples per second (see python_sampler.h); 0 disables them
+    uint32_t python_sampling_frequency_hz_ = 0;
+
+    /// Count cycles, instructions, LLC, branch and dTLB misses of every profiler_scope
+    bool enable_hardware_counters_ = false;
+
+    /// Measure queue wait and utilization of the thread pool workers (see pool_instrumentation)
+    bool enable_thread_pool_stats_ = false;
+
+    /// Count contention, wait and hold time of every profiled_mutex site
+    bool enable_lock_stats_ = false;
+
+    /// Switch the profiler_scope labels that cost too much to record to sampled recording
+    bool enable_overhead_control_ = false;
+
+    /// Recording cost in nanoseconds a label may take before it is sampled
+    int64_t overhead_budget_ns_ = 10 * 1000 * 1000;
+
+    /// Scopes of a sampled label per scope recorded in full
+    uint32_t overhead_sample_period_ = 100;
+
+    /// Channel of a profiler_aggregator that stop() sends the collected XSpace to; empty for none
+    std::string aggregator_channel_;
 };
 
 /**
@@ -247,6 +278,9 @@ struct profiler_scope_data
     /// ID of the thread that executed this scope
     std::thread::id thread_id_;
 
+    /// Hardware counter deltas of this scope, empty unless enabled and available
+    quarisma::profiler::hardware_counter_values hardware_counters_;
+
     /// Nesting depth level in the profiling hierarchy (0 = root)
     size_t depth_level_ = 0;
 
@@ -353,6 +387,23 @@ public:
      */
     bool has_collected_xspace() const { return xspace_ready_; }
 
+    /**
+     * @brief Add planes recorded outside the session to collected_xspace()
+     *
+     * For the GPU planes of a Kineto run, e.g. with the per-kernel metrics of
+     * add_kernel_metrics(). The line timestamps, Unix time in nanoseconds,
+     * are rebased on the session start like those the session collected.
+     * Call it once the session is stopped.
+     */
+    QUARISMA_API void add_planes(quarisma::x_space&& space);
+
+    /**
+     * @brief Unix time the session started, in nanoseconds
+     *
+     * The line timestamps of collected_xspace() count from it.
+     */
+    uint64_t start_time_ns() const { return start_time_ns_; }
+
     /**
      * @brief Generate a Chrome trace (JSON) representation of collected profiler data.
      */
@@ -363,6 +414,13 @@ public:
      */
     QUARISMA_API bool write_chrome_trace(const std::string& filename) const;
 
+    /**
+     * @brief Write the CPU samples as folded stacks, the input of flame graph tools.
+     * @return false if the session did not sample (see with_cpu_sampling()) or
+     *         the file cannot be written
+     */
+    QUARISMA_API bool write_folded_stacks(const std::string& filename) const;
+
     /**
      * @brief Export profiling report to a file
      * @param filename Path to the output file
@@ -402,6 +460,38 @@ public:
         return statistical_analyzer_.get();
     }
 
+    /**
+     * @brief Per-worker queueing and utilization of the thread pools
+     *
+     * Live while the session runs, frozen when it stops. Empty unless the
+     * session was built with_thread_pool_stats().
+     */
+    QUARISMA_API std::vector<quarisma::pool_instrumentation::worker_stats> thread_pool_stats()
+        const;
+
+    /**
+     * @brief Contention of every profiled_mutex site, most waited on first
+     *
+     * Live while the session runs, frozen when it stops. Empty unless the
+     * session was built with_lock_stats().
+     */
+    QUARISMA_API std::vector<quarisma::profiled_mutex::site_stats> lock_stats() const;
+
+    /**
+     * @brief Recording cost and sampling state of every profiler_scope label
+     *
+     * Sampled labels come first: their calls are exact, their timing comes
+     * from the recorded scopes only. Empty unless the session was built
+     * with_overhead_control().
+     */
+    QUARISMA_API std::vector<quarisma::label_overhead_control::label_stats> label_overheads()
+        const;
+
+    /**
+     * @brief Access the configuration of this session
+     */
+    const quarisma::profiler_options& options() const { return options_; }
+
     /**
      * @brief Get the current active profiling session (thread-safe)
      * @return Pointer to current session or nullptr if none active
@@ -439,6 +529,9 @@ private:
     uint64_t start_time_ns_ = 0;
     uint64_t end_time_ns_   = 0;
 
+    /// tsc_clock reading taken together with start_time_, see scope_time()
+    int64_t start_clock_ns_ = 0;
+
     /// Memory tracking component
     std::unique_ptr<quarisma::memory_tracker> memory_tracker_;
 
@@ -484,6 +577,15 @@ private:
     quarisma::x_space xspace_;
     bool            xspace_ready_ = false;
 
+    /// Thread pool counters captured when the session stopped
+    std::vector<quarisma::pool_instrumentation::worker_stats> thread_pool_stats_;
+
+    /// Lock contention counters captured when the session stopped
+    std::vector<quarisma::profiled_mutex::site_stats> lock_stats_;
+
+    /// Per-label recording cost over the lifetime of the session, when enabled
+    std::unique_ptr<quarisma::label_overhead_control> overhead_control_;
+
     /// Allow profiler_scope to access private registration methods
     friend class quarisma::profiler_scope;
 
@@ -498,6 +600,14 @@ private:
      * @param scope Pointer to the scope being ended
      */
     void register_scope_end(const quarisma::profiler_scope* scope);
+
+    /**
+     * @brief Current time for scope boundaries on the start_time_ timeline
+     *
+     * Scopes are opened and closed on hot paths, so they read tsc_clock and are
+     * placed relative to start_time_ instead of calling high_resolution_clock.
+     */
+    std::chrono::high_resolution_clock::time_point scope_time() const noexcept;
 };
 
 /**
@@ -648,6 +758,104 @@ public:
         return *this;
     }
 
+    /**
+     * @brief Enable or disable sampling of the CPU stacks, for uninstrumented code
+     * @param frequency_hz Samples per second of CPU time, 0 to disable
+     * @return Reference to this profiler_session_builder for method chaining
+     */
+    profiler_session_builder& with_cpu_sampling(uint32_t frequency_hz = 99)
+    {
+        options_.cpu_sampling_frequency_hz_ = frequency_hz;
+        return *this;
+    }
+
+    /**
+     * @brief Enable or disable sampling of the Python stacks, without per-call hooks
+     * @param frequency_hz Samples per second of wall-clock time, 0 to disable
+     * @return Reference to this profiler_session_builder for method chaining
+     *
+     * Needs the Python bindings to have registered a python_stack_reader.
+     * With with_cpu_sampling() too, the folded stacks join both.
+     */
+    profiler_session_builder& with_python_sampling(uint32_t frequency_hz = 99)
+    {
+        options_.python_sampling_frequency_hz_ = frequency_hz;
+        return *this;
+    }
+
+    /**
+     * @brief Enable or disable hardware performance counters per profiler scope
+     * @param enable true to count cycles, instructions, LLC, branch and dTLB misses
+     * @return Reference to this profiler_session_builder for method chaining
+     *
+     * Needs Linux and access to the PMU (perf_event_paranoid <= 2); scopes
+     * have no counters otherwise.
+     */
+    profiler_session_builder& with_hardware_counters(bool enable = true)
+    {
+        options_.enable_hardware_counters_ = enable;
+        return *this;
+    }
+
+    /**
+     * @brief Enable or disable thread pool queueing and utilization counters
+     * @param enable true to measure the jobs of parallel_thread_pool and
+     *        threaded_callback_queue while the session runs
+     * @return Reference to this profiler_session_builder for method chaining
+     *
+     * The report then shows per-worker utilization and queue-wait histograms.
+     */
+    profiler_session_builder& with_thread_pool_stats(bool enable = true)
+    {
+        options_.enable_thread_pool_stats_ = enable;
+        return *this;
+    }
+
+    /**
+     * @brief Enable or disable lock contention counters
+     * @param enable true to time the contended acquisitions of every
+     *        profiled_mutex (allocators, thread pool queues, logger sinks)
+     * @return Reference to this profiler_session_builder for method chaining
+     *
+     * The report then lists the lock sites by total wait time.
+     */
+    profiler_session_builder& with_lock_stats(bool enable = true)
+    {
+        options_.enable_lock_stats_ = enable;
+        return *this;
+    }
+
+    /**
+     * @brief Sample the profiler_scope labels whose recording costs too much
+     * @param budget_ns Recording cost a label may take before it is sampled
+     * @param sample_period Scopes of a sampled label per scope recorded in full
+     * @return Reference to this profiler_session_builder for method chaining
+     *
+     * Counts stay exact; the report marks the labels whose timing was sampled.
+     */
+    profiler_session_builder& with_overhead_control(
+        int64_t budget_ns = 10 * 1000 * 1000, uint32_t sample_period = 100)
+    {
+        options_.enable_overhead_control_ = true;
+        options_.overhead_budget_ns_      = budget_ns;
+        options_.overhead_sample_period_  = sample_period;
+        return *this;
+    }
+
+    /**
+     * @brief Send the collected XSpace to a profiler_aggregator when the session stops
+     * @param channel_name Channel the aggregator created, empty to send nothing
+     * @return Reference to this profiler_session_builder for method chaining
+     *
+     * The aggregator merges the timelines of every process sending to it;
+     * see profiler_aggregator.h.
+     */
+    profiler_session_builder& with_aggregator(std::string channel_name)
+    {
+        options_.aggregator_channel_ = std::move(channel_name);
+        return *this;
+    }
+
     /**
      * @brief Build the configured profiler session
      * @return Unique pointer to the created profiler session
@@ -728,12 +936,25 @@ private:
     /// Whether start_memory_stats_ contains valid data
     bool has_start_memory_stats_ = false;
 
+    /// Hardware counters read at scope start, when has_start_hardware_counters_
+    quarisma::profiler::hardware_counter_values start_hardware_counters_;
+    bool                                        has_start_hardware_counters_ = false;
+
     /// Flag indicating if profiling has been started
     bool started_ = false;
 
     /// Flag indicating if profiling has been stopped
     bool stopped_ = false;
 
+    /// Whether an NVTX/ITT range is open for this scope (see external_ranges)
+    bool external_range_ = false;
+
+    /// Label counters of the session's overhead control, or null without it
+    quarisma::label_overhead_control::label* label_ = nullptr;
+
+    /// Recording cost of start(), charged to label_ when the scope stops
+    int64_t start_cost_ns_ = 0;
+
     std::unique_ptr<scoped_memory_debug_annotation> memory_annotation_;
 };
 
@@ -0,0 +1,741 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler_aggregator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "logging/logger.h"
+#include "profiler/native/exporters/xplane/xplane_utils.h"
+#include "profiler/native/session/profiler.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace
+{
+constexpr uint32_t chunk_magic = 0x47415051;  // "QPAG"
+
+enum message_kind : uint8_t
+{
+    space_message = 1,
+    stats_message = 2,
+};
+
+// Prefix of every chunk; a message is its chunks' payloads in index order
+struct chunk_header
+{
+    uint32_t magic;
+    uint8_t  kind;
+    uint8_t  reserved[3];
+    uint32_t index;
+    uint32_t count;
+    uint64_t source_id;
+    uint64_t sequence;
+    int64_t  sent_unix_ns;
+};
+
+static_assert(sizeof(chunk_header) == 40, "chunk_header is sent as raw bytes");
+
+uint64_t process_id()
+{
+#ifdef _WIN32
+    return static_cast<uint64_t>(::_getpid());
+#else
+    return static_cast<uint64_t>(::getpid());
+#endif
+}
+
+// Fields in host byte order, as both ends run on one host
+class wire_writer
+{
+public:
+    explicit wire_writer(std::string& out) : out_(out) {}
+
+    template <typename T>
+    void put(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "put() copies bytes");
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void put_string(std::string_view value)
+    {
+        put(static_cast<uint64_t>(value.size()));
+        out_.append(value.data(), value.size());
+    }
+
+private:
+    std::string& out_;
+};
+
+// Reads what wire_writer wrote; a short or corrupt message clears ok()
+class wire_reader
+{
+public:
+    wire_reader(const char* data, size_t size) : p_(data), end_(data + size) {}
+
+    template <typename T>
+    T get()
+    {
+        T value{};
+        if (remaining() < sizeof(T))
+        {
+            fail();
+            return value;
+        }
+        std::memcpy(&value, p_, sizeof(T));
+        p_ += sizeof(T);
+        return value;
+    }
+
+    std::string get_string()
+    {
+        auto const size = get<uint64_t>();
+        if (size > remaining())
+        {
+            fail();
+            return {};
+        }
+        std::string value(p_, static_cast<size_t>(size));
+        p_ += size;
+        return value;
+    }
+
+    // An element count, bounded by the bytes left so corrupt input allocates little
+    size_t get_count(size_t min_element_bytes)
+    {
+        auto const count = get<uint64_t>();
+        if (count > remaining() / min_element_bytes)
+        {
+            fail();
+            return 0;
+        }
+        return static_cast<size_t>(count);
+    }
+
+    bool ok() const noexcept { return ok_; }
+    bool done() const noexcept { return ok_ && p_ == end_; }
+
+private:
+    size_t remaining() const noexcept { return static_cast<size_t>(end_ - p_); }
+
+    void fail() noexcept
+    {
+        ok_ = false;
+        p_  = end_;
+    }
+
+    const char* p_;
+    const char* end_;
+    bool        ok_ = true;
+};
+
+void write_stats(wire_writer& out, const std::vector<xstat>& stats)
+{
+    out.put(static_cast<uint64_t>(stats.size()));
+    for (const xstat& stat : stats)
+    {
+        auto const value_case = stat.value_case();
+        out.put(stat.metadata_id());
+        out.put(static_cast<uint8_t>(value_case));
+        switch (value_case)
+        {
+        case xstat::value_case_type::kDoubleValue:
+            out.put(stat.double_value());
+            break;
+        case xstat::value_case_type::kUint64Value:
+            out.put(stat.uint64_value());
+            break;
+        case xstat::value_case_type::kInt64Value:
+            out.put(stat.int64_value());
+            break;
+        case xstat::value_case_type::kRefValue:
+            out.put(stat.ref_value());
+            break;
+        case xstat::value_case_type::kStrValue:
+            out.put_string(stat.str_value());
+            break;
+        case xstat::value_case_type::kBytesValue:
+            out.put_string(stat.bytes_value());
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void read_stats(wire_reader& in, std::vector<xstat>& stats)
+{
+    size_t const count = in.get_count(9);
+    stats.resize(count);
+    for (xstat& stat : stats)
+    {
+        stat.set_metadata_id(in.get<int64_t>());
+        switch (static_cast<xstat::value_case_type>(in.get<uint8_t>()))
+        {
+        case xstat::value_case_type::kDoubleValue:
+            stat.set_value(in.get<double>());
+            break;
+        case xstat::value_case_type::kUint64Value:
+            stat.set_value(in.get<uint64_t>());
+            break;
+        case xstat::value_case_type::kInt64Value:
+            stat.set_value(in.get<int64_t>());
+            break;
+        case xstat::value_case_type::kRefValue:
+            stat.set_ref_value(in.get<int64_t>());
+            break;
+        case xstat::value_case_type::kStrValue:
+            stat.set_value(in.get_string());
+            break;
+        case xstat::value_case_type::kBytesValue:
+        {
+            std::string const bytes = in.get_string();
+            stat.set_value(std::vector<uint8_t>(bytes.begin(), bytes.end()));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void write_strings(wire_writer& out, const std::vector<std::string>& strings)
+{
+    out.put(static_cast<uint64_t>(strings.size()));
+    for (const auto& value : strings)
+    {
+        out.put_string(value);
+    }
+}
+
+void read_strings(wire_reader& in, std::vector<std::string>& strings)
+{
+    strings.resize(in.get_count(sizeof(uint64_t)));
+    for (auto& value : strings)
+    {
+        value = in.get_string();
+    }
+}
+
+void write_space(wire_writer& out, const x_space& space)
+{
+    out.put(static_cast<uint64_t>(space.planes().size()));
+    for (const xplane& plane : space.planes())
+    {
+        out.put(plane.id());
+        out.put_string(plane.name());
+        write_stats(out, plane.stats());
+
+        out.put(static_cast<uint64_t>(plane.event_metadata().size()));
+        for (const auto& [key, metadata] : plane.event_metadata())
+        {
+            out.put(key);
+            out.put(metadata.id());
+            out.put_string(metadata.name());
+            out.put_string(metadata.display_name());
+            out.put_string(std::string_view(
+                reinterpret_cast<const char*>(metadata.metadata().data()),
+                metadata.metadata().size()));
+            write_stats(out, metadata.stats());
+            out.put(static_cast<uint64_t>(metadata.child_id().size()));
+            for (int64_t const child : metadata.child_id())
+            {
+                out.put(child);
+            }
+        }
+
+        out.put(static_cast<uint64_t>(plane.stat_metadata().size()));
+        for (const auto& [key, metadata] : plane.stat_metadata())
+        {
+            out.put(key);
+            out.put(metadata.id());
+            out.put_string(metadata.name());
+            out.put_string(metadata.description());
+        }
+
+        out.put(static_cast<uint64_t>(plane.lines().size()));
+        for (const xline& line : plane.lines())
+        {
+            out.put(line.id());
+            out.put(line.display_id());
+            out.put_string(line.name());
+            out.put_string(line.display_name());
+            out.put(line.timestamp_ns());
+            out.put(line.duration_ps());
+            out.put(static_cast<uint64_t>(line.events().size()));
+            for (const xevent& event : line.events())
+            {
+                out.put(event.metadata_id());
+                out.put(static_cast<uint8_t>(event.has_offset_ps() ? 0 : 1));
+                out.put(event.has_offset_ps() ? event.offset_ps() : event.num_occurrences());
+                out.put(event.duration_ps());
+                write_stats(out, event.stats());
+            }
+        }
+    }
+    write_strings(out, space.errors());
+    write_strings(out, space.warnings());
+    write_strings(out, space.hostnames());
+}
+
+bool read_space(wire_reader& in, x_space& space)
+{
+    auto& planes = *space.mutable_planes();
+    planes.resize(in.get_count(8));
+    for (xplane& plane : planes)
+    {
+        plane.set_id(in.get<int64_t>());
+        plane.set_name(in.get_string());
+        read_stats(in, *plane.mutable_stats());
+
+        for (size_t n = in.get_count(8); n > 0 && in.ok(); --n)
+        {
+            xevent_metadata& metadata = *plane.add_event_metadata(in.get<int64_t>());
+            metadata.set_id(in.get<int64_t>());
+            metadata.set_name(in.get_string());
+            metadata.set_display_name(in.get_string());
+            std::string const bytes = in.get_string();
+            metadata.set_metadata(std::vector<uint8_t>(bytes.begin(), bytes.end()));
+            read_stats(in, *metadata.mutable_stats());
+            auto& children = *metadata.mutable_child_id();
+            children.resize(in.get_count(sizeof(int64_t)));
+            for (int64_t& child : children)
+            {
+                child = in.get<int64_t>();
+            }
+        }
+
+        for (size_t n = in.get_count(8); n > 0 && in.ok(); --n)
+        {
+            x_stat_metadata& metadata = *plane.add_stat_metadata(in.get<int64_t>());
+            metadata.set_id(in.get<int64_t>());
+            metadata.set_name(in.get_string());
+            metadata.set_description(in.get_string());
+        }
+
+        auto& lines = *plane.mutable_lines();
+        lines.resize(in.get_count(8));
+        for (xline& line : lines)
+        {
+            line.set_id(in.get<int64_t>());
+            line.set_display_id(in.get<int64_t>());
+            line.set_name(in.get_string());
+            line.set_display_name(in.get_string());
+            line.set_timestamp_ns(in.get<int64_t>());
+            line.set_duration_ps(in.get<int64_t>());
+            auto& events = *line.mutable_events();
+            events.resize(in.get_count(25));
+            for (xevent& event : events)
+            {
+                event.set_metadata_id(in.get<int64_t>());
+                bool const counted = in.get<uint8_t>() != 0;
+                auto const value   = in.get<int64_t>();
+                if (counted)
+                {
+                    event.set_num_occurrences(value);
+                }
+                else
+                {
+                    event.set_offset_ps(value);
+                }
+                event.set_duration_ps(in.get<int64_t>());
+                read_stats(in, *event.mutable_stats());
+            }
+        }
+    }
+    read_strings(in, *space.mutable_errors());
+    read_strings(in, *space.mutable_warnings());
+    read_strings(in, *space.mutable_hostnames());
+    return in.done();
+}
+
+void write_stat(wire_writer& out, const stat<int64_t>& value)
+{
+    out.put(value.count());
+    out.put(value.first());
+    out.put(value.newest());
+    out.put(value.min());
+    out.put(value.max());
+    out.put(value.sum());
+    out.put(value.squared_sum());
+}
+
+stat<int64_t> read_stat(wire_reader& in)
+{
+    auto const count       = in.get<int64_t>();
+    auto const first       = in.get<int64_t>();
+    auto const newest      = in.get<int64_t>();
+    auto const min         = in.get<int64_t>();
+    auto const max         = in.get<int64_t>();
+    auto const sum         = in.get<int64_t>();
+    auto const squared_sum = in.get<double>();
+    return stat<int64_t>::from_summary(count, first, newest, min, max, sum, squared_sum);
+}
+
+void write_calculator(wire_writer& out, const stats_calculator& stats)
+{
+    write_stat(out, stats.run_total_us());
+    write_stat(out, stats.memory_used());
+    out.put(static_cast<uint64_t>(stats.get_details().size()));
+    for (const auto& entry : stats.get_details())
+    {
+        const auto& node = entry.second;
+        out.put_string(node.name);
+        out.put_string(node.type);
+        out.put(node.run_order);
+        out.put(node.times_called);
+        write_stat(out, node.elapsed_time);
+        write_stat(out, node.mem_used);
+    }
+}
+
+bool read_calculator(wire_reader& in, stats_calculator& stats)
+{
+    auto const run_total_us = read_stat(in);
+    auto const memory       = read_stat(in);
+    stats.merge_run_stats(run_total_us, memory);
+    for (size_t n = in.get_count(32); n > 0 && in.ok(); --n)
+    {
+        stats_calculator::detail node;
+        node.name         = in.get_string();
+        node.type         = in.get_string();
+        node.run_order    = in.get<int64_t>();
+        node.times_called = in.get<int64_t>();
+        node.elapsed_time = read_stat(in);
+        node.mem_used     = read_stat(in);
+        stats.merge_node_stats(node);
+    }
+    return in.done();
+}
+}  // namespace
+
+//=============================================================================
+// profiler_collector Implementation
+//=============================================================================
+
+profiler_collector::profiler_collector(const std::string& channel_name, std::string source)
+    : channel_(io::shm_channel::open(channel_name)),
+      source_(std::move(source)),
+      to_unix_ns_(ApproximateClockToUnixTimeConverter().makeConverter())
+{
+    // Collectors of one process are told apart by the lower half
+    static std::atomic<uint32_t> collectors{0};
+    uint64_t const               pid = process_id();
+    source_id_                       = (pid << 32) | collectors.fetch_add(1);
+    if (source_.empty())
+    {
+        source_ = "pid " + std::to_string(pid);
+    }
+
+    chunk_size_ = channel_.arena() != nullptr
+                      ? (std::min)(channel_.arena()->segment().size() / 8, size_t{1} << 20)
+                      : channel_.slot_size();
+    QUARISMA_CHECK(
+        chunk_size_ > sizeof(chunk_header),
+        "{} has {}-byte messages, too small for the profiler",
+        channel_name,
+        chunk_size_);
+}
+
+profiler_collector::~profiler_collector() = default;
+
+bool profiler_collector::send_space(const x_space& space, int64_t base_unix_ns, duration timeout)
+{
+    std::string payload;
+    wire_writer out(payload);
+    out.put(base_unix_ns);
+    write_space(out, space);
+    return send_message(space_message, payload, timeout);
+}
+
+bool profiler_collector::send_session(const profiler_session& session, duration timeout)
+{
+    return send_space(
+        session.collected_xspace(), static_cast<int64_t>(session.start_time_ns()), timeout);
+}
+
+bool profiler_collector::send_stats(const stats_calculator& stats, duration timeout)
+{
+    std::string payload;
+    wire_writer out(payload);
+    write_calculator(out, stats);
+    return send_message(stats_message, payload, timeout);
+}
+
+bool profiler_collector::send_message(uint8_t kind, const std::string& payload, duration timeout)
+{
+    std::string body;
+    wire_writer out(body);
+    out.put_string(source_);
+    body += payload;
+
+    size_t const per_chunk = chunk_size_ - sizeof(chunk_header);
+    size_t const count     = (std::max)(size_t{1}, (body.size() + per_chunk - 1) / per_chunk);
+    QUARISMA_CHECK(
+        count <= (std::numeric_limits<uint32_t>::max)(),
+        "A profile of {} bytes is too large to send",
+        body.size());
+
+    chunk_header header{};
+    header.magic     = chunk_magic;
+    header.kind      = kind;
+    header.count     = static_cast<uint32_t>(count);
+    header.source_id = source_id_;
+    header.sequence  = sequence_++;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t const offset = i * per_chunk;
+        size_t const bytes  = (std::min)(per_chunk, body.size() - offset);
+        header.index        = static_cast<uint32_t>(i);
+        header.sent_unix_ns = to_unix_ns_(getApproximateTime());
+
+        chunk_.resize(sizeof(header) + bytes);
+        std::memcpy(chunk_.data(), &header, sizeof(header));
+        std::memcpy(chunk_.data() + sizeof(header), body.data() + offset, bytes);
+        if (!channel_.send(chunk_.data(), chunk_.size(), timeout))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//=============================================================================
+// profiler_aggregator Implementation
+//=============================================================================
+
+struct profiler_aggregator::source
+{
+    size_t      index = 0;
+    std::string name;
+
+    // Smallest receive minus send time over the chunks so far
+    int64_t clock_offset_ns = (std::numeric_limits<int64_t>::max)();
+    size_t  spaces          = 0;
+
+    std::unique_ptr<stats_calculator> stats;
+
+    // Messages whose chunks are still arriving, by sequence number
+    struct pending_message
+    {
+        uint32_t    chunks = 0;
+        std::string body;
+    };
+    std::map<uint64_t, pending_message> pending;
+};
+
+profiler_aggregator::profiler_aggregator(const std::string& channel_name)
+    : profiler_aggregator(channel_name, Options())
+{
+}
+
+profiler_aggregator::profiler_aggregator(const std::string& channel_name, const Options& opts)
+    : opts_(opts), to_unix_ns_(ApproximateClockToUnixTimeConverter().makeConverter())
+{
+    io::shm_channel::Options channel_opts;
+    channel_opts.capacity       = opts.capacity;
+    channel_opts.multi_producer = true;
+    channel_opts.arena_size     = opts.arena_size;
+    channel_                    = io::shm_channel::create(channel_name, channel_opts);
+}
+
+profiler_aggregator::~profiler_aggregator() = default;
+
+size_t profiler_aggregator::poll(duration timeout)
+{
+    size_t const before = merged_;
+    while (channel_.receive(
+        [this](const void* data, size_t size) { receive_chunk(data, size); }, timeout))
+    {
+    }
+    return merged_ - before;
+}
+
+stats_calculator profiler_aggregator::merged_stats() const
+{
+    stats_calculator merged{stat_summarizer_options()};
+    for (const auto& from : sources_)
+    {
+        if (from->stats != nullptr)
+        {
+            merged.merge(*from->stats);
+        }
+    }
+    return merged;
+}
+
+std::vector<profiler_aggregator::source_info> profiler_aggregator::sources() const
+{
+    std::vector<source_info> result;
+    result.reserve(sources_.size());
+    for (const auto& from : sources_)
+    {
+        result.push_back(
+            {from->name,
+             opts_.align_clocks ? from->clock_offset_ns : 0,
+             from->spaces,
+             from->stats != nullptr});
+    }
+    return result;
+}
+
+profiler_aggregator::source& profiler_aggregator::source_of(uint64_t id)
+{
+    auto const [it, inserted] = source_index_.emplace(id, sources_.size());
+    if (inserted)
+    {
+        auto& from = sources_.emplace_back(std::make_unique<source>());
+        from->index = it->second;
+    }
+    return *sources_[it->second];
+}
+
+void profiler_aggregator::receive_chunk(const void* data, size_t size)
+{
+    int64_t const received_ns = to_unix_ns_(getApproximateTime());
+
+    chunk_header header{};
+    if (size >= sizeof(header))
+    {
+        std::memcpy(&header, data, sizeof(header));
+    }
+    if (header.magic != chunk_magic || header.index >= header.count)
+    {
+        QUARISMA_LOG_WARNING("Dropping a malformed profiler message of {} bytes", size);
+        return;
+    }
+
+    source& from         = source_of(header.source_id);
+    from.clock_offset_ns = (std::min)(from.clock_offset_ns, received_ns - header.sent_unix_ns);
+
+    auto& message = from.pending[header.sequence];
+    if (header.index != message.chunks)
+    {
+        QUARISMA_LOG_WARNING(
+            "Dropping profiler message {} of {}, which lost chunks",
+            header.sequence,
+            from.name);
+        from.pending.erase(header.sequence);
+        return;
+    }
+    message.body.append(static_cast<const char*>(data) + sizeof(header), size - sizeof(header));
+    if (++message.chunks < header.count)
+    {
+        return;
+    }
+
+    std::string const body = std::move(message.body);
+    from.pending.erase(header.sequence);
+
+    wire_reader in(body.data(), body.size());
+    std::string name = in.get_string();
+    if (in.ok())
+    {
+        from.name = std::move(name);
+    }
+
+    bool decoded = false;
+    if (header.kind == space_message)
+    {
+        auto const base_unix_ns = in.get<int64_t>();
+        x_space    space;
+        decoded = read_space(in, space);
+        if (decoded)
+        {
+            merge_space(from, space, base_unix_ns);
+            ++from.spaces;
+        }
+    }
+    else if (header.kind == stats_message)
+    {
+        auto stats = std::make_unique<stats_calculator>(stat_summarizer_options());
+        decoded    = read_calculator(in, *stats);
+        if (decoded)
+        {
+            from.stats = std::move(stats);
+        }
+    }
+
+    if (!decoded)
+    {
+        QUARISMA_LOG_WARNING("Dropping a corrupt profiler message from {}", from.name);
+        return;
+    }
+    ++merged_;
+}
+
+void profiler_aggregator::merge_space(const source& from, x_space& space, int64_t base_unix_ns)
+{
+    int64_t const  shift  = base_unix_ns + (opts_.align_clocks ? from.clock_offset_ns : 0);
+    uint64_t const prefix = static_cast<uint64_t>(from.index + 1) << 32;
+    for (xplane& plane : *space.mutable_planes())
+    {
+        for (xline& line : *plane.mutable_lines())
+        {
+            auto const local_id = static_cast<uint64_t>(line.id()) & 0xFFFFFFFFu;
+            line.set_id(static_cast<int64_t>(prefix | local_id));
+            std::string_view const label =
+                line.display_name().empty() ? line.name() : line.display_name();
+            line.set_display_name(from.name + "/" + std::string(label));
+            line.set_timestamp_ns(line.timestamp_ns() + shift);
+        }
+
+        auto const [it, inserted] = plane_index_.emplace(plane.name(), space_.planes().size());
+        if (inserted)
+        {
+            xplane* merged = space_.add_planes();
+            merged->set_id(plane.id());
+            merged->set_name(plane.name());
+        }
+        MergePlanes(plane, space_.mutable_planes(it->second));
+    }
+
+    for (const auto& error : space.errors())
+    {
+        space_.add_error(from.name + ": " + error);
+    }
+    for (const auto& warning : space.warnings())
+    {
+        space_.add_warning(from.name + ": " + warning);
+    }
+    for (const auto& hostname : space.hostnames())
+    {
+        const auto& known = space_.hostnames();
+        if (std::find(known.begin(), known.end(), hostname) == known.end())
+        {
+            space_.add_hostname(hostname);
+        }
+    }
+}
+
+}  // namespace quarisma
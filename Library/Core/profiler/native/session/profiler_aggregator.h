@@ -0,0 +1,235 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/macros.h"
+#include "io/shm_channel.h"
+#include "profiler/native/analysis/stats_calculator.h"
+#include "profiler/native/exporters/xplane/xplane.h"
+#include "util/approximate_clock.h"
+
+namespace quarisma
+{
+class profiler_session;
+
+/**
+ * @brief Sends the profiles of one process to a profiler_aggregator.
+ *
+ * Every send_*() serializes its argument and sends it through the
+ * aggregator's shm_channel in chunks that fit its arena, so a space of any
+ * size goes through. Each chunk carries the Unix time it was sent, read
+ * from the TSC through ApproximateClockToUnixTimeConverter, from which the
+ * aggregator estimates the clock offset of this process.
+ *
+ * Spaces are deltas: each one is appended to the merged timeline, so send
+ * only what was collected since the previous call. Stats are snapshots:
+ * the latest from a collector replaces its earlier ones.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * // Each worker process
+ * profiler_collector collector("/pricing_profiles", "worker-" + std::to_string(rank));
+ * session->stop();
+ * collector.send_session(*session);
+ * collector.send_stats(calculator);
+ * ```
+ *
+ * **Thread Safety**: not thread-safe; use one collector per thread
+ */
+class QUARISMA_VISIBILITY profiler_collector
+{
+public:
+    using duration = io::shm_channel::duration;
+
+    /** @brief How long a send waits for room before giving up, by default. */
+    static constexpr duration default_timeout = std::chrono::seconds(10);
+
+    /**
+     * @brief Opens the channel the aggregator created.
+     * @param source Label of this collector in the merged timeline; "pid <pid>" if empty
+     * @throws quarisma::Error when the channel does not exist
+     */
+    QUARISMA_API explicit profiler_collector(
+        const std::string& channel_name, std::string source = std::string());
+
+    QUARISMA_API ~profiler_collector();
+
+    /**
+     * @brief Sends `space`, whose line timestamps count from the Unix time `base_unix_ns`.
+     * @return false if the channel had no room within `timeout`
+     */
+    QUARISMA_API bool send_space(
+        const x_space& space, int64_t base_unix_ns = 0, duration timeout = default_timeout);
+
+    /** @brief Sends the XSpace collected by a stopped session. */
+    QUARISMA_API bool send_session(
+        const profiler_session& session, duration timeout = default_timeout);
+
+    /** @brief Sends a snapshot of `stats`, replacing the previous one of this collector. */
+    QUARISMA_API bool send_stats(const stats_calculator& stats, duration timeout = default_timeout);
+
+    const std::string& source() const noexcept { return source_; }
+
+private:
+    bool send_message(uint8_t kind, const std::string& payload, duration timeout);
+
+    io::shm_channel                      channel_;
+    std::string                          source_;
+    uint64_t                             source_id_  = 0;
+    uint64_t                             sequence_   = 0;
+    size_t                               chunk_size_ = 0;
+    std::function<time_t(approx_time_t)> to_unix_ns_;
+    std::vector<uint8_t>                 chunk_;
+
+    profiler_collector(const profiler_collector&) = delete;
+    void operator=(const profiler_collector&)     = delete;
+};
+
+/**
+ * @brief Merges the profiles of many processes into one timeline and one set of stats.
+ *
+ * Creates the shm_channel that profiler_collector instances, or sessions
+ * built with_aggregator(), send to, and merges what poll() receives:
+ *
+ * - **Timeline**: planes of the same name from every source are merged
+ *   with MergePlanes(), so "/host:CPU" holds the threads of all processes.
+ *   The lines of a source get its index in the upper 32 bits of their id
+ *   and its label before their display name, and their timestamps become
+ *   Unix nanoseconds on the aggregator's clock.
+ * - **Clocks**: the offset of a source is estimated as the smallest
+ *   receive time minus send time of its chunks, which is its clock offset
+ *   plus the channel latency, a few microseconds at most. A space is
+ *   shifted by the estimate when it arrives.
+ * - **Stats**: merged_stats() merges the latest snapshot of every source
+ *   with stats_calculator::merge().
+ *
+ * Sources are on one host, as the channel lives in shared memory.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * profiler_aggregator aggregator("/pricing_profiles");
+ * launch_workers();
+ * while (workers_running())
+ * {
+ *     aggregator.poll(std::chrono::milliseconds(100));
+ * }
+ * write_chrome_trace(aggregator.merged_space(), "pricing.json");
+ * std::cout << aggregator.merged_stats().get_output_string();
+ * ```
+ *
+ * **Thread Safety**: not thread-safe; one thread polls
+ */
+class QUARISMA_VISIBILITY profiler_aggregator
+{
+public:
+    using duration = io::shm_channel::duration;
+
+    /**
+     * @brief Configuration options for profiler_aggregator.
+     */
+    struct Options
+    {
+        /**
+         * @brief Slots of the channel; multi_producer is always set.
+         *
+         * **Default**: 1024 slots of 240 bytes
+         */
+        size_t capacity = 1024;
+
+        /**
+         * @brief Bytes of the arena holding the chunks of the messages.
+         *
+         * Chunks are an eighth of it, at most 1 MiB.
+         *
+         * **Default**: 64 MiB
+         */
+        size_t arena_size = size_t{64} << 20;
+
+        /**
+         * @brief Whether to shift the timeline of each source by its clock offset.
+         *
+         * **Default**: true
+         */
+        bool align_clocks = true;
+    };
+
+    /** @brief Summary of one source. */
+    struct source_info
+    {
+        std::string name;
+        int64_t     clock_offset_ns = 0;
+        size_t      spaces          = 0;
+        bool        has_stats       = false;
+    };
+
+    /**
+     * @brief Creates the channel `channel_name`, replacing a stale one.
+     * @throws quarisma::Error when the channel cannot be created
+     */
+    QUARISMA_API explicit profiler_aggregator(const std::string& channel_name);
+    QUARISMA_API profiler_aggregator(const std::string& channel_name, const Options& opts);
+
+    QUARISMA_API ~profiler_aggregator();
+
+    /**
+     * @brief Receives and merges messages until none arrives within `timeout`.
+     * @return Spaces and stats merged; chunks of unfinished messages do not count
+     */
+    QUARISMA_API size_t poll(duration timeout);
+
+    /** @brief Every space received, merged into one timeline. */
+    const x_space& merged_space() const noexcept { return space_; }
+
+    /** @brief The latest stats of every source, merged. */
+    QUARISMA_API stats_calculator merged_stats() const;
+
+    /** @brief The sources seen so far, in order of their first message. */
+    QUARISMA_API std::vector<source_info> sources() const;
+
+private:
+    struct source;
+
+    void    receive_chunk(const void* data, size_t size);
+    void    merge_space(const source& from, x_space& space, int64_t base_unix_ns);
+    source& source_of(uint64_t id);
+
+    io::shm_channel                      channel_;
+    Options                              opts_;
+    std::function<time_t(approx_time_t)> to_unix_ns_;
+    std::vector<std::unique_ptr<source>> sources_;
+    std::map<uint64_t, size_t>           source_index_;
+    std::map<std::string, size_t>        plane_index_;
+    x_space                              space_;
+    size_t                               merged_ = 0;
+
+    profiler_aggregator(const profiler_aggregator&) = delete;
+    void operator=(const profiler_aggregator&)     = delete;
+};
+
+}  // namespace quarisma
@@ -20,20 +20,32 @@
 #include "profiler_report.h"
 
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <numeric>
+#include <ostream>
 #include <set>
 #include <sstream>
+#include <streambuf>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "logging/logger.h"
+#include "memory/columnar/columnar_ipc.h"
+#include "profiler/native/analysis/kernel_metrics.h"
 #include "profiler/native/analysis/statistical_analyzer.h"
 #include "profiler/native/session/profiler.h"
 
@@ -76,6 +88,84 @@ std::vector<scope_snapshot> collect_scope_snapshots(const profiler_scope_data* r
     return snapshots;
 }
 
+bool longer_scope(const scope_snapshot& lhs, const scope_snapshot& rhs)
+{
+    return lhs.scope->get_duration_ms() > rhs.scope->get_duration_ms();
+}
+
+bool larger_memory_delta(const scope_snapshot& lhs, const scope_snapshot& rhs)
+{
+    return std::abs(lhs.scope->memory_stats_.delta_since_start_) >
+           std::abs(rhs.scope->memory_stats_.delta_since_start_);
+}
+
+// The first `limit` snapshots in `order`, without sorting all of them
+template <typename Compare>
+std::vector<scope_snapshot> top_snapshots(
+    const std::vector<scope_snapshot>& snapshots, size_t limit, Compare order)
+{
+    std::vector<scope_snapshot> top((std::min)(limit, snapshots.size()));
+    std::partial_sort_copy(snapshots.begin(), snapshots.end(), top.begin(), top.end(), order);
+    return top;
+}
+
+// Buffers a report on its way to a file descriptor, which it leaves open
+class fd_streambuf : public std::streambuf
+{
+public:
+    explicit fd_streambuf(int fd) : fd_(fd) { setp(buffer_, buffer_ + sizeof(buffer_)); }
+
+    fd_streambuf(const fd_streambuf&)            = delete;
+    fd_streambuf& operator=(const fd_streambuf&) = delete;
+
+    ~fd_streambuf() override { flush_buffer(); }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (!flush_buffer())
+        {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override { return flush_buffer() ? 0 : -1; }
+
+private:
+    bool flush_buffer()
+    {
+        const char* p = pbase();
+        while (p < pptr())
+        {
+#ifdef _WIN32
+            auto const written = ::_write(fd_, p, static_cast<unsigned>(pptr() - p));
+#else
+            auto const written = ::write(fd_, p, static_cast<size_t>(pptr() - p));
+#endif
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                return false;
+            }
+            p += written;
+        }
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        return true;
+    }
+
+    int  fd_;
+    char buffer_[64 * 1024];
+};
+
 size_t compute_max_depth(const std::vector<scope_snapshot>& snapshots)
 {
     // Use std::accumulate to find maximum depth
@@ -118,6 +208,24 @@ std::vector<std::pair<std::string, ValueT>> sort_map_by_value_desc(
     return entries;
 }
 
+std::string wait_bucket_label(size_t bucket)
+{
+    using quarisma::pool_instrumentation;
+    if (bucket + 1 >= pool_instrumentation::wait_buckets)
+    {
+        int64_t const lower_ns = pool_instrumentation::wait_bucket_limit_ns(bucket - 1);
+        return ">=" + std::to_string(lower_ns / 1000) + "us";
+    }
+    return "<" + std::to_string(pool_instrumentation::wait_bucket_limit_ns(bucket) / 1000) + "us";
+}
+
+std::string worker_label(const quarisma::pool_instrumentation::worker_stats& stats)
+{
+    return stats.worker_ == quarisma::pool_instrumentation::external_worker
+               ? std::string("caller")
+               : std::to_string(stats.worker_);
+}
+
 }  // namespace
 
 //=============================================================================
@@ -128,40 +236,80 @@ profiler_report::profiler_report(const quarisma::profiler_session& session) : se
 
 std::string profiler_report::generate_console_report() const
 {
-    std::stringstream ss;
+    std::ostringstream ss;
+    write_console_report(ss);
+    return ss.str();
+}
+
+std::string profiler_report::generate_json_report() const
+{
+    std::ostringstream ss;
+    write_json_report(ss);
+    return ss.str();
+}
 
-    ss << generate_header_section();
-    ss << generate_summary_section();
+std::string profiler_report::generate_csv_report() const
+{
+    std::ostringstream ss;
+    write_csv_report(ss);
+    return ss.str();
+}
+
+std::string profiler_report::generate_xml_report() const
+{
+    std::ostringstream ss;
+    write_xml_report(ss);
+    return ss.str();
+}
+
+void profiler_report::write_console_report(std::ostream& out) const
+{
+    write_header_section(out);
+    write_summary_section(out);
 
     if (include_hierarchical_data_)
     {
-        ss << generate_hierarchical_section();
+        write_hierarchical_section(out);
     }
 
-    ss << generate_timing_section();
-    ss << generate_memory_section();
-    ss << generate_statistical_section();
+    write_timing_section(out);
+    write_memory_section(out);
+    if (session_.options().enable_hardware_counters_)
+    {
+        write_hardware_counter_section(out);
+    }
+    if (session_.options().enable_thread_pool_stats_)
+    {
+        write_thread_pool_section(out);
+    }
+    if (session_.options().enable_lock_stats_)
+    {
+        write_lock_section(out);
+    }
+    if (session_.options().enable_overhead_control_)
+    {
+        write_overhead_section(out);
+    }
+    write_gpu_kernel_section(out);
+    write_statistical_section(out);
 
     if (include_thread_info_)
     {
-        ss << generate_thread_section();
+        write_thread_section(out);
     }
-
-    return ss.str();
 }
 
-std::string profiler_report::generate_json_report() const
+void profiler_report::write_json_report(std::ostream& out) const
 {
     auto const* root = session_.get_root_scope();
     auto const  snapshots =
         root != nullptr ? collect_scope_snapshots(root) : std::vector<scope_snapshot>();
 
-    std::stringstream ss;
-    ss << "{\n";
-    ss << "  \"header\": {\n";
-    ss << "    \"active\": " << (session_.is_active() ? "true" : "false") << ",\n";
-    ss << "    \"scope_count\": " << snapshots.size() << ",\n";
-    ss << "    \"max_depth\": " << compute_max_depth(snapshots) << ",\n";
+    out << "{\n";
+    out << "  \"header\": {\n";
+    out << "    \"active\": " << (session_.is_active() ? "true" : "false") << ",\n";
+    out << "    \"scope_count\": " << snapshots.size() << ",\n";
+    out << "    \"max_depth\": " << compute_max_depth(snapshots) << ",\n";
 
     auto const start_time = session_.session_start_time();
     auto const end_time   = session_.session_end_time();
@@ -169,177 +317,400 @@ std::string profiler_report::generate_json_report() const
     {
         auto const duration_ns =
             std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
-        ss << "    \"duration_ms\": " << format_double(duration_ns / 1'000'000.0) << "\n";
+        out << "    \"duration_ms\": " << format_double(duration_ns / 1'000'000.0) << "\n";
     }
     else
     {
-        ss << "    \"duration_ms\": 0.0\n";
+        out << "    \"duration_ms\": 0.0\n";
     }
-    ss << "  },\n";
+    out << "  },\n";
 
     if (include_hierarchical_data_ && (root != nullptr))
     {
-        ss << "  \"scopes\": [\n";
-        process_scope_data_json_recursive(*root, ss, 4);
-        ss << "\n  ],\n";
+        out << "  \"scopes\": [\n";
+        process_scope_data_json_recursive(*root, out, 4);
+        out << "\n  ],\n";
     }
     else
     {
-        ss << "  \"scopes\": [],\n";
+        out << "  \"scopes\": [],\n";
     }
 
-    std::vector<scope_snapshot> by_duration = snapshots;
-    std::sort(
-        by_duration.begin(),
-        by_duration.end(),
-        [](const auto& lhs, const auto& rhs)
-        { return lhs.scope->get_duration_ms() > rhs.scope->get_duration_ms(); });
+    auto const by_duration = top_snapshots(snapshots, 10, longer_scope);
 
-    ss << "  \"top_durations\": [\n";
-    size_t const duration_limit =
-        (std::min)(static_cast<size_t>(10), by_duration.size());  // top 10 entries
-    for (size_t i = 0; i < duration_limit; ++i)
+    out << "  \"top_durations\": [\n";
+    for (size_t i = 0; i < by_duration.size(); ++i)
     {
         const auto& snapshot = by_duration[i];
         const auto* scope    = snapshot.scope;
-        ss << "    {\n";
-        ss << "      \"name\": " << escape_json_string(scope->name_) << ",\n";
-        ss << "      \"duration_ms\": " << format_double(scope->get_duration_ms()) << ",\n";
-        ss << "      \"depth\": " << snapshot.depth << ",\n";
-        ss << "      \"thread\": " << escape_json_string(format_thread_id(scope->thread_id_))
-           << "\n";
-        ss << "    }";
-        if (i + 1 < duration_limit)
+        out << "    {\n";
+        out << "      \"name\": " << escape_json_string(scope->name_) << ",\n";
+        out << "      \"duration_ms\": " << format_double(scope->get_duration_ms()) << ",\n";
+        out << "      \"depth\": " << snapshot.depth << ",\n";
+        out << "      \"thread\": " << escape_json_string(format_thread_id(scope->thread_id_))
+            << "\n";
+        out << "    }";
+        if (i + 1 < by_duration.size())
         {
-            ss << ",\n";
+            out << ",\n";
         }
     }
-    if (duration_limit > 0)
+    if (!by_duration.empty())
     {
-        ss << "\n";
+        out << "\n";
     }
-    ss << "  ],\n";
+    out << "  ],\n";
 
-    ss << "  \"memory\": {\n";
+    out << "  \"memory\": {\n";
     if (auto const* tracker = session_.memory_tracker_ptr())
     {
         auto const stats = tracker->get_current_stats();
-        ss << "    \"current_bytes\": " << stats.current_usage_ << ",\n";
-        ss << "    \"peak_bytes\": " << stats.peak_usage_ << ",\n";
-        ss << "    \"total_allocated_bytes\": " << stats.total_allocated_ << ",\n";
-        ss << "    \"total_deallocated_bytes\": " << stats.total_deallocated_ << "\n";
+        out << "    \"current_bytes\": " << stats.current_usage_ << ",\n";
+        out << "    \"peak_bytes\": " << stats.peak_usage_ << ",\n";
+        out << "    \"total_allocated_bytes\": " << stats.total_allocated_ << ",\n";
+        out << "    \"total_deallocated_bytes\": " << stats.total_deallocated_ << "\n";
     }
     else
     {
-        ss << "    \"enabled\": false\n";
+        out << "    \"enabled\": false\n";
     }
-    ss << "  },\n";
+    out << "  },\n";
 
-    ss << "  \"threads\": [\n";
+    if (session_.options().enable_thread_pool_stats_)
+    {
+        out << "  \"thread_pools\": [\n";
+        auto const workers = session_.thread_pool_stats();
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            const auto& w = workers[i];
+            out << "    {\n";
+            out << "      \"pool\": " << escape_json_string(w.pool_) << ",\n";
+            out << "      \"worker\": " << escape_json_string(worker_label(w)) << ",\n";
+            out << "      \"jobs\": " << w.jobs_ << ",\n";
+            out << "      \"utilization\": " << format_double(w.utilization()) << ",\n";
+            out << "      \"busy_ns\": " << w.busy_ns_ << ",\n";
+            out << "      \"idle_ns\": " << w.idle_ns() << ",\n";
+            out << "      \"wait_ns\": " << w.wait_ns_ << ",\n";
+            out << "      \"max_wait_ns\": " << w.max_wait_ns_ << ",\n";
+            out << "      \"wait_histogram\": [";
+            for (size_t b = 0; b < w.wait_histogram_.size(); ++b)
+            {
+                out << (b != 0 ? ", " : "") << w.wait_histogram_[b];
+            }
+            out << "]\n";
+            out << "    }" << (i + 1 < workers.size() ? ",\n" : "\n");
+        }
+        out << "  ],\n";
+    }
+
+    if (session_.options().enable_lock_stats_)
+    {
+        out << "  \"locks\": [\n";
+        auto const sites = session_.lock_stats();
+        for (size_t i = 0; i < sites.size(); ++i)
+        {
+            const auto& l = sites[i];
+            out << "    {\n";
+            out << "      \"site\": " << escape_json_string(l.site_) << ",\n";
+            out << "      \"mutexes\": " << l.mutexes_ << ",\n";
+            out << "      \"acquisitions\": " << l.acquisitions_ << ",\n";
+            out << "      \"contentions\": " << l.contentions_ << ",\n";
+            out << "      \"contention_rate\": " << format_double(l.contention_rate()) << ",\n";
+            out << "      \"wait_ns\": " << l.wait_ns_ << ",\n";
+            out << "      \"max_wait_ns\": " << l.max_wait_ns_ << ",\n";
+            out << "      \"hold_samples\": " << l.hold_samples_ << ",\n";
+            out << "      \"mean_hold_ns\": " << format_double(l.mean_hold_ns()) << ",\n";
+            out << "      \"max_hold_ns\": " << l.max_hold_ns_ << "\n";
+            out << "    }" << (i + 1 < sites.size() ? ",\n" : "\n");
+        }
+        out << "  ],\n";
+    }
+
+    if (session_.options().enable_overhead_control_)
+    {
+        out << "  \"overhead_control\": {\n";
+        out << "    \"budget_ns\": " << session_.options().overhead_budget_ns_ << ",\n";
+        out << "    \"sample_period\": " << session_.options().overhead_sample_period_ << ",\n";
+        out << "    \"labels\": [\n";
+        auto const labels = session_.label_overheads();
+        for (size_t i = 0; i < labels.size(); ++i)
+        {
+            const auto& l = labels[i];
+            out << "      {\n";
+            out << "        \"label\": " << escape_json_string(l.label_) << ",\n";
+            out << "        \"sampled\": " << (l.sampled_ ? "true" : "false") << ",\n";
+            out << "        \"calls\": " << l.calls_ << ",\n";
+            out << "        \"recorded\": " << l.recorded_ << ",\n";
+            out << "        \"overhead_ns\": " << l.overhead_ns_ << "\n";
+            out << "      }" << (i + 1 < labels.size() ? ",\n" : "\n");
+        }
+        out << "    ]\n";
+        out << "  },\n";
+    }
+
+    auto const kernels = summarize_kernel_metrics(session_.collected_xspace());
+    if (!kernels.empty())
+    {
+        out << "  \"gpu_kernels\": [\n";
+        for (size_t i = 0; i < kernels.size(); ++i)
+        {
+            const auto& k = kernels[i];
+            out << "    {\n";
+            out << "      \"kernel\": " << escape_json_string(k.kernel) << ",\n";
+            out << "      \"launches\": " << k.launches << ",\n";
+            out << "      \"total_ns\": " << k.total_ns;
+            for (size_t m = 0; m < kernel_metric_count; ++m)
+            {
+                // Metrics no launch measured are left out, JSON having no NaN
+                if (!std::isnan(k.mean[m]))
+                {
+                    out << ",\n      \""
+                        << GetStatTypeStr(stat_type(static_cast<kernel_metric>(m)))
+                        << "\": " << format_double(k.mean[m]);
+                }
+            }
+            out << "\n    }" << (i + 1 < kernels.size() ? ",\n" : "\n");
+        }
+        out << "  ],\n";
+    }
+
+    out << "  \"threads\": [\n";
     auto const thread_histogram = sort_map_by_value_desc(build_thread_histogram(snapshots));
     for (size_t i = 0; i < thread_histogram.size(); ++i)
     {
         if (i != 0)
         {
-            ss << ",\n";
+            out << ",\n";
         }
-        ss << "    {\n";
-        ss << "      \"thread\": " << escape_json_string(thread_histogram[i].first) << ",\n";
-        ss << "      \"scope_count\": " << thread_histogram[i].second << "\n";
-        ss << "    }";
+        out << "    {\n";
+        out << "      \"thread\": " << escape_json_string(thread_histogram[i].first) << ",\n";
+        out << "      \"scope_count\": " << thread_histogram[i].second << "\n";
+        out << "    }";
     }
     if (!thread_histogram.empty())
     {
-        ss << "\n";
+        out << "\n";
     }
-    ss << "  ]\n";
-    ss << "}\n";
-
-    return ss.str();
+    out << "  ]\n";
+    out << "}\n";
 }
 
-std::string profiler_report::generate_csv_report() const
+void profiler_report::write_csv_report(std::ostream& out) const
 {
-    std::stringstream ss;
-
-    ss << generate_csv_header() << "\n";
+    out << generate_csv_header() << "\n";
     if (include_hierarchical_data_ && (session_.get_root_scope() != nullptr))
     {
-        std::vector<std::string> rows;
-        process_scope_data_csv_recursive(*session_.get_root_scope(), rows);
-        for (const auto& row : rows)
-        {
-            ss << row << "\n";
-        }
+        process_scope_data_csv_recursive(*session_.get_root_scope(), out);
     }
-
-    return ss.str();
 }
 
-std::string profiler_report::generate_xml_report() const
+void profiler_report::write_xml_report(std::ostream& out) const
 {
-    std::stringstream ss;
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out << "<profiler_report>\n";
 
-    ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    ss << "<profiler_report>\n";
-
-    ss << "  <header>\n" << generate_header_section() << "  </header>\n";
-    ss << "  <summary>\n" << generate_summary_section() << "  </summary>\n";
+    out << "  <header>\n";
+    write_header_section(out);
+    out << "  </header>\n";
+    out << "  <summary>\n";
+    write_summary_section(out);
+    out << "  </summary>\n";
 
     if (include_hierarchical_data_)
     {
-        ss << "  <hierarchical_data>\n"
-           << generate_hierarchical_section() << "  </hierarchical_data>\n";
+        out << "  <hierarchical_data>\n";
+        write_hierarchical_section(out);
+        out << "  </hierarchical_data>\n";
     }
 
-    ss << "  <timing>\n" << generate_timing_section() << "  </timing>\n";
-    ss << "  <memory>\n" << generate_memory_section() << "  </memory>\n";
-    ss << "  <statistics>\n" << generate_statistical_section() << "  </statistics>\n";
+    out << "  <timing>\n";
+    write_timing_section(out);
+    out << "  </timing>\n";
+    out << "  <memory>\n";
+    write_memory_section(out);
+    out << "  </memory>\n";
+    if (session_.options().enable_hardware_counters_)
+    {
+        out << "  <hardware_counters>\n";
+        write_hardware_counter_section(out);
+        out << "  </hardware_counters>\n";
+    }
+    if (session_.options().enable_thread_pool_stats_)
+    {
+        out << "  <thread_pools>\n";
+        write_thread_pool_section(out);
+        out << "  </thread_pools>\n";
+    }
+    if (session_.options().enable_lock_stats_)
+    {
+        out << "  <locks>\n";
+        write_lock_section(out);
+        out << "  </locks>\n";
+    }
+    if (session_.options().enable_overhead_control_)
+    {
+        out << "  <overhead_control>\n";
+        write_overhead_section(out);
+        out << "  </overhead_control>\n";
+    }
+    if (!summarize_kernel_metrics(session_.collected_xspace()).empty())
+    {
+        out << "  <gpu_kernels>\n";
+        write_gpu_kernel_section(out);
+        out << "  </gpu_kernels>\n";
+    }
+    out << "  <statistics>\n";
+    write_statistical_section(out);
+    out << "  </statistics>\n";
 
     if (include_thread_info_)
     {
-        ss << "  <threads>\n" << generate_thread_section() << "  </threads>\n";
+        out << "  <threads>\n";
+        write_thread_section(out);
+        out << "  </threads>\n";
     }
 
-    ss << "</profiler_report>\n";
-
-    return ss.str();
+    out << "</profiler_report>\n";
 }
 
-bool profiler_report::export_to_file(
-    const std::string& filename, quarisma::profiler_options::output_format_enum format) const
+void profiler_report::write_report(
+    std::ostream& out, quarisma::profiler_options::output_format_enum format) const
 {
-    std::string content;
-
     switch (format)
     {
     case quarisma::profiler_options::output_format_enum::CONSOLE:
     case quarisma::profiler_options::output_format_enum::FILE:
-        content = generate_console_report();
+        write_console_report(out);
         break;
     case quarisma::profiler_options::output_format_enum::JSON:
-        content = generate_json_report();
+        write_json_report(out);
         break;
     case quarisma::profiler_options::output_format_enum::CSV:
-        content = generate_csv_report();
+        write_csv_report(out);
         break;
     case quarisma::profiler_options::output_format_enum::STRUCTURED:
-        content = generate_xml_report();
+        write_xml_report(out);
         break;
     default:
-        content = generate_console_report();
+        write_console_report(out);
         break;
     }
+}
+
+bool profiler_report::write_report(
+    int fd, quarisma::profiler_options::output_format_enum format) const
+{
+    fd_streambuf buffer(fd);
+    std::ostream out(&buffer);
+    write_report(out, format);
+    out.flush();
+    return !out.fail();
+}
 
+columnar::record_batch profiler_report::generate_columnar_report(
+    std::vector<std::string>& strings) const
+{
+    strings.clear();
+    columnar::record_batch batch;
+    auto const* root = session_.get_root_scope();
+    if (root == nullptr)
+    {
+        return batch;
+    }
+
+    auto const   snapshots = collect_scope_snapshots(root);
+    size_t const rows      = snapshots.size();
+
+    auto parent       = columnar::column::allocate<int64_t>(rows);
+    auto depth        = columnar::column::allocate<uint32_t>(rows);
+    auto name         = columnar::column::allocate<uint32_t>(rows);
+    auto thread       = columnar::column::allocate<uint32_t>(rows);
+    auto start_ns     = columnar::column::allocate<int64_t>(rows);
+    auto duration_ns  = columnar::column::allocate<int64_t>(rows);
+    auto current      = columnar::column::allocate<uint64_t>(rows);
+    auto peak         = columnar::column::allocate<uint64_t>(rows);
+    auto delta        = columnar::column::allocate<int64_t>(rows);
+    auto cycles       = columnar::column::allocate<uint64_t>(rows);
+    auto instructions = columnar::column::allocate<uint64_t>(rows);
+
+    std::unordered_map<std::string, uint32_t> string_ids;
+    auto const intern = [&](const std::string& value)
+    {
+        auto const inserted = string_ids.emplace(value, static_cast<uint32_t>(strings.size()));
+        if (inserted.second)
+        {
+            strings.push_back(value);
+        }
+        return inserted.first->second;
+    };
+
+    // Snapshots are in depth-first order, so the parent of a row is the last row one level up
+    std::vector<int64_t> last_row_at_depth;
+    auto const           session_start = session_.session_start_time();
+    for (size_t row = 0; row < rows; ++row)
+    {
+        const auto& snapshot = snapshots[row];
+        const auto* scope    = snapshot.scope;
+
+        last_row_at_depth.resize(snapshot.depth + 1);
+        last_row_at_depth[snapshot.depth] = static_cast<int64_t>(row);
+
+        parent.mutable_values<int64_t>()[row] =
+            snapshot.depth == 0 ? -1 : last_row_at_depth[snapshot.depth - 1];
+        depth.mutable_values<uint32_t>()[row] = static_cast<uint32_t>(snapshot.depth);
+        name.mutable_values<uint32_t>()[row]  = intern(scope->name_);
+        thread.mutable_values<uint32_t>()[row] = intern(format_thread_id(scope->thread_id_));
+        start_ns.mutable_values<int64_t>()[row] =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(scope->start_time_ - session_start)
+                .count();
+        duration_ns.mutable_values<int64_t>()[row] =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                scope->end_time_ - scope->start_time_)
+                .count();
+        current.mutable_values<uint64_t>()[row] = scope->memory_stats_.current_usage_;
+        peak.mutable_values<uint64_t>()[row]    = scope->memory_stats_.peak_usage_;
+        delta.mutable_values<int64_t>()[row]    = scope->memory_stats_.delta_since_start_;
+
+        using quarisma::profiler::hardware_counter;
+        const auto& counters = scope->hardware_counters_;
+        cycles.mutable_values<uint64_t>()[row]       = counters.get(hardware_counter::cycles);
+        instructions.mutable_values<uint64_t>()[row] = counters.get(hardware_counter::instructions);
+        if (!counters.has(hardware_counter::cycles))
+        {
+            cycles.set_valid(row, false);
+        }
+        if (!counters.has(hardware_counter::instructions))
+        {
+            instructions.set_valid(row, false);
+        }
+    }
+
+    batch.add("parent", std::move(parent));
+    batch.add("depth", std::move(depth));
+    batch.add("name", std::move(name));
+    batch.add("thread", std::move(thread));
+    batch.add("start_ns", std::move(start_ns));
+    batch.add("duration_ns", std::move(duration_ns));
+    batch.add("memory_current_bytes", std::move(current));
+    batch.add("memory_peak_bytes", std::move(peak));
+    batch.add("memory_delta_bytes", std::move(delta));
+    batch.add("cycles", std::move(cycles));
+    batch.add("instructions", std::move(instructions));
+    return batch;
+}
+
+bool profiler_report::export_to_file(
+    const std::string& filename, quarisma::profiler_options::output_format_enum format) const
+{
     std::ofstream file(filename);
     if (!file.is_open())
     {
         return false;
     }
 
-    file << content;
+    write_report(file, format);
     file.close();
-    return true;
+    return !file.fail();
 }
 
 bool profiler_report::export_console_report(const std::string& filename) const
@@ -362,6 +733,40 @@ bool profiler_report::export_xml_report(const std::string& filename) const
     return export_to_file(filename, quarisma::profiler_options::output_format_enum::STRUCTURED);
 }
 
+bool profiler_report::export_columnar_report(const std::string& filename) const
+{
+    std::vector<std::string> strings;
+    auto const               batch = generate_columnar_report(strings);
+
+    std::ofstream names(filename + ".strings.json");
+    if (!names.is_open())
+    {
+        return false;
+    }
+    names << "[";
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        names << (i != 0 ? ",\n " : "\n ") << escape_json_string(strings[i]);
+    }
+    names << "\n]\n";
+    names.close();
+    if (names.fail())
+    {
+        return false;
+    }
+
+    try
+    {
+        columnar::write_file(batch, filename);
+    }
+    catch (const std::exception& e)
+    {
+        QUARISMA_LOG_WARNING("Failed to export the columnar report to {}: {}", filename, e.what());
+        return false;
+    }
+    return true;
+}
+
 void profiler_report::print_summary()
 {
     QUARISMA_LOG_WARNING(
@@ -378,21 +783,21 @@ void profiler_report::print_memory_report()
 {
     QUARISMA_LOG_WARNING(
         "profiler_report::print_memory_report() is deprecated. "
-        "Use profiler_session::generate_report()->generate_memory_section().");
+        "Use profiler_session::generate_report()->generate_console_report().");
 }
 
 void profiler_report::print_timing_report()
 {
     QUARISMA_LOG_WARNING(
         "profiler_report::print_timing_report() is deprecated. "
-        "Use profiler_session::generate_report()->generate_timing_section().");
+        "Use profiler_session::generate_report()->generate_console_report().");
 }
 
 void profiler_report::print_statistical_report()
 {
     QUARISMA_LOG_WARNING(
         "profiler_report::print_statistical_report() is deprecated. "
-        "Use profiler_session::generate_report()->generate_statistical_section().");
+        "Use profiler_session::generate_report()->generate_console_report().");
 }
 
 std::string profiler_report::format_duration(double duration_ns) const
@@ -452,11 +857,10 @@ std::string profiler_report::format_double(double value) const
     return ss.str();
 }
 
-std::string profiler_report::generate_header_section() const
+void profiler_report::write_header_section(std::ostream& out) const
 {
-    std::stringstream ss;
-    ss << "=== Quarisma Profiler Report ===\n";
-    ss << "Session active: " << (session_.is_active() ? "yes" : "no") << "\n";
+    out << "=== Quarisma Profiler Report ===\n";
+    out << "Session active: " << (session_.is_active() ? "yes" : "no") << "\n";
 
     auto const start_time = session_.session_start_time();
     auto const end_time   = session_.session_end_time();
@@ -464,112 +868,86 @@ std::string profiler_report::generate_header_section() const
     {
         auto const duration_ns =
             std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
-        ss << "Duration: " << format_duration(static_cast<double>(duration_ns)) << "\n";
+        out << "Duration: " << format_duration(static_cast<double>(duration_ns)) << "\n";
     }
     else
     {
-        ss << "Duration: n/a\n";
+        out << "Duration: n/a\n";
     }
 
     auto const* root = session_.get_root_scope();
     auto const  snapshots =
         root != nullptr ? collect_scope_snapshots(root) : std::vector<scope_snapshot>();
-    ss << "Total scopes: " << snapshots.size() << "\n";
-    ss << "Max depth: " << compute_max_depth(snapshots) << "\n";
-    ss << "\n";
-    return ss.str();
+    out << "Total scopes: " << snapshots.size() << "\n";
+    out << "Max depth: " << compute_max_depth(snapshots) << "\n";
+    out << "\n";
 }
 
-std::string profiler_report::generate_summary_section() const
+void profiler_report::write_summary_section(std::ostream& out) const
 {
-    std::stringstream ss;
-    ss << "=== Summary ===\n";
+    out << "=== Summary ===\n";
     auto const* root = session_.get_root_scope();
     if (root == nullptr)
     {
-        ss << "No profiling scopes were recorded.\n\n";
-        return ss.str();
+        out << "No profiling scopes were recorded.\n\n";
+        return;
     }
 
-    ss << "Root scope: " << root->name_ << "\n";
-    ss << "Total duration: " << format_double(root->get_duration_ms()) << " ms\n";
-    ss << "Root thread: " << format_thread_id(root->thread_id_) << "\n";
+    out << "Root scope: " << root->name_ << "\n";
+    out << "Total duration: " << format_double(root->get_duration_ms()) << " ms\n";
+    out << "Root thread: " << format_thread_id(root->thread_id_) << "\n";
 
     if (auto const* tracker = session_.memory_tracker_ptr())
     {
         auto const stats = tracker->get_current_stats();
-        ss << "Current memory: " << format_memory_size(stats.current_usage_) << "\n";
-        ss << "Peak memory: " << format_memory_size(stats.peak_usage_) << "\n";
-        ss << "Total allocated: " << format_memory_size(stats.total_allocated_) << "\n";
-        ss << "Total deallocated: " << format_memory_size(stats.total_deallocated_) << "\n";
+        out << "Current memory: " << format_memory_size(stats.current_usage_) << "\n";
+        out << "Peak memory: " << format_memory_size(stats.peak_usage_) << "\n";
+        out << "Total allocated: " << format_memory_size(stats.total_allocated_) << "\n";
+        out << "Total deallocated: " << format_memory_size(stats.total_deallocated_) << "\n";
     }
     else
     {
-        ss << "Memory tracking disabled for this session.\n";
+        out << "Memory tracking disabled for this session.\n";
     }
-    ss << "\n";
-    return ss.str();
+    out << "\n";
 }
 
-std::string profiler_report::generate_timing_section() const
+void profiler_report::write_timing_section(std::ostream& out) const
 {
-    std::stringstream ss;
-    ss << "=== Timing Analysis ===\n";
+    out << "=== Timing Analysis ===\n";
     auto const* root = session_.get_root_scope();
     if (root == nullptr)
     {
-        ss << "No timing data available.\n\n";
-        return ss.str();
+        out << "No timing data available.\n\n";
+        return;
     }
 
-    auto snapshots = collect_scope_snapshots(root);
-    std::sort(
-        snapshots.begin(),
-        snapshots.end(),
-        [](const auto& lhs, const auto& rhs)
-        { return lhs.scope->get_duration_ms() > rhs.scope->get_duration_ms(); });
-
     size_t rank = 1;
-    for (const auto& snapshot : snapshots)
+    for (const auto& snapshot : top_snapshots(collect_scope_snapshots(root), 10, longer_scope))
     {
         const auto* scope = snapshot.scope;
-        ss << "#" << rank++ << " ";
-        ss << scope->name_ << " - " << format_double(scope->get_duration_ms()) << " ms"
-           << " (depth " << snapshot.depth << ", thread " << format_thread_id(scope->thread_id_)
-           << ")\n";
-
-        if (rank > 10)
-        {
-            break;
-        }
+        out << "#" << rank++ << " ";
+        out << scope->name_ << " - " << format_double(scope->get_duration_ms()) << " ms"
+            << " (depth " << snapshot.depth << ", thread " << format_thread_id(scope->thread_id_)
+            << ")\n";
     }
-    ss << "\n";
-    return ss.str();
+    out << "\n";
 }
 
-std::string profiler_report::generate_memory_section() const
+void profiler_report::write_memory_section(std::ostream& out) const
 {
-    std::stringstream ss;
-    ss << "=== Memory Analysis ===\n";
+    out << "=== Memory Analysis ===\n";
     auto const* root = session_.get_root_scope();
     if (root == nullptr)
     {
-        ss << "No memory data captured.\n\n";
-        return ss.str();
+        out << "No memory data captured.\n\n";
+        return;
     }
 
-    std::vector<scope_snapshot> snapshots = collect_scope_snapshots(root);
-    std::sort(
-        snapshots.begin(),
-        snapshots.end(),
-        [](const auto& lhs, const auto& rhs)
-        {
-            return std::abs(lhs.scope->memory_stats_.delta_since_start_) >
-                   std::abs(rhs.scope->memory_stats_.delta_since_start_);
-        });
-
+    // Scopes without a delta sort last, so they are skipped only when fewer than 10 have one
     size_t displayed = 0;
-    for (const auto& snapshot : snapshots)
+    for (const auto& snapshot :
+         top_snapshots(collect_scope_snapshots(root), 10, larger_memory_delta))
     {
         const auto*   scope = snapshot.scope;
         int64_t const delta = scope->memory_stats_.delta_since_start_;
@@ -577,55 +955,237 @@ std::string profiler_report::generate_memory_section() const
         {
             continue;
         }
-        ss << scope->name_ << " (depth " << snapshot.depth << "): delta "
-           << format_memory_delta(delta) << ", current "
-           << format_memory_size(scope->memory_stats_.current_usage_) << ", peak "
-           << format_memory_size(scope->memory_stats_.peak_usage_) << "\n";
+        out << scope->name_ << " (depth " << snapshot.depth << "): delta "
+            << format_memory_delta(delta) << ", current "
+            << format_memory_size(scope->memory_stats_.current_usage_) << ", peak "
+            << format_memory_size(scope->memory_stats_.peak_usage_) << "\n";
+        ++displayed;
+    }
+    if (displayed == 0)
+    {
+        out << "No significant memory deltas observed.\n";
+    }
+    out << "\n";
+}
+
+void profiler_report::write_hardware_counter_section(std::ostream& out) const
+{
+    using quarisma::profiler::hardware_counter;
+
+    out << "=== Hardware Counters ===\n";
+    auto const* root = session_.get_root_scope();
+
+    // Counts of all the scopes of a label
+    struct label_counters
+    {
+        size_t                                      calls = 0;
+        quarisma::profiler::hardware_counter_values values;
+    };
+    std::unordered_map<std::string, label_counters> labels;
+    for (const auto& snapshot :
+         root != nullptr ? collect_scope_snapshots(root) : std::vector<scope_snapshot>())
+    {
+        if (!snapshot.scope->hardware_counters_.empty())
+        {
+            auto& label = labels[snapshot.scope->name_];
+            ++label.calls;
+            label.values.accumulate(snapshot.scope->hardware_counters_);
+        }
+    }
+    if (labels.empty())
+    {
+        out << "No hardware counters were read; the PMU is not accessible.\n\n";
+        return;
+    }
+
+    std::unordered_map<std::string, uint64_t> cycles;
+    for (const auto& entry : labels)
+    {
+        cycles[entry.first] = entry.second.values.get(hardware_counter::cycles);
+    }
+    auto const rate = [this](const quarisma::profiler::hardware_counter_values& values,
+                             hardware_counter                                   counter)
+    {
+        return values.has(counter) && values.has(hardware_counter::instructions)
+                   ? format_double(values.per_kilo_instruction(counter))
+                   : std::string("n/a");
+    };
+
+    size_t displayed = 0;
+    for (const auto& entry : sort_map_by_value_desc(cycles))
+    {
+        const auto& label = labels[entry.first];
+        const auto& v     = label.values;
+        out << entry.first << ": calls " << label.calls << ", cycles " << entry.second << ", IPC "
+            << (v.has(hardware_counter::instructions) ? format_double(v.ipc()) : "n/a")
+            << ", misses per 1k instructions: LLC " << rate(v, hardware_counter::llc_misses)
+            << ", branch " << rate(v, hardware_counter::branch_misses) << ", dTLB "
+            << rate(v, hardware_counter::dtlb_misses) << "\n";
         if (++displayed >= 10)
         {
             break;
         }
     }
-    if (displayed == 0)
+    out << "\n";
+}
+
+void profiler_report::write_thread_pool_section(std::ostream& out) const
+{
+    out << "=== Thread Pool Analysis ===\n";
+    auto const workers = session_.thread_pool_stats();
+    if (workers.empty())
     {
-        ss << "No significant memory deltas observed.\n";
+        out << "No thread pool jobs were measured.\n\n";
+        return;
     }
-    ss << "\n";
-    return ss.str();
+
+    for (const auto& w : workers)
+    {
+        out << w.pool_ << " worker " << worker_label(w) << ": " << w.jobs_
+            << " job(s), utilization " << format_percentage(w.utilization()) << ", busy "
+            << format_duration(static_cast<double>(w.busy_ns_)) << ", idle "
+            << format_duration(static_cast<double>(w.idle_ns())) << ", mean wait "
+            << format_duration(w.mean_wait_ns()) << ", max wait "
+            << format_duration(static_cast<double>(w.max_wait_ns_)) << "\n";
+
+        out << "  queue wait:";
+        for (size_t b = 0; b < w.wait_histogram_.size(); ++b)
+        {
+            if (w.wait_histogram_[b] != 0)
+            {
+                out << " " << wait_bucket_label(b) << " " << w.wait_histogram_[b];
+            }
+        }
+        out << "\n";
+    }
+    out << "\n";
 }
 
-std::string profiler_report::generate_hierarchical_section() const
+void profiler_report::write_lock_section(std::ostream& out) const
 {
-    std::stringstream ss;
-    ss << "=== Hierarchical Analysis ===\n";
+    out << "=== Lock Contention ===\n";
+    auto const sites = session_.lock_stats();
+    if (sites.empty())
+    {
+        out << "No profiled mutex was acquired.\n\n";
+        return;
+    }
+
+    for (const auto& l : sites)
+    {
+        out << l.site_ << ": " << l.acquisitions_ << " acquisition(s), " << l.contentions_
+            << " contended (" << format_percentage(l.contention_rate()) << "), wait "
+            << format_duration(static_cast<double>(l.wait_ns_)) << ", mean wait "
+            << format_duration(l.mean_wait_ns()) << ", max wait "
+            << format_duration(static_cast<double>(l.max_wait_ns_));
+        if (l.hold_samples_ != 0)
+        {
+            out << ", mean hold " << format_duration(l.mean_hold_ns()) << ", max hold "
+                << format_duration(static_cast<double>(l.max_hold_ns_));
+        }
+        out << "\n";
+    }
+    out << "\n";
+}
+
+void profiler_report::write_overhead_section(std::ostream& out) const
+{
+    out << "=== Overhead Control ===\n";
+    auto const labels = session_.label_overheads();
+    if (labels.empty())
+    {
+        out << "No profiler scope was recorded.\n\n";
+        return;
+    }
+
+    out << "Budget " << format_duration(static_cast<double>(session_.options().overhead_budget_ns_))
+        << " of recording per label; sampled labels record 1 in "
+        << session_.options().overhead_sample_period_ << " scopes\n";
+    size_t displayed = 0;
+    for (const auto& l : labels)
+    {
+        out << l.label_ << (l.sampled_ ? " [sampled]" : "") << ": " << l.calls_ << " call(s), "
+            << l.recorded_ << " recorded, overhead "
+            << format_duration(static_cast<double>(l.overhead_ns_)) << " (mean "
+            << format_duration(l.mean_overhead_ns()) << ")\n";
+        if (++displayed >= 10)
+        {
+            break;
+        }
+    }
+    out << "\n";
+}
+
+void profiler_report::write_gpu_kernel_section(std::ostream& out) const
+{
+    auto const kernels = summarize_kernel_metrics(session_.collected_xspace());
+    if (kernels.empty())
+    {
+        return;
+    }
+
+    out << "=== GPU Kernel Metrics ===\n";
+    size_t displayed = 0;
+    for (const auto& k : kernels)
+    {
+        out << k.kernel << ": " << k.launches << " launch(es), total "
+            << format_duration(static_cast<double>(k.total_ns));
+        for (size_t m = 0; m < kernel_metric_count; ++m)
+        {
+            if (!std::isnan(k.mean[m]))
+            {
+                out << ", " << to_string(static_cast<kernel_metric>(m)) << " "
+                    << format_percentage(k.mean[m] / 100.0);
+            }
+        }
+        out << "\n";
+        if (++displayed >= 10)
+        {
+            break;
+        }
+    }
+    out << "\n";
+}
+
+void profiler_report::write_hierarchical_section(std::ostream& out) const
+{
+    out << "=== Hierarchical Analysis ===\n";
     auto const* root = session_.get_root_scope();
     if (root == nullptr)
     {
-        ss << "No scope hierarchy available.\n\n";
-        return ss.str();
+        out << "No scope hierarchy available.\n\n";
+        return;
     }
 
-    process_scope_data_recursive(*root, ss, 0);
-    ss << "\n";
-    return ss.str();
+    process_scope_data_recursive(*root, out, 0);
+    out << "\n";
 }
 
-std::string profiler_report::generate_statistical_section() const
+void profiler_report::write_statistical_section(std::ostream& out) const
 {
-    std::stringstream ss;
-    ss << "=== Statistical Analysis ===\n";
+    out << "=== Statistical Analysis ===\n";
     auto const* analyzer = session_.statistical_analyzer_ptr();
     if (analyzer == nullptr)
     {
-        ss << "Statistical analysis disabled for this session.\n\n";
-        return ss.str();
+        out << "Statistical analysis disabled for this session.\n\n";
+        return;
     }
 
     auto const timing_metrics = analyzer->calculate_all_timing_stats();
     if (timing_metrics.empty())
     {
-        ss << "No timing statistics recorded.\n\n";
-        return ss.str();
+        out << "No timing statistics recorded.\n\n";
+        return;
+    }
+
+    // Labels whose timing comes from a sample of their scopes
+    std::unordered_map<std::string, uint64_t> sampled_calls;
+    for (const auto& l : session_.label_overheads())
+    {
+        if (l.sampled_)
+        {
+            sampled_calls.emplace(l.label_, l.calls_);
+        }
     }
 
     size_t count = 0;
@@ -636,27 +1196,31 @@ std::string profiler_report::generate_statistical_section() const
         {
             continue;
         }
-        ss << entry.first << ": mean " << format_double(metrics.mean) << " ms, ";
-        ss << "std-dev " << format_double(metrics.std_deviation) << " ms, ";
-        ss << "count " << metrics.count << "\n";
+        out << entry.first << ": mean " << format_double(metrics.mean) << " ms, ";
+        out << "std-dev " << format_double(metrics.std_deviation) << " ms, ";
+        out << "count " << metrics.count;
+        auto const sampled = sampled_calls.find(entry.first);
+        if (sampled != sampled_calls.end())
+        {
+            out << " (sampled from " << sampled->second << " calls)";
+        }
+        out << "\n";
         if (++count >= 10)
         {
             break;
         }
     }
-    ss << "\n";
-    return ss.str();
+    out << "\n";
 }
 
-std::string profiler_report::generate_thread_section() const
+void profiler_report::write_thread_section(std::ostream& out) const
 {
-    std::stringstream ss;
-    ss << "=== Thread Analysis ===\n";
+    out << "=== Thread Analysis ===\n";
     auto const* root = session_.get_root_scope();
     if (root == nullptr)
     {
-        ss << "No thread information available.\n\n";
-        return ss.str();
+        out << "No thread information available.\n\n";
+        return;
     }
 
     auto const snapshots = collect_scope_snapshots(root);
@@ -664,7 +1228,7 @@ std::string profiler_report::generate_thread_section() const
     size_t     rank      = 1;
     for (const auto& entry : histogram)
     {
-        ss << "#" << rank++ << " " << entry.first << ": " << entry.second << " scope(s)\n";
+        out << "#" << rank++ << " " << entry.first << ": " << entry.second << " scope(s)\n";
         if (rank > 10)
         {
             break;
@@ -672,10 +1236,9 @@ std::string profiler_report::generate_thread_section() const
     }
     if (histogram.empty())
     {
-        ss << "No scopes were recorded per-thread.\n";
+        out << "No scopes were recorded per-thread.\n";
     }
-    ss << "\n";
-    return ss.str();
+    out << "\n";
 }
 
 std::string profiler_report::escape_json_string(const std::string& str)
@@ -806,69 +1369,88 @@ std::string profiler_report::generate_xml_attribute(
 }
 
 void profiler_report::process_scope_data_recursive(
-    const profiler_scope_data& scope, std::stringstream& ss, int indent) const
+    const profiler_scope_data& scope, std::ostream& out, int indent) const
 {
     std::string const prefix(static_cast<size_t>(indent) * 2, ' ');
-    ss << prefix << "- " << scope.name_ << " | duration " << format_double(scope.get_duration_ms())
-       << " ms" << " | thread " << format_thread_id(scope.thread_id_) << " | memory "
-       << format_memory_delta(scope.memory_stats_.delta_since_start_) << "\n";
+    out << prefix << "- " << scope.name_ << " | duration " << format_double(scope.get_duration_ms())
+        << " ms" << " | thread " << format_thread_id(scope.thread_id_) << " | memory "
+        << format_memory_delta(scope.memory_stats_.delta_since_start_) << "\n";
 
     for (const auto& child : scope.children_)
     {
-        process_scope_data_recursive(*child, ss, indent + 1);
+        process_scope_data_recursive(*child, out, indent + 1);
     }
 }
 
 void profiler_report::process_scope_data_json_recursive(
-    const profiler_scope_data& scope, std::stringstream& ss, int indent) const
+    const profiler_scope_data& scope, std::ostream& out, int indent) const
 {
     std::string const indent_str(static_cast<size_t>(indent), ' ');
-    ss << indent_str << "{\n";
-    ss << indent_str << "  \"name\": " << escape_json_string(scope.name_) << ",\n";
-    ss << indent_str << "  \"duration_ms\": " << format_double(scope.get_duration_ms()) << ",\n";
-    ss << indent_str << "  \"thread\": " << escape_json_string(format_thread_id(scope.thread_id_))
-       << ",\n";
-    ss << indent_str << "  \"memory\": {\n";
-    ss << indent_str << "    \"current_bytes\": " << scope.memory_stats_.current_usage_ << ",\n";
-    ss << indent_str << "    \"peak_bytes\": " << scope.memory_stats_.peak_usage_ << ",\n";
-    ss << indent_str << "    \"delta_bytes\": " << scope.memory_stats_.delta_since_start_ << "\n";
-    ss << indent_str << "  }";
+    out << indent_str << "{\n";
+    out << indent_str << "  \"name\": " << escape_json_string(scope.name_) << ",\n";
+    out << indent_str << "  \"duration_ms\": " << format_double(scope.get_duration_ms()) << ",\n";
+    out << indent_str << "  \"thread\": " << escape_json_string(format_thread_id(scope.thread_id_))
+        << ",\n";
+    out << indent_str << "  \"memory\": {\n";
+    out << indent_str << "    \"current_bytes\": " << scope.memory_stats_.current_usage_ << ",\n";
+    out << indent_str << "    \"peak_bytes\": " << scope.memory_stats_.peak_usage_ << ",\n";
+    out << indent_str << "    \"delta_bytes\": " << scope.memory_stats_.delta_since_start_ << "\n";
+    out << indent_str << "  }";
+
+    if (const auto& counters = scope.hardware_counters_; !counters.empty())
+    {
+        using quarisma::profiler::hardware_counter;
+        out << ",\n" << indent_str << "  \"hardware_counters\": {\n";
+        for (size_t i = 0; i < quarisma::profiler::kNumHardwareCounters; ++i)
+        {
+            auto const counter = static_cast<hardware_counter>(i);
+            if (counters.has(counter))
+            {
+                out << indent_str << "    \""
+                    << quarisma::profiler::hardware_counter_name(counter)
+                    << "\": " << counters.get(counter) << ",\n";
+            }
+        }
+        out << indent_str << "    \"ipc\": " << format_double(counters.ipc()) << "\n";
+        out << indent_str << "  }";
+    }
 
     if (!scope.children_.empty())
     {
-        ss << ",\n" << indent_str << "  \"children\": [\n";
+        out << ",\n" << indent_str << "  \"children\": [\n";
         for (size_t i = 0; i < scope.children_.size(); ++i)
         {
-            process_scope_data_json_recursive(*scope.children_[i], ss, indent + 4);
+            process_scope_data_json_recursive(*scope.children_[i], out, indent + 4);
             if (i + 1 < scope.children_.size())
             {
-                ss << ",\n";
+                out << ",\n";
             }
         }
-        ss << "\n" << indent_str << "  ]\n" << indent_str << "}";
+        out << "\n" << indent_str << "  ]\n" << indent_str << "}";
     }
     else
     {
-        ss << "\n" << indent_str << "}";
+        out << "\n" << indent_str << "}";
     }
 }
 
 void profiler_report::process_scope_data_csv_recursive(
-    const profiler_scope_data& scope, std::vector<std::string>& rows, int depth) const
-{
-    rows.push_back(generate_csv_row({
-        std::string(static_cast<size_t>(depth) * 2, ' ') + scope.name_,
-        std::to_string(depth),
-        format_thread_id(scope.thread_id_),
-        format_double(scope.get_duration_ms()),
-        format_memory_size(scope.memory_stats_.current_usage_),
-        format_memory_size(scope.memory_stats_.peak_usage_),
-        format_memory_delta(scope.memory_stats_.delta_since_start_),
-    }));
+    const profiler_scope_data& scope, std::ostream& out, int depth) const
+{
+    out << generate_csv_row({
+               std::string(static_cast<size_t>(depth) * 2, ' ') + scope.name_,
+               std::to_string(depth),
+               format_thread_id(scope.thread_id_),
+               format_double(scope.get_duration_ms()),
+               format_memory_size(scope.memory_stats_.current_usage_),
+               format_memory_size(scope.memory_stats_.peak_usage_),
+               format_memory_delta(scope.memory_stats_.delta_since_start_),
+           })
+        << "\n";
 
     for (const auto& child : scope.children_)
     {
-        process_scope_data_csv_recursive(*child, rows, depth + 1);
+        process_scope_data_csv_recursive(*child, out, depth + 1);
     }
 }
 
@@ -21,10 +21,12 @@
 
 #include <fstream>
 #include <iomanip>
+#include <ostream>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "memory/columnar/column.h"
 #include "profiler/native/analysis/statistical_analyzer.h"
 #include "profiler/native/memory/memory_tracker.h"
 #include "profiler/native/session/profiler.h"
@@ -37,6 +39,12 @@ namespace quarisma
  *
  * Provides comprehensive report generation capabilities with multiple
  * output formats including console, JSON, CSV, and XML formats.
+ *
+ * The write_*() methods stream a report as it is generated, so its size
+ * never adds to the peak memory of a session with millions of scopes; the
+ * generate_*() methods return the same text as a string, and export_*()
+ * stream to a file. generate_columnar_report() flattens the scope tree
+ * into a columnar::record_batch for downstream analytics.
  */
 class QUARISMA_VISIBILITY profiler_report
 {
@@ -76,6 +84,59 @@ public:
      */
     QUARISMA_API std::string generate_xml_report() const;
 
+    /**
+     * @brief Stream a report to an output stream as it is generated
+     * @param out Stream to write to; its error state tells whether the write succeeded
+     */
+    QUARISMA_API void write_console_report(std::ostream& out) const;
+    QUARISMA_API void write_json_report(std::ostream& out) const;
+    QUARISMA_API void write_csv_report(std::ostream& out) const;
+    QUARISMA_API void write_xml_report(std::ostream& out) const;
+
+    /**
+     * @brief Stream a report in the specified format to an output stream
+     * @param out Stream to write to
+     * @param format Output format to use
+     */
+    QUARISMA_API void write_report(
+        std::ostream& out, quarisma::profiler_options::output_format_enum format) const;
+
+    /**
+     * @brief Stream a report in the specified format to a file descriptor
+     * @param fd Open descriptor, e.g. a pipe or socket; it is left open
+     * @param format Output format to use
+     * @return true if every byte was written, false otherwise
+     */
+    QUARISMA_API bool write_report(
+        int fd, quarisma::profiler_options::output_format_enum format) const;
+
+    /**
+     * @brief Flatten the scope tree into columns, one row per scope in depth-first order
+     *
+     * Columns: parent (int64, row of the parent scope, -1 for the root),
+     * depth (uint32), name and thread (uint32, indices into `strings`),
+     * start_ns (int64, from the session start), duration_ns (int64),
+     * memory_current_bytes, memory_peak_bytes (uint64), memory_delta_bytes
+     * (int64), and cycles and instructions (uint64, null where the counter
+     * was not read). Hierarchical data is always included.
+     *
+     * @param strings Receives the scope names and thread ids the columns index
+     * @return The batch, empty if no scope was recorded
+     */
+    QUARISMA_API columnar::record_batch generate_columnar_report(
+        std::vector<std::string>& strings) const;
+
+    /**
+     * @brief Export the columnar report through columnar::write_file()
+     *
+     * The batch goes to `filename`, memory-mappable and exchangeable with
+     * Arrow through arrow_bridge.h; the strings its name and thread columns
+     * index go to `filename` + ".strings.json" as a JSON array.
+     * @param filename Path to output file
+     * @return true if export successful, false otherwise
+     */
+    QUARISMA_API bool export_columnar_report(const std::string& filename) const;
+
     /**
      * @brief Export report to file in specified format
      * @param filename Path to output file
@@ -145,14 +206,19 @@ private:
     static std::string format_thread_id(const std::thread::id& thread_id);
 
     std::string format_double(double value) const;
-    // Section generators
-    std::string generate_header_section() const;
-    std::string generate_summary_section() const;
-    std::string generate_timing_section() const;
-    std::string generate_memory_section() const;
-    std::string generate_hierarchical_section() const;
-    std::string generate_statistical_section() const;
-    std::string generate_thread_section() const;
+    // Section writers
+    void write_header_section(std::ostream& out) const;
+    void write_summary_section(std::ostream& out) const;
+    void write_timing_section(std::ostream& out) const;
+    void write_memory_section(std::ostream& out) const;
+    void write_hardware_counter_section(std::ostream& out) const;
+    void write_thread_pool_section(std::ostream& out) const;
+    void write_lock_section(std::ostream& out) const;
+    void write_overhead_section(std::ostream& out) const;
+    void write_gpu_kernel_section(std::ostream& out) const;
+    void write_hierarchical_section(std::ostream& out) const;
+    void write_statistical_section(std::ostream& out) const;
+    void write_thread_section(std::ostream& out) const;
 
     // JSON helpers
     static std::string escape_json_string(const std::string& str);
@@ -169,13 +235,11 @@ private:
 
     // Hierarchical data processing
     void process_scope_data_recursive(
-        const quarisma::profiler_scope_data& scope, std::stringstream& ss, int indent = 0) const;
+        const quarisma::profiler_scope_data& scope, std::ostream& out, int indent = 0) const;
     void process_scope_data_json_recursive(
-        const quarisma::profiler_scope_data& scope, std::stringstream& ss, int indent = 0) const;
+        const quarisma::profiler_scope_data& scope, std::ostream& out, int indent = 0) const;
     void process_scope_data_csv_recursive(
-        const quarisma::profiler_scope_data& scope,
-        std::vector<std::string>&          rows,
-        int                                depth = 0) const;
+        const quarisma::profiler_scope_data& scope, std::ostream& out, int depth = 0) const;
 };
 
 // Report builder with fluent interface
@@ -35,15 +35,19 @@ limitations under the License.
 
 #include <chrono>
 #include <cstdint>
+#include <initializer_list>
 #include <limits>
 #include <string>
 #include <type_traits>
 #include <utility>
 
 #include "logging/logger.h"
+#include "profiler/base/external_ranges.h"
 #include "profiler/native/tracing/traceme_encode.h"
+#include "profiler/native/tracing/traceme_name.h"
 #include "profiler/native/tracing/traceme_recorder.h"
 #include "util/no_init.h"
+#include "util/tsc_clock.h"
 
 namespace quarisma
 {
@@ -60,18 +64,14 @@ namespace quarisma
  * **Performance**: Optimized for speed - typically 10-50 nanoseconds per call
  * **Resolution**: Nanosecond precision where supported by the system
  * **Thread Safety**: Safe to call from any thread
- * **Monotonic**: Uses high_resolution_clock which may not be monotonic on all systems,
- *                but provides the best available precision for profiling
+ * **Monotonic**: Reads tsc_clock, the calibrated cycle counter on the steady_clock
+ *                timeline, or steady_clock itself when the counter is unusable
  *
  * @note This function is force-inlined for optimal performance in hot paths
  */
 QUARISMA_FORCE_INLINE int64_t get_current_time_nanos()
 {
-    // Monotonic clock for consistent relative timing
-    auto now = std::chrono::steady_clock::now();
-    auto nanos =
-        std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
-    return nanos;
+    return tsc_clock::now_ns();
 }
 
 /**
@@ -212,8 +212,14 @@ public:
             traceme_recorder::active(level) && traceme_recorder::check_filter(filter_mask))
         {
             name_.Emplace(std::string(name));
+            payload_.Emplace();
             start_time_ = get_current_time_nanos();
         }
+        if QUARISMA_UNLIKELY (quarisma::profiler::external_ranges::active(level))
+        {
+            quarisma::profiler::external_ranges::push(name);
+            external_range_ = true;
+        }
 #endif
     }
 
@@ -263,6 +269,50 @@ public:
      */
     explicit traceme(const char* raw, int level = 1) : traceme(std::string_view(raw), level) {}
 
+    /**
+     * @brief Constructs a scoped trace event with an interned name and arguments.
+     *
+     * Records the same event as
+     * `traceme([&]() { return traceme_encode(name.str(), {...}); })`, but the
+     * name and arguments are stored as ids and typed values: no string is
+     * built or allocated while recording. The name is formatted when the
+     * events are collected.
+     *
+     * @param name Interned event name, usually a static
+     * @param args Interned keys with numeric, boolean or traceme_name values;
+     *             at most traceme_payload::kMaxArgs are kept
+     * @param level Trace priority level (default: 1)
+     *
+     * **Example**:
+     * ```cpp
+     * static const traceme_name kGemm("gemm");
+     * static const traceme_name kRows("rows");
+     * traceme trace(kGemm, {{kRows, rows}});
+     * ```
+     */
+    explicit traceme(
+        const traceme_name&                         name,
+        std::initializer_list<traceme_interned_arg> args        = {},
+        int                                         level       = 1,
+        uint64_t                                    filter_mask = kTraceFilterDefaultMask)
+    {
+        QUARISMA_CHECK_DEBUG(level >= 1, "level is less than 1");
+#if !defined(IS_MOBILE_PLATFORM)
+        if QUARISMA_UNLIKELY (
+            traceme_recorder::active(level) && traceme_recorder::check_filter(filter_mask))
+        {
+            name_.Emplace();
+            payload_.Emplace(name, args);
+            start_time_ = get_current_time_nanos();
+        }
+        if QUARISMA_UNLIKELY (quarisma::profiler::external_ranges::active(level))
+        {
+            quarisma::profiler::external_ranges::push(name.id(), name.str());
+            external_range_ = true;
+        }
+#endif
+    }
+
     /**
      * @brief Constructs a trace event with lazy name generation for optimal performance.
      *
@@ -310,11 +360,23 @@ public:
     {
         QUARISMA_CHECK_DEBUG(level >= 1, "level is less than 1");
 #if !defined(IS_MOBILE_PLATFORM)
-        if QUARISMA_UNLIKELY (
-            traceme_recorder::active(level) && traceme_recorder::check_filter(filter_mask))
+        bool const record =
+            traceme_recorder::active(level) && traceme_recorder::check_filter(filter_mask);
+        bool const annotate = quarisma::profiler::external_ranges::active(level);
+        if QUARISMA_UNLIKELY (record || annotate)
         {
-            name_.Emplace(std::forward<NameGeneratorT>(name_generator)());
-            start_time_ = get_current_time_nanos();
+            std::string name(std::forward<NameGeneratorT>(name_generator)());
+            if (annotate)
+            {
+                quarisma::profiler::external_ranges::push(name);
+                external_range_ = true;
+            }
+            if (record)
+            {
+                name_.Emplace(std::move(name));
+                payload_.Emplace();
+                start_time_ = get_current_time_nanos();
+            }
         }
 #endif
     }
@@ -351,8 +413,14 @@ public:
         if QUARISMA_UNLIKELY (other.start_time_ != kUntracedActivity)
         {
             name_.Emplace(std::move(other.name_).Consume());
+            payload_.Emplace(other.payload_.value);
             start_time_ = std::exchange(other.start_time_, kUntracedActivity);
         }
+        if QUARISMA_UNLIKELY (external_range_)
+        {
+            quarisma::profiler::external_ranges::pop();
+        }
+        external_range_ = std::exchange(other.external_range_, false);
 #endif
         return *this;
     }
@@ -415,11 +483,19 @@ public:
             if QUARISMA_LIKELY (traceme_recorder::active())
             {
                 traceme_recorder::record(
-                    {std::move(name_.value), start_time_, get_current_time_nanos()});
+                    {std::move(name_.value),
+                     start_time_,
+                     get_current_time_nanos(),
+                     payload_.value});
             }
             name_.Destroy();
             start_time_ = kUntracedActivity;
         }
+        if QUARISMA_UNLIKELY (external_range_)
+        {
+            quarisma::profiler::external_ranges::pop();
+            external_range_ = false;
+        }
 #endif
     }
 
@@ -469,6 +545,11 @@ public:
         {
             if QUARISMA_LIKELY (traceme_recorder::active())
             {
+                if (!payload_.value.empty())
+                {
+                    // The metadata is a string: format the interned name now
+                    name_.value = std::exchange(payload_.value, traceme_payload()).format();
+                }
                 traceme_internal::append_metadata(
                     &name_.value, std::forward<MetadataGeneratorT>(metadata_generator)());
             }
@@ -559,7 +640,42 @@ public:
             traceme_recorder::active(level) && traceme_recorder::check_filter(filter_mask))
         {
             int64_t activity_id = traceme_recorder::new_activity_id();
-            traceme_recorder::record({std::string(name), get_current_time_nanos(), -activity_id});
+            traceme_recorder::record(
+                {std::string(name), get_current_time_nanos(), -activity_id, traceme_payload()});
+            return activity_id;
+        }
+#endif
+        return kUntracedActivity;
+    }
+
+    /**
+     * @brief Starts a trace activity with an interned name and arguments.
+     *
+     * Like the traceme constructor taking a traceme_name, records the start
+     * without building a string.
+     *
+     * @param name Interned activity name
+     * @param args Interned keys with numeric, boolean or traceme_name values
+     * @param level Trace priority level (default: 1)
+     * @return Unique activity ID for use with activity_end(), or kUntracedActivity
+     *         if tracing is disabled
+     */
+    static int64_t activity_start(
+        const traceme_name&                         name,
+        std::initializer_list<traceme_interned_arg> args        = {},
+        int                                         level       = 1,
+        uint64_t                                    filter_mask = kTraceFilterDefaultMask)
+    {
+#if !defined(IS_MOBILE_PLATFORM)
+        if QUARISMA_UNLIKELY (
+            traceme_recorder::active(level) && traceme_recorder::check_filter(filter_mask))
+        {
+            int64_t activity_id = traceme_recorder::new_activity_id();
+            traceme_recorder::record(
+                {std::string(),
+                 get_current_time_nanos(),
+                 -activity_id,
+                 traceme_payload(name, args)});
             return activity_id;
         }
 #endif
@@ -620,7 +736,8 @@ public:
         {
             if QUARISMA_LIKELY (traceme_recorder::active())
             {
-                traceme_recorder::record({std::string(), -activity_id, get_current_time_nanos()});
+                traceme_recorder::record(
+                    {std::string(), -activity_id, get_current_time_nanos(), traceme_payload()});
             }
         }
 #endif
@@ -749,8 +866,14 @@ private:
     /// Lazily-initialized trace name storage (only allocated when tracing is active)
     no_init<std::string> name_;
 
+    /// Interned name and arguments, initialized along with name_
+    no_init<traceme_payload> payload_;
+
     /// Start timestamp in nanoseconds, or kUntracedActivity if tracing is disabled
     int64_t start_time_ = kUntracedActivity;
+
+    /// Whether an NVTX/ITT range was opened for this event (see external_ranges)
+    bool external_range_ = false;
 };
 
 /**
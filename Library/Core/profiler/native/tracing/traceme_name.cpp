@@ -0,0 +1,137 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "profiler/native/tracing/traceme_name.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "util/exception.h"
+#include "util/flat_hash.h"
+#include "util/string_util.h"
+
+namespace quarisma
+{
+
+namespace
+{
+
+class traceme_name_registry
+{
+public:
+    static traceme_name_registry& instance()
+    {
+        static traceme_name_registry* registry = new traceme_name_registry();  // Never destroyed
+        return *registry;
+    }
+
+    uint32_t add(std::string_view name)
+    {
+        std::scoped_lock const lock(mutex_);
+        if (auto it = ids_.find(name); it != ids_.end())
+        {
+            return it->second;
+        }
+        // Ids index names_ from 1; deque elements do not move, so the keys
+        // of ids_ and the views returned by lookup() stay valid
+        names_.emplace_back(name);
+        auto const id = static_cast<uint32_t>(names_.size());
+        ids_.emplace(names_.back(), id);
+        return id;
+    }
+
+    std::string_view lookup(uint32_t id) const
+    {
+        std::scoped_lock const lock(mutex_);
+        if (id == 0 || id > names_.size())
+        {
+            return {};
+        }
+        return names_[id - 1];
+    }
+
+private:
+    mutable std::mutex                                  mutex_;
+    std::deque<std::string>                             names_;
+    quarisma::flat_hash_map<std::string_view, uint32_t> ids_;
+};
+
+void append_value(std::string* out, traceme_arg_type type, uint64_t value)
+{
+    switch (type)
+    {
+    case traceme_arg_type::kInt64:
+        out->append(std::to_string(static_cast<int64_t>(value)));
+        break;
+    case traceme_arg_type::kUint64:
+        out->append(std::to_string(value));
+        break;
+    case traceme_arg_type::kDouble:
+    {
+        double d;
+        std::memcpy(&d, &value, sizeof(d));
+        out->append(std::to_string(d));
+        break;
+    }
+    case traceme_arg_type::kBool:
+        out->append(value != 0 ? "true" : "false");
+        break;
+    case traceme_arg_type::kName:
+        out->append(traceme_name::lookup(static_cast<uint32_t>(value)));
+        break;
+    case traceme_arg_type::kNone:
+        break;
+    }
+}
+
+}  // namespace
+
+traceme_name::traceme_name(std::string_view name)
+{
+    QUARISMA_CHECK(
+        !strings::str_contains(name, '#'), "'#' is not a valid character in traceme_name {}", name);
+    id_ = traceme_name_registry::instance().add(name);
+}
+
+std::string_view traceme_name::lookup(uint32_t id)
+{
+    return traceme_name_registry::instance().lookup(id);
+}
+
+std::string traceme_payload::format() const
+{
+    std::string name(traceme_name::lookup(name_id));
+    if (arg_count == 0)
+    {
+        return name;
+    }
+    name.push_back('#');
+    for (uint8_t i = 0; i < arg_count; ++i)
+    {
+        name.append(traceme_name::lookup(keys[i]));
+        name.push_back('=');
+        append_value(&name, types[i], values[i]);
+        name.push_back(',');
+    }
+    name.back() = '#';
+    return name;
+}
+
+}  // namespace quarisma
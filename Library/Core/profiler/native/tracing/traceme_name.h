@@ -0,0 +1,184 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "common/macros.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief Event name or argument key registered once with a numeric id.
+ *
+ * Interned names let traceme record an event and its arguments as a few
+ * integers instead of a string built with traceme_encode(); the string is
+ * formatted when the events are collected, off the hot path. Registration
+ * takes a global lock, so declare names as function-local or namespace-scope
+ * statics:
+ *
+ * ```cpp
+ * static const traceme_name kGemm("gemm");
+ * static const traceme_name kRows("rows");
+ * traceme trace(kGemm, {{kRows, rows}});  // recorded as "gemm#rows=<rows>#"
+ * ```
+ *
+ * Registering the same string twice returns the same id. Names are never
+ * unregistered.
+ *
+ * **Thread Safety**: Registration and lookup are thread-safe
+ */
+class QUARISMA_VISIBILITY traceme_name
+{
+public:
+    /**
+     * @brief Register a name
+     * @param name Event name or argument key; must not contain '#'
+     */
+    QUARISMA_API explicit traceme_name(std::string_view name);
+
+    /** Get the id of the name, never 0. */
+    uint32_t id() const { return id_; }
+
+    /** Get the registered string. */
+    std::string_view str() const { return lookup(id_); }
+
+    /**
+     * @brief Get the string registered under an id
+     * @return The string, or an empty view for an unknown id
+     */
+    QUARISMA_API static std::string_view lookup(uint32_t id);
+
+private:
+    uint32_t id_;
+};
+
+/**
+ * @brief Type of an interned traceme argument value.
+ */
+enum class traceme_arg_type : uint8_t
+{
+    kNone,
+    kInt64,
+    kUint64,
+    kDouble,
+    kBool,
+    kName  ///< Value is the id of a traceme_name
+};
+
+/**
+ * @brief Argument of an interned traceme event: an interned key and a typed value.
+ *
+ * Values are formatted as traceme_encode() formats TraceMeArg, so an interned
+ * event has the same name as its string-encoded equivalent. Strings are only
+ * accepted as traceme_name values; use traceme_encode() for dynamic strings.
+ */
+struct traceme_interned_arg
+{
+    template <
+        typename T,
+        std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, bool> = true>
+    traceme_interned_arg(const traceme_name& k, T v) : key(k.id())
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            type = traceme_arg_type::kDouble;
+            const double d = v;
+            std::memcpy(&value, &d, sizeof(d));
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            type  = traceme_arg_type::kInt64;
+            value = static_cast<uint64_t>(static_cast<int64_t>(v));
+        }
+        else
+        {
+            type  = traceme_arg_type::kUint64;
+            value = static_cast<uint64_t>(v);
+        }
+    }
+
+    traceme_interned_arg(const traceme_name& k, bool v)
+        : key(k.id()), type(traceme_arg_type::kBool), value(v ? 1 : 0)
+    {
+    }
+
+    traceme_interned_arg(const traceme_name& k, const traceme_name& v)
+        : key(k.id()), type(traceme_arg_type::kName), value(v.id())
+    {
+    }
+
+    uint32_t         key;
+    traceme_arg_type type  = traceme_arg_type::kNone;
+    uint64_t         value = 0;
+};
+
+/**
+ * @brief Interned name and arguments of a recorded event, stored inline in the event.
+ *
+ * A name_id of 0 means the event carries an ordinary string name. Arguments
+ * beyond kMaxArgs are dropped.
+ */
+struct QUARISMA_VISIBILITY traceme_payload
+{
+    static constexpr size_t kMaxArgs = 4;
+
+    traceme_payload() = default;
+
+    traceme_payload(const traceme_name& name, std::initializer_list<traceme_interned_arg> args)
+        : name_id(name.id())
+    {
+        for (const auto& arg : args)
+        {
+            if QUARISMA_UNLIKELY (arg_count == kMaxArgs)
+            {
+                break;
+            }
+            keys[arg_count]   = arg.key;
+            types[arg_count]  = arg.type;
+            values[arg_count] = arg.value;
+            ++arg_count;
+        }
+    }
+
+    /** Check whether the event has an ordinary string name instead. */
+    bool empty() const { return name_id == 0; }
+
+    /**
+     * @brief Build the event name in the traceme_encode() format
+     * @return "name#key1=value1,key2=value2#", or "name" without arguments
+     */
+    QUARISMA_API std::string format() const;
+
+    uint32_t         name_id   = 0;
+    uint8_t          arg_count = 0;
+    traceme_arg_type types[kMaxArgs]{};
+    uint32_t         keys[kMaxArgs]{};
+    uint64_t         values[kMaxArgs]{};
+};
+
+}  // namespace quarisma
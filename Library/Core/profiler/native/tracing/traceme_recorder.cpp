@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
@@ -39,6 +40,7 @@
 #include "util/flat_hash.h"
 #include "util/lock_free_queue.h"
 #include "util/per_thread.h"
+#include "util/tsc_clock.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -76,6 +78,27 @@ static_assert(ATOMIC_INT_LOCK_FREE == 2, "Assumed atomic<int> was lock free");
 namespace
 {
 
+// Flight-recorder mode: record() writes to the per-thread rings instead of the
+// queues. g_flight_mutex serializes snapshot() with stop() and with itself.
+std::atomic<bool>    g_flight_recorder{false};
+std::atomic<size_t>  g_flight_capacity{0};
+std::atomic<int64_t> g_flight_window_ns{0};
+std::mutex           g_flight_mutex;
+
+// g_trace_level while start_flight_recorder() sets the mode up; no level is active
+constexpr int kTracingStarting = -2;
+
+// Builds the name of an event recorded with an interned name. Called as
+// events are collected, so that recording threads never format strings.
+void format_name(traceme_recorder::Event* event)
+{
+    if QUARISMA_UNLIKELY (!event->payload.empty())
+    {
+        event->name    = event->payload.format();
+        event->payload = traceme_payload();
+    }
+}
+
 // Track events created by ActivityStart and merge their data into events
 // created by ActivityEnd. TraceMe records events in its destructor, so this
 // results in complete events sorted by their end_time in the thread they ended.
@@ -183,6 +206,7 @@ public:
         std::optional<traceme_recorder::Event> event;
         while ((event = queue_.pop()))
         {
+            format_name(&*event);
             if (event->is_start())
             {
                 split_event_tracker->AddStart(*std::move(event));
@@ -197,11 +221,122 @@ public:
         return events;
     }
 
+    // RecordRecent is only called from the producer thread, in flight-recorder
+    // mode. Once the ring is full, the oldest event is overwritten.
+    void RecordRecent(traceme_recorder::Event&& event, size_t capacity)
+    {
+        std::scoped_lock const lock(ring_mutex_);
+        if (ring_.size() < capacity)
+        {
+            ring_.push_back(std::move(event));
+        }
+        else if (!ring_.empty())
+        {
+            ring_[ring_head_] = std::move(event);
+            ring_head_        = (ring_head_ + 1) % ring_.size();
+        }
+    }
+
+    // CopyRecent is called from the control thread; returns the ring oldest
+    // first, and empties it if `release` is set.
+    std::deque<traceme_recorder::Event> CopyRecent(bool release)
+    {
+        std::deque<traceme_recorder::Event> events;
+        std::scoped_lock const              lock(ring_mutex_);
+        for (size_t i = 0; i < ring_.size(); ++i)
+        {
+            events.push_back(ring_[(ring_head_ + i) % ring_.size()]);
+        }
+        if (release)
+        {
+            std::vector<traceme_recorder::Event>().swap(ring_);
+            ring_head_ = 0;
+        }
+        return events;
+    }
+
+    // Drain is called from the control thread while tracing is active.
+    void Drain(const traceme_recorder::EventVisitor& visitor)
+    {
+        std::optional<traceme_recorder::Event> event;
+        while ((event = queue_.pop()))
+        {
+            format_name(&*event);
+            visitor(info_, *std::move(event));
+        }
+    }
+
 private:
     traceme_recorder::ThreadInfo           info_;
     LockFreeQueue<traceme_recorder::Event> queue_;
+
+    // Flight-recorder ring, with ring_[ring_head_] the oldest event once full
+    std::mutex                           ring_mutex_;
+    std::vector<traceme_recorder::Event> ring_ QUARISMA_GUARDED_BY(ring_mutex_);
+    size_t                               ring_head_ QUARISMA_GUARDED_BY(ring_mutex_) = 0;
 };
 
+// Collects the flight-recorder rings of all live threads: complete events that
+// ended after `cutoff`, with split activities paired.
+traceme_recorder::Events collect_recent(int64_t cutoff, bool release)
+{
+    traceme_recorder::Events result;
+    SplitEventTracker        split_event_tracker;
+    auto                     recorders = per_thread<ThreadLocalRecorder>::GetAll();
+    // The tracker points into the deques: result must not reallocate, which
+    // copies them since the deque move constructor is not noexcept
+    result.reserve(recorders.size());
+    for (auto& recorder : recorders)
+    {
+        std::deque<traceme_recorder::Event> events;
+        for (auto& event : recorder->CopyRecent(release))
+        {
+            // Outside the ring lock, which the recording thread contends for
+            format_name(&event);
+            if (event.is_start())
+            {
+                split_event_tracker.AddStart(std::move(event));
+                continue;
+            }
+            events.push_back(std::move(event));
+            if (events.back().is_end())
+            {
+                split_event_tracker.AddEnd(&events.back());
+            }
+        }
+        if (!events.empty())
+        {
+            result.push_back({recorder->Info(), std::move(events)});
+        }
+    }
+    split_event_tracker.HandleCrossThreadEvents();
+
+    for (auto& thread : result)
+    {
+        auto& events = thread.events;
+        events.erase(
+            std::remove_if(
+                events.begin(),
+                events.end(),
+                [cutoff](const traceme_recorder::Event& event)
+                { return !event.is_complete() || event.end_time < cutoff; }),
+            events.end());
+    }
+    result.erase(
+        std::remove_if(
+            result.begin(),
+            result.end(),
+            [](const traceme_recorder::ThreadEvents& thread) { return thread.events.empty(); }),
+        result.end());
+    return result;
+}
+
+// Start of the snapshot window, on the clock of traceme timestamps
+int64_t flight_window_start()
+{
+    return tsc_clock::now_ns() - g_flight_window_ns.load(std::memory_order_relaxed);
+}
+
 }  // namespace
 
 // This method is performance critical and should be kept fast. It is called
@@ -222,6 +357,8 @@ private:
     traceme_recorder::Events result;
     SplitEventTracker        split_event_tracker;
     auto                     recorders = per_thread<ThreadLocalRecorder>::StopRecording();
+    // See collect_recent()
+    result.reserve(recorders.size());
     for (auto& recorder : recorders)
     {
         auto events = recorder->Consume(&split_event_tracker);
@@ -257,9 +394,64 @@ private:
     return started;
 }
 
+/* static */ bool traceme_recorder::start_flight_recorder(const FlightRecorderOptions& options)
+{
+    QUARISMA_CHECK(
+        options.events_per_thread > 0, "traceme_recorder: flight recorder ring must not be empty");
+    QUARISMA_CHECK(
+        options.window.count() > 0, "traceme_recorder: flight recorder window must be positive");
+
+    // Claim the session without enabling any level until the rings are set up
+    int expected = kTracingDisabled;
+    if (!internal::g_trace_level.compare_exchange_strong(
+            expected, kTracingStarting, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+
+    {
+        std::scoped_lock const lock(g_flight_mutex);
+        g_flight_capacity.store(options.events_per_thread, std::memory_order_relaxed);
+        g_flight_window_ns.store(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(options.window).count(),
+            std::memory_order_relaxed);
+        // Events left over from a record() that raced with the last stop()
+        for (auto& recorder : per_thread<ThreadLocalRecorder>::GetAll())
+        {
+            (void)recorder->CopyRecent(true);
+        }
+        g_flight_recorder.store(true, std::memory_order_release);
+    }
+
+    internal::g_trace_filter_bitmap.store(options.filter_mask, std::memory_order_relaxed);
+    internal::g_trace_level.store(options.level > 0 ? options.level : 0, std::memory_order_release);
+    return true;
+}
+
+/* static */ traceme_recorder::Events traceme_recorder::snapshot()
+{
+    std::scoped_lock const lock(g_flight_mutex);
+    if (!flight_recorder_active())
+    {
+        return {};
+    }
+    return collect_recent(flight_window_start(), false);
+}
+
+/* static */ bool traceme_recorder::flight_recorder_active()
+{
+    return g_flight_recorder.load(std::memory_order_acquire) && active(0);
+}
+
 /* static */ void traceme_recorder::record(Event&& event)
 {
-    per_thread<ThreadLocalRecorder>::Get().Record(std::move(event));
+    auto& recorder = per_thread<ThreadLocalRecorder>::Get();
+    if (g_flight_recorder.load(std::memory_order_relaxed))
+    {
+        recorder.RecordRecent(std::move(event), g_flight_capacity.load(std::memory_order_relaxed));
+        return;
+    }
+    recorder.Record(std::move(event));
 }
 
 /* static */ traceme_recorder::Events traceme_recorder::stop()
@@ -268,13 +460,33 @@ private:
     if (internal::g_trace_level.exchange(kTracingDisabled, std::memory_order_acq_rel) !=
         kTracingDisabled)
     {
-        events = consume();
+        std::scoped_lock const lock(g_flight_mutex);
+        if (g_flight_recorder.exchange(false, std::memory_order_acq_rel))
+        {
+            events = collect_recent(flight_window_start(), true);
+        }
+        else
+        {
+            events = consume();
+        }
     }
     // Clear the filter bitmap
     internal::g_trace_filter_bitmap.store(kDefaultTraceFilter, std::memory_order_relaxed);
     return events;
 }
 
+/* static */ void traceme_recorder::drain(const EventVisitor& visitor)
+{
+    if (!active(0))
+    {
+        return;
+    }
+    for (auto& recorder : per_thread<ThreadLocalRecorder>::GetAll())
+    {
+        recorder->Drain(visitor);
+    }
+}
+
 /*static*/ int64_t traceme_recorder::new_activity_id()
 {
     // Activity IDs: To avoid contention over a counter, the top 32 bits identify
@@ -20,13 +20,17 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <string>
 #include <vector>
 
 #include "common/macros.h"
+#include "profiler/native/tracing/traceme_name.h"
 
 namespace quarisma
 {
@@ -93,7 +97,7 @@ QUARISMA_API extern std::atomic<uint64_t> g_trace_filter_bitmap;
  *
  * **Performance Characteristics**:
  * - Recording overhead: ~10-20 nanoseconds per event
- * - Memory usage: ~64 bytes per recorded event
+ * - Memory usage: ~112 bytes per recorded event
  * - Thread contention: Minimal due to thread-local buffers
  * - Collection time: Proportional to number of events and threads
  *
@@ -146,6 +150,9 @@ public:
         std::string name;    ///< Human-readable event name with optional metadata
         int64_t start_time;  ///< Start timestamp (ns since epoch) or -activity_id for end events
         int64_t end_time;    ///< End timestamp (ns since epoch) or -activity_id for start events
+
+        /// Interned name and arguments, formatted into `name` when the event is collected
+        traceme_payload payload;
     };
     /**
      * @brief Thread identification and metadata for trace event attribution.
@@ -218,7 +225,8 @@ public:
      * the corresponding start() call. Events are organized by thread and include
      * complete timing information with start/end event pairing resolved.
      *
-     * @return Collection of events grouped by thread, or empty if tracing wasn't active
+     * @return Collection of events grouped by thread, or empty if tracing wasn't active.
+     *         In flight-recorder mode, the final snapshot().
      *
      * **Thread Safety**: Safe to call from any thread
      * **Event Processing**: Automatically pairs start/end events and discards orphaned events
@@ -227,6 +235,90 @@ public:
      */
     QUARISMA_API static Events stop();
 
+    /**
+     * @brief Configuration of the flight-recorder mode.
+     */
+    struct FlightRecorderOptions
+    {
+        int level = 1;  ///< Maximum trace level to record
+
+        uint64_t filter_mask = kDefaultTraceFilter;  ///< Bitmap filter for recorded events
+
+        /// Age of the oldest event a snapshot returns
+        std::chrono::milliseconds window{1000};
+
+        /// Capacity of each thread's ring; a busy thread keeps fewer than `window` of events
+        size_t events_per_thread = 8192;
+    };
+
+    /**
+     * @brief Starts recording in flight-recorder mode.
+     *
+     * Instead of queueing every event until stop(), each thread keeps its most
+     * recent events in a fixed-size ring that overwrites the oldest entry, so
+     * the recorder can stay on indefinitely with bounded memory: at most
+     * `events_per_thread` events per live thread. snapshot() returns the last
+     * `window` of events at any time, for instance when a request breaches its
+     * latency target; stop() ends the mode and returns a final snapshot.
+     *
+     * Events of threads that exit are discarded with their ring.
+     *
+     * @param options Level, filter, window and ring capacity
+     * @return true if the recorder started, false if a session is already active
+     *
+     * **Example**:
+     * ```cpp
+     * traceme_recorder::start_flight_recorder({});
+     * ...
+     * if (latency > sla)
+     * {
+     *     auto events = traceme_recorder::snapshot();
+     *     convert_complete_events_to_xplane(0, std::move(events), space.add_planes());
+     *     export_to_chrome_trace_json_file(space, "slow_request.json");
+     * }
+     * ```
+     */
+    QUARISMA_API static bool start_flight_recorder(const FlightRecorderOptions& options);
+
+    /**
+     * @brief Returns the events of the last `window` without stopping the flight recorder.
+     *
+     * Complete events that ended within the window are returned, grouped by
+     * thread in the order they ended. Split activities are paired across
+     * threads; a half whose counterpart was overwritten is dropped.
+     *
+     * @return Recent events, or empty if the flight recorder is not running
+     *
+     * **Thread Safety**: Safe to call from any thread, concurrently with recording.
+     *                    Snapshots are serialized with each other.
+     * **Performance**: Copies every ring under its lock; recording threads wait at
+     *                  most for the copy of their own ring
+     */
+    QUARISMA_API static Events snapshot();
+
+    /**
+     * @brief Checks whether the flight recorder is running.
+     */
+    QUARISMA_API static bool flight_recorder_active();
+
+    /// Receives the events of drain(), one at a time
+    using EventVisitor = std::function<void(const ThreadInfo& thread, Event&& event)>;
+
+    /**
+     * @brief Hands the events recorded so far to `visitor` without stopping the session.
+     *
+     * Lets a long session be written out incrementally instead of holding every
+     * event until stop(). Events are passed as recorded: the start and end
+     * records of split activities (activity_start/activity_end) are not paired,
+     * since the end may not have happened yet; match them on activity_id().
+     *
+     * @param visitor Called for each event, on the calling thread
+     *
+     * **Thread Safety**: Recording threads are not blocked. Only one thread may
+     *                    drain at a time, and not concurrently with stop().
+     */
+    QUARISMA_API static void drain(const EventVisitor& visitor);
+
     /**
      * @brief Fast, lock-free check if tracing is active for the specified level.
      *
@@ -273,7 +365,8 @@ public:
      *
      * @param event Trace event to record (moved to avoid copying)
      *
-     * **Performance**: Very fast (~10-20 nanoseconds) - no locking or allocation
+     * **Performance**: Very fast (~10-20 nanoseconds) - no locking or allocation. In
+     *                  flight-recorder mode, an uncontended lock of the thread's ring
      * **Thread Safety**: Safe to call from any thread - uses thread-local storage
      * **Memory**: Events are stored in thread-local buffers until collection
      * **Blocking**: Never blocks - uses lock-free data structures
@@ -34,15 +34,11 @@ limitations under the License.
 
 #include "parse_annotation.h"
 
-#include <algorithm>
 #include <cctype>
-#include <stack>
-#include <string>
 #include <string_view>
-#include <utility>
 #include <vector>
 
-#include "util/exception.h"
+#include "util/small_vector.h"
 
 namespace quarisma
 {
@@ -71,74 +67,15 @@ std::string_view strip_whitespace(std::string_view str)
     return str.substr(start, end - start);
 }
 
-// Helper function to split a string by delimiter with max splits
-std::vector<std::string_view> split_string(
-    std::string_view str, char delimiter, size_t max_splits = 0)
-{
-    std::vector<std::string_view> result;
-    size_t                        start  = 0;
-    size_t                        pos    = 0;
-    size_t                        splits = 0;
-
-    while ((pos = str.find(delimiter, start)) != std::string_view::npos)
-    {
-        if (max_splits > 0 && splits >= max_splits)
-        {
-            break;
-        }
-        result.push_back(str.substr(start, pos - start));
-        start = pos + 1;
-        ++splits;
-    }
-
-    // Add the remaining part
-    result.push_back(str.substr(start));
-
-    return result;
-}
-
-// Splits annotation into name and metadata parts
-std::vector<std::string_view> split_name_and_metadata(std::string_view annotation_str)
-{
-    std::vector<std::string_view> parts;
-
-    if (!has_metadata(annotation_str))
-    {
-        parts.push_back(annotation_str);
-    }
-    else
-    {
-        // Remove trailing '#'
-        annotation_str.remove_suffix(1);
-
-        // Split by '#'
-        parts = split_string(annotation_str, '#');
-
-        // Keep only first two parts (name and metadata)
-        if (parts.size() > 2)
-        {
-            parts.resize(2);
-        }
-    }
-
-    // Ensure we have at least 2 parts (name and metadata)
-    while (parts.size() < 2)
-    {
-        parts.emplace_back();
-    }
-
-    return parts;
-}
-
 // Use comma as separator to split input metadata. However, treat comma inside
-// ""/''/[]/{}/() pairs as normal characters.
-std::vector<std::string_view> split_pairs(std::string_view metadata)
+// ""/''/[]/{}/() pairs as normal characters. Returns the end of the pair
+// starting at start.
+size_t find_pair_end(std::string_view metadata, size_t start)
 {
-    std::vector<std::string_view> key_value_pairs;
-    std::stack<char>              quotes;
-    size_t                        start = 0;
-    size_t                        end   = 0;
+    // Nesting rarely goes more than a few levels deep
+    small_vector<char, 16> quotes;
 
+    size_t end = start;
     for (; end < metadata.size(); ++end)
     {
         char const ch = metadata[end];
@@ -146,46 +83,42 @@ std::vector<std::string_view> split_pairs(std::string_view metadata)
         {
         case '\"':
         case '\'':
-            if (quotes.empty() || quotes.top() != ch)
+            if (quotes.empty() || quotes.back() != ch)
             {
-                quotes.push(ch);
+                quotes.push_back(ch);
             }
             else
             {
-                quotes.pop();
+                quotes.pop_back();
             }
             break;
         case '{':
         case '(':
         case '[':
-            quotes.push(ch);
+            quotes.push_back(ch);
             break;
         case '}':
-            if (!quotes.empty() && quotes.top() == '{')
+            if (!quotes.empty() && quotes.back() == '{')
             {
-                quotes.pop();
+                quotes.pop_back();
             }
             break;
         case ')':
-            if (!quotes.empty() && quotes.top() == '(')
+            if (!quotes.empty() && quotes.back() == '(')
             {
-                quotes.pop();
+                quotes.pop_back();
             }
             break;
         case ']':
-            if (!quotes.empty() && quotes.top() == '[')
+            if (!quotes.empty() && quotes.back() == '[')
             {
-                quotes.pop();
+                quotes.pop_back();
             }
             break;
         case ',':
             if (quotes.empty())
             {
-                if (end - start > 1)
-                {
-                    key_value_pairs.emplace_back(metadata.data() + start, end - start);
-                }
-                start = end + 1;  // Skip the current ','.
+                return end;
             }
             break;
         default:
@@ -194,52 +127,66 @@ std::vector<std::string_view> split_pairs(std::string_view metadata)
             break;
         }
     }
+    return end;
+}
+
+}  // namespace
 
-    if (end - start > 1)
+annotation_parser::annotation_parser(std::string_view annotation_str)
+{
+    std::string_view name = annotation_str;
+    if (has_metadata(annotation_str))
     {
-        key_value_pairs.emplace_back(metadata.data() + start, end - start);
+        // "<name>#<metadata>#": anything after a second '#' is ignored
+        annotation_str.remove_suffix(1);
+        size_t const name_end = annotation_str.find('#');
+        name                  = annotation_str.substr(0, name_end);
+        if (name_end != std::string_view::npos)
+        {
+            std::string_view const rest = annotation_str.substr(name_end + 1);
+            metadata_                   = rest.substr(0, rest.find('#'));
+        }
     }
-
-    return key_value_pairs;
+    name_ = strip_whitespace(name);
 }
 
-// Parses metadata string into key-value pairs
-std::vector<std::pair<std::string_view, std::string_view>> parse_metadata(std::string_view metadata)
+bool annotation_parser::next(annotation::metadata_entry& entry)
 {
-    std::vector<std::pair<std::string_view, std::string_view>> key_values;
-
-    for (std::string_view const pair : split_pairs(metadata))
+    while (position_ < metadata_.size())
     {
-        std::vector<std::string_view> parts = split_string(pair, '=', 1);
+        size_t const           start = position_;
+        size_t const           end   = find_pair_end(metadata_, start);
+        std::string_view const pair  = metadata_.substr(start, end - start);
+        position_                    = end + 1;  // Skip the current ','.
 
-        if (parts.size() == 2)
+        size_t const equals = pair.find('=');
+        if (pair.size() <= 1 || equals == std::string_view::npos)
         {
-            std::string_view const key   = strip_whitespace(parts[0]);
-            std::string_view const value = strip_whitespace(parts[1]);
+            continue;
+        }
 
-            if (!key.empty() && !value.empty())
-            {
-                key_values.emplace_back(key, value);
-            }
+        std::string_view const key   = strip_whitespace(pair.substr(0, equals));
+        std::string_view const value = strip_whitespace(pair.substr(equals + 1));
+        if (!key.empty() && !value.empty())
+        {
+            entry.key   = key;
+            entry.value = value;
+            return true;
         }
     }
-
-    return key_values;
+    return false;
 }
 
-}  // namespace
-
 annotation parse_annotation(std::string_view annotation_str)
 {
-    annotation                    result;
-    std::vector<std::string_view> parts = split_name_and_metadata(annotation_str);
+    annotation_parser parser(annotation_str);
+    annotation        result;
+    result.name = parser.name();
 
-    // parts is guaranteed to have at least 2 elements from split_name_and_metadata
-    result.name = strip_whitespace(parts[0]);
-
-    for (const auto& key_value : parse_metadata(parts[1]))
+    annotation::metadata_entry entry;
+    while (parser.next(entry))
     {
-        result.metadata.push_back({key_value.first, key_value.second});
+        result.metadata.push_back(entry);
     }
 
     return result;
@@ -248,29 +195,10 @@ annotation parse_annotation(std::string_view annotation_str)
 std::vector<annotation> parse_annotation_stack(std::string_view annotation_stack)
 {
     std::vector<annotation> annotations;
-    const std::string       kAnnotationDelimiter = "::";
-
-    // Split by "::" delimiter
-    size_t start = 0;
-    size_t pos   = 0;
-
-    while ((pos = annotation_stack.find(kAnnotationDelimiter, start)) != std::string_view::npos)
-    {
-        std::string_view const part = annotation_stack.substr(start, pos - start);
-        if (!part.empty())
-        {
-            annotations.emplace_back(parse_annotation(part));
-        }
-        start = pos + kAnnotationDelimiter.length();
-    }
-
-    // Add the last part
-    std::string_view const last_part = annotation_stack.substr(start);
-    if (!last_part.empty())
-    {
-        annotations.emplace_back(parse_annotation(last_part));
-    }
-
+    for_each_annotation(
+        annotation_stack,
+        [&annotations](std::string_view part)
+        { annotations.emplace_back(parse_annotation(part)); });
     return annotations;
 }
 
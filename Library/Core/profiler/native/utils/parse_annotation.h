@@ -76,6 +76,48 @@ struct annotation
  */
 QUARISMA_API annotation parse_annotation(std::string_view annotation_str);
 
+/**
+ * @brief Reads an annotation string without allocating.
+ *
+ * Yields what parse_annotation() returns, as views into annotation_str: the
+ * name up front, then the metadata entries one at a time. Use it where
+ * annotations are parsed once per event, e.g. when converting traces.
+ *
+ * Example:
+ * @code
+ * annotation_parser parser(event_name);
+ * annotation::metadata_entry entry;
+ * while (parser.next(entry))
+ *     add_stat(parser.name(), entry.key, entry.value);
+ * @endcode
+ */
+class QUARISMA_VISIBILITY annotation_parser
+{
+public:
+    /**
+     * @brief Starts reading annotation_str, which must outlive the parser.
+     */
+    QUARISMA_API explicit annotation_parser(std::string_view annotation_str);
+
+    /**
+     * @brief Name of the annotation, with surrounding whitespace stripped.
+     */
+    std::string_view name() const { return name_; }
+
+    /**
+     * @brief Reads the next metadata entry.
+     *
+     * @param entry Receives the key and value of the entry
+     * @return false once every entry has been read
+     */
+    QUARISMA_API bool next(annotation::metadata_entry& entry);
+
+private:
+    std::string_view name_;
+    std::string_view metadata_;
+    size_t           position_ = 0;
+};
+
 /**
  * @brief Checks if an annotation string contains metadata.
  *
@@ -100,6 +142,33 @@ inline bool has_metadata(std::string_view annotation_str)
  */
 QUARISMA_API std::vector<annotation> parse_annotation_stack(std::string_view annotation_stack);
 
+/**
+ * @brief Calls f(std::string_view) on each non-empty annotation of a stack.
+ *
+ * The zero-allocation counterpart of parse_annotation_stack(): pass each
+ * annotation to annotation_parser to read it.
+ */
+template <typename F>
+void for_each_annotation(std::string_view annotation_stack, F&& f)
+{
+    constexpr std::string_view kAnnotationDelimiter = "::";
+
+    size_t start = 0;
+    while (start <= annotation_stack.size())
+    {
+        size_t end = annotation_stack.find(kAnnotationDelimiter, start);
+        if (end == std::string_view::npos)
+        {
+            end = annotation_stack.size();
+        }
+        if (end > start)
+        {
+            f(annotation_stack.substr(start, end - start));
+        }
+        start = end + kAnnotationDelimiter.size();
+    }
+}
+
 }  // namespace profiler
 }  // namespace quarisma
 
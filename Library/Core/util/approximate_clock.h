@@ -86,6 +86,11 @@ inline auto getApproximateTime()
 {
 #if defined(QUARISMA_RDTSC)
     return static_cast<uint64_t>(__rdtsc());
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    // Generic timer virtual count, the arm64 counterpart of the TSC
+    uint64_t ticks = 0;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
 #else
     return getTime();
 #endif
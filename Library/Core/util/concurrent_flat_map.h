@@ -0,0 +1,321 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+
+#include "common/macros.h"
+#include "util/exception.h"
+#include "util/flat_hash.h"
+
+namespace quarisma
+{
+
+/**
+ * @brief Hash map striped over independently locked quarisma_map shards
+ *
+ * Meant for maps shared by many threads where each operation touches one key,
+ * such as the allocation tables of the memory trackers: two threads only
+ * contend when their keys fall in the same shard. Each shard is a quarisma_map
+ * behind a std::shared_mutex, so lookups through cvisit() run concurrently.
+ *
+ * There are no iterators, since they would outlive the shard lock. Elements
+ * are reached with callbacks invoked under the lock of their shard:
+ * - visit(key, f) calls f(V&) under the exclusive lock;
+ * - cvisit(key, f) calls f(const V&) under the shared lock;
+ * - visit_all() and cvisit_all() call f(const K&, V&) for every element,
+ *   locking one shard at a time, so they do not see a single snapshot.
+ * Callbacks must not call back into the same map.
+ *
+ * The shard of a key is taken from the high bits of its mixed hash, leaving
+ * the low bits, which quarisma_map indexes with, spread inside every shard.
+ */
+template <typename K, typename V, typename H = std::hash<K>>
+class concurrent_flat_map
+{
+public:
+    using key_type    = K;
+    using mapped_type = V;
+    using hasher      = H;
+    using map_type    = quarisma_map<K, V, H>;
+
+    /// Enough shards to keep 64 threads on distinct keys mostly apart
+    static constexpr std::size_t default_shard_count = 64;
+
+    /**
+     * @param shard_count number of shards, rounded up to a power of two
+     */
+    explicit concurrent_flat_map(
+        std::size_t shard_count = default_shard_count, const H& hash = H())
+        : hash_(hash)
+    {
+        QUARISMA_CHECK(shard_count > 0, "concurrent_flat_map needs at least one shard");
+        while ((std::size_t{1} << shard_bits_) < shard_count)
+        {
+            ++shard_bits_;
+        }
+        shards_ = std::make_unique<shard[]>(std::size_t{1} << shard_bits_);
+    }
+
+    QUARISMA_DELETE_COPY_AND_MOVE(concurrent_flat_map);
+
+    ~concurrent_flat_map() = default;
+
+    /**
+     * @brief Insert V(args...) under key unless the key is present
+     * @return true if the element was inserted
+     */
+    template <typename... Args>
+    bool try_emplace(const K& key, Args&&... args)
+    {
+        shard&           s = shard_for(key);
+        write_lock const lock(s.mutex_);
+        if (s.map_.find(key) != s.map_.end())
+        {
+            return false;
+        }
+        s.map_.emplace(key, V(std::forward<Args>(args)...));
+        return true;
+    }
+
+    /**
+     * @brief Insert or overwrite the value of key
+     * @return true if the element was inserted, false if it was assigned
+     */
+    template <typename M>
+    bool insert_or_assign(const K& key, M&& value)
+    {
+        shard&           s = shard_for(key);
+        write_lock const lock(s.mutex_);
+        auto             it = s.map_.find(key);
+        if (it != s.map_.end())
+        {
+            it->second = std::forward<M>(value);
+            return false;
+        }
+        s.map_.emplace(key, std::forward<M>(value));
+        return true;
+    }
+
+    /**
+     * @brief Insert V(args...) if key is absent, then call f(V&) on its value
+     *
+     * The insertion and the call happen under the same exclusive lock.
+     * @return true if the element was inserted
+     */
+    template <typename F, typename... Args>
+    bool emplace_or_visit(const K& key, F&& f, Args&&... args)
+    {
+        shard&           s = shard_for(key);
+        write_lock const lock(s.mutex_);
+        auto             it       = s.map_.find(key);
+        bool             inserted = false;
+        if (it == s.map_.end())
+        {
+            it       = s.map_.emplace(key, V(std::forward<Args>(args)...)).first;
+            inserted = true;
+        }
+        std::forward<F>(f)(it->second);
+        return inserted;
+    }
+
+    /**
+     * @brief Call f(V&) on the value of key under the exclusive lock
+     * @return false if the key is absent
+     */
+    template <typename F>
+    bool visit(const K& key, F&& f)
+    {
+        shard&           s = shard_for(key);
+        write_lock const lock(s.mutex_);
+        auto             it = s.map_.find(key);
+        if (it == s.map_.end())
+        {
+            return false;
+        }
+        std::forward<F>(f)(it->second);
+        return true;
+    }
+
+    /**
+     * @brief Call f(const V&) on the value of key under the shared lock
+     * @return false if the key is absent
+     */
+    template <typename F>
+    bool cvisit(const K& key, F&& f) const
+    {
+        const shard&    s = shard_for(key);
+        read_lock const lock(s.mutex_);
+        auto            it = s.map_.find(key);
+        if (it == s.map_.end())
+        {
+            return false;
+        }
+        std::forward<F>(f)(std::as_const(it->second));
+        return true;
+    }
+
+    bool contains(const K& key) const
+    {
+        const shard&    s = shard_for(key);
+        read_lock const lock(s.mutex_);
+        return s.map_.find(key) != s.map_.end();
+    }
+
+    /**
+     * @brief Remove key and return its value, or nullopt if absent
+     */
+    std::optional<V> extract(const K& key)
+    {
+        shard&           s = shard_for(key);
+        write_lock const lock(s.mutex_);
+        auto             it = s.map_.find(key);
+        if (it == s.map_.end())
+        {
+            return std::nullopt;
+        }
+        std::optional<V> value(std::move(it->second));
+        s.map_.erase(it);
+        return value;
+    }
+
+    /**
+     * @return number of elements removed, 0 or 1
+     */
+    std::size_t erase(const K& key)
+    {
+        shard&           s = shard_for(key);
+        write_lock const lock(s.mutex_);
+        return s.map_.erase(key);
+    }
+
+    /**
+     * @brief Call f(const K&, V&) on every element, one shard at a time
+     */
+    template <typename F>
+    void visit_all(F&& f)
+    {
+        for (std::size_t i = 0, n = shard_count(); i < n; ++i)
+        {
+            write_lock const lock(shards_[i].mutex_);
+            for (auto& entry : shards_[i].map_)
+            {
+                f(std::as_const(entry.first), entry.second);
+            }
+        }
+    }
+
+    /**
+     * @brief Call f(const K&, const V&) on every element, one shard at a time
+     */
+    template <typename F>
+    void cvisit_all(F&& f) const
+    {
+        for (std::size_t i = 0, n = shard_count(); i < n; ++i)
+        {
+            read_lock const lock(shards_[i].mutex_);
+            for (const auto& entry : shards_[i].map_)
+            {
+                f(entry.first, entry.second);
+            }
+        }
+    }
+
+    /**
+     * @brief Number of elements, summed over the shards one at a time
+     */
+    std::size_t size() const
+    {
+        std::size_t total = 0;
+        for (std::size_t i = 0, n = shard_count(); i < n; ++i)
+        {
+            read_lock const lock(shards_[i].mutex_);
+            total += shards_[i].map_.size();
+        }
+        return total;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    void clear()
+    {
+        for (std::size_t i = 0, n = shard_count(); i < n; ++i)
+        {
+            write_lock const lock(shards_[i].mutex_);
+            shards_[i].map_.clear();
+        }
+    }
+
+    /**
+     * @brief Reserve room for n elements spread evenly over the shards
+     */
+    void reserve(std::size_t n)
+    {
+        std::size_t const per_shard = (n + shard_count() - 1) / shard_count();
+        for (std::size_t i = 0, count = shard_count(); i < count; ++i)
+        {
+            write_lock const lock(shards_[i].mutex_);
+            shards_[i].map_.reserve(per_shard);
+        }
+    }
+
+    std::size_t shard_count() const noexcept { return std::size_t{1} << shard_bits_; }
+
+    /**
+     * @brief Shard holding key, exposed for tests
+     */
+    std::size_t shard_index(const K& key) const noexcept
+    {
+        if (shard_bits_ == 0)
+        {
+            return 0;
+        }
+        auto const mixed =
+            static_cast<std::uint64_t>(hash_(key)) * UINT64_C(0x9E3779B97F4A7C15);
+        return static_cast<std::size_t>(mixed >> (64 - shard_bits_));
+    }
+
+private:
+    using read_lock  = std::shared_lock<std::shared_mutex>;
+    using write_lock = std::unique_lock<std::shared_mutex>;
+
+    struct alignas(64) shard
+    {
+        mutable std::shared_mutex mutex_;
+        map_type                  map_;
+    };
+
+    shard& shard_for(const K& key) noexcept { return shards_[shard_index(key)]; }
+
+    const shard& shard_for(const K& key) const noexcept { return shards_[shard_index(key)]; }
+
+    H                        hash_;
+    unsigned                 shard_bits_ = 0;
+    std::unique_ptr<shard[]> shards_;
+};
+
+}  // namespace quarisma
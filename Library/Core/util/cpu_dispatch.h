@@ -0,0 +1,155 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "common/export.h"
+#include "util/cpu_info.h"
+
+/**
+ * @file cpu_dispatch.h
+ * @brief Kernels built for several instruction sets, selected at run time
+ *
+ * QUARISMA_VECTORIZATION_TYPE fixes one instruction set for the whole
+ * library, so a binary shipped to a mixed fleet has to target its oldest
+ * machines. A dispatched kernel is instead compiled once per cpu_capability,
+ * and the first call picks the best one this CPU supports.
+ *
+ * A kernel file lives in the cpu/ directory of its library and is added with
+ * quarisma_add_dispatch_sources(), which compiles it once as is and, when
+ * QUARISMA_ENABLE_CPU_DISPATCH is on, once more per capability with
+ * QUARISMA_CPU_CAPABILITY (and QUARISMA_CPU_CAPABILITY_AVX2 or _AVX512)
+ * defined and the matching compiler flags. Everything a kernel file defines,
+ * other than its registrations, goes in an anonymous namespace: the copies
+ * are compiled with different flags and must not be merged.
+ *
+ * @code
+ * // scan.h
+ * using scan_fn = size_t (*)(const char* data, size_t size);
+ * QUARISMA_DECLARE_DISPATCH(scan_fn, scan_stub);
+ *
+ * // scan.cpp
+ * QUARISMA_DEFINE_DISPATCH(scan_stub);
+ *
+ * // cpu/scan_kernel.cpp
+ * namespace { size_t scan_kernel(const char* data, size_t size) { ... } }
+ * QUARISMA_REGISTER_DISPATCH(scan_stub, &scan_kernel);
+ *
+ * // caller
+ * size_t const n = scan_stub(data, size);
+ * @endcode
+ */
+
+#if !defined(QUARISMA_CPU_CAPABILITY)
+#define QUARISMA_CPU_CAPABILITY DEFAULT
+#define QUARISMA_CPU_CAPABILITY_DEFAULT
+#endif
+
+namespace quarisma
+{
+
+/**
+ * @brief Function pointer selected from the kernels registered for each capability
+ *
+ * Derived, declared by QUARISMA_DECLARE_DISPATCH, holds one static pointer
+ * per capability. The selection is made on the first call and cached; stubs
+ * are constant-initialized, so they can be called during static initialization.
+ */
+template <typename FnPtr, typename Derived>
+class dispatch_stub
+{
+public:
+    constexpr dispatch_stub() noexcept = default;
+
+    template <typename... Args>
+    decltype(auto) operator()(Args&&... args) const
+    {
+        return selected()(std::forward<Args>(args)...);
+    }
+
+    /** The kernel used by operator(). */
+    FnPtr selected() const noexcept
+    {
+        FnPtr fn = fn_.load(std::memory_order_acquire);
+        if (fn == nullptr)
+        {
+            fn = kernel(cpu_info::capability());
+            fn_.store(fn, std::memory_order_release);
+        }
+        return fn;
+    }
+
+    /**
+     * @brief The kernel for capability, or for the highest one below it that has one
+     *
+     * The caller must make sure the CPU supports capability.
+     */
+    static FnPtr kernel(cpu_capability capability) noexcept
+    {
+#if QUARISMA_HAS_CPU_DISPATCH
+        if (capability >= cpu_capability::AVX512 && Derived::AVX512 != nullptr)
+        {
+            return Derived::AVX512;
+        }
+        if (capability >= cpu_capability::AVX2 && Derived::AVX2 != nullptr)
+        {
+            return Derived::AVX2;
+        }
+#else
+        (void)capability;
+#endif
+        return Derived::DEFAULT;
+    }
+
+private:
+    mutable std::atomic<FnPtr> fn_{nullptr};
+};
+
+}  // namespace quarisma
+
+#if QUARISMA_HAS_CPU_DISPATCH
+#define QUARISMA_DISPATCH_CAPABILITY_MEMBERS(fn_type) \
+    static QUARISMA_API fn_type AVX2;                 \
+    static QUARISMA_API fn_type AVX512;
+#else
+#define QUARISMA_DISPATCH_CAPABILITY_MEMBERS(fn_type)
+#endif
+
+/** Declares the stub name, of function pointer type fn; goes in a header. */
+#define QUARISMA_DECLARE_DISPATCH(fn, name)                                  \
+    struct name##_type : ::quarisma::dispatch_stub<fn, name##_type>          \
+    {                                                                        \
+        using fn_type = fn;                                                  \
+        static QUARISMA_API fn_type DEFAULT;                                 \
+        QUARISMA_DISPATCH_CAPABILITY_MEMBERS(fn_type)                        \
+    };                                                                       \
+    extern QUARISMA_API name##_type name
+
+/** Defines the stub name; goes in exactly one source file outside cpu/. */
+#define QUARISMA_DEFINE_DISPATCH(name) name##_type name
+
+/**
+ * Registers fn as the kernel of name for the capability this file is being
+ * compiled for; goes in the kernel file, in the namespace of the stub.
+ */
+#define QUARISMA_REGISTER_DISPATCH(name, fn) \
+    name##_type::fn_type name##_type::QUARISMA_CPU_CAPABILITY = fn
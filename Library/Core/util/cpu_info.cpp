@@ -4,14 +4,77 @@
 #include <fmt/core.h>
 
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "util/cpu_topology.h"
+#include "util/startup_tracer.h"
 
 namespace quarisma
 {
-bool cpu_info::initialize()
+namespace
+{
+bool traced_cpuinfo_initialize()
 {
+    const startup_tracer::scope traced("cpuinfo_initialize");
     return cpuinfo_initialize();
 }
 
+cpu_capability detect_capability()
+{
+    if (!traced_cpuinfo_initialize())
+    {
+        return cpu_capability::DEFAULT;
+    }
+
+    // cpuinfo also checks that the OS saves the wider registers
+    auto hardware = cpu_capability::DEFAULT;
+    if (cpuinfo_has_x86_avx512f() && cpuinfo_has_x86_avx512bw() && cpuinfo_has_x86_avx512dq() &&
+        cpuinfo_has_x86_avx512vl())
+    {
+        hardware = cpu_capability::AVX512;
+    }
+    else if (cpuinfo_has_x86_avx2() && cpuinfo_has_x86_fma3())
+    {
+        hardware = cpu_capability::AVX2;
+    }
+
+    const char* const requested = std::getenv("QUARISMA_CPU_CAPABILITY");
+    if (requested == nullptr)
+    {
+        return hardware;
+    }
+    auto limit = hardware;
+    if (std::strcmp(requested, "default") == 0)
+    {
+        limit = cpu_capability::DEFAULT;
+    }
+    else if (std::strcmp(requested, "avx2") == 0)
+    {
+        limit = cpu_capability::AVX2;
+    }
+    return limit < hardware ? limit : hardware;
+}
+}  // namespace
+
+const char* to_string(cpu_capability capability) noexcept
+{
+    switch (capability)
+    {
+    case cpu_capability::AVX2:
+        return "avx2";
+    case cpu_capability::AVX512:
+        return "avx512";
+    default:
+        return "default";
+    }
+}
+
+bool cpu_info::initialize()
+{
+    return traced_cpuinfo_initialize();
+}
+
 int cpu_info::number_of_cores()
 {
     return cpuinfo_get_cores_count();
@@ -40,6 +103,7 @@ void cpu_info::info()
     fmt::print("-- support avx2:     {}\n", cpuinfo_has_x86_avx2() ? "True" : "False");
     fmt::print("-- support axv512:   {}\n", cpuinfo_has_x86_avx512f() ? "True" : "False");
     fmt::print("-- support arm neon: {}\n", cpuinfo_has_arm_neon() ? "True" : "False");
+    fmt::print("-- dispatching to:   {}\n", to_string(capability()));
 
     fmt::print("-- size of double {}\n", static_cast<int>(sizeof(double)));
     fmt::print("-- size of float {}\n", static_cast<int>(sizeof(float)));
@@ -129,18 +193,20 @@ void cpu_info::info()
 #endif  // QUARISMA_HAS_MKL
 }
 
+cpu_capability cpu_info::capability()
+{
+    static cpu_capability const detected = detect_capability();
+    return detected;
+}
+
 void cpu_info::cpuinfo_cach(
     std::ptrdiff_t& l1, std::ptrdiff_t& l2, std::ptrdiff_t& l3, std::ptrdiff_t& l3_count)
 {
-    const struct cpuinfo_cache* l1d_cache = cpuinfo_get_l1d_caches();
-    const struct cpuinfo_cache* l2_cache  = cpuinfo_get_l2_caches();
-    const struct cpuinfo_cache* l3_cache  = cpuinfo_get_l3_caches();
+    cpu_topology const& topology = cpu_topology::instance();
 
-    l1       = (l1d_cache != nullptr) ? l1d_cache->size : 0;
-    l2       = (l2_cache != nullptr) ? l2_cache->size : 0;
-    l3       = (l3_cache != nullptr) ? l3_cache->size : 0;
-    l3_count = (l3_cache != nullptr) ? l3_cache->processor_count : 0;
-
-    cpuinfo_deinitialize();
+    l1       = static_cast<std::ptrdiff_t>(topology.l1d().size);
+    l2       = static_cast<std::ptrdiff_t>(topology.l2().size);
+    l3       = static_cast<std::ptrdiff_t>(topology.l3().size);
+    l3_count = topology.l3().size != 0 ? topology.l3().processors : 0;
 }
 };  // namespace quarisma
@@ -4,6 +4,20 @@
 
 namespace quarisma
 {
+/**
+ * @brief Instruction sets that dispatched kernels are built for, in increasing order
+ *
+ * AVX2 includes FMA; AVX512 is the F, BW, DQ and VL subsets.
+ */
+enum class cpu_capability : int
+{
+    DEFAULT = 0,
+    AVX2    = 1,
+    AVX512  = 2,
+};
+
+QUARISMA_API const char* to_string(cpu_capability capability) noexcept;
+
 class QUARISMA_VISIBILITY cpu_info
 {
     QUARISMA_DELETE_CLASS(cpu_info);
@@ -17,6 +31,20 @@ public:
 
     QUARISMA_API static void info();
 
+    /**
+     * @brief Highest cpu_capability of this CPU, detected once
+     *
+     * The QUARISMA_CPU_CAPABILITY environment variable (default, avx2 or
+     * avx512) lowers it, e.g. to compare kernels or work around a faulty one;
+     * it never raises it above what the CPU supports.
+     */
+    QUARISMA_API static cpu_capability capability();
+
+    /**
+     * @brief L1d, L2 and L3 sizes in bytes and the processors sharing an L3
+     *
+     * Read from cpu_topology, which has the rest of the cache hierarchy.
+     */
     QUARISMA_API static void cpuinfo_cach(
         std::ptrdiff_t& l1, std::ptrdiff_t& l2, std::ptrdiff_t& l3, std::ptrdiff_t& l3_count);
 };
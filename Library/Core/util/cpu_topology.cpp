@@ -0,0 +1,118 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "util/cpu_topology.h"
+
+#include <cpuinfo.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+#include "memory/numa.h"
+#include "util/startup_tracer.h"
+
+namespace quarisma
+{
+namespace
+{
+cpu_cache cache_of(const struct cpuinfo_cache* cache)
+{
+    cpu_cache result;
+    if (cache != nullptr)
+    {
+        result.size          = cache->size;
+        result.line_size     = cache->line_size != 0 ? cache->line_size : result.line_size;
+        result.associativity = static_cast<int>(cache->associativity);
+        result.processors    = std::max(static_cast<int>(cache->processor_count), 1);
+    }
+    return result;
+}
+}  // namespace
+
+const cpu_topology& cpu_topology::instance()
+{
+    static cpu_topology const topology;
+    return topology;
+}
+
+cpu_topology::cpu_topology()
+{
+    {
+        const startup_tracer::scope traced("cpuinfo_initialize");
+        detected_ = cpuinfo_initialize() && cpuinfo_get_processors_count() > 0;
+    }
+    if (detected_)
+    {
+        packages_ = std::max(static_cast<int>(cpuinfo_get_packages_count()), 1);
+        cores_    = std::max(static_cast<int>(cpuinfo_get_cores_count()), 1);
+        l1d_      = cache_of(cpuinfo_get_l1d_cache(0));
+        l2_       = cache_of(cpuinfo_get_l2_cache(0));
+        l3_       = cache_of(cpuinfo_get_l3_cache(0));
+
+        uint32_t const count = cpuinfo_get_processors_count();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const struct cpuinfo_processor* p = cpuinfo_get_processor(i);
+#if defined(__linux__)
+            int const id = p->linux_id;
+#else
+            int const id = static_cast<int>(i);
+#endif
+            if (id < 0)
+            {
+                continue;
+            }
+            if (static_cast<size_t>(id) >= processors_.size())
+            {
+                processors_.resize(static_cast<size_t>(id) + 1);
+            }
+            cpu_processor& processor = processors_[static_cast<size_t>(id)];
+            processor.core    = static_cast<int>(p->core - cpuinfo_get_cores());
+            processor.package = static_cast<int>(p->package - cpuinfo_get_packages());
+            processor.smt     = static_cast<int>(i - p->core->processor_start);
+        }
+    }
+    else
+    {
+        unsigned const count = std::max(std::thread::hardware_concurrency(), 1U);
+        cores_               = static_cast<int>(count);
+        l1d_.size            = size_t{32} << 10;
+        l2_.size             = size_t{256} << 10;
+        processors_.resize(count);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            processors_[i].core = static_cast<int>(i);
+        }
+    }
+
+    // Keeps threads_per_core() at 1 or more should cpuinfo miss processors
+    if (processors_.empty())
+    {
+        processors_.resize(1);
+    }
+    cores_ = std::min(cores_, processors());
+
+    numa_nodes_ = std::max(GetNumNUMANodes(), 1);
+    for (int id = 0; id < processors(); ++id)
+    {
+        processors_[static_cast<size_t>(id)].numa_node = std::max(GetNUMANodeOfCPU(id), 0);
+    }
+}
+}  // namespace quarisma
@@ -0,0 +1,117 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace quarisma
+{
+/**
+ * @brief One level of the cache hierarchy, as seen by a single core
+ *
+ * size is 0 when the level is absent.
+ */
+struct cpu_cache
+{
+    size_t size          = 0;
+    size_t line_size     = 64;
+    int    associativity = 0;
+    int    processors    = 1;  ///< Logical processors sharing one instance
+};
+
+/**
+ * @brief Placement of one logical processor
+ *
+ * smt is the rank of the processor among the SMT siblings of its core, so
+ * that the processors of rank 0 cover every core once.
+ */
+struct cpu_processor
+{
+    int core      = 0;
+    int package   = 0;
+    int smt       = 0;
+    int numa_node = 0;
+};
+
+/**
+ * @brief Processors, caches and NUMA nodes of the machine, detected once
+ *
+ * Taken from cpuinfo and memory/numa.h on first use and never refreshed, so
+ * hot paths may query it freely; those that run per call should still cache
+ * what they derive from it. When cpuinfo cannot read the machine, every
+ * processor counts as one core of one package, and the caches take typical
+ * sizes (32 KiB L1d, 256 KiB L2, no L3) so that block sizes stay sensible.
+ *
+ * Processors are indexed by operating system id, the ids of sched_setaffinity
+ * and numa_node_of_cpu.
+ */
+class QUARISMA_VISIBILITY cpu_topology
+{
+public:
+    QUARISMA_API static const cpu_topology& instance();
+
+    /** False when the fallback values above are in use. */
+    bool detected() const noexcept { return detected_; }
+
+    int packages() const noexcept { return packages_; }
+    int cores() const noexcept { return cores_; }
+    int processors() const noexcept { return static_cast<int>(processors_.size()); }
+    int cores_per_package() const noexcept { return cores_ / packages_; }
+
+    /** SMT siblings of a core, 1 without SMT. */
+    int threads_per_core() const noexcept { return processors() / cores_; }
+
+    const cpu_cache& l1d() const noexcept { return l1d_; }
+    const cpu_cache& l2() const noexcept { return l2_; }
+    const cpu_cache& l3() const noexcept { return l3_; }
+
+    /** Bytes of cache one core can count on: its share of the cores using it. */
+    size_t cache_per_core(const cpu_cache& cache) const noexcept
+    {
+        int const sharing_cores = cache.processors / threads_per_core();
+        return cache.size / static_cast<size_t>(sharing_cores > 1 ? sharing_cores : 1);
+    }
+
+    /** At least 1, also without NUMA support. */
+    int numa_nodes() const noexcept { return numa_nodes_; }
+
+    /** Placement of processor id; a default cpu_processor for unknown ids. */
+    cpu_processor processor(int id) const noexcept
+    {
+        return id >= 0 && id < processors() ? processors_[static_cast<size_t>(id)]
+                                            : cpu_processor{};
+    }
+
+private:
+    cpu_topology();
+
+    bool                       detected_   = false;
+    int                        packages_   = 1;
+    int                        cores_      = 1;
+    int                        numa_nodes_ = 1;
+    cpu_cache                  l1d_;
+    cpu_cache                  l2_;
+    cpu_cache                  l3_;
+    std::vector<cpu_processor> processors_;
+};
+}  // namespace quarisma
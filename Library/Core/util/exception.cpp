@@ -2,11 +2,11 @@
 
 #include <atomic>
 #include <cstdlib>  // for getenv
-#include <functional>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include "logging/back_trace.h"
 #include "logging/logger.h"
@@ -33,15 +33,22 @@ std::atomic<exception_mode> g_exception_mode_{
 std::atomic<bool> g_exception_mode_initialized_{false};
 std::mutex        g_exception_mode_init_mutex_;
 
-std::function<std::string(void)>* GetFetchStackTrace()  // NOLINT
+// Only the stack walk happens at the throw site; symbolization waits for backtrace()
+QUARISMA_NOINLINE std::vector<void*> capture_return_addresses()
 {
-    static std::function<std::string(void)> func = []()
-    {
-        // Skip 2 frames: this lambda and GetFetchStackTrace
-        return quarisma::back_trace::print(/*frames_to_skip=*/2, /*maximum_number_of_frames=*/32);
-    };
-    return &func;
-};
+    // Skip 2 frames: this function and the exception constructor
+    return quarisma::back_trace::capture_addresses(
+        /*frames_to_skip=*/2, /*maximum_number_of_frames=*/32);
+}
+
+std::string backtrace_header(const source_location& source_location)
+{
+    return fmt::format(
+        "Exception raised from {} at {}:{} (most recent call first):\n",
+        source_location.function,
+        source_location.file,
+        source_location.line);
+}
 }  // namespace
 
 // ============================================================================
@@ -113,14 +120,13 @@ exception::exception(
 
 //-----------------------------------------------------------------------------
 exception::exception(source_location source_location, std::string msg, exception_category category)
-    : exception(
-          std::move(msg),
-          std::string("Exception raised from ") + std::string(source_location.function) + " at " +
-              std::string(source_location.file) + ":" + std::to_string(source_location.line) +
-              " (most recent call first):\n" + (*GetFetchStackTrace())(),
-          nullptr,
-          category)
+    : msg_(std::move(msg)),
+      backtrace_(backtrace_header(source_location)),
+      return_addresses_(capture_return_addresses()),
+      caller_(nullptr),
+      category_(category)
 {
+    refresh_what();
 }
 
 //-----------------------------------------------------------------------------
@@ -130,10 +136,8 @@ exception::exception(
     std::shared_ptr<exception> nested,
     exception_category         category)
     : msg_(std::move(msg)),
-      backtrace_(
-          std::string("Exception raised from ") + std::string(source_location.function) + " at " +
-          std::string(source_location.file) + ":" + std::to_string(source_location.line) +
-          " (most recent call first):\n" + (*GetFetchStackTrace())()),
+      backtrace_(backtrace_header(source_location)),
+      return_addresses_(capture_return_addresses()),
       caller_(nullptr),
       nested_exception_(std::move(nested)),  //NOLINT
       category_(category)
@@ -141,6 +145,29 @@ exception::exception(
     refresh_what();
 }
 
+//-----------------------------------------------------------------------------
+const std::string& exception::backtrace() const noexcept
+{
+    if (return_addresses_.empty())
+    {
+        return backtrace_;
+    }
+    return symbolized_backtrace_.ensure(
+        [this]
+        {
+            try
+            {
+                // The lookup happens here, on first use, rather than at the throw site
+                auto const frames = back_trace::symbolize(return_addresses_);
+                return backtrace_ + back_trace::format(frames);
+            }
+            catch (...)
+            {
+                return backtrace_;
+            }
+        });
+}
+
 //-----------------------------------------------------------------------------
 const char* exception::what() const noexcept
 {
@@ -182,7 +209,8 @@ std::string exception::compute_what(bool include_backtrace) const
     if (nested_exception_)
     {
         oss << "\n\nCaused by:\n";
-        oss << nested_exception_->what();
+        oss << (include_backtrace ? nested_exception_->what()
+                                  : nested_exception_->what_without_backtrace());
     }
 
     return oss.str();
@@ -192,8 +220,9 @@ std::string exception::compute_what(bool include_backtrace) const
 void exception::refresh_what()
 {
     what_.reset();
-    what_without_backtrace_ = compute_what(/*include_backtrace*/ true);
-    QUARISMA_LOG_ERROR("Error message: {}", what());
+    what_without_backtrace_ = compute_what(/*include_backtrace*/ false);
+    // Logging what() would symbolize the backtrace on every throw
+    QUARISMA_LOG_ERROR("Error message: {}", what_without_backtrace_);
 }
 
 //-----------------------------------------------------------------------------
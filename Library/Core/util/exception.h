@@ -103,8 +103,10 @@ enum class exception_category : int
  * **Thread Safety**: All methods are thread-safe except add_context()
  * which should only be called from the thread that created the exception.
  *
- * **Performance**: Stack trace capture adds ~25μs overhead. Consider
- * disabling in hot paths if needed.
+ * **Performance**: Construction only records the raw return addresses of
+ * the stack; they are symbolized the first time what() or backtrace() is
+ * called, so an exception that is caught and handled never pays for
+ * symbol lookup.
  *
  * **Naming**: Uses lowercase 'exception' following standard C++ conventions.
  * Type alias 'Error' provided for backward compatibility.
@@ -121,10 +123,16 @@ class QUARISMA_VISIBILITY exception : public std::exception
 
     // The C++ backtrace at the point when this exception was raised.  This
     // may be empty if there is no valid backtrace.  (We don't use optional
-    // here to reduce the dependencies this file has.)
+    // here to reduce the dependencies this file has.)  When return_addresses_
+    // is not empty this is only the "Exception raised from" header, and the
+    // frames are appended to it by backtrace() on first use.
     std::string backtrace_;
 
-    // These two are derived fields from msg_stack_ and backtrace_, but we need
+    // Raw return addresses captured at the throw site, symbolized lazily
+    std::vector<void*>                   return_addresses_;
+    mutable optimistic_lazy<std::string> symbolized_backtrace_;
+
+    // These two are derived fields from msg_stack_ and backtrace(), but we need
     // fields for the strings so that we can return a const char* (as the
     // signature of std::exception requires).  Currently, the invariant
     // is that these fields are ALWAYS populated consistently with respect
@@ -189,9 +197,8 @@ public:
     /// @note Inline for performance - frequently accessed in hot paths
     inline const std::vector<std::string>& context() const noexcept { return context_; }
 
-    /// Get backtrace
-    /// @note Inline for performance - frequently accessed in hot paths
-    inline const std::string& backtrace() const noexcept { return backtrace_; }
+    /// Get backtrace, symbolizing the captured frames on first call
+    QUARISMA_API const std::string& backtrace() const noexcept;
 
     /// Get error category
     /// @note Inline for performance - frequently accessed in hot paths
@@ -30,6 +30,14 @@
 #include "common/macros.h"
 #include "util/exception.h"
 
+#if QUARISMA_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+
+#if defined(QUARISMA_SWISS_TABLE)
+#include "util/swiss_table.h"
+#endif
+
 #if defined(_MSC_VER) && !defined(__clang__)
 #pragma warning(push)
 #pragma warning(disable : 4624)  // destructor was implicitly defined as deleted
@@ -727,7 +735,7 @@ public:
         swap_pointers(other);
         swap(static_cast<ArgumentHash&>(*this), static_cast<ArgumentHash&>(other));
         swap(static_cast<ArgumentEqual&>(*this), static_cast<ArgumentEqual&>(other));
-        if (AllocatorTraits::propagate_on_container_swap::value)
+        if constexpr (AllocatorTraits::propagate_on_container_swap::value)
             swap(static_cast<EntryAlloc&>(*this), static_cast<EntryAlloc&>(other));
     }
 
@@ -1735,13 +1743,38 @@ public:
     }
 };
 
+#if QUARISMA_HAS_MEMORY_RESOURCE
+namespace pmr
+{
+/// Hash containers drawing from a std::pmr::memory_resource, such as an arena
+/// or an allocator_resource over allocator_bfc or allocator_pool
+template <typename K, typename V, typename H = std::hash<K>, typename E = std::equal_to<K>>
+using flat_hash_map =
+    quarisma::flat_hash_map<K, V, H, E, std::pmr::polymorphic_allocator<std::pair<K, V>>>;
+template <typename T, typename H = std::hash<T>, typename E = std::equal_to<T>>
+using flat_hash_set = quarisma::flat_hash_set<T, H, E, std::pmr::polymorphic_allocator<T>>;
+#if defined(QUARISMA_SWISS_TABLE)
+template <typename K, typename V, typename H = std::hash<K>, typename E = std::equal_to<K>>
+using swiss_hash_map =
+    quarisma::swiss_hash_map<K, V, H, E, std::pmr::polymorphic_allocator<std::pair<K, V>>>;
+template <typename T, typename H = std::hash<T>, typename E = std::equal_to<T>>
+using swiss_hash_set = quarisma::swiss_hash_set<T, H, E, std::pmr::polymorphic_allocator<T>>;
+#endif
+}  // namespace pmr
+#endif
+
 template <typename T>
 struct power_of_two_std_hash : std::hash<T>
 {
     typedef quarisma::power_of_two_hash_policy hash_policy;
 };
 
-#if 1
+#if defined(QUARISMA_SWISS_TABLE)
+template <typename T>
+using quarisma_set = swiss_hash_set<T>;
+template <typename K, typename V, typename H = std::hash<K>>
+using quarisma_map = swiss_hash_map<K, V, H>;
+#elif 1
 template <typename T>
 using quarisma_set = flat_hash_set<T>;
 template <typename K, typename V, typename H = std::hash<K>>
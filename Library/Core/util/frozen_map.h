@@ -0,0 +1,322 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "util/exception.h"
+#include "util/flat_hash.h"
+
+namespace quarisma
+{
+namespace detail
+{
+// Murmur3's 64-bit finalizer, which derives the seeds and salts
+inline uint64_t perfect_hash_mix(uint64_t x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Maps the high half of x onto [0, n) without a division
+inline size_t perfect_hash_range(uint64_t x, size_t n) noexcept
+{
+    return static_cast<size_t>(((x >> 32) * static_cast<uint64_t>(n)) >> 32);
+}
+}  // namespace detail
+
+/**
+ * @brief Immutable hash map over a minimal perfect hash of its keys
+ *
+ * Built once from a set of entries, after which a lookup is one hash of the
+ * key, two table reads and one key comparison, whether the key is present or
+ * not: no probing, no chains.
+ *
+ * **Construction**: hash-and-displace. Keys are spread over about n / 2
+ * buckets; buckets of two or more keys, largest first, search for a
+ * displacement that sends all their keys to free slots, and single-key
+ * buckets then take the remaining slots directly. Expected O(n), with n
+ * slots for n keys. When several entries share a key the last one is kept.
+ *
+ * **Thread Safety**: Lookups are thread-safe; the map never changes after
+ * construction.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * frozen_map<std::string, int> const months({{"jan", 1}, {"feb", 2}, {"mar", 3}});
+ * const int* feb = months.find("feb");  // nullptr when absent
+ * ```
+ *
+ * @tparam Key Key type, hashable by Hash and comparable by Equal
+ * @tparam Value Mapped type
+ */
+template <
+    typename Key,
+    typename Value,
+    typename Hash  = std::hash<Key>,
+    typename Equal = std::equal_to<Key>>
+class frozen_map
+{
+public:
+    using value_type = std::pair<Key, Value>;
+
+    frozen_map() = default;
+
+    /**
+     * @brief Builds the perfect hash of entries
+     *
+     * @throws quarisma::exception if Hash maps distinct keys to the same value
+     */
+    explicit frozen_map(std::vector<value_type> entries, Hash hash = Hash(), Equal equal = Equal())
+        : hash_(std::move(hash)), equal_(std::move(equal))
+    {
+        build(std::move(entries));
+    }
+
+    size_t size() const noexcept { return slots_.size(); }
+
+    bool empty() const noexcept { return slots_.empty(); }
+
+    /** Value of key, or nullptr when absent. */
+    const Value* find(const Key& key) const
+    {
+        if (slots_.empty())
+        {
+            return nullptr;
+        }
+        value_type const& entry = slots_[slot_of(key)];
+        return equal_(entry.first, key) ? &entry.second : nullptr;
+    }
+
+    Value* find(const Key& key)
+    {
+        return const_cast<Value*>(static_cast<const frozen_map&>(*this).find(key));
+    }
+
+    bool contains(const Key& key) const { return find(key) != nullptr; }
+
+    /** Entries in slot order, which is unrelated to insertion order. */
+    auto begin() const noexcept { return slots_.begin(); }
+    auto end() const noexcept { return slots_.end(); }
+
+private:
+    // An unplaced multi-key bucket gives up on a bucket seed after this many displacements
+    static constexpr uint32_t max_displacement = 1U << 16;
+    static constexpr int      max_seeds        = 8;
+
+    // Fibonacci hashing: the high half of the product depends on every bit of the key hash
+    uint64_t hash_of(const Key& key) const
+    {
+        return (static_cast<uint64_t>(hash_(key)) ^ seed_) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    static size_t displaced_slot(uint64_t hash, int64_t salt, size_t n) noexcept
+    {
+        return detail::perfect_hash_range(
+            (hash ^ static_cast<uint64_t>(salt)) * 0xc4ceb9fe1a85ec53ULL, n);
+    }
+
+    /// Salt of displacement d, non-negative so the sign can mark single-key buckets
+    static int64_t salt_of(uint32_t d) noexcept
+    {
+        return static_cast<int64_t>(detail::perfect_hash_mix(d) >> 1);
+    }
+
+    size_t slot_of(const Key& key) const
+    {
+        uint64_t const hash   = hash_of(key);
+        size_t const   bucket = detail::perfect_hash_range(hash, displacements_.size());
+        int64_t const  salt   = displacements_[bucket];
+        // A negative entry is the slot of a single-key bucket, encoded as ~slot
+        return salt < 0 ? static_cast<size_t>(~salt) : displaced_slot(hash, salt, slots_.size());
+    }
+
+    void build(std::vector<value_type> entries)
+    {
+        // Keep the last entry of each key
+        {
+            flat_hash_map<Key, size_t, Hash, Equal> last(entries.size(), hash_, equal_);
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                last[entries[i].first] = i;
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                if (last[entries[i].first] == i)
+                {
+                    if (kept != i)
+                    {
+                        entries[kept] = std::move(entries[i]);
+                    }
+                    ++kept;
+                }
+            }
+            entries.resize(kept);
+        }
+
+        size_t const n = entries.size();
+        if (n == 0)
+        {
+            return;
+        }
+        QUARISMA_CHECK(
+            n <= std::numeric_limits<uint32_t>::max(), "frozen_map holds below 2^32 keys");
+
+        for (int attempt = 0; attempt < max_seeds; ++attempt)
+        {
+            seed_ = detail::perfect_hash_mix(static_cast<uint64_t>(attempt) + 1);
+            std::vector<size_t> order;
+            if (place(entries, order))
+            {
+                slots_.resize(n);
+                for (size_t i = 0; i < n; ++i)
+                {
+                    slots_[order[i]] = std::move(entries[i]);
+                }
+                return;
+            }
+        }
+        QUARISMA_THROW("frozen_map: no perfect hash found for {} keys; is the hash degenerate?", n);
+    }
+
+    // Assigns entry i to slot order[i] and fills displacements_; false to retry with a new seed
+    bool place(const std::vector<value_type>& entries, std::vector<size_t>& order)
+    {
+        size_t const n       = entries.size();
+        size_t const buckets = n / 2 + 1;
+
+        std::vector<uint64_t> hashes(n);
+        std::vector<size_t>   bucket_start(buckets + 1, 0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            hashes[i] = hash_of(entries[i].first);
+            ++bucket_start[detail::perfect_hash_range(hashes[i], buckets) + 1];
+        }
+        for (size_t b = 0; b < buckets; ++b)
+        {
+            bucket_start[b + 1] += bucket_start[b];
+        }
+
+        // Entries grouped by bucket
+        std::vector<size_t> members(n);
+        {
+            std::vector<size_t> cursor(bucket_start.begin(), bucket_start.end() - 1);
+            for (size_t i = 0; i < n; ++i)
+            {
+                members[cursor[detail::perfect_hash_range(hashes[i], buckets)]++] = i;
+            }
+        }
+
+        std::vector<size_t> by_size(buckets);
+        for (size_t b = 0; b < buckets; ++b)
+        {
+            by_size[b] = b;
+        }
+        std::stable_sort(
+            by_size.begin(),
+            by_size.end(),
+            [&](size_t x, size_t y)
+            {
+                return bucket_start[x + 1] - bucket_start[x] >
+                       bucket_start[y + 1] - bucket_start[y];
+            });
+
+        displacements_.assign(buckets, 0);
+        order.assign(n, 0);
+        std::vector<bool>   taken(n, false);
+        std::vector<size_t> candidate;
+
+        size_t next_free = 0;
+        for (size_t const b : by_size)
+        {
+            size_t const first = bucket_start[b];
+            size_t const count = bucket_start[b + 1] - first;
+            if (count == 0)
+            {
+                break;
+            }
+
+            if (count == 1)
+            {
+                while (taken[next_free])
+                {
+                    ++next_free;
+                }
+                taken[next_free]      = true;
+                order[members[first]] = next_free;
+                displacements_[b]     = ~static_cast<int64_t>(next_free);
+                continue;
+            }
+
+            bool placed = false;
+            for (uint32_t d = 0; d < max_displacement && !placed; ++d)
+            {
+                int64_t const salt = salt_of(d);
+                candidate.clear();
+                placed = true;
+                for (size_t k = first; k < first + count; ++k)
+                {
+                    size_t const slot = displaced_slot(hashes[members[k]], salt, n);
+                    if (taken[slot] ||
+                        std::find(candidate.begin(), candidate.end(), slot) != candidate.end())
+                    {
+                        placed = false;
+                        break;
+                    }
+                    candidate.push_back(slot);
+                }
+                if (placed)
+                {
+                    for (size_t k = 0; k < count; ++k)
+                    {
+                        taken[candidate[k]]       = true;
+                        order[members[first + k]] = candidate[k];
+                    }
+                    displacements_[b] = salt;
+                }
+            }
+            if (!placed)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<value_type> slots_;
+    std::vector<int64_t>    displacements_;
+    uint64_t                seed_ = 0;
+    Hash                    hash_;
+    Equal                   equal_;
+};
+
+}  // namespace quarisma
@@ -0,0 +1,197 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "util/hash.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <nmmintrin.h>
+#define QUARISMA_CRC32C_SSE42 1
+#define QUARISMA_CRC32C_TARGET
+#elif defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#include <nmmintrin.h>
+#define QUARISMA_CRC32C_SSE42 1
+#define QUARISMA_CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define QUARISMA_CRC32C_ARM 1
+#endif
+
+namespace quarisma
+{
+
+namespace
+{
+/// Reflected Castagnoli polynomial
+constexpr uint32_t crc32c_polynomial = 0x82F63B78U;
+
+using crc32c_tables = std::array<std::array<uint32_t, 256>, 8>;
+
+/**
+ * @brief Slicing-by-8 tables: tables[k][b] is the CRC of byte b followed by k zero bytes
+ */
+const crc32c_tables& software_tables()
+{
+    static const crc32c_tables tables = []
+    {
+        crc32c_tables t{};
+        for (uint32_t b = 0; b < 256; ++b)
+        {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ ((crc & 1U) != 0 ? crc32c_polynomial : 0U);
+            }
+            t[0][b] = crc;
+        }
+        for (size_t k = 1; k < t.size(); ++k)
+        {
+            for (uint32_t b = 0; b < 256; ++b)
+            {
+                t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFFU];
+            }
+        }
+        return t;
+    }();
+    return tables;
+}
+
+uint32_t crc32c_software(const unsigned char* p, size_t size, uint32_t crc) noexcept
+{
+    const crc32c_tables& t = software_tables();
+    while (size >= 8)
+    {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, p, sizeof(low));
+        std::memcpy(&high, p + 4, sizeof(high));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        low  = __builtin_bswap32(low);
+        high = __builtin_bswap32(high);
+#endif
+        low ^= crc;
+        crc = t[7][low & 0xFFU] ^ t[6][(low >> 8) & 0xFFU] ^ t[5][(low >> 16) & 0xFFU] ^
+              t[4][low >> 24] ^ t[3][high & 0xFFU] ^ t[2][(high >> 8) & 0xFFU] ^
+              t[1][(high >> 16) & 0xFFU] ^ t[0][high >> 24];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- != 0)
+    {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFFU];
+    }
+    return crc;
+}
+
+#if defined(QUARISMA_CRC32C_SSE42)
+QUARISMA_CRC32C_TARGET uint32_t
+crc32c_hardware_impl(const unsigned char* p, size_t size, uint32_t crc) noexcept
+{
+    uint64_t crc64 = crc;
+    while (size >= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    auto crc32 = static_cast<uint32_t>(crc64);
+    while (size-- != 0)
+    {
+        crc32 = _mm_crc32_u8(crc32, *p++);
+    }
+    return crc32;
+}
+
+bool detect_crc32c_hardware() noexcept
+{
+    constexpr unsigned sse42_bit = 1U << 20;  // CPUID.1:ECX.SSE4_2
+#if defined(_MSC_VER)
+    int regs[4] = {};
+    __cpuid(regs, 1);
+    return (static_cast<unsigned>(regs[2]) & sse42_bit) != 0;
+#else
+    unsigned eax = 0;
+    unsigned ebx = 0;
+    unsigned ecx = 0;
+    unsigned edx = 0;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & sse42_bit) != 0;
+#endif
+}
+#elif defined(QUARISMA_CRC32C_ARM)
+uint32_t crc32c_hardware_impl(const unsigned char* p, size_t size, uint32_t crc) noexcept
+{
+    while (size >= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc = __crc32cd(crc, word);
+        p += 8;
+        size -= 8;
+    }
+    while (size-- != 0)
+    {
+        crc = __crc32cb(crc, *p++);
+    }
+    return crc;
+}
+
+bool detect_crc32c_hardware() noexcept
+{
+    return true;  // The build targets the CRC extension
+}
+#else
+uint32_t crc32c_hardware_impl(const unsigned char* p, size_t size, uint32_t crc) noexcept
+{
+    return crc32c_software(p, size, crc);
+}
+
+bool detect_crc32c_hardware() noexcept
+{
+    return false;
+}
+#endif
+}  // namespace
+
+//-----------------------------------------------------------------------------
+bool crc32c_hardware() noexcept
+{
+    static const bool hardware = detect_crc32c_hardware();
+    return hardware;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) noexcept
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    crc           = ~crc;
+    crc           = crc32c_hardware() ? crc32c_hardware_impl(p, size, crc)
+                                      : crc32c_software(p, size, crc);
+    return ~crc;
+}
+
+}  // namespace quarisma
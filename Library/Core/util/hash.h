@@ -1,16 +1,22 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iomanip>
 #include <ios>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "common/export.h"
+#include "common/macros.h"
+#include "memory/device.h"
 #include "util/array_ref.h"
 #include "util/exception.h"
 //#include "util/complex.h"
@@ -286,6 +292,311 @@ constexpr uint64_t twang_mix64(uint64_t key) noexcept
     return key;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Byte range hashing
+////////////////////////////////////////////////////////////////////////////////
+
+// 128-bit hash value, e.g. a content address.
+struct hash128
+{
+    uint64_t low_{};
+    uint64_t high_{};
+
+    bool operator==(const hash128& other) const noexcept
+    {
+        return low_ == other.low_ && high_ == other.high_;
+    }
+    bool operator!=(const hash128& other) const noexcept { return !(*this == other); }
+
+    // 32 hex digits, high word first
+    std::string str() const
+    {
+        std::ostringstream ss;
+        ss << std::hex << std::setfill('0') << std::setw(16) << high_ << std::setw(16) << low_;
+        return ss.str();
+    }
+
+    static size_t hash(const hash128& h) noexcept { return static_cast<size_t>(h.low_); }
+};
+
+namespace _hash_detail
+{
+
+// Constants of the wyhash construction (Wang Yi, public domain)
+inline constexpr uint64_t wy_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+// Seed offset of the second word of the 128-bit hashes
+inline constexpr uint64_t wy_seed128 = 0x9e3779b97f4a7c15ULL;
+
+// Bytes absorbed per round, in three independent 16-byte lanes
+inline constexpr size_t wy_block = 48;
+
+// 64x64 -> 128-bit multiplication, low half in a and high half in b
+QUARISMA_FORCE_INLINE void wy_mum(uint64_t& a, uint64_t& b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t const r = static_cast<__uint128_t>(a) * b;
+    a                   = static_cast<uint64_t>(r);
+    b                   = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t const ha  = a >> 32;
+    uint64_t const hb  = b >> 32;
+    uint64_t const la  = static_cast<uint32_t>(a);
+    uint64_t const lb  = static_cast<uint32_t>(b);
+    uint64_t const rh  = ha * hb;
+    uint64_t const rm0 = ha * lb;
+    uint64_t const rm1 = hb * la;
+    uint64_t const rl  = la * lb;
+    uint64_t const t   = rl + (rm0 << 32);
+    uint64_t       c   = static_cast<uint64_t>(t < rl);
+    uint64_t const lo  = t + (rm1 << 32);
+    c += static_cast<uint64_t>(lo < t);
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+QUARISMA_FORCE_INLINE uint64_t wy_mix(uint64_t a, uint64_t b) noexcept
+{
+    wy_mum(a, b);
+    return a ^ b;
+}
+
+// Little-endian loads, so that hashes do not depend on the platform
+QUARISMA_FORCE_INLINE uint64_t wy_r8(const unsigned char* p) noexcept
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+QUARISMA_FORCE_INLINE uint64_t wy_r4(const unsigned char* p) noexcept
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+// 1 to 3 bytes
+QUARISMA_FORCE_INLINE uint64_t wy_r3(const unsigned char* p, size_t k) noexcept
+{
+    return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[k >> 1]) << 8) |
+           p[k - 1];
+}
+
+// Chaining state of Words independent 64-bit hashes over the same bytes
+template <size_t Words>
+struct wy_state
+{
+    uint64_t seed_[Words];
+    uint64_t see1_[Words];
+    uint64_t see2_[Words];
+
+    explicit wy_state(uint64_t seed) noexcept
+    {
+        for (size_t w = 0; w < Words; ++w)
+        {
+            uint64_t const s = w == 0 ? seed : seed ^ wy_seed128;
+            seed_[w]         = s ^ wy_mix(s ^ wy_secret[0], wy_secret[1]);
+            see1_[w]         = seed_[w];
+            see2_[w]         = seed_[w];
+        }
+    }
+
+    // Absorbs wy_block bytes; only called while more than wy_block bytes remain
+    QUARISMA_FORCE_INLINE void absorb(const unsigned char* p) noexcept
+    {
+        uint64_t const r0 = wy_r8(p);
+        uint64_t const r1 = wy_r8(p + 8);
+        uint64_t const r2 = wy_r8(p + 16);
+        uint64_t const r3 = wy_r8(p + 24);
+        uint64_t const r4 = wy_r8(p + 32);
+        uint64_t const r5 = wy_r8(p + 40);
+        for (size_t w = 0; w < Words; ++w)
+        {
+            seed_[w] = wy_mix(r0 ^ wy_secret[1], r1 ^ seed_[w]);
+            see1_[w] = wy_mix(r2 ^ wy_secret[2], r3 ^ see1_[w]);
+            see2_[w] = wy_mix(r4 ^ wy_secret[3], r5 ^ see2_[w]);
+        }
+    }
+
+    // Hashes of `len` bytes, the last `tail` of which (at most wy_block) are
+    // at p and not absorbed. When len > 16 the 16 bytes before p + tail must
+    // be readable, even if they were absorbed already.
+    void finish(const unsigned char* p, size_t tail, uint64_t len, uint64_t (&out)[Words])
+        const noexcept
+    {
+        for (size_t w = 0; w < Words; ++w)
+        {
+            // Without any absorbed block the three lanes are equal and fold to seed_
+            uint64_t seed = seed_[w] ^ see1_[w] ^ see2_[w];
+            uint64_t a    = 0;
+            uint64_t b    = 0;
+            if (len <= 16)
+            {
+                if (len >= 4)
+                {
+                    size_t const half = (len >> 3) << 2;
+                    a                 = (wy_r4(p) << 32) | wy_r4(p + half);
+                    b                 = (wy_r4(p + len - 4) << 32) | wy_r4(p + len - 4 - half);
+                }
+                else if (len > 0)
+                {
+                    a = wy_r3(p, len);
+                }
+            }
+            else
+            {
+                const unsigned char* q = p;
+                size_t               i = tail;
+                while (i > 16)
+                {
+                    seed = wy_mix(wy_r8(q) ^ wy_secret[1], wy_r8(q + 8) ^ seed);
+                    q += 16;
+                    i -= 16;
+                }
+                a = wy_r8(q + i - 16);
+                b = wy_r8(q + i - 8);
+            }
+            a ^= wy_secret[1];
+            b ^= seed;
+            wy_mum(a, b);
+            out[w] = wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+        }
+    }
+};
+
+template <size_t Words>
+void wy_hash(const void* data, size_t size, uint64_t seed, uint64_t (&out)[Words]) noexcept
+{
+    const auto*     p = static_cast<const unsigned char*>(data);
+    wy_state<Words> state(seed);
+    size_t          i = size;
+    while (i > wy_block)
+    {
+        state.absorb(p);
+        p += wy_block;
+        i -= wy_block;
+    }
+    state.finish(p, i, size, out);
+}
+
+// Streaming form of wy_hash, see byte_hasher
+template <size_t Words>
+class basic_byte_hasher
+{
+public:
+    using result_type = std::conditional_t<Words == 1, uint64_t, hash128>;
+
+    explicit basic_byte_hasher(uint64_t seed = 0) noexcept : state_(seed) {}
+
+    basic_byte_hasher& update(const void* data, size_t size) noexcept
+    {
+        const auto* p = static_cast<const unsigned char*>(data);
+        size_ += size;
+        if (pending_ + size <= wy_block)
+        {
+            std::memcpy(buffer_ + history + pending_, p, size);
+            pending_ += size;
+            return *this;
+        }
+
+        // More bytes follow the pending ones: they form a full block
+        if (pending_ != 0)
+        {
+            size_t const fill = wy_block - pending_;
+            std::memcpy(buffer_ + history + pending_, p, fill);
+            p += fill;
+            size -= fill;
+            state_.absorb(buffer_ + history);
+            std::memcpy(buffer_, buffer_ + wy_block, history);
+        }
+        if (size > wy_block)
+        {
+            do
+            {
+                state_.absorb(p);
+                p += wy_block;
+                size -= wy_block;
+            } while (size > wy_block);
+            std::memcpy(buffer_, p - history, history);
+        }
+        std::memcpy(buffer_ + history, p, size);
+        pending_ = size;
+        return *this;
+    }
+
+    // Same value as hash_bytes (or hash_bytes128) of all the bytes so far
+    result_type digest() const noexcept
+    {
+        uint64_t out[Words];
+        state_.finish(buffer_ + history, pending_, size_, out);
+        if constexpr (Words == 1)
+        {
+            return out[0];
+        }
+        else
+        {
+            return hash128{out[0], out[1]};
+        }
+    }
+
+private:
+    // Bytes of the last absorbed block kept for finish()
+    static constexpr size_t history = 16;
+
+    wy_state<Words> state_;
+    uint64_t        size_{0};
+    size_t          pending_{0};
+    unsigned char   buffer_[history + wy_block]{};
+};
+
+}  // namespace _hash_detail
+
+// Fast non-cryptographic 64-bit hash of a byte range, following the wyhash
+// construction: three independent multiply-mix lanes over 48-byte blocks.
+// The value only depends on the bytes and the seed, on every platform, so it
+// can key persistent content-addressed caches. Use sha1 where an adversary
+// may choose the input.
+inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) noexcept
+{
+    uint64_t out[1];
+    _hash_detail::wy_hash(data, size, seed, out);
+    return out[0];
+}
+
+// 128-bit variant of hash_bytes, two hashes with unrelated seeds computed in
+// the same pass. low_ equals hash_bytes(data, size, seed).
+inline hash128 hash_bytes128(const void* data, size_t size, uint64_t seed = 0) noexcept
+{
+    uint64_t out[2];
+    _hash_detail::wy_hash(data, size, seed, out);
+    return {out[0], out[1]};
+}
+
+// Incremental hash_bytes / hash_bytes128 over data arriving in pieces.
+// Usage:
+//   quarisma::byte_hasher128 hasher;
+//   hasher.update(header.data(), header.size()).update(payload, payload_size);
+//   const auto key = hasher.digest();
+using byte_hasher    = _hash_detail::basic_byte_hasher<1>;
+using byte_hasher128 = _hash_detail::basic_byte_hasher<2>;
+
+// CRC-32C (Castagnoli) of a byte range, chained through crc. Uses the SSE4.2
+// crc32 instruction when the CPU has it (ARMv8 CRC when the build targets
+// it), a sliced table otherwise.
+QUARISMA_API uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0) noexcept;
+
+// Whether crc32c() runs on the CRC instructions
+QUARISMA_API bool crc32c_hardware() noexcept;
+
 ////////////////////////////////////////////////////////////////////////////////
 // quarisma::hash implementation
 ////////////////////////////////////////////////////////////////////////////////
@@ -428,6 +739,49 @@ size_t get_hash(const Types&... args)
     return quarisma::hash<decltype(std::tie(args...))>()(std::tie(args...));
 }
 
+// Contiguous bytes to hash with hash_bytes, alone or as one of the arguments
+// of get_hash. Only the object representation is hashed: padding bytes and
+// the different encodings of equal floating-point values are not normalized.
+struct byte_range
+{
+    const void* data_{};
+    size_t      size_{};
+
+    static size_t hash(const byte_range& range) noexcept
+    {
+        return static_cast<size_t>(hash_bytes(range.data_, range.size_));
+    }
+};
+
+inline byte_range as_byte_range(const void* data, size_t size) noexcept
+{
+    return {data, size};
+}
+
+inline byte_range as_byte_range(std::string_view s) noexcept
+{
+    return {s.data(), s.size()};
+}
+
+template <typename T>
+byte_range as_byte_range(quarisma::array_ref<T> values) noexcept
+{
+    static_assert(std::is_trivially_copyable_v<T>, "as_byte_range needs trivially copyable data");
+    return {values.data(), values.size() * sizeof(T)};
+}
+
+template <typename T>
+byte_range as_byte_range(const std::vector<T>& values) noexcept
+{
+    return as_byte_range(quarisma::array_ref<T>(values));
+}
+
+// Hash of a byte range alone: hash_bytes, without the tuple combination
+inline size_t get_hash(const byte_range& range) noexcept
+{
+    return byte_range::hash(range);
+}
+
 // Specialization for quarisma::complex
 //template <typename T>
 //struct hash<quarisma::complex<T>> {
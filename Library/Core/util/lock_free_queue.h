@@ -39,6 +39,7 @@ limitations under the License.
 #include <atomic>
 #include <cstddef>
 #include <optional>
+#include <thread>
 #include <utility>
 
 #include "common/macros.h"
@@ -79,6 +80,10 @@ namespace QueueBaseInternal
 // Beyond the QueueBase,
 //   * LockFreeQueue's PopAll() will generate a BlockedQueue efficiently
 //   * BlockedQueue support move constructor/assignment and iterators
+//
+// MultiProducerLockFreeQueue is the multi-producer single-consumer variant. It
+// keeps the block list but uses its own block layout (MultiProducerBlock), see
+// the comment of that class.
 
 template <typename T, size_t kBlockSize>
 struct InternalBlock
@@ -217,6 +222,30 @@ protected:
     Index<kAtomicEnd> end_;          // Maybe atomic: read also by consumer thread.
 };
 
+// Block of MultiProducerLockFreeQueue. Producers claim slots with a fetch_add
+// on `claimed` and publish each slot with its own `ready` flag, since slots of
+// a block are no longer filled in order when several threads push.
+template <typename T, size_t kBlockSize>
+struct MultiProducerBlock
+{
+    struct Slot
+    {
+        std::atomic<bool> ready;
+        no_init<T>        element;
+    };
+
+    static constexpr size_t kNumSlots =
+        (kBlockSize - (sizeof(size_t /*start*/) + sizeof(std::atomic<MultiProducerBlock*>) +
+                       sizeof(MultiProducerBlock* /*free_next*/) + sizeof(std::atomic<size_t>))) /
+        sizeof(Slot);
+
+    size_t                           start;      // The number of the first slot.
+    std::atomic<MultiProducerBlock*> next;       // Set once by the producer that fills the block
+    MultiProducerBlock*              free_next;  // Link in the free list
+    std::atomic<size_t>              claimed;    // Slots handed out to producers
+    Slot                             slots[kNumSlots];
+};
+
 }  // namespace QueueBaseInternal
 
 template <typename T, size_t kBlockSize>
@@ -235,13 +264,13 @@ public:
 
     BlockedQueue& operator=(BlockedQueue&& src)
     {
-        this->Clear();
+        this->clear();
         std::swap(this->start_block_, src.start_block_);
         std::swap(this->start_, src.start_);
         std::swap(this->end_block_, src.end_block_);
-        auto origin_end = this->End();
-        this->SetEnd(src.End());
-        src.SetEnd(origin_end);
+        auto origin_end = this->get_end();
+        this->set_end(src.get_end());
+        src.set_end(origin_end);
         return *this;
     }
 
@@ -270,10 +299,10 @@ public:
                 block_->start,
                 Block::kNumSlots);
             QUARISMA_CHECK_DEBUG(
-                index_ < queue_->End(),
-                "index_={} is greater than queue_->End()={}",
+                index_ < queue_->get_end(),
+                "index_={} is greater than queue_->get_end()={}",
                 index_,
-                queue_->End());
+                queue_->get_end());
             return block_->slots[index_ - block_->start].value;
         }
 
@@ -283,12 +312,12 @@ public:
         {
             QUARISMA_CHECK_DEBUG(queue_ != nullptr, "queue_ is nullptr");
             QUARISMA_CHECK_DEBUG(block_ != nullptr, "block_ is nullptr");
-            if (index_ < queue_->End())
+            if (index_ < queue_->get_end())
             {
                 ++index_;
                 auto next_block_start = block_->start + Block::kNumSlots;
                 QUARISMA_CHECK_DEBUG(
-                    index_ < next_block_start,
+                    index_ <= next_block_start,
                     "index_ {} is greater than next_block_start {}",
                     index_,
                     next_block_start);
@@ -319,7 +348,7 @@ public:
 
     Iterator begin() { return Iterator(this, this->start_block_, this->start_); }
 
-    Iterator end() { return Iterator(this, this->end_block_, this->End()); }
+    Iterator end() { return Iterator(this, this->end_block_, this->get_end()); }
 };
 
 template <typename T, size_t kBlockSize = 1 << 16 /* 64 KiB */>
@@ -338,8 +367,8 @@ public:
         result.start_block_ = result.end_block_ = nullptr;
         result.start_                           = this->start_;
         // Use the end we see now, skip further growing if any in another thread
-        size_t end = this->End();
-        result.SetEnd(end);
+        size_t end = this->get_end();
+        result.set_end(end);
         while (this->start_block_->start + Block::kNumSlots <= end)
         {
             auto* old_block = std::exchange(this->start_block_, this->start_block_->next);
@@ -377,4 +406,189 @@ public:
     }
 };
 
+// Multi-producer single-consumer version of LockFreeQueue.
+//
+// push() may be called from any number of threads; pop(), clear() and PopAll()
+// from a single consumer thread. Pushing is lock free in the common case: a
+// producer claims a slot of the tail block with one fetch_add, constructs the
+// element and sets the slot's ready flag. The producer whose claim overflows the
+// tail block links the next block; the other overflowing producers wait for it.
+//
+// The consumer returns drained blocks to a free list that producers take the
+// next blocks from, so once the queue has reached its working size pushing no
+// longer allocates. Blocks are freed only on destruction.
+//
+// Elements of one producer are popped in the order they were pushed. The
+// consumer stops at the first claimed slot that is not published yet, so an
+// element pushed concurrently with pop() may stay in the queue.
+template <typename T, size_t kBlockSize = 1 << 16 /* 64 KiB */>
+class MultiProducerLockFreeQueue final
+{
+    using Block = QueueBaseInternal::MultiProducerBlock<T, kBlockSize>;
+
+public:
+    static constexpr size_t kNumSlotsPerBlockForTesting = Block::kNumSlots;
+
+    MultiProducerLockFreeQueue()
+        : start_block_(allocate_block(0)), start_(0), end_block_(start_block_)
+    {
+    }
+
+    // As for LockFreeQueue, no push() may be in flight during destruction.
+    ~MultiProducerLockFreeQueue()
+    {
+        clear();
+        for (Block* block = start_block_; block != nullptr;)
+        {
+            delete std::exchange(block, block->next.load(std::memory_order_relaxed));
+        }
+        for (Block* block = free_blocks_.load(std::memory_order_acquire); block != nullptr;)
+        {
+            delete std::exchange(block, block->free_next);
+        }
+    }
+
+    MultiProducerLockFreeQueue(const MultiProducerLockFreeQueue&)            = delete;
+    MultiProducerLockFreeQueue& operator=(const MultiProducerLockFreeQueue&) = delete;
+
+    // Adds a new element to the back of the queue. Thread safe.
+    void push(T&& element)
+    {
+        while (true)
+        {
+            Block*       block = end_block_.load(std::memory_order_acquire);
+            const size_t index = block->claimed.fetch_add(1, std::memory_order_acq_rel);
+            if QUARISMA_LIKELY (index < Block::kNumSlots)
+            {
+                auto& slot = block->slots[index];
+                slot.element.emplace(std::move(element));
+                slot.ready.store(true, std::memory_order_release);  // Publish after contents.
+                return;
+            }
+
+            if (index == Block::kNumSlots)
+            {
+                // First claim past the block: this producer links the next one. A
+                // stale pointer to a recycled block can land here before the block
+                // is the tail again; wait so that blocks are linked in order.
+                while (end_block_.load(std::memory_order_acquire) != block)
+                {
+                    std::this_thread::yield();
+                }
+                Block* next = allocate_block(block->start + Block::kNumSlots);
+                block->next.store(next, std::memory_order_release);
+                end_block_.store(next, std::memory_order_release);
+            }
+            else
+            {
+                while (end_block_.load(std::memory_order_acquire) == block)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    // Removes one element off the front of the queue and returns it.
+    // Consumer thread only.
+    std::optional<T> pop()
+    {
+        std::optional<T> element;
+        if (front_ready())
+        {
+            element = pop_impl();
+        }
+        return element;
+    }
+
+    // Removes all the published elements from the queue. Consumer thread only.
+    void clear()
+    {
+        while (front_ready())
+        {
+            pop_impl();
+        }
+    }
+
+    // Moves all the published elements into a normal block storage queue.
+    // Unlike LockFreeQueue::PopAll() the blocks are not handed over: they stay
+    // with this queue, on the free list. Consumer thread only.
+    BlockedQueue<T, kBlockSize> PopAll()
+    {
+        BlockedQueue<T, kBlockSize> result;
+        while (front_ready())
+        {
+            result.push(pop_impl());
+        }
+        return result;
+    }
+
+private:
+    // Returns true if the element at start_ is published. Moves to the next
+    // block, recycling the current one, when start_ has reached its end.
+    bool front_ready()
+    {
+        if QUARISMA_UNLIKELY (start_ - start_block_->start == Block::kNumSlots)
+        {
+            Block* next = start_block_->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+            {
+                return false;
+            }
+            recycle_block(std::exchange(start_block_, next));
+            QUARISMA_CHECK_DEBUG(
+                start_ == start_block_->start, "start_ is not equal to start_block_->start");
+        }
+        return start_block_->slots[start_ - start_block_->start].ready.load(
+            std::memory_order_acquire);
+    }
+
+    // REQUIRES: front_ready() returned true.
+    T pop_impl()
+    {
+        auto& slot = start_block_->slots[start_++ - start_block_->start];
+        slot.ready.store(false, std::memory_order_relaxed);  // Published by recycle_block
+        return std::move(slot.element).consume();
+    }
+
+    // Called by the producer linking a block, so by one thread at a time: the
+    // free list has a single popper and is immune to ABA.
+    Block* allocate_block(size_t start)
+    {
+        Block* block = free_blocks_.load(std::memory_order_acquire);
+        while (block != nullptr &&
+               !free_blocks_.compare_exchange_weak(
+                   block, block->free_next, std::memory_order_acquire, std::memory_order_acquire))
+        {
+        }
+        if (block == nullptr)
+        {
+            block = new Block;
+            for (auto& slot : block->slots)
+            {
+                slot.ready.store(false, std::memory_order_relaxed);
+            }
+        }
+        block->start = start;
+        block->next.store(nullptr, std::memory_order_relaxed);
+        block->claimed.store(0, std::memory_order_release);  // Open the block to producers
+        return block;
+    }
+
+    void recycle_block(Block* block)
+    {
+        block->free_next = free_blocks_.load(std::memory_order_relaxed);
+        while (!free_blocks_.compare_exchange_weak(
+            block->free_next, block, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Declared first: the constructor takes the first block from it.
+    std::atomic<Block*> free_blocks_{nullptr};  // Drained blocks ready for reuse.
+    Block*              start_block_;           // Head: updated only by consumer thread.
+    size_t              start_;                 // Read only by consumer thread.
+    std::atomic<Block*> end_block_;             // Tail: advanced by the producer linking a block.
+};
+
 }  // namespace quarisma
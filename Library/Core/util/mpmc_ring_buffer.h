@@ -0,0 +1,172 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "util/no_init.h"
+
+namespace quarisma
+{
+
+// Bounded multi-producer multi-consumer FIFO over a ring of slots (D. Vyukov's
+// design). Each slot carries a sequence number telling whether it is ready to
+// be written for lap N or read for lap N:
+//
+//   slot.sequence == pos        -> free, a producer may claim position pos
+//   slot.sequence == pos + 1    -> full, a consumer may claim position pos
+//
+// Producers and consumers claim positions with a CAS on their own cursor and
+// then publish the slot with a release store of its sequence, so try_push and
+// try_pop are lock free and never allocate. Unlike LockFreeQueue the capacity is
+// fixed: try_push fails when the ring is full and the caller decides whether to
+// retry, drop or block.
+template <typename T>
+class mpmc_ring_buffer
+{
+public:
+    // The capacity is rounded up to a power of two, and is at least 2.
+    explicit mpmc_ring_buffer(size_t capacity)
+        : mask_(round_up_to_power_of_two(capacity) - 1), slots_(new slot[mask_ + 1])
+    {
+        for (size_t i = 0; i <= mask_; ++i)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Destroys the elements still queued. No push or pop may be in flight.
+    ~mpmc_ring_buffer()
+    {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t pos = head_.load(std::memory_order_acquire); pos != tail; ++pos)
+        {
+            slots_[pos & mask_].value.Destroy();
+        }
+    }
+
+    mpmc_ring_buffer(const mpmc_ring_buffer&)            = delete;
+    mpmc_ring_buffer& operator=(const mpmc_ring_buffer&) = delete;
+
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+    // Enqueues `value` unless the ring is full. Thread safe.
+    bool try_push(T&& value)
+    {
+        size_t pos  = tail_.load(std::memory_order_relaxed);
+        slot*  cell = nullptr;
+        while (true)
+        {
+            cell                  = &slots_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto   diff =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;  // Full: the slot still holds the previous lap
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value.emplace(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Dequeues the oldest element into `value` unless the ring is empty. Thread safe.
+    bool try_pop(T& value)
+    {
+        size_t pos  = head_.load(std::memory_order_relaxed);
+        slot*  cell = nullptr;
+        while (true)
+        {
+            cell                  = &slots_[pos & mask_];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto   diff =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;  // Empty: the slot has not been written for this lap
+            }
+            else
+            {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value).consume();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate number of elements; exact when no push or pop is in flight.
+    size_t size_approx() const noexcept
+    {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+private:
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct alignas(kCacheLineSize) slot
+    {
+        std::atomic<size_t> sequence;
+        no_init<T>          value;
+    };
+
+    static size_t round_up_to_power_of_two(size_t n)
+    {
+        size_t result = 2;
+        while (result < n)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t            mask_;
+    std::unique_ptr<slot[]> slots_;
+
+    // Producers and consumers update different cursors; keep them on separate lines.
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+};
+
+}  // namespace quarisma
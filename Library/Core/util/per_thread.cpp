@@ -0,0 +1,120 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "util/per_thread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#include "memory/helper/memory_allocator.h"
+#include "memory/numa.h"
+#include "util/exception.h"
+
+namespace quarisma
+{
+namespace detail
+{
+namespace
+{
+constexpr size_t page_size  = size_t{4} << 10;
+constexpr size_t chunk_size = size_t{64} << 10;
+constexpr int    max_nodes  = 64;
+
+struct slot_chunk
+{
+    char*               data;
+    size_t              capacity;
+    std::atomic<size_t> used{0};
+};
+
+// Chunk being carved on each node; the ones before it are full and never freed
+std::atomic<slot_chunk*> g_current_chunk[max_nodes];
+
+slot_chunk* new_chunk(size_t bytes, int node)
+{
+    size_t const rounded  = std::max(bytes, chunk_size) + page_size - 1;
+    size_t const capacity = rounded / page_size * page_size;
+    void* const  data     = cpu::memory_allocator::allocate(capacity, page_size);
+    if (GetNumNUMANodes() > 1)
+    {
+        NUMAMove(data, capacity, node);
+    }
+    auto* chunk     = new slot_chunk;
+    chunk->data     = static_cast<char*>(data);
+    chunk->capacity = capacity;
+    return chunk;
+}
+
+// Offset of `bytes` at `alignment` in chunk, or capacity when it does not fit
+size_t carve(slot_chunk& chunk, size_t bytes, size_t alignment)
+{
+    size_t used = chunk.used.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        size_t const offset = (used + alignment - 1) / alignment * alignment;
+        if (offset + bytes > chunk.capacity)
+        {
+            return chunk.capacity;
+        }
+        if (chunk.used.compare_exchange_weak(used, offset + bytes, std::memory_order_relaxed))
+        {
+            return offset;
+        }
+    }
+}
+}  // namespace
+
+void* allocate_per_thread_slot(size_t bytes, size_t alignment, int node)
+{
+    QUARISMA_CHECK(alignment <= page_size, "per_thread slots align to at most a page");
+    std::atomic<slot_chunk*>& current = g_current_chunk[std::clamp(node, 0, max_nodes - 1)];
+
+    slot_chunk* chunk = current.load(std::memory_order_acquire);
+    for (;;)
+    {
+        if (chunk != nullptr)
+        {
+            size_t const offset = carve(*chunk, bytes, alignment);
+            if (offset != chunk->capacity)
+            {
+                return chunk->data + offset;
+            }
+        }
+
+        slot_chunk* fresh = new_chunk(bytes, node);
+        if (current.compare_exchange_strong(
+                chunk, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            chunk = fresh;
+            continue;
+        }
+        // Another thread installed a chunk first: carve from that one instead
+        cpu::memory_allocator::free(fresh->data, fresh->capacity);
+        delete fresh;
+    }
+}
+
+int per_thread_numa_node()
+{
+    return std::max(GetCurrentNUMANode(), 0);
+}
+}  // namespace detail
+}  // namespace quarisma
@@ -33,17 +33,31 @@ limitations under the License.
 ==============================================================================*/
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
-#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "common/macros.h"
-#include "util/flat_hash.h"
 
-//#include "absl/synchronization/mutex.h"
-//#include "absl/base/thread_annotations.h"
 namespace quarisma
 {
+namespace detail
+{
+/**
+ * @brief Memory for a per_thread slot on NUMA node `node`
+ *
+ * Carved without a lock from page-aligned chunks bound to the node. It is
+ * never returned: per_thread reuses the slots of exited threads instead.
+ */
+QUARISMA_API void* allocate_per_thread_slot(size_t bytes, size_t alignment, int node);
+
+/** NUMA node of the calling thread, 0 without NUMA support. */
+QUARISMA_API int per_thread_numa_node();
+}  // namespace detail
 
 // per_thread<T> provides a thread-local instance of T accessible to each
 // application application thread, and provides the profiler thread access to
@@ -54,6 +68,14 @@ namespace quarisma
 // The thread-local instance is destroyed when the thread exits, unless
 // StartRecording has been called. During recording, if a thread exits, its
 // thread-local instance of T is kept alive until StopRecording is called.
+//
+// Each instance lives in a slot of its own cache lines, allocated on the NUMA
+// node of the thread that created it, so that neither Get() nor the accesses
+// through it share a line with another thread. Slots are pushed onto a
+// lock-free list, and the slot of an exited thread is reused by a later
+// thread on the same node once every shared_ptr to its instance is gone.
+// Only a slot's own spin lock is taken, by its thread when it exits and by
+// the functions that visit all the instances.
 template <typename T>
 class per_thread
 {
@@ -79,11 +101,78 @@ public:
         return Registry::Get().StopRecording();
     }
 
+    // Returns all instances of T from live threads and, while recording, from
+    // destroyed threads, without changing the recording state.
+    static std::vector<std::shared_ptr<T>> GetAll() { return Registry::Get().GetAll(); }
+
+    // Calls f(T&) on the instances GetAll() would return, without copying a
+    // shared_ptr or allocating. A thread exiting meanwhile waits for f to
+    // return if f is visiting its instance, so keep f short.
+    template <typename F>
+    static void ForEachThread(F&& f)
+    {
+        Registry::Get().ForEachThread(f);
+    }
+
 private:
     // Prevent instantiation.
     per_thread()  = delete;
     ~per_thread() = delete;
 
+    struct alignas(64) Slot
+    {
+        enum State : int
+        {
+            kLive,     // Owned by a running thread
+            kRetired,  // Thread exited while recording; instance kept
+            kFree,     // Reusable once storage_free is set
+        };
+
+        Slot* next = nullptr;  // Immutable once the slot is published
+        int   node = 0;
+
+        std::atomic<int>  state{kLive};
+        std::atomic<bool> storage_free{true};  // Set when the instance is destroyed
+
+        std::atomic_flag   lock = ATOMIC_FLAG_INIT;  // Guards instance
+        std::shared_ptr<T> instance;
+
+        // On a line of its own: the header above is what other threads touch
+        alignas(alignof(T) > 64 ? alignof(T) : 64) unsigned char storage[sizeof(T)];
+    };
+
+    class SlotLock
+    {
+    public:
+        explicit SlotLock(Slot& slot) : slot_(slot)
+        {
+            while (slot_.lock.test_and_set(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        ~SlotLock() { slot_.lock.clear(std::memory_order_release); }
+
+        SlotLock(const SlotLock&)       = delete;
+        void operator=(const SlotLock&) = delete;
+
+    private:
+        Slot& slot_;
+    };
+
+    // Destroys the instance in place and lets the slot be reused
+    struct SlotDeleter
+    {
+        void operator()(T* value) const noexcept
+        {
+            value->~T();
+            slot->storage_free.store(true, std::memory_order_release);
+        }
+
+        Slot* slot;
+    };
+
     // Singleton registry of all thread-local instances of T.
     class Registry
     {
@@ -96,59 +185,115 @@ private:
 
         std::vector<std::shared_ptr<T>> StartRecording()
         {
-            std::vector<std::shared_ptr<T>> threads;
-            std::lock_guard<std::mutex>     lock(mutex_);
-            threads.reserve(threads_.size());
-            for (auto iter = threads_.begin(); iter != threads_.end(); ++iter)
-            {
-                threads.push_back(iter->first);
-            }
-            recording_ = true;
-            return threads;
+            recording_.store(true);
+            return GetAll();
         }
 
         std::vector<std::shared_ptr<T>> StopRecording()
         {
+            // A thread exiting after this store releases its instance; one that
+            // read recording_ first has retired its slot before it is visited
+            recording_.store(false);
+
             std::vector<std::shared_ptr<T>> threads;
-            std::lock_guard<std::mutex>     lock(mutex_);
-            threads.reserve(threads_.size());
-            for (auto iter = threads_.begin(); iter != threads_.end();)
+            for (Slot* slot = First(); slot != nullptr; slot = slot->next)
             {
-                if (!iter->second)
+                SlotLock const lock(*slot);
+                if (slot->instance == nullptr)
+                {
+                    continue;
+                }
+                if (slot->state.load(std::memory_order_relaxed) == Slot::kRetired)
                 {  // The creator thread is dead.
-                    threads.push_back(std::move(iter->first));
-                    threads_.erase(iter++);
+                    threads.push_back(std::move(slot->instance));
+                    slot->state.store(Slot::kFree, std::memory_order_release);
                 }
                 else
                 {
-                    threads.push_back(iter->first);
-                    ++iter;
+                    threads.push_back(slot->instance);
+                }
+            }
+            return threads;
+        }
+
+        std::vector<std::shared_ptr<T>> GetAll()
+        {
+            std::vector<std::shared_ptr<T>> threads;
+            for (Slot* slot = First(); slot != nullptr; slot = slot->next)
+            {
+                SlotLock const lock(*slot);
+                if (slot->instance != nullptr)
+                {
+                    threads.push_back(slot->instance);
                 }
             }
-            recording_ = false;
             return threads;
         }
 
-        void Register(std::shared_ptr<T> thread)
+        template <typename F>
+        void ForEachThread(F& f)
         {
-            std::lock_guard<std::mutex> lock(mutex_);
-            threads_.insert_or_assign(std::move(thread), true);
+            for (Slot* slot = First(); slot != nullptr; slot = slot->next)
+            {
+                SlotLock const lock(*slot);
+                if (slot->instance != nullptr)
+                {
+                    f(*slot->instance);
+                }
+            }
         }
 
-        void Unregister(const std::shared_ptr<T>& thread)
+        // Returns a live slot with a new instance, reusing a free slot of this node
+        Slot* Register(T*& value)
         {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!recording_)
+            int const node = detail::per_thread_numa_node();
+            for (Slot* slot = First(); slot != nullptr; slot = slot->next)
+            {
+                int expected = Slot::kFree;
+                if (slot->node != node ||
+                    slot->state.load(std::memory_order_relaxed) != Slot::kFree ||
+                    !slot->state.compare_exchange_strong(
+                        expected, Slot::kLive, std::memory_order_acq_rel))
+                {
+                    continue;
+                }
+                // Read after claiming, so that the state seen is the current one
+                if (!slot->storage_free.load(std::memory_order_acquire))
+                {
+                    slot->state.store(Slot::kFree, std::memory_order_release);
+                    continue;
+                }
+                value = Construct(slot);
+                return slot;
+            }
+
+            void* memory = detail::allocate_per_thread_slot(sizeof(Slot), alignof(Slot), node);
+            auto* slot   = new (memory) Slot();
+            slot->node   = node;
+            value        = Construct(slot);
+
+            slot->next = head_.load(std::memory_order_relaxed);
+            while (!head_.compare_exchange_weak(
+                slot->next, slot, std::memory_order_release, std::memory_order_relaxed))
             {
-                threads_.erase(thread);
             }
-            else
+            return slot;
+        }
+
+        void Unregister(Slot* slot)
+        {
+            std::shared_ptr<T> released;
             {
-                if (auto it = threads_.find(thread); it != threads_.end())
+                SlotLock const lock(*slot);
+                if (recording_.load())
                 {
-                    it->second = false;
+                    slot->state.store(Slot::kRetired, std::memory_order_relaxed);
+                    return;
                 }
+                released = std::move(slot->instance);
+                slot->state.store(Slot::kFree, std::memory_order_release);
             }
+            // ~T() runs outside the lock, here or wherever the last copy goes
         }
 
     private:
@@ -157,23 +302,57 @@ private:
         Registry(const Registry&)       = delete;
         void operator=(const Registry&) = delete;
 
-        std::mutex                                               mutex_;
-        quarisma::flat_hash_map<std::shared_ptr<T>, bool> threads_ QUARISMA_GUARDED_BY(mutex_);
-        bool recording_                                          QUARISMA_GUARDED_BY(mutex_) = false;
+        Slot* First() const noexcept { return head_.load(std::memory_order_acquire); }
+
+        static T* Construct(Slot* slot)
+        {
+            slot->storage_free.store(false, std::memory_order_relaxed);
+            T* value = nullptr;
+            try
+            {
+                value = new (slot->storage) T();
+            }
+            catch (...)
+            {
+                slot->storage_free.store(true, std::memory_order_release);
+                slot->state.store(Slot::kFree, std::memory_order_release);
+                throw;
+            }
+
+            // Should the control block fail to allocate, the deleter has run
+            std::shared_ptr<T> instance;
+            try
+            {
+                instance = std::shared_ptr<T>(value, SlotDeleter{slot});
+            }
+            catch (...)
+            {
+                slot->state.store(Slot::kFree, std::memory_order_release);
+                throw;
+            }
+
+            SlotLock const lock(*slot);
+            slot->instance = std::move(instance);
+            return value;
+        }
+
+        std::atomic<Slot*> head_{nullptr};
+        std::atomic<bool>  recording_{false};
     };
 
     // Thread-local instance of T.
     class ThreadLocalPtr
     {
     public:
-        ThreadLocalPtr() : ptr_(std::make_shared<T>()) { Registry::Get().Register(ptr_); }
+        ThreadLocalPtr() : slot_(Registry::Get().Register(value_)) {}
 
-        ~ThreadLocalPtr() { Registry::Get().Unregister(ptr_); }
+        ~ThreadLocalPtr() { Registry::Get().Unregister(slot_); }
 
-        T& Get() { return *ptr_; }
+        T& Get() { return *value_; }
 
     private:
-        std::shared_ptr<T> ptr_;
+        T*    value_ = nullptr;
+        Slot* slot_;
     };
 };
 
@@ -7,63 +7,134 @@
 
 // NB: This Registry works poorly when you have other namespaces.
 // Make all macro invocations from inside the at namespace.
+//
+// Registration only appends to a list, which keeps static initialization
+// cheap. The first lookup, or an explicit Freeze() once startup registration
+// is done, builds a frozen_map (a minimal perfect hash) of the entries, and
+// every later lookup is a hash, two reads and one key comparison. Registering
+// after that thaws the registry and the next lookup rebuilds it; like before,
+// registration must not race with lookups.
+#include <atomic>
 #include <functional>
+#include <iterator>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 #include "common/macros.h"
 #include "util/exception.h"
-#include "util/flat_hash.h"
+#include "util/frozen_map.h"
 
 namespace quarisma
 {
+namespace detail
+{
+/// Entries of a registry: appended by add(), looked up in a frozen_map
 template <class KeyType, typename Function>
-class Registry
+class registry_table
 {
 public:
-    Registry() = default;
+    void add(const KeyType& key, Function f)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.emplace_back(key, std::move(f));
+        frozen_.store(false, std::memory_order_release);
+    }
+
+    /// Builds the perfect hash of every entry added so far; the last entry of a key wins
+    void freeze() const
+    {
+        if (frozen_.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (frozen_.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (!pending_.empty())
+        {
+            std::vector<std::pair<KeyType, Function>> entries(table_.begin(), table_.end());
+            entries.insert(
+                entries.end(),
+                std::make_move_iterator(pending_.begin()),
+                std::make_move_iterator(pending_.end()));
+            table_ = frozen_map<KeyType, Function>(std::move(entries));
+            pending_.clear();
+            pending_.shrink_to_fit();
+        }
+        frozen_.store(true, std::memory_order_release);
+    }
 
-    void Register(const KeyType& key, Function f)
+    Function* find(const KeyType& key) const
     {
-        std::lock_guard<std::mutex> lock(register_mutex_);
-        registry_[key] = f;
+        freeze();
+        return table_.find(key);
     }
 
-    inline bool Has(const KeyType& key) { return (registry_.count(key) != 0); }
+    std::vector<KeyType> keys() const
+    {
+        freeze();
+        std::vector<KeyType> keys;
+        keys.reserve(table_.size());
+        for (const auto& it : table_)
+        {
+            keys.push_back(it.first);
+        }
+        return keys;
+    }
+
+private:
+    mutable frozen_map<KeyType, Function>             table_;
+    mutable std::vector<std::pair<KeyType, Function>> pending_;
+    mutable std::atomic<bool>                         frozen_{true};
+    mutable std::mutex                                mutex_;
+};
+}  // namespace detail
+
+template <class KeyType, typename Function>
+class Registry
+{
+public:
+    Registry() = default;
+
+    void Register(const KeyType& key, Function f) { registry_.add(key, std::move(f)); }
+
+    /**
+     * Builds the lookup table now rather than on the first lookup; call it
+     * once startup registration is done.
+     */
+    void Freeze() const { registry_.freeze(); }
+
+    inline bool Has(const KeyType& key) { return registry_.find(key) != nullptr; }
 
     template <class Arg1, class Arg2, class... Args>
     auto run(const KeyType& key, Arg1& arg1, Arg2* arg2, Args... args)
     {
-        QUARISMA_CHECK_DEBUG(registry_.count(key) != 0, "key ", key, " was not found");
-        return registry_[key](arg1, arg2, args...);
+        Function* const f = registry_.find(key);
+        QUARISMA_CHECK_DEBUG(f != nullptr, "key ", key, " was not found");
+        return (*f)(arg1, arg2, args...);
     }
 
     template <class Arg1, class Arg2, class... Args>
     auto run(const KeyType& key, Arg1& arg1, Arg2& arg2, Args... args)
     {
-        QUARISMA_CHECK_DEBUG(registry_.count(key) != 0, "key ", key, " was not found");
-        return registry_[key](arg1, arg2, args...);
+        Function* const f = registry_.find(key);
+        QUARISMA_CHECK_DEBUG(f != nullptr, "key ", key, " was not found");
+        return (*f)(arg1, arg2, args...);
     }
 
     /**
      * Returns the keys currently registered as a std::vector.
      */
-    std::vector<KeyType> Keys() const
-    {
-        std::vector<KeyType> keys;
-        for (const auto& it : registry_)
-        {
-            keys.push_back(it.first);
-        }
-        return keys;
-    }
+    std::vector<KeyType> Keys() const { return registry_.keys(); }
 
     Registry(const Registry&)                    = delete;
     Registry& operator=(const Registry& /*rhs*/) = delete;
 
 private:
-    quarisma_map<KeyType, Function> registry_{};
-    std::mutex                    register_mutex_;
+    detail::registry_table<KeyType, Function> registry_;
 };
 
 template <class KeyType, typename Function>
@@ -95,43 +166,37 @@ public:
 
     Registry() = default;
 
-    void Register(const KeyType& key, Function f)
-    {
-        std::lock_guard<std::mutex> lock(register_mutex_);
-        registry_[key] = f;
-    }
+    void Register(const KeyType& key, Function f) { registry_.add(key, std::move(f)); }
 
-    inline bool Has(const KeyType& key) { return (registry_.count(key) != 0); }
+    /**
+     * Builds the lookup table now rather than on the first lookup; call it
+     * once startup registration is done.
+     */
+    void Freeze() const { registry_.freeze(); }
+
+    inline bool Has(const KeyType& key) { return registry_.find(key) != nullptr; }
 
     ReturnType run(const KeyType& key, Args... args)
     {
-        if (registry_.count(key) == 0)
+        Function* const f = registry_.find(key);
+        if (f == nullptr)
         {
             // Returns nullptr if the key is not registered.
             return nullptr;
         }
-        return registry_[key](args...);
+        return (*f)(args...);
     }
 
     /**
      * Returns the keys currently registered as a std::vector.
      */
-    std::vector<KeyType> Keys() const
-    {
-        std::vector<KeyType> keys;
-        for (const auto& it : registry_)
-        {
-            keys.push_back(it.first);
-        }
-        return keys;
-    }
+    std::vector<KeyType> Keys() const { return registry_.keys(); }
 
     Registry(const Registry&)                    = delete;
     Registry& operator=(const Registry& /*rhs*/) = delete;
 
 private:
-    quarisma_map<KeyType, Function> registry_{};
-    std::mutex                    register_mutex_;
+    quarisma::detail::registry_table<KeyType, Function> registry_;
 };
 
 template <class KeyType, class ReturnType, class... Args>
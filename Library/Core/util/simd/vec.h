@@ -0,0 +1,120 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+/**
+ * @file vec.h
+ * @brief Portable SIMD vectors: quarisma::simd::vec<T, N>
+ *
+ * vec<T> holds as many lanes of T as the widest register enabled for the
+ * translation unit: AVX-512, AVX2, SSE2 or NEON, in that order. Other widths
+ * and lane types use the generic lane loop, so code written against vec
+ * compiles everywhere:
+ *
+ * @code
+ * using V = quarisma::simd::vec<double>;
+ * size_t i = 0;
+ * for (; i + V::size <= n; i += V::size)
+ * {
+ *     fma(V::loadu(x + i), V(a), V::loadu(y + i)).storeu(y + i);
+ * }
+ * fma(V::load_partial(x + i, n - i), V(a), V::load_partial(y + i, n - i))
+ *     .store_partial(y + i, n - i);
+ * @endcode
+ *
+ * The instruction set is the one the file is compiled with, so a kernel
+ * built once per capability by quarisma_add_dispatch_sources() gets the
+ * widest vec of each; see util/cpu_dispatch.h.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util/simd/vec_generic.h"
+#include "util/simd/vec_sse.h"
+#include "util/simd/vec_avx2.h"
+#include "util/simd/vec_avx512.h"
+#include "util/simd/vec_neon.h"
+#include "util/simd/vec_math.h"
+
+namespace quarisma
+{
+namespace simd
+{
+inline namespace QUARISMA_CPU_CAPABILITY
+{
+namespace detail
+{
+template <typename T>
+struct identity
+{
+    using type = T;
+};
+
+// Keeps the right operand out of deduction, so that scalars convert
+template <typename T>
+using identity_t = typename identity<T>::type;
+}  // namespace detail
+
+template <typename T, size_t N>
+vec<T, N>& operator+=(vec<T, N>& a, const detail::identity_t<vec<T, N>>& b) noexcept
+{
+    return a = a + b;
+}
+
+template <typename T, size_t N>
+vec<T, N>& operator-=(vec<T, N>& a, const detail::identity_t<vec<T, N>>& b) noexcept
+{
+    return a = a - b;
+}
+
+template <typename T, size_t N>
+vec<T, N>& operator*=(vec<T, N>& a, const detail::identity_t<vec<T, N>>& b) noexcept
+{
+    return a = a * b;
+}
+
+template <typename T, size_t N>
+vec<T, N>& operator/=(vec<T, N>& a, const detail::identity_t<vec<T, N>>& b) noexcept
+{
+    return a = a / b;
+}
+
+/**
+ * @brief Lanes of b where bit i of Mask is set, of a elsewhere
+ *
+ * The compile-time counterpart of select(); lane 0 is the lowest bit.
+ */
+template <uint64_t Mask, typename T, size_t N>
+vec<T, N> blend(const vec<T, N>& a, const vec<T, N>& b) noexcept
+{
+    static_assert(N <= 64, "blend() takes one mask bit per lane");
+
+    alignas(vec<T, N>::alignment) T lanes[N];
+    for (size_t i = 0; i < N; ++i)
+    {
+        lanes[i] = detail::mask_lane<T>(((Mask >> i) & 1) != 0);
+    }
+    return select(vec<T, N>::load(lanes), b, a);
+}
+
+}  // namespace QUARISMA_CPU_CAPABILITY
+}  // namespace simd
+}  // namespace quarisma
@@ -0,0 +1,259 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include "util/simd/vec_generic.h"
+#include "util/simd/vec_sse.h"
+
+#if defined(QUARISMA_SIMD_AVX2)
+
+#include <immintrin.h>
+
+namespace quarisma
+{
+namespace simd
+{
+inline namespace QUARISMA_CPU_CAPABILITY
+{
+
+/// 4 doubles in an AVX2 register
+template <>
+class vec<double, 4>
+{
+public:
+    using value_type                  = double;
+    using register_type               = __m256d;
+    static constexpr size_t size      = 4;
+    static constexpr size_t alignment = 32;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(double value) noexcept : v_(_mm256_set1_pd(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const double* p) noexcept { return _mm256_load_pd(p); }
+    static vec loadu(const double* p) noexcept { return _mm256_loadu_pd(p); }
+    static vec load_partial(const double* p, size_t count) noexcept
+    {
+        return _mm256_maskload_pd(p, lanes_below(count));
+    }
+
+    void store(double* p) const noexcept { _mm256_store_pd(p, v_); }
+    void storeu(double* p) const noexcept { _mm256_storeu_pd(p, v_); }
+    void store_partial(double* p, size_t count) const noexcept
+    {
+        _mm256_maskstore_pd(p, lanes_below(count), v_);
+    }
+
+    double operator[](size_t i) const noexcept
+    {
+        alignas(alignment) double lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return _mm256_add_pd(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return _mm256_sub_pd(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return _mm256_mul_pd(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return _mm256_div_pd(a, b); }
+    friend vec operator-(vec a) noexcept { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+
+    friend vec operator&(vec a, vec b) noexcept { return _mm256_and_pd(a, b); }
+    friend vec operator|(vec a, vec b) noexcept { return _mm256_or_pd(a, b); }
+    friend vec operator^(vec a, vec b) noexcept { return _mm256_xor_pd(a, b); }
+    friend vec and_not(vec a, vec b) noexcept { return _mm256_andnot_pd(b, a); }
+
+    friend vec operator==(vec a, vec b) noexcept { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    friend vec operator!=(vec a, vec b) noexcept { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+    friend vec operator<(vec a, vec b) noexcept { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    friend vec operator<=(vec a, vec b) noexcept { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    friend vec operator>(vec a, vec b) noexcept { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    friend vec operator>=(vec a, vec b) noexcept { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+
+    friend vec min(vec a, vec b) noexcept { return _mm256_min_pd(a, b); }
+    friend vec max(vec a, vec b) noexcept { return _mm256_max_pd(a, b); }
+    friend vec abs(vec a) noexcept { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    friend vec sqrt(vec a) noexcept { return _mm256_sqrt_pd(a); }
+    friend vec round(vec a) noexcept
+    {
+        return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+    friend vec fma(vec a, vec b, vec c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+    friend vec select(vec mask, vec a, vec b) noexcept { return _mm256_blendv_pd(b, a, mask); }
+
+    friend double reduce_add(vec a) noexcept
+    {
+        return reduce_add(vec<double, 2>(_mm_add_pd(low(a), high(a))));
+    }
+    friend double reduce_min(vec a) noexcept
+    {
+        return reduce_min(vec<double, 2>(_mm_min_pd(low(a), high(a))));
+    }
+    friend double reduce_max(vec a) noexcept
+    {
+        return reduce_max(vec<double, 2>(_mm_max_pd(low(a), high(a))));
+    }
+
+    friend vec pow2(vec n) noexcept
+    {
+        __m256i const biased = _mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(0x1p52 + 1023)));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52));
+    }
+
+    friend vec exponent(vec a) noexcept
+    {
+        __m256i const biased = _mm256_srli_epi64(_mm256_castpd_si256(a), 52);
+        __m256d const value  = _mm256_or_pd(_mm256_castsi256_pd(biased), _mm256_set1_pd(0x1p52));
+        return _mm256_sub_pd(value, _mm256_set1_pd(0x1p52 + 1023));
+    }
+
+    friend vec mantissa(vec a) noexcept
+    {
+        __m256d const fraction = _mm256_castsi256_pd(_mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+        return _mm256_or_pd(_mm256_and_pd(a, fraction), _mm256_set1_pd(1.0));
+    }
+
+private:
+    static __m256i lanes_below(size_t count) noexcept
+    {
+        return _mm256_cmpgt_epi64(
+            _mm256_set1_epi64x(static_cast<int64_t>(count)), _mm256_set_epi64x(3, 2, 1, 0));
+    }
+
+    static __m128d low(vec a) noexcept { return _mm256_castpd256_pd128(a); }
+    static __m128d high(vec a) noexcept { return _mm256_extractf128_pd(a, 1); }
+
+    register_type v_;
+};
+
+/// 8 floats in an AVX2 register
+template <>
+class vec<float, 8>
+{
+public:
+    using value_type                  = float;
+    using register_type               = __m256;
+    static constexpr size_t size      = 8;
+    static constexpr size_t alignment = 32;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(float value) noexcept : v_(_mm256_set1_ps(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const float* p) noexcept { return _mm256_load_ps(p); }
+    static vec loadu(const float* p) noexcept { return _mm256_loadu_ps(p); }
+    static vec load_partial(const float* p, size_t count) noexcept
+    {
+        return _mm256_maskload_ps(p, lanes_below(count));
+    }
+
+    void store(float* p) const noexcept { _mm256_store_ps(p, v_); }
+    void storeu(float* p) const noexcept { _mm256_storeu_ps(p, v_); }
+    void store_partial(float* p, size_t count) const noexcept
+    {
+        _mm256_maskstore_ps(p, lanes_below(count), v_);
+    }
+
+    float operator[](size_t i) const noexcept
+    {
+        alignas(alignment) float lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return _mm256_add_ps(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return _mm256_sub_ps(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return _mm256_mul_ps(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return _mm256_div_ps(a, b); }
+    friend vec operator-(vec a) noexcept { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+
+    friend vec operator&(vec a, vec b) noexcept { return _mm256_and_ps(a, b); }
+    friend vec operator|(vec a, vec b) noexcept { return _mm256_or_ps(a, b); }
+    friend vec operator^(vec a, vec b) noexcept { return _mm256_xor_ps(a, b); }
+    friend vec and_not(vec a, vec b) noexcept { return _mm256_andnot_ps(b, a); }
+
+    friend vec operator==(vec a, vec b) noexcept { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    friend vec operator!=(vec a, vec b) noexcept { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+    friend vec operator<(vec a, vec b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    friend vec operator<=(vec a, vec b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    friend vec operator>(vec a, vec b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    friend vec operator>=(vec a, vec b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+
+    friend vec min(vec a, vec b) noexcept { return _mm256_min_ps(a, b); }
+    friend vec max(vec a, vec b) noexcept { return _mm256_max_ps(a, b); }
+    friend vec abs(vec a) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    friend vec sqrt(vec a) noexcept { return _mm256_sqrt_ps(a); }
+    friend vec round(vec a) noexcept
+    {
+        return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+    friend vec fma(vec a, vec b, vec c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+    friend vec select(vec mask, vec a, vec b) noexcept { return _mm256_blendv_ps(b, a, mask); }
+
+    friend float reduce_add(vec a) noexcept
+    {
+        return reduce_add(vec<float, 4>(_mm_add_ps(low(a), high(a))));
+    }
+    friend float reduce_min(vec a) noexcept
+    {
+        return reduce_min(vec<float, 4>(_mm_min_ps(low(a), high(a))));
+    }
+    friend float reduce_max(vec a) noexcept
+    {
+        return reduce_max(vec<float, 4>(_mm_max_ps(low(a), high(a))));
+    }
+
+    friend vec pow2(vec n) noexcept
+    {
+        __m256i const biased = _mm256_castps_si256(_mm256_add_ps(n, _mm256_set1_ps(0x1p23f + 127)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(biased, 23));
+    }
+
+    friend vec exponent(vec a) noexcept
+    {
+        __m256i const biased = _mm256_srli_epi32(_mm256_castps_si256(a), 23);
+        return _mm256_sub_ps(_mm256_cvtepi32_ps(biased), _mm256_set1_ps(127.0f));
+    }
+
+    friend vec mantissa(vec a) noexcept
+    {
+        __m256 const fraction = _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF));
+        return _mm256_or_ps(_mm256_and_ps(a, fraction), _mm256_set1_ps(1.0f));
+    }
+
+private:
+    static __m256i lanes_below(size_t count) noexcept
+    {
+        return _mm256_cmpgt_epi32(
+            _mm256_set1_epi32(static_cast<int>(count)), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+
+    static __m128 low(vec a) noexcept { return _mm256_castps256_ps128(a); }
+    static __m128 high(vec a) noexcept { return _mm256_extractf128_ps(a, 1); }
+
+    register_type v_;
+};
+
+}  // namespace QUARISMA_CPU_CAPABILITY
+}  // namespace simd
+}  // namespace quarisma
+
+#endif  // QUARISMA_SIMD_AVX2
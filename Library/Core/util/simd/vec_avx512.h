@@ -0,0 +1,254 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include "util/simd/vec_avx2.h"
+#include "util/simd/vec_generic.h"
+
+#if defined(QUARISMA_SIMD_AVX512)
+
+#include <immintrin.h>
+
+namespace quarisma
+{
+namespace simd
+{
+inline namespace QUARISMA_CPU_CAPABILITY
+{
+
+/// 8 doubles in an AVX-512 register; comparisons go through mask registers
+template <>
+class vec<double, 8>
+{
+public:
+    using value_type                  = double;
+    using register_type               = __m512d;
+    static constexpr size_t size      = 8;
+    static constexpr size_t alignment = 64;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(double value) noexcept : v_(_mm512_set1_pd(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const double* p) noexcept { return _mm512_load_pd(p); }
+    static vec loadu(const double* p) noexcept { return _mm512_loadu_pd(p); }
+    static vec load_partial(const double* p, size_t count) noexcept
+    {
+        return _mm512_maskz_loadu_pd(lanes_below(count), p);
+    }
+
+    void store(double* p) const noexcept { _mm512_store_pd(p, v_); }
+    void storeu(double* p) const noexcept { _mm512_storeu_pd(p, v_); }
+    void store_partial(double* p, size_t count) const noexcept
+    {
+        _mm512_mask_storeu_pd(p, lanes_below(count), v_);
+    }
+
+    double operator[](size_t i) const noexcept
+    {
+        alignas(alignment) double lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return _mm512_add_pd(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return _mm512_sub_pd(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return _mm512_mul_pd(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return _mm512_div_pd(a, b); }
+    friend vec operator-(vec a) noexcept { return _mm512_xor_pd(a, _mm512_set1_pd(-0.0)); }
+
+    friend vec operator&(vec a, vec b) noexcept { return _mm512_and_pd(a, b); }
+    friend vec operator|(vec a, vec b) noexcept { return _mm512_or_pd(a, b); }
+    friend vec operator^(vec a, vec b) noexcept { return _mm512_xor_pd(a, b); }
+    friend vec and_not(vec a, vec b) noexcept { return _mm512_andnot_pd(b, a); }
+
+    friend vec operator==(vec a, vec b) noexcept { return compare<_CMP_EQ_OQ>(a, b); }
+    friend vec operator!=(vec a, vec b) noexcept { return compare<_CMP_NEQ_UQ>(a, b); }
+    friend vec operator<(vec a, vec b) noexcept { return compare<_CMP_LT_OQ>(a, b); }
+    friend vec operator<=(vec a, vec b) noexcept { return compare<_CMP_LE_OQ>(a, b); }
+    friend vec operator>(vec a, vec b) noexcept { return compare<_CMP_GT_OQ>(a, b); }
+    friend vec operator>=(vec a, vec b) noexcept { return compare<_CMP_GE_OQ>(a, b); }
+
+    friend vec min(vec a, vec b) noexcept { return _mm512_min_pd(a, b); }
+    friend vec max(vec a, vec b) noexcept { return _mm512_max_pd(a, b); }
+    friend vec abs(vec a) noexcept { return _mm512_abs_pd(a); }
+    friend vec sqrt(vec a) noexcept { return _mm512_sqrt_pd(a); }
+    friend vec round(vec a) noexcept
+    {
+        return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+    friend vec fma(vec a, vec b, vec c) noexcept { return _mm512_fmadd_pd(a, b, c); }
+    friend vec select(vec mask, vec a, vec b) noexcept
+    {
+        return _mm512_mask_blend_pd(_mm512_movepi64_mask(_mm512_castpd_si512(mask)), b, a);
+    }
+
+    friend double reduce_add(vec a) noexcept
+    {
+        return reduce_add(vec<double, 4>(_mm256_add_pd(low(a), high(a))));
+    }
+    friend double reduce_min(vec a) noexcept
+    {
+        return reduce_min(vec<double, 4>(_mm256_min_pd(low(a), high(a))));
+    }
+    friend double reduce_max(vec a) noexcept
+    {
+        return reduce_max(vec<double, 4>(_mm256_max_pd(low(a), high(a))));
+    }
+
+    friend vec pow2(vec n) noexcept { return _mm512_scalef_pd(_mm512_set1_pd(1.0), n); }
+    friend vec exponent(vec a) noexcept { return _mm512_getexp_pd(a); }
+    friend vec mantissa(vec a) noexcept
+    {
+        return _mm512_getmant_pd(a, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+    }
+
+private:
+    static __mmask8 lanes_below(size_t count) noexcept
+    {
+        return count >= size ? static_cast<__mmask8>(~0u)
+                             : static_cast<__mmask8>((1u << count) - 1);
+    }
+
+    template <int Predicate>
+    static vec compare(vec a, vec b) noexcept
+    {
+        return _mm512_castsi512_pd(_mm512_movm_epi64(_mm512_cmp_pd_mask(a, b, Predicate)));
+    }
+
+    static __m256d low(vec a) noexcept { return _mm512_castpd512_pd256(a); }
+    static __m256d high(vec a) noexcept { return _mm512_extractf64x4_pd(a, 1); }
+
+    register_type v_;
+};
+
+/// 16 floats in an AVX-512 register; comparisons go through mask registers
+template <>
+class vec<float, 16>
+{
+public:
+    using value_type                  = float;
+    using register_type               = __m512;
+    static constexpr size_t size      = 16;
+    static constexpr size_t alignment = 64;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(float value) noexcept : v_(_mm512_set1_ps(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const float* p) noexcept { return _mm512_load_ps(p); }
+    static vec loadu(const float* p) noexcept { return _mm512_loadu_ps(p); }
+    static vec load_partial(const float* p, size_t count) noexcept
+    {
+        return _mm512_maskz_loadu_ps(lanes_below(count), p);
+    }
+
+    void store(float* p) const noexcept { _mm512_store_ps(p, v_); }
+    void storeu(float* p) const noexcept { _mm512_storeu_ps(p, v_); }
+    void store_partial(float* p, size_t count) const noexcept
+    {
+        _mm512_mask_storeu_ps(p, lanes_below(count), v_);
+    }
+
+    float operator[](size_t i) const noexcept
+    {
+        alignas(alignment) float lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return _mm512_add_ps(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return _mm512_sub_ps(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return _mm512_mul_ps(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return _mm512_div_ps(a, b); }
+    friend vec operator-(vec a) noexcept { return _mm512_xor_ps(a, _mm512_set1_ps(-0.0f)); }
+
+    friend vec operator&(vec a, vec b) noexcept { return _mm512_and_ps(a, b); }
+    friend vec operator|(vec a, vec b) noexcept { return _mm512_or_ps(a, b); }
+    friend vec operator^(vec a, vec b) noexcept { return _mm512_xor_ps(a, b); }
+    friend vec and_not(vec a, vec b) noexcept { return _mm512_andnot_ps(b, a); }
+
+    friend vec operator==(vec a, vec b) noexcept { return compare<_CMP_EQ_OQ>(a, b); }
+    friend vec operator!=(vec a, vec b) noexcept { return compare<_CMP_NEQ_UQ>(a, b); }
+    friend vec operator<(vec a, vec b) noexcept { return compare<_CMP_LT_OQ>(a, b); }
+    friend vec operator<=(vec a, vec b) noexcept { return compare<_CMP_LE_OQ>(a, b); }
+    friend vec operator>(vec a, vec b) noexcept { return compare<_CMP_GT_OQ>(a, b); }
+    friend vec operator>=(vec a, vec b) noexcept { return compare<_CMP_GE_OQ>(a, b); }
+
+    friend vec min(vec a, vec b) noexcept { return _mm512_min_ps(a, b); }
+    friend vec max(vec a, vec b) noexcept { return _mm512_max_ps(a, b); }
+    friend vec abs(vec a) noexcept { return _mm512_abs_ps(a); }
+    friend vec sqrt(vec a) noexcept { return _mm512_sqrt_ps(a); }
+    friend vec round(vec a) noexcept
+    {
+        return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+    friend vec fma(vec a, vec b, vec c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+    friend vec select(vec mask, vec a, vec b) noexcept
+    {
+        return _mm512_mask_blend_ps(_mm512_movepi32_mask(_mm512_castps_si512(mask)), b, a);
+    }
+
+    friend float reduce_add(vec a) noexcept
+    {
+        return reduce_add(vec<float, 8>(_mm256_add_ps(low(a), high(a))));
+    }
+    friend float reduce_min(vec a) noexcept
+    {
+        return reduce_min(vec<float, 8>(_mm256_min_ps(low(a), high(a))));
+    }
+    friend float reduce_max(vec a) noexcept
+    {
+        return reduce_max(vec<float, 8>(_mm256_max_ps(low(a), high(a))));
+    }
+
+    friend vec pow2(vec n) noexcept { return _mm512_scalef_ps(_mm512_set1_ps(1.0f), n); }
+    friend vec exponent(vec a) noexcept { return _mm512_getexp_ps(a); }
+    friend vec mantissa(vec a) noexcept
+    {
+        return _mm512_getmant_ps(a, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+    }
+
+private:
+    static __mmask16 lanes_below(size_t count) noexcept
+    {
+        return count >= size ? static_cast<__mmask16>(~0u)
+                             : static_cast<__mmask16>((1u << count) - 1);
+    }
+
+    template <int Predicate>
+    static vec compare(vec a, vec b) noexcept
+    {
+        return _mm512_castsi512_ps(_mm512_movm_epi32(_mm512_cmp_ps_mask(a, b, Predicate)));
+    }
+
+    static __m256 low(vec a) noexcept { return _mm512_castps512_ps256(a); }
+    static __m256 high(vec a) noexcept { return _mm512_extractf32x8_ps(a, 1); }
+
+    register_type v_;
+};
+
+}  // namespace QUARISMA_CPU_CAPABILITY
+}  // namespace simd
+}  // namespace quarisma
+
+#endif  // QUARISMA_SIMD_AVX512
@@ -0,0 +1,395 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "common/macros.h"
+#include "util/cpu_dispatch.h"
+
+// Instruction sets enabled for this translation unit; several can be set at once
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+#define QUARISMA_SIMD_AVX512 1
+#endif
+#if defined(__AVX2__) && (defined(__FMA__) || (defined(_MSC_VER) && !defined(__clang__)))
+#define QUARISMA_SIMD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUARISMA_SIMD_SSE2 1
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define QUARISMA_SIMD_NEON 1
+#endif
+
+namespace quarisma
+{
+namespace simd
+{
+// Every definition depends on the compiler flags, so each cpu_capability gets its own copy
+inline namespace QUARISMA_CPU_CAPABILITY
+{
+
+/// Bytes of the widest register enabled; bytes of the generic fallback otherwise
+#if defined(QUARISMA_SIMD_AVX512)
+inline constexpr size_t native_bytes = 64;
+#elif defined(QUARISMA_SIMD_AVX2)
+inline constexpr size_t native_bytes = 32;
+#else
+inline constexpr size_t native_bytes = 16;
+#endif
+
+/// Lanes of T in the widest register enabled
+template <typename T>
+inline constexpr size_t native_lanes = native_bytes / sizeof(T) != 0 ? native_bytes / sizeof(T) : 1;
+
+template <typename T, size_t N = native_lanes<T>>
+class vec;
+
+namespace detail
+{
+template <size_t Bytes>
+struct unsigned_of_size;
+
+template <>
+struct unsigned_of_size<1>
+{
+    using type = uint8_t;
+};
+
+template <>
+struct unsigned_of_size<2>
+{
+    using type = uint16_t;
+};
+
+template <>
+struct unsigned_of_size<4>
+{
+    using type = uint32_t;
+};
+
+template <>
+struct unsigned_of_size<8>
+{
+    using type = uint64_t;
+};
+
+template <typename T>
+using bits_t = typename unsigned_of_size<sizeof(T)>::type;
+
+template <typename T>
+bits_t<T> to_bits(T value) noexcept
+{
+    bits_t<T> bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+
+template <typename T>
+T from_bits(bits_t<T> bits) noexcept
+{
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+/// Lane of a comparison result: every bit set when true
+template <typename T>
+T mask_lane(bool set) noexcept
+{
+    return from_bits<T>(set ? static_cast<bits_t<T>>(~bits_t<T>{0}) : bits_t<T>{0});
+}
+
+constexpr size_t generic_alignment(size_t bytes, size_t lane_alignment) noexcept
+{
+    return (bytes & (bytes - 1)) == 0 && bytes <= QUARISMA_ALIGNMENT ? bytes : lane_alignment;
+}
+}  // namespace detail
+
+/**
+ * @brief N lanes of T, the scalar fallback of every width without a register type
+ *
+ * The backends (vec_sse.h, vec_avx2.h, vec_avx512.h, vec_neon.h) specialize
+ * the float and double widths of their registers with the same interface;
+ * this loops over the lanes, which the compiler usually vectorizes anyway.
+ *
+ * Comparisons return a mask vector, with every bit of a lane set when true,
+ * which select() and the bitwise operators consume. Floating-point only:
+ * division, sqrt, round, pow2, exponent and mantissa.
+ */
+template <typename T, size_t N>
+class vec
+{
+    static_assert(std::is_arithmetic_v<T> && N > 0, "vec holds arithmetic lanes");
+
+public:
+    using value_type                  = T;
+    static constexpr size_t size      = N;
+    static constexpr size_t alignment = detail::generic_alignment(N * sizeof(T), alignof(T));
+
+    vec() noexcept = default;
+
+    /** Broadcasts value to every lane. */
+    vec(T value) noexcept { std::fill(lanes_, lanes_ + N, value); }
+
+    /** Loads from p, aligned to alignment. */
+    static vec load(const T* p) noexcept { return loadu(p); }
+
+    static vec loadu(const T* p) noexcept
+    {
+        vec result;
+        std::memcpy(result.lanes_, p, sizeof(result.lanes_));
+        return result;
+    }
+
+    /** Loads the first count lanes, count <= size; the others are zero, p[count..] is not read. */
+    static vec load_partial(const T* p, size_t count) noexcept
+    {
+        vec result(T{0});
+        std::copy_n(p, count, result.lanes_);
+        return result;
+    }
+
+    void store(T* p) const noexcept { storeu(p); }
+
+    void storeu(T* p) const noexcept { std::memcpy(p, lanes_, sizeof(lanes_)); }
+
+    /** Stores the first count lanes, count <= size; p[count..] is not written. */
+    void store_partial(T* p, size_t count) const noexcept
+    {
+        std::copy_n(lanes_, count, p);
+    }
+
+    T operator[](size_t i) const noexcept { return lanes_[i]; }
+
+    friend vec operator+(const vec& a, const vec& b) noexcept
+    {
+        return apply(a, b, [](T x, T y) { return static_cast<T>(x + y); });
+    }
+
+    friend vec operator-(const vec& a, const vec& b) noexcept
+    {
+        return apply(a, b, [](T x, T y) { return static_cast<T>(x - y); });
+    }
+
+    friend vec operator*(const vec& a, const vec& b) noexcept
+    {
+        return apply(a, b, [](T x, T y) { return static_cast<T>(x * y); });
+    }
+
+    friend vec operator/(const vec& a, const vec& b) noexcept
+    {
+        return apply(a, b, [](T x, T y) { return static_cast<T>(x / y); });
+    }
+
+    friend vec operator-(const vec& a) noexcept { return vec(T{0}) - a; }
+
+    friend vec operator&(const vec& a, const vec& b) noexcept
+    {
+        return apply_bits(a, b, [](auto x, auto y) { return x & y; });
+    }
+
+    friend vec operator|(const vec& a, const vec& b) noexcept
+    {
+        return apply_bits(a, b, [](auto x, auto y) { return x | y; });
+    }
+
+    friend vec operator^(const vec& a, const vec& b) noexcept
+    {
+        return apply_bits(a, b, [](auto x, auto y) { return x ^ y; });
+    }
+
+    /** a & ~b, lane by lane. */
+    friend vec and_not(const vec& a, const vec& b) noexcept
+    {
+        return apply_bits(a, b, [](auto x, auto y) { return x & ~y; });
+    }
+
+    friend vec operator==(const vec& a, const vec& b) noexcept
+    {
+        return compare(a, b, [](T x, T y) { return x == y; });
+    }
+
+    friend vec operator!=(const vec& a, const vec& b) noexcept
+    {
+        return compare(a, b, [](T x, T y) { return x != y; });
+    }
+
+    friend vec operator<(const vec& a, const vec& b) noexcept
+    {
+        return compare(a, b, [](T x, T y) { return x < y; });
+    }
+
+    friend vec operator<=(const vec& a, const vec& b) noexcept
+    {
+        return compare(a, b, [](T x, T y) { return x <= y; });
+    }
+
+    friend vec operator>(const vec& a, const vec& b) noexcept
+    {
+        return compare(a, b, [](T x, T y) { return x > y; });
+    }
+
+    friend vec operator>=(const vec& a, const vec& b) noexcept
+    {
+        return compare(a, b, [](T x, T y) { return x >= y; });
+    }
+
+    friend vec min(const vec& a, const vec& b) noexcept
+    {
+        return apply(a, b, [](T x, T y) { return x < y ? x : y; });
+    }
+
+    friend vec max(const vec& a, const vec& b) noexcept
+    {
+        return apply(a, b, [](T x, T y) { return x > y ? x : y; });
+    }
+
+    friend vec abs(const vec& a) noexcept
+    {
+        return apply(
+            a,
+            a,
+            [](T x, T)
+            {
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    return std::fabs(x);
+                }
+                else
+                {
+                    return x < T{0} ? static_cast<T>(-x) : x;
+                }
+            });
+    }
+
+    friend vec sqrt(const vec& a) noexcept
+    {
+        return apply(a, a, [](T x, T) { return std::sqrt(x); });
+    }
+
+    /** Rounds to the nearest integer, ties to even. */
+    friend vec round(const vec& a) noexcept
+    {
+        return apply(a, a, [](T x, T) { return std::nearbyint(x); });
+    }
+
+    /** a * b + c, fused when the instruction set has it. */
+    friend vec fma(const vec& a, const vec& b, const vec& c) noexcept
+    {
+        vec result;
+        for (size_t i = 0; i < N; ++i)
+        {
+            result.lanes_[i] = static_cast<T>(a.lanes_[i] * b.lanes_[i] + c.lanes_[i]);
+        }
+        return result;
+    }
+
+    /** Lanes of a where mask is set, of b elsewhere. */
+    friend vec select(const vec& mask, const vec& a, const vec& b) noexcept
+    {
+        return (mask & a) | and_not(b, mask);
+    }
+
+    friend T reduce_add(const vec& a) noexcept
+    {
+        T sum = a.lanes_[0];
+        for (size_t i = 1; i < N; ++i)
+        {
+            sum = static_cast<T>(sum + a.lanes_[i]);
+        }
+        return sum;
+    }
+
+    friend T reduce_min(const vec& a) noexcept
+    {
+        return *std::min_element(a.lanes_, a.lanes_ + N);
+    }
+
+    friend T reduce_max(const vec& a) noexcept
+    {
+        return *std::max_element(a.lanes_, a.lanes_ + N);
+    }
+
+    /** 2^n for integral n within the normal exponent range. */
+    friend vec pow2(const vec& n) noexcept
+    {
+        return apply(n, n, [](T x, T) { return std::ldexp(T{1}, static_cast<int>(x)); });
+    }
+
+    /** floor(log2(a)) of positive normal a, as T. */
+    friend vec exponent(const vec& a) noexcept
+    {
+        return apply(a, a, [](T x, T) { return static_cast<T>(std::ilogb(x)); });
+    }
+
+    /** a / 2^exponent(a), in [1, 2), of positive normal a. */
+    friend vec mantissa(const vec& a) noexcept
+    {
+        // ilogb() of zero and NaN may be INT_MIN, which cannot be negated
+        return apply(
+            a,
+            a,
+            [](T x, T)
+            { return std::isfinite(x) && x != T{0} ? std::scalbn(x, -std::ilogb(x)) : x; });
+    }
+
+private:
+    template <typename F>
+    static vec apply(const vec& a, const vec& b, F f) noexcept
+    {
+        vec result;
+        for (size_t i = 0; i < N; ++i)
+        {
+            result.lanes_[i] = f(a.lanes_[i], b.lanes_[i]);
+        }
+        return result;
+    }
+
+    template <typename F>
+    static vec apply_bits(const vec& a, const vec& b, F f) noexcept
+    {
+        return apply(
+            a,
+            b,
+            [f](T x, T y)
+            {
+                return detail::from_bits<T>(
+                    static_cast<detail::bits_t<T>>(f(detail::to_bits(x), detail::to_bits(y))));
+            });
+    }
+
+    template <typename F>
+    static vec compare(const vec& a, const vec& b, F f) noexcept
+    {
+        return apply(a, b, [f](T x, T y) { return detail::mask_lane<T>(f(x, y)); });
+    }
+
+    alignas(alignment) T lanes_[N];
+};
+
+}  // namespace QUARISMA_CPU_CAPABILITY
+}  // namespace simd
+}  // namespace quarisma
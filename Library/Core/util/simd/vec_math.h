@@ -0,0 +1,269 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include "util/simd/vec_generic.h"
+
+namespace quarisma
+{
+namespace simd
+{
+inline namespace QUARISMA_CPU_CAPABILITY
+{
+namespace detail
+{
+template <typename T>
+struct math_constants;
+
+template <>
+struct math_constants<double>
+{
+    static constexpr double log2e        = 1.4426950408889634074;
+    // Cody-Waite split of ln(2): the low bits of ln2_hi are clear, so n * ln2_hi is exact
+    static constexpr double ln2_hi       = 6.93145751953125e-1;
+    static constexpr double ln2_lo       = 1.42860682030941723212e-6;
+    static constexpr double sqrt2        = 1.41421356237309504880;
+    static constexpr double exp_max      = 709.782712893384;    // ln(DBL_MAX)
+    static constexpr double exp_min      = -708.3964185322641;  // ln(DBL_MIN)
+    static constexpr double max_exponent = 1023;
+    static constexpr double min_normal   = std::numeric_limits<double>::min();
+    static constexpr double subnormal_scale          = 0x1p54;
+    static constexpr double subnormal_scale_exponent = 54;
+
+    // 1 / k!, for |r| <= ln(2) / 2
+    static constexpr double exp_terms[] = {
+        1.0,
+        1.0,
+        1.0 / 2,
+        1.0 / 6,
+        1.0 / 24,
+        1.0 / 120,
+        1.0 / 720,
+        1.0 / 5040,
+        1.0 / 40320,
+        1.0 / 362880,
+        1.0 / 3628800,
+        1.0 / 39916800,
+        1.0 / 479001600,
+    };
+
+    // 2 / (2k + 1): log(m) = 2 atanh(s) for s = (m - 1) / (m + 1), |s| <= 0.1716
+    static constexpr double log_terms[] = {
+        2.0,
+        2.0 / 3,
+        2.0 / 5,
+        2.0 / 7,
+        2.0 / 9,
+        2.0 / 11,
+        2.0 / 13,
+        2.0 / 15,
+        2.0 / 17,
+        2.0 / 19,
+        2.0 / 21,
+    };
+};
+
+template <>
+struct math_constants<float>
+{
+    static constexpr float log2e        = 1.44269504f;
+    static constexpr float ln2_hi       = 0.693359375f;
+    static constexpr float ln2_lo       = -2.12194440e-4f;
+    static constexpr float sqrt2        = 1.41421356f;
+    static constexpr float exp_max      = 88.7228394f;  // ln(FLT_MAX)
+    static constexpr float exp_min      = -87.3365479f;  // ln(FLT_MIN)
+    static constexpr float max_exponent = 127;
+    static constexpr float min_normal   = std::numeric_limits<float>::min();
+    static constexpr float subnormal_scale          = 0x1p25f;
+    static constexpr float subnormal_scale_exponent = 25;
+
+    static constexpr float exp_terms[] = {
+        1.0f,
+        1.0f,
+        1.0f / 2,
+        1.0f / 6,
+        1.0f / 24,
+        1.0f / 120,
+        1.0f / 720,
+        1.0f / 5040,
+    };
+
+    static constexpr float log_terms[] = {
+        2.0f,
+        2.0f / 3,
+        2.0f / 5,
+        2.0f / 7,
+        2.0f / 9,
+    };
+};
+
+/// c[0] + c[1] x + c[2] x^2 + ..., by Horner's rule
+template <typename V, typename T, size_t K>
+V polynomial(const V& x, const T (&c)[K]) noexcept
+{
+    V p(c[K - 1]);
+    for (size_t k = K - 1; k-- > 0;)
+    {
+        p = fma(p, x, V(c[k]));
+    }
+    return p;
+}
+
+// Taylor series of erf(x) / x in x^2: 2 / sqrt(pi) * (-1)^n / (n! (2n + 1))
+inline constexpr double erf_terms[] = {
+    1.1283791670955126,
+    -0.3761263890318375,
+    0.1128379167095513,
+    -0.02686617064513125,
+    0.005223977625442187,
+    -8.548327023450852e-4,
+    1.205533298178967e-4,
+    -1.492565035840625e-5,
+};
+
+// Numerical Recipes' erfc(x) = t exp(-x^2 + P(t)), t = 1 / (1 + x / 2)
+inline constexpr double erfc_terms[] = {
+    -1.26551223,
+    1.00002368,
+    0.37409196,
+    0.09678418,
+    -0.18628806,
+    0.27886807,
+    -1.13520398,
+    1.48851587,
+    -0.82215223,
+    0.17087277,
+};
+
+template <typename T, size_t K>
+struct coefficients
+{
+    template <typename Source>
+    constexpr explicit coefficients(const Source (&source)[K]) noexcept : c{}
+    {
+        for (size_t k = 0; k < K; ++k)
+        {
+            c[k] = static_cast<T>(source[k]);
+        }
+    }
+
+    T c[K];
+};
+}  // namespace detail
+
+/**
+ * @brief e^x, lane by lane
+ *
+ * Cody-Waite reduction to r = x - n ln(2), |r| <= ln(2) / 2, then a Taylor
+ * polynomial: within 2 ulp of std::exp. Results below the smallest normal
+ * number flush to zero; overflow gives infinity and NaN stays NaN.
+ */
+template <typename T, size_t N>
+vec<T, N> exp(const vec<T, N>& x) noexcept
+{
+    static_assert(std::is_floating_point_v<T>, "exp() needs floating-point lanes");
+    using V = vec<T, N>;
+    using C = detail::math_constants<T>;
+
+    V const clamped = min(max(x, V(C::exp_min)), V(C::exp_max));
+    V const n       = round(clamped * V(C::log2e));
+    V const r       = fma(n, V(-C::ln2_lo), fma(n, V(-C::ln2_hi), clamped));
+    V const p       = detail::polynomial(r, C::exp_terms);
+
+    // n reaches max_exponent + 1 just below exp_max
+    V const scale = pow2(min(n, V(C::max_exponent)));
+    V result      = p * scale * select(n > V(C::max_exponent), V(T{2}), V(T{1}));
+
+    result = select(x > V(C::exp_max), V(std::numeric_limits<T>::infinity()), result);
+    result = select(x < V(C::exp_min), V(T{0}), result);
+    return select(x != x, x, result);
+}
+
+/**
+ * @brief Natural logarithm, lane by lane
+ *
+ * x = m 2^e with m in [sqrt(1/2), sqrt(2)], then log(m) = 2 atanh((m - 1) /
+ * (m + 1)) by its series: within 2 ulp of std::log, subnormals included.
+ * log(0) is -infinity, log of a negative number NaN.
+ */
+template <typename T, size_t N>
+vec<T, N> log(const vec<T, N>& x) noexcept
+{
+    static_assert(std::is_floating_point_v<T>, "log() needs floating-point lanes");
+    using V = vec<T, N>;
+    using C = detail::math_constants<T>;
+
+    // Bring subnormals into the normal range that exponent() and mantissa() need
+    V const tiny   = x < V(C::min_normal);
+    V const scaled = select(tiny, x * V(C::subnormal_scale), x);
+    V       e      = exponent(scaled) - (tiny & V(C::subnormal_scale_exponent));
+    V       m      = mantissa(scaled);
+
+    V const high = m > V(C::sqrt2);
+    m            = select(high, m * V(T{0.5}), m);
+    e            = e + (high & V(T{1}));
+
+    V const f      = m - V(T{1});
+    V const s      = f / (f + V(T{2}));
+    V const log_m  = s * detail::polynomial(s * s, C::log_terms);
+    V       result = fma(e, V(C::ln2_hi), fma(e, V(C::ln2_lo), log_m));
+
+    result = select(x == V(T{0}), V(-std::numeric_limits<T>::infinity()), result);
+    result = select(x < V(T{0}), V(std::numeric_limits<T>::quiet_NaN()), result);
+    result = select(x == V(std::numeric_limits<T>::infinity()), x, result);
+    return select(x != x, x, result);
+}
+
+/**
+ * @brief Error function, lane by lane
+ *
+ * A Taylor series below 0.5 and Numerical Recipes' Chebyshev fit of erfc
+ * above: absolute error below 2e-7 for float and double alike. Use std::erf
+ * where double precision matters.
+ */
+template <typename T, size_t N>
+vec<T, N> erf(const vec<T, N>& x) noexcept
+{
+    static_assert(std::is_floating_point_v<T>, "erf() needs floating-point lanes");
+    using V = vec<T, N>;
+
+    static constexpr detail::coefficients<T, std::size(detail::erf_terms)> erf_terms(
+        detail::erf_terms);
+    static constexpr detail::coefficients<T, std::size(detail::erfc_terms)> erfc_terms(
+        detail::erfc_terms);
+
+    V const a     = abs(x);
+    V const small = x * detail::polynomial(x * x, erf_terms.c);
+
+    V const t     = V(T{1}) / fma(a, V(T{0.5}), V(T{1}));
+    V const erfc  = t * exp(fma(-a, a, detail::polynomial(t, erfc_terms.c)));
+    V const large = (V(T{1}) - erfc) | (x & V(T{-0.0}));
+
+    return select(x != x, x, select(a < V(T{0.5}), small, large));
+}
+
+}  // namespace QUARISMA_CPU_CAPABILITY
+}  // namespace simd
+}  // namespace quarisma
@@ -0,0 +1,232 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include "util/simd/vec_generic.h"
+
+#if defined(QUARISMA_SIMD_NEON)
+
+#include <arm_neon.h>
+
+namespace quarisma
+{
+namespace simd
+{
+inline namespace QUARISMA_CPU_CAPABILITY
+{
+
+/// 2 doubles in a NEON register (AArch64)
+template <>
+class vec<double, 2>
+{
+public:
+    using value_type                  = double;
+    using register_type               = float64x2_t;
+    static constexpr size_t size      = 2;
+    static constexpr size_t alignment = 16;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(double value) noexcept : v_(vdupq_n_f64(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const double* p) noexcept { return vld1q_f64(p); }
+    static vec loadu(const double* p) noexcept { return vld1q_f64(p); }
+    static vec load_partial(const double* p, size_t count) noexcept
+    {
+        alignas(alignment) double lanes[size] = {};
+        std::copy_n(p, std::min(count, size), lanes);
+        return load(lanes);
+    }
+
+    void store(double* p) const noexcept { vst1q_f64(p, v_); }
+    void storeu(double* p) const noexcept { vst1q_f64(p, v_); }
+    void store_partial(double* p, size_t count) const noexcept
+    {
+        alignas(alignment) double lanes[size];
+        store(lanes);
+        std::copy_n(lanes, std::min(count, size), p);
+    }
+
+    double operator[](size_t i) const noexcept
+    {
+        alignas(alignment) double lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return vaddq_f64(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return vsubq_f64(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return vmulq_f64(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return vdivq_f64(a, b); }
+    friend vec operator-(vec a) noexcept { return vnegq_f64(a); }
+
+    friend vec operator&(vec a, vec b) noexcept { return from_bits(vandq_u64(bits(a), bits(b))); }
+    friend vec operator|(vec a, vec b) noexcept { return from_bits(vorrq_u64(bits(a), bits(b))); }
+    friend vec operator^(vec a, vec b) noexcept { return from_bits(veorq_u64(bits(a), bits(b))); }
+    friend vec and_not(vec a, vec b) noexcept { return from_bits(vbicq_u64(bits(a), bits(b))); }
+
+    friend vec operator==(vec a, vec b) noexcept { return from_bits(vceqq_f64(a, b)); }
+    friend vec operator!=(vec a, vec b) noexcept
+    {
+        return from_bits(vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(vceqq_f64(a, b)))));
+    }
+    friend vec operator<(vec a, vec b) noexcept { return from_bits(vcltq_f64(a, b)); }
+    friend vec operator<=(vec a, vec b) noexcept { return from_bits(vcleq_f64(a, b)); }
+    friend vec operator>(vec a, vec b) noexcept { return from_bits(vcgtq_f64(a, b)); }
+    friend vec operator>=(vec a, vec b) noexcept { return from_bits(vcgeq_f64(a, b)); }
+
+    friend vec min(vec a, vec b) noexcept { return vminq_f64(a, b); }
+    friend vec max(vec a, vec b) noexcept { return vmaxq_f64(a, b); }
+    friend vec abs(vec a) noexcept { return vabsq_f64(a); }
+    friend vec sqrt(vec a) noexcept { return vsqrtq_f64(a); }
+    friend vec round(vec a) noexcept { return vrndnq_f64(a); }
+    friend vec fma(vec a, vec b, vec c) noexcept { return vfmaq_f64(c, a, b); }
+    friend vec select(vec mask, vec a, vec b) noexcept { return vbslq_f64(bits(mask), a, b); }
+
+    friend double reduce_add(vec a) noexcept { return vaddvq_f64(a); }
+    friend double reduce_min(vec a) noexcept { return vminvq_f64(a); }
+    friend double reduce_max(vec a) noexcept { return vmaxvq_f64(a); }
+
+    friend vec pow2(vec n) noexcept
+    {
+        auto const biased = bits(vaddq_f64(n, vdupq_n_f64(0x1p52 + 1023)));
+        return from_bits(vshlq_n_u64(biased, 52));
+    }
+
+    friend vec exponent(vec a) noexcept
+    {
+        auto const biased = vshrq_n_u64(bits(a), 52);
+        return vsubq_f64(vcvtq_f64_u64(biased), vdupq_n_f64(1023));
+    }
+
+    friend vec mantissa(vec a) noexcept
+    {
+        auto const fraction = vandq_u64(bits(a), vdupq_n_u64(0x000FFFFFFFFFFFFFULL));
+        return from_bits(vorrq_u64(fraction, bits(vdupq_n_f64(1.0))));
+    }
+
+private:
+    static uint64x2_t bits(vec a) noexcept { return vreinterpretq_u64_f64(a); }
+    static vec from_bits(uint64x2_t a) noexcept { return vreinterpretq_f64_u64(a); }
+
+    register_type v_;
+};
+
+/// 4 floats in a NEON register (AArch64)
+template <>
+class vec<float, 4>
+{
+public:
+    using value_type                  = float;
+    using register_type               = float32x4_t;
+    static constexpr size_t size      = 4;
+    static constexpr size_t alignment = 16;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(float value) noexcept : v_(vdupq_n_f32(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const float* p) noexcept { return vld1q_f32(p); }
+    static vec loadu(const float* p) noexcept { return vld1q_f32(p); }
+    static vec load_partial(const float* p, size_t count) noexcept
+    {
+        alignas(alignment) float lanes[size] = {};
+        std::copy_n(p, std::min(count, size), lanes);
+        return load(lanes);
+    }
+
+    void store(float* p) const noexcept { vst1q_f32(p, v_); }
+    void storeu(float* p) const noexcept { vst1q_f32(p, v_); }
+    void store_partial(float* p, size_t count) const noexcept
+    {
+        alignas(alignment) float lanes[size];
+        store(lanes);
+        std::copy_n(lanes, std::min(count, size), p);
+    }
+
+    float operator[](size_t i) const noexcept
+    {
+        alignas(alignment) float lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return vaddq_f32(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return vsubq_f32(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return vmulq_f32(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return vdivq_f32(a, b); }
+    friend vec operator-(vec a) noexcept { return vnegq_f32(a); }
+
+    friend vec operator&(vec a, vec b) noexcept { return from_bits(vandq_u32(bits(a), bits(b))); }
+    friend vec operator|(vec a, vec b) noexcept { return from_bits(vorrq_u32(bits(a), bits(b))); }
+    friend vec operator^(vec a, vec b) noexcept { return from_bits(veorq_u32(bits(a), bits(b))); }
+    friend vec and_not(vec a, vec b) noexcept { return from_bits(vbicq_u32(bits(a), bits(b))); }
+
+    friend vec operator==(vec a, vec b) noexcept { return from_bits(vceqq_f32(a, b)); }
+    friend vec operator!=(vec a, vec b) noexcept { return from_bits(vmvnq_u32(vceqq_f32(a, b))); }
+    friend vec operator<(vec a, vec b) noexcept { return from_bits(vcltq_f32(a, b)); }
+    friend vec operator<=(vec a, vec b) noexcept { return from_bits(vcleq_f32(a, b)); }
+    friend vec operator>(vec a, vec b) noexcept { return from_bits(vcgtq_f32(a, b)); }
+    friend vec operator>=(vec a, vec b) noexcept { return from_bits(vcgeq_f32(a, b)); }
+
+    friend vec min(vec a, vec b) noexcept { return vminq_f32(a, b); }
+    friend vec max(vec a, vec b) noexcept { return vmaxq_f32(a, b); }
+    friend vec abs(vec a) noexcept { return vabsq_f32(a); }
+    friend vec sqrt(vec a) noexcept { return vsqrtq_f32(a); }
+    friend vec round(vec a) noexcept { return vrndnq_f32(a); }
+    friend vec fma(vec a, vec b, vec c) noexcept { return vfmaq_f32(c, a, b); }
+    friend vec select(vec mask, vec a, vec b) noexcept { return vbslq_f32(bits(mask), a, b); }
+
+    friend float reduce_add(vec a) noexcept { return vaddvq_f32(a); }
+    friend float reduce_min(vec a) noexcept { return vminvq_f32(a); }
+    friend float reduce_max(vec a) noexcept { return vmaxvq_f32(a); }
+
+    friend vec pow2(vec n) noexcept
+    {
+        auto const biased = bits(vaddq_f32(n, vdupq_n_f32(0x1p23f + 127)));
+        return from_bits(vshlq_n_u32(biased, 23));
+    }
+
+    friend vec exponent(vec a) noexcept
+    {
+        auto const biased = vshrq_n_u32(bits(a), 23);
+        return vsubq_f32(vcvtq_f32_u32(biased), vdupq_n_f32(127));
+    }
+
+    friend vec mantissa(vec a) noexcept
+    {
+        auto const fraction = vandq_u32(bits(a), vdupq_n_u32(0x007FFFFFu));
+        return from_bits(vorrq_u32(fraction, bits(vdupq_n_f32(1.0f))));
+    }
+
+private:
+    static uint32x4_t bits(vec a) noexcept { return vreinterpretq_u32_f32(a); }
+    static vec from_bits(uint32x4_t a) noexcept { return vreinterpretq_f32_u32(a); }
+
+    register_type v_;
+};
+
+}  // namespace QUARISMA_CPU_CAPABILITY
+}  // namespace simd
+}  // namespace quarisma
+
+#endif  // QUARISMA_SIMD_NEON
@@ -0,0 +1,312 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include "util/simd/vec_generic.h"
+
+#if defined(QUARISMA_SIMD_SSE2)
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+#define QUARISMA_SIMD_SSE41 1
+#else
+#include <emmintrin.h>
+#endif
+#if defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace quarisma
+{
+namespace simd
+{
+inline namespace QUARISMA_CPU_CAPABILITY
+{
+
+/// 2 doubles in an SSE2 register; SSE4.1 and FMA are used when enabled
+template <>
+class vec<double, 2>
+{
+public:
+    using value_type                  = double;
+    using register_type               = __m128d;
+    static constexpr size_t size      = 2;
+    static constexpr size_t alignment = 16;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(double value) noexcept : v_(_mm_set1_pd(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const double* p) noexcept { return _mm_load_pd(p); }
+    static vec loadu(const double* p) noexcept { return _mm_loadu_pd(p); }
+    static vec load_partial(const double* p, size_t count) noexcept
+    {
+        return count >= 2 ? _mm_loadu_pd(p) : count == 1 ? _mm_load_sd(p) : _mm_setzero_pd();
+    }
+
+    void store(double* p) const noexcept { _mm_store_pd(p, v_); }
+    void storeu(double* p) const noexcept { _mm_storeu_pd(p, v_); }
+    void store_partial(double* p, size_t count) const noexcept
+    {
+        if (count >= 2)
+        {
+            _mm_storeu_pd(p, v_);
+        }
+        else if (count == 1)
+        {
+            _mm_store_sd(p, v_);
+        }
+    }
+
+    double operator[](size_t i) const noexcept
+    {
+        alignas(alignment) double lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return _mm_add_pd(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return _mm_sub_pd(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return _mm_mul_pd(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return _mm_div_pd(a, b); }
+    friend vec operator-(vec a) noexcept { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+
+    friend vec operator&(vec a, vec b) noexcept { return _mm_and_pd(a, b); }
+    friend vec operator|(vec a, vec b) noexcept { return _mm_or_pd(a, b); }
+    friend vec operator^(vec a, vec b) noexcept { return _mm_xor_pd(a, b); }
+    friend vec and_not(vec a, vec b) noexcept { return _mm_andnot_pd(b, a); }
+
+    friend vec operator==(vec a, vec b) noexcept { return _mm_cmpeq_pd(a, b); }
+    friend vec operator!=(vec a, vec b) noexcept { return _mm_cmpneq_pd(a, b); }
+    friend vec operator<(vec a, vec b) noexcept { return _mm_cmplt_pd(a, b); }
+    friend vec operator<=(vec a, vec b) noexcept { return _mm_cmple_pd(a, b); }
+    friend vec operator>(vec a, vec b) noexcept { return _mm_cmpgt_pd(a, b); }
+    friend vec operator>=(vec a, vec b) noexcept { return _mm_cmpge_pd(a, b); }
+
+    friend vec min(vec a, vec b) noexcept { return _mm_min_pd(a, b); }
+    friend vec max(vec a, vec b) noexcept { return _mm_max_pd(a, b); }
+    friend vec abs(vec a) noexcept { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    friend vec sqrt(vec a) noexcept { return _mm_sqrt_pd(a); }
+
+    friend vec round(vec a) noexcept
+    {
+#if defined(QUARISMA_SIMD_SSE41)
+        return _mm_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+#else
+        // Adding 2^52 drops the fraction; larger magnitudes are integers already
+        vec const magic     = 0x1p52;
+        vec const magnitude = abs(a);
+        vec const rounded   = (magnitude + magic) - magic;
+        return select(magnitude < magic, rounded, magnitude) | (a & vec(-0.0));
+#endif
+    }
+
+    friend vec fma(vec a, vec b, vec c) noexcept
+    {
+#if defined(__FMA__)
+        return _mm_fmadd_pd(a, b, c);
+#else
+        return _mm_add_pd(_mm_mul_pd(a, b), c);
+#endif
+    }
+
+    friend vec select(vec mask, vec a, vec b) noexcept
+    {
+#if defined(QUARISMA_SIMD_SSE41)
+        return _mm_blendv_pd(b, a, mask);
+#else
+        return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+#endif
+    }
+
+    friend double reduce_add(vec a) noexcept
+    {
+        return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+    }
+    friend double reduce_min(vec a) noexcept
+    {
+        return _mm_cvtsd_f64(_mm_min_sd(a, _mm_unpackhi_pd(a, a)));
+    }
+    friend double reduce_max(vec a) noexcept
+    {
+        return _mm_cvtsd_f64(_mm_max_sd(a, _mm_unpackhi_pd(a, a)));
+    }
+
+    // The biased exponent n + 1023 ends up in the low mantissa bits of n + 2^52 + 1023
+    friend vec pow2(vec n) noexcept
+    {
+        __m128i const biased = _mm_castpd_si128(_mm_add_pd(n, _mm_set1_pd(0x1p52 + 1023)));
+        return _mm_castsi128_pd(_mm_slli_epi64(biased, 52));
+    }
+
+    friend vec exponent(vec a) noexcept
+    {
+        __m128i const biased = _mm_srli_epi64(_mm_castpd_si128(a), 52);
+        __m128d const value  = _mm_or_pd(_mm_castsi128_pd(biased), _mm_set1_pd(0x1p52));
+        return _mm_sub_pd(value, _mm_set1_pd(0x1p52 + 1023));
+    }
+
+    friend vec mantissa(vec a) noexcept
+    {
+        __m128d const fraction = _mm_castsi128_pd(_mm_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+        return _mm_or_pd(_mm_and_pd(a, fraction), _mm_set1_pd(1.0));
+    }
+
+private:
+    register_type v_;
+};
+
+/// 4 floats in an SSE2 register; SSE4.1 and FMA are used when enabled
+template <>
+class vec<float, 4>
+{
+public:
+    using value_type                  = float;
+    using register_type               = __m128;
+    static constexpr size_t size      = 4;
+    static constexpr size_t alignment = 16;
+
+    vec() noexcept = default;
+    vec(register_type v) noexcept : v_(v) {}
+    vec(float value) noexcept : v_(_mm_set1_ps(value)) {}
+    operator register_type() const noexcept { return v_; }
+
+    static vec load(const float* p) noexcept { return _mm_load_ps(p); }
+    static vec loadu(const float* p) noexcept { return _mm_loadu_ps(p); }
+    static vec load_partial(const float* p, size_t count) noexcept
+    {
+        alignas(alignment) float lanes[size] = {};
+        std::copy_n(p, std::min(count, size), lanes);
+        return load(lanes);
+    }
+
+    void store(float* p) const noexcept { _mm_store_ps(p, v_); }
+    void storeu(float* p) const noexcept { _mm_storeu_ps(p, v_); }
+    void store_partial(float* p, size_t count) const noexcept
+    {
+        alignas(alignment) float lanes[size];
+        store(lanes);
+        std::copy_n(lanes, std::min(count, size), p);
+    }
+
+    float operator[](size_t i) const noexcept
+    {
+        alignas(alignment) float lanes[size];
+        store(lanes);
+        return lanes[i];
+    }
+
+    friend vec operator+(vec a, vec b) noexcept { return _mm_add_ps(a, b); }
+    friend vec operator-(vec a, vec b) noexcept { return _mm_sub_ps(a, b); }
+    friend vec operator*(vec a, vec b) noexcept { return _mm_mul_ps(a, b); }
+    friend vec operator/(vec a, vec b) noexcept { return _mm_div_ps(a, b); }
+    friend vec operator-(vec a) noexcept { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+
+    friend vec operator&(vec a, vec b) noexcept { return _mm_and_ps(a, b); }
+    friend vec operator|(vec a, vec b) noexcept { return _mm_or_ps(a, b); }
+    friend vec operator^(vec a, vec b) noexcept { return _mm_xor_ps(a, b); }
+    friend vec and_not(vec a, vec b) noexcept { return _mm_andnot_ps(b, a); }
+
+    friend vec operator==(vec a, vec b) noexcept { return _mm_cmpeq_ps(a, b); }
+    friend vec operator!=(vec a, vec b) noexcept { return _mm_cmpneq_ps(a, b); }
+    friend vec operator<(vec a, vec b) noexcept { return _mm_cmplt_ps(a, b); }
+    friend vec operator<=(vec a, vec b) noexcept { return _mm_cmple_ps(a, b); }
+    friend vec operator>(vec a, vec b) noexcept { return _mm_cmpgt_ps(a, b); }
+    friend vec operator>=(vec a, vec b) noexcept { return _mm_cmpge_ps(a, b); }
+
+    friend vec min(vec a, vec b) noexcept { return _mm_min_ps(a, b); }
+    friend vec max(vec a, vec b) noexcept { return _mm_max_ps(a, b); }
+    friend vec abs(vec a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    friend vec sqrt(vec a) noexcept { return _mm_sqrt_ps(a); }
+
+    friend vec round(vec a) noexcept
+    {
+#if defined(QUARISMA_SIMD_SSE41)
+        return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+#else
+        vec const magic     = 0x1p23f;
+        vec const magnitude = abs(a);
+        vec const rounded   = (magnitude + magic) - magic;
+        return select(magnitude < magic, rounded, magnitude) | (a & vec(-0.0f));
+#endif
+    }
+
+    friend vec fma(vec a, vec b, vec c) noexcept
+    {
+#if defined(__FMA__)
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+    friend vec select(vec mask, vec a, vec b) noexcept
+    {
+#if defined(QUARISMA_SIMD_SSE41)
+        return _mm_blendv_ps(b, a, mask);
+#else
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#endif
+    }
+
+    friend float reduce_add(vec a) noexcept
+    {
+        __m128 const pairs = _mm_add_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+    friend float reduce_min(vec a) noexcept
+    {
+        __m128 const pairs = _mm_min_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_min_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+    friend float reduce_max(vec a) noexcept
+    {
+        __m128 const pairs = _mm_max_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    friend vec pow2(vec n) noexcept
+    {
+        __m128i const biased = _mm_castps_si128(_mm_add_ps(n, _mm_set1_ps(0x1p23f + 127)));
+        return _mm_castsi128_ps(_mm_slli_epi32(biased, 23));
+    }
+
+    friend vec exponent(vec a) noexcept
+    {
+        __m128i const biased = _mm_srli_epi32(_mm_castps_si128(a), 23);
+        return _mm_sub_ps(_mm_cvtepi32_ps(biased), _mm_set1_ps(127.0f));
+    }
+
+    friend vec mantissa(vec a) noexcept
+    {
+        __m128 const fraction = _mm_castsi128_ps(_mm_set1_epi32(0x007FFFFF));
+        return _mm_or_ps(_mm_and_ps(a, fraction), _mm_set1_ps(1.0f));
+    }
+
+private:
+    register_type v_;
+};
+
+}  // namespace QUARISMA_CPU_CAPABILITY
+}  // namespace simd
+}  // namespace quarisma
+
+#endif  // QUARISMA_SIMD_SSE2
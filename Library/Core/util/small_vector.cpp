@@ -13,10 +13,16 @@
 // Quarisma: modified from llvm::small_vector.
 // replaced llvm::safe_malloc with std::bad_alloc
 // deleted LLVM_ENABLE_EXCEPTIONS
+// heap buffers record their std::pmr::memory_resource, see small_vector_resource_scope
 
 #include "util/small_vector.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <stdexcept>
 #include <string>
 using namespace quarisma;
@@ -114,9 +120,140 @@ static size_t getNewCapacity(size_t MinSize, size_t OldCapacity)
     return std::min(std::max(NewCapacity, MinSize), MaxSize);
 }
 
+#if QUARISMA_HAS_MEMORY_RESOURCE
+namespace
+{
+thread_local std::pmr::memory_resource* current_resource = nullptr;
+
+// Prefix of every heap buffer: the resource it came from, nullptr for malloc,
+// and the byte count memory_resource::deallocate() needs back
+struct heap_header
+{
+    std::pmr::memory_resource* resource;
+    size_t                     bytes;
+};
+
+// Rounded up so the buffer keeps malloc's alignment
+constexpr size_t heap_header_size =
+    (sizeof(heap_header) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+heap_header* header_of(void* Buffer)
+{
+    return reinterpret_cast<heap_header*>(static_cast<char*>(Buffer) - heap_header_size);
+}
+
+void* allocate_heap(std::pmr::memory_resource* Resource, size_t Bytes)
+{
+    size_t const Total = heap_header_size + Bytes;
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    void* Block = Resource != nullptr ? Resource->allocate(Total, alignof(std::max_align_t))
+                                      : std::malloc(Total);
+    if (Block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    auto* Header = static_cast<heap_header*>(Block);
+    *Header      = {Resource, Bytes};
+    return static_cast<char*>(Block) + heap_header_size;
+}
+
+void* reallocate_heap(void* Buffer, size_t Bytes)
+{
+    heap_header* const Header   = header_of(Buffer);
+    auto* const        Resource = Header->resource;
+    if (Resource == nullptr)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+        void* Block = std::realloc(Header, heap_header_size + Bytes);
+        if (Block == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        static_cast<heap_header*>(Block)->bytes = Bytes;
+        return static_cast<char*>(Block) + heap_header_size;
+    }
+
+    void* const NewBuffer = allocate_heap(Resource, Bytes);
+    memcpy(NewBuffer, Buffer, std::min(Bytes, Header->bytes));
+    Resource->deallocate(Header, heap_header_size + Header->bytes, alignof(std::max_align_t));
+    return NewBuffer;
+}
+
+void free_heap_buffer(void* Buffer)
+{
+    heap_header* const Header = header_of(Buffer);
+    if (Header->resource == nullptr)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+        std::free(Header);
+        return;
+    }
+    Header->resource->deallocate(
+        Header, heap_header_size + Header->bytes, alignof(std::max_align_t));
+}
+}  // namespace
+
+small_vector_resource_scope::small_vector_resource_scope(
+    std::pmr::memory_resource* resource) noexcept
+    : previous_(current_resource)
+{
+    current_resource = resource;
+}
+
+small_vector_resource_scope::~small_vector_resource_scope()
+{
+    current_resource = previous_;
+}
+
+std::pmr::memory_resource* small_vector_resource_scope::current() noexcept
+{
+    return current_resource;
+}
+
+// A vector that has spilled stays in the resource of its buffer
+template <class Size_T>
+void* SmallVectorBase<Size_T>::malloc_for_grow(
+    const void* FirstEl, size_t MinSize, size_t TSize, size_t& NewCapacity)
+{
+    NewCapacity = getNewCapacity<Size_T>(MinSize, this->capacity());
+    auto* const Resource =
+        BeginX == FirstEl ? current_resource : header_of(this->BeginX)->resource;
+    return allocate_heap(Resource, NewCapacity * TSize);
+}
+
 // Note: Moving this function into the header may cause performance regression.
 template <class Size_T>
-void* SmallVectorBase<Size_T>::malloc_for_grow(size_t MinSize, size_t TSize, size_t& NewCapacity)
+void SmallVectorBase<Size_T>::grow_pod(const void* FirstEl, size_t MinSize, size_t TSize)
+{
+    size_t const NewCapacity = getNewCapacity<Size_T>(MinSize, this->capacity());
+    void*        NewElts     = nullptr;
+    if (BeginX == FirstEl)
+    {
+        NewElts = allocate_heap(current_resource, NewCapacity * TSize);
+
+        // Copy the elements over.  No need to run dtors on PODs.
+        memcpy(NewElts, this->BeginX, size() * TSize);
+    }
+    else
+    {
+        // If this wasn't grown from the inline copy, grow the allocated space.
+        NewElts = reallocate_heap(this->BeginX, NewCapacity * TSize);
+    }
+
+    this->BeginX   = NewElts;
+    this->Capacity = NewCapacity;
+}
+
+template <class Size_T>
+void SmallVectorBase<Size_T>::free_heap(void* Ptr)
+{
+    free_heap_buffer(Ptr);
+}
+#else
+// Note: Moving this function into the header may cause performance regression.
+template <class Size_T>
+void* SmallVectorBase<Size_T>::malloc_for_grow(
+    QUARISMA_UNUSED const void* FirstEl, size_t MinSize, size_t TSize, size_t& NewCapacity)
 {
     NewCapacity = getNewCapacity<Size_T>(MinSize, this->capacity());
     // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
@@ -161,6 +298,14 @@ void SmallVectorBase<Size_T>::grow_pod(const void* FirstEl, size_t MinSize, size
     this->Capacity = NewCapacity;
 }
 
+template <class Size_T>
+void SmallVectorBase<Size_T>::free_heap(void* Ptr)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+    std::free(Ptr);
+}
+#endif  // QUARISMA_HAS_MEMORY_RESOURCE
+
 template class quarisma::SmallVectorBase<uint32_t>;
 
 // Disable the uint64_t instantiation for 32-bit builds.
@@ -18,6 +18,7 @@
 // added small_vector::at
 // added operator<< for std::ostream
 // added QUARISMA_API to export SmallVectorBase
+// added small_vector_resource_scope: heap storage can come from a std::pmr::memory_resource
 
 #pragma once
 
@@ -42,9 +43,46 @@
 #include "common/export.h"
 #include "common/macros.h"
 
+#if QUARISMA_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+
 namespace quarisma
 {
 
+#if QUARISMA_HAS_MEMORY_RESOURCE
+/// Routes the heap storage of every small_vector that spills on this thread
+/// to a memory resource, for as long as the scope lives. Scopes nest.
+///
+/// small_vector keeps its layout and its type-erased SmallVectorImpl<T>
+/// interface: the resource a heap buffer came from is recorded in front of
+/// the buffer, so it is returned there even if the vector leaves the scope or
+/// the thread. Once spilled, a vector keeps growing in its resource. The
+/// resource must outlive every vector that allocated from it.
+///
+/// \code
+///   arena scratch(std::make_unique<basic_cpu_allocator>(0, {}, {}), "request", {});
+///   small_vector_resource_scope const scope(&scratch);
+///   small_vector<int, 4> ids;  // spills into the arena instead of malloc
+/// \endcode
+class QUARISMA_VISIBILITY small_vector_resource_scope
+{
+public:
+    /// Use \p resource on this thread; nullptr restores malloc.
+    QUARISMA_API explicit small_vector_resource_scope(std::pmr::memory_resource* resource) noexcept;
+    QUARISMA_API ~small_vector_resource_scope();
+
+    small_vector_resource_scope(const small_vector_resource_scope&)            = delete;
+    small_vector_resource_scope& operator=(const small_vector_resource_scope&) = delete;
+
+    /// Resource of the innermost scope on this thread, nullptr for malloc.
+    QUARISMA_API static std::pmr::memory_resource* current() noexcept;
+
+private:
+    std::pmr::memory_resource* previous_;
+};
+#endif
+
 /// This is all the stuff common to all SmallVectors.
 ///
 /// The template parameter specifies the type which should be used to hold the
@@ -70,13 +108,18 @@ protected:
     /// This is a helper for \a grow() that's out of line to reduce code
     /// duplication.  This function will report a fatal error if it can't grow at
     /// least to \p MinSize.
-    QUARISMA_API void* malloc_for_grow(size_t MinSize, size_t TSize, size_t& NewCapacity);
+    QUARISMA_API void* malloc_for_grow(
+        const void* FirstEl, size_t MinSize, size_t TSize, size_t& NewCapacity);
 
     /// This is an implementation of the grow() method which only works
     /// on POD-like data types and is out of line to reduce code duplication.
     /// This function will report a fatal error if it cannot increase capacity.
     QUARISMA_API void grow_pod(const void* FirstEl, size_t MinSize, size_t TSize);
 
+    /// Releases a heap buffer from malloc_for_grow() or grow_pod() to the
+    /// allocator it came from.
+    QUARISMA_API static void free_heap(void* Ptr);
+
 public:
     SmallVectorBase() = delete;
     size_t size() const { return Size; }
@@ -139,6 +182,11 @@ protected:
 
     void grow_pod(size_t MinSize, size_t TSize) { Base::grow_pod(getFirstEl(), MinSize, TSize); }
 
+    void* malloc_for_grow(size_t MinSize, size_t TSize, size_t& NewCapacity)
+    {
+        return Base::malloc_for_grow(getFirstEl(), MinSize, TSize, NewCapacity);
+    }
+
     /// Return true if this is a smallvector which has not had dynamic
     /// memory allocated for it.
     bool isSmall() const { return this->BeginX == getFirstEl(); }
@@ -409,8 +457,8 @@ protected:
     /// in \p NewCapacity. This is the first section of \a grow().
     T* malloc_for_grow(size_t MinSize, size_t& NewCapacity)
     {
-        return static_cast<T*>(SmallVectorBase<SmallVectorSizeType<T>>::malloc_for_grow(
-            MinSize, sizeof(T), NewCapacity));
+        return static_cast<T*>(
+            SmallVectorTemplateCommon<T>::malloc_for_grow(MinSize, sizeof(T), NewCapacity));
     }
 
     /// Move existing elements over to the new allocation \p NewElts, the middle
@@ -512,7 +560,7 @@ void SmallVectorTemplateBase<T, TriviallyCopyable>::takeAllocationForGrow(
 {
     // If this wasn't grown from the inline copy, deallocate the old space.
     if (!this->isSmall())
-        free(this->begin());
+        this->free_heap(this->begin());
 
     this->BeginX   = NewElts;
     this->Capacity = NewCapacity;
@@ -657,7 +705,7 @@ public:
         // Subclass has already destructed this vector's elements.
         // If this wasn't grown from the inline copy, deallocate the old space.
         if (!this->isSmall())
-            free(this->begin());
+            this->free_heap(this->begin());
     }
 
     void clear()
@@ -1146,7 +1194,7 @@ SmallVectorImpl<T>& SmallVectorImpl<T>::operator=(SmallVectorImpl<T>&& RHS) noex
     {
         this->destroy_range(this->begin(), this->end());
         if (!this->isSmall())
-            free(this->begin());
+            this->free_heap(this->begin());
         this->BeginX   = RHS.BeginX;
         this->Size     = RHS.Size;
         this->Capacity = RHS.Capacity;
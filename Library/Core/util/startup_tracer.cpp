@@ -0,0 +1,175 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#include "util/startup_tracer.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+namespace quarisma
+{
+namespace
+{
+struct slot
+{
+    std::atomic<bool>     ready{false};
+    startup_tracer::phase value;
+};
+
+// Constant-initialized: usable from static initializers of other translation units
+slot                g_slots[startup_tracer::capacity];
+std::atomic<size_t> g_next{0};
+
+void print_report_at_exit()
+{
+    std::fputs(startup_tracer::report().c_str(), stderr);
+}
+
+bool install_exit_report()
+{
+    const char* const value = std::getenv("QUARISMA_STARTUP_TRACE");
+    if (value == nullptr || std::strcmp(value, "1") != 0)
+    {
+        return false;
+    }
+    return std::atexit(&print_report_at_exit) == 0;
+}
+}  // namespace
+
+startup_tracer::scope::scope(const char* name) noexcept : name_(name), start_ns_(now_ns()) {}
+
+startup_tracer::scope::~scope()
+{
+    record(name_, start_ns_, now_ns() - start_ns_);
+}
+
+void startup_tracer::record(const char* name, int64_t start_ns, int64_t duration_ns) noexcept
+{
+    static bool const exit_report = install_exit_report();
+    (void)exit_report;
+
+    size_t const index = g_next.fetch_add(1, std::memory_order_relaxed);
+    if (index >= capacity)
+    {
+        return;
+    }
+    g_slots[index].value = {name, start_ns, duration_ns};
+    g_slots[index].ready.store(true, std::memory_order_release);
+}
+
+int64_t startup_tracer::now_ns() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::vector<startup_tracer::phase> startup_tracer::phases()
+{
+    size_t const       count = std::min(g_next.load(std::memory_order_relaxed), capacity);
+    std::vector<phase> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        // A slot claimed but not yet written is skipped
+        if (g_slots[i].ready.load(std::memory_order_acquire))
+        {
+            result.push_back(g_slots[i].value);
+        }
+    }
+    return result;
+}
+
+size_t startup_tracer::dropped() noexcept
+{
+    size_t const count = g_next.load(std::memory_order_relaxed);
+    return count > capacity ? count - capacity : 0;
+}
+
+std::string startup_tracer::report()
+{
+    auto const  recorded = phases();
+    std::string out      = "=== Startup Phases ===\n";
+    if (recorded.empty())
+    {
+        return out + "(none recorded)\n";
+    }
+
+    int64_t origin = recorded.front().start_ns;
+    for (const auto& p : recorded)
+    {
+        origin = std::min(origin, p.start_ns);
+    }
+
+    std::vector<std::pair<std::string_view, int64_t>> totals;
+    for (const auto& p : recorded)
+    {
+        out += fmt::format(
+            "{:<40} +{:>10.3f} ms {:>10.3f} ms\n",
+            p.name,
+            static_cast<double>(p.start_ns - origin) / 1e6,
+            static_cast<double>(p.duration_ns) / 1e6);
+
+        auto it = std::find_if(
+            totals.begin(), totals.end(), [&p](const auto& t) { return t.first == p.name; });
+        if (it == totals.end())
+        {
+            totals.emplace_back(p.name, p.duration_ns);
+        }
+        else
+        {
+            it->second += p.duration_ns;
+        }
+    }
+
+    std::stable_sort(
+        totals.begin(),
+        totals.end(),
+        [](const auto& a, const auto& b) { return a.second > b.second; });
+    out += "--- Total per phase ---\n";
+    for (const auto& [name, total] : totals)
+    {
+        out += fmt::format("{:<40} {:>10.3f} ms\n", name, static_cast<double>(total) / 1e6);
+    }
+    if (dropped() != 0)
+    {
+        out += fmt::format("({} phase(s) dropped past capacity)\n", dropped());
+    }
+    return out;
+}
+
+void startup_tracer::clear_for_test() noexcept
+{
+    size_t const count = std::min(g_next.load(std::memory_order_relaxed), capacity);
+    for (size_t i = 0; i < count; ++i)
+    {
+        g_slots[i].ready.store(false, std::memory_order_relaxed);
+    }
+    g_next.store(0, std::memory_order_relaxed);
+}
+}  // namespace quarisma
@@ -0,0 +1,100 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/export.h"
+#include "common/macros.h"
+
+namespace quarisma
+{
+/**
+ * @brief Timestamps of the registration phases that run around process startup
+ *
+ * Static registrations (profiler factories, RecordFunction callback managers)
+ * and first-use tables (xplane schema, cpuinfo, logger) record how long they
+ * take, so that short-lived tools can see what they pay before and just after
+ * main. The storage is constant-initialized, which makes record() safe from
+ * any static initializer whatever the initialization order; phases beyond
+ * capacity are counted in dropped() but not kept.
+ *
+ * When QUARISMA_STARTUP_TRACE is set to 1 in the environment, report() is
+ * printed to stderr at exit.
+ *
+ * **Example Usage**:
+ * ```cpp
+ * const startup_tracer::scope phase("my_registry");
+ * build_registry();
+ * ```
+ */
+class QUARISMA_API startup_tracer
+{
+public:
+    /// Most phases kept
+    static constexpr size_t capacity = 256;
+
+    struct phase
+    {
+        const char* name        = nullptr;  ///< Static string
+        int64_t     start_ns    = 0;        ///< steady_clock
+        int64_t     duration_ns = 0;
+    };
+
+    /// Records the lifetime of the scope as a phase named name, a static string
+    class QUARISMA_API scope
+    {
+    public:
+        explicit scope(const char* name) noexcept;
+        ~scope();
+
+        scope(const scope&)            = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        const char* name_;
+        int64_t     start_ns_;
+    };
+
+    static void record(const char* name, int64_t start_ns, int64_t duration_ns) noexcept;
+
+    /// steady_clock reading in nanoseconds, the timeline of record()
+    static int64_t now_ns() noexcept;
+
+    /// Phases recorded so far, in the order they completed
+    static std::vector<phase> phases();
+
+    /// Phases recorded once capacity was reached
+    static size_t dropped() noexcept;
+
+    /**
+     * Phases with their start relative to the first one, followed by the
+     * total time per name, largest first.
+     */
+    static std::string report();
+
+    /// Forgets every phase recorded so far
+    static void clear_for_test() noexcept;
+};
+}  // namespace quarisma
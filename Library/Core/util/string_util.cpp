@@ -18,10 +18,11 @@
 
 #include "util/string_util.h"
 
-#include <cstdio>   // for snprintf, vsnprintf
-#include <cstdlib>  // for strtod, strtof, abs, strtol
-#include <cstring>  // for strlen, memcpy
-#include <string>   // for char_traits, string, operator<<, allocator, operator==, oper...
+#include <algorithm>  // for max
+#include <cstdio>     // for snprintf, vsnprintf
+#include <cstdlib>    // for strtod, strtof, abs, strtol
+#include <cstring>    // for strlen, memcpy
+#include <string>     // for char_traits, string, operator<<, allocator, operator==, oper...
 #include <string_view>
 
 #include "common/macros.h"   // for QUARISMA_UNUSED, QUARISMA_HAS_CXA_DEMANGLE
@@ -133,6 +134,56 @@ void erase_all_sub_string(std::string& mainStr, std::string_view const& toErase)
         mainStr.erase(pos, toErase.length());
     }
 }
+
+namespace strings
+{
+namespace internal
+{
+std::string cat_pieces(std::initializer_list<std::string_view> pieces)
+{
+    size_t size = 0;
+    for (std::string_view const piece : pieces)
+    {
+        size += piece.size();
+    }
+
+    std::string result;
+    result.reserve(size);
+    for (std::string_view const piece : pieces)
+    {
+        result.append(piece);
+    }
+    return result;
+}
+
+void append_pieces(std::string* result, std::initializer_list<std::string_view> pieces)
+{
+    size_t size = result->size();
+    for (std::string_view const piece : pieces)
+    {
+        size += piece.size();
+    }
+
+    // A piece may point into *result, which must not move before it is copied
+    if (size > result->capacity())
+    {
+        std::string grown;
+        grown.reserve(std::max(size, 2 * result->capacity()));
+        grown.append(*result);
+        for (std::string_view const piece : pieces)
+        {
+            grown.append(piece);
+        }
+        result->swap(grown);
+        return;
+    }
+    for (std::string_view const piece : pieces)
+    {
+        result->append(piece);
+    }
+}
+}  // namespace internal
+}  // namespace strings
 }  // namespace quarisma
 
 namespace quarisma
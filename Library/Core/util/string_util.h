@@ -17,14 +17,18 @@
 
 #include <algorithm>  // for transform
 #include <cctype>
-#include <cstddef>      // for size_t
-#include <cstdint>      // for int64_t, uint64_t, uint32_t, int32_t
-#include <filesystem>   // for path (C++17)
-#include <iomanip>      // for setfill, setw, hex
-#include <sstream>      // for ostream, ostringstream, stringstream
-#include <string>       // for string, allocator, char_traits, stoi, to_string
-#include <string_view>  // for string_view
-#include <vector>       // for vector
+#include <charconv>          // for to_chars, chars_format
+#include <cstddef>           // for size_t
+#include <cstdint>           // for int64_t, uint64_t, uint32_t, int32_t
+#include <cstdio>            // for snprintf
+#include <filesystem>        // for path (C++17)
+#include <initializer_list>  // for initializer_list
+#include <iomanip>           // for setfill, setw, hex
+#include <sstream>           // for ostream, ostringstream, stringstream
+#include <string>            // for string, allocator, char_traits, stoi, to_string
+#include <string_view>       // for string_view
+#include <type_traits>       // for enable_if_t, is_arithmetic_v, is_convertible_v
+#include <vector>            // for vector
 
 #include "common/export.h"  // for QUARISMA_API, QUARISMA_VISIBILITY
 #include "common/macros.h"  // for QUARISMA_PRINTF_ATTRIBUTE
@@ -279,8 +283,9 @@ std::string format_hex(Int value, hex_pad padding = hex_pad::none);
  * @tparam Args The types of arguments to concatenate
  * @param args The values to concatenate
  * @return Concatenated string
- * @note This function efficiently concatenates strings, string_views, and numeric types
- * @note Uses std::ostringstream for efficient multi-argument concatenation
+ * @note Strings and numbers are converted without a stream (integers by std::to_chars,
+ * floating-point values as a stream would, with 6 significant digits) and the result is
+ * allocated once, at its final size; other types go through their operator<<
  * @example
  * @code
  * auto str1 = str_cat("Hello", " ", "World");           // Returns "Hello World"
@@ -296,8 +301,8 @@ std::string str_cat(const Args&... args);
  * @tparam Args The types of arguments to append
  * @param result Pointer to the string to append to
  * @param args The values to append
- * @note This function efficiently appends strings, string_views, and numeric types
- * @note More efficient than repeated operator+= for multiple arguments
+ * @note Converts its arguments as str_cat() does and grows result at most once; the
+ * arguments may refer to result itself
  * @example
  * @code
  * std::string s = "Start";
@@ -330,27 +335,104 @@ inline bool str_contains(std::string_view haystack, char needle) noexcept
 
 namespace internal
 {
-// Helper to convert a value to string
+/**
+ * @brief One argument of str_cat() or str_append() as characters, without a stream
+ *
+ * Strings are referenced and numbers are written to the inline buffer, so the piece
+ * lives as long as both the argument and the alpha_num, to the end of the call.
+ * A char is the character itself, a bool 0 or 1, as with operator<<.
+ */
+class alpha_num
+{
+public:
+    alpha_num(const char* value) noexcept : piece_(value != nullptr ? value : "") {}
+
+    alpha_num(std::string_view value) noexcept : piece_(value) {}
+
+    template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    alpha_num(T value) noexcept
+    {
+        size_t size = 0;
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            digits_[size++] = value ? '1' : '0';
+        }
+        else if constexpr (
+            std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+            std::is_same_v<T, unsigned char>)
+        {
+            digits_[size++] = static_cast<char>(value);
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            size = static_cast<size_t>(
+                std::to_chars(digits_, digits_ + sizeof(digits_), value).ptr - digits_);
+        }
+        else
+        {
+#if defined(__cpp_lib_to_chars)
+            char const* const end =
+                std::to_chars(
+                    digits_, digits_ + sizeof(digits_), value, std::chars_format::general, 6)
+                    .ptr;
+            size = static_cast<size_t>(end - digits_);
+#else
+            size = static_cast<size_t>(std::snprintf(
+                digits_, sizeof(digits_), "%.6Lg", static_cast<long double>(value)));
+#endif
+        }
+        piece_ = std::string_view(digits_, size);
+    }
+
+    // piece_ may point into digits_
+    alpha_num(const alpha_num&)            = delete;
+    alpha_num& operator=(const alpha_num&) = delete;
+
+    std::string_view piece() const noexcept { return piece_; }
+
+private:
+    std::string_view piece_;
+    char             digits_[32];
+};
+
+/// The alpha_num of value, or its operator<< output for the types alpha_num does not take
 template <typename T>
-inline void to_string_helper(std::ostringstream& oss, const T& value)
+auto to_piece(const T& value)
 {
-    oss << value;
+    if constexpr (std::is_arithmetic_v<T>)
+    {
+        return alpha_num(value);
+    }
+    else if constexpr (std::is_convertible_v<const T&, const char*>)
+    {
+        return alpha_num(static_cast<const char*>(value));
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+    {
+        return alpha_num(std::string_view(value));
+    }
+    else
+    {
+        std::ostringstream oss;
+        oss << value;
+        return oss.str();
+    }
 }
 
-// Specialization for string_view to avoid unnecessary conversions
-inline void to_string_helper(std::ostringstream& oss, std::string_view value)
+inline std::string_view piece_of(const alpha_num& value) noexcept
 {
-    oss << value;
+    return value.piece();
 }
 
-// Specialization for const char* to avoid unnecessary conversions
-inline void to_string_helper(std::ostringstream& oss, const char* value)
+inline std::string_view piece_of(const std::string& value) noexcept
 {
-    if (value != nullptr)
-    {
-        oss << value;
-    }
+    return value;
 }
+
+QUARISMA_API std::string cat_pieces(std::initializer_list<std::string_view> pieces);
+
+QUARISMA_API void append_pieces(
+    std::string* result, std::initializer_list<std::string_view> pieces);
 }  // namespace internal
 
 template <typename Int>
@@ -366,26 +448,21 @@ std::string format_hex(Int value, hex_pad padding)
                               : sizeof(value) == 4 ? static_cast<uint32_t>(value)
                                                    : static_cast<uint64_t>(value);
 
-    std::ostringstream oss;
-    oss << std::hex;
+    char         digits[16];
+    size_t const size = static_cast<size_t>(
+        std::to_chars(digits, digits + sizeof(digits), unsigned_value, 16).ptr - digits);
 
     // Apply padding if specified
-    int pad_width = static_cast<int>(padding);
-    if (pad_width > 1)
-    {
-        oss << std::setfill('0') << std::setw(pad_width);
-    }
-
-    oss << unsigned_value;
-    return oss.str();
+    auto const  pad_width = static_cast<size_t>(padding);
+    std::string result(pad_width > size ? pad_width - size : 0, '0');
+    result.append(digits, size);
+    return result;
 }
 
 template <typename... Args>
 std::string str_cat(const Args&... args)
 {
-    std::ostringstream oss;
-    (internal::to_string_helper(oss, args), ...);
-    return oss.str();
+    return internal::cat_pieces({internal::piece_of(internal::to_piece(args))...});
 }
 
 template <typename... Args>
@@ -395,10 +472,7 @@ void str_append(std::string* result, const Args&... args)
     {
         return;
     }
-
-    std::ostringstream oss;
-    (internal::to_string_helper(oss, args), ...);
-    *result += oss.str();
+    internal::append_pieces(result, {internal::piece_of(internal::to_piece(args))...});
 }
 
 QUARISMA_FORCE_INLINE std::string to_lower(std::string_view input)
@@ -0,0 +1,1267 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+/**
+ * @file swiss_table.h
+ * @brief Open-addressing hash map and set probing 16 slots per step
+ *
+ * swiss_hash_map and swiss_hash_set are drop-in alternatives to flat_hash_map
+ * and flat_hash_set with the same interface. Instead of walking a Robin Hood
+ * chain one entry at a time, the table keeps one control byte per slot: empty,
+ * deleted, or the low 7 bits of the hash of the element stored there. A
+ * lookup loads 16 control bytes at once and compares them all against the
+ * hash bits with SSE2 or NEON, so that only slots whose 7 bits already match
+ * are compared with the key. Misses usually stop at the first group, since any
+ * empty byte in it ends the probe.
+ *
+ * Layout:
+ * - capacity is 2^k - 1 slots, growth keeps the load factor below 7/8;
+ * - control bytes are [capacity slots][sentinel][first 15 bytes cloned], so a
+ *   group can be loaded at any slot without wrapping;
+ * - groups are probed quadratically, in steps of 16 slots.
+ *
+ * Differences with flat_hash_map:
+ * - the hasher output is mixed before use, so identity hashes of pointers and
+ *   integers are fine, and a hash_policy typedef on the hasher is ignored;
+ * - erase(iterator) returns the iterator to the next element;
+ * - max_load_factor() is fixed at 7/8, the setter has no effect;
+ * - at() checks that the key exists.
+ *
+ * Define QUARISMA_SWISS_TABLE (CMake -DQUARISMA_SWISS_TABLE=ON, Bazel
+ * --config=swiss_table) to make quarisma_map and quarisma_set use these
+ * containers.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "common/macros.h"
+#include "util/exception.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUARISMA_SWISS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define QUARISMA_SWISS_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace quarisma
+{
+namespace detail::swiss
+{
+using ctrl_t = int8_t;
+
+/// Control byte values; full slots hold the 7 hash bits, 0..127
+constexpr ctrl_t ctrl_empty    = -128;  // 0b10000000
+constexpr ctrl_t ctrl_deleted  = -2;    // 0b11111110
+constexpr ctrl_t ctrl_sentinel = -1;    // 0b11111111
+
+constexpr bool is_full(ctrl_t c) noexcept
+{
+    return c >= 0;
+}
+
+constexpr bool is_empty_or_deleted(ctrl_t c) noexcept
+{
+    return c < ctrl_sentinel;
+}
+
+inline int trailing_zeros(uint64_t x) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+inline int leading_zeros(uint64_t x) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+/**
+ * @brief Set of slots of a group, one bit per slot every 2^Shift bits
+ *
+ * Iterating yields the slot indices in increasing order.
+ */
+template <int Width, int Shift>
+class bitmask
+{
+public:
+    explicit bitmask(uint64_t mask) noexcept : mask_(mask) {}
+
+    explicit operator bool() const noexcept { return mask_ != 0; }
+
+    int lowest() const noexcept { return trailing_zeros(mask_) >> Shift; }
+
+    /// Number of unset slots before the lowest set one
+    int trailing_zeros_count() const noexcept
+    {
+        return mask_ == 0 ? Width : trailing_zeros(mask_) >> Shift;
+    }
+
+    /// Number of unset slots after the highest set one
+    int leading_zeros_count() const noexcept
+    {
+        constexpr int unused_bits = 64 - (Width << Shift);
+        return mask_ == 0 ? Width : (leading_zeros(mask_) - unused_bits) >> Shift;
+    }
+
+    // Range-for support
+    bitmask begin() const noexcept { return *this; }
+    bitmask end() const noexcept { return bitmask(0); }
+    int     operator*() const noexcept { return lowest(); }
+    bitmask& operator++() noexcept
+    {
+        mask_ &= mask_ - 1;
+        return *this;
+    }
+    friend bool operator!=(const bitmask& lhs, const bitmask& rhs) noexcept
+    {
+        return lhs.mask_ != rhs.mask_;
+    }
+
+private:
+    uint64_t mask_;
+};
+
+#if defined(QUARISMA_SWISS_SSE2)
+
+/**
+ * @brief 16 control bytes compared in parallel with SSE2
+ */
+struct group
+{
+    static constexpr int width = 16;
+    using mask_type            = bitmask<width, 0>;
+
+    explicit group(const ctrl_t* pos) noexcept
+        : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)))
+    {
+    }
+
+    mask_type match(ctrl_t h2) const noexcept
+    {
+        return mask_type(to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+    }
+
+    mask_type mask_empty() const noexcept
+    {
+        return mask_type(to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), ctrl_)));
+    }
+
+    mask_type mask_empty_or_deleted() const noexcept
+    {
+        return mask_type(to_mask(_mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl_)));
+    }
+
+    /// Number of empty or deleted slots at the start of the group
+    int count_leading_empty_or_deleted() const noexcept
+    {
+        uint64_t const special = to_mask(_mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl_));
+        return trailing_zeros(special + 1);
+    }
+
+private:
+    static uint64_t to_mask(__m128i cmp) noexcept
+    {
+        return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(cmp)));
+    }
+
+    __m128i ctrl_;
+};
+
+#elif defined(QUARISMA_SWISS_NEON)
+
+/**
+ * @brief 16 control bytes compared in parallel with NEON
+ *
+ * NEON has no movemask: the comparison is narrowed to 4 bits per byte and
+ * the top bit of each nibble is kept.
+ */
+struct group
+{
+    static constexpr int width = 16;
+    using mask_type            = bitmask<width, 2>;
+
+    explicit group(const ctrl_t* pos) noexcept : ctrl_(vld1q_s8(pos)) {}
+
+    mask_type match(ctrl_t h2) const noexcept
+    {
+        return mask_type(to_mask(vceqq_s8(vdupq_n_s8(h2), ctrl_)));
+    }
+
+    mask_type mask_empty() const noexcept
+    {
+        return mask_type(to_mask(vceqq_s8(vdupq_n_s8(ctrl_empty), ctrl_)));
+    }
+
+    mask_type mask_empty_or_deleted() const noexcept
+    {
+        return mask_type(to_mask(vcltq_s8(ctrl_, vdupq_n_s8(ctrl_sentinel))));
+    }
+
+    int count_leading_empty_or_deleted() const noexcept
+    {
+        uint64_t const other = ~to_mask(vcltq_s8(ctrl_, vdupq_n_s8(ctrl_sentinel))) & lanes;
+        return mask_type(other).trailing_zeros_count();
+    }
+
+private:
+    static constexpr uint64_t lanes = 0x8888888888888888ULL;
+
+    static uint64_t to_mask(uint8x16_t cmp) noexcept
+    {
+        uint8x8_t const narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & lanes;
+    }
+
+    int8x16_t ctrl_;
+};
+
+#else
+
+/**
+ * @brief 16 control bytes compared one at a time, for targets without SIMD
+ */
+struct group
+{
+    static constexpr int width = 16;
+    using mask_type            = bitmask<width, 0>;
+
+    explicit group(const ctrl_t* pos) noexcept { std::memcpy(ctrl_, pos, width); }
+
+    mask_type match(ctrl_t h2) const noexcept
+    {
+        return mask_type(collect([h2](ctrl_t c) { return c == h2; }));
+    }
+
+    mask_type mask_empty() const noexcept
+    {
+        return mask_type(collect([](ctrl_t c) { return c == ctrl_empty; }));
+    }
+
+    mask_type mask_empty_or_deleted() const noexcept
+    {
+        return mask_type(collect([](ctrl_t c) { return is_empty_or_deleted(c); }));
+    }
+
+    int count_leading_empty_or_deleted() const noexcept
+    {
+        int count = 0;
+        while (count < width && is_empty_or_deleted(ctrl_[count]))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    template <typename Predicate>
+    uint64_t collect(Predicate predicate) const noexcept
+    {
+        uint64_t mask = 0;
+        for (int i = 0; i < width; ++i)
+        {
+            mask |= static_cast<uint64_t>(predicate(ctrl_[i])) << i;
+        }
+        return mask;
+    }
+
+    ctrl_t ctrl_[width];
+};
+
+#endif
+
+/// Control bytes of a table without storage: a sentinel then empty slots
+alignas(16) inline constexpr ctrl_t empty_group[group::width] = {
+    ctrl_sentinel,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty,
+    ctrl_empty};
+
+/// Elements a table of the given capacity holds before growing
+constexpr uint64_t capacity_to_growth(uint64_t capacity) noexcept
+{
+    return capacity - capacity / 8;
+}
+
+/// Smallest valid capacity, 2^k - 1, holding the given number of elements
+constexpr uint64_t growth_to_capacity(uint64_t growth) noexcept
+{
+    uint64_t const wanted   = growth + (growth > 0 ? (growth - 1) / 7 : 0);
+    uint64_t       capacity = 1;
+    while (capacity < wanted)
+    {
+        capacity = capacity * 2 + 1;
+    }
+    return capacity;
+}
+
+/**
+ * @brief Quadratic probing over groups: offsets p, p+16, p+48, p+96, ...
+ */
+class probe_sequence
+{
+public:
+    probe_sequence(uint64_t hash, uint64_t mask) noexcept : mask_(mask), offset_(hash & mask) {}
+
+    uint64_t offset() const noexcept { return offset_; }
+    uint64_t offset(int i) const noexcept { return (offset_ + static_cast<uint64_t>(i)) & mask_; }
+
+    void next() noexcept
+    {
+        index_ += group::width;
+        offset_ = (offset_ + index_) & mask_;
+    }
+
+private:
+    uint64_t mask_;
+    uint64_t offset_;
+    uint64_t index_ = 0;
+};
+
+/// Spread the hasher output over all 64 bits; identity hashes are common
+inline uint64_t mix_hash(uint64_t hash) noexcept
+{
+    uint64_t const mixed = hash * 0x9E3779B97F4A7C15ULL;
+    return mixed ^ (mixed >> 32);
+}
+
+inline ctrl_t h2(uint64_t hash) noexcept
+{
+    return static_cast<ctrl_t>(hash & 0x7F);
+}
+
+inline uint64_t h1(uint64_t hash) noexcept
+{
+    return hash >> 7;
+}
+
+template <typename K, typename V>
+struct map_policy
+{
+    using key_type   = K;
+    using value_type = std::pair<K, V>;
+
+    static const K& key(const value_type& value) noexcept { return value.first; }
+};
+
+template <typename T>
+struct set_policy
+{
+    using key_type   = T;
+    using value_type = T;
+
+    static const T& key(const value_type& value) noexcept { return value; }
+};
+
+/**
+ * @brief Storage and probing shared by swiss_hash_map and swiss_hash_set
+ */
+template <typename Policy, typename Hash, typename Equal, typename Alloc>
+class raw_table
+{
+    using key_type_      = typename Policy::key_type;
+    using slot_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<
+        typename Policy::value_type>;
+    using slot_traits    = std::allocator_traits<slot_allocator>;
+    using ctrl_allocator = typename slot_traits::template rebind_alloc<ctrl_t>;
+    using ctrl_traits    = std::allocator_traits<ctrl_allocator>;
+
+public:
+    using value_type      = typename Policy::value_type;
+    using size_type       = uint64_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher          = Hash;
+    using key_equal       = Equal;
+    using allocator_type  = Alloc;
+    using reference       = value_type&;
+    using const_reference = const value_type&;
+    using pointer         = value_type*;
+    using const_pointer   = const value_type*;
+
+    template <typename ValueType>
+    class templated_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = ValueType;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = ValueType*;
+        using reference         = ValueType&;
+
+        templated_iterator() = default;
+
+        ValueType& operator*() const { return *slot_; }
+        ValueType* operator->() const { return slot_; }
+
+        templated_iterator& operator++()
+        {
+            ++ctrl_;
+            ++slot_;
+            skip_empty_or_deleted();
+            return *this;
+        }
+
+        templated_iterator operator++(int)
+        {
+            templated_iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const templated_iterator& lhs, const templated_iterator& rhs)
+        {
+            return lhs.ctrl_ == rhs.ctrl_;
+        }
+        friend bool operator!=(const templated_iterator& lhs, const templated_iterator& rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+        // Enabled for iterator -> const_iterator only
+        template <
+            class target_type = const ValueType,
+            class             = std::enable_if_t<
+                std::is_same_v<target_type, const ValueType> &&
+                !std::is_same_v<target_type, ValueType>>>
+        operator templated_iterator<target_type>() const
+        {
+            return templated_iterator<target_type>(ctrl_, slot_);
+        }
+
+    private:
+        friend class raw_table;
+        template <typename>
+        friend class templated_iterator;
+
+        templated_iterator(const ctrl_t* ctrl, ValueType* slot) : ctrl_(ctrl), slot_(slot) {}
+
+        // Stops at the next full slot or at the sentinel, which is end()
+        void skip_empty_or_deleted()
+        {
+            while (is_empty_or_deleted(*ctrl_))
+            {
+                int const shift = group(ctrl_).count_leading_empty_or_deleted();
+                ctrl_ += shift;
+                slot_ += shift;
+            }
+        }
+
+        const ctrl_t* ctrl_ = nullptr;
+        ValueType*    slot_ = nullptr;
+    };
+
+    using iterator       = templated_iterator<value_type>;
+    using const_iterator = templated_iterator<const value_type>;
+
+    raw_table() = default;
+
+    explicit raw_table(
+        size_type    bucket_count,
+        const Hash&  hash  = Hash(),
+        const Equal& equal = Equal(),
+        const Alloc& alloc = Alloc())
+        : hash_(hash), equal_(equal), alloc_(alloc)
+    {
+        if (bucket_count != 0)
+        {
+            resize(growth_to_capacity(bucket_count));
+        }
+    }
+    raw_table(size_type bucket_count, const Alloc& alloc)
+        : raw_table(bucket_count, Hash(), Equal(), alloc)
+    {
+    }
+    raw_table(size_type bucket_count, const Hash& hash, const Alloc& alloc)
+        : raw_table(bucket_count, hash, Equal(), alloc)
+    {
+    }
+    explicit raw_table(const Alloc& alloc) : alloc_(alloc) {}
+
+    template <typename It>
+    raw_table(
+        It           first,
+        It           last,
+        size_type    bucket_count = 0,
+        const Hash&  hash         = Hash(),
+        const Equal& equal        = Equal(),
+        const Alloc& alloc        = Alloc())
+        : raw_table(bucket_count, hash, equal, alloc)
+    {
+        insert(first, last);
+    }
+    template <typename It>
+    raw_table(It first, It last, size_type bucket_count, const Alloc& alloc)
+        : raw_table(first, last, bucket_count, Hash(), Equal(), alloc)
+    {
+    }
+    template <typename It>
+    raw_table(It first, It last, size_type bucket_count, const Hash& hash, const Alloc& alloc)
+        : raw_table(first, last, bucket_count, hash, Equal(), alloc)
+    {
+    }
+
+    raw_table(
+        std::initializer_list<value_type> il,
+        size_type                         bucket_count = 0,
+        const Hash&                       hash         = Hash(),
+        const Equal&                      equal        = Equal(),
+        const Alloc&                      alloc        = Alloc())
+        : raw_table(bucket_count == 0 ? il.size() : bucket_count, hash, equal, alloc)
+    {
+        insert(il.begin(), il.end());
+    }
+    raw_table(std::initializer_list<value_type> il, size_type bucket_count, const Alloc& alloc)
+        : raw_table(il, bucket_count, Hash(), Equal(), alloc)
+    {
+    }
+    raw_table(
+        std::initializer_list<value_type> il,
+        size_type                         bucket_count,
+        const Hash&                       hash,
+        const Alloc&                      alloc)
+        : raw_table(il, bucket_count, hash, Equal(), alloc)
+    {
+    }
+
+    raw_table(const raw_table& other)
+        : raw_table(other, slot_traits::select_on_container_copy_construction(other.alloc_))
+    {
+    }
+    raw_table(const raw_table& other, const Alloc& alloc)
+        : raw_table(other.size_, other.hash_, other.equal_, alloc)
+    {
+        copy_elements_from(other);
+    }
+
+    raw_table(raw_table&& other) noexcept
+        : hash_(std::move(other.hash_)),
+          equal_(std::move(other.equal_)),
+          alloc_(std::move(other.alloc_))
+    {
+        swap_storage(other);
+    }
+    raw_table(raw_table&& other, const Alloc& alloc)
+        : hash_(std::move(other.hash_)), equal_(std::move(other.equal_)), alloc_(alloc)
+    {
+        if (alloc_ == other.alloc_)
+        {
+            swap_storage(other);
+        }
+        else
+        {
+            reserve(other.size_);
+            for (value_type& value : other)
+            {
+                emplace_unique(Policy::key(value), std::move(value));
+            }
+            other.clear();
+        }
+    }
+
+    raw_table& operator=(const raw_table& other)
+    {
+        if (this == std::addressof(other))
+        {
+            return *this;
+        }
+        raw_table copy(
+            other,
+            slot_traits::propagate_on_container_copy_assignment::value
+                ? allocator_type(other.alloc_)
+                : allocator_type(alloc_));
+        swap_all(copy);
+        return *this;
+    }
+
+    raw_table& operator=(raw_table&& other) noexcept(
+        slot_traits::propagate_on_container_move_assignment::value ||
+        slot_traits::is_always_equal::value)
+    {
+        if (this == std::addressof(other))
+        {
+            return *this;
+        }
+        if constexpr (
+            slot_traits::propagate_on_container_move_assignment::value ||
+            slot_traits::is_always_equal::value)
+        {
+            destroy_storage();
+            reset_storage();
+            if constexpr (slot_traits::propagate_on_container_move_assignment::value)
+            {
+                alloc_ = std::move(other.alloc_);
+            }
+            swap_storage(other);
+            hash_  = std::move(other.hash_);
+            equal_ = std::move(other.equal_);
+        }
+        else
+        {
+            raw_table moved(std::move(other), allocator_type(alloc_));
+            swap_all(moved);
+        }
+        return *this;
+    }
+
+    ~raw_table() { destroy_storage(); }
+
+    allocator_type get_allocator() const { return allocator_type(alloc_); }
+    const Equal&   key_eq() const { return equal_; }
+    const Hash&    hash_function() const { return hash_; }
+
+    iterator begin()
+    {
+        iterator it(ctrl_, slots_);
+        it.skip_empty_or_deleted();
+        return it;
+    }
+    const_iterator begin() const
+    {
+        return const_cast<raw_table*>(this)->begin();  // NOLINT
+    }
+    const_iterator cbegin() const { return begin(); }
+    iterator       end() { return iterator(ctrl_ + capacity_, slots_ + capacity_); }
+    const_iterator end() const
+    {
+        return const_cast<raw_table*>(this)->end();  // NOLINT
+    }
+    const_iterator cend() const { return end(); }
+
+    iterator find(const key_type_& key)
+    {
+        uint64_t const hash = mix_hash(hash_(key));
+        return iterator_at(find_index(key, hash));
+    }
+    const_iterator find(const key_type_& key) const
+    {
+        return const_cast<raw_table*>(this)->find(key);  // NOLINT
+    }
+    uint64_t count(const key_type_& key) const { return find(key) == end() ? 0 : 1; }
+
+    std::pair<iterator, iterator> equal_range(const key_type_& key)
+    {
+        iterator found = find(key);
+        if (found == end())
+        {
+            return {found, found};
+        }
+        return {found, std::next(found)};
+    }
+    std::pair<const_iterator, const_iterator> equal_range(const key_type_& key) const
+    {
+        const_iterator found = find(key);
+        if (found == end())
+        {
+            return {found, found};
+        }
+        return {found, std::next(found)};
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return emplace_unique(Policy::key(value), value);
+    }
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return emplace_unique(Policy::key(value), std::move(value));
+    }
+    iterator insert(const_iterator, const value_type& value) { return insert(value).first; }
+    iterator insert(const_iterator, value_type&& value) { return insert(std::move(value)).first; }
+
+    template <typename It>
+    void insert(It first, It last)
+    {
+        if constexpr (std::is_base_of_v<
+                          std::forward_iterator_tag,
+                          typename std::iterator_traits<It>::iterator_category>)
+        {
+            reserve(size_ + static_cast<uint64_t>(std::distance(first, last)));
+        }
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+    void insert(std::initializer_list<value_type> il) { insert(il.begin(), il.end()); }
+
+    iterator erase(const_iterator position)
+    {
+        auto const index = static_cast<uint64_t>(position.ctrl_ - ctrl_);
+        erase_at(index);
+        iterator next(ctrl_ + index + 1, slots_ + index + 1);
+        next.skip_empty_or_deleted();
+        return next;
+    }
+    iterator erase(iterator position) { return erase(const_iterator(position)); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        while (first != last)
+        {
+            first = erase(first);
+        }
+        return iterator_at(static_cast<uint64_t>(last.ctrl_ - ctrl_));
+    }
+
+    uint64_t erase(const key_type_& key)
+    {
+        uint64_t const index = find_index(key, mix_hash(hash_(key)));
+        if (index == capacity_)
+        {
+            return 0;
+        }
+        erase_at(index);
+        return 1;
+    }
+
+    void clear()
+    {
+        if (capacity_ == 0)
+        {
+            return;
+        }
+        destroy_elements();
+        std::memset(ctrl_, ctrl_empty, capacity_ + group::width);
+        ctrl_[capacity_] = ctrl_sentinel;
+        size_            = 0;
+        growth_left_     = capacity_to_growth(capacity_);
+    }
+
+    void swap(raw_table& other) noexcept
+    {
+        using std::swap;
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+        if constexpr (slot_traits::propagate_on_container_swap::value)
+        {
+            swap(alloc_, other.alloc_);
+        }
+        swap_storage(other);
+    }
+
+    /// Size the table for at least num_buckets elements, or shrink to fit for 0
+    void rehash(uint64_t num_buckets)
+    {
+        uint64_t const wanted = (std::max)(num_buckets, size_);
+        if (wanted == 0)
+        {
+            destroy_storage();
+            reset_storage();
+            return;
+        }
+        uint64_t const capacity = growth_to_capacity(wanted);
+        if (capacity != capacity_)
+        {
+            resize(capacity);
+        }
+    }
+
+    void reserve(uint64_t num_elements)
+    {
+        if (num_elements > size_ + growth_left_)
+        {
+            resize(growth_to_capacity(num_elements));
+        }
+    }
+
+    void shrink_to_fit() { rehash(0); }
+
+    uint64_t  size() const { return size_; }
+    uint64_t  max_size() const { return slot_traits::max_size(alloc_); }
+    bool      empty() const { return size_ == 0; }
+    uint64_t  bucket_count() const { return capacity_; }
+    size_type max_bucket_count() const { return max_size(); }
+    float     load_factor() const
+    {
+        return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / static_cast<float>(capacity_);
+    }
+    float max_load_factor() const { return 0.875f; }
+    void  max_load_factor(float) {}
+
+protected:
+    /// Insert value_type(args...) unless an element with this key exists
+    template <typename... Args>
+    std::pair<iterator, bool> emplace_unique(const key_type_& key, Args&&... args)
+    {
+        uint64_t const hash  = mix_hash(hash_(key));
+        uint64_t const found = find_index(key, hash);
+        if (found != capacity_)
+        {
+            return {iterator_at(found), false};
+        }
+        uint64_t const index = prepare_insert(hash);
+        slot_traits::construct(alloc_, slots_ + index, std::forward<Args>(args)...);
+        return {iterator_at(index), true};
+    }
+
+    /// Insert value_type(args...), discarding it if its key exists
+    template <typename... Args>
+    std::pair<iterator, bool> emplace_constructed(Args&&... args)
+    {
+        value_type value(std::forward<Args>(args)...);
+        return emplace_unique(Policy::key(value), std::move(value));
+    }
+
+private:
+    iterator iterator_at(uint64_t index) { return iterator(ctrl_ + index, slots_ + index); }
+
+    /// Slot holding key, or capacity_ when absent
+    uint64_t find_index(const key_type_& key, uint64_t hash) const
+    {
+        probe_sequence seq(h1(hash), capacity_);
+        ctrl_t const   tag = h2(hash);
+        while (true)
+        {
+            group const g(ctrl_ + seq.offset());
+            for (int i : g.match(tag))
+            {
+                uint64_t const index = seq.offset(i);
+                if QUARISMA_LIKELY (equal_(Policy::key(slots_[index]), key))
+                {
+                    return index;
+                }
+            }
+            if QUARISMA_LIKELY (g.mask_empty())
+            {
+                return capacity_;
+            }
+            seq.next();
+        }
+    }
+
+    uint64_t find_first_non_full(uint64_t hash) const
+    {
+        probe_sequence seq(h1(hash), capacity_);
+        while (true)
+        {
+            auto const mask = group(ctrl_ + seq.offset()).mask_empty_or_deleted();
+            if (mask)
+            {
+                return seq.offset(mask.lowest());
+            }
+            seq.next();
+        }
+    }
+
+    /// Reserve a slot for a new element with this hash and mark it full
+    uint64_t prepare_insert(uint64_t hash)
+    {
+        uint64_t index = find_first_non_full(hash);
+        if QUARISMA_UNLIKELY (growth_left_ == 0 && ctrl_[index] != ctrl_deleted)
+        {
+            rehash_and_grow();
+            index = find_first_non_full(hash);
+        }
+        growth_left_ -= static_cast<uint64_t>(ctrl_[index] == ctrl_empty);
+        set_ctrl(index, h2(hash));
+        ++size_;
+        return index;
+    }
+
+    /// Out of empty slots: purge tombstones if they are many, else double
+    void rehash_and_grow()
+    {
+        if (capacity_ > group::width && size_ * 32 <= capacity_ * 25)
+        {
+            resize(capacity_);
+        }
+        else
+        {
+            resize(capacity_ * 2 + 1);
+        }
+    }
+
+    void erase_at(uint64_t index)
+    {
+        slot_traits::destroy(alloc_, slots_ + index);
+        --size_;
+
+        // The slot can become empty again when no probe sequence ever found
+        // its group full, i.e. a window of 16 slots around it has an empty.
+        uint64_t const index_before = (index - group::width) & capacity_;
+        auto const     empty_after  = group(ctrl_ + index).mask_empty();
+        auto const     empty_before = group(ctrl_ + index_before).mask_empty();
+        bool const     was_never_full =
+            empty_before && empty_after &&
+            empty_after.trailing_zeros_count() + empty_before.leading_zeros_count() < group::width;
+
+        set_ctrl(index, was_never_full ? ctrl_empty : ctrl_deleted);
+        growth_left_ += static_cast<uint64_t>(was_never_full);
+    }
+
+    // Writes the control byte and its clone past the sentinel
+    void set_ctrl(uint64_t index, ctrl_t value) noexcept
+    {
+        constexpr uint64_t cloned = group::width - 1;
+        ctrl_[index]                                                 = value;
+        ctrl_[((index - cloned) & capacity_) + (cloned & capacity_)] = value;
+    }
+
+    void resize(uint64_t new_capacity)
+    {
+        ctrl_t* const     old_ctrl     = ctrl_;
+        value_type* const old_slots    = slots_;
+        uint64_t const    old_capacity = capacity_;
+
+        ctrl_allocator ctrl_alloc(alloc_);
+        ctrl_ = ctrl_traits::allocate(ctrl_alloc, new_capacity + group::width);
+        try
+        {
+            slots_ = slot_traits::allocate(alloc_, new_capacity);
+        }
+        catch (...)
+        {
+            ctrl_traits::deallocate(ctrl_alloc, ctrl_, new_capacity + group::width);
+            ctrl_ = old_ctrl;
+            throw;
+        }
+        capacity_ = new_capacity;
+        std::memset(ctrl_, ctrl_empty, new_capacity + group::width);
+        ctrl_[new_capacity] = ctrl_sentinel;
+        growth_left_        = capacity_to_growth(new_capacity) - size_;
+
+        for (uint64_t i = 0; i < old_capacity; ++i)
+        {
+            if (is_full(old_ctrl[i]))
+            {
+                uint64_t const hash  = mix_hash(hash_(Policy::key(old_slots[i])));
+                uint64_t const index = find_first_non_full(hash);
+                set_ctrl(index, h2(hash));
+                slot_traits::construct(alloc_, slots_ + index, std::move(old_slots[i]));
+                slot_traits::destroy(alloc_, old_slots + i);
+            }
+        }
+
+        if (old_capacity != 0)
+        {
+            ctrl_traits::deallocate(ctrl_alloc, old_ctrl, old_capacity + group::width);
+            slot_traits::deallocate(alloc_, old_slots, old_capacity);
+        }
+    }
+
+    void copy_elements_from(const raw_table& other)
+    {
+        for (const value_type& value : other)
+        {
+            uint64_t const index = prepare_insert(mix_hash(hash_(Policy::key(value))));
+            slot_traits::construct(alloc_, slots_ + index, value);
+        }
+    }
+
+    void destroy_elements()
+    {
+        if constexpr (!std::is_trivially_destructible_v<value_type>)
+        {
+            for (uint64_t i = 0; i < capacity_; ++i)
+            {
+                if (is_full(ctrl_[i]))
+                {
+                    slot_traits::destroy(alloc_, slots_ + i);
+                }
+            }
+        }
+    }
+
+    void destroy_storage()
+    {
+        if (capacity_ == 0)
+        {
+            return;
+        }
+        destroy_elements();
+        ctrl_allocator ctrl_alloc(alloc_);
+        ctrl_traits::deallocate(ctrl_alloc, ctrl_, capacity_ + group::width);
+        slot_traits::deallocate(alloc_, slots_, capacity_);
+    }
+
+    void reset_storage() noexcept
+    {
+        ctrl_        = const_cast<ctrl_t*>(empty_group);  // NOLINT: never written to
+        slots_       = nullptr;
+        capacity_    = 0;
+        size_        = 0;
+        growth_left_ = 0;
+    }
+
+    void swap_storage(raw_table& other) noexcept
+    {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growth_left_, other.growth_left_);
+    }
+
+    void swap_all(raw_table& other) noexcept
+    {
+        using std::swap;
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+        // The allocators can only differ when assignment propagates them; the
+        // others, such as std::pmr::polymorphic_allocator, may not be assignable
+        if constexpr (
+            slot_traits::propagate_on_container_copy_assignment::value ||
+            slot_traits::propagate_on_container_move_assignment::value)
+        {
+            swap(alloc_, other.alloc_);
+        }
+        swap_storage(other);
+    }
+
+    ctrl_t*        ctrl_        = const_cast<ctrl_t*>(empty_group);  // NOLINT
+    value_type*    slots_       = nullptr;
+    uint64_t       capacity_    = 0;
+    uint64_t       size_        = 0;
+    uint64_t       growth_left_ = 0;
+    Hash           hash_{};
+    Equal          equal_{};
+    slot_allocator alloc_{};
+};
+}  // namespace detail::swiss
+
+template <
+    typename K,
+    typename V,
+    typename H = std::hash<K>,
+    typename E = std::equal_to<K>,
+    typename A = std::allocator<std::pair<K, V>>>
+class swiss_hash_map : public detail::swiss::raw_table<detail::swiss::map_policy<K, V>, H, E, A>
+{
+    using Table = detail::swiss::raw_table<detail::swiss::map_policy<K, V>, H, E, A>;
+
+public:
+    using key_type    = K;
+    using mapped_type = V;
+
+    using Table::Table;
+    swiss_hash_map() = default;
+
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+    V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+    const V& at(const K& key) const
+    {
+        auto it = this->find(key);
+        QUARISMA_CHECK(it != this->end(), "swiss_hash_map::at: key not found");
+        return it->second;
+    }
+    V& at(const K& key)
+    {
+        auto it = this->find(key);
+        QUARISMA_CHECK(it != this->end(), "swiss_hash_map::at: key not found");
+        return it->second;
+    }
+
+    bool contains(const K& key) const { return this->find(key) != this->end(); }
+
+    std::pair<typename Table::iterator, bool> emplace() { return try_emplace(K()); }
+
+    /// emplace(key, mapped) or emplace(pair); the key is looked up before constructing
+    template <typename Key, typename... Args>
+    std::pair<typename Table::iterator, bool> emplace(Key&& key, Args&&... args)
+    {
+        if constexpr (sizeof...(Args) == 0 && !std::is_convertible_v<Key, const K&>)
+        {
+            return this->emplace_unique(key.first, std::forward<Key>(key));
+        }
+        else if constexpr (std::is_same_v<std::decay_t<Key>, K>)
+        {
+            return this->emplace_unique(key, std::forward<Key>(key), std::forward<Args>(args)...);
+        }
+        else
+        {
+            return this->emplace_constructed(std::forward<Key>(key), std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename... Args>
+    typename Table::iterator emplace_hint(typename Table::const_iterator, Args&&... args)
+    {
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    template <typename... Args>
+    std::pair<typename Table::iterator, bool> try_emplace(const K& key, Args&&... args)
+    {
+        return this->emplace_unique(
+            key,
+            std::piecewise_construct,
+            std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    template <typename... Args>
+    std::pair<typename Table::iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        return this->emplace_unique(
+            key,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::move(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename M>
+    std::pair<typename Table::iterator, bool> insert_or_assign(const K& key, M&& m)
+    {
+        auto result = try_emplace(key, std::forward<M>(m));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(m);
+        }
+        return result;
+    }
+    template <typename M>
+    std::pair<typename Table::iterator, bool> insert_or_assign(K&& key, M&& m)
+    {
+        auto result = try_emplace(std::move(key), std::forward<M>(m));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(m);
+        }
+        return result;
+    }
+    template <typename M>
+    typename Table::iterator insert_or_assign(typename Table::const_iterator, const K& key, M&& m)
+    {
+        return insert_or_assign(key, std::forward<M>(m)).first;
+    }
+    template <typename M>
+    typename Table::iterator insert_or_assign(typename Table::const_iterator, K&& key, M&& m)
+    {
+        return insert_or_assign(std::move(key), std::forward<M>(m)).first;
+    }
+
+    friend bool operator==(const swiss_hash_map& lhs, const swiss_hash_map& rhs)
+    {
+        if (lhs.size() != rhs.size())
+        {
+            return false;
+        }
+        for (const auto& value : lhs)
+        {
+            auto found = rhs.find(value.first);
+            if (found == rhs.end() || value.second != found->second)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    friend bool operator!=(const swiss_hash_map& lhs, const swiss_hash_map& rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+template <
+    typename T,
+    typename H = std::hash<T>,
+    typename E = std::equal_to<T>,
+    typename A = std::allocator<T>>
+class swiss_hash_set : public detail::swiss::raw_table<detail::swiss::set_policy<T>, H, E, A>
+{
+    using Table = detail::swiss::raw_table<detail::swiss::set_policy<T>, H, E, A>;
+
+public:
+    using key_type = T;
+
+    using Table::Table;
+    swiss_hash_set() = default;
+
+    template <typename... Args>
+    std::pair<typename Table::iterator, bool> emplace(Args&&... args)
+    {
+        if constexpr (
+            sizeof...(Args) == 1 &&
+            std::conjunction_v<std::is_same<std::decay_t<Args>, T>...>)
+        {
+            return this->emplace_unique(args..., std::forward<Args>(args)...);
+        }
+        else
+        {
+            return this->emplace_constructed(std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename... Args>
+    typename Table::iterator emplace_hint(typename Table::const_iterator, Args&&... args)
+    {
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    bool contains(const T& key) const { return this->find(key) != this->end(); }
+
+    friend bool operator==(const swiss_hash_set& lhs, const swiss_hash_set& rhs)
+    {
+        if (lhs.size() != rhs.size())
+        {
+            return false;
+        }
+        return std::all_of(
+            lhs.begin(),
+            lhs.end(),
+            [&rhs](const T& value) { return rhs.find(value) != rhs.end(); });
+    }
+    friend bool operator!=(const swiss_hash_set& lhs, const swiss_hash_set& rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+}  // namespace quarisma
@@ -0,0 +1,386 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#include "util/tsc_clock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "logging/logger.h"
+#include "util/env.h"
+
+#if defined(QUARISMA_HAS_TSC_CLOCK) && !defined(__aarch64__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef __linux__
+#include <pthread.h>  // For pthread_setaffinity_np
+#include <sched.h>    // For sched_getaffinity
+#endif
+
+namespace quarisma
+{
+
+std::atomic<int>      tsc_clock::state_{tsc_clock::state_uninitialized};
+tsc_clock::conversion tsc_clock::conversion_;
+
+namespace
+{
+/// Number of (steady, ticks, steady) triples one sample keeps the tightest of
+constexpr int sample_tries = 16;
+
+/// Spin length of the initial calibration
+constexpr std::int64_t calibration_ns = 2'000'000;
+
+/// CPUs visited by the skew check
+constexpr int max_skew_cpus = 256;
+
+/**
+ * @brief A counter value and the steady_clock time it was read at
+ */
+struct sample
+{
+    std::uint64_t ticks_{};
+    std::int64_t  ns_{};
+    std::int64_t  window_ns_{};  ///< Uncertainty of ns_
+};
+
+sample take_sample() noexcept
+{
+    sample best;
+    best.window_ns_ = (std::numeric_limits<std::int64_t>::max)();
+    for (int i = 0; i < sample_tries; ++i)
+    {
+        std::int64_t const  before = tsc_clock::steady_ns();
+        std::uint64_t const t      = tsc_clock::ticks();
+        std::int64_t const  after  = tsc_clock::steady_ns();
+        if (after - before < best.window_ns_)
+        {
+            best = {t, before + (after - before) / 2, after - before};
+        }
+    }
+    return best;
+}
+
+std::uint64_t to_mult(double ns_per_tick) noexcept
+{
+    return static_cast<std::uint64_t>(std::llround(ns_per_tick * 4294967296.0));
+}
+
+/**
+ * @brief State shared by the calibration routines, guarded by mutex_
+ */
+struct calibration
+{
+    std::mutex   mutex_;
+    sample       anchor_;         ///< First calibration point
+    double       ns_per_tick_{};  ///< Long-term rate measured from anchor_
+    bool         usable_{};       ///< Whether the counter passed its checks
+    std::int64_t skew_ns_{};      ///< Result of the skew check
+
+    static calibration& instance()
+    {
+        static auto* c = new calibration();  // Leaked: timestamps are taken during shutdown
+        return *c;
+    }
+};
+
+bool invariant_counter() noexcept
+{
+#if defined(QUARISMA_HAS_TSC_CLOCK) && defined(__aarch64__)
+    // The generic timer runs at a fixed frequency by architecture
+    return true;
+#elif defined(QUARISMA_HAS_TSC_CLOCK) && defined(_MSC_VER)
+    int regs[4] = {};
+    __cpuid(regs, 0x80000000);
+    if (static_cast<unsigned>(regs[0]) < 0x80000007U)
+    {
+        return false;
+    }
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#elif defined(QUARISMA_HAS_TSC_CLOCK)
+    // Invariant TSC: CPUID.80000007H:EDX[8]
+    unsigned eax = 0;
+    unsigned ebx = 0;
+    unsigned ecx = 0;
+    unsigned edx = 0;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0)
+    {
+        return false;
+    }
+    return (edx & (1U << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Largest spread of ticks -> ns offsets across the CPUs of the process
+ *
+ * A helper thread moves itself to each CPU in turn and compares the
+ * conversion of the local counter with steady_clock. Returns 0 when the
+ * affinity cannot be queried or changed.
+ */
+std::int64_t measure_skew(const sample& anchor, double ns_per_tick)
+{
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) < 2)
+    {
+        return 0;
+    }
+
+    std::int64_t lowest  = (std::numeric_limits<std::int64_t>::max)();
+    std::int64_t highest = (std::numeric_limits<std::int64_t>::min)();
+    auto         visit   = [&]
+    {
+        int visited = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE && visited < max_skew_cpus; ++cpu)
+        {
+            if (!CPU_ISSET(cpu, &allowed))
+            {
+                continue;
+            }
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(one), &one) != 0)
+            {
+                continue;
+            }
+            ++visited;
+
+            sample const s         = take_sample();
+            auto const   delta     = static_cast<double>(static_cast<std::int64_t>(
+                s.ticks_ - anchor.ticks_));
+            auto const   converted = anchor.ns_ + static_cast<std::int64_t>(delta * ns_per_tick);
+            std::int64_t const offset = converted - s.ns_;
+            lowest                    = (std::min)(lowest, offset - s.window_ns_ / 2);
+            highest                   = (std::max)(highest, offset + s.window_ns_ / 2);
+        }
+    };
+
+    try
+    {
+        std::thread(visit).join();
+    }
+    catch (const std::exception&)
+    {
+        return 0;
+    }
+    return highest >= lowest ? highest - lowest : 0;
+#else
+    (void)anchor;
+    (void)ns_per_tick;
+    return 0;
+#endif
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+std::int64_t tsc_clock::initialize_and_read() noexcept
+{
+    static std::once_flag once;
+    std::call_once(
+        once,
+        []
+        {
+            auto& c = calibration::instance();
+            {
+                std::scoped_lock const lock(c.mutex_);
+
+                std::optional<bool> requested;
+                try
+                {
+                    requested = utils::check_env("QUARISMA_TSC_CLOCK");
+                }
+                catch (const std::exception&)
+                {
+                }
+
+                if (requested.value_or(true) && invariant_counter())
+                {
+                    c.anchor_                = take_sample();
+                    sample last              = c.anchor_;
+                    std::int64_t const until = c.anchor_.ns_ + calibration_ns;
+                    while (last.ns_ < until)
+                    {
+                        last = take_sample();
+                    }
+
+                    if (last.ticks_ > c.anchor_.ticks_)
+                    {
+                        c.ns_per_tick_ = static_cast<double>(last.ns_ - c.anchor_.ns_) /
+                                         static_cast<double>(last.ticks_ - c.anchor_.ticks_);
+                    }
+
+                    // Between 1 MHz and 100 GHz, anything else is a broken counter
+                    if (c.ns_per_tick_ > 0.01 && c.ns_per_tick_ < 1000.0)
+                    {
+                        c.skew_ns_ = measure_skew(c.anchor_, c.ns_per_tick_);
+                        c.usable_  = c.skew_ns_ <= max_skew_ns;
+
+                        conversion_.base_ticks_.store(c.anchor_.ticks_, std::memory_order_relaxed);
+                        conversion_.base_ns_.store(c.anchor_.ns_, std::memory_order_relaxed);
+                        conversion_.mult_.store(to_mult(c.ns_per_tick_), std::memory_order_relaxed);
+                        conversion_.next_ticks_.store(
+                            last.ticks_ + static_cast<std::uint64_t>(
+                                              static_cast<double>(recalibration_ns) /
+                                              c.ns_per_tick_),
+                            std::memory_order_relaxed);
+                    }
+                }
+                state_.store(c.usable_ ? state_tsc : state_steady, std::memory_order_release);
+            }
+
+            if (c.skew_ns_ > max_skew_ns)
+            {
+                QUARISMA_LOG_WARNING(
+                    "tsc_clock: counters differ by {} ns across CPUs, using steady_clock",
+                    c.skew_ns_);
+            }
+        });
+    return now_ns();
+}
+
+//-----------------------------------------------------------------------------
+void tsc_clock::recalibrate_from(std::uint64_t t) noexcept
+{
+    // Only one reader refines the conversion, the others keep extrapolating
+    auto& c = calibration::instance();
+    if (!c.mutex_.try_lock())
+    {
+        return;
+    }
+    std::scoped_lock const lock(std::adopt_lock, c.mutex_);
+
+    // Another reader got here first
+    if (t < conversion_.next_ticks_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    sample const s = take_sample();
+    if (!c.usable_ || s.ticks_ <= c.anchor_.ticks_)
+    {
+        return;
+    }
+
+    // Long-term rate, and the offset accumulated by the previous segment
+    c.ns_per_tick_ = static_cast<double>(s.ns_ - c.anchor_.ns_) /
+                     static_cast<double>(s.ticks_ - c.anchor_.ticks_);
+    std::uint64_t const base_ticks = conversion_.base_ticks_.load(std::memory_order_relaxed);
+    std::int64_t const  base_ns    = conversion_.base_ns_.load(std::memory_order_relaxed);
+    std::uint64_t const mult       = conversion_.mult_.load(std::memory_order_relaxed);
+    std::int64_t const  error      = std::clamp(
+        s.ns_ - (base_ns + scale(static_cast<std::int64_t>(s.ticks_ - base_ticks), mult)),
+        -recalibration_ns / 8,
+        recalibration_ns / 8);
+
+    // Absorb the error over the next interval: the slope stays positive, so
+    // readings stay monotonic, and the new segment starts where the old one is.
+    double const        interval_ticks = static_cast<double>(recalibration_ns) / c.ns_per_tick_;
+    std::uint64_t const next_mult =
+        to_mult(c.ns_per_tick_ + static_cast<double>(error) / interval_ticks);
+
+    std::uint32_t const seq = conversion_.sequence_.load(std::memory_order_relaxed);
+    conversion_.sequence_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::uint64_t const now = ticks();
+    conversion_.base_ns_.store(
+        base_ns + scale(static_cast<std::int64_t>(now - base_ticks), mult),
+        std::memory_order_relaxed);
+    conversion_.base_ticks_.store(now, std::memory_order_relaxed);
+    conversion_.mult_.store(next_mult, std::memory_order_relaxed);
+    conversion_.next_ticks_.store(
+        now + static_cast<std::uint64_t>(interval_ticks), std::memory_order_relaxed);
+
+    conversion_.sequence_.store(seq + 2, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+void tsc_clock::recalibrate() noexcept
+{
+    if (!available())
+    {
+        return;
+    }
+    // Make the next conversion due now, then refine it
+    {
+        auto&                  c = calibration::instance();
+        std::scoped_lock const lock(c.mutex_);
+        conversion_.next_ticks_.store(0, std::memory_order_relaxed);
+    }
+    recalibrate_from(ticks());
+}
+
+//-----------------------------------------------------------------------------
+bool tsc_clock::available() noexcept
+{
+    if (state_.load(std::memory_order_acquire) == state_uninitialized)
+    {
+        initialize_and_read();
+    }
+    return state_.load(std::memory_order_acquire) == state_tsc;
+}
+
+//-----------------------------------------------------------------------------
+double tsc_clock::ticks_per_second() noexcept
+{
+    if (!available())
+    {
+        return 0.0;
+    }
+    auto&                  c = calibration::instance();
+    std::scoped_lock const lock(c.mutex_);
+    return 1e9 / c.ns_per_tick_;
+}
+
+//-----------------------------------------------------------------------------
+std::int64_t tsc_clock::measured_skew_ns() noexcept
+{
+    available();
+    auto&                  c = calibration::instance();
+    std::scoped_lock const lock(c.mutex_);
+    return c.skew_ns_;
+}
+
+//-----------------------------------------------------------------------------
+bool tsc_clock::set_enabled(bool enable) noexcept
+{
+    available();
+    auto&                  c = calibration::instance();
+    std::scoped_lock const lock(c.mutex_);
+    state_.store(enable && c.usable_ ? state_tsc : state_steady, std::memory_order_release);
+    return state_.load(std::memory_order_relaxed) == state_tsc;
+}
+
+}  // namespace quarisma
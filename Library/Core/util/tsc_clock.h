@@ -0,0 +1,221 @@
+/*
+ * Quarisma: High-Performance Quantitative Library
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later OR Commercial
+ *
+ * This file is part of Quarisma and is licensed under a dual-license model:
+ *
+ *   - Open-source License (GPLv3):
+ *       Free for personal, academic, and research use under the terms of
+ *       the GNU General Public License v3.0 or later.
+ *
+ *   - Commercial License:
+ *       A commercial license is required for proprietary, closed-source,
+ *       or SaaS usage. Contact us to obtain a commercial agreement.
+ *
+ * Contact: licensing@quarisma.co.uk
+ * Website: https://www.quarisma.co.uk
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "common/export.h"
+#include "common/macros.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define QUARISMA_HAS_TSC_CLOCK 1
+#elif defined(__GNUC__) || defined(__clang__)
+#include <x86intrin.h>
+#define QUARISMA_HAS_TSC_CLOCK 1
+#endif
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define QUARISMA_HAS_TSC_CLOCK 1
+#endif
+
+namespace quarisma
+{
+
+/**
+ * @brief Calibrated cycle counter clock on the CLOCK_MONOTONIC timeline
+ *
+ * Reads the invariant TSC on x86 (cntvct_el0 on arm64) and converts ticks to
+ * nanoseconds with a fixed-point factor calibrated against
+ * std::chrono::steady_clock, so that its timestamps can be mixed with
+ * steady_clock ones. A read costs a few nanoseconds instead of a
+ * clock_gettime() call, which is what traceme and profiler_scope pay per
+ * event.
+ *
+ * The counter is calibrated lazily on first use. It is only used when:
+ * - on x86, CPUID reports an invariant TSC;
+ * - on Linux, the offsets measured on every CPU the process may run on agree
+ *   within max_skew_ns, so that timestamps taken on different cores compare;
+ * - QUARISMA_TSC_CLOCK is not set to 0 in the environment.
+ * Otherwise, and on other platforms, now_ns() reads steady_clock.
+ *
+ * Every recalibration_ns the conversion is refined against steady_clock:
+ * the long-term rate is measured from the first calibration, and the offset
+ * accumulated since the previous one is absorbed over the next interval, so
+ * readings stay continuous and monotonic on one core.
+ *
+ * tsc_clock satisfies the standard Clock requirements.
+ */
+class QUARISMA_VISIBILITY tsc_clock
+{
+public:
+    using rep                       = std::int64_t;
+    using period                    = std::nano;
+    using duration                  = std::chrono::nanoseconds;
+    using time_point                = std::chrono::time_point<tsc_clock>;
+    static constexpr bool is_steady = true;
+
+    /// Largest cross-CPU offset tolerated by the skew check
+    static constexpr std::int64_t max_skew_ns = 2000;
+
+    /// Interval between two recalibrations against steady_clock
+    static constexpr std::int64_t recalibration_ns = 1'000'000'000;
+
+    static time_point now() noexcept { return time_point(duration(now_ns())); }
+
+    /**
+     * @brief Current time in nanoseconds since the steady_clock epoch
+     */
+    static std::int64_t now_ns() noexcept
+    {
+#if defined(QUARISMA_HAS_TSC_CLOCK)
+        int const state = state_.load(std::memory_order_relaxed);
+        if QUARISMA_LIKELY (state == state_tsc)
+        {
+            return from_ticks(ticks());
+        }
+        if (state == state_uninitialized)
+        {
+            return initialize_and_read();
+        }
+#endif
+        return steady_ns();
+    }
+
+    /**
+     * @brief Raw counter value, not comparable with anything else
+     */
+    static std::uint64_t ticks() noexcept
+    {
+#if defined(QUARISMA_HAS_TSC_CLOCK) && defined(__aarch64__)
+        std::uint64_t value = 0;
+        __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#elif defined(QUARISMA_HAS_TSC_CLOCK)
+        return static_cast<std::uint64_t>(__rdtsc());
+#else
+        return static_cast<std::uint64_t>(steady_ns());
+#endif
+    }
+
+    /**
+     * @brief Whether now_ns() reads the counter, calibrating it if needed
+     */
+    QUARISMA_API static bool available() noexcept;
+
+    /**
+     * @brief Measured counter frequency, or 0 when the counter is not used
+     */
+    QUARISMA_API static double ticks_per_second() noexcept;
+
+    /**
+     * @brief Largest offset between CPUs found by the skew check
+     *
+     * 0 when the check did not run, e.g. outside Linux.
+     */
+    QUARISMA_API static std::int64_t measured_skew_ns() noexcept;
+
+    /**
+     * @brief Refine the conversion against steady_clock now
+     *
+     * Normally done by now_ns() every recalibration_ns.
+     */
+    QUARISMA_API static void recalibrate() noexcept;
+
+    /**
+     * @brief Make now_ns() read steady_clock (false) or the counter (true)
+     *
+     * Enabling only takes effect when the counter passed its checks.
+     * @return whether now_ns() reads the counter afterwards
+     */
+    QUARISMA_API static bool set_enabled(bool enable) noexcept;
+
+    static std::int64_t steady_ns() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    static constexpr int state_uninitialized = 0;
+    static constexpr int state_tsc           = 1;
+    static constexpr int state_steady        = 2;
+
+    /**
+     * @brief Linear segment ticks -> ns, published through a sequence lock
+     *
+     * ns = base_ns_ + (ticks - base_ticks_) * mult_ / 2^32
+     */
+    struct conversion
+    {
+        std::atomic<std::uint32_t> sequence_{0};
+        std::atomic<std::uint64_t> base_ticks_{0};
+        std::atomic<std::int64_t>  base_ns_{0};
+        std::atomic<std::uint64_t> mult_{0};
+        std::atomic<std::uint64_t> next_ticks_{0};  ///< Recalibrate once ticks pass this
+    };
+
+    static std::int64_t from_ticks(std::uint64_t t) noexcept
+    {
+        std::uint32_t seq        = 0;
+        std::uint64_t base_ticks = 0;
+        std::int64_t  base_ns    = 0;
+        std::uint64_t mult       = 0;
+        std::uint64_t next_ticks = 0;
+        do
+        {
+            seq        = conversion_.sequence_.load(std::memory_order_acquire);
+            base_ticks = conversion_.base_ticks_.load(std::memory_order_relaxed);
+            base_ns    = conversion_.base_ns_.load(std::memory_order_relaxed);
+            mult       = conversion_.mult_.load(std::memory_order_relaxed);
+            next_ticks = conversion_.next_ticks_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1U) != 0 || seq != conversion_.sequence_.load(std::memory_order_relaxed));
+
+        if QUARISMA_UNLIKELY (t >= next_ticks)
+        {
+            recalibrate_from(t);
+        }
+        return base_ns + scale(static_cast<std::int64_t>(t - base_ticks), mult);
+    }
+
+    static std::int64_t scale(std::int64_t delta_ticks, std::uint64_t mult) noexcept
+    {
+#if defined(__SIZEOF_INT128__)
+        return static_cast<std::int64_t>((static_cast<__int128>(delta_ticks) * mult) >> 32);
+#else
+        return static_cast<std::int64_t>(
+            static_cast<long double>(delta_ticks) * static_cast<long double>(mult) /
+            4294967296.0L);
+#endif
+    }
+
+    QUARISMA_API static std::int64_t initialize_and_read() noexcept;
+    QUARISMA_API static void         recalibrate_from(std::uint64_t t) noexcept;
+
+    QUARISMA_API static std::atomic<int> state_;
+    QUARISMA_API static conversion       conversion_;
+};
+
+}  // namespace quarisma
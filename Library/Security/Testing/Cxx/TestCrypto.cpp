@@ -1,7 +1,23 @@
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "Core/Testing/baseTest.h"
+#include "chacha20.h"
 #include "crypto.h"
 
 using namespace quarisma::security;
@@ -108,6 +124,123 @@ QUARISMATEST(crypto_test, generate_random_string_empty_charset)
     EXPECT_FALSE(result.has_value());
 }
 
+QUARISMATEST(crypto_test, generate_random_bytes_request_sizes)
+{
+    // Small requests share the per-thread buffer, larger ones bypass it; none
+    // may repeat output
+    std::vector<std::array<uint8_t, 16>> nonces(1000);
+    for (auto& nonce : nonces)
+    {
+        ASSERT_TRUE(crypto::generate_random_bytes(nonce.data(), nonce.size()));
+    }
+    std::sort(nonces.begin(), nonces.end());
+    EXPECT_EQ(std::adjacent_find(nonces.begin(), nonces.end()), nonces.end());
+
+    for (size_t size : {991u, 992u, 1023u, 1024u, 4096u + 7u, (2u << 20) + 13u})
+    {
+        std::vector<uint8_t> first(size);
+        std::vector<uint8_t> second(size);
+        ASSERT_TRUE(crypto::generate_random_bytes(first.data(), size));
+        ASSERT_TRUE(crypto::generate_random_bytes(second.data(), size));
+        EXPECT_NE(first, second);
+
+        // The last bytes are filled too
+        size_t const tail = std::min<size_t>(size, 64);
+        EXPECT_FALSE(std::all_of(
+            first.end() - static_cast<std::ptrdiff_t>(tail),
+            first.end(),
+            [](uint8_t b) { return b == 0; }));
+    }
+}
+
+QUARISMATEST(crypto_test, generate_random_bytes_threads)
+{
+    constexpr size_t                     kThreads = 4;
+    std::vector<std::array<uint8_t, 32>> values(kThreads);
+    std::vector<std::thread>             threads;
+    for (size_t t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&values, t]() { crypto::generate_random_bytes(values[t].data(), values[t].size()); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(std::adjacent_find(values.begin(), values.end()), values.end());
+}
+
+#if !defined(_WIN32)
+QUARISMATEST(crypto_test, generate_random_bytes_after_fork)
+{
+    // Seed the generator of this thread, then compare the next bytes of the
+    // parent and of a child, which must not replay them
+    std::array<uint8_t, 32> parent{};
+    std::array<uint8_t, 32> child{};
+    ASSERT_TRUE(crypto::generate_random_bytes(parent.data(), parent.size()));
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t const pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        close(fds[0]);
+        bool const ok = crypto::generate_random_bytes(child.data(), child.size()) &&
+                        write(fds[1], child.data(), child.size()) ==
+                            static_cast<ssize_t>(child.size());
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    ASSERT_TRUE(crypto::generate_random_bytes(parent.data(), parent.size()));
+    EXPECT_EQ(read(fds[0], child.data(), child.size()), static_cast<ssize_t>(child.size()));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_NE(parent, child);
+}
+#endif
+
+QUARISMATEST(crypto_test, chacha20_kernels_rfc8439_vectors)
+{
+    // RFC 8439, section 2.3.2
+    std::array<uint32_t, 8> key{};
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        key[i] = (4 * i) | ((4 * i + 1) << 8) | ((4 * i + 2) << 16) | ((4 * i + 3) << 24);
+    }
+    std::array<uint32_t, 3> const nonce    = {0x09000000, 0x4a000000, 0x00000000};
+    std::array<uint8_t, 64> const expected = {
+        0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3,
+        0x20, 0x71, 0xc4, 0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22,
+        0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e, 0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa,
+        0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2, 0xb5, 0x12, 0x9c, 0xd1,
+        0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e};
+
+    for (int c = 0; c <= static_cast<int>(quarisma::cpu_info::capability()); ++c)
+    {
+        auto const kernel =
+            detail::chacha20_blocks_stub_type::kernel(static_cast<quarisma::cpu_capability>(c));
+
+        std::array<uint8_t, 64> block{};
+        kernel(key.data(), nonce.data(), 1, block.data(), 1);
+        EXPECT_EQ(block, expected);
+
+        // Runs of blocks, through the vector path, match the blocks one by one
+        constexpr size_t     kBlocks = 37;
+        std::vector<uint8_t> run(kBlocks * 64);
+        kernel(key.data(), nonce.data(), 1, run.data(), kBlocks);
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), run.begin()));
+        for (size_t b = 0; b < kBlocks; ++b)
+        {
+            kernel(key.data(), nonce.data(), static_cast<uint32_t>(1 + b), block.data(), 1);
+            EXPECT_TRUE(std::equal(block.begin(), block.end(), run.begin() + b * 64));
+        }
+    }
+}
+
 // ============================================================================
 // SHA-256 Hashing Tests
 // ============================================================================
@@ -170,6 +303,184 @@ QUARISMATEST(crypto_test, sha256_deterministic)
     EXPECT_EQ(hash1, hash2);
 }
 
+namespace
+{
+const crypto::sha256_kernel all_sha256_kernels[] = {
+    crypto::sha256_kernel::scalar,
+    crypto::sha256_kernel::avx2,
+    crypto::sha256_kernel::sha_ni,
+    crypto::sha256_kernel::armv8};
+}  // namespace
+
+QUARISMATEST(crypto_test, sha256_kernels_nist_vectors)
+{
+    std::string const million_a(1000000, 'a');
+
+    for (auto const kernel : all_sha256_kernels)
+    {
+        if (!crypto::select_sha256_kernel(kernel))
+        {
+            continue;
+        }
+        EXPECT_EQ(crypto::active_sha256_kernel(), kernel);
+        EXPECT_EQ(
+            crypto::sha256_hex("abc"),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        EXPECT_EQ(
+            crypto::sha256_hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        EXPECT_EQ(
+            crypto::sha256_hex(million_a),
+            "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+
+    EXPECT_TRUE(crypto::select_sha256_kernel(crypto::sha256_kernel::automatic));
+    EXPECT_NE(crypto::active_sha256_kernel(), crypto::sha256_kernel::automatic);
+}
+
+QUARISMATEST(crypto_test, sha256_many_matches_sha256)
+{
+    // Lengths around the one- and two-block padding boundaries
+    std::string text(400, '\0');
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        text[i] = static_cast<char>(i * 131 + 7);
+    }
+    crypto::select_sha256_kernel(crypto::sha256_kernel::scalar);
+    std::vector<std::array<uint8_t, 32>> expected;
+    std::vector<std::string_view>        inputs;
+    for (size_t size = 0; size <= 300; ++size)
+    {
+        inputs.emplace_back(text.data() + size % 7, size);
+        expected.push_back(crypto::sha256(inputs.back()));
+    }
+
+    for (auto const kernel : all_sha256_kernels)
+    {
+        if (!crypto::select_sha256_kernel(kernel))
+        {
+            continue;
+        }
+        // Batches smaller and larger than the lane count
+        for (size_t const batch : {size_t{1}, size_t{3}, size_t{8}, size_t{13}, inputs.size()})
+        {
+            for (size_t first = 0; first < inputs.size(); first += batch)
+            {
+                size_t const last = (std::min)(first + batch, inputs.size());
+                std::vector<std::string_view> const slice(
+                    inputs.begin() + first, inputs.begin() + last);
+                auto const hashes = crypto::sha256_many(slice);
+                ASSERT_EQ(hashes.size(), slice.size());
+                for (size_t i = 0; i < slice.size(); ++i)
+                {
+                    EXPECT_EQ(hashes[i], expected[first + i]);
+                }
+            }
+        }
+    }
+    EXPECT_TRUE(crypto::sha256_many({}).empty());
+
+    crypto::select_sha256_kernel(crypto::sha256_kernel::automatic);
+}
+
+QUARISMATEST(crypto_test, sha256_kernels_throughput)
+{
+    std::string const                   large(size_t{8} << 20, 'x');
+    std::vector<std::string>            small(1 << 16, std::string(64, 'y'));
+    std::vector<std::string_view> const small_views(small.begin(), small.end());
+
+    auto const megabytes_per_second = [](size_t bytes, auto&& hash_once)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        hash_once();
+        double const seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(bytes) / (1 << 20) / seconds;
+    };
+
+    std::cout << "\n=== SHA-256 Throughput (MB/s: 8 MB buffer, 64K x 64-byte messages) ===\n";
+    const char* const names[] = {"automatic", "scalar", "avx2", "sha_ni", "armv8"};
+    for (auto const kernel : all_sha256_kernels)
+    {
+        if (!crypto::select_sha256_kernel(kernel))
+        {
+            continue;
+        }
+        double const single = megabytes_per_second(
+            large.size(), [&] { EXPECT_EQ(crypto::sha256(large).size(), 32U); });
+        double const many = megabytes_per_second(
+            small.size() * 64,
+            [&] { EXPECT_EQ(crypto::sha256_many(small_views).size(), small.size()); });
+        std::cout << std::left << std::setw(8) << names[static_cast<int>(kernel)] << std::right
+                  << std::fixed << std::setprecision(0) << std::setw(8) << single << std::setw(8)
+                  << many << "\n";
+    }
+
+    crypto::select_sha256_kernel(crypto::sha256_kernel::automatic);
+}
+
+QUARISMATEST(crypto_test, sha256_hasher_matches_one_shot)
+{
+    std::string text(5000, '\0');
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        text[i] = static_cast<char>(i * 37 + 11);
+    }
+
+    // Chunks that split blocks anywhere, including empty ones
+    for (size_t const chunk :
+         {size_t{1}, size_t{7}, size_t{63}, size_t{64}, size_t{65}, size_t{1000}})
+    {
+        sha256_hasher hasher;
+        for (size_t done = 0; done < text.size(); done += chunk)
+        {
+            hasher.update(std::string_view(text).substr(done, chunk)).update(nullptr, 0);
+        }
+        EXPECT_EQ(hasher.size(), text.size());
+        EXPECT_EQ(hasher.digest(), crypto::sha256(text));
+    }
+
+    // digest() does not consume the input, reset() discards it
+    sha256_hasher hasher;
+    EXPECT_EQ(hasher.hex_digest(), crypto::sha256_hex(""));
+    hasher.update("ab");
+    EXPECT_EQ(hasher.digest(), crypto::sha256("ab"));
+    hasher.update("c");
+    EXPECT_EQ(
+        hasher.hex_digest(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    hasher.reset();
+    EXPECT_EQ(hasher.size(), 0U);
+    EXPECT_EQ(hasher.update("hello").digest(), crypto::sha256("hello"));
+}
+
+QUARISMATEST(crypto_test, sha256_file)
+{
+    auto const path = std::filesystem::temp_directory_path() / "quarisma_test_sha256_file.bin";
+
+    std::string content((size_t{3} << 20) + 123, '\0');
+    for (size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<char>((i * 2654435761U) >> 13);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+    auto const hash = crypto::sha256_file(path.string());
+    ASSERT_TRUE(hash.has_value());
+    EXPECT_EQ(*hash, crypto::sha256(content));
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    }
+    auto const empty = crypto::sha256_file(path.string());
+    ASSERT_TRUE(empty.has_value());
+    EXPECT_EQ(*empty, crypto::sha256(""));
+
+    std::filesystem::remove(path);
+    EXPECT_FALSE(crypto::sha256_file(path.string()).has_value());
+}
+
 // ============================================================================
 // Constant-Time Comparison Tests
 // ============================================================================
@@ -198,6 +509,66 @@ QUARISMATEST(crypto_test, constant_time_compare_null_pointers)
     EXPECT_FALSE(crypto::constant_time_compare(nullptr, nullptr, 3));
 }
 
+QUARISMATEST(crypto_test, constant_time_compare_detects_every_position)
+{
+    for (size_t size = 1; size < 100; ++size)
+    {
+        std::vector<uint8_t> a(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            a[i] = static_cast<uint8_t>(i * 13 + 7);
+        }
+        std::vector<uint8_t> b = a;
+        EXPECT_TRUE(crypto::constant_time_compare(a.data(), b.data(), size));
+        for (size_t i = 0; i < size; ++i)
+        {
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                b[i] ^= static_cast<uint8_t>(1U << bit);
+                EXPECT_FALSE(crypto::constant_time_compare(a.data(), b.data(), size));
+                b[i] ^= static_cast<uint8_t>(1U << bit);
+            }
+        }
+    }
+}
+
+QUARISMATEST(crypto_test, constant_time_compare_time_is_independent_of_difference)
+{
+    // An early exit would make a difference in the first byte about 1000x
+    // faster than one in the last byte; the bound only allows noise
+    size_t const         size = 256 * 1024;
+    std::vector<uint8_t> a(size, 0x5a);
+    std::vector<uint8_t> first = a;
+    std::vector<uint8_t> last  = a;
+    first.front() ^= 1;
+    last.back() ^= 1;
+
+    auto median_ns = [&](const std::vector<uint8_t>& b)
+    {
+        std::vector<int64_t> samples;
+        for (int run = 0; run < 31; ++run)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            for (int i = 0; i < 8; ++i)
+            {
+                EXPECT_FALSE(crypto::constant_time_compare(a.data(), b.data(), size));
+            }
+            samples.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+        }
+        std::nth_element(samples.begin(), samples.begin() + 15, samples.end());
+        return static_cast<double>(samples[15]);
+    };
+
+    median_ns(first);  // Warm up
+    double const early = median_ns(first);
+    double const late  = median_ns(last);
+    EXPECT_GT(early, late / 4) << "early difference " << early << " ns, late " << late << " ns";
+    EXPECT_LT(early, late * 4) << "early difference " << early << " ns, late " << late << " ns";
+}
+
 QUARISMATEST(crypto_test, constant_time_compare_strings_equal)
 {
     EXPECT_TRUE(crypto::constant_time_compare("hello", "hello"));
@@ -282,6 +653,57 @@ QUARISMATEST(crypto_test, hex_roundtrip)
             result.value().begin(), result.value().end(), original, original + sizeof(original)));
 }
 
+QUARISMATEST(crypto_test, hex_codecs_all_lengths)
+{
+    // Sizes straddling the 16-byte SIMD blocks, with every byte value
+    for (size_t size = 0; size < 100; ++size)
+    {
+        std::vector<uint8_t> data(size);
+        std::string          expected;
+        for (size_t i = 0; i < size; ++i)
+        {
+            data[i] = static_cast<uint8_t>(i * 37 + size);
+            char digits[3];
+            std::snprintf(digits, sizeof(digits), "%02x", data[i]);
+            expected += digits;
+        }
+
+        std::string const hex = crypto::bytes_to_hex(data.data(), data.size());
+        EXPECT_EQ(hex, expected);
+
+        std::string upper = hex;
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        auto const lower_bytes = crypto::hex_to_bytes(hex);
+        auto const upper_bytes = crypto::hex_to_bytes(upper);
+        ASSERT_TRUE(lower_bytes.has_value());
+        ASSERT_TRUE(upper_bytes.has_value());
+        EXPECT_EQ(lower_bytes.value(), data);
+        EXPECT_EQ(upper_bytes.value(), data);
+    }
+}
+
+QUARISMATEST(crypto_test, hex_to_bytes_rejects_every_non_digit)
+{
+    // Every position of a string longer than one SIMD block, every byte value
+    std::string const valid(70, 'a');
+    for (size_t position = 0; position < valid.size(); ++position)
+    {
+        for (int c = 0; c < 256; ++c)
+        {
+            std::string hex = valid;
+            hex[position]   = static_cast<char>(c);
+            bool const digit =
+                (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+            EXPECT_EQ(crypto::hex_to_bytes(hex).has_value(), digit) << position << " " << c;
+        }
+    }
+
+    // Sign and space prefixes are not digits either
+    EXPECT_FALSE(crypto::hex_to_bytes("+f").has_value());
+    EXPECT_FALSE(crypto::hex_to_bytes("-1").has_value());
+    EXPECT_FALSE(crypto::hex_to_bytes(" f").has_value());
+}
+
 // ============================================================================
 // Secure Zero Memory Tests
 // ============================================================================
@@ -85,6 +85,38 @@ QUARISMATEST(input_validator_test, has_no_null_bytes_invalid)
     EXPECT_FALSE(input_validator::has_no_null_bytes(with_null));
 }
 
+QUARISMATEST(input_validator_test, string_checks_every_position)
+{
+    // A failing byte at every position of every length around the vector widths
+    for (size_t size = 1; size <= 140; ++size)
+    {
+        std::string const clean(size, 'q');
+        EXPECT_TRUE(input_validator::is_alphanumeric(clean));
+        EXPECT_TRUE(input_validator::is_printable_ascii(clean));
+        EXPECT_TRUE(input_validator::has_no_null_bytes(clean));
+
+        for (size_t pos = 0; pos < size; ++pos)
+        {
+            for (char const bad : {'\0', '\x1f', '\x7f', static_cast<char>(0xE9), ' ', '/', ':'})
+            {
+                std::string input = clean;
+                input[pos]        = bad;
+                bool const printable =
+                    static_cast<unsigned char>(bad) >= 32 && static_cast<unsigned char>(bad) <= 126;
+                EXPECT_FALSE(input_validator::is_alphanumeric(input));
+                EXPECT_EQ(input_validator::is_printable_ascii(input), printable);
+                EXPECT_EQ(input_validator::has_no_null_bytes(input), bad != '\0');
+            }
+            for (char const good : {'0', '9', 'A', 'Z', 'a', 'z'})
+            {
+                std::string input = clean;
+                input[pos]        = good;
+                EXPECT_TRUE(input_validator::is_alphanumeric(input));
+            }
+        }
+    }
+}
+
 // ============================================================================
 // Numeric Validation Tests
 // ============================================================================
@@ -0,0 +1,153 @@
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "Core/Testing/baseTest.h"
+#include "input_validator.h"
+#include "pattern.h"
+
+using namespace quarisma::security;
+
+namespace
+{
+pattern compiled(std::string_view expression)
+{
+    auto result = pattern::compile(expression);
+    EXPECT_TRUE(result.has_value()) << expression;
+    return result ? *result : *pattern::compile("");
+}
+}  // namespace
+
+// ============================================================================
+// Pattern Compilation Tests
+// ============================================================================
+
+QUARISMATEST(pattern_test, compile_invalid)
+{
+    for (const char* const expression :
+         {"(", ")", "a)", "[a", "[z-a]", "a{", "a{2", "a{3,1}", "a{1001}", "*a", "a|*", "\\",
+          "\\1", "\\b", "\\xZZ", "a^", "$a", "(?=a)"})
+    {
+        EXPECT_FALSE(pattern::compile(expression).has_value()) << expression;
+    }
+
+    // Counted repetitions are expanded, and the state count is bounded
+    EXPECT_FALSE(pattern::compile("(a|b)*a(a|b){20}").has_value());
+    EXPECT_TRUE(pattern::compile("(a|b)*a(a|b){8}").has_value());
+}
+
+QUARISMATEST(pattern_test, matches_whole_input)
+{
+    pattern const empty = compiled("");
+    EXPECT_TRUE(empty.matches(""));
+    EXPECT_FALSE(empty.matches("a"));
+
+    pattern const literal = compiled("^abc$");
+    EXPECT_TRUE(literal.matches("abc"));
+    EXPECT_FALSE(literal.matches("abcd"));
+    EXPECT_FALSE(literal.matches("xabc"));
+    EXPECT_EQ(literal.expression(), "^abc$");
+
+    pattern const alternation = compiled("cat|dog|(?:gold)?fish");
+    for (const char* const s : {"cat", "dog", "fish", "goldfish"})
+    {
+        EXPECT_TRUE(alternation.matches(s)) << s;
+    }
+    for (const char* const s : {"", "ca", "cats", "gold", "goldgoldfish"})
+    {
+        EXPECT_FALSE(alternation.matches(s)) << s;
+    }
+
+    pattern const counted = compiled("a{2,3}b{2,}c{0,1}d*");
+    EXPECT_TRUE(counted.matches("aabb"));
+    EXPECT_TRUE(counted.matches("aaabbbbbcddd"));
+    EXPECT_FALSE(counted.matches("abb"));
+    EXPECT_FALSE(counted.matches("aaaabb"));
+    EXPECT_FALSE(counted.matches("aab"));
+    EXPECT_FALSE(counted.matches("aabbcc"));
+
+    pattern const escapes = compiled("\\d\\w\\s\\.\\x41[\\]\\-a-c]\\D\\W\\S.");
+    EXPECT_TRUE(escapes.matches("7_ .A]x!yz"));
+    EXPECT_TRUE(escapes.matches("0a\t.A-_ 9\xff"));
+    EXPECT_FALSE(escapes.matches("0a\t.A-_ 9\n"));
+    EXPECT_FALSE(escapes.matches("0a\t,A-_ 9z"));
+
+    pattern const negated = compiled("[^0-9,]+");
+    EXPECT_TRUE(negated.matches("abc\xe9"));
+    EXPECT_FALSE(negated.matches("ab,c"));
+    EXPECT_FALSE(negated.matches(""));
+
+    // Nested unbounded loops do not blow up
+    pattern const nested = compiled("(a*)*(b|a+)*c");
+    EXPECT_TRUE(nested.matches(std::string(10000, 'a') + "c"));
+    EXPECT_FALSE(nested.matches(std::string(10000, 'a')));
+}
+
+QUARISMATEST(pattern_test, agrees_with_std_regex)
+{
+    const char* const expressions[] = {
+        "[A-Za-z_][A-Za-z0-9_]*",
+        "[+-]?\\d+(\\.\\d+)?([eE][+-]?\\d+)?",
+        "[A-Z]{2}[A-Z0-9]{9}\\d",
+        "\\d{4}-(0[1-9]|1[0-2])-(0[1-9]|[12]\\d|3[01])",
+        "(a|ab)(c|bcd)(d*)",
+        "x*(xy?)*z?",
+    };
+    const char* const inputs[] = {
+        "",  "a", "_x9", "9x", "-12.5e+3", "1.", "+7", "US0378331005", "us0378331005",
+        "2024-02-29", "2024-13-01", "abcd", "abcdd", "acd", "xxyxz", "xyy", "x"};
+
+    for (const char* const expression : expressions)
+    {
+        pattern const    compiled_pattern = compiled(expression);
+        std::regex const reference(expression);
+        for (const char* const input : inputs)
+        {
+            EXPECT_EQ(
+                input_validator::matches_pattern(input, compiled_pattern),
+                input_validator::matches_pattern(input, reference))
+                << expression << " on \"" << input << "\"";
+        }
+    }
+}
+
+QUARISMATEST(pattern_test, throughput_vs_std_regex)
+{
+    const char* const expression = "[A-Z]{2}[A-Z0-9]{9}\\d";
+    pattern const     isin       = compiled(expression);
+    std::regex const  reference(expression);
+
+    std::vector<std::string> fields;
+    for (int i = 0; i < 1000; ++i)
+    {
+        fields.push_back(i % 4 == 0 ? "US037833100Z" : "US037833100" + std::to_string(i % 10));
+    }
+
+    auto const fields_per_second = [&fields](int rounds, auto&& match)
+    {
+        size_t     matched = 0;
+        auto const start   = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (const auto& field : fields)
+            {
+                matched += match(field) ? 1 : 0;
+            }
+        }
+        double const seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        EXPECT_EQ(matched, static_cast<size_t>(rounds) * 750);
+        return static_cast<double>(fields.size()) * rounds / seconds;
+    };
+
+    double const dfa = fields_per_second(
+        1000, [&isin](const std::string& f) { return isin.matches(f); });
+    double const regex = fields_per_second(
+        20, [&reference](const std::string& f) { return std::regex_match(f, reference); });
+
+    std::cout << "\n=== ISIN validation (fields/s) ===\n"
+              << "pattern:    " << dfa << "\n"
+              << "std::regex: " << regex << "\n";
+}
@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <limits>
+#include <string>
+#include <utility>
 
 #include "Core/Testing/baseTest.h"
 #include "sanitizer.h"
@@ -270,3 +274,122 @@ QUARISMATEST(sanitizer_test, path_with_null_bytes)
     std::string result = sanitizer::sanitize_path(path);
     EXPECT_EQ(result.find('\0'), std::string::npos);
 }
+
+// ============================================================================
+// Vectorized Scanning Tests
+// ============================================================================
+
+namespace
+{
+// Byte-by-byte references for the scanning routines
+std::string reference_remove_non_printable(std::string_view str)
+{
+    std::string result;
+    for (unsigned char const c : str)
+    {
+        if (c >= 32 && c <= 126)
+        {
+            result += static_cast<char>(c);
+        }
+    }
+    return result;
+}
+
+std::string reference_escape_json(std::string_view str)
+{
+    std::string result;
+    for (unsigned char const c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += static_cast<char>(c);
+        }
+        else if (c < 32)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        }
+        else
+        {
+            result += static_cast<char>(c);
+        }
+    }
+    // Short forms of the common control characters
+    for (auto [from, to] : {std::pair<const char*, const char*>{"\\u0008", "\\b"},
+                            {"\\u000c", "\\f"},
+                            {"\\u000a", "\\n"},
+                            {"\\u000d", "\\r"},
+                            {"\\u0009", "\\t"}})
+    {
+        for (size_t pos = result.find(from); pos != std::string::npos; pos = result.find(from, pos))
+        {
+            result.replace(pos, 6, to);
+        }
+    }
+    return result;
+}
+}  // namespace
+
+QUARISMATEST(sanitizer_test, scan_matches_bytewise_reference)
+{
+    // One special byte at every position of every length around the vector
+    // widths, on top of clean text that includes bytes of 128 and above
+    char const  specials[] = {'\0', '\x01', '\x1f', '\x7f', '"', '\\', '<', '>', '&', '\'', '\n'};
+    std::string buffer;
+    for (size_t size = 0; size <= 140; ++size)
+    {
+        std::string ascii(size, '\0');
+        for (size_t i = 0; i < size; ++i)
+        {
+            ascii[i] = static_cast<char>('a' + i % 26);
+        }
+        std::string clean = ascii;
+        for (size_t i = 4; i < size; i += 5)
+        {
+            clean[i] = static_cast<char>(0xC3);
+        }
+
+        // Clean input comes back as the same view and leaves the buffer alone
+        buffer = "untouched";
+        EXPECT_EQ(sanitizer::remove_null_bytes(clean, buffer).data(), clean.data());
+        EXPECT_EQ(sanitizer::remove_non_printable(ascii, buffer).data(), ascii.data());
+        EXPECT_EQ(sanitizer::escape_html(clean, buffer).data(), clean.data());
+        EXPECT_EQ(sanitizer::escape_json(clean, buffer).data(), clean.data());
+        EXPECT_EQ(buffer, "untouched");
+
+        for (size_t pos = 0; pos < size; ++pos)
+        {
+            for (char const special : specials)
+            {
+                std::string input = clean;
+                input[pos]        = special;
+                if (pos + 1 < size)
+                {
+                    input[size - 1] = special;
+                }
+
+                std::string without_nulls = input;
+                without_nulls.erase(
+                    std::remove(without_nulls.begin(), without_nulls.end(), '\0'),
+                    without_nulls.end());
+                EXPECT_EQ(sanitizer::remove_null_bytes(input), without_nulls);
+                EXPECT_EQ(sanitizer::remove_null_bytes(input, buffer), without_nulls);
+
+                EXPECT_EQ(
+                    sanitizer::remove_non_printable(input), reference_remove_non_printable(input));
+                EXPECT_EQ(
+                    sanitizer::remove_non_printable(input, buffer),
+                    reference_remove_non_printable(input));
+
+                EXPECT_EQ(sanitizer::escape_json(input), reference_escape_json(input));
+                EXPECT_EQ(sanitizer::escape_json(input, buffer), reference_escape_json(input));
+
+                std::string const html = sanitizer::escape_html(input);
+                EXPECT_EQ(sanitizer::escape_html(input, buffer), html);
+                EXPECT_EQ(html.find_first_of("<>\"'"), std::string::npos);
+            }
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include <string>
+#include <vector>
+
+#include "Core/Testing/baseTest.h"
+#include "string_scan.h"
+
+using namespace quarisma::security::detail;
+using quarisma::cpu_capability;
+
+namespace
+{
+bool is_null(unsigned char c)
+{
+    return c == 0;
+}
+
+bool is_non_printable(unsigned char c)
+{
+    return c < 32 || c > 126;
+}
+
+bool is_json_special(unsigned char c)
+{
+    return c < 32 || c == '"' || c == '\\';
+}
+
+bool is_html_special(unsigned char c)
+{
+    return c == '<' || c == '>' || c == '&' || c == '"' || c == '\'';
+}
+
+bool is_non_alphanumeric(unsigned char c)
+{
+    return !((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
+}
+
+// Every capability up to the one this CPU has; the stubs fill in lower ones
+std::vector<cpu_capability> supported_capabilities()
+{
+    std::vector<cpu_capability> capabilities;
+    for (int c = 0; c <= static_cast<int>(quarisma::cpu_info::capability()); ++c)
+    {
+        capabilities.push_back(static_cast<cpu_capability>(c));
+    }
+    return capabilities;
+}
+
+// Each of the 256 byte values at every position of every length around four
+// registers of the widest kernel, over clean text
+void expect_matches_reference(scan_fn kernel, bool (*reference)(unsigned char), char clean)
+{
+    for (size_t size = 0; size <= 300; size += size < 70 ? 1 : 23)
+    {
+        std::string input(size, clean);
+        ASSERT_EQ(kernel(input.data(), input.size()), size);
+        for (size_t pos = 0; pos < size; ++pos)
+        {
+            for (int value = 0; value < 256; ++value)
+            {
+                input[pos]            = static_cast<char>(value);
+                size_t const expected = reference(static_cast<unsigned char>(value)) ? pos : size;
+                ASSERT_EQ(kernel(input.data(), input.size()), expected)
+                    << "size " << size << ", byte " << value << " at " << pos;
+            }
+            input[pos] = clean;
+        }
+    }
+}
+}  // namespace
+
+QUARISMATEST(string_scan_test, every_capability_matches_reference)
+{
+    for (cpu_capability const capability : supported_capabilities())
+    {
+        SCOPED_TRACE(quarisma::to_string(capability));
+        expect_matches_reference(find_null_byte_stub_type::kernel(capability), is_null, 'a');
+        expect_matches_reference(
+            find_non_printable_byte_stub_type::kernel(capability), is_non_printable, 'a');
+        expect_matches_reference(
+            find_json_special_byte_stub_type::kernel(capability), is_json_special, 'a');
+        expect_matches_reference(
+            find_html_special_byte_stub_type::kernel(capability), is_html_special, 'a');
+        expect_matches_reference(
+            find_non_alphanumeric_byte_stub_type::kernel(capability), is_non_alphanumeric, 'Z');
+    }
+}
+
+QUARISMATEST(string_scan_test, stub_uses_detected_capability)
+{
+    cpu_capability const capability = quarisma::cpu_info::capability();
+    EXPECT_EQ(find_null_byte_stub.selected(), find_null_byte_stub_type::kernel(capability));
+    EXPECT_EQ(
+        find_non_alphanumeric_byte_stub.selected(),
+        find_non_alphanumeric_byte_stub_type::kernel(capability));
+
+    std::string const text = std::string(1000, 'x') + '<';
+    EXPECT_EQ(find_first<html_special_byte>(text), 1000u);
+    EXPECT_EQ(find_first<null_byte>(text), text.size());
+}
@@ -0,0 +1,14 @@
+#include "chacha20.h"
+
+namespace quarisma
+{
+namespace security
+{
+namespace detail
+{
+
+QUARISMA_DEFINE_DISPATCH(chacha20_blocks_stub);
+
+}  // namespace detail
+}  // namespace security
+}  // namespace quarisma
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util/cpu_dispatch.h"
+
+namespace quarisma
+{
+namespace security
+{
+namespace detail
+{
+
+/**
+ * @brief ChaCha20 keystream (RFC 8439): blocks consecutive 64-byte blocks
+ * under key (8 words) and nonce (3 words), the first one at block counter
+ * counter, written to out
+ *
+ * The counter is 32 bits wide and wraps; callers re-key well before. The
+ * kernels are in cpu/chacha20_kernel.cpp, built for each cpu_capability: they
+ * compute as many blocks at once as a vector register has 32-bit lanes.
+ */
+using chacha20_blocks_fn = void (*)(
+    const uint32_t* key, const uint32_t* nonce, uint32_t counter, uint8_t* out, size_t blocks);
+
+QUARISMA_DECLARE_DISPATCH(chacha20_blocks_fn, chacha20_blocks_stub);
+
+constexpr size_t kChaCha20BlockBytes = 64;
+
+}  // namespace detail
+}  // namespace security
+}  // namespace quarisma
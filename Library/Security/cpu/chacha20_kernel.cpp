@@ -0,0 +1,263 @@
+// ChaCha20 keystream of chacha20.h. This file is compiled once per
+// cpu_capability (see util/cpu_dispatch.h), so everything but the
+// registrations stays in the anonymous namespace.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "chacha20.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define QUARISMA_CHACHA_AVX512 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define QUARISMA_CHACHA_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUARISMA_CHACHA_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define QUARISMA_CHACHA_NEON 1
+#endif
+
+namespace quarisma
+{
+namespace security
+{
+namespace detail
+{
+namespace
+{
+
+/**
+ * @brief Word operations on one 32-bit lane per block: the scalar one, and a
+ * vector one computing width blocks side by side, word i of every block in
+ * register i
+ */
+struct scalar
+{
+    using vec                     = uint32_t;
+    static constexpr size_t width = 1;
+
+    static vec splat(uint32_t v) noexcept { return v; }
+    static vec counters(uint32_t first) noexcept { return first; }
+    static vec add(vec a, vec b) noexcept { return a + b; }
+    static vec xor_(vec a, vec b) noexcept { return a ^ b; }
+
+    template <int N>
+    static vec rotl(vec v) noexcept
+    {
+        return (v << N) | (v >> (32 - N));
+    }
+
+    static void store(uint32_t* out, vec v) noexcept { *out = v; }
+};
+
+#if defined(QUARISMA_CHACHA_AVX512)
+struct simd
+{
+    using vec                     = __m512i;
+    static constexpr size_t width = 16;
+
+    static vec splat(uint32_t v) noexcept { return _mm512_set1_epi32(static_cast<int>(v)); }
+    static vec counters(uint32_t first) noexcept
+    {
+        return _mm512_add_epi32(
+            splat(first), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    }
+    static vec add(vec a, vec b) noexcept { return _mm512_add_epi32(a, b); }
+    static vec xor_(vec a, vec b) noexcept { return _mm512_xor_si512(a, b); }
+
+    template <int N>
+    static vec rotl(vec v) noexcept
+    {
+        return _mm512_rol_epi32(v, N);
+    }
+
+    static void store(uint32_t* out, vec v) noexcept { _mm512_storeu_si512(out, v); }
+};
+#elif defined(QUARISMA_CHACHA_AVX2)
+struct simd
+{
+    using vec                     = __m256i;
+    static constexpr size_t width = 8;
+
+    static vec splat(uint32_t v) noexcept { return _mm256_set1_epi32(static_cast<int>(v)); }
+    static vec counters(uint32_t first) noexcept
+    {
+        return _mm256_add_epi32(splat(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    }
+    static vec add(vec a, vec b) noexcept { return _mm256_add_epi32(a, b); }
+    static vec xor_(vec a, vec b) noexcept { return _mm256_xor_si256(a, b); }
+
+    template <int N>
+    static vec rotl(vec v) noexcept
+    {
+        return _mm256_or_si256(_mm256_slli_epi32(v, N), _mm256_srli_epi32(v, 32 - N));
+    }
+
+    static void store(uint32_t* out, vec v) noexcept
+    {
+        _mm256_storeu_si256(reinterpret_cast<vec*>(out), v);
+    }
+};
+#elif defined(QUARISMA_CHACHA_SSE2)
+struct simd
+{
+    using vec                     = __m128i;
+    static constexpr size_t width = 4;
+
+    static vec splat(uint32_t v) noexcept { return _mm_set1_epi32(static_cast<int>(v)); }
+    static vec counters(uint32_t first) noexcept
+    {
+        return _mm_add_epi32(splat(first), _mm_setr_epi32(0, 1, 2, 3));
+    }
+    static vec add(vec a, vec b) noexcept { return _mm_add_epi32(a, b); }
+    static vec xor_(vec a, vec b) noexcept { return _mm_xor_si128(a, b); }
+
+    template <int N>
+    static vec rotl(vec v) noexcept
+    {
+        return _mm_or_si128(_mm_slli_epi32(v, N), _mm_srli_epi32(v, 32 - N));
+    }
+
+    static void store(uint32_t* out, vec v) noexcept
+    {
+        _mm_storeu_si128(reinterpret_cast<vec*>(out), v);
+    }
+};
+#elif defined(QUARISMA_CHACHA_NEON)
+struct simd
+{
+    using vec                     = uint32x4_t;
+    static constexpr size_t width = 4;
+
+    static vec splat(uint32_t v) noexcept { return vdupq_n_u32(v); }
+    static vec counters(uint32_t first) noexcept
+    {
+        static constexpr uint32_t kLanes[4] = {0, 1, 2, 3};
+        return vaddq_u32(splat(first), vld1q_u32(kLanes));
+    }
+    static vec add(vec a, vec b) noexcept { return vaddq_u32(a, b); }
+    static vec xor_(vec a, vec b) noexcept { return veorq_u32(a, b); }
+
+    template <int N>
+    static vec rotl(vec v) noexcept
+    {
+        return vsriq_n_u32(vshlq_n_u32(v, N), v, 32 - N);
+    }
+
+    static void store(uint32_t* out, vec v) noexcept { vst1q_u32(out, v); }
+};
+#endif
+
+template <typename V>
+void quarter_round(
+    typename V::vec& a, typename V::vec& b, typename V::vec& c, typename V::vec& d) noexcept
+{
+    a = V::add(a, b);
+    d = V::template rotl<16>(V::xor_(d, a));
+    c = V::add(c, d);
+    b = V::template rotl<12>(V::xor_(b, c));
+    a = V::add(a, b);
+    d = V::template rotl<8>(V::xor_(d, a));
+    c = V::add(c, d);
+    b = V::template rotl<7>(V::xor_(b, c));
+}
+
+void store_le32(uint8_t* out, uint32_t v) noexcept
+{
+    out[0] = static_cast<uint8_t>(v);
+    out[1] = static_cast<uint8_t>(v >> 8);
+    out[2] = static_cast<uint8_t>(v >> 16);
+    out[3] = static_cast<uint8_t>(v >> 24);
+}
+
+/**
+ * @brief V::width blocks, from block counter counter on, written to out
+ */
+template <typename V>
+void blocks_step(
+    const uint32_t* key, const uint32_t* nonce, uint32_t counter, uint8_t* out) noexcept
+{
+    using vec = typename V::vec;
+
+    vec const init[16] = {
+        V::splat(0x61707865),
+        V::splat(0x3320646e),
+        V::splat(0x79622d32),
+        V::splat(0x6b206574),
+        V::splat(key[0]),
+        V::splat(key[1]),
+        V::splat(key[2]),
+        V::splat(key[3]),
+        V::splat(key[4]),
+        V::splat(key[5]),
+        V::splat(key[6]),
+        V::splat(key[7]),
+        V::counters(counter),
+        V::splat(nonce[0]),
+        V::splat(nonce[1]),
+        V::splat(nonce[2])};
+
+    vec x[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        x[i] = init[i];
+    }
+    for (int round = 0; round < 10; ++round)
+    {
+        quarter_round<V>(x[0], x[4], x[8], x[12]);
+        quarter_round<V>(x[1], x[5], x[9], x[13]);
+        quarter_round<V>(x[2], x[6], x[10], x[14]);
+        quarter_round<V>(x[3], x[7], x[11], x[15]);
+        quarter_round<V>(x[0], x[5], x[10], x[15]);
+        quarter_round<V>(x[1], x[6], x[11], x[12]);
+        quarter_round<V>(x[2], x[7], x[8], x[13]);
+        quarter_round<V>(x[3], x[4], x[9], x[14]);
+    }
+
+    // Word i of block b is lane b of register i
+    uint32_t words[16][V::width];
+    for (int i = 0; i < 16; ++i)
+    {
+        V::store(words[i], V::add(x[i], init[i]));
+    }
+    for (size_t b = 0; b < V::width; ++b)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            store_le32(out + b * kChaCha20BlockBytes + 4 * i, words[i][b]);
+        }
+    }
+}
+
+void chacha20_blocks(
+    const uint32_t* key, const uint32_t* nonce, uint32_t counter, uint8_t* out, size_t blocks)
+{
+    size_t i = 0;
+
+#if defined(QUARISMA_CHACHA_AVX512) || defined(QUARISMA_CHACHA_AVX2) || \
+    defined(QUARISMA_CHACHA_SSE2) || defined(QUARISMA_CHACHA_NEON)
+    for (; i + simd::width <= blocks; i += simd::width)
+    {
+        blocks_step<simd>(
+            key, nonce, counter + static_cast<uint32_t>(i), out + i * kChaCha20BlockBytes);
+    }
+#endif
+
+    for (; i < blocks; ++i)
+    {
+        blocks_step<scalar>(
+            key, nonce, counter + static_cast<uint32_t>(i), out + i * kChaCha20BlockBytes);
+    }
+}
+
+}  // namespace
+
+QUARISMA_REGISTER_DISPATCH(chacha20_blocks_stub, &chacha20_blocks);
+
+}  // namespace detail
+}  // namespace security
+}  // namespace quarisma
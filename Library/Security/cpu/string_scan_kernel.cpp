@@ -0,0 +1,281 @@
+// Byte scans of string_scan.h. This file is compiled once per cpu_capability
+// (see util/cpu_dispatch.h), so everything but the registrations stays in the
+// anonymous namespace.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "string_scan.h"
+
+#if defined(__AVX512BW__)
+#include <immintrin.h>
+#define QUARISMA_SCAN_AVX512 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define QUARISMA_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUARISMA_SCAN_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define QUARISMA_SCAN_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace quarisma
+{
+namespace security
+{
+namespace detail
+{
+namespace
+{
+
+/**
+ * @brief Tests of the byte classes: a scalar one, and a vector one over one
+ * register of bytes giving a mask of the matching lanes
+ *
+ * The vector tests compare bytes as signed: bytes of 128 and above are
+ * negative, so they fall below every ASCII range.
+ */
+struct is_null
+{
+    static constexpr bool test(unsigned char c) noexcept { return c == 0; }
+
+    template <typename V>
+    static typename V::mask test(typename V::vec v) noexcept
+    {
+        return V::eq(v, 0);
+    }
+};
+
+struct is_non_printable
+{
+    static constexpr bool test(unsigned char c) noexcept { return c < 32 || c > 126; }
+
+    template <typename V>
+    static typename V::mask test(typename V::vec v) noexcept
+    {
+        return V::or_(V::lt(v, 32), V::eq(v, 127));
+    }
+};
+
+struct is_json_special
+{
+    static constexpr bool test(unsigned char c) noexcept
+    {
+        return c < 32 || c == '"' || c == '\\';
+    }
+
+    template <typename V>
+    static typename V::mask test(typename V::vec v) noexcept
+    {
+        return V::or_(
+            V::and_(V::lt(v, 32), V::gt(v, -1)), V::or_(V::eq(v, '"'), V::eq(v, '\\')));
+    }
+};
+
+struct is_html_special
+{
+    static constexpr bool test(unsigned char c) noexcept
+    {
+        return c == '<' || c == '>' || c == '&' || c == '"' || c == '\'';
+    }
+
+    template <typename V>
+    static typename V::mask test(typename V::vec v) noexcept
+    {
+        return V::or_(
+            V::or_(V::eq(v, '<'), V::eq(v, '>')),
+            V::or_(V::eq(v, '&'), V::or_(V::eq(v, '"'), V::eq(v, '\''))));
+    }
+};
+
+struct is_non_alphanumeric
+{
+    static constexpr bool test(unsigned char c) noexcept
+    {
+        auto const lower = static_cast<unsigned char>(c | 0x20);
+        return !((c >= '0' && c <= '9') || (lower >= 'a' && lower <= 'z'));
+    }
+
+    template <typename V>
+    static typename V::mask test(typename V::vec v) noexcept
+    {
+        auto const digit = V::and_(V::gt(v, '0' - 1), V::lt(v, '9' + 1));
+        auto const lower = V::fold_case(v);
+        auto const alpha = V::and_(V::gt(lower, 'a' - 1), V::lt(lower, 'z' + 1));
+        return V::not_(V::or_(digit, alpha));
+    }
+};
+
+int trailing_zeros(uint64_t x) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+#if defined(QUARISMA_SCAN_AVX512)
+// Comparisons write mask registers directly, one bit per byte
+struct simd
+{
+    using vec                             = __m512i;
+    using mask                            = __mmask64;
+    static constexpr size_t width         = 64;
+    static constexpr int    bits_per_lane = 1;
+
+    static vec  load(const char* p) noexcept { return _mm512_loadu_si512(p); }
+    static vec  splat(int c) noexcept { return _mm512_set1_epi8(static_cast<char>(c)); }
+    static vec  fold_case(vec v) noexcept { return _mm512_or_si512(v, splat(0x20)); }
+    static mask eq(vec v, int c) noexcept { return _mm512_cmpeq_epi8_mask(v, splat(c)); }
+    static mask lt(vec v, int c) noexcept { return _mm512_cmplt_epi8_mask(v, splat(c)); }
+    static mask gt(vec v, int c) noexcept { return _mm512_cmpgt_epi8_mask(v, splat(c)); }
+    static mask or_(mask a, mask b) noexcept { return a | b; }
+    static mask and_(mask a, mask b) noexcept { return a & b; }
+    static mask not_(mask a) noexcept { return static_cast<mask>(~a); }
+    static uint64_t bits(mask m) noexcept { return m; }
+};
+#elif defined(QUARISMA_SCAN_AVX2)
+struct simd
+{
+    using vec                             = __m256i;
+    using mask                            = __m256i;
+    static constexpr size_t width         = 32;
+    static constexpr int    bits_per_lane = 1;
+
+    static vec load(const char* p) noexcept
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const vec*>(p));
+    }
+    static vec  splat(int c) noexcept { return _mm256_set1_epi8(static_cast<char>(c)); }
+    static vec  fold_case(vec v) noexcept { return _mm256_or_si256(v, splat(0x20)); }
+    static mask eq(vec v, int c) noexcept { return _mm256_cmpeq_epi8(v, splat(c)); }
+    static mask lt(vec v, int c) noexcept { return _mm256_cmpgt_epi8(splat(c), v); }
+    static mask gt(vec v, int c) noexcept { return _mm256_cmpgt_epi8(v, splat(c)); }
+    static mask or_(mask a, mask b) noexcept { return _mm256_or_si256(a, b); }
+    static mask and_(mask a, mask b) noexcept { return _mm256_and_si256(a, b); }
+    static mask not_(mask a) noexcept { return _mm256_xor_si256(a, _mm256_set1_epi8(-1)); }
+    static uint64_t bits(mask m) noexcept
+    {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+    }
+};
+#elif defined(QUARISMA_SCAN_SSE2)
+struct simd
+{
+    using vec                             = __m128i;
+    using mask                            = __m128i;
+    static constexpr size_t width         = 16;
+    static constexpr int    bits_per_lane = 1;
+
+    static vec load(const char* p) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<const vec*>(p));
+    }
+    static vec  splat(int c) noexcept { return _mm_set1_epi8(static_cast<char>(c)); }
+    static vec  fold_case(vec v) noexcept { return _mm_or_si128(v, splat(0x20)); }
+    static mask eq(vec v, int c) noexcept { return _mm_cmpeq_epi8(v, splat(c)); }
+    static mask lt(vec v, int c) noexcept { return _mm_cmplt_epi8(v, splat(c)); }
+    static mask gt(vec v, int c) noexcept { return _mm_cmpgt_epi8(v, splat(c)); }
+    static mask or_(mask a, mask b) noexcept { return _mm_or_si128(a, b); }
+    static mask and_(mask a, mask b) noexcept { return _mm_and_si128(a, b); }
+    static mask not_(mask a) noexcept { return _mm_xor_si128(a, _mm_set1_epi8(-1)); }
+    static uint64_t bits(mask m) noexcept
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(m));
+    }
+};
+#elif defined(QUARISMA_SCAN_NEON)
+struct simd
+{
+    using vec                             = int8x16_t;
+    using mask                            = int8x16_t;
+    static constexpr size_t width         = 16;
+    static constexpr int    bits_per_lane = 4;
+
+    static vec load(const char* p) noexcept
+    {
+        return vld1q_s8(reinterpret_cast<const int8_t*>(p));
+    }
+    static vec  splat(int c) noexcept { return vdupq_n_s8(static_cast<int8_t>(c)); }
+    static vec  fold_case(vec v) noexcept { return vorrq_s8(v, splat(0x20)); }
+    static mask eq(vec v, int c) noexcept { return vreinterpretq_s8_u8(vceqq_s8(v, splat(c))); }
+    static mask lt(vec v, int c) noexcept { return vreinterpretq_s8_u8(vcltq_s8(v, splat(c))); }
+    static mask gt(vec v, int c) noexcept { return vreinterpretq_s8_u8(vcgtq_s8(v, splat(c))); }
+    static mask or_(mask a, mask b) noexcept { return vorrq_s8(a, b); }
+    static mask and_(mask a, mask b) noexcept { return vandq_s8(a, b); }
+    static mask not_(mask a) noexcept { return vmvnq_s8(a); }
+
+    // Four bits per byte, narrowed from the 0x00/0xFF comparison result
+    static uint64_t bits(mask m) noexcept
+    {
+        uint8x8_t const narrowed = vshrn_n_u16(vreinterpretq_u16_s8(m), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+    }
+};
+#endif
+
+/**
+ * @brief Index of the first byte of data for which Test holds, or size
+ *
+ * Clean input, the common case, is scanned four vector registers (64 to 256
+ * bytes) per step; the last partial register is checked byte by byte.
+ */
+template <typename Test>
+size_t scan(const char* data, size_t size)
+{
+    size_t i = 0;
+
+#if defined(QUARISMA_SCAN_AVX512) || defined(QUARISMA_SCAN_AVX2) || \
+    defined(QUARISMA_SCAN_SSE2) || defined(QUARISMA_SCAN_NEON)
+    constexpr size_t width = simd::width;
+    for (; i + 4 * width <= size; i += 4 * width)
+    {
+        auto const m0 = Test::template test<simd>(simd::load(data + i));
+        auto const m1 = Test::template test<simd>(simd::load(data + i + width));
+        auto const m2 = Test::template test<simd>(simd::load(data + i + 2 * width));
+        auto const m3 = Test::template test<simd>(simd::load(data + i + 3 * width));
+        if (simd::bits(simd::or_(simd::or_(m0, m1), simd::or_(m2, m3))) != 0)
+        {
+            break;
+        }
+    }
+    for (; i + width <= size; i += width)
+    {
+        uint64_t const mask = simd::bits(Test::template test<simd>(simd::load(data + i)));
+        if (mask != 0)
+        {
+            return i + static_cast<size_t>(trailing_zeros(mask) / simd::bits_per_lane);
+        }
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        if (Test::test(static_cast<unsigned char>(data[i])))
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+}  // namespace
+
+QUARISMA_REGISTER_DISPATCH(find_null_byte_stub, &scan<is_null>);
+QUARISMA_REGISTER_DISPATCH(find_non_printable_byte_stub, &scan<is_non_printable>);
+QUARISMA_REGISTER_DISPATCH(find_json_special_byte_stub, &scan<is_json_special>);
+QUARISMA_REGISTER_DISPATCH(find_html_special_byte_stub, &scan<is_html_special>);
+QUARISMA_REGISTER_DISPATCH(find_non_alphanumeric_byte_stub, &scan<is_non_alphanumeric>);
+
+}  // namespace detail
+}  // namespace security
+}  // namespace quarisma
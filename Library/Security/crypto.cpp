@@ -1,9 +1,37 @@
 #include "crypto.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <iomanip>
+#include <iterator>
+#include <mutex>
 #include <sstream>
+#include <utility>
+
+#include "chacha20.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#define QUARISMA_SHA256_X86 1
+#define QUARISMA_TARGET_SHA_NI
+#define QUARISMA_TARGET_AVX2
+#elif defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define QUARISMA_SHA256_X86 1
+#define QUARISMA_TARGET_SHA_NI __attribute__((target("sha,sse4.1,ssse3")))
+#define QUARISMA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#include <arm_neon.h>
+#define QUARISMA_SHA256_ARMV8 1
+#endif
 
 // Platform-specific includes for secure random
 #ifdef _WIN32
@@ -21,6 +49,15 @@
 #include <unistd.h>
 #endif
 
+// File access for sha256_file, fork handling of the random generator
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace quarisma
 {
 namespace security
@@ -30,13 +67,14 @@ namespace security
 // Secure Random Number Generation
 // ============================================================================
 
-bool crypto::generate_random_bytes(uint8_t* buffer, size_t size)
+namespace
 {
-    if (buffer == nullptr || size == 0)
-    {
-        return false;
-    }
 
+/**
+ * @brief size bytes from the OS entropy source
+ */
+bool os_random_bytes(uint8_t* buffer, size_t size)
+{
 #ifdef _WIN32
     // Windows: Use BCryptGenRandom
     const NTSTATUS status =
@@ -84,6 +122,140 @@ bool crypto::generate_random_bytes(uint8_t* buffer, size_t size)
 #endif
 }
 
+#if !defined(_WIN32)
+// Bumped in the child after fork(), so that the generators re-key rather than
+// repeat the parent's output
+std::atomic<uint64_t> fork_generation{0};
+
+void on_fork_child()
+{
+    fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+uint64_t current_fork_generation()
+{
+#if !defined(_WIN32)
+    static std::once_flag registered;
+    std::call_once(registered, []() { pthread_atfork(nullptr, nullptr, &on_fork_child); });
+    return fork_generation.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Per-thread ChaCha20 generator behind generate_random_bytes()
+ *
+ * Each refill computes kBufferBlocks keystream blocks under the current key;
+ * the first 32 bytes become the next key and the rest are handed out, wiped as
+ * they go, so the state of a thread never reveals output it already returned
+ * ("fast key erasure"). Requests larger than the buffer take keystream blocks
+ * directly, past the counters the refills use. The key is drawn again from the
+ * OS every kReseedBytes and in a child after fork().
+ */
+class chacha20_generator
+{
+public:
+    ~chacha20_generator()
+    {
+        crypto::secure_zero_memory(key_.data(), sizeof(key_));
+        crypto::secure_zero_memory(buffer_.data(), buffer_.size());
+    }
+
+    bool generate(uint8_t* out, size_t size)
+    {
+        uint64_t const generation = current_fork_generation();
+        if (since_seed_ >= kReseedBytes || generation != generation_)
+        {
+            if (!reseed())
+            {
+                return false;
+            }
+            generation_ = generation;
+        }
+        since_seed_ += size;
+
+        size_t const buffered = std::min(size, buffer_.size() - position_);
+        take(out, buffered);
+        out += buffered;
+        size -= buffered;
+
+        // Whole blocks straight from the keystream, re-keying between chunks
+        while (size > buffer_.size() - kKeyBytes)
+        {
+            size_t const blocks =
+                std::min(size / detail::kChaCha20BlockBytes, kMaxDirectBlocks);
+            detail::chacha20_blocks_stub(
+                key_.data(), kNonce.data(), kBufferBlocks, out, blocks);
+            out += blocks * detail::kChaCha20BlockBytes;
+            size -= blocks * detail::kChaCha20BlockBytes;
+            refill();
+        }
+
+        if (size > 0)
+        {
+            refill();
+            take(out, size);
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t   kBufferBlocks    = 16;
+    static constexpr size_t   kMaxDirectBlocks = 16384;  // 1 MiB under one key
+    static constexpr uint64_t kReseedBytes     = uint64_t{1} << 20;
+    static constexpr size_t   kKeyBytes        = 32;
+
+    // Keys are never reused, so the nonce is constant
+    static constexpr std::array<uint32_t, 3> kNonce{};
+
+    bool reseed()
+    {
+        if (!os_random_bytes(reinterpret_cast<uint8_t*>(key_.data()), kKeyBytes))
+        {
+            return false;
+        }
+        since_seed_ = 0;
+        refill();
+        return true;
+    }
+
+    void refill()
+    {
+        detail::chacha20_blocks_stub(key_.data(), kNonce.data(), 0, buffer_.data(), kBufferBlocks);
+        std::memcpy(key_.data(), buffer_.data(), kKeyBytes);
+        crypto::secure_zero_memory(buffer_.data(), kKeyBytes);
+        position_ = kKeyBytes;
+    }
+
+    void take(uint8_t* out, size_t size)
+    {
+        std::memcpy(out, buffer_.data() + position_, size);
+        crypto::secure_zero_memory(buffer_.data() + position_, size);
+        position_ += size;
+    }
+
+    std::array<uint32_t, 8>                                          key_{};
+    std::array<uint8_t, kBufferBlocks * detail::kChaCha20BlockBytes> buffer_{};
+    size_t                                                           position_ = buffer_.size();
+    uint64_t since_seed_ = kReseedBytes;  // Seeds on first use
+    uint64_t generation_ = 0;
+};
+
+}  // namespace
+
+bool crypto::generate_random_bytes(uint8_t* buffer, size_t size)
+{
+    if (buffer == nullptr || size == 0)
+    {
+        return false;
+    }
+
+    thread_local chacha20_generator generator;
+    return generator.generate(buffer, size);
+}
+
 std::optional<std::string> crypto::generate_random_string(size_t length, std::string_view charset)
 {
     if (length == 0 || charset.empty())
@@ -144,67 +316,538 @@ void crypto::sha256_init(sha256_context* ctx)
     ctx->buffer.fill(0);
 }
 
-void crypto::sha256_transform(sha256_context* ctx, const uint8_t* data)
+namespace
 {
-    uint32_t m[64];
-    uint32_t a;
-    uint32_t b;
-    uint32_t c;
-    uint32_t d;
-    uint32_t e;
-    uint32_t f;
-    uint32_t g;
-    uint32_t h;
+// Compresses `blocks` consecutive 64-byte blocks into state
+void sha256_blocks_scalar(uint32_t* state, const uint8_t* data, size_t blocks)
+{
+    for (; blocks != 0; --blocks, data += 64)
+    {
+        uint32_t m[64];
+        uint32_t a;
+        uint32_t b;
+        uint32_t c;
+        uint32_t d;
+        uint32_t e;
+        uint32_t f;
+        uint32_t g;
+        uint32_t h;
+
+        // Prepare message schedule
+        for (int i = 0; i < 16; ++i)
+        {
+            const size_t offset = static_cast<size_t>(i) * 4;
+            m[i]                = (static_cast<uint32_t>(data[offset]) << 24) |
+                   (static_cast<uint32_t>(data[offset + 1]) << 16) |
+                   (static_cast<uint32_t>(data[offset + 2]) << 8) |
+                   (static_cast<uint32_t>(data[offset + 3]));
+        }
 
-    // Prepare message schedule
-    for (int i = 0; i < 16; ++i)
+        for (int i = 16; i < 64; ++i)
+        {
+            m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+        }
+
+        // Initialize working variables
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
+
+        // Main loop
+        for (int i = 0; i < 64; ++i)
+        {
+            uint32_t const t1 = h + EP1(e) + CH(e, f, g) + K[i] + m[i];
+            uint32_t const t2 = EP0(a) + MAJ(a, b, c);
+            h                 = g;
+            g                 = f;
+            f                 = e;
+            e                 = d + t1;
+            d                 = c;
+            c                 = b;
+            b                 = a;
+            a                 = t1 + t2;
+        }
+
+        // Update state
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#if defined(QUARISMA_SHA256_X86)
+// Four rounds 4q..4q+3 of the SHA extensions, extending the message schedule
+// held in msg[q % 4] as they go (see the Intel SHA extensions white paper)
+template <int Q>
+QUARISMA_TARGET_SHA_NI inline void sha_ni_quad(__m128i& abef, __m128i& cdgh, __m128i (&msg)[4])
+{
+    __m128i rounds = _mm_add_epi32(
+        msg[Q % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[4 * Q])));
+    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, rounds);
+    if constexpr (Q >= 3 && Q <= 14)
     {
-        const size_t offset = static_cast<size_t>(i) * 4;
-        m[i]                = (static_cast<uint32_t>(data[offset]) << 24) |
-               (static_cast<uint32_t>(data[offset + 1]) << 16) |
-               (static_cast<uint32_t>(data[offset + 2]) << 8) |
-               (static_cast<uint32_t>(data[offset + 3]));
+        __m128i const shifted = _mm_alignr_epi8(msg[Q % 4], msg[(Q + 3) % 4], 4);
+        msg[(Q + 1) % 4] =
+            _mm_sha256msg2_epu32(_mm_add_epi32(msg[(Q + 1) % 4], shifted), msg[Q % 4]);
+    }
+    rounds = _mm_shuffle_epi32(rounds, 0x0E);
+    abef   = _mm_sha256rnds2_epu32(abef, cdgh, rounds);
+    if constexpr (Q >= 1 && Q <= 12)
+    {
+        msg[(Q + 3) % 4] = _mm_sha256msg1_epu32(msg[(Q + 3) % 4], msg[Q % 4]);
+    }
+}
+
+template <int... Qs>
+QUARISMA_TARGET_SHA_NI inline void sha_ni_rounds(
+    __m128i& abef, __m128i& cdgh, __m128i (&msg)[4], std::integer_sequence<int, Qs...>)
+{
+    (sha_ni_quad<Qs>(abef, cdgh, msg), ...);
+}
+
+QUARISMA_TARGET_SHA_NI void sha256_blocks_sha_ni(
+    uint32_t* state, const uint8_t* data, size_t blocks)
+{
+    __m128i const byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions keep the state as {A, B, E, F} and {C, D, G, H}
+    __m128i const dcba = _mm_shuffle_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xB1);
+    __m128i const hgfe = _mm_shuffle_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1B);
+    __m128i abef = _mm_alignr_epi8(dcba, hgfe, 8);
+    __m128i cdgh = _mm_blend_epi16(hgfe, dcba, 0xF0);
+
+    for (; blocks != 0; --blocks, data += 64)
+    {
+        __m128i const abef_saved = abef;
+        __m128i const cdgh_saved = cdgh;
+
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            msg[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byte_swap);
+        }
+        sha_ni_rounds(abef, cdgh, msg, std::make_integer_sequence<int, 16>());
+
+        abef = _mm_add_epi32(abef, abef_saved);
+        cdgh = _mm_add_epi32(cdgh, cdgh_saved);
     }
 
-    for (int i = 16; i < 64; ++i)
+    __m128i const feba = _mm_shuffle_epi32(abef, 0x1B);
+    __m128i const dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), _mm_blend_epi16(feba, dchg, 0xF0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), _mm_alignr_epi8(dchg, feba, 8));
+}
+
+QUARISMA_TARGET_AVX2 inline __m256i rotr_avx2(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+QUARISMA_TARGET_AVX2 inline uint32_t load_be32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+// Compresses one block per lane: state[w][l] is word w of lane l
+QUARISMA_TARGET_AVX2 void sha256_block_avx2x8(
+    uint32_t (&state)[8][8], const uint8_t* const (&blocks)[8])
+{
+    __m256i w[16];
+    for (int i = 0; i < 16; ++i)
     {
-        m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+        w[i] = _mm256_setr_epi32(
+            static_cast<int>(load_be32(blocks[0] + 4 * i)),
+            static_cast<int>(load_be32(blocks[1] + 4 * i)),
+            static_cast<int>(load_be32(blocks[2] + 4 * i)),
+            static_cast<int>(load_be32(blocks[3] + 4 * i)),
+            static_cast<int>(load_be32(blocks[4] + 4 * i)),
+            static_cast<int>(load_be32(blocks[5] + 4 * i)),
+            static_cast<int>(load_be32(blocks[6] + 4 * i)),
+            static_cast<int>(load_be32(blocks[7] + 4 * i)));
     }
 
-    // Initialize working variables
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        v[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[i]));
+    }
+    __m256i a = v[0];
+    __m256i b = v[1];
+    __m256i c = v[2];
+    __m256i d = v[3];
+    __m256i e = v[4];
+    __m256i f = v[5];
+    __m256i g = v[6];
+    __m256i h = v[7];
 
-    // Main loop
     for (int i = 0; i < 64; ++i)
     {
-        uint32_t const t1 = h + EP1(e) + CH(e, f, g) + K[i] + m[i];
-        uint32_t const t2 = EP0(a) + MAJ(a, b, c);
-        h                 = g;
-        g                 = f;
-        f                 = e;
-        e                 = d + t1;
-        d                 = c;
-        c                 = b;
-        b                 = a;
-        a                 = t1 + t2;
-    }
-
-    // Update state
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
+        if (i >= 16)
+        {
+            __m256i const w15 = w[(i - 15) & 15];
+            __m256i const w2  = w[(i - 2) & 15];
+            __m256i const s0  = _mm256_xor_si256(
+                _mm256_xor_si256(rotr_avx2(w15, 7), rotr_avx2(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i const s1 = _mm256_xor_si256(
+                _mm256_xor_si256(rotr_avx2(w2, 17), rotr_avx2(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[i & 15] = _mm256_add_epi32(
+                _mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+        }
+
+        __m256i const ep1 = _mm256_xor_si256(
+            _mm256_xor_si256(rotr_avx2(e, 6), rotr_avx2(e, 11)), rotr_avx2(e, 25));
+        __m256i const ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i const t1 = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_add_epi32(h, ep1), _mm256_add_epi32(ch, w[i & 15])),
+            _mm256_set1_epi32(static_cast<int>(K[i])));
+        __m256i const ep0 = _mm256_xor_si256(
+            _mm256_xor_si256(rotr_avx2(a, 2), rotr_avx2(a, 13)), rotr_avx2(a, 22));
+        __m256i const maj = _mm256_xor_si256(
+            _mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_xor_si256(a, b)));
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, _mm256_add_epi32(ep0, maj));
+    }
+
+    __m256i const out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i)
+    {
+        _mm256_store_si256(
+            reinterpret_cast<__m256i*>(state[i]), _mm256_add_epi32(v[i], out[i]));
+    }
+}
+
+// Hashes the inputs eight at a time; a lane takes the next input as soon as
+// its current one is done, so inputs of different lengths keep all lanes busy
+void sha256_many_avx2(
+    const uint32_t*          initial_state,
+    const uint8_t* const*    data,
+    const size_t*            sizes,
+    size_t                   count,
+    std::array<uint8_t, 32>* hashes)
+{
+    struct lane
+    {
+        size_t         input       = 0;
+        const uint8_t* message     = nullptr;
+        size_t         full_blocks = 0;
+        size_t         blocks      = 0;
+        size_t         block       = 0;
+        bool           active      = false;
+        uint8_t        tail[128]   = {};  // Last partial block, padding and length
+    };
+
+    constexpr size_t lanes = 8;
+    alignas(32) uint32_t state[8][lanes];
+    lane                 lane_jobs[lanes];
+    static const uint8_t zero_block[64] = {};
+    size_t               next_input     = 0;
+
+    auto const start = [&](size_t l)
+    {
+        lane& job = lane_jobs[l];
+        if (next_input == count)
+        {
+            job.active = false;
+            return;
+        }
+        size_t const   size        = sizes[next_input];
+        size_t const   remainder   = size % 64;
+        size_t const   tail_blocks = remainder < 56 ? 1 : 2;
+        uint64_t const bit_length  = static_cast<uint64_t>(size) * 8;
+
+        job.input       = next_input++;
+        job.message     = data[job.input];
+        job.full_blocks = size / 64;
+        job.blocks      = job.full_blocks + tail_blocks;
+        job.block       = 0;
+        job.active      = true;
+        std::memset(job.tail, 0, sizeof(job.tail));
+        if (remainder != 0)
+        {
+            std::memcpy(job.tail, job.message + job.full_blocks * 64, remainder);
+        }
+        job.tail[remainder] = 0x80;
+        for (int i = 0; i < 8; ++i)
+        {
+            job.tail[tail_blocks * 64 - 1 - i] = static_cast<uint8_t>(bit_length >> (8 * i));
+        }
+        for (int w = 0; w < 8; ++w)
+        {
+            state[w][l] = initial_state[w];
+        }
+    };
+
+    for (size_t l = 0; l < lanes; ++l)
+    {
+        start(l);
+    }
+
+    while (std::any_of(
+        std::begin(lane_jobs), std::end(lane_jobs), [](const lane& job) { return job.active; }))
+    {
+        const uint8_t* blocks[lanes];
+        for (size_t l = 0; l < lanes; ++l)
+        {
+            lane const& job = lane_jobs[l];
+            if (!job.active)
+            {
+                blocks[l] = zero_block;
+            }
+            else if (job.block < job.full_blocks)
+            {
+                blocks[l] = job.message + job.block * 64;
+            }
+            else
+            {
+                blocks[l] = job.tail + (job.block - job.full_blocks) * 64;
+            }
+        }
+
+        sha256_block_avx2x8(state, blocks);
+
+        for (size_t l = 0; l < lanes; ++l)
+        {
+            lane& job = lane_jobs[l];
+            if (!job.active || ++job.block != job.blocks)
+            {
+                continue;
+            }
+            std::array<uint8_t, 32>& hash = hashes[job.input];
+            for (int w = 0; w < 8; ++w)
+            {
+                hash[4 * w]     = static_cast<uint8_t>(state[w][l] >> 24);
+                hash[4 * w + 1] = static_cast<uint8_t>(state[w][l] >> 16);
+                hash[4 * w + 2] = static_cast<uint8_t>(state[w][l] >> 8);
+                hash[4 * w + 3] = static_cast<uint8_t>(state[w][l]);
+            }
+            start(l);
+        }
+    }
+}
+
+void cpuid(unsigned leaf, unsigned subleaf, unsigned (&regs)[4])
+{
+#if defined(_MSC_VER)
+    int r[4] = {};
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i)
+    {
+        regs[i] = static_cast<unsigned>(r[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+bool cpu_has_sha_ni()
+{
+    unsigned regs[4] = {};
+    cpuid(0, 0, regs);
+    if (regs[0] < 7)
+    {
+        return false;
+    }
+    cpuid(1, 0, regs);
+    bool const ssse3  = (regs[2] & (1U << 9)) != 0;
+    bool const sse4_1 = (regs[2] & (1U << 19)) != 0;
+    cpuid(7, 0, regs);
+    return ssse3 && sse4_1 && (regs[1] & (1U << 29)) != 0;
+}
+
+bool cpu_has_avx2()
+{
+    unsigned regs[4] = {};
+    cpuid(0, 0, regs);
+    if (regs[0] < 7)
+    {
+        return false;
+    }
+    cpuid(1, 0, regs);
+    bool const osxsave = (regs[2] & (1U << 27)) != 0;
+    bool const avx     = (regs[2] & (1U << 28)) != 0;
+    if (!osxsave || !avx)
+    {
+        return false;
+    }
+    // The OS must save the YMM registers
+#if defined(_MSC_VER)
+    uint64_t const xcr0 = _xgetbv(0);
+#else
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    uint64_t const xcr0 = (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    if ((xcr0 & 0x6) != 0x6)
+    {
+        return false;
+    }
+    cpuid(7, 0, regs);
+    return (regs[1] & (1U << 5)) != 0;
+}
+#endif  // QUARISMA_SHA256_X86
+
+#if defined(QUARISMA_SHA256_ARMV8)
+// Four rounds 4q..4q+3, extending the message schedule held in msg[q % 4]
+template <int Q>
+inline void armv8_quad(uint32x4_t& abcd, uint32x4_t& efgh, uint32x4_t (&msg)[4])
+{
+    uint32x4_t const rounds = vaddq_u32(msg[Q % 4], vld1q_u32(&K[4 * Q]));
+    if constexpr (Q < 12)
+    {
+        msg[Q % 4] = vsha256su0q_u32(msg[Q % 4], msg[(Q + 1) % 4]);
+    }
+    uint32x4_t const abcd_before = abcd;
+    abcd                         = vsha256hq_u32(abcd, efgh, rounds);
+    efgh                         = vsha256h2q_u32(efgh, abcd_before, rounds);
+    if constexpr (Q < 12)
+    {
+        msg[Q % 4] = vsha256su1q_u32(msg[Q % 4], msg[(Q + 2) % 4], msg[(Q + 3) % 4]);
+    }
+}
+
+template <int... Qs>
+inline void armv8_rounds(
+    uint32x4_t& abcd, uint32x4_t& efgh, uint32x4_t (&msg)[4], std::integer_sequence<int, Qs...>)
+{
+    (armv8_quad<Qs>(abcd, efgh, msg), ...);
+}
+
+void sha256_blocks_armv8(uint32_t* state, const uint8_t* data, size_t blocks)
+{
+    uint32x4_t abcd = vld1q_u32(&state[0]);
+    uint32x4_t efgh = vld1q_u32(&state[4]);
+
+    for (; blocks != 0; --blocks, data += 64)
+    {
+        uint32x4_t const abcd_saved = abcd;
+        uint32x4_t const efgh_saved = efgh;
+
+        uint32x4_t msg[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+        }
+        armv8_rounds(abcd, efgh, msg, std::make_integer_sequence<int, 16>());
+
+        abcd = vaddq_u32(abcd, abcd_saved);
+        efgh = vaddq_u32(efgh, efgh_saved);
+    }
+
+    vst1q_u32(&state[0], abcd);
+    vst1q_u32(&state[4], efgh);
+}
+#endif  // QUARISMA_SHA256_ARMV8
+
+bool kernel_supported(crypto::sha256_kernel kernel)
+{
+    switch (kernel)
+    {
+    case crypto::sha256_kernel::automatic:
+    case crypto::sha256_kernel::scalar:
+        return true;
+#if defined(QUARISMA_SHA256_X86)
+    case crypto::sha256_kernel::avx2:
+    {
+        static const bool avx2 = cpu_has_avx2();
+        return avx2;
+    }
+    case crypto::sha256_kernel::sha_ni:
+    {
+        static const bool sha_ni = cpu_has_sha_ni();
+        return sha_ni;
+    }
+#endif
+#if defined(QUARISMA_SHA256_ARMV8)
+    case crypto::sha256_kernel::armv8:
+        return true;  // The build targets the extension
+#endif
+    default:
+        return false;
+    }
+}
+
+crypto::sha256_kernel best_kernel()
+{
+    for (auto const kernel :
+         {crypto::sha256_kernel::sha_ni, crypto::sha256_kernel::armv8, crypto::sha256_kernel::avx2})
+    {
+        if (kernel_supported(kernel))
+        {
+            return kernel;
+        }
+    }
+    return crypto::sha256_kernel::scalar;
+}
+
+std::atomic<crypto::sha256_kernel> selected_kernel{crypto::sha256_kernel::automatic};
+
+void sha256_blocks(
+    crypto::sha256_kernel kernel, uint32_t* state, const uint8_t* data, size_t blocks)
+{
+#if defined(QUARISMA_SHA256_X86)
+    if (kernel == crypto::sha256_kernel::sha_ni)
+    {
+        sha256_blocks_sha_ni(state, data, blocks);
+        return;
+    }
+#endif
+#if defined(QUARISMA_SHA256_ARMV8)
+    if (kernel == crypto::sha256_kernel::armv8)
+    {
+        sha256_blocks_armv8(state, data, blocks);
+        return;
+    }
+#endif
+    (void)kernel;
+    sha256_blocks_scalar(state, data, blocks);
+}
+}  // namespace
+
+bool crypto::select_sha256_kernel(sha256_kernel kernel)
+{
+    if (!kernel_supported(kernel))
+    {
+        return false;
+    }
+    selected_kernel.store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+crypto::sha256_kernel crypto::active_sha256_kernel()
+{
+    sha256_kernel const kernel = selected_kernel.load(std::memory_order_relaxed);
+    if (kernel != sha256_kernel::automatic)
+    {
+        return kernel;
+    }
+    static const sha256_kernel best = best_kernel();
+    return best;
+}
+
+void crypto::sha256_transform(sha256_context* ctx, const uint8_t* data, size_t blocks)
+{
+    sha256_blocks(active_sha256_kernel(), ctx->state, data, blocks);
 }
 
 void crypto::sha256_update(sha256_context* ctx, const uint8_t* data, size_t size)
@@ -216,17 +859,15 @@ void crypto::sha256_update(sha256_context* ctx, const uint8_t* data, size_t size
     if (size >= buffer_space)
     {
         std::memcpy(ctx->buffer.data() + (64 - buffer_space), data, buffer_space);
-        sha256_transform(ctx, ctx->buffer.data());
+        sha256_transform(ctx, ctx->buffer.data(), 1);
 
         data += buffer_space;
         size -= buffer_space;
 
-        while (size >= 64)
-        {
-            sha256_transform(ctx, data);
-            data += 64;
-            size -= 64;
-        }
+        size_t const blocks = size / 64;
+        sha256_transform(ctx, data, blocks);
+        data += blocks * 64;
+        size -= blocks * 64;
 
         buffer_space = 64;
     }
@@ -239,16 +880,15 @@ void crypto::sha256_update(sha256_context* ctx, const uint8_t* data, size_t size
 
 void crypto::sha256_final(sha256_context* ctx, uint8_t* hash)
 {
-    size_t const i        = ctx->count % 64;
-    uint8_t*     p        = ctx->buffer.data() + i;
-    size_t const pad_size = (i < 56) ? (56 - i) : (120 - i);
+    size_t const i = ctx->count % 64;
 
-    *p++ = 0x80;
-    std::memset(p, 0, pad_size - 1);
+    ctx->buffer[i] = 0x80;
+    std::memset(ctx->buffer.data() + i + 1, 0, 63 - i);
 
-    if (pad_size < 8)
+    // No room left for the length: it goes in an extra block
+    if (i >= 56)
     {
-        sha256_transform(ctx, ctx->buffer.data());
+        sha256_transform(ctx, ctx->buffer.data(), 1);
         std::memset(ctx->buffer.data(), 0, 56);
     }
 
@@ -259,7 +899,7 @@ void crypto::sha256_final(sha256_context* ctx, uint8_t* hash)
         ctx->buffer[56 + j] = static_cast<uint8_t>(bit_count >> ((7 - j) * 8));
     }
 
-    sha256_transform(ctx, ctx->buffer.data());
+    sha256_transform(ctx, ctx->buffer.data(), 1);
 
     // Produce final hash
     for (int j = 0; j < 8; ++j)
@@ -300,10 +940,314 @@ std::string crypto::sha256_hex(std::string_view str)
     return sha256_hex(reinterpret_cast<const uint8_t*>(str.data()), str.size());
 }
 
+void crypto::sha256_many(
+    const uint8_t* const*    data,
+    const size_t*            sizes,
+    size_t                   count,
+    std::array<uint8_t, 32>* hashes)
+{
+#if defined(QUARISMA_SHA256_X86)
+    if (active_sha256_kernel() == sha256_kernel::avx2)
+    {
+        sha256_context ctx;
+        sha256_init(&ctx);
+        sha256_many_avx2(ctx.state, data, sizes, count, hashes);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+    {
+        hashes[i] = sha256(data[i], sizes[i]);
+    }
+}
+
+std::vector<std::array<uint8_t, 32>> crypto::sha256_many(
+    const std::vector<std::string_view>& inputs)
+{
+    std::vector<const uint8_t*> data(inputs.size());
+    std::vector<size_t>         sizes(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        data[i]  = reinterpret_cast<const uint8_t*>(inputs[i].data());
+        sizes[i] = inputs[i].size();
+    }
+
+    std::vector<std::array<uint8_t, 32>> hashes(inputs.size());
+    sha256_many(data.data(), sizes.data(), inputs.size(), hashes.data());
+    return hashes;
+}
+
+std::optional<std::array<uint8_t, 32>> crypto::sha256_file(const std::string& path)
+{
+    constexpr size_t chunk_size = size_t{1} << 20;
+    sha256_hasher    hasher;
+
+#if defined(_WIN32)
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return std::nullopt;
+    }
+    std::vector<uint8_t> chunk(chunk_size);
+    size_t               read = 0;
+    while ((read = std::fread(chunk.data(), 1, chunk.size(), file)) != 0)
+    {
+        hasher.update(chunk.data(), read);
+    }
+    bool const failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed)
+    {
+        return std::nullopt;
+    }
+#else
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return std::nullopt;
+    }
+
+    struct stat info = {};
+    bool        mapped = false;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        auto const size = static_cast<size_t>(info.st_size);
+        void*      data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            ::madvise(data, size, MADV_SEQUENTIAL);
+            hasher.update(static_cast<const uint8_t*>(data), size);
+            ::munmap(data, size);
+            mapped = true;
+        }
+    }
+
+    if (!mapped)
+    {
+        std::vector<uint8_t> chunk(chunk_size);
+        for (;;)
+        {
+            ssize_t const read = ::read(fd, chunk.data(), chunk.size());
+            if (read > 0)
+            {
+                hasher.update(chunk.data(), static_cast<size_t>(read));
+            }
+            else if (read == 0)
+            {
+                break;
+            }
+            else if (errno != EINTR)
+            {
+                ::close(fd);
+                return std::nullopt;
+            }
+        }
+    }
+    ::close(fd);
+#endif
+
+    return hasher.digest();
+}
+
+// ============================================================================
+// Incremental SHA-256
+// ============================================================================
+
+sha256_hasher::sha256_hasher()
+{
+    reset();
+}
+
+sha256_hasher& sha256_hasher::update(const uint8_t* data, size_t size)
+{
+    if (size != 0)
+    {
+        crypto::sha256_update(&ctx_, data, size);
+    }
+    return *this;
+}
+
+sha256_hasher& sha256_hasher::update(std::string_view str)
+{
+    return update(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+}
+
+std::array<uint8_t, 32> sha256_hasher::digest() const
+{
+    crypto::sha256_context  ctx = ctx_;
+    std::array<uint8_t, 32> hash;
+    crypto::sha256_final(&ctx, hash.data());
+    return hash;
+}
+
+std::string sha256_hasher::hex_digest() const
+{
+    auto const hash = digest();
+    return crypto::bytes_to_hex(hash.data(), hash.size());
+}
+
+void sha256_hasher::reset()
+{
+    crypto::sha256_init(&ctx_);
+}
+
 // ============================================================================
 // Secure Comparison
 // ============================================================================
 
+namespace
+{
+
+// Hides a value from the optimizer, so that an accumulation cannot be turned
+// into a loop that exits early once its result is known
+template <typename T>
+inline void value_barrier(T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ volatile("" : "+r"(value));
+#else
+    volatile T copy = value;
+    value           = copy;
+#endif
+}
+
+uint64_t load_u64(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// OR of a[i] ^ b[i] over whole 8-byte words, then the tail
+uint64_t xor_accumulate_scalar(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    uint64_t diff = 0;
+    size_t   i    = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        diff |= load_u64(a + i) ^ load_u64(b + i);
+        value_barrier(diff);
+    }
+    for (; i < size; ++i)
+    {
+        diff |= static_cast<uint64_t>(a[i] ^ b[i]);
+        value_barrier(diff);
+    }
+    return diff;
+}
+
+#if defined(QUARISMA_SHA256_X86)
+bool has_avx2()
+{
+    static const bool avx2 = cpu_has_avx2();
+    return avx2;
+}
+
+// XOR-accumulates 32-byte lanes into one register and reduces it once at the
+// end: the loop does the same work whatever the data
+QUARISMA_TARGET_AVX2 uint64_t xor_accumulate_avx2(
+    const uint8_t* a, const uint8_t* b, size_t size)
+{
+    __m256i acc = _mm256_setzero_si256();
+    size_t  i   = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i const va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i const vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc              = _mm256_or_si256(acc, _mm256_xor_si256(va, vb));
+    }
+    uint64_t const lanes = static_cast<uint64_t>(_mm256_testz_si256(acc, acc) == 0);
+    return lanes | xor_accumulate_scalar(a + i, b + i, size - i);
+}
+
+// Hex codecs on 16 bytes (32 digits) at a time. pshufb looks the digits up
+// in a 16-entry table indexed by nibble.
+QUARISMA_TARGET_AVX2 size_t bytes_to_hex_avx2(const uint8_t* data, size_t size, char* out)
+{
+    __m128i const digits = _mm_setr_epi8(
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    __m128i const low_nibble = _mm_set1_epi8(0x0f);
+    size_t        i          = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i const v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i const hi =
+            _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), low_nibble));
+        __m128i const lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, low_nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// Nibble values of 16 digits; `valid` has all bits set in the lanes holding a
+// hex digit
+QUARISMA_TARGET_AVX2 __m128i hex_nibbles(__m128i c, __m128i* valid)
+{
+    // Signed compares: bytes >= 0x80 are negative and match neither range.
+    // Letters are folded to lower case, which maps no other byte into a-f.
+    __m128i const lower    = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i const is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), c));
+    __m128i const is_alpha = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+    *valid = _mm_or_si128(is_digit, is_alpha);
+    return _mm_blendv_epi8(
+        _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)),
+        _mm_sub_epi8(c, _mm_set1_epi8('0')),
+        is_digit);
+}
+
+// Decodes whole blocks of 32 digits; returns the digits consumed, or
+// SIZE_MAX on an invalid digit
+QUARISMA_TARGET_AVX2 size_t hex_to_bytes_avx2(const char* hex, size_t size, uint8_t* out)
+{
+    // maddubs pairs the nibbles: 16 * even + odd
+    __m128i const weights = _mm_set1_epi16(0x0110);
+    size_t        i       = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m128i       valid0;
+        __m128i       valid1;
+        __m128i const n0 =
+            hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i)), &valid0);
+        __m128i const n1 =
+            hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i + 16)), &valid1);
+        if (_mm_movemask_epi8(_mm_and_si128(valid0, valid1)) != 0xffff)
+        {
+            return SIZE_MAX;
+        }
+        __m128i const bytes =
+            _mm_packus_epi16(_mm_maddubs_epi16(n0, weights), _mm_maddubs_epi16(n1, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2), bytes);
+    }
+    return i;
+}
+#endif  // QUARISMA_SHA256_X86
+
+constexpr char hex_digits[] = "0123456789abcdef";
+
+// Value of a hex digit, or -1
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+}  // namespace
+
 bool crypto::constant_time_compare(const uint8_t* a, const uint8_t* b, size_t size)
 {
     if (a == nullptr || b == nullptr)
@@ -311,13 +1255,15 @@ bool crypto::constant_time_compare(const uint8_t* a, const uint8_t* b, size_t si
         return false;
     }
 
-    volatile uint8_t result = 0;
-    for (size_t i = 0; i < size; ++i)
+    // Every byte is read and the result is reduced once: the time depends on
+    // size only, never on where or whether the inputs differ
+#if defined(QUARISMA_SHA256_X86)
+    if (has_avx2())
     {
-        result |= a[i] ^ b[i];
+        return xor_accumulate_avx2(a, b, size) == 0;
     }
-
-    return result == 0;
+#endif
+    return xor_accumulate_scalar(a, b, size) == 0;
 }
 
 bool crypto::constant_time_compare(std::string_view a, std::string_view b)
@@ -339,15 +1285,20 @@ bool crypto::constant_time_compare(std::string_view a, std::string_view b)
 
 std::string crypto::bytes_to_hex(const uint8_t* data, size_t size)
 {
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-
-    for (size_t i = 0; i < size; ++i)
+    std::string hex(2 * size, '\0');
+    size_t      i = 0;
+#if defined(QUARISMA_SHA256_X86)
+    if (has_avx2())
     {
-        oss << std::setw(2) << static_cast<int>(data[i]);
+        i = bytes_to_hex_avx2(data, size, hex.data());
     }
-
-    return oss.str();
+#endif
+    for (; i < size; ++i)
+    {
+        hex[2 * i]     = hex_digits[data[i] >> 4];
+        hex[2 * i + 1] = hex_digits[data[i] & 0x0f];
+    }
+    return hex;
 }
 
 std::optional<std::vector<uint8_t>> crypto::hex_to_bytes(std::string_view hex)
@@ -357,21 +1308,27 @@ std::optional<std::vector<uint8_t>> crypto::hex_to_bytes(std::string_view hex)
         return std::nullopt;
     }
 
-    std::vector<uint8_t> bytes;
-    bytes.reserve(hex.length() / 2);
-
-    for (size_t i = 0; i < hex.length(); i += 2)
+    std::vector<uint8_t> bytes(hex.length() / 2);
+    size_t               i = 0;
+#if defined(QUARISMA_SHA256_X86)
+    if (has_avx2())
     {
-        std::string const byte_str(hex.substr(i, 2));
-        char*             end;
-        long              value = std::strtol(byte_str.c_str(), &end, 16);
-
-        if (end != byte_str.c_str() + 2)
+        i = hex_to_bytes_avx2(hex.data(), hex.length(), bytes.data());
+        if (i == SIZE_MAX)
         {
             return std::nullopt;
         }
-
-        bytes.push_back(static_cast<uint8_t>(value));
+    }
+#endif
+    for (; i < hex.length(); i += 2)
+    {
+        int const hi = hex_value(hex[i]);
+        int const lo = hex_value(hex[i + 1]);
+        if (hi < 0 || lo < 0)
+        {
+            return std::nullopt;
+        }
+        bytes[i / 2] = static_cast<uint8_t>((hi << 4) | lo);
     }
 
     return bytes;
@@ -16,6 +16,8 @@ namespace quarisma
 namespace security
 {
 
+class sha256_hasher;
+
 /**
  * @brief Cryptographic utilities for secure data processing
  *
@@ -42,7 +44,9 @@ public:
      * @param size Number of bytes to generate
      * @return true on success, false on failure
      *
-     * Uses platform-specific secure random sources:
+     * Bytes come from a per-thread ChaCha20 generator, keyed from the
+     * platform's secure random source and keyed again every MiB and in a
+     * child after fork():
      * - Linux/macOS: /dev/urandom or getrandom()
      * - Windows: BCryptGenRandom or RtlGenRandom
      */
@@ -141,6 +145,66 @@ public:
      */
     static QUARISMA_API std::string sha256_hex(std::string_view str);
 
+    /**
+     * @brief Computes the SHA-256 hash of a file without loading it whole
+     * @param path File to hash
+     * @return 32-byte hash, or nullopt if the file cannot be opened or read
+     *
+     * Regular files are memory-mapped and hashed in place; other files, and
+     * platforms without mmap, are read in 1 MiB chunks. A file truncated by
+     * another process while it is being hashed may raise SIGBUS.
+     */
+    static QUARISMA_API std::optional<std::array<uint8_t, 32>> sha256_file(const std::string& path);
+
+    /**
+     * @brief Computes the SHA-256 hashes of many independent inputs
+     * @param data Input buffers
+     * @param sizes Sizes of the input buffers
+     * @param count Number of inputs
+     * @param hashes Output, one 32-byte hash per input, in order
+     *
+     * With the avx2 kernel, eight inputs are hashed at once in AVX2 lanes;
+     * otherwise the inputs are hashed one after the other.
+     */
+    static QUARISMA_API void sha256_many(
+        const uint8_t* const*    data,
+        const size_t*            sizes,
+        size_t                   count,
+        std::array<uint8_t, 32>* hashes);
+
+    /**
+     * @brief Computes the SHA-256 hashes of many independent strings
+     * @param inputs Input strings
+     * @return One 32-byte hash per input, in order
+     */
+    static QUARISMA_API std::vector<std::array<uint8_t, 32>> sha256_many(
+        const std::vector<std::string_view>& inputs);
+
+    /**
+     * @brief SHA-256 implementations
+     */
+    enum class sha256_kernel
+    {
+        automatic,  ///< Fastest kernel the CPU supports
+        scalar,     ///< Portable C++
+        avx2,       ///< Portable C++, and eight inputs at once for sha256_many
+        sha_ni,     ///< x86 SHA extensions
+        armv8       ///< ARMv8 cryptography extensions
+    };
+
+    /**
+     * @brief Selects the SHA-256 kernel, mostly for tests and benchmarks
+     * @param kernel Kernel to use from now on
+     * @return false, leaving the selection unchanged, if the CPU or the build
+     *         does not support the kernel
+     */
+    static QUARISMA_API bool select_sha256_kernel(sha256_kernel kernel);
+
+    /**
+     * @brief Kernel used by sha256() and sha256_many(), never automatic
+     */
+    static QUARISMA_API sha256_kernel active_sha256_kernel();
+
     // ========================================================================
     // Secure Comparison
     // ========================================================================
@@ -195,6 +259,8 @@ public:
     static QUARISMA_API void secure_zero_memory(void* ptr, size_t size);
 
 private:
+    friend class sha256_hasher;
+
     // Internal SHA-256 implementation
     struct sha256_context
     {
@@ -206,7 +272,63 @@ private:
     static void sha256_init(sha256_context* ctx);
     static void sha256_update(sha256_context* ctx, const uint8_t* data, size_t size);
     static void sha256_final(sha256_context* ctx, uint8_t* hash);
-    static void sha256_transform(sha256_context* ctx, const uint8_t* data);
+    static void sha256_transform(sha256_context* ctx, const uint8_t* data, size_t blocks);
+};
+
+/**
+ * @brief Incremental SHA-256 over data that arrives in chunks
+ *
+ * Feeding the chunks of an input to update() gives the same hash as
+ * crypto::sha256() on the whole input, whatever the chunk sizes:
+ *
+ * @code
+ * sha256_hasher hasher;
+ * while (auto chunk = next_chunk())
+ * {
+ *     hasher.update(chunk->data(), chunk->size());
+ * }
+ * std::string const hex = hasher.hex_digest();
+ * @endcode
+ */
+class QUARISMA_VISIBILITY sha256_hasher
+{
+public:
+    QUARISMA_API sha256_hasher();
+
+    /**
+     * @brief Appends data to the input
+     * @return *this, for chaining
+     */
+    QUARISMA_API sha256_hasher& update(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Appends a string to the input
+     * @return *this, for chaining
+     */
+    QUARISMA_API sha256_hasher& update(std::string_view str);
+
+    /**
+     * @brief Hash of the input so far; more data may still be appended
+     */
+    QUARISMA_API std::array<uint8_t, 32> digest() const;
+
+    /**
+     * @brief Hash of the input so far, as lowercase hexadecimal
+     */
+    QUARISMA_API std::string hex_digest() const;
+
+    /**
+     * @brief Discards the input, as if newly constructed
+     */
+    QUARISMA_API void reset();
+
+    /**
+     * @brief Number of bytes appended since construction or reset()
+     */
+    uint64_t size() const noexcept { return ctx_.count; }
+
+private:
+    crypto::sha256_context ctx_;
 };
 
 }  // namespace security
@@ -4,6 +4,8 @@
 #include <cctype>
 #include <regex>
 
+#include "string_scan.h"
+
 namespace quarisma
 {
 namespace security
@@ -23,18 +25,12 @@ bool input_validator::is_alphanumeric(std::string_view str)
         return false;
     }
 
-    return std::all_of(str.begin(), str.end(), [](unsigned char c) { return std::isalnum(c); });
+    return detail::find_first<detail::non_alphanumeric_byte>(str) == str.size();
 }
 
 bool input_validator::is_printable_ascii(std::string_view str)
 {
-    return std::all_of(
-        str.begin(),
-        str.end(),
-        [](unsigned char c)
-        {
-            return c >= 32 && c <= 126;  // Printable ASCII range
-        });
+    return detail::find_first<detail::non_printable_byte>(str) == str.size();
 }
 
 bool input_validator::matches_pattern(std::string_view str, const std::regex& pattern)
@@ -44,7 +40,7 @@ bool input_validator::matches_pattern(std::string_view str, const std::regex& pa
 
 bool input_validator::has_no_null_bytes(std::string_view str)
 {
-    return std::find(str.begin(), str.end(), '\0') == str.end();
+    return detail::find_first<detail::null_byte>(str) == str.size();
 }
 
 bool input_validator::is_safe_path(std::string_view path)
@@ -14,6 +14,7 @@
 
 #include "common/export.h"
 #include "common/macros.h"
+#include "pattern.h"
 
 namespace quarisma
 {
@@ -50,7 +51,7 @@ public:
         std::string_view str, size_t min_length, size_t max_length);
 
     /**
-     * @brief Validates string contains only alphanumeric characters
+     * @brief Validates string contains only ASCII letters and digits, whatever the locale
      * @param str String to validate
      * @return true if string is alphanumeric, false otherwise
      */
@@ -71,6 +72,20 @@ public:
      */
     static QUARISMA_API bool matches_pattern(std::string_view str, const std::regex& pattern);
 
+    /**
+     * @brief Validates string matches a precompiled pattern
+     * @param str String to validate
+     * @param compiled Pattern from pattern::compile()
+     * @return true if the whole string matches, false otherwise
+     *
+     * Linear in the length of str and allocation-free; prefer it to the
+     * std::regex overload for validating many fields.
+     */
+    static bool matches_pattern(std::string_view str, const pattern& compiled) noexcept
+    {
+        return compiled.matches(str);
+    }
+
     /**
      * @brief Validates string does not contain null bytes
      * @param str String to validate
@@ -0,0 +1,666 @@
+#include "pattern.h"
+
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <utility>
+
+namespace quarisma
+{
+namespace security
+{
+
+namespace
+{
+using byte_set = std::bitset<256>;
+
+/// Counted repetitions are expanded, so keep them and the automaton small
+constexpr int    max_repeat     = 1000;
+constexpr size_t max_nfa_states = 100000;
+
+struct syntax_node
+{
+    enum class kind
+    {
+        set,
+        concat,
+        alternate,
+        repeat,
+    };
+
+    kind             type = kind::concat;
+    byte_set         bytes;
+    std::vector<int> children;
+    int              min = 0;
+    int              max = 0;  // -1 when unbounded
+};
+
+byte_set byte_range(unsigned first, unsigned last)
+{
+    byte_set bytes;
+    for (unsigned c = first; c <= last; ++c)
+    {
+        bytes.set(c);
+    }
+    return bytes;
+}
+
+byte_set digit_bytes()
+{
+    return byte_range('0', '9');
+}
+
+byte_set word_bytes()
+{
+    byte_set bytes = byte_range('0', '9') | byte_range('A', 'Z') | byte_range('a', 'z');
+    bytes.set('_');
+    return bytes;
+}
+
+byte_set space_bytes()
+{
+    byte_set bytes;
+    for (char const c : {' ', '\t', '\n', '\r', '\f', '\v'})
+    {
+        bytes.set(static_cast<unsigned char>(c));
+    }
+    return bytes;
+}
+
+/**
+ * @brief Recursive descent parser from the expression to a syntax tree
+ *
+ * Every parse_* function returns the index of its node, or -1 on error.
+ */
+class parser
+{
+public:
+    explicit parser(std::string_view expression) : text_(expression) {}
+
+    int parse()
+    {
+        if (peek('^'))
+        {
+            ++pos_;
+        }
+        int const root = parse_alternation();
+        if (root < 0)
+        {
+            return -1;
+        }
+        if (peek('$') && pos_ + 1 == text_.size())
+        {
+            ++pos_;
+        }
+        return pos_ == text_.size() ? root : -1;
+    }
+
+    const std::vector<syntax_node>& nodes() const noexcept { return nodes_; }
+
+private:
+    bool peek(char c) const noexcept { return pos_ < text_.size() && text_[pos_] == c; }
+
+    int add(syntax_node node)
+    {
+        nodes_.push_back(std::move(node));
+        return static_cast<int>(nodes_.size() - 1);
+    }
+
+    int add_set(const byte_set& bytes)
+    {
+        syntax_node node;
+        node.type  = syntax_node::kind::set;
+        node.bytes = bytes;
+        return add(std::move(node));
+    }
+
+    int parse_alternation()
+    {
+        syntax_node node;
+        node.type = syntax_node::kind::alternate;
+        for (;;)
+        {
+            int const branch = parse_concat();
+            if (branch < 0)
+            {
+                return -1;
+            }
+            node.children.push_back(branch);
+            if (!peek('|'))
+            {
+                break;
+            }
+            ++pos_;
+        }
+        return node.children.size() == 1 ? node.children.front() : add(std::move(node));
+    }
+
+    int parse_concat()
+    {
+        syntax_node node;
+        node.type = syntax_node::kind::concat;
+        while (pos_ < text_.size() && !peek('|') && !peek(')') &&
+               !(peek('$') && pos_ + 1 == text_.size()))
+        {
+            int const item = parse_repeat();
+            if (item < 0)
+            {
+                return -1;
+            }
+            node.children.push_back(item);
+        }
+        return add(std::move(node));
+    }
+
+    int parse_repeat()
+    {
+        int item = parse_atom();
+        while (item >= 0 && pos_ < text_.size())
+        {
+            int min = 0;
+            int max = 0;
+            switch (text_[pos_])
+            {
+            case '*':
+                max = -1;
+                break;
+            case '+':
+                min = 1;
+                max = -1;
+                break;
+            case '?':
+                max = 1;
+                break;
+            case '{':
+                if (!parse_bounds(min, max))
+                {
+                    return -1;
+                }
+                --pos_;  // Leave the closing brace to the increment below
+                break;
+            default:
+                return item;
+            }
+            ++pos_;
+
+            syntax_node node;
+            node.type = syntax_node::kind::repeat;
+            node.children.push_back(item);
+            node.min = min;
+            node.max = max;
+            item     = add(std::move(node));
+        }
+        return item;
+    }
+
+    // {n}, {n,} or {n,m}, leaving pos_ past the closing brace
+    bool parse_bounds(int& min, int& max)
+    {
+        ++pos_;
+        if (!parse_number(min))
+        {
+            return false;
+        }
+        max = min;
+        if (peek(','))
+        {
+            ++pos_;
+            max = -1;
+            if (!peek('}') && !parse_number(max))
+            {
+                return false;
+            }
+        }
+        if (!peek('}') || (max >= 0 && max < min))
+        {
+            return false;
+        }
+        ++pos_;
+        return true;
+    }
+
+    bool parse_number(int& value)
+    {
+        size_t const first = pos_;
+        value              = 0;
+        while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9')
+        {
+            value = value * 10 + (text_[pos_] - '0');
+            if (value > max_repeat)
+            {
+                return false;
+            }
+            ++pos_;
+        }
+        return pos_ != first;
+    }
+
+    int parse_atom()
+    {
+        char const c = text_[pos_++];
+        switch (c)
+        {
+        case '(':
+        {
+            if (text_.substr(pos_, 2) == "?:")
+            {
+                pos_ += 2;
+            }
+            int const group = parse_alternation();
+            if (group < 0 || !peek(')'))
+            {
+                return -1;
+            }
+            ++pos_;
+            return group;
+        }
+        case '[':
+            return parse_set();
+        case '.':
+        {
+            byte_set any;
+            any.set();
+            any.reset('\n');
+            return add_set(any);
+        }
+        case '\\':
+        {
+            byte_set bytes;
+            return parse_escape(bytes) ? add_set(bytes) : -1;
+        }
+        case ')':
+        case ']':
+        case '{':
+        case '}':
+        case '*':
+        case '+':
+        case '?':
+        case '^':
+        case '$':
+            return -1;
+        default:
+            return add_set(byte_set().set(static_cast<unsigned char>(c)));
+        }
+    }
+
+    // After a backslash: the bytes the escape stands for
+    bool parse_escape(byte_set& bytes)
+    {
+        if (pos_ == text_.size())
+        {
+            return false;
+        }
+        char const c = text_[pos_++];
+        switch (c)
+        {
+        case 'd':
+            bytes = digit_bytes();
+            return true;
+        case 'D':
+            bytes = ~digit_bytes();
+            return true;
+        case 'w':
+            bytes = word_bytes();
+            return true;
+        case 'W':
+            bytes = ~word_bytes();
+            return true;
+        case 's':
+            bytes = space_bytes();
+            return true;
+        case 'S':
+            bytes = ~space_bytes();
+            return true;
+        case 't':
+            bytes.set('\t');
+            return true;
+        case 'n':
+            bytes.set('\n');
+            return true;
+        case 'r':
+            bytes.set('\r');
+            return true;
+        case 'f':
+            bytes.set('\f');
+            return true;
+        case 'v':
+            bytes.set('\v');
+            return true;
+        case '0':
+            bytes.set(0);
+            return true;
+        case 'x':
+        {
+            unsigned value = 0;
+            for (int i = 0; i < 2; ++i, ++pos_)
+            {
+                if (pos_ == text_.size())
+                {
+                    return false;
+                }
+                char const h     = text_[pos_];
+                int const  digit = (h >= '0' && h <= '9')   ? h - '0'
+                                   : (h >= 'a' && h <= 'f') ? h - 'a' + 10
+                                   : (h >= 'A' && h <= 'F') ? h - 'A' + 10
+                                                            : -1;
+                if (digit < 0)
+                {
+                    return false;
+                }
+                value = value * 16 + static_cast<unsigned>(digit);
+            }
+            bytes.set(value);
+            return true;
+        }
+        default:
+            // Only punctuation escapes to itself; \b, \1 and the like are unsupported
+            if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))
+            {
+                return false;
+            }
+            bytes.set(static_cast<unsigned char>(c));
+            return true;
+        }
+    }
+
+    int parse_set()
+    {
+        bool const negated = peek('^');
+        if (negated)
+        {
+            ++pos_;
+        }
+
+        byte_set bytes;
+        bool     first = true;
+        while (pos_ < text_.size() && (first || !peek(']')))
+        {
+            first = false;
+
+            byte_set item;
+            if (!parse_set_item(item))
+            {
+                return -1;
+            }
+
+            // A range between two single bytes
+            if (item.count() == 1 && peek('-') && pos_ + 1 < text_.size() &&
+                text_[pos_ + 1] != ']')
+            {
+                ++pos_;
+                byte_set last;
+                if (!parse_set_item(last) || last.count() != 1)
+                {
+                    return -1;
+                }
+                unsigned const from = lowest(item);
+                unsigned const to   = lowest(last);
+                if (to < from)
+                {
+                    return -1;
+                }
+                item = byte_range(from, to);
+            }
+            bytes |= item;
+        }
+        if (!peek(']'))
+        {
+            return -1;
+        }
+        ++pos_;
+        return add_set(negated ? ~bytes : bytes);
+    }
+
+    bool parse_set_item(byte_set& item)
+    {
+        char const c = text_[pos_++];
+        if (c == '\\')
+        {
+            return parse_escape(item);
+        }
+        item.set(static_cast<unsigned char>(c));
+        return true;
+    }
+
+    static unsigned lowest(const byte_set& bytes)
+    {
+        unsigned c = 0;
+        while (!bytes.test(c))
+        {
+            ++c;
+        }
+        return c;
+    }
+
+    std::string_view         text_;
+    size_t                   pos_ = 0;
+    std::vector<syntax_node> nodes_;
+};
+
+/**
+ * @brief Thompson automaton: a state either consumes one byte of its set or
+ * moves on, without consuming, to any of its epsilon successors
+ */
+struct nfa
+{
+    struct state
+    {
+        int              set  = -1;  // Index into sets, or -1 for an epsilon state
+        int              next = -1;
+        std::vector<int> epsilon;
+    };
+
+    std::vector<state>    states;
+    std::vector<byte_set> sets;
+    int                   accept    = -1;
+    bool                  too_large = false;
+
+    int add(state s)
+    {
+        if (states.size() >= max_nfa_states)
+        {
+            too_large = true;
+            return accept;
+        }
+        states.push_back(std::move(s));
+        return static_cast<int>(states.size() - 1);
+    }
+
+    // Builds node so that it continues to, and returns the state it starts at
+    int build(const std::vector<syntax_node>& nodes, int index, int next)
+    {
+        if (too_large)
+        {
+            return accept;
+        }
+
+        const syntax_node& node = nodes[static_cast<size_t>(index)];
+        switch (node.type)
+        {
+        case syntax_node::kind::set:
+        {
+            sets.push_back(node.bytes);
+            state s;
+            s.set  = static_cast<int>(sets.size() - 1);
+            s.next = next;
+            return add(std::move(s));
+        }
+        case syntax_node::kind::concat:
+            for (auto it = node.children.rbegin(); it != node.children.rend(); ++it)
+            {
+                next = build(nodes, *it, next);
+            }
+            return next;
+        case syntax_node::kind::alternate:
+        {
+            state s;
+            for (int const child : node.children)
+            {
+                s.epsilon.push_back(build(nodes, child, next));
+            }
+            return add(std::move(s));
+        }
+        case syntax_node::kind::repeat:
+        default:
+        {
+            int const child = node.children.front();
+            if (node.max < 0)
+            {
+                // Loop: the body returns to a state that can leave or go again
+                int const loop = add(state{});
+                if (too_large)
+                {
+                    return accept;
+                }
+                int const body = build(nodes, child, loop);
+                if (too_large)
+                {
+                    return accept;
+                }
+                states[static_cast<size_t>(loop)].epsilon = {body, next};
+                next                                     = loop;
+            }
+            else
+            {
+                // Optional copies, each of which may skip to the end
+                int const end = next;
+                for (int i = node.min; i < node.max; ++i)
+                {
+                    state s;
+                    s.epsilon = {build(nodes, child, next), end};
+                    next      = add(std::move(s));
+                }
+            }
+            for (int i = 0; i < node.min; ++i)
+            {
+                next = build(nodes, child, next);
+            }
+            return next;
+        }
+        }
+    }
+
+    // Byte-consuming states reachable from start without consuming, sorted,
+    // with the accept state appended if it is reachable
+    std::vector<int> closure(const std::vector<int>& start) const
+    {
+        std::vector<int>  result;
+        std::vector<int>  stack(start);
+        std::vector<bool> seen(states.size());
+        while (!stack.empty())
+        {
+            int const s = stack.back();
+            stack.pop_back();
+            if (seen[static_cast<size_t>(s)])
+            {
+                continue;
+            }
+            seen[static_cast<size_t>(s)] = true;
+
+            const state& st = states[static_cast<size_t>(s)];
+            if (st.set >= 0 || s == accept)
+            {
+                result.push_back(s);
+            }
+            stack.insert(stack.end(), st.epsilon.begin(), st.epsilon.end());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+}  // namespace
+
+std::optional<pattern> pattern::compile(std::string_view expression)
+{
+    parser    p(expression);
+    int const root = p.parse();
+    if (root < 0)
+    {
+        return std::nullopt;
+    }
+
+    nfa automaton;
+    automaton.accept = automaton.add(nfa::state{});
+    int const start  = automaton.build(p.nodes(), root, automaton.accept);
+    if (automaton.too_large)
+    {
+        return std::nullopt;
+    }
+
+    // Bytes that every set treats alike share a class and a table column
+    pattern                          result;
+    std::map<std::vector<bool>, int> signatures;
+    std::vector<unsigned>            class_representative;
+    for (unsigned c = 0; c < 256; ++c)
+    {
+        std::vector<bool> signature(automaton.sets.size());
+        for (size_t s = 0; s < automaton.sets.size(); ++s)
+        {
+            signature[s] = automaton.sets[s].test(c);
+        }
+        auto const inserted =
+            signatures.emplace(std::move(signature), static_cast<int>(signatures.size()));
+        if (inserted.second)
+        {
+            class_representative.push_back(c);
+        }
+        result.byte_class_[c] = static_cast<uint8_t>(inserted.first->second);
+    }
+    result.class_count_ = static_cast<uint32_t>(class_representative.size());
+
+    // Subset construction; state 0 is the empty, dead set
+    std::map<std::vector<int>, uint32_t> ids;
+    std::vector<std::vector<int>>        subsets;
+
+    auto const intern = [&](std::vector<int> subset)
+    {
+        auto const it = ids.find(subset);
+        if (it != ids.end())
+        {
+            return it->second;
+        }
+        auto const id = static_cast<uint32_t>(subsets.size());
+        ids.emplace(subset, id);
+        subsets.push_back(std::move(subset));
+        return id;
+    };
+    intern({});
+
+    // The start state gets its own id even when it is the dead set
+    std::vector<int> start_subset = automaton.closure({start});
+    ids.emplace(start_subset, start_state);
+    subsets.push_back(std::move(start_subset));
+
+    for (size_t id = 0; id < subsets.size() && subsets.size() <= max_states; ++id)
+    {
+        for (uint32_t k = 0; k < result.class_count_; ++k)
+        {
+            std::vector<int> targets;
+            for (int const s : subsets[id])
+            {
+                const nfa::state& st = automaton.states[static_cast<size_t>(s)];
+                if (s != automaton.accept &&
+                    automaton.sets[static_cast<size_t>(st.set)].test(class_representative[k]))
+                {
+                    targets.push_back(st.next);
+                }
+            }
+            uint32_t const target = intern(automaton.closure(targets));
+            result.transitions_.push_back(static_cast<uint16_t>(target));
+        }
+
+        // The accept state is NFA state 0, so it sorts first
+        bool const accepting = !subsets[id].empty() && subsets[id].front() == automaton.accept;
+        result.accepting_.push_back(accepting ? 1 : 0);
+    }
+    if (subsets.size() > max_states)
+    {
+        return std::nullopt;
+    }
+
+    result.expression_ = std::string(expression);
+    return result;
+}
+
+}  // namespace security
+}  // namespace quarisma
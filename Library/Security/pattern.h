@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/export.h"
+#include "common/macros.h"
+
+namespace quarisma
+{
+namespace security
+{
+
+/**
+ * @brief Precompiled pattern matched in linear time without allocating
+ *
+ * A replacement for std::regex in input validation. The expression is
+ * compiled once into a deterministic automaton over byte classes; matching
+ * then costs two table lookups per input byte, never backtracks and never
+ * allocates.
+ *
+ * Like std::regex_match, matches() succeeds only if the whole input matches.
+ * The syntax is the non-backtracking part of ECMAScript regular expressions:
+ * - literals, and a backslash to escape any of . [ ] ( ) { } * + ? | ^ $ and itself
+ * - . (any byte except newline), and the classes \d \D \w \W \s \S
+ * - sets: [abc], [a-z0-9_], [^...], with escapes and \d \w \s inside
+ * - groups (...) and (?:...), alternation |
+ * - quantifiers *, +, ?, {n}, {n,}, {n,m}
+ * - ^ at the start and $ at the end, accepted and implied
+ * Back-references, lookaround and lazy quantifiers are not supported.
+ *
+ * @code
+ * static const auto isin = pattern::compile("[A-Z]{2}[A-Z0-9]{9}[0-9]");
+ * if (isin && isin->matches(field)) { ... }
+ * @endcode
+ */
+class QUARISMA_VISIBILITY pattern
+{
+public:
+    /// Compilation fails rather than build an automaton with more states
+    static constexpr size_t max_states = 4096;
+
+    /**
+     * @brief Compiles an expression
+     * @param expression Pattern in the syntax above
+     * @return The compiled pattern, or nullopt if the expression is invalid
+     *         or needs more than max_states states
+     */
+    static QUARISMA_API std::optional<pattern> compile(std::string_view expression);
+
+    /**
+     * @brief Checks whether the whole of str matches the pattern
+     */
+    bool matches(std::string_view str) const noexcept
+    {
+        uint32_t state = start_state;
+        for (unsigned char const c : str)
+        {
+            state = transitions_[state * class_count_ + byte_class_[c]];
+            if (state == dead_state)
+            {
+                return false;
+            }
+        }
+        return accepting_[state] != 0;
+    }
+
+    /**
+     * @brief Expression the pattern was compiled from
+     */
+    const std::string& expression() const noexcept { return expression_; }
+
+    /**
+     * @brief Number of automaton states, including the dead state
+     */
+    size_t state_count() const noexcept { return accepting_.size(); }
+
+private:
+    static constexpr uint32_t dead_state  = 0;
+    static constexpr uint32_t start_state = 1;
+
+    pattern() = default;
+
+    std::string              expression_;
+    std::array<uint8_t, 256> byte_class_{};
+    uint32_t                 class_count_ = 0;
+    std::vector<uint16_t>    transitions_;  // [state * class_count_ + class]
+    std::vector<uint8_t>     accepting_;
+};
+
+}  // namespace security
+}  // namespace quarisma
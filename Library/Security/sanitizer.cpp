@@ -5,42 +5,145 @@
 #include <iomanip>
 #include <sstream>
 
+#include "string_scan.h"
+
 namespace quarisma
 {
 namespace security
 {
 
-std::string sanitizer::remove_null_bytes(std::string_view str)
+namespace
 {
-    std::string result;
-    result.reserve(str.length());
-
-    for (char const c : str)
+/**
+ * @brief Appends str to out, passing each byte of the class Byte to
+ * replace(c, out) and copying the clean runs in between whole
+ */
+template <typename Byte, typename Replace>
+void append_replaced(std::string_view str, std::string& out, Replace replace)
+{
+    while (!str.empty())
     {
-        if (c != '\0')
+        size_t const clean = detail::find_first<Byte>(str);
+        out.append(str.data(), clean);
+        if (clean == str.size())
         {
-            result += c;
+            break;
         }
+        replace(str[clean], out);
+        str.remove_prefix(clean + 1);
     }
+}
 
+/**
+ * @brief Sanitized copy of str, with room reserved for reserve_factor times its size
+ */
+template <typename Byte, typename Replace>
+std::string replaced(std::string_view str, size_t reserve_factor, Replace replace)
+{
+    std::string result;
+    result.reserve(str.length() * reserve_factor);
+    append_replaced<Byte>(str, result, replace);
     return result;
 }
 
-std::string sanitizer::remove_non_printable(std::string_view str)
+/**
+ * @brief str itself when it has no byte of the class Byte, else its sanitized copy in buffer
+ */
+template <typename Byte, typename Replace>
+std::string_view replaced(std::string_view str, std::string& buffer, Replace replace)
 {
-    std::string result;
-    result.reserve(str.length());
+    size_t const clean = detail::find_first<Byte>(str);
+    if (clean == str.size())
+    {
+        return str;
+    }
+    buffer.assign(str.data(), clean);
+    replace(str[clean], buffer);
+    append_replaced<Byte>(str.substr(clean + 1), buffer, replace);
+    return buffer;
+}
 
-    for (unsigned char const c : str)
+void drop_byte(char /*c*/, std::string& /*out*/) {}
+
+void escape_html_byte(char c, std::string& out)
+{
+    switch (c)
     {
-        // Keep only printable ASCII (32-126)
-        if (c >= 32 && c <= 126)
-        {
-            result += static_cast<char>(c);
-        }
+    case '<':
+        out += "&lt;";
+        break;
+    case '>':
+        out += "&gt;";
+        break;
+    case '&':
+        out += "&amp;";
+        break;
+    case '"':
+        out += "&quot;";
+        break;
+    default:  // '\''
+        out += "&#39;";
+        break;
     }
+}
 
-    return result;
+void escape_json_byte(char c, std::string& out)
+{
+    switch (c)
+    {
+    case '"':
+        out += "\\\"";
+        break;
+    case '\\':
+        out += "\\\\";
+        break;
+    case '\b':
+        out += "\\b";
+        break;
+    case '\f':
+        out += "\\f";
+        break;
+    case '\n':
+        out += "\\n";
+        break;
+    case '\r':
+        out += "\\r";
+        break;
+    case '\t':
+        out += "\\t";
+        break;
+    default:
+    {
+        // Other control characters
+        constexpr char digits[]  = "0123456789abcdef";
+        auto const     code      = static_cast<unsigned char>(c);
+        char const     escaped[] = {'\\', 'u', '0', '0', digits[code >> 4], digits[code & 0xF]};
+        out.append(escaped, sizeof(escaped));
+        break;
+    }
+    }
+}
+}  // namespace
+
+std::string sanitizer::remove_null_bytes(std::string_view str)
+{
+    return replaced<detail::null_byte>(str, 1, drop_byte);
+}
+
+std::string_view sanitizer::remove_null_bytes(std::string_view str, std::string& buffer)
+{
+    return replaced<detail::null_byte>(str, buffer, drop_byte);
+}
+
+std::string sanitizer::remove_non_printable(std::string_view str)
+{
+    // Keep only printable ASCII (32-126)
+    return replaced<detail::non_printable_byte>(str, 1, drop_byte);
+}
+
+std::string_view sanitizer::remove_non_printable(std::string_view str, std::string& buffer)
+{
+    return replaced<detail::non_printable_byte>(str, buffer, drop_byte);
 }
 
 std::string sanitizer::trim(std::string_view str)
@@ -79,35 +182,13 @@ std::string sanitizer::truncate(std::string_view str, size_t max_length)
 
 std::string sanitizer::escape_html(std::string_view str)
 {
-    std::string result;
-    result.reserve(str.length() * 2);  // Reserve extra space for escapes
-
-    for (char const c : str)
-    {
-        switch (c)
-        {
-        case '<':
-            result += "&lt;";
-            break;
-        case '>':
-            result += "&gt;";
-            break;
-        case '&':
-            result += "&amp;";
-            break;
-        case '"':
-            result += "&quot;";
-            break;
-        case '\'':
-            result += "&#39;";
-            break;
-        default:
-            result += c;
-            break;
-        }
-    }
+    // Reserve extra space for escapes
+    return replaced<detail::html_special_byte>(str, 2, escape_html_byte);
+}
 
-    return result;
+std::string_view sanitizer::escape_html(std::string_view str, std::string& buffer)
+{
+    return replaced<detail::html_special_byte>(str, buffer, escape_html_byte);
 }
 
 std::string sanitizer::escape_sql(std::string_view str)
@@ -162,52 +243,12 @@ std::string sanitizer::escape_shell(std::string_view str)
 
 std::string sanitizer::escape_json(std::string_view str)
 {
-    std::string result;
-    result.reserve(str.length() * 2);
-
-    for (char const c : str)
-    {
-        switch (c)
-        {
-        case '"':
-            result += "\\\"";
-            break;
-        case '\\':
-            result += "\\\\";
-            break;
-        case '\b':
-            result += "\\b";
-            break;
-        case '\f':
-            result += "\\f";
-            break;
-        case '\n':
-            result += "\\n";
-            break;
-        case '\r':
-            result += "\\r";
-            break;
-        case '\t':
-            result += "\\t";
-            break;
-        default:
-            if (static_cast<unsigned char>(c) < 32)
-            {
-                // Escape control characters
-                std::ostringstream oss;
-                oss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
-                    << static_cast<int>(static_cast<unsigned char>(c));
-                result += oss.str();
-            }
-            else
-            {
-                result += c;
-            }
-            break;
-        }
-    }
+    return replaced<detail::json_special_byte>(str, 2, escape_json_byte);
+}
 
-    return result;
+std::string_view sanitizer::escape_json(std::string_view str, std::string& buffer)
+{
+    return replaced<detail::json_special_byte>(str, buffer, escape_json_byte);
 }
 
 std::string sanitizer::escape_url(std::string_view str)
@@ -23,6 +23,10 @@ namespace security
  * - Return sanitized copies (do not modify input)
  * - Are safe to call with any input
  * - Never throw exceptions
+ *
+ * remove_null_bytes, remove_non_printable, escape_html and escape_json scan
+ * with SIMD and also come in a form taking a caller-owned buffer: clean
+ * input, the common case, is returned as is and nothing is allocated.
  */
 class QUARISMA_VISIBILITY sanitizer
 {
@@ -38,6 +42,16 @@ public:
      */
     static QUARISMA_API std::string remove_null_bytes(std::string_view str);
 
+    /**
+     * @brief Removes null bytes, like remove_null_bytes(str), without allocating
+     * @param str Input string
+     * @param buffer Receives the result when str has to change; reusing it
+     *        across calls avoids reallocating
+     * @return str itself if nothing had to change, otherwise a view of buffer
+     */
+    static QUARISMA_API std::string_view remove_null_bytes(
+        std::string_view str, std::string& buffer);
+
     /**
      * @brief Removes all non-printable ASCII characters
      * @param str Input string
@@ -45,6 +59,16 @@ public:
      */
     static QUARISMA_API std::string remove_non_printable(std::string_view str);
 
+    /**
+     * @brief Removes non-printable characters, like remove_non_printable(str), without allocating
+     * @param str Input string
+     * @param buffer Receives the result when str has to change; reusing it
+     *        across calls avoids reallocating
+     * @return str itself if nothing had to change, otherwise a view of buffer
+     */
+    static QUARISMA_API std::string_view remove_non_printable(
+        std::string_view str, std::string& buffer);
+
     /**
      * @brief Trims whitespace from both ends of a string
      * @param str Input string
@@ -73,6 +97,15 @@ public:
      */
     static QUARISMA_API std::string escape_html(std::string_view str);
 
+    /**
+     * @brief Escapes HTML, like escape_html(str), without allocating
+     * @param str Input string
+     * @param buffer Receives the result when str has to change; reusing it
+     *        across calls avoids reallocating
+     * @return str itself if nothing had to change, otherwise a view of buffer
+     */
+    static QUARISMA_API std::string_view escape_html(std::string_view str, std::string& buffer);
+
     /**
      * @brief Escapes SQL special characters to prevent SQL injection
      * @param str Input string
@@ -98,6 +131,15 @@ public:
      */
     static QUARISMA_API std::string escape_json(std::string_view str);
 
+    /**
+     * @brief Escapes JSON, like escape_json(str), without allocating
+     * @param str Input string
+     * @param buffer Receives the result when str has to change; reusing it
+     *        across calls avoids reallocating
+     * @return str itself if nothing had to change, otherwise a view of buffer
+     */
+    static QUARISMA_API std::string_view escape_json(std::string_view str, std::string& buffer);
+
     /**
      * @brief Escapes URL special characters (percent encoding)
      * @param str Input string
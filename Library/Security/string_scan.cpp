@@ -0,0 +1,18 @@
+#include "string_scan.h"
+
+namespace quarisma
+{
+namespace security
+{
+namespace detail
+{
+
+QUARISMA_DEFINE_DISPATCH(find_null_byte_stub);
+QUARISMA_DEFINE_DISPATCH(find_non_printable_byte_stub);
+QUARISMA_DEFINE_DISPATCH(find_json_special_byte_stub);
+QUARISMA_DEFINE_DISPATCH(find_html_special_byte_stub);
+QUARISMA_DEFINE_DISPATCH(find_non_alphanumeric_byte_stub);
+
+}  // namespace detail
+}  // namespace security
+}  // namespace quarisma
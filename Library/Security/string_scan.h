@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "util/cpu_dispatch.h"
+
+namespace quarisma
+{
+namespace security
+{
+namespace detail
+{
+
+/**
+ * @brief Scan over size bytes of data: index of the first byte in a class, or size
+ *
+ * The kernels are in cpu/string_scan_kernel.cpp, built for each cpu_capability.
+ */
+using scan_fn = size_t (*)(const char* data, size_t size);
+
+QUARISMA_DECLARE_DISPATCH(scan_fn, find_null_byte_stub);
+QUARISMA_DECLARE_DISPATCH(scan_fn, find_non_printable_byte_stub);
+QUARISMA_DECLARE_DISPATCH(scan_fn, find_json_special_byte_stub);
+QUARISMA_DECLARE_DISPATCH(scan_fn, find_html_special_byte_stub);
+QUARISMA_DECLARE_DISPATCH(scan_fn, find_non_alphanumeric_byte_stub);
+
+/**
+ * @brief Byte classes searched for by find_first(), each naming its scan
+ */
+struct null_byte
+{
+    static auto& stub() noexcept { return find_null_byte_stub; }
+};
+
+/// Below 32 or above 126
+struct non_printable_byte
+{
+    static auto& stub() noexcept { return find_non_printable_byte_stub; }
+};
+
+/// Below 32, '"' or '\\'
+struct json_special_byte
+{
+    static auto& stub() noexcept { return find_json_special_byte_stub; }
+};
+
+/// '<', '>', '&', '"' or '\''
+struct html_special_byte
+{
+    static auto& stub() noexcept { return find_html_special_byte_stub; }
+};
+
+/// Anything but ASCII [0-9A-Za-z], which is std::isalnum in the "C" locale
+struct non_alphanumeric_byte
+{
+    static auto& stub() noexcept { return find_non_alphanumeric_byte_stub; }
+};
+
+/**
+ * @brief Index of the first byte of str in the class Byte, or str.size()
+ */
+template <typename Byte>
+size_t find_first(std::string_view str) noexcept
+{
+    return Byte::stub()(str.data(), str.size());
+}
+
+}  // namespace detail
+}  // namespace security
+}  // namespace quarisma
@@ -0,0 +1,431 @@
+#!/usr/bin/env python3
+"""Benchmark regression tracking against stored statistical baselines.
+
+Runs the Google Benchmark executables of a build (benchmark_parallel,
+benchmark_cpumemoryallocators, ..., and the end-to-end quarisma_perf) with
+repetitions, stores the samples of
+each executable as a JSON baseline, and compares later runs against it with a
+Mann-Whitney U test or a bootstrap of the median ratio. A benchmark regresses
+when it is significantly slower *and* slower by more than a threshold, so
+noise alone does not fail a run and tiny but significant shifts are ignored.
+
+Usage:
+    # Record the baselines, one file per executable
+    python Tools/benchmark/benchmark_regression.py record --build-dir build_ninja
+
+    # Compare a new run; exits with 1 when a benchmark regressed
+    python Tools/benchmark/benchmark_regression.py compare --build-dir build_ninja
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import json
+import math
+import random
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional, Sequence, Tuple
+
+BASELINE_FORMAT_VERSION = 1
+
+# Google Benchmark time units, in nanoseconds
+_TIME_UNITS_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+# Suffix Google Benchmark appends to the names of repeated runs
+_REPEATS_SUFFIX = re.compile(r"/repeats:\d+$")
+
+
+@dataclass
+class BenchmarkSamples:
+    """Per-repetition times of one benchmark, in nanoseconds."""
+
+    real_time: List[float] = field(default_factory=list)
+    cpu_time: List[float] = field(default_factory=list)
+
+    def metric(self, name: str) -> List[float]:
+        """Returns the samples of the "real_time" or "cpu_time" metric."""
+        return self.real_time if name == "real_time" else self.cpu_time
+
+
+@dataclass
+class Comparison:
+    """Result of comparing one benchmark against its baseline."""
+
+    name: str
+    status: str  # REGRESSION, IMPROVEMENT, OK, NEW or MISSING
+    baseline_median: float = 0.0
+    current_median: float = 0.0
+    ratio: float = 0.0
+    p_value: Optional[float] = None
+    ci: Optional[Tuple[float, float]] = None
+
+
+# -----------------------------------------------------------------------------
+# Running and parsing
+# -----------------------------------------------------------------------------
+
+
+# Name patterns of the benchmark executables
+_EXECUTABLE_PATTERNS = ("benchmark_*", "quarisma_perf*")
+
+
+def normalize_benchmark_name(name: str) -> str:
+    """Maps "BenchmarkParallel", "benchmark_parallel" and "parallel" to "parallel".
+
+    The end-to-end suite, "BenchmarkPerf" built as "quarisma_perf", maps to "perf".
+    """
+    lowered = name.lower()
+    for prefix in ("benchmark_", "benchmark", "quarisma_"):
+        if lowered.startswith(prefix):
+            lowered = lowered[len(prefix):]
+            break
+    return lowered.replace("_", "")
+
+
+def find_benchmark_executables(build_dir: Path, names: Sequence[str] = ()) -> List[Path]:
+    """Finds the benchmark executables of a build, optionally only `names`."""
+    wanted = {normalize_benchmark_name(n) for n in names}
+    found = {}
+    candidates = {c for pattern in _EXECUTABLE_PATTERNS for c in build_dir.rglob(pattern)}
+    for candidate in sorted(candidates):
+        if not candidate.is_file() or candidate.suffix not in ("", ".exe"):
+            continue
+        key = normalize_benchmark_name(candidate.stem)
+        if (not wanted or key in wanted) and key not in found:
+            found[key] = candidate
+    missing = wanted - found.keys()
+    if missing:
+        raise FileNotFoundError(
+            f"No benchmark executable for {', '.join(sorted(missing))} under {build_dir}"
+        )
+    return [found[key] for key in sorted(found)]
+
+
+def parse_benchmark_report(report: dict) -> Dict[str, BenchmarkSamples]:
+    """Extracts the per-repetition times of a Google Benchmark JSON report.
+
+    Aggregates (mean, median, stddev) are skipped; the tests need the
+    individual repetitions.
+    """
+    samples: Dict[str, BenchmarkSamples] = {}
+    for entry in report.get("benchmarks", []):
+        if entry.get("run_type", "iteration") != "iteration" or entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name") or _REPEATS_SUFFIX.sub("", entry["name"])
+        scale = _TIME_UNITS_NS[entry.get("time_unit", "ns")]
+        series = samples.setdefault(name, BenchmarkSamples())
+        series.real_time.append(float(entry["real_time"]) * scale)
+        series.cpu_time.append(float(entry["cpu_time"]) * scale)
+    return samples
+
+
+def run_benchmark(
+    executable: Path,
+    repetitions: int,
+    benchmark_filter: Optional[str] = None,
+    min_time: Optional[str] = None,
+) -> dict:
+    """Runs one benchmark executable and returns its JSON report."""
+    with tempfile.TemporaryDirectory() as tmp:
+        out = Path(tmp) / "report.json"
+        command = [
+            str(executable),
+            f"--benchmark_repetitions={repetitions}",
+            f"--benchmark_out={out}",
+            "--benchmark_out_format=json",
+        ]
+        if benchmark_filter:
+            command.append(f"--benchmark_filter={benchmark_filter}")
+        if min_time:
+            command.append(f"--benchmark_min_time={min_time}")
+        subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+        return json.loads(out.read_text())
+
+
+# -----------------------------------------------------------------------------
+# Baseline store
+# -----------------------------------------------------------------------------
+
+
+def baseline_path(baseline_dir: Path, executable_name: str) -> Path:
+    """File holding the baseline of one benchmark executable."""
+    return baseline_dir / f"{Path(executable_name).stem}.json"
+
+
+def save_baseline(path: Path, report: dict, samples: Dict[str, BenchmarkSamples]) -> None:
+    """Writes the samples of one executable, with the host context of the run."""
+    path.parent.mkdir(parents=True, exist_ok=True)
+    baseline = {
+        "format_version": BASELINE_FORMAT_VERSION,
+        "context": report.get("context", {}),
+        "benchmarks": {
+            name: {"real_time_ns": s.real_time, "cpu_time_ns": s.cpu_time}
+            for name, s in sorted(samples.items())
+        },
+    }
+    path.write_text(json.dumps(baseline, separators=(",", ":")) + "\n")
+
+
+def load_baseline(path: Path) -> Dict[str, BenchmarkSamples]:
+    """Reads a baseline written by save_baseline()."""
+    baseline = json.loads(path.read_text())
+    version = baseline.get("format_version")
+    if version != BASELINE_FORMAT_VERSION:
+        raise ValueError(f"{path}: unsupported baseline format version {version}")
+    return {
+        name: BenchmarkSamples(list(b["real_time_ns"]), list(b["cpu_time_ns"]))
+        for name, b in baseline["benchmarks"].items()
+    }
+
+
+# -----------------------------------------------------------------------------
+# Statistics
+# -----------------------------------------------------------------------------
+
+
+def _normal_sf(z: float) -> float:
+    """Survival function of the standard normal distribution."""
+    return 0.5 * math.erfc(z / math.sqrt(2.0))
+
+
+def mann_whitney_greater(baseline: Sequence[float], current: Sequence[float]) -> float:
+    """One-sided Mann-Whitney U test that `current` tends to be larger.
+
+    Uses the normal approximation with tie and continuity corrections, fine
+    from about 5 samples per side.
+
+    Returns:
+        The p-value; small values mean current is significantly slower.
+    """
+    n1, n2 = len(baseline), len(current)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+
+    # Mid-ranks of the pooled samples
+    pooled = sorted([(v, 0) for v in baseline] + [(v, 1) for v in current])
+    ranks = [0.0] * len(pooled)
+    tie_term = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1.0
+        ties = j - i + 1
+        tie_term += ties**3 - ties
+        i = j + 1
+
+    rank_sum_current = sum(r for r, (_, side) in zip(ranks, pooled) if side == 1)
+    u_current = rank_sum_current - n2 * (n2 + 1) / 2.0
+    mean_u = n1 * n2 / 2.0
+    n = n1 + n2
+    variance_u = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance_u <= 0.0:
+        return 1.0  # All the samples are equal
+    z = (u_current - mean_u - 0.5) / math.sqrt(variance_u)
+    return _normal_sf(z)
+
+
+def bootstrap_median_ratio(
+    baseline: Sequence[float],
+    current: Sequence[float],
+    confidence: float = 0.99,
+    iterations: int = 2000,
+    seed: int = 0,
+) -> Tuple[float, float]:
+    """Bootstrap confidence interval of median(current) / median(baseline).
+
+    The seed is fixed so that the same samples always give the same verdict.
+    """
+    rng = random.Random(seed)
+    ratios = []
+    for _ in range(iterations):
+        b = statistics.median(rng.choices(baseline, k=len(baseline)))
+        c = statistics.median(rng.choices(current, k=len(current)))
+        ratios.append(c / b if b > 0 else math.inf)
+    ratios.sort()
+    tail = (1.0 - confidence) / 2.0
+    low = ratios[int(tail * (iterations - 1))]
+    high = ratios[int(math.ceil((1.0 - tail) * (iterations - 1)))]
+    return low, high
+
+
+def compare_samples(
+    baseline: Dict[str, BenchmarkSamples],
+    current: Dict[str, BenchmarkSamples],
+    metric: str = "real_time",
+    test: str = "mann-whitney",
+    alpha: float = 0.01,
+    threshold: float = 0.05,
+) -> List[Comparison]:
+    """Compares every benchmark of `current` with its baseline.
+
+    A benchmark regresses when its median is more than `threshold` slower and
+    the test is significant at `alpha`: the Mann-Whitney p-value is below
+    alpha, or the 1 - alpha bootstrap interval of the ratio is above 1.
+    Improvements are the mirror case.
+    """
+    results = []
+    for name in sorted(set(baseline) | set(current)):
+        if name not in current:
+            results.append(Comparison(name, "MISSING"))
+            continue
+        if name not in baseline:
+            results.append(Comparison(name, "NEW"))
+            continue
+
+        b = baseline[name].metric(metric)
+        c = current[name].metric(metric)
+        result = Comparison(name, "OK", statistics.median(b), statistics.median(c))
+        result.ratio = result.current_median / result.baseline_median if b and c else 1.0
+
+        if test == "bootstrap":
+            result.ci = bootstrap_median_ratio(b, c, confidence=1.0 - alpha)
+            slower = result.ci[0] > 1.0
+            faster = result.ci[1] < 1.0
+        else:
+            p_slower = mann_whitney_greater(b, c)
+            p_faster = mann_whitney_greater(c, b)
+            result.p_value = min(p_slower, p_faster)
+            slower = p_slower < alpha
+            faster = p_faster < alpha
+
+        if slower and result.ratio > 1.0 + threshold:
+            result.status = "REGRESSION"
+        elif faster and result.ratio < 1.0 / (1.0 + threshold):
+            result.status = "IMPROVEMENT"
+        results.append(result)
+    return results
+
+
+# -----------------------------------------------------------------------------
+# Reporting
+# -----------------------------------------------------------------------------
+
+
+def _format_time(ns: float) -> str:
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return f"{ns / scale:.3f} {unit}"
+    return f"{ns:.1f} ns"
+
+
+def format_summary(results: Dict[str, List[Comparison]]) -> str:
+    """Human-readable table of the comparisons, grouped by executable."""
+    lines = []
+    regressions = 0
+    for executable, comparisons in results.items():
+        lines.append(f"== {executable}")
+        for r in comparisons:
+            if r.status in ("NEW", "MISSING"):
+                lines.append(f"  {r.status:<11} {r.name}")
+                continue
+            if r.ci is not None:
+                evidence = f"ratio CI [{r.ci[0]:.3f}, {r.ci[1]:.3f}]"
+            else:
+                evidence = f"p={r.p_value:.4f}"
+            lines.append(
+                f"  {r.status:<11} {r.name}: {_format_time(r.baseline_median)} -> "
+                f"{_format_time(r.current_median)} ({(r.ratio - 1.0) * 100.0:+.1f}%, {evidence})"
+            )
+            regressions += r.status == "REGRESSION"
+    lines.append("")
+    lines.append(f"FAIL: {regressions} regression(s)" if regressions else "PASS: no regression")
+    return "\n".join(lines)
+
+
+# -----------------------------------------------------------------------------
+# Command line
+# -----------------------------------------------------------------------------
+
+
+def _collect_reports(args: argparse.Namespace) -> Dict[str, dict]:
+    """JSON reports by executable name, from --input files or by running the build."""
+    if args.input:
+        return {Path(p).stem: json.loads(Path(p).read_text()) for p in args.input}
+    reports = {}
+    for executable in find_benchmark_executables(Path(args.build_dir), args.benchmarks):
+        print(f"Running {executable.name} ({args.repetitions} repetitions)...", file=sys.stderr)
+        reports[executable.stem] = run_benchmark(
+            executable, args.repetitions, args.filter, args.min_time
+        )
+    return reports
+
+
+def main(argv: Optional[Sequence[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("command", choices=("record", "compare"))
+    parser.add_argument(
+        "--build-dir", default=".", help="Build tree holding benchmark_* and quarisma_perf"
+    )
+    parser.add_argument(
+        "--benchmarks", nargs="*", default=(), help="Executables to run, e.g. BenchmarkParallel"
+    )
+    parser.add_argument(
+        "--input", nargs="*", help="Google Benchmark JSON reports to use instead of running"
+    )
+    parser.add_argument(
+        "--baseline-dir", help="Baseline directory (default: <build-dir>/benchmark_baselines)"
+    )
+    parser.add_argument("--repetitions", type=int, default=10)
+    parser.add_argument("--filter", help="Passed to --benchmark_filter")
+    parser.add_argument("--min-time", help="Passed to --benchmark_min_time, e.g. 0.1s")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time")
+    parser.add_argument("--test", choices=("mann-whitney", "bootstrap"), default="mann-whitney")
+    parser.add_argument("--alpha", type=float, default=0.01, help="Significance level")
+    parser.add_argument(
+        "--threshold", type=float, default=0.05, help="Smallest relative change reported"
+    )
+    parser.add_argument("--json", help="Also write the comparisons to this JSON file")
+    args = parser.parse_args(argv)
+
+    baseline_dir = Path(args.baseline_dir or Path(args.build_dir) / "benchmark_baselines")
+    try:
+        reports = _collect_reports(args)
+    except (FileNotFoundError, subprocess.CalledProcessError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 2
+
+    if args.command == "record":
+        for executable, report in reports.items():
+            path = baseline_path(baseline_dir, executable)
+            save_baseline(path, report, parse_benchmark_report(report))
+            print(f"Recorded {path}")
+        return 0
+
+    results: Dict[str, List[Comparison]] = {}
+    for executable, report in reports.items():
+        path = baseline_path(baseline_dir, executable)
+        if not path.exists():
+            print(f"error: no baseline {path}; run 'record' first", file=sys.stderr)
+            return 2
+        results[executable] = compare_samples(
+            load_baseline(path),
+            parse_benchmark_report(report),
+            metric=args.metric,
+            test=args.test,
+            alpha=args.alpha,
+            threshold=args.threshold,
+        )
+
+    print(format_summary(results))
+    if args.json:
+        Path(args.json).write_text(
+            json.dumps(
+                {exe: [vars(r) for r in comparisons] for exe, comparisons in results.items()},
+                indent=2,
+            )
+        )
+    regressed = any(r.status == "REGRESSION" for c in results.values() for r in c)
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,192 @@
+"""Tests for benchmark regression tracking against stored baselines."""
+
+import json
+import tempfile
+import unittest
+from pathlib import Path
+
+from benchmark_regression import (
+    BenchmarkSamples,
+    bootstrap_median_ratio,
+    compare_samples,
+    find_benchmark_executables,
+    format_summary,
+    load_baseline,
+    main,
+    mann_whitney_greater,
+    normalize_benchmark_name,
+    parse_benchmark_report,
+    save_baseline,
+)
+
+
+def make_report(times_by_name, time_unit="ns"):
+    """Google Benchmark JSON report with one entry per repetition plus aggregates."""
+    benchmarks = []
+    for name, times in times_by_name.items():
+        for t in times:
+            benchmarks.append(
+                {
+                    "name": f"{name}/repeats:{len(times)}",
+                    "run_name": name,
+                    "run_type": "iteration",
+                    "real_time": t,
+                    "cpu_time": t * 0.9,
+                    "time_unit": time_unit,
+                }
+            )
+        benchmarks.append(
+            {
+                "name": f"{name}_mean",
+                "run_name": name,
+                "run_type": "aggregate",
+                "aggregate_name": "mean",
+                "real_time": sum(times) / len(times),
+                "cpu_time": 0.0,
+                "time_unit": time_unit,
+            }
+        )
+    return {"context": {"host_name": "test"}, "benchmarks": benchmarks}
+
+
+BASE = [100.0, 101.0, 99.0, 100.5, 99.5, 100.2, 99.8, 100.1, 100.3, 99.7]
+
+
+class TestParsing(unittest.TestCase):
+    """Tests for report parsing and name normalization."""
+
+    def test_skips_aggregates_and_converts_units(self):
+        samples = parse_benchmark_report(make_report({"BM_a": [1.0, 2.0]}, time_unit="us"))
+        self.assertEqual(list(samples), ["BM_a"])
+        self.assertEqual(samples["BM_a"].real_time, [1000.0, 2000.0])
+        self.assertEqual(samples["BM_a"].cpu_time, [900.0, 1800.0])
+
+    def test_normalize_benchmark_name(self):
+        for name in ("BenchmarkParallel", "benchmark_parallel", "parallel"):
+            self.assertEqual(normalize_benchmark_name(name), "parallel")
+        for name in ("BenchmarkPerf", "quarisma_perf", "perf"):
+            self.assertEqual(normalize_benchmark_name(name), "perf")
+
+    def test_finds_end_to_end_suite(self):
+        with tempfile.TemporaryDirectory() as temp:
+            bin_dir = Path(temp) / "bin"
+            bin_dir.mkdir()
+            for name in ("benchmark_parallel", "quarisma_perf", "quarisma_perf.pdb", "quarisma"):
+                (bin_dir / name).write_text("")
+            found = find_benchmark_executables(Path(temp))
+            self.assertEqual([p.name for p in found], ["benchmark_parallel", "quarisma_perf"])
+            only = find_benchmark_executables(Path(temp), ["BenchmarkPerf"])
+            self.assertEqual([p.name for p in only], ["quarisma_perf"])
+
+
+class TestStatistics(unittest.TestCase):
+    """Tests for the significance tests."""
+
+    def test_mann_whitney_detects_shift(self):
+        slower = [t * 1.2 for t in BASE]
+        self.assertLess(mann_whitney_greater(BASE, slower), 0.001)
+        self.assertGreater(mann_whitney_greater(slower, BASE), 0.99)
+
+    def test_mann_whitney_identical_samples(self):
+        self.assertEqual(mann_whitney_greater([5.0] * 6, [5.0] * 6), 1.0)
+        self.assertGreater(mann_whitney_greater(BASE, list(reversed(BASE))), 0.3)
+
+    def test_bootstrap_is_deterministic(self):
+        slower = [t * 1.2 for t in BASE]
+        first = bootstrap_median_ratio(BASE, slower)
+        self.assertEqual(first, bootstrap_median_ratio(BASE, slower))
+        self.assertGreater(first[0], 1.1)
+        self.assertLess(first[1], 1.3)
+
+
+class TestCompare(unittest.TestCase):
+    """Tests for the regression verdicts."""
+
+    def setUp(self):
+        self.baseline = {
+            "steady": BenchmarkSamples(BASE, BASE),
+            "slower": BenchmarkSamples(BASE, BASE),
+            "faster": BenchmarkSamples(BASE, BASE),
+            "small_shift": BenchmarkSamples(BASE, BASE),
+            "removed": BenchmarkSamples(BASE, BASE),
+        }
+        shifted = lambda f: BenchmarkSamples([t * f for t in BASE], [t * f for t in BASE])
+        self.current = {
+            "steady": BenchmarkSamples(list(reversed(BASE)), BASE),
+            "slower": shifted(1.3),
+            "faster": shifted(0.7),
+            "small_shift": shifted(1.02),
+            "added": BenchmarkSamples(BASE, BASE),
+        }
+
+    def test_verdicts(self):
+        for test in ("mann-whitney", "bootstrap"):
+            with self.subTest(test=test):
+                results = {r.name: r.status for r in compare_samples(
+                    self.baseline, self.current, test=test)}
+                self.assertEqual(
+                    results,
+                    {
+                        "steady": "OK",
+                        "slower": "REGRESSION",
+                        "faster": "IMPROVEMENT",
+                        "small_shift": "OK",
+                        "removed": "MISSING",
+                        "added": "NEW",
+                    },
+                )
+
+    def test_summary(self):
+        summary = format_summary({"benchmark_x": compare_samples(self.baseline, self.current)})
+        self.assertIn("REGRESSION  slower", summary)
+        self.assertIn("+30.0%", summary)
+        self.assertTrue(summary.endswith("FAIL: 1 regression(s)"))
+
+
+class TestCommandLine(unittest.TestCase):
+    """Tests for record and compare on pre-run reports."""
+
+    def setUp(self):
+        self.temp_dir = tempfile.TemporaryDirectory()
+        self.dir = Path(self.temp_dir.name)
+
+    def tearDown(self):
+        self.temp_dir.cleanup()
+
+    def write_report(self, name, times):
+        path = self.dir / "runs" / f"{name}.json"
+        path.parent.mkdir(exist_ok=True)
+        path.write_text(json.dumps(make_report({"BM_a": times})))
+        return str(path)
+
+    def test_baseline_round_trip(self):
+        path = self.dir / "benchmark_x.json"
+        report = make_report({"BM_a": BASE})
+        save_baseline(path, report, parse_benchmark_report(report))
+        self.assertEqual(json.loads(path.read_text())["context"]["host_name"], "test")
+        self.assertEqual(load_baseline(path)["BM_a"].real_time, BASE)
+
+    def test_record_then_compare(self):
+        baselines = str(self.dir / "baselines")
+        report = self.write_report("benchmark_x", BASE)
+        self.assertEqual(main(["record", "--input", report, "--baseline-dir", baselines]), 0)
+        self.assertTrue((self.dir / "baselines" / "benchmark_x.json").exists())
+        self.assertEqual(main(["compare", "--input", report, "--baseline-dir", baselines]), 0)
+
+        slower = self.write_report("benchmark_x", [t * 1.5 for t in BASE])
+        out = str(self.dir / "result.json")
+        self.assertEqual(
+            main(["compare", "--input", slower, "--baseline-dir", baselines, "--json", out]), 1
+        )
+        self.assertEqual(json.loads(Path(out).read_text())["benchmark_x"][0]["status"],
+                         "REGRESSION")
+
+    def test_compare_without_baseline(self):
+        report = self.write_report("benchmark_y", BASE)
+        self.assertEqual(
+            main(["compare", "--input", report, "--baseline-dir", str(self.dir / "none")]), 2
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
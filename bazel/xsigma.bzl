@@ -51,8 +51,8 @@ def quarisma_defines():
         "//bazel:enable_tbb": ["QUARISMA_HAS_TBB"],
         "//conditions:default": [],
     }) + select({
-        "//bazel:enable_mkl": ["QUARISMA_ENABLE_MKL"],
-        "//conditions:default": [],
+        "//bazel:enable_mkl": ["QUARISMA_ENABLE_MKL", "QUARISMA_HAS_MKL=1"],
+        "//conditions:default": ["QUARISMA_HAS_MKL=0"],
     }) + select({
         "//bazel:enable_mimalloc": ["QUARISMA_ENABLE_MIMALLOC"],
         "//conditions:default": [],
@@ -77,6 +77,9 @@ def quarisma_defines():
     }) + select({
         "//bazel:sobol_1111": ["QUARISMA_SOBOL_1111"],
         "//conditions:default": [],
+    }) + select({
+        "//bazel:swiss_table": ["QUARISMA_SWISS_TABLE"],
+        "//conditions:default": [],
     }) + select({
         "//bazel:logging_glog": ["QUARISMA_USE_GLOG"],
         "//bazel:logging_loguru": ["QUARISMA_USE_LOGURU"],